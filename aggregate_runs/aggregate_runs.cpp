@@ -0,0 +1,252 @@
+﻿// <copyright file="aggregate_runs.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "power_overwhelming/binary_output_reader.h"
+#include "power_overwhelming/convert_string.h"
+
+#include "run_aggregate.h"
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <tchar.h>
+#endif /* defined(_WIN32) */
+
+#if !defined(_tmain)
+#define _tmain main
+#define TCHAR char
+#define _T(x) (x)
+#endif /* !defined(_tmain) */
+
+
+/// <summary>
+/// Writes <paramref name="str" /> as a CSV field, which is quoted if
+/// necessary.
+/// </summary>
+static void write_csv_string(std::ostream& stream, const std::wstring& str) {
+    const auto s = visus::power_overwhelming::convert_string<char>(str);
+    if (s.find_first_of(",\"\r\n") == std::string::npos) {
+        stream << s;
+        return;
+    }
+
+    stream << '"';
+    for (auto c : s) {
+        if (c == '"') {
+            stream << '"';
+        }
+        stream << c;
+    }
+    stream << '"';
+}
+
+
+/// <summary>
+/// Splits a comma-separated list.
+/// </summary>
+template<class TChar>
+static std::vector<std::basic_string<TChar>> split_list(
+        const std::basic_string<TChar>& list) {
+    std::vector<std::basic_string<TChar>> retval;
+    std::size_t begin = 0;
+
+    while (begin <= list.size()) {
+        auto end = list.find(TChar(','), begin);
+        if (end == std::basic_string<TChar>::npos) {
+            end = list.size();
+        }
+        if (end > begin) {
+            retval.push_back(list.substr(begin, end - begin));
+        }
+        begin = end + 1;
+    }
+
+    return retval;
+}
+
+
+/// <summary>
+/// Entry point of the aggregate_runs application, which computes the energy
+/// and the distribution of the power per marker phase and sensor for a whole
+/// campaign of binary traces.
+/// </summary>
+/// <param name="argc"></param>
+/// <param name="argv"></param>
+/// <returns></returns>
+int _tmain(const int argc, const TCHAR **argv) {
+    using namespace visus::power_overwhelming;
+
+    std::wcout << L"aggregate_runs" << std::endl;
+    std::wcout << L"© 2023 Visualisierungsinstitut der Universität Stuttgart."
+        << std::endl << L"All rights reserved."
+        << std::endl << std::endl;
+
+    const std::vector<std::basic_string<TCHAR>> cmd_line(argv, argv + argc);
+    std::vector<std::wstring> markers;
+    std::basic_string<TCHAR> output(_T("aggregate_runs.csv"));
+    std::vector<double> quantiles { 0.05, 0.5, 0.95 };
+    std::vector<std::basic_string<TCHAR>> runs;
+    std::vector<std::wstring> sensors;
+    auto show_help = false;
+    std::size_t threads = std::thread::hardware_concurrency();
+
+    try {
+        for (auto it = cmd_line.begin() + 1; it != cmd_line.end(); ++it) {
+            const auto has_value = ((it + 1) != cmd_line.end());
+
+            if ((*it == _T("--marker")) && has_value) {
+                for (auto& m : split_list(*++it)) {
+                    markers.push_back(convert_string<wchar_t>(m));
+                }
+            } else if ((*it == _T("--output")) && has_value) {
+                output = *++it;
+            } else if ((*it == _T("--quantiles")) && has_value) {
+                quantiles.clear();
+                for (auto& q : split_list(*++it)) {
+                    quantiles.push_back(std::stod(q));
+                }
+            } else if ((*it == _T("--sensor")) && has_value) {
+                for (auto& s : split_list(*++it)) {
+                    sensors.push_back(convert_string<wchar_t>(s));
+                }
+            } else if ((*it == _T("--threads")) && has_value) {
+                threads = std::stoul(*++it);
+            } else if (it->compare(0, 2, _T("--")) == 0) {
+                show_help = true;
+            } else {
+                runs.push_back(*it);
+            }
+        }
+    } catch (std::exception&) {
+        show_help = true;
+    }
+
+    const auto valid_quantile = [](const double q) {
+        return ((q >= 0.0) && (q <= 1.0));
+    };
+    if (show_help || runs.empty() || !std::all_of(quantiles.begin(),
+            quantiles.end(), valid_quantile)) {
+        std::wcout << L"Aggregates the energy and the power per marker phase "
+            << L"and sensor over many" << std::endl
+            << L"binary traces and writes a single CSV table with one row "
+            << L"per run, marker" << std::endl
+            << L"and sensor. Rows with an empty marker cover the whole run."
+            << std::endl << std::endl;
+        std::wcout << L"Usage: aggregate_runs [--marker <names>] "
+            << L"[--output <path>] [--quantiles <list>]" << std::endl
+            << L"       [--sensor <names>] [--threads <n>] <trace>..."
+            << std::endl;
+        std::wcout << L"--marker     The comma-separated markers to aggregate "
+            << L"(default: all)." << std::endl;
+        std::wcout << L"--output     The path to the table "
+            << L"(default: aggregate_runs.csv)." << std::endl;
+        std::wcout << L"--quantiles  The comma-separated quantiles of the "
+            << L"power in [0, 1]" << std::endl
+            << L"             (default: 0.05,0.5,0.95)." << std::endl;
+        std::wcout << L"--sensor     The comma-separated sensors to aggregate "
+            << L"(default: all)." << std::endl;
+        std::wcout << L"--threads    The number of traces processed in "
+            << L"parallel (default: all cores)." << std::endl;
+        return -2;
+    }
+
+    try {
+        // Each worker opens its own readers, because they are not
+        // thread-safe, and takes the next trace until all are done. The
+        // results are stored by run such that the table is in the order of
+        // the command line regardless of the order of completion.
+        std::vector<std::vector<run_aggregate>> results(runs.size());
+        std::vector<std::string> errors(runs.size());
+        std::atomic<std::size_t> next(0);
+
+        auto worker = [&](void) {
+            for (auto r = next++; r < runs.size(); r = next++) {
+                try {
+                    binary_output_reader reader(runs[r].c_str());
+                    results[r] = aggregate_run(reader, sensors, markers);
+                } catch (std::exception& ex) {
+                    errors[r] = ex.what();
+                }
+            }
+        };
+
+        threads = (std::max)(static_cast<std::size_t>(1),
+            (std::min)(threads, runs.size()));
+        std::vector<std::thread> pool;
+        for (std::size_t i = 1; i < threads; ++i) {
+            pool.emplace_back(worker);
+        }
+        worker();
+        for (auto& t : pool) {
+            t.join();
+        }
+
+        std::ofstream stream(output, std::ofstream::out
+            | std::ofstream::trunc);
+        if (!stream) {
+            throw std::runtime_error("The output file could not be opened.");
+        }
+
+        stream << "run,marker,sensor,phases,samples,duration,energy,mean";
+        for (auto q : quantiles) {
+            stream << ",p" << q;
+        }
+        stream << std::endl;
+
+        std::vector<float> values(quantiles.size());
+        std::size_t failed = 0;
+        for (std::size_t r = 0; r < runs.size(); ++r) {
+            const auto run = convert_string<wchar_t>(runs[r]);
+
+            if (!errors[r].empty()) {
+                std::wcerr << run << L": " << convert_string<wchar_t>(
+                    errors[r]) << std::endl;
+                ++failed;
+                continue;
+            }
+
+            for (auto& a : results[r]) {
+                if (a.samples < 1) {
+                    continue;
+                }
+
+                a.power.quantiles(values.data(), quantiles.data(),
+                    quantiles.size());
+
+                write_csv_string(stream, run);
+                stream << ",";
+                write_csv_string(stream, a.marker);
+                stream << ",";
+                write_csv_string(stream, a.sensor);
+                stream << "," << a.phases
+                    << "," << a.samples
+                    << "," << std::setprecision(9) << a.duration
+                    << "," << a.energy
+                    << "," << (a.power_sum / a.samples);
+                for (auto v : values) {
+                    stream << "," << v;
+                }
+                stream << std::endl;
+            }
+        }
+
+        std::wcout << (runs.size() - failed) << ((runs.size() - failed == 1)
+            ? L" run" : L" runs") << L" aggregated into \""
+            << output.c_str() << L"\"." << std::endl;
+        return (failed > 0) ? -1 : 0;
+    } catch (std::exception& ex) {
+        std::cout << ex.what() << std::endl;
+        return -1;
+    }
+}
@@ -0,0 +1,171 @@
+﻿// <copyright file="run_aggregate.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "run_aggregate.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+
+#include "timestamp.h"
+
+
+namespace {
+
+    typedef visus::power_overwhelming::binary_output_reader::timestamp_type
+        timestamp_type;
+
+    /// <summary>
+    /// The state of the integration of a single sensor in the current phase.
+    /// </summary>
+    struct sensor_state {
+        std::size_t aggregate;
+        timestamp_type first;
+        timestamp_type last;
+        float last_power;
+        bool started;
+    };
+
+    /// <summary>
+    /// The state of the integration of all sensors in the current phase.
+    /// </summary>
+    struct phase_state {
+        std::vector<run_aggregate> *aggregates;
+        const std::wstring *marker;
+        std::map<std::wstring, sensor_state> sensors;
+        double ticks_per_second;
+    };
+
+    /// <summary>
+    /// Integrates the samples of one chunk into the state of its sensor.
+    /// </summary>
+    void integrate(const wchar_t *sensor,
+            const visus::power_overwhelming::measurement_data *samples,
+            const std::size_t cnt,
+            void *context) {
+        auto state = static_cast<phase_state *>(context);
+
+        auto& aggregates = *state->aggregates;
+        auto it = state->sensors.find(sensor);
+        if (it == state->sensors.end()) {
+            // The aggregates are only created once a sensor has samples,
+            // which may happen in any phase of the marker.
+            auto a = std::find_if(aggregates.begin(), aggregates.end(),
+                    [state, sensor](const run_aggregate& r) {
+                return (r.marker == *state->marker) && (r.sensor == sensor);
+            });
+            if (a == aggregates.end()) {
+                aggregates.emplace_back();
+                aggregates.back().marker = *state->marker;
+                aggregates.back().sensor = sensor;
+                a = aggregates.end() - 1;
+            }
+
+            sensor_state s;
+            s.aggregate = static_cast<std::size_t>(a - aggregates.begin());
+            s.started = false;
+            it = state->sensors.emplace(sensor, s).first;
+        }
+
+        auto& s = it->second;
+        auto& aggregate = aggregates[s.aggregate];
+
+        for (std::size_t i = 0; i < cnt; ++i) {
+            const auto power = samples[i].power();
+            const auto timestamp = samples[i].timestamp();
+
+            if (s.started) {
+                aggregate.energy += 0.5 * (power + s.last_power)
+                    * static_cast<double>(timestamp - s.last)
+                    / state->ticks_per_second;
+            } else {
+                s.first = timestamp;
+                s.started = true;
+            }
+
+            s.last = timestamp;
+            s.last_power = power;
+            aggregate.power.push(power);
+            aggregate.power_sum += power;
+            ++aggregate.samples;
+        }
+    }
+
+    /// <summary>
+    /// Integrates the given sensor or all sensors in the given time span.
+    /// </summary>
+    void aggregate_phase(phase_state& state,
+            const visus::power_overwhelming::binary_output_reader& reader,
+            const std::vector<std::wstring>& sensors,
+            const timestamp_type begin,
+            const timestamp_type end) {
+        state.sensors.clear();
+
+        if (sensors.empty()) {
+            reader.read(nullptr, begin, end, integrate, &state);
+        } else {
+            for (auto& s : sensors) {
+                reader.read(s.c_str(), begin, end, integrate, &state);
+            }
+        }
+
+        for (auto& s : state.sensors) {
+            auto& aggregate = (*state.aggregates)[s.second.aggregate];
+            aggregate.duration += static_cast<double>(
+                s.second.last - s.second.first) / state.ticks_per_second;
+            ++aggregate.phases;
+        }
+    }
+}
+
+
+/*
+ * ::aggregate_run
+ */
+std::vector<run_aggregate> aggregate_run(
+        const visus::power_overwhelming::binary_output_reader& reader,
+        const std::vector<std::wstring>& sensors,
+        const std::vector<std::wstring>& markers) {
+    using namespace visus::power_overwhelming;
+    std::vector<run_aggregate> retval;
+
+    // If no markers were requested, use all of them, but report each text
+    // only once even if it has been declared under multiple IDs.
+    std::vector<std::wstring> names;
+    if (markers.empty()) {
+        for (std::size_t i = 0; i < reader.markers(); ++i) {
+            names.emplace_back(reader.marker(i));
+        }
+    } else {
+        names = markers;
+    }
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+
+    phase_state state;
+    state.aggregates = &retval;
+    state.ticks_per_second = detail::ticks_per_second(reader.resolution());
+
+    const std::wstring whole_run;
+    state.marker = &whole_run;
+    aggregate_phase(state, reader, sensors,
+        (std::numeric_limits<timestamp_type>::min)(),
+        (std::numeric_limits<timestamp_type>::max)());
+
+    std::vector<timestamp_type> begins, ends;
+    for (auto& m : names) {
+        const auto cnt = reader.phases(m.c_str(), nullptr, nullptr, 0);
+        begins.resize(cnt);
+        ends.resize(cnt);
+        reader.phases(m.c_str(), begins.data(), ends.data(), cnt);
+
+        state.marker = &m;
+        for (std::size_t i = 0; i < cnt; ++i) {
+            aggregate_phase(state, reader, sensors, begins[i], ends[i]);
+        }
+    }
+
+    return retval;
+}
@@ -0,0 +1,86 @@
+﻿// <copyright file="run_aggregate.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <string>
+#include <vector>
+
+#include "power_overwhelming/binary_output_reader.h"
+
+#include "quantile_sketch.h"
+
+
+/// <summary>
+/// The statistics of one sensor over all phases of one marker in one run.
+/// </summary>
+struct run_aggregate final {
+
+    /// <summary>
+    /// The total time between the first and the last sample of each phase in
+    /// seconds.
+    /// </summary>
+    double duration;
+
+    /// <summary>
+    /// The energy in Joules, which is integrated separately for each phase
+    /// using the trapezoidal rule.
+    /// </summary>
+    double energy;
+
+    /// <summary>
+    /// The name of the marker, which is empty for the whole run.
+    /// </summary>
+    std::wstring marker;
+
+    /// <summary>
+    /// The number of phases in which the marker was set.
+    /// </summary>
+    std::size_t phases;
+
+    /// <summary>
+    /// The distribution of the power samples.
+    /// </summary>
+    visus::power_overwhelming::detail::quantile_sketch power;
+
+    /// <summary>
+    /// The sum of all power samples in Watts.
+    /// </summary>
+    double power_sum;
+
+    /// <summary>
+    /// The number of samples.
+    /// </summary>
+    std::uint64_t samples;
+
+    /// <summary>
+    /// The name of the sensor.
+    /// </summary>
+    std::wstring sensor;
+
+    /// <summary>
+    /// Initialises a new instance.
+    /// </summary>
+    inline run_aggregate(void) : duration(0.0), energy(0.0), phases(0),
+        power_sum(0.0), samples(0) { }
+};
+
+
+/// <summary>
+/// Computes the statistics of the given sensors in the given marker phases of
+/// the trace opened by <paramref name="reader" />.
+/// </summary>
+/// <param name="reader">The reader of the trace.</param>
+/// <param name="sensors">The names of the sensors to aggregate. If empty, all
+/// sensors in the trace are aggregated.</param>
+/// <param name="markers">The names of the markers to aggregate. If empty, all
+/// markers declared in the trace are aggregated.</param>
+/// <returns>One aggregate for each combination of marker and sensor that has
+/// samples, preceded by the ones for the whole run.</returns>
+std::vector<run_aggregate> aggregate_run(
+    const visus::power_overwhelming::binary_output_reader& reader,
+    const std::vector<std::wstring>& sensors,
+    const std::vector<std::wstring>& markers);
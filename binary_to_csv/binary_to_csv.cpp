@@ -0,0 +1,59 @@
+﻿// <copyright file="binary_to_csv.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/binary_output_to_csv.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <tchar.h>
+#endif /* defined(_WIN32) */
+
+#if !defined(_tmain)
+#define _tmain main
+#define TCHAR char
+#define _T(x) (x)
+#endif /* !defined(_tmain) */
+
+
+/// <summary>
+/// Entry point of the binary_to_csv application, which converts the binary
+/// output of a collector into CSV.
+/// </summary>
+/// <param name="argc"></param>
+/// <param name="argv"></param>
+/// <returns></returns>
+int _tmain(const int argc, const TCHAR **argv) {
+    using namespace visus::power_overwhelming;
+
+    std::wcout << L"binary_to_csv" << std::endl;
+    std::wcout << L"© 2023 Visualisierungsinstitut der Universität Stuttgart."
+        << std::endl << L"All rights reserved."
+        << std::endl << std::endl;
+
+    if (argc != 3) {
+        // Input is wrong, so show the help.
+        std::wcout << L"Converts the binary output of a collector into the "
+            << L"CSV format." << std::endl << std::endl;
+        std::wcout << "Usage: binary_to_csv <input path> <output path>"
+            << std::endl;
+        return -2;
+    }
+
+    try {
+        const std::basic_string<TCHAR> input(argv[1]);
+        const std::basic_string<TCHAR> output(argv[2]);
+        const auto cnt = binary_output_to_csv(input, output);
+        std::wcout << cnt << ((cnt == 1) ? L" sample" : L" samples")
+            << L" converted to \"" << output.c_str() << L"\"." << std::endl;
+        return 0;
+    } catch (std::exception& ex) {
+        std::cout << ex.what() << std::endl;
+        return -1;
+    }
+}
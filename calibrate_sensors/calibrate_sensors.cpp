@@ -0,0 +1,239 @@
+﻿// <copyright file="calibrate_sensors.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "power_overwhelming/binary_output_reader.h"
+#include "power_overwhelming/collector.h"
+#include "power_overwhelming/convert_string.h"
+#include "power_overwhelming/graphics_device.h"
+
+#include "step_response.h"
+#include "timestamp.h"
+
+#include "load_generator.h"
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <tchar.h>
+#endif /* defined(_WIN32) */
+
+#if !defined(_tmain)
+#define _tmain main
+#define TCHAR char
+#define _T(x) (x)
+#endif /* !defined(_tmain) */
+
+
+/// <summary>
+/// Writes <paramref name="str" /> as a JSON string.
+/// </summary>
+static void write_json_string(std::ostream& stream, const wchar_t *str) {
+    const auto s = visus::power_overwhelming::convert_string<char>(str);
+    stream << '"';
+    for (auto c : s) {
+        if ((c == '"') || (c == '\\')) {
+            stream << '\\';
+        }
+        stream << c;
+    }
+    stream << '"';
+}
+
+
+/// <summary>
+/// Writes the responses having at least one edge as a JSON object mapping
+/// the names of the sensors to the given member in microseconds.
+/// </summary>
+static void write_json_times(std::ostream& stream,
+        const std::vector<visus::power_overwhelming::detail::step_response>&
+        responses,
+        visus::power_overwhelming::measurement::timestamp_type
+        visus::power_overwhelming::detail::step_response:: *member,
+        const double ticks_per_second) {
+    auto first = true;
+
+    stream << "{";
+    for (auto& r : responses) {
+        if (r.edges > 0) {
+            stream << (first ? "\n" : ",\n") << "        ";
+            write_json_string(stream, r.sensor);
+            stream << ": " << static_cast<long long>(r.*member * 1000000.0
+                / ticks_per_second + 0.5);
+            first = false;
+        }
+    }
+    stream << (first ? "}" : "\n    }");
+}
+
+
+/// <summary>
+/// Entry point of the calibrate_sensors application, which measures the
+/// delay and the rise time of all sensors from their response to steps of
+/// the load and stores the delays as a correction profile for the collector.
+/// </summary>
+/// <param name="argc"></param>
+/// <param name="argv"></param>
+/// <returns></returns>
+int _tmain(const int argc, const TCHAR **argv) {
+    using namespace visus::power_overwhelming;
+
+    std::wcout << L"calibrate_sensors" << std::endl;
+    std::wcout << L"© 2023 Visualisierungsinstitut der Universität Stuttgart."
+        << std::endl << L"All rights reserved."
+        << std::endl << std::endl;
+
+    const auto recording = L"calibrate_sensors.bin";
+    const std::vector<std::basic_string<TCHAR>> cmd_line(argv, argv + argc);
+    std::size_t cycles = 5;
+    auto gpu = true;
+    std::basic_string<TCHAR> output(_T("correction_profile.json"));
+    std::chrono::milliseconds period(2000);
+    auto show_help = false;
+
+    for (auto it = cmd_line.begin() + 1; it != cmd_line.end(); ++it) {
+        const auto has_value = ((it + 1) != cmd_line.end());
+
+        if (*it == _T("--cpu")) {
+            gpu = false;
+        } else if ((*it == _T("--cycles")) && has_value) {
+            cycles = std::stoul(*++it);
+        } else if ((*it == _T("--output")) && has_value) {
+            output = *++it;
+        } else if ((*it == _T("--period")) && has_value) {
+            period = std::chrono::milliseconds(std::stoul(*++it));
+        } else {
+            show_help = true;
+        }
+    }
+
+    if (show_help || (cycles < 1) || (period.count() < 1)) {
+        std::wcout << L"Measures the delay and the rise time of all sensors "
+            << L"from their response" << std::endl
+            << L"to steps of the load and writes a correction profile "
+            << L"for the collector." << std::endl << std::endl;
+        std::wcout << L"Usage: calibrate_sensors [--cpu] [--cycles <n>] "
+            << L"[--output <path>] [--period <ms>]" << std::endl;
+        std::wcout << L"--cpu     Load only the CPU." << std::endl;
+        std::wcout << L"--cycles  The number of high and low phases "
+            << L"(default: 5)." << std::endl;
+        std::wcout << L"--output  The path to the profile "
+            << L"(default: correction_profile.json)." << std::endl;
+        std::wcout << L"--period  The duration of each phase in "
+            << L"milliseconds (default: 2000)." << std::endl;
+        return -2;
+    }
+
+    try {
+        typedef measurement::timestamp_type timestamp_type;
+        detail::step_response_estimator estimator;
+        std::vector<timestamp_type> steps;
+
+        {
+            // Only the first GPU is loaded, because the steps of several GPUs
+            // would not be distinguishable in the power of the system.
+            std::unique_ptr<graphics_device> device;
+            if (gpu) {
+                graphics_device devices[1];
+                if (graphics_device::all(devices, 1) > 0) {
+                    device.reset(new graphics_device(std::move(devices[0])));
+                    std::wcout << L"Loading \"" << device->name() << L"\"."
+                        << std::endl;
+                }
+            }
+
+            load_generator load(device.get());
+
+            auto settings = collector_settings()
+                .output_format(output_format::binary)
+                .output_path(recording)
+                .require_marker(false);
+            auto collector = collector::for_all(settings);
+            std::wcout << L"Recording " << collector.size() << L" sensors "
+                << L"for " << (2 * cycles + 1) << L" phases of "
+                << period.count() << L" ms." << std::endl;
+
+            // Start and end idle such that there is a settled phase before
+            // the first and after the last step.
+            collector.start();
+            std::this_thread::sleep_for(period);
+
+            for (std::size_t i = 0; i < 2 * cycles; ++i) {
+                const auto high = ((i % 2) == 0);
+                load.high(high);
+                steps.push_back(detail::create_timestamp(
+                    timestamp_resolution::hundred_nanoseconds));
+                collector.marker(high ? L"high" : L"low");
+                std::this_thread::sleep_for(period);
+            }
+
+            collector.stop();
+        }
+
+        binary_output_reader reader(recording);
+        const auto resolution = reader.resolution();
+        const auto tps = detail::ticks_per_second(resolution);
+
+        for (auto s : steps) {
+            estimator.step(detail::convert(s, resolution));
+        }
+
+        for (std::size_t i = 0; i < reader.sensors(); ++i) {
+            reader.read(reader.sensor(i),
+                (std::numeric_limits<timestamp_type>::min)(),
+                (std::numeric_limits<timestamp_type>::max)(),
+                [](const wchar_t *sensor, const measurement_data *samples,
+                        const std::size_t cnt, void *context) {
+                    auto e = static_cast<detail::step_response_estimator *>(
+                        context);
+                    for (std::size_t j = 0; j < cnt; ++j) {
+                        e->push(measurement(sensor, samples[j]));
+                    }
+                }, &estimator);
+        }
+
+        const auto responses = estimator.estimate();
+        std::wcout << std::endl << std::fixed << std::setprecision(2);
+        for (auto& r : responses) {
+            std::wcout << r.sensor << L": ";
+            if (r.edges > 0) {
+                std::wcout << L"delay " << (r.delay * 1000.0 / tps)
+                    << L" ms, rise time " << (r.rise_time * 1000.0 / tps)
+                    << L" ms, amplitude " << r.amplitude << L" W over "
+                    << r.edges << L" steps" << std::endl;
+            } else {
+                std::wcout << L"no response to the load" << std::endl;
+            }
+        }
+
+        std::ofstream s;
+        s.exceptions(s.exceptions() | std::ios::failbit | std::ios::badbit);
+        s.open(output, std::ios::out | std::ios::trunc);
+        s << "{\n    \"sensorDelays\": ";
+        write_json_times(s, responses, &detail::step_response::delay, tps);
+        s << ",\n    \"riseTimes\": ";
+        write_json_times(s, responses, &detail::step_response::rise_time,
+            tps);
+        s << "\n}\n";
+        s.close();
+
+        std::wcout << std::endl << L"Add \"correctionProfile\": \""
+            << output.c_str() << L"\" to the collector configuration to "
+            << L"apply the delays." << std::endl;
+        return 0;
+    } catch (std::exception& ex) {
+        std::cout << ex.what() << std::endl;
+        return -1;
+    }
+}
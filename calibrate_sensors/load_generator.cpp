@@ -0,0 +1,190 @@
+﻿// <copyright file="load_generator.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "load_generator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <system_error>
+
+
+#if (POWER_OVERWHELMING_GPU_ABSTRACTION == 12)
+/// <summary>
+/// Throws a <see cref="std::system_error" /> if <paramref name="hr" />
+/// indicates a failure.
+/// </summary>
+static void throw_on_failure(_In_ const HRESULT hr) {
+    if (FAILED(hr)) {
+        throw std::system_error(hr, std::system_category());
+    }
+}
+#endif /* (POWER_OVERWHELMING_GPU_ABSTRACTION == 12) */
+
+
+/*
+ * load_generator::load_generator
+ */
+load_generator::load_generator(
+        _In_opt_ visus::power_overwhelming::graphics_device *device)
+        : _high(false), _running(true) {
+#if (POWER_OVERWHELMING_GPU_ABSTRACTION == 12)
+    ID3D12Device *d = (device != nullptr) ? *device : nullptr;
+    if (d != nullptr) {
+        D3D12_COMMAND_QUEUE_DESC queue_desc = { };
+        queue_desc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+        throw_on_failure(d->CreateCommandQueue(&queue_desc,
+            IID_PPV_ARGS(&this->_queue)));
+        throw_on_failure(d->CreateCommandAllocator(
+            D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&this->_allocator)));
+        throw_on_failure(d->CreateCommandList(0,
+            D3D12_COMMAND_LIST_TYPE_DIRECT, this->_allocator.Get(), nullptr,
+            IID_PPV_ARGS(&this->_list)));
+        throw_on_failure(this->_list->Close());
+        throw_on_failure(d->CreateFence(0, D3D12_FENCE_FLAG_NONE,
+            IID_PPV_ARGS(&this->_fence)));
+
+        // A 256 MiB texture is large enough for a clear to occupy the whole
+        // GPU for a noticeable time.
+        D3D12_HEAP_PROPERTIES heap_props = { };
+        heap_props.Type = D3D12_HEAP_TYPE_DEFAULT;
+
+        D3D12_RESOURCE_DESC target_desc = { };
+        target_desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+        target_desc.Width = 4096;
+        target_desc.Height = 4096;
+        target_desc.DepthOrArraySize = 1;
+        target_desc.MipLevels = 1;
+        target_desc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+        target_desc.SampleDesc.Count = 1;
+        target_desc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+
+        throw_on_failure(d->CreateCommittedResource(&heap_props,
+            D3D12_HEAP_FLAG_NONE, &target_desc,
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS, nullptr,
+            IID_PPV_ARGS(&this->_target)));
+
+        // Clearing a UAV requires its descriptor in a shader-visible heap
+        // and in a CPU-only one.
+        D3D12_DESCRIPTOR_HEAP_DESC heap_desc = { };
+        heap_desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+        heap_desc.NumDescriptors = 1;
+        throw_on_failure(d->CreateDescriptorHeap(&heap_desc,
+            IID_PPV_ARGS(&this->_cpu_heap)));
+        heap_desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+        throw_on_failure(d->CreateDescriptorHeap(&heap_desc,
+            IID_PPV_ARGS(&this->_gpu_heap)));
+
+        d->CreateUnorderedAccessView(this->_target.Get(), nullptr, nullptr,
+            this->_cpu_heap->GetCPUDescriptorHandleForHeapStart());
+        d->CreateUnorderedAccessView(this->_target.Get(), nullptr, nullptr,
+            this->_gpu_heap->GetCPUDescriptorHandleForHeapStart());
+
+        this->_threads.emplace_back(&load_generator::gpu_load, this);
+    }
+#else /* (POWER_OVERWHELMING_GPU_ABSTRACTION == 12) */
+    (void) device;
+#endif /* (POWER_OVERWHELMING_GPU_ABSTRACTION == 12) */
+
+    const auto cores = (std::max)(1u, std::thread::hardware_concurrency());
+    try {
+        for (unsigned int i = 0; i < cores; ++i) {
+            this->_threads.emplace_back(&load_generator::cpu_load, this);
+        }
+    } catch (...) {
+        this->join();
+        throw;
+    }
+}
+
+
+/*
+ * load_generator::~load_generator
+ */
+load_generator::~load_generator(void) {
+    this->join();
+}
+
+
+/*
+ * load_generator::high
+ */
+void load_generator::high(_In_ const bool high) noexcept {
+    this->_high.store(high, std::memory_order_release);
+}
+
+
+/*
+ * load_generator::join
+ */
+void load_generator::join(void) noexcept {
+    this->_running.store(false, std::memory_order_release);
+    for (auto& t : this->_threads) {
+        t.join();
+    }
+    this->_threads.clear();
+}
+
+
+/*
+ * load_generator::cpu_load
+ */
+void load_generator::cpu_load(void) {
+    volatile double sink = 1.0;
+
+    while (this->_running.load(std::memory_order_acquire)) {
+        if (this->_high.load(std::memory_order_acquire)) {
+            for (int i = 0; i < 4096; ++i) {
+                sink = sink * 1.0000001 + 0.0000001;
+            }
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+
+/*
+ * load_generator::gpu_load
+ */
+void load_generator::gpu_load(void) {
+#if (POWER_OVERWHELMING_GPU_ABSTRACTION == 12)
+    static const FLOAT colours[2][4] = {
+        { 0.0f, 0.0f, 0.0f, 0.0f },
+        { 1.0f, 1.0f, 1.0f, 1.0f }
+    };
+    auto event = ::CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    UINT64 value = 0;
+
+    while (this->_running.load(std::memory_order_acquire)) {
+        if (!this->_high.load(std::memory_order_acquire)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        // Submit small batches and wait for them such that the GPU becomes
+        // idle soon after the load has been switched off.
+        this->_allocator->Reset();
+        this->_list->Reset(this->_allocator.Get(), nullptr);
+
+        ID3D12DescriptorHeap *heaps[] = { this->_gpu_heap.Get() };
+        this->_list->SetDescriptorHeaps(1, heaps);
+        for (int i = 0; i < 16; ++i) {
+            this->_list->ClearUnorderedAccessViewFloat(
+                this->_gpu_heap->GetGPUDescriptorHandleForHeapStart(),
+                this->_cpu_heap->GetCPUDescriptorHandleForHeapStart(),
+                this->_target.Get(), colours[i % 2], 0, nullptr);
+        }
+        this->_list->Close();
+
+        ID3D12CommandList *lists[] = { this->_list.Get() };
+        this->_queue->ExecuteCommandLists(1, lists);
+        this->_queue->Signal(this->_fence.Get(), ++value);
+        this->_fence->SetEventOnCompletion(value, event);
+        ::WaitForSingleObject(event, INFINITE);
+    }
+
+    ::CloseHandle(event);
+#endif /* (POWER_OVERWHELMING_GPU_ABSTRACTION == 12) */
+}
@@ -0,0 +1,82 @@
+﻿// <copyright file="load_generator.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "power_overwhelming/graphics_device.h"
+
+#if (POWER_OVERWHELMING_GPU_ABSTRACTION == 12)
+#include <wrl/client.h>
+#endif /* (POWER_OVERWHELMING_GPU_ABSTRACTION == 12) */
+
+
+/// <summary>
+/// Switches the load of the system between idle and full utilisation.
+/// </summary>
+/// <remarks>
+/// <para>The CPU load is created by busy threads on all logical cores. If a
+/// Direct3D 12 device is provided, the GPU is loaded additionally by clearing
+/// a large unordered access view over and over again, which does not require
+/// compiling a shader and reaches all shader engines.</para>
+/// <para>The load follows a call to <see cref="high" /> within the time to
+/// submit a batch of clears, which is in the order of a few milliseconds.
+/// </para>
+/// </remarks>
+class load_generator final {
+
+public:
+
+    /// <summary>
+    /// Initialises a new instance, which starts in the idle state.
+    /// </summary>
+    /// <param name="device">The GPU that should be loaded, or
+    /// <c>nullptr</c> for loading only the CPU.</param>
+    /// <exception cref="std::system_error">If the Direct3D resources could not
+    /// be created.</exception>
+    explicit load_generator(
+        _In_opt_ visus::power_overwhelming::graphics_device *device);
+
+    load_generator(const load_generator&) = delete;
+
+    /// <summary>
+    /// Finalises the instance.
+    /// </summary>
+    ~load_generator(void);
+
+    /// <summary>
+    /// Switches to full or to no load.
+    /// </summary>
+    /// <param name="high"><c>true</c> for full utilisation, <c>false</c> for
+    /// idling.</param>
+    void high(_In_ const bool high) noexcept;
+
+    load_generator& operator =(const load_generator&) = delete;
+
+private:
+
+    void cpu_load(void);
+
+    void gpu_load(void);
+
+    void join(void) noexcept;
+
+    std::atomic<bool> _high;
+    std::atomic<bool> _running;
+    std::vector<std::thread> _threads;
+
+#if (POWER_OVERWHELMING_GPU_ABSTRACTION == 12)
+    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> _allocator;
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> _cpu_heap;
+    Microsoft::WRL::ComPtr<ID3D12Fence> _fence;
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> _gpu_heap;
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> _list;
+    Microsoft::WRL::ComPtr<ID3D12CommandQueue> _queue;
+    Microsoft::WRL::ComPtr<ID3D12Resource> _target;
+#endif /* (POWER_OVERWHELMING_GPU_ABSTRACTION == 12) */
+};
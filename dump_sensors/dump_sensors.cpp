@@ -47,12 +47,38 @@ int _tmain(const int argc, const TCHAR **argv) {
         show_help = ((collector + 1) == cmd_line.end());
     }
 
+    // The filter options all expect a pattern as their argument. Unless the
+    // --collector option is used, the output path is the last argument.
+    sensor_filter filter;
+    for (auto it = cmd_line.begin(); it != cmd_line.end(); ++it) {
+        const auto is_device = (*it == _T("--device"));
+        const auto is_name = (*it == _T("--name"));
+        const auto is_type = (*it == _T("--type"));
+
+        if (is_device || is_name || is_type) {
+            if ((it + 1) == cmd_line.end()) {
+                show_help = true;
+                break;
+            }
+
+            const auto pattern = convert_string<wchar_t>(*++it);
+            if (is_device) {
+                filter.device(pattern.c_str());
+            } else if (is_name) {
+                filter.name(pattern.c_str());
+            } else {
+                filter.type(pattern.c_str());
+            }
+        }
+    }
+
     if (show_help) {
         // Input is wrong, so show the help.
         std::wcout << L"Dumps the definition of all sensors that are currently "
             << L"available on this machine " << std::endl
             << L"into a JSON file." << std::endl << std::endl;
-        std::wcout << "Usage: dump_sensors [--collector] <output path>"
+        std::wcout << "Usage: dump_sensors [--type <regex>] [--name <regex>] "
+            << "[--device <regex>] [--collector] <output path>"
             << std::endl;
         return -2;
     }
@@ -63,13 +89,13 @@ int _tmain(const int argc, const TCHAR **argv) {
         if (collector != cmd_line.end()) {
             const auto path0 = *(collector + 1);
             const auto path = convert_string<wchar_t>(path0);
-            collector::make_configuration_template(path.c_str());
+            collector::make_configuration_template(path.c_str(), filter);
             std::wcout << L"Collector configuration template dumped to \""
                 << path << L"\"." << std::endl;
 
         } else {
-            const auto path = cmd_line[1];
-            const auto cnt = dump_sensors(path);
+            const auto path = cmd_line.back();
+            const auto cnt = dump_sensors(path, filter);
             std::wcout << cnt << ((cnt == 1) ? L" sensor" : L" sensors")
                 << L" dumped to \"" << path.c_str() << L"\"." << std::endl;
         }
@@ -0,0 +1,121 @@
+﻿// <copyright file="collector_benchmark.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+
+
+using namespace visus::power_overwhelming;
+
+
+/// <summary>
+/// The collector shared by all threads of <see cref="collector_push" />.
+/// </summary>
+static std::unique_ptr<detail::collector_impl> shared_collector;
+
+
+/// <summary>
+/// Measures the throughput of the callback delivering samples to a running
+/// collector, which is called concurrently by all threads of the benchmark.
+/// </summary>
+/// <remarks>
+/// The argument of the benchmark is the output format. The I/O thread of the
+/// collector is running while the samples are delivered, so the benchmark
+/// includes the contention between the producers and the writer.
+/// </remarks>
+static void collector_push(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        collector_settings settings;
+        settings.output_format(static_cast<output_format>(state.range(0)))
+            .output_path(L"pobench.out");
+
+        shared_collector.reset(new detail::collector_impl());
+        shared_collector->apply(settings);
+        shared_collector->start();
+    }
+
+    // Note: The benchmark library synchronises all threads at the begin of
+    // the loop, so the collector has been started at this point.
+    for (auto _ : state) {
+        const measurement m(L"sensor", detail::create_timestamp(
+            timestamp_resolution::milliseconds), 12.0f, 1.0f);
+        detail::collector_impl::on_measurement(m, shared_collector.get());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+
+    if (state.thread_index() == 0) {
+        shared_collector->stop();
+        state.counters["overflows"] = benchmark::Counter(
+            static_cast<double>(shared_collector->overflows()));
+        shared_collector.reset();
+    }
+}
+
+BENCHMARK(collector_push)
+    ->Arg(static_cast<int>(output_format::csv))
+    ->Arg(static_cast<int>(output_format::binary))
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+
+
+/// <summary>
+/// The number of samples in the trace replayed by
+/// <see cref="collector_replay" />.
+/// </summary>
+static constexpr int replay_samples = 100000;
+
+
+/// <summary>
+/// Measures the end-to-end throughput of a collector fed by a
+/// <see cref="replay_sensor" /> that replays a recorded trace as fast as
+/// possible.
+/// </summary>
+/// <remarks>
+/// The argument of the benchmark is the output format. In contrast to
+/// <see cref="collector_push" />, the samples take the path of real sensors
+/// from the sampler thread through the whole pipeline of the collector, and
+/// the time includes starting and stopping the collector.
+/// </remarks>
+static void collector_replay(benchmark::State& state) {
+    {
+        detail::binary_output_writer writer;
+        writer.open(L"pobench.replay.bin");
+        writer.header(timestamp_resolution::milliseconds, { L"sensor" });
+
+        for (int i = 0; i < replay_samples; ++i) {
+            writer.push(measurement(L"sensor", i, 12.0f, 1.0f), 0);
+        }
+    }
+
+    for (auto _ : state) {
+        collector_settings settings;
+        settings.output_format(static_cast<output_format>(state.range(0)))
+            .output_path(L"pobench.out");
+
+        std::unique_ptr<replay_sensor> sensor(new replay_sensor(
+            L"pobench.replay.bin", L"sensor"));
+        sensor->speed(replay_sensor::as_fast_as_possible);
+        auto replay = sensor.get();
+
+        detail::collector_impl collector;
+        collector.apply(settings);
+        collector.attach(std::move(sensor));
+        collector.start();
+
+        while (replay->replayed() < replay->samples()) {
+            std::this_thread::yield();
+        }
+
+        collector.stop();
+    }
+
+    state.SetItemsProcessed(state.iterations() * replay_samples);
+}
+
+BENCHMARK(collector_replay)
+    ->Arg(static_cast<int>(output_format::csv))
+    ->Arg(static_cast<int>(output_format::binary))
+    ->Arg(static_cast<int>(output_format::async_binary))
+    ->UseRealTime();
@@ -0,0 +1,52 @@
+﻿// <copyright file="constant_sensor.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "pch.h"
+
+
+/// <summary>
+/// A mock sensor that always returns the same power, which allows for
+/// benchmarking the sampling infrastructure without any hardware.
+/// </summary>
+/// <remarks>
+/// The timestamps of the samples are always created with a resolution of
+/// hundred nanoseconds such that the intervals between the samples can be
+/// measured precisely.
+/// </remarks>
+class constant_sensor final : public visus::power_overwhelming::sensor {
+
+public:
+
+    inline explicit constant_sensor(_In_z_ const wchar_t *name)
+        : _name(name) { }
+
+    ~constant_sensor(void) {
+        this->sample_batch(nullptr);
+    }
+
+    const wchar_t *name(void) const noexcept override {
+        return this->_name;
+    }
+
+    operator bool(void) const noexcept override {
+        return (this->_name != nullptr);
+    }
+
+protected:
+
+    visus::power_overwhelming::measurement_data sample_sync(
+            _In_ const visus::power_overwhelming::timestamp_resolution
+            resolution) const override {
+        using namespace visus::power_overwhelming;
+        return measurement_data(detail::create_timestamp(
+            timestamp_resolution::hundred_nanoseconds), 12.0f, 1.0f);
+    }
+
+private:
+
+    const wchar_t *_name;
+};
@@ -0,0 +1,57 @@
+﻿// <copyright file="csv_benchmark.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+
+
+using namespace visus::power_overwhelming;
+
+
+/// <summary>
+/// Measures formatting samples with the stream operators of the public API.
+/// </summary>
+static void csv_stream(benchmark::State& state) {
+    const measurement m(L"sensor", detail::create_timestamp(
+        timestamp_resolution::milliseconds), 12.0f, 1.0f);
+    std::wstringstream stream;
+    stream << setcsvdelimiter(L'\t') << setcsvquote(L'"');
+
+    for (auto _ : state) {
+        stream << m << L"\n";
+
+        // Prevent the stream from growing indefinitely.
+        if (stream.tellp() > (1 << 20)) {
+            stream.str(L"");
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(csv_stream);
+
+
+/// <summary>
+/// Measures formatting samples with the writer of the collector, including
+/// the writes to the output file.
+/// </summary>
+static void csv_writer(benchmark::State& state) {
+    const measurement m(detail::sensor_name_registry::intern(L"sensor"),
+        detail::create_timestamp(timestamp_resolution::milliseconds),
+        12.0f, 1.0f);
+    detail::csv_output_writer writer;
+    writer.open(L"pobench.csv");
+    writer.quote('"');
+    writer.header();
+
+    for (auto _ : state) {
+        writer.push(m, 0);
+    }
+
+    writer.close();
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(csv_writer);
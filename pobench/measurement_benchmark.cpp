@@ -0,0 +1,80 @@
+﻿// <copyright file="measurement_benchmark.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+
+
+using namespace visus::power_overwhelming;
+
+
+/// <summary>
+/// Measures the construction of a sample with all electrical quantities.
+/// </summary>
+static void measurement_construct(benchmark::State& state) {
+    const auto timestamp = detail::create_timestamp(
+        timestamp_resolution::milliseconds);
+
+    for (auto _ : state) {
+        measurement m(L"sensor", timestamp, 12.0f, 1.0f);
+        benchmark::DoNotOptimize(m);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(measurement_construct);
+
+
+/// <summary>
+/// Measures the construction of a sample from its sensor-independent data.
+/// </summary>
+static void measurement_construct_from_data(benchmark::State& state) {
+    const measurement_data data(detail::create_timestamp(
+        timestamp_resolution::milliseconds), 12.0f, 1.0f);
+
+    for (auto _ : state) {
+        measurement m(L"sensor", data);
+        benchmark::DoNotOptimize(m);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(measurement_construct_from_data);
+
+
+/// <summary>
+/// Measures copying a sample.
+/// </summary>
+static void measurement_copy(benchmark::State& state) {
+    const measurement m(L"sensor", detail::create_timestamp(
+        timestamp_resolution::milliseconds), 12.0f, 1.0f);
+
+    for (auto _ : state) {
+        measurement copy(m);
+        benchmark::DoNotOptimize(copy);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(measurement_copy);
+
+
+/// <summary>
+/// Measures interning a sensor name that is already known.
+/// </summary>
+static void sensor_name_intern(benchmark::State& state) {
+    detail::sensor_name_registry::intern(L"sensor");
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(detail::sensor_name_registry::intern(
+            L"sensor"));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(sensor_name_intern)->ThreadRange(1, 8);
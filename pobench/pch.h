@@ -0,0 +1,31 @@
+﻿// <copyright file="pch.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "power_overwhelming/collector_settings.h"
+#include "power_overwhelming/csv_iomanip.h"
+#include "power_overwhelming/measurement.h"
+#include "power_overwhelming/measurement_data.h"
+#include "power_overwhelming/replay_sensor.h"
+#include "power_overwhelming/sensor.h"
+
+#include "binary_output.h"
+#include "collector_impl.h"
+#include "csv_output.h"
+#include "sensor_name_registry.h"
+#include "timestamp.h"
@@ -0,0 +1,112 @@
+﻿// <copyright file="sampler_benchmark.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+
+#include "constant_sensor.h"
+
+
+using namespace visus::power_overwhelming;
+
+
+/// <summary>
+/// Collects the timestamps of the samples delivered by the sampler.
+/// </summary>
+struct tick_recorder final {
+    std::condition_variable cv;
+    std::mutex lock;
+    std::size_t expected;
+    std::vector<timestamp_type> timestamps;
+
+    static void on_batch(_In_z_ const wchar_t *sensor,
+            _In_reads_(cnt) const measurement_data *samples,
+            _In_ const std::size_t cnt,
+            _In_opt_ void *context) {
+        auto that = static_cast<tick_recorder *>(context);
+        std::lock_guard<decltype(that->lock)> l(that->lock);
+        for (std::size_t i = 0; i < cnt; ++i) {
+            that->timestamps.push_back(samples[i].timestamp());
+        }
+        if (that->timestamps.size() >= that->expected) {
+            that->cv.notify_all();
+        }
+    }
+};
+
+
+/// <summary>
+/// Measures the deviation of the ticks of the sampler from the requested
+/// interval for the given number of mock sensors.
+/// </summary>
+/// <remarks>
+/// The first argument of the benchmark is the sampling interval in
+/// microseconds, the second one is the number of sensors. The first sensor is
+/// used to measure the intervals between the ticks. The jitter is reported as
+/// user counters, whereas the time of each iteration is the time needed for
+/// sampling 100 ticks.
+/// </remarks>
+static void sampler_jitter(benchmark::State& state) {
+    const auto interval = static_cast<sensor::microseconds_type>(
+        state.range(0));
+    const auto cnt = static_cast<std::size_t>(state.range(1));
+    const std::size_t ticks = 100;
+    double mean = 0.0;
+    double max = 0.0;
+    std::size_t total = 0;
+
+    std::vector<std::unique_ptr<constant_sensor>> sensors;
+    std::vector<std::wstring> names;
+    for (std::size_t i = 0; i < cnt; ++i) {
+        names.push_back(L"mock" + std::to_wstring(i));
+    }
+    for (auto& n : names) {
+        sensors.emplace_back(new constant_sensor(n.c_str()));
+    }
+
+    for (auto _ : state) {
+        tick_recorder recorder;
+        recorder.expected = ticks;
+        recorder.timestamps.reserve(2 * ticks);
+
+        sensors.front()->sample_batch(tick_recorder::on_batch, interval,
+            &recorder);
+        for (std::size_t i = 1; i < sensors.size(); ++i) {
+            sensors[i]->sample_batch([](const wchar_t *, const measurement_data *,
+                const std::size_t, void *) { }, interval, nullptr);
+        }
+
+        {
+            std::unique_lock<decltype(recorder.lock)> l(recorder.lock);
+            recorder.cv.wait(l, [&recorder](void) {
+                return (recorder.timestamps.size() >= recorder.expected);
+            });
+        }
+
+        for (auto& s : sensors) {
+            s->sample_batch(nullptr);
+        }
+
+        // The timestamps are in hundred nanoseconds, the interval in
+        // microseconds.
+        for (std::size_t i = 1; i < recorder.timestamps.size(); ++i) {
+            const auto d = static_cast<double>(recorder.timestamps[i]
+                - recorder.timestamps[i - 1]) / 10.0;
+            const auto jitter = std::abs(d - interval);
+            mean += jitter;
+            max = (std::max)(max, jitter);
+            ++total;
+        }
+    }
+
+    state.counters["jitter_mean_us"] = (total > 0) ? mean / total : 0.0;
+    state.counters["jitter_max_us"] = max;
+}
+
+BENCHMARK(sampler_jitter)
+    ->Args({ 1000, 1 })
+    ->Args({ 1000, 16 })
+    ->Args({ 5000, 1 })
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
@@ -0,0 +1,75 @@
+﻿// <copyright file="timestamp_benchmark.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+
+
+using namespace visus::power_overwhelming;
+
+
+/// <summary>
+/// Measures the creation of a timestamp in the resolution given as the
+/// argument of the benchmark.
+/// </summary>
+static void timestamp_create(benchmark::State& state) {
+    const auto resolution = static_cast<timestamp_resolution>(state.range(0));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(detail::create_timestamp(resolution));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(timestamp_create)
+    ->Arg(static_cast<int>(timestamp_resolution::hundred_nanoseconds))
+    ->Arg(static_cast<int>(timestamp_resolution::milliseconds));
+
+
+/// <summary>
+/// Measures the conversion of single timestamps.
+/// </summary>
+static void timestamp_convert(benchmark::State& state) {
+    const auto resolution = static_cast<timestamp_resolution>(state.range(0));
+    auto timestamp = detail::create_timestamp(
+        timestamp_resolution::hundred_nanoseconds);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(detail::convert(timestamp++, resolution));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(timestamp_convert)
+    ->Arg(static_cast<int>(timestamp_resolution::nanoseconds))
+    ->Arg(static_cast<int>(timestamp_resolution::milliseconds));
+
+
+/// <summary>
+/// Measures the conversion of a batch of 4096 timestamps.
+/// </summary>
+static void timestamp_convert_batch(benchmark::State& state) {
+    const auto resolution = static_cast<timestamp_resolution>(state.range(0));
+    std::vector<timestamp_type> src(4096);
+    std::vector<timestamp_type> dst(src.size());
+
+    const auto start = detail::create_timestamp(
+        timestamp_resolution::hundred_nanoseconds);
+    for (std::size_t i = 0; i < src.size(); ++i) {
+        src[i] = start + 10000 * i;
+    }
+
+    for (auto _ : state) {
+        detail::convert(dst.data(), src.data(), src.size(), resolution);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * src.size());
+}
+
+BENCHMARK(timestamp_convert_batch)
+    ->Arg(static_cast<int>(timestamp_resolution::nanoseconds))
+    ->Arg(static_cast<int>(timestamp_resolution::milliseconds));
@@ -0,0 +1,86 @@
+﻿// <copyright file="podaemon.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/collector.h"
+#include "power_overwhelming/collector_daemon.h"
+#include "power_overwhelming/convert_string.h"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <tchar.h>
+#endif /* defined(_WIN32) */
+
+#if !defined(_tmain)
+#define _tmain main
+#define TCHAR char
+#define _T(x) (x)
+#endif /* !defined(_tmain) */
+
+
+/// <summary>
+/// Set by the signal handler once the daemon should exit.
+/// </summary>
+static std::atomic<bool> exit_requested(false);
+
+
+/// <summary>
+/// Entry point of the podaemon application, which keeps the sensors of a
+/// configuration open and serves requests of clients to record them.
+/// </summary>
+/// <param name="argc"></param>
+/// <param name="argv"></param>
+/// <returns></returns>
+int _tmain(const int argc, const TCHAR **argv) {
+    using namespace visus::power_overwhelming;
+
+    std::wcout << L"podaemon" << std::endl;
+    std::wcout << L"© 2023 Visualisierungsinstitut der Universität Stuttgart."
+        << std::endl << L"All rights reserved."
+        << std::endl << std::endl;
+
+    if ((argc < 2) || (argc > 3)) {
+        // Input is wrong, so show the help.
+        std::wcout << L"Keeps the sensors of a collector configuration open "
+            << L"and records them on request of benchmarks using a "
+            << L"collector_client." << std::endl << std::endl;
+        std::wcout << "Usage: podaemon <configuration> [<control segment>]"
+            << std::endl;
+        return -2;
+    }
+
+    try {
+        const auto config = convert_string<wchar_t>(argv[1]);
+        const auto channel = (argc > 2)
+            ? convert_string<wchar_t>(argv[2])
+            : std::wstring(collector_daemon::default_channel);
+
+        auto collector = collector::from_json(config.c_str());
+        std::wcout << collector.size() << L" sensor(s) opened." << std::endl;
+
+        collector_daemon daemon;
+        daemon.start(collector, channel.c_str());
+        std::wcout << L"Serving requests on \"" << channel << L"\". Press "
+            << L"Ctrl+C to exit." << std::endl;
+
+        std::signal(SIGINT, [](int) { exit_requested.store(true); });
+        std::signal(SIGTERM, [](int) { exit_requested.store(true); });
+        while (!exit_requested.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+
+        daemon.stop();
+        return 0;
+    } catch (std::exception& ex) {
+        std::cout << ex.what() << std::endl;
+        return -1;
+    }
+}
@@ -0,0 +1,200 @@
+﻿// <copyright file="command_line.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "command_line.h"
+
+
+/*
+ * command_line::command_line
+ */
+command_line::command_line(void)
+    : compress(false), duration(10),
+    format(visus::power_overwhelming::output_format::csv), help(false),
+    interval(visus::power_overwhelming::collector_settings
+        ::default_sampling_interval),
+    output(L"podump.csv"), overhead(false), rotate_interval(0),
+    rotate_size(0), statistics(1000) { }
+
+
+/*
+ * ::parse_command_line
+ */
+command_line parse_command_line(const int argc, const TCHAR **argv) {
+    using namespace visus::power_overwhelming;
+    command_line retval;
+
+    for (int i = 1; i < argc; ++i) {
+        const auto arg = convert_string<wchar_t>(argv[i]);
+
+        // Retrieves the value of the current option.
+        auto value = [&](void) {
+            if (++i >= argc) {
+                throw std::invalid_argument("The value of a command line "
+                    "option is missing.");
+            }
+            return convert_string<wchar_t>(argv[i]);
+        };
+
+        // Retrieves the value of the current option as unsigned number.
+        auto number = [&](void) {
+            const auto v = value();
+            std::size_t end = 0;
+            unsigned long long n = 0;
+            try {
+                n = std::stoull(v, &end);
+            } catch (std::exception&) {
+                end = 0;
+            }
+            if (v.empty() || (end != v.size()) || (v[0] == L'-')) {
+                throw std::invalid_argument("The value of a command line "
+                    "option is not a positive number.");
+            }
+            return n;
+        };
+
+        if ((arg == L"-c") || (arg == L"--config")) {
+            retval.config = value();
+
+        } else if ((arg == L"-d") || (arg == L"--duration")) {
+            retval.duration = static_cast<unsigned int>(number());
+            if (retval.duration == 0) {
+                throw std::invalid_argument("The duration of the recording "
+                    "must be positive.");
+            }
+
+        } else if ((arg == L"-f") || (arg == L"--format")) {
+            const auto f = value();
+            if (f == L"csv") {
+                retval.format = output_format::csv;
+            } else if (f == L"binary") {
+                retval.format = output_format::binary;
+            } else if (f == L"async") {
+                retval.format = output_format::async_binary;
+            } else if (f == L"direct") {
+                retval.format = output_format::direct_binary;
+            } else if (f == L"mapped") {
+                retval.format = output_format::mapped_binary;
+            } else if (f == L"network") {
+                retval.format = output_format::network_binary;
+            } else if (f == L"perfetto") {
+                retval.format = output_format::perfetto;
+            } else if (f == L"chrome") {
+                retval.format = output_format::chrome_trace;
+            } else if (f == L"arrow") {
+                retval.format = output_format::arrow;
+            } else if (f == L"wide") {
+                retval.format = output_format::wide_csv;
+            } else {
+                throw std::invalid_argument("The output format must be one of "
+                    "\"csv\", \"binary\", \"async\", \"direct\", "
+                    "\"mapped\", \"network\", \"perfetto\", \"chrome\", "
+                    "\"arrow\" or \"wide\".");
+            }
+
+        } else if ((arg == L"-h") || (arg == L"--help")) {
+            retval.help = true;
+
+        } else if ((arg == L"-i") || (arg == L"--interval")) {
+            retval.interval = static_cast<sensor::microseconds_type>(number());
+            if (retval.interval <= 0) {
+                throw std::invalid_argument("The sampling interval must be "
+                    "positive.");
+            }
+
+        } else if ((arg == L"-n") || (arg == L"--names")) {
+            retval.names = value();
+
+        } else if ((arg == L"-o") || (arg == L"--output")) {
+            retval.output = value();
+
+        } else if ((arg == L"-r") || (arg == L"--overhead")) {
+            retval.overhead = true;
+
+        } else if (arg == L"--rotate-interval") {
+            retval.rotate_interval = static_cast<unsigned int>(number());
+
+        } else if (arg == L"--rotate-size") {
+            retval.rotate_size = static_cast<unsigned int>(number());
+
+        } else if ((arg == L"-s") || (arg == L"--statistics")) {
+            retval.statistics = static_cast<unsigned int>(number());
+
+        } else if ((arg == L"-t") || (arg == L"--types")) {
+            retval.types = value();
+
+        } else if ((arg == L"-z") || (arg == L"--compress")) {
+            retval.compress = true;
+
+        } else {
+            throw std::invalid_argument("An unknown command line option was "
+                "specified.");
+        }
+    }
+
+    if (retval.compress && ((retval.format == output_format::csv)
+            || (retval.format == output_format::wide_csv)
+            || (retval.format == output_format::perfetto)
+            || (retval.format == output_format::chrome_trace)
+            || (retval.format == output_format::arrow))) {
+        throw std::invalid_argument("Only the binary output formats can be "
+            "compressed.");
+    }
+
+    if (((retval.rotate_interval > 0) || (retval.rotate_size > 0))
+            && ((retval.format == output_format::network_binary)
+            || (retval.format == output_format::perfetto)
+            || (retval.format == output_format::chrome_trace)
+            || (retval.format == output_format::arrow)
+            || (retval.output == L"-"))) {
+        throw std::invalid_argument("Only the CSV and the binary output to "
+            "files can be rotated.");
+    }
+
+    return retval;
+}
+
+
+/*
+ * ::print_usage
+ */
+void print_usage(std::ostream& stream) {
+    stream << "Usage: podump [options]" << std::endl
+        << std::endl
+        << "Records the samples of the selected sensors." << std::endl
+        << std::endl
+        << "  -c, --config <path>     Load the sensors and the settings from "
+            "a JSON" << std::endl
+        << "                          configuration, which replaces the "
+            "options below." << std::endl
+        << "  -t, --types <regex>     Record sensors of matching types, e.g. "
+            "nvml_sensor." << std::endl
+        << "  -n, --names <regex>     Record sensors with matching names."
+            << std::endl
+        << "  -i, --interval <us>     The sampling interval in microseconds."
+            << std::endl
+        << "  -o, --output <path>     The output path, \"-\" for the standard "
+            "output or" << std::endl
+        << "                          host:port for the network output."
+            << std::endl
+        << "  -f, --format <format>   csv, binary, async, direct, mapped, "
+            << std::endl
+        << "                          network, perfetto, chrome, arrow or "
+            "wide."
+            << std::endl
+        << "  -z, --compress          Compress the binary output."
+            << std::endl
+        << "  -r, --overhead          Record the overhead of the collector."
+            << std::endl
+        << "  --rotate-interval <s>   Continue in a new file after the given "
+            "time." << std::endl
+        << "  --rotate-size <MiB>     Continue in a new file after the given "
+            "size." << std::endl
+        << "  -d, --duration <s>      The duration of the recording in "
+            "seconds." << std::endl
+        << "  -s, --statistics <ms>   The interval of the live statistics, 0 "
+            "to disable." << std::endl
+        << "  -h, --help              Print this help." << std::endl;
+}
@@ -0,0 +1,107 @@
+﻿// <copyright file="command_line.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+
+/// <summary>
+/// The options of a recording passed on the command line.
+/// </summary>
+struct command_line final {
+
+    /// <summary>
+    /// Compress the binary output.
+    /// </summary>
+    bool compress;
+
+    /// <summary>
+    /// The path to a JSON configuration of the collector, which replaces
+    /// the selection of the sensors and the output settings.
+    /// </summary>
+    std::wstring config;
+
+    /// <summary>
+    /// The duration of the recording in seconds.
+    /// </summary>
+    unsigned int duration;
+
+    /// <summary>
+    /// The format of the output.
+    /// </summary>
+    visus::power_overwhelming::output_format format;
+
+    /// <summary>
+    /// Print the usage and exit.
+    /// </summary>
+    bool help;
+
+    /// <summary>
+    /// The sampling interval in microseconds.
+    /// </summary>
+    visus::power_overwhelming::sensor::microseconds_type interval;
+
+    /// <summary>
+    /// The pattern for the names of the sensors to record, or empty for all
+    /// names.
+    /// </summary>
+    std::wstring names;
+
+    /// <summary>
+    /// The path to the output, <c>-</c> for the standard output.
+    /// </summary>
+    std::wstring output;
+
+    /// <summary>
+    /// Record the estimated overhead of the collector itself.
+    /// </summary>
+    bool overhead;
+
+    /// <summary>
+    /// The time in seconds after which the output is continued in a new
+    /// file, or zero to write a single file.
+    /// </summary>
+    unsigned int rotate_interval;
+
+    /// <summary>
+    /// The size in MiB after which the output is continued in a new file, or
+    /// zero to write a single file.
+    /// </summary>
+    unsigned int rotate_size;
+
+    /// <summary>
+    /// The interval in milliseconds in which the throughput is printed, or
+    /// zero to only print it at the end.
+    /// </summary>
+    unsigned int statistics;
+
+    /// <summary>
+    /// The pattern for the types of the sensors to record, for instance
+    /// <c>nvml_sensor|adl_sensor</c>, or empty for all types.
+    /// </summary>
+    std::wstring types;
+
+    /// <summary>
+    /// Initialises the default options.
+    /// </summary>
+    command_line(void);
+};
+
+
+/// <summary>
+/// Parses the command line of podump.
+/// </summary>
+/// <param name="argc">The number of arguments, including the name of the
+/// program.</param>
+/// <param name="argv">The arguments.</param>
+/// <returns>The options parsed.</returns>
+/// <exception cref="std::invalid_argument">If an option is unknown or its
+/// value is missing or invalid.</exception>
+command_line parse_command_line(const int argc, const TCHAR **argv);
+
+/// <summary>
+/// Prints the usage of podump.
+/// </summary>
+/// <param name="stream">The stream to print to.</param>
+void print_usage(std::ostream& stream);
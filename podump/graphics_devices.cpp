@@ -15,8 +15,8 @@ void enumerate_graphics_devices(void) {
 
     try {
         std::vector<graphics_device> devices;
-        devices.resize(graphics_device::all(nullptr, 0));
-        graphics_device::all(devices.data(), devices.size());
+        devices.resize(graphics_device::adapters(nullptr, 0));
+        graphics_device::adapters(devices.data(), devices.size());
 
         for (auto& d : devices) {
             std::wcout << d.name() << L": " << d.id() << std::endl;
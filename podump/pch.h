@@ -5,7 +5,11 @@
 
 #pragma once
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <stdexcept>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -17,6 +21,7 @@
 #include "power_overwhelming/adl_sensor.h"
 #include "power_overwhelming/emi_sensor.h"
 #include "power_overwhelming/collector.h"
+#include "power_overwhelming/convert_string.h"
 #include "power_overwhelming/graphics_device.h"
 #include "power_overwhelming/hmc8015_sensor.h"
 #include "power_overwhelming/measurement.h"
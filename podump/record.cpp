@@ -0,0 +1,118 @@
+﻿// <copyright file="record.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "record.h"
+
+
+/*
+ * ::record
+ */
+int record(const command_line& options) {
+    using namespace visus::power_overwhelming;
+    typedef std::chrono::steady_clock clock_type;
+
+    collector collector;
+
+    if (options.config.empty()) {
+        // The standard output is opened like any other file, which the
+        // collector cannot distinguish from the path of a file.
+#if defined(_WIN32)
+        const auto output = (options.output == L"-")
+            ? std::wstring(L"CONOUT$")
+            : options.output;
+#else /* defined(_WIN32) */
+        const auto output = (options.output == L"-")
+            ? std::wstring(L"/dev/stdout")
+            : options.output;
+#endif /* defined(_WIN32) */
+
+        collector_settings settings;
+        settings.compress_output(options.compress)
+            .output_format(options.format)
+            .output_path(output.c_str())
+            .record_overhead(options.overhead)
+            .rotate_interval(static_cast<sensor::microseconds_type>(
+                options.rotate_interval) * 1000 * 1000)
+            .rotate_size(static_cast<std::uint64_t>(options.rotate_size)
+                << 20)
+            .sampling_interval(options.interval);
+
+        sensor_filter filter;
+        if (!options.names.empty()) {
+            filter.name(options.names.c_str());
+        }
+        if (!options.types.empty()) {
+            filter.type(options.types.c_str());
+        }
+
+        collector = collector::for_all(settings, filter);
+
+    } else {
+        collector = collector::from_json(options.config.c_str());
+    }
+
+    if (collector.size() == 0) {
+        std::cerr << "No sensor has been selected." << std::endl;
+        return 1;
+    }
+
+    std::cerr << "Recording " << collector.size() << " sensor(s) for "
+        << options.duration << " s ..." << std::endl;
+
+    const auto begin = clock_type::now();
+    const auto end = begin + std::chrono::seconds(options.duration);
+    auto last = begin;
+    std::uint64_t last_samples = 0;
+
+    collector.start();
+
+    // Print the throughput since the last report without stopping the
+    // collector, such that the statistics do not disturb the recording.
+    while (clock_type::now() < end) {
+        auto next = end;
+        if (options.statistics > 0) {
+            next = (std::min)(end, last
+                + std::chrono::milliseconds(options.statistics));
+        }
+        std::this_thread::sleep_until(next);
+
+        const auto now = clock_type::now();
+        if ((options.statistics > 0) && (now < end)) {
+            const auto statistics = collector.statistics();
+            const auto samples = statistics.samples();
+            const auto dt = std::chrono::duration<double>(now - last).count();
+            std::cerr << std::chrono::duration_cast<std::chrono::milliseconds>(
+                    now - begin).count() << " ms: "
+                << samples << " samples, "
+                << static_cast<std::uint64_t>((samples - last_samples) / dt)
+                << " samples/s, "
+                << statistics.dropped() << " dropped, "
+                << statistics.backlog() << " pending, "
+                << (statistics.bytes_written() >> 10) << " KiB written"
+                << std::endl;
+            last = now;
+            last_samples = samples;
+        }
+    }
+
+    collector.stop();
+
+    const auto elapsed = std::chrono::duration<double>(
+        clock_type::now() - begin).count();
+    const auto samples = collector.samples();
+    const auto dropped = collector.overflows();
+    const auto total = samples + dropped;
+
+    std::cerr << "Recorded " << samples << " samples in " << elapsed << " s ("
+        << static_cast<std::uint64_t>(samples / elapsed) << " samples/s), "
+        << dropped << " dropped";
+    if (total > 0) {
+        std::cerr << " (" << (100.0 * dropped / total) << " %)";
+    }
+    std::cerr << "." << std::endl;
+
+    return (dropped > 0) ? 1 : 0;
+}
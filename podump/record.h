@@ -0,0 +1,23 @@
+﻿// <copyright file="record.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "command_line.h"
+
+
+/// <summary>
+/// Records the samples of the sensors selected on the command line and prints
+/// the throughput of the collector to <c>stderr</c>.
+/// </summary>
+/// <remarks>
+/// The recording uses the same code paths as any other application using
+/// the <see cref="visus::power_overwhelming::collector" />, wherefore the
+/// statistics can be used to benchmark the overhead of sampling on the
+/// machine.
+/// </remarks>
+/// <param name="options">The options of the recording.</param>
+/// <returns>Zero if no sample has been dropped, one otherwise.</returns>
+int record(const command_line& options);
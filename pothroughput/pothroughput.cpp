@@ -0,0 +1,340 @@
+﻿// <copyright file="pothroughput.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/collector.h"
+#include "power_overwhelming/convert_string.h"
+#include "power_overwhelming/library_threads.h"
+#include "power_overwhelming/sampler_statistics.h"
+#include "power_overwhelming/synthetic_sensor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tcp_drain.h"
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <tchar.h>
+#endif /* defined(_WIN32) */
+
+#if !defined(_tmain)
+#define _tmain main
+#define TCHAR char
+#define _T(x) (x)
+#endif /* !defined(_tmain) */
+
+
+/// <summary>
+/// The names of the sinks the collector can be benchmarked with.
+/// </summary>
+static const wchar_t *const sink_names[] = {
+    L"csv", L"binary", L"compressed", L"network", L"wide"
+};
+
+
+/// <summary>
+/// The results of a single configuration of the benchmark.
+/// </summary>
+struct run_result {
+    std::uint64_t bytes;
+    std::uint64_t dropped;
+    double elapsed;
+    double jitter_max;
+    double jitter_mean;
+    double jitter_p99;
+    std::uint64_t missed_deadlines;
+    std::uint64_t samples;
+    double writer_cpu;
+};
+
+
+/// <summary>
+/// Parses a comma-separated list of positive numbers.
+/// </summary>
+static std::vector<std::uint64_t> parse_numbers(const std::wstring& list) {
+    std::vector<std::uint64_t> retval;
+    std::wstringstream stream(list);
+    std::wstring token;
+
+    while (std::getline(stream, token, L',')) {
+        const auto value = std::stoull(token);
+        if (value == 0) {
+            throw std::invalid_argument("All numbers must be positive.");
+        }
+        retval.push_back(value);
+    }
+
+    return retval;
+}
+
+
+/// <summary>
+/// Parses a comma-separated list of sink names into indices into
+/// <see cref="sink_names" />.
+/// </summary>
+static std::vector<std::size_t> parse_sinks(const std::wstring& list) {
+    std::vector<std::size_t> retval;
+    std::wstringstream stream(list);
+    std::wstring token;
+
+    while (std::getline(stream, token, L',')) {
+        auto it = std::find_if(std::begin(sink_names), std::end(sink_names),
+            [&token](const wchar_t *n) { return (token == n); });
+        if (it == std::end(sink_names)) {
+            throw std::invalid_argument("An unknown sink was specified.");
+        }
+        retval.push_back(std::distance(std::begin(sink_names), it));
+    }
+
+    return retval;
+}
+
+
+/// <summary>
+/// Answer the CPU time of the library threads that write the output in
+/// nanoseconds.
+/// </summary>
+static std::uint64_t writer_cpu_time(void) {
+    static const char *const writers[] = {
+        "PwrOwg Collector Writer Thread",
+        "PwrOwg Network Output Thread"
+    };
+
+    const auto cnt = visus::power_overwhelming::get_library_thread_cpu_times(
+        nullptr, nullptr, 0);
+    std::vector<const char *> names(cnt);
+    std::vector<std::uint64_t> times(cnt);
+    const auto actual = visus::power_overwhelming::get_library_thread_cpu_times(
+        names.data(), times.data(), cnt);
+
+    std::uint64_t retval = 0;
+    for (std::size_t i = 0; i < (std::min)(cnt, actual); ++i) {
+        for (auto w : writers) {
+            if ((names[i] != nullptr) && (std::strcmp(names[i], w) == 0)) {
+                retval += times[i];
+            }
+        }
+    }
+
+    return retval;
+}
+
+
+/// <summary>
+/// Runs a collector with the given number of synthetic sensors for the given
+/// time and collects the statistics about its pipeline.
+/// </summary>
+static run_result run(const std::size_t sensors,
+        const std::uint64_t interval,
+        const std::size_t sink,
+        const std::chrono::seconds duration,
+        const std::wstring& output,
+        tcp_drain& drain) {
+    using namespace visus::power_overwhelming;
+    const auto is_network = (std::wcscmp(sink_names[sink], L"network") == 0);
+    run_result retval { };
+
+    collector_settings settings;
+    settings.sampling_interval(interval)
+        .require_marker(false)
+        .compress_output(std::wcscmp(sink_names[sink], L"compressed") == 0);
+
+    if (is_network) {
+        settings.output_format(output_format::network_binary)
+            .output_path(drain.address().c_str());
+    } else if (std::wcscmp(sink_names[sink], L"csv") == 0) {
+        settings.output_format(output_format::csv)
+            .output_path(output.c_str());
+    } else if (std::wcscmp(sink_names[sink], L"wide") == 0) {
+        settings.output_format(output_format::wide_csv)
+            .output_path(output.c_str());
+    } else {
+        settings.output_format(output_format::binary)
+            .output_path(output.c_str());
+    }
+
+    std::vector<synthetic_sensor> instances;
+    instances.reserve(sensors);
+    for (std::size_t i = 0; i < sensors; ++i) {
+        const auto name = L"synthetic" + std::to_wstring(i);
+        instances.emplace_back(name.c_str());
+    }
+
+    auto collector = collector::from_sensor_lists(settings,
+        std::move(instances));
+
+    drain.reset();
+    sampler_statistics::reset_all();
+    const auto cpu_begin = writer_cpu_time();
+
+    collector.start();
+    std::this_thread::sleep_for(duration);
+
+    // The threads of the collector exit when it is stopped, so all of the
+    // counters must be retrieved while it is still running.
+    const auto cpu_end = writer_cpu_time();
+    const auto statistics = collector.statistics();
+    collector.stop();
+
+    retval.bytes = is_network ? drain.received() : statistics.bytes_written();
+    retval.dropped = statistics.dropped();
+    retval.elapsed = static_cast<double>(statistics.elapsed()) / 1000000.0;
+    retval.samples = statistics.samples();
+    retval.writer_cpu = (retval.elapsed > 0.0)
+        ? 100.0 * (cpu_end - cpu_begin) / (retval.elapsed * 1000000000.0)
+        : 0.0;
+
+    // Combine the jitter of all sampler contexts, which is dominated by the
+    // worst one.
+    {
+        const auto cnt = sampler_statistics::for_all(nullptr, 0);
+        std::vector<sampler_statistics> contexts(cnt);
+        sampler_statistics::for_all(contexts.data(), contexts.size());
+
+        std::uint64_t ticks = 0;
+        for (auto& c : contexts) {
+            if (!c) {
+                continue;
+            }
+
+            const auto& j = c.jitter();
+            retval.jitter_max = (std::max)(retval.jitter_max,
+                static_cast<double>(j.max()) / 1000.0);
+            retval.jitter_mean += j.mean() * j.count() / 1000.0;
+            retval.jitter_p99 = (std::max)(retval.jitter_p99,
+                static_cast<double>(j.percentile(0.99)) / 1000.0);
+            retval.missed_deadlines += c.missed_deadlines();
+            ticks += j.count();
+        }
+
+        if (ticks > 0) {
+            retval.jitter_mean /= ticks;
+        }
+    }
+
+    return retval;
+}
+
+
+/// <summary>
+/// Entry point of the pothroughput application, which measures the sustained
+/// throughput of the whole pipeline of a collector fed by synthetic sensors.
+/// </summary>
+/// <param name="argc"></param>
+/// <param name="argv"></param>
+/// <returns></returns>
+int _tmain(const int argc, const TCHAR **argv) {
+    using namespace visus::power_overwhelming;
+
+    std::wcerr << L"pothroughput" << std::endl;
+    std::wcerr << L"© 2023 Visualisierungsinstitut der Universität Stuttgart."
+        << std::endl << L"All rights reserved."
+        << std::endl << std::endl;
+
+    const std::vector<std::basic_string<TCHAR>> cmd_line(argv, argv + argc);
+    std::chrono::seconds duration(10);
+    std::vector<std::uint64_t> intervals { 1000 };
+    std::wstring output(L"pothroughput.out");
+    std::vector<std::uint64_t> sensors { 1, 10, 100 };
+    auto show_help = false;
+    std::vector<std::size_t> sinks { 0, 1, 2, 3, 4 };
+
+    // All options expect a value, most of them a comma-separated list.
+    try {
+        for (auto it = cmd_line.begin() + 1; it != cmd_line.end(); ++it) {
+            if ((it + 1) == cmd_line.end()) {
+                show_help = true;
+                break;
+            }
+
+            const auto value = convert_string<wchar_t>(*(it + 1));
+            if (*it == _T("--duration")) {
+                duration = std::chrono::seconds(parse_numbers(value).at(0));
+            } else if (*it == _T("--intervals")) {
+                intervals = parse_numbers(value);
+            } else if (*it == _T("--output")) {
+                output = value;
+            } else if (*it == _T("--sensors")) {
+                sensors = parse_numbers(value);
+            } else if (*it == _T("--sinks")) {
+                sinks = parse_sinks(value);
+            } else {
+                show_help = true;
+                break;
+            }
+
+            ++it;
+        }
+    } catch (...) {
+        show_help = true;
+    }
+
+    if (show_help) {
+        // Input is wrong, so show the help.
+        std::wcerr << L"Runs a collector with synthetic sensors for each "
+            << L"combination of the number of" << std::endl
+            << L"sensors, the sampling interval in microseconds and the sink, "
+            << L"and writes the" << std::endl
+            << L"sustained throughput, the drop rate, the jitter of the "
+            << L"sampler ticks, the CPU" << std::endl
+            << L"load of the writer and the size per sample as CSV to the "
+            << L"standard output." << std::endl << std::endl;
+        std::wcerr << L"Usage: pothroughput [--sensors <n,...>] "
+            << L"[--intervals <microseconds,...>]" << std::endl
+            << L"    [--sinks <csv|binary|compressed|network|wide,...>] "
+            << L"[--duration <seconds>]" << std::endl
+            << L"    [--output <path>]" << std::endl;
+        return -2;
+    }
+
+    try {
+        tcp_drain drain;
+
+        std::wcout << L"sensors,interval,sink,elapsed,samples,samples_per_s,"
+            << L"dropped,drop_rate,jitter_mean_us,jitter_p99_us,"
+            << L"jitter_max_us,missed_deadlines,writer_cpu_percent,"
+            << L"bytes_per_sample" << std::endl;
+
+        for (auto n : sensors) {
+            for (auto i : intervals) {
+                for (auto s : sinks) {
+                    std::wcerr << n << L" sensors at " << i << L" µs into "
+                        << sink_names[s] << L" ..." << std::endl;
+                    const auto r = run(n, i, s, duration, output, drain);
+                    const auto total = r.samples + r.dropped;
+
+                    std::wcout << n << L"," << i << L"," << sink_names[s]
+                        << L"," << r.elapsed
+                        << L"," << r.samples
+                        << L"," << ((r.elapsed > 0.0)
+                            ? r.samples / r.elapsed : 0.0)
+                        << L"," << r.dropped
+                        << L"," << ((total > 0)
+                            ? static_cast<double>(r.dropped) / total : 0.0)
+                        << L"," << r.jitter_mean
+                        << L"," << r.jitter_p99
+                        << L"," << r.jitter_max
+                        << L"," << r.missed_deadlines
+                        << L"," << r.writer_cpu
+                        << L"," << ((r.samples > 0)
+                            ? static_cast<double>(r.bytes) / r.samples : 0.0)
+                        << std::endl;
+                }
+            }
+        }
+
+        return 0;
+    } catch (std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return -1;
+    }
+}
@@ -0,0 +1,136 @@
+﻿// <copyright file="tcp_drain.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "tcp_drain.h"
+
+#include <cerrno>
+#include <system_error>
+#include <vector>
+
+#if defined(_WIN32)
+#include <WS2tcpip.h>
+#else /* defined(_WIN32) */
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif /* defined(_WIN32) */
+
+
+#if defined(_WIN32)
+#define close_socket(s) ::closesocket(s)
+#define last_socket_error() ::WSAGetLastError()
+#else /* defined(_WIN32) */
+#define INVALID_SOCKET (-1)
+#define close_socket(s) ::close(s)
+#define last_socket_error() errno
+#endif /* defined(_WIN32) */
+
+
+/*
+ * tcp_drain::tcp_drain
+ */
+tcp_drain::tcp_drain(void) : _port(0), _received(0), _running(true) {
+#if defined(_WIN32)
+    {
+        WSADATA wsa_data;
+        const auto status = ::WSAStartup(MAKEWORD(2, 2), &wsa_data);
+        if (status != 0) {
+            throw std::system_error(status, std::system_category());
+        }
+    }
+#endif /* defined(_WIN32) */
+
+    this->_listener = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (this->_listener == INVALID_SOCKET) {
+        throw std::system_error(last_socket_error(), std::system_category());
+    }
+
+    sockaddr_in address { };
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    socklen_t length = sizeof(address);
+
+    if ((::bind(this->_listener, reinterpret_cast<sockaddr *>(&address),
+                sizeof(address)) != 0)
+            || (::listen(this->_listener, 1) != 0)
+            || (::getsockname(this->_listener,
+                reinterpret_cast<sockaddr *>(&address), &length) != 0)) {
+        const auto error = last_socket_error();
+        close_socket(this->_listener);
+        throw std::system_error(error, std::system_category());
+    }
+
+    this->_port = ntohs(address.sin_port);
+    this->_thread = std::thread(&tcp_drain::receive, this);
+}
+
+
+/*
+ * tcp_drain::~tcp_drain
+ */
+tcp_drain::~tcp_drain(void) {
+    this->_running.store(false);
+
+    // Wake the thread from accept by connecting to ourselves.
+    {
+        auto s = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (s != INVALID_SOCKET) {
+            sockaddr_in address { };
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            address.sin_port = htons(this->_port);
+            ::connect(s, reinterpret_cast<sockaddr *>(&address),
+                sizeof(address));
+            close_socket(s);
+        }
+    }
+
+    if (this->_thread.joinable()) {
+        this->_thread.join();
+    }
+
+    close_socket(this->_listener);
+
+#if defined(_WIN32)
+    ::WSACleanup();
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * tcp_drain::address
+ */
+std::wstring tcp_drain::address(void) const {
+    return L"127.0.0.1:" + std::to_wstring(this->_port);
+}
+
+
+/*
+ * tcp_drain::receive
+ */
+void tcp_drain::receive(void) {
+    std::vector<char> buffer(64 * 1024);
+
+    while (this->_running.load()) {
+        auto client = ::accept(this->_listener, nullptr, nullptr);
+        if (client == INVALID_SOCKET) {
+            continue;
+        }
+
+        while (true) {
+            const auto cnt = ::recv(client, buffer.data(),
+                static_cast<int>(buffer.size()), 0);
+            if (cnt <= 0) {
+                break;
+            }
+
+            this->_received.fetch_add(cnt, std::memory_order_relaxed);
+        }
+
+        close_socket(client);
+    }
+}
@@ -0,0 +1,84 @@
+﻿// <copyright file="tcp_drain.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <cinttypes>
+#include <string>
+#include <thread>
+
+#if defined(_WIN32)
+#include <WinSock2.h>
+#endif /* defined(_WIN32) */
+
+
+/// <summary>
+/// A TCP server on the loopback interface that receives the output of a
+/// collector in the <c>network_binary</c> format and discards it.
+/// </summary>
+/// <remarks>
+/// The drain accepts one connection after the other and only counts the
+/// bytes it receives, such that the benchmark measures the cost of sending
+/// rather than the cost of a remote host storing the data.
+/// </remarks>
+class tcp_drain final {
+
+public:
+
+#if defined(_WIN32)
+    typedef SOCKET socket_type;
+#else /* defined(_WIN32) */
+    typedef int socket_type;
+#endif /* defined(_WIN32) */
+
+    /// <summary>
+    /// Starts listening on an ephemeral port of the loopback interface.
+    /// </summary>
+    /// <exception cref="std::system_error">If the socket could not be
+    /// created.</exception>
+    tcp_drain(void);
+
+    tcp_drain(const tcp_drain&) = delete;
+
+    /// <summary>
+    /// Finalises the instance.
+    /// </summary>
+    ~tcp_drain(void);
+
+    /// <summary>
+    /// Answer the address of the drain in the form expected as output path
+    /// of a collector.
+    /// </summary>
+    /// <returns>The address of the drain.</returns>
+    std::wstring address(void) const;
+
+    /// <summary>
+    /// Answer the number of bytes received so far.
+    /// </summary>
+    /// <returns>The number of bytes received.</returns>
+    inline std::uint64_t received(void) const noexcept {
+        return this->_received.load(std::memory_order_relaxed);
+    }
+
+    /// <summary>
+    /// Resets the counter of received bytes.
+    /// </summary>
+    inline void reset(void) noexcept {
+        this->_received.store(0, std::memory_order_relaxed);
+    }
+
+    tcp_drain& operator =(const tcp_drain&) = delete;
+
+private:
+
+    void receive(void);
+
+    socket_type _listener;
+    std::uint16_t _port;
+    std::atomic<std::uint64_t> _received;
+    std::atomic<bool> _running;
+    std::thread _thread;
+};
@@ -13,6 +13,9 @@ static constexpr const char *FIELD_BLANK_PAGE = "blankPage";
 static constexpr const char *FIELD_COOL_DOWN = "coolDown";
 static constexpr const char *FIELD_INITIAL_WAIT = "initialWait";
 static constexpr const char *FIELD_ITERATIONS = "iterations";
+static constexpr const char *FIELD_MIN_ITERATIONS = "minIterations";
+static constexpr const char *FIELD_PRE_WARM = "preWarm";
+static constexpr const char *FIELD_RELATIVE_ERROR = "relativeError";
 static constexpr const char *FIELD_ROOT = "poweb";
 static constexpr const char *FIELD_URLS = "urls";
 static constexpr const char *FIELD_VISIBLE_PERIOD = "visiblePeriod";
@@ -22,14 +25,15 @@ static constexpr const char *FIELD_VISIBLE_PERIOD = "visiblePeriod";
  * Configuration::Configuration
  */
 Configuration::Configuration(void) : _blankPage(L"about:blank"), _coolDown(0),
-    _initialWait(0), _iterations(0), _visiblePeriod(0) { }
+    _initialWait(0), _iterations(0), _minIterations(2), _preWarm(false),
+    _relativeError(0.0), _visiblePeriod(0) { }
 
 
 /*
  * Configuration::Configuration
  */
 Configuration::Configuration(const std::wstring& path)
-        : _collector(collector::from_json(path.c_str())) {
+        : _collector(collector::from_json(path.c_str(), true)) {
     std::ifstream stream(path);
     assert(stream.good());
     nlohmann::json config;
@@ -44,6 +48,11 @@ Configuration::Configuration(const std::wstring& path)
     this->_initialWait = decltype(this->_initialWait)(
         webConfig[FIELD_INITIAL_WAIT].get<std::uint64_t>());
     this->_iterations = webConfig[FIELD_ITERATIONS].get<std::uint32_t>();
+    // The confidence interval cannot be computed from a single iteration.
+    this->_minIterations = (std::max)(webConfig.value(FIELD_MIN_ITERATIONS,
+        std::uint32_t(2)), std::uint32_t(2));
+    this->_preWarm = webConfig.value(FIELD_PRE_WARM, false);
+    this->_relativeError = webConfig.value(FIELD_RELATIVE_ERROR, 0.0);
 
     {
         auto urls = webConfig[FIELD_URLS].get<std::vector<std::string>>();
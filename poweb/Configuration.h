@@ -65,11 +65,53 @@ public:
     /// <summary>
     /// Gets the number of iterations for each URL.
     /// </summary>
+    /// <remarks>
+    /// If <see cref="GetRelativeError" /> is positive, this is the maximum
+    /// number of iterations.
+    /// </remarks>
     /// <returns></returns>
     inline std::uint32_t GetIterations(void) const noexcept {
         return this->_iterations;
     }
 
+    /// <summary>
+    /// Gets the minimum number of iterations for each URL if the iterations
+    /// are repeated until the energy is known with the
+    /// <see cref="GetRelativeError" />.
+    /// </summary>
+    /// <returns></returns>
+    inline std::uint32_t GetMinIterations(void) const noexcept {
+        return this->_minIterations;
+    }
+
+    /// <summary>
+    /// Gets whether each URL should be visited once before its iterations.
+    /// </summary>
+    /// <remarks>
+    /// Visiting a page warms up the connections and the processes of the
+    /// browser, which would otherwise only affect the first iteration. The
+    /// visit is marked such that it can be excluded from the measurement.
+    /// </remarks>
+    /// <returns></returns>
+    inline bool GetPreWarm(void) const noexcept {
+        return this->_preWarm;
+    }
+
+    /// <summary>
+    /// Gets the relative half-width of the 95% confidence interval of the
+    /// energy of a page below which no more iterations are run.
+    /// </summary>
+    /// <remarks>
+    /// If the relative error is zero, each URL is visited
+    /// <see cref="GetIterations" /> times. Otherwise, the energy of each
+    /// iteration is retrieved from the collector, which requires its energy
+    /// integration to be enabled.
+    /// </remarks>
+    /// <returns></returns>
+    inline double GetRelativeError(void) const noexcept {
+        return this->_relativeError;
+    }
+
     /// <summary>
     /// Gets the URLs that should be visited.
     /// </summary>
@@ -121,6 +163,9 @@ private:
     std::chrono::milliseconds _coolDown;
     std::chrono::milliseconds _initialWait;
     std::uint32_t _iterations;
+    std::uint32_t _minIterations;
+    bool _preWarm;
+    double _relativeError;
     std::vector<std::wstring> _urls;
     std::chrono::milliseconds _visiblePeriod;
 };
@@ -16,13 +16,33 @@
 // next page.
 #define WM_NAVIGATE (WM_USER + 0)
 
+// A user-defined window message instructing the STA thread to replace the
+// markers set by the events of the browser.
+#define WM_SETMARKERS (WM_USER + 1)
+
+// The web message posted by FIRST_PAINT_SCRIPT.
+#define FIRST_PAINT_MESSAGE L"poweb:first-paint"
+
+// A script injected into each document that reports its first contentful
+// paint, which is not exposed as an event of the browser.
+static constexpr const wchar_t *FIRST_PAINT_SCRIPT
+    = L"new PerformanceObserver(function (list) {"
+    L"  list.getEntries().forEach(function (e) {"
+    L"    if (e.name === 'first-contentful-paint') {"
+    L"      window.chrome.webview.postMessage('" FIRST_PAINT_MESSAGE L"');"
+    L"    }"
+    L"  });"
+    L"}).observe({ type: 'paint', buffered: true });";
+
 
 /*
  * Controller::Controller
  */
 Controller::Controller(void)
-        : _hEvent(::CreateEvent(nullptr, FALSE, FALSE, nullptr)),
-    _hWnd(NULL), _tokNavCompleted({}), _tokNavStarting({}) {
+        : _collector(nullptr),
+        _hEvent(::CreateEvent(nullptr, FALSE, FALSE, nullptr)),
+        _hWnd(NULL), _markers({}), _nextMarkers({}), _tokNavCompleted({}),
+        _tokNavStarting({}), _tokWebMessage({}) {
     if (this->_hEvent == NULL) {
         throw std::system_error(::GetLastError(), std::system_category());
     }
@@ -92,6 +112,15 @@ void Controller::Start(HINSTANCE hInstance, const std::wstring& configFile,
                 this, &Controller::OnNavigationCompleted).Get(),
                 &this->_tokNavCompleted);
 
+            // The first paint can only be observed from within the page,
+            // which reports it via a web message.
+            this->_webView->AddScriptToExecuteOnDocumentCreated(
+                FIRST_PAINT_SCRIPT, nullptr);
+            this->_webView->add_WebMessageReceived(
+                Microsoft::WRL::Callback<ICoreWebView2WebMessageReceivedEventHandler>(
+                this, &Controller::OnWebMessageReceived).Get(),
+                &this->_tokWebMessage);
+
             // Signal to worker that we are ready.
             ::SetEvent(this->_hEvent);
 
@@ -150,9 +179,14 @@ LRESULT Controller::WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             break;
 
         case WM_NAVIGATE:
+            that->_markers = that->_nextMarkers;
             that->_webView->Navigate(that->_url.c_str());
             break;
 
+        case WM_SETMARKERS:
+            that->_markers = that->_nextMarkers;
+            break;
+
         case WM_SIZE:
             that->SyncViewSize();
             break;
@@ -236,8 +270,12 @@ void Controller::CreateWnd(HINSTANCE hInstance) {
 /*
  * Controller::Navigate
  */
-void Controller::Navigate(const std::wstring& url) {
+void Controller::Navigate(const std::wstring& url,
+        const PageMarkers& markers) {
     if (!url.empty()) {
+        // The markers are only handed over to the STA thread, which is
+        // the one raising the events, along with the navigation.
+        this->_nextMarkers = markers;
         this->_url = url;
         ::SendMessage(this->_hWnd, WM_NAVIGATE, 0, 0);
     }
@@ -252,6 +290,7 @@ HRESULT Controller::OnNavigationCompleted(ICoreWebView2 *webView,
     assert(webView != nullptr);
     assert(args != nullptr);
     ::OutputDebugString(_T("Navigation completed.\r\n"));
+    this->SetMarker(this->_markers.Loaded);
     ::SetEvent(this->_hEvent);
     return S_OK;
 }
@@ -265,6 +304,26 @@ HRESULT Controller::OnNavigationStarting(ICoreWebView2 *webView,
     assert(webView != nullptr);
     assert(args != nullptr);
     ::OutputDebugString(_T("Navigation starting.\r\n"));
+    this->SetMarker(this->_markers.Navigating);
+    return S_OK;
+}
+
+
+/*
+ * Controller::OnWebMessageReceived
+ */
+HRESULT Controller::OnWebMessageReceived(ICoreWebView2 *webView,
+        ICoreWebView2WebMessageReceivedEventArgs *args) {
+    assert(webView != nullptr);
+    assert(args != nullptr);
+    wil::unique_cotaskmem_string message;
+
+    if (SUCCEEDED(args->TryGetWebMessageAsString(&message))
+            && (::wcscmp(message.get(), FIRST_PAINT_MESSAGE) == 0)) {
+        ::OutputDebugString(_T("First paint.\r\n"));
+        this->SetMarker(this->_markers.Painted);
+    }
+
     return S_OK;
 }
 
@@ -276,48 +335,122 @@ void Controller::Run(const std::wstring configFile,
         const std::function<void(const Configuration &)> onComplete) {
     try {
         Configuration config(configFile);
+        auto& collector = config.GetCollector();
+
+        // Register all markers in advance such that the events of the browser
+        // only need to record their IDs.
+        auto registerMarker = [&collector](const wchar_t *action,
+                const std::wstring& url) {
+            std::wstringstream ss;
+            ss << action << L" \"" << url << L"\"";
+            return collector.register_marker(ss.str().c_str());
+        };
+
+        const auto waiting = collector.register_marker(L"waiting");
+        PageMarkers blank = { };
+        blank.Navigating = collector.register_marker(L"blank");
+
+        std::vector<PageMarkers> pages(config.GetUrls().size());
+        std::vector<PageMarkers> warmUps(pages.size());
+        for (std::size_t i = 0; i < pages.size(); ++i) {
+            auto& u = config.GetUrls()[i];
+            pages[i].Loaded = registerMarker(L"showing", u);
+            pages[i].Navigating = registerMarker(L"navigating", u);
+            pages[i].Painted = registerMarker(L"painted", u);
+            warmUps[i].Navigating = registerMarker(L"warming up", u);
+        }
 
-        // Wait for the browser to become ready.
-        this->WaitEvent();
-
-        // Start collecting power samples.
-        config.GetCollector().marker(L"waiting");
+        // Start collecting power samples while the browser is still being
+        // created on the STA thread, such that neither waits for the other.
+        // The collector runs for all pages, wherefore the phases are only
+        // delimited by the markers.
+        this->_collector = &collector;
+        collector.marker(waiting);
         config.StartCollector();
 
+        // Wait for the browser to become ready. The browser process is reused
+        // for all pages and iterations.
+        this->WaitEvent();
+
         // Initially wait until the browser stops consuming excessive energy for
         // background initialisation tasks.
         ::OutputDebugString(_T("Initial wait.\r\n"));
         config.WaitInitially();
 
-        // Go through the test URLs.
-        for (auto& u : config.GetUrls()) {
-            for (std::uint32_t i = 0; i < config.GetIterations(); ++i) {
+        // Go through the test URLs. The markers are set by the events of the
+        // browser rather than here, such that the phases begin when the
+        // browser actually starts navigating, has painted the page and has
+        // completed loading it.
+        const auto adaptive = (config.GetRelativeError() > 0.0);
+        for (std::size_t p = 0; p < pages.size(); ++p) {
+            auto& u = config.GetUrls()[p];
+
+            if (config.GetPreWarm()) {
+                ::OutputDebugString(_T("Warm up page.\r\n"));
+                this->Navigate(u, warmUps[p]);
+                this->WaitEvent();
+            }
+
+            // The energy of the page is the sum of the phases of all of its
+            // markers. The collector integrates it online, so an iteration
+            // is the difference of the totals before and after it.
+            auto pageEnergy = [&collector](const PageMarkers& m) {
+                return collector.energy(m.Navigating)
+                    + collector.energy(m.Painted)
+                    + collector.energy(m.Loaded);
+            };
+            auto last = pageEnergy(pages[p]);
+            double mean = 0.0;
+            double m2 = 0.0;
+
+            for (std::uint32_t i = 0; adaptive || (i < config.GetIterations());
+                    ++i) {
                 ::OutputDebugString(_T("Blank page.\r\n"));
-                config.GetCollector().marker(L"blank");
-                this->Navigate(config.GetBlankPage());
+                this->Navigate(config.GetBlankPage(), blank);
                 this->WaitEvent();
                 config.WaitForCoolDown();
 
-                ::OutputDebugString(_T("Navigate to actual page.\r\n"));
-                {
-                    std::wstringstream ss;
-                    ss << L"navigating \"" << u << L"\"" << std::ends;
-                    config.GetCollector().marker(ss.str().c_str());
+                // The blank page has ended the previous iteration, and the
+                // cool-down has given the collector the time to integrate
+                // its last samples, so we can decide whether we are done.
+                if (adaptive && (i > 0)) {
+                    const auto current = pageEnergy(pages[p]);
+                    const auto energy = current - last;
+                    last = current;
+
+                    const auto delta = energy - mean;
+                    mean += delta / i;
+                    m2 += delta * (energy - mean);
+
+                    const auto error = (i > 1)
+                        ? 1.96 * std::sqrt(m2 / (i - 1) / i)
+                        : 0.0;
+                    const auto converged = (i >= config.GetMinIterations())
+                        && (error <= config.GetRelativeError()
+                        * std::abs(mean));
+
+                    if (converged || (i >= config.GetIterations())) {
+                        std::wstringstream ss;
+                        ss << u << L": " << mean << L" J +/- " << error
+                            << L" J after " << i << L" iterations."
+                            << std::endl;
+                        ::OutputDebugStringW(ss.str().c_str());
+                        break;
+                    }
                 }
-                this->Navigate(u);
+
+                ::OutputDebugString(_T("Navigate to actual page.\r\n"));
+                this->Navigate(u, pages[p]);
                 this->WaitEvent();
 
                 ::OutputDebugString(_T("Show actual page.\r\n"));
-                {
-                    std::wstringstream ss;
-                    ss << L"showing \"" << u << L"\"" << std::ends;
-                    config.GetCollector().marker(ss.str().c_str());
-                }
                 config.WaitForVisiblePeriod();
             }
         }
 
-        // Stop collecting power samples.
+        // Make sure that late events do not set any marker before we stop
+        // collecting power samples.
+        this->SetMarkers({ });
         config.StopCollector();
 
         // Notifiy the caller that we are done.
@@ -328,6 +461,32 @@ void Controller::Run(const std::wstring configFile,
 }
 
 
+/*
+ * Controller::SetMarker
+ */
+void Controller::SetMarker(std::uint32_t& marker) {
+    if ((marker != 0) && (this->_collector != nullptr)) {
+        try {
+            this->_collector->marker(marker);
+        } catch (std::exception& ex) {
+            ::OutputDebugStringA(ex.what());
+        }
+
+        // Make sure that repeated events do not set the marker again.
+        marker = 0;
+    }
+}
+
+
+/*
+ * Controller::SetMarkers
+ */
+void Controller::SetMarkers(const PageMarkers& markers) {
+    this->_nextMarkers = markers;
+    ::SendMessage(this->_hWnd, WM_SETMARKERS, 0, 0);
+}
+
+
 /*
  * Controller::SyncViewSize
  */
@@ -51,12 +51,37 @@ public:
 
 private:
 
+    /// <summary>
+    /// The IDs of the markers set by the events of the browser while it
+    /// navigates to a page, or zero if no marker should be set.
+    /// </summary>
+    /// <remarks>
+    /// Each marker is set at most once per navigation, because the events
+    /// might fire multiple times, e.g. for redirects.
+    /// </remarks>
+    struct PageMarkers {
+        /// <summary>
+        /// The marker set once the navigation has completed.
+        /// </summary>
+        std::uint32_t Loaded;
+
+        /// <summary>
+        /// The marker set once the browser starts navigating.
+        /// </summary>
+        std::uint32_t Navigating;
+
+        /// <summary>
+        /// The marker set once the page has been painted for the first time.
+        /// </summary>
+        std::uint32_t Painted;
+    };
+
     static LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam,
         LPARAM lParam);
 
     void CreateWnd(HINSTANCE hInstance);
 
-    void Navigate(const std::wstring& url);
+    void Navigate(const std::wstring& url, const PageMarkers& markers);
 
     HRESULT OnNavigationCompleted(ICoreWebView2 *webView,
         ICoreWebView2NavigationCompletedEventArgs *args);
@@ -64,17 +89,28 @@ private:
     HRESULT OnNavigationStarting(ICoreWebView2 *webView,
         ICoreWebView2NavigationStartingEventArgs *args);
 
+    HRESULT OnWebMessageReceived(ICoreWebView2 *webView,
+        ICoreWebView2WebMessageReceivedEventArgs *args);
+
     void Run(const std::wstring configFile,
         const std::function<void(const Configuration&)> onComplete);
 
+    void SetMarker(std::uint32_t& marker);
+
+    void SetMarkers(const PageMarkers& markers);
+
     void SyncViewSize(void);
 
     bool WaitEvent(void);
 
+    visus::power_overwhelming::collector *_collector;
     HANDLE _hEvent;
     HWND _hWnd;
+    PageMarkers _markers;
+    PageMarkers _nextMarkers;
     EventRegistrationToken _tokNavCompleted;
     EventRegistrationToken _tokNavStarting;
+    EventRegistrationToken _tokWebMessage;
     std::wstring _url;
     wil::com_ptr<ICoreWebView2> _webView;
     wil::com_ptr<ICoreWebView2Controller> _webViewController;
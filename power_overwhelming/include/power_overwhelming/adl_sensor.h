@@ -54,6 +54,31 @@ namespace power_overwhelming {
         static adl_sensor from_index(_In_ const int index,
             _In_ const adl_sensor_source source);
 
+        /// <summary>
+        /// Create a new instance for the device with the specified locally
+        /// unique identifier of its DXGI adapter.
+        /// </summary>
+        /// <remarks>
+        /// The adapter is matched to the ADL adapter via its location on the
+        /// PCI bus, which is only supported on Windows.
+        /// </remarks>
+        /// <param name="luid">The LUID of the adapter as returned by
+        /// <see cref="graphics_device::luid" />.</param>
+        /// <param name="source">The sensor source to retrieve. If the source
+        /// is not supported, the method will fail.</param>
+        /// <returns></returns>
+        /// <exception cref="std::invalid_argument">If the adapter is not an
+        /// AMD device or if the source did not match exactly one sensor.
+        /// </exception>
+        /// <exception cref="std::runtime_error">If the adapter could not be
+        /// found.</exception>
+        /// <exception cref="std::logic_error">If the platform does not
+        /// support LUIDs.</exception>
+        /// <exception cref="adl_exception">If an error occurred in ADL.
+        /// </exception>
+        static adl_sensor from_luid(_In_ const std::uint64_t luid,
+            _In_ const adl_sensor_source source);
+
         /// <summary>
         /// Create a new instance for the unique device ID.
         /// </summary>
@@ -86,6 +111,32 @@ namespace power_overwhelming {
         static adl_sensor from_udid(_In_z_ const wchar_t *udid,
             _In_ const adl_sensor_source source);
 
+        /// <summary>
+        /// Samples all of the given sensors without attaching their names to
+        /// the samples.
+        /// </summary>
+        /// <remarks>
+        /// This is the batch variant of <see cref="sample_data" />, which
+        /// enters the library only once for all sensors of the family.
+        /// </remarks>
+        /// <param name="dst">Receives <paramref name="cnt" /> samples.</param>
+        /// <param name="sensors">The sensors to be sampled.</param>
+        /// <param name="cnt">The number of sensors in
+        /// <paramref name="sensors" />.</param>
+        /// <param name="resolution">The resolution of the timestamps to be
+        /// created. This parameter defaults to
+        /// <see cref="timestamp_resolution::milliseconds" />.</param>
+        /// <exception cref="std::invalid_argument">If <paramref name="dst" />
+        /// or <paramref name="sensors" /> is <c>nullptr</c> while
+        /// <paramref name="cnt" /> is not zero.</exception>
+        /// <exception cref="std::runtime_error">If any of the sensors has been
+        /// moved (and therefore disposed).</exception>
+        static void sample_data(_Out_writes_(cnt) measurement_data *dst,
+            _In_reads_(cnt) const adl_sensor *sensors,
+            _In_ const std::size_t cnt,
+            _In_ const timestamp_resolution resolution
+            = timestamp_resolution::milliseconds);
+
         /// <summary>
         /// Initialises a new instance.
         /// </summary>
@@ -134,13 +185,25 @@ namespace power_overwhelming {
         virtual _Ret_maybenull_z_ const wchar_t *name(
             void) const noexcept override;
 
+        /// <summary>
+        /// Answer the interval at which the driver updates the PMLog of the
+        /// adapter.
+        /// </summary>
+        /// <returns>The update interval in microseconds, or zero if the
+        /// PMLog is not running.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        virtual microseconds_type native_interval(void) const override;
+
         /// <summary>
         /// Asynchronously sample the sensor every
         /// <paramref name="sampling_period "/> microseconds.
         /// </summary>
         /// <remarks>
         /// <para>This method <see cref="start" />s the sensor and regularly
-        /// queries it on a background thread.</para>
+        /// queries it on a background thread. The callback is only invoked if
+        /// the driver has updated the sensor readings since the previous
+        /// sample, so it never receives the same sample twice.</para>
         /// <para>If you have multiple sensors running asynchronously, it is
         /// recommended to use the same <paramref name="sampling_period" /> as
         /// the implementation can use the same background thread in this
@@ -165,8 +228,58 @@ namespace power_overwhelming {
             _In_ const microseconds_type period = default_sampling_period,
             _In_opt_ void *context = nullptr);
 
+        /// <summary>
+        /// Asynchronously sample the sensor every
+        /// <paramref name="sampling_period "/> microseconds and deliver the
+        /// samples in batches.
+        /// </summary>
+        /// <remarks>
+        /// <para>In contrast to <see cref="sample" />, the samples are not
+        /// delivered one-by-one, but the sampler thread collects a batch of
+        /// samples and delivers them at once. This reduces the overhead per
+        /// sample at the cost of delivering the samples with a latency of up
+        /// to ten milliseconds. Any samples that have not yet been delivered
+        /// when the sampling is stopped are delivered on the thread disabling
+        /// the asynchronous sampling.</para>
+        /// </remarks>
+        /// <param name="on_batch">The callback to be invoked if new data
+        /// arrived. If this is <c>nullptr</c>, the asynchronous sampling will
+        /// be disabled.</param>
+        /// <param name="period">The desired sampling period in
+        /// microseconds. This parameter defaults to 1 millisecond.</param>
+        /// <param name="context">A user-defined context pointer that is passed
+        /// on to <see cref="on_batch" />. This parameter defaults to
+        /// <c>nullptr</c>.</para>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        /// <exception cref="std::logic_error">If the sensor is already being
+        /// sampled asynchronously due to a previous call to the method or to
+        /// <see cref="sample" />.</exception>
+        virtual void sample_batch(
+            _In_opt_ const measurement_data_callback on_batch,
+            _In_ const microseconds_type period = default_sampling_period,
+            _In_opt_ void *context = nullptr) override;
+
         using sensor::sample;
 
+        /// <summary>
+        /// Sample the sensor using a timestamp with the specified resolution,
+        /// but do not attach the sensor that produces the data to the sample.
+        /// </summary>
+        /// <remarks>
+        /// This method hides <see cref="sensor::sample_data" /> and provides a
+        /// fast path for code that knows the type of the sensor, because it
+        /// does not need any virtual call.
+        /// </remarks>
+        /// <param name="resolution">The resolution of the timestamp to be
+        /// created. This parameter defaults to
+        /// <see cref="timestamp_resolution::milliseconds" />.</param>
+        /// <returns>A single measurement made by the sensor.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved
+        /// (and therefore disposed).</exception>
+        measurement_data sample_data(_In_ const timestamp_resolution resolution
+            = timestamp_resolution::milliseconds) const;
+
         /// <summary>
         /// Starts the sensor asynchronously collecting data.
         /// </summary>
@@ -0,0 +1,254 @@
+﻿// <copyright file="amdgpu_sensor.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "power_overwhelming/amdgpu_sensor_source.h"
+#include "power_overwhelming/sensor.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations */
+    namespace detail { struct amdgpu_sensor_impl; }
+
+
+    /// <summary>
+    /// Implementation of a power sensor for AMD GPUs using the hwmon interface
+    /// of the amdgpu kernel driver on Linux.
+    /// </summary>
+    /// <remarks>
+    /// <para>The <see cref="adl_sensor" /> is only available on Windows, which
+    /// leaves AMD GPUs on Linux without any power sensor. This sensor reads
+    /// the power attributes the amdgpu driver exposes in sysfs instead, which
+    /// does not require any privileges.</para>
+    /// <para>The sensor keeps the attribute file open for its whole lifetime
+    /// and re-reads it from the beginning for each sample, so the costly path
+    /// lookup is only performed once. The asynchronous sampler of the sensor
+    /// is shared by all cards, so all AMD GPUs that are sampled at the same
+    /// rate are read one after the other by the same thread.</para>
+    /// <para>The hwmon interface is not available on Windows, where the
+    /// sensor cannot be created.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API amdgpu_sensor final : public sensor {
+
+    public:
+
+        /// <summary>
+        /// Create sensors for all attributes of all AMD GPUs that the amdgpu
+        /// driver exposes via hwmon.
+        /// </summary>
+        /// <param name="out_sensors">Receives the sensors, if not
+        /// <c>nullptr</c>.</param>
+        /// <param name="cnt_sensors">The available space in
+        /// <paramref name="out_sensors" />.</param>
+        /// <returns>The number of sensors available on the system, regardless
+        /// of the size of the output array. If this number is larger than
+        /// <paramref name="cnt_sensors" />, not all sensors have been returned.
+        /// </returns>
+        static std::size_t for_all(
+            _Out_writes_opt_(cnt_sensors) amdgpu_sensor *out_sensors,
+            _In_ const std::size_t cnt_sensors);
+
+        /// <summary>
+        /// Create a sensor for the GPU with the specified PCI bus ID.
+        /// </summary>
+        /// <param name="bus_id">The PCI bus ID of the GPU in the format of
+        /// sysfs, for instance &quot;0000:03:00.0&quot;.</param>
+        /// <param name="source">The hwmon attribute to be read.</param>
+        /// <returns>A new sensor for the specified GPU and attribute.
+        /// </returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="bus_id" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::system_error">If the GPU is not driven by
+        /// amdgpu or does not provide the requested attribute.</exception>
+        static amdgpu_sensor from_bus_id(_In_z_ const char *bus_id,
+            _In_ const amdgpu_sensor_source source);
+
+        /// <summary>
+        /// Create a sensor for the GPU with the specified PCI bus ID.
+        /// </summary>
+        /// <param name="bus_id">The PCI bus ID of the GPU in the format of
+        /// sysfs, for instance &quot;0000:03:00.0&quot;.</param>
+        /// <param name="source">The hwmon attribute to be read.</param>
+        /// <returns>A new sensor for the specified GPU and attribute.
+        /// </returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="bus_id" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::system_error">If the GPU is not driven by
+        /// amdgpu or does not provide the requested attribute.</exception>
+        static amdgpu_sensor from_bus_id(_In_z_ const wchar_t *bus_id,
+            _In_ const amdgpu_sensor_source source);
+
+        /// <summary>
+        /// Samples all of the given sensors without attaching their names to
+        /// the samples.
+        /// </summary>
+        /// <remarks>
+        /// This is the batch variant of <see cref="sample_data" />, which
+        /// enters the library only once for all sensors of the family.
+        /// </remarks>
+        /// <param name="dst">Receives <paramref name="cnt" /> samples.</param>
+        /// <param name="sensors">The sensors to be sampled.</param>
+        /// <param name="cnt">The number of sensors in
+        /// <paramref name="sensors" />.</param>
+        /// <param name="resolution">The resolution of the timestamps to be
+        /// created. This parameter defaults to
+        /// <see cref="timestamp_resolution::milliseconds" />.</param>
+        /// <exception cref="std::invalid_argument">If <paramref name="dst" />
+        /// or <paramref name="sensors" /> is <c>nullptr</c> while
+        /// <paramref name="cnt" /> is not zero.</exception>
+        /// <exception cref="std::runtime_error">If any of the sensors has been
+        /// moved (and therefore disposed).</exception>
+        static void sample_data(_Out_writes_(cnt) measurement_data *dst,
+            _In_reads_(cnt) const amdgpu_sensor *sensors,
+            _In_ const std::size_t cnt,
+            _In_ const timestamp_resolution resolution
+            = timestamp_resolution::milliseconds);
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        amdgpu_sensor(void);
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline amdgpu_sensor(_In_ amdgpu_sensor&& rhs) noexcept
+                : _impl(rhs._impl) {
+            rhs._impl = nullptr;
+        }
+
+        /// <summary>
+        /// Finalise the instance.
+        /// </summary>
+        virtual ~amdgpu_sensor(void);
+
+        /// <summary>
+        /// Answer the PCI bus ID of the GPU the sensor is sampling.
+        /// </summary>
+        /// <returns>The PCI bus ID in the format of sysfs.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        _Ret_z_ const char *bus_id(void) const;
+
+        /// <summary>
+        /// Reads the energy counter of the GPU if the sensor samples
+        /// <see cref="amdgpu_sensor_source::energy" />.
+        /// </summary>
+        /// <remarks>
+        /// The driver accumulates the counter of the SMU in 64 bits, so the
+        /// difference between two calls is the energy consumed in the
+        /// meantime regardless of whether the sensor has been sampled.
+        /// </remarks>
+        /// <returns>The energy in Joules since an undefined point in time, or
+        /// zero if the sensor reads a power.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        /// <exception cref="std::system_error">If reading the attribute
+        /// failed.</exception>
+        double energy(void) const;
+
+        /// <inheritdoc />
+        virtual _Ret_maybenull_z_ const wchar_t *name(
+            void) const noexcept override;
+
+        /// <summary>
+        /// Answer the interval at which the firmware of the GPU updates the
+        /// power readings, which is approximately one millisecond.
+        /// </summary>
+        /// <returns>The update interval in microseconds.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        virtual microseconds_type native_interval(void) const override;
+
+        using sensor::sample;
+
+        /// <inheritdoc />
+        virtual void sample_adaptive(
+            _In_opt_ const measurement_data_callback on_batch,
+            _In_ const microseconds_type min_period,
+            _In_ const microseconds_type max_period,
+            _In_opt_ void *context = nullptr) override;
+
+        /// <summary>
+        /// Sample the sensor using a timestamp with the specified resolution,
+        /// but do not attach the sensor that produces the data to the sample.
+        /// </summary>
+        /// <remarks>
+        /// This method hides <see cref="sensor::sample_data" /> and provides a
+        /// fast path for code that knows the type of the sensor, because it
+        /// does not need any virtual call.
+        /// </remarks>
+        /// <param name="resolution">The resolution of the timestamp to be
+        /// created. This parameter defaults to
+        /// <see cref="timestamp_resolution::milliseconds" />.</param>
+        /// <returns>A single measurement made by the sensor.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved
+        /// (and therefore disposed).</exception>
+        /// <exception cref="std::system_error">If reading the attribute
+        /// failed.</exception>
+        measurement_data sample_data(_In_ const timestamp_resolution resolution
+            = timestamp_resolution::milliseconds) const;
+
+        /// <summary>
+        /// Asynchronously sample the sensor every
+        /// <paramref name="sampling_period "/> microseconds.
+        /// </summary>
+        /// <param name="on_measurement">The callback to be invoked if new data
+        /// arrived. If this is <c>nullptr</c>, the asynchronous sampling will
+        /// be disabled.</param>
+        /// <param name="period">The desired sampling period in
+        /// microseconds. This parameter defaults to 1 millisecond.</param>
+        /// <param name="timestamp_resolution">The resolution of the timestamps
+        /// that are generated by the sensor. This parameter defaults to
+        /// <see cref="timestamp_resolution::milliseconds" />.</param>
+        /// <param name="context">A user-defined context pointer that is passed
+        /// on to <see cref="on_measurement" />. This parameter defaults to
+        /// <c>nullptr</c>.</para>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        /// <exception cref="std::logic_error">If the sensor is already being
+        /// sampled asynchronously due to a previous call to the method.
+        /// </exception>
+        void sample(_In_opt_ const measurement_callback on_measurement,
+            _In_ const microseconds_type period = default_sampling_period,
+            _In_ const timestamp_resolution timestamp_resolution
+                = timestamp_resolution::milliseconds,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Answer the hwmon attribute the sensor is reading.
+        /// </summary>
+        /// <returns>The source of the sensor readings.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        amdgpu_sensor_source source(void) const;
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand</param>
+        /// <returns><c>*this</c></returns>
+        amdgpu_sensor& operator =(_In_ amdgpu_sensor&& rhs) noexcept;
+
+        /// <inheritdoc />
+        virtual operator bool(void) const noexcept override;
+
+    protected:
+
+        /// <inheritdoc />
+        measurement_data sample_sync(
+            _In_ const timestamp_resolution resolution) const override;
+
+    private:
+
+        detail::amdgpu_sensor_impl *_impl;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,64 @@
+﻿// <copyright file="amdgpu_sensor_source.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// Specifies the hwmon attribute of the amdgpu driver an
+    /// <see cref="amdgpu_sensor" /> reads.
+    /// </summary>
+    enum class amdgpu_sensor_source : std::uint32_t {
+
+        /// <summary>
+        /// The average power of the GPU in microwatts, which is reported by
+        /// <c>power1_average</c>.
+        /// </summary>
+        average_power = 0x0001,
+
+        /// <summary>
+        /// The instantaneous power of the GPU in microwatts, which is
+        /// reported by <c>power1_input</c> on newer ASICs.
+        /// </summary>
+        instantaneous_power = 0x0002,
+
+        /// <summary>
+        /// The accumulated energy of the GPU in microjoules, which is reported
+        /// by <c>energy1_input</c> on some ASICs and from which the sensor
+        /// derives the average power between two samples.
+        /// </summary>
+        energy = 0x0004
+    };
+
+    /// <summary>
+    /// Parse a sensor source from a string.
+    /// </summary>
+    /// <param name="str">The string to be parsed.</param>
+    /// <returns>The sensor source represented by the string.</returns>
+    /// <exception cref="std::invalid_argument">If <paramref name="str" /> is
+    /// <c>nullptr</c> or does not represent a valid source.</exception>
+    extern POWER_OVERWHELMING_API amdgpu_sensor_source
+    parse_amdgpu_sensor_source(_In_z_ const wchar_t *str);
+
+    /// <summary>
+    /// Convert the given sensor source to a human-readable string
+    /// representation.
+    /// </summary>
+    /// <param name="source">The source to be converted.</param>
+    /// <returns>The name of the source.</returns>
+    /// <exception cref="std::invalid_argument">If the source is unknown.
+    /// </exception>
+    extern POWER_OVERWHELMING_API const wchar_t *to_string(
+        _In_ const amdgpu_sensor_source source);
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,181 @@
+﻿// <copyright file="awaitable.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#if defined(__has_include)
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define POWER_OVERWHELMING_AWAITABLE (1)
+#endif /* defined(__cpp_impl_coroutine) && __has_include(<coroutine>) */
+#endif /* defined(__has_include) */
+
+#if defined(POWER_OVERWHELMING_AWAITABLE)
+#include <coroutine>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "power_overwhelming/collector_subscriber.h"
+#include "power_overwhelming/sensor_stream.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// An executor that resumes a coroutine directly on the thread that
+    /// published the samples it is waiting for.
+    /// </summary>
+    /// <remarks>
+    /// This is only suitable for coroutines that do very little work until
+    /// their next suspension, because they run on the I/O thread of the
+    /// collector or the sampler thread of the sensor. Any callable accepting
+    /// a <c>std::coroutine_handle&lt;&gt;</c> can be used as executor, for
+    /// instance one posting the handle to a thread pool.
+    /// </remarks>
+    struct inline_executor final {
+        inline void operator ()(std::coroutine_handle<> handle) const {
+            handle.resume();
+        }
+    };
+
+    /// <summary>
+    /// A batch of samples obtained by awaiting <see cref="next_batch" />.
+    /// </summary>
+    struct subscriber_batch final {
+
+        /// <summary>
+        /// The interned names of the sensors, one for each of the
+        /// <see cref="samples" />.
+        /// </summary>
+        std::vector<const wchar_t *> sensors;
+
+        /// <summary>
+        /// The samples in the order they have been published.
+        /// </summary>
+        std::vector<measurement_data> samples;
+
+        /// <summary>
+        /// Answer whether the batch is empty, which indicates that no more
+        /// samples will arrive.
+        /// </summary>
+        inline bool empty(void) const noexcept {
+            return this->samples.empty();
+        }
+    };
+
+    /// <summary>
+    /// The awaitable returned by <see cref="next_batch" />.
+    /// </summary>
+    /// <remarks>
+    /// The coroutine only suspends if no samples are pending, and it is
+    /// resumed via <typeparamref name="TExecutor" /> once samples have been
+    /// published. As the samples stay in the ring of the subscriber until
+    /// they are awaited, the rate at which a consumer awaits batches
+    /// determines how much it reads, and a consumer that falls behind loses
+    /// samples according to the overflow policy of its subscriber rather than
+    /// slowing down the producer.
+    /// </remarks>
+    /// <typeparam name="TExecutor">The type of the callable that resumes the
+    /// suspended coroutine.</typeparam>
+    template<class TExecutor> class batch_awaitable final {
+
+    public:
+
+        inline batch_awaitable(collector_subscriber& subscriber,
+                TExecutor executor, const std::size_t max_samples)
+            : _executor(std::move(executor)),
+            _max_samples((max_samples > 0) ? max_samples : 1),
+            _subscriber(subscriber) { }
+
+        batch_awaitable(const batch_awaitable&) = delete;
+
+        inline ~batch_awaitable(void) {
+            // A coroutine destroyed while suspended must not be resumed.
+            if (this->_handle) {
+                this->_subscriber.cancel();
+            }
+        }
+
+        inline bool await_ready(void) const noexcept {
+            return (this->_subscriber.available() > 0);
+        }
+
+        inline subscriber_batch await_resume(void) {
+            this->_handle = nullptr;
+
+            subscriber_batch retval;
+            retval.samples.resize(this->_max_samples, measurement_data(0,
+                static_cast<measurement_data::value_type>(0)));
+            retval.sensors.resize(this->_max_samples);
+            const auto cnt = this->_subscriber.read(retval.samples.data(),
+                retval.sensors.data(), this->_max_samples);
+            retval.samples.erase(retval.samples.begin() + cnt,
+                retval.samples.end());
+            retval.sensors.resize(cnt);
+
+            return retval;
+        }
+
+        inline bool await_suspend(std::coroutine_handle<> handle) {
+            this->_handle = handle;
+            if (!this->_subscriber.notify(&batch_awaitable::on_ready, this)) {
+                // Samples arrived in the meantime or none will ever arrive.
+                this->_handle = nullptr;
+                return false;
+            }
+
+            return true;
+        }
+
+        batch_awaitable& operator =(const batch_awaitable&) = delete;
+
+    private:
+
+        static void on_ready(void *context) {
+            auto that = static_cast<batch_awaitable *>(context);
+            that->_executor(that->_handle);
+        }
+
+        TExecutor _executor;
+        std::coroutine_handle<> _handle;
+        std::size_t _max_samples;
+        collector_subscriber& _subscriber;
+    };
+
+    /// <summary>
+    /// Answer an awaitable that completes with the next batch of samples of
+    /// the given subscriber.
+    /// </summary>
+    /// <remarks>
+    /// <para>Awaiting the result yields an empty batch if the collector or
+    /// sensor stream has been destroyed and no more samples will arrive, or
+    /// if the subscriber is invalid.</para>
+    /// <para>This is a free function rather than a member of the subscriber
+    /// such that the library itself does not require C++20.</para>
+    /// </remarks>
+    /// <typeparam name="TExecutor">The type of the callable that resumes a
+    /// suspended coroutine.</typeparam>
+    /// <param name="subscriber">The subscriber to read from, which must
+    /// outlive the awaitable.</param>
+    /// <param name="executor">Resumes the coroutine once samples have been
+    /// published.</param>
+    /// <param name="max_samples">The maximum number of samples in the batch.
+    /// </param>
+    /// <returns>An awaitable yielding a <see cref="subscriber_batch" />.
+    /// </returns>
+    template<class TExecutor = inline_executor>
+    inline batch_awaitable<TExecutor> next_batch(
+            collector_subscriber& subscriber,
+            TExecutor executor = TExecutor(),
+            const std::size_t max_samples = 256) {
+        return batch_awaitable<TExecutor>(subscriber, std::move(executor),
+            max_samples);
+    }
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+#endif /* defined(POWER_OVERWHELMING_AWAITABLE) */
@@ -0,0 +1,249 @@
+﻿// <copyright file="binary_output_reader.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstddef>
+
+#include "power_overwhelming/measurement_data.h"
+#include "power_overwhelming/timestamp_resolution.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations */
+    namespace detail { struct binary_output_reader_impl; }
+
+    /// <summary>
+    /// Provides random access to the samples in a file written by a
+    /// <see cref="collector" /> in <see cref="output_format::binary" />.
+    /// </summary>
+    /// <remarks>
+    /// <para>The reader maps the file into memory and loads the index from
+    /// its footer, which locates the chunks of samples of each sensor and the
+    /// time when each marker was set. Retrieving the samples of a time range
+    /// or of a marker therefore only decodes the chunks that overlap it,
+    /// regardless of the size of the file.</para>
+    /// <para>Files that have not been closed properly, for instance because
+    /// the process has crashed while writing them, and files written by older
+    /// versions of the library have no index. In this case, the reader builds
+    /// the index when it is opened by scanning the headers of all records and
+    /// the timestamps of all chunks, which takes time proportional to the
+    /// size of the file.</para>
+    /// <para>The reader is not thread-safe, but different threads can use
+    /// different readers of the same file.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API binary_output_reader final {
+
+    public:
+
+        /// <summary>
+        /// The type of the timestamps of the samples.
+        /// </summary>
+        typedef measurement_data::timestamp_type timestamp_type;
+
+        /// <summary>
+        /// Initialises a new instance that is not associated with any file.
+        /// </summary>
+        binary_output_reader(void) noexcept;
+
+        /// <summary>
+        /// Initialises a new instance reading the given file.
+        /// </summary>
+        /// <param name="path">The path to the binary output file.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="path" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::system_error">If the file could not be
+        /// opened or mapped.</exception>
+        /// <exception cref="std::runtime_error">If the file is not a valid
+        /// binary output file.</exception>
+        explicit binary_output_reader(_In_z_ const wchar_t *path);
+
+        /// <summary>
+        /// Initialises a new instance reading the given file.
+        /// </summary>
+        /// <param name="path">The path to the binary output file.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="path" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::system_error">If the file could not be
+        /// opened or mapped.</exception>
+        /// <exception cref="std::runtime_error">If the file is not a valid
+        /// binary output file.</exception>
+        explicit binary_output_reader(_In_z_ const char *path);
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline binary_output_reader(_Inout_ binary_output_reader&& rhs) noexcept
+                : _impl(rhs._impl) {
+            rhs._impl = nullptr;
+        }
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~binary_output_reader(void);
+
+        /// <summary>
+        /// Answer whether the index has been loaded from the file rather than
+        /// being built by scanning the file.
+        /// </summary>
+        /// <returns><c>true</c> if the file contains an index, <c>false</c>
+        /// otherwise or if the reader is invalid.</returns>
+        bool indexed(void) const noexcept;
+
+        /// <summary>
+        /// Answer the name of the marker at the given index.
+        /// </summary>
+        /// <remarks>
+        /// The returned string remains valid as long as the reader exists.
+        /// </remarks>
+        /// <param name="index">The index of the marker, which is not its ID.
+        /// </param>
+        /// <returns>The name of the marker, or <c>nullptr</c> if
+        /// <paramref name="index" /> is out of range.</returns>
+        _Ret_maybenull_z_ const wchar_t *marker(
+            _In_ const std::size_t index) const noexcept;
+
+        /// <summary>
+        /// Answer the number of markers declared in the file.
+        /// </summary>
+        /// <returns>The number of markers, or zero if the reader is invalid.
+        /// </returns>
+        std::size_t markers(void) const noexcept;
+
+        /// <summary>
+        /// Retrieves the time spans in which the given marker was set.
+        /// </summary>
+        /// <remarks>
+        /// <para>Each phase lasts from the event setting the marker until the
+        /// next marker event. The phases are returned in chronological order.
+        /// If the marker was still set when the file was closed, the end of
+        /// the last phase is the largest <see cref="timestamp_type" />.</para>
+        /// </remarks>
+        /// <param name="marker">The name of the marker.</param>
+        /// <param name="begin">Receives the begin of at most
+        /// <paramref name="cnt" /> phases. It is safe to pass
+        /// <c>nullptr</c>.</param>
+        /// <param name="end">Receives the first timestamp after at most
+        /// <paramref name="cnt" /> phases. It is safe to pass <c>nullptr</c>.
+        /// </param>
+        /// <param name="cnt">The number of elements that can be written to
+        /// <paramref name="begin" /> and <paramref name="end" />.</param>
+        /// <returns>The number of phases of the marker, which might be larger
+        /// than <paramref name="cnt" />.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="marker" /> is <c>nullptr</c>.</exception>
+        std::size_t phases(_In_z_ const wchar_t *marker,
+            _Out_writes_opt_(cnt) timestamp_type *begin,
+            _Out_writes_opt_(cnt) timestamp_type *end,
+            _In_ const std::size_t cnt) const;
+
+        /// <summary>
+        /// Retrieves the samples in the given time range.
+        /// </summary>
+        /// <remarks>
+        /// <para>The callback is invoked once for each chunk that contains
+        /// samples in the range with the name of the sensor and the samples in
+        /// the order in which they have been recorded. The samples are only
+        /// valid while the callback is running.</para>
+        /// </remarks>
+        /// <param name="sensor">The name of the sensor to retrieve the
+        /// samples of, or <c>nullptr</c> for all sensors.</param>
+        /// <param name="begin">The first timestamp in the range.</param>
+        /// <param name="end">The first timestamp after the range.</param>
+        /// <param name="callback">The callback receiving the samples.</param>
+        /// <param name="context">A user-defined pointer passed to the
+        /// callback.</param>
+        /// <returns>The number of samples passed to the callback.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="callback" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::runtime_error">If a chunk of samples is
+        /// corrupt.</exception>
+        std::size_t read(_In_opt_z_ const wchar_t *sensor,
+            _In_ const timestamp_type begin,
+            _In_ const timestamp_type end,
+            _In_ const measurement_data_callback callback,
+            _In_opt_ void *context = nullptr) const;
+
+        /// <summary>
+        /// Retrieves the samples that have been recorded while the given
+        /// marker was set.
+        /// </summary>
+        /// <remarks>
+        /// <para>The reader only decodes the chunks that overlap any of the
+        /// phases in which the marker was set and passes the samples that
+        /// have been recorded with the marker to the callback, which is
+        /// invoked once for each chunk like for a time range.</para>
+        /// </remarks>
+        /// <param name="sensor">The name of the sensor to retrieve the
+        /// samples of, or <c>nullptr</c> for all sensors.</param>
+        /// <param name="marker">The name of the marker.</param>
+        /// <param name="callback">The callback receiving the samples.</param>
+        /// <param name="context">A user-defined pointer passed to the
+        /// callback.</param>
+        /// <returns>The number of samples passed to the callback, which is
+        /// zero if the marker has not been declared in the file.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="marker" /> or <paramref name="callback" /> is
+        /// <c>nullptr</c>.</exception>
+        /// <exception cref="std::runtime_error">If a chunk of samples is
+        /// corrupt.</exception>
+        std::size_t read(_In_opt_z_ const wchar_t *sensor,
+            _In_z_ const wchar_t *marker,
+            _In_ const measurement_data_callback callback,
+            _In_opt_ void *context = nullptr) const;
+
+        /// <summary>
+        /// Answer the resolution of the timestamps in the file.
+        /// </summary>
+        /// <returns>The resolution of the timestamps, which is
+        /// <see cref="timestamp_resolution::milliseconds" /> if the reader is
+        /// invalid.</returns>
+        timestamp_resolution resolution(void) const noexcept;
+
+        /// <summary>
+        /// Answer the name of the sensor at the given index.
+        /// </summary>
+        /// <remarks>
+        /// The returned string remains valid as long as the reader exists.
+        /// </remarks>
+        /// <param name="index">The index of the sensor.</param>
+        /// <returns>The name of the sensor, or <c>nullptr</c> if
+        /// <paramref name="index" /> is out of range.</returns>
+        _Ret_maybenull_z_ const wchar_t *sensor(
+            _In_ const std::size_t index) const noexcept;
+
+        /// <summary>
+        /// Answer the number of sensors in the file.
+        /// </summary>
+        /// <returns>The number of sensors, or zero if the reader is invalid.
+        /// </returns>
+        std::size_t sensors(void) const noexcept;
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        binary_output_reader& operator =(
+            _Inout_ binary_output_reader&& rhs) noexcept;
+
+        /// <summary>
+        /// Determines whether the object is valid.
+        /// </summary>
+        /// <returns><c>true</c> if the reader has opened a file, <c>false</c>
+        /// otherwise.</returns>
+        operator bool(void) const noexcept;
+
+    private:
+
+        detail::binary_output_reader_impl *_impl;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
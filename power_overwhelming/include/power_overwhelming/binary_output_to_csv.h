@@ -0,0 +1,74 @@
+﻿// <copyright file="binary_output_to_csv.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// Converts a file written by a <see cref="collector" /> in
+    /// <see cref="output_format::binary" /> into the CSV format the collector
+    /// would have written otherwise.
+    /// </summary>
+    /// <param name="input">The path to the binary file to be converted.
+    /// </param>
+    /// <param name="output">The path to the CSV file to be written.</param>
+    /// <returns>The number of samples that have been converted.</returns>
+    /// <exception cref="std::invalid_argument">If any of the paths is
+    /// <c>nullptr</c>.</exception>
+    /// <exception cref="std::runtime_error">If the input is not a valid
+    /// binary output file.</exception>
+    /// <exception cref="std::ios_base::failure">If reading the input or
+    /// writing the output failed.</exception>
+    std::size_t POWER_OVERWHELMING_API binary_output_to_csv(
+        _In_z_ const wchar_t *input, _In_z_ const wchar_t *output);
+
+    /// <summary>
+    /// Converts a file written by a <see cref="collector" /> in
+    /// <see cref="output_format::binary" /> into the CSV format the collector
+    /// would have written otherwise.
+    /// </summary>
+    /// <param name="input">The path to the binary file to be converted.
+    /// </param>
+    /// <param name="output">The path to the CSV file to be written.</param>
+    /// <returns>The number of samples that have been converted.</returns>
+    /// <exception cref="std::invalid_argument">If any of the paths is
+    /// <c>nullptr</c>.</exception>
+    /// <exception cref="std::runtime_error">If the input is not a valid
+    /// binary output file.</exception>
+    /// <exception cref="std::ios_base::failure">If reading the input or
+    /// writing the output failed.</exception>
+    std::size_t POWER_OVERWHELMING_API binary_output_to_csv(
+        _In_z_ const char *input, _In_z_ const char *output);
+
+    /// <summary>
+    /// Converts a file written by a <see cref="collector" /> in
+    /// <see cref="output_format::binary" /> into the CSV format the collector
+    /// would have written otherwise.
+    /// </summary>
+    /// <param name="input">The path to the binary file to be converted.
+    /// </param>
+    /// <param name="output">The path to the CSV file to be written.</param>
+    /// <returns>The number of samples that have been converted.</returns>
+    /// <exception cref="std::runtime_error">If the input is not a valid
+    /// binary output file.</exception>
+    /// <exception cref="std::ios_base::failure">If reading the input or
+    /// writing the output failed.</exception>
+    template<class TChar>
+    inline std::size_t binary_output_to_csv(
+            _In_ const std::basic_string<TChar>& input,
+            _In_ const std::basic_string<TChar>& output) {
+        return binary_output_to_csv(input.c_str(), output.c_str());
+    }
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
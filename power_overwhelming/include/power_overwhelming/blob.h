@@ -18,6 +18,13 @@ namespace power_overwhelming {
     /// <summary>
     /// A block of binary data.
     /// </summary>
+    /// <remarks>
+    /// <para>Blobs of up to <see cref="blob::inline_capacity" /> bytes are
+    /// stored within the object itself, wherefore short instrument responses
+    /// do not require a heap allocation. Larger blobs are allocated with an
+    /// alignment of 64 bytes from a thread-local pool of recently freed
+    /// blocks.</para>
+    /// </remarks>
     class POWER_OVERWHELMING_API blob final {
 
     public:
@@ -27,10 +34,16 @@ namespace power_overwhelming {
         /// </summary>
         typedef std::uint8_t byte_type;
 
+        /// <summary>
+        /// The number of bytes that can be stored without allocating memory
+        /// from the heap.
+        /// </summary>
+        static constexpr std::size_t inline_capacity = 64;
+
         /// <summary>
           /// Initialises a new and empty instance.
           /// </summary>
-        inline blob(void) noexcept : _data(nullptr), _size(0) { }
+        inline blob(void) noexcept : _data(nullptr), _size(0), _capacity(0) { }
 
         /// <summary>
         /// Initialises a new instance.
@@ -38,8 +51,7 @@ namespace power_overwhelming {
         /// <param name="size">The size of the blob in bytes.</param>
         /// <exception cref="std::bad_alloc">If the required memory could not
         /// be allocated.</exception>
-        explicit inline blob(_In_ const std::size_t size)
-            : _data(new byte_type[size]), _size(size) { }
+        explicit blob(_In_ const std::size_t size);
 
         /// <summary>
         /// Initialises a new blob from existing data.
@@ -412,8 +424,30 @@ namespace power_overwhelming {
 
     private:
 
+        /// <summary>
+        /// Sets <see cref="_data" /> to a new buffer of at least
+        /// <paramref name="size" /> bytes, which is the inline buffer if
+        /// possible.
+        /// </summary>
+        /// <remarks>
+        /// This method neither releases the existing buffer nor changes
+        /// <see cref="_size" />.
+        /// </remarks>
+        void allocate(_In_ const std::size_t size);
+
+        /// <summary>
+        /// Returns the buffer to the pool unless it is the inline one and
+        /// sets <see cref="_data" /> to <c>nullptr</c>.
+        /// </summary>
+        /// <remarks>
+        /// This method does not change <see cref="_size" />.
+        /// </remarks>
+        void release(void) noexcept;
+
         byte_type *_data;
         std::size_t _size;
+        std::size_t _capacity;
+        alignas(alignof(std::max_align_t)) byte_type _inline[inline_capacity];
 
     };
 
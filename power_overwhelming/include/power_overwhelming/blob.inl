@@ -10,9 +10,10 @@
 template<class TElement>
 visus::power_overwhelming::blob::blob(
         _In_ const std::initializer_list<TElement>& data)
-        : _data(nullptr), _size(data.size() * sizeof(TElement)) {
+        : _data(nullptr), _size(data.size() * sizeof(TElement)),
+        _capacity(0) {
     if (this->_size > 0) {
-        this->_data = new byte_type[this->_size];
+        this->allocate(this->_size);
         auto d = reinterpret_cast<TElement *>(this->_data);
         std::copy(data.begin(), data.end(), d);
     }
@@ -0,0 +1,303 @@
+﻿// <copyright file="c_api.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+/*
+ * This header declares a stable C interface to the collector for bindings
+ * from other languages. It must remain valid C and must not include any C++
+ * header of the library. Functions are only ever added, and the layout of
+ * the structures never changes, which is indicated by PWROWG_API_VERSION.
+ * All strings are UTF-8.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/// <summary>
+/// The version of the C API declared by this header.
+/// </summary>
+#define PWROWG_API_VERSION (1)
+
+/// <summary>
+/// The result of a function of the C API. Negative values indicate errors,
+/// whose description can be retrieved via <see cref="pwrowg_last_error" />.
+/// </summary>
+typedef int32_t pwrowg_status;
+
+/// <summary>
+/// The operation succeeded.
+/// </summary>
+#define PWROWG_SUCCESS (0)
+
+/// <summary>
+/// The operation completed, but no data became available in time.
+/// </summary>
+#define PWROWG_TIMEOUT (1)
+
+/// <summary>
+/// A parameter was invalid.
+/// </summary>
+#define PWROWG_INVALID_ARGUMENT (-1)
+
+/// <summary>
+/// The operation is not allowed in the current state of the object.
+/// </summary>
+#define PWROWG_INVALID_STATE (-2)
+
+/// <summary>
+/// Memory could not be allocated.
+/// </summary>
+#define PWROWG_OUT_OF_MEMORY (-3)
+
+/// <summary>
+/// A call to the operating system or a driver failed.
+/// </summary>
+#define PWROWG_SYSTEM_ERROR (-4)
+
+/// <summary>
+/// Any other error.
+/// </summary>
+#define PWROWG_ERROR (-5)
+
+/// <summary>
+/// The opaque handle of a collector.
+/// </summary>
+typedef struct pwrowg_collector pwrowg_collector;
+
+/// <summary>
+/// The opaque handle of a live subscription to the samples of a collector.
+/// </summary>
+typedef struct pwrowg_subscriber pwrowg_subscriber;
+
+/// <summary>
+/// A batch of samples in structure-of-arrays layout, whose arrays are
+/// borrowed from the library until the batch is released via
+/// <see cref="pwrowg_subscriber_release" />.
+/// </summary>
+/// <remarks>
+/// All arrays hold <see cref="count" /> elements. Bindings can wrap them as
+/// arrays of their own language without copying the samples.
+/// </remarks>
+typedef struct pwrowg_batch {
+
+    /// <summary>
+    /// The number of samples in the batch.
+    /// </summary>
+    size_t count;
+
+    /// <summary>
+    /// The timestamps of the samples in the resolution configured for the
+    /// collector.
+    /// </summary>
+    const int64_t *timestamps;
+
+    /// <summary>
+    /// The current in Amperes, which is NaN if the sensor does not measure
+    /// it.
+    /// </summary>
+    const float *current;
+
+    /// <summary>
+    /// The power in Watts, which is NaN if the sensor does not measure it.
+    /// </summary>
+    const float *power;
+
+    /// <summary>
+    /// The voltage in Volts, which is NaN if the sensor does not measure it.
+    /// </summary>
+    const float *voltage;
+
+    /// <summary>
+    /// The indices of the sensors of the samples, whose names can be
+    /// retrieved via <see cref="pwrowg_subscriber_sensor" />.
+    /// </summary>
+    const uint32_t *sensors;
+
+    /// <summary>
+    /// Identifies the buffer of the batch within the library, which must not
+    /// be modified.
+    /// </summary>
+    void *reserved;
+} pwrowg_batch;
+
+/// <summary>
+/// Answer the version of the C API implemented by the library, which may be
+/// newer than <see cref="PWROWG_API_VERSION" /> of the header a binding was
+/// built with.
+/// </summary>
+/// <returns>The version of the C API.</returns>
+extern uint32_t POWER_OVERWHELMING_API pwrowg_api_version(void);
+
+/// <summary>
+/// Answer the description of the last error that occurred on the calling
+/// thread.
+/// </summary>
+/// <returns>The description of the last error, which remains valid until the
+/// next call to the C API on the same thread. The string is empty if no
+/// error has occurred.</returns>
+extern _Ret_z_ const char *POWER_OVERWHELMING_API pwrowg_last_error(void);
+
+/// <summary>
+/// Closes a collector, which stops it if it is still running.
+/// </summary>
+/// <param name="collector">The collector to be closed, which may be
+/// <c>NULL</c>.</param>
+extern void POWER_OVERWHELMING_API pwrowg_collector_close(
+    _In_opt_ pwrowg_collector *collector);
+
+/// <summary>
+/// Creates a collector for all sensors found on the machine, which writes
+/// its output to the given path.
+/// </summary>
+/// <param name="output_path">The path of the output file.</param>
+/// <param name="sampling_interval">The sampling interval in microseconds.
+/// </param>
+/// <param name="collector">Receives the new collector, which must be
+/// released via <see cref="pwrowg_collector_close" />.</param>
+/// <returns>The status of the operation.</returns>
+extern pwrowg_status POWER_OVERWHELMING_API pwrowg_collector_for_all(
+    _In_z_ const char *output_path,
+    _In_ const uint32_t sampling_interval,
+    _Out_ pwrowg_collector **collector);
+
+/// <summary>
+/// Creates a collector from a JSON configuration file.
+/// </summary>
+/// <param name="path">The path of the configuration file.</param>
+/// <param name="collector">Receives the new collector, which must be
+/// released via <see cref="pwrowg_collector_close" />.</param>
+/// <returns>The status of the operation.</returns>
+extern pwrowg_status POWER_OVERWHELMING_API pwrowg_collector_from_json(
+    _In_z_ const char *path,
+    _Out_ pwrowg_collector **collector);
+
+/// <summary>
+/// Sets a marker that is recorded with all subsequent samples.
+/// </summary>
+/// <param name="collector">The collector to set the marker for.</param>
+/// <param name="marker">The name of the marker, or <c>NULL</c> for clearing
+/// the current marker.</param>
+/// <returns>The status of the operation.</returns>
+extern pwrowg_status POWER_OVERWHELMING_API pwrowg_collector_marker(
+    _In_ pwrowg_collector *collector,
+    _In_opt_z_ const char *marker);
+
+/// <summary>
+/// Starts collecting samples.
+/// </summary>
+/// <param name="collector">The collector to be started.</param>
+/// <returns>The status of the operation.</returns>
+extern pwrowg_status POWER_OVERWHELMING_API pwrowg_collector_start(
+    _In_ pwrowg_collector *collector);
+
+/// <summary>
+/// Stops collecting samples.
+/// </summary>
+/// <param name="collector">The collector to be stopped.</param>
+/// <returns>The status of the operation.</returns>
+extern pwrowg_status POWER_OVERWHELMING_API pwrowg_collector_stop(
+    _In_ pwrowg_collector *collector);
+
+/// <summary>
+/// Subscribes to the live samples of a collector.
+/// </summary>
+/// <remarks>
+/// The subscriber remains valid if the collector is closed, but does not
+/// receive any samples afterwards.
+/// </remarks>
+/// <param name="collector">The collector to subscribe to.</param>
+/// <param name="skip_to_latest">Non-zero for skipping all pending samples
+/// if the subscriber falls behind, zero for only dropping the oldest
+/// ones.</param>
+/// <param name="subscriber">Receives the new subscriber, which must be
+/// released via <see cref="pwrowg_subscriber_close" />.</param>
+/// <returns>The status of the operation.</returns>
+extern pwrowg_status POWER_OVERWHELMING_API pwrowg_collector_subscribe(
+    _In_ pwrowg_collector *collector,
+    _In_ const int skip_to_latest,
+    _Out_ pwrowg_subscriber **subscriber);
+
+/// <summary>
+/// Waits for samples and hands them out as a batch.
+/// </summary>
+/// <remarks>
+/// <para>The arrays of the batch remain valid until the batch is passed to
+/// <see cref="pwrowg_subscriber_release" />, which returns its memory to a
+/// pool such that subsequent batches do not allocate. Multiple batches may
+/// be held at the same time.</para>
+/// <para>A subscriber must only be used by one thread at a time.</para>
+/// </remarks>
+/// <param name="subscriber">The subscriber to read from.</param>
+/// <param name="capacity">The maximum number of samples in the batch, or
+/// zero for all pending ones.</param>
+/// <param name="timeout">The time in milliseconds to wait for samples if
+/// none are pending.</param>
+/// <param name="batch">Receives the batch. If the call does not succeed, the
+/// batch is empty and need not be released.</param>
+/// <returns><see cref="PWROWG_SUCCESS" /> if the batch holds samples,
+/// <see cref="PWROWG_TIMEOUT" /> if no sample arrived in time, or an error.
+/// </returns>
+extern pwrowg_status POWER_OVERWHELMING_API pwrowg_subscriber_acquire(
+    _In_ pwrowg_subscriber *subscriber,
+    _In_ const size_t capacity,
+    _In_ const uint32_t timeout,
+    _Out_ pwrowg_batch *batch);
+
+/// <summary>
+/// Closes a subscriber, which invalidates all batches that have not yet
+/// been released.
+/// </summary>
+/// <param name="subscriber">The subscriber to be closed, which may be
+/// <c>NULL</c>.</param>
+extern void POWER_OVERWHELMING_API pwrowg_subscriber_close(
+    _In_opt_ pwrowg_subscriber *subscriber);
+
+/// <summary>
+/// Answer the number of samples that have been lost because the subscriber
+/// has fallen behind.
+/// </summary>
+/// <param name="subscriber">The subscriber to query.</param>
+/// <returns>The number of lost samples, which is zero if
+/// <paramref name="subscriber" /> is <c>NULL</c>.</returns>
+extern uint64_t POWER_OVERWHELMING_API pwrowg_subscriber_lost(
+    _In_opt_ const pwrowg_subscriber *subscriber);
+
+/// <summary>
+/// Returns the memory of a batch to the subscriber.
+/// </summary>
+/// <param name="subscriber">The subscriber that has handed out the batch.
+/// </param>
+/// <param name="batch">The batch to be released, which is emptied by the
+/// call. Releasing an empty batch has no effect.</param>
+/// <returns>The status of the operation.</returns>
+extern pwrowg_status POWER_OVERWHELMING_API pwrowg_subscriber_release(
+    _In_ pwrowg_subscriber *subscriber,
+    _Inout_ pwrowg_batch *batch);
+
+/// <summary>
+/// Answer the name of a sensor referenced by the batches of a subscriber.
+/// </summary>
+/// <param name="subscriber">The subscriber that has handed out the batch.
+/// </param>
+/// <param name="index">The index from <see cref="pwrowg_batch::sensors" />.
+/// </param>
+/// <returns>The name of the sensor, which remains valid until the
+/// subscriber is closed, or <c>NULL</c> if the index is invalid.</returns>
+extern _Ret_maybenull_z_ const char *POWER_OVERWHELMING_API
+pwrowg_subscriber_sensor(
+    _In_ const pwrowg_subscriber *subscriber,
+    _In_ const uint32_t index);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
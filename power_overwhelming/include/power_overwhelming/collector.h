@@ -13,7 +13,12 @@
 #include <type_traits>
 #include <vector>
 
+#include "power_overwhelming/collector_discovery.h"
 #include "power_overwhelming/collector_settings.h"
+#include "power_overwhelming/collector_statistics.h"
+#include "power_overwhelming/collector_subscriber.h"
+#include "power_overwhelming/frame_marker.h"
+#include "power_overwhelming/sensor_filter.h"
 
 
 namespace visus {
@@ -30,6 +35,55 @@ namespace power_overwhelming {
 
     public:
 
+        /// <summary>
+        /// Starts discovering all sensors on the machine in the background and
+        /// creates a collector for them once the discovery has completed.
+        /// </summary>
+        /// <remarks>
+        /// This is the non-blocking variant of <see cref="for_all" />, which
+        /// allows user interfaces and services to remain responsive while
+        /// slow instruments like VISA and Tinkerforge devices are probed. The
+        /// discovery runs on a thread of the library.
+        /// </remarks>
+        /// <param name="settings">The general settings for the collector,
+        /// including the sampling interval.</param>
+        /// <param name="callback">An optional callback that is invoked once
+        /// the discovery has completed, failed or has been cancelled.</param>
+        /// <param name="context">A user-defined pointer that is passed to
+        /// <paramref name="callback" />.</param>
+        /// <returns>A handle for waiting for, cancelling and retrieving the
+        /// discovery.</returns>
+        /// <exception cref="std::system_error">If the thread running the
+        /// discovery could not be started.</exception>
+        static collector_discovery discover_async(
+            _In_ const collector_settings& settings,
+            _In_opt_ const collector_discovery::callback_type callback
+            = nullptr,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Starts discovering all sensors on the machine that are accepted by
+        /// the given filter in the background and creates a collector for
+        /// them once the discovery has completed.
+        /// </summary>
+        /// <param name="settings">The general settings for the collector,
+        /// including the sampling interval.</param>
+        /// <param name="filter">The filter selecting the sensors.</param>
+        /// <param name="callback">An optional callback that is invoked once
+        /// the discovery has completed, failed or has been cancelled.</param>
+        /// <param name="context">A user-defined pointer that is passed to
+        /// <paramref name="callback" />.</param>
+        /// <returns>A handle for waiting for, cancelling and retrieving the
+        /// discovery.</returns>
+        /// <exception cref="std::system_error">If the thread running the
+        /// discovery could not be started.</exception>
+        static collector_discovery discover_async(
+            _In_ const collector_settings& settings,
+            _In_ const sensor_filter& filter,
+            _In_opt_ const collector_discovery::callback_type callback
+            = nullptr,
+            _In_opt_ void *context = nullptr);
+
         /// <summary>
         /// Creates a collector for all sensors that could be found and
         /// instantiated on the machine.
@@ -39,6 +93,25 @@ namespace power_overwhelming {
         /// <returns>A collector for all available sensors.</returns>
         static collector for_all(_In_ const collector_settings& settings);
 
+        /// <summary>
+        /// Creates a collector for all sensors that could be found and
+        /// instantiated on the machine and that are accepted by the given
+        /// filter.
+        /// </summary>
+        /// <remarks>
+        /// Sensor types that are rejected by the type filter are not probed
+        /// at all, which makes creating a collector for a subset of the
+        /// sensors much faster.
+        /// </remarks>
+        /// <param name="settings">The general settings for the collector,
+        /// including the sampling interval.</param>
+        /// <param name="filter">The filter selecting the sensors.</param>
+        /// <returns>A collector for the accepted sensors.</returns>
+        /// <exception cref="std::regex_error">If any of the patterns of the
+        /// filter is not a valid regular expression.</exception>
+        static collector for_all(_In_ const collector_settings& settings,
+            _In_ const sensor_filter& filter);
+
         /// <summary>
         /// Creates a collector for all sensors that could be found and
         /// instantiated on the machne.
@@ -68,11 +141,47 @@ namespace power_overwhelming {
         /// <summary>
         /// Initialise a new instance from the given JSON configuration file.
         /// </summary>
+        /// <remarks>
+        /// The parsed sensor descriptors are cached in a compiled form in a
+        /// file next to <paramref name="path" /> with the additional extension
+        /// &quot;.cache&quot;. As long as the configuration file does not
+        /// change, later calls restore the sensors from this cache instead of
+        /// parsing the JSON file again.
+        /// </remarks>
         /// <param name="path">The path to the JSON configuration file.</param>
         /// <returns>A new collector configured with the sensors in the
         /// specified file.</returns>
         static collector from_json(_In_z_ const wchar_t *path);
 
+        /// <summary>
+        /// Initialise a new instance from the given JSON configuration file,
+        /// optionally without opening any of the sensors.
+        /// </summary>
+        /// <remarks>
+        /// <para>If <paramref name="defer_open" /> is set, the sensor
+        /// descriptors are only checked for describing known types of
+        /// sensors. No device is accessed until the collector is started for
+        /// the first time, which opens all sensors in parallel as far as they
+        /// do not share an instrument or a Brick daemon. Therefore, errors
+        /// like a device that does not exist are only reported by
+        /// <see cref="start" />. Tools that only inspect a configuration and
+        /// collectors that are started much later do not hold any device
+        /// handles or sessions this way.</para>
+        /// <para>The sensors that have not been opened yet are included in
+        /// <see cref="size" /> and can be removed by <see cref="detach" />.
+        /// Changing their sampling interval takes effect once they are
+        /// opened.</para>
+        /// <para>If <paramref name="defer_open" /> is not set, the method
+        /// behaves like the overload without this parameter.</para>
+        /// </remarks>
+        /// <param name="path">The path to the JSON configuration file.</param>
+        /// <param name="defer_open">If <c>true</c>, the sensors are created
+        /// when the collector is started rather than immediately.</param>
+        /// <returns>A new collector configured with the sensors in the
+        /// specified file.</returns>
+        static collector from_json(_In_z_ const wchar_t *path,
+            _In_ const bool defer_open);
+
         /// <summary>
         /// Initialise a new instance from the given lists of sensors.
         /// </summary>
@@ -121,6 +230,27 @@ namespace power_overwhelming {
         /// stored.</param>
         static void make_configuration_template(_In_z_ const wchar_t *path);
 
+        /// <summary>
+        /// Creates a configuration file for all sensors currently attached to
+        /// the system that are accepted by the given filter.
+        /// </summary>
+        /// <remarks>
+        /// <para>The sensor descriptors are written to the file while the
+        /// sensors are being discovered. Sensor types that are rejected by
+        /// the type filter are not probed at all, which makes creating a
+        /// template for a subset of the sensors much faster.</para>
+        /// </remarks>
+        /// <param name="path">The path where the configuration file should be
+        /// stored.</param>
+        /// <param name="filter">The filter selecting the sensors to be added
+        /// to the template.</param>
+        /// <exception cref="std::invalid_argument">If <paramref name="path" />
+        /// is <c>nullptr</c>.</exception>
+        /// <exception cref="std::ios_base::failure">If writing the file
+        /// failed.</exception>
+        static void make_configuration_template(_In_z_ const wchar_t *path,
+            _In_ const sensor_filter& filter);
+
         /// <summary>
         /// Initialise a new instance.
         /// </summary>
@@ -145,13 +275,316 @@ namespace power_overwhelming {
         /// </summary>
         ~collector(void);
 
+        /// <summary>
+        /// Adds a sensor to the collector.
+        /// </summary>
+        /// <remarks>
+        /// <para>The sensor may be added while the collector is running, in
+        /// which case it is started immediately and a record of the change is
+        /// written to the output, which remains open. If the collector is
+        /// waiting for a marker, the sensor is started along with the others
+        /// once a marker is set.</para>
+        /// <para>This method is thread-safe with respect to setting markers,
+        /// but must not be called concurrently with <see cref="start" /> or
+        /// <see cref="stop" />.</para>
+        /// </remarks>
+        /// <typeparam name="TSensor">The type of the sensor, which is moved
+        /// into the collector.</typeparam>
+        /// <param name="sensor">The sensor to be added.</param>
+        /// <exception cref="std::runtime_error">If the collector has been
+        /// moved.</exception>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="sensor" /> has been disposed.</exception>
+        /// <exception cref="std::logic_error">If the sensor could not be
+        /// started.</exception>
+        template<class TSensor> void attach(TSensor&& sensor);
+
+        /// <summary>
+        /// Stops and removes the first sensor with the given name.
+        /// </summary>
+        /// <remarks>
+        /// If the collector is running, a record of the change is written to
+        /// the output, which remains open. See <see cref="attach" /> for the
+        /// thread-safety of this method.
+        /// </remarks>
+        /// <param name="name">The name of the sensor to be removed.</param>
+        /// <returns><c>true</c> if the sensor has been removed, <c>false</c>
+        /// if no sensor with the given name exists.</returns>
+        /// <exception cref="std::runtime_error">If the collector has been
+        /// moved.</exception>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="name" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::logic_error">If the sensor is an instrument
+        /// that is logging on its own while the collector is running.
+        /// </exception>
+        bool detach(_In_z_ const wchar_t *name);
+
+        /// <summary>
+        /// Answer the energy all sensors have measured while the given marker
+        /// was set since the collector has been started.
+        /// </summary>
+        /// <remarks>
+        /// <para>The energy is only integrated if
+        /// <see cref="collector_settings::integrate_energy" /> is set. The I/O
+        /// thread publishes the totals after each pass, so the energy of a
+        /// phase is complete once the next marker has been set and the
+        /// <see cref="collector_settings::write_latency" /> has passed.</para>
+        /// <para>Callers that repeat a measurement can compute the energy of
+        /// each repetition as the difference of the totals.</para>
+        /// </remarks>
+        /// <param name="marker">The ID returned by
+        /// <see cref="register_marker" />, or zero for the time without
+        /// marker.</param>
+        /// <returns>The energy in Joules, which is zero if the marker has not
+        /// been set or if the energy is not integrated.</returns>
+        double energy(_In_ const std::uint32_t marker) const;
+
         /// <summary>
         /// Inject a marker in the command stream which will be included in the
         /// output.
         /// </summary>
-        /// <param name="marker"></param>
+        /// <remarks>
+        /// The marker is active for all samples created after the call until
+        /// the next marker is set. Its text is written only once to the
+        /// output, whereas the samples refer to the ID of the marker. The
+        /// text is registered on first use, which requires copying and
+        /// looking up the string. Use <see cref="register_marker" /> in
+        /// advance to avoid this on the thread being measured.
+        /// </remarks>
+        /// <param name="marker">The text of the marker or <c>nullptr</c> to
+        /// clear the marker.</param>
+        /// <exception cref="std::runtime_error">If the collector has been
+        /// moved.</exception>
+        /// <exception cref="std::logic_error">If
+        /// <see cref="collector_settings::require_marker" /> is set and the
+        /// sensors could not be restarted.</exception>
         void marker(_In_opt_z_ const wchar_t *marker);
 
+        /// <summary>
+        /// Inject a marker that has been registered using
+        /// <see cref="register_marker" /> in the command stream.
+        /// </summary>
+        /// <remarks>
+        /// This method only records the ID of the marker along with the
+        /// current time, so it does not copy any string.
+        /// </remarks>
+        /// <param name="id">The ID of the marker, or zero to clear the
+        /// marker.</param>
+        /// <exception cref="std::runtime_error">If the collector has been
+        /// moved.</exception>
+        /// <exception cref="std::out_of_range">If <paramref name="id" /> has
+        /// not been registered.</exception>
+        /// <exception cref="std::logic_error">If
+        /// <see cref="collector_settings::require_marker" /> is set and the
+        /// sensors could not be restarted.</exception>
+        void marker(_In_ const std::uint32_t id);
+
+        /// <summary>
+        /// Inject a marker that has been registered using
+        /// <see cref="register_marker" /> at the given time.
+        /// </summary>
+        /// <remarks>
+        /// <para>This method allows for setting markers after the fact, for
+        /// instance when the time of an event is only known once the GPU has
+        /// executed a timestamp query, which can be mapped to the time of the
+        /// host using <see cref="gpu_timestamp_correlator" />. Setting the
+        /// marker later than the event does not affect its timing.</para>
+        /// <para>The marker only applies to samples the collector has not
+        /// written yet, so it must be set within the
+        /// <see cref="collector_settings::write_latency" /> after
+        /// <paramref name="timestamp" />. Unlike a marker set at the current
+        /// time, it does not trigger any oscilloscope.</para>
+        /// </remarks>
+        /// <param name="id">The ID of the marker, or zero to clear the
+        /// marker.</param>
+        /// <param name="timestamp">The time when the marker became active as
+        /// file time in units of 100 ns, which is converted to the resolution
+        /// of the collector.</param>
+        /// <exception cref="std::runtime_error">If the collector has been
+        /// moved.</exception>
+        /// <exception cref="std::out_of_range">If <paramref name="id" /> has
+        /// not been registered.</exception>
+        /// <exception cref="std::logic_error">If
+        /// <see cref="collector_settings::require_marker" /> is set and the
+        /// sensors could not be restarted.</exception>
+        void marker(_In_ const std::uint32_t id,
+            _In_ const measurement::timestamp_type timestamp);
+
+        /// <summary>
+        /// Answer the name of the shared memory segment through which other
+        /// processes send markers to the collector.
+        /// </summary>
+        /// <returns>The <see cref="collector_settings::marker_channel" />, or
+        /// <c>nullptr</c> if there is none or if the collector has been
+        /// moved.</returns>
+        _Ret_maybenull_z_ const wchar_t *marker_channel(void) const noexcept;
+
+        /// <summary>
+        /// Answer the number of samples that have been dropped because the
+        /// collector could not write them fast enough.
+        /// </summary>
+        /// <remarks>
+        /// <para>If this number is not zero, consider increasing
+        /// <see cref="collector_settings::buffer_size" /> or the sampling
+        /// interval.</para>
+        /// <para>If the output is streamed via
+        /// <see cref="output_format::network_binary" />, the number includes
+        /// the samples that could not be sent.</para>
+        /// </remarks>
+        /// <returns>The number of dropped samples, or zero if the collector
+        /// has been moved.</returns>
+        std::uint64_t overflows(void) const;
+
+        /// <summary>
+        /// Answer the path where the collector writes its output.
+        /// </summary>
+        /// <returns>The path of the output, or <c>nullptr</c> if the
+        /// collector has been moved.</returns>
+        _Ret_maybenull_z_ const wchar_t *output_path(void) const noexcept;
+
+        /// <summary>
+        /// Redirects the output of the next run to the given path.
+        /// </summary>
+        /// <remarks>
+        /// <para>The output of the current configuration is closed, and the
+        /// output of the next run is written to <paramref name="path" /> in
+        /// the same format. This allows for recording several runs into
+        /// different files without creating the sensors anew. Without a new
+        /// path, a restarted collector overwrites the output of its previous
+        /// run.</para>
+        /// <para>This method must not be called concurrently with
+        /// <see cref="start" /> or <see cref="stop" />.</para>
+        /// </remarks>
+        /// <param name="path">The path of the output, or its address if the
+        /// output is streamed via
+        /// <see cref="output_format::network_binary" />.</param>
+        /// <exception cref="std::runtime_error">If the collector has been
+        /// moved.</exception>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="path" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::logic_error">If the collector is running.
+        /// </exception>
+        /// <exception cref="std::system_error">If the output could not be
+        /// opened.</exception>
+        void output_path(_In_z_ const wchar_t *path);
+
+        /// <summary>
+        /// Reports progress of the workload for an overhead experiment.
+        /// </summary>
+        /// <remarks>
+        /// <para>The progress is counted in arbitrary units, for instance
+        /// frames or iterations, which must be the same throughout an
+        /// experiment. It is attributed to the window of the experiment that
+        /// is active when the method is called. See
+        /// <see cref="collector_settings::overhead_report" /> for details.
+        /// </para>
+        /// <para>This method is lock-free and can be called from any thread.
+        /// It has no effect unless an experiment is configured.</para>
+        /// </remarks>
+        /// <param name="units">The progress since the last call.</param>
+        void progress(_In_ const std::uint64_t units = 1) noexcept;
+
+        /// <summary>
+        /// Samples all sensors that are due and writes the buffered samples
+        /// on the calling thread.
+        /// </summary>
+        /// <remarks>
+        /// <para>This method must be called regularly from the loop of the
+        /// application if <see cref="collector_settings::manual_pump" /> is
+        /// set, because the library does not create any threads to sample the
+        /// sensors and to write the output in this case. It should be called
+        /// at least at the sampling interval of the fastest sensor, because
+        /// deadlines that have been missed by more than an interval are
+        /// skipped.</para>
+        /// <para>If <paramref name="budget" /> is exhausted by sampling, the
+        /// output is only written if the write latency has elapsed since the
+        /// last time. Due sensors that did not fit in the budget are sampled
+        /// by the next call, but at least one sensor is sampled by each call.
+        /// </para>
+        /// <para>The method must not be called concurrently with
+        /// <see cref="stop" />, which makes the last pass over the buffers
+        /// itself. It may be called while the collector is not running, in
+        /// which case it only samples sensors outside the collector.</para>
+        /// </remarks>
+        /// <param name="budget">The time in microseconds the method should
+        /// spend, or zero for sampling all due sensors and writing all
+        /// pending samples.</param>
+        /// <returns>The number of sampler ticks that have been run.</returns>
+        /// <exception cref="std::runtime_error">If the collector has been
+        /// moved.</exception>
+        /// <exception cref="std::logic_error">If the collector has not been
+        /// configured for manual pumping.</exception>
+        std::size_t pump(_In_ const collector_settings::sampling_interval_type
+            budget = 0);
+
+        /// <summary>
+        /// Registers a marker such that it can be set without copying its
+        /// text.
+        /// </summary>
+        /// <remarks>
+        /// Registering the same text multiple times yields the same ID.
+        /// </remarks>
+        /// <param name="marker">The text of the marker.</param>
+        /// <returns>The non-zero ID of the marker, which can be passed to
+        /// <see cref="marker" />.</returns>
+        /// <exception cref="std::runtime_error">If the collector has been
+        /// moved.</exception>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="marker" /> is <c>nullptr</c>.</exception>
+        std::uint32_t register_marker(_In_z_ const wchar_t *marker);
+
+        /// <summary>
+        /// Answer the number of samples the collector has retrieved from its
+        /// sensors since it has been started.
+        /// </summary>
+        /// <remarks>
+        /// The samples are counted by the I/O thread once it has processed
+        /// them, i.e. the number includes samples that have been discarded,
+        /// for instance while no marker was set, but not the ones reported by
+        /// <see cref="overflows" />. Together with the number of overflows,
+        /// this allows for monitoring the throughput of the collector while
+        /// it is running.
+        /// </remarks>
+        /// <returns>The number of samples retrieved, or zero if the collector
+        /// has been moved.</returns>
+        std::uint64_t samples(void) const noexcept;
+
+        /// <summary>
+        /// Changes the sampling interval of the first sensor with the given
+        /// name.
+        /// </summary>
+        /// <remarks>
+        /// If the collector is running, the sensor is restarted with the new
+        /// interval and a record of the change is written to the output, which
+        /// remains open. Setting the interval of the collector removes the
+        /// override for the sensor. See <see cref="attach" /> for the
+        /// thread-safety of this method.
+        /// </remarks>
+        /// <param name="name">The name of the sensor to be changed.</param>
+        /// <param name="interval">The new sampling interval in microseconds.
+        /// </param>
+        /// <returns><c>true</c> if the interval has been changed, <c>false</c>
+        /// if no sensor with the given name exists.</returns>
+        /// <exception cref="std::runtime_error">If the collector has been
+        /// moved.</exception>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="name" /> is <c>nullptr</c> or if
+        /// <paramref name="interval" /> is zero.</exception>
+        /// <exception cref="std::logic_error">If the sensor is an instrument
+        /// that is logging on its own while the collector is running or if
+        /// the sensor could not be restarted.</exception>
+        bool sampling_interval(_In_z_ const wchar_t *name,
+            _In_ const sensor::microseconds_type interval);
+
+        /// <summary>
+        /// Answer the name of the shared memory segment in which the collector
+        /// publishes the latest samples.
+        /// </summary>
+        /// <returns>The <see cref="collector_settings::shared_memory" />, or
+        /// <c>nullptr</c> if there is none or if the collector has been
+        /// moved.</returns>
+        _Ret_maybenull_z_ const wchar_t *shared_memory(void) const noexcept;
+
         /// <summary>
         /// Answer the number of sensors in the collector.
         /// </summary>
@@ -164,6 +597,42 @@ namespace power_overwhelming {
         /// </summary>
         void start(void);
 
+        /// <summary>
+        /// Takes a snapshot of the statistics about the pipeline from the
+        /// sensors to the output of the collector.
+        /// </summary>
+        /// <remarks>
+        /// The statistics are reset when the collector is started. Retrieving
+        /// them does not interfere with the threads delivering samples, so
+        /// this method can be called periodically while the collector is
+        /// running, for instance to monitor whether the I/O thread keeps up
+        /// with the sensors.
+        /// </remarks>
+        /// <returns>The current statistics, which are all zero if the
+        /// collector has been moved.</returns>
+        collector_statistics statistics(void) const;
+
+        /// <summary>
+        /// Configures all <see cref="tinkerforge_sensor" />s in the collector
+        /// for the lowest noise that still provides fresh data at the
+        /// sampling interval of the collector.
+        /// </summary>
+        /// <remarks>
+        /// See <see cref="tinkerforge_sensor::select_configuration" /> for
+        /// details of how the configuration is chosen. All bricklets are
+        /// configured at once via
+        /// <see cref="tinkerforge_sensor::configure_all" />, which also allows
+        /// for starting them in quick succession afterwards. The method must
+        /// not be called while the collector is running. Sensors whose opening
+        /// has been deferred are opened by this method.
+        /// </remarks>
+        /// <returns>The number of sensors that have been configured.</returns>
+        /// <exception cref="std::runtime_error">If the collector has been
+        /// moved.</exception>
+        /// <exception cref="tinkerforge_exception">If a bricklet could not be
+        /// configured.</exception>
+        std::size_t tune_tinkerforge_sensors(void);
+
         /// <summary>
         /// Stop collecting.
         /// </summary>
@@ -173,6 +642,66 @@ namespace power_overwhelming {
         /// </remarks>
         void stop(void);
 
+        /// <summary>
+        /// Creates a subscriber that receives the live samples of the
+        /// collector within the process.
+        /// </summary>
+        /// <remarks>
+        /// <para>All subscribers share a single ring of
+        /// <see cref="collector_settings::subscriber_capacity" /> samples,
+        /// which the I/O thread fills while it drains the buffers, so a
+        /// single read of the hardware feeds the output file and any number
+        /// of subscribers. A new subscriber receives all samples published
+        /// after it has been created. Subscribers can be created at any time,
+        /// including while the collector is running.</para>
+        /// <para>The samples are only copied into the ring as long as at
+        /// least one subscriber exists.</para>
+        /// </remarks>
+        /// <param name="overflow">Determines which samples are lost if the
+        /// subscriber falls behind.</param>
+        /// <returns>A new subscriber.</returns>
+        /// <exception cref="std::runtime_error">If the collector has been
+        /// moved.</exception>
+        /// <exception cref="std::bad_alloc">If the ring could not be
+        /// allocated.</exception>
+        collector_subscriber subscribe(_In_ const subscriber_overflow overflow
+            = subscriber_overflow::drop_oldest);
+
+        /// <summary>
+        /// Creates a frame marker that attributes the energy to the frames of
+        /// an interactive application.
+        /// </summary>
+        /// <remarks>
+        /// Each frame is recorded as an event of the marker with the given
+        /// text. See <see cref="frame_marker" /> for details.
+        /// </remarks>
+        /// <param name="marker">The text of the marker the frames are
+        /// recorded as.</param>
+        /// <returns>A new frame marker.</returns>
+        /// <exception cref="std::runtime_error">If the collector has been
+        /// moved.</exception>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="marker" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::logic_error">If another frame marker for the
+        /// collector exists.</exception>
+        frame_marker track_frames(_In_z_ const wchar_t *marker = L"frame");
+
+        /// <summary>
+        /// Raises a trigger in capture mode, which persists the samples in the
+        /// window around the current time.
+        /// </summary>
+        /// <remarks>
+        /// This method only records the current time, which allows for
+        /// calling it on the thread being measured, e.g. right before
+        /// launching a kernel. See
+        /// <see cref="collector_settings::pre_trigger" /> for a description
+        /// of the capture mode. If the capture mode is disabled, the method
+        /// has no effect.
+        /// </remarks>
+        /// <exception cref="std::runtime_error">If the collector has been
+        /// moved.</exception>
+        void trigger(void);
+
         /// <summary>
         /// Move assignment.
         /// </summary>
@@ -233,6 +762,15 @@ namespace power_overwhelming {
         /// must have been allocated using C++ <c>new</c>.</param>
         void add(_In_ sensor *sensor);
 
+        /// <summary>
+        /// Adds a new sensor to the possibly running collector.
+        /// </summary>
+        /// <param name="sensor">The sensor to be added. The object takes
+        /// ownership of the object designated by this pointer if the method
+        /// succeeds. The object must have been allocated using C++
+        /// <c>new</c>.</param>
+        void attach_sensor(_In_ sensor *sensor);
+
         detail::collector_impl *_impl;
 
     };
@@ -31,6 +31,19 @@ namespace detail {
 } /* namespace visus */
 
 
+/*
+ * visus::power_overwhelming::collector::attach
+ */
+template<class TSensor>
+void visus::power_overwhelming::collector::attach(TSensor&& sensor) {
+    std::unique_ptr<power_overwhelming::sensor> instance(
+        new typename std::decay<TSensor>::type(std::move(sensor)));
+    // See 'from_sensors' for the rationale of only passing raw pointers.
+    this->attach_sensor(instance.get());
+    instance.release();
+}
+
+
 /*
  * visus::power_overwhelming::collector::from_sensor_lists
  */
@@ -0,0 +1,134 @@
+﻿// <copyright file="collector_agent.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+
+#include "power_overwhelming/collector.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations */
+    namespace detail { struct collector_agent_impl; }
+
+    /// <summary>
+    /// A TCP server that allows a <see cref="collector_coordinator" /> on
+    /// another node to start and stop a local <see cref="collector" /> and to
+    /// set its markers.
+    /// </summary>
+    /// <remarks>
+    /// <para>The agent serves one coordinator at a time on a dedicated
+    /// thread. Once a coordinator has connected, the agent synchronises with
+    /// the clock of the coordinator using a <see cref="time_synchroniser" />
+    /// and repeats the synchronisation every second while it is idle. The
+    /// requests of the coordinator carry time stamps on its clock, which the
+    /// agent converts to its own clock and waits for before starting the
+    /// collector or setting the marker. This way, all nodes start and switch
+    /// phases at the same instant, even if the network delays the requests
+    /// differently.</para>
+    /// <para>The collector writes its output locally as configured, or
+    /// streams it to wherever its output points to, such that the overhead
+    /// of persisting the samples stays on the node. The coordinator only
+    /// receives the number of samples and overflows when the collector is
+    /// stopped. If the coordinator disconnects while the collector is
+    /// running, the collector is stopped.</para>
+    /// <para>The agent requires the library to be built with support for
+    /// the time synchronisation.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API collector_agent final {
+
+    public:
+
+        /// <summary>
+        /// The default TCP port the agent is listening on.
+        /// </summary>
+        static constexpr std::uint16_t default_port = 48620;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <exception cref="std::bad_alloc">If the state of the agent could
+        /// not be allocated.</exception>
+        collector_agent(void);
+
+        collector_agent(const collector_agent&) = delete;
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline collector_agent(_Inout_ collector_agent&& rhs) noexcept
+                : _impl(rhs._impl) {
+            rhs._impl = nullptr;
+        }
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        /// <remarks>
+        /// The destructor stops the server, which stops the collector if it
+        /// is running.
+        /// </remarks>
+        ~collector_agent(void);
+
+        /// <summary>
+        /// Starts accepting a coordinator.
+        /// </summary>
+        /// <param name="collector">The collector to be controlled by the
+        /// coordinator, which must outlive the agent or at least until
+        /// <see cref="stop" /> has been called.</param>
+        /// <param name="port">The TCP port to listen on.</param>
+        /// <param name="address">The local address to bind to, or
+        /// <c>nullptr</c> for all IPv4 interfaces.</param>
+        /// <param name="sync_port">The UDP port of the time synchroniser of
+        /// the agent, which is chosen by the system if zero.</param>
+        /// <exception cref="std::runtime_error">If the object has been moved.
+        /// </exception>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="collector" /> has been disposed.</exception>
+        /// <exception cref="std::logic_error">If the agent is already
+        /// running.</exception>
+        /// <exception cref="std::system_error">If the socket could not be
+        /// bound.</exception>
+        void start(_In_ collector& collector,
+            _In_ const std::uint16_t port = default_port,
+            _In_opt_z_ const wchar_t *address = nullptr,
+            _In_ const std::uint16_t sync_port = 0);
+
+        /// <summary>
+        /// Stops the server and the collector if the coordinator has started
+        /// it.
+        /// </summary>
+        void stop(void) noexcept;
+
+        collector_agent& operator =(const collector_agent&) = delete;
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_agent& operator =(_Inout_ collector_agent&& rhs) noexcept;
+
+        /// <summary>
+        /// Determines whether the object is valid.
+        /// </summary>
+        /// <remarks>
+        /// The object is valid unless it has been disposed by a move.
+        /// </remarks>
+        /// <returns><c>true</c> if the object is valid, <c>false</c>
+        /// otherwise.</returns>
+        operator bool(void) const noexcept;
+
+    private:
+
+        detail::collector_agent_impl *_impl;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
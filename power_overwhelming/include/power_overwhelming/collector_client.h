@@ -0,0 +1,454 @@
+﻿// <copyright file="collector_client.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else /* defined(_WIN32) */
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif /* defined(_WIN32) */
+
+#include "power_overwhelming/marker_channel.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The magic number identifying the shared memory segment through which
+    /// other processes control a <see cref="collector_daemon" />.
+    /// </summary>
+    static constexpr char collector_daemon_magic[8] = {
+        'P', 'w', 'r', 'O', 'w', 'g', 'D', 'm'
+    };
+
+    /// <summary>
+    /// The version of the layout of the control segment of the daemon.
+    /// </summary>
+    static constexpr std::uint32_t collector_daemon_version = 2;
+
+    /// <summary>
+    /// The requests a client can send to the daemon.
+    /// </summary>
+    enum class collector_daemon_request : std::uint32_t {
+
+        /// <summary>
+        /// Redirects the output to the recording named in
+        /// <see cref="collector_daemon_header::name" /> and starts the
+        /// collector.
+        /// </summary>
+        start = 1,
+
+        /// <summary>
+        /// Stops the collector.
+        /// </summary>
+        stop = 2
+    };
+
+    /// <summary>
+    /// The states of the single request slot in the control segment.
+    /// </summary>
+    /// <remarks>
+    /// <para>A client claims the idle slot, fills the request and marks it
+    /// requested. The daemon marks the requests it picks up as processing and
+    /// the ones it has completed as such, whereupon the client reads the
+    /// response and releases the slot.</para>
+    /// <para>A client that dies while it holds the slot in the claimed or
+    /// completed state would block all other clients forever. The client
+    /// therefore records itself as the
+    /// <see cref="collector_daemon_header::owner" /> of its claim, and the
+    /// daemon releases slots whose owner has exited or that have not moved
+    /// on for a long time.</para>
+    /// </remarks>
+    enum class collector_daemon_state : std::uint32_t {
+        idle = 0,
+        claimed = 1,
+        requested = 2,
+        processing = 3,
+        completed = 4
+    };
+
+    /// <summary>
+    /// The control segment of a <see cref="collector_daemon" />.
+    /// </summary>
+    struct collector_daemon_header final {
+
+        /// <summary>
+        /// The maximum length of the names in the segment in bytes,
+        /// including the terminating zero.
+        /// </summary>
+        static constexpr std::size_t max_name = 128;
+
+        /// <summary>
+        /// The maximum length of an error message in bytes, including the
+        /// terminating zero.
+        /// </summary>
+        static constexpr std::size_t max_message = 256;
+
+        /// <summary>
+        /// The <see cref="collector_daemon_magic" />.
+        /// </summary>
+        char magic[sizeof(collector_daemon_magic)];
+
+        /// <summary>
+        /// The <see cref="collector_daemon_version" />.
+        /// </summary>
+        std::uint32_t version;
+
+        /// <summary>
+        /// Non-zero while the daemon is serving requests.
+        /// </summary>
+        std::atomic<std::uint32_t> active;
+
+        /// <summary>
+        /// The <see cref="collector_daemon_state" /> of the request slot.
+        /// </summary>
+        std::atomic<std::uint32_t> state;
+
+        /// <summary>
+        /// The <see cref="collector_daemon_request" /> in the slot.
+        /// </summary>
+        std::uint32_t request;
+
+        /// <summary>
+        /// Zero if the request succeeded, non-zero if it failed with
+        /// <see cref="message" />.
+        /// </summary>
+        std::uint32_t status;
+
+        /// <summary>
+        /// Non-zero while a recording is running.
+        /// </summary>
+        std::atomic<std::uint32_t> recording;
+
+        /// <summary>
+        /// The ID of the process of the client that has claimed the slot.
+        /// </summary>
+        std::atomic<std::uint64_t> owner;
+
+        /// <summary>
+        /// The time on the steady clock in nanoseconds at which the
+        /// <see cref="owner" /> has claimed the slot, which distinguishes
+        /// subsequent claims of the same process.
+        /// </summary>
+        std::atomic<std::uint64_t> claim_time;
+
+        /// <summary>
+        /// The number of samples of the last recording that has been stopped.
+        /// </summary>
+        std::uint64_t samples;
+
+        /// <summary>
+        /// The number of samples dropped in the last recording that has been
+        /// stopped.
+        /// </summary>
+        std::uint64_t overflows;
+
+        /// <summary>
+        /// The UTF-8 name of the marker channel of the collector, which is
+        /// empty if the collector has none.
+        /// </summary>
+        char marker_channel[max_name];
+
+        /// <summary>
+        /// The UTF-8 name of the segment in which the collector publishes the
+        /// latest samples, which is empty if the collector has none.
+        /// </summary>
+        char shared_memory[max_name];
+
+        /// <summary>
+        /// The UTF-8 name of the recording to be started.
+        /// </summary>
+        char name[max_name];
+
+        /// <summary>
+        /// The UTF-8 error message if the request failed.
+        /// </summary>
+        char message[max_message];
+    };
+
+    static_assert(sizeof(collector_daemon_header) == 704, "The layout of the "
+        "control segment of the collector daemon must not depend on the "
+        "compiler.");
+
+} /* namespace detail */
+
+
+    /// <summary>
+    /// Starts and stops named recordings of a <see cref="collector_daemon" />
+    /// running in another process.
+    /// </summary>
+    /// <remarks>
+    /// <para>The daemon keeps its sensors open between the recordings, which
+    /// spares the benchmark the initialisation of the vendor libraries and
+    /// instruments on each run. Like <see cref="marker_channel" />, this
+    /// class is implemented in its header only, so benchmarks can include it
+    /// without linking against the library.</para>
+    /// <para>The requests are passed through a named shared memory segment,
+    /// which holds a single request at a time. The daemon polls the segment
+    /// every millisecond, so starting a recording typically takes a few
+    /// milliseconds plus the time the collector needs to start its sensors.
+    /// While the recording is running, markers can be set through
+    /// <see cref="markers" /> and the latest samples can be read using a
+    /// <see cref="shared_measurement_reader" /> on
+    /// <see cref="shared_memory" /> if the collector has been configured
+    /// accordingly.</para>
+    /// <para>An instance must only be used by one thread at a time, but
+    /// requests from any number of instances in any number of processes are
+    /// served one after the other.</para>
+    /// </remarks>
+    class collector_client final {
+
+    public:
+
+        /// <summary>
+        /// The name of the control segment a
+        /// <see cref="collector_daemon" /> creates by default.
+        /// </summary>
+        static constexpr const char *default_channel
+            = "PwrOwgCollectorDaemon";
+
+        /// <summary>
+        /// The default time in milliseconds a request waits for the daemon to
+        /// pick it up.
+        /// </summary>
+        static constexpr unsigned int default_timeout = 5000;
+
+        /// <summary>
+        /// Initialises a new instance that is not connected to any daemon.
+        /// </summary>
+        inline collector_client(void) noexcept : _header(nullptr)
+#if defined(_WIN32)
+            , _mapping(NULL)
+#endif /* defined(_WIN32) */
+            , _size(0) { }
+
+        /// <summary>
+        /// Initialises a new instance connected to the given daemon.
+        /// </summary>
+        /// <param name="channel">The name of the control segment of the
+        /// daemon, which must only contain ASCII characters.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="channel" /> is <c>nullptr</c> or empty.
+        /// </exception>
+        /// <exception cref="std::system_error">If the daemon is not running
+        /// or its segment could not be mapped.</exception>
+        /// <exception cref="std::runtime_error">If the segment does not have
+        /// a supported layout.</exception>
+        explicit collector_client(_In_z_ const char *channel);
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline collector_client(_Inout_ collector_client&& rhs) noexcept
+                : collector_client() {
+            this->swap(rhs);
+        }
+
+        collector_client(const collector_client&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        inline ~collector_client(void) {
+            this->close();
+        }
+
+        /// <summary>
+        /// Answer whether the daemon is still serving requests.
+        /// </summary>
+        /// <returns><c>true</c> if the daemon is running, <c>false</c> if it
+        /// has exited or the object is invalid.</returns>
+        inline bool active(void) const noexcept {
+            return (this->_header != nullptr)
+                && (this->_header->active.load(std::memory_order_relaxed)
+                != 0);
+        }
+
+        /// <summary>
+        /// Answer the name of the marker channel of the collector.
+        /// </summary>
+        /// <returns>The name of the channel, or <c>nullptr</c> if the
+        /// collector has none or the object is invalid.</returns>
+        inline _Ret_maybenull_z_ const char *marker_channel(
+                void) const noexcept {
+            return ((this->_header != nullptr)
+                && (this->_header->marker_channel[0] != 0))
+                ? this->_header->marker_channel
+                : nullptr;
+        }
+
+        /// <summary>
+        /// Opens the marker channel of the collector.
+        /// </summary>
+        /// <remarks>
+        /// The collector only creates its marker channel while it is
+        /// running, so this method must be called after the recording has
+        /// been started, and the channel must be reopened for each
+        /// recording.
+        /// </remarks>
+        /// <returns>A channel for setting markers in the recording.</returns>
+        /// <exception cref="std::logic_error">If the collector does not have
+        /// a marker channel.</exception>
+        /// <exception cref="std::system_error">If the channel could not be
+        /// opened.</exception>
+        inline power_overwhelming::marker_channel markers(void) const {
+            auto name = this->marker_channel();
+            if (name == nullptr) {
+                throw std::logic_error("The collector of the daemon does not "
+                    "have a marker channel.");
+            }
+            return power_overwhelming::marker_channel(name);
+        }
+
+        /// <summary>
+        /// Answer whether the daemon is running a recording.
+        /// </summary>
+        /// <returns><c>true</c> if a recording is running, <c>false</c>
+        /// otherwise.</returns>
+        inline bool recording(void) const noexcept {
+            return (this->_header != nullptr)
+                && (this->_header->recording.load(std::memory_order_acquire)
+                != 0);
+        }
+
+        /// <summary>
+        /// Answer the name of the segment in which the collector publishes
+        /// the latest samples.
+        /// </summary>
+        /// <returns>The name of the segment, or <c>nullptr</c> if the
+        /// collector does not publish its samples or the object is invalid.
+        /// </returns>
+        inline _Ret_maybenull_z_ const char *shared_memory(
+                void) const noexcept {
+            return ((this->_header != nullptr)
+                && (this->_header->shared_memory[0] != 0))
+                ? this->_header->shared_memory
+                : nullptr;
+        }
+
+        /// <summary>
+        /// Starts a recording with the given name.
+        /// </summary>
+        /// <remarks>
+        /// The daemon writes the recording to the directory of the output
+        /// configured for its collector, replacing the file name, but
+        /// retaining the extension.
+        /// </remarks>
+        /// <param name="name">The UTF-8 name of the recording, which must be
+        /// a valid file name without extension.</param>
+        /// <param name="timeout">The time in milliseconds to wait for the
+        /// daemon to pick up the request. Once picked up, the method waits
+        /// until the collector has started.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="name" /> is <c>nullptr</c>, empty or too long.
+        /// </exception>
+        /// <exception cref="std::system_error">If the daemon did not pick up
+        /// the request in time.</exception>
+        /// <exception cref="std::runtime_error">If the object is invalid, if
+        /// the daemon has exited or if the recording could not be started.
+        /// </exception>
+        void start(_In_z_ const char *name,
+            _In_ const unsigned int timeout = default_timeout);
+
+        /// <summary>
+        /// Stops the running recording.
+        /// </summary>
+        /// <param name="samples">Receives the number of samples the collector
+        /// has retrieved in the recording.</param>
+        /// <param name="overflows">Receives the number of samples that have
+        /// been dropped in the recording.</param>
+        /// <param name="timeout">The time in milliseconds to wait for the
+        /// daemon to pick up the request.</param>
+        /// <exception cref="std::system_error">If the daemon did not pick up
+        /// the request in time.</exception>
+        /// <exception cref="std::runtime_error">If the object is invalid, if
+        /// the daemon has exited or if no recording is running.</exception>
+        void stop(_Out_opt_ std::uint64_t *samples = nullptr,
+            _Out_opt_ std::uint64_t *overflows = nullptr,
+            _In_ const unsigned int timeout = default_timeout);
+
+        collector_client& operator =(const collector_client&) = delete;
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        inline collector_client& operator =(
+                _Inout_ collector_client&& rhs) noexcept {
+            if (this != &rhs) {
+                this->close();
+                this->swap(rhs);
+            }
+            return *this;
+        }
+
+        /// <summary>
+        /// Determines whether the object is valid.
+        /// </summary>
+        /// <returns><c>true</c> if the object is connected to a daemon,
+        /// <c>false</c> otherwise.</returns>
+        inline operator bool(void) const noexcept {
+            return (this->_header != nullptr);
+        }
+
+    private:
+
+        /// <summary>
+        /// Unmaps the control segment.
+        /// </summary>
+        void close(void) noexcept;
+
+        /// <summary>
+        /// Passes a request to the daemon and waits for its completion.
+        /// </summary>
+        void request(_In_ const detail::collector_daemon_request request,
+            _In_opt_z_ const char *name,
+            _Out_opt_ std::uint64_t *samples,
+            _Out_opt_ std::uint64_t *overflows,
+            _In_ const unsigned int timeout);
+
+        /// <summary>
+        /// Exchanges the segments of this object and <paramref name="rhs" />.
+        /// </summary>
+        inline void swap(_Inout_ collector_client& rhs) noexcept {
+            std::swap(this->_header, rhs._header);
+#if defined(_WIN32)
+            std::swap(this->_mapping, rhs._mapping);
+#endif /* defined(_WIN32) */
+            std::swap(this->_size, rhs._size);
+        }
+
+        detail::collector_daemon_header *_header;
+#if defined(_WIN32)
+        HANDLE _mapping;
+#endif /* defined(_WIN32) */
+        std::size_t _size;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+#include "power_overwhelming/collector_client.inl"
@@ -0,0 +1,269 @@
+﻿// <copyright file="collector_client.inl" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+
+/*
+ * visus::power_overwhelming::collector_client::collector_client
+ */
+inline visus::power_overwhelming::collector_client::collector_client(
+        _In_z_ const char *channel) : collector_client() {
+    if ((channel == nullptr) || (*channel == 0)) {
+        throw std::invalid_argument("The name of the control segment of the "
+            "collector daemon must not be empty.");
+    }
+
+#if defined(_WIN32)
+    this->_mapping = ::OpenFileMappingA(FILE_MAP_READ | FILE_MAP_WRITE, FALSE,
+        channel);
+    if (this->_mapping == NULL) {
+        throw std::system_error(::GetLastError(), std::system_category());
+    }
+
+    auto view = ::MapViewOfFile(this->_mapping, FILE_MAP_READ | FILE_MAP_WRITE,
+        0, 0, 0);
+    if (view == nullptr) {
+        auto error = ::GetLastError();
+        ::CloseHandle(this->_mapping);
+        this->_mapping = NULL;
+        throw std::system_error(error, std::system_category());
+    }
+
+    MEMORY_BASIC_INFORMATION info;
+    this->_size = (::VirtualQuery(view, &info, sizeof(info)) != 0)
+        ? info.RegionSize
+        : 0;
+#else /* defined(_WIN32) */
+    std::string path(channel);
+    if (path.front() != '/') {
+        path.insert(path.begin(), '/');
+    }
+
+    auto handle = ::shm_open(path.c_str(), O_RDWR, 0);
+    if (handle < 0) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    struct stat info;
+    if (::fstat(handle, &info) != 0) {
+        auto error = errno;
+        ::close(handle);
+        throw std::system_error(error, std::system_category());
+    }
+
+    this->_size = static_cast<std::size_t>(info.st_size);
+    auto view = ::mmap(nullptr, this->_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED, handle, 0);
+    auto error = errno;
+    ::close(handle);
+
+    if (view == MAP_FAILED) {
+        this->_size = 0;
+        throw std::system_error(error, std::system_category());
+    }
+#endif /* defined(_WIN32) */
+
+    this->_header = static_cast<detail::collector_daemon_header *>(view);
+
+    const auto valid = (this->_size >= sizeof(detail::collector_daemon_header))
+        && (std::memcmp(this->_header->magic, detail::collector_daemon_magic,
+            sizeof(detail::collector_daemon_magic)) == 0)
+        && (this->_header->version == detail::collector_daemon_version);
+    if (!valid) {
+        this->close();
+        throw std::runtime_error("The shared memory segment is not the "
+            "control segment of a collector daemon of a compatible version.");
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::collector_client::start
+ */
+inline void visus::power_overwhelming::collector_client::start(
+        _In_z_ const char *name,
+        _In_ const unsigned int timeout) {
+    typedef detail::collector_daemon_header header_type;
+
+    if ((name == nullptr) || (*name == 0)) {
+        throw std::invalid_argument("The name of a recording must not be "
+            "empty.");
+    }
+    if (std::strlen(name) >= header_type::max_name) {
+        throw std::invalid_argument("The name of the recording is too long.");
+    }
+
+    this->request(detail::collector_daemon_request::start, name, nullptr,
+        nullptr, timeout);
+}
+
+
+/*
+ * visus::power_overwhelming::collector_client::stop
+ */
+inline void visus::power_overwhelming::collector_client::stop(
+        _Out_opt_ std::uint64_t *samples,
+        _Out_opt_ std::uint64_t *overflows,
+        _In_ const unsigned int timeout) {
+    this->request(detail::collector_daemon_request::stop, nullptr, samples,
+        overflows, timeout);
+}
+
+
+/*
+ * visus::power_overwhelming::collector_client::close
+ */
+inline void visus::power_overwhelming::collector_client::close(
+        void) noexcept {
+    if (this->_header != nullptr) {
+#if defined(_WIN32)
+        ::UnmapViewOfFile(this->_header);
+        ::CloseHandle(this->_mapping);
+        this->_mapping = NULL;
+#else /* defined(_WIN32) */
+        ::munmap(this->_header, this->_size);
+#endif /* defined(_WIN32) */
+        this->_header = nullptr;
+        this->_size = 0;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::collector_client::request
+ */
+inline void visus::power_overwhelming::collector_client::request(
+        _In_ const detail::collector_daemon_request request,
+        _In_opt_z_ const char *name,
+        _Out_opt_ std::uint64_t *samples,
+        _Out_opt_ std::uint64_t *overflows,
+        _In_ const unsigned int timeout) {
+    using namespace std::chrono;
+    typedef detail::collector_daemon_header header_type;
+    typedef detail::collector_daemon_state state_type;
+    const auto claimed = static_cast<std::uint32_t>(state_type::claimed);
+    const auto completed = static_cast<std::uint32_t>(state_type::completed);
+    const auto idle = static_cast<std::uint32_t>(state_type::idle);
+    const auto requested = static_cast<std::uint32_t>(state_type::requested);
+    const auto poll_interval = microseconds(100);
+
+    if (this->_header == nullptr) {
+        throw std::runtime_error("The client is not connected to a collector "
+            "daemon.");
+    }
+
+    const auto deadline = steady_clock::now() + milliseconds(timeout);
+    auto check_alive = [this, deadline](void) {
+        if (!this->active()) {
+            throw std::runtime_error("The collector daemon has exited.");
+        }
+        if (steady_clock::now() > deadline) {
+            throw std::system_error(std::make_error_code(
+                std::errc::timed_out));
+        }
+    };
+
+    // Wait for the requests of other clients to complete before we claim the
+    // slot for ours.
+    for (auto expected = idle; !this->_header->state.compare_exchange_weak(
+            expected, claimed, std::memory_order_acquire,
+            std::memory_order_relaxed);
+            expected = idle) {
+        check_alive();
+        std::this_thread::sleep_for(poll_interval);
+    }
+
+    // Tell the daemon who we are such that it can release the slot if we die
+    // before we release it ourselves.
+#if defined(_WIN32)
+    this->_header->owner.store(::GetCurrentProcessId(),
+        std::memory_order_relaxed);
+#else /* defined(_WIN32) */
+    this->_header->owner.store(static_cast<std::uint64_t>(::getpid()),
+        std::memory_order_relaxed);
+#endif /* defined(_WIN32) */
+    this->_header->claim_time.store(static_cast<std::uint64_t>(
+        duration_cast<nanoseconds>(steady_clock::now().time_since_epoch())
+        .count()), std::memory_order_relaxed);
+
+    this->_header->request = static_cast<std::uint32_t>(request);
+    {
+        std::size_t len = 0;
+        if (name != nullptr) {
+            while ((len < header_type::max_name - 1) && (name[len] != 0)) {
+                ++len;
+            }
+            std::memcpy(this->_header->name, name, len);
+        }
+        this->_header->name[len] = 0;
+    }
+
+    // The daemon might have revoked our claim if we have been stalled for a
+    // very long time, in which case the slot might belong to someone else.
+    {
+        auto expected = claimed;
+        if (!this->_header->state.compare_exchange_strong(expected, requested,
+                std::memory_order_release, std::memory_order_relaxed)) {
+            throw std::system_error(std::make_error_code(
+                std::errc::timed_out));
+        }
+    }
+
+    // The request can be withdrawn as long as the daemon has not picked it
+    // up. Afterwards, we must wait for the daemon, because starting the
+    // collector takes as long as it takes.
+    for (;;) {
+        const auto state = this->_header->state.load(
+            std::memory_order_acquire);
+        if (state == completed) {
+            break;
+        }
+
+        if (state == requested) {
+            try {
+                check_alive();
+            } catch (...) {
+                auto expected = requested;
+                if (this->_header->state.compare_exchange_strong(expected,
+                        idle, std::memory_order_relaxed)) {
+                    throw;
+                }
+                continue;
+            }
+
+        } else if (!this->active()) {
+            throw std::runtime_error("The collector daemon has exited while "
+                "processing the request.");
+        }
+
+        std::this_thread::sleep_for(poll_interval);
+    }
+
+    const auto failed = (this->_header->status != 0);
+    char message[header_type::max_message];
+    std::memcpy(message, this->_header->message, sizeof(message));
+    message[sizeof(message) - 1] = 0;
+
+    if (samples != nullptr) {
+        *samples = this->_header->samples;
+    }
+    if (overflows != nullptr) {
+        *overflows = this->_header->overflows;
+    }
+
+    {
+        auto expected = completed;
+        if (!this->_header->state.compare_exchange_strong(expected, idle,
+                std::memory_order_release, std::memory_order_relaxed)) {
+            // Same as for the claim: the response might have been
+            // overwritten by the request of another client.
+            throw std::system_error(std::make_error_code(
+                std::errc::timed_out));
+        }
+    }
+
+    if (failed) {
+        throw std::runtime_error(message);
+    }
+}
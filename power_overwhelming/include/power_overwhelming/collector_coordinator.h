@@ -0,0 +1,235 @@
+﻿// <copyright file="collector_coordinator.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+
+#include "power_overwhelming/collector_agent.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations */
+    namespace detail { struct collector_coordinator_impl; }
+
+    /// <summary>
+    /// Controls the <see cref="collector" />s on multiple nodes via their
+    /// <see cref="collector_agent" />s.
+    /// </summary>
+    /// <remarks>
+    /// <para>The coordinator runs a <see cref="time_synchroniser" /> that the
+    /// agents use to estimate its clock. All requests are scheduled on the
+    /// clock of the coordinator a configurable lead time ahead, such that
+    /// each agent can convert the instant to its own clock and wait for it.
+    /// The lead time must be larger than the time it takes the requests to
+    /// reach all nodes, otherwise the late nodes execute the request
+    /// immediately, which is reported by <see cref="start_deviation" /> for
+    /// the start.</para>
+    /// <para>All methods block until every agent has answered, and they are
+    /// not thread-safe.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API collector_coordinator final {
+
+    public:
+
+        /// <summary>
+        /// The default UDP port of the time synchroniser of the coordinator.
+        /// </summary>
+        static constexpr std::uint16_t default_sync_port = 48621;
+
+        /// <summary>
+        /// The default lead time of markers in microseconds.
+        /// </summary>
+        static constexpr sensor::microseconds_type default_marker_lead
+            = 50000;
+
+        /// <summary>
+        /// The default lead time of the start in microseconds.
+        /// </summary>
+        static constexpr sensor::microseconds_type default_start_lead
+            = 1000000;
+
+        /// <summary>
+        /// Creates a new coordinator.
+        /// </summary>
+        /// <param name="address_family">The address family used for the
+        /// agents and for the time synchroniser, e.g. <c>AF_INET</c>.</param>
+        /// <param name="sync_port">The UDP port the time synchroniser is
+        /// listening on.</param>
+        /// <returns>A new coordinator without any agents.</returns>
+        /// <exception cref="std::logic_error">If the library has been built
+        /// without support for the time synchronisation.</exception>
+        /// <exception cref="std::system_error">If the time synchroniser could
+        /// not be started.</exception>
+        static collector_coordinator create(_In_ const int address_family,
+            _In_ const std::uint16_t sync_port = default_sync_port);
+
+        /// <summary>
+        /// Initialise a new instance.
+        /// </summary>
+        /// <remarks>
+        /// The default instance is created disposed, ie cannot be used for
+        /// anything, but assigning another instance created by
+        /// <see cref="create" />.
+        /// </remarks>
+        inline collector_coordinator(void) : _impl(nullptr) { }
+
+        collector_coordinator(const collector_coordinator&) = delete;
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline collector_coordinator(_Inout_ collector_coordinator&& rhs)
+                noexcept : _impl(rhs._impl) {
+            rhs._impl = nullptr;
+        }
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        /// <remarks>
+        /// The destructor disconnects from all agents, which stop their
+        /// collectors if they are still running.
+        /// </remarks>
+        ~collector_coordinator(void);
+
+        /// <summary>
+        /// Connects to the agent on the given node.
+        /// </summary>
+        /// <param name="host">The host name or address of the node.</param>
+        /// <param name="port">The TCP port the agent is listening on.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="host" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::runtime_error">If the coordinator has been
+        /// disposed, if the name of the host could not be resolved or if the
+        /// agent rejected the session.</exception>
+        /// <exception cref="std::system_error">If the connection could not be
+        /// established.</exception>
+        collector_coordinator& add(_In_z_ const char *host,
+            _In_ const std::uint16_t port = collector_agent::default_port);
+
+        /// <summary>
+        /// Sets a marker on all nodes at the same instant.
+        /// </summary>
+        /// <param name="marker">The text of the marker, or <c>nullptr</c> for
+        /// ending the current phase.</param>
+        /// <param name="lead">The time in microseconds from now at which the
+        /// marker is set.</param>
+        /// <exception cref="std::runtime_error">If the coordinator has been
+        /// disposed or if an agent failed to set the marker.</exception>
+        /// <exception cref="std::system_error">If the communication with an
+        /// agent failed.</exception>
+        void marker(_In_opt_z_ const wchar_t *marker,
+            _In_ const sensor::microseconds_type lead = default_marker_lead);
+
+        /// <summary>
+        /// Answer the name of a node.
+        /// </summary>
+        /// <param name="node">The zero-based index of the node.</param>
+        /// <returns>The name the agent reported for its computer.</returns>
+        /// <exception cref="std::out_of_range">If <paramref name="node" />
+        /// is not a valid index.</exception>
+        const wchar_t *node(_In_ const std::size_t node) const;
+
+        /// <summary>
+        /// Answer the number of nodes added to the coordinator.
+        /// </summary>
+        /// <returns>The number of nodes, which is zero if the coordinator has
+        /// been disposed.</returns>
+        std::size_t nodes(void) const noexcept;
+
+        /// <summary>
+        /// Answer the number of samples the collector of a node dropped
+        /// during the last run.
+        /// </summary>
+        /// <param name="node">The zero-based index of the node.</param>
+        /// <returns>The number of overflows reported when the collector has
+        /// been stopped.</returns>
+        /// <exception cref="std::out_of_range">If <paramref name="node" />
+        /// is not a valid index.</exception>
+        std::uint64_t overflows(_In_ const std::size_t node) const;
+
+        /// <summary>
+        /// Answer the number of samples the collector of a node retrieved
+        /// during the last run.
+        /// </summary>
+        /// <param name="node">The zero-based index of the node.</param>
+        /// <returns>The number of samples reported when the collector has
+        /// been stopped.</returns>
+        /// <exception cref="std::out_of_range">If <paramref name="node" />
+        /// is not a valid index.</exception>
+        std::uint64_t samples(_In_ const std::size_t node) const;
+
+        /// <summary>
+        /// Starts the collectors on all nodes at the same instant.
+        /// </summary>
+        /// <param name="lead">The time in microseconds from now at which the
+        /// collectors are started.</param>
+        /// <exception cref="std::runtime_error">If the coordinator has been
+        /// disposed or if an agent failed to start its collector.</exception>
+        /// <exception cref="std::system_error">If the communication with an
+        /// agent failed.</exception>
+        void start(
+            _In_ const sensor::microseconds_type lead = default_start_lead);
+
+        /// <summary>
+        /// Answer by how much a node missed the instant of the last start.
+        /// </summary>
+        /// <remarks>
+        /// The deviation is measured on the clock of the node after its
+        /// conversion of the instant, i.e. it does not include the error of
+        /// the time synchronisation.
+        /// </remarks>
+        /// <param name="node">The zero-based index of the node.</param>
+        /// <returns>The delay in microseconds between the requested instant
+        /// and the call to <see cref="collector::start" />.</returns>
+        /// <exception cref="std::out_of_range">If <paramref name="node" />
+        /// is not a valid index.</exception>
+        sensor::microseconds_type start_deviation(
+            _In_ const std::size_t node) const;
+
+        /// <summary>
+        /// Stops the collectors on all nodes and retrieves their
+        /// <see cref="samples" /> and <see cref="overflows" />.
+        /// </summary>
+        /// <exception cref="std::runtime_error">If the coordinator has been
+        /// disposed or if an agent failed to stop its collector.</exception>
+        /// <exception cref="std::system_error">If the communication with an
+        /// agent failed.</exception>
+        void stop(void);
+
+        collector_coordinator& operator =(
+            const collector_coordinator&) = delete;
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_coordinator& operator =(
+            _Inout_ collector_coordinator&& rhs) noexcept;
+
+        /// <summary>
+        /// Determines whether the object is valid.
+        /// </summary>
+        /// <remarks>
+        /// The coordinator is considered valid until it has been disposed by a
+        /// move operation.
+        /// </remarks>
+        /// <returns><c>true</c> if the object is valid, <c>false</c>
+        /// otherwise.</returns>
+        operator bool(void) const noexcept;
+
+    private:
+
+        detail::collector_coordinator_impl *_impl;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
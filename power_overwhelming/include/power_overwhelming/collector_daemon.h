@@ -0,0 +1,127 @@
+﻿// <copyright file="collector_daemon.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "power_overwhelming/collector.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations */
+    namespace detail { struct collector_daemon_impl; }
+
+    /// <summary>
+    /// Serves requests of <see cref="collector_client" />s in other processes
+    /// to start and stop named recordings of a local <see cref="collector" />.
+    /// </summary>
+    /// <remarks>
+    /// <para>The daemon allows for keeping a collector and therefore its
+    /// sensors open over many runs of a benchmark. Each run attaches to the
+    /// daemon through a named shared memory segment, which is much faster
+    /// than initialising the vendor libraries, opening the instruments and
+    /// enumerating the bricklets anew.</para>
+    /// <para>Each recording is written next to the output configured for the
+    /// collector, with its file name replaced by the name of the recording.
+    /// The marker channel and the segment with the latest samples of the
+    /// collector, if configured, are advertised to the clients, which can
+    /// use them while the recording is running.</para>
+    /// <para>The daemon polls for requests on a dedicated thread. If the
+    /// daemon is stopped while a recording is running, the collector is
+    /// stopped.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API collector_daemon final {
+
+    public:
+
+        /// <summary>
+        /// The name of the control segment the daemon creates by default.
+        /// </summary>
+        static constexpr const wchar_t *default_channel
+            = L"PwrOwgCollectorDaemon";
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <exception cref="std::bad_alloc">If the state of the daemon could
+        /// not be allocated.</exception>
+        collector_daemon(void);
+
+        collector_daemon(const collector_daemon&) = delete;
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline collector_daemon(_Inout_ collector_daemon&& rhs) noexcept
+                : _impl(rhs._impl) {
+            rhs._impl = nullptr;
+        }
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        /// <remarks>
+        /// The destructor stops the daemon, which stops the collector if a
+        /// recording is running.
+        /// </remarks>
+        ~collector_daemon(void);
+
+        /// <summary>
+        /// Creates the control segment and starts serving requests.
+        /// </summary>
+        /// <param name="collector">The collector to be controlled by the
+        /// clients, which must outlive the daemon or at least until
+        /// <see cref="stop" /> has been called. The collector must not be
+        /// running.</param>
+        /// <param name="channel">The name of the control segment, which must
+        /// only contain ASCII characters.</param>
+        /// <exception cref="std::runtime_error">If the object has been moved.
+        /// </exception>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="collector" /> has been disposed, if
+        /// <paramref name="channel" /> is <c>nullptr</c> or empty, or if the
+        /// names of the segments of the collector are too long to be
+        /// advertised.</exception>
+        /// <exception cref="std::logic_error">If the daemon is already
+        /// running.</exception>
+        /// <exception cref="std::system_error">If the control segment could
+        /// not be created.</exception>
+        void start(_In_ collector& collector,
+            _In_z_ const wchar_t *channel = default_channel);
+
+        /// <summary>
+        /// Stops serving requests and stops the collector if a recording is
+        /// running.
+        /// </summary>
+        void stop(void) noexcept;
+
+        collector_daemon& operator =(const collector_daemon&) = delete;
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_daemon& operator =(_Inout_ collector_daemon&& rhs) noexcept;
+
+        /// <summary>
+        /// Determines whether the object is valid.
+        /// </summary>
+        /// <remarks>
+        /// The object is valid unless it has been disposed by a move.
+        /// </remarks>
+        /// <returns><c>true</c> if the object is valid, <c>false</c>
+        /// otherwise.</returns>
+        operator bool(void) const noexcept;
+
+    private:
+
+        detail::collector_daemon_impl *_impl;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,162 @@
+﻿// <copyright file="collector_discovery.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations */
+    class collector;
+    namespace detail { struct collector_discovery_impl; }
+
+    /// <summary>
+    /// A handle for the discovery of the sensors of a <see cref="collector" />
+    /// that runs in the background.
+    /// </summary>
+    /// <remarks>
+    /// <para>Instances are created by <see cref="collector::discover_async" />.
+    /// Copies of a handle refer to the same discovery. Destroying the handles
+    /// neither blocks nor stops the discovery.</para>
+    /// <para>Cancelling a discovery stops waiting for the types of sensors
+    /// that have not yet been discovered. Their discovery runs to completion
+    /// in the background, but the result is discarded.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API collector_discovery final {
+
+    public:
+
+        /// <summary>
+        /// The type of callback that is invoked once the discovery has
+        /// completed, failed or has been cancelled.
+        /// </summary>
+        /// <remarks>
+        /// The callback is invoked on the thread of the library that ran the
+        /// discovery, which remains blocked until the callback returns. The
+        /// handle passed to the callback is only valid while it runs, but it
+        /// can be copied. Exceptions thrown by the callback are ignored.
+        /// </remarks>
+        typedef void (*callback_type)(_In_ collector_discovery& discovery,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// Initialises a new instance that does not refer to any discovery.
+        /// </summary>
+        inline collector_discovery(void) noexcept : _impl(nullptr) { }
+
+        /// <summary>
+        /// Clone <paramref name="rhs" />.
+        /// </summary>
+        /// <param name="rhs">The object to be cloned.</param>
+        collector_discovery(_In_ const collector_discovery& rhs);
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline collector_discovery(_In_ collector_discovery&& rhs) noexcept
+                : _impl(rhs._impl) {
+            rhs._impl = nullptr;
+        }
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~collector_discovery(void);
+
+        /// <summary>
+        /// Requests the discovery to stop.
+        /// </summary>
+        /// <returns><c>true</c> if the discovery had not yet completed,
+        /// <c>false</c> if it was already complete or if the handle does not
+        /// refer to a discovery.</returns>
+        bool cancel(void) noexcept;
+
+        /// <summary>
+        /// Answer whether the discovery has been cancelled.
+        /// </summary>
+        /// <returns><c>true</c> if <see cref="cancel" /> has been called,
+        /// <c>false</c> otherwise.</returns>
+        bool cancelled(void) const noexcept;
+
+        /// <summary>
+        /// Waits for the discovery to complete and retrieves the collector.
+        /// </summary>
+        /// <remarks>
+        /// The collector can only be retrieved once for all copies of the
+        /// handle.
+        /// </remarks>
+        /// <returns>The collector for the sensors that have been discovered.
+        /// </returns>
+        /// <exception cref="std::runtime_error">If the handle does not refer to
+        /// a discovery or if the discovery has been cancelled.</exception>
+        /// <exception cref="std::logic_error">If the collector has already
+        /// been retrieved.</exception>
+        /// <exception cref="std::exception">Any exception that the discovery
+        /// itself raised.</exception>
+        collector get(void);
+
+        /// <summary>
+        /// Answer whether the discovery has completed.
+        /// </summary>
+        /// <returns><c>true</c> if the result can be retrieved without
+        /// blocking, <c>false</c> otherwise.</returns>
+        bool ready(void) const noexcept;
+
+        /// <summary>
+        /// Waits for at most <paramref name="timeout" /> milliseconds for the
+        /// discovery to complete.
+        /// </summary>
+        /// <param name="timeout">The timeout in milliseconds.</param>
+        /// <returns><c>true</c> if the discovery has completed, <c>false</c>
+        /// if the timeout expired or the handle does not refer to a
+        /// discovery.</returns>
+        bool wait(_In_ const std::uint32_t timeout) const;
+
+        /// <summary>
+        /// Assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_discovery& operator =(_In_ const collector_discovery& rhs);
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_discovery& operator =(
+            _In_ collector_discovery&& rhs) noexcept;
+
+        /// <summary>
+        /// Determines whether the handle refers to a discovery.
+        /// </summary>
+        /// <returns><c>true</c> if the handle is valid, <c>false</c>
+        /// otherwise.</returns>
+        operator bool(void) const noexcept;
+
+    private:
+
+        /// <summary>
+        /// Initialise a new instance.
+        /// </summary>
+        /// <param name="impl">The implementation, which the object takes
+        /// ownership of.</param>
+        inline explicit collector_discovery(
+            _In_opt_ detail::collector_discovery_impl *impl) noexcept
+            : _impl(impl) { }
+
+        detail::collector_discovery_impl *_impl;
+
+        friend struct detail::collector_discovery_impl;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -7,7 +7,10 @@
 
 #include <cinttypes>
 
+#include "power_overwhelming/output_format.h"
+#include "power_overwhelming/sample_filter.h"
 #include "power_overwhelming/sensor.h"
+#include "power_overwhelming/tinkerforge_sensor_source.h"
 
 
 namespace visus {
@@ -26,6 +29,12 @@ namespace power_overwhelming {
         /// </summary>
         typedef sensor::microseconds_type sampling_interval_type;
 
+        /// <summary>
+        /// The default number of samples that can be buffered per sampling
+        /// thread before samples are dropped.
+        /// </summary>
+        static constexpr std::size_t default_buffer_size = 16384;
+
         /// <summary>
         /// The default output path.
         /// </summary>
@@ -38,6 +47,25 @@ namespace power_overwhelming {
         static constexpr sampling_interval_type default_sampling_interval
             = 5000;
 
+        /// <summary>
+        /// The default number of samples that the ring feeding the in-process
+        /// subscribers of the collector can hold.
+        /// </summary>
+        static constexpr std::size_t default_subscriber_capacity = 16384;
+
+        /// <summary>
+        /// The default maximum latency of 100 milliseconds (or 100000
+        /// microseconds) until buffered samples are written.
+        /// </summary>
+        static constexpr sampling_interval_type default_write_latency
+            = 100000;
+
+        /// <summary>
+        /// The default fill level of half the buffer at which the I/O thread
+        /// is woken.
+        /// </summary>
+        static constexpr float default_write_threshold = 0.5f;
+
         /// <summary>
         /// Initialises a new instance.
         /// </summary>
@@ -55,6 +83,746 @@ namespace power_overwhelming {
         /// </summary>
         ~collector_settings(void);
 
+        /// <summary>
+        /// Gets whether the collector only writes the aggregates of the
+        /// samples.
+        /// </summary>
+        /// <returns><c>true</c> if the raw samples are discarded once they
+        /// have been aggregated, <c>false</c> if they are written as well.
+        /// </returns>
+        inline bool aggregate_only(void) const noexcept {
+            return this->_aggregate_only;
+        }
+
+        /// <summary>
+        /// Sets whether the collector only writes the aggregates of the
+        /// samples.
+        /// </summary>
+        /// <remarks>
+        /// <para>This setting only has an effect if an
+        /// <see cref="aggregation_window" /> has been set. Samples are still
+        /// published to the shared memory and used for estimating the
+        /// overhead if they are not written.</para>
+        /// <para>This setting is disabled by default.</para>
+        /// </remarks>
+        /// <param name="aggregate_only">Whether to discard the raw samples.
+        /// </param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& aggregate_only(_In_ const bool aggregate_only);
+
+        /// <summary>
+        /// Gets the length of the windows the samples of each sensor are
+        /// aggregated in.
+        /// </summary>
+        /// <returns>The length of the windows in microseconds, which is zero
+        /// if the samples are not aggregated.</returns>
+        inline sampling_interval_type aggregation_window(
+                void) const noexcept {
+            return this->_aggregation_window;
+        }
+
+        /// <summary>
+        /// Sets the length of the windows the samples of each sensor are
+        /// aggregated in.
+        /// </summary>
+        /// <remarks>
+        /// <para>If set, the I/O thread reduces the samples of each sensor to
+        /// the minimum, mean and maximum power and the energy in windows of
+        /// the given length, which are aligned to multiples of the length.
+        /// The energy is the trapezoidal integral obtained from the actual
+        /// timestamps, such that the energy of all windows adds up to the
+        /// energy of the raw samples. This allows for sampling at a high rate
+        /// to obtain the energy correctly while only writing a fraction of
+        /// the data if <see cref="aggregate_only" /> is enabled. The
+        /// aggregates are written as <c># aggregate</c> comments to CSV
+        /// files and as separate records to binary files.</para>
+        /// <para>The window must be a multiple of the resolution of the
+        /// timestamps. Aggregation is disabled by default.</para>
+        /// </remarks>
+        /// <param name="window">The length of the windows in microseconds,
+        /// or zero to disable aggregation.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& aggregation_window(
+            _In_ const sampling_interval_type window);
+
+        /// <summary>
+        /// Gets whether the collector aligns the timestamps of sensors that
+        /// stamp their samples after an averaging period.
+        /// </summary>
+        /// <returns><c>true</c> if the timestamps are aligned, <c>false</c>
+        /// otherwise.</returns>
+        inline bool align_timestamps(void) const noexcept {
+            return this->_align_timestamps;
+        }
+
+        /// <summary>
+        /// Sets whether the collector aligns the timestamps of sensors that
+        /// stamp their samples after an averaging period.
+        /// </summary>
+        /// <remarks>
+        /// <para>All sensors use the same clock, but RAPL and EMI sensors
+        /// stamp the middle of the interval they report the average for,
+        /// whereas ADL, HMC8015, NVML and Tinkerforge sensors stamp the
+        /// instant the data arrived. If enabled, the I/O thread estimates the
+        /// latency of the latter as half of their actual interval and moves
+        /// their timestamps back accordingly, such that the samples of all
+        /// sensors refer to the same instants. This happens before the
+        /// markers are assigned to the samples.</para>
+        /// <para>This setting is disabled by default.</para>
+        /// </remarks>
+        /// <param name="align">Whether to align the timestamps.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& align_timestamps(_In_ const bool align);
+
+        /// <summary>
+        /// Gets the number of samples that the collector can buffer for each
+        /// thread delivering samples before it starts dropping them.
+        /// </summary>
+        /// <remarks>
+        /// The memory for the buffers is allocated once when the first sample
+        /// is delivered by a thread. If the I/O thread cannot keep up with
+        /// writing the samples, new samples are dropped rather than growing
+        /// the buffer.
+        /// </remarks>
+        /// <returns>The number of samples buffered per thread.</returns>
+        inline std::size_t buffer_size(void) const noexcept {
+            return this->_buffer_size;
+        }
+
+        /// <summary>
+        /// Sets the number of samples that the collector can buffer for each
+        /// thread delivering samples before it starts dropping them.
+        /// </summary>
+        /// <param name="size">The number of samples to be buffered per thread.
+        /// This number will be rounded up to the next power of two.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="size" /> is zero.</exception>
+        collector_settings& buffer_size(_In_ const std::size_t size);
+
+        /// <summary>
+        /// Gets the path to the capability report from which the collector
+        /// takes the shortest intervals the sensors are sampled at.
+        /// </summary>
+        /// <returns>The path to the report, or <c>nullptr</c> if none is
+        /// used.</returns>
+        inline _Ret_maybenull_z_ const wchar_t *capability_report(
+                void) const noexcept {
+            return this->_capability_report;
+        }
+
+        /// <summary>
+        /// Sets the path to the capability report from which the collector
+        /// takes the shortest intervals the sensors are sampled at.
+        /// </summary>
+        /// <remarks>
+        /// <para>The report is created by <see cref="probe_sensors" /> or the
+        /// <c>probe_sensors</c> tool on the machine the collector runs on.
+        /// If set, the collector raises the sampling interval of each sensor
+        /// in the report to the safe interval for this sensor, because
+        /// sampling faster only yields duplicate readings or occupies the
+        /// sampler threads for too long. The report is read when the
+        /// settings are applied to a collector.</para>
+        /// <para>This setting is disabled by default.</para>
+        /// </remarks>
+        /// <param name="path">The path to the report, or <c>nullptr</c> to
+        /// use the configured intervals as they are.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& capability_report(_In_opt_z_ const wchar_t *path);
+
+        /// <summary>
+        /// Gets whether the collector compresses the samples in binary
+        /// output files.
+        /// </summary>
+        /// <returns><c>true</c> if the samples are compressed, <c>false</c>
+        /// otherwise.</returns>
+        inline bool compress_output(void) const noexcept {
+            return this->_compress_output;
+        }
+
+        /// <summary>
+        /// Sets whether the collector compresses the samples in binary
+        /// output files.
+        /// </summary>
+        /// <remarks>
+        /// <para>If enabled, the timestamps are stored as the deltas of their
+        /// deltas and all other columns are XOR'ed with their predecessors,
+        /// which reduces samples at a regular interval and with slowly
+        /// varying values to a few bits. The compression runs on the I/O
+        /// thread of the collector, not on the threads sampling the sensors.
+        /// </para>
+        /// <para>This setting has no effect on CSV output. It is disabled by
+        /// default.</para>
+        /// </remarks>
+        /// <param name="compress">Whether to compress the samples.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& compress_output(_In_ const bool compress);
+
+        /// <summary>
+        /// Gets whether the collector compresses the samples in the
+        /// <see cref="waveform_archive" />.
+        /// </summary>
+        /// <returns><c>true</c> if the waveforms are compressed, <c>false</c>
+        /// otherwise.</returns>
+        inline bool compress_waveforms(void) const noexcept {
+            return this->_compress_waveforms;
+        }
+
+        /// <summary>
+        /// Sets whether the collector compresses the samples in the
+        /// <see cref="waveform_archive" />.
+        /// </summary>
+        /// <remarks>
+        /// The samples of each waveform are XOR'ed with their predecessors,
+        /// which is lossless. The compression runs on the thread writing the
+        /// archive. This setting is disabled by default.
+        /// </remarks>
+        /// <param name="compress">Whether to compress the waveforms.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& compress_waveforms(_In_ const bool compress);
+
+        /// <summary>
+        /// Gets the change that a sample of the given sensor or type of
+        /// sensor must exceed to be written.
+        /// </summary>
+        /// <param name="sensor">The name of a sensor or the name of a sensor
+        /// type like <c>msr_sensor</c>.</param>
+        /// <returns>The threshold configured for exactly this name, or a
+        /// negative number if all samples of the sensor are written.
+        /// </returns>
+        float delta_threshold(_In_opt_z_ const wchar_t *sensor) const noexcept;
+
+        /// <summary>
+        /// Enables the change-only emission for the given sensor or type of
+        /// sensor.
+        /// </summary>
+        /// <remarks>
+        /// <para>Many sensors, for instance idle GPUs or the RAPL domain of
+        /// the DRAM, change rarely compared to the rate they are sampled at.
+        /// If a threshold is set for such a sensor, a sample is only written
+        /// if its voltage, current or power differs by more than the
+        /// threshold from the last sample written, if its marker differs, or
+        /// if the <see cref="keep_alive_interval" /> has passed. Whenever a
+        /// sample is written due to a change, the last sample discarded
+        /// before it is written first. The output therefore retains the
+        /// exact time of each step, and a threshold of zero allows for
+        /// reconstructing the signal exactly by holding each value until the
+        /// next sample.</para>
+        /// <para>The samples are filtered after the energy has been
+        /// integrated, such that <see cref="integrate_energy" /> is not
+        /// affected. A threshold for the name of a sensor takes precedence
+        /// over a threshold for the type of the sensor.</para>
+        /// </remarks>
+        /// <param name="sensor">The name of a sensor or the name of a sensor
+        /// type.</param>
+        /// <param name="threshold">The change in Volts, Amperes or Watts a
+        /// sample must exceed, or a negative number to write all samples of
+        /// the sensor again.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="sensor" /> is <c>nullptr</c>.</exception>
+        collector_settings& delta_threshold(_In_z_ const wchar_t *sensor,
+            _In_ const float threshold);
+
+        /// <summary>
+        /// Answer the names for which change-only emission has been enabled
+        /// via <see cref="delta_threshold" />.
+        /// </summary>
+        /// <param name="dst">Receives up to <paramref name="cnt" /> names,
+        /// which remain valid until the settings are modified. It is safe to
+        /// pass <c>nullptr</c>.</param>
+        /// <param name="cnt">The number of elements that <paramref name="dst" />
+        /// can hold.</param>
+        /// <returns>The total number of names with thresholds, which might be
+        /// larger than <paramref name="cnt" />.</returns>
+        std::size_t delta_thresholds(
+            _Out_writes_opt_(cnt) const wchar_t **dst,
+            _In_ const std::size_t cnt) const noexcept;
+
+        /// <summary>
+        /// Answer the expression of the derived sensor with the given name.
+        /// </summary>
+        /// <param name="sensor">The name of the derived sensor.</param>
+        /// <returns>The expression of the derived sensor, or <c>nullptr</c>
+        /// if there is no derived sensor with this name. The string remains
+        /// valid until the settings are modified.</returns>
+        _Ret_maybenull_z_ const wchar_t *derived_sensor(
+            _In_opt_z_ const wchar_t *sensor) const noexcept;
+
+        /// <summary>
+        /// Adds a virtual sensor that computes its power from the samples of
+        /// other sensors.
+        /// </summary>
+        /// <remarks>
+        /// <para>The expression consists of numbers, the names of sensors in
+        /// square brackets, the operators <c>+</c>, <c>-</c>, <c>*</c> and
+        /// <c>/</c>, and parentheses. A sensor in brackets denotes its power,
+        /// and <c>.voltage</c> or <c>.current</c> can be appended to the
+        /// brackets to use the voltage or current instead. For instance,
+        /// <c>[tinker/12V].power + [tinker/PCIe].power</c> computes the power
+        /// of a GPU from two of its rails.</para>
+        /// <para>The expression is compiled once, and the collector evaluates
+        /// it live for batches of samples, which are aligned on the grid of
+        /// the <see cref="resampling_interval" /> or, if resampling is
+        /// disabled, of the <see cref="sampling_interval" /> by linear
+        /// interpolation. The samples of the derived sensor therefore lag
+        /// behind the slowest sensor it uses. A derived sensor can use the
+        /// derived sensors added before it.</para>
+        /// </remarks>
+        /// <param name="sensor">The name of the derived sensor.</param>
+        /// <param name="expression">The expression computing the power of the
+        /// derived sensor, or <c>nullptr</c> to remove the derived sensor.
+        /// </param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="sensor" /> is <c>nullptr</c>, or if
+        /// <paramref name="expression" /> is not valid.</exception>
+        collector_settings& derived_sensor(_In_z_ const wchar_t *sensor,
+            _In_opt_z_ const wchar_t *expression);
+
+        /// <summary>
+        /// Answer the names of the derived sensors configured via
+        /// <see cref="derived_sensor" />.
+        /// </summary>
+        /// <param name="dst">Receives up to <paramref name="cnt" /> names in
+        /// the order the sensors have been added, which remain valid until
+        /// the settings are modified. It is safe to pass <c>nullptr</c>.
+        /// </param>
+        /// <param name="cnt">The number of elements that <paramref name="dst" />
+        /// can hold.</param>
+        /// <returns>The total number of derived sensors, which might be
+        /// larger than <paramref name="cnt" />.</returns>
+        std::size_t derived_sensors(
+            _Out_writes_opt_(cnt) const wchar_t **dst,
+            _In_ const std::size_t cnt) const noexcept;
+
+        /// <summary>
+        /// Answer whether the power of NVIDIA GPUs is estimated from their
+        /// utilisation and clocks in addition to being measured.
+        /// </summary>
+        /// <returns><c>true</c> if the power is estimated, <c>false</c>
+        /// otherwise.</returns>
+        inline bool estimate_power(void) const noexcept {
+            return this->_estimate_power;
+        }
+
+        /// <summary>
+        /// Configures whether the power of NVIDIA GPUs is estimated from
+        /// their utilisation and clocks in addition to being measured.
+        /// </summary>
+        /// <remarks>
+        /// <para>If enabled, the collector puts all <see cref="nvml_sensor" />s
+        /// that support it into estimation mode, which fits a model of the
+        /// power to the activity of the GPU and yields an estimate of the
+        /// power with each sample rather than each time the driver updates
+        /// its power reading. The estimates are written for a sensor named
+        /// like the GPU followed by <c>/estimated</c>, and the bounds of their
+        /// 95 % confidence interval are written for the sensors with the
+        /// additional suffixes <c>/lower</c> and <c>/upper</c>.</para>
+        /// <para>GPUs that do not report their utilisation or clocks are
+        /// only measured. This setting is disabled by default.</para>
+        /// </remarks>
+        /// <param name="estimate">Whether to estimate the power.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& estimate_power(_In_ const bool estimate);
+
+        /// <summary>
+        /// Answer the filter applied to the samples of the given sensor or
+        /// type of sensor.
+        /// </summary>
+        /// <param name="sensor">The name of a sensor or the name of a sensor
+        /// type like <c>tinkerforge_sensor</c>.</param>
+        /// <returns>The filter configured for exactly this name, which is of
+        /// type <see cref="sample_filter_type::none" /> if the samples are not
+        /// filtered.</returns>
+        sample_filter filter(_In_opt_z_ const wchar_t *sensor) const noexcept;
+
+        /// <summary>
+        /// Configures a filter for the samples of the given sensor or type of
+        /// sensor.
+        /// </summary>
+        /// <remarks>
+        /// <para>The collector filters the samples before anything else is
+        /// done with them, i.e. aggregates, energies and derived sensors are
+        /// computed from the filtered samples. If
+        /// <see cref="retain_unfiltered" /> is set, the unfiltered samples are
+        /// written as well. Filters that need a window of samples delay the
+        /// samples of the sensor by half a window, but retain the timestamp
+        /// of the sample in the centre of the window. A filter for the name
+        /// of a sensor takes precedence over a filter for the type of the
+        /// sensor.</para>
+        /// </remarks>
+        /// <param name="sensor">The name of a sensor or the name of a sensor
+        /// type.</param>
+        /// <param name="filter">The filter to apply, or a filter of type
+        /// <see cref="sample_filter_type::none" /> to remove the filter.
+        /// </param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="sensor" /> is <c>nullptr</c>.</exception>
+        collector_settings& filter(_In_z_ const wchar_t *sensor,
+            _In_ const sample_filter& filter);
+
+        /// <summary>
+        /// Answer the names for which filters have been configured via
+        /// <see cref="filter" />.
+        /// </summary>
+        /// <param name="dst">Receives up to <paramref name="cnt" /> names,
+        /// which remain valid until the settings are modified. It is safe to
+        /// pass <c>nullptr</c>.</param>
+        /// <param name="cnt">The number of elements that <paramref name="dst" />
+        /// can hold.</param>
+        /// <returns>The total number of names with filters, which might be
+        /// larger than <paramref name="cnt" />.</returns>
+        std::size_t filters(_Out_writes_opt_(cnt) const wchar_t **dst,
+            _In_ const std::size_t cnt) const noexcept;
+
+        /// <summary>
+        /// Gets whether the collector integrates the energy of each sensor
+        /// per phase between two markers.
+        /// </summary>
+        /// <returns><c>true</c> if the energy is integrated, <c>false</c>
+        /// otherwise.</returns>
+        inline bool integrate_energy(void) const noexcept {
+            return this->_integrate_energy;
+        }
+
+        /// <summary>
+        /// Sets whether the collector integrates the energy of each sensor
+        /// per phase between two markers.
+        /// </summary>
+        /// <remarks>
+        /// <para>If enabled, the I/O thread of the collector integrates the
+        /// power of each sensor using the actual timestamps of the samples
+        /// and starts a new phase whenever a marker is set. The energy of the
+        /// interval between two samples is split at the time the marker has
+        /// been set. Sensors reading a hardware energy counter, i.e. RAPL,
+        /// EMI and NVML sensors in energy mode, are integrated such that the
+        /// result reproduces the deltas of the counters. When the collector is
+        /// stopped, it writes a summary of the energy per sensor and phase at
+        /// the end of the output.</para>
+        /// <para>Samples dropped due to <see cref="require_marker" /> are not
+        /// integrated. This setting is disabled by default.</para>
+        /// </remarks>
+        /// <param name="integrate">Whether to integrate the energy.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& integrate_energy(_In_ const bool integrate);
+
+        /// <summary>
+        /// Gets whether the collector reads the energy per phase from the
+        /// hardware integrators of the instruments.
+        /// </summary>
+        /// <returns><c>true</c> if the integrators of the instruments are
+        /// used, <c>false</c> if all instruments are queried live.</returns>
+        inline bool integrate_instruments(void) const noexcept {
+            return this->_integrate_instruments;
+        }
+
+        /// <summary>
+        /// Sets whether the collector reads the energy per phase from the
+        /// hardware integrators of the instruments instead of querying the
+        /// instruments live.
+        /// </summary>
+        /// <remarks>
+        /// <para>If enabled, HMC8015 power analysers are not sampled while the
+        /// collector is running. Instead, the collector resets and starts the
+        /// integrator of each instrument whenever a marker is set and stops
+        /// and reads it when the marker is changed or cleared. This requires
+        /// only a few round trips per phase on the thread setting the marker,
+        /// and the energy is more accurate than anything integrated from
+        /// polled samples. The energy per instrument and marked phase is
+        /// written to the summary at the end of the output, independently
+        /// from <see cref="integrate_energy" />.</para>
+        /// <para>Markers set after the fact at a given timestamp cannot be
+        /// observed by the instruments and are ignored by the integrators.
+        /// This setting takes precedence over
+        /// <see cref="merge_instrument_logs" /> and is disabled by default.
+        /// </para>
+        /// </remarks>
+        /// <param name="integrate">Whether to use the integrators of the
+        /// instruments.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& integrate_instruments(_In_ const bool integrate);
+
+        /// <summary>
+        /// Gets the path to the file the collector writes the energy per
+        /// CUDA kernel to.
+        /// </summary>
+        /// <returns>The path to the file, or <c>nullptr</c> if the energy is
+        /// not attributed to kernels.</returns>
+        inline _Ret_maybenull_z_ const wchar_t *kernel_energy(
+                void) const noexcept {
+            return this->_kernel_energy;
+        }
+
+        /// <summary>
+        /// Sets the path to the file the collector writes the energy per
+        /// CUDA kernel to.
+        /// </summary>
+        /// <remarks>
+        /// <para>If set, the collector traces the CUDA kernels executed by
+        /// the process using CUPTI while it is running and attributes the
+        /// energy of each sensor to the kernels that were executing at the
+        /// same time. If multiple kernels overlap, they share the energy of
+        /// the overlap evenly, and the energy consumed while no kernel was
+        /// running is reported as idle energy. When the collector is
+        /// stopped, it writes a CSV table with the number of invocations,
+        /// the total duration in seconds and the energy in Joules per sensor
+        /// and kernel to the given file.</para>
+        /// <para>The kernels are not synchronised, so the attribution
+        /// accuracy is limited by the sampling interval of the sensors. This
+        /// setting requires the library to be built with CUPTI support and
+        /// is disabled by default.</para>
+        /// </remarks>
+        /// <param name="path">The path to the output file, or <c>nullptr</c>
+        /// to disable the attribution.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& kernel_energy(_In_opt_z_ const wchar_t *path);
+
+        /// <summary>
+        /// Gets the interval after which a sample of a sensor with a
+        /// <see cref="delta_threshold" /> is written even if it has not
+        /// changed.
+        /// </summary>
+        /// <returns>The keep-alive interval in microseconds, which is zero if
+        /// unchanged samples are never written.</returns>
+        inline sampling_interval_type keep_alive_interval(
+                void) const noexcept {
+            return this->_keep_alive_interval;
+        }
+
+        /// <summary>
+        /// Sets the interval after which a sample of a sensor with a
+        /// <see cref="delta_threshold" /> is written even if it has not
+        /// changed.
+        /// </summary>
+        /// <remarks>
+        /// <para>The keep-alive samples bound the time until an unchanged
+        /// sensor shows up in the output, for instance if the collector is
+        /// stopped abnormally.</para>
+        /// <para>This setting is zero by default, i.e. unchanged samples are
+        /// never written.</para>
+        /// </remarks>
+        /// <param name="interval">The keep-alive interval in microseconds, or
+        /// zero to disable the keep-alive samples.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& keep_alive_interval(
+            _In_ const sampling_interval_type interval);
+
+        /// <summary>
+        /// Gets whether the collector never samples a sensor faster than its
+        /// native update interval.
+        /// </summary>
+        /// <returns><c>true</c> if the sampling intervals are limited,
+        /// <c>false</c> otherwise.</returns>
+        inline bool limit_to_native_interval(void) const noexcept {
+            return this->_limit_to_native_interval;
+        }
+
+        /// <summary>
+        /// Sets whether the collector never samples a sensor faster than its
+        /// native update interval.
+        /// </summary>
+        /// <remarks>
+        /// <para>If enabled, the collector raises the interval of each sensor
+        /// whose <see cref="sensor::native_interval" /> is longer than the
+        /// interval it would be sampled at to the native interval, because
+        /// sampling faster only yields duplicate readings, which waste CPU
+        /// time and disk space. Sensors that do not know their update
+        /// interval determine it empirically when the collector is started,
+        /// which may take up to a second per sensor.</para>
+        /// <para>This setting is disabled by default.</para>
+        /// </remarks>
+        /// <param name="limit">Whether to limit the sampling intervals.
+        /// </param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& limit_to_native_interval(_In_ const bool limit);
+
+        /// <summary>
+        /// Gets whether the collector locks its sample buffers into physical
+        /// memory while it is running.
+        /// </summary>
+        /// <returns><c>true</c> if the buffers are locked, <c>false</c>
+        /// otherwise.</returns>
+        inline bool lock_memory(void) const noexcept {
+            return this->_lock_memory;
+        }
+
+        /// <summary>
+        /// Sets whether the collector locks its sample buffers into physical
+        /// memory while it is running.
+        /// </summary>
+        /// <remarks>
+        /// <para>If enabled, the collector allocates the buffers for all
+        /// threads delivering samples when it is started instead of on the
+        /// first sample of each thread. The buffers are prefaulted and locked
+        /// using <c>mlock</c> or <c>VirtualLock</c>, such that neither a page
+        /// fault nor an allocation delays a sampler thread once the
+        /// collector is running. The buffers are unlocked when the collector
+        /// is stopped.</para>
+        /// <para>Locking memory may require privileges or a larger limit of
+        /// locked memory (<c>ulimit -l</c>) on Linux. If the memory cannot be
+        /// locked, starting the collector fails.</para>
+        /// <para>This setting is disabled by default.</para>
+        /// </remarks>
+        /// <param name="lock">Whether to lock the buffers.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& lock_memory(_In_ const bool lock);
+
+        /// <summary>
+        /// Gets whether the application drives the collector by calling
+        /// <see cref="collector::pump" /> instead of the library creating
+        /// threads for sampling and writing.
+        /// </summary>
+        /// <returns><c>true</c> if the collector is pumped manually,
+        /// <c>false</c> otherwise.</returns>
+        inline bool manual_pump(void) const noexcept {
+            return this->_manual_pump;
+        }
+
+        /// <summary>
+        /// Sets whether the application drives the collector by calling
+        /// <see cref="collector::pump" /> instead of the library creating
+        /// threads for sampling and writing.
+        /// </summary>
+        /// <remarks>
+        /// <para>If enabled, the collector neither starts its I/O thread nor
+        /// lets the scheduler of the generic samplers start its workers.
+        /// Instead, the application calls <see cref="collector::pump" />
+        /// regularly from its own loop, which samples all sensors that are
+        /// due and writes the buffered samples on the calling thread. This
+        /// is intended for applications like game engines or embedded
+        /// controllers that must own all of their threads.</para>
+        /// <para>Sensors that are sampled by a driver callback or by a
+        /// dedicated thread, for instance the instruments and Tinkerforge
+        /// bricklets, still use these. The output cannot be sharded across
+        /// multiple <see cref="writer_threads" />, and an overhead experiment
+        /// cannot switch its windows after an
+        /// <see cref="overhead_window" />.</para>
+        /// <para>The samples are taken only as precisely as the application
+        /// calls <see cref="collector::pump" />.</para>
+        /// <para>This setting is disabled by default.</para>
+        /// </remarks>
+        /// <param name="manual">Whether the collector is pumped manually.
+        /// </param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& manual_pump(_In_ const bool manual);
+
+        /// <summary>
+        /// Gets the name of the shared memory segment through which other
+        /// processes can set markers.
+        /// </summary>
+        /// <returns>The name of the segment, or <c>nullptr</c> if the
+        /// collector does not accept markers from other processes.</returns>
+        inline _Ret_maybenull_z_ const wchar_t *marker_channel(
+                void) const noexcept {
+            return this->_marker_channel;
+        }
+
+        /// <summary>
+        /// Sets the name of the shared memory segment through which other
+        /// processes can set markers.
+        /// </summary>
+        /// <remarks>
+        /// <para>If set, the collector creates the named segment when it is
+        /// started, and workloads in other processes can set markers using
+        /// the header-only <see cref="power_overwhelming::marker_channel" />
+        /// without linking against the library. The markers are stamped by
+        /// the clients with the clock of the collector, but they are only
+        /// retrieved when the I/O thread drains the buffers, ie they take
+        /// effect with a latency of up to <see cref="write_latency" />.</para>
+        /// <para>The naming rules are the same as for
+        /// <see cref="shared_memory" />.</para>
+        /// <para>This setting is disabled by default.</para>
+        /// </remarks>
+        /// <param name="name">The name of the segment, or <c>nullptr</c> to
+        /// disable markers from other processes.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& marker_channel(_In_opt_z_ const wchar_t *name);
+
+        /// <summary>
+        /// Gets whether the collector merges the logs recorded on
+        /// instruments into its output.
+        /// </summary>
+        /// <returns><c>true</c> if instrument logs are merged, <c>false</c>
+        /// if all instruments are queried live.</returns>
+        inline bool merge_instrument_logs(void) const noexcept {
+            return this->_merge_instrument_logs;
+        }
+
+        /// <summary>
+        /// Sets whether the collector merges the logs recorded on instruments
+        /// into its output instead of querying the instruments live.
+        /// </summary>
+        /// <remarks>
+        /// <para>If enabled, HMC8015 power analysers are not sampled via the
+        /// network while the collector is running. Instead, the collector
+        /// configures the instruments to log at the sampling interval, which
+        /// allows for much higher rates without any overhead. When the
+        /// collector is stopped, it downloads the log files and writes the
+        /// samples aligned to the start of the log after all other samples.
+        /// Markers are assigned to the samples from the logs based on their
+        /// timestamps.</para>
+        /// <para>This setting is disabled by default.</para>
+        /// </remarks>
+        /// <param name="merge">Whether to merge the instrument logs.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& merge_instrument_logs(_In_ const bool merge);
+
+        /// <summary>
+        /// Gets the shortest interval to which the collector may lower the
+        /// sampling interval of a sensor during a transient.
+        /// </summary>
+        /// <returns>The minimum sampling interval in microseconds, which is
+        /// zero if the sampling intervals are fixed.</returns>
+        inline sampling_interval_type min_sampling_interval(
+                void) const noexcept {
+            return this->_min_sampling_interval;
+        }
+
+        /// <summary>
+        /// Sets the shortest interval to which the collector may lower the
+        /// sampling interval of a sensor during a transient.
+        /// </summary>
+        /// <remarks>
+        /// <para>If this interval is positive and shorter than the interval a
+        /// sensor is sampled at, the collector samples the sensor at its
+        /// regular interval while its readings are stable, switches to the
+        /// minimum interval as soon as the readings change significantly and
+        /// returns to the regular interval step by step once they have
+        /// settled again. This way, transients are captured at a high
+        /// resolution without paying for it during idle phases. The interval
+        /// actually used can be derived from the timestamps of the
+        /// samples.</para>
+        /// <para>Only sensors that are sampled by the library itself, like
+        /// RAPL, can adapt their rate. All other sensors are sampled at their
+        /// regular interval.</para>
+        /// <para>This setting is zero by default, i.e. the sampling intervals
+        /// are fixed.</para>
+        /// </remarks>
+        /// <param name="interval">The minimum sampling interval in
+        /// microseconds, or zero to disable the adaptation.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& min_sampling_interval(
+            _In_ const sampling_interval_type interval);
+
+        /// <summary>
+        /// Gets the format of the file the collector writes.
+        /// </summary>
+        /// <returns>The format of the output file.</returns>
+        inline power_overwhelming::output_format output_format(
+                void) const noexcept {
+            return this->_output_format;
+        }
+
+        /// <summary>
+        /// Sets the format of the file the collector writes.
+        /// </summary>
+        /// <param name="format">The format of the output file.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& output_format(
+            _In_ const power_overwhelming::output_format format);
+
         /// <summary>
         /// Gets the path to the file where the collector should write its
         /// output to.
@@ -74,6 +842,378 @@ namespace power_overwhelming {
         /// <paramref name="output_path" /> is <c>nullptr</c>.</exception>
         collector_settings& output_path(_In_z_ const wchar_t *path);
 
+        /// <summary>
+        /// Gets the sampling interval in the reference windows of an overhead
+        /// experiment.
+        /// </summary>
+        /// <returns>The sampling interval in microseconds, which is zero if
+        /// the sensors are not sampled at all in the reference windows.
+        /// </returns>
+        inline sampling_interval_type overhead_interval(void) const noexcept {
+            return this->_overhead_interval;
+        }
+
+        /// <summary>
+        /// Sets the sampling interval in the reference windows of an overhead
+        /// experiment.
+        /// </summary>
+        /// <remarks>
+        /// <para>If this interval is zero, the sensors are stopped in the
+        /// reference windows, which compares sampling to not sampling.
+        /// Otherwise, all sensors at the global
+        /// <see cref="sampling_interval" /> are sampled at the given interval
+        /// in the reference windows, which compares a high to a low rate.
+        /// Sensors with a <see cref="sensor_interval" /> of their own keep
+        /// it.</para>
+        /// <para>This setting is zero by default.</para>
+        /// </remarks>
+        /// <param name="interval">The sampling interval in microseconds, or
+        /// zero for not sampling.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& overhead_interval(
+            _In_ const sampling_interval_type interval);
+
+        /// <summary>
+        /// Gets the path to the file the collector writes the results of an
+        /// overhead experiment to.
+        /// </summary>
+        /// <returns>The path to the report, or <c>nullptr</c> if no
+        /// experiment is performed.</returns>
+        inline _Ret_maybenull_z_ const wchar_t *overhead_report(
+                void) const noexcept {
+            return this->_overhead_report;
+        }
+
+        /// <summary>
+        /// Sets the path to the file the collector writes the results of an
+        /// overhead experiment to.
+        /// </summary>
+        /// <remarks>
+        /// <para>If set, the collector performs an A/B experiment quantifying
+        /// how much the measurement slows down the workload: it alternates
+        /// between sampling windows, in which the sensors are sampled as
+        /// configured, and reference windows, in which they are sampled at
+        /// the <see cref="overhead_interval" />. The workload reports its
+        /// progress, for instance frames or iterations, via
+        /// <see cref="collector::progress" />. When the collector is stopped,
+        /// it writes a CSV table with the progress rate and the CPU time of
+        /// the library per window, followed by the mean rates of both kinds
+        /// of windows and the resulting overhead with its 95% confidence
+        /// interval.</para>
+        /// <para>The windows switch after each <see cref="overhead_window" />
+        /// or, if it is zero, with each marker other than zero. An experiment
+        /// cannot be combined with <see cref="require_marker" />.</para>
+        /// <para>This setting is disabled by default.</para>
+        /// </remarks>
+        /// <param name="path">The path to the report, or <c>nullptr</c> to
+        /// disable the experiment.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& overhead_report(_In_opt_z_ const wchar_t *path);
+
+        /// <summary>
+        /// Gets the length of the windows of an overhead experiment.
+        /// </summary>
+        /// <returns>The length of a window in microseconds, which is zero if
+        /// the windows are switched by markers.</returns>
+        inline sampling_interval_type overhead_window(void) const noexcept {
+            return this->_overhead_window;
+        }
+
+        /// <summary>
+        /// Sets the length of the windows of an overhead experiment.
+        /// </summary>
+        /// <remarks>
+        /// <para>The windows are switched with a resolution of milliseconds,
+        /// and the windows should be long compared to the time for
+        /// restarting the sensors. If the length is zero, each marker other
+        /// than zero starts a new window, which allows for alternating
+        /// between repetitions of the same phase of the workload.</para>
+        /// <para>This setting is zero by default.</para>
+        /// </remarks>
+        /// <param name="window">The length of a window in microseconds, or
+        /// zero for switching by markers.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& overhead_window(
+            _In_ const sampling_interval_type window);
+
+        /// <summary>
+        /// Gets the time after a trigger for which samples are written in
+        /// capture mode.
+        /// </summary>
+        /// <returns>The length of the window after a trigger in
+        /// microseconds.</returns>
+        inline sampling_interval_type post_trigger(void) const noexcept {
+            return this->_post_trigger;
+        }
+
+        /// <summary>
+        /// Sets the time after a trigger for which samples are written in
+        /// capture mode.
+        /// </summary>
+        /// <remarks>
+        /// See <see cref="pre_trigger" /> for a description of the capture
+        /// mode.
+        /// </remarks>
+        /// <param name="window">The length of the window after a trigger in
+        /// microseconds.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& post_trigger(
+            _In_ const sampling_interval_type window);
+
+        /// <summary>
+        /// Gets the time before a trigger for which samples are written in
+        /// capture mode.
+        /// </summary>
+        /// <returns>The length of the window before a trigger in
+        /// microseconds.</returns>
+        inline sampling_interval_type pre_trigger(void) const noexcept {
+            return this->_pre_trigger;
+        }
+
+        /// <summary>
+        /// Sets the time before a trigger for which samples are written in
+        /// capture mode.
+        /// </summary>
+        /// <remarks>
+        /// <para>The capture mode is enabled if the window before or the
+        /// window after a trigger is non-zero. In this mode, the sensors
+        /// sample at their normal interval, but the I/O thread retains the
+        /// samples in a ring holding <see cref="buffer_size" /> samples per
+        /// sensor instead of writing them. Only the samples from
+        /// <see cref="pre_trigger" /> before until
+        /// <see cref="post_trigger" /> after a trigger are written, which
+        /// allows for sampling at a high rate over long periods with little
+        /// output. Triggers are raised via
+        /// <see cref="collector::trigger" /> or by a sample reaching the
+        /// <see cref="trigger_threshold" />.</para>
+        /// <para>The ring must hold at least the samples of all sensors in
+        /// the window before a trigger and until the I/O thread has drained
+        /// the buffers. The aggregates of <see cref="aggregation_window" />
+        /// only cover the samples written, whereas the energy of
+        /// <see cref="integrate_energy" /> covers all samples. The capture
+        /// mode is disabled by default.</para>
+        /// </remarks>
+        /// <param name="window">The length of the window before a trigger in
+        /// microseconds.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& pre_trigger(
+            _In_ const sampling_interval_type window);
+
+        /// <summary>
+        /// Gets the path to the file the collector writes the energy per
+        /// process of the NVIDIA GPUs to.
+        /// </summary>
+        /// <returns>The path to the file, or <c>nullptr</c> if the energy is
+        /// not attributed to processes.</returns>
+        inline _Ret_maybenull_z_ const wchar_t *process_energy(
+                void) const noexcept {
+            return this->_process_energy;
+        }
+
+        /// <summary>
+        /// Sets the path to the file the collector writes the energy per
+        /// process of the NVIDIA GPUs to.
+        /// </summary>
+        /// <remarks>
+        /// <para>If set, the collector enables the
+        /// <see cref="nvml_sensor::process_energy_mode" /> of all
+        /// <see cref="nvml_sensor" />s while it is running, which splits the
+        /// energy of each GPU between the processes using it according to
+        /// their utilisation. When the collector is stopped, it writes a CSV
+        /// table with the time each process has been using the GPU in
+        /// seconds and its energy in Joules per sensor and process ID to the
+        /// given file. Process ID zero denotes the energy consumed while no
+        /// process was using the GPU.</para>
+        /// <para>GPUs that cannot report their utilisation per process are
+        /// not included in the table. This setting is disabled by default.
+        /// </para>
+        /// </remarks>
+        /// <param name="path">The path to the output file, or <c>nullptr</c>
+        /// to disable the attribution.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& process_energy(_In_opt_z_ const wchar_t *path);
+
+        /// <summary>
+        /// Gets whether the collector records the estimated power the library
+        /// itself draws.
+        /// </summary>
+        /// <returns><c>true</c> if the overhead is recorded, <c>false</c>
+        /// otherwise.</returns>
+        inline bool record_overhead(void) const noexcept {
+            return this->_record_overhead;
+        }
+
+        /// <summary>
+        /// Sets whether the collector records the estimated power the library
+        /// itself draws.
+        /// </summary>
+        /// <remarks>
+        /// <para>If enabled, the I/O thread writes a sample of the virtual
+        /// sensor <c>PwrOwg/overhead</c> after each pass over the buffers.
+        /// The power of the sample is the average power of the CPU packages
+        /// measured by the RAPL and EMI sensors of the collector in the pass,
+        /// scaled by the share of the library threads in the busy time of all
+        /// CPUs as reported by <see cref="get_library_cpu_time" />. No
+        /// overhead is recorded if the collector does not sample any CPU
+        /// package.</para>
+        /// <para>This setting is disabled by default.</para>
+        /// </remarks>
+        /// <param name="record">Whether to record the overhead.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& record_overhead(_In_ const bool record);
+
+        /// <summary>
+        /// Gets whether the collector only records samples while a marker is
+        /// set.
+        /// </summary>
+        /// <returns><c>true</c> if samples are only recorded with a marker,
+        /// <c>false</c> if all samples are recorded.</returns>
+        inline bool require_marker(void) const noexcept {
+            return this->_require_marker;
+        }
+
+        /// <summary>
+        /// Sets whether the collector only records samples while a marker is
+        /// set.
+        /// </summary>
+        /// <remarks>
+        /// <para>If enabled, the sensors that are sampled live are stopped
+        /// whenever the marker is cleared and restarted when a new marker is
+        /// set, such that they do not disturb the machine between the phases
+        /// of a benchmark. Counter-based sensors establish a new baseline when
+        /// they are restarted, so the first sample of a phase does not
+        /// average over the pause. Restarting the sensors happens on the
+        /// thread setting the marker.</para>
+        /// <para>This setting is disabled by default.</para>
+        /// </remarks>
+        /// <param name="require">Whether to require a marker.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& require_marker(_In_ const bool require);
+
+        /// <summary>
+        /// Answer whether the unfiltered samples of filtered sensors are
+        /// written in addition to the filtered ones.
+        /// </summary>
+        /// <returns><c>true</c> if the unfiltered samples are retained,
+        /// <c>false</c> otherwise.</returns>
+        inline bool retain_unfiltered(void) const noexcept {
+            return this->_retain_unfiltered;
+        }
+
+        /// <summary>
+        /// Configures whether the unfiltered samples of sensors with a
+        /// <see cref="filter" /> are written in addition to the filtered
+        /// ones.
+        /// </summary>
+        /// <remarks>
+        /// If enabled, the samples of filtered sensors are processed as if
+        /// they were not filtered, and the filtered samples are written for
+        /// a sensor named like the original one followed by
+        /// <c>/filtered</c>. This setting is disabled by default.
+        /// </remarks>
+        /// <param name="retain">Whether to retain the unfiltered samples.
+        /// </param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& retain_unfiltered(_In_ const bool retain);
+
+        /// <summary>
+        /// Gets the distance between the points of the grid all samples are
+        /// resampled onto.
+        /// </summary>
+        /// <returns>The distance in microseconds, which is zero if the samples
+        /// are not resampled.</returns>
+        inline sampling_interval_type resampling_interval(
+                void) const noexcept {
+            return this->_resampling_interval;
+        }
+
+        /// <summary>
+        /// Sets the distance between the points of the grid all samples are
+        /// resampled onto.
+        /// </summary>
+        /// <remarks>
+        /// <para>If set, the collector writes samples at the multiples of the
+        /// interval instead of the raw samples. The values are interpolated
+        /// linearly between consecutive samples of each sensor, such that the
+        /// samples of all sensors share the same timestamps, which allows for
+        /// computing quantities across sensors without aligning them offline.
+        /// This is typically combined with <see cref="align_timestamps" />.
+        /// </para>
+        /// <para>Resampling only affects the samples written. The aggregates
+        /// of <see cref="aggregation_window" /> and the energy of
+        /// <see cref="integrate_energy" /> are computed from the raw samples.
+        /// The interval must be a multiple of the resolution of the
+        /// timestamps. Resampling is disabled by default.</para>
+        /// </remarks>
+        /// <param name="interval">The distance between two grid points in
+        /// microseconds, or zero to disable resampling.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& resampling_interval(
+            _In_ const sampling_interval_type interval);
+
+        /// <summary>
+        /// Gets the time after which the output is continued in a new
+        /// segment.
+        /// </summary>
+        /// <returns>The age of a segment in microseconds, which is zero if
+        /// the output is not rotated by time.</returns>
+        inline sampling_interval_type rotate_interval(void) const noexcept {
+            return this->_rotate_interval;
+        }
+
+        /// <summary>
+        /// Sets the time after which the output is continued in a new
+        /// segment.
+        /// </summary>
+        /// <remarks>
+        /// <para>If set, the collector opens a new output file whenever the
+        /// current one has been written for the given time, without stopping
+        /// the sensors. The first segment is written to the
+        /// <see cref="output_path" />, the following ones to the same path
+        /// with a four-digit index inserted before the extension, for
+        /// instance <c>output.0001.csv</c>. Each segment is a complete file
+        /// of its own with the header, the start record and all markers
+        /// declared so far. The segment that has been replaced is closed on
+        /// a background thread, so writing its index and footer does not
+        /// delay the samples.</para>
+        /// <para>Only the CSV output and the binary output to files are
+        /// rotated. The output is rotated once per pass of the I/O thread,
+        /// i.e. with a latency of up to <see cref="write_latency" />. This
+        /// setting is disabled by default.</para>
+        /// </remarks>
+        /// <param name="interval">The age of a segment in microseconds, or
+        /// zero to disable the rotation by time.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& rotate_interval(
+            _In_ const sampling_interval_type interval);
+
+        /// <summary>
+        /// Gets the size after which the output is continued in a new
+        /// segment.
+        /// </summary>
+        /// <returns>The size of a segment in bytes, which is zero if the
+        /// output is not rotated by size.</returns>
+        inline std::uint64_t rotate_size(void) const noexcept {
+            return this->_rotate_size;
+        }
+
+        /// <summary>
+        /// Sets the size after which the output is continued in a new
+        /// segment.
+        /// </summary>
+        /// <remarks>
+        /// The segments are rotated like for <see cref="rotate_interval" />,
+        /// once the data written to the current one reach the given size. A
+        /// segment exceeds the size by the data written in the pass of the
+        /// I/O thread reaching it. Both criteria can be combined, in which
+        /// case the one that is met first starts a new segment. This setting
+        /// is disabled by default.
+        /// </remarks>
+        /// <param name="size">The size of a segment in bytes, or zero to
+        /// disable the rotation by size.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& rotate_size(_In_ const std::uint64_t size);
+
         /// <summary>
         /// Gets the time interval in which the collector should sample the
         /// sensors.
@@ -91,6 +1231,650 @@ namespace power_overwhelming {
         collector_settings& sampling_interval(
             _In_ const sampling_interval_type interval);
 
+        /// <summary>
+        /// Gets the fraction of one CPU core that the collector may spend on
+        /// reading its sensors.
+        /// </summary>
+        /// <returns>The CPU budget, or zero if the CPU time is not limited.
+        /// </returns>
+        inline float sampling_cpu_budget(void) const noexcept {
+            return this->_sampling_cpu_budget;
+        }
+
+        /// <summary>
+        /// Sets the fraction of one CPU core that the collector may spend on
+        /// reading its sensors.
+        /// </summary>
+        /// <remarks>
+        /// <para>If a budget is set, the collector stretches the sampling
+        /// intervals of the sensors such that the CPU time of all reads
+        /// stays within the budget. Each sensor receives a share of the
+        /// budget in proportion to its <see cref="sensor_priority" />, but
+        /// never more than it needs for its configured interval, and shares
+        /// that are not needed are redistributed. The intervals are never
+        /// shortened below the configured ones.</para>
+        /// <para>The cost of a read is taken from the self-instrumentation of
+        /// the samplers if the sensor has been sampled before, from the
+        /// <see cref="capability_report" /> otherwise, or assumed to be ten
+        /// microseconds if neither knows the sensor. The intervals are
+        /// re-balanced when the collector is started, when sensors are
+        /// attached or detached and when the interval of a sensor is
+        /// changed, which restarts the sensors whose interval changes.</para>
+        /// <para>This setting is disabled by default.</para>
+        /// </remarks>
+        /// <param name="budget">The fraction of one core, for instance
+        /// <c>0.02f</c> for two percent, or zero for not limiting the CPU
+        /// time.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="budget" /> is negative.</exception>
+        collector_settings& sampling_cpu_budget(_In_ const float budget);
+
+        /// <summary>
+        /// Gets the number of reads per second that the collector may issue
+        /// to all of its sensors.
+        /// </summary>
+        /// <returns>The read budget, or zero if the number of reads is not
+        /// limited.</returns>
+        inline std::uint64_t sampling_read_budget(void) const noexcept {
+            return this->_sampling_read_budget;
+        }
+
+        /// <summary>
+        /// Sets the number of reads per second that the collector may issue
+        /// to all of its sensors.
+        /// </summary>
+        /// <remarks>
+        /// The read budget is distributed like the
+        /// <see cref="sampling_cpu_budget" />, which protects devices that
+        /// suffer from being polled rather than the CPU. Both budgets can be
+        /// combined, in which case both of them are kept.
+        /// </remarks>
+        /// <param name="budget">The number of reads per second, or zero for
+        /// not limiting the number of reads.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& sampling_read_budget(
+            _In_ const std::uint64_t budget);
+
+        /// <summary>
+        /// Gets the calibrated delay of the given sensor or type of sensor.
+        /// </summary>
+        /// <param name="sensor">The name of a sensor or the name of a sensor
+        /// type like <c>nvml_sensor</c>.</param>
+        /// <returns>The delay in microseconds configured for exactly this
+        /// name, or zero if there is none.</returns>
+        sampling_interval_type sensor_delay(
+            _In_opt_z_ const wchar_t *sensor) const noexcept;
+
+        /// <summary>
+        /// Sets the delay by which the samples of the given sensor or type of
+        /// sensor lag the actual power.
+        /// </summary>
+        /// <remarks>
+        /// <para>The delays are typically measured by the
+        /// <c>calibrate_sensors</c> tool from the response of the sensors to
+        /// steps of the load. The I/O thread moves the timestamps of a
+        /// sensor with a delay back by this amount, which replaces the
+        /// estimate used if <see cref="align_timestamps" /> is set. Delays
+        /// are applied regardless of this setting.</para>
+        /// <para>A delay for the name of a sensor takes precedence over a
+        /// delay for the type of the sensor.</para>
+        /// </remarks>
+        /// <param name="sensor">The name of a sensor or the name of a sensor
+        /// type.</param>
+        /// <param name="delay">The delay in microseconds, or zero to remove
+        /// the delay.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="sensor" /> is <c>nullptr</c>.</exception>
+        collector_settings& sensor_delay(_In_z_ const wchar_t *sensor,
+            _In_ const sampling_interval_type delay);
+
+        /// <summary>
+        /// Answer the names for which delays have been configured via
+        /// <see cref="sensor_delay" />.
+        /// </summary>
+        /// <param name="dst">Receives up to <paramref name="cnt" /> names,
+        /// which remain valid until the settings are modified. It is safe to
+        /// pass <c>nullptr</c>.</param>
+        /// <param name="cnt">The number of elements that <paramref name="dst" />
+        /// can hold.</param>
+        /// <returns>The total number of names with delays, which might be
+        /// larger than <paramref name="cnt" />.</returns>
+        std::size_t sensor_delays(
+            _Out_writes_opt_(cnt) const wchar_t **dst,
+            _In_ const std::size_t cnt) const noexcept;
+
+        /// <summary>
+        /// Gets the sampling interval configured for the given sensor or type
+        /// of sensor.
+        /// </summary>
+        /// <param name="sensor">The name of a sensor or the name of a sensor
+        /// type like <c>hmc8015_sensor</c>.</param>
+        /// <returns>The interval configured for exactly this name, or the
+        /// global <see cref="sampling_interval" /> if there is none.</returns>
+        sampling_interval_type sensor_interval(
+            _In_opt_z_ const wchar_t *sensor) const noexcept;
+
+        /// <summary>
+        /// Sets a specific sampling interval for the given sensor or type of
+        /// sensor.
+        /// </summary>
+        /// <remarks>
+        /// <para>Slow instruments like power analysers or oscilloscopes cannot
+        /// deliver samples at the rate of GPU sensors, nor should the GPU
+        /// sensors be slowed down to the rate of the instruments. A sensor
+        /// that matches a specific interval is sampled at this rate, while
+        /// all other sensors use the global <see cref="sampling_interval" />.
+        /// </para>
+        /// <para>An interval for the name of a sensor takes precedence over
+        /// an interval for the type of the sensor. The type is specified by
+        /// its name in the JSON configuration, for instance
+        /// <c>hmc8015_sensor</c>.</para>
+        /// </remarks>
+        /// <param name="sensor">The name of a sensor or the name of a sensor
+        /// type.</param>
+        /// <param name="interval">The sampling interval for the sensor, or
+        /// zero to use the global interval again.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="sensor" /> is <c>nullptr</c>.</exception>
+        collector_settings& sensor_interval(_In_z_ const wchar_t *sensor,
+            _In_ const sampling_interval_type interval);
+
+        /// <summary>
+        /// Answer the names for which specific sampling intervals have been
+        /// configured via <see cref="sensor_interval" />.
+        /// </summary>
+        /// <param name="dst">Receives up to <paramref name="cnt" /> names,
+        /// which remain valid until the settings are modified. It is safe to
+        /// pass <c>nullptr</c>.</param>
+        /// <param name="cnt">The number of elements that <paramref name="dst" />
+        /// can hold.</param>
+        /// <returns>The total number of names with specific intervals, which
+        /// might be larger than <paramref name="cnt" />.</returns>
+        std::size_t sensor_intervals(
+            _Out_writes_opt_(cnt) const wchar_t **dst,
+            _In_ const std::size_t cnt) const noexcept;
+
+        /// <summary>
+        /// Gets the priority of the given sensor or type of sensor when the
+        /// sampling budget is distributed.
+        /// </summary>
+        /// <param name="sensor">The name of a sensor or the name of a sensor
+        /// type like <c>nvml_sensor</c>.</param>
+        /// <returns>The priority configured for exactly this name, or one if
+        /// there is none.</returns>
+        float sensor_priority(_In_opt_z_ const wchar_t *sensor) const noexcept;
+
+        /// <summary>
+        /// Sets the priority of the given sensor or type of sensor when the
+        /// sampling budget is distributed.
+        /// </summary>
+        /// <remarks>
+        /// <para>The share of the <see cref="sampling_cpu_budget" /> and of
+        /// the <see cref="sampling_read_budget" /> a sensor receives is
+        /// proportional to its priority, ie a sensor with priority two may
+        /// spend twice as much as a sensor with the default priority of one
+        /// unless the latter does not need its share. The priorities have no
+        /// effect if no budget is set.</para>
+        /// <para>A priority for the name of a sensor takes precedence over a
+        /// priority for the type of the sensor.</para>
+        /// </remarks>
+        /// <param name="sensor">The name of a sensor or the name of a sensor
+        /// type.</param>
+        /// <param name="priority">The positive priority of the sensor, or
+        /// zero to restore the default priority.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="sensor" /> is <c>nullptr</c> or if
+        /// <paramref name="priority" /> is negative.</exception>
+        collector_settings& sensor_priority(_In_z_ const wchar_t *sensor,
+            _In_ const float priority);
+
+        /// <summary>
+        /// Answer the names for which priorities have been configured via
+        /// <see cref="sensor_priority" />.
+        /// </summary>
+        /// <param name="dst">Receives up to <paramref name="cnt" /> names,
+        /// which remain valid until the settings are modified. It is safe to
+        /// pass <c>nullptr</c>.</param>
+        /// <param name="cnt">The number of elements that <paramref name="dst" />
+        /// can hold.</param>
+        /// <returns>The total number of names with priorities, which might be
+        /// larger than <paramref name="cnt" />.</returns>
+        std::size_t sensor_priorities(
+            _Out_writes_opt_(cnt) const wchar_t **dst,
+            _In_ const std::size_t cnt) const noexcept;
+
+        /// <summary>
+        /// Gets the quantities configured for the given sensor or type of
+        /// sensor.
+        /// </summary>
+        /// <param name="sensor">The name of a sensor or the name of a sensor
+        /// type like <c>tinkerforge_sensor</c>.</param>
+        /// <returns>The quantities configured for exactly this name, or
+        /// <see cref="tinkerforge_sensor_source::none" /> if the sensor
+        /// samples its default quantities.</returns>
+        tinkerforge_sensor_source sensor_quantity(
+            _In_opt_z_ const wchar_t *sensor) const noexcept;
+
+        /// <summary>
+        /// Selects the quantities the given sensor or type of sensor samples.
+        /// </summary>
+        /// <remarks>
+        /// <para>Sensors that report voltage, current and power separately
+        /// can be restricted to the quantities actually needed, which reduces
+        /// the bandwidth to the hardware, the callback rate and the size of
+        /// the output. Currently, only <see cref="tinkerforge_sensor" />s
+        /// support selecting their quantities, which sample only the power by
+        /// default. Any other sensor always delivers what it measures.</para>
+        /// <para>The quantities for the name of a sensor take precedence over
+        /// the quantities for the type of the sensor.</para>
+        /// </remarks>
+        /// <param name="sensor">The name of a sensor or the name of a sensor
+        /// type.</param>
+        /// <param name="quantities">The quantities to be sampled, or
+        /// <see cref="tinkerforge_sensor_source::none" /> to sample the
+        /// default quantities of the sensor again.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="sensor" /> is <c>nullptr</c> or if
+        /// <paramref name="quantities" /> contains invalid bits.</exception>
+        collector_settings& sensor_quantity(_In_z_ const wchar_t *sensor,
+            _In_ const tinkerforge_sensor_source quantities);
+
+        /// <summary>
+        /// Answer the names for which specific quantities have been
+        /// configured via <see cref="sensor_quantity" />.
+        /// </summary>
+        /// <param name="dst">Receives up to <paramref name="cnt" /> names,
+        /// which remain valid until the settings are modified. It is safe to
+        /// pass <c>nullptr</c>.</param>
+        /// <param name="cnt">The number of elements that <paramref name="dst" />
+        /// can hold.</param>
+        /// <returns>The total number of names with specific quantities, which
+        /// might be larger than <paramref name="cnt" />.</returns>
+        std::size_t sensor_quantities(
+            _Out_writes_opt_(cnt) const wchar_t **dst,
+            _In_ const std::size_t cnt) const noexcept;
+
+        /// <summary>
+        /// Gets the name of the shared memory segment the collector publishes
+        /// the latest sample of each sensor in.
+        /// </summary>
+        /// <returns>The name of the segment, or <c>nullptr</c> if the
+        /// collector does not publish its samples.</returns>
+        inline _Ret_maybenull_z_ const wchar_t *shared_memory(
+                void) const noexcept {
+            return this->_shared_memory;
+        }
+
+        /// <summary>
+        /// Sets the name of the shared memory segment the collector publishes
+        /// the latest sample of each sensor in.
+        /// </summary>
+        /// <remarks>
+        /// <para>If set, the I/O thread copies the newest sample of each
+        /// sensor into the named segment whenever it drains the buffers,
+        /// regardless of whether a marker is required. Other processes can
+        /// read the samples without any system call using
+        /// <see cref="shared_measurement_reader" />. The samples therefore lag
+        /// behind the sensors by at most the
+        /// <see cref="write_latency" />.</para>
+        /// <para>On Windows, the name is the name of a file mapping and may
+        /// contain the prefixes <c>Local\</c> or <c>Global\</c>. On other
+        /// platforms, it is the name of a POSIX shared memory object without
+        /// the leading slash.</para>
+        /// <para>This setting is disabled by default.</para>
+        /// </remarks>
+        /// <param name="name">The name of the segment, or <c>nullptr</c> to
+        /// disable publishing the samples.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& shared_memory(_In_opt_z_ const wchar_t *name);
+
+        /// <summary>
+        /// Gets the number of samples that the ring feeding the subscribers of
+        /// the collector can hold.
+        /// </summary>
+        /// <returns>The capacity of the subscriber ring in samples.</returns>
+        inline std::size_t subscriber_capacity(void) const noexcept {
+            return this->_subscriber_capacity;
+        }
+
+        /// <summary>
+        /// Sets the number of samples that the ring feeding the subscribers of
+        /// the collector can hold.
+        /// </summary>
+        /// <remarks>
+        /// <para>All subscribers created by <see cref="collector::subscribe" />
+        /// read from a single ring, which the I/O thread fills with the same
+        /// samples it publishes as live samples. A subscriber that falls
+        /// behind by more than the capacity loses samples according to its
+        /// <see cref="subscriber_overflow" /> policy, but never slows down
+        /// the collector or the other subscribers.</para>
+        /// <para>The ring is allocated when the first subscriber is created.
+        /// </para>
+        /// </remarks>
+        /// <param name="capacity">The capacity of the ring in samples. This
+        /// number will be rounded up to the next power of two.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="capacity" /> is zero.</exception>
+        collector_settings& subscriber_capacity(
+            _In_ const std::size_t capacity);
+
+        /// <summary>
+        /// Gets whether the collector discards samples that repeat the
+        /// previous sample of the same sensor.
+        /// </summary>
+        /// <returns><c>true</c> if duplicates are discarded, <c>false</c>
+        /// otherwise.</returns>
+        inline bool suppress_duplicates(void) const noexcept {
+            return this->_suppress_duplicates;
+        }
+
+        /// <summary>
+        /// Sets whether the collector discards samples that repeat the
+        /// previous sample of the same sensor.
+        /// </summary>
+        /// <remarks>
+        /// <para>A sample is a duplicate if its voltage, current and power
+        /// are the same as in the previous sample of the sensor, which is
+        /// what sensors sampled faster than their native update interval
+        /// produce. Duplicates are discarded before the samples are written,
+        /// but after the energy has been integrated, such that
+        /// <see cref="integrate_energy" /> is not affected.</para>
+        /// <para>This setting is disabled by default.</para>
+        /// </remarks>
+        /// <param name="suppress">Whether to discard duplicates.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& suppress_duplicates(_In_ const bool suppress);
+
+        /// <summary>
+        /// Gets whether the samples of <see cref="tinkerforge_sensor" />s
+        /// carry the time when they arrived on the host.
+        /// </summary>
+        /// <returns><c>true</c> if the raw arrival times are kept, <c>false
+        /// </c> if the timestamps are reconstructed.</returns>
+        inline bool tinkerforge_arrival_times(void) const noexcept {
+            return this->_tinkerforge_arrival_times;
+        }
+
+        /// <summary>
+        /// Sets whether the samples of <see cref="tinkerforge_sensor" />s
+        /// carry the time when they arrived on the host.
+        /// </summary>
+        /// <remarks>
+        /// <para>By default, the sensors stamp their samples using a model of
+        /// the bricklet clock, which removes the jitter of the network and the
+        /// Brick daemon. See
+        /// <see cref="tinkerforge_sensor::reconstruct_timestamps" /> for
+        /// details.</para>
+        /// <para>This setting is disabled by default.</para>
+        /// </remarks>
+        /// <param name="keep">Whether to keep the raw arrival times.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& tinkerforge_arrival_times(_In_ const bool keep);
+
+        /// <summary>
+        /// Gets whether the collector estimates the distribution of the power
+        /// of each sensor per marker.
+        /// </summary>
+        /// <returns><c>true</c> if quantiles are tracked, <c>false</c>
+        /// otherwise.</returns>
+        inline bool track_quantiles(void) const noexcept {
+            return this->_track_quantiles;
+        }
+
+        /// <summary>
+        /// Sets whether the collector estimates the distribution of the power
+        /// of each sensor per marker.
+        /// </summary>
+        /// <remarks>
+        /// <para>If enabled, the I/O thread adds the power of each sample to
+        /// a streaming quantile sketch of its sensor and the active marker,
+        /// which has bounded memory regardless of the length of the
+        /// measurement. The percentiles of each combination are available
+        /// while running via <see cref="collector_statistics::quantile" />
+        /// and are written before the output is closed.</para>
+        /// <para>This setting is disabled by default.</para>
+        /// </remarks>
+        /// <param name="track">Whether to track the quantiles.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& track_quantiles(_In_ const bool track);
+
+        /// <summary>
+        /// Gets whether the collector checks the sequence numbers of the
+        /// samples for gaps and duplicates.
+        /// </summary>
+        /// <returns><c>true</c> if the sequence numbers are checked,
+        /// <c>false</c> otherwise.</returns>
+        inline bool track_sequences(void) const noexcept {
+            return this->_track_sequences;
+        }
+
+        /// <summary>
+        /// Sets whether the collector checks the sequence numbers of the
+        /// samples for gaps and duplicates.
+        /// </summary>
+        /// <remarks>
+        /// <para>If enabled, the I/O thread checks the
+        /// <see cref="measurement_data::sequence" /> of each sample it
+        /// receives and writes a record for each run of samples that has
+        /// been lost, be it because the sensor failed to deliver them or
+        /// because the buffers of the collector overflowed. Before the output
+        /// is closed, the number of samples, gaps, missing samples and
+        /// duplicates of each sensor is written. Samples that are not
+        /// numbered are ignored.</para>
+        /// <para>This setting is disabled by default.</para>
+        /// </remarks>
+        /// <param name="track">Whether to check the sequence numbers.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& track_sequences(_In_ const bool track);
+
+        /// <summary>
+        /// Gets whether setting a marker sends a software trigger to the
+        /// oscilloscopes being sampled.
+        /// </summary>
+        /// <returns><c>true</c> if markers trigger the oscilloscopes,
+        /// <c>false</c> otherwise.</returns>
+        inline bool trigger_oscilloscopes(void) const noexcept {
+            return this->_trigger_oscilloscopes;
+        }
+
+        /// <summary>
+        /// Sets whether setting a marker sends a software trigger to the
+        /// oscilloscopes being sampled.
+        /// </summary>
+        /// <remarks>
+        /// <para>If enabled, <see cref="collector::marker" /> calls
+        /// <see cref="rtx_sensor::trigger" /> on all oscilloscopes of the
+        /// collector whenever a marker other than zero is set. The trigger is
+        /// written asynchronously, so it does not stall the caller. Sensors
+        /// created with
+        /// <see cref="oscilloscope_sensor_definition::software_trigger" />
+        /// only acquire on these triggers and align their waveforms to the
+        /// host time at which the trigger was sent, which lines the captures
+        /// up with the phases of the application.</para>
+        /// <para>This setting is disabled by default.</para>
+        /// </remarks>
+        /// <param name="trigger">Whether markers trigger the oscilloscopes.
+        /// </param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& trigger_oscilloscopes(_In_ const bool trigger);
+
+        /// <summary>
+        /// Gets the power that triggers a capture if reached by a sample.
+        /// </summary>
+        /// <returns>The threshold in Watts, which is zero if samples do not
+        /// raise triggers.</returns>
+        inline float trigger_threshold(void) const noexcept {
+            return this->_trigger_threshold;
+        }
+
+        /// <summary>
+        /// Sets the power that triggers a capture if reached by a sample.
+        /// </summary>
+        /// <remarks>
+        /// The threshold is evaluated by the I/O thread for each sample of
+        /// any sensor. It has no effect unless the capture mode has been
+        /// enabled via <see cref="pre_trigger" /> or
+        /// <see cref="post_trigger" />. It is disabled by default.
+        /// </remarks>
+        /// <param name="threshold">The threshold in Watts, or zero to disable
+        /// triggers by samples.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& trigger_threshold(_In_ const float threshold);
+
+        /// <summary>
+        /// Gets the path to the file the collector archives the complete
+        /// waveforms of oscilloscopes in.
+        /// </summary>
+        /// <returns>The path to the archive, or <c>nullptr</c> if waveforms
+        /// are not archived.</returns>
+        inline _Ret_maybenull_z_ const wchar_t *waveform_archive(
+                void) const noexcept {
+            return this->_waveform_archive;
+        }
+
+        /// <summary>
+        /// Sets the path to the file the collector archives the complete
+        /// waveforms of oscilloscopes in.
+        /// </summary>
+        /// <remarks>
+        /// <para>If set, the collector appends each waveform that an
+        /// <c>rtx_sensor</c> downloads to a chunked binary file along with the
+        /// time of its trigger, its time range, its channel and its segment.
+        /// The waveforms are written on a background thread, and the archive
+        /// ends with an index of all waveforms ordered by the time of their
+        /// triggers, which allows for random access. The samples of
+        /// uncompressed waveforms are aligned such that the file can be
+        /// mapped into memory.</para>
+        /// <para>The samples derived from the waveforms are written to the
+        /// output as usual. This setting is disabled by default.</para>
+        /// </remarks>
+        /// <param name="path">The path to the archive, or <c>nullptr</c> to
+        /// disable it.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& waveform_archive(_In_opt_z_ const wchar_t *path);
+
+        /// <summary>
+        /// Gets the maximum time samples remain in the buffers before the
+        /// I/O thread writes them.
+        /// </summary>
+        /// <returns>The maximum write latency in microseconds.</returns>
+        inline sampling_interval_type write_latency(void) const noexcept {
+            return this->_write_latency;
+        }
+
+        /// <summary>
+        /// Sets the maximum time samples remain in the buffers before the
+        /// I/O thread writes them.
+        /// </summary>
+        /// <remarks>
+        /// The I/O thread is woken when any buffer reaches the
+        /// <see cref="write_threshold" /> or when the latency has elapsed,
+        /// whichever comes first. The latency is independent from the
+        /// sampling interval and is rounded up to full milliseconds.
+        /// </remarks>
+        /// <param name="latency">The maximum latency in microseconds.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="latency" /> is zero.</exception>
+        collector_settings& write_latency(
+            _In_ const sampling_interval_type latency);
+
+        /// <summary>
+        /// Gets the fill level of a buffer at which the I/O thread is woken to
+        /// write the samples.
+        /// </summary>
+        /// <returns>The fraction of the <see cref="buffer_size" /> that
+        /// triggers writing.</returns>
+        inline float write_threshold(void) const noexcept {
+            return this->_write_threshold;
+        }
+
+        /// <summary>
+        /// Sets the fill level of a buffer at which the I/O thread is woken to
+        /// write the samples.
+        /// </summary>
+        /// <remarks>
+        /// Lower thresholds make samples durable earlier at the expense of
+        /// more frequent writes, higher thresholds increase the risk of
+        /// dropping samples if the I/O thread cannot keep up.
+        /// </remarks>
+        /// <param name="threshold">The fraction of the
+        /// <see cref="buffer_size" />, which must be within (0, 1].</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="threshold" /> is out of range.</exception>
+        collector_settings& write_threshold(_In_ const float threshold);
+
+        /// <summary>
+        /// Gets whether the collector appends the self-instrumentation of the
+        /// samplers to the output.
+        /// </summary>
+        /// <returns><c>true</c> if the statistics are written, <c>false</c>
+        /// otherwise.</returns>
+        inline bool write_statistics(void) const noexcept {
+            return this->_write_statistics;
+        }
+
+        /// <summary>
+        /// Sets whether the collector appends the self-instrumentation of the
+        /// samplers to the output.
+        /// </summary>
+        /// <remarks>
+        /// <para>If enabled, the collector writes the
+        /// <see cref="sampler_statistics" /> of all sampler contexts that
+        /// were active while it was running before it closes the output. The
+        /// statistics allow for judging whether the samples were actually
+        /// taken at the requested interval.</para>
+        /// <para>This setting is disabled by default.</para>
+        /// </remarks>
+        /// <param name="write">Whether to write the statistics.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& write_statistics(_In_ const bool write);
+
+        /// <summary>
+        /// Gets the number of threads that format and write the samples.
+        /// </summary>
+        /// <returns>The number of writer threads.</returns>
+        inline std::size_t writer_threads(void) const noexcept {
+            return this->_writer_threads;
+        }
+
+        /// <summary>
+        /// Sets the number of threads that format and write the samples.
+        /// </summary>
+        /// <remarks>
+        /// <para>If more than one thread is requested, the buffers the
+        /// samples are delivered to are distributed among the threads, each
+        /// of which writes its own shard of the output. The first shard is
+        /// the <see cref="output_path" /> itself, the others are named like
+        /// the output with &quot;.shard&quot; and their index inserted before
+        /// the extension. All markers are replicated to every shard, such
+        /// that each of them is self-contained, and a manifest with
+        /// &quot;.shards.json&quot; appended to the output path lists the
+        /// shards.</para>
+        /// <para>Sharding is only supported for CSV and binary files and
+        /// cannot be combined with any processing that needs to see the
+        /// samples of all sensors, like aggregation, resampling, derived
+        /// sensors, filters, capture windows, the integration of the energy,
+        /// the tracking of quantiles or sequences, the alignment of
+        /// timestamps, the rotation of the output or the shared memory.
+        /// Live subscribers only receive the samples of the first shard.
+        /// </para>
+        /// <para>This setting defaults to a single thread.</para>
+        /// </remarks>
+        /// <param name="threads">The number of writer threads, which must
+        /// be at least one.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="threads" /> is zero.</exception>
+        collector_settings& writer_threads(_In_ const std::size_t threads);
+
         /// <summary>
         /// Assignment.
         /// </summary>
@@ -100,8 +1884,95 @@ namespace power_overwhelming {
 
     private:
 
+        /// <summary>
+        /// The name and the expression of a derived sensor.
+        /// </summary>
+        struct derived_sensor_type;
+
+        /// <summary>
+        /// A filter configured for a specific sensor or type.
+        /// </summary>
+        struct sensor_filter_type;
+
+        /// <summary>
+        /// A sampling interval or a delay configured for a specific sensor or
+        /// type.
+        /// </summary>
+        struct sensor_interval_type;
+
+        /// <summary>
+        /// The quantities selected for a specific sensor or type.
+        /// </summary>
+        struct sensor_quantity_type;
+
+        /// <summary>
+        /// A threshold for the change-only emission of a specific sensor or
+        /// type.
+        /// </summary>
+        struct sensor_threshold_type;
+
+        bool _aggregate_only;
+        sampling_interval_type _aggregation_window;
+        bool _align_timestamps;
+        std::size_t _buffer_size;
+        wchar_t *_capability_report;
+        bool _compress_output;
+        bool _compress_waveforms;
+        std::size_t _delta_threshold_count;
+        sensor_threshold_type *_delta_thresholds;
+        std::size_t _derived_sensor_count;
+        derived_sensor_type *_derived_sensors;
+        bool _estimate_power;
+        std::size_t _filter_count;
+        sensor_filter_type *_filters;
+        bool _integrate_energy;
+        bool _integrate_instruments;
+        sampling_interval_type _keep_alive_interval;
+        wchar_t *_kernel_energy;
+        bool _limit_to_native_interval;
+        bool _lock_memory;
+        bool _manual_pump;
+        wchar_t *_marker_channel;
+        bool _merge_instrument_logs;
+        sampling_interval_type _min_sampling_interval;
+        power_overwhelming::output_format _output_format;
         wchar_t *_output_path;
+        sampling_interval_type _overhead_interval;
+        wchar_t *_overhead_report;
+        sampling_interval_type _overhead_window;
+        sampling_interval_type _post_trigger;
+        sampling_interval_type _pre_trigger;
+        wchar_t *_process_energy;
+        bool _record_overhead;
+        bool _require_marker;
+        sampling_interval_type _resampling_interval;
+        bool _retain_unfiltered;
+        sampling_interval_type _rotate_interval;
+        std::uint64_t _rotate_size;
+        float _sampling_cpu_budget;
         sampling_interval_type _sampling_interval;
+        std::uint64_t _sampling_read_budget;
+        std::size_t _sensor_delay_count;
+        sensor_interval_type *_sensor_delays;
+        std::size_t _sensor_interval_count;
+        sensor_interval_type *_sensor_intervals;
+        sensor_threshold_type *_sensor_priorities;
+        std::size_t _sensor_priority_count;
+        sensor_quantity_type *_sensor_quantities;
+        std::size_t _sensor_quantity_count;
+        wchar_t *_shared_memory;
+        std::size_t _subscriber_capacity;
+        bool _suppress_duplicates;
+        bool _tinkerforge_arrival_times;
+        bool _track_quantiles;
+        bool _track_sequences;
+        bool _trigger_oscilloscopes;
+        float _trigger_threshold;
+        wchar_t *_waveform_archive;
+        sampling_interval_type _write_latency;
+        bool _write_statistics;
+        float _write_threshold;
+        std::size_t _writer_threads;
 
     };
 
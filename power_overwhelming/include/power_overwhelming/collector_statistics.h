@@ -0,0 +1,315 @@
+﻿// <copyright file="collector_statistics.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+
+#include "power_overwhelming/latency_histogram.h"
+#include "power_overwhelming/sensor.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    namespace detail { struct collector_statistics_impl; }
+
+    /// <summary>
+    /// A snapshot of the pipeline of a running <see cref="collector" />.
+    /// </summary>
+    /// <remarks>
+    /// <para>The snapshot describes how many samples the I/O thread of the
+    /// collector has processed from which sensor, how many are waiting in
+    /// the buffers of the sampling threads, how long writing the output took
+    /// and how many bytes have been written. This allows for sizing the
+    /// buffers and for detecting a saturated disk while the collector is
+    /// running.</para>
+    /// <para>The counters are maintained by the I/O thread without any lock
+    /// the sampling threads would have to take. The per-sensor counters and
+    /// the elapsed time are published once per pass of the I/O thread, so
+    /// the snapshot lags behind by up to the
+    /// <see cref="collector_settings::write_latency" />. The rates are
+    /// averages since the collector has been started; the current rates can
+    /// be obtained from the difference of two snapshots.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API collector_statistics final {
+
+    public:
+
+        /// <summary>
+        /// The type used to specify durations in microseconds.
+        /// </summary>
+        typedef power_overwhelming::sensor::microseconds_type interval_type;
+
+        /// <summary>
+        /// Initialises a new, empty instance.
+        /// </summary>
+        collector_statistics(void);
+
+        /// <summary>
+        /// Clone <paramref name="rhs" />.
+        /// </summary>
+        /// <param name="rhs">The object to be cloned.</param>
+        collector_statistics(_In_ const collector_statistics& rhs);
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        collector_statistics(_Inout_ collector_statistics&& rhs) noexcept;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~collector_statistics(void);
+
+        /// <summary>
+        /// Answer the number of samples that are waiting in the buffers of the
+        /// sampling threads for the I/O thread.
+        /// </summary>
+        /// <remarks>
+        /// A backlog approaching <see cref="collector_settings::buffer_size" />
+        /// per thread means that samples are about to be dropped.
+        /// </remarks>
+        /// <returns>The number of samples pending.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed by a move.</exception>
+        std::uint64_t backlog(void) const;
+
+        /// <summary>
+        /// Answer the memory occupied by the <see cref="backlog" />.
+        /// </summary>
+        /// <returns>The size of the pending samples in bytes.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed by a move.</exception>
+        std::uint64_t backlog_bytes(void) const;
+
+        /// <summary>
+        /// Answer the number of bytes written to the output.
+        /// </summary>
+        /// <remarks>
+        /// The number includes all segments if the output is rotated. It is
+        /// only maintained for the CSV and the binary output to files and
+        /// updated after each pass of the I/O thread.
+        /// </remarks>
+        /// <returns>The size of the output in bytes.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed by a move.</exception>
+        std::uint64_t bytes_written(void) const;
+
+        /// <summary>
+        /// Answer the number of samples that have been dropped, which is the
+        /// same as <see cref="collector::overflows" />.
+        /// </summary>
+        /// <returns>The number of dropped samples.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed by a move.</exception>
+        std::uint64_t dropped(void) const;
+
+        /// <summary>
+        /// Answer the time the I/O thread has been running when the counters
+        /// were published.
+        /// </summary>
+        /// <returns>The elapsed time in microseconds.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed by a move.</exception>
+        interval_type elapsed(void) const;
+
+        /// <summary>
+        /// Answer the time flushing the output took after each pass of the
+        /// I/O thread.
+        /// </summary>
+        /// <remarks>
+        /// High percentiles of this histogram indicate that the disk or the
+        /// network cannot keep up with the samples.
+        /// </remarks>
+        /// <returns>The durations of the flushes.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed by a move.</exception>
+        const latency_histogram& flush_duration(void) const;
+
+        /// <summary>
+        /// Answer the number of times markers have been set or cleared.
+        /// </summary>
+        /// <returns>The number of marker events written.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed by a move.</exception>
+        std::uint64_t marker_events(void) const;
+
+        /// <summary>
+        /// Answer the estimated power of a sensor at the given quantile of its
+        /// distribution while a marker was active.
+        /// </summary>
+        /// <remarks>
+        /// The collector only estimates the minimum, the 1st, 5th, 10th,
+        /// 25th, 50th, 75th, 90th, 95th and 99th percentile and the maximum.
+        /// Other quantiles are interpolated linearly.
+        /// </remarks>
+        /// <param name="index">The index of the summary, which must be less
+        /// than <see cref="quantiles" />.</param>
+        /// <param name="q">The quantile, which is clamped to [0, 1].</param>
+        /// <returns>The power in Watts.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed by a move.</exception>
+        /// <exception cref="std::out_of_range">If <paramref name="index" />
+        /// is not a valid summary.</exception>
+        float quantile(_In_ const std::size_t index, _In_ const double q) const;
+
+        /// <summary>
+        /// Answer the ID of the marker the given summary of quantiles refers
+        /// to.
+        /// </summary>
+        /// <param name="index">The index of the summary, which must be less
+        /// than <see cref="quantiles" />.</param>
+        /// <returns>The ID of the marker, which is zero for the samples
+        /// before the first marker.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed by a move.</exception>
+        /// <exception cref="std::out_of_range">If <paramref name="index" />
+        /// is not a valid summary.</exception>
+        std::uint32_t quantile_marker(_In_ const std::size_t index) const;
+
+        /// <summary>
+        /// Answer the number of samples the given summary of quantiles has
+        /// been estimated from.
+        /// </summary>
+        /// <param name="index">The index of the summary, which must be less
+        /// than <see cref="quantiles" />.</param>
+        /// <returns>The number of samples.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed by a move.</exception>
+        /// <exception cref="std::out_of_range">If <paramref name="index" />
+        /// is not a valid summary.</exception>
+        std::uint64_t quantile_samples(_In_ const std::size_t index) const;
+
+        /// <summary>
+        /// Answer the name of the sensor the given summary of quantiles
+        /// refers to.
+        /// </summary>
+        /// <param name="index">The index of the summary, which must be less
+        /// than <see cref="quantiles" />.</param>
+        /// <returns>The name of the sensor.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed by a move.</exception>
+        /// <exception cref="std::out_of_range">If <paramref name="index" />
+        /// is not a valid summary.</exception>
+        _Ret_z_ const wchar_t *quantile_sensor(
+            _In_ const std::size_t index) const;
+
+        /// <summary>
+        /// Answer the number of summaries of quantiles, one for each
+        /// combination of sensor and marker.
+        /// </summary>
+        /// <remarks>
+        /// Quantiles are only available if
+        /// <see cref="collector_settings::track_quantiles" /> is set.
+        /// </remarks>
+        /// <returns>The number of summaries.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed by a move.</exception>
+        std::size_t quantiles(void) const;
+
+        /// <summary>
+        /// Answer the average number of samples processed per second.
+        /// </summary>
+        /// <returns>The rate of all sensors in samples per second, or zero
+        /// if no time has elapsed.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed by a move.</exception>
+        double sample_rate(void) const;
+
+        /// <summary>
+        /// Answer the number of samples the I/O thread has retrieved, which
+        /// is the same as <see cref="collector::samples" />.
+        /// </summary>
+        /// <returns>The number of samples retrieved.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed by a move.</exception>
+        std::uint64_t samples(void) const;
+
+        /// <summary>
+        /// Answer the name of the given sensor.
+        /// </summary>
+        /// <param name="index">The index of the sensor, which must be less
+        /// than <see cref="sensors" />.</param>
+        /// <returns>The name of the sensor.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed by a move.</exception>
+        /// <exception cref="std::out_of_range">If <paramref name="index" />
+        /// is not a valid sensor.</exception>
+        _Ret_z_ const wchar_t *sensor(_In_ const std::size_t index) const;
+
+        /// <summary>
+        /// Answer the average number of samples per second of the given
+        /// sensor.
+        /// </summary>
+        /// <param name="index">The index of the sensor, which must be less
+        /// than <see cref="sensors" />.</param>
+        /// <returns>The rate of the sensor in samples per second, or zero if
+        /// no time has elapsed.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed by a move.</exception>
+        /// <exception cref="std::out_of_range">If <paramref name="index" />
+        /// is not a valid sensor.</exception>
+        double sensor_rate(_In_ const std::size_t index) const;
+
+        /// <summary>
+        /// Answer the number of samples retrieved from the given sensor.
+        /// </summary>
+        /// <param name="index">The index of the sensor, which must be less
+        /// than <see cref="sensors" />.</param>
+        /// <returns>The number of samples of the sensor.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed by a move.</exception>
+        /// <exception cref="std::out_of_range">If <paramref name="index" />
+        /// is not a valid sensor.</exception>
+        std::uint64_t sensor_samples(_In_ const std::size_t index) const;
+
+        /// <summary>
+        /// Answer the number of sensors samples have been retrieved from.
+        /// </summary>
+        /// <returns>The number of sensors.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed by a move.</exception>
+        std::size_t sensors(void) const;
+
+        /// <summary>
+        /// Assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_statistics& operator =(_In_ const collector_statistics& rhs);
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_statistics& operator =(
+            _Inout_ collector_statistics&& rhs) noexcept;
+
+        /// <summary>
+        /// Determines whether the object is valid.
+        /// </summary>
+        /// <remarks>
+        /// The object is only invalid if it has been disposed by a move.
+        /// </remarks>
+        /// <returns><c>true</c> if the object is valid, <c>false</c>
+        /// otherwise.</returns>
+        operator bool(void) const noexcept;
+
+    private:
+
+        const detail::collector_statistics_impl& check_not_disposed(
+            void) const;
+
+        detail::collector_statistics_impl *_impl;
+
+        friend class collector;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,215 @@
+﻿// <copyright file="collector_subscriber.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+
+#include "power_overwhelming/measurement.h"
+#include "power_overwhelming/subscriber_overflow.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations */
+    namespace detail { struct collector_subscriber_impl; }
+
+    /// <summary>
+    /// Receives the live samples of a <see cref="collector" /> within the
+    /// same process.
+    /// </summary>
+    /// <remarks>
+    /// <para>Subscribers are created by <see cref="collector::subscribe" />
+    /// or by a <see cref="sensor_stream" />.
+    /// The I/O thread of the collector copies every sample it processes into
+    /// a single broadcast ring, from which each subscriber reads at its own
+    /// pace via its own cursor. This allows for feeding on-screen overlays or
+    /// schedulers from the same hardware reads as the output file without
+    /// sampling the sensors a second time. The samples are the same that are
+    /// published in shared memory, ie they are aligned and filtered, but not
+    /// subject to markers.</para>
+    /// <para>Neither the collector nor the subscribers take a lock while
+    /// samples are exchanged. If a subscriber does not keep up, it loses
+    /// samples according to its <see cref="overflow" /> policy, which never
+    /// affects the collector or other subscribers.</para>
+    /// <para>A subscriber must only be used by one thread at a time. It
+    /// remains valid after its collector has been destroyed, but will not
+    /// receive any more samples.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API collector_subscriber final {
+
+    public:
+
+        /// <summary>
+        /// The type of a callback that is invoked once samples are pending.
+        /// </summary>
+        typedef void (*notification_callback)(_In_opt_ void *context);
+
+        /// <summary>
+        /// Initialises a new, invalid instance.
+        /// </summary>
+        inline collector_subscriber(void) noexcept : _impl(nullptr) { }
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline collector_subscriber(_Inout_ collector_subscriber&& rhs) noexcept
+                : _impl(rhs._impl) {
+            rhs._impl = nullptr;
+        }
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~collector_subscriber(void);
+
+        /// <summary>
+        /// Answer the number of samples that have been published since the
+        /// last read.
+        /// </summary>
+        /// <remarks>
+        /// The number might exceed the number of samples that can actually be
+        /// read if the subscriber has fallen behind.
+        /// </remarks>
+        /// <returns>The number of pending samples, which is zero if the
+        /// object has been disposed.</returns>
+        std::uint64_t available(void) const noexcept;
+
+        /// <summary>
+        /// Removes the pending notification registered via
+        /// <see cref="notify" />, if any.
+        /// </summary>
+        /// <remarks>
+        /// The notification is also cancelled when the subscriber is
+        /// destroyed.
+        /// </remarks>
+        /// <returns><c>true</c> if a notification has been removed,
+        /// <c>false</c> if none was pending.</returns>
+        bool cancel(void) noexcept;
+
+        /// <summary>
+        /// Answer the number of samples that have been lost because they were
+        /// overwritten before the subscriber read them.
+        /// </summary>
+        /// <returns>The number of lost samples.</returns>
+        std::uint64_t lost(void) const noexcept;
+
+        /// <summary>
+        /// Requests a single invocation of <paramref name="callback" /> once
+        /// samples are pending or no more samples will arrive.
+        /// </summary>
+        /// <remarks>
+        /// <para>This is the non-blocking counterpart of <see cref="wait" />.
+        /// It allows for resuming a consumer on an executor of its choice,
+        /// for instance a coroutine awaiting the next batch, without tying up
+        /// a thread. The callback runs on the thread publishing the samples,
+        /// which is the I/O thread of the collector, and must therefore only
+        /// schedule the actual work.</para>
+        /// <para>Only one notification can be pending at a time.</para>
+        /// </remarks>
+        /// <param name="callback">The callback to be invoked.</param>
+        /// <param name="context">A user-defined pointer that is passed to
+        /// <paramref name="callback" />.</param>
+        /// <returns><c>true</c> if the callback will be invoked, <c>false</c>
+        /// if samples are already pending, if the collector has been
+        /// destroyed or if the object has been disposed, in which case the
+        /// callback will not be invoked and the caller should read
+        /// immediately.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="callback" /> is <c>nullptr</c>.</exception>
+        bool notify(_In_ const notification_callback callback,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Answer what happens if the subscriber falls behind.
+        /// </summary>
+        /// <returns>The overflow policy of the subscriber.</returns>
+        subscriber_overflow overflow(void) const noexcept;
+
+        /// <summary>
+        /// Reads the pending samples into the given buffers.
+        /// </summary>
+        /// <param name="samples">Receives the samples.</param>
+        /// <param name="sensors">Receives the interned names of the sensors
+        /// of the samples, which remain valid until the process exits. This
+        /// parameter may be <c>nullptr</c>.</param>
+        /// <param name="cnt">The number of elements that the buffers can
+        /// hold.</param>
+        /// <returns>The number of samples read, which is zero if no sample is
+        /// pending or if the object has been disposed.</returns>
+        std::size_t read(_Out_writes_(cnt) measurement_data *samples,
+            _Out_writes_opt_(cnt) const wchar_t **sensors,
+            _In_ const std::size_t cnt) noexcept;
+
+        /// <summary>
+        /// Reads all pending samples and passes them to the given callback.
+        /// </summary>
+        /// <remarks>
+        /// The callback is invoked on the calling thread for each run of
+        /// consecutive samples from the same sensor.
+        /// </remarks>
+        /// <param name="callback">The callback receiving the samples.</param>
+        /// <param name="context">A user-defined pointer that is passed to
+        /// <paramref name="callback" />.</param>
+        /// <returns>The number of samples read.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="callback" /> is <c>nullptr</c>.</exception>
+        std::size_t read(_In_ const measurement_data_callback callback,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Blocks the calling thread until samples are pending or the timeout
+        /// expires.
+        /// </summary>
+        /// <remarks>
+        /// The collector only wakes waiting subscribers once per pass of its
+        /// I/O thread, ie the latency is bounded by
+        /// <see cref="collector_settings::write_latency" />.
+        /// </remarks>
+        /// <param name="timeout">The maximum time to wait in milliseconds.
+        /// </param>
+        /// <returns><c>true</c> if samples are pending, <c>false</c> if the
+        /// timeout expired, if the collector has been destroyed or if the
+        /// object has been disposed.</returns>
+        bool wait(_In_ const std::uint32_t timeout);
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_subscriber& operator =(
+            _Inout_ collector_subscriber&& rhs) noexcept;
+
+        /// <summary>
+        /// Determines whether the object is valid.
+        /// </summary>
+        /// <remarks>
+        /// The object is valid if it has been created by a collector and has
+        /// not been disposed by a move.
+        /// </remarks>
+        /// <returns><c>true</c> if the object is valid, <c>false</c>
+        /// otherwise.</returns>
+        operator bool(void) const noexcept;
+
+    private:
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        inline explicit collector_subscriber(
+            _In_ detail::collector_subscriber_impl *impl) noexcept
+            : _impl(impl) { }
+
+        detail::collector_subscriber_impl *_impl;
+
+        friend class collector;
+        friend class sensor_stream;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <cinttypes>
+#include <cstddef>
 
 #include "power_overwhelming/power_overwhelming_api.h"
 
@@ -58,5 +59,24 @@ namespace power_overwhelming {
     extern POWER_OVERWHELMING_API void set_thread_affinity(
         _In_ const std::uint32_t logical_cpu);
 
+    /// <summary>
+    /// Sets the CPU affinity of the calling thread to the given set of
+    /// logical CPUs.
+    /// </summary>
+    /// <remarks>
+    /// On Windows, all CPUs must be in the same processor group.
+    /// </remarks>
+    /// <param name="logical_cpus">The indices of the logical CPUs the thread
+    /// may run on.</param>
+    /// <param name="cnt">The number of elements in
+    /// <paramref name="logical_cpus" />.</param>
+    /// <exception cref="std::invalid_argument">If
+    /// <paramref name="logical_cpus" /> is <c>nullptr</c> or if
+    /// <paramref name="cnt" /> is zero.</exception>
+    /// <exception cref="std::system_error">If the operation failed.</exception>
+    extern POWER_OVERWHELMING_API void set_thread_affinity(
+        _In_reads_(cnt) const std::uint32_t *logical_cpus,
+        _In_ const std::size_t cnt);
+
 } /* namespace power_overwhelming */
 } /* namespace visus */
@@ -66,6 +66,38 @@ namespace power_overwhelming {
         std::uint8_t stepping;
     };
 
+    /// <summary>
+    /// Describes where a logical CPU is located in the physical topology of the
+    /// machine.
+    /// </summary>
+    /// <remarks>
+    /// The identifiers are only meaningful for comparing logical CPUs, e.g. two
+    /// logical CPUs with the same <see cref="package" /> are on the same
+    /// socket. They are not necessarily contiguous.
+    /// </remarks>
+    struct cpu_topology {
+
+        /// <summary>
+        /// Identifies the physical package (socket) of the logical CPU.
+        /// </summary>
+        std::uint32_t package;
+
+        /// <summary>
+        /// Identifies the die of the logical CPU within its package.
+        /// </summary>
+        /// <remarks>
+        /// If the operating system does not report dies, this is the same as
+        /// <see cref="package" />.
+        /// </remarks>
+        std::uint32_t die;
+
+        /// <summary>
+        /// Identifies the physical core of the logical CPU within its package,
+        /// which is shared by all hardware threads of the core.
+        /// </summary>
+        std::uint32_t core;
+    };
+
     /// <summary>
     /// Specifies different vendors of CPUs.
     /// </summary>
@@ -268,16 +300,38 @@ namespace power_overwhelming {
         _Out_writes_opt_(cnt) cpu_info *infos,
         _In_ std::uint32_t cnt);
 
+    /// <summary>
+    /// Determines the location of the specified logical CPU in the physical
+    /// topology of the machine.
+    /// </summary>
+    /// <remarks>
+    /// On Linux, the information is retrieved from the sysfs. If it is not
+    /// available there, all logical CPUs are reported to be on package 0 and to
+    /// be distinct cores. On Windows, the information is retrieved from
+    /// <c>GetLogicalProcessorInformationEx</c>.
+    /// </remarks>
+    /// <param name="logical_cpu">The zero-based index of the logical CPU, which
+    /// is the same as for <see cref="set_thread_affinity" />.</param>
+    /// <returns>The topology of the logical CPU.</returns>
+    /// <exception cref="std::system_error">If the topology could not be
+    /// retrieved from the operating system.</exception>
+    /// <exception cref="std::invalid_argument">If
+    /// <paramref name="logical_cpu" /> does not exist.</exception>
+    extern POWER_OVERWHELMING_API cpu_topology get_cpu_topology(
+        _In_ const std::uint32_t logical_cpu);
+
     /// <summary>
     /// Determines the vendor of the CPUs on the system.
     /// </summary>
     /// <remarks>
-    /// This function works using the CPUID intrinsics. For the unlikely case
-    /// that the code is running on a machine with different kinds of CPUs, the
-    /// caller should set the thread affinity to the desired CPU in order to
-    /// make sure that the CPUID registers of the expected processors are read.
-    /// The <see cref="set_thread_affinity" /> function can be used for this
-    /// purpose.
+    /// This function works using the CPUID intrinsics, which are run only once
+    /// per process on the thread that first asks for the vendor. The result is
+    /// cached, so the thread affinity has no effect on later calls. For the
+    /// unlikely case that the code is running on a machine with different
+    /// kinds of CPUs, the caller should set the thread affinity to the desired
+    /// CPU using <see cref="set_thread_affinity" /> and use
+    /// <see cref="get_cpu_info" /> and <see cref="extract_cpu_vendor" />
+    /// instead.
     /// </remarks>
     /// <returns>An enumeration value identifying the CPU vendor or
     /// <see cref="cpu_vendor::unknown" /> if the CPU vendor could not be
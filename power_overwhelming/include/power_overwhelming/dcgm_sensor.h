@@ -0,0 +1,224 @@
+﻿// <copyright file="dcgm_sensor.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+#include "power_overwhelming/multi_channel_sensor.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations */
+    namespace detail { struct dcgm_sensor_impl; }
+
+
+    /// <summary>
+    /// Implementation of a GPU sensor for NVIDIA data-centre GPUs using the
+    /// field watches of the NVIDIA Data Center GPU Manager (DCGM).
+    /// </summary>
+    /// <remarks>
+    /// <para>In contrast to the <see cref="nvml_sensor" />, which polls the
+    /// driver from the measurement process, this sensor connects to the DCGM
+    /// host engine of the node and registers a watch for the board power,
+    /// the energy counter, the clocks and the utilisation of all GPUs at the
+    /// requested update interval. The host engine samples the GPUs, and the
+    /// sensor only retrieves the latest values. This does not interfere with
+    /// the cluster monitoring, which uses the same host engine. If no host
+    /// engine is running, an embedded one is started in the process.</para>
+    /// <para>All sensors created with the same host and update interval share
+    /// a single connection, which retrieves the values of all GPUs in one
+    /// call. If the sensors are sampled together, the host engine is only
+    /// queried once per tick.</para>
+    /// <para>DCGM is loaded lazily when the first sensor is created or
+    /// enumerated. If it is not installed or the library has been built
+    /// without support for it, there are no sensors of this type.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API dcgm_sensor final
+            : public multi_channel_sensor {
+
+    public:
+
+        /// <summary>
+        /// The type of the DCGM identifier of a GPU.
+        /// </summary>
+        typedef unsigned int gpu_type;
+
+        /// <summary>
+        /// The default interval in microseconds at which the host engine
+        /// updates the watched fields.
+        /// </summary>
+        /// <remarks>
+        /// The host engine is shared with the cluster monitoring, and the
+        /// driver does not update the power readings much faster anyway, so
+        /// the default is far slower than the
+        /// <see cref="default_sampling_period" />.
+        /// </remarks>
+        static constexpr microseconds_type default_update_interval = 100000;
+
+        /// <summary>
+        /// The index of the channel for the board power in Watts.
+        /// </summary>
+        static constexpr std::size_t channel_power = 0;
+
+        /// <summary>
+        /// The index of the channel for the energy consumed since the driver
+        /// was loaded in Joules.
+        /// </summary>
+        static constexpr std::size_t channel_energy = 1;
+
+        /// <summary>
+        /// The index of the channel for the SM clock in MHz.
+        /// </summary>
+        static constexpr std::size_t channel_sm_clock = 2;
+
+        /// <summary>
+        /// The index of the channel for the memory clock in MHz.
+        /// </summary>
+        static constexpr std::size_t channel_memory_clock = 3;
+
+        /// <summary>
+        /// The index of the channel for the GPU utilisation in per cent.
+        /// </summary>
+        static constexpr std::size_t channel_utilisation = 4;
+
+        /// <summary>
+        /// Create sensors for all GPUs managed by the local DCGM host engine,
+        /// which update at the <see cref="default_update_interval" />.
+        /// </summary>
+        /// <param name="out_sensors">Receives the sensors, if not
+        /// <c>nullptr</c>.</param>
+        /// <param name="cnt_sensors">The available space in
+        /// <paramref name="out_sensors" />.</param>
+        /// <returns>The number of sensors available on the system, regardless
+        /// of the size of the output array. If this number is larger than
+        /// <paramref name="cnt_sensors" />, not all sensors have been returned.
+        /// </returns>
+        static std::size_t for_all(
+            _Out_writes_opt_(cnt_sensors) dcgm_sensor *out_sensors,
+            _In_ const std::size_t cnt_sensors);
+
+        /// <summary>
+        /// Create sensors for all GPUs managed by the specified DCGM host
+        /// engine.
+        /// </summary>
+        /// <param name="out_sensors">Receives the sensors, if not
+        /// <c>nullptr</c>.</param>
+        /// <param name="cnt_sensors">The available space in
+        /// <paramref name="out_sensors" />.</param>
+        /// <param name="host">The address of the host engine. If
+        /// <c>nullptr</c> or empty, the host engine of the local node is used
+        /// or an embedded one is started.</param>
+        /// <param name="update_interval">The interval in microseconds at which
+        /// the host engine updates the watched fields.</param>
+        /// <returns>The number of sensors available on the system, regardless
+        /// of the size of the output array.</returns>
+        static std::size_t for_all(
+            _Out_writes_opt_(cnt_sensors) dcgm_sensor *out_sensors,
+            _In_ const std::size_t cnt_sensors,
+            _In_opt_z_ const char *host,
+            _In_ const microseconds_type update_interval);
+
+        /// <summary>
+        /// Create a sensor for the specified GPU.
+        /// </summary>
+        /// <param name="gpu">The DCGM identifier of the GPU.</param>
+        /// <param name="host">The address of the host engine. If
+        /// <c>nullptr</c> or empty, the host engine of the local node is used
+        /// or an embedded one is started.</param>
+        /// <param name="update_interval">The interval in microseconds at which
+        /// the host engine updates the watched fields.</param>
+        /// <returns>The sensor for the GPU.</returns>
+        /// <exception cref="std::invalid_argument">If the GPU is not managed
+        /// by the host engine or if <paramref name="update_interval" /> is not
+        /// positive.</exception>
+        /// <exception cref="std::runtime_error">If DCGM is not available.
+        /// </exception>
+        static dcgm_sensor for_gpu(_In_ const gpu_type gpu,
+            _In_opt_z_ const char *host = nullptr,
+            _In_ const microseconds_type update_interval
+            = default_update_interval);
+
+        /// <summary>
+        /// Initialises a new, invalid instance.
+        /// </summary>
+        dcgm_sensor(void);
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline dcgm_sensor(_In_ dcgm_sensor&& rhs) noexcept
+                : multi_channel_sensor(std::move(rhs)), _impl(rhs._impl) {
+            rhs._impl = nullptr;
+        }
+
+        /// <summary>
+        /// Finalise the instance.
+        /// </summary>
+        virtual ~dcgm_sensor(void);
+
+        /// <inheritdoc />
+        virtual sensor_channel channel(
+            _In_ const std::size_t index) const override;
+
+        /// <inheritdoc />
+        virtual std::size_t channels(void) const noexcept override;
+
+        /// <summary>
+        /// Answer the DCGM identifier of the GPU.
+        /// </summary>
+        /// <returns>The identifier of the GPU.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been
+        /// disposed.</exception>
+        gpu_type gpu(void) const;
+
+        /// <summary>
+        /// Answer the address of the host engine the sensor is connected to.
+        /// </summary>
+        /// <returns>The address of the host engine, which is empty for the
+        /// local or embedded one.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been
+        /// disposed.</exception>
+        _Ret_z_ const char *host(void) const;
+
+        /// <inheritdoc />
+        virtual _Ret_maybenull_z_ const wchar_t *name(
+            void) const noexcept override;
+
+        /// <summary>
+        /// Answer the interval at which the host engine updates the values.
+        /// </summary>
+        /// <returns>The update interval of the watch in microseconds.
+        /// </returns>
+        virtual microseconds_type native_interval(void) const override;
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        dcgm_sensor& operator =(_In_ dcgm_sensor&& rhs) noexcept;
+
+        /// <inheritdoc />
+        virtual operator bool(void) const noexcept override;
+
+    protected:
+
+        /// <inheritdoc />
+        timestamp_type sample_channels_sync(
+            _Out_writes_(channels()) value_type *dst,
+            _In_ const timestamp_resolution resolution) const override;
+
+    private:
+
+        detail::dcgm_sensor_impl *_impl;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,31 @@
+﻿// <copyright file="device_catalogue.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// Discards the cached results of the sensor discovery such that the next
+    /// call to one of the <c>for_all</c> methods enumerates the devices
+    /// again.
+    /// </summary>
+    /// <remarks>
+    /// <para>The library enumerates EMI devices, MSR files, NVML devices and
+    /// ADL adapters only once and reuses the results for subsequent calls.
+    /// On Windows, the cache is discarded automatically if a device is added
+    /// to or removed from the system, so this function is only required if
+    /// the set of sensors changes without a PnP notification, for instance
+    /// if the MSR driver is installed while the application is running.</para>
+    /// <para>Sensors that have already been created are not affected.</para>
+    /// </remarks>
+    void POWER_OVERWHELMING_API refresh_device_catalogue(void) noexcept;
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
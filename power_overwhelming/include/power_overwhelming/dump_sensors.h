@@ -9,6 +9,7 @@
 #include <string>
 
 #include "power_overwhelming/power_overwhelming_api.h"
+#include "power_overwhelming/sensor_filter.h"
 
 
 namespace visus {
@@ -34,6 +35,50 @@ namespace power_overwhelming {
     /// failed.</exception>
     std::size_t POWER_OVERWHELMING_API dump_sensors(_In_z_ const wchar_t *path);
 
+    /// <summary>
+    /// Saves a JSON array of all sensors currently found on the the system
+    /// that are accepted by the given filter.
+    /// </summary>
+    /// <remarks>
+    /// The descriptors are written to the file as soon as all sensors of one
+    /// type have been discovered. Sensor types that are rejected by the type
+    /// filter are not enumerated at all, which is much faster than dumping
+    /// all sensors on large machines.
+    /// </remarks>
+    /// <param name="path">The path of the file to write the sensor data to.
+    /// </param>
+    /// <param name="filter">The filter selecting the sensors to be dumped.
+    /// </param>
+    /// <returns>The number of sensors actually dumped.</returns>
+    /// <exception cref="std::ios_base::failure">If saving the sensor data
+    /// failed.</exception>
+    /// <exception cref="std::regex_error">If any of the patterns of the
+    /// filter is not a valid regular expression.</exception>
+    std::size_t POWER_OVERWHELMING_API dump_sensors(_In_z_ const char *path,
+        _In_ const sensor_filter& filter);
+
+    /// <summary>
+    /// Saves a JSON array of all sensors currently found on the the system
+    /// that are accepted by the given filter.
+    /// </summary>
+    /// <remarks>
+    /// The descriptors are written to the file as soon as all sensors of one
+    /// type have been discovered. Sensor types that are rejected by the type
+    /// filter are not enumerated at all, which is much faster than dumping
+    /// all sensors on large machines.
+    /// </remarks>
+    /// <param name="path">The path of the file to write the sensor data to.
+    /// </param>
+    /// <param name="filter">The filter selecting the sensors to be dumped.
+    /// </param>
+    /// <returns>The number of sensors actually dumped.</returns>
+    /// <exception cref="std::ios_base::failure">If saving the sensor data
+    /// failed.</exception>
+    /// <exception cref="std::regex_error">If any of the patterns of the
+    /// filter is not a valid regular expression.</exception>
+    std::size_t POWER_OVERWHELMING_API dump_sensors(_In_z_ const wchar_t *path,
+        _In_ const sensor_filter& filter);
+
     /// <summary>
     /// Saves a JSON array of all sensors currently found on the the system.
     /// </summary>
@@ -47,5 +92,24 @@ namespace power_overwhelming {
         return dump_sensors(path.c_str());
     }
 
+    /// <summary>
+    /// Saves a JSON array of all sensors currently found on the the system
+    /// that are accepted by the given filter.
+    /// </summary>
+    /// <param name="path">The path of the file to write the sensor data to.
+    /// </param>
+    /// <param name="filter">The filter selecting the sensors to be dumped.
+    /// </param>
+    /// <returns>The number of sensors actually dumped.</returns>
+    /// <exception cref="std::ios_base::failure">If saving the sensor data
+    /// failed.</exception>
+    /// <exception cref="std::regex_error">If any of the patterns of the
+    /// filter is not a valid regular expression.</exception>
+    template<class TChar>
+    inline std::size_t dump_sensors(_In_ const std::basic_string<TChar>& path,
+            _In_ const sensor_filter& filter) {
+        return dump_sensors(path.c_str(), filter);
+    }
+
 } /* namespace power_overwhelming */
 } /* namespace visus */
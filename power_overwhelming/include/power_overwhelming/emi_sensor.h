@@ -172,6 +172,32 @@ namespace power_overwhelming {
             _In_z_ const char_type *device,
             _In_ const channel_type channel);
 
+        /// <summary>
+        /// Samples all of the given sensors without attaching their names to
+        /// the samples.
+        /// </summary>
+        /// <remarks>
+        /// This is the batch variant of <see cref="sample_data" />, which
+        /// enters the library only once for all sensors of the family.
+        /// </remarks>
+        /// <param name="dst">Receives <paramref name="cnt" /> samples.</param>
+        /// <param name="sensors">The sensors to be sampled.</param>
+        /// <param name="cnt">The number of sensors in
+        /// <paramref name="sensors" />.</param>
+        /// <param name="resolution">The resolution of the timestamps to be
+        /// created. This parameter defaults to
+        /// <see cref="timestamp_resolution::milliseconds" />.</param>
+        /// <exception cref="std::invalid_argument">If <paramref name="dst" />
+        /// or <paramref name="sensors" /> is <c>nullptr</c> while
+        /// <paramref name="cnt" /> is not zero.</exception>
+        /// <exception cref="std::runtime_error">If any of the sensors has been
+        /// moved (and therefore disposed).</exception>
+        static void sample_data(_Out_writes_(cnt) measurement_data *dst,
+            _In_reads_(cnt) const emi_sensor *sensors,
+            _In_ const std::size_t cnt,
+            _In_ const timestamp_resolution resolution
+            = timestamp_resolution::milliseconds);
+
         /// <summary>
         /// Initialises a new instance.
         /// </summary>
@@ -212,10 +238,42 @@ namespace power_overwhelming {
         /// <returns>The number of channels read at once.</returns>
         channel_type channels(void) const;
 
+        /// <summary>
+        /// Answer the absolute energy the firmware reports for the channel of
+        /// the sensor.
+        /// </summary>
+        /// <remarks>
+        /// The counter has 64 bits and therefore does not wrap in practice,
+        /// so the difference between two calls is the energy consumed in the
+        /// meantime regardless of whether the sensor has been sampled.
+        /// </remarks>
+        /// <returns>The energy in Joules since an undefined point in time.
+        /// </returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        /// <exception cref="std::system_error">If the device could not be
+        /// read.</exception>
+        double energy(void) const;
+
         /// <inheritdoc />
         virtual _Ret_maybenull_z_ const wchar_t *name(
             void) const noexcept override;
 
+        /// <summary>
+        /// Answer the interval at which the firmware updates the energy
+        /// counters.
+        /// </summary>
+        /// <remarks>
+        /// The interval is determined empirically by watching the timestamp
+        /// of the device change when the method is first called, which may
+        /// take up to a second.
+        /// </remarks>
+        /// <returns>The update interval in microseconds, or zero if it could
+        /// not be determined.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        virtual microseconds_type native_interval(void) const override;
+
         /// <summary>
         /// Answer the path to the underlying device.
         /// </summary>
@@ -246,6 +304,34 @@ namespace power_overwhelming {
             _In_ const microseconds_type period = default_sampling_period,
             _In_opt_ void *context = nullptr);
 
+        /// <summary>
+        /// Asynchronously sample the sensor every
+        /// <paramref name="sampling_period "/> microseconds and deliver the
+        /// samples in batches.
+        /// </summary>
+        /// <remarks>
+        /// The sensor is sampled by the same specialised thread as with
+        /// <see cref="sample" />, which reads all channels of an EMI device at
+        /// once. The samples are delivered as soon as they have been read.
+        /// </remarks>
+        /// <param name="on_batch">The callback to be invoked if new data
+        /// arrived. If this is <c>nullptr</c>, the asynchronous sampling will
+        /// be disabled.</param>
+        /// <param name="period">The desired sampling period in
+        /// microseconds. This parameter defaults to 1 millisecond.</param>
+        /// <param name="context">A user-defined context pointer that is passed
+        /// on to <see cref="on_batch" />. This parameter defaults to
+        /// <c>nullptr</c>.</para>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        /// <exception cref="std::logic_error">If the sensor is already being
+        /// sampled asynchronously due to a previous call to the method or to
+        /// <see cref="sample" />.</exception>
+        virtual void sample_batch(
+            _In_opt_ const measurement_data_callback on_batch,
+            _In_ const microseconds_type period = default_sampling_period,
+            _In_opt_ void *context = nullptr) override;
+
 #if defined(_WIN32)
         /// <summary>
         /// Obtains a new sample from EMI using an IOCTL on the underlying
@@ -294,6 +380,24 @@ namespace power_overwhelming {
 
         using sensor::sample;
 
+        /// <summary>
+        /// Sample the sensor using a timestamp with the specified resolution,
+        /// but do not attach the sensor that produces the data to the sample.
+        /// </summary>
+        /// <remarks>
+        /// This method hides <see cref="sensor::sample_data" /> and provides a
+        /// fast path for code that knows the type of the sensor, because it
+        /// does not need any virtual call.
+        /// </remarks>
+        /// <param name="resolution">The resolution of the timestamp to be
+        /// created. This parameter defaults to
+        /// <see cref="timestamp_resolution::milliseconds" />.</param>
+        /// <returns>A single measurement made by the sensor.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved
+        /// (and therefore disposed).</exception>
+        measurement_data sample_data(_In_ const timestamp_resolution resolution
+            = timestamp_resolution::milliseconds) const;
+
         /// <summary>
         /// Answer the version of the Energy Meter Interface used by the sensor.
         /// </summary>
@@ -0,0 +1,202 @@
+﻿// <copyright file="energy_meter.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstddef>
+
+#include "power_overwhelming/sensor.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations */
+    namespace detail { struct energy_meter_impl; }
+
+    /// <summary>
+    /// Measures the energy sensors with native energy counters consume
+    /// between two points in time without any sampling thread.
+    /// </summary>
+    /// <remarks>
+    /// <para>The meter reads the counters of all sensors when it is started
+    /// and once more when it is stopped, and reports the differences. It
+    /// neither starts any thread nor allocates any memory while running, so
+    /// it is the cheapest way of obtaining the energy of a phase if the time
+    /// series of the power is not needed. The counters are read directly,
+    /// regardless of whether the sensors are being sampled by other code at
+    /// the same time.</para>
+    /// <para>The meter supports the RAPL sensors <see cref="msr_sensor" />
+    /// and <see cref="perf_rapl_sensor" />, <see cref="emi_sensor" />,
+    /// <see cref="nvml_sensor" /> on devices providing the total energy,
+    /// <see cref="amdgpu_sensor" /> and <see cref="sysfs_sensor" /> reading
+    /// an energy, and <see cref="level_zero_sensor" />.</para>
+    /// <para>The RAPL registers read by <see cref="msr_sensor" /> and the
+    /// energy counters in sysfs wrap. The meter accounts for one wrap between
+    /// starting and stopping, so phases measured on these sensors must be
+    /// shorter than the wrap period, which is a few minutes for RAPL under
+    /// high load. All other counters have 64 bits.</para>
+    /// <para>The sensors must outlive the meter. The meter is not
+    /// thread-safe.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API energy_meter final {
+
+    public:
+
+        /// <summary>
+        /// Answer whether the given sensor provides an energy counter the
+        /// meter can read.
+        /// </summary>
+        /// <param name="source">The sensor to be tested.</param>
+        /// <returns><c>true</c> if the sensor can be added to a meter,
+        /// <c>false</c> otherwise.</returns>
+        static bool supports(_In_ const sensor& source) noexcept;
+
+        /// <summary>
+        /// Initialises a new instance without any sensor.
+        /// </summary>
+        /// <exception cref="std::bad_alloc">If the state of the meter could
+        /// not be allocated.</exception>
+        energy_meter(void);
+
+        /// <summary>
+        /// Initialises a new instance for the given sensors and starts it.
+        /// </summary>
+        /// <param name="sensors">The sensors to be measured.</param>
+        /// <param name="cnt">The number of elements in
+        /// <paramref name="sensors" />.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="sensors" /> is <c>nullptr</c> while
+        /// <paramref name="cnt" /> is not zero, or if any of the sensors is
+        /// <c>nullptr</c> or not supported.</exception>
+        /// <exception cref="std::system_error">If reading a counter failed.
+        /// </exception>
+        energy_meter(_In_reads_(cnt) const sensor *const *sensors,
+            _In_ const std::size_t cnt);
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline energy_meter(_Inout_ energy_meter&& rhs) noexcept
+                : _impl(rhs._impl) {
+            rhs._impl = nullptr;
+        }
+
+        energy_meter(const energy_meter&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~energy_meter(void);
+
+        /// <summary>
+        /// Adds a sensor to the meter.
+        /// </summary>
+        /// <param name="source">The sensor to be measured, which must outlive
+        /// the meter.</param>
+        /// <exception cref="std::runtime_error">If the object has been moved.
+        /// </exception>
+        /// <exception cref="std::logic_error">If the meter is running.
+        /// </exception>
+        /// <exception cref="std::invalid_argument">If the sensor does not
+        /// provide an energy counter.</exception>
+        void add(_In_ const sensor& source);
+
+        /// <summary>
+        /// Answer the time between starting and stopping the meter.
+        /// </summary>
+        /// <returns>The elapsed time in seconds up to now if the meter is
+        /// running, or zero if it has never been started.</returns>
+        double elapsed(void) const noexcept;
+
+        /// <summary>
+        /// Answer the energy the specified sensor has consumed between
+        /// starting and stopping the meter.
+        /// </summary>
+        /// <param name="index">The index of the sensor in the order in which
+        /// the sensors have been added.</param>
+        /// <returns>The energy in Joules. If the meter is running, the
+        /// counter is read now, which yields the energy consumed so far.
+        /// </returns>
+        /// <exception cref="std::runtime_error">If the object has been moved.
+        /// </exception>
+        /// <exception cref="std::out_of_range">If <paramref name="index" />
+        /// does not designate a sensor of the meter.</exception>
+        /// <exception cref="std::logic_error">If the meter has never been
+        /// started.</exception>
+        double energy(_In_ const std::size_t index) const;
+
+        /// <summary>
+        /// Answer the name of the specified sensor.
+        /// </summary>
+        /// <param name="index">The index of the sensor in the order in which
+        /// the sensors have been added.</param>
+        /// <returns>The name of the sensor, or <c>nullptr</c> if
+        /// <paramref name="index" /> is out of range.</returns>
+        _Ret_maybenull_z_ const wchar_t *name(
+            _In_ const std::size_t index) const noexcept;
+
+        /// <summary>
+        /// Answer whether the meter is running.
+        /// </summary>
+        /// <returns><c>true</c> if the meter has been started, but not yet
+        /// stopped, <c>false</c> otherwise.</returns>
+        bool running(void) const noexcept;
+
+        /// <summary>
+        /// Answer the number of sensors the meter reads.
+        /// </summary>
+        /// <returns>The number of sensors.</returns>
+        std::size_t size(void) const noexcept;
+
+        /// <summary>
+        /// Reads the counters of all sensors as the begin of a new
+        /// measurement, discarding the result of the previous one.
+        /// </summary>
+        /// <exception cref="std::runtime_error">If the object has been moved.
+        /// </exception>
+        /// <exception cref="std::system_error">If reading a counter failed.
+        /// </exception>
+        void start(void);
+
+        /// <summary>
+        /// Reads the counters of all sensors as the end of the measurement.
+        /// </summary>
+        /// <remarks>
+        /// Stopping a meter that is not running has no effect.
+        /// </remarks>
+        /// <exception cref="std::runtime_error">If the object has been moved.
+        /// </exception>
+        /// <exception cref="std::system_error">If reading a counter failed.
+        /// </exception>
+        void stop(void);
+
+        energy_meter& operator =(const energy_meter&) = delete;
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        energy_meter& operator =(_Inout_ energy_meter&& rhs) noexcept;
+
+        /// <summary>
+        /// Determines whether the object is valid.
+        /// </summary>
+        /// <remarks>
+        /// The object is valid unless it has been disposed by a move.
+        /// </remarks>
+        /// <returns><c>true</c> if the object is valid, <c>false</c>
+        /// otherwise.</returns>
+        operator bool(void) const noexcept;
+
+    private:
+
+        detail::energy_meter_impl *_impl;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,59 @@
+﻿// <copyright file="enumerate_sensors.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// The number of sensors <see cref="enumerate_sensors" /> makes room for
+    /// before it knows how many sensors there are.
+    /// </summary>
+    constexpr std::size_t default_sensor_capacity = 8;
+
+    /// <summary>
+    /// Creates all sensors of the specified type in a single pass over the
+    /// hardware if possible.
+    /// </summary>
+    /// <remarks>
+    /// <para>Instead of asking <c>for_all</c> for the number of sensors
+    /// first and creating them in a second call, which enumerates the
+    /// hardware twice, the function provides room for
+    /// <paramref name="capacity" /> sensors right away and only calls
+    /// <c>for_all</c> a second time if there are more sensors than
+    /// that.</para>
+    /// <para>All sensor types with the standard static <c>for_all</c> method
+    /// fill as many sensors as fit into the output and return the total
+    /// number available, which makes this approach safe.</para>
+    /// </remarks>
+    /// <typeparam name="TSensor">The type of the sensor to retrieve, which must
+    /// have the standard static <c>for_all</c> method for retrieval.</typeparam>
+    /// <param name="capacity">The number of sensors expected.</param>
+    /// <returns>All sensors of the specified type, which are available on the
+    /// system.</returns>
+    template<class TSensor> inline std::vector<TSensor> enumerate_sensors(
+            _In_ const std::size_t capacity = default_sensor_capacity) {
+        std::vector<TSensor> retval(capacity);
+        const auto cnt = TSensor::for_all(retval.data(), retval.size());
+
+        if (cnt > retval.size()) {
+            retval.resize(cnt);
+            TSensor::for_all(retval.data(), retval.size());
+        } else {
+            retval.resize(cnt);
+        }
+
+        return retval;
+    }
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -11,10 +11,16 @@
 #include <Windows.h>
 #pragma pop_macro("NOMINMAX")
 
+#elif defined(__linux__)
+#define POWER_OVERWHELMING_EVENT_EVENTFD
+
 #else /*defined(_WIN32) */
 #define POWER_OVERWHELMING_EVENT_EMULATION
 #endif /* defined(_WIN32) */
 
+#include <cstddef>
+#include <limits>
+
 #include "power_overwhelming/power_overwhelming_api.h"
 
 
@@ -22,22 +28,34 @@ namespace visus {
 namespace power_overwhelming {
 
     /* Forward declarations. */
-#if defined(POWER_OVERWHELMING_EVENT_EMULATION)
+#if !defined(_WIN32)
     namespace detail { struct event_impl; }
-#endif /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
+#endif /* !defined(_WIN32) */
 
     /// <summary>
     /// Represents an opaque event handle.
     /// </summary>
     /// <remarks>
-    /// Callers should not make any assumptions about the internals of the event
-    /// handle.
+    /// <para>Callers should not make any assumptions about the internals of
+    /// the event handle.</para>
+    /// <para>On Windows, the handle is a native event. On Linux, the event is
+    /// an <c>eventfd</c>, which can be retrieved via
+    /// <see cref="event_descriptor" /> in order to wait for it in an
+    /// <c>epoll</c> set or an <c>io_uring</c> poll request. On all other
+    /// platforms, the event is emulated using a condition variable.</para>
     /// </remarks>
-#if defined(POWER_OVERWHELMING_EVENT_EMULATION)
-    typedef detail::event_impl *event_type;
-#else /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
+#if defined(_WIN32)
     typedef HANDLE event_type;
-#endif /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
+#else /* defined(_WIN32) */
+    typedef detail::event_impl *event_type;
+#endif /* defined(_WIN32) */
+
+    /// <summary>
+    /// The value <see cref="wait_events" /> returns if none of the events has
+    /// been signalled in time.
+    /// </summary>
+    constexpr std::size_t wait_events_timeout
+        = (std::numeric_limits<std::size_t>::max)();
 
     /// <summary>
     /// Allocates a new event object.
@@ -58,6 +76,24 @@ namespace power_overwhelming {
     extern void POWER_OVERWHELMING_API destroy_event(
         _Inout_opt_ event_type& event);
 
+#if defined(POWER_OVERWHELMING_EVENT_EVENTFD)
+    /// <summary>
+    /// Answer the <c>eventfd</c> of the given event.
+    /// </summary>
+    /// <remarks>
+    /// The descriptor becomes readable when the event is signalled. It is
+    /// owned by the event and must neither be closed nor read from. Polling
+    /// it does not reset an auto-reset event, wherefore callers waiting for
+    /// it in their own <c>epoll</c> set must call <see cref="wait_event" />
+    /// with a zero timeout to consume the signal.
+    /// </remarks>
+    /// <param name="event">The event to retrieve the descriptor of.</param>
+    /// <returns>The file descriptor of the event.</returns>
+    /// <exception cref="std::system_error">If <paramref name="event" /> is
+    /// invalid.</exception>
+    extern int POWER_OVERWHELMING_API event_descriptor(_In_ event_type event);
+#endif /* defined(POWER_OVERWHELMING_EVENT_EVENTFD) */
+
     /// <summary>
     /// Resets a manual reset event.
     /// </summary>
@@ -94,5 +130,58 @@ namespace power_overwhelming {
     extern bool POWER_OVERWHELMING_API wait_event(_In_ event_type event,
         _In_ const unsigned int timeout);
 
+    /// <summary>
+    /// Waits for any or all of the given events to become signalled.
+    /// </summary>
+    /// <remarks>
+    /// <para>Auto-reset events that satisfy the wait are reset. If multiple
+    /// events are signalled when waiting for any of them, the one with the
+    /// lowest index is reported and the others remain signalled.</para>
+    /// <para>On Windows, waiting for all events is atomic and limited to
+    /// <c>MAXIMUM_WAIT_OBJECTS</c> events. On all other platforms, an
+    /// auto-reset event is consumed as soon as it is signalled while the
+    /// call waits for the others, i.e. the call returns once each event has
+    /// been signalled at least once.</para>
+    /// <para>The emulation on platforms other than Windows and Linux polls
+    /// the events every millisecond.</para>
+    /// </remarks>
+    /// <param name="events">The handles of the events to wait for.</param>
+    /// <param name="cnt">The number of events.</param>
+    /// <param name="wait_all"><c>true</c> for waiting until all events have
+    /// been signalled, <c>false</c> for waiting for any of them.</param>
+    /// <returns>The index of the event that has been signalled if
+    /// <paramref name="wait_all" /> is <c>false</c>, zero otherwise.
+    /// </returns>
+    /// <exception cref="std::invalid_argument">If the number of events is
+    /// not supported by the platform.</exception>
+    /// <exception cref="std::system_error">In case the operation failed.
+    /// </exception>
+    extern std::size_t POWER_OVERWHELMING_API wait_events(
+        _In_reads_(cnt) const event_type *events,
+        _In_ const std::size_t cnt,
+        _In_ const bool wait_all);
+
+    /// <summary>
+    /// Waits for any or all of the given events to become signalled.
+    /// </summary>
+    /// <param name="events">The handles of the events to wait for.</param>
+    /// <param name="cnt">The number of events.</param>
+    /// <param name="wait_all"><c>true</c> for waiting until all events have
+    /// been signalled, <c>false</c> for waiting for any of them.</param>
+    /// <param name="timeout">The timeout to wait in milliseconds.</param>
+    /// <returns>The index of the event that has been signalled if
+    /// <paramref name="wait_all" /> is <c>false</c>, zero otherwise, or
+    /// <see cref="wait_events_timeout" /> if the operation timed out without
+    /// another error.</returns>
+    /// <exception cref="std::invalid_argument">If the number of events is
+    /// not supported by the platform.</exception>
+    /// <exception cref="std::system_error">In case the operation failed.
+    /// </exception>
+    extern std::size_t POWER_OVERWHELMING_API wait_events(
+        _In_reads_(cnt) const event_type *events,
+        _In_ const std::size_t cnt,
+        _In_ const bool wait_all,
+        _In_ const unsigned int timeout);
+
 } /* namespace power_overwhelming */
 } /* namespace visus */
@@ -0,0 +1,178 @@
+﻿// <copyright file="frame_marker.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+#if defined(_WIN32)
+/* Forward declarations */
+struct IDXGISwapChain;
+#endif /* defined(_WIN32) */
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations */
+    namespace detail { struct frame_marker_impl; }
+
+    /// <summary>
+    /// Marks the frames of an interactive application in a
+    /// <see cref="collector" /> such that the energy can be attributed to
+    /// individual frames.
+    /// </summary>
+    /// <remarks>
+    /// <para>Frame markers are created by <see cref="collector::track_frames" />.
+    /// Each frame starts a new phase of the marker the frame marker has been
+    /// created for, so if <see cref="collector_settings::integrate_energy" />
+    /// is enabled, the summary of the collector holds the energy of each
+    /// frame. The boundaries are also written to the output like any other
+    /// marker.</para>
+    /// <para>In contrast to <see cref="collector::marker" />, marking a frame
+    /// only takes a timestamp and pushes it to a lock-free ring, which the
+    /// I/O thread of the collector drains, so it never blocks the rendering
+    /// thread. If the ring is full, the frame boundary is dropped and
+    /// counted in <see cref="dropped" />. Frame boundaries do not start or
+    /// stop sampling if <see cref="collector_settings::require_marker" /> is
+    /// set, and they are only recorded while the collector is running.</para>
+    /// <para>A frame marker must only be used by one thread at a time, and a
+    /// collector can only have one frame marker. The frame marker remains
+    /// valid after its collector has been destroyed, but the frames are not
+    /// recorded anymore.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API frame_marker final {
+
+    public:
+
+        /// <summary>
+        /// Initialises a new, invalid instance.
+        /// </summary>
+        inline frame_marker(void) noexcept : _impl(nullptr) { }
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline frame_marker(_Inout_ frame_marker&& rhs) noexcept
+                : _impl(rhs._impl) {
+            rhs._impl = nullptr;
+        }
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        /// <remarks>
+        /// If the frame marker has hooked a swap chain, the hook is removed.
+        /// </remarks>
+        ~frame_marker(void);
+
+        /// <summary>
+        /// Marks the begin of a frame.
+        /// </summary>
+        /// <remarks>
+        /// It is safe to call this method on a disposed object.
+        /// </remarks>
+        void begin(void) noexcept;
+
+        /// <summary>
+        /// Answer the number of frame boundaries that have been dropped
+        /// because the I/O thread of the collector did not keep up.
+        /// </summary>
+        /// <returns>The number of dropped frame boundaries.</returns>
+        std::uint64_t dropped(void) const noexcept;
+
+        /// <summary>
+        /// Marks the end of a frame.
+        /// </summary>
+        /// <remarks>
+        /// <para>The time between the end of a frame and the begin of the next
+        /// one is a phase without marker. Applications that render
+        /// continuously can call <see cref="present" /> instead of pairing
+        /// <see cref="begin" /> and <see cref="end" />.</para>
+        /// <para>It is safe to call this method on a disposed object.</para>
+        /// </remarks>
+        void end(void) noexcept;
+
+#if defined(_WIN32)
+        /// <summary>
+        /// Hooks <c>IDXGISwapChain::Present</c> such that each presentation
+        /// marks a frame boundary like <see cref="present" />.
+        /// </summary>
+        /// <remarks>
+        /// <para>The hook replaces the method in the virtual function table of
+        /// the swap chain, which is shared by all swap chains of the same
+        /// implementation in the process. Therefore, only one frame marker
+        /// can hook swap chains at a time.</para>
+        /// <para>The hook must be removed via <see cref="unhook" /> or by
+        /// destroying the frame marker while no other thread is presenting.
+        /// </para>
+        /// </remarks>
+        /// <param name="swap_chain">The swap chain to be hooked.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="swap_chain" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::logic_error">If another frame marker has
+        /// already hooked a swap chain or if the object has been disposed.
+        /// </exception>
+        /// <exception cref="std::system_error">If the function table could
+        /// not be patched.</exception>
+        void hook(_In_ IDXGISwapChain *swap_chain);
+#endif /* defined(_WIN32) */
+
+        /// <summary>
+        /// Marks the end of the current frame and the begin of the next one.
+        /// </summary>
+        /// <remarks>
+        /// It is safe to call this method on a disposed object.
+        /// </remarks>
+        void present(void) noexcept;
+
+#if defined(_WIN32)
+        /// <summary>
+        /// Removes the hook installed by <see cref="hook" />.
+        /// </summary>
+        /// <remarks>
+        /// It is safe to call this method if no swap chain has been hooked.
+        /// </remarks>
+        void unhook(void) noexcept;
+#endif /* defined(_WIN32) */
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        frame_marker& operator =(_Inout_ frame_marker&& rhs) noexcept;
+
+        /// <summary>
+        /// Determines whether the object is valid.
+        /// </summary>
+        /// <remarks>
+        /// The object is valid if it has been created by a collector and has
+        /// not been disposed by a move.
+        /// </remarks>
+        /// <returns><c>true</c> if the object is valid, <c>false</c>
+        /// otherwise.</returns>
+        operator bool(void) const noexcept;
+
+    private:
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        inline explicit frame_marker(
+            _In_ detail::frame_marker_impl *impl) noexcept
+            : _impl(impl) { }
+
+        detail::frame_marker_impl *_impl;
+
+        friend class collector;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
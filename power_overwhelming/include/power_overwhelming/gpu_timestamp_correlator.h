@@ -0,0 +1,269 @@
+﻿// <copyright file="gpu_timestamp_correlator.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "power_overwhelming/collector.h"
+#include "power_overwhelming/graphics_device.h"
+#include "power_overwhelming/timestamp_resolution.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations */
+    namespace detail { struct gpu_timestamp_correlator_impl; }
+
+    /// <summary>
+    /// Maps timestamps of the GPU onto the timestamps of the library, such
+    /// that GPU work can be correlated with power samples and placed in the
+    /// output of a <see cref="collector" /> as markers.
+    /// </summary>
+    /// <remarks>
+    /// <para>GPU timestamps are ticks of a clock on the device, which is
+    /// neither synchronised with the clock of the host nor running at the
+    /// same rate. The correlator records pairs of GPU and host time whenever
+    /// it is calibrated and fits the offset and the drift of the GPU clock
+    /// through the most recent ones, the same way time stamps of measurement
+    /// instruments are converted. Calibrating once in a while, for instance
+    /// at the begin of every few frames, is therefore sufficient to keep the
+    /// mapping accurate over long benchmarks.</para>
+    /// <para>If the library uses Direct3D 12, the correlator can manage
+    /// timestamp queries on its own: <see cref="mark" /> records a query for
+    /// a marker in a command list, <see cref="resolve" /> copies the results
+    /// into a read-back buffer and <see cref="collect" /> sets the markers
+    /// in a collector once the GPU has executed the command lists. As the
+    /// application decides when to collect, for instance after waiting for
+    /// the fence of a frame it needs to wait for anyway, the CPU never stalls
+    /// for the queries.</para>
+    /// <para>The correlator is not thread-safe.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API gpu_timestamp_correlator final {
+
+    public:
+
+        /// <summary>
+        /// A callback that reads the current value of the GPU clock.
+        /// </summary>
+        typedef std::uint64_t (*clock_query_type)(_In_opt_ void *context);
+
+        /// <summary>
+        /// The type of a GPU timestamp in ticks of the GPU clock.
+        /// </summary>
+        typedef std::uint64_t gpu_timestamp_type;
+
+        /// <summary>
+        /// The type of a timestamp of the host.
+        /// </summary>
+        typedef measurement::timestamp_type timestamp_type;
+
+        /// <summary>
+        /// The default number of timestamp queries that can be in flight.
+        /// </summary>
+        static constexpr std::size_t default_capacity = 1024;
+
+        /// <summary>
+        /// Initialises a new instance that cannot be used for anything.
+        /// </summary>
+        gpu_timestamp_correlator(void) noexcept;
+
+        /// <summary>
+        /// Initialises a new instance for a GPU clock running at the given
+        /// frequency, which is calibrated by the caller.
+        /// </summary>
+        /// <remarks>
+        /// Use this constructor for APIs other than Direct3D 12, for
+        /// instance for the calibrated timestamps of Vulkan, and calibrate
+        /// the instance using the overload of <see cref="calibrate" /> that
+        /// reads the clock via a callback.
+        /// </remarks>
+        /// <param name="frequency">The number of ticks of the GPU clock per
+        /// second.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="frequency" /> is zero.</exception>
+        explicit gpu_timestamp_correlator(
+            _In_ const gpu_timestamp_type frequency);
+
+#if (POWER_OVERWHELMING_GPU_ABSTRACTION == 12)
+        /// <summary>
+        /// Initialises a new instance for the GPU clock of the given command
+        /// queue and creates the resources for the timestamp queries.
+        /// </summary>
+        /// <remarks>
+        /// The new instance is calibrated once. The reference count of the
+        /// queue is incremented.
+        /// </remarks>
+        /// <param name="queue">The command queue that executes the command
+        /// lists the timestamp queries are recorded in.</param>
+        /// <param name="capacity">The number of queries that can be recorded
+        /// before they need to be collected.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="queue" /> is <c>nullptr</c> or if
+        /// <paramref name="capacity" /> is zero.</exception>
+        /// <exception cref="std::system_error">If the resources for the
+        /// queries could not be created.</exception>
+        explicit gpu_timestamp_correlator(_In_ ID3D12CommandQueue *queue,
+            _In_ const std::size_t capacity = default_capacity);
+#endif /* (POWER_OVERWHELMING_GPU_ABSTRACTION == 12) */
+
+        gpu_timestamp_correlator(const gpu_timestamp_correlator&) = delete;
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline gpu_timestamp_correlator(
+                _Inout_ gpu_timestamp_correlator&& rhs) noexcept
+                : _impl(rhs._impl) {
+            rhs._impl = nullptr;
+        }
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~gpu_timestamp_correlator(void);
+
+        /// <summary>
+        /// Records the current time of the command queue the correlator has
+        /// been created for.
+        /// </summary>
+        /// <exception cref="std::logic_error">If the object has not been
+        /// created for a command queue.</exception>
+        /// <exception cref="std::system_error">If the calibration of the
+        /// clocks could not be retrieved.</exception>
+        void calibrate(void);
+
+        /// <summary>
+        /// Records the current time of the GPU clock as reported by the
+        /// given callback.
+        /// </summary>
+        /// <remarks>
+        /// The host time is taken immediately before and after invoking the
+        /// callback, so the callback should do nothing but reading the
+        /// clock.
+        /// </remarks>
+        /// <param name="query">The callback reading the GPU clock.</param>
+        /// <param name="context">A user-defined pointer passed to
+        /// <paramref name="query" />.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="query" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::runtime_error">If the object is invalid.
+        /// </exception>
+        void calibrate(_In_ const clock_query_type query,
+            _In_opt_ void *context);
+
+#if (POWER_OVERWHELMING_GPU_ABSTRACTION == 12)
+        /// <summary>
+        /// Sets a marker in <paramref name="dst" /> for all queries that have
+        /// been resolved.
+        /// </summary>
+        /// <remarks>
+        /// The caller must make sure that the GPU has executed all command
+        /// lists passed to <see cref="resolve" /> before calling this
+        /// method, typically by waiting for a fence it signals after the
+        /// command lists anyway. The markers are set within the
+        /// <see cref="collector_settings::write_latency" /> of the collector,
+        /// so the application should collect at least once per frame.
+        /// </remarks>
+        /// <param name="dst">The collector the markers are set in.</param>
+        /// <returns>The number of markers set.</returns>
+        /// <exception cref="std::runtime_error">If the object is invalid.
+        /// </exception>
+        /// <exception cref="std::system_error">If the read-back buffer could
+        /// not be mapped.</exception>
+        std::size_t collect(_In_ collector& dst);
+#endif /* (POWER_OVERWHELMING_GPU_ABSTRACTION == 12) */
+
+        /// <summary>
+        /// Answer the number of ticks of the GPU clock per second.
+        /// </summary>
+        /// <returns>The frequency of the GPU clock, or zero if the object is
+        /// invalid.</returns>
+        gpu_timestamp_type frequency(void) const noexcept;
+
+#if (POWER_OVERWHELMING_GPU_ABSTRACTION == 12)
+        /// <summary>
+        /// Records a timestamp query for the given marker in a command list.
+        /// </summary>
+        /// <param name="list">The command list to record the query in, which
+        /// must be executed on the queue the correlator was created for.
+        /// </param>
+        /// <param name="marker">The ID of the marker as returned by
+        /// <see cref="collector::register_marker" />, which is set once the
+        /// GPU reaches the query.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="list" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::logic_error">If the object has not been
+        /// created for a command queue.</exception>
+        /// <exception cref="std::length_error">If all queries are in flight,
+        /// because they have not been collected.</exception>
+        void mark(_In_ ID3D12GraphicsCommandList *list,
+            _In_ const std::uint32_t marker);
+
+        /// <summary>
+        /// Records copying the results of all queries recorded by
+        /// <see cref="mark" /> since the last call into the read-back
+        /// buffer.
+        /// </summary>
+        /// <param name="list">The command list to record the copy in, which
+        /// must be executed after the command lists containing the queries.
+        /// </param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="list" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::logic_error">If the object has not been
+        /// created for a command queue.</exception>
+        void resolve(_In_ ID3D12GraphicsCommandList *list);
+#endif /* (POWER_OVERWHELMING_GPU_ABSTRACTION == 12) */
+
+        /// <summary>
+        /// Answer whether the object has been calibrated such that GPU
+        /// timestamps can be converted.
+        /// </summary>
+        /// <returns><c>true</c> if the object has been calibrated,
+        /// <c>false</c> otherwise.</returns>
+        bool synchronised(void) const noexcept;
+
+        /// <summary>
+        /// Converts a GPU timestamp to the time of the host.
+        /// </summary>
+        /// <param name="timestamp">The GPU timestamp in ticks.</param>
+        /// <param name="resolution">The resolution of the result. The
+        /// default is the resolution expected by
+        /// <see cref="collector::marker" />.</param>
+        /// <returns>The time of the host at which the GPU clock had the
+        /// given value.</returns>
+        /// <exception cref="std::runtime_error">If the object is invalid.
+        /// </exception>
+        /// <exception cref="std::logic_error">If the object has not been
+        /// calibrated yet.</exception>
+        timestamp_type to_host(_In_ const gpu_timestamp_type timestamp,
+            _In_ const timestamp_resolution resolution
+            = timestamp_resolution::hundred_nanoseconds) const;
+
+        gpu_timestamp_correlator& operator =(
+            const gpu_timestamp_correlator&) = delete;
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        gpu_timestamp_correlator& operator =(
+            _Inout_ gpu_timestamp_correlator&& rhs) noexcept;
+
+        /// <summary>
+        /// Determines whether the object is valid.
+        /// </summary>
+        /// <returns><c>true</c> if the object knows the frequency of a GPU
+        /// clock, <c>false</c> otherwise.</returns>
+        operator bool(void) const noexcept;
+
+    private:
+
+        detail::gpu_timestamp_correlator_impl *_impl;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
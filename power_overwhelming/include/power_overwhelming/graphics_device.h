@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <cinttypes>
 #include <cstddef>
 
 //#define POWER_OVERWHELIMG_FORCE_D3D11
@@ -84,6 +85,47 @@ namespace power_overwhelming {
         /// </summary>
         typedef POWER_OVERWHALMING_NATIVE_FACTORY_TYPE factory_type;
 
+        /// <summary>
+        /// The type of the locally unique identifier of an adapter.
+        /// </summary>
+        typedef std::uint64_t luid_type;
+
+        /// <summary>
+        /// Create instances for all GPU adapters in the system without
+        /// creating a device on them.
+        /// </summary>
+        /// <remarks>
+        /// <para>Only querying the adapters is much faster than
+        /// <see cref="all" />, because the driver need not initialise a
+        /// device. The instances returned are valid and provide their
+        /// <see cref="id" />, <see cref="luid" /> and <see cref="name" />, but
+        /// they do not have a native device and can therefore not be used to
+        /// generate load or to enable the stable power state.</para>
+        /// <para>Use the <see cref="luid" /> of the adapter to obtain its
+        /// power sensor from <see cref="nvml_sensor::from_luid" /> or
+        /// <see cref="adl_sensor::from_luid" />.</para>
+        /// </remarks>
+        /// <param name="outDevices">Receives the adapters, if not
+        /// <c>nullptr</c>.</param>
+        /// <param name="cntDevices">The available space in
+        /// <paramref name="outDevices" />.</param>
+        /// <param name="onlyHardware">If <c>true</c>, which is the default,
+        /// return only hardware adapters and exclude software emulation like
+        /// WARP devices.</param>
+        /// <returns>The number of adapters available on the system, regardless
+        /// of the size of the output array. If this number is larger than
+        /// <paramref name="outDevices" />, not all adapters have been returned.
+        /// </returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="outDevices" /> is <c>nullptr</c>, but
+        /// <paramref name="cntDevices" /> is not zero.</exception>
+        /// <exception cref="std::system_error">If the adapters could not be
+        /// enumerated due to an error in the underlying APIs.</exception>
+        static std::size_t adapters(
+            _Out_writes_opt_(cntDevices) graphics_device *outDevices,
+            _In_ const std::size_t cntDevices,
+            _In_ const bool onlyHardware = true);
+
         /// <summary>
         /// Create instances for all GPUs in the device.
         /// </summary>
@@ -118,6 +160,19 @@ namespace power_overwhelming {
         /// </remarks>
         graphics_device(void) noexcept;
 
+        /// <summary>
+        /// Initialises a new instance from native handles, for instance from
+        /// the device an application renders with.
+        /// </summary>
+        /// <remarks>
+        /// The reference count of the handles is incremented.
+        /// </remarks>
+        /// <param name="adapter">The adapter of the device.</param>
+        /// <param name="device">The device, which may be <c>nullptr</c> if
+        /// only the adapter is of interest.</param>
+        graphics_device(_In_opt_ adapter_type *adapter,
+            _In_opt_ device_type *device);
+
         /// <summary>
         /// Clone <paramref name="rhs" />.
         /// </summary>
@@ -150,6 +205,19 @@ namespace power_overwhelming {
             return this->_id;
         }
 
+        /// <summary>
+        /// Gets the locally unique identifier of the adapter.
+        /// </summary>
+        /// <remarks>
+        /// The LUID identifies the adapter until the system is restarted and
+        /// is the same as reported by <c>ID3D12Device::GetAdapterLuid</c>.
+        /// </remarks>
+        /// <returns>The LUID with its high part in the upper 32 bits, or zero
+        /// if the instance is not valid.</returns>
+        /// <exception cref="std::system_error">If the description of the
+        /// adapter could not be retrieved.</exception>
+        luid_type luid(void) const;
+
         /// <summary>
         /// Gets the human-readable name of the device.
         /// </summary>
@@ -182,8 +250,12 @@ namespace power_overwhelming {
         /// <summary>
         /// Determines whether the device is valid.
         /// </summary>
-        /// <returns><c>true</c> if the device is valid, <c>false</c>
-        /// otherwise.</returns>
+        /// <remarks>
+        /// Instances obtained from <see cref="adapters" /> are valid, but do
+        /// not have a native device.
+        /// </remarks>
+        /// <returns><c>true</c> if the device refers to an adapter,
+        /// <c>false</c> otherwise.</returns>
         operator bool(void) const noexcept;
 
         /// <summary>
@@ -194,7 +266,8 @@ namespace power_overwhelming {
         /// caller wishes to keep the return value, it must increment the
         /// reference count by itself.
         /// </remarks>
-        /// <returns>The underlying native device.</returns>
+        /// <returns>The underlying native device, which is <c>nullptr</c> if
+        /// the instance only represents an adapter.</returns>
         inline _Ret_maybenull_ operator device_type *(void) noexcept {
             return this->_device;
         }
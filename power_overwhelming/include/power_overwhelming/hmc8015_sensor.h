@@ -20,6 +20,9 @@
 namespace visus {
 namespace power_overwhelming {
 
+    /* Forward declarations. */
+    namespace detail { class hmc8015_sampler; }
+
     /// <summary>
     /// Allows for controlling a Rohde &amp; Schwarz HMC8015 power analyser.
     /// </summary>
@@ -58,7 +61,7 @@ namespace power_overwhelming {
         /// <summary>
         /// Initialises a new instance.
         /// </summary>
-        inline hmc8015_sensor(void) : _name(nullptr) { }
+        inline hmc8015_sensor(void) : _name(nullptr), _sampler(nullptr) { }
 
         /// <summary>
         /// Initialises a new instance.
@@ -158,6 +161,41 @@ namespace power_overwhelming {
         /// processed successfully.</exception>
         hmc8015_sensor& display(_In_opt_z_ const wchar_t *text);
 
+        /// <summary>
+        /// Reads the energy accumulated by the integrator of the instrument.
+        /// </summary>
+        /// <remarks>
+        /// The instrument integrates the active power in hardware, which is
+        /// more accurate than integrating samples retrieved via the network.
+        /// The value is read by temporarily switching the measurement
+        /// functions of the channel to the integrated energy, which must not
+        /// happen while the sensor is sampled asynchronously.
+        /// </remarks>
+        /// <returns>The energy accumulated since the integrator has been reset
+        /// last in Joules.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it or if the response of the
+        /// instrument could not be parsed.</exception>
+        /// <exception cref="visa_exception">If the VISA command was not
+        /// processed successfully.</exception>
+        double integrated_energy(void);
+
+        /// <summary>
+        /// Enables or disables the integrator of the instrument.
+        /// </summary>
+        /// <remarks>
+        /// The integrator is enabled in manual mode, i.e. it needs to be
+        /// controlled via <see cref="start_integrator" /> and
+        /// <see cref="stop_integrator" />.
+        /// </remarks>
+        /// <param name="enable">Whether the integrator is enabled.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it.</exception>
+        /// <exception cref="visa_exception">If the VISA command was not
+        /// processed successfully.</exception>
+        hmc8015_sensor& integrator(_In_ const bool enable);
+
         /// <summary>
         /// Gets whether logging is enabled or not.
         /// </summary>
@@ -169,6 +207,17 @@ namespace power_overwhelming {
         /// processed successfully.</exception>
         bool is_log(void);
 
+        /// <summary>
+        /// Gets the interval at which the instrument logs.
+        /// </summary>
+        /// <returns>The logging interval in seconds.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it or if the response of the
+        /// instrument could not be parsed.</exception>
+        /// <exception cref="visa_exception">If the VISA command was not
+        /// processed successfully.</exception>
+        float log_interval(void);
+
         /// <summary>
         /// Enables or disables logging.
         /// </summary>
@@ -221,6 +270,29 @@ namespace power_overwhelming {
             _In_ const std::int32_t minute = 0,
             _In_ const std::int32_t second = 0);
 
+        /// <summary>
+        /// Downloads a log file from the instrument.
+        /// </summary>
+        /// <remarks>
+        /// The file is transferred as a binary block, which is read in chunks.
+        /// Logging should be disabled before the current log file is
+        /// downloaded to make sure that it is complete.
+        /// </remarks>
+        /// <param name="path">The name of the log file on the instrument.
+        /// </param>
+        /// <param name="use_usb">If <c>true</c>, the file is downloaded from a
+        /// USB drive attached to the instrument. Otherwise, it is downloaded
+        /// from the internal memory, which is the default.</param>
+        /// <returns>The content of the log file.</returns>
+        /// <exception cref="std::invalid_argument">If <paramref name="path" />
+        /// is <c>nullptr</c>.</exception>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it or if the instrument did
+        /// not send the file as binary block.</exception>
+        /// <exception cref="visa_exception">If the VISA command was not
+        /// processed successfully.</exception>
+        blob log_data(_In_z_ const char *path, _In_ const bool use_usb = false);
+
         /// <summary>
         /// Gets the path to the log file.
         /// </summary>
@@ -310,8 +382,76 @@ namespace power_overwhelming {
         /// processed successfully.</exception>
         hmc8015_sensor& reset(void);
 
+        /// <summary>
+        /// Resets the energy accumulated by the integrator to zero.
+        /// </summary>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it.</exception>
+        /// <exception cref="visa_exception">If the VISA command was not
+        /// processed successfully.</exception>
+        hmc8015_sensor& reset_integrator(void);
+
         using sensor::sample;
 
+        /// <summary>
+        /// Asynchronously sample the instrument as fast as possible, but not
+        /// faster than every <paramref name="period" /> microseconds.
+        /// </summary>
+        /// <remarks>
+        /// <para>In contrast to the generic sampler thread, each HMC8015 is
+        /// streamed on its own thread, because the sampling rate is limited by
+        /// the round trip to the instrument, which would delay all other
+        /// sensors sampled on the generic thread. The thread sends the next
+        /// query as soon as the previous response has been received and before
+        /// it is processed, and the samples are timestamped with the midpoint
+        /// of the round trip of their query. Each sample is delivered on its
+        /// own as soon as it has been received.</para>
+        /// <para>The sensor can be moved while it is being sampled. However,
+        /// the instrument must not be used for anything else while it is being
+        /// sampled asynchronously.</para>
+        /// <para>Queries that fail, for instance because the instrument does
+        /// not answer in time, are silently skipped.</para>
+        /// </remarks>
+        /// <param name="on_batch">The callback to be invoked if new data
+        /// arrived. If this is <c>nullptr</c>, the asynchronous sampling will
+        /// be disabled.</param>
+        /// <param name="period">The minimum sampling period in microseconds.
+        /// This parameter defaults to 1 millisecond.</param>
+        /// <param name="context">A user-defined context pointer that is passed
+        /// on to <see cref="on_batch" />. This parameter defaults to
+        /// <c>nullptr</c>.</para>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        /// <exception cref="std::logic_error">If the sensor is already being
+        /// sampled asynchronously.</exception>
+        virtual void sample_batch(
+            _In_opt_ const measurement_data_callback on_batch,
+            _In_ const microseconds_type period = default_sampling_period,
+            _In_opt_ void *context = nullptr) override;
+
+        /// <summary>
+        /// Starts accumulating energy in the integrator, which must have been
+        /// enabled using <see cref="integrator" />.
+        /// </summary>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it.</exception>
+        /// <exception cref="visa_exception">If the VISA command was not
+        /// processed successfully.</exception>
+        hmc8015_sensor& start_integrator(void);
+
+        /// <summary>
+        /// Stops accumulating energy in the integrator, which retains its
+        /// value until it is reset.
+        /// </summary>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it.</exception>
+        /// <exception cref="visa_exception">If the VISA command was not
+        /// processed successfully.</exception>
+        hmc8015_sensor& stop_integrator(void);
+
         /// <summary>
         /// Synchonises the date and time on the instrument with the system
         /// clock of the computer calling this API.
@@ -394,6 +534,7 @@ namespace power_overwhelming {
 
         visa_instrument _instrument;
         wchar_t *_name;
+        detail::hmc8015_sampler *_sampler;
     };
 
 } /* namespace power_overwhelming */
@@ -0,0 +1,199 @@
+﻿// <copyright file="latency_histogram.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    namespace detail {
+        class atomic_latency_histogram;
+        class latency_histogram_codec;
+    }
+
+    /// <summary>
+    /// A histogram of durations with logarithmic buckets of constant relative
+    /// precision.
+    /// </summary>
+    /// <remarks>
+    /// <para>The buckets are organised like the ones of an HDR histogram:
+    /// Durations below <see cref="sub_buckets" /> nanoseconds have a bucket
+    /// of their own. Above, each power of two is split into
+    /// <see cref="sub_buckets" /> buckets of equal width, such that the
+    /// width of a bucket is at most 1/16th of its lower bound. Durations of
+    /// 2^<see cref="max_magnitude" /> nanoseconds (more than a minute) and
+    /// more are counted in the last bucket.</para>
+    /// <para>The histogram is a value type that can be copied freely. The
+    /// sampler contexts record into a lock-free variant of it and expose
+    /// snapshots via <see cref="sampler_statistics" />.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API latency_histogram final {
+
+    public:
+
+        /// <summary>
+        /// The type of the recorded durations, which are in nanoseconds.
+        /// </summary>
+        typedef std::uint64_t value_type;
+
+        /// <summary>
+        /// The number of bits that are resolved below the most significant
+        /// bit of a duration.
+        /// </summary>
+        static constexpr unsigned int sub_bucket_bits = 4;
+
+        /// <summary>
+        /// The number of buckets per power of two.
+        /// </summary>
+        static constexpr std::size_t sub_buckets = 1 << sub_bucket_bits;
+
+        /// <summary>
+        /// The binary logarithm of the smallest duration that is not resolved
+        /// anymore.
+        /// </summary>
+        static constexpr unsigned int max_magnitude = 36;
+
+        /// <summary>
+        /// The total number of buckets.
+        /// </summary>
+        static constexpr std::size_t buckets = (max_magnitude
+            - sub_bucket_bits + 1) * sub_buckets;
+
+        /// <summary>
+        /// Answer the bucket the given duration is counted in.
+        /// </summary>
+        /// <param name="value">The duration in nanoseconds.</param>
+        /// <returns>The index of the bucket.</returns>
+        static std::size_t index_of(_In_ const value_type value) noexcept;
+
+        /// <summary>
+        /// Answer the smallest duration counted in the given bucket.
+        /// </summary>
+        /// <param name="index">The index of the bucket.</param>
+        /// <returns>The lower bound of the bucket in nanoseconds.</returns>
+        /// <exception cref="std::out_of_range">If <paramref name="index" />
+        /// is not less than <see cref="buckets" />.</exception>
+        static value_type lower_bound(_In_ const std::size_t index);
+
+        /// <summary>
+        /// Answer the largest duration counted in the given bucket.
+        /// </summary>
+        /// <param name="index">The index of the bucket.</param>
+        /// <returns>The upper bound of the bucket in nanoseconds.</returns>
+        /// <exception cref="std::out_of_range">If <paramref name="index" />
+        /// is not less than <see cref="buckets" />.</exception>
+        static value_type upper_bound(_In_ const std::size_t index);
+
+        /// <summary>
+        /// Initialises a new, empty instance.
+        /// </summary>
+        latency_histogram(void) noexcept;
+
+        /// <summary>
+        /// Answer the number of durations counted in the given bucket.
+        /// </summary>
+        /// <param name="index">The index of the bucket.</param>
+        /// <returns>The number of durations in the bucket.</returns>
+        /// <exception cref="std::out_of_range">If <paramref name="index" />
+        /// is not less than <see cref="buckets" />.</exception>
+        std::uint64_t bucket(_In_ const std::size_t index) const;
+
+        /// <summary>
+        /// Answer the number of recorded durations.
+        /// </summary>
+        /// <returns>The number of durations.</returns>
+        inline std::uint64_t count(void) const noexcept {
+            return this->_count;
+        }
+
+        /// <summary>
+        /// Answer the longest recorded duration.
+        /// </summary>
+        /// <returns>The maximum in nanoseconds, or zero if the histogram is
+        /// empty.</returns>
+        inline value_type max(void) const noexcept {
+            return this->_max;
+        }
+
+        /// <summary>
+        /// Answer the average of the recorded durations.
+        /// </summary>
+        /// <returns>The mean in nanoseconds, or zero if the histogram is
+        /// empty.</returns>
+        double mean(void) const noexcept;
+
+        /// <summary>
+        /// Adds the counts of another histogram to this one.
+        /// </summary>
+        /// <param name="other">The histogram to be added.</param>
+        /// <returns><c>*this</c>.</returns>
+        latency_histogram& merge(_In_ const latency_histogram& other) noexcept;
+
+        /// <summary>
+        /// Answer the shortest recorded duration.
+        /// </summary>
+        /// <returns>The minimum in nanoseconds, or zero if the histogram is
+        /// empty.</returns>
+        inline value_type min(void) const noexcept {
+            return (this->_count > 0) ? this->_min : 0;
+        }
+
+        /// <summary>
+        /// Answer the duration below which the given fraction of the recorded
+        /// durations lies.
+        /// </summary>
+        /// <remarks>
+        /// The result is the upper bound of the bucket containing the
+        /// requested rank, limited to the recorded minimum and maximum, ie it
+        /// overestimates the exact percentile by at most the width of the
+        /// bucket.
+        /// </remarks>
+        /// <param name="fraction">The fraction of the durations, eg 0.99 for
+        /// the 99th percentile.</param>
+        /// <returns>The percentile in nanoseconds, or zero if the histogram
+        /// is empty.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="fraction" /> is not within [0, 1].</exception>
+        value_type percentile(_In_ const double fraction) const;
+
+        /// <summary>
+        /// Counts the given duration.
+        /// </summary>
+        /// <param name="value">The duration in nanoseconds.</param>
+        void record(_In_ const value_type value) noexcept;
+
+        /// <summary>
+        /// Removes all recorded durations.
+        /// </summary>
+        void reset(void) noexcept;
+
+        /// <summary>
+        /// Answer the sum of all recorded durations.
+        /// </summary>
+        /// <returns>The sum in nanoseconds.</returns>
+        inline value_type sum(void) const noexcept {
+            return this->_sum;
+        }
+
+    private:
+
+        std::uint64_t _buckets[buckets];
+        std::uint64_t _count;
+        value_type _max;
+        value_type _min;
+        value_type _sum;
+
+        friend class detail::atomic_latency_histogram;
+        friend class detail::latency_histogram_codec;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
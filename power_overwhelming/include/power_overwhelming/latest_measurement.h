@@ -0,0 +1,125 @@
+﻿// <copyright file="latest_measurement.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "power_overwhelming/sensor.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations */
+    namespace detail { struct latest_measurement_impl; }
+
+    /// <summary>
+    /// Samples a sensor asynchronously and retains only its most recent
+    /// measurement, which can be retrieved at any time without blocking.
+    /// </summary>
+    /// <remarks>
+    /// <para>This is intended for applications like dashboards that refresh at
+    /// a rate that is independent of the sampling rate and are only interested
+    /// in the newest reading. The sampler thread of the sensor writes each
+    /// batch it delivers into a triple buffer, from which
+    /// <see cref="read" /> obtains the freshest sample without waiting,
+    /// locking or allocating memory.</para>
+    /// <para>There must be only one thread calling <see cref="read" /> at a
+    /// time. The sensor being sampled must outlive the sampling, ie the
+    /// sampling must be stopped before the sensor is destroyed.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API latest_measurement final {
+
+    public:
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <exception cref="std::bad_alloc">If the memory for the buffers
+        /// could not be allocated.</exception>
+        latest_measurement(void);
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline latest_measurement(_Inout_ latest_measurement&& rhs) noexcept
+                : _impl(rhs._impl) {
+            rhs._impl = nullptr;
+        }
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        /// <remarks>
+        /// The destructor stops the sampling if it is still running.
+        /// </remarks>
+        ~latest_measurement(void);
+
+        /// <summary>
+        /// Retrieves the most recent measurement of the sensor.
+        /// </summary>
+        /// <param name="dst">Receives the most recent measurement. If the
+        /// sensor has not delivered any sample yet, this is an invalid
+        /// <see cref="measurement_data" />.</param>
+        /// <returns><c>true</c> if <paramref name="dst" /> has been delivered
+        /// since the previous call, <c>false</c> if it is the same as the
+        /// last time or if there is none.</returns>
+        bool read(_Out_ measurement_data& dst) noexcept;
+
+        /// <summary>
+        /// Starts sampling the given sensor.
+        /// </summary>
+        /// <remarks>
+        /// The sensor is sampled via <see cref="sensor::sample_batch" />. As
+        /// the last sample of each batch is retained, the age of the value
+        /// returned by <see cref="read" /> depends on how the sensor delivers
+        /// its batches.
+        /// </remarks>
+        /// <param name="source">The sensor to be sampled.</param>
+        /// <param name="period">The desired sampling period in
+        /// microseconds.</param>
+        /// <exception cref="std::runtime_error">If the object has been moved.
+        /// </exception>
+        /// <exception cref="std::logic_error">If the object is already
+        /// sampling a sensor or if <paramref name="source" /> is already
+        /// being sampled asynchronously.</exception>
+        void start(_In_ sensor& source,
+            _In_ const sensor::microseconds_type period
+            = sensor::default_sampling_period);
+
+        /// <summary>
+        /// Stops the sampling if it is running.
+        /// </summary>
+        /// <remarks>
+        /// The most recent measurement remains available via
+        /// <see cref="read" />.
+        /// </remarks>
+        void stop(void);
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        latest_measurement& operator =(
+            _Inout_ latest_measurement&& rhs) noexcept;
+
+        /// <summary>
+        /// Determines whether the object is valid.
+        /// </summary>
+        /// <remarks>
+        /// The object is valid unless it has been disposed by a move.
+        /// </remarks>
+        /// <returns><c>true</c> if the object is valid, <c>false</c>
+        /// otherwise.</returns>
+        operator bool(void) const noexcept;
+
+    private:
+
+        detail::latest_measurement_impl *_impl;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,245 @@
+﻿// <copyright file="level_zero_sensor.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+
+#include "power_overwhelming/sensor.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations */
+    namespace detail { struct level_zero_sensor_impl; }
+
+
+    /// <summary>
+    /// Implementation of a power sensor for Intel GPUs using the energy
+    /// counters of the power domains the Level Zero Sysman API provides.
+    /// </summary>
+    /// <remarks>
+    /// <para>The Level Zero loader is loaded lazily when the first sensor is
+    /// created or enumerated. If the loader is not installed, there are no
+    /// sensors of this type.</para>
+    /// <para>All power domains of a GPU share the same device, which reads
+    /// all of their counters at once. If the sensors for the domains of a
+    /// GPU are sampled together, the driver is only queried once for all of
+    /// them.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API level_zero_sensor final : public sensor {
+
+    public:
+
+        /// <summary>
+        /// The type used to index the power domains of a device.
+        /// </summary>
+        typedef std::uint32_t domain_type;
+
+        /// <summary>
+        /// Create sensors for all power domains of all GPUs that Sysman
+        /// reports.
+        /// </summary>
+        /// <param name="out_sensors">Receives the sensors, if not
+        /// <c>nullptr</c>.</param>
+        /// <param name="cnt_sensors">The available space in
+        /// <paramref name="out_sensors" />.</param>
+        /// <returns>The number of sensors available on the system, regardless
+        /// of the size of the output array. If this number is larger than
+        /// <paramref name="cnt_sensors" />, not all sensors have been returned.
+        /// </returns>
+        static std::size_t for_all(
+            _Out_writes_opt_(cnt_sensors) level_zero_sensor *out_sensors,
+            _In_ const std::size_t cnt_sensors);
+
+        /// <summary>
+        /// Create a sensor for the specified power domain of the GPU with the
+        /// specified PCI bus ID.
+        /// </summary>
+        /// <param name="bus_id">The PCI bus ID of the GPU in the format of
+        /// sysfs, for instance &quot;0000:03:00.0&quot;.</param>
+        /// <param name="domain">The zero-based index of the power domain in
+        /// the order in which Sysman enumerates them.</param>
+        /// <returns>A new sensor for the specified power domain.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="bus_id" /> is <c>nullptr</c>, if there is no such
+        /// GPU or if the GPU does not have the requested domain.</exception>
+        /// <exception cref="std::runtime_error">If the Level Zero loader is
+        /// not available or if the Sysman API failed.</exception>
+        static level_zero_sensor for_domain(_In_z_ const char *bus_id,
+            _In_ const domain_type domain);
+
+        /// <summary>
+        /// Create a sensor for the specified power domain of the GPU with the
+        /// specified PCI bus ID.
+        /// </summary>
+        /// <param name="bus_id">The PCI bus ID of the GPU in the format of
+        /// sysfs, for instance &quot;0000:03:00.0&quot;.</param>
+        /// <param name="domain">The zero-based index of the power domain in
+        /// the order in which Sysman enumerates them.</param>
+        /// <returns>A new sensor for the specified power domain.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="bus_id" /> is <c>nullptr</c>, if there is no such
+        /// GPU or if the GPU does not have the requested domain.</exception>
+        /// <exception cref="std::runtime_error">If the Level Zero loader is
+        /// not available or if the Sysman API failed.</exception>
+        static level_zero_sensor for_domain(_In_z_ const wchar_t *bus_id,
+            _In_ const domain_type domain);
+
+        /// <summary>
+        /// Samples all of the given sensors without attaching their names to
+        /// the samples.
+        /// </summary>
+        /// <remarks>
+        /// This is the batch variant of <see cref="sample_data" />, which
+        /// enters the library only once for all sensors of the family.
+        /// </remarks>
+        /// <param name="dst">Receives <paramref name="cnt" /> samples.</param>
+        /// <param name="sensors">The sensors to be sampled.</param>
+        /// <param name="cnt">The number of sensors in
+        /// <paramref name="sensors" />.</param>
+        /// <param name="resolution">The resolution of the timestamps to be
+        /// created. This parameter defaults to
+        /// <see cref="timestamp_resolution::milliseconds" />.</param>
+        /// <exception cref="std::invalid_argument">If <paramref name="dst" />
+        /// or <paramref name="sensors" /> is <c>nullptr</c> while
+        /// <paramref name="cnt" /> is not zero.</exception>
+        /// <exception cref="std::runtime_error">If any of the sensors has been
+        /// moved (and therefore disposed).</exception>
+        static void sample_data(_Out_writes_(cnt) measurement_data *dst,
+            _In_reads_(cnt) const level_zero_sensor *sensors,
+            _In_ const std::size_t cnt,
+            _In_ const timestamp_resolution resolution
+            = timestamp_resolution::milliseconds);
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        level_zero_sensor(void);
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline level_zero_sensor(_In_ level_zero_sensor&& rhs) noexcept
+                : _impl(rhs._impl) {
+            rhs._impl = nullptr;
+        }
+
+        /// <summary>
+        /// Finalise the instance.
+        /// </summary>
+        virtual ~level_zero_sensor(void);
+
+        /// <summary>
+        /// Answer the PCI bus ID of the GPU the sensor is sampling.
+        /// </summary>
+        /// <returns>The PCI bus ID in the format of sysfs.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        _Ret_z_ const char *bus_id(void) const;
+
+        /// <summary>
+        /// Answer the index of the power domain the sensor is sampling.
+        /// </summary>
+        /// <returns>The index of the power domain.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        domain_type domain(void) const;
+
+        /// <summary>
+        /// Answer the energy in Joules the power domain has consumed since the
+        /// sensor was created.
+        /// </summary>
+        /// <returns>The consumed energy in Joules.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed or if reading the counter failed.
+        /// </exception>
+        double energy(void) const;
+
+        /// <inheritdoc />
+        virtual _Ret_maybenull_z_ const wchar_t *name(
+            void) const noexcept override;
+
+        /// <inheritdoc />
+        virtual microseconds_type native_interval(void) const override;
+
+        using sensor::sample;
+
+        /// <inheritdoc />
+        virtual void sample_adaptive(
+            _In_opt_ const measurement_data_callback on_batch,
+            _In_ const microseconds_type min_period,
+            _In_ const microseconds_type max_period,
+            _In_opt_ void *context = nullptr) override;
+
+        /// <summary>
+        /// Sample the sensor using a timestamp with the specified resolution,
+        /// but do not attach the sensor that produces the data to the sample.
+        /// </summary>
+        /// <remarks>
+        /// This method hides <see cref="sensor::sample_data" /> and provides a
+        /// fast path for code that knows the type of the sensor, because it
+        /// does not need any virtual call.
+        /// </remarks>
+        /// <param name="resolution">The resolution of the timestamp to be
+        /// created. This parameter defaults to
+        /// <see cref="timestamp_resolution::milliseconds" />.</param>
+        /// <returns>A single measurement made by the sensor.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved
+        /// (and therefore disposed).</exception>
+        measurement_data sample_data(_In_ const timestamp_resolution resolution
+            = timestamp_resolution::milliseconds) const;
+
+        /// <summary>
+        /// Asynchronously sample the sensor every
+        /// <paramref name="sampling_period "/> microseconds.
+        /// </summary>
+        /// <param name="on_measurement">The callback to be invoked if new data
+        /// arrived. If this is <c>nullptr</c>, the asynchronous sampling will
+        /// be disabled.</param>
+        /// <param name="period">The desired sampling period in
+        /// microseconds. This parameter defaults to 1 millisecond.</param>
+        /// <param name="timestamp_resolution">The resolution of the timestamps
+        /// that are generated by the sensor. This parameter defaults to
+        /// <see cref="timestamp_resolution::milliseconds" />.</param>
+        /// <param name="context">A user-defined context pointer that is passed
+        /// on to <see cref="on_measurement" />. This parameter defaults to
+        /// <c>nullptr</c>.</para>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        /// <exception cref="std::logic_error">If the sensor is already being
+        /// sampled asynchronously due to a previous call to the method.
+        /// </exception>
+        void sample(_In_opt_ const measurement_callback on_measurement,
+            _In_ const microseconds_type period = default_sampling_period,
+            _In_ const timestamp_resolution timestamp_resolution
+                = timestamp_resolution::milliseconds,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand</param>
+        /// <returns><c>*this</c></returns>
+        level_zero_sensor& operator =(_In_ level_zero_sensor&& rhs) noexcept;
+
+        /// <inheritdoc />
+        virtual operator bool(void) const noexcept override;
+
+    protected:
+
+        /// <inheritdoc />
+        measurement_data sample_sync(
+            _In_ const timestamp_resolution resolution) const override;
+
+    private:
+
+        detail::level_zero_sensor_impl *_impl;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
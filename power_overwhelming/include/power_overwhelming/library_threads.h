@@ -0,0 +1,102 @@
+﻿// <copyright file="library_threads.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+
+#include "power_overwhelming/thread_priority.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// Answer the CPU time that all threads created by the library have
+    /// consumed so far.
+    /// </summary>
+    /// <remarks>
+    /// <para>The time comprises the threads listed for
+    /// <see cref="set_library_thread_affinity" /> that are still running
+    /// and all of them that have already exited. It allows for estimating
+    /// the overhead of the measurement itself, for instance via
+    /// <see cref="collector_settings::record_overhead" />. Threads that
+    /// external APIs create on their own, like the receiver of the
+    /// Tinkerforge bindings, are not included.</para>
+    /// <para>The resolution of the time depends on the operating system. On
+    /// Windows, it is the length of the scheduler quantum.</para>
+    /// </remarks>
+    /// <returns>The sum of the user and kernel time of the library threads
+    /// in nanoseconds.</returns>
+    extern POWER_OVERWHELMING_API std::uint64_t get_library_cpu_time(
+        void) noexcept;
+
+    /// <summary>
+    /// Answer the CPU time of the individual threads of the library that are
+    /// currently running.
+    /// </summary>
+    /// <param name="out_names">Receives the debug names of up to
+    /// <paramref name="cnt" /> threads, which remain valid for the lifetime
+    /// of the library. It is safe to pass <c>nullptr</c>.</param>
+    /// <param name="out_times">Receives the CPU time of the threads in
+    /// nanoseconds. It is safe to pass <c>nullptr</c>.</param>
+    /// <param name="cnt">The number of elements that
+    /// <paramref name="out_names" /> and <paramref name="out_times" /> can
+    /// hold.</param>
+    /// <returns>The number of running library threads, which might be
+    /// larger than <paramref name="cnt" />.</returns>
+    extern POWER_OVERWHELMING_API std::size_t get_library_thread_cpu_times(
+        _Out_writes_opt_(cnt) const char **out_names,
+        _Out_writes_opt_(cnt) std::uint64_t *out_times,
+        _In_ const std::size_t cnt) noexcept;
+
+    /// <summary>
+    /// Restricts all threads that the library creates from now on to the
+    /// given set of logical CPUs.
+    /// </summary>
+    /// <remarks>
+    /// <para>The setting applies to the sampler threads, the I/O thread of
+    /// the <see cref="collector" />, the receiver of the
+    /// <see cref="time_synchroniser" /> and the dispatcher threads of
+    /// external APIs. Isolating these threads from the cores running the
+    /// workload prevents the measurement from competing with the code being
+    /// measured. Threads that are already running are not affected, so the
+    /// setting should be made before any sensor is sampled
+    /// asynchronously.</para>
+    /// <para>Threads reading machine-specific registers of a specific core
+    /// remain bound to this core regardless of this setting.</para>
+    /// <para>On Windows, all CPUs must be in the same processor group.</para>
+    /// </remarks>
+    /// <param name="logical_cpus">The indices of the logical CPUs the threads
+    /// may run on. It is safe to pass <c>nullptr</c> if
+    /// <paramref name="cnt" /> is zero.</param>
+    /// <param name="cnt">The number of CPUs in
+    /// <paramref name="logical_cpus" />, or zero to let the threads run on
+    /// any CPU.</param>
+    /// <exception cref="std::invalid_argument">If
+    /// <paramref name="logical_cpus" /> is <c>nullptr</c> while
+    /// <paramref name="cnt" /> is not zero, or if any of the CPUs does not
+    /// exist.</exception>
+    extern POWER_OVERWHELMING_API void set_library_thread_affinity(
+        _In_reads_opt_(cnt) const std::uint32_t *logical_cpus,
+        _In_ const std::size_t cnt);
+
+    /// <summary>
+    /// Sets the priority of all threads that the library creates from now
+    /// on.
+    /// </summary>
+    /// <remarks>
+    /// See <see cref="set_library_thread_affinity" /> for the threads that
+    /// are affected. If the operating system rejects the priority, for
+    /// instance for lack of privileges, the threads keep running at their
+    /// default priority.
+    /// </remarks>
+    /// <param name="priority">The priority of the library threads.</param>
+    extern POWER_OVERWHELMING_API void set_library_thread_priority(
+        _In_ const thread_priority priority) noexcept;
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,341 @@
+﻿// <copyright file="marker_channel.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else /* defined(_WIN32) */
+#include <cerrno>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif /* defined(_WIN32) */
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The magic number identifying a shared memory segment through which
+    /// other processes send markers to a collector.
+    /// </summary>
+    static constexpr char marker_channel_magic[8] = {
+        'P', 'w', 'r', 'O', 'w', 'g', 'M', 'k'
+    };
+
+    /// <summary>
+    /// The version of the layout of the marker channel.
+    /// </summary>
+    static constexpr std::uint32_t marker_channel_version = 1;
+
+    /// <summary>
+    /// The header at the begin of the marker channel.
+    /// </summary>
+    /// <remarks>
+    /// The header is followed by <see cref="capacity" /> instances of
+    /// <see cref="marker_channel_slot" />, where the capacity is a power of
+    /// two.
+    /// </remarks>
+    struct marker_channel_header final {
+
+        /// <summary>
+        /// The <see cref="marker_channel_magic" />.
+        /// </summary>
+        char magic[sizeof(marker_channel_magic)];
+
+        /// <summary>
+        /// The <see cref="marker_channel_version" />.
+        /// </summary>
+        std::uint32_t version;
+
+        /// <summary>
+        /// The number of slots following the header.
+        /// </summary>
+        std::uint32_t capacity;
+
+        /// <summary>
+        /// Non-zero while the collector is listening.
+        /// </summary>
+        std::atomic<std::uint32_t> active;
+
+        /// <summary>
+        /// Pads <see cref="head" /> to its natural alignment.
+        /// </summary>
+        std::uint32_t reserved0;
+
+        /// <summary>
+        /// The position of the next slot to be claimed by a writer.
+        /// </summary>
+        std::atomic<std::uint64_t> head;
+
+        /// <summary>
+        /// Pads the header to a cache line.
+        /// </summary>
+        std::uint8_t reserved1[32];
+    };
+
+
+    /// <summary>
+    /// A single marker in the channel.
+    /// </summary>
+    /// <remarks>
+    /// A writer claims the slot by incrementing the head, clears the
+    /// <see cref="sequence" />, fills the slot and finally stores its
+    /// position plus one as the sequence with release semantics. The
+    /// collector copies the slot and checks afterwards that the sequence is
+    /// unchanged, which detects writers lapping the collector.
+    /// </remarks>
+    struct marker_channel_slot final {
+
+        /// <summary>
+        /// The maximum length of the UTF-8 text of the marker in bytes,
+        /// including the terminating zero.
+        /// </summary>
+        static constexpr std::size_t max_text = 112;
+
+        /// <summary>
+        /// The position of the marker in the channel plus one, or zero if
+        /// the slot is being written.
+        /// </summary>
+        std::atomic<std::uint64_t> sequence;
+
+        /// <summary>
+        /// The time when the marker was set in 100 ns units since 1 January
+        /// 1601, which is the native quantity of the collector.
+        /// </summary>
+        std::atomic<std::int64_t> timestamp;
+
+        /// <summary>
+        /// The zero-terminated UTF-8 text of the marker, which is empty for
+        /// clearing the marker.
+        /// </summary>
+        char text[max_text];
+    };
+
+    static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "The marker channel requires "
+        "lock-free 64-bit atomics.");
+    static_assert(sizeof(marker_channel_header) == 64, "The header of the "
+        "marker channel must have the size of a cache line.");
+    static_assert(sizeof(marker_channel_slot) == 128, "A slot in the marker "
+        "channel must have the size of two cache lines.");
+
+    /// <summary>
+    /// Answer the size of a marker channel with the given number of slots.
+    /// </summary>
+    inline constexpr std::size_t marker_channel_size(
+            _In_ const std::size_t capacity) noexcept {
+        return sizeof(marker_channel_header)
+            + capacity * sizeof(marker_channel_slot);
+    }
+
+    /// <summary>
+    /// Answer the slots following the given header.
+    /// </summary>
+    inline marker_channel_slot *marker_channel_slots(
+            _In_ marker_channel_header *header) noexcept {
+        return reinterpret_cast<marker_channel_slot *>(header + 1);
+    }
+
+} /* namespace detail */
+
+
+    /// <summary>
+    /// Sends markers to a <see cref="collector" /> running in another
+    /// process.
+    /// </summary>
+    /// <remarks>
+    /// <para>The collector listens on a named shared memory segment if
+    /// <see cref="collector_settings::marker_channel" /> has been set. This
+    /// class is implemented in its header only, so workloads can include it
+    /// without linking against the library. Setting a marker takes the
+    /// time, claims a slot with a single atomic operation and copies the
+    /// text, ie it neither issues a system call on common platforms nor
+    /// waits for the collector.</para>
+    /// <para>The channel is a ring shared by all processes writing to it. If
+    /// the collector does not retrieve the markers fast enough, the oldest
+    /// ones are overwritten. The collector retrieves the markers once per
+    /// pass of its I/O thread, but applies them at the time they were set,
+    /// because the markers are stamped with the clock of the collector. If
+    /// the collector requires a marker, the sensors are therefore only
+    /// started once the marker has been retrieved.</para>
+    /// <para>An instance must only be used by one thread at a time, but any
+    /// number of instances in any number of processes can write to the same
+    /// channel.</para>
+    /// </remarks>
+    class marker_channel final {
+
+    public:
+
+        /// <summary>
+        /// Answer the current time in the native quantity of the collector.
+        /// </summary>
+        /// <returns>The current time in 100 ns units since 1 January 1601.
+        /// </returns>
+        static inline std::int64_t now(void) noexcept {
+#if defined(_WIN32)
+            FILETIME time;
+            ::GetSystemTimePreciseAsFileTime(&time);
+            LARGE_INTEGER retval;
+            retval.HighPart = time.dwHighDateTime;
+            retval.LowPart = time.dwLowDateTime;
+            return retval.QuadPart;
+#else /* defined(_WIN32) */
+            using namespace std::chrono;
+            typedef duration<std::int64_t, std::ratio<1, 10000000>> ticks;
+            // This is the offset of the UNIX epoch from 1 January 1601.
+            const auto dt = duration_cast<ticks>(system_clock::now()
+                - system_clock::from_time_t(0));
+            return dt.count() + 116444736000000000LL;
+#endif /* defined(_WIN32) */
+        }
+
+        /// <summary>
+        /// Initialises a new instance that is not connected to any channel.
+        /// </summary>
+        inline marker_channel(void) noexcept : _header(nullptr)
+#if defined(_WIN32)
+            , _mapping(NULL)
+#endif /* defined(_WIN32) */
+            , _size(0) { }
+
+        /// <summary>
+        /// Initialises a new instance writing to the given channel.
+        /// </summary>
+        /// <param name="name">The name of the channel as set in
+        /// <see cref="collector_settings::marker_channel" />, which must only
+        /// contain ASCII characters.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="name" /> is <c>nullptr</c> or empty.</exception>
+        /// <exception cref="std::system_error">If the channel does not exist
+        /// or could not be mapped.</exception>
+        /// <exception cref="std::runtime_error">If the channel does not have
+        /// a supported layout.</exception>
+        explicit marker_channel(_In_z_ const char *name);
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline marker_channel(_Inout_ marker_channel&& rhs) noexcept
+                : marker_channel() {
+            this->swap(rhs);
+        }
+
+        marker_channel(const marker_channel&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        inline ~marker_channel(void) {
+            this->close();
+        }
+
+        /// <summary>
+        /// Answer whether the collector is still listening on the channel.
+        /// </summary>
+        /// <returns><c>true</c> if the collector retrieves the markers,
+        /// <c>false</c> if it has stopped or the object is invalid.
+        /// </returns>
+        inline bool active(void) const noexcept {
+            return (this->_header != nullptr)
+                && (this->_header->active.load(std::memory_order_relaxed)
+                != 0);
+        }
+
+        /// <summary>
+        /// Sets the marker at the current time.
+        /// </summary>
+        /// <param name="text">The UTF-8 text of the marker, which is
+        /// truncated to <see cref="detail::marker_channel_slot::max_text" />
+        /// bytes, or <c>nullptr</c> or an empty string for clearing the
+        /// marker.</param>
+        /// <returns><c>true</c> if the marker has been sent, <c>false</c> if
+        /// the object is invalid.</returns>
+        inline bool marker(_In_opt_z_ const char *text) noexcept {
+            return this->marker(text, now());
+        }
+
+        /// <summary>
+        /// Sets the marker at the given time.
+        /// </summary>
+        /// <param name="text">The UTF-8 text of the marker, or <c>nullptr</c>
+        /// or an empty string for clearing the marker.</param>
+        /// <param name="timestamp">The time of the marker as returned by
+        /// <see cref="now" />.</param>
+        /// <returns><c>true</c> if the marker has been sent, <c>false</c> if
+        /// the object is invalid.</returns>
+        bool marker(_In_opt_z_ const char *text,
+            _In_ const std::int64_t timestamp) noexcept;
+
+        marker_channel& operator =(const marker_channel&) = delete;
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        inline marker_channel& operator =(
+                _Inout_ marker_channel&& rhs) noexcept {
+            if (this != &rhs) {
+                this->close();
+                this->swap(rhs);
+            }
+            return *this;
+        }
+
+        /// <summary>
+        /// Determines whether the object is valid.
+        /// </summary>
+        /// <returns><c>true</c> if the object is connected to a channel,
+        /// <c>false</c> otherwise.</returns>
+        inline operator bool(void) const noexcept {
+            return (this->_header != nullptr);
+        }
+
+    private:
+
+        /// <summary>
+        /// Unmaps the channel.
+        /// </summary>
+        void close(void) noexcept;
+
+        /// <summary>
+        /// Exchanges the channels of this object and <paramref name="rhs" />.
+        /// </summary>
+        inline void swap(_Inout_ marker_channel& rhs) noexcept {
+            std::swap(this->_header, rhs._header);
+#if defined(_WIN32)
+            std::swap(this->_mapping, rhs._mapping);
+#endif /* defined(_WIN32) */
+            std::swap(this->_size, rhs._size);
+        }
+
+        detail::marker_channel_header *_header;
+#if defined(_WIN32)
+        HANDLE _mapping;
+#endif /* defined(_WIN32) */
+        std::size_t _size;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+#include "power_overwhelming/marker_channel.inl"
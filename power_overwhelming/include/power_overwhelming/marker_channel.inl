@@ -0,0 +1,143 @@
+﻿// <copyright file="marker_channel.inl" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+
+/*
+ * visus::power_overwhelming::marker_channel::marker_channel
+ */
+inline visus::power_overwhelming::marker_channel::marker_channel(
+        _In_z_ const char *name) : marker_channel() {
+    if ((name == nullptr) || (*name == 0)) {
+        throw std::invalid_argument("The name of the marker channel must not "
+            "be empty.");
+    }
+
+#if defined(_WIN32)
+    this->_mapping = ::OpenFileMappingA(FILE_MAP_READ | FILE_MAP_WRITE, FALSE,
+        name);
+    if (this->_mapping == NULL) {
+        throw std::system_error(::GetLastError(), std::system_category());
+    }
+
+    // Mapping the whole object answers its size, which we need to know
+    // before we can check the header.
+    auto view = ::MapViewOfFile(this->_mapping, FILE_MAP_READ | FILE_MAP_WRITE,
+        0, 0, 0);
+    if (view == nullptr) {
+        auto error = ::GetLastError();
+        ::CloseHandle(this->_mapping);
+        this->_mapping = NULL;
+        throw std::system_error(error, std::system_category());
+    }
+
+    MEMORY_BASIC_INFORMATION info;
+    this->_size = (::VirtualQuery(view, &info, sizeof(info)) != 0)
+        ? info.RegionSize
+        : 0;
+#else /* defined(_WIN32) */
+    // POSIX requires the name of a portable shared memory object to start
+    // with a slash.
+    std::string path(name);
+    if (path.front() != '/') {
+        path.insert(path.begin(), '/');
+    }
+
+    auto handle = ::shm_open(path.c_str(), O_RDWR, 0);
+    if (handle < 0) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    struct stat info;
+    if (::fstat(handle, &info) != 0) {
+        auto error = errno;
+        ::close(handle);
+        throw std::system_error(error, std::system_category());
+    }
+
+    this->_size = static_cast<std::size_t>(info.st_size);
+    auto view = ::mmap(nullptr, this->_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED, handle, 0);
+    auto error = errno;
+    // The mapping remains valid after the descriptor has been closed.
+    ::close(handle);
+
+    if (view == MAP_FAILED) {
+        this->_size = 0;
+        throw std::system_error(error, std::system_category());
+    }
+#endif /* defined(_WIN32) */
+
+    this->_header = static_cast<detail::marker_channel_header *>(view);
+
+    const auto valid = (this->_size >= sizeof(detail::marker_channel_header))
+        && (std::memcmp(this->_header->magic, detail::marker_channel_magic,
+            sizeof(detail::marker_channel_magic)) == 0)
+        && (this->_header->version == detail::marker_channel_version)
+        && (this->_header->capacity > 0)
+        && ((this->_header->capacity & (this->_header->capacity - 1)) == 0)
+        && (this->_size >= detail::marker_channel_size(
+            this->_header->capacity));
+    if (!valid) {
+        this->close();
+        throw std::runtime_error("The shared memory segment is not a marker "
+            "channel of a compatible version.");
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::marker_channel::marker
+ */
+inline bool visus::power_overwhelming::marker_channel::marker(
+        _In_opt_z_ const char *text,
+        _In_ const std::int64_t timestamp) noexcept {
+    typedef detail::marker_channel_slot slot_type;
+
+    if (this->_header == nullptr) {
+        return false;
+    }
+
+    const auto pos = this->_header->head.fetch_add(1,
+        std::memory_order_relaxed);
+    const auto mask = static_cast<std::uint64_t>(this->_header->capacity) - 1;
+    auto& slot = detail::marker_channel_slots(this->_header)[pos & mask];
+
+    // Mark the slot as busy before any of its content changes, such that the
+    // collector cannot mistake a partially written slot for the old one.
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.timestamp.store(timestamp, std::memory_order_relaxed);
+
+    std::size_t len = 0;
+    if (text != nullptr) {
+        while ((len < slot_type::max_text - 1) && (text[len] != 0)) {
+            ++len;
+        }
+        std::memcpy(slot.text, text, len);
+    }
+    slot.text[len] = 0;
+
+    slot.sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::marker_channel::close
+ */
+inline void visus::power_overwhelming::marker_channel::close(void) noexcept {
+    if (this->_header != nullptr) {
+#if defined(_WIN32)
+        ::UnmapViewOfFile(this->_header);
+        ::CloseHandle(this->_mapping);
+        this->_mapping = NULL;
+#else /* defined(_WIN32) */
+        ::munmap(this->_header, this->_size);
+#endif /* defined(_WIN32) */
+        this->_header = nullptr;
+        this->_size = 0;
+    }
+}
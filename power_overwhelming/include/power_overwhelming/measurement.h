@@ -101,10 +101,12 @@ namespace power_overwhelming {
         /// Clone <paramref name="rhs" />.
         /// </summary>
         /// <param name="rhs">The object to be cloned.</param>
-        inline measurement(_In_ const measurement& rhs)
-                : _data(rhs._data),  _sensor(nullptr) {
-            this->set_sensor(rhs._sensor);
-        }
+        /// <remarks>
+        /// Cloning a measurement is cheap, because the name of the sensor is
+        /// interned and therefore does not need to be copied.
+        /// </remarks>
+        inline measurement(_In_ const measurement& rhs) noexcept
+            : _data(rhs._data),  _sensor(rhs._sensor) { }
 
         /// <summary>
         /// Move <paramref name="rhs" /> to a new object.
@@ -208,7 +210,7 @@ namespace power_overwhelming {
         void set_sensor(_In_z_ const char_type *sensor);
 
         measurement_data _data;
-        char_type *_sensor;
+        const char_type *_sensor;
     };
 
 
@@ -0,0 +1,345 @@
+﻿// <copyright file="measurement_batch.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+
+#include "power_overwhelming/measurement_data.h"
+#include "power_overwhelming/measurement_quantity.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// A batch of samples of a single sensor, which stores the timestamps and
+    /// each of the quantities in separate arrays.
+    /// </summary>
+    /// <remarks>
+    /// <para>In contrast to an array of <see cref="measurement_data" />,
+    /// the structure-of-arrays layout allows for processing each of the
+    /// quantities with SIMD instructions. The arrays of timestamps and values
+    /// are aligned to <see cref="alignment" /> bytes.</para>
+    /// <para>Quantities that have not been measured are stored as
+    /// <see cref="measurement_data::invalid_value" />. In addition, the batch
+    /// maintains a bit mask for each of the quantities, in which the bits of
+    /// the valid samples are set. The first sample is represented by the
+    /// least significant bit of the first word.</para>
+    /// <para>The power is always complete: If a sample only contains voltage
+    /// and current, the power is derived from them when the sample is added
+    /// to the batch rather than each time it is accessed.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API measurement_batch final {
+
+    public:
+
+        /// <summary>
+        /// The type of a word in the validity masks.
+        /// </summary>
+        typedef std::uint64_t mask_type;
+
+        /// <summary>
+        /// The type of a timestamp.
+        /// </summary>
+        typedef measurement_data::timestamp_type timestamp_type;
+
+        /// <summary>
+        /// The type of current, voltage and power.
+        /// </summary>
+        typedef measurement_data::value_type value_type;
+
+        /// <summary>
+        /// The alignment of the arrays in bytes.
+        /// </summary>
+        static constexpr std::size_t alignment = 64;
+
+        /// <summary>
+        /// The number of samples represented by a word of the validity masks.
+        /// </summary>
+        static constexpr std::size_t mask_bits = 8 * sizeof(mask_type);
+
+        /// <summary>
+        /// Initialises a new, empty instance.
+        /// </summary>
+        measurement_batch(void) noexcept;
+
+        /// <summary>
+        /// Initialises a new, empty instance that can hold at least
+        /// <paramref name="capacity" /> samples without reallocating.
+        /// </summary>
+        /// <param name="capacity">The number of samples to reserve space for.
+        /// </param>
+        /// <exception cref="std::bad_alloc">If the memory could not be
+        /// allocated.</exception>
+        explicit measurement_batch(_In_ const std::size_t capacity);
+
+        /// <summary>
+        /// Clone <paramref name="rhs" />.
+        /// </summary>
+        /// <param name="rhs">The object to be cloned.</param>
+        /// <exception cref="std::bad_alloc">If the memory could not be
+        /// allocated.</exception>
+        measurement_batch(_In_ const measurement_batch& rhs);
+
+        /// <summary>
+        /// Move <paramref name="rhs" />.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        measurement_batch(_Inout_ measurement_batch&& rhs) noexcept;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~measurement_batch(void);
+
+        /// <summary>
+        /// Replaces the content of the batch with the given samples.
+        /// </summary>
+        /// <remarks>
+        /// The samples are transposed into the arrays of the batch, and the
+        /// missing power of all of them is computed at once.
+        /// </remarks>
+        /// <param name="samples">The samples to be copied. This parameter
+        /// may be <c>nullptr</c> if <paramref name="cnt" /> is zero.</param>
+        /// <param name="cnt">The number of samples.</param>
+        /// <exception cref="std::bad_alloc">If the memory could not be
+        /// allocated.</exception>
+        void assign(_In_reads_(cnt) const measurement_data *samples,
+            _In_ const std::size_t cnt);
+
+        /// <summary>
+        /// Answer the number of samples the batch can hold without
+        /// reallocating.
+        /// </summary>
+        /// <returns>The capacity of the batch.</returns>
+        inline std::size_t capacity(void) const noexcept {
+            return this->_capacity;
+        }
+
+        /// <summary>
+        /// Removes all samples from the batch, but retains the memory.
+        /// </summary>
+        void clear(void) noexcept;
+
+        /// <summary>
+        /// Answer the number of samples for which the given quantity is
+        /// valid.
+        /// </summary>
+        /// <param name="quantity">The quantity to be checked.</param>
+        /// <returns>The number of valid samples.</returns>
+        std::size_t count(_In_ const measurement_quantity quantity)
+            const noexcept;
+
+        /// <summary>
+        /// Answer whether the batch contains no samples.
+        /// </summary>
+        /// <returns><c>true</c> if the batch is empty, <c>false</c>
+        /// otherwise.</returns>
+        inline bool empty(void) const noexcept {
+            return (this->_size == 0);
+        }
+
+        /// <summary>
+        /// Determines the smallest and the largest valid value of the given
+        /// quantity.
+        /// </summary>
+        /// <param name="minimum">Receives the smallest value. The variable is
+        /// not modified if there is no valid value.</param>
+        /// <param name="maximum">Receives the largest value. The variable is
+        /// not modified if there is no valid value.</param>
+        /// <param name="quantity">The quantity to be evaluated.</param>
+        /// <returns><c>true</c> if the batch contains at least one valid
+        /// value, <c>false</c> otherwise.</returns>
+        bool min_max(_Out_ value_type& minimum, _Out_ value_type& maximum,
+            _In_ const measurement_quantity quantity) const noexcept;
+
+        /// <summary>
+        /// Appends a single sample to the batch.
+        /// </summary>
+        /// <param name="sample">The sample to be added.</param>
+        /// <exception cref="std::bad_alloc">If the memory could not be
+        /// allocated.</exception>
+        void push_back(_In_ const measurement_data& sample);
+
+        /// <summary>
+        /// Makes sure that the batch can hold at least
+        /// <paramref name="capacity" /> samples without reallocating.
+        /// </summary>
+        /// <param name="capacity">The number of samples to reserve space for.
+        /// </param>
+        /// <exception cref="std::bad_alloc">If the memory could not be
+        /// allocated.</exception>
+        void reserve(_In_ const std::size_t capacity);
+
+        /// <summary>
+        /// Answer the number of samples in the batch.
+        /// </summary>
+        /// <returns>The number of samples.</returns>
+        inline std::size_t size(void) const noexcept {
+            return this->_size;
+        }
+
+        /// <summary>
+        /// Computes the sum of all valid values of the given quantity.
+        /// </summary>
+        /// <param name="quantity">The quantity to be evaluated.</param>
+        /// <returns>The sum of all valid values, which is zero if there are
+        /// none.</returns>
+        double sum(_In_ const measurement_quantity quantity) const noexcept;
+
+        /// <summary>
+        /// Answer whether the given quantity of the specified sample is valid.
+        /// </summary>
+        /// <param name="index">The index of the sample, which must be less
+        /// than <see cref="size" />.</param>
+        /// <param name="quantity">The quantity to be checked.</param>
+        /// <returns><c>true</c> if the quantity has been measured or derived,
+        /// <c>false</c> otherwise.</returns>
+        bool valid(_In_ const std::size_t index,
+            _In_ const measurement_quantity quantity) const noexcept;
+
+        /// <summary>
+        /// Gets the validity mask of the given quantity.
+        /// </summary>
+        /// <param name="quantity">The quantity to get the mask for.</param>
+        /// <returns>The mask holding one bit per sample. The pointer may be
+        /// <c>nullptr</c> if the batch has not yet allocated any memory.
+        /// </returns>
+        _Ret_maybenull_ const mask_type *mask(
+            _In_ const measurement_quantity quantity) const noexcept;
+
+        /// <summary>
+        /// Gets the values of the given quantity.
+        /// </summary>
+        /// <param name="quantity">The quantity to get the values for.</param>
+        /// <returns>The array of <see cref="size" /> values. The pointer may
+        /// be <c>nullptr</c> if the batch has not yet allocated any memory.
+        /// </returns>
+        _Ret_maybenull_ const value_type *values(
+            _In_ const measurement_quantity quantity) const noexcept;
+
+        /// <summary>
+        /// Gets the timestamps of the samples.
+        /// </summary>
+        /// <returns>The array of <see cref="size" /> timestamps. The pointer
+        /// may be <c>nullptr</c> if the batch has not yet allocated any
+        /// memory.</returns>
+        inline _Ret_maybenull_ const timestamp_type *timestamps(
+                void) const noexcept {
+            return this->_timestamps;
+        }
+
+        /// <summary>
+        /// Assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        measurement_batch& operator =(_In_ const measurement_batch& rhs);
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        measurement_batch& operator =(
+            _Inout_ measurement_batch&& rhs) noexcept;
+
+        /// <summary>
+        /// Reconstructs the sample at the given index.
+        /// </summary>
+        /// <param name="index">The index of the sample, which must be less
+        /// than <see cref="size" />.</param>
+        /// <returns>The sample at the given location.</returns>
+        measurement_data operator [](_In_ const std::size_t index)
+            const noexcept;
+
+    private:
+
+        /// <summary>
+        /// The number of quantities stored in the batch.
+        /// </summary>
+        static constexpr std::size_t quantities = 3;
+
+        /// <summary>
+        /// Answer the index of the array and the mask of
+        /// <paramref name="quantity" />.
+        /// </summary>
+        static std::size_t index_of(
+            _In_ const measurement_quantity quantity) noexcept;
+
+        void *_block;
+        std::size_t _capacity;
+        mask_type *_masks[quantities];
+        std::size_t _size;
+        timestamp_type *_timestamps;
+        value_type *_values[quantities];
+    };
+
+
+    /// <summary>
+    /// A callback for batches of samples in a
+    /// <see cref="measurement_batch" />.
+    /// </summary>
+    /// <remarks>
+    /// The same rules as for <see cref="measurement_data_callback" /> apply:
+    /// The name of the sensor is interned and the batch is only valid during
+    /// the call.
+    /// </remarks>
+    typedef void (*measurement_batch_callback)(_In_z_ const wchar_t *sensor,
+        _In_ const measurement_batch& batch,
+        _In_opt_ void *context);
+
+
+    /// <summary>
+    /// Delivers the samples of the asynchronous sampling of a sensor as
+    /// <see cref="measurement_batch" /> to a
+    /// <see cref="measurement_batch_callback" />.
+    /// </summary>
+    /// <remarks>
+    /// <para>Pass <see cref="on_batch" /> as callback and the adapter as
+    /// context to <see cref="sensor::sample_batch" /> or
+    /// <see cref="sensor::sample_all" />. The adapter must live until the
+    /// sensors have been stopped. It can be shared by multiple sensors.</para>
+    /// <para>Each sampler thread transposes into its own batch, which is
+    /// reused for all subsequent batches of the thread, such that the
+    /// adapter does not allocate memory once the sampling has been running
+    /// for a while.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API measurement_batch_adapter final {
+
+    public:
+
+        /// <summary>
+        /// The <see cref="measurement_data_callback" /> that transposes the
+        /// samples and forwards them to the adapter passed as
+        /// <paramref name="context" />.
+        /// </summary>
+        static void on_batch(_In_z_ const wchar_t *sensor,
+            _In_reads_(cnt) const measurement_data *samples,
+            _In_ const std::size_t cnt,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="callback">The callback receiving the batches.</param>
+        /// <param name="context">A user-defined context pointer that is passed
+        /// on to <paramref name="callback" />.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="callback" /> is <c>nullptr</c>.</exception>
+        measurement_batch_adapter(
+            _In_ const measurement_batch_callback callback,
+            _In_opt_ void *context = nullptr);
+
+    private:
+
+        measurement_batch_callback _callback;
+        void *_context;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
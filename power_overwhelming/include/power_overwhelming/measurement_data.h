@@ -6,6 +6,7 @@
 #pragma once
 
 #include <cinttypes>
+#include <cstddef>
 #include <utility>
 
 #include "power_overwhelming/power_overwhelming_api.h"
@@ -14,6 +15,9 @@
 namespace visus {
 namespace power_overwhelming {
 
+    /* Forward declarations */
+    class measurement_batch;
+
     /// <summary>
     /// Container for the raw measurement data of a single sample for current,
     ///  voltage and power.
@@ -27,6 +31,11 @@ namespace power_overwhelming {
 
     public:
 
+        /// <summary>
+        /// The type of the sequence number of a sample.
+        /// </summary>
+        typedef std::uint32_t sequence_type;
+
         /// <summary>
         /// The type of a timestamp associated with a measurement.
         /// </summary>
@@ -126,6 +135,33 @@ namespace power_overwhelming {
                 : this->_current * this->_voltage;
         }
 
+        /// <summary>
+        /// Gets the per-sensor sequence number of the sample.
+        /// </summary>
+        /// <remarks>
+        /// Samplers number the samples of each sensor consecutively starting
+        /// with one, such that a consumer can detect samples that have been
+        /// lost on their way. Readings that failed consume a number, too.
+        /// Zero indicates that the sample has not been numbered.
+        /// </remarks>
+        /// <returns>The sequence number, or zero if the sample is not
+        /// numbered.</returns>
+        inline sequence_type sequence(void) const noexcept {
+            return this->_sequence;
+        }
+
+        /// <summary>
+        /// Sets the per-sensor sequence number of the sample.
+        /// </summary>
+        /// <param name="sequence">The sequence number, or zero if the sample
+        /// is not numbered.</param>
+        /// <returns><c>*this</c>.</returns>
+        inline measurement_data& sequence(
+                _In_ const sequence_type sequence) noexcept {
+            this->_sequence = sequence;
+            return *this;
+        }
+
         /// <summary>
         /// Gets the timestamp of the measurement.
         /// </summary>
@@ -173,7 +209,32 @@ namespace power_overwhelming {
         value_type _power;
         timestamp_type _timestamp;
         value_type _voltage;
+        sequence_type _sequence;
+
+        friend class measurement_batch;
     };
 
+
+    /// <summary>
+    /// A callback for batches of <see cref="measurement_data" /> that are
+    /// received asynchronously.
+    /// </summary>
+    /// <remarks>
+    /// <para>In contrast to <see cref="measurement_callback" />, this callback
+    /// is invoked for a contiguous array of samples from the same sensor, which
+    /// amortises the cost of the indirect call and any locking the callee
+    /// needs to perform over the whole batch.</para>
+    /// <para>The first parameter is the name of the sensor that produced the
+    /// samples. The name is interned, i.e. the pointer is the same for all
+    /// batches of a sensor and remains valid until the process exits. It can
+    /// therefore be used as an identifier of the sensor.</para>
+    /// <para>The samples are only valid during the call. Callees must copy
+    /// them if they need them afterwards.</para>
+    /// </remarks>
+    typedef void (*measurement_data_callback)(_In_z_ const wchar_t *sensor,
+        _In_reads_(cnt) const measurement_data *samples,
+        _In_ const std::size_t cnt,
+        _In_opt_ void *context);
+
 } /* namespace power_overwhelming */
 } /* namespace visus */
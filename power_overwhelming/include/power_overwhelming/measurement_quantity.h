@@ -0,0 +1,47 @@
+﻿// <copyright file="measurement_quantity.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// The quantities measured by a sensor, of which the electrical ones are
+    /// stored in a <see cref="measurement_batch" />.
+    /// </summary>
+    enum class measurement_quantity {
+
+        /// <summary>
+        /// The electric current in Amperes.
+        /// </summary>
+        current,
+
+        /// <summary>
+        /// The electric power in Watts.
+        /// </summary>
+        power,
+
+        /// <summary>
+        /// The electric potential in Volts.
+        /// </summary>
+        voltage,
+
+        /// <summary>
+        /// A quantity that is not electrical, for instance an energy counter,
+        /// a clock rate or a utilisation, whose unit is given by the
+        /// <see cref="sensor_channel" /> reporting it.
+        /// </summary>
+        /// <remarks>
+        /// Such values are delivered in the power slot of a
+        /// <see cref="measurement_data" />. A <see cref="measurement_batch" />
+        /// only holds the electrical quantities.
+        /// </remarks>
+        other,
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,159 @@
+﻿// <copyright file="metrics_exporter.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+
+#include "power_overwhelming/sensor.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations */
+    namespace detail { struct metrics_exporter_impl; }
+
+    /// <summary>
+    /// An embedded HTTP server that exposes the latest readings and the
+    /// accumulated energy of sensors in the OpenMetrics text format, which
+    /// can be scraped by Prometheus.
+    /// </summary>
+    /// <remarks>
+    /// <para>The sensors are sampled asynchronously, and each batch they
+    /// deliver is integrated into the energy of the sensor and published via
+    /// a triple buffer like in <see cref="latest_measurement" />. A scrape
+    /// therefore never reads the hardware, but only renders the most recent
+    /// values into a buffer that has been allocated when the exporter was
+    /// started.</para>
+    /// <para>For each sensor, the exporter provides the gauges
+    /// <c>pwrowg_power_watts</c>, <c>pwrowg_voltage_volts</c> and
+    /// <c>pwrowg_current_amperes</c>, if the respective quantity is measured,
+    /// and the counter <c>pwrowg_energy_joules</c>, with the name of the
+    /// sensor as label <c>sensor</c>. The energy is the trapezoidal integral
+    /// of the power samples since the sensor has been added, which is exact
+    /// for sensors deriving their power from energy counters like RAPL, EMI
+    /// or NVML in energy mode.</para>
+    /// <para>The server handles one request at a time on a dedicated thread
+    /// and answers to <c>GET /metrics</c> only. The sensors must outlive the
+    /// exporter, or the exporter must be stopped before they are destroyed.
+    /// </para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API metrics_exporter final {
+
+    public:
+
+        /// <summary>
+        /// The default TCP port, which is the one registered for the
+        /// Prometheus exporter of OpenTelemetry.
+        /// </summary>
+        static constexpr std::uint16_t default_port = 9464;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <exception cref="std::bad_alloc">If the state of the exporter
+        /// could not be allocated.</exception>
+        metrics_exporter(void);
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline metrics_exporter(_Inout_ metrics_exporter&& rhs) noexcept
+                : _impl(rhs._impl) {
+            rhs._impl = nullptr;
+        }
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        /// <remarks>
+        /// The destructor stops the server and the sampling of all sensors.
+        /// </remarks>
+        ~metrics_exporter(void);
+
+        /// <summary>
+        /// Starts sampling the given sensor and adds its metrics to the
+        /// output.
+        /// </summary>
+        /// <param name="source">The sensor to be sampled.</param>
+        /// <param name="period">The desired sampling period in
+        /// microseconds.</param>
+        /// <exception cref="std::runtime_error">If the object has been moved.
+        /// </exception>
+        /// <exception cref="std::logic_error">If the server is already
+        /// running or if <paramref name="source" /> is already being sampled
+        /// asynchronously.</exception>
+        void add(_In_ sensor& source,
+            _In_ const sensor::microseconds_type period
+            = sensor::default_sampling_period);
+
+        /// <summary>
+        /// Renders the current metrics into the given buffer.
+        /// </summary>
+        /// <remarks>
+        /// <para>This method does not allocate any memory. It is what the
+        /// server uses to answer a scrape and is provided for applications
+        /// that want to deliver the metrics by other means.</para>
+        /// <para>The method must not be called while the server is running,
+        /// because the triple buffers only support a single reader.</para>
+        /// </remarks>
+        /// <param name="dst">The buffer to receive the UTF-8 text, which is
+        /// not zero-terminated. It is safe to pass <c>nullptr</c> to measure
+        /// the required size.</param>
+        /// <param name="cnt">The size of <paramref name="dst" /> in bytes.
+        /// </param>
+        /// <returns>The size of the whole text in bytes. If this is larger
+        /// than <paramref name="cnt" />, the text has been truncated.
+        /// </returns>
+        std::size_t render(_Out_writes_opt_(cnt) char *dst,
+            _In_ const std::size_t cnt) const noexcept;
+
+        /// <summary>
+        /// Starts serving the metrics.
+        /// </summary>
+        /// <param name="port">The TCP port to listen on.</param>
+        /// <param name="address">The local address to bind to, or
+        /// <c>nullptr</c> for all interfaces.</param>
+        /// <exception cref="std::runtime_error">If the object has been moved.
+        /// </exception>
+        /// <exception cref="std::logic_error">If the server is already
+        /// running.</exception>
+        /// <exception cref="std::system_error">If the socket could not be
+        /// bound.</exception>
+        void start(_In_ const std::uint16_t port = default_port,
+            _In_opt_z_ const wchar_t *address = nullptr);
+
+        /// <summary>
+        /// Stops the server and the sampling of all sensors, which are
+        /// removed from the exporter.
+        /// </summary>
+        void stop(void) noexcept;
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        metrics_exporter& operator =(_Inout_ metrics_exporter&& rhs) noexcept;
+
+        /// <summary>
+        /// Determines whether the object is valid.
+        /// </summary>
+        /// <remarks>
+        /// The object is valid unless it has been disposed by a move.
+        /// </remarks>
+        /// <returns><c>true</c> if the object is valid, <c>false</c>
+        /// otherwise.</returns>
+        operator bool(void) const noexcept;
+
+    private:
+
+        detail::metrics_exporter_impl *_impl;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,96 @@
+﻿// <copyright file="msr_channel.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// Additional machine-specific registers that an <see cref="msr_sensor" />
+    /// can read along with the energy counter of its RAPL domain.
+    /// </summary>
+    /// <remarks>
+    /// <para>The channels allow for interpreting the power of the domain, for
+    /// instance by computing the effective frequency from the ratio of the
+    /// increments of <see cref="msr_channel::aperf" /> and
+    /// <see cref="msr_channel::mperf" /> or by detecting that the package has
+    /// been throttled.</para>
+    /// <para>Implementation note: If new elements are added to this
+    /// enumeration, they must also be added in the implementation of
+    /// <see cref="to_string" /> and <see cref="parse_msr_channel" />.</para>
+    /// </remarks>
+    enum class msr_channel {
+
+        /// <summary>
+        /// The number of actual clock cycles of the logical CPU while it has
+        /// been in C0 (IA32_APERF).
+        /// </summary>
+        aperf,
+
+        /// <summary>
+        /// The number of clock cycles at the reference frequency of the
+        /// logical CPU while it has been in C0 (IA32_MPERF).
+        /// </summary>
+        mperf,
+
+        /// <summary>
+        /// The thermal status of the package, including the current distance
+        /// to the thermal limit and whether the power limit has been hit
+        /// (IA32_PACKAGE_THERM_STATUS).
+        /// </summary>
+        package_thermal_status,
+
+        /// <summary>
+        /// The time in seconds the package has been throttled by RAPL
+        /// (MSR_PKG_PERF_STATUS).
+        /// </summary>
+        package_throttling,
+
+        /// <summary>
+        /// The time in seconds the cores have been throttled by RAPL
+        /// (MSR_PP0_PERF_STATUS).
+        /// </summary>
+        pp0_throttling,
+
+        /// <summary>
+        /// The time in seconds the DRAM has been throttled by RAPL
+        /// (MSR_DRAM_PERF_STATUS).
+        /// </summary>
+        dram_throttling,
+
+        /// <summary>
+        /// The reasons why the frequency of the cores is currently limited
+        /// (MSR_CORE_PERF_LIMIT_REASONS).
+        /// </summary>
+        core_limit_reasons
+    };
+
+
+    /// <summary>
+    /// Parses a string into a value of the <see cref="msr_channel" />
+    /// enumeration.
+    /// </summary>
+    /// <param name="str">The string to be parsed.</param>
+    /// <returns>The value represented by the string.</returns>
+    /// <exception cref="std::invalid_argument">If <paramref name="str" /> is
+    /// either <c>nullptr</c> or if it does not represent a valid channel.
+    /// </exception>
+    extern POWER_OVERWHELMING_API msr_channel parse_msr_channel(
+        _In_z_ const wchar_t *str);
+
+    /// <summary>
+    /// Convert the given channel to a human-readable string representation.
+    /// </summary>
+    /// <param name="channel">The channel to be converted.</param>
+    /// <returns>The name of the channel.</returns>
+    extern POWER_OVERWHELMING_API _Ret_z_ const wchar_t *to_string(
+        _In_ const msr_channel channel);
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,88 @@
+﻿// <copyright file="msr_channel_sample.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "power_overwhelming/measurement_data.h"
+#include "power_overwhelming/msr_channel.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// The value of an additional <see cref="msr_channel" /> that has been read
+    /// along with a sample of an <see cref="msr_sensor" />.
+    /// </summary>
+    class POWER_OVERWHELMING_API msr_channel_sample final {
+
+    public:
+
+        /// <summary>
+        /// The type used to store timestamps.
+        /// </summary>
+        typedef measurement_data::timestamp_type timestamp_type;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="timestamp">The timestamp of the power sample the
+        /// channel has been read with.</param>
+        /// <param name="channel">The channel that has been read.</param>
+        /// <param name="value">The value of the channel, which is the
+        /// increment since the previous sample for counters and the content
+        /// of the register for status registers.</param>
+        inline msr_channel_sample(_In_ const timestamp_type timestamp,
+                _In_ const msr_channel channel,
+                _In_ const double value) noexcept
+            : _channel(channel), _timestamp(timestamp), _value(value) { }
+
+        /// <summary>
+        /// Initialises a new instance without a value.
+        /// </summary>
+        inline msr_channel_sample(void) noexcept
+            : msr_channel_sample(0, msr_channel::aperf, 0.0) { }
+
+        /// <summary>
+        /// Answer the channel that has been read.
+        /// </summary>
+        /// <returns>The channel.</returns>
+        inline msr_channel channel(void) const noexcept {
+            return this->_channel;
+        }
+
+        /// <summary>
+        /// Answer the timestamp of the sample.
+        /// </summary>
+        /// <returns>The timestamp in the resolution the sensor has been
+        /// sampled with.</returns>
+        inline timestamp_type timestamp(void) const noexcept {
+            return this->_timestamp;
+        }
+
+        /// <summary>
+        /// Answer the value of the channel.
+        /// </summary>
+        /// <remarks>
+        /// For <see cref="msr_channel::aperf" /> and
+        /// <see cref="msr_channel::mperf" />, this is the number of cycles
+        /// since the previous sample, for the throttling counters, it is the
+        /// time in seconds since the previous sample and for the status
+        /// registers, it is the raw content of the register.
+        /// </remarks>
+        /// <returns>The value of the channel.</returns>
+        inline double value(void) const noexcept {
+            return this->_value;
+        }
+
+    private:
+
+        msr_channel _channel;
+        timestamp_type _timestamp;
+        double _value;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -7,6 +7,7 @@
 
 #include <ios>
 
+#include "power_overwhelming/msr_channel_sample.h"
 #include "power_overwhelming/rapl_domain.h"
 #include "power_overwhelming/rapl_quantity.h"
 #include "power_overwhelming/sensor.h"
@@ -16,6 +17,7 @@ namespace visus {
 namespace power_overwhelming {
 
     /* Forward declarations */
+    namespace detail { struct energy_meter_impl; }
     namespace detail { struct msr_sensor_impl; }
     namespace detail { template<class T> struct sensor_desc; }
 
@@ -80,8 +82,11 @@ namespace power_overwhelming {
         /// <c>nullptr</c>.</param>
         /// <param name="cnt_sensors">The available space in
         /// <paramref name="out_sensors" />.</param>
-        /// <param name="reserved">Reserved for future use. Must be
-        /// <c>false</c>.</param>
+        /// <param name="consider_topology">If <c>true</c>, which is the
+        /// default, only one sensor is created for each RAPL register that is
+        /// shared by multiple logical CPUs, e.g. only one sensor per package for
+        /// the package domain. Otherwise, a sensor is created for every logical
+        /// CPU and every RAPL domain.</param>
         /// <returns>The number of sensors available on the system, regardless
         /// of the size of the output array. If this number is larger than
         /// <paramref name="cntSensors" />, not all sensors have been returned.
@@ -91,7 +96,7 @@ namespace power_overwhelming {
         static std::size_t for_all(
             _Out_writes_opt_(cnt_sensors) msr_sensor *out_sensors,
             _In_ const std::size_t cnt_sensors,
-            _In_ const bool reserved = false);
+            _In_ const bool consider_topology = true);
 
         /// <summary>
         /// Create an MSR sensor for the specified core and RAPL domain.
@@ -109,6 +114,32 @@ namespace power_overwhelming {
         static msr_sensor for_core(_In_ const core_type core,
             _In_ const rapl_domain domain);
 
+        /// <summary>
+        /// Samples all of the given sensors without attaching their names to
+        /// the samples.
+        /// </summary>
+        /// <remarks>
+        /// This is the batch variant of <see cref="sample_data" />, which
+        /// enters the library only once for all sensors of the family.
+        /// </remarks>
+        /// <param name="dst">Receives <paramref name="cnt" /> samples.</param>
+        /// <param name="sensors">The sensors to be sampled.</param>
+        /// <param name="cnt">The number of sensors in
+        /// <paramref name="sensors" />.</param>
+        /// <param name="resolution">The resolution of the timestamps to be
+        /// created. This parameter defaults to
+        /// <see cref="timestamp_resolution::milliseconds" />.</param>
+        /// <exception cref="std::invalid_argument">If <paramref name="dst" />
+        /// or <paramref name="sensors" /> is <c>nullptr</c> while
+        /// <paramref name="cnt" /> is not zero.</exception>
+        /// <exception cref="std::runtime_error">If any of the sensors has been
+        /// moved (and therefore disposed).</exception>
+        static void sample_data(_Out_writes_(cnt) measurement_data *dst,
+            _In_reads_(cnt) const msr_sensor *sensors,
+            _In_ const std::size_t cnt,
+            _In_ const timestamp_resolution resolution
+            = timestamp_resolution::milliseconds);
+
         /// <summary>
         /// Initialises a new instance.
         /// </summary>
@@ -127,6 +158,70 @@ namespace power_overwhelming {
         /// </summary>
         virtual ~msr_sensor(void);
 
+        /// <summary>
+        /// Answer whether the given additional channel is read along with the
+        /// energy counter.
+        /// </summary>
+        /// <param name="channel">The channel to be checked.</param>
+        /// <returns><c>true</c> if the channel is enabled, <c>false</c>
+        /// otherwise.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        bool channel(_In_ const msr_channel channel) const;
+
+        /// <summary>
+        /// Enables or disables reading an additional channel along with the
+        /// energy counter.
+        /// </summary>
+        /// <remarks>
+        /// <para>The registers of the enabled channels are read in the same
+        /// request as the energy counter, both in synchronous and in
+        /// asynchronous sampling. In asynchronous sampling, the sampler reads
+        /// each register that is shared by multiple sensors, e.g. the package
+        /// thermal status, only once per tick like the energy counters. This
+        /// requires no additional system calls or inter-processor interrupts
+        /// for cores that are read anyway.</para>
+        /// <para>The values of the channels can be retrieved via
+        /// <see cref="channel_samples" />.</para>
+        /// </remarks>
+        /// <param name="channel">The channel to be changed.</param>
+        /// <param name="enabled"><c>true</c> for reading the channel,
+        /// <c>false</c> for not reading it.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        /// <exception cref="std::invalid_argument">If the channel is being
+        /// enabled, but the CPU core of the sensor does not provide its
+        /// register.</exception>
+        /// <exception cref="std::logic_error">If the sensor is being sampled
+        /// asynchronously.</exception>
+        msr_sensor& channel(_In_ const msr_channel channel,
+            _In_ const bool enabled);
+
+        /// <summary>
+        /// Retrieves the values of the additional channels that have been read
+        /// since the previous call.
+        /// </summary>
+        /// <remarks>
+        /// Counters produce a value from the second sample on, which is the
+        /// increment since the previous sample. Status registers produce their
+        /// content with every sample. All values read in the same sample have
+        /// the timestamp of the power sample.
+        /// </remarks>
+        /// <param name="dst">The buffer to receive the oldest samples, which
+        /// are removed from the sensor. If this is <c>nullptr</c>, the number
+        /// of available samples is returned.</param>
+        /// <param name="cnt">The number of elements that
+        /// <paramref name="dst" /> can hold.</param>
+        /// <returns>The number of samples written to <paramref name="dst" />,
+        /// or the number of available samples if <paramref name="dst" /> is
+        /// <c>nullptr</c>.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        std::size_t channel_samples(
+            _Out_writes_opt_(cnt) msr_channel_sample *dst,
+            _In_ const std::size_t cnt);
+
         /// <summary>
         /// Answer the core the sensor is sampling.
         /// </summary>
@@ -143,6 +238,26 @@ namespace power_overwhelming {
         /// sensor that has been disposed.</exception>
         rapl_domain domain(void) const;
 
+        /// <summary>
+        /// Answer the energy in Joules the RAPL domain has consumed since the
+        /// sensor was created.
+        /// </summary>
+        /// <remarks>
+        /// <para>In contrast to <see cref="read" />, the value is accumulated
+        /// in 64 bits by the sensor and therefore does not wrap like the
+        /// register. This allows callers to obtain the total energy of a run
+        /// without integrating the power samples.</para>
+        /// <para>The RAPL registers wrap every few minutes under high load.
+        /// The result is only correct if the sensor is sampled at least once
+        /// per wrap period, either synchronously or asynchronously.</para>
+        /// </remarks>
+        /// <returns>The accumulated energy in Joules.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        /// <exception cref="std::system_error">If reading the MSR file failed.
+        /// </exception>
+        double energy(void) const;
+
         /// <summary>
         /// Reads the raw sensor data and applies the unit transformation such
         /// that the return value is in Joules (accumulated since an undefined
@@ -155,8 +270,42 @@ namespace power_overwhelming {
         virtual _Ret_maybenull_z_ const wchar_t *name(
             void) const noexcept override;
 
+        /// <summary>
+        /// Answer the interval at which the processor updates the RAPL energy
+        /// counters, which is approximately one millisecond.
+        /// </summary>
+        /// <returns>The update interval in microseconds.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        virtual microseconds_type native_interval(void) const override;
+
         using sensor::sample;
 
+        /// <inheritdoc />
+        virtual void sample_adaptive(
+            _In_opt_ const measurement_data_callback on_batch,
+            _In_ const microseconds_type min_period,
+            _In_ const microseconds_type max_period,
+            _In_opt_ void *context = nullptr) override;
+
+        /// <summary>
+        /// Sample the sensor using a timestamp with the specified resolution,
+        /// but do not attach the sensor that produces the data to the sample.
+        /// </summary>
+        /// <remarks>
+        /// This method hides <see cref="sensor::sample_data" /> and provides a
+        /// fast path for code that knows the type of the sensor, because it
+        /// does not need any virtual call.
+        /// </remarks>
+        /// <param name="resolution">The resolution of the timestamp to be
+        /// created. This parameter defaults to
+        /// <see cref="timestamp_resolution::milliseconds" />.</param>
+        /// <returns>A single measurement made by the sensor.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved
+        /// (and therefore disposed).</exception>
+        measurement_data sample_data(_In_ const timestamp_resolution resolution
+            = timestamp_resolution::milliseconds) const;
+
         /// <summary>
         /// Asynchronously sample the sensor every
         /// <paramref name="sampling_period "/> microseconds.
@@ -205,6 +354,7 @@ namespace power_overwhelming {
 
         detail::msr_sensor_impl *_impl;
 
+        friend struct detail::energy_meter_impl;
         friend struct detail::msr_sensor_impl;
         template<class T> friend struct detail::sensor_desc;
     };
@@ -0,0 +1,202 @@
+﻿// <copyright file="multi_channel_sensor.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+
+#include "power_overwhelming/sensor.h"
+#include "power_overwhelming/sensor_channel.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations */
+    namespace detail { class multi_channel_sampler; }
+
+    /// <summary>
+    /// The interface of sensors that obtain several values with a single
+    /// read, for instance multiple sensor IDs of ADL PMLog, multiple
+    /// channels of an EMI device or multiple RAPL domains.
+    /// </summary>
+    /// <remarks>
+    /// <para>Such sensors describe their values as
+    /// <see cref="sensor_channel" />s and deliver one timestamp and one value
+    /// for each channel per read, which saves the reads, the timestamps and
+    /// the metadata that separate sensors for each value would require.</para>
+    /// <para>A multi-channel sensor can be used wherever a <see cref="sensor" />
+    /// is expected. In this case, <see cref="sample_batch" /> delivers each
+    /// read as one sample per channel, which has the name of the channel and
+    /// the timestamp of the read, such that a <see cref="collector" /> records
+    /// each channel like a separate sensor while reading the device only
+    /// once.</para>
+    /// <para>Implementations must stop the asynchronous sampling by calling
+    /// <see cref="sample_channels" /> with <c>nullptr</c> in their
+    /// destructors, because the sampler thread uses the virtual methods of
+    /// the sensor.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API multi_channel_sensor : public sensor {
+
+    public:
+
+        /// <summary>
+        /// The type of the timestamps of the reads.
+        /// </summary>
+        typedef measurement_data::timestamp_type timestamp_type;
+
+        /// <summary>
+        /// The type of the values of the channels.
+        /// </summary>
+        typedef measurement_data::value_type value_type;
+
+        /// <summary>
+        /// The callback receiving reads of all channels.
+        /// </summary>
+        /// <remarks>
+        /// <paramref name="values" /> holds <c>source.channels()</c> values
+        /// for each of the <paramref name="cnt" /> timestamps, such that the
+        /// value of channel <c>c</c> in read <c>r</c> is at
+        /// <c>values[r * source.channels() + c]</c>. The data are only valid
+        /// while the callback is running.
+        /// </remarks>
+        typedef void (*channel_callback)(
+            _In_ const multi_channel_sensor& source,
+            _In_reads_(cnt) const timestamp_type *timestamps,
+            _In_reads_(cnt * source.channels()) const value_type *values,
+            _In_ const std::size_t cnt,
+            _In_opt_ void *context);
+
+        multi_channel_sensor(const multi_channel_sensor&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        virtual ~multi_channel_sensor(void);
+
+        /// <summary>
+        /// Answer the description of the channel at the given index.
+        /// </summary>
+        /// <param name="index">The index of the channel.</param>
+        /// <returns>The description of the channel.</returns>
+        /// <exception cref="std::out_of_range">If <paramref name="index" />
+        /// is not less than <see cref="channels" />.</exception>
+        virtual sensor_channel channel(_In_ const std::size_t index) const = 0;
+
+        /// <summary>
+        /// Answer the number of values obtained with each read.
+        /// </summary>
+        /// <returns>The number of channels.</returns>
+        virtual std::size_t channels(void) const noexcept = 0;
+
+        /// <summary>
+        /// Reads all channels once.
+        /// </summary>
+        /// <param name="dst">Receives the values of the channels.</param>
+        /// <param name="cnt">The number of elements that can be written to
+        /// <paramref name="dst" />, which must be at least
+        /// <see cref="channels" />.</param>
+        /// <param name="resolution">The resolution of the timestamp.</param>
+        /// <returns>The timestamp of the read.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="dst" /> is <c>nullptr</c> or too small.</exception>
+        /// <exception cref="std::runtime_error">If the sensor has been
+        /// disposed.</exception>
+        timestamp_type sample_channels(_Out_writes_(cnt) value_type *dst,
+            _In_ const std::size_t cnt,
+            _In_ const timestamp_resolution resolution
+            = timestamp_resolution::milliseconds) const;
+
+        /// <summary>
+        /// Starts or stops reading all channels periodically on a sampler
+        /// thread.
+        /// </summary>
+        /// <param name="on_batch">The callback receiving the reads, or
+        /// <c>nullptr</c> to stop sampling.</param>
+        /// <param name="period">The interval between two reads in
+        /// microseconds.</param>
+        /// <param name="context">A user-defined pointer passed to the
+        /// callback.</param>
+        /// <exception cref="std::runtime_error">If the sensor has been
+        /// disposed.</exception>
+        /// <exception cref="std::logic_error">If the sensor is already being
+        /// sampled.</exception>
+        void sample_channels(_In_opt_ const channel_callback on_batch,
+            _In_ const microseconds_type period = default_sampling_period,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Starts or stops reading all channels periodically on a sampler
+        /// thread and delivers each read as one sample per channel.
+        /// </summary>
+        /// <param name="on_batch">The callback receiving the samples, or
+        /// <c>nullptr</c> to stop sampling.</param>
+        /// <param name="period">The interval between two reads in
+        /// microseconds.</param>
+        /// <param name="context">A user-defined pointer passed to the
+        /// callback.</param>
+        /// <exception cref="std::runtime_error">If the sensor has been
+        /// disposed.</exception>
+        /// <exception cref="std::logic_error">If the sensor is already being
+        /// sampled.</exception>
+        void sample_batch(_In_opt_ const measurement_data_callback on_batch,
+            _In_ const microseconds_type period = default_sampling_period,
+            _In_opt_ void *context = nullptr) override;
+
+        multi_channel_sensor& operator =(const multi_channel_sensor&) = delete;
+
+    protected:
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        multi_channel_sensor(void) noexcept;
+
+        /// <summary>
+        /// Initialises a new instance for a moved sensor.
+        /// </summary>
+        /// <remarks>
+        /// The asynchronous sampling is bound to the object and therefore not
+        /// moved.
+        /// </remarks>
+        inline multi_channel_sensor(_Inout_ multi_channel_sensor&& rhs) noexcept
+            : _sampler(nullptr) { }
+
+        /// <summary>
+        /// Reads all channels once.
+        /// </summary>
+        /// <param name="dst">Receives <see cref="channels" /> values.</param>
+        /// <param name="resolution">The resolution of the timestamp.</param>
+        /// <returns>The timestamp of the read.</returns>
+        virtual timestamp_type sample_channels_sync(
+            _Out_writes_(channels()) value_type *dst,
+            _In_ const timestamp_resolution resolution) const = 0;
+
+        /// <summary>
+        /// Reads all channels and answers the value of the first one.
+        /// </summary>
+        /// <param name="resolution">The resolution of the timestamp.</param>
+        /// <returns>The sample of the first channel.</returns>
+        measurement_data sample_sync(
+            _In_ const timestamp_resolution resolution) const override;
+
+        /// <summary>
+        /// Move assignment, which does not move the asynchronous sampling.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        inline multi_channel_sensor& operator =(
+                _Inout_ multi_channel_sensor&& rhs) noexcept {
+            return *this;
+        }
+
+    private:
+
+        detail::multi_channel_sampler *_sampler;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,60 @@
+﻿// <copyright file="nvml_quantity.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// Possible quantities that an <see cref="nvml_sensor" /> retrieves along
+    /// with each sample.
+    /// </summary>
+    enum class nvml_quantity {
+
+        /// <summary>
+        /// The total energy the GPU has consumed since the driver was loaded
+        /// in Joules.
+        /// </summary>
+        energy,
+
+        /// <summary>
+        /// The temperature of the GPU memory in degrees Celsius.
+        /// </summary>
+        memory_temperature,
+
+        /// <summary>
+        /// The instantaneous power draw of the GPU in Watts.
+        /// </summary>
+        power,
+
+        /// <summary>
+        /// The fraction of time within [0, 1] during which a kernel was
+        /// executing on the GPU, which is only retrieved in estimation mode.
+        /// </summary>
+        gpu_utilisation,
+
+        /// <summary>
+        /// The fraction of time within [0, 1] during which the GPU memory was
+        /// read or written, which is only retrieved in estimation mode.
+        /// </summary>
+        memory_utilisation,
+
+        /// <summary>
+        /// The graphics clock in Hertz, which is only retrieved in estimation
+        /// mode.
+        /// </summary>
+        graphics_clock,
+
+        /// <summary>
+        /// The memory clock in Hertz, which is only retrieved in estimation
+        /// mode.
+        /// </summary>
+        memory_clock,
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -5,6 +5,10 @@
 
 #pragma once
 
+#include "power_overwhelming/nvml_quantity.h"
+#include "power_overwhelming/power_estimate.h"
+#include "power_overwhelming/power_governor.h"
+#include "power_overwhelming/process_energy.h"
 #include "power_overwhelming/sensor.h"
 
 
@@ -92,6 +96,27 @@ namespace power_overwhelming {
         /// found, is not unique or another error occurred in NVML.</exception>
         static nvml_sensor from_index(_In_ const unsigned int index);
 
+        /// <summary>
+        /// Create a new instance for the device with the specified locally
+        /// unique identifier of its DXGI adapter.
+        /// </summary>
+        /// <remarks>
+        /// The adapter is matched to the NVML device via its location on the
+        /// PCI bus, which is only supported on Windows.
+        /// </remarks>
+        /// <param name="luid">The LUID of the adapter as returned by
+        /// <see cref="graphics_device::luid" />.</param>
+        /// <returns></returns>
+        /// <exception cref="std::invalid_argument">If the adapter is not an
+        /// NVIDIA device.</exception>
+        /// <exception cref="std::runtime_error">If the adapter could not be
+        /// found.</exception>
+        /// <exception cref="std::logic_error">If the platform does not
+        /// support LUIDs.</exception>
+        /// <exception cref="nvml_exception">If the device could not be
+        /// opened.</exception>
+        static nvml_sensor from_luid(_In_ const std::uint64_t luid);
+
         /// <summary>
         /// Create a new instance for a specific device serial number printed on
         /// the board.
@@ -112,6 +137,32 @@ namespace power_overwhelming {
         /// found, is not unique or another error occurred in NVML.</exception>
         static nvml_sensor from_serial(_In_z_ const wchar_t *serial);
 
+        /// <summary>
+        /// Samples all of the given sensors without attaching their names to
+        /// the samples.
+        /// </summary>
+        /// <remarks>
+        /// This is the batch variant of <see cref="sample_data" />, which
+        /// enters the library only once for all sensors of the family.
+        /// </remarks>
+        /// <param name="dst">Receives <paramref name="cnt" /> samples.</param>
+        /// <param name="sensors">The sensors to be sampled.</param>
+        /// <param name="cnt">The number of sensors in
+        /// <paramref name="sensors" />.</param>
+        /// <param name="resolution">The resolution of the timestamps to be
+        /// created. This parameter defaults to
+        /// <see cref="timestamp_resolution::milliseconds" />.</param>
+        /// <exception cref="std::invalid_argument">If <paramref name="dst" />
+        /// or <paramref name="sensors" /> is <c>nullptr</c> while
+        /// <paramref name="cnt" /> is not zero.</exception>
+        /// <exception cref="std::runtime_error">If any of the sensors has been
+        /// moved (and therefore disposed).</exception>
+        static void sample_data(_Out_writes_(cnt) measurement_data *dst,
+            _In_reads_(cnt) const nvml_sensor *sensors,
+            _In_ const std::size_t cnt,
+            _In_ const timestamp_resolution resolution
+            = timestamp_resolution::milliseconds);
+
         /// <summary>
         /// Initialises a new instance.
         /// </summary>
@@ -136,6 +187,52 @@ namespace power_overwhelming {
         /// </summary>
         virtual ~nvml_sensor(void);
 
+        /// <summary>
+        /// Answer the power limit at which the <see cref="governor" /> has
+        /// observed the best performance per Watt so far.
+        /// </summary>
+        /// <returns>The best power limit in Watts, or NaN if the governor
+        /// does not search the best efficiency.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        double best_power_limit(void) const;
+
+        /// <summary>
+        /// Answer whether asynchronous batches are obtained from the sample
+        /// buffer of the driver.
+        /// </summary>
+        /// <returns><c>true</c> if the buffered mode is enabled, <c>false</c>
+        /// otherwise.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        bool buffered_mode(void) const;
+
+        /// <summary>
+        /// Enables or disables the buffered mode of the sensor.
+        /// </summary>
+        /// <remarks>
+        /// <para>The driver records the power of the GPU at its own rate and
+        /// keeps the most recent samples in a buffer. In buffered mode,
+        /// <see cref="sample_batch" /> drains this buffer every
+        /// <c>period</c> and delivers all samples recorded since the previous
+        /// batch with the timestamps when they have been recorded, which
+        /// yields more samples at a lower cost than polling the current power.
+        /// The period should therefore be between 20 and 100 ms, i.e. shorter
+        /// than the time the buffer covers.</para>
+        /// <para>The mode only takes effect the next time batch sampling is
+        /// started. <see cref="sample" /> and <see cref="sample_sync" /> are
+        /// not affected.</para>
+        /// </remarks>
+        /// <param name="enabled"><c>true</c> for enabling the buffered mode,
+        /// <c>false</c> for polling the power.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        /// <exception cref="nvml_exception">If the buffered mode is being
+        /// enabled, but the driver does not support retrieving the buffered
+        /// samples.</exception>
+        nvml_sensor& buffered_mode(_In_ const bool enabled);
+
         /// <summary>
         /// Gets the GUID NVIDIA uses to uniquely identify the device the sensor
         /// is for.
@@ -143,6 +240,150 @@ namespace power_overwhelming {
         /// <returns>The GUID of the device.</returns>
         _Ret_maybenull_z_ const char *device_guid(void) const noexcept;
 
+        /// <summary>
+        /// Reads the total energy the GPU has consumed since the driver was
+        /// loaded.
+        /// </summary>
+        /// <remarks>
+        /// In contrast to <see cref="value" />, this method always queries the
+        /// driver. The counter has 64 bits and therefore does not wrap in
+        /// practice.
+        /// </remarks>
+        /// <returns>The energy in Joules.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        /// <exception cref="nvml_exception">If the device does not support
+        /// the energy counter, which is only available on Volta and newer.
+        /// </exception>
+        double energy(void) const;
+
+        /// <summary>
+        /// Answer whether the sensor derives the power from the energy counter
+        /// of the GPU.
+        /// </summary>
+        /// <returns><c>true</c> if the energy mode is enabled, <c>false</c>
+        /// otherwise.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        bool energy_mode(void) const;
+
+        /// <summary>
+        /// Enables or disables the energy mode of the sensor.
+        /// </summary>
+        /// <remarks>
+        /// <para>By default, the sensor reports the power reading of NVML,
+        /// which NVML averages internally at its own update rate. In energy
+        /// mode, the sensor reads the total energy counter of the GPU on each
+        /// sample and reports the average power since the previous sample
+        /// instead, which is the same approach the <see cref="msr_sensor" />
+        /// and the <see cref="emi_sensor" /> use. This yields correct energy
+        /// figures even at low sampling rates.</para>
+        /// <para>The energy counter is only available on Volta and newer
+        /// GPUs.</para>
+        /// </remarks>
+        /// <param name="enabled"><c>true</c> for enabling the energy mode,
+        /// <c>false</c> for using the power reading.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        /// <exception cref="nvml_exception">If the energy mode is being
+        /// enabled, but the device does not support the energy counter.
+        /// </exception>
+        nvml_sensor& energy_mode(_In_ const bool enabled);
+
+        /// <summary>
+        /// Retrieves the power estimates that have been produced in
+        /// estimation mode since the previous call.
+        /// </summary>
+        /// <param name="dst">The buffer to receive the oldest estimates,
+        /// which are removed from the sensor. If this is <c>nullptr</c>, the
+        /// number of available estimates is returned.</param>
+        /// <param name="cnt">The number of elements that
+        /// <paramref name="dst" /> can hold.</param>
+        /// <returns>The number of estimates written to
+        /// <paramref name="dst" />, or the number of available estimates if
+        /// <paramref name="dst" /> is <c>nullptr</c>.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        std::size_t estimates(_Out_writes_opt_(cnt) power_estimate *dst,
+            _In_ const std::size_t cnt);
+
+        /// <summary>
+        /// Answer whether the sensor estimates the power from the utilisation
+        /// and the clocks of the GPU.
+        /// </summary>
+        /// <returns><c>true</c> if the estimation mode is enabled,
+        /// <c>false</c> otherwise.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        bool estimation_mode(void) const;
+
+        /// <summary>
+        /// Enables or disables the estimation mode of the sensor.
+        /// </summary>
+        /// <remarks>
+        /// <para>NVML updates the power reading at a much lower rate than the
+        /// utilisation and the clocks of the GPU change. In estimation mode,
+        /// the sensor retrieves the utilisation of the GPU and its memory and
+        /// the graphics and memory clocks along with each sample and fits a
+        /// linear model of the power to them online whenever NVML publishes a
+        /// new power reading. Once the model has converged, every sample
+        /// produces a <see cref="power_estimate" /> with a 95 % confidence
+        /// interval, which can be retrieved via <see cref="estimates" />. The
+        /// measured power is not affected.</para>
+        /// <para>The estimates are produced by <see cref="sample" />,
+        /// <see cref="sample_sync" /> and by asynchronous sampling unless the
+        /// <see cref="buffered_mode" /> is enabled. The queries for the
+        /// utilisation and the clocks increase the time required for a
+        /// sample.</para>
+        /// </remarks>
+        /// <param name="enabled"><c>true</c> for enabling the estimation
+        /// mode, <c>false</c> for disabling it.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        /// <exception cref="nvml_exception">If the estimation mode is being
+        /// enabled, but the device cannot report its utilisation or clocks.
+        /// </exception>
+        nvml_sensor& estimation_mode(_In_ const bool enabled);
+
+        /// <summary>
+        /// Gets the governor that adjusts the power limit of the GPU.
+        /// </summary>
+        /// <returns>The active governor, which is
+        /// <see cref="power_governor_mode::none" /> if the power limit is not
+        /// being changed.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        power_governor governor(void) const;
+
+        /// <summary>
+        /// Installs a governor that adjusts the power limit of the GPU while
+        /// the sensor is being sampled.
+        /// </summary>
+        /// <remarks>
+        /// <para>The governor is clocked by the samples of the sensor, i.e.
+        /// it only makes progress while the sensor is sampled either
+        /// asynchronously, including the <see cref="buffered_mode" />, or
+        /// synchronously. The performance callback of the governor is
+        /// invoked on the thread obtaining the sample.</para>
+        /// <para>Changing the power limit requires administrative
+        /// privileges. The limit that was active before the first governor
+        /// was installed is restored when the governor is removed or the
+        /// sensor is destroyed.</para>
+        /// </remarks>
+        /// <param name="governor">The governor to be installed, which
+        /// replaces any previous one. Pass a default-constructed governor for
+        /// removing the current one.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        /// <exception cref="std::invalid_argument">If the limits of the
+        /// governor are outside the range the device supports.</exception>
+        /// <exception cref="nvml_exception">If the power limit could not be
+        /// retrieved or changed.</exception>
+        nvml_sensor& governor(_In_ const power_governor& governor);
+
         /// <summary>
         /// Gets the name of the sensor.
         /// </summary>
@@ -151,12 +392,119 @@ namespace power_overwhelming {
         virtual _Ret_maybenull_z_ const wchar_t *name(
             void) const noexcept override;
 
+        /// <summary>
+        /// Answer the interval at which the driver updates the power reading.
+        /// </summary>
+        /// <remarks>
+        /// NVML does not document the update rate, which varies between 10
+        /// and 100 Hz depending on the board. The interval is therefore
+        /// determined empirically by watching the power reading change when
+        /// the method is first called, which may take up to a second.
+        /// </remarks>
+        /// <returns>The update interval in microseconds, or zero if it could
+        /// not be determined.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        virtual microseconds_type native_interval(void) const override;
+
+        /// <summary>
+        /// Retrieves the power limit of the GPU.
+        /// </summary>
+        /// <returns>The current power limit in Watts.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        /// <exception cref="nvml_exception">If the power limit could not be
+        /// retrieved.</exception>
+        double power_limit(void) const;
+
+        /// <summary>
+        /// Retrieves the energy that has been attributed to each process in
+        /// <see cref="process_energy_mode" /> since the mode was enabled.
+        /// </summary>
+        /// <param name="dst">The buffer to receive the energies ordered by
+        /// process ID. If this is <c>nullptr</c>, the number of processes is
+        /// returned.</param>
+        /// <param name="cnt">The number of elements that
+        /// <paramref name="dst" /> can hold.</param>
+        /// <returns>The number of energies written to
+        /// <paramref name="dst" />, or the number of available energies if
+        /// <paramref name="dst" /> is <c>nullptr</c>.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        std::size_t process_energies(_Out_writes_opt_(cnt) process_energy *dst,
+            _In_ const std::size_t cnt) const;
+
+        /// <summary>
+        /// Answer whether the sensor attributes the energy of the GPU to the
+        /// processes using it.
+        /// </summary>
+        /// <returns><c>true</c> if the process energy mode is enabled,
+        /// <c>false</c> otherwise.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        bool process_energy_mode(void) const;
+
+        /// <summary>
+        /// Enables or disables the attribution of the energy of the GPU to
+        /// the processes using it.
+        /// </summary>
+        /// <remarks>
+        /// <para>In process energy mode, each sample additionally retrieves
+        /// the utilisation of the GPU per process in a single call to the
+        /// driver. The energy of the board since the previous sample is split
+        /// between the processes according to the sum of their SM and memory
+        /// utilisation. The driver updates the utilisation per process less
+        /// frequently than the power, so the most recent shares are applied
+        /// until new ones become available. Energy consumed while no process
+        /// is using the GPU is attributed to
+        /// <see cref="process_energy::idle" />.</para>
+        /// <para>In <see cref="buffered_mode" />, the utilisation is
+        /// retrieved once per batch. The attribution is most accurate in
+        /// <see cref="energy_mode" />, because the power is then the average
+        /// since the previous sample.</para>
+        /// <para>Enabling the mode discards the energies attributed before.
+        /// </para>
+        /// </remarks>
+        /// <param name="enabled"><c>true</c> for enabling the process energy
+        /// mode, <c>false</c> for disabling it.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        /// <exception cref="nvml_exception">If the mode is being enabled, but
+        /// the driver or the device cannot report the utilisation per
+        /// process.</exception>
+        nvml_sensor& process_energy_mode(_In_ const bool enabled);
+
         using sensor::sample;
 
+        /// <summary>
+        /// Sample the sensor using a timestamp with the specified resolution,
+        /// but do not attach the sensor that produces the data to the sample.
+        /// </summary>
+        /// <remarks>
+        /// This method hides <see cref="sensor::sample_data" /> and provides a
+        /// fast path for code that knows the type of the sensor, because it
+        /// does not need any virtual call.
+        /// </remarks>
+        /// <param name="resolution">The resolution of the timestamp to be
+        /// created. This parameter defaults to
+        /// <see cref="timestamp_resolution::milliseconds" />.</param>
+        /// <returns>A single measurement made by the sensor.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved
+        /// (and therefore disposed).</exception>
+        measurement_data sample_data(_In_ const timestamp_resolution resolution
+            = timestamp_resolution::milliseconds) const;
+
         /// <summary>
         /// Asynchronously sample the sensor every
         /// <paramref name="sampling_period "/> microseconds.
         /// </summary>
+        /// <remarks>
+        /// All GPUs are queried in parallel. If a GPU does not answer within
+        /// the sampling period, the callback receives an invalid
+        /// <see cref="measurement" /> for this period instead of delaying the
+        /// other GPUs.
+        /// </remarks>
         /// <param name="on_measurement">The callback to be invoked if new data
         /// arrived. If this is <c>nullptr</c>, the asynchronous sampling will
         /// be disabled.</param>
@@ -176,6 +524,64 @@ namespace power_overwhelming {
             _In_ const microseconds_type period = default_sampling_period,
             _In_opt_ void *context = nullptr);
 
+        /// <summary>
+        /// Asynchronously sample the sensor every
+        /// <paramref name="sampling_period "/> microseconds and deliver the
+        /// samples in batches.
+        /// </summary>
+        /// <remarks>
+        /// <para>In contrast to <see cref="sample" />, the samples are not
+        /// delivered one-by-one, but the sampler thread collects a batch of
+        /// samples and delivers them at once. This reduces the overhead per
+        /// sample at the cost of delivering the samples with a latency of up
+        /// to ten milliseconds. Any samples that have not yet been delivered
+        /// when the sampling is stopped are delivered on the thread disabling
+        /// the asynchronous sampling.</para>
+        /// </remarks>
+        /// <param name="on_batch">The callback to be invoked if new data
+        /// arrived. If this is <c>nullptr</c>, the asynchronous sampling will
+        /// be disabled.</param>
+        /// <param name="period">The desired sampling period in
+        /// microseconds. This parameter defaults to 1 millisecond.</param>
+        /// <param name="context">A user-defined context pointer that is passed
+        /// on to <see cref="on_batch" />. This parameter defaults to
+        /// <c>nullptr</c>.</para>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        /// <exception cref="std::logic_error">If the sensor is already being
+        /// sampled asynchronously due to a previous call to the method or to
+        /// <see cref="sample" />.</exception>
+        virtual void sample_batch(
+            _In_opt_ const measurement_data_callback on_batch,
+            _In_ const microseconds_type period = default_sampling_period,
+            _In_opt_ void *context = nullptr) override;
+
+        /// <summary>
+        /// Answer the value of the given quantity that has been retrieved along
+        /// with the most recent sample.
+        /// </summary>
+        /// <remarks>
+        /// <para>If the driver supports <c>nvmlDeviceGetFieldValues</c>, the
+        /// sensor retrieves the power and all other quantities in a single
+        /// call whenever it is sampled, either synchronously or by the
+        /// asynchronous sampler. This method does not issue any call to the
+        /// driver, but returns the value cached from the last sample.</para>
+        /// <para>The energy is the total energy of the GPU since the driver
+        /// was loaded, so callers do not need to integrate the power in order
+        /// to obtain the energy of a run.</para>
+        /// <para>The utilisation and the clocks are only retrieved in
+        /// <see cref="estimation_mode" />.</para>
+        /// </remarks>
+        /// <param name="quantity">The quantity to retrieve.</param>
+        /// <returns>The value of the quantity in SI units or degrees Celsius,
+        /// or NaN if the quantity is not supported by the device or the
+        /// sensor has not yet been sampled.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="quantity" /> is not a valid quantity.</exception>
+        double value(_In_ const nvml_quantity quantity) const;
+
         /// <summary>
         /// Move assignment.
         /// </summary>
@@ -0,0 +1,139 @@
+﻿// <copyright file="oscilloscope_acquisition_plan.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+
+#include "power_overwhelming/oscilloscope_decimation_mode.h"
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// Plans the time base, the record length and the decimation of an
+    /// oscilloscope capture such that the waveforms are as small as possible
+    /// while still providing the requested sample rate.
+    /// </summary>
+    /// <remarks>
+    /// <para>The planner rounds the requested duration up to the next time
+    /// range the instrument supports, ie ten divisions of a time scale from
+    /// the 1-2-5 sequence, and chooses the shortest record length that covers
+    /// the time range with at least the requested sample rate. If the
+    /// resulting rate of waveform points is lower than the rate of the
+    /// analogue-digital converter, the instrument must decimate the samples.
+    /// In this case, the planner chooses high-resolution decimation, which
+    /// averages the samples and thereby acts as an anti-aliasing filter, or
+    /// peak detection if short transients must be preserved.</para>
+    /// <para>The plan is computed for the Rohde &amp; Schwarz RTB2000
+    /// series. Apply it to an instrument via <see cref="rtx_instrument::plan" />.
+    /// </para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API oscilloscope_acquisition_plan final {
+
+    public:
+
+        /// <summary>
+        /// The maximum sample rate of the analogue-digital converter per
+        /// channel if multiple channels are active.
+        /// </summary>
+        static constexpr float max_sample_rate = 1.25e9f;
+
+        /// <summary>
+        /// The largest record length the instrument supports.
+        /// </summary>
+        static constexpr unsigned int max_points = 20000000;
+
+        /// <summary>
+        /// The smallest record length the instrument supports.
+        /// </summary>
+        static constexpr unsigned int min_points = 10000;
+
+        /// <summary>
+        /// Plans a capture.
+        /// </summary>
+        /// <param name="duration">The minimum duration of the capture in
+        /// seconds.</param>
+        /// <param name="sample_rate">The minimum effective sample rate of the
+        /// waveforms in samples per second.</param>
+        /// <param name="peaks">If <c>true</c>, decimate using peak detection
+        /// rather than by averaging in case the instrument must decimate the
+        /// samples. This parameter defaults to <c>false</c>.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="duration" /> or <paramref name="sample_rate" /> is
+        /// not positive.</exception>
+        oscilloscope_acquisition_plan(_In_ const float duration,
+            _In_ const float sample_rate,
+            _In_ const bool peaks = false);
+
+        /// <summary>
+        /// Answer the decimation mode the channels should use.
+        /// </summary>
+        /// <returns>The decimation mode.</returns>
+        inline oscilloscope_decimation_mode decimation_mode(
+                void) const noexcept {
+            return this->_decimation_mode;
+        }
+
+        /// <summary>
+        /// Answer the record length of the waveforms.
+        /// </summary>
+        /// <returns>The number of points per waveform.</returns>
+        inline unsigned int points(void) const noexcept {
+            return this->_points;
+        }
+
+        /// <summary>
+        /// Answer whether the plan meets the requested sample rate.
+        /// </summary>
+        /// <remarks>
+        /// The requested rate cannot be met if it exceeds
+        /// <see cref="max_sample_rate" /> or if the longest record length is
+        /// not sufficient for the time range.
+        /// </remarks>
+        /// <returns><c>true</c> if the effective sample rate is at least the
+        /// requested one, <c>false</c> otherwise.</returns>
+        inline bool satisfied(void) const noexcept {
+            return this->_satisfied;
+        }
+
+        /// <summary>
+        /// Answer the effective sample rate of the waveforms.
+        /// </summary>
+        /// <returns>The number of waveform points per second.</returns>
+        inline float sample_rate(void) const noexcept {
+            return this->_sample_rate;
+        }
+
+        /// <summary>
+        /// Answer the time range covered by the waveforms.
+        /// </summary>
+        /// <returns>The time range in seconds, which is ten times the
+        /// <see cref="time_scale" />.</returns>
+        inline float time_range(void) const noexcept {
+            return this->_time_scale * 10.0f;
+        }
+
+        /// <summary>
+        /// Answer the horizontal scale of the instrument.
+        /// </summary>
+        /// <returns>The time per division in seconds.</returns>
+        inline float time_scale(void) const noexcept {
+            return this->_time_scale;
+        }
+
+    private:
+
+        oscilloscope_decimation_mode _decimation_mode;
+        unsigned int _points;
+        float _sample_rate;
+        bool _satisfied;
+        float _time_scale;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -128,6 +128,41 @@ namespace power_overwhelming {
             return this->_channel_current;
         }
 
+        /// <summary>
+        /// Gets the maths channel computing the power on the instrument.
+        /// </summary>
+        /// <returns>The one-based index of the maths channel, or zero if the
+        /// power is computed on the host from the waveforms of the voltage and
+        /// the current channel.</returns>
+        inline std::uint32_t channel_power(void) const noexcept {
+            return this->_channel_power;
+        }
+
+        /// <summary>
+        /// Configures a maths channel of the instrument to compute the power.
+        /// </summary>
+        /// <remarks>
+        /// <para>If a maths channel is set, the sensor configures it to
+        /// multiply the voltage and the current channel and downloads only
+        /// its waveform, which halves the data to be transferred for each
+        /// acquisition. The instrument computes the product from the scaled
+        /// values of the channels, so the attenuation of the probes is
+        /// applied before the multiplication.</para>
+        /// <para>As the waveforms of the voltage and the current channel are
+        /// not downloaded in this mode, the voltage and the current of the
+        /// samples are invalid unless <see cref="raw_channels" /> is
+        /// enabled.</para>
+        /// </remarks>
+        /// <param name="channel">The one-based index of the maths channel,
+        /// which must be within [1, 4] for an RTB2004. If zero, the power is
+        /// computed on the host.</param>
+        /// <returns><c>*this</c>.</returns>
+        inline oscilloscope_sensor_definition& channel_power(
+                _In_ const std::uint32_t channel) noexcept {
+            this->_channel_power = channel;
+            return *this;
+        }
+
         /// <summary>
         /// Gets the channel of the voltage probe.
         /// </summary>
@@ -146,6 +181,68 @@ namespace power_overwhelming {
             return this->_description;
         }
 
+        /// <summary>
+        /// Determines whether the waveforms of the voltage and the current
+        /// channel are downloaded although the power is computed on the
+        /// instrument.
+        /// </summary>
+        /// <returns><c>true</c> if the raw channels are downloaded in addition
+        /// to the maths channel, <c>false</c> otherwise.</returns>
+        inline bool raw_channels(void) const noexcept {
+            return this->_raw_channels;
+        }
+
+        /// <summary>
+        /// Enables or disables downloading the waveforms of the voltage and
+        /// the current channel if the power is computed on the instrument.
+        /// </summary>
+        /// <remarks>
+        /// This setting has no effect unless <see cref="channel_power" /> has
+        /// been set, because the raw channels are always required to compute
+        /// the power on the host.
+        /// </remarks>
+        /// <param name="enable"><c>true</c> for downloading the raw channels,
+        /// <c>false</c> for downloading only the maths channel.</param>
+        /// <returns><c>*this</c>.</returns>
+        inline oscilloscope_sensor_definition& raw_channels(
+                _In_ const bool enable) noexcept {
+            this->_raw_channels = enable;
+            return *this;
+        }
+
+        /// <summary>
+        /// Determines whether the acquisitions are triggered by software
+        /// rather than by a signal.
+        /// </summary>
+        /// <returns><c>true</c> if the sensor is triggered via
+        /// <see cref="rtx_sensor::trigger" />, <c>false</c> otherwise.
+        /// </returns>
+        inline bool software_trigger(void) const noexcept {
+            return this->_software_trigger;
+        }
+
+        /// <summary>
+        /// Enables or disables triggering the acquisitions by software.
+        /// </summary>
+        /// <remarks>
+        /// If enabled, the sensor configures the trigger of the instrument
+        /// such that only <c>*TRG</c> starts an acquisition, and each
+        /// acquisition is aligned to the time
+        /// <see cref="rtx_sensor::trigger" /> has sent this command rather than
+        /// to the time it completed. This
+        /// allows for correlating the waveforms with markers of the
+        /// application, for instance via
+        /// <see cref="collector_settings::trigger_oscilloscopes" />.
+        /// </remarks>
+        /// <param name="enable"><c>true</c> for triggering by software,
+        /// <c>false</c> for keeping the trigger of the instrument.</param>
+        /// <returns><c>*this</c>.</returns>
+        inline oscilloscope_sensor_definition& software_trigger(
+                _In_ const bool enable) noexcept {
+            this->_software_trigger = enable;
+            return *this;
+        }
+
         /// <summary>
         /// Assignment.
         /// </summary>
@@ -161,8 +258,11 @@ namespace power_overwhelming {
         float _attenuation_current;
         float _attenuation_voltage;
         std::uint32_t _channel_current;
+        std::uint32_t _channel_power;
         std::uint32_t _channel_voltage;
         wchar_t *_description;
+        bool _raw_channels;
+        bool _software_trigger;
     };
 
 } /* namespace power_overwhelming */
@@ -11,13 +11,35 @@
 namespace visus {
 namespace power_overwhelming {
 
+    /* Forward declarations. */
+    class rtx_instrument;
+
     /// <summary>
     /// Defines a container for data obtained from an oscilloscope channel.
     /// </summary>
+    /// <remarks>
+    /// The waveform takes over the buffer the samples have been received in
+    /// without copying them. The samples start at the begin of the buffer,
+    /// which is aligned like any allocation by the global <c>operator new</c>
+    /// and therefore suitable for SIMD loads. If a waveform is passed to the
+    /// instrument again, the instrument reuses its buffer unless the new
+    /// waveform is larger, which avoids allocating and faulting in several
+    /// megabytes for every acquisition.
+    /// </remarks>
     class POWER_OVERWHELMING_API oscilloscope_waveform final {
 
     public:
 
+        /// <summary>
+        /// Initialises a new, empty instance.
+        /// </summary>
+        /// <remarks>
+        /// This constructor allows for allocating arrays of waveforms that
+        /// are filled by the instrument.
+        /// </remarks>
+        inline oscilloscope_waveform(void) noexcept
+            : _record_length(0), _time_begin(0.0f), _time_end(0.0f) { }
+
         /// <summary>
         /// Initialises a new instance.
         /// </summary>
@@ -87,10 +109,19 @@ namespace power_overwhelming {
 
     private:
 
+        /// <summary>
+        /// Parses the <paramref name="header" /> and checks it against the
+        /// <paramref name="valid" /> number of bytes in
+        /// <see cref="_samples" />.
+        /// </summary>
+        void parse_header(_In_z_ const char *header, _In_ const std::size_t valid);
+
         std::size_t _record_length;
         blob _samples;
         float _time_begin;
         float _time_end;
+
+        friend class rtx_instrument;
     };
 
 } /* namespace power_overwhelming */
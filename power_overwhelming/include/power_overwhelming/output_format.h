@@ -0,0 +1,170 @@
+﻿// <copyright file="output_format.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// Specifies the format of the file written by a
+    /// <see cref="collector" />.
+    /// </summary>
+    enum class output_format {
+
+        /// <summary>
+        /// The collector writes a CSV file with one line per sample.
+        /// </summary>
+        csv,
+
+        /// <summary>
+        /// The collector writes a chunked binary file that stores the samples
+        /// of each sensor in columns.
+        /// </summary>
+        /// <remarks>
+        /// The binary format is much cheaper to write during acquisition. Use
+        /// <see cref="binary_output_to_csv" /> to convert it to the CSV format
+        /// afterwards, or <see cref="binary_output_reader" /> to retrieve the
+        /// samples of a time range or marker via the index in the footer.
+        /// </remarks>
+        binary,
+
+        /// <summary>
+        /// The collector writes the same file as for <see cref="binary" />,
+        /// but through a memory-mapped window that is advanced in chunks.
+        /// </summary>
+        /// <remarks>
+        /// The file is pre-extended for each chunk, such that the I/O thread
+        /// copies the samples into the page cache without any system call.
+        /// If the process crashes, all samples the I/O thread has written
+        /// are retained, followed by unused space that
+        /// <see cref="binary_output_to_csv" /> ignores. The footer marking
+        /// the file as complete is written when the collector is stopped.
+        /// </remarks>
+        mapped_binary,
+
+        /// <summary>
+        /// The collector streams the same data as for <see cref="binary" />
+        /// to a remote host via TCP instead of writing a file.
+        /// </summary>
+        /// <remarks>
+        /// <para>The output path is the address of the remote host in the
+        /// form <c>host:port</c>, with IPv6 addresses enclosed in brackets.
+        /// The collector connects when it is started and sends a batch of
+        /// records after each pass of its I/O thread, which is compressed if
+        /// <see cref="collector_settings::compress_output" /> is set. The
+        /// remote host can store the bytes it receives as a binary output
+        /// file.</para>
+        /// <para>The batches are sent from a dedicated thread through a
+        /// bounded queue. If the network cannot keep up, the samples of the
+        /// oldest batches are dropped while the declarations of sensors and
+        /// markers are retained, and the dropped samples are reported by
+        /// <see cref="collector::overflows" />.</para>
+        /// </remarks>
+        network_binary,
+
+        /// <summary>
+        /// The collector writes a trace in the protobuf format of Perfetto.
+        /// </summary>
+        /// <remarks>
+        /// <para>Each sensor becomes a counter track of its power, and of its
+        /// voltage and current if available, and the markers become slices
+        /// on a track of their own. The timestamps of the trace use the
+        /// real-time clock, and the trace contains a clock snapshot relating
+        /// it to the boot clock, such that it can be concatenated with a
+        /// system trace recorded at the same time to overlay both in the
+        /// Perfetto UI.</para>
+        /// <para>Aggregates are written as counter tracks of the mean power,
+        /// whereas the energies of the phases and the statistics of the
+        /// samplers are only available in the other formats.</para>
+        /// </remarks>
+        perfetto,
+
+        /// <summary>
+        /// The collector writes the same trace as for
+        /// <see cref="perfetto" /> in the JSON format of the Chrome tracing
+        /// UI.
+        /// </summary>
+        /// <remarks>
+        /// The JSON format is much larger than the protobuf format, but it
+        /// can be read by more tools. The timestamps are in microseconds
+        /// since the UNIX epoch.
+        /// </remarks>
+        chrome_trace,
+
+        /// <summary>
+        /// The collector writes the samples as an Apache Arrow IPC file.
+        /// </summary>
+        /// <remarks>
+        /// <para>The file contains a table with one row per sample and the
+        /// columns <c>sensor</c>, <c>timestamp</c>, <c>voltage</c>,
+        /// <c>current</c>, <c>power</c> and <c>marker</c>. The names of the
+        /// sensors and the markers are dictionary-encoded, and invalid values
+        /// are null. The timestamps are relative to the UNIX epoch in UTC.
+        /// </para>
+        /// <para>Each flush of the collector writes a record batch, such that
+        /// the file can be memory-mapped and queried without conversion by
+        /// any Arrow-based tool once the collector has stopped. Aggregates,
+        /// the energies of the phases and the statistics of the samplers are
+        /// only available in the other formats.</para>
+        /// </remarks>
+        arrow,
+
+        /// <summary>
+        /// The collector writes the same file as for <see cref="binary" />,
+        /// but submits the writes asynchronously from a fixed set of
+        /// buffers.
+        /// </summary>
+        /// <remarks>
+        /// The I/O thread of the collector hands a full buffer to the system
+        /// and continues encoding the next batch into another one, such that
+        /// it only blocks if all buffers are still being written. On Linux,
+        /// the writes go through io_uring with preregistered buffers, on
+        /// Windows through overlapped I/O. This reduces the overhead and the
+        /// latency of the I/O thread for long, high-rate collections.
+        /// </remarks>
+        async_binary,
+
+        /// <summary>
+        /// The collector writes the same file as for
+        /// <see cref="async_binary" />, but bypasses the page cache of the
+        /// operating system.
+        /// </summary>
+        /// <remarks>
+        /// <para>The file is opened with <c>O_DIRECT</c> on Linux and with
+        /// <c>FILE_FLAG_NO_BUFFERING</c> on Windows, such that the output
+        /// does not evict the data of the workload being measured from the
+        /// page cache. The data are only written in whole pages, so up to one
+        /// page of samples remains in memory until it is full or the
+        /// collector is stopped.</para>
+        /// <para>File systems that do not support direct I/O, like tmpfs, are
+        /// written as for <see cref="async_binary" />.</para>
+        /// </remarks>
+        direct_binary,
+
+        /// <summary>
+        /// The collector writes a CSV file with one line per tick and one
+        /// column with the power of each sensor.
+        /// </summary>
+        /// <remarks>
+        /// <para>The samples of all sensors within a sampling interval, or at
+        /// the same point of the grid if
+        /// <see cref="collector_settings::resampling_interval" /> is set,
+        /// share a line, whose timestamp is the start of the interval. The
+        /// header is only repeated if a sensor has been added, and the
+        /// marker is only written if it changed, which makes the file much
+        /// smaller than for <see cref="csv" /> if there are many sensors.
+        /// </para>
+        /// <para>Voltage and current are not written, and if a sensor delivers
+        /// multiple samples within an interval, only the last one is retained.
+        /// All comments, like the markers and the energies of the phases, are
+        /// the same as for <see cref="csv" />.</para>
+        /// </remarks>
+        wide_csv
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,244 @@
+﻿// <copyright file="perf_rapl_sensor.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+
+#include "power_overwhelming/rapl_domain.h"
+#include "power_overwhelming/sensor.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations */
+    namespace detail { struct perf_rapl_sensor_impl; }
+
+
+    /// <summary>
+    /// Implementation of a power sensor for the RAPL domains using the
+    /// <c>power</c> PMU of the Linux perf subsystem.
+    /// </summary>
+    /// <remarks>
+    /// <para>This sensor is an alternative to the <see cref="msr_sensor" /> on
+    /// Linux, which neither requires the msr kernel module nor root
+    /// privileges, but only permission to open system-wide perf events, e.g.
+    /// via <c>CAP_PERFMON</c> or a <c>perf_event_paranoid</c> setting of zero
+    /// or less. The kernel accumulates the energy counters in 64 bits, so the
+    /// sensor does not need to be sampled regularly to handle wrapping
+    /// registers.</para>
+    /// <para>All RAPL domains of a CPU are opened as a single group of events,
+    /// which is shared by all sensors for this CPU. If the sensors are sampled
+    /// together, all domains are retrieved with a single read.</para>
+    /// <para>The PMU is not available on Windows, where the sensor cannot be
+    /// created.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API perf_rapl_sensor final : public sensor {
+
+    public:
+
+        /// <summary>
+        /// The type used to index CPU cores.
+        /// </summary>
+        typedef std::uint32_t core_type;
+
+        /// <summary>
+        /// Create sensors for all RAPL domains that the <c>power</c> PMU
+        /// provides.
+        /// </summary>
+        /// <remarks>
+        /// The PMU reports one logical CPU per package, which is used to open
+        /// the events, so there is exactly one sensor per package and domain.
+        /// </remarks>
+        /// <param name="out_sensors">Receives the sensors, if not
+        /// <c>nullptr</c>.</param>
+        /// <param name="cnt_sensors">The available space in
+        /// <paramref name="out_sensors" />.</param>
+        /// <returns>The number of sensors available on the system, regardless
+        /// of the size of the output array. If this number is larger than
+        /// <paramref name="cnt_sensors" />, not all sensors have been returned.
+        /// </returns>
+        static std::size_t for_all(
+            _Out_writes_opt_(cnt_sensors) perf_rapl_sensor *out_sensors,
+            _In_ const std::size_t cnt_sensors);
+
+        /// <summary>
+        /// Create a sensor for the specified CPU and RAPL domain.
+        /// </summary>
+        /// <param name="core">The logical CPU to open the events on, which
+        /// must be one of the CPUs in the <c>cpumask</c> of the PMU.</param>
+        /// <param name="domain">The RAPL domain that is being sampled.</param>
+        /// <returns>A new sensor for the specified CPU and RAPL domain.
+        /// </returns>
+        /// <exception cref="std::invalid_argument">If the RAPL domain is not
+        /// supported by the PMU.</exception>
+        /// <exception cref="std::system_error">If the PMU is not available or
+        /// if the events could not be opened, e.g. due to missing privileges.
+        /// </exception>
+        static perf_rapl_sensor for_core(_In_ const core_type core,
+            _In_ const rapl_domain domain);
+
+        /// <summary>
+        /// Samples all of the given sensors without attaching their names to
+        /// the samples.
+        /// </summary>
+        /// <remarks>
+        /// This is the batch variant of <see cref="sample_data" />, which
+        /// enters the library only once for all sensors of the family.
+        /// </remarks>
+        /// <param name="dst">Receives <paramref name="cnt" /> samples.</param>
+        /// <param name="sensors">The sensors to be sampled.</param>
+        /// <param name="cnt">The number of sensors in
+        /// <paramref name="sensors" />.</param>
+        /// <param name="resolution">The resolution of the timestamps to be
+        /// created. This parameter defaults to
+        /// <see cref="timestamp_resolution::milliseconds" />.</param>
+        /// <exception cref="std::invalid_argument">If <paramref name="dst" />
+        /// or <paramref name="sensors" /> is <c>nullptr</c> while
+        /// <paramref name="cnt" /> is not zero.</exception>
+        /// <exception cref="std::runtime_error">If any of the sensors has been
+        /// moved (and therefore disposed).</exception>
+        static void sample_data(_Out_writes_(cnt) measurement_data *dst,
+            _In_reads_(cnt) const perf_rapl_sensor *sensors,
+            _In_ const std::size_t cnt,
+            _In_ const timestamp_resolution resolution
+            = timestamp_resolution::milliseconds);
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        perf_rapl_sensor(void);
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline perf_rapl_sensor(_In_ perf_rapl_sensor&& rhs) noexcept
+                : _impl(rhs._impl) {
+            rhs._impl = nullptr;
+        }
+
+        /// <summary>
+        /// Finalise the instance.
+        /// </summary>
+        virtual ~perf_rapl_sensor(void);
+
+        /// <summary>
+        /// Answer the logical CPU the events have been opened on.
+        /// </summary>
+        /// <returns>The index of the CPU the sensor is sampling.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        core_type core(void) const;
+
+        /// <summary>
+        /// Answer the RAPL domain the sensor is sampling.
+        /// </summary>
+        /// <returns>The RAPL domain the sensor is sampling.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        rapl_domain domain(void) const;
+
+        /// <summary>
+        /// Answer the energy in Joules the RAPL domain has consumed since the
+        /// sensor was created.
+        /// </summary>
+        /// <returns>The consumed energy in Joules.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        /// <exception cref="std::system_error">If reading the events failed.
+        /// </exception>
+        double energy(void) const;
+
+        /// <inheritdoc />
+        virtual _Ret_maybenull_z_ const wchar_t *name(
+            void) const noexcept override;
+
+        /// <summary>
+        /// Answer the interval at which the processor updates the RAPL energy
+        /// counters, which is approximately one millisecond.
+        /// </summary>
+        /// <returns>The update interval in microseconds.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        virtual microseconds_type native_interval(void) const override;
+
+        using sensor::sample;
+
+        /// <inheritdoc />
+        virtual void sample_adaptive(
+            _In_opt_ const measurement_data_callback on_batch,
+            _In_ const microseconds_type min_period,
+            _In_ const microseconds_type max_period,
+            _In_opt_ void *context = nullptr) override;
+
+        /// <summary>
+        /// Sample the sensor using a timestamp with the specified resolution,
+        /// but do not attach the sensor that produces the data to the sample.
+        /// </summary>
+        /// <remarks>
+        /// This method hides <see cref="sensor::sample_data" /> and provides a
+        /// fast path for code that knows the type of the sensor, because it
+        /// does not need any virtual call.
+        /// </remarks>
+        /// <param name="resolution">The resolution of the timestamp to be
+        /// created. This parameter defaults to
+        /// <see cref="timestamp_resolution::milliseconds" />.</param>
+        /// <returns>A single measurement made by the sensor.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved
+        /// (and therefore disposed).</exception>
+        measurement_data sample_data(_In_ const timestamp_resolution resolution
+            = timestamp_resolution::milliseconds) const;
+
+        /// <summary>
+        /// Asynchronously sample the sensor every
+        /// <paramref name="sampling_period "/> microseconds.
+        /// </summary>
+        /// <param name="on_measurement">The callback to be invoked if new data
+        /// arrived. If this is <c>nullptr</c>, the asynchronous sampling will
+        /// be disabled.</param>
+        /// <param name="period">The desired sampling period in
+        /// microseconds. This parameter defaults to 1 millisecond.</param>
+        /// <param name="timestamp_resolution">The resolution of the timestamps
+        /// that are generated by the sensor. This parameter defaults to
+        /// <see cref="timestamp_resolution::milliseconds" />.</param>
+        /// <param name="context">A user-defined context pointer that is passed
+        /// on to <see cref="on_measurement" />. This parameter defaults to
+        /// <c>nullptr</c>.</para>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        /// <exception cref="std::logic_error">If the sensor is already being
+        /// sampled asynchronously due to a previous call to the method.
+        /// </exception>
+        void sample(_In_opt_ const measurement_callback on_measurement,
+            _In_ const microseconds_type period = default_sampling_period,
+            _In_ const timestamp_resolution timestamp_resolution
+                = timestamp_resolution::milliseconds,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand</param>
+        /// <returns><c>*this</c></returns>
+        perf_rapl_sensor& operator =(_In_ perf_rapl_sensor&& rhs) noexcept;
+
+        /// <inheritdoc />
+        virtual operator bool(void) const noexcept override;
+
+    protected:
+
+        /// <inheritdoc />
+        measurement_data sample_sync(
+            _In_ const timestamp_resolution resolution) const override;
+
+    private:
+
+        detail::perf_rapl_sensor_impl *_impl;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,97 @@
+﻿// <copyright file="power_estimate.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "power_overwhelming/measurement_data.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// A power estimated from the activity of a device along with the bounds
+    /// of its 95 % confidence interval.
+    /// </summary>
+    class POWER_OVERWHELMING_API power_estimate final {
+
+    public:
+
+        /// <summary>
+        /// The type used to store timestamps.
+        /// </summary>
+        typedef measurement_data::timestamp_type timestamp_type;
+
+        /// <summary>
+        /// The type used to store the power.
+        /// </summary>
+        typedef measurement_data::value_type value_type;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="timestamp">The timestamp of the activity the power
+        /// has been estimated from.</param>
+        /// <param name="power">The estimated power in Watts.</param>
+        /// <param name="lower">The lower bound of the power in Watts.</param>
+        /// <param name="upper">The upper bound of the power in Watts.</param>
+        inline power_estimate(_In_ const timestamp_type timestamp,
+                _In_ const value_type power,
+                _In_ const value_type lower,
+                _In_ const value_type upper) noexcept
+            : _lower(lower), _power(power), _timestamp(timestamp),
+            _upper(upper) { }
+
+        /// <summary>
+        /// Initialises a new instance without an estimate.
+        /// </summary>
+        inline power_estimate(void) noexcept
+            : power_estimate(0, measurement_data::invalid_value,
+                measurement_data::invalid_value,
+                measurement_data::invalid_value) { }
+
+        /// <summary>
+        /// Answer the lower bound of the confidence interval.
+        /// </summary>
+        /// <returns>The lower bound in Watts.</returns>
+        inline value_type lower(void) const noexcept {
+            return this->_lower;
+        }
+
+        /// <summary>
+        /// Answer the estimated power.
+        /// </summary>
+        /// <returns>The power in Watts.</returns>
+        inline value_type power(void) const noexcept {
+            return this->_power;
+        }
+
+        /// <summary>
+        /// Answer the timestamp of the estimate.
+        /// </summary>
+        /// <returns>The timestamp in the resolution the sensor has been
+        /// sampled with.</returns>
+        inline timestamp_type timestamp(void) const noexcept {
+            return this->_timestamp;
+        }
+
+        /// <summary>
+        /// Answer the upper bound of the confidence interval.
+        /// </summary>
+        /// <returns>The upper bound in Watts.</returns>
+        inline value_type upper(void) const noexcept {
+            return this->_upper;
+        }
+
+    private:
+
+        value_type _lower;
+        value_type _power;
+        timestamp_type _timestamp;
+        value_type _upper;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,229 @@
+﻿// <copyright file="power_governor.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstdint>
+
+#include "power_overwhelming/power_governor_mode.h"
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// Describes a closed-loop controller that an <see cref="nvml_sensor" />
+    /// uses to adjust the power limit of its GPU while it is being sampled.
+    /// </summary>
+    /// <remarks>
+    /// <para>The governor runs on the thread that samples the sensor. It
+    /// averages the power of all samples within a control interval and
+    /// updates the power limit at the end of each interval, so it does not
+    /// issue any additional queries to the driver.</para>
+    /// <para>The power limit reacts with a delay of some ten milliseconds
+    /// and the driver averages the power reading over a similar period, so
+    /// the control interval should be at least several hundred
+    /// milliseconds.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API power_governor final {
+
+    public:
+
+        /// <summary>
+        /// The callback reporting the performance of the application.
+        /// </summary>
+        /// <remarks>
+        /// The callback is invoked on the sampler thread once at the end of
+        /// each control interval. It must return the performance achieved
+        /// since its previous invocation as a rate, eg in frames or
+        /// operations per second, where larger is better. It must not change
+        /// the governor of the sensor it is invoked for.
+        /// </remarks>
+        typedef double (*performance_callback)(_In_opt_ void *context);
+
+        /// <summary>
+        /// The default length of a control interval in microseconds.
+        /// </summary>
+        static constexpr std::int64_t default_interval = 1000000;
+
+        /// <summary>
+        /// Creates a governor that adjusts the power limit such that the
+        /// device draws the given power on average.
+        /// </summary>
+        /// <remarks>
+        /// If the application does not reach the target power without a
+        /// limit, the governor raises the limit to the maximum the device
+        /// supports.
+        /// </remarks>
+        /// <param name="target">The target power in Watts, which must be
+        /// positive.</param>
+        /// <returns>The description of the governor.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="target" /> is not positive.</exception>
+        static power_governor hold_power(_In_ const double target);
+
+        /// <summary>
+        /// Creates a governor that searches the power limit at which the
+        /// application achieves the best performance per Watt.
+        /// </summary>
+        /// <remarks>
+        /// The governor starts at the highest limit and changes the limit by
+        /// a step after each control interval. As long as the efficiency
+        /// improves, it continues in the same direction. Otherwise, it turns
+        /// around and halves the step until the step reaches
+        /// <see cref="resolution" />. Afterwards, it keeps oscillating around
+        /// the best limit, which allows for following a change of the
+        /// workload.
+        /// </remarks>
+        /// <param name="performance">The callback reporting the performance
+        /// of the application.</param>
+        /// <param name="context">A user-defined pointer passed to
+        /// <paramref name="performance" />.</param>
+        /// <returns>The description of the governor.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="performance" /> is <c>nullptr</c>.</exception>
+        static power_governor maximise_efficiency(
+            _In_ const performance_callback performance,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Initialises a new instance that does not change the power limit.
+        /// </summary>
+        power_governor(void) noexcept;
+
+        /// <summary>
+        /// Gets the user-defined pointer passed to the performance callback.
+        /// </summary>
+        /// <returns>The context of the performance callback.</returns>
+        inline void *context(void) const noexcept {
+            return this->_context;
+        }
+
+        /// <summary>
+        /// Gets the length of a control interval.
+        /// </summary>
+        /// <returns>The control interval in microseconds.</returns>
+        inline std::int64_t interval(void) const noexcept {
+            return this->_interval;
+        }
+
+        /// <summary>
+        /// Sets the length of a control interval.
+        /// </summary>
+        /// <param name="interval">The control interval in microseconds,
+        /// which must be positive.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="interval" /> is not positive.</exception>
+        power_governor& interval(_In_ const std::int64_t interval);
+
+        /// <summary>
+        /// Gets the upper bound for the power limit.
+        /// </summary>
+        /// <returns>The largest limit in Watts, or zero for the largest limit
+        /// the device supports.</returns>
+        inline double max_limit(void) const noexcept {
+            return this->_max_limit;
+        }
+
+        /// <summary>
+        /// Gets the lower bound for the power limit.
+        /// </summary>
+        /// <returns>The smallest limit in Watts, or zero for the smallest
+        /// limit the device supports.</returns>
+        inline double min_limit(void) const noexcept {
+            return this->_min_limit;
+        }
+
+        /// <summary>
+        /// Restricts the range of power limits the governor may set.
+        /// </summary>
+        /// <remarks>
+        /// The range is intersected with the range the device supports when
+        /// the governor is attached to a sensor.
+        /// </remarks>
+        /// <param name="min_limit">The smallest limit in Watts, or zero for
+        /// the smallest limit the device supports.</param>
+        /// <param name="max_limit">The largest limit in Watts, or zero for
+        /// the largest limit the device supports.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If any of the bounds is
+        /// negative or if <paramref name="max_limit" /> is not zero and
+        /// smaller than <paramref name="min_limit" />.</exception>
+        power_governor& limits(_In_ const double min_limit,
+            _In_ const double max_limit);
+
+        /// <summary>
+        /// Gets the goal of the governor.
+        /// </summary>
+        /// <returns>The mode of the governor.</returns>
+        inline power_governor_mode mode(void) const noexcept {
+            return this->_mode;
+        }
+
+        /// <summary>
+        /// Gets the callback reporting the performance of the application.
+        /// </summary>
+        /// <returns>The performance callback, which is <c>nullptr</c> unless
+        /// the mode is <see cref="power_governor_mode::maximise_efficiency" />.
+        /// </returns>
+        inline performance_callback performance(void) const noexcept {
+            return this->_performance;
+        }
+
+        /// <summary>
+        /// Gets the smallest step by which the efficiency search changes the
+        /// power limit.
+        /// </summary>
+        /// <returns>The resolution of the search in Watts.</returns>
+        inline double resolution(void) const noexcept {
+            return this->_resolution;
+        }
+
+        /// <summary>
+        /// Sets the smallest step by which the efficiency search changes the
+        /// power limit.
+        /// </summary>
+        /// <param name="resolution">The resolution of the search in Watts,
+        /// which must be positive. This parameter defaults to 5 W.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="resolution" /> is not positive.</exception>
+        power_governor& resolution(_In_ const double resolution);
+
+        /// <summary>
+        /// Gets the target power.
+        /// </summary>
+        /// <returns>The target power in Watts, which is zero unless the mode
+        /// is <see cref="power_governor_mode::hold_power" />.</returns>
+        inline double target(void) const noexcept {
+            return this->_target;
+        }
+
+        /// <summary>
+        /// Answer whether the governor changes the power limit.
+        /// </summary>
+        /// <returns><c>true</c> if the mode is not
+        /// <see cref="power_governor_mode::none" />, <c>false</c> otherwise.
+        /// </returns>
+        inline operator bool(void) const noexcept {
+            return (this->_mode != power_governor_mode::none);
+        }
+
+    private:
+
+        void *_context;
+        std::int64_t _interval;
+        double _max_limit;
+        double _min_limit;
+        power_governor_mode _mode;
+        performance_callback _performance;
+        double _resolution;
+        double _target;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,36 @@
+﻿// <copyright file="power_governor_mode.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// Specifies the goal of a <see cref="power_governor" />.
+    /// </summary>
+    enum class power_governor_mode {
+
+        /// <summary>
+        /// The power limit of the device is not changed.
+        /// </summary>
+        none,
+
+        /// <summary>
+        /// The power limit is adjusted such that the device draws a target
+        /// power on average.
+        /// </summary>
+        hold_power,
+
+        /// <summary>
+        /// The power limit is searched for the point at which the performance
+        /// reported by the user divided by the power is maximal.
+        /// </summary>
+        maximise_efficiency
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
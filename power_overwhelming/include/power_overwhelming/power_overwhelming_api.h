@@ -29,13 +29,16 @@
 #define _Inout_
 #define _Inout_opt_
 #define _Inout_opt_z_
+#define _Inout_updates_(cnt)
 #define _In_opt_
 #define _In_opt_z_
 #define _In_reads_(cnt)
 #define _In_reads_bytes_(cnt)
+#define _In_reads_opt_(cnt)
 #define _In_reads_or_z_(cnt)
 #define _In_z_
 #define _Out_
+#define _Out_opt_
 #define _Out_writes_(cnt)
 #define _Out_writes_bytes_(cnt)
 #define _Out_writes_opt_(cnt)
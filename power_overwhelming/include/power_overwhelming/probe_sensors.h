@@ -0,0 +1,105 @@
+﻿// <copyright file="probe_sensors.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+#include "power_overwhelming/sensor.h"
+#include "power_overwhelming/sensor_filter.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// The default time in microseconds for which each sensor is probed.
+    /// </summary>
+    constexpr sensor::microseconds_type default_probe_duration = 1000000;
+
+    /// <summary>
+    /// Measures the capabilities of all sensors currently found on the
+    /// system that are accepted by the given filter and saves them as a JSON
+    /// report.
+    /// </summary>
+    /// <remarks>
+    /// <para>Each sensor is sampled synchronously as fast as possible for
+    /// <paramref name="duration" />, one after the other. The report
+    /// contains the distribution of the time it took to obtain a sample, the
+    /// CPU time spent per sample, the interval at which the readings
+    /// actually changed and the resulting shortest interval at which the
+    /// sensor should be sampled on this machine. Sensors that failed to
+    /// deliver samples are reported with the error message.</para>
+    /// <para>The collector raises the sampling intervals to the safe
+    /// intervals from the report if the report is configured via
+    /// <see cref="collector_settings::capability_report" />.</para>
+    /// </remarks>
+    /// <param name="path">The path of the file to write the report to.
+    /// </param>
+    /// <param name="filter">The filter selecting the sensors to be probed.
+    /// </param>
+    /// <param name="duration">The time in microseconds for which each sensor
+    /// is probed.</param>
+    /// <returns>The number of sensors probed.</returns>
+    /// <exception cref="std::ios_base::failure">If saving the report failed.
+    /// </exception>
+    /// <exception cref="std::regex_error">If any of the patterns of the
+    /// filter is not a valid regular expression.</exception>
+    std::size_t POWER_OVERWHELMING_API probe_sensors(_In_z_ const char *path,
+        _In_ const sensor_filter& filter,
+        _In_ const sensor::microseconds_type duration
+        = default_probe_duration);
+
+    /// <summary>
+    /// Measures the capabilities of all sensors currently found on the
+    /// system that are accepted by the given filter and saves them as a JSON
+    /// report.
+    /// </summary>
+    /// <remarks>
+    /// See the narrow-string overload for details.
+    /// </remarks>
+    /// <param name="path">The path of the file to write the report to.
+    /// </param>
+    /// <param name="filter">The filter selecting the sensors to be probed.
+    /// </param>
+    /// <param name="duration">The time in microseconds for which each sensor
+    /// is probed.</param>
+    /// <returns>The number of sensors probed.</returns>
+    /// <exception cref="std::ios_base::failure">If saving the report failed.
+    /// </exception>
+    /// <exception cref="std::regex_error">If any of the patterns of the
+    /// filter is not a valid regular expression.</exception>
+    std::size_t POWER_OVERWHELMING_API probe_sensors(
+        _In_z_ const wchar_t *path,
+        _In_ const sensor_filter& filter,
+        _In_ const sensor::microseconds_type duration
+        = default_probe_duration);
+
+    /// <summary>
+    /// Measures the capabilities of all sensors currently found on the
+    /// system that are accepted by the given filter and saves them as a JSON
+    /// report.
+    /// </summary>
+    /// <typeparam name="TChar">The type of character used in the path.
+    /// </typeparam>
+    /// <param name="path">The path of the file to write the report to.
+    /// </param>
+    /// <param name="filter">The filter selecting the sensors to be probed.
+    /// </param>
+    /// <param name="duration">The time in microseconds for which each sensor
+    /// is probed.</param>
+    /// <returns>The number of sensors probed.</returns>
+    template<class TChar>
+    inline std::size_t probe_sensors(_In_ const std::basic_string<TChar>& path,
+            _In_ const sensor_filter& filter,
+            _In_ const sensor::microseconds_type duration
+            = default_probe_duration) {
+        return probe_sensors(path.c_str(), filter, duration);
+    }
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
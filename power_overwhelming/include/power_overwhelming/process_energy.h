@@ -0,0 +1,86 @@
+﻿// <copyright file="process_energy.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// The share of the energy of a GPU that has been attributed to a single
+    /// process.
+    /// </summary>
+    class POWER_OVERWHELMING_API process_energy final {
+
+    public:
+
+        /// <summary>
+        /// The type of a process ID.
+        /// </summary>
+        typedef std::uint32_t pid_type;
+
+        /// <summary>
+        /// The pseudo process ID the energy is attributed to while no
+        /// process uses the GPU.
+        /// </summary>
+        static constexpr pid_type idle = 0;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="pid">The ID of the process.</param>
+        /// <param name="energy">The energy attributed to the process in
+        /// Joules.</param>
+        /// <param name="duration">The time in seconds the process has been
+        /// using the GPU.</param>
+        inline process_energy(_In_ const pid_type pid,
+                _In_ const double energy,
+                _In_ const double duration) noexcept
+            : _duration(duration), _energy(energy), _pid(pid) { }
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        inline process_energy(void) noexcept : process_energy(idle, 0.0, 0.0) { }
+
+        /// <summary>
+        /// Gets the time the process has been using the GPU.
+        /// </summary>
+        /// <returns>The duration in seconds.</returns>
+        inline double duration(void) const noexcept {
+            return this->_duration;
+        }
+
+        /// <summary>
+        /// Gets the energy attributed to the process.
+        /// </summary>
+        /// <returns>The energy in Joules.</returns>
+        inline double energy(void) const noexcept {
+            return this->_energy;
+        }
+
+        /// <summary>
+        /// Gets the ID of the process.
+        /// </summary>
+        /// <returns>The process ID, which is <see cref="idle" /> for the
+        /// energy consumed while no process was using the GPU.</returns>
+        inline pid_type pid(void) const noexcept {
+            return this->_pid;
+        }
+
+    private:
+
+        double _duration;
+        double _energy;
+        pid_type _pid;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,261 @@
+﻿// <copyright file="replay_sensor.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "power_overwhelming/sensor.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations */
+    namespace detail { struct replay_sensor_impl; }
+
+
+    /// <summary>
+    /// A sensor that replays the samples of a sensor recorded by a
+    /// <see cref="collector" />, which allows for running analysis pipelines
+    /// deterministically and for benchmarking the collector without any
+    /// hardware.
+    /// </summary>
+    /// <remarks>
+    /// <para>The sensor loads all samples of the sensor with the requested
+    /// name from a file written in <see cref="output_format::binary" /> or
+    /// <see cref="output_format::csv" />, which is detected from the content
+    /// of the file. The replay sensor has the name of the recorded sensor,
+    /// such that configurations referring to the original sensor, for
+    /// instance derived sensors, work unchanged.</para>
+    /// <para>When being sampled asynchronously, the sensor runs its own
+    /// thread that delivers the samples with their original spacing divided
+    /// by the <see cref="speed" />, or as fast as the consumer accepts them if
+    /// the speed is <see cref="as_fast_as_possible" />. The sampling period
+    /// requested by the caller is ignored in this case. Polling the sensor
+    /// returns one sample after the other regardless of the time and repeats
+    /// the last one once a trace that is not looped has been exhausted.
+    /// </para>
+    /// <para>By default, the timestamps are shifted such that the trace
+    /// starts when the replay starts, but the spacing of the samples is
+    /// preserved even if the replay is accelerated, such that the results of
+    /// any analysis are the same as for the original trace. Timestamps in CSV
+    /// files are assumed to be in milliseconds, which is the resolution the
+    /// collector writes.</para>
+    /// <para>The properties of the sensor must not be changed while it is
+    /// being sampled.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API replay_sensor final : public sensor {
+
+    public:
+
+        /// <summary>
+        /// The <see cref="speed" /> at which the samples are delivered without
+        /// any delay.
+        /// </summary>
+        static constexpr double as_fast_as_possible = 0.0;
+
+        /// <summary>
+        /// The <see cref="speed" /> at which the samples are delivered with
+        /// their original spacing.
+        /// </summary>
+        static constexpr double real_time = 1.0;
+
+        /// <summary>
+        /// Create all replay sensors on the system.
+        /// </summary>
+        /// <remarks>
+        /// Replay sensors are not backed by any hardware and can therefore not
+        /// be discovered. They must be created explicitly or described in a
+        /// configuration file. The method only exists such that the sensor can
+        /// be used like all other sensors.
+        /// </remarks>
+        /// <param name="out_sensors">Receives the sensors, if not
+        /// <c>nullptr</c>.</param>
+        /// <param name="cnt_sensors">The available space in
+        /// <paramref name="out_sensors" />.</param>
+        /// <returns>Zero.</returns>
+        static std::size_t for_all(
+            _Out_writes_opt_(cnt_sensors) replay_sensor *out_sensors,
+            _In_ const std::size_t cnt_sensors);
+
+        /// <summary>
+        /// Initialises a new instance, which cannot be sampled until it has
+        /// been replaced by one that has loaded a trace.
+        /// </summary>
+        replay_sensor(void);
+
+        /// <summary>
+        /// Initialises a new instance replaying the samples of the given
+        /// sensor from the given file.
+        /// </summary>
+        /// <param name="path">The path to the recorded trace.</param>
+        /// <param name="name">The name of the recorded sensor, which becomes
+        /// the name of the replay sensor.</param>
+        /// <exception cref="std::invalid_argument">If <paramref name="path" />
+        /// is <c>nullptr</c> or if <paramref name="name" /> is <c>nullptr</c>
+        /// or empty, or if the file does not contain any samples of the
+        /// sensor.</exception>
+        /// <exception cref="std::system_error">If the file could not be
+        /// opened.</exception>
+        /// <exception cref="std::runtime_error">If the file is neither a
+        /// valid binary nor a valid CSV output file.</exception>
+        replay_sensor(_In_z_ const wchar_t *path, _In_z_ const wchar_t *name);
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline replay_sensor(_In_ replay_sensor&& rhs) noexcept
+                : _impl(rhs._impl) {
+            rhs._impl = nullptr;
+        }
+
+        /// <summary>
+        /// Finalise the instance.
+        /// </summary>
+        virtual ~replay_sensor(void);
+
+        /// <summary>
+        /// Answer whether the trace is replayed over and over again.
+        /// </summary>
+        /// <returns><c>true</c> if the replay restarts at the end of the
+        /// trace, <c>false</c> if it stops.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        bool loop(void) const;
+
+        /// <summary>
+        /// Sets whether the trace is replayed over and over again.
+        /// </summary>
+        /// <remarks>
+        /// Each repetition continues the timestamps of the previous one with
+        /// the mean spacing of the samples, such that the timestamps increase
+        /// monotonically.
+        /// </remarks>
+        /// <param name="loop"><c>true</c> for restarting the replay at the end
+        /// of the trace, <c>false</c> for stopping.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        replay_sensor& loop(_In_ const bool loop);
+
+        /// <summary>
+        /// Answer the name of the sensor.
+        /// </summary>
+        /// <returns>The name of the recorded sensor, or <c>nullptr</c> if the
+        /// sensor has been disposed.</returns>
+        virtual _Ret_maybenull_z_ const wchar_t *name(
+            void) const noexcept override;
+
+        /// <summary>
+        /// Answer the mean spacing of the recorded samples.
+        /// </summary>
+        /// <returns>The mean interval between two samples in microseconds,
+        /// or zero if the trace contains only one sample.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        virtual microseconds_type native_interval(void) const override;
+
+        /// <summary>
+        /// Answer the path to the recorded trace.
+        /// </summary>
+        /// <returns>The path, or <c>nullptr</c> if the sensor has been
+        /// disposed.</returns>
+        _Ret_maybenull_z_ const wchar_t *path(void) const noexcept;
+
+        /// <summary>
+        /// Answer whether the timestamps are shifted to the begin of the
+        /// replay.
+        /// </summary>
+        /// <returns><c>true</c> if the trace starts when it is replayed,
+        /// <c>false</c> if the recorded timestamps are reported.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        bool rebase(void) const;
+
+        /// <summary>
+        /// Sets whether the timestamps are shifted to the begin of the replay.
+        /// </summary>
+        /// <param name="rebase"><c>true</c> for shifting the trace to the
+        /// begin of the replay, <c>false</c> for reporting the recorded
+        /// timestamps.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        replay_sensor& rebase(_In_ const bool rebase);
+
+        /// <summary>
+        /// Answer how many samples have been replayed so far.
+        /// </summary>
+        /// <remarks>
+        /// The counter can be queried while the sensor is being sampled, for
+        /// instance in order to wait for the end of a trace that is not being
+        /// looped or for measuring the throughput of the consumer.
+        /// </remarks>
+        /// <returns>The number of samples delivered since the sensor has been
+        /// created.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        std::size_t replayed(void) const;
+
+        /// <inheritdoc />
+        virtual void sample_batch(
+            _In_opt_ const measurement_data_callback on_batch,
+            _In_ const microseconds_type period = default_sampling_period,
+            _In_opt_ void *context = nullptr) override;
+
+        /// <summary>
+        /// Answer the number of recorded samples of the sensor.
+        /// </summary>
+        /// <returns>The number of samples in the trace.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        std::size_t samples(void) const;
+
+        /// <summary>
+        /// Answer the speed of the replay relative to the recording.
+        /// </summary>
+        /// <returns>The speed factor, which is
+        /// <see cref="as_fast_as_possible" /> if the samples are delivered
+        /// without any delay.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        double speed(void) const;
+
+        /// <summary>
+        /// Sets the speed of the replay relative to the recording.
+        /// </summary>
+        /// <param name="speed">The speed factor, for instance
+        /// <see cref="real_time" />, 10 for replaying ten times faster than
+        /// recorded or <see cref="as_fast_as_possible" />.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="speed" /> is negative or not a number.</exception>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        replay_sensor& speed(_In_ const double speed);
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand</param>
+        /// <returns><c>*this</c></returns>
+        replay_sensor& operator =(_In_ replay_sensor&& rhs) noexcept;
+
+        /// <inheritdoc />
+        virtual operator bool(void) const noexcept override;
+
+    protected:
+
+        /// <inheritdoc />
+        measurement_data sample_sync(
+            _In_ const timestamp_resolution resolution) const override;
+
+    private:
+
+        detail::replay_sensor_impl *_impl;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
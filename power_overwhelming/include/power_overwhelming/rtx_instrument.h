@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include "power_overwhelming/oscilloscope_acquisition_plan.h"
 #include "power_overwhelming/oscilloscope_acquisition_state.h"
 #include "power_overwhelming/oscilloscope_channel.h"
 #include "power_overwhelming/oscilloscope_edge_trigger.h"
@@ -144,6 +145,10 @@ namespace power_overwhelming {
         /// Apply the specified channel configuration.
         /// </summary>
         /// <remarks>
+        /// <para>All settings are sent in a single message, and the error
+        /// queue of the instrument is checked only once afterwards. If the
+        /// instrument reports an error, some of the settings might have been
+        /// applied nevertheless.</para>
         /// <para>This method does nothing if the library has been compiled
         /// without VISA support.</para>
         /// </remarks>
@@ -153,6 +158,8 @@ namespace power_overwhelming {
         /// loaded.</exception>
         /// <exception cref="visa_exception">If the sensor could not be
         /// initialised.</exception>
+        /// <exception cref="std::runtime_error">If the instrument reported an
+        /// error for any of the settings.</exception>
         rtx_instrument& channel(_In_ const oscilloscope_channel& channel);
 
         /// <summary>
@@ -163,6 +170,114 @@ namespace power_overwhelming {
         /// <returns>The waveform for the specified channel.</returns>
         oscilloscope_waveform data(_In_ const std::uint32_t channel);
 
+        /// <summary>
+        /// Retrieves the waveform data for the specified channel into an
+        /// existing waveform.
+        /// </summary>
+        /// <remarks>
+        /// The samples are received directly into the buffer of
+        /// <paramref name="waveform" />, which is only reallocated if it is
+        /// too small. Callers that repeatedly download waveforms of the same
+        /// size should therefore keep the waveform and pass it again to avoid
+        /// allocating a new buffer for every download.
+        /// </remarks>
+        /// <param name="waveform">The waveform receiving the data. If the
+        /// method fails, the content of the waveform is undefined.</param>
+        /// <param name="channel">The one-based index of the channel to retrieve
+        /// the waveform for.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it.</exception>
+        /// <exception cref="visa_exception">If any of the API calls to the
+        /// instrument failed.</exception>
+        /// <exception cref="std::logic_error">If the method is called while
+        /// the library was compiled without support for VISA.</exception>
+        rtx_instrument& data(_Inout_ oscilloscope_waveform& waveform,
+            _In_ const std::uint32_t channel);
+
+        /// <summary>
+        /// Retrieves the waveforms of multiple channels of the current
+        /// acquisition at once.
+        /// </summary>
+        /// <remarks>
+        /// <para>Compared to retrieving the channels one after the other, this
+        /// method configures the transfer format and retrieves the headers of
+        /// all channels in a single message, and it checks the error state of
+        /// the instrument only once after all waveforms have been received.
+        /// Therefore, only one round trip per channel, which transfers the
+        /// samples, and one for the errors are required in addition to the
+        /// one for the headers.</para>
+        /// <para>As for <see cref="data(oscilloscope_waveform&amp;,
+        /// const std::uint32_t)" />, the buffers of the existing waveforms are
+        /// reused.</para>
+        /// </remarks>
+        /// <param name="out_waveforms">An array of at least
+        /// <paramref name="cnt" /> waveforms receiving the data of the
+        /// channels in the order of <paramref name="channels" />. If the
+        /// method fails, the content of the waveforms is undefined.</param>
+        /// <param name="channels">The one-based indices of the channels to be
+        /// retrieved.</param>
+        /// <param name="cnt">The number of elements in
+        /// <paramref name="channels" />.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="out_waveforms" /> or <paramref name="channels" />
+        /// is <c>nullptr</c> while <paramref name="cnt" /> is not zero.
+        /// </exception>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it, or if the instrument did
+        /// not send a header for every channel.</exception>
+        /// <exception cref="visa_exception">If any of the API calls to the
+        /// instrument failed.</exception>
+        /// <exception cref="std::logic_error">If the method is called while
+        /// the library was compiled without support for VISA.</exception>
+        rtx_instrument& data(
+            _Out_writes_(cnt) oscilloscope_waveform *out_waveforms,
+            _In_reads_(cnt) const std::uint32_t *channels,
+            _In_ const std::size_t cnt);
+
+        /// <summary>
+        /// Retrieves the waveforms of multiple channels and maths channels of
+        /// the current acquisition at once.
+        /// </summary>
+        /// <remarks>
+        /// This method works like <see cref="data(oscilloscope_waveform *,
+        /// const std::uint32_t *, const std::size_t)" />, but it can also
+        /// retrieve the results of the mathematical expressions configured via
+        /// <see cref="expression" />. The waveforms of the maths channels are
+        /// stored after the ones of the channels.
+        /// </remarks>
+        /// <param name="out_waveforms">An array of at least
+        /// <paramref name="cnt_channels" /> plus <paramref name="cnt_maths" />
+        /// waveforms receiving the data. If the method fails, the content of
+        /// the waveforms is undefined.</param>
+        /// <param name="channels">The one-based indices of the channels to be
+        /// retrieved.</param>
+        /// <param name="cnt_channels">The number of elements in
+        /// <paramref name="channels" />.</param>
+        /// <param name="maths">The one-based indices of the maths channels to
+        /// be retrieved.</param>
+        /// <param name="cnt_maths">The number of elements in
+        /// <paramref name="maths" />.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If any of the arrays is
+        /// <c>nullptr</c> while the number of its elements is not zero.
+        /// </exception>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it, or if the instrument did
+        /// not send a header for every channel.</exception>
+        /// <exception cref="visa_exception">If any of the API calls to the
+        /// instrument failed.</exception>
+        /// <exception cref="std::logic_error">If the method is called while
+        /// the library was compiled without support for VISA.</exception>
+        rtx_instrument& data(
+            _Out_writes_(cnt_channels + cnt_maths)
+            oscilloscope_waveform *out_waveforms,
+            _In_reads_(cnt_channels) const std::uint32_t *channels,
+            _In_ const std::size_t cnt_channels,
+            _In_reads_(cnt_maths) const std::uint32_t *maths,
+            _In_ const std::size_t cnt_maths);
+
         /// <summary>
         /// Enable and configure one of the mathematical expressions.
         /// </summary>
@@ -230,6 +345,115 @@ namespace power_overwhelming {
         /// instrument failed.</exception>
         rtx_instrument& history_segment(_In_ const int segment);
 
+        /// <summary>
+        /// Downloads the waveforms of the given channels for all history
+        /// segments in memory.
+        /// </summary>
+        /// <remarks>
+        /// <para>In contrast to selecting each segment and retrieving its
+        /// waveforms via <see cref="data" />, this method configures the data
+        /// format and retrieves the headers of the waveforms only once, selects
+        /// the segment and requests the data in a single command, and checks
+        /// the error state of the instrument only at the end. Furthermore, the
+        /// VISA read buffer is enlarged to hold a whole waveform. The headers
+        /// are shared by all segments, because they have been recorded with the
+        /// same settings.</para>
+        /// <para>The waveforms are stored contiguously starting with the oldest
+        /// segment. The waveform of the <c>i</c>th channel in
+        /// <paramref name="channels" /> of the <c>s</c>th segment is located at
+        /// <c>s * cnt_channels + i</c>.</para>
+        /// </remarks>
+        /// <param name="out_waveforms">An array receiving the waveforms. If
+        /// this is <c>nullptr</c> or too small to hold all segments, nothing is
+        /// downloaded.</param>
+        /// <param name="cnt_waveforms">The number of waveforms that can be
+        /// stored in <paramref name="out_waveforms" />.</param>
+        /// <param name="channels">The one-based indices of the channels to be
+        /// retrieved.</param>
+        /// <param name="cnt_channels">The number of elements in
+        /// <paramref name="channels" />.</param>
+        /// <returns>The number of waveforms required to hold all segments,
+        /// which is the number of segments times
+        /// <paramref name="cnt_channels" />, regardless of whether they have
+        /// been downloaded.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="channels" /> is <c>nullptr</c> while
+        /// <paramref name="cnt_channels" /> is not zero.</exception>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it.</exception>
+        /// <exception cref="visa_exception">If any of the API calls to the
+        /// instrument failed.</exception>
+        /// <exception cref="std::logic_error">If the method is called while
+        /// the library was compiled without support for VISA.</exception>
+        std::size_t history_data(
+            _Out_writes_opt_(cnt_waveforms)
+            oscilloscope_waveform *out_waveforms,
+            _In_ const std::size_t cnt_waveforms,
+            _In_reads_(cnt_channels) const std::uint32_t *channels,
+            _In_ const std::size_t cnt_channels);
+
+        /// <summary>
+        /// Downloads the waveforms of the given channels and maths channels for
+        /// all history segments in memory.
+        /// </summary>
+        /// <remarks>
+        /// This method works like <see cref="history_data(
+        /// oscilloscope_waveform *, const std::size_t, const std::uint32_t *,
+        /// const std::size_t)" />, but each segment additionally comprises the
+        /// waveforms of the maths channels, which are stored after the ones
+        /// of the channels. The waveform of the <c>i</c>th maths channel of
+        /// the <c>s</c>th segment is therefore located at
+        /// <c>s * (cnt_channels + cnt_maths) + cnt_channels + i</c>.
+        /// </remarks>
+        /// <param name="out_waveforms">An array receiving the waveforms. If
+        /// this is <c>nullptr</c> or too small to hold all segments, nothing is
+        /// downloaded.</param>
+        /// <param name="cnt_waveforms">The number of waveforms that can be
+        /// stored in <paramref name="out_waveforms" />.</param>
+        /// <param name="channels">The one-based indices of the channels to be
+        /// retrieved.</param>
+        /// <param name="cnt_channels">The number of elements in
+        /// <paramref name="channels" />.</param>
+        /// <param name="maths">The one-based indices of the maths channels to
+        /// be retrieved.</param>
+        /// <param name="cnt_maths">The number of elements in
+        /// <paramref name="maths" />.</param>
+        /// <returns>The number of waveforms required to hold all segments,
+        /// regardless of whether they have been downloaded.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="channels" /> or <paramref name="maths" /> is
+        /// <c>nullptr</c> while the number of its elements is not zero.
+        /// </exception>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it.</exception>
+        /// <exception cref="visa_exception">If any of the API calls to the
+        /// instrument failed.</exception>
+        /// <exception cref="std::logic_error">If the method is called while
+        /// the library was compiled without support for VISA.</exception>
+        std::size_t history_data(
+            _Out_writes_opt_(cnt_waveforms)
+            oscilloscope_waveform *out_waveforms,
+            _In_ const std::size_t cnt_waveforms,
+            _In_reads_(cnt_channels) const std::uint32_t *channels,
+            _In_ const std::size_t cnt_channels,
+            _In_reads_(cnt_maths) const std::uint32_t *maths,
+            _In_ const std::size_t cnt_maths);
+
+        /// <summary>
+        /// Queries the time at which the currently selected history segment
+        /// has been acquired relative to the newest segment.
+        /// </summary>
+        /// <returns>The offset of the current segment in seconds, which is
+        /// zero for the newest segment and negative for all older ones.
+        /// </returns>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it.</exception>
+        /// <exception cref="visa_exception">If any of the API calls to the
+        /// instrument failed.</exception>
+        /// <exception cref="std::logic_error">If the method is called while
+        /// the library was compiled without support for VISA.</exception>
+        double history_segment_time(void) const;
+
         /// <summary>
         /// Gets the number of history segments currently available in memory.
         /// </summary>
@@ -242,6 +466,38 @@ namespace power_overwhelming {
         /// the library was compiled without support for VISA.</exception>
         std::size_t history_segments(void) const;
 
+        /// <summary>
+        /// Configures the time base, the record length and the decimation of
+        /// the given channels as computed by an acquisition plan.
+        /// </summary>
+        /// <remarks>
+        /// <para>All settings are sent in a single message, and the error
+        /// queue of the instrument is checked only once afterwards.</para>
+        /// <para>The record length is only retained if subsequent single
+        /// acquisitions are configured with the same number of points, ie
+        /// using <see cref="oscilloscope_single_acquisition::points" /> with
+        /// <see cref="oscilloscope_acquisition_plan::points" />.</para>
+        /// <para>This method does nothing if the library has been compiled
+        /// without VISA support.</para>
+        /// </remarks>
+        /// <param name="plan">The acquisition plan to apply.</param>
+        /// <param name="channels">The one-based indices of the channels that
+        /// should use the decimation mode of the plan.</param>
+        /// <param name="cnt">The number of elements in
+        /// <paramref name="channels" />.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="channels" /> is <c>nullptr</c> while
+        /// <paramref name="cnt" /> is not zero.</exception>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it, or if the instrument
+        /// reported an error for any of the settings.</exception>
+        /// <exception cref="visa_exception">If any of the API calls to the
+        /// instrument failed.</exception>
+        rtx_instrument& plan(_In_ const oscilloscope_acquisition_plan& plan,
+            _In_reads_(cnt) const std::uint32_t *channels,
+            _In_ const std::size_t cnt);
+
         /// <summary>
         /// Sets the reference point in the diagram.
         /// </summary>
@@ -271,8 +527,14 @@ namespace power_overwhelming {
         /// <summary>
         /// Configures the trigger.
         /// </summary>
+        /// <remarks>
+        /// All settings are sent in a single message, and the error queue of
+        /// the instrument is checked only once afterwards.
+        /// </remarks>
         /// <param name="trigger">The trigger configuration.</param>
         /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the instrument reported an
+        /// error for any of the settings.</exception>
         rtx_instrument& trigger(_In_ const oscilloscope_trigger& trigger);
 
         /// <summary>
@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include "power_overwhelming/oscilloscope_sensor_definition.h"
 #include "power_overwhelming/sensor.h"
 #include "power_overwhelming/rtx_instrument.h"
 
@@ -12,9 +13,49 @@
 namespace visus {
 namespace power_overwhelming {
 
+    /* Forward declarations. */
+    namespace detail { class rtx_sampler; }
+
+    /// <summary>
+    /// The callback to be invoked for each waveform an oscilloscope has
+    /// downloaded while being sampled asynchronously.
+    /// </summary>
+    /// <remarks>
+    /// <para>The parameters are the interned name of the sensor, the channel
+    /// of the waveform, which is the number of the math channel for the
+    /// power, the index of the segment in the downloaded history, the time of
+    /// the trigger in milliseconds, the waveform itself and the user-defined
+    /// context.</para>
+    /// <para>The waveform is only valid during the call. Callees must copy it
+    /// if they need it afterwards.</para>
+    /// </remarks>
+    typedef void (*oscilloscope_waveform_callback)(
+        _In_z_ const wchar_t *sensor,
+        _In_ const std::uint32_t channel,
+        _In_ const std::uint32_t segment,
+        _In_ const measurement::timestamp_type timestamp,
+        _In_ const oscilloscope_waveform& waveform,
+        _In_opt_ void *context);
+
     /// <summary>
     /// A sensor using a Rohde &amp; Schwarz RTA and RTB series oscilloscope.
     /// </summary>
+    /// <remarks>
+    /// <para>The sensor measures the voltage on one channel and the current
+    /// using a current probe on another one. The power is computed from the
+    /// waveforms of both channels sample by sample.</para>
+    /// <para>If sampled asynchronously, the sensor performs segmented single
+    /// acquisitions on a dedicated thread and delivers all samples of the
+    /// waveforms, which gives a much higher temporal resolution than any other
+    /// sensor. If sampled synchronously, the sensor performs a single
+    /// acquisition and returns the average over its waveforms.</para>
+    /// <para>If the sensor definition specifies a maths channel for the power,
+    /// the instrument computes the power itself and the sensor downloads only
+    /// the waveform of the maths channel, which halves the data transferred
+    /// for each acquisition. The voltage and the current of the samples are
+    /// invalid in this case unless the raw channels have been requested via
+    /// <see cref="oscilloscope_sensor_definition::raw_channels" />.</para>
+    /// </remarks>
     class POWER_OVERWHELMING_API rtx_sensor final : public sensor {
 
     public:
@@ -37,10 +78,27 @@ namespace power_overwhelming {
             _In_ std::size_t cnt_sensors,
             _In_ const std::int32_t timeout = 3000);
 
+        /// <summary>
+        /// The channel measuring the current if no sensor definition is
+        /// provided.
+        /// </summary>
+        static constexpr std::uint32_t default_channel_current = 2;
+
+        /// <summary>
+        /// The channel measuring the voltage if no sensor definition is
+        /// provided.
+        /// </summary>
+        static constexpr std::uint32_t default_channel_voltage = 1;
+
         /// <summary>
         /// Initialises a new instance.
         /// </summary>
-        inline rtx_sensor(void) : _name(nullptr) { }
+        inline rtx_sensor(void)
+            : _channel_current(default_channel_current), _channel_power(0),
+            _channel_voltage(default_channel_voltage), _name(nullptr),
+            _raw_channels(false), _sampler(nullptr),
+            _software_trigger(false), _waveform_callback(nullptr),
+            _waveform_context(nullptr) { }
 
         /// <summary>
         /// Initialises a new instance.
@@ -74,6 +132,52 @@ namespace power_overwhelming {
         rtx_sensor(_In_z_ const wchar_t *path,
             _In_ const visa_instrument::timeout_type timeout);
 
+        /// <summary>
+        /// Initialises a new instance using the channels from the given sensor
+        /// definition.
+        /// </summary>
+        /// <param name="path">The VISA path of the instrument.</param>
+        /// <param name="definition">The definition of the channels measuring
+        /// voltage and current. If the description is not empty, it is used as
+        /// the name of the sensor. If an attenuation is specified, the probe of
+        /// the respective channel is configured accordingly.</param>
+        /// <param name="timeout">The timeout in milliseconds for connecting to
+        /// the instrument.</param>
+        /// <exception cref="std::invalid_argument">If <paramref name="path" />
+        /// is <c>nullptr</c>.</exception>
+        /// <exception cref="std::bad_alloc">If the memory for the sensor state
+        /// could not be allocated.</exception>
+        /// <exception cref="std::system_error">If the VISA library could not be
+        /// loaded.</exception>
+        /// <exception cref="visa_exception">If the sensor could not be
+        /// initialised.</exception>
+        rtx_sensor(_In_z_ const char *path,
+            _In_ const oscilloscope_sensor_definition& definition,
+            _In_ const visa_instrument::timeout_type timeout);
+
+        /// <summary>
+        /// Initialises a new instance using the channels from the given sensor
+        /// definition.
+        /// </summary>
+        /// <param name="path">The VISA path of the instrument.</param>
+        /// <param name="definition">The definition of the channels measuring
+        /// voltage and current. If the description is not empty, it is used as
+        /// the name of the sensor. If an attenuation is specified, the probe of
+        /// the respective channel is configured accordingly.</param>
+        /// <param name="timeout">The timeout in milliseconds for connecting to
+        /// the instrument.</param>
+        /// <exception cref="std::invalid_argument">If <paramref name="path" />
+        /// is <c>nullptr</c>.</exception>
+        /// <exception cref="std::bad_alloc">If the memory for the sensor state
+        /// could not be allocated.</exception>
+        /// <exception cref="std::system_error">If the VISA library could not be
+        /// loaded.</exception>
+        /// <exception cref="visa_exception">If the sensor could not be
+        /// initialised.</exception>
+        rtx_sensor(_In_z_ const wchar_t *path,
+            _In_ const oscilloscope_sensor_definition& definition,
+            _In_ const visa_instrument::timeout_type timeout);
+
         /// <summary>
         /// Move <paramref name="rhs" /> into a new instance.
         /// </summary>
@@ -85,6 +189,32 @@ namespace power_overwhelming {
         /// </summary>
         virtual ~rtx_sensor(void);
 
+        /// <summary>
+        /// Gets the channel measuring the current.
+        /// </summary>
+        /// <returns>The one-based index of the current channel.</returns>
+        inline std::uint32_t channel_current(void) const noexcept {
+            return this->_channel_current;
+        }
+
+        /// <summary>
+        /// Gets the maths channel computing the power on the instrument.
+        /// </summary>
+        /// <returns>The one-based index of the maths channel, or zero if the
+        /// power is computed from the waveforms of the voltage and the current
+        /// channel.</returns>
+        inline std::uint32_t channel_power(void) const noexcept {
+            return this->_channel_power;
+        }
+
+        /// <summary>
+        /// Gets the channel measuring the voltage.
+        /// </summary>
+        /// <returns>The one-based index of the voltage channel.</returns>
+        inline std::uint32_t channel_voltage(void) const noexcept {
+            return this->_channel_voltage;
+        }
+
         /// <summary>
         /// Gets the name of the sensor.
         /// </summary>
@@ -107,6 +237,40 @@ namespace power_overwhelming {
 
         using sensor::sample;
 
+        /// <inheritdoc />
+        /// <remarks>
+        /// <para>The sensor is sampled on a dedicated thread, which issues
+        /// segmented single acquisitions at most every
+        /// <paramref name="period" /> microseconds and delivers the samples of
+        /// each segment as one batch. The period only limits the rate of the
+        /// acquisitions, whereas the spacing of the samples is determined by
+        /// the time base of the instrument.</para>
+        /// <para>The next acquisition is armed as soon as the waveforms of
+        /// the previous one have been downloaded, and the samples are
+        /// delivered from a second thread while the instrument is capturing.
+        /// Therefore, the callback does not reduce the duty cycle of the
+        /// instrument unless it takes longer than an acquisition.</para>
+        /// <para>The sensor can be moved while being sampled, but the
+        /// instrument must not be used otherwise.</para>
+        /// </remarks>
+        /// <exception cref="std::logic_error">If the sensor is already being
+        /// sampled asynchronously.</exception>
+        virtual void sample_batch(
+            _In_opt_ const measurement_data_callback on_batch,
+            _In_ const microseconds_type period = default_sampling_period,
+            _In_opt_ void *context = nullptr) override;
+
+        /// <summary>
+        /// Answer whether the acquisitions of the sensor are triggered by
+        /// software.
+        /// </summary>
+        /// <returns><c>true</c> if the sensor has been created with
+        /// <see cref="oscilloscope_sensor_definition::software_trigger" />
+        /// enabled, <c>false</c> otherwise.</returns>
+        inline bool software_trigger(void) const noexcept {
+            return this->_software_trigger;
+        }
+
         /// <summary>
         /// Synchonises the date and time on the instrument with the system
         /// clock of the computer calling this API.
@@ -123,11 +287,59 @@ namespace power_overwhelming {
             return *this;
         }
 
+        /// <summary>
+        /// Sends a software trigger to the instrument.
+        /// </summary>
+        /// <remarks>
+        /// <para>If the sensor is being sampled asynchronously, the trigger is
+        /// sent by an asynchronous VISA write and the method returns
+        /// immediately. If the sensor uses a
+        /// <see cref="oscilloscope_sensor_definition::software_trigger" />,
+        /// the samples of the acquisition are aligned to the midpoint between
+        /// the start and the completion of this write. The instrument can only
+        /// accept a trigger while it is armed, ie triggers arriving faster than
+        /// the instrument captures and downloads an acquisition are dropped.
+        /// </para>
+        /// <para>If the sensor is not being sampled asynchronously, the trigger
+        /// is written synchronously.</para>
+        /// </remarks>
+        /// <returns><c>true</c> if the trigger has been sent, <c>false</c> if
+        /// it has been dropped.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it.</exception>
+        /// <exception cref="visa_exception">If the VISA command was not
+        /// processed successfully.</exception>
+        /// <exception cref="std::logic_error">If the method is called while
+        /// the library was compiled without support for VISA.</exception>
+        bool trigger(void);
+
         /// <summary>
         /// Move assignment.
         /// </summary>
         /// <param name="rhs">The right-hand side operand</param>
         /// <returns><c>*this</c></returns>
+        /// <summary>
+        /// Sets a callback that receives the complete waveforms downloaded
+        /// while the sensor is sampled asynchronously.
+        /// </summary>
+        /// <remarks>
+        /// The callback is invoked on the delivery thread of the sensor before
+        /// the samples computed from the same waveforms are delivered. It
+        /// takes effect the next time asynchronous sampling is started.
+        /// </remarks>
+        /// <param name="callback">The callback, or <c>nullptr</c> to discard
+        /// the waveforms.</param>
+        /// <param name="context">A user-defined context pointer that is passed
+        /// on to <paramref name="callback" />.</param>
+        /// <returns><c>*this</c>.</returns>
+        inline rtx_sensor& waveform_callback(
+                _In_opt_ const oscilloscope_waveform_callback callback,
+                _In_opt_ void *context = nullptr) noexcept {
+            this->_waveform_callback = callback;
+            this->_waveform_context = context;
+            return *this;
+        }
+
         rtx_sensor& operator =(_Inout_ rtx_sensor&& rhs) noexcept;
 
         /// <summary>
@@ -149,10 +361,18 @@ namespace power_overwhelming {
 
     private:
 
-        void initialise(void);
+        void initialise(_In_ const oscilloscope_sensor_definition& definition);
 
+        std::uint32_t _channel_current;
+        std::uint32_t _channel_power;
+        std::uint32_t _channel_voltage;
         rtx_instrument _instrument;
         wchar_t *_name;
+        bool _raw_channels;
+        detail::rtx_sampler *_sampler;
+        bool _software_trigger;
+        oscilloscope_waveform_callback _waveform_callback;
+        void *_waveform_context;
     };
 
 } /* namespace power_overwhelming */
@@ -0,0 +1,132 @@
+﻿// <copyright file="sample_filter.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstddef>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+#include "power_overwhelming/sample_filter_type.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// Describes a filter that a <see cref="collector" /> applies to the
+    /// samples of a sensor while recording them.
+    /// </summary>
+    /// <remarks>
+    /// The filters operate on the sequence of samples rather than on their
+    /// timestamps, i.e. they assume that the sensor is sampled at an
+    /// approximately constant rate. Voltage, current and power are filtered
+    /// independently.
+    /// </remarks>
+    class POWER_OVERWHELMING_API sample_filter final {
+
+    public:
+
+        /// <summary>
+        /// Creates an exponential moving average.
+        /// </summary>
+        /// <param name="alpha">The weight of each new sample, which must be
+        /// within (0, 1]. Smaller values smooth more.</param>
+        /// <returns>The description of the filter.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="alpha" /> is out of range.</exception>
+        static sample_filter exponential(_In_ const float alpha);
+
+        /// <summary>
+        /// Creates a windowed-sinc FIR low-pass filter.
+        /// </summary>
+        /// <param name="taps">The length of the kernel, which must be an odd
+        /// number of at least three. The output lags
+        /// <c>taps / 2</c> samples behind the input.</param>
+        /// <param name="cutoff">The cut-off frequency relative to the
+        /// sampling rate, which must be within (0, 0.5).</param>
+        /// <returns>The description of the filter.</returns>
+        /// <exception cref="std::invalid_argument">If any of the parameters
+        /// is out of range.</exception>
+        static sample_filter low_pass(_In_ const std::size_t taps,
+            _In_ const float cutoff);
+
+        /// <summary>
+        /// Creates a running median.
+        /// </summary>
+        /// <param name="window">The number of samples in the window, which
+        /// must be an odd number of at least three. The output lags
+        /// <c>window / 2</c> samples behind the input.</param>
+        /// <returns>The description of the filter.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="window" /> is out of range.</exception>
+        static sample_filter median(_In_ const std::size_t window);
+
+        /// <summary>
+        /// Initialises a new instance that does not filter.
+        /// </summary>
+        sample_filter(void) noexcept;
+
+        /// <summary>
+        /// Gets the weight of new samples for an exponential moving average.
+        /// </summary>
+        /// <returns>The weight, or zero for other types of filters.</returns>
+        inline float alpha(void) const noexcept {
+            return (this->_type == sample_filter_type::exponential)
+                ? this->_parameter
+                : 0.0f;
+        }
+
+        /// <summary>
+        /// Gets the relative cut-off frequency of a low-pass filter.
+        /// </summary>
+        /// <returns>The cut-off frequency, or zero for other types of
+        /// filters.</returns>
+        inline float cutoff(void) const noexcept {
+            return (this->_type == sample_filter_type::low_pass)
+                ? this->_parameter
+                : 0.0f;
+        }
+
+        /// <summary>
+        /// Gets the type of the filter.
+        /// </summary>
+        /// <returns>The type of the filter.</returns>
+        inline sample_filter_type type(void) const noexcept {
+            return this->_type;
+        }
+
+        /// <summary>
+        /// Gets the number of samples the filter combines into an output.
+        /// </summary>
+        /// <returns>The size of the window or the number of taps of the
+        /// kernel, which is one for filters that do not have a window.
+        /// </returns>
+        inline std::size_t window(void) const noexcept {
+            return this->_window;
+        }
+
+        /// <summary>
+        /// Answer whether the filter changes the samples.
+        /// </summary>
+        /// <returns><c>true</c> if the type is not
+        /// <see cref="sample_filter_type::none" />, <c>false</c> otherwise.
+        /// </returns>
+        inline operator bool(void) const noexcept {
+            return (this->_type != sample_filter_type::none);
+        }
+
+    private:
+
+        sample_filter(_In_ const sample_filter_type type,
+            _In_ const std::size_t window,
+            _In_ const float parameter) noexcept;
+
+        float _parameter;
+        sample_filter_type _type;
+        std::size_t _window;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
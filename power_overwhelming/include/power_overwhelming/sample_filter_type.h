@@ -0,0 +1,44 @@
+﻿// <copyright file="sample_filter_type.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// Specifies how a <see cref="sample_filter" /> smoothes the samples of a
+    /// sensor.
+    /// </summary>
+    enum class sample_filter_type {
+
+        /// <summary>
+        /// The samples are not filtered.
+        /// </summary>
+        none,
+
+        /// <summary>
+        /// Each sample is replaced by the median of the window centred on it,
+        /// which rejects isolated outliers while retaining steps.
+        /// </summary>
+        median,
+
+        /// <summary>
+        /// Each sample is replaced by the exponential moving average of all
+        /// samples up to it.
+        /// </summary>
+        exponential,
+
+        /// <summary>
+        /// The samples are convolved with a linear-phase FIR low-pass filter,
+        /// whose delay is compensated by assigning each output the timestamp
+        /// of the sample in the centre of the kernel.
+        /// </summary>
+        low_pass
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
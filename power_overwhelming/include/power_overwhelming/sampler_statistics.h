@@ -0,0 +1,210 @@
+﻿// <copyright file="sampler_statistics.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+
+#include "power_overwhelming/latency_histogram.h"
+#include "power_overwhelming/sensor.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    namespace detail { struct sampler_statistics_impl; }
+
+    /// <summary>
+    /// A snapshot of how well a sampler context kept time.
+    /// </summary>
+    /// <remarks>
+    /// <para>Each sampler context that is run by the library's sampler
+    /// threads, ie each combination of a sensor family sampled without an
+    /// asynchronous API of its own and a sampling interval, continuously
+    /// records how late its ticks started, how long obtaining the samples
+    /// from each source and invoking the user-defined callbacks took, as
+    /// well as how many ticks took longer than the sampling interval. This
+    /// allows for stating the timing uncertainty of measurements and for
+    /// identifying slow sensors.</para>
+    /// <para>Sensors with threads of their own, like Tinkerforge bricklets,
+    /// and sensors sampled by external instruments are not covered.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API sampler_statistics final {
+
+    public:
+
+        /// <summary>
+        /// The type used to specify sampling intervals in microseconds.
+        /// </summary>
+        typedef sensor::microseconds_type interval_type;
+
+        /// <summary>
+        /// Retrieves the statistics of all sampler contexts that have
+        /// performed at least one tick since they have been created or
+        /// since the last call to <see cref="reset_all" />.
+        /// </summary>
+        /// <param name="out_statistics">An array receiving the statistics.
+        /// It is safe to pass <c>nullptr</c>.</param>
+        /// <param name="cnt_statistics">The number of elements that can be
+        /// stored in <paramref name="out_statistics" />.</param>
+        /// <returns>The number of sampler contexts, which might be larger
+        /// than <paramref name="cnt_statistics" />.</returns>
+        static std::size_t for_all(
+            _Out_writes_opt_(cnt_statistics) sampler_statistics *out_statistics,
+            _In_ const std::size_t cnt_statistics);
+
+        /// <summary>
+        /// Restarts the statistics of all sampler contexts.
+        /// </summary>
+        static void reset_all(void) noexcept;
+
+        /// <summary>
+        /// Initialises a new, empty instance.
+        /// </summary>
+        sampler_statistics(void);
+
+        /// <summary>
+        /// Clone <paramref name="rhs" />.
+        /// </summary>
+        /// <param name="rhs">The object to be cloned.</param>
+        sampler_statistics(_In_ const sampler_statistics& rhs);
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        sampler_statistics(_Inout_ sampler_statistics&& rhs) noexcept;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~sampler_statistics(void);
+
+        /// <summary>
+        /// Answer the time the user-defined callbacks took.
+        /// </summary>
+        /// <returns>The durations of the callbacks.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed by a move.</exception>
+        const latency_histogram& callback_duration(void) const;
+
+        /// <summary>
+        /// Answer the sampling interval of the context.
+        /// </summary>
+        /// <returns>The sampling interval in microseconds.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed by a move.</exception>
+        interval_type interval(void) const;
+
+        /// <summary>
+        /// Answer the time between the instants the ticks were due and the
+        /// instants they actually started.
+        /// </summary>
+        /// <returns>The lateness of the ticks.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed by a move.</exception>
+        const latency_histogram& jitter(void) const;
+
+        /// <summary>
+        /// Answer the number of deadlines that have been skipped, because
+        /// the ticks before took too long.
+        /// </summary>
+        /// <returns>The number of skipped ticks.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed by a move.</exception>
+        std::uint64_t missed_deadlines(void) const;
+
+        /// <summary>
+        /// Answer the number of ticks that took longer than the sampling
+        /// interval.
+        /// </summary>
+        /// <returns>The number of overruns.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed by a move.</exception>
+        std::uint64_t overruns(void) const;
+
+        /// <summary>
+        /// Answer the time it took to obtain the samples from the given
+        /// source.
+        /// </summary>
+        /// <param name="index">The index of the source, which must be less
+        /// than <see cref="sources" />.</param>
+        /// <returns>The durations of obtaining a sample.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed by a move.</exception>
+        /// <exception cref="std::out_of_range">If <paramref name="index" />
+        /// is not a valid source.</exception>
+        const latency_histogram& sample_duration(
+            _In_ const std::size_t index) const;
+
+        /// <summary>
+        /// Answer the name of the given source.
+        /// </summary>
+        /// <remarks>
+        /// A source is typically a sensor. Sensors that are read together,
+        /// like all channels of an EMI device, share the duration of the
+        /// read.
+        /// </remarks>
+        /// <param name="index">The index of the source, which must be less
+        /// than <see cref="sources" />.</param>
+        /// <returns>The name of the source.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed by a move.</exception>
+        /// <exception cref="std::out_of_range">If <paramref name="index" />
+        /// is not a valid source.</exception>
+        _Ret_z_ const wchar_t *source(_In_ const std::size_t index) const;
+
+        /// <summary>
+        /// Answer the number of sources that have been sampled by the
+        /// context.
+        /// </summary>
+        /// <returns>The number of sources.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed by a move.</exception>
+        std::size_t sources(void) const;
+
+        /// <summary>
+        /// Answer the number of ticks the context has performed.
+        /// </summary>
+        /// <returns>The number of ticks.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed by a move.</exception>
+        std::uint64_t ticks(void) const;
+
+        /// <summary>
+        /// Assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        sampler_statistics& operator =(_In_ const sampler_statistics& rhs);
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        sampler_statistics& operator =(
+            _Inout_ sampler_statistics&& rhs) noexcept;
+
+        /// <summary>
+        /// Determines whether the object is valid.
+        /// </summary>
+        /// <remarks>
+        /// The object is only invalid if it has been disposed by a move.
+        /// </remarks>
+        /// <returns><c>true</c> if the object is valid, <c>false</c>
+        /// otherwise.</returns>
+        operator bool(void) const noexcept;
+
+    private:
+
+        const detail::sampler_statistics_impl& check_not_disposed(void) const;
+
+        detail::sampler_statistics_impl *_impl;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
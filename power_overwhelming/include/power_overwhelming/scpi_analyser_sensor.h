@@ -0,0 +1,309 @@
+﻿// <copyright file="scpi_analyser_sensor.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "power_overwhelming/sensor.h"
+#include "power_overwhelming/visa_instrument.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations. */
+    namespace detail { struct scpi_analyser_descriptor; }
+    namespace detail { class scpi_sampler; }
+
+    /// <summary>
+    /// A power analyser speaking SCPI, which is configured and queried as
+    /// described by a JSON descriptor rather than by code specific to the
+    /// instrument.
+    /// </summary>
+    /// <remarks>
+    /// <para>The descriptor is a JSON object specifying the query retrieving a
+    /// sample, the position of voltage, current and power in the
+    /// comma-separated response and, optionally, the commands configuring the
+    /// instrument and controlling its integrator. For instance, a Yokogawa
+    /// WT310 could be described as follows:</para>
+    /// <code>
+    /// {
+    ///     "name": "WT310",
+    ///     "vendor": "0x0B21",
+    ///     "product": "0x0025",
+    ///     "identity": "WT310",
+    ///     "setup": [
+    ///         ":NUM:FORM ASC",
+    ///         ":NUM:NORM:NUM 4",
+    ///         ":NUM:NORM:ITEM1 U,1",
+    ///         ":NUM:NORM:ITEM2 I,1",
+    ///         ":NUM:NORM:ITEM3 P,1",
+    ///         ":NUM:NORM:ITEM4 WH,1"
+    ///     ],
+    ///     "teardown": [ ":COMM:REM OFF" ],
+    ///     "query": ":NUM:NORM:VAL?",
+    ///     "fields": { "voltage": 0, "current": 1, "power": 2 },
+    ///     "integrator": {
+    ///         "start": ":INTEG:STAR",
+    ///         "stop": ":INTEG:STOP",
+    ///         "reset": ":INTEG:RES",
+    ///         "energy": ":NUM:NORM:VAL? 4",
+    ///         "energy_scale": 3600
+    ///     }
+    /// }
+    /// </code>
+    /// <para>Only <c>query</c> and the position of the <c>power</c> are
+    /// mandatory. If the descriptor does not specify both, voltage and
+    /// current, samples only report the power.</para>
+    /// <para>The sensor uses the same pipelined sampler thread and
+    /// zero-allocation response parser as the <see cref="hmc8015_sensor" />.
+    /// </para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API scpi_analyser_sensor final : public sensor {
+
+    public:
+
+        /// <summary>
+        /// Create sensor objects for all instruments matching the given
+        /// descriptor that can be enumerated via VISA.
+        /// </summary>
+        /// <remarks>
+        /// USB instruments are found by the <c>vendor</c> and <c>product</c>
+        /// in the descriptor, network instruments by the response to
+        /// <c>*IDN?</c> containing the <c>identity</c> in the descriptor. If
+        /// the descriptor does not specify a vendor and a product, only
+        /// network instruments are considered.
+        /// </remarks>
+        /// <param name="out_sensors">An array receiving the sensors. If this is
+        /// <c>nullptr</c>, nothing is returned.</param>
+        /// <param name="cnt_sensors">The number of sensors that can be stored in
+        /// <paramref name="out_sensors" />.</param>
+        /// <param name="descriptor">The JSON descriptor of the instrument.
+        /// </param>
+        /// <param name="timeout">The timeout in milliseconds for establishing a
+        /// connection to each instrument that was found. This parameter defaults
+        /// to 3000.</param>
+        /// <returns>The number of matching instruments found, regardless of how
+        /// many have been returned to <paramref name="out_sensors" />.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="descriptor" /> is not valid.</exception>
+        static std::size_t for_all(
+            _Out_writes_opt_(cnt_sensors) scpi_analyser_sensor *out_sensors,
+            _In_ std::size_t cnt_sensors,
+            _In_z_ const char *descriptor,
+            _In_ const std::int32_t timeout = 3000);
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        scpi_analyser_sensor(void);
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="path">The VISA path to the instrument.</param>
+        /// <param name="descriptor">The JSON descriptor of the instrument.
+        /// </param>
+        /// <param name="timeout">The timeout in milliseconds for connecting to
+        /// the instrument.</param>
+        /// <exception cref="std::invalid_argument">If <paramref name="path" />
+        /// is <c>nullptr</c> or if <paramref name="descriptor" /> is not valid.
+        /// </exception>
+        /// <exception cref="std::bad_alloc">If the memory for the sensor state
+        /// could not be allocated.</exception>
+        /// <exception cref="std::system_error">If the VISA library could not be
+        /// loaded.</exception>
+        /// <exception cref="visa_exception">If the instrument could not be
+        /// configured.</exception>
+        scpi_analyser_sensor(_In_z_ const wchar_t *path,
+            _In_z_ const char *descriptor,
+            _In_ const visa_instrument::timeout_type timeout);
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="path">The VISA path to the instrument.</param>
+        /// <param name="descriptor">The JSON descriptor of the instrument.
+        /// </param>
+        /// <param name="timeout">The timeout in milliseconds for connecting to
+        /// the instrument.</param>
+        /// <exception cref="std::invalid_argument">If <paramref name="path" />
+        /// is <c>nullptr</c> or if <paramref name="descriptor" /> is not valid.
+        /// </exception>
+        /// <exception cref="std::bad_alloc">If the memory for the sensor state
+        /// could not be allocated.</exception>
+        /// <exception cref="std::system_error">If the VISA library could not be
+        /// loaded.</exception>
+        /// <exception cref="visa_exception">If the instrument could not be
+        /// configured.</exception>
+        scpi_analyser_sensor(_In_z_ const char *path,
+            _In_z_ const char *descriptor,
+            _In_ const visa_instrument::timeout_type timeout);
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        scpi_analyser_sensor(_Inout_ scpi_analyser_sensor&& rhs) noexcept;
+
+        /// <summary>
+        /// Finalise the instance.
+        /// </summary>
+        /// <remarks>
+        /// The destructor stops asynchronous sampling and sends the
+        /// <c>teardown</c> commands from the descriptor to the instrument.
+        /// </remarks>
+        virtual ~scpi_analyser_sensor(void);
+
+        /// <summary>
+        /// Answer the name of the instrument type from the descriptor.
+        /// </summary>
+        /// <returns>The name of the instrument type, which is empty if the
+        /// descriptor does not specify it or if the sensor has been disposed.
+        /// </returns>
+        _Ret_z_ const char *instrument_type(void) const noexcept;
+
+        /// <summary>
+        /// Queries the energy accumulated by the integrator of the instrument.
+        /// </summary>
+        /// <remarks>
+        /// This must not happen while the sensor is sampled asynchronously.
+        /// </remarks>
+        /// <returns>The energy accumulated by the integrator in Joules.
+        /// </returns>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it or if the response of the
+        /// instrument could not be parsed.</exception>
+        /// <exception cref="std::logic_error">If the descriptor does not
+        /// specify how to query the integrated energy.</exception>
+        /// <exception cref="visa_exception">If the VISA command was not
+        /// processed successfully.</exception>
+        double integrated_energy(void);
+
+        /// <inheritdoc />
+        _Ret_maybenull_z_ virtual const wchar_t *name(
+            void) const noexcept override;
+
+        /// <summary>
+        /// Gets the VISA path of the instrument.
+        /// </summary>
+        /// <returns>The path of the instrument, which is <c>nullptr</c> if the
+        /// sensor has been disposed.</returns>
+        inline _Ret_maybenull_z_ const char *path(void) const noexcept {
+            return this->_instrument.path();
+        }
+
+        /// <summary>
+        /// Resets the energy accumulated by the integrator to zero.
+        /// </summary>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it.</exception>
+        /// <exception cref="std::logic_error">If the descriptor does not
+        /// specify a command for this operation.</exception>
+        /// <exception cref="visa_exception">If the VISA command was not
+        /// processed successfully.</exception>
+        scpi_analyser_sensor& reset_integrator(void);
+
+        using sensor::sample;
+
+        /// <summary>
+        /// Asynchronously sample the instrument as fast as possible, but not
+        /// faster than every <paramref name="period" /> microseconds.
+        /// </summary>
+        /// <remarks>
+        /// <para>Each instrument is streamed on its own thread, which sends the
+        /// next query as soon as the previous response has been received and
+        /// before it is processed. The samples are timestamped with the
+        /// midpoint of the round trip of their query and delivered on their
+        /// own as soon as they have been received.</para>
+        /// <para>The sensor can be moved while it is being sampled. However,
+        /// the instrument must not be used for anything else while it is being
+        /// sampled asynchronously.</para>
+        /// <para>Queries that fail, for instance because the instrument does
+        /// not answer in time, are silently skipped.</para>
+        /// </remarks>
+        /// <param name="on_batch">The callback to be invoked if new data
+        /// arrived. If this is <c>nullptr</c>, the asynchronous sampling will
+        /// be disabled.</param>
+        /// <param name="period">The minimum sampling period in microseconds.
+        /// This parameter defaults to 1 millisecond.</param>
+        /// <param name="context">A user-defined context pointer that is passed
+        /// on to <see cref="on_batch" />. This parameter defaults to
+        /// <c>nullptr</c>.</para>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        /// <exception cref="std::logic_error">If the sensor is already being
+        /// sampled asynchronously.</exception>
+        virtual void sample_batch(
+            _In_opt_ const measurement_data_callback on_batch,
+            _In_ const microseconds_type period = default_sampling_period,
+            _In_opt_ void *context = nullptr) override;
+
+        /// <summary>
+        /// Starts accumulating energy in the integrator.
+        /// </summary>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it.</exception>
+        /// <exception cref="std::logic_error">If the descriptor does not
+        /// specify a command for this operation.</exception>
+        /// <exception cref="visa_exception">If the VISA command was not
+        /// processed successfully.</exception>
+        scpi_analyser_sensor& start_integrator(void);
+
+        /// <summary>
+        /// Stops accumulating energy in the integrator.
+        /// </summary>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it.</exception>
+        /// <exception cref="std::logic_error">If the descriptor does not
+        /// specify a command for this operation.</exception>
+        /// <exception cref="visa_exception">If the VISA command was not
+        /// processed successfully.</exception>
+        scpi_analyser_sensor& stop_integrator(void);
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand</param>
+        /// <returns><c>*this</c></returns>
+        scpi_analyser_sensor& operator =(
+            _Inout_ scpi_analyser_sensor&& rhs) noexcept;
+
+        /// <summary>
+        /// Determines whether the sensor is valid.
+        /// </summary>
+        /// <remarks>
+        /// A sensor is considered valid until it has been disposed by a move
+        /// operation.
+        /// </remarks>
+        /// <returns><c>true</c> if the sensor is valid, <c>false</c>
+        /// otherwise.</returns>
+        virtual operator bool(void) const noexcept override;
+
+    protected:
+
+        /// <inheritdoc />
+        measurement_data sample_sync(
+            _In_ const timestamp_resolution resolution) const override;
+
+    private:
+
+        void execute(_In_z_ const char *command);
+
+        void initialise(void);
+
+        detail::scpi_analyser_descriptor *_descriptor;
+        visa_instrument _instrument;
+        wchar_t *_name;
+        detail::scpi_sampler *_sampler;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
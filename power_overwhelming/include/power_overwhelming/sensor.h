@@ -31,6 +31,47 @@ namespace power_overwhelming {
         /// </summary>
         static constexpr microseconds_type default_sampling_period = 1000;
 
+        /// <summary>
+        /// Starts asynchronous sampling of all given sensors at once.
+        /// </summary>
+        /// <remarks>
+        /// <para>The sensors are started in two phases: First, all sensors are
+        /// prepared via their <see cref="sample_batch" /> methods, while the
+        /// sampler threads of the library are held back. Second, all sampler
+        /// threads are released at the same instant and take their first
+        /// sample on a common tick. Sensors that deliver samples via callbacks
+        /// of an external API, like Tinkerforge bricklets, cannot be held back
+        /// and might deliver samples before the release.</para>
+        /// <para>The operation is transactional: if any of the sensors cannot
+        /// be started, the sensors that have already been started are stopped
+        /// before the exception is rethrown.</para>
+        /// </remarks>
+        /// <param name="sensors">The sensors to be started. It is safe to pass
+        /// <c>nullptr</c> if <paramref name="cnt" /> is zero. Elements that
+        /// are <c>nullptr</c> are skipped.</param>
+        /// <param name="cnt">The number of elements in
+        /// <paramref name="sensors" />.</param>
+        /// <param name="on_batch">The callback to be invoked if new data
+        /// arrived.</param>
+        /// <param name="period">The desired sampling period in
+        /// microseconds.</param>
+        /// <param name="context">A user-defined context pointer that is passed
+        /// on to <see cref="on_batch" />.</param>
+        /// <param name="latencies">If not <c>nullptr</c>, receives the time in
+        /// microseconds it took to prepare each of the sensors. The array must
+        /// be able to hold at least <paramref name="cnt" /> elements. Elements
+        /// for sensors that are <c>nullptr</c> are set to zero.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="on_batch" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::logic_error">If any of the sensors is already
+        /// being sampled asynchronously.</exception>
+        static void sample_all(_In_reads_(cnt) sensor *const *sensors,
+            _In_ const std::size_t cnt,
+            _In_ const measurement_data_callback on_batch,
+            _In_ const microseconds_type period = default_sampling_period,
+            _In_opt_ void *context = nullptr,
+            _Out_writes_opt_(cnt) microseconds_type *latencies = nullptr);
+
         /// <summary>
         /// Finalises the instance.
         /// </summary>
@@ -50,6 +91,28 @@ namespace power_overwhelming {
         /// disposed.</returns>
         virtual _Ret_maybenull_z_ const wchar_t *name(void) const noexcept = 0;
 
+        /// <summary>
+        /// Answer the interval at which the source of the sensor produces new
+        /// data.
+        /// </summary>
+        /// <remarks>
+        /// <para>Sampling a sensor faster than its native update interval
+        /// only yields duplicate readings at the expense of CPU time. Sensors
+        /// that know their interval from their configuration, like
+        /// Tinkerforge bricklets or the PMLog of ADL, report this interval.
+        /// Sensors with an undocumented update rate, like NVML and EMI,
+        /// determine the interval empirically by polling the source for a
+        /// short time when the method is first called, which may take up to
+        /// a second.</para>
+        /// <para>The default implementation returns zero.</para>
+        /// </remarks>
+        /// <returns>The native update interval in microseconds, or zero if it
+        /// is unknown or if the sensor produces new data whenever it is
+        /// sampled.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been
+        /// disposed.</exception>
+        virtual microseconds_type native_interval(void) const;
+
         /// <summary>
         /// Sample the sensor using a timestamp with the specified resolution.
         /// </summary>
@@ -73,6 +136,86 @@ namespace power_overwhelming {
         measurement sample(_In_ const timestamp_resolution resolution
             = timestamp_resolution::milliseconds) const;
 
+        /// <summary>
+        /// Asynchronously sample the sensor every
+        /// <paramref name="sampling_period "/> microseconds and deliver the
+        /// samples in batches.
+        /// </summary>
+        /// <remarks>
+        /// <para>This is the common entry point for asynchronous sampling that
+        /// all sensors support. Sensors with an asynchronous API or a
+        /// specialised sampler thread override this method. The default
+        /// implementation samples the sensor via <see cref="sample_sync" /> on
+        /// a generic sampler thread. In this case, the sensor must not be moved
+        /// while it is being sampled asynchronously, and the samples are
+        /// delivered with a latency of up to ten milliseconds.</para>
+        /// <para>Samples that have not yet been delivered when the sampling is
+        /// stopped are delivered on the thread disabling the asynchronous
+        /// sampling.</para>
+        /// <para>The default implementation and the sensors using a generic
+        /// sampler thread of the library accept multiple subscribers that are
+        /// distinguished by their <paramref name="context" />, which must not
+        /// be <c>nullptr</c> in this case. If the period of a subscriber is a
+        /// multiple of the period of an existing one, both are served from the
+        /// same read of the hardware. Disabling the sampling with a
+        /// non-<c>nullptr</c> <paramref name="context" /> only removes this
+        /// subscriber.</para>
+        /// </remarks>
+        /// <param name="on_batch">The callback to be invoked if new data
+        /// arrived. If this is <c>nullptr</c>, the asynchronous sampling will
+        /// be disabled.</param>
+        /// <param name="period">The desired sampling period in
+        /// microseconds. This parameter defaults to 1 millisecond.</param>
+        /// <param name="context">A user-defined context pointer that is passed
+        /// on to <see cref="on_batch" />. This parameter defaults to
+        /// <c>nullptr</c>.</para>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        /// <exception cref="std::logic_error">If the sensor is already being
+        /// sampled asynchronously for the same <paramref name="context" /> or
+        /// without a context.</exception>
+        virtual void sample_batch(
+            _In_opt_ const measurement_data_callback on_batch,
+            _In_ const microseconds_type period = default_sampling_period,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Asynchronously sample the sensor at a rate that adapts to how fast
+        /// its signal changes and deliver the samples in batches.
+        /// </summary>
+        /// <remarks>
+        /// <para>The sensor is sampled every <paramref name="max_period" />
+        /// microseconds while its power is stable. During transients, the
+        /// rate is raised up to one sample every
+        /// <paramref name="min_period" /> microseconds until the signal has
+        /// settled again. Each sample carries its own timestamp, so the
+        /// instantaneous rate is the difference between consecutive
+        /// timestamps.</para>
+        /// <para>Only sensors on the generic sampler threads of the library,
+        /// like the RAPL sensors, adapt their rate. The default
+        /// implementation samples at the fixed <paramref name="max_period" />
+        /// via <see cref="sample_batch" />, which is also used to stop the
+        /// sampling.</para>
+        /// </remarks>
+        /// <param name="on_batch">The callback to be invoked if new data
+        /// arrived. If this is <c>nullptr</c>, the asynchronous sampling will
+        /// be disabled.</param>
+        /// <param name="min_period">The shortest sampling period in
+        /// microseconds.</param>
+        /// <param name="max_period">The longest sampling period in
+        /// microseconds, which is used initially.</param>
+        /// <param name="context">A user-defined context pointer that is passed
+        /// on to <see cref="on_batch" />.</param>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        /// <exception cref="std::logic_error">If the sensor is already being
+        /// sampled asynchronously.</exception>
+        virtual void sample_adaptive(
+            _In_opt_ const measurement_data_callback on_batch,
+            _In_ const microseconds_type min_period,
+            _In_ const microseconds_type max_period,
+            _In_opt_ void *context = nullptr);
+
         /// <summary>
         /// Sample the sensor using a timestamp with the specified resolution,
         /// but do not attach the sensor that produces the data to the sample.
@@ -153,6 +296,44 @@ namespace power_overwhelming {
         /// (and therefore disposed) is sampled.</exception>
         void check_not_disposed(void) const;
 
+        /// <summary>
+        /// Samples the sensor adaptively on the generic sampler threads.
+        /// </summary>
+        /// <remarks>
+        /// Sensors that are sampled by the default implementation of
+        /// <see cref="sample_batch" /> can implement
+        /// <see cref="sample_adaptive" /> using this method.
+        /// </remarks>
+        /// <param name="on_batch">The callback to be invoked if new data
+        /// arrived. If this is <c>nullptr</c>, the asynchronous sampling will
+        /// be disabled.</param>
+        /// <param name="min_period">The shortest sampling period in
+        /// microseconds.</param>
+        /// <param name="max_period">The longest sampling period in
+        /// microseconds.</param>
+        /// <param name="context">A user-defined context pointer that is passed
+        /// on to <see cref="on_batch" />.</param>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        /// <exception cref="std::logic_error">If the sensor is already being
+        /// sampled asynchronously.</exception>
+        void sample_adaptive_sync(
+            _In_opt_ const measurement_data_callback on_batch,
+            _In_ const microseconds_type min_period,
+            _In_ const microseconds_type max_period,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// Throws the <see cref="std::runtime_error" /> indicating that a
+        /// disposed sensor has been used.
+        /// </summary>
+        /// <remarks>
+        /// Final sensor classes can use this method to implement the check
+        /// of <see cref="check_not_disposed" /> without a virtual call.
+        /// </remarks>
+        /// <exception cref="std::runtime_error">Always.</exception>
+        static void throw_disposed(void);
+
         /// <summary>
         /// Synchronously sample the sensor using a timestamp with the specified
         /// resolution.
@@ -0,0 +1,79 @@
+﻿// <copyright file="sensor_channel.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "power_overwhelming/measurement_quantity.h"
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// Describes one of the values that a
+    /// <see cref="multi_channel_sensor" /> delivers on each read.
+    /// </summary>
+    /// <remarks>
+    /// The strings are owned by the sensor and remain valid as long as the
+    /// sensor exists.
+    /// </remarks>
+    class POWER_OVERWHELMING_API sensor_channel final {
+
+    public:
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="name">The name of the channel, which is used like the
+        /// name of a sensor for the samples of the channel.</param>
+        /// <param name="unit">The unit of the values, for instance
+        /// <c>W</c>.</param>
+        /// <param name="quantity">The quantity measured by the channel.
+        /// </param>
+        inline sensor_channel(_In_opt_z_ const wchar_t *name,
+                _In_opt_z_ const wchar_t *unit,
+                _In_ const measurement_quantity quantity) noexcept
+            : _name(name), _quantity(quantity), _unit(unit) { }
+
+        /// <summary>
+        /// Initialises a new, empty instance.
+        /// </summary>
+        inline sensor_channel(void) noexcept
+            : sensor_channel(nullptr, nullptr, measurement_quantity::power) { }
+
+        /// <summary>
+        /// Answer the name of the channel.
+        /// </summary>
+        /// <returns>The name of the channel.</returns>
+        inline _Ret_maybenull_z_ const wchar_t *name(void) const noexcept {
+            return this->_name;
+        }
+
+        /// <summary>
+        /// Answer the quantity measured by the channel.
+        /// </summary>
+        /// <returns>The quantity of the values.</returns>
+        inline measurement_quantity quantity(void) const noexcept {
+            return this->_quantity;
+        }
+
+        /// <summary>
+        /// Answer the unit of the values.
+        /// </summary>
+        /// <returns>The unit of the values.</returns>
+        inline _Ret_maybenull_z_ const wchar_t *unit(void) const noexcept {
+            return this->_unit;
+        }
+
+    private:
+
+        const wchar_t *_name;
+        measurement_quantity _quantity;
+        const wchar_t *_unit;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,127 @@
+﻿// <copyright file="sensor_filter.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// Restricts the sensors that are enumerated when dumping sensor
+    /// descriptors.
+    /// </summary>
+    /// <remarks>
+    /// <para>All criteria are ECMAScript regular expressions that must match
+    /// the whole property of the sensor. A criterion that has not been set
+    /// matches all sensors. A sensor is only accepted if it matches all
+    /// criteria.</para>
+    /// <para>The type filter is evaluated before enumerating the sensors,
+    /// wherefore types that are filtered out are not discovered at all. The
+    /// other criteria can only be evaluated once the descriptor of a sensor is
+    /// available.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API sensor_filter final {
+
+    public:
+
+        /// <summary>
+        /// Initialises a new instance that accepts all sensors.
+        /// </summary>
+        sensor_filter(void) noexcept;
+
+        /// <summary>
+        /// Clone <paramref name="rhs" />.
+        /// </summary>
+        /// <param name="rhs">The object to be cloned.</param>
+        sensor_filter(_In_ const sensor_filter& rhs);
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~sensor_filter(void);
+
+        /// <summary>
+        /// Gets the pattern for the device of the sensor, which is its path,
+        /// UDID, GUID, UID or CPU core depending on the type of sensor.
+        /// </summary>
+        /// <returns>The pattern, or <c>nullptr</c> if all devices are
+        /// accepted.</returns>
+        inline _Ret_maybenull_z_ const wchar_t *device(void) const noexcept {
+            return this->_device;
+        }
+
+        /// <summary>
+        /// Sets the pattern for the device of the sensor.
+        /// </summary>
+        /// <param name="pattern">The pattern for the device, or <c>nullptr</c>
+        /// to accept all devices.</param>
+        /// <param name="literal">If <c>true</c>, <paramref name="pattern" />
+        /// is escaped such that it matches only the literal string.</param>
+        /// <returns><c>*this</c>.</returns>
+        sensor_filter& device(_In_opt_z_ const wchar_t *pattern,
+            _In_ const bool literal = false);
+
+        /// <summary>
+        /// Gets the pattern for the name of the sensor.
+        /// </summary>
+        /// <returns>The pattern, or <c>nullptr</c> if all names are
+        /// accepted.</returns>
+        inline _Ret_maybenull_z_ const wchar_t *name(void) const noexcept {
+            return this->_name;
+        }
+
+        /// <summary>
+        /// Sets the pattern for the name of the sensor.
+        /// </summary>
+        /// <param name="pattern">The pattern for the name, or <c>nullptr</c>
+        /// to accept all names.</param>
+        /// <param name="literal">If <c>true</c>, <paramref name="pattern" />
+        /// is escaped such that it matches only the literal string.</param>
+        /// <returns><c>*this</c>.</returns>
+        sensor_filter& name(_In_opt_z_ const wchar_t *pattern,
+            _In_ const bool literal = false);
+
+        /// <summary>
+        /// Gets the pattern for the type of the sensor, for instance
+        /// <c>nvml_sensor</c>.
+        /// </summary>
+        /// <returns>The pattern, or <c>nullptr</c> if all types are
+        /// accepted.</returns>
+        inline _Ret_maybenull_z_ const wchar_t *type(void) const noexcept {
+            return this->_type;
+        }
+
+        /// <summary>
+        /// Sets the pattern for the type of the sensor.
+        /// </summary>
+        /// <param name="pattern">The pattern for the type, for instance
+        /// <c>nvml_sensor|adl_sensor</c>, or <c>nullptr</c> to accept all
+        /// types.</param>
+        /// <param name="literal">If <c>true</c>, <paramref name="pattern" />
+        /// is escaped such that it matches only the literal string.</param>
+        /// <returns><c>*this</c>.</returns>
+        sensor_filter& type(_In_opt_z_ const wchar_t *pattern,
+            _In_ const bool literal = false);
+
+        /// <summary>
+        /// Assignment.
+        /// </summary>
+        /// <param name="rhs">The right hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        sensor_filter& operator =(_In_ const sensor_filter& rhs);
+
+    private:
+
+        wchar_t *_device;
+        wchar_t *_name;
+        wchar_t *_type;
+
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,119 @@
+﻿// <copyright file="sensor_stream.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstddef>
+
+#include "power_overwhelming/collector_subscriber.h"
+#include "power_overwhelming/sensor.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations */
+    namespace detail { struct sensor_stream_impl; }
+
+    /// <summary>
+    /// Samples a single sensor asynchronously into a broadcast ring from
+    /// which consumers pull the samples at their own pace.
+    /// </summary>
+    /// <remarks>
+    /// <para>This provides the pull model of a
+    /// <see cref="collector_subscriber" /> for a sensor without a collector.
+    /// The sampler thread of the sensor only copies the samples into the
+    /// ring, and consumers read them on their own threads, or are notified
+    /// via <see cref="collector_subscriber::notify" /> such that they can be
+    /// resumed on an executor of their choice. Consumers that do not keep up
+    /// lose samples according to their overflow policy rather than slowing
+    /// down the sampling.</para>
+    /// <para>The stream starts sampling via <see cref="sensor::sample_batch" />
+    /// when it is created and stops when it is destroyed. The sensor must
+    /// therefore outlive the stream and must not be sampled asynchronously
+    /// by anyone else if it does not support multiple subscribers.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API sensor_stream final {
+
+    public:
+
+        /// <summary>
+        /// The default number of samples the ring can hold.
+        /// </summary>
+        static constexpr std::size_t default_capacity = 4096;
+
+        /// <summary>
+        /// Initialises a new, invalid instance.
+        /// </summary>
+        inline sensor_stream(void) noexcept : _impl(nullptr) { }
+
+        /// <summary>
+        /// Initialises a new instance which starts sampling the given sensor.
+        /// </summary>
+        /// <param name="source">The sensor to be sampled, which must outlive
+        /// the stream.</param>
+        /// <param name="period">The sampling period in microseconds.</param>
+        /// <param name="capacity">The number of samples the ring can hold,
+        /// which is rounded up to the next power of two.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="capacity" /> is zero.</exception>
+        /// <exception cref="std::runtime_error">If the sensor has been
+        /// disposed.</exception>
+        /// <exception cref="std::logic_error">If the sensor is already being
+        /// sampled and does not support multiple subscribers.</exception>
+        explicit sensor_stream(_In_ sensor& source,
+            _In_ const sensor::microseconds_type period
+            = sensor::default_sampling_period,
+            _In_ const std::size_t capacity = default_capacity);
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline sensor_stream(_Inout_ sensor_stream&& rhs) noexcept
+                : _impl(rhs._impl) {
+            rhs._impl = nullptr;
+        }
+
+        /// <summary>
+        /// Stops sampling and releases the subscribers waiting for samples.
+        /// </summary>
+        ~sensor_stream(void);
+
+        /// <summary>
+        /// Creates a subscriber that receives the samples of the sensor from
+        /// now on.
+        /// </summary>
+        /// <param name="overflow">Determines what happens if the subscriber
+        /// falls behind.</param>
+        /// <returns>A new subscriber, which remains valid after the stream
+        /// has been destroyed, but will not receive any more samples.
+        /// </returns>
+        /// <exception cref="std::runtime_error">If the stream has been
+        /// disposed.</exception>
+        collector_subscriber subscribe(_In_ const subscriber_overflow overflow
+            = subscriber_overflow::drop_oldest);
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        sensor_stream& operator =(_Inout_ sensor_stream&& rhs) noexcept;
+
+        /// <summary>
+        /// Determines whether the object is valid.
+        /// </summary>
+        /// <returns><c>true</c> if the stream is sampling a sensor,
+        /// <c>false</c> otherwise.</returns>
+        operator bool(void) const noexcept;
+
+    private:
+
+        detail::sensor_stream_impl *_impl;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
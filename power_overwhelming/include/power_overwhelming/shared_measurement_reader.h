@@ -0,0 +1,161 @@
+﻿// <copyright file="shared_measurement_reader.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstddef>
+
+#include "power_overwhelming/measurement_data.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations */
+    namespace detail { struct shared_measurement_reader_impl; }
+
+    /// <summary>
+    /// Reads the latest samples a <see cref="collector" /> publishes in a
+    /// named shared memory segment.
+    /// </summary>
+    /// <remarks>
+    /// <para>The collector publishes the samples if
+    /// <see cref="collector_settings::shared_memory" /> has been set. Each
+    /// sensor occupies a slot of the segment, which is protected by a
+    /// sequence lock, such that reading a sample neither requires a system
+    /// call nor blocks the collector. The samples lag behind the sensors by at
+    /// most the write latency of the collector.</para>
+    /// <para>The reader maps the segment as it was when the reader was
+    /// created. If the collector is restarted, the reader must be recreated
+    /// once <see cref="active" /> returns <c>false</c>.</para>
+    /// <para>The reader is not thread-safe, but different threads can use
+    /// different readers of the same segment.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API shared_measurement_reader final {
+
+    public:
+
+        /// <summary>
+        /// Initialises a new instance that is not connected to any segment.
+        /// </summary>
+        shared_measurement_reader(void) noexcept;
+
+        /// <summary>
+        /// Initialises a new instance reading from the given segment.
+        /// </summary>
+        /// <param name="name">The name of the shared memory segment as set
+        /// in <see cref="collector_settings::shared_memory" />.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="name" /> is <c>nullptr</c> or empty.</exception>
+        /// <exception cref="std::system_error">If the segment does not exist
+        /// or could not be mapped.</exception>
+        /// <exception cref="std::runtime_error">If the segment does not
+        /// contain samples in a supported layout.</exception>
+        explicit shared_measurement_reader(_In_z_ const wchar_t *name);
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline shared_measurement_reader(
+                _Inout_ shared_measurement_reader&& rhs) noexcept
+                : _impl(rhs._impl) {
+            rhs._impl = nullptr;
+        }
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~shared_measurement_reader(void);
+
+        /// <summary>
+        /// Answer whether the collector is still publishing samples.
+        /// </summary>
+        /// <returns><c>true</c> if the samples are being updated,
+        /// <c>false</c> if the collector has stopped or if the reader is
+        /// invalid.</returns>
+        bool active(void) const noexcept;
+
+        /// <summary>
+        /// Answer the maximum number of sensors in the segment.
+        /// </summary>
+        /// <returns>The capacity of the segment, or zero if the reader is
+        /// invalid.</returns>
+        std::size_t capacity(void) const noexcept;
+
+        /// <summary>
+        /// Retrieves the latest sample of the sensor at the given index.
+        /// </summary>
+        /// <param name="index">The index of the sensor, which must be less
+        /// than <see cref="size" />.</param>
+        /// <param name="dst">Receives the latest sample if the method
+        /// succeeds.</param>
+        /// <returns><c>true</c> if the sample has been read, <c>false</c> if
+        /// the index is out of range or if the sensor has not delivered any
+        /// sample yet.</returns>
+        bool read(_In_ const std::size_t index,
+            _Out_ measurement_data& dst) const noexcept;
+
+        /// <summary>
+        /// Retrieves the latest sample of the sensor with the given name.
+        /// </summary>
+        /// <remarks>
+        /// This method searches the names of all sensors. Applications reading
+        /// many samples should resolve the index once and use it instead.
+        /// </remarks>
+        /// <param name="sensor">The name of the sensor.</param>
+        /// <param name="dst">Receives the latest sample if the method
+        /// succeeds.</param>
+        /// <returns><c>true</c> if the sample has been read, <c>false</c> if
+        /// the sensor is not in the segment.</returns>
+        bool read(_In_opt_z_ const wchar_t *sensor,
+            _Out_ measurement_data& dst) const noexcept;
+
+        /// <summary>
+        /// Answer the name of the sensor at the given index.
+        /// </summary>
+        /// <remarks>
+        /// Names longer than 103 bytes in UTF-8 are truncated. The returned
+        /// string remains valid as long as the reader exists.
+        /// </remarks>
+        /// <param name="index">The index of the sensor.</param>
+        /// <returns>The name of the sensor, or <c>nullptr</c> if
+        /// <paramref name="index" /> is out of range.</returns>
+        _Ret_maybenull_z_ const wchar_t *sensor(
+            _In_ const std::size_t index) const noexcept;
+
+        /// <summary>
+        /// Answer the number of sensors in the segment.
+        /// </summary>
+        /// <remarks>
+        /// The number of sensors grows while the collector publishes samples
+        /// of sensors it has not seen before.
+        /// </remarks>
+        /// <returns>The number of sensors, or zero if the reader is invalid.
+        /// </returns>
+        std::size_t size(void) const noexcept;
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        shared_measurement_reader& operator =(
+            _Inout_ shared_measurement_reader&& rhs) noexcept;
+
+        /// <summary>
+        /// Determines whether the object is valid.
+        /// </summary>
+        /// <returns><c>true</c> if the reader is connected to a segment,
+        /// <c>false</c> otherwise.</returns>
+        operator bool(void) const noexcept;
+
+    private:
+
+        detail::shared_measurement_reader_impl *_impl;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -5,6 +5,8 @@
 
 #pragma once
 
+#include <cinttypes>
+
 #include "power_overwhelming/graphics_device.h"
 
 
@@ -16,6 +18,12 @@ namespace power_overwhelming {
     /// ie disables GPU boost for these devices to produce a more predictable
     /// behaviour.
     /// </summary>
+    /// <remarks>
+    /// Setting the stable power state might take several hundred milliseconds
+    /// per device, wherefore all devices are enabled concurrently. The clocks
+    /// might take some more time to settle, which can be awaited using
+    /// <see cref="wait_for_stable_clocks" />.
+    /// </remarks>
     class POWER_OVERWHELMING_API stable_power_state_scope final {
 
     public:
@@ -24,6 +32,10 @@ namespace power_overwhelming {
         /// Initialises a new instance putting all supported devices into a
         /// stable power state.
         /// </summary>
+        /// <exception cref="std::system_error">If any of the devices could not
+        /// be put into stable power state. The error of the first device that
+        /// failed is reported after all devices have been processed.
+        /// </exception>
         stable_power_state_scope(void);
 
         /// <summary>
@@ -50,6 +62,39 @@ namespace power_overwhelming {
             return this->_cnt_devices;
         }
 
+        /// <summary>
+        /// Blocks the calling thread until the graphics clocks of all GPUs
+        /// have settled.
+        /// </summary>
+        /// <remarks>
+        /// <para>The graphics clocks are read via NVML and ADL. As the
+        /// Direct3D devices of the scope cannot be mapped to the devices of
+        /// these libraries, all GPUs that can be monitored are considered,
+        /// regardless of whether they are covered by the scope.</para>
+        /// <para>The clocks of a GPU are considered settled if
+        /// <paramref name="window" /> consecutive readings vary by at most
+        /// <paramref name="tolerance" /> relative to the highest of them.
+        /// </para>
+        /// </remarks>
+        /// <param name="timeout">The maximum time to wait in milliseconds.
+        /// </param>
+        /// <param name="interval">The time between two readings of the clocks
+        /// in milliseconds.</param>
+        /// <param name="window">The number of consecutive readings that must
+        /// be within the tolerance.</param>
+        /// <param name="tolerance">The maximum relative variation of the
+        /// readings in the window.</param>
+        /// <returns><c>true</c> if the clocks settled before the timeout,
+        /// <c>false</c> if they did not or if no GPU clock can be read.
+        /// </returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="window" /> is zero or
+        /// <paramref name="tolerance" /> is negative.</exception>
+        bool wait_for_stable_clocks(_In_ const std::uint32_t timeout = 10000,
+            _In_ const std::uint32_t interval = 100,
+            _In_ const std::size_t window = 10,
+            _In_ const float tolerance = 0.02f) const;
+
         stable_power_state_scope& operator =(
             const stable_power_state_scope&) = delete;
 
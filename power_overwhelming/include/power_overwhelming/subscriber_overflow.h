@@ -0,0 +1,40 @@
+﻿// <copyright file="subscriber_overflow.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// Specifies what happens to a <see cref="collector_subscriber" /> that
+    /// has fallen behind the collector by more than the capacity of the ring
+    /// it reads from.
+    /// </summary>
+    /// <remarks>
+    /// The collector never waits for its subscribers, so a subscriber that
+    /// does not read fast enough always loses samples. The policy only
+    /// determines which ones.
+    /// </remarks>
+    enum class subscriber_overflow {
+
+        /// <summary>
+        /// The oldest samples are lost and the subscriber continues with the
+        /// oldest sample still in the ring, such that it receives as much of
+        /// the history as possible.
+        /// </summary>
+        drop_oldest,
+
+        /// <summary>
+        /// The whole backlog is lost and the subscriber continues with the
+        /// samples published after it has fallen behind, which is preferable
+        /// for consumers only interested in recent data like overlays.
+        /// </summary>
+        skip_to_latest
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,279 @@
+﻿// <copyright file="synthetic_sensor.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "power_overwhelming/sensor.h"
+#include "power_overwhelming/synthetic_waveform.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations */
+    namespace detail { struct synthetic_sensor_impl; }
+
+
+    /// <summary>
+    /// A sensor that generates a synthetic power curve without any hardware,
+    /// which allows for load-testing the samplers, the
+    /// <see cref="collector" /> and its writers with an arbitrary number of
+    /// sensors.
+    /// </summary>
+    /// <remarks>
+    /// <para>The sensor computes the power from its <see cref="waveform" />
+    /// at the time of sampling and reports it at a constant
+    /// <see cref="voltage" />. In order to simulate sensors that are expensive
+    /// to read, each sample can be configured to take a certain
+    /// <see cref="cost" />, during which the sampling thread is kept busy.
+    /// </para>
+    /// <para>By default, the sensor is polled by the generic sampler of the
+    /// library like any sensor without an asynchronous API. If the sensor is
+    /// <see cref="async" />, it runs its own thread when being sampled
+    /// asynchronously, which simulates sensors with an asynchronous API of
+    /// their own.</para>
+    /// <para>The properties of the sensor must not be changed while it is
+    /// being sampled.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API synthetic_sensor final : public sensor {
+
+    public:
+
+        /// <summary>
+        /// The type used to express the generated values.
+        /// </summary>
+        typedef measurement::value_type value_type;
+
+        /// <summary>
+        /// The default amplitude of the waveform in Watts.
+        /// </summary>
+        static constexpr value_type default_amplitude = 50.0f;
+
+        /// <summary>
+        /// The default offset, ie the mean power, in Watts.
+        /// </summary>
+        static constexpr value_type default_offset = 100.0f;
+
+        /// <summary>
+        /// The default period of the waveform in microseconds.
+        /// </summary>
+        static constexpr microseconds_type default_period = 1000000;
+
+        /// <summary>
+        /// The default voltage in Volts.
+        /// </summary>
+        static constexpr value_type default_voltage = 12.0f;
+
+        /// <summary>
+        /// Create all synthetic sensors on the system.
+        /// </summary>
+        /// <remarks>
+        /// Synthetic sensors are not backed by any hardware and can therefore
+        /// not be discovered. They must be created explicitly or described in
+        /// a configuration file. The method only exists such that the sensor
+        /// can be used like all other sensors.
+        /// </remarks>
+        /// <param name="out_sensors">Receives the sensors, if not
+        /// <c>nullptr</c>.</param>
+        /// <param name="cnt_sensors">The available space in
+        /// <paramref name="out_sensors" />.</param>
+        /// <returns>Zero.</returns>
+        static std::size_t for_all(
+            _Out_writes_opt_(cnt_sensors) synthetic_sensor *out_sensors,
+            _In_ const std::size_t cnt_sensors);
+
+        /// <summary>
+        /// Initialises a new instance, which cannot be sampled until it has
+        /// been replaced by a named one.
+        /// </summary>
+        synthetic_sensor(void);
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="name">The name of the sensor.</param>
+        /// <param name="waveform">The shape of the generated power curve.
+        /// </param>
+        /// <exception cref="std::invalid_argument">If <paramref name="name" />
+        /// is <c>nullptr</c> or empty.</exception>
+        explicit synthetic_sensor(_In_z_ const wchar_t *name,
+            _In_ const synthetic_waveform waveform = synthetic_waveform::sine);
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline synthetic_sensor(_In_ synthetic_sensor&& rhs) noexcept
+                : _impl(rhs._impl) {
+            rhs._impl = nullptr;
+        }
+
+        /// <summary>
+        /// Finalise the instance.
+        /// </summary>
+        virtual ~synthetic_sensor(void);
+
+        /// <summary>
+        /// Answer the amplitude of the waveform.
+        /// </summary>
+        /// <returns>The amplitude in Watts.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        value_type amplitude(void) const;
+
+        /// <summary>
+        /// Sets the amplitude of the waveform.
+        /// </summary>
+        /// <param name="amplitude">The amplitude in Watts.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        synthetic_sensor& amplitude(_In_ const value_type amplitude);
+
+        /// <summary>
+        /// Answer whether the sensor runs its own thread when being sampled
+        /// asynchronously.
+        /// </summary>
+        /// <returns><c>true</c> if the sensor has its own thread,
+        /// <c>false</c> if it is polled by the generic sampler.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        bool async(void) const;
+
+        /// <summary>
+        /// Sets whether the sensor runs its own thread when being sampled
+        /// asynchronously.
+        /// </summary>
+        /// <param name="async"><c>true</c> for running a dedicated thread,
+        /// <c>false</c> for being polled by the generic sampler.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        synthetic_sensor& async(_In_ const bool async);
+
+        /// <summary>
+        /// Answer how long generating a sample takes.
+        /// </summary>
+        /// <returns>The time the sampling thread is kept busy for each sample
+        /// in microseconds.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        microseconds_type cost(void) const;
+
+        /// <summary>
+        /// Sets how long generating a sample takes.
+        /// </summary>
+        /// <param name="cost">The time the sampling thread is kept busy for
+        /// each sample in microseconds, which can be zero.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        synthetic_sensor& cost(_In_ const microseconds_type cost);
+
+        /// <inheritdoc />
+        virtual _Ret_maybenull_z_ const wchar_t *name(
+            void) const noexcept override;
+
+        /// <summary>
+        /// Answer the offset of the waveform, ie the mean power.
+        /// </summary>
+        /// <returns>The offset in Watts.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        value_type offset(void) const;
+
+        /// <summary>
+        /// Sets the offset of the waveform, ie the mean power.
+        /// </summary>
+        /// <param name="offset">The offset in Watts.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        synthetic_sensor& offset(_In_ const value_type offset);
+
+        /// <summary>
+        /// Answer the period of the waveform.
+        /// </summary>
+        /// <returns>The period in microseconds.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        microseconds_type period(void) const;
+
+        /// <summary>
+        /// Sets the period of the waveform.
+        /// </summary>
+        /// <param name="period">The period in microseconds.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="period" /> is not positive.</exception>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        synthetic_sensor& period(_In_ const microseconds_type period);
+
+        /// <inheritdoc />
+        virtual void sample_batch(
+            _In_opt_ const measurement_data_callback on_batch,
+            _In_ const microseconds_type period = default_sampling_period,
+            _In_opt_ void *context = nullptr) override;
+
+        /// <summary>
+        /// Answer the constant voltage reported by the sensor.
+        /// </summary>
+        /// <returns>The voltage in Volts.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        value_type voltage(void) const;
+
+        /// <summary>
+        /// Sets the constant voltage reported by the sensor.
+        /// </summary>
+        /// <param name="voltage">The voltage in Volts.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="voltage" /> is not positive.</exception>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        synthetic_sensor& voltage(_In_ const value_type voltage);
+
+        /// <summary>
+        /// Answer the shape of the generated power curve.
+        /// </summary>
+        /// <returns>The waveform.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        synthetic_waveform waveform(void) const;
+
+        /// <summary>
+        /// Sets the shape of the generated power curve.
+        /// </summary>
+        /// <param name="waveform">The waveform.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        synthetic_sensor& waveform(_In_ const synthetic_waveform waveform);
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand</param>
+        /// <returns><c>*this</c></returns>
+        synthetic_sensor& operator =(_In_ synthetic_sensor&& rhs) noexcept;
+
+        /// <inheritdoc />
+        virtual operator bool(void) const noexcept override;
+
+    protected:
+
+        /// <inheritdoc />
+        measurement_data sample_sync(
+            _In_ const timestamp_resolution resolution) const override;
+
+    private:
+
+        detail::synthetic_sensor_impl *_impl;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,71 @@
+﻿// <copyright file="synthetic_waveform.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// Defines the shapes of the power curve that a
+    /// <see cref="synthetic_sensor" /> can generate.
+    /// </summary>
+    enum class synthetic_waveform {
+
+        /// <summary>
+        /// The power is always the offset.
+        /// </summary>
+        constant,
+
+        /// <summary>
+        /// The power oscillates sinusoidally around the offset.
+        /// </summary>
+        sine,
+
+        /// <summary>
+        /// The power alternates between the offset plus and minus the
+        /// amplitude every half period.
+        /// </summary>
+        square,
+
+        /// <summary>
+        /// The power rises linearly from the offset minus the amplitude to the
+        /// offset plus the amplitude within a period.
+        /// </summary>
+        sawtooth,
+
+        /// <summary>
+        /// The power is uniformly distributed within the amplitude around the
+        /// offset.
+        /// </summary>
+        noise
+    };
+
+
+    /// <summary>
+    /// Parses the given string into a <see cref="synthetic_waveform" />.
+    /// </summary>
+    /// <param name="str">The string to be parsed.</param>
+    /// <returns>The waveform represented by <paramref name="str" />.</returns>
+    /// <exception cref="std::invalid_argument">If <paramref name="str" /> is
+    /// <c>nullptr</c> or does not represent a valid waveform.</exception>
+    extern POWER_OVERWHELMING_API synthetic_waveform parse_synthetic_waveform(
+        _In_z_ const wchar_t *str);
+
+    /// <summary>
+    /// Convert the given waveform to a human-readable string.
+    /// </summary>
+    /// <param name="waveform">The waveform to be converted.</param>
+    /// <returns>The name of the waveform.</returns>
+    /// <exception cref="std::invalid_argument">If the waveform is not
+    /// valid.</exception>
+    extern POWER_OVERWHELMING_API _Ret_z_ const wchar_t *to_string(
+        _In_ const synthetic_waveform waveform);
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,310 @@
+﻿// <copyright file="sysfs_sensor.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+
+#include "power_overwhelming/sensor.h"
+#include "power_overwhelming/sysfs_sensor_quantity.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations */
+    namespace detail { struct energy_meter_impl; }
+    namespace detail { struct sysfs_sensor_impl; }
+
+
+    /// <summary>
+    /// Implementation of a generic power sensor reading a file in sysfs, like
+    /// the power and energy attributes in hwmon or the energy counters of
+    /// powercap on Linux.
+    /// </summary>
+    /// <remarks>
+    /// <para>Many sources of power data, like PMBus power supplies, rails of
+    /// a baseboard management controller or the energy meters of Arm SoCs,
+    /// are exposed as decimal numbers in sysfs. The sensor multiplies the
+    /// content of its file by a scale to obtain Watts or Joules,
+    /// respectively, depending on the <see cref="sysfs_sensor_quantity" />.
+    /// </para>
+    /// <para>The sensor keeps its file open for its whole lifetime. The files
+    /// of all sensors are read together, using a single system call via
+    /// io_uring where available, whenever one sensor needs a new value, and
+    /// the other sensors are served from this read once. Sampling all sensors
+    /// at the same rate therefore costs one system call per tick.</para>
+    /// <para>sysfs is not available on Windows, where the sensor cannot be
+    /// created.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API sysfs_sensor final : public sensor {
+
+    public:
+
+        /// <summary>
+        /// The default scale, which converts the microwatts and microjoules
+        /// of hwmon and powercap to Watts and Joules.
+        /// </summary>
+        static constexpr double default_scale = 0.000001;
+
+        /// <summary>
+        /// Create sensors for the power and energy attributes of all hwmon
+        /// devices and the energy counters of all powercap zones.
+        /// </summary>
+        /// <remarks>
+        /// Devices that are covered by a dedicated sensor are skipped in order
+        /// not to measure the same rail twice. These are the hwmon devices of
+        /// the amdgpu driver, which are handled by the
+        /// <see cref="amdgpu_sensor" />, and the RAPL zones of powercap, which
+        /// are handled by the <see cref="perf_rapl_sensor" /> and the
+        /// <see cref="msr_sensor" />. They can still be created via
+        /// <see cref="for_pattern" /> or <see cref="for_path" />.
+        /// </remarks>
+        /// <param name="out_sensors">Receives the sensors, if not
+        /// <c>nullptr</c>.</param>
+        /// <param name="cnt_sensors">The available space in
+        /// <paramref name="out_sensors" />.</param>
+        /// <returns>The number of sensors available on the system, regardless
+        /// of the size of the output array. If this number is larger than
+        /// <paramref name="cnt_sensors" />, not all sensors have been returned.
+        /// </returns>
+        static std::size_t for_all(
+            _Out_writes_opt_(cnt_sensors) sysfs_sensor *out_sensors,
+            _In_ const std::size_t cnt_sensors);
+
+        /// <summary>
+        /// Create a sensor for the specified file.
+        /// </summary>
+        /// <param name="path">The path to the file.</param>
+        /// <param name="quantity">The quantity the file reports.</param>
+        /// <param name="scale">The factor converting the content of the file
+        /// to Watts or Joules. This parameter defaults to
+        /// <see cref="default_scale" />.</param>
+        /// <returns>A new sensor for the file.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="path" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::system_error">If the file could not be
+        /// opened or read.</exception>
+        /// <exception cref="std::runtime_error">If the file does not contain
+        /// a number.</exception>
+        static sysfs_sensor for_path(_In_z_ const char *path,
+            _In_ const sysfs_sensor_quantity quantity,
+            _In_ const double scale = default_scale);
+
+        /// <summary>
+        /// Create a sensor for the specified file.
+        /// </summary>
+        /// <param name="path">The path to the file.</param>
+        /// <param name="quantity">The quantity the file reports.</param>
+        /// <param name="scale">The factor converting the content of the file
+        /// to Watts or Joules. This parameter defaults to
+        /// <see cref="default_scale" />.</param>
+        /// <returns>A new sensor for the file.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="path" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::system_error">If the file could not be
+        /// opened or read.</exception>
+        /// <exception cref="std::runtime_error">If the file does not contain
+        /// a number.</exception>
+        static sysfs_sensor for_path(_In_z_ const wchar_t *path,
+            _In_ const sysfs_sensor_quantity quantity,
+            _In_ const double scale = default_scale);
+
+        /// <summary>
+        /// Create sensors for all files matching the given glob pattern.
+        /// </summary>
+        /// <remarks>
+        /// Files that cannot be opened or do not contain a number are
+        /// skipped.
+        /// </remarks>
+        /// <param name="out_sensors">Receives the sensors, if not
+        /// <c>nullptr</c>.</param>
+        /// <param name="cnt_sensors">The available space in
+        /// <paramref name="out_sensors" />.</param>
+        /// <param name="pattern">The glob pattern for the files, for instance
+        /// &quot;/sys/class/hwmon/hwmon*/power*_input&quot;.</param>
+        /// <param name="quantity">The quantity the files report.</param>
+        /// <param name="scale">The factor converting the content of the files
+        /// to Watts or Joules. This parameter defaults to
+        /// <see cref="default_scale" />.</param>
+        /// <returns>The number of sensors matching the pattern, regardless
+        /// of the size of the output array. If this number is larger than
+        /// <paramref name="cnt_sensors" />, not all sensors have been returned.
+        /// </returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="pattern" /> is <c>nullptr</c>.</exception>
+        static std::size_t for_pattern(
+            _Out_writes_opt_(cnt_sensors) sysfs_sensor *out_sensors,
+            _In_ const std::size_t cnt_sensors,
+            _In_z_ const char *pattern,
+            _In_ const sysfs_sensor_quantity quantity,
+            _In_ const double scale = default_scale);
+
+        /// <summary>
+        /// Samples all of the given sensors without attaching their names to
+        /// the samples.
+        /// </summary>
+        /// <remarks>
+        /// This is the batch variant of <see cref="sample_data" />, which
+        /// enters the library only once for all sensors of the family.
+        /// </remarks>
+        /// <param name="dst">Receives <paramref name="cnt" /> samples.</param>
+        /// <param name="sensors">The sensors to be sampled.</param>
+        /// <param name="cnt">The number of sensors in
+        /// <paramref name="sensors" />.</param>
+        /// <param name="resolution">The resolution of the timestamps to be
+        /// created. This parameter defaults to
+        /// <see cref="timestamp_resolution::milliseconds" />.</param>
+        /// <exception cref="std::invalid_argument">If <paramref name="dst" />
+        /// or <paramref name="sensors" /> is <c>nullptr</c> while
+        /// <paramref name="cnt" /> is not zero.</exception>
+        /// <exception cref="std::runtime_error">If any of the sensors has been
+        /// moved (and therefore disposed).</exception>
+        static void sample_data(_Out_writes_(cnt) measurement_data *dst,
+            _In_reads_(cnt) const sysfs_sensor *sensors,
+            _In_ const std::size_t cnt,
+            _In_ const timestamp_resolution resolution
+            = timestamp_resolution::milliseconds);
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        sysfs_sensor(void);
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline sysfs_sensor(_In_ sysfs_sensor&& rhs) noexcept
+                : _impl(rhs._impl) {
+            rhs._impl = nullptr;
+        }
+
+        /// <summary>
+        /// Finalise the instance.
+        /// </summary>
+        virtual ~sysfs_sensor(void);
+
+        /// <summary>
+        /// Answer the energy in Joules the sensor has accumulated since it was
+        /// created.
+        /// </summary>
+        /// <returns>The consumed energy in Joules, or zero if the sensor
+        /// reads a power.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed or if reading the file failed.
+        /// </exception>
+        double energy(void) const;
+
+        /// <inheritdoc />
+        virtual _Ret_maybenull_z_ const wchar_t *name(
+            void) const noexcept override;
+
+        /// <inheritdoc />
+        virtual microseconds_type native_interval(void) const override;
+
+        using sensor::sample;
+
+        /// <inheritdoc />
+        virtual void sample_adaptive(
+            _In_opt_ const measurement_data_callback on_batch,
+            _In_ const microseconds_type min_period,
+            _In_ const microseconds_type max_period,
+            _In_opt_ void *context = nullptr) override;
+
+        /// <summary>
+        /// Sample the sensor using a timestamp with the specified resolution,
+        /// but do not attach the sensor that produces the data to the sample.
+        /// </summary>
+        /// <remarks>
+        /// This method hides <see cref="sensor::sample_data" /> and provides a
+        /// fast path for code that knows the type of the sensor, because it
+        /// does not need any virtual call.
+        /// </remarks>
+        /// <param name="resolution">The resolution of the timestamp to be
+        /// created. This parameter defaults to
+        /// <see cref="timestamp_resolution::milliseconds" />.</param>
+        /// <returns>A single measurement made by the sensor.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved
+        /// (and therefore disposed).</exception>
+        measurement_data sample_data(_In_ const timestamp_resolution resolution
+            = timestamp_resolution::milliseconds) const;
+
+        /// <summary>
+        /// Asynchronously sample the sensor every
+        /// <paramref name="sampling_period "/> microseconds.
+        /// </summary>
+        /// <param name="on_measurement">The callback to be invoked if new data
+        /// arrived. If this is <c>nullptr</c>, the asynchronous sampling will
+        /// be disabled.</param>
+        /// <param name="period">The desired sampling period in
+        /// microseconds. This parameter defaults to 1 millisecond.</param>
+        /// <param name="timestamp_resolution">The resolution of the timestamps
+        /// that are generated by the sensor. This parameter defaults to
+        /// <see cref="timestamp_resolution::milliseconds" />.</param>
+        /// <param name="context">A user-defined context pointer that is passed
+        /// on to <see cref="on_measurement" />. This parameter defaults to
+        /// <c>nullptr</c>.</para>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        /// <exception cref="std::logic_error">If the sensor is already being
+        /// sampled asynchronously due to a previous call to the method.
+        /// </exception>
+        void sample(_In_opt_ const measurement_callback on_measurement,
+            _In_ const microseconds_type period = default_sampling_period,
+            _In_ const timestamp_resolution timestamp_resolution
+                = timestamp_resolution::milliseconds,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Answer the path to the file the sensor is reading.
+        /// </summary>
+        /// <returns>The path to the file.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        _Ret_z_ const char *path(void) const;
+
+        /// <summary>
+        /// Answer the quantity the file of the sensor reports.
+        /// </summary>
+        /// <returns>The quantity of the file.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        sysfs_sensor_quantity quantity(void) const;
+
+        /// <summary>
+        /// Answer the factor converting the content of the file to Watts or
+        /// Joules.
+        /// </summary>
+        /// <returns>The scale of the sensor.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on a
+        /// sensor that has been disposed.</exception>
+        double scale(void) const;
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand</param>
+        /// <returns><c>*this</c></returns>
+        sysfs_sensor& operator =(_In_ sysfs_sensor&& rhs) noexcept;
+
+        /// <inheritdoc />
+        virtual operator bool(void) const noexcept override;
+
+    protected:
+
+        /// <inheritdoc />
+        measurement_data sample_sync(
+            _In_ const timestamp_resolution resolution) const override;
+
+    private:
+
+        detail::sysfs_sensor_impl *_impl;
+
+        friend struct detail::energy_meter_impl;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
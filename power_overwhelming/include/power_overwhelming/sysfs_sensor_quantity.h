@@ -0,0 +1,59 @@
+﻿// <copyright file="sysfs_sensor_quantity.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// Specifies the physical quantity a <see cref="sysfs_sensor" /> reads
+    /// from its file.
+    /// </summary>
+    enum class sysfs_sensor_quantity : std::uint32_t {
+
+        /// <summary>
+        /// The file reports the current power, which the sensor multiplies by
+        /// its scale to obtain Watts, like hwmon's <c>power*_input</c> in
+        /// microwatts.
+        /// </summary>
+        power = 0x0001,
+
+        /// <summary>
+        /// The file reports an accumulated energy, which the sensor multiplies
+        /// by its scale to obtain Joules, like hwmon's <c>energy*_input</c> or
+        /// powercap's <c>energy_uj</c> in microjoules, and from which it
+        /// derives the average power between two samples.
+        /// </summary>
+        energy = 0x0002
+    };
+
+    /// <summary>
+    /// Parse a quantity from a string.
+    /// </summary>
+    /// <param name="str">The string to be parsed.</param>
+    /// <returns>The quantity represented by the string.</returns>
+    /// <exception cref="std::invalid_argument">If <paramref name="str" /> is
+    /// <c>nullptr</c> or does not represent a valid quantity.</exception>
+    extern POWER_OVERWHELMING_API sysfs_sensor_quantity
+    parse_sysfs_sensor_quantity(_In_z_ const wchar_t *str);
+
+    /// <summary>
+    /// Convert the given quantity to a human-readable string representation.
+    /// </summary>
+    /// <param name="quantity">The quantity to be converted.</param>
+    /// <returns>The name of the quantity.</returns>
+    /// <exception cref="std::invalid_argument">If the quantity is unknown.
+    /// </exception>
+    extern POWER_OVERWHELMING_API const wchar_t *to_string(
+        _In_ const sysfs_sensor_quantity quantity);
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
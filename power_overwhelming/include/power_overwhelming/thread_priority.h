@@ -0,0 +1,56 @@
+﻿// <copyright file="thread_priority.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// Specifies the scheduling priority of a thread.
+    /// </summary>
+    enum class thread_priority {
+
+        /// <summary>
+        /// The default priority of the operating system.
+        /// </summary>
+        normal,
+
+        /// <summary>
+        /// A priority above normal, which still allows the operating system to
+        /// preempt the thread in favour of system services.
+        /// </summary>
+        /// <remarks>
+        /// On Linux, this lowers the nice value of the thread, which might
+        /// require the <c>CAP_SYS_NICE</c> capability.
+        /// </remarks>
+        high,
+
+        /// <summary>
+        /// A real-time priority, which should only be used for threads that
+        /// spend most of their time waiting.
+        /// </summary>
+        /// <remarks>
+        /// On Windows, this is <c>THREAD_PRIORITY_TIME_CRITICAL</c>. On Linux,
+        /// the thread is scheduled as <c>SCHED_FIFO</c>, which typically
+        /// requires elevated privileges.
+        /// </remarks>
+        realtime
+    };
+
+
+    /// <summary>
+    /// Sets the scheduling priority of the calling thread.
+    /// </summary>
+    /// <param name="priority">The new priority of the thread.</param>
+    /// <exception cref="std::system_error">If the operation failed.</exception>
+    extern POWER_OVERWHELMING_API void set_thread_priority(
+        _In_ const thread_priority priority);
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
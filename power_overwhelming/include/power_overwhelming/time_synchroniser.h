@@ -8,6 +8,7 @@
 #include <cinttypes>
 
 #include "power_overwhelming/power_overwhelming_api.h"
+#include "power_overwhelming/timestamp_resolution.h"
 
 
 namespace visus {
@@ -54,6 +55,65 @@ namespace power_overwhelming {
         /// </summary>
         ~time_synchroniser(void);
 
+        /// <summary>
+        /// Sends a batch of timestamp requests to the time synchroniser running
+        /// on the given peer.
+        /// </summary>
+        /// <remarks>
+        /// <para>The responses are received asynchronously. For each response,
+        /// the midpoint of the round trip is paired with the time reported by
+        /// the peer, and the offset and skew of the clock of the peer are
+        /// estimated by a linear regression through the pairs with the
+        /// shortest round trips. Sending several requests at once makes it
+        /// likely that at least one of them is not delayed by other traffic.
+        /// </para>
+        /// <para>The estimate only follows the drift of the clocks if the
+        /// method is called periodically, for instance every few seconds,
+        /// for the whole duration of a measurement.</para>
+        /// </remarks>
+        /// <param name="peer">The host name or address of the peer.</param>
+        /// <param name="port">The port the time synchroniser on the peer is
+        /// listening on.</param>
+        /// <param name="cnt">The number of requests to send at once.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If <paramref name="peer" />
+        /// is <c>nullptr</c>.</exception>
+        /// <exception cref="std::runtime_error">If the synchroniser has been
+        /// disposed or is not running, or if the name of the peer could not be
+        /// resolved.</exception>
+        /// <exception cref="std::system_error">If the requests could not be
+        /// sent.</exception>
+        time_synchroniser& request(_In_z_ const char *peer,
+            _In_ const std::uint16_t port,
+            _In_ const std::size_t cnt = 8);
+
+        /// <summary>
+        /// Converts time stamps created on the given peer to local time.
+        /// </summary>
+        /// <param name="timestamps">The time stamps created on the peer, which
+        /// are converted in place.</param>
+        /// <param name="cnt">The number of elements in
+        /// <paramref name="timestamps" />.</param>
+        /// <param name="resolution">The resolution of the time stamps.</param>
+        /// <param name="peer">The host name or address of the peer.</param>
+        /// <param name="port">The port the time synchroniser on the peer is
+        /// listening on.</param>
+        /// <returns><c>true</c> if the time stamps have been converted,
+        /// <c>false</c> if no response has been received from the peer yet,
+        /// in which case the time stamps have not been modified.</returns>
+        /// <exception cref="std::invalid_argument">If <paramref name="peer" />
+        /// is <c>nullptr</c> or if <paramref name="resolution" /> is
+        /// <see cref="timestamp_resolution::nanoseconds" />, which is not
+        /// supported for time stamps.</exception>
+        /// <exception cref="std::runtime_error">If the synchroniser has been
+        /// disposed or if the name of the peer could not be resolved.
+        /// </exception>
+        bool to_local(_Inout_updates_(cnt) std::int64_t *timestamps,
+            _In_ const std::size_t cnt,
+            _In_ const timestamp_resolution resolution,
+            _In_z_ const char *peer,
+            _In_ const std::uint16_t port) const;
+
         time_synchroniser& operator =(const time_synchroniser&) = delete;
 
         /// <summary>
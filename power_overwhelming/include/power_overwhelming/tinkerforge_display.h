@@ -87,6 +87,15 @@ namespace power_overwhelming {
             rhs._impl = nullptr;
         }
 
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        /// <remarks>
+        /// Text passed to <see cref="print_async" /> that has not yet been
+        /// drawn is discarded.
+        /// </remarks>
+        ~tinkerforge_display(void);
+
         /// <summary>
         /// Clears the display.
         /// </summary>
@@ -108,6 +117,44 @@ namespace power_overwhelming {
             _In_ const std::uint8_t font = 0,
             _In_ const bool colour = true);
 
+        /// <summary>
+        /// Queues text to be printed on a background thread and returns
+        /// immediately.
+        /// </summary>
+        /// <remarks>
+        /// <para>In contrast to <see cref="print" />, this method does not wait
+        /// for the network round trip to the bricklet, which makes it suitable
+        /// for being called from time-critical code like the thread setting
+        /// markers in a <see cref="collector" />. The background thread shares
+        /// the connection to the Brick daemon with the display.</para>
+        /// <para>The queue is coalescing: there is only a single slot for
+        /// pending text, so if the background thread is still busy with a
+        /// previous text, only the text from the most recent call will be
+        /// printed. Asynchronous text is not ordered with respect to calls to
+        /// <see cref="clear" /> or <see cref="print" />.</para>
+        /// <para>As errors on the background thread cannot be reported when
+        /// they occur, they are reported by the next call to this method.
+        /// </para>
+        /// </remarks>
+        /// <param name="text">The text to be printed.</param>
+        /// <param name="x">The x-coordinate of the cell to start at.</param>
+        /// <param name="y">The y-coordinate of the cell to start at.</param>
+        /// <param name="font">The font to use (mainly the size), which is
+        /// one of the constants like <c>LCD_128X64_FONT_6X8</c>.</param>
+        /// <param name="colour">If <c>true</c> (the default), print the text
+        /// in black. Otherwise, print in white.</param>
+        /// <exception cref="std::runtime_error">If the display has been
+        /// disposed.</exception>
+        /// <exception cref="std::invalid_argument">If <paramref name="text" />
+        /// is <c>nullptr</c>.</exception>
+        /// <exception cref="tinkerforge_exception">If printing text queued by
+        /// a previous call failed.</exception>
+        void print_async(_In_z_ const char *text,
+            _In_ const std::uint8_t x = 0,
+            _In_ const std::uint8_t y = 0,
+            _In_ const std::uint8_t font = 0,
+            _In_ const bool colour = true);
+
         /// <summary>
         /// Move assignment.
         /// </summary>
@@ -41,6 +41,43 @@ namespace power_overwhelming {
         static constexpr const tinkerforge_sensor_source default_source
             = tinkerforge_sensor_source::all;
 
+        /// <summary>
+        /// Configures the given bricklets at once for the intervals they will
+        /// be sampled at.
+        /// </summary>
+        /// <remarks>
+        /// <para>Configuring the bricklets one after the other via
+        /// <see cref="configure" /> waits for a round trip to the Brick daemon
+        /// for each of them. This method sends all configurations without
+        /// waiting and afterwards reads them back from all bricklets
+        /// concurrently, such that the time required is roughly that of a
+        /// single round trip.</para>
+        /// <para>Once a bricklet has acknowledged its configuration, it is
+        /// known to be reachable and the requests enabling and disabling its
+        /// callbacks are not acknowledged anymore. This allows for starting
+        /// many bricklets in quick succession.</para>
+        /// </remarks>
+        /// <param name="sensors">The sensors to be configured. Elements that
+        /// are <c>nullptr</c> are ignored.</param>
+        /// <param name="sampling_intervals">The interval in microseconds at
+        /// which each of the sensors will be sampled.</param>
+        /// <param name="cnt">The number of elements in
+        /// <paramref name="sensors" /> and
+        /// <paramref name="sampling_intervals" />.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="sensors" /> or
+        /// <paramref name="sampling_intervals" /> is <c>nullptr</c> and
+        /// <paramref name="cnt" /> is not zero.</exception>
+        /// <exception cref="std::runtime_error">If any of the sensors has been
+        /// disposed by a move before or if a bricklet has not applied its
+        /// configuration.</exception>
+        /// <exception cref="tinkerforge_exception">If the communication with
+        /// any of the bricklets failed.</exception>
+        static void configure_all(
+            _In_reads_(cnt) tinkerforge_sensor *const *sensors,
+            _In_reads_(cnt) const microseconds_type *sampling_intervals,
+            _In_ const std::size_t cnt);
+
         /// <summary>
         /// Create sensors for all Tinkerforge bricklets attached to the
         /// <see cref="host" /> on <see cref="port" />.
@@ -123,6 +160,50 @@ namespace power_overwhelming {
             _In_ const std::uint16_t port = default_port,
             _In_ const std::size_t timeout = 1000);
 
+        /// <summary>
+        /// Create sensors for all Tinkerforge bricklets attached to any of the
+        /// given Brick daemons.
+        /// </summary>
+        /// <remarks>
+        /// The Brick daemons are enumerated concurrently as described for
+        /// the multi-host overload of <see cref="get_definitions" />, so the
+        /// discovery takes about as long as for a single host. The sensors
+        /// are created for the host their bricklets have been found on.
+        /// </remarks>
+        /// <param name="out_sensors">Receives the sensors, if not
+        /// <c>nullptr</c>.</param>
+        /// <param name="cnt_sensors">The available space in
+        /// <paramref name="out_sensors" />.</param>
+        /// <param name="hosts">The hosts on which the Brick daemons are
+        /// running. Elements that are <c>nullptr</c> are interpreted as
+        /// <see cref="default_host" />.</param>
+        /// <param name="ports">The ports on which the Brick daemons are
+        /// listening. If <c>nullptr</c>, all Brick daemons are assumed to
+        /// listen on <see cref="default_port" />.</param>
+        /// <param name="cnt_endpoints">The number of elements in
+        /// <paramref name="hosts" /> and <paramref name="ports" />.</param>
+        /// <param name="timeout">The number of milliseconds to wait for the
+        /// bricklets to connect if none are cached. This value defaults to
+        /// 1000.</param>
+        /// <returns>The number of sensors available on all hosts, regardless
+        /// of the size of the output array. If this number is larger than
+        /// <paramref name="cnt_sensors" />, not all sensors have been
+        /// returned.</returns>
+        /// <exception cref="std::invalid_argument">If <paramref name="hosts" />
+        /// is <c>nullptr</c> although <paramref name="cnt_endpoints" /> is not
+        /// zero.</exception>
+        /// <exception cref="std::bad_alloc">If the required resources could not
+        /// be allocated.</exception>
+        /// <exception cref="tinkerforge_exception">If the connection to any of
+        /// the master bricks could not be established.</exception>
+        static std::size_t for_all(
+            _Out_writes_opt_(cnt_sensors) tinkerforge_sensor *out_sensors,
+            _In_ const std::size_t cnt_sensors,
+            _In_reads_(cnt_endpoints) const char *const *hosts,
+            _In_reads_opt_(cnt_endpoints) const std::uint16_t *ports,
+            _In_ const std::size_t cnt_endpoints,
+            _In_ const std::size_t timeout = 1000);
+
         /// <summary>
         /// Retrieve sensor definitions for all bricklets attacted to the
         /// specified host.
@@ -187,6 +268,87 @@ namespace power_overwhelming {
             _In_opt_z_ const char *host = default_host,
             _In_ const std::uint16_t port = default_port);
 
+        /// <summary>
+        /// Retrieve sensor definitions for all bricklets attached to any of the
+        /// given Brick daemons.
+        /// </summary>
+        /// <remarks>
+        /// <para>All Brick daemons are enumerated concurrently, so the method
+        /// takes about as long as the slowest one rather than the sum of all
+        /// of them. The definitions are returned in the order of the
+        /// endpoints and record the host and port they have been found on,
+        /// such that sensors created from them connect to the right Brick
+        /// daemon.</para>
+        /// <para>In contrast to the single-host overload, the number of
+        /// expected bricklets per host is unknown, so the discovery on each
+        /// host finishes as soon as at least one bricklet has been found or
+        /// the timeout has expired. The remarks on spurious results of the
+        /// single-host overload apply likewise.</para>
+        /// </remarks>
+        /// <param name="out_definitions">Receives the sensor definitions. If
+        /// <c>nullptr</c>, the sensors will only be counted.</param>
+        /// <param name="cnt">Size of
+        /// <paramref name="out_definitions" /> in elements.</param>
+        /// <param name="hosts">The hosts on which the Brick daemons are
+        /// running. Elements that are <c>nullptr</c> are interpreted as
+        /// <see cref="default_host" />.</param>
+        /// <param name="ports">The ports on which the Brick daemons are
+        /// listening. If <c>nullptr</c>, all Brick daemons are assumed to
+        /// listen on <see cref="default_port" />.</param>
+        /// <param name="cnt_endpoints">The number of elements in
+        /// <paramref name="hosts" /> and <paramref name="ports" />.</param>
+        /// <param name="timeout">The number of milliseconds to wait for the
+        /// bricklets to connect if none are cached. This value defaults to
+        /// 1000.</param>
+        /// <returns>The number of current/voltage bricklets available on all
+        /// hosts, regardless of how many have been copied.</returns>
+        /// <exception cref="std::invalid_argument">If <paramref name="hosts" />
+        /// is <c>nullptr</c> although <paramref name="cnt_endpoints" /> is not
+        /// zero.</exception>
+        /// <exception cref="std::bad_alloc">If the required resources could not
+        /// be allocated.</exception>
+        /// <exception cref="tinkerforge_exception">If the connection to any of
+        /// the master bricks could not be established.</exception>
+        static std::size_t get_definitions(
+            _Out_writes_opt_(cnt) tinkerforge_sensor_definition *out_definitions,
+            _In_ const std::size_t cnt,
+            _In_reads_(cnt_endpoints) const char *const *hosts,
+            _In_reads_opt_(cnt_endpoints) const std::uint16_t *ports,
+            _In_ const std::size_t cnt_endpoints,
+            _In_ const std::size_t timeout = 1000);
+
+        /// <summary>
+        /// Selects the configuration of the A/D converter with the lowest noise
+        /// that still provides fresh data every
+        /// <paramref name="sampling_interval" />.
+        /// </summary>
+        /// <remarks>
+        /// <para>The INA226 on the bricklet alternately converts the voltage
+        /// and the current, so it produces a new averaged sample after
+        /// <paramref name="averaging" /> times twice the conversion time. The
+        /// method selects the configuration that integrates over the longest
+        /// time which still fits into the sampling interval. This prevents
+        /// stale readings due to averaging over a longer time than the
+        /// interval, and it prevents wasting bandwidth on oversampling a
+        /// converter that averages over a much shorter time.</para>
+        /// <para>For instance, a sampling interval of 5 ms yields an average
+        /// of four samples at 588 µs, which provides new data every 4.7 ms.
+        /// </para>
+        /// </remarks>
+        /// <param name="sampling_interval">The interval in microseconds at
+        /// which the sensor will be sampled.</param>
+        /// <param name="averaging">Receives the number of samples to average.
+        /// </param>
+        /// <param name="time">Receives the A/D conversion time for both,
+        /// voltage and current.</param>
+        /// <returns><c>true</c> if a matching configuration was found,
+        /// <c>false</c> if the interval is too short for any configuration, in
+        /// which case the fastest one is returned.</returns>
+        static bool select_configuration(
+            _In_ const microseconds_type sampling_interval,
+            _Out_ sample_averaging& averaging,
+            _Out_ conversion_time& time) noexcept;
+
         /// <summary>
         /// Initialises a new instance.
         /// </summary>
@@ -240,9 +402,13 @@ namespace power_overwhelming {
         /// <param name="definition">The definition of the bricklet to create
         /// the sensor for</param>
         /// <param name="host">The host on which the Brick daemon is running.
-        /// This parameter defaults to &quot;localhost&quot;.</param>
+        /// If <c>nullptr</c>, which is the default, the host recorded in the
+        /// definition is used, or &quot;localhost&quot; if the definition
+        /// does not specify a host.</param>
         /// <param name="port">The port on which the Brick daemon is listening.
-        /// This parameter defaults to 4223.</param>
+        /// If zero, which is the default, the port recorded in the definition
+        /// is used, or 4223 if the definition does not specify a port.
+        /// </param>
         /// <exception cref="std::invalid_argument">If the UID in
         /// <paramref name="definition" /> is invalid.</exception>
         /// <exception cref="std::bad_alloc">If the required resources could not
@@ -251,8 +417,8 @@ namespace power_overwhelming {
         /// master brick could not be established.</exception>
         tinkerforge_sensor(
             _In_ const tinkerforge_sensor_definition& definition,
-            _In_opt_z_ const char *host = default_host,
-            _In_ const std::uint16_t port = default_port);
+            _In_opt_z_ const char *host = nullptr,
+            _In_ const std::uint16_t port = 0);
 
         /// <summary>
         /// Move <paramref name="rhs" /> into a new instance.
@@ -301,12 +467,49 @@ namespace power_overwhelming {
             _In_ const conversion_time voltage_conversion_time,
             _In_ const conversion_time current_conversion_time);
 
+        /// <summary>
+        /// Configures the bricklet for the lowest noise that still provides
+        /// fresh data every <paramref name="sampling_interval" />.
+        /// </summary>
+        /// <remarks>
+        /// The configuration is chosen by <see cref="select_configuration" />.
+        /// </remarks>
+        /// <param name="sampling_interval">The interval in microseconds at
+        /// which the sensor will be sampled.</param>
+        /// <exception cref="std::runtime_error">If the sensor has been disposed
+        /// by a move before.</exception>
+        /// <exception cref="tinkerforge_exception">If the operation failed.
+        /// </exception>
+        void configure(_In_ const microseconds_type sampling_interval);
+
         /// <summary>
         /// The user-defined description of what the sensor is measuring.
         /// </summary>
         /// <returns>The description of what the sensor is measuring.</returns>
         _Ret_maybenull_z_ const wchar_t *description(void) const noexcept;
 
+        /// <summary>
+        /// Answer the host on which the Brick daemon the bricklet is attached
+        /// to is running.
+        /// </summary>
+        /// <returns>The host of the Brick daemon, or <c>nullptr</c> if the
+        /// sensor has been disposed.</returns>
+        _Ret_maybenull_z_ const char *host(void) const noexcept;
+
+        /// <summary>
+        /// Answer the number of asynchronous readings that have been dropped,
+        /// because the dispatcher did not keep up with the bricklet.
+        /// </summary>
+        /// <remarks>
+        /// Readings from the bricklet are queued on the callback thread of the
+        /// Tinkerforge connection and delivered in batches from a dispatcher
+        /// thread. If the queue of a bricklet is full, new readings are
+        /// dropped.
+        /// </remarks>
+        /// <returns>The number of dropped readings, or zero if the sensor has
+        /// been disposed.</returns>
+        std::uint64_t dropped_readings(void) const noexcept;
+
         /// <summary>
         /// Identify the bricklet used for the sensor.
         /// </summary>
@@ -344,6 +547,28 @@ namespace power_overwhelming {
         /// </exception>
         void identify(_Out_writes_(8) char uid[8]) const;
 
+        /// <summary>
+        /// Answer the number of asynchronous samples that have been discarded
+        /// because not all of the requested quantities have been received for
+        /// a period.
+        /// </summary>
+        /// <remarks>
+        /// An incomplete period typically indicates that the Brick daemon has
+        /// dropped packets. Incomplete periods can only be detected if more
+        /// than one <see cref="tinkerforge_sensor_source" /> is sampled.
+        /// </remarks>
+        /// <returns>The number of discarded samples, or zero if the sensor has
+        /// been disposed.</returns>
+        std::uint64_t incomplete_samples(void) const noexcept;
+
+        /// <summary>
+        /// Answer the largest number of asynchronous readings that have been
+        /// waiting for delivery at once.
+        /// </summary>
+        /// <returns>The maximum depth of the queue of the sensor, or zero if
+        /// the sensor has been disposed.</returns>
+        std::size_t max_queue_depth(void) const noexcept;
+
         /// <summary>
         /// Gets the name of the sensor.
         /// </summary>
@@ -352,6 +577,94 @@ namespace power_overwhelming {
         virtual _Ret_maybenull_z_ const wchar_t *name(
             void) const noexcept override;
 
+        /// <summary>
+        /// Answer the interval after which the bricklet produces a new
+        /// averaged sample in its current configuration.
+        /// </summary>
+        /// <returns>The number of averaged samples times the conversion times
+        /// of voltage and current in microseconds.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        /// <exception cref="tinkerforge_exception">If the configuration could
+        /// not be read from the bricklet.</exception>
+        virtual microseconds_type native_interval(void) const override;
+
+        /// <summary>
+        /// Answer the port on which the Brick daemon the bricklet is attached
+        /// to is listening.
+        /// </summary>
+        /// <returns>The port of the Brick daemon, or zero if the sensor has
+        /// been disposed.</returns>
+        std::uint16_t port(void) const noexcept;
+
+        /// <summary>
+        /// Answer the quantities that are sampled if the sensor is sampled
+        /// via the generic <see cref="sample_batch" /> overload that does not
+        /// specify a <see cref="tinkerforge_sensor_source" />.
+        /// </summary>
+        /// <returns>The quantities sampled by default, or
+        /// <see cref="tinkerforge_sensor_source::none" /> if the sensor has
+        /// been disposed.</returns>
+        tinkerforge_sensor_source quantities(void) const noexcept;
+
+        /// <summary>
+        /// Changes the quantities that are sampled if the sensor is sampled
+        /// via the generic <see cref="sample_batch" /> overload, which is the
+        /// way a <see cref="collector" /> samples the sensor.
+        /// </summary>
+        /// <remarks>
+        /// By default, only the power is sampled, because each quantity is
+        /// reported in a separate callback of the bricklet. Requesting all
+        /// quantities therefore triples the bandwidth and the callback rate.
+        /// The change takes effect the next time asynchronous sampling is
+        /// started.
+        /// </remarks>
+        /// <param name="quantities">The quantities to be sampled.</param>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="quantities" /> does not select any valid quantity.
+        /// </exception>
+        void quantities(_In_ const tinkerforge_sensor_source quantities);
+
+        /// <summary>
+        /// Answer the number of asynchronous readings that are currently
+        /// waiting for delivery.
+        /// </summary>
+        /// <returns>The current depth of the queue of the sensor, or zero if
+        /// the sensor has been disposed.</returns>
+        std::size_t queue_depth(void) const noexcept;
+
+        /// <summary>
+        /// Answer whether the timestamps of asynchronous samples are
+        /// reconstructed from the period of the bricklet.
+        /// </summary>
+        /// <returns><c>true</c> if the samples are stamped by the model of the
+        /// bricklet clock, <c>false</c> if they carry the time when they
+        /// arrived on the host or if the sensor has been disposed.</returns>
+        bool reconstruct_timestamps(void) const noexcept;
+
+        /// <summary>
+        /// Changes whether the timestamps of asynchronous samples are
+        /// reconstructed from the period of the bricklet.
+        /// </summary>
+        /// <remarks>
+        /// <para>The bricklet emits its callbacks at a fixed period, but the
+        /// host can only stamp them when they arrive, which adds the jitter of
+        /// the network and the Brick daemon. If enabled, the sensor fits a
+        /// model of the bricklet clock to the arrival times and the sequence
+        /// numbers of the samples and stamps the samples using this model
+        /// once enough of them have been received. The model follows the drift
+        /// of the bricklet and starts over if the bricklet restarts.</para>
+        /// <para>This setting is enabled by default. Disable it in order to
+        /// keep the raw arrival times.</para>
+        /// </remarks>
+        /// <param name="reconstruct">Whether to reconstruct the timestamps.
+        /// </param>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        void reconstruct_timestamps(_In_ const bool reconstruct);
+
         /// <summary>
         /// Reset the bricklet.
         /// </summary>
@@ -363,6 +676,13 @@ namespace power_overwhelming {
         /// Asynchronously sample the sensor every
         /// <paramref name="sampling_period "/> microseconds.
         /// </summary>
+        /// <remarks>
+        /// The bricklet reports current, voltage and power in separate
+        /// callbacks. The sensor assembles the quantities requested via
+        /// <paramref name="source" /> into a single sample per period, which is
+        /// delivered once all of them have arrived. Incomplete periods are
+        /// dropped rather than mixing readings from different periods.
+        /// </remarks>
         /// <param name="on_measurement">The callback to be invoked if new data
         /// arrived. If this is <c>nullptr</c>, the asynchronous sampling will
         /// be disabled. Only one callback can be registered, subsequent calls
@@ -392,6 +712,70 @@ namespace power_overwhelming {
             _In_ const microseconds_type period = default_sampling_period,
             _In_opt_ void *context = nullptr);
 
+        /// <summary>
+        /// Asynchronously sample the sensor every
+        /// <paramref name="sampling_period "/> microseconds and deliver the
+        /// samples in batches.
+        /// </summary>
+        /// <remarks>
+        /// <para>In contrast to <see cref="sample" />, the samples are not
+        /// delivered one-by-one, but collected and delivered at once after
+        /// about ten milliseconds. This reduces the overhead per sample at the
+        /// cost of latency. Any samples that have not yet been delivered when
+        /// the sampling is stopped are delivered on the thread disabling the
+        /// asynchronous sampling.</para>
+        /// </remarks>
+        /// <param name="on_batch">The callback to be invoked if new data
+        /// arrived. If this is <c>nullptr</c>, the asynchronous sampling will
+        /// be disabled.</param>
+        /// <param name="source">Specifies the data to be sampled from the
+        /// bricklet.</param>
+        /// <param name="period">The desired sampling period in
+        /// microseconds, which will be clamped to 1 ms at the bottom.</param>
+        /// <param name="context">A user-defined context pointer that is passed
+        /// on to <see cref="on_batch" />. This parameter defaults to
+        /// <c>nullptr</c>.</para>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        /// <exception cref="std::logic_error">If the sensor is already being
+        /// sampled asynchronously due to a previous call to the method or to
+        /// <see cref="sample" />.</exception>
+        /// <exception cref="tinkerforge_exception">If the sensor could not be
+        /// sampled. </exception>
+        void sample_batch(_In_opt_ const measurement_data_callback on_batch,
+            _In_ const tinkerforge_sensor_source source,
+            _In_ const microseconds_type period = default_sampling_period,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Asynchronously sample the <see cref="quantities" /> of the sensor
+        /// every <paramref name="sampling_period "/> microseconds and deliver
+        /// the samples in batches.
+        /// </summary>
+        /// <remarks>
+        /// By default, this overload only enables the power callback of the
+        /// bricklet, such that the sensor produces one sample per period.
+        /// </remarks>
+        /// <param name="on_batch">The callback to be invoked if new data
+        /// arrived. If this is <c>nullptr</c>, the asynchronous sampling of
+        /// all sources will be disabled.</param>
+        /// <param name="period">The desired sampling period in
+        /// microseconds, which will be clamped to 1 ms at the bottom.</param>
+        /// <param name="context">A user-defined context pointer that is passed
+        /// on to <see cref="on_batch" />. This parameter defaults to
+        /// <c>nullptr</c>.</para>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        /// <exception cref="std::logic_error">If the sensor is already being
+        /// sampled asynchronously due to a previous call to the method or to
+        /// <see cref="sample" />.</exception>
+        /// <exception cref="tinkerforge_exception">If the sensor could not be
+        /// sampled. </exception>
+        virtual void sample_batch(
+            _In_opt_ const measurement_data_callback on_batch,
+            _In_ const microseconds_type period = default_sampling_period,
+            _In_opt_ void *context = nullptr) override;
+
         /// <summary>
         /// Move assignment.
         /// </summary>
@@ -5,6 +5,8 @@
 
 #pragma once
 
+#include <cinttypes>
+
 #include "power_overwhelming/power_overwhelming_api.h"
 
 
@@ -15,6 +17,12 @@ namespace power_overwhelming {
     /// Definition of a Tinkerforge sensor allowing the sensor UID and a
     /// description to be specified at the same time.
     /// </summary>
+    /// <remarks>
+    /// Definitions obtained via <see cref="tinkerforge_sensor::get_definitions"
+    /// /> also record the endpoint of the Brick daemon the bricklet has been
+    /// found on, which allows for creating the sensor without knowing from
+    /// which of multiple hosts it came.
+    /// </remarks>
     class POWER_OVERWHELMING_API tinkerforge_sensor_definition final {
 
     public:
@@ -23,17 +31,25 @@ namespace power_overwhelming {
         /// Initialises a new instance.
         /// </summary>
         inline tinkerforge_sensor_definition(void)
-            : _description(nullptr), _uid(nullptr) { }
+            : _description(nullptr), _host(nullptr), _port(0),
+            _uid(nullptr) { }
 
         /// <summary>
         /// Initialises a new instance.
         /// </summary>
         /// <param name="uid">The UID of the sensor.</param>
+        /// <param name="host">The host on which the Brick daemon the bricklet
+        /// is attached to is running. If <c>nullptr</c>, which is the default,
+        /// the host is unknown.</param>
+        /// <param name="port">The port on which the Brick daemon is listening.
+        /// If zero, which is the default, the port is unknown.</param>
         /// <exception cref="std::invalid_argument">If <paramref name="uid" />
         /// is <c>nullptr</c>.</exception>
         /// <exception cref="std::bad_alloc">If the memory for the UID
         /// could not be allocated.</exception>
-        tinkerforge_sensor_definition(_In_z_ const char *uid);
+        tinkerforge_sensor_definition(_In_z_ const char *uid,
+            _In_opt_z_ const char *host = nullptr,
+            _In_ const std::uint16_t port = 0);
 
         /// <summary>
         /// Clone <paramref name="rhs" />.
@@ -50,8 +66,10 @@ namespace power_overwhelming {
         /// <param name="rhs">The object to be moved.</param>
         inline tinkerforge_sensor_definition(
                 _In_ tinkerforge_sensor_definition&& rhs) noexcept
-                : _description(rhs._description), _uid(rhs._uid) {
+                : _description(rhs._description), _host(rhs._host),
+                _port(rhs._port), _uid(rhs._uid) {
             rhs._description = nullptr;
+            rhs._host = nullptr;
             rhs._uid = nullptr;
         }
 
@@ -78,6 +96,27 @@ namespace power_overwhelming {
         /// could not be allocated.</exception>
         void description(_In_opt_z_ const wchar_t *description);
 
+        /// <summary>
+        /// Gets the host on which the Brick daemon the bricklet is attached to
+        /// is running.
+        /// </summary>
+        /// <returns>The host of the Brick daemon, or <c>nullptr</c> if it is
+        /// unknown. The object remains owner of the memory returned.
+        /// </returns>
+        _Ret_maybenull_z_ const char *host(void) const noexcept {
+            return this->_host;
+        }
+
+        /// <summary>
+        /// Gets the port on which the Brick daemon the bricklet is attached to
+        /// is listening.
+        /// </summary>
+        /// <returns>The port of the Brick daemon, or zero if it is unknown.
+        /// </returns>
+        std::uint16_t port(void) const noexcept {
+            return this->_port;
+        }
+
         /// <summary>
         /// Gets the UID of the sensor.
         /// </summary>
@@ -108,6 +147,8 @@ namespace power_overwhelming {
     private:
 
         wchar_t *_description;
+        char *_host;
+        std::uint16_t _port;
         char *_uid;
     };
 
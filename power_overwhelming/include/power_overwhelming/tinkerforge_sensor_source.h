@@ -18,6 +18,12 @@ namespace power_overwhelming {
     /// </summary>
     enum class tinkerforge_sensor_source : std::uint32_t {
 
+        /// <summary>
+        /// Requests nothing, which is used in configurations to indicate that
+        /// the default of the sensor should be used.
+        /// </summary>
+        none = 0x0,
+
         /// <summary>
         /// Request sampling the current sensor only.
         /// </summary>
@@ -59,10 +65,30 @@ namespace power_overwhelming {
         _In_ const tinkerforge_sensor_source lhs,
         _In_ const tinkerforge_sensor_source rhs);
 
+    /// <summary>
+    /// Parse a sensor source from a string.
+    /// </summary>
+    /// <remarks>
+    /// Besides the names of the individual sources, the string may contain
+    /// combinations of sources separated by a vertical bar, for instance
+    /// <c>voltage|current</c>.
+    /// </remarks>
+    /// <param name="str">The string to be parsed.</param>
+    /// <returns>The sensor source represented by the string.</returns>
+    /// <exception cref="std::invalid_argument">If <paramref name="str" /> is
+    /// <c>nullptr</c> or does not represent a valid source.</exception>
+    extern POWER_OVERWHELMING_API tinkerforge_sensor_source
+    parse_tinkerforge_sensor_source(_In_z_ const wchar_t *str);
+
     /// <summary>
     /// Convert the given sensor source to a human-readable string
     /// representation.
     /// </summary>
+    /// <remarks>
+    /// Combinations of two sources are converted to the names of the sources
+    /// separated by a vertical bar, which
+    /// <see cref="parse_tinkerforge_sensor_source" /> accepts.
+    /// </remarks>
     /// <param name="source">The source to be converted.</param>
     /// <returns>The name of the source.</returns>
     /// <exception cref="std::invalid_argument">If the source is not
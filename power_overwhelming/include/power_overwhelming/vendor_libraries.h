@@ -0,0 +1,46 @@
+﻿// <copyright file="vendor_libraries.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// Starts initialising the vendor libraries for reading GPU sensors,
+    /// i.e. NVML and ADL, on a background thread.
+    /// </summary>
+    /// <remarks>
+    /// <para>Initialising NVML alone takes more than 100 ms on some systems.
+    /// The library therefore initialises each vendor library only once and
+    /// keeps it initialised for the whole process, which is shared by all
+    /// sensors, discoveries and collectors. Calling this function early
+    /// allows for hiding the cost of the first initialisation, which
+    /// otherwise occurs when the first GPU sensor is created.</para>
+    /// <para>If the library has been built with the CMake option
+    /// <c>PWROWG_PreloadVendorLibraries</c>, this function is called when the
+    /// library is loaded.</para>
+    /// <para>Failures, for instance because a library is not installed, are
+    /// ignored. They will be reported by the sensors.</para>
+    /// </remarks>
+    extern POWER_OVERWHELMING_API void preload_vendor_libraries(
+        void) noexcept;
+
+    /// <summary>
+    /// Releases the process-wide initialisation of the vendor libraries.
+    /// </summary>
+    /// <remarks>
+    /// The vendor libraries are shut down once all sensors using them have
+    /// been destroyed. Creating another GPU sensor afterwards initialises the
+    /// respective library again.
+    /// </remarks>
+    extern POWER_OVERWHELMING_API void release_vendor_libraries(
+        void) noexcept;
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
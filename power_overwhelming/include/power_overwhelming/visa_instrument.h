@@ -12,6 +12,7 @@
 #endif /*defined(POWER_OVERWHELMING_WITH_VISA) */
 
 #include "power_overwhelming/blob.h"
+#include "power_overwhelming/timestamp_resolution.h"
 
 
 namespace visus {
@@ -38,11 +39,49 @@ namespace power_overwhelming {
         /// </summary>
         typedef blob::byte_type byte_type;
 
+        /// <summary>
+        /// The callback to be invoked when an asynchronous I/O operation
+        /// started by <see cref="read_async" /> or <see cref="write_async" />
+        /// completed.
+        /// </summary>
+        /// <param name="status">The VISA status code of the operation, which
+        /// is negative if the operation failed, for instance because it timed
+        /// out or was aborted when the instrument was closed.</param>
+        /// <param name="cnt">The number of bytes that have been transferred.
+        /// </param>
+        /// <param name="context">The user-defined pointer that was passed to
+        /// the method that started the operation.</param>
+        typedef void (*io_completion_callback)(_In_ const std::int32_t status,
+            _In_ const std::size_t cnt, _In_opt_ void *context);
+
         /// <summary>
         /// The type used to express device timeouts in milliseconds.
         /// </summary>
         typedef std::uint32_t timeout_type;
 
+        /// <summary>
+        /// Enables or disables the persistent cache of the responses of
+        /// instruments on the network to <c>*IDN?</c>.
+        /// </summary>
+        /// <remarks>
+        /// <para>Instruments connected via LAN cannot be identified from their
+        /// resource path, so the discovery in the <c>for_all</c> methods of the
+        /// sensors must ask each of them. If the cache is enabled, instruments
+        /// whose identity was learned less than <paramref name="ttl" />
+        /// seconds ago are not asked again, which makes discovery on large
+        /// networks considerably faster.</para>
+        /// <para>Calling this method discards any previously loaded cache.
+        /// </para>
+        /// </remarks>
+        /// <param name="path">The path to the JSON file holding the cache. If
+        /// the file does not exist, it will be created on the next discovery.
+        /// If <c>nullptr</c>, the cache is disabled, which is the default.
+        /// </param>
+        /// <param name="ttl">The time in seconds for which cached identities
+        /// are considered valid.</param>
+        static void cache_identities(_In_opt_z_ const wchar_t *path,
+            _In_ const std::uint32_t ttl = 86400);
+
         /// <summary>
         /// Find all resources matching the given VISA resource query.
         /// </summary>
@@ -452,6 +491,70 @@ namespace power_overwhelming {
         /// the instrument after the call.</exception>
         blob read_all(_In_ const std::size_t buffer_size = 1024) const;
 
+        /// <summary>
+        /// Starts reading from the instrument into the given buffer and
+        /// returns without waiting for the data to arrive.
+        /// </summary>
+        /// <remarks>
+        /// <para>The callback is invoked exactly once from a thread of the
+        /// VISA library, or from the calling thread if the operation
+        /// completed immediately. This allows a single thread to drive the
+        /// I/O of many instruments at the same time, for instance by
+        /// signalling an <see cref="event_type" /> passed as
+        /// <paramref name="context" /> from the callback:</para>
+        /// <code>
+        /// auto evt = create_event();
+        /// instrument.read_async(buffer, sizeof(buffer),
+        ///     [](const std::int32_t, const std::size_t, void *c) {
+        ///         set_event(static_cast&lt;event_type&gt;(c));
+        ///     }, evt);
+        /// wait_event(evt);
+        /// </code>
+        /// <para>The callback should return quickly and must not throw.</para>
+        /// </remarks>
+        /// <param name="buffer">The buffer to write the data to, which must
+        /// remain valid until <paramref name="callback" /> has been invoked.
+        /// </param>
+        /// <param name="cnt">The size of the buffer in bytes.</param>
+        /// <param name="callback">The callback to be invoked once the
+        /// operation completed.</param>
+        /// <param name="context">A user-defined pointer that is passed to
+        /// <paramref name="callback" />.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it.</exception>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="buffer" /> or <paramref name="callback" /> is
+        /// <c>nullptr</c>.</exception>
+        /// <exception cref="visa_exception">If the operation could not be
+        /// started.</exception>
+        /// <exception cref="std::logic_error">If the library was compiled
+        /// without support for VISA.</exception>
+        visa_instrument& read_async(_Out_writes_bytes_(cnt) byte_type *buffer,
+            _In_ const std::size_t cnt,
+            _In_ const io_completion_callback callback,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Reads a binary response in the IEEE 488.2 definite or indefinite
+        /// length block format, which starts with a # marker for the number of
+        /// bytes to follow.
+        /// </summary>
+        /// <remarks>
+        /// <para>The data are read in chunks, which allows for transferring
+        /// large files from the instrument. The line feed after the data is
+        /// consumed such that the next query will not be interrupted.</para>
+        /// <para>This method has no effect if the library has been compiled
+        /// without support for VISA.</para>
+        /// </remarks>
+        /// <returns>The binary data excluding the length marker.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it, or if the response is
+        /// not in the expected format.</exception>
+        /// <exception cref="visa_exception">If the operation failed.
+        /// </exception>
+        blob read_binary(void) const;
+
         /// <summary>
         /// Resets the instrument to its default state by issuing the *RST
         /// command.
@@ -532,6 +635,39 @@ namespace power_overwhelming {
         /// not be retrieved.</exception>
         visa_instrument& timeout(_In_ const timeout_type timeout);
 
+        /// <summary>
+        /// Write the given null-terminated query to the instrument, read the
+        /// response and estimate the time at which the instrument answered.
+        /// </summary>
+        /// <remarks>
+        /// <para>Taking the host time after a query returned includes the
+        /// whole round trip to the instrument. The session therefore keeps
+        /// track of the round trips of all timestamped queries and estimates
+        /// the one-way latency of the connection from the shortest recent one.
+        /// The returned time stamp is the time of receipt less this latency,
+        /// but never earlier than the midpoint of the round trip.</para>
+        /// <para>This method has no effect except for creating the time stamp
+        /// if the library has been compiled without support for VISA.</para>
+        /// </remarks>
+        /// <param name="query">The query to be sent to the instrument.</param>
+        /// <param name="timestamp">Receives the estimated time at which the
+        /// instrument sent its response.</param>
+        /// <param name="resolution">The resolution of
+        /// <paramref name="timestamp" />.</param>
+        /// <param name="buffer_size">The buffer size used to read the response.
+        /// This parameter defaults to 1024.</param>
+        /// <returns>The data received from the instrument.</returns>
+        /// <exception cref="std::invalid_argument">If <paramref name="query" />
+        /// is <c>nullptr</c>.</exception>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it.</exception>
+        /// <exception cref="visa_exception">If the operation failed.
+        /// </exception>
+        blob timestamped_query(_In_z_ const char *query,
+            _Out_ std::int64_t& timestamp,
+            _In_ const timestamp_resolution resolution,
+            _In_ const std::size_t buffer_size = 1024) const;
+
         /// <summary>
         /// Issue and wait for an OPC query.
         /// </summary>
@@ -594,6 +730,39 @@ namespace power_overwhelming {
             _In_reads_bytes_(cnt) const byte_type *buffer,
             _In_ const std::size_t cnt) const;
 
+        /// <summary>
+        /// Starts writing the given data to the instrument and returns without
+        /// waiting for the transfer to complete.
+        /// </summary>
+        /// <remarks>
+        /// The callback is invoked in the same way as for
+        /// <see cref="read_async" />.
+        /// </remarks>
+        /// <param name="buffer">The buffer holding the data to write, which
+        /// must remain valid until <paramref name="callback" /> has been
+        /// invoked.</param>
+        /// <param name="cnt">The size of <paramref name="buffer" /> in bytes.
+        /// </param>
+        /// <param name="callback">The callback to be invoked once the
+        /// operation completed.</param>
+        /// <param name="context">A user-defined pointer that is passed to
+        /// <paramref name="callback" />.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it.</exception>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="buffer" /> or <paramref name="callback" /> is
+        /// <c>nullptr</c>.</exception>
+        /// <exception cref="visa_exception">If the operation could not be
+        /// started.</exception>
+        /// <exception cref="std::logic_error">If the library was compiled
+        /// without support for VISA.</exception>
+        visa_instrument& write_async(
+            _In_reads_bytes_(cnt) const byte_type *buffer,
+            _In_ const std::size_t cnt,
+            _In_ const io_completion_callback callback,
+            _In_opt_ void *context = nullptr);
+
         /// <summary>
         /// Writes the given null-terminated data to the instrument.
         /// </summary>
@@ -0,0 +1,109 @@
+﻿// <copyright file="adaptive_interval.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "adaptive_interval.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+
+/*
+ * visus::power_overwhelming::detail::adaptive_interval::default_patience
+ */
+constexpr unsigned int
+visus::power_overwhelming::detail::adaptive_interval::default_patience;
+
+
+/*
+ * visus::power_overwhelming::detail::adaptive_interval::default_sensitivity
+ */
+constexpr float
+visus::power_overwhelming::detail::adaptive_interval::default_sensitivity;
+
+
+/*
+ * visus::power_overwhelming::detail::adaptive_interval::adaptive_interval
+ */
+visus::power_overwhelming::detail::adaptive_interval::adaptive_interval(void)
+    : _activity(0.0f), _current(0), _have_previous(false), _max(0), _min(0),
+        _patience(default_patience), _previous(0.0f),
+        _sensitivity(default_sensitivity), _stable(0) { }
+
+
+/*
+ * visus::power_overwhelming::detail::adaptive_interval::configure
+ */
+void visus::power_overwhelming::detail::adaptive_interval::configure(
+        _In_ const interval_type min_interval,
+        _In_ const interval_type max_interval,
+        _In_ const float sensitivity,
+        _In_ const unsigned int patience) {
+    if (min_interval <= interval_type::zero()) {
+        throw std::invalid_argument("The minimum sampling interval must be "
+            "positive.");
+    }
+    if (min_interval > max_interval) {
+        throw std::invalid_argument("The minimum sampling interval must not "
+            "be larger than the maximum one.");
+    }
+    if (!(sensitivity > 0.0f)) {
+        throw std::invalid_argument("The sensitivity of the adaptive "
+            "sampling must be positive.");
+    }
+
+    this->_activity = 0.0f;
+    this->_current = max_interval;
+    this->_have_previous = false;
+    this->_max = max_interval;
+    this->_min = min_interval;
+    this->_patience = patience;
+    this->_sensitivity = sensitivity;
+    this->_stable = 0;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::adaptive_interval::update
+ */
+visus::power_overwhelming::detail::adaptive_interval::interval_type
+visus::power_overwhelming::detail::adaptive_interval::update(
+        _In_ const measurement_data::value_type value) noexcept {
+    if (!this->enabled() || (value == measurement_data::invalid_value)) {
+        return this->_current;
+    }
+
+    if (!this->_have_previous) {
+        this->_have_previous = true;
+        this->_previous = value;
+        return this->_current;
+    }
+
+    // Relate the change to the magnitude of the signal, but do not inflate
+    // the noise of signals close to zero.
+    const auto reference = (std::max)(std::abs(this->_previous), 1e-3f);
+    auto change = std::abs(value - this->_previous) / reference;
+    change *= static_cast<float>(this->_max.count())
+        / static_cast<float>(this->_current.count());
+    this->_previous = value;
+    this->_activity += 0.25f * (change - this->_activity);
+
+    if (change > this->_sensitivity) {
+        // Transients are short, so we need the full rate immediately.
+        this->_current = this->_min;
+        this->_stable = 0;
+
+    } else if (this->_activity < 0.5f * this->_sensitivity) {
+        if (++this->_stable >= this->_patience) {
+            this->_current = (std::min)(this->_max, 2 * this->_current);
+            this->_stable = 0;
+        }
+
+    } else {
+        this->_stable = 0;
+    }
+
+    return this->_current;
+}
@@ -0,0 +1,139 @@
+﻿// <copyright file="adaptive_interval.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <chrono>
+
+#include "power_overwhelming/measurement_data.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Adapts the sampling interval of a sensor to how fast its signal
+    /// changes.
+    /// </summary>
+    /// <remarks>
+    /// <para>The controller estimates the relative change of the signal
+    /// between two samples, normalised to the maximum interval such that a
+    /// ramp yields the same estimate at any rate. If the change exceeds the
+    /// sensitivity, a transient has started and the interval drops to the
+    /// minimum immediately. The estimate is smoothed by an exponential moving
+    /// average, and once it has been below half of the sensitivity for the
+    /// configured number of samples, the interval is doubled until it reaches
+    /// the maximum again.</para>
+    /// <para>The controller is not thread-safe and meant to be updated by the
+    /// thread sampling the sensor.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API adaptive_interval final {
+
+    public:
+
+        /// <summary>
+        /// The type to express sampling intervals.
+        /// </summary>
+        typedef std::chrono::microseconds interval_type;
+
+        /// <summary>
+        /// The number of stable samples after which the interval is raised
+        /// by default.
+        /// </summary>
+        static constexpr unsigned int default_patience = 8;
+
+        /// <summary>
+        /// The relative change over the maximum interval that is considered a
+        /// transient by default.
+        /// </summary>
+        static constexpr float default_sensitivity = 0.05f;
+
+        /// <summary>
+        /// Initialises a new instance, which is disabled.
+        /// </summary>
+        adaptive_interval(void);
+
+        /// <summary>
+        /// Configures the bounds of the interval and resets the estimate.
+        /// </summary>
+        /// <param name="min_interval">The interval used while the signal
+        /// changes quickly.</param>
+        /// <param name="max_interval">The interval used while the signal is
+        /// stable, which is the initial one.</param>
+        /// <param name="sensitivity">The relative change over
+        /// <paramref name="max_interval" /> that is considered a transient.
+        /// </param>
+        /// <param name="patience">The number of stable samples after which
+        /// the interval is raised.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="min_interval" /> is not positive or larger than
+        /// <paramref name="max_interval" />, or if
+        /// <paramref name="sensitivity" /> is not positive.</exception>
+        void configure(_In_ const interval_type min_interval,
+            _In_ const interval_type max_interval,
+            _In_ const float sensitivity = default_sensitivity,
+            _In_ const unsigned int patience = default_patience);
+
+        /// <summary>
+        /// Answer whether the interval can change at all.
+        /// </summary>
+        /// <returns><c>true</c> if the minimum is smaller than the maximum,
+        /// <c>false</c> otherwise.</returns>
+        inline bool enabled(void) const noexcept {
+            return (this->_min < this->_max);
+        }
+
+        /// <summary>
+        /// Answer the current interval.
+        /// </summary>
+        /// <returns>The interval the sensor should be sampled at.</returns>
+        inline interval_type interval(void) const noexcept {
+            return this->_current;
+        }
+
+        /// <summary>
+        /// Answer the maximum interval.
+        /// </summary>
+        /// <returns>The interval used while the signal is stable.</returns>
+        inline interval_type max_interval(void) const noexcept {
+            return this->_max;
+        }
+
+        /// <summary>
+        /// Answer the minimum interval.
+        /// </summary>
+        /// <returns>The interval used during transients.</returns>
+        inline interval_type min_interval(void) const noexcept {
+            return this->_min;
+        }
+
+        /// <summary>
+        /// Updates the estimate with a new sample of the signal.
+        /// </summary>
+        /// <param name="value">The new value of the signal, typically the
+        /// power. <see cref="measurement_data::invalid_value" /> is ignored.
+        /// </param>
+        /// <returns>The interval the sensor should be sampled at from now on.
+        /// </returns>
+        interval_type update(_In_ const measurement_data::value_type value)
+            noexcept;
+
+    private:
+
+        float _activity;
+        interval_type _current;
+        bool _have_previous;
+        interval_type _max;
+        interval_type _min;
+        unsigned int _patience;
+        measurement_data::value_type _previous;
+        float _sensitivity;
+        unsigned int _stable;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
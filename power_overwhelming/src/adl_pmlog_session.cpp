@@ -0,0 +1,273 @@
+﻿// <copyright file="adl_pmlog_session.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "adl_pmlog_session.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+#include "adl_exception.h"
+#include "zero_memory.h"
+
+
+/*
+ * visus::power_overwhelming::detail::adl_pmlog_session::acquire
+ */
+std::shared_ptr<visus::power_overwhelming::detail::adl_pmlog_session>
+visus::power_overwhelming::detail::adl_pmlog_session::acquire(
+        _In_ const adapter_type adapter) {
+    std::lock_guard<decltype(_lock_sessions)> l(_lock_sessions);
+
+    auto retval = _sessions[adapter].lock();
+    if (retval == nullptr) {
+        // Note: we cannot use make_shared as the constructor is private.
+        retval.reset(new adl_pmlog_session(adapter));
+        _sessions[adapter] = retval;
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::adl_pmlog_session::~adl_pmlog_session
+ */
+visus::power_overwhelming::detail::adl_pmlog_session::~adl_pmlog_session(
+        void) {
+    try {
+        std::lock_guard<decltype(this->_lock)> l(this->_lock);
+        this->stop();
+    } catch (...) {
+        // There is nothing we can do about a log that cannot be stopped.
+    }
+
+    if (this->_device != 0) {
+        // Note: AMD's sample uses zero as guard as well, so we assume this is
+        // safe to do.
+        amd_display_library::instance().ADL2_Device_PMLog_Device_Destroy(
+            this->_scope, this->_device);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::adl_pmlog_session::changed
+ */
+bool visus::power_overwhelming::detail::adl_pmlog_session::changed(
+        _In_ const update_type last_updated) const {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    if (!this->_running) {
+        return false;
+    }
+
+    // The PMLog is written by the driver, so we must make sure that the
+    // compiler actually reads the memory every time we look at it.
+    const auto data = static_cast<const volatile ADLPMLogData *>(
+        this->_output.pLoggingAddress);
+    return (data->ulLastUpdated != last_updated);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::adl_pmlog_session::read
+ */
+void visus::power_overwhelming::detail::adl_pmlog_session::read(
+        _Out_ ADLPMLogData& dst) const {
+    static constexpr auto max_retries = 4;
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+
+    if (!this->_running) {
+        throw std::logic_error("The PMLog cannot be read while it is not "
+            "running.");
+    }
+
+    const auto src = static_cast<const volatile ADLPMLogData *>(
+        this->_output.pLoggingAddress);
+
+    // There is no way to synchronise with the driver, so we check the timestamp
+    // before and after copying the log and retry if it has changed meanwhile.
+    // If the driver keeps updating, we use the last copy as AMD's sample does.
+    for (auto i = 0; i < max_retries; ++i) {
+        const auto before = src->ulLastUpdated;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        std::memcpy(&dst, const_cast<const ADLPMLogData *>(src), sizeof(dst));
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if ((src->ulLastUpdated == before) && (dst.ulLastUpdated == before)) {
+            break;
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::adl_pmlog_session::subscribe
+ */
+void visus::power_overwhelming::detail::adl_pmlog_session::subscribe(
+        _In_ const void *subscriber,
+        _In_ const ADLPMLogStartInput& input) {
+    assert(subscriber != nullptr);
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+
+    auto merged = this->_input;
+    auto restart = !this->_running;
+
+    // Add all sensors which are not yet logged. ADL_SENSOR_MAXTYPES, which is
+    // the guard for unused entries, is zero.
+    const auto begin = merged.usSensors;
+    auto end = std::find(begin, begin + ADL_PMLOG_MAX_SENSORS,
+        ADL_SENSOR_MAXTYPES);
+
+    for (auto s = input.usSensors; (s < input.usSensors + ADL_PMLOG_MAX_SENSORS)
+            && (*s != ADL_SENSOR_MAXTYPES); ++s) {
+        if (std::find(begin, end, *s) == end) {
+            if (end == begin + ADL_PMLOG_MAX_SENSORS) {
+                throw std::length_error("The sensors requested for the "
+                    "adapter exceed the capacity of the PMLog.");
+            }
+
+            *end++ = *s;
+            restart = true;
+        }
+    }
+
+    // Log at the highest rate anyone has been asking for. Zero is the rate of
+    // those who do not care.
+    if ((input.ulSampleRate > 0) && ((merged.ulSampleRate == 0)
+            || (input.ulSampleRate < merged.ulSampleRate))) {
+        merged.ulSampleRate = input.ulSampleRate;
+        restart = true;
+    }
+
+    if (restart) {
+        const auto previous = this->_input;
+        this->_input = merged;
+
+        try {
+            this->restart();
+        } catch (...) {
+            // If the new configuration does not work, try to restore the one
+            // that is being used by the existing subscribers.
+            this->_input = previous;
+            if (!this->_subscribers.empty()) {
+                try {
+                    this->restart();
+                } catch (...) { }
+            }
+            throw;
+        }
+    }
+
+    this->_subscribers[subscriber] = input;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::adl_pmlog_session::unsubscribe
+ */
+void visus::power_overwhelming::detail::adl_pmlog_session::unsubscribe(
+        _In_ const void *subscriber) {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+
+    if ((this->_subscribers.erase(subscriber) > 0)
+            && this->_subscribers.empty()) {
+        // The last one turns out the light. The next subscriber will start
+        // from scratch with only the sensors it needs.
+        ::ZeroMemory(&this->_input, sizeof(this->_input));
+        this->stop();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::adl_pmlog_session::update_interval
+ */
+visus::power_overwhelming::detail::adl_pmlog_session::update_interval_type
+visus::power_overwhelming::detail::adl_pmlog_session::update_interval(
+        void) const {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    if (!this->_running) {
+        return update_interval_type::zero();
+    }
+
+    const auto data = static_cast<const volatile ADLPMLogData *>(
+        this->_output.pLoggingAddress);
+    const auto active = data->ulActiveSampleRate;
+
+    // The driver might not be able to log at the requested rate, so prefer
+    // what it reports to actually do.
+    return update_interval_type((active > 0)
+        ? active
+        : this->_input.ulSampleRate);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::adl_pmlog_session::adl_pmlog_session
+ */
+visus::power_overwhelming::detail::adl_pmlog_session::adl_pmlog_session(
+        _In_ const adapter_type adapter)
+        : _adapter(adapter), _device(0), _running(false) {
+    ::ZeroMemory(&this->_input, sizeof(this->_input));
+    ::ZeroMemory(&this->_output, sizeof(this->_output));
+
+    auto status = amd_display_library::instance()
+        .ADL2_Device_PMLog_Device_Create(this->_scope, this->_adapter,
+        &this->_device);
+    if (status != ADL_OK) {
+        throw adl_exception(status);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::adl_pmlog_session::restart
+ */
+void visus::power_overwhelming::detail::adl_pmlog_session::restart(void) {
+    this->stop();
+
+    auto status = amd_display_library::instance().ADL2_Adapter_PMLog_Start(
+        this->_scope, this->_adapter, &this->_input, &this->_output,
+        this->_device);
+    if (status != ADL_OK) {
+        throw adl_exception(status);
+    }
+
+    this->_running = true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::adl_pmlog_session::stop
+ */
+void visus::power_overwhelming::detail::adl_pmlog_session::stop(void) {
+    if (this->_running) {
+        // Note: The log is broken if we cannot stop it, so we still mark it as
+        // not running in order to allow for restarting it.
+        this->_running = false;
+        auto status = amd_display_library::instance().ADL2_Adapter_PMLog_Stop(
+            this->_scope, this->_adapter, this->_device);
+        if (status != ADL_OK) {
+            throw adl_exception(status);
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::adl_pmlog_session::_lock_sessions
+ */
+std::mutex visus::power_overwhelming::detail::adl_pmlog_session::_lock_sessions;
+
+
+/*
+ * visus::power_overwhelming::detail::adl_pmlog_session::_sessions
+ */
+std::map<visus::power_overwhelming::detail::adl_pmlog_session::adapter_type,
+    std::weak_ptr<visus::power_overwhelming::detail::adl_pmlog_session>>
+visus::power_overwhelming::detail::adl_pmlog_session::_sessions;
@@ -0,0 +1,190 @@
+﻿// <copyright file="adl_pmlog_session.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+#include "adl_scope.h"
+#include "amd_display_library.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Manages the PMLog of a single adapter, which is shared between all
+    /// <see cref="adl_sensor" />s on this adapter.
+    /// </summary>
+    /// <remarks>
+    /// <para>Each sensor subscribes to the session with the sensor IDs it is
+    /// interested in and the rate at which it wants them to be updated. The
+    /// session starts logging the union of all sensor IDs at the highest
+    /// requested rate, which requires only a single logging session on the
+    /// SMU regardless of how many sensors are used on the adapter. The
+    /// sensors pick their own readings from the shared log.</para>
+    /// <para>If a new subscription is not covered by the running log, logging
+    /// is restarted with the new configuration. The log keeps running with
+    /// the superset of all sensor IDs until the last subscriber has left.
+    /// </para>
+    /// <para>Sessions are reference-counted. All instances returned by
+    /// <see cref="acquire" /> for the same adapter share the session as long
+    /// as any of them exists.</para>
+    /// </remarks>
+    class adl_pmlog_session final {
+
+    public:
+
+        /// <summary>
+        /// The type of the adapter index identifying the session.
+        /// </summary>
+        typedef decltype(AdapterInfo::iAdapterIndex) adapter_type;
+
+        /// <summary>
+        /// The type used to express the update interval of the PMLog.
+        /// </summary>
+        typedef std::chrono::milliseconds update_interval_type;
+
+        /// <summary>
+        /// The type of the timestamp of the PMLog.
+        /// </summary>
+        typedef decltype(ADLPMLogData::ulLastUpdated) update_type;
+
+        /// <summary>
+        /// Gets the session for the given adapter, creating it if it does not
+        /// yet exist.
+        /// </summary>
+        /// <param name="adapter">The index of the adapter.</param>
+        /// <returns>The session for the adapter.</returns>
+        /// <exception cref="adl_exception">If the PMLog device could not be
+        /// created for a new session.</exception>
+        static std::shared_ptr<adl_pmlog_session> acquire(
+            _In_ const adapter_type adapter);
+
+        adl_pmlog_session(const adl_pmlog_session&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~adl_pmlog_session(void);
+
+        /// <summary>
+        /// Answer the index of the adapter the session is for.
+        /// </summary>
+        /// <returns>The adapter index.</returns>
+        inline adapter_type adapter(void) const noexcept {
+            return this->_adapter;
+        }
+
+        /// <summary>
+        /// Answer whether the PMLog has been updated since
+        /// <paramref name="last_updated" />.
+        /// </summary>
+        /// <param name="last_updated">The timestamp of the PMLog when it was
+        /// last <see cref="read" />.</param>
+        /// <returns><c>true</c> if the PMLog is running and contains new data,
+        /// <c>false</c> otherwise.</returns>
+        bool changed(_In_ const update_type last_updated) const;
+
+        /// <summary>
+        /// Copies the PMLog into <paramref name="dst" />.
+        /// </summary>
+        /// <remarks>
+        /// The copy is retried a few times if the driver updated the PMLog
+        /// while it was being copied, such that all readings in the copy
+        /// belong together.
+        /// </remarks>
+        /// <param name="dst">Receives the copy of the PMLog.</param>
+        /// <exception cref="std::logic_error">If the session is not
+        /// logging.</exception>
+        void read(_Out_ ADLPMLogData& dst) const;
+
+        /// <summary>
+        /// Makes sure that the PMLog contains the sensors and is updated at
+        /// least at the rate in <paramref name="input" />.
+        /// </summary>
+        /// <param name="subscriber">An opaque pointer identifying the
+        /// subscriber, which must be passed to <see cref="unsubscribe" />
+        /// later.</param>
+        /// <param name="input">The sensor IDs and the sampling rate requested
+        /// by the subscriber. A sampling rate of zero indicates that the
+        /// subscriber has no requirement for the rate.</param>
+        /// <exception cref="std::length_error">If the union of all requested
+        /// sensors exceeds the capacity of the PMLog.</exception>
+        /// <exception cref="adl_exception">If the PMLog could not be
+        /// (re-) started.</exception>
+        void subscribe(_In_ const void *subscriber,
+            _In_ const ADLPMLogStartInput& input);
+
+        /// <summary>
+        /// Removes the subscription of <paramref name="subscriber" /> and stops
+        /// logging if it was the last one.
+        /// </summary>
+        /// <param name="subscriber">The subscriber to be removed. It is safe
+        /// to pass a pointer that is not subscribed.</param>
+        /// <exception cref="adl_exception">If the PMLog could not be stopped.
+        /// </exception>
+        void unsubscribe(_In_ const void *subscriber);
+
+        /// <summary>
+        /// Answer the interval at which the driver updates the PMLog.
+        /// </summary>
+        /// <remarks>
+        /// The interval is the active sampling rate reported by the driver
+        /// if available, or the rate requested from the driver otherwise.
+        /// </remarks>
+        /// <returns>The update interval of the PMLog, which is zero if it is
+        /// unknown or if the session is not logging.</returns>
+        update_interval_type update_interval(void) const;
+
+        adl_pmlog_session& operator =(const adl_pmlog_session&) = delete;
+
+    private:
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        explicit adl_pmlog_session(_In_ const adapter_type adapter);
+
+        /// <summary>
+        /// Starts logging with <see cref="_input" />, stopping the previous
+        /// log if it is running.
+        /// </summary>
+        /// <remarks>
+        /// The caller must hold <see cref="_lock" />.
+        /// </remarks>
+        void restart(void);
+
+        /// <summary>
+        /// Stops logging if it is running.
+        /// </summary>
+        /// <remarks>
+        /// The caller must hold <see cref="_lock" />.
+        /// </remarks>
+        void stop(void);
+
+        static std::mutex _lock_sessions;
+        static std::map<adapter_type, std::weak_ptr<adl_pmlog_session>>
+            _sessions;
+
+        adapter_type _adapter;
+        ADL_D3DKMT_HANDLE _device;
+        ADLPMLogStartInput _input;
+        mutable std::mutex _lock;
+        ADLPMLogStartOutput _output;
+        bool _running;
+        adl_scope _scope;
+        std::map<const void *, ADLPMLogStartInput> _subscribers;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
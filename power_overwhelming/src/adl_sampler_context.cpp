@@ -0,0 +1,311 @@
+﻿// <copyright file="adl_sampler_context.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "adl_sampler_context.h"
+
+#include <algorithm>
+
+#include "adl_sensor_impl.h"
+#include "system_trace.h"
+
+
+/*
+ * ...::detail::adl_sampler_context::registration::deliver
+ */
+void visus::power_overwhelming::detail::adl_sampler_context::registration
+::deliver(void) {
+    if (!this->batch.empty()) {
+        assert(this->data_callback != nullptr);
+        this->data_callback(this->name, this->batch.data(),
+            this->batch.size(), this->context);
+        this->batch.clear();
+    }
+}
+
+
+/*
+ * ...::detail::adl_sampler_context::max_batch_latency
+ */
+constexpr visus::power_overwhelming::detail::adl_sampler_context::interval_type
+visus::power_overwhelming::detail::adl_sampler_context::max_batch_latency;
+
+
+/*
+ * ...::detail::adl_sampler_context::adl_sampler_context
+ */
+visus::power_overwhelming::detail::adl_sampler_context::adl_sampler_context(
+        void) : active(std::make_shared<snapshot_type>()), epoch(0),
+        instrumentation(task), running(false),
+        task(&adl_sampler_context::tick, this) { }
+
+
+/*
+ * visus::power_overwhelming::detail::adl_sampler_context::add
+ */
+bool visus::power_overwhelming::detail::adl_sampler_context::add(
+        sensor_type sensor, const measurement_callback callback, void *context) {
+    assert(sensor != nullptr);
+    assert(callback != nullptr);
+    auto registration = std::make_shared<adl_sampler_context::registration>();
+    registration->batch_size = 0;
+    registration->callback = callback;
+    registration->context = context;
+    registration->data_callback = nullptr;
+    registration->name = sensor_name_registry::intern(
+        sensor->sensor_name.c_str());
+    registration->sample_duration = &this->instrumentation.sample_duration(
+        registration->name);
+    return this->add(sensor, std::move(registration));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::adl_sampler_context::add
+ */
+bool visus::power_overwhelming::detail::adl_sampler_context::add(
+        sensor_type sensor, const measurement_data_callback callback,
+        void *context) {
+    assert(sensor != nullptr);
+    assert(callback != nullptr);
+    auto registration = std::make_shared<adl_sampler_context::registration>();
+    registration->batch_size = static_cast<std::size_t>(
+        max_batch_latency / (std::max)(this->interval, interval_type(1)));
+    if (registration->batch_size < 1) {
+        registration->batch_size = 1;
+    }
+    registration->batch.reserve(registration->batch_size);
+    registration->callback = nullptr;
+    registration->context = context;
+    registration->data_callback = callback;
+    registration->name = sensor_name_registry::intern(
+        sensor->sensor_name.c_str());
+    registration->sample_duration = &this->instrumentation.sample_duration(
+        registration->name);
+    return this->add(sensor, std::move(registration));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::adl_sampler_context::clear
+ */
+void visus::power_overwhelming::detail::adl_sampler_context::clear(void) {
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    this->sensors.clear();
+    this->publish();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::adl_sampler_context::remove
+ */
+bool visus::power_overwhelming::detail::adl_sampler_context::remove(
+        sensor_type sensor) {
+    auto is_sampler_thread = false;
+    registration_type registration;
+
+    {
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        auto it = this->sensors.find(sensor);
+        is_sampler_thread = this->task.executing();
+
+        if (it != this->sensors.end()) {
+            registration = std::move(it->second);
+            this->sensors.erase(it);
+            this->publish();
+        }
+    }
+
+    if (registration != nullptr) {
+        if (!is_sampler_thread) {
+            // The sampler thread might still use the old snapshot, so we must
+            // not return until it has finished, because the caller is
+            // typically about to stop and destroy the sensor.
+            this->synchronise();
+        }
+
+        // At this point, the sampler thread cannot access the registration
+        // anymore, so we can deliver the remaining samples of the last batch.
+        if (registration->data_callback != nullptr) {
+            registration->deliver();
+        }
+    }
+
+    return (registration != nullptr);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::adl_sampler_context::sample
+ */
+bool visus::power_overwhelming::detail::adl_sampler_context::sample(void) {
+    typedef sampler_instrumentation::clock_type clock_type;
+    const auto begin = this->instrumentation.begin_tick();
+    const auto converter = get_timestamp_converter(
+        timestamp_resolution::milliseconds);
+    auto have_sensors = true;
+
+    // Mark the begin of the dispatch *before* obtaining the snapshot like the
+    // default_sampler_context does.
+    ++this->epoch;
+    {
+        auto sensors = std::atomic_load(&this->active);
+        assert(sensors != nullptr);
+
+        for (auto& s : *sensors) {
+            auto& r = *s.second;
+
+            // Only copy the PMLog if the driver has written it since we have
+            // looked at it the last time, which prevents duplicate samples and
+            // saves the copy on most of the polls.
+            if (!s.first->changed()) {
+                continue;
+            }
+
+            const auto start = clock_type::now();
+            auto sample = s.first->sample(converter);
+            const auto sampled = clock_type::now();
+            r.sample_duration->record(sampled - start);
+            system_trace::sample(r.name, sample);
+
+            if (r.data_callback != nullptr) {
+                r.batch.push_back(std::move(sample));
+                if (r.batch.size() >= r.batch_size) {
+                    r.deliver();
+                    this->instrumentation.callback_duration().record(
+                        clock_type::now() - sampled);
+                }
+
+            } else {
+                r.callback(measurement(r.name, sample), r.context);
+                this->instrumentation.callback_duration().record(
+                    clock_type::now() - sampled);
+            }
+        }
+
+        have_sensors = !sensors->empty();
+
+        if (!have_sensors) {
+            // Decide about stopping while holding the lock, because a sensor
+            // might have been added after we obtained the snapshot and add()
+            // must know whether it needs to schedule the task again.
+            std::lock_guard<decltype(this->lock)> l(this->lock);
+            have_sensors = !this->sensors.empty();
+            this->running = have_sensors;
+        }
+
+        if (have_sensors) {
+            // The set of sensors or the rate of the driver might have changed,
+            // in which case we restart the task at the new rate.
+            const auto poll = this->poll_interval(*sensors);
+            if (poll != this->task.interval()) {
+                this->task.restart(poll);
+            }
+        }
+    }
+    ++this->epoch;
+
+    this->instrumentation.end_tick(begin);
+    return have_sensors;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::adl_sampler_context::samples
+ */
+bool visus::power_overwhelming::detail::adl_sampler_context::samples(
+        const sensor_type sensor) {
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    return (this->sensors.find(sensor) != this->sensors.end());
+}
+
+
+/*
+ * visus::power_overwhelming::detail::adl_sampler_context::add
+ */
+bool visus::power_overwhelming::detail::adl_sampler_context::add(
+        sensor_type sensor, registration_type&& registration) {
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+
+    if (this->sensors.find(sensor) != this->sensors.end()) {
+        // Sensor is already being sampled, so there is nothing to do.
+        return false;
+    }
+
+    this->sensors.emplace(sensor, std::move(registration));
+    this->publish();
+
+    if (!this->running) {
+        // If this is the first sensor, we need to schedule the task. If the
+        // task is still in its last tick, the scheduler restarts it after the
+        // tick has completed.
+        this->running = true;
+        sampler_scheduler::instance().schedule(this->task,
+            this->poll_interval(*std::atomic_load(&this->active)));
+    }
+
+    return true;
+}
+
+
+/*
+ * ...::detail::adl_sampler_context::poll_interval
+ */
+visus::power_overwhelming::detail::adl_sampler_context::interval_type
+visus::power_overwhelming::detail::adl_sampler_context::poll_interval(
+        const snapshot_type& sensors) const {
+    auto retval = this->interval;
+
+    for (auto& s : sensors) {
+        const auto i = std::chrono::duration_cast<interval_type>(
+            s.first->update_interval());
+        if ((i > interval_type::zero()) && (i < retval)) {
+            retval = i;
+        }
+    }
+
+    // Poll at twice the rate of the fastest PMLog such that we see every
+    // update at most half a period late.
+    retval /= 2;
+    return (std::max)(retval, interval_type(1));
+}
+
+
+/*
+ * ...::detail::adl_sampler_context::publish
+ */
+void visus::power_overwhelming::detail::adl_sampler_context::publish(void) {
+    std::shared_ptr<snapshot_type> snapshot = std::make_shared<snapshot_type>(
+        this->sensors.begin(), this->sensors.end());
+    std::atomic_store(&this->active,
+        std::shared_ptr<const snapshot_type>(std::move(snapshot)));
+}
+
+
+/*
+ * ...::detail::adl_sampler_context::synchronise
+ */
+void visus::power_overwhelming::detail::adl_sampler_context::synchronise(
+        void) const {
+    const auto epoch = this->epoch.load();
+
+    if ((epoch & 1) != 0) {
+        // The sampler thread is within a dispatch, so wait until it has left
+        // it. It is irrelevant whether it entered a new one since then, because
+        // the new dispatch will use the updated snapshot.
+        while (this->epoch.load() == epoch) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::adl_sampler_context::tick
+ */
+bool visus::power_overwhelming::detail::adl_sampler_context::tick(
+        _In_ void *context) {
+    assert(context != nullptr);
+    return static_cast<adl_sampler_context *>(context)->sample();
+}
@@ -0,0 +1,290 @@
+﻿// <copyright file="adl_sampler_context.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cinttypes>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "power_overwhelming/measurement.h"
+
+#include "sampler_instrumentation.h"
+#include "sampler_scheduler.h"
+#include "sensor_name_registry.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /* Forward declarations. */
+    struct adl_sensor_impl;
+
+
+    /// <summary>
+    /// A context represents a task of the <see cref="sampler_scheduler" />
+    /// that handles sampling
+    /// <see cref="adl_sensor" />s at a specific interval.
+    /// </summary>
+    /// <remarks>
+    /// <para>The driver writes the PMLog of an ADL sensor at its own rate,
+    /// which is configured via <c>ADLPMLogStartInput::ulSampleRate</c> when the
+    /// sensor is started. Copying the log on every tick of a fixed timer would
+    /// produce duplicate samples whenever the driver has not updated the log
+    /// since the previous tick. Therefore, the context only peeks at the
+    /// timestamp of the log and delivers a sample if the timestamp has
+    /// changed.</para>
+    /// <para>In order not to miss updates, the context polls at twice the rate
+    /// of the fastest PMLog it samples, but at least at twice the requested
+    /// sampling rate. This way, the context adapts to the rate the driver
+    /// actually uses, which might be different from the requested one.</para>
+    /// </remarks>
+    struct adl_sampler_context {
+
+        /// <summary>
+        /// The type to express sampling intervals.
+        /// </summary>
+        typedef std::chrono::microseconds interval_type;
+
+        /// <summary>
+        /// The type of the sensor implementation, which must be the ADL sensor
+        /// implementation.
+        /// </summary>
+        typedef adl_sensor_impl *sensor_type;
+
+        /// <summary>
+        /// Describes how the samples of a sensor are delivered to the user.
+        /// </summary>
+        struct registration {
+
+            /// <summary>
+            /// The batch of samples that have not yet been delivered to
+            /// <see cref="data_callback" />.
+            /// </summary>
+            /// <remarks>
+            /// The batch is only accessed by the sampler thread while the
+            /// sensor is in the active snapshot.
+            /// </remarks>
+            std::vector<measurement_data> batch;
+
+            /// <summary>
+            /// The number of samples in <see cref="batch" /> that cause the
+            /// batch to be delivered.
+            /// </summary>
+            std::size_t batch_size;
+
+            /// <summary>
+            /// The callback for individual samples, or <c>nullptr</c> if the
+            /// sensor is sampled in batches.
+            /// </summary>
+            measurement_callback callback;
+
+            /// <summary>
+            /// The user-defined context pointer passed to the callback.
+            /// </summary>
+            void *context;
+
+            /// <summary>
+            /// The callback for batches of samples, or <c>nullptr</c> if the
+            /// samples are delivered one by one.
+            /// </summary>
+            measurement_data_callback data_callback;
+
+            /// <summary>
+            /// The interned name of the sensor.
+            /// </summary>
+            const wchar_t *name;
+
+            /// <summary>
+            /// The histogram of the time copying the PMLog takes for the
+            /// sensor, which is owned by <see cref="instrumentation" />.
+            /// </summary>
+            sampler_instrumentation::histogram_type *sample_duration;
+
+            /// <summary>
+            /// Invokes <see cref="data_callback" /> for all samples in
+            /// <see cref="batch" /> and clears the batch.
+            /// </summary>
+            void deliver(void);
+        };
+
+        /// <summary>
+        /// The type that is used to store <see cref="registration" />s, which
+        /// are shared between the <see cref="sensors" /> and the snapshots.
+        /// </summary>
+        typedef std::shared_ptr<registration> registration_type;
+
+        /// <summary>
+        /// The type of an immutable snapshot of the sensors that the sampling
+        /// thread dispatches to.
+        /// </summary>
+        typedef std::vector<std::pair<sensor_type, registration_type>>
+            snapshot_type;
+
+        /// <summary>
+        /// The maximum time a sample may be retained in a batch before it is
+        /// delivered to a <see cref="measurement_data_callback" />.
+        /// </summary>
+        static constexpr interval_type max_batch_latency
+            = std::chrono::milliseconds(10);
+
+        /// <summary>
+        /// The snapshot of <see cref="sensors" /> that is currently being used
+        /// by the sampler thread.
+        /// </summary>
+        /// <remarks>
+        /// This pointer must only be accessed via <c>std::atomic_load</c> and
+        /// <c>std::atomic_store</c>.
+        /// </remarks>
+        std::shared_ptr<const snapshot_type> active;
+
+        /// <summary>
+        /// A counter that is incremented by the sampler thread before and after
+        /// it dispatches to <see cref="active" />.
+        /// </summary>
+        /// <remarks>
+        /// An odd value indicates that the sampler thread is currently using a
+        /// snapshot, which might still contain a sensor that has just been
+        /// removed.
+        /// </remarks>
+        std::atomic<std::uint64_t> epoch;
+
+        /// <summary>
+        /// Records the timing of the ticks of <see cref="task" />.
+        /// </summary>
+        sampler_instrumentation instrumentation;
+
+        /// <summary>
+        /// The sampling interval.
+        /// </summary>
+        interval_type interval;
+
+        /// <summary>
+        /// A lock protecting the list of <see cref="sensors" />.
+        /// </summary>
+        std::mutex lock;
+
+        /// <summary>
+        /// Indicates whether the <see cref="task" /> is scheduled.
+        /// </summary>
+        /// <remarks>
+        /// The flag is protected by <see cref="lock" />. The sampler task
+        /// clears it when it has found <see cref="sensors" /> empty and is
+        /// about to stop, in which case <see cref="add" /> must schedule it
+        /// again.
+        /// </remarks>
+        bool running;
+
+        /// <summary>
+        /// The sensors to sample along with the callback to be invoked.
+        /// </summary>
+        std::map<sensor_type, registration_type> sensors;
+
+        /// <summary>
+        /// The task of the scheduler that periodically checks the PMLogs of
+        /// the <see cref="sensors" /> for updates.
+        /// </summary>
+        /// <remarks>
+        /// The interval of the task is the poll interval, which changes with
+        /// the update rates of the PMLogs.
+        /// </remarks>
+        sampler_scheduler::task task;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        adl_sampler_context(void);
+
+        /// <summary>
+        /// Add the given sensor to the this context.
+        /// </summary>
+        bool add(sensor_type sensor, const measurement_callback callback,
+            void *context);
+
+        /// <summary>
+        /// Add the given sensor to the this context such that its samples are
+        /// delivered in batches.
+        /// </summary>
+        /// <remarks>
+        /// The samples are delivered if the batch covers
+        /// <see cref="max_batch_latency" /> or if the sensor is removed from
+        /// the context.
+        /// </remarks>
+        bool add(sensor_type sensor, const measurement_data_callback callback,
+            void *context);
+
+        /// <summary>
+        /// Remove all sensors from the context, which will make the sampler
+        /// task stop.
+        /// </summary>
+        void clear(void);
+
+        /// <summary>
+        /// Remove the sensor from the context.
+        /// </summary>
+        /// <remarks>
+        /// If the sensor has been removed, the method blocks until the sampler
+        /// task does not use it anymore unless it is called from within a
+        /// callback of the task itself.
+        /// </remarks>
+        bool remove(sensor_type sensor);
+
+        /// <summary>
+        /// Performs one tick of sampling in this context.
+        /// </summary>
+        /// <returns><c>true</c> if the task should continue to be scheduled,
+        /// <c>false</c> if there are no sensors left.</returns>
+        bool sample(void);
+
+        /// <summary>
+        /// Answer whether the given sensor is sampled in this context.
+        /// </summary>
+        bool samples(const sensor_type sensor);
+
+    private:
+
+        /// <summary>
+        /// Add the given registration for the sensor.
+        /// </summary>
+        bool add(sensor_type sensor, registration_type&& registration);
+
+        /// <summary>
+        /// Computes the interval at which the PMLogs of the given sensors must
+        /// be checked in order not to miss an update.
+        /// </summary>
+        interval_type poll_interval(const snapshot_type& sensors) const;
+
+        /// <summary>
+        /// Publishes a new snapshot of <see cref="sensors" /> to the sampler
+        /// task.
+        /// </summary>
+        /// <remarks>
+        /// The caller must hold <see cref="lock" />.
+        /// </remarks>
+        void publish(void);
+
+        /// <summary>
+        /// Blocks the calling thread until the sampler task has completed
+        /// the dispatch that might have been in progress when the method was
+        /// called.
+        /// </summary>
+        void synchronise(void) const;
+
+        /// <summary>
+        /// The callback of <see cref="task" />.
+        /// </summary>
+        static bool tick(_In_ void *context);
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -6,11 +6,38 @@
 #include "adl_scope.h"
 
 #include <cassert>
+#include <mutex>
+#include <vector>
 
 #include "adl_exception.h"
 #include "amd_display_library.h"
 
 
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The pool of ADL contexts shared by all <see cref="adl_scope" />s.
+    /// </summary>
+    struct adl_scope_pool final {
+        std::vector<ADL_CONTEXT_HANDLE> idle;
+        std::mutex lock;
+        bool retained;
+
+        inline adl_scope_pool(void) : retained(false) { }
+
+        static adl_scope_pool& instance(void) {
+            static adl_scope_pool retval;
+            return retval;
+        }
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
 /*
  * visus::power_overwhelming::detail::adl_scope::allocate
  */
@@ -31,10 +58,42 @@ void __stdcall visus::power_overwhelming::detail::adl_scope::deallocate(
 }
 
 
+/*
+ * visus::power_overwhelming::detail::adl_scope::release
+ */
+void visus::power_overwhelming::detail::adl_scope::release(void) noexcept {
+    auto& pool = adl_scope_pool::instance();
+    std::vector<ADL_CONTEXT_HANDLE> idle;
+
+    {
+        std::lock_guard<decltype(pool.lock)> l(pool.lock);
+        pool.retained = false;
+        idle.swap(pool.idle);
+    }
+
+    for (auto h : idle) {
+        amd_display_library::instance().ADL2_Main_Control_Destroy(h);
+    }
+}
+
+
 /*
  * visus::power_overwhelming::detail::adl_scope::adl_scope
  */
 visus::power_overwhelming::detail::adl_scope::adl_scope(void) : _handle(0) {
+    auto& pool = adl_scope_pool::instance();
+
+    {
+        std::lock_guard<decltype(pool.lock)> l(pool.lock);
+        pool.retained = true;
+
+        if (!pool.idle.empty()) {
+            this->_handle = pool.idle.back();
+            pool.idle.pop_back();
+            return;
+        }
+    }
+
     auto status = amd_display_library::instance().ADL2_Main_Control_Create(
         adl_scope::allocate, 1, &this->_handle);
     if (status != ADL_OK) {
@@ -47,5 +106,15 @@ visus::power_overwhelming::detail::adl_scope::adl_scope(void) : _handle(0) {
  * visus::power_overwhelming::detail::adl_scope::~adl_scope
  */
 visus::power_overwhelming::detail::adl_scope::~adl_scope(void) {
+    auto& pool = adl_scope_pool::instance();
+
+    {
+        std::lock_guard<decltype(pool.lock)> l(pool.lock);
+        if (pool.retained) {
+            pool.idle.push_back(this->_handle);
+            return;
+        }
+    }
+
     amd_display_library::instance().ADL2_Main_Control_Destroy(this->_handle);
 }
@@ -16,8 +16,13 @@ namespace detail {
     /// A RAII container for the ADL library.
     /// </summary>
     /// <remarks>
-    /// The implementation represents an ADL2 scope with a separate execution
-    /// context. APIs using the same scope should not be called concurrently.
+    /// <para>The implementation represents an ADL2 scope with a separate
+    /// execution context. APIs using the same scope should not be called
+    /// concurrently.</para>
+    /// <para>As creating a context is very expensive, contexts are not
+    /// destroyed with their scope, but returned to a pool shared by the whole
+    /// process, from which the next scope takes its context. The pooled
+    /// contexts are only destroyed by <see cref="release" />.</para>
     /// </remarks>
     class adl_scope final {
 
@@ -37,6 +42,12 @@ namespace detail {
         /// <param name="buffer"></param>
         static void __stdcall deallocate(void **buffer);
 
+        /// <summary>
+        /// Destroys all pooled contexts and stops pooling the contexts of
+        /// scopes being destroyed until the next scope is created.
+        /// </summary>
+        static void release(void) noexcept;
+
         /// <summary>
         /// Initialises a new instance.
         /// </summary>
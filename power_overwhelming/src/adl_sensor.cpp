@@ -6,7 +6,9 @@
 #include "power_overwhelming/adl_sensor.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cstring>
+#include <stdexcept>
 #include <vector>
 
 #include "power_overwhelming/adl_sensor_source.h"
@@ -15,6 +17,7 @@
 #include "adl_exception.h"
 #include "adl_scope.h"
 #include "adl_sensor_impl.h"
+#include "pci_location.h"
 #include "zero_memory.h"
 
 
@@ -126,32 +129,10 @@ namespace detail {
     template<class TPredicate>
     static std::vector<adl_sensor> for_predicate(const TPredicate& predicate,
             const adl_sensor_source source) {
-        std::vector<AdapterInfo> adapters;
         std::vector<adl_sensor> retval;
         adl_scope scope;
-
-        {
-            int cnt;
-
-            auto status = detail::amd_display_library::instance()
-                .ADL2_Adapter_NumberOfAdapters_Get(scope, &cnt);
-            if (status != ADL_OK) {
-                throw adl_exception(status);
-            }
-
-            adapters.resize(cnt);
-            retval.reserve(cnt);
-        }
-
-        ::ZeroMemory(adapters.data(), adapters.size() * sizeof(AdapterInfo));
-        {
-            auto status = detail::amd_display_library::instance()
-                .ADL2_Adapter_AdapterInfo_Get(scope, adapters.data(),
-                    static_cast<int>(adapters.size() * sizeof(AdapterInfo)));
-            if (status != ADL_OK) {
-                throw adl_exception(status);
-            }
-        }
+        const auto adapters = adl_sensor_impl::get_adapters(scope);
+        retval.reserve(adapters.size());
 
         for (auto& a : adapters) {
             if (predicate(a)) {
@@ -174,31 +155,9 @@ std::size_t visus::power_overwhelming::adl_sensor::for_all(
         _Out_writes_opt_(cntSensors) adl_sensor *outSensors,
         _In_ const std::size_t cntSensors) {
     try {
-        int cnt = 0;
         std::vector<adl_sensor> retval;
         detail::adl_scope scope;
-
-        // Find out how many adapters we know.
-        {
-            auto status = detail::amd_display_library::instance()
-                .ADL2_Adapter_NumberOfAdapters_Get(scope, &cnt);
-            if (status != ADL_OK) {
-                throw adl_exception(status);
-            }
-        }
-
-        // Get the descriptors for all the adapters.
-        std::vector<AdapterInfo> adapters(cnt);
-        ::ZeroMemory(adapters.data(), adapters.size() * sizeof(AdapterInfo));
-
-        {
-            auto status = detail::amd_display_library::instance()
-                .ADL2_Adapter_AdapterInfo_Get(scope, adapters.data(),
-                static_cast<int>(adapters.size() * sizeof(AdapterInfo)));
-            if (status != ADL_OK) {
-                throw adl_exception(status);
-            }
-        }
+        const auto adapters = detail::adl_sensor_impl::get_adapters(scope);
 
         // For each adapter, get all supported sensors.
         for (auto& a : adapters) {
@@ -230,11 +189,7 @@ visus::power_overwhelming::adl_sensor::from_index(_In_ const int index,
         _In_ const adl_sensor_source source) {
     adl_sensor retval;
 
-    auto status = detail::amd_display_library::instance()
-        .ADL2_Device_PMLog_Device_Create(nullptr, index, &retval._impl->device);
-    if (status != ADL_OK) {
-        throw adl_exception(status);
-    }
+    retval._impl->session = detail::adl_pmlog_session::acquire(index);
 
     throw "TODO";
 
@@ -242,6 +197,39 @@ visus::power_overwhelming::adl_sensor::from_index(_In_ const int index,
 }
 
 
+/*
+ * visus::power_overwhelming::adl_sensor::from_luid
+ */
+visus::power_overwhelming::adl_sensor
+visus::power_overwhelming::adl_sensor::from_luid(_In_ const std::uint64_t luid,
+        _In_ const adl_sensor_source source) {
+    const auto location = detail::get_pci_location(luid);
+
+    // ADL reports an adapter for each display output of the same GPU, so we
+    // only create sensors for the first one on the location.
+    auto found = false;
+    auto retval = detail::for_predicate([&](const AdapterInfo &a) {
+        if (found) {
+            return false;
+        }
+
+        detail::pci_location l;
+        l.bus = static_cast<std::uint32_t>(a.iBusNumber);
+        l.device = static_cast<std::uint32_t>(a.iDeviceNumber);
+        l.function = static_cast<std::uint32_t>(a.iFunctionNumber);
+        found = (l == location);
+        return found;
+    }, source);
+
+    if (retval.size() != 1) {
+        throw std::invalid_argument("The specified adapter is not an AMD "
+            "device or the sensor source did not match a single sensor.");
+    }
+
+    return std::move(retval.front());
+}
+
+
 /*
  * visus::power_overwhelming::adl_sensor::from_udid
  */
@@ -277,6 +265,25 @@ visus::power_overwhelming::adl_sensor::from_udid(_In_z_ const wchar_t *udid,
 }
 
 
+/*
+ * visus::power_overwhelming::adl_sensor::sample_data
+ */
+void visus::power_overwhelming::adl_sensor::sample_data(
+        _Out_writes_(cnt) measurement_data *dst,
+        _In_reads_(cnt) const adl_sensor *sensors,
+        _In_ const std::size_t cnt,
+        _In_ const timestamp_resolution resolution) {
+    if ((cnt > 0) && ((dst == nullptr) || (sensors == nullptr))) {
+        throw std::invalid_argument("The output and the sensors must be "
+            "valid if sensors are to be sampled.");
+    }
+
+    for (std::size_t i = 0; i < cnt; ++i) {
+        dst[i] = sensors[i].sample_data(resolution);
+    }
+}
+
+
 /*
  * visus::power_overwhelming::adl_sensor::adl_sensor
  */
@@ -305,6 +312,17 @@ _Ret_maybenull_z_ const wchar_t *visus::power_overwhelming::adl_sensor::name(
 }
 
 
+/*
+ * visus::power_overwhelming::adl_sensor::native_interval
+ */
+visus::power_overwhelming::sensor::microseconds_type
+visus::power_overwhelming::adl_sensor::native_interval(void) const {
+    this->check_not_disposed();
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        this->_impl->update_interval()).count();
+}
+
+
 /*
  * visus::power_overwhelming::adl_sensor::sample
  */
@@ -344,6 +362,45 @@ void visus::power_overwhelming::adl_sensor::sample(
 }
 
 
+/*
+ * visus::power_overwhelming::adl_sensor::sample_batch
+ */
+void visus::power_overwhelming::adl_sensor::sample_batch(
+        _In_opt_ const measurement_data_callback on_batch,
+        _In_ const microseconds_type period,
+        _In_opt_ void *context) {
+    using std::chrono::duration_cast;
+    typedef decltype(detail::adl_sensor_impl::sampler)::interval_type
+        interval_type;
+
+    this->check_not_disposed();
+
+    if (on_batch != nullptr) {
+        auto sampler_rate = interval_type(period);
+        auto adl_rate = duration_cast<std::chrono::milliseconds>(sampler_rate);
+
+        // Make sure that the sensor is running before queuing to the thread.
+        if (!this->_impl->running()) {
+            this->_impl->start(static_cast<unsigned long>(adl_rate.count()));
+        }
+
+        if (!detail::adl_sensor_impl::sampler.add(this->_impl, on_batch,
+                context, sampler_rate)) {
+            throw std::logic_error("Asynchronous sampling cannot be started "
+                "while it is already running.");
+        }
+
+    } else {
+        detail::adl_sensor_impl::sampler.remove(this->_impl);
+
+        if (!detail::adl_sensor_impl::sampler.samples()) {
+            // If there is no sensor left to sample, stop the sensor.
+            this->_impl->stop();
+        }
+    }
+}
+
+
 /*
  * visus::power_overwhelming::adl_sensor::start
  */
@@ -418,12 +475,15 @@ visus::power_overwhelming::adl_sensor::operator bool(void) const noexcept {
 
 
 /*
- * visus::power_overwhelming::adl_sensor::sample_sync
+ * visus::power_overwhelming::adl_sensor::sample_data
  */
 visus::power_overwhelming::measurement_data
-visus::power_overwhelming::adl_sensor::sample_sync(
+visus::power_overwhelming::adl_sensor::sample_data(
         _In_ const timestamp_resolution resolution) const {
-    this->check_not_disposed();
+    if (!*this) {
+        // The class is final, so this does not require a virtual call.
+        throw_disposed();
+    }
     const auto is_running = this->_impl->running();
 
     if (!is_running) {
@@ -441,3 +501,13 @@ visus::power_overwhelming::adl_sensor::sample_sync(
 
     return retval;
 }
+
+
+/*
+ * visus::power_overwhelming::adl_sensor::sample_sync
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::adl_sensor::sample_sync(
+        _In_ const timestamp_resolution resolution) const {
+    return this->sample_data(resolution);
+}
@@ -36,7 +36,9 @@ visus::power_overwhelming::detail::adl_sensor_impl::count_sensor_readings(
 std::size_t
 visus::power_overwhelming::detail::adl_sensor_impl::filter_sensor_readings(
         unsigned int& voltage, unsigned int& current, unsigned int& power,
-        const ADLPMLogData& data) {
+        const ADLPMLogData& data, const ADLPMLogStartInput& selection) {
+    const auto selection_end = std::find(selection.usSensors,
+        selection.usSensors + ADL_PMLOG_MAX_SENSORS, ADL_SENSOR_MAXTYPES);
     auto have_current = false;
     auto have_power = false;
     auto have_voltage = false;
@@ -46,6 +48,11 @@ visus::power_overwhelming::detail::adl_sensor_impl::filter_sensor_readings(
             && (data.ulValues[i][0] != ADL_SENSOR_MAXTYPES); ++i) {
         auto s = static_cast<ADL_PMLOG_SENSORS>(data.ulValues[i][0]);
 
+        if (std::find(selection.usSensors, selection_end, s) == selection_end) {
+            // This is a reading requested by another sensor sharing the log.
+            continue;
+        }
+
         if (is_power(s)) {
             power = data.ulValues[i][1];
             have_power = true;
@@ -207,12 +214,52 @@ bool visus::power_overwhelming::detail::adl_sensor_impl::is_voltage(
 }
 
 
+/*
+ * visus::power_overwhelming::detail::adl_sensor_impl::adapters
+ */
+visus::power_overwhelming::detail::cached_discovery<AdapterInfo>
+visus::power_overwhelming::detail::adl_sensor_impl::adapters;
+
+
+/*
+ * visus::power_overwhelming::detail::adl_sensor_impl::get_adapters
+ */
+std::vector<AdapterInfo>
+visus::power_overwhelming::detail::adl_sensor_impl::get_adapters(
+        _In_ adl_scope& scope) {
+    return adapters.get([&scope](void) {
+        int cnt = 0;
+
+        {
+            auto status = amd_display_library::instance()
+                .ADL2_Adapter_NumberOfAdapters_Get(scope, &cnt);
+            if (status != ADL_OK) {
+                throw adl_exception(status);
+            }
+        }
+
+        std::vector<AdapterInfo> retval(cnt);
+        ::ZeroMemory(retval.data(), retval.size() * sizeof(AdapterInfo));
+
+        {
+            auto status = amd_display_library::instance()
+                .ADL2_Adapter_AdapterInfo_Get(scope, retval.data(),
+                static_cast<int>(retval.size() * sizeof(AdapterInfo)));
+            if (status != ADL_OK) {
+                throw adl_exception(status);
+            }
+        }
+
+        return retval;
+    });
+}
+
+
 /*
  * visus::power_overwhelming::detail::adl_sensor_impl::sampler
  */
 visus::power_overwhelming::detail::sampler<
-    visus::power_overwhelming::detail::default_sampler_context<
-    visus::power_overwhelming::detail::adl_sensor_impl>>
+    visus::power_overwhelming::detail::adl_sampler_context>
 visus::power_overwhelming::detail::adl_sensor_impl::sampler;
 
 
@@ -220,8 +267,8 @@ visus::power_overwhelming::detail::adl_sensor_impl::sampler;
  * visus::power_overwhelming::detail::adl_sensor_impl::adl_sensor_impl
  */
 visus::power_overwhelming::detail::adl_sensor_impl::adl_sensor_impl(void)
-    : adapter_index(0), device(0), source(adl_sensor_source::all),
-    start_input({ 0 }), start_output({ 0 }), state(0) { }
+    : adapter_index(0), last_updated(0), source(adl_sensor_source::all),
+    start_input({ 0 }), state(0) { }
 
 
 /*
@@ -229,16 +276,10 @@ visus::power_overwhelming::detail::adl_sensor_impl::adl_sensor_impl(void)
  */
 visus::power_overwhelming::detail::adl_sensor_impl::adl_sensor_impl(
         const AdapterInfo& adapterInfo)
-    : adapter_index(adapterInfo.iAdapterIndex), device(0),
-        source(adl_sensor_source::all), start_input({ 0 }),
-        start_output({ 0 }), state(0), udid(adapterInfo.strUDID) {
-    auto status = detail::amd_display_library::instance()
-        .ADL2_Device_PMLog_Device_Create(this->scope, this->adapter_index,
-        &this->device);
-    if (status != ADL_OK) {
-        throw adl_exception(status);
-    }
-
+    : adapter_index(adapterInfo.iAdapterIndex), last_updated(0),
+        session(adl_pmlog_session::acquire(adapterInfo.iAdapterIndex)),
+        source(adl_sensor_source::all), start_input({ 0 }), state(0),
+        udid(adapterInfo.strUDID) {
     this->device_name = power_overwhelming::convert_string<wchar_t>(
         adapterInfo.strAdapterName);
 }
@@ -248,15 +289,27 @@ visus::power_overwhelming::detail::adl_sensor_impl::adl_sensor_impl(
  * visus::power_overwhelming::detail::adl_sensor_impl::~adl_sensor_impl
  */
 visus::power_overwhelming::detail::adl_sensor_impl::~adl_sensor_impl(void) {
-    if (this->device != 0) {
-        // Note: AMD's sample uses zero as guard as well, so we assume this is
-        // safe to do.
-        amd_display_library::instance().ADL2_Device_PMLog_Device_Destroy(
-            this->scope, this->device);
+    if (this->session != nullptr) {
+        // Make sure that a sensor that is still running does not keep the
+        // shared log running. The session itself is released once the last
+        // sensor on the adapter is gone.
+        try {
+            this->session->unsubscribe(this);
+        } catch (...) { }
     }
 }
 
 
+/*
+ * visus::power_overwhelming::detail::adl_sensor_impl::changed
+ */
+bool visus::power_overwhelming::detail::adl_sensor_impl::changed(
+        void) const {
+    assert(this->session != nullptr);
+    return this->session->changed(this->last_updated);
+}
+
+
 /*
  * visus::power_overwhelming::detail::adl_sensor_impl::configure_source
  */
@@ -320,17 +373,23 @@ void visus::power_overwhelming::detail::adl_sensor_impl::configure_source(
  */
 visus::power_overwhelming::measurement_data
 visus::power_overwhelming::detail::adl_sensor_impl::sample(
-        const timestamp_resolution resolution) {
+        const timestamp_converter converter) {
+    assert(converter != nullptr);
     assert(this->state.load() == 1);
-    const auto data = static_cast<ADLPMLogData *>(
-        this->start_output.pLoggingAddress);
     static constexpr auto thousand = static_cast<measurement::value_type>(1000);
 
+    // Take all readings from the same copy such that voltage, current and power
+    // are guaranteed to belong together.
+    ADLPMLogData data;
+    assert(this->session != nullptr);
+    this->session->read(data);
+    this->last_updated = data.ulLastUpdated;
+
     // We found empirically that the timestamp from ADL is in 100 ns units (at
     // least on Windows). Based on this assumption, convert to the requested
     // unit.
-    auto timestamp = convert(static_cast<measurement::timestamp_type>(
-        data->ulLastUpdated), resolution);
+    auto timestamp = converter(static_cast<measurement::timestamp_type>(
+        data.ulLastUpdated));
 
     // MAJOR HAZARD HERE!!! WE HAVE NO IDEA WHAT UNIT IS USED FOR VOLTAGE AND
     // CURRENT. The documentation says nothing about this, but some overclocking
@@ -338,7 +397,8 @@ visus::power_overwhelming::detail::adl_sensor_impl::sample(
     // current in A and power in W.
 
     unsigned int current, power, voltage;
-    switch (filter_sensor_readings(voltage, current, power, *data)) {
+    switch (filter_sensor_readings(voltage, current, power, data,
+            this->start_input)) {
         case 1:
             // If we have one reading, it must be a power reading due to the way
             // we enumerate the sensors in get_sensor_ids.
@@ -379,15 +439,21 @@ void visus::power_overwhelming::detail::adl_sensor_impl::start(
     }
 
     this->start_input.ulSampleRate = samplingRate;
+    this->last_updated = 0;
+
+    try {
+        if (this->session == nullptr) {
+            throw std::runtime_error("The ADL sensor cannot be started, "
+                "because it is not associated with an adapter.");
+        }
 
-    auto status = detail::amd_display_library::instance()
-        .ADL2_Adapter_PMLog_Start(this->scope, this->adapter_index,
-            &this->start_input, &this->start_output, this->device);
-    if (status == ADL_OK) {
+        // Subscribing to the shared log of the adapter only restarts the log
+        // if our sensors or our rate are not yet covered by it.
+        this->session->subscribe(this, this->start_input);
         this->state.store(1, std::memory_order::memory_order_release);
-    } else {
+    } catch (...) {
         this->state.store(0, std::memory_order::memory_order_release);
-        throw new adl_exception(status);
+        throw;
     }
 }
 
@@ -400,19 +466,30 @@ void visus::power_overwhelming::detail::adl_sensor_impl::stop(void) {
     if (this->state.compare_exchange_strong(expected, 2)) {
         // Note: Transitioning to two will ensure that the sensor cannot be
         // started or stopped by another thread while we are tearing it down.
+        assert(this->session != nullptr);
+
+        try {
+            this->session->unsubscribe(this);
+        } catch (...) {
+            // Note: The sensor is broken if we marked it running and cannot
+            // stop it, so we still mark it as not running in order to allow
+            // the user to restart it (this might be an unreasonable approach
+            // so).
+            this->state.store(0, std::memory_order::memory_order_release);
+            throw;
+        }
 
-        auto status = detail::amd_display_library::instance()
-            .ADL2_Adapter_PMLog_Stop(this->scope, this->adapter_index,
-                this->device);
-
-        // Note: The sensor is broken if we marked it running and cannot stop
-        // it, so we still mark it as not running in order to allow the user
-        // to restart it (this might be an unreasonable approach so).
         this->state.store(0, std::memory_order::memory_order_release);
-
-        if (status != ADL_OK) {
-            throw new adl_exception(status);
-        }
     }
 }
 
+
+/*
+ * visus::power_overwhelming::detail::adl_sensor_impl::update_interval
+ */
+visus::power_overwhelming::detail::adl_sensor_impl::update_interval_type
+visus::power_overwhelming::detail::adl_sensor_impl::update_interval(
+        void) const {
+    assert(this->session != nullptr);
+    return this->session->update_interval();
+}
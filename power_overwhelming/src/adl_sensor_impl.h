@@ -6,13 +6,18 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <functional>
+#include <memory>
 #include <vector>
 
 #include "power_overwhelming/adl_sensor_source.h"
 #include "power_overwhelming/measurement.h"
 
+#include "adl_pmlog_session.h"
+#include "adl_sampler_context.h"
 #include "adl_scope.h"
+#include "cached_discovery.h"
 #include "amd_display_library.h"
 #include "sampler.h"
 #include "timestamp.h"
@@ -41,12 +46,15 @@ namespace detail {
         /// <param name="current"></param>
         /// <param name="power"></param>
         /// <param name="data"></param>
+        /// <param name="selection">The sensors the caller is interested in.
+        /// As the log might be shared with other sensors, readings of any
+        /// other sensor are ignored.</param>
         /// <returns>The number of readings returned. If this is 1, only power
         /// has been set. If it is 2, voltage and current have been set.
         /// Otherwise, all values are set.</returns>
         static std::size_t filter_sensor_readings(unsigned int& voltage,
             unsigned int& current, unsigned int& power,
-            const ADLPMLogData& data);
+            const ADLPMLogData& data, const ADLPMLogStartInput& selection);
 
         /// <summary>
         /// Find the index of the first sensor in <paramref name="data" />
@@ -112,10 +120,38 @@ namespace detail {
         static bool is_voltage(const ADL_PMLOG_SENSORS id);
 
         /// <summary>
-        /// A sampler for ADL sensors.
+        /// The descriptors of all adapters known to ADL, which are enumerated
+        /// only once until the <see cref="device_catalogue" /> changes.
         /// </summary>
-        static detail::sampler<default_sampler_context<
-            adl_sensor_impl>> sampler;
+        static cached_discovery<AdapterInfo> adapters;
+
+        /// <summary>
+        /// Gets the descriptors of all adapters from the cache in
+        /// <see cref="adapters" /> or enumerates them if the cache is not
+        /// valid.
+        /// </summary>
+        /// <param name="scope">The ADL scope used for enumerating the
+        /// adapters.</param>
+        /// <returns>The descriptors of all adapters.</returns>
+        /// <exception cref="adl_exception">If the adapters could not be
+        /// enumerated.</exception>
+        static std::vector<AdapterInfo> get_adapters(_In_ adl_scope& scope);
+
+        /// <summary>
+        /// A sampler for ADL sensors, which only delivers samples if the
+        /// PMLog has been updated.
+        /// </summary>
+        static detail::sampler<adl_sampler_context> sampler;
+
+        /// <summary>
+        /// The type used to express the update interval of the PMLog.
+        /// </summary>
+        typedef adl_pmlog_session::update_interval_type update_interval_type;
+
+        /// <summary>
+        /// The type of the timestamp of the PMLog.
+        /// </summary>
+        typedef adl_pmlog_session::update_type update_type;
 
         /// <summary>
         /// The adpater index of the device, which is required for a series of
@@ -124,14 +160,19 @@ namespace detail {
         decltype(AdapterInfo::iAdapterIndex) adapter_index;
 
         /// <summary>
-        /// The handle for the device the sensor is working on.
+        /// The name of the device.
         /// </summary>
-        ADL_D3DKMT_HANDLE device;
+        std::wstring device_name;
 
         /// <summary>
-        /// The name of the device.
+        /// The value of <c>ADLPMLogData::ulLastUpdated</c> when the sensor was
+        /// last sampled.
         /// </summary>
-        std::wstring device_name;
+        /// <remarks>
+        /// This value allows for determining whether the PMLog has been
+        /// updated by the driver since the last sample.
+        /// </remarks>
+        update_type last_updated;
 
         /// <summary>
         /// The ADL scope making sure the library is ready while the sensor
@@ -145,20 +186,21 @@ namespace detail {
         std::wstring sensor_name;
 
         /// <summary>
-        /// The input for the sensor start function (selection of sensors to
-        /// report).
+        /// The PMLog session of the adapter, which is shared with all other
+        /// sensors on the same adapter.
         /// </summary>
-        ADLPMLogStartInput start_input;
+        std::shared_ptr<adl_pmlog_session> session;
 
         /// <summary>
-        /// The output of the sensor start function (valid only as long as the
-        /// sensor is running).
+        /// The input for the sensor start function (selection of sensors to
+        /// report), which is the subscription of the sensor to the
+        /// <see cref="session" />.
         /// </summary>
-        ADLPMLogStartOutput start_output;
+        ADLPMLogStartInput start_input;
 
         /// <summary>
-        /// Remembers whether the sensor is running and sampling asynchronously
-        /// to <see cref="start_output" />.
+        /// Remembers whether the sensor is subscribed to the PMLog of the
+        /// <see cref="session" />.
         /// </summary>
         /// <remarks>
         /// The following values are used here: zero, if the sensor is not
@@ -201,6 +243,18 @@ namespace detail {
         void configure_source(const adl_sensor_source source,
             std::vector<ADL_PMLOG_SENSORS>&& sensorIDs);
 
+        /// <summary>
+        /// Answer whether the driver has updated the PMLog since the sensor
+        /// has been sampled last.
+        /// </summary>
+        /// <remarks>
+        /// This method only peeks at the timestamp of the PMLog and is
+        /// therefore much cheaper than <see cref="sample" />.
+        /// </remarks>
+        /// <returns><c>true</c> if the PMLog contains new data, <c>false</c>
+        /// otherwise.</returns>
+        bool changed(void) const;
+
         /// <summary>
         /// Checks whether <see cref="state" /> represents the running
         /// state (not stopped or transitional).
@@ -219,10 +273,14 @@ namespace detail {
         /// results. The implementation does not verify that, though, for
         /// performance reasons. Callers must make sure that this invariant
         /// is met.</para>
-        /// <para>The method checks how the data in <see cref="start_output" />
-        /// are best converted into an instance of <see cref="measurement" />
+        /// <para>The method checks how the data in the log of the
+        /// <see cref="session" /> are best converted into an instance of <see cref="measurement" />
         /// (based on the sensor readings available) and creates the instance
         /// for the <see cref="sensor_name" />.</para>
+        /// <para>All sensor readings are taken from the same copy of the
+        /// PMLog. Readings of sensors that other <see cref="adl_sensor" />s
+        /// requested from the shared log are ignored. The timestamp of the
+        /// copy is remembered in <see cref="last_updated" />.</para>
         /// <para>Valid combinations of input data are: power measurements only,
         /// measurements of voltage and current and measurement of all of the
         /// sensors before. Any other combination will cause the method to
@@ -235,12 +293,33 @@ namespace detail {
         /// <param name="resolution">The resolution of the timestamp being
         /// returned.</param>
         /// <returns>The current measurement from the sensor.</returns>
-        measurement_data sample(const timestamp_resolution resolution
-            = timestamp_resolution::milliseconds);
+        inline measurement_data sample(const timestamp_resolution resolution
+                = timestamp_resolution::milliseconds) {
+            return this->sample(get_timestamp_converter(resolution));
+        }
+
+        /// <summary>
+        /// Sample the sensor using a timestamp converter that has been
+        /// resolved in advance.
+        /// </summary>
+        /// <remarks>
+        /// This is the same as the overload accepting a resolution, but saves
+        /// the sampler contexts from selecting the conversion for every
+        /// sample.
+        /// </remarks>
+        /// <param name="converter">The converter creating the timestamp of the
+        /// requested resolution from the 100 ns time stamp of ADL.</param>
+        /// <returns>The current measurement from the sensor.</returns>
+        measurement_data sample(const timestamp_converter converter);
 
         /// <summary>
         /// Starts the source if not yet running.
         /// </summary>
+        /// <remarks>
+        /// The source is started by subscribing to the <see cref="session" />,
+        /// which only restarts the PMLog of the adapter if the sensors or
+        /// the sampling rate are not yet covered by the log.
+        /// </remarks>
         /// <param name="samplingRate">The sampling rate at which the sensor
         /// should update.</param>
         /// <exception cref="std::runtime_error">If the method is called when
@@ -252,7 +331,22 @@ namespace detail {
         /// <summary>
         /// Stops the source if <see cref="state" /> is <c>1</c>.
         /// </summary>
+        /// <remarks>
+        /// The PMLog of the adapter is only stopped once all sensors on the
+        /// adapter have been stopped.
+        /// </remarks>
         void stop(void);
+
+        /// <summary>
+        /// Answer the interval at which the driver updates the PMLog.
+        /// </summary>
+        /// <remarks>
+        /// As the log is shared between all sensors on the adapter, it might
+        /// be updated faster than requested via <see cref="start_input" />.
+        /// </remarks>
+        /// <returns>The update interval of the PMLog, which is zero if it is
+        /// unknown.</returns>
+        update_interval_type update_interval(void) const;
     };
 
 } /* namespace detail */
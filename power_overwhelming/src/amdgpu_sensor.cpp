@@ -0,0 +1,269 @@
+﻿// <copyright file="amdgpu_sensor.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/amdgpu_sensor.h"
+
+#include <cassert>
+#include <stdexcept>
+#include <system_error>
+
+#include "power_overwhelming/convert_string.h"
+
+#include "amdgpu_sensor_impl.h"
+
+
+/*
+ * visus::power_overwhelming::amdgpu_sensor::for_all
+ */
+std::size_t visus::power_overwhelming::amdgpu_sensor::for_all(
+        _Out_writes_opt_(cnt_sensors) amdgpu_sensor *out_sensors,
+        _In_ const std::size_t cnt_sensors) {
+    static const amdgpu_sensor_source sources[] = {
+        amdgpu_sensor_source::average_power,
+        amdgpu_sensor_source::instantaneous_power,
+        amdgpu_sensor_source::energy
+    };
+    std::size_t retval = 0;
+
+    for (auto& b : detail::amdgpu_sensor_impl::get_bus_ids()) {
+        for (auto s : sources) {
+            try {
+                // Which attributes are supported depends on the ASIC, so we
+                // just try to open and read all of them. If there is no
+                // space left in the output, we still need to check the
+                // attribute in order to return the correct number.
+                if (retval < cnt_sensors) {
+                    auto& sensor = out_sensors[retval];
+                    assert(sensor._impl != nullptr);
+                    sensor._impl->set(b, s);
+                } else {
+                    detail::amdgpu_sensor_impl().set(b, s);
+                }
+
+                ++retval;
+            } catch (const std::runtime_error&) {
+                // The attribute is not available for this GPU.
+            }
+        }
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::amdgpu_sensor::from_bus_id
+ */
+visus::power_overwhelming::amdgpu_sensor
+visus::power_overwhelming::amdgpu_sensor::from_bus_id(
+        _In_z_ const char *bus_id,
+        _In_ const amdgpu_sensor_source source) {
+    if (bus_id == nullptr) {
+        throw std::invalid_argument("The PCI bus ID of the GPU must not be "
+            "null.");
+    }
+
+    amdgpu_sensor retval;
+    assert(retval._impl != nullptr);
+    retval._impl->set(bus_id, source);
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::amdgpu_sensor::from_bus_id
+ */
+visus::power_overwhelming::amdgpu_sensor
+visus::power_overwhelming::amdgpu_sensor::from_bus_id(
+        _In_z_ const wchar_t *bus_id,
+        _In_ const amdgpu_sensor_source source) {
+    if (bus_id == nullptr) {
+        throw std::invalid_argument("The PCI bus ID of the GPU must not be "
+            "null.");
+    }
+
+    auto b = power_overwhelming::convert_string<char>(bus_id);
+    return from_bus_id(b.c_str(), source);
+}
+
+
+/*
+ * visus::power_overwhelming::amdgpu_sensor::sample_data
+ */
+void visus::power_overwhelming::amdgpu_sensor::sample_data(
+        _Out_writes_(cnt) measurement_data *dst,
+        _In_reads_(cnt) const amdgpu_sensor *sensors,
+        _In_ const std::size_t cnt,
+        _In_ const timestamp_resolution resolution) {
+    if ((cnt > 0) && ((dst == nullptr) || (sensors == nullptr))) {
+        throw std::invalid_argument("The output and the sensors must be "
+            "valid if sensors are to be sampled.");
+    }
+
+    for (std::size_t i = 0; i < cnt; ++i) {
+        dst[i] = sensors[i].sample_data(resolution);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::amdgpu_sensor::amdgpu_sensor
+ */
+visus::power_overwhelming::amdgpu_sensor::amdgpu_sensor(void)
+    : _impl(new detail::amdgpu_sensor_impl()) { }
+
+
+/*
+ * visus::power_overwhelming::amdgpu_sensor::~amdgpu_sensor
+ */
+visus::power_overwhelming::amdgpu_sensor::~amdgpu_sensor(void) {
+    detail::amdgpu_sensor_impl::sampler.remove(this->_impl);
+    // Make sure that the generic sampler thread does not use the sensor
+    // anymore.
+    this->sample_batch(nullptr);
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::amdgpu_sensor::bus_id
+ */
+_Ret_z_ const char *visus::power_overwhelming::amdgpu_sensor::bus_id(
+        void) const {
+    this->check_not_disposed();
+    return this->_impl->bus_id.c_str();
+}
+
+
+/*
+ * visus::power_overwhelming::amdgpu_sensor::energy
+ */
+double visus::power_overwhelming::amdgpu_sensor::energy(void) const {
+    this->check_not_disposed();
+    return (this->_impl->source == amdgpu_sensor_source::energy)
+        ? this->_impl->read() / 1000000.0
+        : 0.0;
+}
+
+
+/*
+ * visus::power_overwhelming::amdgpu_sensor::name
+ */
+_Ret_maybenull_z_
+const wchar_t *visus::power_overwhelming::amdgpu_sensor::name(
+        void) const noexcept {
+    return (this->_impl != nullptr)
+        ? this->_impl->sensor_name.c_str()
+        : nullptr;
+}
+
+
+/*
+ * visus::power_overwhelming::amdgpu_sensor::native_interval
+ */
+visus::power_overwhelming::sensor::microseconds_type
+visus::power_overwhelming::amdgpu_sensor::native_interval(void) const {
+    // The driver caches the metrics table of the SMU for one millisecond,
+    // so reading the attributes more often yields the same values.
+    this->check_not_disposed();
+    return 1000;
+}
+
+
+/*
+ * visus::power_overwhelming::amdgpu_sensor::sample
+ */
+void visus::power_overwhelming::amdgpu_sensor::sample(
+        _In_opt_ const measurement_callback on_measurement,
+        _In_ const microseconds_type period,
+        _In_ const timestamp_resolution timestamp_resolution,
+        _In_opt_ void *context) {
+    typedef decltype(detail::amdgpu_sensor_impl::sampler)::interval_type
+        interval_type;
+
+    this->check_not_disposed();
+
+    if (on_measurement != nullptr) {
+        if (!detail::amdgpu_sensor_impl::sampler.add(this->_impl,
+                on_measurement, context, interval_type(period))) {
+            throw std::logic_error("Asynchronous sampling cannot be started "
+                "while it is already running.");
+        }
+
+    } else {
+        detail::amdgpu_sensor_impl::sampler.remove(this->_impl, context);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::amdgpu_sensor::sample_adaptive
+ */
+void visus::power_overwhelming::amdgpu_sensor::sample_adaptive(
+        _In_opt_ const measurement_data_callback on_batch,
+        _In_ const microseconds_type min_period,
+        _In_ const microseconds_type max_period,
+        _In_opt_ void *context) {
+    this->sample_adaptive_sync(on_batch, min_period, max_period, context);
+}
+
+
+/*
+ * visus::power_overwhelming::amdgpu_sensor::source
+ */
+visus::power_overwhelming::amdgpu_sensor_source
+visus::power_overwhelming::amdgpu_sensor::source(void) const {
+    this->check_not_disposed();
+    return this->_impl->source;
+}
+
+
+/*
+ * visus::power_overwhelming::amdgpu_sensor::operator =
+ */
+visus::power_overwhelming::amdgpu_sensor&
+visus::power_overwhelming::amdgpu_sensor::operator =(
+        _In_ amdgpu_sensor&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        detail::amdgpu_sensor_impl::sampler.remove(this->_impl);
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::amdgpu_sensor::operator bool
+ */
+visus::power_overwhelming::amdgpu_sensor::operator bool(void) const noexcept {
+    return ((this->_impl != nullptr) && (this->_impl->file >= 0));
+}
+
+
+/*
+ * visus::power_overwhelming::amdgpu_sensor::sample_data
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::amdgpu_sensor::sample_data(
+        _In_ const timestamp_resolution resolution) const {
+    if (!*this) {
+        // The class is final, so this does not require a virtual call.
+        throw_disposed();
+    }
+    return this->_impl->sample(resolution);
+}
+
+
+/*
+ * visus::power_overwhelming::amdgpu_sensor::sample_sync
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::amdgpu_sensor::sample_sync(
+        _In_ const timestamp_resolution resolution) const {
+    return this->sample_data(resolution);
+}
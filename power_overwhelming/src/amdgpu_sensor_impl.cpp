@@ -0,0 +1,293 @@
+﻿// <copyright file="amdgpu_sensor_impl.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "amdgpu_sensor_impl.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+#if !defined(_WIN32)
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif /* !defined(_WIN32) */
+
+#include "power_overwhelming/convert_string.h"
+
+#include "io_util.h"
+#include "timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+#if !defined(_WIN32)
+    /// <summary>
+    /// Answer whether the hwmon interface in the directory
+    /// <paramref name="path" /> has been registered by amdgpu.
+    /// </summary>
+    static bool is_amdgpu_hwmon(_In_ const std::string& path) {
+        std::ifstream stream(path + "name");
+        std::string name;
+        return (std::getline(stream, name) && (name == "amdgpu"));
+    }
+
+    /// <summary>
+    /// Invokes <paramref name="callback" /> for the path of every
+    /// <c>hwmon*</c> subdirectory of <paramref name="path" />, including the
+    /// trailing path separator, until it returns <c>false</c>.
+    /// </summary>
+    template<class TCallback>
+    static void for_each_hwmon(_In_ const std::string& path,
+            _In_ TCallback callback) {
+        auto dir = ::opendir(path.c_str());
+        if (dir == nullptr) {
+            return;
+        }
+
+        while (auto entry = ::readdir(dir)) {
+            if (::strncmp(entry->d_name, "hwmon", 5) == 0) {
+                if (!callback(path + entry->d_name + "/")) {
+                    break;
+                }
+            }
+        }
+
+        ::closedir(dir);
+    }
+#endif /* !defined(_WIN32) */
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::amdgpu_sensor_impl::sampler
+ */
+visus::power_overwhelming::detail::sampler<
+    visus::power_overwhelming::detail::default_sampler_context<
+    visus::power_overwhelming::detail::amdgpu_sensor_impl>>
+    visus::power_overwhelming::detail::amdgpu_sensor_impl::sampler;
+
+
+/*
+ * visus::power_overwhelming::detail::amdgpu_sensor_impl::attribute
+ */
+_Ret_z_ const char *
+visus::power_overwhelming::detail::amdgpu_sensor_impl::attribute(
+        _In_ const amdgpu_sensor_source source) {
+    switch (source) {
+        case amdgpu_sensor_source::average_power: return "power1_average";
+        case amdgpu_sensor_source::energy: return "energy1_input";
+        case amdgpu_sensor_source::instantaneous_power: return "power1_input";
+        default: throw std::invalid_argument("The specified sensor source is "
+            "unknown.");
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::amdgpu_sensor_impl::get_bus_ids
+ */
+std::vector<std::string>
+visus::power_overwhelming::detail::amdgpu_sensor_impl::get_bus_ids(void) {
+    std::vector<std::string> retval;
+
+#if !defined(_WIN32)
+    // The hwmon devices are numbered in the order of their registration,
+    // which is not stable, so we identify the GPUs via their PCI device the
+    // "device" link of the hwmon directory points to.
+    for_each_hwmon("/sys/class/hwmon/", [&retval](const std::string& path) {
+        char device[PATH_MAX];
+        if (is_amdgpu_hwmon(path)
+                && (::realpath((path + "device").c_str(), device) != nullptr)) {
+            auto bus_id = ::strrchr(device, '/');
+            retval.emplace_back((bus_id != nullptr) ? bus_id + 1 : device);
+        }
+        return true;
+    });
+
+    std::sort(retval.begin(), retval.end());
+#endif /* !defined(_WIN32) */
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::amdgpu_sensor_impl::get_hwmon_path
+ */
+std::string
+visus::power_overwhelming::detail::amdgpu_sensor_impl::get_hwmon_path(
+        _In_ const std::string& bus_id) {
+    std::string retval;
+
+#if !defined(_WIN32)
+    const auto path = "/sys/bus/pci/devices/" + bus_id + "/hwmon/";
+    for_each_hwmon(path, [&retval](const std::string& path) {
+        if (is_amdgpu_hwmon(path)) {
+            retval = path;
+            return false;
+        } else {
+            return true;
+        }
+    });
+#endif /* !defined(_WIN32) */
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::amdgpu_sensor_impl::parse
+ */
+std::uint64_t visus::power_overwhelming::detail::amdgpu_sensor_impl::parse(
+        _In_reads_(cnt) const char *str,
+        _In_ const std::size_t cnt) {
+    // The attributes are short decimal numbers followed by a line break, so
+    // a small buffer for adding the terminator is sufficient.
+    char buffer[32];
+    const auto len = (std::min)(cnt, sizeof(buffer) - 1);
+    ::memcpy(buffer, str, len);
+    buffer[len] = 0;
+
+    auto end = static_cast<char *>(nullptr);
+    const auto retval = std::strtoull(buffer, &end, 10);
+    if (end == buffer) {
+        throw std::runtime_error("The hwmon attribute does not contain a "
+            "number.");
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::amdgpu_sensor_impl::~amdgpu_sensor_impl
+ */
+visus::power_overwhelming::detail::amdgpu_sensor_impl::~amdgpu_sensor_impl(
+        void) noexcept {
+#if !defined(_WIN32)
+    if (this->file >= 0) {
+        ::close(this->file);
+    }
+#endif /* !defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::amdgpu_sensor_impl::read
+ */
+std::uint64_t visus::power_overwhelming::detail::amdgpu_sensor_impl::read(
+        void) const {
+#if defined(_WIN32)
+    throw std::system_error(ENOTSUP, std::system_category());
+
+#else /* defined(_WIN32) */
+    assert(this->file >= 0);
+    char buffer[32];
+
+    // sysfs regenerates the content of the attribute on every read from the
+    // beginning of the file, so there is no need to reopen it.
+    const auto cnt = ::pread(this->file, buffer, sizeof(buffer), 0);
+    if (cnt < 0) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    return parse(buffer, static_cast<std::size_t>(cnt));
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::amdgpu_sensor_impl::sample
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::detail::amdgpu_sensor_impl::sample(
+        _In_ const timestamp_resolution resolution) const {
+    typedef std::chrono::duration<double> seconds_type;
+
+    if (this->source != amdgpu_sensor_source::energy) {
+        const auto timestamp = create_timestamp(resolution);
+        const auto power = static_cast<measurement_data::value_type>(
+            this->read() / 1000000.0);
+        return measurement_data(timestamp, power);
+    }
+
+    if (resolution == timestamp_resolution::nanoseconds) {
+        throw std::invalid_argument("Timestamps of amdgpu energy sensors "
+            "cannot be created in nanoseconds.");
+    }
+
+    const auto converter = get_timestamp_converter(resolution);
+    const auto energy = this->read();
+    const auto now = std::chrono::system_clock::now();
+
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    const auto de = (energy - this->last_energy) / 1000000.0;
+    const auto dt = now - this->last_time;
+    const auto sample_time = this->last_time + dt / 2;
+    const auto timestamp = converter(convert_to_file_time(sample_time));
+    const auto power = static_cast<measurement_data::value_type>(de
+        / std::chrono::duration_cast<seconds_type>(dt).count());
+
+    this->last_energy = energy;
+    this->last_time = now;
+
+    return measurement_data(timestamp, power);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::amdgpu_sensor_impl::set
+ */
+void visus::power_overwhelming::detail::amdgpu_sensor_impl::set(
+        _In_ const std::string& bus_id,
+        _In_ const amdgpu_sensor_source source) {
+#if defined(_WIN32)
+    throw std::system_error(ENOTSUP, std::system_category());
+
+#else /* defined(_WIN32) */
+    const auto hwmon = get_hwmon_path(bus_id);
+    if (hwmon.empty()) {
+        throw std::system_error(ENODEV, std::system_category());
+    }
+
+    const auto path = hwmon + attribute(source);
+    const auto file = detail::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (this->file >= 0) {
+        ::close(this->file);
+    }
+
+    this->bus_id = bus_id;
+    this->file = file;
+    this->source = source;
+    this->sensor_name = L"amdgpu/"
+        + power_overwhelming::convert_string<wchar_t>(this->bus_id) + L"/"
+        + to_string(this->source);
+
+    // Retrieve a first sample as reference for the power of the next one,
+    // which also makes sure that the attribute can actually be read.
+    try {
+        this->last_energy = this->read();
+        this->last_time = std::chrono::system_clock::now();
+    } catch (...) {
+        ::close(this->file);
+        this->file = -1;
+        throw;
+    }
+#endif /* defined(_WIN32) */
+}
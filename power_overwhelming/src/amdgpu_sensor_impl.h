@@ -0,0 +1,182 @@
+﻿// <copyright file="amdgpu_sensor_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <chrono>
+#include <cinttypes>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "power_overwhelming/amdgpu_sensor.h"
+#include "power_overwhelming/amdgpu_sensor_source.h"
+#include "power_overwhelming/measurement.h"
+
+#include "default_sampler_context.h"
+#include "sampler.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Private data container for the <see cref="amdgpu_sensor" />.
+    /// </summary>
+    struct amdgpu_sensor_impl final {
+
+        /// <summary>
+        /// The type of the point in time when an energy counter was read.
+        /// </summary>
+        typedef std::chrono::system_clock::time_point time_point;
+
+        /// <summary>
+        /// A sampler for amdgpu sensors.
+        /// </summary>
+        /// <remarks>
+        /// The default context samples all sensors with the same interval on
+        /// the same thread, so all GPUs are read in a single batch.
+        /// </remarks>
+        static detail::sampler<default_sampler_context<amdgpu_sensor_impl>>
+            sampler;
+
+        /// <summary>
+        /// Answer the name of the hwmon attribute for the given source.
+        /// </summary>
+        /// <param name="source">The source to get the file name for.</param>
+        /// <returns>The name of the attribute file.</returns>
+        /// <exception cref="std::invalid_argument">If the source is unknown.
+        /// </exception>
+        static _Ret_z_ const char *attribute(
+            _In_ const amdgpu_sensor_source source);
+
+        /// <summary>
+        /// Answer the PCI bus IDs of all devices for which amdgpu has
+        /// registered a hwmon interface.
+        /// </summary>
+        /// <returns>The bus IDs in the format of sysfs, which are empty on
+        /// Windows.</returns>
+        static std::vector<std::string> get_bus_ids(void);
+
+        /// <summary>
+        /// Answer the hwmon directory of the device with the given PCI bus
+        /// ID.
+        /// </summary>
+        /// <param name="bus_id">The PCI bus ID of the device.</param>
+        /// <returns>The path to the hwmon directory of the device including
+        /// the trailing path separator, or an empty string if the device
+        /// does not have a hwmon interface of amdgpu.</returns>
+        static std::string get_hwmon_path(_In_ const std::string& bus_id);
+
+        /// <summary>
+        /// Parses the decimal content of a hwmon attribute.
+        /// </summary>
+        /// <param name="str">The content of the attribute.</param>
+        /// <param name="cnt">The number of valid bytes in
+        /// <paramref name="str" />.</param>
+        /// <returns>The value of the attribute.</returns>
+        /// <exception cref="std::runtime_error">If the content is not a
+        /// number.</exception>
+        static std::uint64_t parse(_In_reads_(cnt) const char *str,
+            _In_ const std::size_t cnt);
+
+        /// <summary>
+        /// The PCI bus ID of the GPU.
+        /// </summary>
+        std::string bus_id;
+
+        /// <summary>
+        /// The file descriptor of the opened attribute, which is re-read for
+        /// every sample.
+        /// </summary>
+        int file;
+
+        /// <summary>
+        /// The value of the energy counter in microjoules at the last sample.
+        /// </summary>
+        mutable std::uint64_t last_energy;
+
+        /// <summary>
+        /// The point in time when the energy counter of the last sample was
+        /// read.
+        /// </summary>
+        mutable time_point last_time;
+
+        /// <summary>
+        /// Protects <see cref="last_energy" /> and <see cref="last_time" />
+        /// against concurrent samples.
+        /// </summary>
+        mutable std::mutex lock;
+
+        /// <summary>
+        /// The sensor name.
+        /// </summary>
+        std::wstring sensor_name;
+
+        /// <summary>
+        /// The attribute the sensor is reading.
+        /// </summary>
+        amdgpu_sensor_source source;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        inline amdgpu_sensor_impl(void) : file(-1), last_energy(0),
+            source(amdgpu_sensor_source::average_power) { }
+
+        amdgpu_sensor_impl(const amdgpu_sensor_impl&) = delete;
+
+        /// <summary>
+        /// Finalise the instance.
+        /// </summary>
+        ~amdgpu_sensor_impl(void) noexcept;
+
+        /// <summary>
+        /// Re-reads the raw value of the attribute from the open file.
+        /// </summary>
+        /// <returns>The value of the attribute in microwatts or microjoules,
+        /// respectively.</returns>
+        /// <exception cref="std::system_error">If reading the attribute
+        /// failed.</exception>
+        std::uint64_t read(void) const;
+
+        /// <summary>
+        /// Obtain a new sample with a timestamp in milliseconds, which is the
+        /// interface required by the <see cref="default_sampler_context" />.
+        /// </summary>
+        /// <returns>The result of the measurement.</returns>
+        inline measurement_data sample(void) const {
+            return this->sample(timestamp_resolution::milliseconds);
+        }
+
+        /// <summary>
+        /// Obtain a new sample.
+        /// </summary>
+        /// <param name="resolution">The resolution of the timestamp being
+        /// created.</param>
+        /// <returns>The result of the measurement.</returns>
+        /// <exception cref="std::system_error">If reading the attribute
+        /// failed.</exception>
+        measurement_data sample(
+            _In_ const timestamp_resolution resolution) const;
+
+        /// <summary>
+        /// Opens the attribute of the given GPU and prepares the sensor for
+        /// sampling it.
+        /// </summary>
+        /// <param name="bus_id">The PCI bus ID of the GPU.</param>
+        /// <param name="source">The attribute to be read.</param>
+        /// <exception cref="std::system_error">If the attribute could not be
+        /// opened.</exception>
+        void set(_In_ const std::string& bus_id,
+            _In_ const amdgpu_sensor_source source);
+
+        amdgpu_sensor_impl& operator =(const amdgpu_sensor_impl&) = delete;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
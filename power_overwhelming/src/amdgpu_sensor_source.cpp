@@ -0,0 +1,59 @@
+﻿// <copyright file="amdgpu_sensor_source.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/amdgpu_sensor_source.h"
+
+#include <stdexcept>
+#include <string>
+
+
+/*
+ * visus::power_overwhelming::parse_amdgpu_sensor_source
+ */
+visus::power_overwhelming::amdgpu_sensor_source
+visus::power_overwhelming::parse_amdgpu_sensor_source(
+        _In_z_ const wchar_t *str) {
+    if (str == nullptr) {
+        throw std::invalid_argument("Only a valid string can be parsed into a "
+            "amdgpu_sensor_source.");
+    }
+
+    const std::wstring s(str);
+#define _FROM_STRING_CASE(v) else if (to_string(amdgpu_sensor_source::v) == s) \
+    return amdgpu_sensor_source::v
+
+    if (false);
+    _FROM_STRING_CASE(average_power);
+    _FROM_STRING_CASE(energy);
+    _FROM_STRING_CASE(instantaneous_power);
+    else throw std::invalid_argument("The given string represents no "
+        "valid amdgpu_sensor_source");
+
+#undef _FROM_STRING_CASE
+}
+
+
+/*
+ * visus::power_overwhelming::to_string
+ */
+const wchar_t *visus::power_overwhelming::to_string(
+        _In_ const amdgpu_sensor_source source) {
+#define _GCC_IS_SHIT(v) L##v
+#define _TO_STRING_CASE(v) case amdgpu_sensor_source::v: \
+    return _GCC_IS_SHIT(#v)
+
+    switch (source) {
+        _TO_STRING_CASE(average_power);
+        _TO_STRING_CASE(energy);
+        _TO_STRING_CASE(instantaneous_power);
+
+        default:
+            throw std::invalid_argument("The specified sensor source is "
+                "unknown. Make sure to add all new sources in to_string.");
+    }
+
+#undef _GCC_IS_SHIT
+#undef _TO_STRING_CASE
+}
@@ -0,0 +1,622 @@
+﻿// <copyright file="arrow_output.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "arrow_output.h"
+
+#include <cassert>
+#include <stdexcept>
+
+#include "power_overwhelming/convert_string.h"
+
+#include "sensor_name_registry.h"
+#include "string_functions.h"
+#include "timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+namespace arrow {
+
+    /// <summary>
+    /// The IDs of the dictionaries in the schema.
+    /// </summary>
+    static constexpr std::int64_t sensor_dictionary = 0;
+    static constexpr std::int64_t marker_dictionary = 1;
+
+    /// <summary>
+    /// The <c>MessageHeader</c> union of <c>Message.fbs</c>.
+    /// </summary>
+    static constexpr std::uint8_t schema_header = 1;
+    static constexpr std::uint8_t dictionary_batch_header = 2;
+    static constexpr std::uint8_t record_batch_header = 3;
+
+    /// <summary>
+    /// <c>MetadataVersion.V5</c> of <c>Schema.fbs</c>.
+    /// </summary>
+    static constexpr std::int16_t metadata_version = 4;
+
+    /// <summary>
+    /// The <c>Type</c> union of <c>Schema.fbs</c>.
+    /// </summary>
+    static constexpr std::uint8_t int_type = 2;
+    static constexpr std::uint8_t floating_point_type = 3;
+    static constexpr std::uint8_t utf8_type = 5;
+    static constexpr std::uint8_t timestamp_type = 10;
+
+    /// <summary>
+    /// <c>Precision.SINGLE</c> of <c>Schema.fbs</c>.
+    /// </summary>
+    static constexpr std::int16_t single_precision = 1;
+
+    /// <summary>
+    /// The continuation marker preceding each encapsulated message.
+    /// </summary>
+    static constexpr std::uint32_t continuation = 0xFFFFFFFF;
+
+} /* namespace arrow */
+
+    /// <summary>
+    /// The number of seconds between the epoch of <c>FILETIME</c> and the
+    /// UNIX epoch.
+    /// </summary>
+    static constexpr std::int64_t arrow_file_time_offset = 11644473600LL;
+
+    /// <summary>
+    /// Converts a wide string to UTF-8.
+    /// </summary>
+    static std::string arrow_utf8(_In_opt_z_ const wchar_t *str) {
+        std::string retval;
+        if (str != nullptr) {
+            append_utf8(retval, str);
+        }
+        return retval;
+    }
+
+    /// <summary>
+    /// Builds a vector of <c>FieldNode</c> or <c>Buffer</c> structs, both of
+    /// which consist of two 64-bit integers.
+    /// </summary>
+    static flatbuffer_builder::offset_type arrow_pairs(
+            _In_ flatbuffer_builder& builder,
+            _In_ const std::vector<std::pair<std::int64_t, std::int64_t>>& v) {
+        builder.start_vector(2 * sizeof(std::int64_t), v.size(),
+            sizeof(std::int64_t));
+        for (auto it = v.rbegin(); it != v.rend(); ++it) {
+            builder.prepend_raw(it->second);
+            builder.prepend_raw(it->first);
+        }
+        return builder.end_vector(v.size());
+    }
+
+    /// <summary>
+    /// Builds a <c>RecordBatch</c> table from the given nodes and buffers.
+    /// </summary>
+    static flatbuffer_builder::offset_type arrow_record_batch(
+            _In_ flatbuffer_builder& builder,
+            _In_ const std::int64_t length,
+            _In_ const std::vector<std::pair<std::int64_t, std::int64_t>>& nodes,
+            _In_ const std::vector<std::pair<std::int64_t, std::int64_t>>& bufs) {
+        const auto n = arrow_pairs(builder, nodes);
+        const auto b = arrow_pairs(builder, bufs);
+        builder.start_table();
+        builder.add_scalar(0, length);
+        builder.add_offset(1, n);
+        builder.add_offset(2, b);
+        return builder.end_table();
+    }
+
+    /// <summary>
+    /// Builds a <c>Message</c> table.
+    /// </summary>
+    static flatbuffer_builder::offset_type arrow_message(
+            _In_ flatbuffer_builder& builder,
+            _In_ const std::uint8_t type,
+            _In_ const flatbuffer_builder::offset_type header,
+            _In_ const std::size_t body) {
+        builder.start_table();
+        builder.add_scalar(0, arrow::metadata_version);
+        builder.add_scalar(1, type);
+        builder.add_offset(2, header);
+        builder.add_scalar(3, static_cast<std::int64_t>(body));
+        return builder.end_table();
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::arrow_output_writer::magic
+ */
+constexpr const char *visus::power_overwhelming::detail::arrow_output_writer
+::magic;
+
+
+/*
+ * visus::power_overwhelming::detail::arrow_output_writer::arrow_output_writer
+ */
+visus::power_overwhelming::detail::arrow_output_writer::arrow_output_writer(
+        void) : _epoch(0), _offset(0),
+        _resolution(timestamp_resolution::milliseconds), _tick_scale(1) {
+    this->_marker_names.declared = false;
+    this->_marker_names.written = 0;
+    this->_sensor_names.declared = false;
+    this->_sensor_names.written = 0;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::arrow_output_writer::~arrow_output_writer
+ */
+visus::power_overwhelming::detail::arrow_output_writer::~arrow_output_writer(
+        void) {
+    this->close();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::arrow_output_writer::close
+ */
+void visus::power_overwhelming::detail::arrow_output_writer::close(void) {
+    if (this->is_open()) {
+        this->flush();
+
+        // The end-of-stream marker allows stream readers to stop before the
+        // footer.
+        const std::uint32_t eos[] = { arrow::continuation, 0 };
+        this->_file.sputn(reinterpret_cast<const char *>(eos), sizeof(eos));
+        this->_offset += sizeof(eos);
+
+        // The footer repeats the schema and locates all batches.
+        this->_builder.clear();
+        const auto schema = this->write_schema();
+
+        auto blocks = [this](const std::vector<block>& blocks) {
+            this->_builder.start_vector(3 * sizeof(std::int64_t),
+                blocks.size(), sizeof(std::int64_t));
+            for (auto it = blocks.rbegin(); it != blocks.rend(); ++it) {
+                this->_builder.prepend_raw(static_cast<std::int64_t>(
+                    it->body));
+                this->_builder.prepend_raw(std::int32_t(0));
+                this->_builder.prepend_raw(it->metadata);
+                this->_builder.prepend_raw(static_cast<std::int64_t>(
+                    it->offset));
+            }
+            return this->_builder.end_vector(blocks.size());
+        };
+
+        const auto dictionaries = blocks(this->_dictionaries);
+        const auto batches = blocks(this->_record_batches);
+        this->_builder.start_table();
+        this->_builder.add_scalar(0, arrow::metadata_version);
+        this->_builder.add_offset(1, schema);
+        this->_builder.add_offset(2, dictionaries);
+        this->_builder.add_offset(3, batches);
+        const auto footer = this->_builder.end_table();
+
+        this->_metadata.clear();
+        this->_builder.finish(this->_metadata, footer);
+        const auto size = static_cast<std::int32_t>(this->_metadata.size());
+        this->_file.sputn(reinterpret_cast<const char *>(
+            this->_metadata.data()), this->_metadata.size());
+        this->_file.sputn(reinterpret_cast<const char *>(&size),
+            sizeof(size));
+        this->_file.sputn(magic, 6);
+        this->_file.close();
+    }
+
+    this->_current.clear();
+    this->_dictionaries.clear();
+    this->_marker.clear();
+    this->_marker_names.declared = false;
+    this->_marker_names.entries.clear();
+    this->_marker_names.written = 0;
+    this->_markers.clear();
+    this->_offset = 0;
+    this->_power.clear();
+    this->_record_batches.clear();
+    this->_sensor.clear();
+    this->_sensor_names.declared = false;
+    this->_sensor_names.entries.clear();
+    this->_sensor_names.written = 0;
+    this->_sensors.clear();
+    this->_timestamp.clear();
+    this->_voltage.clear();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::arrow_output_writer::flush
+ */
+void visus::power_overwhelming::detail::arrow_output_writer::flush(void) {
+    const auto rows = this->_timestamp.size();
+    if (!this->is_open() || (rows == 0)) {
+        return;
+    }
+
+    // Readers must know all entries of the dictionaries referenced by the
+    // batch before the batch itself.
+    this->write_dictionary(arrow::sensor_dictionary, this->_sensor_names);
+    this->write_dictionary(arrow::marker_dictionary, this->_marker_names);
+
+    this->_body.clear();
+    this->_buffers.clear();
+    this->_nodes.clear();
+
+    // The sensor is never null, so its validity bitmap is omitted.
+    this->body(nullptr, 0);
+    this->body(this->_sensor.data(), rows * sizeof(std::int32_t));
+    this->_nodes.emplace_back(rows, 0);
+
+    for (auto& t : this->_timestamp) {
+        t = (t - this->_epoch) * this->_tick_scale;
+    }
+    this->body(nullptr, 0);
+    this->body(this->_timestamp.data(), rows * sizeof(std::int64_t));
+    this->_nodes.emplace_back(rows, 0);
+
+    this->_nodes.emplace_back(rows, this->write_values(this->_voltage));
+    this->_nodes.emplace_back(rows, this->write_values(this->_current));
+    this->_nodes.emplace_back(rows, this->write_values(this->_power));
+
+    {
+        std::vector<std::uint8_t> validity((rows + 7) / 8, 0);
+        std::size_t invalid = 0;
+        for (std::size_t i = 0; i < rows; ++i) {
+            if (this->_marker[i] < 0) {
+                // The index of a null entry must still be valid.
+                this->_marker[i] = 0;
+                ++invalid;
+            } else {
+                validity[i / 8] |= static_cast<std::uint8_t>(1 << (i % 8));
+            }
+        }
+
+        if (invalid > 0) {
+            this->body(validity.data(), validity.size());
+        } else {
+            this->body(nullptr, 0);
+        }
+        this->body(this->_marker.data(), rows * sizeof(std::int32_t));
+        this->_nodes.emplace_back(rows, invalid);
+    }
+
+    this->_builder.clear();
+    const auto batch = arrow_record_batch(this->_builder,
+        static_cast<std::int64_t>(rows), this->_nodes, this->_buffers);
+    const auto message = arrow_message(this->_builder,
+        arrow::record_batch_header, batch, this->_body.size());
+    this->_record_batches.push_back(this->write_message(message));
+    this->_file.pubsync();
+
+    this->_current.clear();
+    this->_marker.clear();
+    this->_power.clear();
+    this->_sensor.clear();
+    this->_timestamp.clear();
+    this->_voltage.clear();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::arrow_output_writer::header
+ */
+void visus::power_overwhelming::detail::arrow_output_writer::header(
+        _In_ const timestamp_resolution resolution,
+        _In_ const std::vector<std::wstring>& sensors) {
+    this->_resolution = resolution;
+
+    // Arrow has no unit of 100 ns, so we scale them to nanoseconds. All
+    // Arrow timestamps use the UNIX epoch.
+    const auto tps = static_cast<std::int64_t>(ticks_per_second(resolution));
+    this->_epoch = arrow_file_time_offset * tps;
+    this->_tick_scale = (resolution == timestamp_resolution::hundred_nanoseconds)
+        ? 100
+        : 1;
+
+    for (auto& s : sensors) {
+        auto name = sensor_name_registry::intern(s.c_str());
+        if (this->_sensors.find(name) == this->_sensors.end()) {
+            this->_sensors.emplace(name, static_cast<std::int32_t>(
+                this->_sensor_names.entries.size()));
+            this->_sensor_names.entries.push_back(arrow_utf8(name));
+        }
+    }
+
+    this->_builder.clear();
+    const auto schema = this->write_schema();
+    const auto message = arrow_message(this->_builder, arrow::schema_header,
+        schema, 0);
+    this->_body.clear();
+    this->write_message(message);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::arrow_output_writer::marker
+ */
+void visus::power_overwhelming::detail::arrow_output_writer::marker(
+        _In_ const std::uint32_t id, _In_z_ const wchar_t *name) {
+    assert(id != 0);
+    if (this->_markers.find(id) == this->_markers.end()) {
+        this->_markers.emplace(id, static_cast<std::int32_t>(
+            this->_marker_names.entries.size()));
+        this->_marker_names.entries.push_back(arrow_utf8(name));
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::arrow_output_writer::open
+ */
+void visus::power_overwhelming::detail::arrow_output_writer::open(
+        _In_z_ const wchar_t *path) {
+    if (path == nullptr) {
+        throw std::invalid_argument("The path to the Arrow output file must "
+            "not be null.");
+    }
+
+    this->close();
+
+    const auto mode = std::ofstream::binary | std::ofstream::out
+        | std::ofstream::trunc;
+#if defined(_WIN32)
+    this->_file.open(path, mode);
+#else /* defined(_WIN32) */
+    auto p = power_overwhelming::convert_string<char>(path);
+    this->_file.open(p, mode);
+#endif /* defined(_WIN32) */
+
+    if (!this->_file.is_open()) {
+        throw std::ios_base::failure("The Arrow output file could not be "
+            "opened.");
+    }
+
+    // The magic number is padded to eight bytes such that the messages are
+    // aligned.
+    const char preamble[8] = { 'A', 'R', 'R', 'O', 'W', '1', 0, 0 };
+    this->_file.sputn(preamble, sizeof(preamble));
+    this->_offset = sizeof(preamble);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::arrow_output_writer::push
+ */
+void visus::power_overwhelming::detail::arrow_output_writer::push(
+        _In_ const measurement& sample, _In_ const std::uint32_t marker) {
+    auto sensor = this->_sensors.find(sample.sensor());
+    if (sensor == this->_sensors.end()) {
+        sensor = this->_sensors.emplace(sample.sensor(),
+            static_cast<std::int32_t>(this->_sensor_names.entries.size()))
+            .first;
+        this->_sensor_names.entries.push_back(arrow_utf8(sample.sensor()));
+    }
+
+    auto m = (marker != 0) ? this->_markers.find(marker) : this->_markers.end();
+
+    this->_current.push_back(sample.current());
+    this->_marker.push_back((m != this->_markers.end()) ? m->second : -1);
+    this->_power.push_back(sample.power());
+    this->_sensor.push_back(sensor->second);
+    this->_timestamp.push_back(sample.timestamp());
+    this->_voltage.push_back(sample.voltage());
+}
+
+
+/*
+ * visus::power_overwhelming::detail::arrow_output_writer::body
+ */
+void visus::power_overwhelming::detail::arrow_output_writer::body(
+        _In_reads_bytes_(size) const void *data, _In_ const std::size_t size) {
+    const auto offset = this->_body.size();
+    auto d = static_cast<const std::uint8_t *>(data);
+    this->_buffers.emplace_back(offset, size);
+
+    if (size > 0) {
+        this->_body.insert(this->_body.end(), d, d + size);
+        this->_body.resize((this->_body.size() + 7) / 8 * 8, 0);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::arrow_output_writer::write_dictionary
+ */
+void visus::power_overwhelming::detail::arrow_output_writer::write_dictionary(
+        _In_ const std::int64_t id, _Inout_ dictionary& dict) {
+    if (dict.declared && (dict.written == dict.entries.size())) {
+        return;
+    }
+
+    const auto cnt = dict.entries.size() - dict.written;
+    std::vector<std::int32_t> offsets;
+    std::string values;
+    offsets.reserve(cnt + 1);
+    offsets.push_back(0);
+    for (auto i = dict.written; i < dict.entries.size(); ++i) {
+        values += dict.entries[i];
+        offsets.push_back(static_cast<std::int32_t>(values.size()));
+    }
+
+    this->_body.clear();
+    this->_buffers.clear();
+    this->_nodes.clear();
+    this->body(nullptr, 0);
+    this->body(offsets.data(), offsets.size() * sizeof(std::int32_t));
+    this->body(values.data(), values.size());
+    this->_nodes.emplace_back(cnt, 0);
+
+    // The first batch of a dictionary defines it, all later ones extend it,
+    // because the file format does not support replacing dictionaries.
+    this->_builder.clear();
+    const auto data = arrow_record_batch(this->_builder,
+        static_cast<std::int64_t>(cnt), this->_nodes, this->_buffers);
+    this->_builder.start_table();
+    this->_builder.add_scalar(0, id);
+    this->_builder.add_offset(1, data);
+    this->_builder.add_scalar(2, static_cast<std::uint8_t>(
+        dict.declared ? 1 : 0));
+    const auto batch = this->_builder.end_table();
+    const auto message = arrow_message(this->_builder,
+        arrow::dictionary_batch_header, batch, this->_body.size());
+    this->_dictionaries.push_back(this->write_message(message));
+
+    dict.declared = true;
+    dict.written = dict.entries.size();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::arrow_output_writer::write_message
+ */
+visus::power_overwhelming::detail::arrow_output_writer::block
+visus::power_overwhelming::detail::arrow_output_writer::write_message(
+        _In_ const flatbuffer_builder::offset_type root) {
+    this->_metadata.clear();
+    this->_builder.finish(this->_metadata, root);
+
+    // The body must start at a multiple of eight bytes.
+    this->_metadata.resize((this->_metadata.size() + 7) / 8 * 8, 0);
+
+    const std::uint32_t prefix[] = {
+        arrow::continuation,
+        static_cast<std::uint32_t>(this->_metadata.size())
+    };
+
+    block retval;
+    retval.offset = this->_offset;
+    retval.metadata = static_cast<std::int32_t>(sizeof(prefix)
+        + this->_metadata.size());
+    retval.body = this->_body.size();
+
+    this->_file.sputn(reinterpret_cast<const char *>(prefix), sizeof(prefix));
+    this->_file.sputn(reinterpret_cast<const char *>(this->_metadata.data()),
+        this->_metadata.size());
+    this->_file.sputn(reinterpret_cast<const char *>(this->_body.data()),
+        this->_body.size());
+    this->_offset += retval.metadata + retval.body;
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::arrow_output_writer::write_schema
+ */
+visus::power_overwhelming::detail::flatbuffer_builder::offset_type
+visus::power_overwhelming::detail::arrow_output_writer::write_schema(void) {
+    auto& b = this->_builder;
+
+    auto utf8 = [&b](void) {
+        b.start_table();
+        return b.end_table();
+    };
+
+    auto single = [&b](void) {
+        b.start_table();
+        b.add_scalar(0, arrow::single_precision);
+        return b.end_table();
+    };
+
+    auto dictionary = [&b](const std::int64_t id) {
+        b.start_table();
+        b.add_scalar(0, std::int32_t(32));
+        b.add_scalar(1, std::uint8_t(1));
+        const auto index = b.end_table();
+
+        b.start_table();
+        b.add_scalar(0, id);
+        b.add_offset(1, index);
+        b.add_scalar(2, std::uint8_t(0));
+        return b.end_table();
+    };
+
+    auto field = [&b](const char *name, const bool nullable,
+            const std::uint8_t type_id,
+            const flatbuffer_builder::offset_type type,
+            const flatbuffer_builder::offset_type dictionary) {
+        const auto n = b.create_string(name);
+        const auto children = b.create_vector({ });
+        b.start_table();
+        b.add_offset(0, n);
+        b.add_scalar(1, static_cast<std::uint8_t>(nullable ? 1 : 0));
+        b.add_scalar(2, type_id);
+        b.add_offset(3, type);
+        if (dictionary != 0) {
+            b.add_offset(4, dictionary);
+        }
+        b.add_offset(5, children);
+        return b.end_table();
+    };
+
+    std::vector<flatbuffer_builder::offset_type> fields;
+
+    {
+        const auto type = utf8();
+        const auto dict = dictionary(arrow::sensor_dictionary);
+        fields.push_back(field("sensor", false, arrow::utf8_type, type, dict));
+    }
+
+    {
+        // Arrow has no unit for 100 ns, which are scaled to nanoseconds.
+        static const std::int16_t units[] = { 0, 1, 2, 3, 3 };
+        const auto tz = b.create_string("UTC");
+        b.start_table();
+        b.add_scalar(0, units[static_cast<std::size_t>(this->_resolution)]);
+        b.add_offset(1, tz);
+        const auto type = b.end_table();
+        fields.push_back(field("timestamp", false, arrow::timestamp_type,
+            type, 0));
+    }
+
+    for (auto name : { "voltage", "current", "power" }) {
+        const auto type = single();
+        fields.push_back(field(name, true, arrow::floating_point_type, type,
+            0));
+    }
+
+    {
+        const auto type = utf8();
+        const auto dict = dictionary(arrow::marker_dictionary);
+        fields.push_back(field("marker", true, arrow::utf8_type, type, dict));
+    }
+
+    const auto f = b.create_vector(fields);
+    b.start_table();
+    b.add_scalar(0, std::int16_t(0));
+    b.add_offset(1, f);
+    return b.end_table();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::arrow_output_writer::write_values
+ */
+std::size_t visus::power_overwhelming::detail::arrow_output_writer
+::write_values(_In_ const std::vector<measurement::value_type>& values) {
+    std::vector<std::uint8_t> validity((values.size() + 7) / 8, 0);
+    std::size_t retval = 0;
+
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        if (values[i] == measurement::invalid_value) {
+            ++retval;
+        } else {
+            validity[i / 8] |= static_cast<std::uint8_t>(1 << (i % 8));
+        }
+    }
+
+    // Arrow allows for omitting the bitmap if all values are valid.
+    if (retval > 0) {
+        this->body(validity.data(), validity.size());
+    } else {
+        this->body(nullptr, 0);
+    }
+    this->body(values.data(), values.size() * sizeof(measurement::value_type));
+
+    return retval;
+}
@@ -0,0 +1,204 @@
+﻿// <copyright file="arrow_output.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "power_overwhelming/measurement.h"
+#include "power_overwhelming/timestamp_resolution.h"
+
+#include "flatbuffer_builder.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Writes the samples of a collector as an Apache Arrow IPC file.
+    /// </summary>
+    /// <remarks>
+    /// <para>The file has a single schema with one row per sample and the
+    /// columns <c>sensor</c>, <c>timestamp</c>, <c>voltage</c>,
+    /// <c>current</c>, <c>power</c> and <c>marker</c>. The sensor and the
+    /// marker are dictionary-encoded strings with 32-bit indices, the
+    /// timestamp is an Arrow timestamp in UTC, and invalid values as well as
+    /// samples without marker are null.</para>
+    /// <para>Each call to <see cref="flush" /> writes one record batch, which
+    /// is preceded by delta dictionary batches for the sensors and markers
+    /// that have not been written before. The footer written on
+    /// <see cref="close" /> makes the file readable via random access and
+    /// memory mapping, e.g. by <c>pyarrow.ipc.open_file</c> or
+    /// <c>polars.read_ipc</c>. If the file has not been closed, the messages
+    /// written so far can still be read as an IPC stream after skipping the
+    /// first eight bytes.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API arrow_output_writer final {
+
+    public:
+
+        /// <summary>
+        /// The magic number at the begin and the end of an Arrow file.
+        /// </summary>
+        static constexpr const char *magic = "ARROW1";
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        arrow_output_writer(void);
+
+        arrow_output_writer(const arrow_output_writer&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~arrow_output_writer(void);
+
+        /// <summary>
+        /// Writes all pending samples, the end-of-stream marker and the footer
+        /// and closes the file.
+        /// </summary>
+        void close(void);
+
+        /// <summary>
+        /// Writes all pending samples as a record batch.
+        /// </summary>
+        void flush(void);
+
+        /// <summary>
+        /// Writes the schema.
+        /// </summary>
+        /// <param name="resolution">The resolution of the timestamps of the
+        /// samples.</param>
+        /// <param name="sensors">The names of the sensors known in advance,
+        /// which become the first entries of the dictionary of sensors.
+        /// </param>
+        void header(_In_ const timestamp_resolution resolution,
+            _In_ const std::vector<std::wstring>& sensors);
+
+        /// <summary>
+        /// Answer whether the output file is open.
+        /// </summary>
+        /// <returns><c>true</c> if the file is open, <c>false</c> otherwise.
+        /// </returns>
+        inline bool is_open(void) const {
+            return this->_file.is_open();
+        }
+
+        /// <summary>
+        /// Declares a marker.
+        /// </summary>
+        /// <param name="id">The non-zero ID of the marker.</param>
+        /// <param name="name">The text of the marker.</param>
+        void marker(_In_ const std::uint32_t id, _In_z_ const wchar_t *name);
+
+        /// <summary>
+        /// Opens the given file for writing, replacing any existing content.
+        /// </summary>
+        /// <param name="path">The path to the output file.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="path" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::ios_base::failure">If the file could not be
+        /// opened.</exception>
+        void open(_In_z_ const wchar_t *path);
+
+        /// <summary>
+        /// Adds a sample to the pending record batch.
+        /// </summary>
+        /// <param name="sample">The sample to be added.</param>
+        /// <param name="marker">The ID of the marker active for the sample,
+        /// which is zero if no marker is active.</param>
+        void push(_In_ const measurement& sample,
+            _In_ const std::uint32_t marker);
+
+        arrow_output_writer& operator =(const arrow_output_writer&) = delete;
+
+    private:
+
+        /// <summary>
+        /// The location of a message in the file, which is recorded in the
+        /// footer.
+        /// </summary>
+        struct block {
+            std::uint64_t offset;
+            std::int32_t metadata;
+            std::uint64_t body;
+        };
+
+        /// <summary>
+        /// A dictionary of strings that grows while the file is written.
+        /// </summary>
+        struct dictionary {
+            bool declared;
+            std::vector<std::string> entries;
+            std::size_t written;
+        };
+
+        /// <summary>
+        /// Appends <paramref name="data" /> to the body of the pending
+        /// message, padded to eight bytes, and records it in the buffers of
+        /// the message.
+        /// </summary>
+        void body(_In_reads_bytes_(size) const void *data,
+            _In_ const std::size_t size);
+
+        /// <summary>
+        /// Writes the entries of <paramref name="dict" /> that have not been
+        /// written as (delta) dictionary batch.
+        /// </summary>
+        void write_dictionary(_In_ const std::int64_t id,
+            _Inout_ dictionary& dict);
+
+        /// <summary>
+        /// Writes a message with the metadata in <see cref="_builder" /> and
+        /// the pending body, and answer its location.
+        /// </summary>
+        block write_message(_In_ const flatbuffer_builder::offset_type root);
+
+        /// <summary>
+        /// Builds the schema in <see cref="_builder" />.
+        /// </summary>
+        flatbuffer_builder::offset_type write_schema(void);
+
+        /// <summary>
+        /// Appends a validity bitmap of the values in
+        /// <paramref name="values" /> to the body and answer the number of
+        /// invalid values.
+        /// </summary>
+        std::size_t write_values(
+            _In_ const std::vector<measurement::value_type>& values);
+
+        std::vector<std::uint8_t> _body;
+        std::vector<std::pair<std::int64_t, std::int64_t>> _buffers;
+        flatbuffer_builder _builder;
+        std::vector<measurement::value_type> _current;
+        std::vector<block> _dictionaries;
+        std::int64_t _epoch;
+        std::filebuf _file;
+        std::vector<std::int32_t> _marker;
+        dictionary _marker_names;
+        std::unordered_map<std::uint32_t, std::int32_t> _markers;
+        std::vector<std::uint8_t> _metadata;
+        std::vector<std::pair<std::int64_t, std::int64_t>> _nodes;
+        std::uint64_t _offset;
+        std::vector<measurement::value_type> _power;
+        std::vector<block> _record_batches;
+        timestamp_resolution _resolution;
+        std::vector<std::int32_t> _sensor;
+        dictionary _sensor_names;
+        std::unordered_map<const wchar_t *, std::int32_t> _sensors;
+        std::int64_t _tick_scale;
+        std::vector<measurement::timestamp_type> _timestamp;
+        std::vector<measurement::value_type> _voltage;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
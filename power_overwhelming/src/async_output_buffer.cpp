@@ -0,0 +1,746 @@
+﻿// <copyright file="async_output_buffer.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "async_output_buffer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif /* !defined(_WIN32) */
+
+#include "power_overwhelming/convert_string.h"
+
+
+/*
+ * visus::power_overwhelming::detail::async_output_buffer::default_buffer_count
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::async_output_buffer::default_buffer_count;
+
+
+/*
+ * visus::power_overwhelming::detail::async_output_buffer::default_buffer_size
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::async_output_buffer::default_buffer_size;
+
+
+/*
+ * visus::power_overwhelming::detail::async_output_buffer::async_output_buffer
+ */
+visus::power_overwhelming::detail::async_output_buffer::async_output_buffer(
+        void)
+    : _buffer_size(0), _current(0), _direct(false), _error(0),
+#if defined(_WIN32)
+        _file(INVALID_HANDLE_VALUE),
+#else /* defined(_WIN32) */
+        _cq_head(nullptr), _cq_mask(0), _cq_tail(nullptr), _cqes(nullptr),
+        _cq_ring(nullptr), _cq_size(0), _file(-1), _fixed(false), _ring(-1),
+        _sq_array(nullptr), _sq_entries(0), _sq_mask(0), _sq_tail(nullptr),
+        _sq_ring(nullptr), _sq_size(0), _sqes(nullptr),
+#endif /* defined(_WIN32) */
+        _memory(nullptr), _offset(0) { }
+
+
+/*
+ * visus::power_overwhelming::detail::async_output_buffer::~async_output_buffer
+ */
+visus::power_overwhelming::detail::async_output_buffer::~async_output_buffer(
+        void) {
+    this->close();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::async_output_buffer::close
+ */
+void visus::power_overwhelming::detail::async_output_buffer::close(
+        void) noexcept {
+    if (!this->is_open()) {
+        return;
+    }
+
+    const auto length = this->written();
+
+    if (this->_direct) {
+        // Direct writes must cover whole pages, so we pad the last one with
+        // zeros and remove the padding after all writes have completed.
+        const auto page = this->page_size();
+        const auto cnt = static_cast<std::size_t>(this->pptr()
+            - this->pbase());
+        const auto padding = (page - cnt % page) % page;
+        ::memset(this->pptr(), 0, padding);
+        this->pbump(static_cast<int>(padding));
+    }
+
+    // Submit the rest of the data and wait for everything in flight, because
+    // the buffers must not be freed while the system is still reading them.
+    this->submit();
+    for (std::size_t i = 0; i < this->_slots.size(); ++i) {
+        this->wait(i);
+    }
+
+#if defined(_WIN32)
+    if (this->_direct) {
+        FILE_END_OF_FILE_INFO info;
+        info.EndOfFile.QuadPart = static_cast<LONGLONG>(length);
+        if (!::SetFileInformationByHandle(this->_file, FileEndOfFileInfo,
+                &info, sizeof(info))) {
+            this->fail(static_cast<int>(::GetLastError()));
+        }
+    }
+
+    for (auto& s : this->_slots) {
+        ::CloseHandle(s.overlapped.hEvent);
+    }
+
+    ::CloseHandle(this->_file);
+    this->_file = INVALID_HANDLE_VALUE;
+
+    ::VirtualFree(this->_memory, 0, MEM_RELEASE);
+#else /* defined(_WIN32) */
+    this->release();
+
+    if (this->_direct && (::ftruncate(this->_file,
+            static_cast<off_t>(length)) != 0)) {
+        this->fail(errno);
+    }
+
+    ::close(this->_file);
+    this->_file = -1;
+
+    ::munmap(this->_memory, this->_slots.size() * this->_buffer_size);
+#endif /* defined(_WIN32) */
+
+    this->setp(nullptr, nullptr);
+    this->_direct = false;
+    this->_memory = nullptr;
+    this->_offset = 0;
+    this->_slots.clear();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::async_output_buffer::is_open
+ */
+bool visus::power_overwhelming::detail::async_output_buffer::is_open(
+        void) const noexcept {
+#if defined(_WIN32)
+    return (this->_file != INVALID_HANDLE_VALUE);
+#else /* defined(_WIN32) */
+    return (this->_file >= 0);
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::async_output_buffer::open
+ */
+void visus::power_overwhelming::detail::async_output_buffer::open(
+        _In_z_ const wchar_t *path,
+        _In_ const std::size_t buffer_count,
+        _In_ const std::size_t buffer_size,
+        _In_ const bool direct) {
+    if (path == nullptr) {
+        throw std::invalid_argument("The path to the asynchronous output file "
+            "must not be null.");
+    }
+
+    this->close();
+
+    // The page size is a multiple of the sector size of all devices we know
+    // of, so aligning everything to pages satisfies the requirements of
+    // direct I/O.
+    const auto page_size = this->page_size();
+
+#if defined(_WIN32)
+    const DWORD flags = FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED;
+    this->_direct = direct;
+    this->_file = ::CreateFileW(path, GENERIC_WRITE, FILE_SHARE_READ,
+        nullptr, CREATE_ALWAYS, flags | (direct ? FILE_FLAG_NO_BUFFERING : 0),
+        NULL);
+    if ((this->_file == INVALID_HANDLE_VALUE) && direct
+            && (::GetLastError() == ERROR_INVALID_PARAMETER)) {
+        this->_direct = false;
+        this->_file = ::CreateFileW(path, GENERIC_WRITE, FILE_SHARE_READ,
+            nullptr, CREATE_ALWAYS, flags, NULL);
+    }
+    if (this->_file == INVALID_HANDLE_VALUE) {
+        throw std::system_error(::GetLastError(), std::system_category());
+    }
+#else /* defined(_WIN32) */
+    const int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    auto p = power_overwhelming::convert_string<char>(path);
+    this->_direct = direct;
+    this->_file = ::open(p.c_str(), flags | (direct ? O_DIRECT : 0), 0666);
+    if ((this->_file < 0) && direct && (errno == EINVAL)) {
+        // File systems like tmpfs do not support direct I/O at all.
+        this->_direct = false;
+        this->_file = ::open(p.c_str(), flags, 0666);
+    }
+    if (this->_file < 0) {
+        throw std::system_error(errno, std::system_category());
+    }
+#endif /* defined(_WIN32) */
+
+    this->_buffer_size = (std::max)(buffer_size, page_size);
+    this->_buffer_size = (this->_buffer_size + page_size - 1)
+        / page_size * page_size;
+    this->_current = 0;
+    this->_error = 0;
+    this->_offset = 0;
+
+    // At least two buffers are required to fill one while the other one is
+    // being written.
+    this->_slots.resize((std::max)(buffer_count, std::size_t(2)));
+    for (auto& s : this->_slots) {
+        ::memset(&s, 0, sizeof(s));
+    }
+
+#if defined(_WIN32)
+    for (auto& s : this->_slots) {
+        // Each write needs its own event, because waiting on the file
+        // cannot tell which of the writes in flight has completed.
+        s.overlapped.hEvent = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        if (s.overlapped.hEvent == NULL) {
+            const auto error = ::GetLastError();
+            for (auto& t : this->_slots) {
+                if (t.overlapped.hEvent != NULL) {
+                    ::CloseHandle(t.overlapped.hEvent);
+                }
+            }
+            this->_slots.clear();
+            ::CloseHandle(this->_file);
+            this->_file = INVALID_HANDLE_VALUE;
+            throw std::system_error(error, std::system_category());
+        }
+    }
+#endif /* defined(_WIN32) */
+
+    // The buffers are allocated from the virtual memory manager, because
+    // direct I/O requires them to be aligned to pages.
+    const auto size = this->_slots.size() * this->_buffer_size;
+#if defined(_WIN32)
+    this->_memory = static_cast<char_type *>(::VirtualAlloc(nullptr, size,
+        MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+    if (this->_memory == nullptr) {
+        const auto error = ::GetLastError();
+        for (auto& s : this->_slots) {
+            ::CloseHandle(s.overlapped.hEvent);
+        }
+        this->_slots.clear();
+        ::CloseHandle(this->_file);
+        this->_file = INVALID_HANDLE_VALUE;
+        throw std::system_error(error, std::system_category());
+    }
+#else /* defined(_WIN32) */
+    auto memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        const auto error = errno;
+        this->_slots.clear();
+        ::close(this->_file);
+        this->_file = -1;
+        throw std::system_error(error, std::system_category());
+    }
+    this->_memory = static_cast<char_type *>(memory);
+#endif /* defined(_WIN32) */
+
+    this->setup();
+    this->setp(this->data(0), this->data(0) + this->_buffer_size);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::async_output_buffer::written
+ */
+std::uint64_t visus::power_overwhelming::detail::async_output_buffer::written(
+        void) const noexcept {
+    return this->_offset + (this->pptr() - this->pbase());
+}
+
+
+/*
+ * visus::power_overwhelming::detail::async_output_buffer::overflow
+ */
+visus::power_overwhelming::detail::async_output_buffer::int_type
+visus::power_overwhelming::detail::async_output_buffer::overflow(
+        _In_ int_type c) {
+    if (!this->is_open() || (this->_error != 0)) {
+        return traits_type::eof();
+    }
+
+    if (this->pptr() == this->epptr()) {
+        this->submit();
+
+        if (this->_error != 0) {
+            return traits_type::eof();
+        }
+    }
+
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *this->pptr() = traits_type::to_char_type(c);
+        this->pbump(1);
+        return c;
+    }
+
+    return traits_type::not_eof(c);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::async_output_buffer::seekoff
+ */
+visus::power_overwhelming::detail::async_output_buffer::pos_type
+visus::power_overwhelming::detail::async_output_buffer::seekoff(
+        _In_ off_type off, _In_ std::ios_base::seekdir dir,
+        _In_ std::ios_base::openmode which) {
+    if (this->is_open() && (off == 0) && (dir == std::ios_base::cur)
+            && ((which & std::ios_base::out) != 0)) {
+        return pos_type(static_cast<off_type>(this->written()));
+    }
+
+    return pos_type(off_type(-1));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::async_output_buffer::sync
+ */
+int visus::power_overwhelming::detail::async_output_buffer::sync(void) {
+    if (!this->is_open()) {
+        return 0;
+    }
+
+    this->submit();
+    return (this->_error == 0) ? 0 : -1;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::async_output_buffer::xsputn
+ */
+std::streamsize
+visus::power_overwhelming::detail::async_output_buffer::xsputn(
+        _In_reads_(cnt) const char_type *data,
+        _In_ std::streamsize cnt) {
+    std::streamsize retval = 0;
+
+    while (this->is_open() && (this->_error == 0) && (retval < cnt)) {
+        if (this->pptr() == this->epptr()) {
+            this->submit();
+            continue;
+        }
+
+        const auto n = (std::min)(cnt - retval,
+            static_cast<std::streamsize>(this->epptr() - this->pptr()));
+        ::memcpy(this->pptr(), data + retval, static_cast<std::size_t>(n));
+        this->pbump(static_cast<int>(n));
+        retval += n;
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::async_output_buffer::complete
+ */
+void visus::power_overwhelming::detail::async_output_buffer::complete(
+        _In_ const std::size_t slot,
+        _In_ const std::int64_t result) noexcept {
+    assert(slot < this->_slots.size());
+    auto& s = this->_slots[slot];
+    s.pending = false;
+
+#if !defined(_WIN32)
+    if ((result == -EINTR) || (result == -EAGAIN)) {
+        this->start(slot);
+        return;
+    }
+#endif /* !defined(_WIN32) */
+
+    if (result < 0) {
+        this->fail(static_cast<int>(-result));
+
+    } else if (result == 0) {
+        // A write that makes no progress would be resubmitted forever.
+#if defined(_WIN32)
+        this->fail(ERROR_WRITE_FAULT);
+#else /* defined(_WIN32) */
+        this->fail(EIO);
+#endif /* defined(_WIN32) */
+
+    } else {
+        s.done += static_cast<std::size_t>(result);
+        if (s.done < s.size) {
+            this->start(slot);
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::async_output_buffer::enter
+ */
+bool visus::power_overwhelming::detail::async_output_buffer::enter(
+        _In_ unsigned int submit, _In_ const unsigned int wait) noexcept {
+#if defined(_WIN32)
+    return false;
+
+#else /* defined(_WIN32) */
+    assert(this->_ring >= 0);
+    const auto flags = (wait > 0) ? IORING_ENTER_GETEVENTS : 0u;
+
+    while (true) {
+        const auto status = ::syscall(__NR_io_uring_enter, this->_ring,
+            submit, wait, flags, nullptr, 0);
+        if (status >= 0) {
+            submit -= (std::min)(submit, static_cast<unsigned int>(status));
+            if (submit == 0) {
+                return true;
+            }
+
+        } else if ((errno != EINTR) && (errno != EAGAIN)
+                && (errno != EBUSY)) {
+            // The ring is broken, so nothing in flight will ever complete.
+            this->fail(errno);
+            for (auto& s : this->_slots) {
+                s.pending = false;
+            }
+            return false;
+        }
+    }
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::async_output_buffer::fail
+ */
+void visus::power_overwhelming::detail::async_output_buffer::fail(
+        _In_ const int error) noexcept {
+    if (this->_error == 0) {
+        this->_error = error;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::async_output_buffer::page_size
+ */
+std::size_t visus::power_overwhelming::detail::async_output_buffer::page_size(
+        void) noexcept {
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    ::GetSystemInfo(&info);
+    return info.dwPageSize;
+#else /* defined(_WIN32) */
+    return static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::async_output_buffer::reap
+ */
+void visus::power_overwhelming::detail::async_output_buffer::reap(
+        void) noexcept {
+#if !defined(_WIN32)
+    auto cqes = static_cast<::io_uring_cqe *>(this->_cqes);
+    auto head = *this->_cq_head;
+    const auto tail = __atomic_load_n(this->_cq_tail, __ATOMIC_ACQUIRE);
+
+    for (; head != tail; ++head) {
+        auto& cqe = cqes[head & this->_cq_mask];
+        assert(cqe.user_data < this->_slots.size());
+        auto& s = this->_slots[cqe.user_data];
+        s.reaped = true;
+        s.result = cqe.res;
+    }
+
+    __atomic_store_n(this->_cq_head, head, __ATOMIC_RELEASE);
+
+    // Completing a short write resubmits the rest, so this must happen only
+    // after the completion queue has been released.
+    for (std::size_t i = 0; i < this->_slots.size(); ++i) {
+        auto& s = this->_slots[i];
+        if (s.reaped) {
+            s.reaped = false;
+            this->complete(i, s.result);
+        }
+    }
+#endif /* !defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::async_output_buffer::release
+ */
+void visus::power_overwhelming::detail::async_output_buffer::release(
+        void) noexcept {
+#if !defined(_WIN32)
+    if (this->_sqes != nullptr) {
+        ::munmap(this->_sqes, this->_sq_entries * sizeof(::io_uring_sqe));
+        this->_sqes = nullptr;
+    }
+
+    if ((this->_cq_ring != nullptr) && (this->_cq_ring != this->_sq_ring)) {
+        ::munmap(this->_cq_ring, this->_cq_size);
+    }
+    this->_cq_ring = nullptr;
+
+    if (this->_sq_ring != nullptr) {
+        ::munmap(this->_sq_ring, this->_sq_size);
+        this->_sq_ring = nullptr;
+    }
+
+    // Closing the ring also unregisters the buffers.
+    if (this->_ring >= 0) {
+        ::close(this->_ring);
+        this->_ring = -1;
+    }
+
+    this->_fixed = false;
+#endif /* !defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::async_output_buffer::setup
+ */
+void visus::power_overwhelming::detail::async_output_buffer::setup(
+        void) noexcept {
+#if !defined(_WIN32)
+    assert(this->_ring < 0);
+    ::io_uring_params params;
+    ::memset(&params, 0, sizeof(params));
+
+    // There are never more writes in flight than buffers, so the queues
+    // cannot overflow.
+    this->_ring = static_cast<int>(::syscall(__NR_io_uring_setup,
+        static_cast<unsigned int>(this->_slots.size()), &params));
+    if (this->_ring < 0) {
+        this->_ring = -1;
+        return;
+    }
+
+    this->_sq_entries = params.sq_entries;
+    this->_sq_size = params.sq_off.array
+        + params.sq_entries * sizeof(unsigned int);
+    this->_cq_size = params.cq_off.cqes
+        + params.cq_entries * sizeof(::io_uring_cqe);
+
+    const auto single = ((params.features & IORING_FEAT_SINGLE_MMAP) != 0);
+    if (single) {
+        this->_sq_size = this->_cq_size = (std::max)(this->_sq_size,
+            this->_cq_size);
+    }
+
+    this->_sq_ring = ::mmap(nullptr, this->_sq_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, this->_ring, IORING_OFF_SQ_RING);
+    if (this->_sq_ring == MAP_FAILED) {
+        this->_sq_ring = nullptr;
+        this->release();
+        return;
+    }
+
+    if (single) {
+        this->_cq_ring = this->_sq_ring;
+    } else {
+        this->_cq_ring = ::mmap(nullptr, this->_cq_size,
+            PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->_ring,
+            IORING_OFF_CQ_RING);
+        if (this->_cq_ring == MAP_FAILED) {
+            this->_cq_ring = nullptr;
+            this->release();
+            return;
+        }
+    }
+
+    this->_sqes = ::mmap(nullptr, params.sq_entries * sizeof(::io_uring_sqe),
+        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->_ring,
+        IORING_OFF_SQES);
+    if (this->_sqes == MAP_FAILED) {
+        this->_sqes = nullptr;
+        this->release();
+        return;
+    }
+
+    auto sq = static_cast<char *>(this->_sq_ring);
+    auto cq = static_cast<char *>(this->_cq_ring);
+    this->_sq_array = reinterpret_cast<unsigned int *>(sq
+        + params.sq_off.array);
+    this->_sq_mask = *reinterpret_cast<unsigned int *>(sq
+        + params.sq_off.ring_mask);
+    this->_sq_tail = reinterpret_cast<unsigned int *>(sq
+        + params.sq_off.tail);
+    this->_cq_head = reinterpret_cast<unsigned int *>(cq
+        + params.cq_off.head);
+    this->_cq_mask = *reinterpret_cast<unsigned int *>(cq
+        + params.cq_off.ring_mask);
+    this->_cq_tail = reinterpret_cast<unsigned int *>(cq
+        + params.cq_off.tail);
+    this->_cqes = cq + params.cq_off.cqes;
+
+    // Registering the buffers saves the kernel from mapping them for each
+    // write, but it counts against the limit of locked memory, so we use
+    // plain writes if the registration is refused.
+    std::vector<::iovec> buffers(this->_slots.size());
+    for (std::size_t i = 0; i < buffers.size(); ++i) {
+        buffers[i].iov_base = this->data(i);
+        buffers[i].iov_len = this->_buffer_size;
+    }
+
+    this->_fixed = (::syscall(__NR_io_uring_register, this->_ring,
+        IORING_REGISTER_BUFFERS, buffers.data(),
+        static_cast<unsigned int>(buffers.size())) == 0);
+#endif /* !defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::async_output_buffer::start
+ */
+void visus::power_overwhelming::detail::async_output_buffer::start(
+        _In_ const std::size_t slot) noexcept {
+    assert(slot < this->_slots.size());
+    auto& s = this->_slots[slot];
+    assert(!s.pending);
+    assert(s.done < s.size);
+    const auto cnt = s.size - s.done;
+    const auto data = this->data(slot) + s.done;
+    const auto offset = s.offset + s.done;
+    s.pending = true;
+
+#if defined(_WIN32)
+    s.overlapped.Internal = 0;
+    s.overlapped.InternalHigh = 0;
+    s.overlapped.Offset = static_cast<DWORD>(offset);
+    s.overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+    if (!::WriteFile(this->_file, data, static_cast<DWORD>(cnt), nullptr,
+            &s.overlapped)) {
+        const auto error = ::GetLastError();
+        if (error != ERROR_IO_PENDING) {
+            s.pending = false;
+            this->fail(static_cast<int>(error));
+        }
+    }
+
+#else /* defined(_WIN32) */
+    if (this->_ring < 0) {
+        const auto written = ::pwrite(this->_file, data, cnt,
+            static_cast<off_t>(offset));
+        this->complete(slot, (written < 0)
+            ? -static_cast<std::int64_t>(errno)
+            : static_cast<std::int64_t>(written));
+        return;
+    }
+
+    // We are the only producer, so the tail can be read without any
+    // synchronisation, but the kernel must see the entry before the new tail.
+    const auto tail = *this->_sq_tail;
+    const auto index = tail & this->_sq_mask;
+    auto& sqe = static_cast<::io_uring_sqe *>(this->_sqes)[index];
+    ::memset(&sqe, 0, sizeof(sqe));
+    if (this->_fixed) {
+        sqe.opcode = IORING_OP_WRITE_FIXED;
+        sqe.buf_index = static_cast<std::uint16_t>(slot);
+    } else {
+        sqe.opcode = IORING_OP_WRITE;
+    }
+    sqe.fd = this->_file;
+    sqe.addr = reinterpret_cast<std::uint64_t>(data);
+    sqe.len = static_cast<std::uint32_t>(cnt);
+    sqe.off = offset;
+    sqe.user_data = slot;
+    this->_sq_array[index] = index;
+    __atomic_store_n(this->_sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    this->enter(1, 0);
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::async_output_buffer::submit
+ */
+void visus::power_overwhelming::detail::async_output_buffer::submit(
+        void) noexcept {
+    const auto cnt = static_cast<std::size_t>(this->pptr() - this->pbase());
+    auto size = cnt;
+
+    if (this->_direct) {
+        const auto page = this->page_size();
+        size = size / page * page;
+    }
+
+    if ((size == 0) || (this->_error != 0)) {
+        return;
+    }
+
+    auto& s = this->_slots[this->_current];
+    s.done = 0;
+    s.offset = this->_offset;
+    s.size = size;
+    this->_offset += size;
+    this->start(this->_current);
+    const auto rest = this->data(this->_current) + size;
+
+    // The buffers are used round-robin, so the next one is the one that has
+    // been in flight for the longest time.
+    this->_current = (this->_current + 1) % this->_slots.size();
+    this->wait(this->_current);
+
+    auto data = this->data(this->_current);
+    this->setp(data, data + this->_buffer_size);
+
+    // Carry over the incomplete page, which is only read by the write in
+    // flight, to the begin of the new put area.
+    if (cnt > size) {
+        ::memcpy(data, rest, cnt - size);
+        this->pbump(static_cast<int>(cnt - size));
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::async_output_buffer::wait
+ */
+void visus::power_overwhelming::detail::async_output_buffer::wait(
+        _In_ const std::size_t slot) noexcept {
+    assert(slot < this->_slots.size());
+    auto& s = this->_slots[slot];
+
+#if defined(_WIN32)
+    while (s.pending) {
+        DWORD written = 0;
+        if (::GetOverlappedResult(this->_file, &s.overlapped, &written,
+                TRUE)) {
+            this->complete(slot, written);
+        } else {
+            s.pending = false;
+            this->fail(static_cast<int>(::GetLastError()));
+        }
+    }
+
+#else /* defined(_WIN32) */
+    while (s.pending && this->enter(0, 1)) {
+        this->reap();
+    }
+#endif /* defined(_WIN32) */
+}
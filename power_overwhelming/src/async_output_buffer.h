@@ -0,0 +1,295 @@
+﻿// <copyright file="async_output_buffer.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <streambuf>
+#include <vector>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#endif /* defined(_WIN32) */
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A stream buffer that writes a file asynchronously from a fixed set of
+    /// buffers.
+    /// </summary>
+    /// <remarks>
+    /// <para>The buffer allocates <see cref="buffer_count" /> buffers once the
+    /// file is opened and uses one of them as its put area. Once the put area
+    /// is full or the buffer is synchronised, the data are submitted as a
+    /// positional write and the next buffer becomes the put area. The writer
+    /// only blocks if all buffers are still in flight, such that it can
+    /// encode the next batch while the previous ones are being written.</para>
+    /// <para>On Linux, the writes are submitted to an io_uring, with which
+    /// the buffers are registered if the limit of locked memory permits.
+    /// On kernels without io_uring, the buffer falls back to synchronous
+    /// <c>pwrite</c>. On Windows, the file is opened for overlapped I/O and
+    /// each buffer has its own <c>OVERLAPPED</c> structure.</para>
+    /// <para>Synchronising the buffer does not wait for the writes to
+    /// complete. Only <see cref="close" /> waits for all writes in flight.
+    /// If a write fails, all subsequent output fails, too.</para>
+    /// <para>In <see cref="direct" /> mode, the file bypasses the page cache
+    /// such that the output does not evict the data of the application being
+    /// measured. All writes must then be aligned to the page size, wherefore
+    /// synchronising only submits the complete pages and carries the rest
+    /// over to the next buffer. The last page is padded with zeros and the
+    /// padding is truncated once the file is closed.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API async_output_buffer final
+            : public std::streambuf {
+
+    public:
+
+        /// <summary>
+        /// The default number of buffers.
+        /// </summary>
+        static constexpr std::size_t default_buffer_count = 4;
+
+        /// <summary>
+        /// The default size of a single buffer in bytes.
+        /// </summary>
+        static constexpr std::size_t default_buffer_size = 1 << 20;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        async_output_buffer(void);
+
+        async_output_buffer(const async_output_buffer&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~async_output_buffer(void);
+
+        /// <summary>
+        /// Answer the number of buffers.
+        /// </summary>
+        /// <returns>The number of buffers, which is zero if the file is not
+        /// open.</returns>
+        inline std::size_t buffer_count(void) const noexcept {
+            return this->_slots.size();
+        }
+
+        /// <summary>
+        /// Writes the pending data, waits for all writes in flight and closes
+        /// the file.
+        /// </summary>
+        void close(void) noexcept;
+
+        /// <summary>
+        /// Answer whether the file is written without the page cache.
+        /// </summary>
+        /// <returns><c>true</c> if the file has been opened for direct I/O,
+        /// <c>false</c> otherwise, which includes the case that direct I/O
+        /// was requested, but is not supported by the file system.</returns>
+        inline bool direct(void) const noexcept {
+            return this->_direct;
+        }
+
+        /// <summary>
+        /// Answer the error that made a write fail.
+        /// </summary>
+        /// <returns>The <c>errno</c> or the Windows error code of the first
+        /// write that failed, or zero if no write failed.</returns>
+        inline int error(void) const noexcept {
+            return this->_error;
+        }
+
+        /// <summary>
+        /// Answer whether a file has been opened.
+        /// </summary>
+        /// <returns><c>true</c> if the file is open, <c>false</c> otherwise.
+        /// </returns>
+        bool is_open(void) const noexcept;
+
+        /// <summary>
+        /// Creates the given file, replacing any existing content, and
+        /// allocates the buffers.
+        /// </summary>
+        /// <param name="path">The path to the output file.</param>
+        /// <param name="buffer_count">The number of buffers, which determines
+        /// how many writes can be in flight. At least two buffers are
+        /// allocated.</param>
+        /// <param name="buffer_size">The size of a single buffer in bytes,
+        /// which will be rounded up to the page size.</param>
+        /// <param name="direct">If <c>true</c>, the file is opened with
+        /// <c>O_DIRECT</c> or <c>FILE_FLAG_NO_BUFFERING</c>, respectively. If
+        /// the file system does not support this, the file is opened for
+        /// buffered I/O, which can be checked via <see cref="direct" />.
+        /// </param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="path" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::system_error">If the file could not be
+        /// created or the buffers could not be allocated.</exception>
+        void open(_In_z_ const wchar_t *path,
+            _In_ const std::size_t buffer_count = default_buffer_count,
+            _In_ const std::size_t buffer_size = default_buffer_size,
+            _In_ const bool direct = false);
+
+        /// <summary>
+        /// Answer the number of bytes written to the buffer so far.
+        /// </summary>
+        /// <returns>The logical size of the file in bytes, which includes the
+        /// writes that are still in flight.</returns>
+        std::uint64_t written(void) const noexcept;
+
+        async_output_buffer& operator =(const async_output_buffer&) = delete;
+
+    protected:
+
+        /// <inheritdoc />
+        int_type overflow(_In_ int_type c) override;
+
+        /// <summary>
+        /// Answer the current position in the file.
+        /// </summary>
+        /// <remarks>
+        /// The buffer only supports querying the position of the put area,
+        /// which is required for <c>tellp</c>, but not moving it.
+        /// </remarks>
+        pos_type seekoff(_In_ off_type off, _In_ std::ios_base::seekdir dir,
+            _In_ std::ios_base::openmode which) override;
+
+        /// <summary>
+        /// Submits the data in the put area without waiting for the write to
+        /// complete.
+        /// </summary>
+        int sync(void) override;
+
+        /// <inheritdoc />
+        std::streamsize xsputn(_In_reads_(cnt) const char_type *data,
+            _In_ std::streamsize cnt) override;
+
+    private:
+
+        /// <summary>
+        /// The state of the write of a single buffer.
+        /// </summary>
+        struct slot_type {
+            std::size_t done;
+            std::uint64_t offset;
+            bool pending;
+#if defined(_WIN32)
+            OVERLAPPED overlapped;
+#else /* defined(_WIN32) */
+            bool reaped;
+            std::int32_t result;
+#endif /* defined(_WIN32) */
+            std::size_t size;
+        };
+
+        /// <summary>
+        /// Processes the result of a write of the buffer at
+        /// <paramref name="slot" />, which is either the number of bytes
+        /// written or the negated error code, and resubmits the remainder of
+        /// a short write.
+        /// </summary>
+        void complete(_In_ const std::size_t slot,
+            _In_ const std::int64_t result) noexcept;
+
+        /// <summary>
+        /// Answer the begin of the buffer at <paramref name="slot" />.
+        /// </summary>
+        inline char_type *data(_In_ const std::size_t slot) noexcept {
+            return this->_memory + slot * this->_buffer_size;
+        }
+
+        /// <summary>
+        /// Submits <paramref name="submit" /> entries of the io_uring and/or
+        /// waits for <paramref name="wait" /> completions.
+        /// </summary>
+        bool enter(_In_ unsigned int submit,
+            _In_ const unsigned int wait) noexcept;
+
+        /// <summary>
+        /// Fails all output with the given error.
+        /// </summary>
+        void fail(_In_ const int error) noexcept;
+
+        /// <summary>
+        /// Answer the page size of the system.
+        /// </summary>
+        static std::size_t page_size(void) noexcept;
+
+        /// <summary>
+        /// Fetches all available completions of the io_uring.
+        /// </summary>
+        void reap(void) noexcept;
+
+        /// <summary>
+        /// Unmaps the rings and closes the io_uring.
+        /// </summary>
+        void release(void) noexcept;
+
+        /// <summary>
+        /// Creates the io_uring and registers the buffers with it. If this is
+        /// not possible, the buffer falls back to synchronous writes.
+        /// </summary>
+        void setup(void) noexcept;
+
+        /// <summary>
+        /// Starts writing the remainder of the buffer at
+        /// <paramref name="slot" />.
+        /// </summary>
+        void start(_In_ const std::size_t slot) noexcept;
+
+        /// <summary>
+        /// Submits the put area and makes the next buffer the put area once
+        /// its previous write has completed.
+        /// </summary>
+        /// <remarks>
+        /// In <see cref="direct" /> mode, only the complete pages are
+        /// submitted and the rest is moved to the new put area.
+        /// </remarks>
+        void submit(void) noexcept;
+
+        /// <summary>
+        /// Blocks until the write of the buffer at <paramref name="slot" />
+        /// has completed.
+        /// </summary>
+        void wait(_In_ const std::size_t slot) noexcept;
+
+        std::size_t _buffer_size;
+        std::size_t _current;
+        bool _direct;
+        int _error;
+#if defined(_WIN32)
+        HANDLE _file;
+#else /* defined(_WIN32) */
+        unsigned int *_cq_head;
+        unsigned int _cq_mask;
+        unsigned int *_cq_tail;
+        void *_cqes;
+        void *_cq_ring;
+        std::size_t _cq_size;
+        int _file;
+        bool _fixed;
+        int _ring;
+        unsigned int *_sq_array;
+        unsigned int _sq_entries;
+        unsigned int _sq_mask;
+        unsigned int *_sq_tail;
+        void *_sq_ring;
+        std::size_t _sq_size;
+        void *_sqes;
+#endif /* defined(_WIN32) */
+        char_type *_memory;
+        std::uint64_t _offset;
+        std::vector<slot_type> _slots;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,73 @@
+﻿// <copyright file="atomic_latency_histogram.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "atomic_latency_histogram.h"
+
+#include <limits>
+
+
+/*
+ * ...::detail::atomic_latency_histogram::atomic_latency_histogram
+ */
+visus::power_overwhelming::detail::atomic_latency_histogram
+::atomic_latency_histogram(void) noexcept {
+    this->reset();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::atomic_latency_histogram::record
+ */
+void visus::power_overwhelming::detail::atomic_latency_histogram::record(
+        _In_ const value_type value) noexcept {
+    const auto index = latency_histogram::index_of(value);
+    this->_buckets[index].fetch_add(1, std::memory_order_relaxed);
+    this->_sum.fetch_add(value, std::memory_order_relaxed);
+
+    // Only try to update the extrema if the new value actually is one, which
+    // is rarely the case once the histogram has seen a few values.
+    auto max = this->_max.load(std::memory_order_relaxed);
+    while ((value > max) && !this->_max.compare_exchange_weak(max, value,
+        std::memory_order_relaxed));
+
+    auto min = this->_min.load(std::memory_order_relaxed);
+    while ((value < min) && !this->_min.compare_exchange_weak(min, value,
+        std::memory_order_relaxed));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::atomic_latency_histogram::reset
+ */
+void visus::power_overwhelming::detail::atomic_latency_histogram::reset(
+        void) noexcept {
+    for (auto& b : this->_buckets) {
+        b.store(0, std::memory_order_relaxed);
+    }
+
+    this->_max.store(0, std::memory_order_relaxed);
+    this->_min.store((std::numeric_limits<value_type>::max)(),
+        std::memory_order_relaxed);
+    this->_sum.store(0, std::memory_order_relaxed);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::atomic_latency_histogram::snapshot
+ */
+void visus::power_overwhelming::detail::atomic_latency_histogram::snapshot(
+        _Out_ latency_histogram& dst) const noexcept {
+    // Derive the count from the buckets such that percentiles computed from
+    // the snapshot are consistent even if a value is being recorded.
+    dst._count = 0;
+    for (std::size_t i = 0; i < latency_histogram::buckets; ++i) {
+        dst._buckets[i] = this->_buckets[i].load(std::memory_order_relaxed);
+        dst._count += dst._buckets[i];
+    }
+
+    dst._max = this->_max.load(std::memory_order_relaxed);
+    dst._min = this->_min.load(std::memory_order_relaxed);
+    dst._sum = this->_sum.load(std::memory_order_relaxed);
+}
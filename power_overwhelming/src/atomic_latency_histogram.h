@@ -0,0 +1,93 @@
+﻿// <copyright file="atomic_latency_histogram.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+
+#include "power_overwhelming/latency_histogram.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A <see cref="latency_histogram" /> that can be recorded into while
+    /// other threads take snapshots of it.
+    /// </summary>
+    /// <remarks>
+    /// All counters are updated with relaxed atomic operations, so recording
+    /// never blocks and never takes a lock. A snapshot taken while a duration
+    /// is being recorded might therefore already contain the bucket, but not
+    /// yet the sum or the extrema of the duration, which is irrelevant for
+    /// statistics over thousands of samples.
+    /// </remarks>
+    class POWER_OVERWHELMING_API atomic_latency_histogram final {
+
+    public:
+
+        /// <summary>
+        /// The type of the recorded durations, which are in nanoseconds.
+        /// </summary>
+        typedef latency_histogram::value_type value_type;
+
+        /// <summary>
+        /// Initialises a new, empty instance.
+        /// </summary>
+        atomic_latency_histogram(void) noexcept;
+
+        atomic_latency_histogram(const atomic_latency_histogram&) = delete;
+
+        /// <summary>
+        /// Counts the given duration.
+        /// </summary>
+        /// <param name="value">The duration in nanoseconds.</param>
+        void record(_In_ const value_type value) noexcept;
+
+        /// <summary>
+        /// Counts the given duration, which is clamped to zero if it is
+        /// negative.
+        /// </summary>
+        /// <typeparam name="TRep">The type of the ticks of the duration.
+        /// </typeparam>
+        /// <typeparam name="TPeriod">The period of the ticks of the duration.
+        /// </typeparam>
+        /// <param name="value">The duration.</param>
+        template<class TRep, class TPeriod>
+        inline void record(
+                _In_ const std::chrono::duration<TRep, TPeriod> value) noexcept {
+            const auto ns = std::chrono::duration_cast<
+                std::chrono::nanoseconds>(value).count();
+            this->record(static_cast<value_type>((ns > 0) ? ns : 0));
+        }
+
+        /// <summary>
+        /// Removes all recorded durations.
+        /// </summary>
+        void reset(void) noexcept;
+
+        /// <summary>
+        /// Copies the current state of the histogram.
+        /// </summary>
+        /// <param name="dst">Receives the snapshot.</param>
+        void snapshot(_Out_ latency_histogram& dst) const noexcept;
+
+        atomic_latency_histogram& operator =(
+            const atomic_latency_histogram&) = delete;
+
+    private:
+
+        std::atomic<std::uint64_t> _buckets[latency_histogram::buckets];
+        std::atomic<value_type> _max;
+        std::atomic<value_type> _min;
+        std::atomic<value_type> _sum;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,290 @@
+﻿// <copyright file="batch_kernels.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "batch_kernels.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define POWER_OVERWHELMING_BATCH_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define POWER_OVERWHELMING_BATCH_NEON
+#endif /* defined(_M_X64) || defined(__SSE2__) */
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The number of bits set in each nibble.
+    /// </summary>
+    static constexpr unsigned int nibble_bits[] = {
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+    };
+
+#if defined(POWER_OVERWHELMING_BATCH_NEON)
+    /// <summary>
+    /// Answer the lanes of <paramref name="v" /> that are not
+    /// <paramref name="invalid" />.
+    /// </summary>
+    static inline uint32x4_t neon_valid(_In_ const float32x4_t v,
+            _In_ const float32x4_t invalid) noexcept {
+        return vmvnq_u32(vceqq_f32(v, invalid));
+    }
+
+    /// <summary>
+    /// Packs the most significant bit of each lane of
+    /// <paramref name="mask" /> into a nibble.
+    /// </summary>
+    static inline unsigned int neon_movemask(
+            _In_ const uint32x4_t mask) noexcept {
+        static const std::uint32_t weights[] = { 1, 2, 4, 8 };
+        return vaddvq_u32(vandq_u32(mask, vld1q_u32(weights)));
+    }
+#endif /* defined(POWER_OVERWHELMING_BATCH_NEON) */
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::mask_valid
+ */
+std::size_t visus::power_overwhelming::detail::mask_valid(
+        _Out_writes_((cnt + 63) / 64) std::uint64_t *dst,
+        _In_reads_(cnt) const float *src,
+        _In_ const std::size_t cnt,
+        _In_ const float invalid) noexcept {
+    std::size_t retval = 0;
+
+#if defined(POWER_OVERWHELMING_BATCH_SSE2)
+    const auto inv = _mm_set1_ps(invalid);
+#elif defined(POWER_OVERWHELMING_BATCH_NEON)
+    const auto inv = vdupq_n_f32(invalid);
+#endif /* defined(POWER_OVERWHELMING_BATCH_SSE2) */
+
+    for (std::size_t w = 0; w < cnt; w += 64) {
+        const auto s = src + w;
+        const auto n = (std::min)(static_cast<std::size_t>(64), cnt - w);
+        std::uint64_t word = 0;
+        std::size_t i = 0;
+
+        // Each vector yields a nibble of the mask, so the scalar path only
+        // needs to handle the last few elements of the batch.
+#if defined(POWER_OVERWHELMING_BATCH_SSE2)
+        for (; i + 4 <= n; i += 4) {
+            const auto v = _mm_loadu_ps(s + i);
+            const auto m = static_cast<unsigned int>(
+                _mm_movemask_ps(_mm_cmpneq_ps(v, inv)));
+            word |= static_cast<std::uint64_t>(m) << i;
+            retval += nibble_bits[m];
+        }
+
+#elif defined(POWER_OVERWHELMING_BATCH_NEON)
+        for (; i + 4 <= n; i += 4) {
+            const auto v = vld1q_f32(s + i);
+            const auto m = neon_movemask(neon_valid(v, inv));
+            word |= static_cast<std::uint64_t>(m) << i;
+            retval += nibble_bits[m];
+        }
+#endif /* defined(POWER_OVERWHELMING_BATCH_SSE2) */
+
+        for (; i < n; ++i) {
+            if (s[i] != invalid) {
+                word |= static_cast<std::uint64_t>(1) << i;
+                ++retval;
+            }
+        }
+
+        dst[w / 64] = word;
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::multiply_missing
+ */
+void visus::power_overwhelming::detail::multiply_missing(
+        _Inout_updates_(cnt) float *dst,
+        _In_reads_(cnt) const float *lhs,
+        _In_reads_(cnt) const float *rhs,
+        _In_ const std::size_t cnt,
+        _In_ const float invalid) noexcept {
+    std::size_t i = 0;
+
+#if defined(POWER_OVERWHELMING_BATCH_SSE2)
+    const auto inv = _mm_set1_ps(invalid);
+    for (; i + 4 <= cnt; i += 4) {
+        const auto d = _mm_loadu_ps(dst + i);
+        const auto l = _mm_loadu_ps(lhs + i);
+        const auto r = _mm_loadu_ps(rhs + i);
+        const auto dv = _mm_cmpneq_ps(d, inv);
+        const auto pv = _mm_and_ps(_mm_cmpneq_ps(l, inv),
+            _mm_cmpneq_ps(r, inv));
+        const auto p = _mm_or_ps(_mm_and_ps(pv, _mm_mul_ps(l, r)),
+            _mm_andnot_ps(pv, inv));
+        _mm_storeu_ps(dst + i, _mm_or_ps(_mm_and_ps(dv, d),
+            _mm_andnot_ps(dv, p)));
+    }
+
+#elif defined(POWER_OVERWHELMING_BATCH_NEON)
+    const auto inv = vdupq_n_f32(invalid);
+    for (; i + 4 <= cnt; i += 4) {
+        const auto d = vld1q_f32(dst + i);
+        const auto l = vld1q_f32(lhs + i);
+        const auto r = vld1q_f32(rhs + i);
+        const auto pv = vandq_u32(neon_valid(l, inv), neon_valid(r, inv));
+        const auto p = vbslq_f32(pv, vmulq_f32(l, r), inv);
+        vst1q_f32(dst + i, vbslq_f32(neon_valid(d, inv), d, p));
+    }
+#endif /* defined(POWER_OVERWHELMING_BATCH_SSE2) */
+
+    for (; i < cnt; ++i) {
+        if ((dst[i] == invalid) && (lhs[i] != invalid)
+                && (rhs[i] != invalid)) {
+            dst[i] = lhs[i] * rhs[i];
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::min_max_valid
+ */
+bool visus::power_overwhelming::detail::min_max_valid(_Inout_ float& minimum,
+        _Inout_ float& maximum,
+        _In_reads_(cnt) const float *src,
+        _In_ const std::size_t cnt,
+        _In_ const float invalid) noexcept {
+    // As the invalid value is the lowest one, it never wins the maximum, so
+    // only the minimum needs to mask invalid elements.
+    auto any = false;
+    auto hi = invalid;
+    auto lo = (std::numeric_limits<float>::max)();
+    std::size_t i = 0;
+
+#if defined(POWER_OVERWHELMING_BATCH_SSE2)
+    if (cnt >= 4) {
+        const auto inv = _mm_set1_ps(invalid);
+        const auto top = _mm_set1_ps(lo);
+        auto vany = _mm_setzero_ps();
+        auto vmax = inv;
+        auto vmin = top;
+
+        for (; i + 4 <= cnt; i += 4) {
+            const auto v = _mm_loadu_ps(src + i);
+            const auto valid = _mm_cmpneq_ps(v, inv);
+            vany = _mm_or_ps(vany, valid);
+            vmax = _mm_max_ps(vmax, v);
+            vmin = _mm_min_ps(vmin, _mm_or_ps(_mm_and_ps(valid, v),
+                _mm_andnot_ps(valid, top)));
+        }
+
+        float lanes[2][4];
+        _mm_storeu_ps(lanes[0], vmax);
+        _mm_storeu_ps(lanes[1], vmin);
+        for (int l = 0; l < 4; ++l) {
+            hi = (std::max)(hi, lanes[0][l]);
+            lo = (std::min)(lo, lanes[1][l]);
+        }
+        any = (_mm_movemask_ps(vany) != 0);
+    }
+
+#elif defined(POWER_OVERWHELMING_BATCH_NEON)
+    if (cnt >= 4) {
+        const auto inv = vdupq_n_f32(invalid);
+        const auto top = vdupq_n_f32(lo);
+        auto vany = vdupq_n_u32(0);
+        auto vmax = inv;
+        auto vmin = top;
+
+        for (; i + 4 <= cnt; i += 4) {
+            const auto v = vld1q_f32(src + i);
+            const auto valid = neon_valid(v, inv);
+            vany = vorrq_u32(vany, valid);
+            vmax = vmaxq_f32(vmax, v);
+            vmin = vminq_f32(vmin, vbslq_f32(valid, v, top));
+        }
+
+        hi = vmaxvq_f32(vmax);
+        lo = vminvq_f32(vmin);
+        any = (vmaxvq_u32(vany) != 0);
+    }
+#endif /* defined(POWER_OVERWHELMING_BATCH_SSE2) */
+
+    for (; i < cnt; ++i) {
+        if (src[i] != invalid) {
+            hi = (std::max)(hi, src[i]);
+            lo = (std::min)(lo, src[i]);
+            any = true;
+        }
+    }
+
+    if (any) {
+        minimum = lo;
+        maximum = hi;
+    }
+
+    return any;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sum_valid
+ */
+double visus::power_overwhelming::detail::sum_valid(
+        _In_reads_(cnt) const float *src,
+        _In_ const std::size_t cnt,
+        _In_ const float invalid) noexcept {
+    auto retval = 0.0;
+    std::size_t i = 0;
+
+    // Long batches of power samples lose significant digits if accumulated
+    // in single precision, so the lanes are widened before adding them.
+#if defined(POWER_OVERWHELMING_BATCH_SSE2)
+    const auto inv = _mm_set1_ps(invalid);
+    auto vlo = _mm_setzero_pd();
+    auto vhi = _mm_setzero_pd();
+    for (; i + 4 <= cnt; i += 4) {
+        const auto v = _mm_loadu_ps(src + i);
+        const auto m = _mm_and_ps(_mm_cmpneq_ps(v, inv), v);
+        vlo = _mm_add_pd(vlo, _mm_cvtps_pd(m));
+        vhi = _mm_add_pd(vhi, _mm_cvtps_pd(_mm_movehl_ps(m, m)));
+    }
+
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(vlo, vhi));
+    retval = lanes[0] + lanes[1];
+
+#elif defined(POWER_OVERWHELMING_BATCH_NEON)
+    const auto inv = vdupq_n_f32(invalid);
+    const auto zero = vdupq_n_f32(0.0f);
+    auto vlo = vdupq_n_f64(0.0);
+    auto vhi = vdupq_n_f64(0.0);
+    for (; i + 4 <= cnt; i += 4) {
+        const auto v = vld1q_f32(src + i);
+        const auto m = vbslq_f32(neon_valid(v, inv), v, zero);
+        vlo = vaddq_f64(vlo, vcvt_f64_f32(vget_low_f32(m)));
+        vhi = vaddq_f64(vhi, vcvt_high_f64_f32(m));
+    }
+
+    retval = vaddvq_f64(vaddq_f64(vlo, vhi));
+#endif /* defined(POWER_OVERWHELMING_BATCH_SSE2) */
+
+    for (; i < cnt; ++i) {
+        if (src[i] != invalid) {
+            retval += src[i];
+        }
+    }
+
+    return retval;
+}
@@ -0,0 +1,90 @@
+﻿// <copyright file="batch_kernels.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Computes a bit mask of the elements of <paramref name="src" /> that are
+    /// not <paramref name="invalid" />.
+    /// </summary>
+    /// <param name="dst">Receives one bit per element, starting with the least
+    /// significant bit of the first word. The array must hold at least
+    /// <c>(cnt + 63) / 64</c> words. Unused bits of the last word are
+    /// cleared.</param>
+    /// <param name="src">The values to be checked.</param>
+    /// <param name="cnt">The number of elements in
+    /// <paramref name="src" />.</param>
+    /// <param name="invalid">The value marking invalid elements.</param>
+    /// <returns>The number of valid elements.</returns>
+    std::size_t POWER_OVERWHELMING_API mask_valid(
+        _Out_writes_((cnt + 63) / 64) std::uint64_t *dst,
+        _In_reads_(cnt) const float *src,
+        _In_ const std::size_t cnt,
+        _In_ const float invalid) noexcept;
+
+    /// <summary>
+    /// Replaces all invalid elements of <paramref name="dst" /> with the
+    /// product of <paramref name="lhs" /> and <paramref name="rhs" /> if both
+    /// of them are valid.
+    /// </summary>
+    /// <param name="dst">The values to be completed.</param>
+    /// <param name="lhs">The left-hand side factors.</param>
+    /// <param name="rhs">The right-hand side factors.</param>
+    /// <param name="cnt">The number of elements of all arrays.</param>
+    /// <param name="invalid">The value marking invalid elements.</param>
+    void POWER_OVERWHELMING_API multiply_missing(
+        _Inout_updates_(cnt) float *dst,
+        _In_reads_(cnt) const float *lhs,
+        _In_reads_(cnt) const float *rhs,
+        _In_ const std::size_t cnt,
+        _In_ const float invalid) noexcept;
+
+    /// <summary>
+    /// Determines the smallest and the largest valid element of
+    /// <paramref name="src" />.
+    /// </summary>
+    /// <param name="minimum">Receives the smallest valid element. The value
+    /// is not modified if there is no valid element.</param>
+    /// <param name="maximum">Receives the largest valid element. The value is
+    /// not modified if there is no valid element.</param>
+    /// <param name="src">The values to be checked.</param>
+    /// <param name="cnt">The number of elements in
+    /// <paramref name="src" />.</param>
+    /// <param name="invalid">The value marking invalid elements, which must
+    /// be the lowest value representable.</param>
+    /// <returns><c>true</c> if there was at least one valid element,
+    /// <c>false</c> otherwise.</returns>
+    bool POWER_OVERWHELMING_API min_max_valid(_Inout_ float& minimum,
+        _Inout_ float& maximum,
+        _In_reads_(cnt) const float *src,
+        _In_ const std::size_t cnt,
+        _In_ const float invalid) noexcept;
+
+    /// <summary>
+    /// Computes the sum of all valid elements of <paramref name="src" /> in
+    /// double precision.
+    /// </summary>
+    /// <param name="src">The values to be summed.</param>
+    /// <param name="cnt">The number of elements in
+    /// <paramref name="src" />.</param>
+    /// <param name="invalid">The value marking invalid elements.</param>
+    /// <returns>The sum of the valid elements.</returns>
+    double POWER_OVERWHELMING_API sum_valid(_In_reads_(cnt) const float *src,
+        _In_ const std::size_t cnt,
+        _In_ const float invalid) noexcept;
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
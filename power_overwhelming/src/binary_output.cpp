@@ -0,0 +1,760 @@
+﻿// <copyright file="binary_output.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "binary_output.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+#include "power_overwhelming/convert_string.h"
+
+#include "latency_histogram_codec.h"
+#include "sensor_name_registry.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Converts a wide string into UTF-16 code units.
+    /// </summary>
+    static std::vector<std::uint16_t> to_utf16(_In_z_ const wchar_t *str) {
+        assert(str != nullptr);
+        std::vector<std::uint16_t> retval;
+
+        for (; *str != 0; ++str) {
+            auto c = static_cast<std::uint32_t>(*str);
+
+            if ((sizeof(wchar_t) > 2) && (c > 0xFFFF)) {
+                // Encode a surrogate pair on platforms where wchar_t is UTF-32.
+                c -= 0x10000;
+                retval.push_back(static_cast<std::uint16_t>(0xD800 + (c >> 10)));
+                retval.push_back(static_cast<std::uint16_t>(0xDC00
+                    + (c & 0x3FF)));
+            } else {
+                retval.push_back(static_cast<std::uint16_t>(c));
+            }
+        }
+
+        return retval;
+    }
+
+    /// <summary>
+    /// Converts UTF-16 code units into a wide string.
+    /// </summary>
+    static std::wstring from_utf16(_In_ const std::vector<std::uint16_t>& str) {
+        std::wstring retval;
+        retval.reserve(str.size());
+
+        for (std::size_t i = 0; i < str.size(); ++i) {
+            std::uint32_t c = str[i];
+
+            if ((sizeof(wchar_t) > 2) && (c >= 0xD800) && (c < 0xDC00)
+                    && (i + 1 < str.size())) {
+                // Decode a surrogate pair on platforms where wchar_t is UTF-32.
+                c = 0x10000 + ((c - 0xD800) << 10) + (str[++i] - 0xDC00);
+            }
+
+            retval.push_back(static_cast<wchar_t>(c));
+        }
+
+        return retval;
+    }
+
+    /// <summary>
+    /// Writes the raw bytes of <paramref name="value" /> to the given stream.
+    /// </summary>
+    template<class TValue>
+    inline void write_binary(_In_ std::ostream& stream,
+            _In_ const TValue& value) {
+        stream.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    /// <summary>
+    /// Writes the content of <paramref name="values" /> to the given stream.
+    /// </summary>
+    template<class TValue>
+    inline void write_binary(_In_ std::ostream& stream,
+            _In_ const std::vector<TValue>& values) {
+        stream.write(reinterpret_cast<const char *>(values.data()),
+            values.size() * sizeof(TValue));
+    }
+
+    /// <summary>
+    /// Answer the number of bytes <see cref="write_binary_string" /> writes
+    /// for the given string.
+    /// </summary>
+    static std::uint64_t binary_string_size(_In_z_ const wchar_t *str) {
+        return sizeof(std::uint32_t)
+            + to_utf16(str).size() * sizeof(std::uint16_t);
+    }
+
+    /// <summary>
+    /// Writes the header of a record.
+    /// </summary>
+    static void write_record_header(_In_ std::ostream& stream,
+            _In_ const binary_record_type type,
+            _In_ const std::uint64_t size) {
+        write_binary(stream, static_cast<std::uint32_t>(type));
+        write_binary(stream, size);
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::binary_output_magic
+ */
+const char visus::power_overwhelming::detail::binary_output_magic[8] = {
+    'P', 'W', 'R', 'O', 'W', 'G', 'B', '\0'
+};
+
+
+/*
+ * visus::power_overwhelming::detail::read_binary_string
+ */
+std::wstring visus::power_overwhelming::detail::read_binary_string(
+        _In_ std::istream& stream) {
+    std::uint32_t length = 0;
+    stream.read(reinterpret_cast<char *>(&length), sizeof(length));
+
+    std::vector<std::uint16_t> str(length);
+    stream.read(reinterpret_cast<char *>(str.data()),
+        str.size() * sizeof(std::uint16_t));
+
+    if (!stream) {
+        throw std::runtime_error("The binary output ended while reading a "
+            "string.");
+    }
+
+    return from_utf16(str);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::read_binary_string
+ */
+std::wstring visus::power_overwhelming::detail::read_binary_string(
+        _Inout_ const std::uint8_t *& data,
+        _In_ const std::uint8_t *end) {
+    assert(data <= end);
+    std::uint32_t length = 0;
+
+    if (static_cast<std::size_t>(end - data) < sizeof(length)) {
+        throw std::runtime_error("The binary output ended while reading a "
+            "string.");
+    }
+    ::memcpy(&length, data, sizeof(length));
+    data += sizeof(length);
+
+    const auto size = static_cast<std::size_t>(length)
+        * sizeof(std::uint16_t);
+    if (static_cast<std::size_t>(end - data) < size) {
+        throw std::runtime_error("The binary output ended while reading a "
+            "string.");
+    }
+
+    std::vector<std::uint16_t> str(length);
+    if (size > 0) {
+        ::memcpy(str.data(), data, size);
+    }
+    data += size;
+
+    return from_utf16(str);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::write_binary_string
+ */
+void visus::power_overwhelming::detail::write_binary_string(
+        _In_ std::ostream& stream, _In_z_ const wchar_t *str) {
+    const auto utf16 = to_utf16(str);
+    write_binary(stream, static_cast<std::uint32_t>(utf16.size()));
+    write_binary(stream, utf16);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::binary_output_writer::binary_output_writer
+ */
+visus::power_overwhelming::detail::binary_output_writer::binary_output_writer(
+        void) : _compressed(false), _indexed(false), _last_sensor(nullptr),
+        _last_sensor_index(0), _samples(0), _stream(nullptr) { }
+
+
+/*
+ * visus::power_overwhelming::detail::binary_output_writer::~binary_output_writer
+ */
+visus::power_overwhelming::detail::binary_output_writer::~binary_output_writer(
+        void) {
+    this->close();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::binary_output_writer::aggregate
+ */
+void visus::power_overwhelming::detail::binary_output_writer::aggregate(
+        _In_ const sample_aggregate& aggregate) {
+    const auto index = this->sensor(aggregate.sensor);
+    const std::uint64_t size = 2 * sizeof(std::uint32_t)
+        + 2 * sizeof(measurement::timestamp_type) + sizeof(std::uint64_t)
+        + 3 * sizeof(measurement::value_type) + sizeof(double);
+
+    write_record_header(this->_stream, binary_record_type::aggregate, size);
+    write_binary(this->_stream, index);
+    write_binary(this->_stream, aggregate.begin);
+    write_binary(this->_stream, aggregate.end);
+    write_binary(this->_stream, aggregate.count);
+    write_binary(this->_stream, aggregate.minimum);
+    write_binary(this->_stream, aggregate.mean);
+    write_binary(this->_stream, aggregate.maximum);
+    write_binary(this->_stream, aggregate.energy);
+    write_binary(this->_stream, aggregate.marker);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::binary_output_writer::close
+ */
+void visus::power_overwhelming::detail::binary_output_writer::close(void) {
+    if (this->is_open()) {
+        this->flush();
+        const auto index = this->_indexed ? this->write_index() : 0;
+
+        // The footer marks the file as complete, which cannot be inferred
+        // from its size if it has been pre-extended by a mapping.
+        write_record_header(this->_stream, binary_record_type::end,
+            sizeof(this->_samples) + sizeof(index));
+        write_binary(this->_stream, this->_samples);
+        write_binary(this->_stream, index);
+        this->_stream.flush();
+
+        this->_async.close();
+        this->_file.close();
+        this->_mapped.close();
+        this->_network.close();
+        this->_stream.rdbuf(nullptr);
+    }
+
+    this->_chunks.clear();
+    this->_indexed = false;
+    this->_marker_events.clear();
+    this->_markers.clear();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::binary_output_writer::compressed
+ */
+void visus::power_overwhelming::detail::binary_output_writer::compressed(
+        _In_ const bool compressed) noexcept {
+    this->_compressed = compressed;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::binary_output_writer::connect
+ */
+void visus::power_overwhelming::detail::binary_output_writer::connect(
+        _In_z_ const wchar_t *address, _In_ const std::size_t queue_size) {
+    this->close();
+    this->_samples = 0;
+
+    // The network buffer might drop chunks, so the receiver cannot use the
+    // offsets of an index.
+    this->_network.open(address, queue_size);
+    this->_stream.rdbuf(&this->_network);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::binary_output_writer::flush
+ */
+void visus::power_overwhelming::detail::binary_output_writer::flush(void) {
+    typedef measurement::timestamp_type timestamp_type;
+    typedef measurement::value_type value_type;
+    static constexpr auto sample_size = sizeof(timestamp_type)
+        + 3 * sizeof(value_type) + sizeof(std::uint32_t);
+
+    for (std::size_t i = 0; i < this->_columns.size(); ++i) {
+        auto& c = this->_columns[i];
+        const auto cnt = static_cast<std::uint32_t>(c.timestamp.size());
+
+        if (cnt == 0) {
+            continue;
+        }
+
+        if (this->_indexed) {
+            const auto t = std::minmax_element(c.timestamp.begin(),
+                c.timestamp.end());
+            binary_chunk_index entry;
+            entry.offset = static_cast<std::uint64_t>(this->_stream.tellp());
+            entry.sensor = static_cast<std::uint32_t>(i);
+            entry.count = cnt;
+            entry.begin = *t.first;
+            entry.end = *t.second;
+            this->_chunks.push_back(entry);
+        }
+
+        if (this->_compressed) {
+            // Each column is preceded by its size, so we can encode all of
+            // them into the same buffer and remember where they end.
+            std::uint32_t ends[5];
+            this->_encoded.clear();
+            encode_timestamps(this->_encoded, c.timestamp.data(), cnt);
+            ends[0] = static_cast<std::uint32_t>(this->_encoded.size());
+            encode_xor(this->_encoded, c.voltage.data(), cnt);
+            ends[1] = static_cast<std::uint32_t>(this->_encoded.size());
+            encode_xor(this->_encoded, c.current.data(), cnt);
+            ends[2] = static_cast<std::uint32_t>(this->_encoded.size());
+            encode_xor(this->_encoded, c.power.data(), cnt);
+            ends[3] = static_cast<std::uint32_t>(this->_encoded.size());
+            encode_xor(this->_encoded, c.marker.data(), cnt);
+            ends[4] = static_cast<std::uint32_t>(this->_encoded.size());
+
+            write_record_header(this->_stream,
+                binary_record_type::compressed_samples,
+                2 * sizeof(std::uint32_t) + sizeof(ends)
+                + this->_encoded.size());
+            write_binary(this->_stream, static_cast<std::uint32_t>(i));
+            write_binary(this->_stream, cnt);
+
+            std::uint32_t begin = 0;
+            for (auto e : ends) {
+                write_binary(this->_stream, e - begin);
+                this->_stream.write(reinterpret_cast<const char *>(
+                    this->_encoded.data() + begin), e - begin);
+                begin = e;
+            }
+
+        } else {
+            write_record_header(this->_stream, binary_record_type::samples,
+                2 * sizeof(std::uint32_t) + cnt * sample_size);
+            write_binary(this->_stream, static_cast<std::uint32_t>(i));
+            write_binary(this->_stream, cnt);
+            write_binary(this->_stream, c.timestamp);
+            write_binary(this->_stream, c.voltage);
+            write_binary(this->_stream, c.current);
+            write_binary(this->_stream, c.power);
+            write_binary(this->_stream, c.marker);
+        }
+
+        this->_samples += cnt;
+        c.current.clear();
+        c.marker.clear();
+        c.power.clear();
+        c.timestamp.clear();
+        c.voltage.clear();
+    }
+
+    this->_stream.flush();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::binary_output_writer::header
+ */
+void visus::power_overwhelming::detail::binary_output_writer::header(
+        _In_ const timestamp_resolution resolution,
+        _In_ const std::vector<std::wstring>& sensors) {
+    this->_stream.write(binary_output_magic, sizeof(binary_output_magic));
+    write_binary(this->_stream, this->_compressed
+        ? binary_output_version
+        : std::uint32_t(1));
+    write_binary(this->_stream, static_cast<std::uint32_t>(resolution));
+    write_binary(this->_stream, static_cast<std::uint32_t>(sensors.size()));
+
+    for (auto& s : sensors) {
+        auto name = sensor_name_registry::intern(s.c_str());
+        // Note: If the same name is used twice, the first index is used for
+        // all samples of the sensor.
+        this->_sensors.emplace(name, static_cast<std::uint32_t>(
+            this->_columns.size()));
+        this->_columns.emplace_back();
+        write_binary_string(this->_stream, name);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::binary_output_writer::marker
+ */
+void visus::power_overwhelming::detail::binary_output_writer::marker(
+        _In_ const std::uint32_t id, _In_z_ const wchar_t *name) {
+    assert(id != 0);
+    const auto n = (name != nullptr) ? name : L"";
+    write_record_header(this->_stream, binary_record_type::marker,
+        sizeof(std::uint32_t) + binary_string_size(n));
+    write_binary(this->_stream, id);
+    write_binary_string(this->_stream, n);
+
+    if (this->_indexed) {
+        this->_markers.emplace_back(id, n);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::binary_output_writer::marker_event
+ */
+void visus::power_overwhelming::detail::binary_output_writer::marker_event(
+        _In_ const measurement::timestamp_type timestamp,
+        _In_ const std::uint32_t id) {
+    write_record_header(this->_stream, binary_record_type::marker_event,
+        sizeof(timestamp) + sizeof(id));
+    write_binary(this->_stream, timestamp);
+    write_binary(this->_stream, id);
+
+    if (this->_indexed) {
+        this->_marker_events.emplace_back(timestamp, id);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::binary_output_writer::open
+ */
+void visus::power_overwhelming::detail::binary_output_writer::open(
+        _In_z_ const wchar_t *path, _In_ const bool mapped) {
+    if (path == nullptr) {
+        throw std::invalid_argument("The path to the binary output file must "
+            "not be null.");
+    }
+
+    this->close();
+    this->_samples = 0;
+
+    if (mapped) {
+        this->_mapped.open(path);
+        this->_stream.rdbuf(&this->_mapped);
+
+    } else {
+        const auto mode = std::ofstream::binary | std::ofstream::out
+            | std::ofstream::trunc;
+#if defined(_WIN32)
+        this->_file.open(path, mode);
+#else /* defined(_WIN32) */
+        auto p = power_overwhelming::convert_string<char>(path);
+        this->_file.open(p, mode);
+#endif /* defined(_WIN32) */
+
+        if (!this->_file.is_open()) {
+            throw std::ios_base::failure("The binary output file could not be "
+                "opened.");
+        }
+
+        this->_stream.rdbuf(&this->_file);
+    }
+
+    this->_indexed = true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::binary_output_writer::open_async
+ */
+void visus::power_overwhelming::detail::binary_output_writer::open_async(
+        _In_z_ const wchar_t *path, _In_ const bool direct) {
+    this->close();
+    this->_samples = 0;
+
+    // The buffer knows the logical position of the output, so the file can
+    // be indexed although the writes are still in flight.
+    this->_async.open(path, async_output_buffer::default_buffer_count,
+        async_output_buffer::default_buffer_size, direct);
+    this->_stream.rdbuf(&this->_async);
+    this->_indexed = true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::binary_output_writer::phase_energy
+ */
+void visus::power_overwhelming::detail::binary_output_writer::phase_energy(
+        _In_ const detail::phase_energy& energy) {
+    const auto index = this->sensor(energy.sensor);
+    const std::uint64_t size = 3 * sizeof(std::uint32_t)
+        + 2 * sizeof(measurement::timestamp_type) + sizeof(std::uint64_t)
+        + sizeof(double);
+
+    write_record_header(this->_stream, binary_record_type::phase_energy,
+        size);
+    write_binary(this->_stream, index);
+    write_binary(this->_stream, energy.phase);
+    write_binary(this->_stream, energy.begin);
+    write_binary(this->_stream, energy.end);
+    write_binary(this->_stream, energy.samples);
+    write_binary(this->_stream, energy.energy);
+    write_binary(this->_stream, energy.marker);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::binary_output_writer::phase_quantiles
+ */
+void visus::power_overwhelming::detail::binary_output_writer::phase_quantiles(
+        _In_ const detail::phase_quantiles& quantiles) {
+    typedef detail::phase_quantiles quantiles_type;
+    const auto index = this->sensor(quantiles.sensor);
+    const auto cnt = static_cast<std::uint32_t>(quantiles_type::size);
+    const std::uint64_t size = 3 * sizeof(std::uint32_t)
+        + sizeof(std::uint64_t)
+        + cnt * (sizeof(double) + sizeof(float));
+
+    write_record_header(this->_stream, binary_record_type::phase_quantiles,
+        size);
+    write_binary(this->_stream, index);
+    write_binary(this->_stream, quantiles.marker);
+    write_binary(this->_stream, quantiles.samples);
+    write_binary(this->_stream, cnt);
+    for (std::size_t i = 0; i < quantiles_type::size; ++i) {
+        write_binary(this->_stream, quantiles_type::levels[i]);
+        write_binary(this->_stream, quantiles.values[i]);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::binary_output_writer::push
+ */
+void visus::power_overwhelming::detail::binary_output_writer::push(
+        _In_ const measurement& sample, _In_ const std::uint32_t marker) {
+    auto& c = this->_columns[this->sensor(sample.sensor())];
+    c.current.push_back(sample.current());
+    c.marker.push_back(marker);
+    c.power.push_back(sample.power());
+    c.timestamp.push_back(sample.timestamp());
+    c.voltage.push_back(sample.voltage());
+}
+
+
+/*
+ * visus::power_overwhelming::detail::binary_output_writer::schema_change
+ */
+void visus::power_overwhelming::detail::binary_output_writer::schema_change(
+        _In_ const detail::schema_change& change) {
+    // Declare the sensor first such that readers know all sensors mentioned in
+    // changes of the schema.
+    this->sensor(sensor_name_registry::intern(change.name.c_str()));
+
+    const auto interval = static_cast<std::uint64_t>(change.interval);
+    const auto type = static_cast<std::uint32_t>(change.type);
+    write_record_header(this->_stream, binary_record_type::schema_change,
+        sizeof(change.timestamp) + sizeof(type) + sizeof(interval)
+        + binary_string_size(change.name.c_str()));
+    write_binary(this->_stream, change.timestamp);
+    write_binary(this->_stream, type);
+    write_binary(this->_stream, interval);
+    write_binary_string(this->_stream, change.name.c_str());
+}
+
+
+/*
+ * visus::power_overwhelming::detail::binary_output_writer::sequence_gap
+ */
+void visus::power_overwhelming::detail::binary_output_writer::sequence_gap(
+        _In_ const detail::sequence_gap& gap) {
+    const auto index = this->sensor(gap.sensor);
+    const std::uint64_t size = 3 * sizeof(std::uint32_t)
+        + sizeof(measurement::timestamp_type);
+
+    write_record_header(this->_stream, binary_record_type::sequence_gap,
+        size);
+    write_binary(this->_stream, index);
+    write_binary(this->_stream, gap.timestamp);
+    write_binary(this->_stream, gap.first);
+    write_binary(this->_stream, gap.missing);
+}
+
+
+/*
+ * ...::detail::binary_output_writer::sequence_summary
+ */
+void visus::power_overwhelming::detail::binary_output_writer::sequence_summary(
+        _In_ const detail::sequence_summary& summary) {
+    const auto index = this->sensor(summary.sensor);
+    const std::uint64_t size = sizeof(std::uint32_t)
+        + 4 * sizeof(std::uint64_t);
+
+    write_record_header(this->_stream, binary_record_type::sequence_summary,
+        size);
+    write_binary(this->_stream, index);
+    write_binary(this->_stream, summary.samples);
+    write_binary(this->_stream, summary.gaps);
+    write_binary(this->_stream, summary.missing);
+    write_binary(this->_stream, summary.duplicates);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::binary_output_writer::start
+ */
+void visus::power_overwhelming::detail::binary_output_writer::start(
+        _In_ const start_record& record) {
+    std::uint64_t size = sizeof(record.timestamp) + sizeof(std::uint32_t);
+    for (auto& l : record.latencies) {
+        size += binary_string_size(l.first.c_str()) + sizeof(std::uint64_t);
+    }
+
+    write_record_header(this->_stream, binary_record_type::start, size);
+    write_binary(this->_stream, record.timestamp);
+    write_binary(this->_stream, static_cast<std::uint32_t>(
+        record.latencies.size()));
+
+    for (auto& l : record.latencies) {
+        write_binary_string(this->_stream, l.first.c_str());
+        write_binary(this->_stream, static_cast<std::uint64_t>(l.second));
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::binary_output_writer::statistics
+ */
+void visus::power_overwhelming::detail::binary_output_writer::statistics(
+        _In_ const sampler_statistics_impl& statistics) {
+    std::uint64_t size = 4 * sizeof(std::uint64_t)
+        + latency_histogram_codec::size(statistics.jitter)
+        + latency_histogram_codec::size(statistics.callback_duration)
+        + sizeof(std::uint32_t);
+    for (auto& s : statistics.sources) {
+        size += binary_string_size(s.first.c_str())
+            + latency_histogram_codec::size(s.second);
+    }
+
+    write_record_header(this->_stream, binary_record_type::sampler_statistics,
+        size);
+    write_binary(this->_stream, static_cast<std::uint64_t>(
+        statistics.interval));
+    write_binary(this->_stream, statistics.ticks);
+    write_binary(this->_stream, statistics.overruns);
+    write_binary(this->_stream, statistics.missed_deadlines);
+    latency_histogram_codec::write(this->_stream, statistics.jitter);
+    latency_histogram_codec::write(this->_stream,
+        statistics.callback_duration);
+    write_binary(this->_stream, static_cast<std::uint32_t>(
+        statistics.sources.size()));
+
+    for (auto& s : statistics.sources) {
+        write_binary_string(this->_stream, s.first.c_str());
+        latency_histogram_codec::write(this->_stream, s.second);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::binary_output_writer::written
+ */
+std::uint64_t visus::power_overwhelming::detail::binary_output_writer::written(
+        void) {
+    // Buffers that cannot report their position, like the network, are
+    // treated as empty.
+    const auto retval = this->_stream.tellp();
+    return (retval < 0) ? 0 : static_cast<std::uint64_t>(retval);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::binary_output_writer::write_index
+ */
+std::uint64_t visus::power_overwhelming::detail::binary_output_writer
+::write_index(void) {
+    static constexpr auto chunk_size = sizeof(std::uint64_t)
+        + 2 * sizeof(std::uint32_t) + 2 * sizeof(measurement::timestamp_type);
+    static constexpr auto event_size = sizeof(measurement::timestamp_type)
+        + sizeof(std::uint32_t);
+    const auto retval = static_cast<std::uint64_t>(this->_stream.tellp());
+
+    // The sensors have been declared in the order of their indices, but the
+    // names are only stored in the map from the interned names.
+    std::vector<const wchar_t *> sensors(this->_columns.size(), L"");
+    for (auto& s : this->_sensors) {
+        if (s.first != nullptr) {
+            sensors[s.second] = s.first;
+        }
+    }
+
+    std::uint64_t size = 4 * sizeof(std::uint32_t)
+        + this->_markers.size() * sizeof(std::uint32_t)
+        + this->_marker_events.size() * event_size
+        + this->_chunks.size() * chunk_size;
+    for (auto s : sensors) {
+        size += binary_string_size(s);
+    }
+    for (auto& m : this->_markers) {
+        size += binary_string_size(m.second.c_str());
+    }
+
+    write_record_header(this->_stream, binary_record_type::index, size);
+
+    write_binary(this->_stream, static_cast<std::uint32_t>(sensors.size()));
+    for (auto s : sensors) {
+        write_binary_string(this->_stream, s);
+    }
+
+    write_binary(this->_stream, static_cast<std::uint32_t>(
+        this->_markers.size()));
+    for (auto& m : this->_markers) {
+        write_binary(this->_stream, m.first);
+        write_binary_string(this->_stream, m.second.c_str());
+    }
+
+    write_binary(this->_stream, static_cast<std::uint32_t>(
+        this->_marker_events.size()));
+    for (auto& e : this->_marker_events) {
+        write_binary(this->_stream, e.first);
+        write_binary(this->_stream, e.second);
+    }
+
+    write_binary(this->_stream, static_cast<std::uint32_t>(
+        this->_chunks.size()));
+    for (auto& c : this->_chunks) {
+        write_binary(this->_stream, c.offset);
+        write_binary(this->_stream, c.sensor);
+        write_binary(this->_stream, c.count);
+        write_binary(this->_stream, c.begin);
+        write_binary(this->_stream, c.end);
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::binary_output_writer::sensor
+ */
+std::uint32_t visus::power_overwhelming::detail::binary_output_writer::sensor(
+        _In_z_ const wchar_t *name) {
+    // The names of measurements are interned, so we can compare pointers. We
+    // also remember the last sensor, because the samples of a sensor are
+    // often consecutive in the buffers.
+    if ((name == this->_last_sensor) && (name != nullptr)) {
+        return this->_last_sensor_index;
+    }
+
+    auto it = this->_sensors.find(name);
+    if (it == this->_sensors.end()) {
+        const auto index = static_cast<std::uint32_t>(this->_columns.size());
+        it = this->_sensors.emplace(name, index).first;
+        this->_columns.emplace_back();
+
+        const auto n = (name != nullptr) ? name : L"";
+        write_record_header(this->_stream, binary_record_type::sensor,
+            sizeof(std::uint32_t) + binary_string_size(n));
+        write_binary(this->_stream, index);
+        write_binary_string(this->_stream, n);
+    }
+
+    this->_last_sensor = name;
+    this->_last_sensor_index = it->second;
+    return this->_last_sensor_index;
+}
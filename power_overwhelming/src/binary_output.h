@@ -0,0 +1,636 @@
+﻿// <copyright file="binary_output.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "power_overwhelming/measurement.h"
+#include "power_overwhelming/timestamp_resolution.h"
+
+#include "async_output_buffer.h"
+#include "column_codec.h"
+#include "mapped_output_buffer.h"
+#include "network_output_buffer.h"
+#include "phase_energy.h"
+#include "phase_quantiles.h"
+#include "sample_aggregator.h"
+#include "sampler_statistics_impl.h"
+#include "schema_change.h"
+#include "sequence_tracker.h"
+#include "start_record.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The magic number at the begin of a binary output file.
+    /// </summary>
+    /// <remarks>
+    /// <para>A binary output file starts with the following header:</para>
+    /// <list type="bullet">
+    /// <item>The eight bytes of the magic number.</item>
+    /// <item>The <see cref="binary_output_version" /> as 32-bit unsigned
+    /// integer.</item>
+    /// <item>The <see cref="timestamp_resolution" /> as 32-bit unsigned
+    /// integer.</item>
+    /// <item>The number of sensors as 32-bit unsigned integer followed by the
+    /// names of the sensors. The position of the sensor in this list is its
+    /// index.</item>
+    /// </list>
+    /// <para>The header is followed by an arbitrary number of records, each of
+    /// which starts with its <see cref="binary_record_type" /> as 32-bit
+    /// unsigned integer and the size of the following payload in bytes as
+    /// 64-bit unsigned integer. Readers must skip records of unknown types.
+    /// A complete file ends with a <see cref="binary_record_type::end" />
+    /// record. The type zero is never used for a record, but marks the
+    /// pre-extended space at the end of a memory-mapped file that has not
+    /// been closed properly. Readers must stop at either of them.</para>
+    /// <para>Strings are stored as the number of UTF-16 code units as 32-bit
+    /// unsigned integer followed by the code units. All numbers are stored in
+    /// the native (little endian) byte order.</para>
+    /// </remarks>
+    extern POWER_OVERWHELMING_API const char binary_output_magic[8];
+
+    /// <summary>
+    /// The latest version of the binary output format written by
+    /// <see cref="binary_output_writer" />.
+    /// </summary>
+    /// <remarks>
+    /// Version 2 adds <see cref="binary_record_type::compressed_samples" />.
+    /// Files without compressed samples are still written as version 1, such
+    /// that older readers can process them.
+    /// </remarks>
+    constexpr std::uint32_t binary_output_version = 2;
+
+    /// <summary>
+    /// Identifies the type of a record in a binary output file.
+    /// </summary>
+    enum class binary_record_type : std::uint32_t {
+
+        /// <summary>
+        /// Declares a sensor that was not contained in the header. The payload
+        /// is the 32-bit index of the sensor followed by its name.
+        /// </summary>
+        sensor = 1,
+
+        /// <summary>
+        /// Declares a marker. The payload is the 32-bit ID of the marker
+        /// followed by its name. The ID zero is reserved for samples without
+        /// marker and is never declared.
+        /// </summary>
+        marker = 2,
+
+        /// <summary>
+        /// A chunk of samples of a single sensor. The payload is the 32-bit
+        /// index of the sensor, the 32-bit number <c>n</c> of samples and the
+        /// columns of the samples: <c>n</c> 64-bit timestamps, <c>n</c> 32-bit
+        /// floating point voltages, currents and powers, and <c>n</c> 32-bit
+        /// marker IDs.
+        /// </summary>
+        samples = 3,
+
+        /// <summary>
+        /// The <see cref="start_record" /> of the collector. The payload is the
+        /// 64-bit start timestamp, the 32-bit number of sensors and, for each
+        /// sensor, its name followed by its start latency in microseconds as
+        /// 64-bit unsigned integer.
+        /// </summary>
+        start = 4,
+
+        /// <summary>
+        /// Records that a marker has been set. The payload is the 64-bit
+        /// timestamp when the marker was set followed by the 32-bit ID of the
+        /// marker, which is zero if the marker was cleared.
+        /// </summary>
+        marker_event = 5,
+
+        /// <summary>
+        /// The <see cref="schema_change" /> of a running collector. The
+        /// payload is the 64-bit timestamp of the change, the 32-bit
+        /// <see cref="schema_change_type" />, the new sampling interval in
+        /// microseconds as 64-bit unsigned integer and the name of the sensor.
+        /// </summary>
+        schema_change = 6,
+
+        /// <summary>
+        /// The footer written when the file is closed. The payload is the
+        /// total number of samples in the file as 64-bit unsigned integer
+        /// followed by the offset of the
+        /// <see cref="binary_record_type::index" /> record from the begin of
+        /// the file as 64-bit unsigned integer, which is zero if the file has
+        /// no index.
+        /// </summary>
+        /// <remarks>
+        /// The footer is the last record in a complete file, such that readers
+        /// can locate the index by reading the last 28 bytes. Files written
+        /// by older versions of the library only contain the number of
+        /// samples.
+        /// </remarks>
+        end = 7,
+
+        /// <summary>
+        /// A chunk of samples of a single sensor like
+        /// <see cref="binary_record_type::samples" />, but with compressed
+        /// columns. The payload is the 32-bit index of the sensor and the
+        /// 32-bit number <c>n</c> of samples followed by the columns of the
+        /// timestamps, voltages, currents, powers and marker IDs. Each column
+        /// is stored as its size in bytes as 32-bit unsigned integer followed
+        /// by the output of <see cref="encode_timestamps" /> for the
+        /// timestamps or of <see cref="encode_xor" /> for all other columns.
+        /// </summary>
+        compressed_samples = 8,
+
+        /// <summary>
+        /// The self-instrumentation of a sampler context, which is written
+        /// before the footer. The payload is the sampling interval in
+        /// microseconds, the number of ticks, overruns and missed deadlines,
+        /// each as 64-bit unsigned integer, the histograms of the jitter and
+        /// of the duration of the callbacks, and the 32-bit number of sources
+        /// followed by the name and the histogram of each source. The
+        /// histograms are stored as described for
+        /// <see cref="latency_histogram_codec" />.
+        /// </summary>
+        /// <remarks>
+        /// Readers of older versions skip this record, wherefore it does not
+        /// change the <see cref="binary_output_version" />.
+        /// </remarks>
+        sampler_statistics = 9,
+
+        /// <summary>
+        /// The <see cref="sample_aggregate" /> of a sensor in a window. The
+        /// payload is the 32-bit index of the sensor, the 64-bit begin and end
+        /// of the window, the number of samples as 64-bit unsigned integer,
+        /// the minimum, mean and maximum power as 32-bit floating point
+        /// numbers, the energy as 64-bit floating point number and the 32-bit
+        /// ID of the marker.
+        /// </summary>
+        /// <remarks>
+        /// Readers of older versions skip this record, wherefore it does not
+        /// change the <see cref="binary_output_version" />.
+        /// </remarks>
+        aggregate = 10,
+
+        /// <summary>
+        /// The <see cref="phase_energy" /> of a sensor between two markers.
+        /// The payload is the 32-bit index of the sensor, the 32-bit index of
+        /// the phase, the 64-bit timestamps of the first and the last sample
+        /// in the phase, the number of samples as 64-bit unsigned integer, the
+        /// energy as 64-bit floating point number and the 32-bit ID of the
+        /// marker.
+        /// </summary>
+        /// <remarks>
+        /// Readers of older versions skip this record, wherefore it does not
+        /// change the <see cref="binary_output_version" />.
+        /// </remarks>
+        phase_energy = 11,
+
+        /// <summary>
+        /// The index of a file, which is written immediately before the
+        /// footer. The payload is the 32-bit number of sensors followed by
+        /// their names in the order of their indices, the 32-bit number of
+        /// markers followed by the 32-bit ID and the name of each marker, the
+        /// 32-bit number of marker events followed by the 64-bit timestamp and
+        /// the 32-bit ID of each event, and the 32-bit number of chunks
+        /// followed by a <see cref="binary_chunk_index" /> for each of the
+        /// <see cref="binary_record_type::samples" /> and
+        /// <see cref="binary_record_type::compressed_samples" /> records in
+        /// the file.
+        /// </summary>
+        /// <remarks>
+        /// <para>The index allows readers to retrieve the samples in a time
+        /// range or of a marker without scanning the whole file. Files
+        /// streamed to a remote host have no index, because the offsets of
+        /// the records are not known.</para>
+        /// <para>Readers of older versions skip this record, wherefore it does
+        /// not change the <see cref="binary_output_version" />.</para>
+        /// </remarks>
+        index = 12,
+
+        /// <summary>
+        /// A <see cref="sequence_gap" /> in the samples of a sensor. The
+        /// payload is the 32-bit index of the sensor, the 64-bit timestamp of
+        /// the sample after the gap, the 32-bit sequence number of the first
+        /// missing sample and the 32-bit number of missing samples.
+        /// </summary>
+        /// <remarks>
+        /// Readers of older versions skip this record, wherefore it does not
+        /// change the <see cref="binary_output_version" />.
+        /// </remarks>
+        sequence_gap = 13,
+
+        /// <summary>
+        /// The <see cref="sequence_summary" /> of a sensor, which is written
+        /// before the output is closed. The payload is the 32-bit index of the
+        /// sensor followed by the number of samples, gaps, missing samples and
+        /// duplicates as 64-bit unsigned integers.
+        /// </summary>
+        /// <remarks>
+        /// Readers of older versions skip this record, wherefore it does not
+        /// change the <see cref="binary_output_version" />.
+        /// </remarks>
+        sequence_summary = 14,
+
+        /// <summary>
+        /// The <see cref="phase_quantiles" /> of a sensor and marker, which
+        /// are written before the output is closed. The payload is the 32-bit
+        /// index of the sensor, the 32-bit ID of the marker, the number of
+        /// samples as 64-bit unsigned integer and the 32-bit number of
+        /// quantiles, each of which is the level as 64-bit floating point
+        /// number followed by the power as 32-bit floating point number.
+        /// </summary>
+        /// <remarks>
+        /// Readers of older versions skip this record, wherefore it does not
+        /// change the <see cref="binary_output_version" />.
+        /// </remarks>
+        phase_quantiles = 15
+    };
+
+    /// <summary>
+    /// An entry in the <see cref="binary_record_type::index" /> that locates a
+    /// chunk of samples in a binary output file.
+    /// </summary>
+    /// <remarks>
+    /// The entry is stored as the 64-bit offset, the 32-bit index of the
+    /// sensor, the 32-bit number of samples and the 64-bit minimum and
+    /// maximum timestamps.
+    /// </remarks>
+    struct binary_chunk_index final {
+
+        /// <summary>
+        /// The offset of the chunk record from the begin of the file.
+        /// </summary>
+        std::uint64_t offset;
+
+        /// <summary>
+        /// The index of the sensor that has produced the samples.
+        /// </summary>
+        std::uint32_t sensor;
+
+        /// <summary>
+        /// The number of samples in the chunk.
+        /// </summary>
+        std::uint32_t count;
+
+        /// <summary>
+        /// The smallest timestamp of any sample in the chunk.
+        /// </summary>
+        measurement::timestamp_type begin;
+
+        /// <summary>
+        /// The largest timestamp of any sample in the chunk.
+        /// </summary>
+        measurement::timestamp_type end;
+    };
+
+    /// <summary>
+    /// Reads a string in the format of the binary output from the given
+    /// stream.
+    /// </summary>
+    /// <param name="stream">The stream to read from.</param>
+    /// <returns>The string read from the stream.</returns>
+    /// <exception cref="std::runtime_error">If the stream ended prematurely.
+    /// </exception>
+    std::wstring POWER_OVERWHELMING_API read_binary_string(
+        _In_ std::istream& stream);
+
+    /// <summary>
+    /// Reads a string in the format of the binary output from the given
+    /// memory range.
+    /// </summary>
+    /// <param name="data">The begin of the string, which will be moved past
+    /// the string.</param>
+    /// <param name="end">The end of the readable memory.</param>
+    /// <returns>The string read from the memory.</returns>
+    /// <exception cref="std::runtime_error">If the string exceeds the
+    /// memory range.</exception>
+    std::wstring POWER_OVERWHELMING_API read_binary_string(
+        _Inout_ const std::uint8_t *& data,
+        _In_ const std::uint8_t *end);
+
+    /// <summary>
+    /// Writes a string in the format of the binary output to the given
+    /// stream.
+    /// </summary>
+    /// <param name="stream">The stream to write to.</param>
+    /// <param name="str">The string to be written.</param>
+    void POWER_OVERWHELMING_API write_binary_string(_In_ std::ostream& stream,
+        _In_z_ const wchar_t *str);
+
+    /// <summary>
+    /// Writes samples in the chunked binary format.
+    /// </summary>
+    /// <remarks>
+    /// The writer collects the samples passed to <see cref="push" /> in
+    /// columns per sensor and writes one chunk per sensor on
+    /// <see cref="flush" />. The column buffers are retained between chunks,
+    /// so the writer does not allocate memory in steady state.
+    /// </remarks>
+    class POWER_OVERWHELMING_API binary_output_writer final {
+
+    public:
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        binary_output_writer(void);
+
+        binary_output_writer(const binary_output_writer&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~binary_output_writer(void);
+
+        /// <summary>
+        /// Writes the aggregate of the samples of a sensor in a window.
+        /// </summary>
+        /// <remarks>
+        /// If the aggregate refers to a sensor that has not been declared yet,
+        /// the sensor is declared before the record is written.
+        /// </remarks>
+        /// <param name="aggregate">The aggregate to be written.</param>
+        void aggregate(_In_ const sample_aggregate& aggregate);
+
+        /// <summary>
+        /// Writes all pending samples, the index and the footer and closes the
+        /// file.
+        /// </summary>
+        void close(void);
+
+        /// <summary>
+        /// Answer whether the samples are written as
+        /// <see cref="binary_record_type::compressed_samples" />.
+        /// </summary>
+        /// <returns><c>true</c> if the columns are compressed, <c>false</c>
+        /// otherwise.</returns>
+        inline bool compressed(void) const noexcept {
+            return this->_compressed;
+        }
+
+        /// <summary>
+        /// Sets whether the samples are written as
+        /// <see cref="binary_record_type::compressed_samples" />.
+        /// </summary>
+        /// <remarks>
+        /// This setting must be made before the <see cref="header" /> is
+        /// written. The compression runs in the thread calling
+        /// <see cref="flush" />.
+        /// </remarks>
+        /// <param name="compressed">Whether to compress the columns.</param>
+        void compressed(_In_ const bool compressed) noexcept;
+
+        /// <summary>
+        /// Connects to the given remote host and streams the output to it
+        /// via a <see cref="network_output_buffer" />.
+        /// </summary>
+        /// <param name="address">The address of the remote host in the form
+        /// <c>host:port</c>.</param>
+        /// <param name="queue_size">The maximum number of bytes waiting to be
+        /// sent.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="address" /> is <c>nullptr</c> or invalid.
+        /// </exception>
+        /// <exception cref="std::system_error">If the connection could not be
+        /// established.</exception>
+        /// <exception cref="std::runtime_error">If the host could not be
+        /// resolved.</exception>
+        void connect(_In_z_ const wchar_t *address,
+            _In_ const std::size_t queue_size
+            = network_output_buffer::default_queue_size);
+
+        /// <summary>
+        /// Answer the number of samples that have been dropped while being
+        /// streamed to a remote host.
+        /// </summary>
+        /// <remarks>
+        /// This method can be called from any thread.
+        /// </remarks>
+        /// <returns>The number of dropped samples, which is always zero for
+        /// files.</returns>
+        inline std::uint64_t dropped(void) const noexcept {
+            return this->_network.dropped();
+        }
+
+        /// <summary>
+        /// Writes all pending samples to the file.
+        /// </summary>
+        void flush(void);
+
+        /// <summary>
+        /// Writes the file header.
+        /// </summary>
+        /// <param name="resolution">The resolution of the timestamps of the
+        /// samples.</param>
+        /// <param name="sensors">The names of the sensors known in advance.
+        /// </param>
+        void header(_In_ const timestamp_resolution resolution,
+            _In_ const std::vector<std::wstring>& sensors);
+
+        /// <summary>
+        /// Answer whether the output file is open.
+        /// </summary>
+        /// <returns><c>true</c> if the file is open, <c>false</c> otherwise.
+        /// </returns>
+        inline bool is_open(void) const {
+            return (this->_async.is_open() || this->_file.is_open()
+                || this->_mapped.is_open() || this->_network.is_open());
+        }
+
+        /// <summary>
+        /// Declares a marker.
+        /// </summary>
+        /// <remarks>
+        /// Each marker must be declared once before samples or events refer
+        /// to it.
+        /// </remarks>
+        /// <param name="id">The non-zero ID of the marker.</param>
+        /// <param name="name">The text of the marker.</param>
+        void marker(_In_ const std::uint32_t id, _In_z_ const wchar_t *name);
+
+        /// <summary>
+        /// Writes the event of a marker being set.
+        /// </summary>
+        /// <param name="timestamp">The time when the marker was set.</param>
+        /// <param name="id">The ID of the marker, which is zero if the marker
+        /// was cleared.</param>
+        void marker_event(_In_ const measurement::timestamp_type timestamp,
+            _In_ const std::uint32_t id);
+
+        /// <summary>
+        /// Opens the given file for writing, replacing any existing content.
+        /// </summary>
+        /// <param name="path">The path to the output file.</param>
+        /// <param name="mapped">If <c>true</c>, the file is written through a
+        /// <see cref="mapped_output_buffer" /> rather than a file stream.
+        /// </param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="path" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::ios_base::failure">If the file could not be
+        /// opened.</exception>
+        /// <exception cref="std::system_error">If the file could not be
+        /// mapped.</exception>
+        void open(_In_z_ const wchar_t *path, _In_ const bool mapped = false);
+
+        /// <summary>
+        /// Opens the given file for writing, replacing any existing content,
+        /// and writes it asynchronously through an
+        /// <see cref="async_output_buffer" />.
+        /// </summary>
+        /// <remarks>
+        /// <see cref="flush" /> only submits the pending data, so the thread
+        /// writing the output does not block on the disk unless all buffers
+        /// are in flight.
+        /// </remarks>
+        /// <param name="path">The path to the output file.</param>
+        /// <param name="direct">If <c>true</c>, the file is written without
+        /// the page cache if the file system supports this.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="path" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::system_error">If the file could not be
+        /// created.</exception>
+        void open_async(_In_z_ const wchar_t *path,
+            _In_ const bool direct = false);
+
+        /// <summary>
+        /// Writes the energy of a sensor in a phase between two markers.
+        /// </summary>
+        /// <remarks>
+        /// If the phase refers to a sensor that has not been declared yet,
+        /// the sensor is declared before the record is written.
+        /// </remarks>
+        /// <param name="energy">The energy to be written.</param>
+        void phase_energy(_In_ const detail::phase_energy& energy);
+
+        /// <summary>
+        /// Writes the distribution of the power of a sensor while a marker
+        /// was active.
+        /// </summary>
+        /// <remarks>
+        /// If the quantiles refer to a sensor that has not been declared yet,
+        /// the sensor is declared before the record is written.
+        /// </remarks>
+        /// <param name="quantiles">The quantiles to be written.</param>
+        void phase_quantiles(_In_ const detail::phase_quantiles& quantiles);
+
+        /// <summary>
+        /// Adds a sample to the pending chunk of its sensor.
+        /// </summary>
+        /// <param name="sample">The sample to be added.</param>
+        /// <param name="marker">The ID of the marker active for the sample,
+        /// which is zero if no marker is active.</param>
+        void push(_In_ const measurement& sample,
+            _In_ const std::uint32_t marker);
+
+        /// <summary>
+        /// Writes a change of the sensors of the running collector.
+        /// </summary>
+        /// <remarks>
+        /// If the change refers to a sensor that has not been declared yet,
+        /// the sensor is declared before the record is written.
+        /// </remarks>
+        /// <param name="change">The change to be written.</param>
+        void schema_change(_In_ const detail::schema_change& change);
+
+        /// <summary>
+        /// Writes a gap in the sequence numbers of the samples of a sensor.
+        /// </summary>
+        /// <remarks>
+        /// If the gap refers to a sensor that has not been declared yet, the
+        /// sensor is declared before the record is written.
+        /// </remarks>
+        /// <param name="gap">The gap to be written.</param>
+        void sequence_gap(_In_ const detail::sequence_gap& gap);
+
+        /// <summary>
+        /// Writes the counters of the sequence numbers of a sensor.
+        /// </summary>
+        /// <remarks>
+        /// If the summary refers to a sensor that has not been declared yet,
+        /// the sensor is declared before the record is written.
+        /// </remarks>
+        /// <param name="summary">The summary to be written.</param>
+        void sequence_summary(_In_ const detail::sequence_summary& summary);
+
+        /// <summary>
+        /// Writes the start record of the collector.
+        /// </summary>
+        /// <param name="record">The start record to be written.</param>
+        void start(_In_ const start_record& record);
+
+        /// <summary>
+        /// Writes the self-instrumentation of a sampler context.
+        /// </summary>
+        /// <param name="statistics">The statistics to be written.</param>
+        void statistics(_In_ const sampler_statistics_impl& statistics);
+
+        /// <summary>
+        /// Answer the number of bytes written to the output so far.
+        /// </summary>
+        /// <remarks>
+        /// Samples are only written on <see cref="flush" />, so the pending
+        /// chunks are not included.
+        /// </remarks>
+        /// <returns>The size of the output in bytes, which is zero for the
+        /// network.</returns>
+        std::uint64_t written(void);
+
+        binary_output_writer& operator =(const binary_output_writer&) = delete;
+
+    private:
+
+        /// <summary>
+        /// The pending samples of a single sensor.
+        /// </summary>
+        struct column_set {
+            std::vector<measurement::value_type> current;
+            std::vector<std::uint32_t> marker;
+            std::vector<measurement::value_type> power;
+            std::vector<measurement::timestamp_type> timestamp;
+            std::vector<measurement::value_type> voltage;
+        };
+
+        /// <summary>
+        /// Answer the index of the given interned sensor name, declaring the
+        /// sensor if necessary.
+        /// </summary>
+        std::uint32_t sensor(_In_z_ const wchar_t *name);
+
+        /// <summary>
+        /// Writes the <see cref="binary_record_type::index" /> record and
+        /// answer its offset from the begin of the file.
+        /// </summary>
+        std::uint64_t write_index(void);
+
+        async_output_buffer _async;
+        std::vector<binary_chunk_index> _chunks;
+        std::vector<column_set> _columns;
+        bool _compressed;
+        std::vector<std::uint8_t> _encoded;
+        std::filebuf _file;
+        bool _indexed;
+        const wchar_t *_last_sensor;
+        std::uint32_t _last_sensor_index;
+        mapped_output_buffer _mapped;
+        std::vector<std::pair<measurement::timestamp_type, std::uint32_t>>
+            _marker_events;
+        std::vector<std::pair<std::uint32_t, std::wstring>> _markers;
+        network_output_buffer _network;
+        std::uint64_t _samples;
+        std::unordered_map<const wchar_t *, std::uint32_t> _sensors;
+        std::ostream _stream;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
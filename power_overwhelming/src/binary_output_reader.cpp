@@ -0,0 +1,367 @@
+﻿// <copyright file="binary_output_reader.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/binary_output_reader.h"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+#include "power_overwhelming/convert_string.h"
+
+#include "binary_output_reader_impl.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Decodes the given chunk and passes the samples matching
+    /// <paramref name="predicate" /> to the callback.
+    /// </summary>
+    template<class TPredicate>
+    static std::size_t deliver(_In_ binary_output_reader_impl& impl,
+            _In_ const binary_chunk_index& chunk,
+            _In_ TPredicate predicate,
+            _In_ const measurement_data_callback callback,
+            _In_opt_ void *context) {
+        impl.decode(chunk);
+        impl.samples.clear();
+
+        for (std::size_t i = 0; i < chunk.count; ++i) {
+            if (predicate(impl.timestamp[i], impl.marker[i])) {
+                impl.samples.emplace_back(impl.timestamp[i], impl.voltage[i],
+                    impl.current[i], impl.power[i]);
+            }
+        }
+
+        if (!impl.samples.empty()) {
+            callback(impl.sensors[chunk.sensor].c_str(), impl.samples.data(),
+                impl.samples.size(), context);
+        }
+
+        return impl.samples.size();
+    }
+
+    /// <summary>
+    /// Answer the IDs under which <paramref name="marker" /> was declared.
+    /// </summary>
+    static std::vector<std::uint32_t> marker_ids(
+            _In_ const binary_output_reader_impl& impl,
+            _In_z_ const wchar_t *marker) {
+        // The same text might have been declared under multiple IDs.
+        std::vector<std::uint32_t> retval;
+        for (auto& m : impl.markers) {
+            if (m.second == marker) {
+                retval.push_back(m.first);
+            }
+        }
+        return retval;
+    }
+
+    /// <summary>
+    /// Answer the time spans in which any of the given markers was set.
+    /// </summary>
+    static std::vector<std::pair<binary_output_reader::timestamp_type,
+            binary_output_reader::timestamp_type>> marker_phases(
+            _In_ const binary_output_reader_impl& impl,
+            _In_ const std::vector<std::uint32_t>& ids) {
+        typedef binary_output_reader::timestamp_type timestamp_type;
+        std::vector<std::pair<timestamp_type, timestamp_type>> retval;
+
+        // Each phase of the marker lasts until the next marker event. As the
+        // events are chronological, the phases are disjoint and sorted.
+        for (std::size_t i = 0; i < impl.marker_events.size(); ++i) {
+            if (std::find(ids.begin(), ids.end(),
+                    impl.marker_events[i].second) != ids.end()) {
+                retval.emplace_back(impl.marker_events[i].first,
+                    (i + 1 < impl.marker_events.size())
+                    ? impl.marker_events[i + 1].first
+                    : (std::numeric_limits<timestamp_type>::max)());
+            }
+        }
+
+        return retval;
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::binary_output_reader::binary_output_reader
+ */
+visus::power_overwhelming::binary_output_reader::binary_output_reader(
+    void) noexcept : _impl(nullptr) { }
+
+
+/*
+ * visus::power_overwhelming::binary_output_reader::binary_output_reader
+ */
+visus::power_overwhelming::binary_output_reader::binary_output_reader(
+    _In_z_ const wchar_t *path)
+    : _impl(new detail::binary_output_reader_impl(path)) { }
+
+
+/*
+ * visus::power_overwhelming::binary_output_reader::binary_output_reader
+ */
+visus::power_overwhelming::binary_output_reader::binary_output_reader(
+        _In_z_ const char *path) : _impl(nullptr) {
+    if (path == nullptr) {
+        throw std::invalid_argument("The path to the binary output file must "
+            "not be null.");
+    }
+
+    auto p = power_overwhelming::convert_string<wchar_t>(path);
+    this->_impl = new detail::binary_output_reader_impl(p.c_str());
+}
+
+
+/*
+ * visus::power_overwhelming::binary_output_reader::~binary_output_reader
+ */
+visus::power_overwhelming::binary_output_reader::~binary_output_reader(
+        void) {
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::binary_output_reader::indexed
+ */
+bool visus::power_overwhelming::binary_output_reader::indexed(
+        void) const noexcept {
+    return (this->_impl != nullptr) && this->_impl->indexed;
+}
+
+
+/*
+ * visus::power_overwhelming::binary_output_reader::marker
+ */
+_Ret_maybenull_z_ const wchar_t *
+visus::power_overwhelming::binary_output_reader::marker(
+        _In_ const std::size_t index) const noexcept {
+    return (index < this->markers())
+        ? this->_impl->markers[index].second.c_str()
+        : nullptr;
+}
+
+
+/*
+ * visus::power_overwhelming::binary_output_reader::markers
+ */
+std::size_t visus::power_overwhelming::binary_output_reader::markers(
+        void) const noexcept {
+    return (this->_impl != nullptr) ? this->_impl->markers.size() : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::binary_output_reader::phases
+ */
+std::size_t visus::power_overwhelming::binary_output_reader::phases(
+        _In_z_ const wchar_t *marker,
+        _Out_writes_opt_(cnt) timestamp_type *begin,
+        _Out_writes_opt_(cnt) timestamp_type *end,
+        _In_ const std::size_t cnt) const {
+    if (marker == nullptr) {
+        throw std::invalid_argument("The name of the marker must not be "
+            "null.");
+    }
+
+    if (this->_impl == nullptr) {
+        return 0;
+    }
+
+    const auto phases = detail::marker_phases(*this->_impl,
+        detail::marker_ids(*this->_impl, marker));
+    for (std::size_t i = 0; (i < cnt) && (i < phases.size()); ++i) {
+        if (begin != nullptr) {
+            begin[i] = phases[i].first;
+        }
+        if (end != nullptr) {
+            end[i] = phases[i].second;
+        }
+    }
+
+    return phases.size();
+}
+
+
+/*
+ * visus::power_overwhelming::binary_output_reader::read
+ */
+std::size_t visus::power_overwhelming::binary_output_reader::read(
+        _In_opt_z_ const wchar_t *sensor,
+        _In_ const timestamp_type begin,
+        _In_ const timestamp_type end,
+        _In_ const measurement_data_callback callback,
+        _In_opt_ void *context) const {
+    if (callback == nullptr) {
+        throw std::invalid_argument("The callback receiving the samples must "
+            "not be null.");
+    }
+
+    if (this->_impl == nullptr) {
+        return 0;
+    }
+
+    auto& impl = *this->_impl;
+    const auto index = (sensor != nullptr)
+        ? impl.find_sensor(sensor)
+        : impl.sensors.size();
+    if ((sensor != nullptr) && (index >= impl.sensors.size())) {
+        return 0;
+    }
+
+    std::size_t retval = 0;
+    for (auto& c : impl.chunks) {
+        if ((sensor != nullptr) && (c.sensor != index)) {
+            continue;
+        }
+        if ((c.end < begin) || (c.begin >= end)) {
+            continue;
+        }
+
+        retval += detail::deliver(impl, c,
+            [begin, end](const timestamp_type t, const std::uint32_t) {
+                return ((t >= begin) && (t < end));
+            }, callback, context);
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::binary_output_reader::read
+ */
+std::size_t visus::power_overwhelming::binary_output_reader::read(
+        _In_opt_z_ const wchar_t *sensor,
+        _In_z_ const wchar_t *marker,
+        _In_ const measurement_data_callback callback,
+        _In_opt_ void *context) const {
+    typedef std::pair<timestamp_type, timestamp_type> span_type;
+
+    if (marker == nullptr) {
+        throw std::invalid_argument("The name of the marker must not be "
+            "null.");
+    }
+    if (callback == nullptr) {
+        throw std::invalid_argument("The callback receiving the samples must "
+            "not be null.");
+    }
+
+    if (this->_impl == nullptr) {
+        return 0;
+    }
+
+    auto& impl = *this->_impl;
+    const auto index = (sensor != nullptr)
+        ? impl.find_sensor(sensor)
+        : impl.sensors.size();
+    if ((sensor != nullptr) && (index >= impl.sensors.size())) {
+        return 0;
+    }
+
+    const auto ids = detail::marker_ids(impl, marker);
+    auto is_marker = [&ids](const std::uint32_t id) {
+        return (std::find(ids.begin(), ids.end(), id) != ids.end());
+    };
+
+    const auto phases = detail::marker_phases(impl, ids);
+    if (phases.empty()) {
+        return 0;
+    }
+
+    std::size_t retval = 0;
+    for (auto& c : impl.chunks) {
+        if ((sensor != nullptr) && (c.sensor != index)) {
+            continue;
+        }
+
+        // Find the last phase starting before the end of the chunk, which is
+        // the only one that can overlap it if it does not end before the
+        // chunk.
+        auto it = std::upper_bound(phases.begin(), phases.end(), c.end,
+            [](const timestamp_type t, const span_type& p) {
+                return (t < p.first);
+            });
+        if ((it == phases.begin()) || ((--it)->second <= c.begin)) {
+            continue;
+        }
+
+        // The samples carry the marker that was active when they were
+        // recorded, which is authoritative for the phase.
+        retval += detail::deliver(impl, c,
+            [&is_marker](const timestamp_type, const std::uint32_t m) {
+                return is_marker(m);
+            }, callback, context);
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::binary_output_reader::resolution
+ */
+visus::power_overwhelming::timestamp_resolution
+visus::power_overwhelming::binary_output_reader::resolution(
+        void) const noexcept {
+    return (this->_impl != nullptr)
+        ? this->_impl->resolution
+        : timestamp_resolution::milliseconds;
+}
+
+
+/*
+ * visus::power_overwhelming::binary_output_reader::sensor
+ */
+_Ret_maybenull_z_ const wchar_t *
+visus::power_overwhelming::binary_output_reader::sensor(
+        _In_ const std::size_t index) const noexcept {
+    return (index < this->sensors())
+        ? this->_impl->sensors[index].c_str()
+        : nullptr;
+}
+
+
+/*
+ * visus::power_overwhelming::binary_output_reader::sensors
+ */
+std::size_t visus::power_overwhelming::binary_output_reader::sensors(
+        void) const noexcept {
+    return (this->_impl != nullptr) ? this->_impl->sensors.size() : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::binary_output_reader::operator =
+ */
+visus::power_overwhelming::binary_output_reader&
+visus::power_overwhelming::binary_output_reader::operator =(
+        _Inout_ binary_output_reader&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::binary_output_reader::operator bool
+ */
+visus::power_overwhelming::binary_output_reader::operator bool(
+        void) const noexcept {
+    return (this->_impl != nullptr);
+}
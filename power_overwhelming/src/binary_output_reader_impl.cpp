@@ -0,0 +1,483 @@
+﻿// <copyright file="binary_output_reader_impl.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "binary_output_reader_impl.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else /* defined(_WIN32) */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif /* defined(_WIN32) */
+
+#include "power_overwhelming/convert_string.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Reads values from a memory range, checking that they do not exceed it.
+    /// </summary>
+    class binary_cursor final {
+
+    public:
+
+        inline binary_cursor(_In_reads_(size) const std::uint8_t *data,
+                _In_ const std::uint64_t size) noexcept
+            : _current(data), _end(data + size) { }
+
+        inline const std::uint8_t *position(void) const noexcept {
+            return this->_current;
+        }
+
+        template<class TValue> inline TValue read(void) {
+            TValue retval;
+            ::memcpy(&retval, this->skip(sizeof(retval)), sizeof(retval));
+            return retval;
+        }
+
+        template<class TValue>
+        inline void read(_Out_writes_(cnt) TValue *dst,
+                _In_ const std::size_t cnt) {
+            const auto size = cnt * sizeof(TValue);
+            const auto src = this->skip(size);
+            if (size > 0) {
+                ::memcpy(dst, src, size);
+            }
+        }
+
+        inline std::uint64_t remaining(void) const noexcept {
+            return static_cast<std::uint64_t>(this->_end - this->_current);
+        }
+
+        inline const std::uint8_t *skip(_In_ const std::uint64_t size) {
+            if (size > this->remaining()) {
+                throw std::runtime_error("The binary output ended "
+                    "prematurely.");
+            }
+
+            auto retval = this->_current;
+            this->_current += size;
+            return retval;
+        }
+
+        inline std::wstring string(void) {
+            return read_binary_string(this->_current, this->_end);
+        }
+
+    private:
+
+        const std::uint8_t *_current;
+        const std::uint8_t *_end;
+    };
+
+
+    /// <summary>
+    /// Unmaps a file mapped by <see cref="map_file" />.
+    /// </summary>
+    static void unmap_file(_In_ const std::uint8_t *data,
+            _In_ const std::uint64_t size) noexcept {
+        if (data != nullptr) {
+#if defined(_WIN32)
+            ::UnmapViewOfFile(data);
+#else /* defined(_WIN32) */
+            ::munmap(const_cast<std::uint8_t *>(data),
+                static_cast<std::size_t>(size));
+#endif /* defined(_WIN32) */
+        }
+    }
+
+
+    /// <summary>
+    /// Maps the whole file at the given location for reading.
+    /// </summary>
+    static const std::uint8_t *map_file(_In_z_ const wchar_t *path,
+            _Out_ std::uint64_t& size) {
+        assert(path != nullptr);
+        const std::uint8_t *retval = nullptr;
+        size = 0;
+
+#if defined(_WIN32)
+        // The collector might still be writing the file, so we must share
+        // it for writing.
+        auto file = ::CreateFileW(path, GENERIC_READ,
+            FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::system_error(::GetLastError(), std::system_category());
+        }
+
+        LARGE_INTEGER length;
+        if (!::GetFileSizeEx(file, &length)) {
+            auto error = ::GetLastError();
+            ::CloseHandle(file);
+            throw std::system_error(error, std::system_category());
+        }
+        size = static_cast<std::uint64_t>(length.QuadPart);
+
+        if (size > 0) {
+            // The view keeps the mapping and the file alive, so we do not
+            // need to retain their handles.
+            auto mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY,
+                0, 0, nullptr);
+            if (mapping == NULL) {
+                auto error = ::GetLastError();
+                ::CloseHandle(file);
+                throw std::system_error(error, std::system_category());
+            }
+
+            retval = static_cast<const std::uint8_t *>(::MapViewOfFile(
+                mapping, FILE_MAP_READ, 0, 0, 0));
+            auto error = ::GetLastError();
+            ::CloseHandle(mapping);
+            if (retval == nullptr) {
+                ::CloseHandle(file);
+                throw std::system_error(error, std::system_category());
+            }
+        }
+
+        ::CloseHandle(file);
+
+#else /* defined(_WIN32) */
+        auto p = power_overwhelming::convert_string<char>(path);
+        auto file = ::open(p.c_str(), O_RDONLY | O_CLOEXEC);
+        if (file < 0) {
+            throw std::system_error(errno, std::system_category());
+        }
+
+        struct stat info;
+        if (::fstat(file, &info) != 0) {
+            auto error = errno;
+            ::close(file);
+            throw std::system_error(error, std::system_category());
+        }
+        size = static_cast<std::uint64_t>(info.st_size);
+
+        if (size > 0) {
+            auto data = ::mmap(nullptr, static_cast<std::size_t>(size),
+                PROT_READ, MAP_SHARED, file, 0);
+            if (data == MAP_FAILED) {
+                auto error = errno;
+                ::close(file);
+                throw std::system_error(error, std::system_category());
+            }
+
+            // The chunks are accessed in arbitrary order.
+            ::madvise(data, static_cast<std::size_t>(size), MADV_RANDOM);
+            retval = static_cast<const std::uint8_t *>(data);
+        }
+
+        ::close(file);
+#endif /* defined(_WIN32) */
+
+        return retval;
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * ...::detail::binary_output_reader_impl::binary_output_reader_impl
+ */
+visus::power_overwhelming::detail::binary_output_reader_impl
+::binary_output_reader_impl(_In_z_ const wchar_t *path)
+        : data(nullptr), indexed(false),
+        resolution(timestamp_resolution::milliseconds), size(0) {
+    // The footer consists of the record header, the number of samples and
+    // the offset of the index.
+    static constexpr auto footer_size = sizeof(std::uint32_t)
+        + 3 * sizeof(std::uint64_t);
+
+    if (path == nullptr) {
+        throw std::invalid_argument("The path to the binary output file must "
+            "not be null.");
+    }
+
+    this->data = map_file(path, this->size);
+
+    try {
+        binary_cursor header(this->data, this->size);
+
+        if ((header.remaining() < sizeof(binary_output_magic))
+                || (::memcmp(header.skip(sizeof(binary_output_magic)),
+                binary_output_magic, sizeof(binary_output_magic)) != 0)) {
+            throw std::runtime_error("The input is not a binary output "
+                "file of a collector.");
+        }
+
+        if (header.read<std::uint32_t>() > binary_output_version) {
+            throw std::runtime_error("The binary output file has been "
+                "written by a newer version of the library.");
+        }
+
+        this->resolution = static_cast<timestamp_resolution>(
+            header.read<std::uint32_t>());
+        this->sensors.resize(header.read<std::uint32_t>());
+        for (auto& s : this->sensors) {
+            s = header.string();
+        }
+
+        const auto records = static_cast<std::uint64_t>(header.position()
+            - this->data);
+        std::uint64_t index = 0;
+
+        // A complete file ends with the footer, which locates the index.
+        if (header.remaining() >= footer_size) {
+            binary_cursor footer(this->data + this->size - footer_size,
+                footer_size);
+            const auto type = footer.read<std::uint32_t>();
+            const auto payload = footer.read<std::uint64_t>();
+
+            if ((static_cast<binary_record_type>(type)
+                    == binary_record_type::end)
+                    && (payload == 2 * sizeof(std::uint64_t))) {
+                footer.read<std::uint64_t>();
+                index = footer.read<std::uint64_t>();
+            }
+        }
+
+        if ((index >= records) && (index < this->size)) {
+            this->load_index(index);
+            this->indexed = true;
+        } else {
+            this->scan(records);
+        }
+
+    } catch (...) {
+        unmap_file(this->data, this->size);
+        throw;
+    }
+}
+
+
+/*
+ * ...::detail::binary_output_reader_impl::~binary_output_reader_impl
+ */
+visus::power_overwhelming::detail::binary_output_reader_impl
+::~binary_output_reader_impl(void) {
+    unmap_file(this->data, this->size);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::binary_output_reader_impl::decode
+ */
+void visus::power_overwhelming::detail::binary_output_reader_impl::decode(
+        _In_ const binary_chunk_index& chunk) {
+    binary_cursor record(this->data, this->size);
+    record.skip(chunk.offset);
+    const auto type = static_cast<binary_record_type>(
+        record.read<std::uint32_t>());
+    const auto size = record.read<std::uint64_t>();
+    binary_cursor payload(record.skip(size), size);
+
+    const auto sensor = payload.read<std::uint32_t>();
+    const auto cnt = payload.read<std::uint32_t>();
+    if ((sensor != chunk.sensor) || (cnt != chunk.count)) {
+        throw std::runtime_error("The index of the binary output does not "
+            "match its chunks of samples.");
+    }
+
+    this->current.resize(cnt);
+    this->marker.resize(cnt);
+    this->power.resize(cnt);
+    this->timestamp.resize(cnt);
+    this->voltage.resize(cnt);
+
+    switch (type) {
+        case binary_record_type::samples:
+            payload.read(this->timestamp.data(), cnt);
+            payload.read(this->voltage.data(), cnt);
+            payload.read(this->current.data(), cnt);
+            payload.read(this->power.data(), cnt);
+            payload.read(this->marker.data(), cnt);
+            break;
+
+        case binary_record_type::compressed_samples: {
+            // Each column is preceded by its size in bytes.
+            auto column = [&payload](void) {
+                const auto size = payload.read<std::uint32_t>();
+                return std::make_pair(payload.skip(size), size);
+            };
+
+            auto c = column();
+            decode_timestamps(this->timestamp.data(), cnt, c.first, c.second);
+            c = column();
+            decode_xor(this->voltage.data(), cnt, c.first, c.second);
+            c = column();
+            decode_xor(this->current.data(), cnt, c.first, c.second);
+            c = column();
+            decode_xor(this->power.data(), cnt, c.first, c.second);
+            c = column();
+            decode_xor(this->marker.data(), cnt, c.first, c.second);
+            } break;
+
+        default:
+            throw std::runtime_error("The index of the binary output does not "
+                "refer to a chunk of samples.");
+    }
+}
+
+
+/*
+ * ...::detail::binary_output_reader_impl::find_sensor
+ */
+std::size_t visus::power_overwhelming::detail::binary_output_reader_impl
+::find_sensor(_In_z_ const wchar_t *name) const noexcept {
+    assert(name != nullptr);
+    for (std::size_t i = 0; i < this->sensors.size(); ++i) {
+        if (this->sensors[i] == name) {
+            return i;
+        }
+    }
+
+    return this->sensors.size();
+}
+
+
+/*
+ * ...::detail::binary_output_reader_impl::load_index
+ */
+void visus::power_overwhelming::detail::binary_output_reader_impl::load_index(
+        _In_ const std::uint64_t offset) {
+    binary_cursor record(this->data, this->size);
+    record.skip(offset);
+    const auto type = static_cast<binary_record_type>(
+        record.read<std::uint32_t>());
+    const auto size = record.read<std::uint64_t>();
+    binary_cursor payload(record.skip(size), size);
+
+    if (type != binary_record_type::index) {
+        throw std::runtime_error("The footer of the binary output does not "
+            "refer to its index.");
+    }
+
+    this->sensors.resize(payload.read<std::uint32_t>());
+    for (auto& s : this->sensors) {
+        s = payload.string();
+    }
+
+    this->markers.resize(payload.read<std::uint32_t>());
+    for (auto& m : this->markers) {
+        m.first = payload.read<std::uint32_t>();
+        m.second = payload.string();
+    }
+
+    this->marker_events.resize(payload.read<std::uint32_t>());
+    for (auto& e : this->marker_events) {
+        e.first = payload.read<timestamp_type>();
+        e.second = payload.read<std::uint32_t>();
+    }
+
+    this->chunks.resize(payload.read<std::uint32_t>());
+    for (auto& c : this->chunks) {
+        c.offset = payload.read<std::uint64_t>();
+        c.sensor = payload.read<std::uint32_t>();
+        c.count = payload.read<std::uint32_t>();
+        c.begin = payload.read<timestamp_type>();
+        c.end = payload.read<timestamp_type>();
+
+        if ((c.sensor >= this->sensors.size()) || (c.offset >= offset)) {
+            throw std::runtime_error("The index of the binary output is "
+                "corrupt.");
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::binary_output_reader_impl::scan
+ */
+void visus::power_overwhelming::detail::binary_output_reader_impl::scan(
+        _In_ const std::uint64_t offset) {
+    static constexpr auto header_size = sizeof(std::uint32_t)
+        + sizeof(std::uint64_t);
+    binary_cursor records(this->data, this->size);
+    records.skip(offset);
+
+    while (records.remaining() >= header_size) {
+        const auto position = static_cast<std::uint64_t>(records.position()
+            - this->data);
+        const auto type = records.read<std::uint32_t>();
+        const auto size = records.read<std::uint64_t>();
+
+        if ((type == 0) || (static_cast<binary_record_type>(type)
+                == binary_record_type::end)) {
+            // This is either the footer or the unused space of a mapped file
+            // that has not been closed, so there are no more data.
+            break;
+        }
+
+        if (size > records.remaining()) {
+            // The process writing the file has crashed while writing the
+            // last record, which we ignore.
+            break;
+        }
+
+        binary_cursor payload(records.skip(size), size);
+
+        switch (static_cast<binary_record_type>(type)) {
+            case binary_record_type::sensor: {
+                const auto index = payload.read<std::uint32_t>();
+                if (index >= this->sensors.size()) {
+                    this->sensors.resize(index + 1);
+                }
+                this->sensors[index] = payload.string();
+                } break;
+
+            case binary_record_type::marker: {
+                const auto id = payload.read<std::uint32_t>();
+                this->markers.emplace_back(id, payload.string());
+                } break;
+
+            case binary_record_type::marker_event: {
+                const auto timestamp = payload.read<timestamp_type>();
+                const auto id = payload.read<std::uint32_t>();
+                this->marker_events.emplace_back(timestamp, id);
+                } break;
+
+            case binary_record_type::samples:
+            case binary_record_type::compressed_samples: {
+                binary_chunk_index chunk;
+                chunk.offset = position;
+                chunk.sensor = payload.read<std::uint32_t>();
+                chunk.count = payload.read<std::uint32_t>();
+
+                if (chunk.sensor >= this->sensors.size()) {
+                    throw std::runtime_error("The binary output contains "
+                        "samples of an undeclared sensor.");
+                }
+
+                if (chunk.count > 0) {
+                    // Only the timestamps are needed for the index, but the
+                    // compressed columns cannot be skipped without decoding.
+                    this->decode(chunk);
+                    const auto t = std::minmax_element(this->timestamp.begin(),
+                        this->timestamp.end());
+                    chunk.begin = *t.first;
+                    chunk.end = *t.second;
+                    this->chunks.push_back(chunk);
+                }
+                } break;
+
+            default:
+                // Skip records we do not know.
+                break;
+        }
+    }
+}
@@ -0,0 +1,144 @@
+﻿// <copyright file="binary_output_reader_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "power_overwhelming/binary_output_reader.h"
+
+#include "binary_output.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The private state of a <see cref="binary_output_reader" />.
+    /// </summary>
+    struct binary_output_reader_impl final {
+
+        /// <summary>
+        /// The type of the timestamps of the samples.
+        /// </summary>
+        typedef measurement_data::timestamp_type timestamp_type;
+
+        /// <summary>
+        /// The chunks of samples in the order in which they are stored in
+        /// the file.
+        /// </summary>
+        std::vector<binary_chunk_index> chunks;
+
+        /// <summary>
+        /// The currents of the chunk being decoded.
+        /// </summary>
+        std::vector<measurement_data::value_type> current;
+
+        /// <summary>
+        /// The begin of the mapped file.
+        /// </summary>
+        const std::uint8_t *data;
+
+        /// <summary>
+        /// Indicates whether the index has been loaded from the file.
+        /// </summary>
+        bool indexed;
+
+        /// <summary>
+        /// The marker IDs of the chunk being decoded.
+        /// </summary>
+        std::vector<std::uint32_t> marker;
+
+        /// <summary>
+        /// The times when markers have been set or cleared in chronological
+        /// order.
+        /// </summary>
+        std::vector<std::pair<timestamp_type, std::uint32_t>> marker_events;
+
+        /// <summary>
+        /// The IDs and names of the markers.
+        /// </summary>
+        std::vector<std::pair<std::uint32_t, std::wstring>> markers;
+
+        /// <summary>
+        /// The powers of the chunk being decoded.
+        /// </summary>
+        std::vector<measurement_data::value_type> power;
+
+        /// <summary>
+        /// The resolution of the timestamps.
+        /// </summary>
+        timestamp_resolution resolution;
+
+        /// <summary>
+        /// The samples passed to the callback.
+        /// </summary>
+        std::vector<measurement_data> samples;
+
+        /// <summary>
+        /// The names of the sensors in the order of their indices.
+        /// </summary>
+        std::vector<std::wstring> sensors;
+
+        /// <summary>
+        /// The size of the mapped file in bytes.
+        /// </summary>
+        std::uint64_t size;
+
+        /// <summary>
+        /// The timestamps of the chunk being decoded.
+        /// </summary>
+        std::vector<timestamp_type> timestamp;
+
+        /// <summary>
+        /// The voltages of the chunk being decoded.
+        /// </summary>
+        std::vector<measurement_data::value_type> voltage;
+
+        /// <summary>
+        /// Maps the given file and loads or builds its index.
+        /// </summary>
+        explicit binary_output_reader_impl(_In_z_ const wchar_t *path);
+
+        binary_output_reader_impl(const binary_output_reader_impl&) = delete;
+
+        /// <summary>
+        /// Unmaps the file.
+        /// </summary>
+        ~binary_output_reader_impl(void);
+
+        /// <summary>
+        /// Decodes the columns of the given chunk into the column buffers.
+        /// </summary>
+        void decode(_In_ const binary_chunk_index& chunk);
+
+        /// <summary>
+        /// Answer the index of the sensor with the given name, or the number
+        /// of sensors if there is no such sensor.
+        /// </summary>
+        std::size_t find_sensor(_In_z_ const wchar_t *name) const noexcept;
+
+        /// <summary>
+        /// Loads the index record at the given offset.
+        /// </summary>
+        void load_index(_In_ const std::uint64_t offset);
+
+        /// <summary>
+        /// Builds the index by scanning the records starting at the given
+        /// offset.
+        /// </summary>
+        void scan(_In_ const std::uint64_t offset);
+
+        binary_output_reader_impl& operator =(
+            const binary_output_reader_impl&) = delete;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,466 @@
+﻿// <copyright file="binary_output_to_csv.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/binary_output_to_csv.h"
+
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+#include "power_overwhelming/convert_string.h"
+#include "power_overwhelming/csv_iomanip.h"
+
+#include "binary_output.h"
+#include "latency_histogram_codec.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Reads <paramref name="cnt" /> values from the given stream.
+    /// </summary>
+    template<class TValue>
+    static void read_binary(_In_ std::istream& stream,
+            _Out_writes_(cnt) TValue *values, _In_ const std::size_t cnt) {
+        stream.read(reinterpret_cast<char *>(values), cnt * sizeof(TValue));
+
+        if (!stream) {
+            throw std::runtime_error("The binary output ended prematurely.");
+        }
+    }
+
+    /// <summary>
+    /// Converts the binary input stream to CSV.
+    /// </summary>
+    static std::size_t binary_output_to_csv(_In_ std::istream& input,
+            _In_ std::wostream& output) {
+        std::vector<measurement::value_type> current;
+        const auto delimiter = getcsvdelimiter(output);
+        std::vector<std::uint8_t> encoded;
+        std::vector<std::uint32_t> marker;
+        std::map<std::uint32_t, std::wstring> markers;
+        std::vector<measurement::value_type> power;
+        std::size_t retval = 0;
+        std::vector<std::wstring> sensors;
+        std::vector<measurement::timestamp_type> timestamp;
+        std::vector<measurement::value_type> voltage;
+
+        // Check the header.
+        {
+            char magic[sizeof(binary_output_magic)];
+            std::uint32_t version;
+
+            input.read(magic, sizeof(magic));
+            if (!input || (std::memcmp(magic, binary_output_magic,
+                    sizeof(magic)) != 0)) {
+                throw std::runtime_error("The input is not a binary output "
+                    "file of a collector.");
+            }
+
+            read_binary(input, &version, 1);
+            if (version > binary_output_version) {
+                throw std::runtime_error("The binary output file has been "
+                    "written by a newer version of the library.");
+            }
+        }
+
+        {
+            std::uint32_t resolution, cnt;
+            read_binary(input, &resolution, 1);
+            read_binary(input, &cnt, 1);
+
+            sensors.reserve(cnt);
+            for (std::uint32_t i = 0; i < cnt; ++i) {
+                sensors.push_back(read_binary_string(input));
+            }
+        }
+
+        auto resize = [&](const std::uint32_t cnt) {
+            current.resize(cnt);
+            marker.resize(cnt);
+            power.resize(cnt);
+            timestamp.resize(cnt);
+            voltage.resize(cnt);
+        };
+
+        // Writes the first cnt samples in the columns as lines of the CSV.
+        auto emit = [&](const std::uint32_t index, const std::uint32_t cnt) {
+            if (index >= sensors.size()) {
+                throw std::runtime_error("The binary output contains "
+                    "samples of an undeclared sensor.");
+            }
+
+            for (std::uint32_t i = 0; i < cnt; ++i) {
+                measurement m(sensors[index].c_str(), timestamp[i],
+                    voltage[i], current[i], power[i]);
+
+                if (retval == 0) {
+                    output << csvheader
+                        << m << delimiter
+                        << L"marker" << std::endl
+                        << csvdata;
+                }
+
+                output << m << delimiter;
+                if (marker[i] != 0) {
+                    output << markers[marker[i]];
+                }
+                output << L'\n';
+
+                ++retval;
+            }
+        };
+
+        // Process the records.
+        while (input.peek() != std::istream::traits_type::eof()) {
+            std::uint32_t type;
+            std::uint64_t size;
+            read_binary(input, &type, 1);
+            read_binary(input, &size, 1);
+
+            if ((type == 0) || (static_cast<binary_record_type>(type)
+                    == binary_record_type::end)) {
+                // This is either the footer or the unused space of a mapped
+                // file that has not been closed, so there are no more data.
+                break;
+            }
+
+            switch (static_cast<binary_record_type>(type)) {
+                case binary_record_type::sensor: {
+                    std::uint32_t index;
+                    read_binary(input, &index, 1);
+                    if (index >= sensors.size()) {
+                        sensors.resize(index + 1);
+                    }
+                    sensors[index] = read_binary_string(input);
+                    } break;
+
+                case binary_record_type::marker: {
+                    std::uint32_t id;
+                    read_binary(input, &id, 1);
+                    markers[id] = read_binary_string(input);
+                    } break;
+
+                case binary_record_type::samples: {
+                    std::uint32_t index, cnt;
+                    read_binary(input, &index, 1);
+                    read_binary(input, &cnt, 1);
+                    resize(cnt);
+
+                    read_binary(input, timestamp.data(), cnt);
+                    read_binary(input, voltage.data(), cnt);
+                    read_binary(input, current.data(), cnt);
+                    read_binary(input, power.data(), cnt);
+                    read_binary(input, marker.data(), cnt);
+
+                    emit(index, cnt);
+                    } break;
+
+                case binary_record_type::compressed_samples: {
+                    std::uint32_t index, cnt;
+                    read_binary(input, &index, 1);
+                    read_binary(input, &cnt, 1);
+                    resize(cnt);
+
+                    auto column = [&input, &encoded](void) {
+                        std::uint32_t size;
+                        read_binary(input, &size, 1);
+                        encoded.resize(size);
+                        read_binary(input, encoded.data(), size);
+                    };
+
+                    column();
+                    decode_timestamps(timestamp.data(), cnt, encoded.data(),
+                        encoded.size());
+                    column();
+                    decode_xor(voltage.data(), cnt, encoded.data(),
+                        encoded.size());
+                    column();
+                    decode_xor(current.data(), cnt, encoded.data(),
+                        encoded.size());
+                    column();
+                    decode_xor(power.data(), cnt, encoded.data(),
+                        encoded.size());
+                    column();
+                    decode_xor(marker.data(), cnt, encoded.data(),
+                        encoded.size());
+
+                    emit(index, cnt);
+                    } break;
+
+                case binary_record_type::start: {
+                    start_record record;
+                    std::uint32_t cnt;
+                    read_binary(input, &record.timestamp, 1);
+                    read_binary(input, &cnt, 1);
+
+                    record.latencies.resize(cnt);
+                    for (auto& l : record.latencies) {
+                        std::uint64_t latency;
+                        l.first = read_binary_string(input);
+                        read_binary(input, &latency, 1);
+                        l.second = latency;
+                    }
+
+                    write_csv(output, record);
+                    } break;
+
+                case binary_record_type::marker_event: {
+                    measurement::timestamp_type timestamp;
+                    std::uint32_t id;
+                    read_binary(input, &timestamp, 1);
+                    read_binary(input, &id, 1);
+
+                    output << L"# marker event" << delimiter << timestamp
+                        << delimiter;
+                    if (id != 0) {
+                        output << markers[id];
+                    }
+                    output << L'\n';
+                    } break;
+
+                case binary_record_type::schema_change: {
+                    schema_change change;
+                    std::uint32_t kind;
+                    std::uint64_t interval;
+                    read_binary(input, &change.timestamp, 1);
+                    read_binary(input, &kind, 1);
+                    read_binary(input, &interval, 1);
+                    change.interval = static_cast<sensor::microseconds_type>(
+                        interval);
+                    change.name = read_binary_string(input);
+                    change.type = static_cast<schema_change_type>(kind);
+
+                    write_csv(output, change);
+                    } break;
+
+                case binary_record_type::sampler_statistics: {
+                    sampler_statistics_impl statistics;
+                    std::uint64_t interval;
+                    std::uint32_t cnt;
+                    read_binary(input, &interval, 1);
+                    read_binary(input, &statistics.ticks, 1);
+                    read_binary(input, &statistics.overruns, 1);
+                    read_binary(input, &statistics.missed_deadlines, 1);
+                    statistics.interval = static_cast<
+                        sensor::microseconds_type>(interval);
+                    statistics.jitter = latency_histogram_codec::read(input);
+                    statistics.callback_duration
+                        = latency_histogram_codec::read(input);
+                    read_binary(input, &cnt, 1);
+
+                    statistics.sources.resize(cnt);
+                    for (auto& s : statistics.sources) {
+                        s.first = read_binary_string(input);
+                        s.second = latency_histogram_codec::read(input);
+                    }
+
+                    write_csv(output, statistics);
+                    } break;
+
+                case binary_record_type::aggregate: {
+                    sample_aggregate aggregate;
+                    std::uint32_t index;
+                    read_binary(input, &index, 1);
+                    read_binary(input, &aggregate.begin, 1);
+                    read_binary(input, &aggregate.end, 1);
+                    read_binary(input, &aggregate.count, 1);
+                    read_binary(input, &aggregate.minimum, 1);
+                    read_binary(input, &aggregate.mean, 1);
+                    read_binary(input, &aggregate.maximum, 1);
+                    read_binary(input, &aggregate.energy, 1);
+                    read_binary(input, &aggregate.marker, 1);
+
+                    if (index >= sensors.size()) {
+                        throw std::runtime_error("The binary output contains "
+                            "an aggregate of an undeclared sensor.");
+                    }
+
+                    const auto quote_char = getcsvquote(output);
+                    output << L"# aggregate" << delimiter;
+                    if (quote_char != 0) {
+                        output << quote(sensors[index].c_str(), quote_char);
+                    } else {
+                        output << sensors[index];
+                    }
+                    output << delimiter
+                        << aggregate.begin << delimiter
+                        << aggregate.end << delimiter
+                        << aggregate.count << delimiter
+                        << aggregate.minimum << delimiter
+                        << aggregate.mean << delimiter
+                        << aggregate.maximum << delimiter;
+
+                    // Use the same precision for the energy as the CSV
+                    // output of the collector.
+                    const auto precision = output.precision(15);
+                    output << aggregate.energy << delimiter;
+                    output.precision(precision);
+                    if (aggregate.marker != 0) {
+                        output << markers[aggregate.marker];
+                    }
+                    output << L'\n';
+                    } break;
+
+                case binary_record_type::phase_energy: {
+                    phase_energy energy;
+                    std::uint32_t index;
+                    read_binary(input, &index, 1);
+                    read_binary(input, &energy.phase, 1);
+                    read_binary(input, &energy.begin, 1);
+                    read_binary(input, &energy.end, 1);
+                    read_binary(input, &energy.samples, 1);
+                    read_binary(input, &energy.energy, 1);
+                    read_binary(input, &energy.marker, 1);
+
+                    if (index >= sensors.size()) {
+                        throw std::runtime_error("The binary output contains "
+                            "the energy of an undeclared sensor.");
+                    }
+
+                    const auto quote_char = getcsvquote(output);
+                    output << L"# phase energy" << delimiter
+                        << energy.phase << delimiter;
+                    if (quote_char != 0) {
+                        output << quote(sensors[index].c_str(), quote_char);
+                    } else {
+                        output << sensors[index];
+                    }
+                    output << delimiter
+                        << energy.begin << delimiter
+                        << energy.end << delimiter
+                        << energy.samples << delimiter;
+
+                    const auto precision = output.precision(15);
+                    output << energy.energy << delimiter;
+                    output.precision(precision);
+                    if (energy.marker != 0) {
+                        output << markers[energy.marker];
+                    }
+                    output << L'\n';
+                    } break;
+
+                case binary_record_type::phase_quantiles: {
+                    std::uint32_t index, marker, cnt;
+                    std::uint64_t samples;
+                    read_binary(input, &index, 1);
+                    read_binary(input, &marker, 1);
+                    read_binary(input, &samples, 1);
+                    read_binary(input, &cnt, 1);
+
+                    if (index >= sensors.size()) {
+                        throw std::runtime_error("The binary output contains "
+                            "the quantiles of an undeclared sensor.");
+                    }
+
+                    const auto quote_char = getcsvquote(output);
+                    output << L"# phase quantiles" << delimiter;
+                    if (quote_char != 0) {
+                        output << quote(sensors[index].c_str(), quote_char);
+                    } else {
+                        output << sensors[index];
+                    }
+                    output << delimiter;
+                    if (marker != 0) {
+                        output << markers[marker];
+                    }
+                    output << delimiter << samples;
+
+                    // The levels are stored with each record, but the
+                    // comment only holds the estimates like the CSV output
+                    // of the collector.
+                    for (std::uint32_t i = 0; i < cnt; ++i) {
+                        double level;
+                        float value;
+                        read_binary(input, &level, 1);
+                        read_binary(input, &value, 1);
+                        output << delimiter << value;
+                    }
+                    output << L'\n';
+                    } break;
+
+                default:
+                    // Skip records we do not know.
+                    input.seekg(static_cast<std::streamoff>(size),
+                        std::ios_base::cur);
+                    break;
+            }
+        }
+
+        output.flush();
+        return retval;
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::binary_output_to_csv
+ */
+std::size_t visus::power_overwhelming::binary_output_to_csv(
+        _In_z_ const wchar_t *input, _In_z_ const wchar_t *output) {
+    if (input == nullptr) {
+        throw std::invalid_argument("The input path must not be null.");
+    }
+    if (output == nullptr) {
+        throw std::invalid_argument("The output path must not be null.");
+    }
+
+    std::ifstream i;
+    i.exceptions(std::ios::badbit);
+    std::wofstream o;
+    o.exceptions(o.exceptions() | std::ios::failbit | std::ios::badbit);
+
+#if defined(_WIN32)
+    i.open(input, std::ifstream::binary | std::ifstream::in);
+    o.open(output, std::ofstream::out | std::ofstream::trunc);
+#else /* defined(_WIN32) */
+    i.open(power_overwhelming::convert_string<char>(input),
+        std::ifstream::binary | std::ifstream::in);
+    o.open(power_overwhelming::convert_string<char>(output),
+        std::ofstream::out | std::ofstream::trunc);
+#endif /* defined(_WIN32) */
+
+    if (!i.is_open()) {
+        throw std::ios_base::failure("The binary output file could not be "
+            "opened.");
+    }
+
+    return detail::binary_output_to_csv(i, o);
+}
+
+
+/*
+ * visus::power_overwhelming::binary_output_to_csv
+ */
+std::size_t visus::power_overwhelming::binary_output_to_csv(
+        _In_z_ const char *input, _In_z_ const char *output) {
+    if (input == nullptr) {
+        throw std::invalid_argument("The input path must not be null.");
+    }
+    if (output == nullptr) {
+        throw std::invalid_argument("The output path must not be null.");
+    }
+
+    std::ifstream i;
+    i.exceptions(std::ios::badbit);
+    i.open(input, std::ifstream::binary | std::ifstream::in);
+    if (!i.is_open()) {
+        throw std::ios_base::failure("The binary output file could not be "
+            "opened.");
+    }
+
+    std::wofstream o;
+    o.exceptions(o.exceptions() | std::ios::failbit | std::ios::badbit);
+    o.open(output, std::ofstream::out | std::ofstream::trunc);
+
+    return detail::binary_output_to_csv(i, o);
+}
@@ -9,14 +9,31 @@
 #include <cstring>
 #include <memory>
 
+#include "blob_pool.h"
+
+
+/*
+ * visus::power_overwhelming::blob::inline_capacity
+ */
+constexpr std::size_t visus::power_overwhelming::blob::inline_capacity;
+
+
+/*
+ * visus::power_overwhelming::blob::blob
+ */
+visus::power_overwhelming::blob::blob(_In_ const std::size_t size)
+        : _data(nullptr), _size(size), _capacity(0) {
+    this->allocate(this->_size);
+}
+
 
 /*
  * visus::power_overwhelming::blob::blob
  */
 visus::power_overwhelming::blob::blob(_In_ const blob& rhs)
-        : _data(nullptr), _size(rhs._size) {
+        : _data(nullptr), _size(rhs._size), _capacity(0) {
     if (rhs._data != nullptr) {
-        this->_data = new byte_type[this->_size];
+        this->allocate(this->_size);
         ::memcpy(this->_data, rhs._data, this->_size);
     }
 
@@ -28,9 +45,16 @@ visus::power_overwhelming::blob::blob(_In_ const blob& rhs)
  * visus::power_overwhelming::blob::blob
  */
 visus::power_overwhelming::blob::blob(_Inout_ blob&& rhs) noexcept
-        : _data(rhs._data), _size(rhs._size) {
+        : _data(rhs._data), _size(rhs._size), _capacity(rhs._capacity) {
+    if (rhs._data == rhs._inline) {
+        // Inline data cannot be stolen, but must be copied.
+        ::memcpy(this->_inline, rhs._inline, this->_size);
+        this->_data = this->_inline;
+    }
+
     rhs._data = nullptr;
     rhs._size = 0;
+    rhs._capacity = 0;
     assert(rhs._data == nullptr);
     assert(rhs._size == 0);
 }
@@ -40,7 +64,7 @@ visus::power_overwhelming::blob::blob(_Inout_ blob&& rhs) noexcept
  * visus::power_overwhelming::blob::~blob
  */
 visus::power_overwhelming::blob::~blob(void) {
-    delete[] this->_data;
+    this->release();
 }
 
 
@@ -72,8 +96,7 @@ _Ret_maybenull_ const void *visus::power_overwhelming::blob::at(
  * visus::power_overwhelming::blob::clear
  */
 void visus::power_overwhelming::blob::clear(void) {
-    delete[] this->_data;
-    this->_data = nullptr;
+    this->release();
     this->_size = 0;
 }
 
@@ -107,14 +130,24 @@ bool visus::power_overwhelming::blob::grow(_In_ const std::size_t size) {
     const auto retval = (size > this->_size);
 
     if (retval) {
-        const auto existing = this->_data;
-        this->_data = new byte_type[size];
-
-        if (existing != nullptr) {
-            ::memcpy(this->_data, existing, this->_size);
-            delete[] existing;
-            this->_size = size;
+        if ((this->_data == nullptr) || (size > this->_capacity)) {
+            // Note: if the existing buffer is the inline one, the new one
+            // cannot be, because it is too small. Therefore, there is no risk
+            // of copying the inline buffer onto itself.
+            const auto existing = this->_data;
+            const auto capacity = this->_capacity;
+            this->allocate(size);
+
+            if (existing != nullptr) {
+                ::memcpy(this->_data, existing, this->_size);
+
+                if (existing != this->_inline) {
+                    detail::blob_pool::deallocate(existing, capacity);
+                }
+            }
         }
+
+        this->_size = size;
     }
 
     return retval;
@@ -172,9 +205,12 @@ bool visus::power_overwhelming::blob::reserve(_In_ const std::size_t size) {
     const auto retval = (size > this->_size);
 
     if (retval) {
-        delete[] this->_data;
+        if ((this->_data == nullptr) || (size > this->_capacity)) {
+            this->release();
+            this->allocate(size);
+        }
+
         this->_size = size;
-        this->_data = new byte_type[this->_size];
     }
 
     return retval;
@@ -186,14 +222,14 @@ bool visus::power_overwhelming::blob::reserve(_In_ const std::size_t size) {
  */
 void visus::power_overwhelming::blob::resize(_In_ const std::size_t size) {
     if (this->_size != size) {
-        delete[] this->_data;
-        this->_size = size;
-
-        if (this->_size > 0) {
-            this->_data = new byte_type[this->_size];
-        } else {
-            this->_data = nullptr;
+        if (size == 0) {
+            this->release();
+        } else if ((this->_data == nullptr) || (size > this->_capacity)) {
+            this->release();
+            this->allocate(size);
         }
+
+        this->_size = size;
     }
 }
 
@@ -203,20 +239,18 @@ void visus::power_overwhelming::blob::resize(_In_ const std::size_t size) {
  */
 void visus::power_overwhelming::blob::truncate(_In_ const std::size_t size) {
     if (this->_size != size) {
-        const auto existing = this->_data;
+        if (size == 0) {
+            this->release();
+            this->_size = 0;
 
-        if (size > 0) {
-            this->_data = new byte_type[size];
-        } else {
-            this->_data = nullptr;
-        }
+        } else if ((this->_data != nullptr) && (size <= this->_capacity)) {
+            // The existing buffer is large enough, so the content and any
+            // uninitialised memory after it remain in place.
+            this->_size = size;
 
-        if ((this->_data != nullptr) && (existing != nullptr)) {
-            ::memcpy(this->_data, existing, (std::min)(this->_size, size));
+        } else {
+            this->grow(size);
         }
-
-        delete[] existing;
-        this->_size = size;
     }
 }
 
@@ -227,14 +261,13 @@ void visus::power_overwhelming::blob::truncate(_In_ const std::size_t size) {
 visus::power_overwhelming::blob& visus::power_overwhelming::blob::operator =(
         _In_ const blob& rhs) {
     if (this != std::addressof(rhs)) {
-        if ((this->_data != nullptr) && (this->_size != rhs._size)) {
-            delete[] this->_data;
-            this->_data = nullptr;
+        if ((rhs._data == nullptr) || (rhs._size > this->_capacity)) {
+            this->release();
         }
 
         this->_size = rhs._size;
         if ((this->_data == nullptr) && (rhs._data != nullptr)) {
-            this->_data = new byte_type[this->_size];
+            this->allocate(this->_size);
         }
 
         if (this->_data != nullptr) {
@@ -256,13 +289,50 @@ visus::power_overwhelming::blob& visus::power_overwhelming::blob::operator =(
 visus::power_overwhelming::blob& visus::power_overwhelming::blob::operator =(
         _Inout_ blob&& rhs) noexcept {
     if (this != std::addressof(rhs)) {
-        this->_data = rhs._data;
-        rhs._data = nullptr;
+        this->release();
+
+        if (rhs._data == rhs._inline) {
+            ::memcpy(this->_inline, rhs._inline, rhs._size);
+            this->_data = this->_inline;
+        } else {
+            this->_data = rhs._data;
+        }
+
+        this->_capacity = rhs._capacity;
         this->_size = rhs._size;
+        rhs._data = nullptr;
+        rhs._capacity = 0;
         rhs._size = 0;
     }
 
     assert(rhs._data == nullptr);
     assert(rhs._size == 0);
     return *this;
-}
\ No newline at end of file
+}
+
+
+/*
+ * visus::power_overwhelming::blob::allocate
+ */
+void visus::power_overwhelming::blob::allocate(_In_ const std::size_t size) {
+    if (size <= inline_capacity) {
+        this->_data = this->_inline;
+        this->_capacity = inline_capacity;
+    } else {
+        this->_data = static_cast<byte_type *>(
+            detail::blob_pool::allocate(size, this->_capacity));
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::blob::release
+ */
+void visus::power_overwhelming::blob::release(void) noexcept {
+    if (this->_data != this->_inline) {
+        detail::blob_pool::deallocate(this->_data, this->_capacity);
+    }
+
+    this->_data = nullptr;
+    this->_capacity = 0;
+}
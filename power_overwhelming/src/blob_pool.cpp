@@ -0,0 +1,218 @@
+﻿// <copyright file="blob_pool.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "blob_pool.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif /* defined(_WIN32) */
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The number of size classes from
+    /// <see cref="blob_pool::min_class_size" /> to
+    /// <see cref="blob_pool::max_class_size" />.
+    /// </summary>
+    static constexpr std::size_t blob_pool_classes = 14;
+
+    static_assert((blob_pool::min_class_size << (blob_pool_classes - 1))
+        == blob_pool::max_class_size, "The number of size classes matches "
+        "the range of class sizes.");
+
+    /// <summary>
+    /// Allocates a block of <paramref name="size" /> bytes with the alignment
+    /// of the pool from the heap.
+    /// </summary>
+    static void *aligned_allocate(_In_ const std::size_t size) {
+#if defined(_WIN32)
+        auto retval = ::_aligned_malloc(size, blob_pool::alignment);
+        if (retval == nullptr) {
+            throw std::bad_alloc();
+        }
+#else /* defined(_WIN32) */
+        void *retval = nullptr;
+        if (::posix_memalign(&retval, blob_pool::alignment, size) != 0) {
+            throw std::bad_alloc();
+        }
+#endif /* defined(_WIN32) */
+
+        return retval;
+    }
+
+    /// <summary>
+    /// Returns a block from <see cref="aligned_allocate" /> to the heap.
+    /// </summary>
+    static void aligned_free(_In_opt_ void *block) noexcept {
+#if defined(_WIN32)
+        ::_aligned_free(block);
+#else /* defined(_WIN32) */
+        ::free(block);
+#endif /* defined(_WIN32) */
+    }
+
+    /// <summary>
+    /// Answer the index of the size class of a block with the given capacity.
+    /// </summary>
+    static std::size_t blob_pool_class(_In_ std::size_t capacity) noexcept {
+        assert(capacity >= blob_pool::min_class_size);
+        assert(capacity <= blob_pool::max_class_size);
+        std::size_t retval = 0;
+
+        while (capacity > blob_pool::min_class_size) {
+            capacity >>= 1;
+            ++retval;
+        }
+
+        return retval;
+    }
+
+    /// <summary>
+    /// Indicates whether the cache of the calling thread has already been
+    /// destroyed, in which case blocks are returned to the heap.
+    /// </summary>
+    /// <remarks>
+    /// This flag is trivially destructible and therefore remains valid while
+    /// the other thread-local objects are being destroyed.
+    /// </remarks>
+    static thread_local bool blob_pool_cache_destroyed = false;
+
+    /// <summary>
+    /// The free blocks of a thread.
+    /// </summary>
+    struct blob_pool_cache final {
+        void *blocks[blob_pool_classes][blob_pool::max_cached];
+        std::size_t counts[blob_pool_classes];
+
+        inline blob_pool_cache(void) : counts() { }
+
+        ~blob_pool_cache(void) {
+            blob_pool_cache_destroyed = true;
+
+            for (std::size_t c = 0; c < blob_pool_classes; ++c) {
+                for (std::size_t i = 0; i < this->counts[c]; ++i) {
+                    aligned_free(this->blocks[c][i]);
+                }
+            }
+        }
+    };
+
+    /// <summary>
+    /// Answer the cache of the calling thread, or <c>nullptr</c> if it has
+    /// already been destroyed.
+    /// </summary>
+    static blob_pool_cache *get_blob_pool_cache(void) noexcept {
+        if (blob_pool_cache_destroyed) {
+            return nullptr;
+        }
+
+        thread_local blob_pool_cache cache;
+        return &cache;
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::blob_pool::alignment
+ */
+constexpr std::size_t visus::power_overwhelming::detail::blob_pool::alignment;
+
+
+/*
+ * visus::power_overwhelming::detail::blob_pool::max_cached
+ */
+constexpr std::size_t visus::power_overwhelming::detail::blob_pool::max_cached;
+
+
+/*
+ * visus::power_overwhelming::detail::blob_pool::max_class_size
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::blob_pool::max_class_size;
+
+
+/*
+ * visus::power_overwhelming::detail::blob_pool::min_class_size
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::blob_pool::min_class_size;
+
+
+/*
+ * visus::power_overwhelming::detail::blob_pool::allocate
+ */
+_Ret_valid_ void *visus::power_overwhelming::detail::blob_pool::allocate(
+        _In_ const std::size_t size,
+        _Out_ std::size_t& capacity) {
+    assert(size > 0);
+    capacity = blob_pool::capacity(size);
+
+    if (capacity <= max_class_size) {
+        auto cache = get_blob_pool_cache();
+        if (cache != nullptr) {
+            const auto c = blob_pool_class(capacity);
+            if (cache->counts[c] > 0) {
+                return cache->blocks[c][--cache->counts[c]];
+            }
+        }
+    }
+
+    return aligned_allocate(capacity);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::blob_pool::capacity
+ */
+std::size_t visus::power_overwhelming::detail::blob_pool::capacity(
+        _In_ const std::size_t size) noexcept {
+    if (size > max_class_size) {
+        // Large blocks are rounded to the alignment only, because we expect
+        // them to be created rarely and do not cache them.
+        return (size + alignment - 1) & ~(alignment - 1);
+    }
+
+    auto retval = min_class_size;
+    while (retval < size) {
+        retval <<= 1;
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::blob_pool::deallocate
+ */
+void visus::power_overwhelming::detail::blob_pool::deallocate(
+        _In_opt_ void *block,
+        _In_ const std::size_t capacity) noexcept {
+    if (block == nullptr) {
+        return;
+    }
+
+    if (capacity <= max_class_size) {
+        auto cache = get_blob_pool_cache();
+        if (cache != nullptr) {
+            const auto c = blob_pool_class(capacity);
+            if (cache->counts[c] < max_cached) {
+                cache->blocks[c][cache->counts[c]++] = block;
+                return;
+            }
+        }
+    }
+
+    aligned_free(block);
+}
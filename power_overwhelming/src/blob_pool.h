@@ -0,0 +1,92 @@
+﻿// <copyright file="blob_pool.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstddef>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Provides aligned memory for the heap-allocated storage of
+    /// <see cref="blob" />s.
+    /// </summary>
+    /// <remarks>
+    /// <para>Requests up to <see cref="max_class_size" /> bytes are rounded up
+    /// to the next power of two and served from a thread-local cache of free
+    /// blocks of this size class, such that blobs that are repeatedly created
+    /// for instrument responses of similar size do not hit the heap. Larger
+    /// requests are allocated directly.</para>
+    /// <para>All blocks are aligned to <see cref="alignment" /> bytes, which
+    /// is suitable for SIMD processing of waveforms. Blocks may be returned
+    /// on a different thread than the one they were obtained on.</para>
+    /// </remarks>
+    class blob_pool final {
+
+    public:
+
+        /// <summary>
+        /// The alignment of all blocks in bytes.
+        /// </summary>
+        static constexpr std::size_t alignment = 64;
+
+        /// <summary>
+        /// The maximum number of free blocks that are cached per size class
+        /// and thread.
+        /// </summary>
+        static constexpr std::size_t max_cached = 8;
+
+        /// <summary>
+        /// The size of the largest size class in bytes.
+        /// </summary>
+        static constexpr std::size_t max_class_size = 1 << 20;
+
+        /// <summary>
+        /// The size of the smallest size class in bytes.
+        /// </summary>
+        static constexpr std::size_t min_class_size = 128;
+
+        /// <summary>
+        /// Allocates a block of at least <paramref name="size" /> bytes.
+        /// </summary>
+        /// <param name="size">The requested size in bytes, which must not be
+        /// zero.</param>
+        /// <param name="capacity">Receives the actual size of the block, which
+        /// must be passed to <see cref="deallocate" />.</param>
+        /// <returns>The aligned block.</returns>
+        /// <exception cref="std::bad_alloc">If the memory could not be
+        /// allocated.</exception>
+        static _Ret_valid_ void *allocate(_In_ const std::size_t size,
+            _Out_ std::size_t& capacity);
+
+        /// <summary>
+        /// Answer the capacity of the block that <see cref="allocate" />
+        /// returns for the given size.
+        /// </summary>
+        /// <param name="size">The requested size in bytes.</param>
+        /// <returns>The actual size of the block in bytes.</returns>
+        static std::size_t capacity(_In_ const std::size_t size) noexcept;
+
+        /// <summary>
+        /// Returns a block obtained from <see cref="allocate" />.
+        /// </summary>
+        /// <param name="block">The block to be returned. It is safe to pass
+        /// <c>nullptr</c>.</param>
+        /// <param name="capacity">The capacity returned by
+        /// <see cref="allocate" /> along with the block.</param>
+        static void deallocate(_In_opt_ void *block,
+            _In_ const std::size_t capacity) noexcept;
+
+        blob_pool(void) = delete;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
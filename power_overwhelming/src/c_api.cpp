@@ -0,0 +1,386 @@
+﻿// <copyright file="c_api.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/c_api.h"
+
+#include <algorithm>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+
+#include "c_api_impl.h"
+#include "string_functions.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The description of the last error on the calling thread.
+    /// </summary>
+    static thread_local std::string c_api_error;
+
+    /// <summary>
+    /// Invokes <paramref name="func" /> and translates any exception into a
+    /// status code, because exceptions must not cross the C API.
+    /// </summary>
+    template<class TFunc>
+    static pwrowg_status c_api_call(TFunc&& func) noexcept {
+        try {
+            c_api_error.clear();
+            return func();
+
+        } catch (std::bad_alloc& ex) {
+            c_api_error = ex.what();
+            return PWROWG_OUT_OF_MEMORY;
+        } catch (std::invalid_argument& ex) {
+            c_api_error = ex.what();
+            return PWROWG_INVALID_ARGUMENT;
+        } catch (std::logic_error& ex) {
+            c_api_error = ex.what();
+            return PWROWG_INVALID_STATE;
+        } catch (std::system_error& ex) {
+            c_api_error = ex.what();
+            return PWROWG_SYSTEM_ERROR;
+        } catch (std::exception& ex) {
+            c_api_error = ex.what();
+            return PWROWG_ERROR;
+        } catch (...) {
+            c_api_error = "An unknown error occurred.";
+            return PWROWG_ERROR;
+        }
+    }
+
+    /// <summary>
+    /// Decodes a UTF-8 string from the C API.
+    /// </summary>
+    static std::wstring c_api_string(_In_z_ const char *str) {
+        std::wstring retval;
+        append_from_utf8(retval, str);
+        return retval;
+    }
+
+    /// <summary>
+    /// Replaces the invalid marker of the library with NaN, which bindings
+    /// understand without knowing the library.
+    /// </summary>
+    static inline float c_api_value(
+            _In_ const measurement_data::value_type value) noexcept {
+        return (value == measurement_data::invalid_value)
+            ? std::numeric_limits<float>::quiet_NaN()
+            : static_cast<float>(value);
+    }
+
+    /// <summary>
+    /// Throws if a required parameter is <c>nullptr</c>.
+    /// </summary>
+    template<class TType>
+    static inline void c_api_require(_In_opt_ TType *value,
+            _In_z_ const char *name) {
+        if (value == nullptr) {
+            throw std::invalid_argument(std::string("The parameter \"")
+                + name + "\" must not be NULL.");
+        }
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * ::pwrowg_api_version
+ */
+uint32_t pwrowg_api_version(void) {
+    return PWROWG_API_VERSION;
+}
+
+
+/*
+ * ::pwrowg_last_error
+ */
+_Ret_z_ const char *pwrowg_last_error(void) {
+    return visus::power_overwhelming::detail::c_api_error.c_str();
+}
+
+
+/*
+ * ::pwrowg_collector_close
+ */
+void pwrowg_collector_close(_In_opt_ pwrowg_collector *collector) {
+    // The destructor of the collector stops it, but must not throw anyway.
+    delete collector;
+}
+
+
+/*
+ * ::pwrowg_collector_for_all
+ */
+pwrowg_status pwrowg_collector_for_all(_In_z_ const char *output_path,
+        _In_ const uint32_t sampling_interval,
+        _Out_ pwrowg_collector **collector) {
+    using namespace visus::power_overwhelming;
+    using namespace visus::power_overwhelming::detail;
+    return c_api_call([&](void) {
+        c_api_require(collector, "collector");
+        *collector = nullptr;
+        c_api_require(output_path, "output_path");
+
+        const auto path = c_api_string(output_path);
+        std::unique_ptr<pwrowg_collector> retval(new pwrowg_collector {
+            collector::for_all(path.c_str(), sampling_interval)
+        });
+        *collector = retval.release();
+        return PWROWG_SUCCESS;
+    });
+}
+
+
+/*
+ * ::pwrowg_collector_from_json
+ */
+pwrowg_status pwrowg_collector_from_json(_In_z_ const char *path,
+        _Out_ pwrowg_collector **collector) {
+    using namespace visus::power_overwhelming;
+    using namespace visus::power_overwhelming::detail;
+    return c_api_call([&](void) {
+        c_api_require(collector, "collector");
+        *collector = nullptr;
+        c_api_require(path, "path");
+
+        const auto p = c_api_string(path);
+        std::unique_ptr<pwrowg_collector> retval(new pwrowg_collector {
+            collector::from_json(p.c_str())
+        });
+        *collector = retval.release();
+        return PWROWG_SUCCESS;
+    });
+}
+
+
+/*
+ * ::pwrowg_collector_marker
+ */
+pwrowg_status pwrowg_collector_marker(_In_ pwrowg_collector *collector,
+        _In_opt_z_ const char *marker) {
+    using namespace visus::power_overwhelming::detail;
+    return c_api_call([&](void) {
+        c_api_require(collector, "collector");
+
+        if (marker != nullptr) {
+            const auto m = c_api_string(marker);
+            collector->collector.marker(m.c_str());
+        } else {
+            collector->collector.marker(nullptr);
+        }
+
+        return PWROWG_SUCCESS;
+    });
+}
+
+
+/*
+ * ::pwrowg_collector_start
+ */
+pwrowg_status pwrowg_collector_start(_In_ pwrowg_collector *collector) {
+    using namespace visus::power_overwhelming::detail;
+    return c_api_call([&](void) {
+        c_api_require(collector, "collector");
+        collector->collector.start();
+        return PWROWG_SUCCESS;
+    });
+}
+
+
+/*
+ * ::pwrowg_collector_stop
+ */
+pwrowg_status pwrowg_collector_stop(_In_ pwrowg_collector *collector) {
+    using namespace visus::power_overwhelming::detail;
+    return c_api_call([&](void) {
+        c_api_require(collector, "collector");
+        collector->collector.stop();
+        return PWROWG_SUCCESS;
+    });
+}
+
+
+/*
+ * ::pwrowg_collector_subscribe
+ */
+pwrowg_status pwrowg_collector_subscribe(_In_ pwrowg_collector *collector,
+        _In_ const int skip_to_latest,
+        _Out_ pwrowg_subscriber **subscriber) {
+    using namespace visus::power_overwhelming;
+    using namespace visus::power_overwhelming::detail;
+    return c_api_call([&](void) {
+        c_api_require(subscriber, "subscriber");
+        *subscriber = nullptr;
+        c_api_require(collector, "collector");
+
+        const auto overflow = (skip_to_latest != 0)
+            ? subscriber_overflow::skip_to_latest
+            : subscriber_overflow::drop_oldest;
+        std::unique_ptr<pwrowg_subscriber> retval(new pwrowg_subscriber());
+        retval->subscriber = collector->collector.subscribe(overflow);
+        *subscriber = retval.release();
+        return PWROWG_SUCCESS;
+    });
+}
+
+
+/*
+ * ::pwrowg_subscriber_acquire
+ */
+pwrowg_status pwrowg_subscriber_acquire(_In_ pwrowg_subscriber *subscriber,
+        _In_ const size_t capacity,
+        _In_ const uint32_t timeout,
+        _Out_ pwrowg_batch *batch) {
+    using namespace visus::power_overwhelming;
+    using namespace visus::power_overwhelming::detail;
+    return c_api_call([&](void) {
+        c_api_require(batch, "batch");
+        *batch = pwrowg_batch { };
+        c_api_require(subscriber, "subscriber");
+
+        auto& s = subscriber->subscriber;
+        if ((s.available() == 0) && !s.wait(timeout)) {
+            return PWROWG_TIMEOUT;
+        }
+
+        // The ring holds complete samples, so we read them in one go and
+        // transpose them into the pooled buffer, which is the only copy made
+        // until the binding releases the batch.
+        auto cnt = static_cast<std::size_t>(s.available());
+        if ((capacity > 0) && (capacity < cnt)) {
+            cnt = capacity;
+        }
+        subscriber->samples.resize(cnt, measurement_data(0, 0.0f));
+        subscriber->sensors.resize(cnt);
+        cnt = s.read(subscriber->samples.data(), subscriber->sensors.data(),
+            cnt);
+        if (cnt == 0) {
+            // Another policy might have skipped the samples in the meantime.
+            return PWROWG_TIMEOUT;
+        }
+
+        if (subscriber->free_buffers.empty()) {
+            subscriber->buffers.emplace_back(
+                new pwrowg_subscriber::buffer_type());
+            subscriber->free_buffers.push_back(
+                subscriber->buffers.back().get());
+        }
+
+        auto buffer = subscriber->free_buffers.back();
+        buffer->current.resize(cnt);
+        buffer->power.resize(cnt);
+        buffer->sensors.resize(cnt);
+        buffer->timestamps.resize(cnt);
+        buffer->voltage.resize(cnt);
+
+        for (std::size_t i = 0; i < cnt; ++i) {
+            auto& d = subscriber->samples[i];
+            const auto name = subscriber->sensors[i];
+
+            auto it = subscriber->indices.find(name);
+            if (it == subscriber->indices.end()) {
+                std::string utf8;
+                append_utf8(utf8, name);
+                subscriber->names.push_back(std::move(utf8));
+                it = subscriber->indices.emplace(name, static_cast<
+                    std::uint32_t>(subscriber->names.size() - 1)).first;
+            }
+
+            buffer->current[i] = c_api_value(d.current());
+            buffer->power[i] = c_api_value(d.power());
+            buffer->sensors[i] = it->second;
+            buffer->timestamps[i] = d.timestamp();
+            buffer->voltage[i] = c_api_value(d.voltage());
+        }
+
+        // Only hand out the buffer once nothing can fail anymore.
+        subscriber->free_buffers.pop_back();
+        batch->count = cnt;
+        batch->current = buffer->current.data();
+        batch->power = buffer->power.data();
+        batch->sensors = buffer->sensors.data();
+        batch->timestamps = buffer->timestamps.data();
+        batch->voltage = buffer->voltage.data();
+        batch->reserved = buffer;
+        return PWROWG_SUCCESS;
+    });
+}
+
+
+/*
+ * ::pwrowg_subscriber_close
+ */
+void pwrowg_subscriber_close(_In_opt_ pwrowg_subscriber *subscriber) {
+    delete subscriber;
+}
+
+
+/*
+ * ::pwrowg_subscriber_lost
+ */
+uint64_t pwrowg_subscriber_lost(
+        _In_opt_ const pwrowg_subscriber *subscriber) {
+    return (subscriber != nullptr) ? subscriber->subscriber.lost() : 0;
+}
+
+
+/*
+ * ::pwrowg_subscriber_release
+ */
+pwrowg_status pwrowg_subscriber_release(_In_ pwrowg_subscriber *subscriber,
+        _Inout_ pwrowg_batch *batch) {
+    using namespace visus::power_overwhelming::detail;
+    return c_api_call([&](void) {
+        c_api_require(subscriber, "subscriber");
+        c_api_require(batch, "batch");
+
+        if (batch->reserved == nullptr) {
+            return PWROWG_SUCCESS;
+        }
+
+        // Make sure that the batch has been handed out by this subscriber and
+        // has not yet been released, because a buffer in the pool twice would
+        // be handed out to two batches.
+        auto buffer = static_cast<pwrowg_subscriber::buffer_type *>(
+            batch->reserved);
+        auto& buffers = subscriber->buffers;
+        auto& free_buffers = subscriber->free_buffers;
+        const auto owned = std::any_of(buffers.begin(), buffers.end(),
+            [buffer](const std::unique_ptr<pwrowg_subscriber::buffer_type>& b) {
+                return (b.get() == buffer);
+            });
+        const auto released = std::find(free_buffers.begin(),
+            free_buffers.end(), buffer) != free_buffers.end();
+        if (!owned || released) {
+            throw std::invalid_argument("The batch has not been acquired from "
+                "this subscriber or has already been released.");
+        }
+
+        free_buffers.push_back(buffer);
+        *batch = pwrowg_batch { };
+        return PWROWG_SUCCESS;
+    });
+}
+
+
+/*
+ * ::pwrowg_subscriber_sensor
+ */
+_Ret_maybenull_z_ const char *pwrowg_subscriber_sensor(
+        _In_ const pwrowg_subscriber *subscriber,
+        _In_ const uint32_t index) {
+    if ((subscriber == nullptr) || (index >= subscriber->names.size())) {
+        return nullptr;
+    }
+
+    return subscriber->names[index].c_str();
+}
@@ -0,0 +1,83 @@
+﻿// <copyright file="c_api_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "power_overwhelming/c_api.h"
+#include "power_overwhelming/collector.h"
+#include "power_overwhelming/collector_subscriber.h"
+
+
+/// <summary>
+/// The state behind the <see cref="pwrowg_collector" /> handle of the C API.
+/// </summary>
+struct pwrowg_collector final {
+
+    /// <summary>
+    /// The collector being wrapped.
+    /// </summary>
+    visus::power_overwhelming::collector collector;
+};
+
+
+/// <summary>
+/// The state behind the <see cref="pwrowg_subscriber" /> handle of the C API.
+/// </summary>
+struct pwrowg_subscriber final {
+
+    /// <summary>
+    /// The memory behind the arrays of a <see cref="pwrowg_batch" />.
+    /// </summary>
+    struct buffer_type {
+        std::vector<float> current;
+        std::vector<float> power;
+        std::vector<std::uint32_t> sensors;
+        std::vector<std::int64_t> timestamps;
+        std::vector<float> voltage;
+    };
+
+    /// <summary>
+    /// All buffers that have been allocated, including the ones that are
+    /// currently borrowed by a batch.
+    /// </summary>
+    std::vector<std::unique_ptr<buffer_type>> buffers;
+
+    /// <summary>
+    /// The buffers that are not currently borrowed.
+    /// </summary>
+    std::vector<buffer_type *> free_buffers;
+
+    /// <summary>
+    /// Maps the interned names of the sensors to their index in
+    /// <see cref="names" />.
+    /// </summary>
+    std::unordered_map<const wchar_t *, std::uint32_t> indices;
+
+    /// <summary>
+    /// The UTF-8 names of the sensors that have been referenced by a batch.
+    /// </summary>
+    std::vector<std::string> names;
+
+    /// <summary>
+    /// The samples read from the <see cref="subscriber" /> before they are
+    /// transposed into a buffer.
+    /// </summary>
+    std::vector<visus::power_overwhelming::measurement_data> samples;
+
+    /// <summary>
+    /// The interned names of the sensors of <see cref="samples" />.
+    /// </summary>
+    std::vector<const wchar_t *> sensors;
+
+    /// <summary>
+    /// The subscriber being wrapped.
+    /// </summary>
+    visus::power_overwhelming::collector_subscriber subscriber;
+};
@@ -0,0 +1,126 @@
+﻿// <copyright file="cached_discovery.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <cinttypes>
+#include <mutex>
+#include <vector>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Tracks the validity of all cached results of the sensor discovery in
+    /// the process.
+    /// </summary>
+    /// <remarks>
+    /// <para>The catalogue does not store any devices itself, but maintains a
+    /// generation counter that is incremented whenever the cached results of
+    /// the <see cref="cached_discovery" /> instances of the individual sensor
+    /// types become stale. This happens if the user explicitly requests a
+    /// refresh or, on Windows, if a device interface arrives or is removed.
+    /// </para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API device_catalogue final {
+
+    public:
+
+        /// <summary>
+        /// The type of the generation counter.
+        /// </summary>
+        typedef std::uint64_t generation_type;
+
+        /// <summary>
+        /// Answer the current generation of the catalogue.
+        /// </summary>
+        /// <remarks>
+        /// Calling this method makes sure that the catalogue is subscribed to
+        /// PnP notifications on Windows.
+        /// </remarks>
+        /// <returns>The current generation.</returns>
+        static generation_type generation(void);
+
+        /// <summary>
+        /// Marks all cached discovery results as stale such that the devices
+        /// are enumerated again on the next request.
+        /// </summary>
+        static void invalidate(void) noexcept;
+
+        device_catalogue(void) = delete;
+
+    private:
+
+        static std::atomic<generation_type> _generation;
+        static std::once_flag _watch;
+    };
+
+
+    /// <summary>
+    /// Caches the result of a potentially expensive enumeration of devices
+    /// until the <see cref="device_catalogue" /> is invalidated.
+    /// </summary>
+    /// <remarks>
+    /// <para>The cache is thread-safe.</para>
+    /// </remarks>
+    /// <typeparam name="TValue">The type of the values describing the devices
+    /// found by the enumeration.</typeparam>
+    template<class TValue> class cached_discovery final {
+
+    public:
+
+        /// <summary>
+        /// The type of the values describing the devices.
+        /// </summary>
+        typedef TValue value_type;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        inline cached_discovery(void) : _generation(0), _valid(false) { }
+
+        cached_discovery(const cached_discovery&) = delete;
+
+        /// <summary>
+        /// Gets the cached enumeration results or enumerates the devices if
+        /// there are no valid results.
+        /// </summary>
+        /// <typeparam name="TEnumerator">A functor that returns a
+        /// <c>std::vector</c> of <typeparamref name="TValue" /> describing all
+        /// of the devices.</typeparam>
+        /// <param name="enumerate">The enumerator that is invoked if the cached
+        /// results are not valid.</param>
+        /// <returns>A copy of the enumeration results.</returns>
+        /// <exception cref="std::exception">Any exception thrown by
+        /// <paramref name="enumerate" />, in which case nothing is cached.
+        /// </exception>
+        template<class TEnumerator>
+        std::vector<value_type> get(TEnumerator enumerate);
+
+        /// <summary>
+        /// Discards the cached results of this discovery.
+        /// </summary>
+        void invalidate(void);
+
+        cached_discovery& operator =(const cached_discovery&) = delete;
+
+    private:
+
+        device_catalogue::generation_type _generation;
+        std::mutex _lock;
+        bool _valid;
+        std::vector<value_type> _values;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+#include "cached_discovery.inl"
@@ -0,0 +1,41 @@
+﻿// <copyright file="cached_discovery.inl" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+
+/*
+ * visus::power_overwhelming::detail::cached_discovery<TValue>::get
+ */
+template<class TValue>
+template<class TEnumerator>
+std::vector<typename visus::power_overwhelming::detail::cached_discovery<
+    TValue>::value_type>
+visus::power_overwhelming::detail::cached_discovery<TValue>::get(
+        TEnumerator enumerate) {
+    // Retrieve the generation before enumerating such that a PnP event that
+    // happens while enumerating causes the next request to enumerate again.
+    const auto generation = device_catalogue::generation();
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+
+    if (!this->_valid || (this->_generation != generation)) {
+        this->_valid = false;
+        this->_values = enumerate();
+        this->_generation = generation;
+        this->_valid = true;
+    }
+
+    return this->_values;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::cached_discovery<TValue>::invalidate
+ */
+template<class TValue>
+void visus::power_overwhelming::detail::cached_discovery<TValue>::invalidate(
+        void) {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    this->_valid = false;
+    this->_values.clear();
+}
@@ -0,0 +1,86 @@
+﻿// <copyright file="clock_settle_detector.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "clock_settle_detector.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+
+/*
+ * visus::power_overwhelming::detail::clock_settle_detector::clock_settle_detector
+ */
+visus::power_overwhelming::detail::clock_settle_detector::clock_settle_detector(
+        _In_ const std::size_t window, _In_ const float tolerance)
+        : _tolerance(tolerance), _window(window) {
+    if (window == 0) {
+        throw std::invalid_argument("The window for detecting settled clocks "
+            "must comprise at least one reading.");
+    }
+    if (!(tolerance >= 0.0f)) {
+        throw std::invalid_argument("The tolerance for detecting settled "
+            "clocks must not be negative.");
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::clock_settle_detector::push
+ */
+bool visus::power_overwhelming::detail::clock_settle_detector::push(
+        _In_reads_(cnt) const clock_type *clocks,
+        _In_ const std::size_t cnt) {
+    assert((clocks != nullptr) || (cnt == 0));
+
+    if (this->_history.size() != cnt) {
+        this->_history.clear();
+        this->_history.resize(cnt);
+    }
+
+    for (std::size_t i = 0; i < cnt; ++i) {
+        auto& h = this->_history[i];
+        h.push_back(clocks[i]);
+        while (h.size() > this->_window) {
+            h.pop_front();
+        }
+    }
+
+    return this->settled();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::clock_settle_detector::reset
+ */
+void visus::power_overwhelming::detail::clock_settle_detector::reset(
+        void) noexcept {
+    this->_history.clear();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::clock_settle_detector::settled
+ */
+bool visus::power_overwhelming::detail::clock_settle_detector::settled(
+        void) const noexcept {
+    if (this->_history.empty()) {
+        return false;
+    }
+
+    for (auto& h : this->_history) {
+        if (h.size() < this->_window) {
+            return false;
+        }
+
+        const auto range = std::minmax_element(h.begin(), h.end());
+        const auto delta = static_cast<float>(*range.second - *range.first);
+        if (delta > this->_tolerance * static_cast<float>(*range.second)) {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,101 @@
+﻿// <copyright file="clock_settle_detector.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <deque>
+#include <vector>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Decides from a series of clock readings of one or more GPUs whether
+    /// the clocks have settled.
+    /// </summary>
+    /// <remarks>
+    /// The clocks are considered settled if the last <see cref="window" />
+    /// readings of each GPU vary by at most <see cref="tolerance" /> relative
+    /// to the highest of them. The detector must be fed with readings of the
+    /// same GPUs in the same order; if the number of GPUs changes, the history
+    /// is discarded.
+    /// </remarks>
+    class POWER_OVERWHELMING_API clock_settle_detector final {
+
+    public:
+
+        /// <summary>
+        /// The type of a clock reading, which is typically in MHz.
+        /// </summary>
+        typedef std::uint32_t clock_type;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="window">The number of consecutive readings that must
+        /// be within the tolerance.</param>
+        /// <param name="tolerance">The maximum variation of the readings in
+        /// the window relative to the highest reading.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="window" /> is zero or if
+        /// <paramref name="tolerance" /> is negative.</exception>
+        clock_settle_detector(_In_ const std::size_t window,
+            _In_ const float tolerance);
+
+        /// <summary>
+        /// Adds a reading for each GPU.
+        /// </summary>
+        /// <param name="clocks">The current clocks of all GPUs.</param>
+        /// <param name="cnt">The number of elements in
+        /// <paramref name="clocks" />.</param>
+        /// <returns>The result of <see cref="settled" /> after the readings
+        /// have been added.</returns>
+        bool push(_In_reads_(cnt) const clock_type *clocks,
+            _In_ const std::size_t cnt);
+
+        /// <summary>
+        /// Discards all readings.
+        /// </summary>
+        void reset(void) noexcept;
+
+        /// <summary>
+        /// Answer whether the clocks of all GPUs have settled.
+        /// </summary>
+        /// <returns><c>true</c> if readings of at least one GPU have been
+        /// added and the window of each GPU is full and within the tolerance,
+        /// <c>false</c> otherwise.</returns>
+        bool settled(void) const noexcept;
+
+        /// <summary>
+        /// Answer the relative tolerance for the readings in the window.
+        /// </summary>
+        /// <returns>The tolerance.</returns>
+        inline float tolerance(void) const noexcept {
+            return this->_tolerance;
+        }
+
+        /// <summary>
+        /// Answer the number of readings that must be within the tolerance.
+        /// </summary>
+        /// <returns>The size of the window.</returns>
+        inline std::size_t window(void) const noexcept {
+            return this->_window;
+        }
+
+    private:
+
+        std::vector<std::deque<clock_type>> _history;
+        float _tolerance;
+        std::size_t _window;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -5,16 +5,24 @@
 
 #include "power_overwhelming/collector.h"
 
+#include <fstream>
 #include <memory>
 #include <stdexcept>
+#include <thread>
 #include <vector>
 
 #include <nlohmann/json.hpp>
 
 #include "power_overwhelming/computer_name.h"
 #include "power_overwhelming/convert_string.h"
+#include "power_overwhelming/tinkerforge_sensor.h"
 
+#include "collector_discovery_impl.h"
 #include "collector_impl.h"
+#include "collector_subscriber_impl.h"
+#include "compiled_config.h"
+#include "frame_marker_impl.h"
+#include "library_thread.h"
 #include "sensor_desc.h"
 #include "sensor_utilities.h"
 #include "tinkerforge_sensor_impl.h"
@@ -24,32 +32,660 @@ namespace visus {
 namespace power_overwhelming {
 namespace detail {
 
+    static constexpr const char *field_aggregate_only = "aggregateOnly";
+    static constexpr const char *field_aggregation_window
+        = "aggregationWindow";
+    static constexpr const char *field_align_timestamps = "alignTimestamps";
+    static constexpr const char *field_buffer_size = "bufferSize";
+    static constexpr const char *field_capability_report
+        = "capabilityReport";
+    static constexpr const char *field_compress = "compressOutput";
+    static constexpr const char *field_compress_waveforms
+        = "compressWaveforms";
     static constexpr const char *field_computer_name = "machine";
+    static constexpr const char *field_correction_profile
+        = "correctionProfile";
+    static constexpr const char *field_delta_thresholds = "deltaThresholds";
+    static constexpr const char *field_derived_sensors = "derivedSensors";
+    static constexpr const char *field_derived_expression = "expression";
+    static constexpr const char *field_derived_name = "name";
+    static constexpr const char *field_estimate_power = "estimatePower";
+    static constexpr const char *field_filter_alpha = "alpha";
+    static constexpr const char *field_filter_cutoff = "cutoff";
+    static constexpr const char *field_filter_type = "type";
+    static constexpr const char *field_filter_window = "window";
+    static constexpr const char *field_filters = "filters";
+    static constexpr const char *field_format = "outputFormat";
+    static constexpr const char *field_integrate_energy = "integrateEnergy";
+    static constexpr const char *field_integrate_instruments
+        = "integrateInstruments";
+    static constexpr const char *field_keep_alive = "keepAliveInterval";
+    static constexpr const char *field_kernel_energy = "kernelEnergy";
+    static constexpr const char *field_limit_native
+        = "limitToNativeInterval";
+    static constexpr const char *field_lock_memory = "lockMemory";
+    static constexpr const char *field_manual_pump = "manualPump";
+    static constexpr const char *field_marker_channel = "markerChannel";
+    static constexpr const char *field_merge_logs = "mergeInstrumentLogs";
+    static constexpr const char *field_min_sampling = "minSamplingInterval";
     static constexpr const char *field_output = "outputPath";
+    static constexpr const char *field_overhead_interval = "overheadInterval";
+    static constexpr const char *field_overhead_report = "overheadReport";
+    static constexpr const char *field_overhead_window = "overheadWindow";
+    static constexpr const char *field_post_trigger = "postTrigger";
+    static constexpr const char *field_pre_trigger = "preTrigger";
+    static constexpr const char *field_process_energy = "processEnergy";
+    static constexpr const char *field_record_overhead = "recordOverhead";
     static constexpr const char *field_require_marker = "collectRequiresMarker";
+    static constexpr const char *field_resampling = "resamplingInterval";
+    static constexpr const char *field_retain_unfiltered = "retainUnfiltered";
+    static constexpr const char *field_rotate_interval = "rotateInterval";
+    static constexpr const char *field_rotate_size = "rotateSize";
     static constexpr const char *field_sampling = "samplingInterval";
+    static constexpr const char *field_sampling_cpu_budget
+        = "samplingCpuBudget";
+    static constexpr const char *field_sampling_read_budget
+        = "samplingReadBudget";
+    static constexpr const char *field_sensor_intervals = "samplingIntervals";
+    static constexpr const char *field_sensor_delays = "sensorDelays";
+    static constexpr const char *field_sensor_priorities = "sensorPriorities";
+    static constexpr const char *field_sensor_quantities = "sensorQuantities";
     static constexpr const char *field_sensors = "sensors";
+    static constexpr const char *field_shared_memory = "sharedMemory";
+    static constexpr const char *field_subscriber_capacity
+        = "subscriberCapacity";
+    static constexpr const char *field_suppress_duplicates
+        = "suppressDuplicates";
+    static constexpr const char *field_tinkerforge_arrival_times
+        = "tinkerforgeArrivalTimes";
+    static constexpr const char *field_track_quantiles = "trackQuantiles";
+    static constexpr const char *field_track_sequences = "trackSequences";
+    static constexpr const char *field_trigger_oscilloscopes
+        = "triggerOscilloscopes";
+    static constexpr const char *field_trigger_threshold = "triggerThreshold";
+    static constexpr const char *field_waveform_archive = "waveformArchive";
+    static constexpr const char *field_write_latency = "writeLatency";
+    static constexpr const char *field_write_statistics = "writeStatistics";
+    static constexpr const char *field_write_threshold = "writeThreshold";
+    static constexpr const char *field_writer_threads = "writerThreads";
 
     /// <summary>
-    /// Create an in-memory JSON document with the template for configuring the
-    /// sensors on the machine the software is running on.
+    /// Parses the description of a <see cref="sample_filter" /> like
+    /// <c>{ "type": "median", "window": 5 }</c>.
+    /// </summary>
+    static sample_filter parse_filter(const nlohmann::json& cfg) {
+        auto type = cfg.at(field_filter_type).get<std::string>();
+
+        if (type == "median") {
+            return sample_filter::median(
+                cfg.at(field_filter_window).get<std::size_t>());
+        } else if (type == "exponential") {
+            return sample_filter::exponential(
+                cfg.at(field_filter_alpha).get<float>());
+        } else if (type == "low_pass") {
+            return sample_filter::low_pass(
+                cfg.at(field_filter_window).get<std::size_t>(),
+                cfg.at(field_filter_cutoff).get<float>());
+        } else if (type == "none") {
+            return sample_filter();
+        }
+
+        throw std::invalid_argument("The type of a sample filter must be "
+            "\"median\", \"exponential\", \"low_pass\" or \"none\".");
+    }
+
+    /// <summary>
+    /// Create an in-memory JSON document with the default settings of the
+    /// configuration template, but without any sensors.
     /// </summary>
     /// <param name=""></param>
     /// <returns></returns>
-    static nlohmann::json make_json_template(void) {
-        using power_overwhelming::convert_string;
-
+    static nlohmann::json make_json_settings(void) {
         nlohmann::json retval;
 
+        retval[field_aggregate_only] = false;
+        retval[field_aggregation_window] = 0;
+        retval[field_align_timestamps] = false;
+        retval[field_buffer_size] = collector_settings::default_buffer_size;
+        retval[field_capability_report] = "";
+        retval[field_compress] = false;
+        retval[field_compress_waveforms] = false;
         retval[field_computer_name] = computer_name<char>();
+        retval[field_correction_profile] = "";
+        retval[field_delta_thresholds] = nlohmann::json::object();
+        retval[field_derived_sensors] = nlohmann::json::array();
+        retval[field_estimate_power] = false;
+        retval[field_filters] = nlohmann::json::object();
+        retval[field_format] = "csv";
+        retval[field_integrate_energy] = false;
+        retval[field_integrate_instruments] = false;
+        retval[field_keep_alive] = 0;
+        retval[field_kernel_energy] = "";
+        retval[field_limit_native] = false;
+        retval[field_lock_memory] = false;
+        retval[field_manual_pump] = false;
+        retval[field_marker_channel] = "";
+        retval[field_merge_logs] = false;
+        retval[field_min_sampling] = 0;
         retval[field_output] = "output.csv";
+        retval[field_overhead_interval] = 0;
+        retval[field_overhead_report] = "";
+        retval[field_overhead_window] = 0;
+        retval[field_post_trigger] = 0;
+        retval[field_pre_trigger] = 0;
+        retval[field_process_energy] = "";
         retval[field_sampling] = 5000;  // 5000 µs == 5 ms
+        retval[field_sampling_cpu_budget] = 0.0f;
+        retval[field_sampling_read_budget] = 0;
+        retval[field_sensor_delays] = nlohmann::json::object();
+        retval[field_sensor_intervals] = nlohmann::json::object();
+        retval[field_sensor_priorities] = nlohmann::json::object();
+        retval[field_sensor_quantities] = nlohmann::json::object();
+        retval[field_record_overhead] = false;
         retval[field_require_marker] = true;
-        retval[field_sensors] = get_all_sensor_descs();
+        retval[field_resampling] = 0;
+        retval[field_retain_unfiltered] = false;
+        retval[field_rotate_interval] = 0;
+        retval[field_rotate_size] = 0;
+        retval[field_shared_memory] = "";
+        retval[field_subscriber_capacity]
+            = collector_settings::default_subscriber_capacity;
+        retval[field_suppress_duplicates] = false;
+        retval[field_tinkerforge_arrival_times] = false;
+        retval[field_track_quantiles] = false;
+        retval[field_track_sequences] = false;
+        retval[field_trigger_oscilloscopes] = false;
+        retval[field_trigger_threshold] = 0.0f;
+        retval[field_waveform_archive] = "";
+        retval[field_write_latency] = collector_settings::default_write_latency;
+        retval[field_write_statistics] = false;
+        retval[field_write_threshold]
+            = collector_settings::default_write_threshold;
+        retval[field_writer_threads] = 1;
 
         return retval;
     }
 
+    /// <summary>
+    /// Create an in-memory JSON document with the template for configuring the
+    /// sensors on the machine the software is running on.
+    /// </summary>
+    /// <param name=""></param>
+    /// <returns></returns>
+    static nlohmann::json make_json_template(void) {
+        auto retval = make_json_settings();
+        retval[field_sensors] = get_all_sensor_descs();
+        return retval;
+    }
+
+    /// <summary>
+    /// Apply all settings except for the sensors from the given JSON
+    /// configuration to the given collector.
+    /// </summary>
+    /// <param name="dst"></param>
+    /// <param name="cfg"></param>
+    static void apply_settings(collector_impl *dst, const nlohmann::json& cfg) {
+        assert(dst != nullptr);
+
+        // The output format is optional for compatibility with existing
+        // configuration files.
+        auto format = output_format::csv;
+        {
+            auto it = cfg.find(field_format);
+            if (it != cfg.end()) {
+                auto value = it->get<std::string>();
+                if (value == "binary") {
+                    format = output_format::binary;
+                } else if (value == "async_binary") {
+                    format = output_format::async_binary;
+                } else if (value == "direct_binary") {
+                    format = output_format::direct_binary;
+                } else if (value == "mapped_binary") {
+                    format = output_format::mapped_binary;
+                } else if (value == "network_binary") {
+                    format = output_format::network_binary;
+                } else if (value == "perfetto") {
+                    format = output_format::perfetto;
+                } else if (value == "chrome_trace") {
+                    format = output_format::chrome_trace;
+                } else if (value == "arrow") {
+                    format = output_format::arrow;
+                } else if (value == "wide_csv") {
+                    format = output_format::wide_csv;
+                }
+            }
+        }
+
+        const auto output = power_overwhelming::convert_string<wchar_t>(
+            cfg[field_output].get<std::string>());
+        dst->open(output.c_str(), format);
+        dst->sampling_interval = decltype(dst->sampling_interval)(
+            cfg[field_sampling].get<sensor::microseconds_type>());
+
+        // The buffer size is optional for compatibility with existing
+        // configuration files.
+        auto buffer_size = cfg.find(field_buffer_size);
+        if (buffer_size != cfg.end()) {
+            dst->buffer_size = (std::max)(std::size_t(1),
+                buffer_size->get<std::size_t>());
+        }
+
+        // Aggregating the samples is optional, too.
+        auto aggregation_window = cfg.find(field_aggregation_window);
+        if (aggregation_window != cfg.end()) {
+            dst->aggregation_window = decltype(dst->aggregation_window)(
+                aggregation_window->get<sensor::microseconds_type>());
+        }
+
+        auto aggregate_only = cfg.find(field_aggregate_only);
+        if (aggregate_only != cfg.end()) {
+            dst->aggregate_only = aggregate_only->get<bool>();
+        }
+
+        // Aligning and resampling the timestamps is optional, too.
+        auto align_timestamps = cfg.find(field_align_timestamps);
+        if (align_timestamps != cfg.end()) {
+            dst->align_timestamps = align_timestamps->get<bool>();
+        }
+
+        auto resampling = cfg.find(field_resampling);
+        if (resampling != cfg.end()) {
+            dst->resampling_interval = decltype(dst->resampling_interval)(
+                resampling->get<sensor::microseconds_type>());
+        }
+
+        // Compressing binary output is optional, too.
+        auto compress = cfg.find(field_compress);
+        if (compress != cfg.end()) {
+            dst->binary_stream->compressed(compress->get<bool>());
+        }
+
+        // Integrating the energy per phase is optional, too.
+        auto integrate_energy = cfg.find(field_integrate_energy);
+        if (integrate_energy != cfg.end()) {
+            dst->integrate_energy = integrate_energy->get<bool>();
+        }
+
+        // Using the integrators of the instruments is optional, too.
+        auto integrate_instruments = cfg.find(field_integrate_instruments);
+        if (integrate_instruments != cfg.end()) {
+            dst->integrate_instruments = integrate_instruments->get<bool>();
+        }
+
+        // The keep-alive samples of unchanged sensors are optional, too.
+        auto keep_alive = cfg.find(field_keep_alive);
+        if (keep_alive != cfg.end()) {
+            dst->keep_alive_interval = std::chrono::microseconds(
+                keep_alive->get<sensor::microseconds_type>());
+        }
+
+        // Attributing the energy to CUDA kernels is optional, too.
+        auto kernel_energy = cfg.find(field_kernel_energy);
+        if (kernel_energy != cfg.end()) {
+            dst->kernel_energy_path = power_overwhelming::convert_string<
+                wchar_t>(kernel_energy->get<std::string>());
+        }
+
+        // The safe intervals from a capability report are optional, too.
+        auto capability_report = cfg.find(field_capability_report);
+        if (capability_report != cfg.end()) {
+            const auto path = power_overwhelming::convert_string<wchar_t>(
+                capability_report->get<std::string>());
+            dst->load_safe_intervals(path.c_str());
+        }
+
+        // Limiting the sensors to their native rate is optional, too.
+        auto limit_native = cfg.find(field_limit_native);
+        if (limit_native != cfg.end()) {
+            dst->limit_to_native_interval = limit_native->get<bool>();
+        }
+
+        // Locking the buffers into memory is optional, too.
+        auto lock_memory = cfg.find(field_lock_memory);
+        if (lock_memory != cfg.end()) {
+            dst->lock_memory = lock_memory->get<bool>();
+        }
+
+        // Pumping the collector from the application is optional, too.
+        auto manual_pump = cfg.find(field_manual_pump);
+        if (manual_pump != cfg.end()) {
+            dst->manual_pump = manual_pump->get<bool>();
+        }
+
+        // Merging the logs of the instruments is optional, too.
+        auto merge_logs = cfg.find(field_merge_logs);
+        if (merge_logs != cfg.end()) {
+            dst->merge_instrument_logs = merge_logs->get<bool>();
+        }
+
+        // Adapting the sampling rate to transients is optional, too.
+        auto min_sampling = cfg.find(field_min_sampling);
+        if (min_sampling != cfg.end()) {
+            dst->min_sampling_interval = std::chrono::microseconds(
+                min_sampling->get<sensor::microseconds_type>());
+        }
+
+        // The capture mode around triggers is optional, too.
+        auto post_trigger = cfg.find(field_post_trigger);
+        if (post_trigger != cfg.end()) {
+            dst->post_trigger = decltype(dst->post_trigger)(
+                post_trigger->get<sensor::microseconds_type>());
+        }
+
+        auto pre_trigger = cfg.find(field_pre_trigger);
+        if (pre_trigger != cfg.end()) {
+            dst->pre_trigger = decltype(dst->pre_trigger)(
+                pre_trigger->get<sensor::microseconds_type>());
+        }
+
+        // Attributing the energy of the GPUs to processes is optional.
+        auto process_energy = cfg.find(field_process_energy);
+        if (process_energy != cfg.end()) {
+            dst->process_energy_path = power_overwhelming::convert_string<
+                wchar_t>(process_energy->get<std::string>());
+        }
+
+        // Triggering oscilloscopes by markers is optional, too.
+        auto trigger_oscilloscopes = cfg.find(field_trigger_oscilloscopes);
+        if (trigger_oscilloscopes != cfg.end()) {
+            dst->trigger_oscilloscopes = trigger_oscilloscopes->get<bool>();
+        }
+
+        auto trigger_threshold = cfg.find(field_trigger_threshold);
+        if (trigger_threshold != cfg.end()) {
+            dst->trigger_threshold = trigger_threshold->get<float>();
+        }
+
+        // Archiving the waveforms of the oscilloscopes is optional, too.
+        auto waveform_archive = cfg.find(field_waveform_archive);
+        if (waveform_archive != cfg.end()) {
+            dst->waveform_archive_path = power_overwhelming::convert_string<
+                wchar_t>(waveform_archive->get<std::string>());
+        }
+
+        auto compress_waveforms = cfg.find(field_compress_waveforms);
+        if (compress_waveforms != cfg.end()) {
+            dst->compress_waveforms = compress_waveforms->get<bool>();
+        }
+
+        // Recording the overhead of the library is optional, too.
+        auto record_overhead = cfg.find(field_record_overhead);
+        if (record_overhead != cfg.end()) {
+            dst->record_overhead = record_overhead->get<bool>();
+        }
+
+        // Gating the sampling by markers is optional as well.
+        auto require_marker = cfg.find(field_require_marker);
+        if (require_marker != cfg.end()) {
+            dst->require_marker = require_marker->get<bool>();
+        }
+
+        // An overhead experiment is optional, too, but it cannot be gated by
+        // markers.
+        auto overhead_report = cfg.find(field_overhead_report);
+        if (overhead_report != cfg.end()) {
+            dst->experiment_report = power_overwhelming::convert_string<
+                wchar_t>(overhead_report->get<std::string>());
+        }
+
+        if (dst->require_marker && !dst->experiment_report.empty()) {
+            throw std::invalid_argument("An overhead experiment cannot be "
+                "performed if sampling requires a marker.");
+        }
+
+        auto overhead_interval = cfg.find(field_overhead_interval);
+        if (overhead_interval != cfg.end()) {
+            dst->experiment_interval = std::chrono::microseconds(
+                overhead_interval->get<sensor::microseconds_type>());
+        }
+
+        auto overhead_window = cfg.find(field_overhead_window);
+        if (overhead_window != cfg.end()) {
+            dst->experiment_window = std::chrono::microseconds(
+                overhead_window->get<sensor::microseconds_type>());
+        }
+
+        auto retain_unfiltered = cfg.find(field_retain_unfiltered);
+        if (retain_unfiltered != cfg.end()) {
+            dst->retain_unfiltered = retain_unfiltered->get<bool>();
+        }
+
+        // Rotating the output into segments is optional, too.
+        auto rotate_interval = cfg.find(field_rotate_interval);
+        if (rotate_interval != cfg.end()) {
+            dst->rotate_interval = std::chrono::microseconds(
+                rotate_interval->get<sensor::microseconds_type>());
+        }
+
+        auto rotate_size = cfg.find(field_rotate_size);
+        if (rotate_size != cfg.end()) {
+            dst->rotate_size = rotate_size->get<std::uint64_t>();
+        }
+
+        // Estimating the power of GPUs from their activity is optional.
+        auto estimate_power = cfg.find(field_estimate_power);
+        if (estimate_power != cfg.end()) {
+            dst->estimate_power = estimate_power->get<bool>();
+        }
+
+        // Publishing the latest samples in shared memory is optional, too.
+        auto shared_memory = cfg.find(field_shared_memory);
+        if (shared_memory != cfg.end()) {
+            dst->shared_memory_name = power_overwhelming::convert_string<
+                wchar_t>(shared_memory->get<std::string>());
+        }
+
+        // Accepting markers from other processes is optional.
+        auto marker_channel = cfg.find(field_marker_channel);
+        if (marker_channel != cfg.end()) {
+            dst->marker_channel_name = power_overwhelming::convert_string<
+                wchar_t>(marker_channel->get<std::string>());
+        }
+
+        // The capacity of the ring for in-process subscribers is optional.
+        auto subscriber_capacity = cfg.find(field_subscriber_capacity);
+        if (subscriber_capacity != cfg.end()) {
+            dst->subscriber_capacity = (std::max)(std::size_t(1),
+                subscriber_capacity->get<std::size_t>());
+        }
+
+        // Discarding duplicate samples is optional, too.
+        auto suppress_duplicates = cfg.find(field_suppress_duplicates);
+        if (suppress_duplicates != cfg.end()) {
+            dst->suppress_duplicates = suppress_duplicates->get<bool>();
+        }
+
+        // Keeping the raw arrival times of Tinkerforge samples is optional.
+        auto tinkerforge_arrival_times = cfg.find(
+            field_tinkerforge_arrival_times);
+        if (tinkerforge_arrival_times != cfg.end()) {
+            dst->tinkerforge_arrival_times
+                = tinkerforge_arrival_times->get<bool>();
+        }
+
+        // Estimating the distribution of the power is optional, too.
+        auto track_quantiles = cfg.find(field_track_quantiles);
+        if (track_quantiles != cfg.end()) {
+            dst->track_quantiles = track_quantiles->get<bool>();
+        }
+
+        // Checking the sequence numbers of the samples is optional, too.
+        auto track_sequences = cfg.find(field_track_sequences);
+        if (track_sequences != cfg.end()) {
+            dst->track_sequences = track_sequences->get<bool>();
+        }
+
+        // The wake-up criteria of the I/O thread are optional, too.
+        auto write_latency = cfg.find(field_write_latency);
+        if (write_latency != cfg.end()) {
+            dst->write_latency = std::chrono::milliseconds((std::max)(
+                sensor::microseconds_type(1),
+                (write_latency->get<sensor::microseconds_type>() + 999)
+                / 1000));
+        }
+
+        auto write_statistics = cfg.find(field_write_statistics);
+        if (write_statistics != cfg.end()) {
+            dst->write_statistics = write_statistics->get<bool>();
+        }
+
+        auto write_threshold = cfg.find(field_write_threshold);
+        if (write_threshold != cfg.end()) {
+            dst->write_threshold = (std::min)(1.0f, (std::max)(0.0f,
+                write_threshold->get<float>()));
+        }
+
+        auto writer_threads = cfg.find(field_writer_threads);
+        if (writer_threads != cfg.end()) {
+            dst->writer_threads = (std::max)(std::size_t(1),
+                writer_threads->get<std::size_t>());
+        }
+
+        // Specific intervals map the names of sensors or their types to the
+        // interval they are sampled at, which is also optional.
+        dst->sensor_intervals.clear();
+        auto sensor_intervals = cfg.find(field_sensor_intervals);
+        if (sensor_intervals != cfg.end()) {
+            for (auto& i : sensor_intervals->items()) {
+                auto name = power_overwhelming::convert_string<wchar_t>(
+                    i.key());
+                dst->sensor_intervals[name] = std::chrono::microseconds(
+                    i.value().get<sensor::microseconds_type>());
+            }
+        }
+
+        // The budget for the overhead of sampling is optional, too. The
+        // priorities for distributing it map the names of sensors or their
+        // types like the intervals.
+        {
+            auto cpu_budget = cfg.find(field_sampling_cpu_budget);
+            auto read_budget = cfg.find(field_sampling_read_budget);
+            dst->rate_budget = sampling_budget(
+                (cpu_budget != cfg.end()) ? cpu_budget->get<float>() : 0.0f,
+                (read_budget != cfg.end())
+                ? read_budget->get<std::uint64_t>()
+                : 0);
+        }
+
+        dst->sensor_priorities.clear();
+        auto sensor_priorities = cfg.find(field_sensor_priorities);
+        if (sensor_priorities != cfg.end()) {
+            for (auto& i : sensor_priorities->items()) {
+                auto name = power_overwhelming::convert_string<wchar_t>(
+                    i.key());
+                const auto priority = i.value().get<float>();
+                if (priority > 0.0f) {
+                    dst->sensor_priorities[name] = priority;
+                }
+            }
+        }
+
+        // The quantities map the names of sensors or their types to a source
+        // like "power" or "voltage|current". "none" selects the default of
+        // the sensor.
+        dst->sensor_quantities.clear();
+        auto sensor_quantities = cfg.find(field_sensor_quantities);
+        if (sensor_quantities != cfg.end()) {
+            for (auto& q : sensor_quantities->items()) {
+                auto name = power_overwhelming::convert_string<wchar_t>(
+                    q.key());
+                auto source = power_overwhelming::convert_string<wchar_t>(
+                    q.value().get<std::string>());
+                auto quantities = parse_tinkerforge_sensor_source(
+                    source.c_str());
+                if (quantities != tinkerforge_sensor_source::none) {
+                    dst->sensor_quantities[name] = quantities;
+                }
+            }
+        }
+
+        // The calibrated delays map the names of sensors or their types to
+        // microseconds. They can be given inline or in a correction profile
+        // created by the calibration tool, but entries given inline take
+        // precedence.
+        dst->sensor_delays.clear();
+        auto sensor_delays = cfg.find(field_sensor_delays);
+        if (sensor_delays != cfg.end()) {
+            for (auto& i : sensor_delays->items()) {
+                auto name = power_overwhelming::convert_string<wchar_t>(
+                    i.key());
+                dst->sensor_delays[name] = std::chrono::microseconds(
+                    i.value().get<sensor::microseconds_type>());
+            }
+        }
+
+        auto correction_profile = cfg.find(field_correction_profile);
+        if ((correction_profile != cfg.end())
+                && !correction_profile->get<std::string>().empty()) {
+            std::ifstream s;
+            s.exceptions(s.exceptions() | std::ios::failbit
+                | std::ios::badbit);
+#if defined(_WIN32)
+            s.open(power_overwhelming::convert_string<wchar_t>(
+                correction_profile->get<std::string>()));
+#else /* defined(_WIN32) */
+            s.open(correction_profile->get<std::string>());
+#endif /* defined(_WIN32) */
+            auto profile = nlohmann::json::parse(s);
+
+            auto delays = profile.find(field_sensor_delays);
+            if (delays != profile.end()) {
+                for (auto& i : delays->items()) {
+                    auto name = power_overwhelming::convert_string<wchar_t>(
+                        i.key());
+                    dst->sensor_delays.emplace(name,
+                        std::chrono::microseconds(
+                        i.value().get<sensor::microseconds_type>()));
+                }
+            }
+        }
+
+        // The thresholds for the change-only emission map the names of
+        // sensors or their types in the same way.
+        dst->delta_thresholds.clear();
+        auto delta_thresholds = cfg.find(field_delta_thresholds);
+        if (delta_thresholds != cfg.end()) {
+            for (auto& i : delta_thresholds->items()) {
+                auto name = power_overwhelming::convert_string<wchar_t>(
+                    i.key());
+                dst->delta_thresholds[name] = i.value().get<float>();
+            }
+        }
+
+        // The filters map the names of sensors or their types like the
+        // thresholds.
+        dst->sample_filters.clear();
+        auto filters = cfg.find(field_filters);
+        if (filters != cfg.end()) {
+            for (auto& i : filters->items()) {
+                auto name = power_overwhelming::convert_string<wchar_t>(
+                    i.key());
+                auto filter = parse_filter(i.value());
+                if (filter) {
+                    dst->sample_filters[name] = filter;
+                }
+            }
+        }
+
+        // The derived sensors are a list, because they might use the ones
+        // declared before them.
+        dst->derived.clear();
+        auto derived_sensors = cfg.find(field_derived_sensors);
+        if (derived_sensors != cfg.end()) {
+            for (auto& d : *derived_sensors) {
+                auto name = power_overwhelming::convert_string<wchar_t>(
+                    d[field_derived_name].get<std::string>());
+                auto expression = power_overwhelming::convert_string<wchar_t>(
+                    d[field_derived_expression].get<std::string>());
+                dst->derived.add(name.c_str(), expression.c_str());
+            }
+        }
+
+        // The shards can only be created once we know that all of the
+        // settings permit sharding the output.
+        dst->open_shards();
+    }
+
     /// <summary>
     /// Apply the given JSON configuration to the given collector.
     /// </summary>
@@ -62,12 +698,9 @@ namespace detail {
         auto& sensor_list = cfg[field_sensors];
         dst->sensors = detail::parse_sensors(sensor_list);
 
-        // If we have the sensors, create the output file and store the rest of the
-        // properties.
-        dst->stream.open(cfg[field_output].get<std::string>(),
-            std::ofstream::trunc);
-        dst->sampling_interval = decltype(dst->sampling_interval)(
-            cfg[field_sampling].get<sensor::microseconds_type>());
+        // If we have the sensors, create the output file and store the rest of
+        // the properties.
+        apply_settings(dst, cfg);
     }
 
 } /* namespace detail */
@@ -75,6 +708,52 @@ namespace detail {
 } /* namespace visus */
 
 
+/*
+ * visus::power_overwhelming::collector::discover_async
+ */
+visus::power_overwhelming::collector_discovery
+visus::power_overwhelming::collector::discover_async(
+        _In_ const collector_settings& settings,
+        _In_opt_ const collector_discovery::callback_type callback,
+        _In_opt_ void *context) {
+    return discover_async(settings, sensor_filter(), callback, context);
+}
+
+
+/*
+ * visus::power_overwhelming::collector::discover_async
+ */
+visus::power_overwhelming::collector_discovery
+visus::power_overwhelming::collector::discover_async(
+        _In_ const collector_settings& settings,
+        _In_ const sensor_filter& filter,
+        _In_opt_ const collector_discovery::callback_type callback,
+        _In_opt_ void *context) {
+    auto state = std::make_shared<detail::collector_discovery_state>(
+        callback, context);
+    auto retval = detail::collector_discovery_impl::create(state);
+
+    // The thread owns copies of the settings and the filter, because the
+    // caller might not keep them alive until the discovery completes.
+    std::thread([filter, settings, state](void) {
+        detail::enter_library_thread("PwrOwg Discovery Thread");
+
+        try {
+            auto result = collector(new detail::collector_impl());
+            result._impl->apply(settings);
+            result._impl->sensors = detail::get_all_sensors(filter,
+                &state->cancelled);
+            detail::complete_discovery(state, std::move(result), nullptr);
+        } catch (...) {
+            detail::complete_discovery(state, collector(),
+                std::current_exception());
+        }
+    }).detach();
+
+    return retval;
+}
+
+
 /*
  * visus::power_overwhelming::collector::for_all
  */
@@ -88,6 +767,20 @@ visus::power_overwhelming::collector::for_all(
 }
 
 
+/*
+ * visus::power_overwhelming::collector::for_all
+ */
+visus::power_overwhelming::collector
+visus::power_overwhelming::collector::for_all(
+        _In_ const collector_settings& settings,
+        _In_ const sensor_filter& filter) {
+    auto retval = collector(new detail::collector_impl());
+    retval._impl->apply(settings);
+    retval._impl->sensors = detail::get_all_sensors(filter);
+    return retval;
+}
+
+
 /*
  * visus::power_overwhelming::collector::from_defaults
  */
@@ -111,7 +804,42 @@ visus::power_overwhelming::collector::from_json(_In_z_ const wchar_t *path) {
     }
 
     auto retval = collector(new detail::collector_impl());
-    detail::apply_template(retval._impl, detail::read_json(path));
+    nlohmann::json config;
+    retval._impl->sensors = detail::compiled_config::load(config, path,
+        detail::field_sensors);
+    detail::apply_settings(retval._impl, config);
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::collector::from_json
+ */
+visus::power_overwhelming::collector
+visus::power_overwhelming::collector::from_json(_In_z_ const wchar_t *path,
+        _In_ const bool defer_open) {
+    if (!defer_open) {
+        return from_json(path);
+    }
+
+    if (path == nullptr) {
+        throw std::invalid_argument("The path to the configuration file must "
+            "not be null.");
+    }
+
+    // The compiled cache is bypassed, because restoring sensors from it
+    // would open them. Validating the descriptors is cheap anyway.
+    auto config = detail::read_json(path);
+    auto retval = collector(new detail::collector_impl());
+
+    auto sensors = config.find(detail::field_sensors);
+    if (sensors != config.end()) {
+        retval._impl->deferred_sensors = detail::validate_sensor_descs(
+            *sensors);
+    }
+
+    detail::apply_settings(retval._impl, config);
 
     return retval;
 }
@@ -122,7 +850,45 @@ visus::power_overwhelming::collector::from_json(_In_z_ const wchar_t *path) {
  */
 void visus::power_overwhelming::collector::make_configuration_template(
         _In_z_ const wchar_t *path) {
-    detail::write_json(path, detail::make_json_template());
+    make_configuration_template(path, sensor_filter());
+}
+
+
+/*
+ * visus::power_overwhelming::collector::make_configuration_template
+ */
+void visus::power_overwhelming::collector::make_configuration_template(
+        _In_z_ const wchar_t *path,
+        _In_ const sensor_filter& filter) {
+    if (path == nullptr) {
+        throw std::invalid_argument("The path to the configuration file must "
+            "not be null.");
+    }
+
+    // Format the settings like write_json and strip the closing brace, which
+    // allows us to stream the sensors as the last member of the object.
+    // Note that nlohmann::json sorts the keys, wherefore the sensors would be
+    // the last member anyway.
+    auto settings = detail::make_json_settings().dump(4);
+    assert(settings.back() == '}');
+    settings.pop_back();
+    while (!settings.empty() && (settings.back() == '\n')) {
+        settings.pop_back();
+    }
+
+    std::ofstream s;
+    s.exceptions(s.exceptions() | std::ios::failbit | std::ios::badbit);
+#if defined(_WIN32)
+    s.open(path, std::ofstream::out | std::ofstream::trunc);
+#else /* defined(_WIN32) */
+    auto p = power_overwhelming::convert_string<char>(path);
+    s.open(p, std::ofstream::out | std::ofstream::trunc);
+#endif /* defined(_WIN32) */
+
+    s << settings << ",\n    \"" << detail::field_sensors << "\": ";
+    detail::write_sensor_descs(s, filter, 4);
+    s << "\n}";
+    s.flush();
 }
 
 
@@ -135,6 +901,35 @@ visus::power_overwhelming::collector::~collector(void) {
 }
 
 
+/*
+ * visus::power_overwhelming::collector::detach
+ */
+bool visus::power_overwhelming::collector::detach(_In_z_ const wchar_t *name) {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("The collector has been moved to another "
+            "instance wherefore no sensor can be removed.");
+    }
+
+    return this->_impl->detach(name);
+}
+
+
+/*
+ * visus::power_overwhelming::collector::energy
+ */
+double visus::power_overwhelming::collector::energy(
+        _In_ const std::uint32_t marker) const {
+    if (this->_impl == nullptr) {
+        return 0.0;
+    }
+
+    std::lock_guard<decltype(this->_impl->statistics_lock)> l(
+        this->_impl->statistics_lock);
+    const auto& energies = this->_impl->marker_energies;
+    return (marker < energies.size()) ? energies[marker] : 0.0;
+}
+
+
 /*
  * visus::power_overwhelming::collector::marker
  */
@@ -149,11 +944,170 @@ void visus::power_overwhelming::collector::marker(
 }
 
 
+/*
+ * visus::power_overwhelming::collector::marker
+ */
+void visus::power_overwhelming::collector::marker(_In_ const std::uint32_t id) {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("The collector has been moved to another "
+            "instance wherefore no marker can be set.");
+    }
+
+    this->_impl->marker(id);
+}
+
+
+/*
+ * visus::power_overwhelming::collector::marker
+ */
+void visus::power_overwhelming::collector::marker(_In_ const std::uint32_t id,
+        _In_ const measurement::timestamp_type timestamp) {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("The collector has been moved to another "
+            "instance wherefore no marker can be set.");
+    }
+
+    this->_impl->marker(id, detail::convert(timestamp,
+        this->_impl->timestamp_resolution));
+}
+
+
+/*
+ * visus::power_overwhelming::collector::marker_channel
+ */
+_Ret_maybenull_z_ const wchar_t *
+visus::power_overwhelming::collector::marker_channel(void) const noexcept {
+    return ((this->_impl != nullptr)
+        && !this->_impl->marker_channel_name.empty())
+        ? this->_impl->marker_channel_name.c_str()
+        : nullptr;
+}
+
+
+/*
+ * visus::power_overwhelming::collector::overflows
+ */
+std::uint64_t visus::power_overwhelming::collector::overflows(void) const {
+    return (this->_impl != nullptr) ? this->_impl->overflows() : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::collector::output_path
+ */
+_Ret_maybenull_z_ const wchar_t *
+visus::power_overwhelming::collector::output_path(void) const noexcept {
+    return (this->_impl != nullptr)
+        ? this->_impl->output_path.c_str()
+        : nullptr;
+}
+
+
+/*
+ * visus::power_overwhelming::collector::output_path
+ */
+void visus::power_overwhelming::collector::output_path(
+        _In_z_ const wchar_t *path) {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("The collector has been moved to another "
+            "instance wherefore its output cannot be redirected.");
+    }
+
+    if (path == nullptr) {
+        throw std::invalid_argument("The output path must not be null.");
+    }
+
+    this->_impl->reopen(path);
+}
+
+
+/*
+ * visus::power_overwhelming::collector::progress
+ */
+void visus::power_overwhelming::collector::progress(
+        _In_ const std::uint64_t units) noexcept {
+    if (this->_impl != nullptr) {
+        this->_impl->experiment.progress(units);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::collector::pump
+ */
+std::size_t visus::power_overwhelming::collector::pump(
+        _In_ const collector_settings::sampling_interval_type budget) {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("The collector has been moved to another "
+            "instance wherefore it cannot be pumped.");
+    }
+
+    return this->_impl->pump(std::chrono::microseconds(budget));
+}
+
+
+/*
+ * visus::power_overwhelming::collector::register_marker
+ */
+std::uint32_t visus::power_overwhelming::collector::register_marker(
+        _In_z_ const wchar_t *marker) {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("The collector has been moved to another "
+            "instance wherefore no marker can be registered.");
+    }
+
+    return this->_impl->register_marker(marker);
+}
+
+
+/*
+ * visus::power_overwhelming::collector::samples
+ */
+std::uint64_t visus::power_overwhelming::collector::samples(
+        void) const noexcept {
+    return (this->_impl != nullptr)
+        ? this->_impl->samples.load(std::memory_order_relaxed)
+        : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::collector::sampling_interval
+ */
+bool visus::power_overwhelming::collector::sampling_interval(
+        _In_z_ const wchar_t *name,
+        _In_ const sensor::microseconds_type interval) {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("The collector has been moved to another "
+            "instance and therefore cannot be configured.");
+    }
+
+    return this->_impl->interval(name, std::chrono::microseconds(interval));
+}
+
+
+/*
+ * visus::power_overwhelming::collector::shared_memory
+ */
+_Ret_maybenull_z_ const wchar_t *
+visus::power_overwhelming::collector::shared_memory(void) const noexcept {
+    return ((this->_impl != nullptr)
+        && !this->_impl->shared_memory_name.empty())
+        ? this->_impl->shared_memory_name.c_str()
+        : nullptr;
+}
+
+
 /*
  * visus::power_overwhelming::collector::size
  */
 std::size_t visus::power_overwhelming::collector::size(void) const noexcept {
-    return (this->_impl != nullptr) ? this->_impl->sensors.size() : 0;
+    if (this->_impl == nullptr) {
+        return 0;
+    }
+
+    std::lock_guard<decltype(this->_impl->gate_lock)> l(this->_impl->gate_lock);
+    return this->_impl->sensors.size() + this->_impl->deferred_sensors.size();
 }
 
 
@@ -170,6 +1124,21 @@ void visus::power_overwhelming::collector::start(void) {
 }
 
 
+/*
+ * visus::power_overwhelming::collector::statistics
+ */
+visus::power_overwhelming::collector_statistics
+visus::power_overwhelming::collector::statistics(void) const {
+    collector_statistics retval;
+
+    if (this->_impl != nullptr) {
+        this->_impl->statistics(*retval._impl);
+    }
+
+    return retval;
+}
+
+
 /*
  * visus::power_overwhelming::collector::stop
  */
@@ -180,6 +1149,88 @@ void visus::power_overwhelming::collector::stop(void) {
 }
 
 
+/*
+ * visus::power_overwhelming::collector::subscribe
+ */
+visus::power_overwhelming::collector_subscriber
+visus::power_overwhelming::collector::subscribe(
+        _In_ const subscriber_overflow overflow) {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("The collector has been moved to another "
+            "instance wherefore no subscriber can be created.");
+    }
+
+    return collector_subscriber(new detail::collector_subscriber_impl(
+        this->_impl->subscribe(), overflow));
+}
+
+
+/*
+ * visus::power_overwhelming::collector::track_frames
+ */
+visus::power_overwhelming::frame_marker
+visus::power_overwhelming::collector::track_frames(
+        _In_z_ const wchar_t *marker) {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("The collector has been moved to another "
+            "instance wherefore no frames can be tracked.");
+    }
+
+    const auto id = this->_impl->register_marker(marker);
+    return frame_marker(new detail::frame_marker_impl(
+        this->_impl->track_frames(), id, this->_impl->timestamp_resolution));
+}
+
+
+/*
+ * visus::power_overwhelming::collector::trigger
+ */
+void visus::power_overwhelming::collector::trigger(void) {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("The collector has been moved to another "
+            "instance wherefore no trigger can be raised.");
+    }
+
+    this->_impl->trigger();
+}
+
+
+/*
+ * visus::power_overwhelming::collector::tune_tinkerforge_sensors
+ */
+std::size_t visus::power_overwhelming::collector::tune_tinkerforge_sensors(
+        void) {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("The collector has been moved to another "
+            "instance and therefore cannot be configured.");
+    }
+
+    std::lock_guard<decltype(this->_impl->gate_lock)> l(this->_impl->gate_lock);
+    std::vector<sensor::microseconds_type> intervals;
+    std::vector<tinkerforge_sensor *> sensors;
+
+    // Configuring the bricklets requires them to be opened.
+    this->_impl->open_deferred_sensors();
+
+    for (auto& s : this->_impl->sensors) {
+        auto t = dynamic_cast<tinkerforge_sensor *>(s.get());
+        if (t != nullptr) {
+            // Tune each bricklet for the interval it will be sampled at.
+            this->_impl->resolve_interval(t);
+            intervals.push_back(static_cast<sensor::microseconds_type>(
+                this->_impl->interval_of(t).count()));
+            sensors.push_back(t);
+        }
+    }
+
+    // Configure all bricklets at once rather than waiting for each of them.
+    tinkerforge_sensor::configure_all(sensors.data(), intervals.data(),
+        sensors.size());
+
+    return sensors.size();
+}
+
+
 /*
  * visus::power_overwhelming::collector::operator =
  */
@@ -235,3 +1286,23 @@ void visus::power_overwhelming::collector::add(_In_ sensor *sensor) {
     this->_impl->sensors.emplace_back(sensor);
 }
 
+
+/*
+ * visus::power_overwhelming::collector::attach_sensor
+ */
+void visus::power_overwhelming::collector::attach_sensor(_In_ sensor *sensor) {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("The collector has been moved to another "
+            "instance wherefore no sensor can be added.");
+    }
+
+    std::unique_ptr<power_overwhelming::sensor> s(sensor);
+    try {
+        this->_impl->attach(std::move(s));
+    } catch (...) {
+        // The caller retains ownership if the sensor could not be added.
+        s.release();
+        throw;
+    }
+}
+
@@ -0,0 +1,98 @@
+﻿// <copyright file="collector_agent.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/collector_agent.h"
+
+#include <memory>
+#include <stdexcept>
+
+#include "collector_agent_impl.h"
+
+
+/*
+ * visus::power_overwhelming::collector_agent::default_port
+ */
+constexpr std::uint16_t visus::power_overwhelming::collector_agent
+::default_port;
+
+
+/*
+ * visus::power_overwhelming::collector_agent::collector_agent
+ */
+visus::power_overwhelming::collector_agent::collector_agent(void)
+    : _impl(new detail::collector_agent_impl()) { }
+
+
+/*
+ * visus::power_overwhelming::collector_agent::~collector_agent
+ */
+visus::power_overwhelming::collector_agent::~collector_agent(void) {
+    this->stop();
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_agent::start
+ */
+void visus::power_overwhelming::collector_agent::start(
+        _In_ collector& collector,
+        _In_ const std::uint16_t port,
+        _In_opt_z_ const wchar_t *address,
+        _In_ const std::uint16_t sync_port) {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("A collector_agent which has been disposed "
+            "by a move operation cannot be started.");
+    }
+
+    if (!collector) {
+        throw std::invalid_argument("A disposed collector cannot be "
+            "coordinated.");
+    }
+
+    if (this->_impl->running.load()) {
+        throw std::logic_error("The collector_agent is already running.");
+    }
+
+    this->_impl->collector = std::addressof(collector);
+    this->_impl->sync_port = sync_port;
+    this->_impl->start(port, address);
+}
+
+
+/*
+ * visus::power_overwhelming::collector_agent::stop
+ */
+void visus::power_overwhelming::collector_agent::stop(void) noexcept {
+    if (this->_impl != nullptr) {
+        this->_impl->stop();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::collector_agent::operator =
+ */
+visus::power_overwhelming::collector_agent&
+visus::power_overwhelming::collector_agent::operator =(
+        _Inout_ collector_agent&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        this->stop();
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_agent::operator bool
+ */
+visus::power_overwhelming::collector_agent::operator bool(
+        void) const noexcept {
+    return (this->_impl != nullptr);
+}
@@ -0,0 +1,350 @@
+﻿// <copyright file="collector_agent_impl.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "collector_agent_impl.h"
+
+#include <cassert>
+#include <chrono>
+#include <stdexcept>
+#include <system_error>
+
+#include "power_overwhelming/computer_name.h"
+#include "power_overwhelming/convert_string.h"
+
+#include "library_thread.h"
+#include "on_exit.h"
+
+
+/*
+ * visus::power_overwhelming::detail::collector_agent_impl::session_type
+ * ::session_type
+ */
+visus::power_overwhelming::detail::collector_agent_impl::session_type
+::session_type(_In_ const coordination_socket socket)
+    : collecting(false), socket(socket), sync_port(0) { }
+
+
+/*
+ * visus::power_overwhelming::detail::collector_agent_impl::sync_interval
+ */
+constexpr unsigned int
+visus::power_overwhelming::detail::collector_agent_impl::sync_interval;
+
+
+/*
+ * visus::power_overwhelming::detail::collector_agent_impl::collector_agent_impl
+ */
+visus::power_overwhelming::detail::collector_agent_impl::collector_agent_impl(
+        void)
+    : collector(nullptr),
+        listener(static_cast<std::intptr_t>(INVALID_SOCKET)),
+        running(false),
+        sync_port(0) { }
+
+
+/*
+ * visus::power_overwhelming::detail::collector_agent_impl::handle
+ */
+visus::power_overwhelming::detail::coordination_message
+visus::power_overwhelming::detail::collector_agent_impl::handle(
+        _Inout_ session_type& session,
+        _In_ const coordination_message type,
+        _In_ const std::vector<std::uint8_t>& payload,
+        _Out_ std::vector<std::uint8_t>& response) {
+    assert(this->collector != nullptr);
+    std::size_t offset = 0;
+    response.clear();
+
+    if ((type != coordination_message::hello) && !session.synchroniser) {
+        throw std::logic_error("The coordinator must greet the agent before "
+            "sending requests.");
+    }
+
+    switch (type) {
+        case coordination_message::hello: {
+            session.sync_port = coordination_read<std::uint16_t>(payload,
+                offset);
+
+            // The synchroniser must use the address family of the
+            // connection, because it talks to the host of the coordinator.
+            sockaddr_storage addr;
+            socklen_t length = sizeof(addr);
+            if (::getsockname(session.socket, reinterpret_cast<sockaddr *>(
+                    &addr), &length) == SOCKET_ERROR) {
+                throw std::system_error(get_socket_error(),
+                    std::system_category());
+            }
+
+            session.synchroniser = time_synchroniser::create(addr.ss_family,
+                this->sync_port);
+            session.synchroniser.request(session.host.c_str(),
+                session.sync_port);
+
+            coordination_append(response, computer_name<wchar_t>().c_str());
+            return coordination_message::welcome;
+            }
+
+        case coordination_message::start: {
+            if (session.collecting) {
+                throw std::logic_error("The collector is already running.");
+            }
+
+            const auto at = to_local(session,
+                coordination_read<timestamp_type>(payload, offset));
+            const auto lateness = coordination_wait(at);
+            this->collector->start();
+            session.collecting = true;
+            coordination_append(response, lateness);
+            return coordination_message::started;
+            }
+
+        case coordination_message::marker: {
+            const auto at = to_local(session,
+                coordination_read<timestamp_type>(payload, offset));
+            const auto marker = coordination_read_string(payload, offset);
+
+            coordination_wait(at);
+            this->collector->marker(marker.empty() ? nullptr : marker.c_str());
+            return coordination_message::marked;
+            }
+
+        case coordination_message::stop:
+            this->collector->stop();
+            session.collecting = false;
+            coordination_append(response, this->collector->samples());
+            coordination_append(response, this->collector->overflows());
+            return coordination_message::stopped;
+
+        default:
+            throw std::runtime_error("The coordinator sent an unknown "
+                "request.");
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_agent_impl::serve
+ */
+void visus::power_overwhelming::detail::collector_agent_impl::serve(void) {
+    enter_library_thread("PwrOwg Collector Agent Thread");
+
+    while (this->running.load(std::memory_order_acquire)) {
+        auto peer = ::accept(static_cast<coordination_socket>(
+            this->listener), nullptr, nullptr);
+        if (peer == INVALID_SOCKET) {
+            // This is how we are interrupted by stop().
+            continue;
+        }
+
+        const auto guard_peer = on_exit([peer](void) { close_socket(peer); });
+
+        try {
+            this->serve(peer);
+        } catch (...) {
+            // The coordinator is gone, so we wait for the next one.
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_agent_impl::serve
+ */
+void visus::power_overwhelming::detail::collector_agent_impl::serve(
+        _In_ const coordination_socket peer) {
+    session_type session(peer);
+    std::vector<std::uint8_t> payload;
+    std::vector<std::uint8_t> response;
+    coordination_message type;
+
+    // Do not leave the collector running if the coordinator goes away.
+    const auto guard_collector = on_exit([this, &session](void) {
+        if (session.collecting) {
+            this->collector->stop();
+        }
+    });
+
+    {
+        sockaddr_storage addr;
+        socklen_t length = sizeof(addr);
+        char host[NI_MAXHOST];
+        if ((::getpeername(peer, reinterpret_cast<sockaddr *>(&addr),
+                &length) == SOCKET_ERROR)
+                || (::getnameinfo(reinterpret_cast<sockaddr *>(&addr),
+                length, host, sizeof(host), nullptr, 0, NI_NUMERICHOST) != 0)) {
+            throw std::system_error(get_socket_error(),
+                std::system_category());
+        }
+        session.host = host;
+    }
+
+    {
+        int value = 1;
+        ::setsockopt(peer, IPPROTO_TCP, TCP_NODELAY,
+            reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    // The timeout allows for checking whether we should exit and for
+    // following the drift of the clocks while idle.
+    coordination_timeout(peer, sync_interval);
+
+    while (this->running.load(std::memory_order_acquire)) {
+        if (!coordination_receive(peer, type, payload)) {
+            if (session.synchroniser) {
+                session.synchroniser.request(session.host.c_str(),
+                    session.sync_port);
+            }
+            continue;
+        }
+
+        try {
+            type = this->handle(session, type, payload, response);
+        } catch (std::exception& ex) {
+            type = coordination_message::error;
+            response.clear();
+            coordination_append(response, power_overwhelming::convert_string<
+                wchar_t>(ex.what()).c_str());
+        }
+
+        coordination_send(peer, type, response);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_agent_impl::start
+ */
+void visus::power_overwhelming::detail::collector_agent_impl::start(
+        _In_ const std::uint16_t port,
+        _In_opt_z_ const wchar_t *address) {
+    assert(!this->running.load());
+
+#if defined(_WIN32)
+    {
+        WSADATA wsa_data = { };
+        auto status = ::WSAStartup(MAKEWORD(2, 2), &wsa_data);
+        if (status != 0) {
+            throw std::system_error(status, std::system_category());
+        }
+    }
+
+    auto guard_wsa_cleanup = on_exit([](void) { ::WSACleanup(); });
+#endif /* defined(_WIN32) */
+
+    addrinfo hints = { };
+    hints.ai_family = (address != nullptr) ? AF_UNSPEC : AF_INET;
+    hints.ai_flags = AI_PASSIVE;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+
+    const auto host = power_overwhelming::convert_string<char>(address);
+    const auto service = std::to_string(port);
+    addrinfo *addresses = nullptr;
+    const auto status = ::getaddrinfo((address != nullptr)
+        ? host.c_str()
+        : nullptr, service.c_str(), &hints, &addresses);
+    if (status != 0) {
+#if defined(_WIN32)
+        throw std::system_error(status, std::system_category());
+#else /* defined(_WIN32) */
+        throw std::runtime_error(::gai_strerror(status));
+#endif /* defined(_WIN32) */
+    }
+
+    const auto guard_addresses = on_exit([addresses](void) {
+        ::freeaddrinfo(addresses);
+    });
+
+    auto listener = ::socket(addresses->ai_family, addresses->ai_socktype,
+        addresses->ai_protocol);
+    if (listener == INVALID_SOCKET) {
+        throw std::system_error(get_socket_error(), std::system_category());
+    }
+
+    auto guard_listener = on_exit([listener](void) {
+        close_socket(listener);
+    });
+
+#if !defined(_WIN32)
+    // Allow for restarting the agent while old connections linger. On
+    // Windows, this would allow other processes to steal the port.
+    {
+        int value = 1;
+        ::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR,
+            reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+#endif /* !defined(_WIN32) */
+
+    if (::bind(listener, addresses->ai_addr,
+            static_cast<int>(addresses->ai_addrlen)) == SOCKET_ERROR) {
+        throw std::system_error(get_socket_error(), std::system_category());
+    }
+
+    if (::listen(listener, 1) == SOCKET_ERROR) {
+        throw std::system_error(get_socket_error(), std::system_category());
+    }
+
+    this->listener = static_cast<std::intptr_t>(listener);
+    this->running.store(true, std::memory_order_release);
+
+    try {
+        this->server = std::thread([this](void) { this->serve(); });
+    } catch (...) {
+        this->running.store(false, std::memory_order_release);
+        this->listener = static_cast<std::intptr_t>(INVALID_SOCKET);
+        throw;
+    }
+
+    guard_listener.cancel();
+#if defined(_WIN32)
+    guard_wsa_cleanup.cancel();
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_agent_impl::stop
+ */
+void visus::power_overwhelming::detail::collector_agent_impl::stop(
+        void) noexcept {
+    if (this->running.exchange(false, std::memory_order_acq_rel)) {
+        // Closing the socket interrupts the server blocking in accept, and
+        // a session ends within the receive timeout.
+        close_socket(static_cast<coordination_socket>(this->listener));
+        this->listener = static_cast<std::intptr_t>(INVALID_SOCKET);
+        this->server.join();
+#if defined(_WIN32)
+        ::WSACleanup();
+#endif /* defined(_WIN32) */
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_agent_impl::to_local
+ */
+visus::power_overwhelming::timestamp_type
+visus::power_overwhelming::detail::collector_agent_impl::to_local(
+        _Inout_ session_type& session,
+        _In_ const timestamp_type timestamp) {
+    static const auto resolution = timestamp_resolution::hundred_nanoseconds;
+    static constexpr int attempts = 20;
+
+    // The responses to the synchronisation requested when the session was
+    // opened might not have arrived yet, so we request some more.
+    for (int i = 0; i < attempts; ++i) {
+        auto retval = static_cast<std::int64_t>(timestamp);
+        if (session.synchroniser.to_local(&retval, 1, resolution,
+                session.host.c_str(), session.sync_port)) {
+            return static_cast<timestamp_type>(retval);
+        }
+
+        session.synchroniser.request(session.host.c_str(), session.sync_port);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    throw std::runtime_error("The clock of the coordinator could not be "
+        "determined.");
+}
@@ -0,0 +1,149 @@
+﻿// <copyright file="collector_agent_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <cinttypes>
+#include <string>
+#include <thread>
+#include <vector>
+
+// WinSock2.h must be included before Windows.h.
+#include "coordination_protocol.h"
+
+#include "power_overwhelming/collector.h"
+#include "power_overwhelming/time_synchroniser.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The private state of a <see cref="collector_agent" />.
+    /// </summary>
+    struct collector_agent_impl final {
+
+        /// <summary>
+        /// The state of the session with a coordinator.
+        /// </summary>
+        struct session_type {
+
+            /// <summary>
+            /// Indicates whether the coordinator has started the collector.
+            /// </summary>
+            bool collecting;
+
+            /// <summary>
+            /// The numeric address of the coordinator.
+            /// </summary>
+            std::string host;
+
+            /// <summary>
+            /// The socket connected to the coordinator.
+            /// </summary>
+            coordination_socket socket;
+
+            /// <summary>
+            /// The synchroniser estimating the clock of the coordinator, which
+            /// is created once the coordinator has greeted the agent.
+            /// </summary>
+            time_synchroniser synchroniser;
+
+            /// <summary>
+            /// The UDP port of the time synchroniser of the coordinator.
+            /// </summary>
+            std::uint16_t sync_port;
+
+            explicit session_type(_In_ const coordination_socket socket);
+        };
+
+        /// <summary>
+        /// The time in milliseconds after which an idle agent repeats the
+        /// synchronisation with the coordinator.
+        /// </summary>
+        static constexpr unsigned int sync_interval = 1000;
+
+        /// <summary>
+        /// The collector controlled by the coordinator.
+        /// </summary>
+        power_overwhelming::collector *collector;
+
+        /// <summary>
+        /// The socket accepting the coordinator, which is stored as integer
+        /// such that we do not need to expose the socket API.
+        /// </summary>
+        std::intptr_t listener;
+
+        /// <summary>
+        /// Indicates whether the <see cref="server" /> should continue
+        /// accepting coordinators.
+        /// </summary>
+        std::atomic<bool> running;
+
+        /// <summary>
+        /// The thread executing <see cref="serve" />.
+        /// </summary>
+        std::thread server;
+
+        /// <summary>
+        /// The UDP port of the time synchroniser of the agent.
+        /// </summary>
+        std::uint16_t sync_port;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        collector_agent_impl(void);
+
+        /// <summary>
+        /// Handles a request of the coordinator.
+        /// </summary>
+        /// <param name="session">The session with the coordinator.</param>
+        /// <param name="type">The type of the request.</param>
+        /// <param name="payload">The payload of the request.</param>
+        /// <param name="response">Receives the payload of the response.
+        /// </param>
+        /// <returns>The type of the response.</returns>
+        coordination_message handle(_Inout_ session_type& session,
+            _In_ const coordination_message type,
+            _In_ const std::vector<std::uint8_t>& payload,
+            _Out_ std::vector<std::uint8_t>& response);
+
+        /// <summary>
+        /// The body of the <see cref="server" /> thread.
+        /// </summary>
+        void serve(void);
+
+        /// <summary>
+        /// Serves a connected coordinator until it disconnects or the agent
+        /// is stopped.
+        /// </summary>
+        void serve(_In_ const coordination_socket peer);
+
+        /// <summary>
+        /// Starts accepting coordinators on the given address.
+        /// </summary>
+        void start(_In_ const std::uint16_t port,
+            _In_opt_z_ const wchar_t *address);
+
+        /// <summary>
+        /// Stops the server.
+        /// </summary>
+        void stop(void) noexcept;
+
+        /// <summary>
+        /// Converts a time stamp of the coordinator to the local clock.
+        /// </summary>
+        /// <exception cref="std::runtime_error">If the clock of the
+        /// coordinator is not known after several attempts.</exception>
+        static timestamp_type to_local(_Inout_ session_type& session,
+            _In_ const timestamp_type timestamp);
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,236 @@
+﻿// <copyright file="collector_coordinator.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/collector_coordinator.h"
+
+#include <memory>
+#include <stdexcept>
+
+#include "collector_coordinator_impl.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Answer the private state of a coordinator or throw if it has been
+    /// disposed.
+    /// </summary>
+    static collector_coordinator_impl& check_impl(
+            _In_opt_ collector_coordinator_impl *impl) {
+        if (impl == nullptr) {
+            throw std::runtime_error("A collector_coordinator which has been "
+                "disposed by a move operation cannot be used.");
+        }
+
+        return *impl;
+    }
+
+    /// <summary>
+    /// Answer the time stamp of the instant the given time from now.
+    /// </summary>
+    static timestamp_type scheduled(
+            _In_ const sensor::microseconds_type lead) {
+        return create_timestamp(timestamp_resolution::hundred_nanoseconds)
+            + 10 * lead;
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::collector_coordinator::default_sync_port
+ */
+constexpr std::uint16_t
+visus::power_overwhelming::collector_coordinator::default_sync_port;
+
+
+/*
+ * visus::power_overwhelming::collector_coordinator::default_marker_lead
+ */
+constexpr visus::power_overwhelming::sensor::microseconds_type
+visus::power_overwhelming::collector_coordinator::default_marker_lead;
+
+
+/*
+ * visus::power_overwhelming::collector_coordinator::default_start_lead
+ */
+constexpr visus::power_overwhelming::sensor::microseconds_type
+visus::power_overwhelming::collector_coordinator::default_start_lead;
+
+
+/*
+ * visus::power_overwhelming::collector_coordinator::create
+ */
+visus::power_overwhelming::collector_coordinator
+visus::power_overwhelming::collector_coordinator::create(
+        _In_ const int address_family,
+        _In_ const std::uint16_t sync_port) {
+    collector_coordinator retval;
+    retval._impl = new detail::collector_coordinator_impl(address_family,
+        sync_port);
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_coordinator::~collector_coordinator
+ */
+visus::power_overwhelming::collector_coordinator::~collector_coordinator(
+        void) {
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_coordinator::add
+ */
+visus::power_overwhelming::collector_coordinator&
+visus::power_overwhelming::collector_coordinator::add(
+        _In_z_ const char *host,
+        _In_ const std::uint16_t port) {
+    if (host == nullptr) {
+        throw std::invalid_argument("The host of a collector agent must not "
+            "be null.");
+    }
+
+    detail::check_impl(this->_impl).add(host, port);
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_coordinator::marker
+ */
+void visus::power_overwhelming::collector_coordinator::marker(
+        _In_opt_z_ const wchar_t *marker,
+        _In_ const sensor::microseconds_type lead) {
+    auto& impl = detail::check_impl(this->_impl);
+    std::vector<std::vector<std::uint8_t>> answers;
+    std::vector<std::uint8_t> payload;
+
+    detail::coordination_append(payload, detail::scheduled(lead));
+    detail::coordination_append(payload, (marker != nullptr) ? marker : L"");
+    impl.broadcast(detail::coordination_message::marker, payload,
+        detail::coordination_message::marked,
+        static_cast<unsigned int>(lead / 1000), answers);
+}
+
+
+/*
+ * visus::power_overwhelming::collector_coordinator::node
+ */
+const wchar_t *visus::power_overwhelming::collector_coordinator::node(
+        _In_ const std::size_t node) const {
+    return detail::check_impl(this->_impl).node(node).name.c_str();
+}
+
+
+/*
+ * visus::power_overwhelming::collector_coordinator::nodes
+ */
+std::size_t visus::power_overwhelming::collector_coordinator::nodes(
+        void) const noexcept {
+    return (this->_impl != nullptr) ? this->_impl->nodes.size() : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_coordinator::overflows
+ */
+std::uint64_t visus::power_overwhelming::collector_coordinator::overflows(
+        _In_ const std::size_t node) const {
+    return detail::check_impl(this->_impl).node(node).overflows;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_coordinator::samples
+ */
+std::uint64_t visus::power_overwhelming::collector_coordinator::samples(
+        _In_ const std::size_t node) const {
+    return detail::check_impl(this->_impl).node(node).samples;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_coordinator::start
+ */
+void visus::power_overwhelming::collector_coordinator::start(
+        _In_ const sensor::microseconds_type lead) {
+    auto& impl = detail::check_impl(this->_impl);
+    std::vector<std::vector<std::uint8_t>> answers;
+    std::vector<std::uint8_t> payload;
+
+    detail::coordination_append(payload, detail::scheduled(lead));
+    impl.broadcast(detail::coordination_message::start, payload,
+        detail::coordination_message::started,
+        static_cast<unsigned int>(lead / 1000), answers);
+
+    for (std::size_t i = 0; i < answers.size(); ++i) {
+        std::size_t offset = 0;
+        impl.nodes[i].start_deviation = detail::coordination_read<
+            timestamp_type>(answers[i], offset);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::collector_coordinator::start_deviation
+ */
+visus::power_overwhelming::sensor::microseconds_type
+visus::power_overwhelming::collector_coordinator::start_deviation(
+        _In_ const std::size_t node) const {
+    // The deviation is measured in units of 100 ns.
+    return detail::check_impl(this->_impl).node(node).start_deviation / 10;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_coordinator::stop
+ */
+void visus::power_overwhelming::collector_coordinator::stop(void) {
+    auto& impl = detail::check_impl(this->_impl);
+    std::vector<std::vector<std::uint8_t>> answers;
+
+    impl.broadcast(detail::coordination_message::stop, { },
+        detail::coordination_message::stopped, 0, answers);
+
+    for (std::size_t i = 0; i < answers.size(); ++i) {
+        std::size_t offset = 0;
+        impl.nodes[i].samples = detail::coordination_read<std::uint64_t>(
+            answers[i], offset);
+        impl.nodes[i].overflows = detail::coordination_read<std::uint64_t>(
+            answers[i], offset);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::collector_coordinator::operator =
+ */
+visus::power_overwhelming::collector_coordinator&
+visus::power_overwhelming::collector_coordinator::operator =(
+        _Inout_ collector_coordinator&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_coordinator::operator bool
+ */
+visus::power_overwhelming::collector_coordinator::operator bool(
+        void) const noexcept {
+    return (this->_impl != nullptr);
+}
@@ -0,0 +1,214 @@
+﻿// <copyright file="collector_coordinator_impl.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "collector_coordinator_impl.h"
+
+#include <stdexcept>
+#include <system_error>
+
+#include "power_overwhelming/convert_string.h"
+
+#include "on_exit.h"
+
+
+/*
+ * visus::power_overwhelming::detail::collector_coordinator_impl::node_type
+ * ::node_type
+ */
+visus::power_overwhelming::detail::collector_coordinator_impl::node_type
+::node_type(_In_ const coordination_socket socket)
+    : overflows(0), samples(0), socket(socket), start_deviation(0) { }
+
+
+/*
+ * ...::detail::collector_coordinator_impl::answer_timeout
+ */
+constexpr unsigned int visus::power_overwhelming::detail
+::collector_coordinator_impl::answer_timeout;
+
+
+/*
+ * ...::detail::collector_coordinator_impl::collector_coordinator_impl
+ */
+visus::power_overwhelming::detail::collector_coordinator_impl
+::collector_coordinator_impl(_In_ const int address_family,
+        _In_ const std::uint16_t sync_port)
+        : address_family(address_family), sync_port(sync_port) {
+#if defined(_WIN32)
+    WSADATA wsa_data = { };
+    auto status = ::WSAStartup(MAKEWORD(2, 2), &wsa_data);
+    if (status != 0) {
+        throw std::system_error(status, std::system_category());
+    }
+
+    auto guard_wsa_cleanup = on_exit([](void) { ::WSACleanup(); });
+#endif /* defined(_WIN32) */
+
+    this->synchroniser = time_synchroniser::create(address_family, sync_port);
+
+#if defined(_WIN32)
+    guard_wsa_cleanup.cancel();
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * ...::detail::collector_coordinator_impl::~collector_coordinator_impl
+ */
+visus::power_overwhelming::detail::collector_coordinator_impl
+::~collector_coordinator_impl(void) {
+    // The agents stop their collectors once the session is closed.
+    for (auto& n : this->nodes) {
+        close_socket(n.socket);
+    }
+
+#if defined(_WIN32)
+    ::WSACleanup();
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_coordinator_impl::add
+ */
+void visus::power_overwhelming::detail::collector_coordinator_impl::add(
+        _In_z_ const char *host, _In_ const std::uint16_t port) {
+    addrinfo hints = { };
+    hints.ai_family = this->address_family;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+
+    const auto service = std::to_string(port);
+    addrinfo *addresses = nullptr;
+    const auto status = ::getaddrinfo(host, service.c_str(), &hints,
+        &addresses);
+    if (status != 0) {
+#if defined(_WIN32)
+        throw std::system_error(status, std::system_category());
+#else /* defined(_WIN32) */
+        throw std::runtime_error(::gai_strerror(status));
+#endif /* defined(_WIN32) */
+    }
+
+    const auto guard_addresses = on_exit([addresses](void) {
+        ::freeaddrinfo(addresses);
+    });
+
+    // Use the first address we can connect to.
+    auto error = 0;
+    auto socket = static_cast<coordination_socket>(INVALID_SOCKET);
+    for (auto a = addresses; a != nullptr; a = a->ai_next) {
+        socket = ::socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (socket == INVALID_SOCKET) {
+            error = get_socket_error();
+            continue;
+        }
+
+        if (::connect(socket, a->ai_addr, static_cast<int>(a->ai_addrlen))
+                != SOCKET_ERROR) {
+            break;
+        }
+
+        error = get_socket_error();
+        close_socket(socket);
+        socket = INVALID_SOCKET;
+    }
+
+    if (socket == INVALID_SOCKET) {
+        if (error == 0) {
+            throw std::runtime_error("The address of the agent could not be "
+                "resolved.");
+        }
+        throw std::system_error(error, std::system_category());
+    }
+
+    auto guard_socket = on_exit([socket](void) { close_socket(socket); });
+
+    {
+        int value = 1;
+        ::setsockopt(socket, IPPROTO_TCP, TCP_NODELAY,
+            reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+    coordination_timeout(socket, answer_timeout);
+
+    // The greeting tells the agent where to synchronise its clock.
+    node_type node(socket);
+    std::vector<std::uint8_t> payload;
+    coordination_append(payload, this->sync_port);
+    coordination_send(socket, coordination_message::hello, payload);
+    this->receive(node, coordination_message::welcome, payload);
+
+    std::size_t offset = 0;
+    node.name = coordination_read_string(payload, offset);
+
+    this->nodes.push_back(node);
+    guard_socket.cancel();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_coordinator_impl::broadcast
+ */
+void visus::power_overwhelming::detail::collector_coordinator_impl::broadcast(
+        _In_ const coordination_message request,
+        _In_ const std::vector<std::uint8_t>& payload,
+        _In_ const coordination_message expected,
+        _In_ const unsigned int lead,
+        _Out_ std::vector<std::vector<std::uint8_t>>& answers) {
+    answers.resize(this->nodes.size());
+
+    // Send all requests before waiting for the first answer, because the
+    // agents might block until the instant of the request.
+    for (auto& n : this->nodes) {
+        coordination_timeout(n.socket, lead + answer_timeout);
+        coordination_send(n.socket, request, payload);
+    }
+
+    for (std::size_t i = 0; i < this->nodes.size(); ++i) {
+        this->receive(this->nodes[i], expected, answers[i]);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_coordinator_impl::node
+ */
+const visus::power_overwhelming::detail::collector_coordinator_impl
+::node_type&
+visus::power_overwhelming::detail::collector_coordinator_impl::node(
+        _In_ const std::size_t node) const {
+    if (node >= this->nodes.size()) {
+        throw std::out_of_range("The node index is out of range.");
+    }
+
+    return this->nodes[node];
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_coordinator_impl::receive
+ */
+void visus::power_overwhelming::detail::collector_coordinator_impl::receive(
+        _In_ const node_type& node,
+        _In_ const coordination_message expected,
+        _Out_ std::vector<std::uint8_t>& answer) {
+    coordination_message type;
+
+    if (!coordination_receive(node.socket, type, answer)) {
+        throw std::runtime_error("A collector agent did not answer in time.");
+    }
+
+    if (type == coordination_message::error) {
+        std::size_t offset = 0;
+        const auto message = coordination_read_string(answer, offset);
+        throw std::runtime_error(power_overwhelming::convert_string<char>(
+            message));
+    }
+
+    if (type != expected) {
+        throw std::runtime_error("A collector agent sent an unexpected "
+            "answer.");
+    }
+}
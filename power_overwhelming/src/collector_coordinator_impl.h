@@ -0,0 +1,127 @@
+﻿// <copyright file="collector_coordinator_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <string>
+#include <vector>
+
+// WinSock2.h must be included before Windows.h.
+#include "coordination_protocol.h"
+
+#include "power_overwhelming/time_synchroniser.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The private state of a <see cref="collector_coordinator" />.
+    /// </summary>
+    struct collector_coordinator_impl final {
+
+        /// <summary>
+        /// The state of a node running a <see cref="collector_agent" />.
+        /// </summary>
+        struct node_type {
+            std::wstring name;
+            std::uint64_t overflows;
+            std::uint64_t samples;
+            coordination_socket socket;
+            timestamp_type start_deviation;
+
+            explicit node_type(_In_ const coordination_socket socket);
+        };
+
+        /// <summary>
+        /// The time in milliseconds an agent may take to answer in addition
+        /// to the lead time of the request.
+        /// </summary>
+        static constexpr unsigned int answer_timeout = 10000;
+
+        /// <summary>
+        /// The address family used for connecting to the agents.
+        /// </summary>
+        int address_family;
+
+        /// <summary>
+        /// The nodes that have been added.
+        /// </summary>
+        std::vector<node_type> nodes;
+
+        /// <summary>
+        /// The time synchroniser answering the requests of the agents.
+        /// </summary>
+        time_synchroniser synchroniser;
+
+        /// <summary>
+        /// The UDP port of the <see cref="synchroniser" />.
+        /// </summary>
+        std::uint16_t sync_port;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <exception cref="std::system_error">If the socket library could
+        /// not be initialised.</exception>
+        collector_coordinator_impl(_In_ const int address_family,
+            _In_ const std::uint16_t sync_port);
+
+        collector_coordinator_impl(const collector_coordinator_impl&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~collector_coordinator_impl(void);
+
+        /// <summary>
+        /// Connects to an agent and opens the session.
+        /// </summary>
+        void add(_In_z_ const char *host, _In_ const std::uint16_t port);
+
+        /// <summary>
+        /// Sends a request to all nodes and receives their answers.
+        /// </summary>
+        /// <param name="request">The type of the request.</param>
+        /// <param name="payload">The payload of the request.</param>
+        /// <param name="expected">The type of the answer on success.</param>
+        /// <param name="lead">The time in milliseconds until the request is
+        /// executed, which extends the time the agents may take to answer.
+        /// </param>
+        /// <param name="answers">Receives the payloads of the answers in the
+        /// order of the <see cref="nodes" />.</param>
+        /// <exception cref="std::runtime_error">If any agent reports an
+        /// error or does not answer in time.</exception>
+        void broadcast(_In_ const coordination_message request,
+            _In_ const std::vector<std::uint8_t>& payload,
+            _In_ const coordination_message expected,
+            _In_ const unsigned int lead,
+            _Out_ std::vector<std::vector<std::uint8_t>>& answers);
+
+        /// <summary>
+        /// Answer the node with the given index.
+        /// </summary>
+        /// <exception cref="std::out_of_range">If <paramref name="node" />
+        /// is not a valid index.</exception>
+        const node_type& node(_In_ const std::size_t node) const;
+
+        collector_coordinator_impl& operator =(
+            const collector_coordinator_impl&) = delete;
+
+    private:
+
+        /// <summary>
+        /// Receives the answer to a request.
+        /// </summary>
+        void receive(_In_ const node_type& node,
+            _In_ const coordination_message expected,
+            _Out_ std::vector<std::uint8_t>& answer);
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
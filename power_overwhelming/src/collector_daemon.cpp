@@ -0,0 +1,100 @@
+﻿// <copyright file="collector_daemon.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/collector_daemon.h"
+
+#include <memory>
+#include <stdexcept>
+
+#include "collector_daemon_impl.h"
+
+
+/*
+ * visus::power_overwhelming::collector_daemon::default_channel
+ */
+constexpr const wchar_t *visus::power_overwhelming::collector_daemon
+::default_channel;
+
+
+/*
+ * visus::power_overwhelming::collector_daemon::collector_daemon
+ */
+visus::power_overwhelming::collector_daemon::collector_daemon(void)
+    : _impl(new detail::collector_daemon_impl()) { }
+
+
+/*
+ * visus::power_overwhelming::collector_daemon::~collector_daemon
+ */
+visus::power_overwhelming::collector_daemon::~collector_daemon(void) {
+    this->stop();
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_daemon::start
+ */
+void visus::power_overwhelming::collector_daemon::start(
+        _In_ collector& collector,
+        _In_z_ const wchar_t *channel) {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("A collector_daemon which has been disposed "
+            "by a move operation cannot be started.");
+    }
+
+    if (!collector) {
+        throw std::invalid_argument("A disposed collector cannot be served "
+            "by a daemon.");
+    }
+
+    if ((channel == nullptr) || (*channel == 0)) {
+        throw std::invalid_argument("The name of the control segment must not "
+            "be empty.");
+    }
+
+    if (this->_impl->running.load()) {
+        throw std::logic_error("The collector_daemon is already running.");
+    }
+
+    this->_impl->collector = std::addressof(collector);
+    this->_impl->start(channel);
+}
+
+
+/*
+ * visus::power_overwhelming::collector_daemon::stop
+ */
+void visus::power_overwhelming::collector_daemon::stop(void) noexcept {
+    if (this->_impl != nullptr) {
+        this->_impl->stop();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::collector_daemon::operator =
+ */
+visus::power_overwhelming::collector_daemon&
+visus::power_overwhelming::collector_daemon::operator =(
+        _Inout_ collector_daemon&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        this->stop();
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_daemon::operator bool
+ */
+visus::power_overwhelming::collector_daemon::operator bool(
+        void) const noexcept {
+    return (this->_impl != nullptr);
+}
@@ -0,0 +1,332 @@
+﻿// <copyright file="collector_daemon_impl.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "collector_daemon_impl.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <cerrno>
+
+#include <signal.h>
+#endif /* !defined(_WIN32) */
+
+#include "power_overwhelming/convert_string.h"
+
+#include "library_thread.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Answer whether the process with the given ID is still running.
+    /// </summary>
+    /// <remarks>
+    /// If in doubt, the process is considered running, because releasing the
+    /// slot of a living client is worse than waiting for the timeout.
+    /// </remarks>
+    static bool is_running(_In_ const std::uint64_t pid) noexcept {
+#if defined(_WIN32)
+        auto process = ::OpenProcess(SYNCHRONIZE, FALSE,
+            static_cast<DWORD>(pid));
+        if (process == NULL) {
+            return (::GetLastError() != ERROR_INVALID_PARAMETER);
+        }
+
+        const auto retval = (::WaitForSingleObject(process, 0) == WAIT_TIMEOUT);
+        ::CloseHandle(process);
+        return retval;
+
+#else /* defined(_WIN32) */
+        const auto process = static_cast<pid_t>(pid);
+        if ((process <= 0) || (static_cast<std::uint64_t>(process) != pid)) {
+            // This cannot be a valid process.
+            return false;
+        }
+
+        return ((::kill(process, 0) == 0) || (errno != ESRCH));
+#endif /* defined(_WIN32) */
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * ...::detail::collector_daemon_impl::abandon_grace
+ */
+constexpr unsigned int
+visus::power_overwhelming::detail::collector_daemon_impl::abandon_grace;
+
+
+/*
+ * ...::detail::collector_daemon_impl::abandon_timeout
+ */
+constexpr unsigned int
+visus::power_overwhelming::detail::collector_daemon_impl::abandon_timeout;
+
+
+/*
+ * visus::power_overwhelming::detail::collector_daemon_impl::poll_interval
+ */
+constexpr unsigned int
+visus::power_overwhelming::detail::collector_daemon_impl::poll_interval;
+
+
+/*
+ * ...::detail::collector_daemon_impl::collector_daemon_impl
+ */
+visus::power_overwhelming::detail::collector_daemon_impl
+::collector_daemon_impl(void)
+    : collector(nullptr), header(nullptr), running(false) {
+    this->observed.state = static_cast<std::uint32_t>(
+        collector_daemon_state::idle);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_daemon_impl::handle
+ */
+void visus::power_overwhelming::detail::collector_daemon_impl::handle(void) {
+    assert(this->collector != nullptr);
+    assert(this->header != nullptr);
+    auto& header = *this->header;
+    header.status = 0;
+    header.message[0] = 0;
+
+    try {
+        switch (static_cast<collector_daemon_request>(header.request)) {
+            case collector_daemon_request::start: {
+                if (header.recording.load(std::memory_order_relaxed) != 0) {
+                    throw std::logic_error("A recording is already running.");
+                }
+
+                const auto len = std::find(header.name, header.name
+                    + sizeof(header.name), 0) - header.name;
+                const auto path = this->path_of(power_overwhelming::
+                    convert_string<wchar_t>(std::string(header.name, len)));
+
+                this->collector->output_path(path.c_str());
+                this->collector->start();
+                header.recording.store(1, std::memory_order_release);
+                } break;
+
+            case collector_daemon_request::stop:
+                if (header.recording.load(std::memory_order_relaxed) == 0) {
+                    throw std::logic_error("No recording is running.");
+                }
+
+                this->collector->stop();
+                header.recording.store(0, std::memory_order_release);
+                header.samples = this->collector->samples();
+                header.overflows = this->collector->overflows();
+                break;
+
+            default:
+                throw std::runtime_error("The client sent an unknown "
+                    "request.");
+        }
+    } catch (std::exception& ex) {
+        const auto len = (std::min)(std::strlen(ex.what()),
+            sizeof(header.message) - 1);
+        std::memcpy(header.message, ex.what(), len);
+        header.message[len] = 0;
+        header.status = 1;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_daemon_impl::path_of
+ */
+std::wstring visus::power_overwhelming::detail::collector_daemon_impl::path_of(
+        _In_ const std::wstring& name) const {
+    // The clients must not be able to write anywhere else than the directory
+    // of the configured output.
+    const auto invalid = name.empty()
+        || (name == L".")
+        || (name == L"..")
+        || (name.find_first_of(L"/\\:") != std::wstring::npos);
+    if (invalid) {
+        throw std::invalid_argument("The name of a recording must be a valid "
+            "file name.");
+    }
+
+    return this->directory + name + this->extension;
+}
+
+
+/*
+ * ...::detail::collector_daemon_impl::release_abandoned
+ */
+void visus::power_overwhelming::detail::collector_daemon_impl
+::release_abandoned(_In_ const std::uint32_t state) {
+    using namespace std::chrono;
+    const auto claimed = static_cast<std::uint32_t>(
+        collector_daemon_state::claimed);
+    const auto completed = static_cast<std::uint32_t>(
+        collector_daemon_state::completed);
+    const auto now = steady_clock::now();
+    const auto owner = this->header->owner.load(std::memory_order_relaxed);
+    const auto claim_time = this->header->claim_time.load(
+        std::memory_order_relaxed);
+
+    // Any change of the slot restarts the observation, which makes sure that
+    // we never act on the owner of a previous claim.
+    const auto changed = (state != this->observed.state)
+        || (owner != this->observed.owner)
+        || (claim_time != this->observed.claim_time);
+    if (changed) {
+        this->observed.claim_time = claim_time;
+        this->observed.owner = owner;
+        this->observed.since = now;
+        this->observed.state = state;
+        return;
+    }
+
+    // Only the clients move the slot on from these states.
+    if ((state != claimed) && (state != completed)) {
+        return;
+    }
+
+    const auto age = now - this->observed.since;
+    const auto abandoned = (age >= milliseconds(abandon_timeout))
+        || ((age >= milliseconds(abandon_grace)) && !is_running(owner));
+    if (abandoned) {
+        // The client might move on right now, so we must not overwrite what
+        // it did.
+        auto expected = state;
+        this->header->state.compare_exchange_strong(expected,
+            static_cast<std::uint32_t>(collector_daemon_state::idle),
+            std::memory_order_acq_rel, std::memory_order_relaxed);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_daemon_impl::serve
+ */
+void visus::power_overwhelming::detail::collector_daemon_impl::serve(void) {
+    enter_library_thread("PwrOwg Collector Daemon Thread");
+
+    const auto requested = static_cast<std::uint32_t>(
+        collector_daemon_state::requested);
+    const auto processing = static_cast<std::uint32_t>(
+        collector_daemon_state::processing);
+
+    while (this->running.load(std::memory_order_acquire)) {
+        // A client that gave up waiting withdraws its request, so we must
+        // claim it before we act on it.
+        auto expected = requested;
+        if (!this->header->state.compare_exchange_strong(expected, processing,
+                std::memory_order_acquire, std::memory_order_relaxed)) {
+            this->release_abandoned(expected);
+            std::this_thread::sleep_for(std::chrono::milliseconds(
+                poll_interval));
+            continue;
+        }
+
+        this->handle();
+        this->header->state.store(static_cast<std::uint32_t>(
+            collector_daemon_state::completed), std::memory_order_release);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_daemon_impl::start
+ */
+void visus::power_overwhelming::detail::collector_daemon_impl::start(
+        _In_z_ const wchar_t *channel) {
+    assert(!this->running.load());
+    assert(this->collector != nullptr);
+
+    // The recordings replace the file name of the configured output, but
+    // retain its directory and its extension.
+    {
+        const std::wstring output(this->collector->output_path());
+        const auto separator = output.find_last_of(L"/\\");
+        const auto name = (separator == std::wstring::npos)
+            ? 0
+            : separator + 1;
+        const auto dot = output.find_last_of(L'.');
+        this->directory = output.substr(0, name);
+        this->extension = ((dot != std::wstring::npos) && (dot > name))
+            ? output.substr(dot)
+            : std::wstring();
+    }
+
+    const auto marker_channel = (this->collector->marker_channel() != nullptr)
+        ? power_overwhelming::convert_string<char>(
+            this->collector->marker_channel())
+        : std::string();
+    const auto shared_memory = (this->collector->shared_memory() != nullptr)
+        ? power_overwhelming::convert_string<char>(
+            this->collector->shared_memory())
+        : std::string();
+    if ((marker_channel.size() >= collector_daemon_header::max_name)
+            || (shared_memory.size() >= collector_daemon_header::max_name)) {
+        throw std::invalid_argument("The names of the shared memory segments "
+            "of the collector are too long to be advertised by the daemon.");
+    }
+
+    this->segment.create(channel, sizeof(collector_daemon_header));
+
+    // Fresh segments are zero-filled, so the request slot is idle and we only
+    // need to fill the header.
+    this->header = static_cast<collector_daemon_header *>(
+        this->segment.data());
+    ::memcpy(this->header->magic, collector_daemon_magic,
+        sizeof(this->header->magic));
+    this->header->version = collector_daemon_version;
+    ::memcpy(this->header->marker_channel, marker_channel.c_str(),
+        marker_channel.size() + 1);
+    ::memcpy(this->header->shared_memory, shared_memory.c_str(),
+        shared_memory.size() + 1);
+
+    this->running.store(true, std::memory_order_release);
+
+    try {
+        this->server = std::thread([this](void) { this->serve(); });
+    } catch (...) {
+        this->running.store(false, std::memory_order_release);
+        this->header = nullptr;
+        this->segment.close();
+        throw;
+    }
+
+    this->header->active.store(1, std::memory_order_release);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_daemon_impl::stop
+ */
+void visus::power_overwhelming::detail::collector_daemon_impl::stop(
+        void) noexcept {
+    if (this->running.exchange(false, std::memory_order_acq_rel)) {
+        this->server.join();
+
+        // Clients that keep the segment mapped can detect that their requests
+        // are not served any more.
+        this->header->active.store(0, std::memory_order_release);
+
+        if (this->header->recording.exchange(0) != 0) {
+            try {
+                this->collector->stop();
+            } catch (...) { /* We need to exit anyway. */ }
+        }
+
+        this->header = nullptr;
+        this->segment.close();
+    }
+}
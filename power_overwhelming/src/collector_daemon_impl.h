@@ -0,0 +1,155 @@
+﻿// <copyright file="collector_daemon_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "power_overwhelming/collector.h"
+#include "power_overwhelming/collector_client.h"
+
+#include "shared_memory_segment.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The private state of a <see cref="collector_daemon" />.
+    /// </summary>
+    struct collector_daemon_impl final {
+
+        /// <summary>
+        /// The time in milliseconds that the request slot must remain
+        /// unchanged before the daemon releases it if its owner has exited.
+        /// </summary>
+        /// <remarks>
+        /// The owner is recorded after the slot has been claimed, so the
+        /// daemon must give the client a moment to do so.
+        /// </remarks>
+        static constexpr unsigned int abandon_grace = 100;
+
+        /// <summary>
+        /// The time in milliseconds after which the daemon releases the
+        /// request slot if it has remained unchanged even though its owner is
+        /// still running.
+        /// </summary>
+        /// <remarks>
+        /// Healthy clients hold the slot for microseconds, so this only
+        /// applies to clients that hang. The timeout is longer than the
+        /// default timeout of the clients, because such a client must not
+        /// lose its slot while it is only slow.
+        /// </remarks>
+        static constexpr unsigned int abandon_timeout = 10000;
+
+        /// <summary>
+        /// The time in milliseconds between two checks for a request.
+        /// </summary>
+        static constexpr unsigned int poll_interval = 1;
+
+        /// <summary>
+        /// The state of the request slot as the daemon has last seen it while
+        /// waiting for a request.
+        /// </summary>
+        struct observation_type final {
+            std::uint64_t claim_time;
+            std::uint64_t owner;
+            std::chrono::steady_clock::time_point since;
+            std::uint32_t state;
+        };
+
+        /// <summary>
+        /// The collector controlled by the clients.
+        /// </summary>
+        power_overwhelming::collector *collector;
+
+        /// <summary>
+        /// The directory of the configured output including the trailing
+        /// separator, which is the directory of all recordings.
+        /// </summary>
+        std::wstring directory;
+
+        /// <summary>
+        /// The extension of the configured output including the dot, which
+        /// is appended to the names of all recordings.
+        /// </summary>
+        std::wstring extension;
+
+        /// <summary>
+        /// The header of the control <see cref="segment" />.
+        /// </summary>
+        collector_daemon_header *header;
+
+        /// <summary>
+        /// The state of the request slot when it was first seen unchanged.
+        /// </summary>
+        observation_type observed;
+
+        /// <summary>
+        /// Indicates whether the <see cref="server" /> should continue
+        /// serving requests.
+        /// </summary>
+        std::atomic<bool> running;
+
+        /// <summary>
+        /// The control segment shared with the clients.
+        /// </summary>
+        shared_memory_segment segment;
+
+        /// <summary>
+        /// The thread executing <see cref="serve" />.
+        /// </summary>
+        std::thread server;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        collector_daemon_impl(void);
+
+        /// <summary>
+        /// Executes the request in the control segment and fills in the
+        /// response.
+        /// </summary>
+        void handle(void);
+
+        /// <summary>
+        /// Answer the path of the output of the recording with the given
+        /// name.
+        /// </summary>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="name" /> is not a valid file name.</exception>
+        std::wstring path_of(_In_ const std::wstring& name) const;
+
+        /// <summary>
+        /// Releases the request slot if the client holding it has died or if
+        /// it has not moved on for <see cref="abandon_timeout" />.
+        /// </summary>
+        /// <param name="state">The state of the slot that has been found
+        /// while checking for a request.</param>
+        void release_abandoned(_In_ const std::uint32_t state);
+
+        /// <summary>
+        /// The body of the <see cref="server" /> thread.
+        /// </summary>
+        void serve(void);
+
+        /// <summary>
+        /// Creates the control segment and starts serving requests.
+        /// </summary>
+        void start(_In_z_ const wchar_t *channel);
+
+        /// <summary>
+        /// Stops the server and the running recording.
+        /// </summary>
+        void stop(void) noexcept;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
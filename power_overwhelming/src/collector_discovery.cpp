@@ -0,0 +1,191 @@
+﻿// <copyright file="collector_discovery.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/collector_discovery.h"
+
+#include <cassert>
+#include <chrono>
+#include <stdexcept>
+
+#include "collector_discovery_impl.h"
+
+
+/*
+ * visus::power_overwhelming::detail::complete_discovery
+ */
+void visus::power_overwhelming::detail::complete_discovery(
+        _In_ const std::shared_ptr<collector_discovery_state>& state,
+        _In_ collector&& result,
+        _In_ std::exception_ptr error) noexcept {
+    assert(state != nullptr);
+
+    {
+        std::lock_guard<decltype(state->lock)> l(state->lock);
+        if (state->cancelled.load()) {
+            state->error = std::make_exception_ptr(std::runtime_error(
+                "The discovery of the sensors has been cancelled."));
+        } else if (error != nullptr) {
+            state->error = error;
+        } else {
+            state->result = std::move(result);
+        }
+
+        state->done = true;
+    }
+
+    state->completed.notify_all();
+
+    if (state->callback != nullptr) {
+        try {
+            auto discovery = collector_discovery_impl::create(state);
+            state->callback(discovery, state->context);
+        } catch (...) { /* The callback must not stop the thread. */ }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::collector_discovery::collector_discovery
+ */
+visus::power_overwhelming::collector_discovery::collector_discovery(
+        _In_ const collector_discovery& rhs)
+    : _impl((rhs._impl != nullptr)
+        ? new detail::collector_discovery_impl(rhs._impl->state)
+        : nullptr) { }
+
+
+/*
+ * visus::power_overwhelming::collector_discovery::~collector_discovery
+ */
+visus::power_overwhelming::collector_discovery::~collector_discovery(void) {
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_discovery::cancel
+ */
+bool visus::power_overwhelming::collector_discovery::cancel(void) noexcept {
+    if (this->_impl == nullptr) {
+        return false;
+    }
+
+    auto& state = *this->_impl->state;
+    std::lock_guard<decltype(state.lock)> l(state.lock);
+    if (state.done) {
+        return false;
+    }
+
+    state.cancelled.store(true);
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_discovery::cancelled
+ */
+bool visus::power_overwhelming::collector_discovery::cancelled(
+        void) const noexcept {
+    return (this->_impl != nullptr) && this->_impl->state->cancelled.load();
+}
+
+
+/*
+ * visus::power_overwhelming::collector_discovery::get
+ */
+visus::power_overwhelming::collector
+visus::power_overwhelming::collector_discovery::get(void) {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("The collector cannot be retrieved from a "
+            "handle that does not refer to a discovery.");
+    }
+
+    auto& state = *this->_impl->state;
+    std::unique_lock<decltype(state.lock)> l(state.lock);
+    state.completed.wait(l, [&state](void) { return state.done; });
+
+    if (state.error != nullptr) {
+        std::rethrow_exception(state.error);
+    }
+
+    if (state.retrieved) {
+        throw std::logic_error("The collector has already been retrieved from "
+            "the discovery.");
+    }
+
+    state.retrieved = true;
+    return std::move(state.result);
+}
+
+
+/*
+ * visus::power_overwhelming::collector_discovery::ready
+ */
+bool visus::power_overwhelming::collector_discovery::ready(
+        void) const noexcept {
+    if (this->_impl == nullptr) {
+        return false;
+    }
+
+    auto& state = *this->_impl->state;
+    std::lock_guard<decltype(state.lock)> l(state.lock);
+    return state.done;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_discovery::wait
+ */
+bool visus::power_overwhelming::collector_discovery::wait(
+        _In_ const std::uint32_t timeout) const {
+    if (this->_impl == nullptr) {
+        return false;
+    }
+
+    auto& state = *this->_impl->state;
+    std::unique_lock<decltype(state.lock)> l(state.lock);
+    return state.completed.wait_for(l, std::chrono::milliseconds(timeout),
+        [&state](void) { return state.done; });
+}
+
+
+/*
+ * visus::power_overwhelming::collector_discovery::operator =
+ */
+visus::power_overwhelming::collector_discovery&
+visus::power_overwhelming::collector_discovery::operator =(
+        _In_ const collector_discovery& rhs) {
+    if (this != std::addressof(rhs)) {
+        collector_discovery copy(rhs);
+        *this = std::move(copy);
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_discovery::operator =
+ */
+visus::power_overwhelming::collector_discovery&
+visus::power_overwhelming::collector_discovery::operator =(
+        _In_ collector_discovery&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_discovery::operator bool
+ */
+visus::power_overwhelming::collector_discovery::operator bool(
+        void) const noexcept {
+    return (this->_impl != nullptr);
+}
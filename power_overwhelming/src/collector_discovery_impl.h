@@ -0,0 +1,137 @@
+﻿// <copyright file="collector_discovery_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+#include "power_overwhelming/collector.h"
+#include "power_overwhelming/collector_discovery.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The state of a discovery that is shared between all handles and the
+    /// thread running the discovery.
+    /// </summary>
+    struct collector_discovery_state final {
+
+        /// <summary>
+        /// The callback to be invoked on completion, which may be
+        /// <c>nullptr</c>.
+        /// </summary>
+        collector_discovery::callback_type callback;
+
+        /// <summary>
+        /// Requests the discovery to stop.
+        /// </summary>
+        std::atomic<bool> cancelled;
+
+        /// <summary>
+        /// Signals that <see cref="done" /> has been set.
+        /// </summary>
+        std::condition_variable completed;
+
+        /// <summary>
+        /// The user-defined pointer passed to <see cref="callback" />.
+        /// </summary>
+        void *context;
+
+        /// <summary>
+        /// Indicates that the discovery has finished, either with
+        /// <see cref="result" /> or with <see cref="error" />.
+        /// </summary>
+        bool done;
+
+        /// <summary>
+        /// The exception that stopped the discovery, if any.
+        /// </summary>
+        std::exception_ptr error;
+
+        /// <summary>
+        /// Protects <see cref="done" />, <see cref="error" />,
+        /// <see cref="result" /> and <see cref="retrieved" />.
+        /// </summary>
+        std::mutex lock;
+
+        /// <summary>
+        /// The collector that has been created.
+        /// </summary>
+        collector result;
+
+        /// <summary>
+        /// Indicates that <see cref="result" /> has been moved out.
+        /// </summary>
+        bool retrieved;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        inline collector_discovery_state(
+                _In_opt_ const collector_discovery::callback_type callback,
+                _In_opt_ void *context)
+            : callback(callback), cancelled(false), context(context),
+            done(false), retrieved(false) { }
+    };
+
+
+    /// <summary>
+    /// The implementation of a <see cref="collector_discovery" /> handle.
+    /// </summary>
+    struct collector_discovery_impl final {
+
+        /// <summary>
+        /// Creates a new handle for the given discovery.
+        /// </summary>
+        /// <param name="state">The state of the discovery.</param>
+        /// <returns>A new handle.</returns>
+        static inline collector_discovery create(
+                _In_ std::shared_ptr<collector_discovery_state> state) {
+            return collector_discovery(new collector_discovery_impl(
+                std::move(state)));
+        }
+
+        /// <summary>
+        /// The state of the discovery.
+        /// </summary>
+        std::shared_ptr<collector_discovery_state> state;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        inline explicit collector_discovery_impl(
+                _In_ std::shared_ptr<collector_discovery_state> state)
+            : state(std::move(state)) { }
+    };
+
+
+    /// <summary>
+    /// Publishes the outcome of a discovery to all handles and invokes the
+    /// completion callback.
+    /// </summary>
+    /// <remarks>
+    /// If the discovery has been cancelled, <paramref name="result" /> is
+    /// discarded and the handles report the cancellation instead.
+    /// </remarks>
+    /// <param name="state">The state of the discovery.</param>
+    /// <param name="result">The collector that has been created, which is
+    /// ignored if <paramref name="error" /> is set.</param>
+    /// <param name="error">The exception that stopped the discovery, or
+    /// <c>nullptr</c> if it succeeded.</param>
+    void complete_discovery(
+        _In_ const std::shared_ptr<collector_discovery_state>& state,
+        _In_ collector&& result,
+        _In_ std::exception_ptr error) noexcept;
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -5,16 +5,128 @@
 
 #include "collector_impl.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cwchar>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <stdexcept>
 #include <system_error>
+#include <unordered_map>
 
-#include "power_overwhelming/adl_sensor.h"
-#include "power_overwhelming/emi_sensor.h"
 #include "power_overwhelming/collector.h"
 #include "power_overwhelming/convert_string.h"
-#include "power_overwhelming/nvml_sensor.h"
-#include "power_overwhelming/hmc8015_sensor.h"
-#include "power_overwhelming/tinkerforge_sensor.h"
+#include "power_overwhelming/multi_channel_sensor.h"
+
+#include "cupti_kernel_tracer.h"
+#include "hmc8015_log.h"
+#include "library_thread.h"
+#include "on_exit.h"
+#include "process_energy_integrator.h"
+#include "sampler_instrumentation.h"
+#include "sampler_scheduler.h"
+#include "nvml_exception.h"
+#include "sensor_capability.h"
+#include "sensor_desc.h"
+#include "sensor_name_registry.h"
+#include "sensor_utilities.h"
+#include "start_barrier.h"
+#include "system_trace.h"
+#include "timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The context passed to <see cref="on_instrument_log_entry" />.
+    /// </summary>
+    struct instrument_log_context final {
+        const collector_impl::instrument_log *log;
+        const wchar_t *name;
+        collector_impl *that;
+        double ticks_per_second;
+    };
+
+    /// <summary>
+    /// Converts an entry of an HMC8015 log into a sample for the collector.
+    /// </summary>
+    static void on_instrument_log_entry(const hmc8015_log_entry& entry,
+            void *context) {
+        auto ctx = static_cast<instrument_log_context *>(context);
+        assert(ctx != nullptr);
+        const auto timestamp = ctx->log->start + static_cast<timestamp_type>(
+            entry.offset * ctx->ticks_per_second);
+
+        if (timestamp >= ctx->that->start_time.load(
+                std::memory_order::memory_order_relaxed)) {
+            ctx->that->instrument_samples.emplace_back(ctx->name, timestamp,
+                entry.voltage, entry.current, entry.power);
+        }
+    }
+
+    /// <summary>
+    /// Appends a waveform downloaded by an <see cref="rtx_sensor" /> to the
+    /// archive of the collector.
+    /// </summary>
+    static void on_archived_waveform(const wchar_t *sensor,
+            const std::uint32_t channel,
+            const std::uint32_t segment,
+            const measurement::timestamp_type timestamp,
+            const oscilloscope_waveform& waveform,
+            void *context) {
+        auto that = static_cast<collector_impl *>(context);
+        assert(that != nullptr);
+
+        // The oscilloscope reports the trigger in milliseconds, but the
+        // archive should use the same resolution as the output.
+        const auto time = static_cast<timestamp_type>(timestamp
+            * ticks_per_second(that->timestamp_resolution) / 1000.0);
+
+        try {
+            that->archive.append(sensor, time, channel, segment, waveform);
+        } catch (...) { /* The waveform is lost, but sampling continues. */ }
+    }
+
+    /// <summary>
+    /// Finds the first of the deferred sensor descriptors in
+    /// <paramref name="descs" /> that has the given name.
+    /// </summary>
+    static nlohmann::json::iterator find_deferred(nlohmann::json& descs,
+            const wchar_t *name) {
+        assert(name != nullptr);
+        if (!descs.is_array()) {
+            return descs.end();
+        }
+
+        const auto n = power_overwhelming::convert_string<char>(name);
+        return std::find_if(descs.begin(), descs.end(),
+                [&n](const nlohmann::json& d) {
+            auto it = d.find(json_field_name);
+            return ((it != d.end()) && it->is_string()
+                && (it->get<std::string>() == n));
+        });
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::instrument_log_file
+ */
+constexpr const char *
+visus::power_overwhelming::detail::collector_impl::instrument_log_file;
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::marker_event_capacity
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::collector_impl::marker_event_capacity;
 
 
 /*
@@ -24,9 +136,33 @@ void visus::power_overwhelming::detail::collector_impl::on_measurement(
         const measurement& m, void *context) {
     auto that = static_cast<collector_impl *>(context);
 
+    if (that->can_buffer() && (m.timestamp() >= that->start_time.load(
+            std::memory_order::memory_order_relaxed))) {
+        that->push(m);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::on_measurement_data
+ */
+void visus::power_overwhelming::detail::collector_impl::on_measurement_data(
+        const wchar_t *sensor, const measurement_data *samples,
+        const std::size_t cnt, void *context) {
+    assert((samples != nullptr) || (cnt == 0));
+    auto that = static_cast<collector_impl *>(context);
+
     if (that->can_buffer()) {
-        std::lock_guard<decltype(that->lock)> l(that->lock);
-        that->buffer.push_back(m);
+        // Discard samples that sensors delivered before all of them have been
+        // released to start at a common timestamp.
+        const auto start_time = that->start_time.load(
+            std::memory_order::memory_order_relaxed);
+
+        for (std::size_t i = 0; i < cnt; ++i) {
+            if (samples[i].timestamp() >= start_time) {
+                that->push(measurement(sensor, samples[i]));
+            }
+        }
     }
 }
 
@@ -35,16 +171,60 @@ void visus::power_overwhelming::detail::collector_impl::on_measurement(
  * visus::power_overwhelming::detail::collector_impl::collector_impl
  */
 visus::power_overwhelming::detail::collector_impl::collector_impl(void)
-        : evt_write(create_event(false, false)),
-        have_marker(false), running(false), sampling_interval(0),
-        require_marker(false),
-        timestamp_resolution(default_timestamp_resolution) { }
+        : aggregate_only(false), aggregation_window(0),
+        align_timestamps(false), binary_stream(new binary_output_writer()),
+        buffer_size(collector_settings::default_buffer_size),
+        bytes_written(0), compress_waveforms(false),
+        estimate_power(false), evt_experiment(create_event(false, false)),
+        evt_write(create_event(false, false)), experiment_interval(0),
+        experiment_window(0),
+        format(output_format::csv), have_marker(false),
+        integrate_energy(false), integrate_instruments(false),
+        integrator_marker(0), integrator_phase(0), keep_alive_interval(0),
+        limit_to_native_interval(false), lock_memory(false),
+        manual_pump(false), marker_event_count(0),
+        merge_instrument_logs(false), min_sampling_interval(0),
+        paused(false),
+        post_trigger(0), pre_trigger(0), pumped_scheduler(false),
+        running(false),
+        sampling_interval(0), samples(0), statistics_elapsed(0),
+        record_overhead(false),
+        require_marker(false), resampling_interval(0),
+        retain_unfiltered(false), rotate_interval(0), rotate_size(0),
+        suppress_duplicates(false),
+        start_time((std::numeric_limits<measurement::timestamp_type>::max)()),
+        stream(new csv_output_writer()),
+        subscriber_capacity(collector_settings::default_subscriber_capacity),
+        timestamp_resolution(default_timestamp_resolution),
+        tinkerforge_arrival_times(false),
+        track_quantiles(false), track_sequences(false),
+        trigger_oscilloscopes(false),
+        trigger_threshold(0.0f),
+        write_latency(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::microseconds(
+            collector_settings::default_write_latency))),
+        write_statistics(false),
+        write_threshold(collector_settings::default_write_threshold),
+        writer_threads(1) {
+    static std::atomic<std::uint64_t> next_id(1);
+    this->id = next_id.fetch_add(1, std::memory_order_relaxed);
+
+    // Reserve the ID zero for samples without marker.
+    this->marker_names.emplace_back();
+    this->marker_events.reserve(marker_event_capacity);
+}
 
 
 /*
  * visus::power_overwhelming::detail::collector_impl::~collector_impl
  */
 visus::power_overwhelming::detail::collector_impl::~collector_impl(void) {
+    // Release subscribers waiting for samples that will never arrive.
+    if (this->subscribers != nullptr) {
+        this->subscribers->close();
+    }
+
+    destroy_event(this->evt_experiment);
     destroy_event(this->evt_write);
 }
 
@@ -55,17 +235,240 @@ visus::power_overwhelming::detail::collector_impl::~collector_impl(void) {
 void visus::power_overwhelming::detail::collector_impl::apply(
         const collector_settings& settings) {
     assert(settings.output_path() != nullptr);
-    auto output_path = settings.output_path();
-
-#if defined(_WIN32)
-    this->stream.open(output_path, std::ofstream::trunc);
-#else /* defined(_WIN32) */
-    auto p = power_overwhelming::convert_string<char>(output_path);
-    this->stream.open(p, std::ofstream::trunc);
-#endif /* defined(_WIN32) */
+    if (settings.require_marker() && (settings.overhead_report() != nullptr)) {
+        throw std::invalid_argument("An overhead experiment cannot be "
+            "performed if sampling requires a marker.");
+    }
 
+    this->open(settings.output_path(), settings.output_format());
+    this->aggregate_only = settings.aggregate_only();
+    this->aggregation_window = std::chrono::microseconds(
+        settings.aggregation_window());
+    this->align_timestamps = settings.align_timestamps();
+    this->binary_stream->compressed(settings.compress_output());
+    this->compress_waveforms = settings.compress_waveforms();
+    this->buffer_size = settings.buffer_size();
+    this->estimate_power = settings.estimate_power();
+    this->experiment_interval = std::chrono::microseconds(
+        settings.overhead_interval());
+    this->experiment_report = (settings.overhead_report() != nullptr)
+        ? settings.overhead_report()
+        : L"";
+    this->experiment_window = std::chrono::microseconds(
+        settings.overhead_window());
+    this->integrate_energy = settings.integrate_energy();
+    this->integrate_instruments = settings.integrate_instruments();
+    this->limit_to_native_interval = settings.limit_to_native_interval();
+    this->lock_memory = settings.lock_memory();
+    this->manual_pump = settings.manual_pump();
+    this->marker_channel_name = (settings.marker_channel() != nullptr)
+        ? settings.marker_channel()
+        : L"";
+    this->merge_instrument_logs = settings.merge_instrument_logs();
+    this->min_sampling_interval = std::chrono::microseconds(
+        settings.min_sampling_interval());
+    this->post_trigger = std::chrono::microseconds(settings.post_trigger());
+    this->pre_trigger = std::chrono::microseconds(settings.pre_trigger());
+    this->record_overhead = settings.record_overhead();
+    this->require_marker = settings.require_marker();
+    this->retain_unfiltered = settings.retain_unfiltered();
+    this->rotate_interval = std::chrono::microseconds(
+        settings.rotate_interval());
+    this->rotate_size = settings.rotate_size();
+    this->resampling_interval = std::chrono::microseconds(
+        settings.resampling_interval());
     this->sampling_interval = std::chrono::microseconds(
         settings.sampling_interval());
+    this->shared_memory_name = (settings.shared_memory() != nullptr)
+        ? settings.shared_memory()
+        : L"";
+    this->keep_alive_interval = std::chrono::microseconds(
+        settings.keep_alive_interval());
+    this->kernel_energy_path = (settings.kernel_energy() != nullptr)
+        ? settings.kernel_energy()
+        : L"";
+    this->process_energy_path = (settings.process_energy() != nullptr)
+        ? settings.process_energy()
+        : L"";
+    this->load_safe_intervals(settings.capability_report());
+    this->rate_budget = sampling_budget(settings.sampling_cpu_budget(),
+        settings.sampling_read_budget());
+    this->subscriber_capacity = settings.subscriber_capacity();
+    this->suppress_duplicates = settings.suppress_duplicates();
+    this->tinkerforge_arrival_times = settings.tinkerforge_arrival_times();
+    this->track_quantiles = settings.track_quantiles();
+    this->track_sequences = settings.track_sequences();
+    this->trigger_oscilloscopes = settings.trigger_oscilloscopes();
+    this->trigger_threshold = settings.trigger_threshold();
+    this->waveform_archive_path = (settings.waveform_archive() != nullptr)
+        ? settings.waveform_archive()
+        : L"";
+    this->write_latency = std::chrono::milliseconds(
+        (settings.write_latency() + 999) / 1000);
+    this->write_statistics = settings.write_statistics();
+    this->write_threshold = settings.write_threshold();
+    this->writer_threads = settings.writer_threads();
+
+    std::vector<const wchar_t *> names(settings.sensor_delays(nullptr, 0));
+    settings.sensor_delays(names.data(), names.size());
+    this->sensor_delays.clear();
+    for (auto n : names) {
+        this->sensor_delays[n] = std::chrono::microseconds(
+            settings.sensor_delay(n));
+    }
+
+    names.resize(settings.sensor_intervals(nullptr, 0));
+    settings.sensor_intervals(names.data(), names.size());
+    this->sensor_intervals.clear();
+    for (auto n : names) {
+        this->sensor_intervals[n] = std::chrono::microseconds(
+            settings.sensor_interval(n));
+    }
+
+    names.resize(settings.sensor_priorities(nullptr, 0));
+    settings.sensor_priorities(names.data(), names.size());
+    this->sensor_priorities.clear();
+    for (auto n : names) {
+        this->sensor_priorities[n] = settings.sensor_priority(n);
+    }
+
+    names.resize(settings.sensor_quantities(nullptr, 0));
+    settings.sensor_quantities(names.data(), names.size());
+    this->sensor_quantities.clear();
+    for (auto n : names) {
+        this->sensor_quantities[n] = settings.sensor_quantity(n);
+    }
+
+    names.resize(settings.delta_thresholds(nullptr, 0));
+    settings.delta_thresholds(names.data(), names.size());
+    this->delta_thresholds.clear();
+    for (auto n : names) {
+        this->delta_thresholds[n] = settings.delta_threshold(n);
+    }
+
+    names.resize(settings.filters(nullptr, 0));
+    settings.filters(names.data(), names.size());
+    this->sample_filters.clear();
+    for (auto n : names) {
+        this->sample_filters[n] = settings.filter(n);
+    }
+
+    names.resize(settings.derived_sensors(nullptr, 0));
+    settings.derived_sensors(names.data(), names.size());
+    this->derived.clear();
+    for (auto n : names) {
+        this->derived.add(n, settings.derived_sensor(n));
+    }
+
+    this->open_shards();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::apply_budget
+ */
+void visus::power_overwhelming::detail::collector_impl::apply_budget(
+        const std::vector<sensor *>& sensors) {
+    this->budget_intervals.clear();
+
+    if (!this->rate_budget.enabled()) {
+        return;
+    }
+
+    // The self-instrumentation knows the cost of the sensors that have been
+    // sampled before under the current load of the machine, which we prefer
+    // over the capability report.
+    std::vector<sampler_statistics_impl> statistics;
+    sampler_instrumentation::snapshot_all(statistics);
+    std::unordered_map<std::wstring, latency_histogram> measured;
+    for (auto& s : statistics) {
+        for (auto& d : s.sources) {
+            measured[d.first].merge(d.second);
+        }
+    }
+
+    std::vector<sampling_budget::request> requests;
+    std::vector<const sensor *> requesters;
+    requests.reserve(sensors.size());
+    requesters.reserve(sensors.size());
+
+    for (auto s : sensors) {
+        if (s == nullptr) {
+            continue;
+        }
+
+        sampling_budget::request request;
+        request.cost = 0.0;
+        request.interval = this->interval_of(s);
+        request.priority = this->priority_of(s);
+
+        if (s->name() != nullptr) {
+            auto m = measured.find(s->name());
+            if ((m != measured.end()) && (m->second.count() > 0)) {
+                // The histograms are in nanoseconds.
+                request.cost = m->second.mean() / 1000.0;
+            } else {
+                auto c = this->read_costs.find(s->name());
+                if (c != this->read_costs.end()) {
+                    request.cost = c->second;
+                }
+            }
+        }
+
+        requests.push_back(request);
+        requesters.push_back(s);
+    }
+
+    this->rate_budget.allocate(requests.data(), requests.size());
+
+    for (std::size_t i = 0; i < requests.size(); ++i) {
+        if (requests[i].granted > requests[i].interval) {
+            this->budget_intervals[requesters[i]] = requests[i].granted;
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::attach
+ */
+void visus::power_overwhelming::detail::collector_impl::attach(
+        std::unique_ptr<sensor>&& sensor) {
+    if (sensor == nullptr) {
+        throw std::invalid_argument("None of the sensors added to a collector "
+            "must be null.");
+    }
+    if (!*sensor) {
+        throw std::invalid_argument("None of the sensors added to a collector "
+            "must have been disposed.");
+    }
+
+    std::lock_guard<decltype(this->gate_lock)> l(this->gate_lock);
+    this->resolve_delta_threshold(sensor.get());
+    this->resolve_interval(sensor.get());
+    this->resolve_power_estimator(sensor.get());
+    this->resolve_quantities(sensor.get());
+    this->resolve_sample_filter(sensor.get());
+
+    if (this->running.load(std::memory_order::memory_order_acquire)) {
+        // Reserve the space first such that the sensor is not left running if
+        // we cannot remember it.
+        this->live_sensors.reserve(this->live_sensors.size() + 1);
+        this->sensors.reserve(this->sensors.size() + 1);
+
+        // Make room for the new sensor in the budget before it starts.
+        this->rebalance(sensor.get());
+
+        if (!this->paused) {
+            this->start_sampling({ sensor.get() });
+        }
+
+        this->live_sensors.push_back(sensor.get());
+        this->record(schema_change_type::added, *sensor,
+            this->sampled_interval_of(sensor.get()));
+    }
+
+    this->sensors.push_back(std::move(sensor));
 }
 
 
@@ -79,219 +482,2849 @@ bool visus::power_overwhelming::detail::collector_impl::can_buffer(void) const {
 
 
 /*
- * visus::power_overwhelming::detail::collector_impl::marker
+ * visus::power_overwhelming::detail::collector_impl::close
  */
-void visus::power_overwhelming::detail::collector_impl::marker(
-        const wchar_t *marker) {
-    const auto have_marker = (marker != nullptr);
+void visus::power_overwhelming::detail::collector_impl::close(void) {
+    switch (this->format) {
+        case output_format::binary:
+        case output_format::mapped_binary:
+        case output_format::async_binary:
+        case output_format::direct_binary:
+        case output_format::network_binary:
+            this->binary_stream->close();
+            break;
 
-    // Enable/disable collection of samples by other threads.
-    this->have_marker.store(have_marker,
-        std::memory_order::memory_order_release);
+        case output_format::perfetto:
+        case output_format::chrome_trace:
+            this->trace_stream.close();
+            break;
 
-    if (have_marker) {
-        // If we now have a marker, store it for the I/O thread to process.
-        std::lock_guard<decltype(this->lock)> l(this->lock);
-        this->markers.emplace_back(marker, this->buffer.size());
+        case output_format::arrow:
+            this->arrow_stream.close();
+            break;
 
-        // Wake the I/O thread, because if we start a new phase, it is typically
-        // a good idea to make sure that what we already have is persisted.
-        set_event(this->evt_write);
+        default:
+            this->stream->close();
+            break;
     }
 }
 
 
 /*
- * visus::power_overwhelming::detail::collector_impl::start
+ * visus::power_overwhelming::detail::collector_impl::detach
  */
-void visus::power_overwhelming::detail::collector_impl::start(void) {
-    using namespace std::chrono;
+bool visus::power_overwhelming::detail::collector_impl::detach(
+        const wchar_t *name) {
+    if (name == nullptr) {
+        throw std::invalid_argument("The name of the sensor to be removed "
+            "must not be null.");
+    }
+
+    // The sensor is destroyed after the lock has been released, because we do
+    // not know how long this takes.
+    std::unique_ptr<sensor> retval;
 
     {
-        auto expected = false;
-        if (!this->running.compare_exchange_strong(expected, true)) {
-            throw std::runtime_error("The power sample collector is already "
-                "running and cannot be restarted.");
+        std::lock_guard<decltype(this->gate_lock)> l(this->gate_lock);
+        auto it = std::find_if(this->sensors.begin(), this->sensors.end(),
+                [name](const std::unique_ptr<sensor>& s) {
+            auto n = s->name();
+            return ((n != nullptr) && (::wcscmp(n, name) == 0));
+        });
+        if (it == this->sensors.end()) {
+            // A sensor that has not been opened yet is simply forgotten.
+            auto d = find_deferred(this->deferred_sensors, name);
+            if (d == this->deferred_sensors.end()) {
+                return false;
+            }
+
+            this->deferred_sensors.erase(d);
+            return true;
         }
-    }
 
-    try {
-        for (auto& s : this->sensors) {
-            {
-                // Start ADL sampler. ADL is asynchronous, but we start a
-                // separate thread to collect the data at regular intervals.
-                // Registering a callback with the sensor implementation will
-                // start the ADL sampling and our collector thread.
-                auto ss = dynamic_cast<adl_sensor *>(s.get());
-                if (ss != nullptr) {
-                    //ss->start(this->sampling_interval.count());
-                    const auto si = duration_cast<microseconds>(
-                        this->sampling_interval).count();
-                    ss->sample(on_measurement, si, this);
-                    continue;
-                }
+        for (auto& i : this->instrument_logs) {
+            if (i.sensor == it->get()) {
+                throw std::logic_error("An instrument that is logging on its "
+                    "own cannot be removed from a running collector.");
             }
+        }
 
-            {
-                // EMI is in principle synchronous, but we built a specialised
-                // sampling thread that minimises the number of reads of the EMI
-                // registers.
-                auto ss = dynamic_cast<emi_sensor *>(s.get());
-                if (ss != nullptr) {
-                    const auto si = duration_cast<microseconds>(
-                        this->sampling_interval).count();
-                    ss->sample(on_measurement, si, this);
-                    continue;
-                }
+        for (auto& i : this->instrument_integrators) {
+            if (i.sensor == it->get()) {
+                throw std::logic_error("An instrument that is integrating on "
+                    "its own cannot be removed from a running collector.");
             }
+        }
 
-            {
-                // HMC8015 logs externally, so just start it.
-                auto ss = dynamic_cast<hmc8015_sensor *>(s.get());
-                if (ss != nullptr) {
-                    ss->display("The way you're meant to be trrolled.");
-                    ss->log(true);
-                    continue;
-                }
+        auto live = std::find(this->live_sensors.begin(),
+            this->live_sensors.end(), it->get());
+        if (live != this->live_sensors.end()) {
+            if (!this->paused) {
+                try {
+                    (**it).sample_batch(nullptr);
+                } catch (...) { /* The sensor is gone anyway. */ }
             }
 
-            {
-                // Start NVML sampler. NVML is in principle synchronous, but we
-                // built our own sampling thread around it.
-                auto ss = dynamic_cast<nvml_sensor *>(s.get());
-                if (ss != nullptr) {
-                    const auto si = duration_cast<microseconds>(
-                        this->sampling_interval).count();
-                    ss->sample(on_measurement, si, this);
-                    continue;
-                }
-            }
+            this->live_sensors.erase(live);
+            this->record(schema_change_type::removed, **it,
+                std::chrono::microseconds(0));
 
-            {
-                // Tinkerforge is truly asynchronous, so we need to register
-                // a callback to receive the samples.
-                auto ss = dynamic_cast<tinkerforge_sensor *>(s.get());
-                if (ss != nullptr) {
-                    const auto si = duration_cast<microseconds>(
-                        this->sampling_interval).count();
-                    ss->sample(on_measurement, tinkerforge_sensor_source::power,    // TODO: Allow other config here.
-                        si, this);
-                    continue;
-                }
-            }
+            // The share of the sensor goes to the remaining ones.
+            this->budget_intervals.erase(it->get());
+            this->rebalance(nullptr);
         }
 
-        // Finally, start the I/O thread.
-        this->writer_thread = std::thread(&collector_impl::write, this);
-    } catch (...) {
-        this->running = false;
-        throw;
+        this->intervals.erase(it->get());
+        this->power_estimators.erase(std::remove_if(
+            this->power_estimators.begin(), this->power_estimators.end(),
+            [&it](const power_estimator& e) {
+                return (e.sensor == it->get());
+            }), this->power_estimators.end());
+        retval = std::move(*it);
+        this->sensors.erase(it);
     }
+
+    return true;
 }
 
 
 /*
- * visus::power_overwhelming::detail::collector_impl::stop
+ * visus::power_overwhelming::detail::collector_impl::delay_of
  */
-void visus::power_overwhelming::detail::collector_impl::stop(void) {
-    // Tell the threads to exit if they are running.
-    this->running.store(false, std::memory_order::memory_order_release);
+std::chrono::microseconds
+visus::power_overwhelming::detail::collector_impl::delay_of(
+        const sensor *sensor) const {
+    assert(sensor != nullptr);
+    auto it = this->sensor_delays.end();
 
-    for (auto& s : this->sensors) {
-        try {
-            // Stop ADL sampler.
-            auto ss = dynamic_cast<adl_sensor *>(s.get());
-            if (ss != nullptr) {
-                ss->sample(nullptr);
-                continue;
-            }
-        } catch (...) { /* Ignore this, we need to stop all.*/ }
+    if (!this->sensor_delays.empty()) {
+        if (sensor->name() != nullptr) {
+            it = this->sensor_delays.find(sensor->name());
+        }
 
-        try {
-            // Stop on-device logging of HMC8015.
-            auto ss = dynamic_cast<hmc8015_sensor *>(s.get());
-            if (ss != nullptr) {
-                ss->log(false);
-                continue;
+        if (it == this->sensor_delays.end()) {
+            auto type = get_sensor_type(*sensor);
+            if (type != nullptr) {
+                it = this->sensor_delays.find(
+                    power_overwhelming::convert_string<wchar_t>(type));
             }
-        } catch (...) { /* Ignore this, we need to stop all.*/ }
+        }
+    }
 
-        try {
-            // Stop delivery of NVML sampler thread.
-            auto ss = dynamic_cast<nvml_sensor *>(s.get());
-            if (ss != nullptr) {
-                ss->sample(nullptr);
-                continue;
-            }
-        } catch (...) { /* Ignore this, we need to stop all.*/ }
+    return (it != this->sensor_delays.end())
+        ? it->second
+        : std::chrono::microseconds::zero();
+}
 
-        try {
-            // Unregister callback from Tinkerforge, which will stop it.
-            auto ss = dynamic_cast<tinkerforge_sensor *>(s.get());
-            if (ss != nullptr) {
-                ss->sample(nullptr, tinkerforge_sensor_source::all);
-                continue;
-            }
-        } catch (...) { /* Ignore this, we need to stop all.*/ }
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::interval
+ */
+bool visus::power_overwhelming::detail::collector_impl::interval(
+        const wchar_t *name, const std::chrono::microseconds interval) {
+    if (name == nullptr) {
+        throw std::invalid_argument("The name of the sensor to be changed "
+            "must not be null.");
+    }
+    if (interval.count() <= 0) {
+        throw std::invalid_argument("The sampling interval of a sensor must "
+            "be positive.");
     }
 
-    // Then, wake the I/O thread for a last time to make sure it exits.
-    set_event(this->evt_write);
-    if (this->writer_thread.joinable()) {
-        this->writer_thread.join();
+    std::lock_guard<decltype(this->gate_lock)> l(this->gate_lock);
+    auto it = std::find_if(this->sensors.begin(), this->sensors.end(),
+            [name](const std::unique_ptr<sensor>& s) {
+        auto n = s->name();
+        return ((n != nullptr) && (::wcscmp(n, name) == 0));
+    });
+    if (it == this->sensors.end()) {
+        // The interval of a sensor that has not been opened yet is applied
+        // like a configured one once the sensor is created on start.
+        auto d = find_deferred(this->deferred_sensors, name);
+        if (d == this->deferred_sensors.end()) {
+            return false;
+        }
+
+        this->sensor_intervals[name] = interval;
+        return true;
+    }
+
+    auto sensor = it->get();
+    for (auto& i : this->instrument_logs) {
+        if (i.sensor == sensor) {
+            throw std::logic_error("The logging interval of an instrument "
+                "cannot be changed while the collector is running.");
+        }
+    }
+
+    // Remember the interval even if it is the global one, because it must
+    // not be replaced by a configured one when the collector is restarted.
+    this->intervals[sensor] = interval;
+
+    auto live = std::find(this->live_sensors.begin(),
+        this->live_sensors.end(), sensor);
+    if (live != this->live_sensors.end()) {
+        // The new interval changes the demand of the sensor on the budget,
+        // which might change the intervals of all other sensors.
+        this->rebalance(sensor);
+
+        if (!this->paused) {
+            // The sensor is restarted from scratch, which establishes a new
+            // baseline for counters.
+            sensor->sample_batch(nullptr);
+            this->start_sampling({ sensor });
+        }
+
+        this->record(schema_change_type::interval, *sensor,
+            this->sampled_interval_of(sensor));
     }
+
+    return true;
 }
 
 
 /*
- * visus::power_overwhelming::detail::collector_impl::write
+ * visus::power_overwhelming::detail::collector_impl::interval_of
  */
-void visus::power_overwhelming::detail::collector_impl::write(void) {
-    using namespace std::chrono;
-    buffer_type buffer;
-    const auto delimiter = getcsvdelimiter(this->stream);
-    marker_list_type markers;
-    const auto timeout = static_cast<unsigned int>(duration_cast<milliseconds>(
-        this->sampling_interval).count()) * 8;
+std::chrono::microseconds
+visus::power_overwhelming::detail::collector_impl::interval_of(
+        const sensor *sensor) const {
+    auto it = this->intervals.find(sensor);
+    return (it != this->intervals.end()) ? it->second : this->sampling_interval;
+}
 
-    while (this->running.load()) {
-        wait_event(this->evt_write, timeout);
 
-        {
-            std::lock_guard<decltype(this->lock)> l(this->lock);
-            buffer = std::move(this->buffer);
-            markers = std::move(this->markers);
+/*
+ * visus::power_overwhelming::detail::collector_impl::is_open
+ */
+bool visus::power_overwhelming::detail::collector_impl::is_open(void) const {
+    switch (this->format) {
+        case output_format::binary:
+        case output_format::mapped_binary:
+        case output_format::async_binary:
+        case output_format::direct_binary:
+        case output_format::network_binary:
+            return this->binary_stream->is_open();
 
-            if (!markers.empty() && this->have_marker.load()) {
-                // Remember the last marker if it is still active. This is
-                // relevant in cases when we were invoked because of a timeout.
-                this->markers.push_back(markers.back());
-            }
-        }
+        case output_format::perfetto:
+        case output_format::chrome_trace:
+            return this->trace_stream.is_open();
 
-        if ((this->stream.tellp() == 0) && !buffer.empty()) {
-            // If this is the first line, print the CSV header.
-            this->stream << csvheader
-                << buffer.front() << delimiter
-                << L"marker" << std::endl
-                << csvdata;
+        case output_format::arrow:
+            return this->arrow_stream.is_open();
+
+        default:
+            return this->stream->is_open();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::load_safe_intervals
+ */
+void visus::power_overwhelming::detail::collector_impl::load_safe_intervals(
+        const wchar_t *path) {
+    this->read_costs.clear();
+    this->safe_intervals.clear();
+
+    if ((path != nullptr) && (*path != 0)) {
+        for (auto& i : detail::load_safe_intervals(path)) {
+            this->safe_intervals[i.first] = std::chrono::microseconds(
+                i.second);
         }
 
-        for (std::size_t i = 0, m = 0; i < buffer.size(); ++i) {
-            if ((m + 1 < markers.size()) && (i >= markers[m + 1].second)) {
-                ++m;
-            }
+        this->read_costs = detail::load_read_costs(path);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::local_buffer
+ */
+visus::power_overwhelming::detail::collector_impl::buffer_type&
+visus::power_overwhelming::detail::collector_impl::local_buffer(void) {
+    // The scheduler may run the ticks of a task on any of its workers or on
+    // the thread pumping it, so the buffers must be assigned to the tasks
+    // rather than to the threads. Otherwise, the samples of a sensor would be
+    // spread over several buffers and the writer would receive them out of
+    // order. Samplers with a dedicated thread are identified by the thread.
+    thread_local char dedicated_thread;
+    const auto task = sampler_scheduler::task::current();
+    const auto producer = (task != nullptr)
+        ? static_cast<const void *>(task)
+        : static_cast<const void *>(&dedicated_thread);
+
+    // Cache the buffers of the last producers the thread has run, because
+    // the workers alternate between the tasks. We identify the collector by
+    // its ID rather than by its address, because a new collector might be
+    // allocated at the address of a deleted one.
+    struct cache_entry {
+        std::uint64_t id;
+        const void *producer;
+        buffer_type *buffer;
+    };
+    thread_local cache_entry cache[16] = { };
+    auto& cached = cache[(reinterpret_cast<std::uintptr_t>(producer)
+        / alignof(std::max_align_t)) % (sizeof(cache) / sizeof(*cache))];
+
+    if ((cached.id != this->id) || (cached.producer != producer)) {
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        auto it = std::find_if(this->producers.begin(), this->producers.end(),
+                [producer](const std::pair<const void *, buffer_type *>& p) {
+            return (p.first == producer);
+        });
 
-            if (m < markers.size()) {
-                this->stream << buffer[i] << delimiter
-                    << markers[m].first << std::endl;
+        if (it == this->producers.end()) {
+            if (this->spare_buffers.empty()) {
+                this->buffers.emplace_back(new buffer_type(this->buffer_size));
             } else {
-                this->stream << buffer[i] << delimiter << std::endl;
+                // Use a buffer that has been allocated and locked on start.
+                this->buffers.push_back(std::move(this->spare_buffers.back()));
+                this->spare_buffers.pop_back();
             }
+
+            this->producers.emplace_back(producer,
+                this->buffers.back().get());
+            it = this->producers.end() - 1;
         }
 
-        this->stream.flush();
+        cached.id = this->id;
+        cached.producer = producer;
+        cached.buffer = it->second;
+    }
+
+    assert(cached.buffer != nullptr);
+    return *cached.buffer;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::lock_buffers
+ */
+void visus::power_overwhelming::detail::collector_impl::lock_buffers(void) {
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+
+    // The buffers are assigned per scheduler task or per dedicated sampler
+    // thread rather than per thread (see local_buffer), and each of these
+    // producers samples at least one sensor, so one buffer per sensor
+    // suffices however the scheduler distributes the tasks between its
+    // workers and the pump. The lists are reserved such that assigning a
+    // buffer to a producer does not allocate either.
+    const auto expected = (std::max)(this->sensors.size(), std::size_t(1));
+    auto cnt = this->buffers.size() + this->spare_buffers.size();
+    for (; cnt < expected; ++cnt) {
+        this->spare_buffers.emplace_back(new buffer_type(this->buffer_size));
+    }
+
+    this->buffers.reserve(cnt);
+    this->producers.reserve(cnt);
+
+    this->locked_memory.clear();
+    this->locked_memory.reserve(cnt);
+    for (auto& b : this->buffers) {
+        this->locked_memory.emplace_back(b->storage(), b->storage_size());
+    }
+    for (auto& b : this->spare_buffers) {
+        this->locked_memory.emplace_back(b->storage(), b->storage_size());
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::marker
+ */
+void visus::power_overwhelming::detail::collector_impl::marker(
+        const wchar_t *marker) {
+    this->marker((marker != nullptr) ? this->register_marker(marker) : 0);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::marker
+ */
+void visus::power_overwhelming::detail::collector_impl::marker(
+        const std::uint32_t id) {
+    this->record_marker(id, nullptr);
+
+    if (this->integrate_instruments) {
+        // The instruments integrate in hardware, so they only need to know
+        // when a phase begins and ends, which they learn on this thread to
+        // keep the delay between the marker and the integrators short.
+        std::lock_guard<decltype(this->gate_lock)> l(this->gate_lock);
+        this->switch_instrument_integrators(id);
+    }
+
+    if (this->trigger_oscilloscopes && (id != 0)) {
+        // The triggers are written asynchronously, so the caller is only
+        // delayed by starting the writes. A failed trigger must not prevent
+        // the marker from being set, because the marker has already been
+        // recorded and the oscilloscope only misses an acquisition.
+        std::lock_guard<decltype(this->gate_lock)> l(this->gate_lock);
+        for (auto s : this->live_sensors) {
+            auto rtx = dynamic_cast<rtx_sensor *>(s);
+            if (rtx != nullptr) {
+                try {
+                    rtx->trigger();
+                } catch (...) { /* The acquisition is lost. */ }
+            }
+        }
     }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::marker
+ */
+void visus::power_overwhelming::detail::collector_impl::marker(
+        const std::uint32_t id, const timestamp_type timestamp) {
+    this->record_marker(id, &timestamp);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::open
+ */
+void visus::power_overwhelming::detail::collector_impl::open(
+        const wchar_t *path, const output_format format) {
+    assert(path != nullptr);
+    this->format = format;
+    this->output_path = path;
+
+    switch (this->format) {
+        case output_format::binary:
+        case output_format::mapped_binary:
+            this->binary_stream->open(path,
+                (format == output_format::mapped_binary));
+            break;
+
+        case output_format::async_binary:
+        case output_format::direct_binary:
+            this->binary_stream->open_async(path,
+                (format == output_format::direct_binary));
+            break;
+
+        case output_format::network_binary:
+            this->binary_stream->connect(path);
+            break;
+
+        case output_format::perfetto:
+        case output_format::chrome_trace:
+            this->trace_stream.open(path, format);
+            break;
+
+        case output_format::arrow:
+            this->arrow_stream.open(path);
+            break;
+
+        default:
+            this->stream->open(path);
+            break;
+    }
+}
+
+
+/*
+ * ...::detail::collector_impl::open_deferred_sensors
+ */
+void visus::power_overwhelming::detail::collector_impl::open_deferred_sensors(
+        void) {
+    if (this->deferred_sensors.empty()) {
+        return;
+    }
+
+    // Create all sensors before adding any of them such that a failure does
+    // not leave the collector with a part of its sensors.
+    auto sensors = parse_sensors(this->deferred_sensors);
+    this->sensors.reserve(this->sensors.size() + sensors.size());
+    for (auto& s : sensors) {
+        this->sensors.push_back(std::move(s));
+    }
+
+    this->deferred_sensors = nlohmann::json::array();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::open_shards
+ */
+void visus::power_overwhelming::detail::collector_impl::open_shards(void) {
+    this->shards.clear();
+
+    if (this->writer_threads < 2) {
+        return;
+    }
+
+    switch (this->format) {
+        case output_format::csv:
+        case output_format::binary:
+        case output_format::async_binary:
+        case output_format::direct_binary:
+        case output_format::mapped_binary:
+            break;
+
+        default:
+            throw std::invalid_argument("The output can only be sharded if it "
+                "is a CSV or a binary file.");
+    }
+
+    // The shards only assign the markers to the samples and write them, so
+    // anything that combines the samples of different sensors or that must
+    // see all of them cannot be performed.
+    if ((this->aggregation_window.count() > 0)
+            || (this->resampling_interval.count() > 0)
+            || (this->keep_alive_interval.count() > 0)
+            || !this->delta_thresholds.empty()
+            || !this->sample_filters.empty()
+            || !this->derived.names().empty()
+            || (this->pre_trigger.count() > 0)
+            || (this->post_trigger.count() > 0)
+            || this->align_timestamps
+            || this->integrate_energy
+            || this->suppress_duplicates
+            || this->track_quantiles
+            || this->track_sequences
+            || (this->rotate_interval.count() > 0)
+            || (this->rotate_size > 0)
+            || !this->shared_memory_name.empty()) {
+        throw std::invalid_argument("The output cannot be sharded if the "
+            "samples are processed beyond assigning the markers.");
+    }
+
+    this->shards.reserve(this->writer_threads - 1);
+    for (std::size_t i = 1; i < this->writer_threads; ++i) {
+        const auto path = writer_shard::shard_path(this->output_path, i);
+        this->shards.emplace_back(new writer_shard());
+        this->shards.back()->open(path.c_str(), this->format,
+            this->binary_stream->compressed());
+    }
+
+    writer_shard::write_manifest(this->output_path, this->format,
+        this->writer_threads);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::overflows
+ */
+std::uint64_t visus::power_overwhelming::detail::collector_impl::overflows(
+        void) const {
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    std::uint64_t retval = 0;
+
+    for (auto& b : this->buffers) {
+        retval += b->overflows();
+    }
+
+    // Samples that could not be sent are lost as well.
+    retval += this->binary_stream->dropped();
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::pause
+ */
+void visus::power_overwhelming::detail::collector_impl::pause(void) {
+    std::lock_guard<decltype(this->gate_lock)> l(this->gate_lock);
+
+    if (!this->paused) {
+        for (auto s : this->live_sensors) {
+            try {
+                if (s != nullptr) {
+                    s->sample_batch(nullptr);
+                }
+            } catch (...) { /* Ignore this, we need to stop all.*/ }
+        }
+
+        this->paused = true;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::priority_of
+ */
+float visus::power_overwhelming::detail::collector_impl::priority_of(
+        const sensor *sensor) const {
+    assert(sensor != nullptr);
+    auto it = this->sensor_priorities.end();
+
+    if (!this->sensor_priorities.empty()) {
+        if (sensor->name() != nullptr) {
+            it = this->sensor_priorities.find(sensor->name());
+        }
+
+        if (it == this->sensor_priorities.end()) {
+            auto type = get_sensor_type(*sensor);
+            if (type != nullptr) {
+                it = this->sensor_priorities.find(
+                    power_overwhelming::convert_string<wchar_t>(type));
+            }
+        }
+    }
+
+    return (it != this->sensor_priorities.end()) ? it->second : 1.0f;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::pump
+ */
+std::size_t visus::power_overwhelming::detail::collector_impl::pump(
+        const std::chrono::microseconds budget) {
+    using namespace std::chrono;
+
+    if (!this->manual_pump) {
+        throw std::logic_error("The collector cannot be pumped, because it "
+            "has not been configured for manual pumping.");
+    }
+
+    const auto begin = steady_clock::now();
+    const auto retval = sampler_scheduler::instance().pump(begin, budget);
+
+    std::lock_guard<decltype(this->pump_lock)> l(this->pump_lock);
+    if (this->pump_state == nullptr) {
+        // The collector is not running.
+        return retval;
+    }
+
+    // Like the I/O thread, we drain the buffers if a producer has reached the
+    // threshold or if the latency has elapsed. If the sensors have used up
+    // the budget, only the latter can force a pass such that the event
+    // remains signalled for the next call.
+    const auto now = steady_clock::now();
+    const auto exhausted = (budget > microseconds::zero())
+        && (now - begin >= budget);
+    const auto overdue = (now - this->pump_pass >= this->write_latency);
+
+    if (overdue || (!exhausted && wait_event(this->evt_write, 0))) {
+        this->write(*this->pump_state, write_phase::pass);
+        this->pump_pass = now;
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::push
+ */
+void visus::power_overwhelming::detail::collector_impl::push(
+        const measurement& m) {
+    auto& buffer = this->local_buffer();
+
+    const auto threshold = (std::max)(std::size_t(1), static_cast<std::size_t>(
+        buffer.capacity() * this->write_threshold));
+
+    if (buffer.push(m) == threshold) {
+        // Wake the I/O thread before the buffer overflows.
+        set_event(this->evt_write);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::read_instrument_logs
+ */
+void visus::power_overwhelming::detail::collector_impl::read_instrument_logs(
+        void) {
+    instrument_log_context ctx;
+    ctx.that = this;
+    ctx.ticks_per_second = ticks_per_second(this->timestamp_resolution);
+
+    for (auto& l : this->instrument_logs) {
+        try {
+            // Stop logging first to make sure that the file is complete.
+            l.sensor->log(false);
+            auto data = l.sensor->log_data(instrument_log_file);
+
+            ctx.log = &l;
+            ctx.name = l.sensor->name();
+            if (ctx.name == nullptr) {
+                ctx.name = L"";
+            }
+
+            parse_hmc8015_log(data.as<char>(), data.size(), l.interval,
+                on_instrument_log_entry, &ctx);
+        } catch (...) { /* Ignore this, we need to retrieve all. */ }
+    }
+
+    this->instrument_logs.clear();
+
+    // The samples of each instrument are already ordered, but the output of
+    // multiple instruments must be merged.
+    std::stable_sort(this->instrument_samples.begin(),
+        this->instrument_samples.end(),
+        [](const measurement& lhs, const measurement& rhs) {
+            return (lhs.timestamp() < rhs.timestamp());
+        });
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::rebalance
+ */
+void visus::power_overwhelming::detail::collector_impl::rebalance(
+        sensor *pending) {
+    if (!this->rate_budget.enabled()) {
+        return;
+    }
+
+    std::vector<sensor *> sensors(this->live_sensors);
+    if ((pending != nullptr) && (std::find(sensors.begin(), sensors.end(),
+            pending) == sensors.end())) {
+        sensors.push_back(pending);
+    }
+
+    std::vector<std::chrono::microseconds> previous;
+    previous.reserve(this->live_sensors.size());
+    for (auto s : this->live_sensors) {
+        previous.push_back((s != nullptr)
+            ? this->sampled_interval_of(s)
+            : std::chrono::microseconds::zero());
+    }
+
+    this->apply_budget(sensors);
+
+    for (std::size_t i = 0; i < this->live_sensors.size(); ++i) {
+        auto s = this->live_sensors[i];
+        if ((s == nullptr) || (s == pending)) {
+            continue;
+        }
+
+        const auto interval = this->sampled_interval_of(s);
+        if (interval == previous[i]) {
+            continue;
+        }
+
+        if (!this->paused) {
+            s->sample_batch(nullptr);
+            this->start_sampling({ s });
+        }
+
+        this->record(schema_change_type::interval, *s, interval);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::record_marker
+ */
+void visus::power_overwhelming::detail::collector_impl::record_marker(
+        const std::uint32_t id, const timestamp_type *timestamp) {
+    {
+        // Create the timestamp, unless given, while holding the lock such
+        // that the events are ordered and that the I/O thread cannot have retrieved a sample
+        // taken after an event without also retrieving the event.
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        if (id >= this->marker_names.size()) {
+            throw std::out_of_range("The marker has not been registered with "
+                "the collector.");
+        }
+
+        this->marker_events.emplace_back((timestamp != nullptr)
+            ? *timestamp
+            : create_timestamp(this->timestamp_resolution), id);
+
+        // Emit the system event on the calling thread such that it is
+        // attributed to the code that set the marker.
+        system_trace::marker(id, (id != 0)
+            ? this->marker_names[id].c_str()
+            : nullptr);
+    }
+
+    // Enable/disable collection of samples by other threads.
+    this->have_marker.store(id != 0, std::memory_order::memory_order_release);
+
+    if (this->require_marker) {
+        // Do not sample at all while we would discard the samples anyway.
+        if (id != 0) {
+            this->resume();
+        } else {
+            this->pause();
+        }
+    }
+
+    if ((id != 0) && !this->experiment_report.empty()
+            && (this->experiment_window.count() == 0)) {
+        this->switch_experiment();
+    }
+
+    if (id != 0) {
+        // Wake the I/O thread, because if we start a new phase, it is typically
+        // a good idea to make sure that what we already have is persisted.
+        set_event(this->evt_write);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::register_marker
+ */
+std::uint32_t visus::power_overwhelming::detail::collector_impl::register_marker(
+        const wchar_t *marker) {
+    if (marker == nullptr) {
+        throw std::invalid_argument("The text of a marker must not be null.");
+    }
+
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    auto it = this->marker_ids.find(marker);
+
+    if (it == this->marker_ids.end()) {
+        const auto id = static_cast<std::uint32_t>(this->marker_names.size());
+        it = this->marker_ids.emplace(marker, id).first;
+        this->marker_names.emplace_back(marker);
+    }
+
+    return it->second;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::record
+ */
+void visus::power_overwhelming::detail::collector_impl::record(
+        const schema_change_type type, const sensor& sensor,
+        const std::chrono::microseconds interval) {
+    schema_change change;
+    auto name = sensor.name();
+    change.interval = static_cast<sensor::microseconds_type>(interval.count());
+    change.name = (name != nullptr) ? name : L"";
+    change.timestamp = create_timestamp(this->timestamp_resolution);
+    change.type = type;
+
+    {
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        this->schema_changes.push_back(std::move(change));
+    }
+
+    set_event(this->evt_write);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::reopen
+ */
+void visus::power_overwhelming::detail::collector_impl::reopen(
+        const wchar_t *path) {
+    assert(path != nullptr);
+    if (this->running.load(std::memory_order_acquire)) {
+        throw std::logic_error("The output of a running collector cannot be "
+            "redirected.");
+    }
+
+    // The I/O thread has exited, so nobody else is using the output.
+    if (this->is_open()) {
+        this->close();
+    }
+
+    this->open(path, this->format);
+    this->open_shards();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::resolve_delta_threshold
+ */
+void
+visus::power_overwhelming::detail::collector_impl::resolve_delta_threshold(
+        const sensor *sensor) {
+    assert(sensor != nullptr);
+    auto name = sensor->name();
+
+    if (this->delta_thresholds.empty() || (name == nullptr)) {
+        return;
+    }
+
+    // The name of the sensor takes precedence over its type.
+    auto it = this->delta_thresholds.find(name);
+    if (it == this->delta_thresholds.end()) {
+        auto type = get_sensor_type(*sensor);
+        if (type != nullptr) {
+            it = this->delta_thresholds.find(
+                power_overwhelming::convert_string<wchar_t>(type));
+        }
+    }
+
+    if (it != this->delta_thresholds.end()) {
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        this->resolved_thresholds.emplace_back(name, it->second);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::resolve_interval
+ */
+void visus::power_overwhelming::detail::collector_impl::resolve_interval(
+        const sensor *sensor) {
+    assert(sensor != nullptr);
+
+    if (!this->sensor_intervals.empty()) {
+        // The name of the sensor takes precedence over its type.
+        auto name = sensor->name();
+        auto it = this->sensor_intervals.end();
+        if (name != nullptr) {
+            it = this->sensor_intervals.find(name);
+        }
+
+        if (it == this->sensor_intervals.end()) {
+            auto type = get_sensor_type(*sensor);
+            if (type != nullptr) {
+                it = this->sensor_intervals.find(
+                    power_overwhelming::convert_string<wchar_t>(type));
+            }
+        }
+
+        if (it != this->sensor_intervals.end()) {
+            this->intervals.emplace(sensor, it->second);
+        }
+    }
+
+    if (this->limit_to_native_interval) {
+        // A sensor whose interval cannot be determined is sampled as
+        // configured, because limiting the rate is only an optimisation.
+        sensor::microseconds_type native = 0;
+        try {
+            native = sensor->native_interval();
+        } catch (...) { }
+
+        const auto interval = std::chrono::microseconds(native);
+        if (interval > this->interval_of(sensor)) {
+            this->intervals[sensor] = interval;
+        }
+    }
+
+    if (!this->safe_intervals.empty() && (sensor->name() != nullptr)) {
+        auto it = this->safe_intervals.find(sensor->name());
+        if ((it != this->safe_intervals.end())
+                && (it->second > this->interval_of(sensor))) {
+            this->intervals[sensor] = it->second;
+        }
+    }
+}
+
+
+/*
+ * ...::detail::collector_impl::resolve_power_estimator
+ */
+void visus::power_overwhelming::detail::collector_impl::resolve_power_estimator(
+        sensor *sensor) {
+    assert(sensor != nullptr);
+    auto nvml = dynamic_cast<nvml_sensor *>(sensor);
+
+    if (!this->estimate_power || (nvml == nullptr)
+            || (sensor->name() == nullptr)) {
+        return;
+    }
+
+    auto it = std::find_if(this->power_estimators.begin(),
+            this->power_estimators.end(), [nvml](const power_estimator& e) {
+        return (e.sensor == nvml);
+    });
+    if (it != this->power_estimators.end()) {
+        return;
+    }
+
+    try {
+        nvml->estimation_mode(true);
+    } catch (nvml_exception&) {
+        // GPUs that cannot report their activity are only measured.
+        return;
+    }
+
+    const std::wstring name(sensor->name());
+    power_estimator estimator;
+    estimator.estimated = sensor_name_registry::intern(
+        (name + L"/estimated").c_str());
+    estimator.lower = sensor_name_registry::intern(
+        (name + L"/estimated/lower").c_str());
+    estimator.sensor = nvml;
+    estimator.upper = sensor_name_registry::intern(
+        (name + L"/estimated/upper").c_str());
+    this->power_estimators.push_back(estimator);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::resolve_quantities
+ */
+void visus::power_overwhelming::detail::collector_impl::resolve_quantities(
+        sensor *sensor) {
+    assert(sensor != nullptr);
+    auto tinkerforge = dynamic_cast<tinkerforge_sensor *>(sensor);
+
+    if (tinkerforge == nullptr) {
+        return;
+    }
+
+    tinkerforge->reconstruct_timestamps(!this->tinkerforge_arrival_times);
+
+    if (this->sensor_quantities.empty()) {
+        return;
+    }
+
+    // The name of the sensor takes precedence over its type.
+    auto name = sensor->name();
+    auto it = this->sensor_quantities.end();
+    if (name != nullptr) {
+        it = this->sensor_quantities.find(name);
+    }
+
+    if (it == this->sensor_quantities.end()) {
+        auto type = get_sensor_type(*sensor);
+        if (type != nullptr) {
+            it = this->sensor_quantities.find(
+                power_overwhelming::convert_string<wchar_t>(type));
+        }
+    }
+
+    if (it != this->sensor_quantities.end()) {
+        tinkerforge->quantities(it->second);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::resolve_sample_filter
+ */
+void visus::power_overwhelming::detail::collector_impl::resolve_sample_filter(
+        const sensor *sensor) {
+    assert(sensor != nullptr);
+    auto name = sensor->name();
+
+    if (this->sample_filters.empty() || (name == nullptr)) {
+        return;
+    }
+
+    // The name of the sensor takes precedence over its type.
+    auto it = this->sample_filters.find(name);
+    if (it == this->sample_filters.end()) {
+        auto type = get_sensor_type(*sensor);
+        if (type != nullptr) {
+            it = this->sample_filters.find(
+                power_overwhelming::convert_string<wchar_t>(type));
+        }
+    }
+
+    if (it != this->sample_filters.end()) {
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        this->resolved_filters.emplace_back(name, it->second);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::resume
+ */
+void visus::power_overwhelming::detail::collector_impl::resume(void) {
+    std::lock_guard<decltype(this->gate_lock)> l(this->gate_lock);
+
+    if (this->paused) {
+        // Restart all sensors at once such that the phase starts on a common
+        // tick. The sampler contexts establish new baselines for counters.
+        this->start_sampling(this->live_sensors);
+        this->paused = false;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::run_experiment
+ */
+void visus::power_overwhelming::detail::collector_impl::run_experiment(
+        void) {
+    enter_library_thread("PwrOwg Overhead Experiment Thread");
+
+    const auto timeout = static_cast<unsigned int>((std::max)(
+        decltype(this->experiment_window)::rep(1),
+        (this->experiment_window.count() + 999) / 1000));
+
+    while (!wait_event(this->evt_experiment, timeout)) {
+        try {
+            this->switch_experiment();
+        } catch (...) {
+            // The sensors that failed are lost for the rest of the run, but
+            // the experiment continues with the others.
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::sampled_interval_of
+ */
+std::chrono::microseconds
+visus::power_overwhelming::detail::collector_impl::sampled_interval_of(
+        const sensor *sensor) const {
+    auto it = this->budget_intervals.find(sensor);
+    return (it != this->budget_intervals.end())
+        ? it->second
+        : this->interval_of(sensor);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::start
+ */
+void visus::power_overwhelming::detail::collector_impl::start(void) {
+    using namespace std::chrono;
+
+    if (this->manual_pump && ((this->writer_threads > 1)
+            || (this->experiment_window.count() > 0))) {
+        throw std::logic_error("A collector that is pumped manually cannot "
+            "shard its output or switch the windows of an experiment on its "
+            "own.");
+    }
+
+    {
+        auto expected = false;
+        if (!this->running.compare_exchange_strong(expected, true)) {
+            throw std::runtime_error("The power sample collector is already "
+                "running and cannot be restarted.");
+        }
+    }
+
+    try {
+        // Hold the lock while starting such that no sensor can be attached or
+        // detached before we know which ones are sampled live.
+        std::unique_lock<decltype(this->gate_lock)> l(this->gate_lock);
+
+        // Sensors from a configuration that has only been validated are
+        // opened now, which happens in parallel for different devices.
+        this->open_deferred_sensors();
+
+        // The previous run has closed the output, so a restart without a new
+        // path overwrites it.
+        if (!this->is_open()) {
+            const auto path = this->output_path;
+            this->open(path.c_str(), this->format);
+            this->open_shards();
+        }
+
+        // Allocate and lock all buffers before any sensor is started such
+        // that no sampler thread needs to allocate memory later on.
+        if (this->lock_memory) {
+            this->lock_buffers();
+        }
+
+        // Start all sensors at once. Each sensor knows how it is sampled best,
+        // be it via its own asynchronous API, a specialised sampler thread or
+        // the generic sampler thread.
+        std::vector<sensor::microseconds_type> latencies(this->sensors.size());
+        std::vector<sensor *> sensors;
+        sensors.reserve(this->sensors.size());
+        for (auto& s : this->sensors) {
+            this->resolve_delta_threshold(s.get());
+            this->resolve_interval(s.get());
+            this->resolve_power_estimator(s.get());
+            this->resolve_quantities(s.get());
+            this->resolve_sample_filter(s.get());
+            sensors.push_back(s.get());
+        }
+
+        if (this->integrate_instruments) {
+            this->start_instrument_integrators(sensors);
+        }
+
+        if (!this->waveform_archive_path.empty()) {
+            // The waveforms are passed on by the delivery threads of the
+            // oscilloscopes, which are created when sampling starts.
+            this->archive.open(this->waveform_archive_path.c_str(),
+                this->compress_waveforms);
+            for (auto s : sensors) {
+                auto rtx = dynamic_cast<rtx_sensor *>(s);
+                if (rtx != nullptr) {
+                    rtx->waveform_callback(on_archived_waveform, this);
+                }
+            }
+        }
+
+        if (this->merge_instrument_logs) {
+            this->start_instrument_logs(sensors);
+        }
+
+        // The writer thread is not running, so we can safely prepare the
+        // estimate of our own overhead here.
+        if (this->record_overhead) {
+            this->overhead.reset();
+            for (auto s : sensors) {
+                if (is_cpu_package_sensor(*s) && (s->name() != nullptr)) {
+                    this->overhead.add_package(s->name());
+                }
+            }
+        }
+
+        if (this->integrate_energy) {
+            this->phase_energies.reset(ticks_per_second(
+                this->timestamp_resolution));
+            for (auto s : sensors) {
+                if (is_energy_counter_sensor(*s) && (s->name() != nullptr)) {
+                    this->phase_energies.add_counter(s->name());
+                }
+            }
+        }
+
+        if (this->track_quantiles) {
+            this->quantiles.reset();
+        }
+
+        if (this->track_sequences) {
+            this->sequences.reset();
+        }
+
+        if (!this->kernel_energy_path.empty()) {
+#if defined(POWER_OVERWHELMING_WITH_CUPTI)
+            this->kernel_energies.reset(ticks_per_second(
+                this->timestamp_resolution));
+            for (auto s : sensors) {
+                if (is_energy_counter_sensor(*s) && (s->name() != nullptr)) {
+                    this->kernel_energies.add_counter(s->name());
+                }
+            }
+
+            cupti_kernel_tracer::instance().start();
+#else /* defined(POWER_OVERWHELMING_WITH_CUPTI) */
+            throw std::logic_error("The energy cannot be attributed to CUDA "
+                "kernels, because the library has been built without "
+                "support for CUPTI.");
+#endif /* defined(POWER_OVERWHELMING_WITH_CUPTI) */
+        }
+
+        if (!this->process_energy_path.empty()) {
+            for (auto s : sensors) {
+                auto nvml = dynamic_cast<nvml_sensor *>(s);
+                if (nvml != nullptr) {
+                    try {
+                        nvml->process_energy_mode(true);
+                    } catch (...) {
+                        // GPUs that cannot report their processes are
+                        // omitted from the table.
+                    }
+                }
+            }
+        }
+
+        // Distribute the budget before anything depends on the intervals.
+        this->apply_budget(sensors);
+
+        // Calibrated delays are applied as they are. The latency of other
+        // sensors stamping their samples at the end of an averaging period
+        // is estimated from the interval we configured.
+        this->aligner.reset();
+        if (this->align_timestamps || !this->sensor_delays.empty()) {
+            const auto tps = ticks_per_second(this->timestamp_resolution);
+            for (auto s : sensors) {
+                if (s->name() == nullptr) {
+                    continue;
+                }
+
+                const auto delay = this->delay_of(s).count();
+                if (delay > 0) {
+                    this->aligner.add_delay(s->name(),
+                        static_cast<timestamp_type>(delay * tps / 1000000.0
+                        + 0.5));
+
+                } else if (this->align_timestamps
+                        && has_trailing_timestamps(*s)) {
+                    const auto interval = this->sampled_interval_of(s)
+                        .count();
+                    this->aligner.add_trailing(s->name(),
+                        static_cast<timestamp_type>(interval * tps / 1000000.0
+                        + 0.5));
+                }
+            }
+        }
+
+        // Create the segment before any sensor is started such that a name
+        // already in use does not leave the sensors running.
+        if (!this->shared_memory_name.empty()) {
+            this->shared_memory.open(this->shared_memory_name.c_str());
+        }
+        if (!this->marker_channel_name.empty()) {
+            this->marker_channel.open(this->marker_channel_name.c_str());
+        }
+
+        // The sampler contexts survive their sensors, so the statistics would
+        // otherwise include previous runs.
+        if (this->write_statistics) {
+            sampler_instrumentation::reset_all();
+        }
+
+        this->samples.store(0, std::memory_order_relaxed);
+        this->bytes_written.store(0, std::memory_order_relaxed);
+        this->marker_event_count.store(0, std::memory_order_relaxed);
+        this->flush_duration.reset();
+
+        {
+            // Frames marked while the collector was not running must not end
+            // up in the output. The I/O thread is not yet running, so we can
+            // act as the consumer of the ring.
+            std::lock_guard<decltype(this->lock)> l(this->lock);
+            if (this->frames != nullptr) {
+                this->frames->drain([](const marker_event_type&,
+                    const frame_ring::position_type) { });
+            }
+        }
+        {
+            std::lock_guard<decltype(this->statistics_lock)> l(
+                this->statistics_lock);
+            this->marker_energies.clear();
+            this->published_quantiles.clear();
+            this->sensor_samples.clear();
+            this->statistics_elapsed = std::chrono::microseconds(0);
+        }
+
+        // Switch the scheduler before any sensor is started such that it does
+        // not start its workers, but leaves the ticks to pump().
+        if (this->manual_pump) {
+            auto& scheduler = sampler_scheduler::instance();
+            this->pumped_scheduler = scheduler.manual();
+            scheduler.manual(true);
+        }
+
+        // Discard all samples until the sensors are released. We arm the start
+        // barrier ourselves such that the start timestamp is known before the
+        // first sampler thread is released.
+        this->start_time.store((std::numeric_limits<
+            measurement::timestamp_type>::max)());
+        start_barrier::arm();
+        {
+            const auto guard_barrier = on_exit([](void) {
+                start_barrier::release();
+            });
+
+            this->start_sampling(sensors, latencies.data());
+
+            this->start_info.timestamp = create_timestamp(
+                this->timestamp_resolution);
+            this->start_time.store(this->start_info.timestamp);
+        }
+
+        this->start_info.latencies.clear();
+        this->start_info.latencies.reserve(this->sensors.size());
+        for (std::size_t i = 0; i < this->sensors.size(); ++i) {
+            auto name = this->sensors[i]->name();
+            this->start_info.latencies.emplace_back(
+                (name != nullptr) ? name : L"", latencies[i]);
+        }
+
+        // Remember which sensors we sample live. If we require a marker, but
+        // none is set, there is no point in sampling them, but we start them
+        // nevertheless such that problems with the sensors surface here and
+        // that the start latencies are known.
+        this->live_sensors = std::move(sensors);
+        this->paused = false;
+        l.unlock();
+
+        if (this->require_marker && !this->have_marker.load(
+                std::memory_order::memory_order_acquire)) {
+            this->pause();
+        }
+
+        // Finally, start the I/O thread or prepare the application to act
+        // as the I/O thread.
+        if (this->manual_pump) {
+            std::lock_guard<decltype(this->pump_lock)> p(this->pump_lock);
+            this->pump_state.reset(new write_state());
+            this->write(*this->pump_state, write_phase::begin);
+            this->pump_pass = steady_clock::now();
+        } else {
+            this->writer_thread = std::thread(
+                static_cast<void (collector_impl::*)(void)>(
+                &collector_impl::write), this);
+        }
+
+        if (!this->experiment_report.empty()) {
+            {
+                std::lock_guard<decltype(this->gate_lock)> g(this->gate_lock);
+                this->experiment.begin(
+                    create_timestamp(this->timestamp_resolution),
+                    ticks_per_second(this->timestamp_resolution));
+            }
+
+            if (this->experiment_window.count() > 0) {
+                reset_event(this->evt_experiment);
+                this->experiment_thread = std::thread(
+                    &collector_impl::run_experiment, this);
+            }
+        }
+    } catch (...) {
+        for (auto& i : this->instrument_integrators) {
+            try {
+                i.sensor->integrator(false);
+            } catch (...) { /* Ignore this, we need to stop all.*/ }
+        }
+        this->instrument_integrators.clear();
+        this->archive.close();
+        for (auto& l : this->instrument_logs) {
+            try {
+                l.sensor->log(false);
+            } catch (...) { /* Ignore this, we need to stop all.*/ }
+        }
+        this->instrument_logs.clear();
+        this->marker_channel.close();
+        this->shared_memory.close();
+        {
+            std::lock_guard<decltype(this->lock)> l(this->lock);
+            this->locked_memory.clear();
+        }
+        if (this->manual_pump) {
+            std::lock_guard<decltype(this->pump_lock)> p(this->pump_lock);
+            this->pump_state.reset();
+            sampler_scheduler::instance().manual(this->pumped_scheduler);
+        }
+
+        this->running = false;
+        throw;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::start_sampling
+ */
+void visus::power_overwhelming::detail::collector_impl::start_sampling(
+        const std::vector<sensor *>& sensors,
+        sensor::microseconds_type *latencies) {
+    using namespace std::chrono;
+    const auto adaptive = (this->min_sampling_interval > microseconds::zero());
+    const auto si = duration_cast<microseconds>(
+        this->sampling_interval).count();
+
+    const auto common_interval = [this](const sensor *s) {
+        return (this->sampled_interval_of(s) == this->sampling_interval);
+    };
+
+    if (this->intervals.empty() && this->budget_intervals.empty()
+            && !adaptive) {
+        // This is the common case of all sensors sampling at the same rate.
+        sensor::sample_all(sensors.data(), sensors.size(),
+            on_measurement_data, si, this, latencies);
+        return;
+    }
+
+    // Start the sensors at the global interval together and the ones with
+    // their own interval after them. Adaptive sensors are always started on
+    // their own. If the start barrier is armed, all of them still start on
+    // the same tick.
+    std::vector<sensor *> common(sensors);
+    for (auto& s : common) {
+        if (adaptive || !common_interval(s)) {
+            s = nullptr;
+        }
+    }
+
+    sensor::sample_all(common.data(), common.size(), on_measurement_data, si,
+        this, latencies);
+
+    try {
+        for (std::size_t i = 0; i < sensors.size(); ++i) {
+            if ((sensors[i] == nullptr) || (common[i] != nullptr)) {
+                continue;
+            }
+
+            const auto begin = steady_clock::now();
+            const auto interval = this->sampled_interval_of(sensors[i])
+                .count();
+            if (adaptive) {
+                const auto min_interval = (std::min)(interval,
+                    this->min_sampling_interval.count());
+                sensors[i]->sample_adaptive(on_measurement_data, min_interval,
+                    interval, this);
+            } else {
+                sensors[i]->sample_batch(on_measurement_data, interval, this);
+            }
+
+            if (latencies != nullptr) {
+                latencies[i] = duration_cast<microseconds>(
+                    steady_clock::now() - begin).count();
+            }
+        }
+    } catch (...) {
+        for (auto s : sensors) {
+            try {
+                if (s != nullptr) {
+                    s->sample_batch(nullptr);
+                }
+            } catch (...) { /* Ignore this, we need to stop all.*/ }
+        }
+        throw;
+    }
+}
+
+
+/*
+ * ...::detail::collector_impl::start_instrument_integrators
+ */
+void visus::power_overwhelming::detail::collector_impl::start_instrument_integrators(
+        std::vector<sensor *>& sensors) {
+    this->instrument_energies.clear();
+    this->instrument_integrators.clear();
+    this->integrator_phase = 0;
+
+    for (auto& s : sensors) {
+        auto hmc8015 = dynamic_cast<hmc8015_sensor *>(s);
+        if (hmc8015 == nullptr) {
+            continue;
+        }
+
+        instrument_integrator integrator;
+        integrator.begin = 0;
+        integrator.running = false;
+        integrator.sensor = hmc8015;
+
+        hmc8015->integrator(true);
+        this->instrument_integrators.push_back(integrator);
+
+        // Do not sample the instrument live as we cannot query the
+        // integrator while the sampler thread is streaming.
+        s = nullptr;
+    }
+
+    if (this->integrator_marker != 0) {
+        // Start the phase of the marker that has been set before, which is
+        // the first one we measure.
+        this->switch_instrument_integrators(this->integrator_marker);
+    }
+
+    this->integrator_phase = 0;
+}
+
+
+/*
+ * ...::detail::collector_impl::start_instrument_logs
+ */
+void visus::power_overwhelming::detail::collector_impl::start_instrument_logs(
+        std::vector<sensor *>& sensors) {
+    this->instrument_logs.clear();
+    this->instrument_samples.clear();
+
+    for (auto& s : sensors) {
+        auto hmc8015 = dynamic_cast<hmc8015_sensor *>(s);
+        if (hmc8015 == nullptr) {
+            continue;
+        }
+
+        const auto interval = std::chrono::duration_cast<
+            std::chrono::duration<float>>(this->interval_of(s)).count();
+        hmc8015->log_file(instrument_log_file, true);
+        hmc8015->log_behaviour(interval, log_mode::unlimited);
+
+        instrument_log log;
+        log.interval = hmc8015->log_interval();
+        log.sensor = hmc8015;
+
+        // The instrument starts logging when it receives the command, which
+        // is sent first, whereas the method also waits for checking the
+        // error state of the instrument.
+        log.start = create_timestamp(this->timestamp_resolution);
+        hmc8015->log(true);
+        this->instrument_logs.push_back(log);
+
+        // Do not sample the instrument live as this would interfere with the
+        // log.
+        s = nullptr;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::statistics
+ */
+void visus::power_overwhelming::detail::collector_impl::statistics(
+        collector_statistics_impl& dst) const {
+    dst.bytes_written = this->bytes_written.load(std::memory_order_relaxed);
+    dst.marker_events = this->marker_event_count.load(
+        std::memory_order_relaxed);
+    dst.samples = this->samples.load(std::memory_order_relaxed);
+    this->flush_duration.snapshot(dst.flush_duration);
+
+    {
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        dst.backlog = 0;
+        for (auto& b : this->buffers) {
+            dst.backlog += b->size();
+        }
+    }
+    dst.backlog_bytes = dst.backlog * sizeof(measurement);
+    dst.dropped = this->overflows();
+
+    {
+        std::lock_guard<decltype(this->statistics_lock)> l(
+            this->statistics_lock);
+        dst.elapsed = this->statistics_elapsed.count();
+        dst.sensors.clear();
+        dst.sensors.reserve(this->sensor_samples.size());
+        for (auto& s : this->sensor_samples) {
+            dst.sensors.emplace_back(s.first, s.second);
+        }
+        dst.quantiles = this->published_quantiles;
+    }
+
+    // The counters are kept in a hash map, so we sort them to make the
+    // snapshot reproducible.
+    std::sort(dst.sensors.begin(), dst.sensors.end());
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::stop
+ */
+void visus::power_overwhelming::detail::collector_impl::stop(void) {
+    // Stop switching the windows of the experiment before the sensors are
+    // stopped for good.
+    set_event(this->evt_experiment);
+    if (this->experiment_thread.joinable()) {
+        this->experiment_thread.join();
+    }
+
+    {
+        std::lock_guard<decltype(this->gate_lock)> l(this->gate_lock);
+        if (this->experiment.running()) {
+            // Note: We do not throw from here, wherefore a report that cannot
+            // be written is silently skipped.
+            this->experiment.end(create_timestamp(this->timestamp_resolution));
+
+            std::ofstream file;
+#if defined(_WIN32)
+            file.open(this->experiment_report, std::ofstream::out
+                | std::ofstream::trunc);
+#else /* defined(_WIN32) */
+            file.open(power_overwhelming::convert_string<char>(
+                this->experiment_report), std::ofstream::out
+                | std::ofstream::trunc);
+#endif /* defined(_WIN32) */
+            if (file.is_open()) {
+                write_overhead_experiment(file, this->experiment);
+            }
+        }
+
+        for (auto& s : this->sensors) {
+            try {
+                s->sample_batch(nullptr);
+            } catch (...) { /* Ignore this, we need to stop all.*/ }
+        }
+
+        this->live_sensors.clear();
+        this->paused = false;
+
+        this->stop_instrument_integrators();
+
+        // All sensors have been stopped, so the attribution to the processes
+        // is complete.
+        if (!this->process_energy_path.empty()) {
+            std::map<std::wstring, std::vector<process_energy>> energies;
+            for (auto& s : this->sensors) {
+                auto nvml = dynamic_cast<nvml_sensor *>(s.get());
+                if ((nvml == nullptr) || (nvml->name() == nullptr)) {
+                    continue;
+                }
+
+                try {
+                    if (nvml->process_energy_mode()) {
+                        auto& e = energies[nvml->name()];
+                        e.resize(nvml->process_energies(nullptr, 0));
+                        e.resize(nvml->process_energies(e.data(), e.size()));
+                        nvml->process_energy_mode(false);
+                    }
+                } catch (...) { /* Ignore this, we need to stop all.*/ }
+            }
+
+            std::ofstream file;
+#if defined(_WIN32)
+            file.open(this->process_energy_path, std::ofstream::out
+                | std::ofstream::trunc);
+#else /* defined(_WIN32) */
+            file.open(power_overwhelming::convert_string<char>(
+                this->process_energy_path), std::ofstream::out
+                | std::ofstream::trunc);
+#endif /* defined(_WIN32) */
+            if (file.is_open()) {
+                write_process_energy(file, energies);
+            }
+        }
+
+        // All oscilloscopes have delivered their last waveforms when their
+        // samplers have been destroyed, so the archive is complete.
+        for (auto& s : this->sensors) {
+            auto rtx = dynamic_cast<rtx_sensor *>(s.get());
+            if (rtx != nullptr) {
+                rtx->waveform_callback(nullptr);
+            }
+        }
+        this->archive.close();
+    }
+
+    // Retrieve the logs of the instruments such that the I/O thread can write
+    // them in its last pass.
+    this->read_instrument_logs();
+
+    // Tell the I/O thread to exit only after all sensors have been stopped,
+    // which might have flushed pending samples into the buffers.
+    this->running.store(false, std::memory_order::memory_order_release);
+
+    // Then, wake the I/O thread for a last time to make sure it exits.
+    set_event(this->evt_write);
+    if (this->writer_thread.joinable()) {
+        this->writer_thread.join();
+    }
+
+    // If the application acts as the I/O thread, we make the last pass on its
+    // behalf.
+    {
+        std::lock_guard<decltype(this->pump_lock)> l(this->pump_lock);
+        if (this->pump_state != nullptr) {
+            this->pump_state->running = false;
+            this->write(*this->pump_state, write_phase::pass);
+            this->write(*this->pump_state, write_phase::end);
+            this->pump_state.reset();
+            sampler_scheduler::instance().manual(this->pumped_scheduler);
+        }
+    }
+
+    // The buffers themselves are retained for a restart.
+    {
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        this->locked_memory.clear();
+    }
+}
+
+
+/*
+ * ...::detail::collector_impl::stop_instrument_integrators
+ */
+void visus::power_overwhelming::detail::collector_impl::stop_instrument_integrators(
+        void) {
+    // Close the current phase, but retain the marker for a restart.
+    const auto marker = this->integrator_marker;
+    this->switch_instrument_integrators(0);
+    this->integrator_marker = marker;
+
+    for (auto& i : this->instrument_integrators) {
+        try {
+            i.sensor->integrator(false);
+        } catch (...) { /* Ignore this, we need to stop all.*/ }
+    }
+
+    this->instrument_integrators.clear();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::subscribe
+ */
+std::shared_ptr<visus::power_overwhelming::detail::subscriber_ring>
+visus::power_overwhelming::detail::collector_impl::subscribe(void) {
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+
+    if (this->subscribers == nullptr) {
+        this->subscribers = std::make_shared<subscriber_ring>(
+            this->subscriber_capacity);
+    }
+
+    return this->subscribers;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::switch_experiment
+ */
+void visus::power_overwhelming::detail::collector_impl::switch_experiment(
+        void) {
+    std::lock_guard<decltype(this->gate_lock)> l(this->gate_lock);
+
+    if (!this->experiment.running()) {
+        return;
+    }
+
+    const auto sampling = this->experiment.toggle(create_timestamp(
+        this->timestamp_resolution));
+
+    // Stop all sensors first such that the next window starts on a common
+    // tick like after a marker.
+    if (!this->paused) {
+        for (auto s : this->live_sensors) {
+            try {
+                if (s != nullptr) {
+                    s->sample_batch(nullptr);
+                }
+            } catch (...) { /* Ignore this, we need to stop all.*/ }
+        }
+
+        this->paused = true;
+    }
+
+    if (sampling) {
+        this->start_sampling(this->live_sensors);
+        this->paused = false;
+
+    } else if (this->experiment_interval.count() > 0) {
+        // The sensors at the global interval are restarted at the interval of
+        // the reference windows, the ones with an override keep theirs.
+        const auto interval = this->sampling_interval;
+        const auto restore_interval = on_exit([this, interval](void) {
+            this->sampling_interval = interval;
+        });
+
+        this->sampling_interval = this->experiment_interval;
+        this->start_sampling(this->live_sensors);
+        this->paused = false;
+    }
+}
+
+
+/*
+ * ...::detail::collector_impl::switch_instrument_integrators
+ */
+void visus::power_overwhelming::detail::collector_impl::switch_instrument_integrators(
+        const std::uint32_t id) {
+    for (auto& i : this->instrument_integrators) {
+        try {
+            if (i.running) {
+                // The instrument stops integrating when it receives the
+                // command, which is sent first, whereas the method also
+                // waits for checking the error state of the instrument.
+                const auto end = create_timestamp(this->timestamp_resolution);
+                i.running = false;
+                i.sensor->stop_integrator();
+
+                phase_energy energy;
+                energy.begin = i.begin;
+                energy.end = end;
+                energy.energy = i.sensor->integrated_energy();
+                energy.marker = this->integrator_marker;
+                energy.phase = this->integrator_phase;
+                energy.samples = 0;
+                energy.sensor = i.sensor->name();
+                this->instrument_energies.push_back(energy);
+            }
+
+            if (id != 0) {
+                i.sensor->reset_integrator();
+                i.begin = create_timestamp(this->timestamp_resolution);
+                i.sensor->start_integrator();
+                i.running = true;
+            }
+        } catch (...) { /* The phase is lost for this instrument. */ }
+    }
+
+    this->integrator_marker = id;
+    ++this->integrator_phase;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::track_frames
+ */
+std::shared_ptr<visus::power_overwhelming::detail::frame_ring>
+visus::power_overwhelming::detail::collector_impl::track_frames(void) {
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+
+    // The ring has a single producer, so we only hand it out to one frame
+    // marker at a time. A disposed marker releases its reference.
+    if ((this->frames != nullptr) && (this->frames.use_count() > 1)) {
+        throw std::logic_error("A collector can only track the frames of a "
+            "single frame marker.");
+    }
+
+    if (this->frames == nullptr) {
+        this->frames = std::make_shared<frame_ring>(frame_capacity);
+    }
+
+    return this->frames;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::trigger
+ */
+void visus::power_overwhelming::detail::collector_impl::trigger(void) {
+    if ((this->pre_trigger.count() == 0) && (this->post_trigger.count() == 0)) {
+        return;
+    }
+
+    {
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        this->trigger_events.push_back(create_timestamp(
+            this->timestamp_resolution));
+    }
+
+    // Wake the I/O thread such that the retained samples are written before
+    // they are overwritten.
+    set_event(this->evt_write);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::write
+ */
+void visus::power_overwhelming::detail::collector_impl::write(void) {
+    using namespace std::chrono;
+    write_state state;
+
+    // The I/O thread is woken by the producers once a buffer reaches the
+    // threshold, so the timeout only bounds the latency of sparse samples. It
+    // must not be derived from the sampling interval, because sub-millisecond
+    // intervals would yield a zero timeout and make the thread spin.
+    const auto timeout = static_cast<unsigned int>((std::max)(
+        this->write_latency.count(), milliseconds::rep(1)));
+
+    enter_library_thread("PwrOwg Collector Writer Thread");
+
+    this->write(state, write_phase::begin);
+
+    while (state.running) {
+        // Check the flag before draining the buffers such that we always
+        // perform a last pass after the collector has been stopped.
+        state.running = this->running.load(
+            std::memory_order::memory_order_acquire);
+        if (state.running) {
+            wait_event(this->evt_write, timeout);
+        }
+
+        this->write(state, write_phase::pass);
+    }
+
+    this->write(state, write_phase::end);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::write
+ */
+void visus::power_overwhelming::detail::collector_impl::write(
+        write_state& state, const write_phase phase) {
+    using namespace std::chrono;
+    const auto arrow = (this->format == output_format::arrow);
+    const auto binary = (this->format == output_format::binary)
+        || (this->format == output_format::async_binary)
+        || (this->format == output_format::direct_binary)
+        || (this->format == output_format::mapped_binary)
+        || (this->format == output_format::network_binary);
+    const auto trace = (this->format == output_format::perfetto)
+        || (this->format == output_format::chrome_trace);
+    const auto wide = (this->format == output_format::wide_csv);
+    const auto convert_channel = get_timestamp_converter(
+        this->timestamp_resolution);
+    // The writer thread drains every stride-th buffer and leaves the others
+    // to the shards.
+    const auto stride = this->shards.size() + 1;
+
+    // The state retained between the passes is aliased such that the stages
+    // below read like the body of a single loop.
+    auto& aggregate = state.aggregate;
+    auto& aggregates = state.aggregates;
+    auto& buffers = state.buffers;
+    auto& captured = state.captured;
+    auto& gap = state.gap;
+    auto& channel_markers = state.channel_markers;
+    auto& count = state.count;
+    auto& counted_sensor = state.counted_sensor;
+    auto& counts = state.counts;
+    auto& declared_markers = state.declared_markers;
+    auto& derived_samples = state.derived_samples;
+    auto& ends = state.ends;
+    auto& estimates = state.estimates;
+    auto& estimated = state.estimated;
+    auto& events = state.events;
+    auto& filtered = state.filtered;
+    auto& finished_bytes = state.finished_bytes;
+    auto& have_header = state.have_header;
+    auto& names = state.names;
+    auto& new_markers = state.new_markers;
+    auto& pending_changes = state.pending_changes;
+    auto& pending_events = state.pending_events;
+    auto& pending_filters = state.pending_filters;
+    auto& pending_thresholds = state.pending_thresholds;
+    auto& pending_triggers = state.pending_triggers;
+    auto& previous = state.previous;
+    auto& resampled = state.resampled;
+    auto& running = state.running;
+    auto& smoothed = state.smoothed;
+    auto& sharded_counts = state.sharded_counts;
+    auto& subscribed = state.subscribed;
+    auto& subscribers = state.subscribers;
+    const auto& started = state.started;
+
+    if (phase == write_phase::begin) {
+        state.started = steady_clock::now();
+
+        // The events retrieved in a pass are swapped with the ones the markers
+        // are recorded in, so their capacity must be retained.
+        pending_events.reserve(marker_event_capacity);
+
+        {
+            // Convert the window to ticks of the timestamps, making sure that
+            // windows shorter than a tick do not disable the aggregation.
+            const auto tps = ticks_per_second(this->timestamp_resolution);
+            auto window = static_cast<timestamp_type>(
+                this->aggregation_window.count() * tps / 1000000.0 + 0.5);
+            if ((window == 0) && (this->aggregation_window.count() > 0)) {
+                window = 1;
+            }
+            this->aggregator.configure(window, tps);
+
+            // The capture mode is enabled by any of its windows, and its ring
+            // holds the number of samples of a buffer for each sensor.
+            const auto pre = static_cast<timestamp_type>(
+                this->pre_trigger.count() * tps / 1000000.0 + 0.5);
+            const auto post = static_cast<timestamp_type>(
+                this->post_trigger.count() * tps / 1000000.0 + 0.5);
+            std::size_t capacity = 0;
+            if ((this->pre_trigger.count() > 0)
+                    || (this->post_trigger.count() > 0)) {
+                std::lock_guard<decltype(this->gate_lock)> l(this->gate_lock);
+                capacity = this->buffer_size * (std::max)(std::size_t(1),
+                    this->sensors.size());
+            }
+            this->capture.configure(pre, post, this->trigger_threshold,
+                capacity);
+
+            auto step = static_cast<timestamp_type>(
+                this->resampling_interval.count() * tps / 1000000.0 + 0.5);
+            if ((step == 0) && (this->resampling_interval.count() > 0)) {
+                step = 1;
+            }
+            this->resampler.configure(step);
+
+            this->delta.configure(static_cast<timestamp_type>(
+                this->keep_alive_interval.count() * tps / 1000000.0 + 0.5));
+
+            // The derived sensors are evaluated on the grid of the resampler,
+            // such that their samples pass it unchanged, or on the sampling
+            // interval.
+            if (step == 0) {
+                step = static_cast<timestamp_type>(
+                    this->sampling_interval.count() * tps / 1000000.0 + 0.5);
+            }
+            this->derived.configure((std::max)(step, timestamp_type(1)));
+
+            // The lines of the wide layout are the same ticks, and they wait
+            // for slow sensors for at most a second.
+            this->wide_rows.configure(step, static_cast<timestamp_type>(tps));
+        }
+
+        this->filter.configure(this->retain_unfiltered);
+
+        {
+            // Only files are rotated, and the trace and the Arrow file cannot
+            // be split, because their structure spans the whole file.
+            const auto rotatable = !arrow && !trace
+                && (this->format != output_format::network_binary);
+            this->rotator.configure(this->output_path,
+                rotatable ? this->rotate_size : 0,
+                rotatable
+                    ? this->rotate_interval
+                    : std::chrono::microseconds(0),
+                output_rotator::clock_type::now());
+        }
+
+        if (arrow || binary || trace) {
+            // The binary output, the trace and the Arrow file describe all
+            // sensors we know in advance in their header. The names are
+            // retained for the header of the segments if the output is rotated.
+            {
+                std::lock_guard<decltype(this->gate_lock)> l(this->gate_lock);
+                names.reserve(this->sensors.size());
+                for (auto& s : this->sensors) {
+                    // The samples of multi-channel sensors are named after
+                    // their channels rather than the sensor itself.
+                    auto mc = dynamic_cast<multi_channel_sensor *>(s.get());
+                    if (mc != nullptr) {
+                        for (std::size_t c = 0; c < mc->channels(); ++c) {
+                            auto name = mc->channel(c).name();
+                            if (name != nullptr) {
+                                names.emplace_back(name);
+                            }
+                        }
+                        continue;
+                    }
+
+                    auto name = s->name();
+                    if (name != nullptr) {
+                        names.emplace_back(name);
+                    }
+                }
+            }
+
+            {
+                std::lock_guard<decltype(this->gate_lock)> l(this->gate_lock);
+                for (auto& e : this->power_estimators) {
+                    names.emplace_back(e.estimated);
+                    names.emplace_back(e.lower);
+                    names.emplace_back(e.upper);
+                }
+            }
+
+            for (auto& n : this->derived.names()) {
+                names.push_back(std::move(n));
+            }
+
+            if (binary) {
+                this->binary_stream->header(this->timestamp_resolution, names);
+                this->binary_stream->start(this->start_info);
+            } else if (arrow) {
+                this->arrow_stream.header(this->timestamp_resolution, names);
+            } else {
+                this->trace_stream.header(this->timestamp_resolution, names);
+            }
+
+        } else {
+            // The CSV output starts with comments describing the start.
+            this->stream->start(this->start_info);
+        }
+
+        // The shards are self-contained, so they start like the output of the
+        // writer thread. The names are only required by the binary output.
+        for (auto& s : this->shards) {
+            s->start(this->timestamp_resolution, names, this->start_info,
+                this->require_marker, this->samples);
+        }
+    }
+
+    auto declare = [&](const std::uint32_t id, const std::wstring& marker) {
+        // The text of a marker is only written once, whereas the samples
+        // only refer to its ID.
+        if (arrow) {
+            this->arrow_stream.marker(id, marker.c_str());
+        } else if (binary) {
+            this->binary_stream->marker(id, marker.c_str());
+        } else if (trace) {
+            this->trace_stream.marker(id, marker.c_str());
+        } else {
+            this->stream->marker(id, marker.c_str());
+        }
+    };
+
+    auto write_aggregate = [&](const sample_aggregate& a) {
+        // Arrow tables have a fixed schema, which only holds the samples.
+        if (arrow) {
+            return;
+        }
+
+        if (binary) {
+            this->binary_stream->aggregate(a);
+        } else if (trace) {
+            this->trace_stream.aggregate(a);
+        } else {
+            this->stream->aggregate(a);
+        }
+    };
+
+    auto write_sample = [&](const measurement& s, const std::uint32_t marker) {
+        if (arrow) {
+            this->arrow_stream.push(s, marker);
+            return;
+        }
+
+        if (binary) {
+            this->binary_stream->push(s, marker);
+            return;
+        }
+
+        if (trace) {
+            this->trace_stream.push(s, marker);
+            return;
+        }
+
+        if (wide) {
+            // The lines are assembled from the samples of all sensors and
+            // written when the pass is flushed.
+            this->wide_rows.push(s, marker);
+            return;
+        }
+
+        if (!have_header) {
+            // If this is the first line, print the CSV header.
+            have_header = true;
+            this->stream->header();
+        }
+
+        // Note: The writer only issues a system call if its buffer is full,
+        // because we flush the whole batch at the end of the pass.
+        this->stream->push(s, marker);
+    };
+
+    auto publish = [&](const measurement& s) {
+        this->shared_memory.publish(s);
+        if (subscribed) {
+            subscribers->push(s);
+        }
+    };
+
+    auto flush = [&](void) {
+        const auto begin = steady_clock::now();
+
+        // Each flush of the Arrow output yields a record batch.
+        if (arrow) {
+            this->arrow_stream.flush();
+        } else if (binary) {
+            this->binary_stream->flush();
+        } else if (trace) {
+            this->trace_stream.flush();
+        } else {
+            // The last pass and everything after it completes all lines.
+            if (wide) {
+                this->wide_rows.flush(*this->stream, !running);
+            }
+            this->stream->flush();
+        }
+
+        this->flush_duration.record(steady_clock::now() - begin);
+    };
+
+    auto publish_statistics = [&](void) {
+        // The size of the output can only be determined on the I/O thread,
+        // because querying the position of a stream is not thread-safe.
+        auto written = finished_bytes;
+        if (binary) {
+            written += this->binary_stream->written();
+        } else if (!arrow && !trace) {
+            written += this->stream->written();
+        }
+        for (auto& s : this->shards) {
+            written += s->written();
+        }
+        this->bytes_written.store(written, std::memory_order_relaxed);
+
+        // The shards count the samples of their sensors themselves.
+        auto published = &counts;
+        if (!this->shards.empty()) {
+            sharded_counts = counts;
+            for (auto& s : this->shards) {
+                s->counts(sharded_counts);
+            }
+            published = &sharded_counts;
+        }
+
+        // Only the sketches that changed are evaluated, which we do before
+        // acquiring the lock to keep the readers of the statistics waiting
+        // as briefly as possible.
+        auto quantiles = this->track_quantiles
+            ? &this->quantiles.summary()
+            : nullptr;
+
+        const auto elapsed = duration_cast<microseconds>(
+            steady_clock::now() - started);
+        std::lock_guard<decltype(this->statistics_lock)> l(
+            this->statistics_lock);
+        this->sensor_samples.assign(published->begin(), published->end());
+        this->statistics_elapsed = elapsed;
+        if (this->integrate_energy) {
+            this->marker_energies = this->phase_energies.markers();
+        }
+        if (quantiles != nullptr) {
+            this->published_quantiles = *quantiles;
+        }
+    };
+
+    auto rotate = [&](void) {
+        const auto now = output_rotator::clock_type::now();
+        const auto written = binary
+            ? this->binary_stream->written()
+            : this->stream->written();
+        if (!this->rotator.due(written, now)) {
+            return;
+        }
+
+        // The new segment must be self-contained, so it repeats the start
+        // and all markers declared so far.
+        std::vector<std::wstring> markers;
+        {
+            std::lock_guard<decltype(this->lock)> l(this->lock);
+            markers.assign(this->marker_names.begin() + 1,
+                this->marker_names.begin() + declared_markers);
+        }
+
+        const auto path = this->rotator.next_path();
+        try {
+            if (binary) {
+                std::unique_ptr<binary_output_writer> s(
+                    new binary_output_writer());
+                s->compressed(this->binary_stream->compressed());
+                if ((this->format == output_format::async_binary)
+                        || (this->format == output_format::direct_binary)) {
+                    s->open_async(path.c_str(),
+                        (this->format == output_format::direct_binary));
+                } else {
+                    s->open(path.c_str(),
+                        (this->format == output_format::mapped_binary));
+                }
+
+                s->header(this->timestamp_resolution, names);
+                s->start(this->start_info);
+                for (std::uint32_t i = 1; i < declared_markers; ++i) {
+                    s->marker(i, markers[i - 1].c_str());
+                }
+
+                {
+                    std::lock_guard<decltype(this->lock)> l(this->lock);
+                    std::swap(this->binary_stream, s);
+                }
+                this->rotator.finalise(std::move(s));
+
+            } else {
+                std::unique_ptr<csv_output_writer> s(new csv_output_writer());
+                s->delimiter(this->stream->delimiter());
+                s->quote(this->stream->quote());
+                s->open(path.c_str());
+
+                s->start(this->start_info);
+                for (std::uint32_t i = 1; i < declared_markers; ++i) {
+                    s->marker(i, markers[i - 1].c_str());
+                }
+
+                std::swap(this->stream, s);
+                this->rotator.finalise(std::move(s));
+                have_header = false;
+                this->wide_rows.restart();
+            }
+
+            finished_bytes += written;
+            this->rotator.advance(now);
+        } catch (std::exception&) {
+            // Losing the segment is better than losing the samples, so we
+            // continue in the current one and try again later.
+            this->rotator.defer(written, now);
+        }
+    };
+
+    auto persist = [&](const measurement& s, const std::uint32_t marker) {
+        if (this->aggregator.enabled()) {
+            // The sample is added after the closed window has been emitted,
+            // so the aggregates precede the raw samples of the next window.
+            if (this->aggregator.push(s, marker, aggregate)) {
+                write_aggregate(aggregate);
+            }
+
+            if (this->aggregate_only) {
+                return;
+            }
+        }
+
+        // Only the raw output is resampled, whereas the aggregates are based
+        // on the samples as they have been measured.
+        if (this->resampler.enabled()) {
+            this->resampler.push(s, marker, resampled);
+            for (auto& r : resampled) {
+                write_sample(r.first, r.second);
+            }
+            resampled.clear();
+        } else {
+            write_sample(s, marker);
+        }
+    };
+
+    auto is_duplicate = [&](const measurement& s) {
+        auto it = previous.find(s.sensor());
+        if (it == previous.end()) {
+            previous.emplace(s.sensor(), s);
+            return false;
+        }
+
+        const auto retval = (s.voltage() == it->second.voltage())
+            && (s.current() == it->second.current())
+            && (s.power() == it->second.power());
+        it->second = s;
+        return retval;
+    };
+
+    auto release = [&](const measurement& s, const std::uint32_t marker) {
+        if (this->capture.enabled()) {
+            this->capture.push(s, marker, captured);
+            for (auto& c : captured) {
+                persist(c.first, c.second);
+            }
+            captured.clear();
+        } else {
+            persist(s, marker);
+        }
+    };
+
+    auto emit = [&](const measurement& s) {
+        std::uint32_t marker = 0;
+        // The phases are the intervals between the events, starting with the
+        // one before the first marker.
+        std::uint32_t phase = 0;
+        timestamp_type phase_begin = 0;
+
+        // Find the last marker that has been set before the sample was
+        // created. Most samples are newer than the last marker, so we check
+        // this before searching the whole history.
+        if (!events.empty() && (s.timestamp() >= events.back().first)) {
+            marker = events.back().second;
+            phase = static_cast<std::uint32_t>(events.size());
+            phase_begin = events.back().first;
+        } else {
+            auto it = std::upper_bound(events.begin(), events.end(),
+                s.timestamp(), [](const timestamp_type lhs,
+                    const marker_event_type& rhs) {
+                return (lhs < rhs.first);
+            });
+            phase = static_cast<std::uint32_t>(it - events.begin());
+            if (it != events.begin()) {
+                --it;
+                marker = it->second;
+                phase_begin = it->first;
+            }
+        }
+
+        // The kernels run regardless of the markers, so their energy must
+        // not have any gaps.
+        if (!this->kernel_energy_path.empty()) {
+            this->kernel_energies.push(s);
+        }
+
+        if (this->require_marker && (marker == 0)) {
+            return;
+        }
+
+        if (this->integrate_energy) {
+            this->phase_energies.push(s, phase, phase_begin, marker);
+        }
+
+        if (this->track_quantiles) {
+            this->quantiles.push(s, marker);
+        }
+
+        if (this->suppress_duplicates && is_duplicate(s)) {
+            return;
+        }
+
+        if (this->delta.enabled()) {
+            this->delta.push(s, marker, filtered);
+            for (auto& f : filtered) {
+                release(f.first, f.second);
+            }
+            filtered.clear();
+        } else {
+            release(s, marker);
+        }
+    };
+
+    auto emit_smoothed = [&](void) {
+        // The filtered samples are processed like the ones drained from the
+        // buffers, but only after the whole batch has been filtered.
+        for (auto& s : smoothed) {
+            publish(s);
+            this->derived.push(s);
+            emit(s);
+        }
+        smoothed.clear();
+    };
+
+    auto emit_estimates = [&](void) {
+        {
+            std::lock_guard<decltype(this->gate_lock)> l(this->gate_lock);
+            for (auto& e : this->power_estimators) {
+                estimates.resize(e.sensor->estimates(nullptr, 0));
+                estimates.resize(e.sensor->estimates(estimates.data(),
+                    estimates.size()));
+
+                for (auto& p : estimates) {
+                    estimated.emplace_back(e.estimated, p.timestamp(),
+                        p.power());
+                    estimated.emplace_back(e.lower, p.timestamp(), p.lower());
+                    estimated.emplace_back(e.upper, p.timestamp(), p.upper());
+                }
+            }
+        }
+
+        // The estimates are based on the activity at the time of the sample
+        // rather than on the average of the driver, so they are not aligned.
+        for (auto& e : estimated) {
+            publish(e);
+            this->derived.push(e);
+            emit(e);
+        }
+        estimated.clear();
+    };
+
+    if (phase == write_phase::begin) {
+        return;
+    }
+
+    if (phase == write_phase::pass) {
+        // Markers from other processes are recorded like the ones set via
+        // the API, but with the time stamped by the client. The normal
+        // processing below sorts them in between the events that have been
+        // recorded in the meantime. We must do this before taking the lock,
+        // because recording a marker acquires it, too.
+        if (this->marker_channel.poll(channel_markers) > 0) {
+            for (auto& m : channel_markers) {
+                const auto timestamp = convert_channel(m.first);
+                const auto id = m.second.empty()
+                    ? 0
+                    : this->register_marker(power_overwhelming::convert_string<
+                        wchar_t>(m.second).c_str());
+                this->record_marker(id, &timestamp);
+            }
+            channel_markers.clear();
+        }
+
+        {
+            std::lock_guard<decltype(this->lock)> l(this->lock);
+            // Swap the events such that the threads setting markers can
+            // continue in the memory we have already allocated.
+            std::swap(pending_events, this->marker_events);
+            std::swap(pending_changes, this->schema_changes);
+            std::swap(pending_triggers, this->trigger_events);
+            std::swap(pending_thresholds, this->resolved_thresholds);
+            std::swap(pending_filters, this->resolved_filters);
+
+            for (auto i = declared_markers; i < this->marker_names.size();
+                    ++i) {
+                new_markers.push_back(this->marker_names[i]);
+            }
+
+            // Only copy the pointers such that we do not hold the lock while
+            // writing. The buffers themselves remain valid. We also remember
+            // the current end of each buffer, because samples added after
+            // that might belong to a marker we have not yet retrieved.
+            buffers.resize(this->buffers.size());
+            ends.resize(this->buffers.size());
+            for (std::size_t i = 0; i < buffers.size(); ++i) {
+                buffers[i] = this->buffers[i].get();
+                ends[i] = buffers[i]->position();
+            }
+
+            // The frame boundaries are retrieved after the ends of the
+            // buffers such that no sample taken after a boundary can be
+            // processed without it. They are sorted in like any other event.
+            if (this->frames != nullptr) {
+                this->frames->drain([&pending_events](
+                        const marker_event_type& e,
+                        const frame_ring::position_type) {
+                    pending_events.push_back(e);
+                });
+            }
+
+            // The ring is never replaced, but it might have been created
+            // since the last pass. Samples are only copied into it while
+            // anyone is listening.
+            subscribers = this->subscribers.get();
+            subscribed = (subscribers != nullptr)
+                && subscribers->subscribed();
+        }
+
+        // The shards receive all markers, but only the buffers assigned to
+        // them, whose ends have been retrieved along with the markers.
+        for (std::size_t i = 0; i < this->shards.size(); ++i) {
+            this->shards[i]->post(new_markers, pending_events, buffers, ends,
+                i + 1, stride);
+        }
+
+        for (auto& m : new_markers) {
+            declare(declared_markers++, m);
+        }
+        new_markers.clear();
+
+        for (auto& t : pending_thresholds) {
+            this->delta.threshold(t.first, t.second);
+        }
+        pending_thresholds.clear();
+
+        for (auto& f : pending_filters) {
+            this->filter.filter(f.first, f.second);
+        }
+        pending_filters.clear();
+
+        // All events are retained, because samples are not ordered across
+        // buffers and might be older than the last event.
+        for (auto& e : pending_events) {
+            if (binary) {
+                this->binary_stream->marker_event(e.first, e.second);
+            } else if (trace) {
+                this->trace_stream.marker_event(e.first, e.second);
+            } else if (!arrow) {
+                this->stream->marker_event(e.first, e.second);
+            }
+        }
+        this->marker_event_count.fetch_add(pending_events.size(),
+            std::memory_order_relaxed);
+        // Markers set at a given time might be older than the ones we already
+        // have, so they must be sorted in. The events of a single thread are
+        // in order, so we keep the order of events with the same time.
+        for (auto& e : pending_events) {
+            if (events.empty() || (e.first >= events.back().first)) {
+                events.push_back(e);
+            } else {
+                auto it = std::upper_bound(events.begin(), events.end(),
+                    e.first, [](const timestamp_type lhs,
+                        const marker_event_type& rhs) {
+                    return (lhs < rhs.first);
+                });
+                events.insert(it, e);
+            }
+        }
+        pending_events.clear();
+
+        // Changes of the sensors are written before the samples retrieved in
+        // the same pass, which might already stem from an added sensor. The
+        // trace declares the tracks of added sensors on their first sample.
+        for (auto& c : pending_changes) {
+            if (binary) {
+                this->binary_stream->schema_change(c);
+            } else if (!arrow && !trace) {
+                this->stream->schema_change(c);
+            }
+        }
+        pending_changes.clear();
+
+        // Triggers release the retained samples before the new ones are
+        // drained, which are then in the window if they belong to it.
+        for (auto t : pending_triggers) {
+            this->capture.trigger(t, captured);
+            for (auto& c : captured) {
+                persist(c.first, c.second);
+            }
+            captured.clear();
+        }
+        pending_triggers.clear();
+
+        std::uint64_t retrieved = 0;
+        for (std::size_t b = 0; b < buffers.size(); b += stride) {
+            buffers[b]->drain([&](const measurement& r,
+                    const buffer_type::position_type) {
+                ++retrieved;
+                // Samples of a buffer typically stem from the same sensor, so
+                // we avoid looking up its counter for every sample.
+                if (r.sensor() != counted_sensor) {
+                    counted_sensor = r.sensor();
+                    count = &counts[counted_sensor];
+                }
+                ++*count;
+                // Everything downstream, including the live samples, uses the
+                // aligned timestamps. The aligner returns the sample as it is
+                // if no sensor has been registered.
+                const auto s = this->aligner.align(r);
+                // The aligner does not preserve the sequence number, so we
+                // must check it on the original sample.
+                if (this->track_sequences && this->sequences.push(r, gap)) {
+                    gap.timestamp = s.timestamp();
+                    if (binary) {
+                        this->binary_stream->sequence_gap(gap);
+                    } else if (!arrow && !trace) {
+                        this->stream->sequence_gap(gap);
+                    }
+                }
+                if (this->record_overhead) {
+                    this->overhead.push(s);
+                }
+                // Filtered samples are released after the pass, because the
+                // filters process all samples of a sensor at once.
+                if (this->filter.push(s)) {
+                    return;
+                }
+                // Consumers of the live samples are not interested in markers,
+                // so we publish them before they might be discarded.
+                publish(s);
+                this->derived.push(s);
+                emit(s);
+            }, ends[b]);
+        }
+        this->samples.fetch_add(retrieved, std::memory_order_relaxed);
+
+        if (this->filter.enabled()) {
+            this->filter.process(smoothed);
+            emit_smoothed();
+        }
+
+        if (this->estimate_power) {
+            emit_estimates();
+        }
+
+        // The derived sensors are evaluated for all grid points the samples
+        // of this pass have completed.
+        this->derived.evaluate(derived_samples);
+        for (auto& d : derived_samples) {
+            publish(d);
+            emit(d);
+        }
+        derived_samples.clear();
+
+        // The overhead is averaged over the time since the previous pass,
+        // i.e. it is based on the samples we have just written.
+        measurement::value_type overhead;
+        if (this->record_overhead && this->overhead.sample(overhead)) {
+            emit(measurement(overhead_estimator::sensor_name,
+                create_timestamp(this->timestamp_resolution), overhead));
+        }
+
+        // The subscribers are woken once per pass rather than per sample.
+        if (subscribed) {
+            subscribers->commit();
+        }
+
+        flush();
+
+        if (this->rotator.enabled()) {
+            rotate();
+        }
+
+        publish_statistics();
+        return;
+    }
+
+    if (this->filter.enabled()) {
+        // The windows of the last samples are completed such that no sample
+        // of a filtered sensor is lost.
+        this->filter.flush(smoothed);
+        emit_smoothed();
+
+        this->derived.evaluate(derived_samples);
+        for (auto& d : derived_samples) {
+            emit(d);
+        }
+        derived_samples.clear();
+
+        flush();
+    }
+
+    if (!this->instrument_samples.empty()) {
+        // The logs of the instruments are only available after the collector
+        // has stopped, so they cannot be interleaved with the live samples,
+        // but the markers are assigned in the same way based on the time they
+        // have been set.
+        for (auto& s : this->instrument_samples) {
+            this->derived.push(s);
+            emit(s);
+        }
+
+        this->derived.evaluate(derived_samples);
+        for (auto& d : derived_samples) {
+            emit(d);
+        }
+        derived_samples.clear();
+
+        this->instrument_samples.clear();
+
+        flush();
+    }
+
+    if (this->delta.enabled()) {
+        // The last unchanged samples mark the end of the plateaus, which
+        // would otherwise be lost.
+        this->delta.flush(filtered);
+        for (auto& f : filtered) {
+            release(f.first, f.second);
+        }
+        filtered.clear();
+
+        flush();
+    }
+
+    if (this->aggregator.enabled()) {
+        // Close the windows that are still open, which are incomplete.
+        this->aggregator.flush(aggregates);
+        for (auto& a : aggregates) {
+            write_aggregate(a);
+        }
+
+        flush();
+    }
+
+    if (this->integrate_energy) {
+        // All samples have been integrated at this point, so the summary of
+        // the phases is complete.
+        for (auto& e : this->phase_energies.summary()) {
+            if (binary) {
+                this->binary_stream->phase_energy(e);
+            } else if (!arrow && !trace) {
+                this->stream->phase_energy(e);
+            }
+        }
+    }
+
+    if (this->integrate_instruments) {
+        // The integrators have been read when the collector was stopped,
+        // before the I/O thread has been told to exit.
+        std::lock_guard<decltype(this->gate_lock)> l(this->gate_lock);
+        for (auto& e : this->instrument_energies) {
+            if (binary) {
+                this->binary_stream->phase_energy(e);
+            } else if (!arrow && !trace) {
+                this->stream->phase_energy(e);
+            }
+        }
+    }
+
+    if (this->track_quantiles) {
+        for (auto& q : this->quantiles.summary()) {
+            if (binary) {
+                this->binary_stream->phase_quantiles(q);
+            } else if (!arrow && !trace) {
+                this->stream->phase_quantiles(q);
+            }
+        }
+    }
+
+    if (this->track_sequences) {
+        for (auto& s : this->sequences.summary()) {
+            if (binary) {
+                this->binary_stream->sequence_summary(s);
+            } else if (!arrow && !trace) {
+                this->stream->sequence_summary(s);
+            }
+        }
+    }
+
+#if defined(POWER_OVERWHELMING_WITH_CUPTI)
+    if (!this->kernel_energy_path.empty()) {
+        // All samples have been integrated at this point, so we can add the
+        // kernels, which are only delivered in bulk once tracing stops.
+        // Note: We do not throw from the writer thread, wherefore an output
+        // file that cannot be written is silently skipped.
+        cupti_kernel_tracer::instance().stop(this->kernel_energies,
+            this->timestamp_resolution);
+
+        std::ofstream file;
+#if defined(_WIN32)
+        file.open(this->kernel_energy_path, std::ofstream::out
+            | std::ofstream::trunc);
+#else /* defined(_WIN32) */
+        file.open(power_overwhelming::convert_string<char>(
+            this->kernel_energy_path), std::ofstream::out
+            | std::ofstream::trunc);
+#endif /* defined(_WIN32) */
+        if (file.is_open()) {
+            write_kernel_energy(file, this->kernel_energies.summary());
+        }
+    }
+#endif /* defined(POWER_OVERWHELMING_WITH_CUPTI) */
+
+    if (this->write_statistics) {
+        // All sensors have been stopped at this point, so the statistics are
+        // final, but the contexts remain registered.
+        std::vector<sampler_statistics_impl> statistics;
+        sampler_instrumentation::snapshot_all(statistics);
+
+        for (auto& s : statistics) {
+            if (binary) {
+                this->binary_stream->statistics(s);
+            } else if (!arrow && !trace) {
+                this->stream->statistics(s);
+            }
+        }
+    }
+
+    // The shards have received everything in the last pass, so they can
+    // write their remaining samples and close their output.
+    for (auto& s : this->shards) {
+        s->stop();
+    }
+
+    // The samples written after the last pass are only included if we
+    // publish the counters once more before the output is closed.
+    publish_statistics();
+
+    this->marker_channel.close();
+    this->shared_memory.close();
+    this->close();
 
-    this->stream.close();
+    // The last segment has been closed above, but its predecessors might
+    // still be finalised in the background.
+    this->rotator.wait();
 }
@@ -12,14 +12,57 @@
 #include <mutex>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #if defined(_WIN32)
 #include <Windows.h>
 #endif /* defined(_WIN32) */
 
+#include <nlohmann/json.hpp>
+
 #include "power_overwhelming/collector_settings.h"
 #include "power_overwhelming/event.h"
+#include "power_overwhelming/hmc8015_sensor.h"
+#include "power_overwhelming/nvml_sensor.h"
+#include "power_overwhelming/output_format.h"
+#include "power_overwhelming/power_estimate.h"
+#include "power_overwhelming/rtx_sensor.h"
+#include "power_overwhelming/tinkerforge_sensor.h"
+
+#include "arrow_output.h"
+#include "atomic_latency_histogram.h"
+#include "binary_output.h"
+#include "collector_statistics_impl.h"
+#include "csv_output.h"
+#include "delta_filter.h"
+#include "derived_evaluator.h"
+#include "filter_stage.h"
+#include "frame_marker_impl.h"
+#include "grid_resampler.h"
+#include "kernel_energy.h"
+#include "marker_channel_listener.h"
+#include "memory_lock.h"
+#include "output_rotator.h"
+#include "overhead_estimator.h"
+#include "overhead_experiment.h"
+#include "phase_energy.h"
+#include "phase_quantiles.h"
+#include "sample_aggregator.h"
+#include "sampling_budget.h"
+#include "schema_change.h"
+#include "sequence_tracker.h"
+#include "shared_measurement_writer.h"
+#include "spsc_ring.h"
+#include "start_record.h"
+#include "subscriber_ring.h"
+#include "timestamp.h"
+#include "timestamp_aligner.h"
+#include "trace_output.h"
+#include "trigger_capture.h"
+#include "waveform_archive.h"
+#include "wide_csv_rows.h"
+#include "writer_shard.h"
 
 
 namespace visus {
@@ -29,23 +72,200 @@ namespace detail {
     /// <summary>
     /// Private data container for <see cref="collector" />.
     /// </summary>
-    struct collector_impl final {
+    /// <remarks>
+    /// The container is exported such that the benchmarks can feed samples
+    /// directly into the buffers of the collector.
+    /// </remarks>
+    struct POWER_OVERWHELMING_API collector_impl final {
 
         /// <summary>
         /// The type of the buffer for incoming measurements that are kept until
         /// they can be written to disk.
         /// </summary>
-        typedef std::vector<measurement> buffer_type;
+        /// <remarks>
+        /// There is one buffer for each thread delivering samples, and all of
+        /// them are drained by the <see cref="writer_thread" />.
+        /// </remarks>
+        typedef spsc_ring<measurement> buffer_type;
+
+        /// <summary>
+        /// The type of a list of buffers.
+        /// </summary>
+        typedef std::vector<std::unique_ptr<buffer_type>> buffer_list_type;
+
+        /// <summary>
+        /// Represents the event of a marker being set, which comprises the
+        /// time when the marker was set and the ID of the marker.
+        /// </summary>
+        /// <remarks>
+        /// A marker is active for all samples from its timestamp until the
+        /// timestamp of the next event. The ID zero designates that the marker
+        /// has been cleared.
+        /// </remarks>
+        typedef std::pair<timestamp_type, std::uint32_t> marker_event_type;
+
+        /// <summary>
+        /// The type of a list of marker events.
+        /// </summary>
+        typedef std::vector<marker_event_type> marker_event_list_type;
+
+        /// <summary>
+        /// The number of marker events that can be recorded without
+        /// allocating memory on the thread setting the markers.
+        /// </summary>
+        static constexpr std::size_t marker_event_capacity = 64;
+
+        /// <summary>
+        /// The number of frame boundaries that can be pending before the
+        /// <see cref="frame_marker" /> starts dropping them.
+        /// </summary>
+        static constexpr std::size_t frame_capacity = 1024;
+
+        /// <summary>
+        /// Describes an instrument whose hardware integrator measures the
+        /// energy per phase while the collector is running.
+        /// </summary>
+        struct instrument_integrator final {
+
+            /// <summary>
+            /// The time when the integrator has been started.
+            /// </summary>
+            timestamp_type begin;
+
+            /// <summary>
+            /// Indicates whether the integrator is currently running.
+            /// </summary>
+            bool running;
+
+            /// <summary>
+            /// The instrument, which is owned by <see cref="sensors" />.
+            /// </summary>
+            hmc8015_sensor *sensor;
+        };
+
+        /// <summary>
+        /// Describes an instrument that logs on its own while the collector is
+        /// running.
+        /// </summary>
+        struct instrument_log final {
+
+            /// <summary>
+            /// The logging interval in seconds.
+            /// </summary>
+            double interval;
+
+            /// <summary>
+            /// The instrument, which is owned by <see cref="sensors" />.
+            /// </summary>
+            hmc8015_sensor *sensor;
+
+            /// <summary>
+            /// The time when logging has been started.
+            /// </summary>
+            timestamp_type start;
+        };
+
+        /// <summary>
+        /// Describes a GPU whose power is estimated in addition to being
+        /// measured.
+        /// </summary>
+        struct power_estimator final {
+
+            /// <summary>
+            /// The interned name of the estimated power.
+            /// </summary>
+            const wchar_t *estimated;
+
+            /// <summary>
+            /// The interned name of the lower bound of the estimate.
+            /// </summary>
+            const wchar_t *lower;
+
+            /// <summary>
+            /// The sensor in estimation mode, which is owned by
+            /// <see cref="sensors" />.
+            /// </summary>
+            nvml_sensor *sensor;
+
+            /// <summary>
+            /// The interned name of the upper bound of the estimate.
+            /// </summary>
+            const wchar_t *upper;
+        };
+
+        /// <summary>
+        /// Identifies the part of <see cref="write" /> to be executed.
+        /// </summary>
+        enum class write_phase {
+
+            /// <summary>
+            /// Configures the processing stages and writes the header of the
+            /// output.
+            /// </summary>
+            begin,
+
+            /// <summary>
+            /// Drains the buffers once and writes their samples.
+            /// </summary>
+            pass,
+
+            /// <summary>
+            /// Completes and closes the output after the last pass.
+            /// </summary>
+            end
+        };
 
         /// <summary>
-        /// Represents a marker in the measurement buffer.
+        /// The state of the I/O that is retained between the passes of
+        /// <see cref="write" />.
         /// </summary>
-        typedef std::pair<std::wstring, std::size_t> marker_type;
+        /// <remarks>
+        /// The state lives on the stack of the <see cref="writer_thread" />,
+        /// or in <see cref="pump_state" /> if the application drives the
+        /// I/O via <see cref="pump" />. Most of the members are scratch
+        /// buffers whose capacity is retained between the passes.
+        /// </remarks>
+        struct write_state final {
+            sample_aggregate aggregate;
+            std::vector<sample_aggregate> aggregates;
+            std::vector<buffer_type *> buffers;
+            std::vector<trigger_capture::sample_type> captured;
+            std::vector<marker_channel_listener::marker_type> channel_markers;
+            std::uint64_t *count = nullptr;
+            const wchar_t *counted_sensor = nullptr;
+            std::unordered_map<const wchar_t *, std::uint64_t> counts;
+            std::uint32_t declared_markers = 1;
+            std::vector<measurement> derived_samples;
+            std::vector<buffer_type::position_type> ends;
+            std::vector<power_estimate> estimates;
+            std::vector<measurement> estimated;
+            marker_event_list_type events;
+            std::vector<delta_filter::sample_type> filtered;
+            std::uint64_t finished_bytes = 0;
+            sequence_gap gap;
+            bool have_header = false;
+            std::vector<std::wstring> names;
+            std::vector<std::wstring> new_markers;
+            std::vector<schema_change> pending_changes;
+            marker_event_list_type pending_events;
+            std::vector<std::pair<std::wstring, sample_filter>>
+                pending_filters;
+            std::vector<std::pair<std::wstring, float>> pending_thresholds;
+            std::vector<timestamp_type> pending_triggers;
+            std::unordered_map<const wchar_t *, measurement> previous;
+            std::vector<grid_resampler::sample_type> resampled;
+            bool running = true;
+            std::unordered_map<const wchar_t *, std::uint64_t> sharded_counts;
+            std::vector<measurement> smoothed;
+            std::chrono::steady_clock::time_point started;
+            bool subscribed = false;
+            subscriber_ring *subscribers = nullptr;
+        };
 
         /// <summary>
-        /// The type of a marker list.
+        /// The name of the log file on the instruments.
         /// </summary>
-        typedef std::vector<marker_type> marker_list_type;
+        static constexpr const char *instrument_log_file = "PWROWG.CSV";
 
         /// <summary>
         /// The type to specify the resolution of timestamps.
@@ -60,6 +280,17 @@ namespace detail {
         /// <param name="context"></param>
         static void on_measurement(const measurement& m, void *context);
 
+        /// <summary>
+        /// Processes batches of asynchronously created samples.
+        /// </summary>
+        /// <param name="sensor"></param>
+        /// <param name="samples"></param>
+        /// <param name="cnt"></param>
+        /// <param name="context"></param>
+        static void on_measurement_data(const wchar_t *sensor,
+            const measurement_data *samples, const std::size_t cnt,
+            void *context);
+
         /// <summary>
         /// The default resolution of timestamps.
         /// </summary>
@@ -67,124 +298,1520 @@ namespace detail {
             = timestamp_resolution_type::milliseconds;
 
         /// <summary>
-        /// Buffers the measurements until a marker is reached.
+        /// Indicates whether only the aggregates created by the
+        /// <see cref="aggregator" /> are written, but not the raw samples.
+        /// </summary>
+        bool aggregate_only;
+
+        /// <summary>
+        /// The length of the windows the samples are aggregated in, which is
+        /// zero if the samples are not aggregated.
+        /// </summary>
+        std::chrono::microseconds aggregation_window;
+
+        /// <summary>
+        /// Reduces the samples in windows of the
+        /// <see cref="aggregation_window" />. The aggregator must only be used
+        /// by the <see cref="writer_thread" />.
+        /// </summary>
+        sample_aggregator aggregator;
+
+        /// <summary>
+        /// Indicates whether the timestamps of sensors stamping their samples
+        /// after an averaging period are aligned.
+        /// </summary>
+        bool align_timestamps;
+
+        /// <summary>
+        /// Stores the complete waveforms of the oscilloscopes if
+        /// <see cref="waveform_archive_path" /> is not empty.
         /// </summary>
-        buffer_type buffer;
+        waveform_archive archive;
+
+        /// <summary>
+        /// Aligns the timestamps of the samples if
+        /// <see cref="align_timestamps" /> is set or if delays have been
+        /// calibrated for the sensors. This aligner must only be used by the
+        /// <see cref="writer_thread" /> once the collector is running.
+        /// </summary>
+        timestamp_aligner aligner;
+
+        /// <summary>
+        /// The writer for the results if the <see cref="format" /> is
+        /// <see cref="output_format::arrow" />.
+        /// </summary>
+        arrow_output_writer arrow_stream;
+
+        /// <summary>
+        /// The writer for the results if the <see cref="format" /> is
+        /// <see cref="output_format::binary" />.
+        /// </summary>
+        /// <remarks>
+        /// The writer is replaced by the <see cref="writer_thread" /> when
+        /// the output is rotated. Replacing it and using it from other
+        /// threads is protected by <see cref="lock" />.
+        /// </remarks>
+        std::unique_ptr<binary_output_writer> binary_stream;
+
+        /// <summary>
+        /// The intervals the <see cref="rate_budget" /> has granted to the
+        /// live sensors it had to slow down.
+        /// </summary>
+        /// <remarks>
+        /// This map is protected by <see cref="gate_lock" />.
+        /// </remarks>
+        std::unordered_map<const sensor *, std::chrono::microseconds>
+            budget_intervals;
+
+        /// <summary>
+        /// The number of samples each of the <see cref="buffers" /> can hold.
+        /// </summary>
+        std::size_t buffer_size;
+
+        /// <summary>
+        /// The buffers for each of the threads delivering samples.
+        /// </summary>
+        /// <remarks>
+        /// Buffers are only ever added to this list while the collector is
+        /// alive, so that pointers to the buffers remain valid.
+        /// </remarks>
+        buffer_list_type buffers;
+
+        /// <summary>
+        /// The number of bytes the <see cref="writer_thread" /> has written
+        /// to all segments of the output, which is updated after each pass.
+        /// </summary>
+        std::atomic<std::uint64_t> bytes_written;
+
+        /// <summary>
+        /// Retains the samples in capture mode until a trigger is raised. The
+        /// capture must only be used by the <see cref="writer_thread" />.
+        /// </summary>
+        trigger_capture capture;
+
+        /// <summary>
+        /// Indicates whether the samples in the <see cref="archive" /> are
+        /// compressed.
+        /// </summary>
+        bool compress_waveforms;
+
+        /// <summary>
+        /// Retains the samples of sensors that have not changed. The filter
+        /// must only be used by the <see cref="writer_thread" />.
+        /// </summary>
+        delta_filter delta;
+
+        /// <summary>
+        /// The descriptors of the sensors that have been validated, but not
+        /// yet been created, because the hardware is only opened once the
+        /// collector is started.
+        /// </summary>
+        /// <remarks>
+        /// The sensors are created by <see cref="open_deferred_sensors" />
+        /// and moved to the end of <see cref="sensors" />. This array is
+        /// protected by <see cref="gate_lock" /> like the sensors.
+        /// </remarks>
+        nlohmann::json deferred_sensors;
+
+        /// <summary>
+        /// The thresholds for the change-only emission configured for the
+        /// names or the types of sensors.
+        /// </summary>
+        std::unordered_map<std::wstring, float> delta_thresholds;
+
+        /// <summary>
+        /// Computes the samples of the derived sensors. The evaluator must
+        /// only be used by the <see cref="writer_thread" /> while the
+        /// collector is running.
+        /// </summary>
+        derived_evaluator derived;
+
+        /// <summary>
+        /// Indicates whether the power of NVIDIA GPUs is estimated from their
+        /// activity.
+        /// </summary>
+        bool estimate_power;
+
+        /// <summary>
+        /// An event telling the <see cref="experiment_thread" /> to exit.
+        /// </summary>
+        event_type evt_experiment;
 
         /// <summary>
         /// An event to wake the I/O thread.
         /// </summary>
         event_type evt_write;
 
+        /// <summary>
+        /// Records the progress of the workload in the windows of an overhead
+        /// experiment. Except for reporting progress, the experiment is
+        /// guarded by <see cref="gate_lock" />.
+        /// </summary>
+        overhead_experiment experiment;
+
+        /// <summary>
+        /// The sampling interval in the reference windows of the
+        /// <see cref="experiment" />, which is zero if the sensors are
+        /// stopped in these windows.
+        /// </summary>
+        std::chrono::microseconds experiment_interval;
+
+        /// <summary>
+        /// The path to the report of the <see cref="experiment" />, which is
+        /// empty if no experiment is performed.
+        /// </summary>
+        std::wstring experiment_report;
+
+        /// <summary>
+        /// The thread executing <see cref="run_experiment" /> if the windows
+        /// of the <see cref="experiment" /> are switched by time.
+        /// </summary>
+        std::thread experiment_thread;
+
+        /// <summary>
+        /// The length of the windows of the <see cref="experiment" />, which
+        /// is zero if the windows are switched by markers.
+        /// </summary>
+        std::chrono::microseconds experiment_window;
+
+        /// <summary>
+        /// Filters the samples of the sensors with a filter in
+        /// <see cref="sample_filters" />. The stage must only be used by the
+        /// <see cref="writer_thread" />.
+        /// </summary>
+        filter_stage filter;
+
+        /// <summary>
+        /// The time the <see cref="writer_thread" /> took to flush the output
+        /// after each pass.
+        /// </summary>
+        atomic_latency_histogram flush_duration;
+
+        /// <summary>
+        /// The format of the output file.
+        /// </summary>
+        /// <remarks>
+        /// Depending on the format, <see cref="stream" />,
+        /// <see cref="arrow_stream" />, <see cref="binary_stream" /> or
+        /// <see cref="trace_stream" /> is used.
+        /// </remarks>
+        output_format format;
+
+        /// <summary>
+        /// The ring that the <see cref="frame_marker" /> pushes the frame
+        /// boundaries to, which is created by <see cref="track_frames" />.
+        /// </summary>
+        /// <remarks>
+        /// The pointer is protected by <see cref="lock" />. The
+        /// <see cref="writer_thread" /> is the only consumer of the ring.
+        /// </remarks>
+        std::shared_ptr<frame_ring> frames;
+
+        /// <summary>
+        /// Serialises stopping and restarting the <see cref="live_sensors" />
+        /// if <see cref="require_marker" /> is set.
+        /// </summary>
+        /// <remarks>
+        /// This lock is separate from <see cref="lock" />, because stopping a
+        /// sensor flushes its pending samples into the <see cref="buffers" />.
+        /// The lock also protects <see cref="sensors" />,
+        /// <see cref="intervals" /> and <see cref="live_sensors" /> against
+        /// sensors being attached or detached while the collector is running.
+        /// </remarks>
+        mutable std::mutex gate_lock;
+
         /// <summary>
         /// Indicates whether a have a valid marker.
         /// </summary>
         /// <remarks>
         /// This flag is used to bypass collection of
-        /// <see cref="measurement" />s into <see cref="buffer" /> while we have
+        /// <see cref="measurement" />s into <see cref="buffers" /> while we have
         /// no active marker.
         /// </remarks>
         std::atomic<bool> have_marker;
 
         /// <summary>
-        /// The lock protecting the <see cref="buffer" /> and the
-        /// <see cref="markers" />.
+        /// A unique identifier of the collector, which allows threads to cache
+        /// their buffer.
         /// </summary>
-        std::mutex lock;
+        std::uint64_t id;
 
         /// <summary>
-        /// The markers for the current <see cref="buffer" />.
+        /// The energy per phase read from the
+        /// <see cref="instrument_integrators" />.
         /// </summary>
-        marker_list_type markers;
+        /// <remarks>
+        /// The list is protected by <see cref="gate_lock" />. It is written by
+        /// the <see cref="writer_thread" /> after its last pass over the
+        /// <see cref="buffers" />.
+        /// </remarks>
+        std::vector<phase_energy> instrument_energies;
 
         /// <summary>
-        /// Indicates whether the collector thread should continue running.
+        /// The instruments that integrate the energy on their own if
+        /// <see cref="integrate_instruments" /> is enabled.
         /// </summary>
-        std::atomic<bool> running;
+        /// <remarks>
+        /// The list is protected by <see cref="gate_lock" />.
+        /// </remarks>
+        std::vector<instrument_integrator> instrument_integrators;
 
         /// <summary>
-        /// The desired sampling interval.
+        /// The instruments that log on their own if
+        /// <see cref="merge_instrument_logs" /> is enabled.
         /// </summary>
-        std::chrono::microseconds sampling_interval;
+        std::vector<instrument_log> instrument_logs;
 
         /// <summary>
-        /// Indicates whether collecting sensor data requires a marker being
-        /// set.
+        /// The samples retrieved from <see cref="instrument_logs" /> when the
+        /// collector was stopped, ordered by their timestamps.
         /// </summary>
         /// <remarks>
-        /// This flag is assumed to be immutable and therefore readable without
-        /// holding a lock.
+        /// The list is filled before <see cref="running" /> is cleared and
+        /// written by the <see cref="writer_thread" /> after its last pass over
+        /// the <see cref="buffers" />.
         /// </remarks>
-        bool require_marker;
+        std::vector<measurement> instrument_samples;
 
         /// <summary>
-        /// The list of sensors.
+        /// Indicates whether the energy of each sensor is integrated per
+        /// phase between two markers.
         /// </summary>
-        std::vector<std::unique_ptr<sensor>> sensors;
+        bool integrate_energy;
 
         /// <summary>
-        /// The output stream for the results.
+        /// Indicates whether the energy per phase is read from the hardware
+        /// integrators of the instruments instead of sampling them live.
         /// </summary>
-        std::wofstream stream;
+        bool integrate_instruments;
 
         /// <summary>
-        /// The resolution of the timestamps being created.
+        /// The marker active in the current phase of the
+        /// <see cref="instrument_integrators" />.
         /// </summary>
-        timestamp_resolution_type timestamp_resolution;
+        /// <remarks>
+        /// This field is protected by <see cref="gate_lock" />.
+        /// </remarks>
+        std::uint32_t integrator_marker;
 
         /// <summary>
-        /// The I/O thread executing <see cref="write" />.
+        /// The sequence number of the current phase of the
+        /// <see cref="instrument_integrators" />, which is the number of
+        /// markers set since the collector has been started.
         /// </summary>
-        std::thread writer_thread;
+        /// <remarks>
+        /// This field is protected by <see cref="gate_lock" />.
+        /// </remarks>
+        std::uint32_t integrator_phase;
 
         /// <summary>
-        /// Initialises a new instance.
+        /// The sampling intervals of sensors that are not sampled at the
+        /// global <see cref="sampling_interval" />.
         /// </summary>
-        collector_impl(void);
+        /// <remarks>
+        /// This map is filled from the <see cref="sensor_intervals" /> by
+        /// <see cref="resolve_interval" /> and by changing the interval of a
+        /// sensor explicitly. It is protected by <see cref="gate_lock" />.
+        /// </remarks>
+        std::unordered_map<const sensor *, std::chrono::microseconds> intervals;
 
         /// <summary>
-        /// Finalises the instance.
+        /// The interval after which an unchanged sample of a sensor with a
+        /// threshold in <see cref="delta_thresholds" /> is written anyway.
         /// </summary>
-        ~collector_impl(void);
+        std::chrono::microseconds keep_alive_interval;
 
         /// <summary>
-        /// Applies the given settings.
+        /// Attributes the energy of each sensor to the CUDA kernels if
+        /// <see cref="kernel_energy_path" /> is not empty. This integrator
+        /// must only be used by the <see cref="writer_thread" /> once the
+        /// collector is running.
         /// </summary>
-        /// <param name="settings"></param>
-        void apply(const collector_settings& settings);
+        kernel_energy_integrator kernel_energies;
 
         /// <summary>
-        /// Answer whether data can be written to the buffer.
+        /// The path to the file the energy per kernel is written to, or an
+        /// empty string if the energy is not attributed to kernels.
         /// </summary>
-        /// <returns></returns>
-        bool can_buffer(void) const;
+        std::wstring kernel_energy_path;
 
         /// <summary>
-        /// Runs in <see cref="thread" /> and collects the data.
+        /// Indicates whether no sensor is sampled faster than its native
+        /// update interval.
         /// </summary>
-        void collect(void);
+        bool limit_to_native_interval;
 
         /// <summary>
-        /// Inject a marker in the stream.
+        /// The sensors that are sampled live while the collector is running.
         /// </summary>
-        /// <param name="marker"></param>
-        void marker(const wchar_t *marker);
+        /// <remarks>
+        /// Instruments that log on their own are not part of this list. The
+        /// list is protected by <see cref="gate_lock" />.
+        /// </remarks>
+        std::vector<sensor *> live_sensors;
 
         /// <summary>
-        /// Starts the collector thread if not running.
+        /// The lock protecting the <see cref="buffers" />,
+        /// <see cref="producers" /> and the markers. Note that the content of
+        /// the buffers is not protected by the lock.
         /// </summary>
-        void start(void);
+        mutable std::mutex lock;
 
         /// <summary>
-        /// Stops the collector thread.
+        /// Indicates whether the <see cref="buffers" /> are allocated on start
+        /// and locked into physical memory while the collector is running.
         /// </summary>
-        void stop(void);
+        bool lock_memory;
 
         /// <summary>
-        /// Asynchronously writes data from <see cref="buffer" /> and
-        /// <see cref="markers" /> to <see cref="stream" />.
+        /// The locks of the storage of the <see cref="buffers" /> and the
+        /// <see cref="spare_buffers" /> if <see cref="lock_memory" /> is set.
+        /// This list is protected by <see cref="lock" />.
         /// </summary>
-        void write(void);
+        std::vector<memory_lock> locked_memory;
+
+        /// <summary>
+        /// Indicates whether the library must not create any threads for
+        /// the collector, but the application drives the sampling and the
+        /// I/O by calling <see cref="pump" />.
+        /// </summary>
+        bool manual_pump;
+
+        /// <summary>
+        /// The marker events that have not yet been processed by the
+        /// <see cref="writer_thread" />.
+        /// </summary>
+        /// <remarks>
+        /// The events are ordered by their timestamps, because the timestamp
+        /// is created while holding the <see cref="lock" />.
+        /// </remarks>
+        marker_event_list_type marker_events;
+
+        /// <summary>
+        /// The energy per marker that the <see cref="writer_thread" />
+        /// publishes from <see cref="phase_energies" /> after each pass.
+        /// </summary>
+        /// <remarks>
+        /// The list is protected by <see cref="statistics_lock" />.
+        /// </remarks>
+        std::vector<double> marker_energies;
+
+        /// <summary>
+        /// The number of marker events the <see cref="writer_thread" /> has
+        /// written since the collector has been started.
+        /// </summary>
+        std::atomic<std::uint64_t> marker_event_count;
+
+        /// <summary>
+        /// Retrieves the markers set by other processes if
+        /// <see cref="marker_channel_name" /> is not empty. The listener must
+        /// only be used by the <see cref="writer_thread" /> once the collector
+        /// is running.
+        /// </summary>
+        marker_channel_listener marker_channel;
+
+        /// <summary>
+        /// The name of the shared memory segment through which other
+        /// processes set markers, or an empty string if they cannot.
+        /// </summary>
+        std::wstring marker_channel_name;
+
+        /// <summary>
+        /// Maps the text of all registered markers to their ID.
+        /// </summary>
+        std::unordered_map<std::wstring, std::uint32_t> marker_ids;
+
+        /// <summary>
+        /// The text of all registered markers, indexed by their ID.
+        /// </summary>
+        /// <remarks>
+        /// The first element is the empty string, which is reserved for
+        /// samples without marker.
+        /// </remarks>
+        std::vector<std::wstring> marker_names;
+
+        /// <summary>
+        /// Indicates whether instruments write logs that are merged into the
+        /// output instead of being sampled live.
+        /// </summary>
+        bool merge_instrument_logs;
+
+        /// <summary>
+        /// The shortest interval to which the sampling interval of a sensor
+        /// that can adapt its rate is lowered during transients, or zero if
+        /// all sensors are sampled at a fixed rate.
+        /// </summary>
+        std::chrono::microseconds min_sampling_interval;
+
+        /// <summary>
+        /// The path the output has been opened at, from which the paths of
+        /// the segments are derived if the output is rotated.
+        /// </summary>
+        std::wstring output_path;
+
+        /// <summary>
+        /// Estimates the power drawn by the library from the CPU packages
+        /// sampled. This estimator must only be used by the
+        /// <see cref="writer_thread" /> once the collector is running.
+        /// </summary>
+        overhead_estimator overhead;
+
+        /// <summary>
+        /// Indicates whether the <see cref="live_sensors" /> have been stopped
+        /// because no marker is set.
+        /// </summary>
+        /// <remarks>
+        /// This flag is protected by <see cref="gate_lock" />.
+        /// </remarks>
+        bool paused;
+
+        /// <summary>
+        /// Integrates the energy of each sensor per phase if
+        /// <see cref="integrate_energy" /> is set. This integrator must only
+        /// be used by the <see cref="writer_thread" /> once the collector is
+        /// running.
+        /// </summary>
+        phase_energy_integrator phase_energies;
+
+        /// <summary>
+        /// The length of the window after a trigger in capture mode.
+        /// </summary>
+        std::chrono::microseconds post_trigger;
+
+        /// <summary>
+        /// The GPUs whose power is estimated, which are determined by
+        /// <see cref="resolve_power_estimator" />.
+        /// </summary>
+        /// <remarks>
+        /// The list is protected by <see cref="gate_lock" />.
+        /// </remarks>
+        std::vector<power_estimator> power_estimators;
+
+        /// <summary>
+        /// The length of the window before a trigger in capture mode.
+        /// </summary>
+        std::chrono::microseconds pre_trigger;
+
+        /// <summary>
+        /// The path to the file the energy per process of the NVIDIA GPUs is
+        /// written to, or an empty string if the energy is not attributed to
+        /// processes.
+        /// </summary>
+        std::wstring process_energy_path;
+
+        /// <summary>
+        /// Maps the producers delivering samples to their buffer.
+        /// </summary>
+        /// <remarks>
+        /// <para>The map is a list, because there are only a few producers
+        /// and <see cref="local_buffer" /> caches the result of the search,
+        /// and because a list with reserved capacity does not allocate memory
+        /// when a producer is added.</para>
+        /// <para>A producer is either a
+        /// <see cref="sampler_scheduler::task" /> or the thread of a sampler
+        /// that does not use the scheduler.</para>
+        /// </remarks>
+        std::vector<std::pair<const void *, buffer_type *>> producers;
+
+        /// <summary>
+        /// The quantiles per sensor and marker that the
+        /// <see cref="writer_thread" /> publishes from
+        /// <see cref="quantiles" /> after each pass.
+        /// </summary>
+        /// <remarks>
+        /// The list is protected by <see cref="statistics_lock" />.
+        /// </remarks>
+        std::vector<phase_quantiles> published_quantiles;
+
+        /// <summary>
+        /// Serialises the passes of <see cref="pump" /> with the final pass
+        /// in <see cref="stop" /> if <see cref="manual_pump" /> is set.
+        /// </summary>
+        std::mutex pump_lock;
+
+        /// <summary>
+        /// The time of the last pass <see cref="pump" /> has made over the
+        /// <see cref="buffers" />.
+        /// </summary>
+        /// <remarks>
+        /// This member is protected by <see cref="pump_lock" />.
+        /// </remarks>
+        std::chrono::steady_clock::time_point pump_pass;
+
+        /// <summary>
+        /// The state of the writer if <see cref="manual_pump" /> is set and
+        /// the collector is running, which replaces the stack of the
+        /// <see cref="writer_thread" />.
+        /// </summary>
+        /// <remarks>
+        /// This member is protected by <see cref="pump_lock" />.
+        /// </remarks>
+        std::unique_ptr<write_state> pump_state;
+
+        /// <summary>
+        /// The mode of the <see cref="sampler_scheduler" /> before
+        /// <see cref="start" /> has switched it to manual mode, which is
+        /// restored by <see cref="stop" />.
+        /// </summary>
+        bool pumped_scheduler;
+
+        /// <summary>
+        /// Estimates the distribution of the power of each sensor per marker
+        /// if <see cref="track_quantiles" /> is set. This tracker must only
+        /// be used by the <see cref="writer_thread" /> once the collector is
+        /// running.
+        /// </summary>
+        phase_quantile_tracker quantiles;
+
+        /// <summary>
+        /// The global budget for the overhead of sampling, which is
+        /// distributed across the live sensors by <see cref="apply_budget" />.
+        /// </summary>
+        sampling_budget rate_budget;
+
+        /// <summary>
+        /// The CPU time in microseconds per read of the sensors with the
+        /// given names, which is taken from a capability report.
+        /// </summary>
+        std::unordered_map<std::wstring, double> read_costs;
+
+        /// <summary>
+        /// Indicates whether the collector thread should continue running.
+        /// </summary>
+        std::atomic<bool> running;
+
+        /// <summary>
+        /// The desired sampling interval.
+        /// </summary>
+        std::chrono::microseconds sampling_interval;
+
+        /// <summary>
+        /// The number of samples the <see cref="writer_thread" /> has
+        /// retrieved from the buffers since the collector has been started.
+        /// </summary>
+        std::atomic<std::uint64_t> samples;
+
+        /// <summary>
+        /// The number of samples the <see cref="writer_thread" /> has
+        /// retrieved per sensor, which it publishes after each pass.
+        /// </summary>
+        /// <remarks>
+        /// The list and <see cref="statistics_elapsed" /> are protected by
+        /// <see cref="statistics_lock" />, which is never acquired by the
+        /// threads delivering samples.
+        /// </remarks>
+        std::vector<std::pair<const wchar_t *, std::uint64_t>> sensor_samples;
+
+        /// <summary>
+        /// The time the <see cref="writer_thread" /> has been running when it
+        /// published the <see cref="sensor_samples" />.
+        /// </summary>
+        std::chrono::microseconds statistics_elapsed;
+
+        /// <summary>
+        /// Protects the counters published by the <see cref="writer_thread" />
+        /// once per pass.
+        /// </summary>
+        mutable std::mutex statistics_lock;
+
+        /// <summary>
+        /// Indicates whether the <see cref="writer_thread" /> records the
+        /// estimated <see cref="overhead" /> after each pass.
+        /// </summary>
+        bool record_overhead;
+
+        /// <summary>
+        /// Indicates whether collecting sensor data requires a marker being
+        /// set.
+        /// </summary>
+        /// <remarks>
+        /// <para>This flag is assumed to be immutable and therefore readable
+        /// without holding a lock.</para>
+        /// <para>If the flag is set, the <see cref="live_sensors" /> are only
+        /// sampled while a marker is set.</para>
+        /// </remarks>
+        bool require_marker;
+
+        /// <summary>
+        /// Resamples the samples written onto a common grid. The resampler
+        /// must only be used by the <see cref="writer_thread" />.
+        /// </summary>
+        grid_resampler resampler;
+
+        /// <summary>
+        /// The distance between the points of the grid of the
+        /// <see cref="resampler" />, which is zero if the samples are not
+        /// resampled.
+        /// </summary>
+        std::chrono::microseconds resampling_interval;
+
+        /// <summary>
+        /// The shortest intervals at which the sensors with the given names
+        /// may be sampled, which are taken from a capability report.
+        /// </summary>
+        std::unordered_map<std::wstring, std::chrono::microseconds>
+            safe_intervals;
+
+        /// <summary>
+        /// The changes of the sensors that have not yet been processed by the
+        /// <see cref="writer_thread" />.
+        /// </summary>
+        /// <remarks>
+        /// This list is protected by <see cref="lock" />.
+        /// </remarks>
+        std::vector<schema_change> schema_changes;
+
+        /// <summary>
+        /// The thresholds resolved by <see cref="resolve_delta_threshold" />
+        /// for the names of sensors, which the <see cref="writer_thread" /> has
+        /// not yet applied to the <see cref="delta" /> filter.
+        /// </summary>
+        /// <remarks>
+        /// The list is protected by <see cref="lock" />.
+        /// </remarks>
+        std::vector<std::pair<std::wstring, float>> resolved_thresholds;
+
+        /// <summary>
+        /// The filters resolved by <see cref="resolve_sample_filter" /> for
+        /// the names of sensors, which the <see cref="writer_thread" /> has
+        /// not yet applied to the <see cref="filter" /> stage.
+        /// </summary>
+        /// <remarks>
+        /// The list is protected by <see cref="lock" />.
+        /// </remarks>
+        std::vector<std::pair<std::wstring, sample_filter>> resolved_filters;
+
+        /// <summary>
+        /// Indicates whether the unfiltered samples of filtered sensors are
+        /// written as well.
+        /// </summary>
+        bool retain_unfiltered;
+
+        /// <summary>
+        /// The age after which the output is continued in a new segment, or
+        /// zero if the output is not rotated by time.
+        /// </summary>
+        std::chrono::microseconds rotate_interval;
+
+        /// <summary>
+        /// The size in bytes after which the output is continued in a new
+        /// segment, or zero if the output is not rotated by size.
+        /// </summary>
+        std::uint64_t rotate_size;
+
+        /// <summary>
+        /// Decides when the output is rotated and closes the segments that
+        /// have been replaced. The rotator must only be used by the
+        /// <see cref="writer_thread" /> once the collector is running.
+        /// </summary>
+        output_rotator rotator;
+
+        /// <summary>
+        /// The filters configured for the names or the types of sensors.
+        /// </summary>
+        std::unordered_map<std::wstring, sample_filter> sample_filters;
+
+        /// <summary>
+        /// Publishes the latest sample of each sensor to other processes if
+        /// <see cref="shared_memory_name" /> is not empty. The publisher must
+        /// only be used by the <see cref="writer_thread" /> once the collector
+        /// is running.
+        /// </summary>
+        shared_measurement_writer shared_memory;
+
+        /// <summary>
+        /// The name of the shared memory segment the latest samples are
+        /// published in, or an empty string if they are not published.
+        /// </summary>
+        std::wstring shared_memory_name;
+
+        /// <summary>
+        /// The shards writing the samples of every
+        /// <see cref="writer_threads" />-th buffer besides the ones the
+        /// <see cref="writer_thread" /> writes itself.
+        /// </summary>
+        /// <remarks>
+        /// The shards are created when the output is opened and started by
+        /// the <see cref="writer_thread" />, which also stops them after its
+        /// last pass.
+        /// </remarks>
+        std::vector<std::unique_ptr<writer_shard>> shards;
+
+        /// <summary>
+        /// Indicates whether samples repeating the previous sample of their
+        /// sensor are not written.
+        /// </summary>
+        bool suppress_duplicates;
+
+        /// <summary>
+        /// The calibrated delays configured for the names or the types of
+        /// sensors.
+        /// </summary>
+        std::unordered_map<std::wstring, std::chrono::microseconds>
+            sensor_delays;
+
+        /// <summary>
+        /// The sampling intervals configured for the names or the types of
+        /// sensors.
+        /// </summary>
+        std::unordered_map<std::wstring, std::chrono::microseconds>
+            sensor_intervals;
+
+        /// <summary>
+        /// The priorities for distributing the <see cref="rate_budget" />
+        /// configured for the names or the types of sensors.
+        /// </summary>
+        std::unordered_map<std::wstring, float> sensor_priorities;
+
+        /// <summary>
+        /// The quantities configured for the names or the types of sensors.
+        /// </summary>
+        std::unordered_map<std::wstring, tinkerforge_sensor_source>
+            sensor_quantities;
+
+        /// <summary>
+        /// The list of sensors.
+        /// </summary>
+        std::vector<std::unique_ptr<sensor>> sensors;
+
+        /// <summary>
+        /// Buffers that have been allocated on start because of
+        /// <see cref="lock_memory" />, but have not yet been assigned to a
+        /// producer thread. This list is protected by <see cref="lock" />.
+        /// </summary>
+        buffer_list_type spare_buffers;
+
+        /// <summary>
+        /// Checks the sequence numbers of the samples if
+        /// <see cref="track_sequences" /> is set. This tracker must only be
+        /// used by the <see cref="writer_thread" /> once the collector is
+        /// running.
+        /// </summary>
+        sequence_tracker sequences;
+
+        /// <summary>
+        /// Describes when the sensors have been started, which is written at
+        /// the begin of the output.
+        /// </summary>
+        start_record start_info;
+
+        /// <summary>
+        /// The timestamp of the first sample that is written to the output.
+        /// </summary>
+        /// <remarks>
+        /// While the sensors are being started, this is the largest possible
+        /// timestamp such that all samples delivered by sensors that cannot be
+        /// held back by the start barrier are discarded.
+        /// </remarks>
+        std::atomic<measurement::timestamp_type> start_time;
+
+        /// <summary>
+        /// The writer for the results if the <see cref="format" /> is
+        /// <see cref="output_format::csv" />.
+        /// </summary>
+        /// <remarks>
+        /// The writer is replaced by the <see cref="writer_thread" /> when
+        /// the output is rotated.
+        /// </remarks>
+        std::unique_ptr<csv_output_writer> stream;
+
+        /// <summary>
+        /// The number of samples the <see cref="subscribers" /> ring holds.
+        /// </summary>
+        std::size_t subscriber_capacity;
+
+        /// <summary>
+        /// The ring that the <see cref="writer_thread" /> broadcasts the live
+        /// samples to the in-process subscribers through, which is created
+        /// by <see cref="subscribe" /> on first use.
+        /// </summary>
+        /// <remarks>
+        /// The pointer is protected by <see cref="lock" />, but the ring is
+        /// never replaced once it has been created. The subscribers share the
+        /// ownership such that they can outlive the collector.
+        /// </remarks>
+        std::shared_ptr<subscriber_ring> subscribers;
+
+        /// <summary>
+        /// The resolution of the timestamps being created.
+        /// </summary>
+        timestamp_resolution_type timestamp_resolution;
+
+        /// <summary>
+        /// Indicates whether <see cref="tinkerforge_sensor" />s stamp their
+        /// samples with the arrival time rather than reconstructing it.
+        /// </summary>
+        bool tinkerforge_arrival_times;
+
+        /// <summary>
+        /// The times of the triggers that have not yet been processed by the
+        /// <see cref="writer_thread" />.
+        /// </summary>
+        /// <remarks>
+        /// This list is protected by <see cref="lock" />.
+        /// </remarks>
+        std::vector<timestamp_type> trigger_events;
+
+        /// <summary>
+        /// The writer for the results if the <see cref="format" /> is
+        /// <see cref="output_format::perfetto" /> or
+        /// <see cref="output_format::chrome_trace" />.
+        /// </summary>
+        trace_output_writer trace_stream;
+
+        /// <summary>
+        /// Indicates whether the <see cref="writer_thread" /> estimates the
+        /// distribution of the power of each sensor per marker.
+        /// </summary>
+        bool track_quantiles;
+
+        /// <summary>
+        /// Indicates whether the <see cref="writer_thread" /> checks the
+        /// sequence numbers of the samples for gaps and duplicates.
+        /// </summary>
+        bool track_sequences;
+
+        /// <summary>
+        /// Indicates whether setting a marker sends a software trigger to all
+        /// <see cref="rtx_sensor" />s being sampled.
+        /// </summary>
+        bool trigger_oscilloscopes;
+
+        /// <summary>
+        /// The power that raises a trigger in capture mode if reached by a
+        /// sample, or zero if samples do not raise triggers.
+        /// </summary>
+        measurement::value_type trigger_threshold;
+
+        /// <summary>
+        /// The path to the <see cref="archive" />, which is empty if the
+        /// waveforms of the oscilloscopes are not archived.
+        /// </summary>
+        std::wstring waveform_archive_path;
+
+        /// <summary>
+        /// Assembles the lines of the <see cref="output_format::wide_csv" />
+        /// output. The assembler must only be used by the
+        /// <see cref="writer_thread" />.
+        /// </summary>
+        wide_csv_rows wide_rows;
+
+        /// <summary>
+        /// The maximum time the <see cref="writer_thread" /> sleeps before it
+        /// drains the <see cref="buffers" /> even if none of them has reached
+        /// the <see cref="write_threshold" />.
+        /// </summary>
+        std::chrono::milliseconds write_latency;
+
+        /// <summary>
+        /// Indicates whether the <see cref="writer_thread" /> appends the
+        /// self-instrumentation of the sampler contexts before it closes the
+        /// output.
+        /// </summary>
+        bool write_statistics;
+
+        /// <summary>
+        /// The fraction of the capacity of a buffer at which the producer
+        /// wakes the <see cref="writer_thread" />.
+        /// </summary>
+        float write_threshold;
+
+        /// <summary>
+        /// The I/O thread executing <see cref="write" />.
+        /// </summary>
+        std::thread writer_thread;
+
+        /// <summary>
+        /// The number of threads writing the output, including the
+        /// <see cref="writer_thread" />.
+        /// </summary>
+        std::size_t writer_threads;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        collector_impl(void);
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~collector_impl(void);
+
+        /// <summary>
+        /// Applies the given settings.
+        /// </summary>
+        /// <param name="settings"></param>
+        /// <exception cref="std::invalid_argument">If an overhead experiment
+        /// is combined with <see cref="require_marker" />.</exception>
+        void apply(const collector_settings& settings);
+
+        /// <summary>
+        /// Distributes the <see cref="rate_budget" /> across the given
+        /// sensors and stores the intervals of the ones that must be slowed
+        /// down in <see cref="budget_intervals" />.
+        /// </summary>
+        /// <remarks>
+        /// <para>The cost of a read is taken from the self-instrumentation of
+        /// the samplers if the sensor has been sampled before, or from the
+        /// <see cref="read_costs" /> otherwise. The sensors are not
+        /// restarted.</para>
+        /// <para>The caller must hold <see cref="gate_lock" />.</para>
+        /// </remarks>
+        /// <param name="sensors">The sensors sharing the budget. Elements
+        /// that are <c>nullptr</c> are skipped.</param>
+        void apply_budget(const std::vector<sensor *>& sensors);
+
+        /// <summary>
+        /// Adds a sensor, which is sampled immediately if the collector is
+        /// running.
+        /// </summary>
+        /// <param name="sensor">The sensor to be added. The collector only
+        /// takes ownership if the method succeeds.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="sensor" /> is <c>nullptr</c> or has been disposed.
+        /// </exception>
+        /// <exception cref="std::logic_error">If the sensor is already being
+        /// sampled by someone else.</exception>
+        void attach(std::unique_ptr<sensor>&& sensor);
+
+        /// <summary>
+        /// Answer whether data can be written to the buffer.
+        /// </summary>
+        /// <returns></returns>
+        bool can_buffer(void) const;
+
+        /// <summary>
+        /// Runs in <see cref="thread" /> and collects the data.
+        /// </summary>
+        void collect(void);
+
+        /// <summary>
+        /// Stops and removes the first sensor with the given name.
+        /// </summary>
+        /// <param name="name">The name of the sensor to be removed.</param>
+        /// <returns><c>true</c> if a sensor has been removed, <c>false</c> if
+        /// there is no sensor with the given name.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="name" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::logic_error">If the sensor is an instrument
+        /// that is logging on its own.</exception>
+        bool detach(const wchar_t *name);
+
+        /// <summary>
+        /// Answer the calibrated delay of the given sensor.
+        /// </summary>
+        /// <param name="sensor">The sensor to retrieve the delay for.</param>
+        /// <returns>The delay configured in <see cref="sensor_delays" /> for
+        /// the name or, with lower precedence, for the type of the sensor,
+        /// or zero if there is none.</returns>
+        std::chrono::microseconds delay_of(const sensor *sensor) const;
+
+        /// <summary>
+        /// Changes the sampling interval of the first sensor with the given
+        /// name, restarting the sensor if it is being sampled.
+        /// </summary>
+        /// <param name="name">The name of the sensor.</param>
+        /// <param name="interval">The new sampling interval.</param>
+        /// <returns><c>true</c> if the interval has been changed, <c>false</c>
+        /// if there is no sensor with the given name.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="name" /> is <c>nullptr</c> or if
+        /// <paramref name="interval" /> is zero.</exception>
+        /// <exception cref="std::logic_error">If the sensor is an instrument
+        /// that is logging on its own or if it could not be restarted.
+        /// </exception>
+        bool interval(const wchar_t *name,
+            const std::chrono::microseconds interval);
+
+        /// <summary>
+        /// Answer the sampling interval of the given sensor.
+        /// </summary>
+        /// <remarks>
+        /// The caller must hold <see cref="gate_lock" />.
+        /// </remarks>
+        /// <param name="sensor">The sensor to retrieve the interval for.
+        /// </param>
+        /// <returns>The interval from <see cref="intervals" /> or the global
+        /// <see cref="sampling_interval" />.</returns>
+        std::chrono::microseconds interval_of(const sensor *sensor) const;
+
+        /// <summary>
+        /// Replaces the <see cref="safe_intervals" /> and the
+        /// <see cref="read_costs" /> with the ones from the given capability
+        /// report.
+        /// </summary>
+        /// <param name="path">The path to the report, or <c>nullptr</c> or
+        /// an empty string for clearing the safe intervals and the costs.
+        /// </param>
+        /// <exception cref="std::ios_base::failure">If the report could not
+        /// be read.</exception>
+        void load_safe_intervals(const wchar_t *path);
+
+        /// <summary>
+        /// Answer the buffer of the scheduler task running on the calling
+        /// thread or of the calling thread if it does not run a task, which
+        /// is created on first use.
+        /// </summary>
+        /// <remarks>
+        /// <para>Keying the buffers by task ensures that all samples of a
+        /// sensor end up in the same buffer in the order of their timestamps
+        /// even if the scheduler moves the task between threads. As the ticks
+        /// of a task never overlap, each buffer still has a single producer at
+        /// a time.</para>
+        /// <para>If <see cref="spare_buffers" /> are available, one of them is
+        /// assigned to a new producer instead of allocating a new one.</para>
+        /// </remarks>
+        /// <returns>The buffer that the caller may write to.</returns>
+        buffer_type& local_buffer(void);
+
+        /// <summary>
+        /// Allocates a buffer for each sensor that might be sampled on a
+        /// thread of its own, and prefaults and locks all buffers.
+        /// </summary>
+        /// <remarks>
+        /// The caller must hold <see cref="gate_lock" />.
+        /// </remarks>
+        /// <exception cref="std::system_error">If the buffers could not be
+        /// locked.</exception>
+        void lock_buffers(void);
+
+        /// <summary>
+        /// Inject a marker in the stream.
+        /// </summary>
+        /// <param name="marker">The text of the marker, which is registered if
+        /// necessary, or <c>nullptr</c> to clear the marker.</param>
+        void marker(const wchar_t *marker);
+
+        /// <summary>
+        /// Inject an already registered marker in the stream.
+        /// </summary>
+        /// <remarks>
+        /// This method only records the time and the ID of the marker and
+        /// does not copy any string.
+        /// </remarks>
+        /// <param name="id">The ID returned by <see cref="register_marker" />
+        /// or zero to clear the marker.</param>
+        /// <exception cref="std::out_of_range">If <paramref name="id" /> has
+        /// not been registered.</exception>
+        void marker(const std::uint32_t id);
+
+        /// <summary>
+        /// Inject an already registered marker in the stream at the given
+        /// time.
+        /// </summary>
+        /// <param name="id">The ID returned by <see cref="register_marker" />
+        /// or zero to clear the marker.</param>
+        /// <param name="timestamp">The time of the marker in the
+        /// <see cref="timestamp_resolution" /> of the collector.</param>
+        /// <exception cref="std::out_of_range">If <paramref name="id" /> has
+        /// not been registered.</exception>
+        void marker(const std::uint32_t id, const timestamp_type timestamp);
+
+        /// <summary>
+        /// Creates the sensors from <see cref="deferred_sensors" /> and
+        /// appends them to <see cref="sensors" />.
+        /// </summary>
+        /// <remarks>
+        /// The caller must hold <see cref="gate_lock" />. The sensors are
+        /// created in parallel as far as they do not share a resource. If any
+        /// of them cannot be created, none of them is added and the
+        /// descriptors are retained such that the operation can be retried.
+        /// </remarks>
+        void open_deferred_sensors(void);
+
+        /// <summary>
+        /// Answer the total number of samples that have been dropped because
+        /// the buffers were full.
+        /// </summary>
+        /// <returns>The number of dropped samples.</returns>
+        std::uint64_t overflows(void) const;
+
+        /// <summary>
+        /// Stops sampling the <see cref="live_sensors" /> until
+        /// <see cref="resume" /> is called.
+        /// </summary>
+        void pause(void);
+
+        /// <summary>
+        /// Answer the priority of the given sensor when distributing the
+        /// <see cref="rate_budget" />.
+        /// </summary>
+        /// <param name="sensor">The sensor to retrieve the priority for.
+        /// </param>
+        /// <returns>The priority configured for the name or the type of the
+        /// sensor in <see cref="sensor_priorities" />, or one.</returns>
+        float priority_of(const sensor *sensor) const;
+
+        /// <summary>
+        /// Adds the given measurement to the buffer of the calling thread.
+        /// </summary>
+        /// <param name="m"></param>
+        void push(const measurement& m);
+
+        /// <summary>
+        /// Samples all sensors that are due and writes the buffered samples
+        /// on the calling thread if <see cref="manual_pump" /> is set.
+        /// </summary>
+        /// <remarks>
+        /// The buffers are drained if the producers have signalled
+        /// <see cref="evt_write" /> or if <see cref="write_latency" /> has
+        /// elapsed since the last pass, provided that the sensors have left
+        /// some of the <paramref name="budget" />.
+        /// </remarks>
+        /// <param name="budget">The time the method should spend, or zero
+        /// for sampling all due sensors and writing all pending samples.
+        /// </param>
+        /// <returns>The number of sampler ticks that have been run.</returns>
+        /// <exception cref="std::logic_error">If the collector has not been
+        /// configured for manual pumping.</exception>
+        std::size_t pump(const std::chrono::microseconds budget);
+
+        /// <summary>
+        /// Downloads the <see cref="instrument_logs" /> and fills
+        /// <see cref="instrument_samples" />.
+        /// </summary>
+        /// <remarks>
+        /// Instruments whose log cannot be retrieved are skipped.
+        /// </remarks>
+        void read_instrument_logs(void);
+
+        /// <summary>
+        /// Distributes the <see cref="rate_budget" /> anew after the set of
+        /// live sensors or their intervals have changed.
+        /// </summary>
+        /// <remarks>
+        /// <para>All live sensors whose interval changes are restarted unless
+        /// sampling is paused, and the change is recorded in the schema of
+        /// the output. The caller must hold <see cref="gate_lock" />.</para>
+        /// <para>The method has no effect if no budget is set.</para>
+        /// </remarks>
+        /// <param name="pending">A sensor that is not live yet or that is
+        /// restarted by the caller anyway, which takes part in the
+        /// distribution, but is not restarted. It is safe to pass
+        /// <c>nullptr</c>.</param>
+        void rebalance(sensor *pending);
+
+        /// <summary>
+        /// Records a marker event and starts or stops sampling if necessary.
+        /// </summary>
+        /// <param name="id">The ID of the marker, or zero to clear the
+        /// marker.</param>
+        /// <param name="timestamp">The time of the marker, or <c>nullptr</c>
+        /// to use the current time.</param>
+        /// <exception cref="std::out_of_range">If <paramref name="id" /> has
+        /// not been registered.</exception>
+        void record_marker(const std::uint32_t id,
+            const timestamp_type *timestamp);
+
+        /// <summary>
+        /// Answer the ID of the given marker text, registering it if necessary.
+        /// </summary>
+        /// <param name="marker">The text of the marker.</param>
+        /// <returns>The non-zero ID of the marker.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="marker" /> is <c>nullptr</c>.</exception>
+        std::uint32_t register_marker(const wchar_t *marker);
+
+        /// <summary>
+        /// Records a change of the sensors for the
+        /// <see cref="writer_thread" />.
+        /// </summary>
+        /// <param name="type">The kind of the change.</param>
+        /// <param name="sensor">The sensor that has been changed.</param>
+        /// <param name="interval">The sampling interval of the sensor after
+        /// the change.</param>
+        void record(const schema_change_type type, const sensor& sensor,
+            const std::chrono::microseconds interval);
+
+        /// <summary>
+        /// Closes the output and opens it at the given path for the next run.
+        /// </summary>
+        /// <remarks>
+        /// The format of the output and the number of shards are retained.
+        /// </remarks>
+        /// <param name="path">The path of the new output.</param>
+        /// <exception cref="std::logic_error">If the collector is running.
+        /// </exception>
+        /// <exception cref="std::system_error">If the output could not be
+        /// opened.</exception>
+        void reopen(const wchar_t *path);
+
+        /// <summary>
+        /// Passes the threshold configured for the name or the type of the
+        /// given sensor in <see cref="delta_thresholds" /> to the
+        /// <see cref="writer_thread" />.
+        /// </summary>
+        /// <remarks>
+        /// The thresholds must be resolved before the sensor delivers its
+        /// first sample, because the writer releases the samples of sensors
+        /// it does not know a threshold for.
+        /// </remarks>
+        /// <param name="sensor">The sensor to resolve the threshold of.
+        /// </param>
+        void resolve_delta_threshold(const sensor *sensor);
+
+        /// <summary>
+        /// Passes the filter configured for the name or the type of the given
+        /// sensor in <see cref="sample_filters" /> to the
+        /// <see cref="writer_thread" />.
+        /// </summary>
+        /// <remarks>
+        /// The filters must be resolved before the sensor delivers its first
+        /// sample, because the writer passes on the samples of sensors it
+        /// does not know a filter for.
+        /// </remarks>
+        /// <param name="sensor">The sensor to resolve the filter of.</param>
+        void resolve_sample_filter(const sensor *sensor);
+
+        /// <summary>
+        /// Assigns the interval configured for the name or the type of the
+        /// given sensor in <see cref="sensor_intervals" /> unless the sensor
+        /// already has a specific interval.
+        /// </summary>
+        /// <remarks>
+        /// <para>If <see cref="limit_to_native_interval" /> is set, the
+        /// interval is raised to the native update interval of the sensor
+        /// afterwards, which might require probing the sensor. Likewise, the
+        /// interval is raised to the <see cref="safe_intervals" /> of the
+        /// sensor.</para>
+        /// <para>The caller must hold <see cref="gate_lock" />.</para>
+        /// </remarks>
+        /// <param name="sensor">The sensor to assign the interval to.</param>
+        void resolve_interval(const sensor *sensor);
+
+        /// <summary>
+        /// Enables the estimation mode of the given sensor and adds it to the
+        /// <see cref="power_estimators" /> if <see cref="estimate_power" /> is
+        /// set and the sensor is a GPU supporting it.
+        /// </summary>
+        /// <remarks>
+        /// The caller must hold <see cref="gate_lock" />.
+        /// </remarks>
+        /// <param name="sensor">The sensor to estimate the power of.</param>
+        void resolve_power_estimator(sensor *sensor);
+
+        /// <summary>
+        /// Selects the quantities configured for the name or the type of the
+        /// given sensor in <see cref="sensor_quantities" /> if the sensor
+        /// supports this.
+        /// </summary>
+        /// <remarks>
+        /// The quantities must be resolved before the sensor is started,
+        /// because they determine which callbacks the sensor enables. The
+        /// method also applies <see cref="tinkerforge_arrival_times" />. The
+        /// caller must hold <see cref="gate_lock" />.
+        /// </remarks>
+        /// <param name="sensor">The sensor to configure.</param>
+        void resolve_quantities(sensor *sensor);
+
+        /// <summary>
+        /// Restarts sampling the <see cref="live_sensors" /> if they have been
+        /// stopped by <see cref="pause" />.
+        /// </summary>
+        /// <exception cref="std::logic_error">If any of the sensors is being
+        /// sampled by someone else.</exception>
+        void resume(void);
+
+        /// <summary>
+        /// Switches the windows of the <see cref="experiment" /> after each
+        /// <see cref="experiment_window" /> until
+        /// <see cref="evt_experiment" /> is signalled.
+        /// </summary>
+        void run_experiment(void);
+
+        /// <summary>
+        /// Answer the interval the given sensor is actually sampled at.
+        /// </summary>
+        /// <param name="sensor">The sensor to retrieve the interval for.
+        /// </param>
+        /// <returns>The interval from <see cref="budget_intervals" /> if the
+        /// budget slows the sensor down, or its <see cref="interval_of" />.
+        /// </returns>
+        std::chrono::microseconds sampled_interval_of(
+            const sensor *sensor) const;
+
+        /// <summary>
+        /// Starts the collector thread if not running.
+        /// </summary>
+        void start(void);
+
+        /// <summary>
+        /// Takes a snapshot of the pipeline of the collector.
+        /// </summary>
+        /// <remarks>
+        /// This method can be called from any thread. It does not block the
+        /// threads delivering samples, which push them to lock-free buffers.
+        /// </remarks>
+        /// <param name="dst">Receives the snapshot.</param>
+        void statistics(collector_statistics_impl& dst) const;
+
+        /// <summary>
+        /// Starts asynchronous sampling of the given sensors, each at its
+        /// <see cref="interval_of" />.
+        /// </summary>
+        /// <remarks>
+        /// <para>All sensors at the global <see cref="sampling_interval" /> are
+        /// started at once. The caller must hold <see cref="gate_lock" />.
+        /// </para>
+        /// <para>If <see cref="min_sampling_interval" /> is set, all sensors
+        /// are started individually with an adaptive rate between it and
+        /// their <see cref="interval_of" />.</para>
+        /// <para>The operation is transactional: If any of the sensors cannot
+        /// be started, all of them are stopped before the exception is
+        /// rethrown.</para>
+        /// </remarks>
+        /// <param name="sensors">The sensors to be started. Elements that
+        /// are <c>nullptr</c> are skipped.</param>
+        /// <param name="latencies">If not <c>nullptr</c>, receives the start
+        /// latency of each of the sensors.</param>
+        void start_sampling(const std::vector<sensor *>& sensors,
+            sensor::microseconds_type *latencies = nullptr);
+
+        /// <summary>
+        /// Enables the hardware integrator of all instruments in
+        /// <paramref name="sensors" /> that support it and replaces them with
+        /// <c>nullptr</c> such that they are not sampled live.
+        /// </summary>
+        /// <remarks>
+        /// The caller must hold <see cref="gate_lock" />. If a marker is
+        /// already set, the integrators are started immediately.
+        /// </remarks>
+        /// <param name="sensors">The sensors to be started.</param>
+        void start_instrument_integrators(std::vector<sensor *>& sensors);
+
+        /// <summary>
+        /// Makes all instruments in <paramref name="sensors" /> that support
+        /// it log on their own and replaces them with <c>nullptr</c> such that
+        /// they are not sampled live.
+        /// </summary>
+        /// <param name="sensors">The sensors to be started.</param>
+        void start_instrument_logs(std::vector<sensor *>& sensors);
+
+        /// <summary>
+        /// Stops the collector thread.
+        /// </summary>
+        void stop(void);
+
+        /// <summary>
+        /// Reads the energy of the phase that ends now from the
+        /// <see cref="instrument_integrators" /> and disables them.
+        /// </summary>
+        /// <remarks>
+        /// The caller must hold <see cref="gate_lock" />.
+        /// </remarks>
+        void stop_instrument_integrators(void);
+
+        /// <summary>
+        /// Answer the ring of the <see cref="subscribers" />, which is created
+        /// if necessary.
+        /// </summary>
+        /// <returns>The ring that new subscribers read from.</returns>
+        /// <exception cref="std::bad_alloc">If the ring could not be
+        /// allocated.</exception>
+        std::shared_ptr<subscriber_ring> subscribe(void);
+
+        /// <summary>
+        /// Ends the current window of the <see cref="experiment" /> and
+        /// restarts the <see cref="live_sensors" /> for the next one.
+        /// </summary>
+        /// <remarks>
+        /// The method has no effect if the experiment is not running.
+        /// </remarks>
+        /// <exception cref="std::logic_error">If any of the sensors could not
+        /// be restarted.</exception>
+        void switch_experiment(void);
+
+        /// <summary>
+        /// Stops and reads the <see cref="instrument_integrators" /> that are
+        /// running and restarts them from zero if a new marker is set.
+        /// </summary>
+        /// <remarks>
+        /// <para>The caller must hold <see cref="gate_lock" />.</para>
+        /// <para>Instruments that fail lose the current phase, but they are
+        /// restarted with the next marker.</para>
+        /// </remarks>
+        /// <param name="id">The ID of the marker that starts the next phase,
+        /// which is zero if no phase is to be measured.</param>
+        void switch_instrument_integrators(const std::uint32_t id);
+
+        /// <summary>
+        /// Creates the ring for a <see cref="frame_marker" />.
+        /// </summary>
+        /// <returns>The ring the frame marker pushes to.</returns>
+        /// <exception cref="std::logic_error">If a frame marker for the
+        /// collector already exists.</exception>
+        /// <exception cref="std::bad_alloc">If the ring could not be
+        /// allocated.</exception>
+        std::shared_ptr<frame_ring> track_frames(void);
+
+        /// <summary>
+        /// Records a trigger at the current time for the
+        /// <see cref="writer_thread" />.
+        /// </summary>
+        void trigger(void);
+
+        /// <summary>
+        /// Closes the output in the configured <see cref="format" />.
+        /// </summary>
+        void close(void);
+
+        /// <summary>
+        /// Answer whether the output in the configured <see cref="format" />
+        /// is open.
+        /// </summary>
+        /// <returns><c>true</c> if the output is open, <c>false</c> if it has
+        /// been closed at the end of the previous run.</returns>
+        bool is_open(void) const;
+
+        /// <summary>
+        /// Opens the output file in the given format.
+        /// </summary>
+        /// <param name="path"></param>
+        /// <param name="format"></param>
+        void open(const wchar_t *path, const output_format format);
+
+        /// <summary>
+        /// Creates the <see cref="shards" /> for the configured number of
+        /// <see cref="writer_threads" /> and writes their manifest.
+        /// </summary>
+        /// <remarks>
+        /// This method must be called after the output has been opened and
+        /// all other settings have been applied, because it checks that none
+        /// of them requires all samples to be processed on one thread.
+        /// </remarks>
+        /// <exception cref="std::invalid_argument">If the output cannot be
+        /// sharded.</exception>
+        /// <exception cref="std::system_error">If any of the shards or the
+        /// manifest could not be created.</exception>
+        void open_shards(void);
+
+        /// <summary>
+        /// Asynchronously writes data from <see cref="buffers" /> and
+        /// <see cref="marker_events" /> to <see cref="stream" /> or
+        /// <see cref="binary_stream" />.
+        /// </summary>
+        /// <remarks>
+        /// This is the body of the <see cref="writer_thread" />, which makes
+        /// the passes of the overload below until the collector is stopped.
+        /// </remarks>
+        void write(void);
+
+        /// <summary>
+        /// Performs the given phase of writing data from
+        /// <see cref="buffers" /> and <see cref="marker_events" /> to the
+        /// output.
+        /// </summary>
+        /// <remarks>
+        /// The <see cref="write_phase::begin" /> opens the output and must be
+        /// performed once before any pass. The
+        /// <see cref="write_phase::end" /> completes the output and must be
+        /// performed once after <see cref="write_state::running" /> has been
+        /// cleared and a last pass has been made.
+        /// </remarks>
+        /// <param name="state">The state of the writer, which is preserved
+        /// between the phases.</param>
+        /// <param name="phase">The phase to perform.</param>
+        void write(write_state& state, const write_phase phase);
     };
 
 } /* namespace detail */
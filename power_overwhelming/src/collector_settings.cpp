@@ -5,11 +5,66 @@
 
 #include "power_overwhelming/collector_settings.h"
 
+#include <algorithm>
+#include <cwchar>
 #include <stdexcept>
 
+#include "derived_expression.h"
 #include "string_functions.h"
 
 
+/*
+ * visus::power_overwhelming::collector_settings::derived_sensor_type
+ */
+struct visus::power_overwhelming::collector_settings::derived_sensor_type {
+    wchar_t *expression;
+    wchar_t *sensor;
+};
+
+
+/*
+ * visus::power_overwhelming::collector_settings::sensor_filter_type
+ */
+struct visus::power_overwhelming::collector_settings::sensor_filter_type {
+    sample_filter filter;
+    wchar_t *sensor;
+};
+
+
+/*
+ * visus::power_overwhelming::collector_settings::sensor_interval_type
+ */
+struct visus::power_overwhelming::collector_settings::sensor_interval_type {
+    wchar_t *sensor;
+    sampling_interval_type interval;
+};
+
+
+/*
+ * visus::power_overwhelming::collector_settings::sensor_quantity_type
+ */
+struct visus::power_overwhelming::collector_settings::sensor_quantity_type {
+    tinkerforge_sensor_source quantities;
+    wchar_t *sensor;
+};
+
+
+/*
+ * visus::power_overwhelming::collector_settings::sensor_threshold_type
+ */
+struct visus::power_overwhelming::collector_settings::sensor_threshold_type {
+    wchar_t *sensor;
+    float threshold;
+};
+
+
+/*
+ * visus::power_overwhelming::collector_settings::default_buffer_size
+ */
+constexpr std::size_t visus::power_overwhelming::collector_settings
+::default_buffer_size;
+
+
 /*
  * visus::power_overwhelming::collector_settings::default_output_path
  */
@@ -17,11 +72,67 @@ constexpr const wchar_t *visus::power_overwhelming::collector_settings
 ::default_output_path;
 
 
+/*
+ * visus::power_overwhelming::collector_settings::default_subscriber_capacity
+ */
+constexpr std::size_t visus::power_overwhelming::collector_settings
+::default_subscriber_capacity;
+
+
+/*
+ * visus::power_overwhelming::collector_settings::default_write_latency
+ */
+constexpr visus::power_overwhelming::collector_settings::sampling_interval_type
+visus::power_overwhelming::collector_settings::default_write_latency;
+
+
+/*
+ * visus::power_overwhelming::collector_settings::default_write_threshold
+ */
+constexpr float
+visus::power_overwhelming::collector_settings::default_write_threshold;
+
+
 /*
  * visus::power_overwhelming::collector_settings::collector_settings
  */
 visus::power_overwhelming::collector_settings::collector_settings(void)
-        : _output_path(nullptr), _sampling_interval(default_sampling_interval) {
+        : _aggregate_only(false), _aggregation_window(0),
+        _align_timestamps(false), _buffer_size(default_buffer_size),
+        _capability_report(nullptr),
+        _compress_output(false), _compress_waveforms(false),
+        _delta_threshold_count(0),
+        _delta_thresholds(nullptr), _derived_sensor_count(0),
+        _derived_sensors(nullptr), _estimate_power(false), _filter_count(0),
+        _filters(nullptr), _integrate_energy(false),
+        _integrate_instruments(false),
+        _keep_alive_interval(0), _kernel_energy(nullptr),
+        _limit_to_native_interval(false), _lock_memory(false),
+        _manual_pump(false), _marker_channel(nullptr),
+        _merge_instrument_logs(false), _min_sampling_interval(0),
+        _output_format(power_overwhelming::output_format::csv),
+        _output_path(nullptr), _overhead_interval(0),
+        _overhead_report(nullptr), _overhead_window(0),
+        _post_trigger(0), _pre_trigger(0), _process_energy(nullptr),
+        _record_overhead(false), _require_marker(false),
+        _resampling_interval(0), _retain_unfiltered(false),
+        _rotate_interval(0), _rotate_size(0),
+        _sampling_cpu_budget(0.0f),
+        _sampling_interval(default_sampling_interval),
+        _sampling_read_budget(0),
+        _sensor_delay_count(0), _sensor_delays(nullptr),
+        _sensor_interval_count(0), _sensor_intervals(nullptr),
+        _sensor_priorities(nullptr), _sensor_priority_count(0),
+        _sensor_quantities(nullptr), _sensor_quantity_count(0),
+        _shared_memory(nullptr),
+        _subscriber_capacity(default_subscriber_capacity),
+        _suppress_duplicates(false), _tinkerforge_arrival_times(false),
+        _track_quantiles(false),
+        _track_sequences(false),
+        _trigger_oscilloscopes(false), _trigger_threshold(0.0f),
+        _waveform_archive(nullptr), _write_latency(default_write_latency),
+        _write_statistics(false),
+        _write_threshold(default_write_threshold), _writer_threads(1) {
     this->output_path(default_output_path);
 }
 
@@ -30,7 +141,16 @@ visus::power_overwhelming::collector_settings::collector_settings(void)
  * visus::power_overwhelming::collector_settings::collector_settings
  */
 visus::power_overwhelming::collector_settings::collector_settings(
-        _In_ const collector_settings& rhs) : _output_path(nullptr) {
+        _In_ const collector_settings& rhs) : _capability_report(nullptr),
+        _delta_threshold_count(0), _delta_thresholds(nullptr),
+        _derived_sensor_count(0), _derived_sensors(nullptr), _filter_count(0),
+        _filters(nullptr), _kernel_energy(nullptr), _marker_channel(nullptr),
+        _output_path(nullptr), _overhead_report(nullptr),
+        _process_energy(nullptr), _sensor_delay_count(0), _sensor_delays(nullptr),
+        _sensor_interval_count(0), _sensor_intervals(nullptr),
+        _sensor_priorities(nullptr), _sensor_priority_count(0),
+        _sensor_quantities(nullptr), _sensor_quantity_count(0),
+        _shared_memory(nullptr), _waveform_archive(nullptr) {
     *this = rhs;
 }
 
@@ -42,45 +162,1400 @@ visus::power_overwhelming::collector_settings::~collector_settings(void) {
     if (this->_output_path != nullptr) {
         ::free(this->_output_path);
     }
+
+    for (std::size_t i = 0; i < this->_delta_threshold_count; ++i) {
+        detail::safe_assign(this->_delta_thresholds[i].sensor, nullptr);
+    }
+    delete[] this->_delta_thresholds;
+
+    for (std::size_t i = 0; i < this->_derived_sensor_count; ++i) {
+        detail::safe_assign(this->_derived_sensors[i].expression, nullptr);
+        detail::safe_assign(this->_derived_sensors[i].sensor, nullptr);
+    }
+    delete[] this->_derived_sensors;
+
+    for (std::size_t i = 0; i < this->_filter_count; ++i) {
+        detail::safe_assign(this->_filters[i].sensor, nullptr);
+    }
+    delete[] this->_filters;
+
+    for (std::size_t i = 0; i < this->_sensor_delay_count; ++i) {
+        detail::safe_assign(this->_sensor_delays[i].sensor, nullptr);
+    }
+    delete[] this->_sensor_delays;
+
+    for (std::size_t i = 0; i < this->_sensor_interval_count; ++i) {
+        detail::safe_assign(this->_sensor_intervals[i].sensor, nullptr);
+    }
+    delete[] this->_sensor_intervals;
+
+    for (std::size_t i = 0; i < this->_sensor_priority_count; ++i) {
+        detail::safe_assign(this->_sensor_priorities[i].sensor, nullptr);
+    }
+    delete[] this->_sensor_priorities;
+
+    for (std::size_t i = 0; i < this->_sensor_quantity_count; ++i) {
+        detail::safe_assign(this->_sensor_quantities[i].sensor, nullptr);
+    }
+    delete[] this->_sensor_quantities;
+
+    detail::safe_assign(this->_capability_report, nullptr);
+    detail::safe_assign(this->_kernel_energy, nullptr);
+    detail::safe_assign(this->_marker_channel, nullptr);
+    detail::safe_assign(this->_overhead_report, nullptr);
+    detail::safe_assign(this->_process_energy, nullptr);
+    detail::safe_assign(this->_shared_memory, nullptr);
+    detail::safe_assign(this->_waveform_archive, nullptr);
 }
 
 
 /*
- * visus::power_overwhelming::collector_settings::output_path
+ * visus::power_overwhelming::collector_settings::aggregate_only
  */
 visus::power_overwhelming::collector_settings&
-visus::power_overwhelming::collector_settings::output_path(
-        _In_z_ const wchar_t *path) {
-    if (path == nullptr) {
-        throw std::invalid_argument("The output path must be a valid string.");
+visus::power_overwhelming::collector_settings::aggregate_only(
+        _In_ const bool aggregate_only) {
+    this->_aggregate_only = aggregate_only;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::aggregation_window
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::aggregation_window(
+        _In_ const sampling_interval_type window) {
+    this->_aggregation_window = window;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::align_timestamps
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::align_timestamps(
+        _In_ const bool align) {
+    this->_align_timestamps = align;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::buffer_size
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::buffer_size(
+        _In_ const std::size_t size) {
+    if (size == 0) {
+        throw std::invalid_argument("The buffer size must be positive.");
     }
 
-    detail::safe_assign(this->_output_path, path);
+    this->_buffer_size = size;
+    return *this;
+}
 
+
+/*
+ * visus::power_overwhelming::collector_settings::capability_report
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::capability_report(
+        _In_opt_z_ const wchar_t *path) {
+    if ((path != nullptr) && (*path == 0)) {
+        path = nullptr;
+    }
+
+    detail::safe_assign(this->_capability_report, path);
     return *this;
 }
 
 
 /*
- * visus::power_overwhelming::collector_settings::sampling_interval
+ * visus::power_overwhelming::collector_settings::compress_output
  */
 visus::power_overwhelming::collector_settings&
-visus::power_overwhelming::collector_settings::sampling_interval(
+visus::power_overwhelming::collector_settings::compress_output(
+        _In_ const bool compress) {
+    this->_compress_output = compress;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::compress_waveforms
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::compress_waveforms(
+        _In_ const bool compress) {
+    this->_compress_waveforms = compress;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::delta_threshold
+ */
+float visus::power_overwhelming::collector_settings::delta_threshold(
+        _In_opt_z_ const wchar_t *sensor) const noexcept {
+    if (sensor != nullptr) {
+        for (std::size_t i = 0; i < this->_delta_threshold_count; ++i) {
+            auto& s = this->_delta_thresholds[i];
+            if (::wcscmp(s.sensor, sensor) == 0) {
+                return s.threshold;
+            }
+        }
+    }
+
+    return -1.0f;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::delta_threshold
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::delta_threshold(
+        _In_z_ const wchar_t *sensor,
+        _In_ const float threshold) {
+    if (sensor == nullptr) {
+        throw std::invalid_argument("The sensor to configure the change "
+            "threshold for must be a valid string.");
+    }
+
+    for (std::size_t i = 0; i < this->_delta_threshold_count; ++i) {
+        auto& s = this->_delta_thresholds[i];
+        if (::wcscmp(s.sensor, sensor) != 0) {
+            continue;
+        }
+
+        if (threshold >= 0.0f) {
+            s.threshold = threshold;
+        } else {
+            // Remove the entry by moving the last one into its place.
+            detail::safe_assign(s.sensor, nullptr);
+            s = this->_delta_thresholds[--this->_delta_threshold_count];
+        }
+
+        return *this;
+    }
+
+    if (threshold >= 0.0f) {
+        // The list is expected to be very short, so we grow it one by one.
+        const auto cnt = this->_delta_threshold_count;
+        auto thresholds = new sensor_threshold_type[cnt + 1];
+        std::copy(this->_delta_thresholds, this->_delta_thresholds + cnt,
+            thresholds);
+
+        thresholds[cnt].sensor = nullptr;
+        thresholds[cnt].threshold = threshold;
+        try {
+            detail::safe_assign(thresholds[cnt].sensor, sensor);
+        } catch (...) {
+            delete[] thresholds;
+            throw;
+        }
+
+        delete[] this->_delta_thresholds;
+        this->_delta_thresholds = thresholds;
+        ++this->_delta_threshold_count;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::delta_thresholds
+ */
+std::size_t visus::power_overwhelming::collector_settings::delta_thresholds(
+        _Out_writes_opt_(cnt) const wchar_t **dst,
+        _In_ const std::size_t cnt) const noexcept {
+    if (dst != nullptr) {
+        for (std::size_t i = 0; (i < cnt)
+                && (i < this->_delta_threshold_count); ++i) {
+            dst[i] = this->_delta_thresholds[i].sensor;
+        }
+    }
+
+    return this->_delta_threshold_count;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::derived_sensor
+ */
+const wchar_t *visus::power_overwhelming::collector_settings::derived_sensor(
+        _In_opt_z_ const wchar_t *sensor) const noexcept {
+    if (sensor != nullptr) {
+        for (std::size_t i = 0; i < this->_derived_sensor_count; ++i) {
+            auto& s = this->_derived_sensors[i];
+            if (::wcscmp(s.sensor, sensor) == 0) {
+                return s.expression;
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::derived_sensor
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::derived_sensor(
+        _In_z_ const wchar_t *sensor,
+        _In_opt_z_ const wchar_t *expression) {
+    if (sensor == nullptr) {
+        throw std::invalid_argument("The name of a derived sensor must be a "
+            "valid string.");
+    }
+
+    if (expression != nullptr) {
+        // Compile the expression to report errors as early as possible.
+        detail::derived_expression e(expression);
+    }
+
+    for (std::size_t i = 0; i < this->_derived_sensor_count; ++i) {
+        auto& s = this->_derived_sensors[i];
+        if (::wcscmp(s.sensor, sensor) != 0) {
+            continue;
+        }
+
+        if (expression != nullptr) {
+            detail::safe_assign(s.expression, expression);
+        } else {
+            // Derived sensors might use the ones before them, so we must
+            // retain the order when removing one.
+            detail::safe_assign(s.expression, nullptr);
+            detail::safe_assign(s.sensor, nullptr);
+            std::copy(this->_derived_sensors + i + 1,
+                this->_derived_sensors + this->_derived_sensor_count,
+                this->_derived_sensors + i);
+            --this->_derived_sensor_count;
+        }
+
+        return *this;
+    }
+
+    if (expression != nullptr) {
+        const auto cnt = this->_derived_sensor_count;
+        auto sensors = new derived_sensor_type[cnt + 1];
+        std::copy(this->_derived_sensors, this->_derived_sensors + cnt,
+            sensors);
+
+        sensors[cnt].expression = nullptr;
+        sensors[cnt].sensor = nullptr;
+        try {
+            detail::safe_assign(sensors[cnt].expression, expression);
+            detail::safe_assign(sensors[cnt].sensor, sensor);
+        } catch (...) {
+            detail::safe_assign(sensors[cnt].expression, nullptr);
+            delete[] sensors;
+            throw;
+        }
+
+        delete[] this->_derived_sensors;
+        this->_derived_sensors = sensors;
+        ++this->_derived_sensor_count;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::derived_sensors
+ */
+std::size_t visus::power_overwhelming::collector_settings::derived_sensors(
+        _Out_writes_opt_(cnt) const wchar_t **dst,
+        _In_ const std::size_t cnt) const noexcept {
+    if (dst != nullptr) {
+        for (std::size_t i = 0; (i < cnt)
+                && (i < this->_derived_sensor_count); ++i) {
+            dst[i] = this->_derived_sensors[i].sensor;
+        }
+    }
+
+    return this->_derived_sensor_count;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::estimate_power
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::estimate_power(
+        _In_ const bool estimate) {
+    this->_estimate_power = estimate;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::filter
+ */
+visus::power_overwhelming::sample_filter
+visus::power_overwhelming::collector_settings::filter(
+        _In_opt_z_ const wchar_t *sensor) const noexcept {
+    if (sensor != nullptr) {
+        for (std::size_t i = 0; i < this->_filter_count; ++i) {
+            auto& s = this->_filters[i];
+            if (::wcscmp(s.sensor, sensor) == 0) {
+                return s.filter;
+            }
+        }
+    }
+
+    return sample_filter();
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::filter
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::filter(
+        _In_z_ const wchar_t *sensor,
+        _In_ const sample_filter& filter) {
+    if (sensor == nullptr) {
+        throw std::invalid_argument("The sensor to configure the filter for "
+            "must be a valid string.");
+    }
+
+    for (std::size_t i = 0; i < this->_filter_count; ++i) {
+        auto& s = this->_filters[i];
+        if (::wcscmp(s.sensor, sensor) != 0) {
+            continue;
+        }
+
+        if (filter) {
+            s.filter = filter;
+        } else {
+            // Remove the entry by moving the last one into its place.
+            detail::safe_assign(s.sensor, nullptr);
+            s = this->_filters[--this->_filter_count];
+        }
+
+        return *this;
+    }
+
+    if (filter) {
+        const auto cnt = this->_filter_count;
+        auto filters = new sensor_filter_type[cnt + 1];
+        std::copy(this->_filters, this->_filters + cnt, filters);
+
+        filters[cnt].filter = filter;
+        filters[cnt].sensor = nullptr;
+        try {
+            detail::safe_assign(filters[cnt].sensor, sensor);
+        } catch (...) {
+            delete[] filters;
+            throw;
+        }
+
+        delete[] this->_filters;
+        this->_filters = filters;
+        ++this->_filter_count;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::filters
+ */
+std::size_t visus::power_overwhelming::collector_settings::filters(
+        _Out_writes_opt_(cnt) const wchar_t **dst,
+        _In_ const std::size_t cnt) const noexcept {
+    if (dst != nullptr) {
+        for (std::size_t i = 0; (i < cnt) && (i < this->_filter_count); ++i) {
+            dst[i] = this->_filters[i].sensor;
+        }
+    }
+
+    return this->_filter_count;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::integrate_energy
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::integrate_energy(
+        _In_ const bool integrate) {
+    this->_integrate_energy = integrate;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::integrate_instruments
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::integrate_instruments(
+        _In_ const bool integrate) {
+    this->_integrate_instruments = integrate;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::keep_alive_interval
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::keep_alive_interval(
         _In_ const sampling_interval_type interval) {
-    this->_sampling_interval = interval;
+    this->_keep_alive_interval = interval;
     return *this;
 }
 
 
 /*
- * visus::power_overwhelming::collector_settings::operator =
+ * visus::power_overwhelming::collector_settings::kernel_energy
  */
 visus::power_overwhelming::collector_settings&
-visus::power_overwhelming::collector_settings::operator =(
-        _In_ const collector_settings& rhs) {
-    if (this != std::addressof(rhs)) {
-        this->output_path(rhs._output_path);
-        this->sampling_interval(rhs._sampling_interval);
+visus::power_overwhelming::collector_settings::kernel_energy(
+        _In_opt_z_ const wchar_t *path) {
+    if ((path != nullptr) && (*path == 0)) {
+        path = nullptr;
+    }
+
+    detail::safe_assign(this->_kernel_energy, path);
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::limit_to_native_interval
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::limit_to_native_interval(
+        _In_ const bool limit) {
+    this->_limit_to_native_interval = limit;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::lock_memory
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::lock_memory(
+        _In_ const bool lock) {
+    this->_lock_memory = lock;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::manual_pump
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::manual_pump(
+        _In_ const bool manual) {
+    this->_manual_pump = manual;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::marker_channel
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::marker_channel(
+        _In_opt_z_ const wchar_t *name) {
+    if ((name != nullptr) && (*name == 0)) {
+        name = nullptr;
+    }
+
+    detail::safe_assign(this->_marker_channel, name);
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::merge_instrument_logs
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::merge_instrument_logs(
+        _In_ const bool merge) {
+    this->_merge_instrument_logs = merge;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::min_sampling_interval
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::min_sampling_interval(
+        _In_ const sampling_interval_type interval) {
+    this->_min_sampling_interval = interval;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::output_format
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::output_format(
+        _In_ const power_overwhelming::output_format format) {
+    this->_output_format = format;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::output_path
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::output_path(
+        _In_z_ const wchar_t *path) {
+    if (path == nullptr) {
+        throw std::invalid_argument("The output path must be a valid string.");
+    }
+
+    detail::safe_assign(this->_output_path, path);
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::overhead_interval
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::overhead_interval(
+        _In_ const sampling_interval_type interval) {
+    this->_overhead_interval = interval;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::overhead_report
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::overhead_report(
+        _In_opt_z_ const wchar_t *path) {
+    if ((path != nullptr) && (*path == 0)) {
+        path = nullptr;
+    }
+
+    detail::safe_assign(this->_overhead_report, path);
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::overhead_window
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::overhead_window(
+        _In_ const sampling_interval_type window) {
+    this->_overhead_window = window;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::post_trigger
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::post_trigger(
+        _In_ const sampling_interval_type window) {
+    this->_post_trigger = window;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::pre_trigger
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::pre_trigger(
+        _In_ const sampling_interval_type window) {
+    this->_pre_trigger = window;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::process_energy
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::process_energy(
+        _In_opt_z_ const wchar_t *path) {
+    if ((path != nullptr) && (*path == 0)) {
+        path = nullptr;
+    }
+
+    detail::safe_assign(this->_process_energy, path);
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::record_overhead
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::record_overhead(
+        _In_ const bool record) {
+    this->_record_overhead = record;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::require_marker
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::require_marker(
+        _In_ const bool require) {
+    this->_require_marker = require;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::resampling_interval
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::resampling_interval(
+        _In_ const sampling_interval_type interval) {
+    this->_resampling_interval = interval;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::retain_unfiltered
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::retain_unfiltered(
+        _In_ const bool retain) {
+    this->_retain_unfiltered = retain;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::rotate_interval
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::rotate_interval(
+        _In_ const sampling_interval_type interval) {
+    this->_rotate_interval = interval;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::rotate_size
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::rotate_size(
+        _In_ const std::uint64_t size) {
+    this->_rotate_size = size;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::sampling_interval
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::sampling_interval(
+        _In_ const sampling_interval_type interval) {
+    this->_sampling_interval = interval;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::sampling_cpu_budget
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::sampling_cpu_budget(
+        _In_ const float budget) {
+    if (!(budget >= 0.0f)) {
+        throw std::invalid_argument("The CPU budget for sampling must not be "
+            "negative.");
+    }
+
+    this->_sampling_cpu_budget = budget;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::sampling_read_budget
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::sampling_read_budget(
+        _In_ const std::uint64_t budget) {
+    this->_sampling_read_budget = budget;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::sensor_delay
+ */
+visus::power_overwhelming::collector_settings::sampling_interval_type
+visus::power_overwhelming::collector_settings::sensor_delay(
+        _In_opt_z_ const wchar_t *sensor) const noexcept {
+    if (sensor != nullptr) {
+        for (std::size_t i = 0; i < this->_sensor_delay_count; ++i) {
+            auto& s = this->_sensor_delays[i];
+            if (::wcscmp(s.sensor, sensor) == 0) {
+                return s.interval;
+            }
+        }
+    }
+
+    return 0;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::sensor_delay
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::sensor_delay(
+        _In_z_ const wchar_t *sensor,
+        _In_ const sampling_interval_type delay) {
+    if (sensor == nullptr) {
+        throw std::invalid_argument("The sensor to configure the delay for "
+            "must be a valid string.");
+    }
+
+    for (std::size_t i = 0; i < this->_sensor_delay_count; ++i) {
+        auto& s = this->_sensor_delays[i];
+        if (::wcscmp(s.sensor, sensor) != 0) {
+            continue;
+        }
+
+        if (delay != 0) {
+            s.interval = delay;
+        } else {
+            // Remove the entry by moving the last one into its place.
+            detail::safe_assign(s.sensor, nullptr);
+            s = this->_sensor_delays[--this->_sensor_delay_count];
+        }
+
+        return *this;
+    }
+
+    if (delay != 0) {
+        const auto cnt = this->_sensor_delay_count;
+        auto delays = new sensor_interval_type[cnt + 1];
+        std::copy(this->_sensor_delays, this->_sensor_delays + cnt, delays);
+
+        delays[cnt].sensor = nullptr;
+        delays[cnt].interval = delay;
+        try {
+            detail::safe_assign(delays[cnt].sensor, sensor);
+        } catch (...) {
+            delete[] delays;
+            throw;
+        }
+
+        delete[] this->_sensor_delays;
+        this->_sensor_delays = delays;
+        ++this->_sensor_delay_count;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::sensor_delays
+ */
+std::size_t visus::power_overwhelming::collector_settings::sensor_delays(
+        _Out_writes_opt_(cnt) const wchar_t **dst,
+        _In_ const std::size_t cnt) const noexcept {
+    if (dst != nullptr) {
+        for (std::size_t i = 0; (i < cnt)
+                && (i < this->_sensor_delay_count); ++i) {
+            dst[i] = this->_sensor_delays[i].sensor;
+        }
+    }
+
+    return this->_sensor_delay_count;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::sensor_interval
+ */
+visus::power_overwhelming::collector_settings::sampling_interval_type
+visus::power_overwhelming::collector_settings::sensor_interval(
+        _In_opt_z_ const wchar_t *sensor) const noexcept {
+    if (sensor != nullptr) {
+        for (std::size_t i = 0; i < this->_sensor_interval_count; ++i) {
+            auto& s = this->_sensor_intervals[i];
+            if (::wcscmp(s.sensor, sensor) == 0) {
+                return s.interval;
+            }
+        }
+    }
+
+    return this->_sampling_interval;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::sensor_interval
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::sensor_interval(
+        _In_z_ const wchar_t *sensor,
+        _In_ const sampling_interval_type interval) {
+    if (sensor == nullptr) {
+        throw std::invalid_argument("The sensor to configure the sampling "
+            "interval for must be a valid string.");
+    }
+
+    for (std::size_t i = 0; i < this->_sensor_interval_count; ++i) {
+        auto& s = this->_sensor_intervals[i];
+        if (::wcscmp(s.sensor, sensor) != 0) {
+            continue;
+        }
+
+        if (interval != 0) {
+            s.interval = interval;
+        } else {
+            // Remove the entry by moving the last one into its place.
+            detail::safe_assign(s.sensor, nullptr);
+            s = this->_sensor_intervals[--this->_sensor_interval_count];
+        }
+
+        return *this;
+    }
+
+    if (interval != 0) {
+        // The list is expected to be very short, so we grow it one by one.
+        const auto cnt = this->_sensor_interval_count;
+        auto intervals = new sensor_interval_type[cnt + 1];
+        std::copy(this->_sensor_intervals, this->_sensor_intervals + cnt,
+            intervals);
+
+        intervals[cnt].sensor = nullptr;
+        intervals[cnt].interval = interval;
+        try {
+            detail::safe_assign(intervals[cnt].sensor, sensor);
+        } catch (...) {
+            delete[] intervals;
+            throw;
+        }
+
+        delete[] this->_sensor_intervals;
+        this->_sensor_intervals = intervals;
+        ++this->_sensor_interval_count;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::sensor_intervals
+ */
+std::size_t visus::power_overwhelming::collector_settings::sensor_intervals(
+        _Out_writes_opt_(cnt) const wchar_t **dst,
+        _In_ const std::size_t cnt) const noexcept {
+    if (dst != nullptr) {
+        for (std::size_t i = 0; (i < cnt)
+                && (i < this->_sensor_interval_count); ++i) {
+            dst[i] = this->_sensor_intervals[i].sensor;
+        }
+    }
+
+    return this->_sensor_interval_count;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::sensor_priority
+ */
+float visus::power_overwhelming::collector_settings::sensor_priority(
+        _In_opt_z_ const wchar_t *sensor) const noexcept {
+    if (sensor != nullptr) {
+        for (std::size_t i = 0; i < this->_sensor_priority_count; ++i) {
+            auto& s = this->_sensor_priorities[i];
+            if (::wcscmp(s.sensor, sensor) == 0) {
+                return s.threshold;
+            }
+        }
+    }
+
+    return 1.0f;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::sensor_priority
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::sensor_priority(
+        _In_z_ const wchar_t *sensor,
+        _In_ const float priority) {
+    if (sensor == nullptr) {
+        throw std::invalid_argument("The sensor to configure the priority for "
+            "must be a valid string.");
+    }
+    if (!(priority >= 0.0f)) {
+        throw std::invalid_argument("The priority of a sensor must not be "
+            "negative.");
+    }
+
+    for (std::size_t i = 0; i < this->_sensor_priority_count; ++i) {
+        auto& s = this->_sensor_priorities[i];
+        if (::wcscmp(s.sensor, sensor) != 0) {
+            continue;
+        }
+
+        if (priority > 0.0f) {
+            s.threshold = priority;
+        } else {
+            // Remove the entry by moving the last one into its place.
+            detail::safe_assign(s.sensor, nullptr);
+            s = this->_sensor_priorities[--this->_sensor_priority_count];
+        }
+
+        return *this;
+    }
+
+    if (priority > 0.0f) {
+        // The list is expected to be very short, so we grow it one by one.
+        const auto cnt = this->_sensor_priority_count;
+        auto priorities = new sensor_threshold_type[cnt + 1];
+        std::copy(this->_sensor_priorities, this->_sensor_priorities + cnt,
+            priorities);
+
+        priorities[cnt].sensor = nullptr;
+        priorities[cnt].threshold = priority;
+        try {
+            detail::safe_assign(priorities[cnt].sensor, sensor);
+        } catch (...) {
+            delete[] priorities;
+            throw;
+        }
+
+        delete[] this->_sensor_priorities;
+        this->_sensor_priorities = priorities;
+        ++this->_sensor_priority_count;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::sensor_priorities
+ */
+std::size_t visus::power_overwhelming::collector_settings::sensor_priorities(
+        _Out_writes_opt_(cnt) const wchar_t **dst,
+        _In_ const std::size_t cnt) const noexcept {
+    if (dst != nullptr) {
+        for (std::size_t i = 0; (i < cnt)
+                && (i < this->_sensor_priority_count); ++i) {
+            dst[i] = this->_sensor_priorities[i].sensor;
+        }
+    }
+
+    return this->_sensor_priority_count;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::sensor_quantity
+ */
+visus::power_overwhelming::tinkerforge_sensor_source
+visus::power_overwhelming::collector_settings::sensor_quantity(
+        _In_opt_z_ const wchar_t *sensor) const noexcept {
+    if (sensor != nullptr) {
+        for (std::size_t i = 0; i < this->_sensor_quantity_count; ++i) {
+            auto& s = this->_sensor_quantities[i];
+            if (::wcscmp(s.sensor, sensor) == 0) {
+                return s.quantities;
+            }
+        }
+    }
+
+    return tinkerforge_sensor_source::none;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::sensor_quantity
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::sensor_quantity(
+        _In_z_ const wchar_t *sensor,
+        _In_ const tinkerforge_sensor_source quantities) {
+    if (sensor == nullptr) {
+        throw std::invalid_argument("The sensor to select the quantities for "
+            "must be a valid string.");
+    }
+    if ((quantities & tinkerforge_sensor_source::all) != quantities) {
+        throw std::invalid_argument("The quantities of a sensor must be a "
+            "combination of current, voltage and power.");
+    }
+
+    for (std::size_t i = 0; i < this->_sensor_quantity_count; ++i) {
+        auto& s = this->_sensor_quantities[i];
+        if (::wcscmp(s.sensor, sensor) != 0) {
+            continue;
+        }
+
+        if (quantities != tinkerforge_sensor_source::none) {
+            s.quantities = quantities;
+        } else {
+            // Remove the entry by moving the last one into its place.
+            detail::safe_assign(s.sensor, nullptr);
+            s = this->_sensor_quantities[--this->_sensor_quantity_count];
+        }
+
+        return *this;
+    }
+
+    if (quantities != tinkerforge_sensor_source::none) {
+        const auto cnt = this->_sensor_quantity_count;
+        auto entries = new sensor_quantity_type[cnt + 1];
+        std::copy(this->_sensor_quantities, this->_sensor_quantities + cnt,
+            entries);
+
+        entries[cnt].quantities = quantities;
+        entries[cnt].sensor = nullptr;
+        try {
+            detail::safe_assign(entries[cnt].sensor, sensor);
+        } catch (...) {
+            delete[] entries;
+            throw;
+        }
+
+        delete[] this->_sensor_quantities;
+        this->_sensor_quantities = entries;
+        ++this->_sensor_quantity_count;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::sensor_quantities
+ */
+std::size_t visus::power_overwhelming::collector_settings::sensor_quantities(
+        _Out_writes_opt_(cnt) const wchar_t **dst,
+        _In_ const std::size_t cnt) const noexcept {
+    if (dst != nullptr) {
+        for (std::size_t i = 0; (i < cnt)
+                && (i < this->_sensor_quantity_count); ++i) {
+            dst[i] = this->_sensor_quantities[i].sensor;
+        }
+    }
+
+    return this->_sensor_quantity_count;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::shared_memory
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::shared_memory(
+        _In_opt_z_ const wchar_t *name) {
+    if ((name != nullptr) && (*name == 0)) {
+        name = nullptr;
+    }
+
+    detail::safe_assign(this->_shared_memory, name);
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::subscriber_capacity
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::subscriber_capacity(
+        _In_ const std::size_t capacity) {
+    if (capacity == 0) {
+        throw std::invalid_argument("The capacity of the subscriber ring must "
+            "be positive.");
+    }
+
+    this->_subscriber_capacity = capacity;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::suppress_duplicates
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::suppress_duplicates(
+        _In_ const bool suppress) {
+    this->_suppress_duplicates = suppress;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::tinkerforge_arrival_times
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::tinkerforge_arrival_times(
+        _In_ const bool keep) {
+    this->_tinkerforge_arrival_times = keep;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::track_quantiles
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::track_quantiles(
+        _In_ const bool track) {
+    this->_track_quantiles = track;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::track_sequences
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::track_sequences(
+        _In_ const bool track) {
+    this->_track_sequences = track;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::trigger_oscilloscopes
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::trigger_oscilloscopes(
+        _In_ const bool trigger) {
+    this->_trigger_oscilloscopes = trigger;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::trigger_threshold
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::trigger_threshold(
+        _In_ const float threshold) {
+    this->_trigger_threshold = threshold;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::waveform_archive
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::waveform_archive(
+        _In_opt_z_ const wchar_t *path) {
+    if ((path != nullptr) && (*path == 0)) {
+        path = nullptr;
+    }
+
+    detail::safe_assign(this->_waveform_archive, path);
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::write_latency
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::write_latency(
+        _In_ const sampling_interval_type latency) {
+    if (latency == 0) {
+        throw std::invalid_argument("The write latency must be positive.");
+    }
+
+    this->_write_latency = latency;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::write_statistics
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::write_statistics(
+        _In_ const bool write) {
+    this->_write_statistics = write;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::write_threshold
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::write_threshold(
+        _In_ const float threshold) {
+    if (!(threshold > 0.0f) || (threshold > 1.0f)) {
+        throw std::invalid_argument("The write threshold must be within "
+            "(0, 1].");
+    }
+
+    this->_write_threshold = threshold;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::writer_threads
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::writer_threads(
+        _In_ const std::size_t threads) {
+    if (threads < 1) {
+        throw std::invalid_argument("At least one writer thread is "
+            "required.");
+    }
+
+    this->_writer_threads = threads;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::operator =
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::operator =(
+        _In_ const collector_settings& rhs) {
+    if (this != std::addressof(rhs)) {
+        this->aggregate_only(rhs._aggregate_only);
+        this->aggregation_window(rhs._aggregation_window);
+        this->align_timestamps(rhs._align_timestamps);
+        this->buffer_size(rhs._buffer_size);
+        this->capability_report(rhs._capability_report);
+        this->compress_output(rhs._compress_output);
+        this->compress_waveforms(rhs._compress_waveforms);
+        this->estimate_power(rhs._estimate_power);
+        this->integrate_energy(rhs._integrate_energy);
+        this->integrate_instruments(rhs._integrate_instruments);
+        this->keep_alive_interval(rhs._keep_alive_interval);
+        this->kernel_energy(rhs._kernel_energy);
+        this->limit_to_native_interval(rhs._limit_to_native_interval);
+        this->lock_memory(rhs._lock_memory);
+        this->manual_pump(rhs._manual_pump);
+        this->marker_channel(rhs._marker_channel);
+        this->merge_instrument_logs(rhs._merge_instrument_logs);
+        this->min_sampling_interval(rhs._min_sampling_interval);
+        this->output_format(rhs._output_format);
+        this->output_path(rhs._output_path);
+        this->overhead_interval(rhs._overhead_interval);
+        this->overhead_report(rhs._overhead_report);
+        this->overhead_window(rhs._overhead_window);
+        this->post_trigger(rhs._post_trigger);
+        this->pre_trigger(rhs._pre_trigger);
+        this->process_energy(rhs._process_energy);
+        this->record_overhead(rhs._record_overhead);
+        this->require_marker(rhs._require_marker);
+        this->resampling_interval(rhs._resampling_interval);
+        this->retain_unfiltered(rhs._retain_unfiltered);
+        this->rotate_interval(rhs._rotate_interval);
+        this->rotate_size(rhs._rotate_size);
+        this->sampling_cpu_budget(rhs._sampling_cpu_budget);
+        this->sampling_interval(rhs._sampling_interval);
+        this->sampling_read_budget(rhs._sampling_read_budget);
+        this->shared_memory(rhs._shared_memory);
+        this->subscriber_capacity(rhs._subscriber_capacity);
+        this->suppress_duplicates(rhs._suppress_duplicates);
+        this->tinkerforge_arrival_times(rhs._tinkerforge_arrival_times);
+        this->track_quantiles(rhs._track_quantiles);
+        this->track_sequences(rhs._track_sequences);
+        this->trigger_oscilloscopes(rhs._trigger_oscilloscopes);
+        this->trigger_threshold(rhs._trigger_threshold);
+        this->waveform_archive(rhs._waveform_archive);
+        this->write_latency(rhs._write_latency);
+        this->write_statistics(rhs._write_statistics);
+        this->write_threshold(rhs._write_threshold);
+        this->writer_threads(rhs._writer_threads);
+
+        while (this->_sensor_delay_count > 0) {
+            auto& s = this->_sensor_delays[0];
+            this->sensor_delay(s.sensor, 0);
+        }
+        for (std::size_t i = 0; i < rhs._sensor_delay_count; ++i) {
+            auto& s = rhs._sensor_delays[i];
+            this->sensor_delay(s.sensor, s.interval);
+        }
+
+        while (this->_sensor_interval_count > 0) {
+            auto& s = this->_sensor_intervals[0];
+            this->sensor_interval(s.sensor, 0);
+        }
+        for (std::size_t i = 0; i < rhs._sensor_interval_count; ++i) {
+            auto& s = rhs._sensor_intervals[i];
+            this->sensor_interval(s.sensor, s.interval);
+        }
+
+        while (this->_sensor_priority_count > 0) {
+            auto& s = this->_sensor_priorities[0];
+            this->sensor_priority(s.sensor, 0.0f);
+        }
+        for (std::size_t i = 0; i < rhs._sensor_priority_count; ++i) {
+            auto& s = rhs._sensor_priorities[i];
+            this->sensor_priority(s.sensor, s.threshold);
+        }
+
+        while (this->_sensor_quantity_count > 0) {
+            auto& s = this->_sensor_quantities[0];
+            this->sensor_quantity(s.sensor, tinkerforge_sensor_source::none);
+        }
+        for (std::size_t i = 0; i < rhs._sensor_quantity_count; ++i) {
+            auto& s = rhs._sensor_quantities[i];
+            this->sensor_quantity(s.sensor, s.quantities);
+        }
+
+        while (this->_delta_threshold_count > 0) {
+            auto& s = this->_delta_thresholds[0];
+            this->delta_threshold(s.sensor, -1.0f);
+        }
+        for (std::size_t i = 0; i < rhs._delta_threshold_count; ++i) {
+            auto& s = rhs._delta_thresholds[i];
+            this->delta_threshold(s.sensor, s.threshold);
+        }
+
+        while (this->_derived_sensor_count > 0) {
+            auto& s = this->_derived_sensors[0];
+            this->derived_sensor(s.sensor, nullptr);
+        }
+        for (std::size_t i = 0; i < rhs._derived_sensor_count; ++i) {
+            auto& s = rhs._derived_sensors[i];
+            this->derived_sensor(s.sensor, s.expression);
+        }
+
+        while (this->_filter_count > 0) {
+            auto& s = this->_filters[0];
+            this->filter(s.sensor, sample_filter());
+        }
+        for (std::size_t i = 0; i < rhs._filter_count; ++i) {
+            auto& s = rhs._filters[i];
+            this->filter(s.sensor, s.filter);
+        }
     }
 
     return *this;
@@ -0,0 +1,269 @@
+﻿// <copyright file="collector_statistics.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/collector_statistics.h"
+
+#include <memory>
+#include <stdexcept>
+
+#include "collector_statistics_impl.h"
+
+
+/*
+ * visus::power_overwhelming::collector_statistics::collector_statistics
+ */
+visus::power_overwhelming::collector_statistics::collector_statistics(void)
+    : _impl(new detail::collector_statistics_impl()) { }
+
+
+/*
+ * visus::power_overwhelming::collector_statistics::collector_statistics
+ */
+visus::power_overwhelming::collector_statistics::collector_statistics(
+        _In_ const collector_statistics& rhs)
+    : _impl(new detail::collector_statistics_impl(rhs.check_not_disposed())) { }
+
+
+/*
+ * visus::power_overwhelming::collector_statistics::collector_statistics
+ */
+visus::power_overwhelming::collector_statistics::collector_statistics(
+        _Inout_ collector_statistics&& rhs) noexcept : _impl(rhs._impl) {
+    rhs._impl = nullptr;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_statistics::~collector_statistics
+ */
+visus::power_overwhelming::collector_statistics::~collector_statistics(
+        void) {
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_statistics::backlog
+ */
+std::uint64_t visus::power_overwhelming::collector_statistics::backlog(
+        void) const {
+    return this->check_not_disposed().backlog;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_statistics::backlog_bytes
+ */
+std::uint64_t visus::power_overwhelming::collector_statistics::backlog_bytes(
+        void) const {
+    return this->check_not_disposed().backlog_bytes;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_statistics::bytes_written
+ */
+std::uint64_t visus::power_overwhelming::collector_statistics::bytes_written(
+        void) const {
+    return this->check_not_disposed().bytes_written;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_statistics::dropped
+ */
+std::uint64_t visus::power_overwhelming::collector_statistics::dropped(
+        void) const {
+    return this->check_not_disposed().dropped;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_statistics::elapsed
+ */
+visus::power_overwhelming::collector_statistics::interval_type
+visus::power_overwhelming::collector_statistics::elapsed(void) const {
+    return this->check_not_disposed().elapsed;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_statistics::flush_duration
+ */
+const visus::power_overwhelming::latency_histogram&
+visus::power_overwhelming::collector_statistics::flush_duration(void) const {
+    return this->check_not_disposed().flush_duration;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_statistics::marker_events
+ */
+std::uint64_t visus::power_overwhelming::collector_statistics::marker_events(
+        void) const {
+    return this->check_not_disposed().marker_events;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_statistics::quantile
+ */
+float visus::power_overwhelming::collector_statistics::quantile(
+        _In_ const std::size_t index, _In_ const double q) const {
+    return this->check_not_disposed().quantiles.at(index).at(q);
+}
+
+
+/*
+ * visus::power_overwhelming::collector_statistics::quantile_marker
+ */
+std::uint32_t visus::power_overwhelming::collector_statistics::quantile_marker(
+        _In_ const std::size_t index) const {
+    return this->check_not_disposed().quantiles.at(index).marker;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_statistics::quantile_samples
+ */
+std::uint64_t
+visus::power_overwhelming::collector_statistics::quantile_samples(
+        _In_ const std::size_t index) const {
+    return this->check_not_disposed().quantiles.at(index).samples;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_statistics::quantile_sensor
+ */
+_Ret_z_ const wchar_t *
+visus::power_overwhelming::collector_statistics::quantile_sensor(
+        _In_ const std::size_t index) const {
+    return this->check_not_disposed().quantiles.at(index).sensor;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_statistics::quantiles
+ */
+std::size_t visus::power_overwhelming::collector_statistics::quantiles(
+        void) const {
+    return this->check_not_disposed().quantiles.size();
+}
+
+
+/*
+ * visus::power_overwhelming::collector_statistics::sample_rate
+ */
+double visus::power_overwhelming::collector_statistics::sample_rate(
+        void) const {
+    auto& impl = this->check_not_disposed();
+    return impl.rate(impl.samples);
+}
+
+
+/*
+ * visus::power_overwhelming::collector_statistics::samples
+ */
+std::uint64_t visus::power_overwhelming::collector_statistics::samples(
+        void) const {
+    return this->check_not_disposed().samples;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_statistics::sensor
+ */
+_Ret_z_ const wchar_t *visus::power_overwhelming::collector_statistics::sensor(
+        _In_ const std::size_t index) const {
+    return this->check_not_disposed().sensors.at(index).first.c_str();
+}
+
+
+/*
+ * visus::power_overwhelming::collector_statistics::sensor_rate
+ */
+double visus::power_overwhelming::collector_statistics::sensor_rate(
+        _In_ const std::size_t index) const {
+    auto& impl = this->check_not_disposed();
+    return impl.rate(impl.sensors.at(index).second);
+}
+
+
+/*
+ * visus::power_overwhelming::collector_statistics::sensor_samples
+ */
+std::uint64_t visus::power_overwhelming::collector_statistics::sensor_samples(
+        _In_ const std::size_t index) const {
+    return this->check_not_disposed().sensors.at(index).second;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_statistics::sensors
+ */
+std::size_t visus::power_overwhelming::collector_statistics::sensors(
+        void) const {
+    return this->check_not_disposed().sensors.size();
+}
+
+
+/*
+ * visus::power_overwhelming::collector_statistics::operator =
+ */
+visus::power_overwhelming::collector_statistics&
+visus::power_overwhelming::collector_statistics::operator =(
+        _In_ const collector_statistics& rhs) {
+    if (this != std::addressof(rhs)) {
+        const auto& impl = rhs.check_not_disposed();
+        if (this->_impl == nullptr) {
+            this->_impl = new detail::collector_statistics_impl(impl);
+        } else {
+            *this->_impl = impl;
+        }
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_statistics::operator =
+ */
+visus::power_overwhelming::collector_statistics&
+visus::power_overwhelming::collector_statistics::operator =(
+        _Inout_ collector_statistics&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_statistics::operator bool
+ */
+visus::power_overwhelming::collector_statistics::operator bool(
+        void) const noexcept {
+    return (this->_impl != nullptr);
+}
+
+
+/*
+ * visus::power_overwhelming::collector_statistics::check_not_disposed
+ */
+const visus::power_overwhelming::detail::collector_statistics_impl&
+visus::power_overwhelming::collector_statistics::check_not_disposed(
+        void) const {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("Collector statistics which have been "
+            "disposed by a move operation cannot be used anymore.");
+    }
+
+    return *this->_impl;
+}
@@ -0,0 +1,104 @@
+﻿// <copyright file="collector_statistics_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "power_overwhelming/latency_histogram.h"
+#include "power_overwhelming/sensor.h"
+
+#include "phase_quantiles.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The snapshot of the pipeline of a collector.
+    /// </summary>
+    struct POWER_OVERWHELMING_API collector_statistics_impl final {
+
+        /// <summary>
+        /// The type of the number of samples retrieved from a single sensor.
+        /// </summary>
+        typedef std::pair<std::wstring, std::uint64_t> sensor_type;
+
+        /// <summary>
+        /// The number of samples waiting in the buffers.
+        /// </summary>
+        std::uint64_t backlog;
+
+        /// <summary>
+        /// The size of the samples waiting in the buffers in bytes.
+        /// </summary>
+        std::uint64_t backlog_bytes;
+
+        /// <summary>
+        /// The number of bytes written to the output.
+        /// </summary>
+        std::uint64_t bytes_written;
+
+        /// <summary>
+        /// The number of samples that have been dropped.
+        /// </summary>
+        std::uint64_t dropped;
+
+        /// <summary>
+        /// The time the I/O thread has been running in microseconds.
+        /// </summary>
+        sensor::microseconds_type elapsed;
+
+        /// <summary>
+        /// The time flushing the output took.
+        /// </summary>
+        latency_histogram flush_duration;
+
+        /// <summary>
+        /// The number of marker events written.
+        /// </summary>
+        std::uint64_t marker_events;
+
+        /// <summary>
+        /// The quantiles of the power per sensor and marker, which are only
+        /// available if the collector tracks them.
+        /// </summary>
+        std::vector<phase_quantiles> quantiles;
+
+        /// <summary>
+        /// The number of samples retrieved from all sensors.
+        /// </summary>
+        std::uint64_t samples;
+
+        /// <summary>
+        /// The number of samples retrieved per sensor.
+        /// </summary>
+        std::vector<sensor_type> sensors;
+
+        /// <summary>
+        /// Answer the rate of <paramref name="samples" /> over the
+        /// <see cref="elapsed" /> time.
+        /// </summary>
+        inline double rate(_In_ const std::uint64_t samples) const noexcept {
+            return (this->elapsed > 0)
+                ? (samples * 1000000.0 / this->elapsed)
+                : 0.0;
+        }
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        inline collector_statistics_impl(void) : backlog(0), backlog_bytes(0),
+            bytes_written(0), dropped(0), elapsed(0), marker_events(0),
+            samples(0) { }
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
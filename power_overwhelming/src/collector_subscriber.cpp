@@ -0,0 +1,181 @@
+﻿// <copyright file="collector_subscriber.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/collector_subscriber.h"
+
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+
+#include "collector_subscriber_impl.h"
+
+
+/*
+ * visus::power_overwhelming::collector_subscriber::~collector_subscriber
+ */
+visus::power_overwhelming::collector_subscriber::~collector_subscriber(
+        void) {
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_subscriber::available
+ */
+std::uint64_t visus::power_overwhelming::collector_subscriber::available(
+        void) const noexcept {
+    return (this->_impl != nullptr)
+        ? this->_impl->ring->head() - this->_impl->cursor
+        : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_subscriber::cancel
+ */
+bool visus::power_overwhelming::collector_subscriber::cancel(void) noexcept {
+    return (this->_impl != nullptr)
+        ? this->_impl->ring->cancel(this->_impl)
+        : false;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_subscriber::lost
+ */
+std::uint64_t visus::power_overwhelming::collector_subscriber::lost(
+        void) const noexcept {
+    return (this->_impl != nullptr) ? this->_impl->lost : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_subscriber::notify
+ */
+bool visus::power_overwhelming::collector_subscriber::notify(
+        _In_ const notification_callback callback,
+        _In_opt_ void *context) {
+    if (callback == nullptr) {
+        throw std::invalid_argument("The notification callback of a "
+            "subscriber must not be null.");
+    }
+    if (this->_impl == nullptr) {
+        return false;
+    }
+
+    // Replace any pending notification, because only one is supported.
+    this->_impl->ring->cancel(this->_impl);
+    return this->_impl->ring->notify(this->_impl->cursor, callback, context,
+        this->_impl);
+}
+
+
+/*
+ * visus::power_overwhelming::collector_subscriber::overflow
+ */
+visus::power_overwhelming::subscriber_overflow
+visus::power_overwhelming::collector_subscriber::overflow(
+        void) const noexcept {
+    return (this->_impl != nullptr)
+        ? this->_impl->policy
+        : subscriber_overflow::drop_oldest;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_subscriber::read
+ */
+std::size_t visus::power_overwhelming::collector_subscriber::read(
+        _Out_writes_(cnt) measurement_data *samples,
+        _Out_writes_opt_(cnt) const wchar_t **sensors,
+        _In_ const std::size_t cnt) noexcept {
+    if ((this->_impl == nullptr) || (samples == nullptr)) {
+        return 0;
+    }
+
+    return this->_impl->ring->read(this->_impl->cursor, this->_impl->policy,
+        this->_impl->lost, sensors, samples, cnt);
+}
+
+
+/*
+ * visus::power_overwhelming::collector_subscriber::read
+ */
+std::size_t visus::power_overwhelming::collector_subscriber::read(
+        _In_ const measurement_data_callback callback,
+        _In_opt_ void *context) {
+    if (callback == nullptr) {
+        throw std::invalid_argument("The callback receiving the samples of a "
+            "subscriber must not be null.");
+    }
+    if (this->_impl == nullptr) {
+        return 0;
+    }
+
+    auto& samples = this->_impl->samples;
+    auto& sensors = this->_impl->sensors;
+    std::size_t retval = 0;
+
+    while (true) {
+        const auto cnt = this->read(samples.data(), sensors.data(),
+            samples.size());
+        if (cnt == 0) {
+            break;
+        }
+
+        // Pass each run of samples from the same sensor as one batch.
+        std::size_t begin = 0;
+        for (std::size_t i = 1; i <= cnt; ++i) {
+            if ((i == cnt) || (sensors[i] != sensors[begin])) {
+                callback(sensors[begin], samples.data() + begin, i - begin,
+                    context);
+                begin = i;
+            }
+        }
+
+        retval += cnt;
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_subscriber::wait
+ */
+bool visus::power_overwhelming::collector_subscriber::wait(
+        _In_ const std::uint32_t timeout) {
+    if (this->_impl == nullptr) {
+        return false;
+    }
+
+    return this->_impl->ring->wait(this->_impl->cursor,
+        std::chrono::milliseconds(timeout));
+}
+
+
+/*
+ * visus::power_overwhelming::collector_subscriber::operator =
+ */
+visus::power_overwhelming::collector_subscriber&
+visus::power_overwhelming::collector_subscriber::operator =(
+        _Inout_ collector_subscriber&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_subscriber::operator bool
+ */
+visus::power_overwhelming::collector_subscriber::operator bool(
+        void) const noexcept {
+    return (this->_impl != nullptr);
+}
@@ -0,0 +1,39 @@
+﻿// <copyright file="collector_subscriber_impl.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "collector_subscriber_impl.h"
+
+#include <cassert>
+
+
+/*
+ * visus::power_overwhelming::detail::collector_subscriber_impl::batch_size
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::collector_subscriber_impl::batch_size;
+
+
+/*
+ * ...::detail::collector_subscriber_impl::collector_subscriber_impl
+ */
+visus::power_overwhelming::detail::collector_subscriber_impl
+::collector_subscriber_impl(const std::shared_ptr<subscriber_ring>& ring,
+        const subscriber_overflow policy)
+        : cursor(0), lost(0), policy(policy), ring(ring),
+        samples(batch_size, measurement_data(0, 0.0f)),
+        sensors(batch_size, nullptr) {
+    assert(this->ring != nullptr);
+    this->cursor = this->ring->attach();
+}
+
+
+/*
+ * ...::detail::collector_subscriber_impl::~collector_subscriber_impl
+ */
+visus::power_overwhelming::detail::collector_subscriber_impl
+::~collector_subscriber_impl(void) {
+    this->ring->cancel(this);
+    this->ring->detach();
+}
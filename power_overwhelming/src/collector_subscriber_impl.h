@@ -0,0 +1,87 @@
+﻿// <copyright file="collector_subscriber_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "power_overwhelming/collector_subscriber.h"
+
+#include "subscriber_ring.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Private data container for <see cref="collector_subscriber" />.
+    /// </summary>
+    struct collector_subscriber_impl final {
+
+        /// <summary>
+        /// The number of samples read from the <see cref="ring" /> at once if
+        /// the samples are passed to a callback.
+        /// </summary>
+        static constexpr std::size_t batch_size = 256;
+
+        /// <summary>
+        /// The position of the next sample to be read from the
+        /// <see cref="ring" />.
+        /// </summary>
+        subscriber_ring::position_type cursor;
+
+        /// <summary>
+        /// The number of samples that have been overwritten before they could
+        /// be read.
+        /// </summary>
+        std::uint64_t lost;
+
+        /// <summary>
+        /// Determines where the subscriber continues if it has fallen behind.
+        /// </summary>
+        subscriber_overflow policy;
+
+        /// <summary>
+        /// The ring shared with the collector, which keeps it alive even if
+        /// the collector is destroyed first.
+        /// </summary>
+        std::shared_ptr<subscriber_ring> ring;
+
+        /// <summary>
+        /// The buffer for the samples passed to a callback, which is
+        /// allocated on construction.
+        /// </summary>
+        std::vector<measurement_data> samples;
+
+        /// <summary>
+        /// The buffer for the names of the sensors of the
+        /// <see cref="samples" />.
+        /// </summary>
+        std::vector<const wchar_t *> sensors;
+
+        /// <summary>
+        /// Initialises a new instance and registers it with the given ring.
+        /// </summary>
+        /// <param name="ring">The ring to read from.</param>
+        /// <param name="policy">The overflow policy of the subscriber.</param>
+        collector_subscriber_impl(const std::shared_ptr<subscriber_ring>& ring,
+            const subscriber_overflow policy);
+
+        collector_subscriber_impl(const collector_subscriber_impl&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~collector_subscriber_impl(void);
+
+        collector_subscriber_impl& operator =(
+            const collector_subscriber_impl&) = delete;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,344 @@
+﻿// <copyright file="column_codec.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "column_codec.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif /* defined(_MSC_VER) */
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Appends bits to a byte vector, most significant bit first.
+    /// </summary>
+    class bit_writer final {
+
+    public:
+
+        inline explicit bit_writer(_Inout_ std::vector<std::uint8_t>& dst)
+            : _bits(0), _dst(dst), _value(0) { }
+
+        inline ~bit_writer(void) {
+            if (this->_bits > 0) {
+                this->_dst.push_back(static_cast<std::uint8_t>(
+                    this->_value << (8 - this->_bits)));
+            }
+        }
+
+        inline void write(_In_ const std::uint64_t value,
+                _In_ const unsigned int bits) {
+            assert(bits <= 64);
+            auto remaining = bits;
+
+            // Fill the current byte with as many bits as possible at once.
+            while (remaining > 0) {
+                const auto n = (std::min)(8 - this->_bits, remaining);
+                const auto chunk = static_cast<unsigned int>(
+                    (value >> (remaining - n)) & ((1u << n) - 1));
+                this->_value = (this->_value << n) | chunk;
+                this->_bits += n;
+                remaining -= n;
+
+                if (this->_bits == 8) {
+                    this->_dst.push_back(static_cast<std::uint8_t>(
+                        this->_value));
+                    this->_bits = 0;
+                    this->_value = 0;
+                }
+            }
+        }
+
+    private:
+
+        unsigned int _bits;
+        std::vector<std::uint8_t>& _dst;
+        unsigned int _value;
+    };
+
+
+    /// <summary>
+    /// Reads bits from a byte array, most significant bit first.
+    /// </summary>
+    class bit_reader final {
+
+    public:
+
+        inline bit_reader(_In_reads_(size) const std::uint8_t *src,
+                _In_ const std::size_t size)
+            : _position(0), _size(size * 8), _src(src) { }
+
+        inline std::uint64_t read(_In_ const unsigned int bits) {
+            assert(bits <= 64);
+            if (this->_position + bits > this->_size) {
+                throw std::runtime_error("The encoded column ended "
+                    "prematurely.");
+            }
+
+            std::uint64_t retval = 0;
+            auto remaining = bits;
+
+            // Consume the rest of the current byte at once.
+            while (remaining > 0) {
+                const auto offset = static_cast<unsigned int>(
+                    this->_position % 8);
+                const auto n = (std::min)(8 - offset, remaining);
+                const auto b = this->_src[this->_position / 8];
+                const auto chunk = (b >> (8 - offset - n)) & ((1u << n) - 1);
+                retval = (retval << n) | chunk;
+                this->_position += n;
+                remaining -= n;
+            }
+
+            return retval;
+        }
+
+    private:
+
+        std::size_t _position;
+        std::size_t _size;
+        const std::uint8_t *_src;
+    };
+
+
+    /// <summary>
+    /// Answer the number of leading zeros of a non-zero word.
+    /// </summary>
+    static inline unsigned int leading_zeros(_In_ const std::uint32_t value) {
+        assert(value != 0);
+#if defined(_MSC_VER)
+        unsigned long retval;
+        ::_BitScanReverse(&retval, value);
+        return 31 - retval;
+#else /* defined(_MSC_VER) */
+        return ::__builtin_clz(value);
+#endif /* defined(_MSC_VER) */
+    }
+
+    /// <summary>
+    /// Answer the number of trailing zeros of a non-zero word.
+    /// </summary>
+    static inline unsigned int trailing_zeros(_In_ const std::uint32_t value) {
+        assert(value != 0);
+#if defined(_MSC_VER)
+        unsigned long retval;
+        ::_BitScanForward(&retval, value);
+        return retval;
+#else /* defined(_MSC_VER) */
+        return ::__builtin_ctz(value);
+#endif /* defined(_MSC_VER) */
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::encode_timestamps
+ */
+void visus::power_overwhelming::detail::encode_timestamps(
+        _Inout_ std::vector<std::uint8_t>& dst,
+        _In_reads_(cnt) const std::int64_t *src,
+        _In_ const std::size_t cnt) {
+    assert((src != nullptr) || (cnt == 0));
+    bit_writer writer(dst);
+    std::uint64_t delta = 0;
+
+    for (std::size_t i = 0; i < cnt; ++i) {
+        if (i == 0) {
+            writer.write(static_cast<std::uint64_t>(src[i]), 64);
+            continue;
+        }
+
+        // Compute in the unsigned domain, where overflows are well-defined.
+        const auto d = static_cast<std::uint64_t>(src[i])
+            - static_cast<std::uint64_t>(src[i - 1]);
+        const auto dod = d - delta;
+        const auto zigzag = (dod << 1) ^ (0 - (dod >> 63));
+        delta = d;
+
+        if (zigzag == 0) {
+            writer.write(0, 1);
+        } else if (zigzag < (std::uint64_t(1) << 8)) {
+            writer.write(0x2, 2);
+            writer.write(zigzag, 8);
+        } else if (zigzag < (std::uint64_t(1) << 16)) {
+            writer.write(0x6, 3);
+            writer.write(zigzag, 16);
+        } else if (zigzag < (std::uint64_t(1) << 32)) {
+            writer.write(0xE, 4);
+            writer.write(zigzag, 32);
+        } else {
+            writer.write(0xF, 4);
+            writer.write(zigzag, 64);
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::decode_timestamps
+ */
+void visus::power_overwhelming::detail::decode_timestamps(
+        _Out_writes_(cnt) std::int64_t *dst,
+        _In_ const std::size_t cnt,
+        _In_reads_(size) const std::uint8_t *src,
+        _In_ const std::size_t size) {
+    assert((dst != nullptr) || (cnt == 0));
+    bit_reader reader(src, size);
+    std::uint64_t delta = 0;
+    std::uint64_t value = 0;
+
+    for (std::size_t i = 0; i < cnt; ++i) {
+        if (i == 0) {
+            value = reader.read(64);
+
+        } else {
+            std::uint64_t zigzag = 0;
+
+            if (reader.read(1) != 0) {
+                if (reader.read(1) == 0) {
+                    zigzag = reader.read(8);
+                } else if (reader.read(1) == 0) {
+                    zigzag = reader.read(16);
+                } else if (reader.read(1) == 0) {
+                    zigzag = reader.read(32);
+                } else {
+                    zigzag = reader.read(64);
+                }
+            }
+
+            const auto dod = (zigzag >> 1) ^ (0 - (zigzag & 1));
+            delta += dod;
+            value += delta;
+        }
+
+        dst[i] = static_cast<std::int64_t>(value);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::encode_xor
+ */
+void visus::power_overwhelming::detail::encode_xor(
+        _Inout_ std::vector<std::uint8_t>& dst,
+        _In_reads_(cnt) const std::uint32_t *src,
+        _In_ const std::size_t cnt) {
+    assert((src != nullptr) || (cnt == 0));
+    unsigned int leading = 0;
+    std::uint32_t previous = 0;
+    unsigned int trailing = 0;
+    bit_writer writer(dst);
+    auto window = false;
+
+    for (std::size_t i = 0; i < cnt; ++i) {
+        const auto x = src[i] ^ previous;
+        previous = src[i];
+
+        if (x == 0) {
+            writer.write(0, 1);
+            continue;
+        }
+
+        writer.write(1, 1);
+        const auto lz = leading_zeros(x);
+        const auto tz = trailing_zeros(x);
+
+        if (window && (lz >= leading) && (tz >= trailing)) {
+            writer.write(0, 1);
+            writer.write(x >> trailing, 32 - leading - trailing);
+
+        } else {
+            const auto len = 32 - lz - tz;
+            writer.write(1, 1);
+            writer.write(lz, 5);
+            writer.write(len - 1, 5);
+            writer.write(x >> tz, len);
+
+            leading = lz;
+            trailing = tz;
+            window = true;
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::encode_xor
+ */
+void visus::power_overwhelming::detail::encode_xor(
+        _Inout_ std::vector<std::uint8_t>& dst,
+        _In_reads_(cnt) const float *src,
+        _In_ const std::size_t cnt) {
+    static_assert(sizeof(float) == sizeof(std::uint32_t), "The XOR encoding "
+        "of floating-point numbers requires them to be 32 bits wide.");
+    std::vector<std::uint32_t> words(cnt);
+    if (cnt > 0) {
+        ::memcpy(words.data(), src, cnt * sizeof(float));
+    }
+    encode_xor(dst, words.data(), words.size());
+}
+
+
+/*
+ * visus::power_overwhelming::detail::decode_xor
+ */
+void visus::power_overwhelming::detail::decode_xor(
+        _Out_writes_(cnt) std::uint32_t *dst,
+        _In_ const std::size_t cnt,
+        _In_reads_(size) const std::uint8_t *src,
+        _In_ const std::size_t size) {
+    assert((dst != nullptr) || (cnt == 0));
+    unsigned int leading = 0;
+    std::uint32_t previous = 0;
+    bit_reader reader(src, size);
+    unsigned int trailing = 0;
+
+    for (std::size_t i = 0; i < cnt; ++i) {
+        if (reader.read(1) != 0) {
+            if (reader.read(1) != 0) {
+                leading = static_cast<unsigned int>(reader.read(5));
+                const auto len = static_cast<unsigned int>(reader.read(5)) + 1;
+                if (leading + len > 32) {
+                    throw std::runtime_error("The encoded column is "
+                        "corrupt.");
+                }
+                trailing = 32 - leading - len;
+            }
+
+            const auto len = 32 - leading - trailing;
+            previous ^= static_cast<std::uint32_t>(reader.read(len))
+                << trailing;
+        }
+
+        dst[i] = previous;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::decode_xor
+ */
+void visus::power_overwhelming::detail::decode_xor(
+        _Out_writes_(cnt) float *dst,
+        _In_ const std::size_t cnt,
+        _In_reads_(size) const std::uint8_t *src,
+        _In_ const std::size_t size) {
+    std::vector<std::uint32_t> words(cnt);
+    decode_xor(words.data(), words.size(), src, size);
+    if (cnt > 0) {
+        ::memcpy(dst, words.data(), cnt * sizeof(float));
+    }
+}
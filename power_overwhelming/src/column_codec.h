@@ -0,0 +1,137 @@
+﻿// <copyright file="column_codec.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <vector>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Encodes a column of timestamps as the deltas of their deltas.
+    /// </summary>
+    /// <remarks>
+    /// <para>The encoding follows the timestamp compression of Facebook's
+    /// Gorilla, but with buckets suitable for sub-second clocks: The first
+    /// value is stored with 64 bits. For each subsequent value, the
+    /// difference between its delta and the delta of its predecessor is
+    /// stored zig-zag encoded as a single zero bit if it is zero, or with the
+    /// prefixes <c>10</c>, <c>110</c>, <c>1110</c> and <c>1111</c> followed by
+    /// 8, 16, 32 or 64 bits, respectively.</para>
+    /// <para>Samples at a regular interval therefore only need a single bit
+    /// per timestamp.</para>
+    /// </remarks>
+    /// <param name="dst">Receives the encoded bytes, which are appended.
+    /// </param>
+    /// <param name="src">The timestamps to be encoded.</param>
+    /// <param name="cnt">The number of timestamps in <paramref name="src" />.
+    /// </param>
+    void POWER_OVERWHELMING_API encode_timestamps(
+        _Inout_ std::vector<std::uint8_t>& dst,
+        _In_reads_(cnt) const std::int64_t *src,
+        _In_ const std::size_t cnt);
+
+    /// <summary>
+    /// Decodes a column of timestamps encoded with
+    /// <see cref="encode_timestamps" />.
+    /// </summary>
+    /// <param name="dst">Receives <paramref name="cnt" /> timestamps.</param>
+    /// <param name="cnt">The number of timestamps to be decoded.</param>
+    /// <param name="src">The encoded bytes.</param>
+    /// <param name="size">The number of bytes in <paramref name="src" />.
+    /// </param>
+    /// <exception cref="std::runtime_error">If the encoded data end before
+    /// all timestamps have been decoded.</exception>
+    void POWER_OVERWHELMING_API decode_timestamps(
+        _Out_writes_(cnt) std::int64_t *dst,
+        _In_ const std::size_t cnt,
+        _In_reads_(size) const std::uint8_t *src,
+        _In_ const std::size_t size);
+
+    /// <summary>
+    /// Encodes a column of 32-bit words by XOR'ing each of them with its
+    /// predecessor.
+    /// </summary>
+    /// <remarks>
+    /// <para>This is the value compression of Facebook's Gorilla for 32-bit
+    /// values: If a word is the same as its predecessor, a single zero bit is
+    /// stored. Otherwise, the bit one is followed by the meaningful bits of
+    /// the XOR, i.e. the bits between the leading and the trailing zeros.
+    /// If these fit into the window of the last XOR, a zero bit and the bits
+    /// in the window are stored. Otherwise, a one bit, the number of leading
+    /// zeros as five bits, the number of meaningful bits minus one as five
+    /// bits and the meaningful bits are stored.</para>
+    /// <para>Slowly varying floating-point numbers share their sign, their
+    /// exponent and the upper bits of their mantissa, wherefore the XOR of
+    /// their representations has many leading zeros. Marker IDs rarely change
+    /// and only need a single bit per sample.</para>
+    /// </remarks>
+    /// <param name="dst">Receives the encoded bytes, which are appended.
+    /// </param>
+    /// <param name="src">The words to be encoded.</param>
+    /// <param name="cnt">The number of words in <paramref name="src" />.
+    /// </param>
+    void POWER_OVERWHELMING_API encode_xor(
+        _Inout_ std::vector<std::uint8_t>& dst,
+        _In_reads_(cnt) const std::uint32_t *src,
+        _In_ const std::size_t cnt);
+
+    /// <summary>
+    /// Encodes a column of floating-point numbers with
+    /// <see cref="encode_xor" />.
+    /// </summary>
+    /// <param name="dst">Receives the encoded bytes, which are appended.
+    /// </param>
+    /// <param name="src">The numbers to be encoded.</param>
+    /// <param name="cnt">The number of numbers in <paramref name="src" />.
+    /// </param>
+    void POWER_OVERWHELMING_API encode_xor(
+        _Inout_ std::vector<std::uint8_t>& dst,
+        _In_reads_(cnt) const float *src,
+        _In_ const std::size_t cnt);
+
+    /// <summary>
+    /// Decodes a column of 32-bit words encoded with
+    /// <see cref="encode_xor" />.
+    /// </summary>
+    /// <param name="dst">Receives <paramref name="cnt" /> words.</param>
+    /// <param name="cnt">The number of words to be decoded.</param>
+    /// <param name="src">The encoded bytes.</param>
+    /// <param name="size">The number of bytes in <paramref name="src" />.
+    /// </param>
+    /// <exception cref="std::runtime_error">If the encoded data end before
+    /// all words have been decoded.</exception>
+    void POWER_OVERWHELMING_API decode_xor(
+        _Out_writes_(cnt) std::uint32_t *dst,
+        _In_ const std::size_t cnt,
+        _In_reads_(size) const std::uint8_t *src,
+        _In_ const std::size_t size);
+
+    /// <summary>
+    /// Decodes a column of floating-point numbers encoded with
+    /// <see cref="encode_xor" />.
+    /// </summary>
+    /// <param name="dst">Receives <paramref name="cnt" /> numbers.</param>
+    /// <param name="cnt">The number of numbers to be decoded.</param>
+    /// <param name="src">The encoded bytes.</param>
+    /// <param name="size">The number of bytes in <paramref name="src" />.
+    /// </param>
+    /// <exception cref="std::runtime_error">If the encoded data end before
+    /// all numbers have been decoded.</exception>
+    void POWER_OVERWHELMING_API decode_xor(
+        _Out_writes_(cnt) float *dst,
+        _In_ const std::size_t cnt,
+        _In_reads_(size) const std::uint8_t *src,
+        _In_ const std::size_t size);
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
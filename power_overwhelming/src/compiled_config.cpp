@@ -0,0 +1,331 @@
+﻿// <copyright file="compiled_config.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "compiled_config.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include "power_overwhelming/convert_string.h"
+
+#include "sensor_desc.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    static constexpr const char *compiled_field_config = "config";
+    static constexpr const char *compiled_field_desc = "desc";
+    static constexpr const char *compiled_field_name = "name";
+    static constexpr const char *compiled_field_sensors = "sensors";
+    static constexpr const char *compiled_field_type = "type";
+
+    /// <summary>
+    /// The magic number at the begin of every cache file.
+    /// </summary>
+    static constexpr char compiled_magic[] = { 'P', 'O', 'C', 'C' };
+
+    /// <summary>
+    /// Creates the sensor of the type at position <paramref name="type" />
+    /// in the type list from <paramref name="desc" />.
+    /// </summary>
+    template<class TSensor, class... TSensors>
+    std::unique_ptr<sensor> compiled_create(_In_ const std::size_t type,
+            _In_ const nlohmann::json& desc,
+            sensor_list_type<TSensor, TSensors ...>) {
+        if (type > 0) {
+            return compiled_create(type - 1, desc,
+                sensor_list_type<TSensors ...>());
+        }
+
+        if (!sensor_desc<TSensor>::describes(desc)) {
+            throw std::invalid_argument("The compiled type of the sensor does "
+                "not match its descriptor.");
+        }
+
+        return std::unique_ptr<sensor>(new TSensor(
+            sensor_desc<TSensor>::deserialise(desc)));
+    }
+
+    /// <summary>
+    /// Recursion stop for <see cref="compiled_create" />.
+    /// </summary>
+    inline std::unique_ptr<sensor> compiled_create(_In_ const std::size_t type,
+            _In_ const nlohmann::json& desc,
+            sensor_list_type<>) {
+        throw std::invalid_argument("The compiled type of the sensor is not "
+            "known.");
+    }
+
+    /// <summary>
+    /// Creates the sensor described by <paramref name="desc" /> and answers
+    /// the position of its type in the type list.
+    /// </summary>
+    template<class TSensor, class... TSensors>
+    std::unique_ptr<sensor> compiled_parse(_Inout_ std::size_t& type,
+            _In_ const nlohmann::json& desc,
+            sensor_list_type<TSensor, TSensors ...>) {
+        if (sensor_desc<TSensor>::describes(desc)) {
+            return std::unique_ptr<sensor>(new TSensor(
+                sensor_desc<TSensor>::deserialise(desc)));
+
+        } else {
+            ++type;
+            return compiled_parse(type, desc, sensor_list_type<TSensors ...>());
+        }
+    }
+
+    /// <summary>
+    /// Recursion stop for <see cref="compiled_parse" />.
+    /// </summary>
+    inline std::unique_ptr<sensor> compiled_parse(_Inout_ std::size_t& type,
+            _In_ const nlohmann::json& desc,
+            sensor_list_type<>) {
+        throw std::invalid_argument("An unknown type of sensor was specified.");
+    }
+
+    /// <summary>
+    /// Creates the sensor described by <paramref name="desc" /> in
+    /// <paramref name="dst" /> and answers its entry in the cache.
+    /// </summary>
+    static nlohmann::json compile_sensor(_Out_ std::unique_ptr<sensor>& dst,
+            _In_ const nlohmann::json& desc) {
+        std::size_t type = 0;
+        dst = compiled_parse(type, desc, sensor_list());
+        auto name = power_overwhelming::convert_string<char>(dst->name());
+
+        return nlohmann::json::object({
+            { compiled_field_type, type },
+            { compiled_field_name, name },
+            { compiled_field_desc, desc }
+        });
+    }
+
+    /// <summary>
+    /// Opens <paramref name="stream" /> for the given wide-character path.
+    /// </summary>
+    template<class TStream>
+    void open_stream(_In_ TStream& stream, _In_ const std::wstring& path,
+            _In_ const std::ios_base::openmode mode) {
+#if defined(_WIN32)
+        stream.open(path, mode);
+#else /* defined(_WIN32) */
+        auto p = power_overwhelming::convert_string<char>(path.c_str());
+        stream.open(p, mode);
+#endif /* defined(_WIN32) */
+    }
+
+    /// <summary>
+    /// Reads the cache at <paramref name="path" /> if it exists and has been
+    /// compiled from a source with the given hash.
+    /// </summary>
+    static bool read_cache(_Out_ nlohmann::json& dst,
+            _In_ const std::wstring& path,
+            _In_ const compiled_config::hash_type hash) noexcept {
+        try {
+            std::ifstream s;
+            open_stream(s, path, std::ios::in | std::ios::binary);
+            if (!s) {
+                return false;
+            }
+
+            char magic[sizeof(compiled_magic)];
+            std::uint32_t version;
+            compiled_config::hash_type source;
+            std::uint64_t size;
+            s.read(magic, sizeof(magic));
+            s.read(reinterpret_cast<char *>(&version), sizeof(version));
+            s.read(reinterpret_cast<char *>(&source), sizeof(source));
+            s.read(reinterpret_cast<char *>(&size), sizeof(size));
+
+            if (!s
+                    || (::memcmp(magic, compiled_magic, sizeof(magic)) != 0)
+                    || (version != compiled_config::version)
+                    || (source != hash)) {
+                return false;
+            }
+
+            std::vector<std::uint8_t> payload(static_cast<std::size_t>(size));
+            s.read(reinterpret_cast<char *>(payload.data()), payload.size());
+            if (!s) {
+                return false;
+            }
+
+            dst = nlohmann::json::from_cbor(payload);
+            return dst.is_object()
+                && dst.contains(compiled_field_config)
+                && dst[compiled_field_sensors].is_array();
+        } catch (...) {
+            return false;
+        }
+    }
+
+    /// <summary>
+    /// Reads the whole text of the configuration file at
+    /// <paramref name="path" />.
+    /// </summary>
+    static std::string read_source(_In_ const std::wstring& path) {
+        std::ifstream s;
+        s.exceptions(s.exceptions() | std::ios::failbit | std::ios::badbit);
+        open_stream(s, path, std::ios::in | std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(s),
+            std::istreambuf_iterator<char>());
+    }
+
+    /// <summary>
+    /// Writes <paramref name="compiled" /> as cache for the source with the
+    /// given hash to <paramref name="path" />.
+    /// </summary>
+    static void write_cache(_In_ const std::wstring& path,
+            _In_ const compiled_config::hash_type hash,
+            _In_ const nlohmann::json& compiled) noexcept {
+        try {
+            const auto payload = nlohmann::json::to_cbor(compiled);
+            const std::uint32_t version = compiled_config::version;
+            const std::uint64_t size = payload.size();
+
+            std::ofstream s;
+            open_stream(s, path, std::ios::out | std::ios::binary
+                | std::ios::trunc);
+            s.write(compiled_magic, sizeof(compiled_magic));
+            s.write(reinterpret_cast<const char *>(&version), sizeof(version));
+            s.write(reinterpret_cast<const char *>(&hash), sizeof(hash));
+            s.write(reinterpret_cast<const char *>(&size), sizeof(size));
+            s.write(reinterpret_cast<const char *>(payload.data()),
+                payload.size());
+        } catch (...) { /* The cache is optional, so ignore any error. */ }
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::compiled_config::extension
+ */
+constexpr const wchar_t *
+visus::power_overwhelming::detail::compiled_config::extension;
+
+
+/*
+ * visus::power_overwhelming::detail::compiled_config::version
+ */
+constexpr std::uint32_t
+visus::power_overwhelming::detail::compiled_config::version;
+
+
+/*
+ * visus::power_overwhelming::detail::compiled_config::hash
+ */
+visus::power_overwhelming::detail::compiled_config::hash_type
+visus::power_overwhelming::detail::compiled_config::hash(
+        _In_ const std::string& source) noexcept {
+    hash_type retval = 0xcbf29ce484222325ull;
+
+    for (auto c : source) {
+        retval ^= static_cast<std::uint8_t>(c);
+        retval *= 0x100000001b3ull;
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::compiled_config::load
+ */
+std::vector<std::unique_ptr<visus::power_overwhelming::sensor>>
+visus::power_overwhelming::detail::compiled_config::load(
+        _Out_ nlohmann::json& config,
+        _In_z_ const wchar_t *path,
+        _In_z_ const char *sensors) {
+    if (path == nullptr) {
+        throw std::invalid_argument("The path to the configuration file must "
+            "not be null.");
+    }
+    if (sensors == nullptr) {
+        throw std::invalid_argument("The name of the sensor field must not be "
+            "null.");
+    }
+
+    const auto source = read_source(path);
+    const auto hash = compiled_config::hash(source);
+    const auto cache_path = std::wstring(path) + extension;
+    nlohmann::json compiled;
+    std::vector<std::unique_ptr<sensor>> retval;
+
+    if (read_cache(compiled, cache_path, hash)) {
+        // The source is only parsed if any of the sensors cannot be restored
+        // from the cache.
+        nlohmann::json parsed;
+        auto stale = false;
+
+        config = compiled[compiled_field_config];
+        auto& entries = compiled[compiled_field_sensors];
+        retval.reserve(entries.size());
+
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            auto& entry = entries[i];
+
+            try {
+                auto s = compiled_create(
+                    entry[compiled_field_type].get<std::size_t>(),
+                    entry[compiled_field_desc],
+                    sensor_list());
+                auto name = power_overwhelming::convert_string<char>(s->name());
+
+                if (entry[compiled_field_name].get<std::string>() == name) {
+                    retval.push_back(std::move(s));
+                    continue;
+                }
+            } catch (...) { /* Fall back to the source below. */ }
+
+            if (parsed.is_null()) {
+                parsed = nlohmann::json::parse(source);
+            }
+
+            const auto& descs = parsed[sensors];
+            retval.emplace_back();
+            entry = compile_sensor(retval.back(),
+                descs.is_array() ? descs.at(i) : descs);
+            stale = true;
+        }
+
+        if (stale) {
+            write_cache(cache_path, hash, compiled);
+        }
+
+    } else {
+        auto entries = nlohmann::json::array();
+        config = nlohmann::json::parse(source);
+
+        auto it = config.find(sensors);
+        if (it != config.end()) {
+            if (it->is_array()) {
+                retval.reserve(it->size());
+                for (auto& d : *it) {
+                    retval.emplace_back();
+                    entries.push_back(compile_sensor(retval.back(), d));
+                }
+
+            } else if (it->is_object()) {
+                retval.emplace_back();
+                entries.push_back(compile_sensor(retval.back(), *it));
+            }
+
+            config.erase(it);
+        }
+
+        compiled[compiled_field_config] = config;
+        compiled[compiled_field_sensors] = std::move(entries);
+        write_cache(cache_path, hash, compiled);
+    }
+
+    return retval;
+}
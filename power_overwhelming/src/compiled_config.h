@@ -0,0 +1,95 @@
+﻿// <copyright file="compiled_config.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "power_overwhelming/sensor.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Loads JSON configuration files through a binary cache of the already
+    /// parsed and validated sensor descriptors.
+    /// </summary>
+    /// <remarks>
+    /// <para>After a configuration file has been parsed successfully, the
+    /// settings and the descriptors of all sensors are written to a file with
+    /// the additional extension <see cref="extension" /> next to the JSON
+    /// file. The cache is stored as CBOR and tagged with the hash of the JSON
+    /// source and the index of the sensor type in <c>sensor_list</c>, such
+    /// that later runs neither need to parse the text nor to search the
+    /// matching <c>sensor_desc</c> for each sensor.</para>
+    /// <para>If the JSON source changes, the cache is discarded altogether.
+    /// If a sensor cannot be recreated from the cache or yields a different
+    /// name than when the cache was compiled, which indicates that the
+    /// hardware has changed, this sensor is parsed from the JSON source as
+    /// usual and the cache is updated.</para>
+    /// <para>The cache is an optimisation only, wherefore any error while
+    /// reading or writing it is ignored.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API compiled_config final {
+
+    public:
+
+        /// <summary>
+        /// The type of a hash of the JSON source.
+        /// </summary>
+        typedef std::uint64_t hash_type;
+
+        /// <summary>
+        /// The extension that is appended to the path of the JSON file to
+        /// obtain the path of the cache.
+        /// </summary>
+        static constexpr const wchar_t *extension = L".cache";
+
+        /// <summary>
+        /// The version of the cache format, which must be increased whenever
+        /// the layout or the list of sensor types changes.
+        /// </summary>
+        static constexpr std::uint32_t version = 7;
+
+        /// <summary>
+        /// Computes the FNV-1a hash of the given JSON source.
+        /// </summary>
+        /// <param name="source">The text of the configuration file.</param>
+        /// <returns>The hash of the text.</returns>
+        static hash_type hash(_In_ const std::string& source) noexcept;
+
+        /// <summary>
+        /// Loads the configuration file at <paramref name="path" />, using
+        /// and updating its cache if possible.
+        /// </summary>
+        /// <param name="config">Receives the configuration without the
+        /// sensors.</param>
+        /// <param name="path">The path to the JSON configuration file.</param>
+        /// <param name="sensors">The name of the field that holds the sensor
+        /// descriptors in the configuration.</param>
+        /// <returns>The sensors described in the configuration.</returns>
+        /// <exception cref="std::invalid_argument">If any of the parameters
+        /// is <c>nullptr</c> or if the configuration describes an unknown
+        /// type of sensor.</exception>
+        /// <exception cref="std::ios_base::failure">If the configuration
+        /// file could not be read.</exception>
+        static std::vector<std::unique_ptr<sensor>> load(
+            _Out_ nlohmann::json& config,
+            _In_z_ const wchar_t *path,
+            _In_z_ const char *sensors);
+
+        compiled_config(void) = delete;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
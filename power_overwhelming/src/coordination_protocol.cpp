@@ -0,0 +1,199 @@
+﻿// <copyright file="coordination_protocol.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "coordination_protocol.h"
+
+#include <chrono>
+#include <sstream>
+#include <system_error>
+#include <thread>
+
+#include "binary_output.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Receives exactly <paramref name="cnt" /> bytes.
+    /// </summary>
+    /// <returns><c>false</c> if the timeout elapsed before the first byte
+    /// and <paramref name="timeout" /> is <c>true</c>.</returns>
+    static bool coordination_receive_all(
+            _In_ const coordination_socket socket,
+            _Out_writes_bytes_(cnt) void *dst,
+            _In_ const std::size_t cnt,
+            _In_ const bool timeout) {
+        auto d = static_cast<char *>(dst);
+        std::size_t received = 0;
+
+        while (received < cnt) {
+            const auto n = ::recv(socket, d + received,
+                static_cast<int>(cnt - received), 0);
+            if (n == 0) {
+                throw std::runtime_error("The peer closed the coordination "
+                    "session.");
+            }
+
+            if (n == SOCKET_ERROR) {
+                const auto error = get_socket_error();
+#if defined(_WIN32)
+                const auto elapsed = (error == WSAETIMEDOUT);
+#else /* defined(_WIN32) */
+                const auto elapsed = (error == EAGAIN)
+                    || (error == EWOULDBLOCK);
+#endif /* defined(_WIN32) */
+                if (elapsed && timeout && (received == 0)) {
+                    return false;
+                }
+
+                // A timeout within a message means that the peer is stuck.
+                throw std::system_error(error, std::system_category());
+            }
+
+            received += static_cast<std::size_t>(n);
+        }
+
+        return true;
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::coordination_append
+ */
+void visus::power_overwhelming::detail::coordination_append(
+        _Inout_ std::vector<std::uint8_t>& dst,
+        _In_z_ const wchar_t *value) {
+    std::ostringstream stream;
+    write_binary_string(stream, value);
+    const auto str = stream.str();
+    dst.insert(dst.end(), str.begin(), str.end());
+}
+
+
+/*
+ * visus::power_overwhelming::detail::coordination_read_string
+ */
+std::wstring visus::power_overwhelming::detail::coordination_read_string(
+        _In_ const std::vector<std::uint8_t>& src,
+        _Inout_ std::size_t& offset) {
+    if (offset > src.size()) {
+        throw std::runtime_error("A coordination message is truncated.");
+    }
+
+    auto data = src.data() + offset;
+    auto retval = read_binary_string(data, src.data() + src.size());
+    offset = static_cast<std::size_t>(data - src.data());
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::coordination_receive
+ */
+bool visus::power_overwhelming::detail::coordination_receive(
+        _In_ const coordination_socket socket,
+        _Out_ coordination_message& type,
+        _Out_ std::vector<std::uint8_t>& payload) {
+    static_assert(sizeof(coordination_header) == 2 * sizeof(std::uint32_t),
+        "The header of the coordination messages must not be padded.");
+    coordination_header header;
+
+    payload.clear();
+    if (!coordination_receive_all(socket, &header, sizeof(header), true)) {
+        return false;
+    }
+
+    if (header.length > coordination_max_payload) {
+        throw std::runtime_error("A coordination message exceeds the maximum "
+            "size.");
+    }
+
+    type = header.type;
+    payload.resize(header.length);
+    if (!payload.empty()) {
+        coordination_receive_all(socket, payload.data(), payload.size(),
+            false);
+    }
+
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::coordination_send
+ */
+void visus::power_overwhelming::detail::coordination_send(
+        _In_ const coordination_socket socket,
+        _In_ const coordination_message type,
+        _In_ const std::vector<std::uint8_t>& payload) {
+    // Send the header and the payload at once, because the messages are
+    // small and the peers have disabled Nagle's algorithm.
+    std::vector<std::uint8_t> message;
+    message.reserve(sizeof(coordination_header) + payload.size());
+    coordination_append(message, static_cast<std::uint32_t>(type));
+    coordination_append(message, static_cast<std::uint32_t>(payload.size()));
+    message.insert(message.end(), payload.begin(), payload.end());
+
+    std::size_t sent = 0;
+    while (sent < message.size()) {
+        const auto n = ::send(socket, reinterpret_cast<const char *>(
+            message.data() + sent), static_cast<int>(message.size() - sent),
+            MSG_NOSIGNAL);
+        if (n == SOCKET_ERROR) {
+            throw std::system_error(get_socket_error(),
+                std::system_category());
+        }
+        sent += static_cast<std::size_t>(n);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::coordination_timeout
+ */
+void visus::power_overwhelming::detail::coordination_timeout(
+        _In_ const coordination_socket socket,
+        _In_ const unsigned int timeout) noexcept {
+#if defined(_WIN32)
+    DWORD value = timeout;
+#else /* defined(_WIN32) */
+    timeval value = { };
+    value.tv_sec = timeout / 1000;
+    value.tv_usec = (timeout % 1000) * 1000;
+#endif /* defined(_WIN32) */
+    ::setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO,
+        reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::coordination_wait
+ */
+visus::power_overwhelming::timestamp_type
+visus::power_overwhelming::detail::coordination_wait(
+        _In_ const timestamp_type target) {
+    // Waking up from a sleep may take more than a millisecond, so we only
+    // sleep until two milliseconds before the target.
+    static constexpr timestamp_type spin = 20000;
+    const auto resolution = timestamp_resolution::hundred_nanoseconds;
+    auto now = create_timestamp(resolution);
+
+    if (target - now > spin) {
+        std::this_thread::sleep_for(std::chrono::microseconds(
+            (target - now - spin) / 10));
+    }
+
+    while ((now = create_timestamp(resolution)) < target) {
+        std::this_thread::yield();
+    }
+
+    return now - target;
+}
@@ -0,0 +1,206 @@
+﻿// <copyright file="coordination_protocol.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+#include "socket_functions.h"
+#include "timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The messages exchanged between a <see cref="collector_coordinator" />
+    /// and its <see cref="collector_agent" />s.
+    /// </summary>
+    /// <remarks>
+    /// <para>Each message consists of a <see cref="coordination_header" />
+    /// and the number of payload bytes given therein. All numbers are stored
+    /// in little endian, and the texts are stored like in the binary output,
+    /// i.e. as UTF-16 with a 32-bit length. All time stamps are in units of
+    /// 100 ns on the clock of the coordinator.</para>
+    /// <para>The coordinator sends the odd messages and the agent answers
+    /// each of them with the next even one or with
+    /// <see cref="coordination_message::error" />.</para>
+    /// </remarks>
+    enum class coordination_message : std::uint32_t {
+
+        /// <summary>
+        /// Opens a session with the port of the time synchroniser of the
+        /// coordinator as <c>std::uint16_t</c>.
+        /// </summary>
+        hello = 1,
+
+        /// <summary>
+        /// Accepts the session with the name of the node.
+        /// </summary>
+        welcome = 2,
+
+        /// <summary>
+        /// Starts the collector at the time stamp given as
+        /// <c>std::int64_t</c>.
+        /// </summary>
+        start = 3,
+
+        /// <summary>
+        /// Confirms the start with the time by which the agent missed the
+        /// requested instant on its own clock as <c>std::int64_t</c>.
+        /// </summary>
+        started = 4,
+
+        /// <summary>
+        /// Sets a marker at the time stamp given as <c>std::int64_t</c>,
+        /// followed by the text of the marker, which is empty for ending the
+        /// current phase.
+        /// </summary>
+        marker = 5,
+
+        /// <summary>
+        /// Confirms the marker.
+        /// </summary>
+        marked = 6,
+
+        /// <summary>
+        /// Stops the collector.
+        /// </summary>
+        stop = 7,
+
+        /// <summary>
+        /// Confirms the stop with the number of samples and overflows as two
+        /// <c>std::uint64_t</c>.
+        /// </summary>
+        stopped = 8,
+
+        /// <summary>
+        /// Reports that a request failed with the error message.
+        /// </summary>
+        error = 9
+    };
+
+    /// <summary>
+    /// The header preceding each <see cref="coordination_message" />.
+    /// </summary>
+    struct coordination_header final {
+        coordination_message type;
+        std::uint32_t length;
+    };
+
+    /// <summary>
+    /// The largest payload that is accepted, which protects the peers from
+    /// allocating arbitrary amounts of memory on corrupt input.
+    /// </summary>
+    constexpr std::uint32_t coordination_max_payload = 64 * 1024;
+
+    /// <summary>
+    /// The type of a socket.
+    /// </summary>
+    typedef decltype(INVALID_SOCKET) coordination_socket;
+
+    /// <summary>
+    /// Appends a number to a payload.
+    /// </summary>
+    template<class TValue>
+    inline void coordination_append(_Inout_ std::vector<std::uint8_t>& dst,
+            _In_ const TValue value) {
+        auto v = reinterpret_cast<const std::uint8_t *>(&value);
+        dst.insert(dst.end(), v, v + sizeof(value));
+    }
+
+    /// <summary>
+    /// Appends a text to a payload.
+    /// </summary>
+    void POWER_OVERWHELMING_API coordination_append(
+        _Inout_ std::vector<std::uint8_t>& dst,
+        _In_z_ const wchar_t *value);
+
+    /// <summary>
+    /// Reads a number from a payload.
+    /// </summary>
+    /// <exception cref="std::runtime_error">If the payload is too short.
+    /// </exception>
+    template<class TValue>
+    TValue coordination_read(_In_ const std::vector<std::uint8_t>& src,
+        _Inout_ std::size_t& offset);
+
+    /// <summary>
+    /// Reads a text from a payload.
+    /// </summary>
+    /// <exception cref="std::runtime_error">If the payload is too short.
+    /// </exception>
+    std::wstring POWER_OVERWHELMING_API coordination_read_string(
+        _In_ const std::vector<std::uint8_t>& src,
+        _Inout_ std::size_t& offset);
+
+    /// <summary>
+    /// Receives a message.
+    /// </summary>
+    /// <param name="socket">The connected socket.</param>
+    /// <param name="type">Receives the type of the message.</param>
+    /// <param name="payload">Receives the payload of the message.</param>
+    /// <returns><c>true</c> if a message has been received, <c>false</c> if
+    /// the receive timeout of the socket elapsed before the message started.
+    /// </returns>
+    /// <exception cref="std::runtime_error">If the peer closed the
+    /// connection or sent an oversized message.</exception>
+    /// <exception cref="std::system_error">If the message could not be
+    /// received.</exception>
+    bool POWER_OVERWHELMING_API coordination_receive(
+        _In_ const coordination_socket socket,
+        _Out_ coordination_message& type,
+        _Out_ std::vector<std::uint8_t>& payload);
+
+    /// <summary>
+    /// Sends a message.
+    /// </summary>
+    /// <param name="socket">The connected socket.</param>
+    /// <param name="type">The type of the message.</param>
+    /// <param name="payload">The payload of the message.</param>
+    /// <exception cref="std::system_error">If the message could not be
+    /// sent.</exception>
+    void POWER_OVERWHELMING_API coordination_send(
+        _In_ const coordination_socket socket,
+        _In_ const coordination_message type,
+        _In_ const std::vector<std::uint8_t>& payload);
+
+    /// <summary>
+    /// Sets the receive timeout of a socket.
+    /// </summary>
+    /// <param name="socket">The socket to be configured.</param>
+    /// <param name="timeout">The timeout in milliseconds.</param>
+    void POWER_OVERWHELMING_API coordination_timeout(
+        _In_ const coordination_socket socket,
+        _In_ const unsigned int timeout) noexcept;
+
+    /// <summary>
+    /// Blocks the calling thread until the given time.
+    /// </summary>
+    /// <remarks>
+    /// The thread sleeps until shortly before the requested instant and spins
+    /// for the rest, because the resolution of sleeping is too coarse for
+    /// aligning multiple nodes to the millisecond.
+    /// </remarks>
+    /// <param name="target">The time stamp in units of 100 ns on the local
+    /// clock.</param>
+    /// <returns>The time in units of 100 ns by which the instant has been
+    /// missed, which is positive if the thread woke up late or if the
+    /// instant had already passed when the method was called.</returns>
+    timestamp_type POWER_OVERWHELMING_API coordination_wait(
+        _In_ const timestamp_type target);
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+#include "coordination_protocol.inl"
@@ -0,0 +1,22 @@
+﻿// <copyright file="coordination_protocol.inl" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+
+/*
+ * visus::power_overwhelming::detail::coordination_read
+ */
+template<class TValue>
+TValue visus::power_overwhelming::detail::coordination_read(
+        _In_ const std::vector<std::uint8_t>& src,
+        _Inout_ std::size_t& offset) {
+    if (offset + sizeof(TValue) > src.size()) {
+        throw std::runtime_error("A coordination message is truncated.");
+    }
+
+    TValue retval;
+    ::memcpy(&retval, src.data() + offset, sizeof(TValue));
+    offset += sizeof(TValue);
+    return retval;
+}
@@ -147,3 +147,83 @@ void visus::power_overwhelming::set_thread_affinity(
     }
 #endif /* (defined(_WIN32_WINNT) && (_WIN32_WINNT >= 0x0601)) */
 }
+
+
+/*
+ * visus::power_overwhelming::set_thread_affinity
+ */
+void visus::power_overwhelming::set_thread_affinity(
+        _In_reads_(cnt) const std::uint32_t *logical_cpus,
+        _In_ const std::size_t cnt) {
+    if ((logical_cpus == nullptr) || (cnt == 0)) {
+        throw std::invalid_argument("At least one logical CPU must be "
+            "specified to set the thread affinity.");
+    }
+
+#if (defined(_WIN32_WINNT) && (_WIN32_WINNT >= 0x0601))
+    const auto groups = ::GetActiveProcessorGroupCount();
+    GROUP_AFFINITY affinity { 0 };
+
+    for (std::size_t i = 0; i < cnt; ++i) {
+        // Search the group in which the CPU falls, like for a single CPU.
+        std::decay<decltype(*logical_cpus)>::type total = 0;
+        WORD group = 0;
+        for (; group < groups; ++group) {
+            const auto current = ::GetActiveProcessorCount(group);
+            if (total + current > logical_cpus[i]) {
+                break;
+            } else {
+                total += current;
+            }
+        }
+
+        if (group >= groups) {
+            throw std::system_error(ERROR_NOT_FOUND, std::system_category(),
+                "The specified logical CPU number is too large.");
+        }
+        if ((i > 0) && (group != affinity.Group)) {
+            throw std::system_error(ERROR_NOT_SUPPORTED,
+                std::system_category(), "All logical CPUs in the set must be "
+                "in the same processor group.");
+        }
+
+        affinity.Group = group;
+        affinity.Mask |= 1ULL << (logical_cpus[i] - total);
+    }
+
+    if (!::SetThreadGroupAffinity(::GetCurrentThread(), &affinity, nullptr)) {
+        throw std::system_error(::GetLastError(), std::system_category());
+    }
+
+#elif defined(_WIN32)
+    DWORD_PTR mask = 0;
+    for (std::size_t i = 0; i < cnt; ++i) {
+        if (logical_cpus[i] > std::numeric_limits<DWORD_PTR>::digits) {
+            throw std::system_error(WINCODEC_ERR_VALUEOUTOFRANGE,
+                std::system_category(), ERROR_MSG_TOO_MANY_CORES);
+        }
+
+        mask |= static_cast<DWORD_PTR>(1) << logical_cpus[i];
+    }
+
+    if (!::SetThreadAffinityMask(::GetCurrentThread(), mask)) {
+        throw std::system_error(::GetLastError(), std::system_category());
+    }
+
+#else /* (defined(_WIN32_WINNT) && (_WIN32_WINNT >= 0x0601)) */
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    for (std::size_t i = 0; i < cnt; ++i) {
+        if (logical_cpus[i] >= CPU_SETSIZE) {
+            throw std::system_error(EINVAL, std::system_category(),
+                ERROR_MSG_TOO_MANY_CORES);
+        }
+
+        CPU_SET(logical_cpus[i], &cpuset);
+    }
+
+    if (::sched_setaffinity(0, sizeof(cpuset), &cpuset)) {
+        throw std::system_error(errno, std::system_category());
+    }
+#endif /* (defined(_WIN32_WINNT) && (_WIN32_WINNT >= 0x0601)) */
+}
@@ -7,8 +7,11 @@
 
 #include <array>
 #include <cstring>
+#include <fstream>
 #include <stdexcept>
+#include <string>
 #include <system_error>
+#include <vector>
 
 #if defined(_WIN32)
 #include <intrin.h>
@@ -16,8 +19,11 @@
 #else /* defined(_WIN32) */
 #include <cpuid.h>
 #include <errno.h>
+#include <unistd.h>
 #endif /* defined(_WIN32) */
 
+#include "machine_topology.h"
+
 
 /*
  * visus::power_overwhelming::extract_cpu_model
@@ -130,15 +136,147 @@ std::uint32_t visus::power_overwhelming::get_cpu_info(
 }
 
 
+/*
+ * visus::power_overwhelming::get_cpu_topology
+ */
+visus::power_overwhelming::cpu_topology
+visus::power_overwhelming::get_cpu_topology(
+        _In_ const std::uint32_t logical_cpu) {
+    cpu_topology retval;
+
+#if defined(_WIN32)
+    DWORD size = 0;
+    std::vector<std::uint8_t> buffer;
+
+    // Retrieve the relationships of all processors, which we need to enumerate
+    // as the identifiers are the order of the packages and cores.
+    if (!::GetLogicalProcessorInformationEx(RelationAll, nullptr, &size)) {
+        const auto error = ::GetLastError();
+        if (error != ERROR_INSUFFICIENT_BUFFER) {
+            throw std::system_error(error, std::system_category());
+        }
+    }
+
+    buffer.resize(size);
+    auto infos = reinterpret_cast<
+        PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data());
+    if (!::GetLogicalProcessorInformationEx(RelationAll, infos, &size)) {
+        throw std::system_error(::GetLastError(), std::system_category());
+    }
+
+    // Find out in which group the logical CPU is and which bit of the group
+    // affinity mask represents it. This must match the numbering scheme of
+    // set_thread_affinity.
+    const auto groups = ::GetActiveProcessorGroupCount();
+    WORD group = 0;
+    KAFFINITY mask = 0;
+    {
+        std::uint32_t total = 0;
+        for (; group < groups; ++group) {
+            const auto current = ::GetActiveProcessorCount(group);
+            if (total + current > logical_cpu) {
+                mask = static_cast<KAFFINITY>(1) << (logical_cpu - total);
+                break;
+            } else {
+                total += current;
+            }
+        }
+    }
+
+    if (group >= groups) {
+        throw std::invalid_argument("The specified logical CPU does not "
+            "exist.");
+    }
+
+    auto found_package = false;
+    auto found_core = false;
+    std::uint32_t packages = 0;
+    std::uint32_t cores = 0;
+
+    for (DWORD offset = 0; offset < size;) {
+        auto info = reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(
+            buffer.data() + offset);
+        offset += info->Size;
+
+        switch (info->Relationship) {
+            case RelationProcessorPackage:
+                for (WORD g = 0; g < info->Processor.GroupCount; ++g) {
+                    auto& m = info->Processor.GroupMask[g];
+                    if ((m.Group == group) && ((m.Mask & mask) != 0)) {
+                        retval.package = packages;
+                        found_package = true;
+                    }
+                }
+                ++packages;
+                break;
+
+            case RelationProcessorCore:
+                for (WORD g = 0; g < info->Processor.GroupCount; ++g) {
+                    auto& m = info->Processor.GroupMask[g];
+                    if ((m.Group == group) && ((m.Mask & mask) != 0)) {
+                        retval.core = cores;
+                        found_core = true;
+                    }
+                }
+                ++cores;
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    if (!found_package) {
+        retval.package = 0;
+    }
+    if (!found_core) {
+        retval.core = logical_cpu;
+    }
+
+    // Windows only reports dies on very recent versions, so we use the
+    // package, which is what most CPUs have.
+    retval.die = retval.package;
+
+#else /* defined(_WIN32) */
+    const auto cnt = ::sysconf(_SC_NPROCESSORS_CONF);
+    if ((cnt > 0) && (logical_cpu >= static_cast<std::uint32_t>(cnt))) {
+        throw std::invalid_argument("The specified logical CPU does not "
+            "exist.");
+    }
+
+    // Reads an identifier from the sysfs or returns the fallback value if the
+    // respective file does not exist, which is the case e.g. for dies on older
+    // kernels.
+    const auto read = [logical_cpu](const char *name,
+            const std::uint32_t fallback) {
+        auto path = std::string("/sys/devices/system/cpu/cpu")
+            + std::to_string(logical_cpu) + "/topology/" + name;
+        std::ifstream stream(path);
+        std::int64_t value = -1;
+        if (!(stream >> value) || (value < 0)) {
+            return fallback;
+        } else {
+            return static_cast<std::uint32_t>(value);
+        }
+    };
+
+    retval.package = read("physical_package_id", 0);
+    retval.die = read("die_id", retval.package);
+    retval.core = read("core_id", logical_cpu);
+#endif /* defined(_WIN32) */
+
+    return retval;
+}
+
+
 /*
  * visus::power_overwhelming::get_cpu_vendor
  */
 visus::power_overwhelming::cpu_vendor visus::power_overwhelming::get_cpu_vendor(
         void) noexcept {
-    cpu_info info;
-    if (get_cpu_info(&info, 1) > 0) {
-        return extract_cpu_vendor(info);
-    } else {
+    try {
+        return detail::machine_topology::instance().vendor();
+    } catch (...) {
         return cpu_vendor::unknown;
     }
 }
@@ -0,0 +1,725 @@
+﻿// <copyright file="csv_output.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "csv_output.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+#if ((defined(_MSVC_LANG) && (_MSVC_LANG >= 201703L)) \
+    || (__cplusplus >= 201703L))
+#include <charconv>
+#endif /* ((defined(_MSVC_LANG) && (_MSVC_LANG >= 201703L)) ... */
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif /* !defined(_WIN32) */
+
+#include "power_overwhelming/convert_string.h"
+#include "power_overwhelming/csv_iomanip.h"
+
+#include "string_functions.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The largest number of bytes a single number is formatted into.
+    /// </summary>
+    static constexpr std::size_t csv_max_number = 32;
+
+    /// <summary>
+    /// The number of significant digits of double-precision numbers.
+    /// </summary>
+    static constexpr int csv_double_precision = 15;
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::block_size
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::csv_output_writer::block_size;
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::default_delimiter
+ */
+constexpr visus::power_overwhelming::detail::csv_output_writer::char_type
+visus::power_overwhelming::detail::csv_output_writer::default_delimiter;
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::csv_output_writer
+ */
+visus::power_overwhelming::detail::csv_output_writer::csv_output_writer(void)
+    : _buffer(new char_type[block_size]),
+        _delimiter(default_delimiter),
+#if defined(_WIN32)
+        _file(INVALID_HANDLE_VALUE),
+#else /* defined(_WIN32) */
+        _file(-1),
+#endif /* defined(_WIN32) */
+        _good(true),
+        _last_sensor(nullptr),
+        _last_sensor_text(nullptr),
+        _position(0),
+        _quote(0),
+        _written(0) { }
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::~csv_output_writer
+ */
+visus::power_overwhelming::detail::csv_output_writer::~csv_output_writer(
+        void) {
+    this->close();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::aggregate
+ */
+void visus::power_overwhelming::detail::csv_output_writer::aggregate(
+        _In_ const sample_aggregate& aggregate) {
+    auto& name = this->sensor(aggregate.sensor);
+
+    this->append("# aggregate");
+    this->append(&this->_delimiter, 1);
+    this->append(name.data(), name.size());
+    this->append(&this->_delimiter, 1);
+    this->append(static_cast<std::int64_t>(aggregate.begin));
+    this->append(&this->_delimiter, 1);
+    this->append(static_cast<std::int64_t>(aggregate.end));
+    this->append(&this->_delimiter, 1);
+    this->append(aggregate.count);
+    this->append(&this->_delimiter, 1);
+    this->append(aggregate.minimum);
+    this->append(&this->_delimiter, 1);
+    this->append(aggregate.mean);
+    this->append(&this->_delimiter, 1);
+    this->append(aggregate.maximum);
+    this->append(&this->_delimiter, 1);
+    this->append(aggregate.energy);
+    this->append(&this->_delimiter, 1);
+    this->append(static_cast<std::uint64_t>(aggregate.marker));
+    this->append("\n");
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::close
+ */
+void visus::power_overwhelming::detail::csv_output_writer::close(void) {
+    if (this->is_open()) {
+        this->flush();
+
+#if defined(_WIN32)
+        ::CloseHandle(this->_file);
+        this->_file = INVALID_HANDLE_VALUE;
+#else /* defined(_WIN32) */
+        ::close(this->_file);
+        this->_file = -1;
+#endif /* defined(_WIN32) */
+    }
+
+    this->_last_sensor = nullptr;
+    this->_last_sensor_text = nullptr;
+    this->_sensors.clear();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::delimiter
+ */
+void visus::power_overwhelming::detail::csv_output_writer::delimiter(
+        _In_ const char_type delimiter) noexcept {
+    this->_delimiter = delimiter;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::flush
+ */
+void visus::power_overwhelming::detail::csv_output_writer::flush(void) {
+    if (this->_position > 0) {
+        this->write_buffer();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::header
+ */
+void visus::power_overwhelming::detail::csv_output_writer::header(void) {
+    this->append_string(L"sensor");
+    this->append(&this->_delimiter, 1);
+    this->append_string(L"timestamp");
+    this->append(&this->_delimiter, 1);
+    this->append_string(L"valid");
+    this->append(&this->_delimiter, 1);
+    this->append_string(L"voltage");
+    this->append(&this->_delimiter, 1);
+    this->append_string(L"current");
+    this->append(&this->_delimiter, 1);
+    this->append_string(L"power");
+    this->append(&this->_delimiter, 1);
+    this->append("marker\n");
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::header
+ */
+void visus::power_overwhelming::detail::csv_output_writer::header(
+        _In_reads_(cnt) const wchar_t *const *sensors,
+        _In_ const std::size_t cnt) {
+    assert((sensors != nullptr) || (cnt == 0));
+    this->append_string(L"timestamp");
+    this->append(&this->_delimiter, 1);
+
+    for (std::size_t i = 0; i < cnt; ++i) {
+        auto& name = this->sensor(sensors[i]);
+        this->append(name.data(), name.size());
+        this->append(&this->_delimiter, 1);
+    }
+
+    this->append("marker\n");
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::is_open
+ */
+bool visus::power_overwhelming::detail::csv_output_writer::is_open(
+        void) const noexcept {
+#if defined(_WIN32)
+    return (this->_file != INVALID_HANDLE_VALUE);
+#else /* defined(_WIN32) */
+    return (this->_file >= 0);
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::marker
+ */
+void visus::power_overwhelming::detail::csv_output_writer::marker(
+        _In_ const std::uint32_t id, _In_z_ const wchar_t *name) {
+    this->append("# marker");
+    this->append(&this->_delimiter, 1);
+    this->append(static_cast<std::uint64_t>(id));
+    this->append(&this->_delimiter, 1);
+    this->append_string(name);
+    this->append("\n");
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::marker_event
+ */
+void visus::power_overwhelming::detail::csv_output_writer::marker_event(
+        _In_ const measurement::timestamp_type timestamp,
+        _In_ const std::uint32_t id) {
+    this->append("# marker event");
+    this->append(&this->_delimiter, 1);
+    this->append(static_cast<std::int64_t>(timestamp));
+    this->append(&this->_delimiter, 1);
+    this->append(static_cast<std::uint64_t>(id));
+    this->append("\n");
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::open
+ */
+void visus::power_overwhelming::detail::csv_output_writer::open(
+        _In_z_ const wchar_t *path) {
+    if (path == nullptr) {
+        throw std::invalid_argument("The path to the CSV output file must not "
+            "be null.");
+    }
+
+    this->close();
+
+#if defined(_WIN32)
+    this->_file = ::CreateFileW(path, GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+        CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+        NULL);
+    if (this->_file == INVALID_HANDLE_VALUE) {
+        throw std::system_error(::GetLastError(), std::system_category());
+    }
+#else /* defined(_WIN32) */
+    auto p = power_overwhelming::convert_string<char>(path);
+    this->_file = ::open(p.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+        0666);
+    if (this->_file < 0) {
+        throw std::system_error(errno, std::system_category());
+    }
+#endif /* defined(_WIN32) */
+
+    this->_good = true;
+    this->_written = 0;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::phase_energy
+ */
+void visus::power_overwhelming::detail::csv_output_writer::phase_energy(
+        _In_ const detail::phase_energy& energy) {
+    auto& name = this->sensor(energy.sensor);
+
+    this->append("# phase energy");
+    this->append(&this->_delimiter, 1);
+    this->append(static_cast<std::uint64_t>(energy.phase));
+    this->append(&this->_delimiter, 1);
+    this->append(name.data(), name.size());
+    this->append(&this->_delimiter, 1);
+    this->append(static_cast<std::int64_t>(energy.begin));
+    this->append(&this->_delimiter, 1);
+    this->append(static_cast<std::int64_t>(energy.end));
+    this->append(&this->_delimiter, 1);
+    this->append(energy.samples);
+    this->append(&this->_delimiter, 1);
+    this->append(energy.energy);
+    this->append(&this->_delimiter, 1);
+    this->append(static_cast<std::uint64_t>(energy.marker));
+    this->append("\n");
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::phase_quantiles
+ */
+void visus::power_overwhelming::detail::csv_output_writer::phase_quantiles(
+        _In_ const detail::phase_quantiles& quantiles) {
+    auto& name = this->sensor(quantiles.sensor);
+
+    this->append("# phase quantiles");
+    this->append(&this->_delimiter, 1);
+    this->append(name.data(), name.size());
+    this->append(&this->_delimiter, 1);
+    this->append(static_cast<std::uint64_t>(quantiles.marker));
+    this->append(&this->_delimiter, 1);
+    this->append(quantiles.samples);
+    for (auto v : quantiles.values) {
+        this->append(&this->_delimiter, 1);
+        this->append(v);
+    }
+    this->append("\n");
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::push
+ */
+void visus::power_overwhelming::detail::csv_output_writer::push(
+        _In_ const measurement& sample,
+        _In_ const std::uint32_t marker) {
+    auto& name = this->sensor(sample.sensor());
+    this->append(name.data(), name.size());
+    this->append(&this->_delimiter, 1);
+
+    this->append(static_cast<std::int64_t>(sample.timestamp()));
+    this->append(&this->_delimiter, 1);
+
+    {
+        auto dst = this->reserve(2);
+        dst[0] = static_cast<bool>(sample) ? '1' : '0';
+        dst[1] = this->_delimiter;
+        this->_position += 2;
+    }
+
+    this->append(sample.voltage());
+    this->append(&this->_delimiter, 1);
+    this->append(sample.current());
+    this->append(&this->_delimiter, 1);
+    this->append(sample.power());
+    this->append(&this->_delimiter, 1);
+    this->append(static_cast<std::uint64_t>(marker));
+
+    *this->reserve(1) = '\n';
+    ++this->_position;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::push
+ */
+void visus::power_overwhelming::detail::csv_output_writer::push(
+        _In_ const measurement::timestamp_type timestamp,
+        _In_reads_(cnt) const float *values,
+        _In_ const std::size_t cnt,
+        _In_opt_ const std::uint32_t *marker) {
+    assert((values != nullptr) || (cnt == 0));
+    this->append(static_cast<std::int64_t>(timestamp));
+    this->append(&this->_delimiter, 1);
+
+    // Missing values are empty fields, which is what makes the wide layout
+    // compact if the sensors are not sampled at the same rate.
+    for (std::size_t i = 0; i < cnt; ++i) {
+        if (!std::isnan(values[i])) {
+            this->append(values[i]);
+        }
+        this->append(&this->_delimiter, 1);
+    }
+
+    if (marker != nullptr) {
+        this->append(static_cast<std::uint64_t>(*marker));
+    }
+
+    *this->reserve(1) = '\n';
+    ++this->_position;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::quote
+ */
+void visus::power_overwhelming::detail::csv_output_writer::quote(
+        _In_ const char_type quote) noexcept {
+    if (quote != this->_quote) {
+        // The cached names of the sensors include the quote.
+        this->_last_sensor = nullptr;
+        this->_last_sensor_text = nullptr;
+        this->_sensors.clear();
+        this->_quote = quote;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::schema_change
+ */
+void visus::power_overwhelming::detail::csv_output_writer::schema_change(
+        _In_ const detail::schema_change& change) {
+    this->append("# schema change");
+    this->append(&this->_delimiter, 1);
+    this->append(static_cast<std::int64_t>(change.timestamp));
+    this->append(&this->_delimiter, 1);
+
+    {
+        std::string type;
+        append_utf8(type, to_string(change.type));
+        this->append(type.data(), type.size());
+    }
+
+    this->append(&this->_delimiter, 1);
+    this->append_string(change.name.c_str());
+    this->append(&this->_delimiter, 1);
+    this->append(static_cast<std::uint64_t>(change.interval));
+    this->append("\n");
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::sequence_gap
+ */
+void visus::power_overwhelming::detail::csv_output_writer::sequence_gap(
+        _In_ const detail::sequence_gap& gap) {
+    auto& name = this->sensor(gap.sensor);
+
+    this->append("# sequence gap");
+    this->append(&this->_delimiter, 1);
+    this->append(name.data(), name.size());
+    this->append(&this->_delimiter, 1);
+    this->append(static_cast<std::int64_t>(gap.timestamp));
+    this->append(&this->_delimiter, 1);
+    this->append(static_cast<std::uint64_t>(gap.first));
+    this->append(&this->_delimiter, 1);
+    this->append(static_cast<std::uint64_t>(gap.missing));
+    this->append("\n");
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::sequence_summary
+ */
+void visus::power_overwhelming::detail::csv_output_writer::sequence_summary(
+        _In_ const detail::sequence_summary& summary) {
+    auto& name = this->sensor(summary.sensor);
+
+    this->append("# sequence summary");
+    this->append(&this->_delimiter, 1);
+    this->append(name.data(), name.size());
+    this->append(&this->_delimiter, 1);
+    this->append(summary.samples);
+    this->append(&this->_delimiter, 1);
+    this->append(summary.gaps);
+    this->append(&this->_delimiter, 1);
+    this->append(summary.missing);
+    this->append(&this->_delimiter, 1);
+    this->append(summary.duplicates);
+    this->append("\n");
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::start
+ */
+void visus::power_overwhelming::detail::csv_output_writer::start(
+        _In_ const start_record& record) {
+    this->append("# start");
+    this->append(&this->_delimiter, 1);
+    this->append(static_cast<std::int64_t>(record.timestamp));
+    this->append("\n");
+
+    for (auto& l : record.latencies) {
+        this->append("# start latency");
+        this->append(&this->_delimiter, 1);
+        this->append_string(l.first.c_str());
+        this->append(&this->_delimiter, 1);
+        this->append(static_cast<std::uint64_t>(l.second));
+        this->append("\n");
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::statistics
+ */
+void visus::power_overwhelming::detail::csv_output_writer::statistics(
+        _In_ const sampler_statistics_impl& statistics) {
+    // This is written only once per sampler context when the collector stops,
+    // so we reuse the stream formatter instead of formatting the percentiles
+    // ourselves.
+    std::wostringstream stream;
+    stream << setcsvdelimiter(static_cast<wchar_t>(this->_delimiter))
+        << setcsvquote(static_cast<wchar_t>(this->_quote));
+    write_csv(stream, statistics);
+
+    std::string text;
+    append_utf8(text, stream.str().c_str());
+    this->append(text.data(), text.size());
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::append
+ */
+void visus::power_overwhelming::detail::csv_output_writer::append(
+        _In_reads_(cnt) const char_type *data,
+        _In_ const std::size_t cnt) {
+    assert((data != nullptr) || (cnt == 0));
+    auto remaining = cnt;
+
+    // Data larger than the buffer is split into blocks, which only happens for
+    // very long marker texts.
+    while (remaining > 0) {
+        if (this->_position == block_size) {
+            this->write_buffer();
+        }
+
+        const auto n = (std::min)(remaining, block_size - this->_position);
+        ::memcpy(this->_buffer.get() + this->_position, data, n);
+        this->_position += n;
+        data += n;
+        remaining -= n;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::append
+ */
+void visus::power_overwhelming::detail::csv_output_writer::append(
+        _In_z_ const char_type *str) {
+    assert(str != nullptr);
+    this->append(str, ::strlen(str));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::append
+ */
+void visus::power_overwhelming::detail::csv_output_writer::append(
+        _In_ const std::int64_t value) {
+    if (value < 0) {
+        *this->reserve(1) = '-';
+        ++this->_position;
+        // Negate in the unsigned domain to handle the smallest value.
+        this->append(static_cast<std::uint64_t>(0)
+            - static_cast<std::uint64_t>(value));
+    } else {
+        this->append(static_cast<std::uint64_t>(value));
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::append
+ */
+void visus::power_overwhelming::detail::csv_output_writer::append(
+        _In_ const std::uint64_t value) {
+    char_type digits[csv_max_number];
+    auto end = digits + sizeof(digits);
+    auto cur = end;
+    auto v = value;
+
+    do {
+        *--cur = static_cast<char_type>('0' + (v % 10));
+        v /= 10;
+    } while (v != 0);
+
+    const auto cnt = static_cast<std::size_t>(end - cur);
+    ::memcpy(this->reserve(cnt), cur, cnt);
+    this->_position += cnt;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::append
+ */
+void visus::power_overwhelming::detail::csv_output_writer::append(
+        _In_ const float value) {
+    // Streams format floating-point numbers like "%g" with a precision of six
+    // digits by default, which we reproduce here.
+    auto dst = this->reserve(csv_max_number);
+#if defined(__cpp_lib_to_chars)
+    auto result = std::to_chars(dst, dst + csv_max_number, value,
+        std::chars_format::general, 6);
+    assert(result.ec == std::errc());
+    this->_position += static_cast<std::size_t>(result.ptr - dst);
+#else /* defined(__cpp_lib_to_chars) */
+    auto cnt = ::snprintf(dst, csv_max_number, "%g",
+        static_cast<double>(value));
+    assert(cnt > 0);
+    this->_position += (std::min)(static_cast<std::size_t>(cnt),
+        csv_max_number - 1);
+#endif /* defined(__cpp_lib_to_chars) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::append
+ */
+void visus::power_overwhelming::detail::csv_output_writer::append(
+        _In_ const double value) {
+    auto dst = this->reserve(csv_max_number);
+#if defined(__cpp_lib_to_chars)
+    auto result = std::to_chars(dst, dst + csv_max_number, value,
+        std::chars_format::general, csv_double_precision);
+    assert(result.ec == std::errc());
+    this->_position += static_cast<std::size_t>(result.ptr - dst);
+#else /* defined(__cpp_lib_to_chars) */
+    auto cnt = ::snprintf(dst, csv_max_number, "%.*g", csv_double_precision,
+        value);
+    assert(cnt > 0);
+    this->_position += (std::min)(static_cast<std::size_t>(cnt),
+        csv_max_number - 1);
+#endif /* defined(__cpp_lib_to_chars) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::append_string
+ */
+void visus::power_overwhelming::detail::csv_output_writer::append_string(
+        _In_opt_z_ const wchar_t *str) {
+    std::string text;
+
+    if (this->_quote != 0) {
+        text += this->_quote;
+    }
+    if (str != nullptr) {
+        append_utf8(text, str);
+    }
+    if (this->_quote != 0) {
+        text += this->_quote;
+    }
+
+    this->append(text.data(), text.size());
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::sensor
+ */
+const std::string& visus::power_overwhelming::detail::csv_output_writer::sensor(
+        _In_opt_z_ const wchar_t *name) {
+    // The names of measurements are interned, so we can compare pointers. We
+    // also remember the last sensor, because the samples of a sensor are
+    // often consecutive in the buffers.
+    if ((name == this->_last_sensor) && (this->_last_sensor_text != nullptr)) {
+        return *this->_last_sensor_text;
+    }
+
+    auto it = this->_sensors.find(name);
+    if (it == this->_sensors.end()) {
+        std::string text;
+        if (this->_quote != 0) {
+            text += this->_quote;
+        }
+        if (name != nullptr) {
+            append_utf8(text, name);
+        }
+        if (this->_quote != 0) {
+            text += this->_quote;
+        }
+
+        it = this->_sensors.emplace(name, std::move(text)).first;
+    }
+
+    this->_last_sensor = name;
+    this->_last_sensor_text = &it->second;
+    return it->second;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::csv_output_writer::write_buffer
+ */
+void visus::power_overwhelming::detail::csv_output_writer::write_buffer(
+        void) noexcept {
+    auto data = this->_buffer.get();
+    auto remaining = this->_position;
+    this->_written += remaining;
+
+    // The buffer is always reset such that a failed write does not block all
+    // subsequent output.
+    this->_position = 0;
+
+    if (!this->is_open()) {
+        this->_good = false;
+        return;
+    }
+
+    while (remaining > 0) {
+#if defined(_WIN32)
+        DWORD written = 0;
+        if (!::WriteFile(this->_file, data, static_cast<DWORD>(remaining),
+                &written, nullptr)) {
+            this->_good = false;
+            return;
+        }
+#else /* defined(_WIN32) */
+        auto written = ::write(this->_file, data, remaining);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            this->_good = false;
+            return;
+        }
+#endif /* defined(_WIN32) */
+
+        data += written;
+        remaining -= static_cast<std::size_t>(written);
+    }
+}
@@ -0,0 +1,382 @@
+﻿// <copyright file="csv_output.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#endif /* defined(_WIN32) */
+
+#include "power_overwhelming/measurement.h"
+
+#include "phase_energy.h"
+#include "phase_quantiles.h"
+#include "sample_aggregator.h"
+#include "sampler_statistics_impl.h"
+#include "schema_change.h"
+#include "sequence_tracker.h"
+#include "start_record.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Writes samples as UTF-8 encoded CSV.
+    /// </summary>
+    /// <remarks>
+    /// <para>The writer produces the same output as formatting the samples
+    /// with <c>operator &lt;&lt;</c> on a wide stream, but it formats all
+    /// numbers into a large byte buffer without consulting the locale or the
+    /// <c>iword</c>s of a stream and writes the buffer to the file with a
+    /// single system call once it is full or <see cref="flush" /> is called.
+    /// </para>
+    /// <para>The <see cref="delimiter" /> and the <see cref="quote" /> have the
+    /// same semantics as <see cref="setcsvdelimiter" /> and
+    /// <see cref="setcsvquote" />: Strings are enclosed in the quote unless it
+    /// is zero, whereas numbers are never quoted.</para>
+    /// <para>Like a stream, the writer does not throw if writing fails, but
+    /// discards the data and reports the error via <see cref="good" />.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API csv_output_writer final {
+
+    public:
+
+        /// <summary>
+        /// The type of characters written to the file.
+        /// </summary>
+        typedef char char_type;
+
+        /// <summary>
+        /// The size of the buffer in bytes, which is written at once.
+        /// </summary>
+        static constexpr std::size_t block_size = 1 << 20;
+
+        /// <summary>
+        /// The delimiter used unless another one is set, which matches the
+        /// default of <see cref="getcsvdelimiter" />.
+        /// </summary>
+        static constexpr char_type default_delimiter = '\t';
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        csv_output_writer(void);
+
+        csv_output_writer(const csv_output_writer&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~csv_output_writer(void);
+
+        /// <summary>
+        /// Writes the comment line of the aggregate of the samples of a sensor
+        /// in a window.
+        /// </summary>
+        /// <remarks>
+        /// The line holds the keyword <c>aggregate</c>, the name of the
+        /// sensor, the begin and the end of the window, the number of
+        /// samples, the minimum, mean and maximum power, the energy and the
+        /// ID of the marker.
+        /// </remarks>
+        /// <param name="aggregate">The aggregate to be written.</param>
+        void aggregate(_In_ const sample_aggregate& aggregate);
+
+        /// <summary>
+        /// Writes all buffered data and closes the file.
+        /// </summary>
+        void close(void);
+
+        /// <summary>
+        /// Answer the delimiter between the fields of a line.
+        /// </summary>
+        /// <returns>The delimiter.</returns>
+        inline char_type delimiter(void) const noexcept {
+            return this->_delimiter;
+        }
+
+        /// <summary>
+        /// Sets the delimiter between the fields of a line.
+        /// </summary>
+        /// <param name="delimiter">The new delimiter.</param>
+        void delimiter(_In_ const char_type delimiter) noexcept;
+
+        /// <summary>
+        /// Writes all buffered data to the file.
+        /// </summary>
+        void flush(void);
+
+        /// <summary>
+        /// Answer whether all data have been written successfully since the
+        /// file was opened.
+        /// </summary>
+        /// <returns><c>true</c> if no error occurred, <c>false</c> otherwise.
+        /// </returns>
+        inline bool good(void) const noexcept {
+            return this->_good;
+        }
+
+        /// <summary>
+        /// Writes the header line of the samples.
+        /// </summary>
+        void header(void);
+
+        /// <summary>
+        /// Writes the header line of the wide layout, which has a column
+        /// with the power of each of the given sensors.
+        /// </summary>
+        /// <remarks>
+        /// The line holds <c>timestamp</c>, the names of the sensors and
+        /// <c>marker</c>.
+        /// </remarks>
+        /// <param name="sensors">The interned names of the sensors.</param>
+        /// <param name="cnt">The number of sensors.</param>
+        void header(_In_reads_(cnt) const wchar_t *const *sensors,
+            _In_ const std::size_t cnt);
+
+        /// <summary>
+        /// Answer whether the output file is open.
+        /// </summary>
+        /// <returns><c>true</c> if the file is open, <c>false</c> otherwise.
+        /// </returns>
+        bool is_open(void) const noexcept;
+
+        /// <summary>
+        /// Writes the comment declaring a marker.
+        /// </summary>
+        /// <param name="id">The non-zero ID of the marker.</param>
+        /// <param name="name">The text of the marker.</param>
+        void marker(_In_ const std::uint32_t id, _In_z_ const wchar_t *name);
+
+        /// <summary>
+        /// Writes the comment for a marker being set.
+        /// </summary>
+        /// <param name="timestamp">The time when the marker was set.</param>
+        /// <param name="id">The ID of the marker, which is zero if the marker
+        /// was cleared.</param>
+        void marker_event(_In_ const measurement::timestamp_type timestamp,
+            _In_ const std::uint32_t id);
+
+        /// <summary>
+        /// Opens the given file for writing, replacing any existing content.
+        /// </summary>
+        /// <param name="path">The path to the output file.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="path" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::system_error">If the file could not be
+        /// opened.</exception>
+        void open(_In_z_ const wchar_t *path);
+
+        /// <summary>
+        /// Writes the comment line of the energy of a sensor in a phase
+        /// between two markers.
+        /// </summary>
+        /// <remarks>
+        /// The line holds the keyword <c>phase energy</c>, the index of the
+        /// phase, the name of the sensor, the timestamps of the first and the
+        /// last sample in the phase, the number of samples, the energy and the
+        /// ID of the marker.
+        /// </remarks>
+        /// <param name="energy">The energy to be written.</param>
+        void phase_energy(_In_ const detail::phase_energy& energy);
+
+        /// <summary>
+        /// Writes the comment line of the distribution of the power of a
+        /// sensor while a marker was active.
+        /// </summary>
+        /// <remarks>
+        /// The line holds the keyword <c>phase quantiles</c>, the name of the
+        /// sensor, the ID of the marker, the number of samples and the power
+        /// at each of the <see cref="phase_quantiles::levels" />.
+        /// </remarks>
+        /// <param name="quantiles">The quantiles to be written.</param>
+        void phase_quantiles(_In_ const detail::phase_quantiles& quantiles);
+
+        /// <summary>
+        /// Writes the line of a sample.
+        /// </summary>
+        /// <param name="sample">The sample to be written.</param>
+        /// <param name="marker">The ID of the marker active for the sample,
+        /// which is zero if no marker is active.</param>
+        void push(_In_ const measurement& sample,
+            _In_ const std::uint32_t marker);
+
+        /// <summary>
+        /// Writes a line of the wide layout.
+        /// </summary>
+        /// <param name="timestamp">The timestamp of the line.</param>
+        /// <param name="values">The power of each column of the
+        /// <see cref="header" />, which is written as an empty field if it
+        /// is not a number.</param>
+        /// <param name="cnt">The number of values.</param>
+        /// <param name="marker">The ID of the marker, or <c>nullptr</c> for
+        /// writing an empty field.</param>
+        void push(_In_ const measurement::timestamp_type timestamp,
+            _In_reads_(cnt) const float *values,
+            _In_ const std::size_t cnt,
+            _In_opt_ const std::uint32_t *marker);
+
+        /// <summary>
+        /// Answer the character enclosing strings.
+        /// </summary>
+        /// <returns>The quote, which is zero if strings are not quoted.
+        /// </returns>
+        inline char_type quote(void) const noexcept {
+            return this->_quote;
+        }
+
+        /// <summary>
+        /// Sets the character enclosing strings.
+        /// </summary>
+        /// <param name="quote">The new quote, or zero for not quoting strings.
+        /// </param>
+        void quote(_In_ const char_type quote) noexcept;
+
+        /// <summary>
+        /// Writes the comment for a change of the sensors of the running
+        /// collector.
+        /// </summary>
+        /// <param name="change">The change to be written.</param>
+        void schema_change(_In_ const detail::schema_change& change);
+
+        /// <summary>
+        /// Writes the comment line of a gap in the sequence numbers of the
+        /// samples of a sensor.
+        /// </summary>
+        /// <remarks>
+        /// The line holds the keyword <c>sequence gap</c>, the name of the
+        /// sensor, the timestamp of the sample after the gap, the sequence
+        /// number of the first missing sample and the number of missing
+        /// samples.
+        /// </remarks>
+        /// <param name="gap">The gap to be written.</param>
+        void sequence_gap(_In_ const detail::sequence_gap& gap);
+
+        /// <summary>
+        /// Writes the comment line of the counters of the sequence numbers of
+        /// a sensor.
+        /// </summary>
+        /// <remarks>
+        /// The line holds the keyword <c>sequence summary</c>, the name of the
+        /// sensor and the number of samples, gaps, missing samples and
+        /// duplicates.
+        /// </remarks>
+        /// <param name="summary">The summary to be written.</param>
+        void sequence_summary(_In_ const detail::sequence_summary& summary);
+
+        /// <summary>
+        /// Writes the comments describing the start of the collector.
+        /// </summary>
+        /// <param name="record">The start record to be written.</param>
+        void start(_In_ const start_record& record);
+
+        /// <summary>
+        /// Writes the comments describing the self-instrumentation of a
+        /// sampler context in the format of
+        /// <see cref="write_csv(std::wostream&amp;, const sampler_statistics_impl&amp;)" />.
+        /// </summary>
+        /// <param name="statistics">The statistics to be written.</param>
+        void statistics(_In_ const sampler_statistics_impl& statistics);
+
+        /// <summary>
+        /// Answer the number of bytes written to the file since it was opened,
+        /// including the data that are still buffered.
+        /// </summary>
+        /// <returns>The size of the output in bytes.</returns>
+        inline std::uint64_t written(void) const noexcept {
+            return (this->_written + this->_position);
+        }
+
+        csv_output_writer& operator =(const csv_output_writer&) = delete;
+
+    private:
+
+        /// <summary>
+        /// Appends <paramref name="cnt" /> bytes to the buffer.
+        /// </summary>
+        void append(_In_reads_(cnt) const char_type *data,
+            _In_ const std::size_t cnt);
+
+        /// <summary>
+        /// Appends the given null-terminated ASCII string.
+        /// </summary>
+        void append(_In_z_ const char_type *str);
+
+        /// <summary>
+        /// Appends the decimal representation of a signed integer.
+        /// </summary>
+        void append(_In_ const std::int64_t value);
+
+        /// <summary>
+        /// Appends the decimal representation of an unsigned integer.
+        /// </summary>
+        void append(_In_ const std::uint64_t value);
+
+        /// <summary>
+        /// Appends a floating-point number like a stream with the default
+        /// precision would format it.
+        /// </summary>
+        void append(_In_ const float value);
+
+        /// <summary>
+        /// Appends a double-precision number with 15 significant digits,
+        /// which preserves accumulated energies.
+        /// </summary>
+        void append(_In_ const double value);
+
+        /// <summary>
+        /// Appends the given string as (optionally quoted) UTF-8.
+        /// </summary>
+        void append_string(_In_opt_z_ const wchar_t *str);
+
+        /// <summary>
+        /// Ensures that at least <paramref name="cnt" /> bytes can be appended
+        /// to the buffer without writing it.
+        /// </summary>
+        inline char_type *reserve(_In_ const std::size_t cnt) {
+            if (this->_position + cnt > block_size) {
+                this->write_buffer();
+            }
+            return this->_buffer.get() + this->_position;
+        }
+
+        /// <summary>
+        /// Answer the quoted UTF-8 representation of the given interned sensor
+        /// name.
+        /// </summary>
+        const std::string& sensor(_In_opt_z_ const wchar_t *name);
+
+        /// <summary>
+        /// Writes the buffer to the file with a single system call if
+        /// possible.
+        /// </summary>
+        void write_buffer(void) noexcept;
+
+        std::unique_ptr<char_type[]> _buffer;
+        char_type _delimiter;
+#if defined(_WIN32)
+        HANDLE _file;
+#else /* defined(_WIN32) */
+        int _file;
+#endif /* defined(_WIN32) */
+        bool _good;
+        const wchar_t *_last_sensor;
+        const std::string *_last_sensor_text;
+        std::size_t _position;
+        char_type _quote;
+        std::unordered_map<const wchar_t *, std::string> _sensors;
+        std::uint64_t _written;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,214 @@
+﻿// <copyright file="cupti_kernel_tracer.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "cupti_kernel_tracer.h"
+
+#if defined(POWER_OVERWHELMING_WITH_CUPTI)
+#include <cassert>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#include "timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Throws a <see cref="std::runtime_error" /> if the given CUPTI call
+    /// failed.
+    /// </summary>
+    static void throw_on_cupti_error(_In_ const CUptiResult result) {
+        if (result != CUPTI_SUCCESS) {
+            const char *message = nullptr;
+            if ((::cuptiGetResultString(result, &message) != CUPTI_SUCCESS)
+                    || (message == nullptr)) {
+                message = "CUPTI failed with an unknown error.";
+            }
+
+            throw std::runtime_error(message);
+        }
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * ...::detail::cupti_kernel_tracer::buffer_size
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::cupti_kernel_tracer::buffer_size;
+
+
+/*
+ * visus::power_overwhelming::detail::cupti_kernel_tracer::instance
+ */
+visus::power_overwhelming::detail::cupti_kernel_tracer&
+visus::power_overwhelming::detail::cupti_kernel_tracer::instance(void) {
+    static cupti_kernel_tracer retval;
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::cupti_kernel_tracer::start
+ */
+void visus::power_overwhelming::detail::cupti_kernel_tracer::start(void) {
+    {
+        std::lock_guard<decltype(this->_lock)> l(this->_lock);
+        this->_clock.reset(new instrument_clock());
+        this->_kernels.clear();
+        this->_name_indices.clear();
+        this->_names.clear();
+    }
+
+    this->_dropped.store(0, std::memory_order_relaxed);
+    this->synchronise();
+
+    throw_on_cupti_error(::cuptiActivityRegisterCallbacks(
+        on_buffer_requested, on_buffer_completed));
+    throw_on_cupti_error(::cuptiActivityEnable(
+        CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::cupti_kernel_tracer::stop
+ */
+void visus::power_overwhelming::detail::cupti_kernel_tracer::stop(
+        _Inout_ kernel_energy_integrator& dst,
+        _In_ const timestamp_resolution resolution) {
+    // Disable the activity first such that the flush delivers the last
+    // records, including the ones in buffers that are not full yet.
+    ::cuptiActivityDisable(CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL);
+    ::cuptiActivityFlushAll(CUPTI_ACTIVITY_FLAG_FLUSH_FORCED);
+    this->synchronise();
+
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    for (auto& k : this->_kernels) {
+        // The clock works in units of 100 ns like the timestamps of the host.
+        const auto begin = this->_clock->to_host(static_cast<timestamp_type>(
+            k.begin / 100));
+        const auto end = this->_clock->to_host(static_cast<timestamp_type>(
+            k.end / 100));
+        dst.push_kernel(this->_names[k.name].c_str(),
+            convert(begin, resolution),
+            convert(end, resolution));
+    }
+
+    this->_kernels.clear();
+}
+
+
+/*
+ * ...::detail::cupti_kernel_tracer::on_buffer_completed
+ */
+void CUPTIAPI
+visus::power_overwhelming::detail::cupti_kernel_tracer::on_buffer_completed(
+        _In_ CUcontext context,
+        _In_ std::uint32_t stream,
+        _In_ std::uint8_t *buffer,
+        _In_ std::size_t size,
+        _In_ std::size_t valid) {
+    auto& that = instance();
+    CUpti_Activity *record = nullptr;
+
+    {
+        std::lock_guard<decltype(that._lock)> l(that._lock);
+        while (::cuptiActivityGetNextRecord(buffer, valid, &record)
+                == CUPTI_SUCCESS) {
+            const auto kind = record->kind;
+            if ((kind != CUPTI_ACTIVITY_KIND_KERNEL)
+                    && (kind != CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL)) {
+                continue;
+            }
+
+            // Note: The records have grown over the versions of CUPTI, but
+            // only by appending fields, so the begin, the end and the name
+            // are at the same place for all versions since 4.
+            auto kernel = reinterpret_cast<CUpti_ActivityKernel4 *>(record);
+
+            // The name is shared by all records of the same kernel, so we
+            // can intern it by its address.
+            const auto name = (kernel->name != nullptr) ? kernel->name : "";
+            auto it = that._name_indices.find(name);
+            if (it == that._name_indices.end()) {
+                it = that._name_indices.emplace(name,
+                    that._names.size()).first;
+                that._names.emplace_back(name);
+            }
+
+            kernel_type k;
+            k.begin = kernel->start;
+            k.end = kernel->end;
+            k.name = it->second;
+            that._kernels.push_back(k);
+        }
+    }
+
+    std::size_t dropped = 0;
+    if ((::cuptiActivityGetNumDroppedRecords(context, stream, &dropped)
+            == CUPTI_SUCCESS) && (dropped > 0)) {
+        that._dropped.fetch_add(dropped, std::memory_order_relaxed);
+    }
+
+    ::free(buffer);
+
+    // Completed buffers are a cheap opportunity to refine the mapping of the
+    // clocks over the whole recording.
+    that.synchronise();
+}
+
+
+/*
+ * ...::detail::cupti_kernel_tracer::on_buffer_requested
+ */
+void CUPTIAPI
+visus::power_overwhelming::detail::cupti_kernel_tracer::on_buffer_requested(
+        _Out_ std::uint8_t **buffer,
+        _Out_ std::size_t *size,
+        _Out_ std::size_t *max_records) {
+    assert(buffer != nullptr);
+    assert(size != nullptr);
+    assert(max_records != nullptr);
+    // Note: CUPTI requires the buffers to be aligned to eight bytes, which
+    // is guaranteed by malloc.
+    *buffer = static_cast<std::uint8_t *>(::malloc(buffer_size));
+    *size = (*buffer != nullptr) ? buffer_size : 0;
+    // Fill the buffer with as many records as fit.
+    *max_records = 0;
+}
+
+
+/*
+ * ...::detail::cupti_kernel_tracer::cupti_kernel_tracer
+ */
+visus::power_overwhelming::detail::cupti_kernel_tracer::cupti_kernel_tracer(
+    void) : _clock(new instrument_clock()), _dropped(0) { }
+
+
+/*
+ * visus::power_overwhelming::detail::cupti_kernel_tracer::synchronise
+ */
+void visus::power_overwhelming::detail::cupti_kernel_tracer::synchronise(
+        void) {
+    std::uint64_t cupti = 0;
+
+    const auto request = create_timestamp(
+        timestamp_resolution::hundred_nanoseconds);
+    const auto result = ::cuptiGetTimestamp(&cupti);
+    const auto response = create_timestamp(
+        timestamp_resolution::hundred_nanoseconds);
+
+    if (result == CUPTI_SUCCESS) {
+        this->_clock->update(request, static_cast<timestamp_type>(cupti / 100),
+            response);
+    }
+}
+#endif /* defined(POWER_OVERWHELMING_WITH_CUPTI) */
@@ -0,0 +1,139 @@
+﻿// <copyright file="cupti_kernel_tracer.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#if defined(POWER_OVERWHELMING_WITH_CUPTI)
+#include <atomic>
+#include <cinttypes>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <cupti.h>
+
+#include "power_overwhelming/timestamp_resolution.h"
+
+#include "instrument_clock.h"
+#include "kernel_energy.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Records the execution of CUDA kernels via the activity API of CUPTI.
+    /// </summary>
+    /// <remarks>
+    /// <para>CUPTI delivers the activity records asynchronously in buffers
+    /// that the tracer provides on request, so the application is never
+    /// synchronised with the GPU for tracing its kernels. The callbacks only
+    /// copy the name and the begin and end of each kernel, which is all that
+    /// is needed to attribute the energy.</para>
+    /// <para>The timestamps of CUPTI are in nanoseconds on a clock of its
+    /// own. The tracer maps them to the clock of the host using an
+    /// <see cref="instrument_clock" />, which is updated with the time of
+    /// CUPTI whenever a buffer completes.</para>
+    /// <para>The callbacks of CUPTI are global for the process, wherefore
+    /// there is only a single tracer.</para>
+    /// </remarks>
+    class cupti_kernel_tracer final {
+
+    public:
+
+        /// <summary>
+        /// The size of the buffers provided to CUPTI in bytes.
+        /// </summary>
+        static constexpr std::size_t buffer_size = 8 * 1024 * 1024;
+
+        /// <summary>
+        /// Gets the only instance of the class.
+        /// </summary>
+        /// <returns>The tracer.</returns>
+        static cupti_kernel_tracer& instance(void);
+
+        cupti_kernel_tracer(const cupti_kernel_tracer&) = delete;
+
+        /// <summary>
+        /// Answer the number of activity records CUPTI has dropped, because
+        /// it could not obtain a buffer in time.
+        /// </summary>
+        /// <returns>The number of records dropped since the last call to
+        /// <see cref="start" />.</returns>
+        inline std::uint64_t dropped(void) const noexcept {
+            return this->_dropped.load(std::memory_order_relaxed);
+        }
+
+        /// <summary>
+        /// Discards all kernels recorded so far and starts tracing the
+        /// kernels of all CUDA contexts.
+        /// </summary>
+        /// <exception cref="std::runtime_error">If CUPTI could not be
+        /// initialised.</exception>
+        void start(void);
+
+        /// <summary>
+        /// Flushes all pending activity records and stops tracing.
+        /// </summary>
+        /// <remarks>
+        /// All kernels recorded since the last call to <see cref="start" />
+        /// are passed to <paramref name="dst" /> with timestamps in the
+        /// given resolution on the clock of the host.
+        /// </remarks>
+        /// <param name="dst">The integrator receiving the kernels.</param>
+        /// <param name="resolution">The resolution of the timestamps used by
+        /// <paramref name="dst" />.</param>
+        void stop(_Inout_ kernel_energy_integrator& dst,
+            _In_ const timestamp_resolution resolution);
+
+        cupti_kernel_tracer& operator =(const cupti_kernel_tracer&) = delete;
+
+    private:
+
+        /// <summary>
+        /// A single execution of a kernel in CUPTI time.
+        /// </summary>
+        struct kernel_type {
+            std::uint64_t begin;
+            std::uint64_t end;
+            std::size_t name;
+        };
+
+        /// <summary>
+        /// Receives a buffer full of activity records from CUPTI.
+        /// </summary>
+        static void CUPTIAPI on_buffer_completed(_In_ CUcontext context,
+            _In_ std::uint32_t stream, _In_ std::uint8_t *buffer,
+            _In_ std::size_t size, _In_ std::size_t valid);
+
+        /// <summary>
+        /// Provides CUPTI with an empty buffer for activity records.
+        /// </summary>
+        static void CUPTIAPI on_buffer_requested(
+            _Out_ std::uint8_t **buffer, _Out_ std::size_t *size,
+            _Out_ std::size_t *max_records);
+
+        cupti_kernel_tracer(void);
+
+        /// <summary>
+        /// Records the current time of CUPTI in <see cref="_clock" />.
+        /// </summary>
+        void synchronise(void);
+
+        std::unique_ptr<instrument_clock> _clock;
+        std::atomic<std::uint64_t> _dropped;
+        std::vector<kernel_type> _kernels;
+        std::mutex _lock;
+        std::unordered_map<const char *, std::size_t> _name_indices;
+        std::vector<std::string> _names;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+#endif /* defined(POWER_OVERWHELMING_WITH_CUPTI) */
@@ -0,0 +1,46 @@
+﻿// <copyright file="dcgm_exception.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "dcgm_exception.h"
+
+#if defined(POWER_OVERWHELMING_WITH_DCGM)
+#include <sstream>
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    static std::string dcgm_message(const dcgmReturn_t code) {
+        std::stringstream stream;
+        // Note: We cannot use errorString() here, because the exception might
+        // be raised while the library itself is being initialised.
+        stream << "The DCGM call failed with error code " << code << ".";
+        return stream.str();
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::dcgm_exception::check
+ */
+void visus::power_overwhelming::dcgm_exception::check(const value_type code) {
+    if (code != DCGM_ST_OK) {
+        throw dcgm_exception(code);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::dcgm_exception::dcgm_exception
+ */
+visus::power_overwhelming::dcgm_exception::dcgm_exception(
+        const value_type code)
+    : std::runtime_error(detail::dcgm_message(code)), _code(code) { }
+
+#endif /* defined(POWER_OVERWHELMING_WITH_DCGM) */
@@ -0,0 +1,62 @@
+﻿// <copyright file="dcgm_exception.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#if defined(POWER_OVERWHELMING_WITH_DCGM)
+#include <stdexcept>
+#include <string>
+
+#include <dcgm_agent.h>
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// An exception representing an error reported by the NVIDIA Data Center
+    /// GPU Manager.
+    /// </summary>
+    class dcgm_exception : public std::runtime_error {
+
+    public:
+
+        /// <summary>
+        /// The type of the status code.
+        /// </summary>
+        typedef ::dcgmReturn_t value_type;
+
+        /// <summary>
+        /// Throws a <see cref="dcgm_exception" /> if <paramref name="code" />
+        /// does not indicate success.
+        /// </summary>
+        /// <param name="code">The status code to be checked.</param>
+        /// <exception cref="dcgm_exception">If <paramref name="code" /> is
+        /// not <c>DCGM_ST_OK</c>.</exception>
+        static void check(const value_type code);
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="code">The status code reported by DCGM.</param>
+        dcgm_exception(const value_type code);
+
+        /// <summary>
+        /// Answer the status code reported by DCGM.
+        /// </summary>
+        /// <returns>The status code.</returns>
+        value_type code(void) const noexcept {
+            return this->_code;
+        }
+
+    private:
+
+        value_type _code;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+#endif /* defined(POWER_OVERWHELMING_WITH_DCGM) */
@@ -0,0 +1,54 @@
+﻿// <copyright file="dcgm_library.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "dcgm_library.h"
+
+#if defined(POWER_OVERWHELMING_WITH_DCGM)
+#include "dcgm_exception.h"
+
+
+#define __POWER_OVERWHELMING_GET_DCGM_FUNC(n) \
+    this->n = this->get_function<decltype(this->n)>(#n)
+
+
+/*
+ * visus::power_overwhelming::detail::dcgm_library::instance
+ */
+const visus::power_overwhelming::detail::dcgm_library&
+visus::power_overwhelming::detail::dcgm_library::instance(void) {
+    static const dcgm_library instance;
+    return instance;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::dcgm_library::dcgm_library
+ */
+visus::power_overwhelming::detail::dcgm_library::dcgm_library(void)
+        : library_base("libdcgm.so.4", "libdcgm.so.3", "libdcgm.so") {
+    __POWER_OVERWHELMING_GET_DCGM_FUNC(dcgmConnect_v2);
+    __POWER_OVERWHELMING_GET_DCGM_FUNC(dcgmDisconnect);
+    __POWER_OVERWHELMING_GET_DCGM_FUNC(dcgmFieldGroupCreate);
+    __POWER_OVERWHELMING_GET_DCGM_FUNC(dcgmFieldGroupDestroy);
+    __POWER_OVERWHELMING_GET_DCGM_FUNC(dcgmGetAllSupportedDevices);
+    __POWER_OVERWHELMING_GET_DCGM_FUNC(dcgmGetDeviceAttributes);
+    __POWER_OVERWHELMING_GET_DCGM_FUNC(dcgmGetLatestValues_v2);
+    __POWER_OVERWHELMING_GET_DCGM_FUNC(dcgmGroupAddDevice);
+    __POWER_OVERWHELMING_GET_DCGM_FUNC(dcgmGroupCreate);
+    __POWER_OVERWHELMING_GET_DCGM_FUNC(dcgmGroupDestroy);
+    __POWER_OVERWHELMING_GET_DCGM_FUNC(dcgmInit);
+    __POWER_OVERWHELMING_GET_DCGM_FUNC(dcgmShutdown);
+    __POWER_OVERWHELMING_GET_DCGM_FUNC(dcgmStartEmbedded);
+    __POWER_OVERWHELMING_GET_DCGM_FUNC(dcgmStopEmbedded);
+    __POWER_OVERWHELMING_GET_DCGM_FUNC(dcgmUnwatchFields);
+    __POWER_OVERWHELMING_GET_DCGM_FUNC(dcgmWatchFields);
+
+    // DCGM must be initialised once per process before connecting to a host
+    // engine. Like for Level Zero, we never shut it down, because sessions
+    // might be alive until the process exits.
+    dcgm_exception::check(this->dcgmInit());
+}
+
+#endif /* defined(POWER_OVERWHELMING_WITH_DCGM) */
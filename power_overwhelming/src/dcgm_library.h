@@ -0,0 +1,71 @@
+﻿// <copyright file="dcgm_library.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#if defined(POWER_OVERWHELMING_WITH_DCGM)
+#include <dcgm_agent.h>
+
+#include "library_base.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+/// <summary>
+/// Declares a function pointer for the DCGM function <paramref name="f" />.
+/// </summary>
+#define __POWER_OVERWHELMING_DCGM_FUNC(f) decltype(&::f) f = nullptr
+
+    /// <summary>
+    /// Wraps the NVIDIA Data Center GPU Manager, which is loaded at runtime
+    /// such that the library does not depend on it being installed.
+    /// </summary>
+    class dcgm_library final : library_base {
+
+    public:
+
+        /// <summary>
+        /// Gets the only instance of the class, which is initialised on first
+        /// use.
+        /// </summary>
+        /// <returns>The only instance of the library.</returns>
+        /// <exception cref="std::system_error">If the library could not be
+        /// loaded.</exception>
+        /// <exception cref="dcgm_exception">If DCGM could not be initialised.
+        /// </exception>
+        static const dcgm_library& instance(void);
+
+        __POWER_OVERWHELMING_DCGM_FUNC(dcgmConnect_v2);
+        __POWER_OVERWHELMING_DCGM_FUNC(dcgmDisconnect);
+        __POWER_OVERWHELMING_DCGM_FUNC(dcgmFieldGroupCreate);
+        __POWER_OVERWHELMING_DCGM_FUNC(dcgmFieldGroupDestroy);
+        __POWER_OVERWHELMING_DCGM_FUNC(dcgmGetAllSupportedDevices);
+        __POWER_OVERWHELMING_DCGM_FUNC(dcgmGetDeviceAttributes);
+        __POWER_OVERWHELMING_DCGM_FUNC(dcgmGetLatestValues_v2);
+        __POWER_OVERWHELMING_DCGM_FUNC(dcgmGroupAddDevice);
+        __POWER_OVERWHELMING_DCGM_FUNC(dcgmGroupCreate);
+        __POWER_OVERWHELMING_DCGM_FUNC(dcgmGroupDestroy);
+        __POWER_OVERWHELMING_DCGM_FUNC(dcgmInit);
+        __POWER_OVERWHELMING_DCGM_FUNC(dcgmShutdown);
+        __POWER_OVERWHELMING_DCGM_FUNC(dcgmStartEmbedded);
+        __POWER_OVERWHELMING_DCGM_FUNC(dcgmStopEmbedded);
+        __POWER_OVERWHELMING_DCGM_FUNC(dcgmUnwatchFields);
+        __POWER_OVERWHELMING_DCGM_FUNC(dcgmWatchFields);
+
+    private:
+
+        dcgm_library(void);
+
+    };
+
+#undef __POWER_OVERWHELMING_DCGM_FUNC
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+#endif /* defined(POWER_OVERWHELMING_WITH_DCGM) */
@@ -0,0 +1,298 @@
+﻿// <copyright file="dcgm_sensor.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/dcgm_sensor.h"
+
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "dcgm_sensor_impl.h"
+#include "timestamp.h"
+
+
+/*
+ * visus::power_overwhelming::dcgm_sensor::channel_energy
+ */
+constexpr std::size_t visus::power_overwhelming::dcgm_sensor::channel_energy;
+
+
+/*
+ * visus::power_overwhelming::dcgm_sensor::channel_memory_clock
+ */
+constexpr std::size_t
+visus::power_overwhelming::dcgm_sensor::channel_memory_clock;
+
+
+/*
+ * visus::power_overwhelming::dcgm_sensor::channel_power
+ */
+constexpr std::size_t visus::power_overwhelming::dcgm_sensor::channel_power;
+
+
+/*
+ * visus::power_overwhelming::dcgm_sensor::channel_sm_clock
+ */
+constexpr std::size_t
+visus::power_overwhelming::dcgm_sensor::channel_sm_clock;
+
+
+/*
+ * visus::power_overwhelming::dcgm_sensor::channel_utilisation
+ */
+constexpr std::size_t
+visus::power_overwhelming::dcgm_sensor::channel_utilisation;
+
+
+/*
+ * visus::power_overwhelming::dcgm_sensor::default_update_interval
+ */
+constexpr visus::power_overwhelming::sensor::microseconds_type
+visus::power_overwhelming::dcgm_sensor::default_update_interval;
+
+
+/*
+ * visus::power_overwhelming::dcgm_sensor::for_all
+ */
+std::size_t visus::power_overwhelming::dcgm_sensor::for_all(
+        _Out_writes_opt_(cnt_sensors) dcgm_sensor *out_sensors,
+        _In_ const std::size_t cnt_sensors) {
+    return for_all(out_sensors, cnt_sensors, nullptr,
+        default_update_interval);
+}
+
+
+/*
+ * visus::power_overwhelming::dcgm_sensor::for_all
+ */
+std::size_t visus::power_overwhelming::dcgm_sensor::for_all(
+        _Out_writes_opt_(cnt_sensors) dcgm_sensor *out_sensors,
+        _In_ const std::size_t cnt_sensors,
+        _In_opt_z_ const char *host,
+        _In_ const microseconds_type update_interval) {
+    std::size_t retval = 0;
+
+#if defined(POWER_OVERWHELMING_WITH_DCGM)
+    try {
+        // The session is shared, so all sensors created below query the host
+        // engine together.
+        auto session = detail::dcgm_session::create(
+            (host != nullptr) ? host : "",
+            std::chrono::microseconds(update_interval));
+        assert(session != nullptr);
+
+        for (auto g : session->gpus()) {
+            if ((out_sensors != nullptr) && (retval < cnt_sensors)) {
+                auto& sensor = out_sensors[retval];
+                assert(sensor._impl != nullptr);
+                sensor._impl->set(session, g);
+            }
+
+            ++retval;
+        }
+    } catch (const std::runtime_error&) {
+        // DCGM is not installed or no host engine could be started, which is
+        // not fatal, there are just no sensors of this type.
+    }
+#endif /* defined(POWER_OVERWHELMING_WITH_DCGM) */
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::dcgm_sensor::for_gpu
+ */
+visus::power_overwhelming::dcgm_sensor
+visus::power_overwhelming::dcgm_sensor::for_gpu(
+        _In_ const gpu_type gpu,
+        _In_opt_z_ const char *host,
+        _In_ const microseconds_type update_interval) {
+#if defined(POWER_OVERWHELMING_WITH_DCGM)
+    auto session = detail::dcgm_session::create(
+        (host != nullptr) ? host : "",
+        std::chrono::microseconds(update_interval));
+    assert(session != nullptr);
+
+    dcgm_sensor retval;
+    assert(retval._impl != nullptr);
+    retval._impl->set(session, gpu);
+    return retval;
+
+#else /* defined(POWER_OVERWHELMING_WITH_DCGM) */
+    throw std::runtime_error("The library has been built without support for "
+        "DCGM.");
+#endif /* defined(POWER_OVERWHELMING_WITH_DCGM) */
+}
+
+
+/*
+ * visus::power_overwhelming::dcgm_sensor::dcgm_sensor
+ */
+visus::power_overwhelming::dcgm_sensor::dcgm_sensor(void)
+    : _impl(new detail::dcgm_sensor_impl()) { }
+
+
+/*
+ * visus::power_overwhelming::dcgm_sensor::~dcgm_sensor
+ */
+visus::power_overwhelming::dcgm_sensor::~dcgm_sensor(void) {
+    // Make sure that the sampler does not use the sensor anymore.
+    this->sample_channels(nullptr);
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::dcgm_sensor::channel
+ */
+visus::power_overwhelming::sensor_channel
+visus::power_overwhelming::dcgm_sensor::channel(
+        _In_ const std::size_t index) const {
+    this->check_not_disposed();
+
+    const auto name = this->_impl->channel_names[index].c_str();
+    switch (index) {
+        case channel_power:
+            return sensor_channel(name, L"W", measurement_quantity::power);
+
+        case channel_energy:
+            return sensor_channel(name, L"J", measurement_quantity::other);
+
+        case channel_sm_clock:
+        case channel_memory_clock:
+            return sensor_channel(name, L"MHz", measurement_quantity::other);
+
+        case channel_utilisation:
+            return sensor_channel(name, L"%", measurement_quantity::other);
+
+        default:
+            throw std::out_of_range("The channel index is out of range.");
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::dcgm_sensor::channels
+ */
+std::size_t visus::power_overwhelming::dcgm_sensor::channels(
+        void) const noexcept {
+    return detail::dcgm_sensor_impl::channel_count;
+}
+
+
+/*
+ * visus::power_overwhelming::dcgm_sensor::gpu
+ */
+visus::power_overwhelming::dcgm_sensor::gpu_type
+visus::power_overwhelming::dcgm_sensor::gpu(void) const {
+    this->check_not_disposed();
+    return this->_impl->gpu;
+}
+
+
+/*
+ * visus::power_overwhelming::dcgm_sensor::host
+ */
+_Ret_z_ const char *visus::power_overwhelming::dcgm_sensor::host(
+        void) const {
+    this->check_not_disposed();
+    return this->_impl->host.c_str();
+}
+
+
+/*
+ * visus::power_overwhelming::dcgm_sensor::name
+ */
+_Ret_maybenull_z_
+const wchar_t *visus::power_overwhelming::dcgm_sensor::name(
+        void) const noexcept {
+    return (this->_impl != nullptr)
+        ? this->_impl->sensor_name.c_str()
+        : nullptr;
+}
+
+
+/*
+ * visus::power_overwhelming::dcgm_sensor::native_interval
+ */
+visus::power_overwhelming::sensor::microseconds_type
+visus::power_overwhelming::dcgm_sensor::native_interval(void) const {
+    this->check_not_disposed();
+#if defined(POWER_OVERWHELMING_WITH_DCGM)
+    return this->_impl->session->update_interval().count();
+#else /* defined(POWER_OVERWHELMING_WITH_DCGM) */
+    return sensor::native_interval();
+#endif /* defined(POWER_OVERWHELMING_WITH_DCGM) */
+}
+
+
+/*
+ * visus::power_overwhelming::dcgm_sensor::operator =
+ */
+visus::power_overwhelming::dcgm_sensor&
+visus::power_overwhelming::dcgm_sensor::operator =(
+        _In_ dcgm_sensor&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        try {
+            this->sample_channels(nullptr);
+        } catch (...) { /* The sampler is stopped anyway. */ }
+
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::dcgm_sensor::operator bool
+ */
+visus::power_overwhelming::dcgm_sensor::operator bool(void) const noexcept {
+#if defined(POWER_OVERWHELMING_WITH_DCGM)
+    return ((this->_impl != nullptr) && (this->_impl->session != nullptr));
+#else /* defined(POWER_OVERWHELMING_WITH_DCGM) */
+    return false;
+#endif /* defined(POWER_OVERWHELMING_WITH_DCGM) */
+}
+
+
+/*
+ * visus::power_overwhelming::dcgm_sensor::sample_channels_sync
+ */
+visus::power_overwhelming::dcgm_sensor::timestamp_type
+visus::power_overwhelming::dcgm_sensor::sample_channels_sync(
+        _Out_writes_(channels()) value_type *dst,
+        _In_ const timestamp_resolution resolution) const {
+#if defined(POWER_OVERWHELMING_WITH_DCGM)
+    assert(dst != nullptr);
+    assert(this->_impl != nullptr);
+    assert(this->_impl->session != nullptr);
+    double values[detail::dcgm_session::field_count];
+
+    const auto time = this->_impl->session->read(this->_impl->gpu, values);
+
+    // DCGM reports the energy in millijoules, all other fields are in the
+    // units of their channels already.
+    values[channel_energy] /= 1000.0;
+
+    for (std::size_t i = 0; i < detail::dcgm_sensor_impl::channel_count; ++i) {
+        dst[i] = std::isnan(values[i])
+            ? measurement_data::invalid_value
+            : static_cast<value_type>(values[i]);
+    }
+
+    return detail::convert(time, resolution);
+
+#else /* defined(POWER_OVERWHELMING_WITH_DCGM) */
+    throw_disposed();
+    return 0;
+#endif /* defined(POWER_OVERWHELMING_WITH_DCGM) */
+}
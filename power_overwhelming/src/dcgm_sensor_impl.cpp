@@ -0,0 +1,45 @@
+﻿// <copyright file="dcgm_sensor_impl.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "dcgm_sensor_impl.h"
+
+#include <cassert>
+
+#include "power_overwhelming/convert_string.h"
+
+
+/*
+ * visus::power_overwhelming::detail::dcgm_sensor_impl::channel_count
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::dcgm_sensor_impl::channel_count;
+
+
+#if defined(POWER_OVERWHELMING_WITH_DCGM)
+/*
+ * visus::power_overwhelming::detail::dcgm_sensor_impl::set
+ */
+void visus::power_overwhelming::detail::dcgm_sensor_impl::set(
+        _In_ const dcgm_session::session_type& session,
+        _In_ const dcgm_sensor::gpu_type gpu) {
+    static const wchar_t *const suffixes[channel_count] = {
+        L"/power", L"/energy", L"/sm_clock", L"/memory_clock", L"/utilisation"
+    };
+    assert(session != nullptr);
+
+    const auto device_name = power_overwhelming::convert_string<wchar_t>(
+        session->device_name(gpu));
+    const auto bus_id = power_overwhelming::convert_string<wchar_t>(session->bus_id(gpu));
+
+    this->gpu = gpu;
+    this->host = session->host();
+    this->sensor_name = L"DCGM/" + device_name + L"/" + bus_id;
+    this->session = session;
+
+    for (std::size_t i = 0; i < channel_count; ++i) {
+        this->channel_names[i] = this->sensor_name + suffixes[i];
+    }
+}
+#endif /* defined(POWER_OVERWHELMING_WITH_DCGM) */
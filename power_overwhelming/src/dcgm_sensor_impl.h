@@ -0,0 +1,76 @@
+﻿// <copyright file="dcgm_sensor_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <string>
+
+#include "power_overwhelming/dcgm_sensor.h"
+
+#include "dcgm_session.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Private data container for the <see cref="dcgm_sensor" />.
+    /// </summary>
+    struct dcgm_sensor_impl final {
+
+        /// <summary>
+        /// The number of channels of a sensor.
+        /// </summary>
+        static constexpr std::size_t channel_count = 5;
+
+        /// <summary>
+        /// The names of the <see cref="channel_count" /> channels.
+        /// </summary>
+        std::wstring channel_names[channel_count];
+
+        /// <summary>
+        /// The DCGM identifier of the GPU.
+        /// </summary>
+        dcgm_sensor::gpu_type gpu;
+
+        /// <summary>
+        /// The address of the host engine as requested by the user.
+        /// </summary>
+        std::string host;
+
+        /// <summary>
+        /// The name of the sensor.
+        /// </summary>
+        std::wstring sensor_name;
+
+#if defined(POWER_OVERWHELMING_WITH_DCGM)
+        /// <summary>
+        /// The connection to the host engine shared by all sensors with the
+        /// same settings.
+        /// </summary>
+        dcgm_session::session_type session;
+
+        static_assert(channel_count == dcgm_session::field_count, "The "
+            "channels of a sensor must match the watched fields.");
+#endif /* defined(POWER_OVERWHELMING_WITH_DCGM) */
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        inline dcgm_sensor_impl(void) : gpu(0) { }
+
+#if defined(POWER_OVERWHELMING_WITH_DCGM)
+        /// <summary>
+        /// Binds the sensor to the given GPU of the given session.
+        /// </summary>
+        void set(_In_ const dcgm_session::session_type& session,
+            _In_ const dcgm_sensor::gpu_type gpu);
+#endif /* defined(POWER_OVERWHELMING_WITH_DCGM) */
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,336 @@
+﻿// <copyright file="dcgm_session.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "dcgm_session.h"
+
+#if defined(POWER_OVERWHELMING_WITH_DCGM)
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+
+#include "dcgm_exception.h"
+#include "dcgm_library.h"
+
+
+/*
+ * visus::power_overwhelming::detail::dcgm_session::field_count
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::dcgm_session::field_count;
+
+
+/*
+ * visus::power_overwhelming::detail::dcgm_session::fields
+ */
+const unsigned short
+visus::power_overwhelming::detail::dcgm_session::fields[field_count] = {
+    DCGM_FI_DEV_POWER_USAGE,
+    DCGM_FI_DEV_TOTAL_ENERGY_CONSUMPTION,
+    DCGM_FI_DEV_SM_CLOCK,
+    DCGM_FI_DEV_MEM_CLOCK,
+    DCGM_FI_DEV_GPU_UTIL
+};
+
+
+/*
+ * visus::power_overwhelming::detail::dcgm_session::max_reuse
+ */
+constexpr std::chrono::microseconds
+visus::power_overwhelming::detail::dcgm_session::max_reuse;
+
+
+/*
+ * visus::power_overwhelming::detail::dcgm_session::create
+ */
+visus::power_overwhelming::detail::dcgm_session::session_type
+visus::power_overwhelming::detail::dcgm_session::create(
+        _In_ const std::string& host,
+        _In_ const interval_type update_interval) {
+    const key_type key(host, update_interval.count());
+    std::lock_guard<decltype(_lock)> l(_lock);
+
+    auto it = _instances.find(key);
+    if (it != _instances.end()) {
+        auto retval = it->second.lock();
+        if (retval != nullptr) {
+            return retval;
+        }
+    }
+
+    // Unlike Level Zero devices, sessions are not kept alive forever, because
+    // the watches they hold cause load on the host engine.
+    auto retval = std::make_shared<dcgm_session>(host, update_interval);
+    _instances[key] = retval;
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::dcgm_session::dcgm_session
+ */
+visus::power_overwhelming::detail::dcgm_session::dcgm_session(
+        _In_ const std::string& host,
+        _In_ const interval_type update_interval)
+    : _consumed(0), _embedded(false), _field_group(0), _group(0), _handle(0),
+        _host(host), _update_interval(update_interval) {
+    auto& dcgm = dcgm_library::instance();
+
+    if (this->_update_interval.count() < 1) {
+        throw std::invalid_argument("The update interval of DCGM must be "
+            "positive.");
+    }
+
+    {
+        // Prefer the host engine of the node, which the cluster monitoring is
+        // using already, and fall back to an embedded one only if there is
+        // none and the user has not asked for a specific one.
+        dcgmConnectV2Params_t params { };
+        params.version = dcgmConnectV2Params_version;
+        const auto address = this->_host.empty()
+            ? "127.0.0.1"
+            : this->_host.c_str();
+        const auto status = dcgm.dcgmConnect_v2(address, &params,
+            &this->_handle);
+
+        if ((status != DCGM_ST_OK) && this->_host.empty()) {
+            dcgm_exception::check(dcgm.dcgmStartEmbedded(
+                DCGM_OPERATION_MODE_AUTO, &this->_handle));
+            this->_embedded = true;
+        } else {
+            dcgm_exception::check(status);
+        }
+    }
+
+    try {
+        unsigned int gpus[DCGM_MAX_NUM_DEVICES];
+        int cnt = 0;
+        dcgm_exception::check(dcgm.dcgmGetAllSupportedDevices(this->_handle,
+            gpus, &cnt));
+        // The consumption flags are a bit mask, so we cannot handle more
+        // than 64 GPUs, which DCGM does not support anyway.
+        cnt = (std::min)(cnt, std::numeric_limits<std::uint64_t>::digits);
+        this->_gpus.assign(gpus, gpus + (std::max)(cnt, 0));
+        this->_values.resize(this->_gpus.size() * field_count,
+            std::numeric_limits<double>::quiet_NaN());
+
+        if (!this->_gpus.empty()) {
+            char group_name[] = "power_overwhelming";
+            dcgm_exception::check(dcgm.dcgmGroupCreate(this->_handle,
+                DCGM_GROUP_EMPTY, group_name, &this->_group));
+
+            for (auto g : this->_gpus) {
+                dcgm_exception::check(dcgm.dcgmGroupAddDevice(this->_handle,
+                    this->_group, g));
+            }
+
+            // Field groups are named per host engine, so the name must be
+            // unique among all sessions of all processes on the node.
+            auto field_group_name = "power_overwhelming_"
+                + std::to_string(reinterpret_cast<std::uintptr_t>(this));
+            unsigned short field_ids[field_count];
+            std::copy(fields, fields + field_count, field_ids);
+            dcgm_exception::check(dcgm.dcgmFieldGroupCreate(this->_handle,
+                static_cast<int>(field_count), field_ids,
+                &field_group_name[0], &this->_field_group));
+
+            // We only ever need the latest value, so the host engine does not
+            // need to keep more than a few samples.
+            const auto max_age = 10.0 * std::chrono::duration_cast<
+                std::chrono::duration<double>>(this->_update_interval).count();
+            dcgm_exception::check(dcgm.dcgmWatchFields(this->_handle,
+                this->_group, this->_field_group,
+                static_cast<long long>(this->_update_interval.count()),
+                max_age, 0));
+        }
+    } catch (...) {
+        this->close();
+        throw;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::dcgm_session::~dcgm_session
+ */
+visus::power_overwhelming::detail::dcgm_session::~dcgm_session(void) {
+    this->close();
+}
+
+
+
+/*
+ * visus::power_overwhelming::detail::dcgm_session::bus_id
+ */
+std::string visus::power_overwhelming::detail::dcgm_session::bus_id(
+        _In_ const gpu_type gpu) const {
+    auto& dcgm = dcgm_library::instance();
+    dcgmDeviceAttributes_t attributes { };
+    attributes.version = dcgmDeviceAttributes_version;
+    dcgm_exception::check(dcgm.dcgmGetDeviceAttributes(this->_handle, gpu,
+        &attributes));
+    return attributes.identifiers.pciBusId;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::dcgm_session::close
+ */
+void visus::power_overwhelming::detail::dcgm_session::close(void) noexcept {
+    auto& dcgm = dcgm_library::instance();
+
+    if (this->_field_group != 0) {
+        dcgm.dcgmUnwatchFields(this->_handle, this->_group,
+            this->_field_group);
+        dcgm.dcgmFieldGroupDestroy(this->_handle, this->_field_group);
+        this->_field_group = 0;
+    }
+
+    if (this->_group != 0) {
+        dcgm.dcgmGroupDestroy(this->_handle, this->_group);
+        this->_group = 0;
+    }
+
+    if (this->_handle != 0) {
+        if (this->_embedded) {
+            dcgm.dcgmStopEmbedded(this->_handle);
+        } else {
+            dcgm.dcgmDisconnect(this->_handle);
+        }
+        this->_handle = 0;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::dcgm_session::device_name
+ */
+std::string visus::power_overwhelming::detail::dcgm_session::device_name(
+        _In_ const gpu_type gpu) const {
+    auto& dcgm = dcgm_library::instance();
+    dcgmDeviceAttributes_t attributes { };
+    attributes.version = dcgmDeviceAttributes_version;
+    dcgm_exception::check(dcgm.dcgmGetDeviceAttributes(this->_handle, gpu,
+        &attributes));
+    return attributes.identifiers.deviceName;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::dcgm_session::read
+ */
+visus::power_overwhelming::detail::dcgm_session::time_point
+visus::power_overwhelming::detail::dcgm_session::read(
+        _In_ const gpu_type gpu,
+        _Out_writes_(field_count) double *dst) {
+    assert(dst != nullptr);
+    const auto index = this->index_of(gpu);
+    const auto bit = static_cast<std::uint64_t>(1) << index;
+    const auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<decltype(this->_read_lock)> l(this->_read_lock);
+    if (((this->_consumed & bit) != 0) || (now - this->_read_time > max_reuse)) {
+        // The GPU has already consumed the values of the last call or they are
+        // too old, so retrieve the values of all GPUs again.
+        auto& dcgm = dcgm_library::instance();
+        std::fill(this->_values.begin(), this->_values.end(),
+            std::numeric_limits<double>::quiet_NaN());
+        this->_time = time_point();
+        dcgm_exception::check(dcgm.dcgmGetLatestValues_v2(this->_handle,
+            this->_group, this->_field_group, &dcgm_session::on_values, this));
+
+        this->_consumed = 0;
+        this->_read_time = std::chrono::steady_clock::now();
+    }
+
+    this->_consumed |= bit;
+    std::copy_n(this->_values.begin() + index * field_count, field_count, dst);
+    return (this->_time != time_point())
+        ? this->_time
+        : std::chrono::system_clock::now();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::dcgm_session::on_values
+ */
+int visus::power_overwhelming::detail::dcgm_session::on_values(
+        _In_ dcgm_field_entity_group_t group,
+        _In_ dcgm_field_eid_t entity,
+        _In_reads_(cnt) dcgmFieldValue_v1 *values,
+        _In_ int cnt,
+        _In_opt_ void *context) {
+    assert(context != nullptr);
+    auto that = static_cast<dcgm_session *>(context);
+
+    if (group != DCGM_FE_GPU) {
+        return 0;
+    }
+
+    auto it = std::find(that->_gpus.begin(), that->_gpus.end(), entity);
+    if (it == that->_gpus.end()) {
+        return 0;
+    }
+
+    const auto offset = std::distance(that->_gpus.begin(), it) * field_count;
+    for (int i = 0; i < cnt; ++i) {
+        auto& v = values[i];
+        auto f = std::find(fields, fields + field_count, v.fieldId);
+        if ((f == fields + field_count) || (v.status != DCGM_ST_OK)) {
+            continue;
+        }
+
+        auto& dst = that->_values[offset + std::distance(fields, f)];
+        if (v.fieldType == DCGM_FT_DOUBLE) {
+            if (!DCGM_FP64_IS_BLANK(v.value.dbl)) {
+                dst = v.value.dbl;
+            }
+        } else if (v.fieldType == DCGM_FT_INT64) {
+            if (!DCGM_INT64_IS_BLANK(v.value.i64)) {
+                dst = static_cast<double>(v.value.i64);
+            }
+        }
+
+        // The timestamps of the host engine are in microseconds since the
+        // epoch of the Unix time.
+        const time_point time(std::chrono::microseconds(v.ts));
+        if (time > that->_time) {
+            that->_time = time;
+        }
+    }
+
+    return 0;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::dcgm_session::index_of
+ */
+std::size_t visus::power_overwhelming::detail::dcgm_session::index_of(
+        _In_ const gpu_type gpu) const {
+    auto it = std::find(this->_gpus.begin(), this->_gpus.end(), gpu);
+    if (it == this->_gpus.end()) {
+        throw std::invalid_argument("The specified GPU is not managed by the "
+            "DCGM host engine.");
+    }
+
+    return std::distance(this->_gpus.begin(), it);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::dcgm_session::_instances
+ */
+std::map<visus::power_overwhelming::detail::dcgm_session::key_type,
+    std::weak_ptr<visus::power_overwhelming::detail::dcgm_session>>
+visus::power_overwhelming::detail::dcgm_session::_instances;
+
+
+/*
+ * visus::power_overwhelming::detail::dcgm_session::_lock
+ */
+std::mutex visus::power_overwhelming::detail::dcgm_session::_lock;
+
+#endif /* defined(POWER_OVERWHELMING_WITH_DCGM) */
@@ -0,0 +1,204 @@
+﻿// <copyright file="dcgm_session.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#if defined(POWER_OVERWHELMING_WITH_DCGM)
+#include <chrono>
+#include <cinttypes>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <dcgm_agent.h>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A connection to a DCGM host engine which watches the fields of all
+    /// GPUs it manages.
+    /// </summary>
+    /// <remarks>
+    /// <para>The session connects to the host engine that is already running
+    /// on the node such that measurements share the watches of the cluster
+    /// monitoring rather than polling the driver a second time. If no host
+    /// engine is running locally, the session starts an embedded one.</para>
+    /// <para>All GPUs are put into a single group whose
+    /// <see cref="fields" /> are watched at the update interval of the
+    /// session. The latest values of all GPUs are retrieved in a single call,
+    /// and the session serves every GPU once from this call like the
+    /// <see cref="level_zero_device" /> does for its domains, such that
+    /// sensors sampled together cause only one round trip to the host
+    /// engine.</para>
+    /// <para>Sessions are shared by all sensors with the same host and
+    /// update interval via <see cref="create" />.</para>
+    /// </remarks>
+    class dcgm_session final {
+
+    public:
+
+        /// <summary>
+        /// The type of the DCGM identifier of a GPU.
+        /// </summary>
+        typedef unsigned int gpu_type;
+
+        /// <summary>
+        /// The type of the update interval.
+        /// </summary>
+        typedef std::chrono::microseconds interval_type;
+
+        /// <summary>
+        /// The type of a shared session.
+        /// </summary>
+        typedef std::shared_ptr<dcgm_session> session_type;
+
+        /// <summary>
+        /// The type used to store the point in time a value has been sampled
+        /// by the host engine.
+        /// </summary>
+        typedef std::chrono::system_clock::time_point time_point;
+
+        /// <summary>
+        /// The number of <see cref="fields" /> that are watched.
+        /// </summary>
+        static constexpr std::size_t field_count = 5;
+
+        /// <summary>
+        /// The identifiers of the watched fields, which are the board power
+        /// in Watts, the energy counter in millijoules, the SM and memory
+        /// clocks in MHz and the GPU utilisation in per cent.
+        /// </summary>
+        static const unsigned short fields[field_count];
+
+        /// <summary>
+        /// The maximum age of the cached values before all GPUs are queried
+        /// again, even if a GPU has not yet consumed its values.
+        /// </summary>
+        static constexpr std::chrono::microseconds max_reuse
+            = std::chrono::microseconds(1000);
+
+        /// <summary>
+        /// Gets a session for the given host engine and update interval,
+        /// which is shared with all other sensors using the same settings.
+        /// </summary>
+        /// <param name="host">The address of the host engine. If empty, the
+        /// local host engine or an embedded one is used.</param>
+        /// <param name="update_interval">The interval at which the host engine
+        /// updates the watched fields.</param>
+        /// <returns>The session.</returns>
+        /// <exception cref="std::system_error">If DCGM is not installed.
+        /// </exception>
+        /// <exception cref="dcgm_exception">If the connection or the watch
+        /// could not be established.</exception>
+        static session_type create(_In_ const std::string& host,
+            _In_ const interval_type update_interval);
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        dcgm_session(_In_ const std::string& host,
+            _In_ const interval_type update_interval);
+
+        dcgm_session(const dcgm_session&) = delete;
+
+        /// <summary>
+        /// Removes the watches and disconnects from the host engine.
+        /// </summary>
+        ~dcgm_session(void);
+
+        /// <summary>
+        /// Answer the PCI bus ID of the given GPU.
+        /// </summary>
+        std::string bus_id(_In_ const gpu_type gpu) const;
+
+        /// <summary>
+        /// Answer the product name of the given GPU.
+        /// </summary>
+        std::string device_name(_In_ const gpu_type gpu) const;
+
+        /// <summary>
+        /// Answer the identifiers of all GPUs in the group.
+        /// </summary>
+        inline const std::vector<gpu_type>& gpus(void) const noexcept {
+            return this->_gpus;
+        }
+
+        /// <summary>
+        /// Answer the address of the host engine.
+        /// </summary>
+        inline const std::string& host(void) const noexcept {
+            return this->_host;
+        }
+
+        /// <summary>
+        /// Retrieves the latest values of all <see cref="fields" /> of the
+        /// given GPU.
+        /// </summary>
+        /// <param name="gpu">The GPU to read.</param>
+        /// <param name="dst">Receives <see cref="field_count" /> values, which
+        /// are NaN if the host engine has not yet sampled them or if the GPU
+        /// does not support them.</param>
+        /// <returns>The point in time when the host engine sampled the most
+        /// recent of the values.</returns>
+        /// <exception cref="std::invalid_argument">If the GPU is not part of
+        /// the session.</exception>
+        /// <exception cref="dcgm_exception">If the values could not be
+        /// retrieved.</exception>
+        time_point read(_In_ const gpu_type gpu,
+            _Out_writes_(field_count) double *dst);
+
+        /// <summary>
+        /// Answer the interval at which the host engine updates the fields.
+        /// </summary>
+        inline interval_type update_interval(void) const noexcept {
+            return this->_update_interval;
+        }
+
+        dcgm_session& operator =(const dcgm_session&) = delete;
+
+    private:
+
+        typedef std::pair<std::string, interval_type::rep> key_type;
+
+        void close(void) noexcept;
+
+        static int on_values(_In_ dcgm_field_entity_group_t group,
+            _In_ dcgm_field_eid_t entity,
+            _In_reads_(cnt) dcgmFieldValue_v1 *values,
+            _In_ int cnt,
+            _In_opt_ void *context);
+
+        std::size_t index_of(_In_ const gpu_type gpu) const;
+
+        static std::map<key_type, std::weak_ptr<dcgm_session>> _instances;
+        static std::mutex _lock;
+
+        std::uint64_t _consumed;
+        bool _embedded;
+        dcgmFieldGrp_t _field_group;
+        std::vector<gpu_type> _gpus;
+        dcgmGpuGrp_t _group;
+        dcgmHandle_t _handle;
+        std::string _host;
+        std::mutex _read_lock;
+        time_point _time;
+        std::chrono::steady_clock::time_point _read_time;
+        interval_type _update_interval;
+        std::vector<double> _values;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+#endif /* defined(POWER_OVERWHELMING_WITH_DCGM) */
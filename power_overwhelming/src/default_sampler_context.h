@@ -5,16 +5,28 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
+#include <cinttypes>
+#include <condition_variable>
+#include <iterator>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <vector>
 
 #include "power_overwhelming/measurement.h"
 
-#include "thread_name.h"
+#include "adaptive_interval.h"
+#include "library_thread.h"
+#include "sampler_instrumentation.h"
+#include "sampler_scheduler.h"
+#include "sensor_name_registry.h"
+#include "sequence_tracker.h"
+#include "system_trace.h"
 
 
 namespace visus {
@@ -22,8 +34,36 @@ namespace power_overwhelming {
 namespace detail {
 
     /// <summary>
-    /// A context represents a thread that handles a specific sampling
-    /// interval.
+    /// Appends all samples that <paramref name="sensor" /> has buffered since
+    /// it was last drained to <paramref name="dst" />.
+    /// </summary>
+    /// <remarks>
+    /// This overload is selected for sensor implementations exposing a
+    /// <c>drain</c> method, which allows devices that record samples on their
+    /// own, like NVIDIA GPUs, to deliver all of them with their native
+    /// timestamps instead of a single reading per tick.
+    /// </remarks>
+    template<class TSensorImpl>
+    inline auto sample_into(_In_ const TSensorImpl& sensor,
+            _Inout_ std::vector<measurement_data>& dst, int)
+            -> decltype(sensor.drain(dst), void()) {
+        sensor.drain(dst);
+    }
+
+    /// <summary>
+    /// Appends a single sample of <paramref name="sensor" /> to
+    /// <paramref name="dst" />.
+    /// </summary>
+    template<class TSensorImpl>
+    inline void sample_into(_In_ const TSensorImpl& sensor,
+            _Inout_ std::vector<measurement_data>& dst, long) {
+        dst.push_back(sensor.sample());
+    }
+
+
+    /// <summary>
+    /// A context represents a task of the <see cref="sampler_scheduler" />
+    /// that handles a specific sampling interval.
     /// </summary>
     /// <remarks>
     /// This template is to be used as parameter to <see cref="sampler" />. The
@@ -37,10 +77,9 @@ namespace detail {
     struct default_sampler_context {
 
         /// <summary>
-        /// The type of the on-measurement callback and the user data pointer
-        /// to be passed to it.
+        /// The clock used to measure the reads of the sensors.
         /// </summary>
-        typedef std::pair<measurement_callback, void *> callback_type;
+        typedef sampler_instrumentation::clock_type clock_type;
 
         /// <summary>
         /// The type to express sampling intervals.
@@ -52,6 +91,276 @@ namespace detail {
         /// </summary>
         typedef TSensorImpl *sensor_type;
 
+        /// <summary>
+        /// Describes how the samples of a sensor are delivered to the user.
+        /// </summary>
+        struct registration {
+
+            /// <summary>
+            /// Adapts the interval of the context to the signal of the sensor
+            /// if the context has a <see cref="min_interval" />.
+            /// </summary>
+            /// <remarks>
+            /// The controller is only accessed by the sampler thread while the
+            /// sensor is in the active snapshot.
+            /// </remarks>
+            adaptive_interval adaptation;
+
+            /// <summary>
+            /// The batch of samples that have not yet been delivered to
+            /// <see cref="data_callback" />.
+            /// </summary>
+            /// <remarks>
+            /// The batch is only accessed by the sampler thread while the
+            /// sensor is in the active snapshot.
+            /// </remarks>
+            std::vector<measurement_data> batch;
+
+            /// <summary>
+            /// The number of samples in <see cref="batch" /> that cause the
+            /// batch to be delivered.
+            /// </summary>
+            std::size_t batch_size;
+
+            /// <summary>
+            /// The callback for individual samples, or <c>nullptr</c> if the
+            /// sensor is sampled in batches.
+            /// </summary>
+            measurement_callback callback;
+
+            /// <summary>
+            /// The number of ticks of the context that remain until the
+            /// registration receives the next reading.
+            /// </summary>
+            /// <remarks>
+            /// The countdown is only accessed by the sampler thread while the
+            /// sensor is in the active snapshot.
+            /// </remarks>
+            std::size_t countdown;
+
+            /// <summary>
+            /// The user-defined context pointer passed to the callback.
+            /// </summary>
+            void *context;
+
+            /// <summary>
+            /// The callback for batches of samples, or <c>nullptr</c> if the
+            /// samples are delivered one by one.
+            /// </summary>
+            measurement_data_callback data_callback;
+
+            /// <summary>
+            /// The registration receives the reading of every
+            /// <see cref="divisor" />-th tick of the context, which allows a
+            /// subscriber with a longer interval to share the reads of the
+            /// sensor with a faster one.
+            /// </summary>
+            std::size_t divisor;
+
+            /// <summary>
+            /// The interned name of the sensor.
+            /// </summary>
+            const wchar_t *name;
+
+            /// <summary>
+            /// The histogram of the time <c>sample</c> takes for the sensor,
+            /// which is owned by <see cref="instrumentation" />.
+            /// </summary>
+            sampler_instrumentation::histogram_type *sample_duration;
+
+            /// <summary>
+            /// The sequence number of the last sample delivered to the
+            /// registration.
+            /// </summary>
+            /// <remarks>
+            /// The samples are numbered per registration, such that a
+            /// subscriber with a <see cref="divisor" /> receives a contiguous
+            /// sequence. The counter is only accessed by the sampler thread
+            /// while the sensor is in the active snapshot.
+            /// </remarks>
+            measurement_data::sequence_type sequence;
+
+            /// <summary>
+            /// Invokes <see cref="data_callback" /> for all samples in
+            /// <see cref="batch" /> and clears the batch.
+            /// </summary>
+            inline void deliver(void) {
+                if (!this->batch.empty()) {
+                    assert(this->data_callback != nullptr);
+                    this->data_callback(this->name, this->batch.data(),
+                        this->batch.size(), this->context);
+                    this->batch.clear();
+                }
+            }
+        };
+
+        /// <summary>
+        /// The type that is used to store <see cref="registration" />s, which
+        /// are shared between the <see cref="sensors" /> and the snapshots.
+        /// </summary>
+        typedef std::shared_ptr<registration> registration_type;
+
+        /// <summary>
+        /// The type of the list of subscribers of a single sensor, all of
+        /// which are served from one read of the hardware.
+        /// </summary>
+        typedef std::vector<registration_type> subscribers_type;
+
+        /// <summary>
+        /// Tracks whether the reads of a sensor stay within their budget.
+        /// </summary>
+        /// <remarks>
+        /// The health is only accessed by the thread that currently owns the
+        /// sensor, which is either the sampler task or the
+        /// <see cref="isolation_thread" />, and by <see cref="transfer" />
+        /// while the sensor is handed over between them.
+        /// </remarks>
+        struct health_type {
+
+            /// <summary>
+            /// The current delay between two attempts to read an isolated
+            /// sensor.
+            /// </summary>
+            interval_type backoff;
+
+            /// <summary>
+            /// The number of consecutive good reads of an isolated sensor.
+            /// </summary>
+            std::size_t recovered;
+
+            /// <summary>
+            /// The point in time when an isolated sensor is read next.
+            /// </summary>
+            clock_type::time_point retry;
+
+            /// <summary>
+            /// The number of consecutive reads that failed or exceeded the
+            /// <see cref="interval" /> of the context.
+            /// </summary>
+            std::size_t strikes;
+        };
+
+        /// <summary>
+        /// The state of a sensor in the context.
+        /// </summary>
+        struct entry_type {
+
+            /// <summary>
+            /// The health of the sensor, which is shared with the snapshots.
+            /// </summary>
+            std::shared_ptr<health_type> health;
+
+            /// <summary>
+            /// Indicates whether the sensor has been moved to the
+            /// <see cref="isolation_thread" />.
+            /// </summary>
+            bool isolated;
+
+            /// <summary>
+            /// The subscribers receiving the readings of the sensor.
+            /// </summary>
+            subscribers_type subscribers;
+        };
+
+        /// <summary>
+        /// The maximum time a sample may be retained in a batch before it is
+        /// delivered to a <see cref="measurement_data_callback" />.
+        /// </summary>
+        static constexpr interval_type max_batch_latency
+            = std::chrono::milliseconds(10);
+
+        /// <summary>
+        /// The longest delay between two attempts to read an isolated sensor.
+        /// </summary>
+        static constexpr interval_type max_backoff = std::chrono::seconds(1);
+
+        /// <summary>
+        /// The number of consecutive reads that may fail or exceed the
+        /// interval before a sensor is isolated.
+        /// </summary>
+        static constexpr std::size_t max_strikes = 3;
+
+        /// <summary>
+        /// The number of consecutive good reads after which an isolated sensor
+        /// returns to the sampler task.
+        /// </summary>
+        static constexpr std::size_t recovery_reads = 8;
+
+        /// <summary>
+        /// The type of an immutable snapshot of the sensors that the sampling
+        /// thread dispatches to.
+        /// </summary>
+        typedef std::vector<std::pair<sensor_type, entry_type>> snapshot_type;
+
+        /// <summary>
+        /// The snapshot of <see cref="sensors" /> that is currently being used
+        /// by the sampler thread.
+        /// </summary>
+        /// <remarks>
+        /// This pointer must only be accessed via <c>std::atomic_load</c> and
+        /// <c>std::atomic_store</c>. It is replaced as a whole whenever
+        /// <see cref="sensors" /> change, which allows the sampler thread to
+        /// invoke the callbacks without holding <see cref="lock" />.
+        /// </remarks>
+        std::shared_ptr<const snapshot_type> active;
+
+        /// <summary>
+        /// A counter that is incremented by the sampler thread before and after
+        /// it dispatches to <see cref="active" />.
+        /// </summary>
+        /// <remarks>
+        /// An odd value indicates that the sampler thread is currently using a
+        /// snapshot, which might still contain a sensor that has just been
+        /// removed. <see cref="remove" /> uses this counter to wait for the
+        /// dispatch to complete such that the caller can safely destroy the
+        /// sensor afterwards.
+        /// </remarks>
+        std::atomic<std::uint64_t> epoch;
+
+        /// <summary>
+        /// Records the timing of the ticks of <see cref="task" />.
+        /// </summary>
+        sampler_instrumentation instrumentation;
+
+        /// <summary>
+        /// The snapshot of the isolated <see cref="sensors" /> that is used by
+        /// the <see cref="isolation_thread" />.
+        /// </summary>
+        /// <remarks>
+        /// This pointer must only be accessed via <c>std::atomic_load</c> and
+        /// <c>std::atomic_store</c> like <see cref="active" />.
+        /// </remarks>
+        std::shared_ptr<const snapshot_type> isolated;
+
+        /// <summary>
+        /// The equivalent of <see cref="epoch" /> for the
+        /// <see cref="isolation_thread" />.
+        /// </summary>
+        std::atomic<std::uint64_t> isolation_epoch;
+
+        /// <summary>
+        /// Wakes the <see cref="isolation_thread" /> if the isolated sensors
+        /// have changed.
+        /// </summary>
+        std::condition_variable isolation_signal;
+
+        /// <summary>
+        /// A dedicated thread that samples the sensors which repeatedly failed
+        /// or exceeded their budget, such that they cannot stall the other
+        /// sensors of the context.
+        /// </summary>
+        /// <remarks>
+        /// The thread is started on demand and exits if there are no isolated
+        /// sensors anymore. Whether it is running is protected by
+        /// <see cref="lock" /> and indicated by <see cref="isolating" />.
+        /// </remarks>
+        std::thread isolation_thread;
+
+        /// <summary>
+        /// Indicates whether the <see cref="isolation_thread" /> is running.
+        /// </summary>
+        bool isolating;
+
         /// <summary>
         /// The sampling interval.
         /// </summary>
@@ -60,58 +369,162 @@ namespace detail {
         /// <summary>
         /// A lock protecting the list of <see cref="sensors" />.
         /// </summary>
+        /// <remarks>
+        /// The lock only serialises modifications of the sensor list. It is
+        /// not held while sampling.
+        /// </remarks>
         std::mutex lock;
 
         /// <summary>
-        /// The sensors to sample along with the callback to be invoked.
+        /// The shortest interval the context may sample at if the signals of
+        /// its sensors change quickly.
         /// </summary>
-        std::map<sensor_type, callback_type> sensors;
+        /// <remarks>
+        /// If this interval is zero, which is the default, the context samples
+        /// at the fixed <see cref="interval" />. Otherwise, the
+        /// <see cref="interval" /> is the longest one, which is used while all
+        /// signals are stable, and the context follows the sensor whose
+        /// <see cref="registration::adaptation" /> requests the shortest
+        /// interval.
+        /// </remarks>
+        interval_type min_interval;
 
         /// <summary>
-        /// The thread sampling the <see cref="sensors" />.
+        /// Indicates whether the <see cref="task" /> is scheduled.
         /// </summary>
         /// <remarks>
-        /// The <see cref="sampler" /> will make sure that the thread exited
-        /// before destroying the context. The context does not need to join
-        /// the thread on destruction.
+        /// The flag is protected by <see cref="lock" />. The sampler task
+        /// clears it when it has found <see cref="sensors" /> empty and is
+        /// about to stop, in which case <see cref="add" /> must schedule it
+        /// again.
         /// </remarks>
-        std::thread thread;
+        bool running;
+
+        /// <summary>
+        /// The readings of the sensor that the sampler task is currently
+        /// dispatching.
+        /// </summary>
+        /// <remarks>
+        /// The buffer is only accessed by the sampler task. It is a member
+        /// such that its memory is reused across ticks.
+        /// </remarks>
+        std::vector<measurement_data> readings;
+
+        /// <summary>
+        /// The sensors to sample along with the callbacks to be invoked.
+        /// </summary>
+        std::map<sensor_type, entry_type> sensors;
+
+        /// <summary>
+        /// The task of the scheduler that periodically samples the
+        /// <see cref="sensors" />.
+        /// </summary>
+        /// <remarks>
+        /// The <see cref="sampler" /> will make sure that the task has been
+        /// cancelled before destroying the context.
+        /// </remarks>
+        sampler_scheduler::task task;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        inline default_sampler_context(void)
+            : active(std::make_shared<snapshot_type>()), epoch(0),
+                instrumentation(task),
+                isolated(std::make_shared<snapshot_type>()),
+                isolation_epoch(0), isolating(false), min_interval(0),
+                running(false), task(&default_sampler_context::tick, this) { }
+
+        default_sampler_context(const default_sampler_context&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        /// <remarks>
+        /// The destructor removes all sensors and waits for the
+        /// <see cref="isolation_thread" /> to exit.
+        /// </remarks>
+        ~default_sampler_context(void);
 
         /// <summary>
         /// Add the given sensor to the this context.
         /// </summary>
+        /// <remarks>
+        /// A sensor may have multiple subscribers, which are distinguished
+        /// by their <paramref name="context" />. The sensor is read only once
+        /// per tick and the reading is passed to all of them. A subscriber
+        /// without a context cannot be told apart and is therefore always
+        /// exclusive.
+        /// </remarks>
         /// <param name="sensor"></param>
         /// <param name="callback"></param>
         /// <param name="context"></param>
-        /// <returns></returns>
+        /// <param name="divisor">Deliver only the reading of every n-th tick
+        /// to the callback.</param>
+        /// <returns><c>false</c> if the sensor is already sampled for the
+        /// same <paramref name="context" /> or if either the new or an
+        /// existing subscriber has no context, <c>true</c> otherwise.
+        /// </returns>
         bool add(sensor_type sensor, const measurement_callback callback,
-            void *context);
+            void *context, const std::size_t divisor = 1);
+
+        /// <summary>
+        /// Add the given sensor to the this context such that its samples are
+        /// delivered in batches.
+        /// </summary>
+        /// <remarks>
+        /// The samples are delivered if the batch covers
+        /// <see cref="max_batch_latency" /> or if the sensor is removed from
+        /// the context.
+        /// </remarks>
+        /// <param name="sensor"></param>
+        /// <param name="callback"></param>
+        /// <param name="context"></param>
+        /// <param name="divisor">Deliver only the reading of every n-th tick
+        /// to the callback.</param>
+        /// <returns><c>false</c> if the sensor is already sampled for the
+        /// same <paramref name="context" />, <c>true</c> otherwise.</returns>
+        bool add(sensor_type sensor, const measurement_data_callback callback,
+            void *context, const std::size_t divisor = 1);
 
         /// <summary>
         /// Remove the sensor from the context.
         /// </summary>
         /// <param name="sensor">The sensor to be removed.</param>
-        /// <returns><c>true</c> if the sensor has been removed, <c>false</c> if
-        /// it has not been sampled in the first place.</returns>
-        inline bool remove(sensor_type sensor) {
-            std::lock_guard<decltype(this->lock)> l(this->lock);
-            return (this->sensors.erase(sensor) > 0);
-        }
+        /// <param name="context">The user context the subscriber to be
+        /// removed has been added with. If this is <c>nullptr</c>, all
+        /// subscribers of the sensor are removed.</param>
+        /// <returns><c>true</c> if a subscriber has been removed, <c>false</c>
+        /// if it has not been sampled in the first place.</returns>
+        /// <remarks>
+        /// If the sensor has been removed, the method blocks until the sampler
+        /// task does not use it anymore unless it is called from within a
+        /// callback of the task itself.
+        /// </remarks>
+        bool remove(sensor_type sensor, void *context = nullptr);
 
         /// <summary>
-        /// Performs sampling in this context.
+        /// Remove all sensors from the context, which will make the sampler
+        /// task stop.
+        /// </summary>
+        void clear(void);
+
+        /// <summary>
+        /// Performs one tick of sampling in this context.
         /// </summary>
         /// <remarks>
-        /// <para>This is the sampling method running in <see cref="thread" />.
-        /// </para>
-        /// <para>The <see cref="add" /> method shall start the thread if
+        /// <para>This is the method the scheduler invokes via
+        /// <see cref="task" />.</para>
+        /// <para>The <see cref="add" /> method shall schedule the task if
         /// adding the first sensor to <see cref="sensors" />.</para>
-        /// <para>This method periodically samples all sensors in
-        /// <see cref="sensors" /> as long as there is any callback left in
-        /// the map. If <see cref="sensors" /> is empty, the method will exit.
-        /// </para>
+        /// <para>This method samples all sensors in <see cref="sensors" />
+        /// once, except for the isolated ones. Sensors whose reads fail or
+        /// exceed the interval <see cref="max_strikes" /> times in a row are
+        /// moved to the <see cref="isolation_thread" />.</para>
         /// </remarks>
-        void sample(void);
+        /// <returns><c>true</c> if the task should continue to be scheduled,
+        /// <c>false</c> if <see cref="sensors" /> is empty.</returns>
+        bool sample(void);
 
         /// <summary>
         /// Answer whether the given sensor is sampled in this context.
@@ -123,6 +536,108 @@ namespace detail {
             std::lock_guard<decltype(this->lock)> l(this->lock);
             return (this->sensors.find(sensor) != this->sensors.end());
         }
+
+        default_sampler_context& operator =(
+            const default_sampler_context&) = delete;
+
+    private:
+
+        /// <summary>
+        /// The outcome of <see cref="dispatch" />.
+        /// </summary>
+        enum class dispatch_result {
+            /// <summary>
+            /// None of the subscribers was due, so the sensor was not read.
+            /// </summary>
+            skipped,
+
+            /// <summary>
+            /// The sensor was read within the interval of the context.
+            /// </summary>
+            healthy,
+
+            /// <summary>
+            /// Reading the sensor threw or took longer than the interval.
+            /// </summary>
+            unhealthy
+        };
+
+        /// <summary>
+        /// Add the given registration for the sensor.
+        /// </summary>
+        bool add(sensor_type sensor, registration_type&& registration);
+
+        /// <summary>
+        /// Reads the sensor once if any of its subscribers is due and passes
+        /// the reading to all due subscribers.
+        /// </summary>
+        /// <param name="sensor">The sensor to be read.</param>
+        /// <param name="entry">The subscribers of the sensor.</param>
+        /// <param name="readings">A buffer for the readings of the sensor,
+        /// which is owned by the calling thread.</param>
+        /// <param name="now">The time the previous measurement ended, which
+        /// is updated to the end of the current one.</param>
+        /// <param name="next">Receives the interval requested by the adaptive
+        /// subscribers.</param>
+        /// <returns>Whether the sensor has been read and whether this was
+        /// successful.</returns>
+        dispatch_result dispatch(_In_ sensor_type sensor,
+            _In_ const entry_type& entry,
+            _Inout_ std::vector<measurement_data>& readings,
+            _Inout_ clock_type::time_point& now,
+            _Inout_ interval_type& next);
+
+        /// <summary>
+        /// Answer whether any of the sensors is sampled by the sampler task.
+        /// </summary>
+        /// <remarks>
+        /// The caller must hold <see cref="lock" />.
+        /// </remarks>
+        bool has_active(void) const;
+
+        /// <summary>
+        /// Answer whether any of the sensors has been isolated.
+        /// </summary>
+        /// <remarks>
+        /// The caller must hold <see cref="lock" />.
+        /// </remarks>
+        bool has_isolated(void) const;
+
+        /// <summary>
+        /// The thread procedure of <see cref="isolation_thread" />, which
+        /// retries the isolated sensors with an exponential back-off.
+        /// </summary>
+        void isolate(void);
+
+        /// <summary>
+        /// The callback of <see cref="task" />.
+        /// </summary>
+        static bool tick(_In_ void *context);
+
+        /// <summary>
+        /// Moves the sensor to the <see cref="isolation_thread" /> or back to
+        /// the sampler task.
+        /// </summary>
+        /// <remarks>
+        /// The caller must not hold <see cref="lock" />.
+        /// </remarks>
+        void transfer(_In_ sensor_type sensor, _In_ const bool isolate);
+
+        /// <summary>
+        /// Publishes a new snapshot of <see cref="sensors" /> to the sampler
+        /// task.
+        /// </summary>
+        /// <remarks>
+        /// The caller must hold <see cref="lock" />.
+        /// </remarks>
+        void publish(void);
+
+        /// <summary>
+        /// Blocks the calling thread until the sampler task and the
+        /// <see cref="isolation_thread" /> have completed the dispatch that
+        /// might have been in progress when the method was called.
+        /// </summary>
+        void synchronise(void) const;
     };
 
 } /* namespace detail */
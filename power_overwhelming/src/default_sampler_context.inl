@@ -4,29 +4,196 @@
 // <author>Christoph Mller</author>
 
 
+/*
+ * ...::detail::default_sampler_context<TSensorImpl>::max_batch_latency
+ */
+template<class TSensorImpl>
+constexpr typename visus::power_overwhelming::detail::default_sampler_context<
+    TSensorImpl>::interval_type
+visus::power_overwhelming::detail::default_sampler_context<TSensorImpl>
+::max_batch_latency;
+
+
+/*
+ * ...::detail::default_sampler_context<TSensorImpl>::max_backoff
+ */
+template<class TSensorImpl>
+constexpr typename visus::power_overwhelming::detail::default_sampler_context<
+    TSensorImpl>::interval_type
+visus::power_overwhelming::detail::default_sampler_context<TSensorImpl>
+::max_backoff;
+
+
+/*
+ * ...::detail::default_sampler_context<TSensorImpl>::max_strikes
+ */
+template<class TSensorImpl>
+constexpr std::size_t
+visus::power_overwhelming::detail::default_sampler_context<TSensorImpl>
+::max_strikes;
+
+
+/*
+ * ...::detail::default_sampler_context<TSensorImpl>::recovery_reads
+ */
+template<class TSensorImpl>
+constexpr std::size_t
+visus::power_overwhelming::detail::default_sampler_context<TSensorImpl>
+::recovery_reads;
+
+
+/*
+ * ...::detail::default_sampler_context<TSensorImpl>::~default_sampler_context
+ */
+template<class TSensorImpl>
+visus::power_overwhelming::detail::default_sampler_context<TSensorImpl>
+::~default_sampler_context(void) {
+    this->clear();
+
+    if (this->isolation_thread.joinable()) {
+        // The thread exits once it finds no isolated sensor anymore.
+        this->isolation_thread.join();
+    }
+}
+
+
 /*
  * visus::power_overwhelming::detail::default_sampler_context<TSensorImpl>::add
  */
 template<class TSensorImpl>
 bool visus::power_overwhelming::detail::default_sampler_context<TSensorImpl>
-::add(sensor_type sensor, const measurement_callback callback, void *context) {
+::add(sensor_type sensor, const measurement_callback callback, void *context,
+        const std::size_t divisor) {
     assert(sensor != nullptr);
     assert(callback != nullptr);
+    assert(divisor > 0);
+    auto registration = std::make_shared<typename default_sampler_context
+        ::registration>();
+    registration->batch_size = 0;
+    registration->callback = callback;
+    registration->context = context;
+    registration->countdown = 0;
+    registration->data_callback = nullptr;
+    registration->divisor = divisor;
+    registration->name = sensor_name_registry::intern(
+        sensor->sensor_name.c_str());
+    registration->sample_duration = &this->instrumentation.sample_duration(
+        registration->name);
+    registration->sequence = 0;
+    if (this->min_interval > interval_type::zero()) {
+        registration->adaptation.configure(this->min_interval, this->interval);
+    }
+    return this->add(sensor, std::move(registration));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::default_sampler_context<TSensorImpl>::add
+ */
+template<class TSensorImpl>
+bool visus::power_overwhelming::detail::default_sampler_context<TSensorImpl>
+::add(sensor_type sensor, const measurement_data_callback callback,
+        void *context, const std::size_t divisor) {
+    assert(sensor != nullptr);
+    assert(callback != nullptr);
+    assert(divisor > 0);
+    auto registration = std::make_shared<typename default_sampler_context
+        ::registration>();
+    registration->batch_size = static_cast<std::size_t>(max_batch_latency
+        / ((std::max)(this->interval, interval_type(1)) * divisor));
+    if (registration->batch_size < 1) {
+        registration->batch_size = 1;
+    }
+    registration->batch.reserve(registration->batch_size);
+    registration->callback = nullptr;
+    registration->context = context;
+    registration->countdown = 0;
+    registration->data_callback = callback;
+    registration->divisor = divisor;
+    registration->name = sensor_name_registry::intern(
+        sensor->sensor_name.c_str());
+    registration->sample_duration = &this->instrumentation.sample_duration(
+        registration->name);
+    registration->sequence = 0;
+    if (this->min_interval > interval_type::zero()) {
+        registration->adaptation.configure(this->min_interval, this->interval);
+    }
+    return this->add(sensor, std::move(registration));
+}
+
+
+/*
+ * ...::detail::default_sampler_context<TSensorImpl>::clear
+ */
+template<class TSensorImpl>
+void visus::power_overwhelming::detail::default_sampler_context<TSensorImpl>
+::clear(void) {
     std::lock_guard<decltype(this->lock)> l(this->lock);
+    this->sensors.clear();
+    this->publish();
+    this->isolation_signal.notify_all();
+}
+
+
+/*
+ * ...::detail::default_sampler_context<TSensorImpl>::remove
+ */
+template<class TSensorImpl>
+bool visus::power_overwhelming::detail::default_sampler_context<TSensorImpl>
+::remove(sensor_type sensor, void *context) {
+    auto is_sampler_thread = false;
+    subscribers_type removed;
 
-    if (this->sensors.find(sensor) != this->sensors.end()) {
-        // Sensor is already being sampled, so there is nothing to do.
-        return false;
+    {
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        auto it = this->sensors.find(sensor);
+        is_sampler_thread = this->task.executing()
+            || (this->isolation_thread.get_id() == std::this_thread::get_id());
+
+        if (it != this->sensors.end()) {
+            auto& subscribers = it->second.subscribers;
+
+            if (context == nullptr) {
+                removed = std::move(subscribers);
+                subscribers.clear();
+            } else {
+                auto jt = std::stable_partition(subscribers.begin(),
+                    subscribers.end(), [context](const registration_type& r) {
+                        return (r->context != context);
+                    });
+                std::move(jt, subscribers.end(), std::back_inserter(removed));
+                subscribers.erase(jt, subscribers.end());
+            }
+
+            if (subscribers.empty()) {
+                this->sensors.erase(it);
+            }
+
+            if (!removed.empty()) {
+                this->publish();
+                this->isolation_signal.notify_all();
+            }
+        }
     }
 
-    this->sensors.emplace(sensor, std::make_pair(callback, context));
+    if (!removed.empty()) {
+        if (!is_sampler_thread) {
+            // The sampler thread might still use the old snapshot, so we must
+            // not return until it has finished, because the caller is
+            // typically about to destroy the sensor.
+            this->synchronise();
+        }
 
-    if ((this->sensors.size() == 1) && !this->thread.joinable()) {
-        // If this is the first sensor, we need to start a worker thread.
-        this->thread = std::thread(&default_sampler_context::sample, this);
+        // At this point, the sampler thread cannot access the registrations
+        // anymore, so we can deliver the remaining samples of the last batch.
+        for (auto& r : removed) {
+            if (r->data_callback != nullptr) {
+                r->deliver();
+            }
+        }
     }
 
-    return true;
+    return !removed.empty();
 }
 
 
@@ -34,28 +201,443 @@ bool visus::power_overwhelming::detail::default_sampler_context<TSensorImpl>
  * ...::detail::default_sampler_context<TSensorImpl>::sample
  */
 template<class TSensorImpl>
-void visus::power_overwhelming::detail::default_sampler_context<TSensorImpl>
+bool visus::power_overwhelming::detail::default_sampler_context<TSensorImpl>
 ::sample(void) {
+    const auto adaptive = (this->min_interval > interval_type::zero());
+    const auto begin = this->instrumentation.begin_tick();
     auto have_sensors = true;
+    auto next = this->interval;
+    std::vector<sensor_type> quarantine;
 
-    set_thread_name("PwrOwg Default Sampler Thread");
+    // Mark the begin of the dispatch *before* obtaining the snapshot. This
+    // way, anyone who removed a sensor either sees that we are dispatching and
+    // waits for us, or we see the snapshot without the sensor.
+    ++this->epoch;
+    {
+        auto sensors = std::atomic_load(&this->active);
+        assert(sensors != nullptr);
 
-    while (have_sensors) {
-        auto now = std::chrono::high_resolution_clock::now();
+        // Each duration starts where the previous one ended, which saves
+        // reading the clock twice per sample.
+        auto now = begin;
 
+        for (auto& s : *sensors) {
+            auto& health = *s.second.health;
+
+            switch (this->dispatch(s.first, s.second, this->readings, now,
+                    next)) {
+                case dispatch_result::healthy:
+                    health.strikes = 0;
+                    break;
+
+                case dispatch_result::unhealthy:
+                    if (++health.strikes >= max_strikes) {
+                        quarantine.push_back(s.first);
+                    }
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        have_sensors = !sensors->empty();
+    }
+    ++this->epoch;
+
+    // Move the offending sensors only after the dispatch, because transfer()
+    // acquires the lock, which we must not hold while invoking callbacks.
+    for (auto s : quarantine) {
+        this->transfer(s, true);
+    }
+
+    this->instrumentation.end_tick(begin);
+
+    if (adaptive && have_sensors && (next != this->task.interval())) {
+        // The sensor with the fastest changing signal determines the rate of
+        // all sensors in the context.
+        this->task.restart(next);
+    }
+
+    if (!have_sensors || !quarantine.empty()) {
+        // Decide about stopping while holding the lock, because a sensor
+        // might have been added after we obtained the snapshot and add() must
+        // know whether it needs to schedule the task again.
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        have_sensors = this->has_active();
+        this->running = have_sensors;
+    }
+
+    return have_sensors;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::default_sampler_context<TSensorImpl>::add
+ */
+template<class TSensorImpl>
+bool visus::power_overwhelming::detail::default_sampler_context<TSensorImpl>
+::add(sensor_type sensor, registration_type&& registration) {
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    auto& entry = this->sensors[sensor];
+
+    if (entry.health == nullptr) {
+        entry.health = std::make_shared<health_type>();
+        entry.health->backoff = this->interval;
+        entry.health->recovered = 0;
+        entry.health->strikes = 0;
+        entry.isolated = false;
+    }
+
+    for (auto& r : entry.subscribers) {
+        if ((r->context == registration->context)
+                || (r->context == nullptr)
+                || (registration->context == nullptr)) {
+            // Sensor is already being sampled for the same subscriber, so
+            // there is nothing to do. A subscriber without a context cannot
+            // be told apart from the others, so it must be the only one.
+            return false;
+        }
+    }
+
+    entry.subscribers.push_back(std::move(registration));
+    this->publish();
+
+    if (entry.isolated) {
+        // The new subscriber joins the isolated sensor, so the sampler task
+        // does not need to run for it.
+        this->isolation_signal.notify_all();
+
+    } else if (!this->running) {
+        // If this is the first sensor, we need to schedule the task. If the
+        // task is still in its last tick, the scheduler restarts it after the
+        // tick has completed.
+        this->running = true;
+        sampler_scheduler::instance().schedule(this->task, this->interval);
+    }
+
+    return true;
+}
+
+
+/*
+ * ...::detail::default_sampler_context<TSensorImpl>::dispatch
+ */
+template<class TSensorImpl>
+typename visus::power_overwhelming::detail::default_sampler_context<TSensorImpl>
+::dispatch_result
+visus::power_overwhelming::detail::default_sampler_context<TSensorImpl>
+::dispatch(_In_ sensor_type sensor, _In_ const entry_type& entry,
+        _Inout_ std::vector<measurement_data>& readings,
+        _Inout_ clock_type::time_point& now, _Inout_ interval_type& next) {
+    const auto adaptive = (this->min_interval > interval_type::zero());
+    auto& subscribers = entry.subscribers;
+    assert(!subscribers.empty());
+    auto any_batch = false;
+    auto any_due = false;
+    auto retval = dispatch_result::healthy;
+
+    for (auto& r : subscribers) {
+        if (r->countdown == 0) {
+            any_batch = any_batch || (r->data_callback != nullptr);
+            any_due = true;
+        }
+    }
+
+    if (!any_due) {
+        // None of the subscribers wants a reading in this tick, so we save
+        // the access to the hardware.
+        for (auto& r : subscribers) {
+            --r->countdown;
+        }
+        return dispatch_result::skipped;
+    }
+
+    // Read the sensor once for all subscribers. Sensors that buffer their
+    // samples are only drained if there is a subscriber accepting batches,
+    // because the callback for individual samples has always been invoked
+    // for the latest reading.
+    auto& first = *subscribers.front();
+    const auto then = now;
+    readings.clear();
+    try {
+        if (any_batch) {
+            sample_into(*sensor, readings, 0);
+        } else {
+            readings.push_back(sensor->sample());
+        }
+    } catch (...) {
+        // A sensor that throws must not take down the thread sampling all
+        // the other sensors, so we drop the reading and count the failure.
+        readings.clear();
+        retval = dispatch_result::unhealthy;
+    }
+    now = clock_type::now();
+    first.sample_duration->record(now - then);
+
+    if (now - then > this->interval) {
+        retval = dispatch_result::unhealthy;
+    }
+
+    system_trace::sample(first.name, readings.data(),
+        readings.size());
+
+    for (auto& rp : subscribers) {
+        auto& r = *rp;
+
+        if (r.countdown > 0) {
+            --r.countdown;
+            continue;
+        }
+        r.countdown = r.divisor - 1;
+
+        if (adaptive && !readings.empty()) {
+            next = (std::min)(next, r.adaptation.update(
+                readings.back().power()));
+        }
+
+        if (readings.empty()) {
+            // Consume a sequence number for the failed reading such that the
+            // consumer can detect the missing sample.
+            sequence_tracker::next(r.sequence);
+        }
+
+        if (r.data_callback != nullptr) {
+            const auto offset = r.batch.size();
+            r.batch.insert(r.batch.end(), readings.begin(),
+                readings.end());
+            for (auto it = r.batch.begin() + offset; it != r.batch.end();
+                    ++it) {
+                it->sequence(sequence_tracker::next(r.sequence));
+            }
+
+            if (r.batch.size() >= r.batch_size) {
+                const auto start = now;
+                r.deliver();
+                now = clock_type::now();
+                this->instrumentation.callback_duration().record(now - start);
+            }
+
+        } else if (!readings.empty()) {
+            auto reading = readings.back();
+            reading.sequence(sequence_tracker::next(r.sequence));
+            const auto start = now;
+            // TODO
+            r.callback(measurement(r.name, reading), r.context);
+            now = clock_type::now();
+            this->instrumentation.callback_duration().record(now - start);
+        }
+    }
+
+    return retval;
+}
+
+
+/*
+ * ...::detail::default_sampler_context<TSensorImpl>::has_active
+ */
+template<class TSensorImpl>
+bool visus::power_overwhelming::detail::default_sampler_context<TSensorImpl>
+::has_active(void) const {
+    return std::any_of(this->sensors.begin(), this->sensors.end(),
+        [](const typename decltype(this->sensors)::value_type& s) {
+            return !s.second.isolated;
+        });
+}
+
+
+/*
+ * ...::detail::default_sampler_context<TSensorImpl>::has_isolated
+ */
+template<class TSensorImpl>
+bool visus::power_overwhelming::detail::default_sampler_context<TSensorImpl>
+::has_isolated(void) const {
+    return std::any_of(this->sensors.begin(), this->sensors.end(),
+        [](const typename decltype(this->sensors)::value_type& s) {
+            return s.second.isolated;
+        });
+}
+
+
+/*
+ * ...::detail::default_sampler_context<TSensorImpl>::isolate
+ */
+template<class TSensorImpl>
+void visus::power_overwhelming::detail::default_sampler_context<TSensorImpl>
+::isolate(void) {
+    enter_library_thread("PwrOwg Isolated Sensor Thread");
+
+    std::unique_lock<decltype(this->lock)> l(this->lock, std::defer_lock);
+    std::vector<measurement_data> readings;
+    std::vector<sensor_type> recovered;
+
+    while (true) {
+        auto wake = clock_type::now() + max_backoff;
+
+        ++this->isolation_epoch;
         {
-            std::lock_guard<decltype(this->lock)> l(this->lock);
-            for (auto& s : this->sensors) {
-                // TODO
-                s.second.first(measurement(s.first->sensor_name.c_str(),
-                    s.first->sample()), s.second.second);
+            auto sensors = std::atomic_load(&this->isolated);
+            assert(sensors != nullptr);
+
+            // The isolated sensors do not take part in the adaptation of the
+            // rate of the context.
+            auto next = this->interval;
+
+            for (auto& s : *sensors) {
+                auto& health = *s.second.health;
+                auto now = clock_type::now();
+
+                if (now < health.retry) {
+                    wake = (std::min)(wake, health.retry);
+                    continue;
+                }
+
+                switch (this->dispatch(s.first, s.second, readings, now,
+                        next)) {
+                    case dispatch_result::healthy:
+                        health.backoff = this->interval;
+                        if (++health.recovered >= recovery_reads) {
+                            recovered.push_back(s.first);
+                        }
+                        break;
+
+                    case dispatch_result::unhealthy:
+                        // Double the delay on each failure such that a sensor
+                        // which hangs does not occupy the thread permanently.
+                        health.backoff = (std::min)(2 * health.backoff,
+                            max_backoff);
+                        health.recovered = 0;
+                        break;
+
+                    default:
+                        break;
+                }
+
+                health.retry = now + health.backoff;
+                wake = (std::min)(wake, health.retry);
             }
+        }
+        ++this->isolation_epoch;
+
+        for (auto s : recovered) {
+            this->transfer(s, false);
+        }
+        recovered.clear();
+
+        l.lock();
+        if (!this->has_isolated()) {
+            // Decide about exiting while holding the lock, such that
+            // transfer() knows whether it needs to start the thread again.
+            this->isolating = false;
+            return;
+        }
+
+        this->isolation_signal.wait_until(l, wake);
+        l.unlock();
+    }
+}
+
+
+/*
+ * ...::detail::default_sampler_context<TSensorImpl>::publish
+ */
+template<class TSensorImpl>
+void visus::power_overwhelming::detail::default_sampler_context<TSensorImpl>
+::publish(void) {
+    auto active = std::make_shared<snapshot_type>();
+    auto isolated = std::make_shared<snapshot_type>();
+
+    for (auto& s : this->sensors) {
+        (s.second.isolated ? isolated : active)->push_back(s);
+    }
+
+    std::atomic_store(&this->active,
+        std::shared_ptr<const snapshot_type>(std::move(active)));
+    std::atomic_store(&this->isolated,
+        std::shared_ptr<const snapshot_type>(std::move(isolated)));
+}
+
+
+/*
+ * ...::detail::default_sampler_context<TSensorImpl>::synchronise
+ */
+template<class TSensorImpl>
+void visus::power_overwhelming::detail::default_sampler_context<TSensorImpl>
+::synchronise(void) const {
+    const auto epoch = this->epoch.load();
+    const auto isolation_epoch = this->isolation_epoch.load();
 
-            have_sensors = !this->sensors.empty();
+    if ((epoch & 1) != 0) {
+        // The sampler thread is within a dispatch, so wait until it has left
+        // it. It is irrelevant whether it entered a new one since then, because
+        // the new dispatch will use the updated snapshot.
+        while (this->epoch.load() == epoch) {
+            std::this_thread::yield();
         }
+    }
 
-        if (have_sensors) {
-            std::this_thread::sleep_until(now + this->interval);
+    if ((isolation_epoch & 1) != 0) {
+        // The same applies to the thread sampling the isolated sensors.
+        while (this->isolation_epoch.load() == isolation_epoch) {
+            std::this_thread::yield();
         }
     }
 }
+
+
+/*
+ * ...::detail::default_sampler_context<TSensorImpl>::tick
+ */
+template<class TSensorImpl>
+bool visus::power_overwhelming::detail::default_sampler_context<TSensorImpl>
+::tick(_In_ void *context) {
+    assert(context != nullptr);
+    return static_cast<default_sampler_context *>(context)->sample();
+}
+
+
+/*
+ * ...::detail::default_sampler_context<TSensorImpl>::transfer
+ */
+template<class TSensorImpl>
+void visus::power_overwhelming::detail::default_sampler_context<TSensorImpl>
+::transfer(_In_ sensor_type sensor, _In_ const bool isolate) {
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    auto it = this->sensors.find(sensor);
+
+    if ((it == this->sensors.end()) || (it->second.isolated == isolate)) {
+        // The sensor has been removed in the meantime.
+        return;
+    }
+
+    // Hand over the health to the new owner, which starts with a clean slate.
+    // The isolation thread waits for the first retry in order to give the
+    // sensor a chance to recover.
+    auto& health = *it->second.health;
+    health.backoff = this->interval;
+    health.recovered = 0;
+    health.retry = clock_type::now() + health.backoff;
+    health.strikes = 0;
+
+    it->second.isolated = isolate;
+    this->publish();
+
+    if (isolate) {
+        if (!this->isolating) {
+            if (this->isolation_thread.joinable()) {
+                // The previous thread has already decided to exit.
+                this->isolation_thread.join();
+            }
+
+            this->isolating = true;
+            this->isolation_thread = std::thread(
+                &default_sampler_context::isolate, this);
+        }
+
+        this->isolation_signal.notify_all();
+
+    } else if (!this->running) {
+        this->running = true;
+        sampler_scheduler::instance().schedule(this->task, this->interval);
+    }
+}
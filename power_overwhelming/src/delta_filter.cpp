@@ -0,0 +1,144 @@
+﻿// <copyright file="delta_filter.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "delta_filter.h"
+
+#include <cmath>
+#include <stdexcept>
+
+
+/*
+ * visus::power_overwhelming::detail::delta_filter::delta_filter
+ */
+visus::power_overwhelming::detail::delta_filter::delta_filter(void)
+    : _keep_alive(0) { }
+
+
+/*
+ * visus::power_overwhelming::detail::delta_filter::configure
+ */
+void visus::power_overwhelming::detail::delta_filter::configure(
+        _In_ const measurement::timestamp_type keep_alive) {
+    if (keep_alive < 0) {
+        throw std::invalid_argument("The keep-alive interval of the change "
+            "filter must not be negative.");
+    }
+
+    this->_keep_alive = keep_alive;
+    this->_states.clear();
+    this->_thresholds.clear();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::delta_filter::flush
+ */
+void visus::power_overwhelming::detail::delta_filter::flush(
+        _Inout_ std::vector<sample_type>& dst) {
+    for (auto& s : this->_states) {
+        if (s.second.is_held) {
+            dst.push_back(s.second.held);
+            s.second.is_held = false;
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::delta_filter::push
+ */
+void visus::power_overwhelming::detail::delta_filter::push(
+        _In_ const measurement& sample,
+        _In_ const std::uint32_t marker,
+        _Inout_ std::vector<sample_type>& dst) {
+    auto it = this->_states.find(sample.sensor());
+
+    if (it == this->_states.end()) {
+        // Resolve the threshold once per sensor, because the names of the
+        // samples of a sensor are always the same pointer.
+        auto t = this->_thresholds.find(sample.sensor());
+        const auto threshold = (t != this->_thresholds.end())
+            ? t->second
+            : -1.0f;
+        it = this->_states.emplace(sample.sensor(),
+            state_type(sample, threshold)).first;
+    }
+
+    auto& state = it->second;
+
+    if (state.threshold < 0.0f) {
+        dst.emplace_back(sample, marker);
+        return;
+    }
+
+    if (!state.is_started) {
+        state.is_started = true;
+        state.last = sample_type(sample, marker);
+        dst.push_back(state.last);
+        return;
+    }
+
+    if (changed(state, sample, marker)) {
+        // The retained sample is the last one with the old value, which
+        // preserves the time of the step.
+        if (state.is_held) {
+            dst.push_back(state.held);
+            state.is_held = false;
+        }
+
+        state.last = sample_type(sample, marker);
+        dst.push_back(state.last);
+
+    } else if ((this->_keep_alive > 0) && (sample.timestamp()
+            - state.last.first.timestamp() >= this->_keep_alive)) {
+        // The retained sample is within the threshold of the keep-alive
+        // sample, so it does not carry any information.
+        state.is_held = false;
+        state.last = sample_type(sample, marker);
+        dst.push_back(state.last);
+
+    } else {
+        state.held = sample_type(sample, marker);
+        state.is_held = true;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::delta_filter::threshold
+ */
+void visus::power_overwhelming::detail::delta_filter::threshold(
+        _In_ const std::wstring& sensor,
+        _In_ const measurement::value_type threshold) {
+    if (threshold < 0.0f) {
+        this->_thresholds.erase(sensor);
+    } else {
+        this->_thresholds[sensor] = threshold;
+    }
+
+    // Sensors that have already been seen must use the new threshold, too.
+    for (auto& s : this->_states) {
+        if (sensor == s.first) {
+            s.second.threshold = threshold;
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::delta_filter::changed
+ */
+bool visus::power_overwhelming::detail::delta_filter::changed(
+        _In_ const state_type& state,
+        _In_ const measurement& sample,
+        _In_ const std::uint32_t marker) noexcept {
+    const auto& last = state.last.first;
+    // Invalid values are the lowest representable number, so a change in
+    // their presence always exceeds the threshold.
+    return (marker != state.last.second)
+        || (std::abs(sample.voltage() - last.voltage()) > state.threshold)
+        || (std::abs(sample.current() - last.current()) > state.threshold)
+        || (std::abs(sample.power() - last.power()) > state.threshold);
+}
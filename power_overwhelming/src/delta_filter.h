@@ -0,0 +1,135 @@
+﻿// <copyright file="delta_filter.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "power_overwhelming/measurement.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Only releases the samples of sensors that have changed.
+    /// </summary>
+    /// <remarks>
+    /// <para>The filter only applies to sensors for which a threshold has
+    /// been set, whereas the samples of all other sensors are released
+    /// directly. A sample of a filtered sensor is released if its voltage,
+    /// current or power differs by more than the threshold from the last
+    /// sample released, if it belongs to another marker, or if the
+    /// keep-alive interval has passed since the last sample released. All
+    /// other samples are retained, but only the newest one is kept.</para>
+    /// <para>If a sample is released due to a change, the retained sample is
+    /// released before it. The retained sample marks the end of the plateau,
+    /// such that the time of the step is preserved, and holding each value
+    /// until the next sample reconstructs the signal within the threshold.
+    /// </para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API delta_filter final {
+
+    public:
+
+        /// <summary>
+        /// A sample along with the ID of the marker active for it.
+        /// </summary>
+        typedef std::pair<measurement, std::uint32_t> sample_type;
+
+        /// <summary>
+        /// Initialises a new instance, which is disabled.
+        /// </summary>
+        delta_filter(void);
+
+        /// <summary>
+        /// Configures the keep-alive interval and clears all thresholds and
+        /// retained samples.
+        /// </summary>
+        /// <param name="keep_alive">The time in ticks of the timestamps after
+        /// which an unchanged sample is released. Zero disables the
+        /// keep-alive samples.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="keep_alive" /> is negative.</exception>
+        void configure(_In_ const measurement::timestamp_type keep_alive);
+
+        /// <summary>
+        /// Answer whether any sensor is filtered.
+        /// </summary>
+        /// <returns><c>true</c> if at least one threshold has been set,
+        /// <c>false</c> if all samples are released.</returns>
+        inline bool enabled(void) const noexcept {
+            return !this->_thresholds.empty();
+        }
+
+        /// <summary>
+        /// Releases the retained samples of all sensors.
+        /// </summary>
+        /// <param name="dst">Receives the retained samples, which are
+        /// appended.</param>
+        void flush(_Inout_ std::vector<sample_type>& dst);
+
+        /// <summary>
+        /// Adds a sample.
+        /// </summary>
+        /// <param name="sample">The sample to be added.</param>
+        /// <param name="marker">The ID of the marker active for the sample.
+        /// </param>
+        /// <param name="dst">Receives the samples released, which are
+        /// appended. This might be nothing, the sample itself or the sample
+        /// preceded by the last sample retained for the same sensor.</param>
+        void push(_In_ const measurement& sample,
+            _In_ const std::uint32_t marker,
+            _Inout_ std::vector<sample_type>& dst);
+
+        /// <summary>
+        /// Sets the threshold for the sensor with the given name.
+        /// </summary>
+        /// <param name="sensor">The name of the sensor.</param>
+        /// <param name="threshold">The change a sample must exceed to be
+        /// released, or a negative number to release all samples of the
+        /// sensor.</param>
+        void threshold(_In_ const std::wstring& sensor,
+            _In_ const measurement::value_type threshold);
+
+    private:
+
+        /// <summary>
+        /// The state of a single sensor.
+        /// </summary>
+        struct state_type {
+            sample_type held;
+            bool is_held;
+            sample_type last;
+            bool is_started;
+            measurement::value_type threshold;
+
+            inline state_type(_In_ const measurement& sample,
+                    _In_ const measurement::value_type threshold)
+                : held(sample, 0), is_held(false), last(sample, 0),
+                is_started(false), threshold(threshold) { }
+        };
+
+        /// <summary>
+        /// Answer whether <paramref name="sample" /> differs from the last
+        /// sample released for <paramref name="state" />.
+        /// </summary>
+        static bool changed(_In_ const state_type& state,
+            _In_ const measurement& sample,
+            _In_ const std::uint32_t marker) noexcept;
+
+        measurement::timestamp_type _keep_alive;
+        std::unordered_map<const wchar_t *, state_type> _states;
+        std::unordered_map<std::wstring, measurement::value_type> _thresholds;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,384 @@
+﻿// <copyright file="derived_evaluator.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "derived_evaluator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+
+#include "sensor_name_registry.h"
+#include "waveform_kernels.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Answer the index of the last grid point at or before
+    /// <paramref name="timestamp" />.
+    /// </summary>
+    static inline measurement::timestamp_type floor_grid(
+            _In_ const measurement::timestamp_type timestamp,
+            _In_ const measurement::timestamp_type step) noexcept {
+        assert(step > 0);
+        auto retval = timestamp / step;
+        if ((timestamp % step != 0) && (timestamp < 0)) {
+            --retval;
+        }
+        return retval;
+    }
+
+    /// <summary>
+    /// Answer the index of the first grid point at or after
+    /// <paramref name="timestamp" />.
+    /// </summary>
+    static inline measurement::timestamp_type ceil_grid(
+            _In_ const measurement::timestamp_type timestamp,
+            _In_ const measurement::timestamp_type step) noexcept {
+        auto retval = floor_grid(timestamp, step);
+        if (retval * step < timestamp) {
+            ++retval;
+        }
+        return retval;
+    }
+
+    /// <summary>
+    /// Answer the requested value of a sample, which is NaN if the sensor
+    /// does not provide it.
+    /// </summary>
+    static inline float value_of(_In_ const measurement_data& sample,
+            _In_ const derived_expression::quantity_type quantity) noexcept {
+        const auto invalid = measurement_data::invalid_value;
+        switch (quantity) {
+            case derived_expression::quantity_type::current:
+                return (sample.current() != invalid)
+                    ? sample.current()
+                    : std::numeric_limits<float>::quiet_NaN();
+
+            case derived_expression::quantity_type::voltage:
+                return (sample.voltage() != invalid)
+                    ? sample.voltage()
+                    : std::numeric_limits<float>::quiet_NaN();
+
+            default:
+                return sample.power();
+        }
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::derived_evaluator::max_history
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::derived_evaluator::max_history;
+
+
+/*
+ * visus::power_overwhelming::detail::derived_evaluator::derived_evaluator
+ */
+visus::power_overwhelming::detail::derived_evaluator::derived_evaluator(void)
+    : _step(0) { }
+
+
+/*
+ * visus::power_overwhelming::detail::derived_evaluator::add
+ */
+void visus::power_overwhelming::detail::derived_evaluator::add(
+        _In_z_ const wchar_t *name,
+        _In_z_ const wchar_t *expression) {
+    if (name == nullptr) {
+        throw std::invalid_argument("The name of a derived sensor must not be "
+            "null.");
+    }
+
+    const auto n = sensor_name_registry::intern(name);
+    for (auto& s : this->_sensors) {
+        if (s.name == n) {
+            throw std::invalid_argument("The names of derived sensors must be "
+                "unique.");
+        }
+    }
+
+    sensor_type sensor(n, expression);
+    if (sensor.expression.inputs().empty()) {
+        throw std::invalid_argument("The expression of a derived sensor must "
+            "refer to at least one other sensor.");
+    }
+
+    for (auto& i : sensor.expression.inputs()) {
+        // All inputs from the same sensor share the history of its samples.
+        const auto source = sensor_name_registry::intern(i.sensor.c_str());
+        auto it = this->_sources.find(source);
+        if (it == this->_sources.end()) {
+            it = this->_sources.emplace(source, this->_samples.size()).first;
+            this->_samples.emplace_back();
+        }
+
+        auto jt = std::find_if(this->_inputs.begin(), this->_inputs.end(),
+                [&i, it](const input_type& j) {
+            return (j.quantity == i.quantity) && (j.samples == it->second);
+        });
+        if (jt == this->_inputs.end()) {
+            this->_inputs.push_back(input_type { i.quantity, it->second });
+            jt = this->_inputs.end() - 1;
+        }
+
+        sensor.inputs.push_back(jt - this->_inputs.begin());
+    }
+
+    this->_sensors.push_back(std::move(sensor));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::derived_evaluator::clear
+ */
+void visus::power_overwhelming::detail::derived_evaluator::clear(
+        void) noexcept {
+    this->_inputs.clear();
+    this->_samples.clear();
+    this->_sensors.clear();
+    this->_sources.clear();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::derived_evaluator::configure
+ */
+void visus::power_overwhelming::detail::derived_evaluator::configure(
+        _In_ const measurement::timestamp_type step) {
+    if (step < 0) {
+        throw std::invalid_argument("The step of the grid for the derived "
+            "sensors must not be negative.");
+    }
+
+    for (auto& s : this->_samples) {
+        s.clear();
+    }
+    for (auto& s : this->_sensors) {
+        s.next = (std::numeric_limits<measurement::timestamp_type>::lowest)();
+    }
+
+    this->_step = step;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::derived_evaluator::evaluate
+ */
+void visus::power_overwhelming::detail::derived_evaluator::evaluate(
+        _Inout_ std::vector<measurement>& dst) {
+    typedef measurement::timestamp_type timestamp_type;
+
+    if (!this->enabled()) {
+        return;
+    }
+
+    for (auto& s : this->_sensors) {
+        auto begin = (std::numeric_limits<timestamp_type>::lowest)();
+        auto end = (std::numeric_limits<timestamp_type>::max)();
+        auto ready = true;
+
+        // The grid points that can be evaluated are the ones covered by the
+        // samples of all inputs.
+        for (auto i : s.inputs) {
+            auto& samples = this->_samples[this->_inputs[i].samples];
+            if (samples.empty()) {
+                ready = false;
+                break;
+            }
+
+            begin = (std::max)(begin, samples.front().timestamp());
+            end = (std::min)(end, samples.back().timestamp());
+        }
+
+        if (!ready) {
+            continue;
+        }
+
+        const auto first = (std::max)(s.next, ceil_grid(begin, this->_step));
+        const auto last = floor_grid(end, this->_step);
+        if (last < first) {
+            continue;
+        }
+
+        const auto cnt = static_cast<std::size_t>(last - first + 1);
+        const auto& inputs = s.expression.inputs();
+        if (this->_columns.size() < inputs.size()) {
+            this->_columns.resize(inputs.size());
+        }
+        this->_pointers.resize(inputs.size());
+
+        for (std::size_t i = 0; i < inputs.size(); ++i) {
+            auto& column = this->_columns[i];
+            column.resize(cnt);
+            this->interpolate(column.data(), this->_inputs[s.inputs[i]],
+                first, cnt);
+            this->_pointers[i] = column.data();
+        }
+
+        this->_results.resize(cnt);
+        s.expression.evaluate(this->_results.data(), this->_pointers.data(),
+            cnt);
+
+        // Derived sensors might be the inputs of the ones added after them.
+        auto source = this->_sources.find(s.name);
+        auto history = (source != this->_sources.end())
+            ? &this->_samples[source->second]
+            : nullptr;
+
+        for (std::size_t i = 0; i < cnt; ++i) {
+            // Inputs that do not provide the quantity yield NaN.
+            const auto value = this->_results[i];
+            if (std::isnan(value)) {
+                continue;
+            }
+
+            const auto t = (first + static_cast<timestamp_type>(i))
+                * this->_step;
+            dst.emplace_back(s.name, t, value);
+            if (history != nullptr) {
+                history->emplace_back(t, value);
+            }
+        }
+
+        s.next = last + 1;
+    }
+
+    // Discard the samples that are older than the segment the next grid
+    // point of any derived sensor using them falls into.
+    for (std::size_t i = 0; i < this->_samples.size(); ++i) {
+        auto needed = (std::numeric_limits<timestamp_type>::max)();
+        for (auto& s : this->_sensors) {
+            for (auto j : s.inputs) {
+                if (this->_inputs[j].samples == i) {
+                    needed = (std::min)(needed, s.next);
+                }
+            }
+        }
+
+        auto& samples = this->_samples[i];
+        if (needed == (std::numeric_limits<timestamp_type>::lowest)()) {
+            continue;
+        }
+
+        const auto t = (needed == (std::numeric_limits<timestamp_type>::max)())
+            ? needed
+            : needed * this->_step;
+        auto it = std::upper_bound(samples.begin(), samples.end(), t,
+                [](const timestamp_type lhs, const measurement_data& rhs) {
+            return (lhs < rhs.timestamp());
+        });
+        if (it != samples.begin()) {
+            samples.erase(samples.begin(), it - 1);
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::derived_evaluator::names
+ */
+std::vector<std::wstring>
+visus::power_overwhelming::detail::derived_evaluator::names(void) const {
+    std::vector<std::wstring> retval;
+    retval.reserve(this->_sensors.size());
+
+    for (auto& s : this->_sensors) {
+        retval.emplace_back(s.name);
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::derived_evaluator::push
+ */
+void visus::power_overwhelming::detail::derived_evaluator::push(
+        _In_ const measurement& sample) {
+    if (!this->enabled() || !sample) {
+        return;
+    }
+
+    auto it = this->_sources.find(sample.sensor());
+    if (it == this->_sources.end()) {
+        return;
+    }
+
+    auto& samples = this->_samples[it->second];
+    if (!samples.empty()
+            && (sample.timestamp() <= samples.back().timestamp())) {
+        return;
+    }
+
+    if (samples.size() >= max_history) {
+        // Drop half of the history at once such that a stalled input does not
+        // cause the history to be moved for each sample.
+        samples.erase(samples.begin(), samples.begin() + max_history / 2);
+    }
+
+    samples.push_back(sample.data());
+}
+
+
+/*
+ * visus::power_overwhelming::detail::derived_evaluator::interpolate
+ */
+void visus::power_overwhelming::detail::derived_evaluator::interpolate(
+        _Out_writes_(cnt) float *dst,
+        _In_ const input_type& input,
+        _In_ const measurement::timestamp_type first,
+        _In_ const std::size_t cnt) const {
+    typedef measurement::timestamp_type timestamp_type;
+    auto& samples = this->_samples[input.samples];
+    assert(!samples.empty());
+
+    auto t = first * this->_step;
+    auto k = static_cast<std::size_t>(std::upper_bound(samples.begin(),
+        samples.end(), t, [](const timestamp_type lhs,
+            const measurement_data& rhs) {
+        return (lhs < rhs.timestamp());
+    }) - samples.begin());
+    assert(k > 0);
+    --k;
+
+    for (std::size_t i = 0; i < cnt;) {
+        const auto& lhs = samples[k];
+        const auto v0 = value_of(lhs, input.quantity);
+
+        if (k + 1 == samples.size()) {
+            // Only the grid point exactly at the last sample can be left.
+            std::fill(dst + i, dst + cnt, v0);
+            break;
+        }
+
+        const auto& rhs = samples[k + 1];
+        const auto t0 = lhs.timestamp();
+        const auto t1 = rhs.timestamp();
+
+        if (t < t1) {
+            // Interpolate all grid points in [t0, t1) at once.
+            const auto n = (std::min)(cnt - i, static_cast<std::size_t>(
+                (t1 - t + this->_step - 1) / this->_step));
+            const auto d = static_cast<float>(t1 - t0);
+            interpolate_waveform(dst + i, n, v0,
+                value_of(rhs, input.quantity),
+                static_cast<float>(t - t0) / d,
+                static_cast<float>(this->_step) / d);
+            i += n;
+            t += static_cast<timestamp_type>(n) * this->_step;
+        }
+
+        ++k;
+    }
+}
@@ -0,0 +1,149 @@
+﻿// <copyright file="derived_evaluator.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "power_overwhelming/measurement.h"
+
+#include "derived_expression.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Computes the samples of derived sensors from the samples of the
+    /// sensors their expressions refer to.
+    /// </summary>
+    /// <remarks>
+    /// <para>The samples of different sensors are not synchronised, so the
+    /// evaluator aligns them on a grid consisting of the multiples of its
+    /// step before evaluating the expressions. Each input is interpolated
+    /// linearly onto the grid points, which yields one column per input, and
+    /// the compiled <see cref="derived_expression" /> is then evaluated for
+    /// the whole batch of grid points at once. A derived sensor can use the
+    /// derived sensors that have been added before it.</para>
+    /// <para>A grid point can only be evaluated once all inputs have a
+    /// sample at or after it, so the derived samples lag behind the slowest
+    /// of their inputs. Samples of the inputs are retained until no derived
+    /// sensor needs them anymore, but at most <see cref="max_history" />
+    /// samples per input, such that an input that stops delivering samples
+    /// cannot exhaust the memory.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API derived_evaluator final {
+
+    public:
+
+        /// <summary>
+        /// The maximum number of samples that are retained for an input.
+        /// </summary>
+        static constexpr std::size_t max_history = 1 << 16;
+
+        /// <summary>
+        /// Initialises a new instance without any derived sensors.
+        /// </summary>
+        derived_evaluator(void);
+
+        /// <summary>
+        /// Compiles and adds a derived sensor.
+        /// </summary>
+        /// <param name="name">The name of the derived sensor.</param>
+        /// <param name="expression">The expression computing its power.
+        /// </param>
+        /// <exception cref="std::invalid_argument">If any of the parameters is
+        /// <c>nullptr</c>, if a sensor with the same name has already been
+        /// added, or if the expression is invalid or does not refer to any
+        /// sensor.</exception>
+        void add(_In_z_ const wchar_t *name, _In_z_ const wchar_t *expression);
+
+        /// <summary>
+        /// Removes all derived sensors.
+        /// </summary>
+        void clear(void) noexcept;
+
+        /// <summary>
+        /// Sets the step of the grid and forgets all samples.
+        /// </summary>
+        /// <param name="step">The distance between two grid points in ticks
+        /// of the timestamps, or zero to disable the derived sensors.</param>
+        /// <exception cref="std::invalid_argument">If <paramref name="step" />
+        /// is negative.</exception>
+        void configure(_In_ const measurement::timestamp_type step);
+
+        /// <summary>
+        /// Answer whether any derived sensor is evaluated.
+        /// </summary>
+        /// <returns><c>true</c> if there are derived sensors and a grid,
+        /// <c>false</c> otherwise.</returns>
+        inline bool enabled(void) const noexcept {
+            return (!this->_sensors.empty() && (this->_step > 0));
+        }
+
+        /// <summary>
+        /// Evaluates all grid points for which the samples of the inputs are
+        /// available.
+        /// </summary>
+        /// <param name="dst">Receives the derived samples, which are appended
+        /// in order of the sensors and their timestamps.</param>
+        void evaluate(_Inout_ std::vector<measurement>& dst);
+
+        /// <summary>
+        /// Answer the names of the derived sensors.
+        /// </summary>
+        /// <returns>The names of the derived sensors in the order they have
+        /// been added.</returns>
+        std::vector<std::wstring> names(void) const;
+
+        /// <summary>
+        /// Retains the given sample if it is an input of any derived sensor.
+        /// </summary>
+        /// <param name="sample">The sample to be added. Samples that are older
+        /// than the last one of the same sensor are ignored.</param>
+        void push(_In_ const measurement& sample);
+
+    private:
+
+        struct sensor_type {
+            derived_expression expression;
+            std::vector<std::size_t> inputs;
+            const wchar_t *name;
+            measurement::timestamp_type next;
+            inline sensor_type(_In_z_ const wchar_t *name,
+                    _In_z_ const wchar_t *expression)
+                : expression(expression), name(name),
+                next((std::numeric_limits<measurement::timestamp_type>
+                    ::lowest)()) { }
+        };
+
+        struct input_type {
+            derived_expression::quantity_type quantity;
+            std::size_t samples;
+        };
+
+        void interpolate(_Out_writes_(cnt) float *dst,
+            _In_ const input_type& input,
+            _In_ const measurement::timestamp_type first,
+            _In_ const std::size_t cnt) const;
+
+        std::vector<std::vector<float>> _columns;
+        std::vector<input_type> _inputs;
+        std::vector<const float *> _pointers;
+        std::vector<float> _results;
+        std::vector<std::vector<measurement_data>> _samples;
+        std::unordered_map<const wchar_t *, std::size_t> _sources;
+        std::vector<sensor_type> _sensors;
+        measurement::timestamp_type _step;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,403 @@
+﻿// <copyright file="derived_expression.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "derived_expression.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cwctype>
+#include <limits>
+#include <stdexcept>
+
+#include "power_overwhelming/convert_string.h"
+
+
+/*
+ * visus::power_overwhelming::detail::derived_expression::operand_type
+ */
+struct visus::power_overwhelming::detail::derived_expression::operand_type {
+    bool constant;
+    float value;
+};
+
+
+/*
+ * visus::power_overwhelming::detail::derived_expression::parser
+ */
+class visus::power_overwhelming::detail::derived_expression::parser final {
+
+public:
+
+    inline parser(_Inout_ derived_expression& expression,
+            _In_z_ const wchar_t *text)
+        : _cur(text), _expression(expression), _text(text) { }
+
+    void parse(void) {
+        auto retval = this->sum(0);
+
+        this->skip();
+        if (*this->_cur != 0) {
+            this->fail("unexpected character");
+        }
+
+        // The result of the program is always in the first register.
+        this->materialise(retval, 0);
+    }
+
+private:
+
+    typedef std::uint16_t register_type;
+
+    operand_type binary(_In_ const opcode_type opcode,
+            _In_ const operand_type& lhs,
+            _In_ const operand_type& rhs,
+            _In_ const register_type depth) {
+        if (lhs.constant && rhs.constant) {
+            operand_type retval { true, lhs.value };
+            switch (opcode) {
+                case opcode_type::add: retval.value += rhs.value; break;
+                case opcode_type::divide: retval.value /= rhs.value; break;
+                case opcode_type::multiply: retval.value *= rhs.value; break;
+                case opcode_type::subtract: retval.value -= rhs.value; break;
+                default: assert(false); break;
+            }
+            return retval;
+        }
+
+        // The right-hand side has been evaluated into the next register,
+        // which does not interfere with filling the current one.
+        this->materialise(lhs, depth);
+        this->materialise(rhs, depth + 1);
+        this->emit(opcode, depth, depth, depth + 1);
+        return operand_type { false, 0.0f };
+    }
+
+    void emit(_In_ const opcode_type opcode,
+            _In_ const register_type dst,
+            _In_ const register_type lhs = 0,
+            _In_ const register_type rhs = 0,
+            _In_ const float value = 0.0f) {
+        this->_expression._program.push_back(
+            instruction_type { opcode, dst, lhs, rhs, value });
+        this->_expression._registers = (std::max)(
+            this->_expression._registers, std::size_t(dst) + 1);
+    }
+
+    [[noreturn]] void fail(_In_z_ const char *reason) const {
+        const auto position = this->_cur - this->_text;
+        throw std::invalid_argument("The derived expression \""
+            + power_overwhelming::convert_string<char>(this->_text)
+            + "\" is invalid at position " + std::to_string(position) + ": "
+            + reason + ".");
+    }
+
+    register_type next(_In_ const register_type depth) const {
+        if (depth == (std::numeric_limits<register_type>::max)()) {
+            this->fail("the expression is nested too deeply");
+        }
+        return depth + 1;
+    }
+
+    void materialise(_In_ const operand_type& operand,
+            _In_ const register_type dst) {
+        if (operand.constant) {
+            this->emit(opcode_type::constant, dst, 0, 0, operand.value);
+        }
+    }
+
+    operand_type number(void) {
+        // We parse the number ourselves, because the library functions would
+        // depend on the locale.
+        double mantissa = 0.0;
+        int exponent = 0;
+        auto digits = false;
+
+        while (std::iswdigit(*this->_cur)) {
+            mantissa = 10.0 * mantissa + (*this->_cur++ - L'0');
+            digits = true;
+        }
+
+        if (*this->_cur == L'.') {
+            ++this->_cur;
+            while (std::iswdigit(*this->_cur)) {
+                mantissa = 10.0 * mantissa + (*this->_cur++ - L'0');
+                --exponent;
+                digits = true;
+            }
+        }
+
+        if (!digits) {
+            this->fail("a number was expected");
+        }
+
+        if ((*this->_cur == L'e') || (*this->_cur == L'E')) {
+            ++this->_cur;
+            const auto negative = (*this->_cur == L'-');
+            if (negative || (*this->_cur == L'+')) {
+                ++this->_cur;
+            }
+            if (!std::iswdigit(*this->_cur)) {
+                this->fail("the exponent of the number is missing");
+            }
+
+            int e = 0;
+            while (std::iswdigit(*this->_cur)) {
+                e = (std::min)(10 * e + (*this->_cur++ - L'0'), 10000);
+            }
+            exponent += negative ? -e : e;
+        }
+
+        const auto value = mantissa * std::pow(10.0, exponent);
+        return operand_type { true, static_cast<float>(value) };
+    }
+
+    operand_type primary(_In_ const register_type depth) {
+        this->skip();
+
+        if (*this->_cur == L'(') {
+            ++this->_cur;
+            auto retval = this->sum(depth);
+            this->skip();
+            if (*this->_cur != L')') {
+                this->fail("a closing parenthesis was expected");
+            }
+            ++this->_cur;
+            return retval;
+        }
+
+        if (*this->_cur == L'[') {
+            return this->reference(depth);
+        }
+
+        return this->number();
+    }
+
+    operand_type product(_In_ const register_type depth) {
+        auto retval = this->unary(depth);
+
+        while (true) {
+            this->skip();
+
+            if (*this->_cur == L'*') {
+                ++this->_cur;
+                auto rhs = this->unary(this->next(depth));
+                retval = this->binary(opcode_type::multiply, retval, rhs,
+                    depth);
+
+            } else if (*this->_cur == L'/') {
+                ++this->_cur;
+                auto rhs = this->unary(this->next(depth));
+                retval = this->binary(opcode_type::divide, retval, rhs, depth);
+
+            } else {
+                return retval;
+            }
+        }
+    }
+
+    operand_type reference(_In_ const register_type depth) {
+        assert(*this->_cur == L'[');
+        auto begin = ++this->_cur;
+        while ((*this->_cur != 0) && (*this->_cur != L']')) {
+            ++this->_cur;
+        }
+        if (*this->_cur != L']') {
+            this->fail("a closing bracket was expected");
+        }
+
+        input_type input { quantity_type::power,
+            std::wstring(begin, this->_cur++) };
+        if (input.sensor.empty()) {
+            this->fail("the name of the sensor is missing");
+        }
+
+        if (*this->_cur == L'.') {
+            begin = ++this->_cur;
+            while (std::iswalpha(*this->_cur)) {
+                ++this->_cur;
+            }
+
+            const std::wstring quantity(begin, this->_cur);
+            if (quantity == L"current") {
+                input.quantity = quantity_type::current;
+            } else if (quantity == L"power") {
+                input.quantity = quantity_type::power;
+            } else if (quantity == L"voltage") {
+                input.quantity = quantity_type::voltage;
+            } else {
+                this->_cur = begin;
+                this->fail("the quantity must be \"current\", \"power\" or "
+                    "\"voltage\"");
+            }
+        }
+
+        // Each value of a sensor is an input only once, no matter how often
+        // it is used.
+        auto& inputs = this->_expression._inputs;
+        auto it = std::find_if(inputs.begin(), inputs.end(),
+                [&input](const input_type& i) {
+            return (i.quantity == input.quantity) && (i.sensor == input.sensor);
+        });
+        if (it == inputs.end()) {
+            inputs.push_back(std::move(input));
+            it = inputs.end() - 1;
+        }
+
+        const auto index = static_cast<std::size_t>(it - inputs.begin());
+        if (index > (std::numeric_limits<register_type>::max)()) {
+            this->fail("the expression uses too many sensors");
+        }
+
+        this->emit(opcode_type::load, depth,
+            static_cast<register_type>(index));
+        return operand_type { false, 0.0f };
+    }
+
+    inline void skip(void) noexcept {
+        while (std::iswspace(*this->_cur)) {
+            ++this->_cur;
+        }
+    }
+
+    operand_type sum(_In_ const register_type depth) {
+        auto retval = this->product(depth);
+
+        while (true) {
+            this->skip();
+
+            if (*this->_cur == L'+') {
+                ++this->_cur;
+                auto rhs = this->product(this->next(depth));
+                retval = this->binary(opcode_type::add, retval, rhs, depth);
+
+            } else if (*this->_cur == L'-') {
+                ++this->_cur;
+                auto rhs = this->product(this->next(depth));
+                retval = this->binary(opcode_type::subtract, retval, rhs,
+                    depth);
+
+            } else {
+                return retval;
+            }
+        }
+    }
+
+    operand_type unary(_In_ const register_type depth) {
+        this->skip();
+
+        if (*this->_cur == L'+') {
+            ++this->_cur;
+            return this->unary(depth);
+        }
+
+        if (*this->_cur == L'-') {
+            ++this->_cur;
+            auto retval = this->unary(depth);
+            if (retval.constant) {
+                retval.value = -retval.value;
+            } else {
+                this->emit(opcode_type::negate, depth, depth);
+            }
+            return retval;
+        }
+
+        return this->primary(depth);
+    }
+
+    const wchar_t *_cur;
+    derived_expression& _expression;
+    const wchar_t *_text;
+};
+
+
+/*
+ * visus::power_overwhelming::detail::derived_expression::block_size
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::derived_expression::block_size;
+
+
+/*
+ * visus::power_overwhelming::detail::derived_expression::derived_expression
+ */
+visus::power_overwhelming::detail::derived_expression::derived_expression(
+        _In_z_ const wchar_t *expression) : _registers(0) {
+    if (expression == nullptr) {
+        throw std::invalid_argument("The expression of a derived sensor must "
+            "not be null.");
+    }
+
+    parser(*this, expression).parse();
+    assert(this->_registers > 0);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::derived_expression::evaluate
+ */
+void visus::power_overwhelming::detail::derived_expression::evaluate(
+        _Out_writes_(cnt) float *dst,
+        _In_ const float *const *inputs,
+        _In_ const std::size_t cnt) {
+    assert((dst != nullptr) || (cnt == 0));
+    assert((inputs != nullptr) || this->_inputs.empty());
+    this->_scratch.resize(this->_registers * block_size);
+    auto registers = this->_scratch.data();
+
+    for (std::size_t b = 0; b < cnt; b += block_size) {
+        const auto n = (std::min)(block_size, cnt - b);
+
+        // Each instruction is a simple loop over the block, which allows the
+        // compiler to vectorise it.
+        for (auto& i : this->_program) {
+            auto d = registers + i.dst * block_size;
+            auto l = registers + i.lhs * block_size;
+            auto r = registers + i.rhs * block_size;
+
+            switch (i.opcode) {
+                case opcode_type::add:
+                    for (std::size_t k = 0; k < n; ++k) {
+                        d[k] = l[k] + r[k];
+                    }
+                    break;
+
+                case opcode_type::constant:
+                    std::fill(d, d + n, i.value);
+                    break;
+
+                case opcode_type::divide:
+                    for (std::size_t k = 0; k < n; ++k) {
+                        d[k] = l[k] / r[k];
+                    }
+                    break;
+
+                case opcode_type::load:
+                    std::copy(inputs[i.lhs] + b, inputs[i.lhs] + b + n, d);
+                    break;
+
+                case opcode_type::multiply:
+                    for (std::size_t k = 0; k < n; ++k) {
+                        d[k] = l[k] * r[k];
+                    }
+                    break;
+
+                case opcode_type::negate:
+                    for (std::size_t k = 0; k < n; ++k) {
+                        d[k] = -l[k];
+                    }
+                    break;
+
+                case opcode_type::subtract:
+                    for (std::size_t k = 0; k < n; ++k) {
+                        d[k] = l[k] - r[k];
+                    }
+                    break;
+            }
+        }
+
+        std::copy(registers, registers + n, dst + b);
+    }
+}
@@ -0,0 +1,142 @@
+﻿// <copyright file="derived_expression.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <string>
+#include <vector>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// An arithmetic expression over the samples of other sensors, which has
+    /// been compiled into a flat program.
+    /// </summary>
+    /// <remarks>
+    /// <para>The expression consists of numbers, references to sensors in
+    /// square brackets, the binary operators <c>+</c>, <c>-</c>, <c>*</c> and
+    /// <c>/</c>, unary signs and parentheses. A reference like
+    /// <c>[nvml/0]</c> denotes the power of the sensor, and the voltage or
+    /// the current can be selected by appending <c>.voltage</c> or
+    /// <c>.current</c> to the brackets, e.g. <c>[tinker/12V].current</c>.
+    /// </para>
+    /// <para>The program is a sequence of instructions on registers, each of
+    /// which holds a whole column of values. Evaluating the program therefore
+    /// executes one tight loop per instruction over a block of rows, which
+    /// the compiler can vectorise, instead of interpreting a tree for each
+    /// row. Sub-expressions that only consist of numbers are folded while
+    /// compiling.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API derived_expression final {
+
+    public:
+
+        /// <summary>
+        /// Identifies the value of a sensor that an input refers to.
+        /// </summary>
+        enum class quantity_type : std::uint8_t {
+            current,
+            power,
+            voltage
+        };
+
+        /// <summary>
+        /// Describes a value of another sensor that the expression uses.
+        /// </summary>
+        struct input_type {
+
+            /// <summary>
+            /// The value of the sensor that is used.
+            /// </summary>
+            quantity_type quantity;
+
+            /// <summary>
+            /// The name of the sensor.
+            /// </summary>
+            std::wstring sensor;
+        };
+
+        /// <summary>
+        /// The number of rows that are evaluated at once, which is chosen such
+        /// that the registers remain in the L1 cache.
+        /// </summary>
+        static constexpr std::size_t block_size = 256;
+
+        /// <summary>
+        /// Compiles the given expression.
+        /// </summary>
+        /// <param name="expression">The expression to compile.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="expression" /> is <c>nullptr</c> or not a valid
+        /// expression.</exception>
+        explicit derived_expression(_In_z_ const wchar_t *expression);
+
+        /// <summary>
+        /// Evaluates the expression for a batch of rows.
+        /// </summary>
+        /// <param name="dst">Receives <paramref name="cnt" /> results.</param>
+        /// <param name="inputs">The columns of the <see cref="inputs" /> in
+        /// the order they are reported, each holding <paramref name="cnt" />
+        /// values.</param>
+        /// <param name="cnt">The number of rows to evaluate.</param>
+        void evaluate(_Out_writes_(cnt) float *dst,
+            _In_ const float *const *inputs,
+            _In_ const std::size_t cnt);
+
+        /// <summary>
+        /// Answer the values of other sensors the expression uses.
+        /// </summary>
+        /// <returns>The distinct inputs of the expression.</returns>
+        inline const std::vector<input_type>& inputs(void) const noexcept {
+            return this->_inputs;
+        }
+
+        /// <summary>
+        /// Answer the number of instructions of the compiled program.
+        /// </summary>
+        /// <returns>The length of the program.</returns>
+        inline std::size_t size(void) const noexcept {
+            return this->_program.size();
+        }
+
+    private:
+
+        enum class opcode_type : std::uint8_t {
+            add,
+            constant,
+            divide,
+            load,
+            multiply,
+            negate,
+            subtract
+        };
+
+        struct instruction_type {
+            opcode_type opcode;
+            std::uint16_t dst;
+            std::uint16_t lhs;
+            std::uint16_t rhs;
+            float value;
+        };
+
+        struct operand_type;
+
+        class parser;
+
+        std::vector<input_type> _inputs;
+        std::vector<instruction_type> _program;
+        std::size_t _registers;
+        std::vector<float> _scratch;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
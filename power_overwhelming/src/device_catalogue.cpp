@@ -0,0 +1,122 @@
+﻿// <copyright file="device_catalogue.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/device_catalogue.h"
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <cfgmgr32.h>
+
+#pragma comment(lib, "cfgmgr32.lib")
+#endif /* defined(_WIN32) */
+
+#include "cached_discovery.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+#if defined(_WIN32)
+    /// <summary>
+    /// Invalidates the <see cref="device_catalogue" /> whenever a device
+    /// interface arrives or is removed.
+    /// </summary>
+    static DWORD CALLBACK on_device_interface_change(_In_ HCM_NOTIFY handle,
+            _In_opt_ PVOID context, _In_ CM_NOTIFY_ACTION action,
+            _In_reads_bytes_(size) PCM_NOTIFY_EVENT_DATA data,
+            _In_ DWORD size) {
+        switch (action) {
+            case CM_NOTIFY_ACTION_DEVICEINTERFACEARRIVAL:
+            case CM_NOTIFY_ACTION_DEVICEINTERFACEREMOVAL:
+                device_catalogue::invalidate();
+                break;
+
+            default:
+                break;
+        }
+
+        return ERROR_SUCCESS;
+    }
+
+    /// <summary>
+    /// RAII wrapper for the PnP notification registered by the
+    /// <see cref="device_catalogue" />.
+    /// </summary>
+    struct device_catalogue_notification final {
+        HCM_NOTIFY handle;
+
+        inline device_catalogue_notification(void) : handle(nullptr) {
+            CM_NOTIFY_FILTER filter;
+            ::ZeroMemory(&filter, sizeof(filter));
+            filter.cbSize = sizeof(filter);
+            filter.Flags = CM_NOTIFY_FILTER_FLAG_ALL_INTERFACE_CLASSES;
+            filter.FilterType = CM_NOTIFY_FILTER_TYPE_DEVICEINTERFACE;
+
+            // If we cannot register for notifications, the catalogue can only
+            // be refreshed on demand, which is not an error.
+            if (::CM_Register_Notification(&filter, nullptr,
+                    on_device_interface_change, &this->handle) != CR_SUCCESS) {
+                this->handle = nullptr;
+            }
+        }
+
+        inline ~device_catalogue_notification(void) {
+            if (this->handle != nullptr) {
+                ::CM_Unregister_Notification(this->handle);
+            }
+        }
+    };
+#endif /* defined(_WIN32) */
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::refresh_device_catalogue
+ */
+void visus::power_overwhelming::refresh_device_catalogue(void) noexcept {
+    detail::device_catalogue::invalidate();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::device_catalogue::generation
+ */
+visus::power_overwhelming::detail::device_catalogue::generation_type
+visus::power_overwhelming::detail::device_catalogue::generation(void) {
+    std::call_once(_watch, [](void) {
+#if defined(_WIN32)
+        static device_catalogue_notification notification;
+#endif /* defined(_WIN32) */
+    });
+
+    return _generation.load(std::memory_order_acquire);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::device_catalogue::invalidate
+ */
+void visus::power_overwhelming::detail::device_catalogue::invalidate(
+        void) noexcept {
+    _generation.fetch_add(1, std::memory_order_acq_rel);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::device_catalogue::_generation
+ */
+std::atomic<visus::power_overwhelming::detail::device_catalogue
+    ::generation_type>
+visus::power_overwhelming::detail::device_catalogue::_generation(0);
+
+
+/*
+ * visus::power_overwhelming::detail::device_catalogue::_watch
+ */
+std::once_flag visus::power_overwhelming::detail::device_catalogue::_watch;
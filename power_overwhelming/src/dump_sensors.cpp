@@ -5,6 +5,10 @@
 
 #include "power_overwhelming/dump_sensors.h"
 
+#include <fstream>
+
+#include "power_overwhelming/convert_string.h"
+
 #include "sensor_utilities.h"
 
 
@@ -12,9 +16,7 @@
  * visus::power_overwhelming::dump_sensors
  */
 std::size_t visus::power_overwhelming::dump_sensors(_In_z_ const char *path) {
-    const auto descs = detail::get_all_sensor_descs();
-    detail::write_json(path, descs);
-    return descs.size();
+    return dump_sensors(path, sensor_filter());
 }
 
 
@@ -23,7 +25,41 @@ std::size_t visus::power_overwhelming::dump_sensors(_In_z_ const char *path) {
  */
 std::size_t visus::power_overwhelming::dump_sensors(
         _In_z_ const wchar_t *path) {
-    const auto descs = detail::get_all_sensor_descs();
-    detail::write_json(path, descs);
-    return descs.size();
+    return dump_sensors(path, sensor_filter());
+}
+
+
+/*
+ * visus::power_overwhelming::dump_sensors
+ */
+std::size_t visus::power_overwhelming::dump_sensors(_In_z_ const char *path,
+        _In_ const sensor_filter& filter) {
+    std::ofstream s;
+    s.exceptions(s.exceptions() | std::ios::failbit | std::ios::badbit);
+    s.open(path, std::ofstream::out | std::ofstream::trunc);
+    const auto retval = detail::write_sensor_descs(s, filter);
+    s.flush();
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::dump_sensors
+ */
+std::size_t visus::power_overwhelming::dump_sensors(
+        _In_z_ const wchar_t *path,
+        _In_ const sensor_filter& filter) {
+    std::ofstream s;
+    s.exceptions(s.exceptions() | std::ios::failbit | std::ios::badbit);
+
+#if defined(_WIN32)
+    s.open(path, std::ofstream::out | std::ofstream::trunc);
+#else /* defined(_WIN32) */
+    auto p = power_overwhelming::convert_string<char>(path);
+    s.open(p, std::ofstream::out | std::ofstream::trunc);
+#endif /* defined(_WIN32) */
+
+    const auto retval = detail::write_sensor_descs(s, filter);
+    s.flush();
+    return retval;
 }
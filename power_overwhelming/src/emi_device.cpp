@@ -8,6 +8,7 @@
 #include <cassert>
 #include <memory>
 #include <system_error>
+#include <utility>
 
 
 #if defined(_WIN32)
@@ -16,13 +17,20 @@
  */
 visus::power_overwhelming::detail::emi_device::emi_device(
         const string_type& path)
-        : _handle(INVALID_HANDLE_VALUE), _version({ 0 }) {
+        : _event(nullptr), _handle(INVALID_HANDLE_VALUE), _version({ 0 }) {
     this->_handle = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
-        nullptr, OPEN_EXISTING, 0, NULL);
+        nullptr, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, NULL);
     if (this->_handle == INVALID_HANDLE_VALUE) {
         // Nothing has been allocated in the object here, so it is OK to fail.
         throw std::system_error(::GetLastError(), std::system_category());
     }
+
+    try {
+        this->_event = create_event(true);
+    } catch (...) {
+        ::CloseHandle(this->_handle);
+        throw;
+    }
 }
 
 
@@ -31,7 +39,8 @@ visus::power_overwhelming::detail::emi_device::emi_device(
  */
 
 visus::power_overwhelming::detail::emi_device::emi_device(
-        emi_device&& rhs) noexcept {
+        emi_device&& rhs) noexcept
+        : _event(nullptr), _handle(INVALID_HANDLE_VALUE), _version({ 0 }) {
     *this = std::move(rhs);
 }
 
@@ -43,6 +52,42 @@ visus::power_overwhelming::detail::emi_device::~emi_device(void) noexcept {
     if (this->_handle != INVALID_HANDLE_VALUE) {
         ::CloseHandle(this->_handle);
     }
+
+    destroy_event(this->_event);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::emi_device::control
+ */
+DWORD visus::power_overwhelming::detail::emi_device::control(
+        _In_ const DWORD code,
+        _In_reads_bytes_opt_(input_size) void *input,
+        _In_ const DWORD input_size,
+        _Out_writes_bytes_opt_(output_size) void *output,
+        _In_ const DWORD output_size) const {
+    // The handle has been opened for overlapped I/O, so even synchronous
+    // requests need an OVERLAPPED structure, which must have an event of its
+    // own if multiple threads use the device at the same time.
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    OVERLAPPED overlapped = { 0 };
+    overlapped.hEvent = this->_event;
+    reset_event(this->_event);
+
+    DWORD retval = 0;
+    if (!::DeviceIoControl(this->_handle, code, input, input_size,
+            output, output_size, &retval, &overlapped)) {
+        const auto e = ::GetLastError();
+        if (e != ERROR_IO_PENDING) {
+            throw std::system_error(e, std::system_category());
+        }
+    }
+
+    if (!::GetOverlappedResult(this->_handle, &overlapped, &retval, TRUE)) {
+        throw std::system_error(::GetLastError(), std::system_category());
+    }
+
+    return retval;
 }
 
 
@@ -72,15 +117,9 @@ visus::power_overwhelming::detail::emi_device::metadata(void) const {
     if (this->_metadata.empty()) {
         // Find out how big the metadata are.
         {
-            DWORD returned = 0;
             EMI_METADATA_SIZE size;
-            if (!::DeviceIoControl(this->_handle, IOCTL_EMI_GET_METADATA_SIZE,
-                    nullptr, 0,
-                    &size, sizeof(size),
-                    &returned, 0)) {
-                const auto e = ::GetLastError();
-                throw std::system_error(e, std::system_category());
-            }
+            const auto returned = this->control(IOCTL_EMI_GET_METADATA_SIZE,
+                nullptr, 0, &size, sizeof(size));
             assert(returned == sizeof(size));
 
             this->_metadata.resize(size.MetadataSize);
@@ -88,17 +127,15 @@ visus::power_overwhelming::detail::emi_device::metadata(void) const {
 
         // Retrieve the metadata.
         {
-            DWORD returned = 0;
             const auto size = static_cast<DWORD>(this->_metadata.size());
-            if (!::DeviceIoControl(this->_handle, IOCTL_EMI_GET_METADATA,
-                    nullptr, 0,
-                    this->_metadata.data(), size,
-                    &returned, 0)) {
+            try {
+                const auto returned = this->control(IOCTL_EMI_GET_METADATA,
+                    nullptr, 0, this->_metadata.data(), size);
+                assert(returned == size);
+            } catch (...) {
                 this->_metadata.clear();
-                const auto e = ::GetLastError();
-                throw std::system_error(e, std::system_category());
+                throw;
             }
-            assert(returned == size);
         }
     }
 
@@ -111,14 +148,8 @@ visus::power_overwhelming::detail::emi_device::metadata(void) const {
  */
 EMI_VERSION visus::power_overwhelming::detail::emi_device::version(void) const {
     if (this->_version.EmiVersion < 1) {
-        DWORD returned = 0;
-        if (!::DeviceIoControl(this->_handle, IOCTL_EMI_GET_VERSION,
-                nullptr, 0,
-                &_version, sizeof(_version),
-                &returned, 0)) {
-            const auto e = ::GetLastError();
-            throw std::system_error(e, std::system_category());
-        }
+        const auto returned = this->control(IOCTL_EMI_GET_VERSION,
+            nullptr, 0, &this->_version, sizeof(this->_version));
         assert(returned == sizeof(this->_version));
     }
 
@@ -133,8 +164,8 @@ visus::power_overwhelming::detail::emi_device&
 visus::power_overwhelming::detail::emi_device::operator =(
         emi_device &&rhs) noexcept {
     if (this != std::addressof(rhs)) {
-        this->_handle = rhs._handle;
-        rhs._handle = INVALID_HANDLE_VALUE;
+        std::swap(this->_event, rhs._event);
+        std::swap(this->_handle, rhs._handle);
         this->_metadata = std::move(rhs._metadata);
         this->_version = rhs._version;
         rhs._version.EmiVersion = 0;
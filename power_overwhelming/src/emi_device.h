@@ -6,9 +6,12 @@
 #pragma once
 
 #include <cinttypes>
+#include <mutex>
 #include <string>
 #include <vector>
 
+#include "power_overwhelming/event.h"
+
 #include "setup_api.h"
 
 
@@ -27,6 +30,10 @@ namespace detail {
     /// multiple sensors may share one device. Therefore, we want to be able to
     /// share a device between multiple sensor implementations such that we can
     /// query all channels at once in an asynchronous sampling scenario.</para>
+    /// <para>The device is opened for overlapped I/O such that the sampler can
+    /// issue the requests to multiple devices at once. All requests that are
+    /// not explicitly overlapped must therefore be made via
+    /// <see cref="control" />, which waits for their completion.</para>
     /// </remarks>
     class emi_device final {
 
@@ -62,6 +69,28 @@ namespace detail {
         /// </summary>
         ~emi_device(void) noexcept;
 
+        /// <summary>
+        /// Performs an I/O control request on the device and waits for it to
+        /// complete.
+        /// </summary>
+        /// <param name="code">The control code of the request.</param>
+        /// <param name="input">The input buffer, which may be
+        /// <c>nullptr</c> if <paramref name="input_size" /> is zero.</param>
+        /// <param name="input_size">The size of the input in bytes.</param>
+        /// <param name="output">The output buffer, which may be
+        /// <c>nullptr</c> if <paramref name="output_size" /> is zero.</param>
+        /// <param name="output_size">The size of the output buffer in bytes.
+        /// </param>
+        /// <returns>The number of bytes written to
+        /// <paramref name="output" />.</returns>
+        /// <exception cref="std::system_error">If the request failed.
+        /// </exception>
+        DWORD control(_In_ const DWORD code,
+            _In_reads_bytes_opt_(input_size) void *input,
+            _In_ const DWORD input_size,
+            _Out_writes_bytes_opt_(output_size) void *output,
+            _In_ const DWORD output_size) const;
+
         /// <summary>
         /// Answer the number of channels provided by the device.
         /// </summary>
@@ -143,7 +172,9 @@ namespace detail {
 
     private:
 
+        mutable event_type _event;
         HANDLE _handle;
+        mutable std::mutex _lock;
         mutable metadata_type _metadata;
         mutable EMI_VERSION _version;
 #endif /* defined(_WIN32) */
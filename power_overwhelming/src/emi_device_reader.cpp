@@ -0,0 +1,151 @@
+﻿// <copyright file="emi_device_reader.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "emi_device_reader.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <system_error>
+
+
+#if defined(_WIN32)
+/*
+ * visus::power_overwhelming::detail::emi_device_reader::emi_device_reader
+ */
+visus::power_overwhelming::detail::emi_device_reader::emi_device_reader(
+        _In_ const device_type& device)
+        : _device(device), _error(ERROR_SUCCESS), _state(state_type::idle) {
+    if (this->_device == nullptr) {
+        throw std::invalid_argument("The EMI device to be read must not be "
+            "null.");
+    }
+
+    ::ZeroMemory(&this->_overlapped, sizeof(this->_overlapped));
+
+    this->_version = this->_device->version();
+
+    switch (this->_version.EmiVersion) {
+        case EMI_VERSION_V1:
+            this->_buffer.resize(sizeof(EMI_MEASUREMENT_DATA_V1));
+            this->_channels.resize(1);
+            break;
+
+        case EMI_VERSION_V2: {
+            const auto cnt = this->_device->channels();
+            assert(cnt > 0);
+            this->_buffer.resize(sizeof(EMI_MEASUREMENT_DATA_V2)
+                + (cnt - 1) * sizeof(EMI_CHANNEL_MEASUREMENT_DATA));
+            this->_channels.resize(cnt);
+            } break;
+
+        default:
+            throw std::logic_error("The specified version of the Energy "
+                "Meter Interface is not supported by the implementation.");
+    }
+
+    // The event is created last, because no destructor runs if the
+    // constructor fails.
+    this->_overlapped.hEvent = create_event(true);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::emi_device_reader::~emi_device_reader
+ */
+visus::power_overwhelming::detail::emi_device_reader::~emi_device_reader(
+        void) noexcept {
+    if (this->_state == state_type::pending) {
+        // The kernel must not write to the buffer once it has been freed, so
+        // we need to wait for the cancellation to complete.
+        DWORD cnt = 0;
+        ::CancelIoEx(*this->_device, &this->_overlapped);
+        ::GetOverlappedResult(*this->_device, &this->_overlapped, &cnt, TRUE);
+    }
+
+    destroy_event(this->_overlapped.hEvent);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::emi_device_reader::begin_read
+ */
+void visus::power_overwhelming::detail::emi_device_reader::begin_read(
+        void) noexcept {
+    if (this->_state == state_type::pending) {
+        DWORD cnt = 0;
+        ::GetOverlappedResult(*this->_device, &this->_overlapped, &cnt, TRUE);
+    }
+
+    auto event = this->_overlapped.hEvent;
+    ::ZeroMemory(&this->_overlapped, sizeof(this->_overlapped));
+    this->_overlapped.hEvent = event;
+    reset_event(event);
+
+    // If the request completes immediately, the event is signalled and
+    // end_read() retrieves the result like for a pending request.
+    if (::DeviceIoControl(*this->_device, IOCTL_EMI_GET_MEASUREMENT, nullptr,
+            0, this->_buffer.data(), static_cast<DWORD>(this->_buffer.size()),
+            nullptr, &this->_overlapped)) {
+        this->_state = state_type::pending;
+
+    } else {
+        this->_error = ::GetLastError();
+        this->_state = (this->_error == ERROR_IO_PENDING)
+            ? state_type::pending
+            : state_type::failed;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::emi_device_reader::end_read
+ */
+const EMI_CHANNEL_MEASUREMENT_DATA *
+visus::power_overwhelming::detail::emi_device_reader::end_read(void) {
+    switch (this->_state) {
+        case state_type::idle:
+            throw std::logic_error("A measurement must be requested before "
+                "it can be retrieved.");
+
+        case state_type::failed:
+            this->_state = state_type::idle;
+            throw std::system_error(this->_error, std::system_category());
+
+        default:
+            break;
+    }
+
+    DWORD cnt = 0;
+    this->_state = state_type::idle;
+    if (!::GetOverlappedResult(*this->_device, &this->_overlapped, &cnt,
+            TRUE)) {
+        throw std::system_error(::GetLastError(), std::system_category());
+    }
+
+    switch (this->_version.EmiVersion) {
+        case EMI_VERSION_V1: {
+            auto src = reinterpret_cast<const EMI_MEASUREMENT_DATA_V1 *>(
+                this->_buffer.data());
+            this->_channels[0].AbsoluteEnergy = src->AbsoluteEnergy;
+            this->_channels[0].AbsoluteTime = src->AbsoluteTime;
+            } break;
+
+        case EMI_VERSION_V2: {
+            auto src = reinterpret_cast<const EMI_MEASUREMENT_DATA_V2 *>(
+                this->_buffer.data());
+            std::copy(src->ChannelData, src->ChannelData
+                + this->_channels.size(), this->_channels.begin());
+            } break;
+
+        default:
+            // Unsupported versions have been rejected in the constructor.
+            assert(false);
+            break;
+    }
+
+    return this->_channels.data();
+}
+#endif /* defined(_WIN32) */
@@ -0,0 +1,156 @@
+﻿// <copyright file="emi_device_reader.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <vector>
+
+#include "emi_device_factory.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Reads all channels of an EMI device in a single
+    /// <c>IOCTL_EMI_GET_MEASUREMENT</c> request, which can be overlapped with
+    /// the requests to other devices.
+    /// </summary>
+    /// <remarks>
+    /// <para>The reader allocates the buffer for the raw measurement and the
+    /// array of decoded channels once when it is created and reuses them for
+    /// every subsequent read. This allows the asynchronous sampler to read a
+    /// device once per tick without allocating memory and to hand out the
+    /// data of all channels to the sensors sharing the device.</para>
+    /// <para>The request can be split into <see cref="begin_read" />, which
+    /// issues it without waiting, and <see cref="end_read" />, which waits for
+    /// its completion and decodes the result. Issuing the requests for all
+    /// devices before waiting for any of them makes the time for reading all
+    /// devices the maximum rather than the sum of their latencies.</para>
+    /// <para>Readers are not thread-safe. The caller must make sure that only
+    /// one thread reads at a time. As the kernel writes to the reader while a
+    /// request is pending, readers can neither be copied nor moved.</para>
+    /// </remarks>
+    class emi_device_reader final {
+
+    public:
+
+        /// <summary>
+        /// The type used to reference EMI devices.
+        /// </summary>
+        typedef emi_device_factory::device_type device_type;
+
+#if defined(_WIN32)
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="device">The device to be read. This must not be
+        /// <c>nullptr</c>.</param>
+        /// <exception cref="std::invalid_argument">If <paramref name="device" />
+        /// is <c>nullptr</c>.</exception>
+        /// <exception cref="std::logic_error">If the device implements a
+        /// version of EMI that is not supported.</exception>
+        /// <exception cref="std::system_error">If the metadata of the device
+        /// could not be retrieved.</exception>
+        explicit emi_device_reader(_In_ const device_type& device);
+
+        emi_device_reader(const emi_device_reader&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        /// <remarks>
+        /// A pending request is cancelled.
+        /// </remarks>
+        ~emi_device_reader(void) noexcept;
+
+        /// <summary>
+        /// Issues the request for the current measurement of all channels
+        /// without waiting for its completion.
+        /// </summary>
+        /// <remarks>
+        /// Any error is reported by the next call to <see cref="end_read" />,
+        /// which must be called before the request is issued again. If a
+        /// request is still pending, the method waits for it first.
+        /// </remarks>
+        void begin_read(void) noexcept;
+
+        /// <summary>
+        /// Answer the number of channels provided by the device, which is the
+        /// number of elements returned by <see cref="read" />.
+        /// </summary>
+        /// <returns>The number of channels of the device.</returns>
+        inline std::size_t channels(void) const noexcept {
+            return this->_channels.size();
+        }
+
+        /// <summary>
+        /// Answer the device being read.
+        /// </summary>
+        /// <returns>The device.</returns>
+        inline const device_type& device(void) const noexcept {
+            return this->_device;
+        }
+
+        /// <summary>
+        /// Waits for the request issued by <see cref="begin_read" /> to
+        /// complete and decodes the measurement of all channels.
+        /// </summary>
+        /// <remarks>
+        /// For EMIv1 devices, which do not have channels, the result comprises
+        /// a single channel holding the absolute energy and time of the
+        /// device.
+        /// </remarks>
+        /// <returns>A pointer to <see cref="channels" /> decoded measurements,
+        /// which remains valid until the next read.</returns>
+        /// <exception cref="std::logic_error">If no request has been issued.
+        /// </exception>
+        /// <exception cref="std::system_error">If the I/O control request
+        /// failed.</exception>
+        const EMI_CHANNEL_MEASUREMENT_DATA *end_read(void);
+
+        /// <summary>
+        /// Reads the current measurement of all channels and waits for the
+        /// result.
+        /// </summary>
+        /// <returns>A pointer to <see cref="channels" /> decoded measurements,
+        /// which remains valid until the next read.</returns>
+        /// <exception cref="std::system_error">If the I/O control request
+        /// failed.</exception>
+        inline const EMI_CHANNEL_MEASUREMENT_DATA *read(void) {
+            this->begin_read();
+            return this->end_read();
+        }
+
+        emi_device_reader& operator =(const emi_device_reader&) = delete;
+#endif /* defined(_WIN32) */
+
+    private:
+
+#if defined(_WIN32)
+        /// <summary>
+        /// The states of the request of the reader.
+        /// </summary>
+        enum class state_type {
+            idle,
+            pending,
+            failed
+        };
+
+        std::vector<std::uint8_t> _buffer;
+        std::vector<EMI_CHANNEL_MEASUREMENT_DATA> _channels;
+        device_type _device;
+        DWORD _error;
+        OVERLAPPED _overlapped;
+        state_type _state;
+        EMI_VERSION _version;
+#endif /* defined(_WIN32) */
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -5,7 +5,11 @@
 
 #include "emi_sampler_context.h"
 
+#include <tuple>
+#include <utility>
+
 #include "emi_sensor_impl.h"
+#include "system_trace.h"
 
 
 /*
@@ -16,40 +20,53 @@ bool visus::power_overwhelming::detail::emi_sampler_context::add(
 #if defined(_WIN32)
     assert(sensor != nullptr);
     assert(callback != nullptr);
-    std::lock_guard<decltype(this->lock)> l(this->lock);
-
-    auto it = this->sensors.find(sensor->device);
-    if (it != this->sensors.end()) {
-        // We already know the EMI device, but do not know yet whether we
-        // already know the sensor, too.
-        if (it->second.find(sensor) != it->second.end()) {
-            // Sensor is already being sampled, so there is nothing to do.
-            return false;
-
-        } else {
-            // Add the sensor to the existing device.
-            it->second.emplace(sensor, std::make_pair(callback, context));
-        }
-
-    } else {
-        // Need to sample a previously unknown device, so add it and its first
-        // sensor.
-        this->sensors[sensor->device].emplace(sensor,
-            std::make_pair(callback, context));
-    }
+    callback_type cb;
+    cb.callback = callback;
+    cb.context = context;
+    cb.data_callback = nullptr;
+    cb.name = sensor_name_registry::intern(sensor->sensor_name.c_str());
+    cb.sample_duration = &this->instrumentation.sample_duration(cb.name);
+    return this->add(sensor, cb);
+#else /* defined(_WIN32) */
+    return false;
+#endif /* defined(_WIN32) */
+}
 
-    if ((this->sensors.size() == 1) && !this->thread.joinable()) {
-        // If this is the first sensor, we need to start a worker thread.
-        this->thread = std::thread(&emi_sampler_context::sample, this);
-    }
 
-    return true;
+/*
+ * visus::power_overwhelming::detail::emi_sampler_context::add
+ */
+bool visus::power_overwhelming::detail::emi_sampler_context::add(
+        sensor_type sensor, const measurement_data_callback callback,
+        void *context) {
+#if defined(_WIN32)
+    assert(sensor != nullptr);
+    assert(callback != nullptr);
+    callback_type cb;
+    cb.callback = nullptr;
+    cb.context = context;
+    cb.data_callback = callback;
+    cb.name = sensor_name_registry::intern(sensor->sensor_name.c_str());
+    cb.sample_duration = &this->instrumentation.sample_duration(cb.name);
+    return this->add(sensor, cb);
 #else /* defined(_WIN32) */
     return false;
 #endif /* defined(_WIN32) */
 }
 
 
+/*
+ * visus::power_overwhelming::detail::emi_sampler_context::clear
+ */
+void visus::power_overwhelming::detail::emi_sampler_context::clear(void) {
+#if defined(_WIN32)
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    this->sensors.clear();
+    this->readers.clear();
+#endif /* defined(_WIN32) */
+}
+
+
 /*
  * visus::power_overwhelming::detail::emi_sampler_context::remove
  */
@@ -69,6 +86,7 @@ bool visus::power_overwhelming::detail::emi_sampler_context::remove(
             // If this was the last sensor on the given device, remove the
             // device itself from the list, which makes it cheaper to determine
             // whether the sampler should be stopped.
+            this->readers.erase(dit->first);
             this->sensors.erase(dit);
         }
     }
@@ -83,48 +101,69 @@ bool visus::power_overwhelming::detail::emi_sampler_context::remove(
 /*
  * visus::power_overwhelming::detail::emi_sampler_context::sample
  */
-void visus::power_overwhelming::detail::emi_sampler_context::sample(void) {
+bool visus::power_overwhelming::detail::emi_sampler_context::sample(void) {
 #if defined(_WIN32)
-    auto have_sensors = true;
-    std::vector<std::uint8_t> sample;
-
-    set_thread_name("PwrOwg Energy Meter Interface Sampler Thread");
+    // The EMI sampler always produces timestamps in milliseconds.
+    typedef sampler_instrumentation::clock_type clock_type;
+    const auto begin = this->instrumentation.begin_tick();
+    const auto converter = get_timestamp_converter(
+        timestamp_resolution::milliseconds);
 
-    while (have_sensors) {
-        auto now = std::chrono::high_resolution_clock::now();
-
-        {
-            std::lock_guard<decltype(this->lock)> l(this->lock);
-            for (auto& d : this->sensors) {
-                auto device = d.first;
-                auto& sensors = d.second;
-                auto version = device->version().EmiVersion;
-
-                for (auto s : sensors) {
-                    auto sensor = s.first;
-                    auto callback = s.second.first;
-                    auto context = s.second.second;
-
-                    if (sample.empty()) {
-                        sample = sensor->sample();
-                    }
+    std::lock_guard<decltype(this->lock)> l(this->lock);
 
-                    // TODO
-                    callback(measurement(s.first->sensor_name.c_str(),
-                        sensor->evaluate(sample, version,
-                        timestamp_resolution::milliseconds)), context);
-                }
+    // Issue the requests to all devices before waiting for any of them such
+    // that the devices are read in parallel. Every device has a reader, but
+    // not every reader might be used by a sensor anymore.
+    const auto read_start = clock_type::now();
+    for (auto& d : this->sensors) {
+        auto reader = this->readers.find(d.first);
+        assert(reader != this->readers.end());
+        reader->second.begin_read();
+    }
 
-                sample.clear();
+    for (auto& d : this->sensors) {
+        auto& sensors = d.second;
+
+        // Wait for the measurement of all channels of the device and
+        // distribute the decoded channels to the sensors. The duration of
+        // the read includes waiting for the devices completing earlier, which
+        // is what the sensor effectively spent in the tick.
+        auto reader = this->readers.find(d.first);
+        assert(reader != this->readers.end());
+        const auto channels = reader->second.end_read();
+        const auto read = clock_type::now() - read_start;
+
+        for (auto& s : sensors) {
+            auto sensor = s.first;
+            auto& callback = s.second;
+            assert(sensor->channel < reader->second.channels());
+
+            // All sensors of the device share the duration of the read.
+            const auto start = clock_type::now();
+            const auto data = sensor->evaluate(channels[sensor->channel],
+                converter);
+            const auto evaluated = clock_type::now();
+            callback.sample_duration->record(read + (evaluated - start));
+            system_trace::sample(callback.name, data);
+
+            if (callback.data_callback != nullptr) {
+                callback.data_callback(callback.name, &data, 1,
+                    callback.context);
+            } else {
+                callback.callback(measurement(callback.name, data),
+                    callback.context);
             }
 
-            have_sensors = !this->sensors.empty();
-        }
-
-        if (have_sensors) {
-            std::this_thread::sleep_until(now + this->interval);
+            this->instrumentation.callback_duration().record(
+                clock_type::now() - evaluated);
         }
     }
+
+    this->instrumentation.end_tick(begin);
+    this->running = !this->sensors.empty();
+    return this->running;
+#else /* defined(_WIN32) */
+    return false;
 #endif /* defined(_WIN32) */
 }
 
@@ -144,3 +183,66 @@ bool visus::power_overwhelming::detail::emi_sampler_context::samples(
     return false;
 #endif /* defined(_WIN32) */
 }
+
+
+/*
+ * visus::power_overwhelming::detail::emi_sampler_context::add
+ */
+bool visus::power_overwhelming::detail::emi_sampler_context::add(
+        sensor_type sensor, const callback_type& callback) {
+#if defined(_WIN32)
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+
+    auto it = this->sensors.find(sensor->device);
+    if (it != this->sensors.end()) {
+        // We already know the EMI device, but do not know yet whether we
+        // already know the sensor, too.
+        if (it->second.find(sensor) != it->second.end()) {
+            // Sensor is already being sampled, so there is nothing to do.
+            return false;
+        }
+
+    } else {
+        // Need to sample a previously unknown device. The reader is created
+        // first such that we do not leave an unreadable device in the list if
+        // the reader cannot be created.
+        this->readers.emplace(std::piecewise_construct,
+            std::forward_as_tuple(sensor->device),
+            std::forward_as_tuple(sensor->device));
+    }
+
+    {
+        // If the sensor has been sampled before, its baseline is from the
+        // time when it was stopped, so the first new sample would average over
+        // the whole pause unless we establish a new baseline now.
+        auto reader = this->readers.find(sensor->device);
+        assert(reader != this->readers.end());
+        assert(sensor->channel < reader->second.channels());
+        sensor->rearm(reader->second.read()[sensor->channel]);
+    }
+
+    this->sensors[sensor->device].emplace(sensor, callback);
+
+    if (!this->running) {
+        // If this is the first sensor, we need to schedule the task. If the
+        // task is still in its last tick, the scheduler restarts it after the
+        // tick has completed.
+        this->running = true;
+        sampler_scheduler::instance().schedule(this->task, this->interval);
+    }
+
+    return true;
+#else /* defined(_WIN32) */
+    return false;
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::emi_sampler_context::tick
+ */
+bool visus::power_overwhelming::detail::emi_sampler_context::tick(
+        _In_ void *context) {
+    assert(context != nullptr);
+    return static_cast<emi_sampler_context *>(context)->sample();
+}
@@ -18,7 +18,10 @@
 #include "power_overwhelming/measurement.h"
 
 #include "emi_device_factory.h"
-#include "thread_name.h"
+#include "emi_device_reader.h"
+#include "sampler_instrumentation.h"
+#include "sampler_scheduler.h"
+#include "sensor_name_registry.h"
 
 
 namespace visus {
@@ -30,16 +33,46 @@ namespace detail {
 
 
     /// <summary>
-    /// A context represents a thread that handles sampling
+    /// A context represents a task of the <see cref="sampler_scheduler" />
+    /// that handles sampling
     /// <see cref="emi_sensor" />s at a specific interval.
     /// </summary>
     struct emi_sampler_context {
 
         /// <summary>
-        /// The type of the on-measurement callback and the user data pointer
+        /// The callback to be invoked for a sensor and the user data pointer
         /// to be passed to it.
         /// </summary>
-        typedef std::pair<measurement_callback, void *> callback_type;
+        struct callback_type {
+
+            /// <summary>
+            /// The callback for individual samples, or <c>nullptr</c> if the
+            /// samples are delivered to <see cref="data_callback" />.
+            /// </summary>
+            measurement_callback callback;
+
+            /// <summary>
+            /// The user-defined context pointer passed to the callback.
+            /// </summary>
+            void *context;
+
+            /// <summary>
+            /// The callback for batches of samples, or <c>nullptr</c> if the
+            /// samples are delivered to <see cref="callback" />.
+            /// </summary>
+            measurement_data_callback data_callback;
+
+            /// <summary>
+            /// The interned name of the sensor.
+            /// </summary>
+            const wchar_t *name;
+
+            /// <summary>
+            /// The histogram of the time reading the device and evaluating
+            /// the channel of the sensor takes.
+            /// </summary>
+            sampler_instrumentation::histogram_type *sample_duration;
+        };
 
         /// <summary>
         /// The type used to reference EMI devices.
@@ -58,6 +91,11 @@ namespace detail {
         typedef emi_sensor_impl *sensor_type;
 
 #if defined(_WIN32)
+        /// <summary>
+        /// Records the timing of the ticks of <see cref="task" />.
+        /// </summary>
+        sampler_instrumentation instrumentation;
+
         /// <summary>
         /// The sampling interval.
         /// </summary>
@@ -68,6 +106,24 @@ namespace detail {
         /// </summary>
         std::mutex lock;
 
+        /// <summary>
+        /// The readers for all devices in <see cref="sensors" />, which obtain
+        /// the data of all channels of a device with a single request per
+        /// sampling period.
+        /// </summary>
+        std::map<device_type, emi_device_reader> readers;
+
+        /// <summary>
+        /// Indicates whether the <see cref="task" /> is scheduled.
+        /// </summary>
+        /// <remarks>
+        /// The flag is protected by <see cref="lock" />. The sampler task
+        /// clears it when it has found <see cref="sensors" /> empty and is
+        /// about to stop, in which case <see cref="add" /> must schedule it
+        /// again.
+        /// </remarks>
+        bool running;
+
         /// <summary>
         /// The sensors to sample along with the callback to be invoked, grouped
         /// by their EMI device, such that we can sample all channels of each
@@ -76,9 +132,16 @@ namespace detail {
         std::map<device_type, std::map<sensor_type, callback_type>> sensors;
 
         /// <summary>
-        /// The thread sampling the <see cref="sensors" />.
+        /// The task of the scheduler that periodically samples the
+        /// <see cref="sensors" />.
+        /// </summary>
+        sampler_scheduler::task task;
+
+        /// <summary>
+        /// Initialises a new instance.
         /// </summary>
-        std::thread thread;
+        inline emi_sampler_context(void) : instrumentation(task),
+            running(false), task(&emi_sampler_context::tick, this) { }
 #endif /* defined(_WIN32) */
 
         /// <summary>
@@ -87,20 +150,52 @@ namespace detail {
         bool add(sensor_type sensor, const measurement_callback callback,
             void *context);
 
+        /// <summary>
+        /// Add the given sensor to the this context such that its samples are
+        /// delivered to a <see cref="measurement_data_callback" />.
+        /// </summary>
+        /// <remarks>
+        /// As the EMI sampler task reads all channels of a device at once,
+        /// it delivers the samples of each period immediately rather than
+        /// retaining them in a batch.
+        /// </remarks>
+        bool add(sensor_type sensor, const measurement_data_callback callback,
+            void *context);
+
+        /// <summary>
+        /// Remove all sensors from the context, which will make the sampler
+        /// task stop.
+        /// </summary>
+        void clear(void);
+
         /// <summary>
         /// Remove the sensor from the context.
         /// </summary>
         bool remove(sensor_type sensor);
 
         /// <summary>
-        /// Performs sampling in this context.
+        /// Performs one tick of sampling in this context.
         /// </summary>
-        void sample(void);
+        /// <returns><c>true</c> if the task should continue to be scheduled,
+        /// <c>false</c> if there are no sensors left.</returns>
+        bool sample(void);
 
         /// <summary>
         /// Answer whether the given sensor is sampled in this context.
         /// </summary>
         bool samples(const sensor_type sensor);
+
+    private:
+
+        /// <summary>
+        /// Add the given sensor with the given callback to the context.
+        /// </summary>
+        bool add(sensor_type sensor, const callback_type& callback);
+
+        /// <summary>
+        /// The callback of <see cref="task" />.
+        /// </summary>
+        static bool tick(_In_ void *context);
     };
 
 } /* namespace detail */
@@ -14,6 +14,7 @@
 
 #include "emi_sensor_impl.h"
 #include "setup_api.h"
+#include "update_interval_probe.h"
 
 
 #define ERROR_MSG_NOT_SUPPORTED ("The EMI sensor is not supported on this " \
@@ -150,6 +151,25 @@ std::size_t visus::power_overwhelming::emi_sensor::for_device_and_channel(
 }
 
 
+/*
+ * visus::power_overwhelming::emi_sensor::sample_data
+ */
+void visus::power_overwhelming::emi_sensor::sample_data(
+        _Out_writes_(cnt) measurement_data *dst,
+        _In_reads_(cnt) const emi_sensor *sensors,
+        _In_ const std::size_t cnt,
+        _In_ const timestamp_resolution resolution) {
+    if ((cnt > 0) && ((dst == nullptr) || (sensors == nullptr))) {
+        throw std::invalid_argument("The output and the sensors must be "
+            "valid if sensors are to be sampled.");
+    }
+
+    for (std::size_t i = 0; i < cnt; ++i) {
+        dst[i] = sensors[i].sample_data(resolution);
+    }
+}
+
+
 /*
  * visus::power_overwhelming::emi_sensor::emi_sensor
  */
@@ -198,6 +218,19 @@ visus::power_overwhelming::emi_sensor::channels(void) const {
 }
 
 
+/*
+ * visus::power_overwhelming::emi_sensor::energy
+ */
+double visus::power_overwhelming::emi_sensor::energy(void) const {
+    this->check_not_disposed();
+#if defined(_WIN32)
+    return this->_impl->energy();
+#else /* defined(_WIN32) */
+    throw std::logic_error(ERROR_MSG_NOT_SUPPORTED);
+#endif /* defined(_WIN32) */
+}
+
+
 /*
  * visus::power_overwhelming::emi_sensor::name
  */
@@ -213,6 +246,27 @@ _Ret_maybenull_z_ const wchar_t *visus::power_overwhelming::emi_sensor::name(
 }
 
 
+/*
+ * visus::power_overwhelming::emi_sensor::native_interval
+ */
+visus::power_overwhelming::sensor::microseconds_type
+visus::power_overwhelming::emi_sensor::native_interval(void) const {
+    this->check_not_disposed();
+#if defined(_WIN32)
+    std::call_once(this->_impl->native_interval_probed, [this](void) {
+        // The raw sample contains the timestamp of the firmware, so it
+        // changes on every update even if the energy does not.
+        this->_impl->native_interval = detail::probe_update_interval(
+            [this](void) { return this->_impl->sample(); });
+    });
+
+    return this->_impl->native_interval.count();
+#else /* defined(_WIN32) */
+    return 0;
+#endif /* defined(_WIN32) */
+}
+
+
 /*
  * visus::power_overwhelming::emi_sensor::path
  */
@@ -257,6 +311,35 @@ void visus::power_overwhelming::emi_sensor::sample(
 }
 
 
+/*
+ * visus::power_overwhelming::emi_sensor::sample_batch
+ */
+void visus::power_overwhelming::emi_sensor::sample_batch(
+        _In_opt_ const measurement_data_callback on_batch,
+        _In_ const microseconds_type period,
+        _In_opt_ void *context) {
+#if defined(_WIN32)
+    typedef decltype(detail::emi_sensor_impl::sampler)::interval_type
+        interval_type;
+
+    this->check_not_disposed();
+
+    if (on_batch != nullptr) {
+        if (!detail::emi_sensor_impl::sampler.add(this->_impl, on_batch,
+                context, interval_type(period))) {
+            throw std::logic_error("Asynchronous sampling cannot be started "
+                "while it is already running.");
+        }
+
+    } else {
+        detail::emi_sensor_impl::sampler.remove(this->_impl);
+    }
+#else /* defined(_WIN32) */
+    throw std::logic_error(ERROR_MSG_NOT_SUPPORTED);
+#endif /* defined(_WIN32) */
+}
+
+
 #if defined(_WIN32)
 /*
  * visus::power_overwhelming::emi_sensor::sample
@@ -341,13 +424,16 @@ visus::power_overwhelming::emi_sensor::operator bool(void) const noexcept {
 
 
 /*
- * visus::power_overwhelming::emi_sensor::sample_sync
+ * visus::power_overwhelming::emi_sensor::sample_data
  */
 visus::power_overwhelming::measurement_data
-visus::power_overwhelming::emi_sensor::sample_sync(
+visus::power_overwhelming::emi_sensor::sample_data(
         _In_ const timestamp_resolution resolution) const {
 #if defined(_WIN32)
-    this->check_not_disposed();
+    if (!*this) {
+        // The class is final, so this does not require a virtual call.
+        throw_disposed();
+    }
 
     switch (this->version()) {
         case EMI_VERSION_V1: {
@@ -370,3 +456,13 @@ visus::power_overwhelming::emi_sensor::sample_sync(
     throw std::logic_error(ERROR_MSG_NOT_SUPPORTED);
 #endif /* defined(_WIN32) */
 }
+
+
+/*
+ * visus::power_overwhelming::emi_sensor::sample_sync
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::emi_sensor::sample_sync(
+        _In_ const timestamp_resolution resolution) const {
+    return this->sample_data(resolution);
+}
@@ -12,6 +12,14 @@
 
 
 #if defined(_WIN32)
+/*
+ * visus::power_overwhelming::detail::emi_sensor_impl::paths
+ */
+visus::power_overwhelming::detail::cached_discovery<
+    visus::power_overwhelming::detail::emi_sensor_impl::string_type>
+visus::power_overwhelming::detail::emi_sensor_impl::paths;
+
+
 /*
  * visus::power_overwhelming::detail::emi_sensor_impl::sampler
  */
@@ -30,13 +38,44 @@ visus::power_overwhelming::detail::emi_sensor_impl::~emi_sensor_impl(void) {
 }
 
 
+/*
+ * visus::power_overwhelming::detail::emi_sensor_impl::energy
+ */
+double visus::power_overwhelming::detail::emi_sensor_impl::energy(void) {
+    const auto data = this->sample();
+    energy_type retval = 0;
+
+    switch (this->device->version().EmiVersion) {
+        case EMI_VERSION_V1:
+            assert(data.size() >= sizeof(EMI_MEASUREMENT_DATA_V1));
+            retval = reinterpret_cast<const EMI_MEASUREMENT_DATA_V1 *>(
+                data.data())->AbsoluteEnergy;
+            break;
+
+        case EMI_VERSION_V2:
+            assert(data.size() >= sizeof(EMI_MEASUREMENT_DATA_V2));
+            retval = reinterpret_cast<const EMI_MEASUREMENT_DATA_V2 *>(
+                data.data())->ChannelData[this->channel].AbsoluteEnergy;
+            break;
+
+        default:
+            throw std::logic_error("The specified version of the Energy "
+                "Meter Interface is not supported by the implementation.");
+    }
+
+    // 1 [pWh] = 10^-12 [W] * 3600 [s]
+    return static_cast<double>(retval) * 3.6e-9;
+}
+
+
 /*
  * visus::power_overwhelming::detail::emi_sensor_impl::evaluate
  */
 visus::power_overwhelming::measurement_data
 visus::power_overwhelming::detail::emi_sensor_impl::evaluate(
         const EMI_CHANNEL_MEASUREMENT_DATA& data,
-        const timestamp_resolution resolution) {
+        const timestamp_converter converter) {
+    assert(converter != nullptr);
     const auto de = data.AbsoluteEnergy - this->last_energy;
     const auto dt = data.AbsoluteTime - this->last_time;
 
@@ -48,11 +87,13 @@ visus::power_overwhelming::detail::emi_sensor_impl::evaluate(
             // de / dt [pWh / 100ns]
             // 1 [pW] = 10^-12 [W]
             // 100 [ns] = 10^-7 [s]
-            auto value = static_cast<float>(de) * 0.036f;
-            value /= static_cast<float>(dt);
+            // The integral deltas are converted in double precision, because
+            // a float cannot represent them exactly over long runs.
+            const auto value = static_cast<measurement_data::value_type>(
+                static_cast<double>(de) * 0.036 / static_cast<double>(dt));
 
             auto time = data.AbsoluteTime - dt / 2 + this->time_offset;
-            time = convert(time, resolution);
+            time = converter(time);
 
             return measurement_data(time, value);
             }
@@ -102,13 +143,8 @@ std::size_t visus::power_overwhelming::detail::emi_sensor_impl::sample(
     assert(this->device != nullptr);
     assert(dst != nullptr);
 
-    DWORD retval = 0;
-    if (!::DeviceIoControl(*this->device, IOCTL_EMI_GET_MEASUREMENT, nullptr, 0,
-            dst, cnt, &retval, 0)) {
-        throw std::system_error(::GetLastError(), std::system_category());
-    }
-
-    return retval;
+    return this->device->control(IOCTL_EMI_GET_MEASUREMENT, nullptr, 0,
+        dst, cnt);
 }
 
 
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <cassert>
+#include <chrono>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -13,6 +14,7 @@
 #include "power_overwhelming/emi_sensor.h"
 #include "power_overwhelming/measurement.h"
 
+#include "cached_discovery.h"
 #include "emi_device_factory.h"
 #include "emi_sampler_context.h"
 #include "sampler.h"
@@ -75,6 +77,12 @@ namespace detail {
         /// </remarks>
         static std::map<string_type, std::shared_ptr<emi_device>> devices;
 
+        /// <summary>
+        /// The paths of all EMI devices on the system, which are enumerated
+        /// only once until the <see cref="device_catalogue" /> changes.
+        /// </summary>
+        static cached_discovery<string_type> paths;
+
         /// <summary>
         /// A lock for protecting <see cref="emi_sensor_impl::devices" />
         /// against concurrent access.
@@ -106,6 +114,17 @@ namespace detail {
         /// </summary>
         time_type last_time;
 
+        /// <summary>
+        /// The update interval of the firmware, which is determined by
+        /// <see cref="emi_sensor::native_interval" /> once.
+        /// </summary>
+        std::chrono::microseconds native_interval;
+
+        /// <summary>
+        /// Makes sure that the update interval is only probed once.
+        /// </summary>
+        std::once_flag native_interval_probed;
+
         /// <summary>
         /// The path of the <see cref="device" />.
         /// </summary>
@@ -137,7 +156,7 @@ namespace detail {
         /// Initialises a new instance.
         /// </summary>
         inline emi_sensor_impl(void) : channel(0), last_energy(0), last_time(0),
-            sample_size(0), time_offset(0),
+            native_interval(0), sample_size(0), time_offset(0),
             unit(EmiMeasurementUnitPicowattHours) { }
 
         /// <summary>
@@ -145,6 +164,16 @@ namespace detail {
         /// </summary>
         ~emi_sensor_impl(void);
 
+        /// <summary>
+        /// Reads the absolute energy of the channel represented by this
+        /// sensor.
+        /// </summary>
+        /// <returns>The energy in Joules since an undefined point in time.
+        /// </returns>
+        /// <exception cref="std::system_error">If the device could not be
+        /// read.</exception>
+        double energy(void);
+
         /// <summary>
         /// Evaluate the given channel data and save them as the previous
         /// measurement in <see cref="emi_sensor_impl::last_energy" /> and
@@ -153,8 +182,23 @@ namespace detail {
         /// <param name="data"></param>
         /// <param name="resolution"></param>
         /// <returns></returns>
+        inline measurement_data evaluate(
+                const EMI_CHANNEL_MEASUREMENT_DATA& data,
+                const timestamp_resolution resolution) {
+            return this->evaluate(data, get_timestamp_converter(resolution));
+        }
+
+        /// <summary>
+        /// Evaluate the given channel data using a timestamp converter that has
+        /// been resolved in advance and save them as the previous measurement
+        /// in <see cref="emi_sensor_impl::last_energy" /> and
+        /// <see cref="emi_sensor_impl::last_time" />.
+        /// </summary>
+        /// <param name="data"></param>
+        /// <param name="converter"></param>
+        /// <returns></returns>
         measurement_data evaluate(const EMI_CHANNEL_MEASUREMENT_DATA& data,
-            const timestamp_resolution resolution);
+            const timestamp_converter converter);
 
         /// <summary>
         /// Evaluate the channel represented by this sensor with data from the
@@ -186,6 +230,17 @@ namespace detail {
             const emi_sensor::version_type version,
             const timestamp_resolution resolution);
 
+        /// <summary>
+        /// Save the given channel data as the previous measurement without
+        /// evaluating them, which establishes a new baseline for the next
+        /// sample.
+        /// </summary>
+        /// <param name="data"></param>
+        inline void rearm(const EMI_CHANNEL_MEASUREMENT_DATA& data) noexcept {
+            this->last_energy = data.AbsoluteEnergy;
+            this->last_time = data.AbsoluteTime;
+        }
+
         /// <summary>
         /// Obtains a sample from the sensor by issuing the
         /// <c>IOCTL_EMI_GET_MEASUREMENT</c> I/O control request on the device.
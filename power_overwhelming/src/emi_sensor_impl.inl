@@ -19,10 +19,19 @@ std::size_t visus::power_overwhelming::detail::emi_sensor_impl::create(
         cnt_sensors = 0;
     }
 
-    detail::enumerate_device_interface(::GUID_DEVICE_ENERGY_METER,
-            [out_sensors, cnt_sensors, &retval, predicate](HDEVINFO h,
-            SP_DEVICE_INTERFACE_DATA& d) {
-        auto path = detail::get_device_path(h, d);
+    // Enumerating the device interfaces takes a considerable amount of time,
+    // so we only do this if the device catalogue has been invalidated.
+    const auto paths = emi_sensor_impl::paths.get([](void) {
+        std::vector<string_type> retval;
+        detail::enumerate_device_interface(::GUID_DEVICE_ENERGY_METER,
+                [&retval](HDEVINFO h, SP_DEVICE_INTERFACE_DATA& d) {
+            retval.push_back(detail::get_device_path(h, d));
+            return true;
+        });
+        return retval;
+    });
+
+    for (auto& path : paths) {
         auto dev = emi_device_factory::create(path);
 
         switch (dev->version().EmiVersion) {
@@ -52,9 +61,7 @@ std::size_t visus::power_overwhelming::detail::emi_sensor_impl::create(
 
                 } break;
         }
-
-        return true;
-    });
+    }
 
     return retval;
 }
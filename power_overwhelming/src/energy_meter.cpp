@@ -0,0 +1,225 @@
+﻿// <copyright file="energy_meter.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/energy_meter.h"
+
+#include <memory>
+#include <stdexcept>
+
+#include "energy_meter_impl.h"
+
+
+/*
+ * visus::power_overwhelming::energy_meter::supports
+ */
+bool visus::power_overwhelming::energy_meter::supports(
+        _In_ const sensor& source) noexcept {
+    detail::energy_meter_impl::counter_type counter;
+    return detail::energy_meter_impl::resolve(counter, source);
+}
+
+
+/*
+ * visus::power_overwhelming::energy_meter::energy_meter
+ */
+visus::power_overwhelming::energy_meter::energy_meter(void)
+    : _impl(new detail::energy_meter_impl()) { }
+
+
+/*
+ * visus::power_overwhelming::energy_meter::energy_meter
+ */
+visus::power_overwhelming::energy_meter::energy_meter(
+        _In_reads_(cnt) const sensor *const *sensors,
+        _In_ const std::size_t cnt) : energy_meter() {
+    if ((sensors == nullptr) && (cnt > 0)) {
+        throw std::invalid_argument("The sensors of an energy_meter must not "
+            "be null.");
+    }
+
+    this->_impl->counters.reserve(cnt);
+    for (std::size_t i = 0; i < cnt; ++i) {
+        if (sensors[i] == nullptr) {
+            throw std::invalid_argument("The sensors of an energy_meter must "
+                "not be null.");
+        }
+
+        this->add(*sensors[i]);
+    }
+
+    this->start();
+}
+
+
+/*
+ * visus::power_overwhelming::energy_meter::~energy_meter
+ */
+visus::power_overwhelming::energy_meter::~energy_meter(void) {
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::energy_meter::add
+ */
+void visus::power_overwhelming::energy_meter::add(_In_ const sensor& source) {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("An energy_meter which has been disposed by "
+            "a move operation cannot read sensors.");
+    }
+
+    if (this->_impl->running) {
+        throw std::logic_error("Sensors cannot be added to a running "
+            "energy_meter.");
+    }
+
+    detail::energy_meter_impl::counter_type counter;
+    if (!detail::energy_meter_impl::resolve(counter, source)) {
+        throw std::invalid_argument("The sensor does not provide an energy "
+            "counter.");
+    }
+
+    this->_impl->counters.push_back(counter);
+}
+
+
+/*
+ * visus::power_overwhelming::energy_meter::elapsed
+ */
+double visus::power_overwhelming::energy_meter::elapsed(void) const noexcept {
+    typedef std::chrono::duration<double> seconds_type;
+
+    if ((this->_impl == nullptr) || !this->_impl->started) {
+        return 0.0;
+    }
+
+    const auto end = this->_impl->running
+        ? detail::energy_meter_impl::clock_type::now()
+        : this->_impl->end;
+    return std::chrono::duration_cast<seconds_type>(
+        end - this->_impl->begin).count();
+}
+
+
+/*
+ * visus::power_overwhelming::energy_meter::energy
+ */
+double visus::power_overwhelming::energy_meter::energy(
+        _In_ const std::size_t index) const {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("An energy_meter which has been disposed by "
+            "a move operation cannot read sensors.");
+    }
+
+    if (index >= this->_impl->counters.size()) {
+        throw std::out_of_range("The index does not designate a sensor of "
+            "the energy_meter.");
+    }
+
+    if (!this->_impl->started) {
+        throw std::logic_error("The energy_meter has not yet been started.");
+    }
+
+    auto& counter = this->_impl->counters[index];
+    return counter.delta(this->_impl->running
+        ? counter.read(*counter.source)
+        : counter.end);
+}
+
+
+/*
+ * visus::power_overwhelming::energy_meter::name
+ */
+_Ret_maybenull_z_ const wchar_t *visus::power_overwhelming::energy_meter::name(
+        _In_ const std::size_t index) const noexcept {
+    return (this->size() > index)
+        ? this->_impl->counters[index].source->name()
+        : nullptr;
+}
+
+
+/*
+ * visus::power_overwhelming::energy_meter::running
+ */
+bool visus::power_overwhelming::energy_meter::running(void) const noexcept {
+    return (this->_impl != nullptr) && this->_impl->running;
+}
+
+
+/*
+ * visus::power_overwhelming::energy_meter::size
+ */
+std::size_t visus::power_overwhelming::energy_meter::size(
+        void) const noexcept {
+    return (this->_impl != nullptr) ? this->_impl->counters.size() : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::energy_meter::start
+ */
+void visus::power_overwhelming::energy_meter::start(void) {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("An energy_meter which has been disposed by "
+            "a move operation cannot read sensors.");
+    }
+
+    // The clock is read after the counters here and before them when
+    // stopping, such that the elapsed time does not include the readings.
+    this->_impl->running = false;
+    for (auto& c : this->_impl->counters) {
+        c.begin = c.end = c.read(*c.source);
+    }
+
+    this->_impl->begin = detail::energy_meter_impl::clock_type::now();
+    this->_impl->running = true;
+    this->_impl->started = true;
+}
+
+
+/*
+ * visus::power_overwhelming::energy_meter::stop
+ */
+void visus::power_overwhelming::energy_meter::stop(void) {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("An energy_meter which has been disposed by "
+            "a move operation cannot read sensors.");
+    }
+
+    if (!this->_impl->running) {
+        return;
+    }
+
+    this->_impl->end = detail::energy_meter_impl::clock_type::now();
+    for (auto& c : this->_impl->counters) {
+        c.end = c.read(*c.source);
+    }
+
+    this->_impl->running = false;
+}
+
+
+/*
+ * visus::power_overwhelming::energy_meter::operator =
+ */
+visus::power_overwhelming::energy_meter&
+visus::power_overwhelming::energy_meter::operator =(
+        _Inout_ energy_meter&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::energy_meter::operator bool
+ */
+visus::power_overwhelming::energy_meter::operator bool(void) const noexcept {
+    return (this->_impl != nullptr);
+}
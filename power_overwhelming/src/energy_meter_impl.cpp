@@ -0,0 +1,149 @@
+﻿// <copyright file="energy_meter_impl.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "energy_meter_impl.h"
+
+#include "power_overwhelming/amdgpu_sensor.h"
+#include "power_overwhelming/emi_sensor.h"
+#include "power_overwhelming/level_zero_sensor.h"
+#include "power_overwhelming/msr_sensor.h"
+#include "power_overwhelming/nvml_sensor.h"
+#include "power_overwhelming/perf_rapl_sensor.h"
+#include "power_overwhelming/sysfs_sensor.h"
+
+#include "msr_magic.h"
+#include "msr_sensor_impl.h"
+#include "sysfs_sensor_impl.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Reads the energy of sensors whose counter does not wrap in practice
+    /// via their public interface.
+    /// </summary>
+    template<class TSensor> double read_energy(_In_ const sensor& source) {
+        return static_cast<const TSensor&>(source).energy();
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * ...::detail::energy_meter_impl::counter_type::delta
+ */
+double visus::power_overwhelming::detail::energy_meter_impl::counter_type
+::delta(_In_ const double reading) const noexcept {
+    auto retval = reading - this->begin;
+
+    if ((retval < 0.0) && (this->range > 0.0)) {
+        retval += this->range;
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::energy_meter_impl::resolve
+ */
+bool visus::power_overwhelming::detail::energy_meter_impl::resolve(
+        _Out_ counter_type& dst, _In_ const sensor& source) noexcept {
+    dst.begin = dst.end = 0.0;
+    dst.range = 0.0;
+    dst.read = nullptr;
+    dst.source = &source;
+
+    if (!source) {
+        return false;
+    }
+
+    // The RAPL registers and the sysfs counters wrap, so we read them raw
+    // instead of relying on the accumulation of the sensors, which is only
+    // correct if the sensors are sampled at least once per wrap.
+    if (auto s = dynamic_cast<const msr_sensor *>(&source)) {
+        dst.range = static_cast<double>(energy_status_mask + 1)
+            / s->_impl->unit_divisor;
+        dst.read = energy_meter_impl::read_msr;
+        return true;
+    }
+
+    if (auto s = dynamic_cast<const sysfs_sensor *>(&source)) {
+        if (s->_impl->quantity != sysfs_sensor_quantity::energy) {
+            return false;
+        }
+
+        dst.range = static_cast<double>(s->_impl->range) * s->_impl->scale;
+        dst.read = energy_meter_impl::read_sysfs;
+        return true;
+    }
+
+    if (dynamic_cast<const perf_rapl_sensor *>(&source) != nullptr) {
+        dst.read = read_energy<perf_rapl_sensor>;
+        return true;
+    }
+
+    if (dynamic_cast<const level_zero_sensor *>(&source) != nullptr) {
+        dst.read = read_energy<level_zero_sensor>;
+        return true;
+    }
+
+    if (auto s = dynamic_cast<const amdgpu_sensor *>(&source)) {
+        if (s->source() != amdgpu_sensor_source::energy) {
+            return false;
+        }
+
+        dst.read = read_energy<amdgpu_sensor>;
+        return true;
+    }
+
+#if defined(_WIN32)
+    if (dynamic_cast<const emi_sensor *>(&source) != nullptr) {
+        dst.read = read_energy<emi_sensor>;
+        return true;
+    }
+#endif /* defined(_WIN32) */
+
+    if (auto s = dynamic_cast<const nvml_sensor *>(&source)) {
+        // Only Volta and newer provide the counter, which we can only find
+        // out by trying.
+        try {
+            s->energy();
+            dst.read = read_energy<nvml_sensor>;
+            return true;
+        } catch (...) {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::energy_meter_impl::read_msr
+ */
+double visus::power_overwhelming::detail::energy_meter_impl::read_msr(
+        _In_ const sensor& source) {
+    auto& impl = *static_cast<const msr_sensor&>(source)._impl;
+    const auto value = impl.device->read(impl.offset) & energy_status_mask;
+    return static_cast<double>(value) / impl.unit_divisor;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::energy_meter_impl::read_sysfs
+ */
+double visus::power_overwhelming::detail::energy_meter_impl::read_sysfs(
+        _In_ const sensor& source) {
+    auto& impl = *static_cast<const sysfs_sensor&>(source)._impl;
+    sysfs_batch::time_point time;
+    const auto value = sysfs_batch::instance().read(impl.slot, time);
+    return static_cast<double>(value) * impl.scale;
+}
@@ -0,0 +1,122 @@
+﻿// <copyright file="energy_meter_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include "power_overwhelming/sensor.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The private state of an <see cref="energy_meter" />.
+    /// </summary>
+    struct energy_meter_impl final {
+
+        /// <summary>
+        /// The clock measuring the duration of a measurement.
+        /// </summary>
+        typedef std::chrono::steady_clock clock_type;
+
+        /// <summary>
+        /// A function reading the energy counter of a sensor in Joules.
+        /// </summary>
+        typedef double (*reader_type)(_In_ const sensor& source);
+
+        /// <summary>
+        /// The state of a single energy counter.
+        /// </summary>
+        struct counter_type {
+
+            /// <summary>
+            /// The reading when the meter was started.
+            /// </summary>
+            double begin;
+
+            /// <summary>
+            /// The reading when the meter was stopped.
+            /// </summary>
+            double end;
+
+            /// <summary>
+            /// The energy in Joules after which the counter wraps, or zero if
+            /// it does not wrap in practice.
+            /// </summary>
+            double range;
+
+            /// <summary>
+            /// Reads the counter.
+            /// </summary>
+            reader_type read;
+
+            /// <summary>
+            /// The sensor providing the counter.
+            /// </summary>
+            const sensor *source;
+
+            /// <summary>
+            /// Answer the energy between <see cref="begin" /> and the given
+            /// reading, considering that the counter might have wrapped once.
+            /// </summary>
+            double delta(_In_ const double reading) const noexcept;
+        };
+
+        /// <summary>
+        /// Determines how to read the energy counter of the given sensor.
+        /// </summary>
+        /// <param name="dst">Receives the <see cref="counter_type::read" />,
+        /// <see cref="counter_type::range" /> and
+        /// <see cref="counter_type::source" /> for the sensor.</param>
+        /// <param name="source">The sensor to be read.</param>
+        /// <returns><c>true</c> if the sensor provides a counter,
+        /// <c>false</c> otherwise.</returns>
+        static bool resolve(_Out_ counter_type& dst,
+            _In_ const sensor& source) noexcept;
+
+        /// <summary>
+        /// The point in time when the meter was started.
+        /// </summary>
+        clock_type::time_point begin;
+
+        /// <summary>
+        /// The counters of all sensors added to the meter.
+        /// </summary>
+        std::vector<counter_type> counters;
+
+        /// <summary>
+        /// The point in time when the meter was stopped.
+        /// </summary>
+        clock_type::time_point end;
+
+        /// <summary>
+        /// Indicates whether the meter is currently running.
+        /// </summary>
+        bool running;
+
+        /// <summary>
+        /// Indicates whether the meter has been started at least once.
+        /// </summary>
+        bool started;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        inline energy_meter_impl(void) : running(false), started(false) { }
+
+    private:
+
+        static double read_msr(_In_ const sensor& source);
+
+        static double read_sysfs(_In_ const sensor& source);
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
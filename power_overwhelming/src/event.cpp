@@ -6,16 +6,181 @@
 #include "power_overwhelming/event.h"
 
 #include <cassert>
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
 
 #include <errno.h>
 
+#if defined(POWER_OVERWHELMING_EVENT_EVENTFD)
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif /* defined(POWER_OVERWHELMING_EVENT_EVENTFD) */
+
 
 namespace visus {
 namespace power_overwhelming {
 namespace detail {
 
+#if defined(POWER_OVERWHELMING_EVENT_EVENTFD)
+    struct event_impl {
+        int descriptor;
+        bool manual_reset;
+    };
+
+    /// <summary>
+    /// Checks the given event handle.
+    /// </summary>
+    static event_impl *check_event(_In_ event_type event) {
+        if (event == nullptr) {
+            throw std::system_error(EINVAL, std::system_category());
+        }
+
+        return event;
+    }
+
+    /// <summary>
+    /// Tries resetting an auto-reset event that has been found signalled,
+    /// which fails if another thread has consumed the signal in the
+    /// meantime.
+    /// </summary>
+    static bool consume_event(_In_ event_impl *event) {
+        if (event->manual_reset) {
+            return true;
+        }
+
+        std::uint64_t value;
+        while (::read(event->descriptor, &value, sizeof(value)) < 0) {
+            switch (errno) {
+                case EINTR:
+                    break;
+
+                case EAGAIN:
+                    return false;
+
+                default:
+                    throw std::system_error(errno, std::system_category());
+            }
+        }
+
+        return true;
+    }
+
+    /// <summary>
+    /// Consumes the signals of all given events at once, which fails if
+    /// another thread has consumed one of them in the meantime.
+    /// </summary>
+    /// <remarks>
+    /// If one of the events cannot be consumed, the signals of the events
+    /// that have already been consumed are restored such that waiting for
+    /// all events does not lose any signal unless it succeeds.
+    /// </remarks>
+    static bool consume_events(_In_reads_(cnt) const event_type *events,
+            _In_ const std::size_t cnt) {
+        for (std::size_t i = 0; i < cnt; ++i) {
+            if (!consume_event(events[i])) {
+                for (std::size_t j = 0; j < i; ++j) {
+                    if (!events[j]->manual_reset) {
+                        set_event(events[j]);
+                    }
+                }
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /// <summary>
+    /// Waits for the given events using a single <c>poll</c>, where a
+    /// negative timeout waits infinitely.
+    /// </summary>
+    /// <remarks>
+    /// If <paramref name="wait_all" /> is set, the events are only consumed
+    /// once all of them are signalled like <c>WaitForMultipleObjects</c>
+    /// does, so a timeout leaves the events that have been signalled in the
+    /// meantime untouched.
+    /// </remarks>
+    static std::size_t wait_eventfd(
+            _In_reads_(cnt) const event_type *events,
+            _In_ const std::size_t cnt,
+            _In_ const bool wait_all,
+            _In_ const int timeout) {
+        using namespace std::chrono;
+
+        if ((events == nullptr) || (cnt == 0)) {
+            throw std::system_error(EINVAL, std::system_category());
+        }
+
+        std::vector<pollfd> fds(cnt);
+        for (std::size_t i = 0; i < cnt; ++i) {
+            fds[i].fd = check_event(events[i])->descriptor;
+            fds[i].events = POLLIN;
+        }
+
+        const auto deadline = steady_clock::now() + milliseconds(timeout);
+        std::size_t remaining = cnt;
+
+        while (true) {
+            auto dt = timeout;
+            if (timeout > 0) {
+                const auto left = duration_cast<milliseconds>(
+                    deadline - steady_clock::now()).count();
+                dt = (left > 0) ? static_cast<int>(left) : 0;
+            }
+
+            const auto ready = ::poll(fds.data(),
+                static_cast<nfds_t>(fds.size()), dt);
+            if (ready < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::system_category());
+            }
+
+            for (std::size_t i = 0; (ready > 0) && (i < cnt); ++i) {
+                if ((fds[i].revents & POLLIN) == 0) {
+                    continue;
+                }
+
+                if (!wait_all) {
+                    if (consume_event(events[i])) {
+                        return i;
+                    }
+
+                } else if (fds[i].fd >= 0) {
+                    // poll ignores negative descriptors, which we use to
+                    // remove the events that have already been signalled.
+                    fds[i].fd = -1;
+                    --remaining;
+                }
+            }
+
+            if (wait_all && (remaining == 0)) {
+                if (consume_events(events, cnt)) {
+                    return 0;
+                }
+
+                // Another thread was faster, so start over with all events.
+                for (std::size_t i = 0; i < cnt; ++i) {
+                    fds[i].fd = events[i]->descriptor;
+                }
+                remaining = cnt;
+                continue;
+            }
+
+            if ((ready == 0) && (dt == 0)) {
+                return wait_events_timeout;
+            }
+        }
+    }
+
+#else /* defined(POWER_OVERWHELMING_EVENT_EVENTFD) */
     struct event_impl {
         std::condition_variable condition;
         std::mutex mutex;
@@ -23,6 +188,45 @@ namespace detail {
         bool signalled;
     };
 
+    /// <summary>
+    /// Answer whether the given event is signalled without consuming the
+    /// signal.
+    /// </summary>
+    static bool is_signalled(_In_ event_impl *event) {
+        if (event == nullptr) {
+            throw std::system_error(EINVAL, std::system_category());
+        }
+
+        std::lock_guard<decltype(event->mutex)> lock(event->mutex);
+        return event->signalled;
+    }
+
+    /// <summary>
+    /// Consumes the signals of all given events at once, which fails if
+    /// another thread has consumed one of them in the meantime.
+    /// </summary>
+    /// <remarks>
+    /// If one of the events cannot be consumed, the signals of the events
+    /// that have already been consumed are restored such that waiting for
+    /// all events does not lose any signal unless it succeeds.
+    /// </remarks>
+    static bool consume_events(_In_reads_(cnt) const event_type *events,
+            _In_ const std::size_t cnt) {
+        for (std::size_t i = 0; i < cnt; ++i) {
+            if (!wait_event(events[i], 0)) {
+                for (std::size_t j = 0; j < i; ++j) {
+                    if (!events[j]->manual_reset) {
+                        set_event(events[j]);
+                    }
+                }
+                return false;
+            }
+        }
+
+        return true;
+    }
+#endif /* defined(POWER_OVERWHELMING_EVENT_EVENTFD) */
+
 } /* namespace detail */
 } /* namespace power_overwhelming */
 } /* namespace visus */
@@ -34,7 +238,28 @@ namespace detail {
 _Ret_valid_ visus::power_overwhelming::event_type
 visus::power_overwhelming::create_event(_In_ const bool manual_reset,
         _In_ const bool initially_signalled) {
-#if defined(POWER_OVERWHELMING_EVENT_EMULATION)
+#if defined(POWER_OVERWHELMING_EVENT_EVENTFD)
+    // The counter of the eventfd is reset as a whole by a single read, so
+    // any number of signals are consumed by one waiter like an auto-reset
+    // event on Windows.
+    auto descriptor = ::eventfd(initially_signalled ? 1 : 0,
+        EFD_CLOEXEC | EFD_NONBLOCK);
+    if (descriptor < 0) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    auto retval = new (std::nothrow) detail::event_impl;
+    if (retval == nullptr) {
+        ::close(descriptor);
+        throw std::bad_alloc();
+    }
+
+    retval->descriptor = descriptor;
+    retval->manual_reset = manual_reset;
+
+    return retval;
+
+#elif defined(POWER_OVERWHELMING_EVENT_EMULATION)
     auto retval = new detail::event_impl;
 
     retval->manual_reset = manual_reset;
@@ -46,7 +271,7 @@ visus::power_overwhelming::create_event(_In_ const bool manual_reset,
 
     return retval;
 
-#else /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
+#else /* defined(POWER_OVERWHELMING_EVENT_EVENTFD) */
     auto retval = ::CreateEvent(nullptr, manual_reset, initially_signalled,
         nullptr);
 
@@ -55,7 +280,7 @@ visus::power_overwhelming::create_event(_In_ const bool manual_reset,
     }
 
     return retval;
-#endif /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
+#endif /* defined(POWER_OVERWHELMING_EVENT_EVENTFD) */
 }
 
 
@@ -63,22 +288,56 @@ visus::power_overwhelming::create_event(_In_ const bool manual_reset,
  * visus::power_overwhelming::destroy_event
  */
 void visus::power_overwhelming::destroy_event(_Inout_opt_ event_type& event) {
-#if defined(POWER_OVERWHELMING_EVENT_EMULATION)
+#if defined(POWER_OVERWHELMING_EVENT_EVENTFD)
+    if (event != nullptr) {
+        ::close(event->descriptor);
+        delete event;
+        event = nullptr;
+    }
+
+#elif defined(POWER_OVERWHELMING_EVENT_EMULATION)
     delete event;
     event = nullptr;
 
-#else /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
+#else /* defined(POWER_OVERWHELMING_EVENT_EVENTFD) */
     ::CloseHandle(event);
     event = NULL;
-#endif /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
+#endif /* defined(POWER_OVERWHELMING_EVENT_EVENTFD) */
+}
+
+
+#if defined(POWER_OVERWHELMING_EVENT_EVENTFD)
+/*
+ * visus::power_overwhelming::event_descriptor
+ */
+int visus::power_overwhelming::event_descriptor(_In_ event_type event) {
+    return detail::check_event(event)->descriptor;
 }
+#endif /* defined(POWER_OVERWHELMING_EVENT_EVENTFD) */
 
 
 /*
  * visus::power_overwhelming::reset_event
  */
 void visus::power_overwhelming::reset_event(_In_ event_type event) {
-#if defined(POWER_OVERWHELMING_EVENT_EMULATION)
+#if defined(POWER_OVERWHELMING_EVENT_EVENTFD)
+    std::uint64_t value;
+    const auto descriptor = detail::check_event(event)->descriptor;
+    while (::read(descriptor, &value, sizeof(value)) < 0) {
+        switch (errno) {
+            case EINTR:
+                break;
+
+            case EAGAIN:
+                // The event was not signalled in the first place.
+                return;
+
+            default:
+                throw std::system_error(errno, std::system_category());
+        }
+    }
+
+#elif defined(POWER_OVERWHELMING_EVENT_EMULATION)
     if (event == nullptr) {
         throw std::system_error(EINVAL, std::system_category());
     }
@@ -86,12 +345,12 @@ void visus::power_overwhelming::reset_event(_In_ event_type event) {
     std::unique_lock<decltype(event->mutex)> lock(event->mutex);
     event->signalled = false;
 
-#else /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
+#else /* defined(POWER_OVERWHELMING_EVENT_EVENTFD) */
     if (!::ResetEvent(event)) {
         throw std::system_error(::GetLastError(),
             std::system_category());
     }
-#endif /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
+#endif /* defined(POWER_OVERWHELMING_EVENT_EVENTFD) */
 }
 
 
@@ -99,7 +358,24 @@ void visus::power_overwhelming::reset_event(_In_ event_type event) {
  * visus::power_overwhelming::set_event
  */
 void visus::power_overwhelming::set_event(_In_ event_type event) {
-#if defined(POWER_OVERWHELMING_EVENT_EMULATION)
+#if defined(POWER_OVERWHELMING_EVENT_EVENTFD)
+    const std::uint64_t value = 1;
+    const auto descriptor = detail::check_event(event)->descriptor;
+    while (::write(descriptor, &value, sizeof(value)) < 0) {
+        switch (errno) {
+            case EINTR:
+                break;
+
+            case EAGAIN:
+                // The counter is saturated, so the event is signalled anyway.
+                return;
+
+            default:
+                throw std::system_error(errno, std::system_category());
+        }
+    }
+
+#elif defined(POWER_OVERWHELMING_EVENT_EMULATION)
     if (event == nullptr) {
         throw std::system_error(EINVAL, std::system_category());
     }
@@ -108,19 +384,19 @@ void visus::power_overwhelming::set_event(_In_ event_type event) {
     event->signalled = true;
 
     if (event->manual_reset) {
-        // In case of a manual reset event, signal one thread.
-        event->condition.notify_one();
-    } else {
-        // In case of an auto reset event, signal all threads.
+        // In case of a manual reset event, signal all threads.
         event->condition.notify_all();
+    } else {
+        // In case of an auto reset event, only one thread can be released.
+        event->condition.notify_one();
     }
 
-#else /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
+#else /* defined(POWER_OVERWHELMING_EVENT_EVENTFD) */
     if (!::SetEvent(event)) {
         throw std::system_error(::GetLastError(),
             std::system_category());
     }
-#endif /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
+#endif /* defined(POWER_OVERWHELMING_EVENT_EVENTFD) */
 }
 
 
@@ -128,7 +404,10 @@ void visus::power_overwhelming::set_event(_In_ event_type event) {
  * visus::power_overwhelming::wait_event
  */
 void visus::power_overwhelming::wait_event(_In_ event_type event) {
-#if defined(POWER_OVERWHELMING_EVENT_EMULATION)
+#if defined(POWER_OVERWHELMING_EVENT_EVENTFD)
+    detail::wait_eventfd(&event, 1, false, -1);
+
+#elif defined(POWER_OVERWHELMING_EVENT_EMULATION)
     if (event == nullptr) {
         throw std::system_error(EINVAL, std::system_category());
     }
@@ -141,7 +420,7 @@ void visus::power_overwhelming::wait_event(_In_ event_type event) {
         event->signalled = false;
     }
 
-#else /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
+#else /* defined(POWER_OVERWHELMING_EVENT_EVENTFD) */
     switch (::WaitForSingleObject(event, INFINITE)) {
         case WAIT_ABANDONED:
         case WAIT_OBJECT_0:
@@ -154,7 +433,7 @@ void visus::power_overwhelming::wait_event(_In_ event_type event) {
             throw std::system_error(::GetLastError(),
                 std::system_category());
     }
-#endif /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
+#endif /* defined(POWER_OVERWHELMING_EVENT_EVENTFD) */
 }
 
 
@@ -163,7 +442,10 @@ void visus::power_overwhelming::wait_event(_In_ event_type event) {
  */
 bool visus::power_overwhelming::wait_event(_In_ event_type event,
         _In_ const unsigned int timeout) {
-#if defined(POWER_OVERWHELMING_EVENT_EMULATION)
+#if defined(POWER_OVERWHELMING_EVENT_EVENTFD)
+    return (wait_events(&event, 1, false, timeout) != wait_events_timeout);
+
+#elif defined(POWER_OVERWHELMING_EVENT_EMULATION)
     if (event == nullptr) {
         throw std::system_error(EINVAL, std::system_category());
     }
@@ -182,7 +464,7 @@ bool visus::power_overwhelming::wait_event(_In_ event_type event,
 
     return retval;
 
-#else /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
+#else /* defined(POWER_OVERWHELMING_EVENT_EVENTFD) */
     auto retval = ::WaitForSingleObject(event, timeout);
 
     switch (retval) {
@@ -196,5 +478,105 @@ bool visus::power_overwhelming::wait_event(_In_ event_type event,
             throw std::system_error(::GetLastError(),
                 std::system_category());
     }
-#endif /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
+#endif /* defined(POWER_OVERWHELMING_EVENT_EVENTFD) */
+}
+
+
+/*
+ * visus::power_overwhelming::wait_events
+ */
+std::size_t visus::power_overwhelming::wait_events(
+        _In_reads_(cnt) const event_type *events,
+        _In_ const std::size_t cnt,
+        _In_ const bool wait_all) {
+#if defined(POWER_OVERWHELMING_EVENT_EVENTFD)
+    return detail::wait_eventfd(events, cnt, wait_all, -1);
+
+#elif defined(POWER_OVERWHELMING_EVENT_EMULATION)
+    std::size_t retval;
+    while ((retval = wait_events(events, cnt, wait_all, 1000))
+        == wait_events_timeout);
+    return retval;
+
+#else /* defined(POWER_OVERWHELMING_EVENT_EVENTFD) */
+    return wait_events(events, cnt, wait_all, INFINITE);
+#endif /* defined(POWER_OVERWHELMING_EVENT_EVENTFD) */
+}
+
+
+/*
+ * visus::power_overwhelming::wait_events
+ */
+std::size_t visus::power_overwhelming::wait_events(
+        _In_reads_(cnt) const event_type *events,
+        _In_ const std::size_t cnt,
+        _In_ const bool wait_all,
+        _In_ const unsigned int timeout) {
+#if defined(POWER_OVERWHELMING_EVENT_EVENTFD)
+    // poll takes a signed timeout, where negative values wait infinitely.
+    const auto dt = static_cast<int>((std::min)(timeout,
+        static_cast<unsigned int>((std::numeric_limits<int>::max)())));
+    return detail::wait_eventfd(events, cnt, wait_all, dt);
+
+#elif defined(POWER_OVERWHELMING_EVENT_EMULATION)
+    if ((events == nullptr) || (cnt == 0)) {
+        throw std::system_error(EINVAL, std::system_category());
+    }
+
+    // The condition variables cannot be waited for at once, so we poll them.
+    // If we wait for all of them, the signals are only consumed once all
+    // events are signalled, so a timeout does not lose any of them.
+    const auto deadline = std::chrono::steady_clock::now()
+        + std::chrono::milliseconds(timeout);
+
+    while (true) {
+        if (wait_all) {
+            auto all = true;
+            for (std::size_t i = 0; all && (i < cnt); ++i) {
+                all = detail::is_signalled(events[i]);
+            }
+
+            if (all && detail::consume_events(events, cnt)) {
+                return 0;
+            }
+
+        } else {
+            for (std::size_t i = 0; i < cnt; ++i) {
+                if (wait_event(events[i], 0)) {
+                    return i;
+                }
+            }
+        }
+
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return wait_events_timeout;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+#else /* defined(POWER_OVERWHELMING_EVENT_EVENTFD) */
+    if ((cnt == 0) || (cnt > MAXIMUM_WAIT_OBJECTS)) {
+        throw std::invalid_argument("The number of events to wait for must "
+            "be within [1, MAXIMUM_WAIT_OBJECTS].");
+    }
+
+    const auto retval = ::WaitForMultipleObjects(static_cast<DWORD>(cnt),
+        events, wait_all ? TRUE : FALSE, timeout);
+
+    if (retval == WAIT_TIMEOUT) {
+        return wait_events_timeout;
+
+    } else if ((retval >= WAIT_OBJECT_0)
+            && (retval < WAIT_OBJECT_0 + cnt)) {
+        return wait_all ? 0 : (retval - WAIT_OBJECT_0);
+
+    } else if ((retval >= WAIT_ABANDONED_0)
+            && (retval < WAIT_ABANDONED_0 + cnt)) {
+        return wait_all ? 0 : (retval - WAIT_ABANDONED_0);
+
+    } else {
+        throw std::system_error(::GetLastError(), std::system_category());
+    }
+#endif /* defined(POWER_OVERWHELMING_EVENT_EVENTFD) */
 }
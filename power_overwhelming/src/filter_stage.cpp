@@ -0,0 +1,280 @@
+﻿// <copyright file="filter_stage.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "filter_stage.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+
+#include "sensor_name_registry.h"
+#include "waveform_kernels.h"
+
+
+/*
+ * visus::power_overwhelming::detail::filter_stage::state_type::state_type
+ */
+visus::power_overwhelming::detail::filter_stage::state_type::state_type(
+        _In_ const sample_filter& filter,
+        _In_z_ const wchar_t *name)
+    : electric(true), filter(filter), name(name), smoothed { 0.0f },
+        started(false) {
+    if (filter.type() == sample_filter_type::low_pass) {
+        // Design a windowed-sinc kernel with a Hamming window, which is
+        // symmetric and therefore has a constant delay of half its length.
+        const auto pi = 3.14159265358979323846;
+        const auto n = filter.window();
+        const auto m = static_cast<double>(n - 1) / 2.0;
+        const auto fc = static_cast<double>(filter.cutoff());
+        this->taps.resize(n);
+
+        for (std::size_t i = 0; i < n; ++i) {
+            const auto x = static_cast<double>(i) - m;
+            const auto sinc = (x == 0.0)
+                ? 2.0 * fc
+                : std::sin(2.0 * pi * fc * x) / (pi * x);
+            const auto w = 0.54 - 0.46 * std::cos(2.0 * pi
+                * static_cast<double>(i) / static_cast<double>(n - 1));
+            this->taps[i] = static_cast<float>(sinc * w);
+        }
+
+        // Normalise the kernel such that constant signals are retained.
+        const auto sum = std::accumulate(this->taps.begin(), this->taps.end(),
+            0.0f);
+        for (auto& t : this->taps) {
+            t /= sum;
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::filter_stage::state_type::append
+ */
+void visus::power_overwhelming::detail::filter_stage::state_type::append(
+        _In_ const measurement_data& sample) {
+    const auto invalid = measurement_data::invalid_value;
+    this->electric = this->electric
+        && (sample.voltage() != invalid)
+        && (sample.current() != invalid);
+    this->current.push_back(sample.current());
+    this->power.push_back(sample.power());
+    this->timestamps.push_back(sample.timestamp());
+    this->voltage.push_back(sample.voltage());
+}
+
+
+/*
+ * visus::power_overwhelming::detail::filter_stage::filtered_suffix
+ */
+constexpr const wchar_t *
+visus::power_overwhelming::detail::filter_stage::filtered_suffix;
+
+
+/*
+ * visus::power_overwhelming::detail::filter_stage::filter_stage
+ */
+visus::power_overwhelming::detail::filter_stage::filter_stage(void)
+    : _retain_unfiltered(false) { }
+
+
+/*
+ * visus::power_overwhelming::detail::filter_stage::configure
+ */
+void visus::power_overwhelming::detail::filter_stage::configure(
+        _In_ const bool retain_unfiltered) {
+    this->_filters.clear();
+    this->_retain_unfiltered = retain_unfiltered;
+    this->_states.clear();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::filter_stage::filter
+ */
+void visus::power_overwhelming::detail::filter_stage::filter(
+        _In_ const std::wstring& sensor,
+        _In_ const sample_filter& filter) {
+    if (filter) {
+        this->_filters[sensor] = filter;
+    } else {
+        this->_filters.erase(sensor);
+    }
+
+    // Sensors that have already been seen must resolve their filter again.
+    for (auto it = this->_states.begin(); it != this->_states.end();) {
+        if (sensor == it->first) {
+            it = this->_states.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::filter_stage::flush
+ */
+void visus::power_overwhelming::detail::filter_stage::flush(
+        _Inout_ std::vector<measurement>& dst) {
+    for (auto& s : this->_states) {
+        auto& state = s.second;
+        if (!state.filter || !state.started) {
+            continue;
+        }
+
+        if (state.filter.type() != sample_filter_type::exponential) {
+            // Replicate the last sample to complete the windows of the samples
+            // that have not been released yet.
+            const auto last = measurement_data(state.timestamps.back(),
+                state.voltage.back(), state.current.back(),
+                state.power.back());
+            for (std::size_t i = 0; i < state.filter.window() / 2; ++i) {
+                state.append(last);
+            }
+        }
+
+        this->process(state, dst);
+        state.started = false;
+        state.current.clear();
+        state.power.clear();
+        state.timestamps.clear();
+        state.voltage.clear();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::filter_stage::process
+ */
+void visus::power_overwhelming::detail::filter_stage::process(
+        _Inout_ std::vector<measurement>& dst) {
+    for (auto& s : this->_states) {
+        if (s.second.filter) {
+            this->process(s.second, dst);
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::filter_stage::push
+ */
+bool visus::power_overwhelming::detail::filter_stage::push(
+        _In_ const measurement& sample) {
+    if (!this->enabled() || !sample) {
+        return false;
+    }
+
+    auto it = this->_states.find(sample.sensor());
+
+    if (it == this->_states.end()) {
+        // Resolve the filter once per sensor, because the names of the
+        // samples of a sensor are always the same pointer.
+        auto f = this->_filters.find(sample.sensor());
+        const auto filter = (f != this->_filters.end())
+            ? f->second
+            : sample_filter();
+
+        auto name = sample.sensor();
+        if (filter && this->_retain_unfiltered) {
+            const auto n = std::wstring(name) + filtered_suffix;
+            name = sensor_name_registry::intern(n.c_str());
+        }
+
+        it = this->_states.emplace(sample.sensor(),
+            state_type(filter, name)).first;
+    }
+
+    auto& state = it->second;
+    if (!state.filter) {
+        return false;
+    }
+
+    if (!state.started) {
+        state.started = true;
+
+        // Replicate the first sample such that the window of the first
+        // output is complete.
+        for (std::size_t i = 0; i < state.filter.window() / 2; ++i) {
+            state.append(sample.data());
+        }
+
+        if (state.filter.type() == sample_filter_type::exponential) {
+            state.smoothed[0] = sample.current();
+            state.smoothed[1] = sample.power();
+            state.smoothed[2] = sample.voltage();
+        }
+    }
+
+    state.append(sample.data());
+    return !this->_retain_unfiltered;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::filter_stage::process
+ */
+void visus::power_overwhelming::detail::filter_stage::process(
+        _Inout_ state_type& state,
+        _Inout_ std::vector<measurement>& dst) {
+    const auto cnt = state.timestamps.size();
+    const auto exponential = (state.filter.type()
+        == sample_filter_type::exponential);
+    const auto window = state.filter.window();
+
+    if (cnt < window) {
+        return;
+    }
+
+    auto apply = [&](float *out, const float *src, float& smoothed) {
+        switch (state.filter.type()) {
+            case sample_filter_type::exponential:
+                smooth_waveform(out, src, cnt, state.filter.alpha(), smoothed);
+                return cnt;
+
+            case sample_filter_type::low_pass:
+                return convolve_waveform(out, src, cnt, state.taps.data(),
+                    state.taps.size());
+
+            default:
+                return median_waveform(out, src, cnt, window);
+        }
+    };
+
+    this->_power.resize(cnt);
+    const auto n = apply(this->_power.data(), state.power.data(),
+        state.smoothed[1]);
+
+    if (state.electric) {
+        this->_current.resize(cnt);
+        this->_voltage.resize(cnt);
+        apply(this->_current.data(), state.current.data(),
+            state.smoothed[0]);
+        apply(this->_voltage.data(), state.voltage.data(),
+            state.smoothed[2]);
+    }
+
+    // Each output is attributed to the sample in the centre of its window.
+    const auto centre = window / 2;
+    const auto invalid = measurement_data::invalid_value;
+    for (std::size_t i = 0; i < n; ++i) {
+        dst.emplace_back(state.name, state.timestamps[i + centre],
+            state.electric ? this->_voltage[i] : invalid,
+            state.electric ? this->_current[i] : invalid,
+            this->_power[i]);
+    }
+
+    // The last samples are retained to complete the next windows.
+    const auto consumed = exponential ? cnt : n;
+    state.current.erase(state.current.begin(),
+        state.current.begin() + consumed);
+    state.power.erase(state.power.begin(), state.power.begin() + consumed);
+    state.timestamps.erase(state.timestamps.begin(),
+        state.timestamps.begin() + consumed);
+    state.voltage.erase(state.voltage.begin(),
+        state.voltage.begin() + consumed);
+}
@@ -0,0 +1,140 @@
+﻿// <copyright file="filter_stage.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "power_overwhelming/measurement.h"
+#include "power_overwhelming/sample_filter.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Applies the <see cref="sample_filter" />s configured for sensors to
+    /// their samples.
+    /// </summary>
+    /// <remarks>
+    /// <para>The samples of filtered sensors are collected while the I/O
+    /// thread drains the buffers and are filtered in one batch per pass,
+    /// such that the kernels in <see cref="waveform_kernels.h" /> can process
+    /// columns of voltages, currents and powers at once. The samples of all
+    /// other sensors are not affected.</para>
+    /// <para>The median and the low-pass filter need the samples after the
+    /// one they are computing the output for, so their output lags half a
+    /// window behind the input. The output retains the timestamp of the
+    /// sample in the centre of the window, though, and the first and last
+    /// samples of a sensor are replicated to fill the window at the begin and
+    /// the end of the stream.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API filter_stage final {
+
+    public:
+
+        /// <summary>
+        /// The suffix appended to the name of a sensor for its filtered
+        /// samples if the unfiltered ones are retained.
+        /// </summary>
+        static constexpr const wchar_t *filtered_suffix = L"/filtered";
+
+        /// <summary>
+        /// Initialises a new instance, which is disabled.
+        /// </summary>
+        filter_stage(void);
+
+        /// <summary>
+        /// Clears all filters and the samples retained for them.
+        /// </summary>
+        /// <param name="retain_unfiltered">If <c>true</c>, the samples of
+        /// filtered sensors are passed on as they are, and the filtered
+        /// samples are emitted for a sensor with the
+        /// <see cref="filtered_suffix" /> in addition.</param>
+        void configure(_In_ const bool retain_unfiltered);
+
+        /// <summary>
+        /// Answer whether any sensor is filtered.
+        /// </summary>
+        /// <returns><c>true</c> if at least one filter has been set,
+        /// <c>false</c> otherwise.</returns>
+        inline bool enabled(void) const noexcept {
+            return !this->_filters.empty();
+        }
+
+        /// <summary>
+        /// Sets the filter for the sensor with the given name.
+        /// </summary>
+        /// <remarks>
+        /// If the sensor has already delivered samples, its filter restarts
+        /// and the samples that have not yet been released are discarded.
+        /// </remarks>
+        /// <param name="sensor">The name of the sensor.</param>
+        /// <param name="filter">The filter to apply, which removes the filter
+        /// if it is <see cref="sample_filter_type::none" />.</param>
+        void filter(_In_ const std::wstring& sensor,
+            _In_ const sample_filter& filter);
+
+        /// <summary>
+        /// Releases the filtered samples of all sensors, completing the
+        /// windows by replicating the last sample.
+        /// </summary>
+        /// <param name="dst">Receives the filtered samples, which are
+        /// appended.</param>
+        void flush(_Inout_ std::vector<measurement>& dst);
+
+        /// <summary>
+        /// Filters all samples added since the last call.
+        /// </summary>
+        /// <param name="dst">Receives the filtered samples that can be
+        /// released, which are appended.</param>
+        void process(_Inout_ std::vector<measurement>& dst);
+
+        /// <summary>
+        /// Adds a sample.
+        /// </summary>
+        /// <param name="sample">The sample to be added.</param>
+        /// <returns><c>true</c> if the sample has been retained for filtering
+        /// and must not be processed further, <c>false</c> if it must be
+        /// passed on.</returns>
+        bool push(_In_ const measurement& sample);
+
+    private:
+
+        struct state_type {
+            std::vector<float> current;
+            bool electric;
+            sample_filter filter;
+            const wchar_t *name;
+            std::vector<float> power;
+            float smoothed[3];
+            bool started;
+            std::vector<float> taps;
+            std::vector<measurement::timestamp_type> timestamps;
+            std::vector<float> voltage;
+
+            state_type(_In_ const sample_filter& filter,
+                _In_z_ const wchar_t *name);
+
+            void append(_In_ const measurement_data& sample);
+        };
+
+        void process(_Inout_ state_type& state,
+            _Inout_ std::vector<measurement>& dst);
+
+        std::vector<float> _current;
+        std::unordered_map<std::wstring, sample_filter> _filters;
+        std::vector<float> _power;
+        bool _retain_unfiltered;
+        std::unordered_map<const wchar_t *, state_type> _states;
+        std::vector<float> _voltage;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,179 @@
+﻿// <copyright file="flatbuffer_builder.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "flatbuffer_builder.h"
+
+#include <algorithm>
+#include <cassert>
+
+
+/*
+ * ...::detail::flatbuffer_builder::flatbuffer_builder
+ */
+visus::power_overwhelming::detail::flatbuffer_builder::flatbuffer_builder(
+        void) : _min_align(1), _table(0) { }
+
+
+/*
+ * visus::power_overwhelming::detail::flatbuffer_builder::add_offset
+ */
+void visus::power_overwhelming::detail::flatbuffer_builder::add_offset(
+        _In_ const std::uint16_t field, _In_ const offset_type value) {
+    this->prep(sizeof(offset_type), 0);
+    assert(value <= this->size());
+
+    // The offset is relative to the position of the field itself.
+    this->prepend_raw(static_cast<offset_type>(this->size() - value
+        + sizeof(offset_type)));
+    this->_fields.emplace_back(field, this->size());
+}
+
+
+/*
+ * visus::power_overwhelming::detail::flatbuffer_builder::clear
+ */
+void visus::power_overwhelming::detail::flatbuffer_builder::clear(
+        void) noexcept {
+    this->_fields.clear();
+    this->_min_align = 1;
+    this->_reversed.clear();
+    this->_table = 0;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::flatbuffer_builder::create_string
+ */
+visus::power_overwhelming::detail::flatbuffer_builder::offset_type
+visus::power_overwhelming::detail::flatbuffer_builder::create_string(
+        _In_ const std::string& str) {
+    // Strings are zero-terminated in addition to their length.
+    this->prep(sizeof(std::uint32_t), str.size() + 1);
+    this->_reversed.push_back(0);
+    this->_reversed.insert(this->_reversed.end(), str.rbegin(), str.rend());
+    return this->end_vector(str.size());
+}
+
+
+/*
+ * visus::power_overwhelming::detail::flatbuffer_builder::create_vector
+ */
+visus::power_overwhelming::detail::flatbuffer_builder::offset_type
+visus::power_overwhelming::detail::flatbuffer_builder::create_vector(
+        _In_ const std::vector<offset_type>& offsets) {
+    this->start_vector(sizeof(offset_type), offsets.size(),
+        sizeof(offset_type));
+
+    for (auto it = offsets.rbegin(); it != offsets.rend(); ++it) {
+        assert(*it <= this->size());
+        this->prepend_raw(static_cast<offset_type>(this->size() - *it
+            + sizeof(offset_type)));
+    }
+
+    return this->end_vector(offsets.size());
+}
+
+
+/*
+ * visus::power_overwhelming::detail::flatbuffer_builder::end_vector
+ */
+visus::power_overwhelming::detail::flatbuffer_builder::offset_type
+visus::power_overwhelming::detail::flatbuffer_builder::end_vector(
+        _In_ const std::size_t cnt) {
+    // The elements have been aligned such that the length is aligned, too.
+    this->prepend_raw(static_cast<std::uint32_t>(cnt));
+    return this->size();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::flatbuffer_builder::end_table
+ */
+visus::power_overwhelming::detail::flatbuffer_builder::offset_type
+visus::power_overwhelming::detail::flatbuffer_builder::end_table(void) {
+    // Prepend the placeholder for the offset to the vtable.
+    this->prepend(std::int32_t(0));
+    const auto retval = this->size();
+
+    std::uint16_t cnt = 0;
+    for (auto& f : this->_fields) {
+        cnt = (std::max)(cnt, static_cast<std::uint16_t>(f.first + 1));
+    }
+
+    // The vtable holds the position of each field relative to the table,
+    // or zero if the field is absent. It is prepended last to first.
+    std::vector<std::uint16_t> positions(cnt, 0);
+    for (auto& f : this->_fields) {
+        positions[f.first] = static_cast<std::uint16_t>(retval - f.second);
+    }
+
+    for (auto it = positions.rbegin(); it != positions.rend(); ++it) {
+        this->prepend_raw(*it);
+    }
+    this->prepend_raw(static_cast<std::uint16_t>(retval - this->_table));
+    this->prepend_raw(static_cast<std::uint16_t>(
+        (cnt + 2) * sizeof(std::uint16_t)));
+
+    // The vtable immediately precedes the table, so the signed offset from
+    // the table to the vtable is the size of the vtable.
+    const auto vtable = static_cast<std::int32_t>(this->size() - retval);
+    std::uint8_t bytes[sizeof(vtable)];
+    ::memcpy(bytes, &vtable, sizeof(vtable));
+    for (std::size_t i = 0; i < sizeof(bytes); ++i) {
+        this->_reversed[retval - 1 - i] = bytes[i];
+    }
+
+    this->_fields.clear();
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::flatbuffer_builder::finish
+ */
+void visus::power_overwhelming::detail::flatbuffer_builder::finish(
+        _Inout_ std::vector<std::uint8_t>& dst, _In_ const offset_type root) {
+    this->prep(this->_min_align, sizeof(offset_type));
+    this->prepend_raw(static_cast<offset_type>(this->size() - root
+        + sizeof(offset_type)));
+    dst.insert(dst.end(), this->_reversed.rbegin(), this->_reversed.rend());
+}
+
+
+/*
+ * visus::power_overwhelming::detail::flatbuffer_builder::prep
+ */
+void visus::power_overwhelming::detail::flatbuffer_builder::prep(
+        _In_ const std::size_t size, _In_ const std::size_t additional) {
+    assert(size > 0);
+    this->_min_align = (std::max)(this->_min_align, size);
+    const auto used = this->_reversed.size() + additional;
+    const auto padding = (size - (used % size)) % size;
+    this->_reversed.insert(this->_reversed.end(), padding, 0);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::flatbuffer_builder::start_table
+ */
+void visus::power_overwhelming::detail::flatbuffer_builder::start_table(
+        void) {
+    assert(this->_fields.empty());
+    this->_table = this->size();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::flatbuffer_builder::start_vector
+ */
+void visus::power_overwhelming::detail::flatbuffer_builder::start_vector(
+        _In_ const std::size_t size,
+        _In_ const std::size_t cnt,
+        _In_ const std::size_t alignment) {
+    // The length must be aligned after the elements, and the elements must
+    // be aligned as a whole.
+    this->prep(sizeof(std::uint32_t), size * cnt);
+    this->prep(alignment, size * cnt);
+}
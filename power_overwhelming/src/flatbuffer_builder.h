@@ -0,0 +1,186 @@
+﻿// <copyright file="flatbuffer_builder.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Builds a FlatBuffer from back to front like the builder of the
+    /// FlatBuffers library, which we do not want to depend on for the few
+    /// messages of the Arrow IPC format.
+    /// </summary>
+    /// <remarks>
+    /// <para>Objects are referred to by their offset from the end of the
+    /// buffer, which is stable while the buffer grows. Children must
+    /// therefore be created before their parents, and only one table can be
+    /// under construction at a time.</para>
+    /// <para>The bytes are collected in reverse order and reversed once the
+    /// buffer is finished, such that prepending does not move the data
+    /// already written.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API flatbuffer_builder final {
+
+    public:
+
+        /// <summary>
+        /// The type of an offset of an object from the end of the buffer.
+        /// </summary>
+        typedef std::uint32_t offset_type;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        flatbuffer_builder(void);
+
+        /// <summary>
+        /// Adds an offset to another object as field of the current table.
+        /// </summary>
+        /// <param name="field">The zero-based index of the field.</param>
+        /// <param name="value">The offset of the object.</param>
+        void add_offset(_In_ const std::uint16_t field,
+            _In_ const offset_type value);
+
+        /// <summary>
+        /// Adds a scalar field to the current table.
+        /// </summary>
+        /// <typeparam name="TValue">The type of the field.</typeparam>
+        /// <param name="field">The zero-based index of the field.</param>
+        /// <param name="value">The value of the field.</param>
+        template<class TValue>
+        inline void add_scalar(_In_ const std::uint16_t field,
+                _In_ const TValue value) {
+            this->prepend(value);
+            this->_fields.emplace_back(field, this->size());
+        }
+
+        /// <summary>
+        /// Clears the buffer for building a new one.
+        /// </summary>
+        void clear(void) noexcept;
+
+        /// <summary>
+        /// Creates a string.
+        /// </summary>
+        /// <param name="str">The UTF-8 string.</param>
+        /// <returns>The offset of the string.</returns>
+        offset_type create_string(_In_ const std::string& str);
+
+        /// <summary>
+        /// Creates a vector of offsets to other objects.
+        /// </summary>
+        /// <param name="offsets">The offsets of the elements.</param>
+        /// <returns>The offset of the vector.</returns>
+        offset_type create_vector(_In_ const std::vector<offset_type>& offsets);
+
+        /// <summary>
+        /// Finishes the current vector.
+        /// </summary>
+        /// <param name="cnt">The number of elements that have been prepended
+        /// since <see cref="start_vector" />.</param>
+        /// <returns>The offset of the vector.</returns>
+        offset_type end_vector(_In_ const std::size_t cnt);
+
+        /// <summary>
+        /// Finishes the current table by prepending its vtable.
+        /// </summary>
+        /// <returns>The offset of the table.</returns>
+        offset_type end_table(void);
+
+        /// <summary>
+        /// Finishes the buffer with the given root table and appends the
+        /// buffer to <paramref name="dst" />.
+        /// </summary>
+        /// <remarks>
+        /// The size of the buffer is a multiple of the largest alignment of
+        /// any object, such that the root is aligned if <paramref name="dst" />
+        /// was aligned.
+        /// </remarks>
+        /// <param name="dst">Receives the finished buffer.</param>
+        /// <param name="root">The offset of the root table.</param>
+        void finish(_Inout_ std::vector<std::uint8_t>& dst,
+            _In_ const offset_type root);
+
+        /// <summary>
+        /// Prepends padding to align the next <paramref name="size" /> bytes
+        /// after <paramref name="additional" /> bytes.
+        /// </summary>
+        /// <param name="size">The required alignment.</param>
+        /// <param name="additional">The number of bytes that will be written
+        /// before the aligned value.</param>
+        void prep(_In_ const std::size_t size,
+            _In_ const std::size_t additional);
+
+        /// <summary>
+        /// Prepends a scalar aligned to its size.
+        /// </summary>
+        /// <typeparam name="TValue">The type of the scalar.</typeparam>
+        /// <param name="value">The value to be prepended.</param>
+        template<class TValue> inline void prepend(_In_ const TValue value) {
+            this->prep(sizeof(value), 0);
+            this->prepend_raw(value);
+        }
+
+        /// <summary>
+        /// Prepends a scalar without aligning it, which is used for the
+        /// members of structs that have been aligned as a whole.
+        /// </summary>
+        /// <typeparam name="TValue">The type of the scalar.</typeparam>
+        /// <param name="value">The value to be prepended.</param>
+        template<class TValue>
+        inline void prepend_raw(_In_ const TValue value) {
+            std::uint8_t bytes[sizeof(TValue)];
+            ::memcpy(bytes, &value, sizeof(value));
+            for (std::size_t i = sizeof(bytes); i > 0; --i) {
+                this->_reversed.push_back(bytes[i - 1]);
+            }
+        }
+
+        /// <summary>
+        /// Answer the current size of the buffer.
+        /// </summary>
+        /// <returns>The number of bytes written so far.</returns>
+        inline offset_type size(void) const noexcept {
+            return static_cast<offset_type>(this->_reversed.size());
+        }
+
+        /// <summary>
+        /// Starts a table, whose fields are added subsequently.
+        /// </summary>
+        void start_table(void);
+
+        /// <summary>
+        /// Starts a vector whose elements are prepended in reverse order
+        /// subsequently.
+        /// </summary>
+        /// <param name="size">The size of an element in bytes.</param>
+        /// <param name="cnt">The number of elements.</param>
+        /// <param name="alignment">The alignment of the elements.</param>
+        void start_vector(_In_ const std::size_t size,
+            _In_ const std::size_t cnt,
+            _In_ const std::size_t alignment);
+
+    private:
+
+        std::vector<std::pair<std::uint16_t, offset_type>> _fields;
+        std::size_t _min_align;
+        std::vector<std::uint8_t> _reversed;
+        offset_type _table;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
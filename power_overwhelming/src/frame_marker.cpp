@@ -0,0 +1,233 @@
+﻿// <copyright file="frame_marker.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/frame_marker.h"
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#endif /* defined(_WIN32) */
+
+#include "frame_marker_impl.h"
+
+
+#if defined(_WIN32)
+namespace {
+
+    /// <summary>
+    /// The type of <c>IDXGISwapChain::Present</c>.
+    /// </summary>
+    typedef HRESULT (STDMETHODCALLTYPE *present_type)(IDXGISwapChain *,
+        UINT, UINT);
+
+    /// <summary>
+    /// The index of <c>IDXGISwapChain::Present</c> in the virtual function
+    /// table, which follows the three methods of <c>IUnknown</c>, the four
+    /// of <c>IDXGIObject</c> and the one of <c>IDXGIDeviceSubObject</c>.
+    /// </summary>
+    constexpr std::size_t present_slot = 8;
+
+    /// <summary>
+    /// The frame marker that the hook reports to, if any.
+    /// </summary>
+    std::atomic<visus::power_overwhelming::detail::frame_marker_impl *>
+        hooked_marker(nullptr);
+
+    /// <summary>
+    /// The original implementation of <c>IDXGISwapChain::Present</c>.
+    /// </summary>
+    /// <remarks>
+    /// The pointer is retained after the hook has been removed, because
+    /// another thread might still be in the hook.
+    /// </remarks>
+    std::atomic<present_type> original_present(nullptr);
+
+    /// <summary>
+    /// The virtual function table that has been patched.
+    /// </summary>
+    void **patched_table = nullptr;
+
+    /// <summary>
+    /// Replaces the given slot of a virtual function table.
+    /// </summary>
+    void patch(void **table, const std::size_t slot, void *function) {
+        auto entry = table + slot;
+        DWORD protection = 0;
+
+        if (!::VirtualProtect(entry, sizeof(*entry), PAGE_READWRITE,
+                &protection)) {
+            throw std::system_error(::GetLastError(), std::system_category());
+        }
+
+        *entry = function;
+        ::VirtualProtect(entry, sizeof(*entry), protection, &protection);
+        ::FlushInstructionCache(::GetCurrentProcess(), entry, sizeof(*entry));
+    }
+
+    /// <summary>
+    /// Marks a frame boundary and forwards to the original
+    /// <c>IDXGISwapChain::Present</c>.
+    /// </summary>
+    HRESULT STDMETHODCALLTYPE hooked_present(IDXGISwapChain *that,
+            UINT sync_interval, UINT flags) {
+        auto marker = hooked_marker.load(std::memory_order_acquire);
+        if (marker != nullptr) {
+            marker->push(marker->id);
+        }
+
+        auto present = original_present.load(std::memory_order_acquire);
+        return present(that, sync_interval, flags);
+    }
+
+} /* namespace */
+#endif /* defined(_WIN32) */
+
+
+/*
+ * visus::power_overwhelming::frame_marker::~frame_marker
+ */
+visus::power_overwhelming::frame_marker::~frame_marker(void) {
+#if defined(_WIN32)
+    this->unhook();
+#endif /* defined(_WIN32) */
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::frame_marker::begin
+ */
+void visus::power_overwhelming::frame_marker::begin(void) noexcept {
+    if (this->_impl != nullptr) {
+        this->_impl->push(this->_impl->id);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::frame_marker::dropped
+ */
+std::uint64_t visus::power_overwhelming::frame_marker::dropped(
+        void) const noexcept {
+    return (this->_impl != nullptr) ? this->_impl->ring->overflows() : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::frame_marker::end
+ */
+void visus::power_overwhelming::frame_marker::end(void) noexcept {
+    if (this->_impl != nullptr) {
+        this->_impl->push(0);
+    }
+}
+
+
+#if defined(_WIN32)
+/*
+ * visus::power_overwhelming::frame_marker::hook
+ */
+void visus::power_overwhelming::frame_marker::hook(
+        _In_ IDXGISwapChain *swap_chain) {
+    if (swap_chain == nullptr) {
+        throw std::invalid_argument("The swap chain to be hooked must not be "
+            "null.");
+    }
+    if (this->_impl == nullptr) {
+        throw std::logic_error("A disposed frame marker cannot hook a swap "
+            "chain.");
+    }
+
+    detail::frame_marker_impl *expected = nullptr;
+    if (!hooked_marker.compare_exchange_strong(expected, this->_impl)) {
+        throw std::logic_error("Another frame marker has already hooked a "
+            "swap chain.");
+    }
+
+    try {
+        auto table = *reinterpret_cast<void ***>(swap_chain);
+        auto present = reinterpret_cast<void *>(&hooked_present);
+
+        // If the table is still patched by a previous hook, we must not
+        // forward to ourselves.
+        if (table[present_slot] != present) {
+            original_present.store(reinterpret_cast<present_type>(
+                table[present_slot]), std::memory_order_release);
+            patch(table, present_slot, present);
+        }
+
+        patched_table = table;
+    } catch (...) {
+        hooked_marker.store(nullptr, std::memory_order_release);
+        throw;
+    }
+}
+#endif /* defined(_WIN32) */
+
+
+/*
+ * visus::power_overwhelming::frame_marker::present
+ */
+void visus::power_overwhelming::frame_marker::present(void) noexcept {
+    if (this->_impl != nullptr) {
+        this->_impl->push(this->_impl->id);
+    }
+}
+
+
+#if defined(_WIN32)
+/*
+ * visus::power_overwhelming::frame_marker::unhook
+ */
+void visus::power_overwhelming::frame_marker::unhook(void) noexcept {
+    if ((this->_impl == nullptr)
+            || (hooked_marker.load(std::memory_order_acquire) != this->_impl)) {
+        return;
+    }
+
+    try {
+        patch(patched_table, present_slot, reinterpret_cast<void *>(
+            original_present.load(std::memory_order_acquire)));
+        patched_table = nullptr;
+    } catch (...) {
+        // If the table cannot be restored, the hook remains in place, but
+        // it does not report to the frame marker anymore.
+    }
+
+    hooked_marker.store(nullptr, std::memory_order_release);
+}
+#endif /* defined(_WIN32) */
+
+
+/*
+ * visus::power_overwhelming::frame_marker::operator =
+ */
+visus::power_overwhelming::frame_marker&
+visus::power_overwhelming::frame_marker::operator =(
+        _Inout_ frame_marker&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+#if defined(_WIN32)
+        this->unhook();
+#endif /* defined(_WIN32) */
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::frame_marker::operator bool
+ */
+visus::power_overwhelming::frame_marker::operator bool(
+        void) const noexcept {
+    return (this->_impl != nullptr);
+}
@@ -0,0 +1,87 @@
+﻿// <copyright file="frame_marker_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <memory>
+#include <utility>
+
+#include "power_overwhelming/frame_marker.h"
+#include "power_overwhelming/measurement.h"
+#include "power_overwhelming/timestamp_resolution.h"
+
+#include "spsc_ring.h"
+#include "timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The ring transporting frame boundaries from a
+    /// <see cref="frame_marker" /> to the I/O thread of its collector.
+    /// </summary>
+    /// <remarks>
+    /// The elements are the same pairs of timestamp and marker ID as the
+    /// marker events of the collector.
+    /// </remarks>
+    typedef spsc_ring<std::pair<measurement::timestamp_type, std::uint32_t>>
+        frame_ring;
+
+
+    /// <summary>
+    /// Private data container for <see cref="frame_marker" />.
+    /// </summary>
+    struct frame_marker_impl final {
+
+        /// <summary>
+        /// The ID of the marker starting a frame.
+        /// </summary>
+        std::uint32_t id;
+
+        /// <summary>
+        /// The resolution of the timestamps of the collector.
+        /// </summary>
+        timestamp_resolution resolution;
+
+        /// <summary>
+        /// The ring shared with the collector, which keeps it alive even if
+        /// the collector is destroyed first.
+        /// </summary>
+        std::shared_ptr<frame_ring> ring;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="ring">The ring to write to.</param>
+        /// <param name="id">The ID of the marker starting a frame.</param>
+        /// <param name="resolution">The resolution of the timestamps of the
+        /// collector.</param>
+        inline frame_marker_impl(const std::shared_ptr<frame_ring>& ring,
+                const std::uint32_t id,
+                const timestamp_resolution resolution)
+            : id(id), resolution(resolution), ring(ring) { }
+
+        frame_marker_impl(const frame_marker_impl&) = delete;
+
+        /// <summary>
+        /// Pushes a frame boundary at the current time to the
+        /// <see cref="ring" />.
+        /// </summary>
+        /// <param name="marker">The ID of the marker active from now on,
+        /// which is zero outside of frames.</param>
+        inline void push(const std::uint32_t marker) noexcept {
+            this->ring->push(std::make_pair(create_timestamp(
+                this->resolution), marker));
+        }
+
+        frame_marker_impl& operator =(const frame_marker_impl&) = delete;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,155 @@
+﻿// <copyright file="gpu_clock_monitor.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "gpu_clock_monitor.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include "adl_scope.h"
+#include "adl_sensor_impl.h"
+#include "nvidia_management_library.h"
+#include "nvml_sensor_impl.h"
+#include "zero_memory.h"
+
+
+/*
+ * visus::power_overwhelming::detail::gpu_clock_monitor::gpu_clock_monitor
+ */
+visus::power_overwhelming::detail::gpu_clock_monitor::gpu_clock_monitor(
+        void) {
+    this->discover_nvml();
+    this->discover_adl();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::gpu_clock_monitor::~gpu_clock_monitor
+ */
+visus::power_overwhelming::detail::gpu_clock_monitor::~gpu_clock_monitor(
+        void) {
+    for (auto& s : this->_adl_sessions) {
+        try {
+            s->unsubscribe(this);
+        } catch (...) {
+            // The session will stop logging once the last sensor has left.
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::gpu_clock_monitor::sample
+ */
+void visus::power_overwhelming::detail::gpu_clock_monitor::sample(
+        _Out_ std::vector<clock_type>& dst) const {
+    dst.clear();
+    dst.reserve(this->size());
+
+    for (auto d : this->_nvml_devices) {
+        unsigned int clock = 0;
+        auto status = nvidia_management_library::instance()
+            .nvmlDeviceGetClockInfo(d, NVML_CLOCK_GRAPHICS, &clock);
+        dst.push_back((status == NVML_SUCCESS) ? clock : 0);
+    }
+
+    for (auto& s : this->_adl_sessions) {
+        ADLPMLogData data;
+        clock_type clock = 0;
+
+        try {
+            s->read(data);
+            auto i = adl_sensor_impl::find_if(data,
+                    [](const ADL_PMLOG_SENSORS id) {
+                return (id == ADL_PMLOG_CLK_GFXCLK);
+            });
+            if (i >= 0) {
+                clock = data.ulValues[i][1];
+            }
+        } catch (...) {
+            clock = 0;
+        }
+
+        dst.push_back(clock);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::gpu_clock_monitor::discover_adl
+ */
+void visus::power_overwhelming::detail::gpu_clock_monitor::discover_adl(
+        void) {
+    try {
+        adl_scope scope;
+        std::vector<std::string> udids;
+
+        ADLPMLogStartInput input;
+        ::ZeroMemory(&input, sizeof(input));
+        input.usSensors[0] = ADL_PMLOG_CLK_GFXCLK;
+        input.usSensors[1] = ADL_SENSOR_MAXTYPES;
+
+        for (auto& a : adl_sensor_impl::get_adapters(scope)) {
+            // ADL reports an adapter for each display output, but the log is
+            // per GPU, so we must subscribe only once.
+            if (std::find(udids.begin(), udids.end(), a.strUDID)
+                    != udids.end()) {
+                continue;
+            }
+
+            ADLPMLogSupportInfo info;
+            auto status = amd_display_library::instance()
+                .ADL2_Adapter_PMLog_Support_Get(scope, a.iAdapterIndex, &info);
+            if (status != ADL_OK) {
+                continue;
+            }
+
+            auto end = info.usSensors + ADL_PMLOG_MAX_SENSORS;
+            if (std::find(info.usSensors, end, ADL_PMLOG_CLK_GFXCLK) == end) {
+                continue;
+            }
+
+            try {
+                auto session = adl_pmlog_session::acquire(a.iAdapterIndex);
+                session->subscribe(this, input);
+                this->_adl_sessions.push_back(std::move(session));
+                udids.emplace_back(a.strUDID);
+            } catch (...) {
+                // The adapter cannot be monitored, but the others might be.
+            }
+        }
+    } catch (...) {
+        // ADL is not available, so there are no AMD GPUs to monitor.
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::gpu_clock_monitor::discover_nvml
+ */
+void visus::power_overwhelming::detail::gpu_clock_monitor::discover_nvml(
+        void) {
+    try {
+        this->_nvml_scope.reset(new nvml_scope());
+
+        auto& nvml = nvidia_management_library::instance();
+        if (nvml.nvmlDeviceGetClockInfo == nullptr) {
+            return;
+        }
+
+        for (auto& id : nvml_sensor_impl::get_bus_ids()) {
+            nvmlDevice_t device;
+            auto status = nvml.nvmlDeviceGetHandleByPciBusId(id.c_str(),
+                &device);
+            if (status == NVML_SUCCESS) {
+                this->_nvml_devices.push_back(device);
+            }
+        }
+    } catch (...) {
+        // NVML is not available, so there are no NVIDIA GPUs to monitor.
+        this->_nvml_devices.clear();
+    }
+}
@@ -0,0 +1,86 @@
+﻿// <copyright file="gpu_clock_monitor.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <nvml.h>
+
+#include "adl_pmlog_session.h"
+#include "clock_settle_detector.h"
+#include "nvml_scope.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Reads the current graphics clock of all NVIDIA and AMD GPUs in the
+    /// system.
+    /// </summary>
+    /// <remarks>
+    /// <para>The monitor reuses the device discovery of the
+    /// <see cref="nvml_sensor" /> and the <see cref="adl_sensor" />, and it
+    /// subscribes to the shared PMLog session of AMD adapters, such that it
+    /// does not interfere with sensors recording at the same time.</para>
+    /// <para>GPUs whose clock cannot be read are silently ignored, which
+    /// includes all GPUs if the respective vendor library is not installed.
+    /// </para>
+    /// </remarks>
+    class gpu_clock_monitor final {
+
+    public:
+
+        /// <summary>
+        /// The type of a clock reading in MHz.
+        /// </summary>
+        typedef clock_settle_detector::clock_type clock_type;
+
+        /// <summary>
+        /// Initialises a new instance monitoring all GPUs which support it.
+        /// </summary>
+        gpu_clock_monitor(void);
+
+        gpu_clock_monitor(const gpu_clock_monitor&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~gpu_clock_monitor(void);
+
+        /// <summary>
+        /// Reads the current graphics clock of all monitored GPUs.
+        /// </summary>
+        /// <param name="dst">Receives one clock per GPU, NVIDIA devices
+        /// first. A GPU whose reading failed reports zero.</param>
+        void sample(_Out_ std::vector<clock_type>& dst) const;
+
+        /// <summary>
+        /// Answer the number of monitored GPUs.
+        /// </summary>
+        /// <returns>The number of GPUs whose clock can be read.</returns>
+        inline std::size_t size(void) const noexcept {
+            return this->_nvml_devices.size() + this->_adl_sessions.size();
+        }
+
+        gpu_clock_monitor& operator =(const gpu_clock_monitor&) = delete;
+
+    private:
+
+        void discover_adl(void);
+
+        void discover_nvml(void);
+
+        std::vector<std::shared_ptr<adl_pmlog_session>> _adl_sessions;
+        std::vector<nvmlDevice_t> _nvml_devices;
+        std::unique_ptr<nvml_scope> _nvml_scope;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,386 @@
+﻿// <copyright file="gpu_timestamp_correlator.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/gpu_timestamp_correlator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <stdexcept>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <wrl.h>
+#endif /* defined(_WIN32) */
+
+#include "com_error_category.h"
+#include "gpu_timestamp_correlator_impl.h"
+#include "on_exit.h"
+#include "safe_com.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+#if (POWER_OVERWHELMING_GPU_ABSTRACTION == 12)
+    /// <summary>
+    /// Records the current time of the command queue of
+    /// <paramref name="impl" />.
+    /// </summary>
+    static void calibrate_queue(_In_ gpu_timestamp_correlator_impl& impl) {
+        assert(impl.queue != nullptr);
+        UINT64 cpu = 0;
+        UINT64 gpu = 0;
+
+        const auto request = create_timestamp(
+            timestamp_resolution::hundred_nanoseconds);
+        const auto hr = impl.queue->GetClockCalibration(&gpu, &cpu);
+        const auto response = create_timestamp(
+            timestamp_resolution::hundred_nanoseconds);
+        if (FAILED(hr)) {
+            throw std::system_error(hr, com_category());
+        }
+
+        impl.update(request, gpu, response);
+    }
+#endif /* (POWER_OVERWHELMING_GPU_ABSTRACTION == 12) */
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::gpu_timestamp_correlator::default_capacity
+ */
+constexpr std::size_t
+visus::power_overwhelming::gpu_timestamp_correlator::default_capacity;
+
+
+/*
+ * ...::gpu_timestamp_correlator::gpu_timestamp_correlator
+ */
+visus::power_overwhelming::gpu_timestamp_correlator::gpu_timestamp_correlator(
+    void) noexcept : _impl(nullptr) { }
+
+
+/*
+ * ...::gpu_timestamp_correlator::gpu_timestamp_correlator
+ */
+visus::power_overwhelming::gpu_timestamp_correlator::gpu_timestamp_correlator(
+        _In_ const gpu_timestamp_type frequency) : _impl(nullptr) {
+    if (frequency == 0) {
+        throw std::invalid_argument("The frequency of the GPU clock must not "
+            "be zero.");
+    }
+
+    this->_impl = new detail::gpu_timestamp_correlator_impl(frequency);
+}
+
+
+#if (POWER_OVERWHELMING_GPU_ABSTRACTION == 12)
+/*
+ * ...::gpu_timestamp_correlator::gpu_timestamp_correlator
+ */
+visus::power_overwhelming::gpu_timestamp_correlator::gpu_timestamp_correlator(
+        _In_ ID3D12CommandQueue *queue,
+        _In_ const std::size_t capacity) : _impl(nullptr) {
+    if (queue == nullptr) {
+        throw std::invalid_argument("The command queue to be calibrated must "
+            "not be null.");
+    }
+    if (capacity == 0) {
+        throw std::invalid_argument("The number of timestamp queries must not "
+            "be zero.");
+    }
+
+    UINT64 frequency = 0;
+    auto hr = queue->GetTimestampFrequency(&frequency);
+    if (FAILED(hr)) {
+        throw std::system_error(hr, detail::com_category());
+    }
+
+    std::unique_ptr<detail::gpu_timestamp_correlator_impl> impl(
+        new detail::gpu_timestamp_correlator_impl(frequency));
+    impl->capacity = capacity;
+    impl->markers.resize(capacity);
+    impl->queue = queue;
+    detail::safe_add_ref(impl->queue);
+
+    Microsoft::WRL::ComPtr<ID3D12Device> device;
+    hr = queue->GetDevice(IID_PPV_ARGS(&device));
+    if (FAILED(hr)) {
+        throw std::system_error(hr, detail::com_category());
+    }
+
+    // Copy queues require a special kind of query heap.
+    const auto queue_desc = queue->GetDesc();
+
+    {
+        D3D12_QUERY_HEAP_DESC desc = { };
+        desc.Type = (queue_desc.Type == D3D12_COMMAND_LIST_TYPE_COPY)
+            ? D3D12_QUERY_HEAP_TYPE_COPY_QUEUE_TIMESTAMP
+            : D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+        desc.Count = static_cast<UINT>(capacity);
+        desc.NodeMask = queue_desc.NodeMask;
+
+        hr = device->CreateQueryHeap(&desc, IID_PPV_ARGS(&impl->heap));
+        if (FAILED(hr)) {
+            throw std::system_error(hr, detail::com_category());
+        }
+    }
+
+    {
+        D3D12_HEAP_PROPERTIES props = { };
+        props.Type = D3D12_HEAP_TYPE_READBACK;
+        props.CreationNodeMask = queue_desc.NodeMask;
+        props.VisibleNodeMask = queue_desc.NodeMask;
+
+        D3D12_RESOURCE_DESC desc = { };
+        desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+        desc.Width = capacity * sizeof(UINT64);
+        desc.Height = 1;
+        desc.DepthOrArraySize = 1;
+        desc.MipLevels = 1;
+        desc.Format = DXGI_FORMAT_UNKNOWN;
+        desc.SampleDesc.Count = 1;
+        desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+        hr = device->CreateCommittedResource(&props, D3D12_HEAP_FLAG_NONE,
+            &desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr,
+            IID_PPV_ARGS(&impl->readback));
+        if (FAILED(hr)) {
+            throw std::system_error(hr, detail::com_category());
+        }
+    }
+
+    detail::calibrate_queue(*impl);
+    this->_impl = impl.release();
+}
+#endif /* (POWER_OVERWHELMING_GPU_ABSTRACTION == 12) */
+
+
+/*
+ * ...::gpu_timestamp_correlator::~gpu_timestamp_correlator
+ */
+visus::power_overwhelming::gpu_timestamp_correlator::~gpu_timestamp_correlator(
+        void) {
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::gpu_timestamp_correlator::calibrate
+ */
+void visus::power_overwhelming::gpu_timestamp_correlator::calibrate(void) {
+#if (POWER_OVERWHELMING_GPU_ABSTRACTION == 12)
+    if ((this->_impl != nullptr) && (this->_impl->queue != nullptr)) {
+        detail::calibrate_queue(*this->_impl);
+        return;
+    }
+#endif /* (POWER_OVERWHELMING_GPU_ABSTRACTION == 12) */
+
+    throw std::logic_error("The GPU timestamp correlator has not been "
+        "created for a command queue, so it must be calibrated via a "
+        "callback.");
+}
+
+
+/*
+ * visus::power_overwhelming::gpu_timestamp_correlator::calibrate
+ */
+void visus::power_overwhelming::gpu_timestamp_correlator::calibrate(
+        _In_ const clock_query_type query,
+        _In_opt_ void *context) {
+    if (query == nullptr) {
+        throw std::invalid_argument("The callback reading the GPU clock must "
+            "not be null.");
+    }
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("A GPU timestamp correlator that has been "
+            "disposed cannot be calibrated.");
+    }
+
+    const auto request = detail::create_timestamp(
+        timestamp_resolution::hundred_nanoseconds);
+    const auto gpu = query(context);
+    const auto response = detail::create_timestamp(
+        timestamp_resolution::hundred_nanoseconds);
+
+    this->_impl->update(request, gpu, response);
+}
+
+
+#if (POWER_OVERWHELMING_GPU_ABSTRACTION == 12)
+/*
+ * visus::power_overwhelming::gpu_timestamp_correlator::collect
+ */
+std::size_t visus::power_overwhelming::gpu_timestamp_correlator::collect(
+        _In_ collector& dst) {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("A GPU timestamp correlator that has been "
+            "disposed cannot collect any queries.");
+    }
+
+    auto& impl = *this->_impl;
+    std::size_t retval = 0;
+
+    if ((impl.readback == nullptr) || (impl.collected == impl.resolved)) {
+        return retval;
+    }
+
+    void *data = nullptr;
+    D3D12_RANGE range = { 0, impl.capacity * sizeof(UINT64) };
+    auto hr = impl.readback->Map(0, &range, &data);
+    if (FAILED(hr)) {
+        throw std::system_error(hr, detail::com_category());
+    }
+
+    auto unmap = detail::on_exit([&impl](void) {
+        // We did not write anything.
+        D3D12_RANGE range = { 0, 0 };
+        impl.readback->Unmap(0, &range);
+    });
+
+    auto timestamps = static_cast<const UINT64 *>(data);
+    for (; impl.collected < impl.resolved; ++impl.collected, ++retval) {
+        const auto slot = impl.collected % impl.capacity;
+        dst.marker(impl.markers[slot], this->to_host(timestamps[slot]));
+    }
+
+    return retval;
+}
+#endif /* (POWER_OVERWHELMING_GPU_ABSTRACTION == 12) */
+
+
+/*
+ * visus::power_overwhelming::gpu_timestamp_correlator::frequency
+ */
+visus::power_overwhelming::gpu_timestamp_correlator::gpu_timestamp_type
+visus::power_overwhelming::gpu_timestamp_correlator::frequency(
+        void) const noexcept {
+    return (this->_impl != nullptr) ? this->_impl->frequency : 0;
+}
+
+
+#if (POWER_OVERWHELMING_GPU_ABSTRACTION == 12)
+/*
+ * visus::power_overwhelming::gpu_timestamp_correlator::mark
+ */
+void visus::power_overwhelming::gpu_timestamp_correlator::mark(
+        _In_ ID3D12GraphicsCommandList *list,
+        _In_ const std::uint32_t marker) {
+    if (list == nullptr) {
+        throw std::invalid_argument("The command list to record the "
+            "timestamp query in must not be null.");
+    }
+    if ((this->_impl == nullptr) || (this->_impl->heap == nullptr)) {
+        throw std::logic_error("The GPU timestamp correlator has not been "
+            "created for a command queue, so it cannot record queries.");
+    }
+
+    auto& impl = *this->_impl;
+    if (impl.next - impl.collected >= impl.capacity) {
+        throw std::length_error("All timestamp queries are in flight. Collect "
+            "the results of the queries more often or increase the capacity "
+            "of the correlator.");
+    }
+
+    const auto slot = static_cast<std::size_t>(impl.next % impl.capacity);
+    list->EndQuery(impl.heap, D3D12_QUERY_TYPE_TIMESTAMP,
+        static_cast<UINT>(slot));
+    impl.markers[slot] = marker;
+    ++impl.next;
+}
+
+
+/*
+ * visus::power_overwhelming::gpu_timestamp_correlator::resolve
+ */
+void visus::power_overwhelming::gpu_timestamp_correlator::resolve(
+        _In_ ID3D12GraphicsCommandList *list) {
+    if (list == nullptr) {
+        throw std::invalid_argument("The command list to record the "
+            "resolution of the queries in must not be null.");
+    }
+    if ((this->_impl == nullptr) || (this->_impl->heap == nullptr)) {
+        throw std::logic_error("The GPU timestamp correlator has not been "
+            "created for a command queue, so it cannot resolve queries.");
+    }
+
+    auto& impl = *this->_impl;
+
+    // The queries wrap around at the end of the heap, in which case two
+    // contiguous ranges must be resolved.
+    while (impl.resolved < impl.next) {
+        const auto begin = static_cast<std::size_t>(impl.resolved
+            % impl.capacity);
+        const auto cnt = (std::min)(
+            static_cast<std::size_t>(impl.next - impl.resolved),
+            impl.capacity - begin);
+        list->ResolveQueryData(impl.heap, D3D12_QUERY_TYPE_TIMESTAMP,
+            static_cast<UINT>(begin), static_cast<UINT>(cnt), impl.readback,
+            begin * sizeof(UINT64));
+        impl.resolved += cnt;
+    }
+}
+#endif /* (POWER_OVERWHELMING_GPU_ABSTRACTION == 12) */
+
+
+/*
+ * visus::power_overwhelming::gpu_timestamp_correlator::synchronised
+ */
+bool visus::power_overwhelming::gpu_timestamp_correlator::synchronised(
+        void) const noexcept {
+    return (this->_impl != nullptr) && this->_impl->clock.synchronised();
+}
+
+
+/*
+ * visus::power_overwhelming::gpu_timestamp_correlator::to_host
+ */
+visus::power_overwhelming::gpu_timestamp_correlator::timestamp_type
+visus::power_overwhelming::gpu_timestamp_correlator::to_host(
+        _In_ const gpu_timestamp_type timestamp,
+        _In_ const timestamp_resolution resolution) const {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("A GPU timestamp correlator that has been "
+            "disposed cannot convert timestamps.");
+    }
+    if (!this->_impl->clock.synchronised()) {
+        throw std::logic_error("The GPU timestamp correlator must be "
+            "calibrated before it can convert timestamps.");
+    }
+
+    const auto retval = this->_impl->clock.to_host(
+        this->_impl->to_file_time(timestamp));
+    return detail::convert(retval, resolution);
+}
+
+
+/*
+ * visus::power_overwhelming::gpu_timestamp_correlator::operator =
+ */
+visus::power_overwhelming::gpu_timestamp_correlator&
+visus::power_overwhelming::gpu_timestamp_correlator::operator =(
+        _Inout_ gpu_timestamp_correlator&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::gpu_timestamp_correlator::operator bool
+ */
+visus::power_overwhelming::gpu_timestamp_correlator::operator bool(
+        void) const noexcept {
+    return (this->_impl != nullptr);
+}
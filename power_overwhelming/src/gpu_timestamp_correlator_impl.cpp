@@ -0,0 +1,65 @@
+﻿// <copyright file="gpu_timestamp_correlator_impl.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "gpu_timestamp_correlator_impl.h"
+
+#include <cassert>
+
+#include "safe_com.h"
+
+
+/*
+ * ...::detail::gpu_timestamp_correlator_impl::gpu_timestamp_correlator_impl
+ */
+visus::power_overwhelming::detail::gpu_timestamp_correlator_impl
+::gpu_timestamp_correlator_impl(_In_ const gpu_timestamp_type frequency)
+    : frequency(frequency)
+#if (POWER_OVERWHELMING_GPU_ABSTRACTION == 12)
+        , capacity(0), collected(0), heap(nullptr), next(0), queue(nullptr),
+        readback(nullptr), resolved(0)
+#endif /* (POWER_OVERWHELMING_GPU_ABSTRACTION == 12) */
+    {
+    assert(this->frequency > 0);
+}
+
+
+/*
+ * ...::detail::gpu_timestamp_correlator_impl::~gpu_timestamp_correlator_impl
+ */
+visus::power_overwhelming::detail::gpu_timestamp_correlator_impl
+::~gpu_timestamp_correlator_impl(void) {
+#if (POWER_OVERWHELMING_GPU_ABSTRACTION == 12)
+    safe_release(this->heap);
+    safe_release(this->queue);
+    safe_release(this->readback);
+#endif /* (POWER_OVERWHELMING_GPU_ABSTRACTION == 12) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::gpu_timestamp_correlator_impl::update
+ */
+void visus::power_overwhelming::detail::gpu_timestamp_correlator_impl::update(
+        _In_ const timestamp_type request,
+        _In_ const gpu_timestamp_type gpu,
+        _In_ const timestamp_type response) {
+    this->clock.update(request, this->to_file_time(gpu), response);
+}
+
+
+/*
+ * ...::detail::gpu_timestamp_correlator_impl::to_file_time
+ */
+visus::power_overwhelming::timestamp_type
+visus::power_overwhelming::detail::gpu_timestamp_correlator_impl::to_file_time(
+        _In_ const gpu_timestamp_type gpu) const noexcept {
+    // Split the conversion such that GPU clocks running at GHz do not
+    // overflow after a few minutes.
+    constexpr gpu_timestamp_type file_time_frequency = 10000000;
+    const auto seconds = gpu / this->frequency;
+    const auto remainder = gpu % this->frequency;
+    return static_cast<timestamp_type>(seconds * file_time_frequency
+        + remainder * file_time_frequency / this->frequency);
+}
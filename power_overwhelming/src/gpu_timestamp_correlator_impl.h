@@ -0,0 +1,128 @@
+﻿// <copyright file="gpu_timestamp_correlator_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <vector>
+
+#include "power_overwhelming/gpu_timestamp_correlator.h"
+
+#include "instrument_clock.h"
+#include "timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The private state of a <see cref="gpu_timestamp_correlator" />.
+    /// </summary>
+    struct gpu_timestamp_correlator_impl final {
+
+        /// <summary>
+        /// The type of a GPU timestamp in ticks of the GPU clock.
+        /// </summary>
+        typedef gpu_timestamp_correlator::gpu_timestamp_type
+            gpu_timestamp_type;
+
+        /// <summary>
+        /// Fits the GPU clock, which has been converted to units of 100 ns.
+        /// </summary>
+        instrument_clock clock;
+
+        /// <summary>
+        /// The number of ticks of the GPU clock per second.
+        /// </summary>
+        gpu_timestamp_type frequency;
+
+#if (POWER_OVERWHELMING_GPU_ABSTRACTION == 12)
+        /// <summary>
+        /// The number of queries in <see cref="heap" />.
+        /// </summary>
+        std::size_t capacity;
+
+        /// <summary>
+        /// The total number of queries that have been collected.
+        /// </summary>
+        std::uint64_t collected;
+
+        /// <summary>
+        /// The heap holding the timestamp queries, which is used as a ring
+        /// buffer.
+        /// </summary>
+        ID3D12QueryHeap *heap;
+
+        /// <summary>
+        /// The IDs of the markers for each query in <see cref="heap" />.
+        /// </summary>
+        std::vector<std::uint32_t> markers;
+
+        /// <summary>
+        /// The total number of queries that have been recorded.
+        /// </summary>
+        std::uint64_t next;
+
+        /// <summary>
+        /// The command queue whose clock is calibrated.
+        /// </summary>
+        ID3D12CommandQueue *queue;
+
+        /// <summary>
+        /// The buffer the results of the queries are resolved into, which
+        /// has a 64-bit timestamp for each query in <see cref="heap" />.
+        /// </summary>
+        ID3D12Resource *readback;
+
+        /// <summary>
+        /// The total number of queries that have been resolved.
+        /// </summary>
+        std::uint64_t resolved;
+#endif /* (POWER_OVERWHELMING_GPU_ABSTRACTION == 12) */
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="frequency">The number of ticks of the GPU clock per
+        /// second.</param>
+        explicit gpu_timestamp_correlator_impl(
+            _In_ const gpu_timestamp_type frequency);
+
+        gpu_timestamp_correlator_impl(
+            const gpu_timestamp_correlator_impl&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~gpu_timestamp_correlator_impl(void);
+
+        /// <summary>
+        /// Records a GPU time observed between two host times.
+        /// </summary>
+        /// <param name="request">The host time before the GPU time was read
+        /// in units of 100 ns.</param>
+        /// <param name="gpu">The GPU time.</param>
+        /// <param name="response">The host time after the GPU time was read
+        /// in units of 100 ns.</param>
+        void update(_In_ const timestamp_type request,
+            _In_ const gpu_timestamp_type gpu,
+            _In_ const timestamp_type response);
+
+        /// <summary>
+        /// Converts ticks of the GPU clock to units of 100 ns.
+        /// </summary>
+        /// <param name="gpu">The GPU time.</param>
+        /// <returns>The GPU time in units of 100 ns.</returns>
+        timestamp_type to_file_time(
+            _In_ const gpu_timestamp_type gpu) const noexcept;
+
+        gpu_timestamp_correlator_impl& operator =(
+            const gpu_timestamp_correlator_impl&) = delete;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
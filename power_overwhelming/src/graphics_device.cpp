@@ -15,6 +15,36 @@
 #include "safe_com.h"
 
 
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Enumerates the DXGI adapters and optionally creates a device on each
+    /// of them.
+    /// </summary>
+    static std::size_t enumerate_graphics_devices(
+            _Out_writes_opt_(cntDevices) graphics_device *outDevices,
+            _In_ const std::size_t cntDevices,
+            _In_ const bool onlyHardware,
+            _In_ const bool createDevices);
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::graphics_device::adapters
+ */
+std::size_t visus::power_overwhelming::graphics_device::adapters(
+        _Out_writes_opt_(cntDevices) graphics_device *outDevices,
+        _In_ const std::size_t cntDevices,
+        _In_ const bool onlyHardware) {
+    return detail::enumerate_graphics_devices(outDevices, cntDevices,
+        onlyHardware, false);
+}
+
 
 /*
  * visus::power_overwhelming::graphics_device::all
@@ -23,6 +53,19 @@ std::size_t visus::power_overwhelming::graphics_device::all(
         _Out_writes_opt_(cntDevices) graphics_device *outDevices,
         _In_ const std::size_t cntDevices,
         _In_ const bool onlyHardware) {
+    return detail::enumerate_graphics_devices(outDevices, cntDevices,
+        onlyHardware, true);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::enumerate_graphics_devices
+ */
+std::size_t visus::power_overwhelming::detail::enumerate_graphics_devices(
+        _Out_writes_opt_(cntDevices) graphics_device *outDevices,
+        _In_ const std::size_t cntDevices,
+        _In_ const bool onlyHardware,
+        _In_ const bool createDevices) {
 #if (POWER_OVERWHELMING_GPU_ABSTRACTION >= 11)
     Microsoft::WRL::ComPtr<IDXGIFactory1> factory;
     auto hr = S_OK;
@@ -59,8 +102,8 @@ std::size_t visus::power_overwhelming::graphics_device::all(
             }
         }
 
-        if (SUCCEEDED(hr) && (retval < cntDevices)) {
-            Microsoft::WRL::ComPtr<device_type> device;
+        if (SUCCEEDED(hr) && (retval < cntDevices) && createDevices) {
+            Microsoft::WRL::ComPtr<graphics_device::device_type> device;
             D3D_FEATURE_LEVEL featureLevel = D3D_FEATURE_LEVEL_11_0;
 
 #if (POWER_OVERWHELMING_GPU_ABSTRACTION == 11)
@@ -78,8 +121,12 @@ std::size_t visus::power_overwhelming::graphics_device::all(
             }
 #endif /* (POWER_OVERWHELMING_GPU_ABSTRACTION == 11) */
 
-            detail::safe_replace(outDevices[retval]._adapter, adapter.Get());
-            detail::safe_replace(outDevices[retval]._device, device.Get());
+            outDevices[retval] = graphics_device(adapter.Get(), device.Get());
+
+        } else if (SUCCEEDED(hr) && (retval < cntDevices)) {
+            // Only retrieving the adapter is much cheaper than creating a
+            // device, which requires initialising the driver.
+            outDevices[retval] = graphics_device(adapter.Get(), nullptr);
         }
 
         if (SUCCEEDED(hr)) {
@@ -115,6 +162,19 @@ visus::power_overwhelming::graphics_device::graphics_device(
 }
 
 
+/*
+ * visus::power_overwhelming::graphics_device::graphics_device
+ */
+visus::power_overwhelming::graphics_device::graphics_device(
+        _In_opt_ adapter_type *adapter, _In_opt_ device_type *device)
+    : _adapter(adapter), _device(device), _id(nullptr), _name(nullptr) {
+#if (POWER_OVERWHELMING_GPU_ABSTRACTION >= 11)
+    detail::safe_add_ref(this->_adapter);
+    detail::safe_add_ref(this->_device);
+#endif /* (POWER_OVERWHELMING_GPU_ABSTRACTION >= 11) */
+}
+
+
 /*
  * visus::power_overwhelming::graphics_device::graphics_device
  */
@@ -143,6 +203,29 @@ visus::power_overwhelming::graphics_device::~graphics_device(void) {
 }
 
 
+/*
+ * visus::power_overwhelming::graphics_device::luid
+ */
+visus::power_overwhelming::graphics_device::luid_type
+visus::power_overwhelming::graphics_device::luid(void) const {
+#if (POWER_OVERWHELMING_GPU_ABSTRACTION >= 11)
+    if (this->_adapter != nullptr) {
+        DXGI_ADAPTER_DESC desc;
+
+        auto hr = this->_adapter->GetDesc(&desc);
+        if (FAILED(hr)) {
+            throw std::system_error(hr, detail::com_category());
+        }
+
+        return (static_cast<luid_type>(desc.AdapterLuid.HighPart) << 32)
+            | static_cast<luid_type>(desc.AdapterLuid.LowPart);
+    }
+#endif /* (POWER_OVERWHELMING_GPU_ABSTRACTION >= 11) */
+
+    return 0;
+}
+
+
 /*
  * visus::power_overwhelming::graphics_device::operator =
  */
@@ -196,8 +279,7 @@ visus::power_overwhelming::graphics_device::operator =(
  * visus::power_overwhelming::graphics_device::operator bool
  */
 visus::power_overwhelming::graphics_device::operator bool(void) const noexcept {
-    return ((this->_adapter != nullptr)
-        && (this->_device != nullptr));
+    return (this->_adapter != nullptr);
 }
 
 
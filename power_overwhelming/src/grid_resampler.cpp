@@ -0,0 +1,129 @@
+﻿// <copyright file="grid_resampler.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "grid_resampler.h"
+
+#include <stdexcept>
+
+#include "waveform_kernels.h"
+
+
+/*
+ * visus::power_overwhelming::detail::grid_resampler::grid_resampler
+ */
+visus::power_overwhelming::detail::grid_resampler::grid_resampler(void)
+    : _step(0) { }
+
+
+/*
+ * visus::power_overwhelming::detail::grid_resampler::configure
+ */
+void visus::power_overwhelming::detail::grid_resampler::configure(
+        _In_ const measurement::timestamp_type step) {
+    if (step < 0) {
+        throw std::invalid_argument("The step of the resampling grid must not "
+            "be negative.");
+    }
+
+    this->_states.clear();
+    this->_step = step;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::grid_resampler::push
+ */
+void visus::power_overwhelming::detail::grid_resampler::push(
+        _In_ const measurement& sample,
+        _In_ const std::uint32_t marker,
+        _Inout_ std::vector<sample_type>& dst) {
+    if (!this->enabled()) {
+        dst.emplace_back(sample, marker);
+        return;
+    }
+
+    if (!sample) {
+        return;
+    }
+
+    const auto invalid = measurement_data::invalid_value;
+    const auto t1 = sample.timestamp();
+    auto it = this->_states.find(sample.sensor());
+
+    if (it == this->_states.end()) {
+        // The first sample of a sensor can only be used if it is on the grid.
+        this->_states.emplace(sample.sensor(), state_type(sample.data()));
+        if (t1 % this->_step == 0) {
+            dst.emplace_back(sample, marker);
+        }
+        return;
+    }
+
+    auto& state = it->second;
+    const auto& lhs = state.previous;
+    const auto t0 = lhs.timestamp();
+    const auto dt = t1 - t0;
+
+    if (dt <= 0) {
+        // Ignore samples that are out of order.
+        return;
+    }
+
+    if ((state.interval == 0) || (dt <= 8 * state.interval)) {
+        state.interval = dt;
+
+        // Find the grid points in (t0, t1], which requires rounding towards
+        // negative infinity for timestamps before the epoch.
+        auto floor = [this](const measurement::timestamp_type t) {
+            auto q = t / this->_step;
+            if ((t % this->_step != 0) && (t < 0)) {
+                --q;
+            }
+            return q;
+        };
+        const auto first = floor(t0) + 1;
+        const auto cnt = static_cast<std::size_t>(floor(t1) - first + 1);
+
+        if (cnt > 0) {
+            const auto& rhs = sample.data();
+            const auto d = static_cast<float>(dt);
+            const auto offset = static_cast<float>(first * this->_step - t0)
+                / d;
+            const auto step = static_cast<float>(this->_step) / d;
+            const auto electric = (lhs.voltage() != invalid)
+                && (lhs.current() != invalid)
+                && (rhs.voltage() != invalid)
+                && (rhs.current() != invalid);
+
+            this->_power.resize(cnt);
+            interpolate_waveform(this->_power.data(), cnt, lhs.power(),
+                rhs.power(), offset, step);
+
+            if (electric) {
+                this->_current.resize(cnt);
+                this->_voltage.resize(cnt);
+                interpolate_waveform(this->_current.data(), cnt,
+                    lhs.current(), rhs.current(), offset, step);
+                interpolate_waveform(this->_voltage.data(), cnt,
+                    lhs.voltage(), rhs.voltage(), offset, step);
+            }
+
+            for (std::size_t i = 0; i < cnt; ++i) {
+                const auto t = (first + static_cast<measurement
+                    ::timestamp_type>(i)) * this->_step;
+                dst.emplace_back(measurement(sample.sensor(), t,
+                    electric ? this->_voltage[i] : invalid,
+                    electric ? this->_current[i] : invalid,
+                    this->_power[i]), marker);
+            }
+        }
+
+    } else if (t1 % this->_step == 0) {
+        // Restart after the gap as for the first sample.
+        dst.emplace_back(sample, marker);
+    }
+
+    state.previous = sample.data();
+}
@@ -0,0 +1,108 @@
+﻿// <copyright file="grid_resampler.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "power_overwhelming/measurement.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Resamples the samples of all sensors onto a common grid by means of
+    /// linear interpolation.
+    /// </summary>
+    /// <remarks>
+    /// <para>The grid consists of the multiples of its step, which is the same
+    /// for all sensors, such that the resampled samples of different sensors
+    /// share their timestamps. Between two consecutive samples of a sensor,
+    /// a sample is created for each grid point after the first and up to
+    /// and including the second sample. The values are interpolated with the
+    /// vectorised kernel of <see cref="interpolate_waveform" />. Voltage and
+    /// current are only interpolated if both samples provide them.</para>
+    /// <para>Gaps of more than eight times the previous interval of a sensor
+    /// are not bridged, because the sensor has most likely been paused.
+    /// </para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API grid_resampler final {
+
+    public:
+
+        /// <summary>
+        /// A sample along with the ID of the marker active for it.
+        /// </summary>
+        typedef std::pair<measurement, std::uint32_t> sample_type;
+
+        /// <summary>
+        /// Initialises a new instance, which is disabled.
+        /// </summary>
+        grid_resampler(void);
+
+        /// <summary>
+        /// Sets the step of the grid and forgets all samples.
+        /// </summary>
+        /// <param name="step">The distance between two grid points in ticks
+        /// of the timestamps, or zero to disable resampling.</param>
+        /// <exception cref="std::invalid_argument">If <paramref name="step" />
+        /// is negative.</exception>
+        void configure(_In_ const measurement::timestamp_type step);
+
+        /// <summary>
+        /// Answer whether the samples are resampled.
+        /// </summary>
+        /// <returns><c>true</c> if resampling is enabled, <c>false</c>
+        /// otherwise.</returns>
+        inline bool enabled(void) const noexcept {
+            return (this->_step > 0);
+        }
+
+        /// <summary>
+        /// Adds a sample.
+        /// </summary>
+        /// <param name="sample">The sample to be added.</param>
+        /// <param name="marker">The ID of the marker active for the sample,
+        /// which is assigned to all grid points up to the sample.</param>
+        /// <param name="dst">Receives the resampled samples, which are
+        /// appended. If resampling is disabled, this is
+        /// <paramref name="sample" /> itself.</param>
+        void push(_In_ const measurement& sample,
+            _In_ const std::uint32_t marker,
+            _Inout_ std::vector<sample_type>& dst);
+
+        /// <summary>
+        /// Answer the step of the grid.
+        /// </summary>
+        /// <returns>The distance between two grid points in ticks of the
+        /// timestamps, which is zero if resampling is disabled.</returns>
+        inline measurement::timestamp_type step(void) const noexcept {
+            return this->_step;
+        }
+
+    private:
+
+        struct state_type {
+            measurement::timestamp_type interval;
+            measurement_data previous;
+            inline state_type(_In_ const measurement_data& previous)
+                : interval(0), previous(previous) { }
+        };
+
+        std::vector<float> _current;
+        std::vector<float> _power;
+        std::unordered_map<const wchar_t *, state_type> _states;
+        measurement::timestamp_type _step;
+        std::vector<float> _voltage;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,245 @@
+﻿// <copyright file="hmc8015_log.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "hmc8015_log.h"
+
+#include <cassert>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "parse_real.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The indices of the columns we are interested in.
+    /// </summary>
+    struct hmc8015_log_columns final {
+        int current;
+        int power;
+        int time;
+        int voltage;
+    };
+
+    /// <summary>
+    /// Removes spaces and quotes from both ends of [begin, end[.
+    /// </summary>
+    static void trim_field(const char *& begin, const char *& end) noexcept {
+        while ((begin < end) && ((*begin == ' ') || (*begin == '"')
+                || (*begin == '\t'))) {
+            ++begin;
+        }
+        while ((end > begin) && ((end[-1] == ' ') || (end[-1] == '"')
+                || (end[-1] == '\t') || (end[-1] == '\r'))) {
+            --end;
+        }
+    }
+
+    /// <summary>
+    /// Answer whether the header [begin, end[, without its unit, is equal to
+    /// the upper-case <paramref name="name" />.
+    /// </summary>
+    static bool is_column(const char *begin, const char *end,
+            const char *name) noexcept {
+        assert(name != nullptr);
+        for (; (begin < end) && (*begin != '[') && (*begin != '(')
+                && (*begin != ' '); ++begin, ++name) {
+            if ((*name == 0) || (std::toupper(*begin) != *name)) {
+                return false;
+            }
+        }
+
+        return (*name == 0);
+    }
+
+    /// <summary>
+    /// Parses the whole field [begin, end[ as a number of seconds, which might
+    /// be formatted as <c>hh:mm:ss.fff</c>.
+    /// </summary>
+    static bool parse_seconds(const char *begin, const char *end,
+            double& value) noexcept {
+        // If the field contains the date as well, only use the time after it.
+        for (auto c = end; c > begin; --c) {
+            if (c[-1] == ' ') {
+                begin = c;
+                break;
+            }
+        }
+
+        value = 0.0;
+
+        while (true) {
+            double v;
+            if (!parse_real(begin, end, v)) {
+                return false;
+            }
+
+            value += v;
+            if ((begin < end) && (*begin == ':')) {
+                // There is a smaller unit to follow.
+                value *= 60.0;
+                ++begin;
+            } else {
+                return (begin == end);
+            }
+        }
+    }
+
+    /// <summary>
+    /// Parses the whole field [begin, end[ as a value.
+    /// </summary>
+    static measurement::value_type parse_value(const char *begin,
+            const char *end) noexcept {
+        double retval;
+        if (parse_real(begin, end, retval) && (begin == end)) {
+            return static_cast<measurement::value_type>(retval);
+        } else {
+            return std::numeric_limits<measurement::value_type>::quiet_NaN();
+        }
+    }
+
+    /// <summary>
+    /// Invokes <paramref name="action" /> with the index, the begin and the end
+    /// of each trimmed field in the line [begin, end[.
+    /// </summary>
+    template<class TAction>
+    static void for_each_field(const char *begin, const char *end,
+            TAction action) {
+        for (int i = 0; ; ++i) {
+            auto e = begin;
+            while ((e < end) && (*e != ',') && (*e != ';')) {
+                ++e;
+            }
+
+            auto b = begin;
+            auto f = e;
+            trim_field(b, f);
+            action(i, b, f);
+
+            if (e == end) {
+                break;
+            }
+
+            begin = e + 1;
+        }
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::parse_hmc8015_log
+ */
+std::size_t visus::power_overwhelming::detail::parse_hmc8015_log(
+        _In_reads_(cnt) const char *data,
+        _In_ const std::size_t cnt,
+        _In_ const double interval,
+        _In_ const hmc8015_log_callback callback,
+        _In_opt_ void *context) {
+    static constexpr double seconds_per_day = 24.0 * 60.0 * 60.0;
+    assert(callback != nullptr);
+
+    hmc8015_log_columns columns = { -1, -1, -1, -1 };
+    hmc8015_log_entry entry;
+    auto have_header = false;
+    auto first_time = 0.0;
+    auto last_time = 0.0;
+    std::size_t retval = 0;
+    auto wraps = 0.0;
+
+    if (data == nullptr) {
+        return 0;
+    }
+
+    const auto end = data + cnt;
+    for (auto line = data; line < end;) {
+        auto eol = static_cast<const char *>(std::memchr(line, '\n',
+            end - line));
+        if (eol == nullptr) {
+            eol = end;
+        }
+
+        // If we know the columns, the line is data if any of the value
+        // columns holds a number.
+        auto have_time = false;
+        auto is_data = false;
+        auto time = 0.0;
+
+        if (have_header) {
+            const auto nan = std::numeric_limits<
+                measurement::value_type>::quiet_NaN();
+            entry.current = entry.power = entry.voltage = nan;
+
+            for_each_field(line, eol, [&](const int i, const char *b,
+                    const char *e) {
+                if (i == columns.current) {
+                    entry.current = parse_value(b, e);
+                } else if (i == columns.power) {
+                    entry.power = parse_value(b, e);
+                } else if (i == columns.voltage) {
+                    entry.voltage = parse_value(b, e);
+                } else if (i == columns.time) {
+                    have_time = parse_seconds(b, e, time);
+                }
+            });
+
+            is_data = !std::isnan(entry.current) || !std::isnan(entry.power)
+                || !std::isnan(entry.voltage);
+        }
+
+        if (is_data) {
+            if (have_time) {
+                if (retval == 0) {
+                    first_time = last_time = time;
+                }
+                if (time + wraps < last_time) {
+                    // A time of day has passed midnight.
+                    wraps += seconds_per_day;
+                }
+                last_time = time + wraps;
+                entry.offset = last_time - first_time;
+            } else {
+                entry.offset = retval * interval;
+            }
+
+            callback(entry, context);
+            ++retval;
+
+        } else {
+            // Check whether the line is a header that names the columns we are
+            // looking for. Only if so, we replace what we have found before.
+            hmc8015_log_columns candidate = { -1, -1, -1, -1 };
+            for_each_field(line, eol, [&candidate](const int i,
+                    const char *b, const char *e) {
+                if (is_column(b, e, "U") || is_column(b, e, "URMS")) {
+                    candidate.voltage = i;
+                } else if (is_column(b, e, "I") || is_column(b, e, "IRMS")) {
+                    candidate.current = i;
+                } else if (is_column(b, e, "P")) {
+                    candidate.power = i;
+                } else if (is_column(b, e, "TIME")) {
+                    candidate.time = i;
+                }
+            });
+
+            if ((candidate.current >= 0) || (candidate.power >= 0)
+                    || (candidate.voltage >= 0)) {
+                columns = candidate;
+                have_header = true;
+            }
+        }
+
+        line = (eol < end) ? eol + 1 : end;
+    }
+
+    return retval;
+}
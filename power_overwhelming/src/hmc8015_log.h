@@ -0,0 +1,85 @@
+﻿// <copyright file="hmc8015_log.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstddef>
+
+#include "power_overwhelming/measurement.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A single row of the log file written by an HMC8015.
+    /// </summary>
+    struct hmc8015_log_entry final {
+
+        /// <summary>
+        /// The RMS current in Ampere, or NaN if the log does not contain it.
+        /// </summary>
+        measurement::value_type current;
+
+        /// <summary>
+        /// The time in seconds since the first entry in the log.
+        /// </summary>
+        double offset;
+
+        /// <summary>
+        /// The active power in Watts, or NaN if the log does not contain it.
+        /// </summary>
+        measurement::value_type power;
+
+        /// <summary>
+        /// The RMS voltage in Volts, or NaN if the log does not contain it.
+        /// </summary>
+        measurement::value_type voltage;
+    };
+
+
+    /// <summary>
+    /// The callback receiving the entries of an HMC8015 log.
+    /// </summary>
+    typedef void (*hmc8015_log_callback)(const hmc8015_log_entry& entry,
+        void *context);
+
+
+    /// <summary>
+    /// Parses the CSV log file written by an HMC8015 in place.
+    /// </summary>
+    /// <remarks>
+    /// <para>The parser works directly on the downloaded file and does not
+    /// allocate any memory, which matters for long logs recorded at a high
+    /// rate. Fields can be separated by commas or semicolons. Lines that
+    /// neither contain a header nor numeric data, like the metadata at the
+    /// begin of the file, are skipped.</para>
+    /// <para>The columns are identified by their headers, ignoring units and
+    /// case: <c>U</c> or <c>URMS</c> is the voltage, <c>I</c> or <c>IRMS</c>
+    /// is the current and <c>P</c> is the power. If there is a <c>TIME</c>
+    /// column in seconds or in the form <c>hh:mm:ss.fff</c>, the offsets of
+    /// the entries are computed from it. Otherwise, the entries are assumed
+    /// to be <paramref name="interval" /> apart.</para>
+    /// </remarks>
+    /// <param name="data">The content of the log file.</param>
+    /// <param name="cnt">The size of <paramref name="data" /> in bytes.</param>
+    /// <param name="interval">The logging interval in seconds, which is used
+    /// if the log does not contain the time of the entries.</param>
+    /// <param name="callback">The callback to be invoked for each entry.
+    /// </param>
+    /// <param name="context">A user-defined pointer passed to
+    /// <paramref name="callback" />.</param>
+    /// <returns>The number of entries that have been parsed.</returns>
+    std::size_t POWER_OVERWHELMING_API parse_hmc8015_log(
+        _In_reads_(cnt) const char *data,
+        _In_ const std::size_t cnt,
+        _In_ const double interval,
+        _In_ const hmc8015_log_callback callback,
+        _In_opt_ void *context);
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,38 @@
+﻿// <copyright file="hmc8015_sampler.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "hmc8015_sampler.h"
+
+#include <stdexcept>
+
+#include "scpi_response.h"
+
+
+/*
+ * visus::power_overwhelming::detail::parse_hmc8015_data
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::detail::parse_hmc8015_data(
+        _In_ const blob& response, _In_ const timestamp_type timestamp) {
+    auto cur = response.as<char>();
+    const auto end = cur + response.size();
+    double values[3];
+
+    if ((cur == nullptr) || !parse_real_list(cur, end, values, 3)) {
+        throw std::invalid_argument("The response of the instrument does "
+            "not contain three valid numbers.");
+    }
+
+    return measurement_data(timestamp,
+        static_cast<measurement::value_type>(values[0]),
+        static_cast<measurement::value_type>(values[1]),
+        static_cast<measurement::value_type>(values[2]));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::hmc8015_sampler::query
+ */
+constexpr const char *visus::power_overwhelming::detail::hmc8015_sampler::query;
@@ -0,0 +1,82 @@
+﻿// <copyright file="hmc8015_sampler.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "power_overwhelming/blob.h"
+#include "power_overwhelming/measurement.h"
+#include "power_overwhelming/sensor.h"
+#include "power_overwhelming/visa_instrument.h"
+
+#include "scpi_sampler.h"
+#include "timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Parses the response of an HMC8015 to <c>CHAN1:MEAS:DATA?</c>.
+    /// </summary>
+    /// <remarks>
+    /// The instrument must have been configured to report the functions
+    /// <c>URMS, IRMS, P</c> in this order. The values are parsed directly from
+    /// <paramref name="response" /> without copying it.
+    /// </remarks>
+    /// <param name="response">The response of the instrument.</param>
+    /// <param name="timestamp">The timestamp to be assigned to the sample.
+    /// </param>
+    /// <returns>The sample parsed from the response.</returns>
+    /// <exception cref="std::invalid_argument">If the response does not
+    /// contain three numbers.</exception>
+    measurement_data POWER_OVERWHELMING_API parse_hmc8015_data(_In_ const blob& response,
+        _In_ const timestamp_type timestamp);
+
+
+    /// <summary>
+    /// A dedicated sampler thread continuously streaming measurements from a
+    /// single HMC8015 instrument.
+    /// </summary>
+    /// <remarks>
+    /// This is the pipelined <see cref="scpi_sampler" /> configured with the
+    /// query and the parser of the HMC8015.
+    /// </remarks>
+    class hmc8015_sampler final : public scpi_sampler {
+
+    public:
+
+        /// <summary>
+        /// The query used to retrieve the measurements from the instrument.
+        /// </summary>
+        static constexpr const char *query = "CHAN1:MEAS:DATA?\n";
+
+        /// <summary>
+        /// Initialises a new instance and starts sampling.
+        /// </summary>
+        /// <param name="path">The VISA path of the instrument, which must
+        /// already be open.</param>
+        /// <param name="name">The name of the sensor reported to
+        /// <paramref name="callback" />, which must live as long as the
+        /// sampler.</param>
+        /// <param name="callback">The callback receiving the samples.</param>
+        /// <param name="period">The minimum interval between two queries in
+        /// microseconds.</param>
+        /// <param name="context">A user-defined context pointer passed to
+        /// <paramref name="callback" />.</param>
+        /// <exception cref="visa_exception">If the instrument could not be
+        /// opened.</exception>
+        inline hmc8015_sampler(_In_z_ const char *path,
+                _In_z_ const wchar_t *name,
+                _In_ const measurement_data_callback callback,
+                _In_ const sensor::microseconds_type period,
+                _In_opt_ void *context)
+            : scpi_sampler(path, name, query, parse_hmc8015_data, callback,
+                period, context) { }
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
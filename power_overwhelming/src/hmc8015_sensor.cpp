@@ -13,9 +13,13 @@
 
 #include "power_overwhelming/convert_string.h"
 
+#include "hmc8015_sampler.h"
+#include "scpi_response.h"
+#include "sensor_name_registry.h"
+
 #include "string_functions.h"
 #include "timestamp.h"
-#include "tokenise.h"
+#include "visa_discovery.h"
 #include "visa_library.h"
 
 
@@ -26,26 +30,21 @@ std::size_t visus::power_overwhelming::hmc8015_sensor::for_all(
         _Out_writes_opt_(cnt_sensors) hmc8015_sensor *out_sensors,
         _In_ std::size_t cnt_sensors,
         _In_ const std::int32_t timeout) {
-    // Build the query for all R&S HMC8015 instruments.
-    std::string query("?*::");      // Any protocol
-    query += visa_instrument::rohde_und_schwarz;    // Only R&S
-    query += "::";
-    query += product_id;            // Only HMC8015
-    query += "::?*::INSTR";         // All serial numbers.
-
-    // Search the instruments using VISA.
-    auto devices = detail::visa_library::instance().find_resource(
-        query.c_str());
+    // Search all R&S HMC8015 instruments using VISA, including the ones on the
+    // network, which can only be recognised by asking them.
+    auto devices = detail::find_instruments(visa_instrument::rohde_und_schwarz,
+        product_id, [](const std::string& identity) {
+            return (identity.find("HMC8015") != std::string::npos);
+        }, timeout);
 
     // Guard against misuse.
     if (out_sensors == nullptr) {
         cnt_sensors = 0;
     }
 
-    // Create a sensor for each instrument we found.
-    for (std::size_t i = 0; (i < cnt_sensors) && (i < devices.size()); ++i) {
-        out_sensors[i] = hmc8015_sensor(devices[i].c_str(), timeout);
-    }
+    // Create a sensor for each instrument we found. Opening an instrument is
+    // dominated by the round-trip to it, so we open all of them at once.
+    detail::open_instruments(out_sensors, cnt_sensors, devices, timeout);
 
     return devices.size();
 }
@@ -57,7 +56,7 @@ std::size_t visus::power_overwhelming::hmc8015_sensor::for_all(
 visus::power_overwhelming::hmc8015_sensor::hmc8015_sensor(
         _In_z_ const wchar_t *path,
         _In_ const visa_instrument::timeout_type timeout)
-        : _instrument(path, timeout), _name(nullptr) {
+        : _instrument(path, timeout), _name(nullptr), _sampler(nullptr) {
     this->initialise();
     this->configure();
 }
@@ -69,7 +68,7 @@ visus::power_overwhelming::hmc8015_sensor::hmc8015_sensor(
 visus::power_overwhelming::hmc8015_sensor::hmc8015_sensor(
         _In_z_ const char *path,
         _In_ const visa_instrument::timeout_type timeout)
-        : _instrument(path, timeout), _name(nullptr) {
+        : _instrument(path, timeout), _name(nullptr), _sampler(nullptr) {
     this->initialise();
     this->configure();
 }
@@ -80,8 +79,10 @@ visus::power_overwhelming::hmc8015_sensor::hmc8015_sensor(
  */
 visus::power_overwhelming::hmc8015_sensor::hmc8015_sensor(
         _Inout_ hmc8015_sensor&& rhs) noexcept
-    : _instrument(std::move(rhs._instrument)), _name(rhs._name) {
+    : _instrument(std::move(rhs._instrument)), _name(rhs._name),
+        _sampler(rhs._sampler) {
     rhs._name = nullptr;
+    rhs._sampler = nullptr;
 }
 
 
@@ -89,6 +90,9 @@ visus::power_overwhelming::hmc8015_sensor::hmc8015_sensor(
  * visus::power_overwhelming::hmc8015_sensor::~hmc8015_sensor
  */
 visus::power_overwhelming::hmc8015_sensor::~hmc8015_sensor(void) {
+    // Make sure that the sampler thread does not use the instrument anymore.
+    this->sample_batch(nullptr);
+
 #if defined(POWER_OVERWHELMING_WITH_VISA)
     if (this->_instrument) {
         // Reset the system state to local operations, but make sure that we
@@ -139,6 +143,44 @@ visus::power_overwhelming::hmc8015_sensor::display(
 }
 
 
+/*
+ * visus::power_overwhelming::hmc8015_sensor::integrated_energy
+ */
+double visus::power_overwhelming::hmc8015_sensor::integrated_energy(void) {
+    this->check_not_disposed();
+
+    // The energy is not part of the functions we sample, so we switch to it
+    // for a single query and restore the functions set in configure().
+    this->_instrument.write("CHAN1:MEAS:FUNC WH\n");
+    auto response = this->_instrument.query("CHAN1:MEAS:DATA?\n");
+    this->_instrument.write("CHAN1:MEAS:FUNC URMS, IRMS, P\n");
+    this->_instrument.throw_on_system_error();
+
+    // The instrument reports Wh, but we use SI units everywhere.
+    return detail::parse_real_response(response) * 3600.0;
+}
+
+
+/*
+ * visus::power_overwhelming::hmc8015_sensor::integrator
+ */
+visus::power_overwhelming::hmc8015_sensor&
+visus::power_overwhelming::hmc8015_sensor::integrator(_In_ const bool enable) {
+    this->check_not_disposed();
+
+    if (enable) {
+        this->_instrument.write("INT:STAT ON\n");
+        this->_instrument.write("INT:MODE MAN\n");
+    } else {
+        this->_instrument.write("INT:STOP\n");
+        this->_instrument.write("INT:STAT OFF\n");
+    }
+
+    this->_instrument.throw_on_system_error();
+    return *this;
+}
+
+
 /*
  * visus::power_overwhelming::hmc8015_sensor::is_log
  */
@@ -181,6 +223,24 @@ visus::power_overwhelming::hmc8015_sensor::log(_In_ const bool enable) {
 }
 
 
+/*
+ * visus::power_overwhelming::hmc8015_sensor::log_data
+ */
+visus::power_overwhelming::blob
+visus::power_overwhelming::hmc8015_sensor::log_data(_In_z_ const char *path,
+        _In_ const bool use_usb) {
+    if (path == nullptr) {
+        throw std::invalid_argument("The path to the log file cannot be null.");
+    }
+
+    auto location = use_usb ? "EXT" : "INT";
+    auto cmd = detail::format_string("DATA:DATA? \"%s\", %s\n", path,
+        location);
+    this->_instrument.write(cmd);
+    return this->_instrument.read_binary();
+}
+
+
 /*
  * visus::power_overwhelming::hmc8015_sensor::log_behaviour
  */
@@ -296,6 +356,15 @@ visus::power_overwhelming::hmc8015_sensor::log_behaviour(
 }
 
 
+/*
+ * visus::power_overwhelming::hmc8015_sensor::log_interval
+ */
+float visus::power_overwhelming::hmc8015_sensor::log_interval(void) {
+    auto response = this->_instrument.query("LOG:INT?\n");
+    return static_cast<float>(detail::parse_real_response(response));
+}
+
+
 /*
  * visus::power_overwhelming::hmc8015_sensor::log_file
  */
@@ -393,6 +462,18 @@ visus::power_overwhelming::hmc8015_sensor::reset(void) {
 }
 
 
+/*
+ * visus::power_overwhelming::hmc8015_sensor::reset_integrator
+ */
+visus::power_overwhelming::hmc8015_sensor&
+visus::power_overwhelming::hmc8015_sensor::reset_integrator(void) {
+    this->check_not_disposed();
+    this->_instrument.write("INT:RES\n");
+    this->_instrument.throw_on_system_error();
+    return *this;
+}
+
+
 /*
  * visus::power_overwhelming::hmc8015_sensor::operator =
  */
@@ -404,6 +485,9 @@ visus::power_overwhelming::hmc8015_sensor::operator =(
         assert(rhs._instrument == false);
         this->_name = rhs._name;
         rhs._name = nullptr;
+        delete this->_sampler;
+        this->_sampler = rhs._sampler;
+        rhs._sampler = nullptr;
     }
 
     return *this;
@@ -418,22 +502,72 @@ visus::power_overwhelming::hmc8015_sensor::operator bool(void) const noexcept {
 }
 
 
+/*
+ * visus::power_overwhelming::hmc8015_sensor::sample_batch
+ */
+void visus::power_overwhelming::hmc8015_sensor::sample_batch(
+        _In_opt_ const measurement_data_callback on_batch,
+        _In_ const microseconds_type period,
+        _In_opt_ void *context) {
+    if (on_batch != nullptr) {
+        this->check_not_disposed();
+
+        if (this->_sampler != nullptr) {
+            throw std::logic_error("Asynchronous sampling cannot be started "
+                "while it is already running.");
+        }
+
+        // Note: the name must be interned, because it must survive the sensor
+        // being moved or destroyed while the sampler delivers a sample.
+        auto name = this->name();
+        this->_sampler = new detail::hmc8015_sampler(this->path(),
+            detail::sensor_name_registry::intern((name != nullptr)
+                ? name : L""),
+            on_batch, period, context);
+
+    } else {
+        // Note: We do not check for the sensor being disposed here, because
+        // the destructor uses this to stop sampling.
+        delete this->_sampler;
+        this->_sampler = nullptr;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::hmc8015_sensor::start_integrator
+ */
+visus::power_overwhelming::hmc8015_sensor&
+visus::power_overwhelming::hmc8015_sensor::start_integrator(void) {
+    this->check_not_disposed();
+    this->_instrument.write("INT:STAR\n");
+    this->_instrument.throw_on_system_error();
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::hmc8015_sensor::stop_integrator
+ */
+visus::power_overwhelming::hmc8015_sensor&
+visus::power_overwhelming::hmc8015_sensor::stop_integrator(void) {
+    this->check_not_disposed();
+    this->_instrument.write("INT:STOP\n");
+    this->_instrument.throw_on_system_error();
+    return *this;
+}
+
+
 /*
  * visus::power_overwhelming::hmc8015_sensor::sample_sync
  */
 visus::power_overwhelming::measurement_data
 visus::power_overwhelming::hmc8015_sensor::sample_sync(
         _In_ const timestamp_resolution resolution) const {
-    auto response = this->_instrument.query("CHAN1:MEAS:DATA?\n");
-    auto timestamp = detail::create_timestamp(resolution);
-    auto tokens = detail::tokenise(std::string(response.begin(),
-        response.end()), ',', true);
-
-    auto v = static_cast<measurement::value_type>(::atof(tokens[0].c_str()));
-    auto c = static_cast<measurement::value_type>(::atof(tokens[1].c_str()));
-    auto p = static_cast<measurement::value_type>(::atof(tokens[2].c_str()));
-
-    return measurement_data(timestamp, v, c, p);
+    measurement_data::timestamp_type timestamp;
+    auto response = this->_instrument.timestamped_query(
+        detail::hmc8015_sampler::query, timestamp, resolution);
+    return detail::parse_hmc8015_data(response, timestamp);
 }
 
 
@@ -458,9 +592,11 @@ void visus::power_overwhelming::hmc8015_sensor::configure(void) {
     this->_instrument.write("VIEW:NUM:PAGE1:CELL9:FUNC WH\n");
     this->_instrument.write("VIEW:NUM:PAGE1:CELL10:FUNC AH\n");
 
-    // Configure the stuff we want to measure.
+    // Configure the stuff we want to measure. We only request what we report
+    // in a sample in this order, because the instrument needs to format and
+    // transfer every function in the list.
     // Default: URMS,IRMS,P,FPLL,URAN,IRAN,S,Q,LAMB,PHI
-    this->_instrument.write("CHAN1:MEAS:FUNC URMS, URAN, IRMS, IRAN, S, P\n");
+    this->_instrument.write("CHAN1:MEAS:FUNC URMS, IRMS, P\n");
 
     this->_instrument.write("CHAN1:ACQ:MODE AUTO\n");
 }
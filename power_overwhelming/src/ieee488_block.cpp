@@ -0,0 +1,60 @@
+﻿// <copyright file="ieee488_block.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "ieee488_block.h"
+
+
+/*
+ * visus::power_overwhelming::detail::ieee488_block_size
+ */
+std::size_t visus::power_overwhelming::detail::ieee488_block_size(
+        _In_reads_opt_(cnt) const char *data,
+        _In_ const std::size_t cnt) noexcept {
+    // Beyond that many digits, the size would overflow.
+    static constexpr std::size_t max_digits = 18;
+
+    if ((data == nullptr) || (cnt < 2) || (data[0] != '#')) {
+        return 0;
+    }
+
+    std::size_t length = 0;
+    std::size_t header = 0;
+
+    if (data[1] == '(') {
+        std::size_t i = 2;
+        for (; (i < cnt) && (data[i] >= '0') && (data[i] <= '9'); ++i) {
+            if (i - 2 >= max_digits) {
+                return 0;
+            }
+            length = 10 * length + (data[i] - '0');
+        }
+
+        if ((i == 2) || (i >= cnt) || (data[i] != ')')) {
+            return 0;
+        }
+
+        header = i + 1;
+
+    } else {
+        if ((data[1] < '1') || (data[1] > '9')) {
+            return 0;
+        }
+
+        const std::size_t digits = data[1] - '0';
+        header = 2 + digits;
+        if (cnt < header) {
+            return 0;
+        }
+
+        for (std::size_t i = 2; i < header; ++i) {
+            if ((data[i] < '0') || (data[i] > '9')) {
+                return 0;
+            }
+            length = 10 * length + (data[i] - '0');
+        }
+    }
+
+    return header + length + 1;
+}
@@ -0,0 +1,37 @@
+﻿// <copyright file="ieee488_block.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstddef>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Computes the size of a whole response from the header of an IEEE 488.2
+    /// definite-length block at its begin.
+    /// </summary>
+    /// <remarks>
+    /// Both, the normal form <c>#&lt;digits&gt;&lt;length&gt;</c> and the
+    /// variable-length form <c>#(&lt;length&gt;)</c> of the header are
+    /// recognised.
+    /// </remarks>
+    /// <param name="data">The begin of the response received so far.</param>
+    /// <param name="cnt">The number of bytes received so far.</param>
+    /// <returns>The number of bytes for the header, the payload and a
+    /// terminating line break, or zero if <paramref name="data" /> does not
+    /// start with a complete header.</returns>
+    std::size_t POWER_OVERWHELMING_API ieee488_block_size(
+        _In_reads_opt_(cnt) const char *data,
+        _In_ const std::size_t cnt) noexcept;
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
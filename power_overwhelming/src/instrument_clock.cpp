@@ -0,0 +1,240 @@
+﻿// <copyright file="instrument_clock.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "instrument_clock.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+
+/*
+ * visus::power_overwhelming::detail::instrument_clock::default_window
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::instrument_clock::default_window;
+
+
+/*
+ * visus::power_overwhelming::detail::instrument_clock::instrument_clock
+ */
+visus::power_overwhelming::detail::instrument_clock::instrument_clock(
+        _In_ const std::size_t window)
+    : _base(0), _drift(0.0), _latency(0), _next(0), _offset(0.0),
+        _synchronised(false),
+        _window((std::max)(window, static_cast<std::size_t>(1))) {
+    this->_observations.reserve(this->_window);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::instrument_clock::answered
+ */
+visus::power_overwhelming::timestamp_type
+visus::power_overwhelming::detail::instrument_clock::answered(
+        _In_ const timestamp_type request,
+        _In_ const timestamp_type response) const {
+    const auto half = (response - request) / 2;
+    auto latency = this->latency();
+
+    if ((latency <= 0) || (latency > half)) {
+        latency = half;
+    }
+
+    return response - latency;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::instrument_clock::drift
+ */
+double visus::power_overwhelming::detail::instrument_clock::drift(
+        void) const {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    return this->_drift;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::instrument_clock::latency
+ */
+visus::power_overwhelming::timestamp_type
+visus::power_overwhelming::detail::instrument_clock::latency(void) const {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    return this->_latency;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::instrument_clock::synchronised
+ */
+bool visus::power_overwhelming::detail::instrument_clock::synchronised(
+        void) const {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    return this->_synchronised;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::instrument_clock::to_host
+ */
+visus::power_overwhelming::timestamp_type
+visus::power_overwhelming::detail::instrument_clock::to_host(
+        _In_ const timestamp_type instrument) const {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    if (!this->_synchronised) {
+        return instrument;
+    }
+
+    const auto x = static_cast<double>(instrument - this->_base);
+    const auto offset = this->_offset + this->_drift * x;
+    return instrument + static_cast<timestamp_type>(std::llround(offset));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::instrument_clock::to_host
+ */
+void visus::power_overwhelming::detail::instrument_clock::to_host(
+        _Inout_updates_(cnt) timestamp_type *timestamps,
+        _In_ const std::size_t cnt) const {
+    assert((timestamps != nullptr) || (cnt == 0));
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    if (!this->_synchronised) {
+        return;
+    }
+
+    for (std::size_t i = 0; i < cnt; ++i) {
+        const auto x = static_cast<double>(timestamps[i] - this->_base);
+        const auto offset = this->_offset + this->_drift * x;
+        timestamps[i] += static_cast<timestamp_type>(std::llround(offset));
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::instrument_clock::update
+ */
+void visus::power_overwhelming::detail::instrument_clock::update(
+        _In_ const timestamp_type request,
+        _In_ const timestamp_type response) {
+    observation o;
+    o.request = request;
+    o.response = response;
+    o.instrument = 0;
+    o.has_instrument = false;
+    this->add(o);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::instrument_clock::update
+ */
+void visus::power_overwhelming::detail::instrument_clock::update(
+        _In_ const timestamp_type request,
+        _In_ const timestamp_type instrument,
+        _In_ const timestamp_type response) {
+    observation o;
+    o.request = request;
+    o.response = response;
+    o.instrument = instrument;
+    o.has_instrument = true;
+    this->add(o);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::instrument_clock::add
+ */
+void visus::power_overwhelming::detail::instrument_clock::add(
+        _In_ const observation& observation) {
+    if (observation.response < observation.request) {
+        // The host clock has been adjusted while the query was in flight, so
+        // the observation is meaningless.
+        return;
+    }
+
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+
+    if (this->_observations.size() < this->_window) {
+        this->_observations.push_back(observation);
+    } else {
+        this->_observations[this->_next] = observation;
+    }
+    this->_next = (this->_next + 1) % this->_window;
+
+    auto rtt = (std::numeric_limits<timestamp_type>::max)();
+    for (auto& o : this->_observations) {
+        rtt = (std::min)(rtt, o.response - o.request);
+    }
+    this->_latency = rtt / 2;
+
+    if (observation.has_instrument) {
+        this->fit();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::instrument_clock::fit
+ */
+void visus::power_overwhelming::detail::instrument_clock::fit(void) {
+    // Only round trips that are not much longer than the shortest one are
+    // used, because the midpoint of a long round trip is most likely skewed
+    // by queueing delay in one direction.
+    auto rtt = (std::numeric_limits<timestamp_type>::max)();
+    for (auto& o : this->_observations) {
+        if (o.has_instrument) {
+            rtt = (std::min)(rtt, o.response - o.request);
+        }
+    }
+
+    const auto limit = 2 * rtt + 1;
+    std::vector<std::pair<double, double>> points;
+    points.reserve(this->_observations.size());
+
+    for (auto& o : this->_observations) {
+        if (!o.has_instrument || (o.response - o.request > limit)) {
+            continue;
+        }
+
+        if (points.empty()) {
+            this->_base = o.instrument;
+        }
+
+        // Compute everything relative to the base to retain precision for
+        // large time stamps.
+        const auto midpoint = o.request + (o.response - o.request) / 2;
+        points.emplace_back(static_cast<double>(o.instrument - this->_base),
+            static_cast<double>(midpoint - o.instrument));
+    }
+
+    if (points.empty()) {
+        return;
+    }
+
+    const auto n = static_cast<double>(points.size());
+    auto mx = 0.0;
+    auto my = 0.0;
+    for (auto& p : points) {
+        mx += p.first;
+        my += p.second;
+    }
+    mx /= n;
+    my /= n;
+
+    auto sxx = 0.0;
+    auto sxy = 0.0;
+    for (auto& p : points) {
+        sxx += (p.first - mx) * (p.first - mx);
+        sxy += (p.first - mx) * (p.second - my);
+    }
+
+    this->_drift = (sxx > 0.0) ? sxy / sxx : 0.0;
+    this->_offset = my - this->_drift * mx;
+    this->_synchronised = true;
+}
@@ -0,0 +1,185 @@
+﻿// <copyright file="instrument_clock.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include "timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Models the relation between the clock of the host and the point in
+    /// time at which an instrument answered a query.
+    /// </summary>
+    /// <remarks>
+    /// <para>Stamping a reading with the host time after the response has been
+    /// received includes the whole round trip to the instrument. The clock
+    /// therefore keeps the round trips of the most recent queries and uses the
+    /// shortest one, which contains the least queueing delay, as estimate for
+    /// the latency of the connection. The instrument is assumed to have sent
+    /// its response half of this round trip before it has been received.</para>
+    /// <para>If the instrument reports its own time along with the
+    /// responses, its offset and drift are estimated using Cristian's
+    /// algorithm: the midpoint of each round trip is paired with the
+    /// instrument time, and a line is fitted through the pairs whose round
+    /// trips are close to the shortest one. The
+    /// <see cref="time_synchroniser" /> uses the same model for the clocks of
+    /// its peers.</para>
+    /// <para>All time stamps passed to and returned by the clock are in units
+    /// of 100 ns, ie <see cref="timestamp_resolution::hundred_nanoseconds" />,
+    /// which can be converted to all other resolutions using
+    /// <see cref="convert" />. The clock is thread-safe, because it is shared
+    /// by all users of a VISA session.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API instrument_clock final {
+
+    public:
+
+        /// <summary>
+        /// The default number of observations kept by the clock.
+        /// </summary>
+        static constexpr std::size_t default_window = 32;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="window">The number of most recent observations the
+        /// estimates are computed from. A value of zero is treated as one.
+        /// </param>
+        explicit instrument_clock(
+            _In_ const std::size_t window = default_window);
+
+        /// <summary>
+        /// Estimates the host time at which the instrument sent the response to
+        /// a query.
+        /// </summary>
+        /// <param name="request">The host time before the query was sent.
+        /// </param>
+        /// <param name="response">The host time after the response was
+        /// received.</param>
+        /// <returns>The estimated host time at which the response was sent,
+        /// which is never before the midpoint of the round trip.</returns>
+        timestamp_type answered(_In_ const timestamp_type request,
+            _In_ const timestamp_type response) const;
+
+        /// <summary>
+        /// Answer the estimated drift of the instrument clock.
+        /// </summary>
+        /// <returns>The number of host ticks that pass during one tick of the
+        /// instrument minus one, or zero if the drift is unknown.</returns>
+        double drift(void) const;
+
+        /// <summary>
+        /// Answer the estimated one-way latency of the connection to the
+        /// instrument.
+        /// </summary>
+        /// <returns>Half of the shortest round trip observed recently, or zero
+        /// if no round trip has been observed yet.</returns>
+        timestamp_type latency(void) const;
+
+        /// <summary>
+        /// Answer whether the offset and drift of the instrument clock are
+        /// known, ie whether <see cref="to_host" /> is able to convert
+        /// instrument time.
+        /// </summary>
+        /// <returns><c>true</c> if the instrument time can be converted,
+        /// <c>false</c> otherwise.</returns>
+        bool synchronised(void) const;
+
+        /// <summary>
+        /// Converts a time stamp of the instrument clock to host time.
+        /// </summary>
+        /// <param name="instrument">The instrument time to be converted.
+        /// </param>
+        /// <returns>The corresponding host time, or
+        /// <paramref name="instrument" /> if the clock is not
+        /// <see cref="synchronised" />.</returns>
+        timestamp_type to_host(_In_ const timestamp_type instrument) const;
+
+        /// <summary>
+        /// Converts time stamps of the instrument clock to host time in place.
+        /// </summary>
+        /// <remarks>
+        /// The time stamps are not modified if the clock is not
+        /// <see cref="synchronised" />. All of them are converted using the
+        /// same estimate even if the clock is updated concurrently.
+        /// </remarks>
+        /// <param name="timestamps">The time stamps to be converted.</param>
+        /// <param name="cnt">The number of elements in
+        /// <paramref name="timestamps" />.</param>
+        void to_host(_Inout_updates_(cnt) timestamp_type *timestamps,
+            _In_ const std::size_t cnt) const;
+
+        /// <summary>
+        /// Records the round trip of a query.
+        /// </summary>
+        /// <param name="request">The host time before the query was sent.
+        /// </param>
+        /// <param name="response">The host time after the response was
+        /// received.</param>
+        void update(_In_ const timestamp_type request,
+            _In_ const timestamp_type response);
+
+        /// <summary>
+        /// Records the round trip of a query that the instrument answered
+        /// with its own time.
+        /// </summary>
+        /// <param name="request">The host time before the query was sent.
+        /// </param>
+        /// <param name="instrument">The instrument time reported in the
+        /// response.</param>
+        /// <param name="response">The host time after the response was
+        /// received.</param>
+        void update(_In_ const timestamp_type request,
+            _In_ const timestamp_type instrument,
+            _In_ const timestamp_type response);
+
+    private:
+
+        /// <summary>
+        /// A single observed round trip.
+        /// </summary>
+        struct observation final {
+            timestamp_type request;
+            timestamp_type response;
+            timestamp_type instrument;
+            bool has_instrument;
+        };
+
+        /// <summary>
+        /// Adds the observation and updates the estimates.
+        /// </summary>
+        void add(_In_ const observation& observation);
+
+        /// <summary>
+        /// Fits offset and drift through the observations with instrument
+        /// time.
+        /// </summary>
+        /// <remarks>
+        /// The caller must hold <see cref="_lock" />.
+        /// </remarks>
+        void fit(void);
+
+        timestamp_type _base;
+        double _drift;
+        timestamp_type _latency;
+        mutable std::mutex _lock;
+        std::size_t _next;
+        std::vector<observation> _observations;
+        double _offset;
+        bool _synchronised;
+        std::size_t _window;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
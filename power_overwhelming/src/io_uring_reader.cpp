@@ -0,0 +1,238 @@
+﻿// <copyright file="io_uring_reader.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "io_uring_reader.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#if !defined(_WIN32)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif /* !defined(_WIN32) */
+
+
+/*
+ * visus::power_overwhelming::detail::io_uring_reader::io_uring_reader
+ */
+visus::power_overwhelming::detail::io_uring_reader::io_uring_reader(
+        _In_ const unsigned int entries)
+    : _cq_head(nullptr), _cq_mask(0), _cq_tail(nullptr), _cqes(nullptr),
+        _cq_ring(nullptr), _cq_size(0), _ring(-1), _sq_array(nullptr),
+        _sq_entries(0), _sq_mask(0), _sq_tail(nullptr), _sq_ring(nullptr),
+        _sq_size(0), _sqes(nullptr) {
+#if defined(_WIN32)
+    throw std::system_error(ENOTSUP, std::system_category());
+
+#else /* defined(_WIN32) */
+    ::io_uring_params params;
+    ::memset(&params, 0, sizeof(params));
+
+    this->_ring = static_cast<int>(::syscall(__NR_io_uring_setup,
+        (std::max)(entries, 1u), &params));
+    if (this->_ring < 0) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    this->_sq_entries = params.sq_entries;
+    this->_sq_size = params.sq_off.array
+        + params.sq_entries * sizeof(unsigned int);
+    this->_cq_size = params.cq_off.cqes
+        + params.cq_entries * sizeof(::io_uring_cqe);
+
+    // Newer kernels map both rings at once, in which case the mapping must
+    // be large enough for both of them.
+    const auto single = ((params.features & IORING_FEAT_SINGLE_MMAP) != 0);
+    if (single) {
+        this->_sq_size = this->_cq_size = (std::max)(this->_sq_size,
+            this->_cq_size);
+    }
+
+    auto error = [this](void) {
+        const auto retval = errno;
+        this->close();
+        return std::system_error(retval, std::system_category());
+    };
+
+    this->_sq_ring = ::mmap(nullptr, this->_sq_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, this->_ring, IORING_OFF_SQ_RING);
+    if (this->_sq_ring == MAP_FAILED) {
+        this->_sq_ring = nullptr;
+        throw error();
+    }
+
+    if (single) {
+        this->_cq_ring = this->_sq_ring;
+    } else {
+        this->_cq_ring = ::mmap(nullptr, this->_cq_size,
+            PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->_ring,
+            IORING_OFF_CQ_RING);
+        if (this->_cq_ring == MAP_FAILED) {
+            this->_cq_ring = nullptr;
+            throw error();
+        }
+    }
+
+    this->_sqes = ::mmap(nullptr, params.sq_entries * sizeof(::io_uring_sqe),
+        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this->_ring,
+        IORING_OFF_SQES);
+    if (this->_sqes == MAP_FAILED) {
+        this->_sqes = nullptr;
+        throw error();
+    }
+
+    auto sq = static_cast<char *>(this->_sq_ring);
+    auto cq = static_cast<char *>(this->_cq_ring);
+    this->_sq_array = reinterpret_cast<unsigned int *>(sq
+        + params.sq_off.array);
+    this->_sq_mask = *reinterpret_cast<unsigned int *>(sq
+        + params.sq_off.ring_mask);
+    this->_sq_tail = reinterpret_cast<unsigned int *>(sq
+        + params.sq_off.tail);
+    this->_cq_head = reinterpret_cast<unsigned int *>(cq
+        + params.cq_off.head);
+    this->_cq_mask = *reinterpret_cast<unsigned int *>(cq
+        + params.cq_off.ring_mask);
+    this->_cq_tail = reinterpret_cast<unsigned int *>(cq
+        + params.cq_off.tail);
+    this->_cqes = cq + params.cq_off.cqes;
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::io_uring_reader::~io_uring_reader
+ */
+visus::power_overwhelming::detail::io_uring_reader::~io_uring_reader(
+        void) noexcept {
+    this->close();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::io_uring_reader::read
+ */
+void visus::power_overwhelming::detail::io_uring_reader::read(
+        _Out_writes_(cnt) std::int32_t *results,
+        _Out_writes_bytes_(cnt * size) char *buffers,
+        _In_ const std::size_t size,
+        _In_reads_(cnt) const int *files,
+        _In_ const std::size_t cnt) {
+    assert((results != nullptr) || (cnt == 0));
+    assert((buffers != nullptr) || (cnt == 0));
+    assert((files != nullptr) || (cnt == 0));
+#if defined(_WIN32)
+    throw std::system_error(ENOTSUP, std::system_category());
+
+#else /* defined(_WIN32) */
+    for (std::size_t offset = 0; offset < cnt;) {
+        const auto n = (std::min)(cnt - offset,
+            static_cast<std::size_t>(this->_sq_entries));
+
+        // We are the only producer, so the tail can be read without any
+        // synchronisation, but the kernel must see the entries before the
+        // new tail.
+        const auto tail = *this->_sq_tail;
+        auto sqes = static_cast<::io_uring_sqe *>(this->_sqes);
+        for (std::size_t i = 0; i < n; ++i) {
+            const auto index = (tail + static_cast<unsigned int>(i))
+                & this->_sq_mask;
+            auto& sqe = sqes[index];
+            ::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = IORING_OP_READ;
+            sqe.fd = files[offset + i];
+            sqe.addr = reinterpret_cast<std::uint64_t>(buffers
+                + (offset + i) * size);
+            sqe.len = static_cast<std::uint32_t>(size);
+            sqe.off = 0;
+            sqe.user_data = offset + i;
+            this->_sq_array[index] = index;
+        }
+        __atomic_store_n(this->_sq_tail, tail + static_cast<unsigned int>(n),
+            __ATOMIC_RELEASE);
+
+        // Submit everything and wait for all completions in the same call.
+        // If the call is interrupted, we need to wait for the rest of the
+        // completions, which have already been submitted.
+        auto submit = static_cast<unsigned int>(n);
+        std::size_t completed = 0;
+        while (completed < n) {
+            const auto wait = static_cast<unsigned int>(n - completed);
+            const auto status = ::syscall(__NR_io_uring_enter, this->_ring,
+                submit, wait, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (status < 0) {
+                if (errno != EINTR) {
+                    throw std::system_error(errno, std::system_category());
+                }
+            } else {
+                submit -= (std::min)(submit,
+                    static_cast<unsigned int>(status));
+            }
+
+            completed += this->reap(results);
+        }
+
+        offset += n;
+    }
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::io_uring_reader::reap
+ */
+std::size_t visus::power_overwhelming::detail::io_uring_reader::reap(
+        _Out_ std::int32_t *results) noexcept {
+    std::size_t retval = 0;
+
+#if !defined(_WIN32)
+    auto cqes = static_cast<::io_uring_cqe *>(this->_cqes);
+    auto head = *this->_cq_head;
+    const auto tail = __atomic_load_n(this->_cq_tail, __ATOMIC_ACQUIRE);
+
+    for (; head != tail; ++head, ++retval) {
+        auto& cqe = cqes[head & this->_cq_mask];
+        results[cqe.user_data] = cqe.res;
+    }
+
+    __atomic_store_n(this->_cq_head, head, __ATOMIC_RELEASE);
+#endif /* !defined(_WIN32) */
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::io_uring_reader::close
+ */
+void visus::power_overwhelming::detail::io_uring_reader::close(
+        void) noexcept {
+#if !defined(_WIN32)
+    if (this->_sqes != nullptr) {
+        ::munmap(this->_sqes, this->_sq_entries * sizeof(::io_uring_sqe));
+        this->_sqes = nullptr;
+    }
+
+    if ((this->_cq_ring != nullptr) && (this->_cq_ring != this->_sq_ring)) {
+        ::munmap(this->_cq_ring, this->_cq_size);
+    }
+    this->_cq_ring = nullptr;
+
+    if (this->_sq_ring != nullptr) {
+        ::munmap(this->_sq_ring, this->_sq_size);
+        this->_sq_ring = nullptr;
+    }
+
+    if (this->_ring >= 0) {
+        ::close(this->_ring);
+        this->_ring = -1;
+    }
+#endif /* !defined(_WIN32) */
+}
@@ -0,0 +1,120 @@
+﻿// <copyright file="io_uring_reader.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Reads the beginning of many files with a single system call using an
+    /// io_uring submission queue on Linux.
+    /// </summary>
+    /// <remarks>
+    /// <para>The reader is intended for polling small attribute files like
+    /// the ones in sysfs, which are always read from offset zero. It does not
+    /// depend on liburing, but sets up the ring using the raw system calls,
+    /// because we only need plain reads.</para>
+    /// <para>On Windows, and on kernels without io_uring or whose io_uring
+    /// has been disabled, the constructor fails and callers are expected to
+    /// fall back to <c>pread</c>.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API io_uring_reader final {
+
+    public:
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="entries">The requested size of the submission queue,
+        /// which limits the number of reads that are submitted at once.
+        /// </param>
+        /// <exception cref="std::system_error">If the ring could not be
+        /// created, most likely because io_uring is not supported.
+        /// </exception>
+        explicit io_uring_reader(_In_ const unsigned int entries = 64);
+
+        io_uring_reader(const io_uring_reader&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~io_uring_reader(void) noexcept;
+
+        /// <summary>
+        /// Answer the number of reads that can be submitted at once.
+        /// </summary>
+        /// <returns>The size of the submission queue.</returns>
+        inline unsigned int entries(void) const noexcept {
+            return this->_sq_entries;
+        }
+
+        /// <summary>
+        /// Reads up to <paramref name="size" /> bytes from the beginning of
+        /// each of the given files.
+        /// </summary>
+        /// <remarks>
+        /// If there are more files than <see cref="entries" />, they are
+        /// submitted in multiple batches.
+        /// </remarks>
+        /// <param name="results">Receives for each file the number of bytes
+        /// read or the negated <c>errno</c> of the read.</param>
+        /// <param name="buffers">The output buffers, which must hold
+        /// <paramref name="cnt" /> times <paramref name="size" /> bytes.
+        /// </param>
+        /// <param name="size">The size of the buffer for a single file.
+        /// </param>
+        /// <param name="files">The descriptors of the files to be read.
+        /// </param>
+        /// <param name="cnt">The number of files in
+        /// <paramref name="files" />.</param>
+        /// <exception cref="std::system_error">If the reads could not be
+        /// submitted.</exception>
+        void read(_Out_writes_(cnt) std::int32_t *results,
+            _Out_writes_bytes_(cnt * size) char *buffers,
+            _In_ const std::size_t size,
+            _In_reads_(cnt) const int *files,
+            _In_ const std::size_t cnt);
+
+        io_uring_reader& operator =(const io_uring_reader&) = delete;
+
+    private:
+
+        /// <summary>
+        /// Unmaps the rings and closes the io_uring.
+        /// </summary>
+        void close(void) noexcept;
+
+        /// <summary>
+        /// Fetches all available completions and answers their number.
+        /// </summary>
+        std::size_t reap(_Out_ std::int32_t *results) noexcept;
+
+        unsigned int *_cq_head;
+        unsigned int _cq_mask;
+        unsigned int *_cq_tail;
+        void *_cqes;
+        void *_cq_ring;
+        std::size_t _cq_size;
+        int _ring;
+        unsigned int *_sq_array;
+        unsigned int _sq_entries;
+        unsigned int _sq_mask;
+        unsigned int *_sq_tail;
+        void *_sq_ring;
+        std::size_t _sq_size;
+        void *_sqes;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
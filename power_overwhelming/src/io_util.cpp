@@ -211,6 +211,71 @@ void visus::power_overwhelming::detail::read_bytes(_In_ const int fd,
 }
 
 
+#if defined(_WIN32)
+/*
+ * visus::power_overwhelming::detail::read_bytes_at
+ */
+void visus::power_overwhelming::detail::read_bytes_at(
+        _In_ const HANDLE handle,
+        _Out_writes_bytes_(cnt) void *dst,
+        _In_ const std::size_t cnt,
+        _In_ const std::streamoff offset) {
+    auto d = static_cast<std::uint8_t *>(dst);
+    auto o = offset;
+    auto rem = static_cast<int>(cnt);
+
+    while (rem > 0) {
+        DWORD c = 0;
+        OVERLAPPED overlapped { 0 };
+        overlapped.Offset = static_cast<DWORD>(o & 0xFFFFFFFF);
+        overlapped.OffsetHigh = static_cast<DWORD>(o >> 32);
+
+        if (!::ReadFile(handle, d, rem, &c, &overlapped)) {
+            THROW_LAST_ERROR();
+        }
+
+        d += c;
+        o += c;
+        rem -= c;
+
+        if ((c == 0) && (rem > 0)) {
+            // Reached the end of the file, but could not read requested data.
+            throw std::system_error(ERROR_NO_MORE_ITEMS, std::system_category());
+        }
+    }
+}
+
+#else /* defined(_WIN32) */
+
+/*
+ * visus::power_overwhelming::detail::read_bytes_at
+ */
+void visus::power_overwhelming::detail::read_bytes_at(_In_ const int fd,
+        _Out_writes_bytes_(cnt) void *dst,
+        _In_ const std::size_t cnt,
+        _In_ const std::streamoff offset) {
+    ssize_t c = 0;
+    auto d = static_cast<std::uint8_t *>(dst);
+    auto o = static_cast<off64_t>(offset);
+    auto rem = cnt;
+
+    while ((rem > 0) && ((c = ::pread64(fd, d, rem, o)) > 0)) {
+        d += c;
+        o += c;
+        rem -= c;
+    }
+
+    if (c == -1) {
+        THROW_LAST_ERROR();
+    }
+
+    if (rem > 0) {
+        throw std::system_error(E2BIG, std::system_category());
+    }
+}
+#endif /* defined(_WIN32) */
+
+
 #if defined(_WIN32)
 /*
  * visus::power_overwhelming::detail::seek
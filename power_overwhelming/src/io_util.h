@@ -160,6 +160,42 @@ namespace detail {
     POWER_OVERWHELMING_API void read_bytes(_In_ const int fd,
         _Out_writes_bytes_(cnt) void *dst, _In_ const std::size_t cnt);
 
+#if defined(_WIN32)
+    /// <summary>
+    /// Reads exactly <paramref name="cnt" /> bytes at the given position of the
+    /// file or fails.
+    /// </summary>
+    /// <remarks>
+    /// In contrast to seeking and reading, this requires only a single call to
+    /// the operating system.
+    /// </remarks>
+    /// <param name="handle">An open file handle.</param>
+    /// <param name="dst">The buffer to receive the data.</param>
+    /// <param name="cnt">The number of bytes to read.</param>
+    /// <param name="offset">The position in the file where to read.</param>
+    /// <exception cref="std::system_error">If the operation failed.</exception>
+    POWER_OVERWHELMING_API void read_bytes_at(_In_ const HANDLE handle,
+        _Out_writes_bytes_(cnt) void *dst, _In_ const std::size_t cnt,
+        _In_ const std::streamoff offset);
+#else /* defined(_WIN32) */
+    /// <summary>
+    /// Reads exactly <paramref name="cnt" /> bytes at the given position of the
+    /// file or fails.
+    /// </summary>
+    /// <remarks>
+    /// In contrast to seeking and reading, this requires only a single call to
+    /// the operating system. The file pointer is not changed.
+    /// </remarks>
+    /// <param name="fd">An open file descriptor.</param>
+    /// <param name="dst">The buffer to receive the data.</param>
+    /// <param name="cnt">The number of bytes to read.</param>
+    /// <param name="offset">The position in the file where to read.</param>
+    /// <exception cref="std::system_error">If the operation failed.</exception>
+    POWER_OVERWHELMING_API void read_bytes_at(_In_ const int fd,
+        _Out_writes_bytes_(cnt) void *dst, _In_ const std::size_t cnt,
+        _In_ const std::streamoff offset);
+#endif /* defined(_WIN32) */
+
 #if defined(_WIN32)
     /// <summary>
     /// Seeks in a file.
@@ -0,0 +1,287 @@
+﻿// <copyright file="kernel_energy.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "kernel_energy.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+
+#include "power_overwhelming/convert_string.h"
+
+#include "sensor_name_registry.h"
+
+
+/*
+ * ...::detail::kernel_energy_integrator::kernel_energy_integrator
+ */
+visus::power_overwhelming::detail::kernel_energy_integrator
+::kernel_energy_integrator(_In_ const double ticks_per_second) {
+    this->reset(ticks_per_second);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::kernel_energy_integrator::add_counter
+ */
+void visus::power_overwhelming::detail::kernel_energy_integrator::add_counter(
+        _In_z_ const wchar_t *sensor) {
+    assert(sensor != nullptr);
+    sensor = sensor_name_registry::intern(sensor);
+
+    auto it = this->_sensors.find(sensor);
+    if (it == this->_sensors.end()) {
+        it = this->_sensors.emplace(sensor, sensor_type()).first;
+        this->_sensor_order.push_back(sensor);
+    }
+
+    it->second.counter = true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::kernel_energy_integrator::push
+ */
+void visus::power_overwhelming::detail::kernel_energy_integrator::push(
+        _In_ const measurement& sample) {
+    if (!sample) {
+        return;
+    }
+
+    auto it = this->_sensors.find(sample.sensor());
+    if (it == this->_sensors.end()) {
+        sensor_type sensor;
+        sensor.counter = false;
+        it = this->_sensors.emplace(sample.sensor(), std::move(sensor)).first;
+        this->_sensor_order.push_back(sample.sensor());
+    }
+
+    sample_type s;
+    s.power = sample.power();
+    s.timestamp = sample.timestamp();
+    it->second.samples.push_back(s);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::kernel_energy_integrator::push_kernel
+ */
+void visus::power_overwhelming::detail::kernel_energy_integrator::push_kernel(
+        _In_z_ const char *kernel,
+        _In_ const measurement::timestamp_type begin,
+        _In_ const measurement::timestamp_type end) {
+    if (kernel == nullptr) {
+        throw std::invalid_argument("The name of a kernel must not be null.");
+    }
+
+    auto it = this->_kernel_names.find(kernel);
+    if (it == this->_kernel_names.end()) {
+        it = this->_kernel_names.emplace(kernel, this->_names.size()).first;
+        this->_names.push_back(kernel);
+    }
+
+    kernel_type k;
+    k.begin = begin;
+    k.end = (std::max)(begin, end);
+    k.name = it->second;
+    this->_kernels.push_back(k);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::kernel_energy_integrator::reset
+ */
+void visus::power_overwhelming::detail::kernel_energy_integrator::reset(
+        _In_ const double ticks_per_second) {
+    if (!(ticks_per_second > 0.0)) {
+        throw std::invalid_argument("The number of ticks per second must be "
+            "positive.");
+    }
+
+    this->_kernel_names.clear();
+    this->_kernels.clear();
+    this->_names.clear();
+    this->_seconds_per_tick = 1.0 / ticks_per_second;
+    this->_sensor_order.clear();
+    this->_sensors.clear();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::kernel_energy_integrator::summary
+ */
+std::vector<visus::power_overwhelming::detail::kernel_energy>
+visus::power_overwhelming::detail::kernel_energy_integrator::summary(
+        void) const {
+    typedef measurement::timestamp_type timestamp_type;
+
+    // A kernel starting or ending. Kernels are identified by their name,
+    // because we only report the energy per name.
+    struct event_type {
+        bool begin;
+        std::size_t name;
+        timestamp_type timestamp;
+    };
+
+    std::vector<double> durations(this->_names.size(), 0.0);
+    std::vector<event_type> events;
+    std::vector<std::uint64_t> invocations(this->_names.size(), 0);
+    std::vector<kernel_energy> retval;
+
+    events.reserve(2 * this->_kernels.size());
+    for (auto& k : this->_kernels) {
+        durations[k.name] += (k.end - k.begin) * this->_seconds_per_tick;
+        ++invocations[k.name];
+        events.push_back(event_type { true, k.name, k.begin });
+        events.push_back(event_type { false, k.name, k.end });
+    }
+
+    // If one kernel ends when another one begins, the order does not matter,
+    // because the interval in between is empty. Processing the begin first
+    // makes sure that kernels without any duration are not left running.
+    std::sort(events.begin(), events.end(),
+            [](const event_type& lhs, const event_type& rhs) {
+        return (lhs.timestamp < rhs.timestamp)
+            || ((lhs.timestamp == rhs.timestamp) && lhs.begin && !rhs.begin);
+    });
+
+    std::vector<std::size_t> active;
+    std::vector<double> energies(this->_names.size());
+    std::vector<sample_type> samples;
+
+    for (auto sensor : this->_sensor_order) {
+        auto& s = this->_sensors.at(sensor);
+        if (s.samples.empty()) {
+            continue;
+        }
+
+        // Samples of a single sensor typically arrive in order, but the
+        // timestamp alignment of the collector might swap a few of them.
+        samples = s.samples;
+        std::stable_sort(samples.begin(), samples.end(),
+                [](const sample_type& lhs, const sample_type& rhs) {
+            return (lhs.timestamp < rhs.timestamp);
+        });
+
+        active.clear();
+        std::fill(energies.begin(), energies.end(), 0.0);
+        auto e = events.begin();
+        auto idle = 0.0;
+
+        auto power_at = [&s](const sample_type& lhs, const sample_type& rhs,
+                const timestamp_type timestamp) {
+            if (s.counter) {
+                // Counters report the average since their previous sample.
+                return static_cast<double>(rhs.power);
+            }
+
+            const auto t = static_cast<double>(timestamp - lhs.timestamp)
+                / (rhs.timestamp - lhs.timestamp);
+            return lhs.power + t * (rhs.power - lhs.power);
+        };
+
+        for (std::size_t i = 1; i < samples.size(); ++i) {
+            auto& lhs = samples[i - 1];
+            auto& rhs = samples[i];
+            if (rhs.timestamp <= lhs.timestamp) {
+                continue;
+            }
+
+            for (auto t = lhs.timestamp; t < rhs.timestamp;) {
+                // Update the running kernels up to the current time.
+                for (; (e != events.end()) && (e->timestamp <= t); ++e) {
+                    if (e->begin) {
+                        active.push_back(e->name);
+                    } else {
+                        auto it = std::find(active.begin(), active.end(),
+                            e->name);
+                        assert(it != active.end());
+                        *it = active.back();
+                        active.pop_back();
+                    }
+                }
+
+                const auto next = ((e != events.end())
+                    && (e->timestamp < rhs.timestamp))
+                    ? e->timestamp
+                    : rhs.timestamp;
+                const auto energy = 0.5 * (power_at(lhs, rhs, t)
+                    + power_at(lhs, rhs, next))
+                    * (next - t) * this->_seconds_per_tick;
+
+                if (active.empty()) {
+                    idle += energy;
+                } else {
+                    const auto share = energy / active.size();
+                    for (auto a : active) {
+                        energies[a] += share;
+                    }
+                }
+
+                t = next;
+            }
+        }
+
+        for (std::size_t n = 0; n < this->_names.size(); ++n) {
+            kernel_energy k;
+            k.duration = durations[n];
+            k.energy = energies[n];
+            k.invocations = invocations[n];
+            k.kernel = this->_names[n];
+            k.sensor = sensor;
+            retval.push_back(std::move(k));
+        }
+
+        {
+            kernel_energy k;
+            k.duration = 0.0;
+            k.energy = idle;
+            k.invocations = 0;
+            k.sensor = sensor;
+            retval.push_back(std::move(k));
+        }
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::write_kernel_energy
+ */
+std::ostream& visus::power_overwhelming::detail::write_kernel_energy(
+        _Inout_ std::ostream& stream,
+        _In_ const std::vector<kernel_energy>& energies) {
+    auto quote = [&stream](const std::string& str) {
+        stream << '"';
+        for (auto c : str) {
+            if (c == '"') {
+                stream << '"';
+            }
+            stream << c;
+        }
+        stream << '"';
+    };
+
+    const auto precision = stream.precision(
+        std::numeric_limits<double>::max_digits10);
+    stream << "sensor,kernel,invocations,duration,energy\n";
+
+    for (auto& e : energies) {
+        quote((e.sensor != nullptr)
+            ? power_overwhelming::convert_string<char>(e.sensor)
+            : std::string());
+        stream << ',';
+        quote(e.kernel);
+        stream << ',' << e.invocations
+            << ',' << e.duration
+            << ',' << e.energy
+            << '\n';
+    }
+
+    stream.precision(precision);
+    return stream;
+}
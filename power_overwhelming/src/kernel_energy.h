@@ -0,0 +1,187 @@
+﻿// <copyright file="kernel_energy.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "power_overwhelming/measurement.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The energy a single sensor has measured while the instances of a GPU
+    /// kernel were running.
+    /// </summary>
+    struct POWER_OVERWHELMING_API kernel_energy final {
+
+        /// <summary>
+        /// The total execution time of all instances of the kernel in
+        /// seconds.
+        /// </summary>
+        double duration;
+
+        /// <summary>
+        /// The energy attributed to the kernel in Joules.
+        /// </summary>
+        double energy;
+
+        /// <summary>
+        /// The number of times the kernel has been launched.
+        /// </summary>
+        std::uint64_t invocations;
+
+        /// <summary>
+        /// The name of the kernel, which is empty for the energy measured
+        /// while no kernel was running.
+        /// </summary>
+        std::string kernel;
+
+        /// <summary>
+        /// The interned name of the sensor.
+        /// </summary>
+        const wchar_t *sensor;
+    };
+
+
+    /// <summary>
+    /// Splits the energy measured by sensors between the GPU kernels that
+    /// were running at the time.
+    /// </summary>
+    /// <remarks>
+    /// <para>The power between two samples of a sensor is interpolated in the
+    /// same way as by the <see cref="phase_energy_integrator" />, i.e.
+    /// linearly for sensors measuring power and constant for sensors
+    /// registered via <see cref="add_counter" />. The energy of each interval
+    /// in which the set of running kernels does not change is split evenly
+    /// between all of them. The energy of intervals in which no kernel was
+    /// running is reported as idle energy.</para>
+    /// <para>Kernel activity typically arrives with a considerable delay and
+    /// not in order, wherefore the integrator keeps the power samples until
+    /// <see cref="summary" /> is called. A sample only requires 16 bytes, so
+    /// this is feasible for the sampling rates of GPU sensors.</para>
+    /// <para>The integrator is not thread-safe.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API kernel_energy_integrator final {
+
+    public:
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="ticks_per_second">The number of ticks of the
+        /// timestamps per second.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="ticks_per_second" /> is not positive.</exception>
+        explicit kernel_energy_integrator(
+            _In_ const double ticks_per_second = 1000.0);
+
+        /// <summary>
+        /// Registers a sensor that derives its power from an energy counter.
+        /// </summary>
+        /// <param name="sensor">The name of the sensor.</param>
+        void add_counter(_In_z_ const wchar_t *sensor);
+
+        /// <summary>
+        /// Adds a power sample of a sensor.
+        /// </summary>
+        /// <param name="sample">The sample to be added. Invalid samples are
+        /// ignored.</param>
+        void push(_In_ const measurement& sample);
+
+        /// <summary>
+        /// Adds the execution of a kernel.
+        /// </summary>
+        /// <param name="kernel">The name of the kernel.</param>
+        /// <param name="begin">The time when the kernel started.</param>
+        /// <param name="end">The time when the kernel ended.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="kernel" /> is <c>nullptr</c>.</exception>
+        void push_kernel(_In_z_ const char *kernel,
+            _In_ const measurement::timestamp_type begin,
+            _In_ const measurement::timestamp_type end);
+
+        /// <summary>
+        /// Removes all samples, kernels and sensors.
+        /// </summary>
+        /// <param name="ticks_per_second">The number of ticks of the
+        /// timestamps per second.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="ticks_per_second" /> is not positive.</exception>
+        void reset(_In_ const double ticks_per_second);
+
+        /// <summary>
+        /// Computes the energy of all kernels.
+        /// </summary>
+        /// <returns>The energies ordered by the order in which the sensors
+        /// have been registered or delivered their first sample and, for each
+        /// sensor, by the order in which the kernels have been added,
+        /// followed by the idle energy. Sensors without samples are omitted.
+        /// </returns>
+        std::vector<kernel_energy> summary(void) const;
+
+    private:
+
+        /// <summary>
+        /// A single execution of a kernel.
+        /// </summary>
+        struct kernel_type {
+            measurement::timestamp_type begin;
+            measurement::timestamp_type end;
+            std::size_t name;
+        };
+
+        /// <summary>
+        /// A single power sample.
+        /// </summary>
+        struct sample_type {
+            measurement::value_type power;
+            measurement::timestamp_type timestamp;
+        };
+
+        /// <summary>
+        /// The samples of a single sensor.
+        /// </summary>
+        struct sensor_type {
+            bool counter;
+            std::vector<sample_type> samples;
+        };
+
+        std::unordered_map<std::string, std::size_t> _kernel_names;
+        std::vector<kernel_type> _kernels;
+        std::vector<std::string> _names;
+        double _seconds_per_tick;
+        std::vector<const wchar_t *> _sensor_order;
+        std::unordered_map<const wchar_t *, sensor_type> _sensors;
+    };
+
+    /// <summary>
+    /// Writes the energy per kernel as CSV table with the columns
+    /// <c>sensor</c>, <c>kernel</c>, <c>invocations</c>, <c>duration</c> and
+    /// <c>energy</c>.
+    /// </summary>
+    /// <remarks>
+    /// The names of the sensors and kernels are quoted, because the mangled
+    /// names of C++ kernels contain commas. The energy consumed while no
+    /// kernel was running is written with an empty kernel name.
+    /// </remarks>
+    /// <param name="stream">The stream to write to.</param>
+    /// <param name="energies">The energies as returned by
+    /// <see cref="kernel_energy_integrator::summary" />.</param>
+    /// <returns><paramref name="stream" />.</returns>
+    POWER_OVERWHELMING_API std::ostream& write_kernel_energy(
+        _Inout_ std::ostream& stream,
+        _In_ const std::vector<kernel_energy>& energies);
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,236 @@
+﻿// <copyright file="latency_histogram.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/latency_histogram.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif /* defined(_MSC_VER) */
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Answer the position of the most significant bit of a non-zero value.
+    /// </summary>
+    static inline unsigned int magnitude(_In_ const std::uint64_t value) {
+        assert(value != 0);
+#if defined(_MSC_VER)
+        unsigned long retval;
+        ::_BitScanReverse64(&retval, value);
+        return retval;
+#else /* defined(_MSC_VER) */
+        return 63 - ::__builtin_clzll(value);
+#endif /* defined(_MSC_VER) */
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::latency_histogram::sub_bucket_bits
+ */
+constexpr unsigned int
+visus::power_overwhelming::latency_histogram::sub_bucket_bits;
+
+
+/*
+ * visus::power_overwhelming::latency_histogram::sub_buckets
+ */
+constexpr std::size_t visus::power_overwhelming::latency_histogram::sub_buckets;
+
+
+/*
+ * visus::power_overwhelming::latency_histogram::max_magnitude
+ */
+constexpr unsigned int
+visus::power_overwhelming::latency_histogram::max_magnitude;
+
+
+/*
+ * visus::power_overwhelming::latency_histogram::buckets
+ */
+constexpr std::size_t visus::power_overwhelming::latency_histogram::buckets;
+
+
+/*
+ * visus::power_overwhelming::latency_histogram::index_of
+ */
+std::size_t visus::power_overwhelming::latency_histogram::index_of(
+        _In_ const value_type value) noexcept {
+    if (value < sub_buckets) {
+        return static_cast<std::size_t>(value);
+    }
+
+    const auto m = detail::magnitude(value);
+    if (m >= max_magnitude) {
+        return buckets - 1;
+    }
+
+    // The sub-bucket is formed by the bits below the most significant one.
+    const auto group = m - sub_bucket_bits + 1;
+    const auto sub = (value >> (m - sub_bucket_bits)) & (sub_buckets - 1);
+    return static_cast<std::size_t>(group * sub_buckets + sub);
+}
+
+
+/*
+ * visus::power_overwhelming::latency_histogram::lower_bound
+ */
+visus::power_overwhelming::latency_histogram::value_type
+visus::power_overwhelming::latency_histogram::lower_bound(
+        _In_ const std::size_t index) {
+    if (index >= buckets) {
+        throw std::out_of_range("The bucket index is out of range.");
+    }
+
+    const auto group = index / sub_buckets;
+    const auto sub = static_cast<value_type>(index % sub_buckets);
+
+    if (group == 0) {
+        return sub;
+    }
+
+    const auto m = static_cast<unsigned int>(group) + sub_bucket_bits - 1;
+    return (sub_buckets + sub) << (m - sub_bucket_bits);
+}
+
+
+/*
+ * visus::power_overwhelming::latency_histogram::upper_bound
+ */
+visus::power_overwhelming::latency_histogram::value_type
+visus::power_overwhelming::latency_histogram::upper_bound(
+        _In_ const std::size_t index) {
+    if (index >= buckets) {
+        throw std::out_of_range("The bucket index is out of range.");
+    }
+
+    return (index < buckets - 1)
+        ? lower_bound(index + 1) - 1
+        : (std::numeric_limits<value_type>::max)();
+}
+
+
+/*
+ * visus::power_overwhelming::latency_histogram::latency_histogram
+ */
+visus::power_overwhelming::latency_histogram::latency_histogram(
+        void) noexcept {
+    this->reset();
+}
+
+
+/*
+ * visus::power_overwhelming::latency_histogram::bucket
+ */
+std::uint64_t visus::power_overwhelming::latency_histogram::bucket(
+        _In_ const std::size_t index) const {
+    if (index >= buckets) {
+        throw std::out_of_range("The bucket index is out of range.");
+    }
+
+    return this->_buckets[index];
+}
+
+
+/*
+ * visus::power_overwhelming::latency_histogram::mean
+ */
+double visus::power_overwhelming::latency_histogram::mean(
+        void) const noexcept {
+    return (this->_count > 0)
+        ? static_cast<double>(this->_sum) / static_cast<double>(this->_count)
+        : 0.0;
+}
+
+
+/*
+ * visus::power_overwhelming::latency_histogram::merge
+ */
+visus::power_overwhelming::latency_histogram&
+visus::power_overwhelming::latency_histogram::merge(
+        _In_ const latency_histogram& other) noexcept {
+    if (other._count > 0) {
+        for (std::size_t i = 0; i < buckets; ++i) {
+            this->_buckets[i] += other._buckets[i];
+        }
+
+        this->_max = (std::max)(this->_max, other._max);
+        this->_min = (std::min)(this->_min, other._min);
+        this->_count += other._count;
+        this->_sum += other._sum;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::latency_histogram::percentile
+ */
+visus::power_overwhelming::latency_histogram::value_type
+visus::power_overwhelming::latency_histogram::percentile(
+        _In_ const double fraction) const {
+    if (!(fraction >= 0.0) || !(fraction <= 1.0)) {
+        throw std::invalid_argument("The fraction of a percentile must be "
+            "within [0, 1].");
+    }
+
+    if (this->_count == 0) {
+        return 0;
+    }
+
+    // The rank is one-based such that the zeroth percentile is the first
+    // duration rather than nothing.
+    const auto rank = (std::max)(std::uint64_t(1), static_cast<std::uint64_t>(
+        std::ceil(fraction * static_cast<double>(this->_count))));
+    std::uint64_t seen = 0;
+
+    for (std::size_t i = 0; i < buckets; ++i) {
+        seen += this->_buckets[i];
+        if (seen >= rank) {
+            const auto retval = (std::min)(upper_bound(i), this->_max);
+            return (std::max)(retval, this->_min);
+        }
+    }
+
+    return this->_max;
+}
+
+
+/*
+ * visus::power_overwhelming::latency_histogram::record
+ */
+void visus::power_overwhelming::latency_histogram::record(
+        _In_ const value_type value) noexcept {
+    ++this->_buckets[index_of(value)];
+    ++this->_count;
+    this->_max = (std::max)(this->_max, value);
+    this->_min = (std::min)(this->_min, value);
+    this->_sum += value;
+}
+
+
+/*
+ * visus::power_overwhelming::latency_histogram::reset
+ */
+void visus::power_overwhelming::latency_histogram::reset(void) noexcept {
+    std::fill(this->_buckets, this->_buckets + buckets, 0);
+    this->_count = 0;
+    this->_max = 0;
+    this->_min = (std::numeric_limits<value_type>::max)();
+    this->_sum = 0;
+}
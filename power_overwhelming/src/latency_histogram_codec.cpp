@@ -0,0 +1,118 @@
+﻿// <copyright file="latency_histogram_codec.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "latency_histogram_codec.h"
+
+#include <stdexcept>
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Reads a single value from the given stream.
+    /// </summary>
+    template<class TValue>
+    static TValue read_histogram_value(_In_ std::istream& stream) {
+        TValue retval;
+        stream.read(reinterpret_cast<char *>(&retval), sizeof(retval));
+
+        if (!stream) {
+            throw std::runtime_error("The binary output ended while reading a "
+                "histogram.");
+        }
+
+        return retval;
+    }
+
+    /// <summary>
+    /// Writes the raw bytes of <paramref name="value" /> to the given stream.
+    /// </summary>
+    template<class TValue>
+    inline void write_histogram_value(_In_ std::ostream& stream,
+            _In_ const TValue value) {
+        stream.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::latency_histogram_codec::read
+ */
+visus::power_overwhelming::latency_histogram
+visus::power_overwhelming::detail::latency_histogram_codec::read(
+        _In_ std::istream& stream) {
+    latency_histogram retval;
+    retval._count = read_histogram_value<std::uint64_t>(stream);
+    retval._sum = read_histogram_value<latency_histogram::value_type>(stream);
+    retval._min = read_histogram_value<latency_histogram::value_type>(stream);
+    retval._max = read_histogram_value<latency_histogram::value_type>(stream);
+
+    const auto cnt = read_histogram_value<std::uint32_t>(stream);
+    for (std::uint32_t i = 0; i < cnt; ++i) {
+        const auto index = read_histogram_value<std::uint32_t>(stream);
+        const auto count = read_histogram_value<std::uint64_t>(stream);
+
+        if (index >= latency_histogram::buckets) {
+            throw std::runtime_error("The binary output contains a histogram "
+                "with an invalid bucket.");
+        }
+
+        retval._buckets[index] = count;
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::latency_histogram_codec::size
+ */
+std::uint64_t visus::power_overwhelming::detail::latency_histogram_codec::size(
+        _In_ const latency_histogram& histogram) noexcept {
+    std::uint64_t retval = sizeof(histogram._count) + sizeof(histogram._sum)
+        + sizeof(histogram._min) + sizeof(histogram._max)
+        + sizeof(std::uint32_t);
+
+    for (auto c : histogram._buckets) {
+        if (c != 0) {
+            retval += sizeof(std::uint32_t) + sizeof(c);
+        }
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::latency_histogram_codec::write
+ */
+void visus::power_overwhelming::detail::latency_histogram_codec::write(
+        _In_ std::ostream& stream,
+        _In_ const latency_histogram& histogram) {
+    std::uint32_t cnt = 0;
+    for (auto c : histogram._buckets) {
+        if (c != 0) {
+            ++cnt;
+        }
+    }
+
+    write_histogram_value(stream, histogram._count);
+    write_histogram_value(stream, histogram._sum);
+    write_histogram_value(stream, histogram._min);
+    write_histogram_value(stream, histogram._max);
+    write_histogram_value(stream, cnt);
+
+    for (std::uint32_t i = 0; i < latency_histogram::buckets; ++i) {
+        if (histogram._buckets[i] != 0) {
+            write_histogram_value(stream, i);
+            write_histogram_value(stream, histogram._buckets[i]);
+        }
+    }
+}
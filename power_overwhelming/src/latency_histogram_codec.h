@@ -0,0 +1,62 @@
+﻿// <copyright file="latency_histogram_codec.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <iostream>
+
+#include "power_overwhelming/latency_histogram.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Serialises <see cref="latency_histogram" />s for the binary output of
+    /// the collector.
+    /// </summary>
+    /// <remarks>
+    /// A histogram is stored as the 64-bit number of durations, their 64-bit
+    /// sum, minimum and maximum, and the 32-bit number of non-empty buckets
+    /// followed by the 32-bit index and the 64-bit count of each of them.
+    /// All numbers are stored in the native byte order.
+    /// </remarks>
+    class POWER_OVERWHELMING_API latency_histogram_codec final {
+
+    public:
+
+        /// <summary>
+        /// Reads a histogram from the given stream.
+        /// </summary>
+        /// <param name="stream">The stream to read from.</param>
+        /// <returns>The histogram read from the stream.</returns>
+        /// <exception cref="std::runtime_error">If the stream ended
+        /// prematurely or holds an invalid bucket index.</exception>
+        static latency_histogram read(_In_ std::istream& stream);
+
+        /// <summary>
+        /// Answer the number of bytes <see cref="write" /> writes for the given
+        /// histogram.
+        /// </summary>
+        /// <param name="histogram">The histogram to be measured.</param>
+        /// <returns>The size of the serialised histogram in bytes.</returns>
+        static std::uint64_t size(
+            _In_ const latency_histogram& histogram) noexcept;
+
+        /// <summary>
+        /// Writes the given histogram to a stream.
+        /// </summary>
+        /// <param name="stream">The stream to write to.</param>
+        /// <param name="histogram">The histogram to be written.</param>
+        static void write(_In_ std::ostream& stream,
+            _In_ const latency_histogram& histogram);
+
+        latency_histogram_codec(void) = delete;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
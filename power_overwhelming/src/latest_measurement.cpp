@@ -0,0 +1,108 @@
+﻿// <copyright file="latest_measurement.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/latest_measurement.h"
+
+#include <memory>
+#include <stdexcept>
+
+#include "latest_measurement_impl.h"
+
+
+/*
+ * visus::power_overwhelming::latest_measurement::latest_measurement
+ */
+visus::power_overwhelming::latest_measurement::latest_measurement(void)
+    : _impl(new detail::latest_measurement_impl()) { }
+
+
+/*
+ * visus::power_overwhelming::latest_measurement::~latest_measurement
+ */
+visus::power_overwhelming::latest_measurement::~latest_measurement(void) {
+    this->stop();
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::latest_measurement::read
+ */
+bool visus::power_overwhelming::latest_measurement::read(
+        _Out_ measurement_data& dst) noexcept {
+    if (this->_impl == nullptr) {
+        dst = detail::latest_measurement_impl::invalid_sample();
+        return false;
+    }
+
+    const auto retval = detail::swap_read_buffer(this->_impl->state);
+    const auto i = detail::get_read_buffer_index(this->_impl->state);
+    dst = this->_impl->buffers[i];
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::latest_measurement::start
+ */
+void visus::power_overwhelming::latest_measurement::start(
+        _In_ sensor& source,
+        _In_ const sensor::microseconds_type period) {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("A latest_measurement which has been disposed "
+            "by a move operation cannot be started.");
+    }
+
+    if (this->_impl->source != nullptr) {
+        throw std::logic_error("The latest_measurement is already sampling a "
+            "sensor.");
+    }
+
+    source.sample_batch(detail::latest_measurement_impl::on_batch, period,
+        this->_impl);
+    this->_impl->source = std::addressof(source);
+}
+
+
+/*
+ * visus::power_overwhelming::latest_measurement::stop
+ */
+void visus::power_overwhelming::latest_measurement::stop(void) {
+    if ((this->_impl != nullptr) && (this->_impl->source != nullptr)) {
+        // Only remove our own subscription, because the sensor might be
+        // shared with other subscribers.
+        this->_impl->source->sample_batch(nullptr,
+            sensor::default_sampling_period, this->_impl);
+        this->_impl->source = nullptr;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::latest_measurement::operator =
+ */
+visus::power_overwhelming::latest_measurement&
+visus::power_overwhelming::latest_measurement::operator =(
+        _Inout_ latest_measurement&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        try {
+            this->stop();
+        } catch (...) { /* We must not throw here. */ }
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::latest_measurement::operator bool
+ */
+visus::power_overwhelming::latest_measurement::operator bool(
+        void) const noexcept {
+    return (this->_impl != nullptr);
+}
@@ -0,0 +1,54 @@
+﻿// <copyright file="latest_measurement_impl.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "latest_measurement_impl.h"
+
+#include <cassert>
+
+
+/*
+ * visus::power_overwhelming::detail::latest_measurement_impl::invalid_sample
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::detail::latest_measurement_impl::invalid_sample(
+        void) noexcept {
+    const auto invalid = measurement_data::invalid_value;
+    return measurement_data(0, invalid, invalid, invalid);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::latest_measurement_impl::on_batch
+ */
+void visus::power_overwhelming::detail::latest_measurement_impl::on_batch(
+        _In_z_ const wchar_t *sensor,
+        _In_reads_(cnt) const measurement_data *samples,
+        _In_ const std::size_t cnt,
+        _In_opt_ void *context) {
+    auto that = static_cast<latest_measurement_impl *>(context);
+    assert(that != nullptr);
+
+    if ((samples == nullptr) || (cnt < 1)) {
+        return;
+    }
+
+    // Only the newest sample of the batch is of interest, so copy it into the
+    // write buffer and publish it to the reader.
+    const auto i = get_write_buffer_index(that->state);
+    that->buffers[i] = samples[cnt - 1];
+    swap_write_buffer(that->state);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::latest_measurement_impl
+ * ::latest_measurement_impl
+ */
+visus::power_overwhelming::detail::latest_measurement_impl
+::latest_measurement_impl(void)
+    : buffers({ { invalid_sample(), invalid_sample(), invalid_sample() } }),
+        source(nullptr) {
+    initialise_triple_buffer_state(this->state);
+}
@@ -0,0 +1,70 @@
+﻿// <copyright file="latest_measurement_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <array>
+
+#include "power_overwhelming/measurement_data.h"
+#include "power_overwhelming/sensor.h"
+
+#include "triple_buffering.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The private state of a <see cref="latest_measurement" />.
+    /// </summary>
+    struct latest_measurement_impl final {
+
+        /// <summary>
+        /// Creates the invalid sample that is returned before the first
+        /// batch has been delivered.
+        /// </summary>
+        /// <returns>A sample with all quantities invalid.</returns>
+        static measurement_data invalid_sample(void) noexcept;
+
+        /// <summary>
+        /// The batch callback that is registered with the sensor, which
+        /// publishes the last sample of the batch.
+        /// </summary>
+        /// <remarks>
+        /// This method is only called on the sampler thread of
+        /// <see cref="source" />, which is the only writer of the triple
+        /// buffer.
+        /// </remarks>
+        static void on_batch(_In_z_ const wchar_t *sensor,
+            _In_reads_(cnt) const measurement_data *samples,
+            _In_ const std::size_t cnt,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// The three buffers of the triple buffer.
+        /// </summary>
+        std::array<measurement_data, 3> buffers;
+
+        /// <summary>
+        /// The sensor being sampled, or <c>nullptr</c> if the sampling is not
+        /// running.
+        /// </summary>
+        sensor *source;
+
+        /// <summary>
+        /// The state of the triple buffer in <see cref="buffers" />.
+        /// </summary>
+        triple_buffer_state state;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        latest_measurement_impl(void);
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,189 @@
+﻿// <copyright file="level_zero_device.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "level_zero_device.h"
+
+#if defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO)
+#include <cassert>
+#include <cstdio>
+#include <stdexcept>
+
+#include "level_zero_exception.h"
+#include "level_zero_library.h"
+
+
+/*
+ * visus::power_overwhelming::detail::level_zero_device::max_reuse
+ */
+constexpr std::chrono::microseconds
+visus::power_overwhelming::detail::level_zero_device::max_reuse;
+
+
+/*
+ * visus::power_overwhelming::detail::level_zero_device::for_each_device
+ */
+template<class TCallback>
+void visus::power_overwhelming::detail::level_zero_device::for_each_device(
+        _In_ TCallback callback) {
+    auto& zes = level_zero_library::instance();
+
+    std::uint32_t cnt_drivers = 0;
+    level_zero_exception::check(zes.zesDriverGet(&cnt_drivers, nullptr));
+    std::vector<zes_driver_handle_t> drivers(cnt_drivers);
+    level_zero_exception::check(zes.zesDriverGet(&cnt_drivers,
+        drivers.data()));
+    drivers.resize(cnt_drivers);
+
+    for (auto d : drivers) {
+        std::uint32_t cnt_devices = 0;
+        level_zero_exception::check(zes.zesDeviceGet(d, &cnt_devices,
+            nullptr));
+        std::vector<zes_device_handle_t> devices(cnt_devices);
+        level_zero_exception::check(zes.zesDeviceGet(d, &cnt_devices,
+            devices.data()));
+        devices.resize(cnt_devices);
+
+        for (auto h : devices) {
+            zes_pci_properties_t pci { };
+            pci.stype = ZES_STRUCTURE_TYPE_PCI_PROPERTIES;
+            level_zero_exception::check(zes.zesDevicePciGetProperties(h,
+                &pci));
+
+            if (!callback(h, to_bus_id(pci.address))) {
+                return;
+            }
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::level_zero_device::bus_ids
+ */
+std::vector<std::string>
+visus::power_overwhelming::detail::level_zero_device::bus_ids(void) {
+    std::vector<std::string> retval;
+
+    for_each_device([&retval](zes_device_handle_t, std::string&& bus_id) {
+        retval.push_back(std::move(bus_id));
+        return true;
+    });
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::level_zero_device::create
+ */
+visus::power_overwhelming::detail::level_zero_device::device_type
+visus::power_overwhelming::detail::level_zero_device::create(
+        _In_ const std::string& bus_id) {
+    std::lock_guard<decltype(_lock)> l(_lock);
+    auto it = _instances.find(bus_id);
+
+    if (it != _instances.end()) {
+        return it->second;
+    }
+
+    device_type retval;
+    for_each_device([&retval, &bus_id](zes_device_handle_t device,
+            std::string&& id) {
+        if (id == bus_id) {
+            retval = std::make_shared<level_zero_device>(device, id);
+            return false;
+        } else {
+            return true;
+        }
+    });
+
+    if (retval == nullptr) {
+        throw std::invalid_argument("No Level Zero device with the specified "
+            "PCI bus ID exists.");
+    }
+
+    _instances[bus_id] = retval;
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::level_zero_device::to_bus_id
+ */
+std::string visus::power_overwhelming::detail::level_zero_device::to_bus_id(
+        _In_ const zes_pci_address_t& address) {
+    char retval[32];
+    ::snprintf(retval, sizeof(retval), "%04x:%02x:%02x.%x", address.domain,
+        address.bus, address.device, address.function);
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::level_zero_device::level_zero_device
+ */
+visus::power_overwhelming::detail::level_zero_device::level_zero_device(
+        _In_ zes_device_handle_t device,
+        _In_ const std::string& bus_id)
+        : _bus_id(bus_id), _consumed(0) {
+    auto& zes = level_zero_library::instance();
+
+    std::uint32_t cnt = 0;
+    level_zero_exception::check(zes.zesDeviceEnumPowerDomains(device, &cnt,
+        nullptr));
+    this->_domains.resize(cnt);
+    level_zero_exception::check(zes.zesDeviceEnumPowerDomains(device, &cnt,
+        this->_domains.data()));
+    this->_domains.resize(cnt);
+    this->_counters.resize(cnt);
+    assert(this->_domains.size() <= 8 * sizeof(this->_consumed));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::level_zero_device::read
+ */
+visus::power_overwhelming::detail::level_zero_device::counter_type
+visus::power_overwhelming::detail::level_zero_device::read(
+        _In_ const std::size_t index,
+        _Out_ time_point& time) {
+    assert(index < this->_domains.size());
+    const auto bit = static_cast<std::uint64_t>(1) << index;
+    const auto now = std::chrono::system_clock::now();
+
+    std::lock_guard<decltype(this->_read_lock)> l(this->_read_lock);
+    if (((this->_consumed & bit) != 0) || (now - this->_time > max_reuse)) {
+        // The counter has already been retrieved from the last read or the
+        // read is too old, so read all domains of the device again.
+        auto& zes = level_zero_library::instance();
+        for (std::size_t i = 0; i < this->_domains.size(); ++i) {
+            level_zero_exception::check(zes.zesPowerGetEnergyCounter(
+                this->_domains[i], this->_counters.data() + i));
+        }
+
+        this->_consumed = 0;
+        this->_time = std::chrono::system_clock::now();
+    }
+
+    this->_consumed |= bit;
+    time = this->_time;
+    return this->_counters[index];
+}
+
+
+/*
+ * visus::power_overwhelming::detail::level_zero_device::_instances
+ */
+std::map<std::string,
+    visus::power_overwhelming::detail::level_zero_device::device_type>
+visus::power_overwhelming::detail::level_zero_device::_instances;
+
+
+/*
+ * visus::power_overwhelming::detail::level_zero_device::_lock
+ */
+std::mutex visus::power_overwhelming::detail::level_zero_device::_lock;
+
+#endif /* defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO) */
@@ -0,0 +1,166 @@
+﻿// <copyright file="level_zero_device.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#if defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO)
+#include <chrono>
+#include <cinttypes>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <zes_api.h>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A Level Zero Sysman device, which holds the energy counters of all
+    /// power domains of a single GPU.
+    /// </summary>
+    /// <remarks>
+    /// <para>Devices are identified by their PCI bus ID, because the order
+    /// in which the drivers enumerate them is not guaranteed to be stable.
+    /// </para>
+    /// <para>Devices are shared by all sensors for the same GPU via
+    /// <see cref="create" />. In order to retrieve all domains in one batch
+    /// if they are sampled together, the device retains the result of its
+    /// last read and serves every domain once from it, provided that the read
+    /// is not older than <see cref="max_reuse" />.</para>
+    /// </remarks>
+    class level_zero_device final {
+
+    public:
+
+        /// <summary>
+        /// The type of a single reading of an energy counter.
+        /// </summary>
+        typedef zes_power_energy_counter_t counter_type;
+
+        /// <summary>
+        /// The type of a shared device.
+        /// </summary>
+        typedef std::shared_ptr<level_zero_device> device_type;
+
+        /// <summary>
+        /// The type used to store the point in time a device has been read.
+        /// </summary>
+        typedef std::chrono::system_clock::time_point time_point;
+
+        /// <summary>
+        /// The maximum age of the last read for which it is used to answer a
+        /// domain that has not yet been retrieved from it.
+        /// </summary>
+        static constexpr std::chrono::microseconds max_reuse
+            = std::chrono::microseconds(1000);
+
+        /// <summary>
+        /// Answer the PCI bus IDs of all devices that Sysman reports.
+        /// </summary>
+        /// <returns>The bus IDs in the format of sysfs.</returns>
+        /// <exception cref="std::runtime_error">If the Level Zero loader is
+        /// not available.</exception>
+        /// <exception cref="level_zero_exception">If the enumeration
+        /// failed.</exception>
+        static std::vector<std::string> bus_ids(void);
+
+        /// <summary>
+        /// Gets the device with the specified PCI bus ID or opens it if no
+        /// sensor is using it yet.
+        /// </summary>
+        /// <param name="bus_id">The PCI bus ID of the device.</param>
+        /// <returns>The device for <paramref name="bus_id" />.</returns>
+        /// <exception cref="std::invalid_argument">If no device with the
+        /// specified bus ID exists.</exception>
+        /// <exception cref="std::runtime_error">If the Level Zero loader is
+        /// not available.</exception>
+        /// <exception cref="level_zero_exception">If the enumeration
+        /// failed.</exception>
+        static device_type create(_In_ const std::string& bus_id);
+
+        /// <summary>
+        /// Formats the given PCI address as bus ID like sysfs does, for
+        /// instance &quot;0000:03:00.0&quot;.
+        /// </summary>
+        /// <param name="address">The address to be formatted.</param>
+        /// <returns>The bus ID.</returns>
+        static std::string to_bus_id(_In_ const zes_pci_address_t& address);
+
+        /// <summary>
+        /// Opens all power domains of the given device.
+        /// </summary>
+        /// <param name="device">The Sysman handle of the device.</param>
+        /// <param name="bus_id">The PCI bus ID of the device.</param>
+        /// <exception cref="level_zero_exception">If the domains could not be
+        /// enumerated.</exception>
+        level_zero_device(_In_ zes_device_handle_t device,
+            _In_ const std::string& bus_id);
+
+        level_zero_device(const level_zero_device&) = delete;
+
+        /// <summary>
+        /// Answer the PCI bus ID of the device.
+        /// </summary>
+        /// <returns>The PCI bus ID.</returns>
+        inline const std::string& bus_id(void) const noexcept {
+            return this->_bus_id;
+        }
+
+        /// <summary>
+        /// Answer the number of power domains of the device.
+        /// </summary>
+        /// <returns>The number of domains, which are indexed starting at
+        /// zero.</returns>
+        inline std::size_t domains(void) const noexcept {
+            return this->_domains.size();
+        }
+
+        /// <summary>
+        /// Reads the energy counter of the specified domain.
+        /// </summary>
+        /// <param name="index">The index of the domain.</param>
+        /// <param name="time">Receives the point in time when the counter
+        /// was read.</param>
+        /// <returns>The reading of the counter, which is in microjoules
+        /// and has a timestamp in microseconds.</returns>
+        /// <exception cref="level_zero_exception">If reading the counters
+        /// failed.</exception>
+        counter_type read(_In_ const std::size_t index,
+            _Out_ time_point& time);
+
+        level_zero_device& operator =(const level_zero_device&) = delete;
+
+    private:
+
+        /// <summary>
+        /// Invokes <paramref name="callback" /> for every Sysman device of
+        /// every driver until it returns <c>false</c>.
+        /// </summary>
+        template<class TCallback>
+        static void for_each_device(_In_ TCallback callback);
+
+        static std::map<std::string, device_type> _instances;
+        static std::mutex _lock;
+
+        std::string _bus_id;
+        std::uint64_t _consumed;
+        std::vector<counter_type> _counters;
+        std::vector<zes_pwr_handle_t> _domains;
+        std::mutex _read_lock;
+        time_point _time;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+#endif /* defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO) */
@@ -0,0 +1,51 @@
+﻿// <copyright file="level_zero_exception.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "level_zero_exception.h"
+
+#if defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO)
+#include <cinttypes>
+#include <sstream>
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Formats the message for the given error code, because Sysman does not
+    /// provide a function for retrieving a description of an error.
+    /// </summary>
+    static std::string level_zero_message(const ze_result_t code) {
+        std::stringstream stream;
+        stream << "The Level Zero Sysman call failed with error code 0x"
+            << std::hex << static_cast<std::uint32_t>(code) << ".";
+        return stream.str();
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::level_zero_exception::check
+ */
+void visus::power_overwhelming::level_zero_exception::check(
+        const value_type code) {
+    if (code != ZE_RESULT_SUCCESS) {
+        throw level_zero_exception(code);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::level_zero_exception::level_zero_exception
+ */
+visus::power_overwhelming::level_zero_exception::level_zero_exception(
+        const value_type code)
+    : std::runtime_error(detail::level_zero_message(code)), _code(code) { }
+
+#endif /* defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO) */
@@ -0,0 +1,62 @@
+﻿// <copyright file="level_zero_exception.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#if defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO)
+#include <stdexcept>
+#include <string>
+
+#include <zes_api.h>
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// Exception class for reporting errors of the Level Zero Sysman API.
+    /// </summary>
+    class level_zero_exception : public std::runtime_error {
+
+    public:
+
+        /// <summary>
+        /// The type of the native error code.
+        /// </summary>
+        typedef ::ze_result_t value_type;
+
+        /// <summary>
+        /// Throws a <see cref="level_zero_exception" /> if
+        /// <paramref name="code" /> indicates an error.
+        /// </summary>
+        /// <param name="code">The result of a Level Zero call.</param>
+        /// <exception cref="level_zero_exception">If
+        /// <paramref name="code" /> is not <c>ZE_RESULT_SUCCESS</c>.
+        /// </exception>
+        static void check(const value_type code);
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="code">The Level Zero error code.</param>
+        level_zero_exception(const value_type code);
+
+        /// <summary>
+        /// Answer the native error code.
+        /// </summary>
+        /// <returns>The error code.</returns>
+        value_type code(void) const noexcept {
+            return this->_code;
+        }
+
+    private:
+
+        value_type _code;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+#endif /* defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO) */
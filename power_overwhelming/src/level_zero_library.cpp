@@ -0,0 +1,49 @@
+﻿// <copyright file="level_zero_library.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "level_zero_library.h"
+
+#if defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO)
+#include "level_zero_exception.h"
+
+
+#define __POWER_OVERWHELMING_GET_ZES_FUNC(n) \
+    this->n = this->get_function<decltype(this->n)>(#n)
+
+
+/*
+ * visus::power_overwhelming::detail::level_zero_library::instance
+ */
+const visus::power_overwhelming::detail::level_zero_library&
+visus::power_overwhelming::detail::level_zero_library::instance(void) {
+    static const level_zero_library instance;
+    return instance;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::level_zero_library::level_zero_library
+ */
+visus::power_overwhelming::detail::level_zero_library::level_zero_library(
+        void)
+#if defined(_WIN32)
+        : library_base(TEXT("ze_loader.dll")) {
+#else /* defined(_WIN32) */
+        : library_base("libze_loader.so.1", "libze_loader.so") {
+#endif /* defined(_WIN32) */
+    __POWER_OVERWHELMING_GET_ZES_FUNC(zesDeviceEnumPowerDomains);
+    __POWER_OVERWHELMING_GET_ZES_FUNC(zesDeviceGet);
+    __POWER_OVERWHELMING_GET_ZES_FUNC(zesDevicePciGetProperties);
+    __POWER_OVERWHELMING_GET_ZES_FUNC(zesDriverGet);
+    __POWER_OVERWHELMING_GET_ZES_FUNC(zesInit);
+    __POWER_OVERWHELMING_GET_ZES_FUNC(zesPowerGetEnergyCounter);
+    __POWER_OVERWHELMING_GET_ZES_FUNC(zesPowerGetProperties);
+
+    // Sysman must be initialised once per process before any of its other
+    // functions can be used. There is no matching call for shutting it down.
+    level_zero_exception::check(this->zesInit(0));
+}
+
+#endif /* defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO) */
@@ -0,0 +1,62 @@
+﻿// <copyright file="level_zero_library.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#if defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO)
+#include <zes_api.h>
+
+#include "library_base.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+#define __POWER_OVERWHELMING_ZES_FUNC(f) decltype(&::f) f = nullptr
+
+    /// <summary>
+    /// Wrapper for lazily loading the Level Zero loader, which provides the
+    /// Sysman API.
+    /// </summary>
+    class level_zero_library final : library_base {
+
+    public:
+
+        /// <summary>
+        /// Gets the only instance of the class.
+        /// </summary>
+        /// <remarks>
+        /// The library is loaded and Sysman is initialised when the instance
+        /// is requested for the first time.
+        /// </remarks>
+        /// <returns>The only instance of the class.</returns>
+        /// <exception cref="std::runtime_error">If the loader could not be
+        /// loaded.</exception>
+        /// <exception cref="level_zero_exception">If Sysman could not be
+        /// initialised.</exception>
+        static const level_zero_library& instance(void);
+
+        __POWER_OVERWHELMING_ZES_FUNC(zesDeviceEnumPowerDomains);
+        __POWER_OVERWHELMING_ZES_FUNC(zesDeviceGet);
+        __POWER_OVERWHELMING_ZES_FUNC(zesDevicePciGetProperties);
+        __POWER_OVERWHELMING_ZES_FUNC(zesDriverGet);
+        __POWER_OVERWHELMING_ZES_FUNC(zesInit);
+        __POWER_OVERWHELMING_ZES_FUNC(zesPowerGetEnergyCounter);
+        __POWER_OVERWHELMING_ZES_FUNC(zesPowerGetProperties);
+
+    private:
+
+        level_zero_library(void);
+
+    };
+
+#undef __POWER_OVERWHELMING_ZES_FUNC
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+#endif /* defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO) */
@@ -0,0 +1,288 @@
+﻿// <copyright file="level_zero_sensor.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/level_zero_sensor.h"
+
+#include <cassert>
+#include <stdexcept>
+
+#include "power_overwhelming/convert_string.h"
+
+#include "level_zero_device.h"
+#include "level_zero_sensor_impl.h"
+
+
+/*
+ * visus::power_overwhelming::level_zero_sensor::for_all
+ */
+std::size_t visus::power_overwhelming::level_zero_sensor::for_all(
+        _Out_writes_opt_(cnt_sensors) level_zero_sensor *out_sensors,
+        _In_ const std::size_t cnt_sensors) {
+    std::size_t retval = 0;
+
+#if defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO)
+    try {
+        for (auto& b : detail::level_zero_device::bus_ids()) {
+            // The device is cached, so the sensors created below share it.
+            auto device = detail::level_zero_device::create(b);
+            assert(device != nullptr);
+
+            for (std::size_t d = 0; d < device->domains(); ++d) {
+                if (retval < cnt_sensors) {
+                    auto& sensor = out_sensors[retval];
+                    assert(sensor._impl != nullptr);
+                    sensor._impl->set(b, static_cast<domain_type>(d));
+                }
+
+                ++retval;
+            }
+        }
+    } catch (const std::runtime_error&) {
+        // The Level Zero loader is not installed or Sysman is not enabled,
+        // which is not fatal, there are just no sensors of this type.
+    }
+#endif /* defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO) */
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::level_zero_sensor::for_domain
+ */
+visus::power_overwhelming::level_zero_sensor
+visus::power_overwhelming::level_zero_sensor::for_domain(
+        _In_z_ const char *bus_id,
+        _In_ const domain_type domain) {
+    if (bus_id == nullptr) {
+        throw std::invalid_argument("The PCI bus ID of a Level Zero sensor "
+            "must not be null.");
+    }
+
+#if defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO)
+    level_zero_sensor retval;
+    assert(retval._impl != nullptr);
+    retval._impl->set(bus_id, domain);
+    return retval;
+
+#else /* defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO) */
+    throw std::runtime_error("The library has been built without support for "
+        "Level Zero.");
+#endif /* defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO) */
+}
+
+
+/*
+ * visus::power_overwhelming::level_zero_sensor::for_domain
+ */
+visus::power_overwhelming::level_zero_sensor
+visus::power_overwhelming::level_zero_sensor::for_domain(
+        _In_z_ const wchar_t *bus_id,
+        _In_ const domain_type domain) {
+    if (bus_id == nullptr) {
+        throw std::invalid_argument("The PCI bus ID of a Level Zero sensor "
+            "must not be null.");
+    }
+
+    auto b = convert_string<char>(bus_id);
+    return for_domain(b.c_str(), domain);
+}
+
+
+/*
+ * visus::power_overwhelming::level_zero_sensor::sample_data
+ */
+void visus::power_overwhelming::level_zero_sensor::sample_data(
+        _Out_writes_(cnt) measurement_data *dst,
+        _In_reads_(cnt) const level_zero_sensor *sensors,
+        _In_ const std::size_t cnt,
+        _In_ const timestamp_resolution resolution) {
+    if ((cnt > 0) && ((dst == nullptr) || (sensors == nullptr))) {
+        throw std::invalid_argument("The output and the sensors must be "
+            "valid if sensors are to be sampled.");
+    }
+
+    // Sensors of the same device are served from a single read of all of its
+    // domains, so there is no need to group them here.
+    for (std::size_t i = 0; i < cnt; ++i) {
+        dst[i] = sensors[i].sample_data(resolution);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::level_zero_sensor::level_zero_sensor
+ */
+visus::power_overwhelming::level_zero_sensor::level_zero_sensor(void)
+    : _impl(new detail::level_zero_sensor_impl()) { }
+
+
+/*
+ * visus::power_overwhelming::level_zero_sensor::~level_zero_sensor
+ */
+visus::power_overwhelming::level_zero_sensor::~level_zero_sensor(void) {
+    detail::level_zero_sensor_impl::sampler.remove(this->_impl);
+    // Make sure that the generic sampler thread does not use the sensor
+    // anymore.
+    this->sample_batch(nullptr);
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::level_zero_sensor::bus_id
+ */
+_Ret_z_ const char *visus::power_overwhelming::level_zero_sensor::bus_id(
+        void) const {
+    if (!*this) {
+        throw_disposed();
+    }
+#if defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO)
+    return this->_impl->device->bus_id().c_str();
+#else /* defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO) */
+    return nullptr;
+#endif /* defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO) */
+}
+
+
+/*
+ * visus::power_overwhelming::level_zero_sensor::domain
+ */
+visus::power_overwhelming::level_zero_sensor::domain_type
+visus::power_overwhelming::level_zero_sensor::domain(void) const {
+    this->check_not_disposed();
+    return this->_impl->domain;
+}
+
+
+/*
+ * visus::power_overwhelming::level_zero_sensor::energy
+ */
+double visus::power_overwhelming::level_zero_sensor::energy(void) const {
+    if (!*this) {
+        throw_disposed();
+    }
+#if defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO)
+    return this->_impl->energy();
+#else /* defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO) */
+    return 0.0;
+#endif /* defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO) */
+}
+
+
+/*
+ * visus::power_overwhelming::level_zero_sensor::name
+ */
+_Ret_maybenull_z_
+const wchar_t *visus::power_overwhelming::level_zero_sensor::name(
+        void) const noexcept {
+    return (this->_impl != nullptr)
+        ? this->_impl->sensor_name.c_str()
+        : nullptr;
+}
+
+
+/*
+ * visus::power_overwhelming::level_zero_sensor::native_interval
+ */
+visus::power_overwhelming::sensor::microseconds_type
+visus::power_overwhelming::level_zero_sensor::native_interval(void) const {
+    // Sysman does not report the update rate of the counters, but the
+    // drivers for current Intel GPUs update them about every millisecond.
+    this->check_not_disposed();
+    return 1000;
+}
+
+
+/*
+ * visus::power_overwhelming::level_zero_sensor::sample
+ */
+void visus::power_overwhelming::level_zero_sensor::sample(
+        _In_opt_ const measurement_callback on_measurement,
+        _In_ const microseconds_type period,
+        _In_ const timestamp_resolution timestamp_resolution,
+        _In_opt_ void *context) {
+    typedef decltype(detail::level_zero_sensor_impl::sampler)::interval_type
+        interval_type;
+
+    this->check_not_disposed();
+
+    if (on_measurement != nullptr) {
+        if (!detail::level_zero_sensor_impl::sampler.add(this->_impl,
+                on_measurement, context, interval_type(period))) {
+            throw std::logic_error("Asynchronous sampling cannot be started "
+                "while it is already running.");
+        }
+
+    } else {
+        detail::level_zero_sensor_impl::sampler.remove(this->_impl, context);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::level_zero_sensor::sample_adaptive
+ */
+void visus::power_overwhelming::level_zero_sensor::sample_adaptive(
+        _In_opt_ const measurement_data_callback on_batch,
+        _In_ const microseconds_type min_period,
+        _In_ const microseconds_type max_period,
+        _In_opt_ void *context) {
+    this->sample_adaptive_sync(on_batch, min_period, max_period, context);
+}
+
+
+/*
+ * visus::power_overwhelming::level_zero_sensor::operator =
+ */
+visus::power_overwhelming::level_zero_sensor&
+visus::power_overwhelming::level_zero_sensor::operator =(
+        _In_ level_zero_sensor&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        detail::level_zero_sensor_impl::sampler.remove(this->_impl);
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::level_zero_sensor::operator bool
+ */
+visus::power_overwhelming::level_zero_sensor::operator bool(
+        void) const noexcept {
+#if defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO)
+    return ((this->_impl != nullptr) && (this->_impl->device != nullptr));
+#else /* defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO) */
+    return false;
+#endif /* defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO) */
+}
+
+
+/*
+ * visus::power_overwhelming::level_zero_sensor::sample_data
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::level_zero_sensor::sample_data(
+        _In_ const timestamp_resolution resolution) const {
+    if (!*this) {
+        // The class is final, so this does not require a virtual call.
+        throw_disposed();
+    }
+    return this->_impl->sample(resolution);
+}
+
+
+/*
+ * visus::power_overwhelming::level_zero_sensor::sample_sync
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::level_zero_sensor::sample_sync(
+        _In_ const timestamp_resolution resolution) const {
+    return this->sample_data(resolution);
+}
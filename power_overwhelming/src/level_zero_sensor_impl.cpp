@@ -0,0 +1,115 @@
+﻿// <copyright file="level_zero_sensor_impl.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "level_zero_sensor_impl.h"
+
+#include <cassert>
+#include <stdexcept>
+
+#include "power_overwhelming/convert_string.h"
+
+
+/*
+ * visus::power_overwhelming::detail::level_zero_sensor_impl::sampler
+ */
+visus::power_overwhelming::detail::sampler<
+    visus::power_overwhelming::detail::default_sampler_context<
+    visus::power_overwhelming::detail::level_zero_sensor_impl>>
+    visus::power_overwhelming::detail::level_zero_sensor_impl::sampler;
+
+
+#if defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO)
+/*
+ * visus::power_overwhelming::detail::level_zero_sensor_impl::energy
+ */
+double visus::power_overwhelming::detail::level_zero_sensor_impl::energy(
+        void) const {
+    assert(this->device != nullptr);
+    level_zero_device::time_point time;
+    // Sysman accumulates the counter in 64 bits, so there is no need to track
+    // wrapping registers like the msr_sensor does.
+    const auto counter = this->device->read(this->domain, time);
+    return static_cast<double>(counter.energy - this->first_counter.energy)
+        / 1000000.0;
+}
+#endif /* defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO) */
+
+
+/*
+ * visus::power_overwhelming::detail::level_zero_sensor_impl::sample
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::detail::level_zero_sensor_impl::sample(
+        _In_ const timestamp_resolution resolution) const {
+#if defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO)
+    assert(this->device != nullptr);
+
+    if (resolution == timestamp_resolution::nanoseconds) {
+        throw std::invalid_argument("Timestamps of Level Zero sensors cannot "
+            "be created in nanoseconds.");
+    }
+
+    const auto converter = get_timestamp_converter(resolution);
+    level_zero_device::time_point now;
+    const auto counter = this->device->read(this->domain, now);
+
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    const auto de = static_cast<double>(counter.energy
+        - this->last_counter.energy);
+    const auto dt = now - this->last_time;
+    const auto sample_time = this->last_time + dt / 2;
+    const auto timestamp = converter(convert_to_file_time(sample_time));
+
+    // Prefer the timestamps of the driver, which belong to the energy values,
+    // over the time when we have read them.
+    auto seconds = static_cast<double>(counter.timestamp
+        - this->last_counter.timestamp) / 1000000.0;
+    if (counter.timestamp <= this->last_counter.timestamp) {
+        typedef std::chrono::duration<double> seconds_type;
+        seconds = std::chrono::duration_cast<seconds_type>(dt).count();
+    }
+
+    const auto power = static_cast<measurement_data::value_type>(
+        de / 1000000.0 / seconds);
+
+    this->last_counter = counter;
+    this->last_time = now;
+
+    return measurement_data(timestamp, power);
+
+#else /* defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO) */
+    throw std::runtime_error("The library has been built without support for "
+        "Level Zero.");
+#endif /* defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO) */
+}
+
+
+#if defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO)
+/*
+ * visus::power_overwhelming::detail::level_zero_sensor_impl::set
+ */
+void visus::power_overwhelming::detail::level_zero_sensor_impl::set(
+        _In_ const std::string& bus_id,
+        _In_ const level_zero_sensor::domain_type domain) {
+    auto device = level_zero_device::create(bus_id);
+    assert(device != nullptr);
+
+    if (domain >= device->domains()) {
+        throw std::invalid_argument("The requested power domain does not "
+            "exist on the specified Level Zero device.");
+    }
+
+    this->device = std::move(device);
+    this->domain = domain;
+    this->sensor_name = L"level_zero/"
+        + power_overwhelming::convert_string<wchar_t>(this->device->bus_id())
+        + L"/" + std::to_wstring(this->domain);
+
+    // Retrieve a first sample as reference for the power of the next one and
+    // for the energy consumed since the creation of the sensor.
+    this->first_counter = this->last_counter = this->device->read(
+        this->domain, this->last_time);
+}
+#endif /* defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO) */
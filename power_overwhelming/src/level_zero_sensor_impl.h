@@ -0,0 +1,145 @@
+﻿// <copyright file="level_zero_sensor_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+
+#include "power_overwhelming/level_zero_sensor.h"
+#include "power_overwhelming/measurement.h"
+
+#include "default_sampler_context.h"
+#include "level_zero_device.h"
+#include "sampler.h"
+#include "timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Private data container for the <see cref="level_zero_sensor" />.
+    /// </summary>
+    struct level_zero_sensor_impl final {
+
+        /// <summary>
+        /// A sampler for Level Zero sensors.
+        /// </summary>
+        /// <remarks>
+        /// The default context samples the sensors of the same device one
+        /// after another, so the device answers all but the first of them
+        /// from a single batch of reads.
+        /// </remarks>
+        static detail::sampler<default_sampler_context<level_zero_sensor_impl>>
+            sampler;
+
+        /// <summary>
+        /// The index of the power domain of the device.
+        /// </summary>
+        level_zero_sensor::domain_type domain;
+
+        /// <summary>
+        /// The sensor name.
+        /// </summary>
+        std::wstring sensor_name;
+
+#if defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO)
+        /// <summary>
+        /// The device the sensor reads its counter from.
+        /// </summary>
+        level_zero_device::device_type device;
+
+        /// <summary>
+        /// The reading of the counter when the sensor was created.
+        /// </summary>
+        level_zero_device::counter_type first_counter;
+
+        /// <summary>
+        /// The reading of the counter at the last sample.
+        /// </summary>
+        mutable level_zero_device::counter_type last_counter;
+
+        /// <summary>
+        /// The point in time when the counter of the last sample was read.
+        /// </summary>
+        mutable level_zero_device::time_point last_time;
+
+        /// <summary>
+        /// Protects <see cref="last_counter" /> and <see cref="last_time" />
+        /// against concurrent samples.
+        /// </summary>
+        mutable std::mutex lock;
+#endif /* defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO) */
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        inline level_zero_sensor_impl(void) : domain(0)
+#if defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO)
+            , first_counter { }, last_counter { }
+#endif /* defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO) */
+            { }
+
+#if defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO)
+        /// <summary>
+        /// Answer the energy in Joules that has been consumed since the sensor
+        /// was created.
+        /// </summary>
+        /// <returns>The consumed energy in Joules.</returns>
+        double energy(void) const;
+#endif /* defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO) */
+
+        /// <summary>
+        /// Obtain a new sample with a timestamp in milliseconds, which is the
+        /// interface required by the <see cref="default_sampler_context" />.
+        /// </summary>
+        /// <returns>The result of the measurement.</returns>
+        inline measurement_data sample(void) const {
+            return this->sample(timestamp_resolution::milliseconds);
+        }
+
+        /// <summary>
+        /// Obtain a new sample and create a measurement from its difference to
+        /// <see cref="last_counter" />.
+        /// </summary>
+        /// <remarks>
+        /// The power is computed from the timestamps of the counter, which are
+        /// recorded by the driver, and only falls back to the time of the
+        /// readings if the driver did not advance the timestamp.
+        /// </remarks>
+        /// <param name="resolution">The resolution of the timestamp being
+        /// created.</param>
+        /// <returns>The result of the measurement.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="resolution" /> is nanoseconds.</exception>
+        /// <exception cref="level_zero_exception">If reading the counter
+        /// failed.</exception>
+        /// <exception cref="std::runtime_error">If the library has been built
+        /// without support for Level Zero.</exception>
+        measurement_data sample(
+            _In_ const timestamp_resolution resolution) const;
+
+#if defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO)
+        /// <summary>
+        /// Opens the device with the given PCI bus ID and prepares the sensor
+        /// for sampling the given power domain.
+        /// </summary>
+        /// <param name="bus_id">The PCI bus ID of the GPU.</param>
+        /// <param name="domain">The index of the power domain.</param>
+        /// <exception cref="std::invalid_argument">If the GPU or the domain
+        /// does not exist.</exception>
+        /// <exception cref="std::runtime_error">If the Level Zero loader is
+        /// not available or if the Sysman API failed.</exception>
+        void set(_In_ const std::string& bus_id,
+            _In_ const level_zero_sensor::domain_type domain);
+#endif /* defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO) */
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
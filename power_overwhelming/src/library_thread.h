@@ -0,0 +1,48 @@
+﻿// <copyright file="library_thread.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "power_overwhelming/library_threads.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Prepares the calling thread, which has been created by the library,
+    /// according to the settings made via
+    /// <see cref="set_library_thread_affinity" /> and
+    /// <see cref="set_library_thread_priority" />.
+    /// </summary>
+    /// <remarks>
+    /// This function must be called first by every thread of the library. It
+    /// also sets the debug name of the thread and registers the thread for
+    /// <see cref="get_library_cpu_time" /> until it exits. Errors while
+    /// applying the settings are ignored, because the thread must run in any
+    /// case.
+    /// </remarks>
+    /// <param name="thread_name">The debug name of the thread.</param>
+    void enter_library_thread(const char *thread_name) noexcept;
+
+    /// <summary>
+    /// Answer the CPU time that the calling thread has consumed so far.
+    /// </summary>
+    /// <returns>The sum of the user and kernel time in nanoseconds, or zero
+    /// if the time could not be determined.</returns>
+    std::uint64_t get_thread_cpu_time(void) noexcept;
+
+    /// <summary>
+    /// Answer the CPU time that all logical CPUs of the system have spent
+    /// outside their idle loop so far.
+    /// </summary>
+    /// <returns>The busy time of the system in nanoseconds, or zero if the
+    /// time could not be determined.</returns>
+    std::uint64_t get_system_busy_time(void) noexcept;
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
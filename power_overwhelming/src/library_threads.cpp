@@ -0,0 +1,378 @@
+﻿// <copyright file="library_threads.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/library_threads.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else /* defined(_WIN32) */
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#endif /* defined(_WIN32) */
+
+#include "power_overwhelming/cpu_affinity.h"
+
+#include "library_thread.h"
+#include "thread_name.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The logical CPUs that library threads are bound to, which is empty if
+    /// they may run anywhere.
+    /// </summary>
+    static std::vector<std::uint32_t> library_thread_cpus;
+
+    /// <summary>
+    /// Protects <see cref="library_thread_cpus" />.
+    /// </summary>
+    static std::mutex library_thread_lock;
+
+    /// <summary>
+    /// The priority of library threads.
+    /// </summary>
+    static std::atomic<thread_priority> library_thread_priority(
+        thread_priority::normal);
+
+#if defined(_WIN32)
+    /// <summary>
+    /// Converts the given <see cref="FILETIME" /> span into nanoseconds.
+    /// </summary>
+    static inline std::uint64_t to_nanoseconds(_In_ const FILETIME& time) {
+        ULARGE_INTEGER retval;
+        retval.HighPart = time.dwHighDateTime;
+        retval.LowPart = time.dwLowDateTime;
+        return retval.QuadPart * 100;
+    }
+#endif /* defined(_WIN32) */
+
+    /// <summary>
+    /// Registers a library thread for measuring its CPU time as long as it
+    /// is running.
+    /// </summary>
+    class library_thread_clock final {
+
+    public:
+
+        /// <summary>
+        /// Registers the calling thread under the given name.
+        /// </summary>
+        explicit library_thread_clock(_In_z_ const char *name);
+
+        library_thread_clock(const library_thread_clock&) = delete;
+
+        /// <summary>
+        /// Moves the CPU time of the calling thread to the time of the exited
+        /// threads and unregisters it.
+        /// </summary>
+        ~library_thread_clock(void);
+
+        /// <summary>
+        /// Answer the CPU time the thread has consumed so far, which can be
+        /// called from any thread.
+        /// </summary>
+        std::uint64_t cpu_time(void) const noexcept;
+
+        /// <summary>
+        /// Answer the name of the thread.
+        /// </summary>
+        inline const char *name(void) const noexcept {
+            return this->_name;
+        }
+
+        library_thread_clock& operator =(const library_thread_clock&) = delete;
+
+    private:
+
+#if defined(_WIN32)
+        HANDLE _clock;
+#else /* defined(_WIN32) */
+        clockid_t _clock;
+        bool _valid;
+#endif /* defined(_WIN32) */
+        const char *_name;
+    };
+
+    /// <summary>
+    /// The registry of the running library threads.
+    /// </summary>
+    struct library_thread_clocks {
+        std::vector<const library_thread_clock *> clocks;
+        std::uint64_t exited;
+        std::mutex lock;
+
+        inline library_thread_clocks(void) : exited(0) { }
+
+        /// <summary>
+        /// Answer the only instance, which is never destroyed, because
+        /// library threads might exit after static objects have been
+        /// destroyed.
+        /// </summary>
+        static inline library_thread_clocks& instance(void) {
+            static auto retval = new library_thread_clocks();
+            return *retval;
+        }
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * ...::detail::library_thread_clock::library_thread_clock
+ */
+visus::power_overwhelming::detail::library_thread_clock::library_thread_clock(
+        _In_z_ const char *name) : _name(name) {
+#if defined(_WIN32)
+    // The pseudo handle of the current thread cannot be used by other threads,
+    // so we need a real one.
+    if (!::DuplicateHandle(::GetCurrentProcess(), ::GetCurrentThread(),
+            ::GetCurrentProcess(), &this->_clock,
+            THREAD_QUERY_LIMITED_INFORMATION, FALSE, 0)) {
+        this->_clock = NULL;
+    }
+#else /* defined(_WIN32) */
+    this->_valid = (::pthread_getcpuclockid(::pthread_self(), &this->_clock)
+        == 0);
+#endif /* defined(_WIN32) */
+
+    auto& r = library_thread_clocks::instance();
+    std::lock_guard<decltype(r.lock)> l(r.lock);
+    r.clocks.push_back(this);
+}
+
+
+/*
+ * ...::detail::library_thread_clock::~library_thread_clock
+ */
+visus::power_overwhelming::detail::library_thread_clock::~library_thread_clock(
+        void) {
+    auto& r = library_thread_clocks::instance();
+
+    {
+        std::lock_guard<decltype(r.lock)> l(r.lock);
+        // Move the time while holding the lock such that concurrent queries
+        // neither miss nor double-count the thread.
+        r.exited += get_thread_cpu_time();
+        auto it = std::find(r.clocks.begin(), r.clocks.end(), this);
+        if (it != r.clocks.end()) {
+            r.clocks.erase(it);
+        }
+    }
+
+#if defined(_WIN32)
+    if (this->_clock != NULL) {
+        ::CloseHandle(this->_clock);
+    }
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::library_thread_clock::cpu_time
+ */
+std::uint64_t visus::power_overwhelming::detail::library_thread_clock::cpu_time(
+        void) const noexcept {
+#if defined(_WIN32)
+    FILETIME creation, exit, kernel, user;
+    if ((this->_clock != NULL) && ::GetThreadTimes(this->_clock, &creation,
+            &exit, &kernel, &user)) {
+        return to_nanoseconds(kernel) + to_nanoseconds(user);
+    }
+#else /* defined(_WIN32) */
+    struct timespec time;
+    if (this->_valid && (::clock_gettime(this->_clock, &time) == 0)) {
+        return static_cast<std::uint64_t>(time.tv_sec) * 1000000000
+            + time.tv_nsec;
+    }
+#endif /* defined(_WIN32) */
+
+    return 0;
+}
+
+
+/*
+ * visus::power_overwhelming::get_library_cpu_time
+ */
+std::uint64_t visus::power_overwhelming::get_library_cpu_time(
+        void) noexcept {
+    auto& r = detail::library_thread_clocks::instance();
+    std::lock_guard<decltype(r.lock)> l(r.lock);
+    auto retval = r.exited;
+
+    for (auto c : r.clocks) {
+        retval += c->cpu_time();
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::get_library_thread_cpu_times
+ */
+std::size_t visus::power_overwhelming::get_library_thread_cpu_times(
+        _Out_writes_opt_(cnt) const char **out_names,
+        _Out_writes_opt_(cnt) std::uint64_t *out_times,
+        _In_ const std::size_t cnt) noexcept {
+    auto& r = detail::library_thread_clocks::instance();
+    std::lock_guard<decltype(r.lock)> l(r.lock);
+
+    for (std::size_t i = 0; (i < cnt) && (i < r.clocks.size()); ++i) {
+        if (out_names != nullptr) {
+            out_names[i] = r.clocks[i]->name();
+        }
+        if (out_times != nullptr) {
+            out_times[i] = r.clocks[i]->cpu_time();
+        }
+    }
+
+    return r.clocks.size();
+}
+
+
+/*
+ * visus::power_overwhelming::set_library_thread_affinity
+ */
+void visus::power_overwhelming::set_library_thread_affinity(
+        _In_reads_opt_(cnt) const std::uint32_t *logical_cpus,
+        _In_ const std::size_t cnt) {
+    if ((logical_cpus == nullptr) && (cnt > 0)) {
+        throw std::invalid_argument("The logical CPUs for the library threads "
+            "must not be null.");
+    }
+
+    // The threads cannot report problems with the affinity, so check at least
+    // that the CPUs exist.
+    const auto cpus = std::thread::hardware_concurrency();
+    for (std::size_t i = 0; (cpus > 0) && (i < cnt); ++i) {
+        if (logical_cpus[i] >= cpus) {
+            throw std::invalid_argument("A logical CPU for the library "
+                "threads does not exist.");
+        }
+    }
+
+    std::lock_guard<decltype(detail::library_thread_lock)> l(
+        detail::library_thread_lock);
+    detail::library_thread_cpus.assign(logical_cpus, logical_cpus + cnt);
+}
+
+
+/*
+ * visus::power_overwhelming::set_library_thread_priority
+ */
+void visus::power_overwhelming::set_library_thread_priority(
+        _In_ const thread_priority priority) noexcept {
+    detail::library_thread_priority.store(priority,
+        std::memory_order::memory_order_relaxed);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::enter_library_thread
+ */
+void visus::power_overwhelming::detail::enter_library_thread(
+        const char *thread_name) noexcept {
+    set_thread_name(thread_name);
+
+    try {
+        // The clock is destroyed when the thread exits, which moves its time
+        // to the exited threads.
+        static thread_local std::unique_ptr<library_thread_clock> clock;
+        if (clock == nullptr) {
+            clock.reset(new library_thread_clock(
+                (thread_name != nullptr) ? thread_name : ""));
+        }
+    } catch (...) { /* The thread is not accounted for if this fails. */ }
+
+    try {
+        std::lock_guard<decltype(library_thread_lock)> l(library_thread_lock);
+        if (!library_thread_cpus.empty()) {
+            set_thread_affinity(library_thread_cpus.data(),
+                library_thread_cpus.size());
+        }
+    } catch (...) { /* Run the thread on any CPU if this fails. */ }
+
+    try {
+        const auto priority = library_thread_priority.load(
+            std::memory_order::memory_order_relaxed);
+        if (priority != thread_priority::normal) {
+            set_thread_priority(priority);
+        }
+    } catch (...) { /* Run the thread at normal priority if this fails. */ }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::get_system_busy_time
+ */
+std::uint64_t visus::power_overwhelming::detail::get_system_busy_time(
+        void) noexcept {
+#if defined(_WIN32)
+    // The kernel time includes the idle time.
+    FILETIME idle, kernel, user;
+    if (::GetSystemTimes(&idle, &kernel, &user)) {
+        return to_nanoseconds(kernel) + to_nanoseconds(user)
+            - to_nanoseconds(idle);
+    }
+
+#else /* defined(_WIN32) */
+    try {
+        // The first line of /proc/stat aggregates all CPUs in clock ticks as
+        // user, nice, system, idle, iowait, irq, softirq and steal time.
+        std::ifstream stat("/proc/stat");
+        std::string cpu;
+        std::uint64_t user, nice, system, idle, iowait, irq, softirq, steal;
+        stat >> cpu >> user >> nice >> system >> idle >> iowait >> irq
+            >> softirq >> steal;
+
+        const auto ticks = ::sysconf(_SC_CLK_TCK);
+        if (stat && (cpu == "cpu") && (ticks > 0)) {
+            return (user + nice + system + irq + softirq + steal)
+                * (1000000000 / static_cast<std::uint64_t>(ticks));
+        }
+    } catch (...) { /* Report that the time is unknown. */ }
+#endif /* defined(_WIN32) */
+
+    return 0;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::get_thread_cpu_time
+ */
+std::uint64_t visus::power_overwhelming::detail::get_thread_cpu_time(
+        void) noexcept {
+#if defined(_WIN32)
+    FILETIME creation, exit, kernel, user;
+    if (::GetThreadTimes(::GetCurrentThread(), &creation, &exit, &kernel,
+            &user)) {
+        return to_nanoseconds(kernel) + to_nanoseconds(user);
+    }
+#else /* defined(_WIN32) */
+    struct timespec time;
+    if (::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) == 0) {
+        return static_cast<std::uint64_t>(time.tv_sec) * 1000000000
+            + time.tv_nsec;
+    }
+#endif /* defined(_WIN32) */
+
+    return 0;
+}
@@ -0,0 +1,124 @@
+﻿// <copyright file="machine_topology.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "machine_topology.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <tuple>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else /* defined(_WIN32) */
+#include <unistd.h>
+#endif /* defined(_WIN32) */
+
+
+#define ERROR_MSG_INVALID_CPU "The specified logical CPU does not exist."
+
+
+/*
+ * visus::power_overwhelming::detail::machine_topology::instance
+ */
+const visus::power_overwhelming::detail::machine_topology&
+visus::power_overwhelming::detail::machine_topology::instance(void) {
+    static const machine_topology instance;
+    return instance;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::machine_topology::siblings
+ */
+std::uint32_t visus::power_overwhelming::detail::machine_topology::siblings(
+        _In_ const cpu_type cpu) const {
+    if (cpu >= this->_siblings.size()) {
+        throw std::invalid_argument(ERROR_MSG_INVALID_CPU);
+    }
+
+    return this->_siblings[cpu];
+}
+
+
+/*
+ * visus::power_overwhelming::detail::machine_topology::topology
+ */
+const visus::power_overwhelming::cpu_topology&
+visus::power_overwhelming::detail::machine_topology::topology(
+        _In_ const cpu_type cpu) const {
+    if (cpu >= this->_topologies.size()) {
+        throw std::invalid_argument(ERROR_MSG_INVALID_CPU);
+    }
+
+    return this->_topologies[cpu];
+}
+
+
+/*
+ * visus::power_overwhelming::detail::machine_topology::machine_topology
+ */
+visus::power_overwhelming::detail::machine_topology::machine_topology(void)
+        : _cores(0), _dies(0), _has_model(false), _packages(0),
+        _vendor(cpu_vendor::unknown) {
+    typedef std::tuple<std::uint32_t, std::uint32_t, std::uint32_t> core_type;
+    ::memset(&this->_model, 0, sizeof(this->_model));
+
+    try {
+        cpu_info infos[2];
+        const auto cnt = get_cpu_info(infos, 2);
+        if (cnt > 0) {
+            this->_vendor = extract_cpu_vendor(infos[0]);
+        }
+        if (cnt > 1) {
+            this->_model = extract_cpu_model(infos);
+            this->_has_model = true;
+        }
+    } catch (...) {
+        // The vendor remains unknown, which sensors depending on it must
+        // handle anyway.
+    }
+
+#if defined(_WIN32)
+    const auto cpus = ::GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+#else /* defined(_WIN32) */
+    const auto cpus = (std::max)(::sysconf(_SC_NPROCESSORS_CONF), 0l);
+#endif /* defined(_WIN32) */
+
+    std::map<core_type, std::uint32_t> cores;
+    std::set<std::pair<std::uint32_t, std::uint32_t>> dies;
+    std::set<std::uint32_t> packages;
+
+    this->_topologies.reserve(static_cast<std::size_t>(cpus));
+    for (cpu_type c = 0; c < static_cast<cpu_type>(cpus); ++c) {
+        cpu_topology topology;
+
+        try {
+            topology = get_cpu_topology(c);
+        } catch (...) {
+            // Treat a CPU whose topology is unknown as a separate package, which
+            // is what the sensors would do if the topology was not available.
+            topology.package = c;
+            topology.die = c;
+            topology.core = c;
+        }
+
+        this->_topologies.push_back(topology);
+        ++cores[core_type(topology.package, topology.die, topology.core)];
+        dies.emplace(topology.package, topology.die);
+        packages.insert(topology.package);
+    }
+
+    this->_siblings.reserve(this->_topologies.size());
+    for (auto& t : this->_topologies) {
+        this->_siblings.push_back(cores[core_type(t.package, t.die, t.core)]);
+    }
+
+    this->_cores = static_cast<std::uint32_t>(cores.size());
+    this->_dies = static_cast<std::uint32_t>(dies.size());
+    this->_packages = static_cast<std::uint32_t>(packages.size());
+}
@@ -0,0 +1,152 @@
+﻿// <copyright file="machine_topology.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <vector>
+
+#include "power_overwhelming/cpu_info.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Process-wide cache of the CPU vendor, the CPU model and the topology of
+    /// all logical CPUs of the machine.
+    /// </summary>
+    /// <remarks>
+    /// <para>The information is gathered once when the instance is first
+    /// used. Sensors that need the vendor, model or topology for a specific
+    /// core, most notably the <see cref="msr_sensor" />, should use this
+    /// cache instead of <see cref="get_cpu_info" /> and
+    /// <see cref="get_cpu_topology" />, which would otherwise run CPUID and
+    /// enumerate the processor relationships for every sensor and, in order
+    /// to run CPUID on the right socket, migrate the calling thread to every
+    /// core in turn.</para>
+    /// <para>CPUID is only run on the thread that first uses the cache, as
+    /// vendor, family and model are the same for all packages of the
+    /// machine.</para>
+    /// <para>Hot-plugging CPUs is not supported, i.e. CPUs that come online
+    /// after the cache has been built have no topology.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API machine_topology final {
+
+    public:
+
+        /// <summary>
+        /// The type used to index logical CPUs.
+        /// </summary>
+        typedef std::uint32_t cpu_type;
+
+        /// <summary>
+        /// Gets the instance for the machine.
+        /// </summary>
+        /// <returns>The cache, which is built on first use.</returns>
+        static const machine_topology& instance(void);
+
+        machine_topology(const machine_topology&) = delete;
+
+        /// <summary>
+        /// Answer the number of physical cores of the machine.
+        /// </summary>
+        /// <returns>The number of cores.</returns>
+        inline std::uint32_t cores(void) const noexcept {
+            return this->_cores;
+        }
+
+        /// <summary>
+        /// Answer the number of logical CPUs of the machine.
+        /// </summary>
+        /// <returns>The number of logical CPUs.</returns>
+        inline std::uint32_t cpus(void) const noexcept {
+            return static_cast<std::uint32_t>(this->_topologies.size());
+        }
+
+        /// <summary>
+        /// Answer the number of dies of the machine.
+        /// </summary>
+        /// <returns>The number of dies.</returns>
+        inline std::uint32_t dies(void) const noexcept {
+            return this->_dies;
+        }
+
+        /// <summary>
+        /// Answer whether <see cref="model" /> is valid, i.e. whether the
+        /// CPUID function for the model is available.
+        /// </summary>
+        /// <returns><c>true</c> if the model is valid, <c>false</c>
+        /// otherwise.</returns>
+        inline bool has_model(void) const noexcept {
+            return this->_has_model;
+        }
+
+        /// <summary>
+        /// Answer the model of the CPUs.
+        /// </summary>
+        /// <returns>The CPU model if <see cref="has_model" /> is <c>true</c>,
+        /// all zeros otherwise.</returns>
+        inline const cpu_model& model(void) const noexcept {
+            return this->_model;
+        }
+
+        /// <summary>
+        /// Answer the number of CPU packages of the machine.
+        /// </summary>
+        /// <returns>The number of packages.</returns>
+        inline std::uint32_t packages(void) const noexcept {
+            return this->_packages;
+        }
+
+        /// <summary>
+        /// Answer the number of logical CPUs that share the physical core of
+        /// the given logical CPU, including the CPU itself.
+        /// </summary>
+        /// <param name="cpu">The zero-based index of the logical CPU.</param>
+        /// <returns>The number of SMT siblings of the CPU.</returns>
+        /// <exception cref="std::invalid_argument">If the logical CPU does not
+        /// exist.</exception>
+        std::uint32_t siblings(_In_ const cpu_type cpu) const;
+
+        /// <summary>
+        /// Answer the location of the given logical CPU in the topology of the
+        /// machine.
+        /// </summary>
+        /// <param name="cpu">The zero-based index of the logical CPU.</param>
+        /// <returns>The package, die and core of the CPU.</returns>
+        /// <exception cref="std::invalid_argument">If the logical CPU does not
+        /// exist.</exception>
+        const cpu_topology& topology(_In_ const cpu_type cpu) const;
+
+        /// <summary>
+        /// Answer the vendor of the CPUs.
+        /// </summary>
+        /// <returns>The CPU vendor, which is <see cref="cpu_vendor::unknown" />
+        /// if it could not be determined.</returns>
+        inline cpu_vendor vendor(void) const noexcept {
+            return this->_vendor;
+        }
+
+        machine_topology& operator =(const machine_topology&) = delete;
+
+    private:
+
+        machine_topology(void);
+
+        std::uint32_t _cores;
+        std::uint32_t _dies;
+        bool _has_model;
+        cpu_model _model;
+        std::uint32_t _packages;
+        std::vector<std::uint32_t> _siblings;
+        std::vector<cpu_topology> _topologies;
+        cpu_vendor _vendor;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,315 @@
+﻿// <copyright file="mapped_output_buffer.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "mapped_output_buffer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif /* !defined(_WIN32) */
+
+#include "power_overwhelming/convert_string.h"
+
+
+/*
+ * visus::power_overwhelming::detail::mapped_output_buffer::default_window_size
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::mapped_output_buffer::default_window_size;
+
+
+/*
+ * visus::power_overwhelming::detail::mapped_output_buffer::mapped_output_buffer
+ */
+visus::power_overwhelming::detail::mapped_output_buffer::mapped_output_buffer(
+        void)
+#if defined(_WIN32)
+    : _file(INVALID_HANDLE_VALUE), _mapping(NULL),
+#else /* defined(_WIN32) */
+    : _file(-1),
+#endif /* defined(_WIN32) */
+        _offset(0), _window(nullptr), _window_size(0) { }
+
+
+/*
+ * visus::power_overwhelming::detail::mapped_output_buffer::~mapped_output_buffer
+ */
+visus::power_overwhelming::detail::mapped_output_buffer::~mapped_output_buffer(
+        void) {
+    this->close();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::mapped_output_buffer::close
+ */
+void visus::power_overwhelming::detail::mapped_output_buffer::close(
+        void) noexcept {
+    if (!this->is_open()) {
+        return;
+    }
+
+    const auto length = this->written();
+    this->unmap();
+
+    // Remove the pre-extended part of the last window, which does not contain
+    // any data.
+#if defined(_WIN32)
+    LARGE_INTEGER end;
+    end.QuadPart = static_cast<LONGLONG>(length);
+    if (::SetFilePointerEx(this->_file, end, nullptr, FILE_BEGIN)) {
+        ::SetEndOfFile(this->_file);
+    }
+
+    ::CloseHandle(this->_file);
+    this->_file = INVALID_HANDLE_VALUE;
+#else /* defined(_WIN32) */
+    (void) ::ftruncate(this->_file, static_cast<off_t>(length));
+    ::close(this->_file);
+    this->_file = -1;
+#endif /* defined(_WIN32) */
+
+    this->_offset = 0;
+    this->_window_size = 0;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::mapped_output_buffer::is_open
+ */
+bool visus::power_overwhelming::detail::mapped_output_buffer::is_open(
+        void) const noexcept {
+#if defined(_WIN32)
+    return (this->_file != INVALID_HANDLE_VALUE);
+#else /* defined(_WIN32) */
+    return (this->_file >= 0);
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::mapped_output_buffer::open
+ */
+void visus::power_overwhelming::detail::mapped_output_buffer::open(
+        _In_z_ const wchar_t *path,
+        _In_ const std::size_t window_size) {
+    if (path == nullptr) {
+        throw std::invalid_argument("The path to the mapped output file must "
+            "not be null.");
+    }
+
+    this->close();
+
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    ::GetSystemInfo(&info);
+    const std::size_t granularity = info.dwAllocationGranularity;
+
+    this->_file = ::CreateFileW(path, GENERIC_READ | GENERIC_WRITE,
+        FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (this->_file == INVALID_HANDLE_VALUE) {
+        throw std::system_error(::GetLastError(), std::system_category());
+    }
+#else /* defined(_WIN32) */
+    const auto granularity = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+
+    auto p = power_overwhelming::convert_string<char>(path);
+    this->_file = ::open(p.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC,
+        0666);
+    if (this->_file < 0) {
+        throw std::system_error(errno, std::system_category());
+    }
+#endif /* defined(_WIN32) */
+
+    // The offsets of the windows must be aligned to the granularity, so the
+    // windows must be a multiple of it.
+    this->_window_size = (std::max)(window_size, granularity);
+    this->_window_size = (this->_window_size + granularity - 1)
+        / granularity * granularity;
+
+    try {
+        this->map(0);
+    } catch (...) {
+        this->close();
+        throw;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::mapped_output_buffer::written
+ */
+std::uint64_t visus::power_overwhelming::detail::mapped_output_buffer::written(
+        void) const noexcept {
+    return (this->_window != nullptr)
+        ? this->_offset + (this->pptr() - this->pbase())
+        : this->_offset;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::mapped_output_buffer::overflow
+ */
+visus::power_overwhelming::detail::mapped_output_buffer::int_type
+visus::power_overwhelming::detail::mapped_output_buffer::overflow(
+        _In_ int_type c) {
+    if (!this->is_open()) {
+        return traits_type::eof();
+    }
+
+    if (this->pptr() == this->epptr()) {
+        this->map(this->_offset + this->_window_size);
+    }
+
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *this->pptr() = traits_type::to_char_type(c);
+        this->pbump(1);
+        return c;
+    }
+
+    return traits_type::not_eof(c);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::mapped_output_buffer::seekoff
+ */
+visus::power_overwhelming::detail::mapped_output_buffer::pos_type
+visus::power_overwhelming::detail::mapped_output_buffer::seekoff(
+        _In_ off_type off, _In_ std::ios_base::seekdir dir,
+        _In_ std::ios_base::openmode which) {
+    if (this->is_open() && (off == 0) && (dir == std::ios_base::cur)
+            && ((which & std::ios_base::out) != 0)) {
+        return pos_type(static_cast<off_type>(this->written()));
+    }
+
+    return pos_type(off_type(-1));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::mapped_output_buffer::sync
+ */
+int visus::power_overwhelming::detail::mapped_output_buffer::sync(void) {
+    if (this->_window == nullptr) {
+        return 0;
+    }
+
+    // Only start the write-back of the pages filled so far, because the
+    // pages themselves survive a crash of the process anyway.
+    const auto cnt = static_cast<std::size_t>(this->pptr() - this->pbase());
+#if defined(_WIN32)
+    return ::FlushViewOfFile(this->_window, cnt) ? 0 : -1;
+#else /* defined(_WIN32) */
+    return ::msync(this->_window, cnt, MS_ASYNC);
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::mapped_output_buffer::xsputn
+ */
+std::streamsize
+visus::power_overwhelming::detail::mapped_output_buffer::xsputn(
+        _In_reads_(cnt) const char_type *data,
+        _In_ std::streamsize cnt) {
+    std::streamsize retval = 0;
+
+    if (!this->is_open()) {
+        return retval;
+    }
+
+    while (retval < cnt) {
+        if (this->pptr() == this->epptr()) {
+            this->map(this->_offset + this->_window_size);
+        }
+
+        const auto n = (std::min)(cnt - retval,
+            static_cast<std::streamsize>(this->epptr() - this->pptr()));
+        ::memcpy(this->pptr(), data + retval, static_cast<std::size_t>(n));
+        this->pbump(static_cast<int>(n));
+        retval += n;
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::mapped_output_buffer::map
+ */
+void visus::power_overwhelming::detail::mapped_output_buffer::map(
+        _In_ const std::uint64_t offset) {
+    assert(this->is_open());
+    assert(this->_window_size > 0);
+    const auto end = offset + this->_window_size;
+
+    this->unmap();
+    this->_offset = offset;
+
+#if defined(_WIN32)
+    // The mapping extends the file to its size.
+    this->_mapping = ::CreateFileMappingW(this->_file, nullptr,
+        PAGE_READWRITE, static_cast<DWORD>(end >> 32),
+        static_cast<DWORD>(end), nullptr);
+    if (this->_mapping == NULL) {
+        throw std::system_error(::GetLastError(), std::system_category());
+    }
+
+    auto window = ::MapViewOfFile(this->_mapping, FILE_MAP_WRITE,
+        static_cast<DWORD>(offset >> 32), static_cast<DWORD>(offset),
+        this->_window_size);
+    if (window == nullptr) {
+        auto error = ::GetLastError();
+        ::CloseHandle(this->_mapping);
+        this->_mapping = NULL;
+        throw std::system_error(error, std::system_category());
+    }
+#else /* defined(_WIN32) */
+    if (::ftruncate(this->_file, static_cast<off_t>(end)) != 0) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    auto window = ::mmap(nullptr, this->_window_size, PROT_WRITE, MAP_SHARED,
+        this->_file, static_cast<off_t>(offset));
+    if (window == MAP_FAILED) {
+        throw std::system_error(errno, std::system_category());
+    }
+#endif /* defined(_WIN32) */
+
+    this->_window = static_cast<char_type *>(window);
+    this->setp(this->_window, this->_window + this->_window_size);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::mapped_output_buffer::unmap
+ */
+void visus::power_overwhelming::detail::mapped_output_buffer::unmap(
+        void) noexcept {
+    if (this->_window != nullptr) {
+        // Remember the data written to the window before it goes away.
+        this->_offset = this->written();
+
+#if defined(_WIN32)
+        ::UnmapViewOfFile(this->_window);
+        ::CloseHandle(this->_mapping);
+        this->_mapping = NULL;
+#else /* defined(_WIN32) */
+        ::munmap(this->_window, this->_window_size);
+#endif /* defined(_WIN32) */
+
+        this->_window = nullptr;
+        this->setp(nullptr, nullptr);
+    }
+}
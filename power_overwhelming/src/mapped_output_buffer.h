@@ -0,0 +1,152 @@
+﻿// <copyright file="mapped_output_buffer.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <streambuf>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#endif /* defined(_WIN32) */
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A stream buffer that appends to a file through a memory-mapped window.
+    /// </summary>
+    /// <remarks>
+    /// <para>The buffer extends the file by <see cref="window_size" /> bytes
+    /// at a time and maps this part of the file as the put area of the
+    /// buffer, such that writing to a stream using the buffer copies the data
+    /// directly into the page cache without any system call. Once the window
+    /// is full, it is unmapped and the next part of the file is extended and
+    /// mapped.</para>
+    /// <para>Synchronising the buffer only schedules the write-back of the
+    /// modified pages asynchronously. The data are safe if the process
+    /// crashes, because the pages are owned by the operating system, but the
+    /// file might end with zero bytes from the pre-extended part of the last
+    /// window until the buffer has been closed, which truncates the file to
+    /// the data actually written.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API mapped_output_buffer final
+            : public std::streambuf {
+
+    public:
+
+        /// <summary>
+        /// The default size of the mapped window in bytes.
+        /// </summary>
+        static constexpr std::size_t default_window_size = 16 << 20;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        mapped_output_buffer(void);
+
+        mapped_output_buffer(const mapped_output_buffer&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~mapped_output_buffer(void);
+
+        /// <summary>
+        /// Unmaps the window and truncates the file to the data written.
+        /// </summary>
+        void close(void) noexcept;
+
+        /// <summary>
+        /// Answer whether a file has been opened.
+        /// </summary>
+        /// <returns><c>true</c> if the file is open, <c>false</c> otherwise.
+        /// </returns>
+        bool is_open(void) const noexcept;
+
+        /// <summary>
+        /// Creates the given file, replacing any existing content, and maps
+        /// the first window.
+        /// </summary>
+        /// <param name="path">The path to the output file.</param>
+        /// <param name="window_size">The size of the window, which will be
+        /// rounded up to the allocation granularity of the system.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="path" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::system_error">If the file could not be
+        /// created or mapped.</exception>
+        void open(_In_z_ const wchar_t *path,
+            _In_ const std::size_t window_size = default_window_size);
+
+        /// <summary>
+        /// Answer the size of the window into the file.
+        /// </summary>
+        /// <returns>The size of the window in bytes, which is zero if the
+        /// file is not open.</returns>
+        inline std::size_t window_size(void) const noexcept {
+            return this->_window_size;
+        }
+
+        /// <summary>
+        /// Answer the number of bytes written to the file so far.
+        /// </summary>
+        /// <returns>The logical size of the file in bytes.</returns>
+        std::uint64_t written(void) const noexcept;
+
+        mapped_output_buffer& operator =(const mapped_output_buffer&) = delete;
+
+    protected:
+
+        /// <inheritdoc />
+        int_type overflow(_In_ int_type c) override;
+
+        /// <summary>
+        /// Answer the current position in the file.
+        /// </summary>
+        /// <remarks>
+        /// The buffer only supports querying the position of the put area,
+        /// which is required for <c>tellp</c>, but not moving it.
+        /// </remarks>
+        pos_type seekoff(_In_ off_type off, _In_ std::ios_base::seekdir dir,
+            _In_ std::ios_base::openmode which) override;
+
+        /// <inheritdoc />
+        int sync(void) override;
+
+        /// <inheritdoc />
+        std::streamsize xsputn(_In_reads_(cnt) const char_type *data,
+            _In_ std::streamsize cnt) override;
+
+    private:
+
+        /// <summary>
+        /// Extends the file to the end of the window at
+        /// <paramref name="offset" /> and maps the window.
+        /// </summary>
+        void map(_In_ const std::uint64_t offset);
+
+        /// <summary>
+        /// Unmaps the current window, if any.
+        /// </summary>
+        void unmap(void) noexcept;
+
+#if defined(_WIN32)
+        HANDLE _file;
+        HANDLE _mapping;
+#else /* defined(_WIN32) */
+        int _file;
+#endif /* defined(_WIN32) */
+        std::uint64_t _offset;
+        char_type *_window;
+        std::size_t _window_size;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,145 @@
+﻿// <copyright file="marker_channel_listener.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "marker_channel_listener.h"
+
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+
+/*
+ * ...::detail::marker_channel_listener::default_capacity
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::marker_channel_listener::default_capacity;
+
+
+/*
+ * ...::detail::marker_channel_listener::marker_channel_listener
+ */
+visus::power_overwhelming::detail::marker_channel_listener
+::marker_channel_listener(void) noexcept
+    : _cursor(0), _header(nullptr), _lost(0) { }
+
+
+/*
+ * ...::detail::marker_channel_listener::~marker_channel_listener
+ */
+visus::power_overwhelming::detail::marker_channel_listener
+::~marker_channel_listener(void) {
+    this->close();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::marker_channel_listener::close
+ */
+void visus::power_overwhelming::detail::marker_channel_listener::close(
+        void) noexcept {
+    if (this->_header != nullptr) {
+        // Clients that keep the channel mapped can detect that their markers
+        // are not retrieved any more.
+        this->_header->active.store(0, std::memory_order_release);
+        this->_header = nullptr;
+    }
+
+    this->_segment.close();
+    this->_cursor = 0;
+    this->_lost = 0;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::marker_channel_listener::open
+ */
+void visus::power_overwhelming::detail::marker_channel_listener::open(
+        _In_z_ const wchar_t *name, _In_ const std::size_t capacity) {
+    const std::size_t max_capacity = std::size_t(1) << 20;
+    if ((capacity == 0) || (capacity > max_capacity)) {
+        throw std::invalid_argument("The capacity of the marker channel is "
+            "out of range.");
+    }
+
+    // The clients map positions to slots by masking, so the capacity must be
+    // a power of two.
+    std::size_t actual = 1;
+    while (actual < capacity) {
+        actual <<= 1;
+    }
+
+    this->close();
+    this->_segment.create(name, marker_channel_size(actual));
+
+    // Fresh segments are zero-filled, so all slots are empty and we only need
+    // to fill the header.
+    this->_header = static_cast<marker_channel_header *>(
+        this->_segment.data());
+    ::memcpy(this->_header->magic, marker_channel_magic,
+        sizeof(this->_header->magic));
+    this->_header->version = marker_channel_version;
+    this->_header->capacity = static_cast<std::uint32_t>(actual);
+    this->_header->head.store(0, std::memory_order_relaxed);
+    this->_header->active.store(1, std::memory_order_release);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::marker_channel_listener::poll
+ */
+std::size_t visus::power_overwhelming::detail::marker_channel_listener::poll(
+        _Inout_ std::vector<marker_type>& dst) {
+    if (this->_header == nullptr) {
+        return 0;
+    }
+
+    const std::uint64_t capacity = this->_header->capacity;
+    const auto mask = capacity - 1;
+    const auto slots = marker_channel_slots(this->_header);
+    const auto size = dst.size();
+
+    char text[marker_channel_slot::max_text];
+    auto head = this->_header->head.load(std::memory_order_acquire);
+
+    while (this->_cursor < head) {
+        if (head - this->_cursor > capacity) {
+            // The writers have lapped us, so the oldest markers have been
+            // overwritten.
+            this->_lost += head - capacity - this->_cursor;
+            this->_cursor = head - capacity;
+        }
+
+        auto& slot = slots[this->_cursor & mask];
+        const auto expected = this->_cursor + 1;
+
+        const auto before = slot.sequence.load(std::memory_order_acquire);
+        const auto timestamp = slot.timestamp.load(std::memory_order_relaxed);
+        ::memcpy(text, slot.text, sizeof(text));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const auto after = slot.sequence.load(std::memory_order_relaxed);
+
+        if ((before == expected) && (after == expected)) {
+            text[sizeof(text) - 1] = 0;
+            dst.emplace_back(timestamp, text);
+            ++this->_cursor;
+
+        } else if ((before > expected) || (after > expected)) {
+            // A writer of the next lap has already claimed the slot.
+            ++this->_lost;
+            ++this->_cursor;
+
+        } else {
+            // The slot is still being written, so we must retry in the next
+            // call unless the writers have lapped us in the meantime.
+            head = this->_header->head.load(std::memory_order_acquire);
+            if (head - this->_cursor <= capacity) {
+                break;
+            }
+        }
+    }
+
+    return dst.size() - size;
+}
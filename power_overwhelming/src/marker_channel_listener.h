@@ -0,0 +1,128 @@
+﻿// <copyright file="marker_channel_listener.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "power_overwhelming/marker_channel.h"
+
+#include "shared_memory_segment.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Creates the shared memory segment through which other processes send
+    /// markers using <see cref="marker_channel" /> and retrieves these
+    /// markers.
+    /// </summary>
+    /// <remarks>
+    /// The listener is not thread-safe. There must be only one listener per
+    /// channel.
+    /// </remarks>
+    class POWER_OVERWHELMING_API marker_channel_listener final {
+
+    public:
+
+        /// <summary>
+        /// The type of a marker retrieved from the channel, which is its
+        /// timestamp in 100 ns units since 1 January 1601 and its UTF-8
+        /// text.
+        /// </summary>
+        typedef std::pair<std::int64_t, std::string> marker_type;
+
+        /// <summary>
+        /// The default number of markers the channel can hold before the
+        /// oldest ones are overwritten.
+        /// </summary>
+        static constexpr std::size_t default_capacity = 1024;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        marker_channel_listener(void) noexcept;
+
+        marker_channel_listener(const marker_channel_listener&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~marker_channel_listener(void);
+
+        /// <summary>
+        /// Marks the channel inactive and closes it.
+        /// </summary>
+        void close(void) noexcept;
+
+        /// <summary>
+        /// Answer whether a channel is open.
+        /// </summary>
+        /// <returns><c>true</c> if the listener has created a channel,
+        /// <c>false</c> otherwise.</returns>
+        inline bool is_open(void) const noexcept {
+            return (this->_header != nullptr);
+        }
+
+        /// <summary>
+        /// Answer the number of markers that have been overwritten before
+        /// they could be retrieved.
+        /// </summary>
+        /// <returns>The number of lost markers since the channel has been
+        /// opened.</returns>
+        inline std::uint64_t lost(void) const noexcept {
+            return this->_lost;
+        }
+
+        /// <summary>
+        /// Creates the named channel and marks it active.
+        /// </summary>
+        /// <param name="name">The name of the channel.</param>
+        /// <param name="capacity">The number of markers the channel can hold,
+        /// which will be rounded up to the next power of two.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="name" /> is <c>nullptr</c> or empty, or if
+        /// <paramref name="capacity" /> is zero or too large.</exception>
+        /// <exception cref="std::system_error">If the channel could not be
+        /// created.</exception>
+        void open(_In_z_ const wchar_t *name,
+            _In_ const std::size_t capacity = default_capacity);
+
+        /// <summary>
+        /// Appends all markers that have been completely written since the
+        /// last call to <paramref name="dst" />.
+        /// </summary>
+        /// <remarks>
+        /// The markers are retrieved in the order in which the writers have
+        /// claimed their slots, which is not necessarily the order of their
+        /// timestamps if multiple processes write to the channel. Retrieval
+        /// stops at the first slot that is still being written unless the
+        /// writers have lapped it, in which case the marker is counted as
+        /// lost.
+        /// </remarks>
+        /// <param name="dst">Receives the new markers.</param>
+        /// <returns>The number of markers appended to
+        /// <paramref name="dst" />.</returns>
+        std::size_t poll(_Inout_ std::vector<marker_type>& dst);
+
+        marker_channel_listener& operator =(
+            const marker_channel_listener&) = delete;
+
+    private:
+
+        std::uint64_t _cursor;
+        marker_channel_header *_header;
+        std::uint64_t _lost;
+        shared_memory_segment _segment;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -7,7 +7,7 @@
 
 #include <stdexcept>
 
-#include "string_functions.h"
+#include "sensor_name_registry.h"
 
 
 /*
@@ -72,9 +72,7 @@ visus::power_overwhelming::measurement::measurement(
  * visus::power_overwhelming::measurement::~measurement
  */
 visus::power_overwhelming::measurement::~measurement(void) {
-    if (this->_sensor != nullptr) {
-        ::free(this->_sensor);
-    }
+    // Note: the name of the sensor is interned and must not be freed.
 }
 
 
@@ -85,7 +83,7 @@ visus::power_overwhelming::measurement&
 visus::power_overwhelming::measurement::operator =(const measurement& rhs) {
     if (this != std::addressof(rhs)) {
         this->_data = rhs._data;
-        detail::safe_assign(this->_sensor, rhs._sensor);
+        this->_sensor = rhs._sensor;
     }
 
     return *this;
@@ -99,7 +97,8 @@ visus::power_overwhelming::measurement&
 visus::power_overwhelming::measurement::operator =(measurement&& rhs) noexcept {
     if (this != std::addressof(rhs)) {
         this->_data = std::move(rhs._data);
-        detail::safe_assign(this->_sensor, std::move(rhs._sensor));
+        this->_sensor = rhs._sensor;
+        rhs._sensor = nullptr;
     }
 
     return *this;
@@ -123,5 +122,5 @@ void visus::power_overwhelming::measurement::set_sensor(
         throw std::invalid_argument("A valid sensor name must be specified.");
     }
 
-    detail::safe_assign(this->_sensor, sensor);
+    this->_sensor = detail::sensor_name_registry::intern(sensor);
 }
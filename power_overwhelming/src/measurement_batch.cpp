@@ -0,0 +1,475 @@
+﻿// <copyright file="measurement_batch.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/measurement_batch.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif /* defined(_WIN32) */
+
+#include "batch_kernels.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Allocates a block of <paramref name="size" /> bytes with the alignment
+    /// of the batch from the heap.
+    /// </summary>
+    static void *allocate_batch(_In_ const std::size_t size) {
+#if defined(_WIN32)
+        auto retval = ::_aligned_malloc(size, measurement_batch::alignment);
+        if (retval == nullptr) {
+            throw std::bad_alloc();
+        }
+#else /* defined(_WIN32) */
+        void *retval = nullptr;
+        if (::posix_memalign(&retval, measurement_batch::alignment, size)
+                != 0) {
+            throw std::bad_alloc();
+        }
+#endif /* defined(_WIN32) */
+
+        return retval;
+    }
+
+    /// <summary>
+    /// Returns a block from <see cref="allocate_batch" /> to the heap.
+    /// </summary>
+    static void free_batch(_In_opt_ void *block) noexcept {
+#if defined(_WIN32)
+        ::_aligned_free(block);
+#else /* defined(_WIN32) */
+        ::free(block);
+#endif /* defined(_WIN32) */
+    }
+
+    /// <summary>
+    /// Answer the number of bits set in <paramref name="word" />.
+    /// </summary>
+    static inline std::size_t count_bits(
+            _In_ measurement_batch::mask_type word) noexcept {
+        std::size_t retval = 0;
+        while (word != 0) {
+            word &= word - 1;
+            ++retval;
+        }
+        return retval;
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::measurement_batch::alignment
+ */
+constexpr std::size_t visus::power_overwhelming::measurement_batch::alignment;
+
+
+/*
+ * visus::power_overwhelming::measurement_batch::mask_bits
+ */
+constexpr std::size_t visus::power_overwhelming::measurement_batch::mask_bits;
+
+
+/*
+ * visus::power_overwhelming::measurement_batch::quantities
+ */
+constexpr std::size_t visus::power_overwhelming::measurement_batch::quantities;
+
+
+/*
+ * visus::power_overwhelming::measurement_batch::measurement_batch
+ */
+visus::power_overwhelming::measurement_batch::measurement_batch(
+        void) noexcept
+    : _block(nullptr), _capacity(0), _masks { nullptr, nullptr, nullptr },
+        _size(0), _timestamps(nullptr),
+        _values { nullptr, nullptr, nullptr } { }
+
+
+/*
+ * visus::power_overwhelming::measurement_batch::measurement_batch
+ */
+visus::power_overwhelming::measurement_batch::measurement_batch(
+        _In_ const std::size_t capacity) : measurement_batch() {
+    this->reserve(capacity);
+}
+
+
+/*
+ * visus::power_overwhelming::measurement_batch::measurement_batch
+ */
+visus::power_overwhelming::measurement_batch::measurement_batch(
+        _In_ const measurement_batch& rhs) : measurement_batch() {
+    *this = rhs;
+}
+
+
+/*
+ * visus::power_overwhelming::measurement_batch::measurement_batch
+ */
+visus::power_overwhelming::measurement_batch::measurement_batch(
+        _Inout_ measurement_batch&& rhs) noexcept : measurement_batch() {
+    *this = std::move(rhs);
+}
+
+
+/*
+ * visus::power_overwhelming::measurement_batch::~measurement_batch
+ */
+visus::power_overwhelming::measurement_batch::~measurement_batch(void) {
+    detail::free_batch(this->_block);
+}
+
+
+/*
+ * visus::power_overwhelming::measurement_batch::assign
+ */
+void visus::power_overwhelming::measurement_batch::assign(
+        _In_reads_(cnt) const measurement_data *samples,
+        _In_ const std::size_t cnt) {
+    assert((samples != nullptr) || (cnt == 0));
+    const auto current = index_of(measurement_quantity::current);
+    const auto power = index_of(measurement_quantity::power);
+    const auto voltage = index_of(measurement_quantity::voltage);
+
+    this->clear();
+    this->reserve(cnt);
+
+    for (std::size_t i = 0; i < cnt; ++i) {
+        auto& s = samples[i];
+        this->_timestamps[i] = s._timestamp;
+        this->_values[current][i] = s._current;
+        this->_values[power][i] = (s._power > static_cast<value_type>(0))
+            ? s._power
+            : measurement_data::invalid_value;
+        this->_values[voltage][i] = s._voltage;
+    }
+
+    this->_size = cnt;
+
+    if (cnt > 0) {
+        detail::multiply_missing(this->_values[power],
+            this->_values[voltage], this->_values[current], cnt,
+            measurement_data::invalid_value);
+
+        for (std::size_t q = 0; q < quantities; ++q) {
+            detail::mask_valid(this->_masks[q], this->_values[q], cnt,
+                measurement_data::invalid_value);
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::measurement_batch::clear
+ */
+void visus::power_overwhelming::measurement_batch::clear(void) noexcept {
+    this->_size = 0;
+}
+
+
+/*
+ * visus::power_overwhelming::measurement_batch::count
+ */
+std::size_t visus::power_overwhelming::measurement_batch::count(
+        _In_ const measurement_quantity quantity) const noexcept {
+    const auto mask = this->_masks[index_of(quantity)];
+    const auto words = (this->_size + mask_bits - 1) / mask_bits;
+    std::size_t retval = 0;
+
+    for (std::size_t w = 0; w < words; ++w) {
+        retval += detail::count_bits(mask[w]);
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::measurement_batch::min_max
+ */
+bool visus::power_overwhelming::measurement_batch::min_max(
+        _Out_ value_type& minimum, _Out_ value_type& maximum,
+        _In_ const measurement_quantity quantity) const noexcept {
+    if (this->_size < 1) {
+        return false;
+    }
+
+    return detail::min_max_valid(minimum, maximum,
+        this->_values[index_of(quantity)], this->_size,
+        measurement_data::invalid_value);
+}
+
+
+/*
+ * visus::power_overwhelming::measurement_batch::push_back
+ */
+void visus::power_overwhelming::measurement_batch::push_back(
+        _In_ const measurement_data& sample) {
+    if (this->_size == this->_capacity) {
+        this->reserve((std::max)(2 * this->_capacity, mask_bits));
+    }
+
+    const auto i = this->_size++;
+    const auto bit = static_cast<mask_type>(1) << (i % mask_bits);
+    const auto word = i / mask_bits;
+
+    if (bit == 1) {
+        // This is the first sample in the word, so clear any stale bits.
+        for (std::size_t q = 0; q < quantities; ++q) {
+            this->_masks[q][word] = 0;
+        }
+    }
+
+    auto power = (sample._power > static_cast<value_type>(0))
+        ? sample._power
+        : measurement_data::invalid_value;
+    if ((power == measurement_data::invalid_value)
+            && (sample._current != measurement_data::invalid_value)
+            && (sample._voltage != measurement_data::invalid_value)) {
+        power = sample._current * sample._voltage;
+    }
+
+    this->_timestamps[i] = sample._timestamp;
+    this->_values[index_of(measurement_quantity::current)][i]
+        = sample._current;
+    this->_values[index_of(measurement_quantity::power)][i] = power;
+    this->_values[index_of(measurement_quantity::voltage)][i]
+        = sample._voltage;
+
+    for (std::size_t q = 0; q < quantities; ++q) {
+        if (this->_values[q][i] != measurement_data::invalid_value) {
+            this->_masks[q][word] |= bit;
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::measurement_batch::reserve
+ */
+void visus::power_overwhelming::measurement_batch::reserve(
+        _In_ const std::size_t capacity) {
+    if (capacity <= this->_capacity) {
+        return;
+    }
+
+    // Round the capacity to full words of the mask, which makes all arrays
+    // a multiple of the alignment.
+    const auto cap = (capacity + mask_bits - 1) / mask_bits * mask_bits;
+    const auto words = cap / mask_bits;
+    const auto size_timestamps = cap * sizeof(timestamp_type);
+    const auto size_values = cap * sizeof(value_type);
+    const auto size_mask = words * sizeof(mask_type);
+    static_assert((mask_bits * sizeof(value_type)) % alignment == 0,
+        "The value arrays of full mask words are aligned.");
+
+    auto block = static_cast<std::uint8_t *>(detail::allocate_batch(
+        size_timestamps + quantities * (size_values + size_mask)));
+    auto timestamps = reinterpret_cast<timestamp_type *>(block);
+    value_type *values[quantities];
+    mask_type *masks[quantities];
+
+    for (std::size_t q = 0; q < quantities; ++q) {
+        values[q] = reinterpret_cast<value_type *>(block + size_timestamps
+            + q * size_values);
+        masks[q] = reinterpret_cast<mask_type *>(block + size_timestamps
+            + quantities * size_values + q * size_mask);
+    }
+
+    if (this->_size > 0) {
+        const auto used = (this->_size + mask_bits - 1) / mask_bits;
+        ::memcpy(timestamps, this->_timestamps,
+            this->_size * sizeof(timestamp_type));
+        for (std::size_t q = 0; q < quantities; ++q) {
+            ::memcpy(values[q], this->_values[q],
+                this->_size * sizeof(value_type));
+            ::memcpy(masks[q], this->_masks[q], used * sizeof(mask_type));
+        }
+    }
+
+    detail::free_batch(this->_block);
+    this->_block = block;
+    this->_capacity = cap;
+    this->_timestamps = timestamps;
+    std::copy(masks, masks + quantities, this->_masks);
+    std::copy(values, values + quantities, this->_values);
+}
+
+
+/*
+ * visus::power_overwhelming::measurement_batch::sum
+ */
+double visus::power_overwhelming::measurement_batch::sum(
+        _In_ const measurement_quantity quantity) const noexcept {
+    if (this->_size < 1) {
+        return 0.0;
+    }
+
+    return detail::sum_valid(this->_values[index_of(quantity)], this->_size,
+        measurement_data::invalid_value);
+}
+
+
+/*
+ * visus::power_overwhelming::measurement_batch::valid
+ */
+bool visus::power_overwhelming::measurement_batch::valid(
+        _In_ const std::size_t index,
+        _In_ const measurement_quantity quantity) const noexcept {
+    assert(index < this->_size);
+    const auto mask = this->_masks[index_of(quantity)];
+    return ((mask[index / mask_bits] >> (index % mask_bits)) & 1) != 0;
+}
+
+
+/*
+ * visus::power_overwhelming::measurement_batch::mask
+ */
+_Ret_maybenull_ const visus::power_overwhelming::measurement_batch::mask_type *
+visus::power_overwhelming::measurement_batch::mask(
+        _In_ const measurement_quantity quantity) const noexcept {
+    return this->_masks[index_of(quantity)];
+}
+
+
+/*
+ * visus::power_overwhelming::measurement_batch::values
+ */
+_Ret_maybenull_ const visus::power_overwhelming::measurement_batch::value_type *
+visus::power_overwhelming::measurement_batch::values(
+        _In_ const measurement_quantity quantity) const noexcept {
+    return this->_values[index_of(quantity)];
+}
+
+
+/*
+ * visus::power_overwhelming::measurement_batch::operator =
+ */
+visus::power_overwhelming::measurement_batch&
+visus::power_overwhelming::measurement_batch::operator =(
+        _In_ const measurement_batch& rhs) {
+    if (this != std::addressof(rhs)) {
+        this->clear();
+        this->reserve(rhs._size);
+
+        if (rhs._size > 0) {
+            const auto used = (rhs._size + mask_bits - 1) / mask_bits;
+            ::memcpy(this->_timestamps, rhs._timestamps,
+                rhs._size * sizeof(timestamp_type));
+            for (std::size_t q = 0; q < quantities; ++q) {
+                ::memcpy(this->_values[q], rhs._values[q],
+                    rhs._size * sizeof(value_type));
+                ::memcpy(this->_masks[q], rhs._masks[q],
+                    used * sizeof(mask_type));
+            }
+        }
+
+        this->_size = rhs._size;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::measurement_batch::operator =
+ */
+visus::power_overwhelming::measurement_batch&
+visus::power_overwhelming::measurement_batch::operator =(
+        _Inout_ measurement_batch&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        detail::free_batch(this->_block);
+
+        this->_block = rhs._block;
+        rhs._block = nullptr;
+        this->_capacity = rhs._capacity;
+        rhs._capacity = 0;
+        std::copy(rhs._masks, rhs._masks + quantities, this->_masks);
+        std::fill(rhs._masks, rhs._masks + quantities, nullptr);
+        this->_size = rhs._size;
+        rhs._size = 0;
+        this->_timestamps = rhs._timestamps;
+        rhs._timestamps = nullptr;
+        std::copy(rhs._values, rhs._values + quantities, this->_values);
+        std::fill(rhs._values, rhs._values + quantities, nullptr);
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::measurement_batch::operator []
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::measurement_batch::operator [](
+        _In_ const std::size_t index) const noexcept {
+    assert(index < this->_size);
+    return measurement_data(this->_timestamps[index],
+        this->_values[index_of(measurement_quantity::voltage)][index],
+        this->_values[index_of(measurement_quantity::current)][index],
+        this->_values[index_of(measurement_quantity::power)][index]);
+}
+
+
+/*
+ * visus::power_overwhelming::measurement_batch::index_of
+ */
+std::size_t visus::power_overwhelming::measurement_batch::index_of(
+        _In_ const measurement_quantity quantity) noexcept {
+    switch (quantity) {
+        case measurement_quantity::current: return 0;
+        case measurement_quantity::power: return 1;
+        default: return 2;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::measurement_batch_adapter::on_batch
+ */
+void visus::power_overwhelming::measurement_batch_adapter::on_batch(
+        _In_z_ const wchar_t *sensor,
+        _In_reads_(cnt) const measurement_data *samples,
+        _In_ const std::size_t cnt,
+        _In_opt_ void *context) {
+    // Each sampler thread reuses its own batch, which will have grown to the
+    // largest batch of the thread after a while.
+    thread_local measurement_batch batch;
+
+    auto that = static_cast<measurement_batch_adapter *>(context);
+    assert(that != nullptr);
+
+    batch.assign(samples, cnt);
+    that->_callback(sensor, batch, that->_context);
+}
+
+
+/*
+ * visus::power_overwhelming::measurement_batch_adapter::measurement_batch_adapter
+ */
+visus::power_overwhelming::measurement_batch_adapter::measurement_batch_adapter(
+        _In_ const measurement_batch_callback callback,
+        _In_opt_ void *context)
+        : _callback(callback), _context(context) {
+    if (callback == nullptr) {
+        throw std::invalid_argument("A valid callback for the batches of "
+            "samples must be provided.");
+    }
+}
@@ -26,7 +26,7 @@ visus::power_overwhelming::measurement_data::measurement_data(
         _In_ const value_type current,
         _In_ const value_type power)
     :_current(current), _power(power), _timestamp(timestamp),
-        _voltage(voltage) { }
+        _voltage(voltage), _sequence(0) { }
 
 
 /*
@@ -37,7 +37,7 @@ visus::power_overwhelming::measurement_data::measurement_data(
         _In_ const value_type voltage,
         _In_ const value_type current)
     :_current(current), _power(invalid_value), _timestamp(timestamp),
-        _voltage(voltage) {
+        _voltage(voltage), _sequence(0) {
     if (voltage == invalid_value) {
         throw std::invalid_argument("A valid voltage measurement_data must be "
             "specified.");
@@ -56,7 +56,7 @@ visus::power_overwhelming::measurement_data::measurement_data(
         _In_ const timestamp_type timestamp,
         _In_ const value_type power)
     : _current(invalid_value), _power(power), _timestamp(timestamp),
-        _voltage(invalid_value) {
+        _voltage(invalid_value), _sequence(0) {
     if (power == invalid_value) {
         throw std::invalid_argument("A valid power measurement_data must be "
             "specified.");
@@ -79,6 +79,8 @@ visus::power_overwhelming::measurement_data::operator =(
         rhs._timestamp = 0;
         this->_voltage = rhs._voltage;
         rhs._voltage = invalid_value;
+        this->_sequence = rhs._sequence;
+        rhs._sequence = 0;
     }
 
     return *this;
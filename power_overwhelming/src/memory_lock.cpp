@@ -0,0 +1,178 @@
+﻿// <copyright file="memory_lock.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "memory_lock.h"
+
+#include <cerrno>
+#include <cinttypes>
+#include <memory>
+#include <system_error>
+#include <utility>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else /* defined(_WIN32) */
+#include <sys/mman.h>
+#include <unistd.h>
+#endif /* defined(_WIN32) */
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Answer the size of a page of virtual memory.
+    /// </summary>
+    static std::size_t get_page_size(void) noexcept {
+#if defined(_WIN32)
+        SYSTEM_INFO info;
+        ::GetSystemInfo(&info);
+        return info.dwPageSize;
+#else /* defined(_WIN32) */
+        const auto retval = ::sysconf(_SC_PAGESIZE);
+        return (retval > 0) ? static_cast<std::size_t>(retval) : 4096;
+#endif /* defined(_WIN32) */
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::memory_lock::prefault
+ */
+void visus::power_overwhelming::detail::memory_lock::prefault(
+        _In_reads_bytes_(size) void *address,
+        _In_ const std::size_t size) noexcept {
+    static const auto page_size = get_page_size();
+
+    if ((address == nullptr) || (size == 0)) {
+        return;
+    }
+
+    // Reading a page is not sufficient, because a fresh page might be mapped
+    // to the shared zero page until it is written. Writing back what we read
+    // allocates the page without changing the memory.
+    auto begin = static_cast<volatile std::uint8_t *>(address);
+    const auto end = begin + size;
+    for (auto p = begin; p < end; p += page_size) {
+        *p = *p;
+    }
+    *(end - 1) = *(end - 1);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::memory_lock::memory_lock
+ */
+visus::power_overwhelming::detail::memory_lock::memory_lock(void) noexcept
+    : _address(nullptr), _size(0) { }
+
+
+/*
+ * visus::power_overwhelming::detail::memory_lock::memory_lock
+ */
+visus::power_overwhelming::detail::memory_lock::memory_lock(
+        _In_reads_bytes_(size) void *address, _In_ const std::size_t size)
+        : _address(nullptr), _size(0) {
+    if ((address == nullptr) || (size == 0)) {
+        return;
+    }
+
+    memory_lock::prefault(address, size);
+
+#if defined(_WIN32)
+    if (!::VirtualLock(address, size)) {
+        auto error = ::GetLastError();
+
+        if (error == ERROR_WORKING_SET_QUOTA) {
+            // The locked pages must fit into the minimum working set, so grow
+            // it by the size of the range plus a page for the unaligned ends.
+            auto process = ::GetCurrentProcess();
+            SIZE_T min_size, max_size;
+            if (::GetProcessWorkingSetSize(process, &min_size, &max_size)) {
+                const auto growth = size + 2 * get_page_size();
+                min_size += growth;
+                if (max_size < min_size) {
+                    max_size = min_size;
+                }
+
+                if (::SetProcessWorkingSetSize(process, min_size, max_size)
+                        && ::VirtualLock(address, size)) {
+                    error = ERROR_SUCCESS;
+                } else {
+                    error = ::GetLastError();
+                }
+            }
+        }
+
+        if (error != ERROR_SUCCESS) {
+            throw std::system_error(error, std::system_category());
+        }
+    }
+#else /* defined(_WIN32) */
+    if (::mlock(address, size) != 0) {
+        throw std::system_error(errno, std::system_category());
+    }
+#endif /* defined(_WIN32) */
+
+    this->_address = address;
+    this->_size = size;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::memory_lock::memory_lock
+ */
+visus::power_overwhelming::detail::memory_lock::memory_lock(
+        _Inout_ memory_lock&& rhs) noexcept
+        : _address(rhs._address), _size(rhs._size) {
+    rhs._address = nullptr;
+    rhs._size = 0;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::memory_lock::~memory_lock
+ */
+visus::power_overwhelming::detail::memory_lock::~memory_lock(void) {
+    this->unlock();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::memory_lock::unlock
+ */
+void visus::power_overwhelming::detail::memory_lock::unlock(void) noexcept {
+    if (this->_address != nullptr) {
+#if defined(_WIN32)
+        ::VirtualUnlock(this->_address, this->_size);
+#else /* defined(_WIN32) */
+        ::munlock(this->_address, this->_size);
+#endif /* defined(_WIN32) */
+        this->_address = nullptr;
+        this->_size = 0;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::memory_lock::operator =
+ */
+visus::power_overwhelming::detail::memory_lock&
+visus::power_overwhelming::detail::memory_lock::operator =(
+        _Inout_ memory_lock&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        this->unlock();
+        this->_address = rhs._address;
+        this->_size = rhs._size;
+        rhs._address = nullptr;
+        rhs._size = 0;
+    }
+
+    return *this;
+}
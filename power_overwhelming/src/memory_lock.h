@@ -0,0 +1,106 @@
+﻿// <copyright file="memory_lock.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstddef>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Prefaults a range of memory and locks it into physical memory for the
+    /// lifetime of the instance.
+    /// </summary>
+    /// <remarks>
+    /// <para>Locking uses <c>mlock</c> on POSIX systems and
+    /// <c>VirtualLock</c> on Windows. As the latter is limited by the minimum
+    /// working set of the process, the working set is grown as necessary
+    /// when locking the range fails for this reason.</para>
+    /// <para>The lock covers whole pages, wherefore the operating system
+    /// might count pages shared by several locked ranges only once. Ranges
+    /// must therefore not overlap with ranges locked by other means that are
+    /// unlocked independently.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API memory_lock final {
+
+    public:
+
+        /// <summary>
+        /// Writes to every page in the given range such that the pages are
+        /// backed by physical memory.
+        /// </summary>
+        /// <remarks>
+        /// The content of the memory is not changed.
+        /// </remarks>
+        /// <param name="address">The begin of the range.</param>
+        /// <param name="size">The size of the range in bytes.</param>
+        static void prefault(_In_reads_bytes_(size) void *address,
+            _In_ const std::size_t size) noexcept;
+
+        /// <summary>
+        /// Initialises a new instance that does not lock anything.
+        /// </summary>
+        memory_lock(void) noexcept;
+
+        /// <summary>
+        /// Prefaults and locks the given range.
+        /// </summary>
+        /// <param name="address">The begin of the range.</param>
+        /// <param name="size">The size of the range in bytes.</param>
+        /// <exception cref="std::system_error">If the range could not be
+        /// locked, for instance because the process lacks the privilege or
+        /// exceeds its limit of locked memory.</exception>
+        memory_lock(_In_reads_bytes_(size) void *address,
+            _In_ const std::size_t size);
+
+        memory_lock(const memory_lock&) = delete;
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        memory_lock(_Inout_ memory_lock&& rhs) noexcept;
+
+        /// <summary>
+        /// Finalises the instance, unlocking the range.
+        /// </summary>
+        ~memory_lock(void);
+
+        /// <summary>
+        /// Answer the number of bytes that are locked.
+        /// </summary>
+        /// <returns>The size of the locked range.</returns>
+        inline std::size_t size(void) const noexcept {
+            return this->_size;
+        }
+
+        /// <summary>
+        /// Unlocks the range if any.
+        /// </summary>
+        void unlock(void) noexcept;
+
+        memory_lock& operator =(const memory_lock&) = delete;
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        /// <returns><c>*this</c>.</returns>
+        memory_lock& operator =(_Inout_ memory_lock&& rhs) noexcept;
+
+    private:
+
+        void *_address;
+        std::size_t _size;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
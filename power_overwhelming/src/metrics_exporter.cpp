@@ -0,0 +1,134 @@
+﻿// <copyright file="metrics_exporter.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/metrics_exporter.h"
+
+#include <memory>
+#include <stdexcept>
+
+#include "metrics_exporter_impl.h"
+
+
+/*
+ * visus::power_overwhelming::metrics_exporter::default_port
+ */
+constexpr std::uint16_t
+visus::power_overwhelming::metrics_exporter::default_port;
+
+
+/*
+ * visus::power_overwhelming::metrics_exporter::metrics_exporter
+ */
+visus::power_overwhelming::metrics_exporter::metrics_exporter(void)
+    : _impl(new detail::metrics_exporter_impl()) { }
+
+
+/*
+ * visus::power_overwhelming::metrics_exporter::~metrics_exporter
+ */
+visus::power_overwhelming::metrics_exporter::~metrics_exporter(void) {
+    this->stop();
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::metrics_exporter::add
+ */
+void visus::power_overwhelming::metrics_exporter::add(
+        _In_ sensor& source,
+        _In_ const sensor::microseconds_type period) {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("A metrics_exporter which has been disposed "
+            "by a move operation cannot sample sensors.");
+    }
+
+    if (this->_impl->running.load()) {
+        throw std::logic_error("Sensors cannot be added to a running "
+            "metrics_exporter.");
+    }
+
+    for (auto& s : this->_impl->sources) {
+        // Every source has its own context, so the sensor would accept
+        // sampling it a second time as another subscriber.
+        if (s->source == std::addressof(source)) {
+            throw std::logic_error("The sensor is already being sampled by "
+                "the metrics_exporter.");
+        }
+    }
+
+    std::unique_ptr<detail::metrics_exporter_impl::source_type> src(
+        new detail::metrics_exporter_impl::source_type(source));
+    this->_impl->sources.reserve(this->_impl->sources.size() + 1);
+
+    source.sample_batch(detail::metrics_exporter_impl::on_batch, period,
+        src.get());
+    this->_impl->sources.push_back(std::move(src));
+}
+
+
+/*
+ * visus::power_overwhelming::metrics_exporter::render
+ */
+std::size_t visus::power_overwhelming::metrics_exporter::render(
+        _Out_writes_opt_(cnt) char *dst,
+        _In_ const std::size_t cnt) const noexcept {
+    return (this->_impl != nullptr) ? this->_impl->render(dst, cnt) : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::metrics_exporter::start
+ */
+void visus::power_overwhelming::metrics_exporter::start(
+        _In_ const std::uint16_t port,
+        _In_opt_z_ const wchar_t *address) {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("A metrics_exporter which has been disposed "
+            "by a move operation cannot be started.");
+    }
+
+    if (this->_impl->running.load()) {
+        throw std::logic_error("The metrics_exporter is already running.");
+    }
+
+    this->_impl->start(port, address);
+}
+
+
+/*
+ * visus::power_overwhelming::metrics_exporter::stop
+ */
+void visus::power_overwhelming::metrics_exporter::stop(void) noexcept {
+    if (this->_impl != nullptr) {
+        this->_impl->stop();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::metrics_exporter::operator =
+ */
+visus::power_overwhelming::metrics_exporter&
+visus::power_overwhelming::metrics_exporter::operator =(
+        _Inout_ metrics_exporter&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        this->stop();
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::metrics_exporter::operator bool
+ */
+visus::power_overwhelming::metrics_exporter::operator bool(
+        void) const noexcept {
+    return (this->_impl != nullptr);
+}
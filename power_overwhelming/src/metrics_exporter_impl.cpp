@@ -0,0 +1,527 @@
+﻿// <copyright file="metrics_exporter_impl.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "metrics_exporter_impl.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include "power_overwhelming/convert_string.h"
+
+// WinSock2.h must be included before Windows.h.
+#include "socket_functions.h"
+
+#include "latest_measurement_impl.h"
+#include "library_thread.h"
+#include "on_exit.h"
+#include "string_functions.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Renders text into a buffer of fixed size, counting the bytes that do
+    /// not fit.
+    /// </summary>
+    class metrics_writer final {
+
+    public:
+
+        inline metrics_writer(_Out_writes_opt_(cnt) char *dst,
+            _In_ const std::size_t cnt) noexcept
+            : _cnt((dst != nullptr) ? cnt : 0), _dst(dst), _position(0) { }
+
+        inline std::size_t position(void) const noexcept {
+            return this->_position;
+        }
+
+        inline void write(_In_reads_(cnt) const char *str,
+                _In_ const std::size_t cnt) noexcept {
+            if (this->_position < this->_cnt) {
+                const auto n = (std::min)(cnt, this->_cnt - this->_position);
+                ::memcpy(this->_dst + this->_position, str, n);
+            }
+            this->_position += cnt;
+        }
+
+        inline void write(_In_z_ const char *str) noexcept {
+            this->write(str, ::strlen(str));
+        }
+
+        inline void write(_In_ const std::string& str) noexcept {
+            this->write(str.data(), str.size());
+        }
+
+        void write(_In_ const double value) noexcept {
+            // OpenMetrics spells the special values differently than printf.
+            if (std::isnan(value)) {
+                this->write("NaN");
+            } else if (std::isinf(value)) {
+                this->write((value > 0.0) ? "+Inf" : "-Inf");
+            } else {
+                char buffer[metrics_exporter_impl::max_number];
+                const auto cnt = ::snprintf(buffer, sizeof(buffer), "%.10g",
+                    value);
+                if (cnt > 0) {
+                    this->write(buffer, (std::min)(
+                        static_cast<std::size_t>(cnt), sizeof(buffer) - 1));
+                }
+            }
+        }
+
+    private:
+
+        std::size_t _cnt;
+        char *_dst;
+        std::size_t _position;
+    };
+
+
+    /// <summary>
+    /// Describes a metric family exported for each sensor.
+    /// </summary>
+    struct metrics_family final {
+        const char *name;
+        const char *sample;
+        const char *type;
+        const char *unit;
+        const char *help;
+    };
+
+    /// <summary>
+    /// The metric families in the order they are rendered.
+    /// </summary>
+    static const metrics_family metrics_families[] = {
+        { "pwrowg_power_watts", "pwrowg_power_watts", "gauge", "watts",
+            "The latest electric power measured by the sensor." },
+        { "pwrowg_voltage_volts", "pwrowg_voltage_volts", "gauge", "volts",
+            "The latest voltage measured by the sensor." },
+        { "pwrowg_current_amperes", "pwrowg_current_amperes", "gauge",
+            "amperes", "The latest electric current measured by the sensor." },
+        { "pwrowg_energy_joules", "pwrowg_energy_joules_total", "counter",
+            "joules", "The energy measured by the sensor since it has been "
+            "added to the exporter." }
+    };
+
+    /// <summary>
+    /// Answer the value of the given metric family, which is NaN if it is not
+    /// available.
+    /// </summary>
+    static double metrics_value(_In_ const std::size_t family,
+            _In_ const metrics_exporter_impl::reading_type& reading) noexcept {
+        const auto invalid = measurement_data::invalid_value;
+        const auto nan = std::numeric_limits<double>::quiet_NaN();
+
+        if (!reading.sample) {
+            return nan;
+        }
+
+        switch (family) {
+            case 0:
+                return reading.sample.power();
+
+            case 1:
+                return (reading.sample.voltage() != invalid)
+                    ? reading.sample.voltage()
+                    : nan;
+
+            case 2:
+                return (reading.sample.current() != invalid)
+                    ? reading.sample.current()
+                    : nan;
+
+            default:
+                return reading.energy;
+        }
+    }
+
+    /// <summary>
+    /// Answer whether <paramref name="request" /> is a request for the
+    /// metrics.
+    /// </summary>
+    static bool is_metrics_request(_In_reads_(cnt) const char *request,
+            _In_ const std::size_t cnt) noexcept {
+        static const char prefix[] = "GET /metrics";
+        const auto len = sizeof(prefix) - 1;
+        return (cnt > len)
+            && (::memcmp(request, prefix, len) == 0)
+            && ((request[len] == ' ') || (request[len] == '?'));
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * ...::detail::metrics_exporter_impl::reading_type::reading_type
+ */
+visus::power_overwhelming::detail::metrics_exporter_impl::reading_type
+::reading_type(void) noexcept
+    : energy(0.0), sample(latest_measurement_impl::invalid_sample()) { }
+
+
+/*
+ * ...::detail::metrics_exporter_impl::source_type::source_type
+ */
+visus::power_overwhelming::detail::metrics_exporter_impl::source_type
+::source_type(_In_ sensor& source)
+        : last_energy(0.0),
+        last_sample(latest_measurement_impl::invalid_sample()),
+        source(std::addressof(source)) {
+    initialise_triple_buffer_state(this->state);
+
+    // Prepare the label in its final form such that rendering only copies it.
+    std::string name;
+    append_utf8(name, (source.name() != nullptr) ? source.name() : L"");
+
+    this->label = "{sensor=\"";
+    for (auto c : name) {
+        switch (c) {
+            case '\\': this->label += "\\\\"; break;
+            case '"': this->label += "\\\""; break;
+            case '\n': this->label += "\\n"; break;
+            default: this->label += c; break;
+        }
+    }
+    this->label += "\"}";
+}
+
+
+/*
+ * visus::power_overwhelming::detail::metrics_exporter_impl::max_number
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::metrics_exporter_impl::max_number;
+
+
+/*
+ * visus::power_overwhelming::detail::metrics_exporter_impl::on_batch
+ */
+void visus::power_overwhelming::detail::metrics_exporter_impl::on_batch(
+        _In_z_ const wchar_t *sensor,
+        _In_reads_(cnt) const measurement_data *samples,
+        _In_ const std::size_t cnt,
+        _In_opt_ void *context) {
+    auto that = static_cast<source_type *>(context);
+    assert(that != nullptr);
+
+    if ((samples == nullptr) || (cnt < 1)) {
+        return;
+    }
+
+    // Batches carry timestamps in milliseconds, which we integrate in the
+    // domain of seconds using the trapezoidal rule.
+    auto& last = that->last_sample;
+    for (std::size_t i = 0; i < cnt; ++i) {
+        auto& s = samples[i];
+        if (!s) {
+            continue;
+        }
+
+        if (last) {
+            const auto dt = static_cast<double>(s.timestamp()
+                - last.timestamp()) / 1000.0;
+            if (dt > 0.0) {
+                that->last_energy += 0.5 * dt
+                    * (static_cast<double>(s.power()) + last.power());
+            }
+        }
+
+        last = s;
+    }
+
+    const auto i = get_write_buffer_index(that->state);
+    that->buffers[i].energy = that->last_energy;
+    that->buffers[i].sample = last;
+    swap_write_buffer(that->state);
+}
+
+
+/*
+ * ...::detail::metrics_exporter_impl::metrics_exporter_impl
+ */
+visus::power_overwhelming::detail::metrics_exporter_impl
+::metrics_exporter_impl(void)
+    : listener(static_cast<std::intptr_t>(INVALID_SOCKET)), running(false) { }
+
+
+/*
+ * visus::power_overwhelming::detail::metrics_exporter_impl::capacity
+ */
+std::size_t visus::power_overwhelming::detail::metrics_exporter_impl::capacity(
+        void) const noexcept {
+    std::size_t retval = sizeof("# EOF\n");
+
+    for (auto& f : metrics_families) {
+        retval += ::strlen(f.name) * 3 + ::strlen(f.type) + ::strlen(f.unit)
+            + ::strlen(f.help) + 32;
+
+        for (auto& s : this->sources) {
+            retval += ::strlen(f.sample) + s->label.size() + max_number + 2;
+        }
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::metrics_exporter_impl::render
+ */
+std::size_t visus::power_overwhelming::detail::metrics_exporter_impl::render(
+        _Out_writes_opt_(cnt) char *dst,
+        _In_ const std::size_t cnt) noexcept {
+    metrics_writer writer(dst, cnt);
+
+    // Obtain the latest readings once such that all families are consistent.
+    for (auto& s : this->sources) {
+        if (swap_read_buffer(s->state)) {
+            s->current = s->buffers[get_read_buffer_index(s->state)];
+        }
+    }
+
+    const auto cnt_families = sizeof(metrics_families)
+        / sizeof(*metrics_families);
+    for (std::size_t f = 0; f < cnt_families; ++f) {
+        auto& family = metrics_families[f];
+        writer.write("# TYPE ");
+        writer.write(family.name);
+        writer.write(" ");
+        writer.write(family.type);
+        writer.write("\n# UNIT ");
+        writer.write(family.name);
+        writer.write(" ");
+        writer.write(family.unit);
+        writer.write("\n# HELP ");
+        writer.write(family.name);
+        writer.write(" ");
+        writer.write(family.help);
+        writer.write("\n");
+
+        for (auto& s : this->sources) {
+            const auto value = metrics_value(f, s->current);
+            if (std::isnan(value)) {
+                // Omit quantities the sensor does not measure.
+                continue;
+            }
+
+            writer.write(family.sample);
+            writer.write(s->label);
+            writer.write(" ");
+            writer.write(value);
+            writer.write("\n");
+        }
+    }
+
+    writer.write("# EOF\n");
+    return writer.position();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::metrics_exporter_impl::serve
+ */
+void visus::power_overwhelming::detail::metrics_exporter_impl::serve(void) {
+    enter_library_thread("PwrOwg Metrics Exporter Thread");
+    char request[2048];
+
+    while (this->running.load(std::memory_order_acquire)) {
+        auto peer = ::accept(static_cast<decltype(INVALID_SOCKET)>(
+            this->listener), nullptr, nullptr);
+        if (peer == INVALID_SOCKET) {
+            // This is how we are interrupted by stop().
+            continue;
+        }
+
+        const auto guard_peer = on_exit([peer](void) { close_socket(peer); });
+
+        {
+#if defined(_WIN32)
+            DWORD value = 1000;
+#else /* defined(_WIN32) */
+            timeval value = { };
+            value.tv_sec = 1;
+#endif /* defined(_WIN32) */
+            ::setsockopt(peer, SOL_SOCKET, SO_RCVTIMEO,
+                reinterpret_cast<const char *>(&value), sizeof(value));
+        }
+
+        // Read until the end of the header, which is all we need.
+        std::size_t length = 0;
+        while (length < sizeof(request)) {
+            const auto cnt = ::recv(peer, request + length,
+                static_cast<int>(sizeof(request) - length), 0);
+            if (cnt <= 0) {
+                break;
+            }
+
+            length += static_cast<std::size_t>(cnt);
+            if (std::search(request, request + length, "\r\n\r\n",
+                    "\r\n\r\n" + 4) != request + length) {
+                break;
+            }
+        }
+
+        const char *status = "404 Not Found";
+        const char *type = "text/plain; charset=utf-8";
+        std::size_t body = 0;
+
+        if (is_metrics_request(request, length)) {
+            status = "200 OK";
+            type = "application/openmetrics-text; version=1.0.0; "
+                "charset=utf-8";
+            body = (std::min)(this->render(this->response.data(),
+                this->response.size()), this->response.size());
+        }
+
+        char header[256];
+        const auto cnt = ::snprintf(header, sizeof(header),
+            "HTTP/1.1 %s\r\n"
+            "Content-Type: %s\r\n"
+            "Content-Length: %zu\r\n"
+            "Connection: close\r\n"
+            "\r\n", status, type, body);
+        assert(cnt > 0);
+
+        ::send(peer, header, cnt, MSG_NOSIGNAL);
+        std::size_t sent = 0;
+        while (sent < body) {
+            const auto n = ::send(peer, this->response.data() + sent,
+                static_cast<int>(body - sent), MSG_NOSIGNAL);
+            if (n == SOCKET_ERROR) {
+                break;
+            }
+            sent += static_cast<std::size_t>(n);
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::metrics_exporter_impl::start
+ */
+void visus::power_overwhelming::detail::metrics_exporter_impl::start(
+        _In_ const std::uint16_t port,
+        _In_opt_z_ const wchar_t *address) {
+    assert(!this->running.load());
+
+#if defined(_WIN32)
+    {
+        WSADATA wsa_data = { };
+        auto status = ::WSAStartup(MAKEWORD(2, 2), &wsa_data);
+        if (status != 0) {
+            throw std::system_error(status, std::system_category());
+        }
+    }
+
+    auto guard_wsa_cleanup = on_exit([](void) { ::WSACleanup(); });
+#endif /* defined(_WIN32) */
+
+    addrinfo hints = { };
+    hints.ai_family = (address != nullptr) ? AF_UNSPEC : AF_INET;
+    hints.ai_flags = AI_PASSIVE;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+
+    const auto host = power_overwhelming::convert_string<char>(address);
+    const auto service = std::to_string(port);
+    addrinfo *addresses = nullptr;
+    const auto status = ::getaddrinfo((address != nullptr)
+        ? host.c_str()
+        : nullptr, service.c_str(), &hints, &addresses);
+    if (status != 0) {
+#if defined(_WIN32)
+        throw std::system_error(status, std::system_category());
+#else /* defined(_WIN32) */
+        throw std::runtime_error(::gai_strerror(status));
+#endif /* defined(_WIN32) */
+    }
+
+    const auto guard_addresses = on_exit([addresses](void) {
+        ::freeaddrinfo(addresses);
+    });
+
+    auto listener = ::socket(addresses->ai_family, addresses->ai_socktype,
+        addresses->ai_protocol);
+    if (listener == INVALID_SOCKET) {
+        throw std::system_error(get_socket_error(), std::system_category());
+    }
+
+    auto guard_listener = on_exit([listener](void) {
+        close_socket(listener);
+    });
+
+#if !defined(_WIN32)
+    // Allow for restarting the exporter while old connections linger. On
+    // Windows, this would allow other processes to steal the port.
+    {
+        int value = 1;
+        ::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR,
+            reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+#endif /* !defined(_WIN32) */
+
+    if (::bind(listener, addresses->ai_addr,
+            static_cast<int>(addresses->ai_addrlen)) == SOCKET_ERROR) {
+        throw std::system_error(get_socket_error(), std::system_category());
+    }
+
+    if (::listen(listener, SOMAXCONN) == SOCKET_ERROR) {
+        throw std::system_error(get_socket_error(), std::system_category());
+    }
+
+    // This is the only allocation for serving the metrics, because the
+    // sensors cannot change while the server is running.
+    this->response.resize(this->capacity());
+
+    this->listener = static_cast<std::intptr_t>(listener);
+    this->running.store(true, std::memory_order_release);
+
+    try {
+        this->server = std::thread(&metrics_exporter_impl::serve, this);
+    } catch (...) {
+        this->running.store(false, std::memory_order_release);
+        this->listener = static_cast<std::intptr_t>(INVALID_SOCKET);
+        throw;
+    }
+
+    guard_listener.cancel();
+#if defined(_WIN32)
+    guard_wsa_cleanup.cancel();
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::metrics_exporter_impl::stop
+ */
+void visus::power_overwhelming::detail::metrics_exporter_impl::stop(
+        void) noexcept {
+    if (this->running.exchange(false, std::memory_order_acq_rel)) {
+        // Closing the socket interrupts the server blocking in accept.
+        close_socket(static_cast<decltype(INVALID_SOCKET)>(this->listener));
+        this->listener = static_cast<std::intptr_t>(INVALID_SOCKET);
+        this->server.join();
+#if defined(_WIN32)
+        ::WSACleanup();
+#endif /* defined(_WIN32) */
+    }
+
+    for (auto& s : this->sources) {
+        try {
+            s->source->sample_batch(nullptr,
+                sensor::default_sampling_period, s.get());
+        } catch (...) { /* Ignore this, we need to stop all. */ }
+    }
+    this->sources.clear();
+}
@@ -0,0 +1,138 @@
+﻿// <copyright file="metrics_exporter_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cinttypes>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "power_overwhelming/measurement_data.h"
+#include "power_overwhelming/sensor.h"
+
+#include "triple_buffering.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The private state of a <see cref="metrics_exporter" />.
+    /// </summary>
+    struct metrics_exporter_impl final {
+
+        /// <summary>
+        /// The values of a sensor that are published to the server.
+        /// </summary>
+        struct reading_type {
+            double energy;
+            measurement_data sample;
+
+            reading_type(void) noexcept;
+        };
+
+        /// <summary>
+        /// The state of a single sensor.
+        /// </summary>
+        /// <remarks>
+        /// The members prefixed with <c>last</c> are only accessed by the
+        /// sampler thread of the sensor, <see cref="current" /> is only
+        /// accessed by the thread rendering the metrics.
+        /// </remarks>
+        struct source_type {
+            std::array<reading_type, 3> buffers;
+            reading_type current;
+            std::string label;
+            double last_energy;
+            measurement_data last_sample;
+            sensor *source;
+            triple_buffer_state state;
+
+            explicit source_type(_In_ sensor& source);
+        };
+
+        /// <summary>
+        /// The maximum number of bytes a single value is formatted into.
+        /// </summary>
+        static constexpr std::size_t max_number = 32;
+
+        /// <summary>
+        /// The batch callback that is registered with the sensors, which
+        /// integrates the energy and publishes the last sample of the batch.
+        /// </summary>
+        static void on_batch(_In_z_ const wchar_t *sensor,
+            _In_reads_(cnt) const measurement_data *samples,
+            _In_ const std::size_t cnt,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// The socket accepting the scrapes, which is stored as integer such
+        /// that we do not need to expose the socket API.
+        /// </summary>
+        std::intptr_t listener;
+
+        /// <summary>
+        /// The pre-allocated buffer the response is rendered into.
+        /// </summary>
+        std::vector<char> response;
+
+        /// <summary>
+        /// Indicates whether the <see cref="server" /> should continue
+        /// accepting requests.
+        /// </summary>
+        std::atomic<bool> running;
+
+        /// <summary>
+        /// The thread executing <see cref="serve" />.
+        /// </summary>
+        std::thread server;
+
+        /// <summary>
+        /// The sensors being exported.
+        /// </summary>
+        std::vector<std::unique_ptr<source_type>> sources;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        metrics_exporter_impl(void);
+
+        /// <summary>
+        /// Answer an upper bound for the size of the metrics.
+        /// </summary>
+        std::size_t capacity(void) const noexcept;
+
+        /// <summary>
+        /// Renders the metrics of all sensors into the given buffer without
+        /// allocating any memory.
+        /// </summary>
+        std::size_t render(_Out_writes_opt_(cnt) char *dst,
+            _In_ const std::size_t cnt) noexcept;
+
+        /// <summary>
+        /// The body of the <see cref="server" /> thread.
+        /// </summary>
+        void serve(void);
+
+        /// <summary>
+        /// Starts accepting requests on the given address.
+        /// </summary>
+        void start(_In_ const std::uint16_t port,
+            _In_opt_z_ const wchar_t *address);
+
+        /// <summary>
+        /// Stops the server and the sampling of all sensors.
+        /// </summary>
+        void stop(void) noexcept;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,65 @@
+﻿// <copyright file="msr_channel.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/msr_channel.h"
+
+#include <stdexcept>
+#include <string>
+
+
+/*
+ * visus::power_overwhelming::parse_msr_channel
+ */
+visus::power_overwhelming::msr_channel
+visus::power_overwhelming::parse_msr_channel(_In_z_ const wchar_t *str) {
+    if (str == nullptr) {
+        throw std::invalid_argument("Only a valid string can be parsed into an "
+            "msr_channel.");
+    }
+
+    const std::wstring s(str);
+#define _FROM_STRING_CASE(v) else if (to_string(msr_channel::v) == s) \
+    return msr_channel::v
+
+    if (false);
+    _FROM_STRING_CASE(aperf);
+    _FROM_STRING_CASE(mperf);
+    _FROM_STRING_CASE(package_thermal_status);
+    _FROM_STRING_CASE(package_throttling);
+    _FROM_STRING_CASE(pp0_throttling);
+    _FROM_STRING_CASE(dram_throttling);
+    _FROM_STRING_CASE(core_limit_reasons);
+    else throw std::invalid_argument("The given string represents no "
+        "valid msr_channel");
+
+#undef _FROM_STRING_CASE
+}
+
+
+/*
+ * visus::power_overwhelming::to_string
+ */
+_Ret_z_ const wchar_t *visus::power_overwhelming::to_string(
+        _In_ const msr_channel channel) {
+#define _GCC_IS_SHIT(v) L##v
+#define _TO_STRING_CASE(v) case msr_channel::v: return _GCC_IS_SHIT(#v)
+
+    switch (channel) {
+        _TO_STRING_CASE(aperf);
+        _TO_STRING_CASE(mperf);
+        _TO_STRING_CASE(package_thermal_status);
+        _TO_STRING_CASE(package_throttling);
+        _TO_STRING_CASE(pp0_throttling);
+        _TO_STRING_CASE(dram_throttling);
+        _TO_STRING_CASE(core_limit_reasons);
+
+        default:
+            throw std::invalid_argument("The specified MSR channel is "
+                "unknown. Make sure to add all new channels in to_string.");
+    }
+
+#undef _GCC_IS_SHIT
+#undef _TO_STRING_CASE
+}
@@ -5,9 +5,34 @@
 
 #include "msr_device.h"
 
+#include <cassert>
+#include <system_error>
+#include <vector>
+
+#if defined(_WIN32)
+#include <winioctl.h>
+#endif /* defined(_WIN32) */
+
 #include "io_util.h"
 
 
+#if defined(_WIN32)
+/// <summary>
+/// The I/O control code for reading multiple registers at once, which must
+/// match the definition in <c>RaplIoctl.h</c> of the driver.
+/// </summary>
+#define IOCTL_RAPL_READ_MSRS CTL_CODE(0x8000, 0x800, METHOD_BUFFERED,\
+    FILE_READ_ACCESS)
+
+/// <summary>
+/// The I/O control code for reading registers of multiple cores at once,
+/// which must match the definition in <c>RaplIoctl.h</c> of the driver.
+/// </summary>
+#define IOCTL_RAPL_READ_CORE_MSRS CTL_CODE(0x8000, 0x801, METHOD_BUFFERED,\
+    FILE_READ_ACCESS)
+#endif /* defined(_WIN32) */
+
+
 /*
  * visus::power_overwhelming::detail::msr_device::path
  */
@@ -36,7 +61,8 @@ visus::power_overwhelming::detail::msr_device::invalid_handle_value;
 visus::power_overwhelming::detail::msr_device::msr_device(
         _In_ const string_type& path)
 #if defined(_WIN32)
-    : _handle(detail::open(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+    : _batch_supported(true), _cores_supported(true),
+        _handle(detail::open(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
         OPEN_EXISTING, 0)) { }
 #else /* defined(_WIN32) */
     : _handle(detail::open(path.c_str(), O_RDONLY)) { }
@@ -72,15 +98,110 @@ visus::power_overwhelming::detail::msr_device::~msr_device(void) noexcept {
 visus::power_overwhelming::detail::msr_device::sample_type
 visus::power_overwhelming::detail::msr_device::read(
         _In_ const std::streamoff where) const {
+    sample_type retval;
+    detail::read_bytes_at(this->_handle, &retval, sizeof(retval), where);
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::msr_device::read
+ */
+void visus::power_overwhelming::detail::msr_device::read(
+        _In_reads_(cnt) const std::streamoff *where,
+        _Out_writes_(cnt) sample_type *dst,
+        _In_ const std::size_t cnt) const {
+    assert((where != nullptr) || (cnt == 0));
+    assert((dst != nullptr) || (cnt == 0));
+
+#if defined(_WIN32)
+    if (this->_batch_supported && (cnt > 1)) {
+        // The driver expects 32-bit register indices, which is what the file
+        // offsets actually are.
+        std::vector<std::uint32_t> registers(cnt);
+        for (std::size_t i = 0; i < cnt; ++i) {
+            registers[i] = static_cast<std::uint32_t>(where[i]);
+        }
+
+        DWORD read = 0;
+        const auto size = static_cast<DWORD>(cnt * sizeof(sample_type));
+        if (::DeviceIoControl(this->_handle, IOCTL_RAPL_READ_MSRS,
+                registers.data(),
+                static_cast<DWORD>(registers.size() * sizeof(std::uint32_t)),
+                dst, size, &read, nullptr)) {
+            if (read == size) {
+                return;
+            }
+
+            throw std::system_error(ERROR_NO_MORE_ITEMS,
+                std::system_category());
+
+        } else {
+            auto error = ::GetLastError();
+            if (error != ERROR_INVALID_FUNCTION) {
+                throw std::system_error(error, std::system_category());
+            }
+
+            // This is an old driver which cannot read multiple registers at
+            // once, so do not try again and read them one by one.
+            this->_batch_supported = false;
+        }
+    }
+#endif /* defined(_WIN32) */
+
+    for (std::size_t i = 0; i < cnt; ++i) {
+        dst[i] = this->read(where[i]);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::msr_device::read_cores
+ */
+bool visus::power_overwhelming::detail::msr_device::read_cores(
+        _In_reads_(cnt) const core_register *registers,
+        _Out_writes_(cnt) sample_type *dst,
+        _In_ const std::size_t cnt) const {
+    static_assert(sizeof(core_register) == 2 * sizeof(std::uint32_t),
+        "The layout of core_register matches RAPL_CORE_MSR.");
+    assert((registers != nullptr) || (cnt == 0));
+    assert((dst != nullptr) || (cnt == 0));
+
 #if defined(_WIN32)
-    constexpr auto seek_origin = win32_seek_origin::begin;
+    if (!this->_cores_supported) {
+        return false;
+    }
+
+    if (cnt == 0) {
+        return true;
+    }
+
+    DWORD read = 0;
+    const auto size = static_cast<DWORD>(cnt * sizeof(sample_type));
+    if (::DeviceIoControl(this->_handle, IOCTL_RAPL_READ_CORE_MSRS,
+            const_cast<core_register *>(registers),
+            static_cast<DWORD>(cnt * sizeof(core_register)),
+            dst, size, &read, nullptr)) {
+        if (read == size) {
+            return true;
+        }
+
+        throw std::system_error(ERROR_NO_MORE_ITEMS, std::system_category());
+
+    } else {
+        auto error = ::GetLastError();
+        if (error != ERROR_INVALID_FUNCTION) {
+            throw std::system_error(error, std::system_category());
+        }
+
+        // This is an old driver which cannot read multiple cores at once.
+        this->_cores_supported = false;
+        return false;
+    }
+
 #else /* defined(_WIN32) */
-    constexpr auto seek_origin = posix_seek_origin::begin;
+    return false;
 #endif /* defined(_WIN32) */
-    sample_type retval;
-    detail::seek(this->_handle, where, seek_origin);
-    detail::read_bytes(this->_handle, &retval, sizeof(retval));
-    return retval;
 }
 
 
@@ -100,6 +221,10 @@ visus::power_overwhelming::detail::msr_device&
 visus::power_overwhelming::detail::msr_device::operator =(
         _In_ msr_device&& rhs) noexcept {
     if (this != std::addressof(rhs)) {
+#if defined(_WIN32)
+        this->_batch_supported = rhs._batch_supported;
+        this->_cores_supported = rhs._cores_supported;
+#endif /* defined(_WIN32) */
         this->_handle = rhs._handle;
         rhs._handle = invalid_handle_value;
     }
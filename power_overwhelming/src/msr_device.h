@@ -38,6 +38,19 @@ namespace detail {
         /// </summary>
         typedef msr_sensor::core_type core_type;
 
+        /// <summary>
+        /// Identifies a register of a specific core in a request to
+        /// <see cref="read_cores" />.
+        /// </summary>
+        /// <remarks>
+        /// The layout of this structure must match <c>RAPL_CORE_MSR</c> in
+        /// <c>RaplIoctl.h</c> of the driver.
+        /// </remarks>
+        struct core_register {
+            std::int32_t core;
+            std::uint32_t index;
+        };
+
         /// <summary>
         /// The native type of the file handle.
         /// </summary>
@@ -110,6 +123,51 @@ namespace detail {
         /// </exception>
         sample_type read(_In_ const std::streamoff where) const;
 
+        /// <summary>
+        /// Reads multiple samples from the file.
+        /// </summary>
+        /// <remarks>
+        /// <para>On Windows, this method tries reading all registers in a
+        /// single request to the driver and falls back to reading them one by
+        /// one if the driver does not support this. On Linux, each register is
+        /// read by a single positional read.</para>
+        /// </remarks>
+        /// <param name="where">The offsets into the file where to read. This
+        /// must hold at least <paramref name="cnt" /> elements.</param>
+        /// <param name="dst">Receives the content of the MSR file at the
+        /// offsets in <paramref name="where" />. This must hold at least
+        /// <paramref name="cnt" /> elements.</param>
+        /// <param name="cnt">The number of registers to read.</param>
+        /// <exception cref="std::system_error">If reading the MSR file failed.
+        /// </exception>
+        void read(_In_reads_(cnt) const std::streamoff *where,
+            _Out_writes_(cnt) sample_type *dst,
+            _In_ const std::size_t cnt) const;
+
+        /// <summary>
+        /// Reads registers of arbitrary cores in a single request.
+        /// </summary>
+        /// <remarks>
+        /// <para>This is only supported by the Windows driver, which reads the
+        /// registers by running a DPC on each of the requested cores. The
+        /// registers are checked against the ones supported by the core of
+        /// this device. On Linux and with old drivers, the method returns
+        /// <c>false</c> without reading anything and callers need to fall back
+        /// to reading the devices of the individual cores.</para>
+        /// </remarks>
+        /// <param name="registers">The cores and registers to read. This must
+        /// hold at least <paramref name="cnt" /> elements.</param>
+        /// <param name="dst">Receives the content of the registers. This must
+        /// hold at least <paramref name="cnt" /> elements.</param>
+        /// <param name="cnt">The number of registers to read.</param>
+        /// <returns><c>true</c> if the registers have been read, <c>false</c>
+        /// if the request is not supported.</returns>
+        /// <exception cref="std::system_error">If reading the registers
+        /// failed.</exception>
+        bool read_cores(_In_reads_(cnt) const core_register *registers,
+            _Out_writes_(cnt) sample_type *dst,
+            _In_ const std::size_t cnt) const;
+
         /// <summary>
         /// Reads the whole content of the file
         /// </summary>
@@ -149,6 +207,10 @@ namespace detail {
 
     private:
 
+#if defined(_WIN32)
+        mutable bool _batch_supported;
+        mutable bool _cores_supported;
+#endif /* defined(_WIN32) */
         handle_type _handle;
     };
 
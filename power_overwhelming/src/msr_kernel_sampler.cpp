@@ -0,0 +1,151 @@
+﻿// <copyright file="msr_kernel_sampler.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "msr_kernel_sampler.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <winioctl.h>
+#endif /* defined(_WIN32) */
+
+#include "io_util.h"
+
+
+#if defined(_WIN32)
+/// <summary>
+/// The I/O control code for starting the kernel-mode sampler, which must
+/// match the definition in <c>RaplIoctl.h</c> of the driver.
+/// </summary>
+#define IOCTL_RAPL_SAMPLE CTL_CODE(0x8000, 0x802, METHOD_OUT_DIRECT,\
+    FILE_READ_ACCESS)
+#endif /* defined(_WIN32) */
+
+
+/*
+ * visus::power_overwhelming::detail::msr_kernel_sampler::min_interval
+ */
+constexpr visus::power_overwhelming::detail::msr_kernel_sampler::interval_type
+visus::power_overwhelming::detail::msr_kernel_sampler::min_interval;
+
+
+/*
+ * visus::power_overwhelming::detail::msr_kernel_sampler::msr_kernel_sampler
+ */
+visus::power_overwhelming::detail::msr_kernel_sampler::msr_kernel_sampler(
+        _In_ const core_type core,
+        _In_reads_(cnt) const core_register *registers,
+        _In_ const std::size_t cnt,
+        _In_ const interval_type interval,
+        _In_ const std::size_t capacity)
+    : _capacity(capacity), _count(cnt), _lost(0), _read(0), _ring(nullptr),
+        _scratch(cnt + 1) {
+    if ((registers == nullptr) || (cnt == 0)) {
+        throw std::invalid_argument("At least one register must be sampled.");
+    }
+    if (interval < min_interval) {
+        throw std::invalid_argument("The sampling interval is too short for "
+            "the kernel-mode sampler.");
+    }
+    if (capacity < 2) {
+        throw std::invalid_argument("The ring must hold at least two "
+            "readings.");
+    }
+
+#if defined(_WIN32)
+    // The request remains pending while the sampler is running, so the
+    // device must be opened for overlapped I/O, which is why we cannot use
+    // the msr_device of the core.
+    const auto path = msr_device::path(core);
+    this->_handle = detail::open(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+        OPEN_EXISTING, FILE_FLAG_OVERLAPPED);
+
+    ::ZeroMemory(&this->_overlapped, sizeof(this->_overlapped));
+    this->_overlapped.hEvent = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (this->_overlapped.hEvent == NULL) {
+        const auto error = ::GetLastError();
+        ::CloseHandle(this->_handle);
+        throw std::system_error(error, std::system_category());
+    }
+
+    // The ring must be page-aligned and zero-initialised, which is what
+    // VirtualAlloc gives us.
+    const auto size = sizeof(ring_header)
+        + capacity * (cnt + 1) * sizeof(std::uint64_t);
+    this->_ring = ::VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE,
+        PAGE_READWRITE);
+    if (this->_ring == nullptr) {
+        const auto error = ::GetLastError();
+        ::CloseHandle(this->_overlapped.hEvent);
+        ::CloseHandle(this->_handle);
+        throw std::system_error(error, std::system_category());
+    }
+
+    // The configuration is the period and a reserved field, followed by the
+    // registers.
+    std::vector<std::uint8_t> config(2 * sizeof(std::uint32_t)
+        + cnt * sizeof(core_register));
+    const auto period = static_cast<std::uint32_t>(interval.count());
+    std::memcpy(config.data(), &period, sizeof(period));
+    std::memcpy(config.data() + 2 * sizeof(std::uint32_t), registers,
+        cnt * sizeof(core_register));
+
+    if (::DeviceIoControl(this->_handle, IOCTL_RAPL_SAMPLE,
+            config.data(), static_cast<DWORD>(config.size()),
+            this->_ring, static_cast<DWORD>(size), nullptr,
+            &this->_overlapped)) {
+        // The request must not complete before it is cancelled.
+        ::VirtualFree(this->_ring, 0, MEM_RELEASE);
+        ::CloseHandle(this->_overlapped.hEvent);
+        ::CloseHandle(this->_handle);
+        throw std::system_error(ERROR_INVALID_FUNCTION,
+            std::system_category());
+    }
+
+    const auto error = ::GetLastError();
+    if (error != ERROR_IO_PENDING) {
+        ::VirtualFree(this->_ring, 0, MEM_RELEASE);
+        ::CloseHandle(this->_overlapped.hEvent);
+        ::CloseHandle(this->_handle);
+        throw std::system_error(error, std::system_category());
+    }
+
+#else /* defined(_WIN32) */
+    throw std::system_error(ENOTSUP, std::system_category());
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::msr_kernel_sampler::~msr_kernel_sampler
+ */
+visus::power_overwhelming::detail::msr_kernel_sampler::~msr_kernel_sampler(
+        void) noexcept {
+#if defined(_WIN32)
+    // The ring must not be freed before the driver has completed the request,
+    // because the memory is locked while the request is pending.
+    DWORD transferred = 0;
+    ::CancelIoEx(this->_handle, &this->_overlapped);
+    ::GetOverlappedResult(this->_handle, &this->_overlapped, &transferred,
+        TRUE);
+
+    ::VirtualFree(this->_ring, 0, MEM_RELEASE);
+    ::CloseHandle(this->_overlapped.hEvent);
+    ::CloseHandle(this->_handle);
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::msr_kernel_sampler::missed
+ */
+std::uint64_t visus::power_overwhelming::detail::msr_kernel_sampler::missed(
+        void) const noexcept {
+    return static_cast<std::uint64_t>(this->header()->missed);
+}
@@ -0,0 +1,172 @@
+﻿// <copyright file="msr_kernel_sampler.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <cinttypes>
+#include <chrono>
+#include <vector>
+
+#include "msr_device.h"
+#include "timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Consumes the readings of the kernel-mode sampler of the RAPL driver,
+    /// which periodically reads registers of arbitrary cores on a
+    /// high-resolution timer and writes them to a ring buffer that is shared
+    /// with the user-mode process.
+    /// </summary>
+    /// <remarks>
+    /// <para>The ring is owned by this object and passed to the driver as the
+    /// output buffer of a request that remains pending until the object is
+    /// destroyed. Consuming the readings therefore does not need any system
+    /// call, and each reading carries the precise time of the tick in the
+    /// kernel.</para>
+    /// <para>The kernel-mode sampler is only available on Windows. On other
+    /// platforms, the constructor always fails.</para>
+    /// <para>Instances are not thread-safe and must only be drained by a
+    /// single thread.</para>
+    /// </remarks>
+    class msr_kernel_sampler final {
+
+    public:
+
+        /// <summary>
+        /// Identifies a register of a specific core.
+        /// </summary>
+        typedef msr_device::core_register core_register;
+
+        /// <summary>
+        /// The type used to identify a CPU core.
+        /// </summary>
+        typedef msr_device::core_type core_type;
+
+        /// <summary>
+        /// The type to express sampling intervals.
+        /// </summary>
+        typedef std::chrono::microseconds interval_type;
+
+        /// <summary>
+        /// The type of data read from the registers.
+        /// </summary>
+        typedef msr_device::sample_type sample_type;
+
+        /// <summary>
+        /// The shortest sampling interval the driver accepts, which must match
+        /// <c>RAPL_MIN_SAMPLING_PERIOD</c> in <c>RaplIoctl.h</c>.
+        /// </summary>
+        static constexpr interval_type min_interval = interval_type(50);
+
+        /// <summary>
+        /// Starts sampling the given registers in the kernel.
+        /// </summary>
+        /// <param name="core">The core of the device the request is issued
+        /// on, which determines the registers the driver accepts.</param>
+        /// <param name="registers">The registers to sample. This must hold at
+        /// least <paramref name="cnt" /> elements.</param>
+        /// <param name="cnt">The number of registers to sample, which must be
+        /// positive.</param>
+        /// <param name="interval">The sampling interval, which must be at
+        /// least <see cref="min_interval" />.</param>
+        /// <param name="capacity">The number of readings the ring can hold,
+        /// which must be at least two.</param>
+        /// <exception cref="std::invalid_argument">If any of the parameters
+        /// is invalid.</exception>
+        /// <exception cref="std::system_error">If the kernel-mode sampler
+        /// could not be started, e.g. because the driver does not support it.
+        /// </exception>
+        msr_kernel_sampler(_In_ const core_type core,
+            _In_reads_(cnt) const core_register *registers,
+            _In_ const std::size_t cnt,
+            _In_ const interval_type interval,
+            _In_ const std::size_t capacity);
+
+        msr_kernel_sampler(const msr_kernel_sampler&) = delete;
+
+        /// <summary>
+        /// Stops the kernel-mode sampler and finalises the instance.
+        /// </summary>
+        ~msr_kernel_sampler(void) noexcept;
+
+        /// <summary>
+        /// Invokes <paramref name="callback" /> for all readings that have not
+        /// yet been consumed.
+        /// </summary>
+        /// <typeparam name="TCallback">The type of the callback, which must
+        /// accept the <see cref="FILETIME" /> of the reading and a pointer to
+        /// the values of all registers in the order they have been passed to
+        /// the constructor.</typeparam>
+        /// <param name="callback">The callback to be invoked.</param>
+        /// <returns>The number of readings that have been consumed.</returns>
+        template<class TCallback>
+        std::size_t drain(_In_ TCallback callback);
+
+        /// <summary>
+        /// Answer the number of readings that have been overwritten before
+        /// they could be consumed.
+        /// </summary>
+        /// <returns>The number of lost readings.</returns>
+        inline std::uint64_t lost(void) const noexcept {
+            return this->_lost;
+        }
+
+        /// <summary>
+        /// Answer the number of ticks the driver has skipped, because the
+        /// registers of the previous tick were still being read.
+        /// </summary>
+        /// <returns>The number of missed ticks.</returns>
+        std::uint64_t missed(void) const noexcept;
+
+        msr_kernel_sampler& operator =(const msr_kernel_sampler&) = delete;
+
+    private:
+
+        /// <summary>
+        /// The layout of the header of the ring, which must match
+        /// <c>RAPL_SAMPLE_RING</c> in <c>RaplIoctl.h</c> of the driver.
+        /// </summary>
+        struct ring_header {
+            volatile std::int64_t written;
+            volatile std::int64_t missed;
+            std::uint32_t capacity;
+            std::uint32_t count;
+        };
+
+        /// <summary>
+        /// Loads the number of readings written by the driver.
+        /// </summary>
+        inline std::uint64_t written(void) const noexcept {
+            const auto retval = this->header()->written;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return static_cast<std::uint64_t>(retval);
+        }
+
+        inline const ring_header *header(void) const noexcept {
+            return static_cast<const ring_header *>(this->_ring);
+        }
+
+        std::size_t _capacity;
+        std::size_t _count;
+        std::uint64_t _lost;
+#if defined(_WIN32)
+        HANDLE _handle;
+        OVERLAPPED _overlapped;
+#endif /* defined(_WIN32) */
+        std::uint64_t _read;
+        void *_ring;
+        std::vector<std::uint64_t> _scratch;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+#include "msr_kernel_sampler.inl"
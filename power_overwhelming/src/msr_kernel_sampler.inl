@@ -0,0 +1,47 @@
+﻿// <copyright file="msr_kernel_sampler.inl" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+
+/*
+ * visus::power_overwhelming::detail::msr_kernel_sampler::drain
+ */
+template<class TCallback>
+std::size_t visus::power_overwhelming::detail::msr_kernel_sampler::drain(
+        _In_ TCallback callback) {
+    const auto records = reinterpret_cast<const volatile std::uint64_t *>(
+        this->header() + 1);
+    const auto stride = this->_count + 1;
+    const auto written = this->written();
+    std::size_t retval = 0;
+
+    if (written - this->_read > this->_capacity) {
+        // The driver has already overwritten the oldest readings we have not
+        // yet consumed, so skip them.
+        const auto skipped = written - this->_read - this->_capacity;
+        this->_lost += skipped;
+        this->_read += skipped;
+    }
+
+    for (; this->_read < written; ++this->_read) {
+        const auto record = records
+            + (this->_read % this->_capacity) * stride;
+        for (std::size_t i = 0; i < stride; ++i) {
+            this->_scratch[i] = record[i];
+        }
+
+        // The driver writes the reading with index 'written' while it is not
+        // yet published. If this is our slot, our copy might be torn.
+        if (this->written() >= this->_read + this->_capacity) {
+            ++this->_lost;
+            continue;
+        }
+
+        callback(static_cast<timestamp_type>(this->_scratch[0]),
+            static_cast<const sample_type *>(this->_scratch.data() + 1));
+        ++retval;
+    }
+
+    return retval;
+}
@@ -5,9 +5,10 @@
 
 #include "msr_magic.h"
 
-#include "power_overwhelming/cpu_affinity.h"
 #include "power_overwhelming/cpu_info.h"
 
+#include "machine_topology.h"
+
 
 /*
  * visus::power_overwhelming::detail::is_rapl_energy_supported
@@ -15,18 +16,17 @@
 bool visus::power_overwhelming::detail::is_rapl_energy_supported(
         _In_ const msr_sensor::core_type core,
         _In_ const rapl_domain domain) {
-    // Force the calling thread to the specified core for the stuff to come such
-    // that we are sure that we get the CPU info from the right CPU.
-    thread_affinity_scope affinity(core);
-
-    power_overwhelming::cpu_info cpu_info[2];
-    if (get_cpu_info(cpu_info, 2) < 2) {
+    // The vendor and model are the same for all cores, so we use the cached
+    // ones rather than migrating the calling thread to the core and running
+    // CPUID there.
+    const auto& machine = machine_topology::instance();
+    if ((core >= machine.cpus()) || !machine.has_model()) {
         return false;
     }
 
-    const auto model = extract_cpu_model(cpu_info);
+    const auto& model = machine.model();
 
-    switch (extract_cpu_vendor(cpu_info[0])) {
+    switch (machine.vendor()) {
         case cpu_vendor::amd:
         case cpu_vendor::hygon: {
             // AMD family is sum of base and extended according to
@@ -77,6 +77,87 @@ bool visus::power_overwhelming::detail::is_rapl_energy_supported(
 }
 
 
+/*
+ * visus::power_overwhelming::detail::is_msr_channel_supported
+ */
+bool visus::power_overwhelming::detail::is_msr_channel_supported(
+        _In_ const msr_sensor::core_type core,
+        _In_ const msr_channel channel) {
+    const auto& machine = machine_topology::instance();
+    if (core >= machine.cpus()) {
+        return false;
+    }
+
+    // The power management leaf 6 of CPUID reports APERF/MPERF in bit 0 of
+    // ECX and the package thermal management in bit 6 of EAX. The leaf is the
+    // same on all cores, so we can run CPUID on the calling thread.
+    cpu_info infos[7];
+    const auto has_leaf = (get_cpu_info(infos, 7) > 6);
+    const auto intel = (machine.vendor() == cpu_vendor::intel);
+
+    switch (channel) {
+        case msr_channel::aperf:
+        case msr_channel::mperf:
+            return has_leaf && ((infos[6].registers.ecx & 0x1) != 0);
+
+        case msr_channel::package_thermal_status:
+            return intel && has_leaf
+                && ((infos[6].registers.eax & 0x40) != 0);
+
+        case msr_channel::package_throttling:
+        case msr_channel::pp0_throttling:
+        case msr_channel::core_limit_reasons:
+            return intel && is_rapl_energy_supported(core,
+                rapl_domain::package);
+
+        case msr_channel::dram_throttling:
+            return intel && is_rapl_energy_supported(core, rapl_domain::dram);
+
+        default:
+            return false;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::make_channel_magic_config
+ */
+visus::power_overwhelming::detail::msr_channel_config_entry
+visus::power_overwhelming::detail::make_channel_magic_config(
+        _In_ const cpu_vendor vendor,
+        _In_ const msr_channel channel,
+        _In_ const std::streamoff data_location,
+        _In_ const rapl_domain_scope scope,
+        _In_ const std::uint64_t counter_mask,
+        _In_ const std::uint64_t unit_mask,
+        _In_ const std::uint32_t unit_offset) {
+    msr_channel_config config;
+    config.counter_mask = counter_mask;
+    config.data_location = data_location;
+    config.is_supported = std::bind(is_msr_channel_supported,
+        std::placeholders::_1, channel);
+    config.scope = scope;
+    config.unit_mask = unit_mask;
+    config.unit_offset = unit_offset;
+
+    switch (vendor) {
+        case cpu_vendor::amd:
+            config.unit_location = msr_offsets::amd::unit_divisors;
+            break;
+
+        case cpu_vendor::intel:
+            config.unit_location = msr_offsets::intel::unit_divisors;
+            break;
+
+        default:
+            config.unit_mask = 0;
+            break;
+    }
+
+    return std::make_pair(channel, config);
+}
+
+
 /*
  * visus::power_overwhelming::detail::make_energy_magic_config
  */
@@ -97,12 +178,20 @@ visus::power_overwhelming::detail::make_energy_magic_config(
 
     switch (vendor) {
         case cpu_vendor::amd:
+            // The core energy on AMD is per physical core, the package energy
+            // is per socket.
+            config.scope = (domain == rapl_domain::package)
+                ? rapl_domain_scope::package
+                : rapl_domain_scope::core;
             config.unit_location = msr_offsets::amd::unit_divisors;
             config.unit_mask = msr_units::amd::energy_mask;
             config.unit_offset = msr_units::amd::energy_offset;
             break;
 
         case cpu_vendor::intel:
+            // All RAPL domains on Intel are per die, which is the same as per
+            // package except for multi-die packages.
+            config.scope = rapl_domain_scope::die;
             config.unit_location = msr_offsets::intel::unit_divisors;
             config.unit_mask = msr_units::intel::energy_mask;
             config.unit_offset = msr_units::intel::energy_offset;
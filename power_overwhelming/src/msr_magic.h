@@ -9,6 +9,7 @@
 #include <utility>
 
 #include "power_overwhelming/cpu_info.h"
+#include "power_overwhelming/msr_channel.h"
 #include "power_overwhelming/msr_sensor.h"
 #include "power_overwhelming/power_overwhelming_api.h"
 #include "power_overwhelming/rapl_domain.h"
@@ -35,6 +36,7 @@ namespace amd {
 
 namespace intel {
     // Offsets from https://lkml.org/lkml/2011/5/26/93
+    constexpr std::streamoff core_perf_limit_reasons = 0x64F;
     constexpr std::streamoff dram_energy_status = 0x619;
     constexpr std::streamoff dram_performance_status = 0x61B;
     constexpr std::streamoff dram_power_info = 0x61C;
@@ -43,6 +45,7 @@ namespace intel {
     constexpr std::streamoff package_performance_status = 0x613;
     constexpr std::streamoff package_power_info = 0x614;
     constexpr std::streamoff package_power_limit = 0x610;
+    constexpr std::streamoff package_thermal_status = 0x1B1;
     constexpr std::streamoff platform_energy_status = 0x64D;
     constexpr std::streamoff pp0_energy_status = 0x639;
     constexpr std::streamoff pp0_performance_status = 0x63B;
@@ -53,6 +56,13 @@ namespace intel {
     constexpr std::streamoff pp1_power_limit = 0x640;
     constexpr std::streamoff unit_divisors = 0x606;
 } /* namespace intel */
+
+namespace x86 {
+    // Architectural offsets from the Intel SDM, vol. 4, which AMD implements
+    // at the same location.
+    constexpr std::streamoff aperf = 0xE8;
+    constexpr std::streamoff mperf = 0xE7;
+} /* namespace x86 */
 } /* namespace msr_offsets */
 
 
@@ -71,12 +81,54 @@ namespace intel {
     constexpr std::uint32_t energy_offset = 0x08;
     constexpr std::uint64_t power_mask = 0x000F;
     constexpr std::uint32_t power_offset = 0x00;
-    constexpr std::uint64_t time_mask = 0xF000;
+    constexpr std::uint64_t time_mask = 0xF0000;
     constexpr std::uint32_t time_offset = 0x10;
 } /* namespace intel */
 } /* namespace msr_units */
 
 
+    /// <summary>
+    /// The bitmask isolating the energy counter in an energy status MSR.
+    /// </summary>
+    /// <remarks>
+    /// The energy status registers of both, AMD and Intel, hold a 32-bit
+    /// counter in the lower bits, the upper 32 bits are reserved.
+    /// </remarks>
+    constexpr std::uint64_t energy_status_mask = 0xFFFFFFFF;
+
+
+    /// <summary>
+    /// Specifies which logical CPUs share the same RAPL register.
+    /// </summary>
+    /// <remarks>
+    /// An MSR can be read via the device file of any logical CPU, but for most
+    /// RAPL domains, all logical CPUs of a package or die read the same
+    /// counter.
+    /// </remarks>
+    enum class rapl_domain_scope {
+
+        /// <summary>
+        /// All logical CPUs in the same package share the register.
+        /// </summary>
+        package,
+
+        /// <summary>
+        /// All logical CPUs on the same die share the register.
+        /// </summary>
+        die,
+
+        /// <summary>
+        /// All hardware threads of a physical core share the register.
+        /// </summary>
+        core,
+
+        /// <summary>
+        /// Every logical CPU has its own register.
+        /// </summary>
+        thread
+    };
+
+
     /// <summary>
     /// A container for all the magic offsets required to retrieve and interpret
     /// data from an MSR device file.
@@ -94,6 +146,12 @@ namespace intel {
         /// </summary>
         std::function<bool(const msr_sensor::core_type)> is_supported;
 
+        /// <summary>
+        /// Specifies which logical CPUs share the register at
+        /// <see cref="data_location" />.
+        /// </summary>
+        rapl_domain_scope scope;
+
         /// <summary>
         /// Specifies the offset into the MSR file where the unit divisors are
         /// stored.
@@ -116,7 +174,8 @@ namespace intel {
         /// Initialises a new instance.
         /// </summary>
         inline msr_magic_config(void) noexcept : data_location(0),
-            unit_location(0), unit_mask(0), unit_offset(0) { }
+            scope(rapl_domain_scope::core), unit_location(0), unit_mask(0),
+            unit_offset(0) { }
     };
 
     /// <summary>
@@ -125,6 +184,70 @@ namespace intel {
     /// </summary>
     typedef std::pair<rapl_domain, msr_magic_config> msr_magic_config_entry;
 
+    /// <summary>
+    /// A container for the magic offsets required to read an additional
+    /// <see cref="msr_channel" /> along with the energy of an
+    /// <see cref="msr_sensor" />.
+    /// </summary>
+    struct msr_channel_config final {
+        /// <summary>
+        /// Specifies the bitmask isolating a counter in the register, or zero
+        /// if the register holds status bits rather than a counter.
+        /// </summary>
+        std::uint64_t counter_mask;
+
+        /// <summary>
+        /// Specifies the offset into the MSR file where the register is
+        /// located.
+        /// </summary>
+        std::streamoff data_location;
+
+        /// <summary>
+        /// A functional that performs a check at runtime whether the CPU the
+        /// code is running on actually supports the register.
+        /// </summary>
+        std::function<bool(const msr_sensor::core_type)> is_supported;
+
+        /// <summary>
+        /// Specifies which logical CPUs share the register at
+        /// <see cref="data_location" />.
+        /// </summary>
+        rapl_domain_scope scope;
+
+        /// <summary>
+        /// Specifies the offset into the MSR file where the unit divisor of
+        /// the counter is stored.
+        /// </summary>
+        std::streamoff unit_location;
+
+        /// <summary>
+        /// Specifies the bitmask that is applied to the data read from
+        /// <see cref="unit_location" /> to isolate the unit, or zero if the
+        /// counter is reported without conversion.
+        /// </summary>
+        std::uint64_t unit_mask;
+
+        /// <summary>
+        /// Specifies the number of bits that the masked unit bits need to be
+        /// shifted to yields a valid number.
+        /// </summary>
+        std::uint32_t unit_offset;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        inline msr_channel_config(void) noexcept : counter_mask(0),
+            data_location(0), scope(rapl_domain_scope::thread),
+            unit_location(0), unit_mask(0), unit_offset(0) { }
+    };
+
+    /// <summary>
+    /// A pair that can be used to initialise a lookup table for
+    /// <see cref="msr_channel_config" />s.
+    /// </summary>
+    typedef std::pair<msr_channel, msr_channel_config>
+        msr_channel_config_entry;
+
     /// <summary>
     /// Performs the default test whether a specific RAPL domain is supported on
     /// the specified CPU core.
@@ -143,6 +266,43 @@ namespace intel {
     extern POWER_OVERWHELMING_API bool is_rapl_energy_supported(
         _In_ const msr_sensor::core_type core, _In_ const rapl_domain domain);
 
+    /// <summary>
+    /// Performs the default test whether the given additional channel is
+    /// supported on the specified CPU core.
+    /// </summary>
+    /// <remarks>
+    /// APERF, MPERF and the thermal status are tested via the power
+    /// management leaf of CPUID. The RAPL status registers are tested like
+    /// the energy registers, which does not guarantee that a model-specific
+    /// register is present, so the sensor still needs to try reading it.
+    /// </remarks>
+    /// <param name="core">The zero-based index of the CPU core to check.
+    /// </param>
+    /// <param name="channel">The channel to be tested.</param>
+    /// <returns><c>true</c> if the core might have the register of the
+    /// channel.</returns>
+    extern POWER_OVERWHELMING_API bool is_msr_channel_supported(
+        _In_ const msr_sensor::core_type core, _In_ const msr_channel channel);
+
+    /// <summary>
+    /// Computes the number of energy units that have been accumulated between
+    /// two readings of an energy status MSR.
+    /// </summary>
+    /// <remarks>
+    /// The 32-bit energy counters wrap every few minutes under high load. As
+    /// long as a register is read at least once per wrap period, the modular
+    /// difference of the masked values is the correct increment.
+    /// </remarks>
+    /// <param name="current">The current raw value of the register.</param>
+    /// <param name="previous">The previous raw value of the register.</param>
+    /// <returns>The increment of the counter in energy units.</returns>
+    inline constexpr std::uint64_t rapl_energy_delta(
+            _In_ const std::uint64_t current,
+            _In_ const std::uint64_t previous) noexcept {
+        return ((current & energy_status_mask) - (previous & energy_status_mask))
+            & energy_status_mask;
+    }
+
     /// <summary>
     /// Creates a <see cref="msr_magic_config" /> for a CPU from the specified
     /// vendor and the energy unit and wraps it into a pair for the initialiser
@@ -154,6 +314,30 @@ namespace intel {
         _In_ const std::streamoff data_location,
         _In_ const std::function<bool(const msr_sensor::core_type)>& check);
 
+    /// <summary>
+    /// Creates a <see cref="msr_channel_config" /> for a CPU from the
+    /// specified vendor and wraps it into a pair for the initialiser of a
+    /// lookup table.
+    /// </summary>
+    /// <param name="vendor">The vendor of the CPU, which determines the unit
+    /// register.</param>
+    /// <param name="channel">The channel to be described.</param>
+    /// <param name="data_location">The offset of the register.</param>
+    /// <param name="scope">The logical CPUs sharing the register.</param>
+    /// <param name="counter_mask">The bits of the counter in the register,
+    /// or zero for a status register.</param>
+    /// <param name="unit_mask">The bits of the unit of the counter in the
+    /// unit register, or zero if the counter has no unit.</param>
+    /// <param name="unit_offset">The shift of the unit bits.</param>
+    extern msr_channel_config_entry make_channel_magic_config(
+        _In_ const cpu_vendor vendor,
+        _In_ const msr_channel channel,
+        _In_ const std::streamoff data_location,
+        _In_ const rapl_domain_scope scope,
+        _In_ const std::uint64_t counter_mask,
+        _In_ const std::uint64_t unit_mask = 0,
+        _In_ const std::uint32_t unit_offset = 0);
+
     /// <summary>
     /// Creates a <see cref="msr_magic_config" /> with the built-in check for
     /// whether RAPL MSRs are supported.
@@ -5,7 +5,64 @@
 
 #include "msr_sampler_context.h"
 
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
 #include "msr_sensor_impl.h"
+#include "system_trace.h"
+#include "tsc_clock.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Reads the registers of all given devices at once.
+    /// </summary>
+    /// <remarks>
+    /// Devices that cannot be read are marked invalid such that their sensors
+    /// do not report anything in this tick, but the others still do.
+    /// </remarks>
+    static void read_devices(
+            _Inout_ std::vector<msr_sampler_context::device_reading>& readings)
+            noexcept {
+        for (auto& r : readings) {
+            try {
+                r.device->read(r.offsets.data(), r.values.data(),
+                    r.offsets.size());
+                r.valid = true;
+            } catch (...) {
+                r.valid = false;
+            }
+        }
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::msr_sampler_context::kernel_buffer
+ */
+constexpr visus::power_overwhelming::detail::msr_sampler_context::interval_type
+visus::power_overwhelming::detail::msr_sampler_context::kernel_buffer;
+
+
+/*
+ * visus::power_overwhelming::detail::msr_sampler_context::kernel_poll
+ */
+constexpr visus::power_overwhelming::detail::msr_sampler_context::interval_type
+visus::power_overwhelming::detail::msr_sampler_context::kernel_poll;
+
+
+/*
+ * visus::power_overwhelming::detail::msr_sampler_context::kernel_threshold
+ */
+constexpr visus::power_overwhelming::detail::msr_sampler_context::interval_type
+visus::power_overwhelming::detail::msr_sampler_context::kernel_threshold;
 
 
 /*
@@ -18,38 +75,57 @@ bool visus::power_overwhelming::detail::msr_sampler_context::add(
         _In_opt_ void *context) {
     assert(sensor != nullptr);
     assert(callback != nullptr);
+
+    if (timestamp_resolution
+            == power_overwhelming::timestamp_resolution::nanoseconds) {
+        throw std::invalid_argument("Timestamps of MSR sensors cannot be "
+            "created in nanoseconds.");
+    }
+
     std::lock_guard<decltype(this->lock)> l(this->lock);
 
-    auto it = this->sensors.find(sensor->device);
-    if (it != this->sensors.end()) {
-        // We already know the device file, but do not know yet whether we
-        // already know the sensor (for a specific register), too.
-        if (it->second.find(sensor) != it->second.end()) {
+    {
+        auto it = this->sensors.find(sensor->device);
+        if ((it != this->sensors.end())
+                && (it->second.find(sensor) != it->second.end())) {
             // Sensor is already being sampled, so there is nothing to do.
             return false;
-
-        } else {
-            // Add the sensor to the existing device.
-            it->second.emplace(sensor, sensor_config(timestamp_resolution,
-                callback, context));
         }
-
-    } else {
-        // Need to sample a previously unknown device, so add it and its first
-        // sensor.
-        this->sensors[sensor->device].emplace(sensor, sensor_config(
-            timestamp_resolution, callback, context));
     }
 
-    if ((this->sensors.size() == 1) && !this->thread.joinable()) {
-        // If this is the first sensor, we need to start a worker thread.
-        this->thread = std::thread(&msr_sampler_context::sample, this);
+    // If the sensor has been sampled before, its baseline is from the time
+    // when it was stopped, so the first new sample would average over the
+    // whole pause unless we establish a new baseline now.
+    sensor->rearm();
+
+    // Add the sensor to its device, which is created if previously unknown.
+    this->sensors[sensor->device].emplace(sensor, sensor_config(
+        timestamp_resolution, callback, context,
+        this->instrumentation.sample_duration(sensor->sensor_name.c_str())));
+    this->shards_dirty = true;
+
+    if (!this->running) {
+        // If this is the first sensor, we need to schedule the task. If the
+        // task is still in its last tick, the scheduler restarts it after the
+        // tick has completed.
+        this->running = true;
+        sampler_scheduler::instance().schedule(this->task, this->interval);
     }
 
     return true;
 }
 
 
+/*
+ * visus::power_overwhelming::detail::msr_sampler_context::clear
+ */
+void visus::power_overwhelming::detail::msr_sampler_context::clear(void) {
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    this->sensors.clear();
+    this->shards_dirty = true;
+}
+
+
 /*
  * visus::power_overwhelming::detail::msr_sampler_context::remove
  */
@@ -72,6 +148,8 @@ bool visus::power_overwhelming::detail::msr_sampler_context::remove(
         }
     }
 
+    this->shards_dirty = this->shards_dirty || retval;
+
     return retval;
 }
 
@@ -79,38 +157,108 @@ bool visus::power_overwhelming::detail::msr_sampler_context::remove(
 /*
  * visus::power_overwhelming::detail::msr_sampler_context::sample
  */
-void visus::power_overwhelming::detail::msr_sampler_context::sample(void) {
-    auto have_sensors = true;
-    std::vector<std::uint8_t> sample;
+bool visus::power_overwhelming::detail::msr_sampler_context::sample(void) {
+    typedef sampler_instrumentation::clock_type clock_type;
+    const auto begin = this->instrumentation.begin_tick();
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    if (this->shards_dirty) {
+        this->rebuild_shards();
+    }
 
-    set_thread_name("PwrOwg Machine-Specific Register Sampler Thread");
+    // Read all registers. If the driver supports it, it reads the registers
+    // of all cores in a single request. Otherwise, if there is only one
+    // package, we read the devices in the task, or the shard threads read the
+    // devices of their package in parallel and we wait for all of them to
+    // finish such that all results belong to the same tick.
+    if (this->kernel != nullptr) {
+        // The driver samples the registers itself, so we only need to consume
+        // its readings, which carry their own timestamps, at a coarser rate.
+        this->kernel->drain([this](const timestamp_type file_time,
+                const msr_device::sample_type *values) {
+            this->scatter(values, true);
+            this->deliver(convert_from_file_time(file_time),
+                clock_type::duration::zero());
+        });
 
-    while (have_sensors) {
-        auto now = std::chrono::high_resolution_clock::now();
+        if (this->task.interval() != kernel_poll) {
+            this->task.restart(kernel_poll);
+        }
 
+        this->instrumentation.end_tick(begin);
+        return this->stop_if_empty();
+    }
+
+    if (this->task.interval() != this->interval) {
+        // The kernel-mode sampler has been stopped, so we need to poll at the
+        // requested rate again.
+        this->task.restart(this->interval);
+    }
+
+    const auto read_start = clock_type::now();
+
+    if (this->cores_supported && this->read_cores()) {
+        // Everything has been read in a single request.
+
+    } else if (this->shards.size() == 1) {
+        read_devices(this->shards.front()->readings);
+
+    } else if (this->shards.size() > 1) {
+        std::unique_lock<decltype(this->shard_lock)> sl(this->shard_lock);
+        this->shard_pending = this->shards.size();
+        ++this->shard_generation;
+        this->shard_cv.notify_all();
+        this->shard_cv.wait(sl, [this](void) {
+            return (this->shard_pending == 0);
+        });
+    }
+
+    // All devices of the tick share a single, cheap time stamp.
+    this->deliver(tsc_clock::now(),
+        clock_type::now() - read_start);
+
+    this->instrumentation.end_tick(begin);
+    return this->stop_if_empty();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::msr_sampler_context::sample_shard
+ */
+void visus::power_overwhelming::detail::msr_sampler_context::sample_shard(
+        _In_ shard_type *shard,
+        _In_ std::uint64_t generation) {
+    assert(shard != nullptr);
+    enter_library_thread("PwrOwg Machine-Specific Register Shard Thread");
+
+    try {
+        set_thread_affinity(shard->cpu);
+    } catch (...) {
+        // If we cannot bind the thread to the package, reading the registers
+        // still works, but we will cause more traffic between the packages.
+    }
+
+    while (true) {
         {
-            std::lock_guard<decltype(this->lock)> l(this->lock);
-            for (auto& d : this->sensors) {
-                auto device = d.first;
-                auto& sensors = d.second;
-
-                for (auto s : sensors) {
-                    auto sensor = s.first;
-
-                    // TODO
-                    s.second.callback(measurement(s.first->sensor_name.c_str(),
-                        sensor->sample(s.second.resolution)),
-                        s.second.context);
-                }
+            std::unique_lock<decltype(this->shard_lock)> l(this->shard_lock);
+            this->shard_cv.wait(l, [this, generation](void) {
+                return (this->shard_exit
+                    || (this->shard_generation != generation));
+            });
 
-                sample.clear();
+            if (this->shard_exit) {
+                return;
             }
 
-            have_sensors = !this->sensors.empty();
+            generation = this->shard_generation;
         }
 
-        if (have_sensors) {
-            std::this_thread::sleep_until(now + this->interval);
+        read_devices(shard->readings);
+
+        {
+            std::lock_guard<decltype(this->shard_lock)> l(this->shard_lock);
+            if (--this->shard_pending == 0) {
+                this->shard_cv.notify_all();
+            }
         }
     }
 }
@@ -127,3 +275,270 @@ bool visus::power_overwhelming::detail::msr_sampler_context::samples(
     return (it != this->sensors.end())
         && (it->second.find(sensor) != it->second.end());
 }
+
+
+/*
+ * visus::power_overwhelming::detail::msr_sampler_context::deliver
+ */
+void visus::power_overwhelming::detail::msr_sampler_context::deliver(
+        _In_ const std::chrono::system_clock::time_point& time,
+        _In_ const sampler_instrumentation::clock_type::duration read) {
+    typedef sampler_instrumentation::clock_type clock_type;
+
+    for (auto& s : this->shards) {
+        for (auto& b : s->bindings) {
+            auto& r = s->readings[b.reading];
+            if (r.valid) {
+                const auto start = clock_type::now();
+                const auto data = b.sensor->sample(r.values[b.value], time,
+                    b.config->converter);
+                const auto sampled = clock_type::now();
+                b.config->sample_duration->record(read + (sampled - start));
+                system_trace::sample(b.sensor->sensor_name.c_str(), data);
+
+                for (auto& c : b.channels) {
+                    auto& cr = s->readings[c.reading];
+                    if (cr.valid) {
+                        b.sensor->sample_channel(c.index, cr.values[c.value],
+                            data.timestamp());
+                    }
+                }
+
+                b.config->callback(measurement(
+                    b.sensor->sensor_name.c_str(), data),
+                    b.config->context);
+                this->instrumentation.callback_duration().record(
+                    clock_type::now() - sampled);
+            }
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::msr_sampler_context::read_cores
+ */
+bool visus::power_overwhelming::detail::msr_sampler_context::read_cores(
+        void) {
+    assert(this->cores_values.size() == this->cores.size());
+    if (this->shards.empty()) {
+        return true;
+    }
+
+    // Any device can be used for the request, because the driver reads the
+    // registers on the cores specified in the request.
+    auto& device = this->shards.front()->readings.front().device;
+    auto valid = true;
+
+    try {
+        if (!device->read_cores(this->cores.data(), this->cores_values.data(),
+                this->cores.size())) {
+            // The driver does not support the request, so we need to start
+            // the shard threads and never try again.
+            this->cores_supported = false;
+            this->rebuild_shards();
+            return false;
+        }
+    } catch (...) {
+        valid = false;
+    }
+
+    this->scatter(this->cores_values.data(), valid);
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::msr_sampler_context::rebuild_shards
+ */
+void visus::power_overwhelming::detail::msr_sampler_context::rebuild_shards(
+        void) {
+    typedef msr_sensor_impl::scope_key_type key_type;
+    typedef std::pair<std::size_t, std::size_t> location_type;
+    std::map<key_type, location_type> locations;
+    std::map<std::uint32_t, std::unique_ptr<shard_type>> shards;
+
+    this->stop_shards();
+
+    for (auto& d : this->sensors) {
+        for (auto& s : d.second) {
+            auto sensor = s.first;
+
+            auto& shard = shards[sensor->topology.package];
+            if (shard == nullptr) {
+                shard.reset(new shard_type(sensor->core));
+            }
+
+            // If the physical register has not yet been read by any other
+            // sensor, add it to the reading of the device of the sensor.
+            // The scope key contains the package, so all aliases of a register
+            // are on the same shard.
+            auto locate = [&](const std::streamoff offset,
+                    const rapl_domain_scope scope) {
+                const auto key = sensor->scope_key(offset, scope);
+                auto it = locations.find(key);
+                if (it == locations.end()) {
+                    auto rit = std::find_if(shard->readings.begin(),
+                        shard->readings.end(), [&d](const device_reading& r) {
+                            return (r.device == d.first);
+                        });
+                    if (rit == shard->readings.end()) {
+                        shard->readings.emplace_back(d.first, sensor->core);
+                        rit = shard->readings.end() - 1;
+                    }
+
+                    rit->offsets.push_back(offset);
+                    rit->values.resize(rit->offsets.size());
+
+                    location_type location(
+                        std::distance(shard->readings.begin(), rit),
+                        rit->offsets.size() - 1);
+                    it = locations.emplace(key, location).first;
+                }
+
+                return it->second;
+            };
+
+            const auto location = locate(sensor->offset, sensor->scope);
+
+            shard_type::binding binding;
+            binding.sensor = sensor;
+            binding.config = &s.second;
+            binding.reading = location.first;
+            binding.value = location.second;
+
+            // The sensor is not sampled asynchronously before we have added
+            // it, so its channels cannot change while we are using them.
+            for (std::size_t i = 0; i < sensor->channels.size(); ++i) {
+                auto& config = sensor->channels[i].config;
+                const auto l = locate(config.data_location, config.scope);
+                shard_type::channel_binding channel;
+                channel.index = i;
+                channel.reading = l.first;
+                channel.value = l.second;
+                binding.channels.push_back(channel);
+            }
+
+            shard->bindings.push_back(binding);
+        }
+    }
+
+    this->cores.clear();
+    for (auto& s : shards) {
+        for (auto& r : s.second->readings) {
+            for (auto o : r.offsets) {
+                msr_device::core_register reg;
+                reg.core = static_cast<std::int32_t>(r.core);
+                reg.index = static_cast<std::uint32_t>(o);
+                this->cores.push_back(reg);
+            }
+        }
+
+        this->shards.push_back(std::move(s.second));
+    }
+    this->cores_values.resize(this->cores.size());
+
+    if (this->kernel_supported && !this->cores.empty()
+            && (this->interval < kernel_threshold)) {
+        // The interval is too short for reliable sampling in user mode, so
+        // ask the driver to sample the registers on a kernel timer. The ring
+        // can hold the readings of 'kernel_buffer', which leaves enough
+        // room if the task is delayed.
+        const auto interval = (std::max)(this->interval,
+            msr_kernel_sampler::min_interval);
+        const auto capacity = (std::max)(static_cast<std::size_t>(
+            kernel_buffer / interval), static_cast<std::size_t>(16));
+
+        try {
+            this->kernel.reset(new msr_kernel_sampler(
+                this->shards.front()->readings.front().core,
+                this->cores.data(), this->cores.size(), interval, capacity));
+        } catch (...) {
+            // The driver cannot sample the registers by itself, so we fall
+            // back to polling and never try again.
+            this->kernel_supported = false;
+        }
+    }
+
+    if ((this->kernel == nullptr) && !this->cores_supported
+            && (this->shards.size() > 1)) {
+        for (auto& s : this->shards) {
+            s->thread = std::thread(&msr_sampler_context::sample_shard, this,
+                s.get(), this->shard_generation);
+        }
+    }
+
+    this->shards_dirty = false;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::msr_sampler_context::scatter
+ */
+void visus::power_overwhelming::detail::msr_sampler_context::scatter(
+        _In_reads_(cores.size()) const msr_device::sample_type *values,
+        _In_ const bool valid) {
+    assert(values != nullptr);
+    auto value = values;
+
+    for (auto& s : this->shards) {
+        for (auto& r : s->readings) {
+            r.valid = valid;
+            std::copy(value, value + r.values.size(), r.values.begin());
+            value += r.values.size();
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::msr_sampler_context::stop_if_empty
+ */
+bool visus::power_overwhelming::detail::msr_sampler_context::stop_if_empty(
+        void) {
+    const auto retval = !this->sensors.empty();
+    this->running = retval;
+    if (!retval) {
+        this->stop_shards();
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::msr_sampler_context::stop_shards
+ */
+void visus::power_overwhelming::detail::msr_sampler_context::stop_shards(
+        void) {
+    this->kernel.reset();
+
+    {
+        std::lock_guard<decltype(this->shard_lock)> l(this->shard_lock);
+        this->shard_exit = true;
+        this->shard_cv.notify_all();
+    }
+
+    for (auto& s : this->shards) {
+        if (s->thread.joinable()) {
+            s->thread.join();
+        }
+    }
+
+    this->shards.clear();
+
+    {
+        std::lock_guard<decltype(this->shard_lock)> l(this->shard_lock);
+        this->shard_exit = false;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::msr_sampler_context::tick
+ */
+bool visus::power_overwhelming::detail::msr_sampler_context::tick(
+        _In_ void *context) {
+    assert(context != nullptr);
+    return static_cast<msr_sampler_context *>(context)->sample();
+}
@@ -8,7 +8,9 @@
 #include <cassert>
 #include <cinttypes>
 #include <chrono>
+#include <condition_variable>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <unordered_map>
@@ -18,8 +20,13 @@
 #include "power_overwhelming/msr_sensor.h"
 #include "power_overwhelming/measurement.h"
 
+#include "library_thread.h"
+#include "msr_device.h"
 #include "msr_device_factory.h"
-#include "thread_name.h"
+#include "msr_kernel_sampler.h"
+#include "sampler_instrumentation.h"
+#include "sampler_scheduler.h"
+#include "timestamp.h"
 
 
 namespace visus {
@@ -31,7 +38,8 @@ namespace detail {
 
 
     /// <summary>
-    /// A context represents a thread that handles sampling
+    /// A context represents a task of the <see cref="sampler_scheduler" />
+    /// that handles sampling
     /// <see cref="msr_sensor" />s at a specific interval.
     /// </summary>
     struct msr_sampler_context {
@@ -43,14 +51,19 @@ namespace detail {
         struct sensor_config {
             measurement_callback callback;
             void *context;
+            timestamp_converter converter;
             timestamp_resolution resolution;
+            sampler_instrumentation::histogram_type *sample_duration;
 
             inline sensor_config(_In_ const timestamp_resolution resolution,
                     _In_ measurement_callback callback,
-                    _In_opt_ void *context)
+                    _In_opt_ void *context,
+                    _In_ sampler_instrumentation::histogram_type& duration)
                 : callback(callback),
                     context(context),
-                    resolution(resolution) { }
+                    converter(get_timestamp_converter(resolution)),
+                    resolution(resolution),
+                    sample_duration(&duration) { }
         };
 
         /// <summary>
@@ -58,6 +71,65 @@ namespace detail {
         /// </summary>
         typedef msr_device_factory::device_type device_type;
 
+        /// <summary>
+        /// The registers of a single device that are read at once in each
+        /// tick.
+        /// </summary>
+        struct device_reading {
+            msr_device::core_type core;
+            device_type device;
+            std::vector<std::streamoff> offsets;
+            std::vector<msr_device::sample_type> values;
+            bool valid;
+
+            inline device_reading(_In_ const device_type& device,
+                    _In_ const msr_device::core_type core)
+                : core(core), device(device), valid(false) { }
+        };
+
+        /// <summary>
+        /// The devices on the same CPU package, which are read by a worker
+        /// thread that is bound to a core of this package.
+        /// </summary>
+        /// <remarks>
+        /// If multiple sensors read the same physical register via the devices
+        /// of different cores, e.g. the package energy, the register is read
+        /// only once and the value is fanned out to all of these sensors. The
+        /// registers of the additional channels of the sensors are part of the
+        /// same readings.
+        /// </remarks>
+        struct shard_type {
+
+            /// <summary>
+            /// Associates the channel at <see cref="index" /> of a sensor with
+            /// the register value it is computed from.
+            /// </summary>
+            struct channel_binding {
+                std::size_t index;
+                std::size_t reading;
+                std::size_t value;
+            };
+
+            /// <summary>
+            /// Associates a sensor with the register value it is computed from,
+            /// which might have been read via the device of another core.
+            /// </summary>
+            struct binding {
+                std::vector<channel_binding> channels;
+                msr_sensor_impl *sensor;
+                const sensor_config *config;
+                std::size_t reading;
+                std::size_t value;
+            };
+
+            std::vector<binding> bindings;
+            std::uint32_t cpu;
+            std::vector<device_reading> readings;
+            std::thread thread;
+
+            inline shard_type(_In_ const std::uint32_t cpu) : cpu(cpu) { }
+        };
+
         /// <summary>
         /// The type to express sampling intervals.
         /// </summary>
@@ -69,16 +141,113 @@ namespace detail {
         /// </summary>
         typedef msr_sensor_impl *sensor_type;
 
+        /// <summary>
+        /// The registers of all <see cref="shards" /> in the order of their
+        /// readings, which are read in a single request to the driver if
+        /// <see cref="cores_supported" /> is set.
+        /// </summary>
+        std::vector<msr_device::core_register> cores;
+
+        /// <summary>
+        /// Indicates whether the MSR device supports reading the registers of
+        /// all <see cref="cores" /> at once.
+        /// </summary>
+        /// <remarks>
+        /// If this flag is set, the shard threads are not started, because
+        /// the driver reads the registers on the cores themselves. It is
+        /// cleared permanently once the driver has rejected the request.
+        /// </remarks>
+        bool cores_supported;
+
+        /// <summary>
+        /// Receives the values of <see cref="cores" />.
+        /// </summary>
+        std::vector<msr_device::sample_type> cores_values;
+
+        /// <summary>
+        /// The task of the scheduler that periodically samples the
+        /// <see cref="sensors" />.
+        /// </summary>
+        /// <remarks>
+        /// <para>The shard threads are not run by the scheduler, because they
+        /// must remain bound to their package.</para>
+        /// <para>The task is declared before the
+        /// <see cref="instrumentation" /> observing it such that it is
+        /// initialised first.</para>
+        /// </remarks>
+        sampler_scheduler::task task;
+
+        /// <summary>
+        /// Records the timing of the ticks of <see cref="task" />.
+        /// </summary>
+        /// <remarks>
+        /// The registers of all sensors are read at once, so the duration of
+        /// a sample of a sensor is the duration of the whole read plus its
+        /// own conversion.
+        /// </remarks>
+        sampler_instrumentation instrumentation;
+
         /// <summary>
         /// The sampling interval.
         /// </summary>
         interval_type interval;
 
+        /// <summary>
+        /// The kernel-mode sampler of the driver, which reads all
+        /// <see cref="cores" /> on a kernel timer if the
+        /// <see cref="interval" /> is shorter than
+        /// <see cref="kernel_threshold" />.
+        /// </summary>
+        /// <remarks>
+        /// If the kernel-mode sampler is running, the task only consumes its
+        /// readings every <see cref="kernel_poll" />. The sampler is
+        /// recreated whenever the <see cref="shards" /> are rebuilt.
+        /// </remarks>
+        std::unique_ptr<msr_kernel_sampler> kernel;
+
+        /// <summary>
+        /// The time span the ring of the <see cref="kernel" /> sampler can
+        /// hold readings for.
+        /// </summary>
+        static constexpr interval_type kernel_buffer
+            = std::chrono::milliseconds(100);
+
+        /// <summary>
+        /// The interval at which the task consumes the readings of the
+        /// <see cref="kernel" /> sampler.
+        /// </summary>
+        static constexpr interval_type kernel_poll
+            = std::chrono::milliseconds(1);
+
+        /// <summary>
+        /// Indicates whether the driver supports the <see cref="kernel" />
+        /// sampler, which is cleared permanently once starting it failed.
+        /// </summary>
+        bool kernel_supported;
+
+        /// <summary>
+        /// Sampling intervals shorter than this are handled by the
+        /// <see cref="kernel" /> sampler if possible.
+        /// </summary>
+        static constexpr interval_type kernel_threshold
+            = std::chrono::milliseconds(1);
+
         /// <summary>
         /// A lock protecting the list of <see cref="sensors" />.
         /// </summary>
         std::mutex lock;
 
+        /// <summary>
+        /// Indicates whether the <see cref="task" /> is scheduled.
+        /// </summary>
+        /// <remarks>
+        /// The flag is protected by <see cref="lock" />. The sampler task
+        /// clears it when it has found <see cref="sensors" /> empty and is
+        /// about to stop, in which case <see cref="add" /> must schedule it
+        /// again.
+        /// </remarks>
+        bool running;
+
         /// <summary>
         /// The sensors to sample along with the callback to be invoked, grouped
         /// by their MSR device, such that we can sample all channels of each
@@ -87,9 +256,70 @@ namespace detail {
         std::map<device_type, std::map<sensor_type, sensor_config>> sensors;
 
         /// <summary>
-        /// The thread sampling the <see cref="sensors" />.
+        /// The devices of the <see cref="sensors" /> grouped by their CPU
+        /// package.
+        /// </summary>
+        /// <remarks>
+        /// Reading an MSR requires an inter-processor interrupt to the core the
+        /// register belongs to. Reading the devices of each package on a thread
+        /// bound to this package allows for sampling many cores within a
+        /// short interval. The shards are rebuilt by the sampler task and
+        /// protected by <see cref="lock" />.
+        /// </remarks>
+        std::vector<std::unique_ptr<shard_type>> shards;
+
+        /// <summary>
+        /// Signals the shard threads that they should exit.
+        /// </summary>
+        bool shard_exit;
+
+        /// <summary>
+        /// Signals the shard threads that they should read their devices
+        /// whenever it changes.
+        /// </summary>
+        std::uint64_t shard_generation;
+
+        /// <summary>
+        /// The condition used to signal <see cref="shard_generation" /> and
+        /// <see cref="shard_pending" />.
+        /// </summary>
+        std::condition_variable shard_cv;
+
+        /// <summary>
+        /// A lock protecting <see cref="shard_exit" />,
+        /// <see cref="shard_generation" /> and <see cref="shard_pending" />.
+        /// </summary>
+        std::mutex shard_lock;
+
+        /// <summary>
+        /// The number of shard threads that have not yet completed reading
+        /// their devices in the current tick.
         /// </summary>
-        std::thread thread;
+        std::size_t shard_pending;
+
+        /// <summary>
+        /// Indicates that the <see cref="sensors" /> have changed and the
+        /// <see cref="shards" /> must be rebuilt before the next tick.
+        /// </summary>
+        bool shards_dirty;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        inline msr_sampler_context(void) :
+#if defined(_WIN32)
+            cores_supported(true),
+#else /* defined(_WIN32) */
+            cores_supported(false),
+#endif /* defined(_WIN32) */
+            task(&msr_sampler_context::tick, this), instrumentation(task),
+#if defined(_WIN32)
+            kernel_supported(true),
+#else /* defined(_WIN32) */
+            kernel_supported(false),
+#endif /* defined(_WIN32) */
+            running(false), shard_exit(false),
+            shard_generation(0), shard_pending(0), shards_dirty(true) { }
 
         /// <summary>
         /// Add the given sensor to the this context.
@@ -104,20 +334,57 @@ namespace detail {
             return this->add(sensor, timestamp_resolution::milliseconds, callback, context);
         }
 
+        /// <summary>
+        /// Remove all sensors from the context, which will make the sampler
+        /// task stop.
+        /// </summary>
+        void clear(void);
+
         /// <summary>
         /// Remove the sensor from the context.
         /// </summary>
         bool remove(_In_ sensor_type sensor);
 
         /// <summary>
-        /// Performs sampling in this context.
+        /// Performs one tick of sampling in this context.
+        /// </summary>
+        /// <returns><c>true</c> if the task should continue to be scheduled,
+        /// <c>false</c> if there are no sensors left.</returns>
+        bool sample(void);
+
+        /// <summary>
+        /// Reads the devices of the given shard whenever
+        /// <see cref="shard_generation" /> changes.
         /// </summary>
-        void sample(void);
+        /// <param name="shard">The shard to be read.</param>
+        /// <param name="generation">The generation when the thread was
+        /// started.</param>
+        void sample_shard(_In_ shard_type *shard,
+            _In_ std::uint64_t generation);
 
         /// <summary>
         /// Answer whether the given sensor is sampled in this context.
         /// </summary>
         bool samples(_In_ const sensor_type sensor);
+
+    private:
+
+        void deliver(_In_ const std::chrono::system_clock::time_point& time,
+            _In_ const sampler_instrumentation::clock_type::duration read);
+
+        bool read_cores(void);
+
+        void rebuild_shards(void);
+
+        void scatter(_In_reads_(cores.size())
+            const msr_device::sample_type *values,
+            _In_ const bool valid);
+
+        bool stop_if_empty(void);
+
+        void stop_shards(void);
+
+        static bool tick(_In_ void *context);
     };
 
 } /* namespace detail */
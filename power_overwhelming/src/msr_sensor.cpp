@@ -6,6 +6,8 @@
 #include "power_overwhelming/msr_sensor.h"
 
 #include <cassert>
+#include <set>
+#include <stdexcept>
 
 #include "power_overwhelming/for_each_rapl_domain.h"
 
@@ -48,48 +50,73 @@ std::size_t visus::power_overwhelming::msr_sensor::for_all(
         _Out_writes_opt_(cnt_sensors) msr_sensor *out_sensors,
         _In_ const std::size_t cnt_sensors,
         _In_ const bool consider_topology) {
+    typedef detail::msr_sensor_impl::catalogue_entry_type entry_type;
+    std::set<detail::msr_sensor_impl::scope_key_type> scopes;
     std::size_t retval = 0;
-    bool succeeded = true;
-
-    for (core_type c = 0; succeeded; ++c) {
-        try {
-            // Test-create the device file to find out whether the core exists.
-            auto dev = detail::msr_device_factory::create(c);
-            if (dev == nullptr) {
-                throw std::logic_error("An invalid MSR device was created by "
-                    "the msr_device_factory, which should never happen.");
-            }
 
-            // Now that we know that the core exists, try creating sensors for
-            // all RAPL domains.
-            for_each_rapl_domain([&](const rapl_domain domain) {
-                try {
-                    msr_sensor sensor;
-                    assert(sensor._impl != nullptr);
-                    sensor._impl->set(c, domain, nullptr);
+    // Probing all cores and domains requires opening the device files and
+    // reading the registers, so we only do this if the device catalogue has
+    // been invalidated.
+    const auto entries = detail::msr_sensor_impl::catalogue.get(
+            [](void) {
+        std::vector<entry_type> retval;
+        bool succeeded = true;
+
+        for (core_type c = 0; succeeded; ++c) {
+            try {
+                // Test-create the device file to find out whether the core
+                // exists.
+                auto dev = detail::msr_device_factory::create(c);
+                if (dev == nullptr) {
+                    throw std::logic_error("An invalid MSR device was created "
+                        "by the msr_device_factory, which should never "
+                        "happen.");
+                }
 
-                    if (retval < cnt_sensors) {
-                        out_sensors[retval] = std::move(sensor);
+                // Now that we know that the core exists, try creating sensors
+                // for all RAPL domains.
+                for_each_rapl_domain([&](const rapl_domain domain) {
+                    try {
+                        detail::msr_sensor_impl impl;
+                        impl.set(c, domain, nullptr);
+                        retval.emplace_back(c, domain, impl.scope_key());
+                    } catch (...) {
+                        // Not being able to create a sensor for a specific
+                        // RAPL domain does not constitute a fatall error. The
+                        // RAPL domain just might not be supported for the CPU,
+                        // so we continue enumerating in this case.
                     }
 
-                    ++retval;
-                } catch (...) {
-                    // Not being able to create a sensor for a specific RAPL
-                    // domain does not constitute a fatall error. The RAPL
-                    // domain just might not be supported for the CPU, so we
-                    // continue enumerating in this case.
-                }
+                    return true;
+                });
 
-                return true;
-            });
+            } catch (std::system_error) {
+                // If creating a device for core 'c' causes an
+                // std::system_error, we have reached the last core and leave
+                // the loop. Papa Schlumpf would not approve this use of
+                // exceptions for control flow, but it is the simplest way to
+                // implement this without duplicating code.
+                succeeded = false;
+            }
+        }
 
-        } catch (std::system_error) {
-            // If creating a device for core 'c' causes an std::system_error, we
-            // have reached the last core and leave the loop. Papa Schlumpf
-            // would not approve this use of exceptions for control flow, but it
-            // is the simplest way to implement this without duplicating code.
-            succeeded = false;
+        return retval;
+    });
+
+    for (auto& e : entries) {
+        // If we already have a sensor reading the same physical register via
+        // another core, skip the duplicate.
+        if (consider_topology && !scopes.insert(std::get<2>(e)).second) {
+            continue;
+        }
+
+        if (retval < cnt_sensors) {
+            auto& sensor = out_sensors[retval];
+            assert(sensor._impl != nullptr);
+            sensor._impl->set(std::get<0>(e), std::get<1>(e), nullptr);
         }
+
+        ++retval;
     }
 
     return retval;
@@ -109,6 +136,25 @@ visus::power_overwhelming::msr_sensor::for_core(_In_ const core_type core,
 }
 
 
+/*
+ * visus::power_overwhelming::msr_sensor::sample_data
+ */
+void visus::power_overwhelming::msr_sensor::sample_data(
+        _Out_writes_(cnt) measurement_data *dst,
+        _In_reads_(cnt) const msr_sensor *sensors,
+        _In_ const std::size_t cnt,
+        _In_ const timestamp_resolution resolution) {
+    if ((cnt > 0) && ((dst == nullptr) || (sensors == nullptr))) {
+        throw std::invalid_argument("The output and the sensors must be "
+            "valid if sensors are to be sampled.");
+    }
+
+    for (std::size_t i = 0; i < cnt; ++i) {
+        dst[i] = sensors[i].sample_data(resolution);
+    }
+}
+
+
 /*
  * visus::power_overwhelming::msr_sensor::msr_sensor
  */
@@ -120,10 +166,47 @@ visus::power_overwhelming::msr_sensor::msr_sensor(void)
  * visus::power_overwhelming::msr_sensor::~msr_sensor
  */
 visus::power_overwhelming::msr_sensor::~msr_sensor(void) {
+    // Make sure that the generic sampler thread does not use the sensor
+    // anymore.
+    this->sample_batch(nullptr);
     delete this->_impl;
 }
 
 
+/*
+ * visus::power_overwhelming::msr_sensor::channel
+ */
+bool visus::power_overwhelming::msr_sensor::channel(
+        _In_ const msr_channel channel) const {
+    this->check_not_disposed();
+    return this->_impl->has_channel(channel);
+}
+
+
+/*
+ * visus::power_overwhelming::msr_sensor::channel
+ */
+visus::power_overwhelming::msr_sensor&
+visus::power_overwhelming::msr_sensor::channel(
+        _In_ const msr_channel channel,
+        _In_ const bool enabled) {
+    this->check_not_disposed();
+    this->_impl->enable_channel(channel, enabled);
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::msr_sensor::channel_samples
+ */
+std::size_t visus::power_overwhelming::msr_sensor::channel_samples(
+        _Out_writes_opt_(cnt) msr_channel_sample *dst,
+        _In_ const std::size_t cnt) {
+    this->check_not_disposed();
+    return this->_impl->get_channel_samples(dst, cnt);
+}
+
+
 /*
  * visus::power_overwhelming::msr_sensor::core
  */
@@ -144,6 +227,15 @@ visus::power_overwhelming::msr_sensor::domain(void) const {
 }
 
 
+/*
+ * visus::power_overwhelming::msr_sensor::energy
+ */
+double visus::power_overwhelming::msr_sensor::energy(void) const {
+    this->check_not_disposed();
+    return this->_impl->energy();
+}
+
+
 /*
  * visus::power_overwhelming::msr_sensor::read
  */
@@ -166,6 +258,18 @@ const wchar_t *visus::power_overwhelming::msr_sensor::name(
 }
 
 
+/*
+ * visus::power_overwhelming::msr_sensor::native_interval
+ */
+visus::power_overwhelming::sensor::microseconds_type
+visus::power_overwhelming::msr_sensor::native_interval(void) const {
+    // Intel documents the update interval of the energy status counters to
+    // be approximately 1 ms, which holds for AMD processors, too.
+    this->check_not_disposed();
+    return 1000;
+}
+
+
 /*
  * visus::power_overwhelming::msr_sensor::sample
  */
@@ -194,6 +298,18 @@ void visus::power_overwhelming::msr_sensor::sample(
 }
 
 
+/*
+ * visus::power_overwhelming::msr_sensor::sample_adaptive
+ */
+void visus::power_overwhelming::msr_sensor::sample_adaptive(
+        _In_opt_ const measurement_data_callback on_batch,
+        _In_ const microseconds_type min_period,
+        _In_ const microseconds_type max_period,
+        _In_opt_ void *context) {
+    this->sample_adaptive_sync(on_batch, min_period, max_period, context);
+}
+
+
 /*
  * visus::power_overwhelming::msr_sensor::operator =
  */
@@ -218,12 +334,25 @@ visus::power_overwhelming::msr_sensor::operator bool(void) const noexcept {
 }
 
 
+/*
+ * visus::power_overwhelming::msr_sensor::sample_data
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::msr_sensor::sample_data(
+        _In_ const timestamp_resolution resolution) const {
+    if (!*this) {
+        // The class is final, so this does not require a virtual call.
+        throw_disposed();
+    }
+    return this->_impl->sample(resolution);
+}
+
+
 /*
  * visus::power_overwhelming::msr_sensor::sample_sync
  */
 visus::power_overwhelming::measurement_data
 visus::power_overwhelming::msr_sensor::sample_sync(
         _In_ const timestamp_resolution resolution) const {
-    this->check_not_disposed();
-    return this->_impl->sample(resolution);
+    return this->sample_data(resolution);
 }
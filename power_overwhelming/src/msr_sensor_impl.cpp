@@ -6,9 +6,11 @@
 #include "msr_sensor_impl.h"
 
 #include <algorithm>
+#include <cmath>
 #include <map>
 #include <stdexcept>
 
+#include "machine_topology.h"
 #include "msr_magic.h"
 #include "timestamp.h"
 
@@ -17,6 +19,8 @@
     "CPU of this machine."
 #define ERROR_MSG_UNSUPPORTED_CORE "The specified RAPL domain is not "\
     "supported for the specified CPU core."
+#define ERROR_MSG_UNSUPPORTED_CHANNEL "The specified MSR channel is not "\
+    "supported for the CPU core of the sensor."
 
 
 namespace visus {
@@ -67,11 +71,115 @@ namespace detail {
         },
     };
 
+    /// <summary>
+    /// The type of a lookup table mapping additional channels to their
+    /// location in the MSR device file for each CPU vendor.
+    /// </summary>
+    typedef std::map<cpu_vendor, std::map<msr_channel, msr_channel_config>>
+        channel_configs_type;
+
+    /// <summary>
+    /// Build a lookup table for the additional channels that can be read along
+    /// with the energy counters.
+    /// </summary>
+    static const channel_configs_type channel_configs = {
+        {
+            cpu_vendor::amd,
+            {
+                make_channel_magic_config(cpu_vendor::amd,
+                    msr_channel::aperf,
+                    msr_offsets::x86::aperf,
+                    rapl_domain_scope::thread,
+                    ~static_cast<std::uint64_t>(0)),
+                make_channel_magic_config(cpu_vendor::amd,
+                    msr_channel::mperf,
+                    msr_offsets::x86::mperf,
+                    rapl_domain_scope::thread,
+                    ~static_cast<std::uint64_t>(0))
+            }
+        },
+
+        {
+            cpu_vendor::intel,
+            {
+                make_channel_magic_config(cpu_vendor::intel,
+                    msr_channel::aperf,
+                    msr_offsets::x86::aperf,
+                    rapl_domain_scope::thread,
+                    ~static_cast<std::uint64_t>(0)),
+                make_channel_magic_config(cpu_vendor::intel,
+                    msr_channel::mperf,
+                    msr_offsets::x86::mperf,
+                    rapl_domain_scope::thread,
+                    ~static_cast<std::uint64_t>(0)),
+                make_channel_magic_config(cpu_vendor::intel,
+                    msr_channel::package_thermal_status,
+                    msr_offsets::intel::package_thermal_status,
+                    rapl_domain_scope::package,
+                    0),
+                make_channel_magic_config(cpu_vendor::intel,
+                    msr_channel::package_throttling,
+                    msr_offsets::intel::package_performance_status,
+                    rapl_domain_scope::die,
+                    energy_status_mask,
+                    msr_units::intel::time_mask,
+                    msr_units::intel::time_offset),
+                make_channel_magic_config(cpu_vendor::intel,
+                    msr_channel::pp0_throttling,
+                    msr_offsets::intel::pp0_performance_status,
+                    rapl_domain_scope::die,
+                    energy_status_mask,
+                    msr_units::intel::time_mask,
+                    msr_units::intel::time_offset),
+                make_channel_magic_config(cpu_vendor::intel,
+                    msr_channel::dram_throttling,
+                    msr_offsets::intel::dram_performance_status,
+                    rapl_domain_scope::die,
+                    energy_status_mask,
+                    msr_units::intel::time_mask,
+                    msr_units::intel::time_offset),
+                make_channel_magic_config(cpu_vendor::intel,
+                    msr_channel::core_limit_reasons,
+                    msr_offsets::intel::core_perf_limit_reasons,
+                    rapl_domain_scope::package,
+                    0)
+            }
+        },
+    };
+
+    /// <summary>
+    /// Retrieves the raw value of the unit register at the given location of
+    /// the given package, which is read only once per package.
+    /// </summary>
+    static msr_device::sample_type read_units(
+            _In_ const msr_device_factory::device_type& device,
+            _In_ const std::uint32_t package,
+            _In_ const std::streamoff location) {
+        const auto key = msr_sensor_impl::unit_key_type(package, location);
+
+        std::lock_guard<decltype(msr_sensor_impl::units_lock)> l(
+            msr_sensor_impl::units_lock);
+        auto it = msr_sensor_impl::units.find(key);
+        if (it == msr_sensor_impl::units.end()) {
+            it = msr_sensor_impl::units.emplace(key,
+                device->read(location)).first;
+        }
+
+        return it->second;
+    }
+
 } /* namespace detail */
 } /* namespace power_overwhelming */
 } /* namespace visus */
 
 
+/*
+ * visus::power_overwhelming::detail::msr_sensor_impl::max_channel_samples
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::msr_sensor_impl::max_channel_samples;
+
+
 /*
  * visus::power_overwhelming::detail::msr_sensor_impl::supported_domains
  */
@@ -95,6 +203,28 @@ visus::power_overwhelming::detail::msr_sensor_impl::supported_domains(
 }
 
 
+/*
+ * visus::power_overwhelming::detail::msr_sensor_impl::units
+ */
+std::map<visus::power_overwhelming::detail::msr_sensor_impl::unit_key_type,
+    visus::power_overwhelming::detail::msr_device::sample_type>
+    visus::power_overwhelming::detail::msr_sensor_impl::units;
+
+
+/*
+ * visus::power_overwhelming::detail::msr_sensor_impl::units_lock
+ */
+std::mutex visus::power_overwhelming::detail::msr_sensor_impl::units_lock;
+
+
+/*
+ * visus::power_overwhelming::detail::msr_sensor_impl::catalogue
+ */
+visus::power_overwhelming::detail::cached_discovery<
+    visus::power_overwhelming::detail::msr_sensor_impl::catalogue_entry_type>
+    visus::power_overwhelming::detail::msr_sensor_impl::catalogue;
+
+
 /*
  * visus::power_overwhelming::detail::msr_sensor_impl::sampler
  */
@@ -103,6 +233,121 @@ visus::power_overwhelming::detail::sampler<
     visus::power_overwhelming::detail::msr_sensor_impl::sampler;
 
 
+/*
+ * visus::power_overwhelming::detail::msr_sensor_impl::enable_channel
+ */
+void visus::power_overwhelming::detail::msr_sensor_impl::enable_channel(
+        _In_ const msr_channel channel,
+        _In_ const bool enabled) {
+    assert(this->device != nullptr);
+    if (sampler.samples(this)) {
+        throw std::logic_error("The channels of an MSR sensor cannot be "
+            "changed while it is being sampled asynchronously.");
+    }
+
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    auto it = std::find_if(this->channels.begin(), this->channels.end(),
+        [channel](const channel_state& c) { return (c.channel == channel); });
+
+    if (!enabled) {
+        if (it != this->channels.end()) {
+            this->channels.erase(it);
+        }
+        return;
+    }
+
+    if (it != this->channels.end()) {
+        // The channel is already being read.
+        return;
+    }
+
+    const auto vendor = machine_topology::instance().vendor();
+    auto vit = channel_configs.find(vendor);
+    if (vit == channel_configs.end()) {
+        throw std::invalid_argument(ERROR_MSG_UNSUPPORTED_CHANNEL);
+    }
+
+    auto cit = vit->second.find(channel);
+    if ((cit == vit->second.end()) || (cit->second.is_supported
+            && !cit->second.is_supported(this->core))) {
+        throw std::invalid_argument(ERROR_MSG_UNSUPPORTED_CHANNEL);
+    }
+
+    channel_state state;
+    state.channel = channel;
+    state.config = cit->second;
+    state.last_value = 0;
+    state.primed = false;
+    state.unit_divisor = 1.0;
+
+    // Many of the registers are model-specific, so we need to make sure that
+    // we can actually read it, because a failure would invalidate the
+    // batched read of all other registers of the device, too.
+    try {
+        this->device->read(state.config.data_location);
+    } catch (...) {
+        throw std::invalid_argument(ERROR_MSG_UNSUPPORTED_CHANNEL);
+    }
+
+    if (state.config.unit_mask != 0) {
+        const auto units = read_units(this->device, this->topology.package,
+            state.config.unit_location);
+        const auto exp = (units & state.config.unit_mask)
+            >> state.config.unit_offset;
+        state.unit_divisor = std::ldexp(1.0, static_cast<int>(exp));
+    }
+
+    this->channels.push_back(state);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::msr_sensor_impl::energy
+ */
+double visus::power_overwhelming::detail::msr_sensor_impl::energy(
+        void) const {
+    assert(this->device != nullptr);
+    const auto value = this->device->read(this->offset);
+
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    const auto retval = this->accumulated
+        + rapl_energy_delta(value, this->last_sample);
+    return static_cast<double>(retval) / this->unit_divisor;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::msr_sensor_impl::get_channel_samples
+ */
+std::size_t
+visus::power_overwhelming::detail::msr_sensor_impl::get_channel_samples(
+        _Out_writes_opt_(cnt) msr_channel_sample *dst,
+        _In_ const std::size_t cnt) {
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+
+    if (dst == nullptr) {
+        return this->channel_samples.size();
+    }
+
+    const auto retval = (std::min)(cnt, this->channel_samples.size());
+    const auto end = this->channel_samples.begin() + retval;
+    std::copy(this->channel_samples.begin(), end, dst);
+    this->channel_samples.erase(this->channel_samples.begin(), end);
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::msr_sensor_impl::has_channel
+ */
+bool visus::power_overwhelming::detail::msr_sensor_impl::has_channel(
+        _In_ const msr_channel channel) const {
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    return std::any_of(this->channels.begin(), this->channels.end(),
+        [channel](const channel_state& c) { return (c.channel == channel); });
+}
+
+
 /*
  * visus::power_overwhelming::detail::msr_sensor_impl::read
  */
@@ -119,12 +364,36 @@ visus::power_overwhelming::detail::msr_sensor_impl::read(
 }
 
 
+/*
+ * visus::power_overwhelming::detail::msr_sensor_impl::rearm
+ */
+void visus::power_overwhelming::detail::msr_sensor_impl::rearm(void) {
+    assert(this->device != nullptr);
+    const auto value = this->device->read(this->offset);
+
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    this->accumulated += rapl_energy_delta(value, this->last_sample);
+    this->last_sample = value;
+    this->last_time = std::chrono::system_clock::now();
+
+    // The counters of the channels must not report the increment over the
+    // pause either, so they need a new baseline from the first tick.
+    for (auto& c : this->channels) {
+        c.primed = false;
+    }
+}
+
+
 /*
  * visus::power_overwhelming::detail::msr_sensor_impl::sample
  */
 void visus::power_overwhelming::detail::msr_sensor_impl::sample(void) {
     assert(this->device != nullptr);
-    this->last_sample = this->device->read(this->offset);
+    const auto value = this->device->read(this->offset);
+
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    this->accumulated = 0;
+    this->last_sample = value;
     this->last_time = std::chrono::system_clock::now();
 }
 
@@ -136,23 +405,86 @@ visus::power_overwhelming::measurement_data
 visus::power_overwhelming::detail::msr_sensor_impl::sample(
         _In_ const timestamp_resolution resolution) const {
     assert(this->device != nullptr);
-    typedef std::chrono::duration<measurement_data::value_type> seconds_type;
+    std::vector<std::streamoff> offsets(1, this->offset);
+
+    {
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        for (auto& c : this->channels) {
+            offsets.push_back(c.config.data_location);
+        }
+    }
+
+    if (offsets.size() == 1) {
+        return this->sample(this->device->read(this->offset), resolution);
+    }
+
+    // Read the energy and all channels in a single request to the device.
+    std::vector<msr_device::sample_type> values(offsets.size());
+    this->device->read(offsets.data(), values.data(), offsets.size());
+
+    const auto retval = this->sample(values.front(), resolution);
+    for (std::size_t i = 1; i < values.size(); ++i) {
+        this->sample_channel(i - 1, values[i], retval.timestamp());
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::msr_sensor_impl::sample
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::detail::msr_sensor_impl::sample(
+        _In_ const msr_device::sample_type value,
+        _In_ const timestamp_resolution resolution) const {
+    if (resolution == timestamp_resolution::nanoseconds) {
+        throw std::invalid_argument("Timestamps of MSR sensors cannot be "
+            "created in nanoseconds.");
+    }
+
+    return this->sample(value, get_timestamp_converter(resolution));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::msr_sensor_impl::sample
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::detail::msr_sensor_impl::sample(
+        _In_ const msr_device::sample_type value,
+        _In_ const timestamp_converter converter) const {
+    return this->sample(value, std::chrono::system_clock::now(), converter);
+}
 
-    // Obtain new readings.
-    const auto value = this->device->read(this->offset);
-    const auto now = std::chrono::system_clock::now();
+
+/*
+ * visus::power_overwhelming::detail::msr_sensor_impl::sample
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::detail::msr_sensor_impl::sample(
+        _In_ const msr_device::sample_type value,
+        _In_ const std::chrono::system_clock::time_point& time,
+        _In_ const timestamp_converter converter) const {
+    assert(converter != nullptr);
+    typedef std::chrono::duration<double> seconds_type;
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    const auto& now = time;
 
     // Compute the difference and convert it to Joules by applying the
-    // divisor obtained during initialisation.
-    const auto dv = value - this->last_sample;
-    auto sample_value = static_cast<measurement_data::value_type>(dv)
-        / this->unit_divisor;
+    // divisor obtained during initialisation. The difference is computed
+    // modulo the width of the counter, which handles wrapping registers. The
+    // result is only narrowed to the value type of the sample once the power
+    // has been computed in double precision.
+    const auto dv = rapl_energy_delta(value, this->last_sample);
+    this->accumulated += dv;
+    auto sample_value = static_cast<double>(dv) / this->unit_divisor;
 
     // Compute the time elapsed since the last call to the method. We use that
     // to compute the point in time for the sample in between the two calls.
     const auto dt = now - this->last_time;
     const auto sample_time = this->last_time + dt / 2;
-    const auto timestamp = convert(sample_time, resolution);
+    const auto timestamp = converter(convert_to_file_time(sample_time));
 
     sample_value /= std::chrono::duration_cast<seconds_type>(dt).count();
 
@@ -160,7 +492,80 @@ visus::power_overwhelming::detail::msr_sensor_impl::sample(
     this->last_sample = value;
     this->last_time = now;
 
-    return measurement_data(timestamp, sample_value);
+    return measurement_data(timestamp,
+        static_cast<measurement_data::value_type>(sample_value));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::msr_sensor_impl::sample_channel
+ */
+void visus::power_overwhelming::detail::msr_sensor_impl::sample_channel(
+        _In_ const std::size_t index,
+        _In_ const msr_device::sample_type value,
+        _In_ const msr_channel_sample::timestamp_type timestamp) const {
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    if (index >= this->channels.size()) {
+        return;
+    }
+
+    auto& c = this->channels[index];
+    auto v = static_cast<double>(value);
+
+    if (c.config.counter_mask != 0) {
+        // The increment of the counter is computed modulo its width like for
+        // the energy counter.
+        const auto primed = c.primed;
+        const auto delta = (value - c.last_value) & c.config.counter_mask;
+        c.last_value = value;
+        c.primed = true;
+
+        if (!primed) {
+            return;
+        }
+
+        v = static_cast<double>(delta) / c.unit_divisor;
+    }
+
+    if (this->channel_samples.size() >= max_channel_samples) {
+        this->channel_samples.pop_front();
+    }
+
+    this->channel_samples.emplace_back(timestamp, c.channel, v);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::msr_sensor_impl::scope_key
+ */
+visus::power_overwhelming::detail::msr_sensor_impl::scope_key_type
+visus::power_overwhelming::detail::msr_sensor_impl::scope_key(
+        _In_ const std::streamoff offset,
+        _In_ const rapl_domain_scope scope) const noexcept {
+    constexpr auto any = (std::numeric_limits<std::uint32_t>::max)();
+    const auto die = (scope != rapl_domain_scope::package)
+        ? this->topology.die
+        : any;
+    auto core = any;
+
+    switch (scope) {
+        case rapl_domain_scope::package:
+        case rapl_domain_scope::die:
+            // All cores of the package or die share the register.
+            break;
+
+        case rapl_domain_scope::core:
+            core = this->topology.core;
+            break;
+
+        case rapl_domain_scope::thread:
+            // The logical CPU is unique on the machine, so it can be used in
+            // place of the physical core.
+            core = this->core;
+            break;
+    }
+
+    return scope_key_type(offset, this->topology.package, die, core);
 }
 
 
@@ -173,13 +578,11 @@ void visus::power_overwhelming::detail::msr_sensor_impl::set(
         _In_opt_ const msr_magic_config *config_override) {
     // Before doing anything else, we need to find out the CPU vendor for being
     // able to decide what the offset of the RAPL domain is (and where the
-    // divisor for the energy unit is located). In order to make sure that we
-    // read the CPUID of the correct socket, we set the thread affinity to the
-    // core requested by the user. If this fails, the core does not exist, so we
-    // do not need to continue anyway.
-    thread_affinity_scope affinity_scope(core);
-
-    const auto vendor = get_cpu_vendor();
+    // divisor for the energy unit is located). The vendor is the same for all
+    // cores, so we use the cached one instead of migrating the thread to the
+    // core and running CPUID there for every sensor.
+    const auto& machine = machine_topology::instance();
+    const auto vendor = machine.vendor();
     if (vendor == cpu_vendor::unknown) {
         throw std::runtime_error("The vendor of the CPU could not be "
             "determined, which is vital for initialising the RAPL domain "
@@ -220,14 +623,28 @@ void visus::power_overwhelming::detail::msr_sensor_impl::set(
     this->core = core;
     this->domain = domain;
     this->offset = config.data_location;
+    this->scope = config.scope;
+    try {
+        this->topology = machine.topology(core);
+    } catch (...) {
+        // Without the topology, we cannot share the register with other cores,
+        // so we treat every logical CPU as a separate package.
+        this->scope = rapl_domain_scope::core;
+        this->topology.package = core;
+        this->topology.die = core;
+        this->topology.core = core;
+    }
     this->sensor_name = L"msr/" + std::to_wstring(this->core) + L"/"
         + to_string(this->domain);
 
-    // Next, retrieve the unit conversion constants for the values.
+    // Next, retrieve the unit conversion constants for the values. The units
+    // are the same for all registers of a package, so we read the register
+    // only for the first sensor of each package.
     {
-        auto divisor = this->device->read(config.unit_location);
+        auto divisor = read_units(this->device, this->topology.package,
+            config.unit_location);
         divisor = (divisor & config.unit_mask) >> config.unit_offset;
-        this->unit_divisor = static_cast<measurement::value_type>(1 << divisor);
+        this->unit_divisor = static_cast<double>(1 << divisor);
     }
 
     // Finally, retrieve a first sample, because we need a reference whenever
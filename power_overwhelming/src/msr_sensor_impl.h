@@ -6,15 +6,23 @@
 #pragma once
 
 #include <chrono>
+#include <deque>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <tuple>
 #include <vector>
 
 #include "power_overwhelming/cpu_affinity.h"
 #include "power_overwhelming/cpu_info.h"
+#include "power_overwhelming/msr_channel_sample.h"
 #include "power_overwhelming/msr_sensor.h"
 #include "power_overwhelming/rapl_domain.h"
 #include "power_overwhelming/measurement.h"
 
+#include "cached_discovery.h"
 #include "msr_device_factory.h"
+#include "msr_magic.h"
 #include "msr_sampler_context.h"
 #include "sampler.h"
 
@@ -23,15 +31,53 @@ namespace visus {
 namespace power_overwhelming {
 namespace detail {
 
-    /* Forward declarations. */
-    struct msr_magic_config;
-
 
     /// <summary>
     /// Private data container for the <see cref="msr_sensor" />.
     /// </summary>
     struct msr_sensor_impl final {
 
+        /// <summary>
+        /// The state of an additional channel that is read along with the
+        /// energy counter.
+        /// </summary>
+        struct channel_state {
+            msr_channel channel;
+            msr_channel_config config;
+            msr_device::sample_type last_value;
+            bool primed;
+            double unit_divisor;
+        };
+
+        /// <summary>
+        /// The type of a key identifying a RAPL register uniquely on the
+        /// machine, which is the offset and the package, die and core, each of
+        /// which is only set if the register is specific for it.
+        /// </summary>
+        typedef std::tuple<std::streamoff, std::uint32_t, std::uint32_t,
+            std::uint32_t> scope_key_type;
+
+        /// <summary>
+        /// The type of an entry in the <see cref="catalogue" />, which is a
+        /// combination of a core and a RAPL domain that can be sampled on the
+        /// machine and the key of the register being read.
+        /// </summary>
+        typedef std::tuple<msr_device::core_type, rapl_domain, scope_key_type>
+            catalogue_entry_type;
+
+        /// <summary>
+        /// The type of a key identifying the register holding the energy units
+        /// of a package, which is the package and the offset of the register.
+        /// </summary>
+        typedef std::tuple<std::uint32_t, std::streamoff> unit_key_type;
+
+        /// <summary>
+        /// All combinations of cores and RAPL domains that are available on
+        /// the machine, which are enumerated only once until the
+        /// <see cref="device_catalogue" /> changes.
+        /// </summary>
+        static cached_discovery<catalogue_entry_type> catalogue;
+
         /// <summary>
         /// Determines which RAPL domains are in principle supported for the
         /// given CPU vendor.
@@ -47,11 +93,46 @@ namespace detail {
         static std::vector<rapl_domain> supported_domains(
             _In_ const cpu_vendor vendor);
 
+        /// <summary>
+        /// The maximum number of channel samples retained in
+        /// <see cref="channel_samples" />, which are discarded from the front
+        /// if nobody retrieves them.
+        /// </summary>
+        static constexpr std::size_t max_channel_samples = 1 << 16;
+
         /// <summary>
         /// A sampler for MSR sensors.
         /// </summary>
         static detail::sampler<msr_sampler_context> sampler;
 
+        /// <summary>
+        /// The raw values of the unit registers that have already been read,
+        /// which are shared by all sensors of the same package.
+        /// </summary>
+        static std::map<unit_key_type, msr_device::sample_type> units;
+
+        /// <summary>
+        /// Protects <see cref="units" />.
+        /// </summary>
+        static std::mutex units_lock;
+
+        /// <summary>
+        /// The values of the <see cref="channels" /> that have not yet been
+        /// retrieved.
+        /// </summary>
+        mutable std::deque<msr_channel_sample> channel_samples;
+
+        /// <summary>
+        /// The additional channels that are read along with the energy
+        /// counter.
+        /// </summary>
+        /// <remarks>
+        /// The channels can only be changed while the sensor is not sampled
+        /// asynchronously, because the sampler builds its batched reads from
+        /// them.
+        /// </remarks>
+        mutable std::vector<channel_state> channels;
+
         /// <summary>
         /// The core the sensor is sampling.
         /// </summary>
@@ -67,6 +148,15 @@ namespace detail {
         /// </summary>
         rapl_domain domain;
 
+        /// <summary>
+        /// The number of energy units accumulated since the first sample.
+        /// </summary>
+        /// <remarks>
+        /// This counter is 64 bits wide and therefore does not wrap like the
+        /// register itself.
+        /// </remarks>
+        mutable std::uint64_t accumulated;
+
         /// <summary>
         /// The value of the last sample.
         /// </summary>
@@ -82,25 +172,100 @@ namespace detail {
         /// </summary>
         std::streamoff offset;
 
+        /// <summary>
+        /// Protects <see cref="accumulated" />, <see cref="last_sample" />,
+        /// <see cref="last_time" />, <see cref="channels" /> and
+        /// <see cref="channel_samples" /> against concurrent samples and
+        /// queries of the accumulated energy.
+        /// </summary>
+        mutable std::mutex lock;
+
+        /// <summary>
+        /// Specifies which logical CPUs share the register the sensor reads.
+        /// </summary>
+        rapl_domain_scope scope;
+
         /// <summary>
         /// The sensor name.
         /// </summary>
         std::wstring sensor_name;
 
+        /// <summary>
+        /// The location of <see cref="core" /> in the topology of the machine.
+        /// </summary>
+        cpu_topology topology;
+
         /// <summary>
         /// The divisor that allows conversion of samples to Joules.
         /// </summary>
         /// <remarks>
         /// As we are solely sampling the accumulated energy consumption in our
-        /// sensor, it is sufficient to have this single divisor.
+        /// sensor, it is sufficient to have this single divisor. The divisor
+        /// is stored in double precision such that the energy accumulated
+        /// over long runs can be converted without loss.
         /// </remarks>
-        measurement::value_type unit_divisor;
+        double unit_divisor;
 
         /// <summary>
         /// Initialises a new instance.
         /// </summary>
-        inline msr_sensor_impl(void) : core(0), domain(rapl_domain::package),
-            last_sample(0), offset(0), unit_divisor(1) { }
+        inline msr_sensor_impl(void) : core(0),
+            domain(rapl_domain::package), accumulated(0), last_sample(0),
+            offset(0),
+            scope(rapl_domain_scope::core), unit_divisor(1) {
+            this->topology.package = 0;
+            this->topology.die = 0;
+            this->topology.core = 0;
+        }
+
+        /// <summary>
+        /// Enables or disables reading the given channel along with the
+        /// energy counter.
+        /// </summary>
+        /// <param name="channel">The channel to be changed.</param>
+        /// <param name="enabled"><c>true</c> for reading the channel,
+        /// <c>false</c> for not reading it.</param>
+        /// <exception cref="std::invalid_argument">If the channel is being
+        /// enabled, but not supported on the core of the sensor.</exception>
+        /// <exception cref="std::logic_error">If the sensor is being sampled
+        /// asynchronously.</exception>
+        void enable_channel(_In_ const msr_channel channel,
+            _In_ const bool enabled);
+
+        /// <summary>
+        /// Answer the energy in Joules that has been accumulated since the
+        /// first sample, including the energy since the last sample.
+        /// </summary>
+        /// <remarks>
+        /// This method reads the register, but does not record it to
+        /// <see cref="last_sample" />. Callers need to sample the sensor at
+        /// least once per wrap period of the register for the result to be
+        /// correct.
+        /// </remarks>
+        /// <returns>The accumulated energy in Joules.</returns>
+        double energy(void) const;
+
+        /// <summary>
+        /// Retrieves and removes the oldest <see cref="channel_samples" />.
+        /// </summary>
+        /// <param name="dst">The buffer to receive the samples. If this is
+        /// <c>nullptr</c>, the number of available samples is returned.
+        /// </param>
+        /// <param name="cnt">The number of elements in
+        /// <paramref name="dst" />.</param>
+        /// <returns>The number of samples written or available.</returns>
+        std::size_t get_channel_samples(
+            _Out_writes_opt_(cnt) msr_channel_sample *dst,
+            _In_ const std::size_t cnt);
+
+        /// <summary>
+        /// Answer whether the given channel is read along with the energy
+        /// counter.
+        /// </summary>
+        /// <param name="channel">The channel to be checked.</param>
+        /// <returns><c>true</c> if the channel is enabled, <c>false</c>
+        /// otherwise.</returns>
+        bool has_channel(_In_ const msr_channel channel) const;
 
         /// <summary>
         /// Reads the current value of the register and optionally performs the
@@ -115,6 +280,18 @@ namespace detail {
         /// <returns>The current value of the MSR.</returns>
         msr_device::sample_type read(_In_ const bool convert) const;
 
+        /// <summary>
+        /// Establishes a new baseline for computing the power of the next
+        /// sample from the current value of the register.
+        /// </summary>
+        /// <remarks>
+        /// This method is used when asynchronous sampling is resumed, such that
+        /// the first sample does not average over the time the sensor was not
+        /// sampled. The energy consumed in the meantime is retained in
+        /// <see cref="accumulated" />.
+        /// </remarks>
+        void rearm(void);
+
         /// <summary>
         /// Read a new sample into <see cref="last_value" />.
         /// </summary>
@@ -129,6 +306,93 @@ namespace detail {
         /// <returns>The result of the measurement.</returns>
         measurement_data sample(_In_ const timestamp_resolution resolution) const;
 
+        /// <summary>
+        /// Create a measurement from the difference of the given register
+        /// value to <see cref="last_value" />.
+        /// </summary>
+        /// <remarks>
+        /// This method allows callers to read all registers of a device at once
+        /// and evaluate the sensors afterwards.
+        /// </remarks>
+        /// <param name="value">The current raw value of the register at
+        /// <see cref="offset" />.</param>
+        /// <param name="resolution">The resolution of the timestamp being
+        /// created.</param>
+        /// <returns>The result of the measurement.</returns>
+        measurement_data sample(_In_ const msr_device::sample_type value,
+            _In_ const timestamp_resolution resolution) const;
+
+        /// <summary>
+        /// Create a measurement from the difference of the given register
+        /// value to <see cref="last_value" /> using a timestamp converter that
+        /// has been resolved in advance.
+        /// </summary>
+        /// <param name="value">The current raw value of the register at
+        /// <see cref="offset" />.</param>
+        /// <param name="converter">The converter creating the timestamp of the
+        /// requested resolution from a <see cref="FILETIME" />.</param>
+        /// <returns>The result of the measurement.</returns>
+        measurement_data sample(_In_ const msr_device::sample_type value,
+            _In_ const timestamp_converter converter) const;
+
+        /// <summary>
+        /// Create a measurement from the difference of the given register
+        /// value to <see cref="last_value" />, which has been read at the
+        /// given point in time.
+        /// </summary>
+        /// <remarks>
+        /// This method is used for registers that have been read in advance,
+        /// e.g. by the kernel-mode sampler of the driver, which delivers the
+        /// time of each reading along with the values.
+        /// </remarks>
+        /// <param name="value">The raw value of the register at
+        /// <see cref="offset" />.</param>
+        /// <param name="time">The point in time when the register has been
+        /// read. This must not be before the previous sample.</param>
+        /// <param name="converter">The converter creating the timestamp of the
+        /// requested resolution from a <see cref="FILETIME" />.</param>
+        /// <returns>The result of the measurement.</returns>
+        measurement_data sample(_In_ const msr_device::sample_type value,
+            _In_ const std::chrono::system_clock::time_point& time,
+            _In_ const timestamp_converter converter) const;
+
+        /// <summary>
+        /// Records the value of the channel at the given index in
+        /// <see cref="channels" />, which has been read along with the sample
+        /// having the given timestamp.
+        /// </summary>
+        /// <remarks>
+        /// The first value of a counter only establishes the baseline for the
+        /// increment and does not produce a sample.
+        /// </remarks>
+        /// <param name="index">The index of the channel, which is ignored if
+        /// it is out of range.</param>
+        /// <param name="value">The raw value of the register of the channel.
+        /// </param>
+        /// <param name="timestamp">The timestamp of the power sample.</param>
+        void sample_channel(_In_ const std::size_t index,
+            _In_ const msr_device::sample_type value,
+            _In_ const msr_channel_sample::timestamp_type timestamp) const;
+
+        /// <summary>
+        /// Gets a key that is the same for all sensors reading the same
+        /// physical register, regardless of the logical CPU they use.
+        /// </summary>
+        /// <returns>The key identifying the physical register.</returns>
+        inline scope_key_type scope_key(void) const noexcept {
+            return this->scope_key(this->offset, this->scope);
+        }
+
+        /// <summary>
+        /// Gets a key that is the same for all sensors reading the physical
+        /// register at the given offset, which is shared by the given scope.
+        /// </summary>
+        /// <param name="offset">The offset of the register.</param>
+        /// <param name="scope">The logical CPUs sharing the register.</param>
+        /// <returns>The key identifying the physical register.</returns>
+        scope_key_type scope_key(_In_ const std::streamoff offset,
+            _In_ const rapl_domain_scope scope) const noexcept;
+
         /// <summary>
         /// Sets the initial parameters.
         /// </summary>
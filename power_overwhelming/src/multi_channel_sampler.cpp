@@ -0,0 +1,180 @@
+﻿// <copyright file="multi_channel_sampler.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "multi_channel_sampler.h"
+
+#include <cassert>
+#include <stdexcept>
+
+
+/*
+ * visus::power_overwhelming::detail::multi_channel_sampler::to_sample
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::detail::multi_channel_sampler::to_sample(
+        _In_ const multi_channel_sensor::timestamp_type timestamp,
+        _In_ const multi_channel_sensor::value_type value,
+        _In_ const measurement_quantity quantity) noexcept {
+    const auto invalid = measurement_data::invalid_value;
+
+    switch (quantity) {
+        case measurement_quantity::current:
+            return measurement_data(timestamp, invalid, value, invalid);
+
+        case measurement_quantity::voltage:
+            return measurement_data(timestamp, value, invalid, invalid);
+
+        default:
+            return measurement_data(timestamp, invalid, invalid, value);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::multi_channel_sampler::multi_channel_sampler
+ */
+visus::power_overwhelming::detail::multi_channel_sampler::multi_channel_sampler(
+        _In_ const multi_channel_sensor& source)
+    : _channel_callback(nullptr), _context(nullptr), _data_callback(nullptr),
+        _source(source), _task(&multi_channel_sampler::tick, this) { }
+
+
+/*
+ * visus::power_overwhelming::detail::multi_channel_sampler::~multi_channel_sampler
+ */
+visus::power_overwhelming::detail::multi_channel_sampler::~multi_channel_sampler(
+        void) {
+    this->stop();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::multi_channel_sampler::running
+ */
+bool visus::power_overwhelming::detail::multi_channel_sampler::running(
+        void) const noexcept {
+    return ((this->_channel_callback != nullptr)
+        || (this->_data_callback != nullptr));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::multi_channel_sampler::start
+ */
+void visus::power_overwhelming::detail::multi_channel_sampler::start(
+        _In_ const multi_channel_sensor::channel_callback callback,
+        _In_opt_ void *context,
+        _In_ const interval_type interval) {
+    assert(callback != nullptr);
+    if (this->running()) {
+        throw std::logic_error("Asynchronous sampling cannot be started "
+            "while it is already running.");
+    }
+
+    this->_channel_callback = callback;
+    this->_context = context;
+    this->schedule(interval);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::multi_channel_sampler::start
+ */
+void visus::power_overwhelming::detail::multi_channel_sampler::start(
+        _In_ const measurement_data_callback callback,
+        _In_opt_ void *context,
+        _In_ const interval_type interval) {
+    assert(callback != nullptr);
+    if (this->running()) {
+        throw std::logic_error("Asynchronous sampling cannot be started "
+            "while it is already running.");
+    }
+
+    this->_data_callback = callback;
+    this->_context = context;
+    this->schedule(interval);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::multi_channel_sampler::stop
+ */
+void visus::power_overwhelming::detail::multi_channel_sampler::stop(void) {
+    if (this->running()) {
+        sampler_scheduler::instance().cancel(this->_task);
+        this->_channel_callback = nullptr;
+        this->_context = nullptr;
+        this->_data_callback = nullptr;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::multi_channel_sampler::tick
+ */
+bool visus::power_overwhelming::detail::multi_channel_sampler::tick(
+        _In_ void *context) {
+    assert(context != nullptr);
+    auto that = static_cast<multi_channel_sampler *>(context);
+
+    try {
+        const auto timestamp = that->_source.sample_channels(
+            that->_values.data(), that->_values.size());
+
+        if (that->_channel_callback != nullptr) {
+            that->_channel_callback(that->_source, &timestamp,
+                that->_values.data(), 1, that->_context);
+
+        } else if (that->_data_callback != nullptr) {
+            // All channels share the timestamp of the read, but consumers of
+            // the sensor interface identify the values by their names.
+            for (std::size_t i = 0; i < that->_values.size(); ++i) {
+                const auto sample = to_sample(timestamp, that->_values[i],
+                    that->_quantities[i]);
+                that->_data_callback(that->_names[i].c_str(), &sample, 1,
+                    that->_context);
+            }
+        }
+    } catch (...) {
+        // A failed read only loses the values of this tick, because there is
+        // no one to report the error to.
+    }
+
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::multi_channel_sampler::schedule
+ */
+void visus::power_overwhelming::detail::multi_channel_sampler::schedule(
+        _In_ const interval_type interval) {
+    const auto cnt = this->_source.channels();
+
+    // The descriptors are retrieved once, such that the sampler thread does
+    // not need to call into the sensor for them.
+    this->_names.clear();
+    this->_names.reserve(cnt);
+    this->_quantities.clear();
+    this->_quantities.reserve(cnt);
+    for (std::size_t i = 0; i < cnt; ++i) {
+        const auto channel = this->_source.channel(i);
+        this->_names.emplace_back((channel.name() != nullptr)
+            ? channel.name()
+            : L"");
+        this->_quantities.push_back(channel.quantity());
+    }
+
+    this->_values.resize(cnt);
+
+    try {
+        sampler_scheduler::instance().schedule(this->_task, interval);
+    } catch (...) {
+        this->_channel_callback = nullptr;
+        this->_context = nullptr;
+        this->_data_callback = nullptr;
+        throw;
+    }
+}
@@ -0,0 +1,132 @@
+﻿// <copyright file="multi_channel_sampler.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "power_overwhelming/multi_channel_sensor.h"
+
+#include "sampler_scheduler.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Periodically reads all channels of a
+    /// <see cref="multi_channel_sensor" /> on the
+    /// <see cref="sampler_scheduler" />.
+    /// </summary>
+    /// <remarks>
+    /// The sampler delivers the reads either as rows of channel values or as
+    /// one <see cref="measurement_data" /> per channel, which is what
+    /// consumers of the <see cref="sensor" /> interface expect.
+    /// </remarks>
+    class multi_channel_sampler final {
+
+    public:
+
+        /// <summary>
+        /// The type of the interval between two reads.
+        /// </summary>
+        typedef sampler_scheduler::interval_type interval_type;
+
+        /// <summary>
+        /// Converts the value of a channel into a sample.
+        /// </summary>
+        /// <param name="timestamp">The timestamp of the read.</param>
+        /// <param name="value">The value of the channel.</param>
+        /// <param name="quantity">The quantity measured by the channel.
+        /// </param>
+        /// <returns>A sample holding only the given quantity.</returns>
+        static measurement_data to_sample(
+            _In_ const multi_channel_sensor::timestamp_type timestamp,
+            _In_ const multi_channel_sensor::value_type value,
+            _In_ const measurement_quantity quantity) noexcept;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="source">The sensor to be read, which must outlive
+        /// the sampler.</param>
+        explicit multi_channel_sampler(
+            _In_ const multi_channel_sensor& source);
+
+        multi_channel_sampler(const multi_channel_sampler&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~multi_channel_sampler(void);
+
+        /// <summary>
+        /// Answer whether the sampler is running.
+        /// </summary>
+        /// <returns><c>true</c> if the sensor is being read, <c>false</c>
+        /// otherwise.</returns>
+        bool running(void) const noexcept;
+
+        /// <summary>
+        /// Starts delivering the reads as rows of channel values.
+        /// </summary>
+        /// <param name="callback">The callback receiving the reads.</param>
+        /// <param name="context">A user-defined pointer passed to the
+        /// callback.</param>
+        /// <param name="interval">The interval between two reads.</param>
+        /// <exception cref="std::logic_error">If the sampler is already
+        /// running.</exception>
+        void start(_In_ const multi_channel_sensor::channel_callback callback,
+            _In_opt_ void *context,
+            _In_ const interval_type interval);
+
+        /// <summary>
+        /// Starts delivering the reads as one sample per channel.
+        /// </summary>
+        /// <param name="callback">The callback receiving the samples.</param>
+        /// <param name="context">A user-defined pointer passed to the
+        /// callback.</param>
+        /// <param name="interval">The interval between two reads.</param>
+        /// <exception cref="std::logic_error">If the sampler is already
+        /// running.</exception>
+        void start(_In_ const measurement_data_callback callback,
+            _In_opt_ void *context,
+            _In_ const interval_type interval);
+
+        /// <summary>
+        /// Stops the sampler and waits for a read in progress to complete.
+        /// </summary>
+        void stop(void);
+
+        multi_channel_sampler& operator =(
+            const multi_channel_sampler&) = delete;
+
+    private:
+
+        /// <summary>
+        /// The callback of the <see cref="_task" />.
+        /// </summary>
+        static bool tick(_In_ void *context);
+
+        /// <summary>
+        /// Prepares the buffers and schedules the <see cref="_task" />.
+        /// </summary>
+        void schedule(_In_ const interval_type interval);
+
+        multi_channel_sensor::channel_callback _channel_callback;
+        std::vector<measurement_quantity> _quantities;
+        void *_context;
+        measurement_data_callback _data_callback;
+        std::vector<std::wstring> _names;
+        const multi_channel_sensor& _source;
+        sampler_scheduler::task _task;
+        std::vector<multi_channel_sensor::value_type> _values;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
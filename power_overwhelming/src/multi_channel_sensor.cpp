@@ -0,0 +1,117 @@
+﻿// <copyright file="multi_channel_sensor.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/multi_channel_sensor.h"
+
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+#include "multi_channel_sampler.h"
+
+
+/*
+ * visus::power_overwhelming::multi_channel_sensor::~multi_channel_sensor
+ */
+visus::power_overwhelming::multi_channel_sensor::~multi_channel_sensor(void) {
+    delete this->_sampler;
+}
+
+
+/*
+ * visus::power_overwhelming::multi_channel_sensor::sample_channels
+ */
+visus::power_overwhelming::multi_channel_sensor::timestamp_type
+visus::power_overwhelming::multi_channel_sensor::sample_channels(
+        _Out_writes_(cnt) value_type *dst,
+        _In_ const std::size_t cnt,
+        _In_ const timestamp_resolution resolution) const {
+    this->check_not_disposed();
+
+    if (dst == nullptr) {
+        throw std::invalid_argument("The output buffer for the channels must "
+            "not be null.");
+    }
+    if (cnt < this->channels()) {
+        throw std::invalid_argument("The output buffer must be large enough "
+            "to hold all channels of the sensor.");
+    }
+
+    return this->sample_channels_sync(dst, resolution);
+}
+
+
+/*
+ * visus::power_overwhelming::multi_channel_sensor::sample_channels
+ */
+void visus::power_overwhelming::multi_channel_sensor::sample_channels(
+        _In_opt_ const channel_callback on_batch,
+        _In_ const microseconds_type period,
+        _In_opt_ void *context) {
+    typedef detail::multi_channel_sampler::interval_type interval_type;
+
+    if (on_batch != nullptr) {
+        this->check_not_disposed();
+        if (this->_sampler == nullptr) {
+            this->_sampler = new detail::multi_channel_sampler(*this);
+        }
+        this->_sampler->start(on_batch, context, std::chrono::duration_cast<
+            interval_type>(std::chrono::microseconds(period)));
+
+    } else if (this->_sampler != nullptr) {
+        // Note: We do not check for the sensor being disposed here, because
+        // implementations use this to stop sampling in their destructors.
+        this->_sampler->stop();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::multi_channel_sensor::sample_batch
+ */
+void visus::power_overwhelming::multi_channel_sensor::sample_batch(
+        _In_opt_ const measurement_data_callback on_batch,
+        _In_ const microseconds_type period,
+        _In_opt_ void *context) {
+    typedef detail::multi_channel_sampler::interval_type interval_type;
+
+    if (on_batch != nullptr) {
+        this->check_not_disposed();
+        if (this->_sampler == nullptr) {
+            this->_sampler = new detail::multi_channel_sampler(*this);
+        }
+        this->_sampler->start(on_batch, context, std::chrono::duration_cast<
+            interval_type>(std::chrono::microseconds(period)));
+
+    } else if (this->_sampler != nullptr) {
+        this->_sampler->stop();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::multi_channel_sensor::multi_channel_sensor
+ */
+visus::power_overwhelming::multi_channel_sensor::multi_channel_sensor(
+    void) noexcept : _sampler(nullptr) { }
+
+
+/*
+ * visus::power_overwhelming::multi_channel_sensor::sample_sync
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::multi_channel_sensor::sample_sync(
+        _In_ const timestamp_resolution resolution) const {
+    std::vector<value_type> values(this->channels());
+    if (values.empty()) {
+        throw std::logic_error("A multi-channel sensor without channels "
+            "cannot be sampled.");
+    }
+
+    const auto timestamp = this->sample_channels(values.data(),
+        values.size(), resolution);
+    return detail::multi_channel_sampler::to_sample(timestamp, values[0],
+        this->channel(0).quantity());
+}
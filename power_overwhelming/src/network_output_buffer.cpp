@@ -0,0 +1,439 @@
+﻿// <copyright file="network_output_buffer.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "network_output_buffer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include "power_overwhelming/convert_string.h"
+
+// WinSock2.h must be included before Windows.h.
+#include "socket_functions.h"
+
+#include "binary_output.h"
+#include "library_thread.h"
+#include "on_exit.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The time a send may block without any progress before the connection
+    /// is considered broken.
+    /// </summary>
+    static constexpr int network_send_timeout = 10;
+
+    /// <summary>
+    /// The size of the header of a record in the binary output.
+    /// </summary>
+    static constexpr std::size_t network_record_header
+        = sizeof(std::uint32_t) + sizeof(std::uint64_t);
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * ...::detail::network_output_buffer::default_queue_size
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::network_output_buffer::default_queue_size;
+
+
+/*
+ * ...::detail::network_output_buffer::network_output_buffer
+ */
+visus::power_overwhelming::detail::network_output_buffer::network_output_buffer(
+        void) : _broken(false), _dropped(0), _first(true),
+        _queue_size(default_queue_size), _queued(0), _running(false),
+        _socket(INVALID_SOCKET) { }
+
+
+/*
+ * ...::detail::network_output_buffer::~network_output_buffer
+ */
+visus::power_overwhelming::detail::network_output_buffer
+::~network_output_buffer(void) {
+    this->close();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::network_output_buffer::close
+ */
+void visus::power_overwhelming::detail::network_output_buffer::close(
+        void) noexcept {
+    if (!this->is_open()) {
+        return;
+    }
+
+    try {
+        this->sync();
+    } catch (...) {
+        // The pending data are lost if we cannot queue them.
+    }
+
+    {
+        std::lock_guard<decltype(this->_lock)> l(this->_lock);
+        this->_running = false;
+    }
+    this->_signal.notify_one();
+
+    // The sender sends everything queued before it exits, which is bounded by
+    // the timeout of the socket if the remote host stalls.
+    this->_sender.join();
+
+    close_socket(this->_socket);
+    this->_socket = INVALID_SOCKET;
+#if defined(_WIN32)
+    ::WSACleanup();
+#endif /* defined(_WIN32) */
+
+    this->_pending.clear();
+    this->_queue.clear();
+    this->_queued = 0;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::network_output_buffer::connected
+ */
+bool visus::power_overwhelming::detail::network_output_buffer::connected(
+        void) const noexcept {
+    return this->is_open() && !this->_broken.load(std::memory_order_acquire);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::network_output_buffer::open
+ */
+void visus::power_overwhelming::detail::network_output_buffer::open(
+        _In_z_ const wchar_t *address,
+        _In_ const std::size_t queue_size) {
+    if (address == nullptr) {
+        throw std::invalid_argument("The address of the remote host must not "
+            "be null.");
+    }
+    if (queue_size == 0) {
+        throw std::invalid_argument("The send queue must be able to hold at "
+            "least one byte.");
+    }
+
+    this->close();
+
+    // Split the address at the port, which is the last colon unless the host
+    // is an IPv6 address in brackets.
+    auto host = power_overwhelming::convert_string<char>(address);
+    std::string port;
+    {
+        auto colon = host.rfind(':');
+        if ((colon == std::string::npos) || (colon + 1 == host.size())) {
+            throw std::invalid_argument("The address of the remote host must "
+                "include the port.");
+        }
+
+        port = host.substr(colon + 1);
+        host.resize(colon);
+
+        if ((host.size() >= 2) && (host.front() == '[')
+                && (host.back() == ']')) {
+            host = host.substr(1, host.size() - 2);
+        }
+    }
+
+#if defined(_WIN32)
+    {
+        WSADATA wsa_data = { };
+        auto status = ::WSAStartup(MAKEWORD(2, 2), &wsa_data);
+        if (status != 0) {
+            throw std::system_error(status, std::system_category());
+        }
+    }
+
+    auto guard_wsa_cleanup = on_exit([](void) { ::WSACleanup(); });
+#endif /* defined(_WIN32) */
+
+    addrinfo hints = { };
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+
+    addrinfo *addresses = nullptr;
+    const auto status = ::getaddrinfo(host.c_str(), port.c_str(), &hints,
+        &addresses);
+    if (status != 0) {
+#if defined(_WIN32)
+        throw std::system_error(status, std::system_category());
+#else /* defined(_WIN32) */
+        throw std::runtime_error(::gai_strerror(status));
+#endif /* defined(_WIN32) */
+    }
+
+    const auto guard_addresses = on_exit([addresses](void) {
+        ::freeaddrinfo(addresses);
+    });
+
+    // Use the first address we can connect to.
+    auto error = 0;
+    for (auto a = addresses; a != nullptr; a = a->ai_next) {
+        this->_socket = ::socket(a->ai_family, a->ai_socktype,
+            a->ai_protocol);
+        if (this->_socket == INVALID_SOCKET) {
+            error = get_socket_error();
+            continue;
+        }
+
+        if (::connect(this->_socket, a->ai_addr,
+                static_cast<int>(a->ai_addrlen)) != SOCKET_ERROR) {
+            break;
+        }
+
+        error = get_socket_error();
+        close_socket(this->_socket);
+        this->_socket = INVALID_SOCKET;
+    }
+
+    if (this->_socket == INVALID_SOCKET) {
+        if (error == 0) {
+            throw std::runtime_error("The address of the remote host could "
+                "not be resolved.");
+        }
+        throw std::system_error(error, std::system_category());
+    }
+
+    // The batches are large, so there is no point in delaying them. The
+    // timeout makes sure that we detect a stalled remote host.
+    {
+        int value = 1;
+        ::setsockopt(this->_socket, IPPROTO_TCP, TCP_NODELAY,
+            reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+    {
+#if defined(_WIN32)
+        DWORD value = network_send_timeout * 1000;
+#else /* defined(_WIN32) */
+        timeval value = { };
+        value.tv_sec = network_send_timeout;
+#endif /* defined(_WIN32) */
+        ::setsockopt(this->_socket, SOL_SOCKET, SO_SNDTIMEO,
+            reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    this->_broken.store(false, std::memory_order_release);
+    this->_dropped.store(0, std::memory_order_relaxed);
+    this->_first = true;
+    this->_queue_size = queue_size;
+    this->_running = true;
+
+    try {
+        this->_sender = std::thread(&network_output_buffer::send, this);
+    } catch (...) {
+        close_socket(this->_socket);
+        this->_socket = INVALID_SOCKET;
+        throw;
+    }
+
+#if defined(_WIN32)
+    // The socket library is cleaned up when the buffer is closed.
+    guard_wsa_cleanup.cancel();
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::network_output_buffer::overflow
+ */
+visus::power_overwhelming::detail::network_output_buffer::int_type
+visus::power_overwhelming::detail::network_output_buffer::overflow(
+        _In_ int_type c) {
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        this->_pending.push_back(traits_type::to_char_type(c));
+        return c;
+    }
+
+    return traits_type::not_eof(c);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::network_output_buffer::sync
+ */
+int visus::power_overwhelming::detail::network_output_buffer::sync(void) {
+    if (this->_pending.empty()) {
+        return 0;
+    }
+
+    batch_type batch;
+    batch.data = std::move(this->_pending);
+    batch.strippable = !this->_first;
+    this->_pending.clear();
+
+    // The first batch contains the header of the file, which is not a
+    // record and must never be removed.
+    this->_first = false;
+
+    if (this->_broken.load(std::memory_order_acquire)) {
+        this->_dropped.fetch_add(strip_samples(batch.data),
+            std::memory_order_relaxed);
+        return 0;
+    }
+
+    {
+        std::lock_guard<decltype(this->_lock)> l(this->_lock);
+
+        // Make room by removing the samples from the oldest batches first,
+        // which keeps the remote host as close to real time as possible.
+        for (auto it = this->_queue.begin(); (it != this->_queue.end())
+                && (this->_queued + batch.data.size() > this->_queue_size);
+                ++it) {
+            if (it->strippable) {
+                this->_queued -= it->data.size();
+                this->_dropped.fetch_add(strip_samples(it->data),
+                    std::memory_order_relaxed);
+                this->_queued += it->data.size();
+                it->strippable = false;
+            }
+        }
+
+        if (batch.strippable
+                && (this->_queued + batch.data.size() > this->_queue_size)) {
+            this->_dropped.fetch_add(strip_samples(batch.data),
+                std::memory_order_relaxed);
+            batch.strippable = false;
+        }
+
+        // The remaining records describe the stream and are always queued,
+        // even if they exceed the bound.
+        if (!batch.data.empty()) {
+            this->_queued += batch.data.size();
+            this->_queue.push_back(std::move(batch));
+        }
+    }
+
+    this->_signal.notify_one();
+    return 0;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::network_output_buffer::xsputn
+ */
+std::streamsize
+visus::power_overwhelming::detail::network_output_buffer::xsputn(
+        _In_reads_(cnt) const char_type *data,
+        _In_ std::streamsize cnt) {
+    this->_pending.insert(this->_pending.end(), data, data + cnt);
+    return cnt;
+}
+
+
+/*
+ * ...::detail::network_output_buffer::strip_samples
+ */
+std::uint64_t
+visus::power_overwhelming::detail::network_output_buffer::strip_samples(
+        _Inout_ std::vector<char>& batch) {
+    std::uint64_t retval = 0;
+    std::size_t dst = 0;
+    std::size_t src = 0;
+
+    while (src + network_record_header <= batch.size()) {
+        std::uint32_t type;
+        std::uint64_t size;
+        ::memcpy(&type, batch.data() + src, sizeof(type));
+        ::memcpy(&size, batch.data() + src + sizeof(type), sizeof(size));
+
+        const auto end = src + network_record_header + size;
+        if ((end < src) || (end > batch.size())) {
+            // This is not a record we have written, so we keep the rest.
+            break;
+        }
+
+        const auto t = static_cast<binary_record_type>(type);
+        const auto is_samples = (t == binary_record_type::samples)
+            || (t == binary_record_type::compressed_samples);
+
+        if (is_samples && (size >= 2 * sizeof(std::uint32_t))) {
+            // The number of samples follows the index of the sensor.
+            std::uint32_t cnt;
+            ::memcpy(&cnt, batch.data() + src + network_record_header
+                + sizeof(std::uint32_t), sizeof(cnt));
+            retval += cnt;
+
+        } else {
+            if (dst != src) {
+                ::memmove(batch.data() + dst, batch.data() + src,
+                    static_cast<std::size_t>(end - src));
+            }
+            dst += static_cast<std::size_t>(end - src);
+        }
+
+        src = static_cast<std::size_t>(end);
+    }
+
+    if (dst != src) {
+        ::memmove(batch.data() + dst, batch.data() + src, batch.size() - src);
+        dst += batch.size() - src;
+    }
+
+    batch.resize(dst);
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::network_output_buffer::send
+ */
+void visus::power_overwhelming::detail::network_output_buffer::send(void) {
+    enter_library_thread("PwrOwg Network Output Thread");
+
+    while (true) {
+        batch_type batch;
+
+        {
+            std::unique_lock<decltype(this->_lock)> l(this->_lock);
+            this->_signal.wait(l, [this](void) {
+                return (!this->_queue.empty() || !this->_running);
+            });
+
+            if (this->_queue.empty()) {
+                assert(!this->_running);
+                break;
+            }
+
+            batch = std::move(this->_queue.front());
+            this->_queue.pop_front();
+            this->_queued -= batch.data.size();
+        }
+
+        std::size_t offset = 0;
+        while (!this->_broken.load(std::memory_order_acquire)
+                && (offset < batch.data.size())) {
+            const auto rem = batch.data.size() - offset;
+            const auto cnt = ::send(this->_socket, batch.data.data() + offset,
+                static_cast<int>((std::min)(rem, std::size_t(1 << 30))),
+                MSG_NOSIGNAL);
+            if (cnt == SOCKET_ERROR) {
+                this->_broken.store(true, std::memory_order_release);
+            } else {
+                offset += static_cast<std::size_t>(cnt);
+            }
+        }
+
+        if (offset < batch.data.size()) {
+            // Everything we could not send is lost, including the samples
+            // that are queued behind this batch.
+            this->_dropped.fetch_add(strip_samples(batch.data),
+                std::memory_order_relaxed);
+        }
+    }
+}
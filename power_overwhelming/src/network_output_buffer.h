@@ -0,0 +1,186 @@
+﻿// <copyright file="network_output_buffer.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <cinttypes>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A stream buffer that sends the binary output of a collector to a
+    /// remote host via TCP.
+    /// </summary>
+    /// <remarks>
+    /// <para>The data written to the buffer are collected in memory until the
+    /// buffer is synchronised, which turns them into a batch that is queued
+    /// for a dedicated sender thread. The writer of the binary output only
+    /// synchronises its stream after complete records, so each batch starts
+    /// at a record boundary. The bytes received by the remote host form a
+    /// valid binary output file.</para>
+    /// <para>The queue is bounded by <see cref="queue_size" /> bytes. If a
+    /// new batch does not fit, the records with samples are removed from
+    /// the oldest queued batches until it does. All other records, like the
+    /// declarations of sensors and markers, are retained, so that the remote
+    /// host can still decode the samples it receives. The number of samples
+    /// removed is reported by <see cref="dropped" />. The first batch, which
+    /// contains the header of the file, is never modified.</para>
+    /// <para>If the connection fails, all subsequent data are dropped. The
+    /// buffer does not reconnect, because the remote host would miss the
+    /// header of the file.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API network_output_buffer final
+            : public std::streambuf {
+
+    public:
+
+        /// <summary>
+        /// The default bound of the send queue in bytes.
+        /// </summary>
+        static constexpr std::size_t default_queue_size = 16 << 20;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        network_output_buffer(void);
+
+        network_output_buffer(const network_output_buffer&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~network_output_buffer(void);
+
+        /// <summary>
+        /// Sends all pending data, waits for the sender thread to exit and
+        /// closes the connection.
+        /// </summary>
+        void close(void) noexcept;
+
+        /// <summary>
+        /// Answer whether the connection to the remote host is still intact.
+        /// </summary>
+        /// <returns><c>true</c> if the buffer is open and no send has failed,
+        /// <c>false</c> otherwise.</returns>
+        bool connected(void) const noexcept;
+
+        /// <summary>
+        /// Answer the number of samples that have been dropped because the
+        /// queue was full or the connection failed.
+        /// </summary>
+        /// <returns>The number of dropped samples.</returns>
+        inline std::uint64_t dropped(void) const noexcept {
+            return this->_dropped.load(std::memory_order_relaxed);
+        }
+
+        /// <summary>
+        /// Answer whether a connection has been opened.
+        /// </summary>
+        /// <returns><c>true</c> if the buffer is open, <c>false</c>
+        /// otherwise.</returns>
+        inline bool is_open(void) const noexcept {
+            return this->_sender.joinable();
+        }
+
+        /// <summary>
+        /// Connects to the given remote host and starts the sender thread.
+        /// </summary>
+        /// <param name="address">The address of the remote host in the form
+        /// <c>host:port</c>. IPv6 addresses must be enclosed in brackets.
+        /// </param>
+        /// <param name="queue_size">The maximum number of bytes waiting to be
+        /// sent.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="address" /> is <c>nullptr</c> or has no port, or
+        /// if <paramref name="queue_size" /> is zero.</exception>
+        /// <exception cref="std::system_error">If the connection could not be
+        /// established.</exception>
+        /// <exception cref="std::runtime_error">If the host could not be
+        /// resolved.</exception>
+        void open(_In_z_ const wchar_t *address,
+            _In_ const std::size_t queue_size = default_queue_size);
+
+        /// <summary>
+        /// Answer the bound of the send queue.
+        /// </summary>
+        /// <returns>The maximum number of bytes waiting to be sent.</returns>
+        inline std::size_t queue_size(void) const noexcept {
+            return this->_queue_size;
+        }
+
+        network_output_buffer& operator =(
+            const network_output_buffer&) = delete;
+
+    protected:
+
+        /// <inheritdoc />
+        int_type overflow(_In_ int_type c) override;
+
+        /// <inheritdoc />
+        int sync(void) override;
+
+        /// <inheritdoc />
+        std::streamsize xsputn(_In_reads_(cnt) const char_type *data,
+            _In_ std::streamsize cnt) override;
+
+    private:
+
+#if defined(_WIN32)
+        // This is SOCKET, which we do not want to expose, because WinSock2.h
+        // must be included before Windows.h.
+        typedef std::uintptr_t socket_type;
+#else /* defined(_WIN32) */
+        typedef int socket_type;
+#endif /* defined(_WIN32) */
+
+        /// <summary>
+        /// A batch of complete records waiting to be sent.
+        /// </summary>
+        struct batch_type {
+            std::vector<char> data;
+            bool strippable;
+        };
+
+        /// <summary>
+        /// Removes all records with samples from <paramref name="batch" />.
+        /// </summary>
+        /// <returns>The number of samples removed.</returns>
+        static std::uint64_t strip_samples(_Inout_ std::vector<char>& batch);
+
+        /// <summary>
+        /// The body of the sender thread.
+        /// </summary>
+        void send(void);
+
+        std::atomic<bool> _broken;
+        std::atomic<std::uint64_t> _dropped;
+        bool _first;
+        std::mutex _lock;
+        std::vector<char> _pending;
+        std::deque<batch_type> _queue;
+        std::size_t _queue_size;
+        std::size_t _queued;
+        bool _running;
+        std::thread _sender;
+        std::condition_variable _signal;
+        socket_type _socket;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
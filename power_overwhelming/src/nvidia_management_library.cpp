@@ -9,6 +9,9 @@
 #define __POWER_OVERWHELMING_GET_NVML_FUNC(n) \
     this->n = this->get_function<decltype(this->n)>(#n)
 
+#define __POWER_OVERWHELMING_TRY_GET_NVML_FUNC(n) \
+    try { __POWER_OVERWHELMING_GET_NVML_FUNC(n); } catch (...) { }
+
 
 /*
  * visus::power_overwhelming::detail::nvidia_management_library::instance
@@ -30,15 +33,25 @@ visus::power_overwhelming::detail::nvidia_management_library
 #else /* defined(_WIN32) */
         : library_base("libnvidia-ml.so") {
 #endif /* defined(_WIN32) */
+    __POWER_OVERWHELMING_TRY_GET_NVML_FUNC(nvmlDeviceGetClockInfo);
     __POWER_OVERWHELMING_GET_NVML_FUNC(nvmlDeviceGetCount);
+    __POWER_OVERWHELMING_TRY_GET_NVML_FUNC(nvmlDeviceGetFieldValues);
     __POWER_OVERWHELMING_GET_NVML_FUNC(nvmlDeviceGetName);
     __POWER_OVERWHELMING_GET_NVML_FUNC(nvmlDeviceGetPciInfo);
+    __POWER_OVERWHELMING_TRY_GET_NVML_FUNC(nvmlDeviceGetPowerManagementLimit);
+    __POWER_OVERWHELMING_TRY_GET_NVML_FUNC(
+        nvmlDeviceGetPowerManagementLimitConstraints);
     __POWER_OVERWHELMING_GET_NVML_FUNC(nvmlDeviceGetPowerUsage);
+    __POWER_OVERWHELMING_TRY_GET_NVML_FUNC(nvmlDeviceGetProcessUtilization);
+    __POWER_OVERWHELMING_TRY_GET_NVML_FUNC(nvmlDeviceGetSamples);
+    __POWER_OVERWHELMING_TRY_GET_NVML_FUNC(nvmlDeviceGetTotalEnergyConsumption);
+    __POWER_OVERWHELMING_TRY_GET_NVML_FUNC(nvmlDeviceGetUtilizationRates);
     __POWER_OVERWHELMING_GET_NVML_FUNC(nvmlDeviceGetHandleByIndex);
     __POWER_OVERWHELMING_GET_NVML_FUNC(nvmlDeviceGetHandleByPciBusId);
     __POWER_OVERWHELMING_GET_NVML_FUNC(nvmlDeviceGetHandleBySerial);
     __POWER_OVERWHELMING_GET_NVML_FUNC(nvmlDeviceGetHandleByUUID);
     __POWER_OVERWHELMING_GET_NVML_FUNC(nvmlDeviceGetUUID);
+    __POWER_OVERWHELMING_TRY_GET_NVML_FUNC(nvmlDeviceSetPowerManagementLimit);
     __POWER_OVERWHELMING_GET_NVML_FUNC(nvmlErrorString);
     __POWER_OVERWHELMING_GET_NVML_FUNC(nvmlInit);
     __POWER_OVERWHELMING_GET_NVML_FUNC(nvmlShutdown);
@@ -8,6 +8,7 @@
 #include <nvml.h>
 
 #include "library_base.h"
+#include "nvml_field_values.h"
 
 
 namespace visus {
@@ -26,6 +27,14 @@ namespace detail {
         /// <summary>
         /// Gets the only instance of the class.
         /// </summary>
+        /// <remarks>
+        /// <c>nvmlDeviceGetFieldValues</c> and
+        /// <c>nvmlDeviceGetTotalEnergyConsumption</c> are optional, because
+        /// they are not available in old drivers. The same applies to the
+        /// functions for managing the power limit and for retrieving the
+        /// utilisation per process. Callers must check whether
+        /// the function pointers are <c>nullptr</c> before using them.
+        /// </remarks>
         /// <param name=""></param>
         /// <returns></returns>
         /// <exception cref="std::system_error">If the library could not
@@ -33,15 +42,25 @@ namespace detail {
         /// </exception>
         static const nvidia_management_library& instance(void);
 
+        __POWER_OVERWHELMING_NVML_FUNC(nvmlDeviceGetClockInfo);
         __POWER_OVERWHELMING_NVML_FUNC(nvmlDeviceGetCount);
+        __POWER_OVERWHELMING_NVML_FUNC(nvmlDeviceGetFieldValues);
         __POWER_OVERWHELMING_NVML_FUNC(nvmlDeviceGetName);
         __POWER_OVERWHELMING_NVML_FUNC(nvmlDeviceGetPciInfo);
+        __POWER_OVERWHELMING_NVML_FUNC(nvmlDeviceGetPowerManagementLimit);
+        __POWER_OVERWHELMING_NVML_FUNC(
+            nvmlDeviceGetPowerManagementLimitConstraints);
         __POWER_OVERWHELMING_NVML_FUNC(nvmlDeviceGetPowerUsage);
+        __POWER_OVERWHELMING_NVML_FUNC(nvmlDeviceGetProcessUtilization);
+        __POWER_OVERWHELMING_NVML_FUNC(nvmlDeviceGetSamples);
+        __POWER_OVERWHELMING_NVML_FUNC(nvmlDeviceGetTotalEnergyConsumption);
+        __POWER_OVERWHELMING_NVML_FUNC(nvmlDeviceGetUtilizationRates);
         __POWER_OVERWHELMING_NVML_FUNC(nvmlDeviceGetHandleByIndex);
         __POWER_OVERWHELMING_NVML_FUNC(nvmlDeviceGetHandleByPciBusId);
         __POWER_OVERWHELMING_NVML_FUNC(nvmlDeviceGetHandleBySerial);
         __POWER_OVERWHELMING_NVML_FUNC(nvmlDeviceGetHandleByUUID);
         __POWER_OVERWHELMING_NVML_FUNC(nvmlDeviceGetUUID);
+        __POWER_OVERWHELMING_NVML_FUNC(nvmlDeviceSetPowerManagementLimit);
         __POWER_OVERWHELMING_NVML_FUNC(nvmlErrorString);
         __POWER_OVERWHELMING_NVML_FUNC(nvmlInit);
         __POWER_OVERWHELMING_NVML_FUNC(nvmlShutdown);
@@ -0,0 +1,150 @@
+﻿// <copyright file="nvml_field_values.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <nvml.h>
+
+
+/*
+ * The version of nvml.h we ship in third_party predates the field value API
+ * and the energy counter, which have been added in R418 of the driver, and the
+ * APIs for retrieving the samples buffered by the driver and the utilisation
+ * per process. The field value API has been extended with the instantaneous
+ * power in R515. As we load NVML dynamically, we only need the
+ * declarations, which we provide here with the same names and layout as in
+ * the current SDK if the header does not define them.
+ */
+
+#if !defined(NVML_FI_DEV_MEMORY_TEMP)
+/// <summary>
+/// The temperature of the GPU memory in degrees Celsius.
+/// </summary>
+#define NVML_FI_DEV_MEMORY_TEMP (82)
+
+/// <summary>
+/// The total energy consumption of the GPU in millijoules since the driver was
+/// last reloaded.
+/// </summary>
+#define NVML_FI_DEV_TOTAL_ENERGY_CONSUMPTION (83)
+
+extern "C" {
+
+    /// <summary>
+    /// Identifies the member of <see cref="nvmlValue_t" /> that is valid.
+    /// </summary>
+    typedef enum nvmlValueType_enum {
+        NVML_VALUE_TYPE_DOUBLE = 0,
+        NVML_VALUE_TYPE_UNSIGNED_INT = 1,
+        NVML_VALUE_TYPE_UNSIGNED_LONG = 2,
+        NVML_VALUE_TYPE_UNSIGNED_LONG_LONG = 3,
+        NVML_VALUE_TYPE_SIGNED_LONG_LONG = 4,
+        NVML_VALUE_TYPE_COUNT
+    } nvmlValueType_t;
+
+    /// <summary>
+    /// Union of the possible types of a field value.
+    /// </summary>
+    typedef union nvmlValue_st {
+        double dVal;
+        unsigned int uiVal;
+        unsigned long ulVal;
+        unsigned long long ullVal;
+        signed long long sllVal;
+    } nvmlValue_t;
+
+    /// <summary>
+    /// The request and result of a single field queried via
+    /// <see cref="nvmlDeviceGetFieldValues" />.
+    /// </summary>
+    typedef struct nvmlFieldValue_st {
+        unsigned int fieldId;
+        unsigned int scopeId;
+        long long timestamp;
+        long long latencyUsec;
+        nvmlValueType_t valueType;
+        nvmlReturn_t nvmlReturn;
+        nvmlValue_t value;
+    } nvmlFieldValue_t;
+
+    /// <summary>
+    /// Identifies the kind of samples retrieved via
+    /// <see cref="nvmlDeviceGetSamples" />.
+    /// </summary>
+    typedef enum nvmlSamplingType_enum {
+        NVML_TOTAL_POWER_SAMPLES = 0,
+        NVML_GPU_UTILIZATION_SAMPLES = 1,
+        NVML_MEMORY_UTILIZATION_SAMPLES = 2,
+        NVML_ENC_UTILIZATION_SAMPLES = 3,
+        NVML_DEC_UTILIZATION_SAMPLES = 4,
+        NVML_PROCESSOR_CLK_SAMPLES = 5,
+        NVML_MEMORY_CLK_SAMPLES = 6,
+        NVML_SAMPLINGTYPE_COUNT
+    } nvmlSamplingType_t;
+
+    /// <summary>
+    /// A single sample from the buffer of the driver, whose timestamp is
+    /// given in microseconds since the Unix epoch.
+    /// </summary>
+    typedef struct nvmlSample_st {
+        unsigned long long timeStamp;
+        nvmlValue_t sampleValue;
+    } nvmlSample_t;
+
+    /// <summary>
+    /// Retrieves the samples the driver has buffered after
+    /// <paramref name="lastSeenTimeStamp" />, or their number if
+    /// <paramref name="samples" /> is <c>nullptr</c>.
+    /// </summary>
+    nvmlReturn_t nvmlDeviceGetSamples(nvmlDevice_t device,
+        nvmlSamplingType_t type, unsigned long long lastSeenTimeStamp,
+        nvmlValueType_t *sampleValType, unsigned int *sampleCount,
+        nvmlSample_t *samples);
+
+    /// <summary>
+    /// The utilisation of the GPU by a single process, whose timestamp is
+    /// given in microseconds since the Unix epoch.
+    /// </summary>
+    typedef struct nvmlProcessUtilizationSample_st {
+        unsigned int pid;
+        unsigned long long timeStamp;
+        unsigned int smUtil;
+        unsigned int memUtil;
+        unsigned int encUtil;
+        unsigned int decUtil;
+    } nvmlProcessUtilizationSample_t;
+
+    /// <summary>
+    /// Retrieves the utilisation of the processes running on the GPU after
+    /// <paramref name="lastSeenTimeStamp" />, or their number if
+    /// <paramref name="utilization" /> is <c>nullptr</c>.
+    /// </summary>
+    nvmlReturn_t nvmlDeviceGetProcessUtilization(nvmlDevice_t device,
+        nvmlProcessUtilizationSample_t *utilization,
+        unsigned int *processSamplesCount,
+        unsigned long long lastSeenTimeStamp);
+
+    /// <summary>
+    /// Requests multiple fields of a device in a single call.
+    /// </summary>
+    nvmlReturn_t nvmlDeviceGetFieldValues(nvmlDevice_t device,
+        int valuesCount, nvmlFieldValue_t *values);
+
+    /// <summary>
+    /// Retrieves the total energy consumption of the GPU in millijoules
+    /// since the driver was last reloaded.
+    /// </summary>
+    nvmlReturn_t nvmlDeviceGetTotalEnergyConsumption(nvmlDevice_t device,
+        unsigned long long *energy);
+
+} /* extern "C" */
+#endif /* !defined(NVML_FI_DEV_MEMORY_TEMP) */
+
+#if !defined(NVML_FI_DEV_POWER_INSTANT)
+/// <summary>
+/// The instantaneous power draw of the GPU in milliwatts.
+/// </summary>
+#define NVML_FI_DEV_POWER_INSTANT (186)
+#endif /* !defined(NVML_FI_DEV_POWER_INSTANT) */
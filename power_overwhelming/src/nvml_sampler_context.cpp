@@ -0,0 +1,484 @@
+﻿// <copyright file="nvml_sampler_context.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "nvml_sampler_context.h"
+
+#include <algorithm>
+
+#include "nvml_sensor_impl.h"
+#include "system_trace.h"
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sampler_context::query::query
+ */
+visus::power_overwhelming::detail::nvml_sampler_context::query::query(void)
+    : batch_size(0), busy(false), callback(nullptr), context(nullptr),
+        data_callback(nullptr), name(nullptr), ready(false), removed(false),
+        result(0, measurement_data::invalid_value,
+            measurement_data::invalid_value,
+            measurement_data::invalid_value),
+        sample_duration(nullptr), sensor(nullptr) { }
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sampler_context::query::deliver
+ */
+void visus::power_overwhelming::detail::nvml_sampler_context::query::deliver(
+        void) {
+    if (!this->batch.empty()) {
+        assert(this->data_callback != nullptr);
+        this->data_callback(this->name, this->batch.data(),
+            this->batch.size(), this->context);
+        this->batch.clear();
+    }
+}
+
+
+/*
+ * ...::detail::nvml_sampler_context::max_batch_latency
+ */
+constexpr visus::power_overwhelming::detail::nvml_sampler_context::interval_type
+visus::power_overwhelming::detail::nvml_sampler_context::max_batch_latency;
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sampler_context::max_workers
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::nvml_sampler_context::max_workers;
+
+
+/*
+ * ...::detail::nvml_sampler_context::nvml_sampler_context
+ */
+visus::power_overwhelming::detail::nvml_sampler_context::nvml_sampler_context(
+        void) : active(std::make_shared<snapshot_type>()), epoch(0),
+        instrumentation(task), inflight_timestamp(0), running(false), sampling(false),
+        task(&nvml_sampler_context::tick, this) { }
+
+
+/*
+ * ...::detail::nvml_sampler_context::~nvml_sampler_context
+ */
+visus::power_overwhelming::detail::nvml_sampler_context::~nvml_sampler_context(
+        void) {
+    for (auto& w : this->workers) {
+        if (w.joinable()) {
+            w.detach();
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sampler_context::add
+ */
+bool visus::power_overwhelming::detail::nvml_sampler_context::add(
+        sensor_type sensor, const measurement_callback callback, void *context) {
+    assert(sensor != nullptr);
+    assert(callback != nullptr);
+    auto query = std::make_shared<nvml_sampler_context::query>();
+    query->callback = callback;
+    query->context = context;
+    sensor->load_device_name();
+    query->name = sensor_name_registry::intern(sensor->sensor_name.c_str());
+    query->sample_duration = &this->instrumentation.sample_duration(
+        query->name);
+    query->sensor = sensor;
+    return this->add(sensor, std::move(query));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sampler_context::add
+ */
+bool visus::power_overwhelming::detail::nvml_sampler_context::add(
+        sensor_type sensor, const measurement_data_callback callback,
+        void *context) {
+    assert(sensor != nullptr);
+    assert(callback != nullptr);
+    auto query = std::make_shared<nvml_sampler_context::query>();
+    query->batch_size = static_cast<std::size_t>(
+        max_batch_latency / (std::max)(this->interval, interval_type(1)));
+    if (query->batch_size < 1) {
+        query->batch_size = 1;
+    }
+    query->batch.reserve(query->batch_size);
+    query->context = context;
+    query->data_callback = callback;
+    sensor->load_device_name();
+    query->name = sensor_name_registry::intern(sensor->sensor_name.c_str());
+    query->sample_duration = &this->instrumentation.sample_duration(
+        query->name);
+    query->sensor = sensor;
+    return this->add(sensor, std::move(query));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sampler_context::clear
+ */
+void visus::power_overwhelming::detail::nvml_sampler_context::clear(void) {
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    this->sensors.clear();
+    this->publish();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sampler_context::remove
+ */
+bool visus::power_overwhelming::detail::nvml_sampler_context::remove(
+        sensor_type sensor) {
+    auto is_sampler_thread = false;
+    query_type query;
+
+    {
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        auto it = this->sensors.find(sensor);
+        is_sampler_thread = this->task.executing();
+
+        if (it != this->sensors.end()) {
+            query = std::move(it->second);
+            this->sensors.erase(it);
+            this->publish();
+        }
+    }
+
+    if (query != nullptr) {
+        if (!is_sampler_thread) {
+            // The sampler thread might still use the old snapshot, so we must
+            // not return until it has finished, because the caller is
+            // typically about to destroy the sensor.
+            this->synchronise();
+        }
+
+        {
+            std::unique_lock<decltype(this->queue_lock)> l(this->queue_lock);
+            // Prevent the sampler thread from delivering anything if we have
+            // been called from one of its callbacks, and make sure that a
+            // query that has not yet been started will not be started anymore.
+            query->removed = true;
+
+            auto it = std::find(this->pending.begin(), this->pending.end(),
+                query);
+            if (it != this->pending.end()) {
+                this->pending.erase(it);
+                query->busy = false;
+            }
+
+            // A worker might be stuck on a GPU that does not answer, but we
+            // cannot let the caller destroy the sensor before it returns.
+            this->completed.wait(l, [&query](void) { return !query->busy; });
+        }
+
+        // At this point, no one can access the query anymore, so we can
+        // deliver the remaining samples of the last batch.
+        if (query->data_callback != nullptr) {
+            query->deliver();
+        }
+    }
+
+    return (query != nullptr);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sampler_context::sample
+ */
+bool visus::power_overwhelming::detail::nvml_sampler_context::sample(void) {
+    typedef sampler_instrumentation::clock_type clock_type;
+    const auto begin = this->instrumentation.begin_tick();
+    auto have_sensors = true;
+
+    // Mark the begin of the dispatch *before* obtaining the snapshot like the
+    // default_sampler_context does.
+    ++this->epoch;
+    {
+        auto sensors = std::atomic_load(&this->active);
+        assert(sensors != nullptr);
+
+        // Deliver the results of the queries from the previous tick, which
+        // had one interval to answer, before querying the GPUs again.
+        if (this->inflight != nullptr) {
+            this->collect();
+            assert(this->results.size() == this->inflight->size());
+
+            for (std::size_t i = 0; i < this->inflight->size(); ++i) {
+                auto& q = *(*this->inflight)[i];
+
+                {
+                    // The sensor might have been removed since the queries
+                    // have been dispatched, or a callback might have removed
+                    // one of the sensors that we have not yet delivered to.
+                    std::lock_guard<decltype(this->queue_lock)> l(
+                        this->queue_lock);
+                    if (q.removed) {
+                        continue;
+                    }
+                }
+
+                system_trace::sample(q.name, this->results[i]);
+
+                const auto start = clock_type::now();
+                if (q.data_callback != nullptr) {
+                    q.batch.push_back(std::move(this->results[i]));
+                    if (q.batch.size() >= q.batch_size) {
+                        q.deliver();
+                        this->instrumentation.callback_duration().record(
+                            clock_type::now() - start);
+                    }
+
+                } else {
+                    q.callback(measurement(q.name, this->results[i]),
+                        q.context);
+                    this->instrumentation.callback_duration().record(
+                        clock_type::now() - start);
+                }
+            }
+        }
+
+        this->dispatch(sensors);
+        have_sensors = !sensors->empty();
+    }
+    ++this->epoch;
+
+    if (!have_sensors) {
+        // Decide about stopping while holding the lock, because a sensor
+        // might have been added after we obtained the snapshot and add() must
+        // know whether it needs to schedule the task again. The workers are
+        // stopped under the lock as well such that add() cannot dispatch to
+        // them while they are exiting. As all queries have been removed, the
+        // workers are idle and exit immediately.
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        have_sensors = !this->sensors.empty();
+        this->sampling = have_sensors;
+
+        if (!have_sensors) {
+            this->stop_workers();
+            this->inflight.reset();
+        }
+    }
+
+    this->instrumentation.end_tick(begin);
+    return have_sensors;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sampler_context::samples
+ */
+bool visus::power_overwhelming::detail::nvml_sampler_context::samples(
+        const sensor_type sensor) {
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    return (this->sensors.find(sensor) != this->sensors.end());
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sampler_context::add
+ */
+bool visus::power_overwhelming::detail::nvml_sampler_context::add(
+        sensor_type sensor, query_type&& query) {
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+
+    if (this->sensors.find(sensor) != this->sensors.end()) {
+        // Sensor is already being sampled, so there is nothing to do.
+        return false;
+    }
+
+    if (sensor->energy_mode.load()) {
+        // If the sensor has been sampled before, its baseline is from the
+        // time when it was stopped, so the first new sample would average over
+        // the whole pause unless we establish a new baseline now.
+        sensor->enable_energy_mode(true);
+    }
+
+    this->sensors.emplace(sensor, std::move(query));
+    this->publish();
+
+    if (!this->sampling) {
+        // If this is the first sensor, we need to schedule the task. If the
+        // task is still in its last tick, the scheduler restarts it after the
+        // tick has completed.
+        this->sampling = true;
+        sampler_scheduler::instance().schedule(this->task, this->interval);
+    }
+
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sampler_context::collect
+ */
+void visus::power_overwhelming::detail::nvml_sampler_context::collect(void) {
+    assert(this->inflight != nullptr);
+    std::lock_guard<decltype(this->queue_lock)> l(this->queue_lock);
+
+    this->results.clear();
+    this->results.reserve(this->inflight->size());
+
+    for (auto& q : *this->inflight) {
+        if (q->ready) {
+            this->results.push_back(q->result);
+            q->ready = false;
+        } else {
+            this->results.emplace_back(this->inflight_timestamp,
+                measurement_data::invalid_value,
+                measurement_data::invalid_value,
+                measurement_data::invalid_value);
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sampler_context::dispatch
+ */
+void visus::power_overwhelming::detail::nvml_sampler_context::dispatch(
+        const std::shared_ptr<const snapshot_type>& queries) {
+    assert(queries != nullptr);
+    this->inflight_timestamp = create_timestamp(
+        timestamp_resolution::milliseconds);
+
+    std::lock_guard<decltype(this->queue_lock)> l(this->queue_lock);
+
+    for (auto& q : *queries) {
+        // If the GPU has not yet answered the query of a previous tick, we do
+        // not ask it again, but flag the tick as missed.
+        if (!q->busy && !q->removed) {
+            q->busy = true;
+            q->ready = false;
+            this->pending.push_back(q);
+        }
+    }
+
+    // Make sure that there is a worker for every GPU up to the size of the
+    // pool. Workers are only created by the sampler task, which joins them
+    // when it stops.
+    if (this->workers.empty()) {
+        this->running = true;
+    }
+
+    const auto cnt_workers = (std::min)(queries->size(), max_workers);
+    while (this->workers.size() < cnt_workers) {
+        this->workers.emplace_back(&nvml_sampler_context::work, this);
+    }
+
+    this->queued.notify_all();
+    this->inflight = queries;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sampler_context::publish
+ */
+void visus::power_overwhelming::detail::nvml_sampler_context::publish(void) {
+    auto snapshot = std::make_shared<snapshot_type>();
+    snapshot->reserve(this->sensors.size());
+
+    for (auto& s : this->sensors) {
+        snapshot->push_back(s.second);
+    }
+
+    std::atomic_store(&this->active,
+        std::shared_ptr<const snapshot_type>(std::move(snapshot)));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sampler_context::synchronise
+ */
+void visus::power_overwhelming::detail::nvml_sampler_context::synchronise(
+        void) const {
+    const auto epoch = this->epoch.load();
+
+    if ((epoch & 1) != 0) {
+        // The sampler thread is within a dispatch, so wait until it has left
+        // it. It is irrelevant whether it entered a new one since then, because
+        // the new dispatch will use the updated snapshot.
+        while (this->epoch.load() == epoch) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sampler_context::stop_workers
+ */
+void visus::power_overwhelming::detail::nvml_sampler_context::stop_workers(
+        void) {
+    {
+        std::lock_guard<decltype(this->queue_lock)> l(this->queue_lock);
+        this->running = false;
+    }
+    this->queued.notify_all();
+
+    for (auto& w : this->workers) {
+        w.join();
+    }
+    this->workers.clear();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sampler_context::tick
+ */
+bool visus::power_overwhelming::detail::nvml_sampler_context::tick(
+        _In_ void *context) {
+    assert(context != nullptr);
+    return static_cast<nvml_sampler_context *>(context)->sample();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sampler_context::work
+ */
+void visus::power_overwhelming::detail::nvml_sampler_context::work(void) {
+    enter_library_thread("PwrOwg NVML Worker Thread");
+
+    std::unique_lock<decltype(this->queue_lock)> l(this->queue_lock);
+
+    while (true) {
+        this->queued.wait(l, [this](void) {
+            return !this->running || !this->pending.empty();
+        });
+
+        if (this->pending.empty()) {
+            // The sampler task is stopping and there is no work left.
+            break;
+        }
+
+        auto query = std::move(this->pending.front());
+        this->pending.pop_front();
+        assert(query->busy);
+
+        // Do not hold the lock while talking to the GPU, as this is the call
+        // that might stall.
+        l.unlock();
+        auto ready = false;
+        measurement_data result(0, measurement_data::invalid_value,
+            measurement_data::invalid_value,
+            measurement_data::invalid_value);
+        try {
+            const auto start = sampler_instrumentation::clock_type::now();
+            result = query->sensor->sample();
+            query->sample_duration->record(
+                sampler_instrumentation::clock_type::now() - start);
+            ready = true;
+        } catch (...) {
+            // A failed query is flagged like a missed one.
+        }
+        l.lock();
+
+        query->result = std::move(result);
+        query->ready = ready;
+        query->busy = false;
+        this->completed.notify_all();
+    }
+}
@@ -0,0 +1,447 @@
+﻿// <copyright file="nvml_sampler_context.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cinttypes>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "power_overwhelming/measurement.h"
+
+#include "library_thread.h"
+#include "sampler_instrumentation.h"
+#include "sampler_scheduler.h"
+#include "sensor_name_registry.h"
+#include "timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /* Forward declarations. */
+    struct nvml_sensor_impl;
+
+
+    /// <summary>
+    /// A context represents a thread that handles sampling
+    /// <see cref="nvml_sensor" />s at a specific interval.
+    /// </summary>
+    /// <remarks>
+    /// <para>In contrast to the <see cref="default_sampler_context" />, the
+    /// context does not query the GPUs one after the other, but hands out the
+    /// queries of each tick to a small pool of worker threads. This way, a GPU
+    /// that is slow to answer, for instance because it is just leaving a low
+    /// power state, does not delay the readings of all other GPUs.</para>
+    /// <para>The sampler task does not wait for the queries, but collects
+    /// their results on the next tick, because it must not block the shared
+    /// workers of the <see cref="sampler_scheduler" />. The samples are
+    /// therefore delivered one interval after they have been requested. If
+    /// the query of a GPU has not completed by then, or if it failed, the
+    /// sensor receives an invalid <see cref="measurement_data" /> for the
+    /// tick, which evaluates to <c>false</c>. A GPU whose query of the
+    /// previous tick is still in progress is not queried again, but flagged
+    /// in the same way until it has answered.</para>
+    /// </remarks>
+    struct nvml_sampler_context {
+
+        /// <summary>
+        /// The type to express sampling intervals.
+        /// </summary>
+        typedef std::chrono::microseconds interval_type;
+
+        /// <summary>
+        /// The type of the sensor implementation, which must be the NVML
+        /// sensor implementation.
+        /// </summary>
+        typedef nvml_sensor_impl *sensor_type;
+
+        /// <summary>
+        /// Describes how a sensor is queried by the worker threads and how its
+        /// samples are delivered to the user.
+        /// </summary>
+        struct query {
+
+            /// <summary>
+            /// The batch of samples that have not yet been delivered to
+            /// <see cref="data_callback" />.
+            /// </summary>
+            /// <remarks>
+            /// The batch is only accessed by the sampler thread while the
+            /// sensor is in the active snapshot.
+            /// </remarks>
+            std::vector<measurement_data> batch;
+
+            /// <summary>
+            /// The number of samples in <see cref="batch" /> that cause the
+            /// batch to be delivered.
+            /// </summary>
+            std::size_t batch_size;
+
+            /// <summary>
+            /// Indicates whether the sensor has been handed to the worker
+            /// threads and has not yet been sampled.
+            /// </summary>
+            /// <remarks>
+            /// This field is protected by <see cref="queue_lock" />.
+            /// </remarks>
+            bool busy;
+
+            /// <summary>
+            /// The callback for individual samples, or <c>nullptr</c> if the
+            /// sensor is sampled in batches.
+            /// </summary>
+            measurement_callback callback;
+
+            /// <summary>
+            /// The user-defined context pointer passed to the callback.
+            /// </summary>
+            void *context;
+
+            /// <summary>
+            /// The callback for batches of samples, or <c>nullptr</c> if the
+            /// samples are delivered one by one.
+            /// </summary>
+            measurement_data_callback data_callback;
+
+            /// <summary>
+            /// The interned name of the sensor.
+            /// </summary>
+            const wchar_t *name;
+
+            /// <summary>
+            /// Indicates whether <see cref="result" /> holds a sample that has
+            /// not yet been delivered.
+            /// </summary>
+            /// <remarks>
+            /// This field is protected by <see cref="queue_lock" />.
+            /// </remarks>
+            bool ready;
+
+            /// <summary>
+            /// Indicates that the sensor has been removed from the context
+            /// while the sampler thread was dispatching.
+            /// </summary>
+            /// <remarks>
+            /// This field is protected by <see cref="queue_lock" />.
+            /// </remarks>
+            bool removed;
+
+            /// <summary>
+            /// The sample obtained by the worker thread.
+            /// </summary>
+            /// <remarks>
+            /// This field is protected by <see cref="queue_lock" />.
+            /// </remarks>
+            measurement_data result;
+
+            /// <summary>
+            /// The histogram of the time the query takes on the worker
+            /// thread, which is owned by <see cref="instrumentation" />.
+            /// </summary>
+            sampler_instrumentation::histogram_type *sample_duration;
+
+            /// <summary>
+            /// The sensor to be sampled.
+            /// </summary>
+            sensor_type sensor;
+
+            /// <summary>
+            /// Initialises a new instance.
+            /// </summary>
+            query(void);
+
+            /// <summary>
+            /// Invokes <see cref="data_callback" /> for all samples in
+            /// <see cref="batch" /> and clears the batch.
+            /// </summary>
+            void deliver(void);
+        };
+
+        /// <summary>
+        /// The type that is used to store <see cref="query" />s, which are
+        /// shared between the <see cref="sensors" />, the snapshots and the
+        /// worker threads.
+        /// </summary>
+        typedef std::shared_ptr<query> query_type;
+
+        /// <summary>
+        /// The type of an immutable snapshot of the sensors that the sampling
+        /// thread dispatches to.
+        /// </summary>
+        typedef std::vector<query_type> snapshot_type;
+
+        /// <summary>
+        /// The maximum time a sample may be retained in a batch before it is
+        /// delivered to a <see cref="measurement_data_callback" />.
+        /// </summary>
+        static constexpr interval_type max_batch_latency
+            = std::chrono::milliseconds(10);
+
+        /// <summary>
+        /// The maximum number of worker threads querying the GPUs.
+        /// </summary>
+        static constexpr std::size_t max_workers = 4;
+
+        /// <summary>
+        /// The snapshot of <see cref="sensors" /> that is currently being used
+        /// by the sampler thread.
+        /// </summary>
+        /// <remarks>
+        /// This pointer must only be accessed via <c>std::atomic_load</c> and
+        /// <c>std::atomic_store</c>.
+        /// </remarks>
+        std::shared_ptr<const snapshot_type> active;
+
+        /// <summary>
+        /// Signals that a worker thread has completed a query.
+        /// </summary>
+        std::condition_variable completed;
+
+        /// <summary>
+        /// A counter that is incremented by the sampler thread before and after
+        /// it dispatches to <see cref="active" />.
+        /// </summary>
+        /// <remarks>
+        /// An odd value indicates that the sampler thread is currently using a
+        /// snapshot, which might still contain a sensor that has just been
+        /// removed.
+        /// </remarks>
+        std::atomic<std::uint64_t> epoch;
+
+        /// <summary>
+        /// Records the timing of the ticks of <see cref="task" />.
+        /// </summary>
+        sampler_instrumentation instrumentation;
+
+        /// <summary>
+        /// The sampling interval.
+        /// </summary>
+        interval_type interval;
+
+        /// <summary>
+        /// The snapshot that has been dispatched to the worker threads on the
+        /// previous tick, whose results are delivered on the next tick.
+        /// </summary>
+        /// <remarks>
+        /// This field is only accessed by the sampler task.
+        /// </remarks>
+        std::shared_ptr<const snapshot_type> inflight;
+
+        /// <summary>
+        /// The timestamp of the tick that dispatched <see cref="inflight" />,
+        /// which is used for the invalid samples of missed queries.
+        /// </summary>
+        /// <remarks>
+        /// This field is only accessed by the sampler task.
+        /// </remarks>
+        timestamp_type inflight_timestamp;
+
+        /// <summary>
+        /// A lock protecting the list of <see cref="sensors" />.
+        /// </summary>
+        std::mutex lock;
+
+        /// <summary>
+        /// The queries that have been submitted to the worker threads, but
+        /// have not yet been picked up.
+        /// </summary>
+        /// <remarks>
+        /// This field is protected by <see cref="queue_lock" />.
+        /// </remarks>
+        std::deque<query_type> pending;
+
+        /// <summary>
+        /// Signals that <see cref="pending" /> or <see cref="running" /> have
+        /// changed.
+        /// </summary>
+        std::condition_variable queued;
+
+        /// <summary>
+        /// A lock protecting the work queue and the state of the queries.
+        /// </summary>
+        std::mutex queue_lock;
+
+        /// <summary>
+        /// Indicates whether the worker threads should continue waiting for
+        /// queries.
+        /// </summary>
+        /// <remarks>
+        /// This field is protected by <see cref="queue_lock" />.
+        /// </remarks>
+        bool running;
+
+        /// <summary>
+        /// The samples collected for <see cref="inflight" />.
+        /// </summary>
+        /// <remarks>
+        /// This field is only accessed by the sampler task.
+        /// </remarks>
+        std::vector<measurement_data> results;
+
+        /// <summary>
+        /// Indicates whether the sampler <see cref="task" /> is scheduled,
+        /// whereas <see cref="running" /> refers to the worker threads.
+        /// </summary>
+        /// <remarks>
+        /// The flag is protected by <see cref="lock" />. The sampler task
+        /// clears it when it has found <see cref="sensors" /> empty and is
+        /// about to stop, in which case <see cref="add" /> must schedule it
+        /// again.
+        /// </remarks>
+        bool sampling;
+
+        /// <summary>
+        /// The sensors to sample along with the callback to be invoked.
+        /// </summary>
+        std::map<sensor_type, query_type> sensors;
+
+        /// <summary>
+        /// The task of the scheduler that periodically samples the
+        /// <see cref="sensors" />.
+        /// </summary>
+        sampler_scheduler::task task;
+
+        /// <summary>
+        /// The worker threads querying the GPUs, which are owned by the
+        /// sampler <see cref="task" />.
+        /// </summary>
+        std::vector<std::thread> workers;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        nvml_sampler_context(void);
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        /// <remarks>
+        /// Like the sampler <see cref="task" />, which is cancelled without
+        /// waiting by the <see cref="sampler" />, worker threads that are
+        /// still running are detached and exit asynchronously.
+        /// </remarks>
+        ~nvml_sampler_context(void);
+
+        /// <summary>
+        /// Add the given sensor to the this context.
+        /// </summary>
+        bool add(sensor_type sensor, const measurement_callback callback,
+            void *context);
+
+        /// <summary>
+        /// Add the given sensor to the this context such that its samples are
+        /// delivered in batches.
+        /// </summary>
+        /// <remarks>
+        /// The samples are delivered if the batch covers
+        /// <see cref="max_batch_latency" /> or if the sensor is removed from
+        /// the context.
+        /// </remarks>
+        bool add(sensor_type sensor, const measurement_data_callback callback,
+            void *context);
+
+        /// <summary>
+        /// Remove all sensors from the context, which will make the sampler
+        /// task stop.
+        /// </summary>
+        void clear(void);
+
+        /// <summary>
+        /// Remove the sensor from the context.
+        /// </summary>
+        /// <remarks>
+        /// If the sensor has been removed, the method blocks until neither the
+        /// sampler task nor any worker thread uses it anymore.
+        /// </remarks>
+        bool remove(sensor_type sensor);
+
+        /// <summary>
+        /// Performs one tick of sampling in this context.
+        /// </summary>
+        /// <returns><c>true</c> if the task should continue to be scheduled,
+        /// <c>false</c> if there are no sensors left.</returns>
+        bool sample(void);
+
+        /// <summary>
+        /// Answer whether the given sensor is sampled in this context.
+        /// </summary>
+        bool samples(const sensor_type sensor);
+
+    private:
+
+        /// <summary>
+        /// Add the given query for the sensor.
+        /// </summary>
+        bool add(sensor_type sensor, query_type&& query);
+
+        /// <summary>
+        /// Collects the results of the queries in <see cref="inflight" />
+        /// into <see cref="results" /> without waiting for them.
+        /// </summary>
+        /// <remarks>
+        /// This method must only be called by the sampler <see cref="task" />.
+        /// The result of a query that has not yet completed or failed is
+        /// invalid.
+        /// </remarks>
+        void collect(void);
+
+        /// <summary>
+        /// Hands the given queries to the worker threads and makes them the
+        /// <see cref="inflight" /> ones.
+        /// </summary>
+        /// <remarks>
+        /// This method must only be called by the sampler <see cref="task" />.
+        /// </remarks>
+        /// <param name="queries">The queries to be performed.</param>
+        void dispatch(const std::shared_ptr<const snapshot_type>& queries);
+
+        /// <summary>
+        /// Publishes a new snapshot of <see cref="sensors" /> to the sampler
+        /// task.
+        /// </summary>
+        /// <remarks>
+        /// The caller must hold <see cref="lock" />.
+        /// </remarks>
+        void publish(void);
+
+        /// <summary>
+        /// Blocks the calling thread until the sampler task has completed
+        /// the dispatch that might have been in progress when the method was
+        /// called.
+        /// </summary>
+        void synchronise(void) const;
+
+        /// <summary>
+        /// Stops and joins the <see cref="workers" />.
+        /// </summary>
+        void stop_workers(void);
+
+        /// <summary>
+        /// The callback of <see cref="task" />.
+        /// </summary>
+        static bool tick(_In_ void *context);
+
+        /// <summary>
+        /// Performs the queries submitted by the sampler task.
+        /// </summary>
+        /// <remarks>
+        /// This is the method running in the <see cref="workers" />.
+        /// </remarks>
+        void work(void);
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -5,18 +5,77 @@
 
 #include "nvml_scope.h"
 
+#include <cassert>
+#include <cstddef>
+#include <mutex>
+
 #include "nvidia_management_library.h"
 #include "nvml_exception.h"
 
 
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The state of the initialisation shared by all
+    /// <see cref="nvml_scope" />s.
+    /// </summary>
+    struct nvml_scope_state final {
+        std::mutex lock;
+        std::size_t references;
+        bool retained;
+
+        inline nvml_scope_state(void) : references(0), retained(false) { }
+
+        static nvml_scope_state& instance(void) {
+            static nvml_scope_state retval;
+            return retval;
+        }
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_scope::release
+ */
+void visus::power_overwhelming::detail::nvml_scope::release(void) noexcept {
+    auto& state = nvml_scope_state::instance();
+    std::lock_guard<decltype(state.lock)> l(state.lock);
+
+    if (state.retained) {
+        assert(state.references > 0);
+        state.retained = false;
+
+        if (--state.references == 0) {
+            nvidia_management_library::instance().nvmlShutdown();
+        }
+    }
+}
+
+
 /*
  * visus::power_overwhelming::detail::nvml_scope::nvml_scope
  */
 visus::power_overwhelming::detail::nvml_scope::nvml_scope(void) {
-    auto status = nvidia_management_library::instance().nvmlInit();
-    if (status != NVML_SUCCESS) {
-        throw nvml_exception(status);
+    auto& state = nvml_scope_state::instance();
+    std::lock_guard<decltype(state.lock)> l(state.lock);
+
+    if (state.references == 0) {
+        auto status = nvidia_management_library::instance().nvmlInit();
+        if (status != NVML_SUCCESS) {
+            throw nvml_exception(status);
+        }
+
+        // Keep the library initialised for all scopes to come.
+        state.retained = true;
+        ++state.references;
     }
+
+    ++state.references;
 }
 
 
@@ -24,5 +83,11 @@ visus::power_overwhelming::detail::nvml_scope::nvml_scope(void) {
  * visus::power_overwhelming::detail::nvml_scope::~nvml_scope
  */
 visus::power_overwhelming::detail::nvml_scope::~nvml_scope(void) {
-    nvidia_management_library::instance().nvmlShutdown();
+    auto& state = nvml_scope_state::instance();
+    std::lock_guard<decltype(state.lock)> l(state.lock);
+    assert(state.references > 0);
+
+    if (--state.references == 0) {
+        nvidia_management_library::instance().nvmlShutdown();
+    }
 }
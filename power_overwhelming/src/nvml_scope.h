@@ -14,14 +14,28 @@ namespace detail {
     /// A RAII container for the NVML library.
     /// </summary>
     /// <remarks>
-    /// As NVML uses an internal reference counter, multiple scopes can be used
-    /// by an application. NVML will not be unloaded unless the last scope was
-    /// destroyed.
+    /// <para>As initialising NVML is very expensive, all scopes of the process
+    /// share a single initialisation, which is counted by the library itself.
+    /// The first scope that successfully initialises NVML adds a reference
+    /// for the whole process, such that NVML remains initialised after the
+    /// last scope was destroyed until <see cref="release" /> is called.
+    /// </para>
     /// </remarks>
     class nvml_scope final {
 
     public:
 
+        /// <summary>
+        /// Drops the reference that keeps NVML initialised for the whole
+        /// process, such that it is shut down once the last scope has been
+        /// destroyed.
+        /// </summary>
+        /// <remarks>
+        /// The next scope being created will initialise NVML again and add a
+        /// new reference for the process.
+        /// </remarks>
+        static void release(void) noexcept;
+
         /// <summary>
         /// Initialises a new instance.
         /// </summary>
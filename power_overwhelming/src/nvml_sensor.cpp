@@ -5,11 +5,16 @@
 
 #include "power_overwhelming/nvml_sensor.h"
 
+#include <limits>
+#include <mutex>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 #include "nvidia_management_library.h"
 #include "nvml_exception.h"
 #include "nvml_sensor_impl.h"
+#include "pci_location.h"
 
 
 /*
@@ -19,31 +24,21 @@ std::size_t visus::power_overwhelming::nvml_sensor::for_all(
         _Out_writes_opt_(cntSensors) nvml_sensor *outSensors,
         _In_ const std::size_t cntSensors) {
     try {
-        unsigned int retval = 0;
-        detail::nvml_scope scope;
+        const auto ids = detail::nvml_sensor_impl::get_bus_ids();
 
-        {
-            auto status = detail::nvidia_management_library::instance()
-                .nvmlDeviceGetCount(&retval);
-            if (status != NVML_SUCCESS) {
-                throw nvml_exception(status);
-            }
-        }
-
-        for (unsigned int i = 0; (outSensors != nullptr) && (i < retval)
+        for (std::size_t i = 0; (outSensors != nullptr) && (i < ids.size())
                 && (i < cntSensors); ++i) {
             auto& sensor = outSensors[i]._impl;
 
             auto status = detail::nvidia_management_library::instance()
-                .nvmlDeviceGetHandleByIndex(i, &sensor->device);
+                .nvmlDeviceGetHandleByPciBusId(ids[i].c_str(),
+                &sensor->device);
             if (status != NVML_SUCCESS) {
                 throw nvml_exception(status);
             }
-
-            sensor->load_device_name();
         }
 
-        return retval;
+        return ids.size();
     } catch (...) {
         return 0;
     }
@@ -64,8 +59,6 @@ visus::power_overwhelming::nvml_sensor::from_bus_id(
         throw nvml_exception(status);
     }
 
-    retval._impl->load_device_name();
-
     return retval;
 }
 
@@ -94,8 +87,6 @@ visus::power_overwhelming::nvml_sensor::from_guid(_In_z_ const char *guid) {
         throw nvml_exception(status);
     }
 
-    retval._impl->load_device_name();
-
     return retval;
 }
 
@@ -124,12 +115,32 @@ visus::power_overwhelming::nvml_sensor::from_index(
         throw nvml_exception(status);
     }
 
-    retval._impl->load_device_name();
-
     return retval;
 }
 
 
+/*
+ * visus::power_overwhelming::nvml_sensor::from_luid
+ */
+visus::power_overwhelming::nvml_sensor
+visus::power_overwhelming::nvml_sensor::from_luid(
+        _In_ const std::uint64_t luid) {
+    const auto location = detail::get_pci_location(luid);
+
+    // Matching the bus IDs we already know is much cheaper than opening each
+    // of the devices to compare them.
+    for (auto& id : detail::nvml_sensor_impl::get_bus_ids()) {
+        detail::pci_location l;
+        if (detail::parse_pci_bus_id(l, id.c_str()) && (l == location)) {
+            return from_bus_id(id.c_str());
+        }
+    }
+
+    throw std::invalid_argument("The specified adapter is not an NVIDIA "
+        "device.");
+}
+
+
 /*
  * visus::power_overwhelming::nvml_sensor::from_serial
  */
@@ -144,8 +155,6 @@ visus::power_overwhelming::nvml_sensor::from_serial(
         throw nvml_exception(status);
     }
 
-    retval._impl->load_device_name();
-
     return retval;
 }
 
@@ -161,6 +170,25 @@ visus::power_overwhelming::nvml_sensor::from_serial(
 }
 
 
+/*
+ * visus::power_overwhelming::nvml_sensor::sample_data
+ */
+void visus::power_overwhelming::nvml_sensor::sample_data(
+        _Out_writes_(cnt) measurement_data *dst,
+        _In_reads_(cnt) const nvml_sensor *sensors,
+        _In_ const std::size_t cnt,
+        _In_ const timestamp_resolution resolution) {
+    if ((cnt > 0) && ((dst == nullptr) || (sensors == nullptr))) {
+        throw std::invalid_argument("The output and the sensors must be "
+            "valid if sensors are to be sampled.");
+    }
+
+    for (std::size_t i = 0; i < cnt; ++i) {
+        dst[i] = sensors[i].sample_data(resolution);
+    }
+}
+
+
 /*
  * visus::power_overwhelming::nvml_sensor::nvml_sensor
  */
@@ -183,12 +211,138 @@ _Ret_maybenull_z_ const char *
 visus::power_overwhelming::nvml_sensor::device_guid(void) const noexcept {
     if (this->_impl == nullptr) {
         return nullptr;
-    } else {
+    }
+
+    try {
+        this->_impl->load_device_name();
         return this->_impl->device_guid.c_str();
+    } catch (...) {
+        return nullptr;
     }
 }
 
 
+/*
+ * visus::power_overwhelming::nvml_sensor::best_power_limit
+ */
+double visus::power_overwhelming::nvml_sensor::best_power_limit(void) const {
+    this->check_not_disposed();
+    std::lock_guard<decltype(this->_impl->governor_lock)> l(
+        this->_impl->governor_lock);
+    const auto search = (this->_impl->governor.mode()
+        == power_governor_mode::maximise_efficiency);
+    return (search && (this->_impl->controller != nullptr))
+        ? this->_impl->controller->best_limit()
+        : std::numeric_limits<double>::quiet_NaN();
+}
+
+
+/*
+ * visus::power_overwhelming::nvml_sensor::buffered_mode
+ */
+bool visus::power_overwhelming::nvml_sensor::buffered_mode(void) const {
+    this->check_not_disposed();
+    return this->_impl->buffered_mode.load();
+}
+
+
+/*
+ * visus::power_overwhelming::nvml_sensor::buffered_mode
+ */
+visus::power_overwhelming::nvml_sensor&
+visus::power_overwhelming::nvml_sensor::buffered_mode(
+        _In_ const bool enabled) {
+    this->check_not_disposed();
+    this->_impl->enable_buffered_mode(enabled);
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::nvml_sensor::energy
+ */
+double visus::power_overwhelming::nvml_sensor::energy(void) const {
+    this->check_not_disposed();
+    return this->_impl->read_energy(false);
+}
+
+
+/*
+ * visus::power_overwhelming::nvml_sensor::energy_mode
+ */
+bool visus::power_overwhelming::nvml_sensor::energy_mode(void) const {
+    this->check_not_disposed();
+    return this->_impl->energy_mode.load();
+}
+
+
+/*
+ * visus::power_overwhelming::nvml_sensor::energy_mode
+ */
+visus::power_overwhelming::nvml_sensor&
+visus::power_overwhelming::nvml_sensor::energy_mode(_In_ const bool enabled) {
+    this->check_not_disposed();
+    this->_impl->enable_energy_mode(enabled);
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::nvml_sensor::estimates
+ */
+std::size_t visus::power_overwhelming::nvml_sensor::estimates(
+        _Out_writes_opt_(cnt) power_estimate *dst,
+        _In_ const std::size_t cnt) {
+    this->check_not_disposed();
+    return this->_impl->get_estimates(dst, cnt);
+}
+
+
+/*
+ * visus::power_overwhelming::nvml_sensor::estimation_mode
+ */
+bool visus::power_overwhelming::nvml_sensor::estimation_mode(void) const {
+    this->check_not_disposed();
+    return this->_impl->estimation_mode.load();
+}
+
+
+/*
+ * visus::power_overwhelming::nvml_sensor::estimation_mode
+ */
+visus::power_overwhelming::nvml_sensor&
+visus::power_overwhelming::nvml_sensor::estimation_mode(
+        _In_ const bool enabled) {
+    this->check_not_disposed();
+    this->_impl->enable_estimation_mode(enabled);
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::nvml_sensor::governor
+ */
+visus::power_overwhelming::power_governor
+visus::power_overwhelming::nvml_sensor::governor(void) const {
+    this->check_not_disposed();
+    std::lock_guard<decltype(this->_impl->governor_lock)> l(
+        this->_impl->governor_lock);
+    return this->_impl->governor;
+}
+
+
+/*
+ * visus::power_overwhelming::nvml_sensor::governor
+ */
+visus::power_overwhelming::nvml_sensor&
+visus::power_overwhelming::nvml_sensor::governor(
+        _In_ const power_governor& governor) {
+    this->check_not_disposed();
+    this->_impl->enable_governor(governor);
+    return *this;
+}
+
+
 /*
  * visus::power_overwhelming::nvml_sensor::name
  */
@@ -196,12 +350,68 @@ _Ret_maybenull_z_ const wchar_t *visus::power_overwhelming::nvml_sensor::name(
         void) const noexcept {
     if (this->_impl == nullptr) {
         return nullptr;
-    } else {
+    }
+
+    try {
+        this->_impl->load_device_name();
         return this->_impl->sensor_name.c_str();
+    } catch (...) {
+        return nullptr;
     }
 }
 
 
+/*
+ * visus::power_overwhelming::nvml_sensor::native_interval
+ */
+visus::power_overwhelming::sensor::microseconds_type
+visus::power_overwhelming::nvml_sensor::native_interval(void) const {
+    this->check_not_disposed();
+    return this->_impl->native_interval().count();
+}
+
+
+/*
+ * visus::power_overwhelming::nvml_sensor::power_limit
+ */
+double visus::power_overwhelming::nvml_sensor::power_limit(void) const {
+    this->check_not_disposed();
+    return this->_impl->power_limit();
+}
+
+
+/*
+ * visus::power_overwhelming::nvml_sensor::process_energies
+ */
+std::size_t visus::power_overwhelming::nvml_sensor::process_energies(
+        _Out_writes_opt_(cnt) process_energy *dst,
+        _In_ const std::size_t cnt) const {
+    this->check_not_disposed();
+    return this->_impl->get_process_energies(dst, cnt);
+}
+
+
+/*
+ * visus::power_overwhelming::nvml_sensor::process_energy_mode
+ */
+bool visus::power_overwhelming::nvml_sensor::process_energy_mode(void) const {
+    this->check_not_disposed();
+    return this->_impl->process_energy_mode.load();
+}
+
+
+/*
+ * visus::power_overwhelming::nvml_sensor::process_energy_mode
+ */
+visus::power_overwhelming::nvml_sensor&
+visus::power_overwhelming::nvml_sensor::process_energy_mode(
+        _In_ const bool enabled) {
+    this->check_not_disposed();
+    this->_impl->enable_process_energy_mode(enabled);
+    return *this;
+}
+
+
 /*
  * visus::power_overwhelming::nvml_sensor::sample
  */
@@ -222,11 +432,57 @@ void visus::power_overwhelming::nvml_sensor::sample(
         }
 
     } else {
-        detail::nvml_sensor_impl::sampler.remove(this->_impl);
+        detail::nvml_sensor_impl::sampler.remove(this->_impl, context);
     }
 }
 
 
+/*
+ * visus::power_overwhelming::nvml_sensor::sample_batch
+ */
+void visus::power_overwhelming::nvml_sensor::sample_batch(
+        _In_opt_ const measurement_data_callback on_batch,
+        _In_ const microseconds_type period,
+        _In_opt_ void *context) {
+    typedef decltype(detail::nvml_sensor_impl::sampler)::interval_type
+        interval_type;
+
+    this->check_not_disposed();
+
+    if (on_batch != nullptr) {
+        // The buffer sampler interns the name itself, so it must be known.
+        auto added = false;
+        if (this->_impl->buffered_mode.load()) {
+            this->_impl->load_device_name();
+            added = detail::nvml_sensor_impl::buffer_sampler.add(this->_impl,
+                on_batch, context, interval_type(period));
+        } else {
+            added = detail::nvml_sensor_impl::sampler.add(this->_impl,
+                on_batch, context, interval_type(period));
+        }
+
+        if (!added) {
+            throw std::logic_error("Asynchronous sampling cannot be started "
+                "while it is already running.");
+        }
+
+    } else {
+        detail::nvml_sensor_impl::sampler.remove(this->_impl, context);
+        detail::nvml_sensor_impl::buffer_sampler.remove(this->_impl, context);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::nvml_sensor::value
+ */
+double visus::power_overwhelming::nvml_sensor::value(
+        _In_ const nvml_quantity quantity) const {
+    this->check_not_disposed();
+    return this->_impl->value(quantity);
+}
+
+
 /*
  * visus::power_overwhelming::nvml_sensor::operator =
  */
@@ -250,12 +506,25 @@ visus::power_overwhelming::nvml_sensor::operator bool(void) const noexcept {
 }
 
 
+/*
+ * visus::power_overwhelming::nvml_sensor::sample_data
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::nvml_sensor::sample_data(
+        _In_ const timestamp_resolution resolution) const {
+    if (!*this) {
+        // The class is final, so this does not require a virtual call.
+        throw_disposed();
+    }
+    return this->_impl->sample(resolution);
+}
+
+
 /*
  * visus::power_overwhelming::nvml_sensor::sample_sync
  */
 visus::power_overwhelming::measurement_data
 visus::power_overwhelming::nvml_sensor::sample_sync(
         _In_ const timestamp_resolution resolution) const {
-    this->check_not_disposed();
-    return this->_impl->sample(resolution);
+    return this->sample_data(resolution);
 }
@@ -5,21 +5,171 @@
 
 #include "nvml_sensor_impl.h"
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
 #include <vector>
 
 #include "power_overwhelming/convert_string.h"
 
 #include "nvidia_management_library.h"
 #include "nvml_exception.h"
+#include "update_interval_probe.h"
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sensor_impl::max_estimates
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::nvml_sensor_impl::max_estimates;
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sensor_impl::bus_ids
+ */
+visus::power_overwhelming::detail::cached_discovery<std::string>
+visus::power_overwhelming::detail::nvml_sensor_impl::bus_ids;
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sensor_impl::get_bus_ids
+ */
+std::vector<std::string>
+visus::power_overwhelming::detail::nvml_sensor_impl::get_bus_ids(void) {
+    // Initialising NVML and enumerating the devices is expensive, so we only
+    // do this if the device catalogue has been invalidated.
+    return bus_ids.get([](void) {
+        unsigned int cnt = 0;
+        std::vector<std::string> retval;
+        nvml_scope scope;
+
+        {
+            auto status = nvidia_management_library::instance()
+                .nvmlDeviceGetCount(&cnt);
+            if (status != NVML_SUCCESS) {
+                throw nvml_exception(status);
+            }
+        }
+
+        retval.reserve(cnt);
+
+        for (unsigned int i = 0; i < cnt; ++i) {
+            nvmlDevice_t device;
+            nvmlPciInfo_t info;
+
+            auto status = nvidia_management_library::instance()
+                .nvmlDeviceGetHandleByIndex(i, &device);
+            if (status != NVML_SUCCESS) {
+                throw nvml_exception(status);
+            }
+
+            status = nvidia_management_library::instance()
+                .nvmlDeviceGetPciInfo(device, &info);
+            if (status != NVML_SUCCESS) {
+                throw nvml_exception(status);
+            }
+
+            retval.emplace_back(info.busId);
+        }
+
+        return retval;
+    });
+}
 
 
 /*
  * visus::power_overwhelming::detail::nvml_sensor_impl::sampler
  */
+visus::power_overwhelming::detail::sampler<
+    visus::power_overwhelming::detail::nvml_sampler_context>
+visus::power_overwhelming::detail::nvml_sensor_impl::sampler;
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sensor_impl::buffer_sampler
+ */
 visus::power_overwhelming::detail::sampler<
     visus::power_overwhelming::detail::default_sampler_context<
     visus::power_overwhelming::detail::nvml_sensor_impl>>
-visus::power_overwhelming::detail::nvml_sensor_impl::sampler;
+visus::power_overwhelming::detail::nvml_sensor_impl::buffer_sampler;
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sensor_impl::field_id
+ */
+unsigned int visus::power_overwhelming::detail::nvml_sensor_impl::field_id(
+        _In_ const nvml_quantity quantity) {
+    switch (quantity) {
+        case nvml_quantity::energy:
+            return NVML_FI_DEV_TOTAL_ENERGY_CONSUMPTION;
+
+        case nvml_quantity::memory_temperature:
+            return NVML_FI_DEV_MEMORY_TEMP;
+
+        case nvml_quantity::power:
+            return NVML_FI_DEV_POWER_INSTANT;
+
+        default:
+            throw std::invalid_argument("The specified quantity cannot be "
+                "retrieved from NVML.");
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sensor_impl::to_double
+ */
+double visus::power_overwhelming::detail::nvml_sensor_impl::to_double(
+        _In_ const nvmlFieldValue_t& value) {
+    return to_double(value.valueType, value.value);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sensor_impl::to_double
+ */
+double visus::power_overwhelming::detail::nvml_sensor_impl::to_double(
+        _In_ const nvmlValueType_t type,
+        _In_ const nvmlValue_t& value) {
+    switch (type) {
+        case NVML_VALUE_TYPE_DOUBLE:
+            return value.dVal;
+
+        case NVML_VALUE_TYPE_UNSIGNED_INT:
+            return static_cast<double>(value.uiVal);
+
+        case NVML_VALUE_TYPE_UNSIGNED_LONG:
+            return static_cast<double>(value.ulVal);
+
+        case NVML_VALUE_TYPE_UNSIGNED_LONG_LONG:
+            return static_cast<double>(value.ullVal);
+
+        case NVML_VALUE_TYPE_SIGNED_LONG_LONG:
+            return static_cast<double>(value.sllVal);
+
+        default:
+            return std::numeric_limits<double>::quiet_NaN();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sensor_impl::nvml_sensor_impl
+ */
+visus::power_overwhelming::detail::nvml_sensor_impl::nvml_sensor_impl(void)
+        : buffered_mode(false), device(nullptr), energy_mode(false),
+        estimation_mode(false), fields_supported(true), governed(false),
+        last_sample_time(0), last_energy(0),
+        last_power(std::numeric_limits<double>::quiet_NaN()),
+        last_process_time(0), observations(0),
+        native_interval_value(0), original_limit(0),
+        process_energy_mode(false) {
+    this->observed.fill(0.0);
+    this->values.fill(std::numeric_limits<double>::quiet_NaN());
+}
 
 
 /*
@@ -29,6 +179,311 @@ visus::power_overwhelming::detail::nvml_sensor_impl::~nvml_sensor_impl(void) {
     // Make sure that a sensor that is being destroyed is removed from all
     // asynchronous sampling threads.
     nvml_sensor_impl::sampler.remove(this);
+    nvml_sensor_impl::buffer_sampler.remove(this);
+
+    // Hand the GPU back with the limit it had before it was governed.
+    try {
+        this->enable_governor(power_governor());
+    } catch (...) { /* There is nothing we can do about it here. */ }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sensor_impl::drain
+ */
+void visus::power_overwhelming::detail::nvml_sensor_impl::drain(
+        _Inout_ std::vector<measurement_data>& dst,
+        _In_ const timestamp_resolution resolution) const {
+    typedef std::chrono::system_clock::time_point time_point;
+    auto& nvml = nvidia_management_library::instance();
+    if (nvml.nvmlDeviceGetSamples == nullptr) {
+        throw nvml_exception(NVML_ERROR_FUNCTION_NOT_FOUND);
+    }
+
+    unsigned long long last_seen = 0;
+    {
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        last_seen = this->last_sample_time;
+    }
+
+    // Ask for the number of samples first, which is small as long as the
+    // buffer is drained frequently, and reuse the buffer afterwards.
+    unsigned int cnt = 0;
+    nvmlValueType_t type;
+    auto status = nvml.nvmlDeviceGetSamples(this->device,
+        NVML_TOTAL_POWER_SAMPLES, last_seen, &type, &cnt, nullptr);
+    if ((status == NVML_ERROR_NOT_FOUND) || (cnt == 0)) {
+        // There are no new samples since the last call.
+        return;
+    }
+    if (status != NVML_SUCCESS) {
+        throw nvml_exception(status);
+    }
+
+    if (this->samples.size() < cnt) {
+        this->samples.resize(cnt);
+    }
+
+    status = nvml.nvmlDeviceGetSamples(this->device, NVML_TOTAL_POWER_SAMPLES,
+        last_seen, &type, &cnt, this->samples.data());
+    if (status == NVML_ERROR_NOT_FOUND) {
+        return;
+    }
+    if (status != NVML_SUCCESS) {
+        throw nvml_exception(status);
+    }
+
+    const auto converter = get_timestamp_converter(resolution);
+    auto power = std::numeric_limits<double>::quiet_NaN();
+    auto total_power = 0.0;
+    unsigned int total_count = 0;
+    dst.reserve(dst.size() + cnt);
+
+    for (unsigned int i = 0; i < cnt; ++i) {
+        const auto& s = this->samples[i];
+        if (s.timeStamp <= last_seen) {
+            continue;
+        }
+
+        // The driver reports the power in milliwatts with the CPU time in
+        // microseconds since the Unix epoch when the sample was recorded.
+        const auto time = time_point(std::chrono::duration_cast<
+            time_point::duration>(std::chrono::microseconds(s.timeStamp)));
+        power = to_double(type, s.sampleValue) / 1000.0;
+        last_seen = s.timeStamp;
+
+        dst.emplace_back(converter(convert_to_file_time(time)),
+            static_cast<measurement_data::value_type>(power));
+
+        if (this->governed.load()) {
+            this->govern(power);
+        }
+
+        total_power += power;
+        ++total_count;
+    }
+
+    // The utilisation per process is only retrieved once per batch in order
+    // not to add a call per buffered sample.
+    if (this->process_energy_mode.load() && (total_count > 0)) {
+        this->attribute(total_power / total_count);
+    }
+
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    this->last_sample_time = last_seen;
+    if (!std::isnan(power)) {
+        this->values[static_cast<std::size_t>(nvml_quantity::power)] = power;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sensor_impl::enable_buffered_mode
+ */
+void visus::power_overwhelming::detail::nvml_sensor_impl::enable_buffered_mode(
+        _In_ const bool enabled) {
+    if (enabled) {
+        if (nvidia_management_library::instance().nvmlDeviceGetSamples
+                == nullptr) {
+            throw nvml_exception(NVML_ERROR_FUNCTION_NOT_FOUND);
+        }
+
+        // Skip everything the driver has recorded before.
+        const auto now = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch());
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        this->last_sample_time = static_cast<unsigned long long>(now.count());
+    }
+
+    this->buffered_mode.store(enabled);
+}
+
+
+/*
+ * ...::detail::nvml_sensor_impl::enable_estimation_mode
+ */
+void visus::power_overwhelming::detail::nvml_sensor_impl
+::enable_estimation_mode(_In_ const bool enabled) {
+    if (enabled) {
+        // Make sure that the device provides all regressors before the
+        // sampler thread relies on them.
+        this->sample_activity();
+
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        this->estimates.clear();
+        this->last_power = std::numeric_limits<double>::quiet_NaN();
+        this->model.reset();
+        this->observations = 0;
+        this->observed.fill(0.0);
+    }
+
+    this->estimation_mode.store(enabled);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sensor_impl::enable_energy_mode
+ */
+void visus::power_overwhelming::detail::nvml_sensor_impl::enable_energy_mode(
+        _In_ const bool enabled) {
+    if (enabled) {
+        // Establish the baseline before enabling the mode such that the
+        // sampler thread cannot compute a difference to an invalid value.
+        const auto energy = this->read_energy(this->sample_fields());
+        const auto now = clock_type::now();
+
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        this->last_energy = energy;
+        this->last_time = now;
+    }
+
+    this->energy_mode.store(enabled);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sensor_impl::enable_governor
+ */
+void visus::power_overwhelming::detail::nvml_sensor_impl::enable_governor(
+        _In_ const power_governor& governor) {
+    auto& nvml = nvidia_management_library::instance();
+    std::lock_guard<decltype(this->governor_lock)> l(this->governor_lock);
+
+    if (!governor) {
+        this->governed.store(false);
+        this->controller.reset();
+        this->governor = governor;
+
+        if (this->original_limit != 0) {
+            auto status = nvml.nvmlDeviceSetPowerManagementLimit(this->device,
+                this->original_limit);
+            if (status != NVML_SUCCESS) {
+                throw nvml_exception(status);
+            }
+            this->original_limit = 0;
+        }
+        return;
+    }
+
+    if ((nvml.nvmlDeviceGetPowerManagementLimit == nullptr)
+            || (nvml.nvmlDeviceGetPowerManagementLimitConstraints == nullptr)
+            || (nvml.nvmlDeviceSetPowerManagementLimit == nullptr)) {
+        throw nvml_exception(NVML_ERROR_FUNCTION_NOT_FOUND);
+    }
+
+    unsigned int max_limit = 0;
+    unsigned int min_limit = 0;
+    auto status = nvml.nvmlDeviceGetPowerManagementLimitConstraints(
+        this->device, &min_limit, &max_limit);
+    if (status != NVML_SUCCESS) {
+        throw nvml_exception(status);
+    }
+
+    unsigned int limit = 0;
+    status = nvml.nvmlDeviceGetPowerManagementLimit(this->device, &limit);
+    if (status != NVML_SUCCESS) {
+        throw nvml_exception(status);
+    }
+
+    std::unique_ptr<power_cap_controller> controller(new power_cap_controller(
+        governor, min_limit / 1000.0, max_limit / 1000.0, limit / 1000.0));
+
+    // Apply the initial limit before the sampler thread starts using the
+    // controller, which fails early if we lack the privileges.
+    status = nvml.nvmlDeviceSetPowerManagementLimit(this->device,
+        static_cast<unsigned int>(std::lround(controller->limit() * 1000.0)));
+    if (status != NVML_SUCCESS) {
+        throw nvml_exception(status);
+    }
+
+    if (this->original_limit == 0) {
+        this->original_limit = limit;
+    }
+
+    this->control_deadline = clock_type::now()
+        + std::chrono::microseconds(governor.interval());
+    this->controller = std::move(controller);
+    this->governor = governor;
+    this->governed.store(true);
+}
+
+
+/*
+ * ...::detail::nvml_sensor_impl::enable_process_energy_mode
+ */
+void visus::power_overwhelming::detail::nvml_sensor_impl
+::enable_process_energy_mode(_In_ const bool enabled) {
+    if (enabled) {
+        auto& nvml = nvidia_management_library::instance();
+        if (nvml.nvmlDeviceGetProcessUtilization == nullptr) {
+            throw nvml_exception(NVML_ERROR_FUNCTION_NOT_FOUND);
+        }
+
+        // Skip everything the driver has recorded before, which also tells
+        // us whether the device supports the query at all.
+        const auto now = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch());
+        const auto last_seen = static_cast<unsigned long long>(now.count());
+        unsigned int cnt = 0;
+        auto status = nvml.nvmlDeviceGetProcessUtilization(this->device,
+            nullptr, &cnt, last_seen);
+        switch (status) {
+            case NVML_SUCCESS:
+            case NVML_ERROR_INSUFFICIENT_SIZE:
+            case NVML_ERROR_NOT_FOUND:
+                break;
+
+            default:
+                throw nvml_exception(status);
+        }
+
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        this->last_attribution = clock_type::now();
+        this->last_process_time = last_seen;
+        this->process_energies.reset();
+    }
+
+    this->process_energy_mode.store(enabled);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sensor_impl::get_estimates
+ */
+std::size_t visus::power_overwhelming::detail::nvml_sensor_impl::get_estimates(
+        _Out_writes_opt_(cnt) power_estimate *dst,
+        _In_ const std::size_t cnt) {
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+
+    if (dst == nullptr) {
+        return this->estimates.size();
+    }
+
+    const auto retval = (std::min)(cnt, this->estimates.size());
+    const auto end = this->estimates.begin() + retval;
+    std::copy(this->estimates.begin(), end, dst);
+    this->estimates.erase(this->estimates.begin(), end);
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sensor_impl::get_process_energies
+ */
+std::size_t
+visus::power_overwhelming::detail::nvml_sensor_impl::get_process_energies(
+        _Out_writes_opt_(cnt) process_energy *dst,
+        _In_ const std::size_t cnt) const {
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    const auto energies = this->process_energies.summary();
+
+    if (dst == nullptr) {
+        return energies.size();
+    }
+
+    const auto retval = (std::min)(cnt, energies.size());
+    std::copy(energies.begin(), energies.begin() + retval, dst);
+    return retval;
 }
 
 
@@ -36,9 +491,11 @@ visus::power_overwhelming::detail::nvml_sensor_impl::~nvml_sensor_impl(void) {
  * visus::power_overwhelming::detail::nvml_sensor_impl::load_device_name
  */
 void visus::power_overwhelming::detail::nvml_sensor_impl::load_device_name(
-        void) {
-    {
+        void) const {
+    std::call_once(this->names_loaded, [this](void) {
         std::array<char, NVML_DEVICE_NAME_BUFFER_SIZE> name;
+        std::array<char, NVML_DEVICE_UUID_BUFFER_SIZE> guid;
+        nvmlPciInfo_t pciInfo;
 
         auto status = nvidia_management_library::instance().nvmlDeviceGetName(
             this->device, name.data(), static_cast<unsigned int>(name.size()));
@@ -46,34 +503,67 @@ void visus::power_overwhelming::detail::nvml_sensor_impl::load_device_name(
             throw nvml_exception(status);
         }
 
-        this->device_name = power_overwhelming::convert_string<wchar_t>(
-            name.data());
-    }
-
-    {
-        std::array<char, NVML_DEVICE_UUID_BUFFER_SIZE> guid;
-
-        auto status = nvidia_management_library::instance().nvmlDeviceGetUUID(
+        status = nvidia_management_library::instance().nvmlDeviceGetUUID(
             this->device, guid.data(), static_cast<unsigned int>(guid.size()));
         if (status != NVML_SUCCESS) {
             throw nvml_exception(status);
         }
 
-        this->device_guid = guid.data();
-    }
-
-    {
-        nvmlPciInfo_t pciInfo;
-
-        auto status = nvidia_management_library::instance()
-            .nvmlDeviceGetPciInfo(this->device, &pciInfo);
+        status = nvidia_management_library::instance().nvmlDeviceGetPciInfo(
+            this->device, &pciInfo);
         if (status != NVML_SUCCESS) {
             throw nvml_exception(status);
         }
 
+        this->device_name = power_overwhelming::convert_string<wchar_t>(
+            name.data());
+        this->device_guid = guid.data();
         this->sensor_name = L"NVML/" + this->device_name + L"/"
             + power_overwhelming::convert_string<wchar_t>(pciInfo.busId);
+    });
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sensor_impl::native_interval
+ */
+std::chrono::microseconds
+visus::power_overwhelming::detail::nvml_sensor_impl::native_interval(
+        void) const {
+    std::call_once(this->native_interval_probed, [this](void) {
+        auto& nvml = nvidia_management_library::instance();
+        this->native_interval_value = probe_update_interval([&](void) {
+            unsigned int retval = 0;
+            auto status = nvml.nvmlDeviceGetPowerUsage(this->device, &retval);
+            if (status != NVML_SUCCESS) {
+                throw nvml_exception(status);
+            }
+            return retval;
+        });
+    });
+
+    return this->native_interval_value;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sensor_impl::power_limit
+ */
+double visus::power_overwhelming::detail::nvml_sensor_impl::power_limit(
+        void) const {
+    auto& nvml = nvidia_management_library::instance();
+    if (nvml.nvmlDeviceGetPowerManagementLimit == nullptr) {
+        throw nvml_exception(NVML_ERROR_FUNCTION_NOT_FOUND);
     }
+
+    unsigned int retval = 0;
+    auto status = nvml.nvmlDeviceGetPowerManagementLimit(this->device,
+        &retval);
+    if (status != NVML_SUCCESS) {
+        throw nvml_exception(status);
+    }
+
+    return retval / 1000.0;
 }
 
 
@@ -83,17 +573,400 @@ void visus::power_overwhelming::detail::nvml_sensor_impl::load_device_name(
 visus::power_overwhelming::measurement_data
 visus::power_overwhelming::detail::nvml_sensor_impl::sample(
         const timestamp_resolution resolution) const {
+    auto retval = this->sample_power(resolution);
+
+    if (this->estimation_mode.load()) {
+        this->estimate(retval);
+    }
+
+    if (this->governed.load()) {
+        this->govern(retval.power());
+    }
+
+    if (this->process_energy_mode.load()) {
+        this->attribute(retval.power());
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sensor_impl::value
+ */
+double visus::power_overwhelming::detail::nvml_sensor_impl::value(
+        _In_ const nvml_quantity quantity) const {
+    const auto i = static_cast<std::size_t>(quantity);
+    if (i >= this->values.size()) {
+        throw std::invalid_argument("The specified quantity cannot be "
+            "retrieved from NVML.");
+    }
+
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    return this->values[i];
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sensor_impl::attribute
+ */
+void visus::power_overwhelming::detail::nvml_sensor_impl::attribute(
+        _In_ const double power) const {
+    typedef process_energy_integrator::utilisation_type utilisation_type;
+    static constexpr unsigned long long max_silence = 2000000;
+    static constexpr unsigned int min_capacity = 16;
+
+    if (this->process_samples.size() < min_capacity) {
+        this->process_samples.resize(min_capacity);
+    }
+
+    unsigned long long last_seen = 0;
+    {
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        last_seen = this->last_process_time;
+    }
+
+    auto cnt = static_cast<unsigned int>(this->process_samples.size());
+    const auto status = nvidia_management_library::instance()
+        .nvmlDeviceGetProcessUtilization(this->device,
+            this->process_samples.data(), &cnt, last_seen);
+    const auto now = clock_type::now();
+    const auto wall_now = static_cast<unsigned long long>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+
+    if (status == NVML_ERROR_INSUFFICIENT_SIZE) {
+        // Grow the buffer for the next sample, which retains the current
+        // shares for this one.
+        this->process_samples.resize((std::max)(2 * cnt, min_capacity));
+        cnt = 0;
+    } else if (status != NVML_SUCCESS) {
+        // Most notably, NVML_ERROR_NOT_FOUND indicates that the driver has
+        // not updated the utilisation since the previous call.
+        cnt = 0;
+    }
+
+    std::vector<utilisation_type> utilisation;
+    utilisation.reserve(cnt);
+    for (unsigned int i = 0; i < cnt; ++i) {
+        const auto& s = this->process_samples[i];
+        if (s.timeStamp > last_seen) {
+            utilisation.push_back({ s.memUtil, s.pid, s.smUtil });
+        }
+    }
+
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    for (unsigned int i = 0; i < cnt; ++i) {
+        this->last_process_time = (std::max)(this->last_process_time,
+            this->process_samples[i].timeStamp);
+    }
+    if (!utilisation.empty()) {
+        this->process_energies.update(utilisation.data(), utilisation.size());
+    } else if (wall_now > this->last_process_time + max_silence) {
+        // The driver stops reporting once all processes have exited, so
+        // processes that have not been seen for a while must not be charged
+        // any more.
+        this->process_energies.update(nullptr, 0);
+    }
+
+    const auto dt = std::chrono::duration<double>(now
+        - this->last_attribution).count();
+    this->last_attribution = now;
+    this->process_energies.push(power, dt);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sensor_impl::estimate
+ */
+void visus::power_overwhelming::detail::nvml_sensor_impl::estimate(
+        _In_ const measurement_data& sample) const {
+    typedef measurement_data::value_type value_type;
+
+    try {
+        this->sample_activity();
+    } catch (...) {
+        // A missing observation only reduces the rate of the estimates, so it
+        // must not invalidate the measurement.
+        return;
+    }
+
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    const auto x = power_model::features(
+        this->values[static_cast<std::size_t>(nvml_quantity::gpu_utilisation)],
+        this->values[static_cast<std::size_t>(
+            nvml_quantity::memory_utilisation)],
+        this->values[static_cast<std::size_t>(nvml_quantity::graphics_clock)],
+        this->values[static_cast<std::size_t>(nvml_quantity::memory_clock)]);
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        this->observed[i] += x[i];
+    }
+    ++this->observations;
+
+    // The power reading of the driver only changes when it publishes a new
+    // average, whereas the energy mode yields a new average with each sample.
+    const auto power = static_cast<double>(sample.power());
+    if (!std::isnan(power) && (power != this->last_power)) {
+        if (!std::isnan(this->last_power)) {
+            auto mean = this->observed;
+            for (auto& m : mean) {
+                m /= static_cast<double>(this->observations);
+            }
+            this->model.update(mean, power);
+        }
+
+        this->last_power = power;
+        this->observations = 0;
+        this->observed.fill(0.0);
+    }
+
+    double predicted, lower, upper;
+    if (this->model.predict(predicted, lower, upper, x)) {
+        if (this->estimates.size() >= max_estimates) {
+            this->estimates.pop_front();
+        }
+
+        this->estimates.emplace_back(sample.timestamp(),
+            static_cast<value_type>(predicted),
+            static_cast<value_type>(lower),
+            static_cast<value_type>(upper));
+    }
+}
+
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sensor_impl::govern
+ */
+void visus::power_overwhelming::detail::nvml_sensor_impl::govern(
+        _In_ const double power) const {
+    std::lock_guard<decltype(this->governor_lock)> l(this->governor_lock);
+    if (this->controller == nullptr) {
+        return;
+    }
+
+    this->controller->observe(power);
+
+    // The control loop is clocked by the samples, so it does not need a
+    // timer of its own.
+    const auto now = clock_type::now();
+    if (now < this->control_deadline) {
+        return;
+    }
+    this->control_deadline = now
+        + std::chrono::microseconds(this->governor.interval());
+
+    const auto previous = this->controller->limit();
+    try {
+        const auto limit = this->controller->update();
+        if (limit != previous) {
+            // If the driver refuses the new limit, the device keeps running
+            // at the old one, which the next interval will measure.
+            nvidia_management_library::instance()
+                .nvmlDeviceSetPowerManagementLimit(this->device,
+                    static_cast<unsigned int>(std::lround(limit * 1000.0)));
+        }
+    } catch (...) { /* Keep the current limit. */ }
+}
+
+/*
+ * visus::power_overwhelming::detail::nvml_sensor_impl::read_energy
+ */
+double visus::power_overwhelming::detail::nvml_sensor_impl::read_energy(
+        _In_ const bool from_fields) const {
+    if (from_fields) {
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        const auto retval = this->values[static_cast<std::size_t>(
+            nvml_quantity::energy)];
+        if (!std::isnan(retval)) {
+            return retval;
+        }
+    }
+
+    auto& nvml = nvidia_management_library::instance();
+    if (nvml.nvmlDeviceGetTotalEnergyConsumption == nullptr) {
+        throw nvml_exception(NVML_ERROR_FUNCTION_NOT_FOUND);
+    }
+
+    unsigned long long mj = 0;
+    auto status = nvml.nvmlDeviceGetTotalEnergyConsumption(this->device, &mj);
+    if (status != NVML_SUCCESS) {
+        throw nvml_exception(status);
+    }
+
+    const auto retval = static_cast<double>(mj) / 1000.0;
+    {
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        this->values[static_cast<std::size_t>(nvml_quantity::energy)] = retval;
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sensor_impl::sample_activity
+ */
+void visus::power_overwhelming::detail::nvml_sensor_impl::sample_activity(
+        void) const {
+    auto& nvml = nvidia_management_library::instance();
+    if ((nvml.nvmlDeviceGetClockInfo == nullptr)
+            || (nvml.nvmlDeviceGetUtilizationRates == nullptr)) {
+        throw nvml_exception(NVML_ERROR_FUNCTION_NOT_FOUND);
+    }
+
+    nvmlUtilization_t utilisation;
+    auto status = nvml.nvmlDeviceGetUtilizationRates(this->device,
+        &utilisation);
+    if (status != NVML_SUCCESS) {
+        throw nvml_exception(status);
+    }
+
+    unsigned int graphics = 0;
+    status = nvml.nvmlDeviceGetClockInfo(this->device, NVML_CLOCK_GRAPHICS,
+        &graphics);
+    if (status != NVML_SUCCESS) {
+        throw nvml_exception(status);
+    }
+
+    unsigned int memory = 0;
+    status = nvml.nvmlDeviceGetClockInfo(this->device, NVML_CLOCK_MEM,
+        &memory);
+    if (status != NVML_SUCCESS) {
+        throw nvml_exception(status);
+    }
+
+    // NVML reports the utilisation in percent and the clocks in Megahertz.
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    this->values[static_cast<std::size_t>(nvml_quantity::gpu_utilisation)]
+        = utilisation.gpu / 100.0;
+    this->values[static_cast<std::size_t>(nvml_quantity::memory_utilisation)]
+        = utilisation.memory / 100.0;
+    this->values[static_cast<std::size_t>(nvml_quantity::graphics_clock)]
+        = graphics * 1e6;
+    this->values[static_cast<std::size_t>(nvml_quantity::memory_clock)]
+        = memory * 1e6;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sensor_impl::sample_power
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::detail::nvml_sensor_impl::sample_power(
+        _In_ const timestamp_resolution resolution) const {
     static constexpr auto thousand = static_cast<measurement_data::value_type>(1000);
     const auto timestamp = create_timestamp(resolution);
+    const auto have_fields = this->sample_fields();
+
+    if (this->energy_mode.load()) {
+        // Derive the average power since the last sample from the energy
+        // counter, which is not subject to the internal averaging of NVML.
+        const auto energy = this->read_energy(have_fields);
+        const auto now = clock_type::now();
+
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        const auto de = energy - this->last_energy;
+        const auto dt = std::chrono::duration<double>(now
+            - this->last_time).count();
+        this->last_energy = energy;
+        this->last_time = now;
+
+        // If the counter was reset, because the driver was reloaded, we
+        // cannot compute the power, but we have a new baseline for the next
+        // sample.
+        const auto power = ((de >= 0.0) && (dt > 0.0))
+            ? de / dt
+            : std::numeric_limits<double>::quiet_NaN();
+        return measurement_data(timestamp,
+            static_cast<measurement_data::value_type>(power));
+    }
+
+    if (have_fields) {
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        const auto power = this->values[static_cast<std::size_t>(
+            nvml_quantity::power)];
+        if (!std::isnan(power)) {
+            return measurement_data(timestamp,
+                static_cast<measurement_data::value_type>(power));
+        }
+    }
 
-    // Get the power usage in milliwatts.
+    // Get the power usage in milliwatts via the legacy API if the field value
+    // API did not provide the power.
     unsigned int mw = 0;
-    auto status = detail::nvidia_management_library::instance()
+    auto status = nvidia_management_library::instance()
         .nvmlDeviceGetPowerUsage(this->device, &mw);
     if (status != NVML_SUCCESS) {
         throw nvml_exception(status);
     }
 
-    return measurement_data(timestamp,
-        static_cast<measurement_data::value_type>(mw) / thousand);
+    const auto retval = static_cast<measurement_data::value_type>(mw)
+        / thousand;
+    {
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        this->values[static_cast<std::size_t>(nvml_quantity::power)] = retval;
+    }
+
+    return measurement_data(timestamp, retval);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sensor_impl::sample_fields
+ */
+bool visus::power_overwhelming::detail::nvml_sensor_impl::sample_fields(
+        void) const {
+    static constexpr nvml_quantity quantities[] = {
+        nvml_quantity::energy,
+        nvml_quantity::memory_temperature,
+        nvml_quantity::power
+    };
+    static constexpr auto cnt = sizeof(quantities) / sizeof(*quantities);
+    static_assert(cnt <= std::tuple_size<values_type>::value, "All "
+        "quantities requested from NVML must be cached.");
+    auto& nvml = nvidia_management_library::instance();
+
+    if (!this->fields_supported.load()
+            || (nvml.nvmlDeviceGetFieldValues == nullptr)) {
+        return false;
+    }
+
+    std::array<nvmlFieldValue_t, cnt> fields;
+    ::memset(fields.data(), 0, fields.size() * sizeof(nvmlFieldValue_t));
+    for (std::size_t i = 0; i < fields.size(); ++i) {
+        assert(static_cast<std::size_t>(quantities[i]) == i);
+        fields[i].fieldId = field_id(quantities[i]);
+    }
+
+    auto status = nvml.nvmlDeviceGetFieldValues(this->device,
+        static_cast<int>(fields.size()), fields.data());
+    switch (status) {
+        case NVML_SUCCESS:
+            break;
+
+        case NVML_ERROR_NOT_SUPPORTED:
+        case NVML_ERROR_FUNCTION_NOT_FOUND:
+            // Old drivers do not support the field value API at all, so we do
+            // not try again on the next sample.
+            this->fields_supported.store(false);
+            return false;
+
+        default:
+            throw nvml_exception(status);
+    }
+
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    for (std::size_t i = 0; i < fields.size(); ++i) {
+        this->values[i] = (fields[i].nvmlReturn == NVML_SUCCESS)
+            ? to_double(fields[i])
+            : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    // The energy is reported in millijoules and the power in milliwatts, so
+    // convert them to SI units.
+    this->values[static_cast<std::size_t>(nvml_quantity::energy)] /= 1000.0;
+    this->values[static_cast<std::size_t>(nvml_quantity::power)] /= 1000.0;
+
+    return true;
 }
@@ -5,11 +5,29 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include <nvml.h>
 
+#include "power_overwhelming/nvml_quantity.h"
+#include "power_overwhelming/power_estimate.h"
+#include "power_overwhelming/power_governor.h"
+
+#include "cached_discovery.h"
+#include "default_sampler_context.h"
+#include "nvml_field_values.h"
+#include "nvml_sampler_context.h"
 #include "nvml_scope.h"
+#include "power_cap_controller.h"
+#include "power_model.h"
+#include "process_energy_integrator.h"
 #include "sampler.h"
 #include "timestamp.h"
 
@@ -24,10 +42,86 @@ namespace detail {
     struct nvml_sensor_impl final {
 
         /// <summary>
-        /// A sampler for NVML sensors.
+        /// The PCI bus IDs of all NVML devices on the system, which are
+        /// enumerated only once until the <see cref="device_catalogue" />
+        /// changes.
+        /// </summary>
+        static cached_discovery<std::string> bus_ids;
+
+        /// <summary>
+        /// Gets the PCI bus IDs of all NVML devices from the cache in
+        /// <see cref="bus_ids" /> or enumerates them if the cache is not
+        /// valid.
+        /// </summary>
+        /// <returns>The PCI bus IDs of all NVML devices.</returns>
+        /// <exception cref="nvml_exception">If the NVML could not be loaded
+        /// or the devices could not be enumerated.</exception>
+        static std::vector<std::string> get_bus_ids(void);
+
+        /// <summary>
+        /// A sampler for NVML sensors in <see cref="buffered_mode" />, which
+        /// drains the sample buffers of the driver instead of reading the
+        /// current power.
+        /// </summary>
+        static detail::sampler<default_sampler_context<nvml_sensor_impl>>
+            buffer_sampler;
+
+        /// <summary>
+        /// A sampler for NVML sensors, which queries multiple GPUs in
+        /// parallel.
+        /// </summary>
+        static detail::sampler<nvml_sampler_context> sampler;
+
+        /// <summary>
+        /// The clock used to measure the time between two readings of the
+        /// energy counter.
+        /// </summary>
+        typedef std::chrono::steady_clock clock_type;
+
+        /// <summary>
+        /// The type of the array holding the most recent value of each
+        /// <see cref="nvml_quantity" />.
+        /// </summary>
+        typedef std::array<double, 7> values_type;
+
+        /// <summary>
+        /// The maximum number of estimates retained in
+        /// <see cref="estimation_mode" /> until they are retrieved, which
+        /// covers more than a minute at the maximum sampling rate of NVML.
+        /// </summary>
+        static constexpr std::size_t max_estimates = 1 << 16;
+
+        /// <summary>
+        /// Answer the NVML field ID that provides the given quantity.
         /// </summary>
-        static detail::sampler<default_sampler_context<
-            nvml_sensor_impl>> sampler;
+        /// <param name="quantity">The quantity to get the field for.</param>
+        /// <returns>The ID of the NVML field.</returns>
+        static unsigned int field_id(_In_ const nvml_quantity quantity);
+
+        /// <summary>
+        /// Converts the value of the given field to a <c>double</c> regardless
+        /// of the type NVML reported.
+        /// </summary>
+        /// <param name="value">The field value to convert.</param>
+        /// <returns>The value as <c>double</c>.</returns>
+        static double to_double(_In_ const nvmlFieldValue_t& value);
+
+        /// <summary>
+        /// Converts a value of the given type to a <c>double</c>.
+        /// </summary>
+        /// <param name="type">The type NVML reported for the value.</param>
+        /// <param name="value">The value to convert.</param>
+        /// <returns>The value as <c>double</c>, which is NaN if the
+        /// <paramref name="type" /> is unknown.</returns>
+        static double to_double(_In_ const nvmlValueType_t type,
+            _In_ const nvmlValue_t& value);
+
+        /// <summary>
+        /// Determines whether asynchronous batches are obtained by draining
+        /// the power samples the driver has buffered rather than by polling
+        /// the current power.
+        /// </summary>
+        std::atomic<bool> buffered_mode;
 
         /// <summary>
         /// The NVML device the sensor is reading from.
@@ -37,12 +131,179 @@ namespace detail {
         /// <summary>
         /// The unique ID which NVML uses to identify the device.
         /// </summary>
-        std::string device_guid;
+        mutable std::string device_guid;
 
         /// <summary>
         /// The name of the device.
         /// </summary>
-        std::wstring device_name;
+        mutable std::wstring device_name;
+
+        /// <summary>
+        /// Determines whether the power is derived from the difference of the
+        /// total energy counter between two samples rather than retrieved
+        /// from the instantaneous power reading.
+        /// </summary>
+        std::atomic<bool> energy_mode;
+
+        /// <summary>
+        /// Determines whether the utilisation and the clocks are retrieved
+        /// with each sample in order to estimate the power from them.
+        /// </summary>
+        std::atomic<bool> estimation_mode;
+
+        /// <summary>
+        /// The estimates that have not yet been retrieved, which are only
+        /// produced in <see cref="estimation_mode" />.
+        /// </summary>
+        mutable std::deque<power_estimate> estimates;
+
+        /// <summary>
+        /// Remembers whether <c>nvmlDeviceGetFieldValues</c> is supported
+        /// for the device, which is assumed until the driver reports
+        /// otherwise.
+        /// </summary>
+        mutable std::atomic<bool> fields_supported;
+
+        /// <summary>
+        /// The control loop of the <see cref="governor" />, which exists
+        /// while the governor changes the power limit.
+        /// </summary>
+        mutable std::unique_ptr<power_cap_controller> controller;
+
+        /// <summary>
+        /// The time at which the current control interval of the
+        /// <see cref="controller" /> ends.
+        /// </summary>
+        mutable clock_type::time_point control_deadline;
+
+        /// <summary>
+        /// Indicates whether the sampler thread needs to feed the
+        /// <see cref="controller" />, which allows for skipping
+        /// <see cref="governor_lock" /> otherwise.
+        /// </summary>
+        std::atomic<bool> governed;
+
+        /// <summary>
+        /// The description of the governor that is currently active.
+        /// </summary>
+        power_governor governor;
+
+        /// <summary>
+        /// A lock protecting <see cref="controller" />,
+        /// <see cref="control_deadline" />, <see cref="governor" /> and
+        /// <see cref="original_limit" />.
+        /// </summary>
+        mutable std::mutex governor_lock;
+
+        /// <summary>
+        /// The timestamp of the most recent sample obtained in
+        /// <see cref="buffered_mode" />, in microseconds since the Unix epoch.
+        /// </summary>
+        mutable unsigned long long last_sample_time;
+
+        /// <summary>
+        /// Remembers the total energy in Joules when the sensor was last
+        /// sampled in <see cref="energy_mode" />.
+        /// </summary>
+        mutable double last_energy;
+
+        /// <summary>
+        /// Remembers the power reading that the <see cref="model" /> has last
+        /// been updated with in order to detect when the driver publishes a
+        /// new one.
+        /// </summary>
+        mutable double last_power;
+
+        /// <summary>
+        /// Remembers the timestamp of the most recent utilisation per process
+        /// in microseconds since the Unix epoch.
+        /// </summary>
+        mutable unsigned long long last_process_time;
+
+        /// <summary>
+        /// Remembers when the energy has last been attributed in
+        /// <see cref="process_energy_mode" />.
+        /// </summary>
+        mutable clock_type::time_point last_attribution;
+
+        /// <summary>
+        /// Remembers when the sensor was last sampled in
+        /// <see cref="energy_mode" />.
+        /// </summary>
+        mutable clock_type::time_point last_time;
+
+        /// <summary>
+        /// A lock protecting <see cref="values" />, <see cref="last_energy" />,
+        /// <see cref="last_sample_time" />, <see cref="last_time" /> and the
+        /// state of the <see cref="estimation_mode" /> and the
+        /// <see cref="process_energy_mode" />, which are updated by the
+        /// sampler thread.
+        /// </summary>
+        mutable std::mutex lock;
+
+        /// <summary>
+        /// The model of the power that is fitted in
+        /// <see cref="estimation_mode" />.
+        /// </summary>
+        mutable power_model model;
+
+        /// <summary>
+        /// The sum of the regressors observed since the driver has published
+        /// the <see cref="last_power" />.
+        /// </summary>
+        mutable power_model::features_type observed;
+
+        /// <summary>
+        /// The number of regressors summed in <see cref="observed" />.
+        /// </summary>
+        mutable std::size_t observations;
+
+        /// <summary>
+        /// Makes sure that <see cref="load_device_name" /> queries the names
+        /// only once.
+        /// </summary>
+        mutable std::once_flag names_loaded;
+
+        /// <summary>
+        /// The buffer receiving the samples from the driver in
+        /// <see cref="drain" />, which is only used by the sampler thread.
+        /// </summary>
+        mutable std::vector<nvmlSample_t> samples;
+
+        /// <summary>
+        /// The update interval of the power reading, which is determined by
+        /// <see cref="native_interval" /> once.
+        /// </summary>
+        mutable std::chrono::microseconds native_interval_value;
+
+        /// <summary>
+        /// Makes sure that the update interval is only probed once.
+        /// </summary>
+        mutable std::once_flag native_interval_probed;
+
+        /// <summary>
+        /// The power limit in milliwatts before the <see cref="governor" />
+        /// changed it, or zero if the limit has not been changed.
+        /// </summary>
+        unsigned int original_limit;
+
+        /// <summary>
+        /// Splits the energy of the GPU between the processes using it in
+        /// <see cref="process_energy_mode" />.
+        /// </summary>
+        mutable process_energy_integrator process_energies;
+
+        /// <summary>
+        /// Determines whether the utilisation per process is retrieved with
+        /// each sample in order to attribute the energy to the processes.
+        /// </summary>
+        std::atomic<bool> process_energy_mode;
+
+        /// <summary>
+        /// The buffer receiving the utilisation per process in
+        /// <see cref="attribute" />, which is only used by the sampler thread.
+        /// </summary>
+        mutable std::vector<nvmlProcessUtilizationSample_t> process_samples;
 
         /// <summary>
         /// The NVML scope making sure the library is ready while the sensor
@@ -53,34 +314,287 @@ namespace detail {
         /// <summary>
         /// The sensor name.
         /// </summary>
-        std::wstring sensor_name;
+        mutable std::wstring sensor_name;
+
+        /// <summary>
+        /// The most recent value of each <see cref="nvml_quantity" />, which
+        /// is NaN if the quantity has not been retrieved successfully.
+        /// </summary>
+        mutable values_type values;
 
         /// <summary>
         /// Initialises a new instance.
         /// </summary>
-        inline nvml_sensor_impl(void) : device(nullptr) { }
+        nvml_sensor_impl(void);
 
         /// <summary>
         /// Finalises the instance.
         /// </summary>
         ~nvml_sensor_impl(void);
 
+        /// <summary>
+        /// Appends all power samples the driver has buffered since the last
+        /// call to <paramref name="dst" />.
+        /// </summary>
+        /// <remarks>
+        /// <para>The driver records the power of the GPU at its own rate,
+        /// which is much higher than what can be achieved by polling
+        /// <c>nvmlDeviceGetPowerUsage</c> and yields accurate timestamps,
+        /// because these have been taken when the samples were recorded. The
+        /// sampler only needs to drain the buffer frequently enough that it
+        /// does not overflow, i.e. at 10 to 50 Hz.</para>
+        /// <para>The method is used by the <see cref="buffer_sampler" /> and
+        /// updates the power in <see cref="values" /> with the most recent
+        /// sample.</para>
+        /// </remarks>
+        /// <param name="dst">The vector to append the samples to.</param>
+        /// <param name="resolution">The resolution of the timestamps to be
+        /// generated, which defaults to milliseconds.</param>
+        /// <exception cref="nvml_exception">If the samples could not be
+        /// retrieved.</exception>
+        void drain(_Inout_ std::vector<measurement_data>& dst,
+            _In_ const timestamp_resolution resolution
+            = timestamp_resolution::milliseconds) const;
+
+        /// <summary>
+        /// Enables or disables the <see cref="buffered_mode" />.
+        /// </summary>
+        /// <remarks>
+        /// Enabling the buffered mode discards all samples the driver has
+        /// buffered before, such that the first batch only contains new
+        /// samples.
+        /// </remarks>
+        /// <param name="enabled"></param>
+        /// <exception cref="nvml_exception">If the driver does not support
+        /// retrieving buffered samples.</exception>
+        void enable_buffered_mode(_In_ const bool enabled);
+
+        /// <summary>
+        /// Enables or disables the <see cref="estimation_mode" />.
+        /// </summary>
+        /// <remarks>
+        /// Enabling the estimation mode discards the model and all estimates
+        /// that have not yet been retrieved.
+        /// </remarks>
+        /// <param name="enabled"></param>
+        /// <exception cref="nvml_exception">If the utilisation or the clocks
+        /// cannot be retrieved from the device.</exception>
+        void enable_estimation_mode(_In_ const bool enabled);
+
+        /// <summary>
+        /// Enables or disables the <see cref="energy_mode" />.
+        /// </summary>
+        /// <remarks>
+        /// Enabling the energy mode reads the energy counter once in order to
+        /// establish the baseline for the first sample.
+        /// </remarks>
+        /// <param name="enabled"></param>
+        /// <exception cref="nvml_exception">If the energy counter is not
+        /// supported by the device or the driver.</exception>
+        void enable_energy_mode(_In_ const bool enabled);
+
+        /// <summary>
+        /// Installs a new <see cref="governor" />.
+        /// </summary>
+        /// <remarks>
+        /// The initial limit of the governor is applied immediately, which
+        /// tests whether the process may change the power limit. Removing the
+        /// governor restores the limit that was active before the first
+        /// governor was installed.
+        /// </remarks>
+        /// <param name="governor">The new governor, which may be
+        /// <see cref="power_governor_mode::none" /> for removing the current
+        /// one.</param>
+        /// <exception cref="nvml_exception">If the power limit cannot be
+        /// retrieved or changed, eg because the process lacks the required
+        /// privileges.</exception>
+        /// <exception cref="std::invalid_argument">If the range of the
+        /// governor does not overlap the one of the device.</exception>
+        void enable_governor(_In_ const power_governor& governor);
+
+        /// <summary>
+        /// Enables or disables the <see cref="process_energy_mode" />.
+        /// </summary>
+        /// <remarks>
+        /// Enabling the mode discards all energy attributed before and skips
+        /// any utilisation the driver has recorded before.
+        /// </remarks>
+        /// <param name="enabled"></param>
+        /// <exception cref="nvml_exception">If the driver or the device does
+        /// not support retrieving the utilisation per process.</exception>
+        void enable_process_energy_mode(_In_ const bool enabled);
+
+        /// <summary>
+        /// Moves the oldest <see cref="estimates" /> to
+        /// <paramref name="dst" />.
+        /// </summary>
+        /// <param name="dst">The buffer to receive the estimates, which may
+        /// be <c>nullptr</c> for answering how many are available.</param>
+        /// <param name="cnt">The number of elements that
+        /// <paramref name="dst" /> can hold.</param>
+        /// <returns>The number of estimates written to
+        /// <paramref name="dst" />, or the number of estimates available if
+        /// <paramref name="dst" /> is <c>nullptr</c>.</returns>
+        std::size_t get_estimates(_Out_writes_opt_(cnt) power_estimate *dst,
+            _In_ const std::size_t cnt);
+
+        /// <summary>
+        /// Copies the energy attributed to each process to
+        /// <paramref name="dst" />.
+        /// </summary>
+        /// <param name="dst">The buffer to receive the energies, which may be
+        /// <c>nullptr</c> for answering how many are available.</param>
+        /// <param name="cnt">The number of elements that
+        /// <paramref name="dst" /> can hold.</param>
+        /// <returns>The number of energies written to
+        /// <paramref name="dst" />, or the number of energies available if
+        /// <paramref name="dst" /> is <c>nullptr</c>.</returns>
+        std::size_t get_process_energies(
+            _Out_writes_opt_(cnt) process_energy *dst,
+            _In_ const std::size_t cnt) const;
+
         /// <summary>
         /// Loads the name of <see cref="device" /> into
         /// <see cref="device_name" />, the device GUID into
         /// <see cref="device_guid" /> and regenerates the
-        /// <see cref="sensor_name" />.
+        /// <see cref="sensor_name" /> unless this has already been done.
+        /// </summary>
+        /// <remarks>
+        /// The names require several queries to NVML and are therefore not
+        /// retrieved before they are first needed. The method is thread-safe
+        /// and can be retried if it failed before.
+        /// </remarks>
+        /// <exception cref="nvml_exception">If any of the names could not be
+        /// retrieved.</exception>
+        void load_device_name(void) const;
+
+        /// <summary>
+        /// Answer the interval at which the driver updates the power reading,
+        /// which is probed when the method is first called.
         /// </summary>
-        void load_device_name(void);
+        /// <returns>The update interval, or zero if it could not be
+        /// determined.</returns>
+        /// <exception cref="nvml_exception">If the power could not be read.
+        /// </exception>
+        std::chrono::microseconds native_interval(void) const;
 
         /// <summary>
         /// Sample the sensor.
         /// </summary>
+        /// <remarks>
+        /// If supported by the driver, the sensor retrieves all of the
+        /// <see cref="nvml_quantity" /> values in a single call to
+        /// <c>nvmlDeviceGetFieldValues</c> and updates <see cref="values" />.
+        /// Otherwise, only the power is obtained via
+        /// <c>nvmlDeviceGetPowerUsage</c>. In <see cref="energy_mode" />, the
+        /// power returned is the average power since the previous sample,
+        /// which is derived from the energy counter. In
+        /// <see cref="estimation_mode" />, the sample also updates the
+        /// <see cref="model" /> and produces an estimate. If a
+        /// <see cref="governor" /> is active, the sample is fed into its
+        /// <see cref="controller" />. In <see cref="process_energy_mode" />,
+        /// the energy is attributed to the processes using the GPU.
+        /// </remarks>
         /// <param name="resolution">The resolution of the timestamp to be
         /// generated, which defaults to milliseconds.</param>
         /// <returns>A measurement from the sensor.</returns>
         measurement_data sample(const timestamp_resolution resolution
             = timestamp_resolution::milliseconds) const;
+
+        /// <summary>
+        /// Reads the total energy in Joules.
+        /// </summary>
+        /// <param name="from_fields">Indicates whether the energy should be
+        /// taken from <see cref="values" /> if available, because these have
+        /// just been updated.</param>
+        /// <returns>The total energy of the device.</returns>
+        /// <exception cref="nvml_exception">If the energy counter is not
+        /// supported.</exception>
+        double read_energy(_In_ const bool from_fields) const;
+
+        /// <summary>
+        /// Retrieves the current power limit of the device.
+        /// </summary>
+        /// <returns>The power limit in Watts.</returns>
+        /// <exception cref="nvml_exception">If the power limit cannot be
+        /// retrieved.</exception>
+        double power_limit(void) const;
+
+        /// <summary>
+        /// Answer the value of <paramref name="quantity" /> obtained with the
+        /// most recent sample.
+        /// </summary>
+        /// <param name="quantity">The quantity to retrieve.</param>
+        /// <returns>The value, which is NaN if it is not (yet) available.
+        /// </returns>
+        double value(_In_ const nvml_quantity quantity) const;
+
+    private:
+
+        /// <summary>
+        /// Retrieves the utilisation per process and attributes the energy
+        /// since the previous call to the processes.
+        /// </summary>
+        /// <remarks>
+        /// This method issues a single call to
+        /// <c>nvmlDeviceGetProcessUtilization</c>, which is the only query
+        /// the <see cref="process_energy_mode" /> adds to a sample. If the
+        /// buffer is too small, it is grown for the next call and the
+        /// previous shares are retained. Errors must not invalidate the
+        /// measurement, so they are ignored.
+        /// </remarks>
+        /// <param name="power">The average power since the previous call in
+        /// Watts.</param>
+        void attribute(_In_ const double power) const;
+
+        /// <summary>
+        /// Updates the <see cref="model" /> with the activity that has just
+        /// been sampled and estimates the power from it.
+        /// </summary>
+        /// <remarks>
+        /// The driver averages the power over its update period, so the model
+        /// is fitted against the mean of the regressors observed since the
+        /// previous power reading whenever a new one arrives.
+        /// </remarks>
+        /// <param name="sample">The sample the power has been measured with.
+        /// </param>
+        void estimate(_In_ const measurement_data& sample) const;
+
+        /// <summary>
+        /// Feeds the power of a sample into the <see cref="controller" /> and
+        /// applies the next power limit if the control interval has ended.
+        /// </summary>
+        /// <remarks>
+        /// Errors in the control loop must not invalidate the measurement, so
+        /// failures of the driver and exceptions from the performance
+        /// callback are ignored and the current limit is retained.
+        /// </remarks>
+        /// <param name="power">The power of the sample in Watts.</param>
+        void govern(_In_ const double power) const;
+
+        /// <summary>
+        /// Retrieves the utilisation and the clocks, which are not available
+        /// as field values, into <see cref="values" />.
+        /// </summary>
+        /// <exception cref="nvml_exception">If any of the calls failed.
+        /// </exception>
+        void sample_activity(void) const;
+
+        /// <summary>
+        /// Sample the power like <see cref="sample" /> does without producing
+        /// an estimate.
+        /// </summary>
+        measurement_data sample_power(
+            _In_ const timestamp_resolution resolution) const;
+
+        /// <summary>
+        /// Retrieves the energy, the memory temperature and the power in a
+        /// single call to <c>nvmlDeviceGetFieldValues</c> if supported.
+        /// </summary>
+        /// <returns><c>true</c> if <see cref="values" /> have been updated,
+        /// <c>false</c> if the field value API is not supported.</returns>
+        /// <exception cref="nvml_exception">If the call failed.</exception>
+        bool sample_fields(void) const;
     };
 
 } /* namespace detail */
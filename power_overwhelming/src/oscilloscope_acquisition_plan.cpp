@@ -0,0 +1,109 @@
+﻿// <copyright file="oscilloscope_acquisition_plan.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/oscilloscope_acquisition_plan.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <stdexcept>
+
+
+/*
+ * ...::oscilloscope_acquisition_plan::max_points
+ */
+constexpr unsigned int
+visus::power_overwhelming::oscilloscope_acquisition_plan::max_points;
+
+
+/*
+ * ...::oscilloscope_acquisition_plan::max_sample_rate
+ */
+constexpr float
+visus::power_overwhelming::oscilloscope_acquisition_plan::max_sample_rate;
+
+
+/*
+ * ...::oscilloscope_acquisition_plan::min_points
+ */
+constexpr unsigned int
+visus::power_overwhelming::oscilloscope_acquisition_plan::min_points;
+
+
+/*
+ * ...::oscilloscope_acquisition_plan::oscilloscope_acquisition_plan
+ */
+visus::power_overwhelming::oscilloscope_acquisition_plan::oscilloscope_acquisition_plan(
+        _In_ const float duration,
+        _In_ const float sample_rate,
+        _In_ const bool peaks) {
+    // The record lengths the RTB2000 accepts for ACQ:POIN.
+    static const unsigned int lengths[] = {
+        10000, 20000, 50000, 100000, 200000, 500000, 1000000, 2000000,
+        5000000, 10000000, 20000000
+    };
+    // The mantissas of the 1-2-5 sequence of time scales.
+    static const double mantissas[] = { 1.0, 2.0, 5.0 };
+    // The instrument supports time scales from 1 ns to 500 s per division.
+    static const double min_scale = 1e-9;
+    static const double max_scale = 500.0;
+
+    if (!(duration > 0.0f)) {
+        throw std::invalid_argument("The duration of an oscilloscope capture "
+            "must be positive.");
+    }
+    if (!(sample_rate > 0.0f)) {
+        throw std::invalid_argument("The sample rate of an oscilloscope "
+            "capture must be positive.");
+    }
+
+    // Find the smallest time scale covering the requested duration with the
+    // ten divisions of the screen. Note that we compute in double precision
+    // and compare with some tolerance, because the decimal scales are not
+    // exactly representable.
+    const auto requested_scale = (std::max)(duration / 10.0, min_scale);
+    auto scale = max_scale;
+    auto decade = std::pow(10.0, std::floor(std::log10(requested_scale)));
+    for (auto d = 0; d < 2; ++d, decade *= 10.0) {
+        auto found = false;
+        for (auto m : mantissas) {
+            if (m * decade >= requested_scale * (1.0 - 1e-6)) {
+                scale = (std::min)(m * decade, max_scale);
+                found = true;
+                break;
+            }
+        }
+        if (found) {
+            break;
+        }
+    }
+
+    // Choose the shortest record length providing the requested rate, which
+    // is pointless beyond the rate of the converter.
+    const auto range = 10.0 * scale;
+    const auto rate = (std::min)(static_cast<double>(sample_rate),
+        static_cast<double>(max_sample_rate));
+    const auto required = range * rate * (1.0 - 1e-6);
+    auto it = std::find_if(std::begin(lengths), std::end(lengths),
+        [required](const unsigned int l) { return (l >= required); });
+    this->_points = (it != std::end(lengths)) ? *it : max_points;
+
+    const auto effective = (std::min)(this->_points / range,
+        static_cast<double>(max_sample_rate));
+    this->_sample_rate = static_cast<float>(effective);
+    this->_satisfied = (effective >= sample_rate * (1.0 - 1e-6));
+    this->_time_scale = static_cast<float>(scale);
+
+    // If the instrument stores fewer points than the converter produces, it
+    // must decimate, which we want it to do with a filter rather than by
+    // dropping samples, which would cause aliasing.
+    if (this->_points / range < max_sample_rate * (1.0 - 1e-6)) {
+        this->_decimation_mode = peaks
+            ? oscilloscope_decimation_mode::peak_detect
+            : oscilloscope_decimation_mode::high_resolution;
+    } else {
+        this->_decimation_mode = oscilloscope_decimation_mode::sample;
+    }
+}
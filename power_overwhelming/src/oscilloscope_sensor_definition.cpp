@@ -20,8 +20,11 @@ visus::power_overwhelming::oscilloscope_sensor_definition::oscilloscope_sensor_d
     : _attenuation_current(0.0f),
         _attenuation_voltage(0.0f),
         _channel_current(channel_current),
+        _channel_power(0),
         _channel_voltage(channel_voltage),
-        _description(nullptr) {
+        _description(nullptr),
+        _raw_channels(false),
+        _software_trigger(false) {
     if (description == nullptr) {
         throw std::invalid_argument("The description of an oscilloscope-based "
             "sensor must not be null.");
@@ -47,8 +50,11 @@ visus::power_overwhelming::oscilloscope_sensor_definition::oscilloscope_sensor_d
     : _attenuation_current(attenuation_current),
         _attenuation_voltage(attenuation_voltage),
         _channel_current(channel_current),
+        _channel_power(0),
         _channel_voltage(channel_voltage),
-        _description(nullptr) {
+        _description(nullptr),
+        _raw_channels(false),
+        _software_trigger(false) {
     if (description == nullptr) {
         throw std::invalid_argument("The description of an oscilloscope-based "
             "sensor must not be null.");
@@ -96,8 +102,11 @@ visus::power_overwhelming::oscilloscope_sensor_definition::operator =(
         this->_attenuation_current = rhs._attenuation_current;
         this->_attenuation_voltage = rhs._attenuation_voltage;
         this->_channel_current = rhs._channel_current;
+        this->_channel_power = rhs._channel_power;
         this->_channel_voltage = rhs._channel_voltage;
         detail::safe_assign(this->_description, rhs._description);
+        this->_raw_channels = rhs._raw_channels;
+        this->_software_trigger = rhs._software_trigger;
     }
 
     return *this;
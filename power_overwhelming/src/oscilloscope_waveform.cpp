@@ -5,8 +5,11 @@
 
 #include "power_overwhelming/oscilloscope_waveform.h"
 
-#include "string_functions.h"
-#include "tokenise.h"
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include "scpi_response.h"
 
 
 /*
@@ -15,25 +18,37 @@
 visus::power_overwhelming::oscilloscope_waveform::oscilloscope_waveform(
         _In_z_ const char *header, _Inout_ blob&& samples)
         : _record_length(0),  _time_begin(0), _time_end(0) {
+    this->parse_header(header, samples.size());
+    // Do not move samples unless everything else succeeded.
+    this->_samples = std::move(samples);
+}
+
+
+/*
+ * visus::power_overwhelming::oscilloscope_waveform::parse_header
+ */
+void visus::power_overwhelming::oscilloscope_waveform::parse_header(
+        _In_z_ const char *header, _In_ const std::size_t valid) {
     if (header == nullptr) {
         throw std::invalid_argument("The data header must not be nullptr.");
     }
 
-    const auto tokens = detail::tokenise(std::string(header), ",", true);
-    if (tokens.size() < 4) {
-        throw std::invalid_argument("The specified data header does not have "
-            "the expected format.");
+    // The header only consists of numbers, so we parse it in place rather
+    // than splitting it into strings.
+    const auto end = header + ::strlen(header);
+    double values[4];
+    auto cur = header;
+    if (!detail::parse_real_list(cur, end, values, 4)) {
+        throw std::invalid_argument("The specified data header does not "
+            "have the expected format.");
     }
 
-    this->_time_begin = std::stof(tokens[0]);
-    this->_time_end = std::stof(tokens[1]);
-    this->_record_length = std::stoul(tokens[2]);
-
-    if (this->_record_length > samples.size() / sizeof(float)) {
+    if ((values[2] < 0.0) || (values[2] > valid / sizeof(float))) {
         throw std::invalid_argument("The number of samples in the data header "
             "does not match the sample data provided.");
     }
 
-    // Do not move samples unless everything else succeeded.
-    this->_samples = std::move(samples);
+    this->_time_begin = static_cast<float>(values[0]);
+    this->_time_end = static_cast<float>(values[1]);
+    this->_record_length = static_cast<std::size_t>(values[2]);
 }
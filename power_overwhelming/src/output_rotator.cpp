@@ -0,0 +1,192 @@
+﻿// <copyright file="output_rotator.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "output_rotator.h"
+
+#include <cassert>
+#include <exception>
+
+#include "library_thread.h"
+
+
+/*
+ * visus::power_overwhelming::detail::output_rotator::segment_path
+ */
+std::wstring visus::power_overwhelming::detail::output_rotator::segment_path(
+        _In_ const std::wstring& path, _In_ const std::size_t index) {
+    if (index == 0) {
+        return path;
+    }
+
+    auto number = std::to_wstring(index);
+    if (number.size() < 4) {
+        number.insert(0, 4 - number.size(), L'0');
+    }
+
+    // Only a dot in the file name starts the extension, and a leading dot
+    // marks a hidden file rather than an extension.
+    const auto separator = path.find_last_of(L"/\\");
+    const auto name = (separator == std::wstring::npos) ? 0 : separator + 1;
+    const auto dot = path.rfind(L'.');
+    if ((dot == std::wstring::npos) || (dot <= name)) {
+        return path + L"." + number;
+    }
+
+    auto retval = path;
+    retval.insert(dot, L"." + number);
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::output_rotator::output_rotator
+ */
+visus::power_overwhelming::detail::output_rotator::output_rotator(void)
+    : _base(0), _busy(false), _failures(0), _index(0), _interval(0),
+        _running(false), _size(0) { }
+
+
+/*
+ * visus::power_overwhelming::detail::output_rotator::~output_rotator
+ */
+visus::power_overwhelming::detail::output_rotator::~output_rotator(void) {
+    {
+        std::lock_guard<decltype(this->_lock)> l(this->_lock);
+        this->_running = false;
+    }
+    this->_signal.notify_all();
+
+    // The thread only exits once it has emptied the queue, so no segment is
+    // left unfinished.
+    if (this->_thread.joinable()) {
+        this->_thread.join();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::output_rotator::advance
+ */
+void visus::power_overwhelming::detail::output_rotator::advance(
+        _In_ const clock_type::time_point now) noexcept {
+    ++this->_index;
+    this->_base = 0;
+    this->_deadline = now + this->_interval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::output_rotator::configure
+ */
+void visus::power_overwhelming::detail::output_rotator::configure(
+        _In_ const std::wstring& path,
+        _In_ const std::uint64_t size,
+        _In_ const std::chrono::microseconds interval,
+        _In_ const clock_type::time_point now) {
+    this->_base = 0;
+    this->_deadline = now + interval;
+    this->_failures.store(0, std::memory_order_relaxed);
+    this->_index = 0;
+    this->_interval = interval;
+    this->_path = path;
+    this->_size = size;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::output_rotator::defer
+ */
+void visus::power_overwhelming::detail::output_rotator::defer(
+        _In_ const std::uint64_t written,
+        _In_ const clock_type::time_point now) noexcept {
+    this->_base = written;
+    this->_deadline = now + this->_interval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::output_rotator::due
+ */
+bool visus::power_overwhelming::detail::output_rotator::due(
+        _In_ const std::uint64_t written,
+        _In_ const clock_type::time_point now) const noexcept {
+    if ((this->_size > 0) && (written >= this->_base)
+            && (written - this->_base >= this->_size)) {
+        return true;
+    }
+
+    return ((this->_interval.count() > 0) && (now >= this->_deadline));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::output_rotator::post
+ */
+void visus::power_overwhelming::detail::output_rotator::post(
+        _In_ task_type&& task) {
+    {
+        std::lock_guard<decltype(this->_lock)> l(this->_lock);
+        this->_tasks.push_back(std::move(task));
+
+        if (!this->_running) {
+            // A previous thread can only have exited on destruction, so
+            // there is nothing to join if we are not running.
+            assert(!this->_thread.joinable());
+            this->_running = true;
+            this->_thread = std::thread(&output_rotator::run, this);
+        }
+    }
+
+    this->_signal.notify_all();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::output_rotator::wait
+ */
+void visus::power_overwhelming::detail::output_rotator::wait(void) {
+    std::unique_lock<decltype(this->_lock)> l(this->_lock);
+    this->_signal.wait(l, [this](void) {
+        return (this->_tasks.empty() && !this->_busy);
+    });
+}
+
+
+/*
+ * visus::power_overwhelming::detail::output_rotator::run
+ */
+void visus::power_overwhelming::detail::output_rotator::run(void) {
+    enter_library_thread("PwrOwg Output Finaliser Thread");
+
+    std::unique_lock<decltype(this->_lock)> l(this->_lock);
+    while (true) {
+        this->_signal.wait(l, [this](void) {
+            return (!this->_tasks.empty() || !this->_running);
+        });
+
+        if (this->_tasks.empty()) {
+            assert(!this->_running);
+            break;
+        }
+
+        auto task = std::move(this->_tasks.front());
+        this->_tasks.pop_front();
+        this->_busy = true;
+        l.unlock();
+
+        // The task is destroyed outside the lock, too, because this releases
+        // the writer it owns.
+        try {
+            task();
+        } catch (...) {
+            this->_failures.fetch_add(1, std::memory_order_relaxed);
+        }
+        task = nullptr;
+
+        l.lock();
+        this->_busy = false;
+        this->_signal.notify_all();
+    }
+}
@@ -0,0 +1,222 @@
+﻿// <copyright file="output_rotator.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Decides when the output of a collector is continued in a new segment
+    /// and finalises the segments that have been replaced on a background
+    /// thread.
+    /// </summary>
+    /// <remarks>
+    /// <para>A segment is replaced once the data written to it reach the
+    /// configured size or once it has been open for the configured interval,
+    /// whichever comes first. The first segment is written to the configured
+    /// path, the following ones to the paths created by
+    /// <see cref="segment_path" />.</para>
+    /// <para>Closing a segment writes the pending data, the index and the
+    /// footer, and it waits for asynchronous writes to complete. The rotator
+    /// therefore takes ownership of the replaced writer and closes it on its
+    /// own thread, such that the thread writing the samples continues in the
+    /// new segment immediately.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API output_rotator final {
+
+    public:
+
+        /// <summary>
+        /// The clock measuring the time a segment has been open.
+        /// </summary>
+        typedef std::chrono::steady_clock clock_type;
+
+        /// <summary>
+        /// The type of a task run on the finalisation thread.
+        /// </summary>
+        typedef std::function<void(void)> task_type;
+
+        /// <summary>
+        /// Answer the path of the segment with the given index.
+        /// </summary>
+        /// <remarks>
+        /// The index is inserted as a four-digit number before the extension
+        /// of the file, such that the segments sort in the order they have
+        /// been written and keep the extension identifying their format. The
+        /// first segment with index zero uses the path as it is.
+        /// </remarks>
+        /// <param name="path">The path configured for the output.</param>
+        /// <param name="index">The zero-based index of the segment.</param>
+        /// <returns>The path to the segment.</returns>
+        static std::wstring segment_path(_In_ const std::wstring& path,
+            _In_ const std::size_t index);
+
+        /// <summary>
+        /// Initialises a new instance, which does not rotate the output.
+        /// </summary>
+        output_rotator(void);
+
+        output_rotator(const output_rotator&) = delete;
+
+        /// <summary>
+        /// Finalises the instance after all pending segments have been
+        /// closed.
+        /// </summary>
+        ~output_rotator(void);
+
+        /// <summary>
+        /// Advances to the segment at <see cref="next_path" />, which has
+        /// been opened at <paramref name="now" />.
+        /// </summary>
+        /// <param name="now">The current time.</param>
+        void advance(_In_ const clock_type::time_point now) noexcept;
+
+        /// <summary>
+        /// Configures the rotation of the output at <paramref name="path" />,
+        /// which is assumed to have been opened at <paramref name="now" />.
+        /// </summary>
+        /// <param name="path">The path to the first segment.</param>
+        /// <param name="size">The number of bytes after which a segment is
+        /// replaced, or zero for no limit.</param>
+        /// <param name="interval">The time after which a segment is replaced,
+        /// or zero for no limit.</param>
+        /// <param name="now">The time when the first segment was opened.
+        /// </param>
+        void configure(_In_ const std::wstring& path,
+            _In_ const std::uint64_t size,
+            _In_ const std::chrono::microseconds interval,
+            _In_ const clock_type::time_point now);
+
+        /// <summary>
+        /// Postpones the rotation of the current segment by another size and
+        /// interval, because its successor could not be opened.
+        /// </summary>
+        /// <param name="written">The number of bytes written to the current
+        /// segment so far.</param>
+        /// <param name="now">The current time.</param>
+        void defer(_In_ const std::uint64_t written,
+            _In_ const clock_type::time_point now) noexcept;
+
+        /// <summary>
+        /// Answer whether the current segment must be replaced.
+        /// </summary>
+        /// <param name="written">The number of bytes written to the current
+        /// segment so far.</param>
+        /// <param name="now">The current time.</param>
+        /// <returns><c>true</c> if the segment has reached its size or age,
+        /// <c>false</c> otherwise.</returns>
+        bool due(_In_ const std::uint64_t written,
+            _In_ const clock_type::time_point now) const noexcept;
+
+        /// <summary>
+        /// Answer whether the output is rotated at all.
+        /// </summary>
+        /// <returns><c>true</c> if a size or an interval has been configured,
+        /// <c>false</c> otherwise.</returns>
+        inline bool enabled(void) const noexcept {
+            return ((this->_size > 0) || (this->_interval.count() > 0));
+        }
+
+        /// <summary>
+        /// Answer the number of segments that could not be finalised.
+        /// </summary>
+        /// <remarks>
+        /// This method can be called from any thread.
+        /// </remarks>
+        /// <returns>The number of tasks that threw.</returns>
+        inline std::size_t failures(void) const noexcept {
+            return this->_failures.load(std::memory_order_relaxed);
+        }
+
+        /// <summary>
+        /// Takes ownership of a replaced writer and closes it on the
+        /// finalisation thread.
+        /// </summary>
+        /// <typeparam name="TWriter">The type of the writer, which must have
+        /// a <c>close</c> method.</typeparam>
+        /// <param name="writer">The writer to be closed. The pointer will be
+        /// empty when the method returns.</param>
+        template<class TWriter>
+        void finalise(_Inout_ std::unique_ptr<TWriter>&& writer) {
+            // The task must be copyable, so it shares the writer, which is
+            // destroyed once the task has run.
+            std::shared_ptr<TWriter> w(std::move(writer));
+            if (w != nullptr) {
+                this->post([w](void) { w->close(); });
+            }
+        }
+
+        /// <summary>
+        /// Answer the path of the segment following the current one.
+        /// </summary>
+        /// <returns>The path to the next segment.</returns>
+        inline std::wstring next_path(void) const {
+            return segment_path(this->_path, this->_index + 1);
+        }
+
+        /// <summary>
+        /// Queues a task for the finalisation thread, which is started on
+        /// first use.
+        /// </summary>
+        /// <param name="task">The task to be run.</param>
+        void post(_In_ task_type&& task);
+
+        /// <summary>
+        /// Answer the number of segments written so far, including the
+        /// current one.
+        /// </summary>
+        /// <returns>The number of segments.</returns>
+        inline std::size_t segments(void) const noexcept {
+            return (this->_index + 1);
+        }
+
+        /// <summary>
+        /// Blocks the calling thread until all queued tasks have run.
+        /// </summary>
+        void wait(void);
+
+        output_rotator& operator =(const output_rotator&) = delete;
+
+    private:
+
+        /// <summary>
+        /// The entry point of the finalisation thread.
+        /// </summary>
+        void run(void);
+
+        std::uint64_t _base;
+        bool _busy;
+        clock_type::time_point _deadline;
+        std::atomic<std::size_t> _failures;
+        std::size_t _index;
+        std::chrono::microseconds _interval;
+        std::mutex _lock;
+        std::wstring _path;
+        bool _running;
+        std::condition_variable _signal;
+        std::uint64_t _size;
+        std::deque<task_type> _tasks;
+        std::thread _thread;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,121 @@
+﻿// <copyright file="overhead_estimator.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "overhead_estimator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "power_overwhelming/library_threads.h"
+
+#include "library_thread.h"
+#include "sensor_name_registry.h"
+
+
+/*
+ * visus::power_overwhelming::detail::overhead_estimator::sensor_name
+ */
+constexpr const wchar_t *
+visus::power_overwhelming::detail::overhead_estimator::sensor_name;
+
+
+/*
+ * visus::power_overwhelming::detail::overhead_estimator::attribute
+ */
+visus::power_overwhelming::measurement::value_type
+visus::power_overwhelming::detail::overhead_estimator::attribute(
+        _In_ const measurement::value_type package_power,
+        _In_ const std::uint64_t library_time,
+        _In_ const std::uint64_t busy_time) noexcept {
+    if (busy_time == 0) {
+        return 0.0f;
+    }
+
+    // The times are sampled at different instants and with different
+    // resolutions, so the library might seem to be busier than the system.
+    const auto share = (std::min)(1.0, static_cast<double>(library_time)
+        / static_cast<double>(busy_time));
+    return static_cast<measurement::value_type>(share * package_power);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::overhead_estimator::overhead_estimator
+ */
+visus::power_overwhelming::detail::overhead_estimator::overhead_estimator(
+        void) : _busy_time(0), _library_time(0) { }
+
+
+/*
+ * visus::power_overwhelming::detail::overhead_estimator::add_package
+ */
+void visus::power_overwhelming::detail::overhead_estimator::add_package(
+        _In_z_ const wchar_t *sensor) {
+    assert(sensor != nullptr);
+    this->_packages[sensor_name_registry::intern(sensor)];
+}
+
+
+/*
+ * visus::power_overwhelming::detail::overhead_estimator::push
+ */
+void visus::power_overwhelming::detail::overhead_estimator::push(
+        _In_ const measurement& sample) noexcept {
+    // The names of measurements are interned, so we can compare pointers.
+    auto it = this->_packages.find(sample.sensor());
+    if ((it != this->_packages.end()) && std::isfinite(sample.power())) {
+        ++it->second.count;
+        it->second.sum += sample.power();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::overhead_estimator::reset
+ */
+void visus::power_overwhelming::detail::overhead_estimator::reset(void) {
+    this->_packages.clear();
+    this->_busy_time = get_system_busy_time();
+    this->_library_time = get_library_cpu_time();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::overhead_estimator::sample
+ */
+bool visus::power_overwhelming::detail::overhead_estimator::sample(
+        _Out_ measurement::value_type& out_power) {
+    const auto busy_time = get_system_busy_time();
+    const auto library_time = get_library_cpu_time();
+    auto have_power = false;
+    double power = 0.0;
+
+    // Each package contributes its average power over the period.
+    for (auto& p : this->_packages) {
+        if (p.second.count > 0) {
+            power += p.second.sum / p.second.count;
+            have_power = true;
+        }
+
+        p.second = package_power();
+    }
+
+    const auto busy = (busy_time > this->_busy_time)
+        ? busy_time - this->_busy_time
+        : 0;
+    const auto library = (library_time > this->_library_time)
+        ? library_time - this->_library_time
+        : 0;
+    this->_busy_time = busy_time;
+    this->_library_time = library_time;
+
+    if (have_power) {
+        out_power = attribute(static_cast<measurement::value_type>(power),
+            library, busy);
+    }
+
+    return have_power;
+}
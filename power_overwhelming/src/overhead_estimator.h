@@ -0,0 +1,119 @@
+﻿// <copyright file="overhead_estimator.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <unordered_map>
+
+#include "power_overwhelming/measurement.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Estimates the power that the threads of the library draw from the CPU
+    /// packages.
+    /// </summary>
+    /// <remarks>
+    /// <para>The estimator averages the power of the CPU packages over the
+    /// samples it is given and attributes the share of it that corresponds
+    /// to the share of the library threads in the busy time of all logical
+    /// CPUs. This is only an approximation, because neither the cores nor
+    /// the code running on them draw the same power, but it allows for
+    /// subtracting a known overhead when measuring small workloads.</para>
+    /// <para>The estimator is not thread-safe.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API overhead_estimator final {
+
+    public:
+
+        /// <summary>
+        /// The name of the virtual sensor reporting the overhead.
+        /// </summary>
+        static constexpr const wchar_t *sensor_name = L"PwrOwg/overhead";
+
+        /// <summary>
+        /// Computes the power attributed to the library.
+        /// </summary>
+        /// <param name="package_power">The power of all CPU packages.</param>
+        /// <param name="library_time">The CPU time of the library threads in
+        /// the period of interest.</param>
+        /// <param name="busy_time">The busy time of all logical CPUs in the
+        /// period of interest.</param>
+        /// <returns>The share of <paramref name="package_power" /> that is
+        /// attributed to the library, which is zero if the system has not
+        /// been busy.</returns>
+        static measurement::value_type attribute(
+            _In_ const measurement::value_type package_power,
+            _In_ const std::uint64_t library_time,
+            _In_ const std::uint64_t busy_time) noexcept;
+
+        /// <summary>
+        /// Initialises a new instance without any package.
+        /// </summary>
+        overhead_estimator(void);
+
+        /// <summary>
+        /// Registers a sensor measuring the power of a CPU package.
+        /// </summary>
+        /// <param name="sensor">The interned name of the sensor as it is used
+        /// in its measurements.</param>
+        void add_package(_In_z_ const wchar_t *sensor);
+
+        /// <summary>
+        /// Answer whether any package has been registered.
+        /// </summary>
+        /// <returns><c>true</c> if there is a package, <c>false</c>
+        /// otherwise.</returns>
+        inline bool has_packages(void) const noexcept {
+            return !this->_packages.empty();
+        }
+
+        /// <summary>
+        /// Accumulates the power of the given sample if it stems from a
+        /// registered package.
+        /// </summary>
+        /// <param name="sample">The sample to be checked.</param>
+        void push(_In_ const measurement& sample) noexcept;
+
+        /// <summary>
+        /// Removes all packages and establishes a new baseline for the CPU
+        /// times.
+        /// </summary>
+        void reset(void);
+
+        /// <summary>
+        /// Estimates the overhead since the previous call or the last
+        /// <see cref="reset" /> and starts a new period.
+        /// </summary>
+        /// <param name="out_power">Receives the power attributed to the
+        /// library if the method succeeds.</param>
+        /// <returns><c>true</c> if the packages have been sampled during the
+        /// period, <c>false</c> if there is nothing to estimate.</returns>
+        bool sample(_Out_ measurement::value_type& out_power);
+
+    private:
+
+        /// <summary>
+        /// The power of a package accumulated over a period.
+        /// </summary>
+        struct package_power {
+            std::size_t count;
+            double sum;
+
+            inline package_power(void) : count(0), sum(0.0) { }
+        };
+
+        std::uint64_t _busy_time;
+        std::uint64_t _library_time;
+        std::unordered_map<const wchar_t *, package_power> _packages;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
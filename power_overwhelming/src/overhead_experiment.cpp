@@ -0,0 +1,197 @@
+﻿// <copyright file="overhead_experiment.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "overhead_experiment.h"
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "power_overwhelming/library_threads.h"
+
+
+/*
+ * ...::detail::overhead_experiment::overhead_experiment
+ */
+visus::power_overwhelming::detail::overhead_experiment::overhead_experiment(
+        void)
+    : _begin(0), _cpu_time(0), _progress(0), _progress_begin(0),
+        _running(false), _sampling(false), _ticks_per_second(1.0) { }
+
+
+/*
+ * visus::power_overwhelming::detail::overhead_experiment::begin
+ */
+void visus::power_overwhelming::detail::overhead_experiment::begin(
+        _In_ const timestamp_type timestamp,
+        _In_ const double ticks_per_second) {
+    this->_ticks_per_second = ticks_per_second;
+    this->_windows.clear();
+    this->_sampling = true;
+    this->_running = true;
+    this->open(timestamp);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::overhead_experiment::end
+ */
+void visus::power_overwhelming::detail::overhead_experiment::end(
+        _In_ const timestamp_type timestamp) {
+    if (this->_running) {
+        this->close(timestamp);
+        this->_running = false;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::overhead_experiment::summary
+ */
+visus::power_overwhelming::detail::overhead_summary
+visus::power_overwhelming::detail::overhead_experiment::summary(
+        void) const {
+    static constexpr auto nan = std::numeric_limits<double>::quiet_NaN();
+    overhead_summary retval { };
+
+    // Welford's algorithm for the mean and the variance of the rates.
+    double m2_reference = 0.0;
+    double m2_sampling = 0.0;
+    for (auto& w : this->_windows) {
+        if (w.duration <= 0.0) {
+            continue;
+        }
+
+        const auto rate = w.progress / w.duration;
+        auto& cnt = w.sampling ? retval.windows_sampling
+            : retval.windows_reference;
+        auto& mean = w.sampling ? retval.rate_sampling
+            : retval.rate_reference;
+        auto& m2 = w.sampling ? m2_sampling : m2_reference;
+
+        ++cnt;
+        const auto delta = rate - mean;
+        mean += delta / cnt;
+        m2 += delta * (rate - mean);
+    }
+
+    retval.stddev_reference = (retval.windows_reference > 1)
+        ? std::sqrt(m2_reference / (retval.windows_reference - 1))
+        : nan;
+    retval.stddev_sampling = (retval.windows_sampling > 1)
+        ? std::sqrt(m2_sampling / (retval.windows_sampling - 1))
+        : nan;
+
+    if ((retval.windows_reference > 0) && (retval.windows_sampling > 0)
+            && (retval.rate_reference > 0.0)) {
+        const auto ratio = retval.rate_sampling / retval.rate_reference;
+        retval.overhead = 1.0 - ratio;
+
+        // The variance of the ratio of the means is propagated to first
+        // order from the standard errors of both means.
+        const auto rel_sampling = (retval.rate_sampling > 0.0)
+            ? retval.stddev_sampling / retval.rate_sampling
+            : 0.0;
+        const auto rel_reference = retval.stddev_reference
+            / retval.rate_reference;
+        retval.overhead_error = 1.96 * std::abs(ratio) * std::sqrt(
+            rel_sampling * rel_sampling / retval.windows_sampling
+            + rel_reference * rel_reference / retval.windows_reference);
+
+    } else {
+        retval.overhead = nan;
+        retval.overhead_error = nan;
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::overhead_experiment::toggle
+ */
+bool visus::power_overwhelming::detail::overhead_experiment::toggle(
+        _In_ const timestamp_type timestamp) {
+    if (!this->_running) {
+        throw std::logic_error("The overhead experiment is not running.");
+    }
+
+    this->close(timestamp);
+    this->_sampling = !this->_sampling;
+    this->open(timestamp);
+
+    return this->_sampling;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::overhead_experiment::close
+ */
+void visus::power_overwhelming::detail::overhead_experiment::close(
+        _In_ const timestamp_type timestamp) {
+    overhead_window window;
+    window.begin = this->_begin;
+    window.cpu_time = get_library_cpu_time() - this->_cpu_time;
+    window.duration = static_cast<double>(timestamp - this->_begin)
+        / this->_ticks_per_second;
+    window.end = timestamp;
+    window.progress = this->_progress.load(std::memory_order_relaxed)
+        - this->_progress_begin;
+    window.sampling = this->_sampling;
+    this->_windows.push_back(window);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::overhead_experiment::open
+ */
+void visus::power_overwhelming::detail::overhead_experiment::open(
+        _In_ const timestamp_type timestamp) {
+    this->_begin = timestamp;
+    this->_cpu_time = get_library_cpu_time();
+    this->_progress_begin = this->_progress.load(std::memory_order_relaxed);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::write_overhead_experiment
+ */
+std::ostream& visus::power_overwhelming::detail::write_overhead_experiment(
+        _Inout_ std::ostream& stream,
+        _In_ const overhead_experiment& experiment) {
+    const auto precision = stream.precision(
+        std::numeric_limits<double>::max_digits10);
+
+    stream << "window,sampling,begin,end,duration,progress,rate,cpu_time\n";
+    std::size_t i = 0;
+    for (auto& w : experiment.windows()) {
+        stream << i++
+            << ',' << (w.sampling ? "true" : "false")
+            << ',' << w.begin
+            << ',' << w.end
+            << ',' << w.duration
+            << ',' << w.progress
+            << ',' << ((w.duration > 0.0) ? w.progress / w.duration : 0.0)
+            << ',' << w.cpu_time
+            << '\n';
+    }
+
+    const auto summary = experiment.summary();
+    stream << "\noverhead,overhead_error,"
+        << "rate_sampling,stddev_sampling,windows_sampling,"
+        << "rate_reference,stddev_reference,windows_reference\n"
+        << summary.overhead
+        << ',' << summary.overhead_error
+        << ',' << summary.rate_sampling
+        << ',' << summary.stddev_sampling
+        << ',' << summary.windows_sampling
+        << ',' << summary.rate_reference
+        << ',' << summary.stddev_reference
+        << ',' << summary.windows_reference
+        << '\n';
+
+    stream.precision(precision);
+    return stream;
+}
@@ -0,0 +1,251 @@
+﻿// <copyright file="overhead_experiment.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <cinttypes>
+#include <ostream>
+#include <vector>
+
+#include "power_overwhelming/measurement.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A single window of an <see cref="overhead_experiment" />.
+    /// </summary>
+    struct POWER_OVERWHELMING_API overhead_window final {
+
+        /// <summary>
+        /// The time when the window began.
+        /// </summary>
+        measurement::timestamp_type begin;
+
+        /// <summary>
+        /// The CPU time of the threads of the library in the window in
+        /// nanoseconds.
+        /// </summary>
+        std::uint64_t cpu_time;
+
+        /// <summary>
+        /// The length of the window in seconds.
+        /// </summary>
+        double duration;
+
+        /// <summary>
+        /// The time when the window ended.
+        /// </summary>
+        measurement::timestamp_type end;
+
+        /// <summary>
+        /// The progress the workload has reported in the window.
+        /// </summary>
+        std::uint64_t progress;
+
+        /// <summary>
+        /// Indicates whether the sensors were sampled at the full rate in the
+        /// window, or whether it was a reference window.
+        /// </summary>
+        bool sampling;
+    };
+
+
+    /// <summary>
+    /// The statistical comparison of the sampling and the reference windows
+    /// of an <see cref="overhead_experiment" />.
+    /// </summary>
+    struct POWER_OVERWHELMING_API overhead_summary final {
+
+        /// <summary>
+        /// The relative slowdown of the workload while sampling, which is one
+        /// minus the ratio of the mean progress rates.
+        /// </summary>
+        double overhead;
+
+        /// <summary>
+        /// The half width of the 95% confidence interval of
+        /// <see cref="overhead" />, which is not a number unless there are
+        /// at least two windows of each kind.
+        /// </summary>
+        double overhead_error;
+
+        /// <summary>
+        /// The mean progress per second in the reference windows.
+        /// </summary>
+        double rate_reference;
+
+        /// <summary>
+        /// The mean progress per second in the sampling windows.
+        /// </summary>
+        double rate_sampling;
+
+        /// <summary>
+        /// The sample standard deviation of the progress per second in the
+        /// reference windows.
+        /// </summary>
+        double stddev_reference;
+
+        /// <summary>
+        /// The sample standard deviation of the progress per second in the
+        /// sampling windows.
+        /// </summary>
+        double stddev_sampling;
+
+        /// <summary>
+        /// The number of reference windows.
+        /// </summary>
+        std::size_t windows_reference;
+
+        /// <summary>
+        /// The number of sampling windows.
+        /// </summary>
+        std::size_t windows_sampling;
+    };
+
+
+    /// <summary>
+    /// Records the progress of a workload in alternating windows with and
+    /// without sampling, which allows for quantifying how much the
+    /// measurement perturbs the workload from a single run.
+    /// </summary>
+    /// <remarks>
+    /// <para>The workload reports its progress in arbitrary units, for
+    /// instance frames or iterations, via <see cref="progress" />, which is
+    /// lock-free and can be called from any thread. All other methods must
+    /// be serialised by the caller.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API overhead_experiment final {
+
+    public:
+
+        /// <summary>
+        /// The type of timestamps.
+        /// </summary>
+        typedef measurement::timestamp_type timestamp_type;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        overhead_experiment(void);
+
+        overhead_experiment(const overhead_experiment&) = delete;
+
+        /// <summary>
+        /// Discards all windows and begins a new experiment with a sampling
+        /// window.
+        /// </summary>
+        /// <param name="timestamp">The time when the experiment begins.
+        /// </param>
+        /// <param name="ticks_per_second">The number of ticks of
+        /// <paramref name="timestamp" /> per second.</param>
+        void begin(_In_ const timestamp_type timestamp,
+            _In_ const double ticks_per_second);
+
+        /// <summary>
+        /// Closes the current window.
+        /// </summary>
+        /// <remarks>
+        /// It is safe to call this method if the experiment is not running.
+        /// </remarks>
+        /// <param name="timestamp">The time when the experiment ends.</param>
+        void end(_In_ const timestamp_type timestamp);
+
+        /// <summary>
+        /// Records progress of the workload.
+        /// </summary>
+        /// <param name="units">The progress since the last call.</param>
+        inline void progress(_In_ const std::uint64_t units) noexcept {
+            this->_progress.fetch_add(units, std::memory_order_relaxed);
+        }
+
+        /// <summary>
+        /// Answer whether the experiment is running.
+        /// </summary>
+        /// <returns><c>true</c> between <see cref="begin" /> and
+        /// <see cref="end" />, <c>false</c> otherwise.</returns>
+        inline bool running(void) const noexcept {
+            return this->_running;
+        }
+
+        /// <summary>
+        /// Answer whether the current window is a sampling window.
+        /// </summary>
+        /// <returns><c>true</c> if the sensors are sampled at the full rate,
+        /// <c>false</c> in a reference window.</returns>
+        inline bool sampling(void) const noexcept {
+            return this->_sampling;
+        }
+
+        /// <summary>
+        /// Compares the progress rates in the sampling and the reference
+        /// windows.
+        /// </summary>
+        /// <remarks>
+        /// Windows of zero length are ignored.
+        /// </remarks>
+        /// <returns>The summary of the experiment.</returns>
+        overhead_summary summary(void) const;
+
+        /// <summary>
+        /// Closes the current window and begins a window of the other kind.
+        /// </summary>
+        /// <param name="timestamp">The time of the switch.</param>
+        /// <returns><c>true</c> if the new window is a sampling window,
+        /// <c>false</c> if it is a reference window.</returns>
+        /// <exception cref="std::logic_error">If the experiment is not
+        /// running.</exception>
+        bool toggle(_In_ const timestamp_type timestamp);
+
+        /// <summary>
+        /// Answer the completed windows.
+        /// </summary>
+        /// <returns>The windows in the order they have been recorded.
+        /// </returns>
+        inline const std::vector<overhead_window>& windows(
+                void) const noexcept {
+            return this->_windows;
+        }
+
+        overhead_experiment& operator =(const overhead_experiment&) = delete;
+
+    private:
+
+        void close(_In_ const timestamp_type timestamp);
+
+        void open(_In_ const timestamp_type timestamp);
+
+        timestamp_type _begin;
+        std::uint64_t _cpu_time;
+        std::atomic<std::uint64_t> _progress;
+        std::uint64_t _progress_begin;
+        bool _running;
+        bool _sampling;
+        double _ticks_per_second;
+        std::vector<overhead_window> _windows;
+    };
+
+
+    /// <summary>
+    /// Writes the windows and the summary of an experiment as CSV.
+    /// </summary>
+    /// <remarks>
+    /// The windows are written as a table with one row per window, followed
+    /// by an empty line and a table with a single row holding the
+    /// <see cref="overhead_summary" />.
+    /// </remarks>
+    /// <param name="stream">The stream to write to.</param>
+    /// <param name="experiment">The experiment to be written.</param>
+    /// <returns><paramref name="stream" />.</returns>
+    extern POWER_OVERWHELMING_API std::ostream& write_overhead_experiment(
+        _Inout_ std::ostream& stream,
+        _In_ const overhead_experiment& experiment);
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,118 @@
+﻿// <copyright file="parse_real.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "parse_real.h"
+
+#include <cinttypes>
+#include <cmath>
+#include <limits>
+
+
+/*
+ * visus::power_overwhelming::detail::parse_real
+ */
+bool visus::power_overwhelming::detail::parse_real(
+        _Inout_ const char *& cur,
+        _In_ const char *end,
+        _Out_ double& value) noexcept {
+    // Beyond that many digits, the mantissa would overflow, and the digits do
+    // not contribute to the precision of a double anyway.
+    static constexpr int max_digits = 19;
+    // The value that SCPI instruments report for invalid measurements.
+    static constexpr double scpi_nan = 9.91e37;
+
+    auto c = cur;
+    std::int32_t exponent = 0;
+    std::uint64_t mantissa = 0;
+    auto negative = false;
+    auto significant = 0;
+    auto have_digits = false;
+
+    while ((c < end) && ((*c == ' ') || (*c == '\t'))) {
+        ++c;
+    }
+
+    if ((c < end) && ((*c == '+') || (*c == '-'))) {
+        negative = (*c == '-');
+        ++c;
+    }
+
+    // Integral part.
+    for (; (c < end) && (*c >= '0') && (*c <= '9'); ++c) {
+        have_digits = true;
+        if (significant < max_digits) {
+            mantissa = 10 * mantissa + (*c - '0');
+            if (mantissa > 0) {
+                ++significant;
+            }
+        } else {
+            ++exponent;
+        }
+    }
+
+    // Fractional part.
+    if ((c < end) && (*c == '.')) {
+        ++c;
+        for (; (c < end) && (*c >= '0') && (*c <= '9'); ++c) {
+            have_digits = true;
+            if (significant < max_digits) {
+                mantissa = 10 * mantissa + (*c - '0');
+                --exponent;
+                if (mantissa > 0) {
+                    ++significant;
+                }
+            }
+        }
+    }
+
+    if (!have_digits) {
+        return false;
+    }
+
+    // Exponent, which is only consumed if it is complete.
+    if ((c < end) && ((*c == 'e') || (*c == 'E'))) {
+        auto e = c + 1;
+        auto negative_exponent = false;
+        std::int32_t explicit_exponent = 0;
+
+        if ((e < end) && ((*e == '+') || (*e == '-'))) {
+            negative_exponent = (*e == '-');
+            ++e;
+        }
+
+        if ((e < end) && (*e >= '0') && (*e <= '9')) {
+            for (; (e < end) && (*e >= '0') && (*e <= '9'); ++e) {
+                if (explicit_exponent < 10000) {
+                    explicit_exponent = 10 * explicit_exponent + (*e - '0');
+                }
+            }
+
+            exponent += negative_exponent
+                ? -explicit_exponent
+                : explicit_exponent;
+            c = e;
+        }
+    }
+
+    // Note: Powers of ten are exact up to 1e22, so dividing by the power
+    // rather than multiplying by its inverse gives the correctly rounded
+    // result for all the numbers that instruments typically send.
+    auto v = static_cast<double>(mantissa);
+    if (exponent < 0) {
+        v /= std::pow(10.0, -exponent);
+    } else if (exponent > 0) {
+        v *= std::pow(10.0, exponent);
+    }
+
+    // Note: The instrument might not send exactly the canonical form of the
+    // invalid value, so we allow for rounding errors.
+    if (std::abs(v - scpi_nan) < 1e-6 * scpi_nan) {
+        v = std::numeric_limits<double>::quiet_NaN();
+    }
+
+    value = negative ? -v : v;
+    cur = c;
+    return true;
+}
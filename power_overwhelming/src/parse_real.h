@@ -0,0 +1,41 @@
+﻿// <copyright file="parse_real.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Parses a decimal floating-point number in the range
+    /// [<paramref name="cur" />, <paramref name="end" />[.
+    /// </summary>
+    /// <remarks>
+    /// <para>In contrast to <c>atof</c> and <c>strtod</c>, the input does not
+    /// need to be null-terminated, which allows for parsing responses of
+    /// instruments directly from the buffer they have been received in, and
+    /// the result does not depend on the locale.</para>
+    /// <para>Leading spaces and tabs are skipped. The number may have a sign,
+    /// a fractional part and an exponent. Other than that, only the special
+    /// SCPI value 9.91E37, which marks an invalid measurement, is recognised
+    /// and returned as NaN.</para>
+    /// </remarks>
+    /// <param name="cur">The begin of the range to be parsed. If the method
+    /// succeeds, this pointer is moved past the last character of the number.
+    /// Otherwise, it remains unchanged.</param>
+    /// <param name="end">The end of the range to be parsed.</param>
+    /// <param name="value">Receives the parsed value.</param>
+    /// <returns><c>true</c> if a number has been parsed, <c>false</c>
+    /// otherwise.</returns>
+    bool POWER_OVERWHELMING_API parse_real(_Inout_ const char *& cur,
+        _In_ const char *end, _Out_ double& value) noexcept;
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
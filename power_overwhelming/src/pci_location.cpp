@@ -0,0 +1,102 @@
+﻿// <copyright file="pci_location.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pci_location.h"
+
+#include <cstdio>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <winternl.h>
+#include <d3dkmthk.h>
+
+#pragma comment(lib, "gdi32.lib")
+#endif /* defined(_WIN32) */
+
+
+/*
+ * visus::power_overwhelming::detail::get_pci_location
+ */
+visus::power_overwhelming::detail::pci_location
+visus::power_overwhelming::detail::get_pci_location(
+        _In_ const std::uint64_t luid) {
+#if defined(_WIN32)
+    D3DKMT_OPENADAPTERFROMLUID open;
+    ::ZeroMemory(&open, sizeof(open));
+    open.AdapterLuid.LowPart = static_cast<DWORD>(luid);
+    open.AdapterLuid.HighPart = static_cast<LONG>(luid >> 32);
+
+    if (!NT_SUCCESS(::D3DKMTOpenAdapterFromLuid(&open))) {
+        throw std::runtime_error("No display adapter with the specified LUID "
+            "could be opened.");
+    }
+
+    // The address must be queried before the adapter is closed, but we must
+    // close it in any case.
+    D3DKMT_ADAPTERADDRESS address;
+    D3DKMT_QUERYADAPTERINFO query;
+    ::ZeroMemory(&address, sizeof(address));
+    ::ZeroMemory(&query, sizeof(query));
+    query.hAdapter = open.hAdapter;
+    query.Type = KMTQAITYPE_ADAPTERADDRESS;
+    query.pPrivateDriverData = &address;
+    query.PrivateDriverDataSize = sizeof(address);
+    const auto status = ::D3DKMTQueryAdapterInfo(&query);
+
+    {
+        D3DKMT_CLOSEADAPTER close;
+        close.hAdapter = open.hAdapter;
+        ::D3DKMTCloseAdapter(&close);
+    }
+
+    if (!NT_SUCCESS(status)) {
+        throw std::runtime_error("The display adapter with the specified LUID "
+            "does not have a PCI address.");
+    }
+
+    pci_location retval;
+    retval.bus = address.BusNumber;
+    retval.device = address.DeviceNumber;
+    retval.function = address.FunctionNumber;
+    return retval;
+
+#else /* defined(_WIN32) */
+    throw std::logic_error("Locally unique identifiers of display adapters "
+        "are only supported on Windows.");
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::parse_pci_bus_id
+ */
+bool visus::power_overwhelming::detail::parse_pci_bus_id(
+        _Out_ pci_location& dst, _In_opt_z_ const char *bus_id) noexcept {
+    unsigned int domain = 0;
+    unsigned int bus = 0;
+    unsigned int device = 0;
+    unsigned int function = 0;
+
+    if (bus_id == nullptr) {
+        return false;
+    }
+
+#if defined(_WIN32)
+    const auto cnt = ::sscanf_s(bus_id, "%x:%x:%x.%x", &domain, &bus, &device,
+        &function);
+#else /* defined(_WIN32) */
+    const auto cnt = ::sscanf(bus_id, "%x:%x:%x.%x", &domain, &bus, &device,
+        &function);
+#endif /* defined(_WIN32) */
+    if (cnt < 3) {
+        return false;
+    }
+
+    dst.bus = bus;
+    dst.device = device;
+    dst.function = function;
+    return true;
+}
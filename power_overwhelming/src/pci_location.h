@@ -0,0 +1,90 @@
+﻿// <copyright file="pci_location.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The location of a device on the PCI bus, which is used to match the
+    /// DXGI adapters to the devices of the vendor libraries.
+    /// </summary>
+    /// <remarks>
+    /// The PCI domain is not part of the location, because the Windows kernel
+    /// reports only the bus, device and function for an adapter.
+    /// </remarks>
+    struct POWER_OVERWHELMING_API pci_location final {
+
+        /// <summary>
+        /// The bus on which the device resides.
+        /// </summary>
+        std::uint32_t bus;
+
+        /// <summary>
+        /// The number of the device on the bus.
+        /// </summary>
+        std::uint32_t device;
+
+        /// <summary>
+        /// The function of the device.
+        /// </summary>
+        std::uint32_t function;
+    };
+
+    /// <summary>
+    /// Answer the PCI location of the display adapter with the given locally
+    /// unique identifier.
+    /// </summary>
+    /// <param name="luid">The LUID of the adapter with the high part in the
+    /// upper 32 bits.</param>
+    /// <returns>The location of the adapter on the PCI bus.</returns>
+    /// <exception cref="std::runtime_error">If the adapter does not exist or
+    /// is not a PCI device.</exception>
+    /// <exception cref="std::logic_error">If the platform does not support
+    /// LUIDs for display adapters.</exception>
+    pci_location POWER_OVERWHELMING_API get_pci_location(
+        _In_ const std::uint64_t luid);
+
+    /// <summary>
+    /// Parses a PCI bus ID in the format
+    /// <c>domain:bus:device.function</c> used by NVML.
+    /// </summary>
+    /// <param name="dst">Receives the location if the ID could be parsed.
+    /// </param>
+    /// <param name="bus_id">The hexadecimal PCI bus ID. The function may be
+    /// omitted, in which case it is zero.</param>
+    /// <returns><c>true</c> if the ID was valid, <c>false</c> otherwise.
+    /// </returns>
+    bool POWER_OVERWHELMING_API parse_pci_bus_id(_Out_ pci_location& dst,
+        _In_opt_z_ const char *bus_id) noexcept;
+
+    /// <summary>
+    /// Answer whether two PCI locations are the same.
+    /// </summary>
+    inline bool operator ==(_In_ const pci_location& lhs,
+            _In_ const pci_location& rhs) noexcept {
+        return (lhs.bus == rhs.bus)
+            && (lhs.device == rhs.device)
+            && (lhs.function == rhs.function);
+    }
+
+    /// <summary>
+    /// Answer whether two PCI locations are different.
+    /// </summary>
+    inline bool operator !=(_In_ const pci_location& lhs,
+            _In_ const pci_location& rhs) noexcept {
+        return !(lhs == rhs);
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,279 @@
+﻿// <copyright file="perf_rapl_group.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "perf_rapl_group.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#if !defined(_WIN32)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif /* !defined(_WIN32) */
+
+#include "power_overwhelming/for_each_rapl_domain.h"
+
+#include "io_util.h"
+#include "tsc_clock.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+#if !defined(_WIN32)
+    /// <summary>
+    /// The sysfs directory of the RAPL PMU.
+    /// </summary>
+    static constexpr const char *perf_rapl_pmu = "/sys/bus/event_source/"
+        "devices/power/";
+
+    /// <summary>
+    /// Reads the first line of the file <paramref name="name" /> in the
+    /// directory of the RAPL PMU.
+    /// </summary>
+    static bool read_perf_rapl_pmu(_Out_ std::string& dst,
+            _In_ const std::string& name) {
+        std::ifstream stream(perf_rapl_pmu + name);
+        return static_cast<bool>(std::getline(stream, dst));
+    }
+#endif /* !defined(_WIN32) */
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::perf_rapl_group::max_reuse
+ */
+constexpr std::chrono::microseconds
+visus::power_overwhelming::detail::perf_rapl_group::max_reuse;
+
+
+/*
+ * visus::power_overwhelming::detail::perf_rapl_group::cpus
+ */
+std::vector<visus::power_overwhelming::detail::perf_rapl_group::cpu_type>
+visus::power_overwhelming::detail::perf_rapl_group::cpus(void) {
+    std::vector<cpu_type> retval;
+
+#if !defined(_WIN32)
+    // The mask is a list of CPUs and ranges of CPUs like "0,18" or "0-1".
+    std::string mask;
+    if (read_perf_rapl_pmu(mask, "cpumask")) {
+        std::stringstream stream(mask);
+        std::string range;
+
+        while (std::getline(stream, range, ',')) {
+            auto end = static_cast<char *>(nullptr);
+            const auto first = std::strtoul(range.c_str(), &end, 10);
+            if (end == range.c_str()) {
+                continue;
+            }
+
+            const auto last = (*end == '-')
+                ? std::strtoul(end + 1, nullptr, 10)
+                : first;
+            for (auto c = first; c <= last; ++c) {
+                retval.push_back(static_cast<cpu_type>(c));
+            }
+        }
+    }
+#endif /* !defined(_WIN32) */
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::perf_rapl_group::create
+ */
+visus::power_overwhelming::detail::perf_rapl_group::group_type
+visus::power_overwhelming::detail::perf_rapl_group::create(
+        _In_ const cpu_type cpu) {
+    std::lock_guard<decltype(_lock)> l(_lock);
+    auto it = _instances.find(cpu);
+
+    if (it == _instances.end()) {
+        auto retval = std::make_shared<perf_rapl_group>(cpu);
+        _instances[cpu] = retval;
+        return retval;
+
+    } else {
+        return it->second;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::perf_rapl_group::event_name
+ */
+_Ret_maybenull_z_ const char *
+visus::power_overwhelming::detail::perf_rapl_group::event_name(
+        _In_ const rapl_domain domain) noexcept {
+    switch (domain) {
+        case rapl_domain::package: return "energy-pkg";
+        case rapl_domain::pp0: return "energy-cores";
+        case rapl_domain::pp1: return "energy-gpu";
+        case rapl_domain::dram: return "energy-ram";
+        default: return nullptr;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::perf_rapl_group::perf_rapl_group
+ */
+visus::power_overwhelming::detail::perf_rapl_group::perf_rapl_group(
+        _In_ const cpu_type cpu) : _consumed(0), _cpu(cpu) {
+#if defined(_WIN32)
+    throw std::system_error(ENOTSUP, std::system_category());
+
+#else /* defined(_WIN32) */
+    std::string type;
+    if (!read_perf_rapl_pmu(type, "type")) {
+        throw std::system_error(ENOENT, std::system_category());
+    }
+
+    perf_event_attr attr;
+    ::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = static_cast<decltype(attr.type)>(std::stoul(type));
+    attr.read_format = PERF_FORMAT_GROUP;
+
+    try {
+        power_overwhelming::for_each_rapl_domain([this, &attr](
+                const rapl_domain domain) {
+            // The events describe their encoding like "event=0x02" and the
+            // factor to obtain Joules in separate files.
+            const std::string name = std::string("events/")
+                + event_name(domain);
+            std::string event, scale;
+            if (!read_perf_rapl_pmu(event, name)
+                    || !read_perf_rapl_pmu(scale, name + ".scale")) {
+                // The domain is not supported on this machine.
+                return true;
+            }
+
+            const auto config = event.find("event=");
+            if (config == std::string::npos) {
+                return true;
+            }
+
+            attr.config = std::strtoull(event.c_str() + config + 6, nullptr,
+                0);
+            const auto leader = this->_events.empty()
+                ? -1
+                : this->_events.front();
+            const auto fd = static_cast<int>(::syscall(__NR_perf_event_open,
+                &attr, -1, this->_cpu, leader, 0));
+            if (fd == -1) {
+                throw std::system_error(errno, std::system_category());
+            }
+
+            this->_domains.push_back(domain);
+            this->_events.push_back(fd);
+            this->_scales.push_back(std::stod(scale));
+            return true;
+        });
+    } catch (...) {
+        // The destructor will not run, so we must not leak the events that
+        // have been opened successfully.
+        for (auto e : this->_events) {
+            ::close(e);
+        }
+        throw;
+    }
+
+    if (this->_events.empty()) {
+        throw std::system_error(ENOENT, std::system_category());
+    }
+
+    // The group is read as the number of events followed by their values.
+    this->_values.resize(this->_events.size() + 1);
+    assert(this->_events.size() <= 8 * sizeof(this->_consumed));
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::perf_rapl_group::~perf_rapl_group
+ */
+visus::power_overwhelming::detail::perf_rapl_group::~perf_rapl_group(
+        void) noexcept {
+#if !defined(_WIN32)
+    // Close the members before the leader of the group.
+    for (auto it = this->_events.rbegin(); it != this->_events.rend(); ++it) {
+        ::close(*it);
+    }
+#endif /* !defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::perf_rapl_group::index
+ */
+std::size_t visus::power_overwhelming::detail::perf_rapl_group::index(
+        _In_ const rapl_domain domain) const {
+    for (std::size_t i = 0; i < this->_domains.size(); ++i) {
+        if (this->_domains[i] == domain) {
+            return i;
+        }
+    }
+
+    throw std::invalid_argument("The specified RAPL domain is not supported "
+        "by the power PMU of the specified CPU.");
+}
+
+
+/*
+ * visus::power_overwhelming::detail::perf_rapl_group::read
+ */
+double visus::power_overwhelming::detail::perf_rapl_group::read(
+        _In_ const std::size_t index,
+        _Out_ time_point& time) {
+    assert(index < this->_scales.size());
+    const auto bit = static_cast<std::uint64_t>(1) << index;
+    const auto now = tsc_clock::now();
+
+    std::lock_guard<decltype(this->_read_lock)> l(this->_read_lock);
+#if !defined(_WIN32)
+    if (((this->_consumed & bit) != 0) || (now - this->_time > max_reuse)) {
+        // The counter has already been retrieved from the last read or the
+        // read is too old, so read all of them again.
+        detail::read_bytes(this->_events.front(), this->_values.data(),
+            this->_values.size() * sizeof(std::uint64_t));
+        this->_consumed = 0;
+        this->_time = tsc_clock::now();
+    }
+#endif /* !defined(_WIN32) */
+
+    this->_consumed |= bit;
+    time = this->_time;
+    return this->_values[index + 1] * this->_scales[index];
+}
+
+
+/*
+ * visus::power_overwhelming::detail::perf_rapl_group::_instances
+ */
+std::map<visus::power_overwhelming::detail::perf_rapl_group::cpu_type,
+    visus::power_overwhelming::detail::perf_rapl_group::group_type>
+visus::power_overwhelming::detail::perf_rapl_group::_instances;
+
+
+/*
+ * visus::power_overwhelming::detail::perf_rapl_group::_lock
+ */
+std::mutex visus::power_overwhelming::detail::perf_rapl_group::_lock;
@@ -0,0 +1,173 @@
+﻿// <copyright file="perf_rapl_group.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <chrono>
+#include <cinttypes>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "power_overwhelming/rapl_domain.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A group of perf events of the Linux <c>power</c> PMU, which holds the
+    /// energy counters of all RAPL domains available for a single CPU.
+    /// </summary>
+    /// <remarks>
+    /// <para>In contrast to the MSR device files, the perf events neither
+    /// require the msr module nor root privileges (only a sufficiently low
+    /// <c>perf_event_paranoid</c> setting or <c>CAP_PERFMON</c>), the kernel
+    /// accumulates the counters in 64 bits, which removes the need for handling
+    /// wrapping registers, and all counters of the group can be retrieved by a
+    /// single <c>read</c>.</para>
+    /// <para>Groups are shared by all sensors for the same CPU via
+    /// <see cref="create" />. In order to retrieve all domains with one system
+    /// call if they are sampled together, the group retains the result of its
+    /// last read and serves every domain once from it, provided that the read
+    /// is not older than <see cref="max_reuse" />.</para>
+    /// </remarks>
+    class perf_rapl_group final {
+
+    public:
+
+        /// <summary>
+        /// The type used to index logical CPUs.
+        /// </summary>
+        typedef std::uint32_t cpu_type;
+
+        /// <summary>
+        /// The type of a shared group.
+        /// </summary>
+        typedef std::shared_ptr<perf_rapl_group> group_type;
+
+        /// <summary>
+        /// The type used to store the point in time a group has been read.
+        /// </summary>
+        typedef std::chrono::system_clock::time_point time_point;
+
+        /// <summary>
+        /// The maximum age of the last read for which it is used to answer a
+        /// domain that has not yet been retrieved from it.
+        /// </summary>
+        /// <remarks>
+        /// This is the interval in which the hardware updates the RAPL
+        /// counters, so retrieving the group again would not yield newer data
+        /// anyway.
+        /// </remarks>
+        static constexpr std::chrono::microseconds max_reuse
+            = std::chrono::microseconds(1000);
+
+        /// <summary>
+        /// Answer the logical CPUs for which the <c>power</c> PMU can be
+        /// opened, which is typically one CPU per package.
+        /// </summary>
+        /// <returns>The CPUs from the <c>cpumask</c> of the PMU, which is
+        /// empty if the PMU is not available.</returns>
+        static std::vector<cpu_type> cpus(void);
+
+        /// <summary>
+        /// Gets the group for the specified CPU or opens it if no sensor is
+        /// using it yet.
+        /// </summary>
+        /// <param name="cpu">The logical CPU to open the events on.</param>
+        /// <returns>The group for <paramref name="cpu" />.</returns>
+        /// <exception cref="std::system_error">If the PMU is not available or
+        /// if no event could be opened.</exception>
+        static group_type create(_In_ const cpu_type cpu);
+
+        /// <summary>
+        /// Answer the name of the event of the <c>power</c> PMU that counts
+        /// the energy of the given RAPL domain.
+        /// </summary>
+        /// <param name="domain">The RAPL domain to get the event for.</param>
+        /// <returns>The name of the event, or <c>nullptr</c> if the domain has
+        /// no counterpart in the PMU.</returns>
+        static _Ret_maybenull_z_ const char *event_name(
+            _In_ const rapl_domain domain) noexcept;
+
+        /// <summary>
+        /// Opens all available domains on the specified CPU.
+        /// </summary>
+        /// <param name="cpu">The logical CPU to open the events on.</param>
+        /// <exception cref="std::system_error">If the PMU is not available or
+        /// if no event could be opened.</exception>
+        explicit perf_rapl_group(_In_ const cpu_type cpu);
+
+        perf_rapl_group(const perf_rapl_group&) = delete;
+
+        /// <summary>
+        /// Finalise the instance.
+        /// </summary>
+        ~perf_rapl_group(void) noexcept;
+
+        /// <summary>
+        /// Answer the CPU the events have been opened on.
+        /// </summary>
+        /// <returns>The logical CPU of the group.</returns>
+        inline cpu_type cpu(void) const noexcept {
+            return this->_cpu;
+        }
+
+        /// <summary>
+        /// Answer the RAPL domains that are counted by the group.
+        /// </summary>
+        /// <returns>The available domains in the order of their indices.
+        /// </returns>
+        inline const std::vector<rapl_domain>& domains(void) const noexcept {
+            return this->_domains;
+        }
+
+        /// <summary>
+        /// Answer the index of the counter for the given RAPL domain.
+        /// </summary>
+        /// <param name="domain">The RAPL domain to search.</param>
+        /// <returns>The index of the counter to pass to <see cref="read" />.
+        /// </returns>
+        /// <exception cref="std::invalid_argument">If the domain is not
+        /// counted by the group.</exception>
+        std::size_t index(_In_ const rapl_domain domain) const;
+
+        /// <summary>
+        /// Reads the energy counter at the given index.
+        /// </summary>
+        /// <param name="index">The index of the counter obtained from
+        /// <see cref="index" />.</param>
+        /// <param name="time">Receives the point in time the counters have
+        /// been read, which might be before the call if the counter has been
+        /// served from the previous read of the group.</param>
+        /// <returns>The energy in Joules counted since the group has been
+        /// opened.</returns>
+        /// <exception cref="std::system_error">If reading the group failed.
+        /// </exception>
+        double read(_In_ const std::size_t index, _Out_ time_point& time);
+
+        perf_rapl_group& operator =(const perf_rapl_group&) = delete;
+
+    private:
+
+        static std::map<cpu_type, group_type> _instances;
+        static std::mutex _lock;
+
+        std::uint64_t _consumed;
+        cpu_type _cpu;
+        std::vector<rapl_domain> _domains;
+        std::vector<int> _events;
+        std::mutex _read_lock;
+        std::vector<double> _scales;
+        time_point _time;
+        std::vector<std::uint64_t> _values;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,241 @@
+﻿// <copyright file="perf_rapl_sensor.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/perf_rapl_sensor.h"
+
+#include <cassert>
+#include <stdexcept>
+#include <system_error>
+
+#include "perf_rapl_group.h"
+#include "perf_rapl_sensor_impl.h"
+
+
+/*
+ * visus::power_overwhelming::perf_rapl_sensor::for_all
+ */
+std::size_t visus::power_overwhelming::perf_rapl_sensor::for_all(
+        _Out_writes_opt_(cnt_sensors) perf_rapl_sensor *out_sensors,
+        _In_ const std::size_t cnt_sensors) {
+    std::size_t retval = 0;
+
+    for (auto c : detail::perf_rapl_group::cpus()) {
+        try {
+            // Opening the group tells us which of the domains are supported.
+            // The group is cached, so the sensors created below share it.
+            auto group = detail::perf_rapl_group::create(c);
+            assert(group != nullptr);
+
+            for (auto d : group->domains()) {
+                if (retval < cnt_sensors) {
+                    auto& sensor = out_sensors[retval];
+                    assert(sensor._impl != nullptr);
+                    sensor._impl->set(c, d);
+                }
+
+                ++retval;
+            }
+        } catch (const std::system_error&) {
+            // The events cannot be opened, most likely because the process
+            // lacks the privileges for system-wide perf events. This is not
+            // fatal, there are just no sensors for this CPU.
+        }
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::perf_rapl_sensor::for_core
+ */
+visus::power_overwhelming::perf_rapl_sensor
+visus::power_overwhelming::perf_rapl_sensor::for_core(
+        _In_ const core_type core,
+        _In_ const rapl_domain domain) {
+    perf_rapl_sensor retval;
+    assert(retval._impl != nullptr);
+    retval._impl->set(core, domain);
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::perf_rapl_sensor::sample_data
+ */
+void visus::power_overwhelming::perf_rapl_sensor::sample_data(
+        _Out_writes_(cnt) measurement_data *dst,
+        _In_reads_(cnt) const perf_rapl_sensor *sensors,
+        _In_ const std::size_t cnt,
+        _In_ const timestamp_resolution resolution) {
+    if ((cnt > 0) && ((dst == nullptr) || (sensors == nullptr))) {
+        throw std::invalid_argument("The output and the sensors must be "
+            "valid if sensors are to be sampled.");
+    }
+
+    for (std::size_t i = 0; i < cnt; ++i) {
+        dst[i] = sensors[i].sample_data(resolution);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::perf_rapl_sensor::perf_rapl_sensor
+ */
+visus::power_overwhelming::perf_rapl_sensor::perf_rapl_sensor(void)
+    : _impl(new detail::perf_rapl_sensor_impl()) { }
+
+
+/*
+ * visus::power_overwhelming::perf_rapl_sensor::~perf_rapl_sensor
+ */
+visus::power_overwhelming::perf_rapl_sensor::~perf_rapl_sensor(void) {
+    detail::perf_rapl_sensor_impl::sampler.remove(this->_impl);
+    // Make sure that the generic sampler thread does not use the sensor
+    // anymore.
+    this->sample_batch(nullptr);
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::perf_rapl_sensor::core
+ */
+visus::power_overwhelming::perf_rapl_sensor::core_type
+visus::power_overwhelming::perf_rapl_sensor::core(void) const {
+    this->check_not_disposed();
+    return this->_impl->core;
+}
+
+
+/*
+ * visus::power_overwhelming::perf_rapl_sensor::domain
+ */
+visus::power_overwhelming::rapl_domain
+visus::power_overwhelming::perf_rapl_sensor::domain(void) const {
+    this->check_not_disposed();
+    return this->_impl->domain;
+}
+
+
+/*
+ * visus::power_overwhelming::perf_rapl_sensor::energy
+ */
+double visus::power_overwhelming::perf_rapl_sensor::energy(void) const {
+    this->check_not_disposed();
+    return this->_impl->energy();
+}
+
+
+/*
+ * visus::power_overwhelming::perf_rapl_sensor::name
+ */
+_Ret_maybenull_z_
+const wchar_t *visus::power_overwhelming::perf_rapl_sensor::name(
+        void) const noexcept {
+    return (this->_impl != nullptr)
+        ? this->_impl->sensor_name.c_str()
+        : nullptr;
+}
+
+
+/*
+ * visus::power_overwhelming::perf_rapl_sensor::native_interval
+ */
+visus::power_overwhelming::sensor::microseconds_type
+visus::power_overwhelming::perf_rapl_sensor::native_interval(void) const {
+    // Intel documents the update interval of the energy status counters to
+    // be approximately 1 ms, which holds for AMD processors, too.
+    this->check_not_disposed();
+    return 1000;
+}
+
+
+/*
+ * visus::power_overwhelming::perf_rapl_sensor::sample
+ */
+void visus::power_overwhelming::perf_rapl_sensor::sample(
+        _In_opt_ const measurement_callback on_measurement,
+        _In_ const microseconds_type period,
+        _In_ const timestamp_resolution timestamp_resolution,
+        _In_opt_ void *context) {
+    typedef decltype(detail::perf_rapl_sensor_impl::sampler)::interval_type
+        interval_type;
+
+    this->check_not_disposed();
+
+    if (on_measurement != nullptr) {
+        if (!detail::perf_rapl_sensor_impl::sampler.add(this->_impl,
+                on_measurement, context, interval_type(period))) {
+            throw std::logic_error("Asynchronous sampling cannot be started "
+                "while it is already running.");
+        }
+
+    } else {
+        detail::perf_rapl_sensor_impl::sampler.remove(this->_impl, context);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::perf_rapl_sensor::sample_adaptive
+ */
+void visus::power_overwhelming::perf_rapl_sensor::sample_adaptive(
+        _In_opt_ const measurement_data_callback on_batch,
+        _In_ const microseconds_type min_period,
+        _In_ const microseconds_type max_period,
+        _In_opt_ void *context) {
+    this->sample_adaptive_sync(on_batch, min_period, max_period, context);
+}
+
+
+/*
+ * visus::power_overwhelming::perf_rapl_sensor::operator =
+ */
+visus::power_overwhelming::perf_rapl_sensor&
+visus::power_overwhelming::perf_rapl_sensor::operator =(
+        _In_ perf_rapl_sensor&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        detail::perf_rapl_sensor_impl::sampler.remove(this->_impl);
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::perf_rapl_sensor::operator bool
+ */
+visus::power_overwhelming::perf_rapl_sensor::operator bool(
+        void) const noexcept {
+    return ((this->_impl != nullptr) && (this->_impl->group != nullptr));
+}
+
+
+/*
+ * visus::power_overwhelming::perf_rapl_sensor::sample_data
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::perf_rapl_sensor::sample_data(
+        _In_ const timestamp_resolution resolution) const {
+    if (!*this) {
+        // The class is final, so this does not require a virtual call.
+        throw_disposed();
+    }
+    return this->_impl->sample(resolution);
+}
+
+
+/*
+ * visus::power_overwhelming::perf_rapl_sensor::sample_sync
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::perf_rapl_sensor::sample_sync(
+        _In_ const timestamp_resolution resolution) const {
+    return this->sample_data(resolution);
+}
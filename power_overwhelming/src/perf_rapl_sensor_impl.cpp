@@ -0,0 +1,90 @@
+﻿// <copyright file="perf_rapl_sensor_impl.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "perf_rapl_sensor_impl.h"
+
+#include <cassert>
+#include <stdexcept>
+
+#include "timestamp.h"
+
+
+/*
+ * visus::power_overwhelming::detail::perf_rapl_sensor_impl::sampler
+ */
+visus::power_overwhelming::detail::sampler<
+    visus::power_overwhelming::detail::default_sampler_context<
+    visus::power_overwhelming::detail::perf_rapl_sensor_impl>>
+    visus::power_overwhelming::detail::perf_rapl_sensor_impl::sampler;
+
+
+/*
+ * visus::power_overwhelming::detail::perf_rapl_sensor_impl::energy
+ */
+double visus::power_overwhelming::detail::perf_rapl_sensor_impl::energy(
+        void) const {
+    assert(this->group != nullptr);
+    perf_rapl_group::time_point time;
+    // The kernel accumulates the counter in 64 bits, so there is no need to
+    // track wrapping registers like the msr_sensor does.
+    return this->group->read(this->index, time) - this->first_energy;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::perf_rapl_sensor_impl::sample
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::detail::perf_rapl_sensor_impl::sample(
+        _In_ const timestamp_resolution resolution) const {
+    typedef std::chrono::duration<double> seconds_type;
+    assert(this->group != nullptr);
+
+    if (resolution == timestamp_resolution::nanoseconds) {
+        throw std::invalid_argument("Timestamps of perf RAPL sensors cannot be "
+            "created in nanoseconds.");
+    }
+
+    const auto converter = get_timestamp_converter(resolution);
+    perf_rapl_group::time_point now;
+    const auto energy = this->group->read(this->index, now);
+
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    const auto de = energy - this->last_energy;
+    const auto dt = now - this->last_time;
+    const auto sample_time = this->last_time + dt / 2;
+    const auto timestamp = converter(convert_to_file_time(sample_time));
+    const auto power = static_cast<measurement_data::value_type>(de
+        / std::chrono::duration_cast<seconds_type>(dt).count());
+
+    this->last_energy = energy;
+    this->last_time = now;
+
+    return measurement_data(timestamp, power);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::perf_rapl_sensor_impl::set
+ */
+void visus::power_overwhelming::detail::perf_rapl_sensor_impl::set(
+        _In_ const perf_rapl_group::cpu_type core,
+        _In_ const rapl_domain domain) {
+    auto group = perf_rapl_group::create(core);
+    assert(group != nullptr);
+    const auto index = group->index(domain);
+
+    this->core = core;
+    this->domain = domain;
+    this->group = std::move(group);
+    this->index = index;
+    this->sensor_name = L"perf/" + std::to_wstring(this->core) + L"/"
+        + to_string(this->domain);
+
+    // Retrieve a first sample as reference for the power of the next one and
+    // for the energy consumed since the creation of the sensor.
+    this->first_energy = this->last_energy = this->group->read(this->index,
+        this->last_time);
+}
@@ -0,0 +1,141 @@
+﻿// <copyright file="perf_rapl_sensor_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+
+#include "power_overwhelming/measurement.h"
+#include "power_overwhelming/perf_rapl_sensor.h"
+#include "power_overwhelming/rapl_domain.h"
+
+#include "default_sampler_context.h"
+#include "perf_rapl_group.h"
+#include "sampler.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Private data container for the <see cref="perf_rapl_sensor" />.
+    /// </summary>
+    struct perf_rapl_sensor_impl final {
+
+        /// <summary>
+        /// A sampler for perf RAPL sensors.
+        /// </summary>
+        /// <remarks>
+        /// The default context samples the sensors of the same group one after
+        /// another, so the group answers all but the first of them from a
+        /// single read.
+        /// </remarks>
+        static detail::sampler<default_sampler_context<perf_rapl_sensor_impl>>
+            sampler;
+
+        /// <summary>
+        /// The logical CPU the events have been opened on.
+        /// </summary>
+        perf_rapl_group::cpu_type core;
+
+        /// <summary>
+        /// The RAPL domain the sensor is sampling.
+        /// </summary>
+        rapl_domain domain;
+
+        /// <summary>
+        /// The value of the counter in Joules when the sensor was created.
+        /// </summary>
+        double first_energy;
+
+        /// <summary>
+        /// The group of events the sensor reads its counter from.
+        /// </summary>
+        perf_rapl_group::group_type group;
+
+        /// <summary>
+        /// The index of the counter of <see cref="domain" /> in
+        /// <see cref="group" />.
+        /// </summary>
+        std::size_t index;
+
+        /// <summary>
+        /// The value of the counter in Joules at the last sample.
+        /// </summary>
+        mutable double last_energy;
+
+        /// <summary>
+        /// The point in time when the counter of the last sample was read.
+        /// </summary>
+        mutable perf_rapl_group::time_point last_time;
+
+        /// <summary>
+        /// Protects <see cref="last_energy" /> and <see cref="last_time" />
+        /// against concurrent samples.
+        /// </summary>
+        mutable std::mutex lock;
+
+        /// <summary>
+        /// The sensor name.
+        /// </summary>
+        std::wstring sensor_name;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        inline perf_rapl_sensor_impl(void) : core(0),
+            domain(rapl_domain::package), first_energy(0), index(0),
+            last_energy(0) { }
+
+        /// <summary>
+        /// Answer the energy in Joules that has been consumed since the sensor
+        /// was created.
+        /// </summary>
+        /// <returns>The consumed energy in Joules.</returns>
+        double energy(void) const;
+
+        /// <summary>
+        /// Obtain a new sample with a timestamp in milliseconds, which is the
+        /// interface required by the <see cref="default_sampler_context" />.
+        /// </summary>
+        /// <returns>The result of the measurement.</returns>
+        inline measurement_data sample(void) const {
+            return this->sample(timestamp_resolution::milliseconds);
+        }
+
+        /// <summary>
+        /// Obtain a new sample and create a measurement from its difference to
+        /// <see cref="last_energy" />.
+        /// </summary>
+        /// <param name="resolution">The resolution of the timestamp being
+        /// created.</param>
+        /// <returns>The result of the measurement.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="resolution" /> is nanoseconds.</exception>
+        /// <exception cref="std::system_error">If reading the counter failed.
+        /// </exception>
+        measurement_data sample(_In_ const timestamp_resolution resolution) const;
+
+        /// <summary>
+        /// Opens the group of events for the given CPU and prepares the sensor
+        /// for sampling the given domain.
+        /// </summary>
+        /// <param name="core">The logical CPU to open the events on, which
+        /// must be in the <c>cpumask</c> of the PMU.</param>
+        /// <param name="domain">The RAPL domain to sample.</param>
+        /// <exception cref="std::invalid_argument">If the RAPL domain is not
+        /// supported by the PMU.</exception>
+        /// <exception cref="std::system_error">If the events could not be
+        /// opened.</exception>
+        void set(_In_ const perf_rapl_group::cpu_type core,
+            _In_ const rapl_domain domain);
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,191 @@
+﻿// <copyright file="periodic_clock.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "periodic_clock.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+/*
+ * visus::power_overwhelming::detail::periodic_clock::default_tolerance
+ */
+constexpr visus::power_overwhelming::timestamp_type
+visus::power_overwhelming::detail::periodic_clock::default_tolerance;
+
+
+/*
+ * visus::power_overwhelming::detail::periodic_clock::default_memory
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::periodic_clock::default_memory;
+
+
+/*
+ * visus::power_overwhelming::detail::periodic_clock::default_window
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::periodic_clock::default_window;
+
+
+/*
+ * visus::power_overwhelming::detail::periodic_clock::min_observations
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::periodic_clock::min_observations;
+
+
+/*
+ * visus::power_overwhelming::detail::periodic_clock::periodic_clock
+ */
+visus::power_overwhelming::detail::periodic_clock::periodic_clock(
+        _In_ const std::size_t window,
+        _In_ const std::size_t memory,
+        _In_ const timestamp_type tolerance)
+    : _base(0), _cxx(0.0), _cxy(0.0), _decay(0.0), _index(0), _last(0),
+        _mean_index(0.0), _mean_time(0.0), _next(0), _offset(0.0),
+        _sequence(0), _slope(0.0), _tolerance(tolerance), _weight(0.0),
+        _window((std::max)(window, min_observations)) {
+    this->_decay = std::exp(-1.0 / static_cast<double>(
+        (std::max)(memory, this->_window)));
+    this->_observations.reserve(this->_window);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::periodic_clock::period
+ */
+double visus::power_overwhelming::detail::periodic_clock::period(
+        void) const noexcept {
+    return this->_slope;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::periodic_clock::push
+ */
+visus::power_overwhelming::timestamp_type
+visus::power_overwhelming::detail::periodic_clock::push(
+        _In_ const sequence_type sequence,
+        _In_ const timestamp_type arrival) {
+    if (!this->_observations.empty()) {
+        // Unwrap the sequence number. Numbers that did not advance or went
+        // back indicate that the device has been restarted.
+        const auto delta = static_cast<sequence_type>(sequence
+            - this->_sequence);
+        if ((delta == 0) || (delta > (std::numeric_limits<
+                sequence_type>::max)() / 2)) {
+            this->reset();
+        } else {
+            this->_index += delta;
+        }
+    }
+
+    if (this->synchronised()) {
+        // A sample far from the model means that the device has been
+        // restarted in a different phase or that we missed more samples than
+        // the sequence numbers tell, so the model does not apply anymore.
+        const auto deviation = arrival - this->predict(this->_index);
+        if ((deviation > this->_tolerance) || (-deviation > this->_tolerance)) {
+            this->reset();
+        }
+    }
+
+    this->_sequence = sequence;
+    this->fit({ this->_index, arrival });
+
+    auto retval = this->synchronised() ? this->predict(this->_index) : arrival;
+    if ((this->_observations.size() > 1) && (retval < this->_last)) {
+        retval = this->_last;
+    }
+
+    this->_last = retval;
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::periodic_clock::reset
+ */
+void visus::power_overwhelming::detail::periodic_clock::reset(void) noexcept {
+    this->_base = 0;
+    this->_cxx = 0.0;
+    this->_cxy = 0.0;
+    this->_index = 0;
+    this->_last = 0;
+    this->_mean_index = 0.0;
+    this->_mean_time = 0.0;
+    this->_next = 0;
+    this->_observations.clear();
+    this->_offset = 0.0;
+    this->_slope = 0.0;
+    this->_weight = 0.0;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::periodic_clock::fit
+ */
+void visus::power_overwhelming::detail::periodic_clock::fit(
+        _In_ const observation& observation) {
+    if (this->_observations.empty()) {
+        // Time is relative to the first sample such that it remains small
+        // enough for double precision.
+        this->_base = observation.arrival;
+    }
+
+    if (this->_observations.size() < this->_window) {
+        this->_observations.push_back(observation);
+    } else {
+        this->_observations[this->_next] = observation;
+    }
+    this->_next = (this->_next + 1) % this->_window;
+
+    // Update the weighted means and co-moments incrementally, decaying the
+    // weight of all previous samples.
+    const auto x = static_cast<double>(observation.index);
+    const auto y = static_cast<double>(observation.arrival - this->_base);
+    this->_weight = this->_decay * this->_weight + 1.0;
+    const auto dx = x - this->_mean_index;
+    this->_mean_index += dx / this->_weight;
+    this->_mean_time += (y - this->_mean_time) / this->_weight;
+    this->_cxx = this->_decay * this->_cxx + dx * (x - this->_mean_index);
+    this->_cxy = this->_decay * this->_cxy + dx * (y - this->_mean_time);
+
+    this->_slope = 0.0;
+    if ((this->_observations.size() < min_observations)
+            || (this->_cxx <= 0.0) || (this->_cxy <= 0.0)) {
+        // Too few samples, or time does not advance, so there is nothing we
+        // could fit.
+        return;
+    }
+
+    const auto slope = this->_cxy / this->_cxx;
+
+    // Move the line down to the least delayed sample.
+    auto residual = (std::numeric_limits<double>::max)();
+    for (auto& o : this->_observations) {
+        const auto r = static_cast<double>(o.arrival - this->_base)
+            - this->_mean_time - slope * (static_cast<double>(o.index)
+            - this->_mean_index);
+        residual = (std::min)(residual, r);
+    }
+
+    this->_offset = residual;
+    this->_slope = slope;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::periodic_clock::predict
+ */
+visus::power_overwhelming::timestamp_type
+visus::power_overwhelming::detail::periodic_clock::predict(
+        _In_ const std::int64_t index) const noexcept {
+    const auto x = static_cast<double>(index) - this->_mean_index;
+    return this->_base + static_cast<timestamp_type>(std::llround(
+        this->_mean_time + this->_offset + this->_slope * x));
+}
@@ -0,0 +1,167 @@
+﻿// <copyright file="periodic_clock.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <vector>
+
+#include "power_overwhelming/measurement_data.h"
+
+#include "timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Models the clock of a device that emits samples at a fixed period in
+    /// order to stamp them without the jitter of their delivery.
+    /// </summary>
+    /// <remarks>
+    /// <para>Devices like the Tinkerforge bricklets emit their callbacks at a
+    /// fixed period, but the host can only stamp them when they arrive, which
+    /// adds the jitter of the network and the Brick daemon. The clock fits a
+    /// line through the arrival times over the sequence numbers, which yields
+    /// the actual period of the device including its drift against the host.
+    /// The fit uses exponentially decaying weights such that the slope is
+    /// estimated from many samples, but still follows slow changes of the
+    /// drift. As the delivery can delay, but never advance a sample, the line
+    /// is moved down to the earliest arrival within a window of the most
+    /// recent samples, ie to the least delayed one.</para>
+    /// <para>Gaps in the sequence numbers are handled by the fit. If the
+    /// sequence restarts or a sample arrives too far from where the model
+    /// expects it, the clock starts over.</para>
+    /// <para>All time stamps passed to and returned by the clock are in units
+    /// of 100 ns, ie <see cref="timestamp_resolution::hundred_nanoseconds" />.
+    /// The clock is not thread-safe, because it is owned by the code that
+    /// assembles the samples of a single device.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API periodic_clock final {
+
+    public:
+
+        /// <summary>
+        /// The type of a sequence number.
+        /// </summary>
+        typedef measurement_data::sequence_type sequence_type;
+
+        /// <summary>
+        /// The default deviation from the model in 100 ns units beyond which
+        /// the clock starts over, which is 100 ms.
+        /// </summary>
+        static constexpr timestamp_type default_tolerance = 1000000;
+
+        /// <summary>
+        /// The default number of samples after which the weight of a sample
+        /// in the fit has decayed to 1/e.
+        /// </summary>
+        static constexpr std::size_t default_memory = 4096;
+
+        /// <summary>
+        /// The default number of recent samples searched for the least delayed
+        /// one.
+        /// </summary>
+        static constexpr std::size_t default_window = 256;
+
+        /// <summary>
+        /// The number of samples required before the model is used.
+        /// </summary>
+        static constexpr std::size_t min_observations = 8;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="window">The number of most recent samples searched
+        /// for the least delayed one. Values less than
+        /// <see cref="min_observations" /> are raised to it.</param>
+        /// <param name="memory">The number of samples after which the weight
+        /// of a sample in the fit has decayed to 1/e. Values less than
+        /// <paramref name="window" /> are raised to it.</param>
+        /// <param name="tolerance">The deviation of an arrival time from the
+        /// model in 100 ns units beyond which the clock starts over.</param>
+        explicit periodic_clock(_In_ const std::size_t window = default_window,
+            _In_ const std::size_t memory = default_memory,
+            _In_ const timestamp_type tolerance = default_tolerance);
+
+        /// <summary>
+        /// Answer the estimated period of the device.
+        /// </summary>
+        /// <returns>The period in 100 ns units, or zero if the clock is not
+        /// <see cref="synchronised" />.</returns>
+        double period(void) const noexcept;
+
+        /// <summary>
+        /// Records the arrival of a sample and answer its time stamp.
+        /// </summary>
+        /// <param name="sequence">The sequence number of the sample, which
+        /// must advance by one for each period of the device, including the
+        /// ones of samples that have been lost.</param>
+        /// <param name="arrival">The host time at which the sample arrived.
+        /// </param>
+        /// <returns>The modelled time of the sample, or
+        /// <paramref name="arrival" /> if the clock is not yet
+        /// <see cref="synchronised" />. The time stamps returned never
+        /// decrease unless the clock starts over.</returns>
+        timestamp_type push(_In_ const sequence_type sequence,
+            _In_ const timestamp_type arrival);
+
+        /// <summary>
+        /// Forgets all samples.
+        /// </summary>
+        void reset(void) noexcept;
+
+        /// <summary>
+        /// Answer whether enough samples have been observed to use the model.
+        /// </summary>
+        /// <returns><c>true</c> if the samples are stamped by the model,
+        /// <c>false</c> if their arrival time is used.</returns>
+        inline bool synchronised(void) const noexcept {
+            return (this->_slope > 0.0);
+        }
+
+    private:
+
+        /// <summary>
+        /// A single observed arrival.
+        /// </summary>
+        struct observation final {
+            std::int64_t index;
+            timestamp_type arrival;
+        };
+
+        /// <summary>
+        /// Adds the given sample to the fit and updates the model.
+        /// </summary>
+        void fit(_In_ const observation& observation);
+
+        /// <summary>
+        /// Evaluates the model for the given unwrapped index.
+        /// </summary>
+        timestamp_type predict(_In_ const std::int64_t index) const noexcept;
+
+        timestamp_type _base;
+        double _cxx;
+        double _cxy;
+        double _decay;
+        std::int64_t _index;
+        timestamp_type _last;
+        double _mean_index;
+        double _mean_time;
+        std::size_t _next;
+        std::vector<observation> _observations;
+        double _offset;
+        sequence_type _sequence;
+        double _slope;
+        timestamp_type _tolerance;
+        double _weight;
+        std::size_t _window;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
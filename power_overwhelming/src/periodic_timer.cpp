@@ -0,0 +1,164 @@
+﻿// <copyright file="periodic_timer.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "periodic_timer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <thread>
+
+#if !defined(_WIN32)
+#include <time.h>
+#endif /* !defined(_WIN32) */
+
+
+#if defined(_WIN32) && !defined(CREATE_WAITABLE_TIMER_HIGH_RESOLUTION)
+// Older SDKs do not define this flag, which is available since Windows 10 1803.
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION (0x00000002)
+#endif /* defined(_WIN32) && !defined(CREATE_WAITABLE_TIMER_HIGH_RESOLUTION) */
+
+
+/*
+ * visus::power_overwhelming::detail::periodic_timer::spin_limit
+ */
+constexpr visus::power_overwhelming::detail::periodic_timer::interval_type
+visus::power_overwhelming::detail::periodic_timer::spin_limit;
+
+
+/*
+ * visus::power_overwhelming::detail::periodic_timer::spin_time
+ */
+constexpr visus::power_overwhelming::detail::periodic_timer::interval_type
+visus::power_overwhelming::detail::periodic_timer::spin_time;
+
+
+/*
+ * visus::power_overwhelming::detail::periodic_timer::periodic_timer
+ */
+visus::power_overwhelming::detail::periodic_timer::periodic_timer(void)
+        : _interval(0), _missed(0), _spin(0) {
+#if defined(_WIN32)
+    this->_timer = ::CreateWaitableTimerExW(nullptr, nullptr,
+        CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+
+    if (this->_timer == NULL) {
+        // High-resolution timers are not supported on older versions of
+        // Windows, so fall back to a normal one.
+        this->_timer = ::CreateWaitableTimerExW(nullptr, nullptr, 0,
+            TIMER_ALL_ACCESS);
+    }
+    // Note: If we still have no timer, we fall back to the STL.
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::periodic_timer::~periodic_timer
+ */
+visus::power_overwhelming::detail::periodic_timer::~periodic_timer(void) {
+#if defined(_WIN32)
+    if (this->_timer != NULL) {
+        ::CloseHandle(this->_timer);
+    }
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::periodic_timer::start
+ */
+void visus::power_overwhelming::detail::periodic_timer::start(
+        _In_ const interval_type interval,
+        _In_ const clock_type::time_point origin) {
+    this->_interval = (std::max)(interval, interval_type(1));
+    this->_missed.store(0, std::memory_order_relaxed);
+    this->_spin = (this->_interval <= spin_limit)
+        ? (std::min)(spin_time, this->_interval / 2)
+        : interval_type::zero();
+    this->_deadline = origin + this->_interval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::periodic_timer::wait
+ */
+bool visus::power_overwhelming::detail::periodic_timer::wait(void) {
+    auto now = clock_type::now();
+    const auto retval = (now < this->_deadline);
+
+    if (retval) {
+        // Let the operating system suspend the thread until shortly before the
+        // deadline and spin for the rest of the time.
+        const auto wake_up = this->_deadline - this->_spin;
+        if (now < wake_up) {
+            this->sleep_until(wake_up);
+        }
+
+        while (clock_type::now() < this->_deadline) {
+            std::this_thread::yield();
+        }
+
+    } else {
+        // We are late. If we are later than a whole interval, there is no way
+        // to recover the samples, so we skip those deadlines.
+        const auto skipped = static_cast<std::uint64_t>((now - this->_deadline)
+            / this->_interval);
+        this->_missed.fetch_add(skipped, std::memory_order_relaxed);
+        this->_deadline += skipped * this->_interval;
+    }
+
+    this->_deadline += this->_interval;
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::periodic_timer::sleep_until
+ */
+void visus::power_overwhelming::detail::periodic_timer::sleep_until(
+        _In_ const clock_type::time_point deadline) {
+#if defined(_WIN32)
+    if (this->_timer != NULL) {
+        // Waitable timers use absolute times on the system clock, which might
+        // be adjusted, so we convert the deadline into a relative timeout, which
+        // is expressed as a negative number of 100 ns units.
+        const auto timeout = std::chrono::duration_cast<
+            std::chrono::duration<LONGLONG, std::ratio<1, 10000000>>>(
+            deadline - clock_type::now()).count();
+
+        if (timeout > 0) {
+            LARGE_INTEGER due;
+            due.QuadPart = -timeout;
+
+            if (::SetWaitableTimer(this->_timer, &due, 0, nullptr, nullptr,
+                    FALSE)) {
+                ::WaitForSingleObject(this->_timer, INFINITE);
+                return;
+            }
+        } else {
+            return;
+        }
+    }
+
+    std::this_thread::sleep_until(deadline);
+
+#else /* defined(_WIN32) */
+    static_assert(clock_type::is_steady, "The deadline must be on a steady "
+        "clock for clock_nanosleep to work as expected.");
+    const auto since_epoch = std::chrono::duration_cast<
+        std::chrono::nanoseconds>(deadline.time_since_epoch());
+    const auto secs = std::chrono::duration_cast<std::chrono::seconds>(
+        since_epoch);
+
+    struct timespec ts;
+    ts.tv_sec = static_cast<decltype(ts.tv_sec)>(secs.count());
+    ts.tv_nsec = static_cast<decltype(ts.tv_nsec)>((since_epoch - secs).count());
+
+    // Note: the STL uses CLOCK_MONOTONIC for the steady_clock on Linux, so we
+    // can pass the deadline directly as absolute time.
+    while (::clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr)
+        == EINTR);
+#endif /* defined(_WIN32) */
+}
@@ -0,0 +1,167 @@
+﻿// <copyright file="periodic_timer.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#endif /* defined(_WIN32) */
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A timer that allows a thread to wake up periodically at absolute
+    /// deadlines.
+    /// </summary>
+    /// <remarks>
+    /// <para>In contrast to sleeping for the interval after the work has been
+    /// completed, the timer computes all deadlines from the instant when it has
+    /// been started. Therefore, the time spent between two calls to
+    /// <see cref="wait" /> does not shift the schedule, and the effective rate
+    /// does not drift below the requested one.</para>
+    /// <para>On Windows, the timer uses a high-resolution waitable timer if
+    /// available. On Linux, it uses <c>clock_nanosleep</c> with an absolute
+    /// deadline. For short intervals, the timer wakes up a bit earlier than
+    /// required and spins for the rest of the time, because the operating
+    /// system cannot wake up threads at arbitrary precision.</para>
+    /// <para>The timer is intended to be used by a single thread, except for
+    /// <see cref="missed" />, which can be called from any thread.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API periodic_timer final {
+
+    public:
+
+        /// <summary>
+        /// The clock used to compute the deadlines.
+        /// </summary>
+        typedef std::chrono::steady_clock clock_type;
+
+        /// <summary>
+        /// The type to express sampling intervals.
+        /// </summary>
+        typedef std::chrono::microseconds interval_type;
+
+        /// <summary>
+        /// The longest interval for which the timer spins in order to meet the
+        /// deadline more precisely.
+        /// </summary>
+        static constexpr interval_type spin_limit
+            = std::chrono::microseconds(1000);
+
+        /// <summary>
+        /// The maximum time the timer spins before a deadline.
+        /// </summary>
+        static constexpr interval_type spin_time
+            = std::chrono::microseconds(200);
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        periodic_timer(void);
+
+        periodic_timer(const periodic_timer&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~periodic_timer(void);
+
+        /// <summary>
+        /// Answer the interval between two deadlines.
+        /// </summary>
+        /// <returns>The interval of the timer.</returns>
+        inline interval_type interval(void) const noexcept {
+            return this->_interval;
+        }
+
+        /// <summary>
+        /// Answer the number of deadlines that have been missed since the
+        /// timer has been started.
+        /// </summary>
+        /// <remarks>
+        /// A deadline is considered missed if <see cref="wait" /> was called
+        /// more than a whole interval after the deadline. Deadlines that have
+        /// been met late, but within the interval, are not missed.
+        /// </remarks>
+        /// <returns>The number of missed deadlines.</returns>
+        inline std::uint64_t missed(void) const noexcept {
+            return this->_missed.load(std::memory_order_relaxed);
+        }
+
+        /// <summary>
+        /// Resets the missed deadlines and computes the first deadline, which
+        /// is one interval from now.
+        /// </summary>
+        /// <param name="interval">The interval between two deadlines.</param>
+        inline void start(_In_ const interval_type interval) {
+            this->start(interval, clock_type::now());
+        }
+
+        /// <summary>
+        /// Resets the missed deadlines and computes the first deadline, which
+        /// is one interval from <paramref name="origin" />.
+        /// </summary>
+        /// <remarks>
+        /// Timers that have been started from the same origin with the same
+        /// interval share all of their deadlines.
+        /// </remarks>
+        /// <param name="interval">The interval between two deadlines.</param>
+        /// <param name="origin">The instant from which the deadlines are
+        /// computed.</param>
+        void start(_In_ const interval_type interval,
+            _In_ const clock_type::time_point origin);
+
+        /// <summary>
+        /// Blocks the calling thread until the next deadline.
+        /// </summary>
+        /// <remarks>
+        /// If the next deadline has already passed, the method returns
+        /// immediately. If more than one interval has passed, the deadlines
+        /// in between are skipped and counted as missed.
+        /// </remarks>
+        /// <returns><c>true</c> if the deadline has been met, <c>false</c> if
+        /// the method was called after the deadline.</returns>
+        bool wait(void);
+
+        /// <summary>
+        /// Blocks the calling thread using the operating system until the
+        /// given point in time.
+        /// </summary>
+        /// <remarks>
+        /// This method does not spin, so the thread might wake up a bit
+        /// later than requested. It does not change the deadlines of the
+        /// timer and can therefore be used for a timer that has not been
+        /// started.
+        /// </remarks>
+        /// <param name="deadline">The instant until which the thread should
+        /// be suspended.</param>
+        void sleep_until(_In_ const clock_type::time_point deadline);
+
+        periodic_timer& operator =(const periodic_timer&) = delete;
+
+    private:
+
+        clock_type::time_point _deadline;
+        interval_type _interval;
+        std::atomic<std::uint64_t> _missed;
+        interval_type _spin;
+#if defined(_WIN32)
+        HANDLE _timer;
+#endif /* defined(_WIN32) */
+
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
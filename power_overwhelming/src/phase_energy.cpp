@@ -0,0 +1,172 @@
+﻿// <copyright file="phase_energy.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "phase_energy.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+#include "sensor_name_registry.h"
+
+
+/*
+ * ...::detail::phase_energy_integrator::phase_energy_integrator
+ */
+visus::power_overwhelming::detail::phase_energy_integrator
+::phase_energy_integrator(_In_ const double ticks_per_second) {
+    this->reset(ticks_per_second);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::phase_energy_integrator::add_counter
+ */
+void visus::power_overwhelming::detail::phase_energy_integrator::add_counter(
+        _In_z_ const wchar_t *sensor) {
+    assert(sensor != nullptr);
+    sensor = sensor_name_registry::intern(sensor);
+    this->_counters.insert(sensor);
+
+    auto it = this->_states.find(sensor);
+    if (it != this->_states.end()) {
+        it->second.counter = true;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::phase_energy_integrator::push
+ */
+void visus::power_overwhelming::detail::phase_energy_integrator::push(
+        _In_ const measurement& sample,
+        _In_ const std::uint32_t phase,
+        _In_ const measurement::timestamp_type begin,
+        _In_ const std::uint32_t marker) {
+    if (!sample) {
+        return;
+    }
+
+    const auto power = sample.power();
+    const auto timestamp = sample.timestamp();
+
+    auto add_phase = [&](const measurement::timestamp_type start) {
+        phase_energy e;
+        e.begin = start;
+        e.end = timestamp;
+        e.energy = 0.0;
+        e.marker = marker;
+        e.phase = phase;
+        e.samples = 0;
+        e.sensor = sample.sensor();
+        this->_phases.push_back(e);
+        return this->_phases.size() - 1;
+    };
+
+    auto it = this->_states.find(sample.sensor());
+    if (it == this->_states.end()) {
+        // This is the first sample of the sensor, so there is nothing to
+        // integrate yet.
+        state_type state;
+        state.counter = (this->_counters.count(sample.sensor()) > 0);
+        state.current = add_phase(timestamp);
+        state.power = power;
+        state.timestamp = timestamp;
+        ++this->_phases[state.current].samples;
+        this->_states.emplace(sample.sensor(), state);
+        return;
+    }
+
+    auto& state = it->second;
+    const auto dt = timestamp - state.timestamp;
+    if (dt <= 0) {
+        // Ignore samples that are out of order.
+        return;
+    }
+
+    // Counter-based sensors report the average since their previous sample,
+    // whereas the power of all other sensors is interpolated linearly.
+    const auto p0 = state.counter ? power : state.power;
+    auto area = [this](const double lhs, const double rhs,
+            const measurement::timestamp_type dt) {
+        return 0.5 * (lhs + rhs) * static_cast<double>(dt)
+            * this->_seconds_per_tick;
+    };
+
+    if (this->_phases[state.current].phase != phase) {
+        // Split the interval at the start of the new phase if the phase
+        // started after the previous sample.
+        auto split = (std::max)(begin, state.timestamp);
+        split = (std::min)(split, timestamp);
+
+        const auto dt0 = split - state.timestamp;
+        const auto pb = p0 + (power - p0) * static_cast<double>(dt0)
+            / static_cast<double>(dt);
+        this->add(state.current, area(p0, pb, dt0));
+
+        // The bounds of the phases must follow the split such that they
+        // cover the energy attributed to the phases.
+        this->_phases[state.current].end = split;
+        state.current = add_phase(split);
+        this->add(state.current, area(pb, power, timestamp - split));
+
+    } else {
+        this->add(state.current, area(p0, power, dt));
+    }
+
+    auto& current = this->_phases[state.current];
+    current.end = timestamp;
+    ++current.samples;
+    state.power = power;
+    state.timestamp = timestamp;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::phase_energy_integrator::reset
+ */
+void visus::power_overwhelming::detail::phase_energy_integrator::reset(
+        _In_ const double ticks_per_second) {
+    if (!(ticks_per_second > 0.0)) {
+        throw std::invalid_argument("The resolution of the timestamps must "
+            "be positive.");
+    }
+
+    this->_counters.clear();
+    this->_markers.clear();
+    this->_phases.clear();
+    this->_seconds_per_tick = 1.0 / ticks_per_second;
+    this->_states.clear();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::phase_energy_integrator::summary
+ */
+std::vector<visus::power_overwhelming::detail::phase_energy>
+visus::power_overwhelming::detail::phase_energy_integrator::summary(
+        void) const {
+    auto retval = this->_phases;
+    std::stable_sort(retval.begin(), retval.end(),
+            [](const phase_energy& lhs, const phase_energy& rhs) {
+        return (lhs.phase < rhs.phase);
+    });
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::phase_energy_integrator::add
+ */
+void visus::power_overwhelming::detail::phase_energy_integrator::add(
+        _In_ const std::size_t phase, _In_ const double energy) {
+    auto& p = this->_phases[phase];
+    p.energy += energy;
+
+    if (p.marker >= this->_markers.size()) {
+        this->_markers.resize(p.marker + 1, 0.0);
+    }
+    this->_markers[p.marker] += energy;
+}
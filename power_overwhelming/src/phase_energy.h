@@ -0,0 +1,175 @@
+﻿// <copyright file="phase_energy.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "power_overwhelming/measurement.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The energy a single sensor has measured in a phase between two
+    /// markers.
+    /// </summary>
+    struct POWER_OVERWHELMING_API phase_energy final {
+
+        /// <summary>
+        /// The begin of the interval the <see cref="energy" /> has been
+        /// integrated over, which is the first sample of the sensor or the
+        /// start of the phase if the sensor had been sampled before.
+        /// </summary>
+        measurement::timestamp_type begin;
+
+        /// <summary>
+        /// The end of the interval the <see cref="energy" /> has been
+        /// integrated over, which is the last sample of the sensor in the
+        /// phase or the start of the next phase.
+        /// </summary>
+        measurement::timestamp_type end;
+
+        /// <summary>
+        /// The energy in Joules.
+        /// </summary>
+        double energy;
+
+        /// <summary>
+        /// The ID of the marker active in the phase, which is zero if no
+        /// marker was set.
+        /// </summary>
+        std::uint32_t marker;
+
+        /// <summary>
+        /// The sequence number of the phase, which is the number of markers
+        /// that have been set before it.
+        /// </summary>
+        std::uint32_t phase;
+
+        /// <summary>
+        /// The number of valid samples of the sensor in the phase.
+        /// </summary>
+        std::uint64_t samples;
+
+        /// <summary>
+        /// The interned name of the sensor.
+        /// </summary>
+        const wchar_t *sensor;
+    };
+
+
+    /// <summary>
+    /// Integrates the energy of each sensor per phase, where each call to
+    /// <see cref="collector::marker" /> starts a new phase.
+    /// </summary>
+    /// <remarks>
+    /// <para>The power between two consecutive samples of a sensor is
+    /// interpolated linearly, i.e. the energy is the trapezoidal integral
+    /// using the actual timestamps of the samples. Sensors registered via
+    /// <see cref="add_counter" /> derive their power from an energy counter
+    /// and report the average power since their previous sample. Their power
+    /// is therefore held constant between samples, which reproduces the
+    /// deltas of the counter.</para>
+    /// <para>If a phase starts between two samples of a sensor, the energy in
+    /// between is split at the start of the phase, such that the energy of
+    /// all phases adds up to the integral over all samples.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API phase_energy_integrator final {
+
+    public:
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="ticks_per_second">The number of ticks of the
+        /// timestamps per second.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="ticks_per_second" /> is not positive.</exception>
+        explicit phase_energy_integrator(
+            _In_ const double ticks_per_second = 1000.0);
+
+        /// <summary>
+        /// Registers a sensor that derives its power from an energy counter.
+        /// </summary>
+        /// <param name="sensor">The name of the sensor.</param>
+        void add_counter(_In_z_ const wchar_t *sensor);
+
+        /// <summary>
+        /// Answer the energy of all sensors in all phases of each marker.
+        /// </summary>
+        /// <remarks>
+        /// The totals are updated with each sample, so reading them is
+        /// cheap regardless of the number of phases. The energy of a phase
+        /// is only complete once all sensors have delivered a sample after
+        /// the phase has ended.
+        /// </remarks>
+        /// <returns>The energy in Joules indexed by the ID of the marker. IDs
+        /// that have not been active yet may be missing.</returns>
+        inline const std::vector<double>& markers(void) const noexcept {
+            return this->_markers;
+        }
+
+        /// <summary>
+        /// Removes all phases and sensors.
+        /// </summary>
+        /// <param name="ticks_per_second">The number of ticks of the
+        /// timestamps per second.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="ticks_per_second" /> is not positive.</exception>
+        void reset(_In_ const double ticks_per_second);
+
+        /// <summary>
+        /// Adds a sample to the energy of its sensor.
+        /// </summary>
+        /// <param name="sample">The sample to be added. Invalid samples are
+        /// ignored.</param>
+        /// <param name="phase">The sequence number of the phase the sample
+        /// belongs to. Phases must not decrease for a sensor.</param>
+        /// <param name="begin">The time when <paramref name="phase" />
+        /// started.</param>
+        /// <param name="marker">The ID of the marker active in
+        /// <paramref name="phase" />.</param>
+        void push(_In_ const measurement& sample,
+            _In_ const std::uint32_t phase,
+            _In_ const measurement::timestamp_type begin,
+            _In_ const std::uint32_t marker);
+
+        /// <summary>
+        /// Answer the energy of all sensors per phase.
+        /// </summary>
+        /// <returns>The energies ordered by phase and, within a phase, by the
+        /// order in which the sensors delivered their first sample.</returns>
+        std::vector<phase_energy> summary(void) const;
+
+    private:
+
+        /// <summary>
+        /// The state of the integration of a single sensor.
+        /// </summary>
+        struct state_type {
+            bool counter;
+            std::size_t current;
+            measurement::value_type power;
+            measurement::timestamp_type timestamp;
+        };
+
+        void add(_In_ const std::size_t phase, _In_ const double energy);
+
+        std::unordered_set<const wchar_t *> _counters;
+        std::vector<double> _markers;
+        std::vector<phase_energy> _phases;
+        double _seconds_per_tick;
+        std::unordered_map<const wchar_t *, state_type> _states;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,125 @@
+﻿// <copyright file="phase_quantiles.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "phase_quantiles.h"
+
+#include <algorithm>
+#include <cassert>
+
+
+/*
+ * visus::power_overwhelming::detail::phase_quantiles::size
+ */
+constexpr std::size_t visus::power_overwhelming::detail::phase_quantiles::size;
+
+
+/*
+ * visus::power_overwhelming::detail::phase_quantiles::levels
+ */
+const double visus::power_overwhelming::detail::phase_quantiles::levels[size]
+    = { 0.0, 0.01, 0.05, 0.1, 0.25, 0.5, 0.75, 0.9, 0.95, 0.99, 1.0 };
+
+
+/*
+ * visus::power_overwhelming::detail::phase_quantiles::at
+ */
+float visus::power_overwhelming::detail::phase_quantiles::at(
+        _In_ const double q) const noexcept {
+    if (!(q > levels[0])) {
+        return this->values[0];
+    }
+
+    for (std::size_t i = 1; i < size; ++i) {
+        if (q <= levels[i]) {
+            const auto t = (q - levels[i - 1]) / (levels[i] - levels[i - 1]);
+            return static_cast<float>(this->values[i - 1]
+                + t * (this->values[i] - this->values[i - 1]));
+        }
+    }
+
+    return this->values[size - 1];
+}
+
+
+/*
+ * ...::detail::phase_quantile_tracker::phase_quantile_tracker
+ */
+visus::power_overwhelming::detail::phase_quantile_tracker
+::phase_quantile_tracker(_In_ const std::size_t accuracy)
+    : _accuracy(accuracy) {
+    // Make sure that an invalid accuracy is reported here rather than on the
+    // first sample.
+    quantile_sketch validate(accuracy);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::phase_quantile_tracker::push
+ */
+void visus::power_overwhelming::detail::phase_quantile_tracker::push(
+        _In_ const measurement& sample,
+        _In_ const std::uint32_t marker) {
+    if (!sample) {
+        return;
+    }
+
+    // The indices are offset by one such that zero marks markers that have
+    // not been encountered for the sensor.
+    auto& indices = this->_indices[sample.sensor()];
+    if (marker >= indices.size()) {
+        indices.resize(marker + 1, 0);
+    }
+
+    auto& index = indices[marker];
+    if (index == 0) {
+        phase_quantiles q;
+        q.marker = marker;
+        q.samples = 0;
+        q.sensor = sample.sensor();
+        std::fill(q.values, q.values + phase_quantiles::size, 0.0f);
+
+        this->_dirty.push_back(true);
+        this->_sketches.emplace_back(this->_accuracy);
+        this->_summaries.push_back(q);
+        index = this->_sketches.size();
+    }
+
+    this->_dirty[index - 1] = true;
+    this->_sketches[index - 1].push(sample.power());
+}
+
+
+/*
+ * visus::power_overwhelming::detail::phase_quantile_tracker::reset
+ */
+void visus::power_overwhelming::detail::phase_quantile_tracker::reset(void) {
+    this->_dirty.clear();
+    this->_indices.clear();
+    this->_sketches.clear();
+    this->_summaries.clear();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::phase_quantile_tracker::summary
+ */
+const std::vector<visus::power_overwhelming::detail::phase_quantiles>&
+visus::power_overwhelming::detail::phase_quantile_tracker::summary(void) {
+    assert(this->_dirty.size() == this->_sketches.size());
+    assert(this->_summaries.size() == this->_sketches.size());
+
+    for (std::size_t i = 0; i < this->_sketches.size(); ++i) {
+        if (this->_dirty[i]) {
+            auto& s = this->_sketches[i];
+            auto& q = this->_summaries[i];
+            q.samples = s.count();
+            s.quantiles(q.values, phase_quantiles::levels,
+                phase_quantiles::size);
+            this->_dirty[i] = false;
+        }
+    }
+
+    return this->_summaries;
+}
@@ -0,0 +1,140 @@
+﻿// <copyright file="phase_quantiles.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <unordered_map>
+#include <vector>
+
+#include "power_overwhelming/measurement.h"
+
+#include "quantile_sketch.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The distribution of the power a single sensor has measured while a
+    /// marker was active.
+    /// </summary>
+    struct POWER_OVERWHELMING_API phase_quantiles final {
+
+        /// <summary>
+        /// The number of quantiles in <see cref="values" />.
+        /// </summary>
+        static constexpr std::size_t size = 11;
+
+        /// <summary>
+        /// The quantiles that are estimated, which are the minimum, the 1st,
+        /// 5th, 10th, 25th, 50th, 75th, 90th, 95th and 99th percentile and
+        /// the maximum.
+        /// </summary>
+        static const double levels[size];
+
+        /// <summary>
+        /// The ID of the marker, which is zero for samples before the first
+        /// marker.
+        /// </summary>
+        std::uint32_t marker;
+
+        /// <summary>
+        /// The number of valid samples of the sensor while the marker was
+        /// active.
+        /// </summary>
+        std::uint64_t samples;
+
+        /// <summary>
+        /// The interned name of the sensor.
+        /// </summary>
+        const wchar_t *sensor;
+
+        /// <summary>
+        /// The estimated power in Watts at each of the
+        /// <see cref="levels" />.
+        /// </summary>
+        float values[size];
+
+        /// <summary>
+        /// Answer the power at an arbitrary quantile, which is interpolated
+        /// linearly between the adjacent <see cref="levels" />.
+        /// </summary>
+        /// <param name="q">The quantile, which is clamped to [0, 1].</param>
+        /// <returns>The estimated power in Watts.</returns>
+        float at(_In_ const double q) const noexcept;
+    };
+
+
+    /// <summary>
+    /// Tracks the distribution of the power of each sensor per marker in a
+    /// <see cref="quantile_sketch" />.
+    /// </summary>
+    /// <remarks>
+    /// All phases of a marker share the same sketch, because the number of
+    /// phases is unbounded whereas the number of markers is not, which keeps
+    /// the memory bounded regardless of the length of the measurement.
+    /// </remarks>
+    class POWER_OVERWHELMING_API phase_quantile_tracker final {
+
+    public:
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="accuracy">The accuracy of the sketches.</param>
+        explicit phase_quantile_tracker(_In_ const std::size_t accuracy
+            = quantile_sketch::default_accuracy);
+
+        /// <summary>
+        /// Answer whether no sample has been tracked yet.
+        /// </summary>
+        /// <returns><c>true</c> if there are no summaries,
+        /// <c>false</c> otherwise.</returns>
+        inline bool empty(void) const noexcept {
+            return this->_sketches.empty();
+        }
+
+        /// <summary>
+        /// Adds the power of a sample to the distribution of its sensor.
+        /// </summary>
+        /// <param name="sample">The sample to be added. Invalid samples are
+        /// ignored.</param>
+        /// <param name="marker">The ID of the marker active when the sample
+        /// was taken.</param>
+        void push(_In_ const measurement& sample,
+            _In_ const std::uint32_t marker);
+
+        /// <summary>
+        /// Removes all distributions.
+        /// </summary>
+        void reset(void);
+
+        /// <summary>
+        /// Answer the quantiles of all sensors per marker.
+        /// </summary>
+        /// <remarks>
+        /// Only the summaries of sketches that have changed since the
+        /// previous call are estimated again, which keeps publishing them
+        /// regularly cheap if only few markers are active.
+        /// </remarks>
+        /// <returns>The quantiles in the order in which the combinations of
+        /// sensor and marker have been encountered first.</returns>
+        const std::vector<phase_quantiles>& summary(void);
+
+    private:
+
+        std::size_t _accuracy;
+        std::vector<bool> _dirty;
+        std::unordered_map<const wchar_t *, std::vector<std::size_t>>
+            _indices;
+        std::vector<quantile_sketch> _sketches;
+        std::vector<phase_quantiles> _summaries;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
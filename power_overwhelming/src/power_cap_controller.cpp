@@ -0,0 +1,139 @@
+﻿// <copyright file="power_cap_controller.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_cap_controller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+
+/*
+ * visus::power_overwhelming::detail::power_cap_controller::gain
+ */
+constexpr double visus::power_overwhelming::detail::power_cap_controller::gain;
+
+
+/*
+ * visus::power_overwhelming::detail::power_cap_controller::initial_steps
+ */
+constexpr double
+visus::power_overwhelming::detail::power_cap_controller::initial_steps;
+
+
+/*
+ * ...::detail::power_cap_controller::power_cap_controller
+ */
+visus::power_overwhelming::detail::power_cap_controller::power_cap_controller(
+        _In_ const power_governor& governor,
+        _In_ const double min_limit,
+        _In_ const double max_limit,
+        _In_ const double limit)
+    : _best_efficiency(0.0), _count(0), _direction(-1.0),
+        _efficiency(std::numeric_limits<double>::quiet_NaN()),
+        _governor(governor), _sum(0.0) {
+    if (!governor) {
+        throw std::invalid_argument("A power cap controller requires a "
+            "governor that changes the power limit.");
+    }
+
+    this->_min_limit = (std::max)(min_limit, governor.min_limit());
+    this->_max_limit = (governor.max_limit() > 0.0)
+        ? (std::min)(max_limit, governor.max_limit())
+        : max_limit;
+    if (this->_max_limit < this->_min_limit) {
+        throw std::invalid_argument("The range of power limits of the "
+            "governor does not overlap the one supported by the device.");
+    }
+
+    this->_step = (std::max)(governor.resolution(),
+        (this->_max_limit - this->_min_limit) / initial_steps);
+
+    // The efficiency search starts at the top, because this is where an
+    // application without limit runs.
+    this->_limit = (governor.mode() == power_governor_mode::maximise_efficiency)
+        ? this->_max_limit
+        : this->clamp(limit);
+    this->_best_limit = this->_limit;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::power_cap_controller::observe
+ */
+void visus::power_overwhelming::detail::power_cap_controller::observe(
+        _In_ const double power) noexcept {
+    if (std::isfinite(power) && (power >= 0.0)) {
+        this->_sum += power;
+        ++this->_count;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::power_cap_controller::update
+ */
+double visus::power_overwhelming::detail::power_cap_controller::update(void) {
+    if (this->_count == 0) {
+        return this->_limit;
+    }
+
+    const auto power = this->_sum / this->_count;
+    this->_count = 0;
+    this->_sum = 0.0;
+
+    switch (this->_governor.mode()) {
+        case power_governor_mode::hold_power:
+            this->_limit = this->clamp(this->_limit
+                + gain * (this->_governor.target() - power));
+            break;
+
+        case power_governor_mode::maximise_efficiency: {
+            const auto performance = this->_governor.performance()(
+                this->_governor.context());
+            if (!(performance >= 0.0) || !(power > 0.0)) {
+                // The application could not tell how it performed, so we
+                // repeat the measurement at the same limit.
+                break;
+            }
+
+            const auto efficiency = performance / power;
+            if (efficiency > this->_best_efficiency) {
+                this->_best_efficiency = efficiency;
+                this->_best_limit = this->_limit;
+            }
+
+            if (efficiency < this->_efficiency) {
+                // We went past the optimum, so turn around and refine.
+                this->_direction = -this->_direction;
+                this->_step = (std::max)(this->_governor.resolution(),
+                    0.5 * this->_step);
+            }
+            this->_efficiency = efficiency;
+
+            auto next = this->_limit + this->_direction * this->_step;
+            if ((next < this->_min_limit) || (next > this->_max_limit)) {
+                this->_direction = -this->_direction;
+                next = this->_limit + this->_direction * this->_step;
+            }
+            this->_limit = this->clamp(next);
+            } break;
+
+        default:
+            break;
+    }
+
+    return this->_limit;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::power_cap_controller::clamp
+ */
+double visus::power_overwhelming::detail::power_cap_controller::clamp(
+        _In_ const double limit) const noexcept {
+    return (std::min)((std::max)(limit, this->_min_limit), this->_max_limit);
+}
@@ -0,0 +1,139 @@
+﻿// <copyright file="power_cap_controller.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstddef>
+
+#include "power_overwhelming/power_governor.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Implements the control loop of a <see cref="power_governor" />
+    /// independently from the driver.
+    /// </summary>
+    /// <remarks>
+    /// <para>The owner feeds the power of each sample into the controller
+    /// and asks it for the next power limit at the end of each control
+    /// interval. The controller does not measure any time itself.</para>
+    /// <para>In <see cref="power_governor_mode::hold_power" />, the limit is
+    /// updated by an integral controller, which compensates the offset
+    /// between the limit and the power the device actually draws. In
+    /// <see cref="power_governor_mode::maximise_efficiency" />, the limit is
+    /// searched by perturb-and-observe hill climbing on the performance per
+    /// Watt.</para>
+    /// <para>The controller is not thread-safe.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API power_cap_controller final {
+
+    public:
+
+        /// <summary>
+        /// The fraction of the deviation from the target power that is
+        /// added to the limit in each control interval.
+        /// </summary>
+        static constexpr double gain = 0.5;
+
+        /// <summary>
+        /// The number of steps into which the range of the power limit is
+        /// divided for the first steps of the efficiency search.
+        /// </summary>
+        static constexpr double initial_steps = 4.0;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="governor">The description of the controller.</param>
+        /// <param name="min_limit">The smallest power limit the device
+        /// supports in Watts.</param>
+        /// <param name="max_limit">The largest power limit the device
+        /// supports in Watts.</param>
+        /// <param name="limit">The current power limit in Watts, which is
+        /// retained when holding a power.</param>
+        /// <exception cref="std::invalid_argument">If the governor is
+        /// <see cref="power_governor_mode::none" /> or if the bounds of the
+        /// governor do not overlap the ones of the device.</exception>
+        power_cap_controller(_In_ const power_governor& governor,
+            _In_ const double min_limit,
+            _In_ const double max_limit,
+            _In_ const double limit);
+
+        /// <summary>
+        /// Gets the limit at which the best efficiency has been observed.
+        /// </summary>
+        /// <returns>The best limit in Watts, or the current limit if the
+        /// controller does not search the efficiency or has not yet
+        /// completed a control interval.</returns>
+        inline double best_limit(void) const noexcept {
+            return this->_best_limit;
+        }
+
+        /// <summary>
+        /// Gets the current power limit.
+        /// </summary>
+        /// <returns>The limit in Watts.</returns>
+        inline double limit(void) const noexcept {
+            return this->_limit;
+        }
+
+        /// <summary>
+        /// Gets the largest limit the controller sets.
+        /// </summary>
+        /// <returns>The upper bound in Watts.</returns>
+        inline double max_limit(void) const noexcept {
+            return this->_max_limit;
+        }
+
+        /// <summary>
+        /// Gets the smallest limit the controller sets.
+        /// </summary>
+        /// <returns>The lower bound in Watts.</returns>
+        inline double min_limit(void) const noexcept {
+            return this->_min_limit;
+        }
+
+        /// <summary>
+        /// Adds the power of a sample to the current control interval.
+        /// </summary>
+        /// <param name="power">The power in Watts. Invalid values are
+        /// ignored.</param>
+        void observe(_In_ const double power) noexcept;
+
+        /// <summary>
+        /// Completes the current control interval and computes the next
+        /// power limit.
+        /// </summary>
+        /// <remarks>
+        /// When searching the efficiency, this method invokes the
+        /// performance callback of the governor. If no power has been
+        /// observed, the limit is retained.
+        /// </remarks>
+        /// <returns>The new power limit in Watts.</returns>
+        double update(void);
+
+    private:
+
+        double clamp(_In_ const double limit) const noexcept;
+
+        double _best_efficiency;
+        double _best_limit;
+        std::size_t _count;
+        double _direction;
+        double _efficiency;
+        power_governor _governor;
+        double _limit;
+        double _max_limit;
+        double _min_limit;
+        double _step;
+        double _sum;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
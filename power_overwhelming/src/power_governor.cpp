@@ -0,0 +1,115 @@
+﻿// <copyright file="power_governor.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/power_governor.h"
+
+#include <stdexcept>
+
+
+/*
+ * visus::power_overwhelming::power_governor::default_interval
+ */
+constexpr std::int64_t
+visus::power_overwhelming::power_governor::default_interval;
+
+
+/*
+ * visus::power_overwhelming::power_governor::hold_power
+ */
+visus::power_overwhelming::power_governor
+visus::power_overwhelming::power_governor::hold_power(
+        _In_ const double target) {
+    if (!(target > 0.0)) {
+        throw std::invalid_argument("The target power must be positive.");
+    }
+
+    power_governor retval;
+    retval._mode = power_governor_mode::hold_power;
+    retval._target = target;
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::power_governor::maximise_efficiency
+ */
+visus::power_overwhelming::power_governor
+visus::power_overwhelming::power_governor::maximise_efficiency(
+        _In_ const performance_callback performance,
+        _In_opt_ void *context) {
+    if (performance == nullptr) {
+        throw std::invalid_argument("The performance callback must be "
+            "valid.");
+    }
+
+    power_governor retval;
+    retval._context = context;
+    retval._mode = power_governor_mode::maximise_efficiency;
+    retval._performance = performance;
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::power_governor::power_governor
+ */
+visus::power_overwhelming::power_governor::power_governor(void) noexcept
+    : _context(nullptr), _interval(default_interval), _max_limit(0.0),
+    _min_limit(0.0), _mode(power_governor_mode::none),
+    _performance(nullptr), _resolution(5.0), _target(0.0) { }
+
+
+/*
+ * visus::power_overwhelming::power_governor::interval
+ */
+visus::power_overwhelming::power_governor&
+visus::power_overwhelming::power_governor::interval(
+        _In_ const std::int64_t interval) {
+    if (interval <= 0) {
+        throw std::invalid_argument("The control interval must be "
+            "positive.");
+    }
+
+    this->_interval = interval;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::power_governor::limits
+ */
+visus::power_overwhelming::power_governor&
+visus::power_overwhelming::power_governor::limits(
+        _In_ const double min_limit,
+        _In_ const double max_limit) {
+    if (!(min_limit >= 0.0) || !(max_limit >= 0.0)) {
+        throw std::invalid_argument("The bounds of the power limit must not "
+            "be negative.");
+    }
+    if ((max_limit > 0.0) && (max_limit < min_limit)) {
+        throw std::invalid_argument("The upper bound of the power limit must "
+            "not be smaller than the lower one.");
+    }
+
+    this->_max_limit = max_limit;
+    this->_min_limit = min_limit;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::power_governor::resolution
+ */
+visus::power_overwhelming::power_governor&
+visus::power_overwhelming::power_governor::resolution(
+        _In_ const double resolution) {
+    if (!(resolution > 0.0)) {
+        throw std::invalid_argument("The resolution of the efficiency search "
+            "must be positive.");
+    }
+
+    this->_resolution = resolution;
+    return *this;
+}
@@ -0,0 +1,182 @@
+﻿// <copyright file="power_model.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_model.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+/*
+ * visus::power_overwhelming::detail::power_model::confidence_factor
+ */
+constexpr double
+visus::power_overwhelming::detail::power_model::confidence_factor;
+
+
+/*
+ * visus::power_overwhelming::detail::power_model::feature_count
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::power_model::feature_count;
+
+
+/*
+ * visus::power_overwhelming::detail::power_model::forgetting_factor
+ */
+constexpr double
+visus::power_overwhelming::detail::power_model::forgetting_factor;
+
+
+/*
+ * visus::power_overwhelming::detail::power_model::initial_covariance
+ */
+constexpr double
+visus::power_overwhelming::detail::power_model::initial_covariance;
+
+
+/*
+ * visus::power_overwhelming::detail::power_model::min_updates
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::power_model::min_updates;
+
+
+/*
+ * visus::power_overwhelming::detail::power_model::features
+ */
+visus::power_overwhelming::detail::power_model::features_type
+visus::power_overwhelming::detail::power_model::features(
+        _In_ const double gpu_utilisation,
+        _In_ const double memory_utilisation,
+        _In_ const double graphics_clock,
+        _In_ const double memory_clock) noexcept {
+    // The clocks are scaled to Gigahertz such that all regressors are of the
+    // same order of magnitude as the utilisation.
+    const auto graphics = graphics_clock / 1e9;
+    const auto memory = memory_clock / 1e9;
+    return features_type {
+        1.0,
+        gpu_utilisation,
+        memory_utilisation,
+        graphics,
+        memory,
+        gpu_utilisation * graphics
+    };
+}
+
+
+/*
+ * visus::power_overwhelming::detail::power_model::power_model
+ */
+visus::power_overwhelming::detail::power_model::power_model(void) noexcept {
+    this->reset();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::power_model::predict
+ */
+bool visus::power_overwhelming::detail::power_model::predict(
+        _Out_ double& power, _Out_ double& lower, _Out_ double& upper,
+        _In_ const features_type& features) const noexcept {
+    if (this->_updates < min_updates) {
+        return false;
+    }
+
+    // The variance of the prediction comprises the residual noise and the
+    // uncertainty of the weights in the direction of the regressors, which
+    // is large if the GPU has never been observed in a similar state.
+    auto estimate = 0.0;
+    auto leverage = 0.0;
+    for (std::size_t r = 0; r < feature_count; ++r) {
+        auto p = 0.0;
+        for (std::size_t c = 0; c < feature_count; ++c) {
+            p += this->_covariance[r * feature_count + c] * features[c];
+        }
+
+        estimate += this->_weights[r] * features[r];
+        leverage += features[r] * p;
+    }
+
+    const auto deviation = std::sqrt(this->_residual
+        * (1.0 + (std::max)(leverage, 0.0)));
+    power = estimate;
+    lower = estimate - confidence_factor * deviation;
+    upper = estimate + confidence_factor * deviation;
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::power_model::reset
+ */
+void visus::power_overwhelming::detail::power_model::reset(void) noexcept {
+    this->_covariance.fill(0.0);
+    for (std::size_t i = 0; i < feature_count; ++i) {
+        this->_covariance[i * feature_count + i] = initial_covariance;
+    }
+    this->_residual = 0.0;
+    this->_updates = 0;
+    this->_weights.fill(0.0);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::power_model::update
+ */
+void visus::power_overwhelming::detail::power_model::update(
+        _In_ const features_type& features,
+        _In_ const double power) noexcept {
+    features_type gain;
+    auto error = power;
+    auto norm = forgetting_factor;
+
+    for (std::size_t r = 0; r < feature_count; ++r) {
+        gain[r] = 0.0;
+        for (std::size_t c = 0; c < feature_count; ++c) {
+            gain[r] += this->_covariance[r * feature_count + c] * features[c];
+        }
+
+        error -= this->_weights[r] * features[r];
+        norm += features[r] * gain[r];
+    }
+
+    // The residual variance is estimated from the a-priori errors, which are
+    // normalised by their expected variance such that the large errors of an
+    // untrained model do not dominate. The plain mean is used until the
+    // exponential window is filled.
+    ++this->_updates;
+    const auto alpha = (std::max)(1.0 - forgetting_factor,
+        1.0 / static_cast<double>(this->_updates));
+    const auto residual = error * error * forgetting_factor / norm;
+    this->_residual += alpha * (residual - this->_residual);
+
+    for (std::size_t r = 0; r < feature_count; ++r) {
+        this->_weights[r] += gain[r] / norm * error;
+    }
+
+    // Update the inverse of the correlation matrix and keep it symmetric,
+    // which rounding errors would otherwise destroy over time.
+    auto trace = 0.0;
+    for (std::size_t r = 0; r < feature_count; ++r) {
+        for (std::size_t c = r; c < feature_count; ++c) {
+            const auto i = r * feature_count + c;
+            const auto v = this->_covariance[i] - gain[r] * gain[c] / norm;
+            this->_covariance[i] = v;
+            this->_covariance[c * feature_count + r] = v;
+        }
+        trace += this->_covariance[r * feature_count + r];
+    }
+
+    // If the GPU stays in the same state, forgetting would inflate the
+    // matrix in all directions that are not excited without bound, so we
+    // only forget while the uncertainty is below its initial value.
+    if (trace < feature_count * initial_covariance) {
+        for (auto& c : this->_covariance) {
+            c /= forgetting_factor;
+        }
+    }
+}
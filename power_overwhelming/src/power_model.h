@@ -0,0 +1,140 @@
+﻿// <copyright file="power_model.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A linear model of the power of a GPU as a function of its utilisation
+    /// and clocks, which is fitted online by recursive least squares.
+    /// </summary>
+    /// <remarks>
+    /// <para>The model is meant for upsampling a power reading that the
+    /// driver updates slowly using activity counters that change quickly.
+    /// Each time the driver publishes a new power reading, the model is
+    /// updated with the mean of the features observed since the previous
+    /// reading, because the driver averages the power over this period. The
+    /// model can then predict the power from every single observation of the
+    /// features.</para>
+    /// <para>Older observations are forgotten exponentially such that the
+    /// model follows changes of the temperature and the voltage, which are
+    /// not part of the features.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API power_model final {
+
+    public:
+
+        /// <summary>
+        /// The number of regressors in the model, including the intercept.
+        /// </summary>
+        static constexpr std::size_t feature_count = 6;
+
+        /// <summary>
+        /// The type of a vector of regressors.
+        /// </summary>
+        typedef std::array<double, feature_count> features_type;
+
+        /// <summary>
+        /// The factor by which the standard deviation of a prediction is
+        /// multiplied to obtain its bounds, which corresponds to a 95 %
+        /// interval.
+        /// </summary>
+        static constexpr double confidence_factor = 1.96;
+
+        /// <summary>
+        /// The weight of the previous observations when a new one is added.
+        /// </summary>
+        static constexpr double forgetting_factor = 0.999;
+
+        /// <summary>
+        /// The number of updates before the model makes predictions.
+        /// </summary>
+        static constexpr std::size_t min_updates = 2 * feature_count;
+
+        /// <summary>
+        /// Creates the regressors from the activity of a GPU.
+        /// </summary>
+        /// <param name="gpu_utilisation">The fraction of time the GPU was
+        /// busy within [0, 1].</param>
+        /// <param name="memory_utilisation">The fraction of time the memory
+        /// was read or written within [0, 1].</param>
+        /// <param name="graphics_clock">The graphics clock in Hertz.</param>
+        /// <param name="memory_clock">The memory clock in Hertz.</param>
+        /// <returns>The regressors, which include the intercept and the
+        /// product of utilisation and graphics clock, because the dynamic
+        /// power scales with both.</returns>
+        static features_type features(_In_ const double gpu_utilisation,
+            _In_ const double memory_utilisation,
+            _In_ const double graphics_clock,
+            _In_ const double memory_clock) noexcept;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        power_model(void) noexcept;
+
+        /// <summary>
+        /// Predicts the power for the given regressors.
+        /// </summary>
+        /// <param name="power">Receives the estimated power.</param>
+        /// <param name="lower">Receives the lower bound of the power.</param>
+        /// <param name="upper">Receives the upper bound of the power.</param>
+        /// <param name="features">The regressors to predict the power for.
+        /// </param>
+        /// <returns><c>true</c> if the model has been updated often enough to
+        /// make a prediction, <c>false</c> otherwise, in which case the
+        /// output parameters are not modified.</returns>
+        bool predict(_Out_ double& power, _Out_ double& lower,
+            _Out_ double& upper,
+            _In_ const features_type& features) const noexcept;
+
+        /// <summary>
+        /// Forgets everything that has been learned.
+        /// </summary>
+        void reset(void) noexcept;
+
+        /// <summary>
+        /// Adds an observation to the model.
+        /// </summary>
+        /// <param name="features">The regressors observed.</param>
+        /// <param name="power">The power observed for the regressors.</param>
+        void update(_In_ const features_type& features,
+            _In_ const double power) noexcept;
+
+        /// <summary>
+        /// Answer the number of observations added since the model has been
+        /// created or reset.
+        /// </summary>
+        /// <returns>The number of updates.</returns>
+        inline std::size_t updates(void) const noexcept {
+            return this->_updates;
+        }
+
+    private:
+
+        /// <summary>
+        /// The initial diagonal of the <see cref="_covariance" />, which
+        /// reflects that nothing is known about the weights.
+        /// </summary>
+        static constexpr double initial_covariance = 1000.0;
+
+        std::array<double, feature_count * feature_count> _covariance;
+        double _residual;
+        std::size_t _updates;
+        features_type _weights;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
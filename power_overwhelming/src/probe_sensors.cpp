@@ -0,0 +1,82 @@
+﻿// <copyright file="probe_sensors.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/probe_sensors.h"
+
+#include <fstream>
+
+#include "power_overwhelming/convert_string.h"
+
+#include "sensor_capability.h"
+#include "sensor_utilities.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Probes all sensors accepted by <paramref name="filter" /> and writes
+    /// the report to <paramref name="stream" />.
+    /// </summary>
+    static std::size_t probe_sensors(_In_ std::ostream& stream,
+            _In_ const sensor_filter& filter,
+            _In_ const sensor::microseconds_type duration) {
+        const auto sensors = get_all_sensors(filter);
+        std::vector<sensor_capability> capabilities;
+        capabilities.reserve(sensors.size());
+
+        // The sensors are probed one after the other such that they do not
+        // compete for the bus or the driver.
+        for (auto& s : sensors) {
+            capabilities.push_back(probe_capability(*s,
+                std::chrono::microseconds(duration)));
+        }
+
+        write_capability_report(stream, capabilities);
+        return capabilities.size();
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::probe_sensors
+ */
+std::size_t visus::power_overwhelming::probe_sensors(_In_z_ const char *path,
+        _In_ const sensor_filter& filter,
+        _In_ const sensor::microseconds_type duration) {
+    std::ofstream s;
+    s.exceptions(s.exceptions() | std::ios::failbit | std::ios::badbit);
+    s.open(path, std::ofstream::out | std::ofstream::trunc);
+    const auto retval = detail::probe_sensors(s, filter, duration);
+    s.flush();
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::probe_sensors
+ */
+std::size_t visus::power_overwhelming::probe_sensors(
+        _In_z_ const wchar_t *path,
+        _In_ const sensor_filter& filter,
+        _In_ const sensor::microseconds_type duration) {
+    std::ofstream s;
+    s.exceptions(s.exceptions() | std::ios::failbit | std::ios::badbit);
+
+#if defined(_WIN32)
+    s.open(path, std::ofstream::out | std::ofstream::trunc);
+#else /* defined(_WIN32) */
+    auto p = power_overwhelming::convert_string<char>(path);
+    s.open(p, std::ofstream::out | std::ofstream::trunc);
+#endif /* defined(_WIN32) */
+
+    const auto retval = detail::probe_sensors(s, filter, duration);
+    s.flush();
+    return retval;
+}
@@ -0,0 +1,13 @@
+﻿// <copyright file="process_energy.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/process_energy.h"
+
+
+/*
+ * visus::power_overwhelming::process_energy::idle
+ */
+constexpr visus::power_overwhelming::process_energy::pid_type
+visus::power_overwhelming::process_energy::idle;
@@ -0,0 +1,132 @@
+﻿// <copyright file="process_energy_integrator.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "process_energy_integrator.h"
+
+#include <cmath>
+#include <limits>
+
+#include "power_overwhelming/convert_string.h"
+
+
+/*
+ * visus::power_overwhelming::detail::process_energy_integrator::push
+ */
+void visus::power_overwhelming::detail::process_energy_integrator::push(
+        _In_ const double power,
+        _In_ const double seconds) noexcept {
+    if (!std::isfinite(power) || !(power >= 0.0) || !(seconds > 0.0)) {
+        return;
+    }
+
+    const auto energy = power * seconds;
+
+    if (this->_shares.empty()) {
+        auto& e = this->_energies[process_energy::idle];
+        e.first += energy;
+        e.second += seconds;
+
+    } else {
+        for (auto& s : this->_shares) {
+            auto& e = this->_energies[s.first];
+            e.first += s.second * energy;
+            e.second += seconds;
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::process_energy_integrator::reset
+ */
+void visus::power_overwhelming::detail::process_energy_integrator::reset(
+        void) noexcept {
+    this->_energies.clear();
+    this->_shares.clear();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::process_energy_integrator::summary
+ */
+std::vector<visus::power_overwhelming::process_energy>
+visus::power_overwhelming::detail::process_energy_integrator::summary(
+        void) const {
+    std::vector<process_energy> retval;
+    retval.reserve(this->_energies.size());
+
+    for (auto& e : this->_energies) {
+        retval.emplace_back(e.first, e.second.first, e.second.second);
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::process_energy_integrator::update
+ */
+void visus::power_overwhelming::detail::process_energy_integrator::update(
+        _In_reads_(cnt) const utilisation_type *utilisation,
+        _In_ const std::size_t cnt) {
+    // The driver may report several samples of a process if we query less
+    // frequently than it updates the utilisation, so we average them.
+    std::map<pid_type, std::pair<double, std::size_t>> weights;
+    for (std::size_t i = 0; (utilisation != nullptr) && (i < cnt); ++i) {
+        auto& w = weights[utilisation[i].pid];
+        w.first += utilisation[i].sm + utilisation[i].memory;
+        ++w.second;
+    }
+
+    auto total = 0.0;
+    for (auto& w : weights) {
+        w.second.first /= w.second.second;
+        total += w.second.first;
+    }
+
+    this->_shares.clear();
+    if (total > 0.0) {
+        for (auto& w : weights) {
+            if (w.second.first > 0.0) {
+                this->_shares.emplace_back(w.first, w.second.first / total);
+            }
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::write_process_energy
+ */
+std::ostream& visus::power_overwhelming::detail::write_process_energy(
+        _Inout_ std::ostream& stream,
+        _In_ const std::map<std::wstring, std::vector<process_energy>>&
+        energies) {
+    const auto precision = stream.precision(
+        std::numeric_limits<double>::max_digits10);
+    stream << "sensor,pid,duration,energy\n";
+
+    for (auto& s : energies) {
+        const auto sensor = power_overwhelming::convert_string<char>(s.first);
+
+        for (auto& e : s.second) {
+            stream << '"';
+            for (auto c : sensor) {
+                if (c == '"') {
+                    stream << '"';
+                }
+                stream << c;
+            }
+            stream << '"'
+                << ',' << e.pid()
+                << ',' << e.duration()
+                << ',' << e.energy()
+                << '\n';
+        }
+    }
+
+    stream.precision(precision);
+    return stream;
+}
@@ -0,0 +1,124 @@
+﻿// <copyright file="process_energy_integrator.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "power_overwhelming/process_energy.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Splits the energy of a GPU between the processes using it according
+    /// to their utilisation of the GPU.
+    /// </summary>
+    /// <remarks>
+    /// <para>The driver reports the utilisation per process at a lower rate
+    /// than the power is sampled. The integrator therefore keeps the most
+    /// recent shares of the processes and applies them to all power samples
+    /// until the next utilisation is reported.</para>
+    /// <para>The share of a process is the sum of its SM and memory
+    /// utilisation relative to the sum over all processes, i.e. the whole
+    /// energy of the board including its static power is distributed.
+    /// Energy consumed while no process is utilising the GPU is attributed
+    /// to <see cref="process_energy::idle" />.</para>
+    /// <para>The integrator is not thread-safe.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API process_energy_integrator final {
+
+    public:
+
+        /// <summary>
+        /// The type of a process ID.
+        /// </summary>
+        typedef process_energy::pid_type pid_type;
+
+        /// <summary>
+        /// The utilisation of the GPU by a single process.
+        /// </summary>
+        struct utilisation_type {
+
+            /// <summary>
+            /// The utilisation of the memory in percent.
+            /// </summary>
+            unsigned int memory;
+
+            /// <summary>
+            /// The ID of the process.
+            /// </summary>
+            pid_type pid;
+
+            /// <summary>
+            /// The utilisation of the streaming multiprocessors in percent.
+            /// </summary>
+            unsigned int sm;
+        };
+
+        /// <summary>
+        /// Adds the energy of a period to the processes according to their
+        /// current shares.
+        /// </summary>
+        /// <param name="power">The average power in Watts during the period.
+        /// Invalid values are ignored.</param>
+        /// <param name="seconds">The length of the period in seconds.</param>
+        void push(_In_ const double power, _In_ const double seconds) noexcept;
+
+        /// <summary>
+        /// Forgets all energies and shares.
+        /// </summary>
+        void reset(void) noexcept;
+
+        /// <summary>
+        /// Answer the energy per process.
+        /// </summary>
+        /// <returns>The energy of all processes that have been attributed
+        /// any energy, ordered by process ID.</returns>
+        std::vector<process_energy> summary(void) const;
+
+        /// <summary>
+        /// Replaces the shares of the processes with new utilisation reported
+        /// by the driver.
+        /// </summary>
+        /// <remarks>
+        /// If a process occurs multiple times, its utilisation is averaged.
+        /// </remarks>
+        /// <param name="utilisation">The utilisation of the processes.
+        /// </param>
+        /// <param name="cnt">The number of elements in
+        /// <paramref name="utilisation" />.</param>
+        void update(_In_reads_(cnt) const utilisation_type *utilisation,
+            _In_ const std::size_t cnt);
+
+    private:
+
+        std::map<pid_type, std::pair<double, double>> _energies;
+        std::vector<std::pair<pid_type, double>> _shares;
+    };
+
+    /// <summary>
+    /// Writes the energy per process as CSV table with the columns
+    /// <c>sensor</c>, <c>pid</c>, <c>duration</c> and <c>energy</c>.
+    /// </summary>
+    /// <param name="stream">The stream to write to.</param>
+    /// <param name="energies">The energies per process for each sensor
+    /// name.</param>
+    /// <returns><paramref name="stream" />.</returns>
+    POWER_OVERWHELMING_API std::ostream& write_process_energy(
+        _Inout_ std::ostream& stream,
+        _In_ const std::map<std::wstring, std::vector<process_energy>>&
+        energies);
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
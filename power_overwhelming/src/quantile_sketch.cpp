@@ -0,0 +1,243 @@
+﻿// <copyright file="quantile_sketch.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "quantile_sketch.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+
+/*
+ * visus::power_overwhelming::detail::quantile_sketch::default_accuracy
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::quantile_sketch::default_accuracy;
+
+
+/*
+ * visus::power_overwhelming::detail::quantile_sketch::quantile_sketch
+ */
+visus::power_overwhelming::detail::quantile_sketch::quantile_sketch(
+        _In_ const std::size_t accuracy)
+        : _accuracy(accuracy), _capacity(0), _count(0), _levels(1),
+        _maximum(std::numeric_limits<float>::quiet_NaN()),
+        _minimum(std::numeric_limits<float>::quiet_NaN()),
+        _odd(false), _retained(0) {
+    if (accuracy < 2) {
+        throw std::invalid_argument("The accuracy of a quantile sketch must "
+            "be at least two.");
+    }
+
+    this->_capacity = this->capacity(0);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::quantile_sketch::maximum
+ */
+float visus::power_overwhelming::detail::quantile_sketch::maximum(
+        void) const noexcept {
+    return this->_maximum;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::quantile_sketch::merge
+ */
+void visus::power_overwhelming::detail::quantile_sketch::merge(
+        _In_ const quantile_sketch& other) {
+    if ((&other == this) || (other._count == 0)) {
+        return;
+    }
+
+    if (other._levels.size() > this->_levels.size()) {
+        this->_levels.resize(other._levels.size());
+        this->_capacity = 0;
+        for (std::size_t l = 0; l < this->_levels.size(); ++l) {
+            this->_capacity += this->capacity(l);
+        }
+    }
+
+    for (std::size_t l = 0; l < other._levels.size(); ++l) {
+        auto& src = other._levels[l];
+        this->_levels[l].insert(this->_levels[l].end(), src.begin(),
+            src.end());
+    }
+    this->_retained += other._retained;
+
+    if (this->_count == 0) {
+        this->_maximum = other._maximum;
+        this->_minimum = other._minimum;
+    } else {
+        this->_maximum = (std::max)(this->_maximum, other._maximum);
+        this->_minimum = (std::min)(this->_minimum, other._minimum);
+    }
+    this->_count += other._count;
+
+    this->compress();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::quantile_sketch::minimum
+ */
+float visus::power_overwhelming::detail::quantile_sketch::minimum(
+        void) const noexcept {
+    return this->_minimum;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::quantile_sketch::push
+ */
+void visus::power_overwhelming::detail::quantile_sketch::push(
+        _In_ const float value) {
+    if (std::isnan(value)) {
+        return;
+    }
+
+    if (this->_count == 0) {
+        this->_maximum = value;
+        this->_minimum = value;
+    } else if (value > this->_maximum) {
+        this->_maximum = value;
+    } else if (value < this->_minimum) {
+        this->_minimum = value;
+    }
+    ++this->_count;
+
+    this->_levels.front().push_back(value);
+    if (++this->_retained >= this->_capacity) {
+        this->compress();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::quantile_sketch::quantile
+ */
+float visus::power_overwhelming::detail::quantile_sketch::quantile(
+        _In_ const double q) const {
+    float retval;
+    this->quantiles(&retval, &q, 1);
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::quantile_sketch::quantiles
+ */
+void visus::power_overwhelming::detail::quantile_sketch::quantiles(
+        _Out_writes_(cnt) float *dst,
+        _In_reads_(cnt) const double *q,
+        _In_ const std::size_t cnt) const {
+    assert((dst != nullptr) || (cnt == 0));
+    assert((q != nullptr) || (cnt == 0));
+
+    if (this->_count == 0) {
+        std::fill(dst, dst + cnt, std::numeric_limits<float>::quiet_NaN());
+        return;
+    }
+
+    // Each value represents 2^level values of the input, and the weights add
+    // up to the number of inputs, because the levels are halved exactly.
+    std::vector<std::pair<float, std::uint64_t>> values;
+    values.reserve(this->_retained);
+    for (std::size_t l = 0; l < this->_levels.size(); ++l) {
+        for (auto v : this->_levels[l]) {
+            values.emplace_back(v, std::uint64_t(1) << l);
+        }
+    }
+    std::sort(values.begin(), values.end());
+
+    std::size_t v = 0;
+    std::uint64_t rank = values.front().second;
+    for (std::size_t i = 0; i < cnt; ++i) {
+        if (!(q[i] > 0.0)) {
+            dst[i] = this->_minimum;
+            continue;
+        }
+        if (!(q[i] < 1.0)) {
+            dst[i] = this->_maximum;
+            continue;
+        }
+
+        const auto target = q[i] * static_cast<double>(this->_count);
+        while ((static_cast<double>(rank) < target)
+                && (v + 1 < values.size())) {
+            rank += values[++v].second;
+        }
+        dst[i] = values[v].first;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::quantile_sketch::retained
+ */
+std::size_t visus::power_overwhelming::detail::quantile_sketch::retained(
+        void) const noexcept {
+    return this->_retained;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::quantile_sketch::capacity
+ */
+std::size_t visus::power_overwhelming::detail::quantile_sketch::capacity(
+        _In_ const std::size_t level) const noexcept {
+    // The top level has the full capacity, and each level below two thirds
+    // of the one above, but at least two values to be compacted.
+    assert(level < this->_levels.size());
+    const auto depth = this->_levels.size() - level - 1;
+    const auto retval = static_cast<std::size_t>(std::ceil(
+        this->_accuracy * std::pow(2.0 / 3.0, static_cast<double>(depth))));
+    return (std::max)(retval, std::size_t(2));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::quantile_sketch::compress
+ */
+void visus::power_overwhelming::detail::quantile_sketch::compress(void) {
+    // Compaction is lazy: As long as the sketch as a whole is within its
+    // capacity, levels may overflow, which retains more values and therefore
+    // improves the accuracy for the same bound on the memory.
+    while (this->_retained >= this->_capacity) {
+        std::size_t l = 0;
+        while (this->_levels[l].size() < this->capacity(l)) {
+            ++l;
+        }
+
+        if (l + 1 == this->_levels.size()) {
+            // Adding a level changes the capacities of all levels below.
+            this->_levels.emplace_back();
+            this->_capacity = 0;
+            for (std::size_t c = 0; c < this->_levels.size(); ++c) {
+                this->_capacity += this->capacity(c);
+            }
+        }
+
+        auto& src = this->_levels[l];
+        auto& dst = this->_levels[l + 1];
+        std::sort(src.begin(), src.end());
+
+        // An odd value out remains on its level such that the weights are
+        // preserved. Alternating the promoted half makes the errors cancel
+        // out rather than accumulate.
+        const auto end = src.size() & ~std::size_t(1);
+        for (std::size_t i = this->_odd ? 1 : 0; i < end; i += 2) {
+            dst.push_back(src[i]);
+        }
+        this->_odd = !this->_odd;
+
+        src.erase(src.begin(), src.begin() + end);
+        this->_retained -= end / 2;
+    }
+}
@@ -0,0 +1,136 @@
+﻿// <copyright file="quantile_sketch.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <vector>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A mergeable streaming sketch of the distribution of a value, which
+    /// answers quantiles with bounded memory.
+    /// </summary>
+    /// <remarks>
+    /// <para>The sketch is a deterministic variant of the KLL sketch: Values
+    /// are collected in a hierarchy of levels, where a value on level
+    /// <c>h</c> represents <c>2^h</c> values of the input. If a level exceeds
+    /// its capacity, it is sorted and every other value is promoted to the
+    /// next level, alternating between the even and the odd ones. The
+    /// capacities shrink geometrically from the top level, such that the
+    /// sketch retains <c>O(k log(n / k))</c> values for <c>n</c> inputs.
+    /// The rank error is in the order of <c>1 / k</c>.</para>
+    /// <para>Minimum and maximum are tracked exactly.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API quantile_sketch final {
+
+    public:
+
+        /// <summary>
+        /// The capacity of the top level used unless specified otherwise,
+        /// which yields a rank error of about one percent.
+        /// </summary>
+        static constexpr std::size_t default_accuracy = 200;
+
+        /// <summary>
+        /// Initialises a new, empty instance.
+        /// </summary>
+        /// <param name="accuracy">The capacity <c>k</c> of the top level,
+        /// which determines the trade-off between accuracy and memory.
+        /// </param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="accuracy" /> is less than two.</exception>
+        explicit quantile_sketch(
+            _In_ const std::size_t accuracy = default_accuracy);
+
+        /// <summary>
+        /// Answer the number of values added to the sketch.
+        /// </summary>
+        /// <returns>The number of values.</returns>
+        inline std::uint64_t count(void) const noexcept {
+            return this->_count;
+        }
+
+        /// <summary>
+        /// Answer the largest value added to the sketch.
+        /// </summary>
+        /// <returns>The maximum, or NaN if the sketch is empty.</returns>
+        float maximum(void) const noexcept;
+
+        /// <summary>
+        /// Adds the values summarised by another sketch.
+        /// </summary>
+        /// <remarks>
+        /// The result has the same accuracy as if all values had been added
+        /// to this sketch. Sketches of different accuracy can be merged, but
+        /// the result has the accuracy of this sketch.
+        /// </remarks>
+        /// <param name="other">The sketch to be merged.</param>
+        void merge(_In_ const quantile_sketch& other);
+
+        /// <summary>
+        /// Answer the smallest value added to the sketch.
+        /// </summary>
+        /// <returns>The minimum, or NaN if the sketch is empty.</returns>
+        float minimum(void) const noexcept;
+
+        /// <summary>
+        /// Adds a value to the sketch.
+        /// </summary>
+        /// <param name="value">The value to be added. NaN is ignored.</param>
+        void push(_In_ const float value);
+
+        /// <summary>
+        /// Estimates the given quantile.
+        /// </summary>
+        /// <param name="q">The quantile, which is clamped to [0, 1]. Zero
+        /// yields the <see cref="minimum" />, one the
+        /// <see cref="maximum" />.</param>
+        /// <returns>The estimated quantile, or NaN if the sketch is empty.
+        /// </returns>
+        float quantile(_In_ const double q) const;
+
+        /// <summary>
+        /// Estimates multiple quantiles at once, which only sorts the sketch
+        /// once.
+        /// </summary>
+        /// <param name="dst">Receives the estimates.</param>
+        /// <param name="q">The quantiles in ascending order.</param>
+        /// <param name="cnt">The number of quantiles.</param>
+        void quantiles(_Out_writes_(cnt) float *dst,
+            _In_reads_(cnt) const double *q,
+            _In_ const std::size_t cnt) const;
+
+        /// <summary>
+        /// Answer the number of values the sketch retains.
+        /// </summary>
+        /// <returns>The number of values in memory.</returns>
+        std::size_t retained(void) const noexcept;
+
+    private:
+
+        std::size_t capacity(_In_ const std::size_t level) const noexcept;
+
+        void compress(void);
+
+        std::size_t _accuracy;
+        std::size_t _capacity;
+        std::uint64_t _count;
+        std::vector<std::vector<float>> _levels;
+        float _maximum;
+        float _minimum;
+        bool _odd;
+        std::size_t _retained;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,256 @@
+﻿// <copyright file="replay_sensor.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/replay_sensor.h"
+
+#include <cassert>
+#include <memory>
+#include <stdexcept>
+
+#include "replay_sensor_impl.h"
+#include "timestamp.h"
+
+
+/*
+ * visus::power_overwhelming::replay_sensor::as_fast_as_possible
+ */
+constexpr double visus::power_overwhelming::replay_sensor::as_fast_as_possible;
+
+
+/*
+ * visus::power_overwhelming::replay_sensor::real_time
+ */
+constexpr double visus::power_overwhelming::replay_sensor::real_time;
+
+
+/*
+ * visus::power_overwhelming::replay_sensor::for_all
+ */
+std::size_t visus::power_overwhelming::replay_sensor::for_all(
+        _Out_writes_opt_(cnt_sensors) replay_sensor *out_sensors,
+        _In_ const std::size_t cnt_sensors) {
+    return 0;
+}
+
+
+/*
+ * visus::power_overwhelming::replay_sensor::replay_sensor
+ */
+visus::power_overwhelming::replay_sensor::replay_sensor(void)
+    : _impl(new detail::replay_sensor_impl()) { }
+
+
+/*
+ * visus::power_overwhelming::replay_sensor::replay_sensor
+ */
+visus::power_overwhelming::replay_sensor::replay_sensor(
+        _In_z_ const wchar_t *path,
+        _In_z_ const wchar_t *name)
+        : _impl(nullptr) {
+    if (path == nullptr) {
+        throw std::invalid_argument("The path to the recorded trace must not "
+            "be null.");
+    }
+    if ((name == nullptr) || (*name == 0)) {
+        throw std::invalid_argument("The name of the sensor to be replayed "
+            "must not be empty.");
+    }
+
+    std::unique_ptr<detail::replay_sensor_impl> impl(
+        new detail::replay_sensor_impl());
+    impl->path = path;
+    impl->sensor_name = name;
+    impl->load();
+    this->_impl = impl.release();
+}
+
+
+/*
+ * visus::power_overwhelming::replay_sensor::~replay_sensor
+ */
+visus::power_overwhelming::replay_sensor::~replay_sensor(void) {
+    // Make sure that neither the dedicated thread nor the generic sampler
+    // thread use the sensor anymore.
+    this->sample_batch(nullptr);
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::replay_sensor::loop
+ */
+bool visus::power_overwhelming::replay_sensor::loop(void) const {
+    this->check_not_disposed();
+    return this->_impl->loop;
+}
+
+
+/*
+ * visus::power_overwhelming::replay_sensor::loop
+ */
+visus::power_overwhelming::replay_sensor&
+visus::power_overwhelming::replay_sensor::loop(_In_ const bool loop) {
+    this->check_not_disposed();
+    this->_impl->loop = loop;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::replay_sensor::name
+ */
+_Ret_maybenull_z_
+const wchar_t *visus::power_overwhelming::replay_sensor::name(
+        void) const noexcept {
+    return (this->_impl != nullptr)
+        ? this->_impl->sensor_name.c_str()
+        : nullptr;
+}
+
+
+/*
+ * visus::power_overwhelming::replay_sensor::native_interval
+ */
+visus::power_overwhelming::sensor::microseconds_type
+visus::power_overwhelming::replay_sensor::native_interval(void) const {
+    this->check_not_disposed();
+    const auto tps = detail::ticks_per_second(this->_impl->resolution);
+    return static_cast<microseconds_type>(this->_impl->interval()
+        * 1000000.0 / tps);
+}
+
+
+/*
+ * visus::power_overwhelming::replay_sensor::path
+ */
+_Ret_maybenull_z_
+const wchar_t *visus::power_overwhelming::replay_sensor::path(
+        void) const noexcept {
+    return (this->_impl != nullptr)
+        ? this->_impl->path.c_str()
+        : nullptr;
+}
+
+
+/*
+ * visus::power_overwhelming::replay_sensor::rebase
+ */
+bool visus::power_overwhelming::replay_sensor::rebase(void) const {
+    this->check_not_disposed();
+    return this->_impl->rebase;
+}
+
+
+/*
+ * visus::power_overwhelming::replay_sensor::rebase
+ */
+visus::power_overwhelming::replay_sensor&
+visus::power_overwhelming::replay_sensor::rebase(_In_ const bool rebase) {
+    this->check_not_disposed();
+    this->_impl->rebase = rebase;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::replay_sensor::replayed
+ */
+std::size_t visus::power_overwhelming::replay_sensor::replayed(void) const {
+    this->check_not_disposed();
+    return this->_impl->replayed.load(std::memory_order_acquire);
+}
+
+
+/*
+ * visus::power_overwhelming::replay_sensor::sample_batch
+ */
+void visus::power_overwhelming::replay_sensor::sample_batch(
+        _In_opt_ const measurement_data_callback on_batch,
+        _In_ const microseconds_type period,
+        _In_opt_ void *context) {
+    if (on_batch != nullptr) {
+        this->check_not_disposed();
+
+        // The recorded spacing of the samples determines when they are
+        // delivered, so the requested period is irrelevant.
+        if (!this->_impl->start(on_batch, context)) {
+            throw std::logic_error("Asynchronous sampling cannot be started "
+                "while it is already running.");
+        }
+
+    } else if (this->_impl != nullptr) {
+        this->_impl->stop();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::replay_sensor::samples
+ */
+std::size_t visus::power_overwhelming::replay_sensor::samples(void) const {
+    this->check_not_disposed();
+    return this->_impl->samples.size();
+}
+
+
+/*
+ * visus::power_overwhelming::replay_sensor::speed
+ */
+double visus::power_overwhelming::replay_sensor::speed(void) const {
+    this->check_not_disposed();
+    return this->_impl->speed;
+}
+
+
+/*
+ * visus::power_overwhelming::replay_sensor::speed
+ */
+visus::power_overwhelming::replay_sensor&
+visus::power_overwhelming::replay_sensor::speed(_In_ const double speed) {
+    if (!(speed >= 0.0)) {
+        throw std::invalid_argument("The speed of a replay must not be "
+            "negative.");
+    }
+
+    this->check_not_disposed();
+    this->_impl->speed = speed;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::replay_sensor::operator =
+ */
+visus::power_overwhelming::replay_sensor&
+visus::power_overwhelming::replay_sensor::operator =(
+        _In_ replay_sensor&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        this->sample_batch(nullptr);
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::replay_sensor::operator bool
+ */
+visus::power_overwhelming::replay_sensor::operator bool(void) const noexcept {
+    return ((this->_impl != nullptr) && !this->_impl->samples.empty());
+}
+
+
+/*
+ * visus::power_overwhelming::replay_sensor::sample_sync
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::replay_sensor::sample_sync(
+        _In_ const timestamp_resolution resolution) const {
+    this->check_not_disposed();
+    return this->_impl->sample_sync(resolution);
+}
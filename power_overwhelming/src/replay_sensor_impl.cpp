@@ -0,0 +1,458 @@
+﻿// <copyright file="replay_sensor_impl.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "replay_sensor_impl.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include "power_overwhelming/binary_output_reader.h"
+#include "power_overwhelming/convert_string.h"
+
+#include "binary_output.h"
+#include "library_thread.h"
+#include "periodic_timer.h"
+#include "sensor_name_registry.h"
+#include "start_barrier.h"
+#include "string_functions.h"
+#include "timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Converts a timestamp between two resolutions.
+    /// </summary>
+    static replay_sensor_impl::timestamp_type rescale_timestamp(
+            _In_ const replay_sensor_impl::timestamp_type value,
+            _In_ const timestamp_resolution from,
+            _In_ const timestamp_resolution to) {
+        typedef replay_sensor_impl::timestamp_type timestamp_type;
+        if (from == to) {
+            return value;
+        }
+
+        // All resolutions are powers of ten apart, so scaling by the integral
+        // ratio is exact unless precision is dropped on purpose.
+        const auto src = ticks_per_second(from);
+        const auto dst = ticks_per_second(to);
+        if (dst > src) {
+            return value * static_cast<timestamp_type>(dst / src + 0.5);
+        } else {
+            return value / static_cast<timestamp_type>(src / dst + 0.5);
+        }
+    }
+
+
+    /// <summary>
+    /// Parses a floating-point column of the CSV output.
+    /// </summary>
+    static measurement_data::value_type parse_csv_value(
+            _In_ const std::string& text) {
+        char *end = nullptr;
+        const auto retval = std::strtof(text.c_str(), &end);
+        if ((end == text.c_str()) || (*end != 0)) {
+            throw std::runtime_error("A value in the CSV output file is not "
+                "a number.");
+        }
+
+        // The writer formats invalid values, which are the lowest number,
+        // with six digits, which does not yield the exact number again.
+        return (retval <= measurement_data::invalid_value * 0.9999f)
+            ? measurement_data::invalid_value
+            : retval;
+    }
+
+
+    /// <summary>
+    /// Splits a line of the CSV output into its columns.
+    /// </summary>
+    static void split_csv_line(_Inout_ std::vector<std::string>& dst,
+            _In_ const std::string& line,
+            _In_ const char delimiter,
+            _In_ const char quote) {
+        std::size_t begin = 0;
+        dst.clear();
+
+        while (true) {
+            auto end = std::string::npos;
+
+            if ((quote != 0) && (begin < line.size())
+                    && (line[begin] == quote)) {
+                auto close = line.find(quote, begin + 1);
+                if (close == std::string::npos) {
+                    close = line.size();
+                }
+
+                dst.emplace_back(line, begin + 1, close - begin - 1);
+                end = line.find(delimiter, close);
+
+            } else {
+                end = line.find(delimiter, begin);
+                const auto last = (end != std::string::npos)
+                    ? end
+                    : line.size();
+                dst.emplace_back(line, begin, last - begin);
+            }
+
+            if (end == std::string::npos) {
+                break;
+            }
+
+            begin = end + 1;
+        }
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::replay_sensor_impl::max_batch_latency
+ */
+constexpr std::chrono::microseconds
+visus::power_overwhelming::detail::replay_sensor_impl::max_batch_latency;
+
+
+/*
+ * visus::power_overwhelming::detail::replay_sensor_impl::max_batch_size
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::replay_sensor_impl::max_batch_size;
+
+
+/*
+ * visus::power_overwhelming::detail::replay_sensor_impl::replay_sensor_impl
+ */
+visus::power_overwhelming::detail::replay_sensor_impl::replay_sensor_impl(
+        void)
+    : callback(nullptr), context(nullptr), loop(false), rebase(true),
+        replayed(0), resolution(timestamp_resolution::milliseconds),
+        running(false), speed(replay_sensor::real_time), sync_origin(0),
+        sync_position(0) { }
+
+
+/*
+ * visus::power_overwhelming::detail::replay_sensor_impl::~replay_sensor_impl
+ */
+visus::power_overwhelming::detail::replay_sensor_impl::~replay_sensor_impl(
+        void) {
+    this->stop();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::replay_sensor_impl::interval
+ */
+visus::power_overwhelming::detail::replay_sensor_impl::timestamp_type
+visus::power_overwhelming::detail::replay_sensor_impl::interval(
+        void) const noexcept {
+    const auto n = this->samples.size();
+    return (n > 1)
+        ? (this->samples.back().timestamp() - this->samples.front().timestamp())
+            / static_cast<timestamp_type>(n - 1)
+        : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::replay_sensor_impl::load
+ */
+void visus::power_overwhelming::detail::replay_sensor_impl::load(void) {
+    std::ifstream stream;
+
+#if defined(_WIN32)
+    stream.open(this->path, std::ifstream::binary | std::ifstream::in);
+#else /* defined(_WIN32) */
+    stream.open(power_overwhelming::convert_string<char>(this->path),
+        std::ifstream::binary | std::ifstream::in);
+#endif /* defined(_WIN32) */
+
+    if (!stream.is_open()) {
+        throw std::ios_base::failure("The recorded trace could not be "
+            "opened.");
+    }
+
+    // The binary format is recognised by its magic number, everything else
+    // must be CSV.
+    char magic[sizeof(binary_output_magic)];
+    stream.read(magic, sizeof(magic));
+    const auto binary = (stream.gcount() == sizeof(magic))
+        && (::memcmp(magic, binary_output_magic, sizeof(magic)) == 0);
+
+    this->samples.clear();
+
+    if (binary) {
+        stream.close();
+        this->load_binary();
+    } else {
+        stream.clear();
+        stream.seekg(0);
+        this->load_csv(stream);
+    }
+
+    if (this->samples.empty()) {
+        throw std::invalid_argument("The recorded trace does not contain any "
+            "samples of the sensor.");
+    }
+
+    // The samples of a sensor are recorded in order, but a CSV file could
+    // have been edited, and the replay relies on the order.
+    std::stable_sort(this->samples.begin(), this->samples.end(),
+            [](const measurement_data& l, const measurement_data& r) {
+        return (l.timestamp() < r.timestamp());
+    });
+}
+
+
+/*
+ * visus::power_overwhelming::detail::replay_sensor_impl::offset
+ */
+visus::power_overwhelming::detail::replay_sensor_impl::timestamp_type
+visus::power_overwhelming::detail::replay_sensor_impl::offset(
+        _In_ const std::size_t index) const noexcept {
+    assert(!this->samples.empty());
+    const auto n = this->samples.size();
+    const auto first = this->samples.front().timestamp();
+    auto retval = this->samples[index % n].timestamp() - first;
+
+    if (index >= n) {
+        // Each repetition starts one mean interval after the previous one
+        // has ended.
+        const auto duration = this->samples.back().timestamp() - first
+            + (std::max)(this->interval(), timestamp_type(1));
+        retval += static_cast<timestamp_type>(index / n) * duration;
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::replay_sensor_impl::sample
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::detail::replay_sensor_impl::sample(
+        _In_ const std::size_t index,
+        _In_ const timestamp_type origin,
+        _In_ const timestamp_resolution resolution) const {
+    assert(!this->samples.empty());
+    auto& s = this->samples[index % this->samples.size()];
+    const auto begin = this->rebase
+        ? origin
+        : this->samples.front().timestamp();
+    const auto timestamp = rescale_timestamp(begin + this->offset(index),
+        this->resolution, resolution);
+    return measurement_data(timestamp, s.voltage(), s.current(), s.power());
+}
+
+
+/*
+ * visus::power_overwhelming::detail::replay_sensor_impl::sample_sync
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::detail::replay_sensor_impl::sample_sync(
+        _In_ const timestamp_resolution resolution) {
+    assert(!this->samples.empty());
+    auto index = this->samples.size() - 1;
+
+    if (this->sync_position == 0) {
+        this->sync_origin = create_timestamp(this->resolution);
+    }
+
+    if (this->loop || (this->sync_position < this->samples.size())) {
+        index = this->sync_position++;
+        ++this->replayed;
+    }
+
+    return this->sample(index, this->sync_origin, resolution);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::replay_sensor_impl::start
+ */
+bool visus::power_overwhelming::detail::replay_sensor_impl::start(
+        _In_ const measurement_data_callback callback,
+        _In_opt_ void *context) {
+    assert(callback != nullptr);
+    if (this->thread.joinable()) {
+        return false;
+    }
+
+    this->callback = callback;
+    this->context = context;
+    this->running.store(true, std::memory_order_release);
+    this->thread = std::thread(&replay_sensor_impl::run, this);
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::replay_sensor_impl::stop
+ */
+void visus::power_overwhelming::detail::replay_sensor_impl::stop(void) {
+    this->running.store(false, std::memory_order_release);
+    if (this->thread.joinable()) {
+        this->thread.join();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::replay_sensor_impl::load_binary
+ */
+void visus::power_overwhelming::detail::replay_sensor_impl::load_binary(
+        void) {
+    binary_output_reader reader(this->path.c_str());
+    this->resolution = reader.resolution();
+
+    reader.read(this->sensor_name.c_str(),
+            (std::numeric_limits<timestamp_type>::min)(),
+            (std::numeric_limits<timestamp_type>::max)(),
+            [](const wchar_t *, const measurement_data *samples,
+                const std::size_t cnt, void *context) {
+        auto that = static_cast<replay_sensor_impl *>(context);
+        that->samples.insert(that->samples.end(), samples, samples + cnt);
+    }, this);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::replay_sensor_impl::load_csv
+ */
+void visus::power_overwhelming::detail::replay_sensor_impl::load_csv(
+        _Inout_ std::istream& stream) {
+    static const std::string header("sensor");
+    char delimiter = 0;
+    std::vector<std::string> fields;
+    std::string line;
+    std::string name;
+    char quote = 0;
+
+    // The collector always writes milliseconds, but does not record them.
+    this->resolution = timestamp_resolution::milliseconds;
+    append_utf8(name, this->sensor_name.c_str());
+
+    while (std::getline(stream, line)) {
+        if (!line.empty() && (line.back() == '\r')) {
+            line.pop_back();
+        }
+
+        // Skip empty lines and the records of markers, aggregates etc.
+        if (line.empty() || (line.front() == '#')) {
+            continue;
+        }
+
+        if (delimiter == 0) {
+            // The first other line is the header, which tells us the quote
+            // and delimiter characters the file has been written with.
+            if ((line.size() > header.size())
+                    && (line.compare(0, header.size(), header) == 0)) {
+                delimiter = line[header.size()];
+
+            } else if ((line.size() > header.size() + 2)
+                    && (line.compare(1, header.size(), header) == 0)
+                    && (line[header.size() + 1] == line.front())) {
+                quote = line.front();
+                delimiter = line[header.size() + 2];
+
+            } else {
+                throw std::runtime_error("The recorded trace is neither a "
+                    "binary nor a CSV output file.");
+            }
+
+            continue;
+        }
+
+        split_csv_line(fields, line, delimiter, quote);
+        if (fields.size() < 6) {
+            throw std::runtime_error("A line of the CSV output file has too "
+                "few columns.");
+        }
+
+        if ((fields[0] != name) || (fields[2] != "1")) {
+            continue;
+        }
+
+        char *end = nullptr;
+        const auto timestamp = std::strtoll(fields[1].c_str(), &end, 10);
+        if ((end == fields[1].c_str()) || (*end != 0)) {
+            throw std::runtime_error("A timestamp in the CSV output file is "
+                "not a number.");
+        }
+
+        this->samples.emplace_back(static_cast<timestamp_type>(timestamp),
+            parse_csv_value(fields[3]),
+            parse_csv_value(fields[4]),
+            parse_csv_value(fields[5]));
+    }
+
+    if (delimiter == 0) {
+        throw std::runtime_error("The recorded trace is neither a binary nor "
+            "a CSV output file.");
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::replay_sensor_impl::run
+ */
+void visus::power_overwhelming::detail::replay_sensor_impl::run(void) {
+    typedef std::chrono::duration<double> seconds_type;
+    std::vector<measurement_data> batch;
+    std::size_t index = 0;
+    const auto name = sensor_name_registry::intern(this->sensor_name.c_str());
+    const auto paced = (this->speed > 0.0);
+    const auto tps = ticks_per_second(this->resolution);
+    periodic_timer timer;
+    const auto total = this->loop
+        ? (std::numeric_limits<std::size_t>::max)()
+        : this->samples.size();
+
+    enter_library_thread("PwrOwg Replay Sampler Thread");
+    batch.reserve(max_batch_size);
+
+    // Start the replay on the common tick if multiple sensors are being
+    // started at once.
+    const auto begin = start_barrier::wait();
+    const auto origin = create_timestamp(this->resolution);
+    if (paced) {
+        timer.start(max_batch_latency, begin);
+    }
+
+    while (this->running.load(std::memory_order_acquire) && (index < total)) {
+        // Deliver everything that is due unless we are replaying as fast as
+        // possible such that we deliver whatever fits into the batch.
+        auto due = (std::numeric_limits<timestamp_type>::max)();
+        if (paced) {
+            timer.wait();
+            const auto elapsed = std::chrono::duration_cast<seconds_type>(
+                periodic_timer::clock_type::now() - begin);
+            due = static_cast<timestamp_type>(elapsed.count() * this->speed
+                * tps);
+        }
+
+        while ((index < total) && (batch.size() < max_batch_size)
+                && (this->offset(index) <= due)) {
+            batch.push_back(this->sample(index++, origin,
+                timestamp_resolution::milliseconds));
+        }
+
+        if (!batch.empty()) {
+            this->callback(name, batch.data(), batch.size(), this->context);
+            this->replayed += batch.size();
+            batch.clear();
+        }
+    }
+}
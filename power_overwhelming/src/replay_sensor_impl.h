@@ -0,0 +1,220 @@
+﻿// <copyright file="replay_sensor_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <istream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "power_overwhelming/measurement.h"
+#include "power_overwhelming/replay_sensor.h"
+#include "power_overwhelming/timestamp_resolution.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Private data container for the <see cref="replay_sensor" />.
+    /// </summary>
+    struct replay_sensor_impl final {
+
+        /// <summary>
+        /// The type of the timestamps of the samples.
+        /// </summary>
+        typedef measurement_data::timestamp_type timestamp_type;
+
+        /// <summary>
+        /// The maximum number of samples the dedicated thread delivers at
+        /// once, which bounds the batches if the replay is as fast as
+        /// possible or falls behind.
+        /// </summary>
+        static constexpr std::size_t max_batch_size = 1024;
+
+        /// <summary>
+        /// The maximum time the dedicated sampler thread accumulates samples
+        /// before delivering them, which matches the generic sampler.
+        /// </summary>
+        static constexpr std::chrono::microseconds max_batch_latency
+            = std::chrono::milliseconds(10);
+
+        /// <summary>
+        /// The callback receiving the samples of the dedicated thread.
+        /// </summary>
+        measurement_data_callback callback;
+
+        /// <summary>
+        /// The user-defined context passed to <see cref="callback" />.
+        /// </summary>
+        void *context;
+
+        /// <summary>
+        /// Indicates whether the trace is replayed over and over again.
+        /// </summary>
+        bool loop;
+
+        /// <summary>
+        /// The path to the recorded trace.
+        /// </summary>
+        std::wstring path;
+
+        /// <summary>
+        /// Indicates whether the timestamps are shifted to the begin of the
+        /// replay.
+        /// </summary>
+        bool rebase;
+
+        /// <summary>
+        /// The number of samples delivered so far.
+        /// </summary>
+        std::atomic<std::size_t> replayed;
+
+        /// <summary>
+        /// The resolution of the timestamps in <see cref="samples" />.
+        /// </summary>
+        timestamp_resolution resolution;
+
+        /// <summary>
+        /// Indicates whether the dedicated thread should continue replaying.
+        /// </summary>
+        std::atomic<bool> running;
+
+        /// <summary>
+        /// The recorded samples in the order of their timestamps.
+        /// </summary>
+        std::vector<measurement_data> samples;
+
+        /// <summary>
+        /// The name of the sensor.
+        /// </summary>
+        std::wstring sensor_name;
+
+        /// <summary>
+        /// The speed of the replay relative to the recording, which is zero
+        /// for replaying as fast as possible.
+        /// </summary>
+        double speed;
+
+        /// <summary>
+        /// The timestamp in <see cref="resolution" /> at which polling the
+        /// sensor has started.
+        /// </summary>
+        timestamp_type sync_origin;
+
+        /// <summary>
+        /// The index of the next sample returned by polling the sensor.
+        /// </summary>
+        std::size_t sync_position;
+
+        /// <summary>
+        /// The dedicated sampler thread, if running.
+        /// </summary>
+        std::thread thread;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        replay_sensor_impl(void);
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~replay_sensor_impl(void);
+
+        /// <summary>
+        /// Answer the mean spacing of the recorded samples.
+        /// </summary>
+        /// <returns>The mean interval in ticks of <see cref="resolution" />,
+        /// which is zero if there are less than two samples.</returns>
+        timestamp_type interval(void) const noexcept;
+
+        /// <summary>
+        /// Loads all samples of <see cref="sensor_name" /> from
+        /// <see cref="path" />.
+        /// </summary>
+        /// <exception cref="std::invalid_argument">If the file does not
+        /// contain any samples of the sensor.</exception>
+        /// <exception cref="std::system_error">If the file could not be
+        /// opened.</exception>
+        /// <exception cref="std::runtime_error">If the file is neither a
+        /// valid binary nor a valid CSV output file.</exception>
+        void load(void);
+
+        /// <summary>
+        /// Answer the time of the sample with the given index relative to the
+        /// first sample.
+        /// </summary>
+        /// <remarks>
+        /// If the trace is looped, indices beyond the number of samples
+        /// address the repetitions of the trace.
+        /// </remarks>
+        /// <param name="index">The index of the sample.</param>
+        /// <returns>The offset in ticks of <see cref="resolution" />.
+        /// </returns>
+        timestamp_type offset(_In_ const std::size_t index) const noexcept;
+
+        /// <summary>
+        /// Creates the sample with the given index for delivery.
+        /// </summary>
+        /// <param name="index">The index of the sample, which may address a
+        /// repetition of the trace if it is looped.</param>
+        /// <param name="origin">The timestamp in <see cref="resolution" />
+        /// which the first sample is shifted to if
+        /// <see cref="rebase" /> is set.</param>
+        /// <param name="resolution">The resolution of the timestamp of the
+        /// returned sample.</param>
+        /// <returns>The sample with its timestamp for the replay.</returns>
+        measurement_data sample(_In_ const std::size_t index,
+            _In_ const timestamp_type origin,
+            _In_ const timestamp_resolution resolution) const;
+
+        /// <summary>
+        /// Returns the next sample for polling the sensor.
+        /// </summary>
+        measurement_data sample_sync(
+            _In_ const timestamp_resolution resolution);
+
+        /// <summary>
+        /// Start the dedicated sampler thread.
+        /// </summary>
+        /// <returns><c>true</c> if the thread was started, <c>false</c> if it
+        /// was already running.</returns>
+        bool start(_In_ const measurement_data_callback callback,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// Stop the dedicated sampler thread, if running, and wait for it to
+        /// deliver its last samples.
+        /// </summary>
+        void stop(void);
+
+    private:
+
+        /// <summary>
+        /// Loads the samples from a file in
+        /// <see cref="output_format::binary" />.
+        /// </summary>
+        void load_binary(void);
+
+        /// <summary>
+        /// Loads the samples from a file in
+        /// <see cref="output_format::csv" />.
+        /// </summary>
+        void load_csv(_Inout_ std::istream& stream);
+
+        /// <summary>
+        /// The body of the dedicated sampler thread.
+        /// </summary>
+        void run(void);
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -5,10 +5,102 @@
 
 #include "power_overwhelming/rtx_instrument.h"
 
+#include <limits>
+#include <string>
+#include <vector>
+
 #include "no_visa_error_msg.h"
+#include "scpi_batch.h"
+#include "scpi_response.h"
 #include "visa_instrument_impl.h"
 
 
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+#if defined(POWER_OVERWHELMING_WITH_VISA)
+    /// <summary>
+    /// Answer the SCPI node of the <paramref name="i" />th waveform source,
+    /// where the channels precede the maths channels.
+    /// </summary>
+    static std::string waveform_source(_In_ const std::size_t i,
+            _In_reads_(cnt_channels) const std::uint32_t *channels,
+            _In_ const std::size_t cnt_channels,
+            _In_opt_ const std::uint32_t *maths) {
+        return (i < cnt_channels)
+            ? format_string("CHAN%u", channels[i])
+            : format_string("CALC:MATH%u", maths[i - cnt_channels]);
+    }
+
+    /// <summary>
+    /// Configures the transfer format for waveforms and retrieves the headers
+    /// of the given channels in a single message.
+    /// </summary>
+    /// <remarks>
+    /// The headers of the maths channels follow the ones of the channels.
+    /// The responses to the header queries are separated by semicolons, which
+    /// are replaced with terminators such that <paramref name="headers" />
+    /// can point directly into the returned blob. The error state of the
+    /// instrument is not checked unless the number of headers is wrong,
+    /// because the caller is expected to do so once it has retrieved all the
+    /// data.
+    /// </remarks>
+    static blob query_waveform_headers(_In_ rtx_instrument& instrument,
+            _In_ visa_instrument_impl& impl,
+            _In_reads_(cnt_channels) const std::uint32_t *channels,
+            _In_ const std::size_t cnt_channels,
+            _In_reads_(cnt_maths) const std::uint32_t *maths,
+            _In_ const std::size_t cnt_maths,
+            _Out_ std::vector<const char *>& headers) {
+        const auto cnt = cnt_channels + cnt_maths;
+        std::string query("FORM REAL,32;:FORM:BORD LSBF");
+        for (std::size_t c = 0; c < cnt; ++c) {
+            query += ";:";
+            query += waveform_source(c, channels, cnt_channels, maths);
+            query += ":DATA:HEAD?";
+        }
+        query += "\n";
+
+        impl.write(query.c_str());
+        auto retval = impl.read_all();
+
+        // Make sure that the last header is terminated even if the instrument
+        // did not send a line break.
+        retval.grow(retval.size() + 1);
+        *retval.rbegin() = 0;
+
+        headers.clear();
+        headers.reserve(cnt);
+        auto cur = retval.as<char>();
+        headers.push_back(cur);
+        for (; *cur != 0; ++cur) {
+            if (*cur == ';') {
+                *cur = 0;
+                headers.push_back(cur + 1);
+            } else if ((*cur == '\r') || (*cur == '\n')) {
+                *cur = 0;
+                break;
+            }
+        }
+
+        if (headers.size() != cnt) {
+            // Most likely, one of the channels was invalid, which the
+            // instrument should be able to tell us.
+            instrument.throw_on_system_error();
+            throw std::runtime_error("The instrument did not send a header "
+                "for each channel requested.");
+        }
+
+        return retval;
+    }
+#endif /* defined(POWER_OVERWHELMING_WITH_VISA) */
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
 /*
  * visus::power_overwhelming::rtx_instrument::rtx_id
  */
@@ -157,94 +249,85 @@ visus::power_overwhelming::rtx_instrument::channel(
         _In_ const oscilloscope_channel& channel) {
 #if defined(POWER_OVERWHELMING_WITH_VISA)
     auto& impl = this->check_not_disposed();
+    detail::scpi_batch batch;
 
     // Note: Attenuation should be set first, because changing the attenuation
     // will also scale other values like the range.
-    impl.format("PROB%d:SET:ATT:UNIT %s\n", channel.channel(),
+    batch.add("PROB%d:SET:ATT:UNIT %s", channel.channel(),
         channel.attenuation().unit());
-    this->throw_on_system_error();
-    impl.format("PROB%d:SET:ATT:MAN %f\n", channel.channel(),
+    batch.add("PROB%d:SET:ATT:MAN %f", channel.channel(),
         channel.attenuation().value());
-    this->throw_on_system_error();
 
     switch (channel.bandwidth()) {
         case oscilloscope_channel_bandwidth::limit_to_20_mhz:
-            impl.format("CHAN%d:BAND B20\n", channel.channel());
+            batch.add("CHAN%d:BAND B20", channel.channel());
             break;
 
         default:
-            impl.format("CHAN%d:BAND FULL\n", channel.channel());
+            batch.add("CHAN%d:BAND FULL", channel.channel());
             break;
     }
-    this->throw_on_system_error();
 
     switch (channel.coupling()) {
         case oscilloscope_channel_coupling::alternating_current_limit:
-            impl.format("CHAN%d:COUP ACL\n", channel.channel());
+            batch.add("CHAN%d:COUP ACL", channel.channel());
             break;
 
         case oscilloscope_channel_coupling::ground:
-            impl.format("CHAN%d:COUP GND\n", channel.channel());
+            batch.add("CHAN%d:COUP GND", channel.channel());
             break;
 
         default:
-            impl.format("CHAN%d:COUP DCL\n", channel.channel());
+            batch.add("CHAN%d:COUP DCL", channel.channel());
             break;
     }
-    this->throw_on_system_error();
 
     switch (channel.decimation_mode()) {
         case oscilloscope_decimation_mode::high_resolution:
-            impl.format("CHAN%d:TYPE HRES\n", channel.channel());
+            batch.add("CHAN%d:TYPE HRES", channel.channel());
             break;
 
         case oscilloscope_decimation_mode::peak_detect:
-            impl.format("CHAN%d:TYPE PDET\n", channel.channel());
+            batch.add("CHAN%d:TYPE PDET", channel.channel());
             break;
 
         default:
-            impl.format("CHAN%d:TYPE SAMP\n", channel.channel());
+            batch.add("CHAN%d:TYPE SAMP", channel.channel());
             break;
     }
-    this->throw_on_system_error();
 
-    impl.format("CHAN%d:LAB \"%s\"\n", channel.channel(),
+    batch.add("CHAN%d:LAB \"%s\"", channel.channel(),
         channel.label().text());
-    this->throw_on_system_error();
-    impl.format("CHAN%d:LAB:STAT %s\n", channel.channel(),
+    batch.add("CHAN%d:LAB:STAT %s", channel.channel(),
         channel.label().visible() ? "ON" : "OFF");
-    this->throw_on_system_error();
 
-    impl.format("CHAN%d:OFFS %f%s\n", channel.channel(),
+    batch.add("CHAN%d:OFFS %f%s", channel.channel(),
         channel.offset().value(), channel.offset().unit());
-    this->throw_on_system_error();
 
     switch (channel.polarity()) {
         case oscilloscope_channel_polarity::inverted:
-            impl.format("CHAN%d:POL INV\n", channel.channel());
+            batch.add("CHAN%d:POL INV", channel.channel());
             break;
 
         default:
-            impl.format("CHAN%d:POL NORM\n", channel.channel());
+            batch.add("CHAN%d:POL NORM", channel.channel());
             break;
     }
-    this->throw_on_system_error();
 
-    impl.format("CHAN%d:RANG %f%s\n", channel.channel(),
+    batch.add("CHAN%d:RANG %f%s", channel.channel(),
         channel.range().value(), channel.range().unit());
-    this->throw_on_system_error();
 
-    impl.format("CHAN%d:SKEW %f%s\n", channel.channel(),
+    batch.add("CHAN%d:SKEW %f%s", channel.channel(),
         channel.skew().value(), channel.skew().unit());
-    this->throw_on_system_error();
 
-    impl.format("CHAN%d:STAT %s\n", channel.channel(),
+    batch.add("CHAN%d:STAT %s", channel.channel(),
         channel.state() ? "ON" : "OFF");
-    this->throw_on_system_error();
 
-    impl.format("CHAN%d:ZOFF %f%s\n", channel.channel(),
+    batch.add("CHAN%d:ZOFF %f%s", channel.channel(),
         channel.zero_offset().value(), channel.zero_offset().unit());
-    this->throw_on_system_error();
+
+    // Send everything at once and check for errors only at the end.
+    batch.execute(impl);
 #endif /*defined(POWER_OVERWHELMING_WITH_VISA) */
 
     return *this;
@@ -257,10 +340,77 @@ visus::power_overwhelming::rtx_instrument::channel(
 visus::power_overwhelming::oscilloscope_waveform
 visus::power_overwhelming::rtx_instrument::data(
         _In_ const std::uint32_t channel) {
+    oscilloscope_waveform retval;
+    this->data(&retval, &channel, 1);
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::rtx_instrument::data
+ */
+visus::power_overwhelming::rtx_instrument&
+visus::power_overwhelming::rtx_instrument::data(
+        _Inout_ oscilloscope_waveform& waveform,
+        _In_ const std::uint32_t channel) {
+    return this->data(&waveform, &channel, 1);
+}
+
+
+/*
+ * visus::power_overwhelming::rtx_instrument::data
+ */
+visus::power_overwhelming::rtx_instrument&
+visus::power_overwhelming::rtx_instrument::data(
+        _Out_writes_(cnt) oscilloscope_waveform *out_waveforms,
+        _In_reads_(cnt) const std::uint32_t *channels,
+        _In_ const std::size_t cnt) {
+    return this->data(out_waveforms, channels, cnt, nullptr, 0);
+}
+
+
+/*
+ * visus::power_overwhelming::rtx_instrument::data
+ */
+visus::power_overwhelming::rtx_instrument&
+visus::power_overwhelming::rtx_instrument::data(
+        _Out_writes_(cnt_channels + cnt_maths)
+        oscilloscope_waveform *out_waveforms,
+        _In_reads_(cnt_channels) const std::uint32_t *channels,
+        _In_ const std::size_t cnt_channels,
+        _In_reads_(cnt_maths) const std::uint32_t *maths,
+        _In_ const std::size_t cnt_maths) {
 #if defined(POWER_OVERWHELMING_WITH_VISA)
-    const auto query = detail::format_string("CHAN%u:DATA:HEAD?\n", channel);
-    const auto header = this->query(query.c_str());
-    return oscilloscope_waveform(header.as<char>(), this->binary_data(channel));
+    const auto cnt = cnt_channels + cnt_maths;
+    if ((cnt > 0) && (out_waveforms == nullptr)) {
+        throw std::invalid_argument("The waveforms to retrieve must not be "
+            "nullptr.");
+    }
+    if (((cnt_channels > 0) && (channels == nullptr))
+            || ((cnt_maths > 0) && (maths == nullptr))) {
+        throw std::invalid_argument("The channels to retrieve must not be "
+            "nullptr.");
+    }
+
+    auto& impl = this->check_not_disposed();
+
+    if (cnt > 0) {
+        std::vector<const char *> headers;
+        const auto buffer = detail::query_waveform_headers(*this, impl,
+            channels, cnt_channels, maths, cnt_maths, headers);
+
+        for (std::size_t c = 0; c < cnt; ++c) {
+            impl.format("%s:DATA?\n", detail::waveform_source(c, channels,
+                cnt_channels, maths).c_str());
+            auto& dst = out_waveforms[c];
+            const auto valid = impl.read_binary(dst._samples);
+            dst.parse_header(headers[c], valid);
+        }
+
+        this->throw_on_system_error();
+    }
+
+    return *this;
 
 #else /*defined(POWER_OVERWHELMING_WITH_VISA) */
     throw std::logic_error(detail::no_visa_error_msg);
@@ -319,7 +469,7 @@ visus::power_overwhelming::rtx_instrument::expression(
 int visus::power_overwhelming::rtx_instrument::history_segment(void) const {
 #if defined(POWER_OVERWHELMING_WITH_VISA)
     auto retval = this->query("CHAN:HIST:CURR?\n");
-    return std::atoi(retval.as<char>());
+    return static_cast<int>(detail::parse_integer_response(retval));
 
 #else /*defined(POWER_OVERWHELMING_WITH_VISA) */
     throw std::logic_error(detail::no_visa_error_msg);
@@ -340,6 +490,110 @@ visus::power_overwhelming::rtx_instrument::history_segment(
 }
 
 
+/*
+ * visus::power_overwhelming::rtx_instrument::history_data
+ */
+std::size_t visus::power_overwhelming::rtx_instrument::history_data(
+        _Out_writes_opt_(cnt_waveforms) oscilloscope_waveform *out_waveforms,
+        _In_ const std::size_t cnt_waveforms,
+        _In_reads_(cnt_channels) const std::uint32_t *channels,
+        _In_ const std::size_t cnt_channels) {
+    return this->history_data(out_waveforms, cnt_waveforms, channels,
+        cnt_channels, nullptr, 0);
+}
+
+
+/*
+ * visus::power_overwhelming::rtx_instrument::history_data
+ */
+std::size_t visus::power_overwhelming::rtx_instrument::history_data(
+        _Out_writes_opt_(cnt_waveforms) oscilloscope_waveform *out_waveforms,
+        _In_ const std::size_t cnt_waveforms,
+        _In_reads_(cnt_channels) const std::uint32_t *channels,
+        _In_ const std::size_t cnt_channels,
+        _In_reads_(cnt_maths) const std::uint32_t *maths,
+        _In_ const std::size_t cnt_maths) {
+#if defined(POWER_OVERWHELMING_WITH_VISA)
+    if (((channels == nullptr) && (cnt_channels > 0))
+            || ((maths == nullptr) && (cnt_maths > 0))) {
+        throw std::invalid_argument("The channels to retrieve must not be "
+            "nullptr.");
+    }
+
+    auto& impl = this->check_not_disposed();
+    const auto segments = this->history_segments();
+    const auto cnt_sources = cnt_channels + cnt_maths;
+    const auto retval = segments * cnt_sources;
+
+    if ((out_waveforms == nullptr) || (cnt_waveforms < retval)
+            || (retval == 0)) {
+        return retval;
+    }
+
+    // All segments have been acquired with the same settings, so the header
+    // of the current segment is valid for all of them.
+    std::vector<const char *> headers;
+    const auto buffer = detail::query_waveform_headers(*this, impl,
+        channels, cnt_channels, maths, cnt_maths, headers);
+
+    auto have_buffer = false;
+    auto dst = out_waveforms;
+    for (int s = 1 - static_cast<int>(segments); s <= 0; ++s) {
+        for (std::size_t c = 0; c < cnt_sources; ++c, ++dst) {
+            const auto source = detail::waveform_source(c, channels,
+                cnt_channels, maths);
+            if (c == 0) {
+                // Select the segment as part of the first query to save the
+                // round trip for the command.
+                impl.format("CHAN:HIST:CURR %i;:%s:DATA?\n", s,
+                    source.c_str());
+            } else {
+                impl.format("%s:DATA?\n", source.c_str());
+            }
+
+            // Receive the samples directly into the buffer of the existing
+            // waveform, which does not need to be reallocated unless the
+            // record length has grown since the last call.
+            const auto valid = impl.read_binary(dst->_samples);
+
+            if (!have_buffer) {
+                // Now that we know how large a waveform is, make the VISA
+                // buffer large enough to receive it in one go.
+                const auto size = (std::min)(valid + 64,
+                    static_cast<std::size_t>((std::numeric_limits<
+                        std::uint32_t>::max)()));
+                this->buffer(VI_READ_BUF, static_cast<std::uint32_t>(size));
+                have_buffer = true;
+            }
+
+            dst->parse_header(headers[c], valid);
+        }
+    }
+
+    this->throw_on_system_error();
+    return retval;
+
+#else /*defined(POWER_OVERWHELMING_WITH_VISA) */
+    throw std::logic_error(detail::no_visa_error_msg);
+#endif /*defined(POWER_OVERWHELMING_WITH_VISA) */
+}
+
+
+/*
+ * visus::power_overwhelming::rtx_instrument::history_segment_time
+ */
+double visus::power_overwhelming::rtx_instrument::history_segment_time(
+        void) const {
+#if defined(POWER_OVERWHELMING_WITH_VISA)
+    auto retval = this->query("CHAN:HIST:TSR?\n");
+    return detail::parse_real_response(retval);
+
+#else /*defined(POWER_OVERWHELMING_WITH_VISA) */
+    throw std::logic_error(detail::no_visa_error_msg);
+#endif /*defined(POWER_OVERWHELMING_WITH_VISA) */
+}
+
+
 /*
  * visus::power_overwhelming::rtx_instrument::history_segments
  */
@@ -347,7 +601,7 @@ std::size_t visus::power_overwhelming::rtx_instrument::history_segments(
         void) const {
 #if defined(POWER_OVERWHELMING_WITH_VISA)
     auto retval = this->query("ACQ:AVA?\n");
-    return std::atoi(retval.as<char>());
+    return static_cast<std::size_t>(detail::parse_integer_response(retval));
 
 #else /*defined(POWER_OVERWHELMING_WITH_VISA) */
     throw std::logic_error(detail::no_visa_error_msg);
@@ -355,6 +609,51 @@ std::size_t visus::power_overwhelming::rtx_instrument::history_segments(
 }
 
 
+/*
+ * visus::power_overwhelming::rtx_instrument::plan
+ */
+visus::power_overwhelming::rtx_instrument&
+visus::power_overwhelming::rtx_instrument::plan(
+        _In_ const oscilloscope_acquisition_plan& plan,
+        _In_reads_(cnt) const std::uint32_t *channels,
+        _In_ const std::size_t cnt) {
+#if defined(POWER_OVERWHELMING_WITH_VISA)
+    if ((channels == nullptr) && (cnt > 0)) {
+        throw std::invalid_argument("The channels to configure must not be "
+            "nullptr.");
+    }
+
+    auto& impl = this->check_not_disposed();
+    detail::scpi_batch batch;
+
+    // Note: The time scales span many orders of magnitude, so the scale must
+    // not be formatted with a fixed number of decimals.
+    batch.add("TIM:SCAL %g", plan.time_scale());
+    batch.add("ACQ:POIN %u", plan.points());
+
+    for (std::size_t c = 0; c < cnt; ++c) {
+        switch (plan.decimation_mode()) {
+            case oscilloscope_decimation_mode::high_resolution:
+                batch.add("CHAN%u:TYPE HRES", channels[c]);
+                break;
+
+            case oscilloscope_decimation_mode::peak_detect:
+                batch.add("CHAN%u:TYPE PDET", channels[c]);
+                break;
+
+            default:
+                batch.add("CHAN%u:TYPE SAMP", channels[c]);
+                break;
+        }
+    }
+
+    batch.execute(impl);
+#endif /*defined(POWER_OVERWHELMING_WITH_VISA) */
+
+    return *this;
+}
+
+
 /*
  * visus::power_overwhelming::rtx_instrument::reference_position
  */
@@ -414,35 +713,28 @@ visus::power_overwhelming::rtx_instrument&
 visus::power_overwhelming::rtx_instrument::trigger(
         _In_ const oscilloscope_trigger& trigger) {
     auto& impl = this->check_not_disposed();
+    detail::scpi_batch batch;
 
     // Apply configuration that is valid for all triggers.
     switch (trigger.mode()) {
         case oscilloscope_trigger_mode::automatic:
-            impl.format("TRIG:A:MODE AUTO\n");
+            batch.add("TRIG:A:MODE AUTO");
             break;
 
         default:
-            impl.format("TRIG:A:MODE NORM\n");
+            batch.add("TRIG:A:MODE NORM");
             break;
     }
-    this->throw_on_system_error();
 
-    impl.format("TRIG:A:SOUR %s\n", trigger.source());
-    this->throw_on_system_error();
-
-    impl.format("TRIG:A:TYPE %s\n", trigger.type());
-    this->throw_on_system_error();
+    batch.add("TRIG:A:SOUR %s", trigger.source());
+    batch.add("TRIG:A:TYPE %s", trigger.type());
 
     if (trigger.hold_off() == nullptr) {
-        impl.format("TRIG:A:HOLD:MODE OFF\n");
-        this->throw_on_system_error();
+        batch.add("TRIG:A:HOLD:MODE OFF");
 
     } else {
-        impl.format("TRIG:A:HOLD:MODE TIME\n");
-        this->throw_on_system_error();
-
-        impl.format("TRIG:A:HOLD:TIME %s\n", trigger.hold_off());
-        this->throw_on_system_error();
+        batch.add("TRIG:A:HOLD:MODE TIME");
+        batch.add("TRIG:A:HOLD:TIME %s", trigger.hold_off());
     }
 
     // Apply special configuration if the trigger is an edge trigger.
@@ -450,61 +742,60 @@ visus::power_overwhelming::rtx_instrument::trigger(
     if (et != nullptr) {
         switch (et->slope()) {
             case oscilloscope_trigger_slope::both:
-                impl.format("TRIG:A:EDGE:SLOP EITH\n");
+                batch.add("TRIG:A:EDGE:SLOP EITH");
                 break;
 
             case oscilloscope_trigger_slope::rising:
-                impl.format("TRIG:A:EDGE:SLOP POS\n");
+                batch.add("TRIG:A:EDGE:SLOP POS");
                 break;
 
             case oscilloscope_trigger_slope::falling:
-                impl.format("TRIG:A:EDGE:SLOP NEG\n");
+                batch.add("TRIG:A:EDGE:SLOP NEG");
                 break;
         }
-        this->throw_on_system_error();
 
-        impl.format("TRIG:A:LEV%d:VAL %f %s\n", et->input(),
+        batch.add("TRIG:A:LEV%d:VAL %f %s", et->input(),
             et->level().value(), et->level().unit());
-        this->throw_on_system_error();
 
         switch (et->coupling()) {
             case oscilloscope_trigger_coupling::alternating_current:
-                impl.format("TRIG:A:EDGE:COUP AC\n");
+                batch.add("TRIG:A:EDGE:COUP AC");
                 break;
 
             case oscilloscope_trigger_coupling::direct_current:
-                impl.format("TRIG:A:EDGE:COUP DC\n");
+                batch.add("TRIG:A:EDGE:COUP DC");
                 break;
 
             case oscilloscope_trigger_coupling::low_frequency_reject:
-                impl.format("TRIG:A:EDGE:COUP LFR\n");
+                batch.add("TRIG:A:EDGE:COUP LFR");
                 break;
         }
-        this->throw_on_system_error();
 
 #if 0
         // TODO: Only RTA
         switch (et->hysteresis()) {
             case oscilloscope_trigger_hysteresis::automatic:
-                impl.printf("TRIG:A:HYST AUTO\n");
+                batch.add("TRIG:A:HYST AUTO");
                 break;
 
             case oscilloscope_trigger_hysteresis::high:
-                impl.printf("TRIG:A:HYST LARGE\n");
+                batch.add("TRIG:A:HYST LARGE");
                 break;
 
             case oscilloscope_trigger_hysteresis::low:
-                impl.printf("TRIG:A:HYST SMAL\n");
+                batch.add("TRIG:A:HYST SMAL");
                 break;
 
             case oscilloscope_trigger_hysteresis::medium:
-                impl.printf("TRIG:A:HYST MED\n");
+                batch.add("TRIG:A:HYST MED");
                 break;
         }
-        this->throw_on_system_error();
 #endif
     }
 
+    // Send everything at once and check for errors only at the end.
+    batch.execute(impl);
+
     return *this;
 }
 
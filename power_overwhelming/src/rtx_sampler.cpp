@@ -0,0 +1,555 @@
+﻿// <copyright file="rtx_sampler.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "rtx_sampler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "library_thread.h"
+#include "start_barrier.h"
+#include "waveform_kernels.h"
+
+
+/*
+ * visus::power_overwhelming::detail::append_rtx_samples
+ */
+std::size_t visus::power_overwhelming::detail::append_rtx_samples(
+        _Inout_ std::vector<measurement_data>& dst,
+        _In_ const oscilloscope_waveform& voltage,
+        _In_ const oscilloscope_waveform& current,
+        _In_ const timestamp_type origin,
+        _In_ const timestamp_resolution resolution) {
+    const auto cnt = (std::min)(voltage.record_length(),
+        current.record_length());
+    if (cnt == 0) {
+        return 0;
+    }
+
+    const auto tps = ticks_per_second(resolution);
+    const auto begin = static_cast<double>(voltage.time_begin());
+    const auto step = (static_cast<double>(voltage.time_end()) - begin)
+        / static_cast<double>(voltage.record_length());
+    const auto c = current.samples();
+    const auto v = voltage.samples();
+
+    dst.reserve(dst.size() + cnt);
+    for (std::size_t i = 0; i < cnt; ++i) {
+        const auto offset = std::llround((begin + i * step) * tps);
+        dst.emplace_back(origin + static_cast<timestamp_type>(offset),
+            v[i], c[i], v[i] * c[i]);
+    }
+
+    return cnt;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::append_rtx_samples
+ */
+std::size_t visus::power_overwhelming::detail::append_rtx_samples(
+        _Inout_ std::vector<measurement_data>& dst,
+        _In_ const oscilloscope_waveform& voltage,
+        _In_ const oscilloscope_waveform& current,
+        _In_ const timestamp_type origin,
+        _In_ const timestamp_resolution resolution,
+        _In_ const std::size_t window) {
+    if (window <= 1) {
+        return append_rtx_samples(dst, voltage, current, origin, resolution);
+    }
+
+    const auto cnt = (std::min)(voltage.record_length(),
+        current.record_length());
+    if (cnt == 0) {
+        return 0;
+    }
+
+    const auto tps = ticks_per_second(resolution);
+    const auto begin = static_cast<double>(voltage.time_begin());
+    const auto step = (static_cast<double>(voltage.time_end()) - begin)
+        / static_cast<double>(voltage.record_length());
+
+    // Compute the instantaneous power first such that its mean is the active
+    // power over the window.
+    std::vector<float> power(cnt);
+    waveform_power(power.data(), voltage.samples(), current.samples(), cnt);
+
+    const auto cnt_windows = (cnt + window - 1) / window;
+    std::vector<waveform_window> windows(3 * cnt_windows);
+    const auto p = windows.data();
+    const auto v = p + cnt_windows;
+    const auto c = v + cnt_windows;
+    decimate_waveform(p, power.data(), cnt, window);
+    decimate_waveform(v, voltage.samples(), cnt, window);
+    decimate_waveform(c, current.samples(), cnt, window);
+
+    dst.reserve(dst.size() + cnt_windows);
+    for (std::size_t i = 0; i < cnt_windows; ++i) {
+        const auto first = i * window;
+        const auto n = (std::min)(window, cnt - first);
+        const auto centre = begin + (first + 0.5 * (n - 1)) * step;
+        const auto offset = std::llround(centre * tps);
+        dst.emplace_back(origin + static_cast<timestamp_type>(offset),
+            v[i].mean, c[i].mean, p[i].mean);
+    }
+
+    return cnt_windows;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::append_rtx_samples
+ */
+std::size_t visus::power_overwhelming::detail::append_rtx_samples(
+        _Inout_ std::vector<measurement_data>& dst,
+        _In_ const oscilloscope_waveform& power,
+        _In_opt_ const oscilloscope_waveform *voltage,
+        _In_opt_ const oscilloscope_waveform *current,
+        _In_ const timestamp_type origin,
+        _In_ const timestamp_resolution resolution) {
+    const auto raw = ((voltage != nullptr) && (current != nullptr));
+    const auto cnt = raw
+        ? (std::min)({ power.record_length(), voltage->record_length(),
+            current->record_length() })
+        : power.record_length();
+    if (cnt == 0) {
+        return 0;
+    }
+
+    const auto tps = ticks_per_second(resolution);
+    const auto begin = static_cast<double>(power.time_begin());
+    const auto step = (static_cast<double>(power.time_end()) - begin)
+        / static_cast<double>(power.record_length());
+    const auto c = raw ? current->samples() : nullptr;
+    const auto p = power.samples();
+    const auto v = raw ? voltage->samples() : nullptr;
+
+    dst.reserve(dst.size() + cnt);
+    for (std::size_t i = 0; i < cnt; ++i) {
+        const auto offset = std::llround((begin + i * step) * tps);
+        const auto timestamp = origin + static_cast<timestamp_type>(offset);
+        if (raw) {
+            dst.emplace_back(timestamp, v[i], c[i], p[i]);
+        } else {
+            dst.emplace_back(timestamp, p[i]);
+        }
+    }
+
+    return cnt;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::rtx_sampler::resolution
+ */
+constexpr visus::power_overwhelming::timestamp_resolution
+visus::power_overwhelming::detail::rtx_sampler::resolution;
+
+
+/*
+ * visus::power_overwhelming::detail::rtx_sampler::segments
+ */
+constexpr unsigned int
+visus::power_overwhelming::detail::rtx_sampler::segments;
+
+
+/*
+ * visus::power_overwhelming::detail::rtx_sampler::rtx_sampler
+ */
+visus::power_overwhelming::detail::rtx_sampler::rtx_sampler(
+        _In_z_ const char *path,
+        _In_z_ const wchar_t *name,
+        _In_ const std::uint32_t channel_voltage,
+        _In_ const std::uint32_t channel_current,
+        _In_ const std::uint32_t channel_power,
+        _In_ const bool raw_channels,
+        _In_ const bool software_trigger,
+        _In_ const measurement_data_callback callback,
+        _In_ const sensor::microseconds_type period,
+        _In_opt_ void *context,
+        _In_opt_ const oscilloscope_waveform_callback on_waveform,
+        _In_opt_ void *waveform_context)
+    : _armed(false), _callback(callback), _channel_current(channel_current),
+        _channel_power(channel_power), _channel_voltage(channel_voltage),
+        _context(context), _draining(false), _errors(0),
+        _instrument(path, 0), _name(name), _period(period),
+        _raw_channels(raw_channels), _running(true),
+        _software_trigger(software_trigger), _trigger_begin(0),
+        _trigger_time(0), _triggered(false), _triggering(false),
+        _waveform_callback(on_waveform), _waveform_context(waveform_context) {
+    assert(callback != nullptr);
+    assert(name != nullptr);
+    // Note: the timeout passed to the instrument is irrelevant, because the
+    // session of the sensor is reused, which has already been configured.
+    this->_delivery = std::thread(&rtx_sampler::deliver, this);
+    this->_thread = std::thread(&rtx_sampler::sample, this);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::rtx_sampler::~rtx_sampler
+ */
+visus::power_overwhelming::detail::rtx_sampler::~rtx_sampler(void) {
+    {
+        // Do not accept any further trigger and wait for the one in flight,
+        // because its completion callback accesses the sampler.
+        std::unique_lock<std::mutex> l(this->_lock);
+        this->_armed = false;
+        this->_running.store(false, std::memory_order_release);
+        this->_passed.wait(l, [this](void) { return !this->_triggering; });
+    }
+    this->_passed.notify_all();
+
+    if (this->_thread.joinable()) {
+        this->_thread.join();
+    }
+
+    // Only stop the delivery once the sampler cannot produce any more passes
+    // such that all waveforms that have been downloaded are delivered.
+    {
+        std::lock_guard<std::mutex> l(this->_lock);
+        this->_draining = true;
+    }
+    this->_passed.notify_all();
+
+    if (this->_delivery.joinable()) {
+        this->_delivery.join();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::rtx_sampler::trigger
+ */
+bool visus::power_overwhelming::detail::rtx_sampler::trigger(void) {
+    static const char command[] = "*TRG\n";
+
+    {
+        std::lock_guard<std::mutex> l(this->_lock);
+        if (!this->_armed) {
+            return false;
+        }
+
+        this->_armed = false;
+        this->_triggering = true;
+    }
+
+    // Note: the write might complete before the call returns, so the start
+    // time must be recorded before.
+    this->_trigger_begin = create_timestamp(resolution);
+
+    try {
+        this->_instrument.write_async(
+            reinterpret_cast<const visa_instrument::byte_type *>(command),
+            sizeof(command) - 1, on_triggered, this);
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> l(this->_lock);
+            this->_armed = this->_running.load(std::memory_order_acquire);
+            this->_triggering = false;
+            this->_passed.notify_all();
+        }
+        throw;
+    }
+
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::rtx_sampler::on_triggered
+ */
+void visus::power_overwhelming::detail::rtx_sampler::on_triggered(
+        _In_ const std::int32_t status,
+        _In_ const std::size_t cnt,
+        _In_opt_ void *context) {
+    const auto end = create_timestamp(resolution);
+    auto that = static_cast<rtx_sampler *>(context);
+    assert(that != nullptr);
+
+    // The instrument receives the command at some point during the write, so
+    // its midpoint is our best estimate of the trigger. Note that we notify
+    // while holding the lock, because the destructor may complete as soon as
+    // it observes that no trigger is in flight.
+    std::lock_guard<std::mutex> l(that->_lock);
+    if (status >= 0) {
+        that->_trigger_time = that->_trigger_begin
+            + (end - that->_trigger_begin) / 2;
+        that->_triggered = true;
+    } else {
+        // The instrument has not been triggered, so it is still armed.
+        that->_armed = that->_running.load(std::memory_order_acquire);
+    }
+    that->_triggering = false;
+    that->_passed.notify_all();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::rtx_sampler::arm
+ */
+void visus::power_overwhelming::detail::rtx_sampler::arm(void) {
+    std::lock_guard<std::mutex> l(this->_lock);
+    this->_armed = this->_running.load(std::memory_order_acquire);
+    this->_triggered = false;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::rtx_sampler::deliver
+ */
+void visus::power_overwhelming::detail::rtx_sampler::deliver(void) {
+    const auto math = (this->_channel_power != 0);
+    const auto raw = (!math || this->_raw_channels);
+    const std::size_t cnt_sources = (raw ? 2 : 0) + (math ? 1 : 0);
+    std::uint32_t channels[3];
+    std::size_t next = 0;
+    std::vector<measurement_data> samples;
+
+    enter_library_thread("PwrOwg RTX Delivery Thread");
+
+    // The waveforms of a segment are ordered like the channels requested by
+    // the sampler thread, ie the raw channels are followed by the math one.
+    {
+        std::size_t i = 0;
+        if (raw) {
+            channels[i++] = this->_channel_voltage;
+            channels[i++] = this->_channel_current;
+        }
+        if (math) {
+            channels[i++] = this->_channel_power;
+        }
+        assert(i == cnt_sources);
+    }
+
+    while (true) {
+        auto& p = this->_passes[next];
+
+        {
+            std::unique_lock<std::mutex> l(this->_lock);
+            this->_passed.wait(l, [this, &p](void) {
+                return (p.ready || this->_draining);
+            });
+
+            if (!p.ready) {
+                // We are draining and the sampler has not produced any
+                // further pass, so we are done.
+                break;
+            }
+        }
+
+        // The sampler does not touch a pass while it is ready, so we can
+        // work on it without holding the lock.
+        for (std::size_t s = 0; s < p.cnt_segments; ++s) {
+            const auto w = p.waveforms.data() + s * cnt_sources;
+            const auto origin = p.origins[s];
+
+            if (this->_waveform_callback != nullptr) {
+                for (std::size_t c = 0; c < cnt_sources; ++c) {
+                    this->_waveform_callback(this->_name, channels[c],
+                        static_cast<std::uint32_t>(s), origin, w[c],
+                        this->_waveform_context);
+                }
+            }
+
+            samples.clear();
+            if (!math) {
+                append_rtx_samples(samples, w[0], w[1], origin, resolution);
+            } else if (raw) {
+                append_rtx_samples(samples, w[2], w, w + 1, origin,
+                    resolution);
+            } else {
+                append_rtx_samples(samples, w[0], nullptr, nullptr, origin,
+                    resolution);
+            }
+
+            if (!samples.empty()) {
+                this->_callback(this->_name, samples.data(), samples.size(),
+                    this->_context);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> l(this->_lock);
+            p.ready = false;
+        }
+        this->_passed.notify_all();
+        next = 1 - next;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::rtx_sampler::sample
+ */
+void visus::power_overwhelming::detail::rtx_sampler::sample(void) {
+    const std::uint32_t channels[] = {
+        this->_channel_voltage, this->_channel_current
+    };
+    auto armed = false;
+    const auto math = (this->_channel_power != 0);
+    // If the instrument computes the power, we only need the raw channels if
+    // they have been requested explicitly.
+    const std::size_t cnt_channels = (!math || this->_raw_channels) ? 2 : 0;
+    const std::size_t cnt_maths = math ? 1 : 0;
+    const auto cnt_sources = cnt_channels + cnt_maths;
+    std::size_t next = 0;
+    const auto tps = ticks_per_second(resolution);
+
+    for (auto& p : this->_passes) {
+        p.waveforms.resize(cnt_sources * segments);
+    }
+
+    enter_library_thread("PwrOwg RTX Sampler Thread");
+
+    // Start the first acquisition on the common tick if multiple sensors are
+    // being started at once.
+    this->_timer.start(this->_period, start_barrier::wait());
+
+    while (this->_running.load(std::memory_order_acquire)) {
+        try {
+            if (!armed) {
+                // Configure the acquisition only once, because every setting
+                // costs a round trip for checking the error state. Afterwards,
+                // we only need to rearm the instrument, which happens as soon
+                // as the previous pass has been downloaded. A software trigger
+                // starts a single acquisition, so there is no history.
+                if (this->_software_trigger) {
+                    this->_instrument.acquisition(
+                        oscilloscope_single_acquisition()
+                        .count(1)
+                        .segmented(false));
+                    this->arm();
+                } else {
+                    this->_timer.wait();
+                    this->_instrument.acquisition(
+                        oscilloscope_single_acquisition()
+                        .count(segments)
+                        .segmented(true));
+                }
+                armed = true;
+            }
+
+            auto completed = static_cast<timestamp_type>(0);
+            if (this->_software_trigger) {
+                // Wait for the trigger before querying the state of the
+                // acquisition such that we do not use the session while the
+                // trigger is being written.
+                std::unique_lock<std::mutex> l(this->_lock);
+                this->_passed.wait(l, [this](void) {
+                    return (this->_triggered || !this->_running.load(
+                        std::memory_order_acquire));
+                });
+                if (!this->_triggered) {
+                    break;
+                }
+
+                completed = this->_trigger_time;
+                this->_triggered = false;
+            }
+
+            this->_instrument.wait();
+            if (!this->_software_trigger) {
+                completed = create_timestamp(resolution);
+            }
+
+            // Wait for the delivery thread to release the buffer we download
+            // to. As we have two of them, this only blocks if the callback
+            // is slower than the instrument.
+            auto& p = this->_passes[next];
+            {
+                std::unique_lock<std::mutex> l(this->_lock);
+                this->_passed.wait(l, [this, &p](void) {
+                    return (!p.ready || !this->_running.load(
+                        std::memory_order_acquire));
+                });
+                if (p.ready) {
+                    break;
+                }
+            }
+
+            if (this->_software_trigger) {
+                // The waveforms of a software trigger start at its time.
+                this->_instrument.data(p.waveforms.data(), channels,
+                    cnt_channels, &this->_channel_power, cnt_maths);
+                p.cnt_segments = 1;
+                p.origins.assign(1, completed);
+
+                this->_instrument.write("SING\n");
+                this->arm();
+
+                {
+                    std::lock_guard<std::mutex> l(this->_lock);
+                    p.ready = true;
+                }
+                this->_passed.notify_all();
+                next = 1 - next;
+                continue;
+            }
+
+            // Download all segments at once. They are ordered from the
+            // oldest to the newest one, so the batches are delivered in
+            // chronological order.
+            auto cnt = this->_instrument.history_data(p.waveforms.data(),
+                p.waveforms.size(), channels, cnt_channels,
+                &this->_channel_power, cnt_maths);
+            if (cnt > p.waveforms.size()) {
+                // The instrument has more segments than we asked for, so we
+                // need to make room for all of them.
+                p.waveforms.resize(cnt);
+                cnt = this->_instrument.history_data(p.waveforms.data(),
+                    p.waveforms.size(), channels, cnt_channels,
+                    &this->_channel_power, cnt_maths);
+            }
+
+            // The offsets of the segments are part of the history, too, so we
+            // must retrieve them before re-arming the instrument.
+            p.cnt_segments = cnt / cnt_sources;
+            p.origins.resize(p.cnt_segments);
+            for (std::size_t s = 0; s < p.cnt_segments; ++s) {
+                const auto segment = static_cast<int>(s + 1)
+                    - static_cast<int>(p.cnt_segments);
+                auto offset = 0.0;
+                if (segment < 0) {
+                    this->_instrument.history_segment(segment);
+                    offset = this->_instrument.history_segment_time();
+                }
+                p.origins[s] = completed + static_cast<timestamp_type>(
+                    std::llround(offset * tps));
+            }
+
+            // Start capturing the next pass before the samples of this one
+            // are computed and delivered.
+            this->_timer.wait();
+            this->_instrument.write("SING\n");
+
+            {
+                std::lock_guard<std::mutex> l(this->_lock);
+                p.ready = true;
+            }
+            this->_passed.notify_all();
+            next = 1 - next;
+
+        } catch (...) {
+            // We cannot report errors from the sampler thread, so we count them
+            // and try to get the instrument back into a defined state. The
+            // acquisition is configured again in the next pass in case the
+            // failure has been caused by someone changing the settings.
+            this->_errors.fetch_add(1, std::memory_order_relaxed);
+            armed = false;
+
+            {
+                std::lock_guard<std::mutex> l(this->_lock);
+                this->_armed = false;
+                this->_triggered = false;
+            }
+
+            try {
+                this->_instrument.clear();
+            } catch (...) { /* There is nothing else we can do. */ }
+        }
+    }
+}
@@ -0,0 +1,342 @@
+﻿// <copyright file="rtx_sampler.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <cinttypes>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "power_overwhelming/measurement.h"
+#include "power_overwhelming/oscilloscope_waveform.h"
+#include "power_overwhelming/rtx_instrument.h"
+#include "power_overwhelming/rtx_sensor.h"
+#include "power_overwhelming/sensor.h"
+
+#include "periodic_timer.h"
+#include "timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Computes the samples of a power sensor from the waveforms of its
+    /// voltage and current channels.
+    /// </summary>
+    /// <remarks>
+    /// The power is computed sample-wise from the instantaneous voltage and
+    /// current. The samples are assumed to be equidistant within the time range
+    /// reported in the header of the waveform, wherefore only the first
+    /// waveform is used to derive the timestamps. If the waveforms have a
+    /// different number of samples, only the common ones are used.
+    /// </remarks>
+    /// <param name="dst">The vector to append the samples to.</param>
+    /// <param name="voltage">The waveform of the voltage channel.</param>
+    /// <param name="current">The waveform of the current channel.</param>
+    /// <param name="origin">The timestamp of the trigger, which is time zero
+    /// of the waveforms.</param>
+    /// <param name="resolution">The resolution of <paramref name="origin" />
+    /// and of the timestamps being generated.</param>
+    /// <returns>The number of samples that have been appended.</returns>
+    /// <exception cref="std::invalid_argument">If the
+    /// <paramref name="resolution" /> is not supported.</exception>
+    std::size_t POWER_OVERWHELMING_API append_rtx_samples(
+        _Inout_ std::vector<measurement_data>& dst,
+        _In_ const oscilloscope_waveform& voltage,
+        _In_ const oscilloscope_waveform& current,
+        _In_ const timestamp_type origin,
+        _In_ const timestamp_resolution resolution);
+
+    /// <summary>
+    /// Computes the samples of a power sensor from the waveforms of its
+    /// voltage and current channels and decimates them to one sample per
+    /// <paramref name="window" /> samples of the waveforms.
+    /// </summary>
+    /// <remarks>
+    /// The voltage, the current and the power of each sample are the means
+    /// over the window, ie the power is the mean of the instantaneous power
+    /// rather than the product of the mean voltage and current. The
+    /// timestamp of each sample is the centre of its window.
+    /// </remarks>
+    /// <param name="dst">The vector to append the samples to.</param>
+    /// <param name="voltage">The waveform of the voltage channel.</param>
+    /// <param name="current">The waveform of the current channel.</param>
+    /// <param name="origin">The timestamp of the trigger, which is time zero
+    /// of the waveforms.</param>
+    /// <param name="resolution">The resolution of <paramref name="origin" />
+    /// and of the timestamps being generated.</param>
+    /// <param name="window">The number of samples of the waveforms that are
+    /// combined into one sample. If this is zero or one, the waveforms are
+    /// not decimated.</param>
+    /// <returns>The number of samples that have been appended.</returns>
+    /// <exception cref="std::invalid_argument">If the
+    /// <paramref name="resolution" /> is not supported.</exception>
+    std::size_t POWER_OVERWHELMING_API append_rtx_samples(
+        _Inout_ std::vector<measurement_data>& dst,
+        _In_ const oscilloscope_waveform& voltage,
+        _In_ const oscilloscope_waveform& current,
+        _In_ const timestamp_type origin,
+        _In_ const timestamp_resolution resolution,
+        _In_ const std::size_t window);
+
+    /// <summary>
+    /// Computes the samples of a power sensor from the waveform of a maths
+    /// channel that computed the power on the instrument.
+    /// </summary>
+    /// <remarks>
+    /// The timestamps are derived from the header of
+    /// <paramref name="power" />. If the waveforms of the voltage and the
+    /// current channel are given, the samples also report their values, but
+    /// only the samples common to all waveforms are used in this case.
+    /// Otherwise, the voltage and the current of the samples are invalid.
+    /// </remarks>
+    /// <param name="dst">The vector to append the samples to.</param>
+    /// <param name="power">The waveform of the maths channel computing the
+    /// power.</param>
+    /// <param name="voltage">The waveform of the voltage channel, which may be
+    /// <c>nullptr</c>.</param>
+    /// <param name="current">The waveform of the current channel, which may be
+    /// <c>nullptr</c>.</param>
+    /// <param name="origin">The timestamp of the trigger, which is time zero
+    /// of the waveforms.</param>
+    /// <param name="resolution">The resolution of <paramref name="origin" />
+    /// and of the timestamps being generated.</param>
+    /// <returns>The number of samples that have been appended.</returns>
+    /// <exception cref="std::invalid_argument">If the
+    /// <paramref name="resolution" /> is not supported.</exception>
+    std::size_t POWER_OVERWHELMING_API append_rtx_samples(
+        _Inout_ std::vector<measurement_data>& dst,
+        _In_ const oscilloscope_waveform& power,
+        _In_opt_ const oscilloscope_waveform *voltage,
+        _In_opt_ const oscilloscope_waveform *current,
+        _In_ const timestamp_type origin,
+        _In_ const timestamp_resolution resolution);
+
+
+    /// <summary>
+    /// A dedicated sampler thread that continuously performs segmented
+    /// acquisitions on an RTA/RTB oscilloscope and delivers all samples of the
+    /// waveforms.
+    /// </summary>
+    /// <remarks>
+    /// <para>Each pass of the sampler issues a single acquisition of
+    /// <see cref="segments" /> history segments, waits for it to complete and
+    /// downloads the voltage and the current waveform of all segments using
+    /// <see cref="rtx_instrument::history_data" />. If a maths channel
+    /// computes the power on the instrument, only its waveform is downloaded
+    /// unless the raw channels have been requested, too. The
+    /// samples of each segment are delivered as one batch. The newest segment
+    /// is assumed to have been triggered when the acquisition completed, and
+    /// the older ones are aligned relative to it using the time stamps the
+    /// instrument records for its history.</para>
+    /// <para>The sampler is double-buffered: As soon as the waveforms of a
+    /// pass have been downloaded, the next acquisition is armed and the
+    /// waveforms are handed over to a second thread, which computes the
+    /// samples and invokes the callback while the instrument is already
+    /// capturing the next pass. The instrument cannot provide its history
+    /// while acquiring, so the download itself cannot overlap with the
+    /// acquisition, but the host-side processing and the callback do not
+    /// delay re-arming the instrument anymore.</para>
+    /// <para>If the trigger of the instrument is not in automatic mode and no
+    /// trigger event occurs, the acquisition does not complete and the pass
+    /// fails as the query times out. Failed passes are counted and the
+    /// sampler continues with the next one.</para>
+    /// <para>In software-trigger mode, each pass consists of a single
+    /// acquisition that is started by <see cref="trigger" />. The sampler
+    /// waits for the trigger instead of the timer, and the waveforms are
+    /// aligned to the host time at the midpoint of the VISA write of the
+    /// trigger rather than to the completion of the acquisition.</para>
+    /// <para>Like the sampler of the HMC8015, the instance opens its own
+    /// <see cref="rtx_instrument" /> on the session of the sensor, which must
+    /// not be used otherwise while the sampler is running.</para>
+    /// </remarks>
+    class rtx_sampler final {
+
+    public:
+
+        /// <summary>
+        /// The resolution of the timestamps of all samples delivered by the
+        /// sampler.
+        /// </summary>
+        /// <remarks>
+        /// This must be the same resolution that is used by the other sensors
+        /// delivering batches of samples.
+        /// </remarks>
+        static constexpr timestamp_resolution resolution
+            = timestamp_resolution::milliseconds;
+
+        /// <summary>
+        /// The number of history segments acquired in a single pass.
+        /// </summary>
+        static constexpr unsigned int segments = 16;
+
+        /// <summary>
+        /// Initialises a new instance and starts sampling.
+        /// </summary>
+        /// <param name="path">The VISA path of the instrument, which must
+        /// already be open.</param>
+        /// <param name="name">The name of the sensor reported to
+        /// <paramref name="callback" />, which must live as long as the
+        /// sampler.</param>
+        /// <param name="channel_voltage">The channel measuring the voltage.
+        /// </param>
+        /// <param name="channel_current">The channel measuring the current.
+        /// </param>
+        /// <param name="channel_power">The maths channel computing the power,
+        /// or zero for computing it from the voltage and the current.</param>
+        /// <param name="raw_channels">If <paramref name="channel_power" /> is
+        /// set, download the voltage and the current channel nevertheless.
+        /// </param>
+        /// <param name="software_trigger">If <c>true</c>, the acquisitions
+        /// are started by <see cref="trigger" /> rather than periodically.
+        /// </param>
+        /// <param name="callback">The callback receiving the samples.</param>
+        /// <param name="period">The minimum interval between the start of two
+        /// acquisitions in microseconds.</param>
+        /// <param name="context">A user-defined context pointer passed to
+        /// <paramref name="callback" />.</param>
+        /// <exception cref="visa_exception">If the instrument could not be
+        /// opened.</exception>
+        rtx_sampler(_In_z_ const char *path,
+            _In_z_ const wchar_t *name,
+            _In_ const std::uint32_t channel_voltage,
+            _In_ const std::uint32_t channel_current,
+            _In_ const std::uint32_t channel_power,
+            _In_ const bool raw_channels,
+            _In_ const bool software_trigger,
+            _In_ const measurement_data_callback callback,
+            _In_ const sensor::microseconds_type period,
+            _In_opt_ void *context,
+            _In_opt_ const oscilloscope_waveform_callback on_waveform
+                = nullptr,
+            _In_opt_ void *waveform_context = nullptr);
+
+        rtx_sampler(const rtx_sampler&) = delete;
+
+        /// <summary>
+        /// Stops sampling and finalises the instance.
+        /// </summary>
+        /// <remarks>
+        /// The destructor blocks until the pass in progress has completed or
+        /// failed, until a trigger being written has completed and until all
+        /// passes that have been downloaded have been delivered.
+        /// </remarks>
+        ~rtx_sampler(void);
+
+        /// <summary>
+        /// Answer the number of passes that failed, for instance because the
+        /// acquisition timed out.
+        /// </summary>
+        /// <returns>The number of failed passes.</returns>
+        inline std::uint64_t errors(void) const noexcept {
+            return this->_errors.load(std::memory_order_relaxed);
+        }
+
+        /// <summary>
+        /// Starts writing a software trigger to the instrument and returns
+        /// immediately.
+        /// </summary>
+        /// <remarks>
+        /// The trigger is only sent if the instrument has been armed and no
+        /// other trigger has been sent since, because the instrument would
+        /// ignore it otherwise and the sampler could not associate its time
+        /// with an acquisition.
+        /// </remarks>
+        /// <returns><c>true</c> if the trigger is being written, <c>false</c>
+        /// if it has been dropped.</returns>
+        /// <exception cref="visa_exception">If the write could not be started.
+        /// </exception>
+        bool trigger(void);
+
+        rtx_sampler& operator =(const rtx_sampler&) = delete;
+
+    private:
+
+        /// <summary>
+        /// The waveforms downloaded in a single pass.
+        /// </summary>
+        struct pass {
+            /// <summary>
+            /// The number of history segments in <see cref="waveforms" />.
+            /// </summary>
+            std::size_t cnt_segments;
+
+            /// <summary>
+            /// The timestamps of the triggers of the segments.
+            /// </summary>
+            std::vector<timestamp_type> origins;
+
+            /// <summary>
+            /// Indicates whether the pass is waiting for being delivered.
+            /// </summary>
+            bool ready;
+
+            /// <summary>
+            /// The waveforms of all sources of all segments.
+            /// </summary>
+            std::vector<oscilloscope_waveform> waveforms;
+
+            inline pass(void) : cnt_segments(0), ready(false) { }
+        };
+
+        /// <summary>
+        /// Records the time of a software trigger once its write completed.
+        /// </summary>
+        static void on_triggered(_In_ const std::int32_t status,
+            _In_ const std::size_t cnt, _In_opt_ void *context);
+
+        /// <summary>
+        /// Allows for <see cref="trigger" /> to send a trigger after the
+        /// instrument has been armed.
+        /// </summary>
+        void arm(void);
+
+        /// <summary>
+        /// Computes the samples of the ready passes and delivers them until
+        /// <see cref="_draining" /> is set and no pass is left.
+        /// </summary>
+        void deliver(void);
+
+        /// <summary>
+        /// Performs acquisitions until <see cref="_running" /> is cleared.
+        /// </summary>
+        void sample(void);
+
+        bool _armed;
+        measurement_data_callback _callback;
+        std::uint32_t _channel_current;
+        std::uint32_t _channel_power;
+        std::uint32_t _channel_voltage;
+        void *_context;
+        std::thread _delivery;
+        bool _draining;
+        std::atomic<std::uint64_t> _errors;
+        rtx_instrument _instrument;
+        std::mutex _lock;
+        const wchar_t *_name;
+        std::condition_variable _passed;
+        pass _passes[2];
+        periodic_timer::interval_type _period;
+        bool _raw_channels;
+        std::atomic<bool> _running;
+        bool _software_trigger;
+        std::thread _thread;
+        periodic_timer _timer;
+        timestamp_type _trigger_begin;
+        timestamp_type _trigger_time;
+        bool _triggered;
+        bool _triggering;
+        oscilloscope_waveform_callback _waveform_callback;
+        void *_waveform_context;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
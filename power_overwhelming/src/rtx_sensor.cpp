@@ -9,15 +9,34 @@
 #include <cassert>
 #include <limits>
 #include <stdexcept>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "power_overwhelming/convert_string.h"
 
+#include "rtx_sampler.h"
+#include "sensor_name_registry.h"
+#include "string_functions.h"
 #include "timestamp.h"
-#include "tokenise.h"
+#include "visa_discovery.h"
 #include "visa_library.h"
 
 
+/*
+ * visus::power_overwhelming::rtx_sensor::default_channel_current
+ */
+constexpr std::uint32_t
+visus::power_overwhelming::rtx_sensor::default_channel_current;
+
+
+/*
+ * visus::power_overwhelming::rtx_sensor::default_channel_voltage
+ */
+constexpr std::uint32_t
+visus::power_overwhelming::rtx_sensor::default_channel_voltage;
+
+
 /*
  * visus::power_overwhelming::rtx_sensor::for_all
  */
@@ -25,26 +44,22 @@ std::size_t visus::power_overwhelming::rtx_sensor::for_all(
         _Out_writes_opt_(cnt_sensors) rtx_sensor *out_sensors,
         _In_ std::size_t cnt_sensors,
         _In_ const std::int32_t timeout) {
-    // Build the query for all R&S RTB2004 instruments.
-    std::string query("?*::");          // Any protocol
-    query += visa_instrument::rohde_und_schwarz;    // Only R&S
-    query += "::";
-    query += rtx_instrument::rtx_id;    // Only RTA/RTB
-    query += "::?*::INSTR";             // All serial numbers.
-
-    // Search the instruments using VISA.
-    auto devices = detail::visa_library::instance().find_resource(
-        query.c_str());
+    // Search all R&S RTA/RTB instruments using VISA, including the ones on the
+    // network, which can only be recognised by asking them.
+    auto devices = detail::find_instruments(visa_instrument::rohde_und_schwarz,
+        rtx_instrument::rtx_id, [](const std::string& identity) {
+            return (identity.find("RTB") != std::string::npos)
+                || (identity.find("RTA") != std::string::npos);
+        }, timeout);
 
     // Guard against misuse.
     if (out_sensors == nullptr) {
         cnt_sensors = 0;
     }
 
-    // Create a sensor for each instrument we found.
-    for (std::size_t i = 0; (i < cnt_sensors) && (i < devices.size()); ++i) {
-        out_sensors[i] = rtx_sensor(devices[i].c_str(), timeout);
-    }
+    // Create a sensor for each instrument we found. Opening an instrument is
+    // dominated by the round-trip to it, so we open all of them at once.
+    detail::open_instruments(out_sensors, cnt_sensors, devices, timeout);
 
     return devices.size();
 }
@@ -56,8 +71,47 @@ std::size_t visus::power_overwhelming::rtx_sensor::for_all(
 visus::power_overwhelming::rtx_sensor::rtx_sensor(
         _In_z_ const char *path,
         _In_ const visa_instrument::timeout_type timeout)
-        : _instrument(path, timeout), _name(nullptr) {
-    this->initialise();
+        : _channel_current(default_channel_current), _channel_power(0),
+        _channel_voltage(default_channel_voltage),
+        _instrument(path, timeout), _name(nullptr), _raw_channels(false),
+        _sampler(nullptr), _software_trigger(false),
+        _waveform_callback(nullptr), _waveform_context(nullptr) {
+    this->initialise(oscilloscope_sensor_definition(L"",
+        default_channel_voltage, default_channel_current));
+}
+
+
+/*
+ * visus::power_overwhelming::rtx_sensor::rtx_sensor
+ */
+visus::power_overwhelming::rtx_sensor::rtx_sensor(
+        _In_z_ const wchar_t *path,
+        _In_ const visa_instrument::timeout_type timeout)
+        : _channel_current(default_channel_current), _channel_power(0),
+        _channel_voltage(default_channel_voltage),
+        _instrument(path, timeout), _name(nullptr), _raw_channels(false),
+        _sampler(nullptr), _software_trigger(false),
+        _waveform_callback(nullptr), _waveform_context(nullptr) {
+    this->initialise(oscilloscope_sensor_definition(L"",
+        default_channel_voltage, default_channel_current));
+}
+
+
+/*
+ * visus::power_overwhelming::rtx_sensor::rtx_sensor
+ */
+visus::power_overwhelming::rtx_sensor::rtx_sensor(
+        _In_z_ const char *path,
+        _In_ const oscilloscope_sensor_definition& definition,
+        _In_ const visa_instrument::timeout_type timeout)
+        : _channel_current(definition.channel_current()),
+        _channel_power(definition.channel_power()),
+        _channel_voltage(definition.channel_voltage()),
+        _instrument(path, timeout), _name(nullptr),
+        _raw_channels(definition.raw_channels()), _sampler(nullptr),
+        _software_trigger(definition.software_trigger()),
+        _waveform_callback(nullptr), _waveform_context(nullptr) {
+    this->initialise(definition);
 }
 
 
@@ -66,9 +120,16 @@ visus::power_overwhelming::rtx_sensor::rtx_sensor(
  */
 visus::power_overwhelming::rtx_sensor::rtx_sensor(
         _In_z_ const wchar_t *path,
+        _In_ const oscilloscope_sensor_definition& definition,
         _In_ const visa_instrument::timeout_type timeout)
-        : _instrument(path, timeout), _name(nullptr) {
-    this->initialise();
+        : _channel_current(definition.channel_current()),
+        _channel_power(definition.channel_power()),
+        _channel_voltage(definition.channel_voltage()),
+        _instrument(path, timeout), _name(nullptr),
+        _raw_channels(definition.raw_channels()), _sampler(nullptr),
+        _software_trigger(definition.software_trigger()),
+        _waveform_callback(nullptr), _waveform_context(nullptr) {
+    this->initialise(definition);
 }
 
 
@@ -77,8 +138,16 @@ visus::power_overwhelming::rtx_sensor::rtx_sensor(
  */
 visus::power_overwhelming::rtx_sensor::rtx_sensor(
         _Inout_ rtx_sensor&& rhs) noexcept
-        : _instrument(std::move(rhs._instrument)), _name(rhs._name) {
+        : _channel_current(rhs._channel_current),
+        _channel_power(rhs._channel_power),
+        _channel_voltage(rhs._channel_voltage),
+        _instrument(std::move(rhs._instrument)), _name(rhs._name),
+        _raw_channels(rhs._raw_channels), _sampler(rhs._sampler),
+        _software_trigger(rhs._software_trigger),
+        _waveform_callback(rhs._waveform_callback),
+        _waveform_context(rhs._waveform_context) {
     rhs._name = nullptr;
+    rhs._sampler = nullptr;
 }
 
 
@@ -86,6 +155,9 @@ visus::power_overwhelming::rtx_sensor::rtx_sensor(
  * visus::power_overwhelming::rtx_sensor::~rtx_sensor
  */
 visus::power_overwhelming::rtx_sensor::~rtx_sensor(void) {
+    // Make sure that the generic sampler thread does not use the sensor
+    // anymore.
+    this->sample_batch(nullptr);
     delete[] this->_name;
 }
 
@@ -106,10 +178,22 @@ visus::power_overwhelming::rtx_sensor&
 visus::power_overwhelming::rtx_sensor::operator =(
         _Inout_ rtx_sensor&& rhs) noexcept {
     if (this != std::addressof(rhs)) {
+        this->sample_batch(nullptr);
+        delete[] this->_name;
+
+        this->_channel_current = rhs._channel_current;
+        this->_channel_power = rhs._channel_power;
+        this->_channel_voltage = rhs._channel_voltage;
         this->_instrument = std::move(rhs._instrument);
         assert(rhs._instrument == false);
         this->_name = rhs._name;
         rhs._name = nullptr;
+        this->_raw_channels = rhs._raw_channels;
+        this->_sampler = rhs._sampler;
+        rhs._sampler = nullptr;
+        this->_software_trigger = rhs._software_trigger;
+        this->_waveform_callback = rhs._waveform_callback;
+        this->_waveform_context = rhs._waveform_context;
     }
 
     return *this;
@@ -124,22 +208,200 @@ visus::power_overwhelming::rtx_sensor::operator bool(void) const noexcept {
 }
 
 
+/*
+ * visus::power_overwhelming::rtx_sensor::sample_batch
+ */
+void visus::power_overwhelming::rtx_sensor::sample_batch(
+        _In_opt_ const measurement_data_callback on_batch,
+        _In_ const microseconds_type period,
+        _In_opt_ void *context) {
+    if (on_batch != nullptr) {
+        this->check_not_disposed();
+
+        if (this->_sampler != nullptr) {
+            throw std::logic_error("Asynchronous sampling cannot be started "
+                "while it is already running.");
+        }
+
+        // Note: the name must be interned, because it must survive the sensor
+        // being moved or destroyed while the sampler delivers a sample.
+        auto name = this->name();
+        this->_sampler = new detail::rtx_sampler(this->path(),
+            detail::sensor_name_registry::intern((name != nullptr)
+                ? name : L""),
+            this->_channel_voltage, this->_channel_current,
+            this->_channel_power, this->_raw_channels,
+            this->_software_trigger, on_batch, period, context,
+            this->_waveform_callback, this->_waveform_context);
+
+    } else {
+        // Note: We do not check for the sensor being disposed here, because
+        // the destructor uses this to stop sampling.
+        delete this->_sampler;
+        this->_sampler = nullptr;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::rtx_sensor::trigger
+ */
+bool visus::power_overwhelming::rtx_sensor::trigger(void) {
+    this->check_not_disposed();
+
+    if (this->_sampler != nullptr) {
+        // The sampler owns the session while it is running, so it must send
+        // the trigger. This also allows it to associate the time of the
+        // trigger with the acquisition it started.
+        return this->_sampler->trigger();
+    } else {
+        this->_instrument.trigger();
+        return true;
+    }
+}
+
+
 /*
  * visus::power_overwhelming::rtx_sensor::sample_sync
  */
 visus::power_overwhelming::measurement_data
 visus::power_overwhelming::rtx_sensor::sample_sync(
         _In_ const timestamp_resolution resolution) const {
-    throw "TODO";
+    this->check_not_disposed();
+
+    // Acquiring the waveforms modifies the state of the instrument, so we
+    // need a non-constant instrument on the same session.
+    rtx_instrument instrument(this->path(), 0);
+    instrument.acquisition(oscilloscope_single_acquisition().count(1));
+
+    // The instrument answers *OPC? once the acquisition completed, so the
+    // time at which it sent the response is the best estimate for the end of
+    // the waveform.
+    measurement_data::timestamp_type timestamp;
+    instrument.timestamped_query("*OPC?\n", timestamp, resolution);
+
+    const std::uint32_t channels[] = {
+        this->_channel_voltage, this->_channel_current
+    };
+    const auto math = (this->_channel_power != 0);
+    const auto raw = (!math || this->_raw_channels);
+    oscilloscope_waveform waveforms[3];
+    instrument.data(waveforms, channels, raw ? 2 : 0, &this->_channel_power,
+        math ? 1 : 0);
+
+    std::vector<measurement_data> samples;
+    if (!math) {
+        detail::append_rtx_samples(samples, waveforms[0], waveforms[1],
+            timestamp, resolution);
+    } else if (raw) {
+        detail::append_rtx_samples(samples, waveforms[2], waveforms,
+            waveforms + 1, timestamp, resolution);
+    } else {
+        detail::append_rtx_samples(samples, waveforms[0], nullptr, nullptr,
+            timestamp, resolution);
+    }
+    if (samples.empty()) {
+        throw std::runtime_error("The instrument did not return any samples.");
+    }
 
+    // Average the waveforms, using double precision for the sums to remain
+    // accurate for long records.
+    auto c = 0.0;
+    auto p = 0.0;
+    auto v = 0.0;
+    for (auto& s : samples) {
+        c += s.current();
+        p += s.power();
+        v += s.voltage();
+    }
+
+    const auto n = static_cast<double>(samples.size());
+    if (!raw) {
+        return measurement_data(timestamp,
+            static_cast<measurement_data::value_type>(p / n));
+    }
+
+    return measurement_data(timestamp,
+        static_cast<measurement_data::value_type>(v / n),
+        static_cast<measurement_data::value_type>(c / n),
+        static_cast<measurement_data::value_type>(p / n));
 }
 
 
 /*
  * visus::power_overwhelming::rtx_sensor::initialise
  */
-void visus::power_overwhelming::rtx_sensor::initialise(void) {
-    // TODO: compose name
+void visus::power_overwhelming::rtx_sensor::initialise(
+        _In_ const oscilloscope_sensor_definition& definition) {
+#if defined(POWER_OVERWHELMING_WITH_VISA)
+    const auto description = definition.description();
+    if ((description != nullptr) && (*description != 0)) {
+        detail::safe_assign(this->_name, description);
+
+    } else {
+        // Compose the name from the instrument and the channels.
+        auto l = this->_instrument.identify(static_cast<wchar_t *>(nullptr), 0);
+        std::vector<wchar_t> id(l);
+        this->_instrument.identify(id.data(), l);
+
+        std::wstring name(id.data());
+        name += L" (U: CH";
+        name += std::to_wstring(this->_channel_voltage);
+        name += L", I: CH";
+        name += std::to_wstring(this->_channel_current);
+        if (this->_channel_power != 0) {
+            name += L", P: MATH";
+            name += std::to_wstring(this->_channel_power);
+        }
+        name += L")";
+        detail::safe_assign(this->_name, name);
+    }
+
+    // Make sure that both channels are recorded and report the right units.
+    this->_instrument.write(detail::format_string("CHAN%u:STAT ON\n",
+        this->_channel_voltage));
+    this->_instrument.throw_on_system_error();
+    this->_instrument.write(detail::format_string("CHAN%u:STAT ON\n",
+        this->_channel_current));
+    this->_instrument.throw_on_system_error();
+
+    this->_instrument.unit(this->_channel_voltage, "V");
+    this->_instrument.unit(this->_channel_current, "A");
+
+    // Note: The attenuation must be set after the unit, because changing the
+    // unit resets the attenuation of the probe.
+    if (!definition.auto_attenuation_voltage()) {
+        this->_instrument.write(detail::format_string(
+            "PROB%u:SET:ATT:MAN %f\n", this->_channel_voltage,
+            definition.attenuation_voltage()));
+        this->_instrument.throw_on_system_error();
+    }
+
+    if (!definition.auto_attenuation_current()) {
+        this->_instrument.write(detail::format_string(
+            "PROB%u:SET:ATT:MAN %f\n", this->_channel_current,
+            definition.attenuation_current()));
+        this->_instrument.throw_on_system_error();
+    }
+
+    // Let the instrument compute the power if requested. The maths operate on
+    // the scaled values of the channels, so the attenuation of the probes set
+    // above is taken into account.
+    if (this->_channel_power != 0) {
+        const auto expression = detail::format_string("CH%u*CH%u",
+            this->_channel_voltage, this->_channel_current);
+        this->_instrument.expression(this->_channel_power, expression.c_str(),
+            "W");
+    }
+
+    // Only *TRG should start an acquisition if we trigger by software, so we
+    // use an edge on the external input, which is not connected, and wait for
+    // a trigger instead of triggering automatically.
+    if (this->_software_trigger) {
+        this->_instrument.trigger(oscilloscope_edge_trigger("EXT")
+            .mode(oscilloscope_trigger_mode::normal));
+    }
+#endif /*defined(POWER_OVERWHELMING_WITH_VISA) */
 }
 
 
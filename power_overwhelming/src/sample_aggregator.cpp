@@ -0,0 +1,158 @@
+﻿// <copyright file="sample_aggregator.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "sample_aggregator.h"
+
+#include <cassert>
+#include <stdexcept>
+
+#include "waveform_kernels.h"
+
+
+/*
+ * visus::power_overwhelming::detail::sample_aggregator::sample_aggregator
+ */
+visus::power_overwhelming::detail::sample_aggregator::sample_aggregator(
+        void) noexcept
+    : _last_sensor(nullptr), _last_state(nullptr), _seconds_per_tick(0.0),
+        _window(0) { }
+
+
+/*
+ * visus::power_overwhelming::detail::sample_aggregator::configure
+ */
+void visus::power_overwhelming::detail::sample_aggregator::configure(
+        _In_ const measurement::timestamp_type window,
+        _In_ const double ticks_per_second) {
+    if (window < 0) {
+        throw std::invalid_argument("The aggregation window must not be "
+            "negative.");
+    }
+    if ((window > 0) && !(ticks_per_second > 0.0)) {
+        throw std::invalid_argument("The resolution of the timestamps must "
+            "be positive.");
+    }
+
+    this->_last_sensor = nullptr;
+    this->_last_state = nullptr;
+    this->_seconds_per_tick = (window > 0) ? 1.0 / ticks_per_second : 0.0;
+    this->_states.clear();
+    this->_window = window;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sample_aggregator::flush
+ */
+void visus::power_overwhelming::detail::sample_aggregator::flush(
+        _Inout_ std::vector<sample_aggregate>& dst) {
+    for (auto& s : this->_states) {
+        if (!s.second.power.empty()) {
+            dst.emplace_back();
+            this->close(s.second, s.first, dst.back());
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sample_aggregator::push
+ */
+bool visus::power_overwhelming::detail::sample_aggregator::push(
+        _In_ const measurement& sample,
+        _In_ const std::uint32_t marker,
+        _Out_ sample_aggregate& dst) {
+    if (!this->enabled() || !sample) {
+        return false;
+    }
+
+    // The names of measurements are interned, and the samples of a sensor
+    // are often consecutive, so we cache the last state we used.
+    if ((this->_last_state == nullptr)
+            || (this->_last_sensor != sample.sensor())) {
+        auto it = this->_states.find(sample.sensor());
+        if (it == this->_states.end()) {
+            state_type state;
+            state.begin = 0;
+            state.energy = 0.0;
+            state.have_previous = false;
+            state.marker = marker;
+            state.previous_power = 0.0f;
+            state.previous_timestamp = 0;
+            it = this->_states.emplace(sample.sensor(), state).first;
+        }
+
+        this->_last_sensor = it->first;
+        this->_last_state = std::addressof(it->second);
+    }
+
+    auto& state = *this->_last_state;
+    const auto timestamp = sample.timestamp();
+    const auto power = sample.power();
+    const auto changed = (state.marker != marker);
+    auto retval = false;
+
+    if (!state.power.empty() && (changed
+            || (timestamp >= state.begin + this->_window))) {
+        this->close(state, sample.sensor(), dst);
+        retval = true;
+    }
+
+    if (state.power.empty()) {
+        // Align the window such that the boundaries of all sensors match.
+        auto offset = timestamp % this->_window;
+        if (offset < 0) {
+            offset += this->_window;
+        }
+
+        state.begin = timestamp - offset;
+        state.marker = marker;
+    }
+
+    if (changed) {
+        state.have_previous = false;
+    }
+
+    if (state.have_previous && (timestamp > state.previous_timestamp)) {
+        const auto dt = static_cast<double>(timestamp
+            - state.previous_timestamp) * this->_seconds_per_tick;
+        state.energy += 0.5 * dt * (static_cast<double>(power)
+            + static_cast<double>(state.previous_power));
+    }
+
+    state.have_previous = true;
+    state.power.push_back(power);
+    state.previous_power = power;
+    state.previous_timestamp = timestamp;
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sample_aggregator::close
+ */
+void visus::power_overwhelming::detail::sample_aggregator::close(
+        _Inout_ state_type& state,
+        _In_z_ const wchar_t *sensor,
+        _Out_ sample_aggregate& dst) noexcept {
+    assert(!state.power.empty());
+    waveform_window window;
+    decimate_waveform(&window, state.power.data(), state.power.size(),
+        state.power.size());
+
+    dst.begin = state.begin;
+    dst.count = state.power.size();
+    dst.end = state.begin + this->_window;
+    dst.energy = state.energy;
+    dst.marker = state.marker;
+    dst.maximum = window.maximum;
+    dst.mean = window.mean;
+    dst.minimum = window.minimum;
+    dst.sensor = sensor;
+
+    state.energy = 0.0;
+    state.power.clear();
+}
@@ -0,0 +1,189 @@
+﻿// <copyright file="sample_aggregator.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <unordered_map>
+#include <vector>
+
+#include "power_overwhelming/measurement.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The reduction of the samples of a single sensor in a time window.
+    /// </summary>
+    struct POWER_OVERWHELMING_API sample_aggregate final {
+
+        /// <summary>
+        /// The begin of the window, which is a multiple of its length.
+        /// </summary>
+        measurement::timestamp_type begin;
+
+        /// <summary>
+        /// The number of valid samples in the window.
+        /// </summary>
+        std::uint64_t count;
+
+        /// <summary>
+        /// The end of the window, which is not part of the window any more.
+        /// </summary>
+        measurement::timestamp_type end;
+
+        /// <summary>
+        /// The energy in Joules that has been consumed since the previous
+        /// sample before the window until the last sample in the window.
+        /// </summary>
+        double energy;
+
+        /// <summary>
+        /// The ID of the marker active for all samples in the window.
+        /// </summary>
+        std::uint32_t marker;
+
+        /// <summary>
+        /// The largest power in the window.
+        /// </summary>
+        measurement::value_type maximum;
+
+        /// <summary>
+        /// The arithmetic mean of the power in the window.
+        /// </summary>
+        measurement::value_type mean;
+
+        /// <summary>
+        /// The smallest power in the window.
+        /// </summary>
+        measurement::value_type minimum;
+
+        /// <summary>
+        /// The interned name of the sensor.
+        /// </summary>
+        const wchar_t *sensor;
+    };
+
+
+    /// <summary>
+    /// Reduces the samples of each sensor to the minimum, mean and maximum
+    /// power and the energy in windows of fixed length.
+    /// </summary>
+    /// <remarks>
+    /// <para>The windows are aligned to multiples of their length, such that
+    /// the windows of all sensors share the same boundaries. The power of the
+    /// samples in the open window of a sensor is buffered in a column, which
+    /// is reduced with the SIMD kernel of <see cref="decimate_waveform" />
+    /// once the window is closed. The column is retained, so the aggregator
+    /// does not allocate in steady state.</para>
+    /// <para>The energy is integrated with the trapezoidal rule using the
+    /// actual timestamps of the samples. Each trapezoid is attributed to the
+    /// window of the later of its samples, such that the sum of the energies
+    /// over all windows is exactly the integral over all samples
+    /// irrespective of the window length. The integration restarts if the
+    /// marker changes, because samples without marker might not have been
+    /// recorded.</para>
+    /// <para>The aggregator expects the samples of a sensor in chronological
+    /// order. A window is closed when the first sample after its end arrives,
+    /// when the marker changes or when <see cref="flush" /> is called.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API sample_aggregator final {
+
+    public:
+
+        /// <summary>
+        /// Initialises a new instance, which is disabled.
+        /// </summary>
+        sample_aggregator(void) noexcept;
+
+        /// <summary>
+        /// Sets the length of the windows.
+        /// </summary>
+        /// <remarks>
+        /// Changing the window discards all open windows.
+        /// </remarks>
+        /// <param name="window">The length of the windows in ticks of the
+        /// timestamps, or zero to disable aggregation.</param>
+        /// <param name="ticks_per_second">The number of ticks of the
+        /// timestamps per second, which is required for computing the energy.
+        /// </param>
+        void configure(_In_ const measurement::timestamp_type window,
+            _In_ const double ticks_per_second);
+
+        /// <summary>
+        /// Answer whether the aggregator has been configured with a window.
+        /// </summary>
+        /// <returns><c>true</c> if samples are aggregated, <c>false</c>
+        /// otherwise.</returns>
+        inline bool enabled(void) const noexcept {
+            return (this->_window > 0);
+        }
+
+        /// <summary>
+        /// Closes the open windows of all sensors.
+        /// </summary>
+        /// <param name="dst">Receives the aggregates of the windows that
+        /// contained samples, which are appended.</param>
+        void flush(_Inout_ std::vector<sample_aggregate>& dst);
+
+        /// <summary>
+        /// Adds a sample to the open window of its sensor.
+        /// </summary>
+        /// <param name="sample">The sample to be added. Invalid samples are
+        /// ignored.</param>
+        /// <param name="marker">The ID of the marker active for the sample.
+        /// </param>
+        /// <param name="dst">Receives the aggregate of the previous window of
+        /// the sensor if the sample closed it.</param>
+        /// <returns><c>true</c> if <paramref name="dst" /> has been filled,
+        /// <c>false</c> otherwise.</returns>
+        bool push(_In_ const measurement& sample,
+            _In_ const std::uint32_t marker,
+            _Out_ sample_aggregate& dst);
+
+        /// <summary>
+        /// Answer the length of the windows.
+        /// </summary>
+        /// <returns>The length of the windows in ticks, which is zero if the
+        /// aggregator is disabled.</returns>
+        inline measurement::timestamp_type window(void) const noexcept {
+            return this->_window;
+        }
+
+    private:
+
+        /// <summary>
+        /// The open window of a single sensor.
+        /// </summary>
+        struct state_type {
+            measurement::timestamp_type begin;
+            double energy;
+            bool have_previous;
+            std::uint32_t marker;
+            std::vector<measurement::value_type> power;
+            measurement::value_type previous_power;
+            measurement::timestamp_type previous_timestamp;
+        };
+
+        /// <summary>
+        /// Reduces the open window of <paramref name="state" /> into
+        /// <paramref name="dst" /> and resets the window.
+        /// </summary>
+        void close(_Inout_ state_type& state,
+            _In_z_ const wchar_t *sensor,
+            _Out_ sample_aggregate& dst) noexcept;
+
+        const wchar_t *_last_sensor;
+        state_type *_last_state;
+        double _seconds_per_tick;
+        std::unordered_map<const wchar_t *, state_type> _states;
+        measurement::timestamp_type _window;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,74 @@
+﻿// <copyright file="sample_filter.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/sample_filter.h"
+
+#include <stdexcept>
+
+
+/*
+ * visus::power_overwhelming::sample_filter::exponential
+ */
+visus::power_overwhelming::sample_filter
+visus::power_overwhelming::sample_filter::exponential(_In_ const float alpha) {
+    if (!(alpha > 0.0f) || (alpha > 1.0f)) {
+        throw std::invalid_argument("The weight of an exponential moving "
+            "average must be within (0, 1].");
+    }
+
+    return sample_filter(sample_filter_type::exponential, 1, alpha);
+}
+
+
+/*
+ * visus::power_overwhelming::sample_filter::low_pass
+ */
+visus::power_overwhelming::sample_filter
+visus::power_overwhelming::sample_filter::low_pass(
+        _In_ const std::size_t taps,
+        _In_ const float cutoff) {
+    if ((taps < 3) || (taps % 2 == 0)) {
+        throw std::invalid_argument("A low-pass filter must have an odd "
+            "number of at least three taps.");
+    }
+    if (!(cutoff > 0.0f) || !(cutoff < 0.5f)) {
+        throw std::invalid_argument("The cut-off frequency of a low-pass "
+            "filter must be within (0, 0.5) of the sampling rate.");
+    }
+
+    return sample_filter(sample_filter_type::low_pass, taps, cutoff);
+}
+
+
+/*
+ * visus::power_overwhelming::sample_filter::median
+ */
+visus::power_overwhelming::sample_filter
+visus::power_overwhelming::sample_filter::median(
+        _In_ const std::size_t window) {
+    if ((window < 3) || (window % 2 == 0)) {
+        throw std::invalid_argument("A median filter must have an odd window "
+            "of at least three samples.");
+    }
+
+    return sample_filter(sample_filter_type::median, window, 0.0f);
+}
+
+
+/*
+ * visus::power_overwhelming::sample_filter::sample_filter
+ */
+visus::power_overwhelming::sample_filter::sample_filter(void) noexcept
+    : _parameter(0.0f), _type(sample_filter_type::none), _window(1) { }
+
+
+/*
+ * visus::power_overwhelming::sample_filter::sample_filter
+ */
+visus::power_overwhelming::sample_filter::sample_filter(
+        _In_ const sample_filter_type type,
+        _In_ const std::size_t window,
+        _In_ const float parameter) noexcept
+    : _parameter(parameter), _type(type), _window(window) { }
@@ -5,12 +5,15 @@
 
 #pragma once
 
+#include <cinttypes>
 #include <functional>
 #include <memory>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
 #include "default_sampler_context.h"
+#include "sampler_scheduler.h"
 
 
 namespace visus {
@@ -18,17 +21,135 @@ namespace power_overwhelming {
 namespace detail {
 
     /// <summary>
-    /// A utility class that manages threads for asynchronously sampling sensors
-    /// that do not have an asynchronous API themselves.
+    /// Answer the <c>min_interval</c> of a context that supports adaptive
+    /// sampling.
+    /// </summary>
+    template<class TContext>
+    inline auto min_interval_of(_In_ const TContext& context, int)
+            -> decltype(context.min_interval) {
+        return context.min_interval;
+    }
+
+    /// <summary>
+    /// Answer zero for contexts that only sample at a fixed interval.
+    /// </summary>
+    template<class TContext>
+    inline typename TContext::interval_type min_interval_of(
+            _In_ const TContext& context, long) {
+        return TContext::interval_type::zero();
+    }
+
+    /// <summary>
+    /// Sets the <c>min_interval</c> of a context that supports adaptive
+    /// sampling.
+    /// </summary>
+    template<class TContext>
+    inline auto set_min_interval(_In_ TContext& context,
+            _In_ const typename TContext::interval_type interval, int)
+            -> decltype(context.min_interval = interval, void()) {
+        context.min_interval = interval;
+    }
+
+    /// <summary>
+    /// Rejects adaptive sampling for contexts that do not support it.
+    /// </summary>
+    template<class TContext>
+    inline void set_min_interval(_In_ TContext& context,
+            _In_ const typename TContext::interval_type interval, long) {
+        if (interval > TContext::interval_type::zero()) {
+            throw std::logic_error("The sampler context does not support "
+                "adaptive sampling.");
+        }
+    }
+
+    /// <summary>
+    /// Adds a subscriber that receives the readings of every
+    /// <paramref name="divisor" />-th tick of a context that supports
+    /// sharing the reads of a sensor.
+    /// </summary>
+    template<class TContext, class TCallback>
+    inline auto add_subscriber(_In_ TContext& context,
+            _In_ typename TContext::sensor_type sensor,
+            _In_ const TCallback callback,
+            _In_opt_ void *user_context,
+            _In_ const std::size_t divisor, int)
+            -> decltype(context.add(sensor, callback, user_context, divisor)) {
+        return context.add(sensor, callback, user_context, divisor);
+    }
+
+    /// <summary>
+    /// Adds a sensor to a context that samples each sensor for a single
+    /// subscriber.
+    /// </summary>
+    template<class TContext, class TCallback>
+    inline bool add_subscriber(_In_ TContext& context,
+            _In_ typename TContext::sensor_type sensor,
+            _In_ const TCallback callback,
+            _In_opt_ void *user_context,
+            _In_ const std::size_t divisor, long) {
+        assert(divisor == 1);
+        return context.add(sensor, callback, user_context);
+    }
+
+    /// <summary>
+    /// Removes the subscriber identified by <paramref name="user_context" />
+    /// from a context that supports multiple subscribers per sensor.
+    /// </summary>
+    template<class TContext>
+    inline auto remove_subscriber(_In_ TContext& context,
+            _In_ typename TContext::sensor_type sensor,
+            _In_opt_ void *user_context, int)
+            -> decltype(context.remove(sensor, user_context)) {
+        return context.remove(sensor, user_context);
+    }
+
+    /// <summary>
+    /// Removes the sensor from a context that samples each sensor for a
+    /// single subscriber.
+    /// </summary>
+    template<class TContext>
+    inline bool remove_subscriber(_In_ TContext& context,
+            _In_ typename TContext::sensor_type sensor,
+            _In_opt_ void *user_context, long) {
+        return context.remove(sensor);
+    }
+
+    /// <summary>
+    /// Answer whether <paramref name="context" /> can serve multiple
+    /// subscribers at different rates from one read of a sensor.
+    /// </summary>
+    template<class TContext>
+    constexpr auto shares_reads(_In_ const TContext& context, int)
+            -> decltype(std::declval<typename TContext::registration>().divisor,
+            bool()) {
+        return true;
+    }
+
+    /// <summary>
+    /// Answer <c>false</c> for contexts that cannot share reads.
+    /// </summary>
+    template<class TContext>
+    constexpr bool shares_reads(_In_ const TContext& context, long) {
+        return false;
+    }
+
+
+    /// <summary>
+    /// A utility class that manages contexts for asynchronously sampling
+    /// sensors that do not have an asynchronous API themselves.
     /// </summary>
     /// <remarks>
+    /// <para>The contexts do not have threads on their own, but are run by
+    /// the process-wide <see cref="sampler_scheduler" /> such that all sensor
+    /// families and sampling intervals share a small pool of threads.</para>
+    /// <para>
     /// The sampler is not working on the <see cref="sensor" /> interface, but
     /// on the sensor implementation, because the abstract sensor class might be
     /// disposed whereas the sensor implementation used in the PIMPL pattern is
     /// guaranteed to live on until the last sensor was destroyed. Implementors
     /// should make sure that the sensor implementation unregisters itself from
     /// the sampler in its destructor to make sure that there are no dangling
-    /// pointers in the sampler.
+    /// pointers in the sampler.</para>
     /// </remarks>
     /// <typeparam name="TContext">The type of the sampler context that
     /// implements the per-sensor sampling functionality. The interface must be
@@ -69,6 +190,56 @@ namespace detail {
         bool add(sensor_type sensor, const measurement_callback callback,
             void *user_context, const interval_type interval);
 
+        /// <summary>
+        /// Add a new sensor to be sampled, whose samples are delivered in
+        /// batches.
+        /// </summary>
+        /// <remarks>
+        /// This method is only available if the context supports
+        /// <see cref="measurement_data_callback" />s.
+        /// </remarks>
+        /// <param name="sensor"></param>
+        /// <param name="callback"></param>
+        /// <param name="user_context"></param>
+        /// <param name="interval"></param>
+        /// <returns></returns>
+        bool add(sensor_type sensor, const measurement_data_callback callback,
+            void *user_context, const interval_type interval);
+
+        /// <summary>
+        /// Add a new sensor to be sampled adaptively, whose samples are
+        /// delivered in batches.
+        /// </summary>
+        /// <remarks>
+        /// <para>The sensor is sampled at <paramref name="interval" /> while
+        /// its signal is stable and as fast as
+        /// <paramref name="min_interval" /> during transients. Sensors with
+        /// the same bounds share a context and therefore the rate.</para>
+        /// <para>This method is only available if the context supports
+        /// <see cref="measurement_data_callback" />s.</para>
+        /// </remarks>
+        /// <param name="sensor"></param>
+        /// <param name="callback"></param>
+        /// <param name="user_context"></param>
+        /// <param name="interval">The longest sampling interval.</param>
+        /// <param name="min_interval">The shortest sampling interval. If this
+        /// is zero or not shorter than <paramref name="interval" />, the
+        /// sensor is sampled at a fixed rate.</param>
+        /// <returns></returns>
+        /// <exception cref="std::logic_error">If the context does not
+        /// support adaptive sampling.</exception>
+        bool add(sensor_type sensor, const measurement_data_callback callback,
+            void *user_context, const interval_type interval,
+            const interval_type min_interval);
+
+        /// <summary>
+        /// Answer the total number of sampling deadlines that have been missed
+        /// by all contexts of the sampler.
+        /// </summary>
+        /// <returns>The number of samples that have been skipped, because the
+        /// sampling threads could not keep up with their intervals.</returns>
+        std::uint64_t missed_deadlines(void) const;
+
         /// <summary>
         /// Remove the sensor from the list of sensors being sampled by this
         /// sampler.
@@ -79,6 +250,24 @@ namespace detail {
         /// it has not been sampled in the first place.</returns>
         bool remove(sensor_type sensor);
 
+        /// <summary>
+        /// Remove the subscriber of the sensor that has been added with the
+        /// given user context.
+        /// </summary>
+        /// <remarks>
+        /// If the context does not support multiple subscribers per sensor or
+        /// if <paramref name="user_context" /> is <c>nullptr</c>, the sensor is
+        /// removed altogether.
+        /// </remarks>
+        /// <param name="sensor">The sensor to be removed. If is safe to pass
+        /// <c>nullptr</c>, in which case nothing will happen.</param>
+        /// <param name="user_context">The user context passed to
+        /// <see cref="add" />.</param>
+        /// <returns><c>true</c> if the subscriber has been removed,
+        /// <c>false</c> if it has not been sampled in the first place.
+        /// </returns>
+        bool remove(sensor_type sensor, void *user_context);
+
         /// <summary>
         /// Answer whether this sampler samples the specified sensor at any
         /// interval.
@@ -101,7 +290,22 @@ namespace detail {
     private:
 
         /// <summary>
-        /// The list of sampling threads.
+        /// Adds the sensor with the given callback to the context for the
+        /// specified interval, which is created on demand.
+        /// </summary>
+        /// <remarks>
+        /// If the sensor is already sampled at a fixed rate by a context whose
+        /// interval divides the requested one, the new subscriber joins this
+        /// context and receives every n-th reading instead of reading the
+        /// hardware another time.
+        /// </remarks>
+        template<class TCallback>
+        bool add_to_context(sensor_type sensor, const TCallback callback,
+            void *user_context, const interval_type interval,
+            const interval_type min_interval = interval_type::zero());
+
+        /// <summary>
+        /// The list of sampling contexts.
         /// </summary>
         std::vector<std::unique_ptr<context_type>> _contexts;
 
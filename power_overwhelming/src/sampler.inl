@@ -12,16 +12,14 @@ visus::power_overwhelming::detail::sampler<TContext>::~sampler(void) {
     std::lock_guard<decltype(this->_lock)> l(this->_lock);
 
     for (auto& c : this->_contexts) {
-        // Clear all sensors, which makes the threads exit.
-        {
-            std::lock_guard<decltype(c->lock)> ll(c->lock);
-            c->sensors.clear();
-        }
-
-        // Detach thread and let it exit asynchronously.
-        if (c->thread.joinable()) {
-            c->thread.detach();
-        }
+        // Clear all sensors, which makes the tasks stop.
+        c->clear();
+
+        // Wait for a tick in progress, because the context is destroyed
+        // afterwards. If the process is exiting, the scheduler has already
+        // been shut down, so this returns immediately unless a worker is
+        // stuck, in which case the wait is bounded.
+        sampler_scheduler::instance().cancel(c->task);
     }
 }
 
@@ -33,36 +31,52 @@ template<class TContext>
 bool visus::power_overwhelming::detail::sampler<TContext>::add(
         sensor_type sensor, const measurement_callback callback,
         void *user_context, const interval_type interval) {
-    if (sensor == nullptr) {
-        throw std::invalid_argument("Sensors to be sampled must be a valid "
-            "pointer.");
-    }
-    if (callback == nullptr) {
-        throw std::invalid_argument("A valid callback must be provided to "
-            "sample a sensor.");
-    }
+    return this->add_to_context(sensor, callback, user_context, interval);
+}
 
-    std::lock_guard<decltype(this->_lock)> l(this->_lock);
-    // Search a context with the same sampling interval as the requested one.
-    auto it = this->_contexts.begin();
-    for (; it != this->_contexts.end(); ++it) {
-        assert(*it != nullptr);
-        if ((**it).interval == interval) {
-            break;
-        }
-    }
 
-    if (it == this->_contexts.end()) {
-        // If we have reached the end of the context list, we have no context
-        // for the requested interval, so we need to create a new one.
-        this->_contexts.emplace_back(new context_type());
-        this->_contexts.back()->interval = interval;
-        return this->_contexts.back()->add(sensor, callback, user_context);
+/*
+ * visus::power_overwhelming::detail::sampler<TContext>::add
+ */
+template<class TContext>
+bool visus::power_overwhelming::detail::sampler<TContext>::add(
+        sensor_type sensor, const measurement_data_callback callback,
+        void *user_context, const interval_type interval) {
+    return this->add_to_context(sensor, callback, user_context, interval);
+}
 
-    } else {
-        // Otherwise, add the sensor to the existing context.
-        return (**it).add(sensor, callback, user_context);
+
+/*
+ * visus::power_overwhelming::detail::sampler<TContext>::add
+ */
+template<class TContext>
+bool visus::power_overwhelming::detail::sampler<TContext>::add(
+        sensor_type sensor, const measurement_data_callback callback,
+        void *user_context, const interval_type interval,
+        const interval_type min_interval) {
+    const auto adaptive = (min_interval > interval_type::zero())
+        && (min_interval < interval);
+    return this->add_to_context(sensor, callback, user_context, interval,
+        adaptive ? min_interval : interval_type::zero());
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sampler<TContext>::missed_deadlines
+ */
+template<class TContext>
+std::uint64_t
+visus::power_overwhelming::detail::sampler<TContext>::missed_deadlines(
+        void) const {
+    std::uint64_t retval = 0;
+
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    for (auto& c : this->_contexts) {
+        assert(c != nullptr);
+        retval += c->task.missed();
     }
+
+    return retval;
 }
 
 
@@ -92,6 +106,31 @@ bool visus::power_overwhelming::detail::sampler<TContext>::remove(
 }
 
 
+/*
+ * visus::power_overwhelming::detail::sampler<TContext>::remove
+ */
+template<class TContext>
+bool visus::power_overwhelming::detail::sampler<TContext>::remove(
+        sensor_type sensor, void *user_context) {
+    if (sensor == nullptr) {
+        // Trivial reject: we never sample nullptrs.
+        return false;
+    }
+
+    auto retval = false;
+
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    for (auto& c : this->_contexts) {
+        assert(c != nullptr);
+        if (remove_subscriber(*c, sensor, user_context, 0)) {
+            retval = true;
+        }
+    }
+
+    return retval;
+}
+
+
 /*
  * visus::power_overwhelming::detail::sampler<TContext>::samples
  */
@@ -133,3 +172,71 @@ bool visus::power_overwhelming::detail::sampler<TContext>::samples(
 
     return false;
 }
+
+
+/*
+ * visus::power_overwhelming::detail::sampler<TContext>::add_to_context
+ */
+template<class TContext>
+template<class TCallback>
+bool visus::power_overwhelming::detail::sampler<TContext>::add_to_context(
+        sensor_type sensor, const TCallback callback,
+        void *user_context, const interval_type interval,
+        const interval_type min_interval) {
+    if (sensor == nullptr) {
+        throw std::invalid_argument("Sensors to be sampled must be a valid "
+            "pointer.");
+    }
+    if (callback == nullptr) {
+        throw std::invalid_argument("A valid callback must be provided to "
+            "sample a sensor.");
+    }
+
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+
+    if ((min_interval == interval_type::zero())
+            && (interval > interval_type::zero())) {
+        // If a context with a fixed rate already reads the sensor at a rate
+        // that is a multiple of the requested one, share its reads.
+        for (auto& c : this->_contexts) {
+            assert(c != nullptr);
+            if (shares_reads(*c, 0)
+                    && (min_interval_of(*c, 0) == interval_type::zero())
+                    && (c->interval > interval_type::zero())
+                    && (c->interval <= interval)
+                    && ((interval % c->interval) == interval_type::zero())
+                    && c->samples(sensor)) {
+                const auto divisor = static_cast<std::size_t>(
+                    interval / c->interval);
+                return add_subscriber(*c, sensor, callback, user_context,
+                    divisor, 0);
+            }
+        }
+    }
+
+    // Search a context with the same sampling interval as the requested one.
+    // Adaptive contexts change their rate, so they can only be shared by
+    // sensors with the same bounds.
+    auto it = this->_contexts.begin();
+    for (; it != this->_contexts.end(); ++it) {
+        assert(*it != nullptr);
+        if (((**it).interval == interval)
+                && (min_interval_of(**it, 0) == min_interval)) {
+            break;
+        }
+    }
+
+    if (it == this->_contexts.end()) {
+        // If we have reached the end of the context list, we have no context
+        // for the requested interval, so we need to create a new one.
+        std::unique_ptr<context_type> context(new context_type());
+        context->interval = interval;
+        set_min_interval(*context, min_interval, 0);
+        this->_contexts.push_back(std::move(context));
+        return this->_contexts.back()->add(sensor, callback, user_context);
+
+    } else {
+        // Otherwise, add the sensor to the existing context.
+        return (**it).add(sensor, callback, user_context);
+    }
+}
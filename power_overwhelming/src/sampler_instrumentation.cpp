@@ -0,0 +1,198 @@
+﻿// <copyright file="sampler_instrumentation.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "sampler_instrumentation.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The list of all live instances of
+    /// <see cref="sampler_instrumentation" />.
+    /// </summary>
+    struct sampler_instrumentation_registry final {
+        std::vector<sampler_instrumentation *> instances;
+        std::mutex lock;
+    };
+
+    /// <summary>
+    /// Answer the registry of all instances.
+    /// </summary>
+    /// <remarks>
+    /// The registry is never destroyed, because the sampler contexts are
+    /// members of static samplers, which might be destroyed after a static
+    /// registry.
+    /// </remarks>
+    static sampler_instrumentation_registry& get_registry(void) {
+        static auto retval = new sampler_instrumentation_registry();
+        return *retval;
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_instrumentation::reset_all
+ */
+void visus::power_overwhelming::detail::sampler_instrumentation::reset_all(
+        void) noexcept {
+    auto& registry = get_registry();
+    std::lock_guard<decltype(registry.lock)> l(registry.lock);
+    for (auto i : registry.instances) {
+        i->reset();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_instrumentation::snapshot_all
+ */
+void visus::power_overwhelming::detail::sampler_instrumentation::snapshot_all(
+        _Inout_ std::vector<sampler_statistics_impl>& dst) {
+    auto& registry = get_registry();
+    std::lock_guard<decltype(registry.lock)> l(registry.lock);
+    dst.reserve(dst.size() + registry.instances.size());
+
+    for (auto i : registry.instances) {
+        if (i->_ticks.load(std::memory_order_relaxed) > 0) {
+            dst.emplace_back();
+            i->snapshot(dst.back());
+        }
+    }
+}
+
+
+/*
+ * ...::detail::sampler_instrumentation::sampler_instrumentation
+ */
+visus::power_overwhelming::detail::sampler_instrumentation
+::sampler_instrumentation(_In_ const sampler_scheduler::task& task)
+        : _missed_base(0), _overruns(0), _task(task), _ticks(0) {
+    auto& registry = get_registry();
+    std::lock_guard<decltype(registry.lock)> l(registry.lock);
+    registry.instances.push_back(this);
+}
+
+
+/*
+ * ...::detail::sampler_instrumentation::~sampler_instrumentation
+ */
+visus::power_overwhelming::detail::sampler_instrumentation
+::~sampler_instrumentation(void) {
+    auto& registry = get_registry();
+    std::lock_guard<decltype(registry.lock)> l(registry.lock);
+    auto it = std::find(registry.instances.begin(), registry.instances.end(),
+        this);
+    assert(it != registry.instances.end());
+    registry.instances.erase(it);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_instrumentation::begin_tick
+ */
+visus::power_overwhelming::detail::sampler_instrumentation::clock_type
+::time_point visus::power_overwhelming::detail::sampler_instrumentation
+::begin_tick(void) noexcept {
+    const auto retval = clock_type::now();
+    this->_jitter.record(retval - this->_task.deadline());
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_instrumentation::end_tick
+ */
+void visus::power_overwhelming::detail::sampler_instrumentation::end_tick(
+        _In_ const clock_type::time_point begin) noexcept {
+    const auto elapsed = clock_type::now() - begin;
+    if (elapsed > this->_task.interval()) {
+        this->_overruns.fetch_add(1, std::memory_order_relaxed);
+    }
+    this->_ticks.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_instrumentation::reset
+ */
+void visus::power_overwhelming::detail::sampler_instrumentation::reset(
+        void) noexcept {
+    this->_callback_duration.reset();
+    this->_jitter.reset();
+    this->_missed_base.store(this->_task.missed(), std::memory_order_relaxed);
+    this->_overruns.store(0, std::memory_order_relaxed);
+    this->_ticks.store(0, std::memory_order_relaxed);
+
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    for (auto& s : this->_sources) {
+        s.second->reset();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_instrumentation::sample_duration
+ */
+visus::power_overwhelming::detail::sampler_instrumentation::histogram_type&
+visus::power_overwhelming::detail::sampler_instrumentation::sample_duration(
+        _In_z_ const wchar_t *source) {
+    if (source == nullptr) {
+        throw std::invalid_argument("The source of samples must have a "
+            "name.");
+    }
+
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    auto& retval = this->_sources[source];
+    if (retval == nullptr) {
+        retval.reset(new histogram_type());
+    }
+
+    return *retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_instrumentation::snapshot
+ */
+void visus::power_overwhelming::detail::sampler_instrumentation::snapshot(
+        _Out_ sampler_statistics_impl& dst) const {
+    this->_callback_duration.snapshot(dst.callback_duration);
+    dst.interval = std::chrono::duration_cast<std::chrono::microseconds>(
+        this->_task.interval()).count();
+    this->_jitter.snapshot(dst.jitter);
+    dst.overruns = this->_overruns.load(std::memory_order_relaxed);
+    dst.ticks = this->_ticks.load(std::memory_order_relaxed);
+
+    {
+        // The task restarts counting if it is scheduled anew, in which case
+        // the baseline of the last reset does not apply anymore.
+        const auto missed = this->_task.missed();
+        const auto base = this->_missed_base.load(std::memory_order_relaxed);
+        dst.missed_deadlines = (missed >= base) ? missed - base : missed;
+    }
+
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    dst.sources.clear();
+    dst.sources.reserve(this->_sources.size());
+    for (auto& s : this->_sources) {
+        dst.sources.emplace_back(s.first, latency_histogram());
+        s.second->snapshot(dst.sources.back().second);
+
+        // Sensors that have been removed retain their histogram, but we do
+        // not report them after the statistics have been reset.
+        if (dst.sources.back().second.count() == 0) {
+            dst.sources.pop_back();
+        }
+    }
+}
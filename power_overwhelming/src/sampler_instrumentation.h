@@ -0,0 +1,157 @@
+﻿// <copyright file="sampler_instrumentation.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <cinttypes>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "atomic_latency_histogram.h"
+#include "sampler_scheduler.h"
+#include "sampler_statistics_impl.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Records how well the <see cref="sampler_scheduler::task" /> of a
+    /// sampler context keeps time.
+    /// </summary>
+    /// <remarks>
+    /// <para>Each sampler context embeds an instance, which registers itself
+    /// in a process-wide list such that <see cref="sampler_statistics" /> can
+    /// enumerate all of them. The task of the context calls
+    /// <see cref="begin_tick" /> and <see cref="end_tick" /> around its work
+    /// and records the durations of obtaining samples and invoking callbacks
+    /// in between.</para>
+    /// <para>Recording is lock-free. Only <see cref="sample_duration" />,
+    /// which creates the histogram of a source on first use, takes a lock
+    /// and should therefore be called when a sensor is added rather than
+    /// while sampling.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API sampler_instrumentation final {
+
+    public:
+
+        /// <summary>
+        /// The clock used for measuring the durations.
+        /// </summary>
+        typedef sampler_scheduler::clock_type clock_type;
+
+        /// <summary>
+        /// The type of the histograms recorded into.
+        /// </summary>
+        typedef atomic_latency_histogram histogram_type;
+
+        /// <summary>
+        /// Restarts the statistics of all instances.
+        /// </summary>
+        static void reset_all(void) noexcept;
+
+        /// <summary>
+        /// Retrieves the statistics of all instances that have recorded at
+        /// least one tick.
+        /// </summary>
+        /// <param name="dst">Receives the statistics, which are appended.
+        /// </param>
+        static void snapshot_all(
+            _Inout_ std::vector<sampler_statistics_impl>& dst);
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="task">The task of the sampler context, which must
+        /// live as long as the instance. It provides the deadlines, the
+        /// interval and the missed deadlines.</param>
+        explicit sampler_instrumentation(
+            _In_ const sampler_scheduler::task& task);
+
+        sampler_instrumentation(const sampler_instrumentation&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~sampler_instrumentation(void);
+
+        /// <summary>
+        /// Records the begin of a tick.
+        /// </summary>
+        /// <remarks>
+        /// This method must only be called from within the callback of the
+        /// task, because it obtains the deadline of the tick from there.
+        /// </remarks>
+        /// <returns>The current time, which needs to be passed to
+        /// <see cref="end_tick" />.</returns>
+        clock_type::time_point begin_tick(void) noexcept;
+
+        /// <summary>
+        /// Answer the histogram of the durations of the user-defined
+        /// callbacks.
+        /// </summary>
+        /// <returns>The histogram to record into.</returns>
+        inline histogram_type& callback_duration(void) noexcept {
+            return this->_callback_duration;
+        }
+
+        /// <summary>
+        /// Records the end of the tick that started at
+        /// <paramref name="begin" />.
+        /// </summary>
+        /// <param name="begin">The value returned by <see cref="begin_tick" />.
+        /// </param>
+        void end_tick(_In_ const clock_type::time_point begin) noexcept;
+
+        /// <summary>
+        /// Restarts the statistics.
+        /// </summary>
+        void reset(void) noexcept;
+
+        /// <summary>
+        /// Answer the histogram of the durations of obtaining samples from
+        /// the given source.
+        /// </summary>
+        /// <remarks>
+        /// The histogram is created on first use and lives as long as the
+        /// instance, so callers may cache the reference.
+        /// </remarks>
+        /// <param name="source">The name of the source, which is typically
+        /// the name of a sensor.</param>
+        /// <returns>The histogram to record into.</returns>
+        histogram_type& sample_duration(_In_z_ const wchar_t *source);
+
+        /// <summary>
+        /// Retrieves the current statistics.
+        /// </summary>
+        /// <param name="dst">Receives the statistics.</param>
+        void snapshot(_Out_ sampler_statistics_impl& dst) const;
+
+        sampler_instrumentation& operator =(
+            const sampler_instrumentation&) = delete;
+
+    private:
+
+        typedef std::map<std::wstring, std::unique_ptr<histogram_type>>
+            source_map_type;
+
+        histogram_type _callback_duration;
+        histogram_type _jitter;
+        mutable std::mutex _lock;
+        std::atomic<std::uint64_t> _missed_base;
+        std::atomic<std::uint64_t> _overruns;
+        source_map_type _sources;
+        const sampler_scheduler::task& _task;
+        std::atomic<std::uint64_t> _ticks;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,565 @@
+﻿// <copyright file="sampler_scheduler.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "sampler_scheduler.h"
+
+#include <algorithm>
+#include <cassert>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#endif /* defined(_WIN32) */
+
+#include "library_thread.h"
+#include "on_exit.h"
+#include "start_barrier.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The task whose callback is currently running on the calling thread.
+    /// </summary>
+    static thread_local const sampler_scheduler::task *current_task = nullptr;
+
+    /// <summary>
+    /// Answer how long a worker should spin before a deadline of a task with
+    /// the given interval.
+    /// </summary>
+    static sampler_scheduler::interval_type spin_time(
+            _In_ const sampler_scheduler::interval_type interval) noexcept {
+        return (interval <= periodic_timer::spin_limit)
+            ? (std::min)(periodic_timer::spin_time, interval / 2)
+            : sampler_scheduler::interval_type::zero();
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_scheduler::task::task
+ */
+visus::power_overwhelming::detail::sampler_scheduler::task::task(
+        _In_ const callback_type callback, _In_opt_ void *context)
+    : _callback(callback), _cancelled(false), _context(context),
+        _generation(0), _interval(interval_type(1)), _missed(0),
+        _rescheduled(false), _restart(false), _spin(0),
+        _state(state_type::idle) {
+    assert(this->_callback != nullptr);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_scheduler::task::current
+ */
+const visus::power_overwhelming::detail::sampler_scheduler::task *
+visus::power_overwhelming::detail::sampler_scheduler::task::current(
+        void) noexcept {
+    return current_task;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_scheduler::task::executing
+ */
+bool visus::power_overwhelming::detail::sampler_scheduler::task::executing(
+        void) const noexcept {
+    return (current_task == this);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_scheduler::task::restart
+ */
+void visus::power_overwhelming::detail::sampler_scheduler::task::restart(
+        _In_ const interval_type interval) noexcept {
+    assert(this->executing());
+    const auto i = (std::max)(interval, interval_type(1));
+    this->_interval.store(i, std::memory_order_relaxed);
+    this->_restart = true;
+    this->_spin = spin_time(i);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_scheduler::barrier_poll
+ */
+constexpr visus::power_overwhelming::detail::sampler_scheduler::interval_type
+visus::power_overwhelming::detail::sampler_scheduler::barrier_poll;
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_scheduler::max_workers
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::sampler_scheduler::max_workers;
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_scheduler::shutdown_timeout
+ */
+constexpr visus::power_overwhelming::detail::sampler_scheduler::interval_type
+visus::power_overwhelming::detail::sampler_scheduler::shutdown_timeout;
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_scheduler::wait_slack
+ */
+constexpr visus::power_overwhelming::detail::sampler_scheduler::interval_type
+visus::power_overwhelming::detail::sampler_scheduler::wait_slack;
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_scheduler::instance
+ */
+visus::power_overwhelming::detail::sampler_scheduler&
+visus::power_overwhelming::detail::sampler_scheduler::instance(void) {
+    static auto retval = new sampler_scheduler();
+    // The guard is destroyed before all static objects that have been created
+    // before the first call, in particular the samplers of the sensors.
+    static const auto guard = on_exit([](void) { retval->shutdown(); });
+    return *retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_scheduler::cancel
+ */
+void visus::power_overwhelming::detail::sampler_scheduler::cancel(
+        _In_ task& task, _In_ const bool wait) {
+    std::unique_lock<decltype(this->_lock)> l(this->_lock);
+    task._rescheduled = false;
+
+    switch (task._state) {
+        case task::state_type::held:
+            this->_held.erase(std::remove(this->_held.begin(),
+                this->_held.end(), &task), this->_held.end());
+            task._state = task::state_type::idle;
+            break;
+
+        case task::state_type::queued:
+            this->_queue.erase(task._position);
+            task._state = task::state_type::idle;
+            break;
+
+        case task::state_type::executing:
+            // The worker drops the task once the tick has completed.
+            task._cancelled = true;
+            if (wait && !task.executing()) {
+                const auto completed = [&task](void) {
+                    return (task._state != task::state_type::executing);
+                };
+
+                if (this->_stopping) {
+                    // The worker running the task might have been detached
+                    // while it was blocked, so do not wait forever.
+                    this->_done.wait_for(l, shutdown_timeout, completed);
+                } else {
+                    this->_done.wait(l, completed);
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_scheduler::manual
+ */
+bool visus::power_overwhelming::detail::sampler_scheduler::manual(
+        void) const {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    return this->_manual;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_scheduler::manual
+ */
+void visus::power_overwhelming::detail::sampler_scheduler::manual(
+        _In_ const bool enable) {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    this->_manual = enable;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_scheduler::pump
+ */
+std::size_t visus::power_overwhelming::detail::sampler_scheduler::pump(
+        _In_ const clock_type::time_point now,
+        _In_ const interval_type budget) {
+    const auto begin = clock_type::now();
+    std::size_t retval = 0;
+
+    std::unique_lock<decltype(this->_lock)> l(this->_lock);
+    this->release_held();
+
+    while (!this->_queue.empty() && (this->_queue.begin()->first <= now)) {
+        if ((retval > 0) && (budget > interval_type::zero())
+                && (clock_type::now() - begin >= budget)) {
+            break;
+        }
+
+        // Claim the task like a worker does such that cancel() waits for it.
+        auto task = this->_queue.begin()->second;
+        this->_queue.erase(this->_queue.begin());
+        task->_state = task::state_type::executing;
+        l.unlock();
+
+        current_task = task;
+        const auto keep = task->_callback(task->_context);
+        current_task = nullptr;
+
+        l.lock();
+        // Note: completing the task before the next one is claimed makes sure
+        // that a task that is still late is not run twice in a row.
+        this->complete(*task, keep);
+        this->_done.notify_all();
+        ++retval;
+    }
+
+    // A worker might be waiting for a head we have just consumed.
+    this->notify();
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_scheduler::schedule
+ */
+void visus::power_overwhelming::detail::sampler_scheduler::schedule(
+        _In_ task& task, _In_ const interval_type interval) {
+    const auto i = (std::max)(interval, interval_type(1));
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+
+    if (this->_stopping) {
+        // The process is exiting, so we must not start any workers again.
+        return;
+    }
+
+    if (task._state == task::state_type::executing) {
+        // The task is in its last tick, so we must not enqueue it twice, but
+        // let the worker restart it afterwards.
+        task._cancelled = false;
+        task._interval.store(i, std::memory_order_relaxed);
+        task._rescheduled = true;
+        return;
+    }
+
+    if (task._state != task::state_type::idle) {
+        // Task is already being scheduled, so there is nothing to do.
+        return;
+    }
+
+    task._interval.store(i, std::memory_order_relaxed);
+    this->enqueue(task);
+
+    if (this->_workers.empty() && !this->_manual) {
+        // Start the pool on demand such that processes not sampling anything
+        // do not have any threads. In manual mode, the application runs the
+        // tasks via pump().
+        const auto hw = static_cast<std::size_t>(
+            std::thread::hardware_concurrency());
+        const auto cnt = (std::max)(std::size_t(1),
+            (std::min)(max_workers, hw));
+        for (std::size_t w = 0; w < cnt; ++w) {
+            this->_workers.emplace_back(&sampler_scheduler::work, this);
+            ++this->_running;
+        }
+    }
+
+    this->_cv.notify_all();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_scheduler::shutdown
+ */
+void visus::power_overwhelming::detail::sampler_scheduler::shutdown(
+        _In_ const interval_type timeout) noexcept {
+    std::vector<std::thread> workers;
+    auto exited = false;
+
+    try {
+        std::unique_lock<decltype(this->_lock)> l(this->_lock);
+        this->_stopping = true;
+        workers = std::move(this->_workers);
+        this->_workers.clear();
+        this->_cv.notify_all();
+
+#if defined(_WIN32)
+        // Wait for the thread handles rather than for the workers to
+        // signal their exit, because the workers have already been
+        // terminated without signalling anything at process exit.
+        l.unlock();
+        std::vector<HANDLE> handles;
+        handles.reserve(workers.size());
+        for (auto& w : workers) {
+            handles.push_back(w.native_handle());
+        }
+
+        const auto millis = std::chrono::duration_cast<
+            std::chrono::milliseconds>(timeout).count();
+        exited = handles.empty() || (::WaitForMultipleObjects(
+            static_cast<DWORD>(handles.size()), handles.data(), TRUE,
+            static_cast<DWORD>(millis)) < WAIT_OBJECT_0 + handles.size());
+#else /* defined(_WIN32) */
+        exited = this->_done.wait_for(l, timeout, [this](void) {
+            return (this->_running == 0);
+        });
+#endif /* defined(_WIN32) */
+    } catch (...) {
+        exited = false;
+    }
+
+    for (auto& w : workers) {
+        try {
+            if (exited) {
+                w.join();
+            } else {
+                w.detach();
+            }
+        } catch (...) { /* Nothing we could do here. */ }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_scheduler::workers
+ */
+std::size_t visus::power_overwhelming::detail::sampler_scheduler::workers(
+        void) const {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    return this->_workers.size();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_scheduler::sampler_scheduler
+ */
+visus::power_overwhelming::detail::sampler_scheduler::sampler_scheduler(void)
+    : _leader(false), _manual(false), _running(0), _stopping(false) { }
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_scheduler::notify
+ */
+void visus::power_overwhelming::detail::sampler_scheduler::notify(void) {
+    if (this->_queue.empty()) {
+        return;
+    }
+
+    const auto head = this->_queue.begin();
+    const auto wake_up = head->first - head->second->_spin - wait_slack;
+
+    // Only wake the leader if it waits for a later instant than the new head
+    // of the queue, because each wake-up costs power.
+    if (!this->_leader || (wake_up < this->_timeout)) {
+        this->_cv.notify_all();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_scheduler::complete
+ */
+void visus::power_overwhelming::detail::sampler_scheduler::complete(
+        _In_ task& task, _In_ const bool keep) {
+    assert(task._state == task::state_type::executing);
+    const auto restart = task._restart;
+    task._restart = false;
+
+    if (task._cancelled) {
+        task._cancelled = false;
+        task._state = task::state_type::idle;
+        return;
+    }
+
+    if (task._rescheduled) {
+        task._rescheduled = false;
+        this->enqueue(task);
+        return;
+    }
+
+    if (!keep) {
+        task._state = task::state_type::idle;
+        return;
+    }
+
+    const auto interval = task.interval();
+    const auto now = clock_type::now();
+
+    if (restart) {
+        task._deadline = now + interval;
+
+    } else {
+        task._deadline += interval;
+
+        if (now > task._deadline) {
+            // We are late. If we are later than a whole interval, there is no
+            // way to recover the samples, so we skip those deadlines like the
+            // periodic_timer does.
+            const auto skipped = static_cast<std::uint64_t>(
+                (now - task._deadline) / interval);
+            task._missed.fetch_add(skipped, std::memory_order_relaxed);
+            task._deadline += skipped * interval;
+        }
+    }
+
+    task._position = this->_queue.emplace(task._deadline, &task);
+    task._state = task::state_type::queued;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_scheduler::enqueue
+ */
+void visus::power_overwhelming::detail::sampler_scheduler::enqueue(
+        _In_ task& task) {
+    task._missed.store(0, std::memory_order_relaxed);
+    task._spin = spin_time(task.interval());
+
+    if (start_barrier::armed(task._generation)) {
+        // If multiple sensors are being started at once, wait for all of them
+        // such that the first sample is taken on a common tick.
+        this->_held.push_back(&task);
+        task._state = task::state_type::held;
+
+    } else {
+        task._deadline = clock_type::now();
+        task._position = this->_queue.emplace(task._deadline, &task);
+        task._state = task::state_type::queued;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_scheduler::release_held
+ */
+void visus::power_overwhelming::detail::sampler_scheduler::release_held(
+        void) {
+    auto it = this->_held.begin();
+
+    while (it != this->_held.end()) {
+        auto task = *it;
+        clock_type::time_point origin;
+
+        if (start_barrier::released(task->_generation, origin)) {
+            task->_deadline = origin;
+            task->_position = this->_queue.emplace(task->_deadline, task);
+            task->_state = task::state_type::queued;
+            it = this->_held.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sampler_scheduler::work
+ */
+void visus::power_overwhelming::detail::sampler_scheduler::work(void) {
+    std::vector<std::pair<task *, bool>> due;
+    periodic_timer timer;
+
+    enter_library_thread("PwrOwg Sampler Worker Thread");
+
+    std::unique_lock<decltype(this->_lock)> l(this->_lock);
+
+    while (!this->_stopping) {
+        if (this->_leader) {
+            // Another worker is already waiting for the next deadline, so we
+            // wait until it hands over or the queue changes.
+            this->_cv.wait(l);
+            continue;
+        }
+
+        this->release_held();
+
+        if (this->_queue.empty()) {
+            if (this->_held.empty()) {
+                this->_cv.wait(l);
+            } else {
+                this->_cv.wait_for(l, barrier_poll);
+            }
+            continue;
+        }
+
+        const auto now = clock_type::now();
+        const auto head = this->_queue.begin();
+        const auto deadline = head->first;
+        const auto wake_up = deadline - head->second->_spin;
+
+        if (now + wait_slack < wake_up) {
+            // Become the leader, which waits for the next deadline while
+            // remaining responsive to new tasks that might be due earlier.
+            auto timeout = wake_up - wait_slack;
+            if (!this->_held.empty()) {
+                timeout = (std::min)(timeout, now + barrier_poll);
+            }
+
+            this->_leader = true;
+            this->_timeout = timeout;
+            this->_cv.wait_until(l, timeout);
+            this->_leader = false;
+            continue;
+        }
+
+        // Claim all tasks sharing the deadline of the head and hand over to
+        // another worker if there are tasks with later deadlines.
+        due.clear();
+        while (!this->_queue.empty()
+                && (this->_queue.begin()->first <= deadline)) {
+            auto task = this->_queue.begin()->second;
+            this->_queue.erase(this->_queue.begin());
+            task->_state = task::state_type::executing;
+            due.emplace_back(task, true);
+        }
+
+        if (!this->_queue.empty() || !this->_held.empty()) {
+            this->_cv.notify_all();
+        }
+
+        l.unlock();
+
+        if (clock_type::now() < wake_up) {
+            timer.sleep_until(wake_up);
+        }
+        while (clock_type::now() < deadline) {
+            std::this_thread::yield();
+        }
+
+        for (auto& d : due) {
+            current_task = d.first;
+            d.second = d.first->_callback(d.first->_context);
+            current_task = nullptr;
+        }
+
+        l.lock();
+
+        for (auto& d : due) {
+            this->complete(*d.first, d.second);
+        }
+
+        this->_done.notify_all();
+        this->notify();
+    }
+
+    // Hand over to the other workers, which might wait for the leader, and
+    // signal the exit to shutdown().
+    --this->_running;
+    this->_cv.notify_all();
+    this->_done.notify_all();
+}
@@ -0,0 +1,410 @@
+﻿// <copyright file="sampler_scheduler.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cinttypes>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+#include "periodic_timer.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A process-wide pool of threads that periodically invokes the sampling
+    /// ticks of all sampler contexts.
+    /// </summary>
+    /// <remarks>
+    /// <para>Instead of running a thread per sensor family and sampling
+    /// interval, the sampler contexts register a <see cref="task" /> with the
+    /// scheduler, which keeps all tasks in a single queue ordered by their
+    /// next deadline. If no task is due, only one of the workers waits for the
+    /// next deadline while the others are blocked without a timeout, and all
+    /// tasks sharing a deadline are run on a single wake-up. This minimises
+    /// the number of threads, context switches and wake-ups, which is
+    /// important when measuring idle power.</para>
+    /// <para>The deadlines of each task are computed like the ones of a
+    /// <see cref="periodic_timer" />, ie the time spent in a tick does not
+    /// shift the schedule, and the workers spin for a short time before
+    /// deadlines of short intervals. Tasks that are scheduled while the
+    /// <see cref="start_barrier" /> is armed are held back until it is
+    /// released and start from the instant of the release.</para>
+    /// <para>As all tasks sharing a deadline are run one after the other,
+    /// ticks should not block for a significant part of their interval.
+    /// Tasks with other deadlines are served by the other workers in the
+    /// meantime.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API sampler_scheduler final {
+
+    public:
+
+        /// <summary>
+        /// The clock used to compute the deadlines.
+        /// </summary>
+        typedef periodic_timer::clock_type clock_type;
+
+        /// <summary>
+        /// The type to express sampling intervals.
+        /// </summary>
+        typedef periodic_timer::interval_type interval_type;
+
+        /// <summary>
+        /// A periodic activity that is run by the scheduler.
+        /// </summary>
+        /// <remarks>
+        /// The task is typically embedded in a sampler context, which must
+        /// make sure to <see cref="sampler_scheduler::cancel" /> it before it
+        /// is destroyed.
+        /// </remarks>
+        class POWER_OVERWHELMING_API task final {
+
+        public:
+
+            /// <summary>
+            /// Answer the task whose callback is running on the calling
+            /// thread.
+            /// </summary>
+            /// <remarks>
+            /// The ticks of a task never overlap, but they may be run on
+            /// different threads. Code that needs to keep state per sampling
+            /// activity rather than per thread can therefore use the task as
+            /// key.
+            /// </remarks>
+            /// <returns>The task being run, or <c>nullptr</c> if the calling
+            /// thread is not within the callback of any task.</returns>
+            static const task *current(void) noexcept;
+
+            /// <summary>
+            /// The callback invoked on every tick, which answers whether the
+            /// task should continue to be scheduled.
+            /// </summary>
+            typedef bool (*callback_type)(_In_ void *context);
+
+            /// <summary>
+            /// Initialises a new instance.
+            /// </summary>
+            /// <param name="callback">The callback to be invoked on every
+            /// tick.</param>
+            /// <param name="context">A user-defined pointer passed to the
+            /// <paramref name="callback" />.</param>
+            task(_In_ const callback_type callback, _In_opt_ void *context);
+
+            task(const task&) = delete;
+
+            /// <summary>
+            /// Answer the instant at which the current tick was due.
+            /// </summary>
+            /// <remarks>
+            /// This method must only be called from within the callback of
+            /// the task.
+            /// </remarks>
+            /// <returns>The deadline of the running tick.</returns>
+            inline clock_type::time_point deadline(void) const noexcept {
+                return this->_deadline;
+            }
+
+            /// <summary>
+            /// Answer whether the calling thread is currently running the
+            /// callback of the task.
+            /// </summary>
+            /// <returns><c>true</c> if the caller is within the callback,
+            /// <c>false</c> otherwise.</returns>
+            bool executing(void) const noexcept;
+
+            /// <summary>
+            /// Answer the current interval between two ticks.
+            /// </summary>
+            /// <returns>The interval of the task.</returns>
+            inline interval_type interval(void) const noexcept {
+                return this->_interval.load(std::memory_order_relaxed);
+            }
+
+            /// <summary>
+            /// Answer the number of deadlines that have been missed since the
+            /// task has been scheduled.
+            /// </summary>
+            /// <returns>The number of ticks that have been skipped.</returns>
+            inline std::uint64_t missed(void) const noexcept {
+                return this->_missed.load(std::memory_order_relaxed);
+            }
+
+            /// <summary>
+            /// Changes the interval of the task such that the next tick is one
+            /// new interval from now.
+            /// </summary>
+            /// <remarks>
+            /// This method must only be called from within the callback of
+            /// the task.
+            /// </remarks>
+            /// <param name="interval">The new interval between two ticks.
+            /// </param>
+            void restart(_In_ const interval_type interval) noexcept;
+
+            task& operator =(const task&) = delete;
+
+        private:
+
+            /// <summary>
+            /// The states a task can be in.
+            /// </summary>
+            enum class state_type {
+                idle,
+                held,
+                queued,
+                executing
+            };
+
+            typedef std::multimap<clock_type::time_point, task *> queue_type;
+
+            callback_type _callback;
+            bool _cancelled;
+            void *_context;
+            clock_type::time_point _deadline;
+            std::uint64_t _generation;
+            std::atomic<interval_type> _interval;
+            std::atomic<std::uint64_t> _missed;
+            queue_type::iterator _position;
+            bool _rescheduled;
+            bool _restart;
+            interval_type _spin;
+            state_type _state;
+
+            friend class sampler_scheduler;
+        };
+
+        /// <summary>
+        /// The time between two checks whether the
+        /// <see cref="start_barrier" /> has been released while any task is
+        /// held back.
+        /// </summary>
+        static constexpr interval_type barrier_poll
+            = std::chrono::milliseconds(1);
+
+        /// <summary>
+        /// The maximum number of worker threads in the pool.
+        /// </summary>
+        static constexpr std::size_t max_workers = 2;
+
+        /// <summary>
+        /// The maximum time <see cref="shutdown" /> waits for the workers to
+        /// exit by default.
+        /// </summary>
+        static constexpr interval_type shutdown_timeout
+            = std::chrono::milliseconds(500);
+
+        /// <summary>
+        /// The time before the deadline at which a waiting worker switches
+        /// from waiting for new tasks to precisely sleeping until the
+        /// deadline.
+        /// </summary>
+        /// <remarks>
+        /// Timeouts of condition variables on Windows have the resolution of
+        /// the system timer, so the last part of a wait needs to be done
+        /// using the high-resolution timer of <see cref="periodic_timer" />.
+        /// </remarks>
+#if defined(_WIN32)
+        static constexpr interval_type wait_slack
+            = std::chrono::milliseconds(16);
+#else /* defined(_WIN32) */
+        static constexpr interval_type wait_slack = interval_type::zero();
+#endif /* defined(_WIN32) */
+
+        /// <summary>
+        /// Answer the only instance of the scheduler.
+        /// </summary>
+        /// <remarks>
+        /// The instance is never destroyed, because the sampler contexts of
+        /// the sensors are static objects themselves, which might be
+        /// destroyed after the scheduler otherwise. However, the workers are
+        /// stopped by <see cref="shutdown" /> when the static objects are
+        /// destroyed at exit, before any sampler context that has been
+        /// created before the first task was scheduled.
+        /// </remarks>
+        /// <returns>The scheduler.</returns>
+        static sampler_scheduler& instance(void);
+
+        sampler_scheduler(const sampler_scheduler&) = delete;
+
+        /// <summary>
+        /// Stops scheduling the given task.
+        /// </summary>
+        /// <remarks>
+        /// It is safe to cancel a task that is not scheduled.
+        /// </remarks>
+        /// <param name="task">The task to be cancelled.</param>
+        /// <param name="wait">If <c>true</c> and a worker is currently
+        /// running the task, block until the tick has completed. The method
+        /// never blocks if called from within the callback of the task. After
+        /// <see cref="shutdown" />, the method blocks at most for
+        /// <see cref="shutdown_timeout" />.</param>
+        void cancel(_In_ task& task, _In_ const bool wait = true);
+
+        /// <summary>
+        /// Answer whether the scheduler is in manual mode.
+        /// </summary>
+        /// <returns><c>true</c> if the tasks are only run by
+        /// <see cref="pump" />, <c>false</c> if worker threads are started on
+        /// demand.</returns>
+        bool manual(void) const;
+
+        /// <summary>
+        /// Enables or disables the manual mode.
+        /// </summary>
+        /// <remarks>
+        /// <para>In manual mode, <see cref="schedule" /> does not start any
+        /// worker threads, but the application runs the due tasks on its own
+        /// thread by calling <see cref="pump" />. Workers that have already
+        /// been started keep running, so the mode should be enabled before
+        /// the first task is scheduled.</para>
+        /// <para>Disabling the manual mode starts the workers on the next
+        /// call to <see cref="schedule" />.</para>
+        /// </remarks>
+        /// <param name="enable">Whether to enable the manual mode.</param>
+        void manual(_In_ const bool enable);
+
+        /// <summary>
+        /// Runs all tasks that are due at <paramref name="now" /> on the
+        /// calling thread.
+        /// </summary>
+        /// <remarks>
+        /// <para>The tasks are run in the order of their deadlines and
+        /// rescheduled like on a worker thread, ie a task that is late by more
+        /// than an interval skips the deadlines it missed. Tasks held back by
+        /// an armed <see cref="start_barrier" /> are released first.</para>
+        /// <para>If <paramref name="budget" /> is exhausted, the remaining
+        /// tasks stay due and are run by the next call. At least one task is
+        /// run per call to make sure that a small budget does not starve all
+        /// tasks.</para>
+        /// <para>The method is intended for the manual mode, but it is also
+        /// safe to call it while workers are running.</para>
+        /// </remarks>
+        /// <param name="now">The point in time up to which the tasks are
+        /// due.</param>
+        /// <param name="budget">The time the method may spend on running
+        /// tasks, or zero for running all due tasks.</param>
+        /// <returns>The number of ticks that have been run.</returns>
+        std::size_t pump(_In_ const clock_type::time_point now,
+            _In_ const interval_type budget = interval_type::zero());
+
+        /// <summary>
+        /// Starts periodically running the given task.
+        /// </summary>
+        /// <remarks>
+        /// <para>The first tick is due immediately, or at the instant the
+        /// <see cref="start_barrier" /> is released if it is armed.</para>
+        /// <para>If the task is currently in its last tick, ie the callback
+        /// is about to return <c>false</c>, it is scheduled anew after the
+        /// tick has completed.</para>
+        /// </remarks>
+        /// <param name="task">The task to be scheduled. The task must live
+        /// until it has been cancelled or its callback returned
+        /// <c>false</c>.</param>
+        /// <param name="interval">The interval between two ticks.</param>
+        void schedule(_In_ task& task, _In_ const interval_type interval);
+
+        /// <summary>
+        /// Stops all workers and joins them.
+        /// </summary>
+        /// <remarks>
+        /// <para>Workers waiting for a deadline are woken immediately, so the
+        /// method does not need to wait out the interval of any task, but only
+        /// for the ticks that are currently running.</para>
+        /// <para>Workers that do not exit within <paramref name="timeout" />,
+        /// e.g. because a tick blocks or because the loader lock prevents them
+        /// from exiting while the library is being unloaded on Windows, are
+        /// detached, which is safe because the scheduler is never destroyed.
+        /// Workers that have already been terminated by the system, which is
+        /// the case at process exit on Windows, are joined without waiting.
+        /// </para>
+        /// <para>Tasks scheduled after the shutdown are not run anymore. The
+        /// method is called automatically when the static objects are
+        /// destroyed at exit.</para>
+        /// </remarks>
+        /// <param name="timeout">The maximum time to wait for the workers to
+        /// exit.</param>
+        void shutdown(_In_ const interval_type timeout
+            = shutdown_timeout) noexcept;
+
+        /// <summary>
+        /// Answer the number of worker threads that have been started.
+        /// </summary>
+        /// <returns>The number of workers.</returns>
+        std::size_t workers(void) const;
+
+        sampler_scheduler& operator =(const sampler_scheduler&) = delete;
+
+    private:
+
+        typedef task::queue_type queue_type;
+
+        sampler_scheduler(void);
+
+        /// <summary>
+        /// Finishes a tick of <paramref name="task" /> and decides about its
+        /// next deadline.
+        /// </summary>
+        /// <remarks>
+        /// The caller must hold <see cref="_lock" />.
+        /// </remarks>
+        void complete(_In_ task& task, _In_ const bool keep);
+
+        /// <summary>
+        /// Enqueues a task that has not been scheduled before.
+        /// </summary>
+        /// <remarks>
+        /// The caller must hold <see cref="_lock" />.
+        /// </remarks>
+        void enqueue(_In_ task& task);
+
+        /// <summary>
+        /// Wakes the workers if the head of the queue is due before the
+        /// instant the leader is waiting for.
+        /// </summary>
+        /// <remarks>
+        /// The caller must hold <see cref="_lock" />.
+        /// </remarks>
+        void notify(void);
+
+        /// <summary>
+        /// Moves all tasks that are held back by a released start barrier to
+        /// the queue.
+        /// </summary>
+        /// <remarks>
+        /// The caller must hold <see cref="_lock" />.
+        /// </remarks>
+        void release_held(void);
+
+        /// <summary>
+        /// The method running in the worker threads.
+        /// </summary>
+        void work(void);
+
+        std::condition_variable _cv;
+        std::condition_variable _done;
+        std::vector<task *> _held;
+        bool _leader;
+        mutable std::mutex _lock;
+        bool _manual;
+        queue_type _queue;
+        std::size_t _running;
+        bool _stopping;
+        clock_type::time_point _timeout;
+        std::vector<std::thread> _workers;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,218 @@
+﻿// <copyright file="sampler_statistics.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/sampler_statistics.h"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+#include "sampler_instrumentation.h"
+#include "sampler_statistics_impl.h"
+
+
+/*
+ * visus::power_overwhelming::sampler_statistics::for_all
+ */
+std::size_t visus::power_overwhelming::sampler_statistics::for_all(
+        _Out_writes_opt_(cnt_statistics) sampler_statistics *out_statistics,
+        _In_ const std::size_t cnt_statistics) {
+    std::vector<detail::sampler_statistics_impl> statistics;
+    detail::sampler_instrumentation::snapshot_all(statistics);
+
+    if (out_statistics != nullptr) {
+        const auto cnt = (std::min)(cnt_statistics, statistics.size());
+        for (std::size_t i = 0; i < cnt; ++i) {
+            auto& impl = out_statistics[i]._impl;
+            if (impl == nullptr) {
+                impl = new detail::sampler_statistics_impl();
+            }
+            *impl = std::move(statistics[i]);
+        }
+    }
+
+    return statistics.size();
+}
+
+
+/*
+ * visus::power_overwhelming::sampler_statistics::reset_all
+ */
+void visus::power_overwhelming::sampler_statistics::reset_all(void) noexcept {
+    detail::sampler_instrumentation::reset_all();
+}
+
+
+/*
+ * visus::power_overwhelming::sampler_statistics::sampler_statistics
+ */
+visus::power_overwhelming::sampler_statistics::sampler_statistics(void)
+    : _impl(new detail::sampler_statistics_impl()) { }
+
+
+/*
+ * visus::power_overwhelming::sampler_statistics::sampler_statistics
+ */
+visus::power_overwhelming::sampler_statistics::sampler_statistics(
+        _In_ const sampler_statistics& rhs)
+    : _impl(new detail::sampler_statistics_impl(rhs.check_not_disposed())) { }
+
+
+/*
+ * visus::power_overwhelming::sampler_statistics::sampler_statistics
+ */
+visus::power_overwhelming::sampler_statistics::sampler_statistics(
+        _Inout_ sampler_statistics&& rhs) noexcept : _impl(rhs._impl) {
+    rhs._impl = nullptr;
+}
+
+
+/*
+ * visus::power_overwhelming::sampler_statistics::~sampler_statistics
+ */
+visus::power_overwhelming::sampler_statistics::~sampler_statistics(void) {
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::sampler_statistics::callback_duration
+ */
+const visus::power_overwhelming::latency_histogram&
+visus::power_overwhelming::sampler_statistics::callback_duration(void) const {
+    return this->check_not_disposed().callback_duration;
+}
+
+
+/*
+ * visus::power_overwhelming::sampler_statistics::interval
+ */
+visus::power_overwhelming::sampler_statistics::interval_type
+visus::power_overwhelming::sampler_statistics::interval(void) const {
+    return this->check_not_disposed().interval;
+}
+
+
+/*
+ * visus::power_overwhelming::sampler_statistics::jitter
+ */
+const visus::power_overwhelming::latency_histogram&
+visus::power_overwhelming::sampler_statistics::jitter(void) const {
+    return this->check_not_disposed().jitter;
+}
+
+
+/*
+ * visus::power_overwhelming::sampler_statistics::missed_deadlines
+ */
+std::uint64_t visus::power_overwhelming::sampler_statistics::missed_deadlines(
+        void) const {
+    return this->check_not_disposed().missed_deadlines;
+}
+
+
+/*
+ * visus::power_overwhelming::sampler_statistics::overruns
+ */
+std::uint64_t visus::power_overwhelming::sampler_statistics::overruns(
+        void) const {
+    return this->check_not_disposed().overruns;
+}
+
+
+/*
+ * visus::power_overwhelming::sampler_statistics::sample_duration
+ */
+const visus::power_overwhelming::latency_histogram&
+visus::power_overwhelming::sampler_statistics::sample_duration(
+        _In_ const std::size_t index) const {
+    return this->check_not_disposed().sources.at(index).second;
+}
+
+
+/*
+ * visus::power_overwhelming::sampler_statistics::source
+ */
+_Ret_z_ const wchar_t *visus::power_overwhelming::sampler_statistics::source(
+        _In_ const std::size_t index) const {
+    return this->check_not_disposed().sources.at(index).first.c_str();
+}
+
+
+/*
+ * visus::power_overwhelming::sampler_statistics::sources
+ */
+std::size_t visus::power_overwhelming::sampler_statistics::sources(
+        void) const {
+    return this->check_not_disposed().sources.size();
+}
+
+
+/*
+ * visus::power_overwhelming::sampler_statistics::ticks
+ */
+std::uint64_t visus::power_overwhelming::sampler_statistics::ticks(
+        void) const {
+    return this->check_not_disposed().ticks;
+}
+
+
+/*
+ * visus::power_overwhelming::sampler_statistics::operator =
+ */
+visus::power_overwhelming::sampler_statistics&
+visus::power_overwhelming::sampler_statistics::operator =(
+        _In_ const sampler_statistics& rhs) {
+    if (this != std::addressof(rhs)) {
+        const auto& impl = rhs.check_not_disposed();
+        if (this->_impl == nullptr) {
+            this->_impl = new detail::sampler_statistics_impl(impl);
+        } else {
+            *this->_impl = impl;
+        }
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::sampler_statistics::operator =
+ */
+visus::power_overwhelming::sampler_statistics&
+visus::power_overwhelming::sampler_statistics::operator =(
+        _Inout_ sampler_statistics&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::sampler_statistics::operator bool
+ */
+visus::power_overwhelming::sampler_statistics::operator bool(
+        void) const noexcept {
+    return (this->_impl != nullptr);
+}
+
+
+/*
+ * visus::power_overwhelming::sampler_statistics::check_not_disposed
+ */
+const visus::power_overwhelming::detail::sampler_statistics_impl&
+visus::power_overwhelming::sampler_statistics::check_not_disposed(
+        void) const {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("Sampler statistics which have been disposed "
+            "by a move operation cannot be used anymore.");
+    }
+
+    return *this->_impl;
+}
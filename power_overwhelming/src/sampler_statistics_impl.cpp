@@ -0,0 +1,76 @@
+﻿// <copyright file="sampler_statistics_impl.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "sampler_statistics_impl.h"
+
+#include "power_overwhelming/csv_iomanip.h"
+#include "power_overwhelming/quote.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Writes a line summarising a histogram.
+    /// </summary>
+    static void write_csv(_In_ std::wostream& stream,
+            _In_z_ const wchar_t *keyword,
+            _In_ const sensor::microseconds_type interval,
+            _In_ const std::wstring& source,
+            _In_ const latency_histogram& histogram) {
+        const auto delimiter = getcsvdelimiter(stream);
+        const auto quote_char = getcsvquote(stream);
+
+        stream << keyword << delimiter << interval << delimiter;
+        if (quote_char != 0) {
+            stream << quote(source.c_str(), quote_char);
+        } else {
+            stream << source;
+        }
+
+        stream << delimiter << histogram.count()
+            << delimiter << histogram.min()
+            << delimiter << static_cast<std::uint64_t>(histogram.mean())
+            << delimiter << histogram.percentile(0.5)
+            << delimiter << histogram.percentile(0.9)
+            << delimiter << histogram.percentile(0.99)
+            << delimiter << histogram.percentile(0.999)
+            << delimiter << histogram.max()
+            << L'\n';
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::write_csv
+ */
+std::wostream& visus::power_overwhelming::detail::write_csv(
+        _In_ std::wostream& stream,
+        _In_ const sampler_statistics_impl& statistics) {
+    const auto delimiter = getcsvdelimiter(stream);
+    const std::wstring none;
+
+    stream << L"# sampler ticks" << delimiter << statistics.interval
+        << delimiter << statistics.ticks
+        << delimiter << statistics.overruns
+        << delimiter << statistics.missed_deadlines
+        << L'\n';
+
+    write_csv(stream, L"# sampler jitter", statistics.interval, none,
+        statistics.jitter);
+    write_csv(stream, L"# sampler callback", statistics.interval, none,
+        statistics.callback_duration);
+
+    for (auto& s : statistics.sources) {
+        write_csv(stream, L"# sampler sample", statistics.interval, s.first,
+            s.second);
+    }
+
+    return stream;
+}
@@ -0,0 +1,103 @@
+﻿// <copyright file="sampler_statistics_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "power_overwhelming/latency_histogram.h"
+#include "power_overwhelming/sensor.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The snapshot of the self-instrumentation of a single sampler context.
+    /// </summary>
+    struct POWER_OVERWHELMING_API sampler_statistics_impl final {
+
+        /// <summary>
+        /// The type of the duration it took to obtain the samples from a
+        /// single source, which is typically a sensor.
+        /// </summary>
+        typedef std::pair<std::wstring, latency_histogram> source_type;
+
+        /// <summary>
+        /// The time the user-defined callbacks took.
+        /// </summary>
+        latency_histogram callback_duration;
+
+        /// <summary>
+        /// The sampling interval of the context in microseconds.
+        /// </summary>
+        sensor::microseconds_type interval;
+
+        /// <summary>
+        /// The time between the instant a tick was due and the instant it
+        /// actually started.
+        /// </summary>
+        latency_histogram jitter;
+
+        /// <summary>
+        /// The number of deadlines that have been skipped, because the
+        /// previous tick took too long.
+        /// </summary>
+        std::uint64_t missed_deadlines;
+
+        /// <summary>
+        /// The number of ticks that took longer than the sampling interval.
+        /// </summary>
+        std::uint64_t overruns;
+
+        /// <summary>
+        /// The time obtaining a sample took per source.
+        /// </summary>
+        std::vector<source_type> sources;
+
+        /// <summary>
+        /// The number of ticks the context has performed.
+        /// </summary>
+        std::uint64_t ticks;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        inline sampler_statistics_impl(void) : interval(0),
+            missed_deadlines(0), overruns(0), ticks(0) { }
+    };
+
+    /// <summary>
+    /// Writes the statistics as comment lines to a CSV stream.
+    /// </summary>
+    /// <remarks>
+    /// <para>The first line holds the keyword <c>sampler ticks</c>, the
+    /// sampling interval in microseconds, the number of ticks, the number of
+    /// overruns and the number of missed deadlines.</para>
+    /// <para>It is followed by a line with the keyword <c>sampler jitter</c>,
+    /// a line with the keyword <c>sampler callback</c> and a line per source
+    /// with the keyword <c>sampler sample</c>. These lines hold the sampling
+    /// interval, the name of the source, which is empty for the first two,
+    /// and the number of durations, the minimum, the mean, the median, the
+    /// 90th, the 99th and the 99.9th percentile and the maximum in
+    /// nanoseconds.</para>
+    /// <para>All lines start with a hash sign such that CSV readers can skip
+    /// them as comment.</para>
+    /// </remarks>
+    /// <param name="stream">The stream to write to.</param>
+    /// <param name="statistics">The record to be written.</param>
+    /// <returns><paramref name="stream" />.</returns>
+    POWER_OVERWHELMING_API std::wostream& write_csv(
+        _In_ std::wostream& stream,
+        _In_ const sampler_statistics_impl& statistics);
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,124 @@
+﻿// <copyright file="sampling_budget.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "sampling_budget.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+
+/*
+ * visus::power_overwhelming::detail::sampling_budget::default_cost
+ */
+constexpr double visus::power_overwhelming::detail::sampling_budget
+::default_cost;
+
+
+/*
+ * visus::power_overwhelming::detail::sampling_budget::max_interval
+ */
+constexpr visus::power_overwhelming::detail::sampling_budget::interval_type
+visus::power_overwhelming::detail::sampling_budget::max_interval;
+
+
+/*
+ * visus::power_overwhelming::detail::sampling_budget::sampling_budget
+ */
+visus::power_overwhelming::detail::sampling_budget::sampling_budget(
+        _In_ const float cpu, _In_ const std::uint64_t reads)
+        : _cpu(cpu), _reads(reads) {
+    if (!(cpu >= 0.0f)) {
+        throw std::invalid_argument("The CPU budget for sampling must not be "
+            "negative.");
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sampling_budget::allocate
+ */
+void visus::power_overwhelming::detail::sampling_budget::allocate(
+        _Inout_updates_(cnt) request *requests,
+        _In_ const std::size_t cnt) const {
+    if ((requests == nullptr) || (cnt < 1)) {
+        return;
+    }
+
+    if (!this->enabled()) {
+        for (std::size_t i = 0; i < cnt; ++i) {
+            requests[i].granted = requests[i].interval;
+        }
+        return;
+    }
+
+    // Express the demand of each sensor as the fraction of the budget it
+    // consumes per read ("charge") and per second at its requested rate
+    // ("demand"), such that the sum of the granted demands must not exceed
+    // one.
+    std::vector<double> charges(cnt);
+    std::vector<double> demands(cnt);
+    std::vector<double> priorities(cnt);
+    for (std::size_t i = 0; i < cnt; ++i) {
+        const auto& r = requests[i];
+        const auto cost = (r.cost > 0.0) ? r.cost : default_cost;
+        const auto interval = (std::max)(r.interval.count(),
+            interval_type::rep(1));
+
+        auto charge = 0.0;
+        if (this->_cpu > 0.0f) {
+            charge = cost / (1000000.0 * this->_cpu);
+        }
+        if (this->_reads > 0) {
+            charge = (std::max)(charge, 1.0 / this->_reads);
+        }
+
+        charges[i] = charge;
+        demands[i] = charge * 1000000.0 / interval;
+        priorities[i] = (r.priority > 0.0f) ? r.priority : 1.0;
+    }
+
+    // Sensors are saturated in the order of their demands relative to their
+    // priorities. Once the fair share of the remaining budget does not cover
+    // the demand of the next sensor, all remaining sensors share what is left
+    // in proportion to their priorities.
+    std::vector<std::size_t> order(cnt);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+            [&](const std::size_t l, const std::size_t r) {
+        return (demands[l] * priorities[r] < demands[r] * priorities[l]);
+    });
+
+    auto remaining = 1.0;
+    auto weight = std::accumulate(priorities.begin(), priorities.end(), 0.0);
+    auto it = order.begin();
+
+    for (; it != order.end(); ++it) {
+        const auto share = remaining * priorities[*it] / weight;
+        if (demands[*it] > share) {
+            break;
+        }
+
+        requests[*it].granted = requests[*it].interval;
+        remaining -= demands[*it];
+        weight -= priorities[*it];
+    }
+
+    for (; it != order.end(); ++it) {
+        const auto share = (std::max)(remaining, 0.0) * priorities[*it]
+            / weight;
+        const auto rate = share / charges[*it];
+        auto interval = static_cast<double>(max_interval.count());
+        if (rate > 0.0) {
+            // Round up such that the sum of the shares is not exceeded.
+            interval = (std::min)(std::ceil(1000000.0 / rate), interval);
+        }
+
+        requests[*it].granted = (std::max)(requests[*it].interval,
+            interval_type(static_cast<interval_type::rep>(interval)));
+    }
+}
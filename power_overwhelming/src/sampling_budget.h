@@ -0,0 +1,153 @@
+﻿// <copyright file="sampling_budget.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <chrono>
+#include <cinttypes>
+#include <cstddef>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Distributes a global budget for the overhead of sampling across
+    /// sensors by stretching their sampling intervals.
+    /// </summary>
+    /// <remarks>
+    /// <para>The budget is expressed as the fraction of one CPU core that
+    /// may be spent on reading sensors and/or as the number of reads per
+    /// second. Each read of a sensor consumes its cost in CPU time and one
+    /// read from the budget. Every sensor receives a share of the budget
+    /// proportional to its priority, but never more than it needs for its
+    /// requested interval. What a sensor does not need is redistributed to
+    /// the others, ie the allocation is a weighted max-min fair share.</para>
+    /// <para>The intervals granted are never shorter than the requested
+    /// ones. If both limits are set, each read is charged with the larger of
+    /// its shares of the two limits, which keeps both of them.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API sampling_budget final {
+
+    public:
+
+        /// <summary>
+        /// The type to express sampling intervals.
+        /// </summary>
+        typedef std::chrono::microseconds interval_type;
+
+        /// <summary>
+        /// The demand of a single sensor.
+        /// </summary>
+        struct request {
+
+            /// <summary>
+            /// The CPU time in microseconds a read of the sensor takes, or
+            /// zero if it is unknown, in which case <see cref="default_cost" />
+            /// is assumed.
+            /// </summary>
+            double cost;
+
+            /// <summary>
+            /// Receives the interval the sensor should be sampled at.
+            /// </summary>
+            interval_type granted;
+
+            /// <summary>
+            /// The shortest interval the sensor should be sampled at.
+            /// </summary>
+            interval_type interval;
+
+            /// <summary>
+            /// The weight of the share of the sensor. Non-positive values are
+            /// treated as one.
+            /// </summary>
+            float priority;
+        };
+
+        /// <summary>
+        /// The CPU time in microseconds assumed for a read if the cost of a
+        /// sensor is unknown.
+        /// </summary>
+        static constexpr double default_cost = 10.0;
+
+        /// <summary>
+        /// The longest interval granted to a sensor, even if its share of the
+        /// budget would require an even longer one.
+        /// </summary>
+        static constexpr interval_type max_interval
+            = std::chrono::duration_cast<interval_type>(
+            std::chrono::minutes(1));
+
+        /// <summary>
+        /// Initialises a new instance, which does not limit the sensors.
+        /// </summary>
+        inline sampling_budget(void) noexcept : _cpu(0.0f), _reads(0) { }
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="cpu">The fraction of one CPU core that may be spent
+        /// on reading sensors, or zero for not limiting the CPU time.</param>
+        /// <param name="reads">The number of reads per second across all
+        /// sensors, or zero for not limiting the number of reads.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="cpu" /> is negative.</exception>
+        sampling_budget(_In_ const float cpu, _In_ const std::uint64_t reads);
+
+        /// <summary>
+        /// Distributes the budget across the given sensors.
+        /// </summary>
+        /// <remarks>
+        /// If the budget is not <see cref="enabled" />, every sensor is
+        /// granted its requested interval.
+        /// </remarks>
+        /// <param name="requests">The demands of the sensors, which receive
+        /// their <see cref="request::granted" /> intervals.</param>
+        /// <param name="cnt">The number of elements in
+        /// <paramref name="requests" />.</param>
+        void allocate(_Inout_updates_(cnt) request *requests,
+            _In_ const std::size_t cnt) const;
+
+        /// <summary>
+        /// Answer the fraction of one CPU core that may be spent on reading
+        /// sensors.
+        /// </summary>
+        /// <returns>The CPU budget, or zero if the CPU time is not limited.
+        /// </returns>
+        inline float cpu(void) const noexcept {
+            return this->_cpu;
+        }
+
+        /// <summary>
+        /// Answer whether any limit is set.
+        /// </summary>
+        /// <returns><c>true</c> if the sensors are limited, <c>false</c>
+        /// otherwise.</returns>
+        inline bool enabled(void) const noexcept {
+            return ((this->_cpu > 0.0f) || (this->_reads > 0));
+        }
+
+        /// <summary>
+        /// Answer the number of reads per second across all sensors.
+        /// </summary>
+        /// <returns>The read budget, or zero if the number of reads is not
+        /// limited.</returns>
+        inline std::uint64_t reads(void) const noexcept {
+            return this->_reads;
+        }
+
+    private:
+
+        float _cpu;
+        std::uint64_t _reads;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,44 @@
+﻿// <copyright file="schema_change.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "schema_change.h"
+
+#include "power_overwhelming/csv_iomanip.h"
+#include "power_overwhelming/quote.h"
+
+
+/*
+ * visus::power_overwhelming::detail::to_string
+ */
+_Ret_z_ const wchar_t *visus::power_overwhelming::detail::to_string(
+        _In_ const schema_change_type type) noexcept {
+    switch (type) {
+        case schema_change_type::added: return L"added";
+        case schema_change_type::removed: return L"removed";
+        case schema_change_type::interval: return L"interval";
+        default: return L"unknown";
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::write_csv
+ */
+std::wostream& visus::power_overwhelming::detail::write_csv(
+        _In_ std::wostream& stream, _In_ const schema_change& change) {
+    const auto delimiter = getcsvdelimiter(stream);
+    const auto quote_char = getcsvquote(stream);
+
+    stream << L"# schema change" << delimiter << change.timestamp
+        << delimiter << to_string(change.type) << delimiter;
+    if (quote_char != 0) {
+        stream << quote(change.name.c_str(), quote_char);
+    } else {
+        stream << change.name;
+    }
+    stream << delimiter << change.interval << L'\n';
+
+    return stream;
+}
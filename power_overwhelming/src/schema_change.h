@@ -0,0 +1,98 @@
+﻿// <copyright file="schema_change.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <iostream>
+#include <string>
+
+#include "power_overwhelming/measurement.h"
+#include "power_overwhelming/sensor.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Possible kinds of changes of the sensors of a running collector.
+    /// </summary>
+    enum class schema_change_type : std::uint32_t {
+
+        /// <summary>
+        /// A sensor has been added and is sampled from now on.
+        /// </summary>
+        added = 1,
+
+        /// <summary>
+        /// A sensor has been removed and is not sampled any more.
+        /// </summary>
+        removed = 2,
+
+        /// <summary>
+        /// The sampling interval of a sensor has been changed.
+        /// </summary>
+        interval = 3
+    };
+
+    /// <summary>
+    /// Describes a change of the sensors of a collector while it was running.
+    /// </summary>
+    struct POWER_OVERWHELMING_API schema_change final {
+
+        /// <summary>
+        /// The sampling interval of the sensor in microseconds after the
+        /// change, which is zero if the sensor has been removed.
+        /// </summary>
+        sensor::microseconds_type interval;
+
+        /// <summary>
+        /// The name of the sensor that has been changed.
+        /// </summary>
+        std::wstring name;
+
+        /// <summary>
+        /// The time when the change has been made.
+        /// </summary>
+        measurement::timestamp_type timestamp;
+
+        /// <summary>
+        /// The kind of the change.
+        /// </summary>
+        schema_change_type type;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        inline schema_change(void) : interval(0), timestamp(0),
+            type(schema_change_type::added) { }
+    };
+
+    /// <summary>
+    /// Answer the keyword of the given kind of change in the CSV output.
+    /// </summary>
+    /// <param name="type">The kind of the change.</param>
+    /// <returns>The keyword describing the change.</returns>
+    POWER_OVERWHELMING_API _Ret_z_ const wchar_t *to_string(
+        _In_ const schema_change_type type) noexcept;
+
+    /// <summary>
+    /// Writes the schema change as comment line to a CSV stream.
+    /// </summary>
+    /// <remarks>
+    /// The line holds the keyword <c>schema change</c>, the timestamp, the
+    /// kind of the change, the name of the sensor and its sampling interval
+    /// in microseconds. It starts with a hash sign such that CSV readers can
+    /// skip it as comment.
+    /// </remarks>
+    /// <param name="stream">The stream to write to.</param>
+    /// <param name="change">The record to be written.</param>
+    /// <returns><paramref name="stream" />.</returns>
+    POWER_OVERWHELMING_API std::wostream& write_csv(
+        _In_ std::wostream& stream, _In_ const schema_change& change);
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,195 @@
+﻿// <copyright file="scpi_analyser_descriptor.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "scpi_analyser_descriptor.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+#include <nlohmann/json.hpp>
+
+#include "scpi_response.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Retrieves the command stored in <paramref name="name" /> of
+    /// <paramref name="desc" /> and makes sure that it is terminated by a
+    /// newline.
+    /// </summary>
+    static std::string get_command(_In_ const nlohmann::json& desc,
+            _In_z_ const char *name) {
+        auto retval = desc.value(name, std::string());
+        if (!retval.empty() && (retval.back() != '\n')) {
+            retval += '\n';
+        }
+        return retval;
+    }
+
+    /// <summary>
+    /// Retrieves the list of commands stored in <paramref name="name" /> of
+    /// <paramref name="desc" />.
+    /// </summary>
+    static std::vector<std::string> get_commands(
+            _In_ const nlohmann::json& desc,
+            _In_z_ const char *name) {
+        std::vector<std::string> retval;
+
+        auto it = desc.find(name);
+        if (it != desc.end()) {
+            for (auto& c : *it) {
+                auto command = c.get<std::string>();
+                if (!command.empty() && (command.back() != '\n')) {
+                    command += '\n';
+                }
+                retval.push_back(std::move(command));
+            }
+        }
+
+        return retval;
+    }
+
+    /// <summary>
+    /// Retrieves the position of <paramref name="name" /> in the field map
+    /// <paramref name="fields" />.
+    /// </summary>
+    static std::size_t get_field(_In_ const nlohmann::json& fields,
+            _In_z_ const char *name) {
+        typedef scpi_analyser_descriptor desc_type;
+
+        auto it = fields.find(name);
+        if (it == fields.end()) {
+            return desc_type::no_field;
+        }
+
+        auto retval = it->get<std::size_t>();
+        if (retval >= desc_type::max_values) {
+            throw std::invalid_argument("The position of a field in the "
+                "response of a SCPI analyser exceeds the maximum number of "
+                "values supported.");
+        }
+
+        return retval;
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::scpi_analyser_descriptor::max_values
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::scpi_analyser_descriptor::max_values;
+
+
+/*
+ * visus::power_overwhelming::detail::scpi_analyser_descriptor::no_field
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::scpi_analyser_descriptor::no_field;
+
+
+/*
+ * visus::power_overwhelming::detail::scpi_analyser_descriptor::parse
+ */
+visus::power_overwhelming::detail::scpi_analyser_descriptor
+visus::power_overwhelming::detail::scpi_analyser_descriptor::parse(
+        _In_z_ const char *json) {
+    if (json == nullptr) {
+        throw std::invalid_argument("The descriptor of a SCPI analyser must "
+            "not be null.");
+    }
+
+    scpi_analyser_descriptor retval;
+
+    try {
+        const auto desc = nlohmann::json::parse(json);
+
+        retval.identity = desc.value("identity", std::string());
+        retval.name = desc.value("name", std::string());
+        retval.product = desc.value("product", std::string());
+        retval.query = get_command(desc, "query");
+        retval.setup = get_commands(desc, "setup");
+        retval.teardown = get_commands(desc, "teardown");
+        retval.vendor = desc.value("vendor", std::string());
+
+        const auto& fields = desc.at("fields");
+        retval.current = get_field(fields, "current");
+        retval.power = get_field(fields, "power");
+        retval.voltage = get_field(fields, "voltage");
+
+        auto it = desc.find("integrator");
+        if (it != desc.end()) {
+            retval.energy = get_command(*it, "energy");
+            retval.energy_scale = it->value("energy_scale", 1.0);
+            retval.reset = get_command(*it, "reset");
+            retval.start = get_command(*it, "start");
+            retval.stop = get_command(*it, "stop");
+        } else {
+            retval.energy_scale = 1.0;
+        }
+    } catch (nlohmann::json::exception& ex) {
+        throw std::invalid_argument(ex.what());
+    }
+
+    if (retval.query.empty()) {
+        throw std::invalid_argument("The descriptor of a SCPI analyser must "
+            "specify the query retrieving a sample.");
+    }
+    if (retval.power == no_field) {
+        throw std::invalid_argument("The descriptor of a SCPI analyser must "
+            "specify the position of the power in the response.");
+    }
+
+    // The number of values we expect is determined by the last field we use,
+    // ie we do not care for anything the instrument reports beyond that.
+    retval.count = retval.power + 1;
+    if (retval.current != no_field) {
+        retval.count = (std::max)(retval.count, retval.current + 1);
+    }
+    if (retval.voltage != no_field) {
+        retval.count = (std::max)(retval.count, retval.voltage + 1);
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::scpi_analyser_descriptor::parse_response
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::detail::scpi_analyser_descriptor::parse_response(
+        _In_reads_opt_(cnt) const char *response,
+        _In_ const std::size_t cnt,
+        _In_ const timestamp_type timestamp) const {
+    assert(this->count <= max_values);
+    double values[max_values];
+
+    if ((response == nullptr)
+            || !parse_real_list(response, response + cnt, values,
+            this->count)) {
+        throw std::invalid_argument("The response of the instrument does "
+            "not contain the expected number of values.");
+    }
+
+    const auto power = static_cast<measurement::value_type>(
+        values[this->power]);
+
+    if ((this->current != no_field) && (this->voltage != no_field)) {
+        return measurement_data(timestamp,
+            static_cast<measurement::value_type>(values[this->voltage]),
+            static_cast<measurement::value_type>(values[this->current]),
+            power);
+    } else {
+        return measurement_data(timestamp, power);
+    }
+}
@@ -0,0 +1,192 @@
+﻿// <copyright file="scpi_analyser_descriptor.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "power_overwhelming/measurement.h"
+
+#include "timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Describes how a SCPI power analyser is configured and queried.
+    /// </summary>
+    /// <remarks>
+    /// <para>The descriptor is created from a JSON object of the following
+    /// form, where all members but <c>query</c> and <c>fields.power</c> are
+    /// optional:</para>
+    /// <code>
+    /// {
+    ///     "name": "WT310",
+    ///     "vendor": "0x0B21",
+    ///     "product": "0x0025",
+    ///     "identity": "WT310",
+    ///     "setup": [ ":NUM:FORM ASC", ":NUM:NORM:NUM 3" ],
+    ///     "teardown": [ ":COMM:REM OFF" ],
+    ///     "query": ":NUM:NORM:VAL?",
+    ///     "fields": { "voltage": 0, "current": 1, "power": 2 },
+    ///     "integrator": {
+    ///         "start": ":INTEG:STAR",
+    ///         "stop": ":INTEG:STOP",
+    ///         "reset": ":INTEG:RES",
+    ///         "energy": ":NUM:NORM:VAL? 4",
+    ///         "energy_scale": 3600
+    ///     }
+    /// }
+    /// </code>
+    /// <para>The response to <c>query</c> must be a comma-separated list of
+    /// numbers, which is parsed without copying it. <c>fields</c> maps the
+    /// quantities of a sample to the zero-based position in this list. Newlines
+    /// terminating the commands are added if missing.</para>
+    /// </remarks>
+    struct POWER_OVERWHELMING_API scpi_analyser_descriptor final {
+
+        /// <summary>
+        /// The maximum number of values in the response to
+        /// <see cref="query" />, which is the size of the buffer the response
+        /// is parsed into.
+        /// </summary>
+        static constexpr std::size_t max_values = 32;
+
+        /// <summary>
+        /// Marks a quantity that is not reported by the instrument.
+        /// </summary>
+        static constexpr std::size_t no_field = static_cast<std::size_t>(-1);
+
+        /// <summary>
+        /// Parses a descriptor from its JSON representation.
+        /// </summary>
+        /// <param name="json">The JSON representation of the descriptor.
+        /// </param>
+        /// <returns>The descriptor.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="json" /> is <c>nullptr</c> or if the query or the
+        /// position of the power is missing or invalid.</exception>
+        static scpi_analyser_descriptor parse(_In_z_ const char *json);
+
+        /// <summary>
+        /// The number of values that must be present in the response, which is
+        /// one past the largest position in the field map.
+        /// </summary>
+        std::size_t count;
+
+        /// <summary>
+        /// The position of the current in the response or
+        /// <see cref="no_field" />.
+        /// </summary>
+        std::size_t current;
+
+        /// <summary>
+        /// The query retrieving the integrated energy, or an empty string if
+        /// not supported.
+        /// </summary>
+        std::string energy;
+
+        /// <summary>
+        /// The factor converting the response to <see cref="energy" /> into
+        /// Joules.
+        /// </summary>
+        double energy_scale;
+
+        /// <summary>
+        /// A substring of the response to <c>*IDN?</c> identifying instruments
+        /// this descriptor applies to, or an empty string for accepting any
+        /// instrument.
+        /// </summary>
+        std::string identity;
+
+        /// <summary>
+        /// A human-readable name of the instrument type.
+        /// </summary>
+        std::string name;
+
+        /// <summary>
+        /// The position of the power in the response.
+        /// </summary>
+        std::size_t power;
+
+        /// <summary>
+        /// The USB product ID of the instrument, or an empty string if it is
+        /// only reachable via the network.
+        /// </summary>
+        std::string product;
+
+        /// <summary>
+        /// The query retrieving a sample.
+        /// </summary>
+        std::string query;
+
+        /// <summary>
+        /// The command resetting the integrator, or an empty string if not
+        /// supported.
+        /// </summary>
+        std::string reset;
+
+        /// <summary>
+        /// The commands configuring the instrument to answer
+        /// <see cref="query" /> as described by the field map.
+        /// </summary>
+        std::vector<std::string> setup;
+
+        /// <summary>
+        /// The command starting the integrator, or an empty string if not
+        /// supported.
+        /// </summary>
+        std::string start;
+
+        /// <summary>
+        /// The command stopping the integrator, or an empty string if not
+        /// supported.
+        /// </summary>
+        std::string stop;
+
+        /// <summary>
+        /// The commands returning the instrument to local operation.
+        /// </summary>
+        std::vector<std::string> teardown;
+
+        /// <summary>
+        /// The position of the voltage in the response or
+        /// <see cref="no_field" />.
+        /// </summary>
+        std::size_t voltage;
+
+        /// <summary>
+        /// The USB vendor ID of the instrument, or an empty string if it is
+        /// only reachable via the network.
+        /// </summary>
+        std::string vendor;
+
+        /// <summary>
+        /// Parses a response to <see cref="query" />.
+        /// </summary>
+        /// <remarks>
+        /// The values are parsed into a buffer on the stack, ie this method
+        /// does not allocate any memory.
+        /// </remarks>
+        /// <param name="response">The begin of the response.</param>
+        /// <param name="cnt">The length of the response in bytes.</param>
+        /// <param name="timestamp">The timestamp to be assigned to the sample.
+        /// </param>
+        /// <returns>The sample parsed from the response.</returns>
+        /// <exception cref="std::invalid_argument">If the response does not
+        /// contain <see cref="count" /> numbers.</exception>
+        measurement_data parse_response(
+            _In_reads_opt_(cnt) const char *response,
+            _In_ const std::size_t cnt,
+            _In_ const timestamp_type timestamp) const;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
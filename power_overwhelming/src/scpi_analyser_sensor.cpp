@@ -0,0 +1,347 @@
+﻿// <copyright file="scpi_analyser_sensor.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/scpi_analyser_sensor.h"
+
+#include <cassert>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "scpi_analyser_descriptor.h"
+#include "scpi_response.h"
+#include "scpi_sampler.h"
+#include "sensor_name_registry.h"
+#include "visa_discovery.h"
+
+
+/*
+ * visus::power_overwhelming::scpi_analyser_sensor::for_all
+ */
+std::size_t visus::power_overwhelming::scpi_analyser_sensor::for_all(
+        _Out_writes_opt_(cnt_sensors) scpi_analyser_sensor *out_sensors,
+        _In_ std::size_t cnt_sensors,
+        _In_z_ const char *descriptor,
+        _In_ const std::int32_t timeout) {
+    const auto desc = detail::scpi_analyser_descriptor::parse(descriptor);
+    const auto usb = !desc.vendor.empty() && !desc.product.empty();
+    const auto identity = desc.identity;
+
+    auto devices = detail::find_instruments(
+        usb ? desc.vendor.c_str() : nullptr,
+        usb ? desc.product.c_str() : nullptr,
+        [&identity](const std::string& i) {
+            return (i.find(identity) != std::string::npos);
+        }, timeout);
+
+    // Guard against misuse.
+    if (out_sensors == nullptr) {
+        cnt_sensors = 0;
+    }
+
+    // Create a sensor for each instrument we found, which needs the
+    // descriptor in addition to the path.
+    detail::create_instruments(out_sensors, cnt_sensors, devices,
+            [descriptor, timeout](const char *path) {
+        return scpi_analyser_sensor(path, descriptor, timeout);
+    });
+
+    return devices.size();
+}
+
+
+/*
+ * visus::power_overwhelming::scpi_analyser_sensor::scpi_analyser_sensor
+ */
+visus::power_overwhelming::scpi_analyser_sensor::scpi_analyser_sensor(void)
+    : _descriptor(nullptr), _name(nullptr), _sampler(nullptr) { }
+
+
+/*
+ * visus::power_overwhelming::scpi_analyser_sensor::scpi_analyser_sensor
+ */
+visus::power_overwhelming::scpi_analyser_sensor::scpi_analyser_sensor(
+        _In_z_ const wchar_t *path,
+        _In_z_ const char *descriptor,
+        _In_ const visa_instrument::timeout_type timeout)
+    : _descriptor(new detail::scpi_analyser_descriptor(
+            detail::scpi_analyser_descriptor::parse(descriptor))),
+        _instrument(path, timeout), _name(nullptr), _sampler(nullptr) {
+    try {
+        this->initialise();
+    } catch (...) {
+        delete this->_descriptor;
+        delete[] this->_name;
+        throw;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::scpi_analyser_sensor::scpi_analyser_sensor
+ */
+visus::power_overwhelming::scpi_analyser_sensor::scpi_analyser_sensor(
+        _In_z_ const char *path,
+        _In_z_ const char *descriptor,
+        _In_ const visa_instrument::timeout_type timeout)
+    : _descriptor(new detail::scpi_analyser_descriptor(
+            detail::scpi_analyser_descriptor::parse(descriptor))),
+        _instrument(path, timeout), _name(nullptr), _sampler(nullptr) {
+    try {
+        this->initialise();
+    } catch (...) {
+        delete this->_descriptor;
+        delete[] this->_name;
+        throw;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::scpi_analyser_sensor::scpi_analyser_sensor
+ */
+visus::power_overwhelming::scpi_analyser_sensor::scpi_analyser_sensor(
+        _Inout_ scpi_analyser_sensor&& rhs) noexcept
+    : _descriptor(rhs._descriptor),
+        _instrument(std::move(rhs._instrument)),
+        _name(rhs._name),
+        _sampler(rhs._sampler) {
+    rhs._descriptor = nullptr;
+    rhs._name = nullptr;
+    rhs._sampler = nullptr;
+}
+
+
+/*
+ * visus::power_overwhelming::scpi_analyser_sensor::~scpi_analyser_sensor
+ */
+visus::power_overwhelming::scpi_analyser_sensor::~scpi_analyser_sensor(void) {
+    // Make sure that the sampler thread does not use the instrument or the
+    // descriptor anymore.
+    this->sample_batch(nullptr);
+
+    if (this->_instrument && (this->_descriptor != nullptr)) {
+        // Return the instrument to local operations, but make sure that we do
+        // not throw in the destructor.
+        for (auto& c : this->_descriptor->teardown) {
+            try {
+                this->_instrument.write(c.c_str());
+            } catch (...) { /* There is nothing we can do here. */ }
+        }
+    }
+
+    delete this->_descriptor;
+    delete[] this->_name;
+}
+
+
+/*
+ * visus::power_overwhelming::scpi_analyser_sensor::instrument_type
+ */
+_Ret_z_ const char *
+visus::power_overwhelming::scpi_analyser_sensor::instrument_type(
+        void) const noexcept {
+    return (this->_descriptor != nullptr)
+        ? this->_descriptor->name.c_str()
+        : "";
+}
+
+
+/*
+ * visus::power_overwhelming::scpi_analyser_sensor::integrated_energy
+ */
+double visus::power_overwhelming::scpi_analyser_sensor::integrated_energy(
+        void) {
+    this->check_not_disposed();
+
+    if (this->_descriptor->energy.empty()) {
+        throw std::logic_error("The descriptor of the instrument does not "
+            "specify how to query the integrated energy.");
+    }
+
+    auto response = this->_instrument.query(
+        this->_descriptor->energy.c_str());
+    this->_instrument.throw_on_system_error();
+
+    return detail::parse_real_response(response)
+        * this->_descriptor->energy_scale;
+}
+
+
+/*
+ * visus::power_overwhelming::scpi_analyser_sensor::name
+ */
+_Ret_maybenull_z_ const wchar_t *
+visus::power_overwhelming::scpi_analyser_sensor::name(void) const noexcept {
+    return this->_name;
+}
+
+
+/*
+ * visus::power_overwhelming::scpi_analyser_sensor::reset_integrator
+ */
+visus::power_overwhelming::scpi_analyser_sensor&
+visus::power_overwhelming::scpi_analyser_sensor::reset_integrator(void) {
+    this->check_not_disposed();
+    this->execute(this->_descriptor->reset.c_str());
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::scpi_analyser_sensor::sample_batch
+ */
+void visus::power_overwhelming::scpi_analyser_sensor::sample_batch(
+        _In_opt_ const measurement_data_callback on_batch,
+        _In_ const microseconds_type period,
+        _In_opt_ void *context) {
+    if (on_batch != nullptr) {
+        this->check_not_disposed();
+
+        if (this->_sampler != nullptr) {
+            throw std::logic_error("Asynchronous sampling cannot be started "
+                "while it is already running.");
+        }
+
+        // Note: the name must be interned, because it must survive the sensor
+        // being moved or destroyed while the sampler delivers a sample. The
+        // descriptor is not affected by moves, and the sampler is stopped
+        // before it is destroyed.
+        auto name = this->name();
+        auto desc = this->_descriptor;
+        this->_sampler = new detail::scpi_sampler(this->path(),
+            detail::sensor_name_registry::intern((name != nullptr)
+                ? name : L""),
+            desc->query.c_str(),
+            [desc](const blob& response, const timestamp_type timestamp) {
+                return desc->parse_response(response.as<char>(),
+                    response.size(), timestamp);
+            },
+            on_batch, period, context);
+
+    } else {
+        // Note: We do not check for the sensor being disposed here, because
+        // the destructor uses this to stop sampling.
+        delete this->_sampler;
+        this->_sampler = nullptr;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::scpi_analyser_sensor::start_integrator
+ */
+visus::power_overwhelming::scpi_analyser_sensor&
+visus::power_overwhelming::scpi_analyser_sensor::start_integrator(void) {
+    this->check_not_disposed();
+    this->execute(this->_descriptor->start.c_str());
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::scpi_analyser_sensor::stop_integrator
+ */
+visus::power_overwhelming::scpi_analyser_sensor&
+visus::power_overwhelming::scpi_analyser_sensor::stop_integrator(void) {
+    this->check_not_disposed();
+    this->execute(this->_descriptor->stop.c_str());
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::scpi_analyser_sensor::operator =
+ */
+visus::power_overwhelming::scpi_analyser_sensor&
+visus::power_overwhelming::scpi_analyser_sensor::operator =(
+        _Inout_ scpi_analyser_sensor&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        // Stop our sampler before the descriptor it uses goes away.
+        delete this->_sampler;
+        this->_sampler = rhs._sampler;
+        rhs._sampler = nullptr;
+
+        delete this->_descriptor;
+        this->_descriptor = rhs._descriptor;
+        rhs._descriptor = nullptr;
+
+        this->_instrument = std::move(rhs._instrument);
+        assert(rhs._instrument == false);
+
+        delete[] this->_name;
+        this->_name = rhs._name;
+        rhs._name = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::scpi_analyser_sensor::operator bool
+ */
+visus::power_overwhelming::scpi_analyser_sensor::operator bool(
+        void) const noexcept {
+    return static_cast<bool>(this->_instrument);
+}
+
+
+/*
+ * visus::power_overwhelming::scpi_analyser_sensor::sample_sync
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::scpi_analyser_sensor::sample_sync(
+        _In_ const timestamp_resolution resolution) const {
+    this->check_not_disposed();
+    measurement_data::timestamp_type timestamp;
+    auto response = this->_instrument.timestamped_query(
+        this->_descriptor->query.c_str(), timestamp, resolution);
+    return this->_descriptor->parse_response(response.as<char>(),
+        response.size(), timestamp);
+}
+
+
+/*
+ * visus::power_overwhelming::scpi_analyser_sensor::execute
+ */
+void visus::power_overwhelming::scpi_analyser_sensor::execute(
+        _In_z_ const char *command) {
+    assert(command != nullptr);
+
+    if (*command == 0) {
+        throw std::logic_error("The descriptor of the instrument does not "
+            "specify a command for this operation.");
+    }
+
+    this->_instrument.write(command);
+    this->_instrument.throw_on_system_error();
+}
+
+
+/*
+ * visus::power_overwhelming::scpi_analyser_sensor::initialise
+ */
+void visus::power_overwhelming::scpi_analyser_sensor::initialise(void) {
+    assert(this->_descriptor != nullptr);
+
+    // Query the instrument name for use a sensor name.
+    {
+        auto l = this->_instrument.identify(static_cast<wchar_t *>(nullptr), 0);
+        this->_name = new wchar_t[l];
+        this->_instrument.identify(this->_name, l);
+    }
+
+    // Configure the instrument to answer the query as described by the field
+    // map. We check for errors only once, because the error queue of the
+    // instrument retains all of them.
+    if (!this->_descriptor->setup.empty()) {
+        for (auto& c : this->_descriptor->setup) {
+            this->_instrument.write(c.c_str());
+        }
+
+        this->_instrument.throw_on_system_error();
+    }
+}
@@ -0,0 +1,198 @@
+﻿// <copyright file="scpi_batch.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "scpi_batch.h"
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+#include "scpi_response.h"
+#include "visa_instrument_impl.h"
+
+
+/*
+ * visus::power_overwhelming::detail::parse_scpi_errors
+ */
+std::size_t visus::power_overwhelming::detail::parse_scpi_errors(
+        _Inout_ std::vector<scpi_error>& dst,
+        _In_reads_(cnt) const char *response,
+        _In_ const std::size_t cnt) {
+    static const auto is_space = [](const char c) {
+        return ((c == ' ') || (c == '\t') || (c == '\r') || (c == '\n')
+            || (c == 0));
+    };
+
+    if (response == nullptr) {
+        return 0;
+    }
+
+    const auto end = response + cnt;
+    std::size_t retval = 0;
+
+    for (auto cur = response; cur < end;) {
+        scpi_error error;
+
+        // Skip the separator from the previous entry and any white space.
+        while ((cur < end) && (is_space(*cur) || (*cur == ','))) {
+            ++cur;
+        }
+        if (cur == end) {
+            break;
+        }
+
+        // Parse the error code.
+        std::int64_t code;
+        if (!parse_integer(cur, end, code)) {
+            throw std::runtime_error("The error queue reported by the "
+                "instrument does not have the expected format.");
+        }
+        error.code = static_cast<int>(code);
+
+        // Parse the quoted message, in which quotes are escaped by doubling
+        // them.
+        while ((cur < end) && is_space(*cur)) {
+            ++cur;
+        }
+        if ((cur < end) && (*cur == ',')) {
+            const char *begin = nullptr;
+            const char *last = nullptr;
+
+            ++cur;
+            if (parse_quoted(cur, end, begin, last)) {
+                append_quoted(error.message, begin, last);
+            } else {
+                // The message is not terminated, so it extends to the end of
+                // the response.
+                cur = end;
+            }
+        }
+
+        if (error.code != 0) {
+            dst.push_back(std::move(error));
+            ++retval;
+        }
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::scpi_batch::add
+ */
+visus::power_overwhelming::detail::scpi_batch&
+visus::power_overwhelming::detail::scpi_batch::add(
+        _In_ std::string&& command) {
+    this->_commands.push_back(std::move(command));
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::scpi_batch::describe
+ */
+std::string visus::power_overwhelming::detail::scpi_batch::describe(
+        _In_ const std::vector<scpi_error>& errors) const {
+    static const auto to_upper = [](std::string str) {
+        std::transform(str.begin(), str.end(), str.begin(),
+            [](const char c) {
+                return static_cast<char>(std::toupper(
+                    static_cast<unsigned char>(c)));
+            });
+        return str;
+    };
+
+    std::string retval;
+
+    for (auto& e : errors) {
+        if (!retval.empty()) {
+            retval += " ";
+        }
+
+        retval += std::to_string(e.code);
+        if (!e.message.empty()) {
+            retval += ", ";
+            retval += e.message;
+        }
+
+        // Find all commands whose header, ie everything before the
+        // parameters, is mentioned in the error message.
+        const auto message = to_upper(e.message);
+        auto first = true;
+
+        for (auto& c : this->_commands) {
+            auto header = to_upper(c.substr(0, c.find(' ')));
+            if (!header.empty() && (header.front() == ':')) {
+                header.erase(0, 1);
+            }
+
+            if (!header.empty()
+                    && (message.find(header) != std::string::npos)) {
+                retval += first ? " (caused by \"" : ", \"";
+                retval += c;
+                retval += "\"";
+                first = false;
+            }
+        }
+
+        retval += first ? "." : ").";
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::scpi_batch::execute
+ */
+void visus::power_overwhelming::detail::scpi_batch::execute(
+        _In_ const visa_instrument_impl& instrument) {
+    if (this->empty()) {
+        return;
+    }
+
+    // Clear the batch no matter whether the instrument accepted the commands
+    // or not, because we cannot tell what has been executed in case of an
+    // error.
+    std::vector<scpi_error> errors;
+    try {
+        instrument.write(this->message().c_str());
+        instrument.write(":SYST:ERR:ALL?\n");
+        auto response = instrument.read_all();
+        parse_scpi_errors(errors, response.as<char>(), response.size());
+    } catch (...) {
+        this->clear();
+        throw;
+    }
+
+    if (errors.empty()) {
+        this->clear();
+    } else {
+        const auto description = this->describe(errors);
+        this->clear();
+        throw std::runtime_error(description);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::scpi_batch::message
+ */
+std::string visus::power_overwhelming::detail::scpi_batch::message(
+        void) const {
+    std::string retval;
+
+    for (auto& c : this->_commands) {
+        retval += retval.empty() ? ":" : ";:";
+        retval += (!c.empty() && (c.front() == ':')) ? c.substr(1) : c;
+    }
+
+    if (!retval.empty()) {
+        retval += "\n";
+    }
+
+    return retval;
+}
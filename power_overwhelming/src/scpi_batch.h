@@ -0,0 +1,192 @@
+﻿// <copyright file="scpi_batch.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+#include "string_functions.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /* Forward declarations. */
+    struct visa_instrument_impl;
+
+
+    /// <summary>
+    /// An entry of the error queue of a SCPI instrument.
+    /// </summary>
+    struct scpi_error final {
+
+        /// <summary>
+        /// The error code, which is never zero.
+        /// </summary>
+        int code;
+
+        /// <summary>
+        /// The description of the error without the quotes.
+        /// </summary>
+        std::string message;
+    };
+
+
+    /// <summary>
+    /// Parses the response to <c>SYST:ERR:ALL?</c>, which is a
+    /// comma-separated list of error codes and quoted messages.
+    /// </summary>
+    /// <remarks>
+    /// The entry <c>0,"No error"</c> that terminates the queue is not added
+    /// to <paramref name="dst" />.
+    /// </remarks>
+    /// <param name="dst">Receives the errors in the order reported by the
+    /// instrument, which is from the oldest one to the newest one.</param>
+    /// <param name="response">The response of the instrument.</param>
+    /// <param name="cnt">The number of characters in
+    /// <paramref name="response" />.</param>
+    /// <returns>The number of errors that have been added to
+    /// <paramref name="dst" />.</returns>
+    /// <exception cref="std::runtime_error">If the response does not have the
+    /// expected format.</exception>
+    std::size_t POWER_OVERWHELMING_API parse_scpi_errors(
+        _Inout_ std::vector<scpi_error>& dst,
+        _In_reads_(cnt) const char *response,
+        _In_ const std::size_t cnt);
+
+
+    /// <summary>
+    /// Collects SCPI commands such that they can be sent to an instrument in a
+    /// single message and checked for errors only once.
+    /// </summary>
+    /// <remarks>
+    /// <para>Checking the error state after each command requires a query and
+    /// therefore a round trip to the instrument, which dominates the time for
+    /// configuring an instrument over the network. The batch concatenates all
+    /// commands with semicolons and requests the whole error queue using
+    /// <c>SYST:ERR:ALL?</c> afterwards. Errors are mapped back to the commands
+    /// by searching the message of the error for the header of the command,
+    /// which Rohde &amp; Schwarz instruments typically include.</para>
+    /// <para>All commands must be absolute, ie the batch prefixes each of them
+    /// with a colon to reset the command tree. Queries should not be batched,
+    /// because their responses are not read.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API scpi_batch final {
+
+    public:
+
+        /// <summary>
+        /// Initialises a new, empty batch.
+        /// </summary>
+        scpi_batch(void) = default;
+
+        /// <summary>
+        /// Appends a command to the batch.
+        /// </summary>
+        /// <param name="command">The command to be added, which must not be
+        /// terminated by a line break.</param>
+        /// <returns><c>*this</c>.</returns>
+        scpi_batch& add(_In_ std::string&& command);
+
+        /// <summary>
+        /// Formats the given command and appends it to the batch.
+        /// </summary>
+        /// <typeparam name="TArgs">The types of the arguments for the
+        /// placeholders in <paramref name="format" />.</typeparam>
+        /// <param name="format">The <c>printf</c>-style format of the command,
+        /// which must not be terminated by a line break.</param>
+        /// <param name="args">The arguments for the placeholders in
+        /// <paramref name="format" />.</param>
+        /// <returns><c>*this</c>.</returns>
+        template<class... TArgs>
+        inline scpi_batch& add(_In_z_ const char *format, TArgs&&... args) {
+            return this->add(format_string(format,
+                std::forward<TArgs>(args)...));
+        }
+
+        /// <summary>
+        /// Removes all commands from the batch.
+        /// </summary>
+        inline void clear(void) noexcept {
+            this->_commands.clear();
+        }
+
+        /// <summary>
+        /// Answer the command at the given position within the batch.
+        /// </summary>
+        /// <param name="idx">The zero-based index of the command.</param>
+        /// <returns>The command.</returns>
+        inline const std::string& command(
+                _In_ const std::size_t idx) const {
+            return this->_commands[idx];
+        }
+
+        /// <summary>
+        /// Renders an exception message from the given errors, which are
+        /// assumed to have been caused by the commands in the batch.
+        /// </summary>
+        /// <param name="errors">The errors reported by the instrument.
+        /// </param>
+        /// <returns>A message describing all errors and the commands that
+        /// caused them as far as they could be identified.</returns>
+        std::string describe(
+            _In_ const std::vector<scpi_error>& errors) const;
+
+        /// <summary>
+        /// Answer whether the batch contains no commands.
+        /// </summary>
+        /// <returns><c>true</c> if the batch is empty, <c>false</c>
+        /// otherwise.</returns>
+        inline bool empty(void) const noexcept {
+            return this->_commands.empty();
+        }
+
+        /// <summary>
+        /// Sends all commands to the given instrument, checks the error queue
+        /// and clears the batch.
+        /// </summary>
+        /// <remarks>
+        /// <para>Nothing is sent if the batch is empty.</para>
+        /// <para>The batch is cleared even if the instrument reported an
+        /// error, because it is unknown which of the commands have been
+        /// executed in this case.</para>
+        /// </remarks>
+        /// <param name="instrument">The instrument to send the commands to.
+        /// </param>
+        /// <exception cref="visa_exception">If the communication with the
+        /// instrument failed.</exception>
+        /// <exception cref="std::runtime_error">If the instrument reported any
+        /// error after the commands have been executed.</exception>
+        void execute(_In_ const visa_instrument_impl& instrument);
+
+        /// <summary>
+        /// Renders the message that sends all commands at once.
+        /// </summary>
+        /// <returns>The commands separated by semicolons, including the
+        /// terminating line break. If the batch is empty, the message is
+        /// empty, too.</returns>
+        std::string message(void) const;
+
+        /// <summary>
+        /// Answer the number of commands in the batch.
+        /// </summary>
+        /// <returns>The number of commands.</returns>
+        inline std::size_t size(void) const noexcept {
+            return this->_commands.size();
+        }
+
+    private:
+
+        std::vector<std::string> _commands;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,205 @@
+﻿// <copyright file="scpi_response.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "scpi_response.h"
+
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Skips all white space in the given range.
+    /// </summary>
+    static inline const char *skip_space(_In_ const char *cur,
+            _In_ const char *end) noexcept {
+        while ((cur < end) && ((*cur == ' ') || (*cur == '\t')
+                || (*cur == '\r') || (*cur == '\n') || (*cur == 0))) {
+            ++cur;
+        }
+        return cur;
+    }
+
+    /// <summary>
+    /// Answer the begin and the end of the response, which must not be empty.
+    /// </summary>
+    static inline const char *response_range(_In_ const blob& response,
+            _Out_ const char *& end) {
+        auto retval = response.as<char>();
+        if (retval == nullptr) {
+            throw std::runtime_error("The instrument did not send a "
+                "response.");
+        }
+
+        end = retval + response.size();
+        return retval;
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::append_quoted
+ */
+void visus::power_overwhelming::detail::append_quoted(
+        _Inout_ std::string& dst,
+        _In_ const char *begin,
+        _In_ const char *last) {
+    assert(begin != nullptr);
+    assert(last >= begin);
+    const auto quote = begin[-1];
+
+    dst.reserve(dst.size() + (last - begin));
+    for (auto c = begin; c < last; ++c) {
+        dst += *c;
+        if (*c == quote) {
+            // Skip the second quote of the escape sequence.
+            ++c;
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::parse_integer
+ */
+bool visus::power_overwhelming::detail::parse_integer(
+        _Inout_ const char *& cur,
+        _In_ const char *end,
+        _Out_ std::int64_t& value) noexcept {
+    static constexpr auto max_value = (std::numeric_limits<
+        std::uint64_t>::max)() / 10;
+    auto c = skip_space(cur, end);
+    std::uint64_t magnitude = 0;
+    auto negative = false;
+
+    if ((c < end) && ((*c == '+') || (*c == '-'))) {
+        negative = (*c == '-');
+        ++c;
+    }
+
+    const auto digits = c;
+    for (; (c < end) && (*c >= '0') && (*c <= '9'); ++c) {
+        if (magnitude > max_value) {
+            return false;
+        }
+        magnitude = 10 * magnitude + (*c - '0');
+    }
+
+    if (c == digits) {
+        return false;
+    }
+
+    // Compute in the unsigned domain, where the negation of the minimum is
+    // well-defined.
+    value = static_cast<std::int64_t>(negative ? 0 - magnitude : magnitude);
+    cur = c;
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::parse_quoted
+ */
+bool visus::power_overwhelming::detail::parse_quoted(
+        _Inout_ const char *& cur,
+        _In_ const char *end,
+        _Out_ const char *& begin,
+        _Out_ const char *& last) noexcept {
+    auto c = skip_space(cur, end);
+
+    if ((c == end) || ((*c != '"') && (*c != '\''))) {
+        return false;
+    }
+
+    const auto quote = *c++;
+    for (auto b = c; c < end; ++c) {
+        if (*c == quote) {
+            if ((c + 1 < end) && (c[1] == quote)) {
+                // This is an escaped quote.
+                ++c;
+            } else {
+                begin = b;
+                last = c;
+                cur = c + 1;
+                return true;
+            }
+        }
+    }
+
+    // The string is not terminated.
+    return false;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::parse_real_list
+ */
+bool visus::power_overwhelming::detail::parse_real_list(
+        _Inout_ const char *& cur,
+        _In_ const char *end,
+        _Out_writes_(cnt) double *dst,
+        _In_ const std::size_t cnt) noexcept {
+    assert((dst != nullptr) || (cnt == 0));
+    auto c = cur;
+
+    for (std::size_t i = 0; i < cnt; ++i) {
+        if (i > 0) {
+            c = skip_space(c, end);
+            if ((c == end) || (*c++ != ',')) {
+                return false;
+            }
+        }
+
+        if (!parse_real(c, end, dst[i])) {
+            return false;
+        }
+    }
+
+    cur = c;
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::parse_integer_response
+ */
+std::int64_t visus::power_overwhelming::detail::parse_integer_response(
+        _In_ const blob& response) {
+    const char *end = nullptr;
+    auto cur = response_range(response, end);
+    std::int64_t retval;
+
+    if (!parse_integer(cur, end, retval) || (skip_space(cur, end) != end)) {
+        throw std::runtime_error("The instrument did not respond with an "
+            "integer.");
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::parse_real_response
+ */
+double visus::power_overwhelming::detail::parse_real_response(
+        _In_ const blob& response) {
+    const char *end = nullptr;
+    auto cur = response_range(response, end);
+    double retval;
+
+    if (!parse_real(cur, end, retval) || (skip_space(cur, end) != end)) {
+        throw std::runtime_error("The instrument did not respond with a "
+            "number.");
+    }
+
+    return retval;
+}
@@ -0,0 +1,119 @@
+﻿// <copyright file="scpi_response.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <string>
+
+#include "power_overwhelming/blob.h"
+
+#include "parse_real.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Appends the content of a string located by <see cref="parse_quoted" />
+    /// to <paramref name="dst" />, removing the escaping of quotes.
+    /// </summary>
+    /// <param name="dst">The string to append the content to.</param>
+    /// <param name="begin">The begin of the content as returned by
+    /// <see cref="parse_quoted" />, which must be preceded by the opening
+    /// quote.</param>
+    /// <param name="last">The end of the content as returned by
+    /// <see cref="parse_quoted" />.</param>
+    void POWER_OVERWHELMING_API append_quoted(_Inout_ std::string& dst,
+        _In_ const char *begin, _In_ const char *last);
+
+    /// <summary>
+    /// Parses a decimal integer in the range
+    /// [<paramref name="cur" />, <paramref name="end" />[.
+    /// </summary>
+    /// <remarks>
+    /// Like <see cref="parse_real" />, the input does not need to be
+    /// null-terminated, so responses can be parsed in the buffer they have
+    /// been received in. Leading white space is skipped and the number may
+    /// have a sign.
+    /// </remarks>
+    /// <param name="cur">The begin of the range to be parsed. If the method
+    /// succeeds, this pointer is moved past the last digit. Otherwise, it
+    /// remains unchanged.</param>
+    /// <param name="end">The end of the range to be parsed.</param>
+    /// <param name="value">Receives the parsed value.</param>
+    /// <returns><c>true</c> if a number has been parsed, <c>false</c>
+    /// otherwise.</returns>
+    bool POWER_OVERWHELMING_API parse_integer(_Inout_ const char *& cur,
+        _In_ const char *end, _Out_ std::int64_t& value) noexcept;
+
+    /// <summary>
+    /// Parses a SCPI string, which is enclosed in single or double quotes, in
+    /// the range [<paramref name="cur" />, <paramref name="end" />[.
+    /// </summary>
+    /// <remarks>
+    /// The method does not copy the string, but only reports where its
+    /// content is located in the input. Quotes within the string are escaped
+    /// by doubling them, and this escaping is not removed from the content.
+    /// </remarks>
+    /// <param name="cur">The begin of the range to be parsed. If the method
+    /// succeeds, this pointer is moved past the closing quote. Otherwise, it
+    /// remains unchanged.</param>
+    /// <param name="end">The end of the range to be parsed.</param>
+    /// <param name="begin">Receives the begin of the content of the string.
+    /// </param>
+    /// <param name="last">Receives the end of the content of the string,
+    /// i.e. the position of the closing quote.</param>
+    /// <returns><c>true</c> if a string has been parsed, <c>false</c>
+    /// otherwise.</returns>
+    bool POWER_OVERWHELMING_API parse_quoted(_Inout_ const char *& cur,
+        _In_ const char *end, _Out_ const char *& begin,
+        _Out_ const char *& last) noexcept;
+
+    /// <summary>
+    /// Parses a comma-separated list of exactly <paramref name="cnt" />
+    /// numbers in the range
+    /// [<paramref name="cur" />, <paramref name="end" />[.
+    /// </summary>
+    /// <param name="cur">The begin of the range to be parsed. If the method
+    /// succeeds, this pointer is moved past the last number. Otherwise, it
+    /// remains unchanged.</param>
+    /// <param name="end">The end of the range to be parsed.</param>
+    /// <param name="dst">Receives the parsed numbers. The content of the
+    /// array is undefined if the method fails.</param>
+    /// <param name="cnt">The number of numbers to be parsed.</param>
+    /// <returns><c>true</c> if all numbers have been parsed, <c>false</c>
+    /// otherwise.</returns>
+    bool POWER_OVERWHELMING_API parse_real_list(_Inout_ const char *& cur,
+        _In_ const char *end, _Out_writes_(cnt) double *dst,
+        _In_ const std::size_t cnt) noexcept;
+
+    /// <summary>
+    /// Parses the response of an instrument that consists of a single
+    /// integer.
+    /// </summary>
+    /// <param name="response">The response of the instrument.</param>
+    /// <returns>The number in the response.</returns>
+    /// <exception cref="std::runtime_error">If the response is not a number
+    /// or contains anything but white space after it.</exception>
+    std::int64_t POWER_OVERWHELMING_API parse_integer_response(
+        _In_ const blob& response);
+
+    /// <summary>
+    /// Parses the response of an instrument that consists of a single
+    /// floating-point number.
+    /// </summary>
+    /// <param name="response">The response of the instrument.</param>
+    /// <returns>The number in the response.</returns>
+    /// <exception cref="std::runtime_error">If the response is not a number
+    /// or contains anything but white space after it.</exception>
+    double POWER_OVERWHELMING_API parse_real_response(
+        _In_ const blob& response);
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
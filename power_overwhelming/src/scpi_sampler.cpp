@@ -0,0 +1,117 @@
+﻿// <copyright file="scpi_sampler.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "scpi_sampler.h"
+
+#include <cassert>
+
+#include "library_thread.h"
+#include "start_barrier.h"
+
+
+/*
+ * visus::power_overwhelming::detail::scpi_sampler::scpi_sampler
+ */
+visus::power_overwhelming::detail::scpi_sampler::scpi_sampler(
+        _In_z_ const char *path,
+        _In_z_ const wchar_t *name,
+        _In_z_ const char *query,
+        _In_ const parser_type& parser,
+        _In_ const measurement_data_callback callback,
+        _In_ const sensor::microseconds_type period,
+        _In_opt_ void *context)
+    : _callback(callback), _context(context), _errors(0),
+        _instrument(path, 0), _name(name), _parser(parser),
+        _period(period), _query(query), _running(true), _sent(0) {
+    assert(callback != nullptr);
+    assert(name != nullptr);
+    assert(parser);
+    // Note: the timeout passed to the instrument is irrelevant, because the
+    // session of the sensor is reused, which has already been configured.
+    this->_thread = std::thread(&scpi_sampler::sample, this);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::scpi_sampler::~scpi_sampler
+ */
+visus::power_overwhelming::detail::scpi_sampler::~scpi_sampler(void) {
+    this->_running.store(false, std::memory_order_release);
+    if (this->_thread.joinable()) {
+        this->_thread.join();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::scpi_sampler::send
+ */
+void visus::power_overwhelming::detail::scpi_sampler::send(void) {
+    this->_timer.wait();
+    this->_sent = create_timestamp(timestamp_resolution::milliseconds);
+    this->_instrument.write(this->_query.c_str());
+}
+
+
+/*
+ * visus::power_overwhelming::detail::scpi_sampler::sample
+ */
+void visus::power_overwhelming::detail::scpi_sampler::sample(void) {
+    auto pending = false;
+
+    enter_library_thread("PwrOwg SCPI Sampler Thread");
+
+    // Take the first sample on the common tick if multiple sensors are being
+    // started at once.
+    this->_timer.start(this->_period, start_barrier::wait());
+
+    while (this->_running.load(std::memory_order_acquire)) {
+        try {
+            if (!pending) {
+                this->send();
+                pending = true;
+            }
+
+            auto response = this->_instrument.read_all();
+            pending = false;
+            const auto received = create_timestamp(
+                timestamp_resolution::milliseconds);
+            const auto timestamp = this->_sent + (received - this->_sent) / 2;
+
+            // Put the instrument to work on the next sample before we spend
+            // any time on the current one.
+            if (this->_running.load(std::memory_order_acquire)) {
+                this->send();
+                pending = true;
+            }
+
+            const auto sample = this->_parser(response, timestamp);
+            this->_callback(this->_name, &sample, 1, this->_context);
+
+        } catch (...) {
+            // We cannot report errors from the sampler thread, so we count them
+            // and try to get the instrument back into a defined state by
+            // discarding the query we might have been waiting for.
+            this->_errors.fetch_add(1, std::memory_order_relaxed);
+            pending = false;
+
+            try {
+                this->_instrument.clear();
+            } catch (...) { /* There is nothing else we can do. */ }
+        }
+    }
+
+    if (pending) {
+        // Do not leave the response in the output queue of the instrument, or
+        // the next one who queries the instrument will read it.
+        try {
+            this->_instrument.read_all();
+        } catch (...) {
+            try {
+                this->_instrument.clear();
+            } catch (...) { }
+        }
+    }
+}
@@ -0,0 +1,144 @@
+﻿// <copyright file="scpi_sampler.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <cinttypes>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include "power_overwhelming/blob.h"
+#include "power_overwhelming/measurement.h"
+#include "power_overwhelming/sensor.h"
+#include "power_overwhelming/visa_instrument.h"
+
+#include "periodic_timer.h"
+#include "timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A dedicated sampler thread continuously streaming measurements from a
+    /// single SCPI instrument, which answers a single query with all values of
+    /// a sample.
+    /// </summary>
+    /// <remarks>
+    /// <para>The sampling rate of bench instruments is limited by the round trip to
+    /// the instrument rather than by the instrument itself, wherefore each
+    /// instrument has its own thread instead of being sampled on the shared
+    /// sampler thread, where it would also delay all other sensors.</para>
+    /// <para>The sampler keeps the instrument busy by pipelining the queries:
+    /// as soon as the response to a query has been received, the next query is
+    /// sent before the response is parsed and delivered. SCPI does not allow
+    /// for more than one query to be in flight, so this is as much overlap as
+    /// we can get. The timestamp of a sample is the midpoint of the round trip
+    /// of its query, which is the best estimate of when the instrument has
+    /// answered.</para>
+    /// <para>The sampler opens its own <see cref="visa_instrument" /> for the
+    /// path of the sensor, which shares the session with the sensor, such that
+    /// the sensor can be moved while it is being sampled. However, the
+    /// instrument must not be used otherwise while the sampler is running as
+    /// the responses would get mixed up.</para>
+    /// </remarks>
+    class scpi_sampler {
+
+    public:
+
+        /// <summary>
+        /// The type of a function converting the response of the instrument
+        /// into a sample.
+        /// </summary>
+        /// <remarks>
+        /// The function may throw if the response is invalid, which is counted
+        /// as an error of the sampler.
+        /// </remarks>
+        typedef std::function<measurement_data(_In_ const blob&,
+            _In_ const timestamp_type)> parser_type;
+
+        /// <summary>
+        /// Initialises a new instance and starts sampling.
+        /// </summary>
+        /// <param name="path">The VISA path of the instrument, which must
+        /// already be open.</param>
+        /// <param name="name">The name of the sensor reported to
+        /// <paramref name="callback" />, which must live as long as the
+        /// sampler.</param>
+        /// <param name="query">The query retrieving a sample from the
+        /// instrument, including the terminating newline.</param>
+        /// <param name="parser">The function converting the response to
+        /// <paramref name="query" /> into a sample. The function is invoked on
+        /// the sampler thread.</param>
+        /// <param name="callback">The callback receiving the samples.</param>
+        /// <param name="period">The minimum interval between two queries in
+        /// microseconds.</param>
+        /// <param name="context">A user-defined context pointer passed to
+        /// <paramref name="callback" />.</param>
+        /// <exception cref="visa_exception">If the instrument could not be
+        /// opened.</exception>
+        scpi_sampler(_In_z_ const char *path,
+            _In_z_ const wchar_t *name,
+            _In_z_ const char *query,
+            _In_ const parser_type& parser,
+            _In_ const measurement_data_callback callback,
+            _In_ const sensor::microseconds_type period,
+            _In_opt_ void *context);
+
+        scpi_sampler(const scpi_sampler&) = delete;
+
+        /// <summary>
+        /// Stops sampling and finalises the instance.
+        /// </summary>
+        /// <remarks>
+        /// The destructor blocks until the query in flight has been answered or
+        /// timed out such that the instrument can be used again afterwards.
+        /// </remarks>
+        ~scpi_sampler(void);
+
+        /// <summary>
+        /// Answer the number of queries that failed, for instance because they
+        /// timed out.
+        /// </summary>
+        /// <returns>The number of failed queries.</returns>
+        inline std::uint64_t errors(void) const noexcept {
+            return this->_errors.load(std::memory_order_relaxed);
+        }
+
+        scpi_sampler& operator =(const scpi_sampler&) = delete;
+
+    private:
+
+        /// <summary>
+        /// Sends a query to the instrument and remembers the time it has been
+        /// sent.
+        /// </summary>
+        void send(void);
+
+        /// <summary>
+        /// Streams the measurements until <see cref="_running" /> is cleared.
+        /// </summary>
+        void sample(void);
+
+        measurement_data_callback _callback;
+        void *_context;
+        std::atomic<std::uint64_t> _errors;
+        visa_instrument _instrument;
+        const wchar_t *_name;
+        parser_type _parser;
+        periodic_timer::interval_type _period;
+        std::string _query;
+        std::atomic<bool> _running;
+        timestamp_type _sent;
+        std::thread _thread;
+        periodic_timer _timer;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,489 @@
+﻿// <copyright file="scpi_socket.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "scpi_socket.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#if !defined(_WIN32)
+#include <sys/select.h>
+#endif /* !defined(_WIN32) */
+
+// WinSock2.h must be included before Windows.h.
+#include "socket_functions.h"
+
+#include "on_exit.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The size of the buffer for parsing the responses.
+    /// </summary>
+    static constexpr std::size_t scpi_socket_buffer_size = 64 * 1024;
+
+    /// <summary>
+    /// The native type of a socket.
+    /// </summary>
+    typedef decltype(INVALID_SOCKET) scpi_socket_type;
+
+    /// <summary>
+    /// Converts the handle stored in <see cref="scpi_socket" /> into a native
+    /// socket.
+    /// </summary>
+    static inline scpi_socket_type scpi_socket_native(
+            _In_ const std::intptr_t socket) noexcept {
+        return static_cast<scpi_socket_type>(socket);
+    }
+
+    /// <summary>
+    /// Answer whether <paramref name="str" /> equals the upper-case
+    /// <paramref name="keyword" /> regardless of its case.
+    /// </summary>
+    static bool scpi_socket_keyword(_In_ const std::string& str,
+            _In_z_ const char *keyword) {
+        assert(keyword != nullptr);
+        const auto len = ::strlen(keyword);
+        if (str.size() != len) {
+            return false;
+        }
+
+        for (std::size_t i = 0; i < len; ++i) {
+            const auto c = static_cast<unsigned char>(str[i]);
+            if (std::toupper(c) != keyword[i]) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /// <summary>
+    /// Converts the error of a failed socket operation into an exception,
+    /// reporting timeouts as <see cref="std::errc::timed_out" />.
+    /// </summary>
+    [[noreturn]] static void scpi_socket_throw(void) {
+        const auto error = get_socket_error();
+#if defined(_WIN32)
+        if (error == WSAETIMEDOUT) {
+#else /* defined(_WIN32) */
+        if ((error == EAGAIN) || (error == EWOULDBLOCK)) {
+#endif /* defined(_WIN32) */
+            throw std::system_error(std::make_error_code(
+                std::errc::timed_out), "The instrument did not respond in "
+                "time.");
+        }
+
+        throw std::system_error(error, std::system_category());
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::scpi_socket::default_port
+ */
+constexpr std::uint16_t
+visus::power_overwhelming::detail::scpi_socket::default_port;
+
+
+/*
+ * visus::power_overwhelming::detail::scpi_socket::default_timeout
+ */
+constexpr std::uint32_t
+visus::power_overwhelming::detail::scpi_socket::default_timeout;
+
+
+/*
+ * visus::power_overwhelming::detail::scpi_socket::interface_type
+ */
+constexpr std::uint16_t
+visus::power_overwhelming::detail::scpi_socket::interface_type;
+
+
+/*
+ * ...::detail::scpi_socket::receive_buffer_size
+ */
+constexpr int
+visus::power_overwhelming::detail::scpi_socket::receive_buffer_size;
+
+
+/*
+ * visus::power_overwhelming::detail::scpi_socket::parse
+ */
+bool visus::power_overwhelming::detail::scpi_socket::parse(
+        _In_ const std::string& path,
+        _Out_ std::string& host,
+        _Out_ std::uint16_t& port) {
+    std::vector<std::string> parts;
+
+    // Split the resource string at the double colons.
+    for (std::size_t begin = 0; begin <= path.size();) {
+        auto end = path.find("::", begin);
+        if (end == std::string::npos) {
+            end = path.size();
+        }
+
+        parts.push_back(path.substr(begin, end - begin));
+        begin = end + 2;
+    }
+
+    if ((parts.size() < 3) || (parts.size() > 4)) {
+        return false;
+    }
+
+    // The interface must be TCPIP with an optional board number.
+    {
+        auto& intf = parts.front();
+        auto digits = intf.size();
+        while ((digits > 0) && std::isdigit(static_cast<unsigned char>(
+                intf[digits - 1]))) {
+            --digits;
+        }
+
+        if (!scpi_socket_keyword(intf.substr(0, digits), "TCPIP")) {
+            return false;
+        }
+    }
+
+    if (!scpi_socket_keyword(parts.back(), "SOCKET") || parts[1].empty()) {
+        return false;
+    }
+
+    if (parts.size() == 4) {
+        auto& p = parts[2];
+        if (p.empty() || (p.size() > 5) || !std::all_of(p.begin(), p.end(),
+                [](const char c) {
+                    return std::isdigit(static_cast<unsigned char>(c)) != 0;
+                })) {
+            return false;
+        }
+
+        const auto value = std::atoi(p.c_str());
+        if ((value <= 0) || (value > 0xFFFF)) {
+            return false;
+        }
+
+        port = static_cast<std::uint16_t>(value);
+    } else {
+        port = default_port;
+    }
+
+    host = parts[1];
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::scpi_socket::scpi_socket
+ */
+visus::power_overwhelming::detail::scpi_socket::scpi_socket(
+        _In_ const std::string& host,
+        _In_ const std::uint16_t port)
+        : _begin(0), _buffer(scpi_socket_buffer_size), _end(0),
+        _socket(static_cast<std::intptr_t>(INVALID_SOCKET)), _termchar('\n'),
+        _termchar_enabled(true) {
+#if defined(_WIN32)
+    {
+        WSADATA wsa_data = { };
+        auto status = ::WSAStartup(MAKEWORD(2, 2), &wsa_data);
+        if (status != 0) {
+            throw std::system_error(status, std::system_category());
+        }
+    }
+
+    auto guard_wsa_cleanup = on_exit([](void) { ::WSACleanup(); });
+#endif /* defined(_WIN32) */
+
+    addrinfo hints = { };
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+
+    addrinfo *addresses = nullptr;
+    const auto service = std::to_string(port);
+    const auto status = ::getaddrinfo(host.c_str(), service.c_str(), &hints,
+        &addresses);
+    if (status != 0) {
+#if defined(_WIN32)
+        throw std::system_error(status, std::system_category());
+#else /* defined(_WIN32) */
+        throw std::runtime_error(::gai_strerror(status));
+#endif /* defined(_WIN32) */
+    }
+
+    const auto guard_addresses = on_exit([addresses](void) {
+        ::freeaddrinfo(addresses);
+    });
+
+    // Use the first address we can connect to.
+    auto error = 0;
+    auto socket = static_cast<scpi_socket_type>(INVALID_SOCKET);
+    for (auto a = addresses; a != nullptr; a = a->ai_next) {
+        socket = ::socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (socket == INVALID_SOCKET) {
+            error = get_socket_error();
+            continue;
+        }
+
+        if (::connect(socket, a->ai_addr, static_cast<int>(a->ai_addrlen))
+                != SOCKET_ERROR) {
+            break;
+        }
+
+        error = get_socket_error();
+        close_socket(socket);
+        socket = INVALID_SOCKET;
+    }
+
+    if (socket == INVALID_SOCKET) {
+        if (error == 0) {
+            throw std::runtime_error("The address of the instrument could "
+                "not be resolved.");
+        }
+        throw std::system_error(error, std::system_category());
+    }
+
+    // Commands and queries are short and answered one after the other, so
+    // delaying them to coalesce packets only adds latency. Waveforms, in
+    // contrast, are large, so the instrument should be able to send as much
+    // as possible before it needs to wait for us.
+    {
+        int value = 1;
+        ::setsockopt(socket, IPPROTO_TCP, TCP_NODELAY,
+            reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+    {
+        int value = receive_buffer_size;
+        ::setsockopt(socket, SOL_SOCKET, SO_RCVBUF,
+            reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    this->_socket = static_cast<std::intptr_t>(socket);
+    this->timeout(default_timeout);
+
+#if defined(_WIN32)
+    // The socket library is cleaned up when the socket is closed.
+    guard_wsa_cleanup.cancel();
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::scpi_socket::~scpi_socket
+ */
+visus::power_overwhelming::detail::scpi_socket::~scpi_socket(void) {
+    close_socket(scpi_socket_native(this->_socket));
+#if defined(_WIN32)
+    ::WSACleanup();
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::scpi_socket::clear
+ */
+void visus::power_overwhelming::detail::scpi_socket::clear(void) {
+    const auto socket = scpi_socket_native(this->_socket);
+    this->_begin = this->_end = 0;
+
+    // Receive whatever has already arrived without blocking.
+    while (true) {
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(socket, &readable);
+        timeval immediately = { };
+
+        const auto status = ::select(static_cast<int>(socket + 1), &readable,
+            nullptr, nullptr, &immediately);
+        if (status == SOCKET_ERROR) {
+            scpi_socket_throw();
+        }
+        if (status == 0) {
+            break;
+        }
+
+        const auto n = ::recv(socket,
+            reinterpret_cast<char *>(this->_buffer.data()),
+            static_cast<int>(this->_buffer.size()), 0);
+        if (n == SOCKET_ERROR) {
+            scpi_socket_throw();
+        }
+        if (n == 0) {
+            throw std::runtime_error("The instrument closed the connection.");
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::scpi_socket::read
+ */
+std::size_t visus::power_overwhelming::detail::scpi_socket::read(
+        _Out_writes_bytes_(cnt) byte_type *dst,
+        _In_ const std::size_t cnt,
+        _Out_opt_ bool *terminated) {
+    assert((dst != nullptr) || (cnt == 0));
+    std::size_t retval = 0;
+
+    if (terminated != nullptr) {
+        *terminated = false;
+    }
+
+    while (retval < cnt) {
+        if (this->_begin == this->_end) {
+            // Do not block for more data if we already have something to
+            // return, because the instrument might not send anything else.
+            if (retval > 0) {
+                break;
+            }
+
+            this->_begin = 0;
+            this->_end = this->receive(this->_buffer.data(),
+                this->_buffer.size());
+        }
+
+        auto begin = this->_buffer.data() + this->_begin;
+        auto end = begin + (std::min)(this->_end - this->_begin,
+            cnt - retval);
+        auto found = false;
+
+        if (this->_termchar_enabled) {
+            auto t = std::find(begin, end,
+                static_cast<byte_type>(this->_termchar));
+            if (t != end) {
+                end = t + 1;
+                found = true;
+            }
+        }
+
+        const auto n = static_cast<std::size_t>(end - begin);
+        ::memcpy(dst + retval, begin, n);
+        this->_begin += n;
+        retval += n;
+
+        if (found) {
+            if (terminated != nullptr) {
+                *terminated = true;
+            }
+            break;
+        }
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::scpi_socket::read_all
+ */
+void visus::power_overwhelming::detail::scpi_socket::read_all(
+        _Out_writes_bytes_(cnt) byte_type *dst,
+        _In_ const std::size_t cnt) {
+    assert((dst != nullptr) || (cnt == 0));
+    std::size_t offset = 0;
+
+    // Use what has already been buffered first.
+    {
+        const auto n = (std::min)(this->_end - this->_begin, cnt);
+        ::memcpy(dst, this->_buffer.data() + this->_begin, n);
+        this->_begin += n;
+        offset += n;
+    }
+
+    while (offset < cnt) {
+        const auto remaining = cnt - offset;
+
+        if (remaining >= this->_buffer.size()) {
+            // Large blocks are received in place to avoid copying them.
+            offset += this->receive(dst + offset, remaining);
+
+        } else {
+            this->_begin = 0;
+            this->_end = this->receive(this->_buffer.data(),
+                this->_buffer.size());
+
+            const auto n = (std::min)(this->_end, remaining);
+            ::memcpy(dst + offset, this->_buffer.data(), n);
+            this->_begin = n;
+            offset += n;
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::scpi_socket::timeout
+ */
+void visus::power_overwhelming::detail::scpi_socket::timeout(
+        _In_ const std::uint32_t timeout) noexcept {
+#if defined(_WIN32)
+    DWORD value = timeout;
+#else /* defined(_WIN32) */
+    timeval value = { };
+    value.tv_sec = timeout / 1000;
+    value.tv_usec = (timeout % 1000) * 1000;
+#endif /* defined(_WIN32) */
+    const auto socket = scpi_socket_native(this->_socket);
+    ::setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO,
+        reinterpret_cast<const char *>(&value), sizeof(value));
+    ::setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO,
+        reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::scpi_socket::write
+ */
+void visus::power_overwhelming::detail::scpi_socket::write(
+        _In_reads_bytes_(cnt) const byte_type *src,
+        _In_ const std::size_t cnt) {
+    assert((src != nullptr) || (cnt == 0));
+    std::size_t sent = 0;
+
+    while (sent < cnt) {
+        const auto n = ::send(scpi_socket_native(this->_socket),
+            reinterpret_cast<const char *>(src + sent),
+            static_cast<int>(cnt - sent), MSG_NOSIGNAL);
+        if (n == SOCKET_ERROR) {
+            scpi_socket_throw();
+        }
+        sent += static_cast<std::size_t>(n);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::scpi_socket::receive
+ */
+std::size_t visus::power_overwhelming::detail::scpi_socket::receive(
+        _Out_writes_bytes_(cnt) byte_type *dst,
+        _In_ const std::size_t cnt) {
+    assert(dst != nullptr);
+    assert(cnt > 0);
+    const auto n = ::recv(scpi_socket_native(this->_socket),
+        reinterpret_cast<char *>(dst),
+        static_cast<int>((std::min)(cnt, static_cast<std::size_t>(
+        receive_buffer_size))), 0);
+
+    if (n == SOCKET_ERROR) {
+        scpi_socket_throw();
+    }
+    if (n == 0) {
+        throw std::runtime_error("The instrument closed the connection.");
+    }
+
+    return static_cast<std::size_t>(n);
+}
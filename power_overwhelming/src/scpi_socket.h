@@ -0,0 +1,231 @@
+﻿// <copyright file="scpi_socket.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <string>
+#include <vector>
+
+#include "power_overwhelming/blob.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A raw TCP connection to an instrument accepting SCPI commands, which
+    /// replaces a VISA session for <c>SOCKET</c> resources.
+    /// </summary>
+    /// <remarks>
+    /// <para>Instruments like the HMC8015 and the RTA/RTB oscilloscopes accept
+    /// SCPI commands on a plain TCP port, typically
+    /// <see cref="default_port" />. Talking to this port directly avoids the
+    /// overhead of VISA on each call and works on machines where no VISA
+    /// installation is available.</para>
+    /// <para>The socket disables Nagle's algorithm, because SCPI exchanges
+    /// short commands in lock-step with their responses, and uses a large
+    /// receive buffer for downloading waveforms. Reads behave like
+    /// <c>viRead</c> on a session with an enabled termination character,
+    /// ie they return after the termination character or once the buffer is
+    /// full, whichever comes first.</para>
+    /// <para>The socket is not thread-safe, which is the same as for a VISA
+    /// session being used for exchanging SCPI commands.</para>
+    /// <para>The header does not include the socket API, because it is
+    /// included by the VISA implementation, which might have included
+    /// <c>Windows.h</c> before.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API scpi_socket final {
+
+    public:
+
+        /// <summary>
+        /// The type representing a single byte.
+        /// </summary>
+        typedef blob::byte_type byte_type;
+
+        /// <summary>
+        /// The port of the SCPI service of R&amp;S instruments.
+        /// </summary>
+        static constexpr std::uint16_t default_port = 5025;
+
+        /// <summary>
+        /// The initial timeout of all I/O operations in milliseconds, which
+        /// is the default of <c>VI_ATTR_TMO_VALUE</c>.
+        /// </summary>
+        static constexpr std::uint32_t default_timeout = 2000;
+
+        /// <summary>
+        /// The value of <c>VI_INTF_TCPIP</c>, which is the interface type
+        /// reported for the socket.
+        /// </summary>
+        static constexpr std::uint16_t interface_type = 6;
+
+        /// <summary>
+        /// The size of the receive buffer of the socket in bytes.
+        /// </summary>
+        static constexpr int receive_buffer_size = 4 * 1024 * 1024;
+
+        /// <summary>
+        /// Splits a VISA resource string of the form
+        /// <c>TCPIP[board]::host::port::SOCKET</c> into the host and the port.
+        /// </summary>
+        /// <remarks>
+        /// The keywords are matched case-insensitively as in VISA. The port
+        /// may be omitted, in which case <see cref="default_port" /> is used.
+        /// </remarks>
+        /// <param name="path">The resource string.</param>
+        /// <param name="host">Receives the host name or address if the path
+        /// designates a socket.</param>
+        /// <param name="port">Receives the port if the path designates a
+        /// socket.</param>
+        /// <returns><c>true</c> if <paramref name="path" /> designates a
+        /// socket, <c>false</c> otherwise.</returns>
+        static bool parse(_In_ const std::string& path,
+            _Out_ std::string& host,
+            _Out_ std::uint16_t& port);
+
+        /// <summary>
+        /// Connects to the given instrument.
+        /// </summary>
+        /// <param name="host">The host name or address of the instrument.
+        /// </param>
+        /// <param name="port">The port of the SCPI service.</param>
+        /// <exception cref="std::system_error">If the connection could not be
+        /// established.</exception>
+        /// <exception cref="std::runtime_error">If the host could not be
+        /// resolved.</exception>
+        scpi_socket(_In_ const std::string& host,
+            _In_ const std::uint16_t port);
+
+        scpi_socket(const scpi_socket&) = delete;
+
+        /// <summary>
+        /// Closes the connection.
+        /// </summary>
+        ~scpi_socket(void);
+
+        /// <summary>
+        /// Discards all input that has been received, but not read.
+        /// </summary>
+        /// <remarks>
+        /// Raw sockets have no device clear, so this is the closest we can
+        /// get to <c>viClear</c>: After a timeout, the remainder of a late
+        /// response is discarded instead of being read as the response to the
+        /// next query.
+        /// </remarks>
+        void clear(void);
+
+        /// <summary>
+        /// Reads at most <paramref name="cnt" /> bytes, but stops after the
+        /// termination character if it is enabled.
+        /// </summary>
+        /// <param name="dst">The buffer to receive the data.</param>
+        /// <param name="cnt">The size of <paramref name="dst" /> in bytes.
+        /// </param>
+        /// <param name="terminated">Receives whether the read stopped at the
+        /// termination character.</param>
+        /// <returns>The number of bytes read.</returns>
+        /// <exception cref="std::system_error">If the data could not be
+        /// received, including a timeout.</exception>
+        /// <exception cref="std::runtime_error">If the instrument closed the
+        /// connection.</exception>
+        std::size_t read(_Out_writes_bytes_(cnt) byte_type *dst,
+            _In_ const std::size_t cnt,
+            _Out_opt_ bool *terminated = nullptr);
+
+        /// <summary>
+        /// Reads exactly <paramref name="cnt" /> bytes regardless of the
+        /// termination character.
+        /// </summary>
+        /// <remarks>
+        /// This is used for the payload of binary blocks, which may contain
+        /// the termination character. Large reads bypass the internal buffer
+        /// and receive into <paramref name="dst" /> directly.
+        /// </remarks>
+        /// <param name="dst">The buffer to receive the data.</param>
+        /// <param name="cnt">The number of bytes to read.</param>
+        /// <exception cref="std::system_error">If the data could not be
+        /// received, including a timeout.</exception>
+        /// <exception cref="std::runtime_error">If the instrument closed the
+        /// connection.</exception>
+        void read_all(_Out_writes_bytes_(cnt) byte_type *dst,
+            _In_ const std::size_t cnt);
+
+        /// <summary>
+        /// Answer the termination character of reads.
+        /// </summary>
+        /// <returns>The termination character.</returns>
+        inline char termchar(void) const noexcept {
+            return this->_termchar;
+        }
+
+        /// <summary>
+        /// Sets the termination character of reads.
+        /// </summary>
+        /// <param name="termchar">The termination character.</param>
+        inline void termchar(_In_ const char termchar) noexcept {
+            this->_termchar = termchar;
+        }
+
+        /// <summary>
+        /// Answer whether reads stop at the termination character.
+        /// </summary>
+        /// <returns><c>true</c> if the termination character is enabled,
+        /// <c>false</c> otherwise.</returns>
+        inline bool termchar_enabled(void) const noexcept {
+            return this->_termchar_enabled;
+        }
+
+        /// <summary>
+        /// Enables or disables stopping reads at the termination character.
+        /// </summary>
+        /// <param name="enabled"><c>true</c> for enabling the termination
+        /// character, <c>false</c> for disabling it.</param>
+        inline void termchar_enabled(_In_ const bool enabled) noexcept {
+            this->_termchar_enabled = enabled;
+        }
+
+        /// <summary>
+        /// Sets the timeout of all I/O operations.
+        /// </summary>
+        /// <param name="timeout">The timeout in milliseconds, or zero for
+        /// blocking indefinitely.</param>
+        void timeout(_In_ const std::uint32_t timeout) noexcept;
+
+        /// <summary>
+        /// Writes all of the given data.
+        /// </summary>
+        /// <param name="src">The data to be written.</param>
+        /// <param name="cnt">The number of bytes to write.</param>
+        /// <exception cref="std::system_error">If the data could not be
+        /// sent.</exception>
+        void write(_In_reads_bytes_(cnt) const byte_type *src,
+            _In_ const std::size_t cnt);
+
+        scpi_socket& operator =(const scpi_socket&) = delete;
+
+    private:
+
+        /// <summary>
+        /// Receives at most <paramref name="cnt" /> bytes into
+        /// <paramref name="dst" />, blocking until at least one byte is
+        /// available.
+        /// </summary>
+        std::size_t receive(_Out_writes_bytes_(cnt) byte_type *dst,
+            _In_ const std::size_t cnt);
+
+        std::size_t _begin;
+        std::vector<byte_type> _buffer;
+        std::size_t _end;
+        std::intptr_t _socket;
+        char _termchar;
+        bool _termchar_enabled;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -5,6 +5,81 @@
 
 #include "power_overwhelming/sensor.h"
 
+#include <chrono>
+#include <stdexcept>
+
+#include "on_exit.h"
+#include "start_barrier.h"
+#include "sync_sampler.h"
+
+
+/*
+ * visus::power_overwhelming::sensor::sample_all
+ */
+void visus::power_overwhelming::sensor::sample_all(
+        _In_reads_(cnt) sensor *const *sensors,
+        _In_ const std::size_t cnt,
+        _In_ const measurement_data_callback on_batch,
+        _In_ const microseconds_type period,
+        _In_opt_ void *context,
+        _Out_writes_opt_(cnt) microseconds_type *latencies) {
+    typedef detail::start_barrier::clock_type clock_type;
+    using namespace std::chrono;
+
+    if (on_batch == nullptr) {
+        throw std::invalid_argument("A valid callback must be provided to "
+            "sample sensors.");
+    }
+    if ((sensors == nullptr) && (cnt > 0)) {
+        throw std::invalid_argument("The array of sensors must not be null.");
+    }
+
+    // Hold back all sampler threads until the last sensor has been prepared.
+    detail::start_barrier::arm();
+    const auto guard_barrier = on_exit([](void) {
+        detail::start_barrier::release();
+    });
+
+    std::size_t i = 0;
+
+    try {
+        for (; i < cnt; ++i) {
+            const auto begin = clock_type::now();
+
+            if (sensors[i] != nullptr) {
+                sensors[i]->sample_batch(on_batch, period, context);
+            }
+
+            if (latencies != nullptr) {
+                latencies[i] = (sensors[i] != nullptr)
+                    ? duration_cast<microseconds>(clock_type::now()
+                        - begin).count()
+                    : 0;
+            }
+        }
+    } catch (...) {
+        // Roll back the sensors we have already started.
+        while (i-- > 0) {
+            try {
+                if (sensors[i] != nullptr) {
+                    sensors[i]->sample_batch(nullptr);
+                }
+            } catch (...) { /* Ignore this, we need to stop all. */ }
+        }
+        throw;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::sensor::native_interval
+ */
+visus::power_overwhelming::sensor::microseconds_type
+visus::power_overwhelming::sensor::native_interval(void) const {
+    this->check_not_disposed();
+    return 0;
+}
+
 
 /*
  * visus::power_overwhelming::sensor::sample
@@ -18,12 +93,84 @@ visus::power_overwhelming::sensor::sample(
 }
 
 
+/*
+ * visus::power_overwhelming::sensor::sample_batch
+ */
+void visus::power_overwhelming::sensor::sample_batch(
+        _In_opt_ const measurement_data_callback on_batch,
+        _In_ const microseconds_type period,
+        _In_opt_ void *context) {
+    typedef detail::sync_sampler::interval_type interval_type;
+
+    if (on_batch != nullptr) {
+        this->check_not_disposed();
+
+        if (!detail::sync_sampler::add(*this, on_batch, context,
+                interval_type(period))) {
+            throw std::logic_error("Asynchronous sampling cannot be started "
+                "while it is already running.");
+        }
+
+    } else {
+        // Note: We do not check for the sensor being disposed here, because
+        // implementations use this to stop sampling in their destructors.
+        detail::sync_sampler::remove(*this, context);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::sensor::sample_adaptive
+ */
+void visus::power_overwhelming::sensor::sample_adaptive(
+        _In_opt_ const measurement_data_callback on_batch,
+        _In_ const microseconds_type min_period,
+        _In_ const microseconds_type max_period,
+        _In_opt_ void *context) {
+    // Sensors with their own sampler cannot change their rate.
+    this->sample_batch(on_batch, max_period, context);
+}
+
+
 /*
  * visus::power_overwhelming::sensor::check_not_disposed
  */
 void visus::power_overwhelming::sensor::check_not_disposed(void) const {
     if (!*this) {
-        throw std::runtime_error("A sensor which has been disposed by "
-            "a move operation cannot be used anymore.");
+        throw_disposed();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::sensor::throw_disposed
+ */
+void visus::power_overwhelming::sensor::throw_disposed(void) {
+    throw std::runtime_error("A sensor which has been disposed by a move "
+        "operation cannot be used anymore.");
+}
+
+
+/*
+ * visus::power_overwhelming::sensor::sample_adaptive_sync
+ */
+void visus::power_overwhelming::sensor::sample_adaptive_sync(
+        _In_opt_ const measurement_data_callback on_batch,
+        _In_ const microseconds_type min_period,
+        _In_ const microseconds_type max_period,
+        _In_opt_ void *context) {
+    typedef detail::sync_sampler::interval_type interval_type;
+
+    if (on_batch != nullptr) {
+        this->check_not_disposed();
+
+        if (!detail::sync_sampler::add(*this, on_batch, context,
+                interval_type(max_period), interval_type(min_period))) {
+            throw std::logic_error("Asynchronous sampling cannot be started "
+                "while it is already running.");
+        }
+
+    } else {
+        detail::sync_sampler::remove(*this, context);
     }
 }
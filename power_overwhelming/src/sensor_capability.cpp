@@ -0,0 +1,233 @@
+﻿// <copyright file="sensor_capability.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "sensor_capability.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+
+#include <nlohmann/json.hpp>
+
+#include "power_overwhelming/computer_name.h"
+#include "power_overwhelming/convert_string.h"
+
+#include "library_thread.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    static constexpr const char *field_cpu_time = "cpuTime";
+    static constexpr const char *field_error = "error";
+    static constexpr const char *field_latency = "latency";
+    static constexpr const char *field_machine = "machine";
+    static constexpr const char *field_max = "max";
+    static constexpr const char *field_median = "median";
+    static constexpr const char *field_min = "min";
+    static constexpr const char *field_p99 = "p99";
+    static constexpr const char *field_safe_interval = "safeInterval";
+    static constexpr const char *field_samples = "samples";
+    static constexpr const char *field_sensors = "sensors";
+    static constexpr const char *field_update_interval = "updateInterval";
+
+    /// <summary>
+    /// Converts a latency in nanoseconds to microseconds.
+    /// </summary>
+    static inline double to_microseconds(
+            _In_ const latency_histogram::value_type value) noexcept {
+        return static_cast<double>(value) / 1000.0;
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::load_read_costs
+ */
+std::unordered_map<std::wstring, double>
+visus::power_overwhelming::detail::load_read_costs(
+        _In_z_ const wchar_t *path) {
+    std::unordered_map<std::wstring, double> retval;
+
+    std::ifstream s;
+    s.exceptions(s.exceptions() | std::ios::failbit | std::ios::badbit);
+#if defined(_WIN32)
+    s.open(path);
+#else /* defined(_WIN32) */
+    s.open(power_overwhelming::convert_string<char>(path));
+#endif /* defined(_WIN32) */
+    const auto report = nlohmann::json::parse(s);
+
+    auto sensors = report.find(field_sensors);
+    if (sensors != report.end()) {
+        for (auto& i : sensors->items()) {
+            auto cpu_time = i.value().find(field_cpu_time);
+            if ((cpu_time != i.value().end()) && !i.value().contains(
+                    field_error)) {
+                auto name = power_overwhelming::convert_string<wchar_t>(
+                    i.key());
+                retval[name] = cpu_time->get<double>();
+            }
+        }
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::load_safe_intervals
+ */
+std::unordered_map<std::wstring,
+    visus::power_overwhelming::sensor::microseconds_type>
+visus::power_overwhelming::detail::load_safe_intervals(
+        _In_z_ const wchar_t *path) {
+    std::unordered_map<std::wstring, sensor::microseconds_type> retval;
+
+    std::ifstream s;
+    s.exceptions(s.exceptions() | std::ios::failbit | std::ios::badbit);
+#if defined(_WIN32)
+    s.open(path);
+#else /* defined(_WIN32) */
+    s.open(power_overwhelming::convert_string<char>(path));
+#endif /* defined(_WIN32) */
+    const auto report = nlohmann::json::parse(s);
+
+    auto sensors = report.find(field_sensors);
+    if (sensors != report.end()) {
+        for (auto& i : sensors->items()) {
+            auto interval = i.value().find(field_safe_interval);
+            if ((interval != i.value().end()) && !i.value().contains(
+                    field_error)) {
+                auto name = power_overwhelming::convert_string<wchar_t>(
+                    i.key());
+                retval[name] = interval->get<sensor::microseconds_type>();
+            }
+        }
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::probe_capability
+ */
+visus::power_overwhelming::detail::sensor_capability
+visus::power_overwhelming::detail::probe_capability(
+        _In_ const sensor& sensor,
+        _In_ const std::chrono::microseconds duration) {
+    typedef std::chrono::steady_clock clock_type;
+    std::uint64_t changes = 0;
+    std::uint64_t cpu_time = 0;
+    std::vector<clock_type::duration> intervals;
+    auto last_change = clock_type::time_point();
+    sensor_capability retval;
+
+    if (sensor.name() != nullptr) {
+        retval.name = sensor.name();
+    }
+
+    const auto deadline = clock_type::now() + duration;
+    measurement_data previous(0, 0.0f);
+
+    try {
+        do {
+            const auto cpu_begin = get_thread_cpu_time();
+            const auto begin = clock_type::now();
+            const auto sample = sensor.sample(timestamp_resolution::
+                hundred_nanoseconds);
+            const auto end = clock_type::now();
+            cpu_time += get_thread_cpu_time() - cpu_begin;
+
+            retval.latency.record(static_cast<latency_histogram::value_type>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                end - begin).count()));
+
+            // The timestamp changes on every sample, so only the readings
+            // tell whether the source has produced new data.
+            auto& data = sample.data();
+            const auto changed = (retval.samples > 0)
+                && ((data.voltage() != previous.voltage())
+                || (data.current() != previous.current())
+                || (data.power() != previous.power()));
+            if (changed) {
+                if (changes > 0) {
+                    intervals.push_back(end - last_change);
+                }
+                last_change = end;
+                ++changes;
+            }
+
+            previous = data;
+            ++retval.samples;
+        } while (clock_type::now() < deadline);
+
+    } catch (std::exception& ex) {
+        retval.error = ex.what();
+    }
+
+    if (retval.samples > 0) {
+        retval.cpu_time = static_cast<double>(cpu_time) / 1000.0
+            / static_cast<double>(retval.samples);
+    }
+
+    // If (almost) every sample changes, the source is at least as fast as
+    // we can poll it, so there is no update interval to respect.
+    if (!intervals.empty() && (changes * 10 < (retval.samples - 1) * 9)) {
+        const auto median = intervals.begin() + intervals.size() / 2;
+        std::nth_element(intervals.begin(), median, intervals.end());
+        retval.update_interval = std::chrono::duration_cast<
+            std::chrono::microseconds>(*median).count();
+    }
+
+    const auto p99 = std::ceil(2.0 * to_microseconds(
+        retval.latency.percentile(0.99)));
+    retval.safe_interval = (std::max)(retval.update_interval,
+        (std::max)(sensor::microseconds_type(1),
+        static_cast<sensor::microseconds_type>(p99)));
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::write_capability_report
+ */
+std::ostream& visus::power_overwhelming::detail::write_capability_report(
+        _In_ std::ostream& stream,
+        _In_ const std::vector<sensor_capability>& capabilities) {
+    nlohmann::json report;
+    report[field_machine] = computer_name<char>();
+    report[field_sensors] = nlohmann::json::object();
+
+    for (auto& c : capabilities) {
+        nlohmann::json latency;
+        latency[field_min] = to_microseconds(c.latency.min());
+        latency[field_median] = to_microseconds(c.latency.percentile(0.5));
+        latency[field_p99] = to_microseconds(c.latency.percentile(0.99));
+        latency[field_max] = to_microseconds(c.latency.max());
+
+        nlohmann::json sensor;
+        sensor[field_cpu_time] = c.cpu_time;
+        sensor[field_latency] = latency;
+        sensor[field_safe_interval] = c.safe_interval;
+        sensor[field_samples] = c.samples;
+        sensor[field_update_interval] = c.update_interval;
+        if (!c.error.empty()) {
+            sensor[field_error] = c.error;
+        }
+
+        const auto name = power_overwhelming::convert_string<char>(c.name);
+        report[field_sensors][name] = sensor;
+    }
+
+    return stream << report.dump(4);
+}
@@ -0,0 +1,147 @@
+﻿// <copyright file="sensor_capability.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <chrono>
+#include <cinttypes>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "power_overwhelming/latency_histogram.h"
+#include "power_overwhelming/sensor.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The capabilities of a sensor on the current machine, which have been
+    /// measured by <see cref="probe_capability" />.
+    /// </summary>
+    struct POWER_OVERWHELMING_API sensor_capability final {
+
+        /// <summary>
+        /// The mean CPU time in microseconds that the probing thread spent
+        /// per sample.
+        /// </summary>
+        double cpu_time;
+
+        /// <summary>
+        /// The message of the exception if the sensor could not be sampled.
+        /// </summary>
+        std::string error;
+
+        /// <summary>
+        /// The distribution of the time in nanoseconds it took to obtain a
+        /// single sample.
+        /// </summary>
+        latency_histogram latency;
+
+        /// <summary>
+        /// The name of the sensor.
+        /// </summary>
+        std::wstring name;
+
+        /// <summary>
+        /// The shortest interval in microseconds at which the sensor should
+        /// be sampled.
+        /// </summary>
+        /// <remarks>
+        /// This is the <see cref="update_interval" />, but at least twice the
+        /// 99th percentile of the <see cref="latency" />, such that a sampler
+        /// thread spends at most half of its time in the sensor.
+        /// </remarks>
+        sensor::microseconds_type safe_interval;
+
+        /// <summary>
+        /// The number of samples obtained while probing.
+        /// </summary>
+        std::uint64_t samples;
+
+        /// <summary>
+        /// The median interval in microseconds between changes of the
+        /// readings, which is zero if the readings changed on (almost) every
+        /// sample or not at all.
+        /// </summary>
+        sensor::microseconds_type update_interval;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        inline sensor_capability(void) : cpu_time(0.0), safe_interval(0),
+            samples(0), update_interval(0) { }
+    };
+
+    /// <summary>
+    /// Reads the CPU time per read of the sensors from a capability report.
+    /// </summary>
+    /// <param name="path">The path to a report created by
+    /// <see cref="write_capability_report" />.</param>
+    /// <returns>The <see cref="sensor_capability::cpu_time" /> in
+    /// microseconds for the names of all sensors that could be sampled.
+    /// </returns>
+    /// <exception cref="std::ios_base::failure">If the file could not be
+    /// read.</exception>
+    /// <exception cref="nlohmann::json::exception">If the file is not a valid
+    /// report.</exception>
+    POWER_OVERWHELMING_API std::unordered_map<std::wstring, double>
+    load_read_costs(_In_z_ const wchar_t *path);
+
+    /// <summary>
+    /// Reads the safe sampling intervals from a capability report.
+    /// </summary>
+    /// <param name="path">The path to a report created by
+    /// <see cref="write_capability_report" />.</param>
+    /// <returns>The <see cref="sensor_capability::safe_interval" /> in
+    /// microseconds for the names of all sensors that could be sampled.
+    /// </returns>
+    /// <exception cref="std::ios_base::failure">If the file could not be
+    /// read.</exception>
+    /// <exception cref="nlohmann::json::exception">If the file is not a valid
+    /// report.</exception>
+    POWER_OVERWHELMING_API std::unordered_map<std::wstring,
+        sensor::microseconds_type> load_safe_intervals(
+        _In_z_ const wchar_t *path);
+
+    /// <summary>
+    /// Determines the capabilities of the given sensor by sampling it
+    /// synchronously as fast as possible.
+    /// </summary>
+    /// <remarks>
+    /// The sensor is sampled on the calling thread for the given
+    /// <paramref name="duration" />, but at least once. Exceptions thrown by
+    /// the sensor are recorded in <see cref="sensor_capability::error" />
+    /// and end the probe.
+    /// </remarks>
+    /// <param name="sensor">The sensor to be probed, which must not be
+    /// sampled asynchronously at the same time.</param>
+    /// <param name="duration">The time for which the sensor is probed.
+    /// </param>
+    /// <returns>The capabilities of the sensor.</returns>
+    POWER_OVERWHELMING_API sensor_capability probe_capability(
+        _In_ const sensor& sensor,
+        _In_ const std::chrono::microseconds duration);
+
+    /// <summary>
+    /// Writes a JSON report of the given capabilities.
+    /// </summary>
+    /// <remarks>
+    /// The report contains the name of the machine and an object per sensor
+    /// with all times in microseconds.
+    /// </remarks>
+    /// <param name="stream">The stream to write to.</param>
+    /// <param name="capabilities">The capabilities of the sensors.</param>
+    /// <returns><paramref name="stream" />.</returns>
+    POWER_OVERWHELMING_API std::ostream& write_capability_report(
+        _In_ std::ostream& stream,
+        _In_ const std::vector<sensor_capability>& capabilities);
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -12,6 +12,18 @@
 constexpr const char *visus::power_overwhelming::detail::sensor_desc<
     visus::power_overwhelming::adl_sensor>::type_name;
 
+/*
+ * visus::power_overwhelming::amdgpu_sensor>::type_name
+ */
+constexpr const char *visus::power_overwhelming::detail::sensor_desc<
+    visus::power_overwhelming::amdgpu_sensor>::type_name;
+
+/*
+ * visus::power_overwhelming::dcgm_sensor>::type_name
+ */
+constexpr const char *visus::power_overwhelming::detail::sensor_desc<
+    visus::power_overwhelming::dcgm_sensor>::type_name;
+
 /*
  * visus::power_overwhelming::emi_sensor>::type_name
  */
@@ -24,6 +36,12 @@ constexpr const char *visus::power_overwhelming::detail::sensor_desc<
 constexpr const char *visus::power_overwhelming::detail::sensor_desc<
     visus::power_overwhelming::hmc8015_sensor>::type_name;
 
+/*
+ * visus::power_overwhelming::level_zero_sensor>::type_name
+ */
+constexpr const char *visus::power_overwhelming::detail::sensor_desc<
+    visus::power_overwhelming::level_zero_sensor>::type_name;
+
 /*
  * visus::power_overwhelming::msr_sensor>::type_name
  */
@@ -36,14 +54,38 @@ constexpr const char *visus::power_overwhelming::detail::sensor_desc<
 constexpr const char *visus::power_overwhelming::detail::sensor_desc<
     visus::power_overwhelming::nvml_sensor>::type_name;
 
+/*
+ * visus::power_overwhelming::perf_rapl_sensor>::type_name
+ */
+constexpr const char *visus::power_overwhelming::detail::sensor_desc<
+    visus::power_overwhelming::perf_rapl_sensor>::type_name;
+
+/*
+ * visus::power_overwhelming::replay_sensor>::type_name
+ */
+constexpr const char *visus::power_overwhelming::detail::sensor_desc<
+    visus::power_overwhelming::replay_sensor>::type_name;
+
 /*
  * visus::power_overwhelming::rtx_sensor>::type_name
  */
 constexpr const char *visus::power_overwhelming::detail::sensor_desc<
     visus::power_overwhelming::rtx_sensor>::type_name;
 
+/*
+ * visus::power_overwhelming::sysfs_sensor>::type_name
+ */
+constexpr const char *visus::power_overwhelming::detail::sensor_desc<
+    visus::power_overwhelming::sysfs_sensor>::type_name;
+
 /*
  * visus::power_overwhelming::tinkerforge_sensor>::type_name
  */
 constexpr const char *visus::power_overwhelming::detail::sensor_desc<
     visus::power_overwhelming::tinkerforge_sensor>::type_name;
+
+/*
+ * visus::power_overwhelming::synthetic_sensor>::type_name
+ */
+constexpr const char *visus::power_overwhelming::detail::sensor_desc<
+    visus::power_overwhelming::synthetic_sensor>::type_name;
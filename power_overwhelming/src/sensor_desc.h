@@ -5,17 +5,25 @@
 
 #pragma once
 
+#include <chrono>
 #include <type_traits>
 
 #include "nlohmann/json.hpp"
 
 #include "power_overwhelming/adl_sensor.h"
+#include "power_overwhelming/amdgpu_sensor.h"
+#include "power_overwhelming/dcgm_sensor.h"
 #include "power_overwhelming/emi_sensor.h"
 #include "power_overwhelming/hmc8015_sensor.h"
+#include "power_overwhelming/level_zero_sensor.h"
 #include "power_overwhelming/msr_sensor.h"
 #include "power_overwhelming/nvml_sensor.h"
+#include "power_overwhelming/perf_rapl_sensor.h"
 #include "power_overwhelming/regex_escape.h"
+#include "power_overwhelming/replay_sensor.h"
 #include "power_overwhelming/rtx_sensor.h"
+#include "power_overwhelming/synthetic_sensor.h"
+#include "power_overwhelming/sysfs_sensor.h"
 #include "power_overwhelming/tinkerforge_sensor.h"
 
 #include "described_sensor_type.h"
@@ -30,6 +38,16 @@
 #define POWER_OVERWHELMING_DECLARE_SENSOR_NAME(name)\
     static constexpr const char *type_name = #name
 
+/// <summary>
+/// Declares the static method <c>discovery_timeout</c> returning the time in
+/// milliseconds that the discovery of all sensors of the described type may
+/// take before it is abandoned.
+/// </summary>
+#define POWER_OVERWHELMING_DECLARE_DISCOVERY_TIMEOUT(millis)\
+    static inline std::chrono::milliseconds discovery_timeout(void) {\
+        return std::chrono::milliseconds(millis);\
+    }
+
 /// <summary>
 /// Declares the static constant <c>intrinsic_async</c> specifying whether a
 /// sensor is intrinsically asynchronous and should not be sampled by polling if
@@ -43,22 +61,38 @@ namespace visus {
 namespace power_overwhelming {
 namespace detail {
 
+    static constexpr const char *json_field_amplitude = "amplitude";
+    static constexpr const char *json_field_async = "async";
+    static constexpr const char *json_field_bus_id = "busId";
     static constexpr const char *json_field_channel = "channel";
+    static constexpr const char *json_field_channel_current = "channelCurrent";
+    static constexpr const char *json_field_channel_voltage = "channelVoltage";
     static constexpr const char *json_field_core = "core";
+    static constexpr const char *json_field_cost = "cost";
     static constexpr const char *json_field_domain = "domain";
     static constexpr const char *json_field_description = "description";
     static constexpr const char *json_field_dev_guid = "deviceGuid";
+    static constexpr const char *json_field_energy_mode = "energyMode";
+    static constexpr const char *json_field_gpu = "gpu";
     static constexpr const char *json_field_host = "host";
+    static constexpr const char *json_field_loop = "loop";
     static constexpr const char *json_field_name = "name";
     static constexpr const char *json_field_offset = "offset";
     static constexpr const char *json_field_path = "path";
+    static constexpr const char *json_field_period = "period";
     static constexpr const char *json_field_port = "port";
+    static constexpr const char *json_field_quantity = "quantity";
+    static constexpr const char *json_field_rebase = "rebase";
+    static constexpr const char *json_field_scale = "scale";
     static constexpr const char *json_field_source = "source";
+    static constexpr const char *json_field_speed = "speed";
     static constexpr const char *json_field_timeout = "timeout";
     static constexpr const char *json_field_type = "type";
     static constexpr const char *json_field_udid = "udid";
     static constexpr const char *json_field_uid = "uid";
     static constexpr const char *json_field_unit_divisor = "unitDivisor";
+    static constexpr const char *json_field_voltage = "voltage";
+    static constexpr const char *json_field_waveform = "waveform";
 
     /// <summary>
     /// Test whether a descriptor has the ability to serialise all sensors at
@@ -100,6 +134,18 @@ namespace detail {
             return (value[detail::json_field_type] == TDerived::type_name);
         }
 
+        /// <summary>
+        /// Answer how long the discovery of all sensors of the described type
+        /// may take before it is abandoned.
+        /// </summary>
+        /// <remarks>
+        /// Sensors that need to probe network resources should hide this
+        /// method using <c>POWER_OVERWHELMING_DECLARE_DISCOVERY_TIMEOUT</c>
+        /// such that slow instruments do not delay the start-up of the
+        /// application unduly.
+        /// </remarks>
+        POWER_OVERWHELMING_DECLARE_DISCOVERY_TIMEOUT(5000);
+
     };
 
 
@@ -155,6 +201,70 @@ namespace detail {
         }
     };
 
+    /// <summary>
+    /// Specialisation for <see cref="amdgpu_sensor" />.
+    /// </summary>
+    template<> struct sensor_desc<amdgpu_sensor> final
+            : detail::sensor_desc_base<sensor_desc<amdgpu_sensor>> {
+        POWER_OVERWHELMING_DECLARE_SENSOR_NAME(amdgpu_sensor);
+        POWER_OVERWHELMING_DECLARE_INTRINSIC_ASYNC(false);
+
+        static inline value_type deserialise(_In_ const nlohmann::json& value) {
+            auto bus_id = value[json_field_bus_id].get<std::string>();
+            auto source0 = value[json_field_source].get<std::string>();
+            auto source = power_overwhelming::convert_string<wchar_t>(source0);
+            return value_type::from_bus_id(bus_id.c_str(),
+                parse_amdgpu_sensor_source(source.c_str()));
+        }
+
+        static inline nlohmann::json serialise(_In_ const value_type& value) {
+            auto name = power_overwhelming::convert_string<char>(value.name());
+            auto source0 = to_string(value.source());
+            auto source = power_overwhelming::convert_string<char>(source0);
+
+            return nlohmann::json::object({
+                { json_field_type, type_name },
+                { json_field_name, name },
+                { json_field_bus_id, value.bus_id() },
+                { json_field_source, source }
+            });
+        }
+    };
+
+    /// <summary>
+    /// Specialisation for <see cref="dcgm_sensor" />.
+    /// </summary>
+    template<> struct sensor_desc<dcgm_sensor> final
+            : detail::sensor_desc_base<sensor_desc<dcgm_sensor>> {
+        POWER_OVERWHELMING_DECLARE_SENSOR_NAME(dcgm_sensor);
+        POWER_OVERWHELMING_DECLARE_INTRINSIC_ASYNC(false);
+
+        static inline value_type deserialise(const nlohmann::json& value) {
+            const auto hit = value.find(json_field_host);
+            const auto pit = value.find(json_field_period);
+            auto gpu = value[json_field_gpu].get<dcgm_sensor::gpu_type>();
+            auto host = (hit != value.end())
+                ? hit->get<std::string>()
+                : std::string();
+            auto period = (pit != value.end())
+                ? pit->get<dcgm_sensor::microseconds_type>()
+                : dcgm_sensor::default_update_interval;
+            return value_type::for_gpu(gpu, host.c_str(), period);
+        }
+
+        static inline nlohmann::json serialise(const value_type& value) {
+            auto name = power_overwhelming::convert_string<char>(value.name());
+
+            return nlohmann::json::object({
+                { json_field_type, type_name },
+                { json_field_name, name },
+                { json_field_gpu, value.gpu() },
+                { json_field_host, value.host() },
+                { json_field_period, value.native_interval() }
+            });
+        }
+    };
+
     /// <summary>
     /// Specialisation for <see cref="emi_sensor" />.
     /// </summary>
@@ -221,6 +331,7 @@ namespace detail {
             : detail::sensor_desc_base<sensor_desc<hmc8015_sensor>> {
         POWER_OVERWHELMING_DECLARE_SENSOR_NAME(hmc8015_sensor);
         POWER_OVERWHELMING_DECLARE_INTRINSIC_ASYNC(false);
+        POWER_OVERWHELMING_DECLARE_DISCOVERY_TIMEOUT(2000);
 
         static inline value_type deserialise(const nlohmann::json& value) {
             auto path = value[json_field_path].get<std::string>();
@@ -241,6 +352,33 @@ namespace detail {
         }
     };
 
+    /// <summary>
+    /// Specialisation for <see cref="level_zero_sensor" />.
+    /// </summary>
+    template<> struct sensor_desc<level_zero_sensor> final
+            : detail::sensor_desc_base<sensor_desc<level_zero_sensor>> {
+        POWER_OVERWHELMING_DECLARE_SENSOR_NAME(level_zero_sensor);
+        POWER_OVERWHELMING_DECLARE_INTRINSIC_ASYNC(false);
+
+        static inline value_type deserialise(_In_ const nlohmann::json& value) {
+            auto bus_id = value[json_field_bus_id].get<std::string>();
+            auto domain = value[json_field_domain]
+                .get<level_zero_sensor::domain_type>();
+            return value_type::for_domain(bus_id.c_str(), domain);
+        }
+
+        static inline nlohmann::json serialise(_In_ const value_type& value) {
+            auto name = power_overwhelming::convert_string<char>(value.name());
+
+            return nlohmann::json::object({
+                { json_field_type, type_name },
+                { json_field_name, name },
+                { json_field_bus_id, value.bus_id() },
+                { json_field_domain, value.domain() }
+            });
+        }
+    };
+
     /// <summary>
     /// Specialisation for <see cref="msr_sensor" />.
     /// </summary>
@@ -251,7 +389,7 @@ namespace detail {
 
         static inline value_type deserialise(_In_ const nlohmann::json& value) {
             auto core = value[json_field_core].get<msr_sensor::core_type>();
-            auto divisor = value[json_field_unit_divisor].get<float>();
+            auto divisor = value[json_field_unit_divisor].get<double>();
             auto domain0 = value[json_field_domain].get<std::string>();
             auto domain1 = power_overwhelming::convert_string<wchar_t>(domain0);
             auto domain = parse_rapl_domain(domain1.c_str());
@@ -292,8 +430,15 @@ namespace detail {
         POWER_OVERWHELMING_DECLARE_INTRINSIC_ASYNC(false);
 
         static inline value_type deserialise(const nlohmann::json& value) {
+            const auto eit = value.find(json_field_energy_mode);
             auto guid = value[json_field_dev_guid].get<std::string>();
-            return value_type::from_guid(guid.c_str());
+            auto retval = value_type::from_guid(guid.c_str());
+
+            if ((eit != value.end()) && eit->get<bool>()) {
+                retval.energy_mode(true);
+            }
+
+            return retval;
         }
 
         static inline nlohmann::json serialise(const value_type& value) {
@@ -303,7 +448,92 @@ namespace detail {
             return nlohmann::json::object({
                 { json_field_type, type_name },
                 { json_field_name, name },
-                { json_field_dev_guid, guid }
+                { json_field_dev_guid, guid },
+                { json_field_energy_mode, value.energy_mode() }
+            });
+        }
+    };
+
+    /// <summary>
+    /// Specialisation for <see cref="perf_rapl_sensor" />.
+    /// </summary>
+    template<> struct sensor_desc<perf_rapl_sensor> final
+            : detail::sensor_desc_base<sensor_desc<perf_rapl_sensor>> {
+        POWER_OVERWHELMING_DECLARE_SENSOR_NAME(perf_rapl_sensor);
+        POWER_OVERWHELMING_DECLARE_INTRINSIC_ASYNC(false);
+
+        static inline value_type deserialise(_In_ const nlohmann::json& value) {
+            auto core = value[json_field_core]
+                .get<perf_rapl_sensor::core_type>();
+            auto domain0 = value[json_field_domain].get<std::string>();
+            auto domain1 = power_overwhelming::convert_string<wchar_t>(domain0);
+            auto domain = parse_rapl_domain(domain1.c_str());
+            return value_type::for_core(core, domain);
+        }
+
+        static inline nlohmann::json serialise(_In_ const value_type& value) {
+            auto core = value.core();
+            auto domain0 = to_string(value.domain());
+            auto domain = power_overwhelming::convert_string<char>(domain0);
+            auto name = power_overwhelming::convert_string<char>(value.name());
+
+            return nlohmann::json::object({
+                { json_field_type, type_name },
+                { json_field_name, name },
+                { json_field_core, core },
+                { json_field_domain, domain }
+            });
+        }
+    };
+
+    /// <summary>
+    /// Specialisation for <see cref="replay_sensor" />.
+    /// </summary>
+    /// <remarks>
+    /// The sensor can only be created from a configuration, because it is not
+    /// discovered. The path and the name of the recorded sensor are required,
+    /// the properties of the replay are optional.
+    /// </remarks>
+    template<> struct sensor_desc<replay_sensor> final
+            : detail::sensor_desc_base<sensor_desc<replay_sensor>> {
+        POWER_OVERWHELMING_DECLARE_SENSOR_NAME(replay_sensor);
+        POWER_OVERWHELMING_DECLARE_INTRINSIC_ASYNC(true);
+
+        static inline value_type deserialise(_In_ const nlohmann::json& value) {
+            const auto lit = value.find(json_field_loop);
+            const auto rit = value.find(json_field_rebase);
+            const auto sit = value.find(json_field_speed);
+
+            auto name = power_overwhelming::convert_string<wchar_t>(
+                value[json_field_name].get<std::string>());
+            auto path = power_overwhelming::convert_string<wchar_t>(
+                value[json_field_path].get<std::string>());
+            value_type retval(path.c_str(), name.c_str());
+
+            if (lit != value.end()) {
+                retval.loop(lit->get<bool>());
+            }
+            if (rit != value.end()) {
+                retval.rebase(rit->get<bool>());
+            }
+            if (sit != value.end()) {
+                retval.speed(sit->get<double>());
+            }
+
+            return retval;
+        }
+
+        static inline nlohmann::json serialise(_In_ const value_type& value) {
+            auto name = power_overwhelming::convert_string<char>(value.name());
+            auto path = power_overwhelming::convert_string<char>(value.path());
+
+            return nlohmann::json::object({
+                { json_field_type, type_name },
+                { json_field_name, name },
+                { json_field_path, path },
+                { json_field_speed, value.speed() },
+                { json_field_loop, value.loop() },
+                { json_field_rebase, value.rebase() }
             });
         }
     };
@@ -315,11 +545,32 @@ namespace detail {
             : detail::sensor_desc_base<sensor_desc<rtx_sensor>> {
         POWER_OVERWHELMING_DECLARE_SENSOR_NAME(rtx_sensor);
         POWER_OVERWHELMING_DECLARE_INTRINSIC_ASYNC(false);
+        POWER_OVERWHELMING_DECLARE_DISCOVERY_TIMEOUT(2000);
 
         static inline value_type deserialise(const nlohmann::json& value) {
+            const auto cit = value.find(json_field_channel_current);
+            const auto dit = value.find(json_field_description);
+            const auto vit = value.find(json_field_channel_voltage);
+
             auto path = value[json_field_path].get<std::string>();
             auto timeout = value[json_field_timeout].get<std::int32_t>();
-            return value_type(path.c_str(), timeout);
+
+            // The channels are optional for compatibility with existing
+            // configuration files.
+            auto current = (cit != value.end())
+                ? cit->get<std::uint32_t>()
+                : value_type::default_channel_current;
+            auto voltage = (vit != value.end())
+                ? vit->get<std::uint32_t>()
+                : value_type::default_channel_voltage;
+            auto desc = (dit != value.end())
+                ? power_overwhelming::convert_string<wchar_t>(
+                    dit->get<std::string>())
+                : std::wstring();
+
+            oscilloscope_sensor_definition definition(desc.c_str(), voltage,
+                current);
+            return value_type(path.c_str(), definition, timeout);
         }
 
         static inline nlohmann::json serialise(const value_type& value) {
@@ -330,11 +581,119 @@ namespace detail {
                 { json_field_type, type_name },
                 { json_field_name, name },
                 { json_field_path, path },
+                { json_field_channel_voltage, value.channel_voltage() },
+                { json_field_channel_current, value.channel_current() },
                 { json_field_timeout, 3000 }
             });
         }
     };
 
+    /// <summary>
+    /// Specialisation for <see cref="synthetic_sensor" />.
+    /// </summary>
+    /// <remarks>
+    /// The sensor can only be created from a configuration, because it is not
+    /// discovered. All of its properties except for the name are optional.
+    /// </remarks>
+    template<> struct sensor_desc<synthetic_sensor> final
+            : detail::sensor_desc_base<sensor_desc<synthetic_sensor>> {
+        POWER_OVERWHELMING_DECLARE_SENSOR_NAME(synthetic_sensor);
+        POWER_OVERWHELMING_DECLARE_INTRINSIC_ASYNC(false);
+
+        static inline value_type deserialise(const nlohmann::json& value) {
+            const auto ait = value.find(json_field_amplitude);
+            const auto async = value.find(json_field_async);
+            const auto cit = value.find(json_field_cost);
+            const auto oit = value.find(json_field_offset);
+            const auto pit = value.find(json_field_period);
+            const auto vit = value.find(json_field_voltage);
+            const auto wit = value.find(json_field_waveform);
+
+            auto name0 = value[json_field_name].get<std::string>();
+            auto name = power_overwhelming::convert_string<wchar_t>(name0);
+            value_type retval(name.c_str());
+
+            if (ait != value.end()) {
+                retval.amplitude(ait->get<value_type::value_type>());
+            }
+            if (async != value.end()) {
+                retval.async(async->get<bool>());
+            }
+            if (cit != value.end()) {
+                retval.cost(cit->get<value_type::microseconds_type>());
+            }
+            if (oit != value.end()) {
+                retval.offset(oit->get<value_type::value_type>());
+            }
+            if (pit != value.end()) {
+                retval.period(pit->get<value_type::microseconds_type>());
+            }
+            if (vit != value.end()) {
+                retval.voltage(vit->get<value_type::value_type>());
+            }
+            if (wit != value.end()) {
+                auto waveform = power_overwhelming::convert_string<wchar_t>(
+                    wit->get<std::string>());
+                retval.waveform(parse_synthetic_waveform(waveform.c_str()));
+            }
+
+            return retval;
+        }
+
+        static inline nlohmann::json serialise(const value_type& value) {
+            auto name = power_overwhelming::convert_string<char>(value.name());
+            auto waveform = power_overwhelming::convert_string<char>(
+                to_string(value.waveform()));
+
+            return nlohmann::json::object({
+                { json_field_type, type_name },
+                { json_field_name, name },
+                { json_field_waveform, waveform },
+                { json_field_offset, value.offset() },
+                { json_field_amplitude, value.amplitude() },
+                { json_field_period, value.period() },
+                { json_field_voltage, value.voltage() },
+                { json_field_cost, value.cost() },
+                { json_field_async, value.async() }
+            });
+        }
+    };
+
+    /// <summary>
+    /// Specialisation for <see cref="sysfs_sensor" />.
+    /// </summary>
+    template<> struct sensor_desc<sysfs_sensor> final
+            : detail::sensor_desc_base<sensor_desc<sysfs_sensor>> {
+        POWER_OVERWHELMING_DECLARE_SENSOR_NAME(sysfs_sensor);
+        POWER_OVERWHELMING_DECLARE_INTRINSIC_ASYNC(false);
+
+        static inline value_type deserialise(_In_ const nlohmann::json& value) {
+            auto path = value[json_field_path].get<std::string>();
+            auto quantity0 = value[json_field_quantity].get<std::string>();
+            auto quantity = power_overwhelming::convert_string<wchar_t>(
+                quantity0);
+            auto scale = value.contains(json_field_scale)
+                ? value[json_field_scale].get<double>()
+                : sysfs_sensor::default_scale;
+            return value_type::for_path(path.c_str(),
+                parse_sysfs_sensor_quantity(quantity.c_str()), scale);
+        }
+
+        static inline nlohmann::json serialise(_In_ const value_type& value) {
+            auto name = power_overwhelming::convert_string<char>(value.name());
+            auto quantity = power_overwhelming::convert_string<char>(
+                to_string(value.quantity()));
+
+            return nlohmann::json::object({
+                { json_field_type, type_name },
+                { json_field_name, name },
+                { json_field_path, value.path() },
+                { json_field_quantity, quantity },
+                { json_field_scale, value.scale() }
+            });
+        }
+    };
+
     /// <summary>
     /// Specialisation for <see cref="tinkerforge_sensor" />.
     /// </summary>
@@ -342,6 +701,7 @@ namespace detail {
             : detail::sensor_desc_base<sensor_desc<tinkerforge_sensor>> {
         POWER_OVERWHELMING_DECLARE_SENSOR_NAME(tinkerforge_sensor);
         POWER_OVERWHELMING_DECLARE_INTRINSIC_ASYNC(true);
+        POWER_OVERWHELMING_DECLARE_DISCOVERY_TIMEOUT(2000);
 
         static inline value_type deserialise(const nlohmann::json& value) {
             const auto dit = value.find(json_field_description);
@@ -354,16 +714,32 @@ namespace detail {
             auto port = (pit != value.end())
                 ? pit->get<std::uint16_t>()
                 : value_type::default_port;
+            const auto sit = value.find(json_field_source);
             auto uid = value[json_field_uid].get<std::string>();
 
+            value_type retval;
             if (dit != value.end()) {
                 auto desc0 = dit->get<std::string>();
                 auto desc = power_overwhelming::convert_string<wchar_t>(desc0);
-                return value_type(uid.c_str(), desc.c_str(), host.c_str(),
+                retval = value_type(uid.c_str(), desc.c_str(), host.c_str(),
                     port);
             } else {
-                return value_type(uid.c_str(), host.c_str(), port);
+                retval = value_type(uid.c_str(), host.c_str(), port);
             }
+
+            // The source selects the quantities the collector samples. If it
+            // is missing, the sensor samples its default quantities.
+            if (sit != value.end()) {
+                auto source = power_overwhelming::convert_string<wchar_t>(
+                    sit->get<std::string>());
+                auto quantities = parse_tinkerforge_sensor_source(
+                    source.c_str());
+                if (quantities != tinkerforge_sensor_source::none) {
+                    retval.quantities(quantities);
+                }
+            }
+
+            return retval;
         }
 
         static inline nlohmann::json serialise(const value_type& value) {
@@ -372,11 +748,17 @@ namespace detail {
 
             auto desc = power_overwhelming::convert_string<char>(
                 value.description());
-            auto host = value_type::default_host;
+            // Record the endpoint the sensor is actually connected to, such
+            // that it can be recreated without enumerating all Brick daemons.
+            auto host = (value.host() != nullptr)
+                ? value.host()
+                : value_type::default_host;
             auto name = power_overwhelming::convert_string<char>(value.name());
-            auto port = value_type::default_port;
+            auto port = (value.port() != 0)
+                ? value.port()
+                : value_type::default_port;
             auto source = power_overwhelming::convert_string<char>(to_string(
-                tinkerforge_sensor_source::all));
+                value.quantities()));
 
             return nlohmann::json::object({
                 { json_field_type, type_name },
@@ -392,10 +774,10 @@ namespace detail {
         static inline nlohmann::json serialise_all(void) {
             auto retval = nlohmann::json::array();
 
-            auto host = value_type::default_host;
-            auto port = value_type::default_port;
+            // The configuration documents the quantities sampled by default,
+            // which can then be changed by the user.
             const auto source = power_overwhelming::convert_string<char>(
-                to_string(tinkerforge_sensor_source::all));
+                to_string(tinkerforge_sensor_source::power));
 
             // We do not need to create the sensor to write its properties,
             // the definition and the API for the sensor name suffice.
@@ -407,6 +789,12 @@ namespace detail {
             for (auto& d : descs) {
                 assert(d.uid() != nullptr);
                 _Analysis_assume_(d.uid() != nullptr);
+                const std::string host = (d.host() != nullptr)
+                    ? d.host()
+                    : value_type::default_host;
+                const auto port = (d.port() != 0)
+                    ? d.port()
+                    : value_type::default_port;
                 auto name = tinkerforge_sensor_impl::get_sensor_name(
                     host, port, d.uid());
 
@@ -426,6 +814,7 @@ namespace detail {
 
 #undef POWER_OVERWHELMING_DECLARE_SENSOR_NAME
 #undef POWER_OVERWHELMING_DECLARE_INTRINSIC_ASYNC
+#undef POWER_OVERWHELMING_DECLARE_DISCOVERY_TIMEOUT
 
     
     /// <summary>
@@ -434,16 +823,25 @@ namespace detail {
     /// </summary>
     /// <remarks>
     /// Implementors of new sensors should register their class here in order to
-    /// make it eligible for automated enumeration and instantiation.
+    /// make it eligible for automated enumeration and instantiation. The
+    /// <see cref="compiled_config::version" /> must be increased whenever
+    /// this list changes.
     /// </remarks>
     typedef sensor_list_type<
         adl_sensor,
+        amdgpu_sensor,
         emi_sensor,
         hmc8015_sensor,
+        level_zero_sensor,
         msr_sensor,
         nvml_sensor,
+        perf_rapl_sensor,
         rtx_sensor,
-        tinkerforge_sensor>
+        sysfs_sensor,
+        tinkerforge_sensor,
+        synthetic_sensor,
+        replay_sensor,
+        dcgm_sensor>
         sensor_list;
 
 } /* namespace detail */
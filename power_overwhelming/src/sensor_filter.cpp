@@ -0,0 +1,114 @@
+﻿// <copyright file="sensor_filter.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/sensor_filter.h"
+
+#include <memory>
+
+#include "power_overwhelming/regex_escape.h"
+
+#include "string_functions.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Assigns <paramref name="pattern" /> to <paramref name="dst" />,
+    /// escaping it before if <paramref name="literal" /> is set.
+    /// </summary>
+    static void assign_pattern(_Inout_opt_z_ wchar_t *& dst,
+            _In_opt_z_ const wchar_t *pattern,
+            _In_ const bool literal) {
+        if (literal && (pattern != nullptr)) {
+            safe_assign(dst, regex_escape(std::wstring(pattern)));
+        } else {
+            safe_assign(dst, pattern);
+        }
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::sensor_filter::sensor_filter
+ */
+visus::power_overwhelming::sensor_filter::sensor_filter(void) noexcept
+    : _device(nullptr), _name(nullptr), _type(nullptr) { }
+
+
+/*
+ * visus::power_overwhelming::sensor_filter::sensor_filter
+ */
+visus::power_overwhelming::sensor_filter::sensor_filter(
+        _In_ const sensor_filter& rhs)
+        : _device(nullptr), _name(nullptr), _type(nullptr) {
+    *this = rhs;
+}
+
+
+/*
+ * visus::power_overwhelming::sensor_filter::~sensor_filter
+ */
+visus::power_overwhelming::sensor_filter::~sensor_filter(void) {
+    detail::safe_assign(this->_device, nullptr);
+    detail::safe_assign(this->_name, nullptr);
+    detail::safe_assign(this->_type, nullptr);
+}
+
+
+/*
+ * visus::power_overwhelming::sensor_filter::device
+ */
+visus::power_overwhelming::sensor_filter&
+visus::power_overwhelming::sensor_filter::device(
+        _In_opt_z_ const wchar_t *pattern,
+        _In_ const bool literal) {
+    detail::assign_pattern(this->_device, pattern, literal);
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::sensor_filter::name
+ */
+visus::power_overwhelming::sensor_filter&
+visus::power_overwhelming::sensor_filter::name(
+        _In_opt_z_ const wchar_t *pattern,
+        _In_ const bool literal) {
+    detail::assign_pattern(this->_name, pattern, literal);
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::sensor_filter::type
+ */
+visus::power_overwhelming::sensor_filter&
+visus::power_overwhelming::sensor_filter::type(
+        _In_opt_z_ const wchar_t *pattern,
+        _In_ const bool literal) {
+    detail::assign_pattern(this->_type, pattern, literal);
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::sensor_filter::operator =
+ */
+visus::power_overwhelming::sensor_filter&
+visus::power_overwhelming::sensor_filter::operator =(
+        _In_ const sensor_filter& rhs) {
+    if (this != std::addressof(rhs)) {
+        detail::safe_assign(this->_device, rhs._device);
+        detail::safe_assign(this->_name, rhs._name);
+        detail::safe_assign(this->_type, rhs._type);
+    }
+
+    return *this;
+}
@@ -0,0 +1,200 @@
+﻿// <copyright file="sensor_group.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cinttypes>
+#include <stdexcept>
+
+#include "power_overwhelming/measurement_batch.h"
+
+#include "sampler_scheduler.h"
+#include "sensor_name_registry.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Samples a fixed set of sensors of the same type in a single loop and
+    /// delivers the readings of each tick as one batch.
+    /// </summary>
+    /// <remarks>
+    /// <para>In contrast to the <see cref="sampler" />, the group does not
+    /// look up its sensors in a map and it does not invoke a callback per
+    /// sensor. The sensor implementations are kept in a fixed-size array and
+    /// their <c>sample</c> method is called directly, such that the compiler
+    /// can inline the reads of large homogeneous sets like the cores of a
+    /// CPU. The readings are written into a <see cref="measurement_batch" />
+    /// that has been allocated for <typeparamref name="N" /> samples, in
+    /// which the sample at index <c>i</c> belongs to the <c>i</c>-th sensor
+    /// of the group.</para>
+    /// <para>The sensors can only be changed while the group is not running.
+    /// Like for the <see cref="sampler" />, the sensor implementations must
+    /// outlive the group or be removed from it.</para>
+    /// </remarks>
+    /// <typeparam name="TSensorImpl">The type of the sensor implementation,
+    /// which must expose a synchronous <c>sample</c> method returning a
+    /// <see cref="measurement_data" />.</typeparam>
+    /// <typeparam name="N">The maximum number of sensors in the group.
+    /// </typeparam>
+    template<class TSensorImpl, std::size_t N> class sensor_group final {
+
+    public:
+
+        /// <summary>
+        /// The callback receiving the readings of a tick.
+        /// </summary>
+        /// <remarks>
+        /// The names are interned and ordered like the samples in the batch.
+        /// The batch is only valid during the call.
+        /// </remarks>
+        typedef void (*callback_type)(
+            _In_ const wchar_t *const *sensors,
+            _In_ const measurement_batch& batch,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// The type to express sampling intervals.
+        /// </summary>
+        typedef sampler_scheduler::interval_type interval_type;
+
+        /// <summary>
+        /// The type of the sensor implementation sampled by the group.
+        /// </summary>
+        typedef TSensorImpl *sensor_type;
+
+        /// <summary>
+        /// The maximum number of sensors in the group.
+        /// </summary>
+        static constexpr std::size_t capacity = N;
+
+        static_assert(N > 0, "A sensor group must be able to hold at least "
+            "one sensor.");
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <exception cref="std::bad_alloc">If the batch could not be
+        /// allocated.</exception>
+        sensor_group(void);
+
+        sensor_group(const sensor_group&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~sensor_group(void);
+
+        /// <summary>
+        /// Adds a sensor to the group.
+        /// </summary>
+        /// <param name="sensor">The sensor implementation to be sampled.
+        /// </param>
+        /// <param name="name">The name of the sensor.</param>
+        /// <returns><c>true</c> if the sensor has been added, <c>false</c> if
+        /// it is already in the group or if the group is full.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="sensor" /> or <paramref name="name" /> is
+        /// <c>nullptr</c>.</exception>
+        /// <exception cref="std::logic_error">If the group is running.
+        /// </exception>
+        bool add(_In_ const sensor_type sensor, _In_z_ const wchar_t *name);
+
+        /// <summary>
+        /// Removes a sensor from the group.
+        /// </summary>
+        /// <remarks>
+        /// The order of the remaining sensors is preserved.
+        /// </remarks>
+        /// <param name="sensor">The sensor implementation to be removed.
+        /// </param>
+        /// <returns><c>true</c> if the sensor has been removed, <c>false</c>
+        /// if it was not in the group.</returns>
+        /// <exception cref="std::logic_error">If the group is running.
+        /// </exception>
+        bool remove(_In_ const sensor_type sensor);
+
+        /// <summary>
+        /// Answer whether the group is being sampled periodically.
+        /// </summary>
+        /// <returns><c>true</c> if the group is running, <c>false</c>
+        /// otherwise.</returns>
+        inline bool running(void) const noexcept {
+            return (this->_callback != nullptr);
+        }
+
+        /// <summary>
+        /// Reads all sensors once and delivers the batch to the given
+        /// callback.
+        /// </summary>
+        /// <param name="callback">The callback receiving the readings.
+        /// </param>
+        /// <param name="context">A user-defined pointer passed to the
+        /// <paramref name="callback" />.</param>
+        void sample(_In_ const callback_type callback,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Answer the number of sensors in the group.
+        /// </summary>
+        /// <returns>The number of sensors.</returns>
+        inline std::size_t size(void) const noexcept {
+            return this->_size;
+        }
+
+        /// <summary>
+        /// Starts sampling the group periodically on the
+        /// <see cref="sampler_scheduler" />.
+        /// </summary>
+        /// <param name="interval">The interval between two reads of the
+        /// sensors.</param>
+        /// <param name="callback">The callback receiving the readings.
+        /// </param>
+        /// <param name="context">A user-defined pointer passed to the
+        /// <paramref name="callback" />.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="callback" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::logic_error">If the group is already
+        /// running.</exception>
+        void start(_In_ const interval_type interval,
+            _In_ const callback_type callback,
+            _In_opt_ void *context = nullptr);
+
+        /// <summary>
+        /// Stops sampling the group and waits for a tick in progress.
+        /// </summary>
+        /// <remarks>
+        /// It is safe to stop a group that is not running.
+        /// </remarks>
+        void stop(void);
+
+        sensor_group& operator =(const sensor_group&) = delete;
+
+    private:
+
+        /// <summary>
+        /// The callback of the <see cref="_task" />.
+        /// </summary>
+        static bool tick(_In_ void *context);
+
+        measurement_batch _batch;
+        callback_type _callback;
+        void *_context;
+        std::array<const wchar_t *, N> _names;
+        std::array<sensor_type, N> _sensors;
+        std::size_t _size;
+        sampler_scheduler::task _task;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+#include "sensor_group.inl"
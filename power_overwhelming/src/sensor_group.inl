@@ -0,0 +1,174 @@
+﻿// <copyright file="sensor_group.inl" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+
+/*
+ * visus::power_overwhelming::detail::sensor_group<TSensorImpl, N>::capacity
+ */
+template<class TSensorImpl, std::size_t N>
+constexpr std::size_t
+visus::power_overwhelming::detail::sensor_group<TSensorImpl, N>::capacity;
+
+
+/*
+ * ...::detail::sensor_group<TSensorImpl, N>::sensor_group
+ */
+template<class TSensorImpl, std::size_t N>
+visus::power_overwhelming::detail::sensor_group<TSensorImpl, N>::sensor_group(
+        void)
+        : _batch(N), _callback(nullptr), _context(nullptr), _size(0),
+        _task(&sensor_group::tick, this) {
+    this->_names.fill(nullptr);
+    this->_sensors.fill(nullptr);
+}
+
+
+/*
+ * ...::detail::sensor_group<TSensorImpl, N>::~sensor_group
+ */
+template<class TSensorImpl, std::size_t N>
+visus::power_overwhelming::detail::sensor_group<TSensorImpl, N>::~sensor_group(
+        void) {
+    this->stop();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sensor_group<TSensorImpl, N>::add
+ */
+template<class TSensorImpl, std::size_t N>
+bool visus::power_overwhelming::detail::sensor_group<TSensorImpl, N>::add(
+        _In_ const sensor_type sensor, _In_z_ const wchar_t *name) {
+    if (sensor == nullptr) {
+        throw std::invalid_argument("The sensor to be added to a group must "
+            "not be null.");
+    }
+    if (name == nullptr) {
+        throw std::invalid_argument("The name of a sensor in a group must not "
+            "be null.");
+    }
+    if (this->running()) {
+        throw std::logic_error("The sensors of a group cannot be changed "
+            "while it is running.");
+    }
+
+    const auto end = this->_sensors.begin() + this->_size;
+    if ((this->_size == N) || (std::find(this->_sensors.begin(), end, sensor)
+            != end)) {
+        return false;
+    }
+
+    this->_names[this->_size] = sensor_name_registry::intern(name);
+    this->_sensors[this->_size] = sensor;
+    ++this->_size;
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sensor_group<TSensorImpl, N>::remove
+ */
+template<class TSensorImpl, std::size_t N>
+bool visus::power_overwhelming::detail::sensor_group<TSensorImpl, N>::remove(
+        _In_ const sensor_type sensor) {
+    if (this->running()) {
+        throw std::logic_error("The sensors of a group cannot be changed "
+            "while it is running.");
+    }
+
+    const auto end = this->_sensors.begin() + this->_size;
+    const auto it = std::find(this->_sensors.begin(), end, sensor);
+    if (it == end) {
+        return false;
+    }
+
+    // Keep the order such that the indices in the batch remain stable for
+    // all sensors before the removed one.
+    const auto i = static_cast<std::size_t>(it - this->_sensors.begin());
+    std::move(it + 1, end, it);
+    std::move(this->_names.begin() + i + 1,
+        this->_names.begin() + this->_size,
+        this->_names.begin() + i);
+    --this->_size;
+    this->_names[this->_size] = nullptr;
+    this->_sensors[this->_size] = nullptr;
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sensor_group<TSensorImpl, N>::sample
+ */
+template<class TSensorImpl, std::size_t N>
+void visus::power_overwhelming::detail::sensor_group<TSensorImpl, N>::sample(
+        _In_ const callback_type callback, _In_opt_ void *context) {
+    assert(callback != nullptr);
+    assert(this->_batch.capacity() >= N);
+
+    // The batch has been allocated for all sensors, so filling it never
+    // allocates, and the calls to the sensors are not virtual.
+    this->_batch.clear();
+    for (std::size_t i = 0; i < this->_size; ++i) {
+        this->_batch.push_back(this->_sensors[i]->sample());
+    }
+
+    callback(this->_names.data(), this->_batch, context);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sensor_group<TSensorImpl, N>::start
+ */
+template<class TSensorImpl, std::size_t N>
+void visus::power_overwhelming::detail::sensor_group<TSensorImpl, N>::start(
+        _In_ const interval_type interval,
+        _In_ const callback_type callback,
+        _In_opt_ void *context) {
+    if (callback == nullptr) {
+        throw std::invalid_argument("The callback of a sensor group must not "
+            "be null.");
+    }
+    if (this->running()) {
+        throw std::logic_error("The sensor group is already running.");
+    }
+
+    this->_callback = callback;
+    this->_context = context;
+    sampler_scheduler::instance().schedule(this->_task, interval);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sensor_group<TSensorImpl, N>::stop
+ */
+template<class TSensorImpl, std::size_t N>
+void visus::power_overwhelming::detail::sensor_group<TSensorImpl, N>::stop(
+        void) {
+    if (this->running()) {
+        sampler_scheduler::instance().cancel(this->_task);
+        this->_callback = nullptr;
+        this->_context = nullptr;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sensor_group<TSensorImpl, N>::tick
+ */
+template<class TSensorImpl, std::size_t N>
+bool visus::power_overwhelming::detail::sensor_group<TSensorImpl, N>::tick(
+        _In_ void *context) {
+    assert(context != nullptr);
+    auto that = static_cast<sensor_group *>(context);
+
+    try {
+        that->sample(that->_callback, that->_context);
+    } catch (...) {
+        // A failed read only loses the batch of this tick, because there is
+        // no one to report the error to.
+    }
+
+    return true;
+}
@@ -0,0 +1,77 @@
+﻿// <copyright file="sensor_name_registry.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "sensor_name_registry.h"
+
+#include <mutex>
+#include <stdexcept>
+
+
+/*
+ * visus::power_overwhelming::detail::sensor_name_registry::intern
+ */
+_Ret_z_ const visus::power_overwhelming::detail::sensor_name_registry::char_type *
+visus::power_overwhelming::detail::sensor_name_registry::intern(
+        _In_z_ const char_type *name) {
+    if (name == nullptr) {
+        throw std::invalid_argument("A valid sensor name must be specified.");
+    }
+
+    auto& registry = instance();
+
+    {
+        // Fast path: the name is already known. This is the case for all but
+        // the very first sample of a sensor, so we only need a shared lock.
+        std::shared_lock<decltype(registry._lock)> l(registry._lock);
+        auto it = registry._index.find(name);
+        if (it != registry._index.end()) {
+            return *it;
+        }
+    }
+
+    std::unique_lock<decltype(registry._lock)> l(registry._lock);
+    // Someone else might have added the name while we were not holding the
+    // lock, so we need to check again.
+    auto it = registry._index.find(name);
+    if (it != registry._index.end()) {
+        return *it;
+    }
+
+    // Note: the STL guarantees that references to elements of a deque are not
+    // invalidated if elements are added at the end.
+    registry._names.emplace_back(name);
+    auto retval = registry._names.back().c_str();
+    registry._index.insert(retval);
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sensor_name_registry::hash::operator ()
+ */
+std::size_t
+visus::power_overwhelming::detail::sensor_name_registry::hash::operator ()(
+        _In_z_ const char_type *str) const noexcept {
+    // FNV-1a, which is sufficient for the short names of sensors.
+    std::size_t retval = static_cast<std::size_t>(14695981039346656037ULL);
+
+    for (; *str != 0; ++str) {
+        retval ^= static_cast<std::size_t>(*str);
+        retval *= static_cast<std::size_t>(1099511628211ULL);
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sensor_name_registry::instance
+ */
+visus::power_overwhelming::detail::sensor_name_registry&
+visus::power_overwhelming::detail::sensor_name_registry::instance(void) {
+    static sensor_name_registry retval;
+    return retval;
+}
@@ -0,0 +1,93 @@
+﻿// <copyright file="sensor_name_registry.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cwchar>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <unordered_set>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A process-wide registry of interned sensor names.
+    /// </summary>
+    /// <remarks>
+    /// <para>Interning a name returns a pointer to an immutable copy of the
+    /// name that is shared by everyone who interns an equal string. The
+    /// interned strings live until the process exits, wherefore the pointers
+    /// can be freely copied without any reference counting. This enables
+    /// <see cref="measurement" /> to store the name of its sensor without
+    /// allocating a copy for each sample.</para>
+    /// <para>The registry is not intended to store arbitrary strings, because
+    /// it never releases any memory. The number of sensor names in a process
+    /// is, however, limited by the hardware installed in the machine.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API sensor_name_registry final {
+
+    public:
+
+        /// <summary>
+        /// The type of characters used for sensor names.
+        /// </summary>
+        typedef wchar_t char_type;
+
+        /// <summary>
+        /// Gets the interned copy of the given sensor name.
+        /// </summary>
+        /// <remarks>
+        /// <para>This method is thread-safe. If the name has already been
+        /// interned, the method does not allocate any memory.</para>
+        /// </remarks>
+        /// <param name="name">The name of the sensor, which must not be
+        /// <c>nullptr</c>.</param>
+        /// <returns>A pointer to the interned name, which remains valid until
+        /// the process exits.</returns>
+        /// <exception cref="std::invalid_argument">If <paramref name="name" />
+        /// is <c>nullptr</c>.</exception>
+        static _Ret_z_ const char_type *intern(_In_z_ const char_type *name);
+
+    private:
+
+        /// <summary>
+        /// Compares the strings designated by two pointers.
+        /// </summary>
+        struct equal_to {
+            inline bool operator ()(_In_z_ const char_type *lhs,
+                    _In_z_ const char_type *rhs) const noexcept {
+                return (::wcscmp(lhs, rhs) == 0);
+            }
+        };
+
+        /// <summary>
+        /// Computes a hash of the string designated by a pointer.
+        /// </summary>
+        struct hash {
+            std::size_t operator ()(
+                _In_z_ const char_type *str) const noexcept;
+        };
+
+        /// <summary>
+        /// Gets the only instance of the registry.
+        /// </summary>
+        static sensor_name_registry& instance(void);
+
+        sensor_name_registry(void) = default;
+
+        std::unordered_set<const char_type *, hash, equal_to> _index;
+        std::shared_timed_mutex _lock;
+        std::deque<std::basic_string<char_type>> _names;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,87 @@
+﻿// <copyright file="sensor_stream.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/sensor_stream.h"
+
+#include <memory>
+#include <stdexcept>
+
+#include "collector_subscriber_impl.h"
+#include "sensor_stream_impl.h"
+
+
+/*
+ * visus::power_overwhelming::sensor_stream::default_capacity
+ */
+constexpr std::size_t
+visus::power_overwhelming::sensor_stream::default_capacity;
+
+
+/*
+ * visus::power_overwhelming::sensor_stream::sensor_stream
+ */
+visus::power_overwhelming::sensor_stream::sensor_stream(
+        _In_ sensor& source,
+        _In_ const sensor::microseconds_type period,
+        _In_ const std::size_t capacity) : _impl(nullptr) {
+    if (capacity == 0) {
+        throw std::invalid_argument("The capacity of a sensor stream must be "
+            "positive.");
+    }
+
+    std::unique_ptr<detail::sensor_stream_impl> impl(
+        new detail::sensor_stream_impl(source, capacity));
+    source.sample_batch(detail::sensor_stream_impl::on_batch, period,
+        impl.get());
+    this->_impl = impl.release();
+}
+
+
+/*
+ * visus::power_overwhelming::sensor_stream::~sensor_stream
+ */
+visus::power_overwhelming::sensor_stream::~sensor_stream(void) {
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::sensor_stream::subscribe
+ */
+visus::power_overwhelming::collector_subscriber
+visus::power_overwhelming::sensor_stream::subscribe(
+        _In_ const subscriber_overflow overflow) {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("A sensor stream which has been disposed by "
+            "a move operation cannot be subscribed to.");
+    }
+
+    return collector_subscriber(new detail::collector_subscriber_impl(
+        this->_impl->ring, overflow));
+}
+
+
+/*
+ * visus::power_overwhelming::sensor_stream::operator =
+ */
+visus::power_overwhelming::sensor_stream&
+visus::power_overwhelming::sensor_stream::operator =(
+        _Inout_ sensor_stream&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::sensor_stream::operator bool
+ */
+visus::power_overwhelming::sensor_stream::operator bool(void) const noexcept {
+    return (this->_impl != nullptr);
+}
@@ -0,0 +1,53 @@
+﻿// <copyright file="sensor_stream_impl.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "sensor_stream_impl.h"
+
+#include <cassert>
+
+#include "power_overwhelming/measurement.h"
+
+
+/*
+ * visus::power_overwhelming::detail::sensor_stream_impl::on_batch
+ */
+void visus::power_overwhelming::detail::sensor_stream_impl::on_batch(
+        _In_z_ const wchar_t *sensor,
+        _In_reads_(cnt) const measurement_data *samples,
+        _In_ const std::size_t cnt,
+        _In_opt_ void *context) {
+    assert(context != nullptr);
+    auto that = static_cast<sensor_stream_impl *>(context);
+
+    std::lock_guard<decltype(that->lock)> l(that->lock);
+    if (that->ring->subscribed()) {
+        for (std::size_t i = 0; i < cnt; ++i) {
+            that->ring->push(measurement(sensor, samples[i]));
+        }
+        that->ring->commit();
+    }
+}
+
+
+/*
+ * ...::detail::sensor_stream_impl::sensor_stream_impl
+ */
+visus::power_overwhelming::detail::sensor_stream_impl::sensor_stream_impl(
+        _In_ sensor& source, _In_ const std::size_t capacity)
+    : ring(std::make_shared<subscriber_ring>(capacity)), source(&source) { }
+
+
+/*
+ * ...::detail::sensor_stream_impl::~sensor_stream_impl
+ */
+visus::power_overwhelming::detail::sensor_stream_impl::~sensor_stream_impl(
+        void) {
+    try {
+        this->source->sample_batch(nullptr, 0, this);
+    } catch (...) { /* We must close the ring anyway. */ }
+
+    // Release subscribers waiting for samples that will never arrive.
+    this->ring->close();
+}
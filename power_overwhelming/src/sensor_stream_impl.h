@@ -0,0 +1,68 @@
+﻿// <copyright file="sensor_stream_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+
+#include "power_overwhelming/sensor.h"
+
+#include "subscriber_ring.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The implementation of a <see cref="sensor_stream" />.
+    /// </summary>
+    struct sensor_stream_impl final {
+
+        /// <summary>
+        /// Copies the samples delivered by the sensor into the
+        /// <see cref="ring" />.
+        /// </summary>
+        static void on_batch(_In_z_ const wchar_t *sensor,
+            _In_reads_(cnt) const measurement_data *samples,
+            _In_ const std::size_t cnt,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// Serialises writers of the <see cref="ring" />, which only supports
+        /// a single one, in case the sensor delivers from multiple threads.
+        /// </summary>
+        std::mutex lock;
+
+        /// <summary>
+        /// The ring from which the subscribers read.
+        /// </summary>
+        std::shared_ptr<subscriber_ring> ring;
+
+        /// <summary>
+        /// The sensor being sampled.
+        /// </summary>
+        sensor *source;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        sensor_stream_impl(_In_ sensor& source,
+            _In_ const std::size_t capacity);
+
+        sensor_stream_impl(const sensor_stream_impl&) = delete;
+
+        /// <summary>
+        /// Stops sampling and closes the ring.
+        /// </summary>
+        ~sensor_stream_impl(void);
+
+        sensor_stream_impl& operator =(const sensor_stream_impl&) = delete;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -5,12 +5,23 @@
 
 #include "sensor_utilities.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <exception>
 #include <fstream>
+#include <future>
+#include <map>
+#include <memory>
+#include <regex>
+#include <sstream>
+#include <thread>
 #include <type_traits>
 
 #include "power_overwhelming/convert_string.h"
 
+#include "library_thread.h"
 #include "sensor_desc.h"
 
 
@@ -44,46 +55,352 @@ namespace detail {
         }
     }
 
+    /// <summary>
+    /// Runs <paramref name="discover" /> on a new thread and returns a future
+    /// for its result.
+    /// </summary>
+    /// <remarks>
+    /// <para>In contrast to <c>std::async</c>, the future returned does not
+    /// block in its destructor, so the caller can abandon a discovery that
+    /// takes too long. The thread runs to completion in the background and
+    /// the result is discarded in this case.</para>
+    /// </remarks>
+    template<class TResult, class TDiscover>
+    std::future<TResult> discover_async(TDiscover discover) {
+        auto promise = std::make_shared<std::promise<TResult>>();
+        auto retval = promise->get_future();
+
+        std::thread([promise, discover](void) {
+            enter_library_thread("PwrOwg Discovery Thread");
+
+            try {
+                promise->set_value(discover());
+            } catch (...) {
+                promise->set_exception(std::current_exception());
+            }
+        }).detach();
+
+        return retval;
+    }
+
+    /// <summary>
+    /// Discovers all sensors of the given types concurrently and passes the
+    /// results that have been obtained within the time budget of the
+    /// respective sensor type to <paramref name="merge" /> in the order of
+    /// the type list.
+    /// </summary>
+    /// <remarks>
+    /// <para>Any sensor type that fails or exceeds the budget returned by
+    /// <c>sensor_desc::discovery_timeout</c> is ignored.</para>
+    /// <para>If <paramref name="cancelled" /> becomes <c>true</c>, the
+    /// remaining types are abandoned like the ones exceeding their budget.
+    /// </para>
+    /// </remarks>
+    template<class TResult, class TMerge, class... TSensors>
+    void discover_all(sensor_list_type<TSensors ...>,
+            TResult (*discover[sizeof...(TSensors)])(void),
+            TMerge merge,
+            const bool *enabled = nullptr,
+            const std::atomic<bool> *cancelled = nullptr) {
+        typedef std::chrono::steady_clock clock_type;
+        const auto start = clock_type::now();
+        const std::chrono::milliseconds timeouts[] = {
+            sensor_desc<TSensors>::discovery_timeout()...
+        };
+
+        std::vector<std::future<TResult>> futures;
+        futures.reserve(sizeof...(TSensors));
+        for (std::size_t i = 0; i < sizeof...(TSensors); ++i) {
+            if ((enabled == nullptr) || enabled[i]) {
+                futures.push_back(discover_async<TResult>(discover[i]));
+            } else {
+                // Keep the indices aligned with the type list.
+                futures.emplace_back();
+            }
+        }
+
+        // Merge in the order of the type list, which makes the result
+        // independent of which backend finishes first.
+        for (std::size_t i = 0; i < futures.size(); ++i) {
+            if (!futures[i].valid()) {
+                continue;
+            }
+
+            const auto deadline = start + timeouts[i];
+            auto status = std::future_status::timeout;
+
+            // Wake up regularly to check for cancellation if requested.
+            do {
+                if ((cancelled != nullptr) && cancelled->load()) {
+                    return;
+                }
+
+                const auto until = (cancelled != nullptr)
+                    ? (std::min)(deadline, clock_type::now()
+                        + std::chrono::milliseconds(10))
+                    : deadline;
+                status = futures[i].wait_until(until);
+            } while ((status != std::future_status::ready)
+                && (clock_type::now() < deadline));
+
+            if (status == std::future_status::ready) {
+                // Only failures of the discovery are ignored, whereas errors
+                // in the merge step, eg while writing the results, are not.
+                TResult result;
+                try {
+                    result = futures[i].get();
+                } catch (...) {
+                    /* Ignore any failing sensor. */
+                    continue;
+                }
+
+                merge(std::move(result));
+            }
+        }
+    }
+
+    /// <summary>
+    /// Gets the descriptors of all sensors of type
+    /// <typeparamref name="TSensor" />.
+    /// </summary>
+    template<class TSensor> nlohmann::json get_descs_of(void) {
+        auto retval = nlohmann::json::array();
+        add_descs_of<TSensor>(retval);
+        return retval;
+    }
+
     /// <summary>
     /// Add descriptors for all sensors of the specified types to the given
     /// list of sensors.
     /// </summary>
-    template<class TSensor, class... TSensors>
-    void add_descs(nlohmann::json& dst,
-            sensor_list_type<TSensor, TSensors ...>) {
-        add_descs(dst, sensor_list_type<TSensor>());
-        add_descs(dst, sensor_list_type<TSensors ...>());
+    template<class... TSensors>
+    void add_descs(nlohmann::json& dst, sensor_list_type<TSensors ...> list) {
+        nlohmann::json (*discover[])(void) = { get_descs_of<TSensors>... };
+        discover_all<nlohmann::json>(list, discover,
+                [&dst](nlohmann::json&& descs) {
+            dst.insert(dst.end(), descs.begin(), descs.end());
+        });
     }
 
     /// <summary>
-    /// Recursion stop for <see cref="add_descs" />.
+    /// The compiled regular expressions of a <see cref="sensor_filter" />.
+    /// </summary>
+    class sensor_filter_regex final {
+
+    public:
+
+        explicit sensor_filter_regex(const sensor_filter& filter)
+            : _device(compile(filter.device())),
+            _name(compile(filter.name())),
+            _type(compile(filter.type())) { }
+
+        /// <summary>
+        /// Answer whether the given descriptor matches the name and device
+        /// criteria.
+        /// </summary>
+        bool matches(const nlohmann::json& desc) const {
+            if (this->_name) {
+                auto it = desc.find(json_field_name);
+                if ((it == desc.end()) || !it->is_string()
+                        || !std::regex_match(it->get<std::string>(),
+                        *this->_name)) {
+                    return false;
+                }
+            }
+
+            if (this->_device) {
+                if (!std::regex_match(get_device(desc), *this->_device)) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        /// <summary>
+        /// Answer whether the filter has any criterion that can only be
+        /// evaluated on the descriptor of a sensor.
+        /// </summary>
+        bool filters_descs(void) const noexcept {
+            return (this->_device || this->_name);
+        }
+
+        /// <summary>
+        /// Answer whether the given sensor type matches the type criterion.
+        /// </summary>
+        bool matches_type(const char *type) const {
+            assert(type != nullptr);
+            return !this->_type || std::regex_match(type, *this->_type);
+        }
+
+    private:
+
+        static std::unique_ptr<std::regex> compile(const wchar_t *pattern) {
+            return (pattern != nullptr)
+                ? std::unique_ptr<std::regex>(new std::regex(
+                    power_overwhelming::convert_string<char>(pattern)))
+                : nullptr;
+        }
+
+        /// <summary>
+        /// Gets the property identifying the device of the sensor, which
+        /// depends on the type of the sensor.
+        /// </summary>
+        static std::string get_device(const nlohmann::json& desc) {
+            static const char *const fields[] = {
+                json_field_path,
+                json_field_udid,
+                json_field_dev_guid,
+                json_field_uid,
+                json_field_core
+            };
+
+            for (auto f : fields) {
+                auto it = desc.find(f);
+                if (it != desc.end()) {
+                    return it->is_string()
+                        ? it->get<std::string>()
+                        : it->dump();
+                }
+            }
+
+            return std::string();
+        }
+
+        std::unique_ptr<std::regex> _device;
+        std::unique_ptr<std::regex> _name;
+        std::unique_ptr<std::regex> _type;
+    };
+
+    /// <summary>
+    /// Writes the descriptors of all sensors of the specified types that are
+    /// accepted by the given filter to the given stream.
+    /// </summary>
+    template<class... TSensors>
+    std::size_t write_descs(std::ostream& dst, const sensor_filter& filter,
+            const std::size_t indent, sensor_list_type<TSensors ...> list) {
+        const sensor_filter_regex regex(filter);
+        const std::string outer(indent, ' ');
+        const std::string inner(indent + 4, ' ');
+        std::size_t retval = 0;
+
+        nlohmann::json (*discover[])(void) = { get_descs_of<TSensors>... };
+        const bool enabled[] = {
+            regex.matches_type(sensor_desc<TSensors>::type_name)...
+        };
+
+        dst << "[";
+        discover_all<nlohmann::json>(list, discover,
+                [&](nlohmann::json&& descs) {
+            for (auto& d : descs) {
+                if (!regex.matches(d)) {
+                    continue;
+                }
+
+                dst << ((retval++ > 0) ? ",\n" : "\n");
+
+                // Indent all lines of the nested object.
+                std::istringstream lines(d.dump(4));
+                std::string line;
+                for (auto first = true; std::getline(lines, line);) {
+                    if (!first) {
+                        dst << "\n";
+                    }
+                    dst << inner << line;
+                    first = false;
+                }
+            }
+
+            dst.flush();
+        }, enabled);
+
+        if (retval > 0) {
+            dst << "\n" << outer;
+        }
+        dst << "]";
+
+        return retval;
+    }
+
+    /// <summary>
+    /// Gets all sensors of type <typeparamref name="TSensor" /> as
+    /// polymorphic sensors.
     /// </summary>
     template<class TSensor>
-    inline void add_descs(nlohmann::json& dst, sensor_list_type<TSensor>) {
-        try {
-            add_descs_of<TSensor>(dst);
-        } catch (...) { /* Ignore any failing sensor. */ }
+    std::vector<std::unique_ptr<sensor>> get_sensors_of(void) {
+        std::vector<std::unique_ptr<sensor>> retval;
+        move_sensors(retval, get_all_sensors_of<TSensor>());
+        return retval;
     }
 
     /// <summary>
     /// Add all sensors of the specified types to the given list of sensors.
     /// </summary>
-    template<class TSensor, class... TSensors>
+    template<class... TSensors>
     void add_sensors(std::vector<std::unique_ptr<sensor>>& dst,
+            sensor_list_type<TSensors ...> list) {
+        typedef std::vector<std::unique_ptr<sensor>> result_type;
+        result_type (*discover[])(void) = { get_sensors_of<TSensors>... };
+        discover_all<result_type>(list, discover,
+                [&dst](result_type&& sensors) {
+            dst.reserve(dst.size() + sensors.size());
+            for (auto& s : sensors) {
+                dst.push_back(std::move(s));
+            }
+        });
+    }
+
+
+    /// <summary>
+    /// Serialises the descriptor of <paramref name="sensor" /> using the
+    /// first type in the list that it is an instance of.
+    /// </summary>
+    template<class TSensor, class... TSensors>
+    nlohmann::json describe_sensor(const sensor& sensor,
             sensor_list_type<TSensor, TSensors ...>) {
-        add_sensors(dst, sensor_list_type<TSensor>());
-        add_sensors(dst, sensor_list_type<TSensors ...>());
+        if (auto s = dynamic_cast<const TSensor *>(&sensor)) {
+            return sensor_desc<TSensor>::serialise(*s);
+        } else {
+            return describe_sensor(sensor, sensor_list_type<TSensors ...>());
+        }
     }
 
     /// <summary>
-    /// Recursion stop for <see cref="add_sensors" />.
+    /// Recursion stop for <see cref="describe_sensor" />.
     /// </summary>
-    template<class TSensor>
-    inline void add_sensors(std::vector<std::unique_ptr<sensor>>& dst,
-            sensor_list_type<TSensor>) {
-        try {
-            move_sensors(dst, get_all_sensors_of<TSensor>());
-        } catch (...) { /* Ignore any failing sensor. */ }
+    inline nlohmann::json describe_sensor(const sensor& sensor,
+            sensor_list_type<>) {
+        return nlohmann::json::object();
+    }
+
+
+    /// <summary>
+    /// Add all sensors of the specified types that are accepted by the given
+    /// filter to the given list of sensors.
+    /// </summary>
+    template<class... TSensors>
+    void add_sensors(std::vector<std::unique_ptr<sensor>>& dst,
+            const sensor_filter& filter,
+            const std::atomic<bool> *cancelled,
+            sensor_list_type<TSensors ...> list) {
+        typedef std::vector<std::unique_ptr<sensor>> result_type;
+        const sensor_filter_regex regex(filter);
+        result_type (*discover[])(void) = { get_sensors_of<TSensors>... };
+        const bool enabled[] = {
+            regex.matches_type(sensor_desc<TSensors>::type_name)...
+        };
+
+        discover_all<result_type>(list, discover,
+                [&](result_type&& sensors) {
+            dst.reserve(dst.size() + sensors.size());
+            for (auto& s : sensors) {
+                // Only serialise the sensor if the descriptor is required.
+                if (!regex.filters_descs()
+                        || regex.matches(describe_sensor(*s, list))) {
+                    dst.push_back(std::move(s));
+                }
+            }
+        }, enabled, cancelled);
     }
 
 
@@ -112,6 +429,82 @@ namespace detail {
         throw std::invalid_argument("An unknown type of sensor was specified.");
     }
 
+    /// <summary>
+    /// Answer whether the given JSON is a descriptor of any of the sensors in
+    /// the given list without creating the sensor.
+    /// </summary>
+    template<class TSensor, class... TSensors>
+    bool is_known_sensor(const nlohmann::json& desc,
+            sensor_list_type<TSensor, TSensors ...>) {
+        return sensor_desc<TSensor>::describes(desc)
+            || is_known_sensor(desc, sensor_list_type<TSensors ...>());
+    }
+
+    /// <summary>
+    /// Recursion stop for <see cref="is_known_sensor" />.
+    /// </summary>
+    inline bool is_known_sensor(const nlohmann::json& desc,
+            sensor_list_type<>) {
+        return false;
+    }
+
+    /// <summary>
+    /// Answer a key for the resource that the sensor described by
+    /// <paramref name="desc" /> is created from.
+    /// </summary>
+    /// <remarks>
+    /// Sensors with the same key are created one after another, because they
+    /// share a connection like the one to a Brick daemon or a VISA session,
+    /// or because their library might not support being initialised
+    /// concurrently. Descriptors without a host or a path are therefore
+    /// grouped by their type.
+    /// </remarks>
+    std::string get_resource_key(const nlohmann::json& desc) {
+        const auto host = desc.find(json_field_host);
+        if ((host != desc.end()) && host->is_string()) {
+            const auto port = desc.find(json_field_port);
+            auto retval = "host:" + host->get<std::string>();
+            if (port != desc.end()) {
+                retval += ":" + port->dump();
+            }
+            return retval;
+        }
+
+        const auto path = desc.find(json_field_path);
+        if ((path != desc.end()) && path->is_string()) {
+            return "path:" + path->get<std::string>();
+        }
+
+        const auto type = desc.find(json_field_type);
+        if ((type != desc.end()) && type->is_string()) {
+            return "type:" + type->get<std::string>();
+        }
+
+        return std::string();
+    }
+
+    /// <summary>
+    /// Answer the name of the first type in the list that
+    /// <paramref name="sensor" /> is an instance of.
+    /// </summary>
+    template<class TSensor, class... TSensors>
+    const char *get_sensor_type(const sensor& sensor,
+            sensor_list_type<TSensor, TSensors ...>) noexcept {
+        if (dynamic_cast<const TSensor *>(&sensor) != nullptr) {
+            return sensor_desc<TSensor>::type_name;
+        } else {
+            return get_sensor_type(sensor, sensor_list_type<TSensors ...>());
+        }
+    }
+
+    /// <summary>
+    /// Recursion stop for <see cref="get_sensor_type" />.
+    /// </summary>
+    inline const char *get_sensor_type(const sensor& sensor,
+            sensor_list_type<>) noexcept {
+        return nullptr;
+    }
+
 } /* namespace detail */
 } /* namespace power_overwhelming */
 } /* namespace visus */
@@ -138,18 +531,192 @@ visus::power_overwhelming::detail::get_all_sensors(void) {
 }
 
 
+/*
+ * visus::power_overwhelming::detail::get_all_sensors
+ */
+std::vector<std::unique_ptr<visus::power_overwhelming::sensor>>
+visus::power_overwhelming::detail::get_all_sensors(
+        const sensor_filter& filter,
+        const std::atomic<bool> *cancelled) {
+    std::vector<std::unique_ptr<sensor>> retval;
+    add_sensors(retval, filter, cancelled, sensor_list());
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::get_sensor_type
+ */
+_Ret_maybenull_z_ const char *visus::power_overwhelming::detail::get_sensor_type(
+        const sensor& sensor) noexcept {
+    return get_sensor_type(sensor, sensor_list());
+}
+
+
+/*
+ * visus::power_overwhelming::detail::has_trailing_timestamps
+ */
+bool visus::power_overwhelming::detail::has_trailing_timestamps(
+        const sensor& sensor) noexcept {
+    try {
+        if (auto s = dynamic_cast<const amdgpu_sensor *>(&sensor)) {
+            return (s->source() == amdgpu_sensor_source::average_power);
+        }
+
+        if (auto s = dynamic_cast<const sysfs_sensor *>(&sensor)) {
+            // hwmon's averaged attributes are marked by their suffix.
+            const std::string path(s->path());
+            const std::string suffix("_average");
+            return (s->quantity() == sysfs_sensor_quantity::power)
+                && (path.size() >= suffix.size())
+                && (path.compare(path.size() - suffix.size(), suffix.size(),
+                    suffix) == 0);
+        }
+    } catch (...) { /* Sensor has been disposed, so it measures nothing. */ }
+
+    return (dynamic_cast<const adl_sensor *>(&sensor) != nullptr)
+        || (dynamic_cast<const hmc8015_sensor *>(&sensor) != nullptr)
+        || (dynamic_cast<const nvml_sensor *>(&sensor) != nullptr)
+        || (dynamic_cast<const tinkerforge_sensor *>(&sensor) != nullptr);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::is_cpu_package_sensor
+ */
+bool visus::power_overwhelming::detail::is_cpu_package_sensor(
+        const sensor& sensor) noexcept {
+    try {
+        if (auto s = dynamic_cast<const msr_sensor *>(&sensor)) {
+            return (s->domain() == rapl_domain::package);
+        }
+
+        if (auto s = dynamic_cast<const perf_rapl_sensor *>(&sensor)) {
+            return (s->domain() == rapl_domain::package);
+        }
+
+        if (dynamic_cast<const emi_sensor *>(&sensor) != nullptr) {
+            const std::wstring suffix(L"_PKG");
+            const std::wstring name = (sensor.name() != nullptr)
+                ? sensor.name()
+                : L"";
+            return (name.size() >= suffix.size()) && (name.compare(
+                name.size() - suffix.size(), suffix.size(), suffix) == 0);
+        }
+    } catch (...) { /* Sensor has been disposed, so it measures nothing. */ }
+
+    return false;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::is_energy_counter_sensor
+ */
+bool visus::power_overwhelming::detail::is_energy_counter_sensor(
+        const sensor& sensor) noexcept {
+    try {
+        if ((dynamic_cast<const msr_sensor *>(&sensor) != nullptr)
+                || (dynamic_cast<const perf_rapl_sensor *>(&sensor) != nullptr)
+                || (dynamic_cast<const emi_sensor *>(&sensor) != nullptr)
+                || (dynamic_cast<const level_zero_sensor *>(&sensor)
+                    != nullptr)) {
+            return true;
+        }
+
+        if (auto s = dynamic_cast<const amdgpu_sensor *>(&sensor)) {
+            return (s->source() == amdgpu_sensor_source::energy);
+        }
+
+        if (auto s = dynamic_cast<const sysfs_sensor *>(&sensor)) {
+            return (s->quantity() == sysfs_sensor_quantity::energy);
+        }
+
+        if (auto s = dynamic_cast<const nvml_sensor *>(&sensor)) {
+            return s->energy_mode();
+        }
+    } catch (...) { /* Sensor has been disposed, so it measures nothing. */ }
+
+    return false;
+}
+
 
 /*
  * visus::power_overwhelming::detail::parse_sensors
  */
 std::vector<std::unique_ptr<visus::power_overwhelming::sensor>>
 visus::power_overwhelming::detail::parse_sensors(const nlohmann::json& descs) {
+    static constexpr std::size_t max_threads = 16;
     std::vector<std::unique_ptr<sensor>> retval;
 
     if (descs.type() == nlohmann::json::value_t::array) {
-        retval.reserve(descs.size());
-        for (auto& s : descs) {
-            retval.emplace_back(detail::parse_sensor(s, sensor_list()));
+        // Group the descriptors by the resource they are created from. Each
+        // group remembers the indices of its descriptors, such that the
+        // sensors end up in the order of the descriptors no matter which
+        // group finishes first.
+        std::vector<std::vector<std::size_t>> groups;
+        {
+            std::map<std::string, std::size_t> keys;
+            for (std::size_t i = 0; i < descs.size(); ++i) {
+                auto key = get_resource_key(descs[i]);
+                auto it = keys.find(key);
+                if (it == keys.end()) {
+                    it = keys.emplace(std::move(key), groups.size()).first;
+                    groups.emplace_back();
+                }
+                groups[it->second].push_back(i);
+            }
+        }
+
+        std::vector<std::exception_ptr> errors(descs.size());
+        std::atomic<std::size_t> next(0);
+        retval.resize(descs.size());
+
+        // Creating a sensor often waits for an instrument or a Brick daemon
+        // on the network, so the groups are created concurrently, but the
+        // sensors of a group one after another. A group stops at its first
+        // failure like the sequential construction would.
+        auto create = [&descs, &errors, &groups, &next, &retval](void) {
+            for (auto g = next++; g < groups.size(); g = next++) {
+                for (auto i : groups[g]) {
+                    try {
+                        retval[i] = detail::parse_sensor(descs[i],
+                            sensor_list());
+                    } catch (...) {
+                        errors[i] = std::current_exception();
+                        break;
+                    }
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        const auto cnt = (std::min)(groups.size(), max_threads);
+        threads.reserve(cnt);
+        for (std::size_t i = 1; i < cnt; ++i) {
+            try {
+                threads.emplace_back([&create](void) {
+                    enter_library_thread("PwrOwg Sensor Creation Thread");
+                    create();
+                });
+            } catch (const std::system_error&) {
+                // Continue with the threads we have, which only makes the
+                // construction slower.
+                break;
+            }
+        }
+
+        create();
+
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        // Report the error of the first descriptor that failed, which is the
+        // one the sequential construction would have raised.
+        for (auto& e : errors) {
+            if (e != nullptr) {
+                std::rethrow_exception(e);
+            }
         }
 
     } else if (descs.type() == nlohmann::json::value_t::object) {
@@ -195,6 +762,52 @@ nlohmann::json visus::power_overwhelming::detail::read_json(
 }
 
 
+/*
+ * visus::power_overwhelming::detail::validate_sensor_descs
+ */
+nlohmann::json visus::power_overwhelming::detail::validate_sensor_descs(
+        const nlohmann::json& descs) {
+    auto retval = nlohmann::json::array();
+
+    if (descs.type() == nlohmann::json::value_t::array) {
+        retval = descs;
+    } else if (descs.type() == nlohmann::json::value_t::object) {
+        retval.push_back(descs);
+    }
+
+    for (auto& d : retval) {
+        if (!d.is_object()) {
+            throw std::invalid_argument("A sensor descriptor must be a JSON "
+                "object.");
+        }
+
+        auto type = d.find(json_field_type);
+        if ((type == d.end()) || !type->is_string()) {
+            throw std::invalid_argument("A sensor descriptor must specify the "
+                "type of the sensor.");
+        }
+
+        if (!is_known_sensor(d, sensor_list())) {
+            throw std::invalid_argument("An unknown type of sensor was "
+                "specified.");
+        }
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::write_sensor_descs
+ */
+std::size_t visus::power_overwhelming::detail::write_sensor_descs(
+        std::ostream& stream,
+        const sensor_filter& filter,
+        const std::size_t indent) {
+    return write_descs(stream, filter, indent, sensor_list());
+}
+
+
 /*
  * visus::power_overwhelming::detail::write_json
  */
@@ -5,13 +5,17 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
+#include <ostream>
 #include <vector>
 
 #include <nlohmann/json.hpp>
 
 #include "power_overwhelming/convert_string.h"
+#include "power_overwhelming/enumerate_sensors.h"
 #include "power_overwhelming/sensor.h"
+#include "power_overwhelming/sensor_filter.h"
 
 
 namespace visus {
@@ -22,15 +26,48 @@ namespace detail {
     /// Get all serialised sensor descriptions for sensors on the current
     /// machine.
     /// </summary>
+    /// <remarks>
+    /// All types of sensors are discovered concurrently. Types that fail or
+    /// do not complete within their <c>sensor_desc::discovery_timeout</c> are
+    /// omitted. The descriptors are ordered by the type list
+    /// <see cref="sensor_list" /> regardless of which type finishes first.
+    /// </remarks>
     /// <returns>A JSON array holding all the descriptors.</returns>
     nlohmann::json get_all_sensor_descs(void);
 
     /// <summary>
     /// Gets all sensors available on the current machine.
     /// </summary>
+    /// <remarks>
+    /// All types of sensors are discovered concurrently. Types that fail or
+    /// do not complete within their <c>sensor_desc::discovery_timeout</c> are
+    /// omitted. The sensors are ordered by the type list
+    /// <see cref="sensor_list" /> regardless of which type finishes first.
+    /// </remarks>
     /// <returns>A list of all sensors we know on this system.</returns>
     extern std::vector<std::unique_ptr<sensor>> get_all_sensors(void);
 
+    /// <summary>
+    /// Gets all sensors available on the current machine that are accepted
+    /// by <paramref name="filter" />.
+    /// </summary>
+    /// <remarks>
+    /// Types that are rejected by the type filter are not discovered at all.
+    /// The criteria for the name and the device are evaluated on the
+    /// descriptors of the sensors, which are only created if any of these
+    /// criteria is set.
+    /// </remarks>
+    /// <param name="filter">The filter selecting the sensors.</param>
+    /// <param name="cancelled">An optional flag that stops the discovery
+    /// once it becomes <c>true</c>. The sensors that have been discovered
+    /// until then are returned.</param>
+    /// <returns>A list of the accepted sensors.</returns>
+    /// <exception cref="std::regex_error">If any of the patterns of the
+    /// filter is not a valid regular expression.</exception>
+    extern std::vector<std::unique_ptr<sensor>> get_all_sensors(
+        const sensor_filter& filter,
+        const std::atomic<bool> *cancelled = nullptr);
+
     /// <summary>
     /// Gets all sensors of the specified type.
     /// </summary>
@@ -39,12 +76,62 @@ namespace detail {
     /// <returns>A list of all sensors of the specified type, which are
     /// available on the system.</returns>
     template<class TSensor> inline std::vector<TSensor> get_all_sensors_of(void) {
-        std::vector<TSensor> retval;
-        retval.resize(TSensor::for_all(nullptr, 0));
-        TSensor::for_all(retval.data(), retval.size());
-        return retval;
+        return enumerate_sensors<TSensor>();
     }
 
+    /// <summary>
+    /// Answer the name of the type of the given sensor as it is used in the
+    /// JSON configuration.
+    /// </summary>
+    /// <param name="sensor">The sensor to get the type of.</param>
+    /// <returns>The type name like <c>hmc8015_sensor</c>, or <c>nullptr</c>
+    /// if the sensor is not one of the types in <see cref="sensor_list" />.
+    /// </returns>
+    _Ret_maybenull_z_ const char *get_sensor_type(
+        const sensor& sensor) noexcept;
+
+    /// <summary>
+    /// Answer whether the given sensor stamps its samples when the data
+    /// arrive, i.e. after the period they have been averaged over.
+    /// </summary>
+    /// <remarks>
+    /// These are ADL, HMC8015, NVML and Tinkerforge sensors as well as amdgpu
+    /// and sysfs sensors reading an average power.
+    /// </remarks>
+    /// <param name="sensor">The sensor to be checked.</param>
+    /// <returns><c>true</c> if the timestamps trail the data, <c>false</c>
+    /// otherwise.</returns>
+    bool has_trailing_timestamps(const sensor& sensor) noexcept;
+
+    /// <summary>
+    /// Answer whether the given sensor measures the power of a whole CPU
+    /// package.
+    /// </summary>
+    /// <remarks>
+    /// These are RAPL sensors of the <see cref="rapl_domain::package" />
+    /// domain and EMI sensors of the package channel of a RAPL device, which
+    /// is recognised by the suffix <c>_PKG</c> of the channel name.
+    /// </remarks>
+    /// <param name="sensor">The sensor to be checked.</param>
+    /// <returns><c>true</c> if the sensor measures a CPU package,
+    /// <c>false</c> otherwise.</returns>
+    bool is_cpu_package_sensor(const sensor& sensor) noexcept;
+
+    /// <summary>
+    /// Answer whether the given sensor derives its power from a hardware
+    /// energy counter.
+    /// </summary>
+    /// <remarks>
+    /// These are all RAPL, EMI and Level Zero sensors, NVML sensors in energy
+    /// mode and amdgpu and sysfs sensors reading an energy counter.
+    /// Their samples report the average power since the previous sample
+    /// rather than an instantaneous reading.
+    /// </remarks>
+    /// <param name="sensor">The sensor to be checked.</param>
+    /// <returns><c>true</c> if the sensor reads an energy counter,
+    /// <c>false</c> otherwise.</returns>
+    bool is_energy_counter_sensor(const sensor& sensor) noexcept;
+
     /// <summary>
     /// Move the given sensor to the given polymorphic sensor list
     /// <paramref name="dst" />.
@@ -85,8 +172,16 @@ namespace detail {
     /// <summary>
     /// Parse sensor instances from a JSON-based configuration.
     /// </summary>
-    /// <param name="descs"></param>
-    /// <returns></returns>
+    /// <remarks>
+    /// Sensors that are created from different resources, for instance from
+    /// different Brick daemons or VISA instruments, are created concurrently.
+    /// The sensors are nevertheless returned in the order of the descriptors,
+    /// and if any of them cannot be created, the error of the first failing
+    /// descriptor is rethrown.
+    /// </remarks>
+    /// <param name="descs">A JSON array of sensor descriptors or a single
+    /// descriptor.</param>
+    /// <returns>The sensors created from the descriptors.</returns>
     std::vector<std::unique_ptr<sensor>> parse_sensors(
         const nlohmann::json &descs);
 
@@ -104,6 +199,22 @@ namespace detail {
     /// <returns>The contents of the JSON file.</returns>
     nlohmann::json read_json(const wchar_t *path);
 
+    /// <summary>
+    /// Checks that <paramref name="descs" /> describes known types of sensors
+    /// without creating any of the sensors.
+    /// </summary>
+    /// <remarks>
+    /// The check does not access any hardware, wherefore it cannot tell
+    /// whether the described devices exist. The sensors can be created from
+    /// the result later using <see cref="parse_sensors" />.
+    /// </remarks>
+    /// <param name="descs">A JSON array of sensor descriptors or a single
+    /// descriptor.</param>
+    /// <returns>A JSON array of the descriptors.</returns>
+    /// <exception cref="std::invalid_argument">If any of the descriptors is
+    /// not an object or describes an unknown type of sensor.</exception>
+    nlohmann::json validate_sensor_descs(const nlohmann::json& descs);
+
     /// <summary>
     /// Write JSON configuration to a file.
     /// </summary>
@@ -111,6 +222,29 @@ namespace detail {
     /// <param name="json">The JSON content to write</param>
     void write_json(const char *path, const nlohmann::json& json);
 
+    /// <summary>
+    /// Writes a JSON array of the serialised descriptions of all sensors on
+    /// the current machine that are accepted by <paramref name="filter" />.
+    /// </summary>
+    /// <remarks>
+    /// <para>In contrast to <see cref="get_all_sensor_descs" />, the
+    /// descriptors are written as soon as all sensors of a type have been
+    /// discovered and are not retained afterwards. Types that are rejected by
+    /// the type filter are not discovered at all. The descriptors are ordered
+    /// by the type list <see cref="sensor_list" />.</para>
+    /// <para>The output is formatted like <c>nlohmann::json::dump(4)</c> for
+    /// an array nested <paramref name="indent" /> spaces deep.</para>
+    /// </remarks>
+    /// <param name="stream">The stream to write the array to.</param>
+    /// <param name="filter">The filter selecting the sensors.</param>
+    /// <param name="indent">The indentation of the array itself, which is
+    /// applied to all but the first line.</param>
+    /// <returns>The number of descriptors written.</returns>
+    /// <exception cref="std::regex_error">If any of the patterns of the
+    /// filter is not a valid regular expression.</exception>
+    std::size_t write_sensor_descs(std::ostream& stream,
+        const sensor_filter& filter, const std::size_t indent = 0);
+
     /// <summary>
     /// Write JSON configuration to a file.
     /// </summary>
@@ -0,0 +1,101 @@
+﻿// <copyright file="sequence_tracker.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "sequence_tracker.h"
+
+#include <algorithm>
+#include <cwchar>
+#include <limits>
+
+
+/*
+ * visus::power_overwhelming::detail::sequence_tracker::push
+ */
+bool visus::power_overwhelming::detail::sequence_tracker::push(
+        _In_ const measurement& sample, _Out_ sequence_gap& gap) {
+    const auto sequence = sample.data().sequence();
+    if (sequence == 0) {
+        // The sample has not been numbered, so there is nothing to check.
+        return false;
+    }
+
+    auto it = this->_states.find(sample.sensor());
+    if (it == this->_states.end()) {
+        state_type state;
+        state.last = sequence;
+        state.summary.duplicates = 0;
+        state.summary.gaps = 0;
+        state.summary.missing = 0;
+        state.summary.samples = 1;
+        state.summary.sensor = sample.sensor();
+        this->_states.emplace(sample.sensor(), state);
+        return false;
+    }
+
+    auto& state = it->second;
+    ++state.summary.samples;
+
+    // The difference is computed modulo the range of the sequence numbers,
+    // such that a number that is not newer than the previous one yields zero
+    // or a difference in the upper half of the range.
+    auto delta = static_cast<sequence_type>(sequence - state.last);
+    if ((delta == 0)
+            || (delta > (std::numeric_limits<sequence_type>::max)() / 2)) {
+        ++state.summary.duplicates;
+        return false;
+    }
+
+    if (sequence < state.last) {
+        // The numbers wrapped around, which skips zero.
+        --delta;
+    }
+
+    const auto last = state.last;
+    state.last = sequence;
+
+    if (delta <= 1) {
+        return false;
+    }
+
+    ++state.summary.gaps;
+    state.summary.missing += delta - 1;
+
+    gap.first = last;
+    next(gap.first);
+    gap.missing = delta - 1;
+    gap.sensor = sample.sensor();
+    gap.timestamp = sample.timestamp();
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sequence_tracker::reset
+ */
+void visus::power_overwhelming::detail::sequence_tracker::reset(void) {
+    this->_states.clear();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sequence_tracker::summary
+ */
+std::vector<visus::power_overwhelming::detail::sequence_summary>
+visus::power_overwhelming::detail::sequence_tracker::summary(void) const {
+    std::vector<sequence_summary> retval;
+    retval.reserve(this->_states.size());
+
+    for (auto& s : this->_states) {
+        retval.push_back(s.second.summary);
+    }
+
+    // Sort the summary by name such that the output is deterministic.
+    std::sort(retval.begin(), retval.end(),
+        [](const sequence_summary& lhs, const sequence_summary& rhs) {
+            return (std::wcscmp(lhs.sensor, rhs.sensor) < 0);
+        });
+
+    return retval;
+}
@@ -0,0 +1,150 @@
+﻿// <copyright file="sequence_tracker.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <unordered_map>
+#include <vector>
+
+#include "power_overwhelming/measurement.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Describes a run of consecutive samples of a sensor that have not been
+    /// received.
+    /// </summary>
+    struct POWER_OVERWHELMING_API sequence_gap final {
+
+        /// <summary>
+        /// The sequence number of the first missing sample.
+        /// </summary>
+        measurement_data::sequence_type first;
+
+        /// <summary>
+        /// The number of samples that are missing.
+        /// </summary>
+        std::uint32_t missing;
+
+        /// <summary>
+        /// The interned name of the sensor.
+        /// </summary>
+        const wchar_t *sensor;
+
+        /// <summary>
+        /// The timestamp of the sample received after the gap.
+        /// </summary>
+        measurement::timestamp_type timestamp;
+    };
+
+
+    /// <summary>
+    /// The counters of a <see cref="sequence_tracker" /> for a single sensor.
+    /// </summary>
+    struct POWER_OVERWHELMING_API sequence_summary final {
+
+        /// <summary>
+        /// The number of samples whose sequence number was not newer than the
+        /// one of the previous sample.
+        /// </summary>
+        std::uint64_t duplicates;
+
+        /// <summary>
+        /// The number of gaps in the sequence.
+        /// </summary>
+        std::uint64_t gaps;
+
+        /// <summary>
+        /// The total number of samples missing in all gaps.
+        /// </summary>
+        std::uint64_t missing;
+
+        /// <summary>
+        /// The number of numbered samples that have been received.
+        /// </summary>
+        std::uint64_t samples;
+
+        /// <summary>
+        /// The interned name of the sensor.
+        /// </summary>
+        const wchar_t *sensor;
+    };
+
+
+    /// <summary>
+    /// Tracks the sequence numbers of the samples of each sensor in order to
+    /// detect samples that have been lost or delivered twice.
+    /// </summary>
+    /// <remarks>
+    /// <para>Samples with the sequence number zero are not numbered and are
+    /// therefore ignored. As the numbers skip zero when they wrap around, the
+    /// tracker does not report a gap in this case.</para>
+    /// <para>The tracker is used by the I/O thread of the collector, which
+    /// sees a gap regardless of whether the sensor failed to deliver the
+    /// reading or whether the collector dropped it.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API sequence_tracker final {
+
+    public:
+
+        /// <summary>
+        /// The type of a sequence number.
+        /// </summary>
+        typedef measurement_data::sequence_type sequence_type;
+
+        /// <summary>
+        /// Advances <paramref name="counter" /> to the next sequence number,
+        /// which is never zero.
+        /// </summary>
+        /// <param name="counter">The counter of the sensor.</param>
+        /// <returns>The new value of <paramref name="counter" />.</returns>
+        static inline sequence_type next(
+                _Inout_ sequence_type& counter) noexcept {
+            if (++counter == 0) {
+                ++counter;
+            }
+            return counter;
+        }
+
+        /// <summary>
+        /// Checks the sequence number of <paramref name="sample" />.
+        /// </summary>
+        /// <param name="sample">The sample to be checked.</param>
+        /// <param name="gap">Receives the gap before
+        /// <paramref name="sample" /> if the method returns <c>true</c>.
+        /// </param>
+        /// <returns><c>true</c> if samples are missing before
+        /// <paramref name="sample" />, <c>false</c> otherwise.</returns>
+        bool push(_In_ const measurement& sample, _Out_ sequence_gap& gap);
+
+        /// <summary>
+        /// Forgets all sensors.
+        /// </summary>
+        void reset(void);
+
+        /// <summary>
+        /// Answer the counters of all sensors that have delivered numbered
+        /// samples.
+        /// </summary>
+        /// <returns>The counters of each sensor.</returns>
+        std::vector<sequence_summary> summary(void) const;
+
+    private:
+
+        struct state_type {
+            sequence_type last;
+            sequence_summary summary;
+        };
+
+        std::unordered_map<const wchar_t *, state_type> _states;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,183 @@
+﻿// <copyright file="shared_measurement_layout.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <cinttypes>
+#include <cstddef>
+#include <cstring>
+
+#include "power_overwhelming/measurement_data.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The magic number identifying a shared memory segment with the latest
+    /// samples of a collector.
+    /// </summary>
+    static constexpr char shared_measurement_magic[8] = {
+        'P', 'w', 'r', 'O', 'w', 'g', 'L', 'v'
+    };
+
+    /// <summary>
+    /// The version of the layout of the shared memory segment.
+    /// </summary>
+    static constexpr std::uint32_t shared_measurement_version = 1;
+
+    /// <summary>
+    /// The header at the begin of the shared memory segment.
+    /// </summary>
+    /// <remarks>
+    /// The header is followed by <see cref="capacity" /> instances of
+    /// <see cref="shared_measurement_slot" />.
+    /// </remarks>
+    struct shared_measurement_header final {
+
+        /// <summary>
+        /// The <see cref="shared_measurement_magic" />.
+        /// </summary>
+        char magic[sizeof(shared_measurement_magic)];
+
+        /// <summary>
+        /// The <see cref="shared_measurement_version" />.
+        /// </summary>
+        std::uint32_t version;
+
+        /// <summary>
+        /// The number of slots following the header.
+        /// </summary>
+        std::uint32_t capacity;
+
+        /// <summary>
+        /// Non-zero while the writer is publishing into the segment.
+        /// </summary>
+        std::atomic<std::uint32_t> active;
+
+        /// <summary>
+        /// The number of slots that have been assigned to a sensor.
+        /// </summary>
+        /// <remarks>
+        /// The name of a slot is written before the count is increased with
+        /// release semantics and never changes afterwards.
+        /// </remarks>
+        std::atomic<std::uint32_t> count;
+
+        /// <summary>
+        /// Pads the header to a cache line.
+        /// </summary>
+        std::uint8_t reserved[40];
+    };
+
+
+    /// <summary>
+    /// The latest sample of a single sensor, protected by a sequence lock.
+    /// </summary>
+    /// <remarks>
+    /// <para>The writer increments <see cref="sequence" /> before and after
+    /// updating the sample, such that it is odd while an update is in
+    /// progress. Readers retry if the sequence is odd or has changed while
+    /// they copied the sample. All fields are atomics accessed with relaxed
+    /// ordering in order to avoid a data race in the sense of the C++ memory
+    /// model while the fences order them with respect to the sequence.</para>
+    /// <para>A slot has the size of two cache lines, which keeps its sample
+    /// in a single line.</para>
+    /// </remarks>
+    struct shared_measurement_slot final {
+
+        /// <summary>
+        /// The maximum length of the UTF-8 name of the sensor in bytes,
+        /// including the terminating zero.
+        /// </summary>
+        static constexpr std::size_t max_name = 104;
+
+        /// <summary>
+        /// The sequence number of the sample, which is zero if no sample has
+        /// been published yet.
+        /// </summary>
+        std::atomic<std::uint32_t> sequence;
+
+        /// <summary>
+        /// The bits of the voltage.
+        /// </summary>
+        std::atomic<std::uint32_t> voltage;
+
+        /// <summary>
+        /// The timestamp of the sample.
+        /// </summary>
+        std::atomic<std::int64_t> timestamp;
+
+        /// <summary>
+        /// The bits of the current.
+        /// </summary>
+        std::atomic<std::uint32_t> current;
+
+        /// <summary>
+        /// The bits of the power.
+        /// </summary>
+        std::atomic<std::uint32_t> power;
+
+        /// <summary>
+        /// The zero-terminated UTF-8 name of the sensor.
+        /// </summary>
+        char name[max_name];
+    };
+
+    static_assert(ATOMIC_INT_LOCK_FREE == 2, "The shared memory layout "
+        "requires lock-free 32-bit atomics.");
+    static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "The shared memory layout "
+        "requires lock-free 64-bit atomics.");
+    static_assert(sizeof(shared_measurement_header) == 64, "The header of the "
+        "shared memory segment must have the size of a cache line.");
+    static_assert(sizeof(shared_measurement_slot) == 128, "A slot in the "
+        "shared memory segment must have the size of two cache lines.");
+    static_assert(sizeof(measurement_data::value_type)
+        == sizeof(std::uint32_t), "The values of a sample must be 32 bits "
+        "wide to be stored in the shared memory segment.");
+
+    /// <summary>
+    /// Answer the size of a shared memory segment with the given number of
+    /// slots.
+    /// </summary>
+    inline constexpr std::size_t shared_measurement_size(
+            _In_ const std::size_t capacity) noexcept {
+        return sizeof(shared_measurement_header)
+            + capacity * sizeof(shared_measurement_slot);
+    }
+
+    /// <summary>
+    /// Answer the slots following the given header.
+    /// </summary>
+    inline shared_measurement_slot *shared_measurement_slots(
+            _In_ shared_measurement_header *header) noexcept {
+        return reinterpret_cast<shared_measurement_slot *>(header + 1);
+    }
+
+    /// <summary>
+    /// Reinterprets a value of a sample as the bits stored in the segment.
+    /// </summary>
+    inline std::uint32_t to_shared_bits(
+            _In_ const measurement_data::value_type value) noexcept {
+        std::uint32_t retval;
+        ::memcpy(&retval, &value, sizeof(retval));
+        return retval;
+    }
+
+    /// <summary>
+    /// Reinterprets the bits stored in the segment as a value of a sample.
+    /// </summary>
+    inline measurement_data::value_type from_shared_bits(
+            _In_ const std::uint32_t bits) noexcept {
+        measurement_data::value_type retval;
+        ::memcpy(&retval, &bits, sizeof(retval));
+        return retval;
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,184 @@
+﻿// <copyright file="shared_measurement_reader.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/shared_measurement_reader.h"
+
+#include <cwchar>
+#include <memory>
+
+#include "shared_measurement_reader_impl.h"
+
+
+/*
+ * ...::shared_measurement_reader::shared_measurement_reader
+ */
+visus::power_overwhelming::shared_measurement_reader::shared_measurement_reader(
+    void) noexcept : _impl(nullptr) { }
+
+
+/*
+ * ...::shared_measurement_reader::shared_measurement_reader
+ */
+visus::power_overwhelming::shared_measurement_reader::shared_measurement_reader(
+    _In_z_ const wchar_t *name)
+    : _impl(new detail::shared_measurement_reader_impl(name)) { }
+
+
+/*
+ * ...::shared_measurement_reader::~shared_measurement_reader
+ */
+visus::power_overwhelming::shared_measurement_reader
+::~shared_measurement_reader(void) {
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::shared_measurement_reader::active
+ */
+bool visus::power_overwhelming::shared_measurement_reader::active(
+        void) const noexcept {
+    return (this->_impl != nullptr)
+        && (this->_impl->header->active.load(std::memory_order_acquire) != 0);
+}
+
+
+/*
+ * visus::power_overwhelming::shared_measurement_reader::capacity
+ */
+std::size_t visus::power_overwhelming::shared_measurement_reader::capacity(
+        void) const noexcept {
+    return (this->_impl != nullptr) ? this->_impl->header->capacity : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::shared_measurement_reader::read
+ */
+bool visus::power_overwhelming::shared_measurement_reader::read(
+        _In_ const std::size_t index,
+        _Out_ measurement_data& dst) const noexcept {
+    if ((this->_impl == nullptr) || (index >= this->_impl->count())) {
+        return false;
+    }
+
+    auto& slot = detail::shared_measurement_slots(
+        const_cast<detail::shared_measurement_header *>(
+        this->_impl->header))[index];
+
+    while (true) {
+        const auto begin = slot.sequence.load(std::memory_order_acquire);
+        if (begin == 0) {
+            // The sensor has not delivered any sample yet.
+            return false;
+        }
+        if ((begin & 1) != 0) {
+            // The writer is updating the slot, which takes only a few
+            // instructions, so we just spin.
+            continue;
+        }
+
+        const auto timestamp = slot.timestamp.load(std::memory_order_relaxed);
+        const auto voltage = slot.voltage.load(std::memory_order_relaxed);
+        const auto current = slot.current.load(std::memory_order_relaxed);
+        const auto power = slot.power.load(std::memory_order_relaxed);
+
+        // The fence prevents the loads of the fields from being reordered
+        // after the second load of the sequence.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == begin) {
+            dst = measurement_data(timestamp,
+                detail::from_shared_bits(voltage),
+                detail::from_shared_bits(current),
+                detail::from_shared_bits(power));
+            return true;
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::shared_measurement_reader::read
+ */
+bool visus::power_overwhelming::shared_measurement_reader::read(
+        _In_opt_z_ const wchar_t *sensor,
+        _Out_ measurement_data& dst) const noexcept {
+    if ((this->_impl == nullptr) || (sensor == nullptr)) {
+        return false;
+    }
+
+    try {
+        this->_impl->update_names();
+    } catch (...) {
+        // Search the names we have converted before.
+    }
+
+    auto& names = this->_impl->names;
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        if (names[i] == sensor) {
+            return this->read(i, dst);
+        }
+    }
+
+    return false;
+}
+
+
+/*
+ * visus::power_overwhelming::shared_measurement_reader::sensor
+ */
+_Ret_maybenull_z_ const wchar_t *
+visus::power_overwhelming::shared_measurement_reader::sensor(
+        _In_ const std::size_t index) const noexcept {
+    if (this->_impl == nullptr) {
+        return nullptr;
+    }
+
+    if (index >= this->_impl->names.size()) {
+        try {
+            this->_impl->update_names();
+        } catch (...) {
+            return nullptr;
+        }
+    }
+
+    return (index < this->_impl->names.size())
+        ? this->_impl->names[index].c_str()
+        : nullptr;
+}
+
+
+/*
+ * visus::power_overwhelming::shared_measurement_reader::size
+ */
+std::size_t visus::power_overwhelming::shared_measurement_reader::size(
+        void) const noexcept {
+    return (this->_impl != nullptr) ? this->_impl->count() : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::shared_measurement_reader::operator =
+ */
+visus::power_overwhelming::shared_measurement_reader&
+visus::power_overwhelming::shared_measurement_reader::operator =(
+        _Inout_ shared_measurement_reader&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::shared_measurement_reader::operator bool
+ */
+visus::power_overwhelming::shared_measurement_reader::operator bool(
+        void) const noexcept {
+    return (this->_impl != nullptr);
+}
@@ -0,0 +1,77 @@
+﻿// <copyright file="shared_measurement_reader_impl.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "shared_measurement_reader_impl.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "power_overwhelming/convert_string.h"
+
+
+/*
+ * ...::detail::shared_measurement_reader_impl::shared_measurement_reader_impl
+ */
+visus::power_overwhelming::detail::shared_measurement_reader_impl
+::shared_measurement_reader_impl(_In_z_ const wchar_t *name)
+        : header(nullptr) {
+    this->segment.open(name);
+
+    if (this->segment.size() < sizeof(shared_measurement_header)) {
+        throw std::runtime_error("The shared memory segment is too small to "
+            "hold any samples.");
+    }
+
+    this->header = static_cast<const shared_measurement_header *>(
+        this->segment.data());
+    if (::memcmp(this->header->magic, shared_measurement_magic,
+            sizeof(shared_measurement_magic)) != 0) {
+        throw std::runtime_error("The shared memory segment does not contain "
+            "samples of a collector.");
+    }
+    if (this->header->version != shared_measurement_version) {
+        throw std::runtime_error("The shared memory segment contains samples "
+            "in an unsupported version of the layout.");
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::shared_measurement_reader_impl::count
+ */
+std::size_t visus::power_overwhelming::detail::shared_measurement_reader_impl
+::count(void) const noexcept {
+    // Do not trust the header beyond the memory we have actually mapped.
+    const auto mapped = (this->segment.size()
+        - sizeof(shared_measurement_header))
+        / sizeof(shared_measurement_slot);
+    const auto capacity = (std::min)(mapped,
+        static_cast<std::size_t>(this->header->capacity));
+    const std::size_t count = this->header->count.load(
+        std::memory_order_acquire);
+    return (std::min)(count, capacity);
+}
+
+
+/*
+ * ...::detail::shared_measurement_reader_impl::update_names
+ */
+void visus::power_overwhelming::detail::shared_measurement_reader_impl
+::update_names(void) {
+    const auto count = this->count();
+    auto slots = shared_measurement_slots(
+        const_cast<shared_measurement_header *>(this->header));
+
+    for (auto i = this->names.size(); i < count; ++i) {
+        // The name cannot change once the slot has been counted, but we must
+        // not rely on the writer to have terminated it.
+        const auto name = slots[i].name;
+        const auto end = std::find(name,
+            name + shared_measurement_slot::max_name, '\0');
+        this->names.push_back(power_overwhelming::convert_string<wchar_t>(
+            std::string(name, end)));
+    }
+}
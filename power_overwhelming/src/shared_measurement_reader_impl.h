@@ -0,0 +1,58 @@
+﻿// <copyright file="shared_measurement_reader_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "shared_measurement_layout.h"
+#include "shared_memory_segment.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The private state of a <see cref="shared_measurement_reader" />.
+    /// </summary>
+    struct shared_measurement_reader_impl final {
+
+        /// <summary>
+        /// The header of the mapped segment.
+        /// </summary>
+        const shared_measurement_header *header;
+
+        /// <summary>
+        /// The wide names of the slots that have been converted so far.
+        /// </summary>
+        std::vector<std::wstring> names;
+
+        /// <summary>
+        /// The mapped segment.
+        /// </summary>
+        shared_memory_segment segment;
+
+        /// <summary>
+        /// Maps the given segment and validates its header.
+        /// </summary>
+        explicit shared_measurement_reader_impl(_In_z_ const wchar_t *name);
+
+        /// <summary>
+        /// Answer the number of slots readers can access.
+        /// </summary>
+        std::size_t count(void) const noexcept;
+
+        /// <summary>
+        /// Converts the names of slots that have been assigned since the last
+        /// call.
+        /// </summary>
+        void update_names(void);
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,172 @@
+﻿// <copyright file="shared_measurement_writer.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "shared_measurement_writer.h"
+
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+
+#include "power_overwhelming/convert_string.h"
+
+
+/*
+ * ...::detail::shared_measurement_writer::default_capacity
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::shared_measurement_writer::default_capacity;
+
+
+/*
+ * ...::detail::shared_measurement_writer::~shared_measurement_writer
+ */
+visus::power_overwhelming::detail::shared_measurement_writer
+::~shared_measurement_writer(void) {
+    this->close();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::shared_measurement_writer::close
+ */
+void visus::power_overwhelming::detail::shared_measurement_writer::close(
+        void) noexcept {
+    if (this->_header != nullptr) {
+        // Readers that keep the segment mapped can detect that the samples
+        // are not updated any more.
+        this->_header->active.store(0, std::memory_order_release);
+        this->_header = nullptr;
+    }
+
+    this->_segment.close();
+    this->_indices.clear();
+    this->_names.clear();
+    this->_pointers.clear();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::shared_measurement_writer::open
+ */
+void visus::power_overwhelming::detail::shared_measurement_writer::open(
+        _In_z_ const wchar_t *name, _In_ const std::size_t capacity) {
+    if ((capacity == 0) || (capacity > (std::numeric_limits<
+            std::uint32_t>::max)() / sizeof(shared_measurement_slot))) {
+        throw std::invalid_argument("The capacity of the shared memory segment "
+            "is out of range.");
+    }
+
+    this->close();
+    this->_segment.create(name, shared_measurement_size(capacity));
+
+    // Fresh segments are zero-filled, so we only need to fill the header.
+    this->_header = static_cast<shared_measurement_header *>(
+        this->_segment.data());
+    ::memcpy(this->_header->magic, shared_measurement_magic,
+        sizeof(this->_header->magic));
+    this->_header->version = shared_measurement_version;
+    this->_header->capacity = static_cast<std::uint32_t>(capacity);
+    this->_header->count.store(0, std::memory_order_relaxed);
+    this->_header->active.store(1, std::memory_order_release);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::shared_measurement_writer::publish
+ */
+bool visus::power_overwhelming::detail::shared_measurement_writer::publish(
+        _In_ const measurement& sample) noexcept {
+    if ((this->_header == nullptr) || (sample.sensor() == nullptr)) {
+        return false;
+    }
+
+    shared_measurement_slot *slot = nullptr;
+    try {
+        slot = this->slot(sample.sensor());
+    } catch (...) {
+        // Running out of memory must not stop the collector.
+    }
+
+    if (slot == nullptr) {
+        return false;
+    }
+
+    // We are the only writer, so the sequence does not need to be loaded
+    // with any particular ordering. The fence prevents the updates of the
+    // fields being reordered before the odd sequence is visible.
+    const auto sequence = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->timestamp.store(sample.timestamp(), std::memory_order_relaxed);
+    slot->voltage.store(to_shared_bits(sample.voltage()),
+        std::memory_order_relaxed);
+    slot->current.store(to_shared_bits(sample.current()),
+        std::memory_order_relaxed);
+    slot->power.store(to_shared_bits(sample.power()),
+        std::memory_order_relaxed);
+
+    slot->sequence.store(sequence + 2, std::memory_order_release);
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::shared_measurement_writer::slot
+ */
+visus::power_overwhelming::detail::shared_measurement_slot *
+visus::power_overwhelming::detail::shared_measurement_writer::slot(
+        _In_z_ const wchar_t *sensor) {
+    assert(this->_header != nullptr);
+    assert(sensor != nullptr);
+    auto slots = shared_measurement_slots(this->_header);
+
+    // The names of the samples typically point to the same strings owned by
+    // their sensors, so we can mostly avoid hashing the names. We must verify
+    // the name, though, because the memory might have been reused.
+    {
+        auto it = this->_pointers.find(sensor);
+        if ((it != this->_pointers.end())
+                && (this->_names[it->second] == sensor)) {
+            return slots + it->second;
+        }
+    }
+
+    std::wstring key(sensor);
+    auto it = this->_indices.find(key);
+    if (it != this->_indices.end()) {
+        this->_pointers[sensor] = it->second;
+        return slots + it->second;
+    }
+
+    const auto index = this->_names.size();
+    if (index >= this->_header->capacity) {
+        return nullptr;
+    }
+
+    // Truncate the name at a code point such that readers always see valid
+    // UTF-8.
+    auto name = power_overwhelming::convert_string<char>(key);
+    if (name.size() >= shared_measurement_slot::max_name) {
+        auto end = shared_measurement_slot::max_name - 1;
+        while ((end > 0) && ((name[end] & 0xC0) == 0x80)) {
+            --end;
+        }
+        name.resize(end);
+    }
+
+    auto retval = slots + index;
+    ::memcpy(retval->name, name.c_str(), name.size() + 1);
+
+    this->_names.push_back(key);
+    this->_indices[key] = index;
+    this->_pointers[sensor] = index;
+
+    // Publish the name along with the slot.
+    this->_header->count.store(static_cast<std::uint32_t>(index + 1),
+        std::memory_order_release);
+
+    return retval;
+}
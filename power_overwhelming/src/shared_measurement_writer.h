@@ -0,0 +1,112 @@
+﻿// <copyright file="shared_measurement_writer.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "power_overwhelming/measurement.h"
+
+#include "shared_measurement_layout.h"
+#include "shared_memory_segment.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Publishes the latest sample of each sensor in a named shared memory
+    /// segment, from which other processes can read them using
+    /// <see cref="shared_measurement_reader" />.
+    /// </summary>
+    /// <remarks>
+    /// <para>Each sensor is assigned a slot of the segment when its first
+    /// sample is published. Once all slots have been assigned, samples of
+    /// other sensors are dropped.</para>
+    /// <para>The writer is not thread-safe. There must be only one writer
+    /// per segment.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API shared_measurement_writer final {
+
+    public:
+
+        /// <summary>
+        /// The default number of sensors the segment can hold.
+        /// </summary>
+        static constexpr std::size_t default_capacity = 256;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        shared_measurement_writer(void) = default;
+
+        shared_measurement_writer(const shared_measurement_writer&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~shared_measurement_writer(void);
+
+        /// <summary>
+        /// Marks the segment inactive and closes it.
+        /// </summary>
+        void close(void) noexcept;
+
+        /// <summary>
+        /// Answer whether a segment is open.
+        /// </summary>
+        /// <returns><c>true</c> if the writer publishes into a segment,
+        /// <c>false</c> otherwise.</returns>
+        inline bool is_open(void) const noexcept {
+            return (this->_segment.data() != nullptr);
+        }
+
+        /// <summary>
+        /// Creates the named segment and marks it active.
+        /// </summary>
+        /// <param name="name">The name of the segment.</param>
+        /// <param name="capacity">The number of sensors the segment can hold.
+        /// </param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="name" /> is <c>nullptr</c> or empty, or if
+        /// <paramref name="capacity" /> is zero or too large.</exception>
+        /// <exception cref="std::system_error">If the segment could not be
+        /// created.</exception>
+        void open(_In_z_ const wchar_t *name,
+            _In_ const std::size_t capacity = default_capacity);
+
+        /// <summary>
+        /// Publishes the given sample as the latest one of its sensor.
+        /// </summary>
+        /// <param name="sample">The sample to be published.</param>
+        /// <returns><c>true</c> if the sample has been published,
+        /// <c>false</c> if no segment is open, if the sample has no sensor or
+        /// if all slots have been assigned to other sensors.</returns>
+        bool publish(_In_ const measurement& sample) noexcept;
+
+        shared_measurement_writer& operator =(
+            const shared_measurement_writer&) = delete;
+
+    private:
+
+        /// <summary>
+        /// Answer the slot of the given sensor, assigning a new one if
+        /// necessary.
+        /// </summary>
+        shared_measurement_slot *slot(_In_z_ const wchar_t *sensor);
+
+        shared_measurement_header *_header = nullptr;
+        std::unordered_map<std::wstring, std::size_t> _indices;
+        std::vector<std::wstring> _names;
+        std::unordered_map<const wchar_t *, std::size_t> _pointers;
+        shared_memory_segment _segment;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
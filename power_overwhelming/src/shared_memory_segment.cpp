@@ -0,0 +1,234 @@
+﻿// <copyright file="shared_memory_segment.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "shared_memory_segment.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif /* !defined(_WIN32) */
+
+#include "power_overwhelming/convert_string.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Checks that <paramref name="name" /> is a valid name of a segment.
+    /// </summary>
+    static void check_segment_name(_In_opt_z_ const wchar_t *name) {
+        if ((name == nullptr) || (*name == 0)) {
+            throw std::invalid_argument("The name of a shared memory segment "
+                "must not be empty.");
+        }
+    }
+
+#if !defined(_WIN32)
+    /// <summary>
+    /// Answer the name of the POSIX shared memory object for the given
+    /// segment.
+    /// </summary>
+    static std::string get_posix_name(_In_z_ const wchar_t *name) {
+        std::string retval("/");
+        retval += power_overwhelming::convert_string<char>(name);
+        return retval;
+    }
+#endif /* !defined(_WIN32) */
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * ...::detail::shared_memory_segment::shared_memory_segment
+ */
+visus::power_overwhelming::detail::shared_memory_segment::shared_memory_segment(
+        void) noexcept
+#if defined(_WIN32)
+    : _data(nullptr), _mapping(NULL), _size(0) { }
+#else /* defined(_WIN32) */
+    : _data(nullptr), _name(nullptr), _size(0) { }
+#endif /* defined(_WIN32) */
+
+
+/*
+ * ...::detail::shared_memory_segment::~shared_memory_segment
+ */
+visus::power_overwhelming::detail::shared_memory_segment
+::~shared_memory_segment(void) {
+    this->close();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::shared_memory_segment::close
+ */
+void visus::power_overwhelming::detail::shared_memory_segment::close(
+        void) noexcept {
+#if defined(_WIN32)
+    if (this->_data != nullptr) {
+        ::UnmapViewOfFile(this->_data);
+    }
+    if (this->_mapping != NULL) {
+        ::CloseHandle(this->_mapping);
+        this->_mapping = NULL;
+    }
+
+#else /* defined(_WIN32) */
+    if (this->_data != nullptr) {
+        ::munmap(this->_data, this->_size);
+    }
+    if (this->_name != nullptr) {
+        ::shm_unlink(this->_name);
+        ::free(this->_name);
+        this->_name = nullptr;
+    }
+#endif /* defined(_WIN32) */
+
+    this->_data = nullptr;
+    this->_size = 0;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::shared_memory_segment::create
+ */
+void visus::power_overwhelming::detail::shared_memory_segment::create(
+        _In_z_ const wchar_t *name, _In_ const std::size_t size) {
+    check_segment_name(name);
+    if (size == 0) {
+        throw std::invalid_argument("A shared memory segment must not be "
+            "empty.");
+    }
+
+    this->close();
+
+#if defined(_WIN32)
+    const auto s = static_cast<std::uint64_t>(size);
+    this->_mapping = ::CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr,
+        PAGE_READWRITE, static_cast<DWORD>(s >> 32), static_cast<DWORD>(s),
+        name);
+    if (this->_mapping == NULL) {
+        throw std::system_error(::GetLastError(), std::system_category());
+    }
+    if (::GetLastError() == ERROR_ALREADY_EXISTS) {
+        // Another process is publishing under this name, which we must not
+        // interfere with.
+        this->close();
+        throw std::system_error(ERROR_ALREADY_EXISTS, std::system_category());
+    }
+
+    this->_data = ::MapViewOfFile(this->_mapping, FILE_MAP_WRITE, 0, 0, size);
+    if (this->_data == nullptr) {
+        const auto error = ::GetLastError();
+        this->close();
+        throw std::system_error(error, std::system_category());
+    }
+
+#else /* defined(_WIN32) */
+    // Objects survive a crash of their creator, so we replace them. Processes
+    // still using a stale object keep their mapping.
+    const auto n = get_posix_name(name);
+    ::shm_unlink(n.c_str());
+
+    auto fd = ::shm_open(n.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        const auto error = errno;
+        ::close(fd);
+        ::shm_unlink(n.c_str());
+        throw std::system_error(error, std::system_category());
+    }
+
+    auto data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+        0);
+    const auto error = errno;
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        ::shm_unlink(n.c_str());
+        throw std::system_error(error, std::system_category());
+    }
+
+    this->_data = data;
+    this->_name = ::strdup(n.c_str());
+#endif /* defined(_WIN32) */
+
+    this->_size = size;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::shared_memory_segment::open
+ */
+void visus::power_overwhelming::detail::shared_memory_segment::open(
+        _In_z_ const wchar_t *name, _In_ const bool writable) {
+    check_segment_name(name);
+    this->close();
+
+#if defined(_WIN32)
+    const DWORD access = writable ? FILE_MAP_WRITE : FILE_MAP_READ;
+    this->_mapping = ::OpenFileMappingW(access, FALSE, name);
+    if (this->_mapping == NULL) {
+        throw std::system_error(::GetLastError(), std::system_category());
+    }
+
+    this->_data = ::MapViewOfFile(this->_mapping, access, 0, 0, 0);
+    if (this->_data == nullptr) {
+        const auto error = ::GetLastError();
+        this->close();
+        throw std::system_error(error, std::system_category());
+    }
+
+    MEMORY_BASIC_INFORMATION info;
+    if (::VirtualQuery(this->_data, &info, sizeof(info)) == 0) {
+        const auto error = ::GetLastError();
+        this->close();
+        throw std::system_error(error, std::system_category());
+    }
+    this->_size = info.RegionSize;
+
+#else /* defined(_WIN32) */
+    const auto n = get_posix_name(name);
+    auto fd = ::shm_open(n.c_str(), writable ? O_RDWR : O_RDONLY, 0);
+    if (fd < 0) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        const auto error = errno;
+        ::close(fd);
+        throw std::system_error(error, std::system_category());
+    }
+
+    const auto size = static_cast<std::size_t>(info.st_size);
+    auto data = ::mmap(nullptr, size, writable
+        ? (PROT_READ | PROT_WRITE)
+        : PROT_READ, MAP_SHARED, fd, 0);
+    const auto error = errno;
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        throw std::system_error(error, std::system_category());
+    }
+
+    this->_data = data;
+    this->_size = size;
+#endif /* defined(_WIN32) */
+}
@@ -0,0 +1,116 @@
+﻿// <copyright file="shared_memory_segment.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#endif /* defined(_WIN32) */
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A named segment of memory that is shared between processes.
+    /// </summary>
+    /// <remarks>
+    /// <para>On Windows, the segment is a named file mapping backed by the
+    /// paging file, which exists as long as any process has it open. On
+    /// other platforms, the segment is a POSIX shared memory object named
+    /// after the UTF-8 representation of the name with a leading slash. The
+    /// object is removed when the process that created it closes it, but
+    /// processes that have it mapped can continue using it.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API shared_memory_segment final {
+
+    public:
+
+        /// <summary>
+        /// Initialises a new instance without any segment.
+        /// </summary>
+        shared_memory_segment(void) noexcept;
+
+        shared_memory_segment(const shared_memory_segment&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~shared_memory_segment(void);
+
+        /// <summary>
+        /// Unmaps the segment and removes it if it has been created by this
+        /// instance.
+        /// </summary>
+        void close(void) noexcept;
+
+        /// <summary>
+        /// Creates a new segment of the given size, replacing any stale
+        /// segment of the same name on platforms where segments survive their
+        /// creator.
+        /// </summary>
+        /// <param name="name">The name of the segment.</param>
+        /// <param name="size">The size of the segment in bytes.</param>
+        /// <exception cref="std::invalid_argument">If <paramref name="name" />
+        /// is <c>nullptr</c> or empty, or if <paramref name="size" /> is zero.
+        /// </exception>
+        /// <exception cref="std::system_error">If the segment could not be
+        /// created or mapped, including the case that another process has
+        /// already created a segment of the same name on Windows.</exception>
+        void create(_In_z_ const wchar_t *name, _In_ const std::size_t size);
+
+        /// <summary>
+        /// Answer the begin of the mapped segment.
+        /// </summary>
+        /// <returns>The begin of the segment, or <c>nullptr</c> if no
+        /// segment is mapped.</returns>
+        inline void *data(void) const noexcept {
+            return this->_data;
+        }
+
+        /// <summary>
+        /// Maps an existing segment.
+        /// </summary>
+        /// <param name="name">The name of the segment.</param>
+        /// <param name="writable">Whether the segment is mapped for writing.
+        /// </param>
+        /// <exception cref="std::invalid_argument">If <paramref name="name" />
+        /// is <c>nullptr</c> or empty.</exception>
+        /// <exception cref="std::system_error">If the segment does not exist
+        /// or could not be mapped.</exception>
+        void open(_In_z_ const wchar_t *name, _In_ const bool writable = false);
+
+        /// <summary>
+        /// Answer the size of the mapped segment.
+        /// </summary>
+        /// <returns>The size in bytes, which is zero if no segment is mapped.
+        /// </returns>
+        inline std::size_t size(void) const noexcept {
+            return this->_size;
+        }
+
+        shared_memory_segment& operator =(
+            const shared_memory_segment&) = delete;
+
+    private:
+
+        void *_data;
+#if defined(_WIN32)
+        HANDLE _mapping;
+#else /* defined(_WIN32) */
+        char *_name;
+#endif /* defined(_WIN32) */
+        std::size_t _size;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,75 @@
+﻿// <copyright file="socket_functions.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#if defined(_WIN32)
+#include <WinSock2.h>
+#include <WS2tcpip.h>
+#include <Windows.h>
+#else /* defined(_WIN32) */
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif /* defined(_WIN32) */
+
+
+#if !defined(SOCKET_ERROR)
+#define SOCKET_ERROR (-1)
+#endif /* !defined(SOCKET_ERROR) */
+
+#if !defined(INVALID_SOCKET)
+#define INVALID_SOCKET (-1)
+#endif /* !defined(INVALID_SOCKET) */
+
+#if !defined(MSG_NOSIGNAL)
+#define MSG_NOSIGNAL (0)
+#endif /* !defined(MSG_NOSIGNAL) */
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Closes the given socket.
+    /// </summary>
+    /// <remarks>
+    /// The socket is shut down first, which interrupts any thread blocking in
+    /// <c>accept</c> or <c>recv</c> on Linux.
+    /// </remarks>
+    /// <param name="socket">The socket to be closed.</param>
+    template<class TSocket> inline void close_socket(
+            _In_ const TSocket socket) noexcept {
+#if defined(_WIN32)
+        ::shutdown(static_cast<SOCKET>(socket), SD_BOTH);
+        ::closesocket(static_cast<SOCKET>(socket));
+#else /* defined(_WIN32) */
+        ::shutdown(socket, SHUT_RDWR);
+        ::close(socket);
+#endif /* defined(_WIN32) */
+    }
+
+    /// <summary>
+    /// Answer the error code of the last socket operation on the calling
+    /// thread.
+    /// </summary>
+    /// <returns>The error code, which can be used with
+    /// <see cref="std::system_category" />.</returns>
+    inline int get_socket_error(void) noexcept {
+#if defined(_WIN32)
+        return ::WSAGetLastError();
+#else /* defined(_WIN32) */
+        return errno;
+#endif /* defined(_WIN32) */
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
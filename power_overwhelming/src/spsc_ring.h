@@ -0,0 +1,204 @@
+﻿// <copyright file="spsc_ring.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A bounded, lock-free ring buffer for exactly one producer thread and
+    /// exactly one consumer thread.
+    /// </summary>
+    /// <remarks>
+    /// <para>The storage of the ring is allocated once on construction, so
+    /// neither the producer nor the consumer allocate memory in steady state.
+    /// If the ring is full, new elements are dropped and counted as
+    /// overflows.</para>
+    /// <para>Each element is identified by its position, which is the number
+    /// of elements that have been pushed to the ring before it. The position
+    /// of the next element to be pushed can be obtained from any thread via
+    /// <see cref="position" />.</para>
+    /// </remarks>
+    /// <typeparam name="TValue">The type of the elements in the ring.
+    /// </typeparam>
+    template<class TValue> class spsc_ring final {
+
+    public:
+
+        /// <summary>
+        /// The type used to identify elements in the ring.
+        /// </summary>
+        typedef std::uint64_t position_type;
+
+        /// <summary>
+        /// The type of the elements in the ring.
+        /// </summary>
+        typedef TValue value_type;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="capacity">The minimum number of elements the ring can
+        /// hold. The actual capacity will be rounded up to the next power of
+        /// two.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="capacity" /> is zero.</exception>
+        /// <exception cref="std::bad_alloc">If the storage could not be
+        /// allocated.</exception>
+        explicit spsc_ring(_In_ const std::size_t capacity);
+
+        spsc_ring(const spsc_ring&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~spsc_ring(void);
+
+        /// <summary>
+        /// Answer the number of elements the ring can hold.
+        /// </summary>
+        /// <returns>The capacity of the ring.</returns>
+        inline std::size_t capacity(void) const noexcept {
+            return this->_mask + 1;
+        }
+
+        /// <summary>
+        /// Removes all elements before <paramref name="end" /> from the ring
+        /// and passes them on to the given consumer.
+        /// </summary>
+        /// <remarks>
+        /// This method must only be called from the consumer thread.
+        /// </remarks>
+        /// <typeparam name="TConsumer">A functor accepting a
+        /// <c>const value_type&amp;</c> and the <see cref="position_type" />
+        /// of the element.</typeparam>
+        /// <param name="consumer">The consumer to be invoked for each element.
+        /// </param>
+        /// <param name="end">The position of the first element that should not
+        /// be removed. This parameter defaults to the maximum position, i.e.
+        /// all elements currently in the ring are removed.</param>
+        /// <returns>The number of elements that have been removed.</returns>
+        template<class TConsumer>
+        std::size_t drain(TConsumer&& consumer, _In_ const position_type end
+            = (std::numeric_limits<position_type>::max)());
+
+        /// <summary>
+        /// Answer the number of elements that could not be added to the ring
+        /// because it was full.
+        /// </summary>
+        /// <returns>The number of dropped elements.</returns>
+        inline std::uint64_t overflows(void) const noexcept {
+            return this->_overflows.load(std::memory_order_relaxed);
+        }
+
+        /// <summary>
+        /// Answer the position the next element pushed to the ring will have.
+        /// </summary>
+        /// <returns>The number of elements that have been added to the ring
+        /// since its creation.</returns>
+        inline position_type position(void) const noexcept {
+            return this->_head.load(std::memory_order_acquire);
+        }
+
+        /// <summary>
+        /// Adds an element to the ring.
+        /// </summary>
+        /// <remarks>
+        /// This method must only be called from the producer thread.
+        /// </remarks>
+        /// <param name="value">The value to be added.</param>
+        /// <returns>The number of elements in the ring after the element has
+        /// been added, or zero if the ring was full.</returns>
+        std::size_t push(_In_ const value_type& value);
+
+        /// <summary>
+        /// Answer the number of elements currently in the ring.
+        /// </summary>
+        /// <remarks>
+        /// If called from a thread other than the producer or the consumer,
+        /// the result is only a snapshot.
+        /// </remarks>
+        /// <returns>The number of elements in the ring.</returns>
+        inline std::size_t size(void) const noexcept {
+            return static_cast<std::size_t>(
+                this->_head.load(std::memory_order_acquire)
+                - this->_tail.load(std::memory_order_acquire));
+        }
+
+        /// <summary>
+        /// Answer the storage of the elements, which has been allocated on
+        /// construction and never changes.
+        /// </summary>
+        /// <remarks>
+        /// The storage is exposed such that it can be locked into physical
+        /// memory. The elements themselves must only be accessed via
+        /// <see cref="push" /> and <see cref="drain" />.
+        /// </remarks>
+        /// <returns>The begin of the storage.</returns>
+        inline void *storage(void) noexcept {
+            return this->_storage.get();
+        }
+
+        /// <summary>
+        /// Answer the size of <see cref="storage" /> in bytes.
+        /// </summary>
+        /// <returns>The size of the storage.</returns>
+        inline std::size_t storage_size(void) const noexcept {
+            return this->capacity() * sizeof(storage_type);
+        }
+
+        spsc_ring& operator =(const spsc_ring&) = delete;
+
+    private:
+
+        /// <summary>
+        /// The size of a cache line we assume to separate the positions of
+        /// the producer and the consumer.
+        /// </summary>
+        static constexpr std::size_t cache_line = 64;
+
+        /// <summary>
+        /// Uninitialised storage for a single element.
+        /// </summary>
+        typedef typename std::aligned_storage<sizeof(value_type),
+            alignof(value_type)>::type storage_type;
+
+        /// <summary>
+        /// Answer the element at <paramref name="position" />.
+        /// </summary>
+        inline value_type *at(_In_ const position_type position) noexcept {
+            auto slot = this->_storage.get() + (position & this->_mask);
+            return reinterpret_cast<value_type *>(slot);
+        }
+
+        std::size_t _mask;
+        std::atomic<std::uint64_t> _overflows;
+        std::unique_ptr<storage_type[]> _storage;
+        char _padding0[cache_line];
+        std::atomic<position_type> _head;
+        char _padding1[cache_line - sizeof(std::atomic<position_type>)];
+        std::atomic<position_type> _tail;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+#include "spsc_ring.inl"
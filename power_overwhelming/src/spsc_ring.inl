@@ -0,0 +1,89 @@
+﻿// <copyright file="spsc_ring.inl" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+
+/*
+ * visus::power_overwhelming::detail::spsc_ring<TValue>::spsc_ring
+ */
+template<class TValue>
+visus::power_overwhelming::detail::spsc_ring<TValue>::spsc_ring(
+        _In_ const std::size_t capacity)
+        : _mask(1), _overflows(0), _head(0), _tail(0) {
+    if (capacity == 0) {
+        throw std::invalid_argument("The capacity of a ring buffer must be "
+            "positive.");
+    }
+
+    while (this->_mask < capacity) {
+        this->_mask <<= 1;
+    }
+
+    this->_storage.reset(new storage_type[this->_mask]);
+    --this->_mask;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::spsc_ring<TValue>::~spsc_ring
+ */
+template<class TValue>
+visus::power_overwhelming::detail::spsc_ring<TValue>::~spsc_ring(void) {
+    const auto head = this->_head.load(std::memory_order_acquire);
+    for (auto i = this->_tail.load(); i < head; ++i) {
+        this->at(i)->~value_type();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::spsc_ring<TValue>::drain
+ */
+template<class TValue>
+template<class TConsumer>
+std::size_t visus::power_overwhelming::detail::spsc_ring<TValue>::drain(
+        TConsumer&& consumer, _In_ const position_type end) {
+    const auto head = (std::min)(this->_head.load(std::memory_order_acquire),
+        end);
+    auto tail = this->_tail.load(std::memory_order_relaxed);
+
+    if (head <= tail) {
+        return 0;
+    }
+
+    const auto retval = static_cast<std::size_t>(head - tail);
+
+    for (; tail < head; ++tail) {
+        auto value = this->at(tail);
+        consumer(static_cast<const value_type&>(*value), tail);
+        value->~value_type();
+
+        // Release each slot as soon as possible, so that the producer can
+        // continue while we are still working on a large batch.
+        this->_tail.store(tail + 1, std::memory_order_release);
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::spsc_ring<TValue>::push
+ */
+template<class TValue>
+std::size_t visus::power_overwhelming::detail::spsc_ring<TValue>::push(
+        _In_ const value_type& value) {
+    const auto head = this->_head.load(std::memory_order_relaxed);
+    const auto tail = this->_tail.load(std::memory_order_acquire);
+
+    if (head - tail > this->_mask) {
+        this->_overflows.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+
+    new (this->at(head)) value_type(value);
+    this->_head.store(head + 1, std::memory_order_release);
+
+    return static_cast<std::size_t>(head + 1 - tail);
+}
@@ -5,12 +5,18 @@
 
 #include "power_overwhelming/stable_power_state_scope.h"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <exception>
 #include <stdexcept>
 #include <system_error>
+#include <thread>
 #include <vector>
 
+#include "clock_settle_detector.h"
 #include "com_error_category.h"
+#include "gpu_clock_monitor.h"
 #include "safe_com.h"
 
 
@@ -23,13 +29,37 @@ visus::power_overwhelming::stable_power_state_scope::stable_power_state_scope(
     devices.resize(graphics_device::all(nullptr, 0, true));
     graphics_device::all(devices.data(), devices.size(), true);
 
-    for (auto it = devices.begin(); it != devices.end(); ) {
-        auto d = static_cast<graphics_device::device_type *>(*it);
-        if (d != nullptr) {
-            this->enable(d);
-            ++it;
-        } else {
-            it = devices.erase(it);
+    devices.erase(std::remove_if(devices.begin(), devices.end(),
+        [](graphics_device& d) {
+            return (static_cast<graphics_device::device_type *>(d)
+                == nullptr);
+        }), devices.end());
+
+    // Enabling the stable power state blocks until the driver has
+    // reconfigured the device, so we do that for all devices at once.
+    {
+        std::vector<std::exception_ptr> errors(devices.size());
+        std::vector<std::thread> threads;
+        threads.reserve(devices.size());
+
+        for (std::size_t i = 0; i < devices.size(); ++i) {
+            threads.emplace_back([this, &devices, &errors, i](void) {
+                try {
+                    this->enable(devices[i]);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            });
+        }
+
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        for (auto& e : errors) {
+            if (e != nullptr) {
+                std::rethrow_exception(e);
+            }
         }
     }
 
@@ -63,6 +93,40 @@ visus::power_overwhelming::stable_power_state_scope::~stable_power_state_scope(
 }
 
 
+/*
+ * visus::power_overwhelming::stable_power_state_scope::wait_for_stable_clocks
+ */
+bool visus::power_overwhelming::stable_power_state_scope::wait_for_stable_clocks(
+        _In_ const std::uint32_t timeout,
+        _In_ const std::uint32_t interval,
+        _In_ const std::size_t window,
+        _In_ const float tolerance) const {
+    typedef std::chrono::steady_clock clock_type;
+    detail::clock_settle_detector detector(window, tolerance);
+    const auto deadline = clock_type::now()
+        + std::chrono::milliseconds(timeout);
+    const detail::gpu_clock_monitor monitor;
+    std::vector<detail::gpu_clock_monitor::clock_type> clocks;
+
+    if (monitor.size() < 1) {
+        return false;
+    }
+
+    while (true) {
+        monitor.sample(clocks);
+        if (detector.push(clocks.data(), clocks.size())) {
+            return true;
+        }
+
+        if (clock_type::now() >= deadline) {
+            return false;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+    }
+}
+
+
 /*
  * visus::power_overwhelming::stable_power_state_scope::enable
  */
@@ -0,0 +1,130 @@
+﻿// <copyright file="start_barrier.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "start_barrier.h"
+
+#include <stdexcept>
+
+
+/*
+ * visus::power_overwhelming::detail::start_barrier::arm
+ */
+void visus::power_overwhelming::detail::start_barrier::arm(void) {
+    std::lock_guard<decltype(_lock)> l(_lock);
+    ++_armed;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::start_barrier::armed
+ */
+bool visus::power_overwhelming::detail::start_barrier::armed(void) {
+    std::lock_guard<decltype(_lock)> l(_lock);
+    return (_armed > 0);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::start_barrier::armed
+ */
+bool visus::power_overwhelming::detail::start_barrier::armed(
+        _Out_ std::uint64_t& generation) {
+    std::lock_guard<decltype(_lock)> l(_lock);
+    generation = _generation;
+    return (_armed > 0);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::start_barrier::release
+ */
+visus::power_overwhelming::detail::start_barrier::clock_type::time_point
+visus::power_overwhelming::detail::start_barrier::release(void) {
+    std::lock_guard<decltype(_lock)> l(_lock);
+
+    if (_armed == 0) {
+        throw std::logic_error("The start barrier cannot be released, because "
+            "it has not been armed.");
+    }
+
+    if (--_armed > 0) {
+        return clock_type::now();
+    }
+
+    _origin = clock_type::now();
+    ++_generation;
+    _cv.notify_all();
+
+    return _origin;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::start_barrier::released
+ */
+bool visus::power_overwhelming::detail::start_barrier::released(
+        _In_ const std::uint64_t generation,
+        _Out_ clock_type::time_point& origin) {
+    std::lock_guard<decltype(_lock)> l(_lock);
+    const auto retval = (_generation != generation);
+
+    if (retval) {
+        origin = _origin;
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::start_barrier::wait
+ */
+visus::power_overwhelming::detail::start_barrier::clock_type::time_point
+visus::power_overwhelming::detail::start_barrier::wait(void) {
+    std::unique_lock<decltype(_lock)> l(_lock);
+
+    if (_armed == 0) {
+        return clock_type::now();
+    }
+
+    // Wait for the generation to change rather than for the barrier to be
+    // disarmed, because it might have been armed again before we wake up.
+    const auto generation = _generation;
+    _cv.wait(l, [generation](void) { return (_generation != generation); });
+
+    return _origin;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::start_barrier::_armed
+ */
+std::size_t visus::power_overwhelming::detail::start_barrier::_armed = 0;
+
+
+/*
+ * visus::power_overwhelming::detail::start_barrier::_cv
+ */
+std::condition_variable visus::power_overwhelming::detail::start_barrier::_cv;
+
+
+/*
+ * visus::power_overwhelming::detail::start_barrier::_generation
+ */
+std::uint64_t visus::power_overwhelming::detail::start_barrier::_generation
+    = 0;
+
+
+/*
+ * visus::power_overwhelming::detail::start_barrier::_lock
+ */
+std::mutex visus::power_overwhelming::detail::start_barrier::_lock;
+
+
+/*
+ * visus::power_overwhelming::detail::start_barrier::_origin
+ */
+visus::power_overwhelming::detail::start_barrier::clock_type::time_point
+visus::power_overwhelming::detail::start_barrier::_origin;
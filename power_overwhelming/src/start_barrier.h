@@ -0,0 +1,117 @@
+﻿// <copyright file="start_barrier.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <condition_variable>
+#include <cinttypes>
+#include <mutex>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+#include "periodic_timer.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A process-wide barrier that holds back sampler threads while multiple
+    /// sensors are being started.
+    /// </summary>
+    /// <remarks>
+    /// <para>Starting a sensor might take several milliseconds, for instance
+    /// if it requires round-trips to an instrument. In order to make sure that
+    /// all sensors start on the same tick, the barrier is armed before the
+    /// first sensor is started and released after the last one has been
+    /// started. Sampler threads that start in between block in
+    /// <see cref="wait" /> until the barrier is released and start their
+    /// timers from the instant of the release.</para>
+    /// <para>The barrier can be armed multiple times, in which case it must be
+    /// released as often as it has been armed before the threads continue.
+    /// </para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API start_barrier final {
+
+    public:
+
+        /// <summary>
+        /// The clock used to express the instant of the release.
+        /// </summary>
+        typedef periodic_timer::clock_type clock_type;
+
+        /// <summary>
+        /// Arms the barrier such that subsequent calls to <see cref="wait" />
+        /// block until it is released.
+        /// </summary>
+        static void arm(void);
+
+        /// <summary>
+        /// Answer whether the barrier is armed.
+        /// </summary>
+        /// <returns><c>true</c> if <see cref="wait" /> would block,
+        /// <c>false</c> otherwise.</returns>
+        static bool armed(void);
+
+        /// <summary>
+        /// Answer whether the barrier is armed and if so, the generation that
+        /// can be passed to <see cref="released" />.
+        /// </summary>
+        /// <param name="generation">Receives the current generation of the
+        /// barrier.</param>
+        /// <returns><c>true</c> if <see cref="wait" /> would block,
+        /// <c>false</c> otherwise.</returns>
+        static bool armed(_Out_ std::uint64_t& generation);
+
+        /// <summary>
+        /// Releases the barrier once.
+        /// </summary>
+        /// <returns>The instant at which the waiting threads have been
+        /// released. If the barrier is still armed by another caller, this is
+        /// the current time.</returns>
+        /// <exception cref="std::logic_error">If the barrier has not been
+        /// armed.</exception>
+        static clock_type::time_point release(void);
+
+        /// <summary>
+        /// Answer without blocking whether a thread that is waiting since the
+        /// barrier was in the given generation would have been released.
+        /// </summary>
+        /// <remarks>
+        /// This method allows for waiting on the barrier without blocking a
+        /// thread that has other work to do, like the workers of the
+        /// <see cref="sampler_scheduler" />.
+        /// </remarks>
+        /// <param name="generation">The generation obtained from
+        /// <see cref="armed" />.</param>
+        /// <param name="origin">Receives the instant at which the barrier has
+        /// been released if the method returns <c>true</c>.</param>
+        /// <returns><c>true</c> if the barrier has been released since,
+        /// <c>false</c> if it is still armed.</returns>
+        static bool released(_In_ const std::uint64_t generation,
+            _Out_ clock_type::time_point& origin);
+
+        /// <summary>
+        /// Blocks the calling thread while the barrier is armed.
+        /// </summary>
+        /// <returns>The instant at which the barrier has been released, or the
+        /// current time if the barrier was not armed.</returns>
+        static clock_type::time_point wait(void);
+
+        start_barrier(void) = delete;
+
+    private:
+
+        static std::size_t _armed;
+        static std::condition_variable _cv;
+        static std::uint64_t _generation;
+        static std::mutex _lock;
+        static clock_type::time_point _origin;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,33 @@
+﻿// <copyright file="start_record.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "start_record.h"
+
+#include "power_overwhelming/csv_iomanip.h"
+#include "power_overwhelming/quote.h"
+
+
+/*
+ * visus::power_overwhelming::detail::write_csv
+ */
+std::wostream& visus::power_overwhelming::detail::write_csv(
+        _In_ std::wostream& stream, _In_ const start_record& record) {
+    const auto delimiter = getcsvdelimiter(stream);
+    const auto quote_char = getcsvquote(stream);
+
+    stream << L"# start" << delimiter << record.timestamp << L'\n';
+
+    for (auto& l : record.latencies) {
+        stream << L"# start latency" << delimiter;
+        if (quote_char != 0) {
+            stream << quote(l.first.c_str(), quote_char);
+        } else {
+            stream << l.first;
+        }
+        stream << delimiter << l.second << L'\n';
+    }
+
+    return stream;
+}
@@ -0,0 +1,68 @@
+﻿// <copyright file="start_record.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "power_overwhelming/measurement.h"
+#include "power_overwhelming/sensor.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Describes when a collector has started sampling and how long it took to
+    /// start each of its sensors.
+    /// </summary>
+    struct POWER_OVERWHELMING_API start_record final {
+
+        /// <summary>
+        /// The type to store the start latency of a sensor, which is the name
+        /// of the sensor and the time in microseconds it took to start it.
+        /// </summary>
+        typedef std::pair<std::wstring, sensor::microseconds_type>
+            latency_type;
+
+        /// <summary>
+        /// The time it took to start each of the sensors.
+        /// </summary>
+        std::vector<latency_type> latencies;
+
+        /// <summary>
+        /// The timestamp at which all sensors have been released to take their
+        /// first sample. Samples before this timestamp are discarded.
+        /// </summary>
+        measurement::timestamp_type timestamp;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        inline start_record(void) : timestamp(0) { }
+    };
+
+    /// <summary>
+    /// Writes the start record as comment lines preceding the CSV header.
+    /// </summary>
+    /// <remarks>
+    /// The first line holds the keyword <c>start</c> and the start timestamp.
+    /// Each of the following lines holds the keyword <c>start latency</c>, the
+    /// name of a sensor and its start latency in microseconds. All lines start
+    /// with a hash sign such that CSV readers can skip them as comments.
+    /// </remarks>
+    /// <param name="stream">The stream to write to.</param>
+    /// <param name="record">The record to be written.</param>
+    /// <returns><paramref name="stream" />.</returns>
+    POWER_OVERWHELMING_API std::wostream& write_csv(
+        _In_ std::wostream& stream, _In_ const start_record& record);
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
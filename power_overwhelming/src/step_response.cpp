@@ -0,0 +1,204 @@
+﻿// <copyright file="step_response.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "step_response.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cwchar>
+
+#include "sensor_name_registry.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Computes the mean and the standard deviation of the power in the
+    /// samples within [<paramref name="begin" />, <paramref name="end" />).
+    /// </summary>
+    template<class TIterator>
+    static std::size_t level_of(_Out_ double& mean, _Out_ double& deviation,
+            _In_ TIterator first, _In_ const TIterator last,
+            _In_ const measurement::timestamp_type begin,
+            _In_ const measurement::timestamp_type end) {
+        double sum = 0.0;
+        double squares = 0.0;
+        std::size_t retval = 0;
+
+        for (; first != last; ++first) {
+            if ((first->first >= begin) && (first->first < end)) {
+                sum += first->second;
+                squares += static_cast<double>(first->second) * first->second;
+                ++retval;
+            }
+        }
+
+        mean = (retval > 0) ? sum / retval : 0.0;
+        deviation = (retval > 0)
+            ? std::sqrt((std::max)(0.0, squares / retval - mean * mean))
+            : 0.0;
+        return retval;
+    }
+
+
+    /// <summary>
+    /// Answer the median of the given values, which must not be empty.
+    /// </summary>
+    template<class TValue>
+    static TValue median_of(_Inout_ std::vector<TValue>& values) {
+        assert(!values.empty());
+        const auto mid = values.begin() + values.size() / 2;
+        std::nth_element(values.begin(), mid, values.end());
+        return *mid;
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::step_response_estimator::estimate
+ */
+std::vector<visus::power_overwhelming::detail::step_response>
+visus::power_overwhelming::detail::step_response_estimator::estimate(
+        void) const {
+    static constexpr double fractions[] = { 0.1, 0.5, 0.9 };
+    static constexpr std::size_t cnt_fractions = sizeof(fractions)
+        / sizeof(*fractions);
+    std::vector<step_response> retval;
+    retval.reserve(this->_samples.size());
+
+    auto steps = this->_steps;
+    std::sort(steps.begin(), steps.end());
+
+    for (auto& s : this->_samples) {
+        auto& series = s.second;
+        std::vector<float> amplitudes;
+        std::vector<timestamp_type> delays;
+        std::vector<timestamp_type> rise_times;
+
+        step_response response;
+        response.amplitude = 0.0f;
+        response.delay = 0;
+        response.edges = 0;
+        response.rise_time = 0;
+        response.sensor = s.first;
+
+        for (std::size_t i = 0; (i < steps.size()) && !series.empty(); ++i) {
+            // The phases around a step end at the adjacent steps or at the
+            // first and last sample if there are none.
+            const auto t0 = steps[i];
+            const auto before = (i > 0) ? steps[i - 1] : series.front().first;
+            const auto after = (i + 1 < steps.size())
+                ? steps[i + 1]
+                : series.back().first + 1;
+            if ((before >= t0) || (after <= t0)) {
+                continue;
+            }
+
+            double low, low_deviation;
+            double high, high_deviation;
+            const auto cnt_low = level_of(low, low_deviation, series.begin(),
+                series.end(), t0 - (t0 - before) / 2, t0);
+            const auto cnt_high = level_of(high, high_deviation,
+                series.begin(), series.end(), t0 + (after - t0) / 2, after);
+            const auto amplitude = high - low;
+            if ((cnt_low == 0) || (cnt_high == 0) || (std::abs(amplitude)
+                    <= 3.0 * (std::max)(low_deviation, high_deviation))) {
+                continue;
+            }
+
+            // Find the crossings starting from the last sample before the
+            // step, which might be interpolated with the first one after it.
+            auto it = std::lower_bound(series.begin(), series.end(), t0,
+                [](const series_type::value_type& l, const timestamp_type r) {
+                    return (l.first < r);
+                });
+            if (it != series.begin()) {
+                --it;
+            }
+
+            timestamp_type crossings[cnt_fractions];
+            std::size_t c = 0;
+            auto prev_t = it->first;
+            auto prev_r = (it->second - low) / amplitude;
+
+            for (; (c < cnt_fractions) && (it != series.end())
+                    && (it->first < after); ++it) {
+                const auto r = (it->second - low) / amplitude;
+                while ((c < cnt_fractions) && (r >= fractions[c])) {
+                    auto t = static_cast<double>(it->first);
+                    if ((r > prev_r) && (prev_r < fractions[c])) {
+                        t = prev_t + (fractions[c] - prev_r) / (r - prev_r)
+                            * static_cast<double>(it->first - prev_t);
+                    }
+                    crossings[c++] = (std::max)(t0,
+                        static_cast<timestamp_type>(std::floor(t + 0.5)));
+                }
+
+                prev_t = it->first;
+                prev_r = r;
+            }
+
+            if (c == cnt_fractions) {
+                amplitudes.push_back(static_cast<float>(std::abs(amplitude)));
+                delays.push_back(crossings[1] - t0);
+                rise_times.push_back(crossings[2] - crossings[0]);
+            }
+        }
+
+        response.edges = delays.size();
+        if (response.edges > 0) {
+            response.amplitude = median_of(amplitudes);
+            response.delay = median_of(delays);
+            response.rise_time = median_of(rise_times);
+        }
+
+        retval.push_back(response);
+    }
+
+    std::sort(retval.begin(), retval.end(),
+        [](const step_response& l, const step_response& r) {
+            return (::wcscmp(l.sensor, r.sensor) < 0);
+        });
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::step_response_estimator::push
+ */
+void visus::power_overwhelming::detail::step_response_estimator::push(
+        _In_ const measurement& sample) {
+    if (sample.sensor() != nullptr) {
+        auto sensor = sensor_name_registry::intern(sample.sensor());
+        this->_samples[sensor].emplace_back(sample.timestamp(),
+            static_cast<float>(sample.power()));
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::step_response_estimator::reset
+ */
+void visus::power_overwhelming::detail::step_response_estimator::reset(
+        void) noexcept {
+    this->_samples.clear();
+    this->_steps.clear();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::step_response_estimator::step
+ */
+void visus::power_overwhelming::detail::step_response_estimator::step(
+        _In_ const timestamp_type timestamp) {
+    this->_steps.push_back(timestamp);
+}
@@ -0,0 +1,129 @@
+﻿// <copyright file="step_response.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "power_overwhelming/measurement.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The response of a sensor to steps of the load, which the
+    /// <see cref="step_response_estimator" /> determined.
+    /// </summary>
+    struct POWER_OVERWHELMING_API step_response final {
+
+        /// <summary>
+        /// The median difference between the power before and after the
+        /// steps in Watts.
+        /// </summary>
+        float amplitude;
+
+        /// <summary>
+        /// The median time from the steps until the power has reached half of
+        /// the <see cref="amplitude" />.
+        /// </summary>
+        /// <remarks>
+        /// This is the shift that moves the timestamps of the sensor to the
+        /// instants the power actually changed, which is consistent with the
+        /// latency that the <see cref="timestamp_aligner" /> estimates for
+        /// sensors averaging over a period.
+        /// </remarks>
+        measurement::timestamp_type delay;
+
+        /// <summary>
+        /// The number of steps the sensor responded to, which is zero if the
+        /// change of power could not be distinguished from the noise.
+        /// </summary>
+        std::size_t edges;
+
+        /// <summary>
+        /// The median time the power needed to rise from 10 % to 90 % of the
+        /// <see cref="amplitude" />.
+        /// </summary>
+        measurement::timestamp_type rise_time;
+
+        /// <summary>
+        /// The interned name of the sensor.
+        /// </summary>
+        const wchar_t *sensor;
+    };
+
+
+    /// <summary>
+    /// Estimates the delay and the rise time of sensors from their response
+    /// to steps of the load.
+    /// </summary>
+    /// <remarks>
+    /// <para>Sensors lag the actual power by different amounts, because
+    /// they average internally, report on the schedule of the firmware or
+    /// need time for the conversion. The estimator receives the samples of
+    /// all sensors and the instants at which the load has been switched
+    /// between two levels. For each step, the settled second halves of the
+    /// phases before and after the step determine the two levels of power,
+    /// and the crossings of 10 %, 50 % and 90 % of the difference are
+    /// interpolated linearly between the samples. Steps where the
+    /// difference is not larger than three times the noise in the settled
+    /// phases are ignored.</para>
+    /// <para>All timestamps must use the same resolution, which is also the
+    /// resolution of the results.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API step_response_estimator final {
+
+    public:
+
+        /// <summary>
+        /// The type of the timestamps.
+        /// </summary>
+        typedef measurement::timestamp_type timestamp_type;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        step_response_estimator(void) = default;
+
+        /// <summary>
+        /// Estimates the response of all sensors with samples.
+        /// </summary>
+        /// <returns>The responses ordered by the names of the sensors.
+        /// </returns>
+        std::vector<step_response> estimate(void) const;
+
+        /// <summary>
+        /// Adds a sample of a sensor.
+        /// </summary>
+        /// <param name="sample">The sample to be added. Samples of a sensor
+        /// must be added in chronological order.</param>
+        void push(_In_ const measurement& sample);
+
+        /// <summary>
+        /// Discards all samples and steps.
+        /// </summary>
+        void reset(void) noexcept;
+
+        /// <summary>
+        /// Records that the load has been switched at the given instant.
+        /// </summary>
+        /// <param name="timestamp">The time of the step.</param>
+        void step(_In_ const timestamp_type timestamp);
+
+    private:
+
+        typedef std::vector<std::pair<timestamp_type, float>> series_type;
+
+        std::unordered_map<const wchar_t *, series_type> _samples;
+        std::vector<timestamp_type> _steps;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -8,6 +8,104 @@
 #include <stdexcept>
 
 
+/*
+ * visus::power_overwhelming::detail::append_from_utf8
+ */
+void visus::power_overwhelming::detail::append_from_utf8(
+        _Inout_ std::wstring& dst, _In_z_ const char *str) {
+    assert(str != nullptr);
+    auto s = reinterpret_cast<const std::uint8_t *>(str);
+
+    while (*s != 0) {
+        std::uint32_t c = *s++;
+        std::size_t follow = 0;
+        std::uint32_t minimum = 0;
+
+        if (c >= 0xF0) {
+            follow = 3;
+            minimum = 0x10000;
+            c &= 0x07;
+        } else if (c >= 0xE0) {
+            follow = 2;
+            minimum = 0x800;
+            c &= 0x0F;
+        } else if (c >= 0xC0) {
+            follow = 1;
+            minimum = 0x80;
+            c &= 0x1F;
+        } else if (c >= 0x80) {
+            // This is a continuation byte without a lead byte.
+            c = 0xFFFD;
+        }
+
+        for (; follow > 0; --follow) {
+            if ((*s & 0xC0) != 0x80) {
+                // The sequence is truncated, but the next byte might start a
+                // valid one, wherefore we must not skip it.
+                c = 0xFFFD;
+                break;
+            }
+            c = (c << 6) | (*s++ & 0x3F);
+        }
+
+        // Reject overlong encodings, surrogates and values beyond Unicode.
+        if ((c != 0xFFFD) && ((c < minimum) || (c > 0x10FFFF)
+                || ((c >= 0xD800) && (c < 0xE000)))) {
+            c = 0xFFFD;
+        }
+
+        if ((sizeof(wchar_t) == 2) && (c >= 0x10000)) {
+            c -= 0x10000;
+            dst += static_cast<wchar_t>(0xD800 + (c >> 10));
+            dst += static_cast<wchar_t>(0xDC00 + (c & 0x3FF));
+        } else {
+            dst += static_cast<wchar_t>(c);
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::append_utf8
+ */
+void visus::power_overwhelming::detail::append_utf8(
+        _Inout_ std::string& dst, _In_z_ const wchar_t *str) {
+    assert(str != nullptr);
+
+    for (; *str != 0; ++str) {
+        auto c = static_cast<std::uint32_t>(*str);
+
+        if ((sizeof(wchar_t) == 2) && (c >= 0xD800) && (c < 0xE000)) {
+            // Combine surrogate pairs from UTF-16 and replace any lone
+            // surrogate with the replacement character.
+            const auto n = static_cast<std::uint32_t>(str[1]);
+            if ((c < 0xDC00) && (n >= 0xDC00) && (n < 0xE000)) {
+                c = 0x10000 + ((c - 0xD800) << 10) + (n - 0xDC00);
+                ++str;
+            } else {
+                c = 0xFFFD;
+            }
+        }
+
+        if (c < 0x80) {
+            dst += static_cast<char>(c);
+        } else if (c < 0x800) {
+            dst += static_cast<char>(0xC0 | (c >> 6));
+            dst += static_cast<char>(0x80 | (c & 0x3F));
+        } else if (c < 0x10000) {
+            dst += static_cast<char>(0xE0 | (c >> 12));
+            dst += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            dst += static_cast<char>(0x80 | (c & 0x3F));
+        } else {
+            dst += static_cast<char>(0xF0 | (c >> 18));
+            dst += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+            dst += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            dst += static_cast<char>(0x80 | (c & 0x3F));
+        }
+    }
+}
+
+
 /*
  * visus::power_overwhelming::detail::safe_duplicate
  */
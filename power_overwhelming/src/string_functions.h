@@ -25,6 +25,35 @@ namespace visus {
 namespace power_overwhelming {
 namespace detail {
 
+    /// <summary>
+    /// Appends the UTF-8 encoding of <paramref name="str" /> to
+    /// <paramref name="dst" />.
+    /// </summary>
+    /// <remarks>
+    /// In contrast to <see cref="convert_string" />, the result does not
+    /// depend on the locale. Lone surrogates in UTF-16 input are replaced by
+    /// the replacement character.
+    /// </remarks>
+    /// <param name="dst">The string to append to.</param>
+    /// <param name="str">The string to be encoded.</param>
+    void POWER_OVERWHELMING_API append_utf8(_Inout_ std::string& dst,
+        _In_z_ const wchar_t *str);
+
+    /// <summary>
+    /// Appends the wide string decoded from the UTF-8 string
+    /// <paramref name="str" /> to <paramref name="dst" />.
+    /// </summary>
+    /// <remarks>
+    /// This is the inverse of <see cref="append_utf8" />, which does not
+    /// depend on the locale either. Invalid sequences are replaced by the
+    /// replacement character. Characters outside the basic multilingual plane
+    /// are encoded as surrogate pairs if <c>wchar_t</c> is UTF-16.
+    /// </remarks>
+    /// <param name="dst">The string to append to.</param>
+    /// <param name="str">The UTF-8 string to be decoded.</param>
+    void POWER_OVERWHELMING_API append_from_utf8(_Inout_ std::wstring& dst,
+        _In_z_ const char *str);
+
     /// <summary>
     /// Format the given string into a new string.
     /// </summary>
@@ -0,0 +1,293 @@
+﻿// <copyright file="subscriber_ring.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "subscriber_ring.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+#include "shared_measurement_layout.h"
+
+
+/*
+ * visus::power_overwhelming::detail::subscriber_ring::cache_line
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::subscriber_ring::cache_line;
+
+
+/*
+ * visus::power_overwhelming::detail::subscriber_ring::subscriber_ring
+ */
+visus::power_overwhelming::detail::subscriber_ring::subscriber_ring(
+        _In_ const std::size_t capacity)
+        : _closed(false), _mask(1), _readers(0), _waiters(0), _written(0),
+        _head(0) {
+    if (capacity == 0) {
+        throw std::invalid_argument("The capacity of a subscriber ring must be "
+            "positive.");
+    }
+
+    while (this->_mask < capacity) {
+        this->_mask <<= 1;
+    }
+
+    this->_slots.reset(new slot[this->_mask]);
+    --this->_mask;
+
+    // No slot must look like it holds the sample at position zero.
+    for (std::size_t i = 0; i <= this->_mask; ++i) {
+        this->_slots[i].sequence.store(0, std::memory_order_relaxed);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::subscriber_ring::attach
+ */
+visus::power_overwhelming::detail::subscriber_ring::position_type
+visus::power_overwhelming::detail::subscriber_ring::attach(void) noexcept {
+    this->_readers.fetch_add(1, std::memory_order_relaxed);
+    return this->head();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::subscriber_ring::close
+ */
+void visus::power_overwhelming::detail::subscriber_ring::close(void) {
+    decltype(this->_notifications) notifications;
+
+    {
+        std::lock_guard<decltype(this->_lock)> l(this->_lock);
+        this->_closed.store(true);
+        notifications.swap(this->_notifications);
+        this->_waiters.fetch_sub(notifications.size(),
+            std::memory_order_relaxed);
+    }
+    this->_cv.notify_all();
+
+    for (auto& n : notifications) {
+        n.callback(n.context);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::subscriber_ring::cancel
+ */
+bool visus::power_overwhelming::detail::subscriber_ring::cancel(
+        _In_ const void *owner) noexcept {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    auto it = std::remove_if(this->_notifications.begin(),
+            this->_notifications.end(),
+            [owner](const notification& n) {
+        return (n.owner == owner);
+    });
+
+    const auto retval = (it != this->_notifications.end());
+    this->_waiters.fetch_sub(this->_notifications.end() - it,
+        std::memory_order_relaxed);
+    this->_notifications.erase(it, this->_notifications.end());
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::subscriber_ring::commit
+ */
+void visus::power_overwhelming::detail::subscriber_ring::commit(void) {
+    if (this->_head.load(std::memory_order_relaxed) == this->_written) {
+        return;
+    }
+
+    // The store must be ordered before checking for waiters, which in turn
+    // check the head after registering, such that no wake-up gets lost.
+    this->_head.store(this->_written, std::memory_order_seq_cst);
+
+    if (this->_waiters.load(std::memory_order_seq_cst) > 0) {
+        decltype(this->_notifications) notifications;
+
+        {
+            // Readers that have registered after the head was stored are
+            // already at the new head and must keep waiting.
+            std::lock_guard<decltype(this->_lock)> l(this->_lock);
+            const auto head = this->_head.load(std::memory_order_relaxed);
+            auto it = std::stable_partition(this->_notifications.begin(),
+                    this->_notifications.end(),
+                    [head](const notification& n) {
+                return (n.cursor == head);
+            });
+            notifications.assign(it, this->_notifications.end());
+            this->_notifications.erase(it, this->_notifications.end());
+            this->_waiters.fetch_sub(notifications.size(),
+                std::memory_order_relaxed);
+        }
+        this->_cv.notify_all();
+
+        for (auto& n : notifications) {
+            n.callback(n.context);
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::subscriber_ring::detach
+ */
+void visus::power_overwhelming::detail::subscriber_ring::detach(
+        void) noexcept {
+    assert(this->_readers.load() > 0);
+    this->_readers.fetch_sub(1, std::memory_order_relaxed);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::subscriber_ring::notify
+ */
+bool visus::power_overwhelming::detail::subscriber_ring::notify(
+        _In_ const position_type cursor,
+        _In_ const notification_callback callback,
+        _In_opt_ void *context,
+        _In_ const void *owner) {
+    if (callback == nullptr) {
+        throw std::invalid_argument("The notification callback must not be "
+            "null.");
+    }
+
+    if ((this->head() != cursor) || this->_closed.load()) {
+        return false;
+    }
+
+    // Register as waiter before checking the head again, which pairs with
+    // the writer storing the head before checking for waiters.
+    this->_waiters.fetch_add(1, std::memory_order_seq_cst);
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    if (this->_closed.load()
+            || (this->_head.load(std::memory_order_seq_cst) != cursor)) {
+        this->_waiters.fetch_sub(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    this->_notifications.push_back({ callback, context, cursor, owner });
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::subscriber_ring::push
+ */
+void visus::power_overwhelming::detail::subscriber_ring::push(
+        _In_ const measurement& sample) noexcept {
+    const auto position = this->_written++;
+    auto& slot = this->_slots[position & this->_mask];
+
+    slot.sequence.store(sequence_of(position) - 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.sensor.store(sample.sensor(), std::memory_order_relaxed);
+    slot.timestamp.store(sample.timestamp(), std::memory_order_relaxed);
+    slot.voltage.store(to_shared_bits(sample.voltage()),
+        std::memory_order_relaxed);
+    slot.current.store(to_shared_bits(sample.current()),
+        std::memory_order_relaxed);
+    slot.power.store(to_shared_bits(sample.power()),
+        std::memory_order_relaxed);
+
+    slot.sequence.store(sequence_of(position), std::memory_order_release);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::subscriber_ring::read
+ */
+std::size_t visus::power_overwhelming::detail::subscriber_ring::read(
+        _Inout_ position_type& cursor,
+        _In_ const subscriber_overflow policy,
+        _Inout_ std::uint64_t& lost,
+        _Out_writes_opt_(cnt) const wchar_t **sensors,
+        _Out_writes_(cnt) measurement_data *samples,
+        _In_ const std::size_t cnt) const noexcept {
+    assert((samples != nullptr) || (cnt == 0));
+    const auto capacity = static_cast<position_type>(this->capacity());
+    auto head = this->head();
+    std::size_t retval = 0;
+
+    while ((retval < cnt) && (cursor < head)) {
+        if (head - cursor > capacity) {
+            // The writer has lapped us, so the samples from the cursor on are
+            // gone for sure.
+            const auto next = (policy == subscriber_overflow::drop_oldest)
+                ? head - capacity
+                : head;
+            lost += next - cursor;
+            cursor = next;
+            continue;
+        }
+
+        auto& slot = this->_slots[cursor & this->_mask];
+        const auto expected = sequence_of(cursor);
+
+        if (slot.sequence.load(std::memory_order_acquire) == expected) {
+            auto sensor = slot.sensor.load(std::memory_order_relaxed);
+            auto timestamp = slot.timestamp.load(std::memory_order_relaxed);
+            auto voltage = slot.voltage.load(std::memory_order_relaxed);
+            auto current = slot.current.load(std::memory_order_relaxed);
+            auto power = slot.power.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (slot.sequence.load(std::memory_order_relaxed) == expected) {
+                if (sensors != nullptr) {
+                    sensors[retval] = sensor;
+                }
+                samples[retval] = measurement_data(timestamp,
+                    from_shared_bits(voltage),
+                    from_shared_bits(current),
+                    from_shared_bits(power));
+                ++retval;
+                ++cursor;
+                continue;
+            }
+        }
+
+        // The writer has started overwriting the slot with a sample it has
+        // not yet committed, so we are about to be lapped.
+        if (policy == subscriber_overflow::drop_oldest) {
+            ++lost;
+            ++cursor;
+        } else {
+            lost += head - cursor;
+            cursor = head;
+        }
+
+        head = this->head();
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::subscriber_ring::wait
+ */
+bool visus::power_overwhelming::detail::subscriber_ring::wait(
+        _In_ const position_type cursor,
+        _In_ const std::chrono::milliseconds timeout) {
+    if (this->head() != cursor) {
+        return true;
+    }
+
+    this->_waiters.fetch_add(1, std::memory_order_seq_cst);
+    std::unique_lock<decltype(this->_lock)> l(this->_lock);
+    const auto retval = this->_cv.wait_for(l, timeout, [this, cursor](void) {
+        return (this->_closed.load()
+            || (this->_head.load(std::memory_order_seq_cst) != cursor));
+    });
+    l.unlock();
+    this->_waiters.fetch_sub(1, std::memory_order_relaxed);
+
+    return (retval && (this->head() != cursor));
+}
@@ -0,0 +1,276 @@
+﻿// <copyright file="subscriber_ring.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "power_overwhelming/measurement.h"
+#include "power_overwhelming/subscriber_overflow.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A bounded, lock-free ring for broadcasting samples from exactly one
+    /// writer to any number of readers.
+    /// </summary>
+    /// <remarks>
+    /// <para>Unlike <see cref="spsc_ring" />, the ring does not have a tail
+    /// that the writer has to respect. The writer always overwrites the
+    /// oldest slot and each reader keeps its own cursor, such that readers
+    /// can never slow down the writer or one another. Each slot is protected
+    /// by a sequence number like the slots in shared memory: The writer makes
+    /// the sequence odd while it is updating the slot and stores the position
+    /// of the sample afterwards, which allows readers to detect samples that
+    /// have been overwritten while they were being copied.</para>
+    /// <para>The writer publishes the samples it has pushed in a batch via
+    /// <see cref="commit" />, which is the only operation that might wake
+    /// readers blocked in <see cref="wait" />. As long as no reader is
+    /// waiting, neither the writer nor the readers ever take a lock.</para>
+    /// <para>The storage of the ring is allocated once on construction, so
+    /// neither the writer nor the readers allocate memory.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API subscriber_ring final {
+
+    public:
+
+        /// <summary>
+        /// The type used to identify samples in the ring.
+        /// </summary>
+        typedef std::uint64_t position_type;
+
+        /// <summary>
+        /// The type of a callback that is invoked once samples are available.
+        /// </summary>
+        typedef void (*notification_callback)(_In_opt_ void *context);
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="capacity">The minimum number of samples the ring can
+        /// hold. The actual capacity will be rounded up to the next power of
+        /// two.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="capacity" /> is zero.</exception>
+        /// <exception cref="std::bad_alloc">If the storage could not be
+        /// allocated.</exception>
+        explicit subscriber_ring(_In_ const std::size_t capacity);
+
+        subscriber_ring(const subscriber_ring&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~subscriber_ring(void) = default;
+
+        /// <summary>
+        /// Registers a new reader.
+        /// </summary>
+        /// <returns>The position at which the reader starts, which is the
+        /// position of the next sample being committed.</returns>
+        position_type attach(void) noexcept;
+
+        /// <summary>
+        /// Answer the number of samples the ring can hold.
+        /// </summary>
+        /// <returns>The capacity of the ring.</returns>
+        inline std::size_t capacity(void) const noexcept {
+            return this->_mask + 1;
+        }
+
+        /// <summary>
+        /// Marks the ring as closed, which releases all readers blocked in
+        /// <see cref="wait" />.
+        /// </summary>
+        void close(void);
+
+        /// <summary>
+        /// Removes the pending notification registered by
+        /// <paramref name="owner" />.
+        /// </summary>
+        /// <remarks>
+        /// If the callback is running on the writer thread while the method
+        /// is called, it will still complete, so callers must not free the
+        /// context of the callback without synchronising with it.
+        /// </remarks>
+        /// <param name="owner">The owner passed to <see cref="notify" />.
+        /// </param>
+        /// <returns><c>true</c> if a pending notification has been removed,
+        /// <c>false</c> otherwise.</returns>
+        bool cancel(_In_ const void *owner) noexcept;
+
+        /// <summary>
+        /// Publishes all samples pushed since the last call to the readers.
+        /// </summary>
+        /// <remarks>
+        /// This method must only be called by the writer.
+        /// </remarks>
+        void commit(void);
+
+        /// <summary>
+        /// Unregisters a reader that has been registered via
+        /// <see cref="attach" />.
+        /// </summary>
+        void detach(void) noexcept;
+
+        /// <summary>
+        /// Registers a callback that is invoked once when a sample after
+        /// <paramref name="cursor" /> has been committed or the ring has been
+        /// closed.
+        /// </summary>
+        /// <remarks>
+        /// <para>This is the non-blocking counterpart of <see cref="wait" />,
+        /// which allows for resuming a reader on an executor of its choice
+        /// rather than blocking a thread. The callback runs on the thread that
+        /// calls <see cref="commit" /> or <see cref="close" /> and must
+        /// therefore return quickly.</para>
+        /// </remarks>
+        /// <param name="cursor">The position of the reader.</param>
+        /// <param name="callback">The callback to be invoked.</param>
+        /// <param name="context">A user-defined pointer passed to the
+        /// callback.</param>
+        /// <param name="owner">Identifies the registration for
+        /// <see cref="cancel" />.</param>
+        /// <returns><c>true</c> if the callback has been registered,
+        /// <c>false</c> if samples are already available or the ring has been
+        /// closed, in which case the callback will not be invoked.</returns>
+        bool notify(_In_ const position_type cursor,
+            _In_ const notification_callback callback,
+            _In_opt_ void *context,
+            _In_ const void *owner);
+
+        /// <summary>
+        /// Answer the position of the next sample being committed.
+        /// </summary>
+        /// <returns>The number of samples that have been committed so far.
+        /// </returns>
+        inline position_type head(void) const noexcept {
+            return this->_head.load(std::memory_order_acquire);
+        }
+
+        /// <summary>
+        /// Copies a sample into the next slot of the ring, overwriting the
+        /// oldest sample if the ring is full.
+        /// </summary>
+        /// <remarks>
+        /// <para>This method must only be called by the writer. The sample
+        /// is not visible to the readers before <see cref="commit" /> has been
+        /// called.</para>
+        /// <para>Only the pointer to the name of the sensor is copied, so the
+        /// name must remain valid as long as the ring exists, which is the
+        /// case for all names interned by the collector.</para>
+        /// </remarks>
+        /// <param name="sample">The sample to be pushed.</param>
+        void push(_In_ const measurement& sample) noexcept;
+
+        /// <summary>
+        /// Copies the committed samples from <paramref name="cursor" /> on
+        /// into the given buffers and advances the cursor.
+        /// </summary>
+        /// <param name="cursor">The position of the reader, which is
+        /// advanced past the samples returned and lost.</param>
+        /// <param name="policy">Determines where the reader continues if the
+        /// writer has overwritten samples the reader has not yet read.
+        /// </param>
+        /// <param name="lost">Is incremented by the number of samples that
+        /// have been overwritten before they could be read.</param>
+        /// <param name="sensors">Receives the names of the sensors of the
+        /// samples. This parameter may be <c>nullptr</c>.</param>
+        /// <param name="samples">Receives the samples.</param>
+        /// <param name="cnt">The number of samples that the buffers can
+        /// hold.</param>
+        /// <returns>The number of samples copied.</returns>
+        std::size_t read(_Inout_ position_type& cursor,
+            _In_ const subscriber_overflow policy,
+            _Inout_ std::uint64_t& lost,
+            _Out_writes_opt_(cnt) const wchar_t **sensors,
+            _Out_writes_(cnt) measurement_data *samples,
+            _In_ const std::size_t cnt) const noexcept;
+
+        /// <summary>
+        /// Answer whether any reader is registered.
+        /// </summary>
+        /// <returns><c>true</c> if the writer needs to push samples,
+        /// <c>false</c> otherwise.</returns>
+        inline bool subscribed(void) const noexcept {
+            return (this->_readers.load(std::memory_order_relaxed) > 0);
+        }
+
+        /// <summary>
+        /// Blocks the calling reader until a sample after
+        /// <paramref name="cursor" /> has been committed, the ring has been
+        /// closed or the timeout has expired.
+        /// </summary>
+        /// <param name="cursor">The position of the reader.</param>
+        /// <param name="timeout">The maximum time to wait.</param>
+        /// <returns><c>true</c> if samples are available, <c>false</c> if the
+        /// timeout expired or the ring has been closed.</returns>
+        bool wait(_In_ const position_type cursor,
+            _In_ const std::chrono::milliseconds timeout);
+
+        subscriber_ring& operator =(const subscriber_ring&) = delete;
+
+    private:
+
+        /// <summary>
+        /// The size of a cache line we assume to separate the position polled
+        /// by the readers from the data of the writer.
+        /// </summary>
+        static constexpr std::size_t cache_line = 64;
+
+        struct notification final {
+            notification_callback callback;
+            void *context;
+            position_type cursor;
+            const void *owner;
+        };
+
+        /// <summary>
+        /// A slot in the ring holding a single sample.
+        /// </summary>
+        struct slot final {
+            std::atomic<std::uint64_t> sequence;
+            std::atomic<const wchar_t *> sensor;
+            std::atomic<measurement_data::timestamp_type> timestamp;
+            std::atomic<std::uint32_t> voltage;
+            std::atomic<std::uint32_t> current;
+            std::atomic<std::uint32_t> power;
+        };
+
+        /// <summary>
+        /// Answer the sequence number of a completely written slot holding
+        /// the sample at the given position.
+        /// </summary>
+        static inline std::uint64_t sequence_of(
+                _In_ const position_type position) noexcept {
+            return 2 * position + 2;
+        }
+
+        std::atomic<bool> _closed;
+        std::condition_variable _cv;
+        std::mutex _lock;
+        std::size_t _mask;
+        std::vector<notification> _notifications;
+        std::atomic<std::size_t> _readers;
+        std::unique_ptr<slot[]> _slots;
+        std::atomic<std::size_t> _waiters;
+        position_type _written;
+        char _padding0[cache_line];
+        std::atomic<position_type> _head;
+        char _padding1[cache_line - sizeof(std::atomic<position_type>)];
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
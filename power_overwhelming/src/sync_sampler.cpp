@@ -0,0 +1,128 @@
+﻿// <copyright file="sync_sampler.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "sync_sampler.h"
+
+
+/*
+ * visus::power_overwhelming::detail::sync_sampler::add
+ */
+bool visus::power_overwhelming::detail::sync_sampler::add(
+        _In_ const sensor& source,
+        _In_ const measurement_data_callback callback,
+        _In_opt_ void *context,
+        _In_ const interval_type interval,
+        _In_ const interval_type min_interval) {
+    auto name = source.name();
+    if (name == nullptr) {
+        throw std::invalid_argument("A sensor without name cannot be sampled "
+            "asynchronously.");
+    }
+
+    std::lock_guard<decltype(_lock)> l(_lock);
+    {
+        auto it = _adapters.find(&source);
+        if (it != _adapters.end()) {
+            // The sensor is already sampled, so the new subscriber shares the
+            // adapter and thereby the reads of the existing ones.
+            return _sampler.add(it->second.get(), callback, context, interval,
+                min_interval);
+        }
+    }
+
+    std::unique_ptr<sync_sensor_adapter> adapter(new sync_sensor_adapter());
+    adapter->sensor_name = name;
+    adapter->source = &source;
+
+    if (!_sampler.add(adapter.get(), callback, context, interval,
+            min_interval)) {
+        return false;
+    }
+
+    _adapters.emplace(&source, std::move(adapter));
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sync_sampler::remove
+ */
+bool visus::power_overwhelming::detail::sync_sampler::remove(
+        _In_ const sensor& source,
+        _In_opt_ void *context) {
+    std::unique_ptr<sync_sensor_adapter> adapter;
+    auto retval = false;
+
+    if (context != nullptr) {
+        sync_sensor_adapter *shared = nullptr;
+
+        {
+            std::lock_guard<decltype(_lock)> l(_lock);
+            auto it = _adapters.find(&source);
+            if (it == _adapters.end()) {
+                return false;
+            }
+
+            shared = it->second.get();
+        }
+
+        // Do not hold the lock while waiting for the sampler thread, because
+        // a callback on the sampler thread might start sampling another
+        // sensor.
+        retval = _sampler.remove(shared, context);
+
+        {
+            // Release the adapter once its last subscriber is gone unless
+            // someone has subscribed again in the meantime.
+            std::lock_guard<decltype(_lock)> l(_lock);
+            auto it = _adapters.find(&source);
+            if ((it != _adapters.end()) && (it->second.get() == shared)
+                    && !_sampler.samples(shared)) {
+                adapter = std::move(it->second);
+                _adapters.erase(it);
+            }
+        }
+
+    } else {
+        {
+            std::lock_guard<decltype(_lock)> l(_lock);
+            auto it = _adapters.find(&source);
+            if (it == _adapters.end()) {
+                return false;
+            }
+
+            adapter = std::move(it->second);
+            _adapters.erase(it);
+        }
+
+        // Do not hold the lock while waiting for the sampler thread, because
+        // a callback on the sampler thread might start sampling another
+        // sensor.
+        retval = _sampler.remove(adapter.get());
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sync_sampler::_adapters
+ */
+std::map<const visus::power_overwhelming::sensor *,
+    std::unique_ptr<visus::power_overwhelming::detail::sync_sensor_adapter>>
+visus::power_overwhelming::detail::sync_sampler::_adapters;
+
+
+/*
+ * visus::power_overwhelming::detail::sync_sampler::_lock
+ */
+std::mutex visus::power_overwhelming::detail::sync_sampler::_lock;
+
+
+/*
+ * visus::power_overwhelming::detail::sync_sampler::_sampler
+ */
+visus::power_overwhelming::detail::sync_sampler::sampler_type
+visus::power_overwhelming::detail::sync_sampler::_sampler;
@@ -0,0 +1,122 @@
+﻿// <copyright file="sync_sampler.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "power_overwhelming/sensor.h"
+
+#include "sampler.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Adapts an arbitrary <see cref="sensor" /> to the interface that the
+    /// <see cref="default_sampler_context" /> expects from a sensor
+    /// implementation.
+    /// </summary>
+    struct sync_sensor_adapter final {
+
+        /// <summary>
+        /// The name of the sensor.
+        /// </summary>
+        std::wstring sensor_name;
+
+        /// <summary>
+        /// The sensor that is sampled via its synchronous API.
+        /// </summary>
+        const sensor *source;
+
+        /// <summary>
+        /// Synchronously samples <see cref="source" />.
+        /// </summary>
+        inline measurement_data sample(void) const {
+            return this->source->sample_data();
+        }
+    };
+
+
+    /// <summary>
+    /// Samples sensors that have no asynchronous API of their own on a
+    /// generic sampler thread that calls their synchronous API.
+    /// </summary>
+    /// <remarks>
+    /// This is the backend of the default implementation of
+    /// <see cref="sensor::sample_batch" />. In contrast to the samplers of
+    /// the specialised sensors, the sync sampler works on the
+    /// <see cref="sensor" /> interface rather than on a sensor implementation.
+    /// Sensors relying on it must therefore stop the sampling in their
+    /// destructors.
+    /// </remarks>
+    class sync_sampler final {
+
+    public:
+
+        /// <summary>
+        /// The type of the sampler used for the adapted sensors.
+        /// </summary>
+        typedef detail::sampler<default_sampler_context<sync_sensor_adapter>>
+            sampler_type;
+
+        /// <summary>
+        /// The type to express sampling intervals.
+        /// </summary>
+        typedef sampler_type::interval_type interval_type;
+
+        /// <summary>
+        /// Starts sampling the given sensor.
+        /// </summary>
+        /// <param name="source">The sensor to be sampled.</param>
+        /// <param name="callback">The callback receiving the samples.</param>
+        /// <param name="context">A user-defined pointer passed to the
+        /// callback.</param>
+        /// <param name="interval">The sampling interval.</param>
+        /// <param name="min_interval">The shortest sampling interval if the
+        /// rate should adapt to the signal, or zero to sample at the fixed
+        /// <paramref name="interval" />.</param>
+        /// <returns><c>true</c> if the sensor has been added, <c>false</c> if
+        /// it was already being sampled for the same
+        /// <paramref name="context" />.</returns>
+        static bool add(_In_ const sensor& source,
+            _In_ const measurement_data_callback callback,
+            _In_opt_ void *context,
+            _In_ const interval_type interval,
+            _In_ const interval_type min_interval = interval_type::zero());
+
+        /// <summary>
+        /// Stops sampling the given sensor.
+        /// </summary>
+        /// <remarks>
+        /// If the sensor has been removed, the method blocks until the sampler
+        /// thread does not use it anymore.
+        /// </remarks>
+        /// <param name="source">The sensor to be removed.</param>
+        /// <param name="context">The user-defined pointer of the subscriber to
+        /// be removed, or <c>nullptr</c> to remove all subscribers.</param>
+        /// <returns><c>true</c> if the sensor has been removed, <c>false</c> if
+        /// it has not been sampled in the first place.</returns>
+        static bool remove(_In_ const sensor& source,
+            _In_opt_ void *context = nullptr);
+
+        sync_sampler(void) = delete;
+
+    private:
+
+        static std::map<const sensor *, std::unique_ptr<sync_sensor_adapter>>
+            _adapters;
+        static std::mutex _lock;
+        static sampler_type _sampler;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
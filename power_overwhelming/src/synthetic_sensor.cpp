@@ -0,0 +1,326 @@
+﻿// <copyright file="synthetic_sensor.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/synthetic_sensor.h"
+
+#include <cassert>
+#include <memory>
+#include <stdexcept>
+
+#include "synthetic_sensor_impl.h"
+
+
+/*
+ * visus::power_overwhelming::synthetic_sensor::default_amplitude
+ */
+constexpr visus::power_overwhelming::synthetic_sensor::value_type
+visus::power_overwhelming::synthetic_sensor::default_amplitude;
+
+
+/*
+ * visus::power_overwhelming::synthetic_sensor::default_offset
+ */
+constexpr visus::power_overwhelming::synthetic_sensor::value_type
+visus::power_overwhelming::synthetic_sensor::default_offset;
+
+
+/*
+ * visus::power_overwhelming::synthetic_sensor::default_period
+ */
+constexpr visus::power_overwhelming::sensor::microseconds_type
+visus::power_overwhelming::synthetic_sensor::default_period;
+
+
+/*
+ * visus::power_overwhelming::synthetic_sensor::default_voltage
+ */
+constexpr visus::power_overwhelming::synthetic_sensor::value_type
+visus::power_overwhelming::synthetic_sensor::default_voltage;
+
+
+/*
+ * visus::power_overwhelming::synthetic_sensor::for_all
+ */
+std::size_t visus::power_overwhelming::synthetic_sensor::for_all(
+        _Out_writes_opt_(cnt_sensors) synthetic_sensor *out_sensors,
+        _In_ const std::size_t cnt_sensors) {
+    return 0;
+}
+
+
+/*
+ * visus::power_overwhelming::synthetic_sensor::synthetic_sensor
+ */
+visus::power_overwhelming::synthetic_sensor::synthetic_sensor(void)
+    : _impl(new detail::synthetic_sensor_impl()) { }
+
+
+/*
+ * visus::power_overwhelming::synthetic_sensor::synthetic_sensor
+ */
+visus::power_overwhelming::synthetic_sensor::synthetic_sensor(
+        _In_z_ const wchar_t *name,
+        _In_ const synthetic_waveform waveform)
+        : _impl(nullptr) {
+    if ((name == nullptr) || (*name == 0)) {
+        throw std::invalid_argument("A synthetic sensor must have a name.");
+    }
+
+    this->_impl = new detail::synthetic_sensor_impl();
+    this->_impl->sensor_name = name;
+    this->_impl->waveform = waveform;
+}
+
+
+/*
+ * visus::power_overwhelming::synthetic_sensor::~synthetic_sensor
+ */
+visus::power_overwhelming::synthetic_sensor::~synthetic_sensor(void) {
+    // Make sure that neither the dedicated thread nor the generic sampler
+    // thread use the sensor anymore.
+    this->sample_batch(nullptr);
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::synthetic_sensor::amplitude
+ */
+visus::power_overwhelming::synthetic_sensor::value_type
+visus::power_overwhelming::synthetic_sensor::amplitude(void) const {
+    this->check_not_disposed();
+    return this->_impl->amplitude;
+}
+
+
+/*
+ * visus::power_overwhelming::synthetic_sensor::amplitude
+ */
+visus::power_overwhelming::synthetic_sensor&
+visus::power_overwhelming::synthetic_sensor::amplitude(
+        _In_ const value_type amplitude) {
+    this->check_not_disposed();
+    this->_impl->amplitude = amplitude;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::synthetic_sensor::async
+ */
+bool visus::power_overwhelming::synthetic_sensor::async(void) const {
+    this->check_not_disposed();
+    return this->_impl->async;
+}
+
+
+/*
+ * visus::power_overwhelming::synthetic_sensor::async
+ */
+visus::power_overwhelming::synthetic_sensor&
+visus::power_overwhelming::synthetic_sensor::async(_In_ const bool async) {
+    this->check_not_disposed();
+    this->_impl->async = async;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::synthetic_sensor::cost
+ */
+visus::power_overwhelming::sensor::microseconds_type
+visus::power_overwhelming::synthetic_sensor::cost(void) const {
+    this->check_not_disposed();
+    return this->_impl->cost.count();
+}
+
+
+/*
+ * visus::power_overwhelming::synthetic_sensor::cost
+ */
+visus::power_overwhelming::synthetic_sensor&
+visus::power_overwhelming::synthetic_sensor::cost(
+        _In_ const microseconds_type cost) {
+    this->check_not_disposed();
+    this->_impl->cost = std::chrono::microseconds(cost);
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::synthetic_sensor::name
+ */
+_Ret_maybenull_z_
+const wchar_t *visus::power_overwhelming::synthetic_sensor::name(
+        void) const noexcept {
+    return (this->_impl != nullptr)
+        ? this->_impl->sensor_name.c_str()
+        : nullptr;
+}
+
+
+/*
+ * visus::power_overwhelming::synthetic_sensor::offset
+ */
+visus::power_overwhelming::synthetic_sensor::value_type
+visus::power_overwhelming::synthetic_sensor::offset(void) const {
+    this->check_not_disposed();
+    return this->_impl->offset;
+}
+
+
+/*
+ * visus::power_overwhelming::synthetic_sensor::offset
+ */
+visus::power_overwhelming::synthetic_sensor&
+visus::power_overwhelming::synthetic_sensor::offset(
+        _In_ const value_type offset) {
+    this->check_not_disposed();
+    this->_impl->offset = offset;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::synthetic_sensor::period
+ */
+visus::power_overwhelming::sensor::microseconds_type
+visus::power_overwhelming::synthetic_sensor::period(void) const {
+    this->check_not_disposed();
+    return this->_impl->period.count();
+}
+
+
+/*
+ * visus::power_overwhelming::synthetic_sensor::period
+ */
+visus::power_overwhelming::synthetic_sensor&
+visus::power_overwhelming::synthetic_sensor::period(
+        _In_ const microseconds_type period) {
+    if (period <= 0) {
+        throw std::invalid_argument("The period of the waveform must be "
+            "positive.");
+    }
+
+    this->check_not_disposed();
+    this->_impl->period = std::chrono::microseconds(period);
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::synthetic_sensor::sample_batch
+ */
+void visus::power_overwhelming::synthetic_sensor::sample_batch(
+        _In_opt_ const measurement_data_callback on_batch,
+        _In_ const microseconds_type period,
+        _In_opt_ void *context) {
+    if (on_batch != nullptr) {
+        this->check_not_disposed();
+
+        if (!this->_impl->async) {
+            sensor::sample_batch(on_batch, period, context);
+
+        } else if (!this->_impl->start(on_batch,
+                std::chrono::microseconds(period), context)) {
+            throw std::logic_error("Asynchronous sampling cannot be started "
+                "while it is already running.");
+        }
+
+    } else {
+        // We do not know which way the sensor is being sampled if the flag
+        // has been changed in the meantime, so we stop both.
+        if (this->_impl != nullptr) {
+            this->_impl->stop();
+        }
+        sensor::sample_batch(nullptr);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::synthetic_sensor::voltage
+ */
+visus::power_overwhelming::synthetic_sensor::value_type
+visus::power_overwhelming::synthetic_sensor::voltage(void) const {
+    this->check_not_disposed();
+    return this->_impl->voltage;
+}
+
+
+/*
+ * visus::power_overwhelming::synthetic_sensor::voltage
+ */
+visus::power_overwhelming::synthetic_sensor&
+visus::power_overwhelming::synthetic_sensor::voltage(
+        _In_ const value_type voltage) {
+    if (!(voltage > 0.0f)) {
+        throw std::invalid_argument("The voltage of a synthetic sensor must "
+            "be positive.");
+    }
+
+    this->check_not_disposed();
+    this->_impl->voltage = voltage;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::synthetic_sensor::waveform
+ */
+visus::power_overwhelming::synthetic_waveform
+visus::power_overwhelming::synthetic_sensor::waveform(void) const {
+    this->check_not_disposed();
+    return this->_impl->waveform;
+}
+
+
+/*
+ * visus::power_overwhelming::synthetic_sensor::waveform
+ */
+visus::power_overwhelming::synthetic_sensor&
+visus::power_overwhelming::synthetic_sensor::waveform(
+        _In_ const synthetic_waveform waveform) {
+    this->check_not_disposed();
+    this->_impl->waveform = waveform;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::synthetic_sensor::operator =
+ */
+visus::power_overwhelming::synthetic_sensor&
+visus::power_overwhelming::synthetic_sensor::operator =(
+        _In_ synthetic_sensor&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        this->sample_batch(nullptr);
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::synthetic_sensor::operator bool
+ */
+visus::power_overwhelming::synthetic_sensor::operator bool(
+        void) const noexcept {
+    return ((this->_impl != nullptr) && !this->_impl->sensor_name.empty());
+}
+
+
+/*
+ * visus::power_overwhelming::synthetic_sensor::sample_sync
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::synthetic_sensor::sample_sync(
+        _In_ const timestamp_resolution resolution) const {
+    this->check_not_disposed();
+    return this->_impl->sample(resolution);
+}
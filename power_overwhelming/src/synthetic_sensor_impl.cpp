@@ -0,0 +1,172 @@
+﻿// <copyright file="synthetic_sensor_impl.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "synthetic_sensor_impl.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "library_thread.h"
+#include "periodic_timer.h"
+#include "sensor_name_registry.h"
+#include "start_barrier.h"
+#include "timestamp.h"
+
+
+/*
+ * visus::power_overwhelming::detail::synthetic_sensor_impl::max_batch_latency
+ */
+constexpr std::chrono::microseconds
+visus::power_overwhelming::detail::synthetic_sensor_impl::max_batch_latency;
+
+
+/*
+ * ...::detail::synthetic_sensor_impl::synthetic_sensor_impl
+ */
+visus::power_overwhelming::detail::synthetic_sensor_impl::synthetic_sensor_impl(
+        void)
+    : amplitude(synthetic_sensor::default_amplitude), async(false),
+        callback(nullptr), context(nullptr), cost(0), interval(0),
+        offset(synthetic_sensor::default_offset), origin(clock_type::now()),
+        period(synthetic_sensor::default_period), running(false),
+        voltage(synthetic_sensor::default_voltage),
+        waveform(synthetic_waveform::sine) { }
+
+
+/*
+ * ...::detail::synthetic_sensor_impl::~synthetic_sensor_impl
+ */
+visus::power_overwhelming::detail::synthetic_sensor_impl::~synthetic_sensor_impl(
+        void) {
+    this->stop();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::synthetic_sensor_impl::power
+ */
+visus::power_overwhelming::detail::synthetic_sensor_impl::value_type
+visus::power_overwhelming::detail::synthetic_sensor_impl::power(
+        _In_ const clock_type::time_point time) {
+    using namespace std::chrono;
+    assert(this->period.count() > 0);
+    const auto elapsed = duration_cast<microseconds>(time - this->origin);
+    const auto phase = static_cast<double>(elapsed.count()
+        % this->period.count()) / this->period.count();
+    double shape = 0.0;
+
+    switch (this->waveform) {
+        case synthetic_waveform::sine:
+            shape = std::sin(2.0 * 3.14159265358979323846 * phase);
+            break;
+
+        case synthetic_waveform::square:
+            shape = (phase < 0.5) ? 1.0 : -1.0;
+            break;
+
+        case synthetic_waveform::sawtooth:
+            shape = 2.0 * phase - 1.0;
+            break;
+
+        case synthetic_waveform::noise:
+            shape = std::uniform_real_distribution<double>(-1.0, 1.0)(
+                this->generator);
+            break;
+
+        default:
+            break;
+    }
+
+    return static_cast<value_type>(this->offset + this->amplitude * shape);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::synthetic_sensor_impl::sample
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::detail::synthetic_sensor_impl::sample(
+        _In_ const timestamp_resolution resolution) {
+    const auto now = clock_type::now();
+    const auto timestamp = create_timestamp(resolution);
+    const auto power = this->power(now);
+
+    // Simulate an expensive sensor by spinning, because sleeping would give
+    // the time slice away, which real sensors busy with I/O would not.
+    if (this->cost.count() > 0) {
+        const auto deadline = now + this->cost;
+        while (clock_type::now() < deadline);
+    }
+
+    return measurement_data(timestamp, this->voltage, power / this->voltage,
+        power);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::synthetic_sensor_impl::start
+ */
+bool visus::power_overwhelming::detail::synthetic_sensor_impl::start(
+        _In_ const measurement_data_callback callback,
+        _In_ const std::chrono::microseconds interval,
+        _In_opt_ void *context) {
+    assert(callback != nullptr);
+    if (this->thread.joinable()) {
+        return false;
+    }
+
+    this->callback = callback;
+    this->context = context;
+    this->interval = (std::max)(interval, std::chrono::microseconds(1));
+    this->running.store(true, std::memory_order_release);
+    this->thread = std::thread(&synthetic_sensor_impl::run, this);
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::synthetic_sensor_impl::stop
+ */
+void visus::power_overwhelming::detail::synthetic_sensor_impl::stop(void) {
+    this->running.store(false, std::memory_order_release);
+    if (this->thread.joinable()) {
+        this->thread.join();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::synthetic_sensor_impl::run
+ */
+void visus::power_overwhelming::detail::synthetic_sensor_impl::run(void) {
+    const auto batch_size = (std::max)(static_cast<std::size_t>(
+        max_batch_latency / this->interval), std::size_t(1));
+    std::vector<measurement_data> batch;
+    const auto name = sensor_name_registry::intern(this->sensor_name.c_str());
+    periodic_timer timer;
+
+    enter_library_thread("PwrOwg Synthetic Sampler Thread");
+    batch.reserve(batch_size);
+
+    // Take the first sample on the common tick if multiple sensors are being
+    // started at once.
+    timer.start(this->interval, start_barrier::wait());
+
+    while (this->running.load(std::memory_order_acquire)) {
+        timer.wait();
+        batch.push_back(this->sample(timestamp_resolution::milliseconds));
+
+        if (batch.size() >= batch_size) {
+            this->callback(name, batch.data(), batch.size(), this->context);
+            batch.clear();
+        }
+    }
+
+    if (!batch.empty()) {
+        this->callback(name, batch.data(), batch.size(), this->context);
+    }
+}
@@ -0,0 +1,167 @@
+﻿// <copyright file="synthetic_sensor_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "power_overwhelming/measurement.h"
+#include "power_overwhelming/synthetic_sensor.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Private data container for the <see cref="synthetic_sensor" />.
+    /// </summary>
+    struct synthetic_sensor_impl final {
+
+        /// <summary>
+        /// The clock used for computing the phase of the waveform and for
+        /// simulating the cost of sampling.
+        /// </summary>
+        typedef std::chrono::steady_clock clock_type;
+
+        /// <summary>
+        /// The type of the generated values.
+        /// </summary>
+        typedef synthetic_sensor::value_type value_type;
+
+        /// <summary>
+        /// The maximum time the dedicated sampler thread accumulates samples
+        /// before delivering them, which matches the generic sampler.
+        /// </summary>
+        static constexpr std::chrono::microseconds max_batch_latency
+            = std::chrono::milliseconds(10);
+
+        /// <summary>
+        /// The amplitude of the waveform in Watts.
+        /// </summary>
+        value_type amplitude;
+
+        /// <summary>
+        /// Indicates whether the sensor runs its own thread if sampled
+        /// asynchronously.
+        /// </summary>
+        bool async;
+
+        /// <summary>
+        /// The callback receiving the samples of the dedicated thread.
+        /// </summary>
+        measurement_data_callback callback;
+
+        /// <summary>
+        /// The user-defined context passed to <see cref="callback" />.
+        /// </summary>
+        void *context;
+
+        /// <summary>
+        /// The time the sampling thread is busy for each sample.
+        /// </summary>
+        std::chrono::microseconds cost;
+
+        /// <summary>
+        /// The generator for <see cref="synthetic_waveform::noise" />.
+        /// </summary>
+        std::minstd_rand generator;
+
+        /// <summary>
+        /// The sampling interval of the dedicated thread.
+        /// </summary>
+        std::chrono::microseconds interval;
+
+        /// <summary>
+        /// The mean power in Watts.
+        /// </summary>
+        value_type offset;
+
+        /// <summary>
+        /// The begin of the first period of the waveform.
+        /// </summary>
+        clock_type::time_point origin;
+
+        /// <summary>
+        /// The period of the waveform.
+        /// </summary>
+        std::chrono::microseconds period;
+
+        /// <summary>
+        /// Indicates whether the dedicated thread should continue sampling.
+        /// </summary>
+        std::atomic<bool> running;
+
+        /// <summary>
+        /// The name of the sensor.
+        /// </summary>
+        std::wstring sensor_name;
+
+        /// <summary>
+        /// The dedicated sampler thread, if running.
+        /// </summary>
+        std::thread thread;
+
+        /// <summary>
+        /// The constant voltage in Volts.
+        /// </summary>
+        value_type voltage;
+
+        /// <summary>
+        /// The shape of the power curve.
+        /// </summary>
+        synthetic_waveform waveform;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        synthetic_sensor_impl(void);
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~synthetic_sensor_impl(void);
+
+        /// <summary>
+        /// Compute the power at the given point in time.
+        /// </summary>
+        value_type power(_In_ const clock_type::time_point time);
+
+        /// <summary>
+        /// Generate a sample, keeping the calling thread busy for
+        /// <see cref="cost" />.
+        /// </summary>
+        measurement_data sample(_In_ const timestamp_resolution resolution);
+
+        /// <summary>
+        /// Start the dedicated sampler thread.
+        /// </summary>
+        /// <returns><c>true</c> if the thread was started, <c>false</c> if it
+        /// was already running.</returns>
+        bool start(_In_ const measurement_data_callback callback,
+            _In_ const std::chrono::microseconds interval,
+            _In_opt_ void *context);
+
+        /// <summary>
+        /// Stop the dedicated sampler thread, if running, and wait for it to
+        /// deliver its last samples.
+        /// </summary>
+        void stop(void);
+
+    private:
+
+        /// <summary>
+        /// The body of the dedicated sampler thread.
+        /// </summary>
+        void run(void);
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,61 @@
+﻿// <copyright file="synthetic_waveform.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/synthetic_waveform.h"
+
+#include <stdexcept>
+#include <string>
+
+
+/*
+ * visus::power_overwhelming::parse_synthetic_waveform
+ */
+visus::power_overwhelming::synthetic_waveform
+visus::power_overwhelming::parse_synthetic_waveform(_In_z_ const wchar_t *str) {
+    if (str == nullptr) {
+        throw std::invalid_argument("Only a valid string can be parsed into a "
+            "synthetic_waveform.");
+    }
+
+    const std::wstring s(str);
+#define _FROM_STRING_CASE(v) else if (to_string(synthetic_waveform::v) == s) \
+    return synthetic_waveform::v
+
+    if (false);
+    _FROM_STRING_CASE(constant);
+    _FROM_STRING_CASE(sine);
+    _FROM_STRING_CASE(square);
+    _FROM_STRING_CASE(sawtooth);
+    _FROM_STRING_CASE(noise);
+    else throw std::invalid_argument("The given string represents no "
+        "valid synthetic_waveform");
+
+#undef _FROM_STRING_CASE
+}
+
+
+/*
+ * visus::power_overwhelming::to_string
+ */
+_Ret_z_ const wchar_t *visus::power_overwhelming::to_string(
+        _In_ const synthetic_waveform waveform) {
+#define _GCC_IS_SHIT(v) L##v
+#define _TO_STRING_CASE(v) case synthetic_waveform::v: return _GCC_IS_SHIT(#v)
+
+    switch (waveform) {
+        _TO_STRING_CASE(constant);
+        _TO_STRING_CASE(sine);
+        _TO_STRING_CASE(square);
+        _TO_STRING_CASE(sawtooth);
+        _TO_STRING_CASE(noise);
+
+        default:
+            throw std::invalid_argument("The specified waveform is unknown. "
+                "Make sure to add all new waveforms in to_string.");
+    }
+
+#undef _GCC_IS_SHIT
+#undef _TO_STRING_CASE
+}
@@ -0,0 +1,213 @@
+﻿// <copyright file="sysfs_batch.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "sysfs_batch.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif /* !defined(_WIN32) */
+
+
+/*
+ * visus::power_overwhelming::detail::sysfs_batch::buffer_size
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::sysfs_batch::buffer_size;
+
+
+/*
+ * visus::power_overwhelming::detail::sysfs_batch::max_reuse
+ */
+constexpr std::chrono::microseconds
+visus::power_overwhelming::detail::sysfs_batch::max_reuse;
+
+
+/*
+ * visus::power_overwhelming::detail::sysfs_batch::instance
+ */
+visus::power_overwhelming::detail::sysfs_batch&
+visus::power_overwhelming::detail::sysfs_batch::instance(void) {
+    static sysfs_batch retval;
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sysfs_batch::parse
+ */
+std::uint64_t visus::power_overwhelming::detail::sysfs_batch::parse(
+        _In_reads_(cnt) const char *str,
+        _In_ const std::size_t cnt) {
+    assert((str != nullptr) || (cnt == 0));
+    std::uint64_t retval = 0;
+    std::size_t i = 0;
+
+    // Skip any leading white space.
+    while ((i < cnt) && ((str[i] == ' ') || (str[i] == '\t'))) {
+        ++i;
+    }
+
+    if ((i >= cnt) || (str[i] < '0') || (str[i] > '9')) {
+        throw std::runtime_error("The sysfs attribute does not contain a "
+            "number.");
+    }
+
+    for (; (i < cnt) && (str[i] >= '0') && (str[i] <= '9'); ++i) {
+        retval = 10 * retval + (str[i] - '0');
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sysfs_batch::add
+ */
+visus::power_overwhelming::detail::sysfs_batch::slot_type
+visus::power_overwhelming::detail::sysfs_batch::add(_In_ const int file) {
+    assert(file >= 0);
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+
+    // Reuse free slots such that the batch does not grow with every sensor
+    // that is moved or recreated.
+    auto it = std::find(this->_files.begin(), this->_files.end(), -1);
+    const auto retval = static_cast<slot_type>(std::distance(
+        this->_files.begin(), it));
+
+    if (it == this->_files.end()) {
+        this->_files.push_back(file);
+        this->_consumed.push_back(true);
+        this->_results.push_back(-ENODATA);
+        this->_buffers.resize(this->_files.size() * buffer_size);
+    } else {
+        *it = file;
+    }
+
+    // The new file has not been part of the last read, so the next read of
+    // the slot must refresh the batch.
+    this->_consumed[retval] = true;
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sysfs_batch::read
+ */
+std::uint64_t visus::power_overwhelming::detail::sysfs_batch::read(
+        _In_ const slot_type slot,
+        _Out_ time_point& time) {
+    const auto now = std::chrono::system_clock::now();
+
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    assert(slot < this->_files.size());
+    assert(this->_files[slot] >= 0);
+
+    if (this->_consumed[slot] || (now - this->_time > max_reuse)) {
+        // The value has already been retrieved from the last read or the read
+        // is too old, so read all attributes again.
+        this->read_all();
+        std::fill(this->_consumed.begin(), this->_consumed.end(), false);
+        this->_time = std::chrono::system_clock::now();
+    }
+
+    this->_consumed[slot] = true;
+    time = this->_time;
+
+    const auto result = this->_results[slot];
+    if (result < 0) {
+        throw std::system_error(-result, std::system_category());
+    }
+
+    return parse(this->_buffers.data() + slot * buffer_size,
+        static_cast<std::size_t>(result));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sysfs_batch::remove
+ */
+void visus::power_overwhelming::detail::sysfs_batch::remove(
+        _In_ const slot_type slot) noexcept {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    if (slot < this->_files.size()) {
+        this->_files[slot] = -1;
+        this->_results[slot] = -EBADF;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sysfs_batch::uses_io_uring
+ */
+bool visus::power_overwhelming::detail::sysfs_batch::uses_io_uring(
+        void) const noexcept {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    return (this->_ring != nullptr);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sysfs_batch::sysfs_batch
+ */
+visus::power_overwhelming::detail::sysfs_batch::sysfs_batch(void) {
+    try {
+        this->_ring.reset(new io_uring_reader());
+    } catch (...) {
+        // io_uring is not available, so we read each attribute on its own.
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sysfs_batch::read_all
+ */
+void visus::power_overwhelming::detail::sysfs_batch::read_all(void) {
+    assert(this->_buffers.size() == this->_files.size() * buffer_size);
+    assert(this->_results.size() == this->_files.size());
+#if defined(_WIN32)
+    std::fill(this->_results.begin(), this->_results.end(), -ENOTSUP);
+
+#else /* defined(_WIN32) */
+    if (this->_ring != nullptr) {
+        try {
+            // Free slots are submitted, too, which fail immediately and are
+            // cheaper than compacting the files in every tick.
+            this->_ring->read(this->_results.data(), this->_buffers.data(),
+                buffer_size, this->_files.data(), this->_files.size());
+        } catch (...) {
+            this->_ring.reset();
+        }
+    }
+
+    for (std::size_t i = 0; i < this->_files.size(); ++i) {
+        const auto file = this->_files[i];
+        if (file < 0) {
+            continue;
+        }
+
+        // Kernels before 5.6 do not know IORING_OP_READ and reject every
+        // entry, in which case we permanently fall back to pread.
+        if ((this->_ring != nullptr) && (this->_results[i] == -EINVAL)) {
+            this->_ring.reset();
+        }
+
+        if (this->_ring == nullptr) {
+            const auto cnt = ::pread(file, this->_buffers.data()
+                + i * buffer_size, buffer_size, 0);
+            this->_results[i] = (cnt < 0)
+                ? -errno
+                : static_cast<std::int32_t>(cnt);
+        }
+    }
+#endif /* defined(_WIN32) */
+}
@@ -0,0 +1,144 @@
+﻿// <copyright file="sysfs_batch.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <chrono>
+#include <cinttypes>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "io_uring_reader.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The set of all open sysfs attributes of the
+    /// <see cref="sysfs_sensor" />s, which are read together.
+    /// </summary>
+    /// <remarks>
+    /// <para>Every sensor registers the descriptor of its attribute in a
+    /// slot of the batch. Once a sensor reads its slot, all attributes are
+    /// re-read at once, using a single system call if io_uring is available
+    /// and one <c>pread</c> per attribute otherwise. The other sensors are
+    /// then served from this read as long as they have not yet consumed it
+    /// and it is not older than <see cref="max_reuse" />, such that a sampler
+    /// tick over all sensors issues only one batch.</para>
+    /// </remarks>
+    class sysfs_batch final {
+
+    public:
+
+        /// <summary>
+        /// The type of the handle to a registered attribute.
+        /// </summary>
+        typedef std::size_t slot_type;
+
+        /// <summary>
+        /// The type used to store the point in time the batch has been read.
+        /// </summary>
+        typedef std::chrono::system_clock::time_point time_point;
+
+        /// <summary>
+        /// The number of bytes read from every attribute, which is large
+        /// enough for any 64-bit number in decimal notation.
+        /// </summary>
+        static constexpr std::size_t buffer_size = 32;
+
+        /// <summary>
+        /// The maximum age of the last read for which it is used to answer a
+        /// slot that has not yet been retrieved from it.
+        /// </summary>
+        static constexpr std::chrono::microseconds max_reuse
+            = std::chrono::microseconds(1000);
+
+        /// <summary>
+        /// Answer the only instance of the batch.
+        /// </summary>
+        /// <returns>The batch shared by all sensors.</returns>
+        static sysfs_batch& instance(void);
+
+        /// <summary>
+        /// Parses the decimal value of an attribute.
+        /// </summary>
+        /// <param name="str">The content of the attribute, which does not
+        /// need to be terminated.</param>
+        /// <param name="cnt">The number of valid bytes in
+        /// <paramref name="str" />.</param>
+        /// <returns>The value of the attribute.</returns>
+        /// <exception cref="std::runtime_error">If the content is not a
+        /// number.</exception>
+        static std::uint64_t parse(_In_reads_(cnt) const char *str,
+            _In_ const std::size_t cnt);
+
+        sysfs_batch(const sysfs_batch&) = delete;
+
+        /// <summary>
+        /// Registers the given file in the batch.
+        /// </summary>
+        /// <remarks>
+        /// The batch does not take ownership of the file, which must remain
+        /// open until it has been removed.
+        /// </remarks>
+        /// <param name="file">The descriptor of the attribute.</param>
+        /// <returns>The slot of the file.</returns>
+        slot_type add(_In_ const int file);
+
+        /// <summary>
+        /// Reads the value of the attribute in the given slot.
+        /// </summary>
+        /// <param name="slot">The slot returned by <see cref="add" />.
+        /// </param>
+        /// <param name="time">Receives the point in time when the attribute
+        /// was read.</param>
+        /// <returns>The value of the attribute.</returns>
+        /// <exception cref="std::system_error">If reading the attribute
+        /// failed.</exception>
+        /// <exception cref="std::runtime_error">If the attribute is not a
+        /// number.</exception>
+        std::uint64_t read(_In_ const slot_type slot, _Out_ time_point& time);
+
+        /// <summary>
+        /// Releases the given slot.
+        /// </summary>
+        /// <param name="slot">The slot returned by <see cref="add" />.
+        /// </param>
+        void remove(_In_ const slot_type slot) noexcept;
+
+        /// <summary>
+        /// Answer whether the batch is read via io_uring.
+        /// </summary>
+        /// <returns><c>true</c> if all attributes are read with a single
+        /// system call, <c>false</c> otherwise.</returns>
+        bool uses_io_uring(void) const noexcept;
+
+        sysfs_batch& operator =(const sysfs_batch&) = delete;
+
+    private:
+
+        sysfs_batch(void);
+
+        /// <summary>
+        /// Reads all registered attributes, which must be called while
+        /// holding <see cref="_lock" />.
+        /// </summary>
+        void read_all(void);
+
+        std::vector<char> _buffers;
+        std::vector<bool> _consumed;
+        std::vector<int> _files;
+        mutable std::mutex _lock;
+        std::vector<std::int32_t> _results;
+        std::unique_ptr<io_uring_reader> _ring;
+        time_point _time;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
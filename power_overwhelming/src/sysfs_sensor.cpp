@@ -0,0 +1,376 @@
+﻿// <copyright file="sysfs_sensor.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/sysfs_sensor.h"
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "power_overwhelming/convert_string.h"
+
+#include "sysfs_sensor_impl.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Answer whether the file at <paramref name="path" /> belongs to a device
+    /// that is covered by a dedicated sensor.
+    /// </summary>
+    static bool has_dedicated_sensor(_In_ const std::string& path) {
+        static const char *const hwmon_names[] = { "amdgpu" };
+        static const char *const powercap_prefix = "/sys/class/powercap/"
+            "intel-rapl";
+
+        if (path.compare(0, ::strlen(powercap_prefix), powercap_prefix) == 0) {
+            return true;
+        }
+
+        const auto sep = path.find_last_of('/');
+        std::ifstream stream(path.substr(0, sep + 1) + "name");
+        std::string name;
+
+        if (std::getline(stream, name)) {
+            for (auto n : hwmon_names) {
+                if (name == n) {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::sysfs_sensor::default_scale
+ */
+constexpr double visus::power_overwhelming::sysfs_sensor::default_scale;
+
+
+/*
+ * visus::power_overwhelming::sysfs_sensor::for_all
+ */
+std::size_t visus::power_overwhelming::sysfs_sensor::for_all(
+        _Out_writes_opt_(cnt_sensors) sysfs_sensor *out_sensors,
+        _In_ const std::size_t cnt_sensors) {
+    static const struct {
+        const char *pattern;
+        sysfs_sensor_quantity quantity;
+    } sources[] = {
+        { "/sys/class/hwmon/hwmon*/power*_input",
+            sysfs_sensor_quantity::power },
+        { "/sys/class/hwmon/hwmon*/power*_average",
+            sysfs_sensor_quantity::power },
+        { "/sys/class/hwmon/hwmon*/energy*_input",
+            sysfs_sensor_quantity::energy },
+        { "/sys/class/powercap/*/energy_uj",
+            sysfs_sensor_quantity::energy }
+    };
+    std::size_t retval = 0;
+
+    for (auto& s : sources) {
+        for (auto& p : detail::sysfs_sensor_impl::glob(s.pattern)) {
+            if (detail::has_dedicated_sensor(p)) {
+                continue;
+            }
+
+            try {
+                // We need to check whether the file can be read even if there
+                // is no space left in the output in order to return the
+                // correct number.
+                if (retval < cnt_sensors) {
+                    auto& sensor = out_sensors[retval];
+                    assert(sensor._impl != nullptr);
+                    sensor._impl->set(p, s.quantity, default_scale);
+                } else {
+                    detail::sysfs_sensor_impl().set(p, s.quantity,
+                        default_scale);
+                }
+
+                ++retval;
+            } catch (const std::runtime_error&) {
+                // The file cannot be read, which happens for instance for
+                // powercap zones if the process lacks the privileges.
+            }
+        }
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::sysfs_sensor::for_path
+ */
+visus::power_overwhelming::sysfs_sensor
+visus::power_overwhelming::sysfs_sensor::for_path(
+        _In_z_ const char *path,
+        _In_ const sysfs_sensor_quantity quantity,
+        _In_ const double scale) {
+    if (path == nullptr) {
+        throw std::invalid_argument("The path of a sysfs sensor must not be "
+            "null.");
+    }
+
+    sysfs_sensor retval;
+    assert(retval._impl != nullptr);
+    retval._impl->set(path, quantity, scale);
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::sysfs_sensor::for_path
+ */
+visus::power_overwhelming::sysfs_sensor
+visus::power_overwhelming::sysfs_sensor::for_path(
+        _In_z_ const wchar_t *path,
+        _In_ const sysfs_sensor_quantity quantity,
+        _In_ const double scale) {
+    if (path == nullptr) {
+        throw std::invalid_argument("The path of a sysfs sensor must not be "
+            "null.");
+    }
+
+    auto p = convert_string<char>(path);
+    return for_path(p.c_str(), quantity, scale);
+}
+
+
+/*
+ * visus::power_overwhelming::sysfs_sensor::for_pattern
+ */
+std::size_t visus::power_overwhelming::sysfs_sensor::for_pattern(
+        _Out_writes_opt_(cnt_sensors) sysfs_sensor *out_sensors,
+        _In_ const std::size_t cnt_sensors,
+        _In_z_ const char *pattern,
+        _In_ const sysfs_sensor_quantity quantity,
+        _In_ const double scale) {
+    if (pattern == nullptr) {
+        throw std::invalid_argument("The pattern for sysfs sensors must not "
+            "be null.");
+    }
+
+    std::size_t retval = 0;
+
+    for (auto& p : detail::sysfs_sensor_impl::glob(pattern)) {
+        try {
+            if (retval < cnt_sensors) {
+                auto& sensor = out_sensors[retval];
+                assert(sensor._impl != nullptr);
+                sensor._impl->set(p, quantity, scale);
+            } else {
+                detail::sysfs_sensor_impl().set(p, quantity, scale);
+            }
+
+            ++retval;
+        } catch (const std::runtime_error&) {
+            // The file is not a readable number, so it is not a sensor.
+        }
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::sysfs_sensor::sample_data
+ */
+void visus::power_overwhelming::sysfs_sensor::sample_data(
+        _Out_writes_(cnt) measurement_data *dst,
+        _In_reads_(cnt) const sysfs_sensor *sensors,
+        _In_ const std::size_t cnt,
+        _In_ const timestamp_resolution resolution) {
+    if ((cnt > 0) && ((dst == nullptr) || (sensors == nullptr))) {
+        throw std::invalid_argument("The output and the sensors must be "
+            "valid if sensors are to be sampled.");
+    }
+
+    // The first sensor reads the files of all sensors and the others are
+    // served from this read, so there is no need to group them here.
+    for (std::size_t i = 0; i < cnt; ++i) {
+        dst[i] = sensors[i].sample_data(resolution);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::sysfs_sensor::sysfs_sensor
+ */
+visus::power_overwhelming::sysfs_sensor::sysfs_sensor(void)
+    : _impl(new detail::sysfs_sensor_impl()) { }
+
+
+/*
+ * visus::power_overwhelming::sysfs_sensor::~sysfs_sensor
+ */
+visus::power_overwhelming::sysfs_sensor::~sysfs_sensor(void) {
+    detail::sysfs_sensor_impl::sampler.remove(this->_impl);
+    // Make sure that the generic sampler thread does not use the sensor
+    // anymore.
+    this->sample_batch(nullptr);
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::sysfs_sensor::energy
+ */
+double visus::power_overwhelming::sysfs_sensor::energy(void) const {
+    if (!*this) {
+        throw_disposed();
+    }
+    return this->_impl->energy();
+}
+
+
+/*
+ * visus::power_overwhelming::sysfs_sensor::name
+ */
+_Ret_maybenull_z_
+const wchar_t *visus::power_overwhelming::sysfs_sensor::name(
+        void) const noexcept {
+    return (this->_impl != nullptr)
+        ? this->_impl->sensor_name.c_str()
+        : nullptr;
+}
+
+
+/*
+ * visus::power_overwhelming::sysfs_sensor::native_interval
+ */
+visus::power_overwhelming::sensor::microseconds_type
+visus::power_overwhelming::sysfs_sensor::native_interval(void) const {
+    // The update rate depends on the driver providing the file. Most of them
+    // refresh their values every few milliseconds, some only every second.
+    this->check_not_disposed();
+    return 1000;
+}
+
+
+/*
+ * visus::power_overwhelming::sysfs_sensor::path
+ */
+_Ret_z_ const char *visus::power_overwhelming::sysfs_sensor::path(
+        void) const {
+    this->check_not_disposed();
+    return this->_impl->path.c_str();
+}
+
+
+/*
+ * visus::power_overwhelming::sysfs_sensor::quantity
+ */
+visus::power_overwhelming::sysfs_sensor_quantity
+visus::power_overwhelming::sysfs_sensor::quantity(void) const {
+    this->check_not_disposed();
+    return this->_impl->quantity;
+}
+
+
+/*
+ * visus::power_overwhelming::sysfs_sensor::sample
+ */
+void visus::power_overwhelming::sysfs_sensor::sample(
+        _In_opt_ const measurement_callback on_measurement,
+        _In_ const microseconds_type period,
+        _In_ const timestamp_resolution timestamp_resolution,
+        _In_opt_ void *context) {
+    typedef decltype(detail::sysfs_sensor_impl::sampler)::interval_type
+        interval_type;
+
+    this->check_not_disposed();
+
+    if (on_measurement != nullptr) {
+        if (!detail::sysfs_sensor_impl::sampler.add(this->_impl,
+                on_measurement, context, interval_type(period))) {
+            throw std::logic_error("Asynchronous sampling cannot be started "
+                "while it is already running.");
+        }
+
+    } else {
+        detail::sysfs_sensor_impl::sampler.remove(this->_impl, context);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::sysfs_sensor::sample_adaptive
+ */
+void visus::power_overwhelming::sysfs_sensor::sample_adaptive(
+        _In_opt_ const measurement_data_callback on_batch,
+        _In_ const microseconds_type min_period,
+        _In_ const microseconds_type max_period,
+        _In_opt_ void *context) {
+    this->sample_adaptive_sync(on_batch, min_period, max_period, context);
+}
+
+
+/*
+ * visus::power_overwhelming::sysfs_sensor::scale
+ */
+double visus::power_overwhelming::sysfs_sensor::scale(void) const {
+    this->check_not_disposed();
+    return this->_impl->scale;
+}
+
+
+/*
+ * visus::power_overwhelming::sysfs_sensor::operator =
+ */
+visus::power_overwhelming::sysfs_sensor&
+visus::power_overwhelming::sysfs_sensor::operator =(
+        _In_ sysfs_sensor&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        detail::sysfs_sensor_impl::sampler.remove(this->_impl);
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::sysfs_sensor::operator bool
+ */
+visus::power_overwhelming::sysfs_sensor::operator bool(
+        void) const noexcept {
+    return ((this->_impl != nullptr) && (this->_impl->file >= 0));
+}
+
+
+/*
+ * visus::power_overwhelming::sysfs_sensor::sample_data
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::sysfs_sensor::sample_data(
+        _In_ const timestamp_resolution resolution) const {
+    if (!*this) {
+        // The class is final, so this does not require a virtual call.
+        throw_disposed();
+    }
+    return this->_impl->sample(resolution);
+}
+
+
+/*
+ * visus::power_overwhelming::sysfs_sensor::sample_sync
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::sysfs_sensor::sample_sync(
+        _In_ const timestamp_resolution resolution) const {
+    return this->sample_data(resolution);
+}
@@ -0,0 +1,217 @@
+﻿// <copyright file="sysfs_sensor_impl.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "sysfs_sensor_impl.h"
+
+#include <cassert>
+#include <cerrno>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <glob.h>
+#include <unistd.h>
+#endif /* !defined(_WIN32) */
+
+#include "power_overwhelming/convert_string.h"
+
+#include "io_util.h"
+
+
+/*
+ * visus::power_overwhelming::detail::sysfs_sensor_impl::sampler
+ */
+visus::power_overwhelming::detail::sampler<
+    visus::power_overwhelming::detail::default_sampler_context<
+    visus::power_overwhelming::detail::sysfs_sensor_impl>>
+    visus::power_overwhelming::detail::sysfs_sensor_impl::sampler;
+
+
+/*
+ * visus::power_overwhelming::detail::sysfs_sensor_impl::glob
+ */
+std::vector<std::string>
+visus::power_overwhelming::detail::sysfs_sensor_impl::glob(
+        _In_z_ const char *pattern) {
+    assert(pattern != nullptr);
+    std::vector<std::string> retval;
+
+#if !defined(_WIN32)
+    ::glob_t matches;
+    if (::glob(pattern, 0, nullptr, &matches) == 0) {
+        retval.reserve(matches.gl_pathc);
+        for (std::size_t i = 0; i < matches.gl_pathc; ++i) {
+            retval.emplace_back(matches.gl_pathv[i]);
+        }
+    }
+
+    ::globfree(&matches);
+#endif /* !defined(_WIN32) */
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sysfs_sensor_impl::get_name
+ */
+std::wstring visus::power_overwhelming::detail::sysfs_sensor_impl::get_name(
+        _In_ const std::string& path) {
+    static const std::string prefix("/sys/class/");
+    auto name = path;
+
+    if (name.compare(0, prefix.size(), prefix) == 0) {
+        name.erase(0, prefix.size());
+    } else if (!name.empty() && (name.front() == '/')) {
+        name.erase(0, 1);
+    }
+
+    return L"sysfs/" + power_overwhelming::convert_string<wchar_t>(name);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sysfs_sensor_impl::~sysfs_sensor_impl
+ */
+visus::power_overwhelming::detail::sysfs_sensor_impl::~sysfs_sensor_impl(
+        void) noexcept {
+    this->close();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sysfs_sensor_impl::close
+ */
+void visus::power_overwhelming::detail::sysfs_sensor_impl::close(
+        void) noexcept {
+#if !defined(_WIN32)
+    if (this->file >= 0) {
+        sysfs_batch::instance().remove(this->slot);
+        ::close(this->file);
+        this->file = -1;
+    }
+#endif /* !defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sysfs_sensor_impl::energy
+ */
+double visus::power_overwhelming::detail::sysfs_sensor_impl::energy(
+        void) const {
+    assert(this->file >= 0);
+    if (this->quantity != sysfs_sensor_quantity::energy) {
+        return 0.0;
+    }
+
+    sysfs_batch::time_point time;
+    const auto value = sysfs_batch::instance().read(this->slot, time);
+    return this->delta(this->first_value, value) * this->scale;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sysfs_sensor_impl::sample
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::detail::sysfs_sensor_impl::sample(
+        _In_ const timestamp_resolution resolution) const {
+    typedef std::chrono::duration<double> seconds_type;
+    assert(this->file >= 0);
+
+    if (resolution == timestamp_resolution::nanoseconds) {
+        throw std::invalid_argument("Timestamps of sysfs sensors cannot be "
+            "created in nanoseconds.");
+    }
+
+    const auto converter = get_timestamp_converter(resolution);
+    sysfs_batch::time_point now;
+    const auto value = sysfs_batch::instance().read(this->slot, now);
+
+    if (this->quantity == sysfs_sensor_quantity::power) {
+        const auto timestamp = converter(convert_to_file_time(now));
+        const auto power = static_cast<measurement_data::value_type>(
+            value * this->scale);
+        return measurement_data(timestamp, power);
+    }
+
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    const auto de = this->delta(this->last_value, value) * this->scale;
+    const auto dt = now - this->last_time;
+    const auto sample_time = this->last_time + dt / 2;
+    const auto timestamp = converter(convert_to_file_time(sample_time));
+    const auto power = static_cast<measurement_data::value_type>(de
+        / std::chrono::duration_cast<seconds_type>(dt).count());
+
+    this->last_value = value;
+    this->last_time = now;
+
+    return measurement_data(timestamp, power);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sysfs_sensor_impl::set
+ */
+void visus::power_overwhelming::detail::sysfs_sensor_impl::set(
+        _In_ const std::string& path,
+        _In_ const sysfs_sensor_quantity quantity,
+        _In_ const double scale) {
+#if defined(_WIN32)
+    throw std::system_error(ENOTSUP, std::system_category());
+
+#else /* defined(_WIN32) */
+    const auto file = detail::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+    this->close();
+    this->file = file;
+    this->path = path;
+    this->quantity = quantity;
+    this->range = 0;
+    this->scale = scale;
+    this->sensor_name = get_name(this->path);
+    this->slot = sysfs_batch::instance().add(this->file);
+
+    if (this->quantity == sysfs_sensor_quantity::energy) {
+        // Powercap zones report where their counter wraps next to it.
+        const auto sep = this->path.find_last_of('/');
+        const auto dir = (sep != std::string::npos)
+            ? this->path.substr(0, sep + 1)
+            : std::string();
+        std::ifstream stream(dir + "max_energy_range_uj");
+        if (!(stream >> this->range)) {
+            this->range = 0;
+        }
+    }
+
+    // Retrieve a first sample as reference for the power of the next one,
+    // which also makes sure that the file can actually be read.
+    try {
+        this->first_value = this->last_value = sysfs_batch::instance().read(
+            this->slot, this->last_time);
+    } catch (...) {
+        this->close();
+        throw;
+    }
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::sysfs_sensor_impl::delta
+ */
+std::uint64_t visus::power_overwhelming::detail::sysfs_sensor_impl::delta(
+        _In_ const std::uint64_t from,
+        _In_ const std::uint64_t to) const noexcept {
+    if (to >= from) {
+        return to - from;
+    }
+
+    // The counter has wrapped. If we do not know where, the best guess is
+    // that it restarted at zero.
+    return (this->range > from) ? (this->range - from + to) : to;
+}
@@ -0,0 +1,198 @@
+﻿// <copyright file="sysfs_sensor_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <chrono>
+#include <cinttypes>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "power_overwhelming/measurement.h"
+#include "power_overwhelming/sysfs_sensor.h"
+
+#include "default_sampler_context.h"
+#include "sampler.h"
+#include "sysfs_batch.h"
+#include "timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Private data container for the <see cref="sysfs_sensor" />.
+    /// </summary>
+    struct sysfs_sensor_impl final {
+
+        /// <summary>
+        /// A sampler for sysfs sensors.
+        /// </summary>
+        /// <remarks>
+        /// The default context samples the sensors one after another, so the
+        /// <see cref="sysfs_batch" /> answers all but the first of them from
+        /// a single read of all files.
+        /// </remarks>
+        static detail::sampler<default_sampler_context<sysfs_sensor_impl>>
+            sampler;
+
+        /// <summary>
+        /// Answer the paths of all files matching the given glob pattern.
+        /// </summary>
+        /// <param name="pattern">The glob pattern.</param>
+        /// <returns>The paths of the matching files, which is empty if
+        /// nothing matches or on Windows.</returns>
+        static std::vector<std::string> glob(_In_z_ const char *pattern);
+
+        /// <summary>
+        /// Derives the name of a sensor from the path to its file.
+        /// </summary>
+        /// <param name="path">The path to the file.</param>
+        /// <returns>The name of the sensor, which is the path relative to
+        /// <c>/sys/class</c> prefixed with &quot;sysfs&quot;.</returns>
+        static std::wstring get_name(_In_ const std::string& path);
+
+        /// <summary>
+        /// The file descriptor of the opened attribute.
+        /// </summary>
+        int file;
+
+        /// <summary>
+        /// The value of the file when the sensor was created.
+        /// </summary>
+        std::uint64_t first_value;
+
+        /// <summary>
+        /// The value of the file at the last sample.
+        /// </summary>
+        mutable std::uint64_t last_value;
+
+        /// <summary>
+        /// The point in time when the file of the last sample was read.
+        /// </summary>
+        mutable sysfs_batch::time_point last_time;
+
+        /// <summary>
+        /// Protects <see cref="last_value" /> and <see cref="last_time" />
+        /// against concurrent samples.
+        /// </summary>
+        mutable std::mutex lock;
+
+        /// <summary>
+        /// The path to the file.
+        /// </summary>
+        std::string path;
+
+        /// <summary>
+        /// The quantity the file reports.
+        /// </summary>
+        sysfs_sensor_quantity quantity;
+
+        /// <summary>
+        /// The largest value of an energy counter before it wraps, which is
+        /// zero if unknown.
+        /// </summary>
+        /// <remarks>
+        /// This value is only known for powercap zones, which report it in
+        /// <c>max_energy_range_uj</c>.
+        /// </remarks>
+        std::uint64_t range;
+
+        /// <summary>
+        /// The factor converting the content of the file to Watts or Joules.
+        /// </summary>
+        double scale;
+
+        /// <summary>
+        /// The sensor name.
+        /// </summary>
+        std::wstring sensor_name;
+
+        /// <summary>
+        /// The slot of <see cref="file" /> in the <see cref="sysfs_batch" />.
+        /// </summary>
+        sysfs_batch::slot_type slot;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        inline sysfs_sensor_impl(void) : file(-1), first_value(0),
+            last_value(0), quantity(sysfs_sensor_quantity::power), range(0),
+            scale(sysfs_sensor::default_scale), slot(0) { }
+
+        sysfs_sensor_impl(const sysfs_sensor_impl&) = delete;
+
+        /// <summary>
+        /// Finalise the instance.
+        /// </summary>
+        ~sysfs_sensor_impl(void) noexcept;
+
+        /// <summary>
+        /// Closes the file and releases its slot in the batch.
+        /// </summary>
+        void close(void) noexcept;
+
+        /// <summary>
+        /// Answer the energy in Joules that has been accumulated since the
+        /// sensor was created.
+        /// </summary>
+        /// <returns>The consumed energy in Joules, or zero if the file reports
+        /// a power.</returns>
+        double energy(void) const;
+
+        /// <summary>
+        /// Obtain a new sample with a timestamp in milliseconds, which is the
+        /// interface required by the <see cref="default_sampler_context" />.
+        /// </summary>
+        /// <returns>The result of the measurement.</returns>
+        inline measurement_data sample(void) const {
+            return this->sample(timestamp_resolution::milliseconds);
+        }
+
+        /// <summary>
+        /// Obtain a new sample.
+        /// </summary>
+        /// <param name="resolution">The resolution of the timestamp being
+        /// created.</param>
+        /// <returns>The result of the measurement.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="resolution" /> is nanoseconds.</exception>
+        /// <exception cref="std::system_error">If reading the file failed.
+        /// </exception>
+        measurement_data sample(
+            _In_ const timestamp_resolution resolution) const;
+
+        /// <summary>
+        /// Opens the given file and prepares the sensor for sampling it.
+        /// </summary>
+        /// <param name="path">The path to the file.</param>
+        /// <param name="quantity">The quantity the file reports.</param>
+        /// <param name="scale">The factor converting the content of the file
+        /// to Watts or Joules.</param>
+        /// <exception cref="std::system_error">If the file could not be
+        /// opened or read.</exception>
+        /// <exception cref="std::runtime_error">If the file does not contain
+        /// a number.</exception>
+        void set(_In_ const std::string& path,
+            _In_ const sysfs_sensor_quantity quantity,
+            _In_ const double scale);
+
+        sysfs_sensor_impl& operator =(const sysfs_sensor_impl&) = delete;
+
+    private:
+
+        /// <summary>
+        /// Answer the difference between the given readings of the energy
+        /// counter, considering that the counter might have wrapped.
+        /// </summary>
+        std::uint64_t delta(_In_ const std::uint64_t from,
+            _In_ const std::uint64_t to) const noexcept;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
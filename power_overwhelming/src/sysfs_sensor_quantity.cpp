@@ -0,0 +1,57 @@
+﻿// <copyright file="sysfs_sensor_quantity.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/sysfs_sensor_quantity.h"
+
+#include <stdexcept>
+#include <string>
+
+
+/*
+ * visus::power_overwhelming::parse_sysfs_sensor_quantity
+ */
+visus::power_overwhelming::sysfs_sensor_quantity
+visus::power_overwhelming::parse_sysfs_sensor_quantity(
+        _In_z_ const wchar_t *str) {
+    if (str == nullptr) {
+        throw std::invalid_argument("Only a valid string can be parsed into a "
+            "sysfs_sensor_quantity.");
+    }
+
+    const std::wstring s(str);
+#define _FROM_STRING_CASE(v) else if (to_string(sysfs_sensor_quantity::v) \
+    == s) return sysfs_sensor_quantity::v
+
+    if (false);
+    _FROM_STRING_CASE(energy);
+    _FROM_STRING_CASE(power);
+    else throw std::invalid_argument("The given string represents no "
+        "valid sysfs_sensor_quantity");
+
+#undef _FROM_STRING_CASE
+}
+
+
+/*
+ * visus::power_overwhelming::to_string
+ */
+const wchar_t *visus::power_overwhelming::to_string(
+        _In_ const sysfs_sensor_quantity quantity) {
+#define _GCC_IS_SHIT(v) L##v
+#define _TO_STRING_CASE(v) case sysfs_sensor_quantity::v: \
+    return _GCC_IS_SHIT(#v)
+
+    switch (quantity) {
+        _TO_STRING_CASE(energy);
+        _TO_STRING_CASE(power);
+
+        default:
+            throw std::invalid_argument("The specified quantity is unknown. "
+                "Make sure to add all new quantities in to_string.");
+    }
+
+#undef _GCC_IS_SHIT
+#undef _TO_STRING_CASE
+}
@@ -0,0 +1,172 @@
+﻿// <copyright file="system_trace.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "system_trace.h"
+
+#if defined(POWER_OVERWHELMING_WITH_SYSTEM_TRACE)
+#include <cmath>
+#include <limits>
+#include <string>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <TraceLoggingProvider.h>
+#include <winmeta.h>
+#else /* defined(_WIN32) */
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+#endif /* defined(_WIN32) */
+
+#include "string_functions.h"
+
+
+#if defined(_WIN32)
+// 680f82be-9183-49be-b56b-cec62c10b3ad
+TRACELOGGING_DEFINE_PROVIDER(power_overwhelming_provider,
+    "VISUS.PowerOverwhelming",
+    (0x680f82be, 0x9183, 0x49be, 0xb5, 0x6b, 0xce, 0xc6, 0x2c, 0x10, 0xb3,
+    0xad));
+
+#else /* defined(_WIN32) */
+// The tracing tools increment the semaphores while they are attached, and the
+// probes reference them by these names.
+extern "C" {
+    unsigned short power_overwhelming_marker_semaphore
+        __attribute__((unused)) __attribute__((section(".probes")));
+    unsigned short power_overwhelming_sample_semaphore
+        __attribute__((unused)) __attribute__((section(".probes")));
+}
+#endif /* defined(_WIN32) */
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+#if defined(_WIN32)
+    /// <summary>
+    /// Registers the provider when the library is loaded and unregisters it
+    /// before the library is unloaded.
+    /// </summary>
+    static const struct provider_registration final {
+        inline provider_registration(void) {
+            ::TraceLoggingRegister(power_overwhelming_provider);
+        }
+
+        inline ~provider_registration(void) {
+            ::TraceLoggingUnregister(power_overwhelming_provider);
+        }
+    } registration;
+
+#else /* defined(_WIN32) */
+    /// <summary>
+    /// Converts a value to micro-units for passing it to a probe.
+    /// </summary>
+    static inline std::int64_t micro(
+            _In_ const measurement_data::value_type value) noexcept {
+        return (value == measurement_data::invalid_value)
+            ? (std::numeric_limits<std::int64_t>::min)()
+            : static_cast<std::int64_t>(std::llround(value * 1e6));
+    }
+
+    /// <summary>
+    /// Converts a string for passing it to a probe, reusing the memory of the
+    /// calling thread.
+    /// </summary>
+    static const char *utf8(_In_opt_z_ const wchar_t *str) {
+        thread_local std::string retval;
+        retval.clear();
+        if (str != nullptr) {
+            append_utf8(retval, str);
+        }
+        return retval.c_str();
+    }
+#endif /* defined(_WIN32) */
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::system_trace::enabled
+ */
+bool visus::power_overwhelming::detail::system_trace::enabled(
+        void) noexcept {
+#if defined(_WIN32)
+    return TraceLoggingProviderEnabled(power_overwhelming_provider, 0, 0);
+#else /* defined(_WIN32) */
+    return (power_overwhelming_sample_semaphore != 0)
+        || (power_overwhelming_marker_semaphore != 0);
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::system_trace::marker
+ */
+void visus::power_overwhelming::detail::system_trace::marker(
+        _In_ const std::uint32_t id,
+        _In_opt_z_ const wchar_t *name) noexcept {
+#if defined(_WIN32)
+    TraceLoggingWrite(power_overwhelming_provider, "Marker",
+        TraceLoggingLevel(WINEVENT_LEVEL_INFO),
+        TraceLoggingUInt32(id, "ID"),
+        TraceLoggingWideString((name != nullptr) ? name : L"", "Name"));
+
+#else /* defined(_WIN32) */
+    if (power_overwhelming_marker_semaphore != 0) {
+        try {
+            DTRACE_PROBE2(power_overwhelming, marker, id, utf8(name));
+        } catch (...) { /* Tracing must not disturb the caller. */ }
+    }
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::system_trace::sample
+ */
+void visus::power_overwhelming::detail::system_trace::sample(
+        _In_opt_z_ const wchar_t *sensor,
+        _In_reads_(cnt) const measurement_data *samples,
+        _In_ const std::size_t cnt) noexcept {
+#if defined(_WIN32)
+    if (!TraceLoggingProviderEnabled(power_overwhelming_provider,
+            WINEVENT_LEVEL_VERBOSE, 0)) {
+        return;
+    }
+
+    for (std::size_t i = 0; i < cnt; ++i) {
+        auto& s = samples[i];
+        TraceLoggingWrite(power_overwhelming_provider, "Sample",
+            TraceLoggingLevel(WINEVENT_LEVEL_VERBOSE),
+            TraceLoggingWideString((sensor != nullptr) ? sensor : L"",
+                "Sensor"),
+            TraceLoggingInt64(s.timestamp(), "Timestamp"),
+            TraceLoggingFloat32(s.voltage(), "Voltage"),
+            TraceLoggingFloat32(s.current(), "Current"),
+            TraceLoggingFloat32(s.power(), "Power"));
+    }
+
+#else /* defined(_WIN32) */
+    if (power_overwhelming_sample_semaphore == 0) {
+        return;
+    }
+
+    try {
+        // The name is only converted once for all samples.
+        const auto name = utf8(sensor);
+        for (std::size_t i = 0; i < cnt; ++i) {
+            auto& s = samples[i];
+            DTRACE_PROBE5(power_overwhelming, sample, name,
+                static_cast<std::int64_t>(s.timestamp()), micro(s.voltage()),
+                micro(s.current()), micro(s.power()));
+        }
+    } catch (...) { /* Tracing must not disturb the caller. */ }
+#endif /* defined(_WIN32) */
+}
+
+#endif /* defined(POWER_OVERWHELMING_WITH_SYSTEM_TRACE) */
@@ -0,0 +1,99 @@
+﻿// <copyright file="system_trace.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+
+#include "power_overwhelming/measurement_data.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Emits samples and markers as events of the tracing facility of the
+    /// operating system, i.e. as TraceLogging events via ETW on Windows and
+    /// as USDT probes on Linux.
+    /// </summary>
+    /// <remarks>
+    /// <para>The events allow for showing the power data in WPA or
+    /// <c>perf</c> on the same timeline as context switches and other system
+    /// events. On Windows, the provider is named
+    /// <c>VISUS.PowerOverwhelming</c>. On Linux, the probes are
+    /// <c>power_overwhelming:sample</c> with the UTF-8 name of the sensor,
+    /// the timestamp and the voltage, current and power in micro-units as
+    /// arguments, and <c>power_overwhelming:marker</c> with the ID and the
+    /// UTF-8 name of the marker. Invalid values are passed as the smallest
+    /// 64-bit integer.</para>
+    /// <para>If no listener is attached, emitting an event only costs
+    /// checking a flag. The events are only compiled into the library if
+    /// <c>POWER_OVERWHELMING_WITH_SYSTEM_TRACE</c> is defined; otherwise,
+    /// all methods are empty inline functions.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API system_trace final {
+
+    public:
+
+#if defined(POWER_OVERWHELMING_WITH_SYSTEM_TRACE)
+        /// <summary>
+        /// Answer whether any listener is interested in the events.
+        /// </summary>
+        /// <returns><c>true</c> if events are recorded, <c>false</c>
+        /// otherwise.</returns>
+        static bool enabled(void) noexcept;
+
+        /// <summary>
+        /// Emits an event for a marker having been set.
+        /// </summary>
+        /// <param name="id">The ID of the marker, which is zero if the
+        /// marker has been cleared.</param>
+        /// <param name="name">The name of the marker.</param>
+        static void marker(_In_ const std::uint32_t id,
+            _In_opt_z_ const wchar_t *name) noexcept;
+
+        /// <summary>
+        /// Emits an event for each of the given samples.
+        /// </summary>
+        /// <param name="sensor">The name of the sensor that produced the
+        /// samples.</param>
+        /// <param name="samples">The samples.</param>
+        /// <param name="cnt">The number of elements in
+        /// <paramref name="samples" />.</param>
+        static void sample(_In_opt_z_ const wchar_t *sensor,
+            _In_reads_(cnt) const measurement_data *samples,
+            _In_ const std::size_t cnt) noexcept;
+
+#else /* defined(POWER_OVERWHELMING_WITH_SYSTEM_TRACE) */
+        static inline constexpr bool enabled(void) noexcept {
+            return false;
+        }
+
+        static inline void marker(_In_ const std::uint32_t id,
+            _In_opt_z_ const wchar_t *name) noexcept { }
+
+        static inline void sample(_In_opt_z_ const wchar_t *sensor,
+            _In_reads_(cnt) const measurement_data *samples,
+            _In_ const std::size_t cnt) noexcept { }
+#endif /* defined(POWER_OVERWHELMING_WITH_SYSTEM_TRACE) */
+
+        /// <summary>
+        /// Emits an event for a sample.
+        /// </summary>
+        /// <param name="sensor">The name of the sensor that produced the
+        /// sample.</param>
+        /// <param name="sample">The sample.</param>
+        static inline void sample(_In_opt_z_ const wchar_t *sensor,
+                _In_ const measurement_data& sample) noexcept {
+            system_trace::sample(sensor, &sample, 1);
+        }
+
+        system_trace(void) = delete;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
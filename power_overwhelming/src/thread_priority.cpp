@@ -0,0 +1,93 @@
+﻿// <copyright file="thread_priority.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/thread_priority.h"
+
+#include <stdexcept>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else /* defined(_WIN32) */
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif /* defined(_WIN32) */
+
+
+/*
+ * visus::power_overwhelming::set_thread_priority
+ */
+void visus::power_overwhelming::set_thread_priority(
+        _In_ const thread_priority priority) {
+#if defined(_WIN32)
+    int value = THREAD_PRIORITY_NORMAL;
+
+    switch (priority) {
+        case thread_priority::normal:
+            value = THREAD_PRIORITY_NORMAL;
+            break;
+
+        case thread_priority::high:
+            value = THREAD_PRIORITY_HIGHEST;
+            break;
+
+        case thread_priority::realtime:
+            value = THREAD_PRIORITY_TIME_CRITICAL;
+            break;
+
+        default:
+            throw std::invalid_argument("The specified thread priority is "
+                "not supported.");
+    }
+
+    if (!::SetThreadPriority(::GetCurrentThread(), value)) {
+        throw std::system_error(::GetLastError(), std::system_category());
+    }
+
+#else /* defined(_WIN32) */
+    sched_param param { 0 };
+    auto policy = SCHED_OTHER;
+    auto nice = 0;
+
+    switch (priority) {
+        case thread_priority::normal:
+            break;
+
+        case thread_priority::high:
+            nice = -10;
+            break;
+
+        case thread_priority::realtime:
+            policy = SCHED_FIFO;
+            param.sched_priority = ::sched_get_priority_max(SCHED_FIFO);
+            break;
+
+        default:
+            throw std::invalid_argument("The specified thread priority is "
+                "not supported.");
+    }
+
+    {
+        auto status = ::pthread_setschedparam(::pthread_self(), policy,
+            &param);
+        if (status != 0) {
+            throw std::system_error(status, std::system_category());
+        }
+    }
+
+    if (policy == SCHED_OTHER) {
+        // On Linux, the nice value is a property of the thread rather than of
+        // the process if the ID of the thread is specified.
+        const auto tid = static_cast<id_t>(::syscall(SYS_gettid));
+        if (::setpriority(PRIO_PROCESS, tid, nice) != 0) {
+            throw std::system_error(errno, std::system_category());
+        }
+    }
+#endif /* defined(_WIN32) */
+}
@@ -5,6 +5,8 @@
 
 #include "power_overwhelming/time_synchroniser.h"
 
+#include <stdexcept>
+
 #include "time_synchroniser_impl.h"
 
 
@@ -39,6 +41,96 @@ visus::power_overwhelming::time_synchroniser::~time_synchroniser(void) {
 }
 
 
+/*
+ * visus::power_overwhelming::time_synchroniser::request
+ */
+visus::power_overwhelming::time_synchroniser&
+visus::power_overwhelming::time_synchroniser::request(
+        _In_z_ const char *peer,
+        _In_ const std::uint16_t port,
+        _In_ const std::size_t cnt) {
+    if (peer == nullptr) {
+        throw std::invalid_argument("The peer to synchronise with must not be "
+            "null.");
+    }
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("A disposed time_synchroniser cannot be "
+            "used.");
+    }
+
+#if defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER)
+    sockaddr_storage addr;
+    const auto addr_length = detail::time_synchroniser_impl::resolve(addr,
+        this->_impl->address_family, peer, port);
+    this->_impl->request(addr, addr_length, cnt);
+#endif /* defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER) */
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::time_synchroniser::to_local
+ */
+bool visus::power_overwhelming::time_synchroniser::to_local(
+        _Inout_updates_(cnt) std::int64_t *timestamps,
+        _In_ const std::size_t cnt,
+        _In_ const timestamp_resolution resolution,
+        _In_z_ const char *peer,
+        _In_ const std::uint16_t port) const {
+    if (peer == nullptr) {
+        throw std::invalid_argument("The peer to synchronise with must not be "
+            "null.");
+    }
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("A disposed time_synchroniser cannot be "
+            "used.");
+    }
+    if (resolution == timestamp_resolution::nanoseconds) {
+        // Cf. detail::create_timestamp, which cannot create them either.
+        throw std::invalid_argument("Time stamps in nanoseconds since 1601 "
+            "cannot be represented and are therefore not supported.");
+    }
+    if ((timestamps == nullptr) || (cnt == 0)) {
+        return true;
+    }
+
+#if defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER)
+    sockaddr_storage addr;
+    detail::time_synchroniser_impl::resolve(addr,
+        this->_impl->address_family, peer, port);
+
+    if (!this->_impl->to_local(nullptr, 0, addr)) {
+        // Do not touch the input if we cannot convert it.
+        return false;
+    }
+
+    // The estimates of the peers are in units of 100 ns, so we convert the
+    // input to this resolution and back. Note that we cannot use floating
+    // point arithmetic for this, because a double does not hold a time
+    // stamp in 100 ns since 1601 exactly.
+    static_assert(sizeof(timestamp_type) == sizeof(std::int64_t),
+        "The public time stamps must match the internal ones.");
+    auto ts = reinterpret_cast<timestamp_type *>(timestamps);
+    const auto hns = timestamp_resolution::hundred_nanoseconds;
+    const auto factor = static_cast<timestamp_type>(
+        detail::ticks_per_second(hns) / detail::ticks_per_second(resolution));
+
+    for (std::size_t i = 0; i < cnt; ++i) {
+        ts[i] *= factor;
+    }
+
+    this->_impl->to_local(ts, cnt, addr);
+    detail::convert(ts, ts, cnt, resolution);
+
+    return true;
+
+#else /* defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER) */
+    return false;
+#endif /* defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER) */
+}
+
+
 /*
  * visus::power_overwhelming::time_synchroniser::operator =
  */
@@ -9,15 +9,19 @@
 #include <cassert>
 #include <chrono>
 #include <cstring>
+#include <stdexcept>
+#include <string>
 #include <system_error>
 
 #if defined(_WIN32)
 #include <WS2tcpip.h>
 #else /* defined(_WIN32) */
 #include <errno.h>
+#include <netdb.h>
 #include <unistd.h>
 #endif /* defined(_WIN32) */
 
+#include "library_thread.h"
 #include "on_exit.h"
 
 
@@ -43,24 +47,36 @@ static inline int WSAGetLastError(void) {
 
 
 /*
- * std::less<sockaddr>::operator ()
+ * std::less<sockaddr_storage>::operator ()
  */
-bool std::less<sockaddr>::operator ()(const sockaddr & lhs,
-        const sockaddr & rhs) const {
-    if (lhs.sa_family == rhs.sa_family) {
-        switch (lhs.sa_family) {
-            case AF_INET:
-                return (::memcmp(&lhs, &rhs, sizeof(sockaddr_in)) < 0);
-
-            case AF_INET6:
-                return (::memcmp(&lhs, &rhs, sizeof(sockaddr_in6)) < 0);
+bool std::less<sockaddr_storage>::operator ()(const sockaddr_storage& lhs,
+        const sockaddr_storage& rhs) const {
+    if (lhs.ss_family == rhs.ss_family) {
+        switch (lhs.ss_family) {
+            case AF_INET: {
+                auto& l = reinterpret_cast<const sockaddr_in&>(lhs);
+                auto& r = reinterpret_cast<const sockaddr_in&>(rhs);
+                const auto retval = ::memcmp(&l.sin_addr, &r.sin_addr,
+                    sizeof(l.sin_addr));
+                return (retval != 0) ? (retval < 0) : (l.sin_port < r.sin_port);
+                }
+
+            case AF_INET6: {
+                auto& l = reinterpret_cast<const sockaddr_in6&>(lhs);
+                auto& r = reinterpret_cast<const sockaddr_in6&>(rhs);
+                const auto retval = ::memcmp(&l.sin6_addr, &r.sin6_addr,
+                    sizeof(l.sin6_addr));
+                return (retval != 0)
+                    ? (retval < 0)
+                    : (l.sin6_port < r.sin6_port);
+                }
 
             default:
-                return (::memcmp(&lhs, &rhs, sizeof(sockaddr)) < 0);
+                return (::memcmp(&lhs, &rhs, sizeof(sockaddr_storage)) < 0);
         }
 
     } else {
-        return lhs.sa_family < rhs.sa_family;
+        return lhs.ss_family < rhs.ss_family;
     }
 }
 
@@ -70,8 +86,9 @@ bool std::less<sockaddr>::operator ()(const sockaddr & lhs,
  */
 visus::power_overwhelming::detail::time_synchroniser_impl
 ::time_synchroniser_impl(void)
-    : grace_period(2), resolution(timestamp_resolution::milliseconds),
-    socket(INVALID_SOCKET), state(0) { }
+    : address_family(AF_UNSPEC), grace_period(2),
+    resolution(timestamp_resolution::hundred_nanoseconds),
+    sequence_number(0), socket(INVALID_SOCKET), state(0) { }
 
 
 /*
@@ -91,14 +108,15 @@ visus::power_overwhelming::detail::time_synchroniser_impl
  * visus::power_overwhelming::detail::time_synchroniser_impl::on_request
  */
 void visus::power_overwhelming::detail::time_synchroniser_impl::on_request(
-        const tsmsg_request *request, const sockaddr& addr,
+        const tsmsg_request *request, const sockaddr_storage& addr,
         const int addr_length) {
     assert(request != nullptr);
     tsmsg_response response(*request);
 
     // Note: fire and forget ...
     ::sendto(this->socket, reinterpret_cast<char *>(&response),
-        sizeof(response), 0, &addr, addr_length);
+        sizeof(response), 0, reinterpret_cast<const sockaddr *>(&addr),
+        addr_length);
 }
 
 
@@ -106,7 +124,7 @@ void visus::power_overwhelming::detail::time_synchroniser_impl::on_request(
  * visus::power_overwhelming::detail::time_synchroniser_impl::on_response
  */
 void visus::power_overwhelming::detail::time_synchroniser_impl::on_response(
-        const tsmsg_response *response, const sockaddr& addr,
+        const tsmsg_response *response, const sockaddr_storage& addr,
         const int addr_length) {
     assert(response != nullptr);
     const auto now = create_timestamp(this->resolution);
@@ -114,21 +132,18 @@ void visus::power_overwhelming::detail::time_synchroniser_impl::on_response(
     // Search the corresponding request for this response. Also, clear all
     // all orphaned requests in the same pass.
     std::lock_guard<decltype(this->lock)> _l(this->lock);
-    for (auto it = this->requests.begin(); it != this->requests.end(); ++it) {
+    auto it = this->requests.begin();
+    while (it != this->requests.end()) {
         if (it->sequence_number == response->sequence_number) {
-            // We found a corresponding request for the response. Update the
-            // estimate for the clock drift based on the round trip time of the
-            // request/response pair and the time we received from the server.
-            assert(it->timestamp >= now);
-            const auto roundtrip = now - it->timestamp;
+            // We found a corresponding request for the response. Add the
+            // request/response pair to the estimate of the clock of the peer,
+            // which pairs the midpoint of the round trip with the time we
+            // received from the peer and fits offset and skew through the
+            // pairs with the shortest round trips.
+            assert(now >= it->timestamp);
             auto& peer = this->peers[addr];
-
-            if (peer.roundtrip > roundtrip) {
-                auto server_time = response->timestamp + (0.5 * roundtrip);
-                peer.roundtrip = roundtrip;
-                peer.timestamp = now;
-                peer.drift = server_time - now;
-            }
+            peer.clock.update(it->timestamp, response->timestamp, now);
+            peer.timestamp = now;
 
             it = this->requests.erase(it);
 
@@ -137,6 +152,9 @@ void visus::power_overwhelming::detail::time_synchroniser_impl::on_response(
             // We consider this request to be orphaned, so we delete it. If we
             // still receive a response for it, it will be ignored.
             it = this->requests.erase(it);
+
+        } else {
+            ++it;
         }
     }
 }
@@ -148,13 +166,12 @@ void visus::power_overwhelming::detail::time_synchroniser_impl::on_response(
 void visus::power_overwhelming::detail::time_synchroniser_impl::receive(
         const int address_family, const std::uint16_t port) {
     assert(this->socket == INVALID_SOCKET);
+    enter_library_thread("PwrOwg Time Synchroniser Thread");
 
-    // Set the state of the receiver and install an exit handler that
-    // marks it stopped if this scope is left. The exit guard will make
-    // sure that the state is reset regardless of whether the thread
-    // existed in an orderly manner or died due to an exception.
-    this->state.store(1, std::memory_order::memory_order_release);
-
+    // Install an exit handler that marks the receiver stopped if this scope
+    // is left. The exit guard will make sure that the state is reset
+    // regardless of whether the thread existed in an orderly manner or died
+    // due to an exception.
     const auto guard_state = on_exit([this](void) {
         this->state.store(0, std::memory_order::memory_order_release);
     });
@@ -224,14 +241,18 @@ void visus::power_overwhelming::detail::time_synchroniser_impl::receive(
                 "the time_synchroniser.");
     } /* end switch (address_family) */
 
+    // The receiver is only running once the socket has been bound, because
+    // requests sent before could not be answered.
+    this->state.store(1, std::memory_order::memory_order_release);
+
     // Receive until indicated to leave.
     while (this->state.load(std::memory_order::memory_order_acquire) == 1) {
-        sockaddr addr;
+        sockaddr_storage addr;
         socklen_t addr_length = sizeof(addr);
         char buffer[TIMESYNC_MAX_DATAGRAM];
 
         const auto cnt = ::recvfrom(this->socket, buffer, sizeof(buffer), 0,
-            &addr, &addr_length);
+            reinterpret_cast<sockaddr *>(&addr), &addr_length);
 
         if (cnt != SOCKET_ERROR) {
             switch (*reinterpret_cast<std::uint32_t *>(buffer)) {
@@ -256,6 +277,77 @@ void visus::power_overwhelming::detail::time_synchroniser_impl::receive(
 }
 
 
+/*
+ * visus::power_overwhelming::detail::time_synchroniser_impl::request
+ */
+void visus::power_overwhelming::detail::time_synchroniser_impl::request(
+        const sockaddr_storage& addr, const int addr_length,
+        const std::size_t cnt) {
+    if ((this->state.load(std::memory_order::memory_order_acquire) != 1)
+            || (this->socket == INVALID_SOCKET)) {
+        throw std::runtime_error("The time_synchroniser is not running.");
+    }
+
+    for (std::size_t i = 0; i < cnt; ++i) {
+        // Register the request before sending it, because the response might
+        // arrive before sendto returns.
+        tsmsg_request request(this->resolution, 0);
+        {
+            std::lock_guard<decltype(this->lock)> l(this->lock);
+            request.sequence_number = this->sequence_number++;
+            request.timestamp = create_timestamp(this->resolution);
+            this->requests.push_back(request);
+        }
+
+        if (::sendto(this->socket, reinterpret_cast<char *>(&request),
+                sizeof(request), 0, reinterpret_cast<const sockaddr *>(&addr),
+                addr_length) == SOCKET_ERROR) {
+            throw std::system_error(::WSAGetLastError(),
+                std::system_category());
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::time_synchroniser_impl::resolve
+ */
+int visus::power_overwhelming::detail::time_synchroniser_impl::resolve(
+        sockaddr_storage& dst, const int address_family, const char *peer,
+        const std::uint16_t port) {
+    assert(peer != nullptr);
+    addrinfo hints = { };
+    hints.ai_family = address_family;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_protocol = IPPROTO_UDP;
+
+    addrinfo *addresses = nullptr;
+    const auto service = std::to_string(port);
+    const auto status = ::getaddrinfo(peer, service.c_str(), &hints,
+        &addresses);
+    if (status != 0) {
+#if defined(_WIN32)
+        throw std::system_error(status, std::system_category());
+#else /* defined(_WIN32) */
+        throw std::runtime_error(::gai_strerror(status));
+#endif /* defined(_WIN32) */
+    }
+
+    const auto guard_addresses = on_exit([addresses](void) {
+        ::freeaddrinfo(addresses);
+    });
+
+    if (addresses == nullptr) {
+        throw std::runtime_error("The address of the peer could not be "
+            "resolved.");
+    }
+
+    ::memset(&dst, 0, sizeof(dst));
+    ::memcpy(&dst, addresses->ai_addr, addresses->ai_addrlen);
+    return static_cast<int>(addresses->ai_addrlen);
+}
+
+
 /*
  * visus::power_overwhelming::detail::time_synchroniser_impl::start
  */
@@ -267,8 +359,15 @@ void visus::power_overwhelming::detail::time_synchroniser_impl::start(
         throw std::runtime_error("The time_synchroniser is already running");
     }
 
+    this->address_family = address_family;
     this->receiver = std::thread(&time_synchroniser_impl::receive,
         this, address_family, port);
+
+    // Wait for the socket to be bound such that requests can be sent as soon
+    // as the synchroniser has been created.
+    while (this->state.load(std::memory_order::memory_order_acquire) == 2) {
+        std::this_thread::yield();
+    }
 }
 
 
@@ -285,9 +384,31 @@ void visus::power_overwhelming::detail::time_synchroniser_impl::stop(void) {
 #if defined(_WIN32)
         ::closesocket(this->socket);
 #else /* defined(_WIN3) */
+        // Closing the socket does not interrupt a blocking recvfrom on Linux,
+        // but shutting it down does.
+        ::shutdown(this->socket, SHUT_RDWR);
         ::close(this->socket);
 #endif /* defined(_WIN3) */
         this->socket = INVALID_SOCKET;
     }
 }
+
+
+/*
+ * visus::power_overwhelming::detail::time_synchroniser_impl::to_local
+ */
+bool visus::power_overwhelming::detail::time_synchroniser_impl::to_local(
+        timestamp_type *timestamps, const std::size_t cnt,
+        const sockaddr_storage& addr) {
+    assert((timestamps != nullptr) || (cnt == 0));
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    auto it = this->peers.find(addr);
+
+    if ((it == this->peers.end()) || !it->second.clock.synchronised()) {
+        return false;
+    }
+
+    it->second.clock.to_host(timestamps, cnt);
+    return true;
+}
 #endif /* defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER) */
@@ -19,6 +19,7 @@
 #include <thread>
 #include <vector>
 
+#include "instrument_clock.h"
 #include "timestamp.h"
 
 
@@ -33,8 +34,9 @@ namespace std {
     /// Specialisation of the <see cref="std::less" /> operator for socket
     /// addresses.
     /// </summary>
-    template<> struct less<sockaddr> {
-        bool operator ()(const sockaddr& lhs, const sockaddr& rhs) const;
+    template<> struct less<sockaddr_storage> {
+        bool operator ()(const sockaddr_storage& lhs,
+            const sockaddr_storage& rhs) const;
     };
 }
 
@@ -82,14 +84,19 @@ namespace detail {
     /// Represents the state of a peer node of the time synchroniser.
     /// </summary>
     struct tsstate {
+
+        /// <summary>
+        /// The estimate of the offset and skew of the clock of the peer, which
+        /// is fitted through the responses with the shortest round trips.
+        /// </summary>
+        instrument_clock clock;
+
+        /// <summary>
+        /// The local time at which the last response has been received.
+        /// </summary>
         timestamp_type timestamp;
-        timestamp_type roundtrip;
-        double drift;
 
-        inline tsstate(void)
-            : timestamp(0),
-            roundtrip((std::numeric_limits<timestamp_type>::max)()),
-            drift(0.0) { }
+        inline tsstate(void) : timestamp(0) { }
     };
 
     /// <summary>
@@ -99,6 +106,12 @@ namespace detail {
     struct time_synchroniser_impl final {
 
 #if defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER)
+        /// <summary>
+        /// The address family of the socket, which is valid once the
+        /// synchroniser has been started.
+        /// </summary>
+        int address_family;
+
         /// <summary>
         /// The grace period for out-of-sequence requests before they are
         /// discarded.
@@ -120,7 +133,7 @@ namespace detail {
         /// <summary>
         /// The peer nodes for which we know the drift.
         /// </summary>
-        std::map<sockaddr, tsstate> peers;
+        std::map<sockaddr_storage, tsstate> peers;
 
         /// <summary>
         /// The receiver thread waiting for incoming synchronisation requests.
@@ -142,8 +155,18 @@ namespace detail {
         /// <summary>
         /// The resolution of the timestamp requests made by the instance.
         /// </summary>
+        /// <remarks>
+        /// This must be <see cref="timestamp_resolution::hundred_nanoseconds" />,
+        /// which is the resolution used by the <see cref="tsstate::clock" />
+        /// of the peers.
+        /// </remarks>
         timestamp_resolution resolution;
 
+        /// <summary>
+        /// The sequence number of the next request.
+        /// </summary>
+        std::uint32_t sequence_number;
+
         /// <summary>
         /// The datagram socket used to exchange network packets.
         /// </summary>
@@ -171,8 +194,8 @@ namespace detail {
         /// <param name="request"></param>
         /// <param name="addr"></param>
         /// <param name="addr_length"></param>
-        void on_request(const tsmsg_request *request, const sockaddr& addr,
-            const int addr_length);
+        void on_request(const tsmsg_request *request,
+            const sockaddr_storage& addr, const int addr_length);
 
         /// <summary>
         /// Handle a response on behalf of <see cref="receive" />.
@@ -180,8 +203,27 @@ namespace detail {
         /// <param name="response"></param>
         /// <param name="addr"></param>
         /// <param name="addr_length"></param>
-        void on_response(const tsmsg_response *response, const sockaddr& addr,
-            const int addr_length);
+        void on_response(const tsmsg_response *response,
+            const sockaddr_storage& addr, const int addr_length);
+
+        /// <summary>
+        /// Sends a batch of timestamp requests to the given peer.
+        /// </summary>
+        /// <remarks>
+        /// Sending multiple requests at once increases the chance that at
+        /// least one of them is not delayed by other traffic, which improves
+        /// the estimate of the clock of the peer.
+        /// </remarks>
+        /// <param name="addr">The address of the peer.</param>
+        /// <param name="addr_length">The length of <paramref name="addr" />
+        /// in bytes.</param>
+        /// <param name="cnt">The number of requests to send.</param>
+        /// <exception cref="std::runtime_error">If the synchroniser is not
+        /// running.</exception>
+        /// <exception cref="std::system_error">If a request could not be
+        /// sent.</exception>
+        void request(const sockaddr_storage& addr, const int addr_length,
+            const std::size_t cnt);
 
         /// <summary>
         /// Runs the receive operations.
@@ -203,6 +245,33 @@ namespace detail {
         /// Stops the time synchroniser if it is running.
         /// </summary>
         void stop(void);
+
+        /// <summary>
+        /// Converts time stamps of the given peer to local time.
+        /// </summary>
+        /// <param name="timestamps">The time stamps in units of 100 ns, which
+        /// are converted in place.</param>
+        /// <param name="cnt">The number of time stamps.</param>
+        /// <param name="addr">The address of the peer.</param>
+        /// <returns><c>true</c> if the clock of the peer is known and the
+        /// time stamps have been converted, <c>false</c> if they have not
+        /// been modified.</returns>
+        bool to_local(timestamp_type *timestamps, const std::size_t cnt,
+            const sockaddr_storage& addr);
+
+        /// <summary>
+        /// Resolves the address of a peer.
+        /// </summary>
+        /// <param name="dst">Receives the address.</param>
+        /// <param name="address_family">The address family of the socket
+        /// used by the synchroniser.</param>
+        /// <param name="peer">The name or address of the peer.</param>
+        /// <param name="port">The port the peer is listening on.</param>
+        /// <returns>The length of the address in bytes.</returns>
+        /// <exception cref="std::system_error">If the name of the peer could
+        /// not be resolved.</exception>
+        static int resolve(sockaddr_storage& dst, const int address_family,
+            const char *peer, const std::uint16_t port);
 #endif /* defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER) */
 
     };
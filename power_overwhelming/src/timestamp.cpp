@@ -5,6 +5,9 @@
 
 #include "timestamp.h"
 
+#include <algorithm>
+#include <cassert>
+
 
 /*
  * visus::power_overwhelming::detail::convert
@@ -13,31 +16,77 @@ visus::power_overwhelming::timestamp_type
 visus::power_overwhelming::detail::convert(
         const timestamp_type file_time,
         const timestamp_resolution resolution) {
-    using namespace std::chrono;
-    duration<decltype(file_time), filetime_period> ft(file_time);
+    return get_timestamp_converter(resolution)(file_time);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::convert
+ */
+void visus::power_overwhelming::detail::convert(
+        _Out_writes_(cnt) timestamp_type *dst,
+        _In_reads_(cnt) const timestamp_type *src,
+        _In_ const std::size_t cnt,
+        _In_ const timestamp_resolution resolution) noexcept {
+    assert((dst != nullptr) || (cnt == 0));
+    assert((src != nullptr) || (cnt == 0));
 
+    // Dispatch once such that the compiler can vectorise the loops, which
+    // all use a factor that is known at compile time.
     switch (resolution) {
-        case timestamp_resolution::microseconds:
-            return duration_cast<microseconds>(ft).count();
+        case timestamp_resolution::seconds:
+            for (std::size_t i = 0; i < cnt; ++i) {
+                dst[i] = convert<timestamp_resolution::seconds>(src[i]);
+            }
+            break;
 
         case timestamp_resolution::milliseconds:
-            return duration_cast<milliseconds>(ft).count();
-
-        case timestamp_resolution::nanoseconds:
-            return duration_cast<nanoseconds>(ft).count();
+            for (std::size_t i = 0; i < cnt; ++i) {
+                dst[i] = convert<timestamp_resolution::milliseconds>(src[i]);
+            }
+            break;
 
-        case timestamp_resolution::hundred_nanoseconds:
-            return file_time;
+        case timestamp_resolution::microseconds:
+            for (std::size_t i = 0; i < cnt; ++i) {
+                dst[i] = convert<timestamp_resolution::microseconds>(src[i]);
+            }
+            break;
 
-        case timestamp_resolution::seconds:
-            return duration_cast<seconds>(ft).count();
+        case timestamp_resolution::nanoseconds:
+            for (std::size_t i = 0; i < cnt; ++i) {
+                dst[i] = convert<timestamp_resolution::nanoseconds>(src[i]);
+            }
+            break;
 
         default:
-            return file_time;
+            if (dst != src) {
+                std::copy(src, src + cnt, dst);
+            }
+            break;
     }
 }
 
 
+/*
+ * visus::power_overwhelming::detail::convert_from_file_time
+ */
+std::chrono::system_clock::time_point
+visus::power_overwhelming::detail::convert_from_file_time(
+        _In_ const timestamp_type file_time) noexcept {
+    using namespace std::chrono;
+    typedef duration<timestamp_type, filetime_period> filetime_dur;
+
+    // The offset of the FILETIME epoch to the UNIX epoch, which must be
+    // removed before the conversion to avoid overflows in nanoseconds like in
+    // convert_to_file_time.
+    const auto dz = filetime_dur(116444736000000000LL);
+    const auto dt = filetime_dur(file_time) - dz;
+
+    return system_clock::from_time_t(0)
+        + duration_cast<system_clock::duration>(dt);
+}
+
+
 /*
  * visus::power_overwhelming::detail::create_timestamp
  */
@@ -53,3 +102,46 @@ visus::power_overwhelming::detail::create_timestamp(
     return detail::convert(std::chrono::system_clock::now(), resolution);
 #endif /* defined(_WIN32) */
 }
+
+
+/*
+ * visus::power_overwhelming::detail::get_timestamp_converter
+ */
+visus::power_overwhelming::detail::timestamp_converter
+visus::power_overwhelming::detail::get_timestamp_converter(
+        _In_ const timestamp_resolution resolution) noexcept {
+    switch (resolution) {
+        case timestamp_resolution::microseconds:
+            return convert<timestamp_resolution::microseconds>;
+
+        case timestamp_resolution::milliseconds:
+            return convert<timestamp_resolution::milliseconds>;
+
+        case timestamp_resolution::nanoseconds:
+            return convert<timestamp_resolution::nanoseconds>;
+
+        case timestamp_resolution::seconds:
+            return convert<timestamp_resolution::seconds>;
+
+        case timestamp_resolution::hundred_nanoseconds:
+        default:
+            return convert<timestamp_resolution::hundred_nanoseconds>;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::ticks_per_second
+ */
+double visus::power_overwhelming::detail::ticks_per_second(
+        _In_ const timestamp_resolution resolution) {
+    switch (resolution) {
+        case timestamp_resolution::hundred_nanoseconds: return 10000000.0;
+        case timestamp_resolution::microseconds: return 1000000.0;
+        case timestamp_resolution::milliseconds: return 1000.0;
+        case timestamp_resolution::nanoseconds: return 1000000000.0;
+        case timestamp_resolution::seconds: return 1.0;
+        default: throw std::invalid_argument("The specified timestamp "
+            "resolution is not supported.");
+    }
+}
@@ -7,6 +7,8 @@
 
 #include <chrono>
 #include <cinttypes>
+#include <cstddef>
+#include <ratio>
 #include <stdexcept>
 
 #if defined(_WIN32)
@@ -33,6 +35,61 @@ namespace power_overwhelming {
 
 namespace detail {
 
+    /// <summary>
+    /// A function converting a raw <see cref="FILETIME" /> in 100ns units to
+    /// a timestamp of a fixed resolution.
+    /// </summary>
+    typedef timestamp_type (*timestamp_converter)(
+        _In_ const timestamp_type file_time);
+
+    /// <summary>
+    /// Allows for resolving the STL period of ticks of the specified
+    /// timestamp resolution.
+    /// </summary>
+    template<timestamp_resolution Resolution> struct timestamp_period final { };
+
+    template<> struct timestamp_period<timestamp_resolution::seconds> final {
+        typedef std::ratio<1> type;
+    };
+
+    template<>
+    struct timestamp_period<timestamp_resolution::milliseconds> final {
+        typedef std::milli type;
+    };
+
+    template<>
+    struct timestamp_period<timestamp_resolution::microseconds> final {
+        typedef std::micro type;
+    };
+
+    template<>
+    struct timestamp_period<timestamp_resolution::hundred_nanoseconds> final {
+        typedef filetime_period type;
+    };
+
+    template<>
+    struct timestamp_period<timestamp_resolution::nanoseconds> final {
+        typedef std::nano type;
+    };
+
+    /// <summary>
+    /// Convert the given raw <see cref="FILETIME" /> to a timestamp of the
+    /// resolution selected at compile time.
+    /// </summary>
+    /// <remarks>
+    /// The conversion factor is resolved at compile time, wherefore the
+    /// conversion is a single multiplication or division. The result is the
+    /// same as the one of the conversion with a run-time resolution,
+    /// including the overflow of absolute time stamps in nanoseconds.
+    /// </remarks>
+    /// <typeparam name="Resolution">The desired resolution of the timestamp.
+    /// </typeparam>
+    /// <param name="file_time">The file time value in 100ns units.</param>
+    /// <returns>The timestamp in the requested resolution.</returns>
+    template<timestamp_resolution Resolution>
+    constexpr timestamp_type convert(
+        _In_ const timestamp_type file_time) noexcept;
+
     /// <summary>
     /// Convert the given raw <see cref="FILETIME" /> to a timestamp of the
     /// specified resolution.
@@ -49,6 +106,28 @@ namespace detail {
         const timestamp_type file_time,
         const timestamp_resolution resolution);
 
+    /// <summary>
+    /// Convert the given raw <see cref="FILETIME" />s to timestamps of the
+    /// specified resolution.
+    /// </summary>
+    /// <remarks>
+    /// The resolution is only evaluated once for the whole array, which
+    /// makes this method preferable over individual conversions when
+    /// processing batches of samples.
+    /// </remarks>
+    /// <param name="dst">Receives <paramref name="cnt" /> timestamps. This
+    /// may be the same as <paramref name="src" />, but must not partially
+    /// overlap with it.</param>
+    /// <param name="src">The file time values in 100ns units.</param>
+    /// <param name="cnt">The number of values to convert.</param>
+    /// <param name="resolution">The desired resolution of the timestamps.
+    /// </param>
+    void POWER_OVERWHELMING_API convert(
+        _Out_writes_(cnt) timestamp_type *dst,
+        _In_reads_(cnt) const timestamp_type *src,
+        _In_ const std::size_t cnt,
+        _In_ const timestamp_resolution resolution) noexcept;
+
 #if defined(_WIN32)
     /// <summary>
     /// Convert the given raw <see cref="LARGE_INTEGER" /> to a timestamp of the
@@ -110,6 +189,31 @@ namespace detail {
             TDuration>& timestamp,
         _In_ const timestamp_resolution resolution);
 
+    /// <summary>
+    /// Convert an STL time point to a raw <see cref="FILETIME" />.
+    /// </summary>
+    /// <typeparam name="TDuration"></typeparam>
+    /// <param name="timestamp">The STL time point to convert.</param>
+    /// <returns>The time stamp in 100ns units since the epoch of
+    /// <see cref="FILETIME" />, which can be converted to other resolutions
+    /// using a <see cref="timestamp_converter" />.</returns>
+    template<class TDuration> timestamp_type convert_to_file_time(
+        _In_ const std::chrono::time_point<std::chrono::system_clock,
+            TDuration>& timestamp);
+
+    /// <summary>
+    /// Convert a raw <see cref="FILETIME" /> to an STL time point.
+    /// </summary>
+    /// <remarks>
+    /// This is the inverse of <see cref="convert_to_file_time" />, which is
+    /// required for sources that deliver <see cref="FILETIME" />s, like the
+    /// kernel-mode sampler of the RAPL driver.
+    /// </remarks>
+    /// <param name="file_time">The file time value in 100ns units.</param>
+    /// <returns>The time point of the system clock.</returns>
+    std::chrono::system_clock::time_point POWER_OVERWHELMING_API
+    convert_from_file_time(_In_ const timestamp_type file_time) noexcept;
+
     /// <summary>
     /// Create a new timestamp using the specified resolution per tick.
     /// </summary>
@@ -121,6 +225,33 @@ namespace detail {
     timestamp_type POWER_OVERWHELMING_API create_timestamp(
         _In_ const timestamp_resolution resolution);
 
+    /// <summary>
+    /// Answer the converter from raw <see cref="FILETIME" />s to timestamps of
+    /// the specified resolution.
+    /// </summary>
+    /// <remarks>
+    /// Sampler contexts should resolve the converter once when a sensor is
+    /// added instead of selecting the resolution for every sample.
+    /// </remarks>
+    /// <param name="resolution">The desired resolution of the timestamps.
+    /// </param>
+    /// <returns>A pointer to the specialisation of <see cref="convert" />
+    /// for <paramref name="resolution" />. Unknown resolutions yield the
+    /// identity like <see cref="convert" /> does.</returns>
+    timestamp_converter POWER_OVERWHELMING_API get_timestamp_converter(
+        _In_ const timestamp_resolution resolution) noexcept;
+
+    /// <summary>
+    /// Answer how many ticks of a timestamp with the specified resolution make
+    /// up one second.
+    /// </summary>
+    /// <param name="resolution">The resolution of the timestamp.</param>
+    /// <returns>The number of ticks per second.</returns>
+    /// <exception cref="std::invalid_argument">If the
+    /// <paramref name="resolution" /> is not supported.</exception>
+    double POWER_OVERWHELMING_API ticks_per_second(
+        _In_ const timestamp_resolution resolution);
+
 } /* namespace detail */
 } /* namespace power_overwhelming */
 } /* namespace visus */
@@ -48,6 +48,21 @@ visus::power_overwhelming::detail::timestamp<Resolution>::create(
 #endif
 
 
+/*
+ * visus::power_overwhelming::detail::convert
+ */
+template<visus::power_overwhelming::timestamp_resolution Resolution>
+constexpr visus::power_overwhelming::timestamp_type
+visus::power_overwhelming::detail::convert(
+        _In_ const timestamp_type file_time) noexcept {
+    typedef std::ratio_divide<filetime_period,
+        typename timestamp_period<Resolution>::type> factor;
+    return (factor::den == 1)
+        ? file_time * factor::num
+        : file_time * factor::num / factor::den;
+}
+
+
 /*
  * visus::power_overwhelming::detail::convert
  */
@@ -57,40 +72,49 @@ visus::power_overwhelming::detail::convert(
         _In_ const std::chrono::time_point<std::chrono::system_clock,
             TDuration>& timestamp,
         _In_ const timestamp_resolution resolution) {
-    using namespace std::chrono;
-    typedef duration<timestamp_type, filetime_period> filetime_dur;
-
-    // The offset of the FILETIME epoch to the UNIX epoch.
-    const auto dz = duration<timestamp_type,
-        detail::filetime_period>(116444736000000000LL);
-
-    // Find out what the difference between the time point and the UNIX
-    // epoch is. Because we cannot rely on the epoch of the STL clock being the
-    // UNIX epoch (until C++ 20), use time_t, which is guaranteed to represent
-    // the UNIX epoch.
-    auto dt = time_point_cast<system_clock::duration>(timestamp)
-        - system_clock::from_time_t(0);
-
-    // Transform the origin of the timestamp clock to the origin of FILETIME.
     switch (resolution) {
         case timestamp_resolution::hundred_nanoseconds:
-            return duration_cast<filetime_dur>(dt + dz).count();
-
         case timestamp_resolution::microseconds:
-            return duration_cast<microseconds>(dt + dz).count();
-
         case timestamp_resolution::milliseconds:
-            return duration_cast<milliseconds>(dt + dz).count();
+        case timestamp_resolution::seconds:
+            return get_timestamp_converter(resolution)(
+                convert_to_file_time(timestamp));
 
         // TODO: This overflows, so we do not support it.
         //case timestamp_resolution::nanoseconds:
-        //    return duration_cast<nanoseconds>(dt + dz).count();
-
-        case timestamp_resolution::seconds:
-            return duration_cast<seconds>(dt + dz).count();
 
         default:
             throw std::invalid_argument("The specified timestamp_resolution "
                 "is unsupported.");
     }
-}
\ No newline at end of file
+}
+
+
+/*
+ * visus::power_overwhelming::detail::convert_to_file_time
+ */
+template<class TDuration>
+visus::power_overwhelming::timestamp_type
+visus::power_overwhelming::detail::convert_to_file_time(
+        _In_ const std::chrono::time_point<std::chrono::system_clock,
+            TDuration>& timestamp) {
+    using namespace std::chrono;
+    typedef duration<timestamp_type, filetime_period> filetime_dur;
+
+    // The offset of the FILETIME epoch to the UNIX epoch.
+    const auto dz = filetime_dur(116444736000000000LL);
+
+    // Find out what the difference between the time point and the UNIX
+    // epoch is. Because we cannot rely on the epoch of the STL clock being the
+    // UNIX epoch (until C++ 20), use time_t, which is guaranteed to represent
+    // the UNIX epoch.
+    // Note that the difference must be converted to FILETIME units before
+    // adding the offset, because the offset does not fit into nanoseconds,
+    // which is the resolution of system_clock for many STL implementations.
+    auto dt = duration_cast<filetime_dur>(
+        time_point_cast<system_clock::duration>(timestamp)
+        - system_clock::from_time_t(0));
+
+    // Transform the origin of the timestamp clock to the origin of FILETIME.
+    return (dt + dz).count();
+}
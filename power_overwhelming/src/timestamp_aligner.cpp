@@ -0,0 +1,106 @@
+﻿// <copyright file="timestamp_aligner.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "timestamp_aligner.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+#include "sensor_name_registry.h"
+
+
+/*
+ * visus::power_overwhelming::detail::timestamp_aligner::add_delay
+ */
+void visus::power_overwhelming::detail::timestamp_aligner::add_delay(
+        _In_z_ const wchar_t *sensor,
+        _In_ const measurement::timestamp_type delay) {
+    assert(sensor != nullptr);
+    state_type state;
+    state.aligned = (std::numeric_limits<measurement::timestamp_type>::min)();
+    state.fixed = true;
+    state.latency = (std::max)(delay, measurement::timestamp_type(0));
+    state.interval = 2.0 * state.latency;
+    state.previous = state.aligned;
+    this->_states[sensor_name_registry::intern(sensor)] = state;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::timestamp_aligner::add_trailing
+ */
+void visus::power_overwhelming::detail::timestamp_aligner::add_trailing(
+        _In_z_ const wchar_t *sensor,
+        _In_ const measurement::timestamp_type interval) {
+    assert(sensor != nullptr);
+    state_type state;
+    state.aligned = (std::numeric_limits<measurement::timestamp_type>::min)();
+    state.fixed = false;
+    state.interval = static_cast<double>((std::max)(interval,
+        measurement::timestamp_type(0)));
+    state.latency = static_cast<measurement::timestamp_type>(
+        state.interval / 2.0 + 0.5);
+    state.previous = state.aligned;
+    this->_states[sensor_name_registry::intern(sensor)] = state;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::timestamp_aligner::align
+ */
+visus::power_overwhelming::measurement
+visus::power_overwhelming::detail::timestamp_aligner::align(
+        _In_ const measurement& sample) {
+    if (this->_states.empty()) {
+        return sample;
+    }
+
+    auto it = this->_states.find(sample.sensor());
+    if (it == this->_states.end()) {
+        return sample;
+    }
+
+    // The smoothing factor of 1/8 follows the estimator of the round-trip
+    // time in TCP, which is robust against the jitter of single samples.
+    auto& state = it->second;
+    const auto timestamp = sample.timestamp();
+    if (!state.fixed && (state.previous != (std::numeric_limits<
+            measurement::timestamp_type>::min)())
+            && (timestamp > state.previous)) {
+        const auto dt = static_cast<double>(timestamp - state.previous);
+        state.interval += (dt - state.interval) / 8.0;
+        state.latency = static_cast<measurement::timestamp_type>(
+            state.interval / 2.0 + 0.5);
+    }
+    state.previous = timestamp;
+
+    state.aligned = (std::max)(state.aligned, timestamp - state.latency);
+
+    auto& data = sample.data();
+    return measurement(sample.sensor(), measurement_data(state.aligned,
+        data.voltage(), data.current(), data.power()));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::timestamp_aligner::latency
+ */
+visus::power_overwhelming::measurement::timestamp_type
+visus::power_overwhelming::detail::timestamp_aligner::latency(
+        _In_z_ const wchar_t *sensor) const {
+    assert(sensor != nullptr);
+    auto it = this->_states.find(sensor_name_registry::intern(sensor));
+    return (it != this->_states.end()) ? it->second.latency : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::timestamp_aligner::reset
+ */
+void visus::power_overwhelming::detail::timestamp_aligner::reset(
+        void) noexcept {
+    this->_states.clear();
+}
@@ -0,0 +1,105 @@
+﻿// <copyright file="timestamp_aligner.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <unordered_map>
+
+#include "power_overwhelming/measurement.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Moves the timestamps of sensors that stamp their samples after an
+    /// averaging period to the middle of this period.
+    /// </summary>
+    /// <remarks>
+    /// <para>All sensors create their timestamps on the same clock, but the
+    /// instant they refer to differs: RAPL and EMI sensors stamp the middle
+    /// of the interval they report the average power for, whereas ADL, NVML,
+    /// Tinkerforge and HMC8015 sensors stamp the instant the data arrived,
+    /// which is after the period the data have been averaged over. The
+    /// aligner estimates the latency of the latter as half of their actual
+    /// interval, which it tracks as an exponential moving average of the
+    /// distance between consecutive samples.</para>
+    /// <para>Sensors whose delay has been calibrated, for instance from their
+    /// response to steps of the load, are moved back by this fixed delay
+    /// instead of the estimate.</para>
+    /// <para>The aligned timestamps of a sensor never decrease.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API timestamp_aligner final {
+
+    public:
+
+        /// <summary>
+        /// Initialises a new instance, which does not change any sample.
+        /// </summary>
+        timestamp_aligner(void) = default;
+
+        /// <summary>
+        /// Registers a sensor whose samples lag the actual power by the given
+        /// fixed delay.
+        /// </summary>
+        /// <remarks>
+        /// The delay replaces the estimate if the sensor has been registered
+        /// via <see cref="add_trailing" /> before and vice versa.
+        /// </remarks>
+        /// <param name="sensor">The name of the sensor.</param>
+        /// <param name="delay">The delay in ticks of the timestamps.</param>
+        void add_delay(_In_z_ const wchar_t *sensor,
+            _In_ const measurement::timestamp_type delay);
+
+        /// <summary>
+        /// Registers a sensor that stamps its samples after an averaging
+        /// period.
+        /// </summary>
+        /// <param name="sensor">The name of the sensor.</param>
+        /// <param name="interval">The expected interval of the sensor in ticks
+        /// of the timestamps, which is the initial estimate.</param>
+        void add_trailing(_In_z_ const wchar_t *sensor,
+            _In_ const measurement::timestamp_type interval);
+
+        /// <summary>
+        /// Aligns the timestamp of the given sample.
+        /// </summary>
+        /// <param name="sample">The sample to be aligned.</param>
+        /// <returns>The sample with the aligned timestamp, which is a copy of
+        /// <paramref name="sample" /> if the sensor has not been registered.
+        /// </returns>
+        measurement align(_In_ const measurement& sample);
+
+        /// <summary>
+        /// Answer the current estimate of the latency of the given sensor.
+        /// </summary>
+        /// <param name="sensor">The name of the sensor.</param>
+        /// <returns>The latency in ticks of the timestamps, which is zero if
+        /// the sensor has not been registered.</returns>
+        measurement::timestamp_type latency(
+            _In_z_ const wchar_t *sensor) const;
+
+        /// <summary>
+        /// Unregisters all sensors.
+        /// </summary>
+        void reset(void) noexcept;
+
+    private:
+
+        struct state_type {
+            measurement::timestamp_type aligned;
+            bool fixed;
+            double interval;
+            measurement::timestamp_type latency;
+            measurement::timestamp_type previous;
+        };
+
+        std::unordered_map<const wchar_t *, state_type> _states;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
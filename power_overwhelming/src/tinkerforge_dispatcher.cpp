@@ -0,0 +1,234 @@
+﻿// <copyright file="tinkerforge_dispatcher.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "tinkerforge_dispatcher.h"
+
+#include <cassert>
+
+#include "library_thread.h"
+
+
+/*
+ * ...::detail::tinkerforge_dispatcher::queue::queue
+ */
+visus::power_overwhelming::detail::tinkerforge_dispatcher::queue::queue(
+        const handler_type handler, void *context, const std::size_t capacity)
+    : _context(context), _handler(handler), _max_depth(0),
+        _readings(capacity) {
+    assert(handler != nullptr);
+    this->_batch.reserve(this->_readings.capacity());
+}
+
+
+/*
+ * ...::detail::tinkerforge_dispatcher::queue::drain
+ */
+std::size_t visus::power_overwhelming::detail::tinkerforge_dispatcher::queue
+::drain(const bool deliver) {
+    // Copy the readings out of the ring before handing them to the handler
+    // such that the producer can reuse the slots while the handler is running.
+    this->_batch.clear();
+    const auto retval = this->_readings.drain([this](
+            const tinkerforge_reading& r,
+            const spsc_ring<tinkerforge_reading>::position_type) {
+        this->_batch.push_back(r);
+    });
+
+    if (retval > this->_max_depth.load(std::memory_order_relaxed)) {
+        this->_max_depth.store(retval, std::memory_order_relaxed);
+    }
+
+    if (deliver && !this->_batch.empty()) {
+        this->_handler(this->_batch.data(), this->_batch.size(),
+            this->_context);
+    }
+
+    return retval;
+}
+
+
+/*
+ * ...::detail::tinkerforge_dispatcher::queue::default_capacity
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::tinkerforge_dispatcher::queue
+::default_capacity;
+
+
+/*
+ * ...::detail::tinkerforge_dispatcher::dispatch_interval
+ */
+constexpr visus::power_overwhelming::detail::tinkerforge_dispatcher
+::interval_type
+visus::power_overwhelming::detail::tinkerforge_dispatcher::dispatch_interval;
+
+
+/*
+ * ...::detail::tinkerforge_dispatcher::tinkerforge_dispatcher
+ */
+visus::power_overwhelming::detail::tinkerforge_dispatcher
+::tinkerforge_dispatcher(void)
+    : _active(std::make_shared<snapshot_type>()), _epoch(0),
+        _running(false) { }
+
+
+/*
+ * ...::detail::tinkerforge_dispatcher::~tinkerforge_dispatcher
+ */
+visus::power_overwhelming::detail::tinkerforge_dispatcher
+::~tinkerforge_dispatcher(void) {
+    if (this->_thread.joinable()) {
+        if (this->_thread.get_id() == std::this_thread::get_id()) {
+            // A handler has released the last reference to the connection.
+            this->_thread.detach();
+        } else {
+            this->_thread.join();
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::tinkerforge_dispatcher::add
+ */
+bool visus::power_overwhelming::detail::tinkerforge_dispatcher::add(
+        std::shared_ptr<queue> queue) {
+    assert(queue != nullptr);
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+
+    if (this->_queues.find(queue.get()) != this->_queues.end()) {
+        return false;
+    }
+
+    // As long as the queue is not registered, we are its only consumer, so we
+    // can safely discard what the callbacks have pushed after the queue was
+    // removed the last time.
+    queue->drain(false);
+
+    this->_queues.emplace(queue.get(), std::move(queue));
+    this->publish();
+
+    if (!this->_running) {
+        if (this->_thread.joinable()) {
+            // The previous thread has already marked itself as not running, so
+            // it is about to exit.
+            this->_thread.join();
+        }
+
+        this->_running = true;
+        this->_thread = std::thread(&tinkerforge_dispatcher::dispatch, this);
+    }
+
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::tinkerforge_dispatcher::remove
+ */
+bool visus::power_overwhelming::detail::tinkerforge_dispatcher::remove(
+        const std::shared_ptr<queue>& queue) {
+    auto is_dispatcher_thread = false;
+
+    {
+        std::lock_guard<decltype(this->_lock)> l(this->_lock);
+        auto it = this->_queues.find(queue.get());
+        if (it == this->_queues.end()) {
+            return false;
+        }
+
+        this->_queues.erase(it);
+        this->publish();
+        is_dispatcher_thread = (this->_thread.get_id()
+            == std::this_thread::get_id());
+    }
+
+    if (!is_dispatcher_thread) {
+        // Make sure that the dispatcher thread is not draining the queue
+        // anymore before we take over as consumer and deliver what is left.
+        // If we are on the dispatcher thread, we might be within the handler
+        // of the very queue, so we must not touch it.
+        this->synchronise();
+        queue->drain(true);
+    }
+
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::tinkerforge_dispatcher::dispatch
+ */
+void visus::power_overwhelming::detail::tinkerforge_dispatcher::dispatch(
+        void) {
+    enter_library_thread("PwrOwg Tinkerforge Dispatcher Thread");
+
+    while (true) {
+        auto have_queues = true;
+
+        // Mark the begin of the dispatch *before* obtaining the snapshot like
+        // the default_sampler_context does.
+        ++this->_epoch;
+        {
+            auto queues = std::atomic_load(&this->_active);
+            assert(queues != nullptr);
+
+            for (auto& q : *queues) {
+                q->drain(true);
+            }
+
+            have_queues = !queues->empty();
+        }
+        ++this->_epoch;
+
+        if (!have_queues) {
+            // Check again under the lock whether we can exit, because a queue
+            // might have been added since we obtained the snapshot, in which
+            // case the thread must not exit.
+            std::lock_guard<decltype(this->_lock)> l(this->_lock);
+            if (this->_queues.empty()) {
+                this->_running = false;
+                break;
+            }
+        }
+
+        std::this_thread::sleep_for(dispatch_interval);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::tinkerforge_dispatcher::publish
+ */
+void visus::power_overwhelming::detail::tinkerforge_dispatcher::publish(
+        void) {
+    auto snapshot = std::make_shared<snapshot_type>();
+    snapshot->reserve(this->_queues.size());
+
+    for (auto& q : this->_queues) {
+        snapshot->push_back(q.second);
+    }
+
+    std::atomic_store(&this->_active,
+        std::shared_ptr<const snapshot_type>(std::move(snapshot)));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::tinkerforge_dispatcher::synchronise
+ */
+void visus::power_overwhelming::detail::tinkerforge_dispatcher::synchronise(
+        void) const {
+    const auto epoch = this->_epoch.load();
+
+    if ((epoch & 1) != 0) {
+        // The dispatcher is within a pass over the queues, so wait until it
+        // has left it. It is irrelevant whether it entered a new one since
+        // then, because the new one will use the updated snapshot.
+        while (this->_epoch.load() == epoch) {
+            std::this_thread::yield();
+        }
+    }
+}
@@ -0,0 +1,280 @@
+﻿// <copyright file="tinkerforge_dispatcher.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "power_overwhelming/measurement.h"
+#include "power_overwhelming/tinkerforge_sensor_source.h"
+
+#include "spsc_ring.h"
+#include "timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A single reading received from a bricklet callback.
+    /// </summary>
+    struct tinkerforge_reading final {
+
+        /// <summary>
+        /// The quantity that has been read.
+        /// </summary>
+        tinkerforge_sensor_source source;
+
+        /// <summary>
+        /// The time when the reading has been received in 100 ns units.
+        /// </summary>
+        timestamp_type timestamp;
+
+        /// <summary>
+        /// The value of the reading in SI units.
+        /// </summary>
+        measurement::value_type value;
+    };
+
+
+    /// <summary>
+    /// Moves the delivery of bricklet callbacks off the callback thread of a
+    /// Tinkerforge <see cref="IPConnection" />.
+    /// </summary>
+    /// <remarks>
+    /// <para>The Tinkerforge bindings invoke the callbacks of all bricklets
+    /// on a connection on a single thread. If this thread spends too much time
+    /// in user code, it cannot keep up with the Brick daemon, which will drop
+    /// packets. Therefore, the callbacks only push their readings into the
+    /// <see cref="queue" /> of their bricklet, which is backed by a lock-free
+    /// <see cref="spsc_ring" />, and return immediately.</para>
+    /// <para>The dispatcher drains all of its queues about every
+    /// <see cref="dispatch_interval" /> on a dedicated thread and passes the
+    /// readings of each queue in a single batch to the handler of the queue.
+    /// If a queue is full, the new reading is dropped and counted in the
+    /// statistics of the queue.</para>
+    /// <para>There is one dispatcher per connection, which is owned by the
+    /// <see cref="tinkerforge_scope" />. The dispatcher thread only runs while
+    /// there are queues registered.</para>
+    /// </remarks>
+    class tinkerforge_dispatcher final {
+
+    public:
+
+        /// <summary>
+        /// The callback receiving a batch of readings from a queue.
+        /// </summary>
+        typedef void (*handler_type)(const tinkerforge_reading *readings,
+            const std::size_t cnt, void *context);
+
+        /// <summary>
+        /// A lock-free single-producer single-consumer queue of readings from
+        /// a single bricklet.
+        /// </summary>
+        /// <remarks>
+        /// The producer is the callback thread of the connection. The consumer
+        /// is the dispatcher thread while the queue is registered with the
+        /// dispatcher, or the thread adding or removing the queue otherwise.
+        /// </remarks>
+        class queue final {
+
+        public:
+
+            /// <summary>
+            /// Initialises a new instance.
+            /// </summary>
+            /// <param name="handler">The callback receiving the readings
+            /// during dispatch.</param>
+            /// <param name="context">A user-defined context pointer passed to
+            /// <paramref name="handler" />.</param>
+            /// <param name="capacity">The maximum number of readings the queue
+            /// can hold, which will be rounded up to the next power of two.
+            /// </param>
+            queue(const handler_type handler, void *context,
+                const std::size_t capacity = default_capacity);
+
+            queue(const queue&) = delete;
+
+            /// <summary>
+            /// Answer the maximum number of readings that can be queued.
+            /// </summary>
+            /// <returns>The capacity of the queue.</returns>
+            inline std::size_t capacity(void) const noexcept {
+                return this->_readings.capacity();
+            }
+
+            /// <summary>
+            /// Answer the number of readings that have been dropped because the
+            /// queue was full.
+            /// </summary>
+            /// <returns>The number of dropped readings.</returns>
+            inline std::uint64_t dropped(void) const noexcept {
+                return this->_readings.overflows();
+            }
+
+            /// <summary>
+            /// Answer the number of readings currently in the queue.
+            /// </summary>
+            /// <returns>The current depth of the queue.</returns>
+            inline std::size_t depth(void) const noexcept {
+                return this->_readings.size();
+            }
+
+            /// <summary>
+            /// Answer the largest number of readings that the dispatcher has
+            /// found in the queue at once.
+            /// </summary>
+            /// <returns>The maximum depth of the queue.</returns>
+            inline std::size_t max_depth(void) const noexcept {
+                return this->_max_depth.load(std::memory_order_relaxed);
+            }
+
+            /// <summary>
+            /// Enqueues a reading.
+            /// </summary>
+            /// <remarks>
+            /// This method must only be called by the producer. It never
+            /// blocks and never allocates memory.
+            /// </remarks>
+            /// <param name="reading">The reading to be added.</param>
+            /// <returns><c>true</c> if the reading has been added, <c>false</c>
+            /// if it has been dropped.</returns>
+            inline bool push(const tinkerforge_reading& reading) {
+                return (this->_readings.push(reading) > 0);
+            }
+
+            queue& operator =(const queue&) = delete;
+
+        private:
+
+            /// <summary>
+            /// The capacity of a queue if not specified otherwise, which is
+            /// enough for all three callbacks of a bricklet running at 1 ms
+            /// for about a third of a second.
+            /// </summary>
+            static constexpr std::size_t default_capacity = 1024;
+
+            /// <summary>
+            /// Removes all readings from the queue and passes them to
+            /// <see cref="_handler" /> if <paramref name="deliver" /> is set.
+            /// </summary>
+            /// <remarks>
+            /// This method must only be called by the consumer.
+            /// </remarks>
+            /// <returns>The number of readings that have been removed.
+            /// </returns>
+            std::size_t drain(const bool deliver);
+
+            std::vector<tinkerforge_reading> _batch;
+            void *_context;
+            handler_type _handler;
+            std::atomic<std::size_t> _max_depth;
+            spsc_ring<tinkerforge_reading> _readings;
+
+            friend class tinkerforge_dispatcher;
+        };
+
+        /// <summary>
+        /// The type of the interval at which the queues are drained.
+        /// </summary>
+        typedef std::chrono::milliseconds interval_type;
+
+        /// <summary>
+        /// The interval at which the dispatcher drains the queues, which
+        /// matches the shortest callback period supported by the bricklets.
+        /// </summary>
+        static constexpr interval_type dispatch_interval
+            = std::chrono::milliseconds(1);
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        tinkerforge_dispatcher(void);
+
+        tinkerforge_dispatcher(const tinkerforge_dispatcher&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        /// <remarks>
+        /// All queues must have been removed before the dispatcher is
+        /// destroyed.
+        /// </remarks>
+        ~tinkerforge_dispatcher(void);
+
+        /// <summary>
+        /// Registers a queue with the dispatcher, starting the dispatcher
+        /// thread if necessary.
+        /// </summary>
+        /// <remarks>
+        /// Any readings that have been left in the queue from a previous
+        /// registration are discarded.
+        /// </remarks>
+        /// <param name="queue">The queue to be dispatched.</param>
+        /// <returns><c>true</c> if the queue has been added, <c>false</c> if
+        /// it was already registered.</returns>
+        bool add(std::shared_ptr<queue> queue);
+
+        /// <summary>
+        /// Removes a queue from the dispatcher.
+        /// </summary>
+        /// <remarks>
+        /// If the queue has been removed, the method blocks until the
+        /// dispatcher thread does not use it anymore unless it is called from
+        /// within a handler on the dispatcher thread itself. The readings left
+        /// in the queue are delivered on the calling thread.
+        /// </remarks>
+        /// <param name="queue">The queue to be removed.</param>
+        /// <returns><c>true</c> if the queue has been removed, <c>false</c> if
+        /// it was not registered.</returns>
+        bool remove(const std::shared_ptr<queue>& queue);
+
+        tinkerforge_dispatcher& operator =(
+            const tinkerforge_dispatcher&) = delete;
+
+    private:
+
+        typedef std::vector<std::shared_ptr<queue>> snapshot_type;
+
+        /// <summary>
+        /// Drains the queues until none is left.
+        /// </summary>
+        void dispatch(void);
+
+        /// <summary>
+        /// Publishes a new snapshot of <see cref="_queues" /> to the dispatcher
+        /// thread.
+        /// </summary>
+        /// <remarks>
+        /// The caller must hold <see cref="_lock" />.
+        /// </remarks>
+        void publish(void);
+
+        /// <summary>
+        /// Blocks the calling thread until the dispatcher thread has completed
+        /// the dispatch that might have been in progress when the method was
+        /// called.
+        /// </summary>
+        void synchronise(void) const;
+
+        std::shared_ptr<const snapshot_type> _active;
+        std::atomic<std::uint64_t> _epoch;
+        std::mutex _lock;
+        std::map<queue *, std::shared_ptr<queue>> _queues;
+        bool _running;
+        std::thread _thread;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -57,6 +57,14 @@ visus::power_overwhelming::tinkerforge_display::tinkerforge_display(
 }
 
 
+/*
+ * visus::power_overwhelming::tinkerforge_display::~tinkerforge_display
+ */
+visus::power_overwhelming::tinkerforge_display::~tinkerforge_display(void) {
+    delete this->_impl;
+}
+
+
 /*
  * visus::power_overwhelming::tinkerforge_display::clear
  */
@@ -98,6 +106,35 @@ void visus::power_overwhelming::tinkerforge_display::print(
 }
 
 
+/*
+ * visus::power_overwhelming::tinkerforge_display::print_async
+ */
+void visus::power_overwhelming::tinkerforge_display::print_async(
+        _In_z_ const char *text,
+        _In_ const std::uint8_t x,
+        _In_ const std::uint8_t y,
+        _In_ const std::uint8_t font,
+        _In_ const bool colour) {
+    if (!*this) {
+        throw std::runtime_error("A disposed instance of tinkerforge_display "
+            "cannot be used to print text.");
+    }
+    if (text == nullptr) {
+        throw std::invalid_argument("The text cannot be null.");
+    }
+
+    // Report any error from the previous asynchronous print, but still queue
+    // the new text, because the caller cannot retry the one that failed.
+    auto status = this->_impl->async_status.exchange(E_OK,
+        std::memory_order_relaxed);
+    this->_impl->print_async(text, x, y, font, colour);
+
+    if (status < 0) {
+        throw tinkerforge_exception(status);
+    }
+}
+
+
 /*
  * visus::power_overwhelming::tinkerforge_display::operator =
  */
@@ -105,6 +142,7 @@ visus::power_overwhelming::tinkerforge_display&
 visus::power_overwhelming::tinkerforge_display::operator =(
         _In_ tinkerforge_display&& rhs) noexcept {
     if (this != std::addressof(rhs)) {
+        delete this->_impl;
         this->_impl = rhs._impl;
         rhs._impl = nullptr;
     }
@@ -5,13 +5,19 @@
 
 #include "tinkerforge_display_impl.h"
 
+#include <cassert>
+
+#include "library_thread.h"
+
 
 /*
  * visus::power_overwhelming::detail::tinkerforge_display_impl::tinkerforge_display_impl
  */
 visus::power_overwhelming::detail::tinkerforge_display_impl::tinkerforge_display_impl(
         const std::string& host, const std::uint16_t port, const char *uid)
-        : scope(host, port) {
+        : async_running(true), async_status(E_OK), scope(host, port) {
+    this->async_text.pending = false;
+
     if (uid == nullptr) {
         // Scope will be destructed automatically as it was initialised in the
         // initialiser list.
@@ -28,5 +34,86 @@ visus::power_overwhelming::detail::tinkerforge_display_impl::tinkerforge_display
  */
 visus::power_overwhelming::detail::tinkerforge_display_impl::~tinkerforge_display_impl(
         void) {
+    {
+        std::lock_guard<decltype(this->async_lock)> l(this->async_lock);
+        this->async_running = false;
+    }
+    this->async_cv.notify_one();
+
+    if (this->async_thread.joinable()) {
+        this->async_thread.join();
+    }
+
     ::lcd_128x64_destroy(&this->bricklet);
 }
+
+
+/*
+ * visus::power_overwhelming::detail::tinkerforge_display_impl::draw_async
+ */
+void visus::power_overwhelming::detail::tinkerforge_display_impl::draw_async(
+        void) {
+    enter_library_thread("PwrOwg Tinkerforge Display Thread");
+
+    // The copy we draw from. Swapping it with the pending text makes sure that
+    // neither of the strings needs to allocate once both have been used.
+    std::string text;
+
+    while (true) {
+        bool colour;
+        std::uint8_t font, x, y;
+
+        {
+            std::unique_lock<decltype(this->async_lock)> l(this->async_lock);
+            this->async_cv.wait(l, [this](void) {
+                return (this->async_text.pending || !this->async_running);
+            });
+
+            if (!this->async_running) {
+                break;
+            }
+
+            colour = this->async_text.colour;
+            font = this->async_text.font;
+            x = this->async_text.x;
+            y = this->async_text.y;
+            text.swap(this->async_text.text);
+            this->async_text.pending = false;
+        }
+
+        // The network round trip happens without holding the lock, so callers
+        // of print_async are never blocked by the I/O.
+        auto status = ::lcd_128x64_draw_text(&this->bricklet, x, y, font,
+            colour, text.c_str());
+        if (status < 0) {
+            this->async_status.store(status, std::memory_order_relaxed);
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::tinkerforge_display_impl::print_async
+ */
+void visus::power_overwhelming::detail::tinkerforge_display_impl::print_async(
+        const char *text, const std::uint8_t x, const std::uint8_t y,
+        const std::uint8_t font, const bool colour) {
+    assert(text != nullptr);
+
+    {
+        std::lock_guard<decltype(this->async_lock)> l(this->async_lock);
+        this->async_text.colour = colour;
+        this->async_text.font = font;
+        this->async_text.pending = true;
+        this->async_text.text.assign(text);
+        this->async_text.x = x;
+        this->async_text.y = y;
+
+        if (!this->async_thread.joinable()) {
+            this->async_thread = std::thread(
+                &tinkerforge_display_impl::draw_async, this);
+        }
+    }
+
+    this->async_cv.notify_one();
+}
@@ -5,7 +5,11 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <thread>
 
 #include <bricklet_lcd_128x64.h>
 
@@ -21,6 +25,53 @@ namespace detail {
     /// </summary>
     struct tinkerforge_display_impl final {
 
+        /// <summary>
+        /// The text that is waiting to be drawn by <see cref="async_thread" />.
+        /// </summary>
+        /// <remarks>
+        /// There is only one slot for pending text, so text that has not been
+        /// drawn before the next call to <see cref="print_async" /> is
+        /// replaced. The string is reused for all texts such that enqueueing
+        /// does not allocate once it has grown to the length of the longest
+        /// text.
+        /// </remarks>
+        struct {
+            bool colour;
+            std::uint8_t font;
+            bool pending;
+            std::string text;
+            std::uint8_t x;
+            std::uint8_t y;
+        } async_text;
+
+        /// <summary>
+        /// Signals <see cref="async_thread" /> that there is new text or that
+        /// it should exit.
+        /// </summary>
+        std::condition_variable async_cv;
+
+        /// <summary>
+        /// Protects <see cref="async_text" /> and <see cref="async_running" />.
+        /// </summary>
+        std::mutex async_lock;
+
+        /// <summary>
+        /// Indicates whether <see cref="async_thread" /> should keep running.
+        /// </summary>
+        bool async_running;
+
+        /// <summary>
+        /// The status of the last draw call made by
+        /// <see cref="async_thread" /> that has not yet been reported.
+        /// </summary>
+        std::atomic<int> async_status;
+
+        /// <summary>
+        /// The thread drawing the text passed to <see cref="print_async" />,
+        /// which is started on the first call to the method.
+        /// </summary>
+        std::thread async_thread;
+
         /// <summary>
         /// The device object.
         /// </summary>
@@ -44,7 +95,28 @@ namespace detail {
         /// <summary>
         /// Finalises the instance.
         /// </summary>
+        /// <remarks>
+        /// Text that is still pending is discarded.
+        /// </remarks>
         ~tinkerforge_display_impl(void);
+
+        /// <summary>
+        /// Drains <see cref="async_text" /> until <see cref="async_running" />
+        /// is cleared.
+        /// </summary>
+        void draw_async(void);
+
+        /// <summary>
+        /// Replaces the pending text and wakes <see cref="async_thread" />.
+        /// </summary>
+        /// <param name="text">The text to be drawn, which must not be
+        /// <c>nullptr</c>.</param>
+        /// <param name="x">The x-coordinate of the cell to start at.</param>
+        /// <param name="y">The y-coordinate of the cell to start at.</param>
+        /// <param name="font">The font to use.</param>
+        /// <param name="colour">The colour of the text.</param>
+        void print_async(const char *text, const std::uint8_t x,
+            const std::uint8_t y, const std::uint8_t font, const bool colour);
     };
 
 } /* namespace detail */
@@ -13,9 +13,24 @@
 #include <WinSock2.h>
 #endif /* defined(_WIN32) */
 
+#include "library_thread.h"
 #include "tinkerforge_exception.h"
 
 
+/*
+ * visus::power_overwhelming::detail::tinkerforge_scope::max_reconnect_delay
+ */
+constexpr std::chrono::milliseconds
+visus::power_overwhelming::detail::tinkerforge_scope::max_reconnect_delay;
+
+
+/*
+ * visus::power_overwhelming::detail::tinkerforge_scope::min_reconnect_delay
+ */
+constexpr std::chrono::milliseconds
+visus::power_overwhelming::detail::tinkerforge_scope::min_reconnect_delay;
+
+
 /*
  * visus::power_overwhelming::detail::tinkerforge_scope::tinkerforge_scope
  */
@@ -39,13 +54,30 @@ visus::power_overwhelming::detail::tinkerforge_scope::tinkerforge_scope(
 }
 
 
+/*
+ * visus::power_overwhelming::detail::tinkerforge_scope::add_reconnect_handler
+ */
+void visus::power_overwhelming::detail::tinkerforge_scope::add_reconnect_handler(
+        const reconnect_handler handler, void *context) {
+    std::lock_guard<decltype(this->_scope->lock_handlers)> l(
+        this->_scope->lock_handlers);
+    this->_scope->handlers.emplace_back(handler, context);
+}
+
+
 /*
  * visus::power_overwhelming::detail::tinkerforge_scope::data::data
  */
 visus::power_overwhelming::detail::tinkerforge_scope::data::data(
-    const std::string &host, const std::uint16_t port) {
+        const std::string &host, const std::uint16_t port)
+    : host(host), port(port), reconnect_exit(false),
+        reconnect_pending(false), reconnect_running(false) {
     ::ipcon_create(&this->connection);
-    //::ipcon_set_auto_reconnect(&this->connection, true);
+
+    // The built-in reconnect of the bindings retries every 100 ms on the
+    // callback thread forever, and the bricklets would not restore their
+    // callbacks afterwards anyway. We therefore handle this ourselves.
+    ::ipcon_set_auto_reconnect(&this->connection, false);
 
     // Connect to master brick.
     {
@@ -57,9 +89,11 @@ visus::power_overwhelming::detail::tinkerforge_scope::data::data(
         }
     }
 
-    // Register the callback.
+    // Register the callbacks.
     ::ipcon_register_callback(&this->connection, IPCON_CALLBACK_ENUMERATE,
         reinterpret_cast<void(*)(void)>(on_enumerate), this);
+    ::ipcon_register_callback(&this->connection, IPCON_CALLBACK_DISCONNECTED,
+        reinterpret_cast<void(*)(void)>(on_disconnected), this);
 
     // Perform first enumeration of devices.
     {
@@ -77,10 +111,163 @@ visus::power_overwhelming::detail::tinkerforge_scope::data::data(
  * visus::power_overwhelming::detail::tinkerforge_scope::data::~data
  */
 visus::power_overwhelming::detail::tinkerforge_scope::data::~data(void) {
+    {
+        std::lock_guard<decltype(this->lock_reconnect)> l(this->lock_reconnect);
+        this->reconnect_exit = true;
+    }
+    this->reconnect_signal.notify_all();
+
+    // No new thread is started once we have set the exit flag, so the thread
+    // cannot change anymore.
+    if (this->reconnect_thread.joinable()) {
+        this->reconnect_thread.join();
+    }
+
     ::ipcon_destroy(&this->connection);
 }
 
 
+/*
+ * visus::power_overwhelming::detail::tinkerforge_scope::data::reconnect
+ */
+void visus::power_overwhelming::detail::tinkerforge_scope::data::reconnect(
+        void) {
+    enter_library_thread("PwrOwg Tinkerforge Reconnect Thread");
+
+    typedef std::chrono::steady_clock clock_type;
+    std::unique_lock<decltype(this->lock_reconnect)> l(this->lock_reconnect);
+    const auto exiting = [this](void) { return this->reconnect_exit; };
+
+    // The thread is started by on_disconnected and runs until it has restored
+    // the connection and all handlers have succeeded, unless the connection
+    // is lost again in the meantime.
+    while (!this->reconnect_exit && this->reconnect_pending) {
+        // Try to connect again with exponential back-off until we succeed or
+        // until the scope is destroyed.
+        auto delay = min_reconnect_delay;
+        while (!this->reconnect_exit) {
+            l.unlock();
+            const auto status = ::ipcon_connect(&this->connection,
+                this->host.c_str(), this->port);
+            l.lock();
+
+            if ((status == E_OK) || (status == E_ALREADY_CONNECTED)) {
+                this->reconnect_pending = false;
+                break;
+            }
+
+            this->reconnect_signal.wait_for(l, delay, exiting);
+            delay = (std::min)(2 * delay, max_reconnect_delay);
+        }
+
+        if (this->reconnect_exit) {
+            break;
+        }
+
+        // Refresh the list of bricklets, which might have changed in the
+        // meantime, and let the sensors restore their callbacks.
+        l.unlock();
+        ::ipcon_enumerate(&this->connection);
+        std::vector<handler_type> pending;
+        {
+            std::lock_guard<decltype(this->lock_handlers)> h(
+                this->lock_handlers);
+            pending = this->handlers;
+        }
+        l.lock();
+
+        // Handlers that failed, for instance because the bricklets are still
+        // booting after a power loss of the master brick, are retried as long
+        // as we are connected. We do not hold the lock while waiting such that
+        // the sensors can unregister in the meantime.
+        delay = min_reconnect_delay;
+        while (!this->reconnect_exit && !this->reconnect_pending
+                && !pending.empty()) {
+            const auto outage = std::chrono::duration_cast<
+                std::chrono::milliseconds>(clock_type::now()
+                - this->reconnect_since);
+            l.unlock();
+
+            {
+                std::lock_guard<decltype(this->lock_handlers)> h(
+                    this->lock_handlers);
+                auto registered = [this](const handler_type& r) {
+                    return (std::find(this->handlers.begin(),
+                        this->handlers.end(), r) != this->handlers.end());
+                };
+                pending.erase(std::remove_if(pending.begin(), pending.end(),
+                    [&registered, outage](const handler_type& r) {
+                        return (!registered(r) || r.first(outage, r.second));
+                    }), pending.end());
+            }
+
+            l.lock();
+            if (!pending.empty()) {
+                this->reconnect_signal.wait_for(l, delay, [this](void) {
+                    return (this->reconnect_exit || this->reconnect_pending);
+                });
+                delay = (std::min)(2 * delay, max_reconnect_delay);
+            }
+        }
+    }
+
+    // The next loss of the connection needs to start a new thread.
+    this->reconnect_running = false;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::tinkerforge_scope::on_disconnected
+ */
+void CALLBACK
+visus::power_overwhelming::detail::tinkerforge_scope::on_disconnected(
+        const std::uint8_t reason, void *user_data) {
+    auto data = static_cast<tinkerforge_scope::data *>(user_data);
+
+    if (reason != IPCON_DISCONNECT_REASON_REQUEST) {
+        std::thread finished;
+
+        {
+            std::lock_guard<decltype(data->lock_reconnect)> l(
+                data->lock_reconnect);
+            if (data->reconnect_exit) {
+                // The scope is being destroyed, so we must not start the
+                // thread anymore.
+                return;
+            }
+
+            if (!data->reconnect_pending) {
+                data->reconnect_since = std::chrono::steady_clock::now();
+                data->reconnect_pending = true;
+            }
+
+            if (!data->reconnect_running) {
+                // A thread from a previous outage has cleared the flag as the
+                // last thing before exiting, so it can be joined safely once
+                // we have released the lock.
+                finished = std::move(data->reconnect_thread);
+
+                try {
+                    data->reconnect_thread = std::thread(
+                        &tinkerforge_scope::data::reconnect, data);
+                    data->reconnect_running = true;
+                } catch (...) {
+                    // We cannot report errors to the bindings, so the next
+                    // loss of the connection will try again.
+                    data->reconnect_pending = false;
+                }
+            }
+        }
+
+        if (finished.joinable()) {
+            finished.join();
+        }
+
+        data->reconnect_signal.notify_all();
+    }
+}
+
+
 /*
  * visus::power_overwhelming::detail::tinkerforge_scope::on_enumerate
  */
@@ -109,6 +296,22 @@ void CALLBACK visus::power_overwhelming::detail::tinkerforge_scope::on_enumerate
 }
 
 
+/*
+ * ...::detail::tinkerforge_scope::remove_reconnect_handler
+ */
+void visus::power_overwhelming::detail::tinkerforge_scope
+::remove_reconnect_handler(const reconnect_handler handler,
+        void *context) noexcept {
+    // The reconnect thread holds the lock while invoking the handlers, so the
+    // handler cannot be running anymore once we got the lock.
+    std::lock_guard<decltype(this->_scope->lock_handlers)> l(
+        this->_scope->lock_handlers);
+    auto& handlers = this->_scope->handlers;
+    handlers.erase(std::remove(handlers.begin(), handlers.end(),
+        data::handler_type(handler, context)), handlers.end());
+}
+
+
 /*
  * visus::power_overwhelming::detail::tinkerforge_scope::to_endpoint
  */
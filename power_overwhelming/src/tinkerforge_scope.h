@@ -6,16 +6,21 @@
 #pragma once
 
 #include <algorithm>
+#include <chrono>
 #include <cinttypes>
+#include <condition_variable>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <utility>
+#include <vector>
 
 #include <ip_connection.h>
 
 #include "tinkerforge_bricklet.h"
+#include "tinkerforge_dispatcher.h"
 
 
 #if !defined(CALLBACK)
@@ -38,11 +43,49 @@ namespace detail {
     /// of the Tingerforge <see cref="IPConnection" /> they can obtain from a
     /// scope. The creation of new scopes and their destruction is, however,
     /// thread-safe.</para>
+    /// <para>If the connection to the Brick daemon is lost, the scope tries to
+    /// reconnect with exponential back-off. Once the connection has been
+    /// re-established, it invokes the <see cref="reconnect_handler" />s
+    /// registered for the connection such that the sensors can restore their
+    /// callbacks. The thread doing so is only started when the connection is
+    /// lost and exits once all handlers have succeeded.</para>
     /// </remarks>
     class tinkerforge_scope final {
 
     public:
 
+        /// <summary>
+        /// The type of a callback that is invoked after the connection has been
+        /// re-established.
+        /// </summary>
+        /// <remarks>
+        /// The handler is invoked on a dedicated thread of the scope, which
+        /// means that it may make blocking calls to the bricklets. If the
+        /// handler returns <c>false</c>, the scope will invoke it again later
+        /// as long as the connection persists.
+        /// </remarks>
+        /// <param name="outage">The time that passed between the loss of the
+        /// connection and the invocation of the handler.</param>
+        /// <param name="context">The user-defined context pointer passed to
+        /// <see cref="add_reconnect_handler" />.</param>
+        /// <returns><c>true</c> if the handler has restored the state of its
+        /// bricklet, <c>false</c> if it needs to be invoked again.</returns>
+        typedef bool (*reconnect_handler)(
+            const std::chrono::milliseconds outage, void *context);
+
+        /// <summary>
+        /// The maximum time between two attempts to reconnect.
+        /// </summary>
+        static constexpr std::chrono::milliseconds max_reconnect_delay
+            = std::chrono::milliseconds(2000);
+
+        /// <summary>
+        /// The time between the loss of the connection and the first attempt
+        /// to reconnect, which doubles with every failed attempt.
+        /// </summary>
+        static constexpr std::chrono::milliseconds min_reconnect_delay
+            = std::chrono::milliseconds(100);
+
         /// <summary>
         /// Initialises a new instance.
         /// </summary>
@@ -54,6 +97,18 @@ namespace detail {
         /// not be established.</exception>
         tinkerforge_scope(const std::string& host, const std::uint16_t port);
 
+        /// <summary>
+        /// Registers a handler that is invoked whenever the connection has been
+        /// re-established after it was lost.
+        /// </summary>
+        /// <param name="handler">The handler to be invoked.</param>
+        /// <param name="context">A user-defined context pointer passed to
+        /// <paramref name="handler" />.</param>
+        /// <exception cref="std::bad_alloc">If the handler could not be
+        /// registered.</exception>
+        void add_reconnect_handler(const reconnect_handler handler,
+            void *context);
+
         /// <summary>
         /// Copy the the currently known <see cref="tinkerforge_bricklet" />s
         /// matching the given predicate in a thread-safe manner to the output
@@ -128,12 +183,42 @@ namespace detail {
         /// circumstance. Callers must also not keep local copies of the
         /// value returned.
         /// </remarks>
-        /// <returns>The IP connection, which is guaranteed to be valid and
-        /// connected for any valid instance of the scope.</returns>
+        /// <returns>The IP connection, which is guaranteed to be valid for any
+        /// valid instance of the scope. It is connected unless the connection
+        /// has been lost and is being re-established.</returns>
         inline operator IPConnection *(void) {
             return std::addressof(this->_scope->connection);
         }
 
+        /// <summary>
+        /// Answer the dispatcher that delivers the callbacks of the bricklets
+        /// on the connection.
+        /// </summary>
+        /// <remarks>
+        /// Bricklet callbacks should not do any work on the callback thread of
+        /// the <see cref="IPConnection" />, but push their readings into a
+        /// queue that is registered with this dispatcher.
+        /// </remarks>
+        /// <returns>The dispatcher of the connection, which lives as long as
+        /// any scope for the connection exists.</returns>
+        inline tinkerforge_dispatcher& dispatcher(void) noexcept {
+            return this->_scope->dispatcher;
+        }
+
+        /// <summary>
+        /// Removes a handler registered before via
+        /// <see cref="add_reconnect_handler" />.
+        /// </summary>
+        /// <remarks>
+        /// Once the method returns, the handler is guaranteed not to be
+        /// running anymore and will not be invoked again.
+        /// </remarks>
+        /// <param name="handler">The handler to be removed.</param>
+        /// <param name="context">The context pointer the handler has been
+        /// registered with.</param>
+        void remove_reconnect_handler(const reconnect_handler handler,
+            void *context) noexcept;
+
     private:
 
         /// <summary>
@@ -144,13 +229,37 @@ namespace detail {
         /// to one of these.
         /// </remarks>
         struct data {
+            typedef std::pair<reconnect_handler, void *> handler_type;
+
             std::map<std::string, tinkerforge_bricklet> bricklets;
             std::mutex lock_bricklets;
             IPConnection connection;
+            tinkerforge_dispatcher dispatcher;
+            std::vector<handler_type> handlers;
+            std::string host;
+            std::mutex lock_handlers;
+            std::mutex lock_reconnect;
+            std::uint16_t port;
+            bool reconnect_exit;
+            std::chrono::steady_clock::time_point reconnect_since;
+            std::condition_variable reconnect_signal;
+            bool reconnect_pending;
+            bool reconnect_running;
+            std::thread reconnect_thread;
             data(const std::string& host, const std::uint16_t port);
             ~data(void);
+            void reconnect(void);
         };
 
+        /// <summary>
+        /// Callback for the connection having been lost, which starts or
+        /// wakes the reconnect thread of the connection.
+        /// </summary>
+        /// <param name="reason"></param>
+        /// <param name="user_data"></param>
+        static void CALLBACK on_disconnected(const std::uint8_t reason,
+            void *user_data);
+
         /// <summary>
         /// Device enumeration callback for a connection.
         /// </summary>
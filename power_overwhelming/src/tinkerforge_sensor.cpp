@@ -5,9 +5,14 @@
 
 #include "power_overwhelming/tinkerforge_sensor.h"
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <future>
+#include <iterator>
+#include <stdexcept>
 #include <thread>
+#include <utility>
 #include <vector>
 
 #include <bricklet_voltage_current_v2.h>
@@ -18,6 +23,133 @@
 #include "zero_memory.h"
 
 
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The durations of the A/D conversions of the INA226 in microseconds,
+    /// indexed by <see cref="conversion_time" />.
+    /// </summary>
+    static constexpr std::uint32_t conversion_times[] = {
+        140, 204, 332, 588, 1100, 2116, 4156, 8244
+    };
+
+    /// <summary>
+    /// The number of samples averaged by the INA226, indexed by
+    /// <see cref="sample_averaging" />.
+    /// </summary>
+    static constexpr std::uint32_t averaging_counts[] = {
+        1, 4, 16, 64, 128, 256, 512, 1024
+    };
+
+    /// <summary>
+    /// Retrieves the definitions of all voltage/current bricklets attached to
+    /// the Brick daemon on <paramref name="host" /> and
+    /// <paramref name="port" />.
+    /// </summary>
+    /// <param name="host">The host on which the Brick daemon is running.
+    /// </param>
+    /// <param name="port">The port on which the Brick daemon is listening.
+    /// </param>
+    /// <param name="timeout">The time to wait for bricklets if none are
+    /// cached.</param>
+    /// <param name="expected">The number of bricklets to wait for, or zero
+    /// to return as soon as any bricklet has been found.</param>
+    /// <returns>The definitions of the bricklets, which record the endpoint
+    /// of the Brick daemon.</returns>
+    static std::vector<tinkerforge_sensor_definition> discover_definitions(
+            const std::string& host, const std::uint16_t port,
+            const std::chrono::milliseconds timeout,
+            const std::size_t expected) {
+        std::vector<tinkerforge_bricklet> bricklets;
+        tinkerforge_scope scope(host, port);
+
+        scope.copy_bricklets(std::back_inserter(bricklets),
+            [](const tinkerforge_bricklet& b) {
+                return (b.device_type() == VOLTAGE_CURRENT_V2_DEVICE_IDENTIFIER);
+            }, timeout, expected);
+
+        std::vector<tinkerforge_sensor_definition> retval;
+        retval.reserve(bricklets.size());
+        for (auto& b : bricklets) {
+            retval.emplace_back(b.uid().c_str(), host.c_str(), port);
+        }
+
+        return retval;
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::tinkerforge_sensor::configure_all
+ */
+void visus::power_overwhelming::tinkerforge_sensor::configure_all(
+        _In_reads_(cnt) tinkerforge_sensor *const *sensors,
+        _In_reads_(cnt) const microseconds_type *sampling_intervals,
+        _In_ const std::size_t cnt) {
+    typedef std::underlying_type<conversion_time>::type native_adc_type;
+    typedef std::underlying_type<sample_averaging>::type native_avg_type;
+
+    if ((sensors == nullptr) && (cnt > 0)) {
+        throw std::invalid_argument("The array of sensors must not be null.");
+    }
+    if ((sampling_intervals == nullptr) && (cnt > 0)) {
+        throw std::invalid_argument("The array of sampling intervals must not "
+            "be null.");
+    }
+
+    // Send all configurations first without waiting for the bricklets to
+    // acknowledge them.
+    std::vector<std::pair<native_avg_type, native_adc_type>> configurations(
+        cnt);
+    for (std::size_t i = 0; i < cnt; ++i) {
+        if (sensors[i] == nullptr) {
+            continue;
+        }
+        if (!*sensors[i]) {
+            throw std::runtime_error("A disposed instance of "
+                "tinkerforge_sensor cannot be configured.");
+        }
+
+        sample_averaging averaging;
+        conversion_time time;
+        select_configuration(sampling_intervals[i], averaging, time);
+        configurations[i].first = static_cast<native_avg_type>(averaging);
+        configurations[i].second = static_cast<native_adc_type>(time);
+
+        sensors[i]->_impl->post_configuration(configurations[i].first,
+            configurations[i].second, configurations[i].second);
+        sensors[i]->_impl->remember_configuration(configurations[i].first,
+            configurations[i].second, configurations[i].second);
+    }
+
+    // Wait for all acknowledgements at once. Requests to different bricklets
+    // can be pending at the same time, even if they share a connection.
+    std::vector<std::future<void>> confirmations;
+    confirmations.reserve(cnt);
+    for (std::size_t i = 0; i < cnt; ++i) {
+        if (sensors[i] != nullptr) {
+            auto impl = sensors[i]->_impl;
+            auto c = configurations[i];
+            confirmations.push_back(std::async(std::launch::async,
+                [impl, c](void) {
+                    impl->confirm_configuration(c.first, c.second, c.second);
+                }));
+        }
+    }
+
+    // If any of the bricklets failed, this rethrows its exception. The
+    // destructors of the remaining futures wait for the other bricklets.
+    for (auto& c : confirmations) {
+        c.get();
+    }
+}
+
+
 /*
  * visus::power_overwhelming::tinkerforge_sensor::for_all
  */
@@ -38,11 +170,39 @@ std::size_t visus::power_overwhelming::tinkerforge_sensor::for_all(
 
         // Handle potential attachment of sensors between measurment call and
         // actual instantiation call.
-        if (retval < cnt_sensors) {
-            retval = cnt_sensors;
+        const auto cnt = (std::min)(retval, cnt_sensors);
+
+        for (std::size_t i = 0; i < cnt; ++i) {
+            out_sensors[i] = tinkerforge_sensor(descs[i]);
         }
 
-        for (std::size_t i = 0; i < retval; ++i) {
+        return retval;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::tinkerforge_sensor::for_all
+ */
+std::size_t visus::power_overwhelming::tinkerforge_sensor::for_all(
+        _Out_writes_opt_(cnt_sensors) tinkerforge_sensor *out_sensors,
+        _In_ const std::size_t cnt_sensors,
+        _In_reads_(cnt_endpoints) const char *const *hosts,
+        _In_reads_opt_(cnt_endpoints) const std::uint16_t *ports,
+        _In_ const std::size_t cnt_endpoints,
+        _In_ const std::size_t timeout) {
+    if ((out_sensors == nullptr) || (cnt_sensors == 0)) {
+        return tinkerforge_sensor::get_definitions(nullptr, 0, hosts, ports,
+            cnt_endpoints, timeout);
+
+    } else {
+        std::vector<tinkerforge_sensor_definition> descs(cnt_sensors);
+        auto retval = tinkerforge_sensor::get_definitions(descs.data(),
+            descs.size(), hosts, ports, cnt_endpoints, timeout);
+        const auto cnt = (std::min)(retval, cnt_sensors);
+
+        for (std::size_t i = 0; i < cnt; ++i) {
+            // The definitions know the endpoint they have been found on.
             out_sensors[i] = tinkerforge_sensor(descs[i]);
         }
 
@@ -74,19 +234,114 @@ std::size_t visus::power_overwhelming::tinkerforge_sensor::get_definitions(
         _In_ const std::size_t timeout,
         _In_opt_z_ const char *host,
         _In_ const std::uint16_t port) {
-    std::vector<detail::tinkerforge_bricklet> bricklets;
     const auto h = (host != nullptr) ? host : default_host;
-    detail::tinkerforge_scope scope(h, port);
+    auto definitions = detail::discover_definitions(h, port,
+        std::chrono::milliseconds(timeout), cnt);
+
+    if (out_definitions != nullptr) {
+        const auto c = (std::min)(cnt, definitions.size());
+        std::move(definitions.begin(), definitions.begin() + c,
+            out_definitions);
+    }
+
+    return definitions.size();
+}
+
+
+/*
+ * visus::power_overwhelming::tinkerforge_sensor::get_definitions
+ */
+std::size_t visus::power_overwhelming::tinkerforge_sensor::get_definitions(
+        _Out_writes_opt_(cnt) tinkerforge_sensor_definition *out_definitions,
+        _In_ const std::size_t cnt,
+        _In_reads_(cnt_endpoints) const char *const *hosts,
+        _In_reads_opt_(cnt_endpoints) const std::uint16_t *ports,
+        _In_ const std::size_t cnt_endpoints,
+        _In_ const std::size_t timeout) {
+    typedef std::vector<tinkerforge_sensor_definition> definitions_type;
+
+    if ((hosts == nullptr) && (cnt_endpoints > 0)) {
+        throw std::invalid_argument("The list of hosts to retrieve Tinkerforge "
+            "sensors from must not be null.");
+    }
+
+    // Start the discovery on all hosts at once, because most of the time is
+    // spent waiting for the enumeration callbacks.
+    std::vector<std::future<definitions_type>> discoveries;
+    discoveries.reserve(cnt_endpoints);
+
+    for (std::size_t i = 0; i < cnt_endpoints; ++i) {
+        const std::string host = (hosts[i] != nullptr)
+            ? hosts[i]
+            : default_host;
+        const auto port = (ports != nullptr) ? ports[i] : default_port;
+        discoveries.push_back(std::async(std::launch::async,
+            detail::discover_definitions, host, port,
+            std::chrono::milliseconds(timeout), 0));
+    }
 
-    auto retval = scope.copy_bricklets(std::back_inserter(bricklets),
-        [](const detail::tinkerforge_bricklet& b) {
-            return (b.device_type() == VOLTAGE_CURRENT_V2_DEVICE_IDENTIFIER);
-        }, std::chrono::milliseconds(timeout), cnt);
+    // Merge the results in the order of the endpoints. If any of the hosts
+    // failed, this rethrows its exception. The destructors of the remaining
+    // futures wait for the other discoveries to complete.
+    definitions_type definitions;
+    for (auto& d : discoveries) {
+        auto r = d.get();
+        definitions.reserve(definitions.size() + r.size());
+        std::move(r.begin(), r.end(), std::back_inserter(definitions));
+    }
 
     if (out_definitions != nullptr) {
-        for (std::size_t i = 0; (i < cnt) && (i < retval); ++i) {
-            out_definitions[i] = tinkerforge_sensor_definition(
-                bricklets[i].uid().c_str());
+        const auto c = (std::min)(cnt, definitions.size());
+        std::move(definitions.begin(), definitions.begin() + c,
+            out_definitions);
+    }
+
+    return definitions.size();
+}
+
+
+/*
+ * visus::power_overwhelming::tinkerforge_sensor::select_configuration
+ */
+bool visus::power_overwhelming::tinkerforge_sensor::select_configuration(
+        _In_ const microseconds_type sampling_interval,
+        _Out_ sample_averaging& averaging,
+        _Out_ conversion_time& time) noexcept {
+    typedef std::underlying_type<conversion_time>::type native_adc_type;
+    typedef std::underlying_type<sample_averaging>::type native_avg_type;
+    auto retval = false;
+    std::uint64_t best = 0;
+
+    // The fastest configuration is our fallback if the interval is too short
+    // for anything.
+    averaging = sample_averaging::average_of_1;
+    time = conversion_time::microseconds_140;
+
+    // In continuous mode, the INA226 converts shunt and bus voltage one after
+    // the other, so fresh data are available after the number of averaged
+    // samples times the sum of both conversion times. The noise decreases
+    // with the total time spent integrating the signal, so we use as much of
+    // the period as possible. For equal integration times, we prefer the
+    // longer conversion time, which is less affected by switching between the
+    // channels.
+    static constexpr auto cnt_averaging = sizeof(detail::averaging_counts)
+        / sizeof(*detail::averaging_counts);
+    static constexpr auto cnt_times = sizeof(detail::conversion_times)
+        / sizeof(*detail::conversion_times);
+
+    for (std::size_t c = 0; c < cnt_times; ++c) {
+        for (std::size_t a = 0; a < cnt_averaging; ++a) {
+            const auto integration = static_cast<std::uint64_t>(
+                detail::averaging_counts[a]) * detail::conversion_times[c];
+            if ((2 * integration <= static_cast<std::uint64_t>(
+                    sampling_interval)) && (integration >= best)) {
+                averaging = static_cast<sample_averaging>(
+                    static_cast<native_avg_type>(a));
+                time = static_cast<conversion_time>(
+                    static_cast<native_adc_type>(c));
+                best = integration;
+                retval = true;
+            }
         }
     }
 
@@ -137,10 +392,19 @@ visus::power_overwhelming::tinkerforge_sensor::tinkerforge_sensor(
         _In_ const tinkerforge_sensor_definition& definition,
         _In_opt_z_ const char *host,
         _In_ const std::uint16_t port) : _impl(nullptr) {
-    this->_impl = new detail::tinkerforge_sensor_impl(
-        (host != nullptr) ? host : default_host,
-        port,
-        definition.uid());
+    auto h = host;
+    auto p = port;
+
+    // Explicitly specified endpoints take precedence over the ones recorded
+    // in the definition, which in turn take precedence over the defaults.
+    if (h == nullptr) {
+        h = (definition.host() != nullptr) ? definition.host() : default_host;
+    }
+    if (p == 0) {
+        p = (definition.port() != 0) ? definition.port() : default_port;
+    }
+
+    this->_impl = new detail::tinkerforge_sensor_impl(h, p, definition.uid());
 
     if (definition.description() != nullptr) {
         this->_impl->description = definition.description();
@@ -183,6 +447,18 @@ void visus::power_overwhelming::tinkerforge_sensor::configuration(
 }
 
 
+/*
+ * visus::power_overwhelming::tinkerforge_sensor::configure
+ */
+void visus::power_overwhelming::tinkerforge_sensor::configure(
+        _In_ const microseconds_type sampling_interval) {
+    sample_averaging averaging;
+    conversion_time time;
+    select_configuration(sampling_interval, averaging, time);
+    this->configure(averaging, time, time);
+}
+
+
 /*
  * visus::power_overwhelming::tinkerforge_sensor::configure
  */
@@ -206,6 +482,13 @@ void visus::power_overwhelming::tinkerforge_sensor::configure(
     if (status < 0) {
         throw tinkerforge_exception(status);
     }
+
+    // The bricklet has answered, so we know that it is reachable.
+    this->_impl->remember_configuration(
+        static_cast<native_avg_type>(averaging),
+        static_cast<native_adc_type>(voltage_conversion_time),
+        static_cast<native_adc_type>(current_conversion_time));
+    this->_impl->unacknowledge_callbacks();
 }
 
 
@@ -223,6 +506,32 @@ visus::power_overwhelming::tinkerforge_sensor::description(
 }
 
 
+/*
+ * visus::power_overwhelming::tinkerforge_sensor::dropped_readings
+ */
+std::uint64_t visus::power_overwhelming::tinkerforge_sensor::dropped_readings(
+        void) const noexcept {
+    if (this->_impl != nullptr) {
+        return this->_impl->async_queue->dropped();
+    } else {
+        return 0;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::tinkerforge_sensor::host
+ */
+_Ret_maybenull_z_ const char *
+visus::power_overwhelming::tinkerforge_sensor::host(void) const noexcept {
+    if (this->_impl != nullptr) {
+        return this->_impl->host.c_str();
+    } else {
+        return nullptr;
+    }
+}
+
+
 /*
  * visus::power_overwhelming::tinkerforge_sensor::identify
  */
@@ -261,6 +570,32 @@ void visus::power_overwhelming::tinkerforge_sensor::identify(
 }
 
 
+/*
+ * visus::power_overwhelming::tinkerforge_sensor::incomplete_samples
+ */
+std::uint64_t visus::power_overwhelming::tinkerforge_sensor::incomplete_samples(
+        void) const noexcept {
+    if (this->_impl != nullptr) {
+        return this->_impl->async_incomplete.load();
+    } else {
+        return 0;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::tinkerforge_sensor::max_queue_depth
+ */
+std::size_t visus::power_overwhelming::tinkerforge_sensor::max_queue_depth(
+        void) const noexcept {
+    if (this->_impl != nullptr) {
+        return this->_impl->async_queue->max_depth();
+    } else {
+        return 0;
+    }
+}
+
+
 /*
  * visus::power_overwhelming::tinkerforge_sensor::name
  */
@@ -274,6 +609,116 @@ visus::power_overwhelming::tinkerforge_sensor::name(void) const noexcept {
 }
 
 
+/*
+ * visus::power_overwhelming::tinkerforge_sensor::native_interval
+ */
+visus::power_overwhelming::sensor::microseconds_type
+visus::power_overwhelming::tinkerforge_sensor::native_interval(void) const {
+    this->check_not_disposed();
+
+    std::uint8_t averaging = 0;
+    std::uint8_t current = 0;
+    std::uint8_t voltage = 0;
+    auto status = ::voltage_current_v2_get_configuration(
+        &this->_impl->bricklet, &averaging, &voltage, &current);
+    if (status < 0) {
+        throw tinkerforge_exception(status);
+    }
+
+    // As explained in select_configuration, the INA226 converts both
+    // channels one after the other for each averaged sample.
+    return static_cast<microseconds_type>(detail::averaging_counts[averaging])
+        * (detail::conversion_times[current]
+        + detail::conversion_times[voltage]);
+}
+
+
+/*
+ * visus::power_overwhelming::tinkerforge_sensor::port
+ */
+std::uint16_t visus::power_overwhelming::tinkerforge_sensor::port(
+        void) const noexcept {
+    return (this->_impl != nullptr) ? this->_impl->port : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::tinkerforge_sensor::quantities
+ */
+visus::power_overwhelming::tinkerforge_sensor_source
+visus::power_overwhelming::tinkerforge_sensor::quantities(
+        void) const noexcept {
+    return (this->_impl != nullptr)
+        ? this->_impl->quantities
+        : tinkerforge_sensor_source::none;
+}
+
+
+/*
+ * visus::power_overwhelming::tinkerforge_sensor::quantities
+ */
+void visus::power_overwhelming::tinkerforge_sensor::quantities(
+        _In_ const tinkerforge_sensor_source quantities) {
+    if (!*this) {
+        throw std::runtime_error("The quantities of a disposed instance of "
+            "tinkerforge_sensor cannot be changed.");
+    }
+
+    const auto valid = quantities & tinkerforge_sensor_source::all;
+    if ((valid == tinkerforge_sensor_source::none) || (valid != quantities)) {
+        throw std::invalid_argument("The quantities of a tinkerforge_sensor "
+            "must be a non-empty combination of current, voltage and power.");
+    }
+
+    this->_impl->quantities = quantities;
+}
+
+
+/*
+ * visus::power_overwhelming::tinkerforge_sensor::queue_depth
+ */
+std::size_t visus::power_overwhelming::tinkerforge_sensor::queue_depth(
+        void) const noexcept {
+    if (this->_impl != nullptr) {
+        return this->_impl->async_queue->depth();
+    } else {
+        return 0;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::tinkerforge_sensor::reconstruct_timestamps
+ */
+bool visus::power_overwhelming::tinkerforge_sensor::reconstruct_timestamps(
+        void) const noexcept {
+    if (this->_impl != nullptr) {
+        std::lock_guard<decltype(this->_impl->async_lock)> l(
+            this->_impl->async_lock);
+        return this->_impl->reconstruct_timestamps;
+    } else {
+        return false;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::tinkerforge_sensor::reconstruct_timestamps
+ */
+void visus::power_overwhelming::tinkerforge_sensor::reconstruct_timestamps(
+        _In_ const bool reconstruct) {
+    if (!*this) {
+        throw std::runtime_error("The timestamps of a disposed instance of "
+            "tinkerforge_sensor cannot be changed.");
+    }
+
+    std::lock_guard<decltype(this->_impl->async_lock)> l(
+        this->_impl->async_lock);
+    this->_impl->reconstruct_timestamps = reconstruct;
+    this->_impl->clock.reset();
+}
+
+
 /*
  * visus::power_overwhelming::tinkerforge_sensor::reset
  */
@@ -316,31 +761,18 @@ void visus::power_overwhelming::tinkerforge_sensor::sample(
                 "while it is already running.");
         }
 
+        if (this->_impl->on_measurement_data.load() != nullptr) {
+            this->_impl->on_measurement.exchange(nullptr);
+            throw std::logic_error("Asynchronous sampling cannot be started "
+                "while it is already running.");
+        }
+
         try {
             auto millis = static_cast<std::int32_t>((std::max)(one,
                 period / thousand));
 
             this->_impl->on_measurement_context = context;
-
-            if (source == tinkerforge_sensor_source::all) {
-                // Enable all sensor readings.
-                this->_impl->enable_callbacks(millis);
-
-            } else {
-                // Enable individual sensor readings.
-                if ((source & tinkerforge_sensor_source::current)
-                        == tinkerforge_sensor_source::current) {
-                    this->_impl->enable_current_callback(millis);
-                }
-                if ((source & tinkerforge_sensor_source::power)
-                    == tinkerforge_sensor_source::power) {
-                    this->_impl->enable_power_callback(millis);
-                }
-                if ((source & tinkerforge_sensor_source::voltage)
-                    == tinkerforge_sensor_source::voltage) {
-                    this->_impl->enable_voltage_callback(millis);
-                }
-            }
+            this->_impl->enable_callbacks(source, millis);
         } catch (...) {
             // Clear the guard in case the operation failed.
             this->_impl->on_measurement.exchange(nullptr);
@@ -358,6 +790,90 @@ void visus::power_overwhelming::tinkerforge_sensor::sample(
 }
 
 
+/*
+ * visus::power_overwhelming::tinkerforge_sensor::sample_batch
+ */
+void visus::power_overwhelming::tinkerforge_sensor::sample_batch(
+        _In_opt_ const measurement_data_callback on_batch,
+        _In_ const tinkerforge_sensor_source source,
+        _In_ const microseconds_type period,
+        _In_opt_ void *context) {
+    static constexpr auto one = static_cast<microseconds_type>(1);
+    static constexpr auto thousand = static_cast<microseconds_type>(1000);
+    static constexpr auto max_latency = static_cast<std::int32_t>(10);
+
+    if (!*this) {
+        throw std::runtime_error("A disposed instance of tinkerforge_sensor "
+            "cannot be sampled.");
+    }
+
+    if (on_batch != nullptr) {
+        measurement_data_callback expected = nullptr;
+
+        if (!this->_impl->on_measurement_data.compare_exchange_strong(expected,
+                on_batch)) {
+            throw std::logic_error("Asynchronous sampling cannot be started "
+                "while it is already running.");
+        }
+
+        if (this->_impl->on_measurement.load() != nullptr) {
+            this->_impl->on_measurement_data.exchange(nullptr);
+            throw std::logic_error("Asynchronous sampling cannot be started "
+                "while it is already running.");
+        }
+
+        try {
+            auto millis = static_cast<std::int32_t>((std::max)(one,
+                period / thousand));
+
+            {
+                std::lock_guard<decltype(this->_impl->async_lock)> l(
+                    this->_impl->async_lock);
+                this->_impl->async_batch_size = static_cast<std::size_t>(
+                    (std::max)(1, max_latency / millis));
+                this->_impl->async_batch.clear();
+                this->_impl->async_batch.reserve(
+                    this->_impl->async_batch_size);
+            }
+
+            this->_impl->on_measurement_context = context;
+            this->_impl->enable_callbacks(source, millis);
+        } catch (...) {
+            // Clear the guard in case the operation failed.
+            this->_impl->on_measurement_data.exchange(nullptr);
+            throw;
+        }
+
+    } else {
+        // If the callback is null, disable asynchronous sampling and flush
+        // any samples that have not yet been delivered.
+        if (this->_impl->on_measurement_data != nullptr) {
+            this->_impl->disable_callbacks();
+
+            std::lock_guard<decltype(this->_impl->async_lock)> l(
+                this->_impl->async_lock);
+            this->_impl->deliver_batch();
+        }
+
+        this->_impl->on_measurement_data.exchange(on_batch);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::tinkerforge_sensor::sample_batch
+ */
+void visus::power_overwhelming::tinkerforge_sensor::sample_batch(
+        _In_opt_ const measurement_data_callback on_batch,
+        _In_ const microseconds_type period,
+        _In_opt_ void *context) {
+    const auto quantities = (this->_impl != nullptr)
+        ? this->_impl->quantities
+        : tinkerforge_sensor_source::power;
+    this->sample_batch(on_batch, quantities, period, context);
+}
+
+
 /*
  * visus::power_overwhelming::tinkerforge_sensor::operator =
  */
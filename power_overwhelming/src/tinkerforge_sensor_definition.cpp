@@ -14,14 +14,22 @@
  * ...::tinkerforge_sensor_definition::tinkerforge_sensor_definition
  */
 visus::power_overwhelming::tinkerforge_sensor_definition::tinkerforge_sensor_definition(
-        _In_z_ const char *uid) : _description(nullptr), _uid(nullptr) {
+        _In_z_ const char *uid,
+        _In_opt_z_ const char *host,
+        _In_ const std::uint16_t port)
+        : _description(nullptr), _host(nullptr), _port(port), _uid(nullptr) {
     if (uid == nullptr) {
         throw std::invalid_argument("The UID of a Tinkerforge sensor cannot "
             "be null.");
     }
 
-    // Note: This may throw, so it must be the only allocation here.
-    detail::safe_assign(this->_uid, uid);
+    try {
+        detail::safe_assign(this->_uid, uid);
+        detail::safe_assign(this->_host, host);
+    } catch (...) {
+        this->~tinkerforge_sensor_definition();
+        throw;
+    }
 }
 
 
@@ -30,7 +38,7 @@ visus::power_overwhelming::tinkerforge_sensor_definition::tinkerforge_sensor_def
  */
 visus::power_overwhelming::tinkerforge_sensor_definition::tinkerforge_sensor_definition(
         _In_ const tinkerforge_sensor_definition& rhs)
-        : _description(nullptr), _uid(nullptr) {
+        : _description(nullptr), _host(nullptr), _port(0), _uid(nullptr) {
     try {
         *this = rhs;
     } catch (...) {
@@ -46,6 +54,7 @@ visus::power_overwhelming::tinkerforge_sensor_definition::tinkerforge_sensor_def
 visus::power_overwhelming::tinkerforge_sensor_definition::~tinkerforge_sensor_definition(
         void) {
     detail::safe_assign(this->_description, nullptr);
+    detail::safe_assign(this->_host, nullptr);
     detail::safe_assign(this->_uid, nullptr);
 }
 
@@ -67,6 +76,8 @@ visus::power_overwhelming::tinkerforge_sensor_definition::operator =(
         _In_ const tinkerforge_sensor_definition& rhs) {
     if (this != std::addressof(rhs)) {
         detail::safe_assign(this->_description, rhs._description);
+        detail::safe_assign(this->_host, rhs._host);
+        this->_port = rhs._port;
         detail::safe_assign(this->_uid, rhs._uid);
     }
 
@@ -83,6 +94,9 @@ visus::power_overwhelming::tinkerforge_sensor_definition::operator =(
     if (this != std::addressof(rhs)) {
         detail::safe_assign(this->_description, std::move(rhs._description));
         assert(rhs._description == nullptr);
+        detail::safe_assign(this->_host, std::move(rhs._host));
+        assert(rhs._host == nullptr);
+        this->_port = rhs._port;
         detail::safe_assign(this->_uid, std::move(rhs._uid));
         assert(rhs._uid == nullptr);
     }
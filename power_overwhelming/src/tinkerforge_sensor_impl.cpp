@@ -5,10 +5,13 @@
 
 #include "tinkerforge_sensor_impl.h"
 
+#include <algorithm>
 #include <cassert>
+#include <stdexcept>
 
 #include "power_overwhelming/convert_string.h"
 
+#include "sensor_name_registry.h"
 #include "tinkerforge_exception.h"
 
 
@@ -19,12 +22,30 @@ void CALLBACK
 visus::power_overwhelming::detail::tinkerforge_sensor_impl::current_callback(
     const std::int32_t current, void *data) {
     assert(data != nullptr);
-    const auto timestamp = create_timestamp(timestamp_resolution::milliseconds);
+    const auto timestamp = create_timestamp(
+        timestamp_resolution::hundred_nanoseconds);
+    auto that = static_cast<tinkerforge_sensor_impl *>(data);
+    that->async_queue->push({ tinkerforge_sensor_source::current, timestamp,
+        static_cast<measurement::value_type>(current)
+        / static_cast<measurement::value_type>(1000) });
+}
+
+
+/*
+ * ..::tinkerforge_sensor_impl::dispatch_callback
+ */
+void visus::power_overwhelming::detail::tinkerforge_sensor_impl
+::dispatch_callback(const tinkerforge_reading *readings,
+        const std::size_t cnt, void *data) {
+    assert(readings != nullptr);
+    assert(data != nullptr);
     auto that = static_cast<tinkerforge_sensor_impl *>(data);
     std::lock_guard<decltype(that->async_lock)> l(that->async_lock);
-    that->async_data[0] = static_cast<measurement::value_type>(current)
-        / static_cast<measurement::value_type>(1000);
-    that->invoke_callback(timestamp);   // TODO: Do we really want to invoke directly? How do we detect a consistent state?
+
+    for (std::size_t i = 0; i < cnt; ++i) {
+        that->assemble(readings[i].source, readings[i].value,
+            readings[i].timestamp);
+    }
 }
 
 
@@ -47,12 +68,23 @@ void CALLBACK
 visus::power_overwhelming::detail::tinkerforge_sensor_impl::power_callback(
         const std::int32_t power, void *data) {
     assert(data != nullptr);
-    const auto timestamp = create_timestamp(timestamp_resolution::milliseconds);
+    const auto timestamp = create_timestamp(
+        timestamp_resolution::hundred_nanoseconds);
     auto that = static_cast<tinkerforge_sensor_impl *>(data);
-    std::lock_guard<decltype(that->async_lock)> l(that->async_lock);
-    that->async_data[1] = static_cast<measurement::value_type>(power)
-        / static_cast<measurement::value_type>(1000);
-    that->invoke_callback(timestamp);   // TODO: Do we really want to invoke directly? How do we detect a consistent state?
+    that->async_queue->push({ tinkerforge_sensor_source::power, timestamp,
+        static_cast<measurement::value_type>(power)
+        / static_cast<measurement::value_type>(1000) });
+}
+
+
+/*
+ * ...::tinkerforge_sensor_impl::reconnect_callback
+ */
+bool visus::power_overwhelming::detail::tinkerforge_sensor_impl
+::reconnect_callback(const std::chrono::milliseconds outage, void *data) {
+    assert(data != nullptr);
+    auto that = static_cast<tinkerforge_sensor_impl *>(data);
+    return that->restore(outage);
 }
 
 
@@ -63,12 +95,12 @@ void CALLBACK
 visus::power_overwhelming::detail::tinkerforge_sensor_impl::voltage_callback(
         const std::int32_t voltage, void *data) {
     assert(data != nullptr);
-    const auto timestamp = create_timestamp(timestamp_resolution::milliseconds);
+    const auto timestamp = create_timestamp(
+        timestamp_resolution::hundred_nanoseconds);
     auto that = static_cast<tinkerforge_sensor_impl *>(data);
-    std::lock_guard<decltype(that->async_lock)> l(that->async_lock);
-    that->async_data[2] = static_cast<measurement::value_type>(voltage)
-        / static_cast<measurement::value_type>(1000);
-    that->invoke_callback(timestamp);   // TODO: Do we really want to invoke directly? How do we detect a consistent state?
+    that->async_queue->push({ tinkerforge_sensor_source::voltage, timestamp,
+        static_cast<measurement::value_type>(voltage)
+        / static_cast<measurement::value_type>(1000) });
 }
 
 
@@ -78,8 +110,14 @@ visus::power_overwhelming::detail::tinkerforge_sensor_impl::voltage_callback(
 visus::power_overwhelming::detail::tinkerforge_sensor_impl::tinkerforge_sensor_impl(
         const std::string& host, const std::uint16_t port,
         const char *uid)
-    : on_measurement(nullptr), on_measurement_context(nullptr),
-        scope(host, port) {
+    : async_expected(static_cast<std::uint32_t>(
+            tinkerforge_sensor_source::all)),
+        async_received(0), async_timestamp(0), async_batch_size(1),
+        async_incomplete(0), async_sequence(0), async_outage(0),
+        async_period(0), configured(false), host(host), port(port),
+        quantities(tinkerforge_sensor_source::power), on_measurement(nullptr),
+        on_measurement_context(nullptr), on_measurement_data(nullptr),
+        reconstruct_timestamps(true), scope(host, port) {
     // Note that there is a delicate balance in what is done where and when in
     // this constructor: If we enter the body, the scope will have a valid
     // connection to a master brick. Otherwise, its constructor would have
@@ -90,7 +128,7 @@ visus::power_overwhelming::detail::tinkerforge_sensor_impl::tinkerforge_sensor_i
     // because the destructor will not be called as the object has never been
     // constructed. This is the reason why the 'sensor_name' is create before
     // the bricklet: creating the string might throw std::bad_alloc and
-    // std::system_error.
+    // std::system_error. The same holds for the queue.
     if (uid == nullptr) {
         throw std::invalid_argument("The UID of the voltage/current bricklet "
             "must not be null.");
@@ -98,8 +136,15 @@ visus::power_overwhelming::detail::tinkerforge_sensor_impl::tinkerforge_sensor_i
 
     this->sensor_name = power_overwhelming::convert_string<wchar_t>(
         tinkerforge_sensor_impl::get_sensor_name(host, port, uid));
+    this->async_queue = std::make_shared<tinkerforge_dispatcher::queue>(
+        &tinkerforge_sensor_impl::dispatch_callback, this);
+    this->scope.add_reconnect_handler(
+        &tinkerforge_sensor_impl::reconnect_callback, this);
 
+    // The handler does not use the bricklet unless the callbacks have been
+    // enabled, so it is safe to create the bricklet after registering it.
     ::voltage_current_v2_create(&this->bricklet, uid, this->scope);
+    std::fill(this->configuration.begin(), this->configuration.end(), 0);
 
     // Initialise the asynchronous measurement buffer with in valid data.
     std::fill(this->async_data.begin(), this->async_data.end(),
@@ -112,6 +157,10 @@ visus::power_overwhelming::detail::tinkerforge_sensor_impl::tinkerforge_sensor_i
  */
 visus::power_overwhelming::detail::tinkerforge_sensor_impl::~tinkerforge_sensor_impl(
         void) {
+    // Make sure that the callbacks are not restored while we are going away.
+    this->scope.remove_reconnect_handler(
+        &tinkerforge_sensor_impl::reconnect_callback, this);
+
     // Make sure to disable the callbacks in case the user forgot to do
     // so before destroying the sensor.
     this->disable_callbacks();
@@ -124,11 +173,118 @@ visus::power_overwhelming::detail::tinkerforge_sensor_impl::~tinkerforge_sensor_
 }
 
 
+/*
+ * visus::power_overwhelming::detail::tinkerforge_sensor_impl::assemble
+ */
+void visus::power_overwhelming::detail::tinkerforge_sensor_impl::assemble(
+        const tinkerforge_sensor_source source,
+        const measurement::value_type value,
+        const timestamp_type timestamp) {
+    const auto bit = static_cast<std::uint32_t>(source);
+
+    switch (source) {
+        case tinkerforge_sensor_source::current:
+            this->async_data[0] = value;
+            break;
+
+        case tinkerforge_sensor_source::power:
+            this->async_data[1] = value;
+            break;
+
+        case tinkerforge_sensor_source::voltage:
+            this->async_data[2] = value;
+            break;
+
+        default:
+            assert(false);
+            return;
+    }
+
+    if ((this->async_received & bit) != 0) {
+        // We have seen this quantity before the sample was complete, so the
+        // remaining readings of the previous period got lost. Start over with
+        // the reading we just got.
+        this->async_received = 0;
+        ++this->async_incomplete;
+        sequence_tracker::next(this->async_sequence);
+    }
+
+    if (this->async_received == 0) {
+        // The first reading of a period determines the timestamp.
+        this->async_timestamp = timestamp;
+    }
+
+    this->async_received |= bit;
+
+    if ((this->async_received & this->async_expected)
+            == this->async_expected) {
+        this->invoke_callback(this->async_timestamp);
+        this->async_received = 0;
+    }
+}
+
+
+/*
+ * ...::detail::tinkerforge_sensor_impl::confirm_configuration
+ */
+void visus::power_overwhelming::detail::tinkerforge_sensor_impl
+::confirm_configuration(const std::uint8_t averaging,
+        const std::uint8_t voltage_time,
+        const std::uint8_t current_time) {
+    std::uint8_t actual_averaging = 0;
+    std::uint8_t actual_voltage_time = 0;
+    std::uint8_t actual_current_time = 0;
+
+    // Getters are always acknowledged, and the bricklet processes the requests
+    // in order, so the answer implies that the configuration has been set.
+    auto status = ::voltage_current_v2_get_configuration(&this->bricklet,
+        &actual_averaging, &actual_voltage_time, &actual_current_time);
+    if (status < 0) {
+        throw tinkerforge_exception(status);
+    }
+
+    if ((actual_averaging != averaging)
+            || (actual_voltage_time != voltage_time)
+            || (actual_current_time != current_time)) {
+        throw std::runtime_error("The voltage/current bricklet has not applied "
+            "the requested configuration.");
+    }
+
+    this->unacknowledge_callbacks();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::tinkerforge_sensor_impl::deliver_batch
+ */
+void visus::power_overwhelming::detail::tinkerforge_sensor_impl::deliver_batch(
+        void) {
+    auto cb = this->on_measurement_data.load();
+
+    if ((cb != nullptr) && !this->async_batch.empty()) {
+        cb(sensor_name_registry::intern(this->sensor_name.c_str()),
+            this->async_batch.data(),
+            this->async_batch.size(),
+            this->on_measurement_context.load());
+    }
+
+    this->async_batch.clear();
+}
+
+
 /*
  * visus::power_overwhelming::detail::tinkerforge_sensor_impl::disable_callbacks
  */
 void visus::power_overwhelming::detail::tinkerforge_sensor_impl::disable_callbacks(
         void) {
+    std::lock_guard<decltype(this->restore_lock)> l(this->restore_lock);
+    this->async_period = 0;
+
+    // Stop dispatching first such that the queue is guaranteed to be detached
+    // even if the bricklet does not answer. This delivers what the dispatcher
+    // has not yet processed.
+    this->scope.dispatcher().remove(this->async_queue);
+
     {
         auto status = ::voltage_current_v2_set_current_callback_configuration(
             &this->bricklet, 0, false, 'x', 0, 0);
@@ -166,6 +322,54 @@ void visus::power_overwhelming::detail::tinkerforge_sensor_impl::enable_callback
 }
 
 
+/*
+ * ...::tinkerforge_sensor_impl::enable_callbacks
+ */
+void visus::power_overwhelming::detail::tinkerforge_sensor_impl::enable_callbacks(
+        const tinkerforge_sensor_source source, const std::int32_t period) {
+    std::lock_guard<decltype(this->restore_lock)> r(this->restore_lock);
+
+    {
+        // Reset the assembly such that we neither complete a sample from the
+        // previous run nor keep values of quantities that are not sampled
+        // anymore.
+        std::lock_guard<decltype(this->async_lock)> l(this->async_lock);
+        std::fill(this->async_data.begin(), this->async_data.end(),
+            measurement::invalid_value);
+        this->async_expected = static_cast<std::uint32_t>(source);
+        this->async_outage = std::chrono::milliseconds::zero();
+        this->async_received = 0;
+        this->clock.reset();
+    }
+
+    // Remember the period first such that a connection lost while we are
+    // enabling the callbacks will restore them.
+    this->async_period = period;
+
+    this->scope.dispatcher().add(this->async_queue);
+
+    if (source == tinkerforge_sensor_source::all) {
+        // Enable all sensor readings.
+        this->enable_callbacks(period);
+
+    } else {
+        // Enable individual sensor readings.
+        if ((source & tinkerforge_sensor_source::current)
+                == tinkerforge_sensor_source::current) {
+            this->enable_current_callback(period);
+        }
+        if ((source & tinkerforge_sensor_source::power)
+                == tinkerforge_sensor_source::power) {
+            this->enable_power_callback(period);
+        }
+        if ((source & tinkerforge_sensor_source::voltage)
+                == tinkerforge_sensor_source::voltage) {
+            this->enable_voltage_callback(period);
+        }
+    }
+}
+
+
 /*
  * ...::detail::tinkerforge_sensor_impl::enable_current_callback
  */
@@ -230,20 +434,186 @@ void visus::power_overwhelming::detail::tinkerforge_sensor_impl
  * visus::power_overwhelming::detail::tinkerforge_sensor_impl::invoke_callback
  */
 void visus::power_overwhelming::detail::tinkerforge_sensor_impl::invoke_callback(
-        const timestamp_type timestamp) {
+        const timestamp_type arrival) {
     auto cb = this->on_measurement.load();
     auto ctx = this->on_measurement_context.load();
+    const auto sequence = sequence_tracker::next(this->async_sequence);
+
+    // The model is fitted to the precise arrival times, but the samples are
+    // delivered in milliseconds as before.
+    const auto timestamp = convert<timestamp_resolution::milliseconds>(
+        this->reconstruct_timestamps
+        ? this->clock.push(sequence, arrival)
+        : arrival);
 
     if (cb != nullptr) {
         auto current = this->async_data[0];
         auto power = this->async_data[1];
         auto voltage = this->async_data[2];
-        measurement measurement(this->sensor_name.c_str(), timestamp, voltage,
-            current, power);
+        measurement_data data(timestamp, voltage, current, power);
+        data.sequence(sequence);
+        measurement measurement(this->sensor_name.c_str(), data);
 
         cb = this->on_measurement.load();
         if ((cb != nullptr) && measurement) {
             cb(measurement, ctx);
         }
     }
+
+    if (this->on_measurement_data.load() != nullptr) {
+        measurement_data sample(timestamp, this->async_data[2],
+            this->async_data[0], this->async_data[1]);
+        sample.sequence(sequence);
+
+        if (sample) {
+            this->async_batch.push_back(sample);
+
+            if (this->async_batch.size() >= this->async_batch_size) {
+                this->deliver_batch();
+            }
+        }
+    }
+}
+
+
+/*
+ * ...::detail::tinkerforge_sensor_impl::post_configuration
+ */
+void visus::power_overwhelming::detail::tinkerforge_sensor_impl
+::post_configuration(const std::uint8_t averaging,
+        const std::uint8_t voltage_time,
+        const std::uint8_t current_time) {
+    static constexpr auto function
+        = VOLTAGE_CURRENT_V2_FUNCTION_SET_CONFIGURATION;
+
+    // Whether a response is expected is a property of the local device object,
+    // so we can switch it off temporarily without talking to the bricklet.
+    auto status = ::voltage_current_v2_set_response_expected(&this->bricklet,
+        function, false);
+    if (status < 0) {
+        throw tinkerforge_exception(status);
+    }
+
+    status = ::voltage_current_v2_set_configuration(&this->bricklet,
+        averaging, voltage_time, current_time);
+    ::voltage_current_v2_set_response_expected(&this->bricklet, function, true);
+    if (status < 0) {
+        throw tinkerforge_exception(status);
+    }
+}
+
+
+/*
+ * ...::detail::tinkerforge_sensor_impl::remember_configuration
+ */
+void visus::power_overwhelming::detail::tinkerforge_sensor_impl
+::remember_configuration(const std::uint8_t averaging,
+        const std::uint8_t voltage_time,
+        const std::uint8_t current_time) {
+    std::lock_guard<decltype(this->restore_lock)> l(this->restore_lock);
+    this->configuration[0] = averaging;
+    this->configuration[1] = voltage_time;
+    this->configuration[2] = current_time;
+    this->configured = true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::tinkerforge_sensor_impl::restore
+ */
+bool visus::power_overwhelming::detail::tinkerforge_sensor_impl::restore(
+        const std::chrono::milliseconds outage) {
+    std::lock_guard<decltype(this->restore_lock)> r(this->restore_lock);
+    const auto period = this->async_period;
+    tinkerforge_sensor_source source;
+
+    if (period <= 0) {
+        // The callbacks are not enabled, so there is nothing to restore. The
+        // configuration of the bricklet is applied once it is sampled.
+        return true;
+    }
+
+    {
+        // Discard the sample that was being assembled when the connection was
+        // lost and skip the sequence numbers of the samples we missed.
+        std::lock_guard<decltype(this->async_lock)> l(this->async_lock);
+        std::fill(this->async_data.begin(), this->async_data.end(),
+            measurement::invalid_value);
+        this->async_received = 0;
+
+        if (outage < this->async_outage) {
+            // This is a new outage rather than another attempt to recover
+            // from the previous one.
+            this->async_outage = std::chrono::milliseconds::zero();
+        }
+
+        auto missed = (outage - this->async_outage).count() / period;
+        this->async_outage = outage;
+        while (missed-- > 0) {
+            sequence_tracker::next(this->async_sequence);
+        }
+
+        // The callbacks will restart in a different phase.
+        this->clock.reset();
+
+        source = static_cast<tinkerforge_sensor_source>(this->async_expected);
+    }
+
+    try {
+        if (this->configured) {
+            const auto& c = this->configuration;
+            this->post_configuration(c[0], c[1], c[2]);
+            this->confirm_configuration(c[0], c[1], c[2]);
+        } else {
+            // Make sure that the bricklet answers before enabling the
+            // callbacks, which are not acknowledged.
+            std::uint8_t a, v, c;
+            auto status = ::voltage_current_v2_get_configuration(
+                &this->bricklet, &a, &v, &c);
+            if (status < 0) {
+                throw tinkerforge_exception(status);
+            }
+        }
+
+        if ((source & tinkerforge_sensor_source::current)
+                == tinkerforge_sensor_source::current) {
+            this->enable_current_callback(period);
+        }
+        if ((source & tinkerforge_sensor_source::power)
+                == tinkerforge_sensor_source::power) {
+            this->enable_power_callback(period);
+        }
+        if ((source & tinkerforge_sensor_source::voltage)
+                == tinkerforge_sensor_source::voltage) {
+            this->enable_voltage_callback(period);
+        }
+
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+
+/*
+ * ...::detail::tinkerforge_sensor_impl::unacknowledge_callbacks
+ */
+void visus::power_overwhelming::detail::tinkerforge_sensor_impl
+::unacknowledge_callbacks(void) {
+    // The parameters we use for the callbacks are always valid, so the only
+    // error the bricklet could report is that it is unreachable, which we
+    // would also notice from the missing callbacks.
+    static constexpr std::uint8_t functions[] = {
+        VOLTAGE_CURRENT_V2_FUNCTION_SET_CURRENT_CALLBACK_CONFIGURATION,
+        VOLTAGE_CURRENT_V2_FUNCTION_SET_POWER_CALLBACK_CONFIGURATION,
+        VOLTAGE_CURRENT_V2_FUNCTION_SET_VOLTAGE_CALLBACK_CONFIGURATION
+    };
+
+    for (auto f : functions) {
+        auto status = ::voltage_current_v2_set_response_expected(
+            &this->bricklet, f, false);
+        if (status < 0) {
+            throw tinkerforge_exception(status);
+        }
+    }
 }
@@ -7,8 +7,10 @@
 
 #include <array>
 #include <atomic>
+#include <chrono>
 #include <mutex>
 #include <functional>
+#include <vector>
 
 #include <bricklet_voltage_current_v2.h>
 
@@ -17,8 +19,12 @@
 #endif /* defined(_WIN32) */
 
 #include "power_overwhelming/measurement.h"
+#include "power_overwhelming/tinkerforge_sensor_source.h"
 
+#include "periodic_clock.h"
+#include "sequence_tracker.h"
 #include "timestamp.h"
+#include "tinkerforge_dispatcher.h"
 #include "tinkerforge_scope.h"
 
 
@@ -45,6 +51,19 @@ namespace detail {
         static void CALLBACK current_callback(const std::int32_t current,
             void *data);
 
+        /// <summary>
+        /// The handler of <see cref="async_queue" />, which assembles the
+        /// readings on the thread of the <see cref="tinkerforge_dispatcher" />.
+        /// </summary>
+        /// <param name="readings">The readings that have been received since
+        /// the last dispatch.</param>
+        /// <param name="cnt">The number of elements in
+        /// <paramref name="readings" />.</param>
+        /// <param name="data">The <see cref="tinkerforge_sensor_impl" />.
+        /// </param>
+        static void dispatch_callback(const tinkerforge_reading *readings,
+            const std::size_t cnt, void *data);
+
         /// <summary>
         /// Compose the sensor name from the given connection information.
         /// </summary>
@@ -64,6 +83,20 @@ namespace detail {
         static void CALLBACK power_callback(const std::int32_t power,
             void *data);
 
+        /// <summary>
+        /// The <see cref="tinkerforge_scope::reconnect_handler" />, which
+        /// restores the state of the bricklet after the connection to the
+        /// Brick daemon has been re-established.
+        /// </summary>
+        /// <param name="outage">The time since the connection was lost.
+        /// </param>
+        /// <param name="data">The <see cref="tinkerforge_sensor_impl" />.
+        /// </param>
+        /// <returns><c>true</c> if the bricklet has been restored, <c>false
+        /// </c> if it must be tried again later.</returns>
+        static bool reconnect_callback(const std::chrono::milliseconds outage,
+            void *data);
+
         /// <summary>
         /// The callback to be invoked for incoming asynchronous voltage
         /// readings.
@@ -82,18 +115,152 @@ namespace detail {
         /// Buffer for incoming asynchronous data (current, power, voltage, in
         /// that order).
         /// </summary>
+        /// <remarks>
+        /// The bricklet reports each quantity in a separate callback. The
+        /// buffer is used to assemble the readings of one period into a
+        /// single sample, which is only delivered once all quantities in
+        /// <see cref="async_expected" /> have arrived.
+        /// </remarks>
         std::array<measurement::value_type, 3> async_data;
 
         /// <summary>
-        /// A lock for protecting <see cref="async_data" />.
+        /// The bitmask of <see cref="tinkerforge_sensor_source" />s that have
+        /// been enabled and must be received before a sample is complete.
+        /// </summary>
+        std::uint32_t async_expected;
+
+        /// <summary>
+        /// The bitmask of <see cref="tinkerforge_sensor_source" />s that have
+        /// been received for the sample currently being assembled in
+        /// <see cref="async_data" />.
+        /// </summary>
+        std::uint32_t async_received;
+
+        /// <summary>
+        /// The arrival time of the first reading of the sample currently being
+        /// assembled in <see cref="async_data" /> in 100 ns units.
+        /// </summary>
+        timestamp_type async_timestamp;
+
+        /// <summary>
+        /// Buffer for asynchronous samples that have not yet been delivered
+        /// to <see cref="on_measurement_data" />.
+        /// </summary>
+        std::vector<measurement_data> async_batch;
+
+        /// <summary>
+        /// The number of samples in <see cref="async_batch" /> that cause the
+        /// batch to be delivered to <see cref="on_measurement_data" />.
+        /// </summary>
+        std::size_t async_batch_size;
+
+        /// <summary>
+        /// A lock for protecting <see cref="async_data" />, the state of the
+        /// assembly and <see cref="async_batch" />.
         /// </summary>
         std::mutex async_lock;
 
+        /// <summary>
+        /// The number of samples that have been discarded by
+        /// <see cref="assemble" /> because not all of their quantities have
+        /// been received, which indicates that the Brick daemon dropped
+        /// packets.
+        /// </summary>
+        std::atomic<std::uint64_t> async_incomplete;
+
+        /// <summary>
+        /// The sequence number of the last sample assembled from the
+        /// callbacks of the bricklet.
+        /// </summary>
+        /// <remarks>
+        /// Samples discarded by <see cref="assemble" /> consume a number such
+        /// that the consumer can detect them. The number is protected by
+        /// <see cref="async_lock" />.
+        /// </remarks>
+        measurement_data::sequence_type async_sequence;
+
+        /// <summary>
+        /// The part of the current outage of the connection that has already
+        /// been accounted for in <see cref="async_sequence" />.
+        /// </summary>
+        /// <remarks>
+        /// Restoring the bricklet might need several attempts, but the gap
+        /// must be marked only once. The value is protected by
+        /// <see cref="async_lock" />.
+        /// </remarks>
+        std::chrono::milliseconds async_outage;
+
+        /// <summary>
+        /// The period in milliseconds at which the callbacks are enabled, or
+        /// zero if they are disabled.
+        /// </summary>
+        /// <remarks>
+        /// Together with <see cref="async_expected" />, this is the state that
+        /// is restored after the connection has been lost. The value is
+        /// protected by <see cref="restore_lock" />.
+        /// </remarks>
+        std::int32_t async_period;
+
+        /// <summary>
+        /// The queue through which the bricklet callbacks pass their readings
+        /// to the <see cref="tinkerforge_dispatcher" /> of the
+        /// <see cref="scope" />.
+        /// </summary>
+        /// <remarks>
+        /// The queue is registered with the dispatcher while callbacks are
+        /// enabled. The callbacks themselves only push into the queue, such
+        /// that the callback thread of the connection is never blocked by the
+        /// user code invoked for a sample.
+        /// </remarks>
+        std::shared_ptr<tinkerforge_dispatcher::queue> async_queue;
+
+        /// <summary>
+        /// The model of the clock of the bricklet, which is used to stamp the
+        /// samples if <see cref="reconstruct_timestamps" /> is set.
+        /// </summary>
+        /// <remarks>
+        /// The clock is protected by <see cref="async_lock" />.
+        /// </remarks>
+        periodic_clock clock;
+
+        /// <summary>
+        /// The averaging and the conversion times for voltage and current (in
+        /// that order) that have last been applied to the bricklet.
+        /// </summary>
+        /// <remarks>
+        /// The configuration is only valid if <see cref="configured" /> is
+        /// set. Both are protected by <see cref="restore_lock" />.
+        /// </remarks>
+        std::array<std::uint8_t, 3> configuration;
+
+        /// <summary>
+        /// Indicates whether <see cref="configuration" /> has been set.
+        /// </summary>
+        bool configured;
+
         /// <summary>
         /// A user-defined description of what the sensor is actually measuring.
         /// </summary>
         std::wstring description;
 
+        /// <summary>
+        /// The host on which the Brick daemon connected to the bricklet is
+        /// running.
+        /// </summary>
+        std::string host;
+
+        /// <summary>
+        /// The port on which the Brick daemon connected to the bricklet is
+        /// listening.
+        /// </summary>
+        std::uint16_t port;
+
+        /// <summary>
+        /// The quantities sampled if the sensor is sampled via the generic
+        /// <see cref="sensor::sample_batch" /> interface.
+        /// </summary>
+        tinkerforge_sensor_source quantities;
+
         /// <summary>
         /// A callback to be invoked if a <see cref="measurement" /> is received
         /// asynchronously.
@@ -105,6 +272,31 @@ namespace detail {
         /// </summary>
         std::atomic<void *> on_measurement_context;
 
+        /// <summary>
+        /// A callback to be invoked if a batch of samples has been received
+        /// asynchronously.
+        /// </summary>
+        /// <remarks>
+        /// This callback and <see cref="on_measurement" /> are mutually
+        /// exclusive. Both use <see cref="on_measurement_context" />.
+        /// </remarks>
+        std::atomic<measurement_data_callback> on_measurement_data;
+
+        /// <summary>
+        /// Indicates whether the samples are stamped using <see cref="clock" />
+        /// rather than with their arrival time.
+        /// </summary>
+        /// <remarks>
+        /// The flag is protected by <see cref="async_lock" />.
+        /// </remarks>
+        bool reconstruct_timestamps;
+
+        /// <summary>
+        /// Serialises enabling and disabling the callbacks with restoring them
+        /// after the connection has been re-established.
+        /// </summary>
+        std::mutex restore_lock;
+
         /// <summary>
         /// The name of the sensor, which has been created from the host,
         /// port and unique ID of the bricklet.
@@ -131,6 +323,59 @@ namespace detail {
         /// </summary>
         ~tinkerforge_sensor_impl(void);
 
+        /// <summary>
+        /// Adds the reading of a single quantity to the sample being
+        /// assembled in <see cref="async_data" /> and invokes the callbacks if
+        /// the sample is complete.
+        /// </summary>
+        /// <remarks>
+        /// <para>If a quantity is received a second time before the sample is
+        /// complete, the callbacks for the other quantities of the previous
+        /// period have been lost. In this case, the incomplete sample is
+        /// discarded and the assembly restarts with the new reading such that
+        /// values from different periods are never mixed.</para>
+        /// <para>The caller must hold <see cref="async_lock" />.</para>
+        /// </remarks>
+        /// <param name="source">The quantity that has been received, which
+        /// must be exactly one of current, power and voltage.</param>
+        /// <param name="value">The value of the quantity in SI units.</param>
+        /// <param name="timestamp">The time when the reading has been
+        /// received in 100 ns units.</param>
+        void assemble(const tinkerforge_sensor_source source,
+            const measurement::value_type value,
+            const timestamp_type timestamp);
+
+        /// <summary>
+        /// Waits until the bricklet has processed all requests sent before by
+        /// reading back its configuration and checks that it matches the
+        /// given one.
+        /// </summary>
+        /// <remarks>
+        /// As the bricklet has answered, it is known to be reachable, wherefore
+        /// the requests (re-) configuring the callbacks will not wait for an
+        /// acknowledgement afterwards.
+        /// </remarks>
+        /// <param name="averaging">The expected number of samples to average.
+        /// </param>
+        /// <param name="voltage_time">The expected conversion time for
+        /// voltage.</param>
+        /// <param name="current_time">The expected conversion time for
+        /// current.</param>
+        /// <exception cref="std::runtime_error">If the bricklet reports a
+        /// different configuration.</exception>
+        /// <exception cref="tinkerforge_exception"></exception>
+        void confirm_configuration(const std::uint8_t averaging,
+            const std::uint8_t voltage_time,
+            const std::uint8_t current_time);
+
+        /// <summary>
+        /// Delivers and clears the pending <see cref="async_batch" />.
+        /// </summary>
+        /// <remarks>
+        /// The caller must hold <see cref="async_lock" />.
+        /// </remarks>
+        void deliver_batch(void);
+
         /// <summary>
         /// Disable all three callbacks of <see cref="bricklet" />.
         /// </summary>
@@ -149,6 +394,19 @@ namespace detail {
         /// <exception cref="tinkerforge_exception"></exception>
         void enable_callbacks(const std::int32_t period = 1);
 
+        /// <summary>
+        /// Enable the callbacks for the given source(s) of data.
+        /// </summary>
+        /// <remarks>
+        /// This method resets the assembly of samples, which will only be
+        /// complete once all of the given sources have been received.
+        /// </remarks>
+        /// <param name="source">The source(s) of data to be enabled.</param>
+        /// <param name="period"></param>
+        /// <exception cref="tinkerforge_exception"></exception>
+        void enable_callbacks(const tinkerforge_sensor_source source,
+            const std::int32_t period);
+
         /// <summary>
         /// Enable the current callback with <see cref="bricklet" />.
         /// </summary>
@@ -175,8 +433,56 @@ namespace detail {
         /// the data stored in <see cref="async_data" />.
         /// </summary>
         /// <remarks>The caller must hold <see cref="async_lock" />.</remarks>
-        /// <param name="timestamp"></param>
-        void invoke_callback(const timestamp_type timestamp);
+        /// <param name="arrival">The arrival time of the sample in 100 ns
+        /// units, which is replaced by the time reconstructed by
+        /// <see cref="clock" /> if requested.</param>
+        void invoke_callback(const timestamp_type arrival);
+
+        /// <summary>
+        /// Sends the configuration of the A/D converter to the bricklet
+        /// without waiting for it to be acknowledged.
+        /// </summary>
+        /// <param name="averaging">The number of samples to average.</param>
+        /// <param name="voltage_time">The conversion time for voltage.</param>
+        /// <param name="current_time">The conversion time for current.</param>
+        /// <exception cref="tinkerforge_exception">If the request could not be
+        /// sent.</exception>
+        void post_configuration(const std::uint8_t averaging,
+            const std::uint8_t voltage_time,
+            const std::uint8_t current_time);
+
+        /// <summary>
+        /// Stores the configuration of the A/D converter such that it can be
+        /// restored after the connection has been lost.
+        /// </summary>
+        /// <param name="averaging">The number of samples to average.</param>
+        /// <param name="voltage_time">The conversion time for voltage.</param>
+        /// <param name="current_time">The conversion time for current.</param>
+        void remember_configuration(const std::uint8_t averaging,
+            const std::uint8_t voltage_time,
+            const std::uint8_t current_time);
+
+        /// <summary>
+        /// Restores the configuration and the callbacks of the bricklet after
+        /// the connection has been re-established.
+        /// </summary>
+        /// <remarks>
+        /// The sequence numbers of the samples that should have been received
+        /// during the <paramref name="outage" /> are skipped, such that the
+        /// gap is visible in the stream of samples.
+        /// </remarks>
+        /// <param name="outage">The time since the connection was lost.
+        /// </param>
+        /// <returns><c>true</c> if the bricklet has been restored, <c>false
+        /// </c> if it did not answer.</returns>
+        bool restore(const std::chrono::milliseconds outage);
+
+        /// <summary>
+        /// Stops waiting for acknowledgements of the requests configuring the
+        /// callbacks of <see cref="bricklet" />.
+        /// </summary>
+        /// <exception cref="tinkerforge_exception"></exception>
+        void unacknowledge_callbacks(void);
     };
 
 } /* namespace detail */
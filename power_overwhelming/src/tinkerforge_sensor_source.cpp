@@ -6,6 +6,7 @@
 #include "power_overwhelming/tinkerforge_sensor_source.h"
 
 #include <stdexcept>
+#include <string>
 #include <type_traits>
 
 
@@ -33,6 +34,49 @@ visus::power_overwhelming::operator &(_In_ const tinkerforge_sensor_source lhs,
 }
 
 
+/*
+ * visus::power_overwhelming::parse_tinkerforge_sensor_source
+ */
+visus::power_overwhelming::tinkerforge_sensor_source
+visus::power_overwhelming::parse_tinkerforge_sensor_source(
+        _In_z_ const wchar_t *str) {
+    if (str == nullptr) {
+        throw std::invalid_argument("Only a valid string can be parsed into a "
+            "tinkerforge_sensor_source.");
+    }
+
+    auto retval = tinkerforge_sensor_source::none;
+    const std::wstring s(str);
+    std::wstring::size_type begin = 0;
+
+#define _FROM_STRING_CASE(v) else if (to_string(tinkerforge_sensor_source::v) \
+    == t) retval = retval | tinkerforge_sensor_source::v
+
+    do {
+        auto end = s.find(L'|', begin);
+        if (end == std::wstring::npos) {
+            end = s.size();
+        }
+
+        const auto t = s.substr(begin, end - begin);
+        if (false);
+        _FROM_STRING_CASE(none);
+        _FROM_STRING_CASE(current);
+        _FROM_STRING_CASE(voltage);
+        _FROM_STRING_CASE(power);
+        _FROM_STRING_CASE(all);
+        else throw std::invalid_argument("The given string represents no "
+            "valid tinkerforge_sensor_source");
+
+        begin = end + 1;
+    } while (begin <= s.size());
+
+#undef _FROM_STRING_CASE
+
+    return retval;
+}
+
+
 /*
  * visus::power_overwhelming::to_string
  */
@@ -42,7 +86,22 @@ _Ret_valid_ const wchar_t *visus::power_overwhelming::to_string(
 #define _TO_STRING_CASE(v) case tinkerforge_sensor_source::v:\
     return _GCC_IS_SHIT(#v)
 
+    // Combinations of two sources have no name in the enumeration.
+    if (source == (tinkerforge_sensor_source::current
+            | tinkerforge_sensor_source::voltage)) {
+        return L"current|voltage";
+    }
+    if (source == (tinkerforge_sensor_source::current
+            | tinkerforge_sensor_source::power)) {
+        return L"current|power";
+    }
+    if (source == (tinkerforge_sensor_source::voltage
+            | tinkerforge_sensor_source::power)) {
+        return L"voltage|power";
+    }
+
     switch (source) {
+        _TO_STRING_CASE(none);
         _TO_STRING_CASE(current);
         _TO_STRING_CASE(voltage);
         _TO_STRING_CASE(power);
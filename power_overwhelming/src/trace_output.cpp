@@ -0,0 +1,711 @@
+﻿// <copyright file="trace_output.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "trace_output.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <time.h>
+#endif /* !defined(_WIN32) */
+
+#include "power_overwhelming/convert_string.h"
+
+#include "string_functions.h"
+#include "timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The protobuf wire types used by the Perfetto format.
+    /// </summary>
+    enum class wire_type : std::uint32_t {
+        varint = 0,
+        fixed64 = 1,
+        length_delimited = 2
+    };
+
+    /// <summary>
+    /// The numbers of the fields of the Perfetto protos we write.
+    /// </summary>
+    /// <remarks>
+    /// The numbers are taken from <c>protos/perfetto/trace</c> in the
+    /// Perfetto repository.
+    /// </remarks>
+    namespace perfetto {
+        static constexpr std::uint32_t clock_id = 1;
+        static constexpr std::uint32_t clock_snapshot = 6;
+        static constexpr std::uint32_t clock_snapshot_clocks = 1;
+        static constexpr std::uint32_t clock_timestamp = 2;
+        static constexpr std::uint32_t counter_unit_name = 6;
+        static constexpr std::uint32_t event_name_iid = 1;
+        static constexpr std::uint32_t event_name_name = 2;
+        static constexpr std::uint32_t interned_data = 12;
+        static constexpr std::uint32_t interned_event_names = 2;
+        static constexpr std::uint32_t sequence_flags = 13;
+        static constexpr std::uint32_t packet_timestamp = 8;
+        static constexpr std::uint32_t timestamp_clock_id = 58;
+        static constexpr std::uint32_t trace_packet = 1;
+        static constexpr std::uint32_t trace_packet_defaults = 59;
+        static constexpr std::uint32_t track_descriptor = 60;
+        static constexpr std::uint32_t track_descriptor_counter = 8;
+        static constexpr std::uint32_t track_descriptor_name = 2;
+        static constexpr std::uint32_t track_descriptor_uuid = 1;
+        static constexpr std::uint32_t track_event = 11;
+        static constexpr std::uint32_t track_event_double_counter_value = 44;
+        static constexpr std::uint32_t track_event_name_iid = 10;
+        static constexpr std::uint32_t track_event_track_uuid = 11;
+        static constexpr std::uint32_t track_event_type = 9;
+        static constexpr std::uint32_t trusted_packet_sequence_id = 10;
+
+        static constexpr std::uint64_t builtin_clock_realtime = 1;
+        static constexpr std::uint64_t builtin_clock_boottime = 6;
+        static constexpr std::uint64_t seq_incremental_state_cleared = 1;
+        static constexpr std::uint64_t seq_needs_incremental_state = 2;
+        static constexpr std::uint64_t sequence_id = 1;
+        static constexpr std::uint64_t type_slice_begin = 1;
+        static constexpr std::uint64_t type_slice_end = 2;
+        static constexpr std::uint64_t type_counter = 4;
+    }
+
+    /// <summary>
+    /// The process and thread ID of all events in the Chrome format.
+    /// </summary>
+    static constexpr const char *chrome_ids = "\"pid\":1,\"tid\":1";
+
+    /// <summary>
+    /// The number of seconds between the epoch of <c>FILETIME</c> and the
+    /// UNIX epoch.
+    /// </summary>
+    static constexpr std::int64_t file_time_offset = 11644473600LL;
+
+    /// <summary>
+    /// The names of the quantities appended to the name of a sensor to obtain
+    /// the name of a track.
+    /// </summary>
+    static constexpr const char *quantity_suffixes[] = {
+        "", " (V)", " (A)", " (mean)"
+    };
+
+    /// <summary>
+    /// The units of the quantities.
+    /// </summary>
+    static constexpr const char *quantity_units[] = { "W", "V", "A", "W" };
+
+    /// <summary>
+    /// Appends <paramref name="str" /> to <paramref name="dst" /> with the
+    /// characters escaped that must not occur in a JSON string.
+    /// </summary>
+    static void append_json(_Inout_ std::string& dst,
+            _In_ const std::string& str) {
+        for (auto c : str) {
+            switch (c) {
+                case '"': dst += "\\\""; break;
+                case '\\': dst += "\\\\"; break;
+                case '\n': dst += "\\n"; break;
+                case '\r': dst += "\\r"; break;
+                case '\t': dst += "\\t"; break;
+
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        char hex[8];
+                        std::snprintf(hex, sizeof(hex), "\\u%04x",
+                            static_cast<unsigned int>(c));
+                        dst += hex;
+                    } else {
+                        dst += c;
+                    }
+                    break;
+            }
+        }
+    }
+
+    /// <summary>
+    /// Appends the time in nanoseconds as microseconds with a fractional part
+    /// to <paramref name="dst" />.
+    /// </summary>
+    static void append_microseconds(_Inout_ std::string& dst,
+            _In_ const std::int64_t nanoseconds) {
+        char text[32];
+        const auto negative = (nanoseconds < 0);
+        const auto ns = negative ? -nanoseconds : nanoseconds;
+        std::snprintf(text, sizeof(text), "%s%lld.%03lld", negative ? "-" : "",
+            static_cast<long long>(ns / 1000),
+            static_cast<long long>(ns % 1000));
+        dst += text;
+    }
+
+    /// <summary>
+    /// Answer the current time of the boot clock in nanoseconds.
+    /// </summary>
+    /// <remarks>
+    /// Windows has no boot clock, so we use the steady clock, which is based on
+    /// the performance counter that starts at boot as well.
+    /// </remarks>
+    static std::int64_t boot_time(void) {
+#if defined(_WIN32)
+        using namespace std::chrono;
+        return duration_cast<nanoseconds>(
+            steady_clock::now().time_since_epoch()).count();
+#else /* defined(_WIN32) */
+        struct timespec time;
+        ::clock_gettime(CLOCK_BOOTTIME, &time);
+        return static_cast<std::int64_t>(time.tv_sec) * 1000000000LL
+            + time.tv_nsec;
+#endif /* defined(_WIN32) */
+    }
+
+    /// <summary>
+    /// Answer the current time of the real-time clock in nanoseconds since the
+    /// UNIX epoch.
+    /// </summary>
+    static std::int64_t real_time(void) {
+        using namespace std::chrono;
+        return duration_cast<nanoseconds>(system_clock::now()
+            - system_clock::from_time_t(0)).count();
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::trace_output_writer::block_size
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::trace_output_writer::block_size;
+
+
+/*
+ * visus::power_overwhelming::detail::trace_output_writer::marker_track
+ */
+constexpr std::uint64_t
+visus::power_overwhelming::detail::trace_output_writer::marker_track;
+
+
+/*
+ * visus::power_overwhelming::detail::trace_output_writer::trace_output_writer
+ */
+visus::power_overwhelming::detail::trace_output_writer::trace_output_writer(
+        void)
+    : _end(0), _epoch(0), _format(output_format::perfetto),
+        _have_event(false), _last_sensor(nullptr), _last_tracks(nullptr),
+        _next_track(marker_track + 1), _ns_per_tick(1), _open_marker(0) { }
+
+
+/*
+ * visus::power_overwhelming::detail::trace_output_writer::~trace_output_writer
+ */
+visus::power_overwhelming::detail::trace_output_writer::~trace_output_writer(
+        void) {
+    this->close();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::trace_output_writer::aggregate
+ */
+void visus::power_overwhelming::detail::trace_output_writer::aggregate(
+        _In_ const sample_aggregate& aggregate) {
+    this->counter(this->tracks(aggregate.sensor), quantity::mean,
+        aggregate.begin, aggregate.mean);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::trace_output_writer::close
+ */
+void visus::power_overwhelming::detail::trace_output_writer::close(void) {
+    if (this->is_open()) {
+        // Perfetto would show an unterminated slice as lasting forever.
+        if (this->_open_marker != 0) {
+            this->slice(this->_end, this->_open_marker, false);
+            this->_open_marker = 0;
+        }
+
+        if (this->_format == output_format::chrome_trace) {
+            this->_buffer += "\n]\n";
+        }
+
+        this->flush();
+        this->_file.close();
+    }
+
+    this->_have_event = false;
+    this->_last_sensor = nullptr;
+    this->_last_tracks = nullptr;
+    this->_markers.clear();
+    this->_next_track = marker_track + 1;
+    this->_sensors.clear();
+    this->_tracks.clear();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::trace_output_writer::flush
+ */
+void visus::power_overwhelming::detail::trace_output_writer::flush(void) {
+    if (!this->_buffer.empty()) {
+        this->_file.sputn(this->_buffer.data(),
+            static_cast<std::streamsize>(this->_buffer.size()));
+        this->_file.pubsync();
+        this->_buffer.clear();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::trace_output_writer::header
+ */
+void visus::power_overwhelming::detail::trace_output_writer::header(
+        _In_ const timestamp_resolution resolution,
+        _In_ const std::vector<std::wstring>& sensors) {
+    using namespace perfetto;
+    const auto tps = ticks_per_second(resolution);
+    this->_epoch = static_cast<std::int64_t>(file_time_offset * tps);
+    this->_ns_per_tick = static_cast<std::int64_t>(1e9 / tps + 0.5);
+
+    if (this->_format == output_format::chrome_trace) {
+        this->write("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+            "\"args\":{\"name\":\"Power Overwhelming\"}}");
+        this->write(std::string("{\"name\":\"thread_name\",\"ph\":\"M\",")
+            + chrome_ids + ",\"args\":{\"name\":\"Markers\"}}");
+
+    } else {
+        // The first packet resets the state of our sequence and makes the
+        // real-time clock the default for all of its packets.
+        this->_event.clear();
+        varint(this->_event, timestamp_clock_id, builtin_clock_realtime);
+        this->_packet.clear();
+        varint(this->_packet, trusted_packet_sequence_id, sequence_id);
+        varint(this->_packet, sequence_flags, seq_incremental_state_cleared);
+        bytes(this->_packet, trace_packet_defaults, this->_event);
+        bytes(this->_buffer, trace_packet, this->_packet);
+
+        // The snapshot relates the real-time clock to the boot clock, which
+        // is the default clock of system traces.
+        std::string clock;
+        this->_event.clear();
+        varint(clock, clock_id, builtin_clock_realtime);
+        varint(clock, clock_timestamp, real_time());
+        bytes(this->_event, clock_snapshot_clocks, clock);
+        clock.clear();
+        varint(clock, clock_id, builtin_clock_boottime);
+        varint(clock, clock_timestamp, boot_time());
+        bytes(this->_event, clock_snapshot_clocks, clock);
+        this->_packet.clear();
+        varint(this->_packet, trusted_packet_sequence_id, sequence_id);
+        bytes(this->_packet, clock_snapshot, this->_event);
+        bytes(this->_buffer, trace_packet, this->_packet);
+
+        this->_event.clear();
+        varint(this->_event, track_descriptor_uuid, marker_track);
+        bytes(this->_event, track_descriptor_name, "Markers");
+        this->_packet.clear();
+        varint(this->_packet, trusted_packet_sequence_id, sequence_id);
+        bytes(this->_packet, track_descriptor, this->_event);
+        bytes(this->_buffer, trace_packet, this->_packet);
+    }
+
+    for (auto& s : sensors) {
+        this->declare(this->tracks(s), quantity::power);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::trace_output_writer::marker
+ */
+void visus::power_overwhelming::detail::trace_output_writer::marker(
+        _In_ const std::uint32_t id, _In_z_ const wchar_t *name) {
+    std::string text;
+    if (name != nullptr) {
+        append_utf8(text, name);
+    }
+
+    if (this->_format == output_format::chrome_trace) {
+        std::string escaped;
+        append_json(escaped, text);
+        text = std::move(escaped);
+    }
+
+    // The name is interned with the first slice of the marker.
+    this->_markers[id] = std::make_pair(std::move(text), false);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::trace_output_writer::marker_event
+ */
+void visus::power_overwhelming::detail::trace_output_writer::marker_event(
+        _In_ const measurement::timestamp_type timestamp,
+        _In_ const std::uint32_t id) {
+    if (this->_open_marker != 0) {
+        this->slice(timestamp, this->_open_marker, false);
+    }
+
+    if (id != 0) {
+        this->slice(timestamp, id, true);
+    }
+
+    this->_open_marker = id;
+    this->_end = (std::max)(this->_end, timestamp);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::trace_output_writer::open
+ */
+void visus::power_overwhelming::detail::trace_output_writer::open(
+        _In_z_ const wchar_t *path, _In_ const output_format format) {
+    if (path == nullptr) {
+        throw std::invalid_argument("The path to the trace output file must "
+            "not be null.");
+    }
+    if ((format != output_format::perfetto)
+            && (format != output_format::chrome_trace)) {
+        throw std::invalid_argument("The trace output only supports the "
+            "Perfetto and the Chrome format.");
+    }
+
+    this->close();
+    this->_format = format;
+
+    const auto mode = std::ofstream::binary | std::ofstream::out
+        | std::ofstream::trunc;
+#if defined(_WIN32)
+    this->_file.open(path, mode);
+#else /* defined(_WIN32) */
+    auto p = power_overwhelming::convert_string<char>(path);
+    this->_file.open(p, mode);
+#endif /* defined(_WIN32) */
+
+    if (!this->_file.is_open()) {
+        throw std::ios_base::failure("The trace output file could not be "
+            "opened.");
+    }
+
+    if (this->_format == output_format::chrome_trace) {
+        this->_buffer += "[\n";
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::trace_output_writer::push
+ */
+void visus::power_overwhelming::detail::trace_output_writer::push(
+        _In_ const measurement& sample,
+        _In_ const std::uint32_t marker) {
+    const auto invalid = measurement::invalid_value;
+    auto& tracks = this->tracks(sample.sensor());
+
+    if (sample.power() != invalid) {
+        this->counter(tracks, quantity::power, sample.timestamp(),
+            sample.power());
+    }
+    if (sample.voltage() != invalid) {
+        this->counter(tracks, quantity::voltage, sample.timestamp(),
+            sample.voltage());
+    }
+    if (sample.current() != invalid) {
+        this->counter(tracks, quantity::current, sample.timestamp(),
+            sample.current());
+    }
+
+    this->_end = (std::max)(this->_end, sample.timestamp());
+}
+
+
+/*
+ * visus::power_overwhelming::detail::trace_output_writer::bytes
+ */
+void visus::power_overwhelming::detail::trace_output_writer::bytes(
+        _Inout_ std::string& dst,
+        _In_ const std::uint32_t field,
+        _In_ const std::string& value) {
+    varint(dst, (static_cast<std::uint64_t>(field) << 3)
+        | static_cast<std::uint64_t>(wire_type::length_delimited));
+    varint(dst, value.size());
+    dst += value;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::trace_output_writer::fixed64
+ */
+void visus::power_overwhelming::detail::trace_output_writer::fixed64(
+        _Inout_ std::string& dst,
+        _In_ const std::uint32_t field,
+        _In_ const double value) {
+    static_assert(sizeof(double) == sizeof(std::uint64_t), "The fixed64 "
+        "encoding of double requires it to be 64 bits wide.");
+    std::uint64_t word;
+    ::memcpy(&word, &value, sizeof(word));
+
+    varint(dst, (static_cast<std::uint64_t>(field) << 3)
+        | static_cast<std::uint64_t>(wire_type::fixed64));
+
+    // Protobuf stores fixed-size numbers in little endian.
+    for (int i = 0; i < 8; ++i) {
+        dst += static_cast<char>((word >> (8 * i)) & 0xFF);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::trace_output_writer::varint
+ */
+void visus::power_overwhelming::detail::trace_output_writer::varint(
+        _Inout_ std::string& dst,
+        _In_ std::uint64_t value) {
+    while (value >= 0x80) {
+        dst += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    dst += static_cast<char>(value);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::trace_output_writer::varint
+ */
+void visus::power_overwhelming::detail::trace_output_writer::varint(
+        _Inout_ std::string& dst,
+        _In_ const std::uint32_t field,
+        _In_ const std::uint64_t value) {
+    varint(dst, (static_cast<std::uint64_t>(field) << 3)
+        | static_cast<std::uint64_t>(wire_type::varint));
+    varint(dst, value);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::trace_output_writer::counter
+ */
+void visus::power_overwhelming::detail::trace_output_writer::counter(
+        _In_ track_set& tracks,
+        _In_ const quantity what,
+        _In_ const measurement::timestamp_type timestamp,
+        _In_ const measurement::value_type value) {
+    using namespace perfetto;
+    const auto q = static_cast<std::size_t>(what);
+
+    if (!tracks.declared[q]) {
+        this->declare(tracks, what);
+    }
+
+    if (this->_format == output_format::chrome_trace) {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.9g", value);
+
+        this->_event = "{\"name\":\"";
+        this->_event += tracks.name;
+        this->_event += quantity_suffixes[q];
+        this->_event += "\",\"ph\":\"C\",\"pid\":1,\"ts\":";
+        append_microseconds(this->_event, this->time(timestamp));
+        this->_event += ",\"args\":{\"";
+        this->_event += quantity_units[q];
+        this->_event += "\":";
+        this->_event += text;
+        this->_event += "}}";
+        this->write(this->_event);
+
+    } else {
+        this->_event.clear();
+        varint(this->_event, track_event_type, type_counter);
+        varint(this->_event, track_event_track_uuid,
+            tracks.uuid + static_cast<std::uint64_t>(what));
+        fixed64(this->_event, track_event_double_counter_value, value);
+
+        this->_packet.clear();
+        varint(this->_packet, packet_timestamp, this->time(timestamp));
+        varint(this->_packet, trusted_packet_sequence_id, sequence_id);
+        varint(this->_packet, sequence_flags, seq_needs_incremental_state);
+        bytes(this->_packet, track_event, this->_event);
+        this->write(this->_packet);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::trace_output_writer::declare
+ */
+void visus::power_overwhelming::detail::trace_output_writer::declare(
+        _In_ track_set& tracks,
+        _In_ const quantity what) {
+    using namespace perfetto;
+    const auto q = static_cast<std::size_t>(what);
+    tracks.declared[q] = true;
+
+    // Chrome identifies the counters by their name, so only Perfetto needs a
+    // descriptor.
+    if (this->_format == output_format::perfetto) {
+        std::string counter;
+        bytes(counter, counter_unit_name, quantity_units[q]);
+
+        this->_event.clear();
+        varint(this->_event, track_descriptor_uuid,
+            tracks.uuid + static_cast<std::uint64_t>(what));
+        bytes(this->_event, track_descriptor_name,
+            tracks.name + quantity_suffixes[q]);
+        bytes(this->_event, track_descriptor_counter, counter);
+
+        this->_packet.clear();
+        varint(this->_packet, trusted_packet_sequence_id, sequence_id);
+        bytes(this->_packet, track_descriptor, this->_event);
+        this->write(this->_packet);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::trace_output_writer::slice
+ */
+void visus::power_overwhelming::detail::trace_output_writer::slice(
+        _In_ const measurement::timestamp_type timestamp,
+        _In_ const std::uint32_t id,
+        _In_ const bool begin) {
+    using namespace perfetto;
+    auto& marker = this->_markers[id];
+
+    if (this->_format == output_format::chrome_trace) {
+        this->_event = "{\"name\":\"";
+        this->_event += marker.first;
+        this->_event += begin ? "\",\"ph\":\"B\"," : "\",\"ph\":\"E\",";
+        this->_event += chrome_ids;
+        this->_event += ",\"ts\":";
+        append_microseconds(this->_event, this->time(timestamp));
+        this->_event += "}";
+        this->write(this->_event);
+
+    } else {
+        this->_packet.clear();
+        varint(this->_packet, packet_timestamp, this->time(timestamp));
+        varint(this->_packet, trusted_packet_sequence_id, sequence_id);
+        varint(this->_packet, sequence_flags, seq_needs_incremental_state);
+
+        if (begin && !marker.second) {
+            // The name of the marker is interned on its first use.
+            std::string name;
+            varint(name, event_name_iid, id);
+            bytes(name, event_name_name, marker.first);
+            this->_event.clear();
+            bytes(this->_event, interned_event_names, name);
+            bytes(this->_packet, interned_data, this->_event);
+            marker.second = true;
+        }
+
+        this->_event.clear();
+        varint(this->_event, track_event_type,
+            begin ? type_slice_begin : type_slice_end);
+        varint(this->_event, track_event_track_uuid, marker_track);
+        if (begin) {
+            varint(this->_event, track_event_name_iid, id);
+        }
+        bytes(this->_packet, track_event, this->_event);
+        this->write(this->_packet);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::trace_output_writer::time
+ */
+std::int64_t visus::power_overwhelming::detail::trace_output_writer::time(
+        _In_ const measurement::timestamp_type timestamp) const noexcept {
+    return (timestamp - this->_epoch) * this->_ns_per_tick;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::trace_output_writer::tracks
+ */
+visus::power_overwhelming::detail::trace_output_writer::track_set&
+visus::power_overwhelming::detail::trace_output_writer::tracks(
+        _In_opt_z_ const wchar_t *name) {
+    // The names of measurements are interned, so we can compare pointers. We
+    // also remember the last sensor, because the samples of a sensor are
+    // often consecutive in the buffers.
+    if ((name == this->_last_sensor) && (this->_last_tracks != nullptr)) {
+        return *this->_last_tracks;
+    }
+
+    auto it = this->_sensors.find(name);
+    if (it == this->_sensors.end()) {
+        // The sensors declared in the header are not interned, so we need to
+        // match the first sample of a sensor by its name.
+        auto& tracks = this->tracks((name != nullptr)
+            ? std::wstring(name)
+            : std::wstring());
+        it = this->_sensors.emplace(name, &tracks).first;
+    }
+
+    this->_last_sensor = name;
+    this->_last_tracks = it->second;
+    return *this->_last_tracks;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::trace_output_writer::tracks
+ */
+visus::power_overwhelming::detail::trace_output_writer::track_set&
+visus::power_overwhelming::detail::trace_output_writer::tracks(
+        _In_ const std::wstring& name) {
+    auto it = this->_tracks.find(name);
+
+    if (it == this->_tracks.end()) {
+        track_set tracks;
+        std::fill(std::begin(tracks.declared), std::end(tracks.declared),
+            false);
+        tracks.uuid = this->_next_track;
+        this->_next_track += static_cast<std::uint64_t>(quantity::count);
+
+        append_utf8(tracks.name, name.c_str());
+        if (this->_format == output_format::chrome_trace) {
+            std::string escaped;
+            append_json(escaped, tracks.name);
+            tracks.name = std::move(escaped);
+        }
+
+        it = this->_tracks.emplace(name, std::move(tracks)).first;
+    }
+
+    return it->second;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::trace_output_writer::write
+ */
+void visus::power_overwhelming::detail::trace_output_writer::write(
+        _In_ const std::string& data) {
+    if (this->_format == output_format::chrome_trace) {
+        // The events are separated by commas, but the closing bracket of the
+        // array is optional, so the trace is valid at any time.
+        if (this->_have_event) {
+            this->_buffer += ",\n";
+        }
+        this->_buffer += data;
+        this->_have_event = true;
+
+    } else {
+        bytes(this->_buffer, perfetto::trace_packet, data);
+    }
+
+    if (this->_buffer.size() >= block_size) {
+        this->flush();
+    }
+}
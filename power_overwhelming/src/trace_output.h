@@ -0,0 +1,246 @@
+﻿// <copyright file="trace_output.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "power_overwhelming/measurement.h"
+#include "power_overwhelming/output_format.h"
+#include "power_overwhelming/timestamp_resolution.h"
+
+#include "sample_aggregator.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Writes the samples of a collector as a trace that can be loaded into
+    /// Perfetto or the Chrome tracing UI.
+    /// </summary>
+    /// <remarks>
+    /// <para>Each sensor is written as a counter track of its power, which is
+    /// accompanied by counter tracks for the voltage and the current if the
+    /// sensor delivers them. The markers are written as consecutive slices on
+    /// a track of their own, which start when the marker is set and end when
+    /// the next one is set.</para>
+    /// <para>In the Perfetto format, the tracks are described once by a
+    /// <c>TrackDescriptor</c> and the samples only refer to the UUID of their
+    /// track, the names of the markers are interned, and all timestamps use
+    /// the real-time clock by default, which is translated to the boot time
+    /// by a clock snapshot. Therefore, a sample only needs around 35
+    /// bytes, and the trace can be concatenated with a system trace recorded
+    /// at the same time.</para>
+    /// <para>The Chrome format uses the JSON array form, which remains
+    /// readable if the file has not been closed.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API trace_output_writer final {
+
+    public:
+
+        /// <summary>
+        /// The UUID of the track for the markers.
+        /// </summary>
+        /// <remarks>
+        /// The UUIDs of the counter tracks are assigned from here on. The
+        /// value makes collisions with the hashed UUIDs of other producers
+        /// unlikely while keeping the varints of the samples short.
+        /// </remarks>
+        static constexpr std::uint64_t marker_track = 0x706f7767ULL;
+
+        /// <summary>
+        /// The number of bytes that are buffered before they are written to
+        /// the file.
+        /// </summary>
+        static constexpr std::size_t block_size = 1 << 20;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        trace_output_writer(void);
+
+        trace_output_writer(const trace_output_writer&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~trace_output_writer(void);
+
+        /// <summary>
+        /// Writes the mean of an aggregate to the counter track of the means
+        /// of its sensor.
+        /// </summary>
+        /// <param name="aggregate">The aggregate to be written.</param>
+        void aggregate(_In_ const sample_aggregate& aggregate);
+
+        /// <summary>
+        /// Ends the open marker slice, flushes and closes the file.
+        /// </summary>
+        void close(void);
+
+        /// <summary>
+        /// Writes all buffered data to the file.
+        /// </summary>
+        void flush(void);
+
+        /// <summary>
+        /// Answer the format of the trace.
+        /// </summary>
+        /// <returns>The format of the trace.</returns>
+        inline output_format format(void) const noexcept {
+            return this->_format;
+        }
+
+        /// <summary>
+        /// Writes the description of the trace and of the sensors that are
+        /// known in advance.
+        /// </summary>
+        /// <param name="resolution">The resolution of the timestamps of all
+        /// samples that are subsequently written.</param>
+        /// <param name="sensors">The names of the sensors, which are
+        /// declared in this order.</param>
+        /// <exception cref="std::invalid_argument">If the
+        /// <paramref name="resolution" /> is not supported.</exception>
+        void header(_In_ const timestamp_resolution resolution,
+            _In_ const std::vector<std::wstring>& sensors);
+
+        /// <summary>
+        /// Answer whether the file is open.
+        /// </summary>
+        /// <returns><c>true</c> if the file is open, <c>false</c> otherwise.
+        /// </returns>
+        inline bool is_open(void) const {
+            return this->_file.is_open();
+        }
+
+        /// <summary>
+        /// Registers the name of a marker.
+        /// </summary>
+        /// <param name="id">The ID of the marker.</param>
+        /// <param name="name">The name of the marker.</param>
+        void marker(_In_ const std::uint32_t id, _In_z_ const wchar_t *name);
+
+        /// <summary>
+        /// Ends the slice of the current marker and starts the slice of the
+        /// given one.
+        /// </summary>
+        /// <param name="timestamp">The time when the marker has been set.
+        /// </param>
+        /// <param name="id">The ID of the marker, which is zero if the
+        /// marker has been cleared.</param>
+        void marker_event(_In_ const measurement::timestamp_type timestamp,
+            _In_ const std::uint32_t id);
+
+        /// <summary>
+        /// Creates the given file, replacing any existing content.
+        /// </summary>
+        /// <param name="path">The path to the output file.</param>
+        /// <param name="format">The format of the trace, which must be
+        /// <see cref="output_format::perfetto" /> or
+        /// <see cref="output_format::chrome_trace" />.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="path" /> is <c>nullptr</c> or if
+        /// <paramref name="format" /> is not a trace format.</exception>
+        /// <exception cref="std::ios_base::failure">If the file could not be
+        /// opened.</exception>
+        void open(_In_z_ const wchar_t *path,
+            _In_ const output_format format);
+
+        /// <summary>
+        /// Writes a sample to the counter tracks of its sensor.
+        /// </summary>
+        /// <remarks>
+        /// The marker is not written with the sample, because it is already
+        /// represented by the slices on the track of the markers.
+        /// </remarks>
+        /// <param name="sample">The sample to be written.</param>
+        /// <param name="marker">The ID of the marker active for the sample.
+        /// </param>
+        void push(_In_ const measurement& sample,
+            _In_ const std::uint32_t marker);
+
+        trace_output_writer& operator =(const trace_output_writer&) = delete;
+
+    private:
+
+        /// <summary>
+        /// The offsets of the tracks of a sensor from the UUID of its power
+        /// track.
+        /// </summary>
+        enum class quantity : std::uint64_t {
+            power = 0,
+            voltage = 1,
+            current = 2,
+            mean = 3,
+            count = 4
+        };
+
+        /// <summary>
+        /// The tracks of a sensor.
+        /// </summary>
+        struct track_set {
+            bool declared[static_cast<std::size_t>(quantity::count)];
+            std::string name;
+            std::uint64_t uuid;
+        };
+
+        static void bytes(_Inout_ std::string& dst,
+            _In_ const std::uint32_t field, _In_ const std::string& value);
+
+        static void fixed64(_Inout_ std::string& dst,
+            _In_ const std::uint32_t field, _In_ const double value);
+
+        static void varint(_Inout_ std::string& dst,
+            _In_ const std::uint64_t value);
+
+        static void varint(_Inout_ std::string& dst,
+            _In_ const std::uint32_t field, _In_ const std::uint64_t value);
+
+        void counter(_In_ track_set& tracks, _In_ const quantity what,
+            _In_ const measurement::timestamp_type timestamp,
+            _In_ const measurement::value_type value);
+
+        void declare(_In_ track_set& tracks, _In_ const quantity what);
+
+        void slice(_In_ const measurement::timestamp_type timestamp,
+            _In_ const std::uint32_t id, _In_ const bool begin);
+
+        std::int64_t time(_In_ const measurement::timestamp_type timestamp)
+            const noexcept;
+
+        track_set& tracks(_In_opt_z_ const wchar_t *name);
+
+        track_set& tracks(_In_ const std::wstring& name);
+
+        void write(_In_ const std::string& data);
+
+        std::string _buffer;
+        measurement::timestamp_type _end;
+        std::int64_t _epoch;
+        std::string _event;
+        std::filebuf _file;
+        output_format _format;
+        bool _have_event;
+        const wchar_t *_last_sensor;
+        track_set *_last_tracks;
+        std::unordered_map<std::uint32_t, std::pair<std::string, bool>>
+            _markers;
+        std::uint64_t _next_track;
+        std::int64_t _ns_per_tick;
+        std::uint32_t _open_marker;
+        std::string _packet;
+        std::unordered_map<const wchar_t *, track_set *> _sensors;
+        std::unordered_map<std::wstring, track_set> _tracks;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
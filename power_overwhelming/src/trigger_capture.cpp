@@ -0,0 +1,134 @@
+﻿// <copyright file="trigger_capture.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "trigger_capture.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+
+/*
+ * visus::power_overwhelming::detail::trigger_capture::trigger_capture
+ */
+visus::power_overwhelming::detail::trigger_capture::trigger_capture(void)
+    : _begin(1), _capacity(0), _count(0), _end(0), _head(0), _post(0),
+        _pre(0), _threshold(0.0f) { }
+
+
+/*
+ * visus::power_overwhelming::detail::trigger_capture::configure
+ */
+void visus::power_overwhelming::detail::trigger_capture::configure(
+        _In_ const measurement::timestamp_type pre,
+        _In_ const measurement::timestamp_type post,
+        _In_ const measurement::value_type threshold,
+        _In_ const std::size_t capacity) {
+    if ((pre < 0) || (post < 0)) {
+        throw std::invalid_argument("The capture windows must not be "
+            "negative.");
+    }
+
+    // An empty window is marked by its begin being after its end.
+    this->_begin = 1;
+    this->_capacity = capacity;
+    this->_count = 0;
+    this->_end = 0;
+    this->_head = 0;
+    this->_post = post;
+    this->_pre = pre;
+    this->_ring.clear();
+    this->_ring.reserve(capacity);
+    this->_threshold = threshold;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::trigger_capture::push
+ */
+void visus::power_overwhelming::detail::trigger_capture::push(
+        _In_ const measurement& sample,
+        _In_ const std::uint32_t marker,
+        _Inout_ std::vector<sample_type>& dst) {
+    if (!this->enabled()) {
+        dst.emplace_back(sample, marker);
+        return;
+    }
+
+    const auto timestamp = sample.timestamp();
+
+    // Only samples extending the window raise a trigger, which prevents
+    // sustained power above the threshold from scanning the ring each time.
+    if ((this->_threshold > 0.0f) && sample
+            && (sample.power() >= this->_threshold)
+            && (timestamp + this->_post > this->_end)) {
+        this->trigger(timestamp, dst);
+    }
+
+    if ((timestamp >= this->_begin) && (timestamp <= this->_end)) {
+        dst.emplace_back(sample, marker);
+        return;
+    }
+
+    if (this->_count < this->_ring.size()) {
+        this->at(this->_count++) = sample_type(sample, marker);
+
+    } else if (this->_ring.size() < this->_capacity) {
+        // The ring is still growing, so the logical end must be the physical
+        // one before we can append.
+        std::rotate(this->_ring.begin(), this->_ring.begin() + this->_head,
+            this->_ring.end());
+        this->_head = 0;
+        this->_ring.emplace_back(sample, marker);
+        ++this->_count;
+
+    } else {
+        // The ring is full, so the new sample replaces the oldest one.
+        assert(this->_count == this->_capacity);
+        this->at(0) = sample_type(sample, marker);
+        this->_head = (this->_head + 1) % this->_ring.size();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::trigger_capture::trigger
+ */
+void visus::power_overwhelming::detail::trigger_capture::trigger(
+        _In_ const measurement::timestamp_type timestamp,
+        _Inout_ std::vector<sample_type>& dst) {
+    if (!this->enabled()) {
+        return;
+    }
+
+    const auto begin = timestamp - this->_pre;
+    const auto end = timestamp + this->_post;
+
+    if ((this->_begin > this->_end) || (begin > this->_end)) {
+        this->_begin = begin;
+    } else {
+        this->_begin = (std::min)(this->_begin, begin);
+    }
+    this->_end = (std::max)(this->_end, end);
+
+    // Release the retained samples in the window and compact the ring to the
+    // ones that might belong to a later window.
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < this->_count; ++i) {
+        auto& s = this->at(i);
+        const auto t = s.first.timestamp();
+
+        if ((t >= this->_begin) && (t <= this->_end)) {
+            dst.push_back(s);
+        } else if (t > this->_end) {
+            if (kept != i) {
+                this->at(kept) = std::move(s);
+            }
+            ++kept;
+        }
+    }
+
+    this->_count = kept;
+}
@@ -0,0 +1,128 @@
+﻿// <copyright file="trigger_capture.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <utility>
+#include <vector>
+
+#include "power_overwhelming/measurement.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Retains samples in a ring of fixed size and only releases the ones in
+    /// a window around a trigger.
+    /// </summary>
+    /// <remarks>
+    /// <para>A trigger at time <c>t</c> opens the window from
+    /// <c>t - pre</c> to <c>t + post</c>. All retained samples in this window
+    /// are released immediately, and samples pushed later are released
+    /// directly as long as they are in the window. Retained samples older
+    /// than the window are discarded, whereas younger ones are kept for the
+    /// next trigger, because samples are not ordered across sensors. Once
+    /// the ring is full, the oldest sample is overwritten.</para>
+    /// <para>Triggers can be raised explicitly or by a sample whose power
+    /// reaches the threshold. Triggers with overlapping windows extend the
+    /// window that is already open.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API trigger_capture final {
+
+    public:
+
+        /// <summary>
+        /// A sample along with the ID of the marker active for it.
+        /// </summary>
+        typedef std::pair<measurement, std::uint32_t> sample_type;
+
+        /// <summary>
+        /// Initialises a new instance, which is disabled.
+        /// </summary>
+        trigger_capture(void);
+
+        /// <summary>
+        /// Answer the number of samples the ring can hold.
+        /// </summary>
+        /// <returns>The capacity of the ring, which is zero if the capture is
+        /// disabled.</returns>
+        inline std::size_t capacity(void) const noexcept {
+            return this->_capacity;
+        }
+
+        /// <summary>
+        /// Configures the windows and clears the ring.
+        /// </summary>
+        /// <param name="pre">The length of the window before a trigger in
+        /// ticks of the timestamps.</param>
+        /// <param name="post">The length of the window after a trigger in
+        /// ticks of the timestamps.</param>
+        /// <param name="threshold">The power in Watts that triggers a
+        /// capture if reached by a sample. Zero or less disables the
+        /// threshold.</param>
+        /// <param name="capacity">The number of samples the ring can hold.
+        /// Zero disables the capture, i.e. all samples are released.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="pre" /> or <paramref name="post" /> is negative.
+        /// </exception>
+        void configure(_In_ const measurement::timestamp_type pre,
+            _In_ const measurement::timestamp_type post,
+            _In_ const measurement::value_type threshold,
+            _In_ const std::size_t capacity);
+
+        /// <summary>
+        /// Answer whether the samples are captured around triggers.
+        /// </summary>
+        /// <returns><c>true</c> if the capture is enabled, <c>false</c> if
+        /// all samples are released.</returns>
+        inline bool enabled(void) const noexcept {
+            return (this->_capacity > 0);
+        }
+
+        /// <summary>
+        /// Adds a sample.
+        /// </summary>
+        /// <param name="sample">The sample to be added.</param>
+        /// <param name="marker">The ID of the marker active for the sample.
+        /// </param>
+        /// <param name="dst">Receives the samples released, which are
+        /// appended. This might include <paramref name="sample" /> and
+        /// retained samples if the sample triggered the capture.</param>
+        void push(_In_ const measurement& sample,
+            _In_ const std::uint32_t marker,
+            _Inout_ std::vector<sample_type>& dst);
+
+        /// <summary>
+        /// Raises a trigger at the given time.
+        /// </summary>
+        /// <param name="timestamp">The time of the trigger.</param>
+        /// <param name="dst">Receives the retained samples in the window of
+        /// the trigger, which are appended.</param>
+        void trigger(_In_ const measurement::timestamp_type timestamp,
+            _Inout_ std::vector<sample_type>& dst);
+
+    private:
+
+        inline sample_type& at(_In_ const std::size_t i) noexcept {
+            return this->_ring[(this->_head + i) % this->_ring.size()];
+        }
+
+        measurement::timestamp_type _begin;
+        std::size_t _capacity;
+        std::size_t _count;
+        measurement::timestamp_type _end;
+        std::size_t _head;
+        measurement::timestamp_type _post;
+        measurement::timestamp_type _pre;
+        std::vector<sample_type> _ring;
+        measurement::value_type _threshold;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,242 @@
+﻿// <copyright file="tsc_clock.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "tsc_clock.h"
+
+#include <atomic>
+#include <thread>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) \
+    || defined(__i386__)
+#define POWER_OVERWHELMING_HAVE_TSC
+#endif /* defined(_M_X64) || ... */
+
+#if defined(POWER_OVERWHELMING_HAVE_TSC)
+#if defined(_WIN32)
+#include <intrin.h>
+#else /* defined(_WIN32) */
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif /* defined(_WIN32) */
+#endif /* defined(POWER_OVERWHELMING_HAVE_TSC) */
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The mapping from the time stamp counter to the system clock, which is
+    /// published via a sequence lock such that readers never block.
+    /// </summary>
+    struct tsc_calibration final {
+        std::atomic<tsc_clock::counter_type> counter;
+        std::atomic<tsc_clock::counter_type> period;
+        std::atomic<double> scale;
+        std::atomic<std::uint32_t> sequence;
+        std::atomic<tsc_clock::rep> time;
+        std::atomic_flag updating;
+
+        tsc_calibration(void) : counter(0), period(0), scale(0.0),
+            sequence(0), time(0), updating(ATOMIC_FLAG_INIT) { }
+    };
+
+    /// <summary>
+    /// Answer whether the CPU has an invariant time stamp counter.
+    /// </summary>
+    static bool has_invariant_tsc(void) noexcept {
+#if defined(POWER_OVERWHELMING_HAVE_TSC)
+        // The invariant TSC is reported in bit 8 of EDX of the extended leaf
+        // 0x80000007 by Intel and AMD alike.
+#if defined(_WIN32)
+        int info[4];
+        ::__cpuid(info, 0x80000000);
+        if (static_cast<unsigned int>(info[0]) < 0x80000007) {
+            return false;
+        }
+
+        ::__cpuid(info, 0x80000007);
+        return ((info[3] & (1 << 8)) != 0);
+#else /* defined(_WIN32) */
+        unsigned int eax, ebx, ecx, edx;
+        if (!::__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+            return false;
+        }
+
+        return ((edx & (1 << 8)) != 0);
+#endif /* defined(_WIN32) */
+#else /* defined(POWER_OVERWHELMING_HAVE_TSC) */
+        return false;
+#endif /* defined(POWER_OVERWHELMING_HAVE_TSC) */
+    }
+
+    /// <summary>
+    /// Reads the time stamp counter unconditionally.
+    /// </summary>
+    inline tsc_clock::counter_type read_tsc(void) noexcept {
+#if defined(POWER_OVERWHELMING_HAVE_TSC)
+        return ::__rdtsc();
+#else /* defined(POWER_OVERWHELMING_HAVE_TSC) */
+        return 0;
+#endif /* defined(POWER_OVERWHELMING_HAVE_TSC) */
+    }
+
+    /// <summary>
+    /// Reads the counter and the system clock at the same time, which is
+    /// approximated by the middle of two reads of the counter around the
+    /// query of the system clock.
+    /// </summary>
+    static void read_pair(tsc_clock::counter_type& counter,
+            tsc_clock::rep& time) noexcept {
+        const auto before = read_tsc();
+        time = std::chrono::system_clock::now().time_since_epoch().count();
+        const auto after = read_tsc();
+        counter = before + (after - before) / 2;
+    }
+
+    /// <summary>
+    /// Publishes a new mapping.
+    /// </summary>
+    static void publish(tsc_calibration& cal,
+            const tsc_clock::counter_type counter,
+            const tsc_clock::rep time,
+            const double scale) noexcept {
+        cal.sequence.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        cal.counter.store(counter, std::memory_order_relaxed);
+        cal.time.store(time, std::memory_order_relaxed);
+        cal.scale.store(scale, std::memory_order_relaxed);
+        cal.period.store(static_cast<tsc_clock::counter_type>(
+            tsc_clock::calibration_period / 1000.0 * tsc_clock::period::den
+            / tsc_clock::period::num / scale), std::memory_order_relaxed);
+        cal.sequence.fetch_add(1, std::memory_order_release);
+    }
+
+    /// <summary>
+    /// Answer the calibration, which is measured on first use.
+    /// </summary>
+    static tsc_calibration& get_calibration(void) noexcept {
+        static tsc_calibration retval;
+        static const bool initialised = [](void) {
+            tsc_clock::counter_type c0, c1;
+            tsc_clock::rep t0, t1;
+
+            read_pair(c0, t0);
+            std::this_thread::sleep_for(std::chrono::milliseconds(
+                tsc_clock::initial_calibration));
+            read_pair(c1, t1);
+
+            const auto scale = (c1 > c0)
+                ? static_cast<double>(t1 - t0) / static_cast<double>(c1 - c0)
+                : 0.0;
+            publish(retval, c1, t1, scale);
+            return true;
+        }();
+        (void) initialised;
+        return retval;
+    }
+
+    /// <summary>
+    /// Updates the mapping from the last calibration to now.
+    /// </summary>
+    static void recalibrate(tsc_calibration& cal) noexcept {
+        if (cal.updating.test_and_set(std::memory_order_acquire)) {
+            // Another thread is already calibrating.
+            return;
+        }
+
+        tsc_clock::counter_type counter;
+        tsc_clock::rep time;
+        read_pair(counter, time);
+
+        // Only the calibrating thread writes, so the relaxed reads are safe.
+        const auto prev_counter = cal.counter.load(std::memory_order_relaxed);
+        const auto prev_time = cal.time.load(std::memory_order_relaxed);
+        if ((counter > prev_counter) && (time > prev_time)) {
+            const auto scale = static_cast<double>(time - prev_time)
+                / static_cast<double>(counter - prev_counter);
+            publish(cal, counter, time, scale);
+        } else {
+            // The system clock has been set back, so we restart from the
+            // current time with the rate we know.
+            publish(cal, counter, time, cal.scale.load(
+                std::memory_order_relaxed));
+        }
+
+        cal.updating.clear(std::memory_order_release);
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::tsc_clock::available
+ */
+bool visus::power_overwhelming::detail::tsc_clock::available(void) noexcept {
+    static const auto retval = has_invariant_tsc();
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::tsc_clock::counter
+ */
+visus::power_overwhelming::detail::tsc_clock::counter_type
+visus::power_overwhelming::detail::tsc_clock::counter(void) noexcept {
+    return available() ? read_tsc() : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::tsc_clock::now
+ */
+visus::power_overwhelming::detail::tsc_clock::time_point
+visus::power_overwhelming::detail::tsc_clock::now(void) noexcept {
+    return available()
+        ? to_time_point(read_tsc())
+        : std::chrono::system_clock::now();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::tsc_clock::to_time_point
+ */
+visus::power_overwhelming::detail::tsc_clock::time_point
+visus::power_overwhelming::detail::tsc_clock::to_time_point(
+        _In_ const counter_type counter) noexcept {
+    if (!available()) {
+        return std::chrono::system_clock::now();
+    }
+
+    auto& cal = get_calibration();
+    counter_type origin, period;
+    double scale;
+    rep time;
+
+    {
+        std::uint32_t sequence;
+        do {
+            sequence = cal.sequence.load(std::memory_order_acquire);
+            origin = cal.counter.load(std::memory_order_relaxed);
+            period = cal.period.load(std::memory_order_relaxed);
+            scale = cal.scale.load(std::memory_order_relaxed);
+            time = cal.time.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while (((sequence & 1) != 0)
+            || (sequence != cal.sequence.load(std::memory_order_relaxed)));
+    }
+
+    if ((counter > origin) && (counter - origin > period)) {
+        recalibrate(cal);
+    }
+
+    // Counters from before the calibration are extrapolated backwards.
+    const auto delta = (counter >= origin)
+        ? static_cast<double>(counter - origin)
+        : -static_cast<double>(origin - counter);
+    return time_point(duration(time + static_cast<rep>(delta * scale)));
+}
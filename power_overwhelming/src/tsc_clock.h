@@ -0,0 +1,131 @@
+﻿// <copyright file="tsc_clock.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <chrono>
+#include <cinttypes>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A clock that derives the time of the system clock from the time stamp
+    /// counter of the CPU.
+    /// </summary>
+    /// <remarks>
+    /// <para>Reading the time stamp counter is considerably cheaper than
+    /// querying the system clock, which matters for samplers that stamp many
+    /// channels per tick. The counter is only used if the CPU reports an
+    /// invariant time stamp counter, which ticks at a constant rate and is
+    /// synchronised between all cores. Otherwise, the clock falls back to
+    /// <c>std::chrono::system_clock</c>.</para>
+    /// <para>The rate of the counter is measured when the clock is used for
+    /// the first time, which blocks the caller for
+    /// <see cref="initial_calibration" /> milliseconds. Afterwards, the
+    /// mapping from the counter to the system clock is recalibrated whenever
+    /// it is older than <see cref="calibration_period" /> milliseconds. The
+    /// thread that notices this first performs the calibration, which costs
+    /// a single query of the system clock, while all other threads continue
+    /// to use the previous mapping. Therefore, the clock follows adjustments
+    /// of the system clock with a delay of at most one period.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API tsc_clock final {
+
+    public:
+
+        /// <summary>
+        /// The type of the raw value of the time stamp counter.
+        /// </summary>
+        typedef std::uint64_t counter_type;
+
+        /// <summary>
+        /// The duration type of the clock, which is the one of the system
+        /// clock.
+        /// </summary>
+        typedef std::chrono::system_clock::duration duration;
+
+        /// <summary>
+        /// The period of the clock.
+        /// </summary>
+        typedef duration::period period;
+
+        /// <summary>
+        /// The type of the ticks of the clock.
+        /// </summary>
+        typedef duration::rep rep;
+
+        /// <summary>
+        /// The type of a point in time, which is the one of the system clock
+        /// such that the results can be used wherever the time of the system
+        /// clock is expected.
+        /// </summary>
+        typedef std::chrono::system_clock::time_point time_point;
+
+        /// <summary>
+        /// The interval in milliseconds after which the mapping from the
+        /// counter to the system clock is recalibrated.
+        /// </summary>
+        static constexpr unsigned int calibration_period = 1000;
+
+        /// <summary>
+        /// The time in milliseconds over which the rate of the counter is
+        /// measured when the clock is used for the first time.
+        /// </summary>
+        static constexpr unsigned int initial_calibration = 20;
+
+        /// <summary>
+        /// Indicates that the clock is not monotonic, because it follows the
+        /// system clock.
+        /// </summary>
+        static constexpr bool is_steady = false;
+
+        /// <summary>
+        /// Answer whether the clock uses the time stamp counter.
+        /// </summary>
+        /// <returns><c>true</c> if the CPU has an invariant time stamp
+        /// counter, <c>false</c> if the clock falls back to the system clock.
+        /// </returns>
+        static bool available(void) noexcept;
+
+        /// <summary>
+        /// Reads the time stamp counter.
+        /// </summary>
+        /// <remarks>
+        /// Samplers can read the counter once per tick and convert it using
+        /// <see cref="to_time_point" /> only if the time is actually needed.
+        /// </remarks>
+        /// <returns>The current value of the counter, or zero if the clock is
+        /// not <see cref="available" />.</returns>
+        static counter_type counter(void) noexcept;
+
+        /// <summary>
+        /// Answer the current time.
+        /// </summary>
+        /// <returns>The current time of the system clock.</returns>
+        static time_point now(void) noexcept;
+
+        /// <summary>
+        /// Converts a value of the time stamp counter to the time of the
+        /// system clock.
+        /// </summary>
+        /// <param name="counter">A value obtained from
+        /// <see cref="counter" />.</param>
+        /// <returns>The time of the system clock at which the counter had the
+        /// given value. If the clock is not <see cref="available" />, this is
+        /// the current time.</returns>
+        static time_point to_time_point(_In_ const counter_type counter)
+            noexcept;
+
+        tsc_clock(void) = delete;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
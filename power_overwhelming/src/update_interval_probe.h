@@ -0,0 +1,99 @@
+﻿// <copyright file="update_interval_probe.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The number of updates <see cref="probe_update_interval" /> observes by
+    /// default.
+    /// </summary>
+    constexpr std::size_t default_probe_updates = 8;
+
+    /// <summary>
+    /// The time <see cref="probe_update_interval" /> waits for updates by
+    /// default.
+    /// </summary>
+    constexpr std::chrono::milliseconds default_probe_timeout(1000);
+
+    /// <summary>
+    /// Empirically determines the interval at which a source updates its
+    /// data.
+    /// </summary>
+    /// <remarks>
+    /// <para>The function polls <paramref name="read" /> as fast as possible
+    /// and records when the value it returns changes. The first change
+    /// synchronises the probe with the updates of the source, after which the
+    /// times between <paramref name="updates" /> changes are measured. The
+    /// result is the median of these times, which is robust against values
+    /// that did not change on an update and against the thread being
+    /// preempted.</para>
+    /// <para>The value returned by <paramref name="read" /> should change on
+    /// each update, so a timestamp of the source is preferable over a
+    /// measured value if available.</para>
+    /// </remarks>
+    /// <typeparam name="TRead">A functor without parameters that returns an
+    /// equality-comparable representation of the current data.</typeparam>
+    /// <param name="read">The functor reading the source.</param>
+    /// <param name="updates">The number of update intervals to measure.
+    /// </param>
+    /// <param name="timeout">The time after which the probe gives up if the
+    /// source has not been updated often enough.</param>
+    /// <returns>The update interval, or zero if the source has not been
+    /// updated <paramref name="updates" /> times before the
+    /// <paramref name="timeout" />.</returns>
+    template<class TRead>
+    std::chrono::microseconds probe_update_interval(_In_ TRead&& read,
+            _In_ const std::size_t updates = default_probe_updates,
+            _In_ const std::chrono::milliseconds timeout
+            = default_probe_timeout) {
+        typedef std::chrono::steady_clock clock_type;
+        const auto deadline = clock_type::now() + timeout;
+        std::vector<clock_type::duration> intervals;
+        intervals.reserve(updates);
+
+        auto previous = read();
+        auto last_update = clock_type::time_point();
+        auto synchronised = false;
+
+        while ((intervals.size() < updates) && (clock_type::now() < deadline)) {
+            auto current = read();
+            if (current == previous) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            const auto now = clock_type::now();
+            if (synchronised) {
+                intervals.push_back(now - last_update);
+            }
+
+            last_update = now;
+            previous = std::move(current);
+            synchronised = true;
+        }
+
+        if ((updates == 0) || (intervals.size() < updates)) {
+            return std::chrono::microseconds::zero();
+        }
+
+        const auto median = intervals.begin() + intervals.size() / 2;
+        std::nth_element(intervals.begin(), median, intervals.end());
+        return std::chrono::duration_cast<std::chrono::microseconds>(*median);
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
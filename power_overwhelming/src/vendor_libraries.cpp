@@ -0,0 +1,64 @@
+﻿// <copyright file="vendor_libraries.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/vendor_libraries.h"
+
+#include <thread>
+
+#include "adl_scope.h"
+#include "library_thread.h"
+#include "nvml_scope.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+#if defined(POWER_OVERWHELMING_PRELOAD_VENDOR_LIBRARIES)
+    /// <summary>
+    /// Starts <see cref="preload_vendor_libraries" /> when the library is
+    /// loaded.
+    /// </summary>
+    static const struct vendor_library_preloader final {
+        inline vendor_library_preloader(void) noexcept {
+            preload_vendor_libraries();
+        }
+    } preloader;
+#endif /* defined(POWER_OVERWHELMING_PRELOAD_VENDOR_LIBRARIES) */
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::preload_vendor_libraries
+ */
+void visus::power_overwhelming::preload_vendor_libraries(void) noexcept {
+    try {
+        std::thread([](void) {
+            detail::enter_library_thread("PwrOwg Preload Thread");
+
+            // The first scope of each library keeps it initialised for the
+            // process, so the scopes can go away immediately.
+            try {
+                detail::nvml_scope scope;
+            } catch (...) { }
+
+            try {
+                detail::adl_scope scope;
+            } catch (...) { }
+        }).detach();
+    } catch (...) { }
+}
+
+
+/*
+ * visus::power_overwhelming::release_vendor_libraries
+ */
+void visus::power_overwhelming::release_vendor_libraries(void) noexcept {
+    detail::nvml_scope::release();
+    detail::adl_scope::release();
+}
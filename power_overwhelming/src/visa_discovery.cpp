@@ -0,0 +1,288 @@
+﻿// <copyright file="visa_discovery.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "visa_discovery.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+#include <nlohmann/json.hpp>
+
+#include "power_overwhelming/convert_string.h"
+
+#include "visa_exception.h"
+#include "visa_library.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    static constexpr const char *field_identity = "identity";
+    static constexpr const char *field_time = "time";
+
+    /// <summary>
+    /// Finds the resources matching <paramref name="query" />, which is not
+    /// an error if there are none.
+    /// </summary>
+    static std::vector<std::string> find_optional_resources(
+            _In_z_ const char *query) {
+        try {
+            return visa_library::instance().find_resource(query);
+        } catch (visa_exception& ex) {
+#if defined(POWER_OVERWHELMING_WITH_VISA)
+            if (ex.code() != VI_ERROR_RSRC_NFOUND) {
+                throw;
+            }
+#endif /* defined(POWER_OVERWHELMING_WITH_VISA) */
+            return std::vector<std::string>();
+        }
+    }
+
+    /// <summary>
+    /// Opens the resource at <paramref name="path" /> and answers its
+    /// response to <c>*IDN?</c>.
+    /// </summary>
+    static std::string identify(_In_ const std::string& path,
+            _In_ const visa_instrument::timeout_type timeout) {
+        visa_instrument instrument(path.c_str(), timeout);
+        auto len = instrument.identify(static_cast<char *>(nullptr), 0);
+        std::string retval(len, '\0');
+        len = instrument.identify(&retval[0], retval.size());
+        retval.resize((len > 0) ? len - 1 : 0);
+        return retval;
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::identity_cache::default_ttl
+ */
+constexpr std::uint32_t
+visus::power_overwhelming::detail::identity_cache::default_ttl;
+
+
+/*
+ * visus::power_overwhelming::detail::identity_cache::instance
+ */
+visus::power_overwhelming::detail::identity_cache&
+visus::power_overwhelming::detail::identity_cache::instance(void) {
+    static identity_cache retval;
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::identity_cache::now
+ */
+visus::power_overwhelming::detail::identity_cache::time_type
+visus::power_overwhelming::detail::identity_cache::now(void) {
+    using namespace std::chrono;
+    return duration_cast<seconds>(system_clock::now().time_since_epoch())
+        .count();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::identity_cache::identity_cache
+ */
+visus::power_overwhelming::detail::identity_cache::identity_cache(void)
+    : _ttl(default_ttl) { }
+
+
+/*
+ * visus::power_overwhelming::detail::identity_cache::enabled
+ */
+bool visus::power_overwhelming::detail::identity_cache::enabled(void) const {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    return !this->_path.empty();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::identity_cache::load
+ */
+void visus::power_overwhelming::detail::identity_cache::load(
+        _In_opt_z_ const wchar_t *path, _In_ const std::uint32_t ttl) {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    this->_entries.clear();
+    this->_path = (path != nullptr) ? path : L"";
+    this->_ttl = ttl;
+
+    if (this->_path.empty()) {
+        return;
+    }
+
+    std::ifstream s;
+#if defined(_WIN32)
+    s.open(this->_path);
+#else /* defined(_WIN32) */
+    s.open(power_overwhelming::convert_string<char>(this->_path));
+#endif /* defined(_WIN32) */
+    if (!s.is_open()) {
+        return;
+    }
+
+    try {
+        const auto cache = nlohmann::json::parse(s);
+        for (auto& e : cache.items()) {
+            this->_entries[e.key()] = std::make_pair(
+                e.value().at(field_identity).get<std::string>(),
+                e.value().at(field_time).get<time_type>());
+        }
+    } catch (std::exception&) {
+        // A corrupt cache is discarded and overwritten on the next save.
+        this->_entries.clear();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::identity_cache::lookup
+ */
+bool visus::power_overwhelming::detail::identity_cache::lookup(
+        _Out_ std::string& identity,
+        _In_ const std::string& resource,
+        _In_ const time_type now) const {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    if (this->_path.empty()) {
+        return false;
+    }
+
+    auto it = this->_entries.find(resource);
+    if ((it == this->_entries.end())
+            || (now - it->second.second >= this->_ttl)
+            || (now < it->second.second)) {
+        return false;
+    }
+
+    identity = it->second.first;
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::identity_cache::save
+ */
+void visus::power_overwhelming::detail::identity_cache::save(
+        _In_ const time_type now) const {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    if (this->_path.empty()) {
+        return;
+    }
+
+    auto cache = nlohmann::json::object();
+    for (auto& e : this->_entries) {
+        if (now - e.second.second < this->_ttl) {
+            cache[e.first] = nlohmann::json::object({
+                { field_identity, e.second.first },
+                { field_time, e.second.second }
+            });
+        }
+    }
+
+    std::ofstream s;
+#if defined(_WIN32)
+    s.open(this->_path, std::ofstream::out | std::ofstream::trunc);
+#else /* defined(_WIN32) */
+    s.open(power_overwhelming::convert_string<char>(this->_path),
+        std::ofstream::out | std::ofstream::trunc);
+#endif /* defined(_WIN32) */
+    if (s.is_open()) {
+        s << cache.dump(4) << std::endl;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::identity_cache::store
+ */
+void visus::power_overwhelming::detail::identity_cache::store(
+        _In_ const std::string& resource,
+        _In_ const std::string& identity,
+        _In_ const time_type now) {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    if (!this->_path.empty()) {
+        this->_entries[resource] = std::make_pair(identity, now);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::find_instruments
+ */
+std::vector<std::string> visus::power_overwhelming::detail::find_instruments(
+        _In_opt_z_ const char *vendor_id,
+        _In_opt_z_ const char *product_id,
+        _In_ const std::function<bool(const std::string&)>& accept,
+        _In_ const visa_instrument::timeout_type timeout) {
+    std::vector<std::string> retval;
+
+    if ((vendor_id != nullptr) && (product_id != nullptr)) {
+        std::string query("?*::");      // Any protocol
+        query += vendor_id;
+        query += "::";
+        query += product_id;
+        query += "::?*::INSTR";         // All serial numbers.
+        retval = find_optional_resources(query.c_str());
+    }
+
+    // The paths of instruments on the network do not tell which instrument
+    // they are, so we must ask them unless we know them already.
+    auto network = find_optional_resources("TCPIP?*::INSTR");
+    network.erase(std::remove_if(network.begin(), network.end(),
+        [&retval](const std::string& n) {
+            return (std::find(retval.begin(), retval.end(), n)
+                != retval.end());
+        }), network.end());
+
+    auto& cache = identity_cache::instance();
+    const auto probe = (std::min)(timeout,
+        static_cast<visa_instrument::timeout_type>(1000));
+    const auto now = identity_cache::now();
+    std::vector<std::string> identities(network.size());
+    std::vector<std::future<std::string>> pending(network.size());
+
+    // Identify all unknown instruments at once such that the discovery
+    // takes a single round-trip rather than one per instrument.
+    for (std::size_t i = 0; i < network.size(); ++i) {
+        if (!cache.lookup(identities[i], network[i], now)) {
+            pending[i] = std::async(std::launch::async,
+                    [&network, i, probe](void) {
+                return identify(network[i], probe);
+            });
+        }
+    }
+
+    auto updated = false;
+    for (std::size_t i = 0; i < network.size(); ++i) {
+        if (pending[i].valid()) {
+            try {
+                identities[i] = pending[i].get();
+                cache.store(network[i], identities[i], now);
+                updated = true;
+            } catch (...) {
+                // The resource is not reachable or not an instrument we can
+                // talk to, so it is skipped.
+            }
+        }
+    }
+
+    if (updated) {
+        cache.save(now);
+    }
+
+    for (std::size_t i = 0; i < network.size(); ++i) {
+        if (!identities[i].empty() && accept(identities[i])) {
+            retval.push_back(network[i]);
+        }
+    }
+
+    return retval;
+}
@@ -0,0 +1,243 @@
+﻿// <copyright file="visa_discovery.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <algorithm>
+#include <cinttypes>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "power_overwhelming/visa_instrument.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A persistent cache of the responses of VISA resources to
+    /// <c>*IDN?</c>.
+    /// </summary>
+    /// <remarks>
+    /// <para>Identifying an instrument on the network requires opening a
+    /// session and a round-trip for the query, wherefore the discovery
+    /// remembers the identities of the resources in a JSON file. An entry
+    /// expires after the configured time to live, such that an instrument
+    /// that has been replaced at the same address is eventually identified
+    /// again.</para>
+    /// <para>The cache is thread-safe. It is disabled until a file has been
+    /// configured via <see cref="load" />.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API identity_cache final {
+
+    public:
+
+        /// <summary>
+        /// The type of the points in time when the entries have been stored,
+        /// which are seconds since the epoch.
+        /// </summary>
+        typedef std::int64_t time_type;
+
+        /// <summary>
+        /// The default time to live of an entry, which is one day.
+        /// </summary>
+        static constexpr std::uint32_t default_ttl = 24 * 60 * 60;
+
+        /// <summary>
+        /// Answer the cache used by the discovery of the instruments.
+        /// </summary>
+        /// <returns>The process-wide cache.</returns>
+        static identity_cache& instance(void);
+
+        /// <summary>
+        /// Answer the current time in the unit of <see cref="time_type" />.
+        /// </summary>
+        /// <returns>The current time.</returns>
+        static time_type now(void);
+
+        /// <summary>
+        /// Initialises a new, disabled instance.
+        /// </summary>
+        identity_cache(void);
+
+        identity_cache(const identity_cache&) = delete;
+
+        /// <summary>
+        /// Answer whether a file has been configured for the cache.
+        /// </summary>
+        /// <returns><c>true</c> if the cache is enabled, <c>false</c>
+        /// otherwise.</returns>
+        bool enabled(void) const;
+
+        /// <summary>
+        /// Configures the file of the cache and loads the entries in it.
+        /// </summary>
+        /// <remarks>
+        /// A file that does not exist or cannot be parsed yields an empty
+        /// cache, which is created once it is saved.
+        /// </remarks>
+        /// <param name="path">The path to the file, or <c>nullptr</c> to
+        /// disable the cache.</param>
+        /// <param name="ttl">The time in seconds an entry remains valid.
+        /// </param>
+        void load(_In_opt_z_ const wchar_t *path, _In_ const std::uint32_t ttl);
+
+        /// <summary>
+        /// Retrieves the identity of the given resource if it has not yet
+        /// expired.
+        /// </summary>
+        /// <param name="identity">Receives the identity if the method
+        /// succeeds.</param>
+        /// <param name="resource">The VISA resource path.</param>
+        /// <param name="now">The current time.</param>
+        /// <returns><c>true</c> if a valid entry was found, <c>false</c>
+        /// otherwise.</returns>
+        bool lookup(_Out_ std::string& identity,
+            _In_ const std::string& resource,
+            _In_ const time_type now) const;
+
+        /// <summary>
+        /// Writes all entries that have not yet expired to the file of the
+        /// cache.
+        /// </summary>
+        /// <remarks>
+        /// Failures are ignored, because the cache only saves time.
+        /// </remarks>
+        /// <param name="now">The current time.</param>
+        void save(_In_ const time_type now) const;
+
+        /// <summary>
+        /// Remembers the identity of the given resource.
+        /// </summary>
+        /// <param name="resource">The VISA resource path.</param>
+        /// <param name="identity">The response of the resource to
+        /// <c>*IDN?</c>.</param>
+        /// <param name="now">The current time.</param>
+        void store(_In_ const std::string& resource,
+            _In_ const std::string& identity,
+            _In_ const time_type now);
+
+        identity_cache& operator =(const identity_cache&) = delete;
+
+    private:
+
+        std::unordered_map<std::string, std::pair<std::string, time_type>>
+            _entries;
+        mutable std::mutex _lock;
+        std::wstring _path;
+        std::uint32_t _ttl;
+    };
+
+
+    /// <summary>
+    /// Finds the VISA resources of all instruments of the given type.
+    /// </summary>
+    /// <remarks>
+    /// <para>Instruments attached via USB are found by the vendor and product
+    /// IDs in their resource paths. Instruments on the network do not have
+    /// these IDs in their paths, so all of them are identified via
+    /// <c>*IDN?</c> concurrently and accepted if
+    /// <paramref name="accept" /> approves the response. Identities from the
+    /// <see cref="identity_cache" /> are used instead of querying the
+    /// instrument if they have not yet expired.</para>
+    /// <para>Resources that cannot be opened or identified within the
+    /// timeout are skipped.</para>
+    /// </remarks>
+    /// <param name="vendor_id">The USB vendor ID of the instruments. If this is
+    /// <c>nullptr</c>, only instruments on the network are searched.</param>
+    /// <param name="product_id">The USB product ID of the instruments, which
+    /// is ignored if <paramref name="vendor_id" /> is <c>nullptr</c>.</param>
+    /// <param name="accept">Answers whether the response of an instrument on
+    /// the network to <c>*IDN?</c> identifies it as one of the instruments
+    /// searched for.</param>
+    /// <param name="timeout">The timeout for opening and identifying the
+    /// instruments on the network in milliseconds.</param>
+    /// <returns>The paths of the instruments found.</returns>
+    /// <exception cref="visa_exception">If the USB instruments could not be
+    /// enumerated.</exception>
+    std::vector<std::string> find_instruments(
+        _In_opt_z_ const char *vendor_id,
+        _In_opt_z_ const char *product_id,
+        _In_ const std::function<bool(const std::string&)>& accept,
+        _In_ const visa_instrument::timeout_type timeout);
+
+    /// <summary>
+    /// Opens the given instruments concurrently using a custom factory.
+    /// </summary>
+    /// <remarks>
+    /// All instruments are opened before the first error, if any, is
+    /// rethrown, such that the caller does not wait for the remaining ones
+    /// after the failed one has been reported.
+    /// </remarks>
+    /// <typeparam name="TInstrument">The type of the sensor or instrument,
+    /// which must be move-assignable.</typeparam>
+    /// <typeparam name="TFactory">A functor creating an instrument from its
+    /// path, which is invoked concurrently.</typeparam>
+    /// <param name="dst">Receives at most <paramref name="cnt" /> instruments.
+    /// </param>
+    /// <param name="cnt">The size of <paramref name="dst" />.</param>
+    /// <param name="paths">The resource paths of the instruments.</param>
+    /// <param name="factory">The factory creating the instruments.</param>
+    template<class TInstrument, class TFactory>
+    void create_instruments(_Out_writes_opt_(cnt) TInstrument *dst,
+            _In_ const std::size_t cnt,
+            _In_ const std::vector<std::string>& paths,
+            _In_ TFactory factory) {
+        std::vector<std::future<void>> pending;
+        pending.reserve((std::min)(cnt, paths.size()));
+
+        for (std::size_t i = 0; (i < cnt) && (i < paths.size()); ++i) {
+            auto path = paths[i].c_str();
+            auto instrument = dst + i;
+            pending.push_back(std::async(std::launch::async,
+                    [instrument, path, &factory](void) {
+                *instrument = factory(path);
+            }));
+        }
+
+        for (auto& p : pending) {
+            p.wait();
+        }
+        for (auto& p : pending) {
+            p.get();
+        }
+    }
+
+    /// <summary>
+    /// Opens the given instruments concurrently.
+    /// </summary>
+    /// <remarks>
+    /// All instruments are opened before the first error, if any, is
+    /// rethrown, such that the caller does not wait for the remaining ones
+    /// after the failed one has been reported.
+    /// </remarks>
+    /// <typeparam name="TInstrument">The type of the sensor or instrument,
+    /// which must be constructible from a path and a timeout and be
+    /// move-assignable.</typeparam>
+    /// <param name="dst">Receives at most <paramref name="cnt" /> instruments.
+    /// </param>
+    /// <param name="cnt">The size of <paramref name="dst" />.</param>
+    /// <param name="paths">The resource paths of the instruments.</param>
+    /// <param name="timeout">The timeout for opening an instrument in
+    /// milliseconds.</param>
+    template<class TInstrument>
+    inline void open_instruments(_Out_writes_opt_(cnt) TInstrument *dst,
+            _In_ const std::size_t cnt,
+            _In_ const std::vector<std::string>& paths,
+            _In_ const visa_instrument::timeout_type timeout) {
+        create_instruments(dst, cnt, paths, [timeout](const char *path) {
+            return TInstrument(path, timeout);
+        });
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
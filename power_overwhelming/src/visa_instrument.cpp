@@ -19,6 +19,9 @@
 #include "power_overwhelming/convert_string.h"
 
 #include "no_visa_error_msg.h"
+#include "scpi_response.h"
+#include "timestamp.h"
+#include "visa_discovery.h"
 #include "visa_exception.h"
 #include "visa_instrument_impl.h"
 #include "visa_library.h"
@@ -31,6 +34,15 @@ constexpr const char *
 visus::power_overwhelming::visa_instrument::rohde_und_schwarz;
 
 
+/*
+ * visus::power_overwhelming::visa_instrument::cache_identities
+ */
+void visus::power_overwhelming::visa_instrument::cache_identities(
+        _In_opt_z_ const wchar_t *path, _In_ const std::uint32_t ttl) {
+    detail::identity_cache::instance().load(path, ttl);
+}
+
+
 /*
  * visus::power_overwhelming::visa_instrument::find_resources
  */
@@ -195,6 +207,11 @@ visus::power_overwhelming::visa_instrument::~visa_instrument(void) {
 const visus::power_overwhelming::visa_instrument &
 visus::power_overwhelming::visa_instrument::attribute(
         _Out_ void *dst, _In_ ViAttr name) const {
+    if (this->check_not_disposed().socket != nullptr) {
+        throw std::logic_error("Raw socket connections do not have VISA "
+            "attributes that could be retrieved.");
+    }
+
     visa_exception::throw_on_error(detail::visa_library::instance()
         .viGetAttribute(this->check_not_disposed().session, name, &dst));
     return *this;
@@ -209,6 +226,30 @@ visus::power_overwhelming::visa_instrument::attribute(
 visus::power_overwhelming::visa_instrument&
 visus::power_overwhelming::visa_instrument::attribute(_In_ ViAttr name,
         _In_ ViAttrState value) {
+    auto socket = this->check_not_disposed().socket.get();
+    if (socket != nullptr) {
+        // Emulate the attributes that are relevant for the I/O on a socket
+        // and ignore all others, which configure VISA itself.
+        switch (name) {
+            case VI_ATTR_TMO_VALUE:
+                socket->timeout(static_cast<std::uint32_t>(value));
+                break;
+
+            case VI_ATTR_TERMCHAR:
+                socket->termchar(static_cast<char>(value));
+                break;
+
+            case VI_ATTR_TERMCHAR_EN:
+                socket->termchar_enabled(value != VI_FALSE);
+                break;
+
+            default:
+                break;
+        }
+
+        return *this;
+    }
+
     visa_exception::throw_on_error(detail::visa_library::instance()
         .viSetAttribute(this->check_not_disposed().session, name, value));
     return *this;
@@ -223,8 +264,12 @@ visus::power_overwhelming::visa_instrument&
 visus::power_overwhelming::visa_instrument::buffer(
         _In_ const std::uint16_t mask, _In_ const std::uint32_t size) {
 #if defined(POWER_OVERWHELMING_WITH_VISA)
-    visa_exception::throw_on_error(detail::visa_library::instance()
-        .viSetBuf(this->check_not_disposed().session, mask, size));
+    auto& impl = this->check_not_disposed();
+    if (impl.socket == nullptr) {
+        // Raw sockets are not buffered by VISA, so this is a no-op for them.
+        visa_exception::throw_on_error(detail::visa_library::instance()
+            .viSetBuf(impl.session, mask, size));
+    }
 #endif /*defined(POWER_OVERWHELMING_WITH_VISA) */
     return *this;
 }
@@ -235,6 +280,12 @@ visus::power_overwhelming::visa_instrument::buffer(
  */
 visus::power_overwhelming::visa_instrument&
 visus::power_overwhelming::visa_instrument::clear(void) {
+    auto socket = this->check_not_disposed().socket.get();
+    if (socket != nullptr) {
+        socket->clear();
+        return *this;
+    }
+
 #if defined(POWER_OVERWHELMING_WITH_VISA)
     visa_exception::throw_on_error(detail::visa_library::instance()
         .viClear(this->check_not_disposed().session));
@@ -380,6 +431,38 @@ visus::power_overwhelming::visa_instrument::read_all(
 }
 
 
+/*
+ * visus::power_overwhelming::visa_instrument::read_async
+ */
+visus::power_overwhelming::visa_instrument&
+visus::power_overwhelming::visa_instrument::read_async(
+        _Out_writes_bytes_(cnt) byte_type *buffer,
+        _In_ const std::size_t cnt,
+        _In_ const io_completion_callback callback,
+        _In_opt_ void *context) {
+    if (buffer == nullptr) {
+        throw std::invalid_argument("The buffer to receive data from a VISA "
+            "instrument must not be null.");
+    }
+    if (callback == nullptr) {
+        throw std::invalid_argument("The callback for an asynchronous read "
+            "must not be null.");
+    }
+
+    this->check_not_disposed().read_async(buffer, cnt, callback, context);
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::visa_instrument::read_binary
+ */
+visus::power_overwhelming::blob
+visus::power_overwhelming::visa_instrument::read_binary(void) const {
+    return this->check_not_disposed().read_binary();
+}
+
+
 /*
  * visus::power_overwhelming::visa_instrument::reset
  */
@@ -443,6 +526,13 @@ visus::power_overwhelming::visa_instrument::synchronise_clock(
  * visus::power_overwhelming::visa_instrument::status
  */
 std::int32_t visus::power_overwhelming::visa_instrument::status(void) {
+    if (this->check_not_disposed().socket != nullptr) {
+        // There is no out-of-band status byte on a raw socket.
+        auto response = this->query("*STB?\n");
+        return static_cast<std::int32_t>(detail::parse_integer_response(
+            response));
+    }
+
 #if defined(POWER_OVERWHELMING_WITH_VISA)
     ViUInt16 retval;
     visa_exception::throw_on_error(detail::visa_library::instance()
@@ -479,15 +569,13 @@ int visus::power_overwhelming::visa_instrument::system_error(void) const {
     auto status = this->query(":SYST:ERR?\n");
 
     if (!status.empty()) {
-        _Analysis_assume_(status.begin() != nullptr);
-        _Analysis_assume_(status.end() != nullptr);
-        auto delimiter = std::find_if(status.begin(),
-            status.end(),
-            [](const byte_type b) { return b == ','; });
-
-        if (delimiter != status.end()) {
-            *delimiter = '\0';
-            return std::atoi(reinterpret_cast<char *>(status.begin()));
+        const char *cur = status.as<char>();
+        const auto end = cur + status.size();
+        std::int64_t retval;
+
+        if (detail::parse_integer(cur, end, retval) && (cur != end)
+                && (*cur == ',')) {
+            return static_cast<int>(retval);
         }
     }
 
@@ -527,11 +615,46 @@ visus::power_overwhelming::visa_instrument::timeout(
 #if defined(POWER_OVERWHELMING_WITH_VISA)
     return this->attribute(VI_ATTR_TMO_VALUE, timeout);
 #else /* defined(POWER_OVERWHELMING_WITH_VISA) */
+    auto socket = this->check_not_disposed().socket.get();
+    if (socket != nullptr) {
+        socket->timeout(timeout);
+    }
     return *this;
 #endif /* defined(POWER_OVERWHELMING_WITH_VISA) */
 }
 
 
+/*
+ * visus::power_overwhelming::visa_instrument::timestamped_query
+ */
+visus::power_overwhelming::blob
+visus::power_overwhelming::visa_instrument::timestamped_query(
+        _In_z_ const char *query,
+        _Out_ std::int64_t& timestamp,
+        _In_ const timestamp_resolution resolution,
+        _In_ const std::size_t buffer_size) const {
+    if (query == nullptr) {
+        throw std::invalid_argument("The query to send to the instrument must "
+            "not be null.");
+    }
+
+    auto& impl = this->check_not_disposed();
+
+    const auto request = detail::create_timestamp(
+        timestamp_resolution::hundred_nanoseconds);
+    impl.write(query);
+    auto retval = impl.read_all(buffer_size);
+    const auto response = detail::create_timestamp(
+        timestamp_resolution::hundred_nanoseconds);
+
+    impl.clock.update(request, response);
+    timestamp = detail::convert(impl.clock.answered(request, response),
+        resolution);
+
+    return retval;
+}
+
+
 /*
  * visus::power_overwhelming::visa_instrument::wait
  */
@@ -576,6 +699,29 @@ visus::power_overwhelming::visa_instrument::write_all(
 }
 
 
+/*
+ * visus::power_overwhelming::visa_instrument::write_async
+ */
+visus::power_overwhelming::visa_instrument&
+visus::power_overwhelming::visa_instrument::write_async(
+        _In_reads_bytes_(cnt) const byte_type *buffer,
+        _In_ const std::size_t cnt,
+        _In_ const io_completion_callback callback,
+        _In_opt_ void *context) {
+    if (buffer == nullptr) {
+        throw std::invalid_argument("The buffer being written to the "
+            "instrument must not be null.");
+    }
+    if (callback == nullptr) {
+        throw std::invalid_argument("The callback for an asynchronous write "
+            "must not be null.");
+    }
+
+    this->check_not_disposed().write_async(buffer, cnt, callback, context);
+    return *this;
+}
+
+
 /*
  * visus::power_overwhelming::visa_instrument::write
  */
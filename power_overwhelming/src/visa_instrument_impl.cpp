@@ -5,27 +5,101 @@
 
 #include "visa_instrument_impl.h"
 
+#include <algorithm>
+#include <cassert>
+#include <cctype>
 #include <stdexcept>
+#include <vector>
 
+#include "ieee488_block.h"
 #include "no_visa_error_msg.h"
+#include "on_exit.h"
+#include "scpi_response.h"
 #include "visa_library.h"
 #include "zero_memory.h"
 
 
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Increases the size of a buffer that receives a message of unknown
+    /// size.
+    /// </summary>
+    /// <remarks>
+    /// If the message is a definite-length block, its header tells us how
+    /// large it is, so we can grow the buffer to the final size at once.
+    /// Otherwise, we fall back to the 50% increase, which is something used
+    /// by many STL vector implementations, so it is probably a reasonable
+    /// heuristic.
+    /// </remarks>
+    static void grow_message(_Inout_ blob& buffer,
+            _In_ const std::size_t offset) {
+        static const std::size_t min_size = 1;
+        const auto hint = ieee488_block_size(buffer.as<char>(), offset);
+        if (hint > buffer.size()) {
+            buffer.grow(hint);
+        } else {
+            buffer.grow(buffer.size() + (std::max)(buffer.size() / 2,
+                min_size));
+        }
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * ...::detail::visa_instrument_impl::binary_chunk_size
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::visa_instrument_impl::binary_chunk_size;
+
+
+/*
+ * visus::power_overwhelming::detail::visa_instrument_impl::idle_lifetime
+ */
+constexpr std::chrono::seconds
+visus::power_overwhelming::detail::visa_instrument_impl::idle_lifetime;
+
+
 /*
  * visus::power_overwhelming::detail::visa_instrument_impl::create
  */
 visus::power_overwhelming::detail::visa_instrument_impl *
 visus::power_overwhelming::detail::visa_instrument_impl::create(
         _In_ const std::string& path, _In_ const std::uint32_t timeout) {
-    std::lock_guard<decltype(_lock_instruments)> l(_lock_instruments);
+    auto& registry = instances();
+    std::lock_guard<decltype(registry.lock)> l(registry.lock);
+    std::string host;
+    std::uint16_t port = 0;
     visa_instrument_impl *retval = nullptr;
 
-    auto it = _instruments.find(path);
-    if (it != _instruments.end()) {
-        // Reuse existing instrument for same connection.
+    close_idle(registry, clock_type::now());
+
+    auto it = registry.instruments.find(path);
+    if (it != registry.instruments.end()) {
+        // Reuse existing instrument for same connection, which might also be
+        // one that is currently idle.
         retval = it->second;
 
+    } else if (scpi_socket::parse(path, host, port)) {
+        // Raw sockets are opened without VISA, so they also work if the
+        // library was compiled without VISA or if it is not installed.
+        retval = new visa_instrument_impl();
+
+        try {
+            retval->socket.reset(new scpi_socket(host, port));
+        } catch (...) {
+            delete retval;
+            throw;
+        }
+
+        retval->_path = path;
+        registry.instruments[path] = retval;
+
     } else {
         // If no existing scope was found or if the previous scope has been
         // deleted, create a new one.
@@ -77,7 +151,7 @@ visus::power_overwhelming::detail::visa_instrument_impl::create(
 
         retval->_path = path;
 
-        _instruments[path] = retval;
+        registry.instruments[path] = retval;
 #else /*defined(POWER_OVERWHELMING_WITH_VISA) */
         throw std::logic_error(no_visa_error_msg);
 #endif /*defined(POWER_OVERWHELMING_WITH_VISA) */
@@ -124,6 +198,36 @@ visus::power_overwhelming::detail::visa_instrument_impl::create(
 visus::power_overwhelming::detail::visa_instrument_impl::~visa_instrument_impl(
         void) {
 #if defined(POWER_OVERWHELMING_WITH_VISA)
+    if (this->socket != nullptr) {
+        // The socket is closed by its own destructor and there is no VISA
+        // session in this case.
+        return;
+    }
+
+    if (this->_io_completion) {
+        // Abort all operations in flight. Their callbacks are invoked with
+        // VI_ERROR_ABORT, possibly synchronously, wherefore we must not hold
+        // the lock while terminating them.
+        std::vector<ViJobId> jobs;
+        {
+            std::lock_guard<decltype(this->_lock_async)> l(this->_lock_async);
+            for (auto& o : this->_async_operations) {
+                if (!o.second.completed) {
+                    jobs.push_back(o.first);
+                }
+            }
+        }
+
+        for (auto j : jobs) {
+            visa_library::instance().viTerminate(this->session, VI_NULL, j);
+        }
+
+        visa_library::instance().viDisableEvent(this->session,
+            VI_EVENT_IO_COMPLETION, VI_HNDLR);
+        visa_library::instance().viUninstallHandler(this->session,
+            VI_EVENT_IO_COMPLETION, on_io_completion, this);
+    }
+
     visa_library::instance().viClose(this->session);
     visa_library::instance().viClose(this->resource_manager);
 #endif /*defined(POWER_OVERWHELMING_WITH_VISA) */
@@ -135,7 +239,12 @@ visus::power_overwhelming::detail::visa_instrument_impl::~visa_instrument_impl(
  */
 std::string visus::power_overwhelming::detail::visa_instrument_impl::identify(
         void) const {
-#if defined(POWER_OVERWHELMING_WITH_VISA)
+#if !defined(POWER_OVERWHELMING_WITH_VISA)
+    if (this->socket == nullptr) {
+        return "";
+    }
+#endif /*!defined(POWER_OVERWHELMING_WITH_VISA) */
+
     const auto cmd = "*IDN?\n";
     this->write_all(reinterpret_cast<const byte_type *>(cmd) , ::strlen(cmd));
     auto retval = this->read_all();
@@ -150,10 +259,6 @@ std::string visus::power_overwhelming::detail::visa_instrument_impl::identify(
     }
 
     return retval.as<char>();
-
-#else/*defined(POWER_OVERWHELMING_WITH_VISA) */
-    return "";
-#endif /*defined(POWER_OVERWHELMING_WITH_VISA) */
 }
 
 
@@ -163,6 +268,10 @@ std::string visus::power_overwhelming::detail::visa_instrument_impl::identify(
 std::uint16_t
 visus::power_overwhelming::detail::visa_instrument_impl::interface_type(
         void) const {
+    if (this->socket != nullptr) {
+        return scpi_socket::interface_type;
+    }
+
 #if defined(POWER_OVERWHELMING_WITH_VISA)
     std::uint16_t retval = 0;
     visa_exception::throw_on_error(detail::visa_library::instance()
@@ -181,6 +290,10 @@ std::size_t visus::power_overwhelming::detail::visa_instrument_impl::read(
         _Out_writes_bytes_(cnt) byte_type *buffer,
         _In_ const std::size_t cnt) const {
     assert(buffer != nullptr);
+    if (this->socket != nullptr) {
+        return this->socket->read(buffer, cnt);
+    }
+
 #if defined(POWER_OVERWHELMING_WITH_VISA)
     ViUInt32 retval = 0;
     visa_exception::throw_on_error(detail::visa_library::instance()
@@ -201,9 +314,27 @@ std::size_t visus::power_overwhelming::detail::visa_instrument_impl::read(
 visus::power_overwhelming::blob
 visus::power_overwhelming::detail::visa_instrument_impl::read_all(
         _In_ const std::size_t buffer_size) const {
-#if defined(POWER_OVERWHELMING_WITH_VISA)
     static const std::size_t min_size = 1;
 
+    if (this->socket != nullptr) {
+        blob retval((std::max)(buffer_size, min_size));
+        std::size_t offset = 0;
+        auto terminated = false;
+
+        while (!terminated) {
+            offset += this->socket->read(retval.as<byte_type>(offset),
+                retval.size() - offset, &terminated);
+
+            if (!terminated) {
+                grow_message(retval, offset);
+            }
+        }
+
+        retval.truncate(offset);
+        return retval;
+    }
+
+#if defined(POWER_OVERWHELMING_WITH_VISA)
     blob retval((std::max)(buffer_size, min_size));
     ViUInt32 offset = 0;
     ViUInt32 read = 0;
@@ -219,10 +350,7 @@ visus::power_overwhelming::detail::visa_instrument_impl::read_all(
 
         if (status == VI_SUCCESS_MAX_CNT) {
             // Increase the buffer size if the message was not completely read.
-            // The 50% increase is something used by many STL vector
-            // implementations, so it is probably a reasonable heuristic.
-            retval.grow(retval.size() + (std::max)(retval.size() / 2,
-                min_size));
+            grow_message(retval, offset);
         } else {
             // Terminate in case of any error.
             visa_exception::throw_on_error(status);
@@ -238,70 +366,197 @@ visus::power_overwhelming::detail::visa_instrument_impl::read_all(
 }
 
 
+/*
+ * visus::power_overwhelming::detail::visa_instrument_impl::read_async
+ */
+void visus::power_overwhelming::detail::visa_instrument_impl::read_async(
+        _Out_writes_bytes_(cnt) byte_type *buffer,
+        _In_ const std::size_t cnt,
+        _In_ const io_completion_callback callback,
+        _In_opt_ void *context) {
+    assert(buffer != nullptr);
+    assert(callback != nullptr);
+    if (this->socket != nullptr) {
+        const auto read = this->socket->read(buffer, cnt);
+        callback(0, static_cast<std::uint32_t>(read), context);
+        return;
+    }
+
+#if defined(POWER_OVERWHELMING_WITH_VISA)
+    std::unique_lock<decltype(this->_lock_async)> l(this->_lock_async);
+    this->enable_io_completion();
+
+    ViJobId job;
+    visa_exception::throw_on_error(detail::visa_library::instance()
+        .viReadAsync(this->session,
+            buffer,
+            static_cast<ViUInt32>(cnt),
+            &job));
+
+    this->track_async(l, job, callback, context);
+#else /*defined(POWER_OVERWHELMING_WITH_VISA) */
+    throw std::logic_error(no_visa_error_msg);
+#endif /*defined(POWER_OVERWHELMING_WITH_VISA) */
+}
+
+
 /*
  * visus::power_overwhelming::detail::visa_instrument_impl::read_binary
  */
 visus::power_overwhelming::blob
 visus::power_overwhelming::detail::visa_instrument_impl::read_binary(
         void) const {
-#if defined(POWER_OVERWHELMING_WITH_VISA)
-    blob retval(16);
+    blob retval;
+    const auto size = this->read_binary(retval);
+    assert(size == retval.size());
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::visa_instrument_impl::read_binary
+ */
+std::size_t visus::power_overwhelming::detail::visa_instrument_impl::read_binary(
+        _Inout_ blob& dst) const {
+#if !defined(POWER_OVERWHELMING_WITH_VISA)
+    if (this->socket == nullptr) {
+        return 0;
+    }
+#endif /*!defined(POWER_OVERWHELMING_WITH_VISA) */
+
+    // Note: The header is at most "#9" followed by nine digits or the number of
+    // bytes in parentheses, so we can parse it on the stack without touching
+    // the buffer provided by the caller.
+    char header[24];
     std::size_t size = 0;
 
-    this->read(retval.begin(), 2);
-    if (*retval.as<char>(0) != '#') {
+    // Note: TCP might deliver fewer bytes than requested in a single read,
+    // wherefore the fixed-size parts of the header must be read completely
+    // when using a socket.
+    auto read_header = [this, &header](const std::size_t cnt) {
+        auto h = reinterpret_cast<byte_type *>(header);
+        if (this->socket != nullptr) {
+            this->socket->read_all(h, cnt);
+        } else {
+            this->read(h, cnt);
+        }
+    };
+
+    read_header(2);
+    if (header[0] != '#') {
         throw std::runtime_error("The instrument did not send the expected "
             "type of binary response.");
     }
 
-    if (*retval.as<char>(1) == '(') {
+    if (header[1] == '(') {
         // This is the "variable length" mode where the data starts with
-        // #(<number of bytes>). We need to read the input character by
-        // character until we read the closing parenthesis.
-        byte_type byte = 0;
-        bool need_more = true;
-
-        assert(size == 0);
-        while (need_more) {
-            this->read(&byte, 1);
+        // #(<number of bytes>). Instead of reading the input character by
+        // character until we find the closing parenthesis, we temporarily make
+        // the parenthesis the termination character and let VISA stop at it.
+        std::size_t cnt = 0;
+
+        if (this->socket != nullptr) {
+            const auto termchar = this->socket->termchar();
+            const auto termchar_enabled = this->socket->termchar_enabled();
+            auto restore = on_exit([this, termchar, termchar_enabled]() {
+                this->socket->termchar(termchar);
+                this->socket->termchar_enabled(termchar_enabled);
+            });
+            this->socket->termchar(')');
+            this->socket->termchar_enabled(true);
+
+            cnt = this->read(reinterpret_cast<byte_type *>(header),
+                sizeof(header));
 
-            if ((byte >= '0') && (byte <= '9')) {
-                size *= 10;
-                size += byte - '0';
+        } else {
+#if defined(POWER_OVERWHELMING_WITH_VISA)
+            auto& library = visa_library::instance();
+            ViUInt8 termchar = 0;
+            ViBoolean termchar_enabled = VI_FALSE;
+            visa_exception::throw_on_error(library.viGetAttribute(
+                this->session, VI_ATTR_TERMCHAR, &termchar));
+            visa_exception::throw_on_error(library.viGetAttribute(
+                this->session, VI_ATTR_TERMCHAR_EN, &termchar_enabled));
+
+            auto restore = on_exit([&library, this, termchar,
+                    termchar_enabled]() {
+                library.viSetAttribute(this->session, VI_ATTR_TERMCHAR,
+                    termchar);
+                library.viSetAttribute(this->session, VI_ATTR_TERMCHAR_EN,
+                    termchar_enabled);
+            });
+            visa_exception::throw_on_error(library.viSetAttribute(
+                this->session, VI_ATTR_TERMCHAR, ')'));
+            visa_exception::throw_on_error(library.viSetAttribute(
+                this->session, VI_ATTR_TERMCHAR_EN, VI_TRUE));
+
+            cnt = this->read(reinterpret_cast<byte_type *>(header),
+                sizeof(header));
+#endif /*defined(POWER_OVERWHELMING_WITH_VISA) */
+        }
 
-            } else if (byte == ')') {
-                need_more = false;
+        if ((cnt == 0) || (header[cnt - 1] != ')')) {
+            throw std::runtime_error("The variable-length header is not "
+                "terminated.");
+        }
 
-            } else {
+        assert(size == 0);
+        for (std::size_t i = 0; i < cnt - 1; ++i) {
+            if ((header[i] < '0') || (header[i] > '9')) {
                 throw std::runtime_error("The variable-length header contains "
                     "non-numeric characters.");
             }
+            size = 10 * size + (header[i] - '0');
         }
 
     } else {
         // This is the "normal length" more where the data starts with
         // #<digits><number of bytes>. In this mode, the second character
         // is the number of digits to follow (at most 9).
-        *retval.as<char>(2) = 0;
-        const auto digits = std::atoi(retval.as<char>(1));
-        retval.reserve(digits + 1);
-        this->read(retval.begin(), digits);
+        const auto digits = header[1] - '0';
+        if ((digits < 1) || (digits > 9)) {
+            throw std::runtime_error("The length header of the binary "
+                "response is invalid.");
+        }
+
+        read_header(digits);
+        for (int i = 0; i < digits; ++i) {
+            if ((header[i] < '0') || (header[i] > '9')) {
+                throw std::runtime_error("The length header contains "
+                    "non-numeric characters.");
+            }
+            size = 10 * size + (header[i] - '0');
+        }
+    }
 
-        *retval.as<char>(digits) = 0;
-        size = std::atoi(retval.as<char>());
+    // Read the data in chunks such that large files are not limited by the
+    // maximum transfer size of a single read and such that we detect if the
+    // instrument stops sending before all data have arrived. The buffer is
+    // only reallocated if it is too small.
+    dst.reserve(size);
+    if (this->socket != nullptr) {
+        // The socket receives large blocks directly into the destination,
+        // wherefore we do not need to split the data into chunks.
+        this->socket->read_all(dst.as<byte_type>(), size);
     }
 
-    retval.reserve(size);
-    this->read(retval.begin(), retval.size());
+    for (std::size_t offset = (this->socket != nullptr) ? size : 0;
+            offset < size;) {
+        const auto chunk = (std::min)(size - offset, binary_chunk_size);
+        const auto read = this->read(dst.as<byte_type>(offset), chunk);
+        if (read == 0) {
+            throw std::runtime_error("The instrument stopped sending before "
+                "the binary response was complete.");
+        }
+
+        offset += read;
+    }
 
     // Read and discard all that is still in the buffer (the "\n"). If we do not
     // do this, the next query would be interrupted.
     this->read_all();
 
-    return retval;
-#else /*defined(POWER_OVERWHELMING_WITH_VISA) */
-    return blob();
-#endif /*defined(POWER_OVERWHELMING_WITH_VISA) */
+    return size;
 }
 
 
@@ -310,19 +565,23 @@ visus::power_overwhelming::detail::visa_instrument_impl::read_binary(
  */
 std::size_t visus::power_overwhelming::detail::visa_instrument_impl::release(
         void) {
-    auto expected = this->_counter.load();
-
-    while (!this->_counter.compare_exchange_weak(expected, expected - 1));
-
-    if (expected == 1) {
-        std::lock_guard<decltype(_lock_instruments)> l(_lock_instruments);
-        _instruments.erase(this->_path);
-        delete this;
+    // Note: The counter must be modified while holding the lock of the
+    // registry. Otherwise, another thread could look up the instrument in
+    // create() while we are deciding whether it is idle.
+    auto& registry = instances();
+    std::lock_guard<decltype(registry.lock)> l(registry.lock);
+    const auto now = clock_type::now();
+    const auto retval = --this->_counter;
+
+    if (retval == 0) {
+        this->_idle_since = now;
     }
 
-    // Note: Do not use counter at this point! Only local variables are still
-    // alive after deleting the object!
-    return (expected - 1);
+    // Take the opportunity to close sessions that have not been reused in
+    // time. This does not affect the object that has just become idle.
+    close_idle(registry, now);
+
+    return retval;
 }
 
 
@@ -332,6 +591,10 @@ std::size_t visus::power_overwhelming::detail::visa_instrument_impl::release(
 std::string
 visus::power_overwhelming::detail::visa_instrument_impl::resource_class(
         void) const {
+    if (this->socket != nullptr) {
+        return "SOCKET";
+    }
+
 #if defined(POWER_OVERWHELMING_WITH_VISA)
     ViChar retval[256];
     visa_exception::throw_on_error(detail::visa_library::instance()
@@ -349,41 +612,49 @@ visus::power_overwhelming::detail::visa_instrument_impl::resource_class(
  */
 int visus::power_overwhelming::detail::visa_instrument_impl::system_error(
         _Out_ std::string& message) const {
-#if defined(POWER_OVERWHELMING_WITH_VISA)
+#if !defined(POWER_OVERWHELMING_WITH_VISA)
+    if (this->socket == nullptr) {
+        message = "";
+        return 0;
+    }
+#endif /*!defined(POWER_OVERWHELMING_WITH_VISA) */
+
     this->write(":SYST:ERR?\n");
     auto status = this->read_all();
 
-    auto delimiter = std::find_if(status.begin(), status.end(),
-        [](const byte_type b) { return b == ','; });
-
-    if ((delimiter != nullptr) && (delimiter != status.end())) {
-        *delimiter = '\0';
+    const char *cur = status.as<char>();
+    const auto end = cur + status.size();
+    std::int64_t retval;
 
+    if ((cur != nullptr) && parse_integer(cur, end, retval) && (cur != end)
+            && (*cur == ',')) {
         // Skip the delimiter itself.
-        ++delimiter;
-
-        // Trim any leading spaces and quotes.
-        for (; (delimiter != status.end()) && (std::isspace(*delimiter)
-            || (*delimiter == '"')); ++delimiter);
+        ++cur;
 
-        // Trim any trailing spaces and quotes.
-        auto end = status.rbegin();
-        for (; (end != status.rend()) && (std::isspace(*end)
-            || (*end == '"')); --end);
+        const char *begin = nullptr;
+        const char *last = nullptr;
+        message.clear();
 
-        // Skip the delimiter itself.
-        ++end;
+        if (parse_quoted(cur, end, begin, last)) {
+            append_quoted(message, begin, last);
 
-        message = std::string(delimiter, end);
+        } else {
+            // Be lenient with instruments that do not quote the message and
+            // trim any white space instead.
+            auto is_space = [](const char c) {
+                return std::isspace(static_cast<unsigned char>(c)) || (c == 0);
+            };
+            begin = cur;
+            last = end;
+            for (; (begin != last) && is_space(*begin); ++begin);
+            for (; (last != begin) && is_space(last[-1]); --last);
+            message.assign(begin, last);
+        }
 
-        return std::atoi(reinterpret_cast<char *>(status.data()));
+        return static_cast<int>(retval);
     } else {
         throw std::runtime_error("The instrument responded unexpectedly.");
     }
-#else /*defined(POWER_OVERWHELMING_WITH_VISA) */
-    message = "";
-    return 0;
-#endif /*defined(POWER_OVERWHELMING_WITH_VISA) */
 }
 
 
@@ -394,6 +665,11 @@ std::size_t visus::power_overwhelming::detail::visa_instrument_impl::write(
         _In_reads_bytes_(cnt) const byte_type *buffer,
         _In_ const std::size_t cnt) const {
     assert(buffer != nullptr);
+    if (this->socket != nullptr) {
+        this->socket->write(buffer, cnt);
+        return cnt;
+    }
+
 #if defined(POWER_OVERWHELMING_WITH_VISA)
     ViUInt32 retval = 0;
     visa_exception::throw_on_error(detail::visa_library::instance()
@@ -425,6 +701,11 @@ void visus::power_overwhelming::detail::visa_instrument_impl::write(
 void visus::power_overwhelming::detail::visa_instrument_impl::write_all(
         _In_reads_bytes_(cnt) const byte_type *buffer,
         _In_ const std::size_t cnt) const {
+    if (this->socket != nullptr) {
+        this->socket->write(buffer, cnt);
+        return;
+    }
+
 #if defined(POWER_OVERWHELMING_WITH_VISA)
     ViUInt32 last = 0;
     ViUInt32 total = 0;
@@ -442,14 +723,193 @@ void visus::power_overwhelming::detail::visa_instrument_impl::write_all(
 
 
 /*
- * visus::power_overwhelming::detail::visa_instrument_impl::_instruments
+ * visus::power_overwhelming::detail::visa_instrument_impl::write_async
  */
-std::map<std::string, visus::power_overwhelming::detail::visa_instrument_impl *>
-visus::power_overwhelming::detail::visa_instrument_impl::_instruments;
+void visus::power_overwhelming::detail::visa_instrument_impl::write_async(
+        _In_reads_bytes_(cnt) const byte_type *buffer,
+        _In_ const std::size_t cnt,
+        _In_ const io_completion_callback callback,
+        _In_opt_ void *context) {
+    assert(buffer != nullptr);
+    assert(callback != nullptr);
+    if (this->socket != nullptr) {
+        this->socket->write(buffer, cnt);
+        callback(0, static_cast<std::uint32_t>(cnt), context);
+        return;
+    }
+
+#if defined(POWER_OVERWHELMING_WITH_VISA)
+    std::unique_lock<decltype(this->_lock_async)> l(this->_lock_async);
+    this->enable_io_completion();
+
+    ViJobId job;
+    visa_exception::throw_on_error(detail::visa_library::instance()
+        .viWriteAsync(this->session,
+            buffer,
+            static_cast<ViUInt32>(cnt),
+            &job));
+
+    this->track_async(l, job, callback, context);
+#else /*defined(POWER_OVERWHELMING_WITH_VISA) */
+    throw std::logic_error(no_visa_error_msg);
+#endif /*defined(POWER_OVERWHELMING_WITH_VISA) */
+}
 
 
 /*
- * visus::power_overwhelming::detail::visa_instrument_impl::_lock_instruments
+ * visus::power_overwhelming::detail::visa_instrument_impl::close_idle
  */
-std::mutex
-visus::power_overwhelming::detail::visa_instrument_impl::_lock_instruments;
+void visus::power_overwhelming::detail::visa_instrument_impl::close_idle(
+        _In_ registry& registry, _In_ const clock_type::time_point now) {
+    auto it = registry.instruments.begin();
+    while (it != registry.instruments.end()) {
+        auto instrument = it->second;
+        if ((instrument->_counter == 0)
+                && (now - instrument->_idle_since > idle_lifetime)) {
+            it = registry.instruments.erase(it);
+            delete instrument;
+        } else {
+            ++it;
+        }
+    }
+}
+
+
+#if defined(POWER_OVERWHELMING_WITH_VISA)
+/*
+ * ...::detail::visa_instrument_impl::enable_io_completion
+ */
+void
+visus::power_overwhelming::detail::visa_instrument_impl::enable_io_completion(
+        void) {
+    if (!this->_io_completion) {
+        visa_exception::throw_on_error(visa_library::instance()
+            .viInstallHandler(this->session, VI_EVENT_IO_COMPLETION,
+                on_io_completion, this));
+
+        auto status = visa_library::instance().viEnableEvent(this->session,
+            VI_EVENT_IO_COMPLETION, VI_HNDLR, VI_NULL);
+        if (status < VI_SUCCESS) {
+            visa_library::instance().viUninstallHandler(this->session,
+                VI_EVENT_IO_COMPLETION, on_io_completion, this);
+            throw visa_exception(status);
+        }
+
+        this->_io_completion = true;
+    }
+}
+#endif /*defined(POWER_OVERWHELMING_WITH_VISA) */
+
+
+/*
+ * visus::power_overwhelming::detail::visa_instrument_impl::instances
+ */
+visus::power_overwhelming::detail::visa_instrument_impl::registry&
+visus::power_overwhelming::detail::visa_instrument_impl::instances(void) {
+#if defined(POWER_OVERWHELMING_WITH_VISA)
+    // Make sure that the library is constructed before the registry. If VISA
+    // is not installed, raw sockets can still be used, so this is not fatal.
+    try {
+        visa_library::instance();
+    } catch (...) { }
+#endif /*defined(POWER_OVERWHELMING_WITH_VISA) */
+    static registry retval;
+    return retval;
+}
+
+
+#if defined(POWER_OVERWHELMING_WITH_VISA)
+/*
+ * visus::power_overwhelming::detail::visa_instrument_impl::on_io_completion
+ */
+ViStatus _VI_FUNCH
+visus::power_overwhelming::detail::visa_instrument_impl::on_io_completion(
+        _In_ ViSession session, _In_ ViEventType type, _In_ ViEvent event,
+        _In_ ViAddr context) {
+    auto that = static_cast<visa_instrument_impl *>(context);
+    ViJobId job = 0;
+    ViStatus status = VI_SUCCESS;
+    ViUInt32 count = 0;
+
+    if ((that == nullptr) || (type != VI_EVENT_IO_COMPLETION)) {
+        return VI_SUCCESS;
+    }
+
+    auto& library = visa_library::instance();
+    if (library.viGetAttribute(event, VI_ATTR_JOB_ID, &job) < VI_SUCCESS) {
+        return VI_SUCCESS;
+    }
+    library.viGetAttribute(event, VI_ATTR_STATUS, &status);
+    library.viGetAttribute(event, VI_ATTR_RET_COUNT, &count);
+
+    std::unique_lock<decltype(that->_lock_async)> l(that->_lock_async);
+    auto it = that->_async_operations.find(job);
+    if (it == that->_async_operations.end()) {
+        // The operation completed before the thread that started it could
+        // register it. Remember the result such that the callback can be
+        // invoked by track_async().
+        auto& o = that->_async_operations[job];
+        o.callback = nullptr;
+        o.context = nullptr;
+        o.completed = true;
+        o.status = status;
+        o.count = count;
+
+    } else {
+        auto operation = it->second;
+        that->_async_operations.erase(it);
+        l.unlock();
+        operation.callback(status, count, operation.context);
+    }
+
+    return VI_SUCCESS;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::visa_instrument_impl::track_async
+ */
+void visus::power_overwhelming::detail::visa_instrument_impl::track_async(
+        _In_ std::unique_lock<std::recursive_mutex>& lock,
+        _In_ const ViJobId job,
+        _In_ const io_completion_callback callback,
+        _In_opt_ void *context) {
+    assert(lock.owns_lock());
+    auto it = this->_async_operations.find(job);
+
+    if (it == this->_async_operations.end()) {
+        auto& o = this->_async_operations[job];
+        o.callback = callback;
+        o.context = context;
+        o.completed = false;
+        o.status = VI_SUCCESS;
+        o.count = 0;
+
+    } else {
+        // The completion handler ran before we could register the operation,
+        // which is typically the case if it completed synchronously.
+        const auto operation = it->second;
+        this->_async_operations.erase(it);
+        lock.unlock();
+        callback(operation.status, operation.count, context);
+    }
+}
+#endif /*defined(POWER_OVERWHELMING_WITH_VISA) */
+
+
+/*
+ * ...::detail::visa_instrument_impl::registry::~registry
+ */
+visus::power_overwhelming::detail::visa_instrument_impl::registry::~registry(
+        void) {
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    for (auto& i : this->instruments) {
+        // Instruments that are still in use are owned by the application, so
+        // we only close the ones that are waiting for being reused.
+        if (i.second->_counter == 0) {
+            delete i.second;
+        }
+    }
+
+    this->instruments.clear();
+}
@@ -6,15 +6,19 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <cinttypes>
 #include <cstdlib>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 
 #include "power_overwhelming/blob.h"
 #include "power_overwhelming/convert_string.h"
 
+#include "instrument_clock.h"
+#include "scpi_socket.h"
 #include "string_functions.h"
 #include "visa_exception.h"
 #include "visa_library.h"
@@ -28,6 +32,23 @@ namespace detail {
     /// Stores the actual VISA resources for the connection to the 
     /// instrument and provides some convenience methods.
     /// </summary>
+    /// <remarks>
+    /// <para>There is only one instance per VISA path in the process, which is
+    /// shared by all <see cref="visa_instrument" />s opened on the same path
+    /// and reference-counted.</para>
+    /// <para>Opening a session over the network is expensive, and the sensors
+    /// typically open their instruments several times in a row, for instance
+    /// for discovering the instruments and for actually creating the sensors
+    /// from the resulting configuration. Therefore, the last reference does
+    /// not close the session immediately, but the session is kept open for
+    /// <see cref="idle_lifetime" /> such that it can be reused by the next
+    /// instrument opened on the same path.</para>
+    /// <para>Resources of the form <c>TCPIP::host::port::SOCKET</c> are not
+    /// opened via VISA, but via a <see cref="scpi_socket" />, which avoids
+    /// the overhead of VISA on each call and does not require VISA to be
+    /// installed. All I/O of the instance is dispatched to the socket in
+    /// this case.</para>
+    /// </remarks>
     struct visa_instrument_impl final {
 
     public:
@@ -37,6 +58,13 @@ namespace detail {
         /// </summary>
         typedef blob::byte_type byte_type;
 
+        /// <summary>
+        /// The callback to be invoked when an asynchronous I/O operation
+        /// completed.
+        /// </summary>
+        typedef void (*io_completion_callback)(_In_ const std::int32_t status,
+            _In_ const std::size_t cnt, _In_opt_ void *context);
+
         /// <summary>
         /// Create or open the instrument at the specified path.
         /// </summary>
@@ -46,7 +74,8 @@ namespace detail {
         /// </remarks>
         /// <param name="path">The path to the device to open.</param>
         /// <param name="timeout">The timeout for establishing the connection
-        /// in milliseconds.</param>
+        /// in milliseconds. This parameter is ignored for raw sockets, which
+        /// are connected using the timeout of the operating system.</param>
         /// <returns></returns>
         static visa_instrument_impl *create(_In_ const std::string& path,
             _In_ const std::uint32_t timeout);
@@ -60,7 +89,8 @@ namespace detail {
         /// </remarks>
         /// <param name="path">The path to the device to open.</param>
         /// <param name="timeout">The timeout for establishing the connection
-        /// in milliseconds.</param>
+        /// in milliseconds. This parameter is ignored for raw sockets, which
+        /// are connected using the timeout of the operating system.</param>
         /// <returns></returns>
         static visa_instrument_impl *create(_In_z_ const wchar_t *path,
             _In_ const std::uint32_t timeout);
@@ -74,7 +104,8 @@ namespace detail {
         /// </remarks>
         /// <param name="path">The path to the device to open.</param>
         /// <param name="timeout">The timeout for establishing the connection
-        /// in milliseconds.</param>
+        /// in milliseconds. This parameter is ignored for raw sockets, which
+        /// are connected using the timeout of the operating system.</param>
         /// <returns></returns>
         static visa_instrument_impl *create(_In_z_ const char *path,
             _In_ const std::uint32_t timeout);
@@ -96,6 +127,18 @@ namespace detail {
         bool vxi;
 #endif /* defined(POWER_OVERWHELMING_WITH_VISA) */
 
+        /// <summary>
+        /// The estimate of the latency of the connection to the instrument,
+        /// which is shared by all users of the session.
+        /// </summary>
+        mutable instrument_clock clock;
+
+        /// <summary>
+        /// The raw TCP connection if the instrument has been opened via a
+        /// <c>SOCKET</c> resource, in which case there is no VISA session.
+        /// </summary>
+        std::unique_ptr<scpi_socket> socket;
+
         /// <summary>
         /// Finalises the instance.
         /// </summary>
@@ -160,6 +203,12 @@ namespace detail {
         /// <summary>
         /// Read a full response.
         /// </summary>
+        /// <remarks>
+        /// If the response is an IEEE 488.2 definite-length block, the buffer
+        /// is resized to the size announced in the header of the block once
+        /// the header has been received, so that large blocks are not copied
+        /// repeatedly while growing the buffer.
+        /// </remarks>
         /// <param name="buffer_size">The size of the read buffer being used. If
         /// this is less than the response size, the buffer will be resized
         /// until everything was read.
@@ -168,6 +217,32 @@ namespace detail {
         /// <exception cref="visa_exception">If the operation failed.</exception>
         blob read_all(_In_ const std::size_t buffer_size = 1024) const;
 
+        /// <summary>
+        /// Starts reading from the instrument into the given buffer without
+        /// waiting for the data to arrive.
+        /// </summary>
+        /// <param name="buffer">The buffer to write the data to, which must
+        /// remain valid until <paramref name="callback" /> has been invoked.
+        /// </param>
+        /// <param name="cnt">The size of the buffer in bytes.</param>
+        /// <param name="callback">The callback to be invoked once the
+        /// operation completed.</param>
+        /// <param name="context">A user-defined pointer that is passed to
+        /// <paramref name="callback" />.</param>
+        /// <remarks>
+        /// Raw sockets do not support asynchronous I/O, wherefore the read
+        /// is performed synchronously and <paramref name="callback" /> is
+        /// invoked before the method returns in this case.
+        /// </remarks>
+        /// <exception cref="visa_exception">If the operation could not be
+        /// started.</exception>
+        /// <exception cref="std::logic_error">If the library was compiled
+        /// without support for VISA.</exception>
+        void read_async(_Out_writes_bytes_(cnt) byte_type *buffer,
+            _In_ const std::size_t cnt,
+            _In_ const io_completion_callback callback,
+            _In_opt_ void *context);
+
         /// <summary>
         /// Reads a binary response starting with the # marker for the number of
         /// bytes to follow.
@@ -179,11 +254,47 @@ namespace detail {
         blob read_binary(void) const;
 
         /// <summary>
-        /// Release the reference on the object and free it if this was the last
-        /// reference.
+        /// Reads a binary response starting with the # marker for the number of
+        /// bytes to follow into an existing buffer.
+        /// </summary>
+        /// <remarks>
+        /// The buffer is only reallocated if it is too small to hold the
+        /// response, which allows for reusing the memory for large responses
+        /// like waveforms that are retrieved repeatedly. The data always start
+        /// at the begin of <paramref name="dst" />.
+        /// </remarks>
+        /// <param name="dst">The buffer to receive the data excluding the
+        /// length marker.</param>
+        /// <returns>The number of valid bytes in <paramref name="dst" />,
+        /// which might be less than its size.</returns>
+        /// <exception cref="visa_exception">If the operation failed.</exception>
+        /// <exception cref="std::runtime_error">If the data being read are not
+        /// binary.</exception>
+        std::size_t read_binary(_Inout_ blob& dst) const;
+
+        /// <summary>
+        /// The maximum number of bytes that <see cref="read_binary" />
+        /// requests from the instrument at once.
+        /// </summary>
+        static constexpr std::size_t binary_chunk_size = 64 * 1024;
+
+        /// <summary>
+        /// The time that a session is kept open after its last reference has
+        /// been released.
+        /// </summary>
+        static constexpr std::chrono::seconds idle_lifetime
+            = std::chrono::seconds(30);
+
+        /// <summary>
+        /// Release the reference on the object.
         /// </summary>
-        /// <returns>The new value of the reference counter. If this is zero,
-        /// the object has been freed.</returns>
+        /// <remarks>
+        /// If this is the last reference, the object is kept alive for
+        /// <see cref="idle_lifetime" /> such that it can be reused by
+        /// <see cref="create" />. Callers must not use the object after
+        /// releasing their reference in any case.
+        /// </remarks>
+        /// <returns>The new value of the reference counter.</returns>
         std::size_t release(void);
 
         /// <summary>
@@ -236,11 +347,136 @@ namespace detail {
         void write_all(_In_reads_bytes_(cnt) const byte_type *buffer,
             _In_ const std::size_t cnt) const;
 
+        /// <summary>
+        /// Starts writing the given data to the instrument without waiting for
+        /// the transfer to complete.
+        /// </summary>
+        /// <param name="buffer">The buffer holding the data to write, which
+        /// must remain valid until <paramref name="callback" /> has been
+        /// invoked.</param>
+        /// <param name="cnt">The size of <paramref name="buffer" /> in bytes.
+        /// </param>
+        /// <param name="callback">The callback to be invoked once the
+        /// operation completed.</param>
+        /// <param name="context">A user-defined pointer that is passed to
+        /// <paramref name="callback" />.</param>
+        /// <remarks>
+        /// Raw sockets do not support asynchronous I/O, wherefore the data
+        /// are written synchronously and <paramref name="callback" /> is
+        /// invoked before the method returns in this case. This only blocks
+        /// until the data have been copied to the send buffer of the socket.
+        /// </remarks>
+        /// <exception cref="visa_exception">If the operation could not be
+        /// started.</exception>
+        /// <exception cref="std::logic_error">If the library was compiled
+        /// without support for VISA.</exception>
+        void write_async(_In_reads_bytes_(cnt) const byte_type *buffer,
+            _In_ const std::size_t cnt,
+            _In_ const io_completion_callback callback,
+            _In_opt_ void *context);
+
     private:
 
-        static std::map<std::string, visa_instrument_impl *> _instruments;
-        static std::mutex _lock_instruments;
+#if defined(POWER_OVERWHELMING_WITH_VISA)
+        /// <summary>
+        /// The bookkeeping for an asynchronous I/O operation in flight.
+        /// </summary>
+        struct async_operation final {
+            io_completion_callback callback;
+            void *context;
+            bool completed;
+            ViStatus status;
+            ViUInt32 count;
+        };
+#endif /* defined(POWER_OVERWHELMING_WITH_VISA) */
+
+        /// <summary>
+        /// The clock used to track how long sessions have been idle.
+        /// </summary>
+        typedef std::chrono::steady_clock clock_type;
+
+        /// <summary>
+        /// The process-wide registry of all open instruments.
+        /// </summary>
+        struct registry final {
+
+            /// <summary>
+            /// The instruments by their VISA path.
+            /// </summary>
+            std::map<std::string, visa_instrument_impl *> instruments;
+
+            /// <summary>
+            /// The lock protecting <see cref="instruments" /> and the
+            /// reference counters of all instruments in it.
+            /// </summary>
+            std::mutex lock;
+
+            /// <summary>
+            /// Closes all idle sessions.
+            /// </summary>
+            ~registry(void);
+        };
+
+        /// <summary>
+        /// Closes all sessions that have been idle for longer than
+        /// <see cref="idle_lifetime" />.
+        /// </summary>
+        /// <remarks>
+        /// The caller must hold the lock of <paramref name="registry" />.
+        /// </remarks>
+        static void close_idle(_In_ registry& registry,
+            _In_ const clock_type::time_point now);
+
+        /// <summary>
+        /// Answer the registry of all instruments.
+        /// </summary>
+        /// <remarks>
+        /// The registry is created after the VISA library has been loaded,
+        /// wherefore it is destroyed, and the idle sessions are closed,
+        /// before the library is unloaded.
+        /// </remarks>
+        static registry& instances(void);
+
+#if defined(POWER_OVERWHELMING_WITH_VISA)
+        /// <summary>
+        /// The handler for <c>VI_EVENT_IO_COMPLETION</c>, which dispatches the
+        /// completion of an asynchronous operation to its callback.
+        /// </summary>
+        static ViStatus _VI_FUNCH on_io_completion(_In_ ViSession session,
+            _In_ ViEventType type, _In_ ViEvent event, _In_ ViAddr context);
+
+        /// <summary>
+        /// Installs <see cref="on_io_completion" /> on the session unless this
+        /// has already been done.
+        /// </summary>
+        /// <remarks>
+        /// The caller must hold <see cref="_lock_async" />.
+        /// </remarks>
+        void enable_io_completion(void);
+
+        /// <summary>
+        /// Registers the callback for the asynchronous operation
+        /// <paramref name="job" /> that has just been started, or invokes it
+        /// if the operation already completed while it was being started.
+        /// </summary>
+        /// <remarks>
+        /// The caller must have locked <see cref="_lock_async" /> using
+        /// <paramref name="lock" /> before starting the operation. The lock
+        /// is released before the callback is invoked.
+        /// </remarks>
+        void track_async(_In_ std::unique_lock<std::recursive_mutex>& lock,
+            _In_ const ViJobId job,
+            _In_ const io_completion_callback callback,
+            _In_opt_ void *context);
+#endif /* defined(POWER_OVERWHELMING_WITH_VISA) */
+
+#if defined(POWER_OVERWHELMING_WITH_VISA)
+        std::map<ViJobId, async_operation> _async_operations;
+        bool _io_completion;
+        std::recursive_mutex _lock_async;
+#endif /* defined(POWER_OVERWHELMING_WITH_VISA) */
         std::atomic<std::size_t> _counter;
+        clock_type::time_point _idle_since;
         std::string _path;
 
         /// <summary>
@@ -249,6 +485,7 @@ namespace detail {
         inline visa_instrument_impl(void) :
 #if defined(POWER_OVERWHELMING_WITH_VISA)
             resource_manager(0), session(0), vxi(false),
+            _io_completion(false),
 #endif /* defined(POWER_OVERWHELMING_WITH_VISA) */
             _counter(0) { }
     };
@@ -10,6 +10,14 @@
 template<class ...TArgs>
 void visus::power_overwhelming::detail::visa_instrument_impl::format(
         _In_z_ const char *format, TArgs&&... args) const {
+    if (this->socket != nullptr) {
+        const auto command = detail::format_string(format,
+            std::forward<TArgs>(args)...);
+        this->socket->write(reinterpret_cast<const byte_type *>(
+            command.data()), command.size());
+        return;
+    }
+
 #if defined(POWER_OVERWHELMING_WITH_VISA)
     visa_exception::throw_on_error(detail::visa_library::instance()
         .viPrintf(this->session, format, std::forward<TArgs>(args)...));
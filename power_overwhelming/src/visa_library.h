@@ -75,13 +75,16 @@ namespace detail {
         __POWER_OVERWHELMING_VISA_FUNC(viOpenDefaultRM);
         __POWER_OVERWHELMING_VISA_FUNC(viPrintf);
         __POWER_OVERWHELMING_VISA_FUNC(viRead);
+        __POWER_OVERWHELMING_VISA_FUNC(viReadAsync);
         __POWER_OVERWHELMING_VISA_FUNC(viReadSTB);
         __POWER_OVERWHELMING_VISA_FUNC(viSetAttribute);
         __POWER_OVERWHELMING_VISA_FUNC(viSetBuf);
         __POWER_OVERWHELMING_VISA_FUNC(viStatusDesc);
+        __POWER_OVERWHELMING_VISA_FUNC(viTerminate);
         __POWER_OVERWHELMING_VISA_FUNC(viUninstallHandler);
         __POWER_OVERWHELMING_VISA_FUNC(viWaitOnEvent);
         __POWER_OVERWHELMING_VISA_FUNC(viWrite);
+        __POWER_OVERWHELMING_VISA_FUNC(viWriteAsync);
 
     private:
 
@@ -0,0 +1,579 @@
+﻿// <copyright file="waveform_archive.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "waveform_archive.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+#include "power_overwhelming/convert_string.h"
+
+#include "column_codec.h"
+#include "library_thread.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The size of the header at the begin of an archive.
+    /// </summary>
+    constexpr std::uint64_t waveform_archive_header_size = 16;
+
+    /// <summary>
+    /// The size of the header of a chunk.
+    /// </summary>
+    constexpr std::uint64_t waveform_chunk_header_size = 16;
+
+    /// <summary>
+    /// The size of the trailer following the index.
+    /// </summary>
+    constexpr std::uint64_t waveform_trailer_size = 16;
+
+    /// <summary>
+    /// Answer the number of padding bytes to align <paramref name="size" />
+    /// to eight bytes.
+    /// </summary>
+    inline std::uint64_t waveform_padding(_In_ const std::uint64_t size) {
+        return (8 - size % 8) % 8;
+    }
+
+    /// <summary>
+    /// Reads the raw bytes of <paramref name="value" /> from the given stream.
+    /// </summary>
+    template<class TValue>
+    inline bool read_waveform_binary(_In_ std::istream& stream,
+            _Out_ TValue& value) {
+        stream.read(reinterpret_cast<char *>(&value), sizeof(value));
+        return stream.good();
+    }
+
+    /// <summary>
+    /// Writes the raw bytes of <paramref name="value" /> to the given stream.
+    /// </summary>
+    template<class TValue>
+    inline void write_waveform_binary(_In_ std::ostream& stream,
+            _In_ const TValue& value) {
+        stream.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    /// <summary>
+    /// Writes zeros until <paramref name="size" /> is aligned to eight bytes.
+    /// </summary>
+    static void write_waveform_padding(_In_ std::ostream& stream,
+            _In_ const std::uint64_t size) {
+        static const char zeros[8] = { 0 };
+        stream.write(zeros, static_cast<std::streamsize>(
+            waveform_padding(size)));
+    }
+
+    /// <summary>
+    /// Converts a wide string into UTF-16 code units.
+    /// </summary>
+    static std::vector<std::uint16_t> waveform_to_utf16(
+            _In_ const std::wstring& str) {
+        std::vector<std::uint16_t> retval;
+        retval.reserve(str.size());
+
+        for (auto c : str) {
+            auto u = static_cast<std::uint32_t>(c);
+            if ((sizeof(wchar_t) > 2) && (u > 0xFFFF)) {
+                u -= 0x10000;
+                retval.push_back(static_cast<std::uint16_t>(0xD800 + (u >> 10)));
+                retval.push_back(static_cast<std::uint16_t>(0xDC00
+                    + (u & 0x3FF)));
+            } else {
+                retval.push_back(static_cast<std::uint16_t>(u));
+            }
+        }
+
+        return retval;
+    }
+
+    /// <summary>
+    /// Converts UTF-16 code units into a wide string.
+    /// </summary>
+    static std::wstring waveform_from_utf16(
+            _In_ const std::vector<std::uint16_t>& str) {
+        std::wstring retval;
+        retval.reserve(str.size());
+
+        for (std::size_t i = 0; i < str.size(); ++i) {
+            std::uint32_t c = str[i];
+            if ((sizeof(wchar_t) > 2) && (c >= 0xD800) && (c < 0xDC00)
+                    && (i + 1 < str.size())) {
+                c = 0x10000 + ((c - 0xD800) << 10) + (str[++i] - 0xDC00);
+            }
+            retval.push_back(static_cast<wchar_t>(c));
+        }
+
+        return retval;
+    }
+
+    /// <summary>
+    /// Sorts the index by the timestamps of the captures, retaining the order
+    /// in which the captures of the same time have been written.
+    /// </summary>
+    static void sort_waveform_index(
+            _Inout_ std::vector<waveform_index_entry>& index) {
+        std::stable_sort(index.begin(), index.end(),
+            [](const waveform_index_entry& lhs,
+                    const waveform_index_entry& rhs) {
+                return (lhs.timestamp < rhs.timestamp);
+            });
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::waveform_archive_magic
+ */
+const char visus::power_overwhelming::detail::waveform_archive_magic[8] = {
+    'P', 'W', 'R', 'O', 'W', 'G', 'W', '\0'
+};
+
+
+/*
+ * visus::power_overwhelming::detail::waveform_archive_index_magic
+ */
+const char visus::power_overwhelming::detail::waveform_archive_index_magic[8]
+= {
+    'P', 'W', 'R', 'O', 'W', 'G', 'I', '\0'
+};
+
+
+/*
+ * visus::power_overwhelming::detail::waveform_archive::waveform_archive
+ */
+visus::power_overwhelming::detail::waveform_archive::waveform_archive(void)
+    : _closing(false), _compress(false) { }
+
+
+/*
+ * visus::power_overwhelming::detail::waveform_archive::~waveform_archive
+ */
+visus::power_overwhelming::detail::waveform_archive::~waveform_archive(void) {
+    this->close();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::waveform_archive::append
+ */
+void visus::power_overwhelming::detail::waveform_archive::append(
+        _In_z_ const wchar_t *sensor,
+        _In_ const timestamp_type timestamp,
+        _In_ const std::uint32_t channel,
+        _In_ const std::uint32_t segment,
+        _In_ const float time_begin,
+        _In_ const float time_end,
+        _In_reads_(cnt) const float *samples,
+        _In_ const std::size_t cnt) {
+    assert(sensor != nullptr);
+    assert((samples != nullptr) || (cnt == 0));
+
+    // Copy the waveform before acquiring the lock such that the writer is not
+    // blocked by the caller.
+    pending_capture capture;
+    capture.header.channel = channel;
+    capture.header.record_length = cnt;
+    capture.header.segment = segment;
+    capture.header.sensor = sensor;
+    capture.header.time_begin = time_begin;
+    capture.header.time_end = time_end;
+    capture.header.timestamp = timestamp;
+    capture.samples.assign(samples, samples + cnt);
+
+    {
+        std::lock_guard<decltype(this->_lock)> l(this->_lock);
+        if (!this->_thread.joinable() || this->_closing) {
+            return;
+        }
+
+        this->_pending.push_back(std::move(capture));
+    }
+
+    this->_signal.notify_one();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::waveform_archive::close
+ */
+void visus::power_overwhelming::detail::waveform_archive::close(void) {
+    {
+        std::lock_guard<decltype(this->_lock)> l(this->_lock);
+        if (!this->_thread.joinable()) {
+            return;
+        }
+
+        this->_closing = true;
+    }
+
+    this->_signal.notify_one();
+    this->_thread.join();
+
+    // The writer has drained the queue, so we own the file now.
+    sort_waveform_index(this->_index);
+    const std::uint64_t offset = this->_stream.tellp();
+    const std::uint64_t count = this->_index.size();
+    const auto size = sizeof(count) + count * (2 * sizeof(std::uint64_t)
+        + 2 * sizeof(std::uint32_t));
+
+    write_waveform_binary(this->_stream, waveform_chunk_type::index);
+    write_waveform_binary(this->_stream, waveform_chunk_flags::none);
+    write_waveform_binary(this->_stream, static_cast<std::uint64_t>(size));
+    write_waveform_binary(this->_stream, count);
+    for (auto& e : this->_index) {
+        write_waveform_binary(this->_stream, e.offset);
+        write_waveform_binary(this->_stream, e.timestamp);
+        write_waveform_binary(this->_stream, e.channel);
+        write_waveform_binary(this->_stream, e.segment);
+    }
+    write_waveform_padding(this->_stream, size);
+
+    write_waveform_binary(this->_stream, offset);
+    this->_stream.write(waveform_archive_index_magic,
+        sizeof(waveform_archive_index_magic));
+
+    this->_stream.close();
+    this->_index.clear();
+
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    this->_closing = false;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::waveform_archive::is_open
+ */
+bool visus::power_overwhelming::detail::waveform_archive::is_open(
+        void) const {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    return (this->_thread.joinable() && !this->_closing);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::waveform_archive::open
+ */
+void visus::power_overwhelming::detail::waveform_archive::open(
+        _In_z_ const wchar_t *path, _In_ const bool compress) {
+    if (path == nullptr) {
+        throw std::invalid_argument("The path to the waveform archive must not "
+            "be null.");
+    }
+
+    this->close();
+
+    const auto mode = std::ofstream::binary | std::ofstream::out
+        | std::ofstream::trunc;
+#if defined(_WIN32)
+    this->_stream.open(path, mode);
+#else /* defined(_WIN32) */
+    auto p = power_overwhelming::convert_string<char>(path);
+    this->_stream.open(p, mode);
+#endif /* defined(_WIN32) */
+
+    if (!this->_stream.is_open()) {
+        throw std::ios_base::failure("The waveform archive could not be "
+            "created.");
+    }
+
+    this->_stream.write(waveform_archive_magic,
+        sizeof(waveform_archive_magic));
+    write_waveform_binary(this->_stream, waveform_archive_version);
+    write_waveform_binary(this->_stream, static_cast<std::uint32_t>(0));
+
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    this->_compress = compress;
+    this->_thread = std::thread(&waveform_archive::write, this);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::waveform_archive::write
+ */
+void visus::power_overwhelming::detail::waveform_archive::write(void) {
+    std::vector<std::uint8_t> compressed;
+    pending_capture capture;
+
+    enter_library_thread("PwrOwg Waveform Archive Thread");
+
+    while (true) {
+        {
+            std::unique_lock<decltype(this->_lock)> l(this->_lock);
+            this->_signal.wait(l, [this](void) {
+                return (!this->_pending.empty() || this->_closing);
+            });
+
+            if (this->_pending.empty()) {
+                // We are closing and have written everything.
+                break;
+            }
+
+            capture = std::move(this->_pending.front());
+            this->_pending.pop_front();
+        }
+
+        const auto& h = capture.header;
+        const auto name = waveform_to_utf16(h.sensor);
+        const auto flags = this->_compress
+            ? waveform_chunk_flags::compressed
+            : waveform_chunk_flags::none;
+
+        // The header of the capture is padded such that uncompressed samples
+        // are aligned in the file.
+        const std::uint64_t header_size = sizeof(h.timestamp)
+            + sizeof(h.time_begin) + sizeof(h.time_end)
+            + sizeof(h.record_length) + sizeof(h.channel) + sizeof(h.segment)
+            + sizeof(std::uint32_t) + name.size() * sizeof(std::uint16_t);
+        auto size = header_size + waveform_padding(header_size);
+
+        if (this->_compress) {
+            compressed.clear();
+            encode_xor(compressed, capture.samples.data(),
+                capture.samples.size());
+            size += compressed.size();
+        } else {
+            size += capture.samples.size() * sizeof(float);
+        }
+
+        waveform_index_entry entry;
+        entry.channel = h.channel;
+        entry.offset = this->_stream.tellp();
+        entry.segment = h.segment;
+        entry.timestamp = h.timestamp;
+
+        write_waveform_binary(this->_stream, waveform_chunk_type::capture);
+        write_waveform_binary(this->_stream, flags);
+        write_waveform_binary(this->_stream, size);
+        write_waveform_binary(this->_stream, h.timestamp);
+        write_waveform_binary(this->_stream, h.time_begin);
+        write_waveform_binary(this->_stream, h.time_end);
+        write_waveform_binary(this->_stream, h.record_length);
+        write_waveform_binary(this->_stream, h.channel);
+        write_waveform_binary(this->_stream, h.segment);
+        write_waveform_binary(this->_stream,
+            static_cast<std::uint32_t>(name.size()));
+        this->_stream.write(reinterpret_cast<const char *>(name.data()),
+            name.size() * sizeof(std::uint16_t));
+        write_waveform_padding(this->_stream, header_size);
+
+        if (this->_compress) {
+            this->_stream.write(reinterpret_cast<const char *>(
+                compressed.data()), compressed.size());
+        } else {
+            this->_stream.write(reinterpret_cast<const char *>(
+                capture.samples.data()),
+                capture.samples.size() * sizeof(float));
+        }
+        write_waveform_padding(this->_stream, size);
+
+        this->_index.push_back(entry);
+    }
+}
+
+
+/*
+ * ...::detail::waveform_archive_reader::waveform_archive_reader
+ */
+visus::power_overwhelming::detail::waveform_archive_reader::waveform_archive_reader(
+        _In_z_ const wchar_t *path) {
+    if (path == nullptr) {
+        throw std::invalid_argument("The path to the waveform archive must not "
+            "be null.");
+    }
+
+    const auto mode = std::ifstream::binary | std::ifstream::in;
+#if defined(_WIN32)
+    this->_stream.open(path, mode);
+#else /* defined(_WIN32) */
+    auto p = power_overwhelming::convert_string<char>(path);
+    this->_stream.open(p, mode);
+#endif /* defined(_WIN32) */
+
+    if (!this->_stream.is_open()) {
+        throw std::ios_base::failure("The waveform archive could not be "
+            "opened.");
+    }
+
+    char magic[sizeof(waveform_archive_magic)];
+    std::uint32_t version = 0;
+    this->_stream.read(magic, sizeof(magic));
+    if (!this->_stream.good()
+            || (::memcmp(magic, waveform_archive_magic, sizeof(magic)) != 0)
+            || !read_waveform_binary(this->_stream, version)
+            || (version > waveform_archive_version)) {
+        throw std::ios_base::failure("The file is not a waveform archive "
+            "supported by this version of the library.");
+    }
+
+    // Try the index at the end of a complete archive first.
+    this->_stream.seekg(0, std::ios::end);
+    const std::uint64_t end = this->_stream.tellg();
+    if (end >= waveform_archive_header_size + waveform_trailer_size) {
+        std::uint64_t offset = 0;
+        this->_stream.seekg(end - waveform_trailer_size);
+        read_waveform_binary(this->_stream, offset);
+        this->_stream.read(magic, sizeof(magic));
+
+        if (this->_stream.good() && (::memcmp(magic,
+                waveform_archive_index_magic, sizeof(magic)) == 0)) {
+            std::uint64_t count = 0;
+            this->_stream.seekg(offset + waveform_chunk_header_size);
+            read_waveform_binary(this->_stream, count);
+            this->_index.resize(static_cast<std::size_t>(count));
+
+            for (auto& e : this->_index) {
+                read_waveform_binary(this->_stream, e.offset);
+                read_waveform_binary(this->_stream, e.timestamp);
+                read_waveform_binary(this->_stream, e.channel);
+                read_waveform_binary(this->_stream, e.segment);
+            }
+
+            if (this->_stream.good()) {
+                return;
+            }
+        }
+    }
+
+    // The archive has not been closed properly, so we rebuild the index from
+    // all chunks that have been written completely.
+    this->_stream.clear();
+    this->_index.clear();
+
+    std::uint64_t offset = waveform_archive_header_size;
+    while (offset + waveform_chunk_header_size <= end) {
+        waveform_chunk_type type;
+        waveform_chunk_flags flags;
+        std::uint64_t size;
+
+        this->_stream.seekg(offset);
+        if (!read_waveform_binary(this->_stream, type)
+                || !read_waveform_binary(this->_stream, flags)
+                || !read_waveform_binary(this->_stream, size)) {
+            break;
+        }
+
+        const auto next = offset + waveform_chunk_header_size + size
+            + waveform_padding(size);
+        if (next > end) {
+            break;
+        }
+
+        if (type == waveform_chunk_type::capture) {
+            waveform_index_entry entry;
+            std::uint64_t record_length;
+            float time;
+            entry.offset = offset;
+            read_waveform_binary(this->_stream, entry.timestamp);
+            read_waveform_binary(this->_stream, time);
+            read_waveform_binary(this->_stream, time);
+            read_waveform_binary(this->_stream, record_length);
+            read_waveform_binary(this->_stream, entry.channel);
+            read_waveform_binary(this->_stream, entry.segment);
+            this->_index.push_back(entry);
+        }
+
+        offset = next;
+    }
+
+    this->_stream.clear();
+    sort_waveform_index(this->_index);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::waveform_archive_reader::find
+ */
+std::size_t visus::power_overwhelming::detail::waveform_archive_reader::find(
+        _In_ const timestamp_type timestamp) const {
+    auto it = std::lower_bound(this->_index.begin(), this->_index.end(),
+        timestamp, [](const waveform_index_entry& lhs,
+                const timestamp_type rhs) {
+            return (lhs.timestamp < rhs);
+        });
+    return static_cast<std::size_t>(it - this->_index.begin());
+}
+
+
+/*
+ * visus::power_overwhelming::detail::waveform_archive_reader::read
+ */
+void visus::power_overwhelming::detail::waveform_archive_reader::read(
+        _In_ const waveform_index_entry& entry,
+        _Out_ waveform_capture& header,
+        _Out_ std::vector<float>& samples) {
+    waveform_chunk_type type;
+    waveform_chunk_flags flags;
+    std::uint64_t size;
+    std::uint32_t length;
+
+    this->_stream.clear();
+    this->_stream.seekg(entry.offset);
+    if (!read_waveform_binary(this->_stream, type)
+            || !read_waveform_binary(this->_stream, flags)
+            || !read_waveform_binary(this->_stream, size)
+            || (type != waveform_chunk_type::capture)) {
+        throw std::ios_base::failure("The index entry does not designate a "
+            "capture in the waveform archive.");
+    }
+
+    read_waveform_binary(this->_stream, header.timestamp);
+    read_waveform_binary(this->_stream, header.time_begin);
+    read_waveform_binary(this->_stream, header.time_end);
+    read_waveform_binary(this->_stream, header.record_length);
+    read_waveform_binary(this->_stream, header.channel);
+    read_waveform_binary(this->_stream, header.segment);
+    read_waveform_binary(this->_stream, length);
+
+    std::vector<std::uint16_t> name(length);
+    this->_stream.read(reinterpret_cast<char *>(name.data()),
+        name.size() * sizeof(std::uint16_t));
+    header.sensor = waveform_from_utf16(name);
+
+    std::uint64_t used = sizeof(header.timestamp) + sizeof(header.time_begin)
+        + sizeof(header.time_end) + sizeof(header.record_length)
+        + sizeof(header.channel) + sizeof(header.segment) + sizeof(length)
+        + name.size() * sizeof(std::uint16_t);
+    this->_stream.seekg(waveform_padding(used), std::ios::cur);
+    used += waveform_padding(used);
+
+    if (!this->_stream.good() || (used > size)) {
+        throw std::ios_base::failure("The capture in the waveform archive is "
+            "corrupted.");
+    }
+
+    samples.resize(static_cast<std::size_t>(header.record_length));
+    if ((static_cast<std::uint32_t>(flags)
+            & static_cast<std::uint32_t>(waveform_chunk_flags::compressed))
+            != 0) {
+        std::vector<std::uint8_t> compressed(static_cast<std::size_t>(
+            size - used));
+        this->_stream.read(reinterpret_cast<char *>(compressed.data()),
+            compressed.size());
+        if (!this->_stream.good()) {
+            throw std::ios_base::failure("The capture in the waveform archive "
+                "is truncated.");
+        }
+        decode_xor(samples.data(), samples.size(), compressed.data(),
+            compressed.size());
+
+    } else {
+        this->_stream.read(reinterpret_cast<char *>(samples.data()),
+            samples.size() * sizeof(float));
+        if (!this->_stream.good()) {
+            throw std::ios_base::failure("The capture in the waveform archive "
+                "is truncated.");
+        }
+    }
+}
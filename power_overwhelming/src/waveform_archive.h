@@ -0,0 +1,364 @@
+﻿// <copyright file="waveform_archive.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "power_overwhelming/oscilloscope_waveform.h"
+
+#include "timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The magic number at the begin of a waveform archive.
+    /// </summary>
+    /// <remarks>
+    /// <para>A waveform archive starts with the eight bytes of the magic
+    /// number, the <see cref="waveform_archive_version" /> as 32-bit unsigned
+    /// integer and 32 reserved bits. The header is followed by an arbitrary
+    /// number of chunks, each of which starts with its
+    /// <see cref="waveform_chunk_type" /> as 32-bit unsigned integer, the
+    /// <see cref="waveform_chunk_flags" /> as 32-bit unsigned integer and the
+    /// size of the following payload in bytes as 64-bit unsigned integer.
+    /// The payload is padded to a multiple of eight bytes, which is not
+    /// included in its size, such that all chunks start at an offset that is
+    /// aligned to eight bytes. Readers must skip chunks of unknown types.</para>
+    /// <para>A complete archive ends with a
+    /// <see cref="waveform_chunk_type::index" /> chunk followed by the 64-bit
+    /// offset of this chunk and the eight bytes of
+    /// <see cref="waveform_archive_index_magic" />. If the archive has not
+    /// been closed properly, readers can rebuild the index by walking the
+    /// chunks.</para>
+    /// <para>Strings are stored as the number of UTF-16 code units as 32-bit
+    /// unsigned integer followed by the code units. All numbers are stored in
+    /// the native (little endian) byte order.</para>
+    /// </remarks>
+    extern POWER_OVERWHELMING_API const char waveform_archive_magic[8];
+
+    /// <summary>
+    /// The magic number at the end of a complete waveform archive.
+    /// </summary>
+    extern POWER_OVERWHELMING_API const char waveform_archive_index_magic[8];
+
+    /// <summary>
+    /// The version of the waveform archive format written by
+    /// <see cref="waveform_archive" />.
+    /// </summary>
+    constexpr std::uint32_t waveform_archive_version = 1;
+
+    /// <summary>
+    /// Identifies the type of a chunk in a waveform archive.
+    /// </summary>
+    enum class waveform_chunk_type : std::uint32_t {
+
+        /// <summary>
+        /// A single waveform. The payload is the 64-bit timestamp of the
+        /// trigger, the 32-bit floating point begin and end of the waveform
+        /// relative to the trigger in seconds, the 64-bit record length, the
+        /// 32-bit channel, the 32-bit segment, the name of the sensor padded
+        /// to a multiple of eight bytes from the begin of the payload and the
+        /// samples. The samples are 32-bit floating point numbers unless the
+        /// chunk is <see cref="waveform_chunk_flags::compressed" />.
+        /// </summary>
+        capture = 1,
+
+        /// <summary>
+        /// The index of all captures. The payload is the 64-bit number of
+        /// entries followed by the <see cref="waveform_index_entry" />s ordered
+        /// by their timestamps.
+        /// </summary>
+        index = 2
+    };
+
+    /// <summary>
+    /// Flags describing the payload of a chunk in a waveform archive.
+    /// </summary>
+    enum class waveform_chunk_flags : std::uint32_t {
+
+        /// <summary>
+        /// The payload is stored as is.
+        /// </summary>
+        none = 0,
+
+        /// <summary>
+        /// The samples of a <see cref="waveform_chunk_type::capture" /> are
+        /// compressed using <see cref="encode_xor" />.
+        /// </summary>
+        compressed = 0x00000001
+    };
+
+    /// <summary>
+    /// The header of a waveform stored in an archive.
+    /// </summary>
+    struct POWER_OVERWHELMING_API waveform_capture final {
+
+        /// <summary>
+        /// The channel of the instrument that has recorded the waveform.
+        /// </summary>
+        std::uint32_t channel;
+
+        /// <summary>
+        /// The length of the waveform in samples.
+        /// </summary>
+        std::uint64_t record_length;
+
+        /// <summary>
+        /// The index of the segment in the history of the instrument, which is
+        /// zero unless multiple acquisitions have been downloaded at once.
+        /// </summary>
+        std::uint32_t segment;
+
+        /// <summary>
+        /// The name of the sensor that has recorded the waveform.
+        /// </summary>
+        std::wstring sensor;
+
+        /// <summary>
+        /// The begin of the waveform relative to the trigger in seconds.
+        /// </summary>
+        float time_begin;
+
+        /// <summary>
+        /// The end of the waveform relative to the trigger in seconds.
+        /// </summary>
+        float time_end;
+
+        /// <summary>
+        /// The time of the trigger.
+        /// </summary>
+        timestamp_type timestamp;
+    };
+
+    /// <summary>
+    /// An entry in the <see cref="waveform_chunk_type::index" /> of a waveform
+    /// archive.
+    /// </summary>
+    /// <remarks>
+    /// The entry is stored as the 64-bit offset, the 64-bit timestamp, the
+    /// 32-bit channel and the 32-bit segment.
+    /// </remarks>
+    struct waveform_index_entry final {
+
+        /// <summary>
+        /// The offset of the capture chunk from the begin of the file.
+        /// </summary>
+        std::uint64_t offset;
+
+        /// <summary>
+        /// The time of the trigger of the capture.
+        /// </summary>
+        timestamp_type timestamp;
+
+        /// <summary>
+        /// The channel of the capture.
+        /// </summary>
+        std::uint32_t channel;
+
+        /// <summary>
+        /// The segment of the capture.
+        /// </summary>
+        std::uint32_t segment;
+    };
+
+    /// <summary>
+    /// Appends complete waveforms to a chunked binary file.
+    /// </summary>
+    /// <remarks>
+    /// <para>The waveforms are copied by the caller and written by a
+    /// background thread, which also compresses them if requested. The
+    /// samples of uncompressed waveforms are aligned in the file such that
+    /// readers can map it into memory and use the samples in place.</para>
+    /// <para>All public methods are thread-safe.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API waveform_archive final {
+
+    public:
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        waveform_archive(void);
+
+        waveform_archive(const waveform_archive&) = delete;
+
+        /// <summary>
+        /// Finalise the instance.
+        /// </summary>
+        ~waveform_archive(void);
+
+        /// <summary>
+        /// Queues a waveform for being written.
+        /// </summary>
+        /// <remarks>
+        /// Waveforms are silently discarded if the archive is not open.
+        /// </remarks>
+        /// <param name="sensor">The name of the sensor that has recorded the
+        /// waveform.</param>
+        /// <param name="timestamp">The time of the trigger.</param>
+        /// <param name="channel">The channel of the waveform.</param>
+        /// <param name="segment">The segment of the waveform.</param>
+        /// <param name="time_begin">The begin of the waveform relative to the
+        /// trigger in seconds.</param>
+        /// <param name="time_end">The end of the waveform relative to the
+        /// trigger in seconds.</param>
+        /// <param name="samples">The samples of the waveform.</param>
+        /// <param name="cnt">The number of samples.</param>
+        /// <exception cref="std::bad_alloc">If the copy of the waveform could
+        /// not be allocated.</exception>
+        void append(_In_z_ const wchar_t *sensor,
+            _In_ const timestamp_type timestamp,
+            _In_ const std::uint32_t channel,
+            _In_ const std::uint32_t segment,
+            _In_ const float time_begin,
+            _In_ const float time_end,
+            _In_reads_(cnt) const float *samples,
+            _In_ const std::size_t cnt);
+
+        /// <summary>
+        /// Queues a waveform for being written.
+        /// </summary>
+        /// <param name="sensor">The name of the sensor that has recorded the
+        /// waveform.</param>
+        /// <param name="timestamp">The time of the trigger.</param>
+        /// <param name="channel">The channel of the waveform.</param>
+        /// <param name="segment">The segment of the waveform.</param>
+        /// <param name="waveform">The waveform.</param>
+        /// <exception cref="std::bad_alloc">If the copy of the waveform could
+        /// not be allocated.</exception>
+        inline void append(_In_z_ const wchar_t *sensor,
+                _In_ const timestamp_type timestamp,
+                _In_ const std::uint32_t channel,
+                _In_ const std::uint32_t segment,
+                _In_ const oscilloscope_waveform& waveform) {
+            this->append(sensor, timestamp, channel, segment,
+                waveform.time_begin(), waveform.time_end(),
+                waveform.samples(), waveform.record_length());
+        }
+
+        /// <summary>
+        /// Writes all queued waveforms and the index, and closes the file.
+        /// </summary>
+        /// <remarks>
+        /// It is safe to call this method on an archive that is not open.
+        /// </remarks>
+        void close(void);
+
+        /// <summary>
+        /// Answer whether the archive is open.
+        /// </summary>
+        /// <returns><c>true</c> if waveforms are written, <c>false</c>
+        /// otherwise.</returns>
+        bool is_open(void) const;
+
+        /// <summary>
+        /// Creates a new archive, closing the current one.
+        /// </summary>
+        /// <param name="path">The path to the file to be created.</param>
+        /// <param name="compress">If <c>true</c>, the samples are compressed
+        /// losslessly on the background thread.</param>
+        /// <exception cref="std::invalid_argument">If <paramref name="path" />
+        /// is <c>nullptr</c>.</exception>
+        /// <exception cref="std::ios_base::failure">If the file could not be
+        /// created.</exception>
+        void open(_In_z_ const wchar_t *path, _In_ const bool compress);
+
+        waveform_archive& operator =(const waveform_archive&) = delete;
+
+    private:
+
+        /// <summary>
+        /// A waveform waiting for being written.
+        /// </summary>
+        struct pending_capture {
+            waveform_capture header;
+            std::vector<float> samples;
+        };
+
+        void write(void);
+
+        bool _closing;
+        bool _compress;
+        std::vector<waveform_index_entry> _index;
+        mutable std::mutex _lock;
+        std::deque<pending_capture> _pending;
+        std::condition_variable _signal;
+        std::ofstream _stream;
+        std::thread _thread;
+    };
+
+    /// <summary>
+    /// Provides random access to the waveforms in an archive.
+    /// </summary>
+    class POWER_OVERWHELMING_API waveform_archive_reader final {
+
+    public:
+
+        /// <summary>
+        /// Opens an archive.
+        /// </summary>
+        /// <remarks>
+        /// If the archive has not been closed properly, the index is rebuilt
+        /// from all complete capture chunks.
+        /// </remarks>
+        /// <param name="path">The path to the archive.</param>
+        /// <exception cref="std::invalid_argument">If <paramref name="path" />
+        /// is <c>nullptr</c>.</exception>
+        /// <exception cref="std::ios_base::failure">If the file could not be
+        /// opened or is not a waveform archive.</exception>
+        explicit waveform_archive_reader(_In_z_ const wchar_t *path);
+
+        /// <summary>
+        /// Finds the first capture that has been triggered at or after the
+        /// given time.
+        /// </summary>
+        /// <param name="timestamp">The time to search for.</param>
+        /// <returns>The position of the capture in the <see cref="index" />,
+        /// which is the size of the index if no such capture exists.
+        /// </returns>
+        std::size_t find(_In_ const timestamp_type timestamp) const;
+
+        /// <summary>
+        /// Answer the index of all captures ordered by their timestamps.
+        /// </summary>
+        /// <returns>The index of the archive.</returns>
+        inline const std::vector<waveform_index_entry>& index(
+                void) const noexcept {
+            return this->_index;
+        }
+
+        /// <summary>
+        /// Reads a capture.
+        /// </summary>
+        /// <param name="entry">The entry of the capture in the
+        /// <see cref="index" />.</param>
+        /// <param name="header">Receives the header of the capture.</param>
+        /// <param name="samples">Receives the decompressed samples.</param>
+        /// <exception cref="std::ios_base::failure">If the capture could not
+        /// be read.</exception>
+        void read(_In_ const waveform_index_entry& entry,
+            _Out_ waveform_capture& header,
+            _Out_ std::vector<float>& samples);
+
+    private:
+
+        std::vector<waveform_index_entry> _index;
+        std::ifstream _stream;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,410 @@
+﻿// <copyright file="waveform_kernels.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "waveform_kernels.h"
+
+#include <algorithm>
+#include <vector>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define POWER_OVERWHELMING_WAVEFORM_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define POWER_OVERWHELMING_WAVEFORM_NEON
+#endif /* defined(_M_X64) || defined(__SSE2__) */
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Answer the median of a single window of samples.
+    /// </summary>
+    static float median_of(_In_reads_(window) const float *src,
+            _In_ const std::size_t window) noexcept {
+        float buffer[max_vector_median];
+        std::vector<float> heap;
+        auto b = buffer;
+
+        if (window > max_vector_median) {
+            // Large windows are rare, so the allocation does not matter.
+            try {
+                heap.assign(src, src + window);
+            } catch (...) {
+                return src[window / 2];
+            }
+            b = heap.data();
+        } else {
+            std::copy(src, src + window, b);
+        }
+
+        std::nth_element(b, b + window / 2, b + window);
+        return b[window / 2];
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::convolve_waveform
+ */
+std::size_t visus::power_overwhelming::detail::convolve_waveform(
+        _Out_writes_(return) float *dst,
+        _In_reads_(cnt) const float *src,
+        _In_ const std::size_t cnt,
+        _In_reads_(n) const float *taps,
+        _In_ const std::size_t n) noexcept {
+    if ((n == 0) || (cnt < n)) {
+        return 0;
+    }
+
+    const auto retval = cnt - n + 1;
+    std::size_t i = 0;
+
+    // Four outputs are accumulated at once, which reads each tap once per
+    // vector instead of once per output.
+#if defined(POWER_OVERWHELMING_WAVEFORM_SSE2)
+    for (; i + 4 <= retval; i += 4) {
+        auto acc = _mm_setzero_ps();
+        for (std::size_t k = 0; k < n; ++k) {
+            const auto t = _mm_set1_ps(taps[k]);
+            acc = _mm_add_ps(acc, _mm_mul_ps(t, _mm_loadu_ps(src + i + k)));
+        }
+        _mm_storeu_ps(dst + i, acc);
+    }
+
+#elif defined(POWER_OVERWHELMING_WAVEFORM_NEON)
+    for (; i + 4 <= retval; i += 4) {
+        auto acc = vdupq_n_f32(0.0f);
+        for (std::size_t k = 0; k < n; ++k) {
+            acc = vmlaq_n_f32(acc, vld1q_f32(src + i + k), taps[k]);
+        }
+        vst1q_f32(dst + i, acc);
+    }
+#endif /* defined(POWER_OVERWHELMING_WAVEFORM_SSE2) */
+
+    for (; i < retval; ++i) {
+        auto acc = 0.0f;
+        for (std::size_t k = 0; k < n; ++k) {
+            acc += taps[k] * src[i + k];
+        }
+        dst[i] = acc;
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::decimate_waveform
+ */
+std::size_t visus::power_overwhelming::detail::decimate_waveform(
+        _Out_writes_(return) waveform_window *dst,
+        _In_reads_(cnt) const float *src,
+        _In_ const std::size_t cnt,
+        _In_ std::size_t window) noexcept {
+    if (window == 0) {
+        window = 1;
+    }
+
+    std::size_t retval = 0;
+
+    for (std::size_t w = 0; w < cnt; w += window, ++retval) {
+        const auto n = (std::min)(window, cnt - w);
+        const auto s = src + w;
+        auto maximum = s[0];
+        auto minimum = s[0];
+        auto sum = 0.0f;
+        std::size_t i = 0;
+
+#if defined(POWER_OVERWHELMING_WAVEFORM_SSE2)
+        if (n >= 4) {
+            auto vmax = _mm_loadu_ps(s);
+            auto vmin = vmax;
+            auto vsum = _mm_setzero_ps();
+
+            for (; i + 4 <= n; i += 4) {
+                const auto v = _mm_loadu_ps(s + i);
+                vmax = _mm_max_ps(vmax, v);
+                vmin = _mm_min_ps(vmin, v);
+                vsum = _mm_add_ps(vsum, v);
+            }
+
+            float lanes[3][4];
+            _mm_storeu_ps(lanes[0], vmax);
+            _mm_storeu_ps(lanes[1], vmin);
+            _mm_storeu_ps(lanes[2], vsum);
+            for (int l = 0; l < 4; ++l) {
+                maximum = (std::max)(maximum, lanes[0][l]);
+                minimum = (std::min)(minimum, lanes[1][l]);
+                sum += lanes[2][l];
+            }
+        }
+
+#elif defined(POWER_OVERWHELMING_WAVEFORM_NEON)
+        if (n >= 4) {
+            auto vmax = vld1q_f32(s);
+            auto vmin = vmax;
+            auto vsum = vdupq_n_f32(0.0f);
+
+            for (; i + 4 <= n; i += 4) {
+                const auto v = vld1q_f32(s + i);
+                vmax = vmaxq_f32(vmax, v);
+                vmin = vminq_f32(vmin, v);
+                vsum = vaddq_f32(vsum, v);
+            }
+
+            float lanes[3][4];
+            vst1q_f32(lanes[0], vmax);
+            vst1q_f32(lanes[1], vmin);
+            vst1q_f32(lanes[2], vsum);
+            for (int l = 0; l < 4; ++l) {
+                maximum = (std::max)(maximum, lanes[0][l]);
+                minimum = (std::min)(minimum, lanes[1][l]);
+                sum += lanes[2][l];
+            }
+        }
+#endif /* defined(POWER_OVERWHELMING_WAVEFORM_SSE2) */
+
+        for (; i < n; ++i) {
+            maximum = (std::max)(maximum, s[i]);
+            minimum = (std::min)(minimum, s[i]);
+            sum += s[i];
+        }
+
+        dst[retval].maximum = maximum;
+        dst[retval].mean = sum / static_cast<float>(n);
+        dst[retval].minimum = minimum;
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::interpolate_waveform
+ */
+void visus::power_overwhelming::detail::interpolate_waveform(
+        _Out_writes_(cnt) float *dst,
+        _In_ const std::size_t cnt,
+        _In_ const float lhs,
+        _In_ const float rhs,
+        _In_ const float offset,
+        _In_ const float step) noexcept {
+    const auto delta = rhs - lhs;
+    std::size_t i = 0;
+
+    // The positions are computed from the index rather than accumulated,
+    // such that the vectorised and the scalar path yield the same results.
+#if defined(POWER_OVERWHELMING_WAVEFORM_SSE2)
+    const auto d = _mm_set1_ps(delta);
+    const auto four = _mm_set1_ps(4.0f);
+    const auto l = _mm_set1_ps(lhs);
+    const auto o = _mm_set1_ps(offset);
+    const auto s = _mm_set1_ps(step);
+    auto n = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    for (; i + 4 <= cnt; i += 4) {
+        const auto w = _mm_add_ps(o, _mm_mul_ps(n, s));
+        _mm_storeu_ps(dst + i, _mm_add_ps(l, _mm_mul_ps(d, w)));
+        n = _mm_add_ps(n, four);
+    }
+
+#elif defined(POWER_OVERWHELMING_WAVEFORM_NEON)
+    const float init[] = { 0.0f, 1.0f, 2.0f, 3.0f };
+    const auto four = vdupq_n_f32(4.0f);
+    const auto l = vdupq_n_f32(lhs);
+    const auto o = vdupq_n_f32(offset);
+    auto n = vld1q_f32(init);
+    for (; i + 4 <= cnt; i += 4) {
+        const auto w = vmlaq_n_f32(o, n, step);
+        vst1q_f32(dst + i, vmlaq_n_f32(l, w, delta));
+        n = vaddq_f32(n, four);
+    }
+#endif /* defined(POWER_OVERWHELMING_WAVEFORM_SSE2) */
+
+    for (; i < cnt; ++i) {
+        dst[i] = lhs + delta * (offset + static_cast<float>(i) * step);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::median_waveform
+ */
+std::size_t visus::power_overwhelming::detail::median_waveform(
+        _Out_writes_(return) float *dst,
+        _In_reads_(cnt) const float *src,
+        _In_ const std::size_t cnt,
+        _In_ const std::size_t window) noexcept {
+    if ((window == 0) || (cnt < window)) {
+        return 0;
+    }
+
+    const auto retval = cnt - window + 1;
+    std::size_t i = 0;
+
+    // An odd-even transposition sort of the registers sorts four windows at
+    // once, which is branch-free and cheaper than selecting the median of
+    // each window for the small windows used to reject outliers.
+#if defined(POWER_OVERWHELMING_WAVEFORM_SSE2)
+    if (window <= max_vector_median) {
+        __m128 v[max_vector_median];
+        for (; i + 4 <= retval; i += 4) {
+            for (std::size_t k = 0; k < window; ++k) {
+                v[k] = _mm_loadu_ps(src + i + k);
+            }
+
+            for (std::size_t r = 0; r < window; ++r) {
+                for (auto k = r % 2; k + 1 < window; k += 2) {
+                    const auto lo = _mm_min_ps(v[k], v[k + 1]);
+                    v[k + 1] = _mm_max_ps(v[k], v[k + 1]);
+                    v[k] = lo;
+                }
+            }
+
+            _mm_storeu_ps(dst + i, v[window / 2]);
+        }
+    }
+
+#elif defined(POWER_OVERWHELMING_WAVEFORM_NEON)
+    if (window <= max_vector_median) {
+        float32x4_t v[max_vector_median];
+        for (; i + 4 <= retval; i += 4) {
+            for (std::size_t k = 0; k < window; ++k) {
+                v[k] = vld1q_f32(src + i + k);
+            }
+
+            for (std::size_t r = 0; r < window; ++r) {
+                for (auto k = r % 2; k + 1 < window; k += 2) {
+                    const auto lo = vminq_f32(v[k], v[k + 1]);
+                    v[k + 1] = vmaxq_f32(v[k], v[k + 1]);
+                    v[k] = lo;
+                }
+            }
+
+            vst1q_f32(dst + i, v[window / 2]);
+        }
+    }
+#endif /* defined(POWER_OVERWHELMING_WAVEFORM_SSE2) */
+
+    for (; i < retval; ++i) {
+        dst[i] = median_of(src + i, window);
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::smooth_waveform
+ */
+void visus::power_overwhelming::detail::smooth_waveform(
+        _Out_writes_(cnt) float *dst,
+        _In_reads_(cnt) const float *src,
+        _In_ const std::size_t cnt,
+        _In_ const float alpha,
+        _Inout_ float& state) noexcept {
+    auto y = state;
+
+    for (std::size_t i = 0; i < cnt; ++i) {
+        y += alpha * (src[i] - y);
+        dst[i] = y;
+    }
+
+    state = y;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::waveform_energy
+ */
+double visus::power_overwhelming::detail::waveform_energy(
+        _In_reads_(cnt) const float *power,
+        _In_ const std::size_t cnt,
+        _In_ const double step) noexcept {
+    if (cnt < 2) {
+        return 0.0;
+    }
+
+    // The trapezoidal rule for equidistant samples is the sum of all samples
+    // less half of the first and the last one. We accumulate in double
+    // precision, because waveforms have up to several million samples.
+    auto sum = 0.0;
+    std::size_t i = 0;
+
+#if defined(POWER_OVERWHELMING_WAVEFORM_SSE2)
+    {
+        auto lo = _mm_setzero_pd();
+        auto hi = _mm_setzero_pd();
+
+        for (; i + 4 <= cnt; i += 4) {
+            const auto v = _mm_loadu_ps(power + i);
+            lo = _mm_add_pd(lo, _mm_cvtps_pd(v));
+            hi = _mm_add_pd(hi, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+        }
+
+        double lanes[2];
+        _mm_storeu_pd(lanes, _mm_add_pd(lo, hi));
+        sum = lanes[0] + lanes[1];
+    }
+
+#elif defined(POWER_OVERWHELMING_WAVEFORM_NEON) \
+    && (defined(__aarch64__) || defined(_M_ARM64))
+    {
+        auto lo = vdupq_n_f64(0.0);
+        auto hi = vdupq_n_f64(0.0);
+
+        for (; i + 4 <= cnt; i += 4) {
+            const auto v = vld1q_f32(power + i);
+            lo = vaddq_f64(lo, vcvt_f64_f32(vget_low_f32(v)));
+            hi = vaddq_f64(hi, vcvt_high_f64_f32(v));
+        }
+
+        sum = vaddvq_f64(vaddq_f64(lo, hi));
+    }
+#endif /* defined(POWER_OVERWHELMING_WAVEFORM_SSE2) */
+
+    for (; i < cnt; ++i) {
+        sum += power[i];
+    }
+
+    sum -= 0.5 * (static_cast<double>(power[0]) + power[cnt - 1]);
+    return sum * step;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::waveform_power
+ */
+void visus::power_overwhelming::detail::waveform_power(
+        _Out_writes_(cnt) float *dst,
+        _In_reads_(cnt) const float *voltage,
+        _In_reads_(cnt) const float *current,
+        _In_ const std::size_t cnt) noexcept {
+    std::size_t i = 0;
+
+#if defined(POWER_OVERWHELMING_WAVEFORM_SSE2)
+    for (; i + 4 <= cnt; i += 4) {
+        const auto v = _mm_loadu_ps(voltage + i);
+        const auto c = _mm_loadu_ps(current + i);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(v, c));
+    }
+
+#elif defined(POWER_OVERWHELMING_WAVEFORM_NEON)
+    for (; i + 4 <= cnt; i += 4) {
+        const auto v = vld1q_f32(voltage + i);
+        const auto c = vld1q_f32(current + i);
+        vst1q_f32(dst + i, vmulq_f32(v, c));
+    }
+#endif /* defined(POWER_OVERWHELMING_WAVEFORM_SSE2) */
+
+    for (; i < cnt; ++i) {
+        dst[i] = voltage[i] * current[i];
+    }
+}
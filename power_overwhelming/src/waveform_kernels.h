@@ -0,0 +1,203 @@
+﻿// <copyright file="waveform_kernels.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstddef>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The statistics of a window of samples produced by
+    /// <see cref="decimate_waveform" />.
+    /// </summary>
+    struct waveform_window final {
+
+        /// <summary>
+        /// The largest sample in the window.
+        /// </summary>
+        float maximum;
+
+        /// <summary>
+        /// The arithmetic mean of all samples in the window.
+        /// </summary>
+        float mean;
+
+        /// <summary>
+        /// The smallest sample in the window.
+        /// </summary>
+        float minimum;
+    };
+
+
+    /// <summary>
+    /// Convolves a waveform with a filter kernel.
+    /// </summary>
+    /// <remarks>
+    /// The <c>i</c>-th output is the sum of <c>taps[k] * src[i + k]</c> for
+    /// all taps, i.e. only the positions are computed for which the kernel
+    /// completely overlaps the input. <paramref name="dst" /> must not
+    /// overlap with <paramref name="src" />.
+    /// </remarks>
+    /// <param name="dst">Receives <c>cnt - n + 1</c> filtered samples, or
+    /// nothing if <paramref name="cnt" /> is less than <paramref name="n" />.
+    /// </param>
+    /// <param name="src">The samples to be filtered.</param>
+    /// <param name="cnt">The number of samples in <paramref name="src" />.
+    /// </param>
+    /// <param name="taps">The coefficients of the filter kernel.</param>
+    /// <param name="n">The number of taps.</param>
+    /// <returns>The number of samples written to <paramref name="dst" />.
+    /// </returns>
+    std::size_t POWER_OVERWHELMING_API convolve_waveform(
+        _Out_writes_(return) float *dst,
+        _In_reads_(cnt) const float *src,
+        _In_ const std::size_t cnt,
+        _In_reads_(n) const float *taps,
+        _In_ const std::size_t n) noexcept;
+
+    /// <summary>
+    /// Summarises consecutive windows of <paramref name="window" /> samples.
+    /// </summary>
+    /// <remarks>
+    /// If <paramref name="cnt" /> is not a multiple of
+    /// <paramref name="window" />, the last window holds the remaining
+    /// samples only.
+    /// </remarks>
+    /// <param name="dst">Receives the statistics of the windows. This must be
+    /// large enough to hold the number of windows returned.</param>
+    /// <param name="src">The samples to be decimated.</param>
+    /// <param name="cnt">The number of samples in <paramref name="src" />.
+    /// </param>
+    /// <param name="window">The number of samples per window. A value of
+    /// zero is treated as one.</param>
+    /// <returns>The number of windows written to <paramref name="dst" />.
+    /// </returns>
+    std::size_t POWER_OVERWHELMING_API decimate_waveform(
+        _Out_writes_(return) waveform_window *dst,
+        _In_reads_(cnt) const float *src,
+        _In_ const std::size_t cnt,
+        _In_ std::size_t window) noexcept;
+
+    /// <summary>
+    /// Interpolates linearly between two values at equidistant positions.
+    /// </summary>
+    /// <remarks>
+    /// The <c>i</c>-th output is <c>lhs + (rhs - lhs) * (offset + i * step)
+    /// </c>, i.e. <paramref name="offset" /> and <paramref name="step" /> are
+    /// relative to the distance between the two values.
+    /// </remarks>
+    /// <param name="dst">Receives <paramref name="cnt" /> interpolated
+    /// values.</param>
+    /// <param name="cnt">The number of values to interpolate.</param>
+    /// <param name="lhs">The value at the relative position zero.</param>
+    /// <param name="rhs">The value at the relative position one.</param>
+    /// <param name="offset">The relative position of the first output.
+    /// </param>
+    /// <param name="step">The relative distance between two outputs.</param>
+    void POWER_OVERWHELMING_API interpolate_waveform(
+        _Out_writes_(cnt) float *dst,
+        _In_ const std::size_t cnt,
+        _In_ const float lhs,
+        _In_ const float rhs,
+        _In_ const float offset,
+        _In_ const float step) noexcept;
+
+    /// <summary>
+    /// Computes the running median of a waveform.
+    /// </summary>
+    /// <remarks>
+    /// The <c>i</c>-th output is the median of the <paramref name="window" />
+    /// samples starting at <c>src[i]</c>. Windows of up to
+    /// <see cref="max_vector_median" /> samples are sorted by a network of
+    /// minima and maxima that processes four windows at once.
+    /// <paramref name="dst" /> must not overlap with <paramref name="src" />.
+    /// </remarks>
+    /// <param name="dst">Receives <c>cnt - window + 1</c> medians, or
+    /// nothing if <paramref name="cnt" /> is less than
+    /// <paramref name="window" />.</param>
+    /// <param name="src">The samples to be filtered.</param>
+    /// <param name="cnt">The number of samples in <paramref name="src" />.
+    /// </param>
+    /// <param name="window">The number of samples per window, which must be
+    /// odd.</param>
+    /// <returns>The number of samples written to <paramref name="dst" />.
+    /// </returns>
+    std::size_t POWER_OVERWHELMING_API median_waveform(
+        _Out_writes_(return) float *dst,
+        _In_reads_(cnt) const float *src,
+        _In_ const std::size_t cnt,
+        _In_ const std::size_t window) noexcept;
+
+    /// <summary>
+    /// The largest window for which <see cref="median_waveform" /> uses the
+    /// vectorised sorting network.
+    /// </summary>
+    constexpr std::size_t max_vector_median = 15;
+
+    /// <summary>
+    /// Smoothes a waveform with an exponential moving average.
+    /// </summary>
+    /// <remarks>
+    /// The average is a recurrence, which cannot be vectorised along the
+    /// waveform. <paramref name="dst" /> may be the same as
+    /// <paramref name="src" />.
+    /// </remarks>
+    /// <param name="dst">Receives <paramref name="cnt" /> smoothed samples.
+    /// </param>
+    /// <param name="src">The samples to be smoothed.</param>
+    /// <param name="cnt">The number of samples to process.</param>
+    /// <param name="alpha">The weight of a new sample in the average.</param>
+    /// <param name="state">The previous average, which is updated to the
+    /// last output.</param>
+    void POWER_OVERWHELMING_API smooth_waveform(
+        _Out_writes_(cnt) float *dst,
+        _In_reads_(cnt) const float *src,
+        _In_ const std::size_t cnt,
+        _In_ const float alpha,
+        _Inout_ float& state) noexcept;
+
+    /// <summary>
+    /// Integrates the power samples using the trapezoidal rule.
+    /// </summary>
+    /// <param name="power">The power samples in Watts.</param>
+    /// <param name="cnt">The number of samples in <paramref name="power" />.
+    /// </param>
+    /// <param name="step">The distance between two samples in seconds.
+    /// </param>
+    /// <returns>The energy in Joules. If there are less than two samples, the
+    /// result is zero.</returns>
+    double POWER_OVERWHELMING_API waveform_energy(
+        _In_reads_(cnt) const float *power,
+        _In_ const std::size_t cnt,
+        _In_ const double step) noexcept;
+
+    /// <summary>
+    /// Computes the instantaneous power from the samples of a voltage and a
+    /// current channel.
+    /// </summary>
+    /// <remarks>
+    /// <paramref name="dst" /> may be the same as one of the inputs, but must
+    /// not partially overlap with them.
+    /// </remarks>
+    /// <param name="dst">Receives <paramref name="cnt" /> power samples.
+    /// </param>
+    /// <param name="voltage">The voltage samples.</param>
+    /// <param name="current">The current samples.</param>
+    /// <param name="cnt">The number of samples to process.</param>
+    void POWER_OVERWHELMING_API waveform_power(
+        _Out_writes_(cnt) float *dst,
+        _In_reads_(cnt) const float *voltage,
+        _In_reads_(cnt) const float *current,
+        _In_ const std::size_t cnt) noexcept;
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
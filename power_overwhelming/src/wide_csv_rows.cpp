@@ -0,0 +1,146 @@
+﻿// <copyright file="wide_csv_rows.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "wide_csv_rows.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+
+/*
+ * visus::power_overwhelming::detail::wide_csv_rows::wide_csv_rows
+ */
+visus::power_overwhelming::detail::wide_csv_rows::wide_csv_rows(void)
+        : _header(0), _hold(0), _marker(0), _marker_written(false),
+        _newest((std::numeric_limits<timestamp_type>::min)()), _step(0) { }
+
+
+/*
+ * visus::power_overwhelming::detail::wide_csv_rows::configure
+ */
+void visus::power_overwhelming::detail::wide_csv_rows::configure(
+        _In_ const timestamp_type step,
+        _In_ const timestamp_type hold) {
+    if (step < 0) {
+        throw std::invalid_argument("The step of the lines must not be "
+            "negative.");
+    }
+    if (hold < 0) {
+        throw std::invalid_argument("The hold time of the lines must not be "
+            "negative.");
+    }
+
+    this->_columns.clear();
+    this->_hold = hold;
+    this->_indices.clear();
+    this->_latest.clear();
+    this->_newest = (std::numeric_limits<timestamp_type>::min)();
+    this->_rows.clear();
+    this->_step = step;
+    this->restart();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::wide_csv_rows::flush
+ */
+void visus::power_overwhelming::detail::wide_csv_rows::flush(
+        _In_ csv_output_writer& dst, _In_ const bool all) {
+    auto end = this->_rows.end();
+
+    if (!all && !this->_rows.empty()) {
+        // A line is complete once every sensor has delivered a sample to a
+        // later line, because the samples of each sensor are ordered. Lines
+        // beyond the hold time are written anyway, because the sensor might
+        // have been paused or removed.
+        auto limit = *std::min_element(this->_latest.begin(),
+            this->_latest.end());
+        if (this->_newest - limit > this->_hold) {
+            limit = this->_newest - this->_hold;
+        }
+
+        end = this->_rows.lower_bound(limit);
+    }
+
+    if ((this->_rows.begin() != end)
+            && (this->_header < this->_columns.size())) {
+        dst.header(this->_columns.data(), this->_columns.size());
+        this->_header = this->_columns.size();
+    }
+
+    for (auto it = this->_rows.begin(); it != end; ++it) {
+        auto& row = it->second;
+        // Lines created before a sensor has been added lack its column.
+        row.values.resize(this->_columns.size(),
+            std::numeric_limits<float>::quiet_NaN());
+
+        const auto marker = (!this->_marker_written
+            || (row.marker != this->_marker));
+        dst.push(it->first, row.values.data(), row.values.size(),
+            marker ? &row.marker : nullptr);
+        this->_marker = row.marker;
+        this->_marker_written = true;
+
+        // Recycle the memory for the next lines.
+        this->_spare.push_back(std::move(row.values));
+    }
+
+    this->_rows.erase(this->_rows.begin(), end);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::wide_csv_rows::push
+ */
+void visus::power_overwhelming::detail::wide_csv_rows::push(
+        _In_ const measurement& sample,
+        _In_ const std::uint32_t marker) {
+    auto index = this->_indices.find(sample.sensor());
+    if (index == this->_indices.end()) {
+        index = this->_indices.emplace(sample.sensor(),
+            this->_columns.size()).first;
+        this->_columns.push_back(sample.sensor());
+        this->_latest.push_back((std::numeric_limits<timestamp_type>::min)());
+    }
+
+    auto timestamp = sample.timestamp();
+    if (this->_step > 0) {
+        // Round towards negative infinity, also for negative timestamps.
+        timestamp -= ((timestamp % this->_step) + this->_step) % this->_step;
+    }
+
+    auto& latest = this->_latest[index->second];
+    latest = (std::max)(latest, timestamp);
+    this->_newest = (std::max)(this->_newest, timestamp);
+
+    auto it = this->_rows.find(timestamp);
+    if (it == this->_rows.end()) {
+        it = this->_rows.emplace(timestamp, row_type()).first;
+        if (!this->_spare.empty()) {
+            it->second.values = std::move(this->_spare.back());
+            this->_spare.pop_back();
+            it->second.values.clear();
+        }
+    }
+
+    auto& row = it->second;
+    row.marker = marker;
+    row.values.resize(this->_columns.size(),
+        std::numeric_limits<float>::quiet_NaN());
+    if (sample) {
+        row.values[index->second] = sample.power();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::wide_csv_rows::restart
+ */
+void visus::power_overwhelming::detail::wide_csv_rows::restart(
+        void) noexcept {
+    this->_header = 0;
+    this->_marker_written = false;
+}
@@ -0,0 +1,129 @@
+﻿// <copyright file="wide_csv_rows.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "power_overwhelming/measurement.h"
+
+#include "csv_output.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Assembles the samples of all sensors into the lines of the wide CSV
+    /// layout, which has one line per tick and one column per sensor.
+    /// </summary>
+    /// <remarks>
+    /// <para>The timestamps of the samples are rounded down to a multiple of
+    /// the step, and all samples with the same rounded timestamp form a line.
+    /// If a sensor delivers multiple samples for a line, the last one is
+    /// retained. If the step is zero, only samples with the same timestamp
+    /// share a line, which is only sensible for samples on a common grid.
+    /// </para>
+    /// <para>The I/O thread retrieves the samples sensor by sensor, so the
+    /// lines are only written once all sensors have delivered a sample after
+    /// them or once they are older than the hold time. Samples arriving
+    /// after their line has been written start a new line with the same
+    /// timestamp.</para>
+    /// <para>The header is written before the first line and again if a
+    /// sensor has been added since. The marker is only written if it differs
+    /// from the one of the previous line.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API wide_csv_rows final {
+
+    public:
+
+        /// <summary>
+        /// The type of timestamps.
+        /// </summary>
+        typedef measurement::timestamp_type timestamp_type;
+
+        /// <summary>
+        /// Initialises a new instance, which writes one line per timestamp.
+        /// </summary>
+        wide_csv_rows(void);
+
+        /// <summary>
+        /// Sets the step of the lines and the hold time and forgets all
+        /// samples and sensors.
+        /// </summary>
+        /// <param name="step">The distance between two lines in ticks of the
+        /// timestamps, or zero for one line per timestamp.</param>
+        /// <param name="hold">The time in ticks of the timestamps for which a
+        /// line waits for sensors that have not yet delivered a sample after
+        /// it.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="step" /> or <paramref name="hold" /> is negative.
+        /// </exception>
+        void configure(_In_ const timestamp_type step,
+            _In_ const timestamp_type hold);
+
+        /// <summary>
+        /// Answer whether no line is pending.
+        /// </summary>
+        /// <returns><c>true</c> if all lines have been written,
+        /// <c>false</c> otherwise.</returns>
+        inline bool empty(void) const noexcept {
+            return this->_rows.empty();
+        }
+
+        /// <summary>
+        /// Writes the lines that are complete.
+        /// </summary>
+        /// <param name="dst">The writer receiving the lines.</param>
+        /// <param name="all">If <c>true</c>, all pending lines are written,
+        /// e.g. because the collector is stopping.</param>
+        void flush(_In_ csv_output_writer& dst, _In_ const bool all);
+
+        /// <summary>
+        /// Adds a sample.
+        /// </summary>
+        /// <param name="sample">The sample to be added. Invalid samples leave
+        /// the field of the sensor empty.</param>
+        /// <param name="marker">The ID of the marker active for the sample.
+        /// </param>
+        void push(_In_ const measurement& sample,
+            _In_ const std::uint32_t marker);
+
+        /// <summary>
+        /// Makes the next line written repeat the header and the marker, e.g.
+        /// because the output has been rotated.
+        /// </summary>
+        void restart(void) noexcept;
+
+    private:
+
+        /// <summary>
+        /// The content of a pending line.
+        /// </summary>
+        struct row_type {
+            std::uint32_t marker;
+            std::vector<float> values;
+        };
+
+        std::vector<const wchar_t *> _columns;
+        std::size_t _header;
+        timestamp_type _hold;
+        std::unordered_map<const wchar_t *, std::size_t> _indices;
+        std::vector<timestamp_type> _latest;
+        std::uint32_t _marker;
+        bool _marker_written;
+        timestamp_type _newest;
+        std::map<timestamp_type, row_type> _rows;
+        std::vector<std::vector<float>> _spare;
+        timestamp_type _step;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,388 @@
+﻿// <copyright file="writer_shard.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "writer_shard.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+#include <nlohmann/json.hpp>
+
+#include "power_overwhelming/convert_string.h"
+
+#include "library_thread.h"
+
+
+/*
+ * visus::power_overwhelming::detail::writer_shard::shard_path
+ */
+std::wstring visus::power_overwhelming::detail::writer_shard::shard_path(
+        _In_ const std::wstring& path, _In_ const std::size_t index) {
+    if (index == 0) {
+        return path;
+    }
+
+    const auto suffix = L".shard" + std::to_wstring(index);
+
+    // Only a dot in the file name starts the extension, and a leading dot
+    // marks a hidden file rather than an extension.
+    const auto separator = path.find_last_of(L"/\\");
+    const auto name = (separator == std::wstring::npos) ? 0 : separator + 1;
+    const auto dot = path.rfind(L'.');
+    if ((dot == std::wstring::npos) || (dot <= name)) {
+        return path + suffix;
+    }
+
+    auto retval = path;
+    retval.insert(dot, suffix);
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::writer_shard::write_manifest
+ */
+void visus::power_overwhelming::detail::writer_shard::write_manifest(
+        _In_ const std::wstring& path, _In_ const output_format format,
+        _In_ const std::size_t shards) {
+    nlohmann::json manifest;
+
+    switch (format) {
+        case output_format::binary:
+            manifest["format"] = "binary";
+            break;
+
+        case output_format::async_binary:
+            manifest["format"] = "async_binary";
+            break;
+
+        case output_format::direct_binary:
+            manifest["format"] = "direct_binary";
+            break;
+
+        case output_format::mapped_binary:
+            manifest["format"] = "mapped_binary";
+            break;
+
+        default:
+            manifest["format"] = "csv";
+            break;
+    }
+
+    // The paths are relative to the directory of the manifest if the
+    // output has been configured with a relative path, too.
+    manifest["shards"] = nlohmann::json::array();
+    for (std::size_t i = 0; i < shards; ++i) {
+        manifest["shards"].push_back(power_overwhelming::convert_string<char>(
+            shard_path(path, i)));
+    }
+
+    std::ofstream file;
+#if defined(_WIN32)
+    file.open(path + L".shards.json", std::ofstream::out
+        | std::ofstream::trunc);
+#else /* defined(_WIN32) */
+    file.open(power_overwhelming::convert_string<char>(path + L".shards.json"),
+        std::ofstream::out | std::ofstream::trunc);
+#endif /* defined(_WIN32) */
+    if (!file.is_open()) {
+        throw std::system_error(errno, std::system_category());
+    }
+
+    file << manifest.dump(4) << std::endl;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::writer_shard::writer_shard
+ */
+visus::power_overwhelming::detail::writer_shard::writer_shard(void)
+    : _binary(false), _declared(1), _have_header(false), _posted(false),
+        _require_marker(false), _running(false), _samples(nullptr),
+        _written(0) { }
+
+
+/*
+ * visus::power_overwhelming::detail::writer_shard::~writer_shard
+ */
+visus::power_overwhelming::detail::writer_shard::~writer_shard(void) {
+    this->stop();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::writer_shard::counts
+ */
+void visus::power_overwhelming::detail::writer_shard::counts(
+        _Inout_ std::unordered_map<const wchar_t *, std::uint64_t>& dst) const {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    for (auto& c : this->_counts) {
+        dst[c.first] += c.second;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::writer_shard::open
+ */
+void visus::power_overwhelming::detail::writer_shard::open(
+        _In_z_ const wchar_t *path, _In_ const output_format format,
+        _In_ const bool compressed) {
+    assert(!this->_thread.joinable());
+    this->_binary_stream.reset();
+    this->_stream.reset();
+
+    switch (format) {
+        case output_format::binary:
+        case output_format::mapped_binary:
+            this->_binary_stream.reset(new binary_output_writer());
+            this->_binary_stream->compressed(compressed);
+            this->_binary_stream->open(path,
+                (format == output_format::mapped_binary));
+            this->_binary = true;
+            break;
+
+        case output_format::async_binary:
+        case output_format::direct_binary:
+            this->_binary_stream.reset(new binary_output_writer());
+            this->_binary_stream->compressed(compressed);
+            this->_binary_stream->open_async(path,
+                (format == output_format::direct_binary));
+            this->_binary = true;
+            break;
+
+        case output_format::csv:
+            this->_stream.reset(new csv_output_writer());
+            this->_stream->open(path);
+            this->_binary = false;
+            break;
+
+        default:
+            throw std::invalid_argument("The output can only be sharded if it "
+                "is a CSV or a binary file.");
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::writer_shard::post
+ */
+void visus::power_overwhelming::detail::writer_shard::post(
+        _In_ const std::vector<std::wstring>& markers,
+        _In_ const std::vector<marker_event_type>& events,
+        _In_ const std::vector<buffer_type *>& buffers,
+        _In_ const std::vector<buffer_type::position_type>& ends,
+        _In_ const std::size_t first, _In_ const std::size_t stride) {
+    assert(buffers.size() == ends.size());
+    assert(stride > 0);
+
+    {
+        std::lock_guard<decltype(this->_lock)> l(this->_lock);
+        this->_markers.insert(this->_markers.end(), markers.begin(),
+            markers.end());
+        this->_pending.insert(this->_pending.end(), events.begin(),
+            events.end());
+
+        // Buffers are only ever added to the collector, so the ones assigned
+        // to the shard are the same as before plus the new ones. Their ends
+        // only grow, so the latest ones include all previous passes.
+        for (auto i = first, j = std::size_t(0); i < buffers.size();
+                i += stride, ++j) {
+            if (j < this->_buffers.size()) {
+                assert(this->_buffers[j].first == buffers[i]);
+                this->_buffers[j].second = ends[i];
+            } else {
+                this->_buffers.emplace_back(buffers[i], ends[i]);
+            }
+        }
+
+        this->_posted = true;
+    }
+
+    this->_cv.notify_one();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::writer_shard::start
+ */
+void visus::power_overwhelming::detail::writer_shard::start(
+        _In_ const timestamp_resolution resolution,
+        _In_ const std::vector<std::wstring>& names,
+        _In_ const start_record& start,
+        _In_ const bool require_marker,
+        _Inout_ std::atomic<std::uint64_t>& samples) {
+    assert(!this->_thread.joinable());
+    if (this->_binary) {
+        this->_binary_stream->header(resolution, names);
+        this->_binary_stream->start(start);
+    } else {
+        this->_stream->start(start);
+    }
+
+    this->_require_marker = require_marker;
+    this->_samples = std::addressof(samples);
+    this->_running = true;
+    this->_thread = std::thread(&writer_shard::run, this);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::writer_shard::stop
+ */
+void visus::power_overwhelming::detail::writer_shard::stop(void) {
+    {
+        std::lock_guard<decltype(this->_lock)> l(this->_lock);
+        this->_running = false;
+    }
+    this->_cv.notify_one();
+
+    if (this->_thread.joinable()) {
+        this->_thread.join();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::writer_shard::marker
+ */
+std::uint32_t visus::power_overwhelming::detail::writer_shard::marker(
+        _In_ const timestamp_type timestamp) const {
+    // Most samples are newer than the last marker, so we check this before
+    // searching the whole history.
+    if (this->_events.empty()) {
+        return 0;
+    } else if (timestamp >= this->_events.back().first) {
+        return this->_events.back().second;
+    }
+
+    auto it = std::upper_bound(this->_events.begin(), this->_events.end(),
+        timestamp, [](const timestamp_type lhs, const marker_event_type& rhs) {
+            return (lhs < rhs.first);
+        });
+    return (it != this->_events.begin()) ? (--it)->second : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::writer_shard::run
+ */
+void visus::power_overwhelming::detail::writer_shard::run(void) {
+    std::vector<std::pair<buffer_type *, buffer_type::position_type>> buffers;
+    std::unordered_map<const wchar_t *, std::uint64_t> counts;
+    std::vector<std::wstring> markers;
+    std::vector<marker_event_type> pending;
+    auto running = true;
+
+    enter_library_thread("PwrOwg Collector Writer Shard");
+
+    while (running) {
+        {
+            std::unique_lock<decltype(this->_lock)> l(this->_lock);
+            this->_cv.wait(l, [this](void) {
+                return (this->_posted || !this->_running);
+            });
+
+            // Everything posted before the shard has been stopped is written
+            // in the last pass.
+            running = this->_running;
+            this->_posted = false;
+            std::swap(markers, this->_markers);
+            std::swap(pending, this->_pending);
+            buffers = this->_buffers;
+        }
+
+        for (auto& m : markers) {
+            if (this->_binary) {
+                this->_binary_stream->marker(this->_declared++, m.c_str());
+            } else {
+                this->_stream->marker(this->_declared++, m.c_str());
+            }
+        }
+        markers.clear();
+
+        // Markers might be older than the ones we already have, so they are
+        // sorted in like on the writer thread of the collector.
+        for (auto& e : pending) {
+            if (this->_binary) {
+                this->_binary_stream->marker_event(e.first, e.second);
+            } else {
+                this->_stream->marker_event(e.first, e.second);
+            }
+
+            if (this->_events.empty()
+                    || (e.first >= this->_events.back().first)) {
+                this->_events.push_back(e);
+            } else {
+                auto it = std::upper_bound(this->_events.begin(),
+                    this->_events.end(), e.first,
+                    [](const timestamp_type lhs, const marker_event_type& rhs) {
+                        return (lhs < rhs.first);
+                    });
+                this->_events.insert(it, e);
+            }
+        }
+        pending.clear();
+
+        std::uint64_t retrieved = 0;
+        const wchar_t *counted_sensor = nullptr;
+        std::uint64_t *count = nullptr;
+        for (auto& b : buffers) {
+            b.first->drain([&](const measurement& s,
+                    const buffer_type::position_type) {
+                ++retrieved;
+                if (s.sensor() != counted_sensor) {
+                    counted_sensor = s.sensor();
+                    count = &counts[counted_sensor];
+                }
+                ++*count;
+
+                const auto m = this->marker(s.timestamp());
+                if (this->_require_marker && (m == 0)) {
+                    return;
+                }
+
+                if (this->_binary) {
+                    this->_binary_stream->push(s, m);
+                } else {
+                    if (!this->_have_header) {
+                        this->_have_header = true;
+                        this->_stream->header();
+                    }
+                    this->_stream->push(s, m);
+                }
+            }, b.second);
+        }
+        this->_samples->fetch_add(retrieved, std::memory_order_relaxed);
+
+        if (this->_binary) {
+            this->_binary_stream->flush();
+            this->_written.store(this->_binary_stream->written(),
+                std::memory_order_relaxed);
+        } else {
+            this->_stream->flush();
+            this->_written.store(this->_stream->written(),
+                std::memory_order_relaxed);
+        }
+
+        if (retrieved > 0) {
+            std::lock_guard<decltype(this->_lock)> l(this->_lock);
+            for (auto& c : counts) {
+                this->_counts[c.first] += c.second;
+            }
+        }
+        counts.clear();
+    }
+
+    if (this->_binary) {
+        this->_binary_stream->close();
+    } else {
+        this->_stream->close();
+    }
+}
@@ -0,0 +1,235 @@
+﻿// <copyright file="writer_shard.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <cinttypes>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "power_overwhelming/measurement.h"
+#include "power_overwhelming/output_format.h"
+#include "power_overwhelming/timestamp_resolution.h"
+
+#include "binary_output.h"
+#include "csv_output.h"
+#include "spsc_ring.h"
+#include "start_record.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Writes the samples of a subset of the buffers of a collector to a
+    /// separate output file on its own thread.
+    /// </summary>
+    /// <remarks>
+    /// <para>The writer thread of the collector remains in charge of
+    /// retrieving the markers and the ends of the buffers while holding the
+    /// lock of the collector, such that no sample can be drained without the
+    /// markers set before it was taken. It hands the ends of the buffers
+    /// assigned to the shard and a copy of all markers to the shard via
+    /// <see cref="post" />, and the shard drains the buffers, assigns the
+    /// markers and writes the samples while the collector continues with its
+    /// own buffers.</para>
+    /// <para>Each buffer must only ever be assigned to one shard, because the
+    /// buffers only support a single consumer.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API writer_shard final {
+
+    public:
+
+        /// <summary>
+        /// The type of the buffers the samples are drained from.
+        /// </summary>
+        typedef spsc_ring<measurement> buffer_type;
+
+        /// <summary>
+        /// The type of a timestamp.
+        /// </summary>
+        typedef measurement::timestamp_type timestamp_type;
+
+        /// <summary>
+        /// The time a marker has been set and its ID.
+        /// </summary>
+        typedef std::pair<timestamp_type, std::uint32_t> marker_event_type;
+
+        /// <summary>
+        /// Answer the path of the shard with the given index.
+        /// </summary>
+        /// <remarks>
+        /// The first shard with index zero uses the path as it is. The others
+        /// insert &quot;.shard&quot; and the index before the extension, such
+        /// that they keep the extension identifying their format.
+        /// </remarks>
+        /// <param name="path">The path configured for the output.</param>
+        /// <param name="index">The zero-based index of the shard.</param>
+        /// <returns>The path to the shard.</returns>
+        static std::wstring shard_path(_In_ const std::wstring& path,
+            _In_ const std::size_t index);
+
+        /// <summary>
+        /// Writes the manifest describing the shards of the given output.
+        /// </summary>
+        /// <remarks>
+        /// The manifest is a JSON file at the path of the output with
+        /// &quot;.shards.json&quot; appended, which holds the format and the
+        /// paths of all shards in the order of their indices.
+        /// </remarks>
+        /// <param name="path">The path configured for the output.</param>
+        /// <param name="format">The format of all shards.</param>
+        /// <param name="shards">The number of shards, including the first one
+        /// written by the collector itself.</param>
+        /// <exception cref="std::system_error">If the manifest could not be
+        /// written.</exception>
+        static void write_manifest(_In_ const std::wstring& path,
+            _In_ const output_format format, _In_ const std::size_t shards);
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        writer_shard(void);
+
+        writer_shard(const writer_shard&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        /// <remarks>
+        /// If the shard is still running, it is stopped, which writes the
+        /// samples posted to it.
+        /// </remarks>
+        ~writer_shard(void);
+
+        /// <summary>
+        /// Answer the number of samples the shard has written per sensor.
+        /// </summary>
+        /// <param name="dst">The map to which the counts are added.</param>
+        void counts(_Inout_ std::unordered_map<const wchar_t *,
+            std::uint64_t>& dst) const;
+
+        /// <summary>
+        /// Creates the output file of the shard.
+        /// </summary>
+        /// <param name="path">The path to the output file.</param>
+        /// <param name="format">The format of the output, which must be CSV
+        /// or one of the binary files.</param>
+        /// <param name="compressed">Whether the binary output is compressed.
+        /// </param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="format" /> is not supported.</exception>
+        /// <exception cref="std::system_error">If the file could not be
+        /// created.</exception>
+        void open(_In_z_ const wchar_t *path, _In_ const output_format format,
+            _In_ const bool compressed);
+
+        /// <summary>
+        /// Hands the given markers and the samples of every
+        /// <paramref name="stride" />-th buffer starting at
+        /// <paramref name="first" /> to the shard.
+        /// </summary>
+        /// <remarks>
+        /// The samples up to the given ends are written by the thread of the
+        /// shard. Ends posted before the shard has drained a buffer are
+        /// replaced by the new ones, which must not be smaller.
+        /// </remarks>
+        /// <param name="markers">The texts of the markers declared since the
+        /// previous call, which receive the IDs following the ones already
+        /// declared.</param>
+        /// <param name="events">The markers set since the previous call.
+        /// </param>
+        /// <param name="buffers">All buffers of the collector.</param>
+        /// <param name="ends">The positions up to which the buffers can be
+        /// drained, which must have as many elements as
+        /// <paramref name="buffers" />.</param>
+        /// <param name="first">The index of the first buffer assigned to the
+        /// shard.</param>
+        /// <param name="stride">The distance between the buffers assigned to
+        /// the shard.</param>
+        void post(_In_ const std::vector<std::wstring>& markers,
+            _In_ const std::vector<marker_event_type>& events,
+            _In_ const std::vector<buffer_type *>& buffers,
+            _In_ const std::vector<buffer_type::position_type>& ends,
+            _In_ const std::size_t first, _In_ const std::size_t stride);
+
+        /// <summary>
+        /// Writes the start of the output and starts the thread of the shard.
+        /// </summary>
+        /// <param name="resolution">The resolution of the timestamps.</param>
+        /// <param name="names">The names of the sensors declared in the header
+        /// of the binary output.</param>
+        /// <param name="start">The description of the start.</param>
+        /// <param name="require_marker">If <c>true</c>, samples taken while no
+        /// marker was set are discarded.</param>
+        /// <param name="samples">The counter of the collector to which the
+        /// number of samples drained is added.</param>
+        void start(_In_ const timestamp_resolution resolution,
+            _In_ const std::vector<std::wstring>& names,
+            _In_ const start_record& start,
+            _In_ const bool require_marker,
+            _Inout_ std::atomic<std::uint64_t>& samples);
+
+        /// <summary>
+        /// Writes the samples posted so far, stops the thread and closes the
+        /// output.
+        /// </summary>
+        void stop(void);
+
+        /// <summary>
+        /// Answer the number of bytes the shard has written.
+        /// </summary>
+        /// <returns>The size of the output in bytes.</returns>
+        inline std::uint64_t written(void) const noexcept {
+            return this->_written.load(std::memory_order_relaxed);
+        }
+
+        writer_shard& operator =(const writer_shard&) = delete;
+
+    private:
+
+        /// <summary>
+        /// Answer the ID of the marker that was set when the given sample was
+        /// taken.
+        /// </summary>
+        std::uint32_t marker(_In_ const timestamp_type timestamp) const;
+
+        /// <summary>
+        /// The body of the thread of the shard.
+        /// </summary>
+        void run(void);
+
+        bool _binary;
+        std::unique_ptr<binary_output_writer> _binary_stream;
+        std::vector<std::pair<buffer_type *, buffer_type::position_type>>
+            _buffers;
+        std::condition_variable _cv;
+        std::unordered_map<const wchar_t *, std::uint64_t> _counts;
+        std::uint32_t _declared;
+        std::vector<marker_event_type> _events;
+        bool _have_header;
+        mutable std::mutex _lock;
+        std::vector<std::wstring> _markers;
+        std::vector<marker_event_type> _pending;
+        bool _posted;
+        bool _require_marker;
+        bool _running;
+        std::atomic<std::uint64_t> *_samples;
+        std::unique_ptr<csv_output_writer> _stream;
+        std::thread _thread;
+        std::atomic<std::uint64_t> _written;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,104 @@
+﻿// <copyright file="probe_sensors.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/convert_string.h"
+#include "power_overwhelming/probe_sensors.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <tchar.h>
+#endif /* defined(_WIN32) */
+
+#if !defined(_tmain)
+#define _tmain main
+#define TCHAR char
+#define _T(x) (x)
+#endif /* !defined(_tmain) */
+
+
+/// <summary>
+/// Entry point of the probe_sensors application, which measures how fast the
+/// sensors on this machine can be sampled and writes a capability report that
+/// the collector can use to select safe sampling intervals.
+/// </summary>
+/// <param name="argc"></param>
+/// <param name="argv"></param>
+/// <returns></returns>
+int _tmain(const int argc, const TCHAR **argv) {
+    using namespace visus::power_overwhelming;
+
+    std::wcout << L"probe_sensors" << std::endl;
+    std::wcout << L"© 2023 Visualisierungsinstitut der Universität Stuttgart."
+        << std::endl << L"All rights reserved."
+        << std::endl << std::endl;
+
+    const std::vector<std::basic_string<TCHAR>> cmd_line(argv, argv + argc);
+    auto duration = default_probe_duration;
+    auto show_help = (argc < 2);
+
+    // The filter options all expect a pattern as their argument and the
+    // duration is given in milliseconds. The output path is the last argument.
+    sensor_filter filter;
+    for (auto it = cmd_line.begin(); it != cmd_line.end(); ++it) {
+        const auto is_device = (*it == _T("--device"));
+        const auto is_duration = (*it == _T("--duration"));
+        const auto is_name = (*it == _T("--name"));
+        const auto is_type = (*it == _T("--type"));
+
+        if (is_device || is_duration || is_name || is_type) {
+            if ((it + 2) >= cmd_line.end()) {
+                show_help = true;
+                break;
+            }
+
+            const auto value = convert_string<wchar_t>(*++it);
+            if (is_device) {
+                filter.device(value.c_str());
+            } else if (is_duration) {
+                try {
+                    duration = std::stoll(value) * 1000;
+                } catch (...) {
+                    duration = 0;
+                }
+                show_help = show_help || (duration <= 0);
+            } else if (is_name) {
+                filter.name(value.c_str());
+            } else {
+                filter.type(value.c_str());
+            }
+        }
+    }
+
+    if (show_help) {
+        // Input is wrong, so show the help.
+        std::wcout << L"Measures the sampling latency, the effective update "
+            << L"rate and the CPU time per" << std::endl
+            << L"sample of all sensors that are currently available on "
+            << L"this machine and writes" << std::endl
+            << L"a capability report to a JSON file, which can be passed "
+            << L"to the collector as" << std::endl
+            << L"\"capabilityReport\"." << std::endl << std::endl;
+        std::wcout << "Usage: probe_sensors [--type <regex>] [--name <regex>] "
+            << "[--device <regex>] [--duration <milliseconds>] <output path>"
+            << std::endl;
+        return -2;
+    }
+
+    try {
+        const auto path = cmd_line.back();
+        const auto cnt = probe_sensors(path, filter, duration);
+        std::wcout << cnt << ((cnt == 1) ? L" sensor" : L" sensors")
+            << L" probed into \"" << path.c_str() << L"\"." << std::endl;
+        return 0;
+    } catch (std::exception& ex) {
+        std::cout << ex.what() << std::endl;
+        return -1;
+    }
+}
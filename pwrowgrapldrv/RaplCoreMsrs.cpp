@@ -0,0 +1,104 @@
+﻿// <copyright file="RaplCoreMsrs.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include <intrin.h>
+
+#include "RaplCoreMsrs.h"
+#include "RaplMsr.h"
+#include "RaplThreadAffinity.h"
+
+
+/// <summary>
+/// The DPC routine reading all registers of the core the DPC has been
+/// targeted at.
+/// </summary>
+/// <param name="dpc"></param>
+/// <param name="deferredContext">The <see cref="RAPL_CORE_DPC" />.</param>
+/// <param name="systemArgument1">The <see cref="RAPL_CORE_MSRS_REQUEST" />.
+/// </param>
+/// <param name="systemArgument2"></param>
+_Function_class_(KDEFERRED_ROUTINE)
+_IRQL_requires_(DISPATCH_LEVEL)
+static void RaplReadCoreMsrsDpc(_In_ PKDPC dpc,
+        _In_opt_ PVOID deferredContext,
+        _In_opt_ PVOID systemArgument1,
+        _In_opt_ PVOID systemArgument2) noexcept {
+    UNREFERENCED_PARAMETER(dpc);
+    UNREFERENCED_PARAMETER(systemArgument2);
+    ASSERT(deferredContext != nullptr);
+    ASSERT(systemArgument1 != nullptr);
+
+    const auto core = static_cast<PRAPL_CORE_DPC>(deferredContext)->Core;
+    auto request = static_cast<PRAPL_CORE_MSRS_REQUEST>(systemArgument1);
+
+    for (SIZE_T i = 0; i < request->Count; ++i) {
+        if (request->Registers[i].Core == core) {
+            request->Values[i] = __readmsr(request->Registers[i].Register);
+        }
+    }
+
+    if (::InterlockedDecrement(&request->Pending) == 0) {
+        if (request->Written != nullptr) {
+            ::InterlockedIncrement64(request->Written);
+        }
+
+        // Signalling the event must be the last access to the request,
+        // because a waiting thread might free it once it was woken.
+        ::InterlockedExchange(&request->Busy, 0);
+        ::KeSetEvent(&request->Done, IO_NO_INCREMENT, FALSE);
+    }
+}
+
+
+/*
+ * ::RaplInitialiseCoreDpcs
+ */
+NTSTATUS RaplInitialiseCoreDpcs(
+        _In_reads_(cnt) const RAPL_CORE_MSR *registers,
+        _In_ const SIZE_T cnt,
+        _In_ const PRAPL_FILE_CONTEXT context,
+        _Out_writes_to_(cnt, cntDpcs) PRAPL_CORE_DPC dpcs,
+        _Out_ SIZE_T& cntDpcs) noexcept {
+    ASSERT(registers != nullptr);
+    ASSERT(context != nullptr);
+    ASSERT(dpcs != nullptr);
+    NTSTATUS status = STATUS_SUCCESS;
+
+    cntDpcs = 0;
+
+    for (SIZE_T i = 0; NT_SUCCESS(status) && (i < cnt); ++i) {
+        PROCESSOR_NUMBER processor;
+
+        if (!::RaplIsRegisterSupported(registers[i].Register, context->Msrs,
+                context->CountMsrs)) {
+            KdPrint(("[PWROWG] Register 0x%x is not supported on this "
+                "CPU.\r\n", registers[i].Register));
+            status = STATUS_END_OF_FILE;
+            break;
+        }
+
+        auto isNew = true;
+        for (SIZE_T j = 0; isNew && (j < cntDpcs); ++j) {
+            isNew = (dpcs[j].Core != registers[i].Core);
+        }
+
+        if (isNew) {
+            status = ::RaplGetProcessorNumber(registers[i].Core, &processor);
+            if (!NT_SUCCESS(status)) {
+                KdPrint(("[PWROWG] Core %d does not exist.\r\n",
+                    registers[i].Core));
+                break;
+            }
+
+            auto& dpc = dpcs[cntDpcs++];
+            dpc.Core = registers[i].Core;
+            ::KeInitializeDpc(&dpc.Dpc, ::RaplReadCoreMsrsDpc, &dpc);
+            ::KeSetImportanceDpc(&dpc.Dpc, HighImportance);
+            status = ::KeSetTargetProcessorDpcEx(&dpc.Dpc, &processor);
+        }
+    }
+
+    return status;
+}
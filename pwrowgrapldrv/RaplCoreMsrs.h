@@ -0,0 +1,112 @@
+﻿// <copyright file="RaplCoreMsrs.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <ntddk.h>
+#include <wdf.h>
+
+#include "RaplDriver.h"
+#include "RaplIoctl.h"
+
+
+/// <summary>
+/// The state shared by all DPCs reading the registers of a single
+/// <see cref="IOCTL_RAPL_READ_CORE_MSRS" /> request or of a single tick of a
+/// <see cref="IOCTL_RAPL_SAMPLE" /> request.
+/// </summary>
+typedef struct _RAPL_CORE_MSRS_REQUEST {
+    /// <summary>
+    /// The number of elements in <see cref="Registers" /> and
+    /// <see cref="Values" />.
+    /// </summary>
+    SIZE_T Count;
+
+    /// <summary>
+    /// Signalled by the last DPC that completes.
+    /// </summary>
+    KEVENT Done;
+
+    /// <summary>
+    /// Indicates that a tick of a sampler is in progress, which is cleared by
+    /// the last DPC after all values have been published.
+    /// </summary>
+    /// <remarks>
+    /// This flag is only used by periodic samplers, which must skip a tick if
+    /// the previous one has not yet completed.
+    /// </remarks>
+    volatile LONG Busy;
+
+    /// <summary>
+    /// The number of DPCs that have not yet completed.
+    /// </summary>
+    volatile LONG Pending;
+
+    /// <summary>
+    /// The registers to read, which must be in non-paged memory.
+    /// </summary>
+    _Field_size_(Count) const RAPL_CORE_MSR *Registers;
+
+    /// <summary>
+    /// Receives the values of the registers, which must be in non-paged
+    /// memory.
+    /// </summary>
+    _Field_size_(Count) unsigned __int64 *Values;
+
+    /// <summary>
+    /// If not <c>nullptr</c>, this counter is incremented by the last DPC
+    /// after all values have been written, which publishes them to a
+    /// consumer that does not wait for <see cref="Done" />.
+    /// </summary>
+    volatile LONG64 *Written;
+} RAPL_CORE_MSRS_REQUEST, *PRAPL_CORE_MSRS_REQUEST;
+
+
+/// <summary>
+/// A DPC reading the registers of a single core for a
+/// <see cref="RAPL_CORE_MSRS_REQUEST" />, which is passed as the first system
+/// argument when queueing the DPC.
+/// </summary>
+typedef struct _RAPL_CORE_DPC {
+    /// <summary>
+    /// The core the DPC is run on.
+    /// </summary>
+    __int32 Core;
+
+    /// <summary>
+    /// The DPC object itself.
+    /// </summary>
+    KDPC Dpc;
+} RAPL_CORE_DPC, *PRAPL_CORE_DPC;
+
+
+
+/// <summary>
+/// Checks all <paramref name="registers" /> and initialises one DPC for each
+/// distinct core among them.
+/// </summary>
+/// <remarks>
+/// The registers are checked before anything is read, because reading an
+/// invalid MSR would cause a bug check.
+/// </remarks>
+/// <param name="registers">The registers to be read, which must be in
+/// non-paged memory.</param>
+/// <param name="cnt">The number of elements in <paramref name="registers" />.
+/// </param>
+/// <param name="context">The context of the file the request was issued on,
+/// which determines the supported registers.</param>
+/// <param name="dpcs">Receives the DPCs. This array must be in non-paged
+/// memory and hold at least <paramref name="cnt" /> elements.</param>
+/// <param name="cntDpcs">Receives the number of DPCs that have been
+/// initialised.</param>
+/// <returns><c>STATUS_SUCCESS</c> in case of success,
+/// <c>STATUS_END_OF_FILE</c> if any of the registers is not supported,
+/// <c>STATUS_NOT_FOUND</c> if any of the cores does not exist.</returns>
+NTSTATUS RaplInitialiseCoreDpcs(
+    _In_reads_(cnt) const RAPL_CORE_MSR *registers,
+    _In_ const SIZE_T cnt,
+    _In_ const PRAPL_FILE_CONTEXT context,
+    _Out_writes_to_(cnt, cntDpcs) PRAPL_CORE_DPC dpcs,
+    _Out_ SIZE_T& cntDpcs) noexcept;
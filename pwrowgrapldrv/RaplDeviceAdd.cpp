@@ -64,7 +64,7 @@ extern "C" NTSTATUS RaplDeviceAdd(_In_ WDFDRIVER driver,
         WDF_OBJECT_ATTRIBUTES_INIT_CONTEXT_TYPE(&fileAttributes,
             RAPL_FILE_CONTEXT);
         ::WDF_FILEOBJECT_CONFIG_INIT(&fileConfig, ::RaplCreate, ::RaplClose,
-            WDF_NO_EVENT_CALLBACK);
+            ::RaplFileCleanup);
         ::WdfDeviceInitSetFileObjectConfig(deviceInit, &fileConfig,
             &fileAttributes);
     }
@@ -101,6 +101,7 @@ extern "C" NTSTATUS RaplDeviceAdd(_In_ WDFDRIVER driver,
         WDF_IO_QUEUE_CONFIG_INIT_DEFAULT_QUEUE(&ioQueueConfig,
             WdfIoQueueDispatchSequential);
         ioQueueConfig.EvtIoRead = ::RaplRead;
+        ioQueueConfig.EvtIoDeviceControl = ::RaplDeviceControl;
 
         WDF_OBJECT_ATTRIBUTES_INIT(&attributes);
         // When reading the MSRs, we need to set the thread affinity to the
@@ -128,6 +129,28 @@ extern "C" NTSTATUS RaplDeviceAdd(_In_ WDFDRIVER driver,
         __analysis_assume(ioQueueConfig.EvtIoStop == 0);
     }
 
+    if (NT_SUCCESS(status)) {
+        // Create the manual queue, which holds the pending sampling requests.
+        // This is necessary, because the default queue is sequential and
+        // would not dispatch any other request while a sampler is running.
+        WDF_OBJECT_ATTRIBUTES attributes{ 0 };
+        WDF_IO_QUEUE_CONFIG ioQueueConfig{ 0 };
+        WDF_IO_QUEUE_CONFIG_INIT(&ioQueueConfig, WdfIoQueueDispatchManual);
+        ioQueueConfig.EvtIoCanceledOnQueue = ::RaplSamplingCanceled;
+        ioQueueConfig.PowerManaged = WdfFalse;
+
+        WDF_OBJECT_ATTRIBUTES_INIT(&attributes);
+        // Stopping a sampler waits for its timer and DPCs, which requires
+        // the cancellation callback to be called at passive level.
+        attributes.ExecutionLevel = WdfExecutionLevelPassive;
+
+        auto context = ::GetRaplDeviceContext(device);
+        ASSERT(context != nullptr);
+        status = ::WdfIoQueueCreate(device, &ioQueueConfig, &attributes,
+            &context->SamplingQueue);
+    }
+    KdPrint(("[PWROWG] Sampling queue creation result: 0x%x\r\n", status));
+
     if (NT_SUCCESS(status)) {
         // Initialise the global state of the device.
         // As the driver object must exist at least as long as the device
@@ -0,0 +1,277 @@
+﻿// <copyright file="RaplDeviceControl.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include <intrin.h>
+#include <ntddk.h>
+#include <wdf.h>
+
+#include "RaplCoreMsrs.h"
+#include "RaplDriver.h"
+#include "RaplIoctl.h"
+#include "RaplMsr.h"
+#include "RaplSampling.h"
+#include "RaplThreadAffinity.h"
+
+
+/// <summary>
+/// Handles <see cref="IOCTL_RAPL_READ_CORE_MSRS" />, which reads the
+/// registers of all cores given in the input buffer by queueing a DPC on each
+/// of these cores.
+/// </summary>
+/// <param name="request"></param>
+/// <param name="context"></param>
+/// <param name="inputLength"></param>
+/// <param name="outputLength"></param>
+/// <param name="bytesRead"></param>
+/// <returns></returns>
+static NTSTATUS RaplReadCoreMsrs(_In_ WDFREQUEST request,
+        _In_ const PRAPL_FILE_CONTEXT context,
+        _In_ const SIZE_T inputLength,
+        _In_ const SIZE_T outputLength,
+        _Out_ SIZE_T& bytesRead) noexcept {
+    ASSERT(context != nullptr);
+    SIZE_T cntDpcs = 0;
+    PRAPL_CORE_DPC dpcs = nullptr;
+    PVOID input = nullptr;
+    PVOID output = nullptr;
+    PRAPL_CORE_MSR registers = nullptr;
+    NTSTATUS status = STATUS_SUCCESS;
+
+    bytesRead = 0;
+
+    const auto cnt = inputLength / sizeof(RAPL_CORE_MSR);
+    if ((cnt == 0) || (inputLength % sizeof(RAPL_CORE_MSR) != 0)) {
+        KdPrint(("[PWROWG] Invalid size of core register list: %Iu\r\n",
+            inputLength));
+        status = STATUS_INVALID_PARAMETER;
+    }
+
+    if (NT_SUCCESS(status) && (outputLength < cnt * sizeof(unsigned __int64))) {
+        KdPrint(("[PWROWG] Output too small for %Iu registers\r\n", cnt));
+        status = STATUS_BUFFER_TOO_SMALL;
+    }
+
+    if (NT_SUCCESS(status)) {
+        status = ::WdfRequestRetrieveInputBuffer(request, inputLength, &input,
+            nullptr);
+    }
+
+    if (NT_SUCCESS(status)) {
+        status = ::WdfRequestRetrieveOutputBuffer(request,
+            cnt * sizeof(unsigned __int64), &output, nullptr);
+    }
+
+    // The DPCs run at DISPATCH_LEVEL, so everything they access must be in
+    // non-paged memory, which the system buffer for METHOD_BUFFERED is. As for
+    // IOCTL_RAPL_READ_MSRS, we must copy the input before writing any results,
+    // because input and output share the system buffer.
+    if (NT_SUCCESS(status)) {
+        registers = static_cast<PRAPL_CORE_MSR>(::ExAllocatePoolWithTag(
+            NonPagedPoolNx, inputLength, RAPL_POOL_TAG));
+        dpcs = static_cast<PRAPL_CORE_DPC>(::ExAllocatePoolWithTag(
+            NonPagedPoolNx, cnt * sizeof(RAPL_CORE_DPC), RAPL_POOL_TAG));
+
+        if ((registers == nullptr) || (dpcs == nullptr)) {
+            status = STATUS_INSUFFICIENT_RESOURCES;
+        } else {
+            ::RtlCopyMemory(registers, input, inputLength);
+        }
+    }
+
+    if (NT_SUCCESS(status)) {
+        status = ::RaplInitialiseCoreDpcs(registers, cnt, context, dpcs,
+            cntDpcs);
+    }
+
+    if (NT_SUCCESS(status)) {
+        RAPL_CORE_MSRS_REQUEST state;
+        state.Busy = 0;
+        state.Count = cnt;
+        state.Pending = static_cast<LONG>(cntDpcs);
+        state.Registers = registers;
+        state.Values = static_cast<unsigned __int64 *>(output);
+        state.Written = nullptr;
+        ::KeInitializeEvent(&state.Done, NotificationEvent, FALSE);
+
+        KdPrint(("[PWROWG] Queueing %Iu DPC(s) for %Iu register(s).\r\n",
+            cntDpcs, cnt));
+        for (SIZE_T i = 0; i < cntDpcs; ++i) {
+            ::KeInsertQueueDpc(&dpcs[i].Dpc, &state, nullptr);
+        }
+
+        // Wait in kernel mode such that the stack holding 'state' cannot be
+        // paged out while the DPCs are using it.
+        ::KeWaitForSingleObject(&state.Done, Executive, KernelMode, FALSE,
+            nullptr);
+
+        bytesRead = cnt * sizeof(unsigned __int64);
+    }
+
+    if (dpcs != nullptr) {
+        ::ExFreePoolWithTag(dpcs, RAPL_POOL_TAG);
+    }
+    if (registers != nullptr) {
+        ::ExFreePoolWithTag(registers, RAPL_POOL_TAG);
+    }
+
+    return status;
+}
+
+
+/// <summary>
+/// Handles <see cref="IOCTL_RAPL_READ_MSRS" />, which reads all registers
+/// given in the input buffer while the thread affinity is set only once.
+/// </summary>
+/// <param name="request"></param>
+/// <param name="context"></param>
+/// <param name="inputLength"></param>
+/// <param name="outputLength"></param>
+/// <param name="bytesRead"></param>
+/// <returns></returns>
+static NTSTATUS RaplReadMsrs(_In_ WDFREQUEST request,
+        _In_ const PRAPL_FILE_CONTEXT context,
+        _In_ const SIZE_T inputLength,
+        _In_ const SIZE_T outputLength,
+        _Out_ SIZE_T& bytesRead) noexcept {
+    ASSERT(context != nullptr);
+    PVOID input = nullptr;
+    PVOID output = nullptr;
+    GROUP_AFFINITY originalAffinity { 0 };
+    NTSTATUS status = STATUS_SUCCESS;
+
+    bytesRead = 0;
+
+    // Each register index must be matched by a 64-bit value in the output.
+    const auto cnt = inputLength / sizeof(unsigned __int32);
+    if ((cnt == 0) || (inputLength % sizeof(unsigned __int32) != 0)) {
+        KdPrint(("[PWROWG] Invalid size of register list: %Iu\r\n",
+            inputLength));
+        status = STATUS_INVALID_PARAMETER;
+    }
+
+    if (NT_SUCCESS(status) && (outputLength < cnt * sizeof(unsigned __int64))) {
+        KdPrint(("[PWROWG] Output too small for %Iu registers\r\n", cnt));
+        status = STATUS_BUFFER_TOO_SMALL;
+    }
+
+    if (NT_SUCCESS(status)) {
+        status = ::WdfRequestRetrieveInputBuffer(request, inputLength, &input,
+            nullptr);
+    }
+
+    if (NT_SUCCESS(status)) {
+        status = ::WdfRequestRetrieveOutputBuffer(request,
+            cnt * sizeof(unsigned __int64), &output, nullptr);
+    }
+
+    // Check all registers before reading anything, because reading an invalid
+    // MSR would cause a bug check. Note that for METHOD_BUFFERED, input and
+    // output share the same system buffer, so we must copy the indices before
+    // writing any results.
+    unsigned __int32 *registers = nullptr;
+    if (NT_SUCCESS(status)) {
+        registers = static_cast<unsigned __int32 *>(::ExAllocatePoolWithTag(
+            PagedPool, inputLength, RAPL_POOL_TAG));
+        if (registers == nullptr) {
+            status = STATUS_INSUFFICIENT_RESOURCES;
+        } else {
+            ::RtlCopyMemory(registers, input, inputLength);
+        }
+    }
+
+    for (SIZE_T i = 0; NT_SUCCESS(status) && (i < cnt); ++i) {
+        if (!::RaplIsRegisterSupported(registers[i], context->Msrs,
+                context->CountMsrs)) {
+            KdPrint(("[PWROWG] Register 0x%x is not supported on this "
+                "CPU.\r\n", registers[i]));
+            status = STATUS_END_OF_FILE;
+        }
+    }
+
+    if (NT_SUCCESS(status)) {
+        status = ::RaplSetThreadAffinity(context->Core, &originalAffinity);
+    }
+
+    if (NT_SUCCESS(status)) {
+        auto dst = static_cast<unsigned __int64 *>(output);
+        for (SIZE_T i = 0; i < cnt; ++i) {
+            dst[i] = __readmsr(registers[i]);
+        }
+
+        KdPrint(("[PWROWG] Restoring original thread affinity.\r\n"));
+        ::KeSetSystemGroupAffinityThread(&originalAffinity, nullptr);
+        bytesRead = cnt * sizeof(unsigned __int64);
+    }
+
+    if (registers != nullptr) {
+        ::ExFreePoolWithTag(registers, RAPL_POOL_TAG);
+    }
+
+    return status;
+}
+
+
+/// <summary>
+/// This event is called when the framework receives
+/// <c>IRP_MJ_DEVICE_CONTROL</c> requests. In addition to reading single
+/// registers via <see cref="RaplRead" />, this allows for reading all
+/// registers of a core or of multiple cores in a single round trip.
+/// </summary>
+/// <param name="queue"></param>
+/// <param name="request"></param>
+/// <param name="outputLength"></param>
+/// <param name="inputLength"></param>
+/// <param name="ioControlCode"></param>
+extern "C" void RaplDeviceControl(_In_ WDFQUEUE queue,
+        _In_ WDFREQUEST request, _In_ SIZE_T outputLength,
+        _In_ SIZE_T inputLength, _In_ ULONG ioControlCode) noexcept {
+    ASSERT(queue != nullptr);
+    ASSERT(request != nullptr);
+    PAGED_CODE();
+
+    SIZE_T bytesRead = 0;
+    NTSTATUS status = STATUS_SUCCESS;
+
+    KdPrint(("[PWROWG] RaplDeviceControl enter\r\n"));
+
+    const auto file = ::WdfRequestGetFileObject(request);
+    ASSERT(file != nullptr);
+    const auto context = ::GetRaplFileContext(file);
+    ASSERT(context != nullptr);
+
+    switch (ioControlCode) {
+        case IOCTL_RAPL_READ_MSRS:
+            status = ::RaplReadMsrs(request, context, inputLength,
+                outputLength, bytesRead);
+            break;
+
+        case IOCTL_RAPL_READ_CORE_MSRS:
+            status = ::RaplReadCoreMsrs(request, context, inputLength,
+                outputLength, bytesRead);
+            break;
+
+        case IOCTL_RAPL_SAMPLE:
+            status = ::RaplStartSampling(request,
+                ::GetRaplDeviceContext(::WdfIoQueueGetDevice(queue)),
+                context, inputLength, outputLength);
+            break;
+
+        default:
+            status = STATUS_INVALID_DEVICE_REQUEST;
+            break;
+    }
+
+    KdPrint(("[PWROWG] Complete device control with 0x%x\r\n", status));
+    if (status == STATUS_PENDING) {
+        // The request has been forwarded to another queue and is completed
+        // once it is cancelled.
+        return;
+
+    } else if (NT_SUCCESS(status)) {
+        ::WdfRequestCompleteWithInformation(request, status, bytesRead);
+    } else {
+        ::WdfRequestComplete(request, status);
+    }
+}
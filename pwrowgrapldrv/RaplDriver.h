@@ -35,11 +35,21 @@ typedef struct _RAPL_DEVICE_CONTEXT {
     /// driver-global information when working with a device.
     /// </summary>
     PRAPL_DRIVER_CONTEXT DriverContext;
+
+    /// <summary>
+    /// The manual queue holding the pending <c>IOCTL_RAPL_SAMPLE</c>
+    /// requests while their samplers are running.
+    /// </summary>
+    WDFQUEUE SamplingQueue;
 } RAPL_DEVICE_CONTEXT, *PRAPL_DEVICE_CONTEXT;
 
 WDF_DECLARE_CONTEXT_TYPE_WITH_NAME(RAPL_DEVICE_CONTEXT, GetRaplDeviceContext)
 
 
+/* Forward declarations. */
+struct _RAPL_SAMPLER;
+
+
 /// <summary>
 /// A context we attach to the file object we get from the KMDF, which allows us
 /// restoring the thread affinity of the core which was requested in the call to
@@ -64,6 +74,12 @@ typedef struct _RAPL_FILE_CONTEXT {
     /// The register indices of the MSRs we found valid for the specified core.
     /// </summary>
     _Field_size_(CountMsrs) unsigned __int32 *Msrs;
+
+    /// <summary>
+    /// The sampler of the <c>IOCTL_RAPL_SAMPLE</c> request issued on the
+    /// file, or <c>nullptr</c> if the file is not sampling.
+    /// </summary>
+    struct _RAPL_SAMPLER *volatile Sampler;
 } RAPL_FILE_CONTEXT, *PRAPL_FILE_CONTEXT;
 
 WDF_DECLARE_CONTEXT_TYPE_WITH_NAME(RAPL_FILE_CONTEXT, GetRaplFileContext)
@@ -81,8 +97,11 @@ extern "C" EVT_WDF_FILE_CLOSE RaplClose;
 extern "C" EVT_WDF_DEVICE_FILE_CREATE RaplCreate;
 // We should not declare this as EVT_WDF_DRIVER_DEVICE_ADD according to
 // https://github.com/microsoft/Windows-driver-samples/blob/main/general/ioctl/kmdf/sys/nonpnp.h
+extern "C" EVT_WDF_IO_QUEUE_IO_DEVICE_CONTROL RaplDeviceControl;
 extern "C" NTSTATUS RaplDeviceAdd(_In_ WDFDRIVER driver,
     _In_ PWDFDEVICE_INIT deviceInit);
 extern "C" EVT_WDF_DRIVER_UNLOAD RaplDriverUnload;
+extern "C" EVT_WDF_FILE_CLEANUP RaplFileCleanup;
 extern "C" EVT_WDF_IO_QUEUE_IO_READ RaplRead;
+extern "C" EVT_WDF_IO_QUEUE_IO_CANCELED_ON_QUEUE RaplSamplingCanceled;
 extern "C" EVT_WDF_DEVICE_SHUTDOWN_NOTIFICATION RaplShutdown;
@@ -0,0 +1,156 @@
+﻿// <copyright file="RaplIoctl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+
+/// <summary>
+/// The device type we use for our custom I/O control codes.
+/// </summary>
+#define RAPL_DEVICE_TYPE (0x8000)
+
+/// <summary>
+/// Reads multiple MSRs of the core represented by the file in a single
+/// request.
+/// </summary>
+/// <remarks>
+/// <para>The input buffer is an array of <c>unsigned __int32</c> register
+/// indices, the output buffer receives one <c>unsigned __int64</c> per input
+/// register in the same order. The request fails with
+/// <c>STATUS_END_OF_FILE</c> if any of the registers is not supported, which
+/// is the same behaviour as for reading a single register.</para>
+/// <para>The user-mode library uses the same code in <c>msr_device.cpp</c>,
+/// so both must be changed together.</para>
+/// </remarks>
+#define IOCTL_RAPL_READ_MSRS CTL_CODE(RAPL_DEVICE_TYPE, 0x800,\
+    METHOD_BUFFERED, FILE_READ_ACCESS)
+
+/// <summary>
+/// Reads MSRs of arbitrary cores in a single request.
+/// </summary>
+/// <remarks>
+/// <para>The input buffer is an array of <see cref="RAPL_CORE_MSR" />, the
+/// output buffer receives one <c>unsigned __int64</c> per input element in
+/// the same order. The driver queues one DPC for each distinct core in the
+/// input, which reads all registers requested from this core, and completes
+/// the request once all of them have run. This way, the registers of all
+/// cores of the machine can be sampled with a single system call and without
+/// changing the affinity of the calling thread.</para>
+/// <para>The registers are checked against the list of registers supported by
+/// the core of the file the request is issued on, i.e. the driver assumes all
+/// cores of the machine to support the same RAPL MSRs. The request fails with
+/// <c>STATUS_END_OF_FILE</c> if any of the registers is not supported and with
+/// <c>STATUS_NOT_FOUND</c> if any of the cores does not exist.</para>
+/// <para>The user-mode library uses the same code and layout in
+/// <c>msr_device.cpp</c>, so both must be changed together.</para>
+/// </remarks>
+#define IOCTL_RAPL_READ_CORE_MSRS CTL_CODE(RAPL_DEVICE_TYPE, 0x801,\
+    METHOD_BUFFERED, FILE_READ_ACCESS)
+
+
+/// <summary>
+/// Identifies a register of a specific core in a
+/// <see cref="IOCTL_RAPL_READ_CORE_MSRS" /> request.
+/// </summary>
+typedef struct _RAPL_CORE_MSR {
+    /// <summary>
+    /// The zero-based index of the logical CPU to read the register of.
+    /// </summary>
+    __int32 Core;
+
+    /// <summary>
+    /// The index of the MSR to read.
+    /// </summary>
+    unsigned __int32 Register;
+} RAPL_CORE_MSR, *PRAPL_CORE_MSR;
+
+/// <summary>
+/// Starts periodically sampling MSRs of arbitrary cores in the kernel, which
+/// writes the readings to a ring buffer shared with the caller.
+/// </summary>
+/// <remarks>
+/// <para>The input buffer is a <see cref="RAPL_SAMPLING_CONFIG" /> followed by
+/// the registers to sample. The output buffer, which is locked by the I/O
+/// manager as it is transferred directly, becomes the ring: It starts with a
+/// <see cref="RAPL_SAMPLE_RING" /> header, followed by as many records of the
+/// size <see cref="RAPL_SAMPLE_RECORD_SIZE" /> as fit into the buffer. Each
+/// record is the <c>FILETIME</c> of the tick followed by the values of the
+/// registers in the order of the input.</para>
+/// <para>The driver samples the registers on a high-resolution timer and
+/// increments <see cref="RAPL_SAMPLE_RING::Written" /> after each record is
+/// complete, i.e. the caller can consume the records without any system
+/// call. The request remains pending until it is cancelled or the file is
+/// closed, and it must therefore be issued on a file opened for overlapped
+/// I/O. Only one request can be active per file.</para>
+/// <para>The registers are checked like for
+/// <see cref="IOCTL_RAPL_READ_CORE_MSRS" />.</para>
+/// <para>The user-mode library uses the same code and layout in
+/// <c>msr_kernel_sampler.cpp</c>, so both must be changed together.</para>
+/// </remarks>
+#define IOCTL_RAPL_SAMPLE CTL_CODE(RAPL_DEVICE_TYPE, 0x802,\
+    METHOD_OUT_DIRECT, FILE_READ_ACCESS)
+
+
+/// <summary>
+/// The shortest sampling period in microseconds the driver accepts for
+/// <see cref="IOCTL_RAPL_SAMPLE" />.
+/// </summary>
+#define RAPL_MIN_SAMPLING_PERIOD (50)
+
+
+/// <summary>
+/// The input of <see cref="IOCTL_RAPL_SAMPLE" />.
+/// </summary>
+typedef struct _RAPL_SAMPLING_CONFIG {
+    /// <summary>
+    /// The sampling period in microseconds.
+    /// </summary>
+    unsigned __int32 Period;
+
+    /// <summary>
+    /// Reserved for future use, must be zero.
+    /// </summary>
+    unsigned __int32 Reserved;
+
+    /// <summary>
+    /// The registers to sample, which fill the rest of the input buffer.
+    /// </summary>
+    RAPL_CORE_MSR Registers[1];
+} RAPL_SAMPLING_CONFIG, *PRAPL_SAMPLING_CONFIG;
+
+
+/// <summary>
+/// The header of the ring buffer filled by <see cref="IOCTL_RAPL_SAMPLE" />.
+/// </summary>
+typedef struct _RAPL_SAMPLE_RING {
+    /// <summary>
+    /// The total number of records written, i.e. the most recent record is at
+    /// index <c>(Written - 1) % Capacity</c>.
+    /// </summary>
+    volatile __int64 Written;
+
+    /// <summary>
+    /// The number of ticks that have been skipped, because the registers of
+    /// the previous tick were still being read.
+    /// </summary>
+    volatile __int64 Missed;
+
+    /// <summary>
+    /// The number of records in the ring.
+    /// </summary>
+    unsigned __int32 Capacity;
+
+    /// <summary>
+    /// The number of registers in each record.
+    /// </summary>
+    unsigned __int32 CountRegisters;
+} RAPL_SAMPLE_RING, *PRAPL_SAMPLE_RING;
+
+
+/// <summary>
+/// Computes the size in bytes of a record in a
+/// <see cref="RAPL_SAMPLE_RING" /> holding <paramref name="cnt" /> registers.
+/// </summary>
+#define RAPL_SAMPLE_RECORD_SIZE(cnt) ((1 + (cnt)) * sizeof(unsigned __int64))
@@ -43,13 +43,15 @@ extern "C" void RaplRead(_In_ WDFQUEUE queue, _In_ WDFREQUEST request,
     const auto context = ::GetRaplFileContext(file);
     ASSERT(context != nullptr);
 
-    // Get the current file pointer from the file object.
-    const auto fileObject = ::WdfFileObjectWdmGetFileObject(file);
-    auto offset = fileObject->CurrentByteOffset;
-    //// Get the request parameters which hold the offset into the file, which we
-    //// interpret as the register number,
-    //::WdfRequestGetParameters(request, &parameters);
-    //const auto offset = parameters.Parameters.Read.DeviceOffset;
+    // Get the request parameters which hold the offset into the file, which we
+    // interpret as the register number. For synchronous handles, the I/O
+    // manager fills this with the current file pointer unless the caller
+    // provided an explicit offset, which allows user mode to read a register
+    // in a single call rather than seeking first.
+    ::WDF_REQUEST_PARAMETERS_INIT(&parameters);
+    ::WdfRequestGetParameters(request, &parameters);
+    LARGE_INTEGER offset;
+    offset.QuadPart = parameters.Parameters.Read.DeviceOffset;
     KdPrint(("[PWROWG] RAPL request offset 0x%I64x\r\n", offset.QuadPart));
 
     if (NT_SUCCESS(status) && (offset.HighPart != 0)) {
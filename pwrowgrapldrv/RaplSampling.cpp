@@ -0,0 +1,285 @@
+﻿// <copyright file="RaplSampling.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "RaplSampling.h"
+
+
+/// <summary>
+/// Frees all memory of <paramref name="sampler" />, which must not be running.
+/// </summary>
+/// <param name="sampler"></param>
+static void RaplFreeSampler(_In_opt_ PRAPL_SAMPLER sampler) noexcept {
+    if (sampler != nullptr) {
+        if (sampler->Dpcs != nullptr) {
+            ::ExFreePoolWithTag(sampler->Dpcs, RAPL_POOL_TAG);
+        }
+        if (sampler->Registers != nullptr) {
+            ::ExFreePoolWithTag(sampler->Registers, RAPL_POOL_TAG);
+        }
+
+        ::ExFreePoolWithTag(sampler, RAPL_POOL_TAG);
+    }
+}
+
+
+/// <summary>
+/// The callback of the high-resolution timer of a sampler, which starts a new
+/// record and queues the DPCs reading its registers.
+/// </summary>
+/// <param name="timer"></param>
+/// <param name="context">The <see cref="RAPL_SAMPLER" />.</param>
+_Function_class_(EXT_CALLBACK)
+_IRQL_requires_(DISPATCH_LEVEL)
+static void RaplSampleTick(_In_ PEX_TIMER timer,
+        _In_opt_ PVOID context) noexcept {
+    UNREFERENCED_PARAMETER(timer);
+    ASSERT(context != nullptr);
+    auto sampler = static_cast<PRAPL_SAMPLER>(context);
+    auto ring = sampler->Ring;
+
+    // If the DPCs of the previous tick have not completed, we skip this one,
+    // because there is only one record being written at any time.
+    if (::InterlockedCompareExchange(&sampler->Tick.Busy, 1, 0) != 0) {
+        ::InterlockedIncrement64(&ring->Missed);
+        return;
+    }
+
+    // The record is only visible to the caller once the last DPC has
+    // incremented 'Written', so we can prepare it without synchronisation.
+    const auto slot = static_cast<SIZE_T>(ring->Written % ring->Capacity);
+    auto record = reinterpret_cast<unsigned __int64 *>(sampler->Records
+        + slot * RAPL_SAMPLE_RECORD_SIZE(ring->CountRegisters));
+
+    LARGE_INTEGER now;
+    ::KeQuerySystemTimePrecise(&now);
+    record[0] = now.QuadPart;
+
+    sampler->Tick.Pending = static_cast<LONG>(sampler->CountDpcs);
+    sampler->Tick.Values = record + 1;
+
+    for (SIZE_T i = 0; i < sampler->CountDpcs; ++i) {
+        ::KeInsertQueueDpc(&sampler->Dpcs[i].Dpc, &sampler->Tick, nullptr);
+    }
+}
+
+
+/*
+ * ::RaplStartSampling
+ */
+NTSTATUS RaplStartSampling(_In_ WDFREQUEST request,
+        _In_ const PRAPL_DEVICE_CONTEXT deviceContext,
+        _In_ const PRAPL_FILE_CONTEXT context,
+        _In_ const SIZE_T inputLength,
+        _In_ const SIZE_T outputLength) noexcept {
+    ASSERT(deviceContext != nullptr);
+    ASSERT(context != nullptr);
+    const auto headerSize = FIELD_OFFSET(RAPL_SAMPLING_CONFIG, Registers);
+    PVOID input = nullptr;
+    PVOID output = nullptr;
+    PRAPL_SAMPLER sampler = nullptr;
+    NTSTATUS status = STATUS_SUCCESS;
+
+    const auto cnt = (inputLength > headerSize)
+        ? (inputLength - headerSize) / sizeof(RAPL_CORE_MSR)
+        : 0;
+    if ((cnt == 0)
+            || ((inputLength - headerSize) % sizeof(RAPL_CORE_MSR) != 0)) {
+        KdPrint(("[PWROWG] Invalid size of sampling configuration: %Iu\r\n",
+            inputLength));
+        status = STATUS_INVALID_PARAMETER;
+    }
+
+    // The ring must hold at least two records such that the caller can read
+    // one while the next one is being written.
+    const auto recordSize = RAPL_SAMPLE_RECORD_SIZE(cnt);
+    const auto capacity = (outputLength > sizeof(RAPL_SAMPLE_RING))
+        ? (outputLength - sizeof(RAPL_SAMPLE_RING)) / recordSize
+        : 0;
+    if (NT_SUCCESS(status) && ((capacity < 2) || (capacity > MAXULONG))) {
+        KdPrint(("[PWROWG] Invalid size of sampling ring: %Iu\r\n",
+            outputLength));
+        status = STATUS_BUFFER_TOO_SMALL;
+    }
+
+    if (NT_SUCCESS(status)) {
+        status = ::WdfRequestRetrieveInputBuffer(request, inputLength, &input,
+            nullptr);
+    }
+
+    if (NT_SUCCESS(status)) {
+        const auto config = static_cast<PRAPL_SAMPLING_CONFIG>(input);
+        if ((config->Period < RAPL_MIN_SAMPLING_PERIOD)
+                || (config->Reserved != 0)) {
+            KdPrint(("[PWROWG] Invalid sampling period: %u\r\n",
+                config->Period));
+            status = STATUS_INVALID_PARAMETER;
+        }
+    }
+
+    // For METHOD_OUT_DIRECT, the I/O manager has locked the caller's buffer
+    // and the framework maps it into system space, so the timer and the DPCs
+    // can write to it directly until the request completes.
+    if (NT_SUCCESS(status)) {
+        status = ::WdfRequestRetrieveOutputBuffer(request, outputLength,
+            &output, nullptr);
+    }
+
+    if (NT_SUCCESS(status)) {
+        sampler = static_cast<PRAPL_SAMPLER>(::ExAllocatePoolWithTag(
+            NonPagedPoolNx, sizeof(RAPL_SAMPLER), RAPL_POOL_TAG));
+        if (sampler != nullptr) {
+            ::RtlZeroMemory(sampler, sizeof(RAPL_SAMPLER));
+            sampler->Registers = static_cast<PRAPL_CORE_MSR>(
+                ::ExAllocatePoolWithTag(NonPagedPoolNx,
+                cnt * sizeof(RAPL_CORE_MSR), RAPL_POOL_TAG));
+            sampler->Dpcs = static_cast<PRAPL_CORE_DPC>(
+                ::ExAllocatePoolWithTag(NonPagedPoolNx,
+                cnt * sizeof(RAPL_CORE_DPC), RAPL_POOL_TAG));
+        }
+
+        if ((sampler == nullptr) || (sampler->Registers == nullptr)
+                || (sampler->Dpcs == nullptr)) {
+            status = STATUS_INSUFFICIENT_RESOURCES;
+        }
+    }
+
+    if (NT_SUCCESS(status)) {
+        const auto config = static_cast<PRAPL_SAMPLING_CONFIG>(input);
+        ::RtlCopyMemory(sampler->Registers, config->Registers,
+            cnt * sizeof(RAPL_CORE_MSR));
+        status = ::RaplInitialiseCoreDpcs(sampler->Registers, cnt, context,
+            sampler->Dpcs, sampler->CountDpcs);
+    }
+
+    LONGLONG period = 0;
+    if (NT_SUCCESS(status)) {
+        period = static_cast<PRAPL_SAMPLING_CONFIG>(input)->Period;
+        period *= 10;   // Convert to 100 ns units.
+
+        sampler->Ring = static_cast<PRAPL_SAMPLE_RING>(output);
+        sampler->Ring->Written = 0;
+        sampler->Ring->Missed = 0;
+        sampler->Ring->Capacity = static_cast<unsigned __int32>(capacity);
+        sampler->Ring->CountRegisters = static_cast<unsigned __int32>(cnt);
+        sampler->Records = static_cast<unsigned __int8 *>(output)
+            + sizeof(RAPL_SAMPLE_RING);
+
+        sampler->Tick.Busy = 0;
+        sampler->Tick.Count = cnt;
+        sampler->Tick.Registers = sampler->Registers;
+        sampler->Tick.Written = &sampler->Ring->Written;
+        ::KeInitializeEvent(&sampler->Tick.Done, NotificationEvent, FALSE);
+
+        sampler->Timer = ::ExAllocateTimer(::RaplSampleTick, sampler,
+            EX_TIMER_HIGH_RESOLUTION);
+        if (sampler->Timer == nullptr) {
+            KdPrint(("[PWROWG] High-resolution timer is not available.\r\n"));
+            status = STATUS_NOT_SUPPORTED;
+        }
+    }
+
+    if (NT_SUCCESS(status)) {
+        if (::InterlockedCompareExchangePointer(
+                reinterpret_cast<PVOID volatile *>(&context->Sampler),
+                sampler, nullptr) != nullptr) {
+            KdPrint(("[PWROWG] The file is already sampling.\r\n"));
+            status = STATUS_DEVICE_BUSY;
+        }
+    }
+
+    if (NT_SUCCESS(status)) {
+        KdPrint(("[PWROWG] Sampling %Iu register(s) every %I64d us into "
+            "%Iu record(s).\r\n", cnt, period / 10, capacity));
+        ::ExSetTimer(sampler->Timer, -period, period, nullptr);
+
+        // Park the request in the manual queue, which allows the framework to
+        // cancel it. The cancellation callback stops the sampler.
+        status = ::WdfRequestForwardToIoQueue(request,
+            deviceContext->SamplingQueue);
+        if (NT_SUCCESS(status)) {
+            return STATUS_PENDING;
+        }
+
+        ::RaplStopSampling(context);
+        return status;
+    }
+
+    if ((sampler != nullptr) && (sampler->Timer != nullptr)) {
+        ::ExDeleteTimer(sampler->Timer, TRUE, FALSE, nullptr);
+    }
+    ::RaplFreeSampler(sampler);
+
+    return status;
+}
+
+
+/*
+ * ::RaplStopSampling
+ */
+_IRQL_requires_(PASSIVE_LEVEL)
+void RaplStopSampling(_In_ const PRAPL_FILE_CONTEXT context) noexcept {
+    ASSERT(context != nullptr);
+    auto sampler = static_cast<PRAPL_SAMPLER>(::InterlockedExchangePointer(
+        reinterpret_cast<PVOID volatile *>(&context->Sampler), nullptr));
+
+    if (sampler != nullptr) {
+        KdPrint(("[PWROWG] Stopping sampler 0x%p.\r\n", sampler));
+
+        // Wait for a running timer callback, which might still queue the DPCs
+        // of its tick, and afterwards for all of these DPCs.
+        ::ExDeleteTimer(sampler->Timer, TRUE, TRUE, nullptr);
+        ::KeFlushQueuedDpcs();
+
+        ::RaplFreeSampler(sampler);
+    }
+}
+
+
+/// <summary>
+/// This event is called when a pending <c>IOCTL_RAPL_SAMPLE</c> request in
+/// the sampling queue is cancelled, e.g. by <c>CancelIoEx</c> in user mode or
+/// because the calling thread exits.
+/// </summary>
+/// <param name="queue"></param>
+/// <param name="request"></param>
+extern "C" void RaplSamplingCanceled(_In_ WDFQUEUE queue,
+        _In_ WDFREQUEST request) noexcept {
+    UNREFERENCED_PARAMETER(queue);
+    ASSERT(request != nullptr);
+    PAGED_CODE();
+
+    const auto file = ::WdfRequestGetFileObject(request);
+    ASSERT(file != nullptr);
+    ::RaplStopSampling(::GetRaplFileContext(file));
+
+    KdPrint(("[PWROWG] Sampling request was cancelled.\r\n"));
+    ::WdfRequestComplete(request, STATUS_CANCELLED);
+}
+
+
+/// <summary>
+/// The framework calls this event when the last handle to a file has been
+/// closed, which ends a sampling request issued on this file.
+/// </summary>
+/// <param name="fileObject"></param>
+extern "C" void RaplFileCleanup(_In_ WDFFILEOBJECT fileObject) noexcept {
+    ASSERT(fileObject != nullptr);
+    PAGED_CODE();
+
+    const auto device = ::WdfFileObjectGetDevice(fileObject);
+    const auto deviceContext = ::GetRaplDeviceContext(device);
+    ASSERT(deviceContext != nullptr);
+    WDFREQUEST request = nullptr;
+
+    while (NT_SUCCESS(::WdfIoQueueRetrieveRequestByFileObject(
+            deviceContext->SamplingQueue, fileObject, &request))) {
+        ::RaplStopSampling(::GetRaplFileContext(fileObject));
+        ::WdfRequestComplete(request, STATUS_CANCELLED);
+    }
+
+    // If the request was not in the queue, it might never have been parked
+    // successfully, so make sure that the sampler is not running anymore.
+    ::RaplStopSampling(::GetRaplFileContext(fileObject));
+}
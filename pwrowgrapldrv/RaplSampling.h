@@ -0,0 +1,84 @@
+﻿// <copyright file="RaplSampling.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "RaplCoreMsrs.h"
+
+
+/// <summary>
+/// The state of a running <see cref="IOCTL_RAPL_SAMPLE" /> request, which is
+/// allocated from non-paged memory, because the timer and the DPCs access it.
+/// </summary>
+typedef struct _RAPL_SAMPLER {
+    /// <summary>
+    /// The number of elements in <see cref="Dpcs" />.
+    /// </summary>
+    SIZE_T CountDpcs;
+
+    /// <summary>
+    /// One DPC for each distinct core in <see cref="Registers" />.
+    /// </summary>
+    _Field_size_(CountDpcs) PRAPL_CORE_DPC Dpcs;
+
+    /// <summary>
+    /// The first record in the ring, which directly follows the
+    /// <see cref="Ring" /> header.
+    /// </summary>
+    unsigned __int8 *Records;
+
+    /// <summary>
+    /// The registers to sample.
+    /// </summary>
+    PRAPL_CORE_MSR Registers;
+
+    /// <summary>
+    /// The system address of the header of the caller's ring buffer.
+    /// </summary>
+    PRAPL_SAMPLE_RING Ring;
+
+    /// <summary>
+    /// The state passed to the DPCs of the current tick.
+    /// </summary>
+    RAPL_CORE_MSRS_REQUEST Tick;
+
+    /// <summary>
+    /// The high-resolution timer triggering the ticks.
+    /// </summary>
+    PEX_TIMER Timer;
+} RAPL_SAMPLER, *PRAPL_SAMPLER;
+
+
+/// <summary>
+/// Handles <see cref="IOCTL_RAPL_SAMPLE" /> by starting a sampler for the file
+/// and forwarding the request to the sampling queue of the device.
+/// </summary>
+/// <param name="request">The request, which remains pending if the method
+/// succeeds.</param>
+/// <param name="deviceContext">The context of the device, which holds the
+/// sampling queue.</param>
+/// <param name="context">The context of the file the request was issued on.
+/// </param>
+/// <param name="inputLength">The size of the input buffer in bytes.</param>
+/// <param name="outputLength">The size of the ring buffer in bytes.</param>
+/// <returns><c>STATUS_PENDING</c> if the sampler has been started, in which
+/// case the request must not be completed by the caller, or an error code
+/// otherwise.</returns>
+NTSTATUS RaplStartSampling(_In_ WDFREQUEST request,
+    _In_ const PRAPL_DEVICE_CONTEXT deviceContext,
+    _In_ const PRAPL_FILE_CONTEXT context,
+    _In_ const SIZE_T inputLength,
+    _In_ const SIZE_T outputLength) noexcept;
+
+/// <summary>
+/// Stops and frees the sampler of the given file if there is one.
+/// </summary>
+/// <remarks>
+/// This function waits for the timer and all DPCs of the sampler to complete
+/// and must therefore be called at <c>PASSIVE_LEVEL</c>.
+/// </remarks>
+/// <param name="context">The context of the file to stop sampling.</param>
+_IRQL_requires_(PASSIVE_LEVEL)
+void RaplStopSampling(_In_ const PRAPL_FILE_CONTEXT context) noexcept;
@@ -6,6 +6,33 @@
 #include "RaplThreadAffinity.h"
 
 
+/*
+ * ::RaplGetProcessorNumber
+ */
+NTSTATUS RaplGetProcessorNumber(_In_ const __int32 logicalCpu,
+        _Out_ PPROCESSOR_NUMBER processor) noexcept {
+    ASSERT(processor != nullptr);
+    const auto groups = ::KeQueryActiveGroupCount();
+    __int32 total = 0;
+
+    ::RtlZeroMemory(processor, sizeof(*processor));
+
+    // Search the group in which 'logicalCpu' falls.
+    for (; processor->Group < groups; ++processor->Group) {
+        const auto current = ::KeQueryActiveProcessorCountEx(processor->Group);
+        if (total + static_cast<__int32>(current) > logicalCpu) {
+            processor->Number = static_cast<UCHAR>(logicalCpu - total);
+            return (logicalCpu >= 0) ? STATUS_SUCCESS : STATUS_NOT_FOUND;
+        } else {
+            total += current;
+        }
+    }
+
+    // Logical CPU number is invalid.
+    return STATUS_NOT_FOUND;
+}
+
+
 /*
  * ::RaplSetThreadAffinity
  */
@@ -16,27 +43,16 @@ NTSTATUS RaplSetThreadAffinity(_In_ const __int32 logicalCpu,
     KdPrint(("[PWROWG] Set thread affinity to logical CPU %d.\r\n",
         logicalCpu));
 
-    const auto groups = ::KeQueryActiveGroupCount();
     GROUP_AFFINITY affinity { 0 };
-    __int32 total = 0;
-
-    // Search the group in which 'logicalCpu' falls.
-    for (; affinity.Group < groups; ++affinity.Group) {
-        const auto current = ::KeQueryActiveProcessorCountEx(affinity.Group);
-        if (total + current > logicalCpu) {
-            affinity.Mask = static_cast<KAFFINITY>(logicalCpu) - total;
-            break;
-        } else {
-            total += current;
-        }
-    }
+    PROCESSOR_NUMBER processor;
 
-    if (affinity.Group >= groups) {
-        // Logical CPU number is invalid.
-        return STATUS_NOT_FOUND;
+    const auto status = ::RaplGetProcessorNumber(logicalCpu, &processor);
+    if (!NT_SUCCESS(status)) {
+        return status;
     }
 
-    affinity.Mask = 1ULL << affinity.Mask;
+    affinity.Group = processor.Group;
+    affinity.Mask = 1ULL << processor.Number;
 
     ::KeSetSystemGroupAffinityThread(&affinity, previousAffinity);
     return STATUS_SUCCESS;
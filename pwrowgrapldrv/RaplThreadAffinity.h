@@ -8,6 +8,20 @@
 #include <ntddk.h>
 
 
+/// <summary>
+/// Determines the processor group and the number within this group of the
+/// logical CPU core identified by the given index.
+/// </summary>
+/// <param name="logicalCpu">The zero-based index of the CPU core over all
+/// processor groups.</param>
+/// <param name="processor">Receives the group and the group-relative number of
+/// the CPU core.</param>
+/// <returns><c>STATUS_SUCCESS</c> in case of success,
+/// <c>STATUS_NOT_FOUND</c> if <paramref name="logical_cpu" /> does not
+/// designate a valid CPU core on the machine.</returns>
+extern NTSTATUS RaplGetProcessorNumber(_In_ const __int32 logicalCpu,
+    _Out_ PPROCESSOR_NUMBER processor) noexcept;
+
 /// <summary>
 /// Sets the thread affinity of the callingt thread to the logical CPU core
 /// identified by the given index.
@@ -17,8 +17,9 @@
 /// <para>This library creates a
 /// <see cref="visus::power_overwhelming::stable_power_state_scope" /> for all
 /// hardware GPUs in the system putting them into a stable power state. It then
-/// waits until user input. This way, the devices are kept in stable power state
-/// until the application exits.</para>
+/// waits until the clocks of the GPUs have settled and reports this to the
+/// user, before it waits for user input. This way, the devices are kept in
+/// stable power state until the application exits.</para>
 /// <para>This tool is intended to testing applications that do not want to
 /// include the Power Overwhelming library in their own code, but need to enable
 /// stable power state for benchmarks.</para>
@@ -36,8 +37,17 @@ int main(void) {
 
         std::cout << spss.size() << ((spss.size() == 1)
             ? " graphics device has " : " graphics devices have ")
-            << "been put into stable power state. Press any key to revert."
-            << std::endl;
+            << "been put into stable power state." << std::endl;
+
+        std::cout << "Waiting for the GPU clocks to settle ..." << std::endl;
+        if (spss.wait_for_stable_clocks()) {
+            std::cout << "The GPU clocks have settled." << std::endl;
+        } else {
+            std::cout << "The GPU clocks could not be verified to have settled."
+                << std::endl;
+        }
+
+        std::cout << "Press any key to revert." << std::endl;
 
         ::_getch();
         return 0;
@@ -0,0 +1,65 @@
+﻿// <copyright file="adaptive_interval_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(adaptive_interval_test) {
+
+    public:
+
+        TEST_METHOD(test_disabled) {
+            typedef detail::adaptive_interval::interval_type interval_type;
+            detail::adaptive_interval adaptation;
+            Assert::IsFalse(adaptation.enabled(), L"Disabled by default", LINE_INFO());
+
+            adaptation.configure(interval_type(1000), interval_type(1000));
+            Assert::IsFalse(adaptation.enabled(), L"Disabled for equal bounds", LINE_INFO());
+            adaptation.update(1.0f);
+            Assert::IsTrue(interval_type(1000) == adaptation.update(100.0f), L"Fixed interval", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([&adaptation](void) { adaptation.configure(interval_type(0), interval_type(1000)); }, L"Zero minimum", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&adaptation](void) { adaptation.configure(interval_type(2000), interval_type(1000)); }, L"Minimum above maximum", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&adaptation](void) { adaptation.configure(interval_type(1000), interval_type(2000), 0.0f); }, L"Zero sensitivity", LINE_INFO());
+        }
+
+        TEST_METHOD(test_transient) {
+            typedef detail::adaptive_interval::interval_type interval_type;
+            const interval_type min_interval(1000);
+            const interval_type max_interval(8000);
+            detail::adaptive_interval adaptation;
+
+            adaptation.configure(min_interval, max_interval);
+            Assert::IsTrue(adaptation.enabled(), L"Enabled", LINE_INFO());
+            Assert::IsTrue(max_interval == adaptation.interval(), L"Start at maximum", LINE_INFO());
+
+            for (int i = 0; i < 16; ++i) {
+                Assert::IsTrue(max_interval == adaptation.update(10.0f), L"Stable at maximum", LINE_INFO());
+            }
+
+            Assert::IsTrue(max_interval == adaptation.update(measurement_data::invalid_value), L"Invalid ignored", LINE_INFO());
+            Assert::IsTrue(min_interval == adaptation.update(20.0f), L"Step raises rate", LINE_INFO());
+
+            auto previous = adaptation.interval();
+            for (int i = 0; (i < 1000) && (previous < max_interval); ++i) {
+                const auto current = adaptation.update(20.0f);
+                Assert::IsTrue(current >= previous, L"Rate decreases monotonically", LINE_INFO());
+                Assert::IsTrue((current == previous) || (current == 2 * previous), L"Interval doubles", LINE_INFO());
+                previous = current;
+            }
+            Assert::IsTrue(max_interval == previous, L"Back at maximum", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
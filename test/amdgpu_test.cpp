@@ -0,0 +1,65 @@
+﻿// <copyright file="amdgpu_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(amdgpu_test) {
+
+    public:
+
+        TEST_METHOD(test_for_all) {
+            std::vector<amdgpu_sensor> sensors(amdgpu_sensor::for_all(nullptr, 0));
+            amdgpu_sensor::for_all(sensors.data(), sensors.size());
+            Assert::AreEqual(std::size_t(0), sensors.size(), L"hwmon is not supported on Windows", LINE_INFO());
+        }
+
+        TEST_METHOD(test_from_bus_id) {
+            Assert::ExpectException<std::system_error>([](void) {
+                amdgpu_sensor::from_bus_id("0000:03:00.0", amdgpu_sensor_source::average_power);
+            }, L"hwmon is not supported on Windows", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                amdgpu_sensor::from_bus_id(static_cast<const char *>(nullptr), amdgpu_sensor_source::average_power);
+            }, L"Null bus ID", LINE_INFO());
+        }
+
+        TEST_METHOD(test_source) {
+            const amdgpu_sensor_source sources[] = {
+                amdgpu_sensor_source::average_power,
+                amdgpu_sensor_source::instantaneous_power,
+                amdgpu_sensor_source::energy
+            };
+
+            for (auto s : sources) {
+                Assert::IsTrue(s == parse_amdgpu_sensor_source(to_string(s)), L"Round trip", LINE_INFO());
+            }
+
+            Assert::AreEqual("power1_average", detail::amdgpu_sensor_impl::attribute(amdgpu_sensor_source::average_power), L"Average power", LINE_INFO());
+            Assert::AreEqual("power1_input", detail::amdgpu_sensor_impl::attribute(amdgpu_sensor_source::instantaneous_power), L"Instantaneous power", LINE_INFO());
+            Assert::AreEqual("energy1_input", detail::amdgpu_sensor_impl::attribute(amdgpu_sensor_source::energy), L"Energy", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                parse_amdgpu_sensor_source(L"voltage");
+            }, L"Invalid source", LINE_INFO());
+        }
+
+        TEST_METHOD(test_parse) {
+            Assert::AreEqual(std::uint64_t(42000000), detail::amdgpu_sensor_impl::parse("42000000\n", 9), L"Watts in microwatts", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(12), detail::amdgpu_sensor_impl::parse("1234", 2), L"Only valid bytes", LINE_INFO());
+            Assert::ExpectException<std::runtime_error>([](void) {
+                detail::amdgpu_sensor_impl::parse("\n", 1);
+            }, L"No number", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
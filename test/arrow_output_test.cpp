@@ -0,0 +1,96 @@
+﻿// <copyright file="arrow_output_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(arrow_output_test) {
+
+    public:
+
+        TEST_METHOD(test_file) {
+            // 2023-01-01 00:00:00 UTC in milliseconds since 1601.
+            const measurement::timestamp_type start = 13317004800000LL;
+
+            {
+                detail::arrow_output_writer writer;
+                writer.open(L"arrow_output_test.arrow");
+                writer.header(timestamp_resolution::milliseconds, { L"sensor1" });
+                writer.marker(1, L"phase");
+                writer.push(measurement(L"sensor1", start + 1, 12.5f), 1);
+                writer.push(measurement(L"sensor1", start + 2, 12.0f), 0);
+                writer.flush();
+                writer.push(measurement(L"sensor2", start + 3, 12.0f, 0.5f, 6.0f), 1);
+            }
+
+            std::ifstream file("arrow_output_test.arrow", std::ios::binary);
+            const std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            Assert::IsTrue(data.size() > 16, L"File not empty", LINE_INFO());
+            Assert::AreEqual(std::string("ARROW1"), data.substr(0, 6), L"Leading magic", LINE_INFO());
+            Assert::AreEqual(std::string("ARROW1"), data.substr(data.size() - 6), L"Trailing magic", LINE_INFO());
+
+            const auto footer_size = read<std::int32_t>(data, data.size() - 10);
+            const auto footer = data.size() - 10 - footer_size;
+            Assert::IsTrue(footer > 8, L"Footer within the file", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(0xFFFFFFFF), read<std::uint32_t>(data, footer - 8), L"End of stream before footer", LINE_INFO());
+
+            // The footer lists the initial dictionaries, a delta for the second
+            // sensor and one record batch per flush.
+            const auto root = footer + read<std::uint32_t>(data, footer);
+            const auto dictionaries = vector(data, root, 2);
+            const auto batches = vector(data, root, 3);
+            Assert::AreEqual(std::uint32_t(3), read<std::uint32_t>(data, dictionaries), L"Three dictionary batches", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(2), read<std::uint32_t>(data, batches), L"Two record batches", LINE_INFO());
+
+            for (std::uint32_t i = 0; i < 2; ++i) {
+                const auto block = batches + 4 + 24 * i;
+                const auto offset = static_cast<std::size_t>(read<std::int64_t>(data, block));
+                const auto metadata = read<std::int32_t>(data, block + 8);
+                Assert::AreEqual(std::uint32_t(0xFFFFFFFF), read<std::uint32_t>(data, offset), L"Continuation of record batch", LINE_INFO());
+                Assert::AreEqual(0, metadata % 8, L"Body is aligned", LINE_INFO());
+            }
+
+            {
+                // The timestamps of the first batch follow the two sensor
+                // indices and are in milliseconds since the UNIX epoch.
+                const auto block = batches + 4;
+                const auto offset = static_cast<std::size_t>(read<std::int64_t>(data, block));
+                const auto body = offset + read<std::int32_t>(data, block + 8);
+                Assert::AreEqual(0, read<std::int32_t>(data, body), L"Index of sensor1", LINE_INFO());
+                Assert::AreEqual(std::int64_t(1672531200001LL), read<std::int64_t>(data, body + 8), L"UNIX timestamp", LINE_INFO());
+                Assert::AreEqual(std::int64_t(1672531200002LL), read<std::int64_t>(data, body + 16), L"UNIX timestamp", LINE_INFO());
+            }
+        }
+
+    private:
+
+        template<class T>
+        static T read(const std::string& data, const std::size_t offset) {
+            Assert::IsTrue(offset + sizeof(T) <= data.size(), L"Read within file", LINE_INFO());
+            T retval;
+            ::memcpy(&retval, data.data() + offset, sizeof(T));
+            return retval;
+        }
+
+        static std::size_t vector(const std::string& data, const std::size_t table, const int field) {
+            const auto vtable = table - read<std::int32_t>(data, table);
+            const auto size = read<std::uint16_t>(data, vtable);
+            Assert::IsTrue(static_cast<std::size_t>(4 + 2 * field) < size, L"Field in vtable", LINE_INFO());
+            const auto position = read<std::uint16_t>(data, vtable + 4 + 2 * field);
+            Assert::AreNotEqual(std::uint16_t(0), position, L"Field present", LINE_INFO());
+            return table + position + read<std::uint32_t>(data, table + position);
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,168 @@
+﻿// <copyright file="binary_output_reader_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(binary_output_reader_test) {
+
+    public:
+
+        TEST_METHOD(test_time_range) {
+            for (auto compressed : { false, true }) {
+                write(compressed);
+
+                binary_output_reader reader(L"binary_output_reader_test.bin");
+                Assert::IsTrue(reader.indexed(), L"Index in footer", LINE_INFO());
+                Assert::AreEqual(std::size_t(2), reader.sensors(), L"All sensors", LINE_INFO());
+                Assert::AreEqual(std::wstring(L"sensor2"), std::wstring(reader.sensor(1)), L"Sensor name", LINE_INFO());
+                Assert::AreEqual(std::size_t(2), reader.markers(), L"All markers", LINE_INFO());
+
+                std::vector<measurement_data> samples;
+                auto cnt = reader.read(L"sensor1", 1000, 1100, collect, &samples);
+                Assert::AreEqual(std::size_t(10), cnt, L"Samples in range", LINE_INFO());
+                Assert::AreEqual(cnt, samples.size(), L"All samples delivered", LINE_INFO());
+                Assert::AreEqual(measurement_data::timestamp_type(1000), samples.front().timestamp(), L"First sample in range", LINE_INFO());
+                Assert::AreEqual(measurement_data::timestamp_type(1090), samples.back().timestamp(), L"Last sample in range", LINE_INFO());
+
+                samples.clear();
+                cnt = reader.read(nullptr, 1000, 1100, collect, &samples);
+                Assert::AreEqual(std::size_t(20), cnt, L"Samples of all sensors in range", LINE_INFO());
+
+                cnt = reader.read(L"sensor3", 0, 100000, collect, &samples);
+                Assert::AreEqual(std::size_t(0), cnt, L"Unknown sensor", LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(test_marker) {
+            write(true);
+
+            binary_output_reader reader("binary_output_reader_test.bin");
+            std::vector<measurement_data> samples;
+            auto cnt = reader.read(L"sensor1", L"phase 1", collect, &samples);
+            Assert::AreEqual(std::size_t(500), cnt, L"Samples of the phase", LINE_INFO());
+            Assert::AreEqual(measurement_data::timestamp_type(2000), samples.front().timestamp(), L"First sample of the phase", LINE_INFO());
+
+            samples.clear();
+            cnt = reader.read(L"sensor1", L"phase 2", collect, &samples);
+            Assert::AreEqual(std::size_t(200), cnt, L"Samples of the repeated phase", LINE_INFO());
+
+            cnt = reader.read(nullptr, L"phase 3", collect, &samples);
+            Assert::AreEqual(std::size_t(0), cnt, L"Unknown marker", LINE_INFO());
+        }
+
+        TEST_METHOD(test_phases) {
+            typedef binary_output_reader::timestamp_type timestamp_type;
+            write(false);
+
+            binary_output_reader reader("binary_output_reader_test.bin");
+            timestamp_type begin[2], end[2];
+            auto cnt = reader.phases(L"phase 2", begin, end, 2);
+            Assert::AreEqual(std::size_t(2), cnt, L"Repeated phase", LINE_INFO());
+            Assert::AreEqual(timestamp_type(7000), begin[0], L"Begin of first phase", LINE_INFO());
+            Assert::AreEqual(timestamp_type(8000), end[0], L"End of first phase", LINE_INFO());
+            Assert::AreEqual(timestamp_type(9000), begin[1], L"Begin of second phase", LINE_INFO());
+            Assert::AreEqual((std::numeric_limits<timestamp_type>::max)(), end[1], L"Open phase", LINE_INFO());
+
+            cnt = reader.phases(L"phase 1", nullptr, nullptr, 0);
+            Assert::AreEqual(std::size_t(1), cnt, L"Count only", LINE_INFO());
+
+            cnt = reader.phases(L"phase 3", begin, end, 2);
+            Assert::AreEqual(std::size_t(0), cnt, L"Unknown marker", LINE_INFO());
+        }
+
+        TEST_METHOD(test_scan) {
+            {
+                detail::binary_output_writer writer;
+                writer.open(L"binary_output_reader_test.bin", true);
+                writer.header(timestamp_resolution::milliseconds, { L"sensor1" });
+                writer.marker(1, L"phase 1");
+                writer.marker_event(5, 1);
+                for (int i = 0; i < 10; ++i) {
+                    writer.push(measurement(L"sensor1", i, 1.0f), (i < 5) ? 0 : 1);
+                }
+                writer.flush();
+
+                // Simulate a crash by copying the file before it has been
+                // closed, which leaves it without index.
+                std::ifstream src("binary_output_reader_test.bin", std::ios::binary);
+                std::ofstream dst("binary_output_reader_test_crash.bin", std::ios::binary);
+                dst << src.rdbuf();
+            }
+
+            binary_output_reader reader(L"binary_output_reader_test_crash.bin");
+            Assert::IsFalse(reader.indexed(), L"Index built by scanning", LINE_INFO());
+
+            std::vector<measurement_data> samples;
+            Assert::AreEqual(std::size_t(3), reader.read(L"sensor1", 2, 5, collect, &samples), L"Samples in range", LINE_INFO());
+            Assert::AreEqual(std::size_t(5), reader.read(L"sensor1", L"phase 1", collect, &samples), L"Samples of the phase", LINE_INFO());
+        }
+
+        TEST_METHOD(test_invalid) {
+            binary_output_reader reader;
+            Assert::IsFalse(reader, L"Default reader is invalid", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), reader.sensors(), L"No sensors", LINE_INFO());
+
+            {
+                std::ofstream file("binary_output_reader_test.txt", std::ios::trunc);
+                file << "This is not a binary output file.";
+            }
+
+            Assert::ExpectException<std::runtime_error>([](void) {
+                binary_output_reader reader(L"binary_output_reader_test.txt");
+            }, L"Invalid magic number", LINE_INFO());
+        }
+
+    private:
+
+        static void collect(_In_z_ const wchar_t *sensor,
+                _In_reads_(cnt) const measurement_data *samples,
+                _In_ const std::size_t cnt,
+                _In_opt_ void *context) {
+            auto dst = static_cast<std::vector<measurement_data> *>(context);
+            dst->insert(dst->end(), samples, samples + cnt);
+        }
+
+        /// <summary>
+        /// Writes 1000 samples of two sensors in chunks of 100 samples, with
+        /// "phase 1" being set from 2000 to 7000 and "phase 2" from 7000 to
+        /// 8000 and again from 9000 on.
+        /// </summary>
+        static void write(_In_ const bool compressed) {
+            detail::binary_output_writer writer;
+            writer.compressed(compressed);
+            writer.open(L"binary_output_reader_test.bin");
+            writer.header(timestamp_resolution::milliseconds, { L"sensor1", L"sensor2" });
+            writer.marker(1, L"phase 1");
+            writer.marker(2, L"phase 2");
+
+            std::uint32_t marker = 0;
+            for (int i = 0; i < 1000; ++i) {
+                const auto t = 10 * i;
+                if ((t == 2000) || (t == 7000) || (t == 8000) || (t == 9000)) {
+                    marker = (t == 2000) ? 1 : (t == 8000) ? 0 : 2;
+                    writer.marker_event(t, marker);
+                }
+
+                writer.push(measurement(L"sensor1", t, 12.0f, 1.0f), marker);
+                writer.push(measurement(L"sensor2", t, 3.0f), marker);
+
+                if (i % 100 == 99) {
+                    writer.flush();
+                }
+            }
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,313 @@
+﻿// <copyright file="binary_output_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(binary_output_test) {
+
+    public:
+
+        TEST_METHOD(test_round_trip) {
+            {
+                detail::binary_output_writer writer;
+                writer.open(L"binary_output_test.bin");
+                writer.header(timestamp_resolution::milliseconds, { L"sensor1", L"sensor2" });
+                writer.marker(1, L"phase 1");
+                writer.push(measurement(L"sensor1", 1, 1.0f, 2.0f), 0);
+                writer.push(measurement(L"sensor2", 2, 3.0f), 1);
+                writer.push(measurement(L"sensor3", 3, 4.0f), 1);
+                writer.flush();
+                writer.marker(2, L"phase 2");
+                writer.push(measurement(L"sensor1", 4, 5.0f), 2);
+            }
+
+            const auto cnt = binary_output_to_csv(L"binary_output_test.bin", L"binary_output_test.csv");
+            Assert::AreEqual(std::size_t(4), cnt, L"All samples converted", LINE_INFO());
+
+            std::wifstream csv("binary_output_test.csv");
+            std::vector<std::wstring> lines;
+            for (std::wstring line; std::getline(csv, line);) {
+                lines.push_back(line);
+            }
+
+            Assert::AreEqual(std::size_t(5), lines.size(), L"Header and one line per sample", LINE_INFO());
+            Assert::AreEqual(std::wstring(L"sensor\ttimestamp\tvalid\tvoltage\tcurrent\tpower\tmarker"), lines[0], L"CSV header", LINE_INFO());
+            Assert::AreEqual(std::wstring(L"sensor1\t1\t1\t1\t2\t2\t"), lines[1], L"Sample without marker", LINE_INFO());
+            Assert::IsTrue(lines[3].find(L"sensor3\t3\t") == 0, L"Sensor declared after the header", LINE_INFO());
+            Assert::IsTrue(lines[3].rfind(L"\tphase 1") != std::wstring::npos, L"Marker of sample", LINE_INFO());
+            Assert::IsTrue(lines[4].rfind(L"\tphase 2") != std::wstring::npos, L"Samples flushed on destruction", LINE_INFO());
+        }
+
+        TEST_METHOD(test_mapped) {
+            {
+                detail::binary_output_writer writer;
+                writer.open(L"binary_output_test.bin", true);
+                writer.header(timestamp_resolution::milliseconds, { L"sensor1" });
+                writer.push(measurement(L"sensor1", 1, 1.0f, 2.0f), 0);
+                writer.push(measurement(L"sensor1", 2, 3.0f), 0);
+                writer.flush();
+
+                // Simulate a crash by converting a copy of the pre-extended
+                // file before the writer is closed.
+                std::ifstream src("binary_output_test.bin", std::ios::binary);
+                std::ofstream dst("binary_output_test_crash.bin", std::ios::binary);
+                dst << src.rdbuf();
+            }
+
+            std::ifstream file("binary_output_test.bin", std::ios::binary | std::ios::ate);
+            std::ifstream crash("binary_output_test_crash.bin", std::ios::binary | std::ios::ate);
+            Assert::IsTrue(crash.tellg() > file.tellg(), L"File is truncated on close", LINE_INFO());
+
+            Assert::AreEqual(std::size_t(2), binary_output_to_csv(L"binary_output_test.bin", L"binary_output_test.csv"), L"All samples converted", LINE_INFO());
+            Assert::AreEqual(std::size_t(2), binary_output_to_csv(L"binary_output_test_crash.bin", L"binary_output_test.csv"), L"Unused space is ignored", LINE_INFO());
+        }
+
+        TEST_METHOD(test_async) {
+            {
+                // Two buffers of a single page force the buffers to be
+                // recycled many times.
+                detail::async_output_buffer buffer;
+                buffer.open(L"binary_output_test_async.raw", 2, 1);
+                Assert::AreEqual(std::size_t(2), buffer.buffer_count(), L"Buffer count", LINE_INFO());
+
+                std::ostream stream(&buffer);
+                for (int i = 0; i < 100000; ++i) {
+                    stream.put(static_cast<char>(i % 251));
+                    if (i % 10000 == 0) {
+                        stream.flush();
+                    }
+                }
+                Assert::IsTrue(stream.good(), L"Stream is good", LINE_INFO());
+                Assert::AreEqual(std::uint64_t(100000), buffer.written(), L"Bytes written", LINE_INFO());
+                buffer.close();
+                Assert::AreEqual(0, buffer.error(), L"No error", LINE_INFO());
+            }
+
+            {
+                std::ifstream file("binary_output_test_async.raw", std::ios::binary);
+                std::vector<char> content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+                Assert::AreEqual(std::size_t(100000), content.size(), L"File size", LINE_INFO());
+                for (std::size_t i = 0; i < content.size(); ++i) {
+                    if (content[i] != static_cast<char>(i % 251)) {
+                        Assert::Fail(L"File content", LINE_INFO());
+                    }
+                }
+            }
+
+            for (auto async : { false, true }) {
+                detail::binary_output_writer writer;
+                if (async) {
+                    writer.open_async(L"binary_output_test_async.bin");
+                } else {
+                    writer.open(L"binary_output_test.bin");
+                }
+                writer.header(timestamp_resolution::milliseconds, { L"sensor1" });
+                for (int i = 0; i < 50000; ++i) {
+                    writer.push(measurement(L"sensor1", i, 12.0f, 0.5f), 0);
+                    if (i % 1000 == 0) {
+                        writer.flush();
+                    }
+                }
+            }
+
+            Assert::AreEqual(std::size_t(50000), binary_output_to_csv(L"binary_output_test_async.bin", L"binary_output_test_async.csv"), L"All samples converted", LINE_INFO());
+            Assert::AreEqual(std::size_t(50000), binary_output_to_csv(L"binary_output_test.bin", L"binary_output_test.csv"), L"Reference converted", LINE_INFO());
+
+            std::ifstream expected("binary_output_test.csv");
+            std::ifstream actual("binary_output_test_async.csv");
+            std::stringstream e, a;
+            e << expected.rdbuf();
+            a << actual.rdbuf();
+            Assert::IsTrue(e.str() == a.str(), L"Asynchronous file is the same", LINE_INFO());
+        }
+
+        TEST_METHOD(test_direct) {
+            {
+                detail::async_output_buffer buffer;
+                buffer.open(L"binary_output_test_direct.raw", 2, 1, true);
+                if (!buffer.direct()) {
+                    Logger::WriteMessage(L"Direct I/O is not supported by the file system.");
+                }
+
+                // Flushing parts of pages must neither lose nor duplicate data.
+                std::ostream stream(&buffer);
+                for (int i = 0; i < 10001; ++i) {
+                    stream.put(static_cast<char>(i % 251));
+                    if (i % 1000 == 0) {
+                        stream.flush();
+                    }
+                }
+                Assert::IsTrue(stream.good(), L"Stream is good", LINE_INFO());
+                buffer.close();
+                Assert::AreEqual(0, buffer.error(), L"No error", LINE_INFO());
+            }
+
+            {
+                std::ifstream file("binary_output_test_direct.raw", std::ios::binary);
+                std::vector<char> content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+                Assert::AreEqual(std::size_t(10001), content.size(), L"Padding is truncated", LINE_INFO());
+                for (std::size_t i = 0; i < content.size(); ++i) {
+                    if (content[i] != static_cast<char>(i % 251)) {
+                        Assert::Fail(L"File content", LINE_INFO());
+                    }
+                }
+            }
+
+            {
+                detail::binary_output_writer writer;
+                writer.open_async(L"binary_output_test_direct.bin", true);
+                writer.header(timestamp_resolution::milliseconds, { L"sensor1" });
+                for (int i = 0; i < 1000; ++i) {
+                    writer.push(measurement(L"sensor1", i, 12.0f, 0.5f), 0);
+                }
+            }
+
+            Assert::AreEqual(std::size_t(1000), binary_output_to_csv(L"binary_output_test_direct.bin", L"binary_output_test_direct.csv"), L"All samples converted", LINE_INFO());
+        }
+
+        TEST_METHOD(test_compressed) {
+            for (auto compressed : { false, true }) {
+                detail::binary_output_writer writer;
+                writer.compressed(compressed);
+                writer.open(compressed ? L"binary_output_test_compressed.bin" : L"binary_output_test.bin");
+                writer.header(timestamp_resolution::milliseconds, { L"sensor1", L"sensor2" });
+                writer.marker(1, L"phase 1");
+                for (int i = 0; i < 1000; ++i) {
+                    writer.push(measurement(L"sensor1", 10 * i, 12.0f, 0.5f + (i % 7) * 0.001f), (i < 500) ? 0 : 1);
+                    writer.push(measurement(L"sensor2", 10 * i + 1, 3.0f), 0);
+                }
+                writer.flush();
+                writer.push(measurement(L"sensor1", 10000, 12.0f, 1.0f), 1);
+            }
+
+            std::ifstream raw("binary_output_test.bin", std::ios::binary | std::ios::ate);
+            std::ifstream compressed("binary_output_test_compressed.bin", std::ios::binary | std::ios::ate);
+            Assert::IsTrue(compressed.tellg() * 4 < raw.tellg(), L"Samples are compressed", LINE_INFO());
+
+            Assert::AreEqual(std::size_t(2001), binary_output_to_csv(L"binary_output_test.bin", L"binary_output_test.csv"), L"All raw samples converted", LINE_INFO());
+            Assert::AreEqual(std::size_t(2001), binary_output_to_csv(L"binary_output_test_compressed.bin", L"binary_output_test_compressed.csv"), L"All compressed samples converted", LINE_INFO());
+
+            std::ifstream expected("binary_output_test.csv");
+            std::ifstream actual("binary_output_test_compressed.csv");
+            std::stringstream e, a;
+            e << expected.rdbuf();
+            a << actual.rdbuf();
+            Assert::IsTrue(e.str() == a.str(), L"Compressed file decodes to the same CSV", LINE_INFO());
+        }
+
+        TEST_METHOD(test_start_record) {
+            {
+                detail::start_record start;
+                start.timestamp = 42;
+                start.latencies.emplace_back(L"sensor1", 1500);
+                start.latencies.emplace_back(L"sensor2", 3);
+
+                detail::binary_output_writer writer;
+                writer.open(L"binary_output_test.bin");
+                writer.header(timestamp_resolution::milliseconds, { L"sensor1", L"sensor2" });
+                writer.start(start);
+                writer.push(measurement(L"sensor1", 42, 1.0f, 2.0f), 0);
+            }
+
+            const auto cnt = binary_output_to_csv(L"binary_output_test.bin", L"binary_output_test.csv");
+            Assert::AreEqual(std::size_t(1), cnt, L"All samples converted", LINE_INFO());
+
+            std::wifstream csv("binary_output_test.csv");
+            std::vector<std::wstring> lines;
+            for (std::wstring line; std::getline(csv, line);) {
+                lines.push_back(line);
+            }
+
+            Assert::AreEqual(std::size_t(5), lines.size(), L"Start record, header and sample", LINE_INFO());
+            Assert::AreEqual(std::wstring(L"# start\t42"), lines[0], L"Start timestamp", LINE_INFO());
+            Assert::AreEqual(std::wstring(L"# start latency\tsensor1\t1500"), lines[1], L"Latency of sensor1", LINE_INFO());
+            Assert::AreEqual(std::wstring(L"# start latency\tsensor2\t3"), lines[2], L"Latency of sensor2", LINE_INFO());
+            Assert::IsTrue(lines[3].find(L"sensor\t") == 0, L"CSV header after start record", LINE_INFO());
+        }
+
+        TEST_METHOD(test_marker_event) {
+            {
+                detail::binary_output_writer writer;
+                writer.open(L"binary_output_test.bin");
+                writer.header(timestamp_resolution::milliseconds, { L"sensor1" });
+                writer.marker(1, L"phase 1");
+                writer.marker_event(10, 1);
+                writer.marker_event(20, 0);
+                writer.push(measurement(L"sensor1", 15, 1.0f, 2.0f), 1);
+            }
+
+            const auto cnt = binary_output_to_csv(L"binary_output_test.bin", L"binary_output_test.csv");
+            Assert::AreEqual(std::size_t(1), cnt, L"All samples converted", LINE_INFO());
+
+            std::wifstream csv("binary_output_test.csv");
+            std::vector<std::wstring> lines;
+            for (std::wstring line; std::getline(csv, line);) {
+                lines.push_back(line);
+            }
+
+            Assert::AreEqual(std::size_t(4), lines.size(), L"Two events, header and sample", LINE_INFO());
+            Assert::AreEqual(std::wstring(L"# marker event\t10\tphase 1"), lines[0], L"Marker set", LINE_INFO());
+            Assert::AreEqual(std::wstring(L"# marker event\t20\t"), lines[1], L"Marker cleared", LINE_INFO());
+            Assert::IsTrue(lines[3].rfind(L"\tphase 1") != std::wstring::npos, L"Marker of sample", LINE_INFO());
+        }
+
+        TEST_METHOD(test_schema_change) {
+            {
+                detail::schema_change change;
+                change.interval = 2000;
+                change.name = L"sensor2";
+                change.timestamp = 30;
+                change.type = detail::schema_change_type::added;
+
+                detail::binary_output_writer writer;
+                writer.open(L"binary_output_test.bin");
+                writer.header(timestamp_resolution::milliseconds, { L"sensor1" });
+                writer.schema_change(change);
+                writer.push(measurement(L"sensor2", 31, 1.0f, 2.0f), 0);
+
+                change.interval = 0;
+                change.timestamp = 40;
+                change.type = detail::schema_change_type::removed;
+                writer.schema_change(change);
+            }
+
+            const auto cnt = binary_output_to_csv(L"binary_output_test.bin", L"binary_output_test.csv");
+            Assert::AreEqual(std::size_t(1), cnt, L"All samples converted", LINE_INFO());
+
+            std::wifstream csv("binary_output_test.csv");
+            std::vector<std::wstring> lines;
+            for (std::wstring line; std::getline(csv, line);) {
+                lines.push_back(line);
+            }
+
+            Assert::AreEqual(std::size_t(4), lines.size(), L"Two changes, header and sample", LINE_INFO());
+            Assert::AreEqual(std::wstring(L"# schema change\t30\tadded\tsensor2\t2000"), lines[0], L"Sensor added", LINE_INFO());
+            Assert::AreEqual(std::wstring(L"# schema change\t40\tremoved\tsensor2\t0"), lines[1], L"Sensor removed", LINE_INFO());
+            Assert::IsTrue(lines[3].find(L"sensor2\t") == 0, L"Sample of added sensor", LINE_INFO());
+        }
+
+        TEST_METHOD(test_invalid_input) {
+            {
+                std::ofstream file("binary_output_test.txt", std::ios::trunc);
+                file << "This is not a binary output file.";
+            }
+
+            Assert::ExpectException<std::runtime_error>([](void) {
+                binary_output_to_csv("binary_output_test.txt", "binary_output_test.csv");
+            }, L"Invalid magic number", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -65,16 +65,60 @@ namespace test {
         }
 
         TEST_METHOD(move_ctor) {
-            blob b1 { std::uint8_t(6), std::uint8_t(7), std::uint8_t(8) };
-            const auto expected_ptr = b1.data();
-            const auto expected_size = b1.size();
-            blob b2(std::move(b1));
-
-            Assert::IsNotNull(b2.data(), L"Data of has been moved", LINE_INFO());
-            Assert::AreEqual(expected_ptr, b2.data(), L"Pointer has been moved", LINE_INFO());
-            Assert::AreEqual(expected_size, b2.size(), L"Size has been copied", LINE_INFO());
-            Assert::IsNull(b1.data(), L"Source of move has been erased", LINE_INFO());
-            Assert::AreEqual(std::size_t(0), b1.size(), L"Source of move has size zero", LINE_INFO());
+            {
+                blob b1(2 * blob::inline_capacity);
+                const auto expected_ptr = b1.data();
+                const auto expected_size = b1.size();
+                blob b2(std::move(b1));
+
+                Assert::IsNotNull(b2.data(), L"Data of has been moved", LINE_INFO());
+                Assert::AreEqual(expected_ptr, b2.data(), L"Pointer has been moved", LINE_INFO());
+                Assert::AreEqual(expected_size, b2.size(), L"Size has been copied", LINE_INFO());
+                Assert::IsNull(b1.data(), L"Source of move has been erased", LINE_INFO());
+                Assert::AreEqual(std::size_t(0), b1.size(), L"Source of move has size zero", LINE_INFO());
+            }
+
+            {
+                blob b1 { std::uint8_t(6), std::uint8_t(7), std::uint8_t(8) };
+                blob b2(std::move(b1));
+
+                Assert::IsNotNull(b2.data(), L"Inline data of has been moved", LINE_INFO());
+                Assert::AreEqual(std::size_t(3), b2.size(), L"Size has been copied", LINE_INFO());
+                Assert::AreEqual(std::uint8_t(6), *b2.as<std::uint8_t>(0), L"Inline data at 0", LINE_INFO());
+                Assert::AreEqual(std::uint8_t(8), *b2.as<std::uint8_t>(2), L"Inline data at 2", LINE_INFO());
+                Assert::IsNull(b1.data(), L"Source of move has been erased", LINE_INFO());
+                Assert::AreEqual(std::size_t(0), b1.size(), L"Source of move has size zero", LINE_INFO());
+
+                b1 = std::move(b2);
+                Assert::AreEqual(std::uint8_t(7), *b1.as<std::uint8_t>(1), L"Move-assigned inline data at 1", LINE_INFO());
+                Assert::IsNull(b2.data(), L"Source of move assignment has been erased", LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(storage) {
+            blob s(blob::inline_capacity);
+            const auto inline_ptr = s.data();
+            s.truncate(1);
+            Assert::AreEqual(inline_ptr, s.data(), L"Shrinking inline blob keeps buffer", LINE_INFO());
+
+            blob l(4096);
+            const auto address = reinterpret_cast<std::uintptr_t>(l.data());
+            Assert::AreEqual(std::uintptr_t(0), address % 64, L"Heap allocation is aligned to 64 bytes", LINE_INFO());
+
+            *l.as<std::uint8_t>(0) = 42;
+            const auto large_ptr = l.data();
+            l.truncate(1024);
+            Assert::AreEqual(large_ptr, l.data(), L"Shrinking keeps buffer", LINE_INFO());
+            l.truncate(4096);
+            Assert::AreEqual(large_ptr, l.data(), L"Growing within capacity keeps buffer", LINE_INFO());
+            Assert::AreEqual(std::uint8_t(42), *l.as<std::uint8_t>(0), L"Content preserved", LINE_INFO());
+
+            l.truncate(8192);
+            Assert::AreEqual(std::size_t(8192), l.size(), L"Size after growing beyond capacity", LINE_INFO());
+            Assert::AreEqual(std::uint8_t(42), *l.as<std::uint8_t>(0), L"Content copied", LINE_INFO());
+
+            l.clear();
+            Assert::IsNull(l.data(), L"Cleared blob is empty", LINE_INFO());
         }
 
         TEST_METHOD(accessors) {
@@ -106,6 +150,10 @@ namespace test {
             Assert::AreEqual(std::size_t(8), b.size(), L"Size unchanged after grow", LINE_INFO());
             Assert::AreEqual(std::uint8_t(1), *b.as<std::uint8_t>(0), L"Data unchanged at 0", LINE_INFO());
             Assert::AreEqual(std::uint8_t(2), *b.as<std::uint8_t>(1), L"Data unchanged at 1", LINE_INFO());
+
+            blob e;
+            Assert::IsTrue(e.grow(4), L"grow 4 from empty", LINE_INFO());
+            Assert::AreEqual(std::size_t(4), e.size(), L"Size after grow from empty", LINE_INFO());
         }
 
         TEST_METHOD(resize) {
@@ -0,0 +1,84 @@
+﻿// <copyright file="c_api_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(c_api_test) {
+
+    public:
+
+        TEST_METHOD(test_errors) {
+            Assert::IsTrue(::pwrowg_api_version() >= PWROWG_API_VERSION, L"API version", LINE_INFO());
+
+            pwrowg_collector *collector = reinterpret_cast<pwrowg_collector *>(this);
+            Assert::AreEqual(PWROWG_INVALID_ARGUMENT, ::pwrowg_collector_for_all(nullptr, 1000, &collector), L"Output path required", LINE_INFO());
+            Assert::IsNull(collector, L"No collector on error", LINE_INFO());
+            Assert::AreNotEqual(std::size_t(0), ::strlen(::pwrowg_last_error()), L"Error description", LINE_INFO());
+
+            Assert::AreEqual(PWROWG_INVALID_ARGUMENT, ::pwrowg_collector_start(nullptr), L"Collector required", LINE_INFO());
+            Assert::AreEqual(PWROWG_INVALID_ARGUMENT, ::pwrowg_collector_marker(nullptr, nullptr), L"Marker requires collector", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(0), ::pwrowg_subscriber_lost(nullptr), L"No losses without subscriber", LINE_INFO());
+            Assert::IsNull(::pwrowg_subscriber_sensor(nullptr, 0), L"No sensor without subscriber", LINE_INFO());
+
+            ::pwrowg_collector_close(nullptr);
+            ::pwrowg_subscriber_close(nullptr);
+        }
+
+        TEST_METHOD(test_batches) {
+            collector_settings settings;
+            settings.output_path(L"c_api_batches.csv").sampling_interval(1000);
+
+            std::unique_ptr<pwrowg_collector> collector(new pwrowg_collector {
+                collector::from_sensors(settings, synthetic_sensor(L"synth"))
+            });
+
+            pwrowg_subscriber *subscriber = nullptr;
+            Assert::AreEqual(PWROWG_SUCCESS, ::pwrowg_collector_subscribe(collector.get(), 0, &subscriber), L"Subscribe", LINE_INFO());
+            Assert::IsNotNull(subscriber, L"Subscriber created", LINE_INFO());
+
+            pwrowg_batch batch;
+            Assert::AreEqual(PWROWG_TIMEOUT, ::pwrowg_subscriber_acquire(subscriber, 0, 1, &batch), L"Nothing before start", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), batch.count, L"Empty batch on timeout", LINE_INFO());
+
+            Assert::AreEqual(PWROWG_SUCCESS, ::pwrowg_collector_start(collector.get()), L"Start", LINE_INFO());
+            Assert::AreEqual(PWROWG_SUCCESS, ::pwrowg_collector_marker(collector.get(), "marker"), L"Marker", LINE_INFO());
+
+            pwrowg_batch first, second;
+            Assert::AreEqual(PWROWG_SUCCESS, ::pwrowg_subscriber_acquire(subscriber, 1, 5000, &first), L"First batch", LINE_INFO());
+            Assert::AreEqual(PWROWG_SUCCESS, ::pwrowg_subscriber_acquire(subscriber, 0, 5000, &second), L"Second batch", LINE_INFO());
+            Assert::AreEqual(PWROWG_SUCCESS, ::pwrowg_collector_stop(collector.get()), L"Stop", LINE_INFO());
+
+            Assert::AreEqual(std::size_t(1), first.count, L"Capacity respected", LINE_INFO());
+            Assert::IsTrue(second.count > 0, L"Pending samples", LINE_INFO());
+            Assert::IsTrue(first.power != second.power, L"Batches held at the same time use different buffers", LINE_INFO());
+            Assert::AreEqual("synth", ::pwrowg_subscriber_sensor(subscriber, first.sensors[0]), L"Sensor name", LINE_INFO());
+            Assert::IsNull(::pwrowg_subscriber_sensor(subscriber, 1), L"Invalid sensor index", LINE_INFO());
+            Assert::IsTrue(first.timestamps[0] <= second.timestamps[0], L"Samples in order", LINE_INFO());
+            Assert::IsFalse(std::isnan(first.power[0]), L"Power measured", LINE_INFO());
+
+            Assert::AreEqual(PWROWG_SUCCESS, ::pwrowg_subscriber_release(subscriber, &first), L"Release first", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), first.count, L"Released batch emptied", LINE_INFO());
+            Assert::AreEqual(PWROWG_SUCCESS, ::pwrowg_subscriber_release(subscriber, &first), L"Releasing empty batch", LINE_INFO());
+
+            pwrowg_batch copy = second;
+            Assert::AreEqual(PWROWG_SUCCESS, ::pwrowg_subscriber_release(subscriber, &second), L"Release second", LINE_INFO());
+            Assert::AreEqual(PWROWG_INVALID_ARGUMENT, ::pwrowg_subscriber_release(subscriber, &copy), L"Double release", LINE_INFO());
+
+            ::pwrowg_subscriber_close(subscriber);
+            ::pwrowg_collector_close(collector.release());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,79 @@
+﻿// <copyright file="clock_settle_detector_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(clock_settle_detector_test) {
+
+    public:
+
+        TEST_METHOD(test_invalid) {
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                detail::clock_settle_detector detector(0, 0.01f);
+            }, L"Empty window", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                detail::clock_settle_detector detector(4, -0.01f);
+            }, L"Negative tolerance", LINE_INFO());
+        }
+
+        TEST_METHOD(test_settle) {
+            typedef detail::clock_settle_detector::clock_type clock_type;
+            detail::clock_settle_detector detector(3, 0.01f);
+            Assert::IsFalse(detector.settled(), L"No readings", LINE_INFO());
+
+            {
+                const clock_type clocks[] = { 1000, 1500 };
+                Assert::IsFalse(detector.push(clocks, 2), L"Window not full", LINE_INFO());
+            }
+
+            {
+                const clock_type clocks[] = { 1005, 1500 };
+                Assert::IsFalse(detector.push(clocks, 2), L"Window not full", LINE_INFO());
+            }
+
+            {
+                const clock_type clocks[] = { 1200, 1500 };
+                Assert::IsFalse(detector.push(clocks, 2), L"First GPU not settled", LINE_INFO());
+            }
+
+            {
+                const clock_type clocks[] = { 1198, 1500 };
+                Assert::IsFalse(detector.push(clocks, 2), L"Boost still in window", LINE_INFO());
+            }
+
+            {
+                const clock_type clocks[] = { 1195, 1505 };
+                Assert::IsTrue(detector.push(clocks, 2), L"All GPUs settled", LINE_INFO());
+            }
+
+            {
+                const clock_type clocks[] = { 1195 };
+                Assert::IsFalse(detector.push(clocks, 1), L"Changed GPUs reset history", LINE_INFO());
+            }
+
+            detector.reset();
+            Assert::IsFalse(detector.settled(), L"Reset", LINE_INFO());
+        }
+
+        TEST_METHOD(test_no_gpus) {
+            detail::clock_settle_detector detector(1, 0.0f);
+            Assert::IsFalse(detector.push(nullptr, 0), L"Nothing to verify", LINE_INFO());
+
+            const detail::clock_settle_detector::clock_type clock = 800;
+            Assert::IsTrue(detector.push(&clock, 1), L"Single reading", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
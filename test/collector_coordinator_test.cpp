@@ -0,0 +1,79 @@
+﻿// <copyright file="collector_coordinator_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(collector_coordinator_test) {
+
+    public:
+
+        TEST_METHOD(test_disposed) {
+            collector_coordinator coordinator;
+            Assert::IsFalse(bool(coordinator), L"Default is disposed", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), coordinator.nodes(), L"No nodes", LINE_INFO());
+            Assert::ExpectException<std::runtime_error>([&coordinator](void) {
+                coordinator.start();
+            }, L"Start disposed", LINE_INFO());
+
+            collector_agent agent;
+            collector collector;
+            Assert::ExpectException<std::invalid_argument>([&](void) {
+                agent.start(collector);
+            }, L"Disposed collector", LINE_INFO());
+        }
+
+        TEST_METHOD(test_loopback) {
+#if defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER)
+            {
+                auto collector = collector::from_sensors(collector_settings().output_path(L"collector_coordinator.csv").sampling_interval(1000), synthetic_sensor(L"synth", synthetic_waveform::constant));
+
+                collector_agent agent;
+                agent.start(collector, 48630, L"127.0.0.1");
+
+                auto coordinator = collector_coordinator::create(AF_INET, 48631);
+                coordinator.add("127.0.0.1", 48630);
+                Assert::AreEqual(std::size_t(1), coordinator.nodes(), L"One node", LINE_INFO());
+                Assert::IsTrue(::wcslen(coordinator.node(0)) > 0, L"Node has a name", LINE_INFO());
+
+                coordinator.start(200000);
+                Assert::IsTrue(coordinator.start_deviation(0) < 10000, L"Started close to the instant", LINE_INFO());
+
+                coordinator.marker(L"phase");
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                coordinator.marker(nullptr);
+
+                coordinator.stop();
+                Assert::IsTrue(coordinator.samples(0) > 0, L"Samples reported", LINE_INFO());
+                Assert::ExpectException<std::out_of_range>([&coordinator](void) {
+                    coordinator.samples(1);
+                }, L"Invalid node", LINE_INFO());
+            }
+
+            std::wifstream csv("collector_coordinator.csv");
+            auto have_marker = false;
+            for (std::wstring line; std::getline(csv, line);) {
+                have_marker = have_marker || (line.find(L"phase") != std::wstring::npos);
+            }
+            Assert::IsTrue(have_marker, L"Marker set by coordinator", LINE_INFO());
+
+#else /* defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER) */
+            Assert::ExpectException<std::logic_error>([](void) {
+                collector_coordinator::create(AF_INET);
+            }, L"Requires the time synchroniser", LINE_INFO());
+#endif /* defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER) */
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,128 @@
+﻿// <copyright file="collector_daemon_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(collector_daemon_test) {
+
+    public:
+
+        TEST_METHOD(test_disposed) {
+            collector_daemon daemon;
+            Assert::IsTrue(bool(daemon), L"New daemon is valid", LINE_INFO());
+
+            collector collector;
+            Assert::ExpectException<std::invalid_argument>([&](void) {
+                daemon.start(collector);
+            }, L"Disposed collector", LINE_INFO());
+
+            collector_client client;
+            Assert::IsFalse(bool(client), L"Default client is invalid", LINE_INFO());
+            Assert::IsFalse(client.active(), L"Default client inactive", LINE_INFO());
+            Assert::IsFalse(client.recording(), L"Default client not recording", LINE_INFO());
+            Assert::IsNull(client.marker_channel(), L"No marker channel", LINE_INFO());
+            Assert::ExpectException<std::runtime_error>([&client](void) {
+                client.stop();
+            }, L"Stop without daemon", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                collector_client c(nullptr);
+            }, L"Null channel", LINE_INFO());
+            Assert::ExpectException<std::system_error>([](void) {
+                collector_client c("PwrOwgTestDoesNotExist");
+            }, L"Missing daemon", LINE_INFO());
+        }
+
+        TEST_METHOD(test_recording) {
+            auto collector = collector::from_sensors(collector_settings().output_path(L"collector_daemon.csv").sampling_interval(1000).marker_channel(L"PwrOwgDaemonTestMarkers"), synthetic_sensor(L"synth", synthetic_waveform::constant));
+
+            collector_daemon daemon;
+            daemon.start(collector, L"PwrOwgDaemonTest");
+            Assert::ExpectException<std::logic_error>([&](void) {
+                daemon.start(collector, L"PwrOwgDaemonTest");
+            }, L"Already running", LINE_INFO());
+
+            collector_client client("PwrOwgDaemonTest");
+            Assert::IsTrue(client.active(), L"Daemon serving", LINE_INFO());
+            Assert::IsFalse(client.recording(), L"Not yet recording", LINE_INFO());
+            Assert::AreEqual(std::string("PwrOwgDaemonTestMarkers"), std::string(client.marker_channel()), L"Marker channel advertised", LINE_INFO());
+            Assert::IsNull(client.shared_memory(), L"No shared memory", LINE_INFO());
+
+            Assert::ExpectException<std::runtime_error>([&client](void) {
+                client.start("../collector_daemon");
+            }, L"Path outside directory", LINE_INFO());
+            Assert::ExpectException<std::runtime_error>([&client](void) {
+                client.stop();
+            }, L"Stop without recording", LINE_INFO());
+
+            for (auto name : { "collector_daemon_run1", "collector_daemon_run2" }) {
+                client.start(name);
+                Assert::IsTrue(client.recording(), L"Recording", LINE_INFO());
+                Assert::ExpectException<std::runtime_error>([&client](void) {
+                    client.start("collector_daemon_run3");
+                }, L"Recording already running", LINE_INFO());
+
+                {
+                    auto markers = client.markers();
+                    Assert::IsTrue(markers.marker(name), L"Set marker", LINE_INFO());
+                    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                }
+
+                std::uint64_t samples = 0;
+                std::uint64_t overflows = 0;
+                client.stop(&samples, &overflows);
+                Assert::IsFalse(client.recording(), L"Recording stopped", LINE_INFO());
+                Assert::IsTrue(samples > 0, L"Samples reported", LINE_INFO());
+
+                std::ifstream file(std::string(name) + ".csv");
+                const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+                Assert::IsTrue(content.find(name) != std::string::npos, L"Recording written to its own file", LINE_INFO());
+            }
+
+            daemon.stop();
+            Assert::IsFalse(client.active(), L"Daemon stopped", LINE_INFO());
+        }
+
+        TEST_METHOD(test_abandoned_claim) {
+            typedef detail::collector_daemon_state state_type;
+            auto collector = collector::from_sensors(collector_settings().output_path(L"collector_daemon.csv").sampling_interval(1000), synthetic_sensor(L"synth", synthetic_waveform::constant));
+
+            collector_daemon daemon;
+            daemon.start(collector, L"PwrOwgDaemonAbandonTest");
+
+            // Act like a client that has died while holding the slot, which
+            // we do via a second mapping of the segment.
+            detail::shared_memory_segment segment;
+            segment.open(L"PwrOwgDaemonAbandonTest", true);
+            auto header = static_cast<detail::collector_daemon_header *>(segment.data());
+            const std::uint64_t dead_process = 0x7ffffff0;
+
+            collector_client client("PwrOwgDaemonAbandonTest");
+            for (auto state : { state_type::claimed, state_type::completed }) {
+                header->owner.store(dead_process);
+                header->claim_time.store(static_cast<std::uint64_t>(state));
+                header->state.store(static_cast<std::uint32_t>(state));
+
+                client.start("collector_daemon_abandoned");
+                Assert::IsTrue(client.recording(), L"Slot of dead client released", LINE_INFO());
+                client.stop();
+                Assert::IsFalse(client.recording(), L"Recording stopped", LINE_INFO());
+            }
+
+            daemon.stop();
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
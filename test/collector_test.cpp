@@ -13,6 +13,46 @@ namespace visus {
 namespace power_overwhelming {
 namespace test {
 
+    /// <summary>
+    /// A movable sensor that always returns the same power.
+    /// </summary>
+    class constant_sensor final : public sensor {
+
+    public:
+
+        inline constant_sensor(const wchar_t *name) : _name(name) { }
+
+        inline constant_sensor(constant_sensor&& rhs) noexcept
+                : _name(rhs._name) {
+            rhs._name = nullptr;
+        }
+
+        ~constant_sensor(void) {
+            this->sample_batch(nullptr);
+        }
+
+        virtual const wchar_t *name(void) const noexcept override {
+            return this->_name;
+        }
+
+        virtual operator bool(void) const noexcept override {
+            return (this->_name != nullptr);
+        }
+
+    protected:
+
+        measurement_data sample_sync(
+                const timestamp_resolution resolution) const override {
+            return measurement_data(detail::create_timestamp(resolution),
+                42.0f);
+        }
+
+    private:
+
+        const wchar_t *_name;
+    };
+
+
     TEST_CLASS(collector_test) {
 
     public:
@@ -21,14 +61,352 @@ namespace test {
             collector_settings settings;
             Assert::AreEqual(collector_settings::default_output_path, settings.output_path(), L"Default for output_path", LINE_INFO());
             Assert::AreEqual(collector_settings::default_sampling_interval, settings.sampling_interval(), L"Default for sampling_interval", LINE_INFO());
+            Assert::AreEqual(collector_settings::default_buffer_size, settings.buffer_size(), L"Default for buffer_size", LINE_INFO());
+            Assert::IsTrue(output_format::csv == settings.output_format(), L"Default for output_format", LINE_INFO());
+            Assert::IsFalse(settings.require_marker(), L"Default for require_marker", LINE_INFO());
+            Assert::IsFalse(settings.limit_to_native_interval(), L"Default for limit_to_native_interval", LINE_INFO());
+            Assert::IsFalse(settings.lock_memory(), L"Default for lock_memory", LINE_INFO());
+            Assert::IsFalse(settings.manual_pump(), L"Default for manual_pump", LINE_INFO());
+            Assert::AreEqual(0.0f, settings.sampling_cpu_budget(), L"Default for sampling_cpu_budget", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(0), settings.sampling_read_budget(), L"Default for sampling_read_budget", LINE_INFO());
+            Assert::AreEqual(1.0f, settings.sensor_priority(L"nvml_sensor"), L"Default for sensor_priority", LINE_INFO());
+            Assert::IsFalse(settings.integrate_instruments(), L"Default for integrate_instruments", LINE_INFO());
+            Assert::IsFalse(settings.suppress_duplicates(), L"Default for suppress_duplicates", LINE_INFO());
+            Assert::IsFalse(settings.tinkerforge_arrival_times(), L"Default for tinkerforge_arrival_times", LINE_INFO());
+            Assert::IsFalse(settings.track_quantiles(), L"Default for track_quantiles", LINE_INFO());
+            Assert::IsFalse(settings.track_sequences(), L"Default for track_sequences", LINE_INFO());
+            Assert::AreEqual(collector_settings::sampling_interval_type(0), settings.rotate_interval(), L"Default for rotate_interval", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(0), settings.rotate_size(), L"Default for rotate_size", LINE_INFO());
+            Assert::IsFalse(settings.trigger_oscilloscopes(), L"Default for trigger_oscilloscopes", LINE_INFO());
+            Assert::AreEqual(collector_settings::sampling_interval_type(0), settings.min_sampling_interval(), L"Default for min_sampling_interval", LINE_INFO());
+            Assert::IsNull(settings.kernel_energy(), L"Default for kernel_energy", LINE_INFO());
+            Assert::IsNull(settings.process_energy(), L"Default for process_energy", LINE_INFO());
+            Assert::IsNull(settings.capability_report(), L"Default for capability_report", LINE_INFO());
+            Assert::IsFalse(settings.compress_waveforms(), L"Default for compress_waveforms", LINE_INFO());
+            Assert::IsNull(settings.waveform_archive(), L"Default for waveform_archive", LINE_INFO());
+            Assert::IsNull(settings.overhead_report(), L"Default for overhead_report", LINE_INFO());
+            Assert::AreEqual(collector_settings::sampling_interval_type(0), settings.overhead_interval(), L"Default for overhead_interval", LINE_INFO());
+            Assert::AreEqual(collector_settings::sampling_interval_type(0), settings.overhead_window(), L"Default for overhead_window", LINE_INFO());
 
-            settings.output_path(L"bla.txt").sampling_interval(42);
+            settings.output_path(L"bla.txt").sampling_interval(42).buffer_size(128).output_format(output_format::binary).require_marker(true);
+            settings.limit_to_native_interval(true).suppress_duplicates(true).min_sampling_interval(10);
+            settings.lock_memory(true).manual_pump(true).tinkerforge_arrival_times(true);
+            settings.sampling_cpu_budget(0.02f).sampling_read_budget(1000).sensor_priority(L"nvml_sensor", 2.0f);
+            settings.integrate_instruments(true);
+            settings.track_quantiles(true).track_sequences(true).rotate_interval(3600000000).rotate_size(1 << 30);
+            settings.trigger_oscilloscopes(true).kernel_energy(L"kernels.csv").process_energy(L"processes.csv");
+            settings.capability_report(L"capabilities.json");
+            settings.compress_waveforms(true).waveform_archive(L"waveforms.bin");
+            settings.overhead_report(L"overhead.csv").overhead_interval(100000).overhead_window(2000000);
             Assert::AreEqual(L"bla.txt", settings.output_path(), L"Set output_path", LINE_INFO());
             Assert::AreEqual(collector_settings::sampling_interval_type(42), settings.sampling_interval(), L"Set sampling_interval", LINE_INFO());
+            Assert::AreEqual(std::size_t(128), settings.buffer_size(), L"Set buffer_size", LINE_INFO());
+            Assert::IsTrue(output_format::binary == settings.output_format(), L"Set output_format", LINE_INFO());
+            Assert::IsTrue(settings.require_marker(), L"Set require_marker", LINE_INFO());
+            Assert::IsTrue(settings.limit_to_native_interval(), L"Set limit_to_native_interval", LINE_INFO());
+            Assert::IsTrue(settings.lock_memory(), L"Set lock_memory", LINE_INFO());
+            Assert::IsTrue(settings.manual_pump(), L"Set manual_pump", LINE_INFO());
+            Assert::AreEqual(0.02f, settings.sampling_cpu_budget(), L"Set sampling_cpu_budget", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(1000), settings.sampling_read_budget(), L"Set sampling_read_budget", LINE_INFO());
+            Assert::AreEqual(2.0f, settings.sensor_priority(L"nvml_sensor"), L"Set sensor_priority", LINE_INFO());
+            Assert::AreEqual(std::size_t(1), settings.sensor_priorities(nullptr, 0), L"One priority", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&settings](void) { settings.sampling_cpu_budget(-1.0f); }, L"Negative sampling_cpu_budget", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&settings](void) { settings.sensor_priority(L"nvml_sensor", -1.0f); }, L"Negative sensor_priority", LINE_INFO());
+            Assert::IsTrue(settings.integrate_instruments(), L"Set integrate_instruments", LINE_INFO());
+            Assert::IsTrue(settings.suppress_duplicates(), L"Set suppress_duplicates", LINE_INFO());
+            Assert::IsTrue(settings.tinkerforge_arrival_times(), L"Set tinkerforge_arrival_times", LINE_INFO());
+            Assert::IsTrue(settings.track_quantiles(), L"Set track_quantiles", LINE_INFO());
+            Assert::IsTrue(settings.track_sequences(), L"Set track_sequences", LINE_INFO());
+            Assert::AreEqual(collector_settings::sampling_interval_type(3600000000), settings.rotate_interval(), L"Set rotate_interval", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(1 << 30), settings.rotate_size(), L"Set rotate_size", LINE_INFO());
+            Assert::IsTrue(settings.trigger_oscilloscopes(), L"Set trigger_oscilloscopes", LINE_INFO());
+            Assert::AreEqual(collector_settings::sampling_interval_type(10), settings.min_sampling_interval(), L"Set min_sampling_interval", LINE_INFO());
+            Assert::AreEqual(L"kernels.csv", settings.kernel_energy(), L"Set kernel_energy", LINE_INFO());
+            Assert::AreEqual(L"processes.csv", settings.process_energy(), L"Set process_energy", LINE_INFO());
+            Assert::AreEqual(L"capabilities.json", settings.capability_report(), L"Set capability_report", LINE_INFO());
+            Assert::IsTrue(settings.compress_waveforms(), L"Set compress_waveforms", LINE_INFO());
+            Assert::AreEqual(L"waveforms.bin", settings.waveform_archive(), L"Set waveform_archive", LINE_INFO());
+            Assert::AreEqual(L"overhead.csv", settings.overhead_report(), L"Set overhead_report", LINE_INFO());
+            Assert::AreEqual(collector_settings::sampling_interval_type(100000), settings.overhead_interval(), L"Set overhead_interval", LINE_INFO());
+            Assert::AreEqual(collector_settings::sampling_interval_type(2000000), settings.overhead_window(), L"Set overhead_window", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&settings](void) { settings.buffer_size(0); }, L"Zero buffer_size", LINE_INFO());
 
             auto copy = settings;
             Assert::AreEqual(settings.output_path(), copy.output_path(), L"Copy output_path", LINE_INFO());
             Assert::AreEqual(settings.sampling_interval(), copy.sampling_interval(), L"Copy sampling_interval", LINE_INFO());
+            Assert::AreEqual(settings.buffer_size(), copy.buffer_size(), L"Copy buffer_size", LINE_INFO());
+            Assert::IsTrue(settings.output_format() == copy.output_format(), L"Copy output_format", LINE_INFO());
+            Assert::AreEqual(settings.require_marker(), copy.require_marker(), L"Copy require_marker", LINE_INFO());
+            Assert::AreEqual(settings.limit_to_native_interval(), copy.limit_to_native_interval(), L"Copy limit_to_native_interval", LINE_INFO());
+            Assert::AreEqual(settings.lock_memory(), copy.lock_memory(), L"Copy lock_memory", LINE_INFO());
+            Assert::AreEqual(settings.manual_pump(), copy.manual_pump(), L"Copy manual_pump", LINE_INFO());
+            Assert::AreEqual(settings.sampling_cpu_budget(), copy.sampling_cpu_budget(), L"Copy sampling_cpu_budget", LINE_INFO());
+            Assert::AreEqual(settings.sampling_read_budget(), copy.sampling_read_budget(), L"Copy sampling_read_budget", LINE_INFO());
+            Assert::AreEqual(settings.sensor_priority(L"nvml_sensor"), copy.sensor_priority(L"nvml_sensor"), L"Copy sensor_priority", LINE_INFO());
+            Assert::AreEqual(settings.integrate_instruments(), copy.integrate_instruments(), L"Copy integrate_instruments", LINE_INFO());
+            Assert::AreEqual(settings.suppress_duplicates(), copy.suppress_duplicates(), L"Copy suppress_duplicates", LINE_INFO());
+            Assert::AreEqual(settings.tinkerforge_arrival_times(), copy.tinkerforge_arrival_times(), L"Copy tinkerforge_arrival_times", LINE_INFO());
+            Assert::AreEqual(settings.track_quantiles(), copy.track_quantiles(), L"Copy track_quantiles", LINE_INFO());
+            Assert::AreEqual(settings.track_sequences(), copy.track_sequences(), L"Copy track_sequences", LINE_INFO());
+            Assert::AreEqual(settings.rotate_interval(), copy.rotate_interval(), L"Copy rotate_interval", LINE_INFO());
+            Assert::AreEqual(settings.rotate_size(), copy.rotate_size(), L"Copy rotate_size", LINE_INFO());
+            Assert::AreEqual(settings.trigger_oscilloscopes(), copy.trigger_oscilloscopes(), L"Copy trigger_oscilloscopes", LINE_INFO());
+            Assert::AreEqual(settings.min_sampling_interval(), copy.min_sampling_interval(), L"Copy min_sampling_interval", LINE_INFO());
+            Assert::AreEqual(settings.kernel_energy(), copy.kernel_energy(), L"Copy kernel_energy", LINE_INFO());
+            Assert::AreEqual(settings.process_energy(), copy.process_energy(), L"Copy process_energy", LINE_INFO());
+            Assert::AreEqual(settings.capability_report(), copy.capability_report(), L"Copy capability_report", LINE_INFO());
+            Assert::AreEqual(settings.compress_waveforms(), copy.compress_waveforms(), L"Copy compress_waveforms", LINE_INFO());
+            Assert::AreEqual(settings.waveform_archive(), copy.waveform_archive(), L"Copy waveform_archive", LINE_INFO());
+            Assert::AreEqual(settings.overhead_report(), copy.overhead_report(), L"Copy overhead_report", LINE_INFO());
+            Assert::AreEqual(settings.overhead_interval(), copy.overhead_interval(), L"Copy overhead_interval", LINE_INFO());
+            Assert::AreEqual(settings.overhead_window(), copy.overhead_window(), L"Copy overhead_window", LINE_INFO());
+
+            settings.kernel_energy(L"");
+            Assert::IsNull(settings.kernel_energy(), L"Empty kernel_energy", LINE_INFO());
+
+            settings.process_energy(L"");
+            Assert::IsNull(settings.process_energy(), L"Empty process_energy", LINE_INFO());
+
+            settings.capability_report(L"");
+            Assert::IsNull(settings.capability_report(), L"Empty capability_report", LINE_INFO());
+        }
+
+        TEST_METHOD(test_sensor_intervals) {
+            collector_settings settings;
+            settings.sampling_interval(1000);
+            Assert::AreEqual(std::size_t(0), settings.sensor_intervals(nullptr, 0), L"No specific intervals", LINE_INFO());
+            Assert::AreEqual(collector_settings::sampling_interval_type(1000), settings.sensor_interval(L"hmc8015_sensor"), L"Fallback to global interval", LINE_INFO());
+
+            settings.sensor_interval(L"hmc8015_sensor", 100000).sensor_interval(L"sensor1", 2000);
+            Assert::AreEqual(std::size_t(2), settings.sensor_intervals(nullptr, 0), L"Two specific intervals", LINE_INFO());
+            Assert::AreEqual(collector_settings::sampling_interval_type(100000), settings.sensor_interval(L"hmc8015_sensor"), L"Type interval", LINE_INFO());
+            Assert::AreEqual(collector_settings::sampling_interval_type(2000), settings.sensor_interval(L"sensor1"), L"Sensor interval", LINE_INFO());
+            Assert::AreEqual(collector_settings::sampling_interval_type(1000), settings.sensor_interval(nullptr), L"Null sensor", LINE_INFO());
+
+            const wchar_t *names[2];
+            settings.sensor_intervals(names, 2);
+            Assert::AreEqual(L"hmc8015_sensor", names[0], L"First name", LINE_INFO());
+            Assert::AreEqual(L"sensor1", names[1], L"Second name", LINE_INFO());
+
+            auto copy = settings;
+            settings.sensor_interval(L"hmc8015_sensor", 0);
+            Assert::AreEqual(std::size_t(1), settings.sensor_intervals(nullptr, 0), L"Interval removed", LINE_INFO());
+            Assert::AreEqual(collector_settings::sampling_interval_type(1000), settings.sensor_interval(L"hmc8015_sensor"), L"Removed interval falls back", LINE_INFO());
+            Assert::AreEqual(std::size_t(2), copy.sensor_intervals(nullptr, 0), L"Copy retains intervals", LINE_INFO());
+            Assert::AreEqual(collector_settings::sampling_interval_type(100000), copy.sensor_interval(L"hmc8015_sensor"), L"Copy type interval", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([&settings](void) {
+                settings.sensor_interval(nullptr, 1000);
+            }, L"Null sensor name", LINE_INFO());
+        }
+
+        TEST_METHOD(test_sensor_quantities) {
+            collector_settings settings;
+            Assert::AreEqual(std::size_t(0), settings.sensor_quantities(nullptr, 0), L"No quantities", LINE_INFO());
+            Assert::IsTrue(tinkerforge_sensor_source::none == settings.sensor_quantity(L"tinkerforge_sensor"), L"Default quantities", LINE_INFO());
+
+            const auto vi = tinkerforge_sensor_source::voltage | tinkerforge_sensor_source::current;
+            settings.sensor_quantity(L"tinkerforge_sensor", tinkerforge_sensor_source::all).sensor_quantity(L"sensor1", vi);
+            Assert::AreEqual(std::size_t(2), settings.sensor_quantities(nullptr, 0), L"Two quantities", LINE_INFO());
+            Assert::IsTrue(tinkerforge_sensor_source::all == settings.sensor_quantity(L"tinkerforge_sensor"), L"Type quantities", LINE_INFO());
+            Assert::IsTrue(vi == settings.sensor_quantity(L"sensor1"), L"Sensor quantities", LINE_INFO());
+
+            auto copy = settings;
+            settings.sensor_quantity(L"sensor1", tinkerforge_sensor_source::none);
+            Assert::AreEqual(std::size_t(1), settings.sensor_quantities(nullptr, 0), L"Quantities removed", LINE_INFO());
+            Assert::IsTrue(vi == copy.sensor_quantity(L"sensor1"), L"Copy retains quantities", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([&settings](void) {
+                settings.sensor_quantity(nullptr, tinkerforge_sensor_source::power);
+            }, L"Null sensor name", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&settings](void) {
+                settings.sensor_quantity(L"sensor1", static_cast<tinkerforge_sensor_source>(0x10));
+            }, L"Invalid quantities", LINE_INFO());
+
+            Assert::IsTrue(vi == parse_tinkerforge_sensor_source(L"voltage|current"), L"Parse combination", LINE_INFO());
+            Assert::IsTrue(vi == parse_tinkerforge_sensor_source(to_string(vi)), L"Round trip combination", LINE_INFO());
+            Assert::IsTrue(tinkerforge_sensor_source::power == parse_tinkerforge_sensor_source(L"power"), L"Parse power", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                parse_tinkerforge_sensor_source(L"power|");
+            }, L"Trailing separator", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                parse_tinkerforge_sensor_source(L"energy");
+            }, L"Unknown quantity", LINE_INFO());
+        }
+
+        TEST_METHOD(test_sensor_delays) {
+            collector_settings settings;
+            Assert::AreEqual(std::size_t(0), settings.sensor_delays(nullptr, 0), L"No delays", LINE_INFO());
+            Assert::AreEqual(collector_settings::sampling_interval_type(0), settings.sensor_delay(L"nvml_sensor"), L"No delay", LINE_INFO());
+
+            settings.sensor_delay(L"nvml_sensor", 50000).sensor_delay(L"sensor1", 1200);
+            Assert::AreEqual(std::size_t(2), settings.sensor_delays(nullptr, 0), L"Two delays", LINE_INFO());
+            Assert::AreEqual(collector_settings::sampling_interval_type(50000), settings.sensor_delay(L"nvml_sensor"), L"Type delay", LINE_INFO());
+            Assert::AreEqual(collector_settings::sampling_interval_type(1200), settings.sensor_delay(L"sensor1"), L"Sensor delay", LINE_INFO());
+            Assert::AreEqual(collector_settings::sampling_interval_type(collector_settings::default_sampling_interval), settings.sensor_interval(L"sensor1"), L"Interval unaffected", LINE_INFO());
+
+            auto copy = settings;
+            settings.sensor_delay(L"nvml_sensor", 0);
+            Assert::AreEqual(std::size_t(1), settings.sensor_delays(nullptr, 0), L"Delay removed", LINE_INFO());
+            Assert::AreEqual(std::size_t(2), copy.sensor_delays(nullptr, 0), L"Copy retains delays", LINE_INFO());
+            Assert::AreEqual(collector_settings::sampling_interval_type(50000), copy.sensor_delay(L"nvml_sensor"), L"Copy type delay", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([&settings](void) {
+                settings.sensor_delay(nullptr, 1000);
+            }, L"Null sensor name", LINE_INFO());
+        }
+
+        TEST_METHOD(test_delta_thresholds) {
+            collector_settings settings;
+            Assert::AreEqual(std::size_t(0), settings.delta_thresholds(nullptr, 0), L"No thresholds", LINE_INFO());
+            Assert::IsTrue(settings.delta_threshold(L"msr_sensor") < 0.0f, L"No threshold for type", LINE_INFO());
+            Assert::AreEqual(collector_settings::sampling_interval_type(0), settings.keep_alive_interval(), L"Default for keep_alive_interval", LINE_INFO());
+
+            settings.delta_threshold(L"msr_sensor", 0.5f).delta_threshold(L"sensor1", 0.0f).keep_alive_interval(1000000);
+            Assert::AreEqual(std::size_t(2), settings.delta_thresholds(nullptr, 0), L"Two thresholds", LINE_INFO());
+            Assert::AreEqual(0.5f, settings.delta_threshold(L"msr_sensor"), L"Type threshold", LINE_INFO());
+            Assert::AreEqual(0.0f, settings.delta_threshold(L"sensor1"), L"Zero threshold", LINE_INFO());
+            Assert::AreEqual(collector_settings::sampling_interval_type(1000000), settings.keep_alive_interval(), L"Set keep_alive_interval", LINE_INFO());
+
+            auto copy = settings;
+            settings.delta_threshold(L"msr_sensor", -1.0f);
+            Assert::AreEqual(std::size_t(1), settings.delta_thresholds(nullptr, 0), L"Threshold removed", LINE_INFO());
+            Assert::IsTrue(settings.delta_threshold(L"msr_sensor") < 0.0f, L"Removed threshold", LINE_INFO());
+            Assert::AreEqual(std::size_t(2), copy.delta_thresholds(nullptr, 0), L"Copy retains thresholds", LINE_INFO());
+            Assert::AreEqual(0.5f, copy.delta_threshold(L"msr_sensor"), L"Copy type threshold", LINE_INFO());
+            Assert::AreEqual(settings.keep_alive_interval(), copy.keep_alive_interval(), L"Copy keep_alive_interval", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([&settings](void) {
+                settings.delta_threshold(nullptr, 1.0f);
+            }, L"Null sensor name", LINE_INFO());
+        }
+
+        TEST_METHOD(test_estimate_power) {
+            collector_settings settings;
+            Assert::IsFalse(settings.estimate_power(), L"Disabled by default", LINE_INFO());
+
+            settings.estimate_power(true);
+            Assert::IsTrue(settings.estimate_power(), L"Enabled", LINE_INFO());
+
+            auto copy = settings;
+            Assert::IsTrue(copy.estimate_power(), L"Copied", LINE_INFO());
+        }
+
+        TEST_METHOD(test_filters) {
+            collector_settings settings;
+            Assert::AreEqual(std::size_t(0), settings.filters(nullptr, 0), L"No filters", LINE_INFO());
+            Assert::IsFalse(settings.filter(L"tinkerforge_sensor"), L"No filter for type", LINE_INFO());
+            Assert::IsFalse(settings.retain_unfiltered(), L"Default for retain_unfiltered", LINE_INFO());
+
+            settings.filter(L"tinkerforge_sensor", sample_filter::median(5)).filter(L"adl/0", sample_filter::exponential(0.25f)).retain_unfiltered(true);
+            Assert::AreEqual(std::size_t(2), settings.filters(nullptr, 0), L"Two filters", LINE_INFO());
+            Assert::IsTrue(settings.filter(L"tinkerforge_sensor").type() == sample_filter_type::median, L"Type filter", LINE_INFO());
+            Assert::AreEqual(std::size_t(5), settings.filter(L"tinkerforge_sensor").window(), L"Window", LINE_INFO());
+            Assert::AreEqual(0.25f, settings.filter(L"adl/0").alpha(), L"Alpha", LINE_INFO());
+            Assert::IsTrue(settings.retain_unfiltered(), L"Set retain_unfiltered", LINE_INFO());
+
+            auto copy = settings;
+            settings.filter(L"adl/0", sample_filter());
+            Assert::AreEqual(std::size_t(1), settings.filters(nullptr, 0), L"Filter removed", LINE_INFO());
+            Assert::AreEqual(std::size_t(2), copy.filters(nullptr, 0), L"Copy retains filters", LINE_INFO());
+            Assert::AreEqual(0.25f, copy.filter(L"adl/0").alpha(), L"Copy alpha", LINE_INFO());
+            Assert::IsTrue(copy.retain_unfiltered(), L"Copy retain_unfiltered", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([&settings](void) {
+                settings.filter(nullptr, sample_filter::median(3));
+            }, L"Null sensor name", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) { sample_filter::median(4); }, L"Even window", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) { sample_filter::exponential(0.0f); }, L"Zero alpha", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) { sample_filter::low_pass(15, 0.5f); }, L"Cut-off at Nyquist", LINE_INFO());
+        }
+
+        TEST_METHOD(test_derived_sensors) {
+            collector_settings settings;
+            Assert::AreEqual(std::size_t(0), settings.derived_sensors(nullptr, 0), L"No derived sensors", LINE_INFO());
+            Assert::IsNull(settings.derived_sensor(L"total"), L"No expression", LINE_INFO());
+
+            settings.derived_sensor(L"total", L"[a] + [b]").derived_sensor(L"twice", L"2 * [total]").derived_sensor(L"ratio", L"[a] / [b]");
+            Assert::AreEqual(std::size_t(3), settings.derived_sensors(nullptr, 0), L"Three derived sensors", LINE_INFO());
+            Assert::AreEqual(L"[a] + [b]", settings.derived_sensor(L"total"), L"Expression", LINE_INFO());
+
+            auto copy = settings;
+            settings.derived_sensor(L"total", nullptr);
+            const wchar_t *names[2];
+            Assert::AreEqual(std::size_t(2), settings.derived_sensors(names, 2), L"Derived sensor removed", LINE_INFO());
+            Assert::AreEqual(L"twice", names[0], L"Order retained #0", LINE_INFO());
+            Assert::AreEqual(L"ratio", names[1], L"Order retained #1", LINE_INFO());
+            Assert::AreEqual(std::size_t(3), copy.derived_sensors(nullptr, 0), L"Copy retains derived sensors", LINE_INFO());
+            Assert::AreEqual(L"[a] + [b]", copy.derived_sensor(L"total"), L"Copy expression", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([&settings](void) {
+                settings.derived_sensor(nullptr, L"[a]");
+            }, L"Null sensor name", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&settings](void) {
+                settings.derived_sensor(L"invalid", L"[a] *");
+            }, L"Invalid expression", LINE_INFO());
+        }
+
+        TEST_METHOD(test_write_wake_up) {
+            collector_settings settings;
+            Assert::AreEqual(collector_settings::default_write_latency, settings.write_latency(), L"Default for write_latency", LINE_INFO());
+            Assert::AreEqual(collector_settings::default_write_threshold, settings.write_threshold(), L"Default for write_threshold", LINE_INFO());
+
+            settings.write_latency(250).write_threshold(0.25f);
+            Assert::AreEqual(collector_settings::sampling_interval_type(250), settings.write_latency(), L"Set write_latency", LINE_INFO());
+            Assert::AreEqual(0.25f, settings.write_threshold(), L"Set write_threshold", LINE_INFO());
+
+            auto copy = settings;
+            Assert::AreEqual(settings.write_latency(), copy.write_latency(), L"Copy write_latency", LINE_INFO());
+            Assert::AreEqual(settings.write_threshold(), copy.write_threshold(), L"Copy write_threshold", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([&settings](void) { settings.write_latency(0); }, L"Zero write_latency", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&settings](void) { settings.write_threshold(0.0f); }, L"Zero write_threshold", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&settings](void) { settings.write_threshold(1.5f); }, L"Too large write_threshold", LINE_INFO());
+        }
+
+        TEST_METHOD(test_writer_threads) {
+            collector_settings settings;
+            Assert::AreEqual(std::size_t(1), settings.writer_threads(), L"Default for writer_threads", LINE_INFO());
+
+            settings.writer_threads(4);
+            Assert::AreEqual(std::size_t(4), settings.writer_threads(), L"Set writer_threads", LINE_INFO());
+
+            auto copy = settings;
+            Assert::AreEqual(settings.writer_threads(), copy.writer_threads(), L"Copy writer_threads", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([&settings](void) { settings.writer_threads(0); }, L"Zero writer_threads", LINE_INFO());
+        }
+
+        TEST_METHOD(test_discover_async) {
+            std::atomic<int> calls(0);
+            auto filter = sensor_filter().type(L"no_such_sensor", true);
+            auto discovery = collector::discover_async(collector_settings().output_path(L"test.csv"), filter, [](collector_discovery& d, void *context) {
+                // Only count invocations after the result has been published.
+                if (d.ready()) {
+                    ++*static_cast<std::atomic<int> *>(context);
+                }
+            }, &calls);
+            Assert::IsTrue(bool(discovery), L"Handle is valid", LINE_INFO());
+
+            Assert::IsTrue(discovery.wait(10000), L"Discovery completed", LINE_INFO());
+            Assert::IsFalse(discovery.cancel(), L"Completed discovery cannot be cancelled", LINE_INFO());
+            Assert::IsFalse(discovery.cancelled(), L"Not cancelled", LINE_INFO());
+
+            auto copy = discovery;
+            auto collector = copy.get();
+            Assert::IsTrue(bool(collector), L"Collector is valid", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), collector.size(), L"All types filtered", LINE_INFO());
+            Assert::ExpectException<std::logic_error>([&discovery](void) { discovery.get(); }, L"Retrieved only once", LINE_INFO());
+
+            for (int i = 0; (i < 100) && (calls.load() == 0); ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            Assert::AreEqual(1, calls.load(), L"Callback invoked once", LINE_INFO());
+
+            collector_discovery invalid;
+            Assert::IsFalse(bool(invalid), L"Default handle is invalid", LINE_INFO());
+            Assert::IsFalse(invalid.wait(0), L"Nothing to wait for", LINE_INFO());
+            Assert::ExpectException<std::runtime_error>([&invalid](void) { invalid.get(); }, L"Nothing to retrieve", LINE_INFO());
         }
 
         TEST_METHOD(test_for_all) {
@@ -36,11 +414,361 @@ namespace test {
             Assert::IsTrue(bool(collector), L"New collector is valid.", LINE_INFO());
         }
 
+        TEST_METHOD(test_register_marker) {
+            auto collector = collector::for_all(L"test.csv");
+            const auto phase1 = collector.register_marker(L"phase 1");
+            const auto phase2 = collector.register_marker(L"phase 2");
+            Assert::AreNotEqual(std::uint32_t(0), phase1, L"ID zero is reserved", LINE_INFO());
+            Assert::AreNotEqual(phase1, phase2, L"Different markers have different IDs", LINE_INFO());
+            Assert::AreEqual(phase1, collector.register_marker(L"phase 1"), L"Same marker has same ID", LINE_INFO());
+
+            collector.marker(phase1);
+            collector.marker(L"phase 2");
+            collector.marker(nullptr);
+            Assert::ExpectException<std::out_of_range>([&collector, phase2](void) {
+                collector.marker(phase2 + 1);
+            }, L"Unregistered marker", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&collector](void) {
+                collector.register_marker(nullptr);
+            }, L"Null marker", LINE_INFO());
+        }
+
+        TEST_METHOD(test_attach) {
+            {
+                auto collector = collector::from_sensors(collector_settings().output_path(L"collector_attach.csv").sampling_interval(1000).sensor_interval(L"sensor2", 500), constant_sensor(L"sensor1"));
+                Assert::AreEqual(std::size_t(1), collector.size(), L"Initial sensor", LINE_INFO());
+
+                collector.start();
+                collector.attach(constant_sensor(L"sensor2"));
+                Assert::AreEqual(std::size_t(2), collector.size(), L"Sensor attached", LINE_INFO());
+                Assert::ExpectException<std::invalid_argument>([&collector](void) {
+                    collector.attach(constant_sensor(nullptr));
+                }, L"Disposed sensor", LINE_INFO());
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                Assert::IsTrue(collector.sampling_interval(L"sensor2", 2000), L"Interval changed", LINE_INFO());
+                Assert::IsFalse(collector.sampling_interval(L"sensor3", 2000), L"Unknown sensor", LINE_INFO());
+                Assert::ExpectException<std::invalid_argument>([&collector](void) {
+                    collector.sampling_interval(L"sensor2", 0);
+                }, L"Zero interval", LINE_INFO());
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                Assert::IsTrue(collector.detach(L"sensor1"), L"Sensor detached", LINE_INFO());
+                Assert::IsFalse(collector.detach(L"sensor1"), L"Sensor already detached", LINE_INFO());
+                Assert::AreEqual(std::size_t(1), collector.size(), L"Sensor removed", LINE_INFO());
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                collector.stop();
+            }
+
+            std::wifstream csv("collector_attach.csv");
+            std::vector<std::wstring> changes;
+            auto have_sensor2 = false;
+            for (std::wstring line; std::getline(csv, line);) {
+                if (line.find(L"# schema change") == 0) {
+                    changes.push_back(line);
+                } else if (line.find(L"sensor2") != std::wstring::npos) {
+                    have_sensor2 = true;
+                }
+            }
+
+            Assert::AreEqual(std::size_t(3), changes.size(), L"Three changes recorded", LINE_INFO());
+            Assert::IsTrue(changes[0].find(L"added") != std::wstring::npos, L"Addition recorded", LINE_INFO());
+            Assert::IsTrue(changes[0].rfind(L"\t500") != std::wstring::npos, L"Configured interval of added sensor", LINE_INFO());
+            Assert::IsTrue(changes[1].find(L"interval") != std::wstring::npos, L"Interval recorded", LINE_INFO());
+            Assert::IsTrue(changes[2].find(L"removed") != std::wstring::npos, L"Removal recorded", LINE_INFO());
+            Assert::IsTrue(have_sensor2, L"Attached sensor sampled", LINE_INFO());
+        }
+
+        TEST_METHOD(test_rotate) {
+            {
+                // A single byte makes every pass of the I/O thread start a new
+                // segment.
+                auto settings = collector_settings().output_path(L"collector_rotate.bin").output_format(output_format::binary).sampling_interval(1000).rotate_size(1);
+                auto collector = collector::from_sensors(settings, constant_sensor(L"sensor1"));
+                collector.start();
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                collector.stop();
+            }
+
+            std::size_t segments = 0;
+            std::size_t samples = 0;
+            for (std::size_t i = 0; ; ++i) {
+                const auto path = detail::output_rotator::segment_path(L"collector_rotate.bin", i);
+                if (!std::ifstream(power_overwhelming::convert_string<char>(path)).good()) {
+                    break;
+                }
+
+                binary_output_reader reader(path.c_str());
+                Assert::IsTrue(reader.indexed(), L"Segment finalised", LINE_INFO());
+                Assert::AreEqual(std::wstring(L"sensor1"), std::wstring(reader.sensor(0)), L"Header repeated", LINE_INFO());
+                samples += reader.read(nullptr, 0, (std::numeric_limits<measurement_data::timestamp_type>::max)(), [](const wchar_t *, const measurement_data *, const std::size_t, void *) { }, nullptr);
+                ++segments;
+            }
+
+            Assert::IsTrue(segments > 1, L"Output rotated", LINE_INFO());
+            Assert::IsTrue(samples > 0, L"Samples in segments", LINE_INFO());
+        }
+
+        TEST_METHOD(test_statistics) {
+            collector_statistics empty;
+            Assert::AreEqual(std::uint64_t(0), empty.samples(), L"No samples", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), empty.sensors(), L"No sensors", LINE_INFO());
+            Assert::AreEqual(0.0, empty.sample_rate(), L"No rate", LINE_INFO());
+
+            auto settings = collector_settings().output_path(L"collector_statistics.csv").sampling_interval(1000);
+            auto collector = collector::from_sensors(settings, constant_sensor(L"sensor1"));
+            collector.start();
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            collector.marker(L"marker");
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            collector.stop();
+
+            auto statistics = collector.statistics();
+            Assert::IsTrue(bool(statistics), L"Statistics valid", LINE_INFO());
+            Assert::IsTrue(statistics.samples() > 0, L"Samples counted", LINE_INFO());
+            Assert::IsTrue(statistics.bytes_written() > 0, L"Bytes counted", LINE_INFO());
+            Assert::IsTrue(statistics.elapsed() > 0, L"Elapsed time", LINE_INFO());
+            Assert::IsTrue(statistics.flush_duration().count() > 0, L"Flushes timed", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(1), statistics.marker_events(), L"Marker counted", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(0), statistics.dropped(), L"Nothing dropped", LINE_INFO());
+            Assert::AreEqual(std::size_t(1), statistics.sensors(), L"One sensor", LINE_INFO());
+            Assert::AreEqual(L"sensor1", statistics.sensor(0), L"Sensor name", LINE_INFO());
+            Assert::AreEqual(statistics.samples(), statistics.sensor_samples(0), L"Per-sensor samples", LINE_INFO());
+            Assert::IsTrue(statistics.sensor_rate(0) > 0.0, L"Per-sensor rate", LINE_INFO());
+
+            auto moved = std::move(statistics);
+            Assert::IsFalse(bool(statistics), L"Moved statistics invalid", LINE_INFO());
+            Assert::ExpectException<std::runtime_error>([&statistics](void) { statistics.samples(); }, L"Moved statistics throw", LINE_INFO());
+        }
+
+        TEST_METHOD(test_subscribe) {
+            collector_settings settings;
+            Assert::AreEqual(collector_settings::default_subscriber_capacity, settings.subscriber_capacity(), L"Default for subscriber_capacity", LINE_INFO());
+            settings.output_path(L"collector_subscribe.csv").sampling_interval(1000).subscriber_capacity(64);
+            Assert::AreEqual(std::size_t(64), settings.subscriber_capacity(), L"Set subscriber_capacity", LINE_INFO());
+            Assert::AreEqual(std::size_t(64), collector_settings(settings).subscriber_capacity(), L"Copy subscriber_capacity", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&settings](void) { settings.subscriber_capacity(0); }, L"Zero subscriber_capacity", LINE_INFO());
+
+            collector_subscriber invalid;
+            Assert::IsFalse(bool(invalid), L"Default subscriber is invalid", LINE_INFO());
+            Assert::IsFalse(invalid.wait(0), L"Nothing to wait for", LINE_INFO());
+
+            auto collector = collector::from_sensors(settings, constant_sensor(L"sensor1"));
+            auto overlay = collector.subscribe(subscriber_overflow::skip_to_latest);
+            auto scheduler = collector.subscribe();
+            Assert::IsTrue(bool(overlay), L"Subscriber is valid", LINE_INFO());
+            Assert::IsTrue(subscriber_overflow::skip_to_latest == overlay.overflow(), L"Overflow policy", LINE_INFO());
+            Assert::IsTrue(subscriber_overflow::drop_oldest == scheduler.overflow(), L"Default overflow policy", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(0), scheduler.available(), L"Nothing published yet", LINE_INFO());
+
+            collector.start();
+            Assert::IsTrue(scheduler.wait(10000), L"Samples published", LINE_INFO());
+
+            std::vector<measurement_data> samples(16, measurement_data(0, 0.0f));
+            std::vector<const wchar_t *> sensors(samples.size());
+            const auto cnt = scheduler.read(samples.data(), sensors.data(), samples.size());
+            Assert::IsTrue(cnt > 0, L"Samples read", LINE_INFO());
+            Assert::AreEqual(L"sensor1", sensors[0], L"Name of sensor", LINE_INFO());
+            Assert::AreEqual(42.0f, samples[0].power(), L"Value of sample", LINE_INFO());
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            collector.stop();
+
+            // The overlay has not read anything, so it has fallen behind by
+            // more than the capacity of the ring.
+            std::size_t batches = 0;
+            const auto overlay_cnt = overlay.read([](const wchar_t *sensor, const measurement_data *samples, const std::size_t cnt, void *context) {
+                Assert::AreEqual(L"sensor1", sensor, L"Name of sensor in batch", LINE_INFO());
+                ++*static_cast<std::size_t *>(context);
+            }, &batches);
+            Assert::AreEqual(std::size_t(0), overlay_cnt, L"Backlog skipped", LINE_INFO());
+            Assert::IsTrue(overlay.lost() > 0, L"Backlog lost", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), batches, L"No batch", LINE_INFO());
+
+            const auto rest = scheduler.read([](const wchar_t *, const measurement_data *, const std::size_t, void *context) {
+                ++*static_cast<std::size_t *>(context);
+            }, &batches);
+            Assert::AreEqual(std::size_t(64), rest, L"Oldest samples dropped", LINE_INFO());
+            Assert::AreEqual(std::size_t(1), batches, L"Consecutive samples of one sensor in one batch", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(0), scheduler.available(), L"All read", LINE_INFO());
+        }
+
+        TEST_METHOD(test_marker_channel) {
+            static const wchar_t *const path = L"collector_marker_channel.csv";
+            collector_settings settings;
+            Assert::IsNull(settings.marker_channel(), L"Default for marker_channel", LINE_INFO());
+            settings.output_path(path).sampling_interval(1000).require_marker(true).marker_channel(L"PwrOwgCollectorMarkerTest");
+            Assert::AreEqual(L"PwrOwgCollectorMarkerTest", settings.marker_channel(), L"Set marker_channel", LINE_INFO());
+            Assert::AreEqual(L"PwrOwgCollectorMarkerTest", collector_settings(settings).marker_channel(), L"Copy marker_channel", LINE_INFO());
+
+            auto collector = collector::from_sensors(settings, constant_sensor(L"sensor1"));
+            Assert::ExpectException<std::system_error>([](void) {
+                marker_channel c("PwrOwgCollectorMarkerTest");
+            }, L"Channel only exists while running", LINE_INFO());
+
+            collector.start();
+            {
+                marker_channel channel("PwrOwgCollectorMarkerTest");
+                Assert::IsTrue(channel.active(), L"Collector listening", LINE_INFO());
+                Assert::IsTrue(channel.marker("external"), L"Set marker", LINE_INFO());
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                Assert::IsTrue(channel.marker(nullptr), L"Clear marker", LINE_INFO());
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                collector.stop();
+                Assert::IsFalse(channel.active(), L"Collector stopped listening", LINE_INFO());
+            }
+
+            std::ifstream file(power_overwhelming::convert_string<char>(path));
+            const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            Assert::IsTrue(content.find("external") != std::string::npos, L"Samples tagged with external marker", LINE_INFO());
+
+            settings.marker_channel(L"");
+            Assert::IsNull(settings.marker_channel(), L"Empty marker_channel", LINE_INFO());
+        }
+
+        TEST_METHOD(test_output_path) {
+            collector_settings settings;
+            settings.output_path(L"collector_output_path1.csv").sampling_interval(1000);
+
+            auto collector = collector::from_sensors(settings, constant_sensor(L"sensor1"));
+            Assert::AreEqual(L"collector_output_path1.csv", collector.output_path(), L"Configured output_path", LINE_INFO());
+            Assert::IsNull(collector.marker_channel(), L"No marker_channel", LINE_INFO());
+            Assert::IsNull(collector.shared_memory(), L"No shared_memory", LINE_INFO());
+
+            collector.start();
+            Assert::ExpectException<std::logic_error>([&collector](void) { collector.output_path(L"collector_output_path2.csv"); }, L"Redirect while running", LINE_INFO());
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            collector.stop();
+
+            collector.output_path(L"collector_output_path2.csv");
+            Assert::AreEqual(L"collector_output_path2.csv", collector.output_path(), L"Redirected output_path", LINE_INFO());
+            collector.start();
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            collector.stop();
+
+            for (auto path : { "collector_output_path1.csv", "collector_output_path2.csv" }) {
+                std::ifstream file(path);
+                const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+                Assert::IsTrue(content.find("sensor1") != std::string::npos, L"Samples in both outputs", LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(test_energy) {
+            collector_settings settings;
+            settings.output_path(L"collector_energy.csv").sampling_interval(1000).integrate_energy(true);
+
+            auto collector = collector::from_sensors(settings, constant_sensor(L"sensor1"));
+            const auto marker = collector.register_marker(L"energy");
+            Assert::AreEqual(0.0, collector.energy(marker), L"Nothing integrated yet", LINE_INFO());
+
+            collector.start();
+            collector.marker(marker);
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            collector.marker(nullptr);
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            collector.stop();
+
+            // The constant sensor draws 42 W, so the phase must have taken
+            // about 42 W * 0.2 s.
+            Assert::IsTrue(collector.energy(marker) > 6.0, L"Energy of marker", LINE_INFO());
+            Assert::AreEqual(0.0, collector.energy(42), L"Unknown marker", LINE_INFO());
+        }
+
+        TEST_METHOD(test_quantiles) {
+            collector_settings settings;
+            settings.output_path(L"collector_quantiles.csv").sampling_interval(1000).track_quantiles(true);
+
+            auto collector = collector::from_sensors(settings, constant_sensor(L"sensor1"));
+            collector.start();
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            collector.marker(L"marker");
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            // The quantiles are published while running.
+            Assert::IsTrue(collector.statistics().quantiles() > 0, L"Quantiles published live", LINE_INFO());
+            collector.stop();
+
+            auto statistics = collector.statistics();
+            Assert::AreEqual(std::size_t(2), statistics.quantiles(), L"Before and after marker", LINE_INFO());
+            Assert::AreEqual(L"sensor1", statistics.quantile_sensor(0), L"Sensor of quantiles", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(0), statistics.quantile_marker(0), L"No marker", LINE_INFO());
+            Assert::AreNotEqual(std::uint32_t(0), statistics.quantile_marker(1), L"Marker", LINE_INFO());
+            Assert::IsTrue(statistics.quantile_samples(1) > 0, L"Samples of marker", LINE_INFO());
+            Assert::AreEqual(42.0f, statistics.quantile(1, 0.5), L"Median of constant", LINE_INFO());
+            Assert::AreEqual(42.0f, statistics.quantile(1, 0.99), L"99th percentile of constant", LINE_INFO());
+            Assert::ExpectException<std::out_of_range>([&statistics](void) { statistics.quantile(2, 0.5); }, L"Invalid summary", LINE_INFO());
+        }
+
+        TEST_METHOD(test_track_frames) {
+            static const wchar_t *const path = L"collector_track_frames.csv";
+            collector_settings settings;
+            settings.output_path(path).sampling_interval(1000);
+
+            frame_marker invalid;
+            Assert::IsFalse(bool(invalid), L"Default frame marker is invalid", LINE_INFO());
+            invalid.present();
+            Assert::AreEqual(std::uint64_t(0), invalid.dropped(), L"Nothing dropped", LINE_INFO());
+
+            auto collector = collector::from_sensors(settings, constant_sensor(L"sensor1"));
+            auto frames = collector.track_frames(L"render");
+            Assert::IsTrue(bool(frames), L"Frame marker is valid", LINE_INFO());
+            Assert::ExpectException<std::logic_error>([&collector](void) { collector.track_frames(); }, L"Only one frame marker", LINE_INFO());
+
+            // Frames before the start are discarded.
+            frames.present();
+
+            collector.start();
+            for (int i = 0; i < 5; ++i) {
+                frames.begin();
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                frames.end();
+            }
+            frames.present();
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            collector.stop();
+
+            Assert::AreEqual(std::uint64_t(11), collector.statistics().marker_events(), L"All frame boundaries recorded", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(0), frames.dropped(), L"No frame dropped", LINE_INFO());
+
+            std::ifstream file(power_overwhelming::convert_string<char>(path));
+            const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            Assert::IsTrue(content.find("render") != std::string::npos, L"Samples tagged with frame marker", LINE_INFO());
+
+            frames = frame_marker();
+            Assert::IsTrue(bool(collector.track_frames()), L"Frame marker can be replaced", LINE_INFO());
+        }
+
         TEST_METHOD(test_from_defaults) {
             auto collector = collector::from_defaults();
             Assert::IsTrue(bool(collector), L"New collector is valid.", LINE_INFO());
         }
 
+        TEST_METHOD(test_from_json_deferred) {
+            {
+                std::ofstream config("collector_deferred.json");
+                config << R"({ "outputPath": "collector_deferred.csv", "samplingInterval": 1000, "sensors": [ { "type": "tinkerforge_sensor", "name": "deferred1", "host": "invalid.host", "port": 4223, "uid": "none" } ] })";
+            }
+
+            // The host does not exist, which must not matter before start.
+            auto collector = collector::from_json(L"collector_deferred.json", true);
+            Assert::IsTrue(bool(collector), L"New collector is valid.", LINE_INFO());
+            Assert::AreEqual(std::size_t(1), collector.size(), L"Deferred sensor counted", LINE_INFO());
+            Assert::IsTrue(collector.sampling_interval(L"deferred1", 2000), L"Interval of deferred sensor changed", LINE_INFO());
+            Assert::IsFalse(collector.sampling_interval(L"deferred2", 2000), L"Unknown sensor", LINE_INFO());
+            Assert::IsTrue(collector.detach(L"deferred1"), L"Deferred sensor detached", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), collector.size(), L"Deferred sensor removed", LINE_INFO());
+
+            {
+                std::ofstream config("collector_deferred.json");
+                config << R"({ "outputPath": "collector_deferred.csv", "samplingInterval": 1000, "sensors": [ { "type": "no_sensor", "name": "deferred1" } ] })";
+            }
+
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                collector::from_json(L"collector_deferred.json", true);
+            }, L"Unknown type of sensor", LINE_INFO());
+        }
+
         TEST_METHOD(test_from_sensor_lists) {
             std::vector<adl_sensor> adl_sensors(adl_sensor::for_all(nullptr, 0));
             adl_sensor::for_all(adl_sensors.data(), adl_sensors.size());
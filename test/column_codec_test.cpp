@@ -0,0 +1,80 @@
+﻿// <copyright file="column_codec_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(column_codec_test) {
+
+    public:
+
+        TEST_METHOD(test_timestamps) {
+            const std::vector<std::int64_t> expected { 1000, 1010, 1020, 1030,
+                1031, 1300, 70000, 69000, (std::numeric_limits<std::int64_t>::min)(),
+                (std::numeric_limits<std::int64_t>::max)(), 0 };
+
+            std::vector<std::uint8_t> encoded;
+            detail::encode_timestamps(encoded, expected.data(), expected.size());
+
+            std::vector<std::int64_t> actual(expected.size());
+            detail::decode_timestamps(actual.data(), actual.size(), encoded.data(), encoded.size());
+            Assert::IsTrue(expected == actual, L"Round trip of timestamps", LINE_INFO());
+
+            Assert::ExpectException<std::runtime_error>([&encoded](void) {
+                std::vector<std::int64_t> actual(20);
+                detail::decode_timestamps(actual.data(), actual.size(), encoded.data(), 4);
+            }, L"Truncated input", LINE_INFO());
+        }
+
+        TEST_METHOD(test_regular_timestamps) {
+            std::vector<std::int64_t> expected(1000);
+            for (std::size_t i = 0; i < expected.size(); ++i) {
+                expected[i] = 5000 + 10 * i;
+            }
+
+            std::vector<std::uint8_t> encoded;
+            detail::encode_timestamps(encoded, expected.data(), expected.size());
+            Assert::IsTrue(encoded.size() < 8 + 2 + 2 + expected.size() / 8 + 1, L"One bit per regular timestamp", LINE_INFO());
+
+            std::vector<std::int64_t> actual(expected.size());
+            detail::decode_timestamps(actual.data(), actual.size(), encoded.data(), encoded.size());
+            Assert::IsTrue(expected == actual, L"Round trip of regular timestamps", LINE_INFO());
+        }
+
+        TEST_METHOD(test_xor) {
+            const std::vector<float> expected { 0.0f, 0.0f, 1.0f, 1.001f, 1.002f,
+                1.002f, -230.5f, std::numeric_limits<float>::quiet_NaN(), 0.5f };
+
+            std::vector<std::uint8_t> encoded;
+            detail::encode_xor(encoded, expected.data(), expected.size());
+
+            std::vector<float> actual(expected.size());
+            detail::decode_xor(actual.data(), actual.size(), encoded.data(), encoded.size());
+            Assert::AreEqual(0, ::memcmp(expected.data(), actual.data(), expected.size() * sizeof(float)), L"Bitwise round trip of floats", LINE_INFO());
+        }
+
+        TEST_METHOD(test_constant_words) {
+            const std::vector<std::uint32_t> expected(800, 42);
+
+            std::vector<std::uint8_t> encoded;
+            detail::encode_xor(encoded, expected.data(), expected.size());
+            Assert::IsTrue(encoded.size() <= 2 + expected.size() / 8 + 1, L"One bit per unchanged word", LINE_INFO());
+
+            std::vector<std::uint32_t> actual(expected.size());
+            detail::decode_xor(actual.data(), actual.size(), encoded.data(), encoded.size());
+            Assert::IsTrue(expected == actual, L"Round trip of words", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
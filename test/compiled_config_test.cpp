@@ -0,0 +1,92 @@
+﻿// <copyright file="compiled_config_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(compiled_config_test) {
+
+    public:
+
+        TEST_METHOD(test_hash) {
+            typedef detail::compiled_config::hash_type hash_type;
+            Assert::AreEqual(hash_type(0xcbf29ce484222325ull), detail::compiled_config::hash(""), L"Offset basis for empty source", LINE_INFO());
+            Assert::AreEqual(detail::compiled_config::hash("{}"), detail::compiled_config::hash("{}"), L"Hash is deterministic", LINE_INFO());
+            Assert::AreNotEqual(detail::compiled_config::hash("{ }"), detail::compiled_config::hash("{}"), L"Hash depends on source", LINE_INFO());
+        }
+
+        TEST_METHOD(test_load) {
+            const auto path = L"compiled_config_test.json";
+            const auto cache = "compiled_config_test.json.cache";
+            Assert::AreEqual(L".cache", detail::compiled_config::extension, L"Path of cache", LINE_INFO());
+
+            {
+                std::ofstream file("compiled_config_test.json", std::ios::trunc);
+                file << "{ \"bufferSize\": 42, \"sensors\": [ ] }";
+            }
+            std::remove(cache);
+
+            {
+                nlohmann::json config;
+                auto sensors = detail::compiled_config::load(config, path, "sensors");
+                Assert::IsTrue(sensors.empty(), L"No sensors from source", LINE_INFO());
+                Assert::AreEqual(42, config["bufferSize"].get<int>(), L"Settings from source", LINE_INFO());
+                Assert::IsFalse(config.contains("sensors"), L"Sensors removed from settings", LINE_INFO());
+                Assert::IsTrue(std::ifstream(cache).good(), L"Cache written", LINE_INFO());
+            }
+
+            {
+                nlohmann::json config;
+                auto sensors = detail::compiled_config::load(config, path, "sensors");
+                Assert::IsTrue(sensors.empty(), L"No sensors from cache", LINE_INFO());
+                Assert::AreEqual(42, config["bufferSize"].get<int>(), L"Settings from cache", LINE_INFO());
+            }
+
+            {
+                std::ofstream file("compiled_config_test.json", std::ios::trunc);
+                file << "{ \"bufferSize\": 7 }";
+            }
+
+            {
+                nlohmann::json config;
+                detail::compiled_config::load(config, path, "sensors");
+                Assert::AreEqual(7, config["bufferSize"].get<int>(), L"Changed source invalidates cache", LINE_INFO());
+            }
+
+            {
+                std::ofstream file(cache, std::ios::trunc);
+                file << "This is not a compiled configuration.";
+            }
+
+            {
+                nlohmann::json config;
+                detail::compiled_config::load(config, path, "sensors");
+                Assert::AreEqual(7, config["bufferSize"].get<int>(), L"Invalid cache is ignored", LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(test_unknown_sensor) {
+            {
+                std::ofstream file("compiled_config_test.json", std::ios::trunc);
+                file << "{ \"sensors\": [ { \"type\": \"no_such_sensor\" } ] }";
+            }
+
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                nlohmann::json config;
+                detail::compiled_config::load(config, L"compiled_config_test.json", "sensors");
+            }, L"Unknown sensor type", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
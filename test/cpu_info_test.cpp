@@ -21,6 +21,42 @@ namespace test {
             thread_affinity_scope scope(0);
         }
 
+        TEST_METHOD(test_cpu_affinity_set) {
+            thread_affinity_scope scope(0);
+            const std::uint32_t cpus[] = { 0 };
+            set_thread_affinity(cpus, 1);
+
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                set_thread_affinity(nullptr, 1);
+            }, L"Null CPU set", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&cpus](void) {
+                set_thread_affinity(cpus, 0);
+            }, L"Empty CPU set", LINE_INFO());
+        }
+
+        TEST_METHOD(test_library_threads) {
+            const std::uint32_t cpus[] = { 0 };
+            set_library_thread_affinity(cpus, 1);
+            set_library_thread_priority(thread_priority::high);
+
+            // Library threads must start even if the settings cannot be applied.
+            std::thread thread([](void) {
+                detail::enter_library_thread("PwrOwg Test Thread");
+            });
+            thread.join();
+
+            set_library_thread_affinity(nullptr, 0);
+            set_library_thread_priority(thread_priority::normal);
+
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                set_library_thread_affinity(nullptr, 1);
+            }, L"Null CPU set", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                const std::uint32_t invalid[] = { (std::numeric_limits<std::uint32_t>::max)() };
+                set_library_thread_affinity(invalid, 1);
+            }, L"Invalid logical CPU", LINE_INFO());
+        }
+
         TEST_METHOD(test_cpu_model) {
             cpu_info vendor_and_model[2];
             Assert::IsTrue(get_cpu_info(vendor_and_model, 2) >= 2, L"Vendor and model available", LINE_INFO());
@@ -28,6 +64,43 @@ namespace test {
             auto model = extract_cpu_model(vendor_and_model);
         }
 
+        TEST_METHOD(test_get_cpu_topology) {
+            const auto first = get_cpu_topology(0);
+            const auto second = get_cpu_topology(0);
+            Assert::AreEqual(first.package, second.package, L"Package is stable", LINE_INFO());
+            Assert::AreEqual(first.die, second.die, L"Die is stable", LINE_INFO());
+            Assert::AreEqual(first.core, second.core, L"Core is stable", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                get_cpu_topology((std::numeric_limits<std::uint32_t>::max)());
+            }, L"Invalid logical CPU", LINE_INFO());
+        }
+
+        TEST_METHOD(test_machine_topology) {
+            const auto& machine = detail::machine_topology::instance();
+            Assert::IsTrue(&machine == &detail::machine_topology::instance(), L"Singleton", LINE_INFO());
+            Assert::IsTrue(machine.cpus() > 0, L"Has logical CPUs", LINE_INFO());
+            Assert::IsTrue(machine.packages() > 0, L"Has packages", LINE_INFO());
+            Assert::IsTrue(machine.dies() >= machine.packages(), L"Every package has a die", LINE_INFO());
+            Assert::IsTrue(machine.cores() >= machine.dies(), L"Every die has a core", LINE_INFO());
+            Assert::IsTrue(machine.cores() <= machine.cpus(), L"Every core has a logical CPU", LINE_INFO());
+            Assert::AreEqual(int(get_cpu_vendor()), int(machine.vendor()), L"Vendor is cached", LINE_INFO());
+
+            const auto expected = get_cpu_topology(0);
+            const auto& actual = machine.topology(0);
+            Assert::AreEqual(expected.package, actual.package, L"Package is cached", LINE_INFO());
+            Assert::AreEqual(expected.die, actual.die, L"Die is cached", LINE_INFO());
+            Assert::AreEqual(expected.core, actual.core, L"Core is cached", LINE_INFO());
+            Assert::IsTrue(machine.siblings(0) >= 1, L"CPU is its own sibling", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([&machine](void) {
+                machine.topology(machine.cpus());
+            }, L"Invalid logical CPU", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&machine](void) {
+                machine.siblings(machine.cpus());
+            }, L"Invalid logical CPU", LINE_INFO());
+        }
+
         TEST_METHOD(test_get_cpu_vendor) {
             const auto actual = get_cpu_vendor();
             Assert::AreNotEqual(int(cpu_vendor::unknown), int(actual), L"CPU vendor identified", LINE_INFO());
@@ -0,0 +1,113 @@
+﻿// <copyright file="csv_output_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(csv_output_test) {
+
+    public:
+
+        TEST_METHOD(test_aggregate) {
+            measurement sample(L"sensor1", 0, 1.0f);
+            detail::sample_aggregate aggregate;
+            aggregate.begin = 1000;
+            aggregate.count = 1000;
+            aggregate.end = 2000;
+            aggregate.energy = 12.3456789012;
+            aggregate.marker = 2;
+            aggregate.maximum = 14.0f;
+            aggregate.mean = 12.5f;
+            aggregate.minimum = 11.0f;
+            aggregate.sensor = sample.sensor();
+
+            {
+                detail::csv_output_writer writer;
+                writer.open(L"csv_output_test.csv");
+                writer.aggregate(aggregate);
+            }
+
+            std::ifstream csv("csv_output_test.csv", std::ios::binary);
+            std::string line;
+            std::getline(csv, line);
+            Assert::AreEqual(std::string("# aggregate\tsensor1\t1000\t2000\t1000\t11\t12.5\t14\t12.3456789012\t2"), line, L"Aggregate line", LINE_INFO());
+        }
+
+        TEST_METHOD(test_matches_stream) {
+            const measurement samples[] = {
+                measurement(L"sensor1", 123456789, 12.5f, 0.333333f, 4.16667f),
+                measurement(L"sensor2", -5, 1e-7f, 3e9f, 0.0f),
+                measurement(L"sensor1", 0, 42.0f)
+            };
+
+            std::wstringstream expected;
+            expected << csvheader << samples[0] << L'\t' << L"marker" << L'\n' << csvdata;
+            for (auto& s : samples) {
+                expected << s << L'\t' << 7 << L'\n';
+            }
+
+            {
+                detail::csv_output_writer writer;
+                writer.open(L"csv_output_test.csv");
+                writer.header();
+                for (auto& s : samples) {
+                    writer.push(s, 7);
+                }
+                Assert::IsTrue(writer.good(), L"Writing succeeded", LINE_INFO());
+            }
+
+            std::ifstream csv("csv_output_test.csv", std::ios::binary);
+            std::stringstream actual;
+            actual << csv.rdbuf();
+            Assert::AreEqual(convert_string<char>(expected.str()), actual.str(), L"Same output as stream", LINE_INFO());
+        }
+
+        TEST_METHOD(test_quote) {
+            {
+                detail::csv_output_writer writer;
+                writer.open(L"csv_output_test.csv");
+                writer.delimiter(',');
+                writer.quote('"');
+                writer.marker(1, L"phase 1");
+                writer.marker_event(42, 1);
+                writer.push(measurement(L"sensor1", 1, 2.0f), 1);
+            }
+
+            std::ifstream csv("csv_output_test.csv", std::ios::binary);
+            std::vector<std::string> lines;
+            for (std::string line; std::getline(csv, line);) {
+                lines.push_back(line);
+            }
+
+            Assert::AreEqual(std::size_t(3), lines.size(), L"One line per record", LINE_INFO());
+            Assert::AreEqual(std::string("# marker,1,\"phase 1\""), lines[0], L"Quoted marker", LINE_INFO());
+            Assert::AreEqual(std::string("# marker event,42,1"), lines[1], L"Unquoted numbers", LINE_INFO());
+            Assert::IsTrue(lines[2].find("\"sensor1\",1,1,") == 0, L"Quoted sensor", LINE_INFO());
+        }
+
+        TEST_METHOD(test_utf8) {
+            {
+                detail::csv_output_writer writer;
+                writer.open(L"csv_output_test.csv");
+                writer.marker(1, L"ü€");
+            }
+
+            std::ifstream csv("csv_output_test.csv", std::ios::binary);
+            std::string line;
+            std::getline(csv, line);
+            Assert::AreEqual(std::string("# marker\t1\t\xc3\xbc\xe2\x82\xac"), line, L"UTF-8 encoding", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
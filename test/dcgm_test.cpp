@@ -0,0 +1,59 @@
+﻿// <copyright file="dcgm_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(dcgm_test) {
+
+    public:
+
+        TEST_METHOD(test_for_all) {
+            std::vector<dcgm_sensor> sensors(dcgm_sensor::for_all(nullptr, 0));
+            dcgm_sensor::for_all(sensors.data(), sensors.size());
+
+            for (auto& s : sensors) {
+                Assert::IsTrue(bool(s), L"Enumerated sensor is valid", LINE_INFO());
+                Assert::IsNotNull(s.name(), L"Enumerated sensor has name", LINE_INFO());
+                Assert::AreEqual(std::size_t(5), s.channels(), L"Five channels", LINE_INFO());
+                Assert::IsTrue(measurement_quantity::power == s.channel(dcgm_sensor::channel_power).quantity(), L"Power channel", LINE_INFO());
+                Assert::AreEqual(L"J", s.channel(dcgm_sensor::channel_energy).unit(), L"Energy in Joules", LINE_INFO());
+                Assert::AreEqual(dcgm_sensor::default_update_interval, s.native_interval(), L"Default update interval", LINE_INFO());
+
+                std::vector<multi_channel_sensor::value_type> values(s.channels());
+                s.sample_channels(values.data(), values.size());
+            }
+        }
+
+        TEST_METHOD(test_disposed) {
+            dcgm_sensor sensor;
+            Assert::IsFalse(bool(sensor), L"Default sensor is invalid", LINE_INFO());
+            Assert::ExpectException<std::runtime_error>([&sensor](void) { sensor.gpu(); }, L"GPU of disposed sensor", LINE_INFO());
+            Assert::ExpectException<std::runtime_error>([&sensor](void) {
+                std::vector<multi_channel_sensor::value_type> values(sensor.channels());
+                sensor.sample_channels(values.data(), values.size());
+            }, L"Sample disposed sensor", LINE_INFO());
+
+            auto moved = std::move(sensor);
+            Assert::IsFalse(bool(moved), L"Moved invalid sensor is invalid", LINE_INFO());
+        }
+
+        TEST_METHOD(test_for_gpu) {
+            Assert::ExpectException<std::exception>([](void) {
+                dcgm_sensor::for_gpu(0, "127.0.0.1:0");
+            }, L"Non-existing host engine", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,99 @@
+﻿// <copyright file="delta_filter_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(delta_filter_test) {
+
+    public:
+
+        TEST_METHOD(test_disabled) {
+            detail::delta_filter filter;
+            std::vector<detail::delta_filter::sample_type> released;
+            Assert::IsFalse(filter.enabled(), L"Disabled by default", LINE_INFO());
+
+            filter.push(measurement(L"sensor", 0, 1.0f), 1, released);
+            filter.push(measurement(L"sensor", 1, 1.0f), 1, released);
+            Assert::AreEqual(std::size_t(2), released.size(), L"Passed through", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([&filter](void) { filter.configure(-1); }, L"Negative keep-alive", LINE_INFO());
+        }
+
+        TEST_METHOD(test_steps) {
+            const wchar_t *name = L"sensor";
+            detail::delta_filter filter;
+            std::vector<detail::delta_filter::sample_type> released;
+            filter.configure(0);
+            filter.threshold(name, 0.5f);
+            Assert::IsTrue(filter.enabled(), L"Enabled", LINE_INFO());
+
+            filter.push(measurement(name, 0, 10.0f), 0, released);
+            Assert::AreEqual(std::size_t(1), released.size(), L"First sample", LINE_INFO());
+
+            // Samples within the threshold are retained.
+            filter.push(measurement(name, 1, 10.2f), 0, released);
+            filter.push(measurement(name, 2, 10.4f), 0, released);
+            Assert::AreEqual(std::size_t(1), released.size(), L"Within threshold", LINE_INFO());
+
+            // The step releases the end of the plateau and the new value.
+            filter.push(measurement(name, 3, 20.0f), 0, released);
+            Assert::AreEqual(std::size_t(3), released.size(), L"Step", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(2), released[1].first.timestamp(), L"End of plateau", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(3), released[2].first.timestamp(), L"Begin of step", LINE_INFO());
+
+            // A change without retained samples only releases the new value.
+            filter.push(measurement(name, 4, 30.0f), 0, released);
+            Assert::AreEqual(std::size_t(4), released.size(), L"Immediate change", LINE_INFO());
+
+            // A new marker is a change, too.
+            filter.push(measurement(name, 5, 30.0f), 1, released);
+            Assert::AreEqual(std::size_t(5), released.size(), L"Marker change", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(1), released.back().second, L"Marker retained", LINE_INFO());
+
+            // The last retained sample is released on flush.
+            filter.push(measurement(name, 6, 30.0f), 1, released);
+            filter.flush(released);
+            Assert::AreEqual(std::size_t(6), released.size(), L"Flushed", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(6), released.back().first.timestamp(), L"Flushed sample", LINE_INFO());
+
+            // Other sensors are not filtered.
+            filter.push(measurement(L"other", 7, 30.0f), 1, released);
+            filter.push(measurement(L"other", 8, 30.0f), 1, released);
+            Assert::AreEqual(std::size_t(8), released.size(), L"Other sensor", LINE_INFO());
+        }
+
+        TEST_METHOD(test_keep_alive) {
+            const wchar_t *name = L"sensor";
+            detail::delta_filter filter;
+            std::vector<detail::delta_filter::sample_type> released;
+            filter.configure(10);
+            filter.threshold(name, 0.0f);
+
+            for (measurement::timestamp_type t = 0; t <= 25; ++t) {
+                filter.push(measurement(name, t, 1.0f), 0, released);
+            }
+
+            Assert::AreEqual(std::size_t(3), released.size(), L"First and keep-alive samples", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(10), released[1].first.timestamp(), L"First keep-alive", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(20), released[2].first.timestamp(), L"Second keep-alive", LINE_INFO());
+
+            // Removing the threshold releases all samples again.
+            filter.threshold(name, -1.0f);
+            filter.push(measurement(name, 26, 1.0f), 0, released);
+            Assert::AreEqual(std::size_t(4), released.size(), L"Threshold removed", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
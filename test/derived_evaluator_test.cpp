@@ -0,0 +1,105 @@
+﻿// <copyright file="derived_evaluator_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(derived_evaluator_test) {
+
+    public:
+
+        TEST_METHOD(test_disabled) {
+            detail::derived_evaluator evaluator;
+            std::vector<measurement> derived;
+            Assert::IsFalse(evaluator.enabled(), L"Disabled by default", LINE_INFO());
+
+            evaluator.add(L"total", L"[a] + [b]");
+            Assert::IsFalse(evaluator.enabled(), L"Disabled without grid", LINE_INFO());
+            Assert::AreEqual(std::size_t(1), evaluator.names().size(), L"Name retained", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([&evaluator](void) { evaluator.add(L"total", L"[a]"); }, L"Duplicate name", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&evaluator](void) { evaluator.add(L"constant", L"42"); }, L"No inputs", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&evaluator](void) { evaluator.add(nullptr, L"[a]"); }, L"Null name", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&evaluator](void) { evaluator.configure(-1); }, L"Negative step", LINE_INFO());
+
+            evaluator.clear();
+            Assert::IsTrue(evaluator.names().empty(), L"Cleared", LINE_INFO());
+        }
+
+        TEST_METHOD(test_sum) {
+            detail::derived_evaluator evaluator;
+            std::vector<measurement> derived;
+            evaluator.add(L"total", L"[a] + [b]");
+            evaluator.configure(10);
+            Assert::IsTrue(evaluator.enabled(), L"Enabled", LINE_INFO());
+
+            evaluator.push(measurement(L"a", 5, 1.0f));
+            evaluator.push(measurement(L"other", 5, 100.0f));
+            evaluator.evaluate(derived);
+            Assert::IsTrue(derived.empty(), L"Waiting for b", LINE_INFO());
+
+            // The grid points 10, 20 and 30 are covered by both sensors.
+            evaluator.push(measurement(L"a", 35, 4.0f));
+            evaluator.push(measurement(L"b", 8, 2.0f));
+            evaluator.push(measurement(L"b", 30, 2.0f));
+            evaluator.evaluate(derived);
+            Assert::AreEqual(std::size_t(3), derived.size(), L"Grid points", LINE_INFO());
+            Assert::AreEqual(L"total", derived[0].sensor(), L"Name", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(10), derived[0].timestamp(), L"Timestamp #0", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(30), derived[2].timestamp(), L"Timestamp #2", LINE_INFO());
+            Assert::AreEqual(3.5f, derived[0].power(), 0.0001f, L"Power #0", LINE_INFO());
+            Assert::AreEqual(4.5f, derived[1].power(), 0.0001f, L"Power #1", LINE_INFO());
+            Assert::AreEqual(5.5f, derived[2].power(), 0.0001f, L"Power #2", LINE_INFO());
+            derived.clear();
+
+            evaluator.evaluate(derived);
+            Assert::IsTrue(derived.empty(), L"Grid points are evaluated once", LINE_INFO());
+
+            evaluator.push(measurement(L"b", 20, 5.0f));
+            evaluator.push(measurement(L"b", 50, 4.0f));
+            evaluator.evaluate(derived);
+            Assert::IsTrue(derived.empty(), L"Old sample ignored, waiting for a", LINE_INFO());
+
+            evaluator.push(measurement(L"a", 45, 5.0f));
+            evaluator.evaluate(derived);
+            Assert::AreEqual(std::size_t(1), derived.size(), L"Next grid point", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(40), derived[0].timestamp(), L"Timestamp", LINE_INFO());
+            Assert::AreEqual(4.5f + 3.0f, derived[0].power(), 0.0001f, L"Power", LINE_INFO());
+        }
+
+        TEST_METHOD(test_quantities) {
+            detail::derived_evaluator evaluator;
+            std::vector<measurement> derived;
+            evaluator.add(L"ratio", L"[a].current / [a].voltage");
+            evaluator.add(L"missing", L"[b].voltage");
+            evaluator.add(L"scaled", L"2 * [ratio]");
+            evaluator.configure(10);
+
+            evaluator.push(measurement(L"a", 10, 10.0f, 2.0f));
+            evaluator.push(measurement(L"a", 20, 20.0f, 8.0f));
+            evaluator.push(measurement(L"b", 10, 1.0f));
+            evaluator.push(measurement(L"b", 20, 1.0f));
+            evaluator.evaluate(derived);
+
+            Assert::AreEqual(std::size_t(4), derived.size(), L"Samples of ratio and scaled", LINE_INFO());
+            Assert::AreEqual(L"ratio", derived[0].sensor(), L"Ratio first", LINE_INFO());
+            Assert::AreEqual(0.2f, derived[0].power(), 0.0001f, L"Ratio #0", LINE_INFO());
+            Assert::AreEqual(0.4f, derived[1].power(), 0.0001f, L"Ratio #1", LINE_INFO());
+            Assert::AreEqual(L"scaled", derived[2].sensor(), L"Chained sensor", LINE_INFO());
+            Assert::AreEqual(0.4f, derived[2].power(), 0.0001f, L"Scaled #0", LINE_INFO());
+            Assert::AreEqual(0.8f, derived[3].power(), 0.0001f, L"Scaled #1", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,81 @@
+﻿// <copyright file="derived_expression_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(derived_expression_test) {
+
+    public:
+
+        TEST_METHOD(test_constant_folding) {
+            detail::derived_expression expression(L"2 * (3 + 4) - -1 / 2");
+            Assert::IsTrue(expression.inputs().empty(), L"No inputs", LINE_INFO());
+            Assert::AreEqual(std::size_t(1), expression.size(), L"Folded into a constant", LINE_INFO());
+
+            float result[3];
+            expression.evaluate(result, nullptr, 3);
+            Assert::AreEqual(14.5f, result[0], 0.0001f, L"Result #0", LINE_INFO());
+            Assert::AreEqual(14.5f, result[2], 0.0001f, L"Result #2", LINE_INFO());
+
+            detail::derived_expression exponent(L"1.5e3 + .5");
+            exponent.evaluate(result, nullptr, 1);
+            Assert::AreEqual(1500.5f, result[0], 0.0001f, L"Exponent", LINE_INFO());
+        }
+
+        TEST_METHOD(test_inputs) {
+            detail::derived_expression expression(L"[nvml/0] + [nvml/1] * [nvml/0] / [tinker/12V].voltage");
+            auto& inputs = expression.inputs();
+            Assert::AreEqual(std::size_t(3), inputs.size(), L"Distinct inputs", LINE_INFO());
+            Assert::AreEqual(L"nvml/0", inputs[0].sensor.c_str(), L"Input #0", LINE_INFO());
+            Assert::IsTrue(inputs[0].quantity == detail::derived_expression::quantity_type::power, L"Power by default", LINE_INFO());
+            Assert::AreEqual(L"tinker/12V", inputs[2].sensor.c_str(), L"Input #2", LINE_INFO());
+            Assert::IsTrue(inputs[2].quantity == detail::derived_expression::quantity_type::voltage, L"Voltage selector", LINE_INFO());
+
+            detail::derived_expression current(L"[tinker/12V].current + [tinker/12V].power");
+            Assert::AreEqual(std::size_t(2), current.inputs().size(), L"Quantities are distinct", LINE_INFO());
+        }
+
+        TEST_METHOD(test_evaluate) {
+            // The batch spans multiple blocks to test the remainder.
+            const auto cnt = 2 * detail::derived_expression::block_size + 3;
+            std::vector<float> a(cnt), b(cnt), result(cnt);
+            for (std::size_t i = 0; i < cnt; ++i) {
+                a[i] = static_cast<float>(i);
+                b[i] = 2.0f;
+            }
+            const float *inputs[] = { a.data(), b.data() };
+
+            detail::derived_expression expression(L"-([a] + 1) * [b] - [a] / [b]");
+            expression.evaluate(result.data(), inputs, cnt);
+
+            for (std::size_t i = 0; i < cnt; ++i) {
+                const auto expected = -(a[i] + 1.0f) * 2.0f - a[i] / 2.0f;
+                Assert::AreEqual(expected, result[i], 0.0001f, L"Result", LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(test_invalid) {
+            Assert::ExpectException<std::invalid_argument>([](void) { detail::derived_expression e(nullptr); }, L"Null expression", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) { detail::derived_expression e(L""); }, L"Empty expression", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) { detail::derived_expression e(L"[a] +"); }, L"Missing operand", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) { detail::derived_expression e(L"([a] + 1"); }, L"Missing parenthesis", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) { detail::derived_expression e(L"[a"); }, L"Missing bracket", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) { detail::derived_expression e(L"[]"); }, L"Empty name", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) { detail::derived_expression e(L"[a].energy"); }, L"Unknown quantity", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) { detail::derived_expression e(L"[a] [b]"); }, L"Trailing input", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
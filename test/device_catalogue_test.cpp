@@ -0,0 +1,61 @@
+﻿// <copyright file="device_catalogue_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(device_catalogue_test) {
+
+    public:
+
+        TEST_METHOD(test_cached_discovery) {
+            detail::cached_discovery<int> cache;
+            std::size_t calls = 0;
+            auto enumerate = [&calls](void) {
+                ++calls;
+                return std::vector<int> { 1, 2, 3 };
+            };
+
+            auto values = cache.get(enumerate);
+            Assert::AreEqual(std::size_t(1), calls, L"First request enumerates", LINE_INFO());
+            Assert::AreEqual(std::size_t(3), values.size(), L"Enumerated values returned", LINE_INFO());
+
+            values = cache.get(enumerate);
+            Assert::AreEqual(std::size_t(1), calls, L"Second request is cached", LINE_INFO());
+            Assert::AreEqual(std::size_t(3), values.size(), L"Cached values returned", LINE_INFO());
+
+            cache.invalidate();
+            cache.get(enumerate);
+            Assert::AreEqual(std::size_t(2), calls, L"Local invalidation enumerates", LINE_INFO());
+
+            refresh_device_catalogue();
+            cache.get(enumerate);
+            Assert::AreEqual(std::size_t(3), calls, L"Refreshing catalogue enumerates", LINE_INFO());
+        }
+
+        TEST_METHOD(test_failed_discovery) {
+            detail::cached_discovery<int> cache;
+
+            Assert::ExpectException<std::runtime_error>([&cache](void) {
+                cache.get([](void) -> std::vector<int> {
+                    throw std::runtime_error("enumeration failed");
+                });
+            }, L"Exception propagated", LINE_INFO());
+
+            const auto values = cache.get([](void) { return std::vector<int> { 42 }; });
+            Assert::AreEqual(std::size_t(1), values.size(), L"Failure not cached", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,105 @@
+﻿// <copyright file="energy_meter_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(energy_meter_test) {
+
+    public:
+
+        TEST_METHOD(test_empty) {
+            energy_meter meter;
+            Assert::IsTrue(bool(meter), L"Meter valid", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), meter.size(), L"No sensors", LINE_INFO());
+            Assert::IsFalse(meter.running(), L"Not running", LINE_INFO());
+            Assert::AreEqual(0.0, meter.elapsed(), L"Not started", LINE_INFO());
+            Assert::IsNull(meter.name(0), L"No name", LINE_INFO());
+            Assert::ExpectException<std::out_of_range>([&meter](void) { meter.energy(0); }, L"No sensor", LINE_INFO());
+
+            meter.start();
+            Assert::IsTrue(meter.running(), L"Running", LINE_INFO());
+            meter.stop();
+            meter.stop();
+            Assert::IsFalse(meter.running(), L"Stopped", LINE_INFO());
+            Assert::IsTrue(meter.elapsed() >= 0.0, L"Elapsed", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                energy_meter m(nullptr, 1);
+            }, L"Null sensors", LINE_INFO());
+
+            auto moved = std::move(meter);
+            Assert::IsFalse(bool(meter), L"Moved meter invalid", LINE_INFO());
+            Assert::IsTrue(bool(moved), L"Target valid", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), meter.size(), L"Moved meter empty", LINE_INFO());
+            Assert::ExpectException<std::runtime_error>([&meter](void) { meter.start(); }, L"Start moved", LINE_INFO());
+        }
+
+#if !defined(_WIN32)
+        TEST_METHOD(test_sysfs) {
+            // The layout of the files mimics a powercap zone, which reports
+            // the range of its counter.
+            const std::string dir("/tmp/pwrowg_energy_meter_test/");
+            const auto power_path = dir + "power1_input";
+            const auto energy_path = dir + "energy_uj";
+            const auto range_path = dir + "max_energy_range_uj";
+            ::mkdir(dir.c_str(), 0755);
+            std::ofstream(power_path) << "1500000\n";
+            std::ofstream(energy_path) << "1000000\n";
+            std::ofstream(range_path) << "10000000\n";
+
+            {
+                auto power = sysfs_sensor::for_path(power_path.c_str(), sysfs_sensor_quantity::power);
+                auto energy = sysfs_sensor::for_path(energy_path.c_str(), sysfs_sensor_quantity::energy);
+                Assert::IsFalse(energy_meter::supports(power), L"Power not supported", LINE_INFO());
+                Assert::IsTrue(energy_meter::supports(energy), L"Energy supported", LINE_INFO());
+                Assert::IsFalse(energy_meter::supports(sysfs_sensor()), L"Disposed sensor not supported", LINE_INFO());
+
+                {
+                    energy_meter meter;
+                    Assert::ExpectException<std::invalid_argument>([&](void) { meter.add(power); }, L"Add power", LINE_INFO());
+                }
+
+                const sensor *sensors[] = { &energy };
+                energy_meter meter(sensors, 1);
+                Assert::IsTrue(meter.running(), L"Started by constructor", LINE_INFO());
+                Assert::AreEqual(std::size_t(1), meter.size(), L"One sensor", LINE_INFO());
+                Assert::AreEqual(energy.name(), meter.name(0), L"Name of sensor", LINE_INFO());
+                Assert::ExpectException<std::logic_error>([&](void) { meter.add(energy); }, L"Add while running", LINE_INFO());
+
+                std::ofstream(energy_path) << "4000000\n";
+                Assert::AreEqual(3.0, meter.energy(0), 0.0001, L"Energy so far", LINE_INFO());
+
+                std::ofstream(energy_path) << "6000000\n";
+                meter.stop();
+                std::ofstream(energy_path) << "9000000\n";
+                Assert::AreEqual(5.0, meter.energy(0), 0.0001, L"Energy until stop", LINE_INFO());
+
+                // The counter wraps at ten Joules.
+                meter.start();
+                std::ofstream(energy_path) << "2000000\n";
+                meter.stop();
+                Assert::AreEqual(3.0, meter.energy(0), 0.0001, L"Energy across wrap", LINE_INFO());
+            }
+
+            std::remove(power_path.c_str());
+            std::remove(energy_path.c_str());
+            std::remove(range_path.c_str());
+            ::rmdir(dir.c_str());
+        }
+#endif /* !defined(_WIN32) */
+
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,77 @@
+﻿// <copyright file="enumerate_sensors_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    /// <summary>
+    /// A fake sensor type that counts the calls to its <c>for_all</c>.
+    /// </summary>
+    struct counted_sensor {
+        static std::size_t available;
+        static std::size_t calls;
+
+        static std::size_t for_all(counted_sensor *dst, const std::size_t cnt) {
+            ++calls;
+            for (std::size_t i = 0; (i < cnt) && (i < available); ++i) {
+                dst[i].index = i;
+            }
+            return available;
+        }
+
+        std::size_t index = static_cast<std::size_t>(-1);
+    };
+
+    std::size_t counted_sensor::available = 0;
+    std::size_t counted_sensor::calls = 0;
+
+
+    TEST_CLASS(enumerate_sensors_test) {
+
+    public:
+
+        TEST_METHOD(test_single_pass) {
+            counted_sensor::available = 3;
+            counted_sensor::calls = 0;
+
+            auto sensors = enumerate_sensors<counted_sensor>();
+            Assert::AreEqual(std::size_t(1), counted_sensor::calls, L"Single pass", LINE_INFO());
+            Assert::AreEqual(std::size_t(3), sensors.size(), L"All sensors", LINE_INFO());
+            Assert::AreEqual(std::size_t(2), sensors.back().index, L"Last sensor filled", LINE_INFO());
+        }
+
+        TEST_METHOD(test_overflow) {
+            counted_sensor::available = default_sensor_capacity + 3;
+            counted_sensor::calls = 0;
+
+            auto sensors = enumerate_sensors<counted_sensor>();
+            Assert::AreEqual(std::size_t(2), counted_sensor::calls, L"Second pass", LINE_INFO());
+            Assert::AreEqual(counted_sensor::available, sensors.size(), L"All sensors", LINE_INFO());
+            Assert::AreEqual(counted_sensor::available - 1, sensors.back().index, L"Last sensor filled", LINE_INFO());
+        }
+
+        TEST_METHOD(test_none) {
+            counted_sensor::available = 0;
+            counted_sensor::calls = 0;
+
+            auto sensors = enumerate_sensors<counted_sensor>(0);
+            Assert::AreEqual(std::size_t(1), counted_sensor::calls, L"Single pass", LINE_INFO());
+            Assert::IsTrue(sensors.empty(), L"No sensors", LINE_INFO());
+
+            auto synthetic = enumerate_sensors<synthetic_sensor>();
+            Assert::IsTrue(synthetic.empty(), L"Synthetic sensors are not discovered", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -60,6 +60,80 @@ namespace test {
 
         }
 
+        TEST_METHOD(test_initially_signalled) {
+            auto event = create_event(false, true);
+            Assert::IsTrue(wait_event(event, 1), L"Event is signalled", LINE_INFO());
+            Assert::IsFalse(wait_event(event, 1), L"Auto reset after wait", LINE_INFO());
+
+            set_event(event);
+            set_event(event);
+            Assert::IsTrue(wait_event(event, 1), L"Multiple signals release one wait", LINE_INFO());
+            Assert::IsFalse(wait_event(event, 1), L"Multiple signals are consumed at once", LINE_INFO());
+
+            destroy_event(event);
+            Assert::IsNull(event, L"Destroyed event is null", LINE_INFO());
+        }
+
+        TEST_METHOD(test_wait_any) {
+            event_type events[] = { create_event(false, false), create_event(true, false) };
+            Assert::AreEqual(wait_events_timeout, wait_events(events, 2, false, 1), L"No event is signalled", LINE_INFO());
+
+            std::thread t([&events] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                set_event(events[1]);
+            });
+            t.detach();
+
+            Assert::AreEqual(std::size_t(1), wait_events(events, 2, false), L"Second event signalled", LINE_INFO());
+            Assert::IsTrue(wait_event(events[1], 1), L"Manual reset event stays signalled", LINE_INFO());
+
+            set_event(events[0]);
+            Assert::AreEqual(std::size_t(0), wait_events(events, 2, false, 1), L"Lowest index reported", LINE_INFO());
+            Assert::AreEqual(std::size_t(1), wait_events(events, 2, false, 1), L"Auto reset event consumed", LINE_INFO());
+
+            destroy_event(events[0]);
+            destroy_event(events[1]);
+        }
+
+        TEST_METHOD(test_wait_all) {
+            event_type events[] = { create_event(false, false), create_event(false, true) };
+            Assert::AreEqual(wait_events_timeout, wait_events(events, 2, true, 1), L"Not all events are signalled", LINE_INFO());
+
+            std::thread t([&events] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                set_event(events[0]);
+            });
+            t.detach();
+
+            Assert::AreEqual(std::size_t(0), wait_events(events, 2, true, 5000), L"All events signalled", LINE_INFO());
+            Assert::IsFalse(wait_event(events[0], 1), L"First event consumed", LINE_INFO());
+            Assert::IsFalse(wait_event(events[1], 1), L"Second event consumed", LINE_INFO());
+
+            destroy_event(events[0]);
+            destroy_event(events[1]);
+        }
+
+        TEST_METHOD(test_wait_all_timeout) {
+            event_type events[] = { create_event(false, false), create_event(false, false), create_event(true, false) };
+
+            set_event(events[0]);
+            set_event(events[2]);
+            Assert::AreEqual(wait_events_timeout, wait_events(events, 3, true, 10), L"Partially signalled", LINE_INFO());
+            Assert::IsTrue(wait_event(events[0], 0), L"Auto reset event retains signal after timeout", LINE_INFO());
+            Assert::IsTrue(wait_event(events[2], 0), L"Manual reset event retains signal after timeout", LINE_INFO());
+
+            set_event(events[0]);
+            set_event(events[1]);
+            Assert::AreEqual(std::size_t(0), wait_events(events, 3, true, 10), L"All signalled", LINE_INFO());
+            Assert::IsFalse(wait_event(events[0], 0), L"First event consumed", LINE_INFO());
+            Assert::IsFalse(wait_event(events[1], 0), L"Second event consumed", LINE_INFO());
+            Assert::IsTrue(wait_event(events[2], 0), L"Manual reset event still signalled", LINE_INFO());
+
+            for (auto& e : events) {
+                destroy_event(e);
+            }
+        }
+
     };
 } /* namespace test */
 } /* namespace power_overwhelming */
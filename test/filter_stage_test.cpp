@@ -0,0 +1,118 @@
+﻿// <copyright file="filter_stage_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(filter_stage_test) {
+
+    public:
+
+        TEST_METHOD(test_sample_filter) {
+            sample_filter none;
+            Assert::IsFalse(none, L"Default is none", LINE_INFO());
+            Assert::IsTrue(none.type() == sample_filter_type::none, L"Type none", LINE_INFO());
+            Assert::AreEqual(std::size_t(1), none.window(), L"Window of none", LINE_INFO());
+
+            const auto median = sample_filter::median(5);
+            Assert::IsTrue(median, L"Median is a filter", LINE_INFO());
+            Assert::AreEqual(std::size_t(5), median.window(), L"Median window", LINE_INFO());
+
+            const auto low_pass = sample_filter::low_pass(9, 0.125f);
+            Assert::IsTrue(low_pass.type() == sample_filter_type::low_pass, L"Type low_pass", LINE_INFO());
+            Assert::AreEqual(std::size_t(9), low_pass.window(), L"Taps", LINE_INFO());
+            Assert::AreEqual(0.125f, low_pass.cutoff(), L"Cut-off", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([](void) { sample_filter::median(1); }, L"Window too small", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) { sample_filter::exponential(1.5f); }, L"Alpha too large", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) { sample_filter::low_pass(8, 0.1f); }, L"Even taps", LINE_INFO());
+        }
+
+        TEST_METHOD(test_median) {
+            detail::filter_stage stage;
+            std::vector<measurement> filtered;
+            stage.configure(false);
+            Assert::IsFalse(stage.enabled(), L"Disabled without filters", LINE_INFO());
+            Assert::IsFalse(stage.push(measurement(L"a", 0, 1.0f)), L"Passed through while disabled", LINE_INFO());
+
+            stage.filter(L"a", sample_filter::median(3));
+            Assert::IsTrue(stage.enabled(), L"Enabled", LINE_INFO());
+            Assert::IsFalse(stage.push(measurement(L"b", 0, 1.0f)), L"Unfiltered sensor passed through", LINE_INFO());
+
+            const float power[] = { 1.0f, 2.0f, 100.0f, 4.0f, 5.0f };
+            for (std::size_t i = 0; i < 5; ++i) {
+                auto t = static_cast<measurement::timestamp_type>(10 * i);
+                Assert::IsTrue(stage.push(measurement(L"a", t, power[i])), L"Sample consumed", LINE_INFO());
+            }
+
+            stage.process(filtered);
+            Assert::AreEqual(std::size_t(4), filtered.size(), L"Medians of complete windows", LINE_INFO());
+            Assert::AreEqual(L"a", filtered[0].sensor(), L"Name", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(0), filtered[0].timestamp(), L"Centred timestamp", LINE_INFO());
+            Assert::AreEqual(1.0f, filtered[0].power(), L"Replicated first sample", LINE_INFO());
+            Assert::AreEqual(2.0f, filtered[1].power(), L"Median #1", LINE_INFO());
+            Assert::AreEqual(4.0f, filtered[2].power(), L"Outlier rejected", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(30), filtered[3].timestamp(), L"Timestamp #3", LINE_INFO());
+            filtered.clear();
+
+            stage.flush(filtered);
+            Assert::AreEqual(std::size_t(1), filtered.size(), L"Tail released", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(40), filtered[0].timestamp(), L"Last timestamp", LINE_INFO());
+            Assert::AreEqual(5.0f, filtered[0].power(), L"Replicated last sample", LINE_INFO());
+        }
+
+        TEST_METHOD(test_exponential) {
+            detail::filter_stage stage;
+            std::vector<measurement> filtered;
+            stage.configure(false);
+            stage.filter(L"a", sample_filter::exponential(0.5f));
+
+            stage.push(measurement(L"a", 0, 2.0f, 1.0f));
+            stage.push(measurement(L"a", 1, 4.0f, 3.0f));
+            stage.process(filtered);
+            Assert::AreEqual(std::size_t(2), filtered.size(), L"All smoothed", LINE_INFO());
+            Assert::AreEqual(2.0f, filtered[0].power(), L"Initial state", LINE_INFO());
+            Assert::AreEqual(7.0f, filtered[1].power(), 0.0001f, L"Smoothed power", LINE_INFO());
+            Assert::AreEqual(3.0f, filtered[1].voltage(), 0.0001f, L"Smoothed voltage", LINE_INFO());
+            Assert::AreEqual(2.0f, filtered[1].current(), 0.0001f, L"Smoothed current", LINE_INFO());
+            filtered.clear();
+
+            stage.push(measurement(L"a", 2, 4.0f, 3.0f));
+            stage.process(filtered);
+            Assert::AreEqual(std::size_t(1), filtered.size(), L"State carried over", LINE_INFO());
+            Assert::AreEqual(3.5f, filtered[0].voltage(), 0.0001f, L"Continued recurrence", LINE_INFO());
+        }
+
+        TEST_METHOD(test_low_pass) {
+            detail::filter_stage stage;
+            std::vector<measurement> filtered;
+            stage.configure(true);
+            stage.filter(L"a", sample_filter::low_pass(7, 0.1f));
+
+            for (std::size_t i = 0; i < 20; ++i) {
+                auto t = static_cast<measurement::timestamp_type>(i);
+                Assert::IsFalse(stage.push(measurement(L"a", t, 3.0f)), L"Raw sample retained", LINE_INFO());
+            }
+
+            stage.process(filtered);
+            stage.flush(filtered);
+            Assert::AreEqual(std::size_t(20), filtered.size(), L"One output per sample", LINE_INFO());
+            for (auto& m : filtered) {
+                Assert::AreEqual(L"a/filtered", m.sensor(), L"Name of filtered sensor", LINE_INFO());
+                Assert::AreEqual(3.0f, m.power(), 0.0001f, L"Unit gain", LINE_INFO());
+            }
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,80 @@
+﻿// <copyright file="gpu_timestamp_correlator_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(gpu_timestamp_correlator_test) {
+
+    public:
+
+        TEST_METHOD(test_invalid) {
+            gpu_timestamp_correlator correlator;
+            Assert::IsFalse(bool(correlator), L"Default is invalid", LINE_INFO());
+            Assert::AreEqual(gpu_timestamp_correlator::gpu_timestamp_type(0), correlator.frequency(), L"No frequency", LINE_INFO());
+            Assert::IsFalse(correlator.synchronised(), L"Not synchronised", LINE_INFO());
+            Assert::ExpectException<std::runtime_error>([&correlator](void) { correlator.to_host(0); }, L"Convert invalid", LINE_INFO());
+            Assert::ExpectException<std::runtime_error>([&correlator](void) { correlator.calibrate(gpu_clock, nullptr); }, L"Calibrate invalid", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) { gpu_timestamp_correlator c(0); }, L"Zero frequency", LINE_INFO());
+        }
+
+        TEST_METHOD(test_uncalibrated) {
+            gpu_timestamp_correlator correlator(frequency);
+            Assert::IsTrue(bool(correlator), L"Valid", LINE_INFO());
+            Assert::AreEqual(frequency, correlator.frequency(), L"Frequency", LINE_INFO());
+            Assert::IsFalse(correlator.synchronised(), L"Not synchronised", LINE_INFO());
+            Assert::ExpectException<std::logic_error>([&correlator](void) { correlator.to_host(0); }, L"Convert uncalibrated", LINE_INFO());
+            Assert::ExpectException<std::logic_error>([&correlator](void) { correlator.calibrate(); }, L"No command queue", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&correlator](void) { correlator.calibrate(nullptr, nullptr); }, L"Null callback", LINE_INFO());
+        }
+
+        TEST_METHOD(test_calibrate) {
+            gpu_timestamp_correlator correlator(frequency);
+            auto offset = gpu_timestamp_correlator::gpu_timestamp_type(42);
+
+            correlator.calibrate(gpu_clock, &offset);
+            Assert::IsTrue(correlator.synchronised(), L"Synchronised", LINE_INFO());
+
+            // The GPU clock ticks three times per 100 ns, so a second on the
+            // GPU must be a second on the host.
+            const auto now = detail::create_timestamp(timestamp_resolution::hundred_nanoseconds);
+            const auto gpu = gpu_clock(&offset);
+            const auto host = correlator.to_host(gpu);
+            Assert::IsTrue(std::abs(host - now) < 10000, L"Maps to current time", LINE_INFO());
+
+            const auto later = correlator.to_host(gpu + frequency);
+            Assert::IsTrue(std::abs(later - host - 10000000) <= 1, L"One second later", LINE_INFO());
+
+            const auto ms = correlator.to_host(gpu, timestamp_resolution::milliseconds);
+            Assert::AreEqual(detail::convert(host, timestamp_resolution::milliseconds), ms, L"Resolution", LINE_INFO());
+
+            gpu_timestamp_correlator moved(std::move(correlator));
+            Assert::IsFalse(bool(correlator), L"Moved away", LINE_INFO());
+            Assert::IsTrue(moved.synchronised(), L"Moved calibration", LINE_INFO());
+        }
+
+    private:
+
+        static constexpr gpu_timestamp_correlator::gpu_timestamp_type frequency = 30000000;
+
+        static gpu_timestamp_correlator::gpu_timestamp_type gpu_clock(void *context) {
+            auto offset = (context != nullptr)
+                ? *static_cast<gpu_timestamp_correlator::gpu_timestamp_type *>(context)
+                : 0;
+            auto now = detail::create_timestamp(timestamp_resolution::hundred_nanoseconds);
+            return 3 * static_cast<gpu_timestamp_correlator::gpu_timestamp_type>(now) + offset;
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
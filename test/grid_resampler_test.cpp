@@ -0,0 +1,86 @@
+﻿// <copyright file="grid_resampler_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(grid_resampler_test) {
+
+    public:
+
+        TEST_METHOD(test_disabled) {
+            detail::grid_resampler resampler;
+            std::vector<detail::grid_resampler::sample_type> resampled;
+            Assert::IsFalse(resampler.enabled(), L"Disabled by default", LINE_INFO());
+
+            resampler.push(measurement(L"sensor", 3, 1.0f), 1, resampled);
+            Assert::AreEqual(std::size_t(1), resampled.size(), L"Passed through", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(3), resampled[0].first.timestamp(), L"Timestamp retained", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([&resampler](void) { resampler.configure(-1); }, L"Negative step", LINE_INFO());
+        }
+
+        TEST_METHOD(test_grid) {
+            detail::grid_resampler resampler;
+            std::vector<detail::grid_resampler::sample_type> resampled;
+            resampler.configure(10);
+            Assert::IsTrue(resampler.enabled(), L"Enabled", LINE_INFO());
+
+            resampler.push(measurement(L"sensor", 5, 1.0f), 0, resampled);
+            Assert::IsTrue(resampled.empty(), L"First sample off the grid", LINE_INFO());
+
+            // The grid points 10, 20 and 30 are between 5 and 35.
+            resampler.push(measurement(L"sensor", 35, 4.0f), 2, resampled);
+            Assert::AreEqual(std::size_t(3), resampled.size(), L"Grid points", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(10), resampled[0].first.timestamp(), L"Timestamp #0", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(30), resampled[2].first.timestamp(), L"Timestamp #2", LINE_INFO());
+            Assert::AreEqual(1.5f, resampled[0].first.power(), 0.0001f, L"Power #0", LINE_INFO());
+            Assert::AreEqual(2.5f, resampled[1].first.power(), 0.0001f, L"Power #1", LINE_INFO());
+            Assert::AreEqual(3.5f, resampled[2].first.power(), 0.0001f, L"Power #2", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(2), resampled[0].second, L"Marker of later sample", LINE_INFO());
+            resampled.clear();
+
+            // Other sensors are resampled independently.
+            resampler.push(measurement(L"other", 20, 1.0f), 0, resampled);
+            Assert::AreEqual(std::size_t(1), resampled.size(), L"First sample on the grid", LINE_INFO());
+            resampled.clear();
+
+            resampler.push(measurement(L"sensor", 38, 4.0f), 0, resampled);
+            Assert::IsTrue(resampled.empty(), L"No grid point", LINE_INFO());
+        }
+
+        TEST_METHOD(test_gap) {
+            detail::grid_resampler resampler;
+            std::vector<detail::grid_resampler::sample_type> resampled;
+            resampler.configure(10);
+
+            resampler.push(measurement(L"sensor", 0, 1.0f), 0, resampled);
+            resampler.push(measurement(L"sensor", 10, 1.0f), 0, resampled);
+            Assert::AreEqual(std::size_t(2), resampled.size(), L"Regular samples", LINE_INFO());
+            resampled.clear();
+
+            resampler.push(measurement(L"sensor", 1005, 1.0f), 0, resampled);
+            Assert::IsTrue(resampled.empty(), L"Gap not bridged", LINE_INFO());
+
+            resampler.push(measurement(L"sensor", 1015, 1.0f), 0, resampled);
+            Assert::AreEqual(std::size_t(1), resampled.size(), L"Continued after gap", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(1010), resampled[0].first.timestamp(), L"Timestamp after gap", LINE_INFO());
+
+            resampler.push(measurement(L"sensor", 1012, 1.0f), 0, resampled);
+            Assert::AreEqual(std::size_t(1), resampled.size(), L"Out of order ignored", LINE_INFO());
+        }
+
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
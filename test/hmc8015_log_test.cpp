@@ -0,0 +1,125 @@
+﻿// <copyright file="hmc8015_log_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(hmc8015_log_test) {
+
+    public:
+
+        TEST_METHOD(test_parse_real) {
+            {
+                const char input[] = " -1.25E+01,";
+                const char *cur = input;
+                double value;
+                Assert::IsTrue(detail::parse_real(cur, input + sizeof(input) - 1, value), L"Parse with exponent", LINE_INFO());
+                Assert::AreEqual(-12.5, value, L"Value with exponent", LINE_INFO());
+                Assert::AreEqual(',', *cur, L"Stops at separator", LINE_INFO());
+            }
+
+            {
+                // Not null-terminated, so the parser must not read past "12".
+                const char input[] = "123";
+                const char *cur = input;
+                double value;
+                Assert::IsTrue(detail::parse_real(cur, input + 2, value), L"Parse range", LINE_INFO());
+                Assert::AreEqual(12.0, value, L"Only range is parsed", LINE_INFO());
+            }
+
+            {
+                const char input[] = "1e";
+                const char *cur = input;
+                double value;
+                Assert::IsTrue(detail::parse_real(cur, input + 2, value), L"Parse incomplete exponent", LINE_INFO());
+                Assert::AreEqual(1.0, value, L"Incomplete exponent ignored", LINE_INFO());
+                Assert::AreEqual('e', *cur, L"Incomplete exponent not consumed", LINE_INFO());
+            }
+
+            {
+                const char input[] = "9.91E+37";
+                const char *cur = input;
+                double value;
+                Assert::IsTrue(detail::parse_real(cur, input + sizeof(input) - 1, value), L"Parse SCPI NaN", LINE_INFO());
+                Assert::IsTrue(std::isnan(value), L"SCPI NaN", LINE_INFO());
+            }
+
+            {
+                const char input[] = "abc";
+                const char *cur = input;
+                double value;
+                Assert::IsFalse(detail::parse_real(cur, input + sizeof(input) - 1, value), L"Not a number", LINE_INFO());
+                Assert::IsTrue(cur == input, L"Position unchanged on failure", LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(test_parse_data) {
+            const char response[] = "2.301E+02, 5.000E-01,+1.150E+02\n";
+            blob data(sizeof(response) - 1);
+            std::copy(response, response + data.size(), data.as<char>());
+
+            auto sample = detail::parse_hmc8015_data(data, 42);
+            Assert::AreEqual(timestamp_type(42), sample.timestamp(), L"Timestamp", LINE_INFO());
+            Assert::AreEqual(230.1f, sample.voltage(), 1e-4f, L"Voltage", LINE_INFO());
+            Assert::AreEqual(0.5f, sample.current(), 1e-4f, L"Current", LINE_INFO());
+            Assert::AreEqual(115.0f, sample.power(), 1e-4f, L"Power", LINE_INFO());
+
+            blob truncated(data.size() - 11);
+            std::copy(response, response + truncated.size(), truncated.as<char>());
+            Assert::ExpectException<std::invalid_argument>([&truncated](void) { detail::parse_hmc8015_data(truncated, 0); }, L"Missing value", LINE_INFO());
+        }
+
+        TEST_METHOD(test_parse_log) {
+            const char input[] = "HMC8015 log\r\n"
+                "\"Time\";\"U[V]\";\"I[A]\";\"P[W]\"\r\n"
+                "12:00:00.0;230.1;0.5;100.0\r\n"
+                "12:00:00.5;230.2;0.6;110.0\r\n"
+                "12:00:01.0;230.3;;120.0";
+            std::vector<detail::hmc8015_log_entry> entries;
+
+            auto cnt = detail::parse_hmc8015_log(input, sizeof(input) - 1, 1.0,
+                [](const detail::hmc8015_log_entry& e, void *c) {
+                    static_cast<std::vector<detail::hmc8015_log_entry> *>(c)->push_back(e);
+                }, &entries);
+
+            Assert::AreEqual(std::size_t(3), cnt, L"Three data lines", LINE_INFO());
+            Assert::AreEqual(cnt, entries.size(), L"Callback per line", LINE_INFO());
+            Assert::AreEqual(0.0, entries[0].offset, L"First offset", LINE_INFO());
+            Assert::AreEqual(0.5, entries[1].offset, 1e-9, L"Second offset from time", LINE_INFO());
+            Assert::AreEqual(1.0, entries[2].offset, 1e-9, L"Third offset from time", LINE_INFO());
+            Assert::AreEqual(230.1f, entries[0].voltage, 1e-4f, L"Voltage", LINE_INFO());
+            Assert::AreEqual(0.6f, entries[1].current, 1e-4f, L"Current", LINE_INFO());
+            Assert::AreEqual(120.0f, entries[2].power, 1e-4f, L"Power", LINE_INFO());
+            Assert::IsTrue(std::isnan(entries[2].current), L"Missing current", LINE_INFO());
+        }
+
+        TEST_METHOD(test_parse_log_without_time) {
+            const char input[] = "URMS,IRMS,P\n1,2,3\n4,5,6\n";
+            std::size_t cnt = 0;
+            double last_offset = -1.0;
+
+            detail::parse_hmc8015_log(input, sizeof(input) - 1, 0.25,
+                [](const detail::hmc8015_log_entry& e, void *c) {
+                    *static_cast<double *>(c) = e.offset;
+                }, &last_offset);
+            cnt = detail::parse_hmc8015_log(input, sizeof(input) - 1, 0.25,
+                [](const detail::hmc8015_log_entry&, void *) { }, nullptr);
+
+            Assert::AreEqual(std::size_t(2), cnt, L"Two data lines", LINE_INFO());
+            Assert::AreEqual(0.25, last_offset, L"Offset from interval", LINE_INFO());
+        }
+
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,80 @@
+﻿// <copyright file="identity_cache_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(identity_cache_test) {
+
+    public:
+
+        TEST_METHOD(test_disabled) {
+            detail::identity_cache cache;
+            std::string identity;
+            Assert::IsFalse(cache.enabled(), L"Disabled by default", LINE_INFO());
+
+            cache.store("TCPIP::1.2.3.4::INSTR", "HMC8015", 100);
+            Assert::IsFalse(cache.lookup(identity, "TCPIP::1.2.3.4::INSTR", 100), L"Nothing stored while disabled", LINE_INFO());
+        }
+
+        TEST_METHOD(test_ttl) {
+            detail::identity_cache cache;
+            std::string identity;
+            cache.load(L"identity_cache_ttl_test.json", 10);
+            Assert::IsTrue(cache.enabled(), L"Enabled by file", LINE_INFO());
+
+            cache.store("TCPIP::1.2.3.4::INSTR", "Rohde&Schwarz,HMC8015,1234,1.0", 100);
+            Assert::IsTrue(cache.lookup(identity, "TCPIP::1.2.3.4::INSTR", 109), L"Valid entry", LINE_INFO());
+            Assert::AreEqual("Rohde&Schwarz,HMC8015,1234,1.0", identity.c_str(), L"Identity retrieved", LINE_INFO());
+            Assert::IsFalse(cache.lookup(identity, "TCPIP::1.2.3.4::INSTR", 110), L"Expired entry", LINE_INFO());
+            Assert::IsFalse(cache.lookup(identity, "TCPIP::1.2.3.5::INSTR", 100), L"Unknown resource", LINE_INFO());
+        }
+
+        TEST_METHOD(test_persistence) {
+            const auto path = L"identity_cache_test.json";
+            std::string identity;
+
+            {
+                detail::identity_cache cache;
+                cache.load(path, 10);
+                cache.store("TCPIP::1.2.3.4::INSTR", "RTB2004", 100);
+                cache.store("TCPIP::1.2.3.5::INSTR", "HMC8015", 90);
+                cache.save(105);
+            }
+
+            {
+                detail::identity_cache cache;
+                cache.load(path, 10);
+                Assert::IsTrue(cache.lookup(identity, "TCPIP::1.2.3.4::INSTR", 105), L"Entry restored", LINE_INFO());
+                Assert::AreEqual("RTB2004", identity.c_str(), L"Identity restored", LINE_INFO());
+                Assert::IsFalse(cache.lookup(identity, "TCPIP::1.2.3.5::INSTR", 95), L"Expired entry not saved", LINE_INFO());
+            }
+
+            {
+                std::ofstream s("identity_cache_test.json", std::ofstream::trunc);
+                s << "{ not json";
+            }
+
+            {
+                detail::identity_cache cache;
+                cache.load(path, 10);
+                Assert::IsTrue(cache.enabled(), L"Enabled despite corrupt file", LINE_INFO());
+                Assert::IsFalse(cache.lookup(identity, "TCPIP::1.2.3.4::INSTR", 105), L"Corrupt file discarded", LINE_INFO());
+            }
+
+            std::remove("identity_cache_test.json");
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
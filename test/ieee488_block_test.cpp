@@ -0,0 +1,45 @@
+﻿// <copyright file="ieee488_block_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(ieee488_block_test) {
+
+    public:
+
+        TEST_METHOD(test_definite_length) {
+            const std::string block("#3128abc");
+            Assert::AreEqual(std::size_t(5 + 128 + 1), detail::ieee488_block_size(block.data(), block.size()), L"Normal header", LINE_INFO());
+            Assert::AreEqual(std::size_t(5 + 128 + 1), detail::ieee488_block_size(block.data(), 5), L"Header only", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), detail::ieee488_block_size(block.data(), 4), L"Incomplete header", LINE_INFO());
+        }
+
+        TEST_METHOD(test_variable_length) {
+            const std::string block("#(1000)abc");
+            Assert::AreEqual(std::size_t(7 + 1000 + 1), detail::ieee488_block_size(block.data(), block.size()), L"Variable-length header", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), detail::ieee488_block_size(block.data(), 6), L"Unterminated header", LINE_INFO());
+        }
+
+        TEST_METHOD(test_invalid) {
+            Assert::AreEqual(std::size_t(0), detail::ieee488_block_size(nullptr, 10), L"nullptr", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), detail::ieee488_block_size("1.0,2.0", 7), L"No block", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), detail::ieee488_block_size("#0", 2), L"Indefinite block", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), detail::ieee488_block_size("#2a1", 4), L"Non-numeric length", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), detail::ieee488_block_size("#()", 3), L"Empty length", LINE_INFO());
+        }
+
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,73 @@
+﻿// <copyright file="instrument_clock_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(instrument_clock_test) {
+
+    public:
+
+        TEST_METHOD(test_latency) {
+            detail::instrument_clock clock(4);
+            Assert::AreEqual(timestamp_type(0), clock.latency(), L"No round trip yet", LINE_INFO());
+            Assert::AreEqual(timestamp_type(150), clock.answered(100, 200), L"Midpoint without estimate", LINE_INFO());
+
+            clock.update(0, 100);
+            clock.update(1000, 1040);
+            clock.update(2000, 2200);
+            Assert::AreEqual(timestamp_type(20), clock.latency(), L"Half of shortest round trip", LINE_INFO());
+            Assert::AreEqual(timestamp_type(2980), clock.answered(2800, 3000), L"Receipt less latency", LINE_INFO());
+            Assert::AreEqual(timestamp_type(3010), clock.answered(3000, 3020), L"Not before midpoint", LINE_INFO());
+
+            clock.update(3000, 3100);
+            clock.update(4000, 4100);
+            Assert::AreEqual(timestamp_type(20), clock.latency(), L"Shortest still in window", LINE_INFO());
+            clock.update(5000, 5100);
+            Assert::AreEqual(timestamp_type(50), clock.latency(), L"Shortest left window", LINE_INFO());
+
+            clock.update(7000, 6000);
+            Assert::AreEqual(timestamp_type(50), clock.latency(), L"Negative round trip ignored", LINE_INFO());
+        }
+
+        TEST_METHOD(test_offset_and_drift) {
+            detail::instrument_clock clock;
+            Assert::IsFalse(clock.synchronised(), L"Not synchronised initially", LINE_INFO());
+            Assert::AreEqual(timestamp_type(42), clock.to_host(42), L"Identity if not synchronised", LINE_INFO());
+
+            // The instrument is 5000 ticks behind and its clock runs 1e-4 slower.
+            const timestamp_type base = 130000000000000000;
+            for (timestamp_type i = 0; i < 10; ++i) {
+                const auto host = base + i * 10000000;
+                const auto instrument = base - 5000 + static_cast<timestamp_type>(i * 10000000 * (1.0 - 1e-4));
+                const auto rtt = (i == 3) ? 40000 : 200;
+                clock.update(host - rtt / 2, instrument, host + rtt / 2);
+            }
+
+            Assert::IsTrue(clock.synchronised(), L"Synchronised", LINE_INFO());
+            Assert::AreEqual(1e-4, clock.drift(), 1e-6, L"Drift", LINE_INFO());
+            Assert::AreEqual(timestamp_type(100), clock.latency(), L"Latency", LINE_INFO());
+
+            const auto instrument = base - 5000 + static_cast<timestamp_type>(20 * 10000000 * (1.0 - 1e-4));
+            const auto expected = base + 20 * 10000000;
+            Assert::IsTrue(std::abs(expected - clock.to_host(instrument)) < 10, L"Extrapolated host time", LINE_INFO());
+
+            timestamp_type bulk[] = { instrument, base };
+            clock.to_host(bulk, 2);
+            Assert::AreEqual(clock.to_host(instrument), bulk[0], L"Bulk conversion", LINE_INFO());
+            Assert::AreEqual(clock.to_host(base), bulk[1], L"Bulk conversion", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -102,6 +102,37 @@ namespace test {
             }
         }
 
+        TEST_METHOD(test_read_bytes_at) {
+            std::array<char, 16> expected;
+            std::generate(expected.begin(), expected.end(), [](void) {
+                static char i = 0;
+                return i++;
+            });
+
+            std::ofstream test_stream("io_test", std::ios::binary | std::ios::trunc);
+            test_stream.write(expected.data(), expected.size());
+            test_stream.close();
+
+            {
+                auto handle = detail::open(L"io_test", GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING);
+                std::array<char, 4> actual;
+                detail::read_bytes_at(handle, actual.data(), actual.size(), 8);
+                Assert::IsTrue(std::equal(expected.begin() + 8, expected.begin() + 12, actual.begin(), actual.end()), L"Bytes at offset read", LINE_INFO());
+                detail::read_bytes_at(handle, actual.data(), actual.size(), 2);
+                Assert::IsTrue(std::equal(expected.begin() + 2, expected.begin() + 6, actual.begin(), actual.end()), L"Bytes at lower offset read", LINE_INFO());
+                ::CloseHandle(handle);
+            }
+
+            {
+                auto handle = detail::open(L"io_test", GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING);
+                Assert::ExpectException<std::system_error>([handle](void) {
+                    std::array<char, 4> actual;
+                    detail::read_bytes_at(handle, actual.data(), actual.size(), 14);
+                }, L"Read beyond end of file", LINE_INFO());
+                ::CloseHandle(handle);
+            }
+        }
+
     };
 } /* namespace test */
 } /* namespace power_overwhelming */
@@ -0,0 +1,103 @@
+﻿// <copyright file="kernel_energy_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(kernel_energy_test) {
+
+    public:
+
+        TEST_METHOD(test_resolution) {
+            Assert::ExpectException<std::invalid_argument>([](void) { detail::kernel_energy_integrator integrator(0.0); }, L"Zero resolution", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) { detail::kernel_energy_integrator integrator(-1.0); }, L"Negative resolution", LINE_INFO());
+
+            detail::kernel_energy_integrator integrator;
+            Assert::IsTrue(integrator.summary().empty(), L"No sensors", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&integrator](void) { integrator.push_kernel(nullptr, 0, 1); }, L"Null kernel", LINE_INFO());
+        }
+
+        TEST_METHOD(test_single_kernel) {
+            detail::kernel_energy_integrator integrator(1000.0);
+
+            // Constant 2 W for 1 s with a kernel running from 250 ms to
+            // 750 ms, which is executed twice.
+            integrator.push(measurement(L"sensor", 0, 2.0f));
+            integrator.push(measurement(L"sensor", 1000, 2.0f));
+            integrator.push_kernel("kernel", 250, 500);
+            integrator.push_kernel("kernel", 500, 750);
+
+            auto summary = integrator.summary();
+            Assert::AreEqual(std::size_t(2), summary.size(), L"Kernel and idle", LINE_INFO());
+            Assert::AreEqual(std::string("kernel"), summary[0].kernel, L"Kernel name", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(2), summary[0].invocations, L"Invocations", LINE_INFO());
+            Assert::IsTrue(std::abs(summary[0].duration - 0.5) < 1e-9, L"Duration", LINE_INFO());
+            Assert::IsTrue(std::abs(summary[0].energy - 1.0) < 1e-9, L"Kernel energy", LINE_INFO());
+            Assert::IsTrue(summary[1].kernel.empty(), L"Idle", LINE_INFO());
+            Assert::IsTrue(std::abs(summary[1].energy - 1.0) < 1e-9, L"Idle energy", LINE_INFO());
+        }
+
+        TEST_METHOD(test_overlap) {
+            detail::kernel_energy_integrator integrator(1000.0);
+
+            // Two kernels overlap between 500 ms and 1000 ms at 4 W.
+            integrator.push_kernel("a", 0, 1000);
+            integrator.push_kernel("b", 500, 1500);
+            integrator.push(measurement(L"sensor", 0, 4.0f));
+            integrator.push(measurement(L"sensor", 2000, 4.0f));
+
+            auto summary = integrator.summary();
+            Assert::AreEqual(std::size_t(3), summary.size(), L"Two kernels and idle", LINE_INFO());
+            Assert::IsTrue(std::abs(summary[0].energy - 3.0) < 1e-9, L"Energy of a", LINE_INFO());
+            Assert::IsTrue(std::abs(summary[1].energy - 3.0) < 1e-9, L"Energy of b", LINE_INFO());
+            Assert::IsTrue(std::abs(summary[2].energy - 2.0) < 1e-9, L"Idle energy", LINE_INFO());
+        }
+
+        TEST_METHOD(test_counter) {
+            detail::kernel_energy_integrator integrator(1000.0);
+            integrator.add_counter(L"counter");
+
+            // Counter-based samples report the average since the previous
+            // one, so the kernel gets 1 W * 0.5 s + 3 W * 0.5 s.
+            integrator.push(measurement(L"counter", 0, 0.0f));
+            integrator.push(measurement(L"counter", 1000, 1.0f));
+            integrator.push(measurement(L"counter", 2000, 3.0f));
+            integrator.push_kernel("kernel", 500, 1500);
+
+            auto summary = integrator.summary();
+            Assert::AreEqual(std::size_t(2), summary.size(), L"Kernel and idle", LINE_INFO());
+            Assert::IsTrue(std::abs(summary[0].energy - 2.0) < 1e-9, L"Kernel energy", LINE_INFO());
+            Assert::IsTrue(std::abs(summary[1].energy - 2.0) < 1e-9, L"Idle energy", LINE_INFO());
+        }
+
+        TEST_METHOD(test_csv) {
+            detail::kernel_energy_integrator integrator(1000.0);
+            integrator.push(measurement(L"sensor", 0, 1.0f));
+            integrator.push(measurement(L"sensor", 1000, 1.0f));
+            integrator.push_kernel("f<\"x\", 2>", 0, 1000);
+
+            std::stringstream stream;
+            detail::write_kernel_energy(stream, integrator.summary());
+
+            std::string line;
+            std::getline(stream, line);
+            Assert::AreEqual(std::string("sensor,kernel,invocations,duration,energy"), line, L"Header", LINE_INFO());
+            std::getline(stream, line);
+            Assert::AreEqual(std::string("\"sensor\",\"f<\"\"x\"\", 2>\",1,1,1"), line, L"Kernel", LINE_INFO());
+            std::getline(stream, line);
+            Assert::AreEqual(std::string("\"sensor\",\"\",0,0,0"), line, L"Idle", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
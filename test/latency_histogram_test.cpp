@@ -0,0 +1,107 @@
+﻿// <copyright file="latency_histogram_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(latency_histogram_test) {
+
+    public:
+
+        TEST_METHOD(test_buckets) {
+            for (latency_histogram::value_type v = 0; v < latency_histogram::sub_buckets; ++v) {
+                Assert::AreEqual(std::size_t(v), latency_histogram::index_of(v), L"Small values are exact", LINE_INFO());
+            }
+
+            for (std::size_t i = 0; i < latency_histogram::buckets; ++i) {
+                const auto lower = latency_histogram::lower_bound(i);
+                const auto upper = latency_histogram::upper_bound(i);
+                Assert::IsTrue(lower <= upper, L"Bounds are ordered", LINE_INFO());
+                Assert::AreEqual(i, latency_histogram::index_of(lower), L"Lower bound round trip", LINE_INFO());
+                Assert::AreEqual(i, latency_histogram::index_of(upper), L"Upper bound round trip", LINE_INFO());
+
+                if (i + 1 < latency_histogram::buckets) {
+                    Assert::AreEqual(upper + 1, latency_histogram::lower_bound(i + 1), L"Buckets are contiguous", LINE_INFO());
+                }
+            }
+
+            Assert::AreEqual(latency_histogram::buckets - 1, latency_histogram::index_of((std::numeric_limits<latency_histogram::value_type>::max)()), L"Large values are clamped", LINE_INFO());
+            Assert::ExpectException<std::out_of_range>([](void) { latency_histogram::lower_bound(latency_histogram::buckets); }, L"Invalid bucket", LINE_INFO());
+        }
+
+        TEST_METHOD(test_record) {
+            latency_histogram histogram;
+            Assert::AreEqual(std::uint64_t(0), histogram.count(), L"Empty count", LINE_INFO());
+            Assert::AreEqual(latency_histogram::value_type(0), histogram.min(), L"Empty minimum", LINE_INFO());
+            Assert::AreEqual(latency_histogram::value_type(0), histogram.percentile(0.5), L"Empty median", LINE_INFO());
+
+            for (latency_histogram::value_type v = 1; v <= 1000; ++v) {
+                histogram.record(v * 1000);
+            }
+
+            Assert::AreEqual(std::uint64_t(1000), histogram.count(), L"Count", LINE_INFO());
+            Assert::AreEqual(latency_histogram::value_type(1000), histogram.min(), L"Minimum", LINE_INFO());
+            Assert::AreEqual(latency_histogram::value_type(1000000), histogram.max(), L"Maximum", LINE_INFO());
+            Assert::AreEqual(500500.0, histogram.mean(), L"Mean", LINE_INFO());
+
+            // The relative error is bounded by the width of the sub-buckets.
+            const auto median = static_cast<double>(histogram.percentile(0.5));
+            Assert::IsTrue(std::abs(median - 500000.0) <= 500000.0 / latency_histogram::sub_buckets, L"Median", LINE_INFO());
+            Assert::AreEqual(histogram.max(), histogram.percentile(1.0), L"Maximum percentile", LINE_INFO());
+            Assert::AreEqual(latency_histogram::index_of(histogram.min()), latency_histogram::index_of(histogram.percentile(0.0)), L"Minimum percentile", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&histogram](void) { histogram.percentile(1.5); }, L"Invalid fraction", LINE_INFO());
+
+            histogram.reset();
+            Assert::AreEqual(std::uint64_t(0), histogram.count(), L"Reset", LINE_INFO());
+        }
+
+        TEST_METHOD(test_merge) {
+            latency_histogram lhs, rhs;
+            lhs.record(10);
+            lhs.record(200);
+            rhs.record(5);
+            rhs.record(7000);
+
+            lhs.merge(rhs);
+            Assert::AreEqual(std::uint64_t(4), lhs.count(), L"Merged count", LINE_INFO());
+            Assert::AreEqual(latency_histogram::value_type(5), lhs.min(), L"Merged minimum", LINE_INFO());
+            Assert::AreEqual(latency_histogram::value_type(7000), lhs.max(), L"Merged maximum", LINE_INFO());
+            Assert::AreEqual(latency_histogram::value_type(7215), lhs.sum(), L"Merged sum", LINE_INFO());
+        }
+
+        TEST_METHOD(test_codec) {
+            latency_histogram expected;
+            expected.record(3);
+            expected.record(42000);
+            expected.record(42001);
+            expected.record(123456789);
+
+            std::stringstream stream;
+            detail::latency_histogram_codec::write(stream, expected);
+            Assert::AreEqual(detail::latency_histogram_codec::size(expected), std::uint64_t(stream.str().size()), L"Size of serialised histogram", LINE_INFO());
+
+            const auto actual = detail::latency_histogram_codec::read(stream);
+            Assert::AreEqual(expected.count(), actual.count(), L"Count", LINE_INFO());
+            Assert::AreEqual(expected.sum(), actual.sum(), L"Sum", LINE_INFO());
+            Assert::AreEqual(expected.min(), actual.min(), L"Minimum", LINE_INFO());
+            Assert::AreEqual(expected.max(), actual.max(), L"Maximum", LINE_INFO());
+            for (std::size_t i = 0; i < latency_histogram::buckets; ++i) {
+                Assert::AreEqual(expected.bucket(i), actual.bucket(i), L"Bucket", LINE_INFO());
+            }
+
+            Assert::ExpectException<std::runtime_error>([&stream](void) { detail::latency_histogram_codec::read(stream); }, L"Stream ended", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
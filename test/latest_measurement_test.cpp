@@ -0,0 +1,114 @@
+﻿// <copyright file="latest_measurement_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    /// <summary>
+    /// A sensor that returns the number of times it has been sampled.
+    /// </summary>
+    class counting_sensor final : public sensor {
+
+    public:
+
+        inline counting_sensor(void) : _cnt(0) { }
+
+        ~counting_sensor(void) {
+            this->sample_batch(nullptr);
+        }
+
+        virtual const wchar_t *name(void) const noexcept override {
+            return L"counting";
+        }
+
+        virtual operator bool(void) const noexcept override {
+            return true;
+        }
+
+    protected:
+
+        measurement_data sample_sync(
+                const timestamp_resolution resolution) const override {
+            return measurement_data(detail::create_timestamp(resolution),
+                static_cast<measurement_data::value_type>(++this->_cnt));
+        }
+
+    private:
+
+        mutable std::atomic<std::size_t> _cnt;
+    };
+
+
+    TEST_CLASS(latest_measurement_test) {
+
+    public:
+
+        TEST_METHOD(test_read) {
+            counting_sensor sensor;
+            latest_measurement latest;
+            Assert::IsTrue(bool(latest), L"New instance is valid", LINE_INFO());
+
+            measurement_data m(0, 0.0f);
+            Assert::IsFalse(latest.read(m), L"Nothing before start", LINE_INFO());
+            Assert::IsFalse(bool(m), L"No valid sample before start", LINE_INFO());
+
+            latest.start(sensor, 1000);
+            Assert::ExpectException<std::logic_error>([&latest, &sensor](void) {
+                latest.start(sensor);
+            }, L"Restart is rejected", LINE_INFO());
+
+            while (!latest.read(m)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            Assert::IsTrue(bool(m), L"Sample is valid", LINE_INFO());
+
+            auto last = m.power();
+            for (int i = 0; i < 8; ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                if (latest.read(m)) {
+                    Assert::IsTrue(m.power() > last, L"Only newer samples are published", LINE_INFO());
+                    last = m.power();
+                }
+            }
+
+            latest.stop();
+            latest.read(m);
+            last = m.power();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            Assert::IsFalse(latest.read(m), L"No samples after stop", LINE_INFO());
+            Assert::AreEqual(last, m.power(), L"Last sample is retained", LINE_INFO());
+        }
+
+        TEST_METHOD(test_move) {
+            counting_sensor sensor;
+            latest_measurement a;
+            a.start(sensor, 1000);
+
+            latest_measurement b(std::move(a));
+            Assert::IsFalse(bool(a), L"Moved instance is invalid", LINE_INFO());
+            Assert::IsTrue(bool(b), L"Target instance is valid", LINE_INFO());
+
+            Assert::ExpectException<std::runtime_error>([&a, &sensor](void) {
+                a.start(sensor);
+            }, L"Moved instance cannot be started", LINE_INFO());
+
+            measurement_data m(0, 0.0f);
+            while (!b.read(m)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            Assert::IsTrue(bool(m), L"Moved sampling continues", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,78 @@
+﻿// <copyright file="level_zero_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(level_zero_test) {
+
+    public:
+
+        TEST_METHOD(test_for_all) {
+            std::vector<level_zero_sensor> sensors(level_zero_sensor::for_all(nullptr, 0));
+            level_zero_sensor::for_all(sensors.data(), sensors.size());
+
+            for (auto& s : sensors) {
+                Assert::IsTrue(bool(s), L"Enumerated sensor is valid", LINE_INFO());
+                Assert::IsNotNull(s.name(), L"Enumerated sensor has name", LINE_INFO());
+                Assert::IsTrue(s.energy() >= 0.0, L"Energy is not negative", LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(test_for_domain) {
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                level_zero_sensor::for_domain(static_cast<const char *>(nullptr), 0);
+            }, L"Null bus ID", LINE_INFO());
+            Assert::ExpectException<std::exception>([](void) {
+                level_zero_sensor::for_domain("ffff:ff:ff.f", 0);
+            }, L"Non-existing device", LINE_INFO());
+        }
+
+        TEST_METHOD(test_disposed) {
+            level_zero_sensor sensor;
+            Assert::IsFalse(bool(sensor), L"Default sensor is invalid", LINE_INFO());
+            Assert::ExpectException<std::runtime_error>([&sensor](void) {
+                sensor.sample_data();
+            }, L"Sample disposed sensor", LINE_INFO());
+        }
+
+#if defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO)
+        TEST_METHOD(test_to_bus_id) {
+            zes_pci_address_t address { };
+            address.domain = 0;
+            address.bus = 3;
+            address.device = 0;
+            address.function = 1;
+            Assert::AreEqual(std::string("0000:03:00.1"), detail::level_zero_device::to_bus_id(address), L"sysfs format", LINE_INFO());
+
+            address.domain = 0x10;
+            address.bus = 0xa2;
+            address.device = 0x1f;
+            address.function = 7;
+            Assert::AreEqual(std::string("0010:a2:1f.7"), detail::level_zero_device::to_bus_id(address), L"Hexadecimal", LINE_INFO());
+        }
+
+        TEST_METHOD(test_exception) {
+            level_zero_exception::check(ZE_RESULT_SUCCESS);
+            Assert::ExpectException<level_zero_exception>([](void) {
+                level_zero_exception::check(ZE_RESULT_ERROR_UNINITIALIZED);
+            }, L"Error code throws", LINE_INFO());
+
+            level_zero_exception ex(ZE_RESULT_ERROR_UNINITIALIZED);
+            Assert::IsTrue(ex.code() == ZE_RESULT_ERROR_UNINITIALIZED, L"Error code retained", LINE_INFO());
+        }
+#endif /* defined(POWER_OVERWHELMING_WITH_LEVEL_ZERO) */
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
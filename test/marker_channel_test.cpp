@@ -0,0 +1,133 @@
+﻿// <copyright file="marker_channel_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(marker_channel_test) {
+
+    public:
+
+        TEST_METHOD(test_invalid) {
+            marker_channel channel;
+            Assert::IsFalse(bool(channel), L"Default channel is invalid", LINE_INFO());
+            Assert::IsFalse(channel.active(), L"Default channel inactive", LINE_INFO());
+            Assert::IsFalse(channel.marker("test"), L"Cannot set marker", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                marker_channel c(nullptr);
+            }, L"Null name", LINE_INFO());
+            Assert::ExpectException<std::system_error>([](void) {
+                marker_channel c("PwrOwgTestDoesNotExist");
+            }, L"Missing channel", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                detail::marker_channel_listener l;
+                l.open(L"PwrOwgMarkerChannelTest", 0);
+            }, L"Zero capacity", LINE_INFO());
+        }
+
+        TEST_METHOD(test_marker) {
+            static const wchar_t *const name = L"PwrOwgMarkerChannelTest";
+            std::vector<detail::marker_channel_listener::marker_type> markers;
+            detail::marker_channel_listener listener;
+            listener.open(name, 3);
+            Assert::IsTrue(listener.is_open(), L"Listener open", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), listener.poll(markers), L"No markers yet", LINE_INFO());
+
+            marker_channel channel("PwrOwgMarkerChannelTest");
+            Assert::IsTrue(bool(channel), L"Channel valid", LINE_INFO());
+            Assert::IsTrue(channel.active(), L"Listener active", LINE_INFO());
+
+            const auto begin = marker_channel::now();
+            Assert::IsTrue(channel.marker("first"), L"Set first", LINE_INFO());
+            Assert::IsTrue(channel.marker(nullptr, 42), L"Clear marker", LINE_INFO());
+
+            const std::string long_text(200, 'x');
+            Assert::IsTrue(channel.marker(long_text.c_str()), L"Set long marker", LINE_INFO());
+
+            Assert::AreEqual(std::size_t(3), listener.poll(markers), L"Three markers", LINE_INFO());
+            Assert::AreEqual(std::string("first"), markers[0].second, L"Text of first", LINE_INFO());
+            Assert::IsTrue(markers[0].first >= begin, L"Timestamp of first", LINE_INFO());
+            Assert::IsTrue(markers[0].first <= marker_channel::now(), L"Timestamp not in future", LINE_INFO());
+            Assert::AreEqual(std::int64_t(42), markers[1].first, L"Given timestamp", LINE_INFO());
+            Assert::IsTrue(markers[1].second.empty(), L"Cleared marker", LINE_INFO());
+            Assert::AreEqual(detail::marker_channel_slot::max_text - 1, markers[2].second.size(), L"Long marker truncated", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(0), listener.lost(), L"Nothing lost", LINE_INFO());
+
+            // The capacity has been rounded up to four, so writing more than
+            // that before polling loses the oldest markers.
+            markers.clear();
+            for (int i = 0; i < 10; ++i) {
+                channel.marker(std::to_string(i).c_str(), i);
+            }
+            Assert::AreEqual(std::size_t(4), listener.poll(markers), L"Newest markers", LINE_INFO());
+            Assert::AreEqual(std::string("6"), markers.front().second, L"Oldest retained", LINE_INFO());
+            Assert::AreEqual(std::string("9"), markers.back().second, L"Newest retained", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(6), listener.lost(), L"Lost markers", LINE_INFO());
+
+            listener.close();
+            Assert::IsFalse(channel.active(), L"Listener closed", LINE_INFO());
+            Assert::IsTrue(channel.marker("late"), L"Mapping remains writable", LINE_INFO());
+        }
+
+        TEST_METHOD(test_concurrent) {
+            static const wchar_t *const name = L"PwrOwgMarkerChannelTest";
+            static const int count = 20000;
+            static const int writers = 4;
+            std::vector<detail::marker_channel_listener::marker_type> markers;
+            detail::marker_channel_listener listener;
+            listener.open(name, 64);
+
+            std::vector<std::thread> threads;
+            for (int t = 0; t < writers; ++t) {
+                threads.emplace_back([t](void) {
+                    marker_channel channel("PwrOwgMarkerChannelTest");
+                    for (int i = 0; i < count; ++i) {
+                        channel.marker(std::to_string(t).c_str(), i);
+                    }
+                });
+            }
+
+            std::size_t received = 0;
+            std::vector<int> last(writers, -1);
+            auto check = [&](void) {
+                for (auto& m : markers) {
+                    // Every marker must be intact, and the markers of each
+                    // writer must be retrieved in order.
+                    const auto t = std::stoi(m.second);
+                    Assert::IsTrue((t >= 0) && (t < writers), L"Valid text", LINE_INFO());
+                    Assert::IsTrue(m.first < count, L"Valid timestamp", LINE_INFO());
+                    Assert::IsTrue(m.first > last[t], L"Markers in order", LINE_INFO());
+                    last[t] = static_cast<int>(m.first);
+                }
+                received += markers.size();
+                markers.clear();
+            };
+
+            while (received + listener.lost() < count * writers) {
+                listener.poll(markers);
+                check();
+            }
+
+            for (auto& t : threads) {
+                t.join();
+            }
+
+            Assert::AreEqual(std::size_t(0), listener.poll(markers), L"No more markers", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(count * writers), received + listener.lost(), L"All markers accounted for", LINE_INFO());
+        }
+
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,146 @@
+﻿// <copyright file="measurement_batch_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(measurement_batch_test) {
+
+    public:
+
+        TEST_METHOD(test_assign) {
+            std::vector<measurement_data> samples;
+            for (int i = 0; i < 67; ++i) {
+                if (i % 3 == 0) {
+                    samples.emplace_back(i, static_cast<float>(i + 1));
+                } else {
+                    samples.emplace_back(i, 2.0f, static_cast<float>(i));
+                }
+            }
+
+            measurement_batch batch;
+            batch.assign(samples.data(), samples.size());
+            Assert::AreEqual(samples.size(), batch.size(), L"Size", LINE_INFO());
+            Assert::IsTrue(batch.capacity() >= batch.size(), L"Capacity", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), reinterpret_cast<std::uintptr_t>(batch.values(measurement_quantity::power)) % measurement_batch::alignment, L"Aligned", LINE_INFO());
+
+            for (std::size_t i = 0; i < samples.size(); ++i) {
+                Assert::AreEqual(samples[i].timestamp(), batch.timestamps()[i], L"Timestamp", LINE_INFO());
+                Assert::AreEqual(samples[i].power(), batch.values(measurement_quantity::power)[i], L"Power", LINE_INFO());
+                Assert::IsTrue(batch.valid(i, measurement_quantity::power), L"Power valid", LINE_INFO());
+                Assert::AreEqual(i % 3 != 0, batch.valid(i, measurement_quantity::voltage), L"Voltage valid", LINE_INFO());
+                Assert::AreEqual(samples[i].current(), batch[i].current(), L"Reconstructed", LINE_INFO());
+            }
+
+            Assert::AreEqual(std::size_t(67), batch.count(measurement_quantity::power), L"Valid power", LINE_INFO());
+            Assert::AreEqual(std::size_t(44), batch.count(measurement_quantity::current), L"Valid current", LINE_INFO());
+
+            batch.assign(nullptr, 0);
+            Assert::IsTrue(batch.empty(), L"Cleared", LINE_INFO());
+        }
+
+        TEST_METHOD(test_push_back) {
+            measurement_batch batch;
+            for (int i = 0; i < 130; ++i) {
+                batch.push_back(measurement_data(i, 2.0f, 0.5f));
+            }
+
+            Assert::AreEqual(std::size_t(130), batch.size(), L"Size", LINE_INFO());
+            Assert::AreEqual(std::size_t(130), batch.count(measurement_quantity::power), L"Derived power", LINE_INFO());
+            Assert::AreEqual(1.0f, batch[129].power(), L"Power from V x I", LINE_INFO());
+            Assert::AreEqual(129.0, double(batch.timestamps()[129]), L"Timestamp", LINE_INFO());
+
+            measurement_batch copy(batch);
+            Assert::AreEqual(batch.size(), copy.size(), L"Copied size", LINE_INFO());
+            Assert::AreEqual(130.0, copy.sum(measurement_quantity::power), 0.0001, L"Copied values", LINE_INFO());
+
+            measurement_batch moved(std::move(copy));
+            Assert::AreEqual(std::size_t(0), copy.size(), L"Moved from", LINE_INFO());
+            Assert::AreEqual(std::size_t(130), moved.size(), L"Moved to", LINE_INFO());
+        }
+
+        TEST_METHOD(test_statistics) {
+            std::vector<measurement_data> samples;
+            auto expected = 0.0;
+            for (int i = 0; i < 23; ++i) {
+                const auto p = static_cast<float>((i * 7) % 23 + 1);
+                samples.emplace_back(i, p);
+                expected += p;
+            }
+            samples.emplace_back(23, 2.0f, 3.0f);
+            expected += 6.0;
+
+            measurement_batch batch;
+            batch.assign(samples.data(), samples.size());
+
+            float minimum = 0.0f;
+            float maximum = 0.0f;
+            Assert::IsTrue(batch.min_max(minimum, maximum, measurement_quantity::power), L"Power valid", LINE_INFO());
+            Assert::AreEqual(1.0f, minimum, L"Minimum power", LINE_INFO());
+            Assert::AreEqual(23.0f, maximum, L"Maximum power", LINE_INFO());
+            Assert::AreEqual(expected, batch.sum(measurement_quantity::power), 0.0001, L"Sum of power", LINE_INFO());
+
+            Assert::IsTrue(batch.min_max(minimum, maximum, measurement_quantity::voltage), L"Single voltage", LINE_INFO());
+            Assert::AreEqual(2.0f, minimum, L"Minimum voltage", LINE_INFO());
+            Assert::AreEqual(2.0f, maximum, L"Maximum voltage", LINE_INFO());
+            Assert::AreEqual(3.0, batch.sum(measurement_quantity::current), 0.0001, L"Sum ignores invalid", LINE_INFO());
+
+            batch.assign(samples.data(), 3);
+            minimum = maximum = -1.0f;
+            Assert::IsFalse(batch.min_max(minimum, maximum, measurement_quantity::current), L"No current", LINE_INFO());
+            Assert::AreEqual(-1.0f, minimum, L"Minimum unchanged", LINE_INFO());
+        }
+
+        TEST_METHOD(test_kernels) {
+            const auto invalid = measurement_data::invalid_value;
+            std::vector<float> values(70, 1.0f);
+            values[3] = invalid;
+            values[64] = invalid;
+            values[69] = invalid;
+
+            std::uint64_t mask[2];
+            Assert::AreEqual(std::size_t(67), detail::mask_valid(mask, values.data(), values.size(), invalid), L"Valid count", LINE_INFO());
+            Assert::IsTrue((mask[0] & (1ull << 3)) == 0, L"Bit 3 cleared", LINE_INFO());
+            Assert::IsTrue((mask[0] & (1ull << 4)) != 0, L"Bit 4 set", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(0x1e), mask[1], L"Last word", LINE_INFO());
+
+            std::vector<float> voltage(7, 2.0f);
+            std::vector<float> current(7, 3.0f);
+            std::vector<float> power(7, invalid);
+            power[0] = 5.0f;
+            current[5] = invalid;
+            detail::multiply_missing(power.data(), voltage.data(), current.data(), power.size(), invalid);
+            Assert::AreEqual(5.0f, power[0], L"Measured power retained", LINE_INFO());
+            Assert::AreEqual(6.0f, power[1], L"Power derived (vector)", LINE_INFO());
+            Assert::AreEqual(invalid, power[5], L"Power not derivable", LINE_INFO());
+            Assert::AreEqual(6.0f, power[6], L"Power derived (scalar)", LINE_INFO());
+        }
+
+        TEST_METHOD(test_adapter) {
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                measurement_batch_adapter adapter(nullptr);
+            }, L"Callback required", LINE_INFO());
+
+            std::size_t received = 0;
+            measurement_batch_adapter adapter([](const wchar_t *, const measurement_batch& batch, void *context) {
+                *static_cast<std::size_t *>(context) += batch.count(measurement_quantity::power);
+            }, &received);
+
+            const measurement_data samples[] = { measurement_data(0, 1.0f), measurement_data(1, 2.0f, 1.0f) };
+            measurement_batch_adapter::on_batch(L"test", samples, 2, &adapter);
+            Assert::AreEqual(std::size_t(2), received, L"Batch forwarded", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
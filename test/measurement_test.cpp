@@ -105,6 +105,23 @@ namespace test {
                 Assert::IsTrue(n, L"destination operator bool", LINE_INFO());
             }
         }
+
+        TEST_METHOD(test_interned_sensor) {
+            std::wstring name(L"test");
+            auto m = measurement(name.c_str(), 42, 2.0f);
+            name = L"changed";
+
+            Assert::AreEqual(L"test", m.sensor(), L"sensor independent of input", LINE_INFO());
+
+            auto n = measurement(L"test", 43, 4.0f);
+            Assert::IsTrue(m.sensor() == n.sensor(), L"same name shared", LINE_INFO());
+
+            auto o = m;
+            Assert::IsTrue(m.sensor() == o.sensor(), L"copy shares name", LINE_INFO());
+
+            auto p = measurement(L"other", 42, 2.0f);
+            Assert::IsFalse(m.sensor() == p.sensor(), L"different names", LINE_INFO());
+        }
     };
 } /* namespace test */
 } /* namespace power_overwhelming */
@@ -0,0 +1,66 @@
+﻿// <copyright file="memory_lock_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(memory_lock_test) {
+
+    public:
+
+        TEST_METHOD(test_prefault) {
+            std::vector<std::uint8_t> data(3 * 4096 + 17);
+            for (std::size_t i = 0; i < data.size(); ++i) {
+                data[i] = static_cast<std::uint8_t>(i);
+            }
+
+            detail::memory_lock::prefault(data.data(), data.size());
+            detail::memory_lock::prefault(nullptr, 0);
+
+            for (std::size_t i = 0; i < data.size(); ++i) {
+                Assert::AreEqual(static_cast<std::uint8_t>(i), data[i], L"Content unchanged", LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(test_lock) {
+            std::vector<std::uint8_t> data(4096);
+
+            detail::memory_lock empty;
+            Assert::AreEqual(std::size_t(0), empty.size(), L"Nothing locked", LINE_INFO());
+
+            detail::memory_lock lock(data.data(), data.size());
+            Assert::AreEqual(data.size(), lock.size(), L"Range locked", LINE_INFO());
+
+            auto moved = std::move(lock);
+            Assert::AreEqual(std::size_t(0), lock.size(), L"Moved from", LINE_INFO());
+            Assert::AreEqual(data.size(), moved.size(), L"Moved to", LINE_INFO());
+
+            moved.unlock();
+            Assert::AreEqual(std::size_t(0), moved.size(), L"Unlocked", LINE_INFO());
+        }
+
+        TEST_METHOD(test_ring_storage) {
+            detail::spsc_ring<int> ring(100);
+            Assert::IsNotNull(ring.storage(), L"Storage allocated", LINE_INFO());
+            Assert::AreEqual(ring.capacity() * sizeof(int), ring.storage_size(), L"Storage size", LINE_INFO());
+
+            detail::memory_lock lock(ring.storage(), ring.storage_size());
+            ring.push(42);
+            auto value = 0;
+            ring.drain([&value](const int v, detail::spsc_ring<int>::position_type) { value = v; });
+            Assert::AreEqual(42, value, L"Ring usable while locked", LINE_INFO());
+        }
+
+    };
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
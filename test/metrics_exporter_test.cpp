@@ -0,0 +1,69 @@
+﻿// <copyright file="metrics_exporter_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(metrics_exporter_test) {
+
+    public:
+
+        TEST_METHOD(test_empty) {
+            metrics_exporter exporter;
+            Assert::IsTrue(bool(exporter), L"New exporter is valid", LINE_INFO());
+
+            const auto size = exporter.render(nullptr, 0);
+            std::string text(size, '\0');
+            Assert::AreEqual(size, exporter.render(&text[0], text.size()), L"Size is stable", LINE_INFO());
+            Assert::AreEqual(std::string::size_type(0), text.find("# TYPE pwrowg_power_watts gauge\n"), L"Starts with first family", LINE_INFO());
+            Assert::AreEqual(text.size() - 6, text.rfind("# EOF\n"), L"Terminated by EOF", LINE_INFO());
+            Assert::AreEqual(std::string::npos, text.find("{sensor="), L"No samples", LINE_INFO());
+
+            char truncated[8];
+            Assert::AreEqual(size, exporter.render(truncated, sizeof(truncated)), L"Truncation reports full size", LINE_INFO());
+            Assert::AreEqual(0, ::memcmp(truncated, text.data(), sizeof(truncated)), L"Truncated prefix", LINE_INFO());
+
+            auto moved = std::move(exporter);
+            Assert::IsFalse(bool(exporter), L"Moved exporter is invalid", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), exporter.render(nullptr, 0), L"Moved exporter renders nothing", LINE_INFO());
+            Assert::ExpectException<std::runtime_error>([&exporter](void) { exporter.start(); }, L"Moved exporter cannot start", LINE_INFO());
+        }
+
+        TEST_METHOD(test_render) {
+            synthetic_sensor sensor(L"synth \"1\"", synthetic_waveform::constant);
+            sensor.offset(24.0f).voltage(12.0f);
+
+            metrics_exporter exporter;
+            exporter.add(sensor, 1000);
+            Assert::ExpectException<std::logic_error>([&exporter, &sensor](void) { exporter.add(sensor); }, L"Sensor is already sampled", LINE_INFO());
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            std::string text(exporter.render(nullptr, 0), '\0');
+            exporter.render(&text[0], text.size());
+            exporter.stop();
+
+            Assert::AreNotEqual(std::string::npos, text.find("pwrowg_power_watts{sensor=\"synth \\\"1\\\"\"} 24\n"), L"Escaped power sample", LINE_INFO());
+            Assert::AreNotEqual(std::string::npos, text.find("pwrowg_voltage_volts{sensor=\"synth \\\"1\\\"\"} 12\n"), L"Voltage sample", LINE_INFO());
+            Assert::AreNotEqual(std::string::npos, text.find("pwrowg_current_amperes{sensor=\"synth \\\"1\\\"\"} 2\n"), L"Current sample", LINE_INFO());
+
+            const auto energy = text.find("pwrowg_energy_joules_total{sensor=");
+            Assert::AreNotEqual(std::string::npos, energy, L"Energy sample", LINE_INFO());
+            const auto value = std::atof(text.c_str() + text.find("} ", energy) + 2);
+            Assert::IsTrue(value > 0.0, L"Energy accumulated", LINE_INFO());
+            Assert::IsTrue(value < 24.0 * 10.0, L"Energy plausible", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
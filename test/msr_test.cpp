@@ -23,10 +23,112 @@ namespace test {
             Assert::AreEqual(std::size_t(0), sensors.size(), L"MSR is not supported on Windows", LINE_INFO());
         }
 
+        TEST_METHOD(test_for_all_topology) {
+            const auto deduplicated = msr_sensor::for_all(nullptr, 0, true);
+            const auto all = msr_sensor::for_all(nullptr, 0, false);
+            Assert::IsTrue(deduplicated <= all, L"Aliases of shared registers are omitted", LINE_INFO());
+        }
+
+        TEST_METHOD(test_sample_data) {
+            msr_sensor sensor;
+            Assert::ExpectException<std::runtime_error>([&sensor](void) {
+                sensor.sample_data();
+            }, L"Invalid sensor", LINE_INFO());
+
+            measurement_data sample(0, 0.0f);
+            Assert::ExpectException<std::runtime_error>([&](void) {
+                msr_sensor::sample_data(&sample, &sensor, 1);
+            }, L"Batch with invalid sensor", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&](void) {
+                msr_sensor::sample_data(nullptr, &sensor, 1);
+            }, L"Batch without output", LINE_INFO());
+
+            msr_sensor::sample_data(nullptr, nullptr, 0);
+        }
+
         TEST_METHOD(test_support) {
             // We test the default support check, which is the same for all vendors.
             auto actual = detail::is_rapl_energy_supported(0, rapl_domain::package);
         }
+
+        TEST_METHOD(test_rapl_energy_delta) {
+            Assert::AreEqual(std::uint64_t(0), detail::rapl_energy_delta(42, 42), L"No change", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(8), detail::rapl_energy_delta(50, 42), L"Linear increase", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(0x11), detail::rapl_energy_delta(0x10, 0xFFFFFFFF), L"Wraparound", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(1), detail::rapl_energy_delta(0, 0xFFFFFFFF), L"Wraparound to zero", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(8), detail::rapl_energy_delta(0xABCD00000000004A, 0x1234000000000042), L"Reserved bits ignored", LINE_INFO());
+        }
+
+        TEST_METHOD(test_channel_names) {
+            const msr_channel channels[] = {
+                msr_channel::aperf,
+                msr_channel::mperf,
+                msr_channel::package_thermal_status,
+                msr_channel::package_throttling,
+                msr_channel::pp0_throttling,
+                msr_channel::dram_throttling,
+                msr_channel::core_limit_reasons
+            };
+
+            for (auto c : channels) {
+                Assert::IsTrue(c == parse_msr_channel(to_string(c)), L"Round trip", LINE_INFO());
+            }
+
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                parse_msr_channel(L"tsc");
+            }, L"Invalid channel", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                parse_msr_channel(nullptr);
+            }, L"Null channel", LINE_INFO());
+        }
+
+        TEST_METHOD(test_channels) {
+            msr_sensor sensor;
+            Assert::ExpectException<std::runtime_error>([&sensor](void) {
+                sensor.channel(msr_channel::aperf, true);
+            }, L"Invalid sensor", LINE_INFO());
+            Assert::ExpectException<std::runtime_error>([&sensor](void) {
+                sensor.channel_samples(nullptr, 0);
+            }, L"Invalid sensor", LINE_INFO());
+
+            const auto invalid = (std::numeric_limits<msr_sensor::core_type>::max)();
+            Assert::IsFalse(detail::is_msr_channel_supported(invalid, msr_channel::aperf), L"Non-existing core", LINE_INFO());
+        }
+
+        TEST_METHOD(test_sample_channel) {
+            detail::msr_sensor_impl impl;
+
+            detail::msr_sensor_impl::channel_state counter;
+            counter.channel = msr_channel::package_throttling;
+            counter.config.counter_mask = detail::energy_status_mask;
+            counter.last_value = 0;
+            counter.primed = false;
+            counter.unit_divisor = 2.0;
+            impl.channels.push_back(counter);
+
+            detail::msr_sensor_impl::channel_state status;
+            status.channel = msr_channel::package_thermal_status;
+            status.last_value = 0;
+            status.primed = false;
+            status.unit_divisor = 1.0;
+            impl.channels.push_back(status);
+
+            impl.sample_channel(0, 0xFFFFFFF0, 1);
+            impl.sample_channel(1, 0x88000000, 1);
+            impl.sample_channel(2, 42, 1);
+            Assert::AreEqual(std::size_t(1), impl.get_channel_samples(nullptr, 0), L"Counter needs baseline", LINE_INFO());
+
+            impl.sample_channel(0, 0x10, 2);
+
+            msr_channel_sample samples[4];
+            Assert::AreEqual(std::size_t(2), impl.get_channel_samples(samples, 4), L"Two samples", LINE_INFO());
+            Assert::IsTrue(samples[0].channel() == msr_channel::package_thermal_status, L"Status first", LINE_INFO());
+            Assert::AreEqual(double(0x88000000), samples[0].value(), L"Raw status", LINE_INFO());
+            Assert::IsTrue(samples[1].channel() == msr_channel::package_throttling, L"Counter second", LINE_INFO());
+            Assert::AreEqual(msr_channel_sample::timestamp_type(2), samples[1].timestamp(), L"Timestamp", LINE_INFO());
+            Assert::AreEqual(16.0, samples[1].value(), L"Wrapped increment in units", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), impl.get_channel_samples(nullptr, 0), L"Samples removed", LINE_INFO());
+        }
     };
 
 } /* namespace test */
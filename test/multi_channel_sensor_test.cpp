@@ -0,0 +1,151 @@
+﻿// <copyright file="multi_channel_sensor_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    /// <summary>
+    /// A sensor with a voltage, a current and a power channel, which counts
+    /// its reads.
+    /// </summary>
+    class three_channel_sensor final : public multi_channel_sensor {
+
+    public:
+
+        std::atomic<int> reads;
+
+        inline three_channel_sensor(void) : reads(0) { }
+
+        ~three_channel_sensor(void) {
+            this->sample_channels(nullptr);
+        }
+
+        sensor_channel channel(_In_ const std::size_t index) const override {
+            switch (index) {
+                case 0: return sensor_channel(L"test/voltage", L"V", measurement_quantity::voltage);
+                case 1: return sensor_channel(L"test/current", L"A", measurement_quantity::current);
+                case 2: return sensor_channel(L"test/power", L"W", measurement_quantity::power);
+                default: throw std::out_of_range("index");
+            }
+        }
+
+        std::size_t channels(void) const noexcept override {
+            return 3;
+        }
+
+        const wchar_t *name(void) const noexcept override {
+            return L"test";
+        }
+
+        operator bool(void) const noexcept override {
+            return true;
+        }
+
+    protected:
+
+        timestamp_type sample_channels_sync(_Out_writes_(channels()) value_type *dst,
+                _In_ const timestamp_resolution resolution) const override {
+            auto that = const_cast<three_channel_sensor *>(this);
+            const auto retval = ++that->reads;
+            dst[0] = 12.0f;
+            dst[1] = 2.0f;
+            dst[2] = 24.0f;
+            return retval;
+        }
+    };
+
+    TEST_CLASS(multi_channel_sensor_test) {
+
+    public:
+
+        TEST_METHOD(test_channels) {
+            three_channel_sensor sensor;
+            Assert::AreEqual(std::size_t(3), sensor.channels(), L"Number of channels", LINE_INFO());
+            Assert::AreEqual(L"test/current", sensor.channel(1).name(), L"Name of channel", LINE_INFO());
+            Assert::AreEqual(L"A", sensor.channel(1).unit(), L"Unit of channel", LINE_INFO());
+            Assert::IsTrue(measurement_quantity::current == sensor.channel(1).quantity(), L"Quantity of channel", LINE_INFO());
+        }
+
+        TEST_METHOD(test_sample_channels) {
+            three_channel_sensor sensor;
+            multi_channel_sensor::value_type values[3];
+
+            auto timestamp = sensor.sample_channels(values, 3);
+            Assert::AreEqual(multi_channel_sensor::timestamp_type(1), timestamp, L"One read", LINE_INFO());
+            Assert::AreEqual(12.0f, values[0], L"Voltage", LINE_INFO());
+            Assert::AreEqual(2.0f, values[1], L"Current", LINE_INFO());
+            Assert::AreEqual(24.0f, values[2], L"Power", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([&sensor, &values](void) {
+                sensor.sample_channels(values, 2);
+            }, L"Buffer too small", LINE_INFO());
+
+            auto sample = sensor.sample();
+            Assert::AreEqual(L"test", sample.sensor(), L"Sample of first channel named after sensor", LINE_INFO());
+            Assert::AreEqual(12.0f, sample.voltage(), L"Sample of first channel", LINE_INFO());
+        }
+
+        TEST_METHOD(test_sample_batch) {
+            typedef std::vector<std::pair<std::wstring, measurement_data>> list_type;
+            three_channel_sensor sensor;
+            list_type samples;
+            std::mutex lock;
+            auto context = std::make_pair(&samples, &lock);
+
+            sensor.sample_batch([](const wchar_t *name, const measurement_data *s, const std::size_t cnt, void *context) {
+                auto c = static_cast<std::pair<list_type *, std::mutex *> *>(context);
+                std::lock_guard<std::mutex> l(*c->second);
+                for (std::size_t i = 0; i < cnt; ++i) {
+                    c->first->emplace_back(name, s[i]);
+                }
+            }, 1000, &context);
+
+            Assert::ExpectException<std::logic_error>([&sensor](void) {
+                sensor.sample_channels([](const multi_channel_sensor&, const multi_channel_sensor::timestamp_type *, const multi_channel_sensor::value_type *, const std::size_t, void *) { }, 1000);
+            }, L"Sampling twice", LINE_INFO());
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            sensor.sample_batch(nullptr);
+
+            std::lock_guard<std::mutex> l(lock);
+            Assert::IsTrue(samples.size() >= 3, L"At least one read", LINE_INFO());
+            Assert::AreEqual(std::size_t(sensor.reads.load()) * 3, samples.size(), L"One sample per channel and read", LINE_INFO());
+            Assert::AreEqual(L"test/voltage", samples[0].first.c_str(), L"Voltage channel", LINE_INFO());
+            Assert::AreEqual(L"test/current", samples[1].first.c_str(), L"Current channel", LINE_INFO());
+            Assert::AreEqual(L"test/power", samples[2].first.c_str(), L"Power channel", LINE_INFO());
+            Assert::AreEqual(samples[0].second.timestamp(), samples[2].second.timestamp(), L"Shared timestamp", LINE_INFO());
+            Assert::AreEqual(2.0f, samples[1].second.current(), L"Current value", LINE_INFO());
+            Assert::AreEqual(24.0f, samples[2].second.power(), L"Power value", LINE_INFO());
+        }
+
+        TEST_METHOD(test_sample_channels_async) {
+            three_channel_sensor sensor;
+            std::atomic<int> rows(0);
+
+            sensor.sample_channels([](const multi_channel_sensor& source, const multi_channel_sensor::timestamp_type *timestamps, const multi_channel_sensor::value_type *values, const std::size_t cnt, void *context) {
+                auto rows = static_cast<std::atomic<int> *>(context);
+                if ((source.channels() == 3) && (values[2] == 24.0f) && (timestamps[0] > 0)) {
+                    *rows += static_cast<int>(cnt);
+                }
+            }, 1000, &rows);
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            sensor.sample_channels(nullptr);
+
+            Assert::IsTrue(rows.load() > 0, L"Rows delivered", LINE_INFO());
+            Assert::AreEqual(sensor.reads.load(), rows.load(), L"One row per read", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,118 @@
+﻿// <copyright file="network_output_buffer_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(network_output_buffer_test) {
+
+    public:
+
+#if defined(_WIN32)
+        TEST_METHOD_INITIALIZE(initialise) {
+            WSADATA wsa_data = { };
+            ::WSAStartup(MAKEWORD(2, 2), &wsa_data);
+        }
+
+        TEST_METHOD_CLEANUP(cleanup) {
+            ::WSACleanup();
+        }
+#endif /* defined(_WIN32) */
+
+        TEST_METHOD(test_invalid) {
+            detail::network_output_buffer buffer;
+            Assert::IsFalse(buffer.is_open(), L"Not open", LINE_INFO());
+            Assert::IsFalse(buffer.connected(), L"Not connected", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([&buffer](void) {
+                buffer.open(nullptr);
+            }, L"Null address", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&buffer](void) {
+                buffer.open(L"localhost");
+            }, L"No port", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&buffer](void) {
+                buffer.open(L"localhost:1234", 0);
+            }, L"Empty queue", LINE_INFO());
+        }
+
+        TEST_METHOD(test_stream) {
+            auto listener = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            sockaddr_in addr = { };
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            Assert::AreEqual(0, ::bind(listener, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)), L"Bind listener", LINE_INFO());
+            Assert::AreEqual(0, ::listen(listener, 1), L"Listen", LINE_INFO());
+
+            socklen_t addr_length = sizeof(addr);
+            ::getsockname(listener, reinterpret_cast<sockaddr *>(&addr), &addr_length);
+            const auto address = L"127.0.0.1:" + std::to_wstring(ntohs(addr.sin_port));
+
+            // Records are a 32-bit type and a 64-bit size followed by the
+            // payload, which is what the buffer expects after the first batch.
+            std::string expected("header");
+            {
+                const std::uint32_t type = 2;
+                const std::uint64_t size = 3;
+                std::string record(sizeof(type) + sizeof(size), '\0');
+                ::memcpy(&record[0], &type, sizeof(type));
+                ::memcpy(&record[sizeof(type)], &size, sizeof(size));
+                record += "abc";
+                expected += record;
+            }
+
+            std::string received;
+            std::thread receiver([listener, &received](void) {
+                auto peer = ::accept(listener, nullptr, nullptr);
+                char data[64];
+                int cnt = 0;
+                while ((cnt = ::recv(peer, data, sizeof(data), 0)) > 0) {
+                    received.append(data, cnt);
+                }
+#if defined(_WIN32)
+                ::closesocket(peer);
+#else /* defined(_WIN32) */
+                ::close(peer);
+#endif /* defined(_WIN32) */
+            });
+
+            {
+                detail::network_output_buffer buffer;
+                buffer.open(address.c_str());
+                Assert::IsTrue(buffer.is_open(), L"Open", LINE_INFO());
+                Assert::IsTrue(buffer.connected(), L"Connected", LINE_INFO());
+
+                std::ostream stream(&buffer);
+                stream.write(expected.data(), 6);
+                stream.flush();
+                stream.write(expected.data() + 6, expected.size() - 6);
+                stream.flush();
+
+                buffer.close();
+                Assert::IsFalse(buffer.is_open(), L"Closed", LINE_INFO());
+                Assert::AreEqual(std::uint64_t(0), buffer.dropped(), L"Nothing dropped", LINE_INFO());
+            }
+
+            receiver.join();
+#if defined(_WIN32)
+            ::closesocket(listener);
+#else /* defined(_WIN32) */
+            ::close(listener);
+#endif /* defined(_WIN32) */
+
+            Assert::IsTrue(expected == received, L"All bytes received in order", LINE_INFO());
+        }
+
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,68 @@
+﻿// <copyright file="oscilloscope_acquisition_plan_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(oscilloscope_acquisition_plan_test) {
+
+    public:
+
+        TEST_METHOD(test_ctor) {
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                oscilloscope_acquisition_plan p(0.0f, 1000.0f);
+            }, L"Invalid duration", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                oscilloscope_acquisition_plan p(1.0f, -1.0f);
+            }, L"Invalid sample rate", LINE_INFO());
+        }
+
+        TEST_METHOD(test_plan) {
+            {
+                oscilloscope_acquisition_plan p(0.1f, 100000.0f);
+                Assert::AreEqual(0.01f, p.time_scale(), 1e-6f, L"Exact time scale", LINE_INFO());
+                Assert::AreEqual(0.1f, p.time_range(), 1e-6f, L"Exact time range", LINE_INFO());
+                Assert::AreEqual(10000u, p.points(), L"Exact record length", LINE_INFO());
+                Assert::AreEqual(100000.0f, p.sample_rate(), 1.0f, L"Effective sample rate", LINE_INFO());
+                Assert::IsTrue(p.satisfied(), L"Rate satisfied", LINE_INFO());
+                Assert::IsTrue(p.decimation_mode() == oscilloscope_decimation_mode::high_resolution, L"Decimation by averaging", LINE_INFO());
+            }
+
+            {
+                oscilloscope_acquisition_plan p(0.15f, 120000.0f, true);
+                Assert::AreEqual(0.02f, p.time_scale(), 1e-6f, L"Time scale rounded up", LINE_INFO());
+                Assert::AreEqual(50000u, p.points(), L"Record length rounded up", LINE_INFO());
+                Assert::AreEqual(250000.0f, p.sample_rate(), 1.0f, L"Effective sample rate", LINE_INFO());
+                Assert::IsTrue(p.decimation_mode() == oscilloscope_decimation_mode::peak_detect, L"Peak detection", LINE_INFO());
+            }
+
+            {
+                oscilloscope_acquisition_plan p(1e-5f, 1e10f);
+                Assert::AreEqual(1e-6f, p.time_scale(), 1e-12f, L"Short time scale", LINE_INFO());
+                Assert::AreEqual(20000u, p.points(), L"Points limited by converter", LINE_INFO());
+                Assert::IsFalse(p.satisfied(), L"Rate beyond converter", LINE_INFO());
+                Assert::IsTrue(p.decimation_mode() == oscilloscope_decimation_mode::sample, L"No decimation", LINE_INFO());
+            }
+
+            {
+                oscilloscope_acquisition_plan p(10.0f, 1e7f);
+                Assert::AreEqual(oscilloscope_acquisition_plan::max_points, p.points(), L"Longest record", LINE_INFO());
+                Assert::IsFalse(p.satisfied(), L"Record too short", LINE_INFO());
+            }
+        }
+
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -98,6 +98,33 @@ namespace test {
             }
         }
 
+        TEST_METHOD(test_channel_power) {
+            oscilloscope_sensor_definition d(L"Horst", 1, 2);
+            Assert::AreEqual(std::uint32_t(0), d.channel_power(), L"Power computed on host by default", LINE_INFO());
+            Assert::IsFalse(d.raw_channels(), L"No raw channels by default", LINE_INFO());
+
+            d.channel_power(3).raw_channels(true);
+            Assert::AreEqual(std::uint32_t(3), d.channel_power(), L"Maths channel for power", LINE_INFO());
+            Assert::IsTrue(d.raw_channels(), L"Raw channels requested", LINE_INFO());
+
+            oscilloscope_sensor_definition dd(L"Hugo", 3, 4);
+            dd = d;
+            Assert::AreEqual(d.channel_power(), dd.channel_power(), L"Maths channel copied", LINE_INFO());
+            Assert::AreEqual(d.raw_channels(), dd.raw_channels(), L"Raw channels copied", LINE_INFO());
+        }
+
+        TEST_METHOD(test_software_trigger) {
+            oscilloscope_sensor_definition d(L"Horst", 1, 2);
+            Assert::IsFalse(d.software_trigger(), L"Instrument trigger by default", LINE_INFO());
+
+            d.software_trigger(true);
+            Assert::IsTrue(d.software_trigger(), L"Software trigger enabled", LINE_INFO());
+
+            oscilloscope_sensor_definition dd(L"Hugo", 3, 4);
+            dd = d;
+            Assert::IsTrue(dd.software_trigger(), L"Software trigger copied", LINE_INFO());
+        }
+
     };
 } /* namespace test */
 } /* namespace power_overwhelming */
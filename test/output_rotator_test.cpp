@@ -0,0 +1,79 @@
+﻿// <copyright file="output_rotator_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(output_rotator_test) {
+
+    public:
+
+        TEST_METHOD(test_segment_path) {
+            typedef detail::output_rotator rotator;
+            Assert::AreEqual(L"output.csv", rotator::segment_path(L"output.csv", 0).c_str(), L"First segment", LINE_INFO());
+            Assert::AreEqual(L"output.0001.csv", rotator::segment_path(L"output.csv", 1).c_str(), L"Second segment", LINE_INFO());
+            Assert::AreEqual(L"output.12345.bin", rotator::segment_path(L"output.bin", 12345).c_str(), L"Many segments", LINE_INFO());
+            Assert::AreEqual(L"dir.d/output.0002", rotator::segment_path(L"dir.d/output", 2).c_str(), L"Dot in directory", LINE_INFO());
+            Assert::AreEqual(L"dir\\.hidden.0003", rotator::segment_path(L"dir\\.hidden", 3).c_str(), L"Hidden file", LINE_INFO());
+        }
+
+        TEST_METHOD(test_due) {
+            typedef detail::output_rotator::clock_type clock_type;
+            const auto now = clock_type::now();
+            detail::output_rotator rotator;
+            Assert::IsFalse(rotator.enabled(), L"Disabled by default", LINE_INFO());
+
+            rotator.configure(L"output.bin", 100, std::chrono::seconds(10), now);
+            Assert::IsTrue(rotator.enabled(), L"Enabled", LINE_INFO());
+            Assert::AreEqual(std::size_t(1), rotator.segments(), L"One segment", LINE_INFO());
+            Assert::IsFalse(rotator.due(99, now), L"Below size", LINE_INFO());
+            Assert::IsTrue(rotator.due(100, now), L"Size reached", LINE_INFO());
+            Assert::IsTrue(rotator.due(0, now + std::chrono::seconds(10)), L"Interval reached", LINE_INFO());
+
+            rotator.defer(100, now);
+            Assert::IsFalse(rotator.due(150, now), L"Deferred size", LINE_INFO());
+            Assert::IsTrue(rotator.due(200, now), L"Deferred size reached", LINE_INFO());
+
+            Assert::AreEqual(L"output.0001.bin", rotator.next_path().c_str(), L"Next path", LINE_INFO());
+            rotator.advance(now + std::chrono::seconds(5));
+            Assert::AreEqual(std::size_t(2), rotator.segments(), L"Two segments", LINE_INFO());
+            Assert::AreEqual(L"output.0002.bin", rotator.next_path().c_str(), L"Path after advance", LINE_INFO());
+            Assert::IsFalse(rotator.due(99, now + std::chrono::seconds(10)), L"Interval restarted", LINE_INFO());
+            Assert::IsTrue(rotator.due(99, now + std::chrono::seconds(15)), L"Restarted interval reached", LINE_INFO());
+        }
+
+        TEST_METHOD(test_finalise) {
+            {
+                detail::output_rotator rotator;
+                std::unique_ptr<detail::csv_output_writer> writer(new detail::csv_output_writer());
+                writer->open(L"output_rotator_test.csv");
+                writer->header();
+                Assert::IsTrue(writer->written() > 0, L"Header buffered", LINE_INFO());
+
+                rotator.finalise(std::move(writer));
+                Assert::IsTrue(writer == nullptr, L"Ownership transferred", LINE_INFO());
+
+                rotator.post([](void) { throw std::runtime_error("failed"); });
+                rotator.wait();
+                Assert::AreEqual(std::size_t(1), rotator.failures(), L"Failure counted", LINE_INFO());
+            }
+
+            std::ifstream file("output_rotator_test.csv");
+            std::string line;
+            std::getline(file, line);
+            Assert::IsFalse(line.empty(), L"Segment finalised", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,77 @@
+﻿// <copyright file="overhead_estimator_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(overhead_estimator_test) {
+
+    public:
+
+        TEST_METHOD(test_attribute) {
+            typedef detail::overhead_estimator estimator;
+            Assert::AreEqual(0.0f, estimator::attribute(100.0f, 10, 0), L"Idle system", LINE_INFO());
+            Assert::AreEqual(25.0f, estimator::attribute(100.0f, 1, 4), L"Quarter of busy time", LINE_INFO());
+            Assert::AreEqual(100.0f, estimator::attribute(100.0f, 8, 4), L"Share is clamped", LINE_INFO());
+        }
+
+        TEST_METHOD(test_sample) {
+            detail::overhead_estimator estimator;
+            measurement::value_type power = -1.0f;
+
+            estimator.reset();
+            Assert::IsFalse(estimator.has_packages(), L"No package", LINE_INFO());
+            Assert::IsFalse(estimator.sample(power), L"Nothing to estimate", LINE_INFO());
+
+            estimator.add_package(L"package");
+            Assert::IsTrue(estimator.has_packages(), L"Package registered", LINE_INFO());
+            Assert::IsFalse(estimator.sample(power), L"Package not sampled", LINE_INFO());
+
+            estimator.push(measurement(L"other", 0, 1000.0f));
+            estimator.push(measurement(L"package", 0, 10.0f));
+            estimator.push(measurement(L"package", 1, 30.0f));
+            Assert::IsTrue(estimator.sample(power), L"Package sampled", LINE_INFO());
+            Assert::IsTrue(power >= 0.0f, L"Non-negative overhead", LINE_INFO());
+            Assert::IsTrue(power <= 20.0f, L"Overhead bounded by average package power", LINE_INFO());
+            Assert::IsFalse(estimator.sample(power), L"New period", LINE_INFO());
+
+            estimator.reset();
+            Assert::IsFalse(estimator.has_packages(), L"Reset removes packages", LINE_INFO());
+        }
+
+        TEST_METHOD(test_library_cpu_time) {
+            const auto before = get_library_cpu_time();
+            auto found = false;
+
+            std::thread thread([&found](void) {
+                detail::enter_library_thread("PwrOwg Test Thread");
+                const auto begin = std::chrono::steady_clock::now();
+                while (std::chrono::steady_clock::now() - begin < std::chrono::milliseconds(50)) { }
+
+                std::vector<const char *> names(get_library_thread_cpu_times(nullptr, nullptr, 0));
+                std::vector<std::uint64_t> times(names.size());
+                get_library_thread_cpu_times(names.data(), times.data(), names.size());
+                for (auto n : names) {
+                    found |= (std::strcmp(n, "PwrOwg Test Thread") == 0);
+                }
+            });
+            thread.join();
+            Assert::IsTrue(found, L"Running thread is listed", LINE_INFO());
+
+            const auto after = get_library_cpu_time();
+            Assert::IsTrue(after > before, L"Exited thread is accounted for", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,71 @@
+﻿// <copyright file="overhead_experiment_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(overhead_experiment_test) {
+
+    public:
+
+        TEST_METHOD(test_windows) {
+            detail::overhead_experiment experiment;
+            Assert::IsFalse(experiment.running(), L"Not running", LINE_INFO());
+            Assert::ExpectException<std::logic_error>([&experiment](void) { experiment.toggle(0); }, L"Toggle before begin", LINE_INFO());
+
+            experiment.begin(0, 1000.0);
+            Assert::IsTrue(experiment.running(), L"Running", LINE_INFO());
+            Assert::IsTrue(experiment.sampling(), L"Begins sampling", LINE_INFO());
+
+            experiment.progress(100);
+            Assert::IsFalse(experiment.toggle(1000), L"Reference window", LINE_INFO());
+            experiment.progress(150);
+            experiment.progress(50);
+            Assert::IsTrue(experiment.toggle(2000), L"Sampling window", LINE_INFO());
+            experiment.progress(100);
+            Assert::IsFalse(experiment.toggle(3000), L"Reference window", LINE_INFO());
+            experiment.progress(200);
+            experiment.end(4000);
+            experiment.end(5000);
+            Assert::IsFalse(experiment.running(), L"Stopped", LINE_INFO());
+
+            const auto& windows = experiment.windows();
+            Assert::AreEqual(std::size_t(4), windows.size(), L"Four windows", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(200), windows[1].progress, L"Progress of window", LINE_INFO());
+            Assert::AreEqual(1.0, windows[1].duration, L"Duration of window", LINE_INFO());
+            Assert::IsFalse(windows[1].sampling, L"Kind of window", LINE_INFO());
+
+            const auto summary = experiment.summary();
+            Assert::AreEqual(std::size_t(2), summary.windows_sampling, L"Sampling windows", LINE_INFO());
+            Assert::AreEqual(std::size_t(2), summary.windows_reference, L"Reference windows", LINE_INFO());
+            Assert::AreEqual(100.0, summary.rate_sampling, 0.0001, L"Sampling rate", LINE_INFO());
+            Assert::AreEqual(200.0, summary.rate_reference, 0.0001, L"Reference rate", LINE_INFO());
+            Assert::AreEqual(0.5, summary.overhead, 0.0001, L"Overhead", LINE_INFO());
+            Assert::AreEqual(0.0, summary.overhead_error, 0.0001, L"No variance", LINE_INFO());
+        }
+
+        TEST_METHOD(test_single_window) {
+            detail::overhead_experiment experiment;
+            experiment.begin(0, 1000.0);
+            experiment.progress(10);
+            experiment.end(1000);
+
+            const auto summary = experiment.summary();
+            Assert::AreEqual(std::size_t(1), summary.windows_sampling, L"Sampling windows", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), summary.windows_reference, L"Reference windows", LINE_INFO());
+            Assert::IsTrue(std::isnan(summary.overhead), L"No overhead without reference", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -5,38 +5,170 @@
 
 #pragma once
 
+#if defined(_WIN32)
+#include <WinSock2.h>
+#include <WS2tcpip.h>
+#else /* defined(_WIN32) */
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif /* defined(_WIN32) */
+
+#include <atomic>
 #include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <random>
 #include <regex>
 #include <sstream>
 #include <thread>
 
 #include <power_overwhelming/adl_sensor.h>
+#include <power_overwhelming/amdgpu_sensor.h>
+#include <power_overwhelming/binary_output_reader.h>
+#include <power_overwhelming/binary_output_to_csv.h>
 #include <power_overwhelming/blob.h>
+#include <power_overwhelming/c_api.h>
 #include <power_overwhelming/collector.h>
+#include <power_overwhelming/collector_agent.h>
+#include <power_overwhelming/collector_client.h>
+#include <power_overwhelming/collector_coordinator.h>
+#include <power_overwhelming/collector_daemon.h>
 #include <power_overwhelming/convert_string.h>
 #include <power_overwhelming/cpu_affinity.h>
 #include <power_overwhelming/cpu_info.h>
+#include <power_overwhelming/dcgm_sensor.h>
+#include <power_overwhelming/device_catalogue.h>
 #include <power_overwhelming/emi_sensor.h>
+#include <power_overwhelming/energy_meter.h>
+#include <power_overwhelming/enumerate_sensors.h>
 #include <power_overwhelming/for_each_rapl_domain.h>
+#include <power_overwhelming/gpu_timestamp_correlator.h>
+#include <power_overwhelming/graphics_device.h>
+#include <power_overwhelming/latency_histogram.h>
+#include <power_overwhelming/level_zero_sensor.h>
+#include <power_overwhelming/latest_measurement.h>
+#include <power_overwhelming/library_threads.h>
+#include <power_overwhelming/marker_channel.h>
 #include <power_overwhelming/event.h>
 #include <power_overwhelming/computer_name.h>
 #include <power_overwhelming/csv_iomanip.h>
 #include <power_overwhelming/measurement.h>
+#include <power_overwhelming/measurement_batch.h>
 #include <power_overwhelming/measurement_data.h>
+#include <power_overwhelming/metrics_exporter.h>
+#include <power_overwhelming/multi_channel_sensor.h>
 #include <power_overwhelming/nvml_sensor.h>
+#include <power_overwhelming/oscilloscope_acquisition_plan.h>
 #include <power_overwhelming/oscilloscope_channel.h>
 #include <power_overwhelming/oscilloscope_sensor_definition.h>
+#include <power_overwhelming/perf_rapl_sensor.h>
+#include <power_overwhelming/power_estimate.h>
+#include <power_overwhelming/power_governor.h>
+#include <power_overwhelming/process_energy.h>
 #include <power_overwhelming/rapl_domain.h>
+#include <power_overwhelming/replay_sensor.h>
+#include <power_overwhelming/sampler_statistics.h>
+#include <power_overwhelming/sample_filter.h>
+#include <power_overwhelming/sensor_channel.h>
+#include <power_overwhelming/sensor_filter.h>
+#include <power_overwhelming/sensor_stream.h>
+#include <power_overwhelming/shared_measurement_reader.h>
+#include <power_overwhelming/synthetic_sensor.h>
+#include <power_overwhelming/sysfs_sensor.h>
+#include <power_overwhelming/tinkerforge_sensor.h>
 #include <power_overwhelming/tinkerforge_sensor_definition.h>
 
+#include <adaptive_interval.h>
 #include <adl_exception.h>
+#include <amdgpu_sensor_impl.h>
+#include <arrow_output.h>
+#include <async_output_buffer.h>
+#include <batch_kernels.h>
+#include <binary_output.h>
+#include <c_api_impl.h>
+#include <cached_discovery.h>
+#include <clock_settle_detector.h>
+#include <column_codec.h>
+#include <compiled_config.h>
+#include <csv_output.h>
+#include <delta_filter.h>
+#include <derived_evaluator.h>
+#include <derived_expression.h>
+#include <filter_stage.h>
 #include <emi_device.h>
+#include <grid_resampler.h>
+#include <hmc8015_log.h>
+#include <hmc8015_sampler.h>
+#include <ieee488_block.h>
+#include <instrument_clock.h>
+#include <library_thread.h>
+#include <io_uring_reader.h>
 #include <io_util.h>
+#include <kernel_energy.h>
+#include <latency_histogram_codec.h>
+#include <level_zero_device.h>
+#include <level_zero_exception.h>
+#include <machine_topology.h>
+#include <marker_channel_listener.h>
+#include <mapped_output_buffer.h>
+#include <memory_lock.h>
 #include <on_exit.h>
+#include <output_rotator.h>
+#include <overhead_estimator.h>
+#include <overhead_experiment.h>
+#include <parse_real.h>
+#include <perf_rapl_group.h>
+#include <pci_location.h>
+#include <phase_energy.h>
+#include <phase_quantiles.h>
+#include <periodic_clock.h>
+#include <periodic_timer.h>
+#include <power_cap_controller.h>
+#include <power_model.h>
+#include <process_energy_integrator.h>
+#include <quantile_sketch.h>
+#include <rtx_sampler.h>
+#include <sample_aggregator.h>
+#include <sampler_scheduler.h>
+#include <sampling_budget.h>
+#include <sensor_capability.h>
+#include <sensor_group.h>
+#include <sequence_tracker.h>
+#include <step_response.h>
+#include <sysfs_batch.h>
+#include <sysfs_sensor_impl.h>
 #include <timestamp.h>
+#include <timestamp_aligner.h>
+#include <trace_output.h>
+#include <trigger_capture.h>
+#include <tsc_clock.h>
+#include <update_interval_probe.h>
+#include <visa_discovery.h>
+#include <visa_instrument_impl.h>
 #include <msr_magic.h>
+#include <msr_sensor_impl.h>
+#include <network_output_buffer.h>
 #include <nvml_exception.h>
 #include <nvml_scope.h>
+#include <scpi_analyser_descriptor.h>
+#include <scpi_batch.h>
+#include <scpi_response.h>
+#include <scpi_socket.h>
 #include <sensor_desc.h>
 #include <setup_api.h>
+#include <shared_measurement_writer.h>
+#include <shared_memory_segment.h>
+#include <spsc_ring.h>
+#include <start_barrier.h>
 #include <string_functions.h>
+#include <subscriber_ring.h>
+#include <waveform_archive.h>
+#include <waveform_kernels.h>
+#include <wide_csv_rows.h>
+#include <writer_shard.h>
@@ -0,0 +1,60 @@
+﻿// <copyright file="pci_location_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(pci_location_test) {
+
+    public:
+
+        TEST_METHOD(test_parse_bus_id) {
+            detail::pci_location location;
+
+            Assert::IsTrue(detail::parse_pci_bus_id(location, "00000000:0A:1F.3"), L"Full bus ID", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(0x0a), location.bus, L"Bus", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(0x1f), location.device, L"Device", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(3), location.function, L"Function", LINE_INFO());
+
+            Assert::IsTrue(detail::parse_pci_bus_id(location, "0000:65:00"), L"Without function", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(0x65), location.bus, L"Bus", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(0), location.device, L"Device", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(0), location.function, L"Function", LINE_INFO());
+
+            Assert::IsFalse(detail::parse_pci_bus_id(location, nullptr), L"nullptr", LINE_INFO());
+            Assert::IsFalse(detail::parse_pci_bus_id(location, "GPU-1234"), L"UUID", LINE_INFO());
+        }
+
+        TEST_METHOD(test_equality) {
+            detail::pci_location lhs { 1, 0, 0 };
+            detail::pci_location rhs { 1, 0, 0 };
+            Assert::IsTrue(lhs == rhs, L"Same location", LINE_INFO());
+
+            rhs.function = 1;
+            Assert::IsTrue(lhs != rhs, L"Different function", LINE_INFO());
+        }
+
+        TEST_METHOD(test_adapters) {
+            std::vector<graphics_device> adapters(graphics_device::adapters(nullptr, 0));
+            graphics_device::adapters(adapters.data(), adapters.size());
+
+            for (auto& a : adapters) {
+                Assert::IsTrue(bool(a), L"Adapter is valid", LINE_INFO());
+                Assert::IsNull(static_cast<graphics_device::device_type *>(a), L"No device created", LINE_INFO());
+                Assert::AreNotEqual(graphics_device::luid_type(0), a.luid(), L"LUID", LINE_INFO());
+            }
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
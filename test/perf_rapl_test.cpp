@@ -0,0 +1,47 @@
+﻿// <copyright file="perf_rapl_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(perf_rapl_test) {
+
+    public:
+
+        TEST_METHOD(test_for_all) {
+            std::vector<perf_rapl_sensor> sensors(perf_rapl_sensor::for_all(nullptr, 0));
+            perf_rapl_sensor::for_all(sensors.data(), sensors.size());
+            Assert::AreEqual(std::size_t(0), sensors.size(), L"perf is not supported on Windows", LINE_INFO());
+        }
+
+        TEST_METHOD(test_for_core) {
+            Assert::ExpectException<std::system_error>([](void) {
+                perf_rapl_sensor::for_core(0, rapl_domain::package);
+            }, L"perf is not supported on Windows", LINE_INFO());
+        }
+
+        TEST_METHOD(test_event_name) {
+            for_each_rapl_domain([](const rapl_domain domain) {
+                Assert::IsNotNull(detail::perf_rapl_group::event_name(domain), L"All domains are mapped", LINE_INFO());
+                return true;
+            });
+
+            Assert::AreEqual("energy-pkg", detail::perf_rapl_group::event_name(rapl_domain::package), L"Package", LINE_INFO());
+            Assert::AreEqual("energy-cores", detail::perf_rapl_group::event_name(rapl_domain::pp0), L"PP0", LINE_INFO());
+            Assert::AreEqual("energy-gpu", detail::perf_rapl_group::event_name(rapl_domain::pp1), L"PP1", LINE_INFO());
+            Assert::AreEqual("energy-ram", detail::perf_rapl_group::event_name(rapl_domain::dram), L"DRAM", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,93 @@
+﻿// <copyright file="periodic_clock_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(periodic_clock_test) {
+
+    public:
+
+        TEST_METHOD(test_jitter) {
+            // 10 ms period with up to 5 ms of delivery jitter in 100 ns units.
+            const timestamp_type origin = 1000000000;
+            const timestamp_type period = 100000;
+            std::mt19937 rng(42);
+            std::uniform_int_distribution<timestamp_type> jitter(0, 50000);
+
+            detail::periodic_clock clock;
+            Assert::IsFalse(clock.synchronised(), L"Not synchronised initially", LINE_INFO());
+
+            timestamp_type max_error = 0;
+            timestamp_type last = 0;
+            for (detail::periodic_clock::sequence_type s = 0; s < 2000; ++s) {
+                const auto expected = origin + s * period;
+                const auto actual = clock.push(s, expected + jitter(rng));
+                Assert::IsTrue(actual >= last, L"Monotonic", LINE_INFO());
+                last = actual;
+
+                if (s >= 500) {
+                    const auto error = std::abs(actual - expected);
+                    max_error = (std::max)(max_error, error);
+                }
+            }
+
+            Assert::IsTrue(clock.synchronised(), L"Synchronised", LINE_INFO());
+            Assert::IsTrue(std::abs(clock.period() - period) < 0.01 * period, L"Period estimated", LINE_INFO());
+            Assert::IsTrue(max_error < 10000, L"Jitter removed", LINE_INFO());
+        }
+
+        TEST_METHOD(test_gaps) {
+            const timestamp_type period = 100000;
+
+            detail::periodic_clock clock;
+            for (detail::periodic_clock::sequence_type s = 0; s < 200; s += 3) {
+                clock.push(s, s * period + (s % 7) * 1000);
+            }
+
+            Assert::IsTrue(clock.synchronised(), L"Synchronised", LINE_INFO());
+            Assert::IsTrue(std::abs(clock.period() - period) < 0.01 * period, L"Period across gaps", LINE_INFO());
+
+            const auto actual = clock.push(300, 300 * period);
+            Assert::IsTrue(std::abs(actual - 300 * period) < 10000, L"Gap bridged", LINE_INFO());
+        }
+
+        TEST_METHOD(test_restart) {
+            const timestamp_type period = 100000;
+
+            detail::periodic_clock clock;
+            for (detail::periodic_clock::sequence_type s = 0; s < 100; ++s) {
+                clock.push(s, s * period);
+            }
+            Assert::IsTrue(clock.synchronised(), L"Synchronised", LINE_INFO());
+
+            // A sequence starting over must not be fitted to the old model.
+            const timestamp_type arrival = 1000 * period;
+            Assert::AreEqual(arrival, clock.push(0, arrival), L"Raw time after restart", LINE_INFO());
+            Assert::IsFalse(clock.synchronised(), L"Started over", LINE_INFO());
+
+            // So must a sample far off the model.
+            for (detail::periodic_clock::sequence_type s = 1; s < 100; ++s) {
+                clock.push(s, arrival + s * period);
+            }
+            Assert::IsTrue(clock.synchronised(), L"Synchronised again", LINE_INFO());
+            const timestamp_type late = arrival + 200 * period;
+            Assert::AreEqual(late, clock.push(100, late), L"Raw time after jump", LINE_INFO());
+
+            clock.reset();
+            Assert::IsFalse(clock.synchronised(), L"Reset", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,57 @@
+﻿// <copyright file="periodic_timer_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(periodic_timer_test) {
+
+    public:
+
+        TEST_METHOD(test_no_drift) {
+            typedef detail::periodic_timer::clock_type clock_type;
+            const auto interval = std::chrono::milliseconds(10);
+            const auto cnt = 20;
+
+            detail::periodic_timer timer;
+            timer.start(interval);
+            Assert::AreEqual(std::uint64_t(0), timer.missed(), L"Nothing missed on start", LINE_INFO());
+
+            const auto begin = clock_type::now();
+            for (int i = 0; i < cnt; ++i) {
+                // Emulate some work, which must not shift the deadlines.
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                timer.wait();
+            }
+            const auto end = clock_type::now();
+
+            Assert::IsTrue(end - begin >= cnt * interval, L"Deadlines met", LINE_INFO());
+            Assert::IsTrue(end - begin < (cnt + 5) * interval, L"Work does not accumulate", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(0), timer.missed(), L"Nothing missed", LINE_INFO());
+        }
+
+        TEST_METHOD(test_missed) {
+            detail::periodic_timer timer;
+            timer.start(std::chrono::milliseconds(1));
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            Assert::IsFalse(timer.wait(), L"Deadline passed", LINE_INFO());
+            Assert::IsTrue(timer.missed() >= 10, L"Missed deadlines counted", LINE_INFO());
+
+            timer.start(std::chrono::milliseconds(1));
+            Assert::AreEqual(std::uint64_t(0), timer.missed(), L"Reset on start", LINE_INFO());
+        }
+
+    };
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,106 @@
+﻿// <copyright file="phase_energy_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(phase_energy_test) {
+
+    public:
+
+        TEST_METHOD(test_resolution) {
+            Assert::ExpectException<std::invalid_argument>([](void) { detail::phase_energy_integrator integrator(0.0); }, L"Zero resolution", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) { detail::phase_energy_integrator integrator(-1.0); }, L"Negative resolution", LINE_INFO());
+
+            detail::phase_energy_integrator integrator;
+            Assert::IsTrue(integrator.summary().empty(), L"No phases", LINE_INFO());
+        }
+
+        TEST_METHOD(test_trapezoid) {
+            detail::phase_energy_integrator integrator(1000.0);
+
+            // Ramp from 1 W to 11 W within 1 s, which is 6 J.
+            for (measurement::timestamp_type t = 0; t <= 1000; t += 100) {
+                integrator.push(measurement(L"sensor", t, 1.0f + t / 100.0f), 0, 0, 0);
+            }
+
+            // Samples that are out of order are ignored.
+            integrator.push(measurement(L"sensor", 500, 100.0f), 0, 0, 0);
+
+            auto summary = integrator.summary();
+            Assert::AreEqual(std::size_t(1), summary.size(), L"One phase", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(11), summary[0].samples, L"Ordered samples", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(0), summary[0].begin, L"First sample", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(1000), summary[0].end, L"Last sample", LINE_INFO());
+            Assert::IsTrue(std::abs(summary[0].energy - 6.0) < 1e-6, L"Trapezoid", LINE_INFO());
+        }
+
+        TEST_METHOD(test_phases) {
+            detail::phase_energy_integrator integrator(1000.0);
+
+            // Constant 2 W with a marker set at 250 ms between the samples at
+            // 0 ms and 1000 ms.
+            integrator.push(measurement(L"sensor", 0, 2.0f), 0, 0, 0);
+            integrator.push(measurement(L"sensor", 1000, 2.0f), 1, 250, 1);
+            integrator.push(measurement(L"sensor", 2000, 2.0f), 1, 250, 1);
+
+            // A second sensor starting in the second phase.
+            integrator.push(measurement(L"other", 1500, 1.0f), 1, 250, 1);
+            integrator.push(measurement(L"other", 1600, 1.0f), 1, 250, 1);
+
+            auto summary = integrator.summary();
+            Assert::AreEqual(std::size_t(3), summary.size(), L"Three entries", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(0), summary[0].phase, L"Sorted by phase", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(0), summary[0].marker, L"No marker", LINE_INFO());
+            Assert::IsTrue(std::abs(summary[0].energy - 0.5) < 1e-9, L"Split before marker", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(0), summary[0].begin, L"Begin of first phase", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(250), summary[0].end, L"First phase ends at marker", LINE_INFO());
+
+            Assert::AreEqual(std::uint32_t(1), summary[1].phase, L"Second phase", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(1), summary[1].marker, L"Marker", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(2), summary[1].samples, L"Samples in second phase", LINE_INFO());
+            Assert::IsTrue(std::abs(summary[1].energy - 3.5) < 1e-9, L"Split after marker", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(250), summary[1].begin, L"Second phase begins at marker", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(2000), summary[1].end, L"End of second phase", LINE_INFO());
+
+            Assert::AreEqual(std::uint32_t(1), summary[2].phase, L"Other sensor", LINE_INFO());
+            Assert::IsTrue(std::abs(summary[2].energy - 0.1) < 1e-9, L"Other energy", LINE_INFO());
+
+            const auto& markers = integrator.markers();
+            Assert::AreEqual(std::size_t(2), markers.size(), L"Totals per marker", LINE_INFO());
+            Assert::IsTrue(std::abs(markers[0] - 0.5) < 1e-9, L"Total without marker", LINE_INFO());
+            Assert::IsTrue(std::abs(markers[1] - 3.6) < 1e-9, L"Total of marker across sensors", LINE_INFO());
+        }
+
+        TEST_METHOD(test_counter) {
+            detail::phase_energy_integrator integrator(1000.0);
+            integrator.add_counter(L"counter");
+
+            // Counter-based samples report the average since the previous
+            // one, so the energy is 1 W * 1 s + 3 W * 1 s regardless of the
+            // first sample.
+            integrator.push(measurement(L"counter", 0, 100.0f), 0, 0, 0);
+            integrator.push(measurement(L"counter", 1000, 1.0f), 0, 0, 0);
+            integrator.push(measurement(L"counter", 2000, 3.0f), 0, 0, 0);
+
+            auto summary = integrator.summary();
+            Assert::AreEqual(std::size_t(1), summary.size(), L"One phase", LINE_INFO());
+            Assert::IsTrue(std::abs(summary[0].energy - 4.0) < 1e-9, L"Counter", LINE_INFO());
+
+            integrator.reset(1000.0);
+            Assert::IsTrue(integrator.summary().empty(), L"Reset", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
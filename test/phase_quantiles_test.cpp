@@ -0,0 +1,68 @@
+﻿// <copyright file="phase_quantiles_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(phase_quantiles_test) {
+
+    public:
+
+        TEST_METHOD(test_tracker) {
+            detail::phase_quantile_tracker tracker;
+            Assert::IsTrue(tracker.empty(), L"Initially empty", LINE_INFO());
+
+            for (int i = 1; i <= 100; ++i) {
+                tracker.push(measurement(L"sensor", i, static_cast<float>(i)), 0);
+                tracker.push(measurement(L"sensor", i, 2.0f * i), 2);
+                tracker.push(measurement(L"other", i, 1.0f), 2);
+            }
+
+            auto& summary = tracker.summary();
+            Assert::AreEqual(std::size_t(3), summary.size(), L"Per sensor and marker", LINE_INFO());
+            Assert::AreEqual(L"sensor", summary[0].sensor, L"Order of first sample", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(0), summary[0].marker, L"No marker", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(100), summary[0].samples, L"Samples", LINE_INFO());
+            Assert::AreEqual(1.0f, summary[0].values[0], L"Minimum", LINE_INFO());
+            Assert::AreEqual(50.0f, summary[0].at(0.5), L"Median", LINE_INFO());
+            Assert::AreEqual(100.0f, summary[0].values[detail::phase_quantiles::size - 1], L"Maximum", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(2), summary[1].marker, L"Marker", LINE_INFO());
+            Assert::AreEqual(100.0f, summary[1].at(0.5), L"Median of marker", LINE_INFO());
+            Assert::AreEqual(L"other", summary[2].sensor, L"Other sensor", LINE_INFO());
+            Assert::AreEqual(1.0f, summary[2].at(0.99), L"Constant", LINE_INFO());
+
+            // Only changed summaries are updated, but the result is the same.
+            tracker.push(measurement(L"sensor", 102, 1000.0f), 2);
+            Assert::AreEqual(1000.0f, tracker.summary()[1].at(1.0), L"Updated maximum", LINE_INFO());
+            Assert::AreEqual(100.0f, tracker.summary()[0].at(1.0), L"Unchanged maximum", LINE_INFO());
+
+            tracker.reset();
+            Assert::IsTrue(tracker.empty(), L"Empty after reset", LINE_INFO());
+            Assert::IsTrue(tracker.summary().empty(), L"No summary after reset", LINE_INFO());
+        }
+
+        TEST_METHOD(test_interpolation) {
+            detail::phase_quantiles q;
+            for (std::size_t i = 0; i < detail::phase_quantiles::size; ++i) {
+                q.values[i] = static_cast<float>(100.0 * detail::phase_quantiles::levels[i]);
+            }
+
+            Assert::AreEqual(0.0f, q.at(-1.0), L"Clamped below", LINE_INFO());
+            Assert::AreEqual(100.0f, q.at(2.0), L"Clamped above", LINE_INFO());
+            Assert::AreEqual(50.0f, q.at(0.5), L"At level", LINE_INFO());
+            Assert::IsTrue(std::abs(q.at(0.6) - 60.0f) < 1e-4f, L"Between levels", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
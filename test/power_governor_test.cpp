@@ -0,0 +1,104 @@
+﻿// <copyright file="power_governor_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(power_governor_test) {
+
+    public:
+
+        TEST_METHOD(test_description) {
+            {
+                power_governor governor;
+                Assert::IsFalse(governor, L"Default does nothing", LINE_INFO());
+                Assert::IsTrue(power_governor_mode::none == governor.mode(), L"Default mode", LINE_INFO());
+                Assert::AreEqual(power_governor::default_interval, governor.interval(), L"Default interval", LINE_INFO());
+            }
+
+            {
+                auto governor = power_governor::hold_power(150.0);
+                Assert::IsTrue(governor, L"Hold power", LINE_INFO());
+                Assert::AreEqual(150.0, governor.target(), L"Target", LINE_INFO());
+                governor.interval(500000).limits(100.0, 200.0);
+                Assert::AreEqual(std::int64_t(500000), governor.interval(), L"Interval", LINE_INFO());
+                Assert::AreEqual(100.0, governor.min_limit(), L"Min limit", LINE_INFO());
+                Assert::AreEqual(200.0, governor.max_limit(), L"Max limit", LINE_INFO());
+            }
+
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                power_governor::hold_power(0.0);
+            }, L"Target not positive", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                power_governor::maximise_efficiency(nullptr);
+            }, L"No performance callback", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                power_governor::hold_power(100.0).limits(200.0, 100.0);
+            }, L"Inverted limits", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                detail::power_cap_controller(power_governor(), 100.0, 200.0, 150.0);
+            }, L"Controller without goal", LINE_INFO());
+        }
+
+        TEST_METHOD(test_hold_power) {
+            // The device undershoots its limit by 5 % and draws 250 W at most.
+            auto draw = [](const double limit) { return (std::min)(0.95 * limit, 250.0); };
+
+            detail::power_cap_controller controller(power_governor::hold_power(150.0), 100.0, 300.0, 300.0);
+            for (int i = 0; i < 50; ++i) {
+                for (int s = 0; s < 10; ++s) {
+                    controller.observe(draw(controller.limit()));
+                }
+                controller.update();
+            }
+            Assert::IsTrue(std::abs(draw(controller.limit()) - 150.0) < 1.0, L"Target held", LINE_INFO());
+
+            // The target cannot be reached, so the limit must saturate.
+            detail::power_cap_controller idle(power_governor::hold_power(150.0), 100.0, 300.0, 120.0);
+            for (int i = 0; i < 50; ++i) {
+                idle.observe(80.0);
+                idle.update();
+            }
+            Assert::AreEqual(300.0, idle.limit(), L"Limit saturated", LINE_INFO());
+        }
+
+        TEST_METHOD(test_maximise_efficiency) {
+            // 50 W of static power and performance growing with the square
+            // root of the dynamic power yields the best efficiency at 100 W.
+            struct plant {
+                double power;
+            } state { 0.0 };
+
+            auto performance = [](void *context) {
+                auto p = static_cast<plant *>(context);
+                return std::sqrt(p->power - 50.0);
+            };
+
+            detail::power_cap_controller controller(
+                power_governor::maximise_efficiency(performance, &state).resolution(2.0),
+                60.0, 300.0, 200.0);
+            Assert::AreEqual(300.0, controller.limit(), L"Search starts at the top", LINE_INFO());
+
+            for (int i = 0; i < 100; ++i) {
+                state.power = controller.limit();
+                controller.observe(state.power);
+                controller.update();
+            }
+
+            Assert::IsTrue(std::abs(controller.best_limit() - 100.0) < 10.0, L"Best limit found", LINE_INFO());
+            Assert::IsTrue(std::abs(controller.limit() - 100.0) < 10.0, L"Staying at the best limit", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
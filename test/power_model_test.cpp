@@ -0,0 +1,97 @@
+﻿// <copyright file="power_model_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(power_model_test) {
+
+    public:
+
+        TEST_METHOD(test_features) {
+            const auto x = detail::power_model::features(0.5, 0.25, 1.5e9, 5e9);
+            Assert::AreEqual(1.0, x[0], 0.0, L"Intercept", LINE_INFO());
+            Assert::AreEqual(0.5, x[1], 0.0, L"GPU utilisation", LINE_INFO());
+            Assert::AreEqual(0.25, x[2], 0.0, L"Memory utilisation", LINE_INFO());
+            Assert::AreEqual(1.5, x[3], 0.0, L"Graphics clock in GHz", LINE_INFO());
+            Assert::AreEqual(5.0, x[4], 0.0, L"Memory clock in GHz", LINE_INFO());
+            Assert::AreEqual(0.75, x[5], 0.0, L"Utilisation times clock", LINE_INFO());
+        }
+
+        TEST_METHOD(test_fit) {
+            detail::power_model model;
+            double power, lower, upper;
+
+            // A deterministic sequence covering all regressors.
+            auto activity = [](const std::size_t i) {
+                const auto u = static_cast<double>(i % 7) / 6.0;
+                const auto m = static_cast<double>(i % 5) / 4.0;
+                const auto g = (1.0 + static_cast<double>(i % 3) * 0.5) * 1e9;
+                const auto c = (4.0 + static_cast<double>(i % 2)) * 1e9;
+                return detail::power_model::features(u, m, g, c);
+            };
+            auto truth = [](const detail::power_model::features_type& x) {
+                return 30.0 + 20.0 * x[2] + 10.0 * x[3] + 5.0 * x[4]
+                    + 100.0 * x[5];
+            };
+
+            Assert::IsFalse(model.predict(power, lower, upper, activity(0)), L"Not ready", LINE_INFO());
+
+            // Add uniform noise within [-1, 1] from a linear congruential
+            // generator, which is not correlated with the regressors.
+            std::uint32_t seed = 42;
+            for (std::size_t i = 0; i < 500; ++i) {
+                seed = seed * 1664525u + 1013904223u;
+                const auto noise = static_cast<double>(seed >> 8) / (1 << 23) - 1.0;
+                const auto x = activity(i);
+                model.update(x, truth(x) + noise);
+            }
+            Assert::AreEqual(std::size_t(500), model.updates(), L"Updates counted", LINE_INFO());
+
+            const auto x = detail::power_model::features(0.9, 0.1, 1.8e9, 4.5e9);
+            Assert::IsTrue(model.predict(power, lower, upper, x), L"Ready", LINE_INFO());
+            Assert::AreEqual(truth(x), power, 1.0, L"Estimate", LINE_INFO());
+            Assert::IsTrue(lower < power, L"Lower bound", LINE_INFO());
+            Assert::IsTrue(upper > power, L"Upper bound", LINE_INFO());
+            Assert::IsTrue(lower <= truth(x), L"Truth above lower bound", LINE_INFO());
+            Assert::IsTrue(upper >= truth(x), L"Truth below upper bound", LINE_INFO());
+            Assert::IsTrue(upper - lower < 10.0, L"Bounds converged", LINE_INFO());
+
+            model.reset();
+            Assert::AreEqual(std::size_t(0), model.updates(), L"Reset", LINE_INFO());
+            Assert::IsFalse(model.predict(power, lower, upper, x), L"Not ready after reset", LINE_INFO());
+        }
+
+        TEST_METHOD(test_unexcited) {
+            detail::power_model model;
+            double power, lower, upper;
+
+            // An idle GPU only determines the power in its idle state.
+            const auto idle = detail::power_model::features(0.0, 0.0, 0.3e9, 0.4e9);
+            for (std::size_t i = 0; i < 10000; ++i) {
+                model.update(idle, 20.0 + ((i % 2 == 0) ? 0.5 : -0.5));
+            }
+
+            Assert::IsTrue(model.predict(power, lower, upper, idle), L"Idle estimate", LINE_INFO());
+            Assert::AreEqual(20.0, power, 0.5, L"Idle power", LINE_INFO());
+            const auto idle_width = upper - lower;
+
+            const auto busy = detail::power_model::features(1.0, 1.0, 2.0e9, 5.0e9);
+            Assert::IsTrue(model.predict(power, lower, upper, busy), L"Busy estimate", LINE_INFO());
+            Assert::IsTrue(std::isfinite(upper - lower), L"Bounded after long idle", LINE_INFO());
+            Assert::IsTrue(upper - lower > 10.0 * idle_width, L"Unknown state is uncertain", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
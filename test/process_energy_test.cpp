@@ -0,0 +1,78 @@
+﻿// <copyright file="process_energy_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(process_energy_test) {
+
+    public:
+
+        TEST_METHOD(test_idle) {
+            detail::process_energy_integrator integrator;
+            integrator.push(50.0, 2.0);
+
+            const auto summary = integrator.summary();
+            Assert::AreEqual(std::size_t(1), summary.size(), L"Only idle", LINE_INFO());
+            Assert::AreEqual(process_energy::idle, summary[0].pid(), L"Idle PID", LINE_INFO());
+            Assert::AreEqual(100.0, summary[0].energy(), 0.001, L"Idle energy", LINE_INFO());
+            Assert::AreEqual(2.0, summary[0].duration(), 0.001, L"Idle duration", LINE_INFO());
+        }
+
+        TEST_METHOD(test_shares) {
+            typedef detail::process_energy_integrator::utilisation_type utilisation_type;
+            detail::process_energy_integrator integrator;
+
+            // Process 42 uses three times the GPU of process 7. The second
+            // sample of 42 is averaged with the first one.
+            const utilisation_type utilisation[] = {
+                { 10, 42, 60 },
+                { 10, 7, 10 },
+                { 30, 42, 20 },
+            };
+            integrator.update(utilisation, 3);
+            integrator.push(100.0, 1.0);
+            integrator.push(std::numeric_limits<double>::quiet_NaN(), 1.0);
+
+            // All processes have exited.
+            integrator.update(nullptr, 0);
+            integrator.push(40.0, 0.5);
+
+            const auto summary = integrator.summary();
+            Assert::AreEqual(std::size_t(3), summary.size(), L"Idle and two processes", LINE_INFO());
+            Assert::AreEqual(process_energy::idle, summary[0].pid(), L"Ordered by PID", LINE_INFO());
+            Assert::AreEqual(20.0, summary[0].energy(), 0.001, L"Idle energy", LINE_INFO());
+            Assert::AreEqual(process_energy::pid_type(7), summary[1].pid(), L"First process", LINE_INFO());
+            Assert::AreEqual(25.0, summary[1].energy(), 0.001, L"Share of 7", LINE_INFO());
+            Assert::AreEqual(1.0, summary[1].duration(), 0.001, L"Duration of 7", LINE_INFO());
+            Assert::AreEqual(process_energy::pid_type(42), summary[2].pid(), L"Second process", LINE_INFO());
+            Assert::AreEqual(75.0, summary[2].energy(), 0.001, L"Share of 42", LINE_INFO());
+
+            std::stringstream stream;
+            std::map<std::wstring, std::vector<process_energy>> energies;
+            energies[L"NVML/GPU"] = summary;
+            detail::write_process_energy(stream, energies);
+
+            std::string line;
+            std::getline(stream, line);
+            Assert::AreEqual(std::string("sensor,pid,duration,energy"), line, L"Header", LINE_INFO());
+            std::getline(stream, line);
+            Assert::AreEqual(std::string("\"NVML/GPU\",0,"), line.substr(0, 13), L"Idle row", LINE_INFO());
+
+            integrator.reset();
+            Assert::IsTrue(integrator.summary().empty(), L"Reset", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
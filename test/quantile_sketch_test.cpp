@@ -0,0 +1,94 @@
+﻿// <copyright file="quantile_sketch_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(quantile_sketch_test) {
+
+    public:
+
+        TEST_METHOD(test_empty) {
+            Assert::ExpectException<std::invalid_argument>([](void) { detail::quantile_sketch sketch(1); }, L"Accuracy too low", LINE_INFO());
+
+            detail::quantile_sketch sketch;
+            Assert::AreEqual(std::uint64_t(0), sketch.count(), L"Empty", LINE_INFO());
+            Assert::IsTrue(std::isnan(sketch.quantile(0.5)), L"No median", LINE_INFO());
+            Assert::IsTrue(std::isnan(sketch.minimum()), L"No minimum", LINE_INFO());
+            Assert::IsTrue(std::isnan(sketch.maximum()), L"No maximum", LINE_INFO());
+
+            sketch.push(std::numeric_limits<float>::quiet_NaN());
+            Assert::AreEqual(std::uint64_t(0), sketch.count(), L"NaN ignored", LINE_INFO());
+        }
+
+        TEST_METHOD(test_exact) {
+            // As long as the first level is not full, the sketch is exact.
+            detail::quantile_sketch sketch;
+            for (int i = 10; i > 0; --i) {
+                sketch.push(static_cast<float>(i));
+            }
+
+            Assert::AreEqual(std::uint64_t(10), sketch.count(), L"Count", LINE_INFO());
+            Assert::AreEqual(1.0f, sketch.minimum(), L"Minimum", LINE_INFO());
+            Assert::AreEqual(10.0f, sketch.maximum(), L"Maximum", LINE_INFO());
+            Assert::AreEqual(1.0f, sketch.quantile(0.0), L"Zero is minimum", LINE_INFO());
+            Assert::AreEqual(10.0f, sketch.quantile(1.0), L"One is maximum", LINE_INFO());
+            Assert::AreEqual(5.0f, sketch.quantile(0.5), L"Median", LINE_INFO());
+            Assert::AreEqual(1.0f, sketch.quantile(-1.0), L"Clamped below", LINE_INFO());
+            Assert::AreEqual(10.0f, sketch.quantile(2.0), L"Clamped above", LINE_INFO());
+        }
+
+        TEST_METHOD(test_accuracy) {
+            detail::quantile_sketch sketch;
+            const auto cnt = 1000000;
+            for (int i = 0; i < cnt; ++i) {
+                // Permute the values such that they do not arrive in order.
+                sketch.push(static_cast<float>((i * 7919) % cnt));
+            }
+
+            Assert::AreEqual(std::uint64_t(cnt), sketch.count(), L"Count", LINE_INFO());
+            Assert::IsTrue(sketch.retained() < 1000, L"Bounded memory", LINE_INFO());
+
+            const double q[] = { 0.01, 0.25, 0.5, 0.95, 0.99 };
+            float values[5];
+            sketch.quantiles(values, q, 5);
+            for (std::size_t i = 0; i < 5; ++i) {
+                Assert::AreEqual(values[i], sketch.quantile(q[i]), L"Bulk and single", LINE_INFO());
+                Assert::IsTrue(std::abs(values[i] / cnt - q[i]) < 0.02, L"Rank error", LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(test_merge) {
+            detail::quantile_sketch lower, upper;
+            for (int i = 0; i < 100000; ++i) {
+                lower.push(static_cast<float>(i % 1000));
+                upper.push(static_cast<float>(1000 + i % 1000));
+            }
+
+            lower.merge(upper);
+            Assert::AreEqual(std::uint64_t(200000), lower.count(), L"Merged count", LINE_INFO());
+            Assert::AreEqual(0.0f, lower.minimum(), L"Merged minimum", LINE_INFO());
+            Assert::AreEqual(1999.0f, lower.maximum(), L"Merged maximum", LINE_INFO());
+            Assert::IsTrue(std::abs(lower.quantile(0.5) - 1000.0f) < 40.0f, L"Merged median", LINE_INFO());
+            Assert::IsTrue(std::abs(lower.quantile(0.25) - 500.0f) < 40.0f, L"Merged lower quartile", LINE_INFO());
+            Assert::IsTrue(std::abs(lower.quantile(0.75) - 1500.0f) < 40.0f, L"Merged upper quartile", LINE_INFO());
+
+            detail::quantile_sketch empty;
+            empty.merge(upper);
+            Assert::AreEqual(upper.count(), empty.count(), L"Merged into empty", LINE_INFO());
+            Assert::AreEqual(upper.minimum(), empty.minimum(), L"Minimum of empty", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,184 @@
+﻿// <copyright file="replay_sensor_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(replay_sensor_test) {
+
+    public:
+
+        TEST_METHOD(test_for_all) {
+            Assert::AreEqual(std::size_t(0), replay_sensor::for_all(nullptr, 0), L"Replay sensors are not discovered", LINE_INFO());
+        }
+
+        TEST_METHOD(test_invalid) {
+            replay_sensor sensor;
+            Assert::IsFalse(sensor, L"Default sensor is invalid", LINE_INFO());
+
+            write_binary();
+            Assert::ExpectException<std::invalid_argument>([](void) { replay_sensor(nullptr, L"sensor1"); }, L"Null path", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) { replay_sensor(L"replay_sensor_test.bin", L""); }, L"Empty name", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) { replay_sensor(L"replay_sensor_test.bin", L"sensor3"); }, L"Unknown sensor", LINE_INFO());
+            Assert::ExpectException<std::system_error>([](void) { replay_sensor(L"replay_sensor_test.missing", L"sensor1"); }, L"Missing file", LINE_INFO());
+
+            {
+                std::ofstream file("replay_sensor_test.txt", std::ios::trunc);
+                file << "This is not a trace.";
+            }
+
+            Assert::ExpectException<std::runtime_error>([](void) { replay_sensor(L"replay_sensor_test.txt", L"sensor1"); }, L"Invalid file", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) { replay_sensor(L"replay_sensor_test.bin", L"sensor1").speed(-1.0); }, L"Negative speed", LINE_INFO());
+        }
+
+        TEST_METHOD(test_binary) {
+            write_binary();
+
+            replay_sensor sensor(L"replay_sensor_test.bin", L"sensor1");
+            Assert::IsTrue(sensor, L"Sensor is valid", LINE_INFO());
+            Assert::AreEqual(L"sensor1", sensor.name(), L"Name of recorded sensor", LINE_INFO());
+            Assert::AreEqual(std::size_t(100), sensor.samples(), L"All samples loaded", LINE_INFO());
+            Assert::AreEqual(sensor::microseconds_type(10000), sensor.native_interval(), L"Mean interval", LINE_INFO());
+            Assert::AreEqual(replay_sensor::real_time, sensor.speed(), L"Real time by default", LINE_INFO());
+            Assert::IsTrue(sensor.rebase(), L"Rebased by default", LINE_INFO());
+            Assert::IsFalse(sensor.loop(), L"Not looped by default", LINE_INFO());
+
+            sensor.rebase(false);
+            for (int i = 0; i < 100; ++i) {
+                auto sample = sensor.sample_data(timestamp_resolution::milliseconds);
+                Assert::AreEqual(measurement_data::timestamp_type(1000 + 10 * i), sample.timestamp(), L"Recorded timestamp", LINE_INFO());
+                Assert::AreEqual(12.0f, sample.voltage(), L"Recorded voltage", LINE_INFO());
+                Assert::AreEqual(0.01f * i, sample.current(), 0.0001f, L"Recorded current", LINE_INFO());
+            }
+
+            auto last = sensor.sample_data(timestamp_resolution::microseconds);
+            Assert::AreEqual(measurement_data::timestamp_type(1990000), last.timestamp(), L"Last sample repeated in other resolution", LINE_INFO());
+            Assert::AreEqual(std::size_t(100), sensor.replayed(), L"Repetition is not counted", LINE_INFO());
+        }
+
+        TEST_METHOD(test_csv) {
+            for (auto quote : { char(0), '"' }) {
+                {
+                    detail::csv_output_writer writer;
+                    writer.quote(quote);
+                    writer.open(L"replay_sensor_test.csv");
+                    writer.marker(1, L"phase");
+                    writer.header();
+                    writer.push(measurement(L"sensor1", 100, 12.0f, 2.0f), 0);
+                    writer.push(measurement(L"sensor2", 100, 3.0f), 0);
+                    writer.marker_event(110, 1);
+                    writer.push(measurement(L"sensor2", 110, 4.0f), 1);
+                    writer.push(measurement(L"sensor1", 120, 12.0f, 1.5f), 1);
+                }
+
+                replay_sensor sensor1(L"replay_sensor_test.csv", L"sensor1");
+                Assert::AreEqual(std::size_t(2), sensor1.samples(), L"Samples of sensor1", LINE_INFO());
+                Assert::AreEqual(sensor::microseconds_type(20000), sensor1.native_interval(), L"Milliseconds assumed", LINE_INFO());
+                sensor1.rebase(false);
+                auto sample = sensor1.sample_data(timestamp_resolution::milliseconds);
+                Assert::AreEqual(measurement_data::timestamp_type(100), sample.timestamp(), L"Timestamp from CSV", LINE_INFO());
+                Assert::AreEqual(24.0f, sample.power(), L"Power from CSV", LINE_INFO());
+                Assert::AreEqual(2.0f, sample.current(), L"Current from CSV", LINE_INFO());
+
+                replay_sensor sensor2(L"replay_sensor_test.csv", L"sensor2");
+                Assert::AreEqual(std::size_t(2), sensor2.samples(), L"Samples of sensor2", LINE_INFO());
+                sensor2.rebase(false);
+                sensor2.sample_data(timestamp_resolution::milliseconds);
+                sample = sensor2.sample_data(timestamp_resolution::milliseconds);
+                Assert::AreEqual(4.0f, sample.power(), L"Power-only sample", LINE_INFO());
+                Assert::AreEqual(measurement_data::invalid_value, sample.voltage(), L"Invalid voltage restored", LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(test_loop) {
+            write_binary();
+
+            replay_sensor sensor(L"replay_sensor_test.bin", L"sensor2");
+            sensor.loop(true).rebase(false);
+
+            for (int i = 0; i < 250; ++i) {
+                auto sample = sensor.sample_data(timestamp_resolution::milliseconds);
+                Assert::AreEqual(measurement_data::timestamp_type(1000 + 10 * i), sample.timestamp(), L"Repetitions continue the timestamps", LINE_INFO());
+                Assert::AreEqual(static_cast<float>(i % 100 + 1), sample.power(), L"Repetitions replay the values", LINE_INFO());
+            }
+
+            Assert::AreEqual(std::size_t(250), sensor.replayed(), L"All samples counted", LINE_INFO());
+        }
+
+        TEST_METHOD(test_async) {
+            write_binary();
+
+            for (auto speed : { replay_sensor::as_fast_as_possible, 10.0 }) {
+                std::vector<measurement_data> samples;
+                replay_sensor sensor(L"replay_sensor_test.bin", L"sensor1");
+                sensor.speed(speed);
+
+                const auto begin = std::chrono::steady_clock::now();
+                const auto now = detail::create_timestamp(timestamp_resolution::milliseconds);
+                sensor.sample_batch(collect, 1000, &samples);
+
+                Assert::ExpectException<std::logic_error>([&sensor](void) {
+                    sensor.sample_batch(collect, 1000);
+                }, L"Sampling twice", LINE_INFO());
+
+                while ((sensor.replayed() < sensor.samples()) && (std::chrono::steady_clock::now() - begin < std::chrono::seconds(10))) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                }
+
+                const auto elapsed = std::chrono::steady_clock::now() - begin;
+                sensor.sample_batch(nullptr);
+
+                Assert::AreEqual(std::size_t(100), samples.size(), L"All samples replayed", LINE_INFO());
+                Assert::IsTrue(samples.front().timestamp() >= now, L"Rebased to the replay", LINE_INFO());
+                Assert::AreEqual(measurement_data::timestamp_type(990), samples.back().timestamp() - samples.front().timestamp(), L"Spacing preserved", LINE_INFO());
+
+                if (speed > replay_sensor::as_fast_as_possible) {
+                    // The last sample is due after a tenth of its offset.
+                    Assert::IsTrue(elapsed >= std::chrono::milliseconds(90), L"Replay paced", LINE_INFO());
+                }
+            }
+        }
+
+    private:
+
+        static void collect(_In_z_ const wchar_t *sensor,
+                _In_reads_(cnt) const measurement_data *samples,
+                _In_ const std::size_t cnt,
+                _In_opt_ void *context) {
+            Assert::AreEqual(L"sensor1", sensor, L"Name of sensor in callback", LINE_INFO());
+            auto dst = static_cast<std::vector<measurement_data> *>(context);
+            dst->insert(dst->end(), samples, samples + cnt);
+        }
+
+        /// <summary>
+        /// Writes 100 samples of two sensors every 10 ms, starting at 1000.
+        /// </summary>
+        static void write_binary(void) {
+            detail::binary_output_writer writer;
+            writer.open(L"replay_sensor_test.bin");
+            writer.header(timestamp_resolution::milliseconds, { L"sensor1", L"sensor2" });
+
+            for (int i = 0; i < 100; ++i) {
+                const auto t = 1000 + 10 * i;
+                writer.push(measurement(L"sensor1", t, 12.0f, 0.01f * i), 0);
+                writer.push(measurement(L"sensor2", t, static_cast<float>(i + 1)), 0);
+
+                if (i % 50 == 49) {
+                    writer.flush();
+                }
+            }
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
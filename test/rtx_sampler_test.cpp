@@ -0,0 +1,134 @@
+﻿// <copyright file="rtx_sampler_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(rtx_sampler_test) {
+
+    public:
+
+        TEST_METHOD(test_append_samples) {
+            blob vdata(4 * sizeof(float));
+            vdata.as<float>()[0] = 1.0f;
+            vdata.as<float>()[1] = 2.0f;
+            vdata.as<float>()[2] = 3.0f;
+            vdata.as<float>()[3] = 4.0f;
+            oscilloscope_waveform voltage("-0.002,0.002,4,1", std::move(vdata));
+
+            blob cdata(3 * sizeof(float));
+            cdata.as<float>()[0] = 0.5f;
+            cdata.as<float>()[1] = 1.0f;
+            cdata.as<float>()[2] = 2.0f;
+            oscilloscope_waveform current("-0.002,0.002,3,1", std::move(cdata));
+
+            std::vector<measurement_data> samples;
+            auto cnt = detail::append_rtx_samples(samples, voltage, current, 1000, timestamp_resolution::milliseconds);
+            Assert::AreEqual(std::size_t(3), cnt, L"Common samples only", LINE_INFO());
+            Assert::AreEqual(cnt, samples.size(), L"Samples appended", LINE_INFO());
+
+            Assert::AreEqual(timestamp_type(998), samples[0].timestamp(), L"First timestamp before trigger", LINE_INFO());
+            Assert::AreEqual(timestamp_type(999), samples[1].timestamp(), L"Second timestamp", LINE_INFO());
+            Assert::AreEqual(timestamp_type(1000), samples[2].timestamp(), L"Third timestamp on trigger", LINE_INFO());
+
+            Assert::AreEqual(1.0f, samples[0].voltage(), L"Voltage", LINE_INFO());
+            Assert::AreEqual(0.5f, samples[0].current(), L"Current", LINE_INFO());
+            Assert::AreEqual(0.5f, samples[0].power(), L"Power #0", LINE_INFO());
+            Assert::AreEqual(2.0f, samples[1].power(), L"Power #1", LINE_INFO());
+            Assert::AreEqual(6.0f, samples[2].power(), L"Power #2", LINE_INFO());
+
+            cnt = detail::append_rtx_samples(samples, voltage, current, 0, timestamp_resolution::microseconds);
+            Assert::AreEqual(std::size_t(6), samples.size(), L"Samples appended to existing ones", LINE_INFO());
+            Assert::AreEqual(timestamp_type(-1000), samples[4].timestamp(), L"Microsecond resolution", LINE_INFO());
+        }
+
+        TEST_METHOD(test_append_decimated) {
+            blob vdata(5 * sizeof(float));
+            blob cdata(5 * sizeof(float));
+            for (int i = 0; i < 5; ++i) {
+                vdata.as<float>()[i] = static_cast<float>(i + 1);
+                cdata.as<float>()[i] = (i % 2 == 0) ? 1.0f : 0.0f;
+            }
+            oscilloscope_waveform voltage("0,0.01,5,1", std::move(vdata));
+            oscilloscope_waveform current("0,0.01,5,1", std::move(cdata));
+
+            std::vector<measurement_data> samples;
+            auto cnt = detail::append_rtx_samples(samples, voltage, current, 100, timestamp_resolution::milliseconds, 2);
+            Assert::AreEqual(std::size_t(3), cnt, L"Windows appended", LINE_INFO());
+            Assert::AreEqual(cnt, samples.size(), L"Samples appended", LINE_INFO());
+
+            Assert::AreEqual(1.5f, samples[0].voltage(), L"Mean voltage", LINE_INFO());
+            Assert::AreEqual(0.5f, samples[0].current(), L"Mean current", LINE_INFO());
+            Assert::AreEqual(0.5f, samples[0].power(), L"Mean of instantaneous power", LINE_INFO());
+            Assert::AreEqual(5.0f, samples[2].voltage(), L"Partial window", LINE_INFO());
+            Assert::AreEqual(5.0f, samples[2].power(), L"Power of partial window", LINE_INFO());
+
+            Assert::AreEqual(timestamp_type(101), samples[0].timestamp(), L"Centre of first window", LINE_INFO());
+            Assert::AreEqual(timestamp_type(108), samples[2].timestamp(), L"Centre of partial window", LINE_INFO());
+
+            cnt = detail::append_rtx_samples(samples, voltage, current, 100, timestamp_resolution::milliseconds, 1);
+            Assert::AreEqual(std::size_t(5), cnt, L"Window of one is not decimated", LINE_INFO());
+        }
+
+        TEST_METHOD(test_append_math) {
+            blob pdata(3 * sizeof(float));
+            pdata.as<float>()[0] = 0.5f;
+            pdata.as<float>()[1] = 2.0f;
+            pdata.as<float>()[2] = 6.0f;
+            oscilloscope_waveform power("-0.002,0.001,3,1", std::move(pdata));
+
+            std::vector<measurement_data> samples;
+            auto cnt = detail::append_rtx_samples(samples, power, nullptr, nullptr, 1000, timestamp_resolution::milliseconds);
+            Assert::AreEqual(std::size_t(3), cnt, L"All samples of maths channel", LINE_INFO());
+            Assert::AreEqual(timestamp_type(998), samples[0].timestamp(), L"Timestamp from maths channel", LINE_INFO());
+            Assert::AreEqual(6.0f, samples[2].power(), L"Power from maths channel", LINE_INFO());
+            Assert::AreEqual(measurement_data::invalid_value, samples[0].voltage(), L"No voltage without raw channels", LINE_INFO());
+            Assert::AreEqual(measurement_data::invalid_value, samples[0].current(), L"No current without raw channels", LINE_INFO());
+
+            blob vdata(2 * sizeof(float));
+            vdata.as<float>()[0] = 1.0f;
+            vdata.as<float>()[1] = 2.0f;
+            oscilloscope_waveform voltage("-0.002,0.001,2,1", std::move(vdata));
+            blob cdata(3 * sizeof(float));
+            cdata.as<float>()[0] = 0.5f;
+            cdata.as<float>()[1] = 1.0f;
+            cdata.as<float>()[2] = 1.0f;
+            oscilloscope_waveform current("-0.002,0.001,3,1", std::move(cdata));
+
+            samples.clear();
+            cnt = detail::append_rtx_samples(samples, power, &voltage, &current, 1000, timestamp_resolution::milliseconds);
+            Assert::AreEqual(std::size_t(2), cnt, L"Common samples only", LINE_INFO());
+            Assert::AreEqual(2.0f, samples[1].voltage(), L"Raw voltage", LINE_INFO());
+            Assert::AreEqual(1.0f, samples[1].current(), L"Raw current", LINE_INFO());
+            Assert::AreEqual(2.0f, samples[1].power(), L"Power from maths channel", LINE_INFO());
+        }
+
+        TEST_METHOD(test_waveform_header) {
+            blob data(4 * sizeof(float));
+            oscilloscope_waveform waveform("-5E-1,0.25,3,1", std::move(data));
+            Assert::AreEqual(-0.5f, waveform.time_begin(), L"Begin", LINE_INFO());
+            Assert::AreEqual(0.25f, waveform.time_end(), L"End", LINE_INFO());
+            Assert::AreEqual(std::size_t(3), waveform.record_length(), L"Record length", LINE_INFO());
+            Assert::IsNull(data.as<float>(), L"Samples moved", LINE_INFO());
+
+            data.resize(2 * sizeof(float));
+            Assert::ExpectException<std::invalid_argument>([&data](void) { oscilloscope_waveform("0,1,3,1", std::move(data)); }, L"Too many samples", LINE_INFO());
+            Assert::IsNotNull(data.as<float>(), L"Samples not moved on error", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&data](void) { oscilloscope_waveform("0;1;1;1", std::move(data)); }, L"Wrong separator", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&data](void) { oscilloscope_waveform("0,1,1", std::move(data)); }, L"Missing field", LINE_INFO());
+        }
+
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
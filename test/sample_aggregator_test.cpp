@@ -0,0 +1,97 @@
+﻿// <copyright file="sample_aggregator_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(sample_aggregator_test) {
+
+    public:
+
+        TEST_METHOD(test_disabled) {
+            detail::sample_aggregator aggregator;
+            detail::sample_aggregate aggregate;
+            Assert::IsFalse(aggregator.enabled(), L"Disabled by default", LINE_INFO());
+            Assert::IsFalse(aggregator.push(measurement(L"sensor", 0, 1.0f), 0, aggregate), L"Nothing aggregated", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([&aggregator](void) { aggregator.configure(-1, 1000.0); }, L"Negative window", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&aggregator](void) { aggregator.configure(1000, 0.0); }, L"Invalid resolution", LINE_INFO());
+        }
+
+        TEST_METHOD(test_windows) {
+            detail::sample_aggregator aggregator;
+            aggregator.configure(1000, 1000.0);
+            Assert::IsTrue(aggregator.enabled(), L"Enabled", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(1000), aggregator.window(), L"Window", LINE_INFO());
+
+            std::vector<detail::sample_aggregate> aggregates;
+            detail::sample_aggregate aggregate;
+            auto energy = 0.0;
+
+            // Samples every millisecond for 2.5 s, alternating between 9 W and
+            // 11 W.
+            for (measurement::timestamp_type t = 500; t < 3000; ++t) {
+                measurement sample(L"sensor", t, (t % 2 == 0) ? 9.0f : 11.0f);
+                if (aggregator.push(sample, 0, aggregate)) {
+                    aggregates.push_back(aggregate);
+                }
+            }
+
+            aggregator.flush(aggregates);
+            Assert::AreEqual(std::size_t(3), aggregates.size(), L"Three windows", LINE_INFO());
+
+            Assert::AreEqual(measurement::timestamp_type(0), aggregates[0].begin, L"Aligned begin", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(1000), aggregates[0].end, L"Aligned end", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(500), aggregates[0].count, L"Partial first window", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(1000), aggregates[1].count, L"Full window", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(2000), aggregates[2].begin, L"Last window", LINE_INFO());
+
+            for (auto& a : aggregates) {
+                Assert::AreEqual(9.0f, a.minimum, L"Minimum", LINE_INFO());
+                Assert::AreEqual(10.0f, a.mean, L"Mean", LINE_INFO());
+                Assert::AreEqual(11.0f, a.maximum, L"Maximum", LINE_INFO());
+                energy += a.energy;
+            }
+
+            // The trapezoids between windows are attributed to the later one.
+            Assert::IsTrue(std::abs(aggregates[0].energy - 4.99) < 1e-9, L"Energy of first window", LINE_INFO());
+            Assert::IsTrue(std::abs(aggregates[1].energy - 10.0) < 1e-9, L"Energy of full window", LINE_INFO());
+            Assert::IsTrue(std::abs(energy - 24.99) < 1e-9, L"Total energy is exact", LINE_INFO());
+        }
+
+        TEST_METHOD(test_marker) {
+            detail::sample_aggregator aggregator;
+            aggregator.configure(1000, 1000.0);
+
+            std::vector<detail::sample_aggregate> aggregates;
+            detail::sample_aggregate aggregate;
+
+            for (measurement::timestamp_type t = 0; t < 1000; ++t) {
+                measurement sample(L"sensor", t, 10.0f);
+                if (aggregator.push(sample, (t < 400) ? 1 : 2, aggregate)) {
+                    aggregates.push_back(aggregate);
+                }
+            }
+
+            aggregator.flush(aggregates);
+            Assert::AreEqual(std::size_t(2), aggregates.size(), L"Split at marker", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(1), aggregates[0].marker, L"First marker", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(400), aggregates[0].count, L"Samples of first marker", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(2), aggregates[1].marker, L"Second marker", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(600), aggregates[1].count, L"Samples of second marker", LINE_INFO());
+            Assert::IsTrue(std::abs(aggregates[1].energy - 5.99) < 1e-9, L"Integration restarts", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,227 @@
+﻿// <copyright file="sampler_scheduler_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    /// <summary>
+    /// Counts the ticks of a task and stops it after a given number of ticks.
+    /// </summary>
+    struct tick_counter {
+        std::atomic<std::size_t> cnt;
+        std::atomic<bool> executing;
+        std::size_t limit;
+        detail::sampler_scheduler::task task;
+
+        inline tick_counter(const std::size_t limit = 0)
+            : cnt(0), executing(false), limit(limit),
+            task(&tick_counter::tick, this) { }
+
+        static bool tick(void *context) {
+            auto that = static_cast<tick_counter *>(context);
+            that->executing = that->task.executing();
+            const auto cnt = ++that->cnt;
+            return ((that->limit == 0) || (cnt < that->limit));
+        }
+    };
+
+
+    /// <summary>
+    /// A task producing numbered samples into the buffer of the task that
+    /// is currently running, like the sensors do in the collector.
+    /// </summary>
+    struct numbered_producer {
+        typedef std::vector<std::pair<const void *, std::vector<measurement>>>
+            buffers_type;
+
+        buffers_type& buffers;
+        std::mutex& lock;
+        const wchar_t *name;
+        measurement_data::sequence_type sequence;
+        std::atomic<bool> wrong_task;
+        detail::sampler_scheduler::task task;
+
+        inline numbered_producer(const wchar_t *name, buffers_type& buffers,
+                std::mutex& lock)
+            : buffers(buffers), lock(lock), name(name), sequence(0),
+            wrong_task(false), task(&numbered_producer::tick, this) { }
+
+        static bool tick(void *context) {
+            auto that = static_cast<numbered_producer *>(context);
+            const auto key = detail::sampler_scheduler::task::current();
+            that->wrong_task = that->wrong_task || (key != &that->task);
+
+            const auto sequence = detail::sequence_tracker::next(
+                that->sequence);
+            measurement_data data(sequence, 1.0f);
+            data.sequence(sequence);
+
+            std::lock_guard<std::mutex> l(that->lock);
+            auto it = std::find_if(that->buffers.begin(), that->buffers.end(),
+                [key](const buffers_type::value_type& b) { return (b.first == key); });
+            if (it == that->buffers.end()) {
+                that->buffers.emplace_back(key, std::vector<measurement>());
+                it = that->buffers.end() - 1;
+            }
+            it->second.emplace_back(that->name, data);
+            return true;
+        }
+    };
+
+
+    TEST_CLASS(sampler_scheduler_test) {
+
+    public:
+
+        TEST_METHOD(test_schedule) {
+            auto& scheduler = detail::sampler_scheduler::instance();
+            tick_counter fast, slow;
+            Assert::IsFalse(fast.task.executing(), L"Not executing outside callback", LINE_INFO());
+
+            scheduler.schedule(fast.task, std::chrono::milliseconds(1));
+            scheduler.schedule(slow.task, std::chrono::milliseconds(10));
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+            Assert::IsTrue(scheduler.workers() >= 1, L"Pool started", LINE_INFO());
+            Assert::IsTrue(scheduler.workers() <= detail::sampler_scheduler::max_workers, L"Pool is small", LINE_INFO());
+            Assert::IsTrue(fast.cnt.load() >= 10, L"Fast task ticks", LINE_INFO());
+            Assert::IsTrue(slow.cnt.load() >= 2, L"Slow task ticks", LINE_INFO());
+            Assert::IsTrue(slow.cnt.load() < fast.cnt.load(), L"Intervals are respected", LINE_INFO());
+            Assert::IsTrue(fast.executing.load(), L"Executing inside callback", LINE_INFO());
+
+            scheduler.cancel(fast.task);
+            scheduler.cancel(slow.task);
+            const auto cnt = fast.cnt.load();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            Assert::AreEqual(cnt, fast.cnt.load(), L"No ticks after cancel", LINE_INFO());
+
+            scheduler.cancel(fast.task);
+        }
+
+        TEST_METHOD(test_stop) {
+            auto& scheduler = detail::sampler_scheduler::instance();
+            tick_counter counter(3);
+
+            scheduler.schedule(counter.task, std::chrono::milliseconds(1));
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            Assert::AreEqual(std::size_t(3), counter.cnt.load(), L"Task stopped by callback", LINE_INFO());
+
+            // Cancelling a stopped task is a no-op, but synchronises with the
+            // worker that completed the last tick.
+            scheduler.cancel(counter.task);
+            counter.limit = 5;
+            scheduler.schedule(counter.task, std::chrono::milliseconds(1));
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            Assert::AreEqual(std::size_t(5), counter.cnt.load(), L"Stopped task can be rescheduled", LINE_INFO());
+            scheduler.cancel(counter.task);
+        }
+
+        TEST_METHOD(test_start_barrier) {
+            auto& scheduler = detail::sampler_scheduler::instance();
+            tick_counter counter;
+
+            detail::start_barrier::arm();
+            scheduler.schedule(counter.task, std::chrono::milliseconds(1));
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            Assert::AreEqual(std::size_t(0), counter.cnt.load(), L"Held back by barrier", LINE_INFO());
+
+            detail::start_barrier::release();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            Assert::IsTrue(counter.cnt.load() > 0, L"Started after release", LINE_INFO());
+
+            scheduler.cancel(counter.task);
+        }
+
+        TEST_METHOD(test_pump) {
+            typedef detail::sampler_scheduler::clock_type clock_type;
+            auto& scheduler = detail::sampler_scheduler::instance();
+            const auto interval = std::chrono::hours(1);
+            tick_counter counter;
+
+            scheduler.manual(true);
+            Assert::IsTrue(scheduler.manual(), L"Manual mode enabled", LINE_INFO());
+
+            scheduler.schedule(counter.task, interval);
+            // If another test has started the workers, they might run the
+            // first tick, so wait for that to complete.
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+            const auto now = clock_type::now() + 3 * interval + interval / 2;
+            Assert::AreEqual(std::size_t(0), scheduler.pump(clock_type::time_point()), L"Nothing due in the past", LINE_INFO());
+            Assert::AreEqual(std::size_t(1), scheduler.pump(now, std::chrono::microseconds(1)), L"Budget limits ticks", LINE_INFO());
+            scheduler.pump(now);
+            Assert::AreEqual(std::size_t(4), counter.cnt.load(), L"All due ticks run", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), scheduler.pump(now), L"Nothing due anymore", LINE_INFO());
+
+            scheduler.cancel(counter.task);
+            scheduler.manual(false);
+            Assert::IsFalse(scheduler.manual(), L"Manual mode disabled", LINE_INFO());
+        }
+
+        TEST_METHOD(test_task_buffers) {
+            typedef detail::sampler_scheduler::clock_type clock_type;
+            auto& scheduler = detail::sampler_scheduler::instance();
+            Assert::IsNull(detail::sampler_scheduler::task::current(), L"No task outside callback", LINE_INFO());
+
+            numbered_producer::buffers_type buffers;
+            std::mutex lock;
+            numbered_producer p1(L"p1", buffers, lock), p2(L"p2", buffers, lock), p3(L"p3", buffers, lock), p4(L"p4", buffers, lock);
+            numbered_producer *producers[] = { &p1, &p2, &p3, &p4 };
+
+            // Let the workers and the pumping test thread compete for the
+            // ticks such that the tasks migrate between the threads.
+            for (auto p : producers) {
+                scheduler.schedule(p->task, std::chrono::microseconds(200));
+            }
+            const auto end = clock_type::now() + std::chrono::milliseconds(100);
+            while (clock_type::now() < end) {
+                scheduler.pump(clock_type::now());
+                std::this_thread::yield();
+            }
+            for (auto p : producers) {
+                scheduler.cancel(p->task);
+            }
+
+            Assert::AreEqual(std::size_t(4), buffers.size(), L"One buffer per task", LINE_INFO());
+
+            // Drain the buffers in chunks like the writer does and check that
+            // the sequence tracker sees every sample exactly once in order.
+            detail::sequence_tracker tracker;
+            detail::sequence_gap gap;
+            std::vector<std::size_t> positions(buffers.size(), 0);
+            for (auto remaining = true; remaining;) {
+                remaining = false;
+                for (std::size_t i = 0; i < buffers.size(); ++i) {
+                    auto& b = buffers[i].second;
+                    const auto end = (std::min)(positions[i] + 7, b.size());
+                    for (; positions[i] < end; ++positions[i]) {
+                        Assert::IsFalse(tracker.push(b[positions[i]], gap), L"No gap", LINE_INFO());
+                    }
+                    remaining = remaining || (positions[i] < b.size());
+                }
+            }
+
+            const auto summary = tracker.summary();
+            Assert::AreEqual(std::size_t(4), summary.size(), L"All producers tracked", LINE_INFO());
+            for (std::size_t i = 0; i < summary.size(); ++i) {
+                Assert::IsFalse(producers[i]->wrong_task.load(), L"Callback runs as its task", LINE_INFO());
+                Assert::AreEqual(std::uint64_t(producers[i]->sequence), summary[i].samples, L"All samples seen", LINE_INFO());
+                Assert::IsTrue(summary[i].samples > 10, L"Producer ticked", LINE_INFO());
+                Assert::AreEqual(std::uint64_t(0), summary[i].duplicates, L"No duplicates", LINE_INFO());
+                Assert::AreEqual(std::uint64_t(0), summary[i].gaps, L"No gaps", LINE_INFO());
+            }
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,69 @@
+﻿// <copyright file="sampler_statistics_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(sampler_statistics_test) {
+
+    public:
+
+        TEST_METHOD(test_ctor) {
+            sampler_statistics statistics;
+            Assert::IsTrue(bool(statistics), L"Default statistics are valid", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(0), statistics.ticks(), L"Default statistics are empty", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), statistics.sources(), L"Default statistics have no source", LINE_INFO());
+
+            auto moved = std::move(statistics);
+            Assert::IsFalse(bool(statistics), L"Moved statistics are invalid", LINE_INFO());
+            Assert::ExpectException<std::runtime_error>([&statistics](void) { statistics.ticks(); }, L"Moved statistics cannot be used", LINE_INFO());
+        }
+
+        TEST_METHOD(test_for_all) {
+            synthetic_sensor sensor(L"statistics_test");
+            sensor.async(false);
+            sampler_statistics::reset_all();
+
+            sensor.sample_batch([](const wchar_t *, const measurement_data *, const std::size_t, void *) { }, 1000);
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            sensor.sample_batch(nullptr);
+
+            std::vector<sampler_statistics> statistics(sampler_statistics::for_all(nullptr, 0));
+            sampler_statistics::for_all(statistics.data(), statistics.size());
+            Assert::IsFalse(statistics.empty(), L"Sampler context has been instrumented", LINE_INFO());
+
+            auto found = false;
+            for (auto& s : statistics) {
+                Assert::IsTrue(bool(s), L"Statistics are valid", LINE_INFO());
+
+                for (std::size_t i = 0; i < s.sources(); ++i) {
+                    if (std::wcscmp(s.source(i), L"statistics_test") == 0) {
+                        found = true;
+                        Assert::IsTrue(s.ticks() > 0, L"Ticks have been counted", LINE_INFO());
+                        Assert::AreEqual(s.ticks(), s.jitter().count(), L"Jitter per tick", LINE_INFO());
+                        Assert::IsTrue(s.sample_duration(i).count() > 0, L"Sample durations recorded", LINE_INFO());
+                        Assert::IsTrue(s.callback_duration().count() > 0, L"Callback durations recorded", LINE_INFO());
+                    }
+                }
+
+                Assert::ExpectException<std::out_of_range>([&s](void) { s.source(s.sources()); }, L"Invalid source", LINE_INFO());
+            }
+            Assert::IsTrue(found, L"Sensor is a source", LINE_INFO());
+
+            sampler_statistics::reset_all();
+            Assert::AreEqual(std::size_t(0), sampler_statistics::for_all(nullptr, 0), L"Idle contexts are not reported after reset", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
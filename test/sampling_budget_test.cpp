@@ -0,0 +1,103 @@
+﻿// <copyright file="sampling_budget_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(sampling_budget_test) {
+
+    public:
+
+        TEST_METHOD(test_disabled) {
+            typedef detail::sampling_budget::interval_type interval_type;
+            detail::sampling_budget::request requests[2];
+            requests[0].cost = 1000.0;
+            requests[0].interval = interval_type(100);
+            requests[0].priority = 1.0f;
+            requests[1].cost = 0.0;
+            requests[1].interval = interval_type(5000);
+            requests[1].priority = 0.0f;
+
+            detail::sampling_budget budget;
+            Assert::IsFalse(budget.enabled(), L"Disabled by default", LINE_INFO());
+            budget.allocate(requests, 2);
+            Assert::IsTrue(interval_type(100) == requests[0].granted, L"Requested interval", LINE_INFO());
+            Assert::IsTrue(interval_type(5000) == requests[1].granted, L"Requested interval", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([](void) { detail::sampling_budget(-1.0f, 0); }, L"Negative CPU budget", LINE_INFO());
+        }
+
+        TEST_METHOD(test_cpu) {
+            typedef detail::sampling_budget::interval_type interval_type;
+            detail::sampling_budget::request requests[3];
+            for (auto& r : requests) {
+                r.cost = 1000.0;
+                r.interval = interval_type(1000);
+                r.priority = 1.0f;
+            }
+            requests[1].priority = 3.0f;
+            // The third one is cheap enough to get all it asks for.
+            requests[2].cost = 10.0;
+            requests[2].interval = interval_type(1000);
+
+            detail::sampling_budget budget(0.5f, 0);
+            Assert::IsTrue(budget.enabled(), L"Enabled", LINE_INFO());
+            budget.allocate(requests, 3);
+
+            Assert::IsTrue(interval_type(1000) == requests[2].granted, L"Saturated sensor", LINE_INFO());
+            // The others share the remaining 490 ms/s in the ratio 1:3.
+            Assert::IsTrue(requests[0].granted >= interval_type(8163), L"Low priority", LINE_INFO());
+            Assert::IsTrue(requests[0].granted <= interval_type(8165), L"Low priority", LINE_INFO());
+            Assert::IsTrue(requests[1].granted >= interval_type(2721), L"High priority", LINE_INFO());
+            Assert::IsTrue(requests[1].granted <= interval_type(2723), L"High priority", LINE_INFO());
+
+            auto used = 0.0;
+            for (auto& r : requests) {
+                used += r.cost / r.granted.count();
+            }
+            Assert::IsTrue(used <= 0.5, L"Budget kept", LINE_INFO());
+        }
+
+        TEST_METHOD(test_reads) {
+            typedef detail::sampling_budget::interval_type interval_type;
+            detail::sampling_budget::request requests[4];
+            for (auto& r : requests) {
+                r.cost = 0.0;
+                r.interval = interval_type(1000);
+                r.priority = 1.0f;
+            }
+
+            detail::sampling_budget budget(0.0f, 100);
+            budget.allocate(requests, 4);
+
+            for (auto& r : requests) {
+                Assert::IsTrue(r.granted >= interval_type(40000), L"25 reads per second", LINE_INFO());
+                Assert::IsTrue(r.granted <= interval_type(40001), L"25 reads per second", LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(test_max_interval) {
+            typedef detail::sampling_budget::interval_type interval_type;
+            detail::sampling_budget::request request;
+            request.cost = 1000000.0;
+            request.interval = interval_type(1000);
+            request.priority = 1.0f;
+
+            detail::sampling_budget budget(0.000001f, 0);
+            budget.allocate(&request, 1);
+            Assert::IsTrue(detail::sampling_budget::max_interval == request.granted, L"Clamped to maximum", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,118 @@
+﻿// <copyright file="scpi_analyser_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(scpi_analyser_test) {
+
+    public:
+
+        TEST_METHOD(test_descriptor) {
+            typedef detail::scpi_analyser_descriptor desc_type;
+
+            {
+                auto desc = desc_type::parse(R"({
+                    "name": "WT310",
+                    "vendor": "0x0B21",
+                    "product": "0x0025",
+                    "identity": "WT310",
+                    "setup": [ ":NUM:FORM ASC", ":NUM:NORM:NUM 4\n" ],
+                    "query": ":NUM:NORM:VAL?",
+                    "fields": { "voltage": 0, "current": 1, "power": 3 },
+                    "integrator": {
+                        "start": ":INTEG:STAR",
+                        "energy": ":NUM:NORM:VAL? 4",
+                        "energy_scale": 3600
+                    }
+                })");
+                Assert::AreEqual(std::string("WT310"), desc.name, L"Name", LINE_INFO());
+                Assert::AreEqual(std::string("0x0B21"), desc.vendor, L"Vendor", LINE_INFO());
+                Assert::AreEqual(std::string(":NUM:NORM:VAL?\n"), desc.query, L"Query terminated", LINE_INFO());
+                Assert::AreEqual(std::size_t(2), desc.setup.size(), L"Setup", LINE_INFO());
+                Assert::AreEqual(std::string(":NUM:FORM ASC\n"), desc.setup[0], L"Setup terminated", LINE_INFO());
+                Assert::AreEqual(std::string(":NUM:NORM:NUM 4\n"), desc.setup[1], L"Setup not terminated twice", LINE_INFO());
+                Assert::AreEqual(std::size_t(0), desc.voltage, L"Voltage", LINE_INFO());
+                Assert::AreEqual(std::size_t(1), desc.current, L"Current", LINE_INFO());
+                Assert::AreEqual(std::size_t(3), desc.power, L"Power", LINE_INFO());
+                Assert::AreEqual(std::size_t(4), desc.count, L"Count", LINE_INFO());
+                Assert::AreEqual(std::string(":INTEG:STAR\n"), desc.start, L"Start", LINE_INFO());
+                Assert::IsTrue(desc.stop.empty(), L"No stop", LINE_INFO());
+                Assert::AreEqual(3600.0, desc.energy_scale, L"Energy scale", LINE_INFO());
+            }
+
+            {
+                auto desc = desc_type::parse(R"({ "query": "MEAS:POW?", "fields": { "power": 0 } })");
+                Assert::AreEqual(desc_type::no_field, desc.voltage, L"No voltage", LINE_INFO());
+                Assert::AreEqual(desc_type::no_field, desc.current, L"No current", LINE_INFO());
+                Assert::AreEqual(std::size_t(1), desc.count, L"Count", LINE_INFO());
+                Assert::AreEqual(1.0, desc.energy_scale, L"Default energy scale", LINE_INFO());
+            }
+
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                desc_type::parse(nullptr);
+            }, L"Null descriptor", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                desc_type::parse(R"({ "fields": { "power": 0 } })");
+            }, L"No query", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                desc_type::parse(R"({ "query": "MEAS?", "fields": { "voltage": 0 } })");
+            }, L"No power", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                desc_type::parse(R"({ "query": "MEAS?", "fields": { "power": 32 } })");
+            }, L"Power out of range", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                desc_type::parse("{ \"query\": ");
+            }, L"Invalid JSON", LINE_INFO());
+        }
+
+        TEST_METHOD(test_response) {
+            typedef detail::scpi_analyser_descriptor desc_type;
+
+            {
+                auto desc = desc_type::parse(R"({ "query": "VAL?", "fields": { "voltage": 2, "current": 0, "power": 1 } })");
+                const std::string response("0.5,115.0,230.0,42.0\n");
+                auto sample = desc.parse_response(response.data(), response.size(), 7);
+                Assert::AreEqual(measurement_data::timestamp_type(7), sample.timestamp(), L"Timestamp", LINE_INFO());
+                Assert::AreEqual(230.0f, sample.voltage(), L"Voltage", LINE_INFO());
+                Assert::AreEqual(0.5f, sample.current(), L"Current", LINE_INFO());
+                Assert::AreEqual(115.0f, sample.power(), L"Power", LINE_INFO());
+            }
+
+            {
+                auto desc = desc_type::parse(R"({ "query": "VAL?", "fields": { "power": 1 } })");
+                const std::string response("1.0,42.5\n");
+                auto sample = desc.parse_response(response.data(), response.size(), 7);
+                Assert::AreEqual(42.5f, sample.power(), L"Power only", LINE_INFO());
+            }
+
+            {
+                auto desc = desc_type::parse(R"({ "query": "VAL?", "fields": { "power": 2 } })");
+                const std::string response("1.0,42.5\n");
+                Assert::ExpectException<std::invalid_argument>([&](void) {
+                    desc.parse_response(response.data(), response.size(), 7);
+                }, L"Too few values", LINE_INFO());
+
+                Assert::ExpectException<std::invalid_argument>([&](void) {
+                    desc.parse_response(nullptr, 0, 7);
+                }, L"Empty response", LINE_INFO());
+            }
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
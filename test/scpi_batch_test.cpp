@@ -0,0 +1,67 @@
+﻿// <copyright file="scpi_batch_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(scpi_batch_test) {
+
+    public:
+
+        TEST_METHOD(test_message) {
+            detail::scpi_batch batch;
+            Assert::IsTrue(batch.empty(), L"New batch is empty", LINE_INFO());
+            Assert::AreEqual(std::string(), batch.message(), L"Empty message", LINE_INFO());
+
+            batch.add("CHAN%d:STAT %s", 1, "ON").add(":CHAN1:BAND FULL").add(std::string("TRIG:A:MODE AUTO"));
+            Assert::AreEqual(std::size_t(3), batch.size(), L"Commands added", LINE_INFO());
+            Assert::AreEqual(std::string("CHAN1:STAT ON"), batch.command(0), L"Formatted command", LINE_INFO());
+            Assert::AreEqual(std::string(":CHAN1:STAT ON;:CHAN1:BAND FULL;:TRIG:A:MODE AUTO\n"), batch.message(), L"Concatenated message", LINE_INFO());
+
+            batch.clear();
+            Assert::IsTrue(batch.empty(), L"Cleared batch is empty", LINE_INFO());
+        }
+
+        TEST_METHOD(test_parse_errors) {
+            std::vector<detail::scpi_error> errors;
+
+            const std::string none("0,\"No error\"\n");
+            Assert::AreEqual(std::size_t(0), detail::parse_scpi_errors(errors, none.data(), none.size()), L"No error", LINE_INFO());
+            Assert::IsTrue(errors.empty(), L"Nothing added", LINE_INFO());
+
+            const std::string some("-222,\"Data out of range;CHAN1:RANG 1000.000000V\",-113,\"Undefined \"\"header\"\"\",0,\"No error\"\n");
+            Assert::AreEqual(std::size_t(2), detail::parse_scpi_errors(errors, some.data(), some.size()), L"Two errors", LINE_INFO());
+            Assert::AreEqual(-222, errors[0].code, L"First code", LINE_INFO());
+            Assert::AreEqual(std::string("Data out of range;CHAN1:RANG 1000.000000V"), errors[0].message, L"First message", LINE_INFO());
+            Assert::AreEqual(-113, errors[1].code, L"Second code", LINE_INFO());
+            Assert::AreEqual(std::string("Undefined \"header\""), errors[1].message, L"Escaped quotes", LINE_INFO());
+
+            const std::string invalid("garbage");
+            Assert::ExpectException<std::runtime_error>([&](void) { detail::parse_scpi_errors(errors, invalid.data(), invalid.size()); }, L"Invalid response", LINE_INFO());
+        }
+
+        TEST_METHOD(test_describe) {
+            detail::scpi_batch batch;
+            batch.add("CHAN1:BAND FULL").add("CHAN1:RANG 1000.000000V");
+
+            std::vector<detail::scpi_error> errors;
+            errors.push_back(detail::scpi_error { -222, "Data out of range;chan1:rang 1000.000000V" });
+            errors.push_back(detail::scpi_error { -350, "Queue overflow" });
+
+            Assert::AreEqual(std::string("-222, Data out of range;chan1:rang 1000.000000V (caused by \"CHAN1:RANG 1000.000000V\"). -350, Queue overflow."), batch.describe(errors), L"Errors mapped to commands", LINE_INFO());
+        }
+
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
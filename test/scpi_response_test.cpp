@@ -0,0 +1,139 @@
+﻿// <copyright file="scpi_response_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(scpi_response_test) {
+
+    public:
+
+        TEST_METHOD(test_integer) {
+            std::int64_t value = 0;
+
+            {
+                const std::string input(" -113,\"Undefined header\"");
+                auto cur = input.data();
+                Assert::IsTrue(detail::parse_integer(cur, input.data() + input.size(), value), L"Negative", LINE_INFO());
+                Assert::AreEqual(std::int64_t(-113), value, L"Value", LINE_INFO());
+                Assert::AreEqual(',', *cur, L"Stopped at delimiter", LINE_INFO());
+            }
+
+            {
+                const std::string input("+42");
+                auto cur = input.data();
+                Assert::IsTrue(detail::parse_integer(cur, input.data() + input.size(), value), L"Positive", LINE_INFO());
+                Assert::AreEqual(std::int64_t(42), value, L"Value", LINE_INFO());
+                Assert::IsTrue(cur == input.data() + input.size(), L"Consumed all", LINE_INFO());
+            }
+
+            {
+                // The range ends before the termination of the string.
+                const std::string input("12345");
+                auto cur = input.data();
+                Assert::IsTrue(detail::parse_integer(cur, input.data() + 2, value), L"Range", LINE_INFO());
+                Assert::AreEqual(std::int64_t(12), value, L"Value", LINE_INFO());
+            }
+
+            {
+                const std::string input("-x");
+                auto cur = input.data();
+                Assert::IsFalse(detail::parse_integer(cur, input.data() + input.size(), value), L"No digits", LINE_INFO());
+                Assert::IsTrue(cur == input.data(), L"Unchanged", LINE_INFO());
+            }
+
+            {
+                const std::string input("99999999999999999999999");
+                auto cur = input.data();
+                Assert::IsFalse(detail::parse_integer(cur, input.data() + input.size(), value), L"Overflow", LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(test_quoted) {
+            const char *begin = nullptr;
+            const char *last = nullptr;
+
+            {
+                const std::string input(" \"Undefined \"\"header\"\"\",0");
+                auto cur = input.data();
+                Assert::IsTrue(detail::parse_quoted(cur, input.data() + input.size(), begin, last), L"Double quotes", LINE_INFO());
+                Assert::AreEqual(std::string("Undefined \"\"header\"\""), std::string(begin, last), L"Raw content", LINE_INFO());
+                Assert::AreEqual(',', *cur, L"Stopped after quote", LINE_INFO());
+
+                std::string message;
+                detail::append_quoted(message, begin, last);
+                Assert::AreEqual(std::string("Undefined \"header\""), message, L"Unescaped content", LINE_INFO());
+            }
+
+            {
+                const std::string input("'CH1'");
+                auto cur = input.data();
+                Assert::IsTrue(detail::parse_quoted(cur, input.data() + input.size(), begin, last), L"Single quotes", LINE_INFO());
+                Assert::AreEqual(std::string("CH1"), std::string(begin, last), L"Content", LINE_INFO());
+            }
+
+            {
+                const std::string input("\"unterminated");
+                auto cur = input.data();
+                Assert::IsFalse(detail::parse_quoted(cur, input.data() + input.size(), begin, last), L"Unterminated", LINE_INFO());
+                Assert::IsTrue(cur == input.data(), L"Unchanged", LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(test_real_list) {
+            double values[3];
+
+            {
+                const std::string input("1.5,-2E-3 , 9.91E37\n");
+                auto cur = input.data();
+                Assert::IsTrue(detail::parse_real_list(cur, input.data() + input.size(), values, 3), L"List", LINE_INFO());
+                Assert::AreEqual(1.5, values[0], 0.0001, L"First", LINE_INFO());
+                Assert::AreEqual(-0.002, values[1], 0.0001, L"Second", LINE_INFO());
+                Assert::IsTrue(std::isnan(values[2]), L"Invalid measurement", LINE_INFO());
+            }
+
+            {
+                const std::string input("1.5,2.5");
+                auto cur = input.data();
+                Assert::IsFalse(detail::parse_real_list(cur, input.data() + input.size(), values, 3), L"Too few", LINE_INFO());
+                Assert::IsTrue(cur == input.data(), L"Unchanged", LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(test_response) {
+            {
+                const std::string input("42\n");
+                blob response(input.size());
+                ::memcpy(response.data(), input.data(), input.size());
+                Assert::AreEqual(std::int64_t(42), detail::parse_integer_response(response), L"Integer", LINE_INFO());
+                Assert::AreEqual(42.0, detail::parse_real_response(response), 0.0001, L"Real", LINE_INFO());
+            }
+
+            {
+                const std::string input("42;*");
+                blob response(input.size());
+                ::memcpy(response.data(), input.data(), input.size());
+                Assert::ExpectException<std::runtime_error>([&response](void) {
+                    detail::parse_integer_response(response);
+                }, L"Trailing garbage", LINE_INFO());
+            }
+
+            Assert::ExpectException<std::runtime_error>([](void) {
+                detail::parse_real_response(blob());
+            }, L"Empty response", LINE_INFO());
+        }
+
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,139 @@
+﻿// <copyright file="scpi_socket_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(scpi_socket_test) {
+
+    public:
+
+#if defined(_WIN32)
+        TEST_METHOD_INITIALIZE(initialise) {
+            WSADATA wsa_data = { };
+            ::WSAStartup(MAKEWORD(2, 2), &wsa_data);
+        }
+
+        TEST_METHOD_CLEANUP(cleanup) {
+            ::WSACleanup();
+        }
+#endif /* defined(_WIN32) */
+
+        TEST_METHOD(test_parse) {
+            std::string host;
+            std::uint16_t port = 0;
+
+            Assert::IsTrue(detail::scpi_socket::parse("TCPIP::192.168.1.2::5025::SOCKET", host, port), L"Full resource", LINE_INFO());
+            Assert::AreEqual(std::string("192.168.1.2"), host, L"Host", LINE_INFO());
+            Assert::AreEqual(std::uint16_t(5025), port, L"Port", LINE_INFO());
+
+            Assert::IsTrue(detail::scpi_socket::parse("tcpip0::rtb2004::1234::socket", host, port), L"Board number and lower case", LINE_INFO());
+            Assert::AreEqual(std::string("rtb2004"), host, L"Host", LINE_INFO());
+            Assert::AreEqual(std::uint16_t(1234), port, L"Port", LINE_INFO());
+
+            Assert::IsTrue(detail::scpi_socket::parse("TCPIP::rtb2004::SOCKET", host, port), L"Default port", LINE_INFO());
+            Assert::AreEqual(std::string("rtb2004"), host, L"Host", LINE_INFO());
+            Assert::AreEqual(detail::scpi_socket::default_port, port, L"Default port", LINE_INFO());
+
+            Assert::IsFalse(detail::scpi_socket::parse("TCPIP::192.168.1.2::INSTR", host, port), L"VXI-11", LINE_INFO());
+            Assert::IsFalse(detail::scpi_socket::parse("USB0::0x0AAD::0x01D6::1234::INSTR", host, port), L"USB", LINE_INFO());
+            Assert::IsFalse(detail::scpi_socket::parse("TCPIP::::SOCKET", host, port), L"No host", LINE_INFO());
+            Assert::IsFalse(detail::scpi_socket::parse("TCPIP::host::port::SOCKET", host, port), L"Non-numeric port", LINE_INFO());
+            Assert::IsFalse(detail::scpi_socket::parse("TCPIP::host::99999::SOCKET", host, port), L"Port out of range", LINE_INFO());
+        }
+
+        TEST_METHOD(test_loopback) {
+            auto listener = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            sockaddr_in addr = { };
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            Assert::AreEqual(0, ::bind(listener, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)), L"Bind listener", LINE_INFO());
+            Assert::AreEqual(0, ::listen(listener, 1), L"Listen", LINE_INFO());
+
+            socklen_t addr_length = sizeof(addr);
+            ::getsockname(listener, reinterpret_cast<sockaddr *>(&addr), &addr_length);
+            const auto port = ntohs(addr.sin_port);
+
+            // The fake instrument answers each line it receives, sending the
+            // responses in small pieces to exercise the reassembly.
+            std::thread instrument([listener](void) {
+                auto peer = ::accept(listener, nullptr, nullptr);
+                auto respond = [peer](const std::string& response) {
+                    for (std::size_t i = 0; i < response.size(); i += 3) {
+                        const auto cnt = (std::min)(response.size() - i, std::size_t(3));
+                        ::send(peer, response.data() + i, static_cast<int>(cnt), 0);
+                    }
+                };
+
+                std::string received;
+                char data[64];
+                int cnt = 0;
+                auto done = false;
+                while (!done && (cnt = ::recv(peer, data, sizeof(data), 0)) > 0) {
+                    received.append(data, cnt);
+
+                    std::string::size_type end;
+                    while ((end = received.find('\n')) != std::string::npos) {
+                        const auto query = received.substr(0, end);
+                        received.erase(0, end + 1);
+
+                        if (query == "*IDN?") {
+                            respond("Rohde&Schwarz,RTB2004,1234,1.0\n");
+                        } else if (query == "DATA?") {
+                            respond("#210abcdefghij\n");
+                        } else if (query == "VAR?") {
+                            respond("#(5)hello\n");
+                            done = true;
+                        }
+                    }
+                }
+#if defined(_WIN32)
+                ::closesocket(peer);
+#else /* defined(_WIN32) */
+                ::close(peer);
+#endif /* defined(_WIN32) */
+            });
+
+            {
+                const auto path = "TCPIP::127.0.0.1::" + std::to_string(port) + "::SOCKET";
+                auto impl = detail::visa_instrument_impl::create(path, 1000);
+                Assert::IsNotNull(impl->socket.get(), L"Opened as socket", LINE_INFO());
+                Assert::AreEqual(detail::scpi_socket::interface_type, impl->interface_type(), L"Interface type", LINE_INFO());
+                Assert::AreEqual(std::string("SOCKET"), impl->resource_class(), L"Resource class", LINE_INFO());
+
+                Assert::AreEqual(std::string("Rohde&Schwarz,RTB2004,1234,1.0"), impl->identify(), L"Identify", LINE_INFO());
+
+                impl->write("DATA?\n");
+                auto data = impl->read_binary();
+                Assert::AreEqual(std::string("abcdefghij"), std::string(data.as<char>(), data.size()), L"Definite-length block", LINE_INFO());
+
+                impl->write("VAR?\n");
+                data = impl->read_binary();
+                Assert::AreEqual(std::string("hello"), std::string(data.as<char>(), data.size()), L"Variable-length block", LINE_INFO());
+                Assert::AreEqual('\n', impl->socket->termchar(), L"Termination character restored", LINE_INFO());
+
+                impl->release();
+            }
+
+            instrument.join();
+#if defined(_WIN32)
+            ::closesocket(listener);
+#else /* defined(_WIN32) */
+            ::close(listener);
+#endif /* defined(_WIN32) */
+        }
+
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,112 @@
+﻿// <copyright file="sensor_capability_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    /// <summary>
+    /// A sensor with constant readings or one that always fails.
+    /// </summary>
+    class probed_sensor final : public sensor {
+
+    public:
+
+        inline probed_sensor(const wchar_t *name, const bool fail)
+            : _fail(fail), _name(name) { }
+
+        ~probed_sensor(void) {
+            this->sample_batch(nullptr);
+        }
+
+        virtual const wchar_t *name(void) const noexcept override {
+            return this->_name;
+        }
+
+        virtual operator bool(void) const noexcept override {
+            return (this->_name != nullptr);
+        }
+
+    protected:
+
+        measurement_data sample_sync(
+                const timestamp_resolution resolution) const override {
+            if (this->_fail) {
+                throw std::runtime_error("The sensor is broken.");
+            }
+
+            return measurement_data(detail::create_timestamp(resolution),
+                12.0f, 2.0f);
+        }
+
+    private:
+
+        bool _fail;
+        const wchar_t *_name;
+    };
+
+
+    TEST_CLASS(sensor_capability_test) {
+
+    public:
+
+        TEST_METHOD(test_probe) {
+            probed_sensor sensor(L"constant", false);
+            const auto capability = detail::probe_capability(sensor,
+                std::chrono::milliseconds(50));
+
+            Assert::AreEqual(std::wstring(L"constant"), capability.name, L"Name", LINE_INFO());
+            Assert::IsTrue(capability.error.empty(), L"No error", LINE_INFO());
+            Assert::IsTrue(capability.samples > 0, L"Samples obtained", LINE_INFO());
+            Assert::AreEqual(capability.samples, capability.latency.count(), L"Latency per sample", LINE_INFO());
+            Assert::IsTrue(capability.cpu_time >= 0.0, L"CPU time", LINE_INFO());
+            Assert::AreEqual(sensor::microseconds_type(0), capability.update_interval, L"Constant readings", LINE_INFO());
+            Assert::IsTrue(capability.safe_interval >= 1, L"Positive safe interval", LINE_INFO());
+        }
+
+        TEST_METHOD(test_error) {
+            probed_sensor sensor(L"broken", true);
+            const auto capability = detail::probe_capability(sensor,
+                std::chrono::milliseconds(10));
+
+            Assert::IsFalse(capability.error.empty(), L"Error recorded", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(0), capability.samples, L"No samples", LINE_INFO());
+        }
+
+        TEST_METHOD(test_report) {
+            const auto path = L"sensor_capability_test.json";
+            std::vector<detail::sensor_capability> capabilities(2);
+            capabilities[0].name = L"sensor1";
+            capabilities[0].safe_interval = 2000;
+            capabilities[0].cpu_time = 12.5;
+            capabilities[0].samples = 10;
+            capabilities[1].name = L"sensor2";
+            capabilities[1].error = "The sensor is broken.";
+
+            {
+                std::ofstream s("sensor_capability_test.json", std::ios::out | std::ios::trunc);
+                detail::write_capability_report(s, capabilities);
+            }
+
+            const auto intervals = detail::load_safe_intervals(path);
+            Assert::AreEqual(std::size_t(1), intervals.size(), L"Failed sensor skipped", LINE_INFO());
+            Assert::AreEqual(sensor::microseconds_type(2000), intervals.at(L"sensor1"), L"Safe interval", LINE_INFO());
+
+            const auto costs = detail::load_read_costs(path);
+            Assert::AreEqual(std::size_t(1), costs.size(), L"Failed sensor skipped", LINE_INFO());
+            Assert::AreEqual(12.5, costs.at(L"sensor1"), L"CPU time", LINE_INFO());
+        }
+
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -23,6 +23,18 @@ namespace test {
             Assert::IsFalse(desc_type::intrinsic_async, L"adl_sensor not intrinsically asynchronous", LINE_INFO());
         }
 
+        TEST_METHOD(test_amdgpu_sensor) {
+            typedef detail::sensor_desc<amdgpu_sensor> desc_type;
+            Assert::AreEqual("amdgpu_sensor", desc_type::type_name, L"amdgpu_sensor type name", LINE_INFO());
+            Assert::IsFalse(desc_type::intrinsic_async, L"amdgpu_sensor not intrinsically asynchronous", LINE_INFO());
+        }
+
+        TEST_METHOD(test_dcgm_sensor) {
+            typedef detail::sensor_desc<dcgm_sensor> desc_type;
+            Assert::AreEqual("dcgm_sensor", desc_type::type_name, L"dcgm_sensor type name", LINE_INFO());
+            Assert::IsFalse(desc_type::intrinsic_async, L"dcgm_sensor not intrinsically asynchronous", LINE_INFO());
+        }
+
         TEST_METHOD(test_emi_sensor) {
             typedef detail::sensor_desc<emi_sensor> desc_type;
             Assert::AreEqual("emi_sensor", desc_type::type_name, L"emi_sensor type name", LINE_INFO());
@@ -36,18 +48,80 @@ namespace test {
             Assert::IsFalse(desc_type::intrinsic_async, L"hmc8015_sensor not intrinsically asynchronous", LINE_INFO());
         }
 
+        TEST_METHOD(test_level_zero_sensor) {
+            typedef detail::sensor_desc<level_zero_sensor> desc_type;
+            Assert::AreEqual("level_zero_sensor", desc_type::type_name, L"level_zero_sensor type name", LINE_INFO());
+            Assert::IsFalse(desc_type::intrinsic_async, L"level_zero_sensor not intrinsically asynchronous", LINE_INFO());
+        }
+
         TEST_METHOD(test_nvml_sensor) {
             typedef detail::sensor_desc<nvml_sensor> desc_type;
             Assert::AreEqual("nvml_sensor", desc_type::type_name, L"nvml_sensor type name", LINE_INFO());
             Assert::IsFalse(desc_type::intrinsic_async, L"nvml_sensor not intrinsically asynchronous", LINE_INFO());
         }
 
+        TEST_METHOD(test_replay_sensor) {
+            typedef detail::sensor_desc<replay_sensor> desc_type;
+            Assert::AreEqual("replay_sensor", desc_type::type_name, L"replay_sensor type name", LINE_INFO());
+            Assert::IsTrue(desc_type::intrinsic_async, L"replay_sensor intrinsically asynchronous", LINE_INFO());
+
+            {
+                detail::csv_output_writer writer;
+                writer.open(L"sensor_desc_test.csv");
+                writer.header();
+                writer.push(measurement(L"replayed", 0, 42.0f), 0);
+            }
+
+            replay_sensor sensor(L"sensor_desc_test.csv", L"replayed");
+            sensor.speed(replay_sensor::as_fast_as_possible).loop(true);
+
+            auto desc = desc_type::serialise(sensor);
+            Assert::IsTrue(desc_type::describes(desc), L"Descriptor describes replay_sensor", LINE_INFO());
+            auto copy = desc_type::deserialise(desc);
+            Assert::AreEqual(L"replayed", copy.name(), L"Name restored", LINE_INFO());
+            Assert::AreEqual(L"sensor_desc_test.csv", copy.path(), L"Path restored", LINE_INFO());
+            Assert::AreEqual(replay_sensor::as_fast_as_possible, copy.speed(), L"Speed restored", LINE_INFO());
+            Assert::IsTrue(copy.loop(), L"Loop restored", LINE_INFO());
+            Assert::IsTrue(copy.rebase(), L"Rebase restored", LINE_INFO());
+        }
+
         TEST_METHOD(test_rtb_sensor) {
             typedef detail::sensor_desc<rtx_sensor> desc_type;
             Assert::AreEqual("rtx_sensor", desc_type::type_name, L"rtx_sensor type name", LINE_INFO());
             Assert::IsFalse(desc_type::intrinsic_async, L"rtx_sensor not intrinsically asynchronous", LINE_INFO());
         }
 
+        TEST_METHOD(test_synthetic_sensor) {
+            typedef detail::sensor_desc<synthetic_sensor> desc_type;
+            Assert::AreEqual("synthetic_sensor", desc_type::type_name, L"synthetic_sensor type name", LINE_INFO());
+            Assert::IsFalse(desc_type::intrinsic_async, L"synthetic_sensor not intrinsically asynchronous", LINE_INFO());
+
+            synthetic_sensor sensor(L"synth", synthetic_waveform::square);
+            sensor.amplitude(2.0f).async(true).cost(5).offset(10.0f).period(2000).voltage(5.0f);
+            auto desc = desc_type::serialise(sensor);
+            Assert::IsTrue(desc_type::describes(desc), L"Descriptor describes synthetic_sensor", LINE_INFO());
+
+            auto copy = desc_type::deserialise(desc);
+            Assert::AreEqual(L"synth", copy.name(), L"Name restored", LINE_INFO());
+            Assert::IsTrue(synthetic_waveform::square == copy.waveform(), L"Waveform restored", LINE_INFO());
+            Assert::AreEqual(2.0f, copy.amplitude(), L"Amplitude restored", LINE_INFO());
+            Assert::IsTrue(copy.async(), L"Async restored", LINE_INFO());
+            Assert::AreEqual(synthetic_sensor::microseconds_type(5), copy.cost(), L"Cost restored", LINE_INFO());
+            Assert::AreEqual(10.0f, copy.offset(), L"Offset restored", LINE_INFO());
+            Assert::AreEqual(synthetic_sensor::microseconds_type(2000), copy.period(), L"Period restored", LINE_INFO());
+            Assert::AreEqual(5.0f, copy.voltage(), L"Voltage restored", LINE_INFO());
+
+            auto minimal = desc_type::deserialise(nlohmann::json::object({ { "type", "synthetic_sensor" }, { "name", "minimal" } }));
+            Assert::AreEqual(synthetic_sensor::default_offset, minimal.offset(), L"Default offset", LINE_INFO());
+            Assert::IsFalse(minimal.async(), L"Polled by default", LINE_INFO());
+        }
+
+        TEST_METHOD(test_sysfs_sensor) {
+            typedef detail::sensor_desc<sysfs_sensor> desc_type;
+            Assert::AreEqual("sysfs_sensor", desc_type::type_name, L"sysfs_sensor type name", LINE_INFO());
+            Assert::IsFalse(desc_type::intrinsic_async, L"sysfs_sensor not intrinsically asynchronous", LINE_INFO());
+        }
+
         TEST_METHOD(test_tinkerforge_sensor) {
             typedef detail::sensor_desc<tinkerforge_sensor> desc_type;
             Assert::AreEqual("tinkerforge_sensor", desc_type::type_name, L"tinkerforge_sensor type name", LINE_INFO());
@@ -0,0 +1,61 @@
+﻿// <copyright file="sensor_filter_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(sensor_filter_test) {
+
+    public:
+
+        TEST_METHOD(test_default) {
+            sensor_filter filter;
+            Assert::IsNull(filter.device(), L"Accept all devices", LINE_INFO());
+            Assert::IsNull(filter.name(), L"Accept all names", LINE_INFO());
+            Assert::IsNull(filter.type(), L"Accept all types", LINE_INFO());
+        }
+
+        TEST_METHOD(test_patterns) {
+            sensor_filter filter;
+            filter.type(L"nvml_sensor|adl_sensor")
+                .name(L"NVML/(.+)")
+                .device(L"PCI(0)", true);
+
+            Assert::AreEqual(L"nvml_sensor|adl_sensor", filter.type(), L"Type pattern", LINE_INFO());
+            Assert::AreEqual(L"NVML/(.+)", filter.name(), L"Name pattern", LINE_INFO());
+            Assert::AreEqual(L"PCI\\(0\\)", filter.device(), L"Literal device is escaped", LINE_INFO());
+
+            sensor_filter copy(filter);
+            Assert::AreEqual(filter.type(), copy.type(), L"Type copied", LINE_INFO());
+            Assert::AreEqual(filter.device(), copy.device(), L"Device copied", LINE_INFO());
+
+            filter.name(nullptr);
+            Assert::IsNull(filter.name(), L"Name pattern reset", LINE_INFO());
+            Assert::IsNotNull(copy.name(), L"Copy is independent", LINE_INFO());
+        }
+
+        TEST_METHOD(test_collector) {
+            sensor_filter filter;
+            filter.type(L"no_such_sensor");
+
+            auto collector = collector::for_all(collector_settings(), filter);
+            Assert::AreEqual(std::size_t(0), collector.size(), L"No type probed", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(0), collector.samples(), L"No samples", LINE_INFO());
+
+            filter.type(L"(");
+            Assert::ExpectException<std::regex_error>([&filter](void) { collector::for_all(collector_settings(), filter); }, L"Invalid pattern", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
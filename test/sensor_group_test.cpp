@@ -0,0 +1,91 @@
+﻿// <copyright file="sensor_group_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(sensor_group_test) {
+
+        struct constant_sensor {
+            mutable std::size_t reads;
+            measurement_data::value_type power;
+
+            inline measurement_data sample(void) const {
+                ++this->reads;
+                return measurement_data(42, this->power);
+            }
+        };
+
+        struct result_type {
+            std::size_t batches;
+            std::vector<std::wstring> names;
+            std::vector<measurement_data::value_type> power;
+        };
+
+        static void on_batch(const wchar_t *const *sensors, const measurement_batch& batch, void *context) {
+            auto result = static_cast<result_type *>(context);
+            ++result->batches;
+            result->names.assign(sensors, sensors + batch.size());
+            auto power = batch.values(measurement_quantity::power);
+            result->power.assign(power, power + batch.size());
+        }
+
+    public:
+
+        TEST_METHOD(test_add_remove) {
+            constant_sensor sensors[3] = { { 0, 1.0f }, { 0, 2.0f }, { 0, 3.0f } };
+            detail::sensor_group<constant_sensor, 2> group;
+            Assert::AreEqual(std::size_t(0), group.size(), L"Empty group", LINE_INFO());
+
+            Assert::IsTrue(group.add(sensors + 0, L"first"), L"First added", LINE_INFO());
+            Assert::IsFalse(group.add(sensors + 0, L"first"), L"Duplicate rejected", LINE_INFO());
+            Assert::IsTrue(group.add(sensors + 1, L"second"), L"Second added", LINE_INFO());
+            Assert::IsFalse(group.add(sensors + 2, L"third"), L"Full group", LINE_INFO());
+            Assert::AreEqual(std::size_t(2), group.size(), L"Two sensors", LINE_INFO());
+
+            Assert::IsTrue(group.remove(sensors + 0), L"First removed", LINE_INFO());
+            Assert::IsFalse(group.remove(sensors + 0), L"Removed twice", LINE_INFO());
+            Assert::IsTrue(group.add(sensors + 2, L"third"), L"Space reused", LINE_INFO());
+
+            result_type result { 0 };
+            group.sample(on_batch, &result);
+            Assert::AreEqual(std::size_t(2), result.names.size(), L"Two samples", LINE_INFO());
+            Assert::AreEqual(std::wstring(L"second"), result.names[0], L"Order preserved", LINE_INFO());
+            Assert::AreEqual(std::wstring(L"third"), result.names[1], L"Appended at end", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([&group](void) { group.add(nullptr, L"null"); }, L"Null sensor", LINE_INFO());
+        }
+
+        TEST_METHOD(test_sample) {
+            constant_sensor sensors[3] = { { 0, 1.0f }, { 0, 2.0f }, { 0, 3.0f } };
+            detail::sensor_group<constant_sensor, 4> group;
+            group.add(sensors + 0, L"a");
+            group.add(sensors + 1, L"b");
+            group.add(sensors + 2, L"c");
+
+            result_type result { 0 };
+            group.sample(on_batch, &result);
+            group.sample(on_batch, &result);
+
+            Assert::AreEqual(std::size_t(2), result.batches, L"One batch per tick", LINE_INFO());
+            Assert::AreEqual(std::size_t(2), sensors[0].reads, L"Each sensor read per tick", LINE_INFO());
+            Assert::AreEqual(std::size_t(3), result.power.size(), L"Batch holds all sensors", LINE_INFO());
+            Assert::AreEqual(1.0f, result.power[0], L"Power of a", LINE_INFO());
+            Assert::AreEqual(2.0f, result.power[1], L"Power of b", LINE_INFO());
+            Assert::AreEqual(3.0f, result.power[2], L"Power of c", LINE_INFO());
+            Assert::AreEqual(std::wstring(L"b"), result.names[1], L"Name of b", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
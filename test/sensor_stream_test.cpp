@@ -0,0 +1,64 @@
+﻿// <copyright file="sensor_stream_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(sensor_stream_test) {
+
+    public:
+
+        TEST_METHOD(test_invalid) {
+            sensor_stream stream;
+            Assert::IsFalse(bool(stream), L"Default stream is invalid", LINE_INFO());
+            Assert::ExpectException<std::runtime_error>([&stream](void) { stream.subscribe(); }, L"Cannot subscribe invalid stream", LINE_INFO());
+
+            synthetic_sensor sensor(L"stream_test");
+            Assert::ExpectException<std::invalid_argument>([&sensor](void) { sensor_stream s(sensor, 1000, 0); }, L"Zero capacity", LINE_INFO());
+        }
+
+        TEST_METHOD(test_stream) {
+            synthetic_sensor sensor(L"stream_test");
+            collector_subscriber subscriber;
+
+            {
+                sensor_stream stream(sensor, 1000);
+                Assert::IsTrue(bool(stream), L"Stream is valid", LINE_INFO());
+                subscriber = stream.subscribe();
+                Assert::IsTrue(bool(subscriber), L"Subscriber is valid", LINE_INFO());
+
+                Assert::IsTrue(subscriber.wait(10000), L"Samples arrive", LINE_INFO());
+                std::vector<measurement_data> samples(16, measurement_data(0, 0.0f));
+                std::vector<const wchar_t *> sensors(samples.size(), nullptr);
+                const auto cnt = subscriber.read(samples.data(), sensors.data(), samples.size());
+                Assert::IsTrue(cnt > 0, L"Samples read", LINE_INFO());
+                Assert::AreEqual(L"stream_test", sensors[0], L"Sensor name", LINE_INFO());
+
+                auto moved = std::move(stream);
+                Assert::IsFalse(bool(stream), L"Moved stream is invalid", LINE_INFO());
+                Assert::IsTrue(bool(moved), L"Stream has been moved", LINE_INFO());
+            }
+
+            // Drain what has been published before the stream was destroyed.
+            std::vector<measurement_data> samples(4096, measurement_data(0, 0.0f));
+            subscriber.read(samples.data(), nullptr, samples.size());
+
+            std::atomic<int> fired(0);
+            Assert::IsFalse(subscriber.notify([](void *c) { ++*static_cast<std::atomic<int> *>(c); }, &fired), L"No notification after stream is gone", LINE_INFO());
+            Assert::IsFalse(subscriber.wait(10), L"No samples after stream is gone", LINE_INFO());
+            Assert::AreEqual(0, fired.load(), L"Callback not invoked", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
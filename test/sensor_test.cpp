@@ -0,0 +1,190 @@
+﻿// <copyright file="sensor_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    /// <summary>
+    /// A sensor that only provides the synchronous API.
+    /// </summary>
+    class sync_only_sensor final : public sensor {
+
+    public:
+
+        inline sync_only_sensor(const wchar_t *name) : _name(name) { }
+
+        ~sync_only_sensor(void) {
+            this->sample_batch(nullptr);
+        }
+
+        virtual const wchar_t *name(void) const noexcept override {
+            return this->_name;
+        }
+
+        virtual operator bool(void) const noexcept override {
+            return (this->_name != nullptr);
+        }
+
+    protected:
+
+        measurement_data sample_sync(
+                const timestamp_resolution resolution) const override {
+            return measurement_data(detail::create_timestamp(resolution),
+                1.0f, 2.0f);
+        }
+
+    private:
+
+        const wchar_t *_name;
+    };
+
+
+    /// <summary>
+    /// A sensor that throws from its synchronous API while it is failing.
+    /// </summary>
+    class failing_sensor final : public sensor {
+
+    public:
+
+        std::atomic<bool> failing;
+
+        inline failing_sensor(const wchar_t *name) : failing(true),
+            _name(name) { }
+
+        ~failing_sensor(void) {
+            this->sample_batch(nullptr);
+        }
+
+        virtual const wchar_t *name(void) const noexcept override {
+            return this->_name;
+        }
+
+        virtual operator bool(void) const noexcept override {
+            return (this->_name != nullptr);
+        }
+
+    protected:
+
+        measurement_data sample_sync(
+                const timestamp_resolution resolution) const override {
+            if (this->failing.load()) {
+                throw std::runtime_error("The sensor is failing.");
+            }
+
+            return measurement_data(detail::create_timestamp(resolution),
+                1.0f, 3.0f);
+        }
+
+    private:
+
+        const wchar_t *_name;
+    };
+
+
+    TEST_CLASS(sensor_test) {
+
+    public:
+
+        TEST_METHOD(test_default_sample_batch) {
+            struct state_type {
+                std::atomic<std::size_t> cnt;
+                std::atomic<bool> valid;
+            } state;
+            state.cnt = 0;
+            state.valid = true;
+
+            sync_only_sensor sensor(L"sync");
+            sensor.sample_batch([](const wchar_t *s, const measurement_data *m, const std::size_t n, void *c) {
+                auto state = static_cast<state_type *>(c);
+                if ((s == nullptr) || (::wcscmp(s, L"sync") != 0) || (m[n - 1].power() != 2.0f)) {
+                    state->valid = false;
+                }
+                state->cnt += n;
+            }, 1000, &state);
+
+            Assert::ExpectException<std::logic_error>([&sensor](void) {
+                sensor.sample_batch([](const wchar_t *, const measurement_data *, const std::size_t, void *) {});
+            }, L"Restart is rejected", LINE_INFO());
+
+            while (state.cnt.load() < 16) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            sensor.sample_batch(nullptr);
+            const auto cnt = state.cnt.load();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            Assert::AreEqual(cnt, state.cnt.load(), L"No samples after stop", LINE_INFO());
+            Assert::IsTrue(state.valid, L"Samples are valid", LINE_INFO());
+        }
+
+        TEST_METHOD(test_isolation) {
+            auto on_batch = [](const wchar_t *, const measurement_data *, const std::size_t n, void *c) {
+                *static_cast<std::atomic<std::size_t> *>(c) += n;
+            };
+            std::atomic<std::size_t> good_cnt(0), bad_cnt(0);
+
+            sync_only_sensor good(L"good");
+            failing_sensor bad(L"bad");
+            good.sample_batch(on_batch, 1000, &good_cnt);
+            bad.sample_batch(on_batch, 1000, &bad_cnt);
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            Assert::IsTrue(good_cnt.load() > 0, L"Healthy sensor is sampled", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), bad_cnt.load(), L"Failing sensor delivers nothing", LINE_INFO());
+
+            bad.failing = false;
+            for (int i = 0; (i < 300) && (bad_cnt.load() == 0); ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            Assert::IsTrue(bad_cnt.load() > 0, L"Recovered sensor is sampled", LINE_INFO());
+
+            bad.sample_batch(nullptr);
+            good.sample_batch(nullptr);
+        }
+
+        TEST_METHOD(test_sample_all) {
+            auto on_batch = [](const wchar_t *, const measurement_data *, const std::size_t n, void *c) {
+                *static_cast<std::atomic<std::size_t> *>(c) += n;
+            };
+            std::atomic<std::size_t> cnt(0);
+
+            sync_only_sensor s1(L"s1");
+            sync_only_sensor s2(L"s2");
+            sensor *sensors[] = { &s1, nullptr, &s2 };
+
+            sensor::sample_all(sensors, 3, on_batch, 1000, &cnt);
+            Assert::ExpectException<std::logic_error>([&](void) {
+                sensor::sample_all(sensors, 3, on_batch, 1000, &cnt);
+            }, L"Restart is rejected", LINE_INFO());
+            s1.sample_batch(nullptr);
+
+            // s2 is still running, so the start of s1 must be rolled back.
+            Assert::ExpectException<std::logic_error>([&](void) {
+                sensor::sample_all(sensors, 3, on_batch, 1000, &cnt);
+            }, L"Start of s2 fails", LINE_INFO());
+            s2.sample_batch(nullptr);
+
+            sensor::microseconds_type latencies[] = { 1, 1, 1 };
+            sensor::sample_all(sensors, 3, on_batch, 1000, &cnt, latencies);
+            Assert::AreEqual(sensor::microseconds_type(0), latencies[1], L"No latency for null sensor", LINE_INFO());
+            s1.sample_batch(nullptr);
+            s2.sample_batch(nullptr);
+
+            Assert::ExpectException<std::invalid_argument>([&](void) {
+                sensor::sample_all(sensors, 3, nullptr, 1000, &cnt);
+            }, L"Null callback", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,80 @@
+﻿// <copyright file="sequence_tracker_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(sequence_tracker_test) {
+
+    public:
+
+        TEST_METHOD(test_next) {
+            measurement_data::sequence_type counter = 0;
+            Assert::AreEqual(measurement_data::sequence_type(1), detail::sequence_tracker::next(counter), L"First number", LINE_INFO());
+            Assert::AreEqual(measurement_data::sequence_type(1), counter, L"Counter advanced", LINE_INFO());
+
+            counter = (std::numeric_limits<measurement_data::sequence_type>::max)();
+            Assert::AreEqual(measurement_data::sequence_type(1), detail::sequence_tracker::next(counter), L"Zero is skipped", LINE_INFO());
+        }
+
+        TEST_METHOD(test_gaps) {
+            detail::sequence_tracker tracker;
+            detail::sequence_gap gap;
+
+            auto make = [](const measurement::timestamp_type t, const measurement_data::sequence_type s, const wchar_t *name = L"sensor") {
+                measurement_data data(t, 1.0f);
+                data.sequence(s);
+                return measurement(name, data);
+            };
+
+            Assert::IsFalse(tracker.push(make(0, 0), gap), L"Unnumbered sample ignored", LINE_INFO());
+            Assert::IsTrue(tracker.summary().empty(), L"Unnumbered sample not counted", LINE_INFO());
+
+            Assert::IsFalse(tracker.push(make(1, 1), gap), L"First sample", LINE_INFO());
+            Assert::IsFalse(tracker.push(make(2, 2), gap), L"Contiguous", LINE_INFO());
+
+            Assert::IsTrue(tracker.push(make(5, 5), gap), L"Gap detected", LINE_INFO());
+            Assert::AreEqual(measurement_data::sequence_type(3), gap.first, L"First missing", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(2), gap.missing, L"Missing samples", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(5), gap.timestamp, L"Timestamp after gap", LINE_INFO());
+
+            Assert::IsFalse(tracker.push(make(6, 5), gap), L"Repeated number", LINE_INFO());
+            Assert::IsFalse(tracker.push(make(7, 4), gap), L"Older number", LINE_INFO());
+
+            // Wrapping around skips zero, which is not a gap.
+            const auto max = (std::numeric_limits<measurement_data::sequence_type>::max)();
+            Assert::IsFalse(tracker.push(make(1, max, L"wrap"), gap), L"Other sensor", LINE_INFO());
+            Assert::IsFalse(tracker.push(make(2, 1, L"wrap"), gap), L"Wrap-around", LINE_INFO());
+            Assert::IsTrue(tracker.push(make(3, 3, L"wrap"), gap), L"Gap after wrap-around", LINE_INFO());
+            Assert::AreEqual(measurement_data::sequence_type(2), gap.first, L"First missing after wrap-around", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(1), gap.missing, L"Missing after wrap-around", LINE_INFO());
+            Assert::AreEqual(L"wrap", gap.sensor, L"Sensor of gap", LINE_INFO());
+
+            auto summary = tracker.summary();
+            Assert::AreEqual(std::size_t(2), summary.size(), L"Two sensors", LINE_INFO());
+            Assert::AreEqual(L"sensor", summary[0].sensor, L"Sorted by name", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(5), summary[0].samples, L"Numbered samples", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(2), summary[0].duplicates, L"Duplicates", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(1), summary[0].gaps, L"Gaps", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(2), summary[0].missing, L"Missing", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(3), summary[1].samples, L"Samples across wrap-around", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(0), summary[1].duplicates, L"No duplicates across wrap-around", LINE_INFO());
+
+            tracker.reset();
+            Assert::IsTrue(tracker.summary().empty(), L"Reset", LINE_INFO());
+        }
+
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
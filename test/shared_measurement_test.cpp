@@ -0,0 +1,83 @@
+﻿// <copyright file="shared_measurement_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(shared_measurement_test) {
+
+    public:
+
+        TEST_METHOD(test_invalid) {
+            shared_measurement_reader reader;
+            measurement_data data(0, 0.0f);
+            Assert::IsFalse(bool(reader), L"Default reader is invalid", LINE_INFO());
+            Assert::IsFalse(reader.active(), L"Default reader inactive", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), reader.size(), L"No sensors", LINE_INFO());
+            Assert::IsFalse(reader.read(std::size_t(0), data), L"Nothing to read", LINE_INFO());
+            Assert::IsNull(reader.sensor(0), L"No sensor name", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                shared_measurement_reader r(nullptr);
+            }, L"Null name", LINE_INFO());
+            Assert::ExpectException<std::system_error>([](void) {
+                shared_measurement_reader r(L"PwrOwgTestDoesNotExist");
+            }, L"Missing segment", LINE_INFO());
+        }
+
+        TEST_METHOD(test_publish) {
+            static const wchar_t *const name = L"PwrOwgSharedMeasurementTest";
+            detail::shared_measurement_writer writer;
+            writer.open(name, 2);
+            Assert::IsTrue(writer.is_open(), L"Writer open", LINE_INFO());
+
+            shared_measurement_reader reader(name);
+            Assert::IsTrue(bool(reader), L"Reader valid", LINE_INFO());
+            Assert::IsTrue(reader.active(), L"Writer active", LINE_INFO());
+            Assert::AreEqual(std::size_t(2), reader.capacity(), L"Capacity", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), reader.size(), L"No sensors yet", LINE_INFO());
+
+            Assert::IsTrue(writer.publish(measurement(L"first", 1, 2.0f, 3.0f, 6.0f)), L"Publish first", LINE_INFO());
+            Assert::IsTrue(writer.publish(measurement(L"second", 2, 5.0f)), L"Publish second", LINE_INFO());
+            Assert::IsFalse(writer.publish(measurement(L"third", 3, 5.0f)), L"Capacity exhausted", LINE_INFO());
+            Assert::IsTrue(writer.publish(measurement(L"first", 4, 2.0f, 4.0f, 8.0f)), L"Update first", LINE_INFO());
+
+            Assert::AreEqual(std::size_t(2), reader.size(), L"Two sensors", LINE_INFO());
+            Assert::AreEqual(L"first", reader.sensor(0), L"Name of first", LINE_INFO());
+            Assert::AreEqual(L"second", reader.sensor(1), L"Name of second", LINE_INFO());
+            Assert::IsNull(reader.sensor(2), L"No third sensor", LINE_INFO());
+
+            measurement_data data(0, 0.0f);
+            Assert::IsTrue(reader.read(std::size_t(0), data), L"Read first", LINE_INFO());
+            Assert::AreEqual(measurement_data::timestamp_type(4), data.timestamp(), L"Latest timestamp", LINE_INFO());
+            Assert::AreEqual(2.0f, data.voltage(), L"Voltage", LINE_INFO());
+            Assert::AreEqual(4.0f, data.current(), L"Current", LINE_INFO());
+            Assert::AreEqual(8.0f, data.power(), L"Power", LINE_INFO());
+
+            Assert::IsTrue(reader.read(L"second", data), L"Read second by name", LINE_INFO());
+            Assert::AreEqual(measurement_data::timestamp_type(2), data.timestamp(), L"Timestamp of second", LINE_INFO());
+            Assert::AreEqual(5.0f, data.power(), L"Power of second", LINE_INFO());
+            Assert::AreEqual(measurement_data::invalid_value, data.voltage(), L"No voltage", LINE_INFO());
+
+            Assert::IsFalse(reader.read(L"third", data), L"Third dropped", LINE_INFO());
+            Assert::IsFalse(reader.read(std::size_t(2), data), L"Index out of range", LINE_INFO());
+
+            writer.close();
+            Assert::IsFalse(reader.active(), L"Writer closed", LINE_INFO());
+            Assert::IsTrue(reader.read(std::size_t(0), data), L"Last sample remains readable", LINE_INFO());
+        }
+
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,83 @@
+﻿// <copyright file="spsc_ring_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(spsc_ring_test) {
+
+    public:
+
+        TEST_METHOD(test_capacity) {
+            detail::spsc_ring<int> ring(5);
+            Assert::AreEqual(std::size_t(8), ring.capacity(), L"Capacity rounded to power of two", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), ring.size(), L"New ring is empty", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) { detail::spsc_ring<int> ring(0); }, L"Zero capacity", LINE_INFO());
+        }
+
+        TEST_METHOD(test_overflow) {
+            detail::spsc_ring<std::wstring> ring(4);
+
+            for (int i = 0; i < 6; ++i) {
+                ring.push(std::to_wstring(i));
+            }
+            Assert::AreEqual(std::size_t(4), ring.size(), L"Ring is full", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(2), ring.overflows(), L"Two elements dropped", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(4), ring.position(), L"Dropped elements have no position", LINE_INFO());
+
+            std::vector<std::wstring> values;
+            auto cnt = ring.drain([&values](const std::wstring& v, const std::uint64_t p) {
+                Assert::AreEqual(std::uint64_t(values.size()), p, L"Position of element", LINE_INFO());
+                values.push_back(v);
+            }, 3);
+            Assert::AreEqual(std::size_t(3), cnt, L"Drained up to end", LINE_INFO());
+            Assert::AreEqual(std::wstring(L"2"), values.back(), L"Oldest elements drained first", LINE_INFO());
+            Assert::AreEqual(std::size_t(1), ring.size(), L"One element remaining", LINE_INFO());
+
+            Assert::AreEqual(std::size_t(2), ring.push(L"4"), L"Push after drain", LINE_INFO());
+            cnt = ring.drain([&values](const std::wstring& v, const std::uint64_t) { values.push_back(v); });
+            Assert::AreEqual(std::size_t(2), cnt, L"Drained all", LINE_INFO());
+            Assert::AreEqual(std::wstring(L"4"), values.back(), L"Wrapped element", LINE_INFO());
+        }
+
+        TEST_METHOD(test_concurrent) {
+            const std::uint64_t cnt = 100000;
+            detail::spsc_ring<std::uint64_t> ring(64);
+            std::uint64_t expected = 0;
+            auto in_order = true;
+
+            std::thread producer([&ring, cnt](void) {
+                for (std::uint64_t i = 0; i < cnt;) {
+                    if (ring.push(i) > 0) {
+                        ++i;
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+
+            while (expected < cnt) {
+                ring.drain([&](const std::uint64_t v, const std::uint64_t p) {
+                    in_order = in_order && (v == expected) && (p == expected);
+                    ++expected;
+                });
+                std::this_thread::yield();
+            }
+
+            producer.join();
+            Assert::IsTrue(in_order, L"All elements received in order", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
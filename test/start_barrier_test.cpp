@@ -0,0 +1,65 @@
+﻿// <copyright file="start_barrier_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(start_barrier_test) {
+
+    public:
+
+        TEST_METHOD(test_not_armed) {
+            Assert::IsFalse(detail::start_barrier::armed(), L"Barrier not armed initially", LINE_INFO());
+            const auto before = detail::start_barrier::clock_type::now();
+            Assert::IsTrue(detail::start_barrier::wait() >= before, L"Wait returns now if not armed", LINE_INFO());
+            Assert::ExpectException<std::logic_error>([](void) { detail::start_barrier::release(); }, L"Release without arm", LINE_INFO());
+        }
+
+        TEST_METHOD(test_release) {
+            typedef detail::start_barrier::clock_type::time_point time_point;
+            std::vector<time_point> origins(4);
+            std::atomic<std::size_t> returned(0);
+
+            detail::start_barrier::arm();
+            detail::start_barrier::arm();
+            Assert::IsTrue(detail::start_barrier::armed(), L"Barrier armed", LINE_INFO());
+
+            std::vector<std::thread> threads;
+            for (std::size_t i = 0; i < origins.size(); ++i) {
+                threads.emplace_back([&origins, &returned, i](void) {
+                    origins[i] = detail::start_barrier::wait();
+                    ++returned;
+                });
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            Assert::AreEqual(std::size_t(0), returned.load(), L"Threads held back", LINE_INFO());
+
+            detail::start_barrier::release();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            Assert::AreEqual(std::size_t(0), returned.load(), L"Threads held back by second arm", LINE_INFO());
+
+            const auto origin = detail::start_barrier::release();
+            for (auto& t : threads) {
+                t.join();
+            }
+
+            Assert::IsFalse(detail::start_barrier::armed(), L"Barrier released", LINE_INFO());
+            for (auto& o : origins) {
+                Assert::IsTrue(o == origin, L"All threads share the origin", LINE_INFO());
+            }
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
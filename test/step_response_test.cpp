@@ -0,0 +1,82 @@
+﻿// <copyright file="step_response_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(step_response_test) {
+
+    public:
+
+        TEST_METHOD(test_empty) {
+            detail::step_response_estimator estimator;
+            Assert::IsTrue(estimator.estimate().empty(), L"No sensors", LINE_INFO());
+
+            estimator.push(measurement(L"sensor", 0, 1.0f));
+            auto responses = estimator.estimate();
+            Assert::AreEqual(std::size_t(1), responses.size(), L"One sensor", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), responses[0].edges, L"No steps", LINE_INFO());
+
+            estimator.reset();
+            Assert::IsTrue(estimator.estimate().empty(), L"Reset", LINE_INFO());
+        }
+
+        TEST_METHOD(test_ramp) {
+            typedef measurement::timestamp_type timestamp_type;
+            detail::step_response_estimator estimator;
+
+            // The load toggles every 1000 ticks, the "ramp" sensor starts to
+            // follow 20 ticks later within 100 ticks, and the "ideal" sensor
+            // follows immediately. The "flat" sensor only sees noise.
+            for (timestamp_type t = 1000; t <= 5000; t += 1000) {
+                estimator.step(t);
+            }
+
+            for (timestamp_type t = 0; t < 6000; t += 10) {
+                const auto phase = t / 1000;
+                const auto since = t - phase * 1000;
+                const auto rising = ((phase % 2) == 1);
+                const auto ramp = (std::min)(1.0f, (std::max)(0.0f,
+                    (since - 20) / 100.0f));
+                const auto r = rising ? ramp : 1.0f - ramp;
+                const auto level = (phase == 0) ? 0.0f : r;
+
+                estimator.push(measurement(L"ramp", t, 50.0f + 100.0f * level));
+                estimator.push(measurement(L"ideal", t,
+                    rising ? 150.0f : 50.0f));
+                estimator.push(measurement(L"flat", t,
+                    ((t / 10) % 2) ? 10.0f : 10.5f));
+            }
+
+            auto responses = estimator.estimate();
+            Assert::AreEqual(std::size_t(3), responses.size(), L"Three sensors", LINE_INFO());
+            Assert::AreEqual(L"flat", responses[0].sensor, L"Ordered by name", LINE_INFO());
+            Assert::AreEqual(L"ideal", responses[1].sensor, L"Ordered by name", LINE_INFO());
+            Assert::AreEqual(L"ramp", responses[2].sensor, L"Ordered by name", LINE_INFO());
+
+            Assert::AreEqual(std::size_t(0), responses[0].edges, L"Noise only", LINE_INFO());
+
+            Assert::AreEqual(std::size_t(5), responses[1].edges, L"Ideal edges", LINE_INFO());
+            Assert::AreEqual(100.0f, responses[1].amplitude, 0.01f, L"Ideal amplitude", LINE_INFO());
+            Assert::AreEqual(timestamp_type(0), responses[1].delay, L"Ideal delay", LINE_INFO());
+
+            Assert::AreEqual(std::size_t(5), responses[2].edges, L"Ramp edges", LINE_INFO());
+            Assert::AreEqual(100.0f, responses[2].amplitude, 0.01f, L"Ramp amplitude", LINE_INFO());
+            Assert::AreEqual(timestamp_type(70), responses[2].delay, L"Ramp delay", LINE_INFO());
+            Assert::AreEqual(timestamp_type(80), responses[2].rise_time, L"Ramp rise time", LINE_INFO());
+        }
+
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -20,6 +20,28 @@ namespace test {
 
     public:
 
+        TEST_METHOD(test_append_from_utf8) {
+            {
+                std::wstring str(L">");
+                detail::append_from_utf8(str, "Universit\xC3\xA4t \xE2\x82\xAC");
+                Assert::AreEqual(std::wstring(L">Universit\u00E4t \u20AC"), str, L"Two and three bytes", LINE_INFO());
+            }
+
+            {
+                std::wstring str;
+                detail::append_from_utf8(str, "\xC3x\x80\xC0\xAF");
+                Assert::AreEqual(std::wstring(L"\uFFFDx\uFFFD\uFFFD"), str, L"Invalid sequences replaced", LINE_INFO());
+            }
+
+            {
+                std::wstring str;
+                detail::append_from_utf8(str, "\xF0\x9F\x98\x80");
+                std::string utf8;
+                detail::append_utf8(utf8, str.c_str());
+                Assert::AreEqual(std::string("\xF0\x9F\x98\x80"), utf8, L"Round trip outside BMP", LINE_INFO());
+            }
+        }
+
         TEST_METHOD(test_convert_char_char) {
             typedef char src_type;
             typedef char dst_type;
@@ -0,0 +1,206 @@
+﻿// <copyright file="subscriber_ring_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(subscriber_ring_test) {
+
+    public:
+
+        TEST_METHOD(test_capacity) {
+            detail::subscriber_ring ring(5);
+            Assert::AreEqual(std::size_t(8), ring.capacity(), L"Capacity rounded to power of two", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(0), ring.head(), L"New ring is empty", LINE_INFO());
+            Assert::IsFalse(ring.subscribed(), L"No reader", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) { detail::subscriber_ring ring(0); }, L"Zero capacity", LINE_INFO());
+        }
+
+        TEST_METHOD(test_commit) {
+            detail::subscriber_ring ring(8);
+            auto cursor = ring.attach();
+            Assert::IsTrue(ring.subscribed(), L"Reader attached", LINE_INFO());
+
+            ring.push(measurement(L"sensor1", 1, 12.0f, 2.0f));
+            ring.push(measurement(L"sensor2", 2, 5.0f));
+
+            std::uint64_t lost = 0;
+            std::vector<measurement_data> samples(4, measurement_data(0, 0.0f));
+            std::vector<const wchar_t *> sensors(4, nullptr);
+            Assert::AreEqual(std::size_t(0), ring.read(cursor, subscriber_overflow::drop_oldest, lost, sensors.data(), samples.data(), samples.size()), L"Not committed", LINE_INFO());
+
+            ring.commit();
+            Assert::AreEqual(std::uint64_t(2), ring.head(), L"Committed", LINE_INFO());
+            Assert::AreEqual(std::size_t(2), ring.read(cursor, subscriber_overflow::drop_oldest, lost, sensors.data(), samples.data(), samples.size()), L"Read committed", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(2), cursor, L"Cursor advanced", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(0), lost, L"Nothing lost", LINE_INFO());
+            Assert::AreEqual(L"sensor1", sensors[0], L"First sensor", LINE_INFO());
+            Assert::AreEqual(L"sensor2", sensors[1], L"Second sensor", LINE_INFO());
+            Assert::AreEqual(12.0f, samples[0].voltage(), L"Voltage", LINE_INFO());
+            Assert::AreEqual(2.0f, samples[0].current(), L"Current", LINE_INFO());
+            Assert::AreEqual(24.0f, samples[0].power(), L"Power", LINE_INFO());
+            Assert::AreEqual(measurement_data::timestamp_type(2), samples[1].timestamp(), L"Timestamp", LINE_INFO());
+            Assert::AreEqual(5.0f, samples[1].power(), L"Power only", LINE_INFO());
+
+            auto late = ring.attach();
+            Assert::AreEqual(std::uint64_t(2), late, L"Late reader starts at head", LINE_INFO());
+
+            ring.detach();
+            ring.detach();
+            Assert::IsFalse(ring.subscribed(), L"Readers detached", LINE_INFO());
+        }
+
+        TEST_METHOD(test_notify) {
+            detail::subscriber_ring ring(8);
+            auto cursor = ring.attach();
+            int fired = 0;
+            auto callback = [](void *context) { ++*static_cast<int *>(context); };
+
+            Assert::ExpectException<std::invalid_argument>([&ring, cursor](void) { ring.notify(cursor, nullptr, nullptr, nullptr); }, L"Null callback", LINE_INFO());
+
+            Assert::IsTrue(ring.notify(cursor, callback, &fired, &ring), L"Registered", LINE_INFO());
+            ring.commit();
+            Assert::AreEqual(0, fired, L"Empty commit does not notify", LINE_INFO());
+            ring.push(measurement(L"sensor", 1, 1.0f));
+            ring.commit();
+            Assert::AreEqual(1, fired, L"Notified by commit", LINE_INFO());
+            ring.push(measurement(L"sensor", 2, 1.0f));
+            ring.commit();
+            Assert::AreEqual(1, fired, L"Notified only once", LINE_INFO());
+
+            Assert::IsFalse(ring.notify(cursor, callback, &fired, &ring), L"Samples pending", LINE_INFO());
+            cursor = ring.head();
+            Assert::IsTrue(ring.notify(cursor, callback, &fired, &ring), L"Registered again", LINE_INFO());
+            Assert::IsTrue(ring.cancel(&ring), L"Cancelled", LINE_INFO());
+            Assert::IsFalse(ring.cancel(&ring), L"Nothing to cancel", LINE_INFO());
+            ring.push(measurement(L"sensor", 3, 1.0f));
+            ring.commit();
+            Assert::AreEqual(1, fired, L"Cancelled notification not fired", LINE_INFO());
+
+            cursor = ring.head();
+            Assert::IsTrue(ring.notify(cursor, callback, &fired, &ring), L"Registered before close", LINE_INFO());
+            ring.close();
+            Assert::AreEqual(2, fired, L"Notified by close", LINE_INFO());
+            Assert::IsFalse(ring.notify(cursor, callback, &fired, &ring), L"Closed", LINE_INFO());
+        }
+
+        TEST_METHOD(test_overflow) {
+            detail::subscriber_ring ring(4);
+            auto oldest = ring.attach();
+            auto latest = ring.attach();
+
+            for (int i = 0; i < 6; ++i) {
+                ring.push(measurement(L"sensor", i, float(i + 1)));
+            }
+            ring.commit();
+
+            std::uint64_t lost = 0;
+            std::vector<measurement_data> samples(8, measurement_data(0, 0.0f));
+            Assert::AreEqual(std::size_t(4), ring.read(oldest, subscriber_overflow::drop_oldest, lost, nullptr, samples.data(), samples.size()), L"Remaining samples read", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(2), lost, L"Oldest samples lost", LINE_INFO());
+            Assert::AreEqual(measurement_data::timestamp_type(2), samples[0].timestamp(), L"Continued with oldest remaining", LINE_INFO());
+            Assert::AreEqual(measurement_data::timestamp_type(5), samples[3].timestamp(), L"Newest sample", LINE_INFO());
+
+            lost = 0;
+            Assert::AreEqual(std::size_t(0), ring.read(latest, subscriber_overflow::skip_to_latest, lost, nullptr, samples.data(), samples.size()), L"Backlog skipped", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(6), lost, L"Whole backlog lost", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(6), latest, L"Cursor at head", LINE_INFO());
+
+            ring.push(measurement(L"sensor", 6, 7.0f));
+            ring.commit();
+            Assert::AreEqual(std::size_t(1), ring.read(latest, subscriber_overflow::skip_to_latest, lost, nullptr, samples.data(), samples.size()), L"New sample after skip", LINE_INFO());
+            Assert::AreEqual(measurement_data::timestamp_type(6), samples[0].timestamp(), L"Latest sample", LINE_INFO());
+        }
+
+        TEST_METHOD(test_wait) {
+            detail::subscriber_ring ring(8);
+            auto cursor = ring.attach();
+            Assert::IsFalse(ring.wait(cursor, std::chrono::milliseconds(1)), L"Timeout", LINE_INFO());
+
+            std::thread writer([&ring](void) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                ring.push(measurement(L"sensor", 1, 1.0f));
+                ring.commit();
+            });
+            Assert::IsTrue(ring.wait(cursor, std::chrono::milliseconds(10000)), L"Woken by commit", LINE_INFO());
+            writer.join();
+
+            ++cursor;
+            std::thread closer([&ring](void) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                ring.close();
+            });
+            Assert::IsFalse(ring.wait(cursor, std::chrono::milliseconds(10000)), L"Woken by close", LINE_INFO());
+            closer.join();
+        }
+
+        TEST_METHOD(test_concurrent) {
+            const std::uint64_t cnt = 100000;
+            detail::subscriber_ring ring(256);
+            std::vector<std::thread> readers;
+            std::atomic<int> attached(0);
+            std::atomic<bool> consistent(true);
+            std::atomic<bool> done(false);
+
+            for (int r = 0; r < 3; ++r) {
+                readers.emplace_back([&, r](void) {
+                    auto cursor = ring.attach();
+                    ++attached;
+                    std::uint64_t lost = 0;
+                    std::uint64_t received = 0;
+                    measurement_data::timestamp_type previous = -1;
+                    std::vector<measurement_data> samples(64, measurement_data(0, 0.0f));
+                    const auto policy = (r == 0) ? subscriber_overflow::skip_to_latest : subscriber_overflow::drop_oldest;
+
+                    while (!done.load() || (cursor < ring.head())) {
+                        const auto n = ring.read(cursor, policy, lost, nullptr, samples.data(), samples.size());
+                        for (std::size_t i = 0; i < n; ++i) {
+                            // Samples are never torn or reordered.
+                            const auto t = samples[i].timestamp();
+                            if ((t <= previous) || (samples[i].power() != float(t % 1000 + 1))) {
+                                consistent.store(false);
+                            }
+                            previous = t;
+                        }
+                        received += n;
+                    }
+
+                    if (received + lost != ring.head()) {
+                        consistent.store(false);
+                    }
+                });
+            }
+
+            // Wait until all readers have attached before we start writing.
+            while (attached.load() < 3) {
+                std::this_thread::yield();
+            }
+
+            for (std::uint64_t i = 0; i < cnt; ++i) {
+                ring.push(measurement(L"sensor", measurement_data::timestamp_type(i), float(i % 1000 + 1)));
+                if (i % 32 == 31) {
+                    ring.commit();
+                }
+            }
+            ring.commit();
+            done.store(true);
+
+            for (auto& r : readers) {
+                r.join();
+            }
+            Assert::IsTrue(consistent.load(), L"All samples consistent", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,104 @@
+﻿// <copyright file="synthetic_sensor_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(synthetic_sensor_test) {
+
+    public:
+
+        TEST_METHOD(test_for_all) {
+            Assert::AreEqual(std::size_t(0), synthetic_sensor::for_all(nullptr, 0), L"Synthetic sensors are not discovered", LINE_INFO());
+        }
+
+        TEST_METHOD(test_ctor) {
+            synthetic_sensor empty;
+            Assert::IsFalse(bool(empty), L"Default sensor is invalid", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                synthetic_sensor sensor(L"");
+            }, L"Name is required", LINE_INFO());
+
+            synthetic_sensor sensor(L"synth");
+            Assert::IsTrue(bool(sensor), L"Named sensor is valid", LINE_INFO());
+            Assert::AreEqual(L"synth", sensor.name(), L"Name", LINE_INFO());
+            Assert::IsTrue(synthetic_waveform::sine == sensor.waveform(), L"Default waveform", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&sensor](void) { sensor.period(0); }, L"Zero period", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&sensor](void) { sensor.voltage(0.0f); }, L"Zero voltage", LINE_INFO());
+
+            auto moved = std::move(sensor);
+            Assert::IsFalse(bool(sensor), L"Moved sensor is invalid", LINE_INFO());
+            Assert::ExpectException<std::runtime_error>([&sensor](void) { sensor.offset(); }, L"Moved sensor cannot be used", LINE_INFO());
+        }
+
+        TEST_METHOD(test_waveforms) {
+            synthetic_sensor constant(L"constant", synthetic_waveform::constant);
+            constant.offset(24.0f).voltage(12.0f);
+            auto sample = constant.sample_data();
+            Assert::AreEqual(24.0f, sample.power(), L"Constant power", LINE_INFO());
+            Assert::AreEqual(12.0f, sample.voltage(), L"Voltage", LINE_INFO());
+            Assert::AreEqual(2.0f, sample.current(), L"Current", LINE_INFO());
+
+            for (auto w : { synthetic_waveform::sine, synthetic_waveform::square, synthetic_waveform::sawtooth, synthetic_waveform::noise }) {
+                synthetic_sensor sensor(L"synth", w);
+                sensor.offset(100.0f).amplitude(10.0f).period(1000);
+                for (int i = 0; i < 100; ++i) {
+                    const auto power = sensor.sample_data().power();
+                    Assert::IsTrue(power >= 90.0f, L"Lower bound of waveform", LINE_INFO());
+                    Assert::IsTrue(power <= 110.0f, L"Upper bound of waveform", LINE_INFO());
+                }
+            }
+
+            Assert::IsTrue(synthetic_waveform::sawtooth == parse_synthetic_waveform(to_string(synthetic_waveform::sawtooth)), L"Waveform round trip", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) { parse_synthetic_waveform(L"triangle"); }, L"Unknown waveform", LINE_INFO());
+        }
+
+        TEST_METHOD(test_cost) {
+            synthetic_sensor sensor(L"synth");
+            sensor.cost(2000);
+
+            const auto begin = std::chrono::steady_clock::now();
+            sensor.sample_data();
+            const auto end = std::chrono::steady_clock::now();
+            Assert::IsTrue(end - begin >= std::chrono::microseconds(2000), L"Sample takes its cost", LINE_INFO());
+        }
+
+        TEST_METHOD(test_async) {
+            for (auto async : { false, true }) {
+                std::atomic<std::size_t> cnt(0);
+                synthetic_sensor sensor(L"synth");
+                sensor.async(async);
+
+                sensor.sample_batch([](const wchar_t *name, const measurement_data *samples, const std::size_t cnt, void *context) {
+                    Assert::AreEqual(L"synth", name, L"Name of sensor in callback", LINE_INFO());
+                    *static_cast<std::atomic<std::size_t> *>(context) += cnt;
+                }, 1000, &cnt);
+
+                Assert::ExpectException<std::logic_error>([&sensor](void) {
+                    sensor.sample_batch([](const wchar_t *, const measurement_data *, const std::size_t, void *) { }, 1000);
+                }, L"Sampling twice", LINE_INFO());
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                sensor.sample_batch(nullptr);
+
+                const std::size_t actual = cnt;
+                Assert::IsTrue(actual > 0, L"Samples delivered", LINE_INFO());
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                Assert::AreEqual(actual, std::size_t(cnt), L"No samples after stop", LINE_INFO());
+            }
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,174 @@
+﻿// <copyright file="sysfs_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(sysfs_test) {
+
+    public:
+
+        TEST_METHOD(test_for_all) {
+            std::vector<sysfs_sensor> sensors(sysfs_sensor::for_all(nullptr, 0));
+            sysfs_sensor::for_all(sensors.data(), sensors.size());
+
+            for (auto& s : sensors) {
+                Assert::IsTrue(bool(s), L"Enumerated sensor is valid", LINE_INFO());
+                Assert::IsNotNull(s.name(), L"Enumerated sensor has name", LINE_INFO());
+            }
+
+#if defined(_WIN32)
+            Assert::AreEqual(std::size_t(0), sensors.size(), L"sysfs is not supported on Windows", LINE_INFO());
+#endif /* defined(_WIN32) */
+        }
+
+        TEST_METHOD(test_for_path) {
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                sysfs_sensor::for_path(static_cast<const char *>(nullptr), sysfs_sensor_quantity::power);
+            }, L"Null path", LINE_INFO());
+            Assert::ExpectException<std::system_error>([](void) {
+                sysfs_sensor::for_path("/sys/class/hwmon/nope/power1_input", sysfs_sensor_quantity::power);
+            }, L"Non-existing file", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                sysfs_sensor::for_pattern(nullptr, 0, nullptr, sysfs_sensor_quantity::power);
+            }, L"Null pattern", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), sysfs_sensor::for_pattern(nullptr, 0, "/sys/class/nope*/power*_input", sysfs_sensor_quantity::power), L"Nothing matches", LINE_INFO());
+        }
+
+        TEST_METHOD(test_quantity) {
+            const sysfs_sensor_quantity quantities[] = {
+                sysfs_sensor_quantity::power,
+                sysfs_sensor_quantity::energy
+            };
+
+            for (auto q : quantities) {
+                Assert::IsTrue(q == parse_sysfs_sensor_quantity(to_string(q)), L"Round trip", LINE_INFO());
+            }
+
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                parse_sysfs_sensor_quantity(L"voltage");
+            }, L"Invalid quantity", LINE_INFO());
+        }
+
+        TEST_METHOD(test_parse) {
+            Assert::AreEqual(std::uint64_t(42000000), detail::sysfs_batch::parse("42000000\n", 9), L"Microwatts", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(12), detail::sysfs_batch::parse("1234", 2), L"Only valid bytes", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(7), detail::sysfs_batch::parse(" 7", 2), L"Leading space", LINE_INFO());
+            Assert::ExpectException<std::runtime_error>([](void) {
+                detail::sysfs_batch::parse("\n", 1);
+            }, L"No number", LINE_INFO());
+        }
+
+        TEST_METHOD(test_name) {
+            Assert::AreEqual(L"sysfs/hwmon/hwmon2/power1_input", detail::sysfs_sensor_impl::get_name("/sys/class/hwmon/hwmon2/power1_input").c_str(), L"Relative to class", LINE_INFO());
+            Assert::AreEqual(L"sysfs/sys/devices/platform/energy", detail::sysfs_sensor_impl::get_name("/sys/devices/platform/energy").c_str(), L"Absolute path", LINE_INFO());
+        }
+
+#if !defined(_WIN32)
+        TEST_METHOD(test_files) {
+            const std::string power_path("/tmp/pwrowg_sysfs_test_power");
+            const std::string energy_path("/tmp/pwrowg_sysfs_test_energy");
+            std::ofstream(power_path) << "1500000\n";
+            std::ofstream(energy_path) << "1000000\n";
+
+            {
+                auto power = sysfs_sensor::for_path(power_path.c_str(), sysfs_sensor_quantity::power);
+                auto energy = sysfs_sensor::for_path(energy_path.c_str(), sysfs_sensor_quantity::energy);
+                Assert::IsTrue(bool(power), L"Power sensor valid", LINE_INFO());
+                Assert::IsTrue(power.quantity() == sysfs_sensor_quantity::power, L"Power quantity", LINE_INFO());
+                Assert::AreEqual(sysfs_sensor::default_scale, power.scale(), L"Default scale", LINE_INFO());
+                Assert::AreEqual(power_path.c_str(), power.path(), L"Path", LINE_INFO());
+
+                auto sample = power.sample_data();
+                Assert::AreEqual(1.5f, sample.power(), 0.0001f, L"Scaled power", LINE_INFO());
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                std::ofstream(energy_path) << "3000000\n";
+                Assert::AreEqual(2.0, energy.energy(), 0.0001, L"Accumulated energy", LINE_INFO());
+                sample = energy.sample_data();
+                Assert::IsTrue(sample.power() > 0.0f, L"Power from energy", LINE_INFO());
+
+                sysfs_sensor sensors[] = { std::move(power), std::move(energy) };
+                measurement_data samples[] = { measurement_data(0, 0.0f), measurement_data(0, 0.0f) };
+                sysfs_sensor::sample_data(samples, sensors, 2);
+                Assert::AreEqual(1.5f, samples[0].power(), 0.0001f, L"Batch power", LINE_INFO());
+            }
+
+            std::remove(power_path.c_str());
+            std::remove(energy_path.c_str());
+        }
+
+        TEST_METHOD(test_shared_sampling) {
+            const std::string path("/tmp/pwrowg_sysfs_shared_test");
+            std::ofstream(path) << "1000000\n";
+
+            {
+                auto sensor = sysfs_sensor::for_path(path.c_str(), sysfs_sensor_quantity::power);
+                std::atomic<std::size_t> fast(0), slow(0);
+                auto on_batch = [](const wchar_t *, const measurement_data *, const std::size_t cnt, void *context) {
+                    *static_cast<std::atomic<std::size_t> *>(context) += cnt;
+                };
+
+                sensor.sample_batch(on_batch, 1000, &fast);
+                sensor.sample_batch(on_batch, 4000, &slow);
+                Assert::ExpectException<std::logic_error>([&](void) {
+                    sensor.sample_batch(on_batch, 1000, &fast);
+                }, L"Same subscriber twice", LINE_INFO());
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                sensor.sample_batch(nullptr, 0, &slow);
+                Assert::IsTrue(slow.load() > 0, L"Slow subscriber sampled", LINE_INFO());
+                Assert::IsTrue(fast.load() > slow.load(), L"Fast subscriber sampled more often", LINE_INFO());
+
+                const auto stopped = slow.load();
+                const auto running = fast.load();
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                Assert::AreEqual(stopped, slow.load(), L"Slow subscriber stopped", LINE_INFO());
+                sensor.sample_batch(nullptr);
+                Assert::IsTrue(fast.load() > running, L"Fast subscriber still running", LINE_INFO());
+            }
+
+            std::remove(path.c_str());
+        }
+
+        TEST_METHOD(test_io_uring_reader) {
+            const std::string path("/tmp/pwrowg_io_uring_test");
+            std::ofstream(path) << "42";
+
+            try {
+                detail::io_uring_reader reader(2);
+                const int files[] = { detail::open(path.c_str(), O_RDONLY), -1, detail::open(path.c_str(), O_RDONLY) };
+                char buffers[3 * 8];
+                std::int32_t results[3];
+
+                // Three files exceed the submission queue of two entries.
+                reader.read(results, buffers, 8, files, 3);
+                Assert::AreEqual(std::int32_t(2), results[0], L"First file read", LINE_INFO());
+                Assert::IsTrue(results[1] < 0, L"Invalid file fails", LINE_INFO());
+                Assert::AreEqual(std::int32_t(2), results[2], L"Third file read", LINE_INFO());
+                Assert::IsTrue(::memcmp(buffers + 16, "42", 2) == 0, L"Content", LINE_INFO());
+
+                ::close(files[0]);
+                ::close(files[2]);
+            } catch (std::system_error) {
+                Logger::WriteMessage(L"io_uring is not available.");
+            }
+
+            std::remove(path.c_str());
+        }
+#endif /* !defined(_WIN32) */
+
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
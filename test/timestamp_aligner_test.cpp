@@ -0,0 +1,75 @@
+﻿// <copyright file="timestamp_aligner_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(timestamp_aligner_test) {
+
+    public:
+
+        TEST_METHOD(test_unknown) {
+            detail::timestamp_aligner aligner;
+            auto aligned = aligner.align(measurement(L"sensor", 100, 1.0f));
+            Assert::AreEqual(measurement::timestamp_type(100), aligned.timestamp(), L"Empty aligner", LINE_INFO());
+
+            aligner.add_trailing(L"trailing", 20);
+            aligned = aligner.align(measurement(L"sensor", 100, 1.0f));
+            Assert::AreEqual(measurement::timestamp_type(100), aligned.timestamp(), L"Unknown sensor", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(0), aligner.latency(L"sensor"), L"No latency", LINE_INFO());
+        }
+
+        TEST_METHOD(test_align) {
+            detail::timestamp_aligner aligner;
+            aligner.add_trailing(L"trailing", 20);
+            Assert::AreEqual(measurement::timestamp_type(10), aligner.latency(L"trailing"), L"Initial latency", LINE_INFO());
+
+            auto aligned = aligner.align(measurement(L"trailing", 100, 2.0f));
+            Assert::AreEqual(measurement::timestamp_type(90), aligned.timestamp(), L"Centre of period", LINE_INFO());
+            Assert::AreEqual(2.0f, aligned.power(), L"Power retained", LINE_INFO());
+            Assert::AreEqual(std::wstring(L"trailing"), std::wstring(aligned.sensor()), L"Sensor retained", LINE_INFO());
+
+            // The estimate converges to the actual interval.
+            for (measurement::timestamp_type t = 140; t < 4000; t += 40) {
+                aligned = aligner.align(measurement(L"trailing", t, 2.0f));
+            }
+            Assert::AreEqual(measurement::timestamp_type(20), aligner.latency(L"trailing"), L"Converged latency", LINE_INFO());
+
+            // Jittering samples never go back in time.
+            const auto previous = aligned.timestamp();
+            aligned = aligner.align(measurement(L"trailing", previous + 1, 2.0f));
+            Assert::IsTrue(aligned.timestamp() >= previous, L"Monotonic", LINE_INFO());
+
+            aligner.reset();
+            Assert::AreEqual(measurement::timestamp_type(0), aligner.latency(L"trailing"), L"Reset", LINE_INFO());
+        }
+
+        TEST_METHOD(test_delay) {
+            detail::timestamp_aligner aligner;
+            aligner.add_trailing(L"calibrated", 20);
+            aligner.add_delay(L"calibrated", 35);
+            Assert::AreEqual(measurement::timestamp_type(35), aligner.latency(L"calibrated"), L"Delay replaces estimate", LINE_INFO());
+
+            // The calibrated delay does not follow the actual interval.
+            measurement aligned(L"calibrated", 0, 0.0f);
+            for (measurement::timestamp_type t = 100; t < 4000; t += 40) {
+                aligned = aligner.align(measurement(L"calibrated", t, 1.0f));
+                Assert::AreEqual(t - 35, aligned.timestamp(), L"Fixed delay", LINE_INFO());
+            }
+            Assert::AreEqual(measurement::timestamp_type(35), aligner.latency(L"calibrated"), L"Delay retained", LINE_INFO());
+        }
+
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
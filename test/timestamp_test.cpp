@@ -43,6 +43,44 @@ namespace test {
             Assert::AreEqual(this->_filetime_zero, a, L"Unix epoch as FILETIME", LINE_INFO());
         }
 
+        TEST_METHOD(test_converter) {
+            using namespace std::chrono;
+            typedef duration<timestamp_type, detail::filetime_period> unit;
+            const auto ft = this->_filetime_zero + 12345678901LL;
+
+            static_assert(detail::convert<timestamp_resolution::milliseconds>(20000) == 2, "Compile-time conversion");
+            Assert::AreEqual(duration_cast<seconds>(unit(ft)).count(), detail::convert<timestamp_resolution::seconds>(ft), L"Seconds", LINE_INFO());
+            Assert::AreEqual(duration_cast<milliseconds>(unit(ft)).count(), detail::convert<timestamp_resolution::milliseconds>(ft), L"Milliseconds", LINE_INFO());
+            Assert::AreEqual(duration_cast<microseconds>(unit(ft)).count(), detail::convert<timestamp_resolution::microseconds>(ft), L"Microseconds", LINE_INFO());
+            Assert::AreEqual(ft, detail::convert<timestamp_resolution::hundred_nanoseconds>(ft), L"100 nanoseconds", LINE_INFO());
+            Assert::AreEqual(timestamp_type(1234500), detail::convert<timestamp_resolution::nanoseconds>(12345), L"Nanoseconds", LINE_INFO());
+
+            for (auto r : { timestamp_resolution::seconds, timestamp_resolution::milliseconds, timestamp_resolution::microseconds, timestamp_resolution::hundred_nanoseconds }) {
+                auto converter = detail::get_timestamp_converter(r);
+                Assert::IsTrue(converter != nullptr, L"Converter available", LINE_INFO());
+                Assert::AreEqual(detail::convert(ft, r), converter(ft), L"Converter matches convert", LINE_INFO());
+
+                timestamp_type batch[] = { ft, ft + 1, ft + 10000, ft + 10000000 };
+                detail::convert(batch, batch, 4, r);
+                Assert::AreEqual(detail::convert(ft, r), batch[0], L"Batch element 0", LINE_INFO());
+                Assert::AreEqual(detail::convert(ft + 1, r), batch[1], L"Batch element 1", LINE_INFO());
+                Assert::AreEqual(detail::convert(ft + 10000, r), batch[2], L"Batch element 2", LINE_INFO());
+                Assert::AreEqual(detail::convert(ft + 10000000, r), batch[3], L"Batch element 3", LINE_INFO());
+            }
+
+            auto now = system_clock::now();
+            Assert::AreEqual(detail::convert(now, timestamp_resolution::milliseconds), detail::convert<timestamp_resolution::milliseconds>(detail::convert_to_file_time(now)), L"Time point via FILETIME", LINE_INFO());
+        }
+
+        TEST_METHOD(test_from_file_time) {
+            using namespace std::chrono;
+            Assert::IsTrue(system_clock::from_time_t(0) == detail::convert_from_file_time(116444736000000000LL), L"UNIX epoch", LINE_INFO());
+
+            auto now = time_point_cast<duration<timestamp_type, detail::filetime_period>>(system_clock::now());
+            auto file_time = detail::convert_to_file_time(now);
+            Assert::AreEqual(file_time, detail::convert_to_file_time(detail::convert_from_file_time(file_time)), L"Round trip via time point", LINE_INFO());
+        }
+
         TEST_METHOD(test_microseconds) {
             typedef std::chrono::microseconds unit;
             static const auto resolution = timestamp_resolution::microseconds;
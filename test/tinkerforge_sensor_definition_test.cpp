@@ -89,6 +89,35 @@ namespace test {
             }
         }
 
+        TEST_METHOD(test_endpoint) {
+            {
+                tinkerforge_sensor_definition d("horst");
+                Assert::IsNull(d.host(), L"Host is unknown", LINE_INFO());
+                Assert::AreEqual(int(0), int(d.port()), L"Port is unknown", LINE_INFO());
+            }
+
+            {
+                tinkerforge_sensor_definition d("horst", "brickd1", 4224);
+                Assert::AreEqual("horst", d.uid(), L"UID is \"horst\"", LINE_INFO());
+                Assert::AreEqual("brickd1", d.host(), L"Host is \"brickd1\"", LINE_INFO());
+                Assert::AreEqual(int(4224), int(d.port()), L"Port is 4224", LINE_INFO());
+
+                tinkerforge_sensor_definition dd(d);
+                Assert::AreEqual(d.host(), dd.host(), L"Host copied", LINE_INFO());
+                Assert::AreEqual(int(d.port()), int(dd.port()), L"Port copied", LINE_INFO());
+
+                tinkerforge_sensor_definition ddd(std::move(dd));
+                Assert::AreEqual("brickd1", ddd.host(), L"Host moved", LINE_INFO());
+                Assert::AreEqual(int(4224), int(ddd.port()), L"Port moved", LINE_INFO());
+                Assert::IsNull(dd.host(), L"Host source erased.", LINE_INFO());
+
+                tinkerforge_sensor_definition dddd;
+                dddd = ddd;
+                Assert::AreEqual("brickd1", dddd.host(), L"Host assigned", LINE_INFO());
+                Assert::AreEqual(int(4224), int(dddd.port()), L"Port assigned", LINE_INFO());
+            }
+        }
+
     };
 } /* namespace test */
 } /* namespace power_overwhelming */
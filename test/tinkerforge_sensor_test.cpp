@@ -0,0 +1,80 @@
+﻿// <copyright file="tinkerforge_sensor_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(tinkerforge_sensor_test) {
+
+    public:
+
+        TEST_METHOD(test_configure_all) {
+            const sensor::microseconds_type interval = 1000;
+            tinkerforge_sensor *null_sensor = nullptr;
+            tinkerforge_sensor disposed;
+
+            Assert::ExpectException<std::invalid_argument>([]() {
+                tinkerforge_sensor::configure_all(nullptr, nullptr, 1);
+            }, L"Null sensors", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([&null_sensor]() {
+                tinkerforge_sensor::configure_all(&null_sensor, nullptr, 1);
+            }, L"Null intervals", LINE_INFO());
+
+            // Nothing to configure does not need a connection.
+            tinkerforge_sensor::configure_all(nullptr, nullptr, 0);
+            tinkerforge_sensor::configure_all(&null_sensor, &interval, 1);
+
+            auto s = &disposed;
+            Assert::ExpectException<std::runtime_error>([&s, &interval]() {
+                tinkerforge_sensor::configure_all(&s, &interval, 1);
+            }, L"Disposed sensor", LINE_INFO());
+        }
+
+        TEST_METHOD(test_select_configuration) {
+            sample_averaging averaging;
+            conversion_time time;
+
+            {
+                auto retval = tinkerforge_sensor::select_configuration(5000, averaging, time);
+                Assert::IsTrue(retval, L"Configuration for 5 ms found", LINE_INFO());
+                Assert::IsTrue(averaging == sample_averaging::average_of_4, L"Average of 4 for 5 ms", LINE_INFO());
+                Assert::IsTrue(time == conversion_time::microseconds_588, L"588 µs for 5 ms", LINE_INFO());
+            }
+
+            {
+                auto retval = tinkerforge_sensor::select_configuration(1000, averaging, time);
+                Assert::IsTrue(retval, L"Configuration for 1 ms found", LINE_INFO());
+                Assert::IsTrue(averaging == sample_averaging::average_of_1, L"Average of 1 for 1 ms", LINE_INFO());
+                Assert::IsTrue(time == conversion_time::microseconds_332, L"332 µs for 1 ms", LINE_INFO());
+            }
+
+            {
+                auto retval = tinkerforge_sensor::select_configuration(1000000, averaging, time);
+                Assert::IsTrue(retval, L"Configuration for 1 s found", LINE_INFO());
+                Assert::IsTrue(averaging == sample_averaging::average_of_1024, L"Average of 1024 for 1 s", LINE_INFO());
+                Assert::IsTrue(time == conversion_time::microseconds_332, L"332 µs for 1 s", LINE_INFO());
+            }
+
+            {
+                auto retval = tinkerforge_sensor::select_configuration(100, averaging, time);
+                Assert::IsFalse(retval, L"No configuration for 100 µs", LINE_INFO());
+                Assert::IsTrue(averaging == sample_averaging::average_of_1, L"Fastest averaging as fallback", LINE_INFO());
+                Assert::IsTrue(time == conversion_time::microseconds_140, L"Fastest conversion as fallback", LINE_INFO());
+            }
+        }
+
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,159 @@
+﻿// <copyright file="trace_output_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(trace_output_test) {
+
+    public:
+
+        TEST_METHOD(test_chrome) {
+            // 2023-01-01 00:00:00 UTC in milliseconds since 1601.
+            const measurement::timestamp_type start = 13317004800000LL;
+            const measurement samples[] = {
+                measurement(L"sensor1", start + 1, 12.5f),
+                measurement(L"sensor2", start + 2, 12.0f, 0.5f, 6.0f)
+            };
+
+            {
+                detail::trace_output_writer writer;
+                writer.open(L"trace_output_test.json", output_format::chrome_trace);
+                writer.header(timestamp_resolution::milliseconds, { L"sensor1" });
+                writer.marker(1, L"phase \"1\"");
+                writer.marker_event(start, 1);
+                for (auto& s : samples) {
+                    writer.push(s, 1);
+                }
+            }
+
+            std::ifstream file("trace_output_test.json", std::ios::binary);
+            const auto trace = nlohmann::json::parse(file);
+            Assert::IsTrue(trace.is_array(), L"JSON array format", LINE_INFO());
+
+            std::size_t begins = 0, counters = 0, ends = 0;
+            for (auto& e : trace) {
+                const auto ph = e["ph"].get<std::string>();
+                if (ph == "B") {
+                    ++begins;
+                    Assert::AreEqual(std::string("phase \"1\""), e["name"].get<std::string>(), L"Marker name", LINE_INFO());
+                    Assert::AreEqual(1672531200000000.0, e["ts"].get<double>(), 0.5, L"Marker time", LINE_INFO());
+                } else if (ph == "E") {
+                    ++ends;
+                    Assert::AreEqual(1672531200002000.0, e["ts"].get<double>(), 0.5, L"Slice closed at end", LINE_INFO());
+                } else if (ph == "C") {
+                    ++counters;
+                }
+            }
+
+            Assert::AreEqual(std::size_t(1), begins, L"One slice begun", LINE_INFO());
+            Assert::AreEqual(std::size_t(1), ends, L"One slice ended", LINE_INFO());
+            Assert::AreEqual(std::size_t(4), counters, L"Power of both, voltage and current of second", LINE_INFO());
+        }
+
+        TEST_METHOD(test_perfetto) {
+            const measurement::timestamp_type start = 13317004800000LL;
+            const auto count = 100;
+
+            {
+                detail::trace_output_writer writer;
+                writer.open(L"trace_output_test.pftrace", output_format::perfetto);
+                writer.header(timestamp_resolution::milliseconds, { L"sensor1" });
+                writer.marker(1, L"phase");
+                writer.marker_event(start, 1);
+                for (int i = 0; i < count; ++i) {
+                    writer.push(measurement(L"sensor1", start + i, 10.0f), 1);
+                }
+                writer.marker_event(start + count, 0);
+            }
+
+            std::ifstream file("trace_output_test.pftrace", std::ios::binary);
+            const std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+            std::size_t offset = 0;
+            std::vector<std::string> packets;
+            while (offset < data.size()) {
+                Assert::AreEqual(0x0A, static_cast<int>(data[offset++]), L"Trace.packet", LINE_INFO());
+                const auto size = varint(data, offset);
+                packets.push_back(data.substr(offset, static_cast<std::size_t>(size)));
+                offset += static_cast<std::size_t>(size);
+            }
+            Assert::AreEqual(data.size(), offset, L"Complete packets", LINE_INFO());
+
+            std::size_t counters = 0, descriptors = 0, interned = 0, slices = 0;
+            for (auto& p : packets) {
+                std::size_t o = 0;
+                std::string event;
+                while (o < p.size()) {
+                    const auto tag = varint(p, o);
+                    const auto field = tag >> 3;
+                    if ((tag & 7) == 0) {
+                        const auto value = varint(p, o);
+                        if ((field == 13) && (&p == &packets.front())) {
+                            Assert::AreEqual(std::uint64_t(1), value, L"Incremental state cleared first", LINE_INFO());
+                        }
+                    } else if ((tag & 7) == 2) {
+                        const auto size = static_cast<std::size_t>(varint(p, o));
+                        if (field == 11) {
+                            event = p.substr(o, size);
+                        } else if (field == 12) {
+                            ++interned;
+                        } else if (field == 60) {
+                            ++descriptors;
+                        }
+                        o += size;
+                    } else {
+                        Assert::Fail(L"Unexpected wire type in packet", LINE_INFO());
+                    }
+                }
+
+                if (!event.empty()) {
+                    // The first field of all our events is the type.
+                    Assert::AreEqual(0x48, static_cast<int>(event[0]), L"TrackEvent.type", LINE_INFO());
+                    if (event[1] == 4) {
+                        ++counters;
+                        Assert::IsTrue(p.size() < 40, L"Compact counter", LINE_INFO());
+                    } else {
+                        ++slices;
+                    }
+                }
+            }
+
+            Assert::AreEqual(std::size_t(2), descriptors, L"Marker and power track", LINE_INFO());
+            Assert::AreEqual(std::size_t(count), counters, L"Counter per sample", LINE_INFO());
+            Assert::AreEqual(std::size_t(2), slices, L"Begin and end", LINE_INFO());
+            Assert::AreEqual(std::size_t(1), interned, L"Name interned once", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                detail::trace_output_writer writer;
+                writer.open(L"trace_output_test.csv", output_format::csv);
+            }, L"Non-trace format", LINE_INFO());
+        }
+
+    private:
+
+        static std::uint64_t varint(const std::string& data, std::size_t& offset) {
+            std::uint64_t retval = 0;
+            for (unsigned int shift = 0; offset < data.size(); shift += 7) {
+                const auto b = static_cast<std::uint8_t>(data[offset++]);
+                retval |= static_cast<std::uint64_t>(b & 0x7F) << shift;
+                if ((b & 0x80) == 0) {
+                    break;
+                }
+            }
+            return retval;
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,85 @@
+﻿// <copyright file="trigger_capture_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(trigger_capture_test) {
+
+    public:
+
+        TEST_METHOD(test_disabled) {
+            detail::trigger_capture capture;
+            std::vector<detail::trigger_capture::sample_type> released;
+            Assert::IsFalse(capture.enabled(), L"Disabled by default", LINE_INFO());
+
+            capture.push(measurement(L"sensor", 0, 1.0f), 1, released);
+            Assert::AreEqual(std::size_t(1), released.size(), L"Passed through", LINE_INFO());
+            Assert::AreEqual(std::uint32_t(1), released[0].second, L"Marker retained", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([&capture](void) { capture.configure(-1, 0, 0.0f, 1); }, L"Negative window", LINE_INFO());
+        }
+
+        TEST_METHOD(test_trigger) {
+            detail::trigger_capture capture;
+            std::vector<detail::trigger_capture::sample_type> released;
+            capture.configure(10, 20, 0.0f, 100);
+            Assert::IsTrue(capture.enabled(), L"Enabled", LINE_INFO());
+
+            for (measurement::timestamp_type t = 0; t < 100; ++t) {
+                capture.push(measurement(L"sensor", t, 1.0f), 0, released);
+            }
+            Assert::IsTrue(released.empty(), L"Nothing before trigger", LINE_INFO());
+
+            // The retained samples from 40 to 70 are released, the younger
+            // ones remain in the ring.
+            capture.trigger(50, released);
+            Assert::AreEqual(std::size_t(31), released.size(), L"Window", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(40), released.front().first.timestamp(), L"Begin of window", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(70), released.back().first.timestamp(), L"End of window", LINE_INFO());
+            released.clear();
+
+            // An overlapping trigger extends the window to the younger ones.
+            capture.trigger(75, released);
+            Assert::AreEqual(std::size_t(25), released.size(), L"Extended window", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(71), released.front().first.timestamp(), L"Continued", LINE_INFO());
+            released.clear();
+
+            // Late samples of other sensors in the window are released
+            // directly.
+            capture.push(measurement(L"other", 95, 1.0f), 0, released);
+            capture.push(measurement(L"other", 96, 1.0f), 0, released);
+            Assert::AreEqual(std::size_t(1), released.size(), L"Until end of window", LINE_INFO());
+        }
+
+        TEST_METHOD(test_threshold) {
+            detail::trigger_capture capture;
+            std::vector<detail::trigger_capture::sample_type> released;
+            capture.configure(2, 2, 10.0f, 4);
+
+            for (measurement::timestamp_type t = 0; t < 10; ++t) {
+                capture.push(measurement(L"sensor", t, 1.0f), 0, released);
+            }
+            Assert::IsTrue(released.empty(), L"Below threshold", LINE_INFO());
+
+            // The ring only holds the four youngest samples, two of which are
+            // in the window before the spike.
+            capture.push(measurement(L"sensor", 10, 20.0f), 0, released);
+            Assert::AreEqual(std::size_t(3), released.size(), L"Spike and window", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(8), released.front().first.timestamp(), L"Begin of window", LINE_INFO());
+            Assert::AreEqual(measurement::timestamp_type(10), released.back().first.timestamp(), L"Spike", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
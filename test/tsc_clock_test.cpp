@@ -0,0 +1,68 @@
+﻿// <copyright file="tsc_clock_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(tsc_clock_test) {
+
+    public:
+
+        TEST_METHOD(test_counter) {
+            const auto c0 = detail::tsc_clock::counter();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            const auto c1 = detail::tsc_clock::counter();
+
+            if (detail::tsc_clock::available()) {
+                Assert::IsTrue(c1 > c0, L"Counter advances", LINE_INFO());
+            } else {
+                Assert::AreEqual(std::uint64_t(0), c0, L"No counter", LINE_INFO());
+                Assert::AreEqual(std::uint64_t(0), c1, L"No counter", LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(test_now) {
+            using namespace std::chrono;
+            const auto tolerance = milliseconds(5);
+
+            // Force the initial calibration.
+            detail::tsc_clock::now();
+
+            for (int i = 0; i < 3; ++i) {
+                const auto before = system_clock::now();
+                const auto now = detail::tsc_clock::now();
+                const auto after = system_clock::now();
+                Assert::IsTrue(now >= before - tolerance, L"Not too early", LINE_INFO());
+                Assert::IsTrue(now <= after + tolerance, L"Not too late", LINE_INFO());
+                std::this_thread::sleep_for(milliseconds(10));
+            }
+        }
+
+        TEST_METHOD(test_to_time_point) {
+            using namespace std::chrono;
+
+            if (detail::tsc_clock::available()) {
+                const auto c0 = detail::tsc_clock::counter();
+                std::this_thread::sleep_for(milliseconds(10));
+                const auto c1 = detail::tsc_clock::counter();
+
+                const auto t0 = detail::tsc_clock::to_time_point(c0);
+                const auto t1 = detail::tsc_clock::to_time_point(c1);
+                Assert::IsTrue(t1 > t0, L"Order preserved", LINE_INFO());
+                Assert::IsTrue(t1 - t0 >= milliseconds(5), L"Elapsed time plausible", LINE_INFO());
+            }
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
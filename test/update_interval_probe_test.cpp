@@ -0,0 +1,51 @@
+﻿// <copyright file="update_interval_probe_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(update_interval_probe_test) {
+
+    public:
+
+        TEST_METHOD(test_periodic) {
+            typedef std::chrono::steady_clock clock_type;
+            const auto begin = clock_type::now();
+
+            // Simulate a source that updates every 10 ms.
+            auto actual = detail::probe_update_interval([begin](void) {
+                return (clock_type::now() - begin) / std::chrono::milliseconds(10);
+            }, 4, std::chrono::milliseconds(1000));
+
+            Assert::IsTrue(actual >= std::chrono::milliseconds(8), L"Interval not too short", LINE_INFO());
+            Assert::IsTrue(actual <= std::chrono::milliseconds(20), L"Interval not too long", LINE_INFO());
+        }
+
+        TEST_METHOD(test_constant) {
+            auto actual = detail::probe_update_interval([](void) {
+                return 42;
+            }, 4, std::chrono::milliseconds(50));
+            Assert::IsTrue(actual == std::chrono::microseconds::zero(), L"Constant source has no interval", LINE_INFO());
+        }
+
+        TEST_METHOD(test_no_updates) {
+            auto cnt = 0;
+            auto actual = detail::probe_update_interval([&cnt](void) {
+                return ++cnt;
+            }, 0, std::chrono::milliseconds(50));
+            Assert::IsTrue(actual == std::chrono::microseconds::zero(), L"Zero updates requested", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,98 @@
+﻿// <copyright file="waveform_archive_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(waveform_archive_test) {
+
+    public:
+
+        TEST_METHOD(test_roundtrip) {
+            static const wchar_t *path = L"waveform_archive_test.bin";
+            std::vector<float> samples(1001);
+            for (std::size_t i = 0; i < samples.size(); ++i) {
+                samples[i] = std::sin(0.01f * i);
+            }
+
+            for (auto compress : { false, true }) {
+                {
+                    detail::waveform_archive archive;
+                    Assert::IsFalse(archive.is_open(), L"New archive closed", LINE_INFO());
+                    archive.open(path, compress);
+                    Assert::IsTrue(archive.is_open(), L"Archive open", LINE_INFO());
+                    archive.append(L"rtx", 300, 1, 0, -0.5f, 0.5f, samples.data(), samples.size());
+                    archive.append(L"rtx", 100, 2, 1, -0.5f, 0.5f, samples.data(), 17);
+                    archive.append(L"rtx", 200, 1, 0, -0.5f, 0.5f, samples.data(), 0);
+                    archive.close();
+                    Assert::IsFalse(archive.is_open(), L"Archive closed", LINE_INFO());
+                }
+
+                detail::waveform_archive_reader reader(path);
+                Assert::AreEqual(std::size_t(3), reader.index().size(), L"Three captures", LINE_INFO());
+                Assert::AreEqual(std::size_t(0), reader.find(0), L"Find before first", LINE_INFO());
+                Assert::AreEqual(std::size_t(1), reader.find(150), L"Find between", LINE_INFO());
+                Assert::AreEqual(std::size_t(2), reader.find(300), L"Find exact", LINE_INFO());
+                Assert::AreEqual(std::size_t(3), reader.find(301), L"Find after last", LINE_INFO());
+
+                detail::waveform_capture header;
+                std::vector<float> actual;
+                reader.read(reader.index()[2], header, actual);
+                Assert::AreEqual(L"rtx", header.sensor.c_str(), L"Sensor", LINE_INFO());
+                Assert::AreEqual(std::uint32_t(1), header.channel, L"Channel", LINE_INFO());
+                Assert::AreEqual(std::uint32_t(0), header.segment, L"Segment", LINE_INFO());
+                Assert::AreEqual(-0.5f, header.time_begin, L"Begin", LINE_INFO());
+                Assert::AreEqual(0.5f, header.time_end, L"End", LINE_INFO());
+                Assert::AreEqual(std::uint64_t(samples.size()), header.record_length, L"Record length", LINE_INFO());
+                Assert::IsTrue(samples == actual, L"Samples are lossless", LINE_INFO());
+
+                reader.read(reader.index()[0], header, actual);
+                Assert::AreEqual(std::uint32_t(2), header.channel, L"Channel", LINE_INFO());
+                Assert::AreEqual(std::size_t(17), actual.size(), L"Partial record", LINE_INFO());
+
+                reader.read(reader.index()[1], header, actual);
+                Assert::IsTrue(actual.empty(), L"Empty record", LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(test_recovery) {
+            static const wchar_t *path = L"waveform_archive_recovery.bin";
+            const float samples[] = { 1.0f, 2.0f, 3.0f, 4.0f };
+
+            {
+                detail::waveform_archive archive;
+                archive.open(path, true);
+                archive.append(L"rtx", 5, 1, 0, 0.0f, 1.0f, samples, 4);
+                archive.append(L"rtx", 6, 1, 0, 0.0f, 1.0f, samples, 4);
+                archive.close();
+            }
+
+            // Cut off the index as if the process had crashed.
+            std::vector<char> content;
+            {
+                std::ifstream stream(path, std::ios::binary);
+                content.assign(std::istreambuf_iterator<char>(stream),
+                    std::istreambuf_iterator<char>());
+            }
+            {
+                std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+                stream.write(content.data(), content.size() - 20);
+            }
+
+            detail::waveform_archive_reader reader(path);
+            Assert::AreEqual(std::size_t(2), reader.index().size(), L"Index rebuilt", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
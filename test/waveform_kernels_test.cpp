@@ -0,0 +1,140 @@
+﻿// <copyright file="waveform_kernels_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(waveform_kernels_test) {
+
+    public:
+
+        TEST_METHOD(test_power) {
+            // Use a count that is not a multiple of the vector width to cover
+            // the scalar remainder as well.
+            std::vector<float> voltage(11), current(11), power(11);
+            for (std::size_t i = 0; i < voltage.size(); ++i) {
+                voltage[i] = static_cast<float>(i);
+                current[i] = 0.5f;
+            }
+
+            detail::waveform_power(power.data(), voltage.data(), current.data(), power.size());
+            for (std::size_t i = 0; i < power.size(); ++i) {
+                Assert::AreEqual(0.5f * i, power[i], L"Element-wise product", LINE_INFO());
+            }
+
+            detail::waveform_power(voltage.data(), voltage.data(), current.data(), voltage.size());
+            Assert::AreEqual(5.0f, voltage[10], L"In-place product", LINE_INFO());
+        }
+
+        TEST_METHOD(test_energy) {
+            const float power[] = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f };
+            Assert::AreEqual(0.0, detail::waveform_energy(power, 1, 1.0), L"Single sample", LINE_INFO());
+            Assert::AreEqual(1.5, detail::waveform_energy(power, 2, 1.0), L"Two samples", LINE_INFO());
+            Assert::AreEqual(2.4, detail::waveform_energy(power, 7, 0.1), 1e-9, L"Seven samples", LINE_INFO());
+        }
+
+        TEST_METHOD(test_interpolate) {
+            std::vector<float> dst(11);
+            detail::interpolate_waveform(dst.data(), dst.size(), 1.0f, 3.0f, 0.0f, 0.1f);
+            for (std::size_t i = 0; i < dst.size(); ++i) {
+                Assert::AreEqual(1.0f + 0.2f * i, dst[i], 0.0001f, L"Interpolated value", LINE_INFO());
+            }
+
+            detail::interpolate_waveform(dst.data(), 2, 4.0f, 2.0f, 0.25f, 0.5f);
+            Assert::AreEqual(3.5f, dst[0], 0.0001f, L"Offset", LINE_INFO());
+            Assert::AreEqual(2.5f, dst[1], 0.0001f, L"Descending", LINE_INFO());
+        }
+
+        TEST_METHOD(test_decimate) {
+            const float src[] = { 1.0f, -2.0f, 3.0f, 4.0f, 0.0f, 8.0f, -1.0f, 1.0f, 2.0f, 5.0f };
+            detail::waveform_window windows[4];
+
+            auto cnt = detail::decimate_waveform(windows, src, 10, 4);
+            Assert::AreEqual(std::size_t(3), cnt, L"Number of windows", LINE_INFO());
+            Assert::AreEqual(4.0f, windows[0].maximum, L"Maximum #0", LINE_INFO());
+            Assert::AreEqual(-2.0f, windows[0].minimum, L"Minimum #0", LINE_INFO());
+            Assert::AreEqual(1.5f, windows[0].mean, L"Mean #0", LINE_INFO());
+            Assert::AreEqual(8.0f, windows[1].maximum, L"Maximum #1", LINE_INFO());
+            Assert::AreEqual(-1.0f, windows[1].minimum, L"Minimum #1", LINE_INFO());
+            Assert::AreEqual(2.0f, windows[1].mean, L"Mean #1", LINE_INFO());
+            Assert::AreEqual(5.0f, windows[2].maximum, L"Maximum of partial window", LINE_INFO());
+            Assert::AreEqual(2.0f, windows[2].minimum, L"Minimum of partial window", LINE_INFO());
+            Assert::AreEqual(3.5f, windows[2].mean, L"Mean of partial window", LINE_INFO());
+
+            cnt = detail::decimate_waveform(windows, src, 2, 0);
+            Assert::AreEqual(std::size_t(2), cnt, L"Window of zero is one", LINE_INFO());
+            Assert::AreEqual(-2.0f, windows[1].mean, L"Sample passed through", LINE_INFO());
+        }
+
+        TEST_METHOD(test_convolve) {
+            std::vector<float> src(12), dst(12);
+            for (std::size_t i = 0; i < src.size(); ++i) {
+                src[i] = static_cast<float>(i * i);
+            }
+            const float taps[] = { 0.25f, 0.5f, 0.25f };
+
+            auto cnt = detail::convolve_waveform(dst.data(), src.data(), src.size(), taps, 3);
+            Assert::AreEqual(std::size_t(10), cnt, L"Complete overlaps only", LINE_INFO());
+            for (std::size_t i = 0; i < cnt; ++i) {
+                const auto expected = 0.25f * src[i] + 0.5f * src[i + 1] + 0.25f * src[i + 2];
+                Assert::AreEqual(expected, dst[i], 0.0001f, L"Convolved value", LINE_INFO());
+            }
+
+            cnt = detail::convolve_waveform(dst.data(), src.data(), 2, taps, 3);
+            Assert::AreEqual(std::size_t(0), cnt, L"Input shorter than kernel", LINE_INFO());
+        }
+
+        TEST_METHOD(test_median) {
+            // Outliers in a ramp, with a count that is not a multiple of the
+            // vector width.
+            std::vector<float> src(13), dst(13);
+            for (std::size_t i = 0; i < src.size(); ++i) {
+                src[i] = static_cast<float>(i);
+            }
+            src[4] = 100.0f;
+            src[9] = -100.0f;
+
+            auto cnt = detail::median_waveform(dst.data(), src.data(), src.size(), 3);
+            Assert::AreEqual(std::size_t(11), cnt, L"Number of medians", LINE_INFO());
+            Assert::AreEqual(3.0f, dst[2], L"Window centred on 3", LINE_INFO());
+            Assert::AreEqual(5.0f, dst[3], L"Outlier rejected", LINE_INFO());
+            Assert::AreEqual(8.0f, dst[8], L"Negative outlier rejected", LINE_INFO());
+            Assert::AreEqual(11.0f, dst[10], L"Last median", LINE_INFO());
+
+            // Windows exceeding the sorting network use the scalar path.
+            const auto window = detail::max_vector_median + 2;
+            std::vector<float> large(window + 4);
+            for (std::size_t i = 0; i < large.size(); ++i) {
+                large[i] = static_cast<float>(large.size() - i);
+            }
+            cnt = detail::median_waveform(dst.data(), large.data(), large.size(), window);
+            Assert::AreEqual(std::size_t(5), cnt, L"Number of large medians", LINE_INFO());
+            Assert::AreEqual(large[window / 2], dst[0], L"Large median", LINE_INFO());
+        }
+
+        TEST_METHOD(test_smooth) {
+            const float src[] = { 1.0f, 1.0f, 3.0f, 3.0f, 3.0f };
+            float dst[5];
+            auto state = 1.0f;
+
+            detail::smooth_waveform(dst, src, 5, 0.5f, state);
+            Assert::AreEqual(1.0f, dst[1], L"Constant", LINE_INFO());
+            Assert::AreEqual(2.0f, dst[2], L"Half of step", LINE_INFO());
+            Assert::AreEqual(2.75f, dst[4], L"Converging", LINE_INFO());
+            Assert::AreEqual(2.75f, state, L"State updated", LINE_INFO());
+        }
+
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,91 @@
+﻿// <copyright file="wide_csv_rows_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(wide_csv_rows_test) {
+
+    public:
+
+        TEST_METHOD(test_rows) {
+            {
+                detail::csv_output_writer writer;
+                writer.open(L"wide_csv_rows_test.csv");
+
+                detail::wide_csv_rows rows;
+                rows.configure(10, 100);
+                rows.push(measurement(L"sensor1", 1, 1.0f), 1);
+                rows.push(measurement(L"sensor1", 11, 2.0f), 1);
+                rows.push(measurement(L"sensor1", 21, 3.0f), 2);
+                rows.push(measurement(L"sensor2", 5, 4.0f), 1);
+                rows.push(measurement(L"sensor2", 15, 5.0f), 1);
+
+                // The second sensor has not yet delivered a sample after the
+                // second line, so only the first one is complete.
+                rows.flush(writer, false);
+                Assert::IsFalse(rows.empty(), L"Lines pending", LINE_INFO());
+
+                rows.push(measurement(L"sensor3", 25, 6.0f), 2);
+                rows.flush(writer, true);
+                Assert::IsTrue(rows.empty(), L"All lines written", LINE_INFO());
+            }
+
+            std::ifstream csv("wide_csv_rows_test.csv", std::ios::binary);
+            std::stringstream actual;
+            actual << csv.rdbuf();
+            Assert::AreEqual(std::string("timestamp\tsensor1\tsensor2\tmarker\n"
+                "0\t1\t4\t1\n"
+                "timestamp\tsensor1\tsensor2\tsensor3\tmarker\n"
+                "10\t2\t5\t\t\n"
+                "20\t3\t\t6\t2\n"), actual.str(), L"Wide layout", LINE_INFO());
+        }
+
+        TEST_METHOD(test_hold) {
+            {
+                detail::csv_output_writer writer;
+                writer.open(L"wide_csv_rows_test.csv");
+
+                detail::wide_csv_rows rows;
+                rows.configure(0, 10);
+                rows.push(measurement(L"sensor1", 0, 1.0f), 0);
+                rows.push(measurement(L"sensor2", 0, 2.0f), 0);
+                rows.push(measurement(L"sensor1", 5, 1.0f), 0);
+                rows.push(measurement(L"sensor1", 20, 1.0f), 0);
+
+                // The second sensor blocks the lines after zero until they are
+                // older than the hold time.
+                rows.flush(writer, false);
+                rows.restart();
+                rows.flush(writer, true);
+            }
+
+            std::ifstream csv("wide_csv_rows_test.csv", std::ios::binary);
+            std::stringstream actual;
+            actual << csv.rdbuf();
+            Assert::AreEqual(std::string("timestamp\tsensor1\tsensor2\tmarker\n"
+                "0\t1\t2\t0\n"
+                "5\t1\t\t\n"
+                "timestamp\tsensor1\tsensor2\tmarker\n"
+                "20\t1\t\t0\n"), actual.str(), L"Held lines", LINE_INFO());
+        }
+
+        TEST_METHOD(test_configure) {
+            detail::wide_csv_rows rows;
+            Assert::ExpectException<std::invalid_argument>([&rows](void) { rows.configure(-1, 0); }, L"Negative step", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&rows](void) { rows.configure(0, -1); }, L"Negative hold", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,75 @@
+﻿// <copyright file="writer_shard_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart. Alle Rechte vorbehalten.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(writer_shard_test) {
+
+    public:
+
+        TEST_METHOD(test_shard_path) {
+            typedef detail::writer_shard shard;
+            Assert::AreEqual(L"output.csv", shard::shard_path(L"output.csv", 0).c_str(), L"First shard", LINE_INFO());
+            Assert::AreEqual(L"output.shard1.csv", shard::shard_path(L"output.csv", 1).c_str(), L"Second shard", LINE_INFO());
+            Assert::AreEqual(L"dir.d/output.shard2", shard::shard_path(L"dir.d/output", 2).c_str(), L"Dot in directory", LINE_INFO());
+            Assert::AreEqual(L"dir\\.hidden.shard3", shard::shard_path(L"dir\\.hidden", 3).c_str(), L"Hidden file", LINE_INFO());
+        }
+
+        TEST_METHOD(test_write) {
+            typedef detail::writer_shard::buffer_type buffer_type;
+            typedef detail::writer_shard::marker_event_type marker_event_type;
+            std::atomic<std::uint64_t> samples(0);
+            buffer_type own(16), first(16), second(16);
+            std::vector<buffer_type *> buffers { &own, &first, &second };
+            std::vector<buffer_type::position_type> ends;
+
+            {
+                detail::writer_shard shard;
+                shard.open(L"writer_shard_test.csv", output_format::csv, false);
+                shard.start(timestamp_resolution::hundred_nanoseconds, {}, detail::start_record(), true, samples);
+
+                own.push(measurement(L"own", 10, 1.0f));
+                first.push(measurement(L"first", 5, 1.0f));
+                first.push(measurement(L"first", 15, 2.0f));
+                second.push(measurement(L"second", 20, 3.0f));
+                ends = { own.position(), first.position(), second.position() };
+
+                // The shard gets every other buffer starting at the second.
+                shard.post({ L"phase" }, { marker_event_type(10, 1) }, buffers, ends, 1, 2);
+
+                // Samples after the ends must not be written.
+                first.push(measurement(L"first", 25, 4.0f));
+                shard.stop();
+
+                std::unordered_map<const wchar_t *, std::uint64_t> counts;
+                shard.counts(counts);
+                Assert::AreEqual(std::size_t(1), counts.size(), L"One sensor drained", LINE_INFO());
+                Assert::IsTrue(shard.written() > 0, L"Output written", LINE_INFO());
+            }
+
+            Assert::AreEqual(std::uint64_t(2), samples.load(), L"Samples up to the end", LINE_INFO());
+            auto ignore = [](const measurement&, const buffer_type::position_type) { };
+            Assert::AreEqual(std::size_t(1), own.drain(ignore), L"Own buffer untouched", LINE_INFO());
+            Assert::AreEqual(std::size_t(1), second.drain(ignore), L"Buffer of other shard untouched", LINE_INFO());
+            Assert::AreEqual(std::size_t(1), first.drain(ignore), L"Later sample retained", LINE_INFO());
+
+            std::ifstream file("writer_shard_test.csv");
+            std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            Assert::IsTrue(content.find("phase") != std::string::npos, L"Marker declared", LINE_INFO());
+            Assert::IsTrue(content.find("first") != std::string::npos, L"Sample written", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */